@@ -43,20 +43,31 @@ class PyObject;
 class PyBuffer;
 class PyCachedObjectDecoder;
 
+/**
+ * @brief Header of a cache file, followed by the cached bytes.
+ *
+ * The files are mapped into memory when loaded, and the bytes
+ * are served straight from the mapping.
+ */
 #pragma pack(1)
 struct CacheFileHeader
 {
     uint64 timestamp;
+    /// CRC32 of the cached bytes.
     uint32 version;
     uint32 length;
     uint32 magic;
+    /// Version of the file format; files of other versions are ignored.
+    uint32 format;
 };
 #pragma pack()
 
 extern const uint32 CacheFileMagic;
+extern const uint32 CacheFileFormat;
 
 class CachedObjectMgr {
 public:
+    CachedObjectMgr();
     ~CachedObjectMgr();
 
     //internal utility function to keep maps simpler.
@@ -66,17 +77,39 @@ public:
     bool HaveCached(const PyRep *objectID) const;
 
     bool IsCacheUpToDate(const PyRep *objectID, uint32 version, uint64 timestamp);
+    //gets the version (checksum of the contents) of the object; false if it is not cached.
+    bool GetCachedVersion(const std::string &objectID, uint32 &version) const;
 
+    //marks the object as out of date; if it is rebuilt with the same contents,
+    //it keeps its version, so the clients do not fetch it again.
     void InvalidateCache(const PyRep *objectID);
 
+    //records that the object is built from rows of the table with the given key
+    //(0 for the whole table), so it is invalidated along with them.
+    void AddDependency(const PyRep *objectID, const std::string &table, uint32 key = 0);
+    //invalidates the objects built from rows of the table with the given key,
+    //or from any rows of the table if key is 0; returns the number of them.
+    size_t InvalidateDependents(const std::string &table, uint32 key = 0);
+
     //bool IsObjectFresh(const std::string &objectID, uint32 version, uint64 timestamp);
     void UpdateCacheFromSS(const std::string &objectID, PySubStream **in_cached_data);
     void UpdateCache(const std::string &objectID, PyRep **in_cached_data);
     void UpdateCache(const PyRep *objectID, PyRep **in_cached_data);
-
+    //takes an already marshaled object, deflating it the same way as UpdateCache
+    //unless it has been run through DeflateMarshaled already:
+    void UpdateCacheMarshaled(const PyRep *objectID, Buffer **in_marshaled_data, bool deflated = false);
+    //deflates a marshaled object if it is big enough; safe to call from any thread.
+    static bool DeflateMarshaled(Buffer &data);
+
+    //returns a new reference to the hint of the object; the hint is built once per
+    //version of the object and shared by all callers, so it must not be modified.
     PyObject *MakeCacheHint(const PyRep *objectID);
     PyObject *MakeCacheHint(const std::string &objectID);
 
+    //gets a number which changes whenever any object is added, rebuilt or invalidated,
+    //so the callers may keep things derived from the current objects until it does.
+    uint32 GetGeneration() const { return m_generation; }
+
     PyObject *GetCachedObject(const PyRep *objectID);
     PyObject *GetCachedObject(const std::string &objectID);
 
@@ -101,6 +134,8 @@ protected:
     void GetCacheFileName(PyRep *key, std::string &into);
 
     void _UpdateCache(const PyRep *objectID, PyBuffer **buffer);
+    void _InvalidateCache(const std::string &objectID);
+    size_t _InvalidateDependents(const std::set<std::string> &objectIDs);
 
     class CacheRecord {
     public:
@@ -108,18 +143,31 @@ protected:
         ~CacheRecord();
 
         PyObject *EncodeHint() const;
+        //returns a new reference to the shared hint, encoding it on first use.
+        PyObject *GetHint() const;
 
         PyRep *objectID;    //we own this
         uint64 timestamp;
         uint32 version;
         PyBuffer *cache; //we own this.
+        bool stale;     //invalidated, kept to compare with the new contents.
+        mutable PyObject *hint; //we own this; NULL until GetHint() is called.
     };
     typedef std::map<std::string, CacheRecord *>    CachedObjMap;
     typedef CachedObjMap::iterator                  CachedObjMapItr;
     typedef CachedObjMap::const_iterator            CachedObjMapConstItr;
 
 
+    //returns the record unless it is missing or stale.
+    CacheRecord *_FindCurrent(const std::string &objectID) const;
+
     CachedObjMap m_cachedObjects;   //we own these pointers
+    uint32 m_generation;            //bumped whenever m_cachedObjects changes
+
+    typedef std::map<std::pair<std::string, uint32>, std::set<std::string> > DependencyMap;
+    typedef DependencyMap::iterator                                          DependencyMapItr;
+
+    DependencyMap m_dependents;     //(table, key) -> object IDs built from it
 };
 
 class PyCachedObject
@@ -0,0 +1,97 @@
+/*
+    ------------------------------------------------------------------------------------
+    LICENSE:
+    ------------------------------------------------------------------------------------
+    This file is part of EVEmu: EVE Online Server Emulator
+    Copyright 2006 - 2011 The EVEmu Team
+    For the latest information visit http://evemu.org
+    ------------------------------------------------------------------------------------
+    This program is free software; you can redistribute it and/or modify it under
+    the terms of the GNU Lesser General Public License as published by the Free Software
+    Foundation; either version 2 of the License, or (at your option) any later
+    version.
+
+    This program is distributed in the hope that it will be useful, but WITHOUT
+    ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+    FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public License along with
+    this program; if not, write to the Free Software Foundation, Inc., 59 Temple
+    Place - Suite 330, Boston, MA 02111-1307, USA, or go to
+    http://www.gnu.org/copyleft/lesser.txt.
+    ------------------------------------------------------------------------------------
+    Author:     EVEmu Team
+*/
+
+#ifndef __DBROWSETMARSHALER_H_INCL__
+#define __DBROWSETMARSHALER_H_INCL__
+
+#include "database/dbcore.h"
+
+class DBRowDescriptor;
+
+/**
+ * @brief Marshals DB result as CRowset without building any PyRep.
+ *
+ * The values go from the rows straight into the stream, in the very
+ * form MarshalStream saves the PyPackedRows of DBResultToCRowset() in,
+ * so the bytes are the same. Only the header of the rowset is built
+ * (once), every row costs just its own bytes; with a streamed result
+ * (DBcore::RunQueryStream()) neither time nor memory go beyond what
+ * the output takes.
+ *
+ * @author EVEmu Team
+ */
+class DBRowsetMarshaler
+{
+public:
+    /**
+     * @brief Prepares the layout of the rows of given result.
+     *
+     * @param[in] result The result to marshal.
+     */
+    DBRowsetMarshaler( DBQueryResult& result );
+    ~DBRowsetMarshaler();
+
+    /**
+     * @brief Appends marshal stream of CRowset of the rows left in the result.
+     *
+     * @param[out] into Buffer which receives the stream; left as it was on failure.
+     *
+     * @retval true  Marshaling ran successfully.
+     * @retval false Error occured during marshaling or fetching the rows.
+     */
+    bool Save( Buffer& into );
+
+    /**
+     * @brief Appends given row as PyPackedRow, without the stream header.
+     *
+     * @param[in]  row  Row of the result.
+     * @param[out] into Buffer which receives the marshaled row.
+     */
+    void SaveRow( const DBResultRow& row, Buffer& into );
+
+protected:
+    /** Appends a non-packed field of given row. */
+    void _SaveField( const DBResultRow& row, uint32 index, DBTYPE type, Buffer& into );
+    /** Appends given size the way MarshalStream does. */
+    static void _PutSizeEx( uint32 size, Buffer& into );
+
+    /// The result being marshaled.
+    DBQueryResult& mResult;
+    /// The header of the rows.
+    DBRowDescriptor* mHeader;
+    /// The header, marshaled; saved with every row.
+    Buffer mHeaderData;
+
+    /// Indexes of the columns in the order of saving.
+    std::vector<uint32> mColumns;
+    /// Types of the columns, in the same order.
+    std::vector<DBTYPE> mTypes;
+    /// Number of the columns of the fixed-size and of the boolean part.
+    size_t mFixedCount, mBoolCount;
+    /// Scratch space for the unpacked fixed-size and boolean part.
+    std::vector<uint8> mData;
+};
+
+#endif /* !__DBROWSETMARSHALER_H_INCL__ */
@@ -0,0 +1,284 @@
+/*
+    ------------------------------------------------------------------------------------
+    LICENSE:
+    ------------------------------------------------------------------------------------
+    This file is part of EVEmu: EVE Online Server Emulator
+    Copyright 2006 - 2011 The EVEmu Team
+    For the latest information visit http://evemu.org
+    ------------------------------------------------------------------------------------
+    This program is free software; you can redistribute it and/or modify it under
+    the terms of the GNU Lesser General Public License as published by the Free Software
+    Foundation; either version 2 of the License, or (at your option) any later
+    version.
+
+    This program is distributed in the hope that it will be useful, but WITHOUT
+    ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+    FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public License along with
+    this program; if not, write to the Free Software Foundation, Inc., 59 Temple
+    Place - Suite 330, Boston, MA 02111-1307, USA, or go to
+    http://www.gnu.org/copyleft/lesser.txt.
+    ------------------------------------------------------------------------------------
+    Author:     EVEmu Team
+*/
+
+
+#ifndef __DATABASE__DB_TABLE_H__INCL__
+#define __DATABASE__DB_TABLE_H__INCL__
+
+#include "database/dbcore.h"
+#include "python/PyRep.h"
+
+class DBRowDescriptor;
+class DBTable;
+
+/**
+ * @brief A row of a DBTable.
+ *
+ * Has the getters of DBResultRow, so DBRowSchema may decode it.
+ *
+ * @author EVEmu Team
+ */
+class DBTableRow
+{
+    friend class DBTable;
+
+public:
+    DBTableRow();
+
+    bool IsNull( uint32 index ) const;
+
+    /* numbers are formatted; the text is valid until the next call. */
+    const char* GetText( uint32 index ) const;
+    int32 GetInt( uint32 index ) const { return static_cast< int32 >( GetInt64( index ) ); }
+    bool GetBool( uint32 index ) const { return 0 != GetInt64( index ); }
+    uint32 GetUInt( uint32 index ) const { return static_cast< uint32 >( GetUInt64( index ) ); }
+    int64 GetInt64( uint32 index ) const;
+    uint64 GetUInt64( uint32 index ) const;
+    float GetFloat( uint32 index ) const { return static_cast< float >( GetDouble( index ) ); }
+    double GetDouble( uint32 index ) const;
+
+    uint32 ColumnCount() const;
+    const char* ColumnName( uint32 index ) const;
+    DBTYPE ColumnType( uint32 index ) const;
+    uint32 ColumnLength( uint32 index ) const;
+
+    /** @return Index of the row in its table. */
+    uint32 index() const { return mIndex; }
+
+protected:
+    const DBTable* mTable;
+    uint32 mIndex;
+
+    /// Numbers formatted by GetText().
+    mutable std::string mFormatted;
+};
+
+/**
+ * @brief Typed in-memory table, stored by columns.
+ *
+ * Keeps the rows of a static table, loaded from a query result or
+ * from a cached rowset, without a single PyRep: every column is
+ * a vector of its values (numbers in binary, texts in one shared
+ * pool), so a scan of a column touches just that column. The rows
+ * are turned into CRowset or PyPackedRow only when asked to; the
+ * values come out the same as DBResultToCRowset() makes them of
+ * the original result.
+ *
+ * @author EVEmu Team
+ */
+class DBTable
+{
+    friend class DBTableRow;
+
+public:
+    DBTable();
+
+    /** @return Number of columns. */
+    uint32 ColumnCount() const { return mColumns.size(); }
+    /** @return Number of rows. */
+    uint32 RowCount() const { return mRowCount; }
+
+    const char* ColumnName( uint32 index ) const { return mColumns[ index ].name.c_str(); }
+    DBTYPE ColumnType( uint32 index ) const { return mColumns[ index ].type; }
+    /**
+     * @return Index of the column of given name; ColumnCount() if there is none.
+     */
+    uint32 FindColumn( const char* name ) const;
+
+    /** @brief Removes all columns and rows. */
+    void clear();
+
+    /**
+     * @brief Loads the rows left in a query result.
+     *
+     * The columns are those of the result; the table is cleared first.
+     *
+     * @param[in] result The result; its rows are fetched.
+     *
+     * @return Number of the loaded rows.
+     */
+    uint32 Load( DBQueryResult& result );
+    /**
+     * @brief Loads a cached rowset.
+     *
+     * The type of every column is the narrowest the values fit:
+     * DBTYPE_BOOL, DBTYPE_I4 or DBTYPE_I8 for integers, DBTYPE_R8
+     * for reals, DBTYPE_STR or DBTYPE_WSTR for strings. The table
+     * is cleared first.
+     *
+     * @param[in] reader Reader of the rowset (RowsetReader or TuplesetReader).
+     *
+     * @return False if a column mixes numbers and strings or has other values.
+     */
+    template< typename _Reader >
+    bool LoadReader( _Reader& reader );
+
+    /**
+     * @brief Gets a row.
+     *
+     * @param[in]  index Index of the row.
+     * @param[out] into  The row; valid until the table changes.
+     *
+     * @return False if there is no such row.
+     */
+    bool GetRow( uint32 index, DBTableRow& into ) const;
+
+    /** @return Header of the rows, as DBRowDescriptor. */
+    DBRowDescriptor* EncodeHeader() const;
+    /**
+     * @brief Encodes a row as PyPackedRow.
+     *
+     * @param[in] index  Index of the row.
+     * @param[in] header Header of the row, see EncodeHeader(); the reference is consumed.
+     */
+    PyPackedRow* EncodePackedRow( uint32 index, DBRowDescriptor* header ) const;
+    /** @return All rows as CRowset. */
+    PyObjectEx* EncodeCRowset() const;
+    /**
+     * @brief Encodes all rows as dict of PyPackedRows.
+     *
+     * @param[in] keyIndex Index of the key column.
+     */
+    PyDict* EncodePackedRowDict( uint32 keyIndex ) const;
+    /** @return Value of a cell, as DBColumnToPyRep() would make it. */
+    PyRep* EncodeValue( uint32 row, uint32 column ) const;
+
+protected:
+    /** How a column keeps its values. */
+    enum ColumnKind
+    {
+        KIND_INT,
+        KIND_UINT,
+        KIND_REAL,
+        KIND_TEXT
+    };
+
+    /**
+     * @brief A column.
+     */
+    struct Column
+    {
+        std::string name;
+        DBTYPE type;
+        ColumnKind kind;
+
+        /// Bits of the values: int64, uint64, double, or offset into mText.
+        std::vector< uint64 > values;
+        /// Lengths of the texts; empty for numbers.
+        std::vector< uint32 > lengths;
+        /// Whether the values are NULL.
+        std::vector< uint8 > nulls;
+    };
+
+    /** @return The kind which keeps values of given type. */
+    static ColumnKind _GetKind( DBTYPE type );
+    /**
+     * @return Type of a column of a rowset, having seen a value of given type.
+     */
+    static DBTYPE _MergeType( DBTYPE type, PyRep::PyType value, bool& valid );
+
+    void _AddColumn( const char* name, DBTYPE type );
+    void _AddNull( Column& col );
+    /* the numbers are converted to the kind of the column. */
+    void _AddInt( Column& col, int64 value );
+    void _AddUInt( Column& col, uint64 value );
+    void _AddReal( Column& col, double value );
+    void _AddText( Column& col, const char* text, uint32 length );
+    void _AddText( Column& col, const char* text ) { _AddText( col, text, strlen( text ) ); }
+
+    double _GetReal( const Column& col, uint32 row ) const;
+
+    std::vector< Column > mColumns;
+    uint32 mRowCount;
+    /// Texts of all columns, each NUL-terminated.
+    std::string mText;
+};
+
+template< typename _Reader >
+bool DBTable::LoadReader( _Reader& reader )
+{
+    clear();
+
+    const uint32 cc = reader.columnCount();
+
+    // DBTYPE_ERROR until a value is seen
+    bool valid = true;
+    std::vector< DBTYPE > types( cc, DBTYPE_ERROR );
+
+    typename _Reader::iterator cur, end;
+    end = reader.end();
+    for( cur = reader.begin(); cur != end; ++cur )
+        for( uint32 col = 0; col < cc; ++col )
+            types[ col ] = _MergeType( types[ col ], cur.IsNone( col ) ? PyRep::PyTypeNone : cur.GetType( col ), valid );
+
+    if( !valid )
+        return false;
+
+    for( uint32 col = 0; col < cc; ++col )
+        // a column of NULLs only
+        _AddColumn( reader.columnName( col ), DBTYPE_ERROR == types[ col ] ? DBTYPE_I4 : types[ col ] );
+
+    for( cur = reader.begin(); cur != end; ++cur, ++mRowCount )
+    {
+        for( uint32 col = 0; col < cc; ++col )
+        {
+            Column& c = mColumns[ col ];
+            if( cur.IsNone( col ) )
+            {
+                _AddNull( c );
+                continue;
+            }
+
+            switch( cur.GetType( col ) )
+            {
+            case PyRep::PyTypeBool:
+                _AddInt( c, cur.GetBool( col ) ? 1 : 0 );
+                break;
+            case PyRep::PyTypeInt:
+                _AddInt( c, (int32)cur.GetInt( col ) );
+                break;
+            case PyRep::PyTypeLong:
+                _AddInt( c, (int64)cur.GetLong( col ) );
+                break;
+            case PyRep::PyTypeFloat:
+                _AddReal( c, cur.GetFloat( col ) );
+                break;
+            case PyRep::PyTypeString:
+                _AddText( c, cur.GetString( col ) );
+                break;
+            case PyRep::PyTypeWString:
+                _AddText( c, cur.GetWString( col ) );
+                break;
+            default:
+                _AddNull( c );
+                break;
+            }
+        }
+    }
+
+    return true;
+}
+
+#endif /* !__DATABASE__DB_TABLE_H__INCL__ */
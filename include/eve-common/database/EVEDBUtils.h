@@ -61,6 +61,9 @@ void DBResultToIntIntlistDict(DBQueryResult &result, std::map<int32, PyRep *> &i
 PyList *DBResultToPackedRowList(DBQueryResult &result);
 PyTuple *DBResultToPackedRowListTuple(DBQueryResult &result);
 PyObjectEx *DBResultToCRowset(DBQueryResult &result);
+//appends the marshal stream of DBResultToCRowset(result) to the buffer, straight from the rows
+//with no PyRep built (see DBRowsetMarshaler); with a streamed result the rows are never held whole either:
+bool MarshalDBResultToCRowset(DBQueryResult &result, Buffer &into);
 
 PyDict *DBResultToPackedRowDict(DBQueryResult &result, const char *key);
 PyDict *DBResultToPackedRowDict(DBQueryResult &result, uint32 key_index);
@@ -61,6 +61,10 @@ protected:
 
         //convert whatever we have into a string
         std::string GetAsString( size_t index ) const;
+        //append whatever we have to a string, as an SQL literal
+        void AppendAsString( size_t index, std::string& into ) const;
+        //append whatever we have to a string, as a field of LOAD DATA
+        void AppendAsData( size_t index, std::string& into ) const;
 
         const iterator& operator++();
         const iterator& operator++(int) { return ++*this; }
@@ -192,16 +196,26 @@ class SetSQLDumper
 : public PyVisitor
 {
 public:
-    SetSQLDumper( const char* table, const char* keyField, FILE* out );
+    /**
+     * @param[in] table    Name of table to be created.
+     * @param[in] keyField Key field of table.
+     * @param[in] out      Output file.
+     * @param[in] dataFile Name of the LOAD DATA file for the rows; NULL to insert them (see ReaderToSQL).
+     */
+    SetSQLDumper( const char* table, const char* keyField, FILE* out, const char* dataFile = NULL );
 
     bool VisitTuple( const PyTuple* rep );
 
     bool VisitObject( const PyObject* rep );
 
 protected:
+    const char* _dataFile() const { return mDataFile.empty() ? NULL : mDataFile.c_str(); }
+
     const std::string mTable;
     const std::string mKeyField;
     FILE* const mOut;
+    /// Empty if the rows are inserted.
+    const std::string mDataFile;
 };
 
 #endif
@@ -110,13 +110,19 @@ void ClassifyColumnTypes( std::vector<ReaderColumnContentDesc>& into, _Reader& r
 /**
  * @brief Dumps rowset to SQL.
  *
+ * The rows are inserted by queries of up to INSERT_QUERY_ROW_LIMIT
+ * rows each; if a data file is given, they are written into it in
+ * the tab-separated format of LOAD DATA instead, and the SQL only
+ * loads it, which is much faster to import.
+ *
  * @param[in]  table_name Name of table to be created.
  * @param[in]  key_field  Key field of table.
  * @param[out] out        Output file.
  * @param[in]  reader     Rowset reader to use.
+ * @param[in]  data_file  Name of the data file to write the rows into; NULL to insert them.
  */
 template<typename _Reader>
-bool ReaderToSQL( const char* table_name, const char* key_field, FILE* out, _Reader& reader )
+bool ReaderToSQL( const char* table_name, const char* key_field, FILE* out, _Reader& reader, const char* data_file = NULL )
 {
     const size_t cc = reader.columnCount();
 
@@ -173,30 +179,74 @@ bool ReaderToSQL( const char* table_name, const char* key_field, FILE* out, _Rea
              table_name
     );
 
+    FILE* data = NULL;
+    if( NULL != data_file )
+    {
+        data = fopen( data_file, "wb" );
+        if( NULL == data )
+        {
+            sLog.Error( "ReaderToSQL", "Unable to open data file '%s'.", data_file );
+            return false;
+        }
+
+        fprintf( out,
+                 "LOAD DATA LOCAL INFILE '%s' INTO TABLE `%s`(%s)",
+                 data_file,
+                 table_name,
+                 field_list.c_str()
+        );
+    }
+
+    // a row is formatted at once and written by a single call
+    std::string row;
+
     typename _Reader::iterator cur, end;
     cur = reader.begin();
     end = reader.end();
     for( size_t rowIndex = 0; cur != end; ++cur, ++rowIndex )
     {
+        row.clear();
+
+        if( NULL != data )
+        {
+            for( size_t col = 0; col < cc; ++col )
+            {
+                if( col != 0 )
+                    row += '\t';
+
+                cur.AppendAsData( col, row );
+            }
+            row += '\n';
+
+            fwrite( row.data(), 1, row.size(), data );
+            continue;
+        }
+
         if( 0 == ( rowIndex % INSERT_QUERY_ROW_LIMIT ) )
         {
             if( 0 != rowIndex )
-                fprintf( out, ";\n" );
+                row += ";\n";
 
-            fprintf( out, "INSERT INTO `%s`(%s) VALUES ", table_name, field_list.c_str() );
+            row += "INSERT INTO `";
+            row += table_name;
+            row += "`(";
+            row += field_list;
+            row += ") VALUES ";
         }
         else
-            fprintf( out, "," );
+            row += ',';
 
-        fprintf( out, "(" );
+        row += '(';
         for( size_t col = 0; col < cc; ++col )
         {
             if( col != 0 )
-                fprintf( out, "," );
+                row += ',';
 
-            fprintf( out, "%s", cur.GetAsString( col ).c_str() );
+            cur.AppendAsString( col, row );
         }
-        fprintf( out, ")" );
+        row += ')';
+
+        fwrite( row.data(), 1, row.size(), out );
     }
 
     fprintf( out,
@@ -206,6 +256,9 @@ bool ReaderToSQL( const char* table_name, const char* key_field, FILE* out, _Rea
              table_name
     );
 
+    if( NULL != data )
+        fclose( data );
+
     return true;
 }
 
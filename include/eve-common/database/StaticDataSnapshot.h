@@ -0,0 +1,63 @@
+/*
+    ------------------------------------------------------------------------------------
+    LICENSE:
+    ------------------------------------------------------------------------------------
+    This file is part of EVEmu: EVE Online Server Emulator
+    Copyright 2006 - 2011 The EVEmu Team
+    For the latest information visit http://evemu.org
+    ------------------------------------------------------------------------------------
+    This program is free software; you can redistribute it and/or modify it under
+    the terms of the GNU Lesser General Public License as published by the Free Software
+    Foundation; either version 2 of the License, or (at your option) any later
+    version.
+
+    This program is distributed in the hope that it will be useful, but WITHOUT
+    ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+    FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public License along with
+    this program; if not, write to the Free Software Foundation, Inc., 59 Temple
+    Place - Suite 330, Boston, MA 02111-1307, USA, or go to
+    http://www.gnu.org/copyleft/lesser.txt.
+    ------------------------------------------------------------------------------------
+    Author:     EVEmu Team
+*/
+
+#ifndef __DATABASE__STATIC_DATA_SNAPSHOT_H__INCL__
+#define __DATABASE__STATIC_DATA_SNAPSHOT_H__INCL__
+
+/**
+ * @brief A table of the static data snapshot.
+ *
+ * The first column of every table is its key; the rest
+ * are in the order the server decodes them in.
+ */
+struct StaticDataSnapshotTable
+{
+    /// Name of the table in the snapshot.
+    const char* name;
+    /// The query of the rows.
+    const char* query;
+};
+
+/// Names of the tables of the static data snapshot.
+extern const char* const STATIC_SNAPSHOT_CATEGORIES;
+extern const char* const STATIC_SNAPSHOT_GROUPS;
+extern const char* const STATIC_SNAPSHOT_TYPES;
+extern const char* const STATIC_SNAPSHOT_TYPE_ATTRIBUTES;
+
+/// The tables of the static data snapshot.
+extern const StaticDataSnapshotTable STATIC_SNAPSHOT_TABLES[];
+/// Number of the tables of the static data snapshot.
+extern const size_t STATIC_SNAPSHOT_TABLE_COUNT;
+
+/**
+ * @brief Queries all the static inventory data through sDatabase and writes the snapshot.
+ *
+ * @param[in] filename Name of the snapshot file.
+ *
+ * @return True on success, false on failure.
+ */
+bool BuildStaticDataSnapshot( const char* filename );
+
+#endif /* !__DATABASE__STATIC_DATA_SNAPSHOT_H__INCL__ */
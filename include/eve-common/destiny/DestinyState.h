@@ -0,0 +1,138 @@
+/*
+    ------------------------------------------------------------------------------------
+    LICENSE:
+    ------------------------------------------------------------------------------------
+    This file is part of EVEmu: EVE Online Server Emulator
+    Copyright 2006 - 2011 The EVEmu Team
+    For the latest information visit http://evemu.org
+    ------------------------------------------------------------------------------------
+    This program is free software; you can redistribute it and/or modify it under
+    the terms of the GNU Lesser General Public License as published by the Free Software
+    Foundation; either version 2 of the License, or (at your option) any later
+    version.
+
+    This program is distributed in the hope that it will be useful, but WITHOUT
+    ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+    FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public License along with
+    this program; if not, write to the Free Software Foundation, Inc., 59 Temple
+    Place - Suite 330, Boston, MA 02111-1307, USA, or go to
+    http://www.gnu.org/copyleft/lesser.txt.
+    ------------------------------------------------------------------------------------
+    Author:     EVEmu Team
+*/
+
+
+#ifndef __DESTINY__DESTINY_STATE_H__INCL__
+#define __DESTINY__DESTINY_STATE_H__INCL__
+
+#include "destiny/DestinyStructs.h"
+
+namespace Destiny
+{
+    /**
+     * @brief A decoded ball of a Destiny binary.
+     *
+     * @author EVEmu Team
+     */
+    struct Ball
+    {
+        BallHeader head;
+        /// Whether mass is present; it is for all balls but the rigid ones.
+        bool hasMass;
+        MassSector mass;
+        /// Whether ship is present; it is if the ball is free.
+        bool hasShip;
+        ShipSector ship;
+        /// The sector of the mode of the ball.
+        SpecificSectors specific;
+        std::vector< MiniBall > miniBalls;
+        /// The name, in UTF-16.
+        std::vector< uint16 > name;
+    };
+
+    /**
+     * @brief A decoded Destiny binary: a SetState or an AddBalls.
+     *
+     * Decodes the binary into its balls, encodes them back the same way
+     * the entities encode themselves, and compares two of them ball by
+     * ball and field by field.
+     *
+     * @author EVEmu Team
+     */
+    class State
+    {
+    public:
+        State();
+
+        /** @return The header. */
+        const AddBall_header& header() const { return mHeader; }
+        /** @return The balls, in the order of the binary. */
+        const std::vector< Ball >& balls() const { return mBalls; }
+
+        /** @brief Sets the header. */
+        void SetHeader( uint8 packetType, uint32 sequence );
+        /** @brief Appends a ball. */
+        void AddBall( const Ball& ball ) { mBalls.push_back( ball ); }
+        /** @brief Removes the header and all balls. */
+        void clear();
+
+        /**
+         * @brief Decodes a binary.
+         *
+         * @param[in] data The binary.
+         * @param[in] len  Length of the binary.
+         *
+         * @return False if the binary is malformed; the state is cleared then.
+         */
+        bool Decode( const uint8* data, size_t len );
+        /**
+         * @brief Encodes the state.
+         *
+         * @param[out] into The binary is appended here.
+         */
+        void Encode( Buffer& into ) const;
+
+        /**
+         * @brief Logs the differences of two states.
+         *
+         * The balls are matched by entityID; a ball of one state only is
+         * logged as added or removed, a ball in both is compared field
+         * by field.
+         *
+         * @param[in] into   Where to log.
+         * @param[in] before The old state.
+         * @param[in] after  The new state.
+         *
+         * @return Number of differences.
+         */
+        static size_t Diff( LogType into, const State& before, const State& after );
+
+        /**
+         * @return Size of the sector of given mode; 0 if the mode may not be in a binary.
+         */
+        static size_t GetModeSize( uint8 mode );
+
+    protected:
+        /**
+         * @brief Decodes a ball.
+         *
+         * @return Number of bytes used; 0 if the ball is malformed.
+         */
+        static size_t _DecodeBall( const uint8* data, size_t len, Ball& into );
+        /** @brief Encodes a ball. */
+        static void _EncodeBall( const Ball& ball, Buffer& into );
+        /**
+         * @brief Logs the differences of two balls.
+         *
+         * @return Number of differences.
+         */
+        static size_t _DiffBall( LogType into, const Ball& before, const Ball& after );
+
+        AddBall_header mHeader;
+        std::vector< Ball > mBalls;
+    };
+}
+
+#endif /* !__DESTINY__DESTINY_STATE_H__INCL__ */
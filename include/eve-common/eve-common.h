@@ -40,15 +40,25 @@
 #include "network/Socket.h"
 #include "network/StreamPacketizer.h"
 #include "network/TCPConnection.h"
+#include "network/TCPReactor.h"
 #include "network/TCPServer.h"
 // utils
 #include "utils/Buffer.h"
+#include "utils/CallTracer.h"
 #include "utils/crc32.h"
 #include "utils/Deflate.h"
+#include "utils/MappedFile.h"
+#include "utils/MemoryTag.h"
+#include "utils/Metrics.h"
 #include "utils/misc.h"
+#include "utils/ObjectPool.h"
+#include "utils/PerfectHash.h"
 #include "utils/RefPtr.h"
 #include "utils/Singleton.h"
+#include "utils/SizeClassPool.h"
 #include "utils/timer.h"
+#include "utils/TickProfiler.h"
+#include "utils/TimerWheel.h"
 #include "utils/utils_hex.h"
 #include "utils/utils_string.h"
 #include "utils/utils_time.h"
@@ -29,6 +29,9 @@
 #include "marshal/EVEMarshalOpcodes.h"
 #include "python/PyVisitor.h"
 
+class DBRowDescriptor;
+class DeflateStream;
+
 /*
  * @brief Marshal Stream builder.
  *
@@ -45,37 +48,197 @@ extern bool Marshal( const PyRep* rep, Buffer& into );
  * @param[in]  rep            Python object to marshal.
  * @param[out] into           Buffer which receives deflated marshaled stream.
  * @param[in]  deflationLimit The least size of buffer which gets deflated.
+ * @param[in]  level          Compression level (0-9 or Z_DEFAULT_COMPRESSION).
+ * @param[out] marshaledSize  If not NULL, receives size of the stream before deflation.
  *
  * @retval true  Marshaling ran successfully.
  * @retval false Error occured during marshaling.
  */
-extern bool MarshalDeflate( const PyRep* rep, Buffer& into, const uint32 deflationLimit = 0x2000 );
+extern bool MarshalDeflate( const PyRep* rep, Buffer& into, const uint32 deflationLimit = 0x2000, int level = Z_DEFAULT_COMPRESSION, size_t* marshaledSize = NULL );
 
 /**
  * @brief Turns Python objects into marshal bytecode.
  *
+ * Saving is done in two passes over the object: the first one runs
+ * without any buffer and only counts the bytes, so the target buffer
+ * can be reserved at once; the second one fills it. Sub-streams which
+ * have not been encoded yet are encoded in place, using the sizes
+ * counted by the first pass.
+ *
+ * Streams which get deflated are handed over to the compressor in
+ * chunks while they are being saved, so they are never held whole.
+ *
+ * Reps are dispatched on their type tag rather than through
+ * PyRep::visit(): the common leaves are saved without any virtual call,
+ * the rest through their (virtual) Visit* method, so subclasses may
+ * still hook containers.
+ *
  * @author Captnoord, Bloody.Rabbit
  */
 class MarshalStream
 : protected PyVisitor
 {
 public:
-    /** initializes object */
-    MarshalStream();
+    /**
+     * @brief Initializes object.
+     *
+     * @param[in] tagDispatch Whether to dispatch on the type tag; if false,
+     *                        every rep goes through PyRep::visit() (for
+     *                        comparison only).
+     */
+    MarshalStream( bool tagDispatch = true );
 
     /** saves given rep to given buffer */
     bool Save( const PyRep* rep, Buffer& into );
+    /**
+     * @brief Saves given rep, deflating it if it is big enough.
+     *
+     * @param[in]  rep            Python object to marshal.
+     * @param[out] into           Buffer which receives the (deflated) stream.
+     * @param[in]  deflationLimit The least size of stream which gets deflated.
+     * @param[in]  level          Compression level (0-9 or Z_DEFAULT_COMPRESSION).
+     * @param[out] marshaledSize  If not NULL, receives size of the stream before deflation.
+     *
+     * @retval true  Marshaling ran successfully.
+     * @retval false Error occured during marshaling or deflation.
+     */
+    bool SaveDeflated( const PyRep* rep, Buffer& into, uint32 deflationLimit, int level, size_t* marshaledSize = NULL );
+
+    /**
+     * @brief Appends given rep alone, without the stream header.
+     *
+     * Lets a stream be built piece by piece, e.g. the items of a list
+     * saved empty (what goes around them is up to the caller).
+     *
+     * @param[in]  rep  Python object to marshal.
+     * @param[out] into Buffer which receives the marshaled rep.
+     *
+     * @retval true  Marshaling ran successfully.
+     * @retval false Error occured during marshaling.
+     */
+    bool SaveItem( const PyRep* rep, Buffer& into );
+
+    /**
+     * @brief Computes length of marshaled stream.
+     *
+     * @param[in]  rep  Python object to measure.
+     * @param[out] size Exact length (in bytes) Save() would append.
+     *
+     * @retval true  Measuring ran successfully.
+     * @retval false Error occured during measuring.
+     */
+    bool CalcSize( const PyRep* rep, size_t& size );
+
+    /**
+     * @brief Saves an object which writes itself into the stream.
+     *
+     * The object is written by its EncodeTo( MarshalStream& ) method
+     * (see eve-xmlpktgen), which calls the Save* methods below; it is
+     * called twice, the same way Save() walks a rep twice.
+     *
+     * @param[in]  obj  Object to marshal.
+     * @param[out] into Buffer which receives marshaled stream.
+     *
+     * @retval true  Marshaling ran successfully.
+     * @retval false Error occured during marshaling.
+     */
+    template<typename T>
+    bool SaveEncoded( const T& obj, Buffer& into )
+    {
+        BeginCount();
+        if( !obj.EncodeTo( *this ) )
+            return false;
+
+        const size_t start = BeginFill( into );
+        const bool res = obj.EncodeTo( *this );
+        return EndFill( into, start, res );
+    }
+
+    /** adds given rep to the stream, dispatching on its type tag */
+    bool SaveRep( const PyRep* rep );
+
+    /* The methods below write the same opcodes the reps would; they
+       let generated code write its fields without building the reps. */
+
+    /** adds an integer, like a PyInt would */
+    void SaveInt( int32 val );
+    /** adds a long, like a PyLong would */
+    void SaveLong( int64 val );
+    /** adds a real, like a PyFloat would */
+    void SaveReal( double val );
+    /** adds a boolean */
+    void SaveBool( bool val ) { Put<uint8>( val ? Op_PyTrue : Op_PyFalse ); }
+    /** adds a None */
+    void SaveNone() { Put<uint8>( Op_PyNone ); }
+    /** adds a buffer */
+    void SaveBuffer( const uint8* data, size_t len );
+    /**
+     * @brief Adds a string.
+     *
+     * @param[in] str        The string.
+     * @param[in] len        Length of the string.
+     * @param[in] tableIndex Index of the string in the string table; STRING_TABLE_ERROR if not present.
+     */
+    void SaveString( const char* str, size_t len, uint8 tableIndex );
+    /** adds a string, looking it up in the string table */
+    void SaveString( const std::string& str );
+    /** adds a wide string, given in UTF-8 */
+    void SaveWString( const char* str, size_t len );
+    void SaveWString( const std::string& str ) { SaveWString( str.c_str(), str.size() ); }
+    /** adds a token */
+    void SaveToken( const char* str, size_t len );
+
+    /** starts a tuple of given size; the items follow */
+    void SaveTupleHeader( uint32 size );
+    /** starts a list of given size; the items follow */
+    void SaveListHeader( uint32 size );
+    /** starts a dict of given size; the pairs follow, value first */
+    void SaveDictHeader( uint32 size );
+    /** starts an object; the type and the arguments follow */
+    void SaveObjectHeader() { Put<uint8>( Op_PyObject ); }
+    /** starts a sub-structure; the structure follows */
+    void SaveSubStructHeader() { Put<uint8>( Op_PySubStruct ); }
+
+    /**
+     * @brief Starts a sub-stream; the streamed rep follows.
+     *
+     * @return Value to pass to EndSubStream().
+     */
+    size_t BeginSubStream();
+    /**
+     * @brief Ends a sub-stream.
+     *
+     * @param[in] token Value BeginSubStream() returned.
+     */
+    void EndSubStream( size_t token );
 
 protected:
+    /** @return True during the counting pass of Save(). */
+    bool IsCounting() const { return NULL == mBuffer; }
+
     /** saves new stream with given rep. */
     bool SaveStream( const PyRep* rep );
+    /** adds the header of a stream */
+    void SaveStreamHeader();
 
     /** adds given value to the data stream */
     template<typename T>
-    void Put( const T& value ) { mBuffer->Append<T>( value ); }
+    void Put( const T& value )
+    {
+        if( NULL != mBuffer )
+            mBuffer->Append<T>( value );
+        else
+            mSize += sizeof( T );
+    }
     /** adds given bytes to the data stream */
     template<typename Iter>
-    void Put( Iter first, Iter last ) { mBuffer->AppendSeq<Iter>( first, last ); }
+    void Put( Iter first, Iter last )
+    {
+        if( NULL != mBuffer )
+            mBuffer->AppendSeq<Iter>( first, last );
+        else
+            mSize += ( last - first ) * sizeof( typename std::iterator_traits< Iter >::value_type );
+    }
 
     /** utility for extended size. */
     void PutSizeEx( uint32 size )
@@ -138,12 +301,57 @@ protected:
     bool VisitChecksumedStream( const PyChecksumedStream* rep );
 
 private:
+    // starts the counting pass of SaveEncoded() and adds the stream header
+    void BeginCount();
+    // starts the second pass of SaveEncoded() and adds the stream header; returns the start of the stream
+    size_t BeginFill( Buffer& into );
+    // ends the second pass of SaveEncoded()
+    bool EndFill( Buffer& into, size_t start, bool res );
+
+    // runs the second pass of Save(), the first one counted size bytes
+    bool SaveCounted( const PyRep* rep, Buffer& into, size_t size );
+    // runs the second pass of SaveDeflated(), the first one counted size bytes
+    bool SaveCounted( const PyRep* rep, DeflateStream& into, size_t size );
+    // hands the buffer over to the compressor if there is enough in it
+    void FlushDeflate();
+
     // utility to handle Op_PyVarInteger (a bit hacky......)
-    void SaveVarInteger( const PyLong* v );
-    // zero-compresses given buffer and adds it to the stream
-    bool SaveZeroCompressed( const Buffer& data );
+    void SaveVarInteger( int64 val );
+    // zero-compresses given bytes and adds them to the stream
+    bool SaveZeroCompressed( const uint8* data, size_t len );
+    // prepares the column layout of packed rows with given header
+    void SetRowHeader( const DBRowDescriptor* header );
+
+    /// Whether SaveRep() dispatches on the type tag.
+    const bool mTagDispatch;
 
+    /// The buffer being filled; NULL while counting.
     Buffer* mBuffer;
+    /// The count of bytes while counting.
+    size_t mSize;
+
+    /// The compressor the buffer is flushed to; NULL if not deflating.
+    DeflateStream* mDeflate;
+    /// The count of bytes flushed to the compressor.
+    size_t mFlushed;
+
+    /// Lengths of sub-streams to be encoded in place, in the order of saving.
+    std::vector<size_t> mSubStreamSizes;
+    /// Index of the next sub-stream length to use.
+    size_t mSubStreamIndex;
+
+    /// Column types of the header the row layout below belongs to.
+    std::vector<DBTYPE> mRowHeaderTypes;
+    /// Indexes of the columns in the order of saving.
+    std::vector<uint32> mRowColumns;
+    /// Types of the columns, in the same order.
+    std::vector<DBTYPE> mRowTypes;
+    /// Number of the columns of the fixed-size and of the boolean part.
+    size_t mRowFixedCount, mRowBoolCount;
+    /// Length (in bytes) of the unpacked fixed-size and boolean part.
+    size_t mRowDataSize;
+    /// Scratch space for the unpacked part.
+    std::vector<uint8> mRowData;
 };
 
 #endif
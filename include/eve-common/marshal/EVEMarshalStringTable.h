@@ -58,6 +58,15 @@ public:
      * @return the index number of the string that was given; STRING_TABLE_ERROR if string is not found.
      */
     uint8 LookupIndex( const std::string& str );
+    /**
+     * @brief lookup a index nr using a string
+     *
+     * @param[in] str string that needs a lookup for a index nr.
+     * @param[in] len length of the string.
+     *
+     * @return the index number of the string that was given; STRING_TABLE_ERROR if string is not found.
+     */
+    uint8 LookupIndex( const char* str, size_t len );
 
     /**
     * @brief lookup a index nr using a string
@@ -101,6 +110,8 @@ private:
     typedef StringTableMap::const_iterator          StringTableMapConstItr;
 
     StringTableMap  mStringTableMap;
+    /* length of the longest string in the table; longer ones are not looked up at all */
+    size_t          mMaxLength;
 
     /* we made up this list so we have efficient string communication with the client */
     static const char* const s_mStringTable[];
@@ -112,6 +123,41 @@ private:
 #define sMarshalStringTable \
     ( MarshalStringTable::get() )
 
+/**
+ * @brief String constant with its string table index resolved up front.
+ *
+ * Meant to be a static object, so the table is searched once for
+ * the constant rather than every time a PyString of it is marshaled:
+ *
+ * @code
+ * static const MarshalStringToken type( "util.Rowset" );
+ * PyString* str = new PyString( type );
+ * @endcode
+ *
+ * @author EVEmu Team
+ */
+class MarshalStringToken
+{
+public:
+    /**
+     * @param[in] str The constant; must outlive the token.
+     */
+    MarshalStringToken( const char* str )
+    : mString( str ),
+      mIndex( sMarshalStringTable.LookupIndex( str ) )
+    {
+    }
+
+    /** @return The string. */
+    const char* c_str() const { return mString; }
+    /** @return Index of the string in the table; STRING_TABLE_ERROR if not present. */
+    uint8 index() const { return mIndex; }
+
+private:
+    const char* const mString;
+    const uint8 mIndex;
+};
+
 #endif /* !__EVE_MARSHAL_STRING_TABLE_H__INCL__ */
 
 
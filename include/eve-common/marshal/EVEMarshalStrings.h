@@ -0,0 +1,199 @@
+//no macroguard on purpose
+//the strings of the marshal string table, in the order of their indexes (counted from 1);
+//the client has the same table, so the list must not be reordered
+
+MARSHAL_STRING( "*corpid" )
+MARSHAL_STRING( "*locationid" )
+MARSHAL_STRING( "age" )
+MARSHAL_STRING( "Asteroid" )
+MARSHAL_STRING( "authentication" )
+MARSHAL_STRING( "ballID" )
+MARSHAL_STRING( "beyonce" )
+MARSHAL_STRING( "bloodlineID" )
+MARSHAL_STRING( "capacity" )
+MARSHAL_STRING( "categoryID" )
+MARSHAL_STRING( "character" )
+MARSHAL_STRING( "characterID" )
+MARSHAL_STRING( "characterName" )
+MARSHAL_STRING( "characterType" )
+MARSHAL_STRING( "charID" )
+MARSHAL_STRING( "chatx" )
+MARSHAL_STRING( "clientID" )
+MARSHAL_STRING( "config" )
+MARSHAL_STRING( "contraband" )
+MARSHAL_STRING( "corporationDateTime" )
+MARSHAL_STRING( "corporationID" )
+MARSHAL_STRING( "createDateTime" )
+MARSHAL_STRING( "customInfo" )
+MARSHAL_STRING( "description" )
+MARSHAL_STRING( "divisionID" )
+MARSHAL_STRING( "DoDestinyUpdate" )
+MARSHAL_STRING( "dogmaIM" )
+MARSHAL_STRING( "EVE System" )
+MARSHAL_STRING( "flag" )
+MARSHAL_STRING( "foo.SlimItem" )
+MARSHAL_STRING( "gangID" )
+MARSHAL_STRING( "Gemini" )
+MARSHAL_STRING( "gender" )
+MARSHAL_STRING( "graphicID" )
+MARSHAL_STRING( "groupID" )
+MARSHAL_STRING( "header" )
+MARSHAL_STRING( "idName" )
+MARSHAL_STRING( "invbroker" )
+MARSHAL_STRING( "itemID" )
+MARSHAL_STRING( "items" )
+MARSHAL_STRING( "jumps" )
+MARSHAL_STRING( "line" )
+MARSHAL_STRING( "lines" )
+MARSHAL_STRING( "locationID" )
+MARSHAL_STRING( "locationName" )
+MARSHAL_STRING( "macho.CallReq" )
+MARSHAL_STRING( "macho.CallRsp" )
+MARSHAL_STRING( "macho.MachoAddress" )
+MARSHAL_STRING( "macho.Notification" )
+MARSHAL_STRING( "macho.SessionChangeNotification" )
+MARSHAL_STRING( "modules" )
+MARSHAL_STRING( "name" )
+MARSHAL_STRING( "objectCaching" )
+MARSHAL_STRING( "objectCaching.CachedObject" )
+MARSHAL_STRING( "OnChatJoin" )
+MARSHAL_STRING( "OnChatLeave" )
+MARSHAL_STRING( "OnChatSpeak" )
+MARSHAL_STRING( "OnGodmaShipEffect" )
+MARSHAL_STRING( "OnItemChange" )
+MARSHAL_STRING( "OnModuleAttributeChange" )
+MARSHAL_STRING( "OnMultiEvent" )
+MARSHAL_STRING( "orbitID" )
+MARSHAL_STRING( "ownerID" )
+MARSHAL_STRING( "ownerName" )
+MARSHAL_STRING( "quantity" )
+MARSHAL_STRING( "raceID" )
+MARSHAL_STRING( "RowClass" )
+MARSHAL_STRING( "securityStatus" )
+MARSHAL_STRING( "Sentry Gun" )
+MARSHAL_STRING( "sessionchange" )
+MARSHAL_STRING( "singleton" )
+MARSHAL_STRING( "skillEffect" )
+MARSHAL_STRING( "squadronID" )
+MARSHAL_STRING( "typeID" )
+MARSHAL_STRING( "used" )
+MARSHAL_STRING( "userID" )
+MARSHAL_STRING( "util.CachedObject" )
+MARSHAL_STRING( "util.IndexRowset" )
+MARSHAL_STRING( "util.Moniker" )
+MARSHAL_STRING( "util.Row" )
+MARSHAL_STRING( "util.Rowset" )
+MARSHAL_STRING( "*multicastID" )
+MARSHAL_STRING( "AddBalls" )
+MARSHAL_STRING( "AttackHit3" )
+MARSHAL_STRING( "AttackHit3R" )
+MARSHAL_STRING( "AttackHit4R" )
+MARSHAL_STRING( "DoDestinyUpdates" )
+MARSHAL_STRING( "GetLocationsEx" )
+MARSHAL_STRING( "InvalidateCachedObjects" )
+MARSHAL_STRING( "JoinChannel" )
+MARSHAL_STRING( "LSC" )
+MARSHAL_STRING( "LaunchMissile" )
+MARSHAL_STRING( "LeaveChannel" )
+MARSHAL_STRING( "OID+" )
+MARSHAL_STRING( "OID-" )
+MARSHAL_STRING( "OnAggressionChange" )
+MARSHAL_STRING( "OnCharGangChange" )
+MARSHAL_STRING( "OnCharNoLongerInStation" )
+MARSHAL_STRING( "OnCharNowInStation" )
+MARSHAL_STRING( "OnDamageMessage" )
+MARSHAL_STRING( "OnDamageStateChange" )
+MARSHAL_STRING( "OnEffectHit" )
+MARSHAL_STRING( "OnGangDamageStateChange" )
+MARSHAL_STRING( "OnLSC" )
+MARSHAL_STRING( "OnSpecialFX" )
+MARSHAL_STRING( "OnTarget" )
+MARSHAL_STRING( "RemoveBalls" )
+MARSHAL_STRING( "SendMessage" )
+MARSHAL_STRING( "SetMaxSpeed" )
+MARSHAL_STRING( "SetSpeedFraction" )
+MARSHAL_STRING( "TerminalExplosion" )
+MARSHAL_STRING( "address" )
+MARSHAL_STRING( "alert" )
+MARSHAL_STRING( "allianceID" )
+MARSHAL_STRING( "allianceid" )
+MARSHAL_STRING( "bid" )
+MARSHAL_STRING( "bookmark" )
+MARSHAL_STRING( "bounty" )
+MARSHAL_STRING( "channel" )
+MARSHAL_STRING( "charid" )
+MARSHAL_STRING( "constellationid" )
+MARSHAL_STRING( "corpID" )
+MARSHAL_STRING( "corpid" )
+MARSHAL_STRING( "corprole" )
+MARSHAL_STRING( "damage" )
+MARSHAL_STRING( "duration" )
+MARSHAL_STRING( "effects.Laser" )
+MARSHAL_STRING( "gangid" )
+MARSHAL_STRING( "gangrole" )
+MARSHAL_STRING( "hqID" )
+MARSHAL_STRING( "issued" )
+MARSHAL_STRING( "jit" )
+MARSHAL_STRING( "languageID" )
+MARSHAL_STRING( "locationid" )
+MARSHAL_STRING( "machoVersion" )
+MARSHAL_STRING( "marketProxy" )
+MARSHAL_STRING( "minVolume" )
+MARSHAL_STRING( "orderID" )
+MARSHAL_STRING( "price" )
+MARSHAL_STRING( "range" )
+MARSHAL_STRING( "regionID" )
+MARSHAL_STRING( "regionid" )
+MARSHAL_STRING( "role" )
+MARSHAL_STRING( "rolesAtAll" )
+MARSHAL_STRING( "rolesAtBase" )
+MARSHAL_STRING( "rolesAtHQ" )
+MARSHAL_STRING( "rolesAtOther" )
+MARSHAL_STRING( "shipid" )
+MARSHAL_STRING( "sn" )
+MARSHAL_STRING( "solarSystemID" )
+MARSHAL_STRING( "solarsystemid" )
+MARSHAL_STRING( "solarsystemid2" )
+MARSHAL_STRING( "source" )
+MARSHAL_STRING( "splash" )
+MARSHAL_STRING( "stationID" )
+MARSHAL_STRING( "stationid" )
+MARSHAL_STRING( "target" )
+MARSHAL_STRING( "userType" )
+MARSHAL_STRING( "userid" )
+MARSHAL_STRING( "volEntered" )
+MARSHAL_STRING( "volRemaining" )
+MARSHAL_STRING( "weapon" )
+MARSHAL_STRING( "agent.missionTemplatizedContent_BasicKillMission" )
+MARSHAL_STRING( "agent.missionTemplatizedContent_ResearchKillMission" )
+MARSHAL_STRING( "agent.missionTemplatizedContent_StorylineKillMission" )
+MARSHAL_STRING( "agent.missionTemplatizedContent_GenericStorylineKillMission" )
+MARSHAL_STRING( "agent.missionTemplatizedContent_BasicCourierMission" )
+MARSHAL_STRING( "agent.missionTemplatizedContent_ResearchCourierMission" )
+MARSHAL_STRING( "agent.missionTemplatizedContent_StorylineCourierMission" )
+MARSHAL_STRING( "agent.missionTemplatizedContent_GenericStorylineCourierMission" )
+MARSHAL_STRING( "agent.missionTemplatizedContent_BasicTradeMission" )
+MARSHAL_STRING( "agent.missionTemplatizedContent_ResearchTradeMission" )
+MARSHAL_STRING( "agent.missionTemplatizedContent_StorylineTradeMission" )
+MARSHAL_STRING( "agent.missionTemplatizedContent_GenericStorylineTradeMission" )
+MARSHAL_STRING( "agent.offerTemplatizedContent_BasicExchangeOffer" )
+MARSHAL_STRING( "agent.offerTemplatizedContent_BasicExchangeOffer_ContrabandDemand" )
+MARSHAL_STRING( "agent.offerTemplatizedContent_BasicExchangeOffer_Crafting" )
+MARSHAL_STRING( "agent.LoyaltyPoints" )
+MARSHAL_STRING( "agent.ResearchPoints" )
+MARSHAL_STRING( "agent.Credits" )
+MARSHAL_STRING( "agent.Item" )
+MARSHAL_STRING( "agent.Entity" )
+MARSHAL_STRING( "agent.Objective" )
+MARSHAL_STRING( "agent.FetchObjective" )
+MARSHAL_STRING( "agent.EncounterObjective" )
+MARSHAL_STRING( "agent.DungeonObjective" )
+MARSHAL_STRING( "agent.TransportObjective" )
+MARSHAL_STRING( "agent.Reward" )
+MARSHAL_STRING( "agent.TimeBonusReward" )
+MARSHAL_STRING( "agent.MissionReferral" )
+MARSHAL_STRING( "agent.Location" )
+MARSHAL_STRING( "agent.StandardMissionDetails" )
+MARSHAL_STRING( "agent.OfferDetails" )
+MARSHAL_STRING( "agent.ResearchMissionDetails" )
+MARSHAL_STRING( "agent.StorylineMissionDetails" )
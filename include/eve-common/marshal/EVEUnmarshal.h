@@ -27,6 +27,7 @@
 #define EVE_UNMARSHAL_H
 
 #include "python/PyRep.h"
+#include "python/PyStatic.h"
 
 /**
  * @brief Turns marshal stream into Python object.
@@ -39,11 +40,12 @@ extern PyRep* Unmarshal( const Buffer& data );
 /**
  * @brief Turns possibly inflated marshal stream into Python object.
  *
- * @param[in] data Possibly inflated marshal stream.
+ * @param[in]  data         Possibly inflated marshal stream.
+ * @param[out] inflatedSize If not NULL, receives size of the stream after inflation.
  *
  * @return Ownership of Python object.
 */
-extern PyRep* InflateUnmarshal( const Buffer& data );
+extern PyRep* InflateUnmarshal( const Buffer& data, size_t* inflatedSize = NULL );
 
 /**
  * @brief Class which turns marshal bytecode into Python object.
@@ -139,29 +141,29 @@ protected:
 
 private:
     /** Loads none from stream. */
-    PyRep* LoadNone() { return new PyNone; }
+    PyRep* LoadNone() { return PyStatic::NewNone(); }
 
     /** Loads true boolean from stream. */
-    PyRep* LoadBoolTrue() { return new PyBool( true ); }
+    PyRep* LoadBoolTrue() { return PyStatic::NewBool( true ); }
     /** Loads false boolean from stream. */
-    PyRep* LoadBoolFalse() { return new PyBool( false ); }
+    PyRep* LoadBoolFalse() { return PyStatic::NewBool( false ); }
 
     /** Loads long long integer from stream. */
     PyRep* LoadIntegerLongLong() { return new PyLong( Read<int64>() ); }
     /** Loads long integer from stream. */
-    PyRep* LoadIntegerLong() { return new PyInt( Read<int32>() ); }
+    PyRep* LoadIntegerLong() { return PyStatic::NewInt( Read<int32>() ); }
     /** Loads signed short from stream. */
-    PyRep* LoadIntegerSignedShort() { return new PyInt( Read<int16>() ); }
+    PyRep* LoadIntegerSignedShort() { return PyStatic::NewInt( Read<int16>() ); }
     /** Loads byte integer from stream. */
-    PyRep* LoadIntegerByte() { return new PyInt( Read<int8>() ); }
+    PyRep* LoadIntegerByte() { return PyStatic::NewInt( Read<int8>() ); }
     /** Loads variable length integer from stream. */
     PyRep* LoadIntegerVar();
     /** Loads minus one integer from stream. */
-    PyRep* LoadIntegerMinusOne() { return new PyInt( -1 ); }
+    PyRep* LoadIntegerMinusOne() { return PyStatic::NewInt( -1 ); }
     /** Loads zero integer from stream. */
-    PyRep* LoadIntegerZero() { return new PyInt( 0 ); }
+    PyRep* LoadIntegerZero() { return PyStatic::NewInt( 0 ); }
     /** Loads one integer from stream. */
-    PyRep* LoadIntegerOne() { return new PyInt( 1 ); }
+    PyRep* LoadIntegerOne() { return PyStatic::NewInt( 1 ); }
 
     /** Loads real from stream. */
     PyRep* LoadReal() { return new PyFloat( Read<double>() ); }
@@ -169,7 +171,7 @@ private:
     PyRep* LoadRealZero() { return new PyFloat( 0.0 ); }
 
     /** Loads empty string from stream. */
-    PyRep* LoadStringEmpty() { return new PyString( "" ); }
+    PyRep* LoadStringEmpty() { return PyStatic::NewString( "", 0 ); }
     /** Loads single character string from stream. */
     PyRep* LoadStringChar();
     /** Loads short (up to 255 chars) string from stream. */
@@ -195,7 +197,7 @@ private:
     PyRep* LoadBuffer();
 
     /** Loads empty tuple from stream. */
-    PyRep* LoadTupleEmpty() { return new PyTuple( 0 ); }
+    PyRep* LoadTupleEmpty() { return PyStatic::NewEmptyTuple(); }
     /** Loads tuple from stream. */
     PyRep* LoadTuple();
     /** Loads one-element tuple from stream. */
@@ -0,0 +1,96 @@
+/*
+    ------------------------------------------------------------------------------------
+    LICENSE:
+    ------------------------------------------------------------------------------------
+    This file is part of EVEmu: EVE Online Server Emulator
+    Copyright 2006 - 2011 The EVEmu Team
+    For the latest information visit http://evemu.org
+    ------------------------------------------------------------------------------------
+    This program is free software; you can redistribute it and/or modify it under
+    the terms of the GNU Lesser General Public License as published by the Free Software
+    Foundation; either version 2 of the License, or (at your option) any later
+    version.
+
+    This program is distributed in the hope that it will be useful, but WITHOUT
+    ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+    FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public License along with
+    this program; if not, write to the Free Software Foundation, Inc., 59 Temple
+    Place - Suite 330, Boston, MA 02111-1307, USA, or go to
+    http://www.gnu.org/copyleft/lesser.txt.
+    ------------------------------------------------------------------------------------
+    Author:     EVEmu Team
+*/
+
+#ifndef __EVE_ZERO_COMPRESS_H__INCL__
+#define __EVE_ZERO_COMPRESS_H__INCL__
+
+/** Number of bytes past the compressed data ZeroCompress() may write to. */
+static const size_t ZERO_COMPRESS_SLACK = 8;
+
+/**
+ * @brief Zero-compresses data.
+ *
+ * Used for the bodies of packed rows. Each opcode byte describes two
+ * parts, each part is either a run of up to 8 zero bytes or up to 8
+ * literal bytes which follow the opcode.
+ *
+ * The data is scanned 64 bytes at a time with SSE2 or NEON where
+ * available, a 64-bit word at a time otherwise; the output is the same.
+ *
+ * @param[in]  data The data to compress.
+ * @param[in]  len  Length of the data.
+ * @param[out] out  Where to write the compressed data, with room for
+ *                  ZERO_COMPRESS_SLACK more bytes, which may get
+ *                  overwritten; only the length is counted if NULL.
+ *
+ * @return Length of the compressed data.
+ */
+extern size_t ZeroCompress( const uint8* data, size_t len, uint8* out );
+
+/**
+ * @brief Computes the greatest length of zero-compressed data.
+ *
+ * Every opcode but the last one covers at least two bytes.
+ *
+ * @param[in] len Length of the data.
+ *
+ * @return Upper bound of the ZeroCompress() result.
+ */
+inline size_t ZeroCompressBound( size_t len ) { return len + ( len + 1 ) / 2; }
+
+/**
+ * @brief Zero-compresses data to the end of a buffer, behind its length.
+ *
+ * The length is encoded like sizes in marshal streams (one byte, or 0xFF
+ * and four bytes). The data is compressed straight into the buffer
+ * behind room for the longest length, so it is scanned only once; the
+ * buffer grows by up to 5 + ZeroCompressBound( len ) + ZERO_COMPRESS_SLACK
+ * bytes meanwhile.
+ *
+ * @param[in]  data The data to compress.
+ * @param[in]  len  Length of the data.
+ * @param[out] into Buffer to append the length and compressed data to.
+ */
+extern void ZeroCompressSized( const uint8* data, size_t len, Buffer& into );
+
+/**
+ * @brief Computes length of zero-uncompressed data.
+ *
+ * @param[in] data The compressed data.
+ * @param[in] len  Length of the compressed data.
+ *
+ * @return Length of the uncompressed data.
+ */
+extern size_t ZeroUncompressedSize( const uint8* data, size_t len );
+/**
+ * @brief Zero-uncompresses data.
+ *
+ * @param[in]  data The compressed data.
+ * @param[in]  len  Length of the compressed data.
+ * @param[out] into Buffer to append the uncompressed data to.
+ */
+extern void ZeroUncompress( const uint8* data, size_t len, Buffer& into );
+
+#endif /* !__EVE_ZERO_COMPRESS_H__INCL__ */
@@ -0,0 +1,144 @@
+/*
+    ------------------------------------------------------------------------------------
+    LICENSE:
+    ------------------------------------------------------------------------------------
+    This file is part of EVEmu: EVE Online Server Emulator
+    Copyright 2006 - 2011 The EVEmu Team
+    For the latest information visit http://evemu.org
+    ------------------------------------------------------------------------------------
+    This program is free software; you can redistribute it and/or modify it under
+    the terms of the GNU Lesser General Public License as published by the Free Software
+    Foundation; either version 2 of the License, or (at your option) any later
+    version.
+
+    This program is distributed in the hope that it will be useful, but WITHOUT
+    ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+    FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public License along with
+    this program; if not, write to the Free Software Foundation, Inc., 59 Temple
+    Place - Suite 330, Boston, MA 02111-1307, USA, or go to
+    http://www.gnu.org/copyleft/lesser.txt.
+    ------------------------------------------------------------------------------------
+    Author:     EVEmu Team
+*/
+
+#ifndef __NETWORK__EVE_ENCODER_POOL_H__INCL__
+#define __NETWORK__EVE_ENCODER_POOL_H__INCL__
+
+#include "threading/Event.h"
+#include "threading/Mutex.h"
+#include "utils/Singleton.h"
+
+class PyRep;
+class EVETCPConnection;
+
+/**
+ * @brief Pool of threads marshaling and deflating outbound packets.
+ *
+ * EVETCPConnection::QueueRep() hands the PyRep over to the pool instead
+ * of encoding it on the game thread. A connection is processed by at
+ * most one worker at a time, so its packets keep their order.
+ *
+ * Reference counting of PyReps is not thread-safe, hence the workers
+ * never touch it: encoded PyReps are collected and released by the
+ * game thread in Process(). Frozen PyReps (see PyRep::Freeze()) are
+ * released by the workers right away.
+ *
+ * @author EVEmu Team
+ */
+class EVEEncoderPool
+: public Singleton< EVEEncoderPool >
+{
+public:
+    /**
+     * @brief Creates pool with no threads running.
+     */
+    EVEEncoderPool();
+    /**
+     * @brief Stops all threads.
+     */
+    ~EVEEncoderPool();
+
+    /** @return True if there are encoder threads running. */
+    bool IsRunning() const { return mRunning; }
+
+    /**
+     * @brief Starts the encoder threads.
+     *
+     * Does nothing if the pool is running already or
+     * @a threadCount is 0 (packets are then encoded
+     * synchronously by the calling thread).
+     *
+     * @param[in] threadCount Number of threads to start.
+     */
+    void Start( uint32 threadCount );
+    /**
+     * @brief Encodes everything pending and stops all threads.
+     */
+    void Stop();
+
+    /**
+     * @brief Releases PyReps the workers are done with.
+     *
+     * Must be called periodically by the game thread.
+     */
+    void Process();
+
+    /**
+     * @brief Schedules a connection which has PyReps waiting to be encoded.
+     *
+     * @param[in] con The connection.
+     */
+    void Submit( EVETCPConnection* con );
+    /**
+     * @brief Unschedules a connection and waits until no worker uses it.
+     *
+     * @param[in] con The connection.
+     */
+    void Cancel( EVETCPConnection* con );
+    /**
+     * @brief Hands an encoded PyRep back for release by the game thread.
+     *
+     * A frozen PyRep is released immediately.
+     *
+     * @param[in] rep The PyRep.
+     */
+    void Release( const PyRep* rep );
+
+protected:
+    void Run();
+
+#ifdef WIN32
+    static DWORD WINAPI WorkerLoop( LPVOID arg );
+#else /* !WIN32 */
+    static void* WorkerLoop( void* arg );
+#endif /* !WIN32 */
+
+    /// Protects the queues below.
+    Mutex mMQueue;
+    /// Connections waiting for a worker.
+    std::deque<EVETCPConnection*> mQueue;
+    /// Connections being processed right now.
+    std::multiset<EVETCPConnection*> mInFlight;
+    /// PyReps waiting to be released.
+    std::vector<const PyRep*> mReleased;
+
+    /// Signaled when there is work (or the pool is stopping).
+    Event mWork;
+    /// Cleared when the workers should stop.
+    volatile bool mRunning;
+
+    /// The worker threads.
+#ifdef WIN32
+    std::vector<HANDLE> mThreads;
+#else /* !WIN32 */
+    std::vector<pthread_t> mThreads;
+#endif /* !WIN32 */
+};
+
+/// A macro for easier access to the singleton.
+#define sEncoderPool \
+    ( EVEEncoderPool::get() )
+
+#endif /* !__NETWORK__EVE_ENCODER_POOL_H__INCL__ */
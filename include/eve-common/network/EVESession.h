@@ -28,6 +28,8 @@
 
 #include "network/EVETCPConnection.h"
 
+struct CallTrace;
+class EVESharedPayload;
 class PyPacket;
 class PyRep;
 
@@ -82,9 +84,17 @@ public:
     /**
      * @brief Queues new packet, retaking ownership.
      *
-     * @param[in] p Packed to be queued.
+     * @param[in] p     Packed to be queued.
+     * @param[in] trace Trace of the call the packet answers; taken over, may be NULL.
+     */
+    void FastQueuePacket( PyPacket** p, CallTrace* trace = NULL );
+    /**
+     * @brief Queues new packet carrying a shared payload, retaking ownership.
+     *
+     * @param[in] p       Packet to be queued; its payload must be @a payload's.
+     * @param[in] payload The shared payload.
      */
-    void FastQueuePacket( PyPacket** p );
+    void FastQueuePacket( PyPacket** p, const EVESharedPayload& payload );
 
     /**
      * @brief Pops new packet from queue.
@@ -97,6 +107,19 @@ public:
      * @brief Disconnects client from the server
      */
     void CloseClientConnection() { mNet->Disconnect(); }
+    /** Wrapper of TCPConnection::Drop(). */
+    void DropClientConnection() { mNet->Drop(); }
+    /** Wrapper of TCPConnection::GetSendStats(). */
+    TCPConnection::SendStats GetSendStats() const { return mNet->GetSendStats(); }
+
+    /** Wrapper of EVETCPConnection::StartCapture(). */
+    bool StartCapture( const char* filename ) { return mNet->StartCapture( filename ); }
+    /** Wrapper of EVETCPConnection::StopCapture(). */
+    void StopCapture() { mNet->StopCapture(); }
+    /** Wrapper of EVETCPConnection::IsCapturing(). */
+    bool IsCapturing() const { return mNet->IsCapturing(); }
+    /** Wrapper of EVETCPConnection::GetTraffic(). */
+    EVETrafficStats::Totals GetTraffic( EVETrafficStats::Direction direction ) const { return mNet->GetTraffic( direction ); }
 
 
 protected:
@@ -143,8 +166,11 @@ protected:
      *
      * @param[in] ccp Login data sent by client.
      *
+     * The verification may be finished later by parking the
+     * authentication (see _ParkAuthentication()) and returning false.
+     *
      * @retval true  Verification succeeded; proceeds to next state.
-     * @retval false Verification failed; stays in current state.
+     * @retval false Verification failed or parked; stays in current state.
      */
     virtual bool _VerifyLogin( CryptoChallengePacket& ccp ) = 0;
     /**
@@ -157,12 +183,28 @@ protected:
      */
     virtual bool _VerifyFuncResult( CryptoHandshakeResult& result ) = 0;
 
+    /**
+     * @brief Parks the authentication while the login is verified elsewhere.
+     *
+     * To be called by _VerifyLogin(); no packets are popped until
+     * _ResumeAuthentication() is called.
+     */
+    void _ParkAuthentication() { mParked = true; }
+    /**
+     * @brief Resumes a parked authentication.
+     *
+     * @param[in] success Whether the login passed; proceeds to next state if so.
+     */
+    void _ResumeAuthentication( bool success );
+
     /** Connection of this session. */
     EVETCPConnection* const mNet;
 
 private:
     // State machine facility:
     PyPacket* ( EVEClientSession::*mPacketHandler )( PyRep* rep );
+    /// Whether the authentication is parked.
+    bool mParked;
 
     PyPacket* _HandleVersion( PyRep* rep );
     PyPacket* _HandleCommand( PyRep* rep );
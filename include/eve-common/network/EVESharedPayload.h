@@ -0,0 +1,101 @@
+/*
+    ------------------------------------------------------------------------------------
+    LICENSE:
+    ------------------------------------------------------------------------------------
+    This file is part of EVEmu: EVE Online Server Emulator
+    Copyright 2006 - 2011 The EVEmu Team
+    For the latest information visit http://evemu.org
+    ------------------------------------------------------------------------------------
+    This program is free software; you can redistribute it and/or modify it under
+    the terms of the GNU Lesser General Public License as published by the Free Software
+    Foundation; either version 2 of the License, or (at your option) any later
+    version.
+
+    This program is distributed in the hope that it will be useful, but WITHOUT
+    ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+    FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public License along with
+    this program; if not, write to the Free Software Foundation, Inc., 59 Temple
+    Place - Suite 330, Boston, MA 02111-1307, USA, or go to
+    http://www.gnu.org/copyleft/lesser.txt.
+    ------------------------------------------------------------------------------------
+    Author:     EVEmu Team
+*/
+
+#ifndef __NETWORK__EVE_SHARED_PAYLOAD_H__INCL__
+#define __NETWORK__EVE_SHARED_PAYLOAD_H__INCL__
+
+class PyPacket;
+class PyTuple;
+
+/**
+ * @brief Packet payload encoded once and sent to many clients.
+ *
+ * The payload is marshaled (and deflated, if large enough) at most
+ * once; every recipient's packet is then built from the small
+ * per-recipient envelope (addresses, userid, named payload) stored
+ * uncompressed around the shared bytes.
+ *
+ * The object never changes once created and must be used by the
+ * game thread only (reference counting is not thread-safe).
+ *
+ * @author EVEmu Team
+ */
+class EVESharedPayload
+: public RefObject
+{
+public:
+    /**
+     * @brief Marshals given payload.
+     *
+     * @param[in] payload The payload; consumed.
+     */
+    EVESharedPayload( PyTuple** payload );
+    /**
+     * @brief Releases the payload.
+     */
+    ~EVESharedPayload();
+
+    /** @return The payload; must not be modified. */
+    PyTuple* payload() const { return mPayload; }
+    /** @return True if the payload has been marshaled successfully. */
+    bool IsValid() const { return 0 < mMarshaled.size(); }
+
+    /**
+     * @brief Encodes a packet carrying the payload.
+     *
+     * @param[in]  packet         The packet; its payload must be ours.
+     * @param[in]  deflationLimit The least size of packet which gets deflated.
+     * @param[in]  level          Compression level (0-9 or Z_DEFAULT_COMPRESSION).
+     * @param[out] marshaledSize  If not NULL, receives size of the packet before deflation.
+     *
+     * @return The packet, including its length; NULL on failure.
+     */
+    Buffer* EncodePacket( PyPacket& packet, uint32 deflationLimit = 0x2000, int level = Z_DEFAULT_COMPRESSION, size_t* marshaledSize = NULL ) const;
+
+protected:
+    /**
+     * @brief Deflates the marshaled payload on first use.
+     *
+     * @retval true  The deflated payload is available.
+     * @retval false Deflation failed.
+     */
+    bool _Deflate( int level ) const;
+
+    /// The payload.
+    PyTuple* mPayload;
+
+    /// The marshaled payload, without stream header.
+    Buffer mMarshaled;
+    /// Adler-32 checksum of the marshaled payload.
+    uint32 mMarshaledAdler;
+
+    /// Raw deflated payload ending with a sync flush; empty until needed.
+    mutable Buffer mDeflated;
+};
+
+/// Reference to a shared payload.
+typedef RefPtr<EVESharedPayload> EVESharedPayloadRef;
+
+#endif /* !__NETWORK__EVE_SHARED_PAYLOAD_H__INCL__ */
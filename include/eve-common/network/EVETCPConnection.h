@@ -26,7 +26,13 @@
 #ifndef __NETWORK__EVE_TCP_CONNECTION_H__INCL__
 #define __NETWORK__EVE_TCP_CONNECTION_H__INCL__
 
+#include "network/EVETrafficStats.h"
+#include "network/PacketCapture.h"
+#include "network/packet_types.h"
+
+struct CallTrace;
 class PyRep;
+class EVEEncoderPool;
 class EVETCPServer;
 
 /**
@@ -37,6 +43,7 @@ class EVETCPServer;
 class EVETCPConnection
 : public TCPConnection
 {
+    friend class EVEEncoderPool;
     friend class EVETCPServer;
 
 public:
@@ -44,25 +51,114 @@ public:
     static const uint32 TIMEOUT_MS;
     /// Hardcoded limit of packet size (NetClient.dll).
     static const uint32 PACKET_SIZE_LIMIT;
+    /// Maximal number of received packets waiting to be popped.
+    static const uint32 PACKET_QUEUE_SIZE;
+
+    /**
+     * @brief Deflation settings of outbound packets.
+     */
+    struct DeflationSettings
+    {
+        /// The least size of packet which gets deflated.
+        uint32 limit;
+        /// Compression level (0-9 or Z_DEFAULT_COMPRESSION).
+        int level;
+    };
+
+    /**
+     * @brief Sets deflation of all packet types.
+     *
+     * Not thread-safe; meant to be called before any packets are sent.
+     *
+     * @param[in] limit The least size of packet which gets deflated.
+     * @param[in] level Compression level (0-9 or Z_DEFAULT_COMPRESSION).
+     */
+    static void SetDeflation( uint32 limit, int level );
+    /**
+     * @brief Sets deflation of given packet type.
+     *
+     * Not thread-safe; meant to be called before any packets are sent.
+     *
+     * @param[in] type  The packet type.
+     * @param[in] limit The least size of packet which gets deflated.
+     * @param[in] level Compression level (0-9 or Z_DEFAULT_COMPRESSION).
+     */
+    static void SetDeflation( MACHONETMSG_TYPE type, uint32 limit, int level );
+    /**
+     * @param[in] type The packet type.
+     *
+     * @return Deflation settings of given packet type.
+     */
+    static const DeflationSettings& GetDeflation( MACHONETMSG_TYPE type );
 
     /**
      * @brief Creates empty EVE connection.
      */
     EVETCPConnection();
+    /**
+     * @brief Disconnects and waits for the reactor to let go of us.
+     */
+    ~EVETCPConnection();
 
     /**
      * @brief Queues given PyRep into send queue.
      *
-     * @param[in] rep PyRep to be queued.
+     * If the encoder pool is running, the PyRep is marshaled
+     * asynchronously and must not be modified afterwards.
+     *
+     * @param[in] rep   PyRep to be queued.
+     * @param[in] trace Trace of the call the PyRep answers; taken over, may be NULL.
+     */
+    void QueueRep( const PyRep* rep, CallTrace* trace = NULL );
+    /**
+     * @brief Queues already encoded packet into send queue.
+     *
+     * Keeps the order with PyReps queued before.
+     *
+     * @param[in] buf     The packet, including its length; consumed.
+     * @param[in] kind    The kind of the packet, see EVETrafficStats.
+     * @param[in] rawSize Size of the packet before deflation.
      */
-    void QueueRep( const PyRep* rep );
+    void QueueBuffer( Buffer** buf, const std::string& kind, size_t rawSize );
 
     /**
      * @brief Pops PyRep from receive queue.
      *
+     * Must be called from a single thread only.
+     *
      * @return Popped PyRep; NULL if nothing was received.
      */
     PyRep* PopRep();
+    /**
+     * @brief Stamps the points the packet popped last passed into a trace.
+     *
+     * Nothing is stamped unless the calls were traced when the packet arrived.
+     *
+     * @param[in] trace The trace of the call the packet carried.
+     */
+    void StampTrace( CallTrace& trace ) const;
+
+    /**
+     * @brief Starts recording the packets of the connection, both ways.
+     *
+     * @param[in] filename Name of the capture file; overwritten if it exists.
+     *
+     * @return True on success.
+     */
+    bool StartCapture( const char* filename ) { return mCapture.Open( filename ); }
+    /**
+     * @brief Stops recording the packets.
+     */
+    void StopCapture() { mCapture.Close(); }
+    /** @return True if the packets are being recorded. */
+    bool IsCapturing() const { return mCapture.IsOpen(); }
+
+    /**
+     * @param[in] direction The direction.
+     *
+     * @return The traffic of the connection one way since it was created.
+     */
+    EVETrafficStats::Totals GetTraffic( EVETrafficStats::Direction direction ) const { return mTraffic[ direction ].Get(); }
 
     /**
      * @brief Dumps buffer to file
@@ -87,18 +183,126 @@ protected:
      */
     EVETCPConnection( Socket* sock, uint32 rIP, uint16 rPort );
 
+    /**
+     * @brief Entry of the encode queue.
+     */
+    struct EncodeEntry
+    {
+        /// PyRep to encode; NULL if the packet is encoded already.
+        const PyRep* rep;
+        /// The encoded packet if rep is NULL.
+        Buffer* packet;
+        /// Trace of the call the PyRep answers; NULL if not traced.
+        CallTrace* trace;
+    };
+
+    /**
+     * @brief Entry of the receive queue.
+     */
+    struct ReceivedPacket
+    {
+        /// The packet.
+        Buffer* packet;
+        /// When its first byte arrived; 0 unless the calls are traced.
+        uint64 received;
+        /// When it was queued; 0 unless the calls are traced.
+        uint64 queued;
+    };
+
+    /**
+     * @brief Hands an entry over to the encoder pool.
+     *
+     * @param[in] entry The entry to queue.
+     */
+    void _QueueEncode( const EncodeEntry& entry );
+    /**
+     * @brief Encodes all queued PyReps; called by encoder workers.
+     */
+    void EncodeQueued();
+    /**
+     * @brief Marshals and deflates a PyRep into a packet.
+     *
+     * @param[in] rep The PyRep to encode.
+     *
+     * @return The packet; NULL on failure.
+     */
+    Buffer* EncodeRep( const PyRep* rep );
+    /**
+     * @brief Sends an encoded packet, keeping the trace of its call until it is sent.
+     *
+     * @param[in] buf   The packet; consumed, may be NULL.
+     * @param[in] trace Trace of the call the packet answers; taken over, may be NULL.
+     */
+    void _Send( Buffer** buf, CallTrace* trace );
+    /**
+     * @brief Takes the trace kept for a packet.
+     *
+     * @param[in] buf The packet.
+     *
+     * @return The trace; NULL if the packet is not traced.
+     */
+    CallTrace* _TakeTrace( const Buffer* buf );
+    /**
+     * @brief Drops the traces of the packets not sent yet.
+     */
+    void _DiscardTraces();
+    /**
+     * @brief Records a packet if the connection is being captured.
+     *
+     * @param[in] direction Where the packet goes.
+     * @param[in] packet    The packet.
+     * @param[in] offset    Offset of the packet data; skips the length of outbound packets.
+     */
+    void _Capture( PacketCapture::Direction direction, const Buffer& packet, size_t offset = 0 );
+    /**
+     * @brief Counts a packet into the traffic of the connection and of its kind.
+     *
+     * @param[in] direction Where the packet goes.
+     * @param[in] kind      The kind of the packet.
+     * @param[in] size      Size of the packet as sent, without its length.
+     * @param[in] rawSize   Size of the packet before deflation.
+     */
+    void _CountTraffic( EVETrafficStats::Direction direction, const std::string& kind, size_t size, size_t rawSize );
+
     bool RecvData( char* errbuf = 0 );
-    bool ProcessReceivedData( char* errbuf = 0 );
+    uint8* GetRecvSpan( size_t& len );
+    bool ProcessReceivedData( size_t len, char* errbuf = 0 );
+    void SentBuffer( const Buffer* buf );
 
     void ClearBuffers();
 
     /// Timer used to implement timeout.
     Timer mTimeoutTimer;
 
-    /// Mutex to protect received data queue.
-    Mutex mMInQueue;
-    /// Received data queue.
+    /// Received data; touched by the I/O thread only.
     StreamPacketizer mInQueue;
+    /// When the first byte of the packet being received arrived; touched by the I/O thread only.
+    uint64 mRecvStart;
+    /// Complete packets; filled by the I/O thread, drained by PopRep().
+    LockFreeQueue<ReceivedPacket> mPackets;
+    /// The packet popped last; its buffer is released already.
+    ReceivedPacket mPopped;
+    /// When the packet popped last was popped; 0 unless the calls are traced.
+    uint64 mPoppedAt;
+
+    /// Protects the encode queue.
+    Mutex mMEncodeQueue;
+    /// PyReps waiting for an encoder worker.
+    std::deque<EncodeEntry> mEncodeQueue;
+    /// True while the connection is handed over to the encoder pool.
+    bool mEncodeScheduled;
+
+    /// Protects the traced packets.
+    Mutex mMTraces;
+    /// Packets in the send queue whose calls are traced, with their traces.
+    std::deque< std::pair< const Buffer*, CallTrace* > > mTraces;
+    /// Number of the traced packets; checked without the lock.
+    volatile uint32 mTraceCount;
+
+    /// Capture of the packets; closed unless asked for.
+    PacketCapture mCapture;
+    /// Traffic of the connection, both ways.
+    EVETrafficStats::Counters mTraffic[ EVETrafficStats::TRAFFIC_DIRECTION_COUNT ];
 };
 
 #endif /* !__NETWORK__EVE_TCP_CONNECTION_H__INCL__ */
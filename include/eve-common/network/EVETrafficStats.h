@@ -0,0 +1,165 @@
+/*
+    ------------------------------------------------------------------------------------
+    LICENSE:
+    ------------------------------------------------------------------------------------
+    This file is part of EVEmu: EVE Online Server Emulator
+    Copyright 2006 - 2011 The EVEmu Team
+    For the latest information visit http://evemu.org
+    ------------------------------------------------------------------------------------
+    This program is free software; you can redistribute it and/or modify it under
+    the terms of the GNU Lesser General Public License as published by the Free Software
+    Foundation; either version 2 of the License, or (at your option) any later
+    version.
+
+    This program is distributed in the hope that it will be useful, but WITHOUT
+    ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+    FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public License along with
+    this program; if not, write to the Free Software Foundation, Inc., 59 Temple
+    Place - Suite 330, Boston, MA 02111-1307, USA, or go to
+    http://www.gnu.org/copyleft/lesser.txt.
+    ------------------------------------------------------------------------------------
+    Author:     EVEmu Team
+*/
+
+#ifndef __NETWORK__EVE_TRAFFIC_STATS_H__INCL__
+#define __NETWORK__EVE_TRAFFIC_STATS_H__INCL__
+
+#include "threading/Atomic.h"
+#include "threading/LockProfile.h"
+#include "threading/SharedMutex.h"
+#include "utils/Metrics.h"
+#include "utils/Singleton.h"
+
+class PyPacket;
+class PyRep;
+
+/**
+ * @brief Traffic of the client connections, by kind of packet.
+ *
+ * The kind of a notification is its type (OnLSC, DoDestinyUpdate,
+ * ...), the kind of another packet is its MACHONETMSG_TYPE name
+ * and the login handshake is of kind "handshake". Every kind is
+ * exported as evemu_net_packets_total, evemu_net_packet_bytes_total
+ * (as sent, ie. deflated) and evemu_net_packet_raw_bytes_total
+ * (marshaled, before deflation), labeled by direction and kind.
+ *
+ * Thread-safe.
+ *
+ * @author EVEmu Team
+ */
+class EVETrafficStats
+: public Singleton< EVETrafficStats >
+{
+public:
+    enum Direction
+    {
+        TRAFFIC_IN,
+        TRAFFIC_OUT,
+
+        TRAFFIC_DIRECTION_COUNT
+    };
+
+    /**
+     * @brief Totals of packets going one way.
+     */
+    struct Totals
+    {
+        uint64 packets;
+        uint64 bytes;
+        uint64 rawBytes;
+    };
+
+    /**
+     * @brief Counters of packets going one way.
+     */
+    struct Counters
+    {
+        Counters() : packets( 0 ), bytes( 0 ), rawBytes( 0 ) {}
+
+        /**
+         * @brief Counts a packet; safe to call from any thread.
+         *
+         * @param[in] size    Size of the packet as sent.
+         * @param[in] rawSize Size of the packet before deflation.
+         */
+        void Add( size_t size, size_t rawSize )
+        {
+            AtomicAdd64( &packets, 1 );
+            AtomicAdd64( &bytes, size );
+            AtomicAdd64( &rawBytes, rawSize );
+        }
+        /** @return The current totals. */
+        Totals Get() const
+        {
+            Totals totals;
+            totals.packets = AtomicLoad64( &packets );
+            totals.bytes = AtomicLoad64( &bytes );
+            totals.rawBytes = AtomicLoad64( &rawBytes );
+            return totals;
+        }
+
+        volatile uint64 packets;
+        volatile uint64 bytes;
+        volatile uint64 rawBytes;
+    };
+
+    EVETrafficStats();
+    ~EVETrafficStats();
+
+    /**
+     * @param[in] rep An encoded PyPacket.
+     *
+     * @return The kind of the packet.
+     */
+    static std::string GetKind( const PyRep* rep );
+    /**
+     * @param[in] packet The packet.
+     *
+     * @return The kind of the packet.
+     */
+    static std::string GetKind( const PyPacket& packet );
+
+    /**
+     * @brief Counts a packet.
+     *
+     * @param[in] direction Where the packet goes.
+     * @param[in] kind      The kind of the packet.
+     * @param[in] size      Size of the packet as sent.
+     * @param[in] rawSize   Size of the packet before deflation.
+     */
+    void Add( Direction direction, const std::string& kind, size_t size, size_t rawSize );
+
+    /**
+     * @brief Reads the totals since the start.
+     *
+     * @param[in]  direction The direction to read.
+     * @param[out] into      The totals, by kind.
+     */
+    void GetKinds( Direction direction, std::map< std::string, Totals >& into ) const;
+
+protected:
+    /**
+     * @brief The metrics of a kind going one way.
+     */
+    struct Kind
+    {
+        MetricCounter* packets;
+        MetricCounter* bytes;
+        MetricCounter* rawBytes;
+    };
+    typedef std::map< std::string, Kind > KindMap;
+    typedef ProfiledMutex< SharedMutex > KindMutex;
+
+    /// Protects mKinds; the kinds are looked up for every packet and added rarely.
+    mutable KindMutex mMutex;
+    /// The kinds, by name.
+    KindMap mKinds[ TRAFFIC_DIRECTION_COUNT ];
+};
+
+/// A macro for easier access to the singleton.
+#define sTrafficStats \
+    ( EVETrafficStats::get() )
+
+#endif /* !__NETWORK__EVE_TRAFFIC_STATS_H__INCL__ */
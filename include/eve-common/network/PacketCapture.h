@@ -0,0 +1,175 @@
+/*
+    ------------------------------------------------------------------------------------
+    LICENSE:
+    ------------------------------------------------------------------------------------
+    This file is part of EVEmu: EVE Online Server Emulator
+    Copyright 2006 - 2011 The EVEmu Team
+    For the latest information visit http://evemu.org
+    ------------------------------------------------------------------------------------
+    This program is free software; you can redistribute it and/or modify it under
+    the terms of the GNU Lesser General Public License as published by the Free Software
+    Foundation; either version 2 of the License, or (at your option) any later
+    version.
+
+    This program is distributed in the hope that it will be useful, but WITHOUT
+    ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+    FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public License along with
+    this program; if not, write to the Free Software Foundation, Inc., 59 Temple
+    Place - Suite 330, Boston, MA 02111-1307, USA, or go to
+    http://www.gnu.org/copyleft/lesser.txt.
+    ------------------------------------------------------------------------------------
+    Author:     EVEmu Team
+*/
+
+#ifndef __NETWORK__PACKET_CAPTURE_H__INCL__
+#define __NETWORK__PACKET_CAPTURE_H__INCL__
+
+/**
+ * @brief Capture of the packets of a connection.
+ *
+ * The file starts with the 8 byte signature "EVECAP1\0", followed by
+ * one record per packet:
+ *
+ *   uint64 time       microseconds since the capture started
+ *   uint8  direction  INBOUND (from the client) or OUTBOUND
+ *   uint32 length     length of the packet
+ *   uint8  data[]     the packet as on the wire, without its length
+ *
+ * The numbers are little-endian. Write() is thread-safe, so the I/O
+ * thread and the encoder workers may record into the same capture.
+ *
+ * @author EVEmu Team
+ */
+class PacketCapture
+{
+public:
+    enum Direction
+    {
+        INBOUND,
+        OUTBOUND
+    };
+
+    /**
+     * @brief A captured packet.
+     */
+    struct Record
+    {
+        /// Microseconds since the capture started.
+        uint64 time;
+        uint8 direction;
+        Buffer data;
+    };
+
+    /**
+     * @brief Reads a capture file record by record.
+     *
+     * Unlike Load(), only the current record is held in memory,
+     * so captures of any length may be processed.
+     */
+    class Reader
+    {
+    public:
+        Reader();
+        /**
+         * @brief Closes the file.
+         */
+        ~Reader();
+
+        /**
+         * @brief Opens a capture file and checks its signature.
+         *
+         * @param[in] filename Name of the file.
+         *
+         * @return True on success.
+         */
+        bool Open( const char* filename );
+        /**
+         * @brief Closes the capture file.
+         */
+        void Close();
+
+        /**
+         * @brief Reads the next record.
+         *
+         * A record cut short at the end of the file is dropped.
+         *
+         * @param[out] into The record; its buffer is reused.
+         *
+         * @return False at the end of the capture.
+         */
+        bool Read( Record& into );
+
+    protected:
+        FILE* mFile;
+        /// Name of the file, for the messages.
+        std::string mFilename;
+    };
+
+    PacketCapture();
+    /**
+     * @brief Closes the file.
+     */
+    ~PacketCapture();
+
+    /** @return True if packets are being captured. */
+    bool IsOpen() const { return mOpen; }
+
+    /**
+     * @brief Creates the capture file.
+     *
+     * @param[in] filename Name of the file; overwritten if it exists.
+     *
+     * @return True on success.
+     */
+    bool Open( const char* filename );
+    /**
+     * @brief Closes the capture file.
+     */
+    void Close();
+
+    /**
+     * @brief Records a packet; does nothing if the capture is not open.
+     *
+     * @param[in] direction Where the packet goes.
+     * @param[in] data      The packet, without its length.
+     * @param[in] length    Length of the packet.
+     */
+    void Write( Direction direction, const uint8* data, size_t length );
+    /**
+     * @brief Records a packet which was received or sent earlier.
+     *
+     * @param[in] time      Microseconds since the start of the capture the packet is recorded at.
+     * @param[in] direction Where the packet went.
+     * @param[in] data      The packet, without its length.
+     * @param[in] length    Length of the packet.
+     */
+    void Write( uint64 time, Direction direction, const uint8* data, size_t length );
+
+    /**
+     * @brief Reads a capture file.
+     *
+     * A record cut short at the end of the file (a capture of
+     * a crashed server) is dropped.
+     *
+     * @param[in]  filename Name of the file.
+     * @param[out] into     The records, in order.
+     *
+     * @return True on success.
+     */
+    static bool Load( const char* filename, std::vector< Record >& into );
+
+protected:
+    static const char SIGNATURE[ 8 ];
+
+    /// Protects the file.
+    Mutex mMutex;
+    FILE* mFile;
+    /// Copy of NULL != mFile, so idle connections check it without locking.
+    volatile bool mOpen;
+    /// Time (in microseconds) at which the capture started.
+    uint64 mStart;
+};
+
+#endif /* !__NETWORK__PACKET_CAPTURE_H__INCL__ */
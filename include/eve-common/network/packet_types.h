@@ -343,6 +343,8 @@ typedef enum {
        skillSmallHybridTurret = 3301,
        skillSpaceshipCommand = 3327,
        skillCaldariFrigate = 3330,
+       skillDiplomacy = 3357,
+       skillConnections = 3359,
        skillIndustry = 3380,
        skillRefining = 3385,
        skillMining = 3386,
@@ -545,7 +547,8 @@ typedef enum JournalRefType {
     RefType_corpPayment = 11,
     RefType_corpRegFee = 39,
     RefType_officeRentalFee = 13,
-    RefType_playerDonation = 10
+    RefType_playerDonation = 10,
+    RefType_playerTrading = 1
 } JournalRefType;
 
 //from market_keyMap
@@ -805,5 +808,14 @@ def IsJunkLocation(locationID):
 #define IsNonStaticItem(itemID) \
     (itemID >= EVEMU_MINIMUM_ID)
 
+// Items which live in memory only, such as the NPCs of the spawns, until a player takes them over.
+// The range lies below the AUTO_INCREMENT of entity, so they are inserted with their own IDs
+// once persisted without moving the counter.
+#define EVEMU_TRANSIENT_MINIMUM_ID 100000000
+#define EVEMU_TRANSIENT_MAXIMUM_ID EVEMU_MINIMUM_ID
+
+#define IsTransientItem(itemID) \
+    ((itemID >= EVEMU_TRANSIENT_MINIMUM_ID) && (itemID < EVEMU_TRANSIENT_MAXIMUM_ID))
+
 #endif
 
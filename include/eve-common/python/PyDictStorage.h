@@ -0,0 +1,113 @@
+/*
+    ------------------------------------------------------------------------------------
+    LICENSE:
+    ------------------------------------------------------------------------------------
+    This file is part of EVEmu: EVE Online Server Emulator
+    Copyright 2006 - 2011 The EVEmu Team
+    For the latest information visit http://evemu.org
+    ------------------------------------------------------------------------------------
+    This program is free software; you can redistribute it and/or modify it under
+    the terms of the GNU Lesser General Public License as published by the Free Software
+    Foundation; either version 2 of the License, or (at your option) any later
+    version.
+
+    This program is distributed in the hope that it will be useful, but WITHOUT
+    ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+    FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public License along with
+    this program; if not, write to the Free Software Foundation, Inc., 59 Temple
+    Place - Suite 330, Boston, MA 02111-1307, USA, or go to
+    http://www.gnu.org/copyleft/lesser.txt.
+    ------------------------------------------------------------------------------------
+    Author:     EVEmu Team
+*/
+
+
+#ifndef __PYTHON__PY_DICT_STORAGE_H__INCL__
+#define __PYTHON__PY_DICT_STORAGE_H__INCL__
+
+class PyRep;
+
+/**
+ * @brief Flat storage of PyDict.
+ *
+ * The entries are kept in a vector in the order they were inserted,
+ * alongside the hashes of their keys; a key is hashed only once, when
+ * its entry is inserted. Small dicts (KeyVals, session dicts) are
+ * searched by scanning the hashes; bigger ones get an open-addressing
+ * table of entry indexes with linear probing.
+ *
+ * Like the node-based map it replaces, keys are equal if their
+ * hashes are. Entries cannot be removed, inserting may invalidate
+ * the iterators.
+ *
+ * @author EVEmu Team
+ */
+class PyDictStorage
+{
+public:
+    typedef std::pair<PyRep*, PyRep*>       value_type;
+    typedef std::vector<value_type>         entry_list;
+    typedef entry_list::iterator            iterator;
+    typedef entry_list::const_iterator      const_iterator;
+
+    iterator begin() { return mEntries.begin(); }
+    iterator end() { return mEntries.end(); }
+    const_iterator begin() const { return mEntries.begin(); }
+    const_iterator end() const { return mEntries.end(); }
+
+    size_t size() const { return mEntries.size(); }
+    bool empty() const { return mEntries.empty(); }
+
+    /** @brief Removes all the entries; releases nothing. */
+    void clear();
+    /** @brief Makes room for the given number of entries. */
+    void reserve( size_t count );
+
+    /** @return The entry of the key; end() if there is none. */
+    iterator find( const PyRep* key ) { return begin() + _Find( _Hash( key ) ); }
+    const_iterator find( const PyRep* key ) const { return begin() + _Find( _Hash( key ) ); }
+    /** @return The entry of a key with given hash; end() if there is none. */
+    iterator find_hash( int32 hash ) { return begin() + _Find( hash ); }
+    const_iterator find_hash( int32 hash ) const { return begin() + _Find( hash ); }
+
+    /**
+     * @brief Inserts an entry unless its key is present.
+     *
+     * @return The entry of the key and whether it has been inserted.
+     */
+    std::pair<iterator, bool> insert( const value_type& entry );
+    /**
+     * @return Value of the key; a NULL value is inserted if the key is not present.
+     */
+    PyRep*& operator[]( PyRep* key ) { return insert( value_type( key, NULL ) ).first->second; }
+
+protected:
+    /// Dicts up to this size are searched without the table.
+    static const size_t LINEAR_MAX = 8;
+
+    static int32 _Hash( const PyRep* key );
+    /** @return Position of the first slot to probe for given hash. */
+    static size_t _Slot( int32 hash, size_t mask )
+    {
+        const uint32 x = (uint32)hash * 2654435769U;
+        return ( x ^ ( x >> 16 ) ) & mask;
+    }
+
+    /** @return Index of the entry with given hash; size() if there is none. */
+    size_t _Find( int32 hash ) const;
+    /** @brief Puts the entry into the table. */
+    void _Index( size_t entry );
+    /** @brief Rebuilds the table with given number of slots, a power of two. */
+    void _Rebuild( size_t slots );
+
+    /// The entries in the order of insertion.
+    entry_list mEntries;
+    /// Hashes of the keys of mEntries.
+    std::vector<int32> mHashes;
+    /// Indexes of mEntries plus one, 0 marks a free slot; empty while the dict is small.
+    std::vector<uint32> mTable;
+};
+
+#endif /* !__PYTHON__PY_DICT_STORAGE_H__INCL__ */
@@ -89,9 +89,22 @@ public:
     PyPacket();
     ~PyPacket();
 
+    /**
+     * @brief Allocates packets from ObjectPool; every call and notification makes one.
+     */
+    static void* operator new( size_t size ) { return ObjectPool< PyPacket >::Allocate( size ); }
+    static void operator delete( void* p, size_t size ) { ObjectPool< PyPacket >::Free( p, size ); }
+
     void Dump(LogType type, PyVisitor& dumper);
     bool Decode(PyRep **packet);    //consumes packet
     PyRep *Encode();
+    /**
+     * @brief Encodes the packet, referencing the payloads instead of cloning them.
+     *
+     * The result shares payload and named_payload with this packet,
+     * so none of them may be modified while it is alive.
+     */
+    PyRep *EncodeShared();
     PyPacket *Clone() const;
 
     //the "type" of object this represents
@@ -124,6 +137,9 @@ public:
     std::string channel;
     uint32 sequence_number;
 #endif
+
+protected:
+    PyRep *_Encode(bool shared);
 };
 
 class PyCallStream {
@@ -149,6 +165,10 @@ public:
     EVENotificationStream();
     ~EVENotificationStream();
 
+    /** @brief Allocates notification streams from ObjectPool. */
+    static void* operator new( size_t size ) { return ObjectPool< EVENotificationStream >::Allocate( size ); }
+    static void operator delete( void* p, size_t size ) { ObjectPool< EVENotificationStream >::Free( p, size ); }
+
     void Dump(LogType type, PyVisitor& dumper);
     bool Decode(const std::string &pkt_type, const std::string &notify_type, PyTuple *&payload); //consumes substream
     PyTuple *Encode();
@@ -33,6 +33,8 @@
  */
 //#pragma pack(push,1)
 
+#include "python/PyDictStorage.h"
+
 class PyInt;
 class PyLong;
 class PyFloat;
@@ -54,6 +56,7 @@ class PyPackedRow;
 
 class PyVisitor;
 class DBRowDescriptor;
+class MarshalStringToken;
 
 /**
  * debug macro's to ease the increase and decrease of references of a object
@@ -66,6 +69,16 @@ class DBRowDescriptor;
 #define PySafeIncRef(op) if( NULL == (op) ) ; else PyIncRef( op )
 #define PySafeDecRef(op) if( NULL == (op) ) ; else PyDecRef( op )
 
+/**
+ * PYREP_POOL
+ *
+ * Allocate PyRep objects from SizeClassPool rather than the heap.
+ * Disabled when tracking leaks through crtdbg, which redefines new.
+ */
+#ifndef HAVE_CRTDBG_H
+#   define PYREP_POOL
+#endif /* !HAVE_CRTDBG_H */
+
 /**
  * @brief Base Python wire object
  */
@@ -214,11 +227,45 @@ public:
      */
     virtual int32 hash() const;
 
+    /** @return True if the object has been frozen. */
+    bool IsFrozen() const { return mFrozen; }
+    /**
+     * @brief Freezes the object and everything it references.
+     *
+     * A frozen object must not be modified anymore and its reference
+     * count is shared (see RefObject::MakeShared()), so any thread
+     * may read it, reference it and release it. The lazily computed
+     * caches are filled in advance, reading never writes into it.
+     *
+     * There is no way back; Clone() gives a mutable copy.
+     */
+    void Freeze() const;
+
+#ifdef PYREP_POOL
+    /**
+     * @brief Allocates objects from SizeClassPool.
+     *
+     * Unmarshaling produces lots of tiny objects which are released
+     * shortly after, pooling saves us the trips to the heap.
+     */
+    static void* operator new( size_t size ) { return SizeClassPool::Allocate( size ); }
+    static void operator delete( void* p, size_t size ) { SizeClassPool::Free( p, size ); }
+#endif /* PYREP_POOL */
+
 protected:
     PyRep( PyType t );
     virtual ~PyRep();
 
+    /**
+     * @brief Freezes the referenced objects and fills the caches.
+     *
+     * Called by Freeze() once the object itself has been frozen.
+     */
+    virtual void _Freeze() const {}
+
     const PyType mType;
+    /// Whether the object has been frozen, see Freeze().
+    mutable bool mFrozen;
 
     /** Lookup table for PyRep type object type names. */
     static const char* const s_mTypeString[];
@@ -361,7 +408,7 @@ public:
      *
      * @return const PyBuffer content
      */
-    const Buffer& content() const { return *mValue; }
+    const Buffer& content() const { return *mValue->value; }
 
     int32 hash() const;
 
@@ -373,9 +420,33 @@ public:
     size_t size() const;
 
 protected:
+    void _Freeze() const;
+
+    /**
+     * @brief Immutable bytes shared by a PyBuffer and its copies.
+     *
+     * Copying the PyBuffer only takes another reference, so big blobs
+     * are never duplicated.
+     */
+    class Data
+    : public RefObject
+    {
+    public:
+        /** Takes ownership of a passed Buffer. */
+        Data( const Buffer* buffer ) : RefObject( 0 ), value( buffer ) {}
+        ~Data() { delete value; }
+
+#ifdef PYREP_POOL
+        static void* operator new( size_t size ) { return SizeClassPool::Allocate( size ); }
+        static void operator delete( void* p, size_t size ) { SizeClassPool::Free( p, size ); }
+#endif /* PYREP_POOL */
+
+        const Buffer* const value;
+    };
+
     virtual ~PyBuffer();
 
-    const Buffer* const mValue;
+    const RefPtr<Data> mValue;
     mutable int32 mHashCache;
 };
 
@@ -396,6 +467,8 @@ public:
     PyString( Iter first, Iter last );
     /** Calls std::string( const std::string& ). */
     PyString( const std::string& str );
+    /** Takes the string and its string table index from the token. */
+    PyString( const MarshalStringToken& token );
 
     /** Copy constructor. */
     PyString( const PyBuffer& buf );
@@ -412,13 +485,58 @@ public:
      *
      * @return the std::string reference.
      */
-    const std::string& content() const { return mValue; }
+    const std::string& content() const { return mValue->value; }
 
     int32 hash() const;
+    /**
+     * @brief Hashes characters the same way hash() does.
+     *
+     * Lets PyDict be searched for a string without creating a PyString of it.
+     */
+    static int32 Hash( const char* str, size_t len );
+
+    /**
+     * @brief Get index of the string in the marshal string table.
+     *
+     * The table is searched on first call only.
+     *
+     * @return The index; STRING_TABLE_ERROR if the string is not in the table.
+     */
+    uint8 tableIndex() const;
 
 protected:
-    const std::string mValue;
+    void _Freeze() const;
+
+    /**
+     * @brief Immutable characters shared by a PyString and its copies.
+     *
+     * Copying the PyString only takes another reference, so big
+     * strings are never duplicated.
+     */
+    class Data
+    : public RefObject
+    {
+    public:
+        Data( const char* str ) : RefObject( 0 ), value( str ) {}
+        Data( const char* str, size_t len ) : RefObject( 0 ), value( str, len ) {}
+        template<typename Iter>
+        Data( Iter first, Iter last ) : RefObject( 0 ), value( first, last ) {}
+        Data( const std::string& str ) : RefObject( 0 ), value( str ) {}
+
+#ifdef PYREP_POOL
+        static void* operator new( size_t size ) { return SizeClassPool::Allocate( size ); }
+        static void operator delete( void* p, size_t size ) { SizeClassPool::Free( p, size ); }
+#endif /* PYREP_POOL */
+
+        const std::string value;
+    };
+
+    /// Value of mTableIndexCache before the table has been searched.
+    static const uint8 TABLE_INDEX_UNKNOWN;
+
+    const RefPtr<Data> mValue;
     mutable int32 mHashCache;
+    mutable uint8 mTableIndexCache;
 };
 
 /**
@@ -463,6 +581,8 @@ public:
     int32 hash() const;
 
 protected:
+    void _Freeze() const;
+
     const std::string mValue;
     mutable int32 mHashCache;
 };
@@ -546,6 +666,7 @@ public:
      */
     void SetItem( size_t index, PyRep* object )
     {
+        assert( !IsFrozen() );
         PyRep** rep = &items.at( index );
 
         PySafeDecRef( *rep );
@@ -567,6 +688,8 @@ public:
 
 protected:
     virtual ~PyTuple();
+
+    void _Freeze() const;
 };
 
 /**
@@ -611,6 +734,7 @@ public:
      */
     void SetItem( size_t index, PyRep* object )
     {
+        assert( !IsFrozen() );
         PyRep** rep = &items.at( index );
 
         PySafeDecRef( *rep );
@@ -624,7 +748,7 @@ public:
      */
     void SetItemString( size_t index, const char* str ) { SetItem( index, new PyString( str ) ); }
 
-    void AddItem( PyRep* i ) { items.push_back( i ); }
+    void AddItem( PyRep* i ) { assert( !IsFrozen() ); items.push_back( i ); }
     void AddItemInt( int32 intval ) { AddItem( new PyInt( intval ) ); }
     void AddItemLong( int64 intval ) { AddItem( new PyLong( intval ) ); }
     void AddItemReal( double realval ) { AddItem( new PyFloat( realval ) ); }
@@ -643,6 +767,8 @@ public:
 
 protected:
     virtual ~PyList();
+
+    void _Freeze() const;
 };
 
 /**
@@ -652,38 +778,10 @@ protected:
  */
 class PyDict : public PyRep
 {
-protected:
-    // hash function
-    class _hash : public std::unary_function<PyRep*, size_t>
-    {
-    public:
-        size_t operator()( const PyRep* _Keyval ) const
-        {
-            assert( _Keyval );
-
-            return (size_t)_Keyval->hash();
-        }
-    };
-
-    // comparison function
-    class _comp : public std::binary_function<PyRep*, PyRep*, bool>
-    {
-    public:
-        bool operator()( const PyRep* _Arg1, const PyRep* _Arg2 ) const
-        {
-            assert( _Arg1 );
-            assert( _Arg2 );
-
-            // Suffers from hash collision but whatever ... still
-            // better than raw pointer comparison
-            return ( _Arg1->hash() == _Arg2->hash() );
-        }
-    };
-
 public:
-    typedef std::tr1::unordered_map<PyRep*, PyRep*, _hash, _comp>   storage_type;
-    typedef storage_type::iterator                                  iterator;
-    typedef storage_type::const_iterator                            const_iterator;
+    typedef PyDictStorage                   storage_type;
+    typedef storage_type::iterator          iterator;
+    typedef storage_type::const_iterator    const_iterator;
 
     PyDict();
     PyDict( const PyDict& oth );
@@ -739,7 +837,7 @@ public:
      * @param[in] key contains the key string which the value needs to be filed under.
      * @param[in] value is the object that needs to be filed under key.
      */
-    void SetItemString( const char* key, PyRep* value ) { SetItem( new PyString( key ), value ); }
+    void SetItemString( const char* key, PyRep* value ) { SetItem( key, value ); }
 
     /**
      * @brief Overload of assigment operator to handle object ownership.
@@ -753,6 +851,8 @@ public:
 
 protected:
     virtual ~PyDict();
+
+    void _Freeze() const;
 };
 
 /**
@@ -777,6 +877,8 @@ public:
 protected:
     virtual ~PyObject();
 
+    void _Freeze() const;
+
     PyString* mType;
     PyRep* const mArguments;
 };
@@ -825,6 +927,8 @@ public:
 protected:
     virtual ~PyObjectEx();
 
+    void _Freeze() const;
+
     PyRep* const mHeader;
     const bool mIsType2;
 
@@ -920,6 +1024,8 @@ public:
 protected:
     virtual ~PyPackedRow();
 
+    void _Freeze() const;
+
     DBRowDescriptor* const mHeader;
     storage_type* const mFields;
 };
@@ -938,6 +1044,8 @@ public:
 protected:
     virtual ~PySubStruct();
 
+    void _Freeze() const;
+
     PyRep* const mSub;
 };
 
@@ -952,7 +1060,18 @@ public:
     bool visit( PyVisitor& v ) const;
 
     PyBuffer* data() const { return mData; }
-    PyRep* decoded() const { return mDecoded; }
+    /**
+     * @brief Get the decoded stream, unmarshaling the data on first access.
+     *
+     * The data is kept and re-sent whenever the stream is marshaled, so
+     * the returned rep must not be modified if data() is non-NULL.
+     *
+     * @return Decoded stream; NULL if the data cannot be unmarshaled.
+     */
+    PyRep* decoded() const { DecodeData(); return mDecoded; }
+
+    /** @return True if the stream has already been decoded. */
+    bool isDecoded() const { return NULL != mDecoded; }
 
     //call to ensure that `data` represents `decoded` IF DATA IS NULL
     void EncodeData() const;
@@ -963,7 +1082,10 @@ public:
 protected:
     virtual ~PySubStream();
 
+    void _Freeze() const;
+
     //if both are non-NULL, they are considered to be equivalent
+    //streams received from the wire are only decoded on demand
     mutable PyBuffer* mData;
     mutable PyRep* mDecoded;
 };
@@ -983,6 +1105,8 @@ public:
 protected:
     virtual ~PyChecksumedStream();
 
+    void _Freeze() const;
+
     PyRep* const mStream;
     const uint32 mChecksum;
 };
@@ -997,9 +1121,9 @@ protected:
  * all together.
  */
 template<typename Iter>
-inline PyBuffer::PyBuffer( Iter first, Iter last ) : PyRep( PyRep::PyTypeBuffer ), mValue( new Buffer( first, last ) ), mHashCache( -1 ) {}
+inline PyBuffer::PyBuffer( Iter first, Iter last ) : PyRep( PyRep::PyTypeBuffer ), mValue( new Data( new Buffer( first, last ) ) ), mHashCache( -1 ) {}
 template<typename Iter>
-inline PyString::PyString( Iter first, Iter last ) : PyRep( PyRep::PyTypeString ), mValue( first, last ), mHashCache( -1 ) {}
+inline PyString::PyString( Iter first, Iter last ) : PyRep( PyRep::PyTypeString ), mValue( new Data( first, last ) ), mHashCache( -1 ), mTableIndexCache( TABLE_INDEX_UNKNOWN ) {}
 template<typename Iter>
 inline PyWString::PyWString( Iter first, Iter last ) : PyRep( PyRep::PyTypeWString ), mValue( first, last ), mHashCache( -1 ) {}
 template<typename Iter>
@@ -0,0 +1,147 @@
+/*
+    ------------------------------------------------------------------------------------
+    LICENSE:
+    ------------------------------------------------------------------------------------
+    This file is part of EVEmu: EVE Online Server Emulator
+    Copyright 2006 - 2011 The EVEmu Team
+    For the latest information visit http://evemu.org
+    ------------------------------------------------------------------------------------
+    This program is free software; you can redistribute it and/or modify it under
+    the terms of the GNU Lesser General Public License as published by the Free Software
+    Foundation; either version 2 of the License, or (at your option) any later
+    version.
+
+    This program is distributed in the hope that it will be useful, but WITHOUT
+    ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+    FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public License along with
+    this program; if not, write to the Free Software Foundation, Inc., 59 Temple
+    Place - Suite 330, Boston, MA 02111-1307, USA, or go to
+    http://www.gnu.org/copyleft/lesser.txt.
+    ------------------------------------------------------------------------------------
+    Author:     EVEmu Team
+*/
+
+
+#ifndef __PY_REP_VIEW_H__INCL__
+#define __PY_REP_VIEW_H__INCL__
+
+#include "python/PyRep.h"
+
+/**
+ * @brief Non-owning view of a string.
+ *
+ * Used by the generated packets decoded with borrow="true" for
+ * string and wstring fields: it points either into the content
+ * of a PyString/PyWString of the decoded tree or at a string literal,
+ * so decoding copies nothing. The viewed string is always
+ * NUL-terminated, so c_str() is valid.
+ *
+ * @author EVEmu Team
+ */
+class PyStringView
+{
+public:
+    PyStringView() : mData( "" ), mLength( 0 ) {}
+    /** @param[in] str The literal; must outlive the view. */
+    PyStringView( const char* str ) : mData( str ), mLength( strlen( str ) ) {}
+    /** @param[in] str The string; must outlive the view and stay unchanged. */
+    PyStringView( const std::string& str ) : mData( str.c_str() ), mLength( str.size() ) {}
+
+    const char* c_str() const { return mData; }
+    const char* data() const { return mData; }
+    size_t size() const { return mLength; }
+    size_t length() const { return mLength; }
+    bool empty() const { return 0 == mLength; }
+
+    char operator[]( size_t index ) const { return mData[ index ]; }
+
+    const char* begin() const { return mData; }
+    const char* end() const { return mData + mLength; }
+
+    /** @return Copy of the viewed string. */
+    std::string str() const { return std::string( mData, mLength ); }
+    operator std::string() const { return str(); }
+
+    bool operator==( const PyStringView& oth ) const
+    {
+        return mLength == oth.mLength
+            && 0 == memcmp( mData, oth.mData, mLength );
+    }
+    bool operator!=( const PyStringView& oth ) const { return !( *this == oth ); }
+
+    bool operator==( const char* oth ) const { return *this == PyStringView( oth ); }
+    bool operator!=( const char* oth ) const { return !( *this == oth ); }
+    bool operator==( const std::string& oth ) const { return *this == PyStringView( oth ); }
+    bool operator!=( const std::string& oth ) const { return !( *this == oth ); }
+
+protected:
+    const char* mData;
+    size_t mLength;
+};
+
+inline bool operator==( const char* a, const PyStringView& b ) { return b == a; }
+inline bool operator!=( const char* a, const PyStringView& b ) { return b != a; }
+inline bool operator==( const std::string& a, const PyStringView& b ) { return b == a; }
+inline bool operator!=( const std::string& a, const PyStringView& b ) { return b != a; }
+
+/**
+ * @brief Non-owning view of a list of integers.
+ *
+ * Used by the generated packets decoded with borrow="true" for
+ * listInt fields instead of copying the list into a std::vector.
+ * The viewed list must contain PyInts only, which the decoder checks.
+ *
+ * @author EVEmu Team
+ */
+class PyIntListView
+{
+public:
+    class const_iterator
+    {
+    public:
+        const_iterator( const PyList* list = NULL, size_t index = 0 ) : mList( list ), mIndex( index ) {}
+
+        int32 operator*() const { return mList->GetItem( mIndex )->AsInt()->value(); }
+
+        const_iterator& operator++() { ++mIndex; return *this; }
+        const_iterator operator++( int ) { const_iterator res( *this ); ++mIndex; return res; }
+
+        bool operator==( const const_iterator& oth ) const { return mIndex == oth.mIndex; }
+        bool operator!=( const const_iterator& oth ) const { return mIndex != oth.mIndex; }
+
+    protected:
+        const PyList* mList;
+        size_t mIndex;
+    };
+
+    PyIntListView() : mList( NULL ) {}
+    /** @param[in] list The list of PyInts; must outlive the view. */
+    PyIntListView( const PyList* list ) : mList( list ) {}
+
+    size_t size() const { return NULL == mList ? 0 : mList->size(); }
+    bool empty() const { return 0 == size(); }
+
+    int32 operator[]( size_t index ) const { return mList->GetItem( index )->AsInt()->value(); }
+
+    const_iterator begin() const { return const_iterator( mList, 0 ); }
+    const_iterator end() const { return const_iterator( mList, size() ); }
+
+    /** @return Copy of the viewed integers. */
+    std::vector<int32> vector() const
+    {
+        std::vector<int32> res;
+        res.reserve( size() );
+
+        for( size_t i = 0; i < size(); ++i )
+            res.push_back( (*this)[ i ] );
+
+        return res;
+    }
+
+protected:
+    const PyList* mList;
+};
+
+#endif /* !__PY_REP_VIEW_H__INCL__ */
@@ -0,0 +1,112 @@
+/*
+    ------------------------------------------------------------------------------------
+    LICENSE:
+    ------------------------------------------------------------------------------------
+    This file is part of EVEmu: EVE Online Server Emulator
+    Copyright 2006 - 2011 The EVEmu Team
+    For the latest information visit http://evemu.org
+    ------------------------------------------------------------------------------------
+    This program is free software; you can redistribute it and/or modify it under
+    the terms of the GNU Lesser General Public License as published by the Free Software
+    Foundation; either version 2 of the License, or (at your option) any later
+    version.
+
+    This program is distributed in the hope that it will be useful, but WITHOUT
+    ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+    FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public License along with
+    this program; if not, write to the Free Software Foundation, Inc., 59 Temple
+    Place - Suite 330, Boston, MA 02111-1307, USA, or go to
+    http://www.gnu.org/copyleft/lesser.txt.
+    ------------------------------------------------------------------------------------
+    Author:     EVEmu Team
+*/
+
+#ifndef __PYTHON__PY_STATIC_H__INCL__
+#define __PYTHON__PY_STATIC_H__INCL__
+
+#include "python/PyRep.h"
+
+/**
+ * @brief Shared instances of the most common immutable objects.
+ *
+ * Small integers, None, True/False, the empty tuple and interned
+ * strings are created once and never released; every New*() call
+ * just hands out a new reference to the shared instance instead of
+ * allocating another object. The caller owns the returned reference
+ * and releases it with PyDecRef() as usual.
+ *
+ * The shared objects are frozen (see PyRep::Freeze()), so any
+ * thread may take and release their references. The table of
+ * interned strings however is not guarded: NewString() must not
+ * run while another thread calls InternString().
+ *
+ * @note Never modify the returned objects; the empty tuple in
+ *       particular must not be resized or filled.
+ *
+ * @author EVEmu Team
+ */
+class PyStatic
+{
+public:
+    /// The smallest integer with a shared instance.
+    static const int32 SMALL_INT_MIN = -5;
+    /// The greatest integer with a shared instance.
+    static const int32 SMALL_INT_MAX = 256;
+    /// Most strings InternString() may add to the table of interned strings.
+    static const size_t MAX_INTERNED = 4096;
+
+    /**
+     * @return Reference to the shared integer if it's small; new integer otherwise.
+     */
+    static PyInt* NewInt( int32 value );
+    /**
+     * @return Reference to the shared boolean.
+     */
+    static PyBool* NewBool( bool value );
+    /**
+     * @return Reference to the shared none.
+     */
+    static PyNone* NewNone();
+    /**
+     * @return Reference to the shared empty tuple.
+     */
+    static PyTuple* NewEmptyTuple();
+
+    /**
+     * @brief Obtains a string, interned if possible.
+     *
+     * Does not intern the string if it is not interned yet, so it
+     * is safe to use on strings coming from the network.
+     *
+     * @param[in] str The string.
+     * @param[in] len Length of the string.
+     *
+     * @return Reference to the interned string if there is one; new string otherwise.
+     */
+    static PyString* NewString( const char* str, size_t len );
+    /** Calls NewString( const char*, size_t ) */
+    static PyString* NewString( const char* str ) { return NewString( str, ::strlen( str ) ); }
+
+    /**
+     * @brief Interns a string.
+     *
+     * Meant for identifiers taken from a finite set, like column names.
+     * The table of interned strings is preloaded with the marshal string
+     * table (see MarshalStringTable).
+     *
+     * @param[in] str The string.
+     * @param[in] len Length of the string.
+     *
+     * @return Reference to the interned string; new string if the table is full.
+     */
+    static PyString* InternString( const char* str, size_t len );
+    /** Calls InternString( const char*, size_t ) */
+    static PyString* InternString( const char* str ) { return InternString( str, ::strlen( str ) ); }
+
+    /** @return Number of interned strings. */
+    static size_t GetInternedCount();
+};
+
+#endif /* !__PYTHON__PY_STATIC_H__INCL__ */
@@ -0,0 +1,253 @@
+/*
+    ------------------------------------------------------------------------------------
+    LICENSE:
+    ------------------------------------------------------------------------------------
+    This file is part of EVEmu: EVE Online Server Emulator
+    Copyright 2006 - 2011 The EVEmu Team
+    For the latest information visit http://evemu.org
+    ------------------------------------------------------------------------------------
+    This program is free software; you can redistribute it and/or modify it under
+    the terms of the GNU Lesser General Public License as published by the Free Software
+    Foundation; either version 2 of the License, or (at your option) any later
+    version.
+
+    This program is distributed in the hope that it will be useful, but WITHOUT
+    ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+    FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public License along with
+    this program; if not, write to the Free Software Foundation, Inc., 59 Temple
+    Place - Suite 330, Boston, MA 02111-1307, USA, or go to
+    http://www.gnu.org/copyleft/lesser.txt.
+    ------------------------------------------------------------------------------------
+    Author:     EVEmu Team
+*/
+
+#ifndef __UTILS__MODIFIER_GRAPH_H__INCL__
+#define __UTILS__MODIFIER_GRAPH_H__INCL__
+
+/**
+ * @brief Dependency graph of attribute modifiers.
+ *
+ * Each modified attribute of an item is a node, and each modifier
+ * is an edge from the attribute it takes its value from (or from
+ * a constant) to the attribute it modifies. Changing a base value
+ * or adding or removing a modifier only marks the attributes
+ * downstream of it; Update() then recomputes just those, each
+ * from its own modifiers, with stacking penalties taken from
+ * a precomputed table.
+ *
+ * @author EVEmu Team
+ */
+class ModifierGraph
+{
+public:
+    /**
+     * @brief Operations of modifiers, in the order they are applied.
+     */
+    enum Operation
+    {
+        OP_PRE_ASSIGN,
+        OP_PRE_MULTIPLY,
+        OP_PRE_DIVIDE,
+        OP_ADD,
+        OP_SUBTRACT,
+        OP_POST_MULTIPLY,
+        OP_POST_DIVIDE,
+        OP_POST_PERCENT,
+        OP_POST_ASSIGN
+    };
+
+    /// Number of stacking penalties in the table; the ones past it are below 0.0001 %.
+    static const uint32 STACKING_PENALTY_COUNT = 10;
+
+    /**
+     * @brief Effectiveness of a stacked modifier.
+     *
+     * @param[in] index Position of the modifier among those of the attribute, strongest first.
+     *
+     * @return The effectiveness; 1.0 for the strongest one.
+     */
+    static double GetStackingPenalty( uint32 index );
+
+    /**
+     * @brief A modifier.
+     *
+     * A modifier is identified by its source item, source attribute,
+     * effect and target attribute; adding one with the same identity
+     * replaces it.
+     */
+    struct Modifier
+    {
+        uint32 sourceItemID;
+        /// Attribute of the source the value is taken from; 0 if it is a constant.
+        uint32 sourceAttributeID;
+        /// The constant value, if sourceAttributeID is 0.
+        double value;
+        uint32 effectID;
+
+        uint32 targetItemID;
+        uint32 targetAttributeID;
+
+        Operation operation;
+        /// True if stacking penalties apply.
+        bool penalized;
+    };
+
+    /**
+     * @brief An attribute whose value has been changed by Update().
+     */
+    struct Change
+    {
+        uint32 itemID;
+        uint32 attributeID;
+        double value;
+    };
+
+    ModifierGraph();
+
+    /** @return Number of the attributes. */
+    uint32 GetAttributeCount() const { return mNodes.size(); }
+    /** @return Number of the modifiers. */
+    uint32 GetModifierCount() const { return mEntries.size() - mFreeEntries.size(); }
+    /** @return Number of attributes recomputed since ResetRecomputeCount(). */
+    uint32 GetRecomputeCount() const { return mRecomputeCount; }
+    /** Resets the count of recomputed attributes. */
+    void ResetRecomputeCount() { mRecomputeCount = 0; }
+
+    /**
+     * @brief Sets the unmodified value of an attribute.
+     *
+     * @param[in] itemID      ID of the item.
+     * @param[in] attributeID ID of the attribute.
+     * @param[in] value       The value.
+     */
+    void SetBaseValue( uint32 itemID, uint32 attributeID, double value );
+    /**
+     * @brief Checks whether an attribute is in the graph.
+     *
+     * @param[in] itemID      ID of the item.
+     * @param[in] attributeID ID of the attribute.
+     *
+     * @return True if the attribute has a base value or modifiers.
+     */
+    bool HasAttribute( uint32 itemID, uint32 attributeID ) const;
+    /**
+     * @brief Obtains the modified value of an attribute.
+     *
+     * @param[in]  itemID      ID of the item.
+     * @param[in]  attributeID ID of the attribute.
+     * @param[out] into        The value.
+     *
+     * @return True if found, false if the attribute is not in the graph.
+     */
+    bool GetValue( uint32 itemID, uint32 attributeID, double& into );
+
+    /**
+     * @brief Adds a modifier, or replaces the one with the same identity.
+     *
+     * @param[in] modifier The modifier.
+     */
+    void AddModifier( const Modifier& modifier );
+    /**
+     * @brief Removes a modifier.
+     *
+     * @param[in] modifier The modifier; only its identity is used.
+     *
+     * @return True if removed, false if there is no such modifier.
+     */
+    bool RemoveModifier( const Modifier& modifier );
+    /**
+     * @brief Removes all modifiers of an effect.
+     *
+     * @param[in] sourceItemID ID of the item the effect belongs to.
+     * @param[in] effectID     ID of the effect.
+     *
+     * @return Number of the removed modifiers.
+     */
+    uint32 RemoveModifiers( uint32 sourceItemID, uint32 effectID );
+    /**
+     * @brief Removes an item, its attributes and all modifiers from or to it.
+     *
+     * @param[in] itemID ID of the item.
+     */
+    void RemoveItem( uint32 itemID );
+    /**
+     * @brief Removes everything.
+     */
+    void Clear();
+
+    /**
+     * @brief Recomputes the attributes affected by the changes since the last call.
+     *
+     * @param[out] changes The attributes whose values have changed.
+     */
+    void Update( std::vector< Change >& changes );
+
+protected:
+    /**
+     * @brief An attribute.
+     */
+    struct Node
+    {
+        uint32 itemID;
+        uint32 attributeID;
+
+        double base;
+        double value;
+        /// Value last reported by Update().
+        double reported;
+        /// True if the value needs to be recomputed.
+        bool dirty;
+
+        /// Indices of the modifiers of this attribute.
+        std::vector< uint32 > inbound;
+        /// Indices of the modifiers taking their value from this attribute.
+        std::vector< uint32 > outbound;
+    };
+    typedef std::tr1::unordered_map< uint64, Node > NodeMap;
+
+    /**
+     * @brief A modifier with the attributes it links.
+     */
+    struct Entry
+    {
+        Modifier modifier;
+
+        /// The source attribute, NULL for a constant.
+        Node* source;
+        Node* target;
+        /// False if the entry is free.
+        bool used;
+    };
+    typedef std::tr1::unordered_map< uint32, std::vector< uint32 > > SourceMap;
+
+    static uint64 _Key( uint32 itemID, uint32 attributeID ) { return ( (uint64)itemID << 32 ) | attributeID; }
+    static bool _SameIdentity( const Modifier& a, const Modifier& b );
+    static double _ApplyPenalized( std::vector< double >& factors );
+    static void _Erase( std::vector< uint32 >& from, uint32 index );
+
+    Node& _GetNode( uint32 itemID, uint32 attributeID );
+    int32 _FindEntry( const Modifier& modifier ) const;
+    void _RemoveEntry( uint32 index );
+    void _Invalidate( Node& node );
+    double _Evaluate( Node& node );
+
+    /// The attributes.
+    NodeMap mNodes;
+    /// The modifiers, indexed by their position.
+    std::vector< Entry > mEntries;
+    /// Indices of free entries.
+    std::vector< uint32 > mFreeEntries;
+    /// Indices of the modifiers of each source item.
+    SourceMap mSources;
+    /// Keys of attributes marked since the last Update().
+    std::vector< uint64 > mDirty;
+
+    uint32 mRecomputeCount;
+
+    /// The stacking penalties.
+    static const double sStackingPenalties[ STACKING_PENALTY_COUNT ];
+};
+
+#endif /* !__UTILS__MODIFIER_GRAPH_H__INCL__ */
@@ -0,0 +1,125 @@
+/*
+    ------------------------------------------------------------------------------------
+    LICENSE:
+    ------------------------------------------------------------------------------------
+    This file is part of EVEmu: EVE Online Server Emulator
+    Copyright 2006 - 2011 The EVEmu Team
+    For the latest information visit http://evemu.org
+    ------------------------------------------------------------------------------------
+    This program is free software; you can redistribute it and/or modify it under
+    the terms of the GNU Lesser General Public License as published by the Free Software
+    Foundation; either version 2 of the License, or (at your option) any later
+    version.
+
+    This program is distributed in the hope that it will be useful, but WITHOUT
+    ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+    FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public License along with
+    this program; if not, write to the Free Software Foundation, Inc., 59 Temple
+    Place - Suite 330, Boston, MA 02111-1307, USA, or go to
+    http://www.gnu.org/copyleft/lesser.txt.
+    ------------------------------------------------------------------------------------
+    Author:     EVEmu Team
+*/
+
+#ifndef __UTILS__RECHARGE_STATE_H__INCL__
+#define __UTILS__RECHARGE_STATE_H__INCL__
+
+/** Fraction of the capacity at which a recharging value counts as full. */
+extern const double RECHARGE_FULL_RATIO;
+
+/**
+ * @brief Closed-form model of capacitor and shield recharge.
+ *
+ * Keeps the value at a point in time along with the capacity and
+ * the recharge time, and computes the value at any later time with
+ * the EVE recharge formula
+ *
+ *     C(t) = Cmax * ( 1 + ( sqrt( C0 / Cmax ) - 1 ) * exp( -5 * t / T ) )^2
+ *
+ * so nothing has to be advanced every tic; the value is only
+ * rebased when it is changed from outside. Times are in milliseconds,
+ * the same clock as TimerWheel::now(); they are compared as
+ * differences, so the clock may wrap around.
+ *
+ * @author EVEmu Team
+ */
+class RechargeState
+{
+public:
+    RechargeState();
+
+    /** @return The capacity. */
+    double capacity() const { return mCapacity; }
+    /** @return Time (in milliseconds) of the full recharge cycle. */
+    double rechargeTime() const { return mRechargeTime; }
+
+    /**
+     * @brief Starts over with the given value.
+     *
+     * @param[in] capacity     The capacity.
+     * @param[in] rechargeTime Time (in milliseconds) of the full recharge cycle;
+     *                         no recharge if not positive.
+     * @param[in] value        The value at @a now.
+     * @param[in] now          The current time.
+     */
+    void Reset( double capacity, double rechargeTime, double value, uint32 now );
+    /**
+     * @brief Changes capacity and recharge time, keeping the current value.
+     *
+     * @param[in] capacity     The new capacity.
+     * @param[in] rechargeTime The new recharge time (in milliseconds).
+     * @param[in] now          The current time.
+     */
+    void SetLimits( double capacity, double rechargeTime, uint32 now );
+
+    /**
+     * @param[in] now The current time.
+     *
+     * @return The value at @a now.
+     */
+    double GetValue( uint32 now ) const;
+    /**
+     * @brief Sets the value, clamped to the capacity.
+     *
+     * @param[in] value The new value.
+     * @param[in] now   The current time.
+     */
+    void SetValue( double value, uint32 now );
+
+    /**
+     * @param[in] now The current time.
+     *
+     * @return True if the value reached RECHARGE_FULL_RATIO of the capacity.
+     */
+    bool IsFull( uint32 now ) const;
+    /**
+     * @brief Computes when the value reaches a level.
+     *
+     * @param[in] value The level.
+     * @param[in] now   The current time.
+     *
+     * @return Time (in milliseconds, relative to @a now) until the value
+     *         reaches @a value; 0 if it already has, 0xFFFFFFFF if never.
+     */
+    uint32 GetTimeToReach( double value, uint32 now ) const;
+    /**
+     * @param[in] now The current time.
+     *
+     * @return Time (in milliseconds, relative to @a now) until IsFull().
+     */
+    uint32 GetTimeToFull( uint32 now ) const { return GetTimeToReach( mCapacity * RECHARGE_FULL_RATIO, now ); }
+
+protected:
+    /// The capacity.
+    double mCapacity;
+    /// Time (in milliseconds) of the full recharge cycle.
+    double mRechargeTime;
+    /// The value at mStamp.
+    double mValue;
+    /// Time the value was set.
+    uint32 mStamp;
+};
+
+#endif /* !__UTILS__RECHARGE_STATE_H__INCL__ */
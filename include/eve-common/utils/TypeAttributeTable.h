@@ -0,0 +1,146 @@
+/*
+    ------------------------------------------------------------------------------------
+    LICENSE:
+    ------------------------------------------------------------------------------------
+    This file is part of EVEmu: EVE Online Server Emulator
+    Copyright 2006 - 2011 The EVEmu Team
+    For the latest information visit http://evemu.org
+    ------------------------------------------------------------------------------------
+    This program is free software; you can redistribute it and/or modify it under
+    the terms of the GNU Lesser General Public License as published by the Free Software
+    Foundation; either version 2 of the License, or (at your option) any later
+    version.
+
+    This program is distributed in the hope that it will be useful, but WITHOUT
+    ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+    FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public License along with
+    this program; if not, write to the Free Software Foundation, Inc., 59 Temple
+    Place - Suite 330, Boston, MA 02111-1307, USA, or go to
+    http://www.gnu.org/copyleft/lesser.txt.
+    ------------------------------------------------------------------------------------
+    Author:     EVEmu Team
+*/
+
+#ifndef __UTILS__TYPE_ATTRIBUTE_TABLE_H__INCL__
+#define __UTILS__TYPE_ATTRIBUTE_TABLE_H__INCL__
+
+#include "utils/EvilNumber.h"
+
+/**
+ * @brief Read-only table of attributes of types.
+ *
+ * The attributes are kept as struct of arrays, sorted by typeID
+ * and attributeID: the typeIDs with offsets of their first
+ * attributes, and contiguous attributeIDs and values. Finding
+ * a type is a binary search over the typeIDs, and its attributes
+ * are then adjacent in memory, unlike in node-based containers.
+ *
+ * @author EVEmu Team
+ */
+class TypeAttributeTable
+{
+public:
+    /**
+     * @brief Attributes of a single type.
+     */
+    class Range
+    {
+        friend class TypeAttributeTable;
+
+    public:
+        Range() : mAttributeIDs( NULL ), mValues( NULL ), mCount( 0 ) {}
+
+        /** @return Number of the attributes. */
+        uint32 size() const { return mCount; }
+        /** @return ID of the attribute at index. */
+        uint16 attributeID( uint32 index ) const { return mAttributeIDs[ index ]; }
+        /** @return Value of the attribute at index. */
+        const EvilNumber& value( uint32 index ) const { return mValues[ index ]; }
+
+        /**
+         * @brief Looks up an attribute.
+         *
+         * @param[in]  attributeID ID of the attribute.
+         * @param[out] into        The value.
+         *
+         * @return True if found, false if the type does not have the attribute.
+         */
+        bool Find( uint16 attributeID, EvilNumber& into ) const;
+
+    protected:
+        const uint16* mAttributeIDs;
+        const EvilNumber* mValues;
+        uint32 mCount;
+    };
+
+    TypeAttributeTable();
+
+    /** @return Number of the types. */
+    uint32 GetTypeCount() const { return mTypeIDs.size(); }
+    /** @return Number of the attributes of all types. */
+    uint32 GetAttributeCount() const { return mAttributeIDs.size(); }
+
+    /**
+     * @brief Adds an attribute.
+     *
+     * The attributes are added in any order; they may not be
+     * looked up until Build() is called.
+     *
+     * @param[in] typeID      ID of the type.
+     * @param[in] attributeID ID of the attribute.
+     * @param[in] value       The value.
+     */
+    void Add( uint32 typeID, uint16 attributeID, const EvilNumber& value );
+    /**
+     * @brief Sorts the added attributes into the table.
+     *
+     * If the same attribute of a type is added more than once,
+     * the last one added is kept.
+     */
+    void Build();
+    /**
+     * @brief Empties the table.
+     */
+    void Clear();
+
+    /**
+     * @brief Looks up the attributes of a type.
+     *
+     * @param[in]  typeID ID of the type.
+     * @param[out] into   The attributes; valid until the table is changed.
+     *
+     * @return True if found, false if the type has no attributes.
+     */
+    bool Find( uint32 typeID, Range& into ) const;
+
+protected:
+    /**
+     * @brief An attribute waiting for Build().
+     */
+    struct Entry
+    {
+        uint32 typeID;
+        uint16 attributeID;
+        /// Order in which it was added.
+        uint32 order;
+        EvilNumber value;
+
+        bool operator<( const Entry& oth ) const;
+    };
+
+    /// The added attributes.
+    std::vector< Entry > mPending;
+
+    /// The typeIDs, sorted.
+    std::vector< uint32 > mTypeIDs;
+    /// Index of the first attribute of each type, plus the end of the last one.
+    std::vector< uint32 > mOffsets;
+    /// IDs of the attributes, sorted within each type.
+    std::vector< uint16 > mAttributeIDs;
+    /// Values of the attributes.
+    std::vector< EvilNumber > mValues;
+};
+
+#endif /* !__UTILS__TYPE_ATTRIBUTE_TABLE_H__INCL__ */
@@ -0,0 +1,202 @@
+/*
+    ------------------------------------------------------------------------------------
+    LICENSE:
+    ------------------------------------------------------------------------------------
+    This file is part of EVEmu: EVE Online Server Emulator
+    Copyright 2006 - 2011 The EVEmu Team
+    For the latest information visit http://evemu.org
+    ------------------------------------------------------------------------------------
+    This program is free software; you can redistribute it and/or modify it under
+    the terms of the GNU Lesser General Public License as published by the Free Software
+    Foundation; either version 2 of the License, or (at your option) any later
+    version.
+
+    This program is distributed in the hope that it will be useful, but WITHOUT
+    ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+    FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public License along with
+    this program; if not, write to the Free Software Foundation, Inc., 59 Temple
+    Place - Suite 330, Boston, MA 02111-1307, USA, or go to
+    http://www.gnu.org/copyleft/lesser.txt.
+    ------------------------------------------------------------------------------------
+    Author:     EVEmu Team
+*/
+
+#ifndef __DATABASE__DB_ASYNC_QUEUE_H__INCL__
+#define __DATABASE__DB_ASYNC_QUEUE_H__INCL__
+
+#include "database/dbcore.h"
+#include "threading/Event.h"
+#include "threading/Mutex.h"
+#include "utils/Singleton.h"
+
+/**
+ * @brief A query run by DBAsyncQueue.
+ *
+ * Subclasses implement Complete(), which gets the result of the query
+ * on the game thread; the query is deleted right after. Subclasses
+ * which have more work to do off the game thread may override Run().
+ *
+ * @author EVEmu Team
+ */
+class DBAsyncQuery
+{
+    friend class DBAsyncQueue;
+
+public:
+    /**
+     * @brief Formats the query.
+     *
+     * @param[in] query_fmt printf-style format of the query, which
+     *                      must return a result.
+     */
+    DBAsyncQuery( const char* query_fmt, ... );
+    virtual ~DBAsyncQuery() {}
+
+    /** @return The query. */
+    const std::string& query() const { return mQuery; }
+
+protected:
+    /**
+     * @brief Creates a job with no query; for subclasses overriding Run().
+     */
+    DBAsyncQuery();
+
+    /**
+     * @brief Runs the query on the calling thread.
+     *
+     * Called by a worker thread, so it must not touch anything owned
+     * by the game thread.
+     *
+     * @return Whether the query succeeded.
+     */
+    virtual bool Run();
+
+    /**
+     * @brief Called on the game thread once the query is done.
+     *
+     * @param[in] success Whether the query succeeded.
+     * @param[in] result  The result; holds the error on failure.
+     */
+    virtual void Complete( bool success, DBQueryResult& result ) = 0;
+
+    /// The query.
+    std::string mQuery;
+    /// Whether the query only reads, so it may run on a read replica; false by default.
+    bool mReadOnly;
+
+private:
+    /// Whether the query succeeded.
+    bool mSuccess;
+    /// The result.
+    DBQueryResult mResult;
+};
+
+/**
+ * @brief Pool of threads running queries in the background.
+ *
+ * Queries are run through sDatabase by the worker threads, each on
+ * a connection of its own up to the size of the connection pool, so
+ * the game thread never waits for them. Results are handed back to
+ * the game thread in Process().
+ *
+ * @author EVEmu Team
+ */
+class DBAsyncQueue
+: public Singleton< DBAsyncQueue >
+{
+public:
+    /**
+     * @brief Creates queue with no threads running.
+     */
+    DBAsyncQueue();
+    /**
+     * @brief Stops all threads.
+     */
+    ~DBAsyncQueue();
+
+    /** @return True if there are worker threads running. */
+    bool IsRunning() const { return mRunning; }
+    /** @return Number of queries submitted but not completed yet. */
+    size_t GetPendingCount();
+
+    /**
+     * @brief Starts the worker threads.
+     *
+     * Does nothing if the queue is running already or
+     * @a threadCount is 0 (queries are then run synchronously
+     * by Submit(), but still completed by Process()).
+     *
+     * @param[in] threadCount Number of threads to start.
+     */
+    void Start( uint32 threadCount );
+    /**
+     * @brief Runs everything pending and stops all threads.
+     *
+     * Completes the queries as well, so it must be called by the game thread.
+     */
+    void Stop();
+
+    /**
+     * @brief Completes the queries which are done.
+     *
+     * Must be called periodically by the game thread.
+     *
+     * @return Number of completed queries.
+     */
+    size_t Process();
+
+    /**
+     * @brief Submits a query.
+     *
+     * @param[in] query The query; the queue takes ownership.
+     */
+    void Submit( DBAsyncQuery* query );
+
+    /**
+     * @brief Sets event to signal when a query is ready for completion.
+     *
+     * @param[in] event The event to signal; NULL to disable notifications.
+     */
+    void SetNotifyEvent( Event* event ) { mNotifyEvent = event; }
+
+protected:
+    void Run();
+    void Notify();
+
+#ifdef WIN32
+    static DWORD WINAPI WorkerLoop( LPVOID arg );
+#else /* !WIN32 */
+    static void* WorkerLoop( void* arg );
+#endif /* !WIN32 */
+
+    /// Protects the queues below.
+    Mutex mMQueue;
+    /// Queries waiting for a worker.
+    std::deque<DBAsyncQuery*> mQueue;
+    /// Queries waiting for completion.
+    std::vector<DBAsyncQuery*> mDone;
+    /// Number of queries being run right now.
+    size_t mInFlight;
+
+    /// Signaled when there is work (or the queue is stopping).
+    Event mWork;
+    /// Signaled when a query is ready for completion.
+    Event* volatile mNotifyEvent;
+    /// Cleared when the workers should stop.
+    volatile bool mRunning;
+
+    /// The worker threads.
+#ifdef WIN32
+    std::vector<HANDLE> mThreads;
+#else /* !WIN32 */
+    std::vector<pthread_t> mThreads;
+#endif /* !WIN32 */
+};
+
+/// A macro for easier access to the singleton.
+#define sDBAsync \
+    ( DBAsyncQueue::get() )
+
+#endif /* !__DATABASE__DB_ASYNC_QUEUE_H__INCL__ */
@@ -0,0 +1,235 @@
+/*
+    ------------------------------------------------------------------------------------
+    LICENSE:
+    ------------------------------------------------------------------------------------
+    This file is part of EVEmu: EVE Online Server Emulator
+    Copyright 2006 - 2011 The EVEmu Team
+    For the latest information visit http://evemu.org
+    ------------------------------------------------------------------------------------
+    This program is free software; you can redistribute it and/or modify it under
+    the terms of the GNU Lesser General Public License as published by the Free Software
+    Foundation; either version 2 of the License, or (at your option) any later
+    version.
+
+    This program is distributed in the hope that it will be useful, but WITHOUT
+    ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+    FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public License along with
+    this program; if not, write to the Free Software Foundation, Inc., 59 Temple
+    Place - Suite 330, Boston, MA 02111-1307, USA, or go to
+    http://www.gnu.org/copyleft/lesser.txt.
+    ------------------------------------------------------------------------------------
+    Author:     EVEmu Team
+*/
+
+#ifndef __DATABASE__DB_ROW_SCHEMA_H__INCL__
+#define __DATABASE__DB_ROW_SCHEMA_H__INCL__
+
+#include "database/dbcore.h"
+#include "utils/gpoint.h"
+
+/**
+ * @brief Decodes columns into a value of type T.
+ *
+ * Integers, bools and enums are all decoded as 64-bit integers;
+ * the other types are specialized below.
+ *
+ * @author EVEmu Team
+ */
+template< typename T >
+struct DBColumnDecoder
+{
+    /// Number of columns the value takes.
+    static const uint32 COLUMNS = 1;
+
+    template< typename Row >
+    static void Decode( const Row& row, uint32 index, T& into ) { into = static_cast< T >( row.GetInt64( index ) ); }
+    static void SetNull( T& into, int value ) { into = static_cast< T >( value ); }
+};
+
+template<>
+struct DBColumnDecoder< uint64 >
+{
+    static const uint32 COLUMNS = 1;
+
+    template< typename Row >
+    static void Decode( const Row& row, uint32 index, uint64& into ) { into = row.GetUInt64( index ); }
+    static void SetNull( uint64& into, int value ) { into = value; }
+};
+
+template<>
+struct DBColumnDecoder< float >
+{
+    static const uint32 COLUMNS = 1;
+
+    template< typename Row >
+    static void Decode( const Row& row, uint32 index, float& into ) { into = row.GetFloat( index ); }
+    static void SetNull( float& into, int value ) { into = (float)value; }
+};
+
+template<>
+struct DBColumnDecoder< double >
+{
+    static const uint32 COLUMNS = 1;
+
+    template< typename Row >
+    static void Decode( const Row& row, uint32 index, double& into ) { into = row.GetDouble( index ); }
+    static void SetNull( double& into, int value ) { into = value; }
+};
+
+template<>
+struct DBColumnDecoder< std::string >
+{
+    static const uint32 COLUMNS = 1;
+
+    template< typename Row >
+    static void Decode( const Row& row, uint32 index, std::string& into ) { into.assign( row.GetText( index ), row.ColumnLength( index ) ); }
+    static void SetNull( std::string& into, int ) { into.clear(); }
+};
+
+/**
+ * @brief Point takes three columns: x, y and z.
+ */
+template<>
+struct DBColumnDecoder< GPoint >
+{
+    static const uint32 COLUMNS = 3;
+
+    template< typename Row >
+    static void Decode( const Row& row, uint32 index, GPoint& into )
+    {
+        into.x = row.GetDouble( index );
+        into.y = row.GetDouble( index + 1 );
+        into.z = row.GetDouble( index + 2 );
+    }
+    static void SetNull( GPoint& into, int value ) { into = GPoint( value, value, value ); }
+};
+
+/**
+ * @brief Column of a row schema, decoded into a member of R.
+ *
+ * @param R          The struct being filled.
+ * @param T          Type of the member.
+ * @param M          The member.
+ * @param NULL_VALUE Value the member gets if the column is NULL.
+ *
+ * @author EVEmu Team
+ */
+template< typename R, typename T, T R::*M, int NULL_VALUE = 0 >
+struct DBField
+{
+    static const uint32 COLUMNS = DBColumnDecoder< T >::COLUMNS;
+
+    template< typename Row >
+    static void Decode( const Row& row, uint32 index, R& into )
+    {
+        if( row.IsNull( index ) )
+            DBColumnDecoder< T >::SetNull( into.*M, NULL_VALUE );
+        else
+            DBColumnDecoder< T >::Decode( row, index, into.*M );
+    }
+};
+
+/**
+ * @brief Unused field of DBRowSchema.
+ */
+struct DBNoField
+{
+    static const uint32 COLUMNS = 0;
+
+    template< typename Row, typename R >
+    static void Decode( const Row&, uint32, R& ) {}
+};
+
+/**
+ * @brief Layout of result rows, known at compile time.
+ *
+ * Lists the members of R the columns of a query go into, in their
+ * order, so that a whole row is decoded by a single call, each column
+ * exactly once and without looking anything up at runtime:
+ *
+ * @code
+ * typedef DBRowSchema< ItemData,
+ *     DBField< ItemData, std::string, &ItemData::name >,
+ *     DBField< ItemData, uint32,      &ItemData::ownerID, 1 >
+ * > ItemDataSchema;
+ *
+ * ItemData data;
+ * if( ItemDataSchema::GetRow( res, data ) ) ...
+ * @endcode
+ *
+ * Best used with DBcore::RunPrepared(), the binary results of which
+ * hold the numbers as they are, so nothing is converted from text.
+ *
+ * @author EVEmu Team
+ */
+template< typename R,
+          typename F0,               typename F1 = DBNoField,  typename F2 = DBNoField,  typename F3 = DBNoField,
+          typename F4 = DBNoField,   typename F5 = DBNoField,  typename F6 = DBNoField,  typename F7 = DBNoField,
+          typename F8 = DBNoField,   typename F9 = DBNoField,  typename F10 = DBNoField, typename F11 = DBNoField,
+          typename F12 = DBNoField,  typename F13 = DBNoField, typename F14 = DBNoField, typename F15 = DBNoField >
+class DBRowSchema
+{
+public:
+    /// Number of columns of the rows.
+    static const uint32 COLUMNS = F0::COLUMNS  + F1::COLUMNS  + F2::COLUMNS  + F3::COLUMNS
+                                + F4::COLUMNS  + F5::COLUMNS  + F6::COLUMNS  + F7::COLUMNS
+                                + F8::COLUMNS  + F9::COLUMNS  + F10::COLUMNS + F11::COLUMNS
+                                + F12::COLUMNS + F13::COLUMNS + F14::COLUMNS + F15::COLUMNS;
+
+    /**
+     * @brief Decodes a row.
+     *
+     * @param[in]  row   The row; a DBResultRow, or anything with the same
+     *                   getters, such as DBSnapshotRow.
+     * @param[out] into  The struct to fill.
+     * @param[in]  first Index of the first column of the schema; the columns
+     *                   before it are left to the caller.
+     *
+     * @return False if the row does not have the columns of the schema.
+     */
+    template< typename Row >
+    static bool Decode( const Row& row, R& into, uint32 first = 0 )
+    {
+        if( row.ColumnCount() != first + COLUMNS )
+            return false;
+
+        // the indexes are all constant but the first
+        uint32 index = first;
+        F0::Decode( row, index, into );  index += F0::COLUMNS;
+        F1::Decode( row, index, into );  index += F1::COLUMNS;
+        F2::Decode( row, index, into );  index += F2::COLUMNS;
+        F3::Decode( row, index, into );  index += F3::COLUMNS;
+        F4::Decode( row, index, into );  index += F4::COLUMNS;
+        F5::Decode( row, index, into );  index += F5::COLUMNS;
+        F6::Decode( row, index, into );  index += F6::COLUMNS;
+        F7::Decode( row, index, into );  index += F7::COLUMNS;
+        F8::Decode( row, index, into );  index += F8::COLUMNS;
+        F9::Decode( row, index, into );  index += F9::COLUMNS;
+        F10::Decode( row, index, into ); index += F10::COLUMNS;
+        F11::Decode( row, index, into ); index += F11::COLUMNS;
+        F12::Decode( row, index, into ); index += F12::COLUMNS;
+        F13::Decode( row, index, into ); index += F13::COLUMNS;
+        F14::Decode( row, index, into ); index += F14::COLUMNS;
+        F15::Decode( row, index, into );
+
+        return true;
+    }
+
+    /**
+     * @brief Fetches the next row of a result and decodes it.
+     *
+     * @param[in]  res  The result.
+     * @param[out] into The struct to fill.
+     *
+     * @return False if there are no more rows or the row does not have the columns of the schema.
+     */
+    static bool GetRow( DBQueryResult& res, R& into )
+    {
+        DBResultRow row;
+        return res.GetRow( row ) && Decode( row, into );
+    }
+};
+
+#endif /* !__DATABASE__DB_ROW_SCHEMA_H__INCL__ */
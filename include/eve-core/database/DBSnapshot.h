@@ -0,0 +1,191 @@
+/*
+    ------------------------------------------------------------------------------------
+    LICENSE:
+    ------------------------------------------------------------------------------------
+    This file is part of EVEmu: EVE Online Server Emulator
+    Copyright 2006 - 2011 The EVEmu Team
+    For the latest information visit http://evemu.org
+    ------------------------------------------------------------------------------------
+    This program is free software; you can redistribute it and/or modify it under
+    the terms of the GNU Lesser General Public License as published by the Free Software
+    Foundation; either version 2 of the License, or (at your option) any later
+    version.
+
+    This program is distributed in the hope that it will be useful, but WITHOUT
+    ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+    FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public License along with
+    this program; if not, write to the Free Software Foundation, Inc., 59 Temple
+    Place - Suite 330, Boston, MA 02111-1307, USA, or go to
+    http://www.gnu.org/copyleft/lesser.txt.
+    ------------------------------------------------------------------------------------
+    Author:     EVEmu Team
+*/
+
+#ifndef __DATABASE__DB_SNAPSHOT_H__INCL__
+#define __DATABASE__DB_SNAPSHOT_H__INCL__
+
+#include "database/dbcore.h"
+#include "utils/Buffer.h"
+
+/**
+ * @brief Writes results of queries into a snapshot file.
+ *
+ * The rows are kept as they are in the result: numbers in binary,
+ * texts NUL-terminated, all of a table in a single block, so the
+ * file is read back by DBSnapshot in one go.
+ *
+ * @author EVEmu Team
+ */
+class DBSnapshotWriter
+{
+public:
+    DBSnapshotWriter();
+
+    /** @return Number of tables added so far. */
+    uint32 GetTableCount() const { return mTableCount; }
+
+    /**
+     * @brief Adds all rows of a result as a table.
+     *
+     * @param[in] name   Name of the table.
+     * @param[in] result The result; its rows are fetched.
+     *
+     * @return Number of the added rows.
+     */
+    uint32 AddTable( const char* name, DBQueryResult& result );
+
+    /**
+     * @brief Writes the snapshot.
+     *
+     * The file is written under a temporary name and renamed,
+     * so readers never see it half-written.
+     *
+     * @param[in] filename Name of the file.
+     *
+     * @return True on success, false on failure.
+     */
+    bool Save( const char* filename ) const;
+
+protected:
+    /// The tables written so far.
+    Buffer mTables;
+    /// Number of the tables.
+    uint32 mTableCount;
+};
+
+class DBSnapshot;
+
+/**
+ * @brief A row of a DBSnapshot table.
+ *
+ * Has the getters of DBResultRow, so DBRowSchema may decode it.
+ *
+ * @author EVEmu Team
+ */
+class DBSnapshotRow
+{
+    friend class DBSnapshot;
+
+public:
+    DBSnapshotRow();
+
+    bool IsNull( uint32 index ) const { return 0 != mNulls[ index ]; }
+
+    /* numbers are formatted; the text is valid until the next call. */
+    const char* GetText( uint32 index ) const;
+    int32 GetInt( uint32 index ) const { return static_cast< int32 >( GetInt64( index ) ); }
+    bool GetBool( uint32 index ) const { return 0 != GetInt64( index ); }
+    uint32 GetUInt( uint32 index ) const { return static_cast< uint32 >( GetUInt64( index ) ); }
+    int64 GetInt64( uint32 index ) const;
+    uint64 GetUInt64( uint32 index ) const;
+    float GetFloat( uint32 index ) const { return static_cast< float >( GetDouble( index ) ); }
+    double GetDouble( uint32 index ) const;
+
+    uint32 ColumnCount() const { return mColumnCount; }
+    uint32 ColumnLength( uint32 index ) const;
+
+protected:
+    /// Gets the raw value of a cell.
+    uint64 _GetValue( uint32 index ) const;
+
+    uint32 mColumnCount;
+    /// Kinds of the columns.
+    const uint8* mKinds;
+    /// NULL flags of the cells of the row.
+    const uint8* mNulls;
+    /// Values of the cells of the row.
+    const uint8* mValues;
+    /// Texts of the table.
+    const char* mText;
+
+    /// Numbers formatted by GetText().
+    mutable std::string mFormatted;
+};
+
+/**
+ * @brief Snapshot of query results, read from a file.
+ *
+ * The whole file is read by a single sequential read, and the tables
+ * are then served straight from it.
+ *
+ * @author EVEmu Team
+ */
+class DBSnapshot
+{
+public:
+    /**
+     * @brief A table of the snapshot.
+     */
+    class Table
+    {
+        friend class DBSnapshot;
+
+    public:
+        const std::string& name() const { return mName; }
+
+        uint32 ColumnCount() const { return mColumnCount; }
+        uint32 RowCount() const { return mRowCount; }
+
+        /**
+         * @brief Gets a row.
+         *
+         * @param[in]  index Index of the row.
+         * @param[out] into  The row; valid until the snapshot is destroyed.
+         *
+         * @return False if there is no such row.
+         */
+        bool GetRow( uint32 index, DBSnapshotRow& into ) const;
+
+    protected:
+        std::string mName;
+        uint32 mColumnCount;
+        uint32 mRowCount;
+
+        const uint8* mKinds;
+        const uint8* mNulls;
+        const uint8* mValues;
+        const char* mText;
+    };
+
+    /**
+     * @brief Reads a snapshot file.
+     *
+     * @param[in] filename Name of the file.
+     *
+     * @return False if the file could not be read or is not a valid snapshot.
+     */
+    bool Load( const char* filename );
+
+    /** @return The table of the given name; NULL if there is none. */
+    const Table* GetTable( const char* name ) const;
+
+protected:
+    /// The contents of the file.
+    Buffer mData;
+    /// The tables, pointing into mData.
+    std::vector< Table > mTables;
+};
+
+#endif /* !__DATABASE__DB_SNAPSHOT_H__INCL__ */
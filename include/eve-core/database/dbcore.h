@@ -30,6 +30,7 @@
 //if you can get over the SQL incompatibilities and mysql auto increment problems.
 
 #include "database/dbtype.h"
+#include "threading/Event.h"
 #include "threading/Mutex.h"
 #include "utils/Singleton.h"
 
@@ -46,8 +47,9 @@ public:
     const char* c_str() const { return GetError(); }
 
 protected:
-    //for DBcore:
+    //for DBcore and DBQueryResult:
     friend class DBcore;
+    friend class DBQueryResult;
     void SetError( uint32 err, const char* str );
     void ClearError();
 
@@ -56,6 +58,51 @@ protected:
 };
 
 
+/**
+ * @brief Typed parameters of a prepared statement.
+ *
+ * The values are sent as they are, so unlike the arguments
+ * of RunQuery() they need no escaping.
+ */
+class DBParams
+{
+public:
+    DBParams& Add( int32 value )                { return _AddInt( value, false ); }
+    DBParams& Add( uint32 value )               { return _AddInt( value, true ); }
+    DBParams& Add( int64 value )                { return _AddInt( value, false ); }
+    DBParams& Add( uint64 value )               { return _AddInt( (int64)value, true ); }
+    DBParams& Add( double value );
+    DBParams& Add( const char* value );
+    DBParams& Add( const std::string& value );
+    /** @brief Adds a binary string. */
+    DBParams& AddBinary( const void* data, size_t length );
+    /** @brief Adds SQL NULL. */
+    DBParams& AddNull();
+
+    size_t size() const { return mParams.size(); }
+    void clear() { mParams.clear(); }
+
+protected:
+    //for DBcore:
+    friend class DBcore;
+
+    struct Param
+    {
+        enum_field_types type;
+        bool isUnsigned;
+        union
+        {
+            int64 i;
+            double d;
+        };
+        std::string s;
+    };
+
+    DBParams& _AddInt( int64 value, bool isUnsigned );
+
+    std::vector<Param> mParams;
+};
+
 class DBResultRow;
 class DBQueryResult
 {
@@ -67,9 +114,14 @@ public:
     DBerror error;
 
     bool GetRow( DBResultRow& into );
-    size_t GetRowCount() { return (size_t)mResult->row_count; }
+    /* rows of a streamed result are only counted as they are fetched. */
+    size_t GetRowCount() { return ( mBinary ? mRowCount : (size_t)mResult->row_count ); }
+    /* streamed result cannot be rewound. */
     void Reset();
 
+    /** @return True if the rows are fetched as they arrive, see DBcore::RunQueryStream(). */
+    bool IsStreamed() const { return mStreamed; }
+
     uint32 ColumnCount() const { return mColumnCount; }
     const char* ColumnName( uint32 index ) const;
     DBTYPE ColumnType( uint32 index ) const;
@@ -81,11 +133,67 @@ protected:
     //for DBcore:
     friend class DBcore;
     void SetResult( MYSQL_RES** res, uint32 colCount );
+    /**
+     * @brief Fetches the whole binary result of executed statement.
+     *
+     * @return False on failure, the error is stored in @a error.
+     */
+    bool SetResult( MYSQL_STMT* stmt );
+    /**
+     * @brief Takes the result of DBcore::RunQueryStream().
+     *
+     * The connection stays checked out until all the rows
+     * are fetched or the result is destroyed.
+     */
+    void SetStream( MYSQL_RES** res, uint32 colCount, MYSQL* mysql );
+    /// Returns the connection of the streamed result to the pool.
+    void _EndStream( bool failed );
+
+    //for DBResultRow:
+    friend class DBResultRow;
+
+    /**
+     * @brief A value of binary result; numbers are kept as they are.
+     */
+    struct Cell
+    {
+        enum Kind { Int, UInt, Real, Text };
+
+        union
+        {
+            int64 i;
+            double d;
+        };
+        /// Where the text is in mData and its length.
+        uint32 offset;
+        uint32 length;
+        uint8 kind;
+        bool null;
+    };
+
+    /// Formats a number of binary result for DBResultRow::GetText().
+    const char* _FormatCell( uint32 index, const Cell& cell );
 
     uint32 mColumnCount;
     MYSQL_RES* mResult;
     MYSQL_FIELD** mFields;
 
+    /// Whether the result came in binary; mResult then only holds the metadata.
+    bool mBinary;
+    /// The binary rows, ColumnCount() cells each.
+    std::vector<Cell> mCells;
+    /// Texts of the binary rows, NUL-terminated.
+    std::vector<char> mData;
+    size_t mRowCount;
+    size_t mNextRow;
+    /// Numbers of the current row formatted by GetText(), by column.
+    std::vector<std::string> mText;
+
+    /// Whether the result is streamed.
+    bool mStreamed;
+    /// The connection the rows are coming from; NULL once they are all fetched.
+    MYSQL* mStreamMysql;
+
     static const DBTYPE MYSQL_DBTYPE_TABLE_SIGNED[];
     static const DBTYPE MYSQL_DBTYPE_TABLE_UNSIGNED[];
 };
@@ -95,9 +203,10 @@ class DBResultRow
 public:
     DBResultRow();
 
-    bool IsNull( uint32 index ) const { return ( NULL == GetText( index ) ); }
+    bool IsNull( uint32 index ) const { return ( NULL == mCells ? NULL == mRow[ index ] : mCells[ index ].null ); }
 
-    const char* GetText( uint32 index ) const { return mRow[ index ]; }
+    /* numbers of binary results are formatted; the text is valid until the next row. */
+    const char* GetText( uint32 index ) const { return ( NULL == mCells ? mRow[ index ] : _GetCellText( index ) ); }
     int32 GetInt( uint32 index ) const;
     bool GetBool( uint32 index ) const;
     uint32 GetUInt( uint32 index ) const;
@@ -119,23 +228,203 @@ protected:
     //for DBQueryResult
     friend class DBQueryResult;
     void SetData( DBQueryResult* res, MYSQL_ROW& row, const unsigned long* lengths );
+    void SetData( DBQueryResult* res, const DBQueryResult::Cell* cells );
+
+    //values of binary result:
+    const char* _GetCellText( uint32 index ) const;
+    int64 _GetCellInt64( uint32 index ) const;
+    uint64 _GetCellUInt64( uint32 index ) const;
+    double _GetCellDouble( uint32 index ) const;
 
     MYSQL_ROW mRow;
     const unsigned long* mLengths;
+    /// Row of binary result; NULL if the result is text.
+    const DBQueryResult::Cell* mCells;
 
     DBQueryResult* mResult;
 };
 
+/**
+ * @brief Pool of connections to the database.
+ *
+ * Every query checks out a connection of its own for its duration, so
+ * that a slow query of one thread does not hold up the others; up to
+ * the pool size of connections are opened on demand. A query which
+ * finds all of them busy waits for one to be returned.
+ */
 class DBcore
 : public Singleton<DBcore>
 {
 public:
     enum eStatus { Closed, Connected, Error };
 
+    /**
+     * @brief Statistics of connection checkouts.
+     */
+    struct Stats
+    {
+        Stats() { Reset(); }
+
+        void Reset()
+        {
+            checkouts = 0;
+            waits = 0;
+            waitTime = 0;
+            maxWaitTime = 0;
+            reconnects = 0;
+            pingFailures = 0;
+            prepares = 0;
+            replicaReads = 0;
+            primaryReads = 0;
+        }
+
+        /// Number of checked out connections.
+        uint32 checkouts;
+        /// Number of checkouts which had to wait for a busy connection.
+        uint32 waits;
+        /// Total time spent waiting (in milliseconds).
+        uint32 waitTime;
+        /// The longest wait (in milliseconds).
+        uint32 maxWaitTime;
+        /// Number of reconnects of lost connections.
+        uint32 reconnects;
+        /// Number of connections which failed a health check.
+        uint32 pingFailures;
+        /// Number of prepared statements (cache misses).
+        uint32 prepares;
+        /// Number of read-only queries run on replicas.
+        uint32 replicaReads;
+        /// Number of read-only queries which fell back to the primary.
+        uint32 primaryReads;
+    };
+
+    /**
+     * @brief Statistics of a single statement, keyed by its fingerprint.
+     */
+    struct QueryStats
+    {
+        /// Number of latency histogram buckets; bucket i holds queries shorter than 10^(i+1) us.
+        static const size_t HISTOGRAM_SIZE = 7;
+
+        QueryStats();
+
+        /**
+         * @brief Records a query.
+         *
+         * @param[in] time     Duration of the query in microseconds.
+         * @param[in] rows     Number of rows returned or affected.
+         * @param[in] waitTime Time (in milliseconds) spent waiting for the connection.
+         * @param[in] file     Call site of the query; may be NULL.
+         * @param[in] line     Line of the call site.
+         */
+        void Record( uint64 time, uint64 rows, uint32 waitTime, const char* file, int line );
+
+        uint64 calls;
+        uint64 rows;
+        /// Total and longest duration of the queries in microseconds.
+        uint64 totalTime;
+        uint64 maxTime;
+        /// Total time (in milliseconds) spent waiting for connections.
+        uint64 waitTime;
+        uint64 histogram[ HISTOGRAM_SIZE ];
+        /// Call site of the longest query.
+        const char* maxFile;
+        int maxLine;
+        /// A run of the statement with its values, for the index advisor; empty unless sampled.
+        std::string sample;
+    };
+    typedef std::map<std::string, QueryStats> QueryStatsMap;
+
+    /**
+     * @brief A table a sampled statement reads without a fitting index, as EXPLAIN reports it.
+     */
+    struct IndexAdvice
+    {
+        /// The statement.
+        std::string fingerprint;
+        /// Number of its runs and their total duration in microseconds.
+        uint64 calls;
+        uint64 totalTime;
+        /// The table, how it is read ("ALL" is a full scan, "index" a full index scan) and the key used, if any.
+        std::string table;
+        std::string access;
+        std::string key;
+        /// Number of rows MySQL expects to examine.
+        uint64 rows;
+        /// The extra information, e.g. "Using filesort" or "Using temporary".
+        std::string extra;
+    };
+
     DBcore(bool compress=false, bool ssl=false);
     ~DBcore();
     eStatus GetStatus() const { return pStatus; }
 
+    /**
+     * @brief Sets maximal number of open connections.
+     *
+     * Connections above the new size are closed once they are returned.
+     *
+     * @param[in] size The new size; at least 1.
+     */
+    void SetPoolSize( size_t size );
+    /** @return Maximal number of open connections. */
+    size_t GetPoolSize() const { return mPoolSize; }
+
+    /** @return Statistics since the last ResetStats(). */
+    Stats GetStats();
+    /** @brief Resets the statistics. */
+    void ResetStats();
+
+    /** @brief Copies the statistics of the statements since the last ResetQueryStats(). */
+    void GetQueryStats( QueryStatsMap& into );
+    /** @brief Resets the statistics of the statements. */
+    void ResetQueryStats();
+    /**
+     * @brief Sets the duration above which queries are logged with their call site.
+     *
+     * @param[in] threshold The duration (in milliseconds); 0 disables the log.
+     */
+    void SetSlowQueryThreshold( uint32 threshold );
+    /**
+     * @brief Enables or disables the index advisor.
+     *
+     * While enabled, the first run of every statement (except the
+     * prepared ones, whose values are not in the text) is kept as
+     * its sample, which AdviseIndexes() explains.
+     */
+    void SetIndexAdvisor( bool enabled );
+    /** @return True if the statements are being sampled. */
+    bool IsIndexAdvisorEnabled() const { return mIndexAdvisor; }
+    /**
+     * @brief Explains the samples of the most expensive statements.
+     *
+     * Reports the tables they read by a full scan (of the table or of
+     * an index) and those needing a filesort or a temporary table.
+     * Runs the EXPLAINs on the calling thread.
+     *
+     * @param[in]  count The most statements explained, by total time.
+     * @param[out] into  The findings, the most expensive statements first.
+     *
+     * @return Number of statements explained.
+     */
+    size_t AdviseIndexes( size_t count, std::vector<IndexAdvice>& into );
+
+    /**
+     * @brief Remembers the call site of the following queries of the calling thread.
+     *
+     * sDatabase goes through it, so every query is attributed to
+     * the line which ran it.
+     *
+     * @return The database itself.
+     */
+    DBcore& At( const char* file, int line );
+    /**
+     * @brief Normalizes a statement, so that its runs with different values look the same.
+     *
+     * Literals become '?', lists of them a single '?' and whitespace is squeezed.
+     */
+    static std::string Fingerprint( const char* query, size_t len );
+
     //new shorter syntax:
     //query which returns a result (error is stored in the result if it occurs)
     bool    RunQuery(DBQueryResult &into, const char *query_fmt, ...);
@@ -145,6 +434,35 @@ public:
     bool    RunQuery(DBerror &err, uint32 &affected_rows, const char *query_fmt, ...);
     //query which returns last insert ID:
     bool    RunQueryLID(DBerror &err, uint32 &last_insert_id, const char *query_fmt, ...);
+    //already formatted query which returns a result, of any length:
+    bool    RunQueryString(DBQueryResult &into, const std::string &query);
+    //query which returns a result fetched row by row as it arrives, nothing is buffered;
+    //the connection stays checked out until all the rows are fetched, so run no other
+    //query from the same thread meanwhile, it could wait for the connection forever:
+    bool    RunQueryStream(DBQueryResult &into, const char *query_fmt, ...);
+
+    //prepared statements with '?' placeholders for the params; each is prepared
+    //once per connection and the results come in binary, so nothing is parsed:
+    //statement which returns a result
+    bool    RunPrepared(DBQueryResult &into, const char *query, const DBParams &params);
+    //statement which returns no information except error status
+    bool    RunPrepared(DBerror &err, const char *query, const DBParams &params);
+    //statement which returns affected rows
+    bool    RunPrepared(DBerror &err, uint32 &affected_rows, const char *query, const DBParams &params);
+
+    //read-only queries, run on a replica if there is an up to date one, otherwise on the primary;
+    //replicas may be a few seconds behind, so only use these where that does not matter:
+    bool    RunReadQuery(DBQueryResult &into, const char *query_fmt, ...);
+    bool    RunReadQueryString(DBQueryResult &into, const std::string &query);
+    bool    RunReadQueryStream(DBQueryResult &into, const char *query_fmt, ...);
+    bool    RunReadPrepared(DBQueryResult &into, const char *query, const DBParams &params);
+
+    //queries which return no information, run on one connection in a single transaction;
+    //rolled back if any of them fails:
+    bool    RunTransaction(DBerror &err, const std::vector<std::string> &queries);
+    //the same, but the last query returns a result; it is read before the commit,
+    //so it sees what the transaction did (LAST_INSERT_ID(), user variables):
+    bool    RunTransaction(DBQueryResult &into, const std::vector<std::string> &queries);
 
     //old style to be used with MakeAnyLengthString
     bool    RunQuery(const char* query, int32 querylen, char* errbuf = 0, MYSQL_RES** result = 0, int32* affected_rows = 0, int32* last_insert_id = 0, int32* errnum = 0, bool retry = true);
@@ -152,22 +470,167 @@ public:
     int32   DoEscapeString(char* tobuf, const char* frombuf, int32 fromlen);
     void    DoEscapeString(std::string &to, const std::string &from);
     static bool IsSafeString(const char *str);
-    void    ping();
+
+    /**
+     * @brief Checks health of the idle connections.
+     *
+     * Pings every connection which is not in use; those which fail are
+     * reconnected by the next query which checks them out.
+     *
+     * @return Number of connections which failed.
+     */
+    size_t  ping();
+
+    /**
+     * @brief Adds a read replica of the primary.
+     *
+     * The replica is connected to with the account and database of the
+     * primary and gets a pool of its own of the same size. It is not
+     * used until CheckReplicas() finds it up to date.
+     *
+     * @param[in] host Host of the replica.
+     * @param[in] port Port of the replica.
+     */
+    void    AddReplica(const char* host, int16 port);
+    /**
+     * @brief Checks replication lag of the replicas.
+     *
+     * Replicas which are unreachable, do not replicate or lag behind
+     * more than allowed get no read-only queries until a later check
+     * finds them up to date again.
+     *
+     * @param[in] maxLag The greatest acceptable lag (in seconds).
+     *
+     * @return Number of replicas in use.
+     */
+    size_t  CheckReplicas(uint32 maxLag);
 
 //  static bool ReadDBINI(char *host, char *user, char *pass, char *db, int32 &port, bool &compress, bool *items);
     bool    Open(const char* iHost, const char* iUser, const char* iPassword, const char* iDatabase, int16 iPort, int32* errnum = 0, char* errbuf = 0, bool iCompress = false, bool iSSL = false);
     bool    Open(DBerror &err, const char* iHost, const char* iUser, const char* iPassword, const char* iDatabase, int16 iPort, bool iCompress = false, bool iSSL = false);
 
-protected:
-    MYSQL*  getMySQL(){ return &mysql; }
-
 private:
-    //MDatabase must be locked before these calls:
-    bool    Open_locked(int32* errnum = 0, char* errbuf = 0);
-    bool    DoQuery_locked(DBerror &err, const char *query, int32 querylen, bool retry = true);
+    //for DBQueryResult:
+    friend class DBQueryResult;
+
+    struct Replica;
+
+    /**
+     * @brief A single connection of the pool.
+     */
+    struct Connection
+    {
+        Connection();
+        ~Connection();
+
+        MYSQL   mysql;
+        eStatus status;
+        /// Whether the connection has ever been connected.
+        bool    opened;
+        /// Statements prepared on the connection, by query.
+        std::map<std::string, MYSQL_STMT*> statements;
+        /// Time (in milliseconds) the current checkout waited for the connection; counted by its first query.
+        uint32  waitTime;
+        /// The replica the connection goes to; NULL if it goes to the primary.
+        Replica* replica;
+
+        /// Closes the statements; they do not survive reconnects.
+        void    CloseStatements();
+    };
+
+    /**
+     * @brief A read replica with its pool of connections.
+     */
+    struct Replica
+    {
+        Replica(const char* _host, int16 _port);
+        ~Replica();
+
+        std::string host;
+        int16   port;
+        /// All open connections of the replica.
+        std::vector<Connection*> connections;
+        /// The connections not in use.
+        std::vector<Connection*> idle;
+        /// Whether the last check found the replica up to date.
+        bool    fresh;
+        /// Whether the replica has been checked yet.
+        bool    checked;
+    };
+
+    /**
+     * @brief Checks out a connection for its lifetime.
+     */
+    class ConnectionLock
+    {
+    public:
+        ConnectionLock( DBcore& db ) : mDB( db ), mConnection( db.Acquire() ) {}
+        ConnectionLock( DBcore& db, Connection* conn ) : mDB( db ), mConnection( conn ) {}
+        ~ConnectionLock() { mDB.Release( mConnection ); }
+
+        Connection& operator*() const { return *mConnection; }
+        MYSQL* mysql() const { return &mConnection->mysql; }
+
+    private:
+        DBcore& mDB;
+        Connection* const mConnection;
+    };
+
+    /// Checks out a connection of the replica (the primary if NULL), waiting for one if all are busy.
+    Connection* Acquire( Replica* replica = NULL );
+    /// Checks out a connection for a read-only query: of an up to date replica if there is one.
+    Connection* AcquireRead();
+    /**
+     * @brief Stops using the replica of a connection which has been lost.
+     *
+     * @param[in] conn The connection.
+     * @param[in] err  Error of the failed query.
+     *
+     * @return True if the connection goes to a replica which has been lost, so the query should go to the primary.
+     */
+    bool    ReplicaFailed( Connection& conn, const DBerror& err );
+    /// Returns a connection to the pool.
+    void    Release( Connection* conn );
+    /// Returns the connection of a streamed result to the pool, reconnecting it if the stream failed.
+    void    EndStream( MYSQL* mysql, bool failed );
+
+    //the connection must be checked out before these calls:
+    bool    Open_locked(Connection& conn, int32* errnum = 0, char* errbuf = 0);
+    //queries with a result store it into the given one, if any:
+    bool    DoQuery_locked(Connection& conn, DBerror &err, const char *query, int32 querylen, bool retry = true, MYSQL_RES **result = NULL);
+    bool    DoResultQuery_locked(Connection& conn, DBQueryResult &into, const char *query, int32 querylen);
+    //takes over the connection, the result returns it:
+    bool    DoStreamQuery(Connection* conn, DBQueryResult &into, const char *query, int32 querylen);
+    MYSQL_STMT* DoPrepared_locked(Connection& conn, DBerror &err, const char *query, const DBParams &params, bool retry = true, DBQueryResult *into = NULL);
+    /// Counts a query in the statistics of its statement, logs it if it was slow; samples it for the index advisor if asked to.
+    void    RecordQuery(Connection& conn, const char *query, size_t querylen, uint64 time, uint64 rows, bool sample);
+
+    /// Protects the pool and the stats.
+    Mutex   mPoolMutex;
+    /// Signaled whenever a connection is returned.
+    Event   mPoolEvent;
+    /// All open connections.
+    std::vector<Connection*> mConnections;
+    /// The connections not in use.
+    std::vector<Connection*> mIdle;
+    /// Maximal number of connections.
+    size_t  mPoolSize;
+    /// The read replicas.
+    std::vector<Replica*> mReplicas;
+    /// The replica next in turn for a read-only query.
+    size_t  mNextReplica;
+    /// Statistics.
+    Stats   mStats;
+
+    /// Protects the statistics of the statements.
+    Mutex   mQueryStatsMutex;
+    /// Statistics of the statements, by fingerprint.
+    QueryStatsMap mQueryStats;
+    /// Duration (in milliseconds) above which queries are logged; 0 if none.
+    uint32  mSlowQueryThreshold;
+    /// Whether the statements are sampled for the index advisor.
+    volatile bool mIndexAdvisor;
 
-    MYSQL   mysql;
-    Mutex   MDatabase;
     eStatus pStatus;
 
     std::string pHost;
@@ -180,6 +643,6 @@ private:
 };
 
 #define sDatabase \
-    ( DBcore::get() )
+    ( DBcore::get().At( __FILE__, __LINE__ ) )
 
 #endif /* !__DATABASE__DBCORE_H__INCL__ */
@@ -217,6 +217,13 @@ float strtof( const char* nptr, char** endptr );
 tm* localtime_r( const time_t* timep, tm* result );
 #endif /* !HAVE_LOCALTIME_R */
 
+/*************************************************************************/
+/* unistd.h                                                              */
+/*************************************************************************/
+#ifndef HAVE_FSYNC
+#   define fsync _commit
+#endif /* !HAVE_FSYNC */
+
 /*************************************************************************/
 /* sys/socket.h                                                          */
 /*************************************************************************/
@@ -231,6 +238,15 @@ tm* localtime_r( const time_t* timep, tm* result );
 /*************************************************************************/
 /* Various other compatibility stuff                                     */
 /*************************************************************************/
+/*
+ * Storage class of variables which have an instance per thread.
+ */
+#ifdef _MSC_VER
+#   define THREAD_LOCAL __declspec( thread )
+#else /* !_MSC_VER */
+#   define THREAD_LOCAL __thread
+#endif /* !_MSC_VER */
+
 #ifndef WIN32
 #   define INVALID_SOCKET -1
 #   define SOCKET_ERROR   -1
@@ -114,7 +114,9 @@
 #   include <unistd.h>
 #   include <arpa/inet.h>
 #   include <netinet/in.h>
+#   include <sys/mman.h>
 #   include <sys/socket.h>
+#   include <sys/uio.h>
 #endif /* !WIN32 */
 
 #ifdef HAVE_CRTDBG_H
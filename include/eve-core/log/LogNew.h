@@ -26,6 +26,9 @@
 #ifndef __LOG__LOG_NEW_H__INCL__
 #define __LOG__LOG_NEW_H__INCL__
 
+#include "log/logsys.h"
+#include "threading/Event.h"
+#include "threading/LockFreeQueue.h"
 #include "threading/Mutex.h"
 #include "utils/Singleton.h"
 
@@ -35,6 +38,12 @@
  * This class is designed to be a simple logging system that both logs to file
  * and console regarding the settings.
  *
+ * In the asynchronous mode the callers only format the message into
+ * a record and queue it without taking any lock; a writer thread
+ * renders the queued records (of logsys as well) and writes them in
+ * batches. Records which do not fit the queue are dropped and counted
+ * by their category.
+ *
  * @author Captnoord.
  * @date August 2009
  */
@@ -120,6 +129,65 @@ public:
      */
     void SetTime( time_t time ) { mTime = time; }
 
+    /**
+     * @brief Statistics of the asynchronous mode.
+     */
+    struct AsyncStats
+    {
+        AsyncStats() { Reset(); }
+
+        void Reset()
+        {
+            AtomicStore( &queued, 0 );
+            AtomicStore( &dropped, 0 );
+            AtomicStore( &written, 0 );
+            AtomicStore( &batches, 0 );
+        }
+
+        /// Number of queued records.
+        volatile uint32 queued;
+        /// Number of records dropped because the queue was full.
+        volatile uint32 dropped;
+        /// Number of records written by the writer thread.
+        volatile uint32 written;
+        /// Number of batches the records were written in.
+        volatile uint32 batches;
+    };
+
+    /** @return True if the messages are written by the writer thread. */
+    bool IsAsync() const { return mAsync; }
+    /** @return Statistics since the last ResetAsyncStats(). */
+    const AsyncStats& asyncStats() const { return mAsyncStats; }
+    /** @brief Resets the statistics. */
+    void ResetAsyncStats() { mAsyncStats.Reset(); }
+
+    /**
+     * @brief Starts the writer thread.
+     *
+     * Does nothing if it runs already.
+     *
+     * @param[in] queueSize Number of records which may wait for the writer.
+     *
+     * @return True if the writer thread runs.
+     */
+    bool StartAsync( uint32 queueSize );
+    /**
+     * @brief Writes all the queued records and stops the writer thread.
+     */
+    void StopAsync();
+
+    /**
+     * @brief Queues a line of logsys.
+     *
+     * @param[in] type   Type of the line.
+     * @param[in] text   The line without the time and the newline.
+     * @param[in] length Length of @a text.
+     *
+     * @retval true  The line has been queued or dropped.
+     * @retval false The asynchronous mode is off; the caller must write the line.
+     */
+    bool QueueLogsys( LogType type, const char* text, size_t length );
+
 protected:
     /// A convenience color enum.
     enum Color
@@ -186,6 +254,77 @@ protected:
      */
     void SetLogfileDefault(std::string logPath);
 
+    /// Number of drop counters of the messages of NewLog, one for each prefix.
+    static const uint32 LEVEL_COUNT = 5;
+    /// Drop counters: the messages of NewLog, then the categories of logsys.
+    static const uint32 DROP_CATEGORY_COUNT = LEVEL_COUNT + NUMBER_OF_LOG_CATEGORIES;
+
+    /**
+     * @brief A queued message.
+     *
+     * Allocated as a single block with the text following the header.
+     */
+    struct Record
+    {
+        /// When the message was logged.
+        time_t time;
+        /// Color of the message; unused by logsys.
+        uint8 color;
+        /// Prefix of the message; 0 for lines of logsys.
+        char pfx;
+        /// Length of the source at the start of text.
+        uint16 sourceLength;
+        /// Length of text.
+        uint32 length;
+        /// The source followed by the message; not terminated.
+        char text[ 1 ];
+    };
+
+    /**
+     * @brief Creates a record of the current time.
+     *
+     * @param[in] color  Color of the message.
+     * @param[in] pfx    Prefix of the message; 0 for lines of logsys.
+     * @param[in] source Origin of the message; may be NULL.
+     * @param[in] text   The message.
+     * @param[in] length Length of @a text.
+     *
+     * @return The record, to be released by free(); NULL if out of memory.
+     */
+    static Record* NewRecord( Color color, char pfx, const char* source, const char* text, size_t length );
+    /**
+     * @brief Queues a record; drops it if the queue is full.
+     *
+     * @param[in] record   The record; released if it is dropped.
+     * @param[in] category The drop counter of the record.
+     */
+    void Queue( Record* record, uint32 category );
+
+    /**
+     * @brief Writes the queued records until the queue is stopped.
+     */
+    void WriterRun();
+    /**
+     * @brief Writes a batch of queued records.
+     *
+     * @return Number of written records.
+     */
+    size_t WriteBatch();
+    /**
+     * @brief Writes a single record.
+     */
+    void WriteRecord( const Record* record );
+    /**
+     * @brief Writes the number of records dropped since the last report, by category.
+     */
+    void ReportDrops();
+
+#ifdef WIN32
+    static DWORD WINAPI WriterLoop( LPVOID arg );
+#else /* !WIN32 */
+    static void* WriterLoop( void* arg );
+#endif /* !WIN32 */
+
     /// The active logfile.
     FILE* mLogfile;
     /// Current timestamp.
@@ -195,6 +334,34 @@ protected:
 
     bool m_initialized;
 
+    /// Whether the messages are queued for the writer thread.
+    volatile bool mAsync;
+    /// Cleared when the writer thread should stop.
+    volatile bool mWriterRunning;
+    /// The records waiting for the writer thread.
+    LockFreeQueue< Record* >* mQueue;
+    /// Signaled when the queue fills up (or the writer is stopping).
+    Event mWake;
+    /// Statistics of the asynchronous mode.
+    AsyncStats mAsyncStats;
+    /// Number of dropped records, by category.
+    volatile uint32 mDropped[ DROP_CATEGORY_COUNT ];
+    /// mDropped at the last report; writer thread only.
+    uint32 mReportedDrops[ DROP_CATEGORY_COUNT ];
+    /// When the drops were last reported; writer thread only.
+    time_t mReportTime;
+    /// The second mTimeText was rendered for; writer thread only.
+    time_t mTimeTextSecond;
+    /// The rendered time of the last record; writer thread only.
+    char mTimeText[ 16 ];
+
+    /// The writer thread.
+#ifdef WIN32
+    HANDLE mWriter;
+#else /* !WIN32 */
+    pthread_t mWriter;
+#endif /* !WIN32 */
+
 #ifdef WIN32
     /// Handle to standard output stream.
     const HANDLE mStdOutHandle;
@@ -213,4 +380,20 @@ protected:
 #define sLog \
     ( NewLog::get() )
 
+/*
+ * _debug( source, fmt, ... ) logs a debug message through sLog.Debug,
+ * checking whether debug messages are enabled before evaluating the
+ * arguments; compiled out by EVEMU_DISABLE_DEBUG_LOG.
+ */
+#if defined ( DISABLE_LOGSYS ) || defined ( NO_VARIADIC_MACROS )
+#   define _debug \
+        sLog.Debug
+#else
+#   define _debug( source, fmt, ... ) \
+        if( !is_log_enabled( DEBUG__DEBUG ) ) \
+            ; \
+        else \
+            sLog.Debug( source, fmt, ##__VA_ARGS__ )
+#endif
+
 #endif /* !__LOG__LOG_NEW_H__INCL__ */
@@ -94,8 +94,27 @@ struct LogTypeStatus
 //expose a read-only pointer
 extern const LogTypeStatus* log_type_info;
 
+#ifdef EVEMU_DISABLE_DEBUG_LOG
+/*
+ * Only the log types enabled by default, except the DEBUG category,
+ * are compiled in; for a constant type the compiler drops the whole
+ * call, arguments included.
+ */
+#define LOG_TYPE(category, type, enabled, str) ( enabled && LOG_DEBUG != LOG_ ##category ),
+static const bool log_type_compiled[NUMBER_OF_LOG_TYPES] =
+{
+    #include "logtypes.h"
+};
+
+#define is_log_compiled( type ) \
+    ( log_type_compiled[ ( type ) ] )
+#else
+#define is_log_compiled( type ) \
+    ( true )
+#endif /* !EVEMU_DISABLE_DEBUG_LOG */
+
 #define is_log_enabled( type ) \
-    ( log_type_info[ ( type ) ].enabled )
+    ( is_log_compiled( type ) && log_type_info[ ( type ) ].enabled )
 
 extern void log_enable( LogType t );
 extern void log_disable( LogType t );
@@ -165,6 +165,7 @@ LOG_TYPE( COMMON, WARNING, DISABLED, "Warning" )
 LOG_TYPE( COMMON, MESSAGE, DISABLED, "Message" )
 LOG_TYPE( COMMON, THREADS, DISABLED, "Threads" )
 LOG_TYPE( COMMON, PYREP, DISABLED, "PyRep" )
+LOG_TYPE( COMMON, TIMERS, DISABLED, "Timers" )
 
 LOG_CATEGORY( SERVER )
 LOG_TYPE( SERVER, INIT_ERR, ENABLED, "ServerInitError" )
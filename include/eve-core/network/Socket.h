@@ -34,6 +34,23 @@
 class Socket
 {
 public:
+#ifdef WIN32
+    /// Descriptor of a single buffer for sendv().
+    typedef WSABUF Chunk;
+#else
+    /// Descriptor of a single buffer for sendv().
+    typedef iovec Chunk;
+#endif /* !WIN32 */
+
+    /**
+     * @brief Fills a chunk descriptor.
+     *
+     * @param[out] chunk The descriptor to fill.
+     * @param[in]  buf   Start of the data.
+     * @param[in]  len   Length of the data.
+     */
+    static void SetChunk( Chunk& chunk, const void* buf, unsigned int len );
+
     Socket( int af, int type, int protocol );
     ~Socket();
 
@@ -43,6 +60,12 @@ public:
     unsigned int recvfrom( void* buf, unsigned int len, int flags, sockaddr* from, unsigned int* fromlen );
     unsigned int send( const void* buf, unsigned int len, int flags );
     unsigned int sendto( const void* buf, unsigned int len, int flags, const sockaddr* to, unsigned int tolen );
+    /**
+     * @brief Sends several buffers using a single system call.
+     *
+     * @return Number of bytes sent or SOCKET_ERROR.
+     */
+    unsigned int sendv( const Chunk* chunks, unsigned int count, int flags );
 
     int bind( const sockaddr* name, unsigned int namelen );
     int listen( int backlog = SOMAXCONN );
@@ -56,6 +79,9 @@ public:
     int fcntl( int cmd, long arg );
 #endif /* !WIN32 */
 
+    /** @return The underlying system socket. */
+    SOCKET fd() const { return mSock; }
+
 protected:
     Socket( SOCKET sock );
 
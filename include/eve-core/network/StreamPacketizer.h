@@ -28,24 +28,99 @@
 
 #include "utils/Buffer.h"
 
+/** Size of the input buffer StreamPacketizer frames packets in. */
+extern const uint32 STREAMPACKETIZER_INPUT_SIZE;
+/** Packets bigger than this are received straight into their own buffer. */
+extern const uint32 STREAMPACKETIZER_DIRECT_SIZE;
+
+/**
+ * @brief Splits a stream of length-prefixed packets.
+ *
+ * Incoming data is written straight into the packetizer (see
+ * GetInputSpan() and CommitInput()) and framed in place; the input buffer
+ * is allocated once and only compacted, never reallocated. Packets bigger
+ * than STREAMPACKETIZER_DIRECT_SIZE get a buffer of their own as soon as
+ * their length is known and the rest of them is received right into it.
+ * That buffer grows as the data arrive, so a peer cannot make us allocate
+ * a whole packet just by announcing its length.
+ *
+ * @author Zhur, Bloody.Rabbit
+ */
 class StreamPacketizer
 {
 public:
+    /**
+     * @param[in] packetSizeLimit Maximal accepted packet size; 0 means no limit.
+     */
+    StreamPacketizer( uint32 packetSizeLimit = 0 );
     ~StreamPacketizer();
 
-    void InputData( const Buffer& data );
-    void Process();
+    /**
+     * @brief Copies data into the packetizer and processes it.
+     *
+     * @param[in] data The data to input.
+     *
+     * @retval true  Data processed fine.
+     * @retval false A packet exceeded the size limit.
+     */
+    bool InputData( const Buffer& data );
+
+    /**
+     * @brief Obtains space the next incoming data should be written to.
+     *
+     * @param[out] len Receives size of the space, in bytes.
+     *
+     * @return Pointer to the space.
+     */
+    uint8* GetInputSpan( size_t& len );
+    /**
+     * @brief Marks data written to the input span as valid.
+     *
+     * @param[in] len Number of bytes written.
+     */
+    void CommitInput( size_t len );
+
+    /**
+     * @brief Frames all complete packets.
+     *
+     * @retval true  Data processed fine.
+     * @retval false A packet exceeded the size limit.
+     */
+    bool Process();
+
+    /** @return True if a packet has been received partially. */
+    bool IsPending() const { return NULL != mPacket || mInputStart < mInputEnd; }
 
+    /**
+     * @return Next complete packet (ownership is passed to the caller); NULL if there is none.
+     */
     Buffer* PopPacket();
 
+    /**
+     * @brief Drops all pending data and packets.
+     */
     void ClearBuffers();
 
 protected:
+    /// Maximal accepted packet size; 0 means no limit.
+    const uint32 mPacketSizeLimit;
+
+    /// Input buffer; valid data are in [mInputStart, mInputEnd).
     Buffer mBuffer;
+    /// Offset of the first valid byte in the input buffer.
+    size_t mInputStart;
+    /// Offset past the last valid byte in the input buffer.
+    size_t mInputEnd;
+
+    /// Big packet being received directly; NULL if there is none.
+    Buffer* mPacket;
+    /// Full size of the big packet, as announced by its length.
+    size_t mPacketSize;
+    /// Number of bytes of the big packet received so far.
+    size_t mPacketFill;
 
+    /// Complete packets.
     std::queue<Buffer*> mPackets;
 };
 
 #endif /* !__STREAM_PACKETIZER_H__INCL__ */
-
-
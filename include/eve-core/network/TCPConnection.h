@@ -27,6 +27,9 @@
 #define __NETWORK__TCP_CONNECTION_H__INCL__
 
 #include "network/Socket.h"
+#include "network/TCPReactor.h"
+#include "threading/Event.h"
+#include "threading/LockFreeQueue.h"
 #include "threading/Mutex.h"
 #include "utils/Buffer.h"
 
@@ -34,8 +37,10 @@
 static const uint32 TCPCONN_ERRBUF_SIZE = 1024;
 /** Size of receive buffer TCPConnection uses. */
 extern const uint32 TCPCONN_RECVBUF_SIZE;
-/** Time (in milliseconds) between periodical process for incoming/outgoing data. */
-extern const uint32 TCPCONN_LOOP_GRANULARITY;
+/** Maximal number of queued buffers TCPConnection sends using a single system call. */
+extern const uint32 TCPCONN_SENDV_MAX;
+/** Maximal number of buffers waiting in TCPConnection's send queue. */
+extern const uint32 TCPCONN_SENDQUEUE_SIZE;
 
 /**
  * @brief Generic class for TCP connections.
@@ -43,7 +48,11 @@ extern const uint32 TCPCONN_LOOP_GRANULARITY;
  * @author Zhur, Bloody.Rabbit
  */
 class TCPConnection
+: protected TCPReactor::Handler
 {
+    template<typename X>
+    friend class TCPServer;
+
 public:
     /** Describes all states this object may be in. */
     enum state_t
@@ -54,6 +63,34 @@ public:
         STATE_DISCONNECTING /**< Disconnect pending, waiting for all data to be sent. */
     };
 
+    /** Counters of the send path. */
+    struct SendStats
+    {
+        /// Number of send system calls made.
+        uint64 syscalls;
+        /// Total number of bytes sent; divide by syscalls to get bytes per call.
+        uint64 bytes;
+        /// Number of buffers currently waiting in the send queue.
+        size_t queueDepth;
+        /// Maximal number of buffers ever waiting in the send queue.
+        size_t maxQueueDepth;
+        /// Number of bytes currently waiting in the send queue.
+        size_t queueBytes;
+    };
+
+    /**
+     * @brief Sets the maximal number of bytes waiting in a send queue.
+     *
+     * A connection whose peer does not read fast enough to keep its
+     * send queue under the limit is dropped at once, without flushing
+     * the queue first.
+     *
+     * @param[in] bytes The limit; 0 for no limit besides TCPCONN_SENDQUEUE_SIZE.
+     */
+    static void SetSendQueueLimit( uint32 bytes );
+    /** @return Number of connections dropped for a full send queue. */
+    static uint32 GetDroppedSlowReaders();
+
     /**
      * @brief Creates new connection in STATE_DISCONNECTED.
      */
@@ -75,6 +112,8 @@ public:
     std::string GetAddress();
     /** @return Current state of connection. */
     state_t GetState() const { return mSockState; }
+    /** @return Current counters of the send path. */
+    SendStats GetSendStats() const;
 
     /**
      * @brief Connects to specified address.
@@ -109,6 +148,13 @@ public:
      * queue before actually disconnecting.
      */
     void Disconnect();
+    /**
+     * @brief Schedules immediate disconnect of current connection.
+     *
+     * Unlike Disconnect(), the send queue is discarded instead
+     * of being flushed.
+     */
+    void Drop();
 
     /**
      * @brief Enqueues data to be sent.
@@ -119,10 +165,22 @@ public:
      */
     bool Send( Buffer** data );
 
+    /**
+     * @brief Sets event to signal when there is something for the owner to do.
+     *
+     * The event is signaled from the I/O thread, eg. when the connection is
+     * closed; children signal it as well once they have new data ready.
+     *
+     * @param[in] event The event to signal; NULL to disable notifications.
+     */
+    void SetNotifyEvent( Event* event ) { mNotifyEvent = event; }
+
 protected:
     /**
      * @brief Creates connection from an existing socket.
      *
+     * The connection is not processed until StartLoop() is called.
+     *
      * @param[in] sock  Socket to be used for connection.
      * @param[in] rIP   Remote IP socket is connected to.
      * @param[in] rPort Remote TCP port socket is connected to.
@@ -130,14 +188,14 @@ protected:
     TCPConnection( Socket* sock, uint32 rIP, uint16 rPort );
 
     /**
-     * @brief Starts working thread.
+     * @brief Registers the connection with the I/O reactor.
      *
-     * This function just starts a thread, does not check
-     * whether there is already one running!
+     * This function does not check whether the connection
+     * is registered already!
      */
     void StartLoop();
     /**
-     * @brief Blocks calling thread until working thread terminates.
+     * @brief Blocks calling thread until the reactor lets go of the connection.
      */
     void WaitLoop();
 
@@ -147,18 +205,30 @@ protected:
      * @return True if connection should be further processed, false if not (eg. error, disconnected).
      */
     virtual bool Process();
+    /**
+     * @brief Obtains storage the received data should be written to.
+     *
+     * The default implementation hands out mRecvBuf; children may
+     * override it to receive straight into their own storage.
+     *
+     * @param[out] len Receives size of the storage, in bytes.
+     *
+     * @return Pointer to the storage.
+     */
+    virtual uint8* GetRecvSpan( size_t& len );
     /**
      * @brief Processes received data.
      *
      * This function must be overloaded by children to process received data.
-     * Called every time a chunk of new data is received. Please note that
-     * receive buffer is overwritten every time data is received.
+     * Called every time a chunk of new data is received into the storage
+     * obtained by GetRecvSpan().
      *
+     * @param[in]  len    Number of bytes received.
      * @param[out] errbuf Buffer which receives description of error.
      *
      * @return True if processing ran fine, false if not.
      */
-    virtual bool ProcessReceivedData( char* errbuf = 0 ) = 0;
+    virtual bool ProcessReceivedData( size_t len, char* errbuf = 0 ) = 0;
 
     /**
      * @brief Sends data in send queue.
@@ -168,6 +238,18 @@ protected:
      * @return True if send was OK, false if not.
      */
     virtual bool SendData( char* errbuf = 0 );
+    /**
+     * @brief Removes sent data from the send queue.
+     *
+     * @param[in] len Number of bytes sent.
+     */
+    void ConsumeSendQueue( size_t len );
+    /**
+     * @brief Called by the I/O thread once a buffer of the send queue has been sent whole.
+     *
+     * @param[in] buf The buffer; released right after.
+     */
+    virtual void SentBuffer( const Buffer* buf ) {}
     /**
      * @brief Receives data and puts them into receive queue.
      *
@@ -187,43 +269,40 @@ protected:
     virtual void ClearBuffers();
 
     /**
-     * @brief Loop for worker threads.
-     *
-     * This function just casts given arg into TCPConnection and calls
-     * member TCPConnectionLoop.
-     *
-     * @param[in] arg Pointer to TCPConnection.
-     */
-#ifdef WIN32
-    static DWORD WINAPI TCPConnectionLoop( LPVOID arg );
-#else /* !WIN32 */
-    static void* TCPConnectionLoop( void* arg );
-#endif /* !WIN32 */
-    /**
-     * @brief Loop for worker threads.
+     * @brief Signals the notify event, if there is any.
      */
-    void TCPConnectionLoop();
+    void Notify();
+
+    SOCKET GetReactorSocket() const;
+    bool ReactorProcess();
+    void ReactorDetach();
 
     /** Protection of socket and associated variables. */
     mutable Mutex mMSock;
     /** Socket for connection. */
     Socket* mSock;
-    /** State the socket is in. */
-    state_t mSockState;
+    /** State the socket is in; changed with mMSock locked only. */
+    volatile state_t mSockState;
     /** Remote IP the socket is connected to. */
     uint32 mrIP;
     /** Remote TCP port the socket is connected to; is in host byte order. */
     uint16 mrPort;
 
-    /** When a thread is running TCPConnectionLoop, it acquires this mutex first; used for synchronization. */
-    mutable Mutex mMLoopRunning;
+    /** Event signaled when there is something for the owner to do. */
+    Event* volatile mNotifyEvent;
 
-    /** Mutex protecting send queue. */
-    mutable Mutex mMSendQueue;
-    /** Send queue. */
-    std::deque<Buffer*> mSendQueue;
+    /** Send queue; filled by any thread, drained by the I/O thread. */
+    LockFreeQueue<Buffer*> mSendQueue;
+    /** Number of bytes of the front buffer in the send queue already sent. */
+    size_t mSendOffset;
+    /** Number of bytes waiting in the send queue, including the sent part of the front buffer. */
+    volatile uint32 mSendQueueBytes;
+    /** Whether the pending disconnect discards the send queue; changed with mMSock locked only. */
+    volatile bool mDropping;
+    /** Send path counters; written by the I/O thread only. */
+    SendStats mSendStats;
 
-    /** Receive buffer. */
+    /** Receive buffer used by the default GetRecvSpan(). */
     Buffer* mRecvBuf;
 };
 
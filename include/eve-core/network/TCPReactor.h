@@ -0,0 +1,172 @@
+/*
+    ------------------------------------------------------------------------------------
+    LICENSE:
+    ------------------------------------------------------------------------------------
+    This file is part of EVEmu: EVE Online Server Emulator
+    Copyright 2006 - 2011 The EVEmu Team
+    For the latest information visit http://evemu.org
+    ------------------------------------------------------------------------------------
+    This program is free software; you can redistribute it and/or modify it under
+    the terms of the GNU Lesser General Public License as published by the Free Software
+    Foundation; either version 2 of the License, or (at your option) any later
+    version.
+
+    This program is distributed in the hope that it will be useful, but WITHOUT
+    ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+    FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public License along with
+    this program; if not, write to the Free Software Foundation, Inc., 59 Temple
+    Place - Suite 330, Boston, MA 02111-1307, USA, or go to
+    http://www.gnu.org/copyleft/lesser.txt.
+    ------------------------------------------------------------------------------------
+    Author:     EVEmu Team
+*/
+
+#ifndef __NETWORK__TCP_REACTOR_H__INCL__
+#define __NETWORK__TCP_REACTOR_H__INCL__
+
+#include "threading/Event.h"
+#include "threading/Mutex.h"
+#include "utils/Singleton.h"
+
+/** Number of I/O threads started if nobody called TCPReactor::Start(). */
+extern const uint32 TCPREACTOR_DEFAULT_THREADS;
+/** Time (in milliseconds) between sweeps over all handlers (timeouts etc.). */
+extern const uint32 TCPREACTOR_SWEEP_INTERVAL;
+/** Time (in milliseconds) the poll backend waits when no wakeup pipe is available. */
+extern const uint32 TCPREACTOR_POLL_GRANULARITY;
+
+/**
+ * @brief Event-driven I/O dispatcher for TCP connections and servers.
+ *
+ * Owns a small fixed pool of I/O threads. Every registered handler is
+ * pinned to one of them and is processed only when its socket becomes
+ * readable/writable, when somebody explicitly wakes it up (eg. new data
+ * queued for sending) or during a periodic sweep, so idle connections
+ * cost (almost) nothing.
+ *
+ * Uses epoll on Linux and falls back to select() polling elsewhere.
+ *
+ * @author EVEmu Team
+ */
+class TCPReactor
+: public Singleton< TCPReactor >
+{
+public:
+    class Worker;
+
+    /**
+     * @brief Interface of objects the reactor can drive.
+     */
+    class Handler
+    {
+        friend class TCPReactor;
+        friend class TCPReactor::Worker;
+
+    public:
+        Handler() : mReactorWorker( NULL ), mReactorAttached( false ) {}
+        virtual ~Handler() {}
+
+    protected:
+        /**
+         * @brief Blocks calling thread until the reactor lets go of the handler.
+         *
+         * Returns at once if the handler is not registered.
+         */
+        void WaitReactorDetach();
+
+        /**
+         * @return Socket to watch; INVALID_SOCKET if there is none (yet).
+         */
+        virtual SOCKET GetReactorSocket() const = 0;
+        /**
+         * @brief Does the actual I/O work.
+         *
+         * Called from the I/O thread the handler is pinned to.
+         *
+         * @retval true  Keep the handler registered.
+         * @retval false Unregister the handler.
+         */
+        virtual bool ReactorProcess() = 0;
+
+        /**
+         * @brief Called from the I/O thread when the handler gets attached.
+         */
+        virtual void ReactorAttach() {}
+        /**
+         * @brief Called from the I/O thread when the handler gets detached.
+         *
+         * Once this call returns, WaitReactorDetach() lets the owner go on.
+         */
+        virtual void ReactorDetach() {}
+
+    private:
+        /// Worker the handler is pinned to.
+        Worker* volatile mReactorWorker;
+
+        /// Protects mReactorAttached.
+        Mutex mMReactorAttached;
+        /// Set by the registering thread, cleared once the reactor lets go.
+        bool mReactorAttached;
+        /// Signaled when mReactorAttached gets cleared.
+        Event mReactorDetached;
+    };
+
+    /**
+     * @brief Creates reactor with no I/O threads running.
+     */
+    TCPReactor();
+    /**
+     * @brief Stops all I/O threads.
+     */
+    ~TCPReactor();
+
+    /** @return Number of I/O threads running. */
+    size_t GetThreadCount() const;
+
+    /**
+     * @brief Starts the I/O threads.
+     *
+     * Does nothing if the reactor is already running.
+     *
+     * @param[in] threadCount Number of I/O threads to start.
+     */
+    void Start( uint32 threadCount );
+    /**
+     * @brief Stops all I/O threads.
+     *
+     * Handlers still registered are detached.
+     */
+    void Stop();
+
+    /**
+     * @brief Registers a handler.
+     *
+     * The handler is assigned to the least loaded I/O thread and
+     * processed for the first time as soon as possible.
+     *
+     * @param[in] handler The handler to register.
+     */
+    void Register( Handler* handler );
+    /**
+     * @brief Schedules processing of a registered handler.
+     *
+     * Safe to call from any thread.
+     *
+     * @param[in] handler The handler to wake up.
+     */
+    void Wake( Handler* handler );
+
+protected:
+    /// Protects the worker list.
+    mutable Mutex mMWorkers;
+    /// The I/O threads.
+    std::vector<Worker*> mWorkers;
+};
+
+/// A macro for easier access to the singleton.
+#define sTCPReactor \
+    ( TCPReactor::get() )
+
+#endif /* !__NETWORK__TCP_REACTOR_H__INCL__ */
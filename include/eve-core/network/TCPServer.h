@@ -27,12 +27,15 @@
 #define __NETWORK__TCP_SERVER_H__INCL__
 
 #include "network/Socket.h"
+#include "network/TCPReactor.h"
+#include "threading/Event.h"
+#include "threading/LockFreeQueue.h"
 #include "threading/Mutex.h"
 
 /** Size of error buffer BaseTCPServer uses. */
 extern const uint32 TCPSRV_ERRBUF_SIZE;
-/** Time (in milliseconds) between periodical checks of socket for new connections. */
-extern const uint32 TCPSRV_LOOP_GRANULARITY;
+/** Maximal number of accepted connections waiting to be popped. */
+extern const uint32 TCPSRV_QUEUE_SIZE;
 
 /**
  * @brief Generic class for TCP server.
@@ -40,6 +43,7 @@ extern const uint32 TCPSRV_LOOP_GRANULARITY;
  * @author Zhur, Bloody.Rabbit
  */
 class BaseTCPServer
+: protected TCPReactor::Handler
 {
 public:
     /**
@@ -70,16 +74,25 @@ public:
      */
     void Close();
 
+    /**
+     * @brief Sets event to signal when a new connection is queued.
+     *
+     * The event is passed on to every accepted connection as well.
+     *
+     * @param[in] event The event to signal; NULL to disable notifications.
+     */
+    void SetNotifyEvent( Event* event ) { mNotifyEvent = event; }
+
 protected:
     /**
-     * @brief Starts worker thread.
+     * @brief Registers the server with the I/O reactor.
      *
-     * This function just starts worker thread; it doesn't check
-     * whether there already is one running!
+     * This function doesn't check whether the server
+     * is registered already!
      */
     void StartLoop();
     /**
-     * @brief Waits for worker thread to terminate.
+     * @brief Waits for the reactor to let go of the server.
      */
     void WaitLoop();
 
@@ -102,23 +115,8 @@ protected:
      */
     virtual void CreateNewConnection( Socket* sock, uint32 rIP, uint16 rPort ) = 0;
 
-    /**
-     * @brief Loop for worker threads.
-     *
-     * This function only casts arg to BaseTCPServer and calls
-     * member TCPServerLoop().
-     *
-     * @param[in] arg Pointer to BaseTCPServer.
-     */
-#ifdef WIN32
-    static DWORD WINAPI TCPServerLoop( LPVOID arg );
-#else /* !WIN32 */
-    static void* TCPServerLoop( void* arg );
-#endif /* !WIN32 */
-    /**
-     * @brief Loop for worker threads.
-     */
-    void TCPServerLoop();
+    SOCKET GetReactorSocket() const;
+    bool ReactorProcess();
 
     /** Mutex to protect socket and associated variables. */
     mutable Mutex mMSock;
@@ -127,8 +125,8 @@ protected:
     /** Port the socket is listening on. */
     uint16 mPort;
 
-    /** Worker thread acquires this mutex before it starts processing; used for thread synchronization. */
-    mutable Mutex mMLoopRunning;
+    /** Event signaled when a new connection is queued. */
+    Event* volatile mNotifyEvent;
 };
 
 /**
@@ -140,13 +138,18 @@ template<typename X>
 class TCPServer : public BaseTCPServer
 {
 public:
+    /**
+     * @brief Creates empty TCP server.
+     */
+    TCPServer()
+    : mQueue( TCPSRV_QUEUE_SIZE )
+    {
+    }
     /**
      * @brief Deletes all stored connections.
      */
     ~TCPServer()
     {
-        MutexLock lock( mMQueue );
-
         X* conn;
         while( ( conn = PopConnection() ) )
             SafeDelete( conn );
@@ -155,18 +158,15 @@ public:
     /**
      * @brief Pops connection from queue.
      *
+     * Must be called from a single thread only.
+     *
      * @return Popped connection.
      */
     X* PopConnection()
     {
-        MutexLock lock( mMQueue );
-
         X* ret = NULL;
-        if( !mQueue.empty() )
-        {
-            ret = mQueue.front();
-            mQueue.pop();
-        }
+        if( !mQueue.Pop( ret ) )
+            ret = NULL;
 
         return ret;
     }
@@ -179,15 +179,28 @@ protected:
      */
     void AddConnection( X* con )
     {
-        MutexLock lock( mMQueue );
+        // We are the only producer, so if there is room now, there
+        // will be room below as well
+        if( mQueue.GetCapacity() <= mQueue.GetSize() )
+        {
+            // Nobody is picking the connections up; refuse this one
+            SafeDelete( con );
+            return;
+        }
+
+        // Now that it's fully constructed, let the reactor drive it
+        con->SetNotifyEvent( mNotifyEvent );
+        con->StartLoop();
+
+        mQueue.Push( con );
 
-        mQueue.push( con );
+        Event* event = mNotifyEvent;
+        if( NULL != event )
+            event->Signal();
     }
 
-    /** Mutex to protect connection queue. */
-    Mutex mMQueue;
-    /** Connection queue. */
-    std::queue<X*> mQueue;
+    /** Connection queue; filled by the I/O thread, drained by the owner. */
+    LockFreeQueue<X*> mQueue;
 };
 
 #endif /* !__NETWORK__TCP_SERVER_H__INCL__ */
@@ -0,0 +1,198 @@
+/*
+    ------------------------------------------------------------------------------------
+    LICENSE:
+    ------------------------------------------------------------------------------------
+    This file is part of EVEmu: EVE Online Server Emulator
+    Copyright 2006 - 2011 The EVEmu Team
+    For the latest information visit http://evemu.org
+    ------------------------------------------------------------------------------------
+    This program is free software; you can redistribute it and/or modify it under
+    the terms of the GNU Lesser General Public License as published by the Free Software
+    Foundation; either version 2 of the License, or (at your option) any later
+    version.
+
+    This program is distributed in the hope that it will be useful, but WITHOUT
+    ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+    FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public License along with
+    this program; if not, write to the Free Software Foundation, Inc., 59 Temple
+    Place - Suite 330, Boston, MA 02111-1307, USA, or go to
+    http://www.gnu.org/copyleft/lesser.txt.
+    ------------------------------------------------------------------------------------
+    Author:     EVEmu Team
+*/
+
+#ifndef __THREADING__ATOMIC_H__INCL__
+#define __THREADING__ATOMIC_H__INCL__
+
+/*
+ * Thin wrappers around platform-specific atomic operations.
+ *
+ * All read-modify-write operations act as full memory barriers.
+ */
+
+/**
+ * @brief Loads a value with acquire semantics.
+ *
+ * @param[in] src The value to load.
+ *
+ * @return The loaded value.
+ */
+inline uint32 AtomicLoad( const volatile uint32* src )
+{
+#if defined( WIN32 )
+    // volatile reads have acquire semantics in MSVC
+    return *src;
+#elif defined( __ATOMIC_ACQUIRE )
+    return __atomic_load_n( src, __ATOMIC_ACQUIRE );
+#else
+    const uint32 value = *src;
+    __sync_synchronize();
+    return value;
+#endif
+}
+
+/**
+ * @brief Stores a value with release semantics.
+ *
+ * @param[out] dest  Where to store the value.
+ * @param[in]  value The value to store.
+ */
+inline void AtomicStore( volatile uint32* dest, uint32 value )
+{
+#if defined( WIN32 )
+    // volatile writes have release semantics in MSVC
+    *dest = value;
+#elif defined( __ATOMIC_RELEASE )
+    __atomic_store_n( dest, value, __ATOMIC_RELEASE );
+#else
+    __sync_synchronize();
+    *dest = value;
+#endif
+}
+
+/**
+ * @brief Atomically adds a value.
+ *
+ * @param[in,out] dest  The value to add to.
+ * @param[in]     value The value to add.
+ *
+ * @return The new value.
+ */
+inline uint32 AtomicAdd( volatile uint32* dest, uint32 value )
+{
+#ifdef WIN32
+    return InterlockedExchangeAdd( (volatile LONG*)dest, (LONG)value ) + value;
+#else
+    return __sync_add_and_fetch( dest, value );
+#endif /* !WIN32 */
+}
+
+/**
+ * @brief Atomically replaces a value.
+ *
+ * @param[in,out] dest  The value to replace.
+ * @param[in]     value The value to store.
+ *
+ * @return The previous value.
+ */
+inline uint32 AtomicExchange( volatile uint32* dest, uint32 value )
+{
+#if defined( WIN32 )
+    return (uint32)InterlockedExchange( (volatile LONG*)dest, (LONG)value );
+#elif defined( __ATOMIC_SEQ_CST )
+    return __atomic_exchange_n( dest, value, __ATOMIC_SEQ_CST );
+#else
+    // only an acquire barrier on its own
+    __sync_synchronize();
+    return __sync_lock_test_and_set( dest, value );
+#endif
+}
+
+/**
+ * @brief Atomically replaces a value if it matches the expected one.
+ *
+ * @param[in,out] dest     The value to replace.
+ * @param[in]     expected The value @a dest must hold.
+ * @param[in]     value    The value to store.
+ *
+ * @retval true  The value has been replaced.
+ * @retval false The value did not match.
+ */
+inline bool AtomicCompareExchange( volatile uint32* dest, uint32 expected, uint32 value )
+{
+#ifdef WIN32
+    return (LONG)expected == InterlockedCompareExchange( (volatile LONG*)dest, (LONG)value, (LONG)expected );
+#else
+    return __sync_bool_compare_and_swap( dest, expected, value );
+#endif /* !WIN32 */
+}
+
+/**
+ * @brief Loads a 64-bit value with acquire semantics.
+ *
+ * @param[in] src The value to load.
+ *
+ * @return The loaded value.
+ */
+inline uint64 AtomicLoad64( const volatile uint64* src )
+{
+#if defined( WIN32 )
+    return InterlockedCompareExchange64( (volatile LONGLONG*)src, 0, 0 );
+#elif defined( __ATOMIC_ACQUIRE )
+    return __atomic_load_n( src, __ATOMIC_ACQUIRE );
+#else
+    return __sync_add_and_fetch( (volatile uint64*)src, 0 );
+#endif
+}
+
+/**
+ * @brief Atomically adds a 64-bit value.
+ *
+ * @param[in,out] dest  The value to add to.
+ * @param[in]     value The value to add.
+ *
+ * @return The new value.
+ */
+inline uint64 AtomicAdd64( volatile uint64* dest, uint64 value )
+{
+#ifdef WIN32
+    return InterlockedExchangeAdd64( (volatile LONGLONG*)dest, (LONGLONG)value ) + value;
+#else
+    return __sync_add_and_fetch( dest, value );
+#endif /* !WIN32 */
+}
+
+/**
+ * @brief Atomically stores a 64-bit value.
+ *
+ * @param[out] dest  Where to store the value.
+ * @param[in]  value The value to store.
+ */
+inline void AtomicStore64( volatile uint64* dest, uint64 value )
+{
+#if defined( WIN32 )
+    InterlockedExchange64( (volatile LONGLONG*)dest, (LONGLONG)value );
+#elif defined( __ATOMIC_RELEASE )
+    __atomic_store_n( dest, value, __ATOMIC_RELEASE );
+#else
+    uint64 old = *dest;
+    while( !__sync_bool_compare_and_swap( dest, old, value ) )
+        old = *dest;
+#endif
+}
+
+/**
+ * @brief Hints the CPU that the thread is spinning.
+ */
+inline void AtomicPause()
+{
+#if defined( WIN32 )
+    YieldProcessor();
+#elif defined( __i386__ ) || defined( __x86_64__ )
+    __asm__ __volatile__( "pause" );
+#endif
+}
+
+#endif /* !__THREADING__ATOMIC_H__INCL__ */
@@ -0,0 +1,83 @@
+/*
+    ------------------------------------------------------------------------------------
+    LICENSE:
+    ------------------------------------------------------------------------------------
+    This file is part of EVEmu: EVE Online Server Emulator
+    Copyright 2006 - 2011 The EVEmu Team
+    For the latest information visit http://evemu.org
+    ------------------------------------------------------------------------------------
+    This program is free software; you can redistribute it and/or modify it under
+    the terms of the GNU Lesser General Public License as published by the Free Software
+    Foundation; either version 2 of the License, or (at your option) any later
+    version.
+
+    This program is distributed in the hope that it will be useful, but WITHOUT
+    ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+    FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public License along with
+    this program; if not, write to the Free Software Foundation, Inc., 59 Temple
+    Place - Suite 330, Boston, MA 02111-1307, USA, or go to
+    http://www.gnu.org/copyleft/lesser.txt.
+    ------------------------------------------------------------------------------------
+    Author:     EVEmu Team
+*/
+
+#ifndef __THREADING__EVENT_H__INCL__
+#define __THREADING__EVENT_H__INCL__
+
+/**
+ * @brief Common wrapper for platform-specific auto-reset events.
+ *
+ * A thread may block in Wait() until another thread calls Signal().
+ * Signals are not counted: several Signal() calls before the next
+ * Wait() wake up only a single waiter once.
+ *
+ * @author EVEmu Team
+ */
+class Event
+{
+public:
+    /**
+     * @brief Primary contructor, creates non-signaled event.
+     */
+    Event();
+    /**
+     * @brief Destructor, releases allocated resources.
+     */
+    ~Event();
+
+    /**
+     * @brief Signals the event, waking up a waiting thread.
+     */
+    void Signal();
+
+    /**
+     * @brief Waits until the event gets signaled.
+     */
+    void Wait();
+    /**
+     * @brief Waits until the event gets signaled or the timeout expires.
+     *
+     * @param[in] timeout Maximal time to wait, in milliseconds.
+     *
+     * @retval true  The event has been signaled.
+     * @retval false The timeout expired.
+     */
+    bool Wait( uint32 timeout );
+
+protected:
+#ifdef WIN32
+    /// An auto-reset event object.
+    HANDLE mEvent;
+#else
+    /// A mutex protecting signaled state.
+    pthread_mutex_t mMutex;
+    /// A condition variable used to wait for the signal.
+    pthread_cond_t mCond;
+    /// True if the event is signaled.
+    bool mSignaled;
+#endif
+};
+
+#endif /* !__THREADING__EVENT_H__INCL__ */
@@ -0,0 +1,195 @@
+/*
+    ------------------------------------------------------------------------------------
+    LICENSE:
+    ------------------------------------------------------------------------------------
+    This file is part of EVEmu: EVE Online Server Emulator
+    Copyright 2006 - 2011 The EVEmu Team
+    For the latest information visit http://evemu.org
+    ------------------------------------------------------------------------------------
+    This program is free software; you can redistribute it and/or modify it under
+    the terms of the GNU Lesser General Public License as published by the Free Software
+    Foundation; either version 2 of the License, or (at your option) any later
+    version.
+
+    This program is distributed in the hope that it will be useful, but WITHOUT
+    ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+    FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public License along with
+    this program; if not, write to the Free Software Foundation, Inc., 59 Temple
+    Place - Suite 330, Boston, MA 02111-1307, USA, or go to
+    http://www.gnu.org/copyleft/lesser.txt.
+    ------------------------------------------------------------------------------------
+    Author:     EVEmu Team
+*/
+
+#ifndef __THREADING__LOCK_FREE_QUEUE_H__INCL__
+#define __THREADING__LOCK_FREE_QUEUE_H__INCL__
+
+#include "threading/Atomic.h"
+#include "utils/misc.h"
+
+/**
+ * @brief Bounded lock-free multi-producer/single-consumer queue.
+ *
+ * Any number of threads may Push() concurrently; Pop() and Peek()
+ * must be only ever called from one thread at a time. Each slot
+ * carries a sequence number telling whether it is free or filled,
+ * so neither side ever takes a lock.
+ *
+ * @author EVEmu Team
+ */
+template< typename T >
+class LockFreeQueue
+{
+public:
+    /**
+     * @brief Creates an empty queue.
+     *
+     * @param[in] capacity Least number of elements the queue can hold;
+     *                     rounded up to a power of 2.
+     */
+    LockFreeQueue( uint32 capacity )
+    : mMask( (uint32)npowof2( capacity < 2 ? 2 : capacity ) - 1 ),
+      mCells( new Cell[ mMask + 1 ] ),
+      mEnqueuePos( 0 ),
+      mDequeuePos( 0 )
+    {
+        for( uint32 i = 0; i <= mMask; ++i )
+            mCells[ i ].sequence = i;
+    }
+    /**
+     * @brief Destroys the queue.
+     *
+     * Elements still queued are not released.
+     */
+    ~LockFreeQueue()
+    {
+        delete[] mCells;
+    }
+
+    /** @return Maximal number of elements the queue can hold. */
+    uint32 GetCapacity() const { return mMask + 1; }
+    /** @return Number of queued elements; exact only if there are no concurrent calls. */
+    uint32 GetSize() const { return AtomicLoad( &mEnqueuePos ) - AtomicLoad( &mDequeuePos ); }
+    /** @return True if the queue is empty; to be called by the consumer. */
+    bool IsEmpty() const { T dummy; return !Peek( 0, dummy ); }
+
+    /**
+     * @brief Appends an element; safe to call from any thread.
+     *
+     * @param[in] value The element to append.
+     *
+     * @retval true  The element has been queued.
+     * @retval false The queue is full.
+     */
+    bool Push( const T& value )
+    {
+        Cell* cell;
+        uint32 pos = AtomicLoad( &mEnqueuePos );
+        while( true )
+        {
+            cell = &mCells[ pos & mMask ];
+
+            const int32 diff = (int32)( AtomicLoad( &cell->sequence ) - pos );
+            if( 0 == diff )
+            {
+                // slot is free; try to claim it
+                if( AtomicCompareExchange( &mEnqueuePos, pos, pos + 1 ) )
+                    break;
+            }
+            else if( 0 > diff )
+            {
+                // the consumer has not freed this slot yet
+                return false;
+            }
+
+            pos = AtomicLoad( &mEnqueuePos );
+        }
+
+        cell->value = value;
+        // publish the element
+        AtomicStore( &cell->sequence, pos + 1 );
+
+        return true;
+    }
+
+    /**
+     * @brief Removes the first element; consumer only.
+     *
+     * @param[out] value Receives the element.
+     *
+     * @retval true  An element has been removed.
+     * @retval false The queue is empty.
+     */
+    bool Pop( T& value )
+    {
+        const uint32 pos = mDequeuePos;
+        Cell& cell = mCells[ pos & mMask ];
+
+        if( AtomicLoad( &cell.sequence ) != pos + 1 )
+            return false;
+
+        value = cell.value;
+        // hand the slot back to producers
+        AtomicStore( &cell.sequence, pos + mMask + 1 );
+        AtomicStore( &mDequeuePos, pos + 1 );
+
+        return true;
+    }
+
+    /**
+     * @brief Obtains an element without removing it; consumer only.
+     *
+     * @param[in]  index Position of the element, counting from the front.
+     * @param[out] value Receives the element.
+     *
+     * @retval true  The element is there.
+     * @retval false There are not that many elements.
+     */
+    bool Peek( uint32 index, T& value ) const
+    {
+        if( mMask < index )
+            return false;
+
+        const uint32 pos = mDequeuePos + index;
+        const Cell& cell = mCells[ pos & mMask ];
+
+        if( AtomicLoad( &cell.sequence ) != pos + 1 )
+            return false;
+
+        value = cell.value;
+        return true;
+    }
+
+protected:
+    /// A single slot of the queue.
+    struct Cell
+    {
+        /// Tells whether the slot is free (== position) or filled (== position + 1).
+        volatile uint32 sequence;
+        /// The element.
+        T value;
+    };
+
+    /// Mask turning position into index of the slot.
+    const uint32 mMask;
+    /// The slots.
+    Cell* const mCells;
+
+    /// Keep producers and the consumer off each other's cache line.
+    uint8 mPadding0[ 64 ];
+    /// Position the next element is pushed to.
+    volatile uint32 mEnqueuePos;
+    uint8 mPadding1[ 64 ];
+    /// Position the next element is popped from.
+    volatile uint32 mDequeuePos;
+    uint8 mPadding2[ 64 ];
+
+private:
+    /// Non-copyable.
+    LockFreeQueue( const LockFreeQueue& );
+    LockFreeQueue& operator=( const LockFreeQueue& );
+};
+
+#endif /* !__THREADING__LOCK_FREE_QUEUE_H__INCL__ */
@@ -0,0 +1,168 @@
+/*
+    ------------------------------------------------------------------------------------
+    LICENSE:
+    ------------------------------------------------------------------------------------
+    This file is part of EVEmu: EVE Online Server Emulator
+    Copyright 2006 - 2011 The EVEmu Team
+    For the latest information visit http://evemu.org
+    ------------------------------------------------------------------------------------
+    This program is free software; you can redistribute it and/or modify it under
+    the terms of the GNU Lesser General Public License as published by the Free Software
+    Foundation; either version 2 of the License, or (at your option) any later
+    version.
+
+    This program is distributed in the hope that it will be useful, but WITHOUT
+    ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+    FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public License along with
+    this program; if not, write to the Free Software Foundation, Inc., 59 Temple
+    Place - Suite 330, Boston, MA 02111-1307, USA, or go to
+    http://www.gnu.org/copyleft/lesser.txt.
+    ------------------------------------------------------------------------------------
+    Author:     EVEmu Team
+*/
+
+
+#ifndef __THREADING__LOCK_PROFILE_H__INCL__
+#define __THREADING__LOCK_PROFILE_H__INCL__
+
+#include "utils/Metrics.h"
+#include "utils/utils_time.h"
+
+/**
+ * @brief Contention statistics of a lock, exported as metrics.
+ *
+ * All the locks of the same name share the metrics, labeled
+ * by the name:
+ *
+ *  - evemu_lock_acquisitions_total: number of acquisitions;
+ *  - evemu_lock_contentions_total: acquisitions which had to wait;
+ *  - evemu_lock_wait_seconds: how long the contended acquisitions waited;
+ *  - evemu_lock_hold_seconds: how long the exclusive locks were held.
+ *
+ * @author EVEmu Team
+ */
+class LockProfile
+{
+public:
+    /**
+     * @param[in] name Name of the lock, used as the label.
+     */
+    LockProfile( const char* name );
+
+    /** @brief Records an acquisition which did not wait. */
+    void Acquired() { mAcquisitions.Add(); }
+    /** @brief Records an acquisition which waited given number of microseconds. */
+    void Contended( uint64 waitTime )
+    {
+        mAcquisitions.Add();
+        mContentions.Add();
+        mWaitTime.Observe( waitTime );
+    }
+    /** @brief Records how many microseconds an exclusive lock was held. */
+    void Released( uint64 holdTime ) { mHoldTime.Observe( holdTime ); }
+
+protected:
+    MetricCounter& mAcquisitions;
+    MetricCounter& mContentions;
+    MetricHistogram& mWaitTime;
+    MetricHistogram& mHoldTime;
+};
+
+/**
+ * @brief A lock which records its contention statistics.
+ *
+ * Wraps any lock with Lock(), TryLock() and Unlock(), and LockShared(),
+ * TryLockShared() and UnlockShared() if it has them:
+ *
+ * @code
+ * ProfiledMutex< SpinMutex > mLock( "api_cache" );
+ * @endcode
+ *
+ * Every acquisition tries to lock first, only contended ones are timed.
+ * Hold times are recorded for exclusive locks only; a recursive lock
+ * records the outermost one. That takes two clock reads for every
+ * exclusive acquisition, so locks taken millions of times a second
+ * are better profiled only while they are being investigated.
+ *
+ * @author EVEmu Team
+ */
+template< typename T >
+class ProfiledMutex
+: public T
+{
+public:
+    /**
+     * @param[in] name Name of the lock, see LockProfile.
+     */
+    ProfiledMutex( const char* name )
+    : mProfile( name ),
+      mDepth( 0 ),
+      mLockedAt( 0 )
+    {
+    }
+
+    void Lock()
+    {
+        if( T::TryLock() )
+            mProfile.Acquired();
+        else
+        {
+            const uint64 start = GetTimeUSeconds();
+            T::Lock();
+            mProfile.Contended( GetTimeUSeconds() - start );
+        }
+
+        if( 0 == mDepth++ )
+            mLockedAt = GetTimeUSeconds();
+    }
+    bool TryLock()
+    {
+        if( !T::TryLock() )
+            return false;
+
+        mProfile.Acquired();
+        if( 0 == mDepth++ )
+            mLockedAt = GetTimeUSeconds();
+
+        return true;
+    }
+    void Unlock()
+    {
+        if( 0 == --mDepth )
+            mProfile.Released( GetTimeUSeconds() - mLockedAt );
+
+        T::Unlock();
+    }
+
+    void LockShared()
+    {
+        if( T::TryLockShared() )
+            mProfile.Acquired();
+        else
+        {
+            const uint64 start = GetTimeUSeconds();
+            T::LockShared();
+            mProfile.Contended( GetTimeUSeconds() - start );
+        }
+    }
+    bool TryLockShared()
+    {
+        if( !T::TryLockShared() )
+            return false;
+
+        mProfile.Acquired();
+        return true;
+    }
+
+protected:
+    LockProfile mProfile;
+
+    /// Recursion depth of the exclusive lock; written by its holder only.
+    uint32 mDepth;
+    /// When the exclusive lock was acquired.
+    uint64 mLockedAt;
+};
+
+#endif /* !__THREADING__LOCK_PROFILE_H__INCL__ */
@@ -76,29 +76,4 @@ protected:
 /// Convenience typedef for Mutex's lock.
 typedef Lock< Mutex > MutexLock;
 
-// Somewhat untested...
-// Multi-read, single write Mutex
-class MRMutex {
-public:
-    MRMutex();
-    ~MRMutex();
-
-    void    ReadLock();
-    bool    TryReadLock();
-    void    UnReadLock();
-
-    void    WriteLock();
-    bool    TryWriteLock();
-    void    UnWriteLock();
-
-    int32    ReadLockCount();
-    int32    WriteLockCount();
-
-private:
-    int32    rl;    // read locks in effect
-    int32    wr;    // write lock requests pending
-    int32    wl;    // write locks in effect (should never be more than 1)
-    Mutex    MCounters;
-};
-
 #endif /* !__THREADING__MUTEX_H__INCL__ */
@@ -0,0 +1,104 @@
+/*
+    ------------------------------------------------------------------------------------
+    LICENSE:
+    ------------------------------------------------------------------------------------
+    This file is part of EVEmu: EVE Online Server Emulator
+    Copyright 2006 - 2011 The EVEmu Team
+    For the latest information visit http://evemu.org
+    ------------------------------------------------------------------------------------
+    This program is free software; you can redistribute it and/or modify it under
+    the terms of the GNU Lesser General Public License as published by the Free Software
+    Foundation; either version 2 of the License, or (at your option) any later
+    version.
+
+    This program is distributed in the hope that it will be useful, but WITHOUT
+    ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+    FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public License along with
+    this program; if not, write to the Free Software Foundation, Inc., 59 Temple
+    Place - Suite 330, Boston, MA 02111-1307, USA, or go to
+    http://www.gnu.org/copyleft/lesser.txt.
+    ------------------------------------------------------------------------------------
+    Author:     EVEmu Team
+*/
+
+
+#ifndef __THREADING__SHARED_MUTEX_H__INCL__
+#define __THREADING__SHARED_MUTEX_H__INCL__
+
+#include "utils/Lock.h"
+
+/**
+ * @brief Common wrapper for platform-specific reader/writer locks.
+ *
+ * Any number of threads may hold the mutex shared, or a single thread
+ * may hold it exclusively. Meant for data which is read by many
+ * threads and written rarely. Pending exclusive locks are preferred
+ * where the platform allows it, so writers do not starve.
+ *
+ * Unlike Mutex, the locks are not recursive.
+ *
+ * @author EVEmu Team
+ */
+class SharedMutex
+: public Lockable
+{
+public:
+    /**
+     * @brief Primary contructor.
+     */
+    SharedMutex();
+    /**
+     * @brief Destructor, releases allocated resources.
+     */
+    ~SharedMutex();
+
+    /**
+     * @brief Locks the mutex exclusively.
+     */
+    void Lock();
+    /**
+     * @brief Attempts to lock the mutex exclusively.
+     *
+     * @retval true  Mutex successfully locked.
+     * @retval false Mutex locked by another thread.
+     */
+    bool TryLock();
+    /**
+     * @brief Unlocks the exclusively locked mutex.
+     */
+    void Unlock();
+
+    /**
+     * @brief Locks the mutex shared.
+     */
+    void LockShared();
+    /**
+     * @brief Attempts to lock the mutex shared.
+     *
+     * @retval true  Mutex successfully locked.
+     * @retval false Mutex locked exclusively by another thread.
+     */
+    bool TryLockShared();
+    /**
+     * @brief Unlocks the mutex locked shared.
+     */
+    void UnlockShared();
+
+protected:
+#ifdef WIN32
+    /// A slim reader/writer lock used for mutex implementation on Windows.
+    SRWLOCK mLock;
+#else
+    /// A pthread rwlock used for mutex implementation using pthread library.
+    pthread_rwlock_t mLock;
+#endif
+};
+
+/// Convenience typedef for SharedMutex's exclusive lock.
+typedef Lock< SharedMutex > SharedMutexLock;
+/// Convenience typedef for SharedMutex's shared lock.
+typedef SharedLock< SharedMutex > SharedMutexReadLock;
+
+#endif /* !__THREADING__SHARED_MUTEX_H__INCL__ */
@@ -0,0 +1,99 @@
+/*
+    ------------------------------------------------------------------------------------
+    LICENSE:
+    ------------------------------------------------------------------------------------
+    This file is part of EVEmu: EVE Online Server Emulator
+    Copyright 2006 - 2011 The EVEmu Team
+    For the latest information visit http://evemu.org
+    ------------------------------------------------------------------------------------
+    This program is free software; you can redistribute it and/or modify it under
+    the terms of the GNU Lesser General Public License as published by the Free Software
+    Foundation; either version 2 of the License, or (at your option) any later
+    version.
+
+    This program is distributed in the hope that it will be useful, but WITHOUT
+    ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+    FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public License along with
+    this program; if not, write to the Free Software Foundation, Inc., 59 Temple
+    Place - Suite 330, Boston, MA 02111-1307, USA, or go to
+    http://www.gnu.org/copyleft/lesser.txt.
+    ------------------------------------------------------------------------------------
+    Author:     EVEmu Team
+*/
+
+
+#ifndef __THREADING__SPIN_MUTEX_H__INCL__
+#define __THREADING__SPIN_MUTEX_H__INCL__
+
+#include "threading/Atomic.h"
+#include "utils/Lock.h"
+
+/**
+ * @brief Adaptive lock for very short critical sections.
+ *
+ * Locking an unlocked mutex takes a single atomic operation, inlined
+ * into the caller. A contended lock spins for a while, expecting the
+ * holder to leave soon, then parks the thread: on a futex where
+ * available, otherwise by yielding and sleeping.
+ *
+ * Not a Lockable, so Lock< SpinMutex > does not go through virtual
+ * calls. Not recursive.
+ *
+ * @author EVEmu Team
+ */
+class SpinMutex
+{
+public:
+    /// Number of attempts made before the thread parks.
+    static const uint32 SPIN_COUNT = 100;
+
+    SpinMutex() : mState( STATE_UNLOCKED ) {}
+
+    /**
+     * @brief Locks the mutex.
+     */
+    void Lock()
+    {
+        if( !TryLock() )
+            _LockContended();
+    }
+    /**
+     * @brief Attempts to lock the mutex.
+     *
+     * @retval true  Mutex successfully locked.
+     * @retval false Mutex locked by another thread.
+     */
+    bool TryLock() { return AtomicCompareExchange( &mState, STATE_UNLOCKED, STATE_LOCKED ); }
+
+    /**
+     * @brief Unlocks the mutex.
+     */
+    void Unlock()
+    {
+        // somebody parked if it was not just locked
+        if( STATE_UNLOCKED != AtomicAdd( &mState, (uint32)-1 ) )
+            _UnlockContended();
+    }
+
+protected:
+    enum
+    {
+        STATE_UNLOCKED = 0,
+        STATE_LOCKED = 1,
+        /// Locked and there may be parked threads.
+        STATE_PARKED = 2
+    };
+
+    void _LockContended();
+    void _UnlockContended();
+
+    /// One of the states above.
+    volatile uint32 mState;
+};
+
+/// Convenience typedef for SpinMutex's lock.
+typedef Lock< SpinMutex > SpinMutexLock;
+
+#endif /* !__THREADING__SPIN_MUTEX_H__INCL__ */
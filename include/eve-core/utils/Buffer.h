@@ -27,6 +27,7 @@
 #define __UTILS__BUFFER_H__INCL__
 
 #include "utils/misc.h"
+#include "utils/RefPtr.h"
 
 /**
  * @brief Generic class for buffers.
@@ -365,11 +366,31 @@ public:
         // Use assigment operator
         *this = oth;
     }
+    /**
+     * @brief Creates read-only buffer over memory it does not own.
+     *
+     * The buffer keeps a reference to @a owner, which must keep
+     * the memory valid until it is released. Such a buffer must
+     * not be resized or written to; copies of it own their memory.
+     *
+     * @param[in] data  The memory.
+     * @param[in] len   Length of the memory, in bytes.
+     * @param[in] owner Owner of the memory.
+     */
+    Buffer( const uint8* data, size_type len, const RefPtr< RefObject >& owner )
+    : mBuffer( const_cast< uint8* >( data ) ),
+      mSize( len ),
+      mCapacity( len ),
+      mOwner( owner )
+    {
+        assert( mOwner );
+    }
     /// Destructor; deletes buffer.
     ~Buffer()
     {
-        // Free buffer
-        SafeFree( mBuffer );
+        // Free buffer unless it is owned by somebody else
+        if( !mOwner )
+            SafeFree( mBuffer );
     }
 
     /********************************************************************/
@@ -712,6 +733,8 @@ protected:
     size_type mSize;
     /// Current capacity of buffer, in bytes.
     size_type mCapacity;
+    /// Owner of the memory if the buffer does not own it.
+    RefPtr< RefObject > mOwner;
 
     /**
      * @brief Resizes buffer.
@@ -764,6 +787,9 @@ protected:
      */
     void _Reallocate( size_type requiredSize )
     {
+        // memory owned by somebody else is read-only
+        assert( !mOwner );
+
         // calculate new capacity for required size
         size_type newCapacity = _CalcBufferCapacity( capacity(), requiredSize );
         // make sure new capacity is bigger than required size
@@ -792,22 +818,22 @@ protected:
      */
     static size_type _CalcBufferCapacity( size_type currentCapacity, size_type requiredSize )
     {
-        size_type newCapacity = 0;
+        /* if current capacity is sufficient, keep it; it either saves
+           resources or it has been reserved on purpose. Empty buffer
+           still releases its memory. Checked first, as it is the case
+           of almost every append. */
+        if( 0 < requiredSize && requiredSize <= currentCapacity )
+            return currentCapacity;
 
         // if more than 0x100 bytes required, return next power of 2
         if( 0x100 < requiredSize )
-            newCapacity = (size_type)npowof2( requiredSize );
+            return (size_type)npowof2( requiredSize );
         // else if non-zero, return 0x100 bytes
         else if( 0 < requiredSize )
-            newCapacity = 0x100;
+            return 0x100;
         // else return 0 bytes
-
-        /* if current capacity is sufficient and at the same time smaller
-           than the new capacity, return current one ... saves resources */
-        if( requiredSize <= currentCapacity && currentCapacity < newCapacity )
-            return currentCapacity;
         else
-            return newCapacity;
+            return 0;
     }
 };
 
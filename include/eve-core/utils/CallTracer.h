@@ -0,0 +1,307 @@
+/*
+    ------------------------------------------------------------------------------------
+    LICENSE:
+    ------------------------------------------------------------------------------------
+    This file is part of EVEmu: EVE Online Server Emulator
+    Copyright 2006 - 2011 The EVEmu Team
+    For the latest information visit http://evemu.org
+    ------------------------------------------------------------------------------------
+    This program is free software; you can redistribute it and/or modify it under
+    the terms of the GNU Lesser General Public License as published by the Free Software
+    Foundation; either version 2 of the License, or (at your option) any later
+    version.
+
+    This program is distributed in the hope that it will be useful, but WITHOUT
+    ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+    FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public License along with
+    this program; if not, write to the Free Software Foundation, Inc., 59 Temple
+    Place - Suite 330, Boston, MA 02111-1307, USA, or go to
+    http://www.gnu.org/copyleft/lesser.txt.
+    ------------------------------------------------------------------------------------
+    Author:     EVEmu Team
+*/
+
+
+#ifndef __UTILS__CALL_TRACER_H__INCL__
+#define __UTILS__CALL_TRACER_H__INCL__
+
+#include "threading/Mutex.h"
+#include "utils/Singleton.h"
+
+class MetricHistogram;
+
+/**
+ * @brief Timestamps of a client call on its way through the server.
+ *
+ * The trace is carried along with the call, from the I/O thread
+ * which received it to the one which sent the answer out; each
+ * stage stamps the point it is done with.
+ *
+ * @author EVEmu Team
+ */
+struct CallTrace
+{
+    /**
+     * @brief Points a traced call passes; in microseconds as per GetTimeUSeconds().
+     */
+    enum Point
+    {
+        RECEIVED,       ///< The first byte of the call arrived.
+        QUEUED,         ///< The call was handed over to the main loop.
+        WOKEN,          ///< The main loop came around to look at it.
+        POPPED,         ///< The client popped the call.
+        UNMARSHALED,    ///< The call was inflated and unmarshaled.
+        REPLIED,        ///< The answer was handed over to the connection.
+        ENCODING,       ///< An encoder began to marshal the answer.
+        ENCODED,        ///< The answer was marshaled and deflated into the send queue.
+        SENT,           ///< The last byte of the answer was sent.
+        POINT_COUNT
+    };
+
+    /**
+     * @brief Stages of a traced call, between the points.
+     */
+    enum Stage
+    {
+        STAGE_RECEIVE,      ///< Receiving the call; RECEIVED to QUEUED.
+        STAGE_QUEUE,        ///< Waiting for the main loop; QUEUED to WOKEN.
+        STAGE_LOOP,         ///< Waiting behind the rest of the tick; WOKEN to POPPED.
+        STAGE_UNMARSHAL,    ///< Inflating and unmarshaling; POPPED to UNMARSHALED.
+        STAGE_DISPATCH,     ///< Dispatching the call; UNMARSHALED to REPLIED, SQL excluded.
+        STAGE_SQL,          ///< Running the queries of the call.
+        STAGE_ENCODE_WAIT,  ///< Waiting for an encoder; REPLIED to ENCODING.
+        STAGE_ENCODE,       ///< Marshaling and deflating the answer; ENCODING to ENCODED.
+        STAGE_SEND,         ///< Waiting in the send queue; ENCODED to SENT.
+        STAGE_COUNT
+    };
+
+    /// Names of the stages.
+    static const char* const STAGE_NAMES[ STAGE_COUNT ];
+
+    CallTrace();
+
+    /**
+     * @brief Stamps a point with the current time.
+     *
+     * @param[in] point The point the call passed.
+     */
+    void Stamp( Point point );
+
+    /**
+     * @param[in] stage The stage.
+     *
+     * @return Time (in microseconds) the call spent in the stage.
+     */
+    uint64 GetStage( Stage stage ) const;
+    /** @return Time (in microseconds) from the first byte of the call to the last of the answer. */
+    uint64 GetTotal() const { return Elapsed( RECEIVED, SENT ); }
+
+    /**
+     * @return Time (in microseconds) between two points; 0 if any of them is missing.
+     */
+    uint64 Elapsed( Point from, Point to ) const;
+
+    /// When the call passed the points; 0 if not stamped.
+    uint64 at[ POINT_COUNT ];
+    /// Time (in microseconds) spent running the queries of the call.
+    uint64 sqlTime;
+    /// Number of queries the call ran.
+    uint32 queries;
+    /// Account which made the call.
+    uint32 accountID;
+    /// Size of the answer as sent, in bytes.
+    uint32 size;
+    /// The service and method called.
+    std::string call;
+};
+
+/**
+ * @brief Traces a sampled fraction of the client calls end to end.
+ *
+ * One in every configured number of calls gets a CallTrace which
+ * travels with it and its answer; once the answer is sent, the
+ * trace is handed back to the tracer, which logs it with its
+ * per-stage breakdown, keeps the latest ones for /calltrace and
+ * observes the stages in the metrics.
+ *
+ * Sample(), BeginTick(), Process() and the dumps are meant to be
+ * called from the main loop; Finish() and Discard() from any thread.
+ *
+ * @author EVEmu Team
+ */
+class CallTracer
+: public Singleton< CallTracer >
+{
+public:
+    /**
+     * @brief Statistics of the tracer.
+     */
+    struct Stats
+    {
+        Stats() { Reset(); }
+
+        void Reset()
+        {
+            sampled = 0;
+            finished = 0;
+            dropped = 0;
+            for( size_t i = 0; i < CallTrace::STAGE_COUNT; ++i )
+            {
+                stageTime[ i ] = 0;
+                maxStageTime[ i ] = 0;
+            }
+            totalTime = 0;
+            maxTotalTime = 0;
+        }
+
+        /// Number of calls sampled.
+        uint32 sampled;
+        /// Number of traces finished.
+        uint32 finished;
+        /// Number of traces dropped before their answer was sent.
+        uint32 dropped;
+        /// Time (in microseconds) the finished traces spent in each stage.
+        uint64 stageTime[ CallTrace::STAGE_COUNT ];
+        /// Longest time (in microseconds) a finished trace spent in each stage.
+        uint64 maxStageTime[ CallTrace::STAGE_COUNT ];
+        /// Total time (in microseconds) of the finished traces.
+        uint64 totalTime;
+        /// Longest total time (in microseconds) of a finished trace.
+        uint64 maxTotalTime;
+    };
+
+    CallTracer();
+    ~CallTracer();
+
+    /** @return True if any calls are sampled; safe to call from any thread. */
+    bool IsEnabled() const;
+    /** @return One in how many calls is traced; 0 if none. */
+    uint32 GetRate() const;
+    /** @return Number of the latest traces kept. */
+    size_t size() const { return mLatest.size(); }
+    /** @return Statistics since the last ResetStats(). */
+    const Stats& stats() const { return mStats; }
+    /** @brief Resets the statistics. */
+    void ResetStats() { mStats.Reset(); }
+
+    /**
+     * @brief Configures the tracer.
+     *
+     * @param[in] rate    One in how many calls to trace; 0 disables the tracing.
+     * @param[in] history Number of the latest traces to keep.
+     * @param[in] log     Whether to log every finished trace.
+     */
+    void Configure( uint32 rate, size_t history, bool log );
+    /**
+     * @brief Changes the sampling rate.
+     *
+     * @param[in] rate One in how many calls to trace; 0 disables the tracing.
+     */
+    void SetRate( uint32 rate );
+
+    /**
+     * @brief Marks the point the main loop wakes up at; the calls received before wait for it.
+     */
+    void BeginTick();
+    /**
+     * @brief Decides whether to trace a call.
+     *
+     * @return New trace, owned by the caller; NULL if the call is not traced.
+     */
+    CallTrace* Sample();
+    /**
+     * @brief Hands a trace whose answer has been sent back to the tracer.
+     *
+     * @param[in] trace The trace; consumed.
+     */
+    void Finish( CallTrace** trace );
+    /**
+     * @brief Drops a trace whose answer is not going to be sent.
+     *
+     * @param[in] trace The trace; consumed.
+     */
+    void Discard( CallTrace** trace );
+
+    /**
+     * @brief Accounts the finished traces; logs them if asked to.
+     */
+    void Process();
+
+    /**
+     * @brief Logs the latest traces, latest first.
+     *
+     * @param[in]  count   Maximal number of traces to dump.
+     * @param[out] summary Receives one line per dumped trace.
+     *
+     * @return Number of traces dumped.
+     */
+    size_t Dump( size_t count, std::string& summary ) const;
+    /**
+     * @brief Forgets the kept traces.
+     */
+    void Reset();
+
+    /**
+     * @brief Sets the trace the queries of the calling thread are charged to.
+     *
+     * @param[in] trace The trace; NULL to stop charging.
+     */
+    static void SetCurrent( CallTrace* trace );
+    /** @return The trace the queries of the calling thread are charged to; NULL if none. */
+    static CallTrace* GetCurrent();
+    /**
+     * @brief Charges a query to the current trace of the calling thread, if any.
+     *
+     * @param[in] time Time (in microseconds) the query took.
+     */
+    static void AddQuery( uint64 time );
+
+    /**
+     * @brief Formats a trace as a line with its per-stage breakdown.
+     *
+     * @param[in]  trace The trace.
+     * @param[out] into  Receives the line.
+     */
+    static void Format( const CallTrace& trace, std::string& into );
+
+protected:
+    /// One in how many calls is traced; 0 if none.
+    volatile uint32 mRate;
+    /// Number of the latest traces kept.
+    size_t mHistory;
+    /// Whether every finished trace is logged.
+    bool mLog;
+
+    /// Number of calls seen since the last sampled one.
+    uint32 mCountdown;
+    /// When the main loop woke up last.
+    uint64 mTickStart;
+
+    /// Protects mFinished.
+    Mutex mMFinished;
+    /// Traces finished by the I/O threads, waiting for Process().
+    std::vector< CallTrace* > mFinished;
+    /// Number of traces dropped since the last Process().
+    uint32 mDropped;
+
+    /// The latest traces; the oldest is replaced first.
+    std::vector< CallTrace* > mLatest;
+    /// Index of the next trace in mLatest to replace.
+    size_t mNextLatest;
+
+    /// Histograms of the stages.
+    MetricHistogram* mStageMetrics[ CallTrace::STAGE_COUNT ];
+    /// Histogram of the whole calls.
+    MetricHistogram* mTotalMetric;
+
+    /// Statistics.
+    Stats mStats;
+};
+
+/// A macro for easier access to the singleton.
+#define sCallTracer \
+    ( CallTracer::get() )
+
+#endif /* !__UTILS__CALL_TRACER_H__INCL__ */
@@ -43,22 +43,92 @@ bool IsDeflated( const Buffer& data );
 /**
  * @brief Deflates given data.
  *
- * @param[in,out] data Data to be deflated, overwritten by result.
+ * @param[in,out] data  Data to be deflated, overwritten by result.
+ * @param[in]     level Compression level (0-9 or Z_DEFAULT_COMPRESSION).
  *
  * @retval true  Deflation ran successfully.
  * @retval false Error occurred during deflation.
  */
-bool DeflateData( Buffer& data );
+bool DeflateData( Buffer& data, int level = Z_DEFAULT_COMPRESSION );
 /**
  * @brief Deflates given data.
  *
  * @param[in]  input  Data to be deflated.
  * @param[out] output Destination of deflated data.
+ * @param[in]  level  Compression level (0-9 or Z_DEFAULT_COMPRESSION).
  *
  * @retval true  Deflation ran successfully.
  * @retval false Error occurred during deflation.
  */
-bool DeflateData( const Buffer& input, Buffer& output );
+bool DeflateData( const Buffer& input, Buffer& output, int level = Z_DEFAULT_COMPRESSION );
+
+/**
+ * @brief Deflates data given in chunks.
+ *
+ * Produces the same zlib stream as DeflateData() of all the chunks
+ * put together, without having them all in memory at once.
+ *
+ * Uses the zlib context of the calling thread, which is set up once
+ * and reset for every stream, so only one DeflateStream may be open
+ * per thread at a time.
+ *
+ * @author EVEmu Team
+ */
+class DeflateStream
+{
+public:
+    /**
+     * @param[out] output Buffer the deflated data is appended to.
+     * @param[in]  level  Compression level (0-9 or Z_DEFAULT_COMPRESSION).
+     */
+    DeflateStream( Buffer& output, int level = Z_DEFAULT_COMPRESSION );
+    /**
+     * @brief Releases the context; drops the output if Finish() was not called.
+     */
+    ~DeflateStream();
+
+    /** @return False if an error occurred. */
+    bool IsValid() const { return NULL != mStream; }
+
+    /**
+     * @brief Deflates the next chunk of data.
+     *
+     * @param[in] data The data.
+     * @param[in] len  Length of the data.
+     *
+     * @retval true  Deflation ran successfully.
+     * @retval false Error occurred during deflation.
+     */
+    bool Write( const uint8* data, size_t len );
+    /**
+     * @brief Finishes the stream.
+     *
+     * @retval true  The output holds the complete stream.
+     * @retval false Error occurred during deflation.
+     */
+    bool Finish();
+
+protected:
+    /**
+     * @brief Runs deflate() until all the input is consumed.
+     *
+     * @param[in] flush Flush mode passed to deflate().
+     */
+    bool _Deflate( int flush );
+    /**
+     * @brief Drops the output and releases the context.
+     */
+    void _Fail();
+
+    /// Buffer the deflated data is appended to.
+    Buffer& mOutput;
+    /// Size of the output before the stream.
+    const size_t mStart;
+    /// Length of the output actually written.
+    size_t mUsed;
+    /// The context of our thread; NULL if failed or finished.
+    z_stream* mStream;
+};
 
 /**
  * @brief Inflates given data.
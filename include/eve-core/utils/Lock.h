@@ -127,4 +127,76 @@ protected:
     bool mLocked;
 };
 
+/**
+ * @brief A shared lock for a reader/writer lockable object.
+ *
+ * The object is locked shared during contruction and unlocked
+ * during destruction.
+ *
+ * The passed typename should provide LockShared() and UnlockShared(),
+ * like SharedMutex does.
+ *
+ * @author EVEmu Team
+ */
+template< typename T >
+class SharedLock
+{
+public:
+    /**
+     * @brief Primary contructor, locks the object shared.
+     *
+     * @param[in] object Object to bound this lock to.
+     * @param[in] lock   Lock the object during construction.
+     */
+    SharedLock( T& object, bool lock = true )
+    : mObject( object ),
+      mLocked( false )
+    {
+        if( lock )
+            Relock();
+    }
+    /**
+     * @brief Destructor, unlocks the object.
+     */
+    ~SharedLock()
+    {
+        Unlock();
+    }
+
+    /**
+     * @brief Obtains the lock state of the object.
+     *
+     * @retval true  The object is locked.
+     * @retval false The object is not locked.
+     */
+    bool isLocked() const { return mLocked; }
+
+    /**
+     * @brief Locks the object shared.
+     */
+    void Relock()
+    {
+        if( !isLocked() )
+            mObject.LockShared();
+
+        mLocked = true;
+    }
+    /**
+     * @brief Unlocks the object.
+     */
+    void Unlock()
+    {
+        if( isLocked() )
+            mObject.UnlockShared();
+
+        mLocked = false;
+    }
+
+protected:
+    /// The object this lock is bound to.
+    T& mObject;
+    /// True the @a mObject is locked, false if not.
+    bool mLocked;
+};
+
 #endif /* !__UTILS__LOCK_H__INCL__ */
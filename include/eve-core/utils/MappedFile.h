@@ -0,0 +1,75 @@
+/*
+    ------------------------------------------------------------------------------------
+    LICENSE:
+    ------------------------------------------------------------------------------------
+    This file is part of EVEmu: EVE Online Server Emulator
+    Copyright 2006 - 2011 The EVEmu Team
+    For the latest information visit http://evemu.org
+    ------------------------------------------------------------------------------------
+    This program is free software; you can redistribute it and/or modify it under
+    the terms of the GNU Lesser General Public License as published by the Free Software
+    Foundation; either version 2 of the License, or (at your option) any later
+    version.
+
+    This program is distributed in the hope that it will be useful, but WITHOUT
+    ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+    FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public License along with
+    this program; if not, write to the Free Software Foundation, Inc., 59 Temple
+    Place - Suite 330, Boston, MA 02111-1307, USA, or go to
+    http://www.gnu.org/copyleft/lesser.txt.
+    ------------------------------------------------------------------------------------
+    Author:     EVEmu Team
+*/
+
+#ifndef __UTILS__MAPPED_FILE_H__INCL__
+#define __UTILS__MAPPED_FILE_H__INCL__
+
+#include "utils/RefPtr.h"
+
+/**
+ * @brief Read-only memory mapping of a whole file.
+ *
+ * The pages are shared with the page cache, so nothing is read until
+ * it is touched and the file stays cached across restarts. Buffers may
+ * view the mapping through Buffer( const uint8*, size_type, owner ),
+ * which keeps it alive for as long as they exist.
+ *
+ * The file must not be truncated while it is mapped; replace it with
+ * a new one instead.
+ *
+ * @author EVEmu Team
+ */
+class MappedFile
+: public RefObject
+{
+public:
+    /**
+     * @brief Maps a file.
+     *
+     * @param[in] filename Name of the file.
+     *
+     * @return The mapping; NULL if the file could not be mapped or is empty.
+     */
+    static RefPtr< MappedFile > Open( const char* filename );
+
+    /** @return The mapped bytes. */
+    const uint8* data() const { return mData; }
+    /** @return Size of the file, in bytes. */
+    size_t size() const { return mSize; }
+
+protected:
+    MappedFile( const uint8* data, size_t size );
+    /**
+     * @brief Unmaps the file.
+     */
+    ~MappedFile();
+
+    /// The mapped bytes.
+    const uint8* const mData;
+    /// Size of the file, in bytes.
+    const size_t mSize;
+};
+
+#endif /* !__UTILS__MAPPED_FILE_H__INCL__ */
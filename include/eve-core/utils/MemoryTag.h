@@ -0,0 +1,243 @@
+/*
+    ------------------------------------------------------------------------------------
+    LICENSE:
+    ------------------------------------------------------------------------------------
+    This file is part of EVEmu: EVE Online Server Emulator
+    Copyright 2006 - 2011 The EVEmu Team
+    For the latest information visit http://evemu.org
+    ------------------------------------------------------------------------------------
+    This program is free software; you can redistribute it and/or modify it under
+    the terms of the GNU Lesser General Public License as published by the Free Software
+    Foundation; either version 2 of the License, or (at your option) any later
+    version.
+
+    This program is distributed in the hope that it will be useful, but WITHOUT
+    ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+    FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public License along with
+    this program; if not, write to the Free Software Foundation, Inc., 59 Temple
+    Place - Suite 330, Boston, MA 02111-1307, USA, or go to
+    http://www.gnu.org/copyleft/lesser.txt.
+    ------------------------------------------------------------------------------------
+    Author:     EVEmu Team
+*/
+
+
+#ifndef __UTILS__MEMORY_TAG_H__INCL__
+#define __UTILS__MEMORY_TAG_H__INCL__
+
+#include "threading/Atomic.h"
+
+class MetricGauge;
+
+/**
+ * @brief Accounts the heap memory of a subsystem.
+ *
+ * A class is tagged by forwarding its operator new and operator delete,
+ * the same way classes are pooled with ObjectPool:
+ *
+ *   static void* operator new( size_t size ) { return sMemoryTag.Allocate( size ); }
+ *   static void operator delete( void* p, size_t size ) { sMemoryTag.Free( p, size ); }
+ *
+ * The size operator delete gets is the size of the dynamic type as
+ * long as the destructor is virtual, so derived classes are accounted
+ * correctly. Memory which does not come from operator new, such as
+ * the buffers of a cache, is accounted with Retain() and Release().
+ * STL containers may account their nodes with MemoryTagAllocator.
+ *
+ * The counters are updated with atomic operations, so any thread may
+ * allocate. The tags are meant to be objects with static storage
+ * duration; they are zero-initialized before any constructor runs, so
+ * allocating during static initialization is fine.
+ *
+ * Every SetSampleRate()-th allocation records its call stack, kept
+ * until the allocation is freed; DumpSamples() groups the stacks of
+ * the live ones, which points at whatever keeps piling up. While any
+ * sample is live, every Free() takes a lock.
+ *
+ * @author EVEmu Team
+ */
+class MemoryTag
+{
+public:
+    /// Most frames of a sampled call stack.
+    static const size_t MAX_FRAMES = 16;
+
+    /**
+     * @brief Current counters of a tag.
+     */
+    struct Stats
+    {
+        /// Number of bytes allocated and not freed.
+        int64 liveBytes;
+        /// Number of objects allocated and not freed.
+        int64 liveObjects;
+        /// Number of allocations ever made.
+        uint64 allocations;
+    };
+
+    /**
+     * @brief A call stack shared by live sampled allocations.
+     */
+    struct Sample
+    {
+        const MemoryTag* tag;
+        /// Number of the live sampled allocations.
+        size_t count;
+        /// Their total size.
+        size_t bytes;
+        /// The call stack, one symbol per frame.
+        std::vector< std::string > frames;
+    };
+
+    /**
+     * @param[in] name Name of the tag; must outlive the tag.
+     */
+    MemoryTag( const char* name );
+
+    /** @return Name of the tag. */
+    const char* name() const { return mName; }
+    /** @return Current counters of the tag. */
+    Stats GetStats() const;
+
+    /**
+     * @brief Allocates an object.
+     *
+     * @return The object; throws std::bad_alloc on failure.
+     */
+    void* Allocate( size_t size )
+    {
+        void* p = ::operator new( size );
+        Retain( size );
+
+        if( 0 < AtomicLoad( &sSampleRate ) )
+            _Sample( p, size );
+
+        return p;
+    }
+    /**
+     * @brief Frees an object.
+     *
+     * @param[in] p    The object, as returned by Allocate(); may be NULL.
+     * @param[in] size Size of the object, as passed to Allocate().
+     */
+    void Free( void* p, size_t size )
+    {
+        if( NULL == p )
+            return;
+
+        Release( size );
+
+        if( 0 < AtomicLoad( &sLiveSamples ) )
+            _Unsample( p );
+
+        ::operator delete( p );
+    }
+
+    /** @brief Accounts an object allocated some other way. */
+    void Retain( size_t size )
+    {
+        AtomicAdd64( &mBytes, size );
+        AtomicAdd64( &mObjects, 1 );
+        AtomicAdd64( &mAllocations, 1 );
+    }
+    /** @brief Accounts an object accounted by Retain() as freed. */
+    void Release( size_t size )
+    {
+        AtomicAdd64( &mBytes, -(uint64)size );
+        AtomicAdd64( &mObjects, -(uint64)1 );
+    }
+
+    /** @return The first of all the tags; iterate with next(). */
+    static const MemoryTag* first() { return sFirst; }
+    /** @return The next tag; NULL after the last one. */
+    const MemoryTag* next() const { return mNext; }
+    /** @return The tag of the name; NULL if there is none. */
+    static const MemoryTag* Find( const char* name );
+
+    /**
+     * @brief Sets how often the allocations of all tags record their call stack.
+     *
+     * @param[in] rate Every rate-th allocation is sampled; 0 disables sampling.
+     */
+    static void SetSampleRate( uint32 rate );
+    /** @return The sample rate; 0 if sampling is disabled. */
+    static uint32 GetSampleRate() { return AtomicLoad( &sSampleRate ); }
+
+    /**
+     * @brief Groups the live sampled allocations by tag and call stack.
+     *
+     * @param[out] into The groups, biggest first.
+     */
+    static void DumpSamples( std::vector< Sample >& into );
+    /** @brief Forgets all the sampled allocations. */
+    static void ClearSamples();
+
+    /**
+     * @brief Publishes the counters of all the tags as gauges.
+     *
+     * The gauges are evemu_memory_live_bytes and evemu_memory_live_objects,
+     * labelled by the tag.
+     */
+    static void PublishMetrics();
+
+protected:
+    /** @brief Samples an allocation if it is its turn. */
+    void _Sample( void* p, size_t size );
+    /** @brief Forgets a freed allocation if it was sampled. */
+    static void _Unsample( void* p );
+
+    const char* const mName;
+    /// The next tag of the list of all tags.
+    MemoryTag* const mNext;
+
+    /* The counters; left alone by the constructor, see above. */
+    volatile uint64 mBytes;
+    volatile uint64 mObjects;
+    volatile uint64 mAllocations;
+
+    /// The gauges of PublishMetrics(); NULL until first published.
+    MetricGauge* mBytesMetric;
+    MetricGauge* mObjectsMetric;
+
+    /// The first of all the tags.
+    static MemoryTag* sFirst;
+    /// Every sSampleRate-th allocation is sampled; 0 if none.
+    static volatile uint32 sSampleRate;
+    /// Number of the live sampled allocations.
+    static volatile uint32 sLiveSamples;
+};
+
+/**
+ * @brief STL allocator which accounts the nodes of a container to a tag.
+ *
+ * @author EVEmu Team
+ */
+template< typename T, MemoryTag& TAG >
+class MemoryTagAllocator
+: public std::allocator< T >
+{
+public:
+    template< typename U >
+    struct rebind
+    {
+        typedef MemoryTagAllocator< U, TAG > other;
+    };
+
+    MemoryTagAllocator() {}
+    MemoryTagAllocator( const MemoryTagAllocator& oth ) : std::allocator< T >( oth ) {}
+    template< typename U >
+    MemoryTagAllocator( const MemoryTagAllocator< U, TAG >& oth ) : std::allocator< T >( oth ) {}
+
+    T* allocate( size_t n, const void* hint = 0 )
+    {
+        return static_cast< T* >( TAG.Allocate( n * sizeof( T ) ) );
+    }
+    void deallocate( T* p, size_t n )
+    {
+        TAG.Free( p, n * sizeof( T ) );
+    }
+};
+
+#endif /* !__UTILS__MEMORY_TAG_H__INCL__ */
@@ -0,0 +1,236 @@
+/*
+    ------------------------------------------------------------------------------------
+    LICENSE:
+    ------------------------------------------------------------------------------------
+    This file is part of EVEmu: EVE Online Server Emulator
+    Copyright 2006 - 2011 The EVEmu Team
+    For the latest information visit http://evemu.org
+    ------------------------------------------------------------------------------------
+    This program is free software; you can redistribute it and/or modify it under
+    the terms of the GNU Lesser General Public License as published by the Free Software
+    Foundation; either version 2 of the License, or (at your option) any later
+    version.
+
+    This program is distributed in the hope that it will be useful, but WITHOUT
+    ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+    FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public License along with
+    this program; if not, write to the Free Software Foundation, Inc., 59 Temple
+    Place - Suite 330, Boston, MA 02111-1307, USA, or go to
+    http://www.gnu.org/copyleft/lesser.txt.
+    ------------------------------------------------------------------------------------
+    Author:     EVEmu Team
+*/
+
+
+#ifndef __UTILS__METRICS_H__INCL__
+#define __UTILS__METRICS_H__INCL__
+
+#include "threading/Atomic.h"
+#include "threading/Mutex.h"
+#include "utils/Singleton.h"
+
+/**
+ * @brief A metric kept by MetricRegistry.
+ *
+ * The values are updated with atomic operations, so any thread may
+ * update them while another renders them. Counters and histograms
+ * are split into shards, one for each thread (threads beyond the
+ * number of shards share them), each on a cache line of its own, so
+ * the threads updating a metric never contend for its cache lines.
+ *
+ * @author EVEmu Team
+ */
+class Metric
+{
+public:
+    enum Type
+    {
+        METRIC_COUNTER,
+        METRIC_GAUGE,
+        METRIC_HISTOGRAM
+    };
+
+    /// Number of shards of counters and histograms.
+    static const uint32 SHARD_COUNT = 16;
+
+    virtual ~Metric() {}
+
+    /**
+     * @brief Appends the samples in the Prometheus text format.
+     *
+     * @param[in]  name   Name of the metric.
+     * @param[in]  labels Labels of the metric, without braces; may be empty.
+     * @param[out] into   The string to append to.
+     */
+    virtual void Render( const std::string& name, const std::string& labels, std::string& into ) const = 0;
+
+protected:
+    /// A value on a cache line of its own.
+    struct Cell
+    {
+        volatile uint64 value;
+        uint8 padding[ 64 - sizeof( uint64 ) ];
+    };
+
+    /** @return The shard of the calling thread. */
+    static uint32 _GetShard();
+    /** @brief Appends a single sample. */
+    static void _RenderSample( const std::string& name, const std::string& labels, const char* value, std::string& into );
+};
+
+/**
+ * @brief A value which only ever goes up.
+ *
+ * @author EVEmu Team
+ */
+class MetricCounter
+: public Metric
+{
+public:
+    MetricCounter();
+
+    /** @brief Adds to the counter; safe to call from any thread. */
+    void Add( uint64 value = 1 ) { AtomicAdd64( &mShards[ _GetShard() ].value, value ); }
+    /** @return The value of the counter. */
+    uint64 Get() const;
+
+    void Render( const std::string& name, const std::string& labels, std::string& into ) const;
+
+protected:
+    Cell mShards[ SHARD_COUNT ];
+};
+
+/**
+ * @brief A value which may go up and down.
+ *
+ * @author EVEmu Team
+ */
+class MetricGauge
+: public Metric
+{
+public:
+    MetricGauge() : mValue( 0 ) {}
+
+    /** @brief Sets the value; safe to call from any thread. */
+    void Set( int64 value ) { AtomicStore64( &mValue, (uint64)value ); }
+    /** @brief Adds to the value, which may be negative; safe to call from any thread. */
+    void Add( int64 value ) { AtomicAdd64( &mValue, (uint64)value ); }
+    /** @return The value. */
+    int64 Get() const { return (int64)AtomicLoad64( &mValue ); }
+
+    void Render( const std::string& name, const std::string& labels, std::string& into ) const;
+
+protected:
+    volatile uint64 mValue;
+};
+
+/**
+ * @brief Distribution of observed values in buckets.
+ *
+ * @author EVEmu Team
+ */
+class MetricHistogram
+: public Metric
+{
+public:
+    /**
+     * @param[in] bounds Upper bounds of the buckets in ascending order;
+     *                   a bucket of the larger values is added.
+     * @param[in] scale  Observed units per rendered unit; 1e6 renders
+     *                   microseconds as seconds.
+     */
+    MetricHistogram( const std::vector< uint64 >& bounds, double scale );
+    ~MetricHistogram();
+
+    /** @brief Records a value; safe to call from any thread. */
+    void Observe( uint64 value );
+
+    void Render( const std::string& name, const std::string& labels, std::string& into ) const;
+
+protected:
+    /// Upper bounds of the buckets.
+    const std::vector< uint64 > mBounds;
+    const double mScale;
+
+    /// Number of values in each shard: the counts of the buckets, then the sum.
+    const uint32 mStride;
+    /// The shards, SHARD_COUNT * mStride values.
+    volatile uint64* mCells;
+};
+
+/**
+ * @brief Registry of the metrics exported by the server.
+ *
+ * Metrics are registered by name (and labels) once and live as long
+ * as the registry, so the callers keep references to them. Render()
+ * writes all of them in the Prometheus text format.
+ *
+ * Thread-safe.
+ *
+ * @author EVEmu Team
+ */
+class MetricRegistry
+: public Singleton< MetricRegistry >
+{
+public:
+    MetricRegistry();
+    ~MetricRegistry();
+
+    /**
+     * @brief Finds or registers a counter.
+     *
+     * @param[in] name   Name of the metric.
+     * @param[in] help   Description of the metric.
+     * @param[in] labels Labels of the metric, like 'kind="x"'; may be empty.
+     *
+     * @return The counter.
+     */
+    MetricCounter& Counter( const char* name, const char* help, const char* labels = "" );
+    /** @brief Finds or registers a gauge. */
+    MetricGauge& Gauge( const char* name, const char* help, const char* labels = "" );
+    /**
+     * @brief Finds or registers a histogram.
+     *
+     * @param[in] bounds Upper bounds of the buckets; ignored if the histogram is registered already.
+     * @param[in] scale  Observed units per rendered unit.
+     */
+    MetricHistogram& Histogram( const char* name, const char* help, const std::vector< uint64 >& bounds, double scale, const char* labels = "" );
+    /**
+     * @brief Finds or registers a histogram of durations in microseconds, rendered in seconds.
+     */
+    MetricHistogram& LatencyHistogram( const char* name, const char* help, const char* labels = "" );
+
+    /**
+     * @brief Appends all the metrics in the Prometheus text format.
+     */
+    void Render( std::string& into );
+
+protected:
+    /**
+     * @brief Metrics of the same name.
+     */
+    struct Family
+    {
+        Metric::Type type;
+        std::string help;
+        /// The metrics, by labels.
+        std::map< std::string, Metric* > metrics;
+    };
+
+    /** @return The registered metric; NULL if there is none. */
+    Metric* _Find( const char* name, const char* help, Metric::Type type, const char* labels );
+    void _Add( const char* name, const char* labels, Metric* metric );
+
+    /// Protects mFamilies.
+    Mutex mMutex;
+    /// The metrics, by name.
+    std::map< std::string, Family > mFamilies;
+};
+
+/// A macro for easier access to the singleton.
+#define sMetrics \
+    ( MetricRegistry::get() )
+
+#endif /* !__UTILS__METRICS_H__INCL__ */
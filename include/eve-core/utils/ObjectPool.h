@@ -0,0 +1,217 @@
+/*
+    ------------------------------------------------------------------------------------
+    LICENSE:
+    ------------------------------------------------------------------------------------
+    This file is part of EVEmu: EVE Online Server Emulator
+    Copyright 2006 - 2011 The EVEmu Team
+    For the latest information visit http://evemu.org
+    ------------------------------------------------------------------------------------
+    This program is free software; you can redistribute it and/or modify it under
+    the terms of the GNU Lesser General Public License as published by the Free Software
+    Foundation; either version 2 of the License, or (at your option) any later
+    version.
+
+    This program is distributed in the hope that it will be useful, but WITHOUT
+    ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+    FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public License along with
+    this program; if not, write to the Free Software Foundation, Inc., 59 Temple
+    Place - Suite 330, Boston, MA 02111-1307, USA, or go to
+    http://www.gnu.org/copyleft/lesser.txt.
+    ------------------------------------------------------------------------------------
+    Author:     EVEmu Team
+*/
+
+
+#ifndef __UTILS__OBJECT_POOL_H__INCL__
+#define __UTILS__OBJECT_POOL_H__INCL__
+
+/**
+ * @brief Allocator of objects of a single class.
+ *
+ * Works like SizeClassPool, but every class has its own per-thread
+ * free list, so the objects of a class which is allocated and freed
+ * at a high rate are recycled among themselves, are counted on their
+ * own and do not compete with the small blocks of other classes.
+ *
+ * A class is pooled by forwarding its operator new and operator delete:
+ *
+ *   static void* operator new( size_t size ) { return ObjectPool< Foo >::Allocate( size ); }
+ *   static void operator delete( void* p, size_t size ) { ObjectPool< Foo >::Free( p, size ); }
+ *
+ * Objects of derived classes (of other size) go straight to the heap.
+ *
+ * Unless NDEBUG is defined, allocated objects are filled with
+ * ALLOCATED_FILL and freed ones with FREED_FILL, and the fill of
+ * a cached object is checked when it is handed out again, which
+ * catches writes through dangling pointers.
+ *
+ * @author EVEmu Team
+ */
+template< typename T >
+class ObjectPool
+{
+public:
+    /// Most objects cached by the free list of a thread.
+    static const size_t MAX_CACHED = 1024;
+    /// Fill of allocated objects in debug builds.
+    static const uint8 ALLOCATED_FILL = 0xCD;
+    /// Fill of freed objects in debug builds.
+    static const uint8 FREED_FILL = 0xDD;
+
+    /**
+     * @brief Allocation statistics of a thread.
+     */
+    struct Stats
+    {
+        Stats() { Reset(); }
+
+        void Reset()
+        {
+            allocations = 0;
+            poolHits = 0;
+            frees = 0;
+            poolReturns = 0;
+            cached = 0;
+        }
+
+        /// Number of Allocate() calls.
+        uint64 allocations;
+        /// Number of allocations served from the free list.
+        uint64 poolHits;
+        /// Number of Free() calls.
+        uint64 frees;
+        /// Number of objects kept in the free list.
+        uint64 poolReturns;
+        /// Number of objects in the free list now.
+        uint64 cached;
+    };
+
+    /**
+     * @brief Allocates an object.
+     *
+     * @param[in] size Size of the object.
+     *
+     * @return The object; throws std::bad_alloc on failure.
+     */
+    static void* Allocate( size_t size )
+    {
+        ++sAllocations;
+
+        if( sizeof( T ) != size || NULL == sFreeList )
+            return _Fill( ::operator new( _BlockSize( size ) ), size, ALLOCATED_FILL );
+
+        FreeBlock* block = sFreeList;
+        sFreeList = block->next;
+        --sFreeCount;
+
+        ++sPoolHits;
+
+#ifndef NDEBUG
+        // the fill after the link must be intact
+        const uint8* p = reinterpret_cast< const uint8* >( block ) + sizeof( FreeBlock );
+        for( size_t i = sizeof( FreeBlock ); i < size; ++i, ++p )
+            assert( FREED_FILL == *p );
+#endif /* !NDEBUG */
+
+        return _Fill( block, size, ALLOCATED_FILL );
+    }
+    /**
+     * @brief Frees an object.
+     *
+     * @param[in] p    The object, as returned by Allocate(); may be NULL.
+     * @param[in] size Size of the object, as passed to Allocate().
+     */
+    static void Free( void* p, size_t size )
+    {
+        if( NULL == p )
+            return;
+
+        ++sFrees;
+        _Fill( p, _BlockSize( size ), FREED_FILL );
+
+        if( sizeof( T ) != size || MAX_CACHED <= sFreeCount )
+        {
+            ::operator delete( p );
+            return;
+        }
+
+        FreeBlock* block = static_cast< FreeBlock* >( p );
+        block->next = sFreeList;
+        sFreeList = block;
+        ++sFreeCount;
+
+        ++sPoolReturns;
+    }
+
+    /** @return Allocation statistics of the calling thread. */
+    static Stats GetStats()
+    {
+        Stats stats;
+        stats.allocations = sAllocations;
+        stats.poolHits = sPoolHits;
+        stats.frees = sFrees;
+        stats.poolReturns = sPoolReturns;
+        stats.cached = sFreeCount;
+
+        return stats;
+    }
+    /**
+     * @brief Resets allocation statistics of the calling thread.
+     */
+    static void ResetStats()
+    {
+        sAllocations = 0;
+        sPoolHits = 0;
+        sFrees = 0;
+        sPoolReturns = 0;
+    }
+
+protected:
+    /// Free object, links to the next one.
+    struct FreeBlock
+    {
+        FreeBlock* next;
+    };
+
+    /** @return Size of the block of an object; a block must hold the link. */
+    static size_t _BlockSize( size_t size )
+    {
+        return ( sizeof( FreeBlock ) < size ? size : sizeof( FreeBlock ) );
+    }
+
+    /** @brief Fills a block in debug builds. */
+    static void* _Fill( void* p, size_t size, uint8 fill )
+    {
+#ifndef NDEBUG
+        memset( p, fill, size );
+#endif /* !NDEBUG */
+
+        return p;
+    }
+
+    /* The free list and statistics of the thread. Plain data only, as
+       thread-local variables may not have constructors. */
+    static THREAD_LOCAL FreeBlock* sFreeList;
+    static THREAD_LOCAL size_t sFreeCount;
+    static THREAD_LOCAL uint64 sAllocations;
+    static THREAD_LOCAL uint64 sPoolHits;
+    static THREAD_LOCAL uint64 sFrees;
+    static THREAD_LOCAL uint64 sPoolReturns;
+};
+
+template< typename T >
+THREAD_LOCAL typename ObjectPool< T >::FreeBlock* ObjectPool< T >::sFreeList = NULL;
+template< typename T >
+THREAD_LOCAL size_t ObjectPool< T >::sFreeCount = 0;
+template< typename T >
+THREAD_LOCAL uint64 ObjectPool< T >::sAllocations = 0;
+template< typename T >
+THREAD_LOCAL uint64 ObjectPool< T >::sPoolHits = 0;
+template< typename T >
+THREAD_LOCAL uint64 ObjectPool< T >::sFrees = 0;
+template< typename T >
+THREAD_LOCAL uint64 ObjectPool< T >::sPoolReturns = 0;
+
+#endif /* !__UTILS__OBJECT_POOL_H__INCL__ */
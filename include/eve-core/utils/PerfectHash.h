@@ -0,0 +1,96 @@
+/*
+    ------------------------------------------------------------------------------------
+    LICENSE:
+    ------------------------------------------------------------------------------------
+    This file is part of EVEmu: EVE Online Server Emulator
+    Copyright 2006 - 2011 The EVEmu Team
+    For the latest information visit http://evemu.org
+    ------------------------------------------------------------------------------------
+    This program is free software; you can redistribute it and/or modify it under
+    the terms of the GNU Lesser General Public License as published by the Free Software
+    Foundation; either version 2 of the License, or (at your option) any later
+    version.
+
+    This program is distributed in the hope that it will be useful, but WITHOUT
+    ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+    FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public License along with
+    this program; if not, write to the Free Software Foundation, Inc., 59 Temple
+    Place - Suite 330, Boston, MA 02111-1307, USA, or go to
+    http://www.gnu.org/copyleft/lesser.txt.
+    ------------------------------------------------------------------------------------
+    Author:     EVEmu Team
+*/
+
+#ifndef __UTILS__PERFECT_HASH_H__INCL__
+#define __UTILS__PERFECT_HASH_H__INCL__
+
+/**
+ * @brief Perfect hash of a fixed set of strings.
+ *
+ * Built once using hash-and-displace: keys are spread into buckets
+ * by one hash, then every bucket gets its own seed for a second hash
+ * which lands all of its keys on distinct free slots. A lookup then
+ * costs two hashes and a single string compare, regardless of the
+ * number of keys.
+ *
+ * @author EVEmu Team
+ */
+class PerfectHash
+{
+public:
+    /// Returned by Find() for unknown keys.
+    static const uint32 INVALID_INDEX;
+
+    /**
+     * @brief Creates empty hash.
+     */
+    PerfectHash();
+
+    /** @return Number of keys. */
+    size_t size() const { return mKeys.size(); }
+
+    /**
+     * @brief Builds the hash of given keys.
+     *
+     * @param[in] keys The keys; must be unique.
+     *
+     * @retval true  Hash built.
+     * @retval false Hash could not be built (duplicate keys); it is empty now.
+     */
+    bool Build( const std::vector<std::string>& keys );
+    /**
+     * @brief Empties the hash.
+     */
+    void Clear();
+
+    /**
+     * @brief Looks up a key.
+     *
+     * @param[in] key The key to look up.
+     *
+     * @return Index of the key in the vector passed to Build(); INVALID_INDEX if not found.
+     */
+    uint32 Find( const std::string& key ) const;
+
+protected:
+    /**
+     * @brief Hashes a key.
+     *
+     * @param[in] seed Seed of the hash.
+     * @param[in] key  The key.
+     *
+     * @return The hash.
+     */
+    static uint32 _Hash( uint32 seed, const std::string& key );
+
+    /// The keys.
+    std::vector<std::string> mKeys;
+    /// Seed of the second hash for each bucket.
+    std::vector<uint32> mSeeds;
+    /// Key index for each slot; INVALID_INDEX for free slots.
+    std::vector<uint32> mSlots;
+};
+
+#endif /* !__UTILS__PERFECT_HASH_H__INCL__ */
@@ -0,0 +1,98 @@
+/*
+    ------------------------------------------------------------------------------------
+    LICENSE:
+    ------------------------------------------------------------------------------------
+    This file is part of EVEmu: EVE Online Server Emulator
+    Copyright 2006 - 2011 The EVEmu Team
+    For the latest information visit http://evemu.org
+    ------------------------------------------------------------------------------------
+    This program is free software; you can redistribute it and/or modify it under
+    the terms of the GNU Lesser General Public License as published by the Free Software
+    Foundation; either version 2 of the License, or (at your option) any later
+    version.
+
+    This program is distributed in the hope that it will be useful, but WITHOUT
+    ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+    FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public License along with
+    this program; if not, write to the Free Software Foundation, Inc., 59 Temple
+    Place - Suite 330, Boston, MA 02111-1307, USA, or go to
+    http://www.gnu.org/copyleft/lesser.txt.
+    ------------------------------------------------------------------------------------
+    Author:     EVEmu Team
+*/
+
+
+#ifndef __UTILS__POINT_BATCH_H__INCL__
+#define __UTILS__POINT_BATCH_H__INCL__
+
+#include "utils/misc.h"
+#include "utils/gpoint.h"
+
+/**
+ * @brief Points laid out for queries of one point against all of them.
+ *
+ * The coordinates are kept in three separate arrays (structure of
+ * arrays), so the distances to several points are computed at once
+ * with SIMD instructions: AVX (4 points), SSE2 or NEON (2 points),
+ * whichever the build targets; plain C++ otherwise. The results are
+ * the same as those of GVector( from, point ).lengthSquared().
+ *
+ * @author EVEmu Team
+ */
+class PointBatch
+{
+public:
+    /** @return Number of points. */
+    size_t size() const { return mX.size(); }
+    /** @return True if there are no points. */
+    bool empty() const { return mX.empty(); }
+
+    /** @brief Removes all points. */
+    void clear();
+    /** @brief Reserves space for given number of points. */
+    void reserve( size_t count );
+
+    /**
+     * @brief Appends a point.
+     *
+     * @return Index of the point.
+     */
+    size_t Add( const GPoint& point );
+    /** @brief Replaces the point at given index. */
+    void Set( size_t index, const GPoint& point );
+    /**
+     * @brief Removes the point at given index.
+     *
+     * The following points move one index down.
+     */
+    void Remove( size_t index );
+    /** @return The point at given index. */
+    GPoint Get( size_t index ) const { return GPoint( mX[ index ], mY[ index ], mZ[ index ] ); }
+
+    /**
+     * @brief Computes squared distances of all points from a point.
+     *
+     * @param[in]  from The point.
+     * @param[out] into size() distances, in order of the points.
+     */
+    void DistanceSquared( const GPoint& from, double* into ) const;
+    /**
+     * @brief Finds the points within range of a point.
+     *
+     * @param[in]  from  The point.
+     * @param[in]  range The range; points exactly at the range are included.
+     * @param[out] into  Vector the indices of the points are appended to, in ascending order.
+     *
+     * @return Number of points found.
+     */
+    size_t FindInRange( const GPoint& from, double range, std::vector< uint32 >& into ) const;
+
+protected:
+    std::vector< double > mX;
+    std::vector< double > mY;
+    std::vector< double > mZ;
+};
+
+#endif /* !__UTILS__POINT_BATCH_H__INCL__ */
@@ -26,6 +26,8 @@
 #ifndef __UTILS__REF_PTR_H__INCL__
 #define __UTILS__REF_PTR_H__INCL__
 
+#include "threading/Atomic.h"
+
 /**
  * ENABLE_REF_TRACE
  *
@@ -50,6 +52,13 @@
  * RefPtr. If you want some of your classes to be
  * reference-counted, derive them from this class.
  *
+ * The reference count is local by default: it is
+ * maintained with plain arithmetic and the object
+ * must not be referenced by more than one thread.
+ * A shared object maintains it with atomic operations
+ * instead, so any thread may take and release its
+ * references; see MakeShared().
+ *
  * @author Bloody.Rabbit
  */
 class RefObject
@@ -62,9 +71,11 @@ public:
      * @brief Initializes reference count.
      *
      * @param[in] initRefCount Initial reference count.
+     * @param[in] shared       Whether the reference count is shared between threads.
      */
-    RefObject( size_t initRefCount )
-    : mRefCount( initRefCount )
+    RefObject( size_t initRefCount, bool shared = false )
+    : mRefCount( (uint32)initRefCount ),
+      mShared( shared )
     {
 #ifdef ENABLE_REF_TRACE
          mDeleted = false;
@@ -85,6 +96,19 @@ public:
         assert( mRefCount == 0);
     }
 
+    /** @return Number of references to the object. */
+    size_t GetRefCount() const { return mShared ? AtomicLoad( &mRefCount ) : mRefCount; }
+    /** @return True if the reference count is shared between threads. */
+    bool IsShared() const { return mShared; }
+
+    /**
+     * @brief Makes the reference count shared between threads.
+     *
+     * Must be called before the object is handed over
+     * to another thread; there is no way back.
+     */
+    void MakeShared() const { mShared = true; }
+
 protected:
     /**
      * @brief Increments reference count of object by one.
@@ -92,7 +116,11 @@ protected:
     void IncRef() const
     {
         REF_TRACE_MACRO();
-        ++mRefCount;
+
+        if( mShared )
+            AtomicAdd( &mRefCount, 1 );
+        else
+            ++mRefCount;
     }
     /**
      * @brief Decrements reference count of object by one.
@@ -104,14 +132,16 @@ protected:
     {
         REF_TRACE_MACRO();
         assert( mRefCount > 0 );
-        --mRefCount;
 
-        if( mRefCount <= 0 )
+        const uint32 refCount = ( mShared ? AtomicAdd( &mRefCount, (uint32)-1 ) : --mRefCount );
+        if( 0 == refCount )
             delete this;
     }
 
     /// Reference count of instance.
-    mutable size_t mRefCount;
+    mutable uint32 mRefCount;
+    /// Whether the reference count is maintained atomically.
+    mutable bool mShared;
 #ifdef ENABLE_REF_TRACE
     mutable bool mDeleted;
 #endif
@@ -0,0 +1,103 @@
+/*
+    ------------------------------------------------------------------------------------
+    LICENSE:
+    ------------------------------------------------------------------------------------
+    This file is part of EVEmu: EVE Online Server Emulator
+    Copyright 2006 - 2011 The EVEmu Team
+    For the latest information visit http://evemu.org
+    ------------------------------------------------------------------------------------
+    This program is free software; you can redistribute it and/or modify it under
+    the terms of the GNU Lesser General Public License as published by the Free Software
+    Foundation; either version 2 of the License, or (at your option) any later
+    version.
+
+    This program is distributed in the hope that it will be useful, but WITHOUT
+    ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+    FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public License along with
+    this program; if not, write to the Free Software Foundation, Inc., 59 Temple
+    Place - Suite 330, Boston, MA 02111-1307, USA, or go to
+    http://www.gnu.org/copyleft/lesser.txt.
+    ------------------------------------------------------------------------------------
+    Author:     EVEmu Team
+*/
+
+#ifndef __UTILS__SIZE_CLASS_POOL_H__INCL__
+#define __UTILS__SIZE_CLASS_POOL_H__INCL__
+
+/**
+ * @brief Allocator of small blocks.
+ *
+ * Freed blocks are kept in per-thread free lists, one for every size
+ * class, and handed out again by the next allocation of the same class,
+ * so short-lived objects do not hit the heap over and over again. No
+ * locking is involved: a block freed in another thread simply joins
+ * the free lists of that thread.
+ *
+ * Every free list is capped, blocks beyond the cap (and blocks larger
+ * than MAX_SIZE) go straight to the heap. Blocks cached by a thread
+ * which exits are not returned.
+ *
+ * @author EVEmu Team
+ */
+class SizeClassPool
+{
+public:
+    /// Granularity of the size classes.
+    static const size_t GRANULARITY = 8;
+    /// Largest pooled block.
+    static const size_t MAX_SIZE = 256;
+    /// Most blocks cached by a single free list.
+    static const size_t MAX_CACHED = 256;
+
+    /**
+     * @brief Allocation statistics of a thread.
+     */
+    struct Stats
+    {
+        Stats() { Reset(); }
+
+        void Reset()
+        {
+            allocations = 0;
+            poolHits = 0;
+            frees = 0;
+            poolReturns = 0;
+        }
+
+        /// Number of Allocate() calls.
+        uint64 allocations;
+        /// Number of allocations served from the free lists.
+        uint64 poolHits;
+        /// Number of Free() calls.
+        uint64 frees;
+        /// Number of blocks kept in the free lists.
+        uint64 poolReturns;
+    };
+
+    /**
+     * @brief Allocates a block.
+     *
+     * @param[in] size Size of the block.
+     *
+     * @return The block; throws std::bad_alloc on failure.
+     */
+    static void* Allocate( size_t size );
+    /**
+     * @brief Frees a block.
+     *
+     * @param[in] p    The block, as returned by Allocate(); may be NULL.
+     * @param[in] size Size of the block, as passed to Allocate().
+     */
+    static void Free( void* p, size_t size );
+
+    /** @return Allocation statistics of the calling thread. */
+    static Stats GetStats();
+    /**
+     * @brief Resets allocation statistics of the calling thread.
+     */
+    static void ResetStats();
+};
+
+#endif /* !__UTILS__SIZE_CLASS_POOL_H__INCL__ */
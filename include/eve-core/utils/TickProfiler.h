@@ -0,0 +1,249 @@
+/*
+    ------------------------------------------------------------------------------------
+    LICENSE:
+    ------------------------------------------------------------------------------------
+    This file is part of EVEmu: EVE Online Server Emulator
+    Copyright 2006 - 2011 The EVEmu Team
+    For the latest information visit http://evemu.org
+    ------------------------------------------------------------------------------------
+    This program is free software; you can redistribute it and/or modify it under
+    the terms of the GNU Lesser General Public License as published by the Free Software
+    Foundation; either version 2 of the License, or (at your option) any later
+    version.
+
+    This program is distributed in the hope that it will be useful, but WITHOUT
+    ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+    FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public License along with
+    this program; if not, write to the Free Software Foundation, Inc., 59 Temple
+    Place - Suite 330, Boston, MA 02111-1307, USA, or go to
+    http://www.gnu.org/copyleft/lesser.txt.
+    ------------------------------------------------------------------------------------
+    Author:     EVEmu Team
+*/
+
+#ifndef __UTILS__TICK_PROFILER_H__INCL__
+#define __UTILS__TICK_PROFILER_H__INCL__
+
+#include "utils/Singleton.h"
+
+/**
+ * @brief Flight recorder of the slowest main loop ticks.
+ *
+ * Every tick of the main loop is recorded as a tree of zones: the
+ * subsystems of the loop, the solar systems, the service calls and
+ * the database queries, each opened and closed by a ProfileZone.
+ * Only zones of the thread which began the tick are recorded; the
+ * others cost a check of a thread-local pointer.
+ *
+ * The slowest ticks since the last Reset() are kept with their zone
+ * trees, so they can be dumped on demand (see /tickprofile); a tick
+ * slower than the threshold is logged as soon as it ends.
+ *
+ * Not thread-safe; meant to be used from the main loop.
+ *
+ * @author EVEmu Team
+ */
+class TickProfiler
+: public Singleton< TickProfiler >
+{
+public:
+    /// Index of a zone which is not recorded.
+    static const size_t NO_ZONE = (size_t)-1;
+    /// Maximal number of zones recorded in a tick.
+    static const size_t MAX_ZONES = 4096;
+    /// Size of the detail of a zone, including the terminator.
+    static const size_t DETAIL_SIZE = 48;
+
+    /**
+     * @brief A zone of a tick.
+     */
+    struct Zone
+    {
+        /// Name of the zone; a string literal.
+        const char* name;
+        /// What the zone processed, truncated; may be empty.
+        char detail[ DETAIL_SIZE ];
+        /// Nesting depth, 0 for the zones of the loop itself.
+        uint16 depth;
+        /// Start (in microseconds) since the start of the tick.
+        uint32 start;
+        /// Duration (in microseconds).
+        uint32 duration;
+    };
+
+    /**
+     * @brief A recorded tick.
+     */
+    struct Tick
+    {
+        /// Number of the tick.
+        uint32 number;
+        /// When the tick began.
+        time_t when;
+        /// Duration (in microseconds).
+        uint32 duration;
+        /// Number of zones which did not fit into the tick.
+        uint32 dropped;
+        /// The zones, in the order they were entered.
+        std::vector< Zone > zones;
+    };
+
+    /**
+     * @brief Statistics of the profiler.
+     */
+    struct Stats
+    {
+        Stats() { Reset(); }
+
+        void Reset()
+        {
+            ticks = 0;
+            slowTicks = 0;
+            zones = 0;
+            droppedZones = 0;
+            maxTickTime = 0;
+        }
+
+        /// Number of ticks recorded.
+        uint32 ticks;
+        /// Number of ticks slower than the threshold.
+        uint32 slowTicks;
+        /// Number of zones recorded.
+        uint32 zones;
+        /// Number of zones which did not fit into their tick.
+        uint32 droppedZones;
+        /// Duration (in microseconds) of the slowest tick.
+        uint32 maxTickTime;
+    };
+
+    TickProfiler();
+
+    /** @return True if the ticks are recorded. */
+    bool IsEnabled() const { return mEnabled; }
+    /** @return Number of ticks kept. */
+    size_t size() const { return mSlowest.size(); }
+    /** @return Statistics since the last ResetStats(). */
+    const Stats& stats() const { return mStats; }
+    /** @brief Resets the statistics. */
+    void ResetStats() { mStats.Reset(); }
+
+    /**
+     * @brief Configures the profiler.
+     *
+     * @param[in] enabled   Whether to record the ticks.
+     * @param[in] threshold Duration (in milliseconds) above which a tick is logged; 0 disables it.
+     * @param[in] history   Number of the slowest ticks to keep.
+     */
+    void Configure( bool enabled, uint32 threshold, size_t history );
+
+    /**
+     * @brief Begins a tick; the calling thread records the zones until EndTick().
+     */
+    void BeginTick();
+    /**
+     * @brief Ends the tick, keeping it if it is one of the slowest.
+     */
+    void EndTick();
+
+    /**
+     * @brief Logs the slowest ticks with their zone trees, slowest first.
+     *
+     * @param[in]  count   Maximal number of ticks to log.
+     * @param[out] summary Receives one line per logged tick.
+     *
+     * @return Number of ticks logged.
+     */
+    size_t Dump( size_t count, std::string& summary ) const;
+    /**
+     * @brief Forgets the kept ticks.
+     */
+    void Reset();
+
+    /**
+     * @brief Enters a zone if the calling thread records one.
+     *
+     * @param[in] name   Name of the zone; must outlive the profiler.
+     * @param[in] detail What the zone processes; may be NULL.
+     * @param[in] length Length of the detail; strlen() of it if -1.
+     *
+     * @return Index of the zone; NO_ZONE if not recorded.
+     */
+    static size_t Enter( const char* name, const char* detail = NULL, size_t length = (size_t)-1 );
+    /**
+     * @brief Leaves a zone entered by Enter().
+     */
+    static void Leave( size_t zone );
+
+protected:
+    /** @brief Logs the zone tree of a tick. */
+    static void _LogTick( const Tick& tick );
+    /** @brief Finds the fastest of the kept ticks. */
+    void _FindFastest();
+
+    /// Whether the ticks are recorded.
+    bool mEnabled;
+    /// Duration (in microseconds) above which a tick is logged; 0 if never.
+    uint32 mThreshold;
+    /// Number of the slowest ticks to keep.
+    size_t mHistory;
+
+    /// The tick in progress.
+    Tick mCurrent;
+    /// When the tick in progress began, as per GetTimeUSeconds().
+    uint64 mStart;
+    /// Number of the next tick.
+    uint32 mNextNumber;
+
+    /// The slowest ticks, unordered.
+    std::vector< Tick > mSlowest;
+    /// Index of the fastest of mSlowest.
+    size_t mFastest;
+
+    /// Statistics.
+    Stats mStats;
+};
+
+/// A macro for easier access to the singleton.
+#define sTickProfiler \
+    ( TickProfiler::get() )
+
+/**
+ * @brief Records the scope it lives in as a zone of the tick in progress.
+ *
+ * @author EVEmu Team
+ */
+class ProfileZone
+{
+public:
+    /**
+     * @param[in] name Name of the zone; a string literal.
+     */
+    explicit ProfileZone( const char* name )
+    : mZone( TickProfiler::Enter( name ) )
+    {
+    }
+    /**
+     * @param[in] name   Name of the zone; a string literal.
+     * @param[in] detail What the zone processes.
+     * @param[in] length Length of the detail; strlen() of it if -1.
+     */
+    ProfileZone( const char* name, const char* detail, size_t length = (size_t)-1 )
+    : mZone( TickProfiler::Enter( name, detail, length ) )
+    {
+    }
+    /**
+     * @param[in] name Name of the zone; a string literal.
+     * @param[in] id   ID of what the zone processes.
+     */
+    ProfileZone( const char* name, uint32 id );
+
+    ~ProfileZone() { TickProfiler::Leave( mZone ); }
+
+protected:
+    /// Index of the zone.
+    size_t mZone;
+};
+
+#endif /* !__UTILS__TICK_PROFILER_H__INCL__ */
@@ -0,0 +1,253 @@
+/*
+    ------------------------------------------------------------------------------------
+    LICENSE:
+    ------------------------------------------------------------------------------------
+    This file is part of EVEmu: EVE Online Server Emulator
+    Copyright 2006 - 2011 The EVEmu Team
+    For the latest information visit http://evemu.org
+    ------------------------------------------------------------------------------------
+    This program is free software; you can redistribute it and/or modify it under
+    the terms of the GNU Lesser General Public License as published by the Free Software
+    Foundation; either version 2 of the License, or (at your option) any later
+    version.
+
+    This program is distributed in the hope that it will be useful, but WITHOUT
+    ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+    FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public License along with
+    this program; if not, write to the Free Software Foundation, Inc., 59 Temple
+    Place - Suite 330, Boston, MA 02111-1307, USA, or go to
+    http://www.gnu.org/copyleft/lesser.txt.
+    ------------------------------------------------------------------------------------
+    Author:     EVEmu Team
+*/
+
+#ifndef __UTILS__TIMER_WHEEL_H__INCL__
+#define __UTILS__TIMER_WHEEL_H__INCL__
+
+#include "utils/Singleton.h"
+
+/** Lateness (in milliseconds) above which a fired timer is counted as late. */
+extern const uint32 TIMERWHEEL_LATE_THRESHOLD;
+
+/**
+ * @brief Hierarchical timer wheel.
+ *
+ * Keeps scheduled callbacks in buckets by their expiry time, with
+ * millisecond resolution in the innermost wheel and coarser outer
+ * wheels which are cascaded inwards as the time goes by. Scheduling,
+ * cancelling and firing a callback all cost O(1), so unlike polling
+ * Timer::Check() of every object, only the expiring timers cost
+ * anything.
+ *
+ * Times are compared as differences, so the clock may wrap around.
+ * Not thread-safe; meant to be used from the main loop.
+ *
+ * @author EVEmu Team
+ */
+class TimerWheel
+: public Singleton< TimerWheel >
+{
+public:
+    /**
+     * @brief Interface of objects which may be scheduled.
+     */
+    class Callback
+    {
+        friend class TimerWheel;
+
+    public:
+        Callback();
+        /**
+         * @brief Cancels the callback if it is scheduled.
+         */
+        virtual ~Callback();
+
+        /** @return True if the callback is scheduled. */
+        bool IsTimerScheduled() const { return NULL != mTimerWheel; }
+
+    protected:
+        /**
+         * @brief Called by TimerWheel::Process() once the callback expires.
+         *
+         * The callback is no longer scheduled at this point, so it
+         * may schedule itself again.
+         */
+        virtual void TimerExpired() = 0;
+
+    private:
+        /// The wheel the callback is scheduled with; NULL if none.
+        TimerWheel* mTimerWheel;
+        /// Head of the list the callback is linked into.
+        Callback** mTimerSlot;
+        /// Neighbours in the list.
+        Callback* mTimerPrev;
+        Callback* mTimerNext;
+        /// Expiry time.
+        uint32 mTimerExpiry;
+    };
+
+    /**
+     * @brief Statistics of fired timers.
+     */
+    struct Stats
+    {
+        Stats() { Reset(); }
+
+        void Reset()
+        {
+            ticks = 0;
+            fired = 0;
+            maxFired = 0;
+            late = 0;
+            maxLateness = 0;
+        }
+
+        /// Number of Process() calls.
+        uint32 ticks;
+        /// Number of fired timers.
+        uint32 fired;
+        /// Most timers fired by a single Process() call.
+        uint32 maxFired;
+        /// Number of timers fired later than TIMERWHEEL_LATE_THRESHOLD.
+        uint32 late;
+        /// Greatest lateness (in milliseconds).
+        uint32 maxLateness;
+    };
+
+    /**
+     * @brief Creates empty wheel.
+     *
+     * @param[in] now The current time (in milliseconds).
+     */
+    TimerWheel( uint32 now = 0 );
+    /**
+     * @brief Cancels all scheduled callbacks.
+     */
+    ~TimerWheel();
+
+    /** @return Number of scheduled callbacks. */
+    size_t size() const { return mCount; }
+    /** @return Time (in milliseconds) of the last Process() call. */
+    uint32 now() const { return mNow; }
+    /** @return Statistics since the last ResetStats(). */
+    const Stats& stats() const { return mStats; }
+
+    /**
+     * @brief Schedules a callback.
+     *
+     * Already scheduled callback is rescheduled.
+     *
+     * @param[in] callback The callback.
+     * @param[in] delay    Time (in milliseconds) from now() until the callback expires.
+     */
+    void Schedule( Callback* callback, uint32 delay );
+    /**
+     * @brief Cancels a callback.
+     *
+     * Does nothing if the callback is not scheduled.
+     *
+     * @param[in] callback The callback.
+     */
+    void Cancel( Callback* callback );
+
+    /**
+     * @brief Fires all callbacks which expired by the given time.
+     *
+     * @param[in] now The current time (in milliseconds).
+     *
+     * @return Number of fired callbacks.
+     */
+    uint32 Process( uint32 now );
+
+    /**
+     * @return Time (in milliseconds, relative to now()) for which Process()
+     *         does not need to be called; 0xFFFFFFFF if nothing is scheduled.
+     */
+    uint32 GetTimeToNextExpiry() const;
+
+    /**
+     * @brief Resets the statistics.
+     */
+    void ResetStats() { mStats.Reset(); }
+
+protected:
+    /// Number of bits of the innermost wheel index.
+    static const uint32 INNER_BITS = 8;
+    /// Number of bits of the outer wheels' indexes.
+    static const uint32 OUTER_BITS = 6;
+    /// Number of outer wheels.
+    static const uint32 OUTER_COUNT = 3;
+
+    static const uint32 INNER_SIZE = 1 << INNER_BITS;
+    static const uint32 INNER_MASK = INNER_SIZE - 1;
+    static const uint32 OUTER_SIZE = 1 << OUTER_BITS;
+    static const uint32 OUTER_MASK = OUTER_SIZE - 1;
+
+    /**
+     * @brief Links the callback into the bucket of its expiry time.
+     */
+    void _Insert( Callback* callback );
+    /**
+     * @brief Unlinks the callback from its list.
+     */
+    static void _Unlink( Callback* callback );
+    /**
+     * @brief Moves the callbacks of given outer bucket to the inner wheels.
+     *
+     * @return The index of the bucket.
+     */
+    uint32 _Cascade( uint32 wheel, uint32 index );
+    /**
+     * @return True if Process() reaching given round boundary moves any callbacks.
+     */
+    bool _IsCascadePending( uint32 time ) const;
+
+    /// The innermost wheel, one bucket per millisecond.
+    Callback* mInner[ INNER_SIZE ];
+    /// The outer wheels.
+    Callback* mOuter[ OUTER_COUNT ][ OUTER_SIZE ];
+    /// Callbacks being fired by Process().
+    Callback* mExpiring;
+
+    /// Number of scheduled callbacks.
+    size_t mCount;
+    /// Time of the last Process() call.
+    uint32 mNow;
+    /// The next time the buckets of which have not been processed yet.
+    uint32 mTime;
+
+    /// Statistics.
+    Stats mStats;
+};
+
+/// A macro for easier access to the singleton.
+#define sTimerWheel \
+    ( TimerWheel::get() )
+
+/**
+ * @brief Callback which calls a member function of its owner.
+ *
+ * Allows a single object to own several timers.
+ *
+ * @author EVEmu Team
+ */
+template< typename T, void ( T::*F )() >
+class TimerWheelMember
+: public TimerWheel::Callback
+{
+public:
+    /**
+     * @param[in] owner The object to call F on.
+     */
+    TimerWheelMember( T& owner ) : mOwner( owner ) {}
+
+protected:
+    void TimerExpired() { ( mOwner.*F )(); }
+
+    /// The object to call F on.
+    T& mOwner;
+};
+
+#endif /* !__UTILS__TIMER_WHEEL_H__INCL__ */
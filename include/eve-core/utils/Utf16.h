@@ -0,0 +1,68 @@
+/*
+    ------------------------------------------------------------------------------------
+    LICENSE:
+    ------------------------------------------------------------------------------------
+    This file is part of EVEmu: EVE Online Server Emulator
+    Copyright 2006 - 2011 The EVEmu Team
+    For the latest information visit http://evemu.org
+    ------------------------------------------------------------------------------------
+    This program is free software; you can redistribute it and/or modify it under
+    the terms of the GNU Lesser General Public License as published by the Free Software
+    Foundation; either version 2 of the License, or (at your option) any later
+    version.
+
+    This program is distributed in the hope that it will be useful, but WITHOUT
+    ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+    FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public License along with
+    this program; if not, write to the Free Software Foundation, Inc., 59 Temple
+    Place - Suite 330, Boston, MA 02111-1307, USA, or go to
+    http://www.gnu.org/copyleft/lesser.txt.
+    ------------------------------------------------------------------------------------
+    Author:     EVEmu Team
+*/
+
+
+#ifndef __UTILS__UTF16_H__INCL__
+#define __UTILS__UTF16_H__INCL__
+
+/*
+ * Conversions between UTF-16 and UTF-8.
+ *
+ * The output is sized up front and written in place; runs of ASCII
+ * are converted 8 or 16 units at a time with SSE2 or NEON, whichever
+ * the build targets (plain C++ otherwise). Unlike the utf8 library,
+ * invalid input never throws: unpaired surrogates and malformed UTF-8
+ * sequences become U+FFFD.
+ */
+
+/**
+ * @brief Converts a UTF-16 string to UTF-8.
+ *
+ * @param[in]  str  The UTF-16 string.
+ * @param[in]  len  Length of the string (in units).
+ * @param[out] into The string the UTF-8 form is appended to;
+ *                  it may be left with spare capacity.
+ */
+void Utf16ToUtf8( const uint16* str, size_t len, std::string& into );
+
+/**
+ * @brief Counts the code points of a UTF-8 string.
+ *
+ * @param[in] str The UTF-8 string.
+ * @param[in] len Size of the string (in bytes).
+ *
+ * @return Number of the code points.
+ */
+size_t Utf8Length( const char* str, size_t len );
+/**
+ * @brief Converts a UTF-8 string to UTF-16.
+ *
+ * @param[in]  str  The UTF-8 string.
+ * @param[in]  len  Size of the string (in bytes).
+ * @param[out] into The vector the UTF-16 form is appended to.
+ */
+void Utf8ToUtf16( const char* str, size_t len, std::vector< uint16 >& into );
+
+#endif /* !__UTILS__UTF16_H__INCL__ */
@@ -32,6 +32,9 @@ extern const uint32 CRC32_LOOKUP_TABLE[ 0x100 ];
 /**
  * @brief Wrapper class for generating CRC-32 checksums.
  *
+ * Uses the CRC-32 instructions of ARMv8 where the compiler targets
+ * them, slicing-by-8 (8 bytes per step) elsewhere.
+ *
  * @author Zhur
  */
 class CRC32
@@ -52,6 +52,24 @@ public:
     static const int32 GetCurrentTime();
     static const int32 GetTimeSeconds();
 
+    /**
+     * @brief Forgets the earliest deadline seen so far.
+     *
+     * Every timer that is started or checked while not yet expired
+     * records its deadline; the main loop may call this at the beginning
+     * of an iteration and query GetTimeToNextDeadline() at its end to
+     * learn how long it may sleep without delaying any timer.
+     *
+     * Only timers used by the thread calling this function are tracked.
+     */
+    static void ResetNextDeadline();
+    /**
+     * @return Time (in milliseconds, relative to GetCurrentTime()) until
+     *         the earliest recorded deadline; 0 if it already passed,
+     *         0xFFFFFFFF if there is none.
+     */
+    static uint32 GetTimeToNextDeadline();
+
 private:
     int32    start_time;
     int32    timer_time;
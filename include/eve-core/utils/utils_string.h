@@ -145,6 +145,14 @@ const char* itoa( int64 num );
  * @param[out] into     contains the string representatives of the numbers.
  */
 void ListToINString( const std::vector<int32>& ints, std::string& into, const char* if_empty = "" );
+/**
+ * @brief ListToINString() for unsigned numbers, such as IDs.
+ *
+ * @param[in]  ints     contains the numbers that need to converted.
+ * @param[in]  if_empty is the default value added if ints is empty.
+ * @param[out] into     contains the string representatives of the numbers.
+ */
+void ListToINString( const std::vector<uint32>& ints, std::string& into, const char* if_empty = "" );
 
 /**
  * @brief toupper() for strings.
@@ -65,7 +65,10 @@ detect clients moving into agro radius
 #include "ship/ModuleManager.h"
 
 class CryptoChallengePacket;
+struct AccountInfo;
+struct CallTrace;
 class EVENotificationStream;
+class EVESharedPayload;
 class PySubStream;
 class InventoryItem;
 class SystemManager;
@@ -92,37 +95,53 @@ public:
 
     bool            ProcessNet();
     virtual void    Process();
+    /**
+     * @brief Sends everything queued by QueueDestinyUpdate and QueueDestinyEvent.
+     *
+     * Called once per destiny tic, after all the systems have been
+     * processed, so the client gets a single bundle with a single stamp.
+     */
+    void            FlushDestinyUpdates();
+    /**
+     * @brief Sends the session change queued during this tic.
+     *
+     * All the session values changed since the last session change
+     * go out in a single notification, and the indexes of sEntityList
+     * are refreshed once. Called by sEntityList at the end of the tic;
+     * calls send it before their return instead.
+     */
+    void            FlushSessionChange() { _SendSessionChange(); }
 
     PyServiceMgr& services() const { return m_services; }
 
     /********************************************************************/
     /* Session values                                                   */
     /********************************************************************/
-    std::string GetAddress() const                  { return mSession.GetCurrentString( "address" ); }
-    std::string GetLanguageID() const               { return mSession.GetCurrentString( "languageID" ); }
-
-    uint32 GetAccountType() const                   { return mSession.GetCurrentInt( "userType" ); }
-    uint32 GetAccountID() const                     { return mSession.GetCurrentInt( "userid" ); }
-    uint64 GetAccountRole() const                   { return mSession.GetCurrentLong( "role" ); }
-
-    uint32 GetCharacterID() const                   { return mSession.GetCurrentInt( "charid" ); }
-    std::string GetCharacterName() const            { return mSession.GetCurrentString( "charname" ); }
-    uint32 GetCorporationID() const                 { return mSession.GetCurrentInt( "corpid" ); }
-    uint32 GetLocationID() const                    { return mSession.GetCurrentInt( "locationid" ); }
-    uint32 GetStationID() const                     { return mSession.GetCurrentInt( "stationid" ); }
-    uint32 GetSystemID() const                      { return mSession.GetCurrentInt( "solarsystemid2" ); }
-    uint32 GetConstellationID() const               { return mSession.GetCurrentInt( "constellationid" ); }
-    uint32 GetRegionID() const                      { return mSession.GetCurrentInt( "regionid" ); }
-
-    uint32 GetCorpHQ() const                        { return mSession.GetCurrentInt( "hqID" ); }
-    uint64 GetCorpRole() const                      { return mSession.GetCurrentLong( "corprole" ); }
-    uint64 GetRolesAtAll() const                    { return mSession.GetCurrentLong( "rolesAtAll" ); }
-    uint64 GetRolesAtBase() const                   { return mSession.GetCurrentLong( "rolesAtBase" ); }
-    uint64 GetRolesAtHQ() const                     { return mSession.GetCurrentLong( "rolesAtHQ" ); }
-    uint64 GetRolesAtOther() const                  { return mSession.GetCurrentLong( "rolesAtOther" ); }
+    std::string GetAddress() const                  { return mSession.GetCurrentString( SESSION_ADDRESS ); }
+    std::string GetLanguageID() const               { return mSession.GetCurrentString( SESSION_LANGUAGE_ID ); }
+
+    uint32 GetAccountType() const                   { return mSession.GetCurrentInt( SESSION_USER_TYPE ); }
+    uint32 GetAccountID() const                     { return mSession.GetCurrentInt( SESSION_USER_ID ); }
+    uint64 GetAccountRole() const                   { return mSession.GetCurrentLong( SESSION_ROLE ); }
+
+    uint32 GetCharacterID() const                   { return mSession.GetCurrentInt( SESSION_CHAR_ID ); }
+    std::string GetCharacterName() const            { return mSession.GetCurrentString( SESSION_CHAR_NAME ); }
+    uint32 GetCorporationID() const                 { return mSession.GetCurrentInt( SESSION_CORP_ID ); }
+    uint32 GetLocationID() const                    { return mSession.GetCurrentInt( SESSION_LOCATION_ID ); }
+    uint32 GetStationID() const                     { return mSession.GetCurrentInt( SESSION_STATION_ID ); }
+    uint32 GetSystemID() const                      { return mSession.GetCurrentInt( SESSION_SOLAR_SYSTEM_ID2 ); }
+    uint32 GetConstellationID() const               { return mSession.GetCurrentInt( SESSION_CONSTELLATION_ID ); }
+    uint32 GetRegionID() const                      { return mSession.GetCurrentInt( SESSION_REGION_ID ); }
+
+    uint32 GetCorpHQ() const                        { return mSession.GetCurrentInt( SESSION_HQ_ID ); }
+    uint64 GetCorpRole() const                      { return mSession.GetCurrentLong( SESSION_CORP_ROLE ); }
+    uint64 GetRolesAtAll() const                    { return mSession.GetCurrentLong( SESSION_ROLES_AT_ALL ); }
+    uint64 GetRolesAtBase() const                   { return mSession.GetCurrentLong( SESSION_ROLES_AT_BASE ); }
+    uint64 GetRolesAtHQ() const                     { return mSession.GetCurrentLong( SESSION_ROLES_AT_HQ ); }
+    uint64 GetRolesAtOther() const                  { return mSession.GetCurrentLong( SESSION_ROLES_AT_OTHER ); }
 
     uint32 GetShipID() const                        { return m_shipId; }
-    uint32 GetGangRole() const                      { return mSession.GetCurrentInt( "gangrole" ); }
+    uint32 GetGangRole() const                      { return mSession.GetCurrentInt( SESSION_GANG_ROLE ); }
 
     // character data
     CharacterRef GetChar() const                    { return m_char; }
@@ -141,7 +160,7 @@ public:
     double GetBalance() const                       { return GetChar() ? GetChar()->balance() : 0.0; }
     double GetAurBalance() const                    { return GetChar() ? GetChar()->aurBalance() : 0.0; }
 
-    bool AddBalance(double amount);
+    bool AddBalance(double amount, bool save = true);
 
     void BoardShip(ShipRef new_ship);
     void MoveToLocation(uint32 location, const GPoint &pt);
@@ -149,8 +168,12 @@ public:
     void MoveItem(uint32 itemID, uint32 location, EVEItemFlags flag);
     bool EnterSystem(bool login);
     bool UpdateLocation();
+    //the attach stage of a login, see LoginPipeline
     bool SelectCharacter( uint32 char_id );
+    //finishes the handshake once LoginAuthenticator verified the login
+    void CompleteLogin( bool success, const AccountInfo& account_info, const std::string& reason );
     void JoinCorporationUpdate(uint32 corp_id);
+    void UpdateFleetSession(uint32 fleetID, uint32 wingID, uint32 squadID, int32 role);
     void SavePosition();
     void SaveAllToDatabase();
     void UpdateSkillTraining();
@@ -161,10 +184,15 @@ public:
 
     void SendNotification(const PyAddress &dest, EVENotificationStream &noti, bool seq=true);
     void SendNotification(const char *notifyType, const char *idType, PyTuple **payload, bool seq=true);
+    //payload is encoded once and shared with other recipients
+    void SendNotification(const PyAddress &dest, const EVESharedPayload &payload, bool seq=true);
 
     //destiny stuff...
     void WarpTo(const GPoint &p, double distance);
     void StargateJump(uint32 fromGate, uint32 toGate);
+    //the arrival of a gate jump, see JumpPipeline; the session change is left to CompleteJump
+    bool ArriveThroughGate(uint32 solarSystemID, uint32 constellationID, uint32 regionID);
+    void CompleteJump();
     void SetDockStationID(uint32 stationID) { m_dockStationID = stationID; };
     uint32 GetDockStationID() { return m_dockStationID; };
     void SetDockingPoint(GPoint &dockPoint);
@@ -197,7 +225,7 @@ public:
     void SelfEveMail(const char *subject, const char *fmt, ...);
     void ChannelJoined(LSCChannel *chan);
     void ChannelLeft(LSCChannel *chan);
-    void UpdateSession( const char *sessionType, int value );
+    void UpdateSession( SessionSlot slot, int value );
     bool IsKennyTranslatorEnabled() { return bKennyfied; };
     void EnableKennyTranslator() { bKennyfied = true; };
     void DisableKennyTranslator() { bKennyfied = false; };
@@ -212,6 +240,7 @@ public:
     /********************************************************************/
     virtual EntityClass GetClass() const { return(ecClient); }
     virtual bool IsClient() const { return true; }
+    virtual bool IsTicked() const { return true; }
     virtual Client *CastToClient() { return(this); }
     virtual const Client *CastToClient() const { return(this); }
 
@@ -220,6 +249,137 @@ public:
     virtual void QueueDestinyUpdate(PyTuple** du);
     virtual void QueueDestinyEvent(PyTuple** multiEvent);
 
+    /**
+     * @brief Statistics of the destiny update budget and bundles, over all clients.
+     */
+    struct DestinyBudgetStats
+    {
+        DestinyBudgetStats() { Reset(); }
+
+        void Reset()
+        {
+            held = 0;
+            merged = 0;
+            dropped = 0;
+            resyncs = 0;
+            superseded = 0;
+            savedBytes = 0;
+            attributeChanges = 0;
+            attributesCoalesced = 0;
+        }
+
+        /// Number of updates held for the budget.
+        uint32 held;
+        /// Number of held updates superseded by a later one.
+        uint32 merged;
+        /// Number of held updates dropped for lack of budget.
+        uint32 dropped;
+        /// Number of SetState resyncs sent to make up for dropped updates.
+        uint32 resyncs;
+        /// Number of positions and velocities superseded within their bundle.
+        uint32 superseded;
+        /// Marshaled size (in bytes) of the superseded updates.
+        uint64 savedBytes;
+        /// Number of OnModuleAttributeChange events queued.
+        uint32 attributeChanges;
+        /// Number of those folded into an earlier change of the same attribute.
+        uint32 attributesCoalesced;
+    };
+
+    /**
+     * @brief Queues a destiny update bubblecast about a ball.
+     *
+     * Movement of other balls is held until the queued updates are
+     * sent. Then the updates of each ball are merged and the balls
+     * are admitted nearest first, as long as they fit into the per-tic
+     * budget (world.destinyUpdateBudget). The updates of the balls which
+     * did not fit are dropped in favour of a later SetState. Anything
+     * else, including movement of balls we target or which target us,
+     * is queued right away.
+     *
+     * @param[in,out] du    The update; consumed.
+     * @param[in]     about The ball the update is about; NULL if none.
+     * @param[in]     size  Marshaled size of the update (in bytes).
+     */
+    void QueueBubbleUpdate(PyTuple** du, const SystemEntity* about, size_t size);
+
+    /**
+     * @brief Queues an OnModuleAttributeChange event.
+     *
+     * Changes of the same attribute within one tic are coalesced: the
+     * event already queued keeps its old value and takes the new value
+     * and time of the later change, so the OnMultiEvent sent by
+     * FlushDestinyUpdates() only carries the final value.
+     *
+     * @param[in,out] change      The Notify_OnModuleAttributeChange tuple; consumed.
+     * @param[in]     itemID      The item the attribute belongs to.
+     * @param[in]     attributeID The attribute that changed.
+     */
+    void QueueAttributeChange(PyTuple** change, uint32 itemID, uint32 attributeID);
+
+    /** @return Statistics since the last ResetDestinyBudgetStats(). */
+    static const DestinyBudgetStats& destinyBudgetStats() { return s_destinyBudgetStats; }
+    static void ResetDestinyBudgetStats() { s_destinyBudgetStats.Reset(); }
+
+    /**
+     * @brief Memory a session holds on to.
+     *
+     * Bound objects and items are counted rather than sized;
+     * they are shared with the rest of the server.
+     */
+    struct MemoryUsage
+    {
+        /// Number of bytes waiting to be sent.
+        size_t sendQueueBytes;
+        /// Number of buffers waiting to be sent.
+        size_t sendQueueBuffers;
+        /// Marshaled size (in bytes) of the destiny updates held for the budget.
+        size_t heldDestinyBytes;
+        /// Number of objects the session has bound.
+        size_t boundObjects;
+        /// Number of items the session keeps loaded: the character, the ship and the warm ships.
+        size_t itemRefs;
+        /// Whether the session is idle, see net.idleSessionTimeout.
+        bool idle;
+        /// Time (in seconds) since the last call.
+        uint32 inactiveTime;
+    };
+
+    /**
+     * @brief Statistics of idle and evicted sessions, over all clients.
+     */
+    struct SessionStats
+    {
+        SessionStats() { Reset(); }
+
+        void Reset()
+        {
+            idled = 0;
+            woken = 0;
+            evicted = 0;
+            changes = 0;
+            coalesced = 0;
+        }
+
+        /// Number of sessions which went idle.
+        uint32 idled;
+        /// Number of idle sessions which called again.
+        uint32 woken;
+        /// Number of sessions disconnected after net.sessionTimeout of silence.
+        uint32 evicted;
+        /// Number of session changes sent.
+        uint32 changes;
+        /// Number of session updates merged into an already queued change.
+        uint32 coalesced;
+    };
+
+    /** @return Current memory usage of the session. */
+    MemoryUsage GetMemoryUsage();
+
+    /** @return Statistics since the last ResetSessionStats(). */
+    static const SessionStats& sessionStats() { return s_sessionStats; }
+    static void ResetSessionStats() { s_sessionStats.Reset(); }
+
     virtual void TargetAdded(SystemEntity *who);
     virtual void TargetLost(SystemEntity *who);
     virtual void TargetedAdd(SystemEntity *who);
@@ -236,22 +396,63 @@ public:
     /********************************************************************/
     void DisconnectClient();
     void BanClient();
+    /**
+     * @brief Starts recording the packets of the session into files.captureDir, for eve-tool's "replay".
+     *
+     * @return Name of the capture file; empty on failure.
+     */
+    std::string StartPacketCapture();
+    using EVEClientSession::StopCapture;
+    using EVEClientSession::IsCapturing;
+    using EVEClientSession::GetTraffic;
+
+    /********************************************************************/
+    /* Deferred calls, see PyDeferredCall                               */
+    /********************************************************************/
+    void SendDeferredReturn( const PyAddress& source, uint64 callID, PyRep* result );
+    void SendDeferredException( const PyAddress& source, uint64 callID, PyRep* except );
 
 protected:
     void _ReduceDamage(Damage &d);
+    virtual double _GetShieldCharge() const;
+    virtual void _SetShieldCharge(double charge);
     void _UpdateSession( const CharacterConstRef& character );
     void _UpdateSession2( uint32 characterID  );
 
     // Packet stuff
     void _SendCallReturn( const PyAddress& source, uint64 callID, PyRep** return_value, const char* channel = NULL );
     void _SendException( const PyAddress& source, uint64 callID, MACHONETMSG_TYPE in_response_to, MACHONETERR_TYPE exception_type, PyRep** payload );
+    /**
+     * @brief Takes the trace of the call being dispatched if the answer is for it.
+     *
+     * @param[in] callID ID of the call answered.
+     *
+     * @return The trace; NULL if the call is not traced.
+     */
+    CallTrace* _TakeTrace( uint64 callID );
+    /**
+     * @brief Queues a session change to be sent by the end of the tic.
+     */
+    void _QueueSessionChange();
     void _SendSessionChange();
     void _SendPingRequest();
     void _SendPingResponse( const PyAddress& source, uint64 callID );
+    void _PingTimerExpired();
+
+    /**
+     * @brief Releases the caches the session can do without; they are loaded again on next use.
+     */
+    void _GoIdle();
 
     PyServiceMgr& m_services;
-    Timer m_pingTimer;
+    TimerWheelMember<Client, &Client::_PingTimerExpired> m_pingTimer;
+    uint32 m_lastReceived;  //sTimerWheel time of the last packet, pings included
+    uint32 m_lastCalled;    //sTimerWheel time of the last packet other than a ping
+    bool m_idle;
     ClientSession mSession;
+    bool m_sessionChangeQueued;   //whether sEntityList flushes our session change by the end of the tic
+    CallTrace* m_trace;     //trace of the call being dispatched; NULL if not traced
+    uint64 m_traceCallID;   //ID of the traced call
 
     SystemManager *m_system;    //we do not own this
     CharacterRef m_char;
@@ -261,15 +462,11 @@ protected:
     //this whole move system is a piece of crap:
     typedef enum {
         msIdle,
-        msJump
+        msJump      //until the JumpPipeline moves us
     } _MoveState;
-    void _postMove(_MoveState type, uint32 wait_ms=500);
     _MoveState m_moveState;
-    Timer m_moveTimer;
-    uint32 m_moveSystemID;
     GPoint m_movePoint;
     uint32 m_dockStationID;
-    void _ExecuteJump();
     bool m_needToDock;
 
     uint32 m_shipId;
@@ -288,7 +485,18 @@ protected:
     GPoint m_undockAlignToPoint;
     // --- END HACK VARIABLES FOR UNDOCK ---
 
-    EvilNumber m_timeEndTrain;
+    void _SkillTrainingExpired();
+    TimerWheelMember<Client, &Client::_SkillTrainingExpired> m_skillTrainingTimer;
+
+    //ships we recently left, kept loaded (with their modules and contents) so boarding them again is instant
+    struct WarmShip {
+        ShipRef ship;
+        uint32 expires;     //sTimerWheel time
+    };
+    void _KeepShipWarm(ShipRef ship);
+    void _WarmShipsExpired();
+    std::vector<WarmShip> m_warmShips;  //oldest first
+    TimerWheelMember<Client, &Client::_WarmShipsExpired> m_warmShipTimer;
 
     /********************************************************************/
     /* EVEClientSession interface                                       */
@@ -305,6 +513,8 @@ protected:
     bool _VerifyLogin( CryptoChallengePacket& ccp );
     bool _VerifyVIPKey( const std::string& vipKey ) { /* do nothing */ return true; }
     bool _VerifyFuncResult( CryptoHandshakeResult& result );
+    /** @return True if the account is listed in net.captureAccounts. */
+    static bool _IsCaptured( const std::string& accountName );
 
     /********************************************************************/
     /* EVEPacketDispatcher interface                                    */
@@ -318,7 +528,25 @@ private:
     //queues for destiny updates:
     PyList* m_destinyEventQueue;    //we own these. These are events as used in OnMultiEvent
     PyList* m_destinyUpdateQueue;    //we own these. They are the `update` which go into DoDestinyAction
-    void _SendQueuedUpdates();
+    std::map<uint64, size_t> m_attributeChangeIndex;    //(itemID << 32 | attributeID) -> index into m_destinyEventQueue
+
+    //movement of other balls held for the budget, see QueueBubbleUpdate():
+    struct HeldDestinyUpdate {
+        PyTuple* update;    //we own this.
+        uint32 ballID;
+        double distance2;
+        size_t size;
+    };
+    std::vector<HeldDestinyUpdate> m_heldDestinyUpdates;
+    uint32 m_destinyBudgetStamp;    //destiny stamp the budget is left for.
+    size_t m_destinyBudgetLeft;    //in bytes.
+    bool m_destinyResyncPending;
+    uint32 m_destinyResyncStamp;    //destiny stamp of the last resync.
+    void _AdmitHeldUpdates();
+
+    static DestinyBudgetStats s_destinyBudgetStats;
+    static SessionStats s_sessionStats;
+    PyPacket *_MakeNotification(const PyAddress &dest, PyTuple *payload, bool seq);
 
     uint32 m_nextNotifySequence;
 
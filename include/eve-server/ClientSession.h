@@ -27,46 +27,121 @@
 #define __CLIENT_SESSION_H__INCL__
 
 /**
- * @brief Value keeper for single EVE session.
+ * @brief Slots of the values of a session, see ClientSession.
+ */
+enum SessionSlot
+{
+    SESSION_ADDRESS,
+    SESSION_LANGUAGE_ID,
+    SESSION_USER_TYPE,
+    SESSION_USER_ID,
+    SESSION_ROLE,
+
+    SESSION_CHAR_ID,
+    SESSION_CHAR_NAME,
+    SESSION_CORP_ID,
+    SESSION_HQ_ID,
+    SESSION_CORP_ROLE,
+    SESSION_ROLES_AT_ALL,
+    SESSION_ROLES_AT_BASE,
+    SESSION_ROLES_AT_HQ,
+    SESSION_ROLES_AT_OTHER,
+
+    SESSION_LOCATION_ID,
+    SESSION_STATION_ID,
+    SESSION_STATION_ID2,
+    SESSION_WORLDSPACE_ID,
+    SESSION_SOLAR_SYSTEM_ID,
+    SESSION_SOLAR_SYSTEM_ID2,
+    SESSION_CONSTELLATION_ID,
+    SESSION_REGION_ID,
+    SESSION_SHIP_ID,
+
+    SESSION_GANG_ROLE,
+    SESSION_FLEET_ID,
+    SESSION_WING_ID,
+    SESSION_SQUAD_ID,
+    SESSION_FLEET_ROLE,
+
+    SESSION_SLOT_COUNT
+};
+
+/**
+ * @brief Values of an EVE session.
+ *
+ * Every value has a fixed slot, so it is read and written in O(1)
+ * without looking up its name; the slots are those of SessionSlot. Every
+ * slot keeps the value last sent to the client and the current one,
+ * and changing a value marks its slot dirty.
  *
- * This object keeps track of string-value pairs
- * and encodes their changes as session changes.
+ * The names only matter on the wire: EncodeChanges() encodes the
+ * dirty slots whose value changed as a session change.
  */
 class ClientSession
 {
 public:
     ClientSession();
-    ~ClientSession();
 
-    bool isDirty() const { return mDirty; }
+    bool isDirty() const { return 0 != mDirty; }
 
     // PyInt
-    int32 GetLastInt( const char* name ) const;
-    int32 GetCurrentInt( const char* name ) const;
-    void SetInt( const char* name, int32 value );
+    int32 GetLastInt( SessionSlot slot ) const;
+    int32 GetCurrentInt( SessionSlot slot ) const;
+    void SetInt( SessionSlot slot, int32 value );
 
     // PyLong
-    int64 GetLastLong( const char* name ) const;
-    int64 GetCurrentLong( const char* name ) const;
-    void SetLong( const char* name, int64 value );
+    int64 GetLastLong( SessionSlot slot ) const;
+    int64 GetCurrentLong( SessionSlot slot ) const;
+    void SetLong( SessionSlot slot, int64 value );
 
     // PyString
-    std::string GetLastString( const char* name ) const;
-    std::string GetCurrentString( const char* name ) const;
-    void SetString( const char* name, const char* value );
+    std::string GetLastString( SessionSlot slot ) const;
+    std::string GetCurrentString( SessionSlot slot ) const;
+    void SetString( SessionSlot slot, const char* value );
 
-    void Clear( const char* name );
+    void Clear( SessionSlot slot );
     void EncodeChanges( PyDict* into );
 
 protected:
-    PyTuple* _GetValueTuple( const char* name ) const;
+    /**
+     * @brief A value of a slot; unset values are None on the wire.
+     */
+    struct Value
+    {
+        enum Kind
+        {
+            KIND_NONE,
+            KIND_INT,
+            KIND_LONG,
+            KIND_STRING
+        };
+
+        Value() : kind( KIND_NONE ), number( 0 ) {}
+
+        bool operator==( const Value& oth ) const;
+        bool operator!=( const Value& oth ) const { return !( *this == oth ); }
+
+        PyRep* Encode() const;
+
+        uint8 kind;
+        int64 number;
+        std::string text;
+    };
+
+    struct Slot
+    {
+        Value last;
+        Value current;
+    };
+
+    void _Set( SessionSlot slot, const Value& value );
 
-    PyRep* _GetLast( const char* name ) const;
-    PyRep* _GetCurrent( const char* name ) const;
-    void _Set( const char* name, PyRep* value );
+    /// Names of the slots on the wire.
+    static const char* const SLOT_NAMES[ SESSION_SLOT_COUNT ];
 
-    PyDict* const mSession;
-    bool mDirty;
+    Slot mSlots[ SESSION_SLOT_COUNT ];
+    /// Bit i is set if the slot i changed since the last EncodeChanges().
+    uint64 mDirty;
 };
 
 #endif /* !__CLIENT_SESSION_H__INCL__ */
@@ -61,6 +61,12 @@ public:
         uint32 autoAccountRole;
         /// A message shown to every client on login.
         std::string loginMessage;
+        /// Logins allowed per address per minute; set to 0 to disable the limit.
+        uint32 loginRate;
+        /// Logins an address may make at once before loginRate applies.
+        uint32 loginBurst;
+        /// The most logins waiting for verification; more are refused.
+        uint32 maxPendingLogins;
     } account;
 
     /// From <character/>
@@ -76,6 +82,10 @@ public:
         uint32 startCorporation;
         /// Delay for terminating a character in seconds
         uint32 terminationDelay;
+        /// Interval in seconds at which finished skills of offline characters are completed; 0 disables.
+        uint32 skillSweepInterval;
+        /// The most offline characters whose skills are completed in one sweep.
+        uint32 skillSweepBatch;
     } character;
 
     // From <database/>
@@ -91,6 +101,24 @@ public:
         std::string password;
         /// A database to be used by server.
         std::string db;
+        /// Maximal number of connections to the database.
+        uint32 poolSize;
+        /// Interval (in seconds) at which idle connections are health-checked; 0 disables the checks.
+        uint32 pingInterval;
+        /// Number of threads running asynchronous queries; 0 runs them on the main thread.
+        uint32 asyncThreads;
+        /// Interval (in milliseconds) at which queued item and attribute saves and market trades are written; 0 writes them right away.
+        uint32 writeBehindInterval;
+        /// Duration (in milliseconds) above which queries are logged with their call site; 0 disables the log.
+        uint32 slowQueryThreshold;
+        /// Whether to sample the queries for the index advisor (/dbstats explain).
+        bool indexAdvisor;
+        /// Read replicas for read-only queries, as comma-separated host[:port]; empty if none.
+        std::string replicas;
+        /// Greatest replication lag (in seconds) at which a replica is still read from.
+        uint32 maxReplicaLag;
+        /// Interval (in seconds) at which the replication lag of the replicas is checked.
+        uint32 lagCheckInterval;
     } database;
 
     // From <files/>
@@ -100,10 +128,22 @@ public:
         std::string logDir;
         /// A log configuration file.
         std::string logSettings;
+        /// Whether the log messages are written by a thread of their own.
+        bool asyncLog;
+        /// Number of log messages which may wait for the writer thread; more are dropped.
+        uint32 logQueueSize;
         /// A directory at which the cache files should be stored.
         std::string cacheDir;
         // used as the base directory for the image server
         std::string imageDir;
+        /// A static data snapshot written by eve-tool's "snapshot" command; empty to query the database instead.
+        std::string staticDataSnapshot;
+        /// The solar systems booted at shutdown, booted again at the next start; empty to disable.
+        std::string warmStart;
+        /// The journal of the market trades not written to the database yet; empty to keep them in memory only.
+        std::string marketJournal;
+        /// A directory in which the packet captures are stored.
+        std::string captureDir;
     } files;
 
     /// From <net/>
@@ -119,8 +159,92 @@ public:
         uint16 apiServerPort;
         /// the apiServer for API functions. should be the evemu server external ip/host
         std::string apiServer;
+        /// Limit (in bytes) of the memory used to cache API responses; 0 disables the cache.
+        uint32 apiCacheSize;
+        /// Number of threads doing the I/O of the API server connections.
+        uint32 apiIoThreads;
+        /// Number of threads building the API documents, so slow ones do not hold up the I/O.
+        uint32 apiWorkerThreads;
+        /// Time (in seconds) an API connection is kept open waiting for the next request.
+        uint32 apiKeepAliveTimeout;
+        /// Number of threads serving the image server connections.
+        uint32 imageIoThreads;
+        /// Limit (in bytes) of the memory used to cache images; 0 disables the cache.
+        uint32 imageCacheSize;
+        /// Number of I/O threads serving client connections.
+        uint32 ioThreads;
+        /// Number of threads marshaling outbound packets; 0 encodes them on the game thread.
+        uint32 encoderThreads;
+        /// The least size (in bytes) of outbound packet which gets deflated.
+        uint32 deflationLimit;
+        /// Compression level of outbound packets (0-9, -1 for the zlib default).
+        int32 deflationLevel;
+        /// Same as deflationLimit, for call responses.
+        uint32 callDeflationLimit;
+        /// Same as deflationLevel, for call responses.
+        int32 callDeflationLevel;
+        /// Same as deflationLimit, for notifications.
+        uint32 notifyDeflationLimit;
+        /// Same as deflationLevel, for notifications.
+        int32 notifyDeflationLevel;
+        /// Comma-separated names of the accounts whose sessions are captured from their login on.
+        std::string captureAccounts;
+        /// Limit (in bytes) of the data waiting to be sent to a client; slower clients are dropped. 0 disables the limit.
+        uint32 sendQueueLimit;
+        /// Time (in seconds) after which a client which sent nothing, not even a ping response, is disconnected; 0 never.
+        uint32 sessionTimeout;
+        /// Time (in seconds) after which a client which made no call goes idle and its caches are released; 0 never.
+        uint32 idleSessionTimeout;
     } net;
 
+    /// From <loop/>
+    struct
+    {
+        /// Block the main loop until there is work to do instead of polling it every 10 ms.
+        bool eventDriven;
+        /// Maximal time (in milliseconds) the main loop may stay idle in event-driven mode.
+        uint32 maxIdleTime;
+        /// Interval (in seconds) at which main loop timing stats are logged; 0 disables them.
+        uint32 statsInterval;
+        /// Whether to record per-method service call counters and latencies (see /callstats).
+        bool callStats;
+        /// Whether to record the zones of every tick (see /tickprofile).
+        bool tickProfiler;
+        /// Duration (in milliseconds) above which a tick is logged with its zones; 0 disables it.
+        uint32 slowTickThreshold;
+        /// Number of the slowest ticks kept for /tickprofile.
+        uint32 slowTickHistory;
+        /// Every n-th allocation of the tagged subsystems records its call stack (see /memstats); 0 disables it.
+        uint32 memorySampleRate;
+        /// Every n-th client call is traced through all its stages (see /calltrace); 0 disables it.
+        uint32 callTraceRate;
+        /// Number of the latest call traces kept for /calltrace.
+        uint32 callTraceHistory;
+        /// Whether to log every call trace with its per-stage breakdown.
+        bool callTraceLog;
+    } loop;
+
+    /// From <world/>
+    struct
+    {
+        /// Most states of solar systems preloaded ahead of their boot; 0 disables preloading.
+        uint32 systemPreloadLimit;
+        /// Number of loaded items above which the unreferenced ones are dropped; 0 keeps all of them.
+        uint32 itemCacheSize;
+        /// Number of computed fittings kept for the fitting window, saved fittings and NPC loadouts; 0 keeps none.
+        uint32 fittingCacheSize;
+        /// Bytes of destiny updates about other balls a client gets per tic; 0 is unlimited.
+        uint32 destinyUpdateBudget;
+        /// Least number of tics between the state resyncs of a client whose updates were dropped.
+        uint32 destinyResyncInterval;
+        /// Seconds a ship left by its pilot stays loaded, so boarding it again is instant; 0 disables.
+        uint32 shipGracePeriod;
+        /// Seconds between the snapshots of the ore of the asteroids; 0 writes every mined tic right away.
+        uint32 asteroidSnapshotInterval;
+        /// Number of sol nodes the regions are spread over; 1 keeps every solar system on the server's node.
+        uint32 solNodes;
+    } world;
+
 protected:
     bool ProcessEveServer( const TiXmlElement* ele );
     bool ProcessRates( const TiXmlElement* ele );
@@ -129,6 +253,8 @@ protected:
     bool ProcessDatabase( const TiXmlElement* ele );
     bool ProcessFiles( const TiXmlElement* ele );
     bool ProcessNet( const TiXmlElement* ele );
+    bool ProcessLoop( const TiXmlElement* ele );
+    bool ProcessWorld( const TiXmlElement* ele );
 };
 
 /// A macro for easier access to the singleton.
@@ -30,6 +30,7 @@
 #ifndef EVE_ENTITY_LIST_H
 #define EVE_ENTITY_LIST_H
 
+#include "system/SystemPreloader.h"
 #include "threading/Mutex.h"
 #include "utils/Singleton.h"
 
@@ -58,6 +59,49 @@ class EntityList
 : public Singleton<EntityList>
 {
 public:
+    /**
+     * @brief Tick timing of the booted systems, summed up.
+     */
+    struct SystemTickStats
+    {
+        SystemTickStats() { Reset(); }
+
+        void Reset()
+        {
+            systems = 0;
+            ticks = 0;
+            tickTime = 0;
+            maxTickTime = 0;
+            destinyTime = 0;
+            maxDestinyTime = 0;
+            aiThinks = 0;
+            aiTime = 0;
+            busiestSystemID = 0;
+            busiestTime = 0;
+        }
+
+        /// Number of booted systems.
+        size_t systems;
+        /// Number of system ticks.
+        uint32 ticks;
+        /// Total time (in microseconds) spent in system ticks.
+        uint64 tickTime;
+        /// Longest tick of any system (in microseconds).
+        uint32 maxTickTime;
+        /// Total time (in microseconds) spent in destiny ticks.
+        uint64 destinyTime;
+        /// Longest destiny tick of any system (in microseconds).
+        uint32 maxDestinyTime;
+        /// Number of times an NPC's AI thought.
+        uint32 aiThinks;
+        /// Total time (in microseconds) the AI spent thinking.
+        uint64 aiTime;
+        /// The system which took the most time; 0 if none.
+        uint32 busiestSystemID;
+        /// Time (in microseconds) taken by the busiest system.
+        uint64 busiestTime;
+    };
+
     EntityList();
     virtual ~EntityList();
 
@@ -69,15 +113,76 @@ public:
 
     void Process();
 
+    /**
+     * @brief Refreshes lookup indexes of the client.
+     *
+     * Must be called whenever any of the session values the
+     * lookups below are keyed by (character, account,
+     * corporation, location) changes.
+     *
+     * @param[in] client The client to reindex.
+     */
+    void UpdateIndexes(Client *client);
+    /**
+     * @brief Has the session change of the client sent at the end of the tic.
+     *
+     * The client sends one coalesced session change then, unless
+     * it sends it earlier (before a call return). See
+     * Client::FlushSessionChange(). Its indexes are updated
+     * by the client right away.
+     *
+     * @param[in] client The client whose session changed.
+     */
+    void QueueSessionChange(Client *client) { m_sessionChanges.push_back(client); }
+    /**
+     * @brief Forgets the queued session change of a client going away.
+     *
+     * @param[in] client The client being destroyed.
+     */
+    void DropSessionChange(Client *client) {
+        m_sessionChanges.erase(std::remove(m_sessionChanges.begin(), m_sessionChanges.end(), client), m_sessionChanges.end());
+    }
+
     Client *FindCharacter(uint32 char_id) const;
     Client *FindCharacter(const char *name) const;
     Client *FindByShip(uint32 ship_id) const;
     Client *FindAccount(uint32 account_id) const;
-        void FindByStationID(uint32 stationID, std::vector<Client *> &result) const;
-        void FindByRegionID(uint32 regionID, std::vector<Client *> &result) const;
+    void FindByStationID(uint32 stationID, std::vector<Client *> &result) const;
+    void FindBySolarSystemID(uint32 solarSystemID, std::vector<Client *> &result) const;
+    void FindByRegionID(uint32 regionID, std::vector<Client *> &result) const;
+    void FindByCorporationID(uint32 corporationID, std::vector<Client *> &result) const;
     uint32 GetClientCount() const { return(uint32(m_clients.size())); }
 
+    /**
+     * @brief Finds a booted system, booting it if needed.
+     *
+     * Systems are booted out of the state prepared by the preloader
+     * if there is one; the systems the stargates of a newly booted
+     * one lead to are preloaded then, as they are likely to be
+     * entered next.
+     */
     SystemManager *FindOrBootSystem(uint32 systemID);
+    /** @return True if the system is booted. */
+    bool IsSystemBooted(uint32 systemID) const { return m_systems.find(systemID) != m_systems.end(); }
+
+    SystemPreloader &systemPreloader() { return m_preloader; }
+
+    /**
+     * @brief Sums up the tick timing of the booted systems.
+     *
+     * @param[out] into Where to store the sums.
+     */
+    void GetSystemTickStats(SystemTickStats &into) const;
+    /**
+     * @brief Collects the time every booted system took since the last reset.
+     *
+     * @param[out] into Tick and destiny time (in microseconds), by systemID.
+     */
+    void GetSystemTimes(std::map<uint32, uint64> &into) const;
+    /**
+     * @brief Resets the tick timing of all booted systems.
+     */
+    void ResetSystemTickStats();
 
     void Broadcast(const char *notifyType, const char *idType, PyTuple **payload) const;
     void Broadcast(const PyAddress &dest, EVENotificationStream &noti) const;
@@ -85,8 +190,21 @@ public:
     void Multicast(const char *notifyType, const char *idType, PyTuple **payload, const MulticastTarget &mcset, bool seq=true);
     void Multicast(const character_set &cset, const PyAddress &dest, EVENotificationStream &noti) const;
     void Multicast(const character_set &cset, const char *notifyType, const char *idType, PyTuple **payload, bool seq=true) const;
+    /**
+     * @brief Sends a notification to given clients, marshaling it once.
+     *
+     * For callers which keep their recipients at hand, so no
+     * characterID has to be looked up per notification.
+     */
+    void Multicast(const std::vector<Client *> &clients, const char *notifyType, const char *idType, PyTuple **payload, bool seq=true) const;
     void Unicast(uint32 charID, const char *notifyType, const char *idType, PyTuple **payload, bool seq=true);
     void GetClients(const character_set &cset, std::vector<Client *> &result) const;
+    /**
+     * @brief Lists all connected clients.
+     *
+     * @param[out] result Where to store the clients.
+     */
+    void GetClients(std::vector<Client *> &result) const;
 
 protected:
     typedef std::list<Client *> client_list;
@@ -94,9 +212,51 @@ protected:
     typedef std::map<uint32, SystemManager *> system_list;
     system_list m_systems;
 
+    //secondary indexes of m_clients, keyed by session values.
+    typedef std::tr1::unordered_set<Client *> client_set;
+    typedef std::tr1::unordered_map<uint32, client_set> client_index;
+    typedef std::tr1::unordered_map<std::string, client_set> client_name_index;
+    client_index m_byCharacter;
+    client_name_index m_byName;
+    client_index m_byAccount;
+    client_index m_byCorporation;
+    client_index m_byLocation;
+    client_index m_byStation;
+    client_index m_bySolarSystem;
+    client_index m_byRegion;
+
+    //the keys each client is currently indexed under.
+    struct index_keys {
+        index_keys();
+
+        uint32 characterID;
+        std::string name;
+        uint32 accountID;
+        uint32 corporationID;
+        uint32 locationID;
+        uint32 stationID;
+        uint32 solarSystemID;
+        uint32 regionID;
+    };
+    typedef std::tr1::unordered_map<Client *, index_keys> client_keys;
+    client_keys m_indexKeys;
+
+    //clients with a queued session change; may hold a client more than once.
+    std::vector<Client *> m_sessionChanges;
+
+    void _RemoveIndexes(Client *client);
+    void _FlushSessionChanges();
+    void _PreloadNeighbours(const SystemManager &system);
+
+    template<typename K>
+    static void _Reindex(std::tr1::unordered_map<K, client_set> &index, Client *client, K &key, const K &new_key);
+    template<typename K>
+    static void _Collect(const std::tr1::unordered_map<K, client_set> &index, const K &key, std::vector<Client *> &result);
+
     Mutex mMutex;
 
     PyServiceMgr *m_services;    //we do not own this, only used for booting systems.
+    SystemPreloader m_preloader;
 };
 
 //Singleton
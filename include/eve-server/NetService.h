@@ -34,10 +34,20 @@ public:
     NetService(PyServiceMgr *mgr);
     virtual ~NetService();
 
+    virtual void PrimeCache();
+
 protected:
     class Dispatcher;
     Dispatcher *const m_dispatch;
 
+    /// The reply of GetInitVals, frozen and shared by all logins.
+    PyTuple *m_initVals;
+    /// Generation of the cache m_initVals was built for (see ObjCacheService::GetGeneration()).
+    uint32 m_initValsGeneration;
+
+    void _BuildInitVals();
+    static PyDict *_BuildServiceInfo();
+
     PyCallable_DECL_CALL(GetInitVals)
     PyCallable_DECL_CALL(GetTime)
 };
@@ -34,6 +34,13 @@ public:
     PyBoundObject(PyServiceMgr *mgr);
     virtual ~PyBoundObject();
 
+    /**
+     * @brief Accounts the bound objects to the "bound objects" MemoryTag.
+     */
+    static void* operator new( size_t size ) { return sMemoryTag.Allocate( size ); }
+    static void operator delete( void* p, size_t size ) { sMemoryTag.Free( p, size ); }
+    static MemoryTag sMemoryTag;
+
     virtual void Release() = 0;
 
     uint32 nodeID() const { return(m_nodeID); }
@@ -47,7 +54,7 @@ public:
     virtual PyResult Call(const std::string &method, PyCallArgs &args);
 
 protected:
-    friend class PyServiceMgr;    //for access to _SetNodeBindID only.
+    friend class PyServiceMgr;    //for access to _SetNodeBindID and the binding list only.
     void _SetNodeBindID(uint32 nodeID, uint32 bindID) { m_nodeID = nodeID; m_bindID = bindID; }
 
     PyServiceMgr *const m_manager;
@@ -56,6 +63,11 @@ protected:
 private:
     uint32 m_nodeID;
     uint32 m_bindID;
+
+    //the client we are bound to and its other bindings, maintained by PyServiceMgr
+    Client *m_boundClient;
+    PyBoundObject *m_prevBinding;
+    PyBoundObject *m_nextBinding;
 };
 
 #endif
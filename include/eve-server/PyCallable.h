@@ -46,9 +46,77 @@ public:
 
     void Dump( LogType type ) const;
 
+    /**
+     * @brief Marks the call as answered later through PyDeferredCall.
+     *
+     * @param[in] source Address the call was made to.
+     * @param[in] callID ID of the call.
+     */
+    void SetDeferrable( const PyAddress& source, uint64 callID );
+
+    /** @return True if the call may be answered later. */
+    bool IsDeferrable() const { return deferrable; }
+    /** @return True if PyDeferredCall took over the call. */
+    bool IsDeferred() const { return deferred; }
+
     Client* const client;    //we do not own this
     PyTuple* tuple;        //we own this, but it may be taken
     std::map<std::string, PyRep*> byname;    //we own this, but elements may be taken.
+
+protected:
+    friend class PyDeferredCall;
+
+    /// Whether the call may be deferred; false for sub-calls.
+    bool deferrable;
+    /// Whether the call has been deferred.
+    bool deferred;
+    /// Where the call went and its ID; valid only if deferrable.
+    PyAddress source;
+    uint64 callID;
+};
+
+/**
+ * @brief Answer to a call which is sent later.
+ *
+ * Takes over a deferrable call so that the handler may return
+ * without an answer (its return value is thrown away) and answer
+ * once it has the result, typically from a DBAsyncQuery completion.
+ * If the client disconnects in the meantime, the answer is dropped.
+ *
+ * @author EVEmu Team
+ */
+class PyDeferredCall
+{
+public:
+    /**
+     * @param[in] call The call; must be deferrable.
+     */
+    PyDeferredCall( PyCallArgs& call );
+
+    /**
+     * @brief Sends the result of the call.
+     *
+     * @param[in] result The result; ownership is taken.
+     */
+    void Return( PyRep* result );
+    /**
+     * @brief Sends an exception as the answer.
+     *
+     * @param[in] except The exception; ownership is taken.
+     */
+    void Throw( PyRep* except );
+
+protected:
+    /** @return The client if still connected, NULL otherwise. */
+    Client* _GetClient() const;
+
+    /// The client which made the call; may be gone.
+    Client* const mClient;
+    /// Account of the client, to find out whether it is still there.
+    const uint32 mAccountID;
+    /// Where the call went and its ID.
+    const PyAddress mSource;
+    const uint64 mCallID;
 };
 
 class PyResult
@@ -82,12 +150,50 @@ public:
 class PyCallable
 {
 public:
+    /**
+     * @brief Statistics of calls to a single method.
+     */
+    struct CallStats
+    {
+        /// Number of latency histogram buckets; bucket i holds calls shorter than 10^(i+1) us.
+        static const size_t HISTOGRAM_SIZE = 7;
+
+        CallStats();
+
+        /** @return True if call statistics should be recorded. */
+        static bool IsEnabled();
+
+        /**
+         * @brief Records a call.
+         *
+         * @param[in] time      Duration of the call in microseconds.
+         * @param[in] exception Whether the call threw.
+         */
+        void Record( uint64 time, bool exception );
+        /**
+         * @brief Adds up another stats.
+         */
+        void Merge( const CallStats& oth );
+
+        uint64 calls;
+        uint64 exceptions;
+        /// Total and longest duration of the calls in microseconds.
+        uint64 totalTime;
+        uint64 maxTime;
+        uint64 histogram[ HISTOGRAM_SIZE ];
+    };
+    typedef std::map<std::string, CallStats> CallStatsMap;
+
     class CallDispatcher
     {
     public:
         virtual ~CallDispatcher() {}
 
         virtual PyResult Dispatch( const std::string& method_name, PyCallArgs& call ) = 0;
+
+        /// Adds up stats of the calls, keyed by method name.
+        virtual void GetCallStats( CallStatsMap& into ) const {}
+        virtual void ResetCallStats() {}
     };
 
     PyCallable();
@@ -96,6 +202,10 @@ public:
     //returns ownership:
     virtual PyResult Call( const std::string& method, PyCallArgs& args );
 
+    //call statistics, recorded if enabled in config:
+    void GetCallStats( CallStatsMap& into ) const;
+    void ResetCallStats();
+
 protected:
     void _SetCallDispatcher( CallDispatcher* d ) { m_serviceDispatch = d; }
 
@@ -52,6 +52,14 @@ public:
     virtual PyResult Call(const std::string &method, PyCallArgs &args);
 
     const char *GetName() const { return(m_name.c_str()); }
+
+    /**
+     * @brief Builds the cached results of the calls clients make at login.
+     *
+     * Called once at startup, after all the services are registered,
+     * so the login burst is served from ObjCacheService without queries.
+     */
+    virtual void PrimeCache() {}
     EntityList &entityList() const { return(m_manager->entity_list); }
 
 protected:
@@ -38,35 +38,78 @@ class PyCallableDispatcher
     : public PyCallable::CallDispatcher
 {
     typedef PyResult (Svc::*CallProc)(PyCallArgs &call);
-    typedef typename std::map<std::string, CallProc>::iterator mapitr;
 public:
     PyCallableDispatcher(Svc *parent)
-    : m_parent(parent) {
+    : m_callTableDirty(false),
+      m_parent(parent) {
     }
 
     virtual ~PyCallableDispatcher() {
     }
 
     void RegisterCall(const char *call_name, CallProc p) {
-        m_serviceCalls[call_name] = p;
+        //registration happens at construction only, so a linear search is fine here
+        std::vector<std::string>::iterator res = std::find(m_callNames.begin(), m_callNames.end(), call_name);
+        if(res != m_callNames.end()) {
+            m_callProcs[res - m_callNames.begin()] = p;
+            return;
+        }
+
+        m_callNames.push_back(call_name);
+        m_callProcs.push_back(p);
+        m_callStats.push_back(PyCallable::CallStats());
+        m_callTableDirty = true;
     }
 
     //CallDispatcher interface:
     virtual PyResult Dispatch(const std::string &method_name, PyCallArgs &call) {
-        //this could be done a lot more efficiently with a custom data structure IF NEEDED
-        mapitr res;
-        res = m_serviceCalls.find(method_name);
-        if(res == m_serviceCalls.end()) {
+        //build the lookup table once all the calls are registered
+        if(m_callTableDirty) {
+            if(!m_callTable.Build(m_callNames))
+                sLog.Error("Server", "Failed to build call table of %lu calls.", m_callNames.size());
+            m_callTableDirty = false;
+        }
+
+        const uint32 index = m_callTable.Find(method_name);
+        if(index == PerfectHash::INVALID_INDEX) {
             sLog.Error("Server","Unknown call to '%s' by '%s'", method_name.c_str(), call.client->GetName());
             return NULL;
         }
 
-        CallProc p = res->second;
-        return (m_parent->*p)(call);
+        CallProc p = m_callProcs[index];
+        if(!PyCallable::CallStats::IsEnabled())
+            return (m_parent->*p)(call);
+
+        const uint64 start = GetTimeUSeconds();
+        try {
+            PyResult res = (m_parent->*p)(call);
+            m_callStats[index].Record(GetTimeUSeconds() - start, false);
+            return res;
+        } catch(PyException &) {
+            m_callStats[index].Record(GetTimeUSeconds() - start, true);
+            throw;
+        }
+    }
+
+    virtual void GetCallStats(PyCallable::CallStatsMap &into) const {
+        for(size_t i = 0; i < m_callNames.size(); i++) {
+            if(0 < m_callStats[i].calls)
+                into[m_callNames[i]].Merge(m_callStats[i]);
+        }
+    }
+
+    virtual void ResetCallStats() {
+        std::fill(m_callStats.begin(), m_callStats.end(), PyCallable::CallStats());
     }
 
 protected:   //_MAY_ consume args
-    std::map<std::string, CallProc> m_serviceCalls;
+    //parallel vectors, indexed by m_callTable
+    std::vector<std::string> m_callNames;
+    std::vector<CallProc> m_callProcs;
+    std::vector<PyCallable::CallStats> m_callStats;
+
+    PerfectHash m_callTable;
+    bool m_callTableDirty;
 
     Svc *const m_parent;    //we do not own this pointer
 };
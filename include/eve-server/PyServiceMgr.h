@@ -27,6 +27,8 @@
 #ifndef __PYSERVICEMGR_H_INCL__
 #define __PYSERVICEMGR_H_INCL__
 
+#include "PyBoundObject.h"
+#include "PyCallable.h"
 #include "inventory/ItemFactory.h"
 
 class PyService;
@@ -54,14 +56,23 @@ public:
 
     void RegisterService( PyService* d );
     PyService* LookupService( const std::string& name );
+    //builds the cached objects and call results of all services, see PyService::PrimeCache()
+    void PrimeCaches();
+
+    //call statistics of all services, keyed by "service::method"
+    void GetCallStats( std::map<std::string, PyCallable::CallStats>& into ) const;
+    void ResetCallStats();
 
     uint32 GetNodeID() const { return(m_nodeID); }
 
     //object binding, not fully understood yet.
-    PySubStruct *BindObject(Client *who, PyBoundObject *obj, PyDict **dict = NULL);
+    //nodeID is the sol node the object is bound at; 0 binds it at our own node.
+    PySubStruct *BindObject(Client *who, PyBoundObject *obj, PyDict **dict = NULL, uint32 nodeID = 0);
     PyBoundObject *FindBoundObject(uint32 bindID);
     void ClearBoundObject(uint32 bindID);
     void ClearBoundObjects(Client *who);
+    //number of objects bound by the client.
+    size_t GetBoundObjectCount(Client *who) const;
 
     //this is a hack and needs to die:
     ServiceDB &serviceDB() { return(m_svcDB); }
@@ -76,21 +87,27 @@ public:
     ObjCacheService *cache_service;
 
 protected:
-    std::set<PyService *> m_services;    //we own these pointers.
+    typedef std::tr1::unordered_map<std::string, PyService *> ServiceMap;
+    ServiceMap m_services;    //we own these pointers.
 
     uint32 m_nextBindID;
     uint32 _GetBindID() { return(m_nextBindID++); }
 
-    struct BoundObject
-    {
-        Client *client;    //we do not own this.
-        PyBoundObject *destination;    //we own this. PyServiceMgr deletes it
-    };
+    //links a bound object into the binding list of its client, or out of it
+    void _LinkBinding(PyBoundObject *obj, Client *who);
+    void _UnlinkBinding(PyBoundObject *obj);
 
-    typedef std::map<uint32, BoundObject>   ObjectsBoundMap;
-    typedef ObjectsBoundMap::iterator       ObjectsBoundMapItr;
+    //we own the objects. PyServiceMgr deletes them; the nodes of both maps are accounted along with the objects
+    typedef std::tr1::unordered_map<uint32, PyBoundObject *, std::tr1::hash<uint32>, std::equal_to<uint32>,
+        MemoryTagAllocator<std::pair<const uint32, PyBoundObject *>, PyBoundObject::sMemoryTag> > ObjectsBoundMap;
+    typedef ObjectsBoundMap::iterator                           ObjectsBoundMapItr;
     ObjectsBoundMap m_boundObjects;
 
+    //the newest binding of every client; the rest follow through the objects, so a client's teardown only walks its own.
+    typedef std::tr1::unordered_map<Client *, PyBoundObject *, std::tr1::hash<Client *>, std::equal_to<Client *>,
+        MemoryTagAllocator<std::pair<Client *const, PyBoundObject *>, PyBoundObject::sMemoryTag> > ClientBindingMap;
+    ClientBindingMap m_clientBindings;
+
     uint32 m_nodeID;
     ServiceDB m_svcDB;    //this is crap, get rid of this
 };
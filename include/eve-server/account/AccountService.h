@@ -30,12 +30,16 @@
 #include "account/AccountDB.h"
 #include "PyService.h"
 
+class ObjectCachedMethodID;
+
 class AccountService
 : public PyService {
 public:
     AccountService(PyServiceMgr *mgr);
     virtual ~AccountService();
 
+    virtual void PrimeCache();
+
 protected:
     class Dispatcher;
     Dispatcher *const m_dispatch;
@@ -49,6 +53,9 @@ protected:
     PyCallable_DECL_CALL(GiveCashFromCorpAccount)
     PyCallable_DECL_CALL(GetJournal)
 
+    void _CacheEntryTypes(const ObjectCachedMethodID &method_id);
+    void _CacheKeyMap(const ObjectCachedMethodID &method_id);
+
     PyTuple * GiveCashToChar(Client * const client, Client * const other, double amount, const char *reason, JournalRefType refTypeID);
     PyTuple * GiveCashToCorp(Client * const client, uint32 corpID, double amount, const char *reason, JournalRefType refTypeID);
     PyTuple * WithdrawCashToChar(Client * const client, Client * const other, double amount, const char *reason, JournalRefType refTypeID);
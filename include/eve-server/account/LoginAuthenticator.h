@@ -0,0 +1,168 @@
+/*
+    ------------------------------------------------------------------------------------
+    LICENSE:
+    ------------------------------------------------------------------------------------
+    This file is part of EVEmu: EVE Online Server Emulator
+    Copyright 2006 - 2011 The EVEmu Team
+    For the latest information visit http://evemu.org
+    ------------------------------------------------------------------------------------
+    This program is free software; you can redistribute it and/or modify it under
+    the terms of the GNU Lesser General Public License as published by the Free Software
+    Foundation; either version 2 of the License, or (at your option) any later
+    version.
+
+    This program is distributed in the hope that it will be useful, but WITHOUT
+    ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+    FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public License along with
+    this program; if not, write to the Free Software Foundation, Inc., 59 Temple
+    Place - Suite 330, Boston, MA 02111-1307, USA, or go to
+    http://www.gnu.org/copyleft/lesser.txt.
+    ------------------------------------------------------------------------------------
+    Author:     EVEmu Team
+*/
+
+
+#ifndef __ACCOUNT__LOGIN_AUTHENTICATOR_H__INCL__
+#define __ACCOUNT__LOGIN_AUTHENTICATOR_H__INCL__
+
+#include "utils/Singleton.h"
+
+class Client;
+
+/**
+ * @brief Verifies the logins of the clients off the game thread.
+ *
+ * The lookup of the account, the hashing of a stored plain password
+ * and the update of the account are run by sDBAsync's worker threads;
+ * meanwhile the handshake of the client stays parked (see
+ * EVEClientSession::_ParkAuthentication()), and the game thread only
+ * finishes the handshake once the result is back.
+ *
+ * Logins are limited per address by a token bucket of the
+ * configured rate and burst; logins over it, or over the configured
+ * number of pending logins, are refused right away.
+ *
+ * Not thread-safe; meant to be used from the main loop.
+ *
+ * @author EVEmu Team
+ */
+class LoginAuthenticator
+: public Singleton< LoginAuthenticator >
+{
+public:
+    /**
+     * @brief Statistics of the logins; times are in milliseconds.
+     */
+    struct Stats
+    {
+        Stats() { Reset(); }
+
+        void Reset()
+        {
+            submitted = 0;
+            accepted = 0;
+            rejected = 0;
+            throttled = 0;
+            overflowed = 0;
+            cancelled = 0;
+            authTime = 0;
+            maxAuthTime = 0;
+        }
+
+        /// Number of logins submitted to the workers.
+        uint32 submitted;
+        /// Number of logins which passed.
+        uint32 accepted;
+        /// Number of logins which failed the verification.
+        uint32 rejected;
+        /// Number of logins refused by the rate of their address.
+        uint32 throttled;
+        /// Number of logins refused as too many were pending.
+        uint32 overflowed;
+        /// Number of logins dropped as their client left.
+        uint32 cancelled;
+        /// Time from the submission until the result was back.
+        uint32 authTime;
+        uint32 maxAuthTime;
+    };
+
+    LoginAuthenticator();
+
+    /** @return Number of logins pending. */
+    size_t size() const { return mLogins.size(); }
+    /** @return Statistics since the last ResetStats(). */
+    const Stats& stats() const { return mStats; }
+    /** @brief Resets the statistics. */
+    void ResetStats() { mStats.Reset(); }
+
+    /**
+     * @brief Submits the login of a client.
+     *
+     * @param[in] client       The client, which must park its handshake on success.
+     * @param[in] address      Remote IP of the client.
+     * @param[in] userName     The account name sent by the client.
+     * @param[in] passwordHash The password hash sent by the client.
+     *
+     * @return True if submitted, false if the login is refused.
+     */
+    bool Submit( Client* client, uint32 address, const std::string& userName, const std::string& passwordHash );
+    /**
+     * @brief Drops the login of a client which is going away.
+     */
+    void Cancel( Client* client );
+
+protected:
+    class AuthQuery;
+
+    /**
+     * @brief Logins an address may still make.
+     */
+    struct Bucket
+    {
+        double tokens;
+        /// Time (in microseconds) the tokens were last refilled.
+        uint64 refilled;
+    };
+
+    /**
+     * @brief A login in flight.
+     */
+    struct Login
+    {
+        Client* client;
+        /// Time (in microseconds) of the submission.
+        uint64 submitted;
+    };
+
+    void _Complete( AuthQuery& query, bool success );
+
+    /**
+     * @brief Takes a token of an address.
+     *
+     * @return False if the address has none left.
+     */
+    bool _Take( uint32 address );
+    /** @brief Forgets the buckets which have filled up again. */
+    void _PruneBuckets( uint64 now );
+
+    /// The logins, by ticket.
+    std::map< uint32, Login > mLogins;
+    /// Ticket of the next login.
+    uint32 mNextTicket;
+
+    /// The buckets, by address.
+    std::tr1::unordered_map< uint32, Bucket > mBuckets;
+    /// Time (in microseconds) of the last pruning of the buckets.
+    uint64 mLastPrune;
+
+    /// Statistics.
+    Stats mStats;
+};
+
+/// A macro for easier access to the singleton.
+#define sLoginAuthenticator \
+    ( LoginAuthenticator::get() )
+
+#endif /* !__ACCOUNT__LOGIN_AUTHENTICATOR_H__INCL__ */
@@ -34,10 +34,15 @@ class PyRep;
 class TutorialDB : public ServiceDB
 {
 public:
-    PyRep *GetPageCriterias(uint32 tutorialID);
-    PyRep *GetPages(uint32 tutorialID);
-    PyRep *GetTutorial(uint32 tutorialID);
-    PyRep *GetTutorialCriterias(uint32 tutorialID);
+    /*
+     * The rows of all the tutorials, ordered by tutorialID
+     * which is the first column; for TutorialStore::Load().
+     */
+    bool GetAllPageCriterias(DBQueryResult &into);
+    bool GetAllPages(DBQueryResult &into);
+    bool GetTutorialRows(DBQueryResult &into);
+    bool GetAllTutorialCriterias(DBQueryResult &into);
+
     PyRep *GetAllTutorials();
     PyRep *GetAllCriterias();
     PyRep *GetCategories();
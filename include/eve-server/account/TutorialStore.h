@@ -0,0 +1,191 @@
+/*
+    ------------------------------------------------------------------------------------
+    LICENSE:
+    ------------------------------------------------------------------------------------
+    This file is part of EVEmu: EVE Online Server Emulator
+    Copyright 2006 - 2011 The EVEmu Team
+    For the latest information visit http://evemu.org
+    ------------------------------------------------------------------------------------
+    This program is free software; you can redistribute it and/or modify it under
+    the terms of the GNU Lesser General Public License as published by the Free Software
+    Foundation; either version 2 of the License, or (at your option) any later
+    version.
+
+    This program is distributed in the hope that it will be useful, but WITHOUT
+    ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+    FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public License along with
+    this program; if not, write to the Free Software Foundation, Inc., 59 Temple
+    Place - Suite 330, Boston, MA 02111-1307, USA, or go to
+    http://www.gnu.org/copyleft/lesser.txt.
+    ------------------------------------------------------------------------------------
+    Author:     EVEmu Team
+*/
+
+
+#ifndef __ACCOUNT__TUTORIAL_STORE_H__INCL__
+#define __ACCOUNT__TUTORIAL_STORE_H__INCL__
+
+#include "cache/ObjCacheService.h"
+#include "utils/Singleton.h"
+
+class PyRep;
+
+/**
+ * @brief Resident tutorials the tutorial service hands out.
+ *
+ * The tutorials, their pages and criterias and the categories are
+ * loaded once at startup; the info of every tutorial is encoded into
+ * its reply then and frozen.
+ *
+ * The replies are cached objects: a reply is handed to the cache
+ * service under its objectID the first time it is asked for, which
+ * marshals and deflates it once; afterwards a call only returns the
+ * cache hint. The content only changes when an operator reloads it
+ * (see Reload()), which invalidates the cached objects.
+ *
+ * Not thread-safe; meant to be used from the main loop.
+ *
+ * @author EVEmu Team
+ */
+class TutorialStore
+: public Singleton< TutorialStore >
+{
+public:
+    /**
+     * @brief Statistics of the store.
+     */
+    struct Stats
+    {
+        Stats() { Reset(); }
+
+        void Reset()
+        {
+            calls = 0;
+            built = 0;
+            unknown = 0;
+        }
+
+        /// Number of calls served.
+        uint32 calls;
+        /// Number of replies handed to the cache service.
+        uint32 built;
+        /// Number of requests of unknown tutorials.
+        uint32 unknown;
+    };
+
+    TutorialStore();
+    ~TutorialStore();
+
+    /** @return Number of tutorials. */
+    size_t size() const { return mTutorials.size(); }
+    /** @return Statistics since the last ResetStats(). */
+    const Stats& stats() const { return mStats; }
+    /** @brief Resets the statistics. */
+    void ResetStats() { mStats.Reset(); }
+
+    /**
+     * @brief Loads all the tutorials.
+     *
+     * The current content is kept if loading fails.
+     *
+     * @return True on success.
+     */
+    bool Load();
+    /**
+     * @brief Loads the tutorials again and invalidates the cached replies.
+     *
+     * @param[in] cache The cache service.
+     *
+     * @return True on success.
+     */
+    bool Reload( ObjCacheService& cache );
+
+    /**
+     * @param[in] cache      The cache service.
+     * @param[in] tutorialID The tutorial.
+     *
+     * @return The cached reply of GetTutorialInfo; an uncached one for unknown tutorials.
+     */
+    PyRep* GetTutorialInfo( ObjCacheService& cache, uint32 tutorialID );
+    /** @return The cached reply of GetTutorials; NULL if not loaded. */
+    PyRep* GetTutorials( ObjCacheService& cache );
+    /** @return The cached reply of GetCriterias; NULL if not loaded. */
+    PyRep* GetCriterias( ObjCacheService& cache );
+    /** @return The cached reply of GetCategories; NULL if not loaded. */
+    PyRep* GetCategories( ObjCacheService& cache );
+
+protected:
+    /**
+     * @brief A tutorial.
+     */
+    struct Tutorial
+    {
+        /// The cached objectID; we own this.
+        PyRep* objectID;
+        /// The frozen reply; we own this.
+        PyRep* info;
+    };
+
+    /**
+     * @brief Rowsets split by the first column of a result.
+     */
+    struct Split
+    {
+        ~Split();
+
+        /// Takes the rowset of a key, or an empty one.
+        PyRep* Take( uint32 key );
+
+        /// Column names of the rowsets.
+        std::vector< std::string > header;
+        /// The rowsets, by the first column; we own these.
+        std::map< uint32, PyRep* > rowsets;
+    };
+
+    /**
+     * @brief Splits a result into util.Rowsets by its first column.
+     *
+     * @param[in]  res  The result.
+     * @param[out] into The rowsets of the columns after the first.
+     */
+    static void _Split( DBQueryResult& res, Split& into );
+
+    /**
+     * @brief Returns the cached reply, handing the contents to the cache service if needed.
+     *
+     * @return The reply; NULL if the contents are not loaded.
+     */
+    PyRep* _Serve( ObjCacheService& cache, const PyRep* objectID, PyRep* contents );
+    /**
+     * @brief Invalidates all the cached replies.
+     */
+    void _Invalidate( ObjCacheService& cache );
+    /**
+     * @brief Releases the content.
+     */
+    void _Clear();
+
+    /// The tutorials, by tutorialID.
+    std::map< uint32, Tutorial > mTutorials;
+    /// The frozen reply for unknown tutorials; we own this.
+    PyRep* mUnknownInfo;
+
+    ObjectCachedMethodID mTutorialsID;
+    /// The frozen replies; we own these.
+    PyRep* mAllTutorials;
+    ObjectCachedMethodID mCriteriasID;
+    PyRep* mCriterias;
+    ObjectCachedMethodID mCategoriesID;
+    PyRep* mCategories;
+
+    /// Statistics.
+    Stats mStats;
+};
+
+/// A macro for easier access to the singleton.
+#define sTutorialStore \
+    ( TutorialStore::get() )
+
+#endif /* !__ACCOUNT__TUTORIAL_STORE_H__INCL__ */
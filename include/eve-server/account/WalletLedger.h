@@ -0,0 +1,221 @@
+/*
+    ------------------------------------------------------------------------------------
+    LICENSE:
+    ------------------------------------------------------------------------------------
+    This file is part of EVEmu: EVE Online Server Emulator
+    Copyright 2006 - 2011 The EVEmu Team
+    For the latest information visit http://evemu.org
+    ------------------------------------------------------------------------------------
+    This program is free software; you can redistribute it and/or modify it under
+    the terms of the GNU Lesser General Public License as published by the Free Software
+    Foundation; either version 2 of the License, or (at your option) any later
+    version.
+
+    This program is distributed in the hope that it will be useful, but WITHOUT
+    ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+    FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public License along with
+    this program; if not, write to the Free Software Foundation, Inc., 59 Temple
+    Place - Suite 330, Boston, MA 02111-1307, USA, or go to
+    http://www.gnu.org/copyleft/lesser.txt.
+    ------------------------------------------------------------------------------------
+    Author:     EVEmu Team
+*/
+
+#ifndef __ACCOUNT__WALLET_LEDGER_H__INCL__
+#define __ACCOUNT__WALLET_LEDGER_H__INCL__
+
+#include "utils/Singleton.h"
+
+/**
+ * @brief A row of market_journal, the wallet journal.
+ */
+struct WalletEntry
+{
+    uint32 refID;
+    uint64 transDate;
+    uint32 refTypeID;
+    uint32 ownerID1;
+    uint32 ownerID2;
+    std::string argID1;
+    uint32 accountKey;
+    double amount;
+    double balance;
+    std::string reason;
+};
+
+/**
+ * @brief Authoritative wallet balances and journal, kept in memory.
+ *
+ * The balances of the corporations are loaded on first use and
+ * changed in memory; the balances of the characters live in the
+ * Character objects. Neither waits for MySQL: the change of a balance
+ * and the entries of the wallet journal are appended to the market
+ * journal, which writes them in batches along with the trades.
+ *
+ * The entries get their refID here, in the order they are recorded,
+ * so the refIDs of an owner's entries are its sequence of changes,
+ * whenever they reach the database.
+ *
+ * The journal queries of the most recently used owners are served
+ * from a window of their latest entries, which the recorded entries
+ * are added to, instead of querying market_journal again.
+ *
+ * Not thread-safe; meant to be used from the main loop.
+ *
+ * @author EVEmu Team
+ */
+class WalletLedger
+: public Singleton< WalletLedger >
+{
+public:
+    /**
+     * @brief Statistics of the ledger.
+     */
+    struct Stats
+    {
+        Stats() { Reset(); }
+
+        void Reset()
+        {
+            changes = 0;
+            entries = 0;
+            windowHits = 0;
+            windowMisses = 0;
+        }
+
+        /// Number of balance changes.
+        uint32 changes;
+        /// Number of recorded journal entries.
+        uint32 entries;
+        /// Number of journal queries served from a window.
+        uint32 windowHits;
+        /// Number of journal queries which had to query the database.
+        uint32 windowMisses;
+    };
+
+    /**
+     * @brief Creates an empty ledger.
+     */
+    WalletLedger();
+
+    /** @return Number of corporations whose balance is resident. */
+    size_t size() const { return mCorpBalances.size(); }
+    /** @return Statistics since the last ResetStats(). */
+    const Stats& stats() const { return mStats; }
+
+    /**
+     * @brief Loads the last refID of the wallet journal.
+     *
+     * Must be called after the market journal is opened, as it may
+     * still have entries to write.
+     *
+     * @return True on success.
+     */
+    bool Load();
+
+    /**
+     * @brief Obtains the balance of a corporation.
+     *
+     * @param[in] corpID The corporation.
+     *
+     * @return The balance; 0 if the corporation doesn't exist.
+     */
+    double GetCorpBalance( uint32 corpID );
+    /**
+     * @brief Changes the balance of a corporation.
+     *
+     * @param[in] corpID The corporation.
+     * @param[in] amount The change (may be negative).
+     *
+     * @return True on success, false if the corporation doesn't exist.
+     */
+    bool AddCorpBalance( uint32 corpID, double amount );
+    /**
+     * @brief Writes the change of a character's balance.
+     *
+     * The balance itself is changed by the Character object.
+     *
+     * @param[in] characterID The character.
+     * @param[in] amount The change (may be negative).
+     */
+    void AddCharacterBalance( uint32 characterID, double amount );
+
+    /**
+     * @brief Records an entry of the wallet journal.
+     *
+     * @param[in] ownerID The owner whose journal the entry is in.
+     * @param[in] accountID The account of the owner.
+     * @param[in] entry The entry; its refID and transDate are assigned.
+     *
+     * @return The refID of the entry.
+     */
+    uint32 Record( uint32 ownerID, uint32 accountID, WalletEntry& entry );
+    /**
+     * @brief Obtains the entries of an owner for the day before a date.
+     *
+     * @param[in] ownerID The owner.
+     * @param[in] refTypeID The type of entries; 0 for any.
+     * @param[in] accountKey The account key.
+     * @param[in] transDate The end of the day.
+     *
+     * @return A util.Rowset of the entries; NULL on failure.
+     */
+    PyObject* GetJournal( uint32 ownerID, uint32 refTypeID, uint32 accountKey, uint64 transDate );
+    /**
+     * @brief Forgets the window of an owner whose journal is deleted.
+     *
+     * @param[in] ownerID The owner.
+     */
+    void Forget( uint32 ownerID ) { mWindows.erase( ownerID ); }
+
+    /**
+     * @brief Resets the statistics.
+     */
+    void ResetStats() { mStats.Reset(); }
+
+protected:
+    /**
+     * @brief The latest entries of an owner.
+     */
+    struct Window
+    {
+        /// The entries since this date are all in the window.
+        uint64 from;
+        /// The entries, oldest first.
+        std::deque< WalletEntry > entries;
+        /// When the window was last used.
+        uint64 lastUsed;
+    };
+
+    /**
+     * @brief Obtains the window of an owner which has all the entries since a date.
+     *
+     * @return The window; NULL on failure.
+     */
+    Window* _GetWindow( uint32 ownerID, uint64 from );
+    /**
+     * @brief Evicts the least recently used window if there are too many.
+     */
+    void _EvictWindow();
+
+    /// The balances of the corporations.
+    std::tr1::unordered_map< uint32, double > mCorpBalances;
+    /// The windows of the owners.
+    std::tr1::unordered_map< uint32, Window > mWindows;
+
+    /// The last refID given out.
+    uint32 mLastRefID;
+    /// Counter for the lastUsed of the windows.
+    uint64 mUseCounter;
+
+    /// Statistics.
+    Stats mStats;
+};
+
+/// A macro for easier access to the singleton.
+#define sWalletLedger \
+    ( WalletLedger::get() )
+
+#endif /* !__ACCOUNT__WALLET_LEDGER_H__INCL__ */
@@ -0,0 +1,145 @@
+/*
+    ------------------------------------------------------------------------------------
+    LICENSE:
+    ------------------------------------------------------------------------------------
+    This file is part of EVEmu: EVE Online Server Emulator
+    Copyright 2006 - 2011 The EVEmu Team
+    For the latest information visit http://evemu.org
+    ------------------------------------------------------------------------------------
+    This program is free software; you can redistribute it and/or modify it under
+    the terms of the GNU Lesser General Public License as published by the Free Software
+    Foundation; either version 2 of the License, or (at your option) any later
+    version.
+
+    This program is distributed in the hope that it will be useful, but WITHOUT
+    ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+    FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public License along with
+    this program; if not, write to the Free Software Foundation, Inc., 59 Temple
+    Place - Suite 330, Boston, MA 02111-1307, USA, or go to
+    http://www.gnu.org/copyleft/lesser.txt.
+    ------------------------------------------------------------------------------------
+    Author:     EVEmu Team
+*/
+
+
+#ifndef __ADMIN__CLIENT_TELEMETRY_H__INCL__
+#define __ADMIN__CLIENT_TELEMETRY_H__INCL__
+
+#include "utils/Singleton.h"
+
+/**
+ * @brief Collects the telemetry of the clients and writes it aggregated in the background.
+ *
+ * The logged strings, the python stack traces and the info events the
+ * clients send are only queued by the game thread, so the calls are
+ * answered right away. The queue is bounded; once it is full, reports
+ * are dropped and counted until the next flush.
+ *
+ * Every few seconds the queued reports are handed over to sDBAsync's
+ * worker threads, which deduplicate them by the hash of their text and
+ * add the counts to clientTelemetry with a single insert. Only one
+ * flush is in flight at a time, so a storm of identical reports costs
+ * a queue push per report and a row per distinct text.
+ *
+ * Not thread-safe; meant to be used from the main loop.
+ *
+ * @author EVEmu Team
+ */
+class ClientTelemetry
+: public Singleton< ClientTelemetry >,
+  protected TimerWheel::Callback
+{
+public:
+    enum Kind
+    {
+        /// A string logged by ClientStatLogger::LogString.
+        KIND_LOG_STRING = 0,
+        /// A python stack trace sent to AlertService.
+        KIND_STACK_TRACE = 1,
+        /// A batch of info events sent to InfoGatheringMgr.
+        KIND_INFO_EVENTS = 2
+    };
+
+    /**
+     * @brief Statistics of the telemetry.
+     */
+    struct Stats
+    {
+        Stats() { Reset(); }
+
+        void Reset()
+        {
+            reports = 0;
+            dropped = 0;
+            flushes = 0;
+            rows = 0;
+            failed = 0;
+        }
+
+        /// Number of reports queued.
+        uint32 reports;
+        /// Number of reports dropped since the queue was full.
+        uint32 dropped;
+        /// Number of flushes completed.
+        uint32 flushes;
+        /// Number of distinct texts written by the flushes.
+        uint32 rows;
+        /// Number of flushes which failed.
+        uint32 failed;
+    };
+
+    ClientTelemetry();
+
+    /** @return Number of queued reports. */
+    size_t size() const { return mQueue.size(); }
+    /** @return Statistics since the last ResetStats(). */
+    const Stats& stats() const { return mStats; }
+    /** @brief Resets the statistics. */
+    void ResetStats() { mStats.Reset(); }
+
+    /**
+     * @brief Queues a report.
+     *
+     * @param[in] kind        What the report is, see Kind.
+     * @param[in] characterID The reporting character; 0 if none yet.
+     * @param[in] text        The text; long texts are cut.
+     */
+    void Report( uint8 kind, uint32 characterID, const std::string& text );
+    /**
+     * @brief Hands the queued reports over to the workers right away; for the shutdown.
+     */
+    void Flush();
+
+protected:
+    /**
+     * @brief A queued report.
+     */
+    struct Entry
+    {
+        uint8 kind;
+        uint32 characterID;
+        uint64 time;
+        std::string text;
+    };
+
+    class FlushQuery;
+    void _Complete( FlushQuery& query, bool success );
+
+    void TimerExpired();
+
+    /// The queued reports.
+    std::vector< Entry > mQueue;
+    /// Whether a flush is being run.
+    bool mPending;
+
+    /// Statistics.
+    Stats mStats;
+};
+
+/// A macro for easier access to the singleton.
+#define sClientTelemetry \
+    ( ClientTelemetry::get() )
+
+#endif /* !__ADMIN__CLIENT_TELEMETRY_H__INCL__ */
@@ -61,6 +61,40 @@ COMMAND( kenny, ROLE_ADMIN,
         "(ON,OFF,0,1) - enable/disable the Kenny Translator for your chatting entertainment!")
 COMMAND( kill, ROLE_ADMIN,
         "(entityID) - insta-pops a destroyable ship, drone, structure, if applicable")
+COMMAND( callstats, ROLE_ADMIN,
+        "[reset] - shows the most expensive service calls (needs loop.callStats), or resets the statistics")
+COMMAND( dbstats, ROLE_ADMIN,
+        "[reset|explain [count]] - shows the most expensive database queries, explains them (needs database.indexAdvisor), or resets the statistics")
+COMMAND( tickprofile, ROLE_ADMIN,
+        "[count|reset] - logs the slowest main loop ticks with their zones (needs loop.tickProfiler), or forgets them")
+COMMAND( calltrace, ROLE_ADMIN,
+        "[count|reset|rate n] - logs the latest traced client calls with the time they spent in each stage, forgets them, or traces every n-th call (0 stops it)")
+COMMAND( capture, ROLE_ADMIN,
+        "(ON,OFF) [characterID] - starts or stops recording the packets of your session (or of a character) for eve-tool's replay")
+COMMAND( trace, ROLE_ADMIN,
+        "[session (characterID)|service (name)|sample (n)|rate (n)|dump|clear] - filters the packets traced while CLIENT__IN_ALL or DESTINY__UPDATES is enabled, or dumps them for eve-tool's unmarshal")
+COMMAND( netstats, ROLE_ADMIN,
+        "[characterID] - shows the traffic of the packets by kind and the busiest clients, or the traffic of a character")
+COMMAND( sessions, ROLE_ADMIN,
+        "[characterID] - shows the sessions holding the most memory, or the memory held by the session of a character")
+COMMAND( fitsim, ROLE_ADMIN,
+        "(shipTypeID) [moduleTypeID ...] - computes the attributes of a fitting with your skills, without any items")
+COMMAND( poolstats, ROLE_ADMIN,
+        "[reset] - shows the allocations of the main thread served by the object pools, or resets the statistics")
+COMMAND( memstats, ROLE_ADMIN,
+        "[sample (n)|dump [count]|clear] - shows the memory held by the tagged subsystems, samples every n-th allocation, or dumps or forgets the call stacks of the live samples")
+COMMAND( tutorials, ROLE_ADMIN,
+        "reload - loads the tutorials again after their tables changed, and makes the clients fetch them anew")
+COMMAND( dungeon, ROLE_ADMIN,
+        "list | spawn (dungeonID) | clear (instanceID) - lists the dungeons, spawns one into a pocket of your system, or tears an instance down")
+COMMAND( starbase, ROLE_ADMIN,
+        "list | online (towerID) | offline (towerID) | reinforce (towerID) (hours) | pass - lists the control towers, changes the state of one, or burns their fuel right away")
+COMMAND( colony, ROLE_ADMIN,
+        "(planetID) show | extractor (resourceTypeID) (hours) | factory (schematicID) - shows your colony on a planet, or installs a pin into it")
+COMMAND( sov, ROLE_ADMIN,
+        "show | claim (allianceID) (corporationID) | contest (0|1) | occupy (factionID) - shows or changes the sovereignty and the occupier of your solar system")
+COMMAND( stress, ROLE_ADMIN,
+        "npcs|cans (typeID) (count) [grid|ring] [spacing] | pilots (typeID) (count) [distance] | items (typeID) (count) [quantity] | ticks | clear - spawns or creates things in bulk, shows the tick times against those before the first spawn, or tears the spawns down")
 /*COMMAND( entity, ROLE_ADMIN,
         "(entityID) - unknown" )
 COMMAND( chatban, ROLE_ADMIN,
@@ -0,0 +1,193 @@
+/*
+    ------------------------------------------------------------------------------------
+    LICENSE:
+    ------------------------------------------------------------------------------------
+    This file is part of EVEmu: EVE Online Server Emulator
+    Copyright 2006 - 2011 The EVEmu Team
+    For the latest information visit http://evemu.org
+    ------------------------------------------------------------------------------------
+    This program is free software; you can redistribute it and/or modify it under
+    the terms of the GNU Lesser General Public License as published by the Free Software
+    Foundation; either version 2 of the License, or (at your option) any later
+    version.
+
+    This program is distributed in the hope that it will be useful, but WITHOUT
+    ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+    FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public License along with
+    this program; if not, write to the Free Software Foundation, Inc., 59 Temple
+    Place - Suite 330, Boston, MA 02111-1307, USA, or go to
+    http://www.gnu.org/copyleft/lesser.txt.
+    ------------------------------------------------------------------------------------
+    Author:     EVEmu Team
+*/
+
+
+#ifndef __ADMIN__PACKET_TRACE_H__INCL__
+#define __ADMIN__PACKET_TRACE_H__INCL__
+
+#include "network/PacketCapture.h"
+#include "utils/Singleton.h"
+
+/**
+ * @brief Sampled trace of the packets of chosen sessions and services.
+ *
+ * Replaces rendering the packets into the log (CLIENT__IN_ALL and
+ * DESTINY__UPDATES): while those categories are enabled, the packets
+ * are filtered by the session (account) and service, sampled (one in
+ * N) and rate-limited, and the ones which pass are only marshalled
+ * into a bounded ring of the latest records. The game thread never
+ * renders them to text.
+ *
+ * Dump() writes the ring into one capture per account, which eve-tool
+ * renders offline ("unmarshal @file"). The service of an incoming
+ * packet is its destination service (empty for calls to bound
+ * objects); that of a destiny update is the name of its notification
+ * ("DoDestinyUpdate" or "OnMultiEvent"). Empty filters pass all.
+ *
+ * Not thread-safe; meant to be used from the main loop.
+ *
+ * @author EVEmu Team
+ */
+class PacketTrace
+: public Singleton< PacketTrace >
+{
+public:
+    /**
+     * @brief Statistics of the trace.
+     */
+    struct Stats
+    {
+        Stats() { Reset(); }
+
+        void Reset()
+        {
+            traced = 0;
+            sampledOut = 0;
+            throttled = 0;
+            oversized = 0;
+            overwritten = 0;
+        }
+
+        /// Number of packets recorded.
+        uint32 traced;
+        /// Number of packets which passed the filters but not the sampling.
+        uint32 sampledOut;
+        /// Number of packets over the rate limit.
+        uint32 throttled;
+        /// Number of packets too big to record or failing to marshal.
+        uint32 oversized;
+        /// Number of records the ring overwrote.
+        uint32 overwritten;
+    };
+
+    PacketTrace();
+
+    /** @return Number of records held. */
+    size_t size() const { return mCount; }
+    /** @return Statistics since the last ResetStats(). */
+    const Stats& stats() const { return mStats; }
+    /** @brief Resets the statistics. */
+    void ResetStats() { mStats.Reset(); }
+
+    /** @return The traced accounts; empty if all. */
+    const std::set< uint32 >& accounts() const { return mAccounts; }
+    /** @return The traced services; empty if all. */
+    const std::set< std::string >& services() const { return mServices; }
+    /** @return One in how many packets is recorded. */
+    uint32 sampling() const { return mSampling; }
+    /** @return The most packets recorded per second. */
+    uint32 rateLimit() const { return mRateLimit; }
+
+    /**
+     * @brief Starts or stops tracing an account.
+     *
+     * @return True if the account is traced now.
+     */
+    bool ToggleAccount( uint32 accountID );
+    /**
+     * @brief Starts or stops tracing a service.
+     *
+     * @return True if the service is traced now.
+     */
+    bool ToggleService( const std::string& service );
+    /** @brief Records one in sampling packets; 1 records all. */
+    void SetSampling( uint32 sampling ) { mSampling = std::max< uint32 >( sampling, 1 ); }
+    /** @brief Sets the most packets recorded per second. */
+    void SetRateLimit( uint32 perSecond ) { mRateLimit = std::max< uint32 >( perSecond, 1 ); }
+    /**
+     * @brief Drops the records and the filters.
+     */
+    void Clear();
+
+    /**
+     * @brief Decides whether a packet is recorded; cheap, so it is asked before encoding the packet.
+     *
+     * Counts the packet against the sampling and the rate limit.
+     *
+     * @param[in] accountID The session.
+     * @param[in] service   The service, see the class.
+     *
+     * @return True if the packet should be passed to Record().
+     */
+    bool Wants( uint32 accountID, const std::string& service );
+    /**
+     * @brief Marshals a packet into the ring.
+     *
+     * @param[in] accountID The session.
+     * @param[in] direction Where the packet goes.
+     * @param[in] rep       The packet.
+     */
+    void Record( uint32 accountID, PacketCapture::Direction direction, const PyRep* rep );
+
+    /**
+     * @brief Writes the records into files.captureDir, a capture per account, oldest first.
+     *
+     * The records are kept.
+     *
+     * @param[out] files Names of the written files.
+     *
+     * @return Number of records written.
+     */
+    size_t Dump( std::vector< std::string >& files ) const;
+
+protected:
+    /**
+     * @brief A recorded packet.
+     */
+    struct Entry
+    {
+        /// Time (in microseconds) of the record.
+        uint64 time;
+        uint32 accountID;
+        uint8 direction;
+        /// The marshalled packet.
+        Buffer data;
+    };
+
+    /// The ring of records; mNext is the slot overwritten next.
+    std::vector< Entry > mRing;
+    size_t mNext;
+    size_t mCount;
+
+    std::set< uint32 > mAccounts;
+    std::set< std::string > mServices;
+    uint32 mSampling;
+    uint32 mRateLimit;
+
+    /// Number of packets which passed the filters, for the sampling.
+    uint64 mSeen;
+    /// Start (in microseconds) of the current second of the rate limit and the packets recorded in it.
+    uint64 mWindowStart;
+    uint32 mWindowCount;
+
+    /// Statistics.
+    Stats mStats;
+};
+
+/// A macro for easier access to the singleton.
+#define sPacketTrace \
+    ( PacketTrace::get() )
+
+#endif /* !__ADMIN__PACKET_TRACE_H__INCL__ */
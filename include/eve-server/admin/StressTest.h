@@ -0,0 +1,147 @@
+/*
+    ------------------------------------------------------------------------------------
+    LICENSE:
+    ------------------------------------------------------------------------------------
+    This file is part of EVEmu: EVE Online Server Emulator
+    Copyright 2006 - 2011 The EVEmu Team
+    For the latest information visit http://evemu.org
+    ------------------------------------------------------------------------------------
+    This program is free software; you can redistribute it and/or modify it under
+    the terms of the GNU Lesser General Public License as published by the Free Software
+    Foundation; either version 2 of the License, or (at your option) any later
+    version.
+
+    This program is distributed in the hope that it will be useful, but WITHOUT
+    ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+    FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public License along with
+    this program; if not, write to the Free Software Foundation, Inc., 59 Temple
+    Place - Suite 330, Boston, MA 02111-1307, USA, or go to
+    http://www.gnu.org/copyleft/lesser.txt.
+    ------------------------------------------------------------------------------------
+    Author:     EVEmu Team
+*/
+
+
+#ifndef __ADMIN__STRESS_TEST_H__INCL__
+#define __ADMIN__STRESS_TEST_H__INCL__
+
+#include "system/DungeonManager.h"
+#include "utils/Singleton.h"
+
+class NPC;
+class PyServiceMgr;
+class SystemManager;
+
+/**
+ * @brief Bulk spawns of the GM stress-test commands and the tick times they cause.
+ *
+ * Every spawn is an ad hoc dungeon blueprint laid out in a pattern
+ * around a point, instanced without a pocket; so the entities are
+ * transient, come from ObjectPool and are torn down the same way as
+ * the dungeons are.
+ *
+ * The first spawn in a solar system records the average times of its
+ * ticks as a baseline, which the later tick times are compared to
+ * until the system is cleared.
+ *
+ * Not thread-safe; meant to be used from the main loop.
+ *
+ * @author EVEmu Team
+ */
+class StressTest
+: public Singleton< StressTest >
+{
+public:
+    enum Pattern
+    {
+        /// Rows in front of the center.
+        PATTERN_GRID,
+        /// A circle around the center.
+        PATTERN_RING
+    };
+
+    /**
+     * @brief Average times (in microseconds) of the ticks of a system.
+     */
+    struct TickTimes
+    {
+        TickTimes() : ticks( 0 ), tickTime( 0.0 ), maxTickTime( 0 ), destinyTime( 0.0 ), aiTime( 0.0 ) {}
+
+        /// Number of ticks averaged.
+        uint32 ticks;
+        /// Average time of Process().
+        double tickTime;
+        /// Longest Process().
+        uint32 maxTickTime;
+        /// Average time of ProcessDestiny().
+        double destinyTime;
+        /// Average time the AI spent thinking per tick.
+        double aiTime;
+    };
+
+    StressTest();
+    ~StressTest();
+
+    /** @return Number of entities spawned in the system and still tracked. */
+    size_t GetEntityCount( uint32 solarSystemID ) const;
+
+    /**
+     * @brief Spawns objects of a type in a pattern.
+     *
+     * @param[in] system  The system to spawn into.
+     * @param[in] kind    DungeonBlueprint::OBJECT_NPC_GROUP for NPCs, DungeonBlueprint::OBJECT_CONTAINER for containers.
+     * @param[in] typeID  Type of the objects.
+     * @param[in] count   Number of the objects.
+     * @param[in] pattern How to lay them out.
+     * @param[in] spacing Distance between two neighbours (in meters).
+     * @param[in] center  The point to lay them out around.
+     * @param[out] npcs   The spawned NPCs, if not NULL.
+     *
+     * @return Number of spawned entities.
+     */
+    size_t Spawn( SystemManager& system, PyServiceMgr& services, uint8 kind, uint32 typeID, uint32 count,
+                  Pattern pattern, double spacing, const GPoint& center, std::vector< NPC* >* npcs = NULL );
+    /**
+     * @brief Tears down all the spawns in the system and forgets its baseline.
+     *
+     * @return Number of torn down spawns.
+     */
+    size_t TeardownSystem( uint32 solarSystemID );
+
+    /** @return The average tick times of the system since its tick statistics were reset. */
+    static TickTimes GetTickTimes( const SystemManager& system );
+    /**
+     * @return The baseline of the system; NULL if nothing has been spawned there.
+     */
+    const TickTimes* GetBaseline( uint32 solarSystemID ) const;
+
+protected:
+    /**
+     * @brief A spawn; the instance refers to the blueprint.
+     */
+    struct Run
+    {
+        Run() : instance( NULL ) {}
+        ~Run() { delete instance; }
+
+        DungeonBlueprint blueprint;
+        DungeonInstance* instance;
+    };
+
+    /** @return Offset of the index-th of count objects laid out in the pattern. */
+    static GPoint _GetOffset( Pattern pattern, uint32 index, uint32 count, double spacing );
+
+    /// The spawns, by solarSystemID.
+    std::map< uint32, std::vector< Run* > > mRuns;
+    /// The baselines, by solarSystemID.
+    std::map< uint32, TickTimes > mBaselines;
+    uint32 mNextInstanceID;
+};
+
+/// A macro for easier access to the singleton.
+#define sStressTest \
+    ( StressTest::get() )
+
+#endif /* !__ADMIN__STRESS_TEST_H__INCL__ */
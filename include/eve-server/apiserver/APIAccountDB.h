@@ -34,17 +34,18 @@ public:
     APIAccountDB();
 
     /**
-     * @brief ?
+     * @brief Queries the characters of an account.
      *
-     * ?
+     * The columns are name, characterID, corporationName and corporationID,
+     * so the rows can be rendered straight into the "characters" rowset.
      *
-     * @param[in] ?
-     * @param[in] ?
+     * @param[in]  accountID The account.
+     * @param[out] res       The characters.
      *
-     * @retval ?
+     * @retval true  Query succeeded.
+     * @retval false Query failed.
      */
-    bool GetCharactersList(uint32 accountID, std::vector<std::string> & charIDList, std::vector<std::string> & charNameList,
-    std::vector<std::string> & charCorpIDList, std::vector<std::string> & charCorpNameList);
+    bool GetCharactersList(uint32 accountID, DBQueryResult & res);
 
     /**
      * @brief ?
@@ -48,12 +48,12 @@ public:
     APIAccountManager(const PyServiceMgr &services);
 
     // Common call shared to all derived classes called via polymorphism
-    std::tr1::shared_ptr<std::string> ProcessCall(const APICommandCall * pAPICommandCall);
+    APIXMLDocumentPtr ProcessCall(const APICommandCall * pAPICommandCall);
 
 protected:
-    std::tr1::shared_ptr<std::string> _APIKeyRequest(const APICommandCall * pAPICommandCall);
-    std::tr1::shared_ptr<std::string> _Characters(const APICommandCall * pAPICommandCall);
-    std::tr1::shared_ptr<std::string> _AccountStatus(const APICommandCall * pAPICommandCall);
+    APIXMLDocumentPtr _APIKeyRequest(const APICommandCall * pAPICommandCall);
+    APIXMLDocumentPtr _Characters(const APICommandCall * pAPICommandCall);
+    APIXMLDocumentPtr _AccountStatus(const APICommandCall * pAPICommandCall);
 
     // Utility Functions:
     std::string _GenerateAPIKey();
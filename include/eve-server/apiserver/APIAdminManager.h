@@ -47,7 +47,7 @@ public:
     APIAdminManager(const PyServiceMgr &services);
 
     // Common call shared to all derived classes called via polymorphism
-    std::tr1::shared_ptr<std::string> ProcessCall(const APICommandCall * pAPICommandCall);
+    APIXMLDocumentPtr ProcessCall(const APICommandCall * pAPICommandCall);
 
 protected:
 
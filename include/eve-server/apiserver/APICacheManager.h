@@ -26,41 +26,154 @@
 #ifndef __APIAPICACHEMANAGER_H_INCL__
 #define __APIAPICACHEMANAGER_H_INCL__
 
+#include "apiserver/APIXMLWriter.h"
+#include "threading/LockProfile.h"
+#include "threading/SpinMutex.h"
 
-
+/**
+ * @brief In-memory cache of API responses.
+ *
+ * The documents are kept in a number of shards, each with its own lock
+ * and least-recently-used order, so API threads only contend when they
+ * hit the same shard. The total size of the documents is bounded; the
+ * least recently used ones are evicted above it.
+ *
+ * The documents are immutable, so they are shared with the callers
+ * instead of copied in and out.
+ *
+ * @author EVEmu Team
+ */
 class APICacheManager
 {
 public:
-    APICacheManager();
+    /**
+     * @brief Cache statistics.
+     */
+    struct Stats
+    {
+        Stats() { Reset(); }
+
+        void Reset()
+        {
+            hits = 0;
+            misses = 0;
+            expired = 0;
+            deposits = 0;
+            evictions = 0;
+        }
+
+        /// Number of documents found.
+        uint32 hits;
+        /// Number of documents not found, including the expired ones.
+        uint32 misses;
+        /// Number of documents found expired.
+        uint32 expired;
+        /// Number of documents deposited.
+        uint32 deposits;
+        /// Number of documents evicted to stay within the size limit.
+        uint32 evictions;
+    };
+
+    /**
+     * @param[in] sizeLimit Limit (in bytes) of the total size of the documents; 0 disables the cache.
+     */
+    APICacheManager(size_t sizeLimit = 0);
 
+    /** @return Limit (in bytes) of the total size of the documents. */
+    size_t GetSizeLimit() const { return m_sizeLimit; }
     /**
-     * @brief ?
+     * Changes the size limit; documents above it are evicted as they are deposited.
      *
-     * ?
+     * @param[in] sizeLimit Limit (in bytes) of the total size of the documents; 0 disables the cache.
+     */
+    void SetSizeLimit(size_t sizeLimit) { m_sizeLimit = sizeLimit; }
+
+    /**
+     * @brief Retrieves a cached document.
+     *
+     * Expired documents are dropped as they are found.
      *
-     * @param[in] ?
-     * @param[in] ?
+     * @param[in]  apiDescriptor Descriptor of the API call.
+     * @param[out] xmlDoc        The document, shared with the cache.
      *
-     * @retval ?
+     * @retval true  Document found.
+     * @retval false Document not cached or expired.
      */
-    bool CacheRetrieve(const std::string * apiDescriptor, std::string * xmlDoc);
+    bool CacheRetrieve(const std::string * apiDescriptor, APIXMLDocumentPtr * xmlDoc);
 
     /**
-     * @brief ?
+     * @brief Deposits a document into the cache.
      *
-     * ?
+     * Replaces the document of the same descriptor, if any.
+     *
+     * @param[in] apiDescriptor       Descriptor of the API call.
+     * @param[in] xmlDoc              The document.
+     * @param[in] win32timeExpiration Win32 time at which the document expires.
+     *
+     * @retval true  Document cached.
+     * @retval false Document not cached: the cache is disabled, the document expired already or is too big.
+     */
+    bool CacheDeposit(const std::string * apiDescriptor, const APIXMLDocumentPtr & xmlDoc, uint64 win32timeExpiration);
+
+    /**
+     * @brief Gets the statistics, summed over the shards.
      *
-     * @param[in] ?
-     * @param[in] ?
+     * @param[out] entries Number of cached documents.
+     * @param[out] size    Total size (in bytes) of the cached documents.
      *
-     * @retval ?
+     * @return The statistics since the last ResetStats().
+     */
+    Stats GetStats(size_t &entries, size_t &size);
+    /**
+     * @brief Resets the statistics.
      */
-    bool CacheDeposit(const std::string * apiDescriptor, const std::string * xmlDoc, uint64 win32timeExpiration);
+    void ResetStats();
 
 protected:
+    /// Number of the shards.
+    static const uint32 SHARD_COUNT = 8;
 
-};
+    /**
+     * @brief A cached document.
+     */
+    struct Entry
+    {
+        APIXMLDocumentPtr xmlDoc;
+        uint64 expiration;
+        /// Position in the LRU list of the shard.
+        std::list<const std::string *>::iterator lru;
+    };
+    typedef std::map<std::string, Entry> EntryMap;
 
-#endif    //__APIAPICACHEMANAGER_H_INCL__
+    /// The critical sections are short lookups and splices.
+    typedef ProfiledMutex< SpinMutex > ShardMutex;
 
+    /**
+     * @brief A shard of the cache.
+     */
+    struct Shard
+    {
+        Shard() : lock("api_cache"), size(0) {}
+
+        ShardMutex lock;
+        EntryMap entries;
+        /// Keys of the entries, most recently used first.
+        std::list<const std::string *> lru;
+        /// Total size of the entries.
+        size_t size;
+        Stats stats;
+    };
+
+    /// @return The shard of given descriptor.
+    Shard &_GetShard(const std::string &apiDescriptor);
+    /// @return Size charged for the entry.
+    static size_t _GetEntrySize(const std::string &apiDescriptor, const APIXMLDocument &xmlDoc);
+    /// Removes the entry from its shard.
+    static void _Erase(Shard &shard, EntryMap::iterator itr);
 
+    /// Limit of the total size; each shard gets an equal part of it.
+    size_t m_sizeLimit;
+    Shard m_shards[ SHARD_COUNT ];
+};
+
+#endif    //__APIAPICACHEMANAGER_H_INCL__
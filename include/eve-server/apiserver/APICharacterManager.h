@@ -48,14 +48,14 @@ public:
     APICharacterManager(const PyServiceMgr &services);
 
     // Common call shared to all derived classes called via polymorphism
-    std::tr1::shared_ptr<std::string> ProcessCall(const APICommandCall * pAPICommandCall);
+    APIXMLDocumentPtr ProcessCall(const APICommandCall * pAPICommandCall);
 
 protected:
 
     APICharacterDB m_charDB;
-    std::tr1::shared_ptr<std::string> _CharacterSheet(const APICommandCall * pAPICommandCall);
-    std::tr1::shared_ptr<std::string> _SkillQueue(const APICommandCall * pAPICommandCall);
-    std::tr1::shared_ptr<std::string> _SkillInTraining(const APICommandCall * pAPICommandCall);
+    APIXMLDocumentPtr _CharacterSheet(const APICommandCall * pAPICommandCall);
+    APIXMLDocumentPtr _SkillQueue(const APICommandCall * pAPICommandCall);
+    APIXMLDocumentPtr _SkillInTraining(const APICommandCall * pAPICommandCall);
 
 };
 
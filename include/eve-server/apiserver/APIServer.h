@@ -27,6 +27,8 @@
 #define __APISERVER__H__INCL__
 
 #include "APIServerListener.h"
+#include "apiserver/APICacheManager.h"
+#include "apiserver/APIXMLWriter.h"
 
 class APIServiceManager;
 
@@ -38,6 +40,10 @@ class APIServiceManager;
  * A very limited HTTP server that can efficiently deliver many different xml structured documents to clients
  * Uses asio for efficient asynchronous network communication
  *
+ * The connections are served by a pool of I/O threads; the documents are built by a separate
+ * pool of worker threads, so a slow document does not hold up the other clients. Every service
+ * manager builds one document at a time.
+ *
  * @author Aknor Jaden
  * @date July 2011
  */
@@ -51,24 +57,42 @@ public:
 
     std::string& url();
 
-    std::tr1::shared_ptr<std::vector<char> > GetXML(const APICommandCall * pAPICommandCall);
+    APIXMLDocumentPtr GetXML(const APICommandCall * pAPICommandCall);
+
+    /**
+     * @return The cache of the API responses.
+     */
+    APICacheManager& cache() { return m_cache; }
+
+    /**
+     * @return The pool of worker threads which build the documents.
+     */
+    boost::asio::io_service& workers() { return *_workerIo; }
 
     // used when the ImageServer can't find the image requested
     // this way we don't have to transfer over all the static NPC images
     static const char *const FallbackURL;
 
 private:
-    void RunInternal();
+    typedef std::tr1::shared_ptr<boost::asio::detail::thread> ThreadPtr;
+
+    static void RunService(boost::asio::io_service* io);
+    // Builds the cache key of a call out of all its parameters
+    static std::string _BuildCacheDescriptor(const APICommandCall * pAPICommandCall);
 
-    std::unique_ptr<boost::asio::detail::thread> _ioThread;
+    std::vector<ThreadPtr> _ioThreads;
     std::unique_ptr<boost::asio::io_service> _io;
+    std::vector<ThreadPtr> _workerThreads;
+    std::unique_ptr<boost::asio::io_service> _workerIo;
+    // keeps the workers waiting while there is nothing to build
+    std::unique_ptr<boost::asio::io_service::work> _work;
     std::unique_ptr<APIServerListener> _listener;
     std::string _url;
     std::string _basePath;
     boost::asio::detail::mutex _limboLock;
     bool runonce;
 
-    std::tr1::shared_ptr<std::string> m_xmlString;
+    APICacheManager m_cache;
 
     std::map<std::string, APIServiceManager *> m_APIServiceManagers;    // We own these
 
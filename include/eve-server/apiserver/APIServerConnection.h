@@ -34,6 +34,11 @@
  * @brief Handles a client connection to the API server
  *
  * Handles exactly one client; does all the protocol related stuff. Very limited HTTP handling.
+ * The I/O handlers of a connection run in its strand; the document is built by the worker pool of APIServer.
+ *
+ * Connections are kept open between requests as HTTP/1.1 asks (or HTTP/1.0 with "Connection: keep-alive"),
+ * every response carrying its Content-Length; pipelined requests are answered in order. A connection
+ * which sends no request for net.apiKeepAliveTimeout seconds is closed.
  *
  * @author Aknor Jaden
  * @date July 2011
@@ -47,10 +52,18 @@ public:
 
 private:
     APIServerConnection(boost::asio::io_service& io);
-    void ProcessHeaders();
-    void ProcessPostData();
-    void SendXML();
+    void IdleTimeout(const boost::system::error_code& error);
+    void ProcessHeaders(const boost::system::error_code& error, size_t bytes);
+    void ParseHeaderFields(std::istream& stream);
+    void ParseParameters(std::string request);
+    void ProcessPostData(const boost::system::error_code& error);
+    void QueueCall();
+    void BuildXML();
+    void SendMetrics();
     void NotFound();
+    void SendResponse(const char* status, const char* contentType, const boost::asio::const_buffer& body);
+    void SendResponse(const char* status, const char* contentType, const std::vector<boost::asio::const_buffer>& body);
+    void FinishRequest(const boost::system::error_code& error);
     void Close();
     void Redirect();
     void RedirectLocation();
@@ -59,20 +72,28 @@ private:
     static bool starts_with(std::string& haystack, const char *const needle);
 
     // request data
+    std::string _query;
     std::string _service;
     std::string _service_handler;
     std::string _redirectUrl;
     std::string _http_cmd_str;
+    std::string _httpVersion;
     APICommandCall m_apiCommandCall;
+    // whether the connection stays open after the response
+    bool _keepAlive;
+    size_t _contentLength;
 
     boost::asio::streambuf _buffer;
-    boost::asio::streambuf _postBuffer;
     boost::asio::ip::tcp::socket _socket;
-    std::tr1::shared_ptr<std::vector<char> > _xmlData;
+    boost::asio::io_service::strand _strand;
+    boost::asio::deadline_timer _timer;
+    std::string _header;
+    // the document being sent, shared with the cache
+    APIXMLDocumentPtr _xmlData;
+    // body of a response which is not a document
+    std::string _body;
 
-    static boost::asio::const_buffers_1 _responseOK;
     static boost::asio::const_buffers_1 _responseNotFound;
-    static boost::asio::const_buffers_1 _responseNoContent;
     static boost::asio::const_buffers_1 _responseRedirectBegin;
     static boost::asio::const_buffers_1 _responseRedirectEnd;
 };
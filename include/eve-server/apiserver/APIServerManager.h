@@ -47,10 +47,10 @@ public:
     APIServerManager(const PyServiceMgr &services);
 
     // Common call shared to all derived classes called via polymorphism
-    std::tr1::shared_ptr<std::string> ProcessCall(const APICommandCall * pAPICommandCall);
+    APIXMLDocumentPtr ProcessCall(const APICommandCall * pAPICommandCall);
 
 protected:
-    std::tr1::shared_ptr<std::string> _ServerStatus(const APICommandCall * pAPICommandCall);
+    APIXMLDocumentPtr _ServerStatus(const APICommandCall * pAPICommandCall);
 
 };
 
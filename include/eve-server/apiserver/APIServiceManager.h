@@ -28,6 +28,8 @@
 
 #include "PyServiceMgr.h"
 #include "apiserver/APIServiceDB.h"
+#include "apiserver/APIXMLWriter.h"
+#include "threading/Mutex.h"
 
 namespace EVEAPI {
     namespace CacheStyles {
@@ -67,6 +69,9 @@ typedef std::map<std::string, std::string> APICommandCall;
  * service handlers for the API Server.  It is used as the base class for polymorphism container in APIServer::GetXML()
  * call to route the API Command Call package to the appropriate service handler using the service category.
  *
+ * The documents are streamed into chunks by an APIXMLWriter as they are built, rows of a DBQueryResult
+ * included, so no intermediate string is built for them.
+ *
  * @author Aknor Jaden
  * @date July 2011
  */
@@ -77,8 +82,18 @@ public:
     PyServiceMgr& services() { return m_services; }
 
     // Common call shared to all derived classes called via polymorphism
-    virtual std::tr1::shared_ptr<std::string> ProcessCall(const APICommandCall * pAPICommandCall);
-    std::tr1::shared_ptr<std::string> BuildErrorXMLResponse(std::string errorCode, std::string errorMessage);
+    virtual APIXMLDocumentPtr ProcessCall(const APICommandCall * pAPICommandCall);
+    APIXMLDocumentPtr BuildErrorXMLResponse(std::string errorCode, std::string errorMessage);
+
+    /**
+     * @return Win32 time of the "cachedUntil" tag of the last document built; 0 if it had none.
+     */
+    uint64 GetCachedUntil() const { return _CachedUntil; }
+
+    /**
+     * @return Lock to hold while building a document and reading its "cachedUntil".
+     */
+    Mutex& lock() { return m_lock; }
 
 protected:
     bool _AuthenticateUserNamePassword(std::string userName, std::string password);
@@ -91,21 +106,24 @@ protected:
     void _BuildXMLRowSet(std::string name, std::string key, const std::vector<std::string> * columns);
     void _CloseXMLRowSet();
     void _BuildXMLRow(const std::vector<std::string> * columns);
+    // Renders every row of the result into the current rowset; the columns of the result go in the order of the rowset's
+    void _BuildXMLRows(DBQueryResult& res);
     void _BuildXMLTag(std::string name);
     void _BuildXMLTag(std::string name, const std::vector<std::pair<std::string, std::string> > * params);
     void _BuildXMLTag(std::string name, const std::vector<std::pair<std::string, std::string> > * params, std::string value);
     void _CloseXMLTag();
     void _BuildSingleXMLTag(std::string name, std::string param);
     void _BuildErrorXMLTag(std::string code, std::string param);
-    std::tr1::shared_ptr<std::string> _GetXMLDocumentString();
+    APIXMLDocumentPtr _GetXMLDocument();
 
     APIServiceDB m_db;
     PyServiceMgr m_services;
 
-    TiXmlDocument _XmlDoc;
-    TiXmlElement * _pXmlDocOuterTag;
-    std::string _CurrentRowSetColumnString;
-    std::stack<TiXmlElement *> * _pXmlElementStack;
+    APIXMLWriter _XmlWriter;
+    std::vector<std::string> _CurrentRowSetColumns;
+    uint64 _CachedUntil;
+
+    Mutex m_lock;
 };
 
 #endif // __APISERVICEMANAGER__H__INCL__
@@ -0,0 +1,164 @@
+/*
+    ------------------------------------------------------------------------------------
+    LICENSE:
+    ------------------------------------------------------------------------------------
+    This file is part of EVEmu: EVE Online Server Emulator
+    Copyright 2006 - 2011 The EVEmu Team
+    For the latest information visit http://evemu.org
+    ------------------------------------------------------------------------------------
+    This program is free software; you can redistribute it and/or modify it under
+    the terms of the GNU Lesser General Public License as published by the Free Software
+    Foundation; either version 2 of the License, or (at your option) any later
+    version.
+
+    This program is distributed in the hope that it will be useful, but WITHOUT
+    ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+    FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public License along with
+    this program; if not, write to the Free Software Foundation, Inc., 59 Temple
+    Place - Suite 330, Boston, MA 02111-1307, USA, or go to
+    http://www.gnu.org/copyleft/lesser.txt.
+    ------------------------------------------------------------------------------------
+    Author:     EVEmu Team
+*/
+
+#ifndef __APIXMLWRITER_H_INCL__
+#define __APIXMLWRITER_H_INCL__
+
+/**
+ * @brief An XML document of the API server.
+ *
+ * The document is a sequence of chunks which are never modified once
+ * they are added, so the cache and the connections sending it share
+ * them instead of copying the text.
+ *
+ * @author EVEmu Team
+ */
+class APIXMLDocument
+{
+public:
+    typedef std::tr1::shared_ptr<const std::string> Chunk;
+
+    APIXMLDocument() : mSize(0) {}
+
+    /** @return The chunks, in order. */
+    const std::vector<Chunk>& chunks() const { return mChunks; }
+    /** @return Total size (in bytes) of the chunks. */
+    size_t size() const { return mSize; }
+    /** @return True if the document has no text. */
+    bool empty() const { return 0 == mSize; }
+
+    /**
+     * @brief Appends a chunk.
+     */
+    void Append(const Chunk& chunk)
+    {
+        mChunks.push_back(chunk);
+        mSize += chunk->size();
+    }
+
+protected:
+    std::vector<Chunk> mChunks;
+    size_t mSize;
+};
+
+typedef std::tr1::shared_ptr<const APIXMLDocument> APIXMLDocumentPtr;
+
+/**
+ * @brief Streaming writer of API documents.
+ *
+ * Renders the elements as they are written into chunks of CHUNK_SIZE
+ * bytes, so a big document is never reallocated nor copied as it grows.
+ * The text and the attribute values are escaped. Elements are indented
+ * as TinyXML prints them; an element which gets nothing but text is
+ * kept on one line.
+ *
+ * @author EVEmu Team
+ */
+class APIXMLWriter
+{
+public:
+    /// Size of the chunks.
+    static const size_t CHUNK_SIZE = 16 * 1024;
+
+    APIXMLWriter();
+
+    /** @return Number of open elements. */
+    size_t depth() const { return mOpen.size(); }
+
+    /**
+     * @brief Discards the document being written and starts a new one with the XML declaration.
+     */
+    void Start();
+
+    /**
+     * @brief Opens an element.
+     */
+    void StartElement(const char* name);
+    /**
+     * @brief Adds an attribute to the element just opened.
+     *
+     * Must be called before anything is written into the element.
+     */
+    void Attribute(const char* name, const char* value);
+    /**
+     * @brief Adds text to the open element.
+     */
+    void Text(const char* text);
+    /**
+     * @brief Closes the innermost open element.
+     */
+    void EndElement();
+
+    /**
+     * @brief Writes an element with nothing but text.
+     */
+    void Element(const char* name, const char* text)
+    {
+        StartElement(name);
+        Text(text);
+        EndElement();
+    }
+
+    /**
+     * @brief Closes the open elements and hands over the document.
+     *
+     * @return The document; the writer is empty afterwards.
+     */
+    APIXMLDocumentPtr Finish();
+
+protected:
+    /**
+     * @brief An open element.
+     */
+    struct Open
+    {
+        std::string name;
+        /// Whether the element has element children, so its end tag goes to its own line.
+        bool children;
+    };
+
+    /// Ends the start tag of the innermost element if it is still open.
+    void _CloseStartTag();
+    /// Starts a line for a tag of an element at given depth.
+    void _NewLine(size_t depth);
+
+    void _Append(const char* data, size_t length);
+    void _Append(const char* str) { _Append(str, strlen(str)); }
+    void _AppendEscaped(const char* str);
+    /// Moves the current chunk into the document.
+    void _Flush();
+
+    std::tr1::shared_ptr<APIXMLDocument> mDocument;
+    /// The chunk being filled.
+    std::string mChunk;
+    /// The open elements, innermost last.
+    std::vector<Open> mOpen;
+    /// Whether the start tag of the innermost element is waiting for more attributes.
+    bool mStartTagOpen;
+    /// Whether the text written so far ends with a line break.
+    bool mAtLineStart;
+};
+
+#endif    //__APIXMLWRITER_H_INCL__
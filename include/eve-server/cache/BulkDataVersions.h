@@ -0,0 +1,121 @@
+/*
+    ------------------------------------------------------------------------------------
+    LICENSE:
+    ------------------------------------------------------------------------------------
+    This file is part of EVEmu: EVE Online Server Emulator
+    Copyright 2006 - 2011 The EVEmu Team
+    For the latest information visit http://evemu.org
+    ------------------------------------------------------------------------------------
+    This program is free software; you can redistribute it and/or modify it under
+    the terms of the GNU Lesser General Public License as published by the Free Software
+    Foundation; either version 2 of the License, or (at your option) any later
+    version.
+
+    This program is distributed in the hope that it will be useful, but WITHOUT
+    ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+    FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public License along with
+    this program; if not, write to the Free Software Foundation, Inc., 59 Temple
+    Place - Suite 330, Boston, MA 02111-1307, USA, or go to
+    http://www.gnu.org/copyleft/lesser.txt.
+    ------------------------------------------------------------------------------------
+    Author:     EVEmu Team
+*/
+
+#ifndef __BULK_DATA_VERSIONS_H_INCL__
+#define __BULK_DATA_VERSIONS_H_INCL__
+
+/**
+ * @brief History of changes of the bulk data.
+ *
+ * Every time the versions of the bulk data objects change, a new change
+ * is recorded, with its own changeID, a hash of all the versions and
+ * the set of objects which changed. A client which reports the hash
+ * of an older change then needs only the objects changed since.
+ *
+ * @author EVEmu Team
+ */
+class BulkDataVersions
+{
+public:
+    /// Versions of the objects, by object ID.
+    typedef std::map<std::string, uint32> VersionMap;
+
+    /// Number of the most recent changes kept.
+    static const size_t MAX_CHANGES = 32;
+
+    BulkDataVersions();
+
+    /** @return ID of the current change; 0 if there is none yet. */
+    uint32 GetChangeID() const;
+    /** @return Hash of the current versions; empty if there is no change yet. */
+    std::string GetHash() const;
+
+    /**
+     * @brief Reads the history from a file.
+     *
+     * @param[in] filename Name of the file.
+     *
+     * @return False if the file could not be read; the history is empty then.
+     */
+    bool Load(const std::string &filename);
+    /**
+     * @brief Writes the history into a file.
+     *
+     * @param[in] filename Name of the file.
+     *
+     * @return True on success, false on failure.
+     */
+    bool Save(const std::string &filename) const;
+
+    /**
+     * @brief Records the current versions of the objects.
+     *
+     * @param[in] versions The versions of all the objects.
+     *
+     * @return True if they differ from the last change, so a new change was recorded.
+     */
+    bool Update(const VersionMap &versions);
+
+    /**
+     * @brief Finds the change of the given hash.
+     *
+     * @param[in]  hash     The hash.
+     * @param[out] changeID The ID of the change.
+     *
+     * @return False if no kept change has the hash.
+     */
+    bool FindChange(const std::string &hash, uint32 &changeID) const;
+    /**
+     * @brief Gets the objects changed since a change.
+     *
+     * @param[in]  changeID The ID of the change.
+     * @param[out] into     The objects changed by the later changes.
+     *
+     * @return False if the change is older than the kept history.
+     */
+    bool GetChangesSince(uint32 changeID, std::set<std::string> &into) const;
+
+    /** @return Hash of the versions. */
+    static std::string HashVersions(const VersionMap &versions);
+
+protected:
+    /**
+     * @brief A recorded change.
+     */
+    struct Change
+    {
+        uint32 changeID;
+        std::string hash;
+        /// Objects whose versions changed.
+        std::set<std::string> objects;
+    };
+
+    /// The kept changes, oldest first.
+    std::vector<Change> m_changes;
+    /// Versions since the last change.
+    VersionMap m_versions;
+};
+
+#endif /* !__BULK_DATA_VERSIONS_H_INCL__ */
@@ -27,6 +27,7 @@
 #define __BULKMGR_SERVICE_H_INCL__
 
 #include "PyService.h"
+#include "cache/BulkDataVersions.h"
 
 class BulkMgrService : public PyService
 {
@@ -48,6 +49,28 @@ protected:
     class Dispatcher;
     Dispatcher *const m_dispatch;
 
+    /**
+     * @brief Records a new change if the bulk data changed since the last one.
+     */
+    void _UpdateVersions();
+    /**
+     * @brief Gets the precompressed objects changed since a change.
+     *
+     * @param[in] changeID The change the client has.
+     *
+     * @return Deflated marshaled dict of the changed cached objects, by object ID; NULL if they could not be built.
+     */
+    const Buffer *_GetDelta(uint32 changeID);
+
+    /// History of the bulk data changes.
+    BulkDataVersions m_versions;
+    /// Name of the file the history is kept in.
+    std::string m_versionsFile;
+
+    typedef std::map<uint32, Buffer *> DeltaMap;
+    /// Deltas built so far, by the change they start at; dropped on every new change.
+    DeltaMap m_deltas;
+
     PyCallable_DECL_CALL(UpdateBulk)
 
 };
@@ -39,9 +39,26 @@ public:
 
     PyRep *GetCachableObject(const std::string &type);
 
+    /** @return True if the object is a rowset which MarshalCachableObject() can stream. */
+    bool IsStreamedObject(const std::string &type) const;
+    /**
+     * @brief Appends the marshal stream of a cachable rowset, streaming its rows.
+     *
+     * Gives the same bytes as marshaling GetCachableObject() would,
+     * but neither the rows nor the rowset are ever held whole.
+     *
+     * @return False on failure or if the object is not streamed.
+     */
+    bool MarshalCachableObject(const std::string &type, Buffer &into);
+
 protected:
     typedef PyRep *(ObjCacheDB::* genFunc)();
     std::map<std::string, genFunc> m_generators;
+    /// Queries of the objects which are plain rowsets of big tables.
+    std::map<std::string, const char*> m_streamedQueries;
+
+    /// Builds a rowset of streamed object for GetCachableObject().
+    PyRep *_GenerateCRowset(const std::string &type, const char *query);
 
     //hack:
     PyRep *DBResultToRowsetTuple(DBQueryResult &result);
@@ -61,7 +78,6 @@ protected:
     PyRep *Generate_Schematics();
     PyRep *Generate_Schematicstypemap();
     PyRep *Generate_Sounds();
-    PyRep *Generate_Invtypematerials();
     PyRep *Generate_Ownericons();
     PyRep *Generate_Icons();
     PyRep *Generate_CharNewExtraRaceSkills();
@@ -75,8 +91,6 @@ protected:
     PyRep *Generate_invCategories();
     PyRep *Generate_invTypeReactions();
 
-    PyRep *Generate_dgmTypeAttribs();
-    PyRep *Generate_dgmTypeEffects();
     PyRep *Generate_dgmEffects();
     PyRep *Generate_dgmAttribs();
 
@@ -89,27 +103,21 @@ protected:
     PyRep *Generate_ramCompletedStatuses();
     PyRep *Generate_ramTypeRequirements();
 
-    PyRep *Generate_mapCelestialDescriptions();
     PyRep *Generate_tickerNames();
     PyRep *Generate_invGroups();
     PyRep *Generate_certificates();
     PyRep *Generate_certificateRelationships();
     PyRep *Generate_invShipTypes();
-    PyRep *Generate_cacheLocations();
-    PyRep *Generate_locationWormholeClasses();
     PyRep *Generate_invBlueprintTypes();
     PyRep *Generate_eveGraphics();
-    PyRep *Generate_invTypes();
     PyRep *Generate_invMetaTypes();
     PyRep *Generate_chrBloodlines();
     PyRep *Generate_eveUnits();
     PyRep *Generate_eveBulkDataUnits();
-    PyRep *Generate_cacheOwners();
     PyRep *Generate_eveStaticOwners();
     PyRep *Generate_chrRaces();
     PyRep *Generate_chrAttributes();
     PyRep *Generate_invFlags();
-    PyRep *Generate_eveStaticLocations();
     PyRep *Generate_invContrabandTypes();
 
     PyRep *Generate_c_chrBloodlines();
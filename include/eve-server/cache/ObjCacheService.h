@@ -53,15 +53,43 @@ public:
     ObjCacheService(PyServiceMgr *mgr, const char *cacheDir);
     virtual ~ObjCacheService();
 
-    void PrimeCache();
+    /**
+     * @brief Loads all the cachable objects.
+     *
+     * The big rowsets are queried, marshaled and deflated by sDBAsync's
+     * worker threads and installed by the game thread as they finish,
+     * so the objects primed already may be served while the rest are
+     * still being built. The other objects are loaded right away.
+     */
+    virtual void PrimeCache();
+    /**
+     * @return Generation of the cache, bumped whenever an object changes.
+     *
+     * Replies which embed cache hints are rebuilt once it changes.
+     */
+    uint32 GetGeneration() const { return m_cache.GetGeneration(); }
+    /** @return Number of objects PrimeCache() is still building. */
+    size_t GetPrimingCount() const { return m_priming.size(); }
 
     //function provided to other services:
     typedef enum {
         hLoginCachables,
         hCharCreateCachables,
         hCharCreateNewExtraCachables,
-        hAppearanceCachables
+        hAppearanceCachables,
+
+        hintSetCount
     } hintSet;
+    /**
+     * @brief Adds the hints of the objects of a hint set to a dict.
+     *
+     * The hints are built once per version of the cache (see
+     * CachedObjectMgr::GetGeneration()) and shared by all replies,
+     * so logins only take references to them.
+     *
+     * @param[in]  hset The hint set.
+     * @param[out] into The dict which receives the hints, by cache key.
+     */
     void InsertCacheHints(hintSet hset, PyDict *into);
 
     PyRep *GetCacheHint(const PyRep* objectID);
@@ -76,6 +104,41 @@ public:
     void InvalidateCache(const PyRep *objectID);
     void InvalidateCache(const ObjectCachedMethodID &m) { InvalidateCache(m.objectID); }
 
+    /**
+     * @brief Gets the versions of the bulk data objects (config.BulkData.*).
+     *
+     * @param[out] into The versions, by object ID.
+     *
+     * @return False if some of them are not loaded yet.
+     */
+    bool GetBulkDataVersions(std::map<std::string, uint32> &into) const;
+    /** @return The cached object; NULL if it is not loaded. */
+    PyObject *GetCachedObject(const std::string &objectID) { return m_cache.GetCachedObject(objectID); }
+
+    /**
+     * @brief Records that the object is built from rows of a table.
+     *
+     * The dependencies are forgotten once the object is invalidated,
+     * so they must be added again whenever it is rebuilt.
+     *
+     * @param[in] objectID The object.
+     * @param[in] table    The table.
+     * @param[in] key      The key of the rows; 0 for the whole table.
+     */
+    void AddCacheDependency(const PyRep *objectID, const char *table, uint32 key = 0);
+    void AddCacheDependency(const ObjectCachedMethodID &m, const char *table, uint32 key = 0) { AddCacheDependency(m.objectID, table, key); }
+    /**
+     * @brief Invalidates the objects built from changed rows of a table.
+     *
+     * Objects rebuilt with the same contents keep their version.
+     *
+     * @param[in] table The table.
+     * @param[in] key   The key of the changed rows; 0 if any rows changed.
+     *
+     * @return Number of invalidated objects.
+     */
+    size_t InvalidateCacheDependents(const char *table, uint32 key = 0);
+
     void GiveCache(const PyRep *objectID, PyRep **contents);
     void GiveCache(const ObjectCachedMethodID &m, PyRep **contents) { GiveCache(m.objectID, contents); }
     void GiveCache(const ObjectCachedSessionMethodID &m, PyRep **contents) { GiveCache(m.objectID, contents); }
@@ -106,6 +169,45 @@ protected:
     CachedObjectMgr m_cache;
 
     bool _LoadCachableObject(const PyRep *objectID);
+    void _SaveCachableObject(const PyRep *objectID);
+
+    /// Hints of the objects of a hint set.
+    struct HintSet {
+        HintSet() : generation(0) {}
+
+        /// Generation of m_cache the hints were built for; 0 if never built.
+        uint32 generation;
+        /// The cache keys and the hints; we own both.
+        std::vector<std::pair<PyRep *, PyRep *> > hints;
+    };
+    void _BuildHintSet(hintSet hset, HintSet &into);
+    static void _ClearHintSet(HintSet &set);
+
+    HintSet m_hintSets[hintSetCount];
+
+    class PrimeQuery;
+    void _PrimeComplete(PrimeQuery &job, bool success);
+    void _LogPrimeTimings();
+
+    /// Time taken by one object in PrimeCache().
+    struct PrimeTiming {
+        /// Where the object was built: "file", "main" or "worker".
+        const char *source;
+        /// Time (in microseconds) spent on querying and marshaling.
+        uint64 buildTime;
+        /// Time (in microseconds) spent on deflating.
+        uint64 deflateTime;
+        /// Time (in microseconds) since PrimeCache() started until the object was installed.
+        uint64 readyTime;
+    };
+    typedef std::map<std::string, PrimeTiming> PrimeTimingMap;
+
+    /// Objects being built by the worker threads.
+    std::set<std::string> m_priming;
+    /// Timings of the objects primed so far.
+    PrimeTimingMap m_primeTimings;
+    /// When (in microseconds) PrimeCache() started.
+    uint64 m_primeStart;
 
     typedef std::map<std::string, std::string>  CacheKeysMap;
     typedef CacheKeysMap::iterator              CacheKeysMapItr;
@@ -0,0 +1,161 @@
+/*
+    ------------------------------------------------------------------------------------
+    LICENSE:
+    ------------------------------------------------------------------------------------
+    This file is part of EVEmu: EVE Online Server Emulator
+    Copyright 2006 - 2011 The EVEmu Team
+    For the latest information visit http://evemu.org
+    ------------------------------------------------------------------------------------
+    This program is free software; you can redistribute it and/or modify it under
+    the terms of the GNU Lesser General Public License as published by the Free Software
+    Foundation; either version 2 of the License, or (at your option) any later
+    version.
+
+    This program is distributed in the hope that it will be useful, but WITHOUT
+    ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+    FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public License along with
+    this program; if not, write to the Free Software Foundation, Inc., 59 Temple
+    Place - Suite 330, Boston, MA 02111-1307, USA, or go to
+    http://www.gnu.org/copyleft/lesser.txt.
+    ------------------------------------------------------------------------------------
+    Author:     EVEmu Team
+*/
+
+
+#ifndef __CHARACTER__CERTIFICATE_GRAPH_H__INCL__
+#define __CHARACTER__CERTIFICATE_GRAPH_H__INCL__
+
+#include "utils/Singleton.h"
+
+/**
+ * @brief The certificate requirements, compiled into bitsets.
+ *
+ * Every certificate requires skills at some levels and other
+ * certificates (certificateRelationShips). At startup every
+ * (skill, level) pair gets a bit and every certificate gets a bit,
+ * and the requirements of a certificate become a few masks over
+ * those bits. The certificates are ordered so that prerequisites come
+ * first, so a single pass evaluates any number of certificates.
+ *
+ * The skill bits of a character set every level up to the trained
+ * one, so "at least level N" is a single bit test.
+ *
+ * Not thread-safe; meant to be used from the main loop.
+ *
+ * @author EVEmu Team
+ */
+class CertificateGraph
+: public Singleton< CertificateGraph >
+{
+public:
+    /// Bitset of the trained skill levels of a character.
+    typedef std::vector< uint64 > SkillBits;
+
+    /**
+     * @brief Statistics of the evaluations.
+     */
+    struct Stats
+    {
+        Stats() { Reset(); }
+
+        void Reset()
+        {
+            evaluations = 0;
+            granted = 0;
+            refused = 0;
+        }
+
+        /// Number of evaluations.
+        uint32 evaluations;
+        /// Number of certificates found grantable.
+        uint32 granted;
+        /// Number of asked certificates whose requirements were not met.
+        uint32 refused;
+    };
+
+    CertificateGraph();
+
+    /** @return Number of certificates. */
+    size_t size() const { return mCertificates.size(); }
+    /** @return Number of (skill, level) bits. */
+    size_t GetSkillBitCount() const { return mSkillIndex.size() * MAX_SKILL_LEVEL; }
+    /** @return Statistics since the last ResetStats(). */
+    const Stats& stats() const { return mStats; }
+    /** @brief Resets the statistics. */
+    void ResetStats() { mStats.Reset(); }
+
+    /**
+     * @brief Loads and compiles the requirements.
+     *
+     * @return True on success.
+     */
+    bool Load();
+
+    /**
+     * @brief Builds the skill bits of a character.
+     *
+     * @param[in] skills Trained levels, by skill typeID.
+     * @param[out] into  The bits.
+     */
+    void BuildSkillBits( const std::map< uint32, uint32 >& skills, SkillBits& into ) const;
+
+    /**
+     * @brief Evaluates certificates in a single pass, prerequisites first.
+     *
+     * A certificate may be granted if the skills are trained and every
+     * prerequisite is held already or may be granted along with it.
+     *
+     * @param[in] skills The skill bits of the character.
+     * @param[in] held   The certificates the character holds.
+     * @param[in] wanted The certificates asked for; NULL for all of them.
+     * @param[out] into  The wanted certificates which may be granted, prerequisites first.
+     */
+    void Evaluate( const SkillBits& skills, const std::set< uint32 >& held, const std::set< uint32 >* wanted, std::vector< uint32 >& into );
+
+protected:
+    static const uint32 MAX_SKILL_LEVEL = 5;
+
+    /**
+     * @brief Bits required from one word of a bitset.
+     */
+    struct Mask
+    {
+        uint32 word;
+        uint64 bits;
+    };
+
+    /**
+     * @brief A compiled certificate.
+     */
+    struct Certificate
+    {
+        uint32 certificateID;
+        /// Required skill bits.
+        std::vector< Mask > skills;
+        /// Required certificate bits.
+        std::vector< Mask > prerequisites;
+    };
+
+    /// Adds a bit to masks, merging masks of the same word.
+    static void _AddBit( std::vector< Mask >& into, uint32 bit );
+    /// Checks that all the bits of masks are set.
+    static bool _HasBits( const std::vector< uint64 >& bits, const std::vector< Mask >& masks );
+
+    /// The certificates, prerequisites first; the position is the certificate bit.
+    std::vector< Certificate > mCertificates;
+    /// Certificate bits, by certificateID.
+    std::tr1::unordered_map< uint32, uint32 > mCertificateIndex;
+    /// Skill indexes, by skill typeID; the bit of a level is index * MAX_SKILL_LEVEL + level - 1.
+    std::tr1::unordered_map< uint32, uint32 > mSkillIndex;
+
+    /// Statistics.
+    Stats mStats;
+};
+
+/// A macro for easier access to the singleton.
+#define sCertificateGraph \
+    ( CertificateGraph::get() )
+
+#endif /* !__CHARACTER__CERTIFICATE_GRAPH_H__INCL__ */
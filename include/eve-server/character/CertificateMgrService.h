@@ -29,6 +29,8 @@
 #include "character/CertificateMgrDB.h"
 #include "PyService.h"
 
+class ObjectCachedMethodID;
+
 class CertificateMgrService
 : public PyService
 {
@@ -36,6 +38,8 @@ public:
     CertificateMgrService(PyServiceMgr *mgr);
     ~CertificateMgrService();
 
+    virtual void PrimeCache();
+
 protected:
     class Dispatcher;
     Dispatcher *const m_dispatch;
@@ -51,6 +55,10 @@ protected:
     PyCallable_DECL_CALL(BatchCertificateUpdate)
     PyCallable_DECL_CALL(GetCertificatesByCharacter)
 
+    void _CacheCertificateCategories(const ObjectCachedMethodID &method_id);
+    void _CacheAllShipCertificateRecommendations(const ObjectCachedMethodID &method_id);
+    void _CacheCertificateClasses(const ObjectCachedMethodID &method_id);
+
     bool _GrantCertificate(uint32 characterID, uint32 certificateID);
     bool _UpdateCertificate(uint32 characterID, uint32 certificateID, bool pub);
 };
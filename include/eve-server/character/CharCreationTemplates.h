@@ -0,0 +1,209 @@
+/*
+    ------------------------------------------------------------------------------------
+    LICENSE:
+    ------------------------------------------------------------------------------------
+    This file is part of EVEmu: EVE Online Server Emulator
+    Copyright 2006 - 2011 The EVEmu Team
+    For the latest information visit http://evemu.org
+    ------------------------------------------------------------------------------------
+    This program is free software; you can redistribute it and/or modify it under
+    the terms of the GNU Lesser General Public License as published by the Free Software
+    Foundation; either version 2 of the License, or (at your option) any later
+    version.
+
+    This program is distributed in the hope that it will be useful, but WITHOUT
+    ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+    FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public License along with
+    this program; if not, write to the Free Software Foundation, Inc., 59 Temple
+    Place - Suite 330, Boston, MA 02111-1307, USA, or go to
+    http://www.gnu.org/copyleft/lesser.txt.
+    ------------------------------------------------------------------------------------
+    Author:     EVEmu Team
+*/
+
+
+#ifndef __CHARACTER__CHAR_CREATION_TEMPLATES_H__INCL__
+#define __CHARACTER__CHAR_CREATION_TEMPLATES_H__INCL__
+
+#include "utils/Singleton.h"
+
+class CharacterData;
+class CharacterType;
+
+/**
+ * @brief Resident templates of the new characters.
+ *
+ * Everything a new character starts from is loaded at startup: the
+ * careers and corporations of the schools, the starting locations
+ * of the careers and corporations, the attribute bonuses of the
+ * ancestries and the starting skills of the races, careers and
+ * career specialities (raceSkills, careerSkills, specialitySkills).
+ * The configured starting corporation and station are resolved at
+ * load time too, so setting up a character queries nothing.
+ *
+ * The skills of a race, career and speciality are merged into a
+ * template the first time a character of them is set up; levels
+ * given by several of them add up to at most 5.
+ *
+ * Not thread-safe; meant to be used from the main loop.
+ *
+ * @author EVEmu Team
+ */
+class CharCreationTemplates
+: public Singleton< CharCreationTemplates >
+{
+public:
+    /// Starting skill levels, by skill typeID.
+    typedef std::map< uint32, uint32 > SkillMap;
+
+    /**
+     * @brief Statistics of the templates.
+     */
+    struct Stats
+    {
+        Stats() { Reset(); }
+
+        void Reset()
+        {
+            setups = 0;
+            failures = 0;
+            merges = 0;
+        }
+
+        /// Number of characters set up.
+        uint32 setups;
+        /// Number of set ups which failed on an unknown career or ancestry.
+        uint32 failures;
+        /// Number of skill templates merged.
+        uint32 merges;
+    };
+
+    /**
+     * @brief What a new character starts with.
+     */
+    struct Start
+    {
+        uint8 intelligence;
+        uint8 charisma;
+        uint8 perception;
+        uint8 memory;
+        uint8 willpower;
+
+        /// The starting skills; owned by the templates.
+        const SkillMap* skills;
+    };
+
+    CharCreationTemplates();
+
+    /** @return Number of careers a character may start in. */
+    size_t size() const { return mCareers.size(); }
+    /** @return Statistics since the last ResetStats(). */
+    const Stats& stats() const { return mStats; }
+    /** @brief Resets the statistics. */
+    void ResetStats() { mStats.Reset(); }
+
+    /**
+     * @brief Loads the templates.
+     *
+     * @return True on success.
+     */
+    bool Load();
+
+    /**
+     * @brief Sets up a new character.
+     *
+     * Gives the character the career of its school, and the corporation
+     * and location the configuration asks for.
+     *
+     * @param[in]     type  Type of the character; gives its race and base attributes.
+     * @param[in,out] cdata Data of the character; its schoolID and ancestryID are read.
+     * @param[out]    into  What the character starts with.
+     *
+     * @return False if the career or the ancestry of the character is unknown.
+     */
+    bool Setup( const CharacterType& type, CharacterData& cdata, Start& into );
+
+protected:
+    /**
+     * @brief A starting location.
+     */
+    struct Location
+    {
+        uint32 stationID;
+        uint32 solarSystemID;
+        uint32 constellationID;
+        uint32 regionID;
+    };
+
+    /**
+     * @brief Where a career starts.
+     */
+    struct Career
+    {
+        uint32 corporationID;
+        uint32 schoolID;
+        uint32 allianceID;
+        Location location;
+    };
+
+    /**
+     * @brief Attribute bonuses of an ancestry.
+     */
+    struct Ancestry
+    {
+        uint8 intelligence;
+        uint8 charisma;
+        uint8 perception;
+        uint8 memory;
+        uint8 willpower;
+    };
+
+    /// Loads skill levels by the first column; levels of a skill add up to at most 5.
+    static bool _LoadSkills( const char* query, std::map< uint32, SkillMap >& into );
+    /// Adds skill levels, which add up to at most 5.
+    static void _AddSkills( const SkillMap& from, SkillMap& into );
+
+    static uint64 _TemplateKey( uint32 raceID, uint32 careerID, uint32 specialityID )
+    {
+        return ( (uint64)raceID << 42 ) | ( (uint64)careerID << 21 ) | specialityID;
+    }
+
+    /// Puts the character at a station; false if the station is unknown.
+    bool _SetLocation( uint32 stationID, CharacterData& cdata ) const;
+
+    /// Careers by schoolID.
+    std::map< uint32, uint32 > mSchoolCareers;
+    /// Corporations by schoolID.
+    std::map< uint32, uint32 > mSchoolCorporations;
+    /// Careers by careerID.
+    std::map< uint32, Career > mCareers;
+    /// Stations of the corporations by corporationID.
+    std::map< uint32, uint32 > mCorporationStations;
+    /// Locations of the stations by stationID.
+    std::map< uint32, Location > mStations;
+    /// Ancestries by ancestryID.
+    std::map< uint32, Ancestry > mAncestries;
+
+    /// Skills by raceID, careerID and specialityID.
+    std::map< uint32, SkillMap > mRaceSkills;
+    std::map< uint32, SkillMap > mCareerSkills;
+    std::map< uint32, SkillMap > mSpecialitySkills;
+    /// Merged skill templates, by _TemplateKey().
+    std::map< uint64, SkillMap > mTemplates;
+
+    /// The configured starting corporation if it exists, otherwise 0.
+    uint32 mStartCorporation;
+    /// The configured starting station if it exists, otherwise 0.
+    uint32 mStartStation;
+
+    /// Statistics.
+    Stats mStats;
+};
+
+/// A macro for easier access to the singleton.
+#define sCharCreationTemplates \
+    ( CharCreationTemplates::get() )
+
+#endif /* !__CHARACTER__CHAR_CREATION_TEMPLATES_H__INCL__ */
@@ -0,0 +1,134 @@
+/*
+    ------------------------------------------------------------------------------------
+    LICENSE:
+    ------------------------------------------------------------------------------------
+    This file is part of EVEmu: EVE Online Server Emulator
+    Copyright 2006 - 2011 The EVEmu Team
+    For the latest information visit http://evemu.org
+    ------------------------------------------------------------------------------------
+    This program is free software; you can redistribute it and/or modify it under
+    the terms of the GNU Lesser General Public License as published by the Free Software
+    Foundation; either version 2 of the License, or (at your option) any later
+    version.
+
+    This program is distributed in the hope that it will be useful, but WITHOUT
+    ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+    FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public License along with
+    this program; if not, write to the Free Software Foundation, Inc., 59 Temple
+    Place - Suite 330, Boston, MA 02111-1307, USA, or go to
+    http://www.gnu.org/copyleft/lesser.txt.
+    ------------------------------------------------------------------------------------
+    Author:     EVEmu Team
+*/
+
+
+#ifndef __CHARACTER__CHAR_SELECT_CACHE_H__INCL__
+#define __CHARACTER__CHAR_SELECT_CACHE_H__INCL__
+
+#include "utils/Singleton.h"
+
+/**
+ * @brief Resident cache of the character selection screen.
+ *
+ * Keeps the rowsets GetCharactersToSelect (by account) and
+ * GetCharacterToSelect (by character) return, so a login does not
+ * run their joins. All of them are built at startup with one query
+ * each, so the logins after a downtime are served from memory.
+ *
+ * An entry is dropped when the character logs off, is created,
+ * deleted or (un)prepared for deletion, and is rebuilt by the next
+ * request. The rowsets are shared; callers get a new reference and
+ * must not modify it.
+ *
+ * Not thread-safe; meant to be used from the main loop.
+ *
+ * @author EVEmu Team
+ */
+class CharSelectCache
+: public Singleton< CharSelectCache >
+{
+public:
+    /**
+     * @brief Statistics of the cache.
+     */
+    struct Stats
+    {
+        Stats() { Reset(); }
+
+        void Reset()
+        {
+            hits = 0;
+            misses = 0;
+            invalidations = 0;
+        }
+
+        /// Number of requests served from the cache.
+        uint32 hits;
+        /// Number of requests which queried the database.
+        uint32 misses;
+        /// Number of entries dropped.
+        uint32 invalidations;
+    };
+
+    CharSelectCache();
+    ~CharSelectCache();
+
+    /** @return Number of cached rowsets. */
+    size_t size() const { return mLists.size() + mInfos.size(); }
+    /** @return Statistics since the last ResetStats(). */
+    const Stats& stats() const { return mStats; }
+    /** @brief Resets the statistics. */
+    void ResetStats() { mStats.Reset(); }
+
+    /**
+     * @brief Builds the rowsets of all the accounts and characters.
+     *
+     * @return True on success.
+     */
+    bool Load();
+
+    /**
+     * @return The characters of an account (GetCharactersToSelect); NULL on error.
+     */
+    PyRep* GetCharacterList( uint32 accountID );
+    /**
+     * @return The selection screen info of a character (GetCharacterToSelect); NULL on error.
+     */
+    PyRep* GetCharSelectInfo( uint32 characterID );
+
+    /** @brief Drops the character list of an account. */
+    void InvalidateAccount( uint32 accountID );
+    /** @brief Drops the info of a character and the character list of its account. */
+    void InvalidateCharacter( uint32 characterID );
+
+protected:
+    typedef std::tr1::unordered_map< uint32, PyRep* > RowsetMap;
+
+    /**
+     * @brief Splits a result by its last column into rowsets of the other columns.
+     *
+     * @param[in]  res  The result, with rows of the same key next to each other.
+     * @param[out] into The rowsets by key.
+     */
+    static void _SplitResult( DBQueryResult& res, RowsetMap& into );
+
+    static void _Drop( RowsetMap& map, uint32 key );
+
+    /// Character lists by accountID.
+    RowsetMap mLists;
+    /// Selection screen infos by characterID.
+    RowsetMap mInfos;
+    /// accountIDs of the characters, by characterID.
+    std::tr1::unordered_map< uint32, uint32 > mAccounts;
+
+    /// Statistics.
+    Stats mStats;
+};
+
+/// A macro for easier access to the singleton.
+#define sCharSelectCache \
+    ( CharSelectCache::get() )
+
+#endif /* !__CHARACTER__CHAR_SELECT_CACHE_H__INCL__ */
@@ -385,8 +385,20 @@ public:
     /*
      * Primary public interface:
      */
-    bool AlterBalance(double balanceChange);
-    void SetLocation(uint32 stationID, uint32 solarSystemID, uint32 constellationID, uint32 regionID);
+    /**
+     * @brief Changes the balance.
+     *
+     * @param[in] balanceChange The change; the balance may not end up negative.
+     * @param[in] save          Whether to save the character; a market trade
+     *                          writes the change through MarketJournal instead.
+     *
+     * @return False if the balance is too low.
+     */
+    bool AlterBalance(double balanceChange, bool save = true);
+    /**
+     * @param[in] save False if the caller saves the location, see InventoryDB::SaveCharacterLocations.
+     */
+    void SetLocation(uint32 stationID, uint32 solarSystemID, uint32 constellationID, uint32 regionID, bool save = true);
     void JoinCorporation(uint32 corporationID);
     void SetDescription(const char *newDescription);
 
@@ -479,6 +491,17 @@ public:
      * @author almamu
      */
     bool GrantCertificate( uint32 certificateID );
+    /**
+     * @brief Grants the certificates whose requirements are met.
+     *
+     * The requirements are evaluated by CertificateGraph in a single
+     * pass; prerequisites granted along count as held. The granted
+     * certificates are written by a single statement.
+     *
+     * @param[in] certificateIDs The asked certificates.
+     * @param[out] granted       The granted ones.
+     */
+    void GrantCertificates( const std::vector<uint32> &certificateIDs, std::vector<uint32> &granted );
     /* UpdateCertificate( uint32 certificateID, bool pub )
      *
      * This will change the public status of the certificate
@@ -688,6 +711,9 @@ protected:
 
     // Skill queue:
     SkillQueue m_skillQueue;
+    // The skill queue as stored in DB, so that saves only write the difference:
+    mutable SkillQueue m_savedSkillQueue;
+    mutable uint32 m_skillQueueFirstIndex;
     EvilNumber m_totalSPtrained;
 
     Certificates m_certificates;
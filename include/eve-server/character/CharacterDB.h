@@ -40,13 +40,28 @@ class CharacterDB : public ServiceDB
 public:
     CharacterDB();
 
-    PyRep *GetCharacterList(uint32 accountID);
-    PyRep *GetCharSelectInfo(uint32 characterID);
+    static PyRep *GetCharacterList(uint32 accountID);
+    static PyRep *GetCharSelectInfo(uint32 characterID);
+    /**
+     * Queries GetCharacterList() of all the accounts at once, ordered by accountID.
+     *
+     * @param[out] res The rows, with the accountID as an extra last column.
+     * @return true on success.
+     */
+    static bool GetAllCharacterLists(DBQueryResult &res);
+    /**
+     * Queries GetCharSelectInfo() of all the characters at once.
+     *
+     * @param[out] res The rows, with the characterID as an extra last column.
+     * @return true on success.
+     */
+    static bool GetAllCharSelectInfo(DBQueryResult &res);
     PyObject *GetCharPublicInfo(uint32 characterID);
     PyObject *GetCharPublicInfo3(uint32 characterID);
     //PyObject *GetAgentPublicInfo(uint32 agentID);
     PyObject *GetOwnerNoteLabels(uint32 charID);
     PyObject *GetOwnerNote(uint32 charID, uint32 noteID);
+    PyObjectEx *GetContacts(uint32 charID);
 
     bool GetCharClones(uint32 characterID, std::vector<uint32> &into);
     bool GetActiveClone(uint32 characterID, uint32 &itemID);
@@ -138,6 +153,10 @@ public:
     bool GetRespecInfo(uint32 characterId, uint32& out_freeRespecs, uint64& out_nextRespec);
 
 private:
+    /* runs the query of GetCharSelectInfo() with extra columns and a WHERE/ORDER BY clause.
+     */
+    static bool _QueryCharSelectInfo(DBQueryResult &res, const char *extraColumns, const char *condition);
+
     /**
      * djb2 algorithm taken from http://www.cse.yorku.ca/~oz/hash.html slightly modified
      *
@@ -0,0 +1,175 @@
+/*
+    ------------------------------------------------------------------------------------
+    LICENSE:
+    ------------------------------------------------------------------------------------
+    This file is part of EVEmu: EVE Online Server Emulator
+    Copyright 2006 - 2011 The EVEmu Team
+    For the latest information visit http://evemu.org
+    ------------------------------------------------------------------------------------
+    This program is free software; you can redistribute it and/or modify it under
+    the terms of the GNU Lesser General Public License as published by the Free Software
+    Foundation; either version 2 of the License, or (at your option) any later
+    version.
+
+    This program is distributed in the hope that it will be useful, but WITHOUT
+    ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+    FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public License along with
+    this program; if not, write to the Free Software Foundation, Inc., 59 Temple
+    Place - Suite 330, Boston, MA 02111-1307, USA, or go to
+    http://www.gnu.org/copyleft/lesser.txt.
+    ------------------------------------------------------------------------------------
+    Author:     EVEmu Team
+*/
+
+
+#ifndef __CHARACTER__LOGIN_PIPELINE_H__INCL__
+#define __CHARACTER__LOGIN_PIPELINE_H__INCL__
+
+#include "utils/Singleton.h"
+
+class Client;
+
+/**
+ * @brief Runs the selection of characters in stages.
+ *
+ * A login goes through:
+ *  - prefetch: the character, its ship, their contents and
+ *    attributes are queried by sDBAsync's worker threads
+ *    (see InventoryDB::GetLoginItems());
+ *  - system: if the solar system of the character is not booted,
+ *    its state is preloaded by the SystemPreloader meanwhile and
+ *    the login waits for it;
+ *  - attach: Client::SelectCharacter() runs on the game thread,
+ *    loading out of what has been fetched instead of querying.
+ *
+ * Many logins may be in flight at once; at most a few are attached
+ * per tick, so a login storm does not stall the simulation.
+ *
+ * Not thread-safe; meant to be used from the main loop.
+ *
+ * @author EVEmu Team
+ */
+class LoginPipeline
+: public Singleton< LoginPipeline >
+{
+public:
+    /**
+     * @brief Statistics of the logins; times are in milliseconds.
+     */
+    struct Stats
+    {
+        Stats() { Reset(); }
+
+        void Reset()
+        {
+            started = 0;
+            completed = 0;
+            failed = 0;
+            cancelled = 0;
+            prefetchTime = 0;
+            maxPrefetchTime = 0;
+            systemWaitTime = 0;
+            maxSystemWaitTime = 0;
+            attachTime = 0;
+            maxAttachTime = 0;
+        }
+
+        /// Number of logins started.
+        uint32 started;
+        /// Number of logins attached.
+        uint32 completed;
+        /// Number of logins which failed.
+        uint32 failed;
+        /// Number of logins dropped as their client left.
+        uint32 cancelled;
+        /// Time from the start until the prefetch was done.
+        uint32 prefetchTime;
+        uint32 maxPrefetchTime;
+        /// Time spent waiting for the solar system.
+        uint32 systemWaitTime;
+        uint32 maxSystemWaitTime;
+        /// Time the game thread spent attaching.
+        uint32 attachTime;
+        uint32 maxAttachTime;
+    };
+
+    LoginPipeline();
+
+    /** @return Number of logins in flight. */
+    size_t size() const { return mLogins.size(); }
+    /** @return Statistics since the last ResetStats(). */
+    const Stats& stats() const { return mStats; }
+    /** @brief Resets the statistics. */
+    void ResetStats() { mStats.Reset(); }
+
+    /**
+     * @brief Starts the login of a character.
+     *
+     * Does nothing if the client is logging in already.
+     *
+     * @param[in] client      The client.
+     * @param[in] characterID The selected character.
+     */
+    void Start( Client* client, uint32 characterID );
+    /**
+     * @brief Drops the login of a client which is going away.
+     */
+    void Cancel( Client* client );
+
+    /**
+     * @brief Attaches the logins which are ready.
+     *
+     * Must be called periodically by the game thread.
+     */
+    void Process();
+
+protected:
+    class PrefetchQuery;
+
+    enum Stage
+    {
+        STAGE_PREFETCH,
+        STAGE_SYSTEM,
+        STAGE_ATTACH
+    };
+
+    /**
+     * @brief A login in flight.
+     */
+    struct Login
+    {
+        Client* client;
+        uint32 characterID;
+        uint8 stage;
+        /// Time (in microseconds) the current stage started.
+        uint64 stageStarted;
+
+        uint32 solarSystemID;
+        /// What has been handed to the ItemFactory, to be discarded after the attach.
+        std::vector<uint32> containerIDs;
+        std::vector<uint32> itemIDs;
+    };
+
+    void _Complete( PrefetchQuery& query, bool success );
+    /** @brief Runs the attach stage and forgets the login. */
+    void _Attach( uint32 ticket );
+
+    /** @brief Accounts the time of a stage which started at @a since. */
+    static void _Account( uint64 since, uint32& total, uint32& max );
+
+    /// The logins, by ticket.
+    std::map< uint32, Login > mLogins;
+    /// Ticket of the next login.
+    uint32 mNextTicket;
+
+    /// Statistics.
+    Stats mStats;
+};
+
+/// A macro for easier access to the singleton.
+#define sLoginPipeline \
+    ( LoginPipeline::get() )
+
+#endif /* !__CHARACTER__LOGIN_PIPELINE_H__INCL__ */
@@ -33,6 +33,21 @@ class PaperDollDB: public ServiceDB
 {
 public:
     PyRep* GetMyPaperDollData() const;
+
+    /**
+     * @brief Queries the doll blobs of characters.
+     *
+     * @param[out] res Rows of characterID, version and dollData.
+     *
+     * @return True on success.
+     */
+    bool LoadDolls(const std::vector<uint32> &characterIDs, DBQueryResult &res) const;
+    /**
+     * @brief Saves the doll blob of a character.
+     *
+     * @return True on success.
+     */
+    bool SaveDoll(uint32 characterID, uint32 version, const Buffer &data) const;
 };
 
 #endif
\ No newline at end of file
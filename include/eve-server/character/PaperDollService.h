@@ -53,6 +53,9 @@ private:
     PyCallable_DECL_CALL(UpdateExistingCharacterLimited)
     PyCallable_DECL_CALL(GetPaperDollPortraitDataFor)
     PyCallable_DECL_CALL(GetMyPaperDollData)
+
+    //saves the doll of the calling character; both updates carry the whole doll
+    PyResult _UpdateDoll(PyCallArgs &call);
 };
 
 #endif // __PAPERDOLLSERVICE__H__INCL__
\ No newline at end of file
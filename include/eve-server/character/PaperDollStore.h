@@ -0,0 +1,145 @@
+/*
+    ------------------------------------------------------------------------------------
+    LICENSE:
+    ------------------------------------------------------------------------------------
+    This file is part of EVEmu: EVE Online Server Emulator
+    Copyright 2006 - 2011 The EVEmu Team
+    For the latest information visit http://evemu.org
+    ------------------------------------------------------------------------------------
+    This program is free software; you can redistribute it and/or modify it under
+    the terms of the GNU Lesser General Public License as published by the Free Software
+    Foundation; either version 2 of the License, or (at your option) any later
+    version.
+
+    This program is distributed in the hope that it will be useful, but WITHOUT
+    ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+    FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public License along with
+    this program; if not, write to the Free Software Foundation, Inc., 59 Temple
+    Place - Suite 330, Boston, MA 02111-1307, USA, or go to
+    http://www.gnu.org/copyleft/lesser.txt.
+    ------------------------------------------------------------------------------------
+    Author:     EVEmu Team
+*/
+
+
+#ifndef __CHARACTER__PAPER_DOLL_STORE_H__INCL__
+#define __CHARACTER__PAPER_DOLL_STORE_H__INCL__
+
+#include "character/PaperDollDB.h"
+#include "utils/Singleton.h"
+
+/**
+ * @brief The paper dolls of the characters, as single compressed blobs.
+ *
+ * The doll and the portrait of a character are saved together as one
+ * marshaled, deflated blob, whose version is bumped by every save.
+ * A loaded doll is kept in memory as a frozen tree, so all the replies
+ * share it until the next save; characters without a doll are kept
+ * too, so asking again costs nothing.
+ *
+ * Prefetch() loads the dolls of many characters by a single query;
+ * station guest lists use it, as the clients then ask for the
+ * portraits of all the guests at once.
+ *
+ * Not thread-safe; meant to be used from the main loop.
+ *
+ * @author EVEmu Team
+ */
+class PaperDollStore
+: public Singleton< PaperDollStore >
+{
+public:
+    /**
+     * @brief Statistics of the store.
+     */
+    struct Stats
+    {
+        Stats() { Reset(); }
+
+        void Reset()
+        {
+            hits = 0;
+            loads = 0;
+            queries = 0;
+            saves = 0;
+        }
+
+        /// Number of dolls served from memory.
+        uint32 hits;
+        /// Number of characters whose dolls were loaded.
+        uint32 loads;
+        /// Number of queries the loads took.
+        uint32 queries;
+        /// Number of dolls saved.
+        uint32 saves;
+    };
+
+    /**
+     * @brief A paper doll.
+     */
+    struct Doll
+    {
+        /// Version of the blob; 0 if the character has no doll.
+        uint32 version;
+        /// The doll; NULL if none.
+        PyRep* dollInfo;
+        /// The portrait; NULL if none.
+        PyRep* portraitInfo;
+    };
+
+    PaperDollStore();
+    ~PaperDollStore();
+
+    /** @return Number of resident dolls. */
+    size_t size() const { return mDolls.size(); }
+    /** @return Statistics since the last ResetStats(). */
+    const Stats& stats() const { return mStats; }
+    /** @brief Resets the statistics. */
+    void ResetStats() { mStats.Reset(); }
+
+    /**
+     * @brief Gets the doll of a character, loading it if necessary.
+     *
+     * @return The doll, whose trees are frozen; NULL on failure.
+     */
+    const Doll* Get( uint32 characterID );
+    /**
+     * @brief Loads the dolls of the characters which are not resident yet.
+     */
+    void Prefetch( const std::vector< uint32 >& characterIDs );
+
+    /**
+     * @brief Saves the doll of a character.
+     *
+     * @param[in] dollInfo     The doll; its ownership is taken.
+     * @param[in] portraitInfo The portrait; its ownership is taken.
+     *
+     * @return True on success.
+     */
+    bool Save( uint32 characterID, PyRep* dollInfo, PyRep* portraitInfo );
+
+    /**
+     * @brief Drops the doll of a deleted character.
+     */
+    void Forget( uint32 characterID );
+
+protected:
+    /// Loads the dolls of the characters; missing ones are kept as empty.
+    void _Load( const std::vector< uint32 >& characterIDs );
+    static void _Clear( Doll& doll );
+
+    /// The dolls, by characterID.
+    std::tr1::unordered_map< uint32, Doll > mDolls;
+
+    PaperDollDB mDB;
+    /// Statistics.
+    Stats mStats;
+};
+
+/// A macro for easier access to the singleton.
+#define sPaperDollStore \
+    ( PaperDollStore::get() )
+
+#endif /* !__CHARACTER__PAPER_DOLL_STORE_H__INCL__ */
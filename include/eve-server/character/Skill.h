@@ -69,6 +69,14 @@ public:
      * @return Amount of SP required.
      */
     EvilNumber GetSPForLevel(EvilNumber level);
+    /**
+     * Calculates required amount of skillpoints for level of a skill which is not loaded.
+     *
+     * @param[in] type Type of the skill.
+     * @param[in] level Level to calculate SP for.
+     * @return Amount of SP required.
+     */
+    static EvilNumber GetSPForLevel(const ItemType &type, EvilNumber level);
     /**
      * Checks whether requirements of skill has been fulfilled.
      *
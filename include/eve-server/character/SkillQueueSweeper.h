@@ -0,0 +1,114 @@
+/*
+    ------------------------------------------------------------------------------------
+    LICENSE:
+    ------------------------------------------------------------------------------------
+    This file is part of EVEmu: EVE Online Server Emulator
+    Copyright 2006 - 2011 The EVEmu Team
+    For the latest information visit http://evemu.org
+    ------------------------------------------------------------------------------------
+    This program is free software; you can redistribute it and/or modify it under
+    the terms of the GNU Lesser General Public License as published by the Free Software
+    Foundation; either version 2 of the License, or (at your option) any later
+    version.
+
+    This program is distributed in the hope that it will be useful, but WITHOUT
+    ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+    FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public License along with
+    this program; if not, write to the Free Software Foundation, Inc., 59 Temple
+    Place - Suite 330, Boston, MA 02111-1307, USA, or go to
+    http://www.gnu.org/copyleft/lesser.txt.
+    ------------------------------------------------------------------------------------
+    Author:     EVEmu Team
+*/
+
+#ifndef __SKILLQUEUESWEEPER_H_INCL__
+#define __SKILLQUEUESWEEPER_H_INCL__
+
+class ItemFactory;
+
+/**
+ * @brief Completes the finished skills of offline characters.
+ *
+ * Online characters are woken up by their client once the skill
+ * in training is done; the queues of the offline ones are advanced
+ * here in the background, a batch of characters at a time, so that
+ * logging in does not have to catch up with them. The characters
+ * are found by a query on sDBAsync's worker threads; a full batch
+ * makes the next one come right after, otherwise the sweep waits
+ * for the interval.
+ *
+ * Must be used by the game thread only.
+ *
+ * @author EVEmu Team
+ */
+class SkillQueueSweeper
+: protected TimerWheel::Callback
+{
+public:
+    /**
+     * @brief Statistics of the sweeps.
+     */
+    struct Stats
+    {
+        Stats() { Reset(); }
+
+        void Reset()
+        {
+            sweeps = 0;
+            characters = 0;
+            failed = 0;
+        }
+
+        /// Number of batches queried.
+        uint32 sweeps;
+        /// Number of characters whose queue was advanced.
+        uint32 characters;
+        /// Number of queries which failed.
+        uint32 failed;
+    };
+
+    /**
+     * @brief Creates a stopped sweeper.
+     *
+     * @param[in] factory The factory to load the characters through.
+     */
+    SkillQueueSweeper(ItemFactory &factory);
+
+    /** @return Statistics since the last ResetStats(). */
+    const Stats &stats() const { return m_stats; }
+
+    /**
+     * @brief Starts sweeping.
+     *
+     * @param[in] interval Time (in seconds) between sweeps; 0 stops sweeping.
+     * @param[in] batch    The most characters advanced by a sweep.
+     */
+    void Start(uint32 interval, uint32 batch);
+
+    /**
+     * @brief Resets the statistics.
+     */
+    void ResetStats() { m_stats.Reset(); }
+
+protected:
+    class SweepQuery;
+    void _Complete(SweepQuery &query, bool success);
+
+    void TimerExpired();
+
+    ItemFactory &m_factory;
+
+    /// Time (in milliseconds) between sweeps.
+    uint32 m_interval;
+    /// The most characters per sweep.
+    uint32 m_batch;
+    /// Whether a query is being run.
+    bool m_pending;
+
+    /// Statistics.
+    Stats m_stats;
+};
+
+#endif /* !__SKILLQUEUESWEEPER_H_INCL__ */
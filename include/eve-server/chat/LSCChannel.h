@@ -42,11 +42,24 @@ public:
       m_allianceID(allianceID),
       m_warFactionID(warFactionID),
       m_role(role),
-      m_extra(extra) { }
+      m_extra(extra),
+      m_quotaUntil(0) { }
 
     virtual ~LSCChannelChar() { }
     PyRep *Encode() const;
 
+    /**
+     * @brief Takes a message off the character's quota in the channel.
+     *
+     * Every message uses the quota up for a while; a burst of
+     * messages is allowed, a steady flood is not.
+     *
+     * @param[in] now Current time in milliseconds.
+     *
+     * @return False if the quota is used up and the message must not be delivered.
+     */
+    bool TakeMessage(uint64 now);
+
 protected:
     LSCChannel *m_parent;
     uint32 m_corpID;
@@ -56,6 +69,8 @@ protected:
     uint32 m_warFactionID;
     uint64 m_role;
     uint32 m_extra;
+    /// The time (in milliseconds) until which the messages sent so far use the quota up.
+    uint64 m_quotaUntil;
 };
 
 class LSCChannelMod {
@@ -86,6 +101,40 @@ protected:
 
 class LSCChannel {
 public:
+    /**
+     * @brief Statistics of the membership changes of all channels.
+     */
+    struct MembershipStats
+    {
+        MembershipStats() { Reset(); }
+
+        void Reset()
+        {
+            immediate = 0;
+            queued = 0;
+            coalesced = 0;
+            flushes = 0;
+            listEncodes = 0;
+            listHits = 0;
+        }
+
+        /// Number of joins and leaves broadcast as they happened.
+        uint32 immediate;
+        /// Number of joins and leaves queued by lazy channels.
+        uint32 queued;
+        /// Number of queued joins and leaves cancelled by a later leave or join.
+        uint32 coalesced;
+        /// Number of flushes of the queued changes.
+        uint32 flushes;
+        /// Number of member lists encoded.
+        uint32 listEncodes;
+        /// Number of member lists served from the encoded one.
+        uint32 listHits;
+    };
+
+    /// Number of members above which a channel is lazy.
+    static const uint32 LAZY_MEMBER_THRESHOLD;
+
     typedef enum {
         normal = 0,
         corp = 1,
@@ -111,6 +160,13 @@ public:
         );
     virtual ~LSCChannel();
 
+    /**
+     * @brief Accounts the channels to the "chat" MemoryTag.
+     */
+    static void* operator new( size_t size ) { return sMemoryTag.Allocate( size ); }
+    static void operator delete( void* p, size_t size ) { sMemoryTag.Free( p, size ); }
+    static MemoryTag sMemoryTag;
+
     PyRep *EncodeChannel(uint32 charID);
     PyRep *EncodeID();
 
@@ -134,6 +190,17 @@ public:
     uint32 GetTemporary() { return m_temporary; }
     uint32 GetMode() { return m_mode; }
     uint32 GetMemberCount() { return m_chars.size(); }
+    /**
+     * @brief Tells whether the channel is lazy.
+     *
+     * The joiners of a lazy channel get an empty member list and
+     * fetch it with GetMembers; its joins and leaves are queued and
+     * broadcast once per tick by FlushMembership(), a join and leave
+     * of the same character within the tick cancelling out.
+     */
+    bool IsLazy() const { return LAZY_MEMBER_THRESHOLD < m_chars.size(); }
+    /** @return True if joins or leaves are queued. */
+    bool HasPendingMembership() const { return !m_pending.empty(); }
 
     void SetOwnerID(uint32 ownerID) { m_ownerID = ownerID; }
     void SetType(Type new_type) { m_type = new_type; }
@@ -159,7 +226,14 @@ public:
 
     void Evacuate(Client * c);
     void SendMessage(Client * c, const char * message, bool self = false);
+    /**
+     * @brief Broadcasts the joins and leaves queued since the last flush.
+     */
+    void FlushMembership();
 
+    /** @return Statistics since the last ResetMembershipStats(). */
+    static const MembershipStats& membershipStats() { return s_membershipStats; }
+    static void ResetMembershipStats() { s_membershipStats.Reset(); }
 
     static OnLSC_SenderInfo *_MakeSenderInfo(Client *from);
 
@@ -183,6 +257,36 @@ protected:
 
     std::vector<LSCChannelMod> m_mods;
     std::map<uint32, LSCChannelChar> m_chars;
+    /// The clients of m_chars, kept as they join and leave, so broadcasts look nobody up.
+    std::vector<Client *> m_members;
+
+    /**
+     * @brief A join or leave queued by a lazy channel.
+     */
+    struct PendingChange
+    {
+        /// +1 for a join, -1 for a leave, 0 if they cancelled out.
+        int32 delta;
+        OnLSC_SenderInfo sender;
+    };
+
+    /// The queued joins and leaves, by characterID.
+    std::map<uint32, PendingChange> m_pending;
+    /// The encoded member list; NULL once the members change.
+    PyRep *m_encodedChars;
+
+    void _RemoveMember(uint32 charID);
+    /**
+     * @brief Broadcasts a join or leave, or queues it if the channel is lazy.
+     *
+     * @param[in] join   True for a join, false for a leave.
+     * @param[in] charID The character joining or leaving.
+     * @param[in] si     Sender info of the character; we take ownership.
+     */
+    void _ChangeMembership(bool join, uint32 charID, OnLSC_SenderInfo * si);
+    void _SendMembership(bool join, OnLSC_SenderInfo * si);
+
+    static MembershipStats s_membershipStats;
 
 
     OnLSC_SenderInfo *_FakeSenderInfo();
@@ -75,6 +75,17 @@ public:
     void CreateSystemChannel(uint32 systemID);
     void CharacterLogout(uint32 charID, OnLSC_SenderInfo * si);
 
+    /**
+     * @brief Broadcasts the joins and leaves the lazy channels queued.
+     *
+     * Meant to be called once per tick from the main loop.
+     */
+    void Process();
+    /**
+     * @brief Has a channel flushed by the next Process().
+     */
+    void QueueMembershipFlush(uint32 channelID) { m_pendingFlushes.insert(channelID); }
+
     void SendMail(uint32 sender, uint32 recipient, const std::string &subject, const std::string &content) {
         std::vector<int32> recs(1, recipient);
         SendMail(sender, recs, subject, content);
@@ -90,6 +101,8 @@ protected:
     LSCDB m_db;
 
     std::map<uint32, LSCChannel *> m_channels;  //we own these pointers
+    /// The channels with queued joins and leaves.
+    std::set<uint32> m_pendingFlushes;
 
     //make sure you add things to the constructor too
     PyCallable_DECL_CALL(GetChannels)
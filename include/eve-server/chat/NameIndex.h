@@ -0,0 +1,237 @@
+/*
+    ------------------------------------------------------------------------------------
+    LICENSE:
+    ------------------------------------------------------------------------------------
+    This file is part of EVEmu: EVE Online Server Emulator
+    Copyright 2006 - 2011 The EVEmu Team
+    For the latest information visit http://evemu.org
+    ------------------------------------------------------------------------------------
+    This program is free software; you can redistribute it and/or modify it under
+    the terms of the GNU Lesser General Public License as published by the Free Software
+    Foundation; either version 2 of the License, or (at your option) any later
+    version.
+
+    This program is distributed in the hope that it will be useful, but WITHOUT
+    ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+    FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public License along with
+    this program; if not, write to the Free Software Foundation, Inc., 59 Temple
+    Place - Suite 330, Boston, MA 02111-1307, USA, or go to
+    http://www.gnu.org/copyleft/lesser.txt.
+    ------------------------------------------------------------------------------------
+    Author:     EVEmu Team
+*/
+
+#ifndef __CHAT__NAME_INDEX_H__INCL__
+#define __CHAT__NAME_INDEX_H__INCL__
+
+#include "utils/Singleton.h"
+
+/**
+ * @brief Resident index of the names the lookup service searches.
+ *
+ * The names of the characters, corporations (and their tickers),
+ * alliances, factions, solar systems and stations are loaded at
+ * startup. Every name is indexed by the trigrams of its lowercase
+ * form, so a search only verifies the names which have the rarest
+ * trigram of the searched text instead of scanning whole tables
+ * with RLIKE. Texts shorter than a trigram scan the names of the
+ * searched kinds.
+ *
+ * The matches are ranked: exact matches first, then prefixes, then
+ * matches at the start of a word, then the rest; shorter names
+ * first within each rank.
+ *
+ * Only literal texts are served, optionally anchored by a leading
+ * '^' or a trailing '$'; the lookups return NULL for any other
+ * regular expression and for non-ASCII texts, which the callers
+ * leave to the database.
+ *
+ * Not thread-safe; meant to be used from the main loop.
+ *
+ * @author EVEmu Team
+ */
+class NameIndex
+: public Singleton< NameIndex >
+{
+public:
+    enum NameKind
+    {
+        NAME_CHARACTER,
+        NAME_CORPORATION,
+        /// Ticker of a corporation; its extra is the name of the corporation.
+        NAME_CORPORATION_TICKER,
+        NAME_ALLIANCE,
+        NAME_FACTION,
+        NAME_SOLAR_SYSTEM,
+        NAME_STATION,
+
+        NAME_KIND_COUNT
+    };
+
+    /**
+     * @brief Statistics of the index.
+     */
+    struct Stats
+    {
+        Stats() { Reset(); }
+
+        void Reset()
+        {
+            lookups = 0;
+            fallbacks = 0;
+            examined = 0;
+            updates = 0;
+        }
+
+        /// Number of lookups served from the index.
+        uint32 lookups;
+        /// Number of lookups left to the database.
+        uint32 fallbacks;
+        /// Number of names the served lookups verified.
+        uint32 examined;
+        /// Number of names added, renamed or removed.
+        uint32 updates;
+    };
+
+    NameIndex();
+
+    /** @return Number of indexed names. */
+    size_t size() const { return mSlots.size(); }
+    /** @return Statistics since the last ResetStats(). */
+    const Stats& stats() const { return mStats; }
+    /** @brief Resets the statistics. */
+    void ResetStats() { mStats.Reset(); }
+
+    /**
+     * @brief Loads all the names.
+     *
+     * @return True on success.
+     */
+    bool Load();
+
+    /**
+     * @brief Adds a name, or renames it if it is already indexed.
+     *
+     * @param[in] kind   What the name is of.
+     * @param[in] id     ID of the named entity.
+     * @param[in] name   The name.
+     * @param[in] typeID typeID of the entity; corporationType of corporations.
+     * @param[in] extra  Name of the corporation of a ticker.
+     */
+    void Add( NameKind kind, uint32 id, const std::string& name, uint32 typeID, const std::string& extra = "" );
+    /**
+     * @brief Renames an item if it is an indexed character, solar system or station.
+     *
+     * @param[in] itemID The item.
+     * @param[in] name   The new name.
+     */
+    void Rename( uint32 itemID, const std::string& name );
+    /**
+     * @brief Removes a name.
+     */
+    void Remove( NameKind kind, uint32 id );
+
+    /**
+     * @brief Looks up characters; the columns are characterID, characterName and typeID.
+     *
+     * @param[in] match       The searched text; "__ALL__" lists all player characters.
+     * @param[in] exact       Whether the name must equal the text.
+     * @param[in] playersOnly Whether to skip the characters which are not players.
+     *
+     * @return The util.Rowset; NULL if the text is left to the database.
+     */
+    PyObject* LookupCharacters( const std::string& match, bool exact, bool playersOnly );
+    /**
+     * @brief Looks up player characters, corporations and alliances; the columns are ownerID, ownerName and groupID.
+     */
+    PyObject* LookupOwners( const std::string& match, bool exact );
+    /** @brief Looks up corporations; the columns are corporationID, corporationName and corporationType. */
+    PyObject* LookupCorporations( const std::string& match );
+    /** @brief Looks up corporation tickers; the columns are corporationID, corporationName and tickerName. */
+    PyObject* LookupCorporationTickers( const std::string& match );
+    /** @brief Looks up factions; the columns are factionID and factionName. */
+    PyObject* LookupFactions( const std::string& match );
+    /** @brief Looks up stations; the columns are stationID, stationName and stationTypeID. */
+    PyObject* LookupStations( const std::string& match );
+    /**
+     * @brief Looks up solar systems and stations of a type; the columns are itemID, itemName and typeID.
+     *
+     * @return The util.Rowset; NULL if the text is left to the database or no location is of the type.
+     */
+    PyObject* LookupKnownLocations( const std::string& match, uint32 typeID );
+
+protected:
+    /**
+     * @brief An indexed name.
+     */
+    struct Entry
+    {
+        uint32 id;
+        uint8 kind;
+        uint32 typeID;
+        std::string name;
+        /// The name in lowercase, which is indexed and matched.
+        std::string lower;
+        std::string extra;
+    };
+
+    /**
+     * @brief A parsed search.
+     */
+    struct Query
+    {
+        /// The literal text in lowercase.
+        std::string text;
+        bool exact;
+        bool anchorStart;
+        bool anchorEnd;
+    };
+
+    /**
+     * @brief Parses a searched text.
+     *
+     * @return False if the text is not served from the index.
+     */
+    static bool _ParseQuery( const std::string& match, bool exact, Query& into );
+    /**
+     * @return Rank of a matching name, lower is better; -1 if the name does not match.
+     */
+    static int _Rank( const Query& query, const std::string& lower );
+
+    static uint64 _EntryKey( uint8 kind, uint32 id ) { return ( (uint64)kind << 32 ) | id; }
+    static uint32 _TrigramKey( uint8 kind, const char* trigram );
+
+    /**
+     * @brief Finds the names of the kinds which match, best first.
+     *
+     * @param[in] query The parsed search.
+     * @param[in] kinds Bitmask of the searched kinds, bit i is the kind i.
+     * @param[out] into The matches.
+     */
+    void _Search( const Query& query, uint32 kinds, std::vector< const Entry* >& into );
+
+    void _Index( uint32 slot );
+    void _Unindex( uint32 slot );
+
+    /// The names; removed ones leave an empty slot behind.
+    std::vector< Entry > mEntries;
+    /// Free slots of mEntries.
+    std::vector< uint32 > mFreeSlots;
+    /// Slots of the names, by kind and ID.
+    std::tr1::unordered_map< uint64, uint32 > mSlots;
+    /// Slots of the names which have a trigram, by kind and trigram.
+    std::tr1::unordered_map< uint32, std::vector< uint32 > > mTrigrams;
+    /// The typeIDs of the indexed solar systems and stations.
+    std::set< uint32 > mLocationTypes;
+
+    /// Statistics.
+    Stats mStats;
+};
+
+/// A macro for easier access to the singleton.
+#define sNameIndex \
+    ( NameIndex::get() )
+
+#endif /* !__CHAT__NAME_INDEX_H__INCL__ */
@@ -0,0 +1,151 @@
+/*
+    ------------------------------------------------------------------------------------
+    LICENSE:
+    ------------------------------------------------------------------------------------
+    This file is part of EVEmu: EVE Online Server Emulator
+    Copyright 2006 - 2011 The EVEmu Team
+    For the latest information visit http://evemu.org
+    ------------------------------------------------------------------------------------
+    This program is free software; you can redistribute it and/or modify it under
+    the terms of the GNU Lesser General Public License as published by the Free Software
+    Foundation; either version 2 of the License, or (at your option) any later
+    version.
+
+    This program is distributed in the hope that it will be useful, but WITHOUT
+    ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+    FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public License along with
+    this program; if not, write to the Free Software Foundation, Inc., 59 Temple
+    Place - Suite 330, Boston, MA 02111-1307, USA, or go to
+    http://www.gnu.org/copyleft/lesser.txt.
+    ------------------------------------------------------------------------------------
+    Author:     EVEmu Team
+*/
+
+
+#ifndef __CHAT__PRESENCE_H__INCL__
+#define __CHAT__PRESENCE_H__INCL__
+
+#include "utils/Singleton.h"
+
+/**
+ * @brief Online state of the characters and who watches it.
+ *
+ * Every character has a reverse watcher list: the characters which
+ * have it on the watch list of their contacts. The lists are loaded
+ * at startup and kept up to date by AddWatcher() and RemoveWatcher().
+ *
+ * Logins and logouts are queued; Process() pushes them once per tick,
+ * one OnMultiEvent per online watcher carrying all the changes it
+ * watches. A character which logs in and out within the same tick
+ * is not announced at all.
+ *
+ * Not thread-safe; meant to be used from the main loop.
+ *
+ * @author EVEmu Team
+ */
+class Presence
+: public Singleton< Presence >
+{
+public:
+    /**
+     * @brief Statistics of the presence.
+     */
+    struct Stats
+    {
+        Stats() { Reset(); }
+
+        void Reset()
+        {
+            logins = 0;
+            logouts = 0;
+            coalesced = 0;
+            pushed = 0;
+            pushes = 0;
+        }
+
+        /// Number of logins.
+        uint32 logins;
+        /// Number of logouts.
+        uint32 logouts;
+        /// Number of changes which cancelled a queued one.
+        uint32 coalesced;
+        /// Number of changes pushed to watchers.
+        uint32 pushed;
+        /// Number of OnMultiEvent notifications they took.
+        uint32 pushes;
+    };
+
+    Presence();
+
+    /** @return Number of online characters. */
+    size_t size() const { return mOnline.size(); }
+    /** @return Number of characters which have watchers. */
+    size_t GetWatchedCount() const { return mWatchers.size(); }
+    /** @return Statistics since the last ResetStats(). */
+    const Stats& stats() const { return mStats; }
+    /** @brief Resets the statistics. */
+    void ResetStats() { mStats.Reset(); }
+
+    /**
+     * @brief Loads the watch lists of all characters.
+     *
+     * @return True on success.
+     */
+    bool Load();
+    /**
+     * @brief Pushes the queued logins and logouts to the watchers.
+     */
+    void Process();
+
+    /**
+     * @return Whether the character is online.
+     */
+    bool IsOnline( uint32 characterID ) const { return 0 < mOnline.count( characterID ); }
+
+    /** @brief Marks a character online; its watchers are told by the next Process(). */
+    void Login( uint32 characterID );
+    /** @brief Marks a character offline; its watchers are told by the next Process(). */
+    void Logout( uint32 characterID );
+
+    /**
+     * @brief Adds a character to the watch list of another one.
+     *
+     * @param[in] watcherID   The character whose watch list changed.
+     * @param[in] characterID The watched character.
+     */
+    void AddWatcher( uint32 watcherID, uint32 characterID );
+    /** @brief Removes a character from the watch list of another one. */
+    void RemoveWatcher( uint32 watcherID, uint32 characterID );
+    /** @brief Removes a deleted character from all the watch lists. */
+    void Remove( uint32 characterID );
+
+    /**
+     * @brief Encodes the online state of the watch list of a character.
+     *
+     * @return CRowset of contactID and online.
+     */
+    PyObjectEx* EncodeWatchedState( uint32 watcherID ) const;
+
+protected:
+    typedef std::tr1::unordered_map< uint32, std::set< uint32 > > WatchMap;
+
+    /// The online characters.
+    std::tr1::unordered_set< uint32 > mOnline;
+    /// Watchers of every watched character.
+    WatchMap mWatchers;
+    /// Watched characters of every watcher.
+    WatchMap mWatched;
+    /// Characters whose online state changed since the last Process(), with the new state.
+    std::map< uint32, bool > mChanges;
+
+    /// Statistics.
+    Stats mStats;
+};
+
+/// A macro for easier access to the singleton.
+#define sPresence \
+    ( Presence::get() )
+
+#endif /* !__CHAT__PRESENCE_H__INCL__ */
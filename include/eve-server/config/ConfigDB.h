@@ -53,7 +53,6 @@ public:
     * @param[in] solarSystemID  ID of the solar system whose objects are being retrieved
     */
     PyRep *GetDynamicCelestials(uint32 solarSystemID);
-    PyRep *GetTextsForGroup(const std::string & langID, uint32 textgroup);
 
 protected:
 };
@@ -25,7 +25,6 @@
 #ifndef __LANGUAGE_SERVICE_H_INCL__
 #define __LANGUAGE_SERVICE_H_INCL__
 
-#include "config/ConfigDB.h"
 #include "PyService.h"
 
 class LanguageService
@@ -39,8 +38,6 @@ protected:
     class Dispatcher;
     Dispatcher *const m_dispatch;
 
-    ConfigDB m_db;
-
     PyCallable_DECL_CALL(GetLanguages)
     PyCallable_DECL_CALL(GetTextsForGroup)
 
@@ -0,0 +1,175 @@
+/*
+    ------------------------------------------------------------------------------------
+    LICENSE:
+    ------------------------------------------------------------------------------------
+    This file is part of EVEmu: EVE Online Server Emulator
+    Copyright 2006 - 2011 The EVEmu Team
+    For the latest information visit http://evemu.org
+    ------------------------------------------------------------------------------------
+    This program is free software; you can redistribute it and/or modify it under
+    the terms of the GNU Lesser General Public License as published by the Free Software
+    Foundation; either version 2 of the License, or (at your option) any later
+    version.
+
+    This program is distributed in the hope that it will be useful, but WITHOUT
+    ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+    FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public License along with
+    this program; if not, write to the Free Software Foundation, Inc., 59 Temple
+    Place - Suite 330, Boston, MA 02111-1307, USA, or go to
+    http://www.gnu.org/copyleft/lesser.txt.
+    ------------------------------------------------------------------------------------
+    Author:     EVEmu Team
+*/
+
+
+#ifndef __CONFIG__OWNER_DIRECTORY_H__INCL__
+#define __CONFIG__OWNER_DIRECTORY_H__INCL__
+
+#include "config/ConfigDB.h"
+#include "utils/Singleton.h"
+
+class PyList;
+class PyTuple;
+
+/**
+ * @brief Resident directory of the rows the config service's GetMulti*Ex calls return.
+ *
+ * Every client asks for the owners, locations, tickers, alliance
+ * short names and types of the IDs it has not seen yet, the same
+ * IDs for everyone in a system. The rows are kept by ID after the
+ * first query, frozen, so a reply only references them next to a
+ * shared header; IDs which do not exist are remembered too, so
+ * they are not queried again either.
+ *
+ * The misses of a call are queried together with the ConfigDB
+ * queries. Renamed, new and deleted characters and new
+ * corporations are invalidated by ID (Invalidate()).
+ *
+ * Not thread-safe; meant to be used from the main loop.
+ *
+ * @author EVEmu Team
+ */
+class OwnerDirectory
+: public Singleton< OwnerDirectory >
+{
+public:
+    enum RowKind
+    {
+        /// GetMultiOwnersEx: ownerID, ownerName, typeID, ownerNameID, gender.
+        ROW_OWNER,
+        /// GetMultiLocationsEx: locationID, locationName, x, y, z, locationNameID.
+        ROW_LOCATION,
+        /// GetMultiAllianceShortNamesEx: allianceID, shortName.
+        ROW_ALLIANCE_SHORT_NAME,
+        /// GetMultiCorpTickerNamesEx: corporationID, tickerName, shapes and colors.
+        ROW_CORP_TICKER,
+        /// GetMultiInvTypesEx: the columns of invTypes.
+        ROW_INV_TYPE,
+
+        ROW_KIND_COUNT
+    };
+
+    /**
+     * @brief Statistics of the directory.
+     */
+    struct Stats
+    {
+        Stats() { Reset(); }
+
+        void Reset()
+        {
+            calls = 0;
+            hits = 0;
+            negativeHits = 0;
+            misses = 0;
+            queries = 0;
+            invalidations = 0;
+        }
+
+        /// Number of calls served.
+        uint32 calls;
+        /// Number of IDs served from resident rows.
+        uint32 hits;
+        /// Number of IDs known not to exist.
+        uint32 negativeHits;
+        /// Number of IDs which had to be queried.
+        uint32 misses;
+        /// Number of queries run for them.
+        uint32 queries;
+        /// Number of IDs invalidated.
+        uint32 invalidations;
+    };
+
+    OwnerDirectory();
+    ~OwnerDirectory();
+
+    /** @return Number of resident IDs, including those known not to exist. */
+    size_t size() const;
+    /** @return Statistics since the last ResetStats(). */
+    const Stats& stats() const { return mStats; }
+    /** @brief Resets the statistics. */
+    void ResetStats() { mStats.Reset(); }
+
+    /**
+     * @brief Gets the rows of IDs.
+     *
+     * @param[in] kind Which rows.
+     * @param[in] ids  The IDs; those which do not exist are left out.
+     *
+     * @return The (header, rows) tuple the GetMulti*Ex calls return; NULL on failure.
+     */
+    PyTuple* Get( RowKind kind, const std::vector< int32 >& ids );
+
+    /**
+     * @brief Drops the rows of an ID, which has been created, renamed or deleted.
+     */
+    void Invalidate( uint32 id );
+
+protected:
+    /**
+     * @brief The resident rows of a kind.
+     */
+    struct Table
+    {
+        Table() : header( NULL ) {}
+
+        /// The frozen list of the column names; NULL until the first query.
+        PyList* header;
+        /// The frozen rows, by ID; NULL for IDs which do not exist.
+        std::tr1::unordered_map< uint32, PyRep* > rows;
+    };
+
+    /**
+     * @brief Queries the rows of IDs and adds them to a table.
+     *
+     * Repeats the query for the IDs it did not return as long as it
+     * returns any, as the owner query searches one table per call.
+     * The IDs which are never returned are added as not existing.
+     *
+     * @return False on failure.
+     */
+    bool _Query( RowKind kind, Table& table, const std::vector< int32 >& ids );
+    /**
+     * @return The rows of a kind, by the ConfigDB query; NULL on failure.
+     */
+    PyTuple* _Run( RowKind kind, const std::vector< int32 >& ids );
+    /**
+     * @return ID of a row, the value of its first column.
+     */
+    static uint32 _RowID( const PyRep* row );
+
+    ConfigDB mDB;
+
+    Table mTables[ ROW_KIND_COUNT ];
+
+    /// Statistics.
+    Stats mStats;
+};
+
+/// A macro for easier access to the singleton.
+#define sOwnerDirectory \
+    ( OwnerDirectory::get() )
+
+#endif /* !__CONFIG__OWNER_DIRECTORY_H__INCL__ */
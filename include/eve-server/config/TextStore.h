@@ -0,0 +1,164 @@
+/*
+    ------------------------------------------------------------------------------------
+    LICENSE:
+    ------------------------------------------------------------------------------------
+    This file is part of EVEmu: EVE Online Server Emulator
+    Copyright 2006 - 2011 The EVEmu Team
+    For the latest information visit http://evemu.org
+    ------------------------------------------------------------------------------------
+    This program is free software; you can redistribute it and/or modify it under
+    the terms of the GNU Lesser General Public License as published by the Free Software
+    Foundation; either version 2 of the License, or (at your option) any later
+    version.
+
+    This program is distributed in the hope that it will be useful, but WITHOUT
+    ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+    FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public License along with
+    this program; if not, write to the Free Software Foundation, Inc., 59 Temple
+    Place - Suite 330, Boston, MA 02111-1307, USA, or go to
+    http://www.gnu.org/copyleft/lesser.txt.
+    ------------------------------------------------------------------------------------
+    Author:     EVEmu Team
+*/
+
+
+#ifndef __CONFIG__TEXT_STORE_H__INCL__
+#define __CONFIG__TEXT_STORE_H__INCL__
+
+#include "utils/Singleton.h"
+
+class PyObject;
+class PyRep;
+
+/**
+ * @brief Resident localization texts the language service hands out.
+ *
+ * The languages and all the texts of the intro table are loaded
+ * once at startup. Every distinct string is stored once in a single
+ * character pool, however many languages or groups use it; a group
+ * is a list of (label, text) pool references, indexed by language
+ * and group.
+ *
+ * The replies are cached objects: the rowset of a group is built
+ * once and handed to the cache service under the objectID of the
+ * group, which marshals and deflates it once; afterwards a call
+ * only returns the cache hint, and clients keep the group between
+ * sessions.
+ *
+ * Not thread-safe; meant to be used from the main loop.
+ *
+ * @author EVEmu Team
+ */
+class TextStore
+: public Singleton< TextStore >
+{
+public:
+    /**
+     * @brief Statistics of the store.
+     */
+    struct Stats
+    {
+        Stats() { Reset(); }
+
+        void Reset()
+        {
+            calls = 0;
+            built = 0;
+            unknown = 0;
+        }
+
+        /// Number of group requests served.
+        uint32 calls;
+        /// Number of group rowsets built.
+        uint32 built;
+        /// Number of requests of groups without texts.
+        uint32 unknown;
+    };
+
+    TextStore();
+    ~TextStore();
+
+    /** @return Number of groups, over all the languages. */
+    size_t size() const { return mGroups.size(); }
+    /** @return Number of distinct strings. */
+    size_t GetStringCount() const { return mStrings.size(); }
+    /** @return Size of the string pool, in bytes. */
+    size_t GetPoolSize() const { return mChars.size(); }
+    /** @return Statistics since the last ResetStats(). */
+    const Stats& stats() const { return mStats; }
+    /** @brief Resets the statistics. */
+    void ResetStats() { mStats.Reset(); }
+
+    /**
+     * @brief Loads the languages and the texts.
+     *
+     * @return True on success.
+     */
+    bool Load();
+
+    /**
+     * @return The util.Rowset of the languages; a new reference.
+     */
+    PyRep* GetLanguages();
+
+    /**
+     * @brief Finds the objectID a group is cached under.
+     *
+     * @param[in] languageID The language; not case sensitive.
+     * @param[in] textgroup  The group.
+     *
+     * @return The objectID, owned by the store; NULL if the group has no texts in the language.
+     */
+    const PyRep* GetGroupObjectID( const std::string& languageID, uint32 textgroup );
+    /**
+     * @brief Builds the util.Rowset of a group.
+     *
+     * @return The rowset; empty if the group has no texts in the language.
+     */
+    PyObject* BuildGroup( const std::string& languageID, uint32 textgroup );
+
+protected:
+    /**
+     * @brief The texts of a group in a language.
+     */
+    struct Group
+    {
+        /// The cached objectID; we own this.
+        PyRep* objectID;
+        /// Indexes of the labels and texts in mStrings.
+        std::vector< std::pair< uint32, uint32 > > texts;
+    };
+
+    /**
+     * @return The key of a group; 0 if the language is unknown.
+     */
+    uint64 _GroupKey( const std::string& languageID, uint32 textgroup ) const;
+    /**
+     * @return Index of a string in mStrings, adding it to the pool if needed.
+     */
+    uint32 _Intern( const std::string& str, std::tr1::unordered_map< std::string, uint32 >& index );
+
+    /// The frozen rowset of the languages.
+    PyRep* mLanguages;
+    /// The languageIDs which have texts, in upper case; a group key holds the index + 1.
+    std::vector< std::string > mLanguageIDs;
+
+    /// The characters of all the distinct strings, one after another.
+    std::string mChars;
+    /// The offset and length of every distinct string.
+    std::vector< std::pair< uint32, uint32 > > mStrings;
+
+    /// The groups, by _GroupKey().
+    std::tr1::unordered_map< uint64, Group > mGroups;
+
+    /// Statistics.
+    Stats mStats;
+};
+
+/// A macro for easier access to the singleton.
+#define sTextStore \
+    ( TextStore::get() )
+
+#endif /* !__CONFIG__TEXT_STORE_H__INCL__ */
@@ -0,0 +1,238 @@
+/*
+    ------------------------------------------------------------------------------------
+    LICENSE:
+    ------------------------------------------------------------------------------------
+    This file is part of EVEmu: EVE Online Server Emulator
+    Copyright 2006 - 2011 The EVEmu Team
+    For the latest information visit http://evemu.org
+    ------------------------------------------------------------------------------------
+    This program is free software; you can redistribute it and/or modify it under
+    the terms of the GNU Lesser General Public License as published by the Free Software
+    Foundation; either version 2 of the License, or (at your option) any later
+    version.
+
+    This program is distributed in the hope that it will be useful, but WITHOUT
+    ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+    FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public License along with
+    this program; if not, write to the Free Software Foundation, Inc., 59 Temple
+    Place - Suite 330, Boston, MA 02111-1307, USA, or go to
+    http://www.gnu.org/copyleft/lesser.txt.
+    ------------------------------------------------------------------------------------
+    Author:     EVEmu Team
+*/
+
+
+#ifndef __CORPORATION__CORP_ROSTER_H__INCL__
+#define __CORPORATION__CORP_ROSTER_H__INCL__
+
+#include "utils/Singleton.h"
+
+class CorpMemberInfo;
+class OfficeInfo;
+
+/**
+ * @brief Resident rosters of the corporations: their members and offices.
+ *
+ * The roster of a corporation is loaded by the first call which needs
+ * it and then served from memory: the member and office lists the
+ * client fetches through its sparse rowsets, a page at a time or by
+ * key, and the single members. Only the rosters of the last
+ * MAX_ROSTERS corporations used are kept.
+ *
+ * The writes keep the resident rosters up to date: joining a
+ * corporation moves the member between the rosters, a role change
+ * updates its row and a rented office is added, so CorporationDB
+ * only sees the writes.
+ *
+ * Not thread-safe; meant to be used from the main loop.
+ *
+ * @author EVEmu Team
+ */
+class CorpRoster
+: public Singleton< CorpRoster >
+{
+public:
+    /// Number of rosters kept in memory.
+    static const size_t MAX_ROSTERS = 256;
+
+    /**
+     * @brief Statistics of the rosters.
+     */
+    struct Stats
+    {
+        Stats() { Reset(); }
+
+        void Reset()
+        {
+            loads = 0;
+            hits = 0;
+            evictions = 0;
+            fetches = 0;
+            rows = 0;
+            updates = 0;
+        }
+
+        /// Number of rosters loaded.
+        uint32 loads;
+        /// Number of calls served from a resident roster.
+        uint32 hits;
+        /// Number of rosters dropped to make room.
+        uint32 evictions;
+        /// Number of pages and keys fetched.
+        uint32 fetches;
+        /// Number of rows those returned.
+        uint32 rows;
+        /// Number of member and office changes applied.
+        uint32 updates;
+    };
+
+    CorpRoster();
+
+    /** @return Number of resident rosters. */
+    size_t size() const { return mRosters.size(); }
+    /** @return Statistics since the last ResetStats(). */
+    const Stats& stats() const { return mStats; }
+    /** @brief Resets the statistics. */
+    void ResetStats() { mStats.Reset(); }
+
+    /**
+     * @return Number of members of the corporation.
+     */
+    uint32 GetMemberCount( uint32 corporationID );
+    /**
+     * @brief Fetches a page of members, ordered by characterID.
+     *
+     * @param[in] corporationID The corporation.
+     * @param[in] startPos      Position of the first member.
+     * @param[in] fetchSize     Number of members.
+     *
+     * @return List of (characterID, row) tuples; NULL if the roster cannot be loaded.
+     */
+    PyList* FetchMembers( uint32 corporationID, uint32 startPos, uint32 fetchSize );
+    /**
+     * @brief Fetches the members with the characterIDs; the unknown ones are skipped.
+     *
+     * @return List of (characterID, row) tuples; NULL if the roster cannot be loaded.
+     */
+    PyList* FetchMembersByKey( uint32 corporationID, const std::vector<int32>& keys );
+    /**
+     * @return The util.Row of the member; NULL if the character is not a member.
+     */
+    PyObject* GetMember( uint32 corporationID, uint32 characterID );
+
+    /**
+     * @return Number of offices of the corporation.
+     */
+    uint32 GetOfficeCount( uint32 corporationID );
+    /**
+     * @brief Fetches a page of offices, in the order they were rented.
+     *
+     * @return List of (officeID, [stationID, typeID, officeID, officeFolderID]) tuples;
+     *         NULL if the roster cannot be loaded.
+     */
+    PyList* FetchOffices( uint32 corporationID, uint32 startPos, uint32 fetchSize );
+
+    /**
+     * @brief Adds a new character to the roster of its corporation.
+     */
+    void AddMember( uint32 characterID, uint32 corporationID, const std::string& title, uint64 startDateTime, const CorpMemberInfo& roles );
+    /**
+     * @brief Moves a member to another corporation.
+     *
+     * @param[in] characterID      The member.
+     * @param[in] oldCorporationID The corporation it left.
+     * @param[in] corporationID    The corporation it joined.
+     * @param[in] startDateTime    When it joined.
+     * @param[in] roles            Its roles in the new corporation.
+     */
+    void MoveMember( uint32 characterID, uint32 oldCorporationID, uint32 corporationID, uint64 startDateTime, const CorpMemberInfo& roles );
+    /**
+     * @brief Updates the roles of a member.
+     */
+    void UpdateRoles( uint32 characterID, const CorpMemberInfo& roles );
+    /**
+     * @brief Removes a deleted character.
+     */
+    void RemoveMember( uint32 characterID );
+    /**
+     * @brief Adds a rented office.
+     */
+    void AddOffice( const OfficeInfo& office );
+
+protected:
+    /**
+     * @brief A member of a corporation.
+     */
+    struct Member
+    {
+        uint32 characterID;
+        std::string title;
+        uint64 startDateTime;
+        uint64 roles;
+        uint64 rolesAtHQ;
+        uint64 rolesAtBase;
+        uint64 rolesAtOther;
+        /// When the row last changed.
+        uint64 rowDate;
+
+        bool operator<( const Member& oth ) const { return characterID < oth.characterID; }
+    };
+
+    /**
+     * @brief An office of a corporation.
+     */
+    struct Office
+    {
+        uint32 officeID;
+        uint32 stationID;
+        uint32 typeID;
+        uint32 officeFolderID;
+    };
+
+    /**
+     * @brief The roster of a corporation.
+     */
+    struct Roster
+    {
+        /// The members, sorted by characterID.
+        std::vector< Member > members;
+        std::vector< Office > offices;
+        /// Position in mRecent.
+        std::list< uint32 >::iterator recent;
+    };
+
+    /**
+     * @brief Finds the roster, loading it if it is not resident.
+     *
+     * @return The roster; NULL if it cannot be loaded.
+     */
+    Roster* _Get( uint32 corporationID );
+    /**
+     * @return The roster if it is resident, NULL otherwise.
+     */
+    Roster* _Find( uint32 corporationID );
+    bool _Load( uint32 corporationID, Roster& into );
+    void _Drop( uint32 corporationID );
+
+    static Member* _FindMember( Roster& roster, uint32 characterID );
+    static void _SetRoles( Member& member, const CorpMemberInfo& roles );
+    PyList* _EncodeMember( uint32 corporationID, const Member& member ) const;
+
+    /// The resident rosters.
+    std::map< uint32, Roster > mRosters;
+    /// corporationIDs of the resident rosters, most recently used first.
+    std::list< uint32 > mRecent;
+    /// Corporation of every member of the resident rosters.
+    std::tr1::unordered_map< uint32, uint32 > mMemberCorps;
+
+    /// Statistics.
+    Stats mStats;
+};
+
+/// A macro for easier access to the singleton.
+#define sCorpRoster \
+    ( CorpRoster::get() )
+
+#endif /* !__CORPORATION__CORP_ROSTER_H__INCL__ */
@@ -67,8 +67,6 @@ public:
     bool JoinCorporation(uint32 charID, uint32 corpID, uint32 oldCorpID, const CorpMemberInfo &roles);
     bool CreateCorporationChangePacket(Notify_OnCorporaionChanged & cc, uint32 oldCorpID, uint32 newCorpID);
     bool CreateCorporationCreatePacket(Notify_OnCorporaionChanged & cc, uint32 oldCorpID, uint32 newCorpID);
-    uint32 GetOffices(uint32 corpID);
-    PyRep *Fetch(uint32 corpID, uint32 from, uint32 count);
 
     uint32 GetQuoteForRentingAnOffice(uint32 corpID);
     uint32 ReserveOffice(const OfficeInfo & oInfo);
@@ -30,6 +30,8 @@
 
 #include "dogmaim/DogmaDB.h"
 
+class ObjectCachedMethodID;
+
 class DogmaService
 : public PyService
 {
@@ -37,6 +39,8 @@ public:
     DogmaService(PyServiceMgr *mgr);
     virtual ~DogmaService();
 
+    virtual void PrimeCache();
+
 protected:
     class Dispatcher;
     Dispatcher *const m_dispatch;
@@ -45,6 +49,8 @@ protected:
 
     PyCallable_DECL_CALL(GetOperandsForChar)
 
+    bool _CacheOperandsForChar(const ObjectCachedMethodID &method_id);
+
 };
 
 #endif
@@ -33,24 +33,35 @@
 
 // database
 #include "database/dbcore.h"
+#include "database/DBAsyncQueue.h"
 // log
 #include "log/LogNew.h"
 #include "log/logsys.h"
 // network
 #include "network/StreamPacketizer.h"
 #include "network/TCPConnection.h"
+#include "network/TCPReactor.h"
 #include "network/TCPServer.h"
 // threading
+#include "threading/Event.h"
 #include "threading/Mutex.h"
 // utils
+#include "utils/CallTracer.h"
 #include "utils/crc32.h"
 #include "utils/Deflate.h"
 #include "utils/EvilNumber.h"
 #include "utils/gpoint.h"
+#include "utils/Metrics.h"
 #include "utils/misc.h"
+#include "utils/ObjectPool.h"
+#include "utils/PerfectHash.h"
+#include "utils/PointBatch.h"
 #include "utils/RefPtr.h"
 #include "utils/Seperator.h"
+#include "utils/SizeClassPool.h"
 #include "utils/timer.h"
+#include "utils/TickProfiler.h"
+#include "utils/TimerWheel.h"
 #include "utils/utils_time.h"
 #include "utils/utils_string.h"
 #include "utils/XMLParserEx.h"
@@ -72,10 +83,13 @@
 #include "destiny/DestinyBinDump.h"
 #include "destiny/DestinyStructs.h"
 // network
+#include "network/EVEEncoderPool.h"
 #include "network/EVETCPConnection.h"
 #include "network/EVETCPServer.h"
+#include "network/EVETrafficStats.h"
 #include "network/EVEPktDispatch.h"
 #include "network/EVESession.h"
+#include "network/EVESharedPayload.h"
 // marshal
 #include "marshal/EVEMarshal.h"
 #include "marshal/EVEMarshalOpcodes.h"
@@ -118,6 +132,9 @@
 // utils
 #include "utils/EVEUtils.h"
 #include "utils/EvilNumber.h"
+#include "utils/ModifierGraph.h"
+#include "utils/RechargeState.h"
+#include "utils/TypeAttributeTable.h"
 
 /************************************************************************/
 /* eve-server includes                                                  */
@@ -26,6 +26,7 @@
 #ifndef __IMAGESERVER__H__INCL__
 #define __IMAGESERVER__H__INCL__
 
+#include "threading/Atomic.h"
 #include "utils/Singleton.h"
 
 class ImageServerListener;
@@ -36,7 +37,11 @@ class ImageServerListener;
  * @brief Handles distribution of character and related game images
  *
  * A very limited HTTP server that can efficiently deliver character and other images to clients
- * Uses asio for efficient asynchronous network communication
+ * Uses asio for efficient asynchronous network communication, served by a pool of I/O threads
+ *
+ * Images requested more than once are kept in a size-bounded memory cache and shared by the
+ * connections sending them; the others are sent from their files (by sendfile where available).
+ * Every image carries an ETag and a Last-Modified date for conditional requests.
  *
  * @author caytchen
  * @date April 2011
@@ -44,6 +49,51 @@ class ImageServerListener;
 class ImageServer : public Singleton<ImageServer>
 {
 public:
+    /**
+     * @brief An image to send.
+     */
+    struct Image
+    {
+        /// The contents; NULL if the image is sent from its file.
+        std::tr1::shared_ptr<std::vector<char> > data;
+        /// Path of the file.
+        std::string path;
+        /// Size (in bytes).
+        size_t size;
+        /// Last modification of the file, as an HTTP date.
+        std::string lastModified;
+        /// Entity tag of the file, quoted.
+        std::string etag;
+    };
+
+    /**
+     * @brief Statistics of the image cache.
+     */
+    struct Stats
+    {
+        Stats() { Reset(); }
+
+        void Reset()
+        {
+            hits = 0;
+            misses = 0;
+            cold = 0;
+            notModified = 0;
+            evictions = 0;
+        }
+
+        /// Number of images sent from the cache.
+        volatile uint32 hits;
+        /// Number of images loaded into the cache.
+        volatile uint32 misses;
+        /// Number of images sent from their files.
+        volatile uint32 cold;
+        /// Number of conditional requests answered by 304 Not Modified.
+        volatile uint32 notModified;
+        /// Number of images evicted from the cache.
+        volatile uint32 evictions;
+    };
+
     ImageServer();
     void Run();
     void Stop();
@@ -54,7 +104,34 @@ public:
     void ReportNewCharacter(uint32 creatorAccountID, uint32 characterID);
 
     std::string GetFilePath(std::string& category, uint32 id, uint32 size);
-    std::tr1::shared_ptr<std::vector<char> > GetImage(std::string& category, uint32 id, uint32 size);
+    /**
+     * @brief Finds an image, from the cache if it is there.
+     *
+     * @return False if there is no such image.
+     */
+    bool GetImage(std::string& category, uint32 id, uint32 size, Image& into);
+    /**
+     * @brief Reads an image which is not in the cache.
+     *
+     * @return The contents; NULL on failure.
+     */
+    static std::tr1::shared_ptr<std::vector<char> > ReadImage(const Image& image);
+    /**
+     * @brief Formats a time as an HTTP date, e.g. "Sun, 06 Nov 1994 08:49:37 GMT".
+     */
+    static std::string FormatHttpDate(time_t time);
+
+    /** @return Statistics since the last ResetStats(). */
+    const Stats& stats() const { return _stats; }
+    /** @brief Resets the statistics. */
+    void ResetStats() { _stats.Reset(); }
+    /** @brief Counts a request answered by 304 Not Modified. */
+    void CountNotModified() { AtomicAdd(&_stats.notModified, 1); }
+    /**
+     * @param[out] entries Number of cached images.
+     * @param[out] bytes   Size of the cached images.
+     */
+    void GetCacheSize(size_t& entries, size_t& bytes);
 
     static const char *const Categories[];
     static const uint32 CategoryCount;
@@ -64,18 +141,38 @@ public:
     static const char *const FallbackURL;
 
 private:
-    void RunInternal();
+    typedef std::tr1::shared_ptr<boost::asio::detail::thread> ThreadPtr;
+
+    static void RunService(boost::asio::io_service* io);
     bool ValidateCategory(std::string& category);
     bool ValidateSize(std::string& category, uint32 size);
+    // drops the cached image of a path, if any; _cacheLock must be held
+    void _Uncache(const std::string& path);
 
     std::tr1::unordered_map<uint32 /*accountID*/, std::tr1::shared_ptr<std::vector<char> > /*imageData*/> _limboImages;
-    std::auto_ptr<boost::asio::detail::thread> _ioThread;
+    std::vector<ThreadPtr> _ioThreads;
     std::auto_ptr<boost::asio::io_service> _io;
     std::auto_ptr<ImageServerListener> _listener;
     std::string _url;
     std::string _basePath;
     boost::asio::detail::mutex _limboLock;
 
+    struct CacheEntry
+    {
+        Image image;
+        std::list<std::string>::iterator lru;
+    };
+
+    // the cached images by path, and the paths from the most recently used
+    std::tr1::unordered_map<std::string, CacheEntry> _cache;
+    std::list<std::string> _cacheLru;
+    size_t _cacheBytes;
+    size_t _cacheLimit;
+    // paths requested once, which get cached when requested again
+    std::tr1::unordered_set<std::string> _requested;
+    boost::asio::detail::mutex _cacheLock;
+    Stats _stats;
+
     class Lock
     {
     public:
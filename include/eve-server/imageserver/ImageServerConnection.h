@@ -26,12 +26,16 @@
 #ifndef __IMAGESERVERCONNECTION__H__INCL__
 #define __IMAGESERVERCONNECTION__H__INCL__
 
+#include "imageserver/ImageServer.h"
+
 /**
  * \class ImageServerConnection
  *
  * @brief Handles a client connection to the image server
  *
  * Handles exactly one client; does all the protocol related stuff. Very limited HTTP handling.
+ * The handlers of a connection run in its strand. Cached images are sent straight from the cache;
+ * the others are sent from their files.
  *
  * @author caytchen
  * @date April 2011
@@ -40,13 +44,17 @@ class ImageServerConnection : public std::tr1::enable_shared_from_this<ImageServ
 {
 public:
     static std::tr1::shared_ptr<ImageServerConnection> create(boost::asio::io_service& io);
+    ~ImageServerConnection();
     void Process();
     boost::asio::ip::tcp::socket& socket();
 
 private:
     ImageServerConnection(boost::asio::io_service& io);
     void ProcessHeaders();
+    void ParseConditions(std::istream& stream);
     void SendImage();
+    void SendFile();
+    void NotModified();
     void NotFound();
     void Close();
     void Redirect();
@@ -60,12 +68,21 @@ private:
     uint32 _id;
     uint32 _size;
     std::string _redirectUrl;
+    // validators of a conditional request
+    std::string _ifNoneMatch;
+    std::string _ifModifiedSince;
 
     boost::asio::streambuf _buffer;
     boost::asio::ip::tcp::socket _socket;
-    std::tr1::shared_ptr<std::vector<char> > _imageData;
+    boost::asio::io_service::strand _strand;
+    ImageServer::Image _image;
+    std::string _header;
+#ifdef HAVE_SYS_SENDFILE_H
+    // the file being sent, and how far
+    int _fd;
+    off_t _offset;
+#endif /* HAVE_SYS_SENDFILE_H */
 
-    static boost::asio::const_buffers_1 _responseOK;
     static boost::asio::const_buffers_1 _responseNotFound;
     static boost::asio::const_buffers_1 _responseRedirectBegin;
     static boost::asio::const_buffers_1 _responseRedirectEnd;
@@ -258,10 +258,21 @@ protected:
  * @note keeping track of the base value of the attribute is not implemented.
  * Besides the fact in increases memory concumption its unclear how to design it
  * at this moment.
+ * @note the attributes listed in EVEHotAttributes.h are kept as plain doubles
+ * in a fixed table indexed by slot; everything else lives in the sparse map.
+ * EvilNumber is only built when a caller asks for one.
  */
 class AttributeMap
 {
 public:
+    /** Slots of the dense attribute table, one per entry of EVEHotAttributes.h. */
+    enum HotAttributeSlot
+    {
+#define HOT_ATTR( attributeID ) HOT_SLOT_##attributeID,
+#include "inventory/EVEHotAttributes.h"
+        HOT_ATTRIBUTE_COUNT
+    };
+
     /**
      * we store our keeper so we can use it in the various functions.
      * @note capt: the way I see it this isn't really needed... ( design thingy )
@@ -285,6 +296,18 @@ public:
 
     EvilNumber GetAttribute(const uint32 attributeId) const;
 
+    /**
+     * @brief get the attribute as a double without going through EvilNumber.
+     *
+     * This is the fast path for the per tick readers; the attributes in the
+     * dense table are a single array load.
+     *
+     * @param[in] attributeId the attribute id to read.
+     *
+     * @return the value of the attribute, 0 if the item does not have it.
+     */
+    double GetAttributeValue(uint32 attributeId) const;
+
     /*
      * HasAttribute
      *
@@ -298,6 +321,10 @@ public:
      * except charge attributes but we won't handle them for now
      */
     bool Save();
+    /**
+     * @brief marks all the attributes as changed, so the next Save() writes every one of them.
+     */
+    void MarkAllDirty();
 
     bool Delete();
 
@@ -313,8 +340,7 @@ public:
     /**
      * SaveAttributes
      *
-     * @note this function always saves everything and doesn't take into account the fact that we should only save the
-     * changes attributes.
+     * @note only the attributes changed since the last save (or the load) are written.
      */
     bool SaveAttributes();
     bool SaveIntAttribute(uint32 attributeID, int64 value);
@@ -330,24 +356,14 @@ public:
     //void set_item(InventoryItem *item) {mItem = item;}
 
     /**
-     * @brief return the begin iterator of the AttributeMap
-     *
-     *
+     * @brief encode all attributes of the item for the client.
      *
-     * @return the begin iterator of the AttributeMap
-     * @note this way to solve the attribute system problems are quite hacky... but atm its needed
+     * @param[out] into the attribute dictionary, the reps are new references.
      */
-    AttrMapItr begin();
+    void EncodeAttributes(std::map<int32, PyRep *> &into) const;
 
-    /**
-     * @brief return the end iterator of the AttributeMap
-     *
-     *
-     *
-     * @return the end iterator of the AttributeMap
-     * @note this way to solve the attribute system problems are quite hacky... but atm its needed
-     */
-    AttrMapItr end();
+    /** @return Number of the attributes in the map. */
+    size_t size() const;
 
 protected:
     /**
@@ -373,18 +389,29 @@ protected:
     bool Add(uint32 attributeID, EvilNumber& num);
 
     /**
-     * @brief queue the attribute changes into the QueueDestinyEvent system.
+     * @brief queue the attribute change, coalesced with earlier changes of the same tic.
      *
-     * @param[in] attrChange the attribute id that needs to be added.
+     * @param[in] attributeID the attribute that changed.
+     * @param[in] attrChange the OnModuleAttributeChange event; consumed.
      *
      * @retval true  The attribute has successfully been added and queued.
      * @retval false The attribute addition has not been queued and not been changed.
      */
-    bool SendAttributeChanges(PyTuple* attrChange);
+    bool SendAttributeChanges(uint32 attributeID, PyTuple* attrChange);
 
     bool SaveIntAttribute(uint32 attributeID);
     bool SaveFloatAttribute(uint32 attributeID);
 
+    /** @return the slot of @a attributeID in the dense table, HOT_ATTRIBUTE_COUNT if it is not in there. */
+    static uint32 _GetHotSlot(uint32 attributeID);
+    /** @return the value of a present dense slot as an EvilNumber. */
+    EvilNumber _GetHotNumber(uint32 slot) const;
+    /** logs a missing attribute, unless it is one of the commonly missing ones. */
+    void _ReportMissing(uint32 attributeID) const;
+
+    /** forgets the changes, after they have been saved or right after loading. */
+    void _ClearDirty();
+
     /** we belong to this item..
      * @note possible design flaw because only items contain AttributeMap's so
      *       we don't need to store this.
@@ -397,12 +424,16 @@ protected:
      */
     AttrMap mAttributes;
 
-    /**
-     * we set and we clear this flag when we change attributes of this item....
-     * @note we should improve this idea... and only save the changed attributes...
-     *       but that is for the future.
-     */
-    bool mChanged;
+    /** values of the dense attributes, valid where mHotPresent has the slot bit set. */
+    double mHotValues[HOT_ATTRIBUTE_COUNT];
+    /** one bit per slot, set when the item has the attribute. */
+    uint32 mHotPresent;
+    /** one bit per slot, set when the attribute was stored as an integer. */
+    uint32 mHotInt;
+    /** one bit per slot, set when the attribute changed since the last Save(). */
+    uint32 mHotDirty;
+    /** the attributes of the sparse map changed since the last Save(). */
+    std::set<uint32> mDirty;
 };
 
 #endif /* __EVE_ATTRIBUTE_MGR__H__INCL__ */
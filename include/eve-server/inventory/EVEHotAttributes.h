@@ -0,0 +1,71 @@
+/*
+    ------------------------------------------------------------------------------------
+    LICENSE:
+    ------------------------------------------------------------------------------------
+    This file is part of EVEmu: EVE Online Server Emulator
+    Copyright 2006 - 2011 The EVEmu Team
+    For the latest information visit http://evemu.org
+    ------------------------------------------------------------------------------------
+    This program is free software; you can redistribute it and/or modify it under
+    the terms of the GNU Lesser General Public License as published by the Free Software
+    Foundation; either version 2 of the License, or (at your option) any later
+    version.
+
+    This program is distributed in the hope that it will be useful, but WITHOUT
+    ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+    FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public License along with
+    this program; if not, write to the Free Software Foundation, Inc., 59 Temple
+    Place - Suite 330, Boston, MA 02111-1307, USA, or go to
+    http://www.gnu.org/copyleft/lesser.txt.
+    ------------------------------------------------------------------------------------
+    Author:     EVEmu Team
+*/
+
+/*
+ * List of the attributes AttributeMap keeps in its dense table instead of
+ * the sparse map. These are the ones read and written every tick by
+ * destiny, damage and the ship status updates; the IDs come from
+ * AttributeEnum.h. The table has room for 32 entries since presence and
+ * int-ness are tracked in a pair of uint32 masks.
+ */
+
+#ifndef HOT_ATTR
+#define HOT_ATTR( attributeID )
+#endif
+
+HOT_ATTR( AttrIsOnline )
+HOT_ATTR( AttrDamage )
+HOT_ATTR( AttrMass )
+HOT_ATTR( AttrHp )
+HOT_ATTR( AttrCharge )
+HOT_ATTR( AttrMaxVelocity )
+HOT_ATTR( AttrCapacity )
+HOT_ATTR( AttrRechargeRate )
+HOT_ATTR( AttrAgility )
+HOT_ATTR( AttrMaxTargetRange )
+HOT_ATTR( AttrKineticDamageResonance )
+HOT_ATTR( AttrThermalDamageResonance )
+HOT_ATTR( AttrExplosiveDamageResonance )
+HOT_ATTR( AttrEmDamageResonance )
+HOT_ATTR( AttrVolume )
+HOT_ATTR( AttrRadius )
+HOT_ATTR( AttrShieldCapacity )
+HOT_ATTR( AttrShieldCharge )
+HOT_ATTR( AttrArmorHP )
+HOT_ATTR( AttrArmorDamage )
+HOT_ATTR( AttrArmorEmDamageResonance )
+HOT_ATTR( AttrArmorExplosiveDamageResonance )
+HOT_ATTR( AttrArmorKineticDamageResonance )
+HOT_ATTR( AttrArmorThermalDamageResonance )
+HOT_ATTR( AttrShieldEmDamageResonance )
+HOT_ATTR( AttrShieldExplosiveDamageResonance )
+HOT_ATTR( AttrShieldKineticDamageResonance )
+HOT_ATTR( AttrShieldThermalDamageResonance )
+HOT_ATTR( AttrShieldRechargeRate )
+HOT_ATTR( AttrCapacitorCapacity )
+HOT_ATTR( AttrSignatureRadius )
+HOT_ATTR( AttrQuantity )
+
+#undef HOT_ATTR
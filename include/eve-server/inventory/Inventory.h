@@ -78,9 +78,16 @@ public:
     bool IsEmptyByFlag(EVEItemFlags flag);
 
 
+    //both kept up to date as the contents change, so they do not visit the items.
     double GetStoredVolume(EVEItemFlags flag) const;
+    uint32 GetItemCount(EVEItemFlags flag) const;
 
     virtual void ValidateAddItem(EVEItemFlags flag, InventoryItemRef item) const {}
+    /* validates adding several items at once, as if they were one.
+     *
+     * throws if they do not fit together; nothing has been moved then.
+     */
+    virtual void ValidateAddItems(EVEItemFlags flag, const std::vector<InventoryItemRef> &items) const;
     void StackAll(EVEItemFlags flag, uint32 forOwner = 0);
 
     /*
@@ -97,8 +104,30 @@ protected:
 
     virtual bool GetItems(ItemFactory &factory, std::vector<uint32> &into) const { return factory.db().GetItemContents( inventoryID(), into ); }
 
+    typedef std::map<uint32, InventoryItemRef> ItemMap;
+
+    static uint64 _IndexKey(uint32 high, uint32 low) { return ( (uint64)high << 32 ) | low; }
+
+    /* Keeps the indexes of a contained item up to date once its flag or owner changed in place.
+     */
+    void _UpdateIndexes(InventoryItemRef item, EVEItemFlags oldFlag, uint32 oldOwnerID);
+    void _Index(InventoryItemRef item);
+    void _Unindex(uint32 itemID, EVEItemFlags flag, uint32 ownerID, uint32 typeID);
+    /* Keeps the stored volume up to date once the quantity or volume of a contained item changed.
+     */
+    void _UpdateVolume(InventoryItemRef item);
+
     bool mContentsLoaded;
-    std::map<uint32, InventoryItemRef> mContents;    //maps item ID to its instance. we own a ref to all of these.
+    ItemMap mContents;    //maps item ID to its instance. we own a ref to all of these.
+
+    //secondary indexes of mContents, so the lookups by flag only visit the items they return
+    std::map<uint32, ItemMap> mByFlag;          //by flag
+    std::map<uint64, ItemMap> mByFlagOwner;     //by flag and ownerID
+    std::map<uint64, ItemMap> mByFlagType;      //by flag and typeID, for stacking
+
+    //running volume aggregates; every item subtracts exactly what it added
+    std::map<uint32, double> mStoredVolumes;    //by flag
+    std::map<uint32, double> mItemVolumes;      //by itemID
 };
 
 class InventoryEx
@@ -109,6 +138,7 @@ public:
     double GetRemainingCapacity(EVEItemFlags flag) const { return GetCapacity( flag ) - GetStoredVolume( flag ); }
 
     void ValidateAddItem(EVEItemFlags flag, InventoryItemRef item) const;
+    void ValidateAddItems(EVEItemFlags flag, const std::vector<InventoryItemRef> &items) const;
 };
 
 #endif /* !__INVENTORY__H__INCL__ */
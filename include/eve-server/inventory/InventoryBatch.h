@@ -0,0 +1,152 @@
+/*
+    ------------------------------------------------------------------------------------
+    LICENSE:
+    ------------------------------------------------------------------------------------
+    This file is part of EVEmu: EVE Online Server Emulator
+    Copyright 2006 - 2011 The EVEmu Team
+    For the latest information visit http://evemu.org
+    ------------------------------------------------------------------------------------
+    This program is free software; you can redistribute it and/or modify it under
+    the terms of the GNU Lesser General Public License as published by the Free Software
+    Foundation; either version 2 of the License, or (at your option) any later
+    version.
+
+    This program is distributed in the hope that it will be useful, but WITHOUT
+    ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+    FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public License along with
+    this program; if not, write to the Free Software Foundation, Inc., 59 Temple
+    Place - Suite 330, Boston, MA 02111-1307, USA, or go to
+    http://www.gnu.org/copyleft/lesser.txt.
+    ------------------------------------------------------------------------------------
+    Author:     EVEmu Team
+*/
+
+
+#ifndef __INVENTORY__INVENTORY_BATCH_H__INCL__
+#define __INVENTORY__INVENTORY_BATCH_H__INCL__
+
+#include "inventory/InventoryItem.h"
+#include "utils/Singleton.h"
+
+/**
+ * @brief Batched inventory changes.
+ *
+ * While a batch is open, the item saves are queued by the
+ * InventoryWriteBehind and the OnItemChange notifications are held
+ * back, coalesced per recipient and item: the changes of an item keep
+ * the oldest previous value of every column and are sent with the row
+ * of the item as it is when the batch ends. Ending the outermost batch
+ * writes the saves at once and sends every recipient one OnMultiEvent
+ * with all its item changes. Columns which are back at their previous
+ * value are left out, and so are changes with no column left.
+ *
+ * The main loop keeps a batch open for the whole tick, so all the
+ * changes of an item within a tick are sent as one and the item is
+ * written once.
+ *
+ * Batches nest; open them with a Scope, so they end even when
+ * a change throws.
+ *
+ * Not thread-safe; meant to be used from the main loop.
+ *
+ * @author EVEmu Team
+ */
+class InventoryBatch
+: public Singleton< InventoryBatch >
+{
+public:
+    /**
+     * @brief Keeps a batch open for its lifetime.
+     */
+    class Scope
+    {
+    public:
+        Scope() { InventoryBatch::get().Begin(); }
+        ~Scope() { InventoryBatch::get().End(); }
+    };
+
+    /**
+     * @brief Statistics of the batches.
+     */
+    struct Stats
+    {
+        Stats() { Reset(); }
+
+        void Reset()
+        {
+            batches = 0;
+            changes = 0;
+            coalesced = 0;
+            reverted = 0;
+            notifications = 0;
+        }
+
+        /// Number of outermost batches ended.
+        uint32 batches;
+        /// Number of item changes held back.
+        uint32 changes;
+        /// Number of them merged into a change of the same item.
+        uint32 coalesced;
+        /// Number of merged changes dropped as the item ended up unchanged.
+        uint32 reverted;
+        /// Number of OnMultiEvent notifications sent.
+        uint32 notifications;
+    };
+
+    InventoryBatch();
+
+    /** @return True if a batch is open. */
+    bool IsOpen() const { return 0 < mDepth; }
+    /** @return Statistics since the last ResetStats(). */
+    const Stats& stats() const { return mStats; }
+    /** @brief Resets the statistics. */
+    void ResetStats() { mStats.Reset(); }
+
+    /** @brief Opens a batch. */
+    void Begin();
+    /** @brief Closes a batch; the outermost one writes the saves and sends the notifications. */
+    void End();
+
+    /**
+     * @brief Holds back an OnItemChange notification until the batch ends.
+     *
+     * @param[in] toID    The character to notify.
+     * @param[in] item    The changed item.
+     * @param[in] changes Previous values of the changed columns; consumed and cleared.
+     */
+    void QueueItemChange( uint32 toID, InventoryItemRef item, std::map<int32, PyRep*>& changes );
+
+protected:
+    struct PendingChange
+    {
+        InventoryItemRef item;
+        std::map<int32, PyRep*> changes;
+    };
+
+    /// Key of a pending change: the recipient and the itemID.
+    typedef std::pair<uint32, uint32> ChangeKey;
+
+    void _SendChanges();
+    /**
+     * @brief Drops the columns of a change which are back at their previous value.
+     *
+     * @return True if any column is left.
+     */
+    static bool _DropUnchanged( PendingChange& pending );
+
+    /// Number of open batches.
+    uint32 mDepth;
+    /// The held back item changes.
+    std::map<ChangeKey, PendingChange> mChanges;
+
+    /// Statistics.
+    Stats mStats;
+};
+
+/// A macro for easier access to the singleton.
+#define sInventoryBatch \
+    ( InventoryBatch::get() )
+
+#endif /* !__INVENTORY__INVENTORY_BATCH_H__INCL__ */
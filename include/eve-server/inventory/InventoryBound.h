@@ -58,9 +58,14 @@ protected:
     Dispatcher *const m_dispatch;
 
     Inventory &mInventory;
+    InventoryItemRef mItem;     //keeps the inventory loaded while it is bound
     EVEItemFlags mFlag;
 
-    PyRep *_ExecAdd(Client *c, const std::vector<int32> &items, uint32 quantity, EVEItemFlags flag);
+    /**
+     * @param[in] items The itemIDs; std::vector<int32> or the borrowed PyIntListView.
+     */
+    template<typename Items>
+    PyRep *_ExecAdd(Client *c, const Items &items, uint32 quantity, EVEItemFlags flag);
 };
 
 #endif//_INVENTORY_BOUND_H
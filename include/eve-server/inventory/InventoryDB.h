@@ -30,6 +30,7 @@
 #include "inventory/ItemRef.h"
 
 class EVEAttributeMgr;
+class DBSnapshotRow;
 
 class CategoryData;
 
@@ -50,6 +51,9 @@ class CelestialObjectData;
 class SolarSystemData;
 class StationData;
 
+/// Saved attributes of an item: pairs of attributeID and value.
+typedef std::vector< std::pair<uint32, EvilNumber> > ItemAttributeList;
+
 class InventoryDB
 : public ServiceDB
 {
@@ -59,18 +63,24 @@ public:
      * (invCategories)
      */
     bool GetCategory(EVEItemCategories category, CategoryData &into);
+    /** Decodes a row of the static data snapshot's category table; false if it has wrong columns. */
+    static bool DecodeCategory(const DBSnapshotRow &row, CategoryData &into);
 
     /*
      * Group stuff
      * (invGroups)
      */
     bool GetGroup(uint32 groupID, GroupData &into);
+    /** Decodes a row of the static data snapshot's group table; false if it has wrong columns. */
+    static bool DecodeGroup(const DBSnapshotRow &row, GroupData &into);
 
     /*
      * Type stuff
      * (invTypes, invBlueprintTypes, bloodlineTypes, chrBloodlines, invShipTypes, staStationTypes)
      */
     bool GetType(uint32 typeID, TypeData &into);
+    /** Decodes a row of the static data snapshot's type table; false if it has wrong columns. */
+    static bool DecodeType(const DBSnapshotRow &row, TypeData &into);
 
     bool GetBlueprintType(uint32 blueprintTypeID, BlueprintTypeData &into);
 
@@ -156,12 +166,67 @@ public:
     bool GetItem(uint32 itemID, ItemData &into);
 
     uint32 NewItem(const ItemData &data);
+    /**
+     * Inserts item with its own ID; for the transient items being persisted.
+     */
+    bool NewItem(uint32 itemID, const ItemData &data);
+    /**
+     * Inserts items with a single multi-row INSERT.
+     *
+     * The IDs of such an insert are consecutive as long as nothing else
+     * inserts into entity meanwhile, which holds since the items are
+     * created from the main loop only.
+     *
+     * @param[in] data Data of the items.
+     * @param[out] into IDs of the items, in the order of data.
+     * @return True on success.
+     */
+    bool NewItems(const std::vector<ItemData> &data, std::vector<uint32> &into);
+    /**
+     * Gets the highest item ID in a range.
+     *
+     * @param[in] fromID The first ID of the range.
+     * @param[in] toID The ID past the range.
+     * @param[out] into The highest ID; 0 if there is no item in the range.
+     */
+    bool GetLastItemID(uint32 fromID, uint32 toID, uint32 &into);
     bool SaveItem(uint32 itemID, const ItemData &data);
     bool DeleteItem(uint32 itemID);
 
     bool GetItemContents(uint32 itemID, std::vector<uint32> &into);
     bool GetItemContents(uint32 itemID, EVEItemFlags flag, std::vector<uint32> &into);
     bool GetItemContents(uint32 itemID, EVEItemFlags flag, uint32 ownerID, std::vector<uint32> &into);
+    /**
+     * Loads data of all items in given containers by a single query.
+     *
+     * @param[in] containerIDs IDs of the containers.
+     * @param[out] into Data of the items, by item ID.
+     * @return True if load was successful, false if not.
+     */
+    bool GetItemContents(const std::vector<uint32> &containerIDs, std::map<uint32, ItemData> &into);
+    /**
+     * Loads saved attributes of all items in given containers by a single query.
+     *
+     * @param[in] containerIDs IDs of the containers.
+     * @param[out] into Attributes of the items, by item ID; items with no saved attributes are left out.
+     * @return True if load was successful, false if not.
+     */
+    bool GetItemContentsAttributes(const std::vector<uint32> &containerIDs, std::map<uint32, ItemAttributeList> &into);
+    /**
+     * Loads what entering the game with a character loads: the character, its ship,
+     * their contents and all their attributes, by three queries.
+     *
+     * Safe to call from a worker thread; the caller must flush sInventoryWriteBehind first.
+     *
+     * @param[in] characterID ID of the character.
+     * @param[out] shipID ID of the active ship.
+     * @param[out] solarSystemID ID of the solar system the character is in.
+     * @param[out] items Data of the items, by item ID.
+     * @param[out] attributes Attributes of the items, by item ID; items with no saved attributes are left out.
+     * @return True if load was successful, false if not.
+     */
+    static bool GetLoginItems(uint32 characterID, uint32 &shipID, uint32 &solarSystemID,
+                              std::map<uint32, ItemData> &items, std::map<uint32, ItemAttributeList> &attributes);
 
     /*
      * Item attribute stuff
@@ -199,7 +264,36 @@ public:
     bool GetCorpMemberInfo(uint32 characterID, CorpMemberInfo &into);
 
     bool NewCharacter(uint32 characterID, const CharacterData &data, const CharacterAppearance &appData, const CorpMemberInfo &corpData);
+    /**
+     * Inserts new character along with its starting items by a single transaction,
+     * so either all of them are there or none.
+     *
+     * The items are owned by the character; those with no locationID go into it.
+     * Their attributes are inserted too, so nothing needs saving once they are loaded.
+     *
+     * @param[in] data Item data of the character.
+     * @param[in] charData Character data.
+     * @param[in] corpData Character's corporation-membership data.
+     * @param[in] attributes Attributes of the character.
+     * @param[in] items Data of the items.
+     * @param[in] itemAttributes Attributes of the items, in the order of items.
+     * @param[in] shipIndex Index of the character's active ship in items.
+     * @param[out] characterID ID of the character.
+     * @param[out] itemIDs IDs of the items, in the order of items.
+     * @return True on success.
+     */
+    bool NewCharacterWithItems(const ItemData &data, const CharacterData &charData, const CorpMemberInfo &corpData,
+                               const ItemAttributeList &attributes, const std::vector<ItemData> &items,
+                               const std::vector<ItemAttributeList> &itemAttributes, size_t shipIndex,
+                               uint32 &characterID, std::vector<uint32> &itemIDs);
     bool SaveCharacter(uint32 characterID, const CharacterData &data);
+    /**
+     * Saves the location of characters which moved to the same place by a single statement.
+     *
+     * @param[in] characterIDs The characters.
+     * @return True if the update succeeds, false if fails.
+     */
+    static bool SaveCharacterLocations(const std::vector<uint32> &characterIDs, uint32 stationID, uint32 solarSystemID, uint32 constellationID, uint32 regionID);
     bool SaveCorpMemberInfo(uint32 characterID, const CorpMemberInfo &data);
     bool DeleteCharacter(uint32 characterID);
 
@@ -215,17 +309,33 @@ public:
      *
      * @param[in] characterID ID of character whose queue should be loaded.
      * @param[in] into SkillQueue into which loaded data should be stored.
+     * @param[out] firstIndex orderIndex of the first skill of the queue.
      * @return True if load succeeds, false if fails.
      */
-    bool LoadSkillQueue(uint32 characterID, SkillQueue &into);
+    bool LoadSkillQueue(uint32 characterID, SkillQueue &into, uint32 &firstIndex);
     /**
      * Saves skill queue.
      *
+     * Only the difference to the saved queue is written: skills taken
+     * off the front are deleted, skills added behind the ones kept are
+     * inserted, so finishing a skill does not rewrite the whole queue.
+     *
      * @param[in] characterID ID of character whose skill queue is saved.
+     * @param[in] saved The queue as it was last loaded or saved.
+     * @param[in,out] firstIndex orderIndex of the first skill of @a saved; updated for @a queue.
      * @param[in] queue Queue to save.
      * @return True if save succeeds, false if fails.
      */
-    bool SaveSkillQueue(uint32 characterID, const SkillQueue &queue);
+    bool SaveSkillQueue(uint32 characterID, const SkillQueue &saved, uint32 &firstIndex, const SkillQueue &queue);
+    /**
+     * Finds offline characters whose skill in training is due.
+     *
+     * @param[in] now The current time (Win32 time).
+     * @param[in] limit The most characters returned.
+     * @param[out] into IDs of the characters.
+     * @return True if query succeeds, false if fails.
+     */
+    bool GetOfflineCharactersWithDueSkills(uint64 now, uint32 limit, std::vector<uint32> &into);
     // Certificates:
     struct currentCertificates {
         uint32 certificateID;
@@ -251,6 +361,14 @@ public:
     * @return True if save succeds, false if fails.
     */
     bool SaveCertificates( uint32 characterID, const Certificates &from );
+    /**
+    * Adds newly granted certificates by a single statement.
+    *
+    * @param[in] characterID ID of the character.
+    * @param[in] added Certificates to add.
+    * @return True if the insert succeeds, false if fails.
+    */
+    bool AddCertificates( uint32 characterID, const Certificates &added );
 
     /*
      * Celestial object stuff
@@ -105,6 +105,47 @@ public:
      */
     static InventoryItemRef Spawn(ItemFactory &factory, ItemData &data);
 
+    /**
+     * @brief Accounts the items (of all classes) to the "items" MemoryTag.
+     */
+    static void* operator new( size_t size ) { return sMemoryTag.Allocate( size ); }
+    static void operator delete( void* p, size_t size ) { sMemoryTag.Free( p, size ); }
+    static MemoryTag sMemoryTag;
+
+    /**
+     * Spawns item which lives in memory only, until Persist() is called.
+     *
+     * @param[in] factory
+     * @param[in] itemID Transient ID of the item.
+     * @param[in] data Item data.
+     * @return Ref to new item; NULL if the type is unknown or is not of the class.
+     */
+    template<class _Ty>
+    static RefPtr<_Ty> SpawnTransient(ItemFactory &factory, uint32 itemID, ItemData &data)
+    {
+        // obtain type of new item
+        const ItemType *type = factory.GetType( data.typeID );
+        if( type == NULL )
+            return RefPtr<_Ty>();
+
+        // fix the name (if empty)
+        if( data.name.empty() )
+            data.name = type->name();
+
+        // no DB row to load from, build it from the data
+        RefPtr<_Ty> i = _Ty::template _LoadItem<_Ty>( factory, itemID, *type, data );
+        if( !i )
+            return RefPtr<_Ty>();
+
+        InventoryItemRef item( i );
+        item->m_transient = true;
+        if( !item->_Load() )
+            return RefPtr<_Ty>();
+        item->_TransientLoaded();
+
+        return i;
+    }
+
     /*
      * Primary public interface:
      */
@@ -125,6 +166,13 @@ public:
      * Helper routines:
      */
     virtual void Delete();  //remove the item from the DB.
+    /**
+     * Writes a transient item to the DB, along with its contents and its transient
+     * locations; it is an ordinary item from then on. Does nothing to other items.
+     *
+     * Called once a player takes the item over, see Move() and ChangeOwner().
+     */
+    void Persist();
     virtual InventoryItemRef Split(int32 qty_to_take, bool notify=true);
     virtual bool Merge(InventoryItemRef to_merge, uint32 qty=0, bool notify=true);
 
@@ -149,6 +197,7 @@ public:
      * Public Fields:
      */
     uint32                  itemID() const      { return m_itemID; }
+    bool                    IsTransient() const { return m_transient; }
     const std::string &     itemName() const    { return m_itemName; }
     const ItemType &        type() const        { return m_type; }
     uint32                  ownerID() const     { return m_ownerID; }
@@ -190,6 +239,9 @@ private:
     AttributeMap mAttributeMap;
     AttributeMap mDefaultAttributeMap;
 public:
+    /** @return Number of the attributes held in memory, including the defaults. */
+    size_t GetAttributeCount() const { return mAttributeMap.size() + mDefaultAttributeMap.size(); }
+
     bool SetAttribute(uint32 attributeID, int num, bool notify = true);
     bool SetAttribute(uint32 attributeID, uint32 num, bool notify = true);
     bool SetAttribute(uint32 attributeID, int64 num, bool notify = true);
@@ -199,6 +251,8 @@ public:
 
     EvilNumber GetAttribute(uint32 attributeID);
     EvilNumber GetAttribute(const uint32 attributeID) const;
+    /** @return the attribute as a double, skipping the EvilNumber round trip; meant for the per tick readers. */
+    double GetAttributeValue(uint32 attributeID) const;
 
     EvilNumber GetDefaultAttribute(uint32 attributeID);
     EvilNumber GetDefaultAttribute(const uint32 attributeID) const;
@@ -263,9 +317,9 @@ protected:
     template<class _Ty>
     static RefPtr<_Ty> _Load(ItemFactory &factory, uint32 itemID)
     {
-        // pull the item info
+        // pull the item info, unless it has been preloaded
         ItemData data;
-        if( !factory.db().GetItem( itemID, data ) )
+        if( !factory.TakePreloadedItem( itemID, data ) && !factory.db().GetItem( itemID, data ) )
             return RefPtr<_Ty>();
 
         // obtain type
@@ -284,6 +338,9 @@ protected:
     );
 
     virtual bool _Load();
+    /* a transient inventory has nothing in the DB, so its contents are loaded already.
+     */
+    void _TransientLoaded();
 
     static uint32 _Spawn(ItemFactory &factory,
         // InventoryItem stuff:
@@ -315,6 +372,7 @@ protected:
     int32               m_quantity;
     GPoint              m_position;
     std::string         m_customInfo;
+    bool                m_transient;  //in memory only, see Persist()
 };
 
 #endif
@@ -0,0 +1,214 @@
+/*
+    ------------------------------------------------------------------------------------
+    LICENSE:
+    ------------------------------------------------------------------------------------
+    This file is part of EVEmu: EVE Online Server Emulator
+    Copyright 2006 - 2011 The EVEmu Team
+    For the latest information visit http://evemu.org
+    ------------------------------------------------------------------------------------
+    This program is free software; you can redistribute it and/or modify it under
+    the terms of the GNU Lesser General Public License as published by the Free Software
+    Foundation; either version 2 of the License, or (at your option) any later
+    version.
+
+    This program is distributed in the hope that it will be useful, but WITHOUT
+    ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+    FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public License along with
+    this program; if not, write to the Free Software Foundation, Inc., 59 Temple
+    Place - Suite 330, Boston, MA 02111-1307, USA, or go to
+    http://www.gnu.org/copyleft/lesser.txt.
+    ------------------------------------------------------------------------------------
+    Author:     EVEmu Team
+*/
+
+#ifndef __INVENTORY__INVENTORY_WRITE_BEHIND_H__INCL__
+#define __INVENTORY__INVENTORY_WRITE_BEHIND_H__INCL__
+
+#include "inventory/InventoryItem.h"
+#include "market/MarketOrderBook.h"
+
+/**
+ * @brief Write-behind queue of item, attribute and market order saves.
+ *
+ * Instead of a statement per save, InventoryDB hands the saves over
+ * to the queue, which keeps only the latest value of every row and
+ * writes all of them at once every flush interval, as multi-row
+ * INSERT ... ON DUPLICATE KEY UPDATE statements in a single
+ * transaction. Reads of items and attributes flush the queue first,
+ * so they never see stale rows; the market orders are read from
+ * MarketOrderBook instead.
+ *
+ * Not thread-safe; meant to be used from the main loop.
+ *
+ * @author EVEmu Team
+ */
+class InventoryWriteBehind
+: public Singleton< InventoryWriteBehind >
+{
+public:
+    /**
+     * @brief Statistics of the queue.
+     */
+    struct Stats
+    {
+        Stats() { Reset(); }
+
+        void Reset()
+        {
+            queued = 0;
+            coalesced = 0;
+            flushes = 0;
+            rows = 0;
+            failures = 0;
+        }
+
+        /// Number of queued writes.
+        uint32 queued;
+        /// Number of queued writes which replaced a pending one.
+        uint32 coalesced;
+        /// Number of flushes which wrote anything.
+        uint32 flushes;
+        /// Number of written rows.
+        uint32 rows;
+        /// Number of flushes which failed.
+        uint32 failures;
+    };
+
+    /**
+     * @brief Creates queue which writes everything through.
+     */
+    InventoryWriteBehind();
+
+    /** @return True if the saves are queued. */
+    bool IsEnabled() const { return 0 < mFlushInterval || 0 < mBatchDepth; }
+    /** @return True if there are writes pending. */
+    bool IsPending() const { return !mItems.empty() || !mAttributes.empty() || !mMarketOrders.empty(); }
+    /** @return Statistics since the last ResetStats(). */
+    const Stats& stats() const { return mStats; }
+
+    /**
+     * @brief Sets the flush interval.
+     *
+     * @param[in] interval Time (in milliseconds) a write may stay
+     *                     queued; 0 disables the queueing.
+     */
+    void SetFlushInterval( uint32 interval );
+
+    /**
+     * @brief Queues a save of the item's entity row.
+     */
+    void SaveItem( uint32 itemID, const ItemData& data );
+    /**
+     * @brief Queues a save of an integer attribute.
+     */
+    void SaveAttribute( uint32 itemID, uint32 attributeID, int64 value );
+    /**
+     * @brief Queues a save of a real attribute.
+     */
+    void SaveAttribute( uint32 itemID, uint32 attributeID, double value );
+    /**
+     * @brief Queues a removal of an attribute.
+     */
+    void EraseAttribute( uint32 itemID, uint32 attributeID );
+    /**
+     * @brief Drops the pending writes of an item.
+     *
+     * Must be called before the item (or all its attributes)
+     * is deleted from the database, so the flush does not bring
+     * the rows back.
+     *
+     * @param[in] itemID         The item.
+     * @param[in] attributesOnly Whether to keep the entity row save.
+     */
+    void Forget( uint32 itemID, bool attributesOnly = false );
+
+    /**
+     * @brief Queues a save of a market order.
+     */
+    void SaveMarketOrder( const MarketOrder& order );
+    /**
+     * @brief Queues a removal of a market order.
+     */
+    void EraseMarketOrder( uint32 orderID );
+
+    /**
+     * @brief Flushes the queue if the oldest write is due.
+     *
+     * @param[in] now The current time (in milliseconds).
+     */
+    void Process( uint32 now );
+    /**
+     * @brief Opens a batch: the saves are queued until the outermost batch ends,
+     *        even if the queueing is disabled.
+     */
+    void BeginBatch() { ++mBatchDepth; }
+    /**
+     * @brief Closes a batch; the outermost one writes the queue at once if the queueing is disabled.
+     */
+    void EndBatch();
+
+    /**
+     * @brief Writes all the pending writes.
+     *
+     * @return True on success (or if nothing was pending).
+     */
+    bool Flush();
+
+    /**
+     * @brief Resets the statistics.
+     */
+    void ResetStats() { mStats.Reset(); }
+
+protected:
+    /**
+     * @brief Pending write of an attribute.
+     */
+    struct AttributeWrite
+    {
+        enum Kind { Int, Real, Erase };
+
+        Kind kind;
+        int64 i;
+        double d;
+    };
+    /// Key of an attribute row: itemID and attributeID.
+    typedef std::pair<uint32, uint32> AttributeKey;
+
+    /**
+     * @brief Pending write of a market order.
+     */
+    struct MarketOrderWrite
+    {
+        bool erase;
+        MarketOrder order;
+    };
+
+    void _QueueAttribute( uint32 itemID, uint32 attributeID, const AttributeWrite& write );
+    void _QueueMarketOrder( uint32 orderID, const MarketOrderWrite& write );
+    void _Queued( bool coalesced );
+
+    /// The latest entity rows, by itemID.
+    std::map<uint32, ItemData> mItems;
+    /// The latest attribute rows.
+    std::map<AttributeKey, AttributeWrite> mAttributes;
+    /// The latest market order rows, by orderID.
+    std::map<uint32, MarketOrderWrite> mMarketOrders;
+
+    /// Time a write may stay queued.
+    uint32 mFlushInterval;
+    /// Time of the oldest pending write.
+    uint32 mFirstQueued;
+    /// Number of open batches.
+    uint32 mBatchDepth;
+
+    /// Statistics.
+    Stats mStats;
+};
+
+/// A macro for easier access to the singleton.
+#define sInventoryWriteBehind \
+    ( InventoryWriteBehind::get() )
+
+#endif /* !__INVENTORY__INVENTORY_WRITE_BEHIND_H__INCL__ */
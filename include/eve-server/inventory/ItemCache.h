@@ -0,0 +1,182 @@
+/*
+    ------------------------------------------------------------------------------------
+    LICENSE:
+    ------------------------------------------------------------------------------------
+    This file is part of EVEmu: EVE Online Server Emulator
+    Copyright 2006 - 2011 The EVEmu Team
+    For the latest information visit http://evemu.org
+    ------------------------------------------------------------------------------------
+    This program is free software; you can redistribute it and/or modify it under
+    the terms of the GNU Lesser General Public License as published by the Free Software
+    Foundation; either version 2 of the License, or (at your option) any later
+    version.
+
+    This program is distributed in the hope that it will be useful, but WITHOUT
+    ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+    FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public License along with
+    this program; if not, write to the Free Software Foundation, Inc., 59 Temple
+    Place - Suite 330, Boston, MA 02111-1307, USA, or go to
+    http://www.gnu.org/copyleft/lesser.txt.
+    ------------------------------------------------------------------------------------
+    Author:     EVEmu Team
+*/
+
+#ifndef __INVENTORY__ITEM_CACHE_H__INCL__
+#define __INVENTORY__ITEM_CACHE_H__INCL__
+
+#include "inventory/ItemRef.h"
+
+/**
+ * @brief Loaded items of ItemFactory, by item ID.
+ *
+ * Items are hashed by their ID and kept in the order of their last
+ * use. Once there are more of them than the capacity, Trim() drops
+ * the least recently used items nothing else refers to: no
+ * inventory holds them as contents, no entity, client or
+ * call has a ref to them, so they are loaded again if ever needed.
+ * Referenced items are never dropped, so the capacity may be exceeded.
+ *
+ * Not thread-safe; meant to be used from the main loop.
+ *
+ * @author EVEmu Team
+ */
+class ItemCache
+{
+public:
+    /**
+     * @brief Statistics of the cache.
+     */
+    struct Stats
+    {
+        Stats() { Reset(); }
+
+        void Reset()
+        {
+            hits = 0;
+            misses = 0;
+            evictions = 0;
+            pinned = 0;
+        }
+
+        /// Number of lookups which found the item.
+        uint32 hits;
+        /// Number of lookups which did not.
+        uint32 misses;
+        /// Number of dropped items.
+        uint32 evictions;
+        /// Number of items Trim() had to skip as referenced.
+        uint32 pinned;
+    };
+
+    /**
+     * @brief Creates empty cache with no capacity limit.
+     */
+    ItemCache();
+
+    /** @return Number of resident items. */
+    size_t size() const { return mItems.size(); }
+    /** @return Estimated memory (in bytes) taken by the resident items. */
+    size_t bytes() const { return mBytes; }
+    /** @return Statistics since the last ResetStats(). */
+    const Stats& stats() const { return mStats; }
+
+    /**
+     * @brief Sets the number of items above which Trim() drops some.
+     *
+     * @param[in] capacity The capacity; 0 for no limit.
+     */
+    void SetCapacity( size_t capacity ) { mCapacity = capacity; }
+
+    /**
+     * @brief Looks up an item, marking it as recently used.
+     *
+     * @param[in] itemID The item.
+     *
+     * @return The item; NULL ref if not resident.
+     */
+    InventoryItemRef Find( uint32 itemID );
+    /**
+     * @brief Checks whether an item is resident, without touching it.
+     */
+    bool Contains( uint32 itemID ) const { return mItems.find( itemID ) != mItems.end(); }
+
+    /**
+     * @brief Adds an item.
+     *
+     * Does nothing if an item with the same ID is resident already.
+     *
+     * @param[in] item The item.
+     *
+     * @return The resident item.
+     */
+    InventoryItemRef Insert( const InventoryItemRef& item );
+    /**
+     * @brief Removes an item.
+     *
+     * @param[in] itemID The item.
+     *
+     * @return False if the item was not resident.
+     */
+    bool Erase( uint32 itemID );
+    /**
+     * @brief Removes all items.
+     */
+    void Clear();
+
+    /**
+     * @brief Drops unreferenced items above the capacity.
+     *
+     * Changed attributes of the dropped items are saved first.
+     * Examines a bounded number of items per call; referenced ones
+     * are moved to the recent end, so they are not examined again
+     * until all the others were.
+     *
+     * @return Number of dropped items.
+     */
+    size_t Trim();
+
+    /**
+     * @brief Resets the statistics.
+     */
+    void ResetStats() { mStats.Reset(); }
+
+protected:
+    /// The most items Trim() examines per call.
+    static const size_t TRIM_SCAN_LIMIT;
+
+    typedef std::list<uint32> LRUList;
+
+    /**
+     * @brief A resident item.
+     */
+    struct Entry
+    {
+        /// The item.
+        InventoryItemRef item;
+        /// Estimated size of the item.
+        size_t size;
+        /// Position in the LRU list.
+        LRUList::iterator lru;
+    };
+    typedef std::tr1::unordered_map<uint32, Entry> ItemMap;
+
+    /** @return Estimated memory (in bytes) taken by given item. */
+    static size_t _EstimateSize( const InventoryItem& item );
+
+    /// The items, by ID.
+    ItemMap mItems;
+    /// IDs of the items, most recently used first.
+    LRUList mLRU;
+
+    /// Number of items above which Trim() drops some; 0 for no limit.
+    size_t mCapacity;
+    /// Estimated memory taken by the items.
+    size_t mBytes;
+
+    /// Statistics.
+    Stats mStats;
+};
+
+#endif /* !__INVENTORY__ITEM_CACHE_H__INCL__ */
@@ -26,6 +26,7 @@
 #define EVE_ITEM_FACTORY_H
 
 #include "inventory/InventoryDB.h"
+#include "inventory/ItemCache.h"
 #include "inventory/ItemRef.h"
 
 class ItemCategory;
@@ -40,6 +41,8 @@ class StationType;
 
 class Inventory;
 
+class DBSnapshot;
+
 class ItemFactory
 {
     friend class InventoryItem;    //only for access to _DeleteItem
@@ -50,6 +53,26 @@ public:
     EntityList& entity_list;    //we do not own this.
     InventoryDB& db() { return(m_db); }
 
+    /** @return The loaded items. */
+    const ItemCache& itemCache() const { return(m_items); }
+    /**
+     * Sets the number of loaded items above which unreferenced ones get dropped.
+     *
+     * @param[in] capacity The capacity; 0 keeps all items loaded.
+     */
+    void SetItemCacheCapacity(size_t capacity) { m_items.SetCapacity( capacity ); }
+    /**
+     * Drops unreferenced items over the capacity; called from the main loop,
+     * when nothing is holding items by plain pointers.
+     *
+     * @return Number of dropped items.
+     */
+    size_t TrimItemCache() { return m_items.Trim(); }
+    /**
+     * Resets the statistics of the loaded items.
+     */
+    void ResetItemCacheStats() { m_items.ResetStats(); }
+
     /*
      * Category stuff
      */
@@ -67,6 +90,34 @@ public:
 
     const BlueprintType *GetBlueprintType(uint32 blueprintTypeID);
 
+    /**
+     * Loads the categories, groups and types of static data snapshot.
+     *
+     * Once loaded, their data are taken from memory instead of being queried.
+     *
+     * @param[in] snapshot The snapshot; it is not needed afterwards.
+     * @return True on success; false if the snapshot is not complete, nothing is loaded then.
+     */
+    bool LoadStaticData(const DBSnapshot &snapshot);
+    /**
+     * Gets data of category from the static data.
+     *
+     * @return True if found, false if it needs to be queried.
+     */
+    bool GetStaticCategory(EVEItemCategories category, CategoryData &into) const;
+    /**
+     * Gets data of group from the static data.
+     *
+     * @return True if found, false if it needs to be queried.
+     */
+    bool GetStaticGroup(uint32 groupID, GroupData &into) const;
+    /**
+     * Gets data of type from the static data.
+     *
+     * @return True if found, false if it needs to be queried.
+     */
+    bool GetStaticType(uint32 typeID, TypeData &into) const;
+
     /**
      * Loads character type, caches it and returns it.
      *
@@ -177,8 +228,93 @@ public:
      */
     CargoContainerRef GetCargoContainer(uint32 containerID);
 
+    /**
+     * Fetches data of all items in given containers, including their
+     * attributes, by two queries; loading of these items then queries nothing.
+     *
+     * Items which are loaded already are left out.
+     *
+     * @param[in] containerIDs IDs of the containers.
+     * @param[out] into Data of the items, by item ID.
+     * @return True if successful, false if not.
+     */
+    bool PreloadItems(const std::vector<uint32> &containerIDs, std::map<uint32, ItemData> &into);
+    /**
+     * Takes preloaded data of item.
+     *
+     * @param[in] itemID ID of the item.
+     * @param[out] into The data.
+     * @return True if the item was preloaded, false if it needs to be queried.
+     */
+    bool TakePreloadedItem(uint32 itemID, ItemData &into);
+    /**
+     * Takes preloaded attributes of item.
+     *
+     * @param[in] itemID ID of the item.
+     * @param[out] into The attributes.
+     * @return True if the item was preloaded, false if its attributes need to be queried.
+     */
+    bool TakePreloadedAttributes(uint32 itemID, ItemAttributeList &into);
+    /**
+     * Drops whatever is left of preloaded item which did not get loaded.
+     *
+     * @param[in] itemID ID of the item.
+     */
+    void DiscardPreloaded(uint32 itemID);
+    /**
+     * Hands over data fetched off the game thread (see InventoryDB::GetLoginItems()),
+     * to be taken as if preloaded.
+     *
+     * Items which are loaded already are left out. Contents of the given containers
+     * are known complete, so their PreloadItems() then queries nothing.
+     *
+     * @param[in] containerIDs IDs of the containers whose contents were fetched.
+     * @param[in] items Data of the items, by item ID; consumed.
+     * @param[in] attributes Attributes of the items, by item ID; consumed.
+     * @param[out] itemIDs IDs of the items taken, for DiscardPrefetched().
+     */
+    void AddPrefetched(const std::vector<uint32> &containerIDs, std::map<uint32, ItemData> &items,
+                       std::map<uint32, ItemAttributeList> &attributes, std::vector<uint32> &itemIDs);
+    /**
+     * Drops whatever is left of AddPrefetched() once the loads it was meant for are done,
+     * since it would get stale.
+     */
+    void DiscardPrefetched(const std::vector<uint32> &containerIDs, const std::vector<uint32> &itemIDs);
+
     //spawn a new item with the specified information, creating it in the DB as well.
     InventoryItemRef SpawnItem(ItemData &data);
+    /**
+     * Spawns plain items (materials, charges, commodities and alike)
+     * with a single insert; the items are loaded without any query.
+     *
+     * @param[in] data Data of the items; the empty names are filled.
+     * @param[out] into Refs to the new items, in the order of data.
+     * @return False if a type is unknown or needs a spawn of its own (see SpawnItem()), or the insert failed.
+     */
+    bool SpawnItems(std::vector<ItemData> &data, std::vector<InventoryItemRef> &into);
+    /**
+     * Spawns new item which lives in memory only, until a player takes it over
+     * (see InventoryItem::Persist()).
+     *
+     * Meant for the short-lived objects in space: the NPCs of the spawns and the
+     * objects of the dungeons, which come and go all the time.
+     *
+     * @param[in] data Item data.
+     * @return Ref to new item; NULL if the type is unknown or the transient IDs have run out.
+     */
+    InventoryItemRef SpawnTransientItem(ItemData &data);
+    /**
+     * Spawns new cargo container which lives in memory only, see SpawnTransientItem().
+     */
+    CargoContainerRef SpawnTransientCargoContainer(ItemData &data);
+    /**
+     * Spawns new structure which lives in memory only, see SpawnTransientItem().
+     */
+    StructureRef SpawnTransientStructure(ItemData &data);
+    /**
+     * @return True if the item is loaded and lives in memory only.
+     */
+    bool IsTransient(uint32 itemID);
     BlueprintRef SpawnBlueprint(ItemData &data, BlueprintData &bpData);
     /**
      * Spawns new character, caches it and returns it.
@@ -190,6 +326,26 @@ public:
      * @return Pointer to new Character object; NULL if spawn failed.
      */
     CharacterRef SpawnCharacter(ItemData &data, CharacterData &charData, CharacterAppearance &appData, CorpMemberInfo &corpData);
+    /**
+     * Spawns new character along with its starting items and ship by a single transaction
+     * (see InventoryDB::NewCharacterWithItems()); they are all loaded without any item or
+     * attribute query.
+     *
+     * @param[in] data Item data of the character.
+     * @param[in] charData Character data.
+     * @param[in] corpData Character's corporation-membership data.
+     * @param[in] attributes Attributes of the character.
+     * @param[in] items Data of the items; they are owned by the character, those with no locationID
+     *                  go into it. The empty names are filled.
+     * @param[in] itemAttributes Attributes of the items, in the order of items.
+     * @param[in] shipIndex Index of the character's active ship in items.
+     * @param[out] into Refs to the items, in the order of items.
+     * @return Ref to new character; NULL if the spawn failed.
+     */
+    CharacterRef SpawnCharacterWithItems(ItemData &data, CharacterData &charData, CorpMemberInfo &corpData,
+                                         ItemAttributeList &attributes, std::vector<ItemData> &items,
+                                         std::vector<ItemAttributeList> &itemAttributes, size_t shipIndex,
+                                         std::vector<InventoryItemRef> &into);
     /**
      * Spawns new ship.
      *
@@ -245,6 +401,25 @@ protected:
     /*
      * Member functions and variables:
      */
+    // Static data, loaded from snapshot:
+    template<class _Data>
+    struct StaticData {
+        const _Data *Find(uint32 id) const;
+
+        // the data, in order of the snapshot
+        std::vector<_Data> rows;
+        // position in rows + 1 by ID; 0 if there is none
+        std::vector<uint32> index;
+    };
+
+    template<class _Data>
+    static bool _LoadStaticData(const DBSnapshot &snapshot, const char *table,
+        bool (*decode)(const DBSnapshotRow &, _Data &), StaticData<_Data> &into);
+
+    StaticData<CategoryData> m_staticCategories;
+    StaticData<GroupData> m_staticGroups;
+    StaticData<TypeData> m_staticTypes;
+
     // Categories:
     std::map<EVEItemCategories, ItemCategory *> m_categories;
 
@@ -263,7 +438,18 @@ protected:
 
     void _DeleteItem(uint32 itemID);
 
-    std::map<uint32, InventoryItemRef> m_items;
+    template<class _Ty>
+    RefPtr<_Ty> _SpawnTransient(ItemData &data);
+
+    ItemCache m_items;
+    // The next ID of a transient item; 0 until the persisted ones are known:
+    uint32 m_nextTransientID;
+
+    // Preloaded items, waiting for their loads:
+    std::map<uint32, ItemData> m_preloadedItems;
+    std::map<uint32, ItemAttributeList> m_preloadedAttributes;
+    // Containers whose whole contents are among the preloaded items:
+    std::set<uint32> m_prefetchedContents;
 };
 
 
@@ -325,7 +325,7 @@ protected:
     {
         // pull data
         TypeData data;
-        if( !factory.db().GetType( typeID, data ) )
+        if( !factory.GetStaticType( typeID, data ) && !factory.db().GetType( typeID, data ) )
             return NULL;
 
         // obtain group
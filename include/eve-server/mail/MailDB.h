@@ -33,6 +33,26 @@ class PyString;
 class Call_CreateLabel;
 class Call_EditLabel;
 
+/**
+ * @brief A mail as one of its recipients sees it.
+ */
+struct MailHeader
+{
+    uint32 messageID;
+    uint32 senderID;
+    std::string toCharacterIDs;
+    uint32 toListID;
+    uint32 toCorpOrAllianceID;
+    std::string title;
+    uint64 sentDate;
+    /// The body in mailBody, shared by all the mails with the same body.
+    uint32 bodyID;
+    /// The status of the mail for the recipient.
+    uint32 statusMask;
+    uint32 labelMask;
+    bool unread;
+};
+
 class MailDB : public ServiceDB
 {
 public:
@@ -41,11 +61,36 @@ public:
     void DeleteLabel(int characterID, int labelID) const;
     void EditLabel(int characterID, Call_EditLabel& args) const;
 
-    PyString* GetMailBody(int id) const;
-    void SetMailUnread(int id, bool unread);
-    int SendMail(int sender, std::vector<int>& toCharacterIDs, int toListID, int toCorpOrAllianceID, std::string& title, std::string& body, int isReplyTo, int isForwardedFrom);
-    PyRep* GetNewMail(int charId);
-    PyRep* GetMailStatus(int charId);
+    /**
+     * @brief Obtains the mails of a character, oldest first.
+     */
+    bool GetMailbox(uint32 characterID, std::vector<MailHeader>& into) const;
+    /**
+     * @brief Stores a body, unless an equal one is stored already.
+     *
+     * @param[in]  compressed The deflated body.
+     * @param[out] shared     Whether an equal body was stored already.
+     *
+     * @return bodyID of the body; 0 on failure.
+     */
+    uint32 StoreBody(const std::string& compressed, bool& shared) const;
+    /**
+     * @return The deflated body; NULL on failure.
+     */
+    PyString* GetMailBody(uint32 bodyID) const;
+    /**
+     * @brief Inserts a mail; its messageID is assigned.
+     */
+    bool InsertMessage(MailHeader& header) const;
+    /**
+     * @brief Delivers a mail to a list of characters with a single statement.
+     */
+    bool InsertRecipients(uint32 messageID, const std::vector<uint32>& characterIDs) const;
+    /**
+     * @brief Delivers a mail to all the members of a corporation or alliance with a single statement.
+     */
+    bool InsertOwnerRecipients(uint32 messageID, uint32 ownerID) const;
+    void SetMailUnread(uint32 characterID, uint32 messageID, bool unread) const;
 
 protected:
     static int BitFromLabelID(int id);
@@ -0,0 +1,196 @@
+/*
+    ------------------------------------------------------------------------------------
+    LICENSE:
+    ------------------------------------------------------------------------------------
+    This file is part of EVEmu: EVE Online Server Emulator
+    Copyright 2006 - 2011 The EVEmu Team
+    For the latest information visit http://evemu.org
+    ------------------------------------------------------------------------------------
+    This program is free software; you can redistribute it and/or modify it under
+    the terms of the GNU Lesser General Public License as published by the Free Software
+    Foundation; either version 2 of the License, or (at your option) any later
+    version.
+
+    This program is distributed in the hope that it will be useful, but WITHOUT
+    ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+    FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public License along with
+    this program; if not, write to the Free Software Foundation, Inc., 59 Temple
+    Place - Suite 330, Boston, MA 02111-1307, USA, or go to
+    http://www.gnu.org/copyleft/lesser.txt.
+    ------------------------------------------------------------------------------------
+    Author:     EVEmu Team
+*/
+
+#ifndef __MAIL__MAIL_STORE_H__INCL__
+#define __MAIL__MAIL_STORE_H__INCL__
+
+#include "mail/MailDB.h"
+#include "utils/Singleton.h"
+
+/**
+ * @brief Storage of the mails, with the mailboxes of the online characters kept in memory.
+ *
+ * A mail is stored once in mailMessage, its body once in mailBody,
+ * shared by every mail with the same body, and every recipient gets
+ * a row of mailRecipient with its own status.
+ *
+ * The mailbox of a character is loaded by its first sync and kept
+ * until it logs out; the syncs, header queries and status changes
+ * are served from it, a sync returning only the mails newer than the
+ * last one the client has seen.
+ *
+ * A mail to a corporation or alliance is delivered to its members in
+ * the background: Process() hands the queued deliveries to sDBAsync
+ * in batches, so sending it never waits for the rows of all its
+ * recipients.
+ *
+ * Not thread-safe; meant to be used from the main loop.
+ *
+ * @author EVEmu Team
+ */
+class MailStore
+: public Singleton< MailStore >
+{
+public:
+    /**
+     * @brief Statistics of the store.
+     */
+    struct Stats
+    {
+        Stats() { Reset(); }
+
+        void Reset()
+        {
+            sent = 0;
+            sharedBodies = 0;
+            mailboxLoads = 0;
+            syncs = 0;
+            bodyHits = 0;
+            bodyMisses = 0;
+            deliveries = 0;
+            failedDeliveries = 0;
+        }
+
+        /// Number of mails sent.
+        uint32 sent;
+        /// Number of those whose body was stored already.
+        uint32 sharedBodies;
+        /// Number of mailboxes loaded.
+        uint32 mailboxLoads;
+        /// Number of syncs served from the mailboxes.
+        uint32 syncs;
+        /// Number of bodies served from the cache.
+        uint32 bodyHits;
+        /// Number of bodies which had to be queried.
+        uint32 bodyMisses;
+        /// Number of mails delivered to corporations and alliances in the background.
+        uint32 deliveries;
+        /// Number of those which failed.
+        uint32 failedDeliveries;
+    };
+
+    MailStore();
+
+    /** @return Number of resident mailboxes. */
+    size_t size() const { return mMailboxes.size(); }
+    /** @return Number of deliveries not done yet. */
+    size_t GetPendingCount() const { return mDeliveries.size() + mDelivering; }
+    /** @return Statistics since the last ResetStats(). */
+    const Stats& stats() const { return mStats; }
+    /** @brief Resets the statistics. */
+    void ResetStats() { mStats.Reset(); }
+
+    /**
+     * @brief Sends a mail.
+     *
+     * @param[in] senderID           The sender.
+     * @param[in] toCharacterIDs     The characters it is sent to.
+     * @param[in] toListID           The mailing list it is sent to; 0 if none.
+     * @param[in] toCorpOrAllianceID The corporation or alliance it is sent to; 0 if none.
+     * @param[in] title              The title.
+     * @param[in] body               The body.
+     *
+     * @return messageID of the mail; 0 on failure.
+     */
+    uint32 Send( uint32 senderID, const std::vector<int32>& toCharacterIDs, uint32 toListID, uint32 toCorpOrAllianceID,
+                 const std::string& title, const std::string& body );
+
+    /**
+     * @brief Syncs the mailbox of a character.
+     *
+     * @param[in] characterID The character.
+     * @param[in] lastSeenID  The newest mail the client has; 0 if none.
+     *
+     * @return A util.KeyVal of the mails newer than @a lastSeenID and the status of all; NULL on failure.
+     */
+    PyObject* Sync( uint32 characterID, uint32 lastSeenID );
+    /**
+     * @return A CRowSet of the headers of the mails of a character; NULL on failure.
+     */
+    PyRep* GetHeaders( uint32 characterID, const std::vector<int32>& messageIDs );
+    /**
+     * @return The deflated body of a mail of a character; NULL if it isn't one.
+     */
+    PyString* GetBody( uint32 characterID, uint32 messageID );
+    /**
+     * @brief Marks a mail of a character as read or unread.
+     */
+    void SetUnread( uint32 characterID, uint32 messageID, bool unread );
+
+    /**
+     * @brief Drops the mailbox of a character logging out.
+     */
+    void Forget( uint32 characterID ) { mMailboxes.erase( characterID ); }
+
+    /**
+     * @brief Starts the next batch of deliveries, unless one is running.
+     */
+    void Process();
+
+protected:
+    class DeliveryQuery;
+
+    /// A mailbox: the mails of a character, by messageID.
+    typedef std::map< uint32, MailHeader > Mailbox;
+
+    /**
+     * @brief Obtains the mailbox of a character, loading it if needed.
+     *
+     * @return The mailbox; NULL on failure.
+     */
+    Mailbox* _GetMailbox( uint32 characterID );
+    /**
+     * @brief Adds a mail to the resident mailbox of a character, if it has one.
+     */
+    void _AddToMailbox( uint32 characterID, const MailHeader& header );
+    /**
+     * @brief Adds the delivered mails to the resident mailboxes of the online members.
+     */
+    void _CompleteDelivery( DeliveryQuery& query, bool success );
+
+    MailDB mDB;
+
+    /// The mailboxes of the online characters.
+    std::tr1::unordered_map< uint32, Mailbox > mMailboxes;
+
+    /// The cached bodies, by bodyID.
+    std::map< uint32, std::string > mBodies;
+    /// bodyIDs of the cached bodies, oldest first.
+    std::deque< uint32 > mBodyOrder;
+
+    /// Mails to deliver to the members of a corporation or alliance.
+    std::deque< MailHeader > mDeliveries;
+    /// Number of deliveries in the running batch.
+    size_t mDelivering;
+
+    /// Statistics.
+    Stats mStats;
+};
+
+/// A macro for easier access to the singleton.
+#define sMailStore \
+    ( MailStore::get() )
+
+#endif /* !__MAIL__MAIL_STORE_H__INCL__ */
@@ -0,0 +1,196 @@
+/*
+    ------------------------------------------------------------------------------------
+    LICENSE:
+    ------------------------------------------------------------------------------------
+    This file is part of EVEmu: EVE Online Server Emulator
+    Copyright 2006 - 2011 The EVEmu Team
+    For the latest information visit http://evemu.org
+    ------------------------------------------------------------------------------------
+    This program is free software; you can redistribute it and/or modify it under
+    the terms of the GNU Lesser General Public License as published by the Free Software
+    Foundation; either version 2 of the License, or (at your option) any later
+    version.
+
+    This program is distributed in the hope that it will be useful, but WITHOUT
+    ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+    FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public License along with
+    this program; if not, write to the Free Software Foundation, Inc., 59 Temple
+    Place - Suite 330, Boston, MA 02111-1307, USA, or go to
+    http://www.gnu.org/copyleft/lesser.txt.
+    ------------------------------------------------------------------------------------
+    Author:     EVEmu Team
+*/
+
+#ifndef __MAIL__NOTIFICATION_QUEUE_H__INCL__
+#define __MAIL__NOTIFICATION_QUEUE_H__INCL__
+
+#include "utils/Singleton.h"
+
+/**
+ * @brief Queue of the notifications on their way to their receivers.
+ *
+ * Producers enqueue a notification for one or many receivers; it
+ * gets its notificationID right away, the same for all of them.
+ * Once per tick, Process() writes everything enqueued since the last
+ * tick with a few multi-row INSERTs, then pushes it to the online
+ * receivers, each of them getting a single OnMultiEvent with all of
+ * its notifications of the tick. A notification is encoded once for
+ * all its receivers.
+ *
+ * The offline receivers find their notifications in chrNotifications
+ * when they log in; so do the online ones, which are pushed only what
+ * arrives meanwhile.
+ *
+ * Not thread-safe; meant to be used from the main loop.
+ *
+ * @author EVEmu Team
+ */
+class NotificationQueue
+: public Singleton< NotificationQueue >
+{
+public:
+    /**
+     * @brief Statistics of the queue.
+     */
+    struct Stats
+    {
+        Stats() { Reset(); }
+
+        void Reset()
+        {
+            enqueued = 0;
+            persisted = 0;
+            inserts = 0;
+            failures = 0;
+            pushed = 0;
+            pushes = 0;
+            maxDepth = 0;
+            delivered = 0;
+            latency = 0;
+            maxLatency = 0;
+        }
+
+        /// Number of notifications enqueued.
+        uint32 enqueued;
+        /// Number of rows written, one per receiver.
+        uint32 persisted;
+        /// Number of INSERTs they took.
+        uint32 inserts;
+        /// Number of flushes which failed; their notifications are retried.
+        uint32 failures;
+        /// Number of notifications pushed to online receivers.
+        uint32 pushed;
+        /// Number of OnMultiEvents they took.
+        uint32 pushes;
+        /// Most notifications queued at once.
+        uint32 maxDepth;
+        /// Number of notifications written and pushed.
+        uint32 delivered;
+        /// Total time (in microseconds) from enqueueing to delivery.
+        uint64 latency;
+        /// Longest time (in microseconds) from enqueueing to delivery.
+        uint64 maxLatency;
+    };
+
+    NotificationQueue();
+
+    /** @return Number of notifications queued. */
+    size_t GetDepth() const { return mQueue.size(); }
+    /** @return Statistics since the last ResetStats(). */
+    const Stats& stats() const { return mStats; }
+    /** @brief Resets the statistics. */
+    void ResetStats() { mStats.Reset(); }
+
+    /**
+     * @brief Loads the last notificationID given out.
+     *
+     * @return True on success.
+     */
+    bool Load();
+
+    /**
+     * @brief Enqueues a notification for a receiver.
+     *
+     * @param[in] receiverID The receiver.
+     * @param[in] groupID    The group the client files the notification under.
+     * @param[in] typeID     The type of the notification.
+     * @param[in] senderID   The sender.
+     * @param[in] data       The data of the notification, as YAML.
+     *
+     * @return notificationID of the notification.
+     */
+    uint32 Enqueue( uint32 receiverID, uint32 groupID, uint32 typeID, uint32 senderID, const std::string& data );
+    /**
+     * @brief Enqueues a notification for many receivers, such as the members of a corporation.
+     */
+    uint32 Enqueue( const std::vector<uint32>& receiverIDs, uint32 groupID, uint32 typeID, uint32 senderID, const std::string& data );
+
+    /**
+     * @brief Writes and pushes everything enqueued.
+     *
+     * @return True on success, false if the notifications could not be written; they stay queued.
+     */
+    bool Process();
+
+    /**
+     * @return A tuple of util.Rows of the notifications of a group of a receiver; NULL on failure.
+     */
+    PyRep* GetByGroupID( uint32 receiverID, uint32 groupID );
+    /**
+     * @return A tuple of util.Rows of the unprocessed notifications of a receiver; NULL on failure.
+     */
+    PyRep* GetUnprocessed( uint32 receiverID );
+
+    /** @brief Marks the notifications of a group as processed with a single UPDATE. */
+    void MarkGroupAsProcessed( uint32 receiverID, uint32 groupID );
+    void MarkAllAsProcessed( uint32 receiverID );
+    void MarkAsProcessed( uint32 receiverID, const std::vector<uint32>& notificationIDs );
+
+    void DeleteGroup( uint32 receiverID, uint32 groupID );
+    void DeleteAll( uint32 receiverID );
+    void Delete( uint32 receiverID, const std::vector<uint32>& notificationIDs );
+
+protected:
+    /**
+     * @brief A queued notification.
+     */
+    struct Notification
+    {
+        uint32 notificationID;
+        uint32 groupID;
+        uint32 typeID;
+        uint32 senderID;
+        uint64 created;
+        std::string data;
+        std::vector<uint32> receiverIDs;
+        /// When it was enqueued (in microseconds).
+        uint64 enqueued;
+    };
+
+    /**
+     * @brief Writes everything enqueued.
+     *
+     * @return True on success.
+     */
+    bool _Persist();
+    /**
+     * @brief Pushes everything enqueued to the online receivers.
+     */
+    void _Push();
+
+    /// The queued notifications, oldest first.
+    std::vector< Notification > mQueue;
+    /// The last notificationID given out.
+    uint32 mLastID;
+
+    /// Statistics.
+    Stats mStats;
+};
+
+/// A macro for easier access to the singleton.
+#define sNotificationQueue \
+    ( NotificationQueue::get() )
+
+#endif /* !__MAIL__NOTIFICATION_QUEUE_H__INCL__ */
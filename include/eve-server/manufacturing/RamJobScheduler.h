@@ -0,0 +1,194 @@
+/*
+    ------------------------------------------------------------------------------------
+    LICENSE:
+    ------------------------------------------------------------------------------------
+    This file is part of EVEmu: EVE Online Server Emulator
+    Copyright 2006 - 2011 The EVEmu Team
+    For the latest information visit http://evemu.org
+    ------------------------------------------------------------------------------------
+    This program is free software; you can redistribute it and/or modify it under
+    the terms of the GNU Lesser General Public License as published by the Free Software
+    Foundation; either version 2 of the License, or (at your option) any later
+    version.
+
+    This program is distributed in the hope that it will be useful, but WITHOUT
+    ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+    FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public License along with
+    this program; if not, write to the Free Software Foundation, Inc., 59 Temple
+    Place - Suite 330, Boston, MA 02111-1307, USA, or go to
+    http://www.gnu.org/copyleft/lesser.txt.
+    ------------------------------------------------------------------------------------
+    Author:     EVEmu Team
+*/
+
+#ifndef __MANUFACTURING__RAM_JOB_SCHEDULER_H__INCL__
+#define __MANUFACTURING__RAM_JOB_SCHEDULER_H__INCL__
+
+#include "manufacturing/RamProxyDB.h"
+#include "utils/Singleton.h"
+
+/**
+ * @brief An in-progress row of ramJobs.
+ */
+struct RamJob
+{
+    uint32 jobID;
+    uint32 ownerID;
+    uint32 installerID;
+    uint32 assemblyLineID;
+    uint32 installedItemID;
+    /// Win32 time the job was installed at.
+    uint64 installTime;
+    /// Win32 time the production begins at.
+    uint64 beginProductionTime;
+    /// Win32 time the production ends at.
+    uint64 endProductionTime;
+    std::string description;
+    uint32 runs;
+    EVEItemFlags outputFlag;
+    uint32 installedInSolarSystemID;
+    int32 licensedProductionRuns;
+    /// Activity of the assembly line.
+    EVERamActivity activity;
+};
+
+/**
+ * @brief Resident schedule of the running manufacturing and research jobs.
+ *
+ * All jobs in progress are loaded at startup and kept in memory,
+ * together with the occupancy of their assembly lines, so
+ * installing, verifying and delivering a job never query them.
+ * The jobs are queued by their end of production, so the
+ * finished ones are found without polling.
+ *
+ * Only state transitions are written to the database: the job
+ * row and the next free time of the line when the job is
+ * installed, its completed status when it is delivered.
+ *
+ * Not thread-safe; meant to be used from the main loop.
+ *
+ * @author EVEmu Team
+ */
+class RamJobScheduler
+: public Singleton< RamJobScheduler >
+{
+public:
+    /**
+     * @brief Statistics of the schedule.
+     */
+    struct Stats
+    {
+        Stats() { Reset(); }
+
+        void Reset()
+        {
+            installed = 0;
+            finished = 0;
+            completed = 0;
+        }
+
+        /// Number of installed jobs.
+        uint32 installed;
+        /// Number of jobs which finished production.
+        uint32 finished;
+        /// Number of jobs delivered or cancelled.
+        uint32 completed;
+    };
+
+    RamJobScheduler();
+
+    /** @return Number of jobs in progress. */
+    size_t size() const { return mJobs.size(); }
+    /** @return Statistics since the last ResetStats(). */
+    const Stats& stats() const { return mStats; }
+    /** @brief Resets the statistics. */
+    void ResetStats() { mStats.Reset(); }
+
+    /**
+     * @brief Loads all jobs in progress.
+     *
+     * @return True on success.
+     */
+    bool Load();
+
+    /**
+     * @param[in] jobID The job.
+     *
+     * @return The job; NULL if there is no such job in progress.
+     */
+    const RamJob* GetJob( uint32 jobID ) const;
+
+    /** @return Number of manufacturing jobs in progress installed by the character. */
+    uint32 CountManufacturingJobs( uint32 installerID ) const;
+    /** @return Number of research jobs in progress installed by the character. */
+    uint32 CountResearchJobs( uint32 installerID ) const;
+    /** @return Win32 time the assembly line is free at; 0 if it is free. */
+    uint64 GetNextFreeTime( uint32 assemblyLineID ) const;
+
+    /**
+     * @brief Installs a new job.
+     *
+     * @param[in,out] job The job; its jobID is assigned.
+     *
+     * @return The jobID; 0 if the job could not be stored.
+     */
+    uint32 InstallJob( RamJob& job );
+    /**
+     * @brief Delivers or cancels a job in progress.
+     *
+     * @param[in] jobID           The job.
+     * @param[in] completedStatus The status to store.
+     *
+     * @return False if there is no such job or it could not be stored.
+     */
+    bool CompleteJob( uint32 jobID, EVERamCompletedStatus completedStatus );
+
+    /** @return Win32 time the next job finishes production at; 0 if none is pending. */
+    uint64 GetNextFinishTime();
+    /**
+     * @brief Takes the jobs which finished production by given time.
+     *
+     * Each job is taken once; it stays in progress until delivered.
+     *
+     * @param[in]  now  The current Win32 time.
+     * @param[out] into The jobIDs.
+     */
+    void PopFinishedJobs( uint64 now, std::vector< uint32 >& into );
+
+protected:
+    /// End of production and jobID; the queue is ordered earliest first.
+    typedef std::pair< uint64, uint32 > FinishKey;
+    typedef std::priority_queue< FinishKey, std::vector< FinishKey >, std::greater< FinishKey > > FinishQueue;
+    /// Ends of production of the jobs of a line.
+    typedef std::multiset< uint64 > LineJobs;
+
+    void _Insert( const RamJob& job );
+    void _Erase( const RamJob& job );
+    /** @brief Drops the queued jobs which are no longer in progress. */
+    void _PruneFinishQueue();
+
+    /// The jobs in progress, by jobID.
+    std::tr1::unordered_map< uint32, RamJob > mJobs;
+    /// The jobs which have not finished production yet.
+    FinishQueue mFinishQueue;
+    /// The busy assembly lines, by assemblyLineID.
+    std::map< uint32, LineJobs > mLines;
+    /// Number of manufacturing jobs of the installers.
+    std::map< uint32, uint32 > mManufacturingJobs;
+    /// Number of research jobs of the installers.
+    std::map< uint32, uint32 > mResearchJobs;
+
+    /// The jobID the next job gets.
+    uint32 mNextJobID;
+
+    /// Statistics.
+    Stats mStats;
+};
+
+/// A macro for easier access to the singleton.
+#define sRamJobScheduler \
+    ( RamJobScheduler::get() )
+
+#endif /* !__MANUFACTURING__RAM_JOB_SCHEDULER_H__INCL__ */
@@ -83,28 +83,56 @@ public:
     // InstallJob stuff
     bool GetAssemblyLineProperties(const uint32 assemblyLineID, double &baseMaterialMultiplier, double &baseTimeMultiplier, double &costInstall, double &costPerHour);
     bool GetAssemblyLineVerifyProperties(const uint32 assemblyLineID, uint32 &ownerID, double &minCharSecurity, double &maxCharSecurity, EVERamRestrictionMask &restrictionMask, EVERamActivity &activity);
-    bool InstallJob(const uint32 ownerID, const uint32 installerID, const uint32 assemblyLineID, const uint32 installedItemID, const uint64 beginProductionTime, const uint64 endProductionTime, const char *description, const uint32 runs, const EVEItemFlags outputFlag, const uint32 installedInSolarSystem, const int32 licensedProductionRuns);
 
     bool IsProducableBy(const uint32 assemblyLineID, const uint32 groupID);
     bool MultiplyMultipliers(const uint32 assemblyLineID, const uint32 productGroupID, double &materialMultiplier, double &timeMultiplier);
-    uint32 CountManufacturingJobs(const uint32 installerID);
-    uint32 CountResearchJobs(const uint32 installerID);
 
     bool GetRequiredItems(const uint32 typeID, const EVERamActivity activity, std::vector<RequiredItem> &into);
 
     // CompleteJob stuff
-    bool GetJobProperties(const uint32 jobID, uint32 &installedItemID, uint32 &ownerID, EVEItemFlags &outputFlag, uint32 &runs, uint32 &licensedProductionRuns, EVERamActivity &activity);
     bool GetJobVerifyProperties(const uint32 jobID, uint32 &ownerID, uint64 &endProductionTime, EVERamRestrictionMask &restrictionMask, EVERamCompletedStatus &status);
-    bool CompleteJob(const uint32 jobID, const EVERamCompletedStatus completedStatus);
 
     // other
     std::string GetStationName(const uint32 stationID);
     uint32 GetRegionOfContainer(const uint32 containerID);
     uint32 GetTech2Blueprint(const uint32 blueprintTypeID);
-    uint64 GetNextFreeTime(const uint32 assemblyLineID);
 
 protected:
+    // properties of an assembly line needed by quotes and installs
+    struct AssemblyLine {
+        double baseMaterialMultiplier;
+        double baseTimeMultiplier;
+        double costInstall;
+        double costPerHour;
+        uint32 ownerID;
+        double minCharSecurity;
+        double maxCharSecurity;
+        EVERamRestrictionMask restrictionMask;
+        EVERamActivity activity;
+    };
+
+    // multipliers of an assembly line for a product group
+    struct Multipliers {
+        bool producable;
+        double materialMultiplier;
+        double timeMultiplier;
+    };
+
+    static uint64 _Key(const uint32 hi, const uint32 lo) { return((uint64(hi) << 32) | lo); }
+
+    const AssemblyLine *_GetAssemblyLine(const uint32 assemblyLineID);
     bool _GetMultipliers(const uint32 assemblyLineID, uint32 groupID, double &materialMultiplier, double &timeMultiplier);
+    bool _QueryMultipliers(const uint32 assemblyLineID, uint32 groupID, Multipliers &into);
+
+    // the tables below never change at runtime, so every row is queried only once;
+    // the blueprint's own ME/PE factors come from the resident Blueprint item
+    std::map<uint32, AssemblyLine> m_assemblyLines;
+    // by assemblyLineID and groupID
+    std::map<uint64, Multipliers> m_multipliers;
+    // by typeID and activity
+    std::map<uint64, std::vector<RequiredItem> > m_requiredItems;
+    // by containerID
+    std::map<uint32, uint32> m_containerRegions;
 };
 
 #endif
@@ -26,7 +26,7 @@
 #ifndef __RAM_PROXY_SERVICE__H__
 #define __RAM_PROXY_SERVICE__H__
 
-#include "manufacturing/RamProxyDB.h"
+#include "manufacturing/RamJobScheduler.h"
 #include "PyService.h"
 
 static const uint32 ramProductionTimeLimit = 60*60*24*30;   //30 days
@@ -53,6 +53,11 @@ private:
 
     void _GetBOMItems(const PathElement &bomLocation, std::vector<InventoryItemRef> &into);
 
+    // tells the installers about the jobs which finished production
+    void _FinishJobs();
+    void _ScheduleJobFinish();
+    TimerWheelMember<RamProxyService, &RamProxyService::_FinishJobs> m_jobFinish;
+
     PyCallable_DECL_CALL(GetJobs2)
     PyCallable_DECL_CALL(AssemblyLinesSelect)
     PyCallable_DECL_CALL(AssemblyLinesGet)
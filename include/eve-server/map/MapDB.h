@@ -35,7 +35,8 @@ public:
     PyObject *GetStationExtraInfo();
     PyObject *GetStationOpServices();
     PyObject *GetStationServiceInfo();
-    PyObject *GetStationCount();
+    /** @return Number of stations, by solarSystemID. */
+    PyDict *GetStationCount();
 
 protected:
 };
@@ -42,12 +42,22 @@ protected:
 
     MapDB m_db;
 
+    /**
+     * @return Whether the method is cached from the snapshot the map statistics published last.
+     */
+    bool _IsSnapshotCached(const std::string &method);
+    /// Versions of the statistics the cached snapshots were made of, by method name.
+    std::map<std::string, uint32> m_snapshotVersions;
+
     PyCallable_DECL_CALL(GetStationExtraInfo)
     PyCallable_DECL_CALL(GetSolarSystemPseudoSecurities)
     PyCallable_DECL_CALL(GetStuckSystems)
     PyCallable_DECL_CALL(GetHistory)
     PyCallable_DECL_CALL(GetIncursionGlobalReport)
     PyCallable_DECL_CALL(GetStationCount)
+    PyCallable_DECL_CALL(GetJumpCount)
+    PyCallable_DECL_CALL(GetRoute)
+    PyCallable_DECL_CALL(GetPilotCounts)
 };
 
 #endif
@@ -0,0 +1,184 @@
+/*
+    ------------------------------------------------------------------------------------
+    LICENSE:
+    ------------------------------------------------------------------------------------
+    This file is part of EVEmu: EVE Online Server Emulator
+    Copyright 2006 - 2011 The EVEmu Team
+    For the latest information visit http://evemu.org
+    ------------------------------------------------------------------------------------
+    This program is free software; you can redistribute it and/or modify it under
+    the terms of the GNU Lesser General Public License as published by the Free Software
+    Foundation; either version 2 of the License, or (at your option) any later
+    version.
+
+    This program is distributed in the hope that it will be useful, but WITHOUT
+    ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+    FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public License along with
+    this program; if not, write to the Free Software Foundation, Inc., 59 Temple
+    Place - Suite 330, Boston, MA 02111-1307, USA, or go to
+    http://www.gnu.org/copyleft/lesser.txt.
+    ------------------------------------------------------------------------------------
+    Author:     EVEmu Team
+*/
+
+
+#ifndef __MAP__MAP_STATISTICS_H__INCL__
+#define __MAP__MAP_STATISTICS_H__INCL__
+
+#include "utils/Singleton.h"
+
+/**
+ * @brief Resident activity statistics of the solar systems.
+ *
+ * The stargate jumps and the kills of every solar system are counted
+ * in memory, in hourly buckets for the last day. Every few minutes
+ * Process() publishes a snapshot: the counters are frozen and the
+ * active pilots of every solar system are counted. The rowsets the
+ * star map asks for are built once per snapshot from the frozen
+ * counters, so the map service only hands out cached objects.
+ *
+ * Not thread-safe; meant to be used from the main loop.
+ *
+ * @author EVEmu Team
+ */
+class MapStatistics
+: public Singleton< MapStatistics >
+{
+public:
+    /**
+     * @brief The statistics GetHistory serves, as the client numbers them.
+     */
+    enum HistoryStat
+    {
+        /// Jumps into the solar system.
+        HISTORY_JUMPS = 1,
+        /// Ship, NPC and pod kills.
+        HISTORY_KILLS = 3,
+        /// Faction warfare kills; not counted, always empty.
+        HISTORY_FACWAR_KILLS = 5
+    };
+
+    enum KillKind
+    {
+        KILL_SHIP,
+        KILL_POD,
+        KILL_NPC
+    };
+
+    /// Milliseconds between two snapshots.
+    static const uint32 SNAPSHOT_INTERVAL = 5 * 60 * 1000;
+    /// Milliseconds counted by a bucket.
+    static const uint32 BUCKET_INTERVAL = 60 * 60 * 1000;
+    /// Number of hourly buckets kept.
+    static const size_t HISTORY_HOURS = 24;
+
+    /**
+     * @brief Statistics of the service.
+     */
+    struct Stats
+    {
+        Stats() { Reset(); }
+
+        void Reset()
+        {
+            jumps = 0;
+            kills = 0;
+            snapshots = 0;
+            builds = 0;
+        }
+
+        /// Number of counted jumps.
+        uint32 jumps;
+        /// Number of counted kills.
+        uint32 kills;
+        /// Number of published snapshots.
+        uint32 snapshots;
+        /// Number of rowsets built from the snapshots.
+        uint32 builds;
+    };
+
+    MapStatistics();
+    ~MapStatistics();
+
+    /** @return Number of the published snapshot; changes every time one is published. */
+    uint32 version() const { return mVersion; }
+    /** @return Statistics since the last ResetStats(). */
+    const Stats& stats() const { return mStats; }
+    /** @brief Resets the statistics. */
+    void ResetStats() { mStats.Reset(); }
+
+    /** @brief Counts a stargate jump into the solar system. */
+    void AddJump( uint32 solarSystemID );
+    /** @brief Counts a kill in the solar system. */
+    void AddKill( uint32 solarSystemID, KillKind kind );
+
+    /**
+     * @brief Gets the published statistic of the last hours.
+     *
+     * @param[in] stat  One of HistoryStat.
+     * @param[in] hours Number of hours summed up, at most HISTORY_HOURS.
+     *
+     * @return CRowset of solarSystemID, value1, value2 and value3; NULL if the statistic is unknown.
+     */
+    PyRep* GetHistory( uint32 stat, uint32 hours );
+    /**
+     * @return CRowset of solarSystemID, pilotsInSpace and pilotsDocked of the published snapshot.
+     */
+    PyRep* GetPilotCounts();
+
+    /**
+     * @brief Rotates the buckets and publishes a snapshot when due.
+     *
+     * @param[in] now Current time in milliseconds.
+     */
+    void Process( uint32 now );
+
+protected:
+    /**
+     * @brief Counters of a solar system.
+     */
+    struct Counters
+    {
+        Counters() : jumps( 0 ), shipKills( 0 ), podKills( 0 ), npcKills( 0 ) {}
+
+        uint32 jumps;
+        uint32 shipKills;
+        uint32 podKills;
+        uint32 npcKills;
+    };
+    typedef std::tr1::unordered_map< uint32, Counters > CounterMap;
+
+    /** @brief Freezes the counters, counts the pilots and drops the built rowsets. */
+    void _Publish();
+    void _ClearBuilt();
+
+    /// Hourly buckets, the current one first.
+    std::list< CounterMap > mBuckets;
+    /// The buckets of the published snapshot.
+    std::list< CounterMap > mPublished;
+    /// Pilots in space and docked of the published snapshot, by solar system.
+    std::map< uint32, std::pair< uint32, uint32 > > mPilots;
+
+    /// Whether Process() has run already.
+    bool mStarted;
+    /// Time the current bucket started.
+    uint32 mBucketStart;
+    /// Time the last snapshot was published.
+    uint32 mPublishTime;
+    uint32 mVersion;
+
+    /// Rowsets built from the published snapshot, by stat and hours.
+    std::map< uint64, PyRep* > mBuilt;
+    PyRep* mBuiltPilots;
+
+    /// Statistics.
+    Stats mStats;
+};
+
+/// A macro for easier access to the singleton.
+#define sMapStatistics \
+    ( MapStatistics::get() )
+
+#endif /* !__MAP__MAP_STATISTICS_H__INCL__ */
@@ -0,0 +1,218 @@
+/*
+    ------------------------------------------------------------------------------------
+    LICENSE:
+    ------------------------------------------------------------------------------------
+    This file is part of EVEmu: EVE Online Server Emulator
+    Copyright 2006 - 2011 The EVEmu Team
+    For the latest information visit http://evemu.org
+    ------------------------------------------------------------------------------------
+    This program is free software; you can redistribute it and/or modify it under
+    the terms of the GNU Lesser General Public License as published by the Free Software
+    Foundation; either version 2 of the License, or (at your option) any later
+    version.
+
+    This program is distributed in the hope that it will be useful, but WITHOUT
+    ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+    FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public License along with
+    this program; if not, write to the Free Software Foundation, Inc., 59 Temple
+    Place - Suite 330, Boston, MA 02111-1307, USA, or go to
+    http://www.gnu.org/copyleft/lesser.txt.
+    ------------------------------------------------------------------------------------
+    Author:     EVEmu Team
+*/
+
+
+#ifndef __MAP__ROUTE_MAP_H__INCL__
+#define __MAP__ROUTE_MAP_H__INCL__
+
+#include "utils/Singleton.h"
+
+/**
+ * @brief Resident graph of the stargates, for jump counts and routes.
+ *
+ * The solar systems and mapSolarSystemJumps are loaded at startup into
+ * a compact adjacency array (CSR): the neighbours of every system are
+ * a slice of a single vector, indexed by dense system indices.
+ *
+ * The jumps between any two systems of a region are precomputed into
+ * a table per region (paths may leave the region), so the common case,
+ * the jumps to an order or an agent of the same region, is a lookup.
+ * Other jumps and routes are searched: A* for the shortest route, with
+ * the straight-line distance over the longest jump as the heuristic,
+ * and Dijkstra for the routes which prefer or avoid high security
+ * space. The last routes searched are kept in an LRU cache.
+ *
+ * Not thread-safe; meant to be used from the main loop.
+ *
+ * @author EVEmu Team
+ */
+class RouteMap
+: public Singleton< RouteMap >
+{
+public:
+    /// The route preferences of the client's autopilot.
+    enum RouteType
+    {
+        ROUTE_SHORTEST,
+        /// Avoids systems of security below HIGH_SECURITY.
+        ROUTE_SAFER,
+        /// Avoids systems of security HIGH_SECURITY and above.
+        ROUTE_LESS_SECURE,
+
+        ROUTE_TYPE_COUNT
+    };
+
+    /// Security of high security space, as rounded by the client.
+    static const double HIGH_SECURITY;
+    /// Most routes kept in the cache.
+    static const size_t ROUTE_CACHE_SIZE = 4096;
+
+    /**
+     * @brief Statistics of the map.
+     */
+    struct Stats
+    {
+        Stats() { Reset(); }
+
+        void Reset()
+        {
+            queries = 0;
+            tableHits = 0;
+            cacheHits = 0;
+            searches = 0;
+            expanded = 0;
+        }
+
+        /// Number of GetJumps() and GetRoute() calls.
+        uint64 queries;
+        /// Number of jump counts served from the tables of the regions.
+        uint64 tableHits;
+        /// Number of routes served from the cache.
+        uint64 cacheHits;
+        /// Number of routes searched.
+        uint64 searches;
+        /// Number of systems the searches expanded.
+        uint64 expanded;
+    };
+
+    RouteMap();
+
+    /** @return Number of solar systems. */
+    size_t size() const { return mSystemIDs.size(); }
+    /** @return Number of stargate jumps, counted in both directions. */
+    size_t GetJumpCount() const { return mNeighbors.size(); }
+    /** @return Statistics since the last ResetStats(). */
+    const Stats& stats() const { return mStats; }
+    /** @brief Resets the statistics. */
+    void ResetStats() { mStats.Reset(); }
+
+    /**
+     * @brief Loads the systems and jumps and precomputes the tables of the regions.
+     *
+     * @return True on success.
+     */
+    bool Load();
+
+    /**
+     * @brief Counts the jumps of the shortest route.
+     *
+     * @param[in] fromSystemID Where the route starts.
+     * @param[in] toSystemID   Where the route ends.
+     *
+     * @return Number of jumps; -1 if there is no route or a system is unknown.
+     */
+    int32 GetJumps( uint32 fromSystemID, uint32 toSystemID );
+    /**
+     * @brief Finds a route.
+     *
+     * @param[in]  fromSystemID Where the route starts.
+     * @param[in]  toSystemID   Where the route ends.
+     * @param[in]  type         Preference of the route.
+     * @param[out] into         The systems of the route, both ends included.
+     *
+     * @return False if there is no route or a system is unknown.
+     */
+    bool GetRoute( uint32 fromSystemID, uint32 toSystemID, RouteType type, std::vector< uint32 >& into );
+
+protected:
+    /// Jumps of unreachable systems in the tables of the regions.
+    static const uint8 UNREACHABLE = 0xFF;
+    /// Cost of a system the route should avoid, in jumps.
+    static const uint32 AVOID_COST = 1000;
+
+    /**
+     * @brief A region and its jump table.
+     */
+    struct Region
+    {
+        uint32 regionID;
+        /// Indices of the systems.
+        std::vector< uint32 > systems;
+        /// Jumps between the systems, row by row; empty if the region has no stargates.
+        std::vector< uint8 > jumps;
+    };
+
+    /// A cached route.
+    typedef std::pair< uint64, std::vector< uint32 > > CachedRoute;
+    typedef std::list< CachedRoute > RouteList;
+
+    /** @return Index of a system; size() if unknown. */
+    uint32 _GetIndex( uint32 systemID ) const;
+    static uint64 _RouteKey( uint32 from, uint32 to, RouteType type ) { return ( (uint64)type << 48 ) | ( (uint64)from << 24 ) | to; }
+
+    /** @brief Fills the table of a region by breadth-first searches. */
+    void _BuildTable( Region& region );
+
+    /**
+     * @brief Finds a route between system indices, in the cache or by a search.
+     *
+     * @return Indices of the systems of the route, valid until the next call; empty if there is no route.
+     */
+    const std::vector< uint32 >& _FindRoute( uint32 from, uint32 to, RouteType type );
+    /**
+     * @brief Searches a route between system indices.
+     *
+     * @return False if there is no route.
+     */
+    bool _Search( uint32 from, uint32 to, RouteType type, std::vector< uint32 >& into );
+    /** @return Cost of entering a system. */
+    uint32 _GetCost( uint32 index, RouteType type ) const;
+    /** @return Least number of jumps between two systems, by their distance. */
+    double _GetEstimate( uint32 from, uint32 to ) const;
+
+    /// The IDs of the systems, by index.
+    std::vector< uint32 > mSystemIDs;
+    /// The indices of the systems, by ID.
+    std::tr1::unordered_map< uint32, uint32 > mIndices;
+    /// Security, position and region of the systems, by index.
+    std::vector< float > mSecurity;
+    std::vector< GPoint > mPositions;
+    std::vector< uint32 > mRegionOf;
+    /// Where the system is in the table of its region, by index.
+    std::vector< uint32 > mRegionSlot;
+
+    /// Start of the neighbours of every system in mNeighbors, by index; one more for the end.
+    std::vector< uint32 > mOffsets;
+    /// Indices of the neighbours.
+    std::vector< uint32 > mNeighbors;
+    /// The longest jump, in meters.
+    double mMaxJumpLength;
+
+    /// The regions.
+    std::vector< Region > mRegions;
+
+    /// The cached routes, most recently used first.
+    RouteList mRoutes;
+    std::tr1::unordered_map< uint64, RouteList::iterator > mRouteIndex;
+
+    /// Statistics.
+    Stats mStats;
+};
+
+/// A macro for easier access to the singleton.
+#define sRouteMap \
+    ( RouteMap::get() )
+
+#endif /* !__MAP__ROUTE_MAP_H__INCL__ */
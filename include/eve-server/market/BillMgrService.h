@@ -30,12 +30,16 @@
 #include "PyService.h"
 #include "market/MarketDB.h"
 
+class ObjectCachedMethodID;
+
 class BillMgrService : public PyService
 {
 public:
     BillMgrService(PyServiceMgr *mgr);
     virtual ~BillMgrService();
 
+    virtual void PrimeCache();
+
 protected:
     class Dispatcher;
     Dispatcher *const m_dispatch;
@@ -45,6 +49,8 @@ protected:
     PyCallable_DECL_CALL(GetBillTypes)
     PyCallable_DECL_CALL(GetCorporationBills)
     PyCallable_DECL_CALL(GetCorporationBillsReceivable)
+
+    void _CacheBillTypes(const ObjectCachedMethodID &method_id);
 };
 
 
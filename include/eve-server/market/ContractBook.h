@@ -0,0 +1,295 @@
+/*
+    ------------------------------------------------------------------------------------
+    LICENSE:
+    ------------------------------------------------------------------------------------
+    This file is part of EVEmu: EVE Online Server Emulator
+    Copyright 2006 - 2011 The EVEmu Team
+    For the latest information visit http://evemu.org
+    ------------------------------------------------------------------------------------
+    This program is free software; you can redistribute it and/or modify it under
+    the terms of the GNU Lesser General Public License as published by the Free Software
+    Foundation; either version 2 of the License, or (at your option) any later
+    version.
+
+    This program is distributed in the hope that it will be useful, but WITHOUT
+    ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+    FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public License along with
+    this program; if not, write to the Free Software Foundation, Inc., 59 Temple
+    Place - Suite 330, Boston, MA 02111-1307, USA, or go to
+    http://www.gnu.org/copyleft/lesser.txt.
+    ------------------------------------------------------------------------------------
+    Author:     EVEmu Team
+*/
+
+#ifndef __MARKET__CONTRACT_BOOK_H__INCL__
+#define __MARKET__CONTRACT_BOOK_H__INCL__
+
+#include "utils/Singleton.h"
+#include "utils/TimerWheel.h"
+
+/**
+ * @brief Types of contracts.
+ */
+enum EVEContractType
+{
+    contractTypeItemExchange = 1,
+    contractTypeAuction      = 2,
+    contractTypeCourier      = 3,
+    contractTypeLoan         = 4
+};
+
+/**
+ * @brief Statuses of contracts.
+ */
+enum EVEContractStatus
+{
+    contractStatusOutstanding        = 0,
+    contractStatusInProgress         = 1,
+    contractStatusFinishedIssuer     = 2,
+    contractStatusFinishedContractor = 3,
+    contractStatusFinished           = 4,
+    contractStatusDeleted            = 5,
+    contractStatusRejected           = 6,
+    contractStatusFailed             = 7,
+    contractStatusExpired            = 8
+};
+
+/**
+ * @brief A row of contracts_items.
+ */
+struct ContractItem
+{
+    uint32 itemID;
+    uint32 typeID;
+    uint32 quantity;
+    /// True if the item is offered, false if it is asked for.
+    bool inCrate;
+};
+
+/**
+ * @brief A row of contracts, with its items.
+ */
+struct Contract
+{
+    uint32 contractID;
+    EVEContractType type;
+    EVEContractStatus status;
+    uint32 issuerID;
+    uint32 issuerCorpID;
+    bool forCorp;
+    /// The character or corporation the contract is assigned to; 0 if public.
+    uint32 assigneeID;
+    uint32 acceptorID;
+    uint32 startStationID;
+    uint32 startSolarSystemID;
+    uint32 startRegionID;
+    uint32 endStationID;
+    double price;
+    double reward;
+    double collateral;
+    double volume;
+    std::string title;
+    /// Win32 time the contract was issued at.
+    uint64 dateIssued;
+    /// Win32 time the outstanding contract expires at.
+    uint64 dateExpired;
+    /// Win32 time the contract was accepted at; 0 if it was not.
+    uint64 dateAccepted;
+    /// Days the acceptor has to finish a courier contract.
+    uint32 numDays;
+
+    std::vector< ContractItem > items;
+};
+
+/**
+ * @brief Criteria of a contract search.
+ *
+ * Only outstanding public contracts are searched; zero
+ * fields match anything.
+ */
+struct ContractFilter
+{
+    ContractFilter()
+    : regionID( 0 ), typeID( 0 ), type( 0 ), issuerID( 0 ), minPrice( 0.0 ), maxPrice( 0.0 ) {}
+
+    uint32 regionID;
+    /// A type offered by the contract.
+    uint32 typeID;
+    uint32 type;
+    uint32 issuerID;
+    double minPrice;
+    double maxPrice;
+};
+
+/**
+ * @brief Resident book of the live contracts.
+ *
+ * All contracts which are not finished or deleted are loaded at
+ * startup and kept in memory. The outstanding public contracts
+ * are indexed by region and by offered type, all of them by
+ * issuer, assignee and acceptor, so searching and listing never
+ * scan the table.
+ *
+ * Searches return their results in pages in contractID order;
+ * each page tells where the next one continues, so a client may
+ * stream through any number of results.
+ *
+ * Outstanding contracts are queued by their expiry and expired
+ * by a single timer, never by the requests. Only state
+ * transitions are written to the database.
+ *
+ * Not thread-safe; meant to be used from the main loop.
+ *
+ * @author EVEmu Team
+ */
+class ContractBook
+: public Singleton< ContractBook >
+{
+public:
+    /**
+     * @brief Statistics of the book.
+     */
+    struct Stats
+    {
+        Stats() { Reset(); }
+
+        void Reset()
+        {
+            created = 0;
+            expired = 0;
+            searches = 0;
+            examined = 0;
+        }
+
+        /// Number of created contracts.
+        uint32 created;
+        /// Number of contracts which expired.
+        uint32 expired;
+        /// Number of searches.
+        uint32 searches;
+        /// Number of contracts the searches examined.
+        uint32 examined;
+    };
+
+    ContractBook();
+
+    /** @return Number of resident contracts. */
+    size_t size() const { return mContracts.size(); }
+    /** @return Statistics since the last ResetStats(). */
+    const Stats& stats() const { return mStats; }
+    /** @brief Resets the statistics. */
+    void ResetStats() { mStats.Reset(); }
+
+    /**
+     * @brief Loads all live contracts and starts expiring them.
+     *
+     * @return True on success.
+     */
+    bool Load();
+
+    /**
+     * @param[in] contractID The contract.
+     *
+     * @return The contract; NULL if there is no such live contract.
+     */
+    const Contract* GetContract( uint32 contractID ) const;
+
+    /**
+     * @brief Creates a new outstanding contract.
+     *
+     * @param[in,out] contract The contract; its contractID is assigned.
+     *
+     * @return The contractID; 0 if the contract could not be stored.
+     */
+    uint32 CreateContract( Contract& contract );
+    /**
+     * @brief Changes the status of a contract.
+     *
+     * Finished and deleted contracts leave the book.
+     *
+     * @param[in] contractID The contract.
+     * @param[in] status     The new status.
+     * @param[in] acceptorID The acceptor when the contract is accepted.
+     *
+     * @return False if there is no such contract or it could not be stored.
+     */
+    bool SetStatus( uint32 contractID, EVEContractStatus status, uint32 acceptorID = 0 );
+
+    /**
+     * @brief Finds a page of outstanding public contracts.
+     *
+     * @param[in]  filter What to look for.
+     * @param[in]  after  The contractID the page starts after; 0 for the first page.
+     * @param[in]  count  Maximal number of contracts in the page.
+     * @param[out] into   The contracts.
+     *
+     * @return The contractID the next page starts after; 0 if there are no more results.
+     */
+    uint32 Search( const ContractFilter& filter, uint32 after, size_t count, std::vector< const Contract* >& into );
+
+    /** @brief Gets the live contracts issued by the character or corporation. */
+    void GetIssuedContracts( uint32 issuerID, std::vector< const Contract* >& into ) const;
+    /** @brief Gets the live contracts assigned to the character or corporation. */
+    void GetAssignedContracts( uint32 assigneeID, std::vector< const Contract* >& into ) const;
+    /** @brief Gets the contracts accepted by the character or corporation. */
+    void GetAcceptedContracts( uint32 acceptorID, std::vector< const Contract* >& into ) const;
+
+    /**
+     * @return Number of contracts of the character or corporation which
+     *         need their attention: outstanding ones assigned to them and
+     *         expired ones they issued.
+     */
+    uint32 CountRequiringAttention( uint32 ownerID ) const;
+
+protected:
+    typedef std::set< uint32 > ContractSet;
+    typedef std::map< uint32, ContractSet > ContractIndex;
+    /// Expiry and contractID; ordered earliest first.
+    typedef std::set< std::pair< uint64, uint32 > > ExpiryQueue;
+
+    static bool _IsSearchable( const Contract& contract );
+    static bool _Matches( const Contract& contract, const ContractFilter& filter );
+    static void _Index( ContractIndex& index, uint32 key, uint32 contractID );
+    static void _Unindex( ContractIndex& index, uint32 key, uint32 contractID );
+    void _Get( const ContractIndex& index, uint32 key, std::vector< const Contract* >& into ) const;
+
+    void _Insert( const Contract& contract );
+    void _Erase( const Contract& contract );
+    /** @brief Expires the due contracts and schedules the next expiry. */
+    void _Expire();
+    void _ScheduleExpiry();
+
+    /// The live contracts, by contractID.
+    std::tr1::unordered_map< uint32, Contract > mContracts;
+    /// Outstanding public contracts.
+    ContractSet mSearchable;
+    /// Outstanding public contracts by region.
+    ContractIndex mRegionIndex;
+    /// Outstanding public contracts by offered type.
+    ContractIndex mTypeIndex;
+    /// Live contracts by issuer; corporation contracts by the corporation too.
+    ContractIndex mIssuerIndex;
+    /// Live contracts by assignee.
+    ContractIndex mAssigneeIndex;
+    /// Live contracts by acceptor.
+    ContractIndex mAcceptorIndex;
+    /// Outstanding contracts by expiry.
+    ExpiryQueue mExpiryQueue;
+
+    /// Timer of the next expiry.
+    TimerWheelMember< ContractBook, &ContractBook::_Expire > mExpiryTimer;
+
+    /// The contractID the next contract gets.
+    uint32 mNextContractID;
+
+    /// Statistics.
+    Stats mStats;
+};
+
+/// A macro for easier access to the singleton.
+#define sContractBook \
+    ( ContractBook::get() )
+
+#endif /* !__MARKET__CONTRACT_BOOK_H__INCL__ */
@@ -0,0 +1,159 @@
+/*
+    ------------------------------------------------------------------------------------
+    LICENSE:
+    ------------------------------------------------------------------------------------
+    This file is part of EVEmu: EVE Online Server Emulator
+    Copyright 2006 - 2011 The EVEmu Team
+    For the latest information visit http://evemu.org
+    ------------------------------------------------------------------------------------
+    This program is free software; you can redistribute it and/or modify it under
+    the terms of the GNU Lesser General Public License as published by the Free Software
+    Foundation; either version 2 of the License, or (at your option) any later
+    version.
+
+    This program is distributed in the hope that it will be useful, but WITHOUT
+    ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+    FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public License along with
+    this program; if not, write to the Free Software Foundation, Inc., 59 Temple
+    Place - Suite 330, Boston, MA 02111-1307, USA, or go to
+    http://www.gnu.org/copyleft/lesser.txt.
+    ------------------------------------------------------------------------------------
+    Author:     EVEmu Team
+*/
+
+
+#ifndef __MARKET__ECONOMY_CACHE_H__INCL__
+#define __MARKET__ECONOMY_CACHE_H__INCL__
+
+#include "utils/Singleton.h"
+
+/**
+ * @brief Resident cache of the static economy: insurance, repair and LP store prices.
+ *
+ * At startup the insurance price and the premium and payout of every
+ * insurance level are computed for every ship type, and the cost of
+ * repairing a hit point of damage for every ship, module and drone
+ * type, all from the base prices. The offers of the LP stores are
+ * encoded once per corporation and shared by every call, so browsing
+ * those windows never queries the database.
+ *
+ * Not thread-safe; meant to be used from the main loop.
+ *
+ * @author EVEmu Team
+ */
+class EconomyCache
+: public Singleton< EconomyCache >
+{
+public:
+    enum InsuranceLevel
+    {
+        INSURANCE_BASIC,
+        INSURANCE_STANDARD,
+        INSURANCE_BRONZE,
+        INSURANCE_SILVER,
+        INSURANCE_GOLD,
+        INSURANCE_PLATINUM,
+
+        INSURANCE_LEVEL_COUNT
+    };
+
+    /**
+     * @brief Statistics of the cache.
+     */
+    struct Stats
+    {
+        Stats() { Reset(); }
+
+        void Reset()
+        {
+            insuranceQuotes = 0;
+            repairQuotes = 0;
+            offerLists = 0;
+        }
+
+        /// Number of insurance prices served.
+        uint32 insuranceQuotes;
+        /// Number of repair quotes served.
+        uint32 repairQuotes;
+        /// Number of LP store offer lists served.
+        uint32 offerLists;
+    };
+
+    EconomyCache();
+    ~EconomyCache();
+
+    /** @return Number of types with a cached price. */
+    size_t size() const { return mTypes.size(); }
+    /** @return Number of LP store offers. */
+    size_t GetOfferCount() const { return mOfferCount; }
+    /** @return Statistics since the last ResetStats(). */
+    const Stats& stats() const { return mStats; }
+    /** @brief Resets the statistics. */
+    void ResetStats() { mStats.Reset(); }
+
+    /**
+     * @brief Loads the prices and the LP store offers.
+     *
+     * @return True on success.
+     */
+    bool Load();
+
+    /**
+     * @return The price a ship type is insured for; 0 if the type is not a ship.
+     */
+    double GetInsurancePrice( uint32 typeID );
+    /**
+     * @return The premium of an insurance level of a ship type; 0 if the type is not a ship.
+     */
+    double GetInsurancePremium( uint32 typeID, InsuranceLevel level ) const;
+    /**
+     * @return The payout of an insurance level of a ship type; 0 if the type is not a ship.
+     */
+    double GetInsurancePayout( uint32 typeID, InsuranceLevel level ) const;
+    /**
+     * @return Cost of repairing one hit point of damage of a type; 0 if the type cannot be repaired.
+     */
+    double GetRepairUnitCost( uint32 typeID );
+
+    /**
+     * @brief Gets the offers of the LP store of a corporation.
+     *
+     * @return A new reference to the shared list of util.KeyVal; empty if the corporation has no store.
+     */
+    PyList* GetOffers( uint32 corporationID );
+
+protected:
+    /**
+     * @brief The cached prices of a type.
+     */
+    struct TypeCosts
+    {
+        /// The insured price; 0 if the type is not a ship.
+        double insurancePrice;
+        double premiums[ INSURANCE_LEVEL_COUNT ];
+        double payouts[ INSURANCE_LEVEL_COUNT ];
+        double repairUnitCost;
+    };
+
+    bool _LoadTypes();
+    bool _LoadOffers();
+    void _ClearOffers();
+
+    std::tr1::unordered_map< uint32, TypeCosts > mTypes;
+    /// The offers of the LP stores, by corporationID; we own a reference to each.
+    std::map< uint32, PyList* > mOffers;
+    /// Served to the corporations without a store.
+    PyList* mNoOffers;
+    size_t mOfferCount;
+
+    /// Statistics.
+    Stats mStats;
+};
+
+/// A macro for easier access to the singleton.
+#define sEconomyCache \
+    ( EconomyCache::get() )
+
+#endif /* !__MARKET__ECONOMY_CACHE_H__INCL__ */
@@ -47,7 +47,7 @@ public:
     PyRep *GetSystemAsks(uint32 solarSystemID);
     PyRep *GetRegionBest(uint32 regionID);
 
-    PyRep *GetOrders(uint32 regionID, uint32 typeID);
+    PyRep *GetOrders(uint32 regionID, uint32 typeID, uint32 fromSystemID = 0);
     PyRep *GetCharOrders(uint32 characterID);
     PyRep *GetOrderRow(uint32 orderID);
 
@@ -67,13 +67,26 @@ public:
     bool AlterOrderPrice(uint32 orderID, double new_price);
     bool DeleteOrder(uint32 orderID);
 
+    /**
+     * @brief Adds to the balance of a character in the database, as a part of the current trade.
+     */
     bool AddCharacterBalance(uint32 char_id, double delta);
 
     uint32 StoreBuyOrder(uint32 clientID, uint32 accountID, uint32 stationID, uint32 typeID, double price, uint32 quantity, uint8 orderRange, uint32 minVolume, uint8 duration, bool isCorp);
     uint32 StoreSellOrder(uint32 clientID, uint32 accountID, uint32 stationID, uint32 typeID, double price, uint32 quantity, uint8 orderRange, uint32 minVolume, uint8 duration, bool isCorp);
+    /**
+     * @brief Records a transaction and adds it to the daily price history, as a part of the current trade.
+     */
     bool RecordTransaction(uint32 typeID, uint32 quantity, double price, MktTransType ttype, uint32 charID, uint32 regionID, uint32 stationID);
 
-    bool BuildOldPriceHistory();
+    /**
+     * @brief Moves the daily records older than HISTORY_AGGREGATION_DAYS to the old price history.
+     *
+     * @param[out] moved The regionID and typeID of every history which changed.
+     *
+     * @return True on success.
+     */
+    bool BuildOldPriceHistory(std::vector<std::pair<uint32, uint32> > &moved);
 
 protected:
     uint32 _StoreOrder(uint32 clientID, uint32 accountID, uint32 stationID, uint32 typeID, double price, uint32 quantity, uint8 orderRange, uint32 minVolume, uint8 duration, bool isCorp, bool isBuy);
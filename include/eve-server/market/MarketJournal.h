@@ -0,0 +1,203 @@
+/*
+    ------------------------------------------------------------------------------------
+    LICENSE:
+    ------------------------------------------------------------------------------------
+    This file is part of EVEmu: EVE Online Server Emulator
+    Copyright 2006 - 2011 The EVEmu Team
+    For the latest information visit http://evemu.org
+    ------------------------------------------------------------------------------------
+    This program is free software; you can redistribute it and/or modify it under
+    the terms of the GNU Lesser General Public License as published by the Free Software
+    Foundation; either version 2 of the License, or (at your option) any later
+    version.
+
+    This program is distributed in the hope that it will be useful, but WITHOUT
+    ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+    FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public License along with
+    this program; if not, write to the Free Software Foundation, Inc., 59 Temple
+    Place - Suite 330, Boston, MA 02111-1307, USA, or go to
+    http://www.gnu.org/copyleft/lesser.txt.
+    ------------------------------------------------------------------------------------
+    Author:     EVEmu Team
+*/
+
+#ifndef __MARKET__MARKET_JOURNAL_H__INCL__
+#define __MARKET__MARKET_JOURNAL_H__INCL__
+
+#include "utils/Singleton.h"
+
+/**
+ * @brief Group-commit log of the database writes of market trades.
+ *
+ * A trade is applied to the order book, the balances and the items
+ * in memory right away; its transaction rows and balance updates are
+ * appended to the journal as a single record instead of being run
+ * one by one. Every flush interval, the file of the journal is synced
+ * once for all the trades since the last flush, and the trades are
+ * written in a single transaction, so a trade never waits for MySQL.
+ *
+ * Each trade has a sequence number; the last one written is stored
+ * in market_journal_sequence by the same transaction. When the server
+ * starts, the trades in the file which are not in the database yet
+ * (because it crashed before they were) are written again, and the
+ * ones which are, are skipped; every trade is written exactly once.
+ *
+ * The balances written by the journal are changes; anything which
+ * reads or writes a balance as a whole must Flush() first.
+ *
+ * Not thread-safe; meant to be used from the main loop.
+ *
+ * @author EVEmu Team
+ */
+class MarketJournal
+: public Singleton< MarketJournal >
+{
+public:
+    /**
+     * @brief Records the statements of a trade until it goes out of scope.
+     *
+     * Whatever is appended while it exists belongs to the same trade,
+     * even if the trade bails out halfway.
+     */
+    class Trade
+    {
+    public:
+        Trade() { MarketJournal::get().BeginTrade(); }
+        ~Trade() { MarketJournal::get().CommitTrade(); }
+    };
+
+    /**
+     * @brief Statistics of the journal.
+     */
+    struct Stats
+    {
+        Stats() { Reset(); }
+
+        void Reset()
+        {
+            trades = 0;
+            statements = 0;
+            flushes = 0;
+            failures = 0;
+            replayed = 0;
+        }
+
+        /// Number of committed trades.
+        uint32 trades;
+        /// Number of their statements.
+        uint32 statements;
+        /// Number of flushes which wrote anything.
+        uint32 flushes;
+        /// Number of flushes which failed; their trades are retried.
+        uint32 failures;
+        /// Number of trades written again at startup.
+        uint32 replayed;
+    };
+
+    /**
+     * @brief Creates journal which writes every trade right away, without a file.
+     */
+    MarketJournal();
+    /**
+     * @brief Closes the file.
+     */
+    ~MarketJournal();
+
+    /** @return True if there are trades not written yet. */
+    bool IsPending() const { return !mPending.empty(); }
+    /** @return Statistics since the last ResetStats(). */
+    const Stats& stats() const { return mStats; }
+
+    /**
+     * @brief Opens the file, writing the trades it has which are not in the database yet.
+     *
+     * @param[in] path The file; empty to keep the trades in memory only.
+     *
+     * @return True on success.
+     */
+    bool Open( const std::string& path );
+    /**
+     * @brief Sets the flush interval.
+     *
+     * @param[in] interval Time (in milliseconds) a trade may stay
+     *                     unwritten; 0 writes every trade right away.
+     */
+    void SetFlushInterval( uint32 interval );
+
+    /**
+     * @brief Starts a trade; a trade which is already started goes on.
+     */
+    void BeginTrade();
+    /**
+     * @brief Appends a statement to the current trade.
+     *
+     * Outside of a trade, the statement is a trade of its own.
+     */
+    void Append( const std::string& statement );
+    /**
+     * @brief Commits the current trade to the file.
+     */
+    void CommitTrade();
+
+    /**
+     * @brief Flushes the journal if the oldest trade is due.
+     *
+     * @param[in] now The current time (in milliseconds).
+     */
+    void Process( uint32 now );
+    /**
+     * @brief Writes all the committed trades.
+     *
+     * @return True on success (or if nothing was pending).
+     */
+    bool Flush();
+
+    /**
+     * @brief Resets the statistics.
+     */
+    void ResetStats() { mStats.Reset(); }
+
+protected:
+    /**
+     * @brief Reads the sequence number of the last trade written.
+     */
+    bool _ReadSequence( uint64& into );
+    /**
+     * @brief Writes the statements and the sequence number in a single transaction.
+     */
+    bool _Write( const std::vector<std::string>& statements, uint64 sequence );
+    /**
+     * @brief Empties the file; everything in it is written.
+     */
+    bool _Truncate();
+
+    /// The file; NULL if there is none.
+    FILE* mFile;
+    /// Path of the file.
+    std::string mPath;
+
+    /// Nesting of BeginTrade() calls.
+    uint32 mTradeDepth;
+    /// Statements of the current trade.
+    std::vector<std::string> mTrade;
+    /// Statements of the committed trades, in order.
+    std::vector<std::string> mPending;
+    /// Sequence number of the last committed trade.
+    uint64 mSequence;
+
+    /// Time a trade may stay unwritten.
+    uint32 mFlushInterval;
+    /// Time of the oldest unwritten trade.
+    uint32 mFirstQueued;
+
+    /// Statistics.
+    Stats mStats;
+};
+
+/// A macro for easier access to the singleton.
+#define sMarketJournal \
+    ( MarketJournal::get() )
+
+#endif /* !__MARKET__MARKET_JOURNAL_H__INCL__ */
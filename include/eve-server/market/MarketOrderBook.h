@@ -0,0 +1,267 @@
+/*
+    ------------------------------------------------------------------------------------
+    LICENSE:
+    ------------------------------------------------------------------------------------
+    This file is part of EVEmu: EVE Online Server Emulator
+    Copyright 2006 - 2011 The EVEmu Team
+    For the latest information visit http://evemu.org
+    ------------------------------------------------------------------------------------
+    This program is free software; you can redistribute it and/or modify it under
+    the terms of the GNU Lesser General Public License as published by the Free Software
+    Foundation; either version 2 of the License, or (at your option) any later
+    version.
+
+    This program is distributed in the hope that it will be useful, but WITHOUT
+    ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+    FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public License along with
+    this program; if not, write to the Free Software Foundation, Inc., 59 Temple
+    Place - Suite 330, Boston, MA 02111-1307, USA, or go to
+    http://www.gnu.org/copyleft/lesser.txt.
+    ------------------------------------------------------------------------------------
+    Author:     EVEmu Team
+*/
+
+#ifndef __MARKET__MARKET_ORDER_BOOK_H__INCL__
+#define __MARKET__MARKET_ORDER_BOOK_H__INCL__
+
+#include "utils/Singleton.h"
+
+class PyRep;
+class PyPackedRow;
+
+/**
+ * @brief A row of market_orders.
+ */
+struct MarketOrder
+{
+    uint32 orderID;
+    uint32 typeID;
+    uint32 charID;
+    uint32 regionID;
+    uint32 stationID;
+    uint32 solarSystemID;
+    uint32 range;
+    bool bid;
+    double price;
+    uint32 volEntered;
+    uint32 volRemaining;
+    /// Win32 time the order was placed at.
+    uint64 issued;
+    uint32 orderState;
+    uint32 minVolume;
+    bool contraband;
+    uint32 accountID;
+    uint32 duration;
+    bool isCorp;
+    bool escrow;
+    int32 jumps;
+};
+
+/**
+ * @brief Resident order book of the whole market.
+ *
+ * All of market_orders is loaded at startup and kept in memory,
+ * so browsing and matching never query the database. The orders
+ * of every region and type, and of every station and type, are
+ * kept in price-time priority: sell orders cheapest first, buy
+ * orders dearest first, older orders before newer ones at the
+ * same price. The best asks of every solar system are indexed
+ * the same way. Looking an order up, matching against one and
+ * changing one all cost O(log n).
+ *
+ * Every change is written through to market_orders by
+ * InventoryWriteBehind, batched with the item saves.
+ *
+ * Not thread-safe; meant to be used from the main loop.
+ *
+ * @author EVEmu Team
+ */
+class MarketOrderBook
+: public Singleton< MarketOrderBook >
+{
+public:
+    /**
+     * @brief Statistics of the book.
+     */
+    struct Stats
+    {
+        Stats() { Reset(); }
+
+        void Reset()
+        {
+            matched = 0;
+            unmatched = 0;
+            placed = 0;
+            removed = 0;
+        }
+
+        /// Number of placed orders matched against the book.
+        uint32 matched;
+        /// Number of placed orders nothing in the book could satisfy.
+        uint32 unmatched;
+        /// Number of orders added to the book.
+        uint32 placed;
+        /// Number of orders filled, cancelled or deleted.
+        uint32 removed;
+    };
+
+    MarketOrderBook();
+
+    /** @return Number of resident orders. */
+    size_t size() const { return mOrders.size(); }
+    /** @return Statistics since the last ResetStats(). */
+    const Stats& stats() const { return mStats; }
+    /** @brief Resets the statistics. */
+    void ResetStats() { mStats.Reset(); }
+
+    /**
+     * @brief Loads all of market_orders.
+     *
+     * @return True on success.
+     */
+    bool Load();
+
+    /**
+     * @param[in] orderID The order.
+     *
+     * @return The order; NULL if there is no such order.
+     */
+    const MarketOrder* GetOrder( uint32 orderID ) const;
+
+    /**
+     * @brief Adds a new order to the book.
+     *
+     * @param[in,out] order The order; its orderID is assigned.
+     *
+     * @return The orderID.
+     */
+    uint32 AddOrder( MarketOrder& order );
+    /**
+     * @brief Changes the remaining volume of an order.
+     *
+     * @return False if there is no such order.
+     */
+    bool SetVolumeRemaining( uint32 orderID, uint32 volRemaining );
+    /**
+     * @brief Changes the price of an order; it keeps its time priority.
+     *
+     * @return False if there is no such order.
+     */
+    bool SetPrice( uint32 orderID, double price );
+    /**
+     * @brief Removes an order from the book.
+     *
+     * @return False if there is no such order.
+     */
+    bool RemoveOrder( uint32 orderID );
+    /**
+     * @brief Removes all orders of a character.
+     */
+    void RemoveCharacterOrders( uint32 charID );
+
+    /**
+     * @brief Finds the best buy order at the station which takes the whole quantity at the price.
+     *
+     * @return The orderID; 0 if there is no such order.
+     */
+    uint32 FindBuyOrder( uint32 stationID, uint32 typeID, double price, uint32 quantity );
+    /**
+     * @brief Finds the best sell order at the station which offers the whole quantity at the price.
+     *
+     * @return The orderID; 0 if there is no such order.
+     */
+    uint32 FindSellOrder( uint32 stationID, uint32 typeID, double price, uint32 quantity );
+
+    /**
+     * @param[in] fromSystemID The solar system the jumps of the orders are counted from; 0 for the stored jumps.
+     *
+     * @return List of the sell and buy order CRowsets of the type in the region.
+     */
+    PyRep* GetOrders( uint32 regionID, uint32 typeID, uint32 fromSystemID = 0 ) const;
+    /**
+     * @return The order as a packed row of the GetOrders() rowsets; NULL if there is no such order.
+     */
+    PyPackedRow* GetOrderRow( uint32 orderID ) const;
+
+    /** @return IndexRowset of the best ask of every type sold at the station. */
+    PyRep* GetStationAsks( uint32 stationID ) const;
+    /** @return IndexRowset of the best ask of every type sold in the solar system. */
+    PyRep* GetSystemAsks( uint32 solarSystemID ) const;
+    /** @return IndexRowset of the best ask of every type sold in the region. */
+    PyRep* GetRegionBest( uint32 regionID ) const;
+
+protected:
+    /**
+     * @brief Position of an order in its sets.
+     *
+     * Sell orders rank by their price, buy orders by the negated
+     * price, so both sides sort best first.
+     */
+    struct OrderKey
+    {
+        double rank;
+        uint64 issued;
+        uint32 orderID;
+        /// The order itself; the elements of mOrders never move.
+        const MarketOrder* order;
+
+        bool operator<( const OrderKey& oth ) const
+        {
+            if( rank != oth.rank )
+                return rank < oth.rank;
+            if( issued != oth.issued )
+                return issued < oth.issued;
+            return orderID < oth.orderID;
+        }
+    };
+    typedef std::set< OrderKey > OrderSet;
+
+    /**
+     * @brief Both sides of a book.
+     */
+    struct Book
+    {
+        OrderSet sells;
+        OrderSet buys;
+
+        bool empty() const { return sells.empty() && buys.empty(); }
+    };
+    /// Key of a book: locationID and typeID, so the books of a location are next to each other.
+    typedef std::map< uint64, Book > BookMap;
+    typedef std::map< uint64, OrderSet > AskMap;
+
+    static uint64 _BookKey( uint32 locationID, uint32 typeID ) { return ( (uint64)locationID << 32 ) | typeID; }
+    static OrderKey _OrderKey( const MarketOrder& order );
+
+    void _Insert( const MarketOrder& order );
+    void _Erase( const MarketOrder& order );
+    void _Save( const MarketOrder& order );
+
+    MarketOrder* _FindOrder( uint32 orderID );
+    uint32 _FindMatch( uint32 stationID, uint32 typeID, bool bid, double price, uint32 quantity );
+    PyRep* _GetAsks( const AskMap& asks, uint32 locationID ) const;
+    PyRep* _GetAsks( const BookMap& books, uint32 locationID ) const;
+
+    /// All the orders, by orderID.
+    std::tr1::unordered_map< uint32, MarketOrder > mOrders;
+    /// Books of the regions.
+    BookMap mRegionBooks;
+    /// Books of the stations.
+    BookMap mStationBooks;
+    /// Sell orders of the solar systems.
+    AskMap mSystemAsks;
+
+    /// The orderID the next order gets.
+    uint32 mNextOrderID;
+
+    /// Statistics.
+    Stats mStats;
+};
+
+/// A macro for easier access to the singleton.
+#define sMarketOrderBook \
+    ( MarketOrderBook::get() )
+
+#endif /* !__MARKET__MARKET_ORDER_BOOK_H__INCL__ */
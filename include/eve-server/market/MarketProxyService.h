@@ -59,11 +59,54 @@ protected:
 
     void _ExecuteBuyOrder(uint32 buy_order_id, uint32 stationID, uint32 quantity, Client *seller, InventoryItemRef item, bool isCorp);
     void _ExecuteSellOrder(uint32 sell_order_id, uint32 stationID, uint32 quantity, Client *buyer, bool isCorp);
+    /**
+     * @brief Changes the balance of a loaded character as a part of the current trade.
+     */
+    bool _AddTradeBalance(Client *who, double amount);
     void _SendOnOwnOrderChanged(Client *who, uint32 orderID, const char *action, bool isCorp, PyRep* order = NULL);
-    void _BroadcastOnOwnOrderChanged(uint32 regionID, uint32 orderID, const char *action, bool isCorp, PyRep* order = NULL);
+    /**
+     * @brief Sends OnOwnOrderChanged to the owner and the sessions watching the orders of the type.
+     */
+    void _BroadcastOnOwnOrderChanged(uint32 regionID, uint32 typeID, uint32 ownerID, uint32 orderID, const char *action, bool isCorp, PyRep* order = NULL);
     void _SendOnMarketRefresh(Client *who);
-    void _BroadcastOnMarketRefresh(uint32 regionID);
-    void _InvalidateOrdersCache(uint32 regionID);
+    /**
+     * @brief Sends OnMarketRefresh to the sessions watching the orders of the type.
+     */
+    void _BroadcastOnMarketRefresh(uint32 regionID, uint32 typeID);
+    void _InvalidateOrdersCache(uint32 regionID, uint32 typeID);
+    /** @return Name of the cached orders of the type in the region, seen from the solar system. */
+    std::string _OrdersMethod(uint32 regionID, uint32 typeID, uint32 systemID);
+    /// Solar systems the orders were cached for, by regionID and typeID (the regionID in the upper half).
+    std::map<uint64, std::set<uint32> > m_ordersSystems;
+
+    /**
+     * @brief Remembers that the client looks at the orders of the type in the region.
+     */
+    void _WatchOrders(Client *who, uint32 regionID, uint32 typeID);
+    void _UnwatchOrders(uint32 charID, uint64 key);
+    /**
+     * @brief Finds the clients watching the orders; forgets the ones which went away.
+     */
+    void _FindOrderWatchers(uint32 regionID, uint32 typeID, std::vector<Client *> &into);
+
+    /// Characters watching the orders, by regionID and typeID (the regionID in the upper half).
+    std::map<uint64, std::set<uint32> > m_orderWatchers;
+    /// The orders every watching character looks at.
+    std::map<uint32, uint64> m_watchedOrders;
+
+    /**
+     * @brief Answers GetOldPriceHistory and GetNewPriceHistory from the cache.
+     */
+    PyResult _GetPriceHistory(PyCallArgs &call, bool old);
+    /** @return Name of the cached history of the type in the region. */
+    std::string _PriceHistoryMethod(uint32 regionID, uint32 typeID, bool old);
+    void _InvalidatePriceHistoryCache(uint32 regionID, uint32 typeID, bool old);
+
+    /**
+     * @brief Moves the aged out price history once a day.
+     */
+    void _RollupPriceHistory();
+    TimerWheelMember<MarketProxyService, &MarketProxyService::_RollupPriceHistory> m_historyRollup;
 
 
     //overloaded in order to support bound objects:
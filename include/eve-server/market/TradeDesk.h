@@ -0,0 +1,182 @@
+/*
+    ------------------------------------------------------------------------------------
+    LICENSE:
+    ------------------------------------------------------------------------------------
+    This file is part of EVEmu: EVE Online Server Emulator
+    Copyright 2006 - 2011 The EVEmu Team
+    For the latest information visit http://evemu.org
+    ------------------------------------------------------------------------------------
+    This program is free software; you can redistribute it and/or modify it under
+    the terms of the GNU Lesser General Public License as published by the Free Software
+    Foundation; either version 2 of the License, or (at your option) any later
+    version.
+
+    This program is distributed in the hope that it will be useful, but WITHOUT
+    ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+    FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public License along with
+    this program; if not, write to the Free Software Foundation, Inc., 59 Temple
+    Place - Suite 330, Boston, MA 02111-1307, USA, or go to
+    http://www.gnu.org/copyleft/lesser.txt.
+    ------------------------------------------------------------------------------------
+    Author:     EVEmu Team
+*/
+
+
+#ifndef __MARKET__TRADE_DESK_H__INCL__
+#define __MARKET__TRADE_DESK_H__INCL__
+
+#include "utils/Singleton.h"
+
+class Client;
+
+/**
+ * @brief A trade between two players docked in the same station.
+ */
+struct TradeSession
+{
+    uint32 tradeContainerID;
+    uint32 stationID;
+    /// Win32 time the trade was initiated at.
+    uint64 when;
+    /// The initiator and the target; we do not own them.
+    Client* traders[ 2 ];
+    /// Whether each trader accepted the current offer.
+    bool accepted[ 2 ];
+    /// The ISK each trader offers.
+    double money[ 2 ];
+    /// The items each trader offers, whole stacks from its hangar.
+    std::vector< uint32 > items[ 2 ];
+};
+
+/**
+ * @brief Resident desk of the player-to-player trades.
+ *
+ * The offered items and ISK stay with their owners until the trade
+ * completes; the desk only holds them in memory. An item may be
+ * offered in one trade at a time and a character may trade with one
+ * character at a time, so the offered ISK is a simple escrow against
+ * the balance. Adding items and ISK, and accepting, never touches
+ * the database.
+ *
+ * When both traders accept, everything is checked again (the items
+ * may have moved, the balances changed) and then applied at once:
+ * the owners of the items, the balances and the wallet entries go to
+ * the market journal as a single trade, which is flushed right away,
+ * so a trade is written whole or not at all, even on a crash. Any
+ * change to the offer takes back both acceptances.
+ *
+ * Not thread-safe; meant to be used from the main loop.
+ *
+ * @author EVEmu Team
+ */
+class TradeDesk
+: public Singleton< TradeDesk >
+{
+public:
+    /**
+     * @brief Statistics of the desk.
+     */
+    struct Stats
+    {
+        Stats() { Reset(); }
+
+        void Reset()
+        {
+            opened = 0;
+            changes = 0;
+            completed = 0;
+            failed = 0;
+            cancelled = 0;
+        }
+
+        /// Number of trades initiated.
+        uint32 opened;
+        /// Number of offer changes held in memory.
+        uint32 changes;
+        /// Number of trades completed.
+        uint32 completed;
+        /// Number of trades whose offer was no longer valid when accepted.
+        uint32 failed;
+        /// Number of trades cancelled.
+        uint32 cancelled;
+    };
+
+    TradeDesk();
+
+    /** @return Number of open trades. */
+    size_t size() const { return mSessions.size(); }
+    /** @return Statistics since the last ResetStats(). */
+    const Stats& stats() const { return mStats; }
+    /** @brief Resets the statistics. */
+    void ResetStats() { mStats.Reset(); }
+
+    /**
+     * @brief Initiates a trade.
+     *
+     * @return The trade; NULL if the characters are not docked in the same station or already trade.
+     */
+    const TradeSession* Open( Client* initiator, Client* target );
+    /**
+     * @return The trade of a character; NULL if it does not trade.
+     */
+    const TradeSession* Find( uint32 characterID ) const;
+
+    /**
+     * @brief Offers a stack from the hangar of a trader.
+     *
+     * @return True on success, false if the item may not be offered.
+     */
+    bool AddItem( Client* who, uint32 itemID );
+    /**
+     * @brief Sets the ISK a trader offers.
+     *
+     * @return True on success, false if the trader does not have that much.
+     */
+    bool OfferMoney( Client* who, double amount );
+    /**
+     * @brief Accepts or declines the current offer; completes the trade once both accept.
+     *
+     * @return False if the trade was completed but the offer was no longer valid; the trade is cancelled then.
+     */
+    bool ToggleAccept( Client* who, bool accept );
+    /**
+     * @brief Cancels the trade of a character, if any; called as the character aborts or leaves.
+     */
+    void Cancel( Client* who );
+
+protected:
+    /**
+     * @return The trade of a character and its side in it; NULL if it does not trade.
+     */
+    TradeSession* _Find( Client* who, uint32& side );
+    /**
+     * @brief Checks the offer again and applies it.
+     *
+     * @return True on success.
+     */
+    bool _Complete( TradeSession& session );
+    /**
+     * @brief Forgets a trade, releasing its items.
+     */
+    void _Close( uint32 tradeContainerID );
+
+    /// The open trades, by tradeContainerID.
+    std::map< uint32, TradeSession > mSessions;
+    /// The tradeContainerID of the trade of every trading character.
+    std::map< uint32, uint32 > mTraders;
+    /// The items offered in any trade.
+    std::set< uint32 > mOfferedItems;
+    /// The last tradeContainerID handed out.
+    uint32 mLastContainerID;
+
+    /// Statistics.
+    Stats mStats;
+};
+
+/// A macro for easier access to the singleton.
+#define sTradeDesk \
+    ( TradeDesk::get() )
+
+#endif /* !__MARKET__TRADE_DESK_H__INCL__ */
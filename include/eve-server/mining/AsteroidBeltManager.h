@@ -29,33 +29,70 @@
 #include "system/SystemEntities.h"
 
 class AsteroidEntity;
+class SystemManager;
 
 static const uint32 ASTEROID_GROWTH_INTERVAL_MS = 3600000;    //RuleI(Mining, AsteroidGrowthInterval_ms)
-
-//There is no solid reason for having this as a different object
-//than the SystemEntity subclass, it is just the way the code came out.
-//It is very likely that this will need to be merged into the entity object
-//once the system matures more.
+static const double ASTEROID_GROWTH_RATE = 0.05;    //fraction of its ore an asteroid grows by, RuleR(Mining, AsteroidGrowthRate)
+
+/**
+ * Keeps the ore of the asteroids of a solar system in memory.
+ *
+ * Mining takes ore off the in-memory quantity right away and the
+ * decrements are applied to the asteroids once per tic, so a fleet
+ * of lasers on the same rock costs a single update. The quantities
+ * (AttrQuantity of the asteroid items) are snapshotted to the DB
+ * every world.asteroidSnapshotInterval seconds and when the system
+ * shuts down.
+ */
 class AsteroidBeltManager {
 public:
-    AsteroidBeltManager(uint32 belt_id);
+    AsteroidBeltManager(SystemManager &system);
     virtual ~AsteroidBeltManager();
 
-    //Database operations.
-    virtual bool LoadState();
+    void AddAsteroid(AsteroidEntity *roid);
+    void RemoveAsteroid(uint32 asteroidID);
+
+    /**
+     * Takes ore off an asteroid.
+     *
+     * @param[in] asteroidID The asteroid.
+     * @param[in] units The units to take.
+     * @return The units taken; less than asked if the asteroid runs out, 0 if it is not ours.
+     */
+    uint32 Mine(uint32 asteroidID, uint32 units);
+    /**
+     * @return Units of ore left in the asteroid; 0 if it is not ours.
+     */
+    uint32 GetOre(uint32 asteroidID) const;
+
+    //writes the ore of the asteroids changed since the last snapshot.
     virtual bool SaveState();
 
     virtual void Process();
     virtual void ForceGrowth();
 
 protected:
-    const uint32 m_beltID;
+    struct Asteroid {
+        AsteroidEntity *entity;    //the system owns these
+        uint32 ore;
+        //ore mined during the tic, not applied yet.
+        uint32 mined;
+        //ore changed since the last snapshot.
+        bool dirty;
+    };
+
+    SystemManager &m_system;    //we do not own this
 
     //runtime state:
     Timer m_growthTimer;
-    std::vector<AsteroidEntity*> m_asteroids;    //we own these
+    Timer m_snapshotTimer;
+    std::map<uint32, Asteroid> m_asteroids;
+    //asteroids mined during the tic.
+    std::set<uint32> m_mined;
 
+    void _ApplyMining();
     void _TriggerGrowth();
+    void _Save(Asteroid &roid);
 
     void _Clear();
 };
@@ -69,10 +106,7 @@ public:
     virtual void EncodeDestiny( Buffer& into ) const;
     virtual void Process();
     //SimpleSystemEntity:
-    virtual bool LoadExtras(SystemDB *db);
-
-protected:
-    AsteroidBeltManager *m_manager;    //dynamic to simplify dependancy issues.
+    virtual bool LoadExtras(const DBSystemState &state);
 };
 
 
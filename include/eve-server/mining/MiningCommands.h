@@ -3,7 +3,7 @@
 COMMAND( roid, ROLE_ADMIN,
          "(typeID) (radius) - Spawn an asteroid with the specified type." )
 COMMAND( growbelt, ROLE_ADMIN,
-         "- Trigger asteroid growth in the current belt." )
+         "- Trigger asteroid growth in the current solar system." )
 COMMAND( spawnbelt, ROLE_ADMIN,
          "- Creates a new asteroid belt." )
 
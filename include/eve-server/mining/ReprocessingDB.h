@@ -40,8 +40,14 @@ class ReprocessingDB
 public:
     bool IsRefinable(const uint32 typeID);
     bool IsRecyclable(const uint32 typeID);
-    bool LoadStatic(const uint32 stationID, double &efficiency, double &tax);
+    bool LoadStatic(const uint32 stationID, double &efficiency, double &tax, uint32 &ownerID);
     bool GetRecoverables(const uint32 typeID, std::vector<Recoverable> &into);
+    // queries the recoverables of all the types not cached yet at once
+    bool LoadRecoverables(const std::set<uint32> &typeIDs);
+
+protected:
+    // typeActivityMaterials never changes at runtime, so the recoverables of every type are queried only once
+    std::map<uint32, std::vector<Recoverable> > m_recoverables;
 };
 
 #endif
@@ -25,6 +25,8 @@
 #ifndef __AGENT_H_INCL__
 #define __AGENT_H_INCL__
 
+#include "missions/AgentCatalogue.h"
+
 class MissionDB;
 class Agent;
 
@@ -159,6 +161,19 @@ public:
 
 class Agent {
 public:
+    /**
+     * The choices of a conversation; the client sends the chosen one back to DoAction.
+     */
+    enum Action {
+        ACTION_GREETING = 0,
+        ACTION_REQUEST_MISSION = 1,
+        ACTION_LOCATE = 2,
+        ACTION_ACCEPT = 3,
+        ACTION_DECLINE = 4,
+        ACTION_COMPLETE = 5,
+        ACTION_QUIT = 6
+    };
+
     Agent(uint32 id);
     ~Agent();
 
@@ -166,9 +181,14 @@ public:
 
     uint32 GetLoyaltyPoints(Client *who);
     void DoAction(Client *who, uint32 actionID, std::string &say, std::map<uint32, std::string> &choices);
+    /**
+     * @return Dict describing the offered or accepted mission of the client; None if there is none.
+     */
+    PyRep *GetMissionBriefingInfo(Client *who);
 
 protected:
     const uint32 m_agentID;
+    const AgentCatalogue::AgentInfo *m_info;    //we do not own this.
     std::map<uint32, AgentActions *> m_actions;    //we own these.
 //    AgentLevel *m_agentLevel;
 };
@@ -0,0 +1,223 @@
+/*
+    ------------------------------------------------------------------------------------
+    LICENSE:
+    ------------------------------------------------------------------------------------
+    This file is part of EVEmu: EVE Online Server Emulator
+    Copyright 2006 - 2011 The EVEmu Team
+    For the latest information visit http://evemu.org
+    ------------------------------------------------------------------------------------
+    This program is free software; you can redistribute it and/or modify it under
+    the terms of the GNU Lesser General Public License as published by the Free Software
+    Foundation; either version 2 of the License, or (at your option) any later
+    version.
+
+    This program is distributed in the hope that it will be useful, but WITHOUT
+    ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+    FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public License along with
+    this program; if not, write to the Free Software Foundation, Inc., 59 Temple
+    Place - Suite 330, Boston, MA 02111-1307, USA, or go to
+    http://www.gnu.org/copyleft/lesser.txt.
+    ------------------------------------------------------------------------------------
+    Author:     EVEmu Team
+*/
+
+
+#ifndef __MISSIONS__AGENT_CATALOGUE_H__INCL__
+#define __MISSIONS__AGENT_CATALOGUE_H__INCL__
+
+#include "missions/MissionDB.h"
+#include "utils/Singleton.h"
+
+/**
+ * @brief Resident catalogue of the agents and the missions they offer.
+ *
+ * The agents, the NPC corporation divisions and the mission templates
+ * are loaded at startup and indexed by agent, by level and by the
+ * mission group (corporation, division, level) of an agent. The
+ * GetAgents rowset is built once from the catalogue.
+ *
+ * Offers are generated from memory and live in memory until they
+ * are accepted, declined or expire; only accepted and completed
+ * missions are written to chrMissionState. The missions of a
+ * character are loaded on first use and forgotten at logout.
+ *
+ * Not thread-safe; meant to be used from the main loop.
+ *
+ * @author EVEmu Team
+ */
+class AgentCatalogue
+: public Singleton< AgentCatalogue >
+{
+public:
+    enum MissionState
+    {
+        MISSION_OFFERED = 1,
+        MISSION_ACCEPTED = 2,
+        MISSION_COMPLETED = 3
+    };
+
+    /// Lifetime of an offer.
+    static const uint64 OFFER_LIFETIME;
+    /// Time an accepted mission is to be completed in.
+    static const uint64 MISSION_LIFETIME;
+
+    /**
+     * @brief An agent.
+     */
+    struct AgentInfo
+    {
+        uint32 agentID;
+        uint32 agentTypeID;
+        uint32 divisionID;
+        uint8 level;
+        int32 quality;
+        uint32 corporationID;
+        uint32 stationID;
+        uint32 solarSystemID;
+        uint32 bloodlineID;
+        uint8 gender;
+    };
+
+    /**
+     * @brief A mission template.
+     */
+    struct MissionInfo
+    {
+        uint32 missionID;
+        std::string missionName;
+        uint8 missionLevel;
+        uint32 missionTypeID;
+        std::string missionTypeName;
+        bool importantMission;
+    };
+
+    /**
+     * @brief Statistics of the catalogue.
+     */
+    struct Stats
+    {
+        Stats() { Reset(); }
+
+        void Reset()
+        {
+            offers = 0;
+            accepted = 0;
+            declined = 0;
+            completed = 0;
+            characterLoads = 0;
+        }
+
+        /// Number of offers generated.
+        uint32 offers;
+        /// Number of missions accepted.
+        uint32 accepted;
+        /// Number of offers declined or missions quit.
+        uint32 declined;
+        /// Number of missions completed.
+        uint32 completed;
+        /// Number of characters whose missions were loaded.
+        uint32 characterLoads;
+    };
+
+    AgentCatalogue();
+    ~AgentCatalogue();
+
+    /** @return Number of agents. */
+    size_t size() const { return mAgents.size(); }
+    /** @return Number of mission templates. */
+    size_t GetMissionCount() const { return mMissions.size(); }
+    /** @return Statistics since the last ResetStats(). */
+    const Stats& stats() const { return mStats; }
+    /** @brief Resets the statistics. */
+    void ResetStats() { mStats.Reset(); }
+
+    /**
+     * @brief Loads the agents, divisions and mission templates.
+     *
+     * @return True on success.
+     */
+    bool Load();
+
+    /** @return The agent; NULL if there is no such agent. */
+    const AgentInfo* GetAgent( uint32 agentID ) const;
+    /** @return Name of the division; empty if unknown. */
+    const std::string& GetDivisionName( uint32 divisionID ) const;
+    /** @return The mission template; NULL if there is no such mission. */
+    const MissionInfo* GetMission( uint32 missionID ) const;
+    /**
+     * @return The CRowset of all the agents; the columns are agentID, agentTypeID, divisionID, level,
+     *         stationID, quality, corporationID, bloodlineID and gender.
+     */
+    PyRep* GetAgentsRowset();
+
+    /**
+     * @brief Gets the mission a character has from an agent.
+     *
+     * @return The mission; NULL if the character has no offer nor mission from the agent.
+     */
+    const AgentMissionState* GetMissionState( uint32 characterID, uint32 agentID );
+    /**
+     * @brief Offers a mission of the agent to a character, unless it has one already.
+     *
+     * @return The offered mission; NULL if the agent has no mission to offer.
+     */
+    const MissionInfo* OfferMission( uint32 characterID, uint32 agentID );
+    /** @brief Accepts the offer of the agent; the mission is persisted. */
+    bool AcceptMission( uint32 characterID, uint32 agentID );
+    /** @brief Declines the offer of the agent, or quits the accepted mission. */
+    bool DeclineMission( uint32 characterID, uint32 agentID );
+    /** @brief Completes the accepted mission of the agent; the completion is persisted. */
+    bool CompleteMission( uint32 characterID, uint32 agentID );
+
+    /** @brief Forgets the missions of a character; they are loaded again on next use. */
+    void Forget( uint32 characterID ) { mCharacters.erase( characterID ); }
+
+protected:
+    /// The missions of a character, by agentID.
+    typedef std::map< uint32, AgentMissionState > CharacterMissions;
+
+    static uint64 _GroupKey( uint32 corporationID, uint32 divisionID, uint8 level )
+    {
+        return ( (uint64)corporationID << 32 ) | ( divisionID << 8 ) | level;
+    }
+
+    /** @return The missions of a character; NULL if they could not be loaded. */
+    CharacterMissions* _GetCharacter( uint32 characterID );
+    /**
+     * @param[in] lastMissionID The mission the character completed last for the agent, which is not offered again unless it is the only one.
+     *
+     * @return Index of the mission to offer; mMissions.size() if there is none.
+     */
+    size_t _PickMission( uint32 characterID, const AgentInfo& agent, uint32 lastMissionID ) const;
+
+    /// The agents, by agentID.
+    std::tr1::unordered_map< uint32, AgentInfo > mAgents;
+    /// The division names, by divisionID.
+    std::map< uint32, std::string > mDivisions;
+    /// The mission templates.
+    std::vector< MissionInfo > mMissions;
+    /// Indices of the mission templates, by missionID.
+    std::tr1::unordered_map< uint32, size_t > mMissionIndex;
+    /// Indices of the mission templates, by level.
+    std::vector< std::vector< size_t > > mMissionsByLevel;
+    /// Index of the mission template of a mission group, by _GroupKey().
+    std::tr1::unordered_map< uint64, size_t > mMissionGroups;
+    /// The GetAgents rowset; NULL until first used.
+    PyRep* mAgentsRowset;
+
+    /// The missions of the characters, by characterID.
+    std::tr1::unordered_map< uint32, CharacterMissions > mCharacters;
+
+    MissionDB mDB;
+
+    /// Statistics.
+    Stats mStats;
+};
+
+/// A macro for easier access to the singleton.
+#define sAgentCatalogue \
+    ( AgentCatalogue::get() )
+
+#endif /* !__MISSIONS__AGENT_CATALOGUE_H__INCL__ */
@@ -32,12 +32,16 @@
 
 class Agent;
 
+class ObjectCachedMethodID;
+
 class AgentMgrService : public PyService
 {
 public:
     AgentMgrService(PyServiceMgr *mgr);
     virtual ~AgentMgrService();
 
+    virtual void PrimeCache();
+
 protected:
     class Dispatcher;
     Dispatcher *const m_dispatch;
@@ -53,6 +57,8 @@ protected:
     PyCallable_DECL_CALL(GetMyEpicJournalDetails)
     PyCallable_DECL_CALL(GetSolarSystemOfAgent)
 
+    void _CacheAgents(const ObjectCachedMethodID &method_id);
+
     //overloaded in order to support bound objects:
     virtual PyBoundObject *_CreateBoundObject(Client *c, const PyRep *bind_args);
 };
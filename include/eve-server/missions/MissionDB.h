@@ -33,13 +33,30 @@ class PyRep;
 
 class AgentActions;
 
+/**
+ * @brief The mission a character runs for an agent.
+ */
+struct AgentMissionState
+{
+    uint32 missionID;
+    /// One of AgentCatalogue::MissionState.
+    uint8 missionState;
+    uint64 expirationTime;
+};
+
 class MissionDB
 : public ServiceDB
 {
 public:
-    PyObjectEx *GetAgents();
     bool LoadAgentActions(uint32 agentID, std::map<uint32, AgentActions *> &into);
 
+    /**
+     * @brief Loads the accepted and completed missions of a character, by agentID.
+     */
+    bool LoadMissionStates(uint32 characterID, std::map<uint32, AgentMissionState> &into);
+    bool SaveMissionState(uint32 characterID, uint32 agentID, const AgentMissionState &state);
+    bool DeleteMissionState(uint32 characterID, uint32 agentID);
+
     //AgentLevel *LoadAgentLevel(uint8 level);
 
 protected:
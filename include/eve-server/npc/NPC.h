@@ -52,9 +52,20 @@ public:
         SpawnEntry *spawner = NULL);
     virtual ~NPC();
 
+    /**
+     * @brief Allocates NPCs from ObjectPool; spawns and dungeons come and go in batches.
+     */
+    static void* operator new( size_t size ) { return ObjectPool< NPC >::Allocate( size ); }
+    static void operator delete( void* p, size_t size ) { ObjectPool< NPC >::Free( p, size ); }
+
     bool Load(ServiceDB &from);
 
     void Orbit(SystemEntity *who);
+    //the spawn entry which spawned us, may be NULL.
+    SpawnEntry *GetSpawner() const { return(m_spawner); }
+    //launched drones are driven by the swarm of their pilot instead of their AI.
+    bool IsSwarmed() const { return(m_swarmed); }
+    void SetSwarmed(bool swarmed) { m_swarmed = swarmed; }
 
     inline double x() const { return(GetPosition().x); }
     inline double y() const { return(GetPosition().y); }
@@ -63,6 +74,7 @@ public:
     //SystemEntity interface:
     virtual EntityClass GetClass() const { return(ecNPC); }
     virtual bool IsNPC() const { return true; }
+    virtual bool IsTicked() const { return true; }
     virtual NPC *CastToNPC() { return(this); }
     virtual const NPC *CastToNPC() const { return(this); }
     virtual void Process();
@@ -122,6 +134,7 @@ protected:
     uint32 m_orbitingID;
 
     NPCAIMgr *m_AI;    //never NULL
+    bool m_swarmed;    //see DroneSwarmManager
 
 
     /* Used to calculate the damages on NPCs
@@ -132,9 +145,6 @@ protected:
     double m_shieldCharge;
     double m_armorDamage;
     double m_hullDamage;
-
-    void _SendDamageStateChanged() const;
-
 };
 
 #endif
@@ -39,12 +39,14 @@ public:
     void TargetLost(SystemEntity *by_who);
 
 protected:
+    void _Think();
     void CheckAttacks(SystemEntity *target);
     void _EnterIdle();
     void _EnterChasing(SystemEntity *target);
     void _EnterFollowing(SystemEntity *target);
     void _EnterEngaged(SystemEntity *target);
     void _SendWeaponEffect(const char *effect, SystemEntity *target);
+    SystemEntity *_FindProximityTarget() const;
 
     typedef enum {
         Idle,
@@ -58,11 +60,13 @@ protected:
     EvilNumber m_entityFlyRange2;
     EvilNumber m_entityChaseMaxDistance2;
     EvilNumber m_entityAttackRange2;
+    EvilNumber m_proximityRange;
 
     NPC *const m_npc;
 
     Timer m_processTimer;
     Timer m_mainAttackTimer;
+    Timer m_proximityTimer;
 
     Timer m_shieldBoosterTimer;
     Timer m_armorRepairTimer;
@@ -28,14 +28,16 @@
 #include "ServiceDB.h"
 
 class SpawnGroup;
-class SpawnEntry;
+struct SpawnPoint;
 
 class SpawnDB
 : public ServiceDB
 {
 public:
-    bool LoadSpawnGroups(uint32 solarSystemID, std::map<uint32, SpawnGroup *> &into);
-    bool LoadSpawnEntries(uint32 solarSystemID, const std::map<uint32, SpawnGroup *> &groups, std::map<uint32, SpawnEntry *> &into);
+    //loads all the spawn groups with their entries; the caller owns them.
+    bool LoadSpawnGroups(std::map<uint32, SpawnGroup *> &into);
+    //loads all the spawns of the groups, by solarSystemID.
+    bool LoadSpawnPoints(const std::map<uint32, SpawnGroup *> &groups, std::map<uint32, std::vector<SpawnPoint> > &into);
 
 protected:
 };
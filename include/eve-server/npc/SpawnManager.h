@@ -26,9 +26,8 @@
 #ifndef __SPAWN_MANAGER_H__
 #define __SPAWN_MANAGER_H__
 
-#include "npc/SpawnDB.h"
-
 class SystemManager;
+class SystemEntity;
 class PyServiceMgr;
 
 //TODO: add formation stuff....
@@ -63,9 +62,13 @@ public:
     const uint32 formation;
 
     std::vector<Entry> entries;
+    //the most NPCs the group spawns at once, the sum of the quantities.
+    uint32 maxMembers;
 };
 
-class SpawnEntry {
+class SpawnEntry
+: public TimerWheel::Callback
+{
 public:
     typedef enum {
         boundsPoint = 0,
@@ -81,7 +84,7 @@ public:
 
     SpawnEntry(
         uint32 id,
-        SpawnGroup &group,
+        const SpawnGroup &group,
         uint32 timerMin,
         uint32 timerMax,
         uint32 timerValue,
@@ -89,35 +92,61 @@ public:
 
     inline uint32 GetID() const { return(m_id); }
 
-    //passing these pointers so we dont have to store them in each entry.
-    void Process(SystemManager &mgr, PyServiceMgr &svc);
+    //starts the spawn timer, the entry spawns into mgr whenever it expires.
+    void Start(SystemManager &mgr, PyServiceMgr &svc);
 
     bool CheckBounds() const;
 
     void SpawnDepoped(uint32 npcID);
 
+    //appends the clients which may be within range of any NPC we spawned.
+    //the NPCs share a single proximity query per destiny stamp, so they
+    //have to check the actual distance themselves.
+    void GetNearbyClients(double range, std::vector<SystemEntity *> &into);
+
     //I really dont want this to be public, but it makes loading a lot
     //easier right now, so here it is.
     std::vector<GPoint> bounds;
 protected:
+    void TimerExpired();
+
     void _DoSpawn(SystemManager &mgr, PyServiceMgr &svc);
 
     //curently spawned information:
     std::set<uint32> m_spawnedIDs;
 
+    //the last proximity query:
+    std::vector<uint32> m_nearbyClients;    //IDs, they may be gone since.
+    uint32 m_nearbyStamp;
+    double m_nearbyRange;
+
     //static info:
     const uint32 m_id;
-    SpawnGroup &m_group;
+    const SpawnGroup &m_group;    //owned by the spawn table
 
     //spawn timer:
     const uint32 m_timerMin;    //in seconds
     const uint32 m_timerMax;    //in seconds
-    Timer m_timer;
+    const uint32 m_timerValue;    //initial, in milliseconds
+
+    SystemManager *m_system;    //we do not own this
+    PyServiceMgr *m_services;    //we do not own this
 
     //bounds:
     const SpawnBoundsType m_boundsType;
 };
 
+//a spawn as loaded from the DB, from which the systems make their spawn entries.
+struct SpawnPoint {
+    uint32 spawnID;
+    uint32 spawnGroupID;
+    SpawnEntry::SpawnBoundsType boundsType;
+    uint32 spawnTimer;        //when it spawns, in seconds
+    uint32 respawnTimeMin;    //in seconds
+    uint32 respawnTimeMax;    //in seconds
+    std::vector<GPoint> bounds;
+};
+
 class SpawnManager
 {
 public:
@@ -126,15 +155,11 @@ public:
 
     bool Load();
     bool DoInitialSpawn();
-    void Process();
 
 protected:
     SystemManager &m_system;    //we do not own this
     PyServiceMgr &m_services;    //we do not own this
 
-    SpawnDB m_db;
-
-    std::map<uint32, SpawnGroup *> m_groups;    //we own these
     std::map<uint32, SpawnEntry *> m_spawns;    //we own these.
 };
 
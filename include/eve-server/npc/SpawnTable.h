@@ -0,0 +1,123 @@
+/*
+    ------------------------------------------------------------------------------------
+    LICENSE:
+    ------------------------------------------------------------------------------------
+    This file is part of EVEmu: EVE Online Server Emulator
+    Copyright 2006 - 2011 The EVEmu Team
+    For the latest information visit http://evemu.org
+    ------------------------------------------------------------------------------------
+    This program is free software; you can redistribute it and/or modify it under
+    the terms of the GNU Lesser General Public License as published by the Free Software
+    Foundation; either version 2 of the License, or (at your option) any later
+    version.
+
+    This program is distributed in the hope that it will be useful, but WITHOUT
+    ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+    FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public License along with
+    this program; if not, write to the Free Software Foundation, Inc., 59 Temple
+    Place - Suite 330, Boston, MA 02111-1307, USA, or go to
+    http://www.gnu.org/copyleft/lesser.txt.
+    ------------------------------------------------------------------------------------
+    Author:     EVEmu Team
+*/
+
+
+#ifndef __NPC__SPAWN_TABLE_H__INCL__
+#define __NPC__SPAWN_TABLE_H__INCL__
+
+#include "npc/SpawnDB.h"
+#include "npc/SpawnManager.h"
+#include "utils/Singleton.h"
+
+/**
+ * @brief Resident tables of the spawn groups and the spawns of all the systems.
+ *
+ * The spawn groups, their entries and the spawns with their bounds
+ * are loaded once at startup, so booting a system makes its spawn
+ * entries from memory instead of querying four tables. The groups
+ * are shared by all the spawn entries which use them.
+ *
+ * The spawn entries schedule themselves on the timer wheel, and the
+ * NPCs they spawn are transient items (see ItemFactory::SpawnTransientItem).
+ *
+ * Not thread-safe; meant to be used from the main loop.
+ *
+ * @author EVEmu Team
+ */
+class SpawnTable
+: public Singleton< SpawnTable >
+{
+public:
+    /**
+     * @brief Statistics of the spawns.
+     */
+    struct Stats
+    {
+        Stats() { Reset(); }
+
+        void Reset()
+        {
+            spawns = 0;
+            npcs = 0;
+            depops = 0;
+        }
+
+        /// Number of spawned groups.
+        uint32 spawns;
+        /// Number of spawned NPCs.
+        uint32 npcs;
+        /// Number of depopped NPCs.
+        uint32 depops;
+    };
+
+    SpawnTable();
+    ~SpawnTable();
+
+    /** @return Number of spawn groups. */
+    size_t size() const { return mGroups.size(); }
+    /** @return Number of spawns of all the systems. */
+    size_t GetSpawnCount() const { return mSpawnCount; }
+    /** @return Statistics since the last ResetStats(). */
+    const Stats& stats() const { return mStats; }
+    /** @brief Resets the statistics. */
+    void ResetStats() { mStats.Reset(); }
+
+    /**
+     * @brief Loads the spawn groups and the spawns.
+     *
+     * @return True on success.
+     */
+    bool Load();
+
+    /** @return The spawn group; NULL if there is no such group. */
+    const SpawnGroup* GetGroup( uint32 spawnGroupID ) const;
+    /** @return The spawns of the system; NULL if it has none. */
+    const std::vector< SpawnPoint >* GetSpawns( uint32 solarSystemID ) const;
+
+    /** @brief Counts a spawned group of NPCs. */
+    void CountSpawn( size_t npcs ) { ++mStats.spawns; mStats.npcs += npcs; }
+    /** @brief Counts a depopped NPC. */
+    void CountDepop() { ++mStats.depops; }
+
+protected:
+    void _Clear();
+
+    SpawnDB mDB;
+
+    /// The spawn groups, by spawnGroupID; we own these.
+    std::map< uint32, SpawnGroup* > mGroups;
+    /// The spawns, by solarSystemID.
+    std::map< uint32, std::vector< SpawnPoint > > mSpawns;
+    size_t mSpawnCount;
+
+    /// Statistics.
+    Stats mStats;
+};
+
+/// A macro for easier access to the singleton.
+#define sSpawnTable \
+    ( SpawnTable::get() )
+
+#endif /* !__NPC__SPAWN_TABLE_H__INCL__ */
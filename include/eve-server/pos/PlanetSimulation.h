@@ -0,0 +1,250 @@
+/*
+    ------------------------------------------------------------------------------------
+    LICENSE:
+    ------------------------------------------------------------------------------------
+    This file is part of EVEmu: EVE Online Server Emulator
+    Copyright 2006 - 2011 The EVEmu Team
+    For the latest information visit http://evemu.org
+    ------------------------------------------------------------------------------------
+    This program is free software; you can redistribute it and/or modify it under
+    the terms of the GNU Lesser General Public License as published by the Free Software
+    Foundation; either version 2 of the License, or (at your option) any later
+    version.
+
+    This program is distributed in the hope that it will be useful, but WITHOUT
+    ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+    FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public License along with
+    this program; if not, write to the Free Software Foundation, Inc., 59 Temple
+    Place - Suite 330, Boston, MA 02111-1307, USA, or go to
+    http://www.gnu.org/copyleft/lesser.txt.
+    ------------------------------------------------------------------------------------
+    Author:     EVEmu Team
+*/
+
+
+#ifndef __POS__PLANET_SIMULATION_H__INCL__
+#define __POS__PLANET_SIMULATION_H__INCL__
+
+#include "utils/Singleton.h"
+
+class PyRep;
+
+/**
+ * @brief Planetary colonies, advanced lazily.
+ *
+ * Nothing is simulated per tick: a colony is loaded and advanced to
+ * the current time only once it is observed (GetColony()) or changed.
+ * The extractors yield a decaying amount per cycle, so the output of
+ * any number of cycles is a closed-form geometric sum; the factories
+ * run as many of the cycles since their last run as their inputs
+ * allow. The extractors are advanced before the factories, so an
+ * extractor's output is available to the factories at once.
+ *
+ * The resource heat maps of a planet are generated once from the
+ * planetID, so they come out the same on every start, and kept for
+ * the extractors and the cached GetPlanetResourceInfo results.
+ *
+ * Not thread-safe; meant to be used from the main loop.
+ *
+ * @author EVEmu Team
+ */
+class PlanetSimulation
+: public Singleton< PlanetSimulation >
+{
+public:
+    enum PinKind
+    {
+        PIN_EXTRACTOR = 0,
+        PIN_FACTORY   = 1
+    };
+
+    /**
+     * @brief Statistics of the simulation.
+     */
+    struct Stats
+    {
+        Stats() { Reset(); }
+
+        void Reset()
+        {
+            observations = 0;
+            loads = 0;
+            extractorCycles = 0;
+            factoryCycles = 0;
+            heatMaps = 0;
+        }
+
+        /// Number of times a colony was observed.
+        uint32 observations;
+        /// Number of colonies loaded.
+        uint32 loads;
+        /// Number of extractor cycles computed.
+        uint32 extractorCycles;
+        /// Number of factory cycles run.
+        uint32 factoryCycles;
+        /// Number of heat maps generated.
+        uint32 heatMaps;
+    };
+
+    /**
+     * @brief A pin of a colony.
+     */
+    struct Pin
+    {
+        uint32 pinID;
+        uint32 typeID;
+        uint8 kind;
+        double latitude;
+        double longitude;
+        /// The schematic of a factory.
+        uint32 schematicID;
+        /// The resource of an extractor.
+        uint32 resourceTypeID;
+        /// Length of a cycle (in seconds).
+        uint32 cycleTime;
+        /// Yield of the first cycle of an extractor.
+        uint32 qtyPerCycle;
+        /// Times (Win32 time).
+        uint64 installTime;
+        /// End of the program of an extractor; 0 for factories.
+        uint64 expiryTime;
+        /// End of the last cycle run.
+        uint64 lastRunTime;
+    };
+
+    /**
+     * @brief The colony of a character on a planet.
+     */
+    struct Colony
+    {
+        uint32 planetID;
+        uint32 ownerID;
+        std::vector< Pin > pins;
+        /// The storage of the colony, by typeID.
+        std::map< uint32, uint32 > contents;
+    };
+
+    PlanetSimulation();
+    ~PlanetSimulation();
+
+    /** @return Number of loaded colonies. */
+    size_t size() const { return mColonies.size(); }
+    /** @return Statistics since the last ResetStats(). */
+    const Stats& stats() const { return mStats; }
+    /** @brief Resets the statistics. */
+    void ResetStats() { mStats.Reset(); }
+
+    /**
+     * @brief Loads the schematics.
+     *
+     * @return True on success.
+     */
+    bool Load();
+
+    /**
+     * @brief Gets a colony advanced to now.
+     *
+     * @return The colony; NULL if it could not be loaded.
+     */
+    const Colony* GetColony( uint32 planetID, uint32 ownerID );
+
+    /**
+     * @brief Installs an extractor.
+     *
+     * @param[in] planetID       The planet.
+     * @param[in] ownerID        The character.
+     * @param[in] resourceTypeID The extracted resource; must be one of the planet's.
+     * @param[in] latitude       Where (in radians, 0 - pi).
+     * @param[in] longitude      Where (in radians, 0 - 2 pi).
+     * @param[in] cycleTime      Length of a cycle (in seconds).
+     * @param[in] programTime    Length of the program (in seconds).
+     *
+     * @return ID of the pin; 0 on failure.
+     */
+    uint32 InstallExtractor( uint32 planetID, uint32 ownerID, uint32 resourceTypeID, double latitude, double longitude, uint32 cycleTime, uint32 programTime );
+    /**
+     * @brief Installs a factory.
+     *
+     * @return ID of the pin; 0 on failure.
+     */
+    uint32 InstallFactory( uint32 planetID, uint32 ownerID, uint32 schematicID );
+
+    /**
+     * @brief Lists the planets a character has colonies on.
+     *
+     * @return The util.Rowset; NULL on failure.
+     */
+    PyRep* GetPlanetsForChar( uint32 ownerID );
+    /**
+     * @brief Describes a colony, advanced to now.
+     *
+     * @return The util.KeyVal; NULL on failure.
+     */
+    PyRep* GetPlanetInfo( uint32 planetID, uint32 ownerID );
+    /**
+     * @brief Gets the qualities of the resources of a planet, by typeID.
+     *
+     * @return The dict; NULL on failure.
+     */
+    PyRep* GetPlanetResourceInfo( uint32 planetID );
+
+protected:
+    /**
+     * @brief A factory recipe.
+     */
+    struct Schematic
+    {
+        uint32 cycleTime;
+        /// A pin which runs it.
+        uint32 pinTypeID;
+        std::map< uint32, uint32 > inputs;
+        std::map< uint32, uint32 > outputs;
+    };
+
+    /**
+     * @brief The resources of a planet.
+     */
+    struct HeatMap
+    {
+        uint32 planetTypeID;
+        /// Concentrations (0 - 1) of the cells of every resource, by its typeID; row by latitude.
+        std::map< uint32, std::vector< float > > cells;
+    };
+
+    static uint64 _ColonyKey( uint32 planetID, uint32 ownerID ) { return ( (uint64)planetID << 32 ) | ownerID; }
+    /**
+     * @return The total yield of the first cycles of an extractor.
+     */
+    static uint64 _Extracted( uint32 qtyPerCycle, uint64 cycles );
+
+    Colony* _GetColony( uint32 planetID, uint32 ownerID );
+    /**
+     * @brief Advances a colony to a time and saves what changed.
+     */
+    void _Advance( Colony& colony, uint64 now );
+    bool _Save( const Colony& colony, const std::vector< uint32 >& pinIDs );
+
+    const HeatMap* _GetHeatMap( uint32 planetID );
+    /**
+     * @return Concentration (0 - 1) of a resource of a heat map at a place.
+     */
+    static float _Concentration( const HeatMap& map, uint32 resourceTypeID, double latitude, double longitude );
+
+    /// The schematics, by ID.
+    std::map< uint32, Schematic > mSchematics;
+    /// The loaded colonies, by _ColonyKey(); we own these.
+    std::map< uint64, Colony* > mColonies;
+    /// The generated heat maps, by planetID.
+    std::map< uint32, HeatMap > mHeatMaps;
+
+    /// Statistics.
+    Stats mStats;
+};
+
+/// A macro for easier access to the singleton.
+#define sPlanetSimulation \
+    ( PlanetSimulation::get() )
+
+#endif /* !__POS__PLANET_SIMULATION_H__INCL__ */
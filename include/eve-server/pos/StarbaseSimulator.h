@@ -0,0 +1,238 @@
+/*
+    ------------------------------------------------------------------------------------
+    LICENSE:
+    ------------------------------------------------------------------------------------
+    This file is part of EVEmu: EVE Online Server Emulator
+    Copyright 2006 - 2011 The EVEmu Team
+    For the latest information visit http://evemu.org
+    ------------------------------------------------------------------------------------
+    This program is free software; you can redistribute it and/or modify it under
+    the terms of the GNU Lesser General Public License as published by the Free Software
+    Foundation; either version 2 of the License, or (at your option) any later
+    version.
+
+    This program is distributed in the hope that it will be useful, but WITHOUT
+    ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+    FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public License along with
+    this program; if not, write to the Free Software Foundation, Inc., 59 Temple
+    Place - Suite 330, Boston, MA 02111-1307, USA, or go to
+    http://www.gnu.org/copyleft/lesser.txt.
+    ------------------------------------------------------------------------------------
+    Author:     EVEmu Team
+*/
+
+
+#ifndef __POS__STARBASE_SIMULATOR_H__INCL__
+#define __POS__STARBASE_SIMULATOR_H__INCL__
+
+#include "inventory/ItemRef.h"
+#include "utils/Singleton.h"
+#include "utils/TimerWheel.h"
+
+class ItemFactory;
+
+/**
+ * @brief States of control towers, as the client knows them.
+ */
+enum StarbaseState
+{
+    starbaseStateUnanchored = 0,
+    starbaseStateAnchored   = 1,
+    starbaseStateOnlining   = 2,
+    starbaseStateReinforced = 3,
+    starbaseStateOnline     = 4
+};
+
+/**
+ * @brief Burns the fuel of the control towers in batched passes.
+ *
+ * The states of the towers are kept in memory along with the start
+ * of their current fuel cycle, so the fuel a tower burnt is computed
+ * from the timestamps instead of polling the tower: a pass burns all
+ * the cycles which ended since, however many of them there are, and
+ * offlines the towers which run out of fuel. The passes run once the
+ * earliest cycle ends, delayed by STARBASE_PASS_DELAY so towers
+ * cycling close to each other share a pass.
+ *
+ * A pass preloads the fuel bays of all the due towers at once and
+ * writes the fuel and the states in bulk, the fuel through
+ * InventoryWriteBehind and the states by a single statement.
+ *
+ * Reinforced towers keep burning fuel and come back online once
+ * their reinforcement ends. Silos and reactors are not simulated.
+ *
+ * Not thread-safe; meant to be used from the main loop.
+ *
+ * @author EVEmu Team
+ */
+class StarbaseSimulator
+: public Singleton< StarbaseSimulator >
+{
+public:
+    /**
+     * @brief Statistics of the passes.
+     */
+    struct Stats
+    {
+        Stats() { Reset(); }
+
+        void Reset()
+        {
+            passes = 0;
+            towers = 0;
+            cycles = 0;
+            offlined = 0;
+            passTime = 0;
+            maxPassTime = 0;
+        }
+
+        /// Number of passes.
+        uint32 passes;
+        /// Number of towers the passes cycled.
+        uint32 towers;
+        /// Number of fuel cycles burnt.
+        uint32 cycles;
+        /// Number of towers which ran out of fuel.
+        uint32 offlined;
+        /// Total time (in microseconds) spent in the passes.
+        uint64 passTime;
+        /// Longest pass (in microseconds).
+        uint32 maxPassTime;
+    };
+
+    /**
+     * @brief A control tower.
+     */
+    struct Tower
+    {
+        uint32 towerID;
+        uint32 typeID;
+        uint8 state;
+        /// Start of the current fuel cycle (Win32 time); 0 if the tower burns no fuel.
+        uint64 cycleStart;
+        /// End of the reinforcement (Win32 time); 0 if not reinforced.
+        uint64 reinforcedUntil;
+        /// Security status of the solar system of the tower.
+        double security;
+        /// The faction owning the solar system; 0 if none.
+        uint32 factionID;
+    };
+
+    StarbaseSimulator();
+
+    /** @return Number of simulated towers. */
+    size_t size() const { return mTowers.size(); }
+    /** @return The simulated towers, by ID. */
+    const std::map< uint32, Tower >& GetTowers() const { return mTowers; }
+    /** @return Statistics since the last ResetStats(). */
+    const Stats& stats() const { return mStats; }
+    /** @brief Resets the statistics. */
+    void ResetStats() { mStats.Reset(); }
+
+    /**
+     * @brief Loads the fuel requirements and the states of the towers, and schedules the first pass.
+     *
+     * @param[in] factory The factory the fuel is taken through.
+     *
+     * @return True on success.
+     */
+    bool Load( ItemFactory& factory );
+
+    /**
+     * @brief Changes the state of a tower; onlining starts its first fuel cycle.
+     *
+     * Towers anchored since Load() are picked up here.
+     *
+     * @param[in] towerID The tower.
+     * @param[in] state   The new state; starbaseStateReinforced is left to Reinforce().
+     *
+     * @return True on success, false if the tower is unknown or the state could not be saved.
+     */
+    bool SetState( uint32 towerID, StarbaseState state );
+    /**
+     * @brief Reinforces an online tower.
+     *
+     * @param[in] towerID The tower.
+     * @param[in] until   End of the reinforcement (Win32 time).
+     *
+     * @return True on success, false if the tower is not online or the state could not be saved.
+     */
+    bool Reinforce( uint32 towerID, uint64 until );
+
+    /**
+     * @brief Runs a pass right away.
+     */
+    void RunPass();
+
+protected:
+    /**
+     * @brief Fuel a tower burns per cycle.
+     */
+    struct Fuel
+    {
+        uint32 typeID;
+        uint32 quantity;
+        /// The least security status at which it is needed; -1 if needed anywhere.
+        double minSecurityLevel;
+        /// The faction whose space needs it; 0 if any.
+        uint32 factionID;
+    };
+
+    /**
+     * @brief Burns the cycles of a tower which ended by now.
+     *
+     * @param[in] tower The tower.
+     * @param[in] now   The current time (Win32 time).
+     * @param[in] bay   The fuel in the bay of the tower.
+     *
+     * @return True if the tower changed.
+     */
+    bool _Cycle( Tower& tower, uint64 now, std::vector< InventoryItemRef >& bay );
+    /**
+     * @brief Gets the fuel in the bay of a tower, out of the preloaded items unless the bay is loaded.
+     *
+     * @param[in] tower     The tower.
+     * @param[in] preloaded IDs of the preloaded items in the bay.
+     * @param[out] into     The fuel.
+     */
+    void _GetBay( const Tower& tower, const std::vector< uint32 >& preloaded, std::vector< InventoryItemRef >& into );
+    /**
+     * @return The end of the current fuel cycle of the tower; 0 if it burns no fuel.
+     */
+    static uint64 _CycleEnd( const Tower& tower );
+
+    /**
+     * @brief Loads towers in space.
+     *
+     * @param[in] towerID The tower to load; 0 loads all of them.
+     */
+    bool _LoadTowers( uint32 towerID );
+    /**
+     * @brief Writes the states of the towers at once.
+     */
+    bool _SaveStates( const std::vector< uint32 >& towerIDs );
+
+    void _Pass();
+    void _SchedulePass();
+
+    /// The factory the fuel is taken through; NULL until Load().
+    ItemFactory* mFactory;
+    /// Fuel per cycle, by type of tower.
+    std::map< uint32, std::vector< Fuel > > mFuel;
+    /// The towers, by ID.
+    std::map< uint32, Tower > mTowers;
+
+    /// The timer of the next pass.
+    TimerWheelMember< StarbaseSimulator, &StarbaseSimulator::_Pass > mPassTimer;
+
+    /// Statistics.
+    Stats mStats;
+};
+
+/// A macro for easier access to the singleton.
+#define sStarbaseSimulator \
+    ( StarbaseSimulator::get() )
+
+#endif /* !__POS__STARBASE_SIMULATOR_H__INCL__ */
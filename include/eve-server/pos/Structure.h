@@ -154,6 +154,12 @@ public:
         PyServiceMgr &services,
         const GPoint &position);
 
+    /**
+     * @brief Allocates structures from ObjectPool; dungeons spawn and tear them down in batches.
+     */
+    static void* operator new( size_t size ) { return ObjectPool< StructureEntity >::Allocate( size ); }
+    static void operator delete( void* p, size_t size ) { ObjectPool< StructureEntity >::Free( p, size ); }
+
     /*
      * Primary public interface:
      */
@@ -54,6 +54,8 @@ public:
     ~DestinyManager();
 
     void Process();
+    //whether Process() would do nothing: stopped, or a ball which never moves by itself.
+    bool IsIdle() const;
 
     void SendSingleDestinyUpdate(PyTuple **up, bool self_only=false) const;
     void SendDestinyUpdate(std::vector<PyTuple *> &updates, bool self_only) const;
@@ -0,0 +1,93 @@
+/*
+    ------------------------------------------------------------------------------------
+    LICENSE:
+    ------------------------------------------------------------------------------------
+    This file is part of EVEmu: EVE Online Server Emulator
+    Copyright 2006 - 2011 The EVEmu Team
+    For the latest information visit http://evemu.org
+    ------------------------------------------------------------------------------------
+    This program is free software; you can redistribute it and/or modify it under
+    the terms of the GNU Lesser General Public License as published by the Free Software
+    Foundation; either version 2 of the License, or (at your option) any later
+    version.
+
+    This program is distributed in the hope that it will be useful, but WITHOUT
+    ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+    FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public License along with
+    this program; if not, write to the Free Software Foundation, Inc., 59 Temple
+    Place - Suite 330, Boston, MA 02111-1307, USA, or go to
+    http://www.gnu.org/copyleft/lesser.txt.
+    ------------------------------------------------------------------------------------
+    Author:     EVEmu Team
+*/
+
+
+#ifndef __SHIP__DRONE_SWARM_H__INCL__
+#define __SHIP__DRONE_SWARM_H__INCL__
+
+class Client;
+class NPC;
+class SystemEntity;
+class SystemManager;
+
+static const int32 DRONE_SWARM_THINK_MS = 250;    //how often the swarms look at the targets of their pilots.
+static const double DRONE_IDLE_ORBIT = 1000.0;    //distance the idle drones orbit their pilot at.
+
+/**
+ * Controls the drones the pilots of a solar system launched.
+ *
+ * The drones of a pilot form a swarm with a single controller
+ * instead of an AI each. The swarm follows the first target its
+ * pilot has locked (without one, the drones orbit the pilot),
+ * orders all its drones only when that target changes, and fires
+ * one volley per cycle: the damage of the drones in range is summed
+ * up and applied to the target as a single hit. The orders and the
+ * weapon effects of a swarm are bubblecast together.
+ *
+ * The drones are still balls of their own, moved by their own
+ * DestinyManager, since the clients see every one of them.
+ */
+class DroneSwarmManager {
+public:
+    DroneSwarmManager(SystemManager &system);
+    ~DroneSwarmManager();
+
+    /** Puts a launched drone under the control of the swarm of its pilot. */
+    void Add(Client *owner, NPC *drone);
+    /** Takes a drone out of its swarm; called as the drone goes away. */
+    void Remove(NPC *drone);
+    /** Leaves the drones of a pilot leaving the system where they are. */
+    void Abandon(Client *owner);
+
+    /** @return Number of drones under control. */
+    size_t GetDroneCount() const { return(m_owners.size()); }
+
+    void Process();
+
+protected:
+    struct Swarm {
+        Swarm() : owner(NULL), targetID(0), ordered(false), nextVolley(0) {}
+
+        Client *owner;    //we do not own this, NULL once abandoned
+        std::vector<NPC *> drones;    //the system owns these
+        uint32 targetID;    //0 while orbiting the owner
+        bool ordered;    //whether all the drones follow targetID
+        uint32 nextVolley;    //Timer::GetCurrentTime() of the next volley
+    };
+
+    void _Think(Swarm &swarm);
+    void _Order(Swarm &swarm, SystemEntity *target);
+    void _Volley(Swarm &swarm, SystemEntity *target);
+
+    SystemManager &m_system;    //we do not own this
+
+    Timer m_thinkTimer;
+    //the swarms, by the character ID of their pilot.
+    std::map<uint32, Swarm> m_swarms;
+    //the pilot of every drone, by the ID of the drone.
+    std::map<uint32, uint32> m_owners;
+};
+
+#endif /* !__SHIP__DRONE_SWARM_H__INCL__ */
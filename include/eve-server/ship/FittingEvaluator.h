@@ -0,0 +1,246 @@
+/*
+    ------------------------------------------------------------------------------------
+    LICENSE:
+    ------------------------------------------------------------------------------------
+    This file is part of EVEmu: EVE Online Server Emulator
+    Copyright 2006 - 2011 The EVEmu Team
+    For the latest information visit http://evemu.org
+    ------------------------------------------------------------------------------------
+    This program is free software; you can redistribute it and/or modify it under
+    the terms of the GNU Lesser General Public License as published by the Free Software
+    Foundation; either version 2 of the License, or (at your option) any later
+    version.
+
+    This program is distributed in the hope that it will be useful, but WITHOUT
+    ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+    FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public License along with
+    this program; if not, write to the Free Software Foundation, Inc., 59 Temple
+    Place - Suite 330, Boston, MA 02111-1307, USA, or go to
+    http://www.gnu.org/copyleft/lesser.txt.
+    ------------------------------------------------------------------------------------
+    Author:     EVEmu Team
+*/
+
+#ifndef __FITTING_EVALUATOR_H__INCL__
+#define __FITTING_EVALUATOR_H__INCL__
+
+#include "ship/modules/ModuleDefs.h"
+#include "utils/Singleton.h"
+
+/**
+ * @brief A fitting to evaluate: a ship type, its modules and the skills flying it.
+ *
+ * @author EVEmu Team
+ */
+struct FittingSpec
+{
+    /**
+     * @brief A fitted module.
+     */
+    struct Module
+    {
+        Module() : typeID( 0 ), chargeTypeID( 0 ), online( true ), overloaded( false ) {}
+
+        uint32 typeID;
+        /// Type of the loaded charge; 0 if none.
+        uint32 chargeTypeID;
+        bool online;
+        bool overloaded;
+    };
+
+    FittingSpec() : shipTypeID( 0 ) {}
+
+    /** @return Hash of the fitting, by which the results are memoized. */
+    uint64 GetHash() const;
+
+    bool operator==( const FittingSpec& oth ) const;
+
+    uint32 shipTypeID;
+    /// The modules; the attributes of the result are in the same order.
+    std::vector< Module > modules;
+    /// Trained skills, typeID -> level.
+    std::map< uint32, uint8 > skills;
+};
+
+/**
+ * @brief Computed attributes of a fitting.
+ *
+ * Never changes once built, so every user of the same fitting
+ * shares one.
+ *
+ * @author EVEmu Team
+ */
+class FittingSnapshot
+: public RefObject
+{
+    friend class FittingEvaluator;
+
+public:
+    /// Attributes of an item, sorted by attributeID.
+    typedef std::vector< std::pair< uint32, double > > AttributeList;
+
+    FittingSnapshot() : RefObject( 0 ) {}
+
+    /** @return Attributes of the ship. */
+    const AttributeList& shipAttributes() const { return mShip; }
+    /** @return Number of the modules. */
+    uint32 GetModuleCount() const { return mModules.size(); }
+    /** @return Attributes of the module at index. */
+    const AttributeList& moduleAttributes( uint32 index ) const { return mModules[ index ]; }
+    /** @return Attributes of the charge of the module at index; empty if none. */
+    const AttributeList& chargeAttributes( uint32 index ) const { return mCharges[ index ]; }
+
+    /**
+     * @brief Looks up an attribute of the ship.
+     *
+     * @param[in]  attributeID ID of the attribute.
+     * @param[out] into        The value.
+     *
+     * @return True if found, false if the ship does not have the attribute.
+     */
+    bool GetShipAttribute( uint32 attributeID, double& into ) const { return Find( mShip, attributeID, into ); }
+    /**
+     * @brief Looks up an attribute of a module.
+     *
+     * @param[in]  index       Index of the module.
+     * @param[in]  attributeID ID of the attribute.
+     * @param[out] into        The value.
+     *
+     * @return True if found, false if the module does not have the attribute.
+     */
+    bool GetModuleAttribute( uint32 index, uint32 attributeID, double& into ) const { return Find( mModules[ index ], attributeID, into ); }
+
+    /**
+     * @brief Looks up an attribute in a list.
+     *
+     * @param[in]  attributes  The list.
+     * @param[in]  attributeID ID of the attribute.
+     * @param[out] into        The value.
+     *
+     * @return True if found, false if it is not in the list.
+     */
+    static bool Find( const AttributeList& attributes, uint32 attributeID, double& into );
+
+protected:
+    AttributeList mShip;
+    std::vector< AttributeList > mModules;
+    std::vector< AttributeList > mCharges;
+};
+
+typedef RefPtr< const FittingSnapshot > FittingSnapshotRef;
+
+/**
+ * @brief Computes the attributes of fittings without any items.
+ *
+ * The base values come from sDgmTypeAttrMgr and the modifiers
+ * from the compiled effects of sDGM_Effects_Table, run into a
+ * ModifierGraph of its own, just like ModuleManager does for
+ * a real ship; so the fitting window, saved fittings and NPC
+ * loadouts get their numbers without moving any items or
+ * touching the database. The results are memoized by the hash
+ * of the fitting; the least recently used ones are dropped
+ * above the capacity.
+ *
+ * Skills, the ship and offline modules apply their persistent
+ * effects; the attributes of a skill are taken per level
+ * trained. Modules online apply their online effects and
+ * overloaded ones their overload effects, as in ModuleManager.
+ *
+ * Must be used by the game thread only.
+ *
+ * @author EVEmu Team
+ */
+class FittingEvaluator
+: public Singleton< FittingEvaluator >
+{
+public:
+    /**
+     * @brief Statistics of the evaluator.
+     */
+    struct Stats
+    {
+        Stats() { Reset(); }
+
+        void Reset()
+        {
+            hits = 0;
+            evaluations = 0;
+            evictions = 0;
+            evaluateTime = 0;
+        }
+
+        /// Number of fittings served from the cache.
+        uint32 hits;
+        /// Number of fittings computed.
+        uint32 evaluations;
+        /// Number of results dropped over the capacity.
+        uint32 evictions;
+        /// Time (in microseconds) spent computing.
+        uint64 evaluateTime;
+    };
+
+    FittingEvaluator();
+
+    /** @return Number of memoized results. */
+    size_t size() const { return mCache.size(); }
+    /** @return Statistics since the last ResetStats(). */
+    const Stats& stats() const { return mStats; }
+
+    /**
+     * @brief Sets the most results kept.
+     *
+     * @param[in] capacity The capacity; 0 disables memoizing.
+     */
+    void SetCapacity( size_t capacity );
+
+    /**
+     * @brief Obtains the attributes of a fitting.
+     *
+     * @param[in] spec The fitting.
+     *
+     * @return The attributes; NULL if the ship type has no attributes.
+     */
+    FittingSnapshotRef Evaluate( const FittingSpec& spec );
+
+    /**
+     * @brief Drops all results, e.g. after the static data changed.
+     */
+    void Clear();
+    /**
+     * @brief Resets the statistics.
+     */
+    void ResetStats() { mStats.Reset(); }
+
+protected:
+    /**
+     * @brief A memoized result.
+     */
+    struct Entry
+    {
+        FittingSpec spec;
+        FittingSnapshotRef snapshot;
+        /// Position in mOrder.
+        std::list< uint64 >::iterator order;
+    };
+
+    FittingSnapshot* _Compute( const FittingSpec& spec ) const;
+    void _Trim();
+
+    /// The most results kept.
+    size_t mCapacity;
+    /// Results by hash of their fitting.
+    std::tr1::unordered_map< uint64, Entry > mCache;
+    /// Hashes of mCache, least recently used first.
+    std::list< uint64 > mOrder;
+
+    /// Statistics.
+    Stats mStats;
+};
+
+/// A macro for easier access to the singleton.
+#define sFittingEvaluator \
+    ( FittingEvaluator::get() )
+
+#endif /* !__FITTING_EVALUATOR_H__INCL__ */
@@ -0,0 +1,274 @@
+/*
+    ------------------------------------------------------------------------------------
+    LICENSE:
+    ------------------------------------------------------------------------------------
+    This file is part of EVEmu: EVE Online Server Emulator
+    Copyright 2006 - 2011 The EVEmu Team
+    For the latest information visit http://evemu.org
+    ------------------------------------------------------------------------------------
+    This program is free software; you can redistribute it and/or modify it under
+    the terms of the GNU Lesser General Public License as published by the Free Software
+    Foundation; either version 2 of the License, or (at your option) any later
+    version.
+
+    This program is distributed in the hope that it will be useful, but WITHOUT
+    ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+    FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public License along with
+    this program; if not, write to the Free Software Foundation, Inc., 59 Temple
+    Place - Suite 330, Boston, MA 02111-1307, USA, or go to
+    http://www.gnu.org/copyleft/lesser.txt.
+    ------------------------------------------------------------------------------------
+    Author:     EVEmu Team
+*/
+
+
+#ifndef __SHIP__FLEET_MANAGER_H__INCL__
+#define __SHIP__FLEET_MANAGER_H__INCL__
+
+#include "utils/Singleton.h"
+
+/**
+ * @brief Resident fleets: their hierarchy, broadcasts and fleet warps.
+ *
+ * Every fleet is a tree kept in memory: the fleet commander, up to
+ * MAX_WINGS wings with a wing commander each, and up to MAX_SQUADS
+ * squads per wing with up to MAX_SQUAD_MEMBERS members each. Every
+ * member is indexed by characterID, so the position of a member and
+ * the members of its squad, wing or fleet are found without touching
+ * the database.
+ *
+ * A broadcast is encoded once and the same payload is sent to every
+ * online member of the scope.
+ *
+ * Fleet warps are queued with a target which the commander computed
+ * once; Process() issues the warps of all the members of the scope
+ * which are in space in the commander's solar system within the same
+ * tick, so they leave together.
+ *
+ * Fleets are not persisted; a fleet is disbanded when its last member
+ * leaves.
+ *
+ * Not thread-safe; meant to be used from the main loop.
+ *
+ * @author EVEmu Team
+ */
+class FleetManager
+: public Singleton< FleetManager >
+{
+public:
+    static const size_t MAX_WINGS = 5;
+    static const size_t MAX_SQUADS = 5;
+    static const size_t MAX_SQUAD_MEMBERS = 10;
+
+    enum FleetRole
+    {
+        ROLE_NONE = 0,
+        ROLE_FLEET_COMMANDER = 1,
+        ROLE_WING_COMMANDER = 2,
+        ROLE_SQUAD_COMMANDER = 3,
+        ROLE_MEMBER = 4
+    };
+
+    /// Whom a broadcast or a fleet warp is sent to, relative to its sender.
+    enum FleetScope
+    {
+        SCOPE_SQUAD,
+        SCOPE_WING,
+        SCOPE_FLEET
+    };
+
+    /**
+     * @brief Statistics of the fleets.
+     */
+    struct Stats
+    {
+        Stats() { Reset(); }
+
+        void Reset()
+        {
+            joins = 0;
+            leaves = 0;
+            broadcasts = 0;
+            broadcastRecipients = 0;
+            fleetWarps = 0;
+            warps = 0;
+        }
+
+        /// Number of members which joined a fleet.
+        uint32 joins;
+        /// Number of members which left a fleet.
+        uint32 leaves;
+        /// Number of broadcasts sent.
+        uint32 broadcasts;
+        /// Number of members they were sent to.
+        uint32 broadcastRecipients;
+        /// Number of fleet warps issued.
+        uint32 fleetWarps;
+        /// Number of members they warped.
+        uint32 warps;
+    };
+
+    FleetManager();
+
+    /** @return Number of fleets. */
+    size_t size() const { return mFleets.size(); }
+    /** @return Number of members of all the fleets. */
+    size_t GetMemberCount() const { return mMembers.size(); }
+    /** @return Statistics since the last ResetStats(). */
+    const Stats& stats() const { return mStats; }
+    /** @brief Resets the statistics. */
+    void ResetStats() { mStats.Reset(); }
+
+    /**
+     * @brief Issues the queued fleet warps.
+     */
+    void Process();
+
+    /**
+     * @brief Creates a fleet with one wing and one squad.
+     *
+     * @param[in] commanderID The character which becomes the fleet commander.
+     *
+     * @return fleetID of the fleet; 0 if the character already is in a fleet.
+     */
+    uint32 CreateFleet( uint32 commanderID );
+    /**
+     * @return wingID of the new wing; 0 if the fleet does not exist or has MAX_WINGS wings.
+     */
+    uint32 CreateWing( uint32 fleetID );
+    /**
+     * @return squadID of the new squad; 0 if the wing does not exist or has MAX_SQUADS squads.
+     */
+    uint32 CreateSquad( uint32 wingID );
+
+    /**
+     * @brief Adds a character to the first squad of a fleet which has room.
+     *
+     * @return True on success, false if the character already is in a fleet or the fleet is full.
+     */
+    bool AddMember( uint32 fleetID, uint32 characterID );
+    /**
+     * @brief Moves a member within its fleet.
+     *
+     * @param[in] characterID The member.
+     * @param[in] wingID      The wing; 0 for the fleet commander.
+     * @param[in] squadID     The squad; 0 for the commander of the wing.
+     * @param[in] role        ROLE_SQUAD_COMMANDER or ROLE_MEMBER within a squad.
+     *
+     * @return True on success, false if the position is taken, full or not of the fleet.
+     */
+    bool MoveMember( uint32 characterID, uint32 wingID, uint32 squadID, FleetRole role = ROLE_MEMBER );
+    /**
+     * @brief Removes a member from its fleet, disbanding the fleet if it was the last one.
+     *
+     * @param[in] characterID   The member.
+     * @param[in] updateSession Whether to clear the fleet of its session; false if it is logging out.
+     */
+    void RemoveMember( uint32 characterID, bool updateSession = true );
+
+    /** @return fleetID of the fleet of the character; 0 if none. */
+    uint32 GetFleetID( uint32 characterID ) const;
+    /** @return Number of members of the fleet. */
+    size_t GetFleetSize( uint32 fleetID ) const;
+
+    /**
+     * @brief Sends an OnFleetBroadcast to the online members of the sender's scope.
+     *
+     * @param[in] senderID The member which broadcasts.
+     * @param[in] scope    Whom to broadcast to.
+     * @param[in] name     Name of the broadcast.
+     * @param[in] itemID   The item the broadcast is about.
+     *
+     * @return Number of members the broadcast was sent to.
+     */
+    size_t Broadcast( uint32 senderID, FleetScope scope, const std::string& name, uint32 itemID );
+    /**
+     * @brief Queues a fleet warp, issued by the next Process().
+     *
+     * @param[in] commanderID The member which warps its scope.
+     * @param[in] scope       Whom to warp.
+     * @param[in] to          The warp-in point, shared by all the members.
+     * @param[in] distance    The distance to warp to.
+     *
+     * @return False if the commander is not in a fleet.
+     */
+    bool WarpFleet( uint32 commanderID, FleetScope scope, const GPoint& to, double distance );
+
+protected:
+    struct Member
+    {
+        uint32 fleetID;
+        uint32 wingID;
+        uint32 squadID;
+        uint8 role;
+    };
+
+    struct Squad
+    {
+        uint32 wingID;
+        std::vector<uint32> members;
+    };
+
+    struct Wing
+    {
+        uint32 fleetID;
+        uint32 commanderID;
+        std::vector<uint32> squads;
+    };
+
+    struct Fleet
+    {
+        uint32 commanderID;
+        std::vector<uint32> wings;
+        size_t memberCount;
+    };
+
+    struct PendingWarp
+    {
+        uint32 commanderID;
+        uint8 scope;
+        GPoint to;
+        double distance;
+    };
+
+    /**
+     * @brief Collects the members of the scope of a member.
+     */
+    void _GetScope( const Member& member, FleetScope scope, std::vector<uint32>& into ) const;
+    void _GetSquad( uint32 squadID, std::vector<uint32>& into ) const;
+    void _GetWing( uint32 wingID, std::vector<uint32>& into ) const;
+
+    /**
+     * @brief Takes a member out of its position, keeping it in the fleet.
+     */
+    void _Unplace( uint32 characterID, const Member& member );
+    /**
+     * @brief Pushes the fleet position of a member to its session.
+     */
+    void _UpdateSession( uint32 characterID, const Member* member );
+
+    void _DisbandFleet( uint32 fleetID );
+
+    /// The next fleetID, wingID and squadID.
+    uint32 mNextID;
+
+    std::tr1::unordered_map<uint32, Fleet> mFleets;
+    std::tr1::unordered_map<uint32, Wing> mWings;
+    std::tr1::unordered_map<uint32, Squad> mSquads;
+    /// Positions of the members, by characterID.
+    std::tr1::unordered_map<uint32, Member> mMembers;
+
+    /// Fleet warps to issue in the next Process().
+    std::vector<PendingWarp> mWarps;
+
+    /// Statistics.
+    Stats mStats;
+};
+
+/// A macro for easier access to the singleton.
+#define sFleetManager \
+    ( FleetManager::get() )
+
+#endif /* !__SHIP__FLEET_MANAGER_H__INCL__ */
@@ -42,34 +42,29 @@ class ModuleManager;
 //
 // --- Explanation of all this confusing crap in here:
 //
-// We need a map of maps to store modifiers from activated effects of modules, skills, ships, implants, subsystems, rigs, etc
-// So, what we've done here is to create a std::map<uint32 attributeID, ModifierMap>  This contains a ModifierMap class object
-// for each attributeID added to this outer map.  For each attribute that is modified by one or more originators (module, rig,
-// ship, skill, implant, etc), an inner map is created and added to this outer map.  The ModifierMap class contains this inner map,
-// which is actually a std::multimap<double modifierValue, Modifier modifierObject>  The reason we use a multimap here is that
-// a multimap allows multiple key values that are exactly the same, which you'll get if you fit more than one module of the exact
-// same type.  The modifier value is used as the key since we need the list of all modifiers for a single attributeID to be sorted
-// largest modifier value to smallest to zero to smaller negative modifier values to largest negative modifier value.  This sort
-// is needed in order to properly apply stacking penalties.  The stacking penalties as explained here http://wiki.eveuniversity.org/Eve_math
-// indicate that the largest modifier value does not get penalized, but the 2nd largest on down get increasingly larger penalties applied.
-// The penalties will NOT be applied into the Modifier class objects, but only when the ModuleManager class methods process these modifiers
-// onto the attributes AFTER any Module class objects are called to change state and apply either new or updated modifiers into
-// these Modifier Maps.
+// We need to store modifiers from activated effects of modules, skills, ships, implants, subsystems, rigs, etc, and recompute
+// the attributes they modify.  All of them go into a single ModifierGraph (see utils/ModifierGraph.h): every modified
+// attribute of an item is a node, and every modifier is an edge into the attribute it modifies.  When a module changes state
+// and adds, updates or removes its modifiers, only the attributes downstream of those modifiers are marked; the ModuleManager
+// then recomputes just those and pushes the changed values into the ship and module items.
 //
-// Each Module class object will make the public calls to the ModuleManager to add Modifiers to the Modifier Map for a particular
-// attributeID, so let's talk about these classes.
+// Stacking penalties as explained here http://wiki.eveuniversity.org/Eve_math indicate that the largest modifier value does
+// not get penalized, but the 2nd largest on down get increasingly larger penalties applied.  The graph sorts the penalized
+// modifiers of an attribute and takes their penalties from a precomputed table.  The penalties will NOT be applied into the
+// Modifier class objects, but only when the attributes are recomputed AFTER any Module class objects are called to change
+// state and apply either new or updated modifiers.
+//
+// Each Module class object will make the public calls to the ModuleManager to add Modifiers for a particular attributeID,
+// so let's talk about these classes.
 //
 // The Modifier class just contains basic information on a single modifier value inserted by an 'originator', some source of the
-// modifier value (module, skill, ship, implant, rig, subsystem, etc).  Every Modifier class object created by an originator
-// is inserted into a ModifierMapType, which is a std::multimap<double modifierValue, ModifierRef modifierRef> structure.  It is
-// a std::multimap<> with double as key value, which are the modifier values themselves so that the multimap can sort the pairs
-// according to the values of the modifier values.
+// modifier value (module, skill, ship, implant, rig, subsystem, etc).  A Modifier is identified by its originatorID, its target
+// item and the attributeID it modifies; applying it again updates the value already in the graph, and removing it simply takes
+// it out of the graph, so there is no need to reverse the calculation.
 //
-// Each of these ModifierMapType structures are inserted into one of a handful of ModifierMaps structures, each of which are
-// std::map<uint32 attributeID, ModifierMap * modifierMap>  Each pair is keyed to the attributeID for the attribute that will
-// be modified by the list of modifier values stored in the ModifierMap object.  There are multiple ModifierMaps objects in the
-// ModuleManager class, one for Subsystems, one for Ships and Skills, one for Modules and Rigs, one for Implants, and one for
-// Remotely applied modifiers from external hostile entities.
+// The separate Apply/Remove methods for Subsystems, Ships and Skills, Modules and Rigs, Implants, and Remotely applied modifiers
+// from external hostile entities are kept for the callers; the order the modifiers are applied in is given by their calculation
+// types, not by where they came from.
 //
 // More to follow, and this will be copied to http://wiki.evemu.org
 //
@@ -103,6 +98,10 @@ public:
     double GetModifierValue() { return m_ModifierValue; }
     void SetModifierValue(double newModifierValue) { m_ModifierValue = newModifierValue; }
     uint32 GetOriginatorID() { return m_OriginatorID; }
+    uint32 GetTargetAttributeID() { return m_TargetAttributeID; }
+    uint32 GetTargetID() { return m_TargetID; }
+    bool GetPenaltiesApply() { return m_bPenaltiesApply; }
+    uint32 GetCalculationTypeID() { return m_CalculationTypeID; }
 
 protected:
     uint32 m_OriginatorID;
@@ -116,20 +115,6 @@ protected:
 
 typedef RefPtr<Modifier> ModifierRef;
 
-typedef std::multimap<double, ModifierRef> ModifierMapType;     // The ModifierRef is NOT owned by the owner of instances of this type
-
-class ModifierMap
-{
-public:
-    ModifierMap() { m_MapIsDirty = false; }
-    ~ModifierMap();
-
-    bool m_MapIsDirty;
-    ModifierMapType m_ModifierMap;   // Key= modifier value, Value= Modifier class object containing all data describing this modifier for this attribute
-};
-
-typedef std::map<uint32, ModifierMap *> ModifierMaps;   // Key= attributeID, Value= ModifierMap class object containing a map of all modifiers for this attribute
-
 #pragma endregion
 /////////////////////////////// END MODIFIER /////////////////////////////////////
 
@@ -394,6 +379,13 @@ private:
 
     ModuleCommand _translateEffectName(std::string s);
 
+    int32 _ApplyModifier(uint32 attributeID, uint32 originatorID, ModifierRef modifierRef);
+    int32 _RemoveModifier(uint32 attributeID, uint32 originatorID, ModifierRef modifierRef);
+    InventoryItem * _GetModifierTarget(uint32 itemID);
+    void _ApplyEffects(GenericModule * mod, ModuleEffectTriggers state);      // runs the compiled effects of the module's type for this state
+    void _RemoveEffects(GenericModule * mod, ModuleEffectTriggers state);
+    void _ApplyAllOnlineEffects(bool apply);
+    void _UpdateModifiedAttributes();     // pushes the recomputed attributes into the ship and the modules
 
     void _SendInfoMessage(const char* fmt, ...);
     void _SendErrorMessage(const char* fmt, ...);
@@ -407,12 +399,8 @@ private:
     //modules storage, we own this
     ModuleContainer * m_Modules;                    // Holds Module class objects in container arrays, one for each slot bank, rig, subsystem
 
-    //modifier maps, we own these
-    ModifierMaps * m_LocalSubsystemModifierMaps;    // Holds std::map<> maps of Modifiers for attributes applied by SUBSYSTEMS
-    ModifierMaps * m_LocalShipSkillModifierMaps;    // Holds std::map<> maps of Modifiers for attributes applied by SHIPS and SKILLS
-    ModifierMaps * m_LocalModuleRigModifierMaps;    // Holds std::map<> maps of Modifiers for attributes applied by MODULES and RIGS
-    ModifierMaps * m_LocalImplantModifierMaps;      // Holds std::map<> maps of Modifiers for attributes applied by IMPLANTS
-    ModifierMaps * m_RemoteModifierMaps;            // Holds std::map<> maps of Modifiers for attributes applied by EXTERNAL ENTITY MODULES
+    //modifiers applied by SUBSYSTEMS, SHIPS, SKILLS, MODULES, RIGS, IMPLANTS and EXTERNAL ENTITY MODULES
+    ModifierGraph m_Modifiers;
 };
 
 #pragma endregion
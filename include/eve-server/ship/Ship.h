@@ -180,6 +180,10 @@ public:
      * @return Pointer to new Ship object; NULL if failed.
      */
     static ShipRef Spawn(ItemFactory &factory, ItemData &data);
+    /**
+     * Creates the default dynamic attributes of a ship which has just been spawned.
+     */
+    void SetSpawnAttributes();
 
     /*
      * Primary public interface:
@@ -237,6 +241,29 @@ public:
     ShipOperatorInterface * GetOperator() { return m_pOperator; }
     std::vector<GenericModule *> GetStackedItems(uint32 typeID, ModulePowerLevel level);
 
+    /*
+     * Capacitor and shield recharge:
+     *
+     * The levels are computed on demand from the last change (see RechargeState),
+     * AttrCharge and AttrShieldCharge are only written when they are changed
+     * from outside, when they become full and when the ship is saved.
+     */
+    double GetCapacitorCharge() const;
+    /**
+     * @brief Takes @a amount from the capacitor.
+     *
+     * @return True if done, false if there is not enough left.
+     */
+    bool UseCapacitor(double amount);
+    /** @return Time (in milliseconds) until the capacitor holds @a amount; 0xFFFFFFFF if never. */
+    uint32 GetTimeToCapacitor(double amount) const;
+    double GetShieldCharge() const;
+    void SetShieldCharge(double charge);
+    /** Picks up changed capacities and recharge times, keeping the current levels. */
+    void UpdateRecharge();
+    /** Writes the current levels into AttrCharge and AttrShieldCharge. */
+    void StoreRecharge();
+
     // External Methods For use by hostile entities directing effects to this entity:
     int32 ApplyRemoteEffect() { assert(true); }     // DO NOT CALL THIS YET!!!  This function needs to call down to ModuleManager::RemoveRemoteEffect with the proper argument list.
     int32 RemoveRemoteEffect() { assert(true); }    // DO NOT CALL THIS YET!!!  This function needs to call down to ModuleManager::RemoveRemoteEffect with the proper argument list.
@@ -301,6 +328,15 @@ private:
 
     //the ship's module manager.  We own this
     ModuleManager * m_ModuleManager;
+
+    void _InitRecharge();
+    void _RechargeTimerExpired();
+    void _ScheduleRechargeTimer();
+
+    RechargeState m_capacitor;
+    RechargeState m_shield;
+    //fires when the capacitor or the shield become full.
+    TimerWheelMember<Ship, &Ship::_RechargeTimerExpired> m_rechargeTimer;
 };
 
 /**
@@ -372,6 +408,8 @@ protected:
     void _ReduceDamage(Damage &d);
     void ApplyDamageModifiers(Damage &d, SystemEntity *target);
     void _DropLoot(SystemEntity *owner);
+    virtual double _GetShieldCharge() const;
+    virtual void _SetShieldCharge(double charge);
 
     /*
      * Member fields:
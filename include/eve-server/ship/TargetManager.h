@@ -40,14 +40,16 @@ public:
 
     void DoDestruction();
 
-    void Process();
-
     //clear out our targeting information (incoming and outgoing)
     void ClearTargets(bool notify_self=true);
     void ClearTarget(SystemEntity *who);
     bool StartTargeting(SystemEntity *who, uint32 lock_time);
     void ClearAllTargets(bool notify_self=true);
 
+    //range checks:
+    double GetMaxTargetRange() const;
+    bool IsInTargetRange(const SystemEntity *who) const;
+
     //Methods for AI:
     SystemEntity *GetFirstTarget(bool need_locked);
     bool HasNoTargets() const { return(m_targets.empty()); }
@@ -76,6 +78,9 @@ protected:
     void TargetedByLost(SystemEntity *from_who);
 
 
+    //the entries are kept inline in small vectors; there are only a few
+    //targets, and even a structure targeted by dozens of pilots is searched
+    //faster linearly than through a map of heap nodes.
     class TargetedByEntry {
     public:
         TargetedByEntry(SystemEntity *_who)
@@ -88,13 +93,13 @@ protected:
             Locking,
             Locked
         } state;
-        SystemEntity *const who;
+        SystemEntity *who;
     };
 
     class TargetEntry {
     public:
         TargetEntry(SystemEntity *_who)
-            : state(Idle), who(_who), timer(0) {}
+            : state(Idle), who(_who), lockExpiry(0) {}
 
         void Dump() const;
 
@@ -104,14 +109,22 @@ protected:
             Locking,
             Locked
         } state;
-        SystemEntity *const who;
-        Timer timer;
+        SystemEntity *who;
+        uint32 lockExpiry;    //timer wheel time the lock completes at, if Locking.
     };
 
+    std::vector<TargetEntry>::iterator _FindTarget(SystemEntity *who);
+    std::vector<TargetedByEntry>::iterator _FindTargetedBy(SystemEntity *who);
+
+    //completes the locks which are due and schedules the next one.
+    void _LockTimerExpired();
+    void _ScheduleLockTimer();
+
     bool m_destroyed;    //true if we have already taken care of destruction logic.
     SystemEntity *const m_self;    //we do not own this.
-    std::map<SystemEntity *, TargetedByEntry *> m_targetedBy;    //we own these values, not the keys
-    std::map<SystemEntity *, TargetEntry *> m_targets;    //we own these values, not the keys
+    std::vector<TargetedByEntry> m_targetedBy;
+    std::vector<TargetEntry> m_targets;
+    TimerWheelMember<TargetManager, &TargetManager::_LockTimerExpired> m_lockTimer;
 };
 
 
@@ -28,6 +28,8 @@
 
 #include "utils/EvilNumber.h"
 
+class DBSnapshot;
+
 
 
 /**
@@ -35,41 +37,13 @@
  * The main idea is that we need to cache most of the important db tables and DgmTypeAttributeInfo is one of them.
  * This file contains all the required parts to make this happen for this table. Its not perfect but its good enough
  * for now.
- * The dgmtypeattributemgr loads the data from the db on startup and puts them into DgmTypeAttributeSets. Those
- * sets are comparable to db query results, you iterate trough the result using begin() and end() iterators like
- * we would use normal std systems.
+ * The dgmtypeattributemgr loads the data from the db on startup and puts them into a read-only TypeAttributeTable.
+ * The attributes of a type are then returned as a DgmTypeAttributeSet, which is comparable to a db query result:
+ * you iterate trough it by index, from 0 to size().
  */
 
-// this represents 1 attribute modifier
-#pragma pack(push,1)
-class DmgTypeAttribute
-{
-public:
-    uint16 attributeID;
-    EvilNumber number;
-};
-#pragma pack(pop)
-
-
-// this represents a collection of attribute modifiers for a single typeID
-class DgmTypeAttributeSet
-{
-public:
-    ~DgmTypeAttributeSet();
-
-    // a set is a collection of pointers...
-    typedef std::list<DmgTypeAttribute *> AttrSet;
-    typedef AttrSet::iterator AttrSetItr;
-
-    // wrap these functions so its cleaner..
-    AttrSetItr begin() {return attributeset.begin();}
-    AttrSetItr end() {return attributeset.end();}
-
-    AttrSet attributeset;
-};
-
-typedef std::map<uint32, DgmTypeAttributeSet*>  DgmTypeAttributeMap;
-typedef DgmTypeAttributeMap::iterator           DgmTypeAttributeMapItr;
+// this represents the attribute modifiers of a single typeID
+typedef TypeAttributeTable::Range DgmTypeAttributeSet;
 
 // class that does all the magic of caching the info
 /**
@@ -83,12 +57,28 @@ typedef DgmTypeAttributeMap::iterator           DgmTypeAttributeMapItr;
 class dgmtypeattributemgr
 {
 public:
-    dgmtypeattributemgr(); // also do init stuff, db loading
-    ~dgmtypeattributemgr();
-
-    DgmTypeAttributeSet* GetDmgTypeAttributeSet(uint32 typeID);
+    /**
+     * @param[in] snapshot Static data snapshot to load the attributes from;
+     *                     if NULL or it has no attributes, they are queried.
+     */
+    dgmtypeattributemgr(const DBSnapshot* snapshot = NULL); // also do init stuff, db loading
+
+    /**
+     * Gets the attributes of a type.
+     *
+     * @param[in] typeID ID of the type.
+     * @param[out] into The attributes; valid as long as the manager.
+     * @return True if found, false if the type has no attributes.
+     */
+    bool GetDmgTypeAttributeSet(uint32 typeID, DgmTypeAttributeSet& into) const;
 private:
-    DgmTypeAttributeMap mDgmTypeAttrInfo;
+    // adds a row of (typeID, attributeID, valueInt, valueFloat)
+    template<typename Row>
+    void _AddRow(const Row& row);
+    bool _LoadSnapshot(const DBSnapshot& snapshot);
+    bool _LoadDatabase();
+
+    TypeAttributeTable mDgmTypeAttrInfo;
 };
 
 extern dgmtypeattributemgr * _sDgmTypeAttrMgr;
@@ -33,6 +33,26 @@
 class ActiveModule : public GenericModule
 {
 public:
+    // cycle instrumentation over all active modules
+    struct CycleStats
+    {
+        CycleStats() { Reset(); }
+
+        void Reset()
+        {
+            activations = 0;
+            cycles = 0;
+            groupCycles.clear();
+        }
+
+        // number of modules activated
+        uint32 activations;
+        // number of cycles started
+        uint32 cycles;
+        // cycles started per module groupID
+        std::map<uint32, uint32> groupCycles;
+    };
+
     ActiveModule(InventoryItemRef item, ShipRef ship);
     ~ActiveModule();
 
@@ -45,25 +65,35 @@ public:
     //access functions
     ModulePowerLevel GetModulePowerLevel()                    { return isHighPower() ? MODULE_BANK_HIGH_POWER : ( isMediumPower() ? MODULE_BANK_MEDIUM_POWER : MODULE_BANK_LOW_POWER); }
 
-    bool isHighPower()                                        { return m_Effects->isHighSlot(); }
-    bool isMediumPower()                                    { return m_Effects->isMediumSlot(); }
-    bool isLowPower()                                        { return m_Effects->isLowSlot(); }
+    bool isHighPower()                                        { return m_Type->isHighSlot(); }
+    bool isMediumPower()                                    { return m_Type->isMediumSlot(); }
+    bool isLowPower()                                        { return m_Type->isLowSlot(); }
     bool isRig()                                            { return false; }
     bool isSubSystem()                                        { return false; }
-    bool requiresTarget()
-    {
-        if( m_Effects->HasDefaultEffect() )
-            return m_Effects->GetDefaultEffect()->GetIsAssistance() || m_Effects->GetDefaultEffect()->GetIsOffensive();
-        else
-            return false;
-    }
+    bool requiresTarget()                                    { return m_Type->requiresTarget(); }
+
+    static const CycleStats& cycleStats()                    { return s_cycleStats; }
+    static void ResetCycleStats()                            { s_cycleStats.Reset(); }
 
 protected:
+    // length of one cycle in ms, taken from the duration attribute of the default effect; 0 if none
+    uint32 _GetCycleDuration();
+    // starts the next cycle and schedules its end
+    void _StartCycle();
+    // the running cycle has ended; starts the next one unless we've been told to stop
+    void _CycleTimerExpired();
+
     ModifyShipAttributesComponent * m_ShipAttrComp;
+    ActiveModuleProcessingComponent * m_ActiveModuleProcComp;
     uint32 targetID;  //passed to us by activate
 
+    // fires at the end of each cycle; idle modules are simply not scheduled
+    TimerWheelMember<ActiveModule, &ActiveModule::_CycleTimerExpired> m_cycleTimer;
+
+    static CycleStats s_cycleStats;
+
     //inheritance crap
-    ActiveModule() {}
+    ActiveModule() : m_ShipAttrComp( NULL ), m_ActiveModuleProcComp( NULL ), targetID( 0 ), m_cycleTimer( *this ) {}
 };
 
 
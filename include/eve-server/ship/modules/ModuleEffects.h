@@ -30,8 +30,34 @@
 #include "ship/modules/ModuleDefs.h"
 #include "utils/Singleton.h"
 
+// ////////////////////// Compiled Effects ////////////////////////////
+
+// Values of the 'operation' of an EffectInstruction:
+enum EffectInstructionOperations
+{
+    EFFECT_OPERATION_NONE = 0xFF    // the calculation type cannot take its value from an attribute; the instruction does nothing
+};
+
+// A single modifier of an effect, compiled at load from the 'dgmEffectsInfo' and 'dgmEffectsActions' rows of the effect,
+// so modules run an array of these without any lookups:
+struct EffectInstruction
+{
+    uint16 effectID;
+    uint16 targetAttributeID;
+    uint16 sourceAttributeID;
+    uint8 calculation;              // EVECalculationType, less CALC_NONE
+    uint8 reverseCalculation;       // EVECalculationType, less CALC_NONE
+    uint8 operation;                // ModifierGraph::Operation doing the calculation, or EFFECT_OPERATION_NONE
+    uint8 target;                   // ModuleEffectTargets, less EFFECT_TARGET_SELF
+    uint8 penalized;                // 1 if stacking penalties apply
+};
+
+typedef std::vector<EffectInstruction> EffectProgram;
+
 
 // ////////////////////// Effects Classs ////////////////////////////
+class TypeEffects;
+
 class MEffect
 {
 public:
@@ -68,11 +94,14 @@ public:
     uint32 GetFittingUsageChanceAttributeID()                    { return (m_EffectID == 0) ? 0 : m_FittingUsageChanceAttributeID; }
 
     //accessors for the effects targetAttributeID, sourceAttributeID and calculation type:
-    uint32 GetSizeOfAttributeList()                                { return (m_EffectID == 0) ? 0 : m_numOfIDs; }
-    uint32 GetTargetAttributeID(uint32 index)                    { return (m_EffectID == 0) ? 0 : m_TargetAttributeIDs[index]; }
-    uint32 GetSourceAttributeID(uint32 index)                    { return (m_EffectID == 0) ? 0 : m_SourceAttributeIDs[index]; }
-    EVECalculationType GetCalculationType(uint32 index)            { return (m_EffectID == 0) ? (EVECalculationType)0 : (EVECalculationType)m_CalculationTypeIDs[index];}
-    EVECalculationType GetReverseCalculationType(uint32 index)    { return (m_EffectID == 0) ? (EVECalculationType)0 : (EVECalculationType)m_ReverseCalculationTypeIDs[index];}
+    uint32 GetSizeOfAttributeList()                                { return (m_EffectID == 0) ? 0 : m_Program.size(); }
+    uint32 GetTargetAttributeID(uint32 index)                    { return (m_EffectID == 0) ? 0 : m_Program[index].targetAttributeID; }
+    uint32 GetSourceAttributeID(uint32 index)                    { return (m_EffectID == 0) ? 0 : m_Program[index].sourceAttributeID; }
+    EVECalculationType GetCalculationType(uint32 index)            { return (m_EffectID == 0) ? (EVECalculationType)0 : (EVECalculationType)(CALC_NONE + m_Program[index].calculation);}
+    EVECalculationType GetReverseCalculationType(uint32 index)    { return (m_EffectID == 0) ? (EVECalculationType)0 : (EVECalculationType)(CALC_NONE + m_Program[index].reverseCalculation);}
+
+    //the compiled modifiers, one for each of the attribute list
+    const EffectProgram & GetProgram() const                    { return m_Program; }
 
     uint32 GetModuleStateWhenEffectApplied(uint32 index)        { return (m_EffectID == 0) ? 0 : m_EffectAppliedWhenID; }
     uint32 GetTargetTypeToWhichEffectApplied(uint32 index)        { return (m_EffectID == 0) ? 0 : m_EffectAppliedTargetID; }
@@ -83,6 +112,7 @@ public:
 
 private:
     void _Populate(uint32 effectID);
+    void _Compile(const std::vector<int> & infoRows);
 
     int m_EffectID;
     std::string m_EffectName;
@@ -112,11 +142,7 @@ private:
     int m_NpcActivationChanceAttributeID;
     int m_FittingUsageChanceAttributeID;
 
-    int m_numOfIDs;
-    int * m_TargetAttributeIDs;
-    int * m_SourceAttributeIDs;
-    int * m_CalculationTypeIDs;
-    int * m_ReverseCalculationTypeIDs;
+    EffectProgram m_Program;
     int m_EffectAppliedWhenID;
     int m_EffectAppliedTargetID;
     int m_EffectAppliedBehaviorID;
@@ -129,6 +155,40 @@ private:
 };
 
 
+// ////////////////////// TypeEffects Class ////////////////////////////
+
+//all effects of a single typeID, sorted by the module state in which they apply, with their compiled modifiers
+//concatenated per state; it never changes once built, so all modules of the type share one
+class TypeEffects
+{
+public:
+    TypeEffects(uint32 typeID);
+
+    bool isHighSlot() const                                     { return m_HighPower; }
+    bool isMediumSlot() const                                   { return m_MediumPower; }
+    bool isLowSlot() const                                      { return m_LowPower; }
+    bool HasEffect(uint32 effectID) const;
+    MEffect * GetDefaultEffect() const                          { return m_defaultEffect; }
+    MEffect * GetEffect(uint32 effectID) const;
+
+    //the effects and their modifiers applied in a module state, EFFECT_PERSISTENT through EFFECT_OVERLOAD
+    const std::vector<MEffect *> & GetEffects(ModuleEffectTriggers state) const     { return m_Effects[state - EFFECT_PERSISTENT]; }
+    const EffectProgram & GetProgram(ModuleEffectTriggers state) const              { return m_Programs[state - EFFECT_PERSISTENT]; }
+
+private:
+    static const uint32 STATE_COUNT = EFFECT_OVERLOAD - EFFECT_PERSISTENT + 1;
+
+    uint32 m_typeID;
+
+    std::vector<uint32> m_EffectIDs;            // all effects of the type, sorted
+    std::vector<MEffect *> m_Effects[STATE_COUNT];
+    EffectProgram m_Programs[STATE_COUNT];
+    MEffect * m_defaultEffect;
+
+    bool m_HighPower, m_MediumPower, m_LowPower;
+};
+
+
 // This class is a singleton object, containing all Effects loaded from dgmEffects table as memory objects of type MEffect:
 class DGM_Effects_Table
 : public Singleton< DGM_Effects_Table >
@@ -143,10 +203,14 @@ public:
     // Returns pointer to MEffect object corresponding to the effectID supplied:
     MEffect * GetEffect(uint32 effectID);
 
+    // Returns the effects of the typeID supplied, built on first use and shared by all modules of that type:
+    const TypeEffects * GetTypeEffects(uint32 typeID);
+
 protected:
     void _Populate();
 
     std::map<uint32, MEffect *> m_EffectsMap;
+    std::map<uint32, TypeEffects *> m_TypeEffectsMap;
 };
 
 #define sDGM_Effects_Table \
@@ -154,49 +218,5 @@ protected:
 //////////////////////////////////////////////////////////////////////////
 
 
-// ////////////////////// ModuleEffects Class ////////////////////////////
-
-//class contained by all modules that is populated on construction of the module
-//this will contain all information about the effects of the module
-class ModuleEffects
-{
-public:
-    ModuleEffects(uint32 typeID);
-    ~ModuleEffects();
-
-    //this will need to be reworked to implement a singleton architecture...i'll do it later -luck
-
-    //useful accessors - probably a better way to do this, but at least it's fast
-    bool isHighSlot();
-    bool isMediumSlot();
-    bool isLowSlot();
-    bool HasEffect(uint32 effectID);
-    bool HasDefaultEffect() { return ( (m_defaultEffect != NULL) ? true : false ); }
-    MEffect * GetDefaultEffect() { return m_defaultEffect; }
-    MEffect * GetEffect(uint32 effectID);
-
-    std::map<uint32, MEffect *>::const_iterator GetPersistentEffectsConstIterator() { return m_PersistentEffects.begin(); }
-    std::map<uint32, MEffect *>::const_iterator GetOnlineEffectsConstIterator() { return m_OnlineEffects.begin(); }
-    std::map<uint32, MEffect *>::const_iterator GetActiveEffectsConstIterator() { return m_ActiveEffects.begin(); }
-    std::map<uint32, MEffect *>::const_iterator GetOverloadEffectsConstIterator() { return m_OverloadEffects.begin(); }
-
-private:
-
-    void _populate(uint32 typeID);
-
-    //data members
-    std::map<uint32, MEffect *> m_PersistentEffects;
-    std::map<uint32, MEffect *> m_OnlineEffects;
-    std::map<uint32, MEffect *> m_ActiveEffects;
-    std::map<uint32, MEffect *> m_OverloadEffects;
-    MEffect * m_defaultEffect;
-
-    uint32 m_typeID;
-
-    //cached stuff
-    bool m_HighPower, m_MediumPower, m_LowPower, m_Cached;
-
-};
-
 #endif /* MODULE_EFFECTS_H */
 //////////////////////////////////////////////////////////////////////////
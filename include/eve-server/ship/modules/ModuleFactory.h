@@ -33,7 +33,7 @@
 #include "SubSystemModules.h"
 #include "ship/modules/propulsion_modules/Afterburner.h"
 
-//how you should access the modules
+//how you should access the modules; which class to create is part of the ModuleType, so it is decided once per typeID
 static GenericModule* ModuleFactory(InventoryItemRef item, ShipRef ship)
 {
 
@@ -44,184 +44,15 @@ static GenericModule* ModuleFactory(InventoryItemRef item, ShipRef ship)
     }
     else
     {
-        switch(item->groupID())
+        switch(sModuleTypeTable.GetModuleType(*item)->GetModuleClass())
         {
-            // Armor Modules Subgroup:
-            case EVEDB::invGroups::Damage_Control:                          return (new ActiveModule(item, ship)); break;    // Active
-            case EVEDB::invGroups::Armor_Repair_Unit:                       return NULL;    // Active
-            case EVEDB::invGroups::Hull_Repair_Unit:                        return NULL;    // Active
-            case EVEDB::invGroups::Reinforced_Bulkheads:                    return (new PassiveModule(item, ship)); break;
-            case EVEDB::invGroups::Armor_Coating:                           return (new PassiveModule(item, ship)); break;
-            case EVEDB::invGroups::Armor_Repair_Projector:                  return NULL;    // Active
-            case EVEDB::invGroups::Armor_Plating_Energized:                 return (new PassiveModule(item, ship)); break;
-            case EVEDB::invGroups::Armor_Hardener:                          return (new ActiveModule(item, ship)); break;    // Active
-            case EVEDB::invGroups::Armor_Reinforcer:                        return (new PassiveModule(item, ship)); break;
-            case EVEDB::invGroups::Remote_Hull_Repairer:                    return NULL;    // Active
-            case EVEDB::invGroups::Expanded_Cargohold:                      return (new PassiveModule(item, ship)); break;
-
-            // Electronics Modules Subgroup:
-            case EVEDB::invGroups::Cargo_Scanner:                           return NULL;    // Active
-            case EVEDB::invGroups::Ship_Scanner:                            return NULL;    // Active
-            case EVEDB::invGroups::Survey_Scanner:                          return NULL;    // Active
-            case EVEDB::invGroups::Cloaking_Device:                         return NULL;    // Active
-            case EVEDB::invGroups::Target_Painter:                          return NULL;    // Active
-            case EVEDB::invGroups::Drone_Control_Unit:                      return (new PassiveModule(item, ship)); break;
-            case EVEDB::invGroups::System_Scanner:                          return NULL;    // Active
-            case EVEDB::invGroups::Scan_Probe_Launcher:                     return NULL;    // Active
-            case EVEDB::invGroups::Drone_Navigation_Computer:               return (new PassiveModule(item, ship)); break;
-            case EVEDB::invGroups::Drone_Tracking_Modules:                  return (new PassiveModule(item, ship)); break;
-            case EVEDB::invGroups::Drone_Control_Range_Module:              return (new PassiveModule(item, ship)); break;
-            case EVEDB::invGroups::Tractor_Beam:                            return NULL;    // Active
-
-            // Engineering Modules Subgroup:
-            case EVEDB::invGroups::Capacitor_Recharger:                     return (new PassiveModule(item, ship)); break;
-            case EVEDB::invGroups::Capacitor_Battery:                       return (new PassiveModule(item, ship)); break;
-            case EVEDB::invGroups::Energy_Transfer_Array:                   return NULL;    // Active
-            case EVEDB::invGroups::Capacitor_Booster:                       return NULL;    // Active
-            case EVEDB::invGroups::Auxiliary_Power_Core:                    return (new PassiveModule(item, ship)); break;
-            case EVEDB::invGroups::Power_Diagnostic_System:                 return (new PassiveModule(item, ship)); break;
-            case EVEDB::invGroups::Capacitor_Power_Relay:                   return (new PassiveModule(item, ship)); break;
-            case EVEDB::invGroups::Capacitor_Flux_Coil:                     return (new PassiveModule(item, ship)); break;
-            case EVEDB::invGroups::Reactor_Control_Unit:                    return (new PassiveModule(item, ship)); break;
-            case EVEDB::invGroups::Shield_Flux_Coil:                        return (new PassiveModule(item, ship)); break;
-
-            // EWAR Modules Subgroup:
-            case EVEDB::invGroups::Warp_Scrambler:                          return NULL;    // Active
-            case EVEDB::invGroups::Stasis_Web:                              return NULL;    // Active
-            case EVEDB::invGroups::ECM_Burst:                               return NULL;    // Active
-            case EVEDB::invGroups::Passive_Targeting_System:                return NULL;    // Active
-            case EVEDB::invGroups::Automated_Targeting_System:              return NULL;    // Active
-            case EVEDB::invGroups::ECM:                                     return NULL;    // Active
-            case EVEDB::invGroups::ECCM:                                    return NULL;    // Active
-            case EVEDB::invGroups::Sensor_Backup_Array:                     return (new PassiveModule(item, ship)); break;
-            case EVEDB::invGroups::Remote_Sensor_Damper:                    return NULL;    // Active
-            case EVEDB::invGroups::Tracking_Link:                           return NULL;    // Active
-            case EVEDB::invGroups::Signal_Amplifier:                        return (new PassiveModule(item, ship)); break;
-            case EVEDB::invGroups::Tracking_Enhancer:                       return (new PassiveModule(item, ship)); break;
-            case EVEDB::invGroups::Sensor_Booster:                          return NULL;    // Active
-            case EVEDB::invGroups::Tracking_Computer:                       return NULL;    // Active
-            case EVEDB::invGroups::CPU_Enhancer:                            return (new PassiveModule(item, ship)); break;
-            case EVEDB::invGroups::Projected_ECCM:                          return NULL;    // Active
-            case EVEDB::invGroups::Remote_Sensor_Booster:                   return NULL;    // Active
-            case EVEDB::invGroups::Tracking_Disruptor:                      return NULL;    // Active
-            case EVEDB::invGroups::ECM_Stabilizer:                          return (new PassiveModule(item, ship)); break;
-            case EVEDB::invGroups::Remote_ECM_Burst:                        return NULL;    // Active
-
-            // Gang Assist Modules Subgroup:
-            case EVEDB::invGroups::Gang_Coordinator:                        return NULL;    // Active
-            case EVEDB::invGroups::Siege_Module:                            return NULL;    // Active
-            case EVEDB::invGroups::Data_Miners:                             return NULL;    // Active
-            case EVEDB::invGroups::Jump_Portal_Generator:                   return NULL;    // Active
-            case EVEDB::invGroups::Cynosural_Field:                         return NULL;    // Active
-            case EVEDB::invGroups::Clone_Vat_Bay:                           return (new PassiveModule(item, ship)); break;
-
-            // Mining Modules Subgroup:
-            case EVEDB::invGroups::Mining_Laser:                            return NULL;    // Active
-            case EVEDB::invGroups::Strip_Miner:                             return NULL;    // Active
-            case EVEDB::invGroups::Frequency_Mining_Laser:                  return NULL;    // Active
-            case EVEDB::invGroups::Mining_Upgrade:                          return (new PassiveModule(item, ship)); break;
-            case EVEDB::invGroups::Gas_Cloud_Harvester:                     return NULL;    // Active
-
-            // Propulsion Modules Subgroup:
-            case EVEDB::invGroups::Afterburner:                             return (new Afterburner(item, ship)); break;
-            case EVEDB::invGroups::Warp_Core_Stabilizer:                    return (new PassiveModule(item, ship)); break;
-            case EVEDB::invGroups::Inertial_Stabilizer:                     return (new PassiveModule(item, ship)); break;
-            case EVEDB::invGroups::Nanofiber_Internal_Structure:            return (new PassiveModule(item, ship)); break;
-            case EVEDB::invGroups::Overdrive_Injector_System:               return (new PassiveModule(item, ship)); break;
-
-            // Shield Modules Subgroup:
-            case EVEDB::invGroups::Shield_Extender:                         return (new PassiveModule(item, ship)); break;
-            case EVEDB::invGroups::Shield_Recharger:                        return (new PassiveModule(item, ship)); break;
-            case EVEDB::invGroups::Shield_Booster:                          return NULL;    // Active
-            case EVEDB::invGroups::Shield_Transporter:                      return NULL;    // Active
-            case EVEDB::invGroups::Shield_Power_Relay:                      return (new PassiveModule(item, ship)); break;
-            case EVEDB::invGroups::Shield_Hardener:                         return NULL;    // Active
-            case EVEDB::invGroups::Shield_Amplifier:                        return (new PassiveModule(item, ship)); break;
-            case EVEDB::invGroups::Shield_Boost_Amplifier:                  return (new PassiveModule(item, ship)); break;
-            case EVEDB::invGroups::Shield_Disruptor:                        return NULL;    // Active
-
-            // Weapon Modules Subgroup:
-            case EVEDB::invGroups::Energy_Weapon:                           return (new ActiveModule(item, ship)); break;    // Active
-            case EVEDB::invGroups::Projectile_Weapon:                       return (new ActiveModule(item, ship)); break;    // Active
-            case EVEDB::invGroups::Gyrostabilizer:                          return (new PassiveModule(item, ship)); break;
-            case EVEDB::invGroups::Energy_Vampire:                          return NULL;    // Active
-            case EVEDB::invGroups::Energy_Destabilizer:                     return NULL;    // Active
-            case EVEDB::invGroups::Smart_Bomb:                              return NULL;    // Active
-            case EVEDB::invGroups::Hybrid_Weapon:                           return (new ActiveModule(item, ship)); break;   // Active
-            case EVEDB::invGroups::Heat_Sink:                               return (new PassiveModule(item, ship)); break;
-            case EVEDB::invGroups::Magnetic_Field_Stabilizer:               return (new PassiveModule(item, ship)); break;
-            case EVEDB::invGroups::Ballistic_Control_system:                return (new PassiveModule(item, ship)); break;
-            case EVEDB::invGroups::Missile_Launcher_Snowball:               return NULL;    // Active
-            case EVEDB::invGroups::Missile_Launcher_Cruise:                 return NULL;    // Active
-            case EVEDB::invGroups::Missile_Launcher_Rocket:                 return NULL;    // Active
-            case EVEDB::invGroups::Missile_Launcher_Siege:                  return NULL;    // Active
-            case EVEDB::invGroups::Missile_Launcher_Standard:               return NULL;    // Active
-            case EVEDB::invGroups::Missile_Launcher_Heavy:                  return NULL;    // Active
-            case EVEDB::invGroups::Missile_Launcher_Assault:                return NULL;    // Active
-            case EVEDB::invGroups::Missile_Launcher_Defender:               return NULL;    // Active
-            case EVEDB::invGroups::Missile_Launcher_Citadel:                return NULL;    // Active
-            case EVEDB::invGroups::Super_Weapon:                            return NULL;    // Active
-            case EVEDB::invGroups::Interdiction_Sphere_Launcher:            return NULL;    // Active
-            case EVEDB::invGroups::Missile_Launcher_Heavy_Assault:          return (new ActiveModule(item, ship)); break;    // Active
-            case EVEDB::invGroups::Missile_Launcher_Bomb:                   return NULL;    // Active
-            case EVEDB::invGroups::Warp_Disrupt_Field_Generator:            return NULL;    // Active
-
-
-            // Uncategorized and Unknown Modules Groups (some of these groups contain NO REAL typeIDs in the 'invTypes' table:
-            case EVEDB::invGroups::Computer_Interface_Node:                 return NULL;
-            case EVEDB::invGroups::GM_Modules:                              return NULL;
-            case EVEDB::invGroups::Cruise_Control:                          return NULL;
-            case EVEDB::invGroups::Smartbomb_Supercharger:                  return NULL;
-            case EVEDB::invGroups::Anti_Ballistic_Defense_System:           return NULL;
-            case EVEDB::invGroups::Microwarpdrive:                          return NULL;
-            case EVEDB::invGroups::New_EW_Testing:                          return NULL;
-            case EVEDB::invGroups::Missile_Launcher:                        return NULL;
-            case EVEDB::invGroups::Countermeasure_Launcher:                 return NULL;
-            case EVEDB::invGroups::Anti_Cloaking_Pulse:                     return NULL;
-            case EVEDB::invGroups::Signature_Scrambling:                    return NULL;
-            case EVEDB::invGroups::Energy_Vampire_Slayer:                   return NULL;
-            case EVEDB::invGroups::Cheat_Module_Group:                      return NULL;
-            case EVEDB::invGroups::Autopilot:                               return NULL;
-            case EVEDB::invGroups::DroneBayExpander:                        return NULL;
-            case EVEDB::invGroups::Drone_Modules:                           return NULL;
-            case EVEDB::invGroups::Navigation_Computer:                     return NULL;
-            case EVEDB::invGroups::Super_Gang_Enhancer:                     return NULL;
-            case EVEDB::invGroups::Drone_Damage_Modules:                    return NULL;
-            case EVEDB::invGroups::ECM_Enhancer:                            return NULL;
-            case EVEDB::invGroups::Cloak_Enhancements:                      return NULL;
-            case EVEDB::invGroups::Mining_Enhancer:                         return NULL;
-            case EVEDB::invGroups::Covert_Cynosural_Field_Generator:        return NULL;
-
-
-            /************************************/
-            /*              Rigs                */
-            /************************************/
-
-            case EVEDB::invGroups::Rig_Armor:                               return (new RigModule(item, ship)); break;
-            case EVEDB::invGroups::Rig_Shield:                              return (new RigModule(item, ship)); break;
-            case EVEDB::invGroups::Rig_Energy_Weapon:                       return (new RigModule(item, ship)); break;
-            case EVEDB::invGroups::Rig_Hybrid_Weapon:                       return (new RigModule(item, ship)); break;
-            case EVEDB::invGroups::Rig_Projectile_Weapon:                   return (new RigModule(item, ship)); break;
-            case EVEDB::invGroups::Rig_Drones:                              return (new RigModule(item, ship)); break;
-            case EVEDB::invGroups::Rig_Launcher:                            return (new RigModule(item, ship)); break;
-            case EVEDB::invGroups::Rig_Electronics:                         return (new RigModule(item, ship)); break;
-            case EVEDB::invGroups::Rig_Energy_Grid:                         return (new RigModule(item, ship)); break;
-            case EVEDB::invGroups::Rig_Astronautic:                         return (new RigModule(item, ship)); break;
-            case EVEDB::invGroups::Rig_Electronics_Superiority:             return (new RigModule(item, ship)); break;
-            case EVEDB::invGroups::Rig_Mining:                              return (new RigModule(item, ship)); break;
-            case EVEDB::invGroups::Rig_Security_Transponder:                return (new RigModule(item, ship)); break;
-
-
-            /************************************/
-            /*        SubSystem Modules         */
-            /************************************/
-            case EVEDB::invGroups::Defensive_Systems:                       return (new SubSystemModule(item, ship)); break;
-            case EVEDB::invGroups::Electronic_Systems:                      return (new SubSystemModule(item, ship)); break;
-            case EVEDB::invGroups::Offensive_Systems:                       return (new SubSystemModule(item, ship)); break;
-            case EVEDB::invGroups::Propulsion_Systems:                      return (new SubSystemModule(item, ship)); break;
-            case EVEDB::invGroups::Engineering_Systems:                     return (new SubSystemModule(item, ship)); break;
-
+            case MODULE_CLASS_PASSIVE:                                      return (new PassiveModule(item, ship));
+            case MODULE_CLASS_ACTIVE:                                       return (new ActiveModule(item, ship));
+            case MODULE_CLASS_RIG:                                          return (new RigModule(item, ship));
+            case MODULE_CLASS_SUBSYSTEM:                                    return (new SubSystemModule(item, ship));
+            case MODULE_CLASS_AFTERBURNER:                                  return (new Afterburner(item, ship));
 
+            case MODULE_CLASS_NONE:
             default:
                 break;
         }
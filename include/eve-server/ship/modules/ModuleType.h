@@ -0,0 +1,116 @@
+/*
+    ------------------------------------------------------------------------------------
+    LICENSE:
+    ------------------------------------------------------------------------------------
+    This file is part of EVEmu: EVE Online Server Emulator
+    Copyright 2006 - 2011 The EVEmu Team
+    For the latest information visit http://evemu.org
+    ------------------------------------------------------------------------------------
+    This program is free software; you can redistribute it and/or modify it under
+    the terms of the GNU Lesser General Public License as published by the Free Software
+    Foundation; either version 2 of the License, or (at your option) any later
+    version.
+
+    This program is distributed in the hope that it will be useful, but WITHOUT
+    ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+    FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public License along with
+    this program; if not, write to the Free Software Foundation, Inc., 59 Temple
+    Place - Suite 330, Boston, MA 02111-1307, USA, or go to
+    http://www.gnu.org/copyleft/lesser.txt.
+    ------------------------------------------------------------------------------------
+    Author:     EVEmu Team
+*/
+
+#ifndef MODULE_TYPE_H
+#define MODULE_TYPE_H
+
+#include "ship/modules/ModuleDefs.h"
+#include "ship/modules/ModuleEffects.h"
+#include "utils/Singleton.h"
+
+class InventoryItem;
+
+// The GenericModule subclass the ModuleFactory creates for a type:
+enum ModuleClass
+{
+    MODULE_CLASS_NONE = 0,      // not implemented yet
+    MODULE_CLASS_PASSIVE,
+    MODULE_CLASS_ACTIVE,
+    MODULE_CLASS_RIG,
+    MODULE_CLASS_SUBSYSTEM,
+    MODULE_CLASS_AFTERBURNER
+};
+
+
+// ////////////////////// ModuleType Class ////////////////////////////
+
+//everything a module takes from its typeID: the class to create, the slot, the shared compiled effects and the flags around them;
+//it never changes once built, so all modules of the type point to one and only keep their own state, timers and charge
+class ModuleType
+{
+public:
+    ModuleType(uint32 typeID, uint32 groupID, uint32 categoryID);
+
+    uint32 typeID() const                                       { return m_typeID; }
+    uint32 groupID() const                                      { return m_groupID; }
+    uint32 categoryID() const                                   { return m_categoryID; }
+    ModuleClass GetModuleClass() const                          { return m_Class; }
+
+    //the compiled effects, shared with the DGM_Effects_Table
+    const TypeEffects * GetTypeEffects() const                  { return m_TypeEffects; }
+    bool HasEffect(uint32 effectID) const                       { return m_TypeEffects->HasEffect(effectID); }
+    bool HasDefaultEffect() const                               { return m_TypeEffects->GetDefaultEffect() != NULL; }
+    MEffect * GetDefaultEffect() const                          { return m_TypeEffects->GetDefaultEffect(); }
+
+    bool isHighSlot() const                                     { return m_TypeEffects->isHighSlot(); }
+    bool isMediumSlot() const                                   { return m_TypeEffects->isMediumSlot(); }
+    bool isLowSlot() const                                      { return m_TypeEffects->isLowSlot(); }
+    bool isRig() const                                          { return m_Rig; }
+    bool isSubSystem() const                                    { return m_SubSystem; }
+    bool isTurret() const                                       { return m_Turret; }
+    bool isLauncher() const                                     { return m_Launcher; }
+    bool isMaxGroupFitLimited() const                           { return m_MaxGroupFitLimited; }
+    bool requiresTarget() const                                 { return m_RequiresTarget; }
+
+private:
+    static ModuleClass _GetModuleClass(uint32 groupID);
+
+    uint32 m_typeID;
+    uint32 m_groupID;
+    uint32 m_categoryID;
+    ModuleClass m_Class;
+
+    const TypeEffects * m_TypeEffects;
+
+    bool m_Rig, m_SubSystem;
+    bool m_Turret, m_Launcher;
+    bool m_MaxGroupFitLimited;
+    bool m_RequiresTarget;
+};
+
+
+// This class is a singleton object, containing the ModuleType of every module type fitted so far:
+class ModuleTypeTable
+: public Singleton< ModuleTypeTable >
+{
+public:
+    ModuleTypeTable();
+    ~ModuleTypeTable();
+
+    // Returns the ModuleType of the item, built on first use and shared by all modules of its typeID:
+    const ModuleType * GetModuleType(const InventoryItem & item);
+
+    // Returns the number of types built:
+    size_t size() const                                         { return m_Types.size(); }
+
+protected:
+    std::map<uint32, ModuleType *> m_Types;
+};
+
+#define sModuleTypeTable \
+    ( ModuleTypeTable::get() )
+
+#endif /* MODULE_TYPE_H */
+//////////////////////////////////////////////////////////////////////////
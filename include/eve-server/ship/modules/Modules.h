@@ -32,7 +32,7 @@
 #include "inventory/ItemRef.h"
 #include "ship/Ship.h"
 #include "ship/modules/ModuleDefs.h"
-#include "ship/modules/ModuleEffects.h"
+#include "ship/modules/ModuleType.h"
 
 //generic module base class - possibly should inherit from RefPtr...
 class GenericModule
@@ -77,43 +77,19 @@ public:
     virtual EVEItemFlags flag()                                    { return m_Item->flag(); }
     virtual uint32 typeID()                                        { return m_Item->typeID(); }
     virtual bool isOnline()                                        { return (m_Item->GetAttribute(AttrIsOnline) == 1); }
-    virtual bool isHighPower()                                    { return m_Effects->isHighSlot(); }
-    virtual bool isMediumPower()                                { return m_Effects->isMediumSlot(); }
-    virtual bool isLowPower()                                    { return m_Effects->isLowSlot(); }
-
-    virtual bool isTurretFitted()
-    {
-        // Try to make the effect called 'turretFitted' active, if it exists, to test for module being a turret:
-        if( m_Effects->HasEffect(Effect_turretFitted) )     // Effect_turretFitted from enum EveAttrEnum::Effect_turretFitted
-            return true;
-        else
-            return false;
-    }
-
-    virtual bool isLauncherFitted()
-    {
-        // Try to make the effect called 'launcherFitted' active, if it exists, to test for module being a launcher:
-        if( m_Effects->HasEffect(Effect_launcherFitted) )   // Effect_launcherFitted from enum EveAttrEnum::Effect_launcherFitted
-            return true;
-        else
-            return false;
-    }
-
-    virtual bool isMaxGroupFitLimited()
-    {
-        if( m_Item->HasAttribute(AttrMaxGroupFitted) )  // AttrMaxGroupFitted from enum EveAttrEnum::AttrMaxGroupFitted
-            return true;
-        else
-            return false;
-    }
-
-    virtual bool isRig()
-    {
-        uint32 i = m_Item->categoryID();
-        return ( (i >= 773 && i <= 782) || (i == 786) || (i == 787) || (i == 896) || (i == 904) );  //need to use enums, but the enum system is a huge mess
-    }
-
-    virtual bool isSubSystem()                                    { return (m_Item->categoryID() == EVEDB::invCategories::Subsystem); }
+    virtual bool isHighPower()                                    { return m_Type->isHighSlot(); }
+    virtual bool isMediumPower()                                { return m_Type->isMediumSlot(); }
+    virtual bool isLowPower()                                    { return m_Type->isLowSlot(); }
+    const ModuleType * GetModuleType()                          { return m_Type; }
+    const TypeEffects * GetTypeEffects()                        { return m_Type->GetTypeEffects(); }
+    ModuleStates GetModuleState()                               { return m_Module_State; }
+
+    // the type data is looked up once per typeID, see ModuleType:
+    virtual bool isTurretFitted()                               { return m_Type->isTurret(); }
+    virtual bool isLauncherFitted()                             { return m_Type->isLauncher(); }
+    virtual bool isMaxGroupFitLimited()                         { return m_Type->isMaxGroupFitLimited(); }
+    virtual bool isRig()                                        { return m_Type->isRig(); }
+    virtual bool isSubSystem()                                  { return m_Type->isSubSystem(); }
 
     //override for rigs and subsystems
     virtual ModulePowerLevel GetModulePowerLevel()                { return isHighPower() ? MODULE_BANK_HIGH_POWER : ( isMediumPower() ? MODULE_BANK_MEDIUM_POWER : MODULE_BANK_LOW_POWER); }
@@ -121,7 +97,7 @@ public:
 protected:
     InventoryItemRef m_Item;
     ShipRef m_Ship;
-    ModuleEffects * m_Effects;
+    const ModuleType * m_Type;              //shared by all modules of the typeID, owned by the ModuleTypeTable
 
     ModuleStates m_Module_State;
     ChargeStates m_Charge_State;
@@ -36,6 +36,9 @@ public:
     ActiveModuleProcessingComponent(GenericModule * mod, ShipRef ship, ModifyShipAttributesComponent * shipAttrMod);
     ~ActiveModuleProcessingComponent();
 
+    //lets the module cycle again; cancels a pending DeactivateCycle()
+    void ActivateCycle();
+    //the module stops once its running cycle ends
     void DeactivateCycle();
 
     bool ShouldProcessActiveCycle();
@@ -34,7 +34,6 @@ class FactionWarMgrDB : public ServiceDB
 {
 public:
     PyRep *GetWarFactions();
-    PyRep *GetFacWarSystems();
     uint32 GetFactionMilitiaCorporation(const uint32 factionID);
 };
 
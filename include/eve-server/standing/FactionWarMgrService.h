@@ -45,6 +45,8 @@ private:
     Dispatcher *const m_dispatch;
 
     FactionWarMgrDB m_db;
+    //the version of the sovereignty table the cached systems were built from.
+    uint64 m_facWarSystemsVersion;
 };
 
 #endif /* __FACTION_WAR_MGR_SERVICE__H__INCL__ */
@@ -0,0 +1,207 @@
+/*
+    ------------------------------------------------------------------------------------
+    LICENSE:
+    ------------------------------------------------------------------------------------
+    This file is part of EVEmu: EVE Online Server Emulator
+    Copyright 2006 - 2011 The EVEmu Team
+    For the latest information visit http://evemu.org
+    ------------------------------------------------------------------------------------
+    This program is free software; you can redistribute it and/or modify it under
+    the terms of the GNU Lesser General Public License as published by the Free Software
+    Foundation; either version 2 of the License, or (at your option) any later
+    version.
+
+    This program is distributed in the hope that it will be useful, but WITHOUT
+    ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+    FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public License along with
+    this program; if not, write to the Free Software Foundation, Inc., 59 Temple
+    Place - Suite 330, Boston, MA 02111-1307, USA, or go to
+    http://www.gnu.org/copyleft/lesser.txt.
+    ------------------------------------------------------------------------------------
+    Author:     EVEmu Team
+*/
+
+
+#ifndef __STANDING__HOSTILITY_RESOLVER_H__INCL__
+#define __STANDING__HOSTILITY_RESOLVER_H__INCL__
+
+#include "utils/Singleton.h"
+
+class Client;
+
+/**
+ * @brief Resident wars, faction war memberships and kill rights; answers who may attack whom.
+ *
+ * The active wars and the unexpired kill rights are loaded at startup
+ * and kept up to date by the calls which change them, which also
+ * write the change. The militias of the factional warfare are the
+ * militia corporations of the factions, which never change.
+ *
+ * GetHostility() takes a few hash lookups: the wars between the
+ * owners of the attacker and of the target, the factions of their
+ * corporations and the kill right of the attacker on the target.
+ *
+ * Not thread-safe; meant to be used from the main loop.
+ *
+ * @author EVEmu Team
+ */
+class HostilityResolver
+: public Singleton< HostilityResolver >
+{
+public:
+    /// Why an attack is legal, by precedence.
+    enum Hostility
+    {
+        HOSTILITY_NONE = 0,
+        HOSTILITY_WAR,
+        HOSTILITY_FACTION_WAR,
+        HOSTILITY_KILL_RIGHT
+    };
+
+    /**
+     * @brief Statistics of the resolver.
+     */
+    struct Stats
+    {
+        Stats() { Reset(); }
+
+        void Reset()
+        {
+            checks = 0;
+            hostile = 0;
+            updates = 0;
+        }
+
+        /// Number of hostilities resolved.
+        uint32 checks;
+        /// Number of them which allowed the attack.
+        uint32 hostile;
+        /// Number of wars and kill rights changed.
+        uint32 updates;
+    };
+
+    HostilityResolver();
+
+    /** @return Number of active wars. */
+    size_t size() const { return mWars.size(); }
+    /** @return Number of kill rights. */
+    size_t GetKillRightCount() const { return mKillRights.size(); }
+    /** @return Statistics since the last ResetStats(). */
+    const Stats& stats() const { return mStats; }
+    /** @brief Resets the statistics. */
+    void ResetStats() { mStats.Reset(); }
+
+    /**
+     * @brief Loads the militias, the active wars and the kill rights.
+     *
+     * @return True on success.
+     */
+    bool Load();
+
+    /**
+     * @brief Resolves why a character may attack another one.
+     *
+     * @return HOSTILITY_NONE if the attack is not legal.
+     */
+    Hostility GetHostility( uint32 attackerID, uint32 attackerCorpID, uint32 attackerAllianceID,
+                            uint32 targetID, uint32 targetCorpID, uint32 targetAllianceID );
+    /** @brief Resolves why a client may attack another one. */
+    Hostility GetHostility( const Client& attacker, const Client& target );
+    /** @return Whether a client may attack another one. */
+    bool MayAttack( const Client& attacker, const Client& target ) { return HOSTILITY_NONE != GetHostility( attacker, target ); }
+
+    /**
+     * @return Whether two owners, corporations or alliances, are at war.
+     */
+    bool AtWar( uint32 ownerID, uint32 otherID ) const;
+    /**
+     * @return factionID of the militia a corporation is, 0 if none.
+     */
+    uint32 GetWarFactionID( uint32 corporationID ) const;
+
+    /**
+     * @brief Declares a war.
+     *
+     * @return warID of the war; 0 on failure.
+     */
+    uint32 DeclareWar( uint32 declaredByID, uint32 againstID, bool mutual );
+    /**
+     * @brief Ends a war.
+     *
+     * @param[in] warID       The war.
+     * @param[in] retractedBy The owner which retracted it; 0 if it just ended.
+     */
+    void EndWar( uint32 warID, uint32 retractedBy );
+
+    /**
+     * @brief Gives a character the right to kill another one.
+     *
+     * @param[in] fromID     The victim, which holds the right.
+     * @param[in] toID       The character the right is on.
+     * @param[in] expiryDate Win32 time the right expires at.
+     */
+    void AddKillRight( uint32 fromID, uint32 toID, uint64 expiryDate );
+    /** @brief Removes a kill right, once used or expired. */
+    void RemoveKillRight( uint32 fromID, uint32 toID );
+    /** @brief Removes all the kill rights of and on a character. */
+    void RemoveCharacter( uint32 characterID );
+
+    /**
+     * @return The util.IndexRowset of the wars of an owner, by warID.
+     */
+    PyObject* EncodeWars( uint32 ownerID ) const;
+    /**
+     * @return Tuple of the kill rights a character holds and of the kill rights on it,
+     *         dicts of the other character to the expiry date.
+     */
+    PyTuple* EncodeKillRights( uint32 characterID ) const;
+
+protected:
+    struct War
+    {
+        uint32 declaredByID;
+        uint32 againstID;
+        uint64 timeDeclared;
+        uint32 billID;
+        bool mutual;
+    };
+
+    typedef std::tr1::unordered_map< uint32, std::set< uint32 > > IDSetMap;
+
+    static uint64 _PairKey( uint32 a, uint32 b ) { return a < b ? ( (uint64)a << 32 ) | b : ( (uint64)b << 32 ) | a; }
+    static uint64 _RightKey( uint32 fromID, uint32 toID ) { return ( (uint64)fromID << 32 ) | toID; }
+
+    /** @return Whether the two factions fight each other in the factional warfare. */
+    static bool _FactionsAtWar( uint32 factionID, uint32 otherID );
+
+    void _AddWar( uint32 warID, const War& war );
+    void _RemoveKillRight( uint32 fromID, uint32 toID );
+
+    /// The active wars, by warID.
+    std::tr1::unordered_map< uint32, War > mWars;
+    /// Number of active wars between two owners, by their pair.
+    std::tr1::unordered_map< uint64, uint32 > mWarPairs;
+    /// The active wars of every owner.
+    IDSetMap mOwnerWars;
+
+    /// Factions of the militia corporations.
+    std::tr1::unordered_map< uint32, uint32 > mMilitias;
+
+    /// Expiry dates of the kill rights, by holder and target.
+    std::tr1::unordered_map< uint64, uint64 > mKillRights;
+    /// The characters every character holds kill rights on.
+    IDSetMap mRightsHeld;
+    /// The characters holding kill rights on every character.
+    IDSetMap mRightsOn;
+
+    /// Statistics.
+    Stats mStats;
+};
+
+/// A macro for easier access to the singleton.
+#define sHostilityResolver \
+    ( HostilityResolver::get() )
+
+#endif /* !__STANDING__HOSTILITY_RESOLVER_H__INCL__ */
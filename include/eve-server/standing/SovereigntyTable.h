@@ -0,0 +1,210 @@
+/*
+    ------------------------------------------------------------------------------------
+    LICENSE:
+    ------------------------------------------------------------------------------------
+    This file is part of EVEmu: EVE Online Server Emulator
+    Copyright 2006 - 2011 The EVEmu Team
+    For the latest information visit http://evemu.org
+    ------------------------------------------------------------------------------------
+    This program is free software; you can redistribute it and/or modify it under
+    the terms of the GNU Lesser General Public License as published by the Free Software
+    Foundation; either version 2 of the License, or (at your option) any later
+    version.
+
+    This program is distributed in the hope that it will be useful, but WITHOUT
+    ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+    FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public License along with
+    this program; if not, write to the Free Software Foundation, Inc., 59 Temple
+    Place - Suite 330, Boston, MA 02111-1307, USA, or go to
+    http://www.gnu.org/copyleft/lesser.txt.
+    ------------------------------------------------------------------------------------
+    Author:     EVEmu Team
+*/
+
+
+#ifndef __STANDING__SOVEREIGNTY_TABLE_H__INCL__
+#define __STANDING__SOVEREIGNTY_TABLE_H__INCL__
+
+#include "utils/Singleton.h"
+
+/**
+ * @brief The sovereignty and the faction warfare state of a solar system.
+ */
+struct SystemSovereignty
+{
+    uint32 solarSystemID;
+    /// The faction the system belongs to (mapSolarSystems); 0 if none.
+    uint32 factionID;
+    /// The alliance holding sovereignty; 0 if none.
+    uint32 allianceID;
+    uint32 corporationID;
+    uint32 claimStructureID;
+    uint32 hubID;
+    /// Win32 time sovereignty was claimed at.
+    uint64 claimTime;
+    bool contested;
+    /// The faction occupying the system in faction warfare; 0 if it is not fought over.
+    uint32 occupierID;
+};
+
+/**
+ * @brief Resident sovereignty and faction warfare state of all the solar systems.
+ *
+ * The state of every solar system is loaded at startup (the factions
+ * from mapSolarSystems, the rest from mapSovereignty), so the clients
+ * entering a system or opening the map are served from memory.
+ *
+ * Every change bumps the version of the table and is appended to a
+ * change feed, which tells which systems changed since a version.
+ * Once per tick the changes since the last tick are pushed to the
+ * sessions in the changed systems: OnSovereigntyChanged when the
+ * alliance holding a system changes, OnSystemOccupierChanged when
+ * the occupier does. The changes themselves are written right away;
+ * they happen a few times a day.
+ *
+ * Not thread-safe; meant to be used from the main loop.
+ *
+ * @author EVEmu Team
+ */
+class SovereigntyTable
+: public Singleton< SovereigntyTable >
+{
+public:
+    /**
+     * @brief Statistics of the table.
+     */
+    struct Stats
+    {
+        Stats() { Reset(); }
+
+        void Reset()
+        {
+            queries = 0;
+            changes = 0;
+            notifications = 0;
+        }
+
+        /// Number of system states served.
+        uint32 queries;
+        /// Number of changes.
+        uint32 changes;
+        /// Number of sessions notified of a change.
+        uint32 notifications;
+    };
+
+    SovereigntyTable();
+    ~SovereigntyTable();
+
+    /** @return Number of solar systems. */
+    size_t size() const { return mSystems.size(); }
+    /** @return The version of the table, bumped by every change. */
+    uint64 GetVersion() const { return mVersion; }
+    /** @return Statistics since the last ResetStats(). */
+    const Stats& stats() const { return mStats; }
+    /** @brief Resets the statistics. */
+    void ResetStats() { mStats.Reset(); }
+
+    /**
+     * @brief Loads the state of all the solar systems.
+     *
+     * @return True on success.
+     */
+    bool Load();
+
+    /**
+     * @return The state of a solar system; NULL if there is no such system.
+     */
+    const SystemSovereignty* Get( uint32 solarSystemID );
+    /**
+     * @return The sovereignty info of a solar system, as sovMgr returns it; NULL if there is no such system.
+     */
+    PyRep* GetSovereigntyInfo( uint32 solarSystemID );
+    /**
+     * @return A new reference to the dict of the faction warfare systems, occupierID and factionID by solarSystemID.
+     */
+    PyDict* GetFacWarSystems();
+
+    /**
+     * @brief Finds the systems changed since a version.
+     *
+     * @param[in] version The version the caller knows.
+     * @param[out] into   The changed systems, in the order of their changes; a system may repeat.
+     *
+     * @return False if the feed no longer goes back that far; the caller has to read everything again.
+     */
+    bool GetChangesSince( uint64 version, std::vector< uint32 >& into ) const;
+
+    /**
+     * @brief Changes the alliance holding sovereignty over a system.
+     *
+     * @param[in] allianceID       The alliance; 0 to drop sovereignty.
+     * @param[in] corporationID    The corporation which claimed the system.
+     * @param[in] claimStructureID The claiming structure.
+     *
+     * @return True on success.
+     */
+    bool Claim( uint32 solarSystemID, uint32 allianceID, uint32 corporationID, uint32 claimStructureID );
+    /**
+     * @brief Marks a system contested or not.
+     */
+    bool SetContested( uint32 solarSystemID, bool contested );
+    /**
+     * @brief Changes the faction occupying a system in faction warfare.
+     *
+     * @param[in] occupierID The faction; 0 if the system is no longer fought over.
+     */
+    bool Occupy( uint32 solarSystemID, uint32 occupierID );
+
+    /**
+     * @brief Pushes the changes since the last call to the sessions in the changed systems.
+     */
+    void Process();
+
+protected:
+    /// Number of changes the feed goes back.
+    static const size_t FEED_LENGTH = 1024;
+
+    enum ChangeKind
+    {
+        CHANGE_SOVEREIGNTY,
+        CHANGE_OCCUPIER
+    };
+
+    /**
+     * @brief An entry of the change feed.
+     */
+    struct Change
+    {
+        uint64 version;
+        uint32 solarSystemID;
+        ChangeKind kind;
+    };
+
+    /**
+     * @brief Writes the state of a system and records the change.
+     */
+    bool _Changed( const SystemSovereignty& system, ChangeKind kind );
+
+    std::tr1::unordered_map< uint32, SystemSovereignty > mSystems;
+
+    /// The latest changes, oldest first.
+    std::deque< Change > mFeed;
+    uint64 mVersion;
+    /// The version the sessions were last notified of.
+    uint64 mPushedVersion;
+
+    /// The faction warfare systems, as of mFacWarVersion; NULL if not built yet.
+    PyDict* mFacWarSystems;
+    uint64 mFacWarVersion;
+
+    /// Statistics.
+    Stats mStats;
+};
+
+/// A macro for easier access to the singleton.
+#define sSovereigntyTable \
+    ( SovereigntyTable::get() )
+
+#endif /* !__STANDING__SOVEREIGNTY_TABLE_H__INCL__ */
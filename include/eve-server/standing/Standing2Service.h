@@ -30,12 +30,16 @@
 #include "standing/StandingDB.h"
 #include "PyService.h"
 
+class ObjectCachedMethodID;
+
 class Standing2Service : public PyService
 {
 public:
     Standing2Service(PyServiceMgr *mgr);
     virtual ~Standing2Service();
 
+    virtual void PrimeCache();
+
 protected:
     class Dispatcher;
     Dispatcher *const m_dispatch;
@@ -91,6 +95,8 @@ protected:
     PyCallable_DECL_CALL(GetStandingTransactions)
     PyCallable_DECL_CALL(GetCharStandings)
     PyCallable_DECL_CALL(GetCorpStandings)
+
+    void _CacheNPCNPCStandings(const ObjectCachedMethodID &method_id);
 };
 
 
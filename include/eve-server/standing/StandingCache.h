@@ -0,0 +1,178 @@
+/*
+    ------------------------------------------------------------------------------------
+    LICENSE:
+    ------------------------------------------------------------------------------------
+    This file is part of EVEmu: EVE Online Server Emulator
+    Copyright 2006 - 2011 The EVEmu Team
+    For the latest information visit http://evemu.org
+    ------------------------------------------------------------------------------------
+    This program is free software; you can redistribute it and/or modify it under
+    the terms of the GNU Lesser General Public License as published by the Free Software
+    Foundation; either version 2 of the License, or (at your option) any later
+    version.
+
+    This program is distributed in the hope that it will be useful, but WITHOUT
+    ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+    FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public License along with
+    this program; if not, write to the Free Software Foundation, Inc., 59 Temple
+    Place - Suite 330, Boston, MA 02111-1307, USA, or go to
+    http://www.gnu.org/copyleft/lesser.txt.
+    ------------------------------------------------------------------------------------
+    Author:     EVEmu Team
+*/
+
+
+#ifndef __STANDING__STANDING_CACHE_H__INCL__
+#define __STANDING__STANDING_CACHE_H__INCL__
+
+#include "utils/Singleton.h"
+
+class Character;
+
+/**
+ * @brief Resident standings: the NPC matrix and the standings of the online characters.
+ *
+ * The standings of the NPCs towards each other never change at
+ * runtime and are loaded at startup. The standings of a character,
+ * towards others and of the NPCs towards it, are loaded by the first
+ * lookup of its session and kept until it logs out.
+ *
+ * The lookups are O(1); the effective standings, raised by the
+ * Connections and Diplomacy skills, are memoized per character until
+ * its skills change.
+ *
+ * Not thread-safe; meant to be used from the main loop.
+ *
+ * @author EVEmu Team
+ */
+class StandingCache
+: public Singleton< StandingCache >
+{
+public:
+    /**
+     * @brief Statistics of the cache.
+     */
+    struct Stats
+    {
+        Stats() { Reset(); }
+
+        void Reset()
+        {
+            lookups = 0;
+            derivedHits = 0;
+            derivedMisses = 0;
+            characterLoads = 0;
+            updates = 0;
+        }
+
+        /// Number of standings looked up.
+        uint32 lookups;
+        /// Number of effective standings served from the memo.
+        uint32 derivedHits;
+        /// Number of effective standings computed.
+        uint32 derivedMisses;
+        /// Number of characters whose standings were loaded.
+        uint32 characterLoads;
+        /// Number of standings changed.
+        uint32 updates;
+    };
+
+    StandingCache();
+
+    /** @return Number of standings in the NPC matrix. */
+    size_t size() const { return mNPCStandings.size(); }
+    /** @return Number of characters whose standings are resident. */
+    size_t GetCharacterCount() const { return mCharacters.size(); }
+    /** @return Statistics since the last ResetStats(). */
+    const Stats& stats() const { return mStats; }
+    /** @brief Resets the statistics. */
+    void ResetStats() { mStats.Reset(); }
+
+    /**
+     * @brief Loads the NPC matrix.
+     *
+     * @return True on success.
+     */
+    bool Load();
+
+    /**
+     * @return Standing of an NPC towards another one; 0 if it has none.
+     */
+    double GetNPCStanding( uint32 fromID, uint32 toID );
+    /**
+     * @return Standing of an NPC towards a character; 0 if it has none.
+     */
+    double GetStanding( uint32 characterID, uint32 fromID );
+    /**
+     * @brief Computes the standing of an NPC towards a character, raised
+     *        by its Connections skill if positive and by its Diplomacy skill if negative.
+     *
+     * @return The effective standing.
+     */
+    double GetEffectiveStanding( const Character& character, uint32 fromID );
+
+    /**
+     * @brief Changes the standing of an NPC towards a character.
+     *
+     * @return True if the change was written.
+     */
+    bool SetStanding( uint32 characterID, uint32 fromID, double standing );
+
+    /** @return util.Rowset of the NPC matrix; the columns are fromID, toID and standing. */
+    PyObject* EncodeNPCStandings() const;
+    /** @return CRowset of the standings of a character towards others; the columns are fromID and standing. */
+    PyObjectEx* EncodeCharStandings( uint32 characterID );
+    /** @return util.Rowset of the standings of the NPCs towards a character; the columns are fromID and standing. */
+    PyObject* EncodeCharNPCStandings( uint32 characterID );
+
+    /**
+     * @brief Drops the effective standings of a character after its skills changed.
+     */
+    void ForgetEffective( uint32 characterID );
+    /**
+     * @brief Drops the standings of a character which logged out.
+     */
+    void Forget( uint32 characterID );
+
+protected:
+    typedef std::tr1::unordered_map< uint32, double > StandingMap;
+
+    /**
+     * @brief Resident standings of a character.
+     */
+    struct CharStandings
+    {
+        /// Standings of the character towards others, by toID.
+        StandingMap own;
+        /// Standings of the NPCs towards the character, by fromID.
+        StandingMap npc;
+        /// Memoized effective standings, by fromID.
+        StandingMap effective;
+    };
+
+    static uint64 _Key( uint32 fromID, uint32 toID ) { return ( (uint64)fromID << 32 ) | toID; }
+
+    /**
+     * @brief Finds the standings of a character, loading them if they are not resident.
+     *
+     * @return The standings; NULL if they cannot be loaded.
+     */
+    CharStandings* _Get( uint32 characterID );
+    bool _Load( uint32 characterID, CharStandings& into );
+
+    /// The NPC matrix.
+    std::tr1::unordered_map< uint64, double > mNPCStandings;
+    /// The resident standings of the characters.
+    std::tr1::unordered_map< uint32, CharStandings > mCharacters;
+
+    /// Statistics.
+    Stats mStats;
+};
+
+/// A macro for easier access to the singleton.
+#define sStandingCache \
+    ( StandingCache::get() )
+
+#endif /* !__STANDING__STANDING_CACHE_H__INCL__ */
@@ -33,11 +33,9 @@ class StandingDB
 : public ServiceDB
 {
 public:
-    PyObject *GetNPCStandings();
-    PyObjectEx *GetCharStandings(uint32 characterID);
     PyObjectEx *GetCorpStandings(uint32 corporationID);
     PyObject *GetCharPrimeStandings(uint32 characterID);
-    PyObject *GetCharNPCStandings(uint32 characterID);
+    static bool SetCharNPCStanding(uint32 characterID, uint32 fromID, double standing);
     PyObject *GetStandingTransactions(uint32 characterID);
 };
 
@@ -0,0 +1,173 @@
+/*
+    ------------------------------------------------------------------------------------
+    LICENSE:
+    ------------------------------------------------------------------------------------
+    This file is part of EVEmu: EVE Online Server Emulator
+    Copyright 2006 - 2011 The EVEmu Team
+    For the latest information visit http://evemu.org
+    ------------------------------------------------------------------------------------
+    This program is free software; you can redistribute it and/or modify it under
+    the terms of the GNU Lesser General Public License as published by the Free Software
+    Foundation; either version 2 of the License, or (at your option) any later
+    version.
+
+    This program is distributed in the hope that it will be useful, but WITHOUT
+    ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+    FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public License along with
+    this program; if not, write to the Free Software Foundation, Inc., 59 Temple
+    Place - Suite 330, Boston, MA 02111-1307, USA, or go to
+    http://www.gnu.org/copyleft/lesser.txt.
+    ------------------------------------------------------------------------------------
+    Author:     EVEmu Team
+*/
+
+
+#ifndef __STATION__STATION_CACHE_H__INCL__
+#define __STATION__STATION_CACHE_H__INCL__
+
+#include "station/StationDB.h"
+#include "utils/Singleton.h"
+
+/**
+ * @brief Resident state of the stations.
+ *
+ * The static info of a station (the util.KeyVal of GetStation and
+ * the item bits of GetStationItemBits) is queried once, on first use,
+ * and shared by all the later callers.
+ *
+ * The guests of every station are kept with their encoded guest row
+ * (characterID, corporationID, allianceID, None), added and removed
+ * as characters dock and undock. Arrivals and departures are queued;
+ * Process() pushes them once per tick, one notification per station
+ * to the characters docked there, instead of a broadcast to everyone
+ * per dock or undock. A character which docks and undocks within the
+ * same tick is not announced at all.
+ *
+ * Not thread-safe; meant to be used from the main loop.
+ *
+ * @author EVEmu Team
+ */
+class StationCache
+: public Singleton< StationCache >
+{
+public:
+    /**
+     * @brief Statistics of the cache.
+     */
+    struct Stats
+    {
+        Stats() { Reset(); }
+
+        void Reset()
+        {
+            hits = 0;
+            misses = 0;
+            arrivals = 0;
+            departures = 0;
+            coalesced = 0;
+            notifications = 0;
+        }
+
+        /// Number of static infos served from the cache.
+        uint32 hits;
+        /// Number of static infos queried.
+        uint32 misses;
+        /// Number of docked characters.
+        uint32 arrivals;
+        /// Number of undocked characters.
+        uint32 departures;
+        /// Number of changes which cancelled a queued one.
+        uint32 coalesced;
+        /// Number of notifications multicast to the stations.
+        uint32 notifications;
+    };
+
+    StationCache();
+    ~StationCache();
+
+    /** @return Number of stations with a resident state. */
+    size_t size() const { return mStations.size(); }
+    /** @return Number of docked characters. */
+    size_t GetGuestCount() const { return mGuestCount; }
+    /** @return Statistics since the last ResetStats(). */
+    const Stats& stats() const { return mStats; }
+    /** @brief Resets the statistics. */
+    void ResetStats() { mStats.Reset(); }
+
+    /**
+     * @return The util.KeyVal of the station; NULL if there is no such station.
+     */
+    PyRep* GetStation( uint32 stationID );
+    /**
+     * @return Tuple of hangarGraphicID, ownerID, stationID, serviceMask and stationTypeID; NULL if there is no such station.
+     */
+    PyRep* GetStationItemBits( uint32 stationID );
+    /**
+     * @return List of the guest rows of the station.
+     */
+    PyList* GetGuests( uint32 stationID );
+    /**
+     * @brief Lists the characterIDs of the guests of a station.
+     */
+    void GetGuestIDs( uint32 stationID, std::vector< uint32 >& into ) const;
+
+    /**
+     * @brief Adds a guest to a station; the guests are told by the next Process().
+     *
+     * Updates the guest row if the character is a guest already.
+     */
+    void AddGuest( uint32 stationID, uint32 characterID, uint32 corporationID, uint32 allianceID );
+    /**
+     * @brief Removes a guest from a station; the guests are told by the next Process().
+     */
+    void RemoveGuest( uint32 stationID, uint32 characterID );
+
+    /**
+     * @brief Pushes the queued arrivals and departures to the guests.
+     */
+    void Process();
+
+protected:
+    /**
+     * @brief A queued arrival or departure.
+     */
+    struct Change
+    {
+        bool arrived;
+        PyTuple* row;
+    };
+
+    /**
+     * @brief Resident state of a station.
+     */
+    struct Station
+    {
+        /// The static info; NULL until first used.
+        PyRep* station;
+        PyRep* itemBits;
+        /// The guest rows, by characterID.
+        std::map< uint32, PyTuple* > guests;
+    };
+
+    Station& _Get( uint32 stationID );
+
+    /// The stations.
+    std::tr1::unordered_map< uint32, Station > mStations;
+    /// Number of guests of all the stations.
+    size_t mGuestCount;
+    /// Changes since the last Process(), by station and character.
+    std::map< uint32, std::map< uint32, Change > > mChanges;
+
+    StationDB mDB;
+
+    /// Statistics.
+    Stats mStats;
+};
+
+/// A macro for easier access to the singleton.
+#define sStationCache \
+    ( StationCache::get() )
+
+#endif /* !__STATION__STATION_CACHE_H__INCL__ */
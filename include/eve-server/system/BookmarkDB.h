@@ -28,14 +28,55 @@
 
 #include "ServiceDB.h"
 
+/**
+ * @brief A bookmark as stored in bookmarks.
+ */
+struct BookmarkData
+{
+    uint32 bookmarkID;
+    uint32 ownerID;
+    uint32 itemID;
+    uint32 typeID;
+    uint32 flag;
+    std::string memo;
+    uint64 created;
+    double x;
+    double y;
+    double z;
+    uint32 locationID;
+    std::string note;
+    uint32 creatorID;
+    /// The folder it is in; 0 if none.
+    uint32 folderID;
+};
+
+/**
+ * @brief A bookmark folder as stored in bookmarkFolders.
+ */
+struct BookmarkFolder
+{
+    uint32 folderID;
+    std::string folderName;
+    uint32 creatorID;
+};
+
 class BookmarkDB
 : public ServiceDB
 {
 public:
-    PyObjectEx *GetBookmarks(uint32 ownerID);
-    PyObjectEx *GetFolders(uint32 ownerID);
+    /**
+     * @brief Obtains all the bookmarks of an owner.
+     */
+    bool LoadBookmarks(uint32 ownerID, std::vector<BookmarkData> &into);
+    /**
+     * @brief Obtains all the bookmark folders of an owner.
+     */
+    bool LoadFolders(uint32 ownerID, std::vector<BookmarkFolder> &into);
 
-       uint32 GetNextAvailableBookmarkID();
+    /**
+     * @return The highest bookmarkID in use; 0 if none.
+     */
+    uint32 GetLastBookmarkID();
 
     uint32 FindBookmarkTypeID(uint32 itemID);
 
@@ -43,13 +84,28 @@ public:
                                 uint32 &flag, std::string &memo, uint64 &created, double &x, double &y,
                                 double &z, uint32 &locationID);
 
-    bool SaveNewBookmarkToDatabase(uint32 &bookmarkID, uint32 ownerID, uint32 itemID,
-                                   uint32 typeID, uint32 flag, std::string memo, uint64 created,
-                                   double x, double y, double z, uint32 locationID);
+    bool InsertBookmark(const BookmarkData &bookmark);
+
+    /**
+     * @brief Deletes bookmarks of an owner with a single statement.
+     */
+    bool DeleteBookmarksFromDatabase(uint32 ownerID, const std::vector<uint32> &bookmarkIDs);
+    /**
+     * @brief Moves bookmarks of an owner into a folder with a single statement.
+     */
+    bool MoveBookmarksInDatabase(uint32 ownerID, const std::vector<uint32> &bookmarkIDs, uint32 folderID);
+    /**
+     * @brief Deletes a folder of an owner, along with the bookmarks in it.
+     */
+    bool DeleteFolderFromDatabase(uint32 ownerID, uint32 folderID);
 
-    bool DeleteBookmarksFromDatabase(uint32 ownerID, std::vector<unsigned long> * bookmarkList);
+    bool UpdateBookmarkInDatabase(uint32 bookmarkID, uint32 ownerID, const std::string &memo);
 
-    bool UpdateBookmarkInDatabase(uint32 bookmarkID, uint32 ownerID, std::string memo);
+protected:
+    /**
+     * @return The IDs as a comma separated list.
+     */
+    static std::string JoinIDs(const std::vector<uint32> &ids);
 };
 
 #endif /* !__BOOKMARK_DB__H__INCL__ */
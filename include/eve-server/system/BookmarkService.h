@@ -45,7 +45,6 @@ public:
 protected:
     class Dispatcher;
     Dispatcher *const m_dispatch;
-    uint32 nextBookmarkID;
 
     BookmarkDB m_db;
 
@@ -53,6 +52,8 @@ protected:
     PyCallable_DECL_CALL(BookmarkLocation)
     PyCallable_DECL_CALL(DeleteBookmarks)
     PyCallable_DECL_CALL(UpdateBookmark)
+    PyCallable_DECL_CALL(MoveBookmarksToFolder)
+    PyCallable_DECL_CALL(DeleteFolder)
 };
 
 #endif
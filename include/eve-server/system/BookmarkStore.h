@@ -0,0 +1,183 @@
+/*
+    ------------------------------------------------------------------------------------
+    LICENSE:
+    ------------------------------------------------------------------------------------
+    This file is part of EVEmu: EVE Online Server Emulator
+    Copyright 2006 - 2011 The EVEmu Team
+    For the latest information visit http://evemu.org
+    ------------------------------------------------------------------------------------
+    This program is free software; you can redistribute it and/or modify it under
+    the terms of the GNU Lesser General Public License as published by the Free Software
+    Foundation; either version 2 of the License, or (at your option) any later
+    version.
+
+    This program is distributed in the hope that it will be useful, but WITHOUT
+    ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+    FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public License along with
+    this program; if not, write to the Free Software Foundation, Inc., 59 Temple
+    Place - Suite 330, Boston, MA 02111-1307, USA, or go to
+    http://www.gnu.org/copyleft/lesser.txt.
+    ------------------------------------------------------------------------------------
+    Author:     EVEmu Team
+*/
+
+
+#ifndef __SYSTEM__BOOKMARK_STORE_H__INCL__
+#define __SYSTEM__BOOKMARK_STORE_H__INCL__
+
+#include "system/BookmarkDB.h"
+#include "utils/Singleton.h"
+
+/**
+ * @brief The bookmarks of the online characters, kept in memory.
+ *
+ * The bookmarks and folders of a character are loaded by the first
+ * call which needs them and kept until it logs out; GetBookmarks is
+ * then served without a query, and a bookmark is found by its ID in
+ * constant time, which warps to bookmarks rely on. Every bookmark is
+ * also indexed by its folder.
+ *
+ * Changes go to the database right away; deleting or moving any
+ * number of bookmarks is a single statement.
+ *
+ * Not thread-safe; meant to be used from the main loop.
+ *
+ * @author EVEmu Team
+ */
+class BookmarkStore
+: public Singleton< BookmarkStore >
+{
+public:
+    /**
+     * @brief Statistics of the store.
+     */
+    struct Stats
+    {
+        Stats() { Reset(); }
+
+        void Reset()
+        {
+            loads = 0;
+            lists = 0;
+            lookups = 0;
+            lookupMisses = 0;
+            deleted = 0;
+            moved = 0;
+        }
+
+        /// Number of characters whose bookmarks were loaded.
+        uint32 loads;
+        /// Number of bookmark lists served from memory.
+        uint32 lists;
+        /// Number of bookmarks found in memory.
+        uint32 lookups;
+        /// Number of bookmarks not found among the own ones, left to the database.
+        uint32 lookupMisses;
+        /// Number of bookmarks deleted.
+        uint32 deleted;
+        /// Number of bookmarks moved between folders.
+        uint32 moved;
+    };
+
+    BookmarkStore();
+
+    /** @return Number of characters whose bookmarks are resident. */
+    size_t size() const { return mBooks.size(); }
+    /** @return Statistics since the last ResetStats(). */
+    const Stats& stats() const { return mStats; }
+    /** @brief Resets the statistics. */
+    void ResetStats() { mStats.Reset(); }
+
+    /**
+     * @brief Lists the bookmarks and folders of a character.
+     *
+     * @return A tuple of the CRowSets of the bookmarks and the folders; NULL on failure.
+     */
+    PyTuple* GetBookmarks( uint32 characterID );
+    /**
+     * @brief Finds a bookmark of a character.
+     *
+     * @return The bookmark; NULL if the character has no such bookmark.
+     */
+    const BookmarkData* Find( uint32 characterID, uint32 bookmarkID );
+
+    /**
+     * @brief Adds a bookmark; its bookmarkID is assigned.
+     *
+     * @return True on success.
+     */
+    bool Add( BookmarkData& bookmark );
+    /**
+     * @brief Changes the memo of a bookmark of a character.
+     *
+     * @return The changed bookmark; NULL on failure.
+     */
+    const BookmarkData* Update( uint32 characterID, uint32 bookmarkID, const std::string& memo );
+    /**
+     * @brief Deletes bookmarks of a character; unknown IDs are skipped.
+     *
+     * @return True on success.
+     */
+    bool Delete( uint32 characterID, const std::vector< uint32 >& bookmarkIDs );
+    /**
+     * @brief Moves bookmarks of a character into a folder; unknown IDs are skipped.
+     *
+     * @param[in] folderID The folder; 0 for none.
+     *
+     * @return True on success.
+     */
+    bool Move( uint32 characterID, const std::vector< uint32 >& bookmarkIDs, uint32 folderID );
+    /**
+     * @brief Deletes a folder of a character along with the bookmarks in it.
+     *
+     * @return True on success.
+     */
+    bool DeleteFolder( uint32 characterID, uint32 folderID );
+
+    /**
+     * @brief Drops the bookmarks of a character logging out.
+     */
+    void Forget( uint32 characterID ) { mBooks.erase( characterID ); }
+
+protected:
+    /**
+     * @brief The bookmarks of a character.
+     */
+    struct Book
+    {
+        /// The bookmarks, by bookmarkID.
+        std::tr1::unordered_map< uint32, BookmarkData > bookmarks;
+        /// bookmarkIDs of the bookmarks in each folder, by folderID; 0 holds those in none.
+        std::map< uint32, std::set< uint32 > > folderIndex;
+        std::vector< BookmarkFolder > folders;
+    };
+
+    /**
+     * @brief Obtains the bookmarks of a character, loading them if needed.
+     *
+     * @return The bookmarks; NULL on failure.
+     */
+    Book* _GetBook( uint32 characterID );
+    /**
+     * @brief Picks the IDs which are bookmarks of a book, without duplicates.
+     */
+    static void _FilterKnown( const Book& book, const std::vector< uint32 >& bookmarkIDs, std::vector< uint32 >& into );
+
+    BookmarkDB mDB;
+
+    /// The bookmarks of the online characters.
+    std::tr1::unordered_map< uint32, Book > mBooks;
+    /// The next free bookmarkID; 0 until it is queried.
+    uint32 mNextID;
+
+    /// Statistics.
+    Stats mStats;
+};
+
+/// A macro for easier access to the singleton.
+#define sBookmarkStore \
+    ( BookmarkStore::get() )
+
+#endif /* !__SYSTEM__BOOKMARK_STORE_H__INCL__ */
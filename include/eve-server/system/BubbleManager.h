@@ -36,10 +36,9 @@ class GPoint;
 //any of the optimized space searching algorithms which we
 // may develop based on bubbles.
 //
-// Right now it is stupid and searches for a bubble using a
-// linear search. obviously a much better spacial partitioning
-// scheme could be written later (octtree or quadtree maybe?)
-// and this would be the place to put it.
+// Bubbles are indexed by a uniform hash grid, the cells of which are
+// large enough for a bubble to overlap at most 2x2x2 of them, so that
+// finding a bubble only needs to look at the bubbles of a single cell.
 class BubbleManager {
 public:
     BubbleManager();
@@ -57,13 +56,40 @@ public:
     void Remove(SystemEntity *ent, bool notify);
     void clear();
 
+    //number of bubbles in the system.
+    size_t GetBubbleCount() const { return m_bubbles.size(); }
+
+    /**
+     * @brief Finds entities within range of a point.
+     *
+     * Only the bubbles near the point are searched, so entities
+     * which have wandered out of their bubble and have not been
+     * moved yet by Process() may be missed.
+     *
+     * @param[in]  center The point.
+     * @param[in]  range  The range (in meters).
+     * @param[out] into   Vector the entities are appended to.
+     */
+    void GetEntitiesInRange(const GPoint &center, double range, std::vector<SystemEntity *> &into) const;
+
 protected:
+    typedef std::tr1::unordered_map<uint64, std::vector<SystemBubble *> > GridMap;
+
     SystemBubble * _FindBubble(const GPoint &pos) const;
 
+    //grid maintenance:
+    void _IndexBubble(SystemBubble *b);
+    void _UnindexBubble(SystemBubble *b);
+    void _DeleteBubble(SystemBubble *b);
+
+    static int32 _GetCell(double coord);
+    static uint64 _GetCellKey(int32 x, int32 y, int32 z);
+
     Timer m_wanderTimer;
 
-    //dumb storage for now:
     std::vector<SystemBubble *> m_bubbles;    //we own these. Dynamic only because I am afraid of copy activities.
+    PointBatch m_centers;    //centers of m_bubbles, in the same order; scanned at once by large queries.
+    GridMap m_grid;    //cell key -> bubbles overlapping the cell, in order of creation.
 };
 
 
@@ -0,0 +1,170 @@
+/*
+    ------------------------------------------------------------------------------------
+    LICENSE:
+    ------------------------------------------------------------------------------------
+    This file is part of EVEmu: EVE Online Server Emulator
+    Copyright 2006 - 2011 The EVEmu Team
+    For the latest information visit http://evemu.org
+    ------------------------------------------------------------------------------------
+    This program is free software; you can redistribute it and/or modify it under
+    the terms of the GNU Lesser General Public License as published by the Free Software
+    Foundation; either version 2 of the License, or (at your option) any later
+    version.
+
+    This program is distributed in the hope that it will be useful, but WITHOUT
+    ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+    FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public License along with
+    this program; if not, write to the Free Software Foundation, Inc., 59 Temple
+    Place - Suite 330, Boston, MA 02111-1307, USA, or go to
+    http://www.gnu.org/copyleft/lesser.txt.
+    ------------------------------------------------------------------------------------
+    Author:     EVEmu Team
+*/
+
+
+#ifndef __SYSTEM__CLUSTER_MAP_H__INCL__
+#define __SYSTEM__CLUSTER_MAP_H__INCL__
+
+#include "utils/Singleton.h"
+
+/**
+ * @brief Assignment of the solar systems to the sol nodes.
+ *
+ * The regions are spread over world.solNodes sol nodes, the biggest
+ * region first to the node owning the fewest solar systems, so every
+ * solar system and station has an owning node. The first node is the
+ * node of the server itself; the others are numbered after it.
+ *
+ * MachoResolveObject answers with the node owning the location in the
+ * bind parameters and the objects bound to a location carry the node
+ * in their bind strings, so the clients address location traffic to
+ * its owning node. All the nodes are hosted by this process for now;
+ * IsLocalNode tells which node IDs it accepts.
+ *
+ * Rebalance moves the busiest solar systems off the busiest node by the
+ * time their ticks took, so a single hot system does not hold a whole
+ * node's regions back. A moved system keeps its new node over the
+ * assignment of its region; the objects bound before stay valid, as
+ * their node is hosted here as well.
+ *
+ * @author EVEmu Team
+ */
+class ClusterMap
+: public Singleton< ClusterMap >
+{
+public:
+    /**
+     * @brief Statistics of the map.
+     */
+    struct Stats
+    {
+        Stats() { Reset(); }
+
+        void Reset()
+        {
+            resolves = 0;
+            remote = 0;
+            migrations = 0;
+        }
+
+        /// Number of locations resolved to their node.
+        uint32 resolves;
+        /// Number of locations resolved to a node other than the server's.
+        uint32 remote;
+        /// Number of solar systems moved to another node.
+        uint32 migrations;
+    };
+
+    ClusterMap();
+
+    /** @return Number of mapped solar systems. */
+    size_t size() const { return mSystemRegions.size(); }
+    /** @return Number of sol nodes. */
+    uint32 GetNodeCount() const { return mNodeCount; }
+    /** @return Statistics since the last ResetStats(). */
+    const Stats& stats() const { return mStats; }
+    /** @brief Resets the statistics. */
+    void ResetStats() { mStats.Reset(); }
+
+    /**
+     * @brief Loads the solar systems and stations and assigns the regions.
+     *
+     * @param[in] nodeID    Node of the server, which is the first sol node.
+     * @param[in] nodeCount Number of sol nodes.
+     *
+     * @return True on success.
+     */
+    bool Load( uint32 nodeID, uint32 nodeCount );
+
+    /**
+     * @brief Finds the node owning a location.
+     *
+     * @param[in] locationID A region, solar system or station.
+     *
+     * @return The owning node; the server's node for other locations.
+     */
+    uint32 GetNodeID( uint32 locationID );
+    /**
+     * @brief Finds the node owning the location of bind parameters.
+     *
+     * @param[in] bindParams A locationID, or a tuple starting with one.
+     *
+     * @return The owning node; the server's node for other parameters.
+     */
+    uint32 GetNodeID( const PyRep* bindParams );
+    /**
+     * @return Whether the node is hosted by this process.
+     */
+    bool IsLocalNode( uint32 nodeID ) const { return nodeID - mNodeID < mNodeCount; }
+
+    /**
+     * @brief Counts the solar systems owned by every node.
+     *
+     * @param[out] into Solar system count by node.
+     */
+    void GetNodeLoad( std::map<uint32, uint32>& into ) const;
+
+    /**
+     * @brief Moves a busy solar system to the least busy node.
+     *
+     * The busiest system of the busiest node is moved if that lowers
+     * the time of the busiest node; at most one system per call, so
+     * the nodes settle over a few calls instead of swinging.
+     *
+     * @param[in] systemTimes Time (in microseconds) the systems took, by solarSystemID.
+     *
+     * @return The moved solar system; 0 if none.
+     */
+    uint32 Rebalance( const std::map<uint32, uint64>& systemTimes );
+
+protected:
+    /**
+     * @brief Finds the node owning a solar system, without stats.
+     */
+    uint32 _GetSystemNode( uint32 solarSystemID ) const;
+
+    /// Node of the server; the first sol node.
+    uint32 mNodeID;
+    /// Number of sol nodes.
+    uint32 mNodeCount;
+
+    /// Regions of the solar systems, by solarSystemID.
+    std::tr1::unordered_map< uint32, uint32 > mSystemRegions;
+    /// Solar systems of the stations, by stationID.
+    std::tr1::unordered_map< uint32, uint32 > mStationSystems;
+    /// Owning nodes of the regions, by regionID.
+    std::tr1::unordered_map< uint32, uint32 > mRegionNodes;
+    /// Owning nodes of the moved solar systems, by solarSystemID.
+    std::tr1::unordered_map< uint32, uint32 > mSystemNodes;
+
+    /// Statistics.
+    Stats mStats;
+};
+
+/// A macro for easier access to the singleton.
+#define sClusterMap \
+    ( ClusterMap::get() )
+
+#endif /* !__SYSTEM__CLUSTER_MAP_H__INCL__ */
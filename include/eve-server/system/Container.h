@@ -161,6 +161,12 @@ public:
         PyServiceMgr &services,
         const GPoint &position);
 
+    /**
+     * @brief Allocates containers from ObjectPool; jettisons and dungeons come and go in batches.
+     */
+    static void* operator new( size_t size ) { return ObjectPool< ContainerEntity >::Allocate( size ); }
+    static void operator delete( void* p, size_t size ) { ObjectPool< ContainerEntity >::Free( p, size ); }
+
     /*
      * Primary public interface:
      */
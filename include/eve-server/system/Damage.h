@@ -46,6 +46,13 @@ public:
             EVEEffectID _effect );
 
     ~Damage();
+
+    /**
+     * @brief Allocates damages from ObjectPool; fatal blows are queued on the heap.
+     */
+    static void* operator new( size_t size ) { return ObjectPool< Damage >::Allocate( size ); }
+    static void operator delete( void* p, size_t size ) { ObjectPool< Damage >::Free( p, size ); }
+
     double GetTotal() const { return ( kinetic + thermal + em + explosive ); }
     Damage MultiplyDup( double _kinetic_multiplier,
                         double _thermal_multiplier,
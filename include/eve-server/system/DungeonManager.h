@@ -0,0 +1,249 @@
+/*
+    ------------------------------------------------------------------------------------
+    LICENSE:
+    ------------------------------------------------------------------------------------
+    This file is part of EVEmu: EVE Online Server Emulator
+    Copyright 2006 - 2011 The EVEmu Team
+    For the latest information visit http://evemu.org
+    ------------------------------------------------------------------------------------
+    This program is free software; you can redistribute it and/or modify it under
+    the terms of the GNU Lesser General Public License as published by the Free Software
+    Foundation; either version 2 of the License, or (at your option) any later
+    version.
+
+    This program is distributed in the hope that it will be useful, but WITHOUT
+    ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+    FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public License along with
+    this program; if not, write to the Free Software Foundation, Inc., 59 Temple
+    Place - Suite 330, Boston, MA 02111-1307, USA, or go to
+    http://www.gnu.org/copyleft/lesser.txt.
+    ------------------------------------------------------------------------------------
+    Author:     EVEmu Team
+*/
+
+
+#ifndef __SYSTEM__DUNGEON_MANAGER_H__INCL__
+#define __SYSTEM__DUNGEON_MANAGER_H__INCL__
+
+#include "inventory/ItemRef.h"
+#include "utils/Singleton.h"
+
+class NPC;
+class PyServiceMgr;
+class SystemEntity;
+class SystemManager;
+
+/**
+ * @brief Immutable blueprint of a dungeon, parsed once from the templates.
+ */
+struct DungeonBlueprint
+{
+    enum ObjectKind
+    {
+        OBJECT_NPC_GROUP = 0,
+        OBJECT_CONTAINER = 1,
+        OBJECT_STRUCTURE = 2
+    };
+
+    /**
+     * @brief An NPC of an NPC group.
+     */
+    struct NPCEntry
+    {
+        uint32 npcTypeID;
+        uint8 quantity;
+        float probability;
+        uint32 ownerID;
+        uint32 corporationID;
+    };
+
+    /**
+     * @brief An object of the dungeon.
+     */
+    struct Object
+    {
+        uint8 kind;
+        uint32 typeID;
+        uint32 ownerID;
+        std::string itemName;
+        /// Position relative to the origin of the dungeon.
+        GPoint offset;
+        /// The NPCs of an NPC group.
+        std::vector< NPCEntry > npcs;
+    };
+
+    uint32 dungeonID;
+    std::string dungeonName;
+    uint32 factionID;
+    std::vector< Object > objects;
+};
+
+/**
+ * @brief A spawned dungeon.
+ */
+class DungeonInstance
+{
+public:
+    DungeonInstance( uint32 instanceID, const DungeonBlueprint& blueprint, SystemManager& system, uint32 pocket, const GPoint& origin );
+
+    uint32 GetID() const { return mInstanceID; }
+    const DungeonBlueprint& GetBlueprint() const { return mBlueprint; }
+    SystemManager& GetSystem() const { return mSystem; }
+    uint32 GetPocket() const { return mPocket; }
+    const GPoint& GetOrigin() const { return mOrigin; }
+    /** @return Number of spawned entities, including the killed ones. */
+    size_t size() const { return mEntities.size(); }
+
+    /**
+     * @brief Spawns the objects of the blueprint into the system.
+     *
+     * @return Number of spawned entities.
+     */
+    size_t Spawn( PyServiceMgr& services );
+    /**
+     * @brief Removes the entities which are still in the system and deletes the items of all of them.
+     */
+    void Teardown();
+    /**
+     * @brief Collects the NPCs which are still in the system.
+     */
+    void GetNPCs( std::vector< NPC* >& into ) const;
+
+protected:
+    /**
+     * @brief A spawned entity.
+     */
+    struct Entity
+    {
+        SystemEntity* entity;
+        InventoryItemRef item;
+    };
+
+    /** @brief Adds a spawned entity to the system. */
+    void _Add( SystemEntity* entity, InventoryItemRef item );
+
+    const uint32 mInstanceID;
+    const DungeonBlueprint& mBlueprint;
+    SystemManager& mSystem;
+    const uint32 mPocket;
+    const GPoint mOrigin;
+
+    std::vector< Entity > mEntities;
+};
+
+/**
+ * @brief Blueprints of the dungeons and their live instances.
+ *
+ * The dungeon templates (dunTemplates, dunTemplateObjects and the
+ * spawnGroupEntries of their NPC groups) are parsed once at startup
+ * into immutable blueprints, so instancing a dungeon queries nothing.
+ *
+ * Every instance is spawned into a deadspace pocket of its solar
+ * system: a point far away from the celestials, a few bubbles apart
+ * from the other pockets, so each instance has a bubble of its own.
+ * The entities come from ObjectPool (see NPC, ContainerEntity and
+ * StructureEntity), and tearing an instance down just returns them
+ * and frees its pocket.
+ *
+ * Not thread-safe; meant to be used from the main loop.
+ *
+ * @author EVEmu Team
+ */
+class DungeonManager
+: public Singleton< DungeonManager >
+{
+public:
+    /// Distance of the pockets from the sun.
+    static const double POCKET_DISTANCE;
+    /// Distance between two pockets.
+    static const double POCKET_SPACING;
+
+    /**
+     * @brief Statistics of the manager.
+     */
+    struct Stats
+    {
+        Stats() { Reset(); }
+
+        void Reset()
+        {
+            instances = 0;
+            entities = 0;
+            teardowns = 0;
+        }
+
+        /// Number of spawned instances.
+        uint32 instances;
+        /// Number of spawned entities.
+        uint32 entities;
+        /// Number of torn down instances.
+        uint32 teardowns;
+    };
+
+    DungeonManager();
+    ~DungeonManager();
+
+    /** @return Number of blueprints. */
+    size_t size() const { return mBlueprints.size(); }
+    /** @return Number of live instances. */
+    size_t GetInstanceCount() const { return mInstances.size(); }
+    /** @return Statistics since the last ResetStats(). */
+    const Stats& stats() const { return mStats; }
+    /** @brief Resets the statistics. */
+    void ResetStats() { mStats.Reset(); }
+
+    /**
+     * @brief Loads the dungeon templates.
+     *
+     * @return True on success.
+     */
+    bool Load();
+
+    /** @return The blueprint; NULL if there is no such dungeon. */
+    const DungeonBlueprint* GetBlueprint( uint32 dungeonID ) const;
+    /** @return The blueprints, by dungeonID. */
+    const std::map< uint32, DungeonBlueprint >& GetBlueprints() const { return mBlueprints; }
+    /** @return The instance; NULL if there is no such instance. */
+    DungeonInstance* GetInstance( uint32 instanceID ) const;
+
+    /**
+     * @brief Spawns an instance of a dungeon into a free pocket of the system.
+     *
+     * @return The instance; NULL if there is no such dungeon.
+     */
+    DungeonInstance* Instantiate( uint32 dungeonID, SystemManager& system, PyServiceMgr& services );
+    /**
+     * @brief Tears an instance down and frees its pocket.
+     *
+     * @return False if there is no such instance.
+     */
+    bool Teardown( uint32 instanceID );
+    /**
+     * @brief Tears down all the instances in the system; for systems being unloaded.
+     */
+    void TeardownSystem( uint32 solarSystemID );
+
+protected:
+    /** @return Position of a pocket. */
+    static GPoint _GetPocketOrigin( uint32 pocket );
+
+    /// The blueprints, by dungeonID.
+    std::map< uint32, DungeonBlueprint > mBlueprints;
+
+    /// The live instances, by instanceID.
+    std::map< uint32, DungeonInstance* > mInstances;
+    /// The used pockets, by solarSystemID.
+    std::map< uint32, std::set< uint32 > > mPockets;
+    uint32 mNextInstanceID;
+
+    /// Statistics.
+    Stats mStats;
+};
+
+/// A macro for easier access to the singleton.
+#define sDungeonManager \
+    ( DungeonManager::get() )
+
+#endif /* !__SYSTEM__DUNGEON_MANAGER_H__INCL__ */
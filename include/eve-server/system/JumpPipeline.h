@@ -0,0 +1,152 @@
+/*
+    ------------------------------------------------------------------------------------
+    LICENSE:
+    ------------------------------------------------------------------------------------
+    This file is part of EVEmu: EVE Online Server Emulator
+    Copyright 2006 - 2011 The EVEmu Team
+    For the latest information visit http://evemu.org
+    ------------------------------------------------------------------------------------
+    This program is free software; you can redistribute it and/or modify it under
+    the terms of the GNU Lesser General Public License as published by the Free Software
+    Foundation; either version 2 of the License, or (at your option) any later
+    version.
+
+    This program is distributed in the hope that it will be useful, but WITHOUT
+    ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+    FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public License along with
+    this program; if not, write to the Free Software Foundation, Inc., 59 Temple
+    Place - Suite 330, Boston, MA 02111-1307, USA, or go to
+    http://www.gnu.org/copyleft/lesser.txt.
+    ------------------------------------------------------------------------------------
+    Author:     EVEmu Team
+*/
+
+
+#ifndef __SYSTEM__JUMP_PIPELINE_H__INCL__
+#define __SYSTEM__JUMP_PIPELINE_H__INCL__
+
+#include "utils/Singleton.h"
+
+class Client;
+
+/**
+ * @brief Moves the pilots through the stargates in batches.
+ *
+ * A gate jump goes through:
+ *  - start: the destination is booted right away (usually out of the
+ *    state the SystemPreloader prepared for the neighbours), while the
+ *    pilot watches the JumpOut animation; a jump into a system which
+ *    fails to boot does not start at all;
+ *  - arrival: at the first destiny tic after the animation is over,
+ *    everybody who jumped through the same gate during the same tic
+ *    arrives at once: the ships are moved and entered into the
+ *    system, the locations of the characters are saved by a single
+ *    statement and only then the session changes are sent.
+ *
+ * The arrivals of a batch land in the same bubble, so they share
+ * their SetState (see SystemManager::MakeSetState).
+ *
+ * Not thread-safe; meant to be used from the main loop.
+ *
+ * @author EVEmu Team
+ */
+class JumpPipeline
+: public Singleton< JumpPipeline >
+{
+public:
+    /**
+     * @brief Statistics of the jumps.
+     */
+    struct Stats
+    {
+        Stats() { Reset(); }
+
+        void Reset()
+        {
+            started = 0;
+            failed = 0;
+            arrived = 0;
+            cancelled = 0;
+            boots = 0;
+            batches = 0;
+            maxBatch = 0;
+        }
+
+        /// Number of jumps started.
+        uint32 started;
+        /// Number of jumps which did not start as the destination failed to boot.
+        uint32 failed;
+        /// Number of pilots moved through a gate.
+        uint32 arrived;
+        /// Number of jumps dropped as their client left.
+        uint32 cancelled;
+        /// Number of destinations booted by a jump.
+        uint32 boots;
+        /// Number of batches moved.
+        uint32 batches;
+        /// Number of pilots in the largest batch.
+        uint32 maxBatch;
+    };
+
+    JumpPipeline();
+
+    /** @return Number of jumps in flight. */
+    size_t size() const { return mSize; }
+    /** @return Statistics since the last ResetStats(). */
+    const Stats& stats() const { return mStats; }
+    /** @brief Resets the statistics. */
+    void ResetStats() { mStats.Reset(); }
+
+    /**
+     * @brief Starts a jump through a stargate, booting the destination.
+     *
+     * @param[in] client          The jumping client.
+     * @param[in] toGate          The stargate it arrives at.
+     * @param[in] solarSystemID   Solar system of the stargate.
+     * @param[in] constellationID Constellation of the stargate.
+     * @param[in] regionID        Region of the stargate.
+     *
+     * @return False if the destination failed to boot.
+     */
+    bool Start( Client* client, uint32 toGate, uint32 solarSystemID, uint32 constellationID, uint32 regionID );
+    /**
+     * @brief Drops the jump of a client which is going away.
+     */
+    void Cancel( Client* client );
+
+    /**
+     * @brief Moves the batches which are due.
+     *
+     * Must be called periodically by the game thread.
+     */
+    void Process();
+
+protected:
+    /**
+     * @brief The jumps through a gate which arrive together.
+     */
+    struct Batch
+    {
+        uint32 solarSystemID;
+        uint32 constellationID;
+        uint32 regionID;
+
+        std::vector< Client* > clients;
+    };
+
+    /// The batches, by the destiny stamp they are due at and the gate.
+    std::map< std::pair< uint32, uint32 >, Batch > mBatches;
+    /// Number of jumps in flight.
+    size_t mSize;
+
+    /// Statistics.
+    Stats mStats;
+};
+
+/// A macro for easier access to the singleton.
+#define sJumpPipeline \
+    ( JumpPipeline::get() )
+
+#endif /* !__SYSTEM__JUMP_PIPELINE_H__INCL__ */
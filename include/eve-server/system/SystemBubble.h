@@ -26,20 +26,50 @@
 #define __SYSTEMBUBBLE_H_INCL__
 
 class SystemEntity;
+class PyList;
+class PyRep;
 class PyTuple;
 class DoDestiny_SetState;
 
+/**
+ * @brief Encoded state of a single ball, as it goes into SetState and AddBalls.
+ *
+ * Everybody gets a reference to the same slim item and damage state,
+ * so they are read-only.
+ */
+class EncodedBall {
+public:
+    EncodedBall(const SystemEntity &ent, uint32 stamp);
+    ~EncodedBall();
+
+    //appends the ball to the destiny binary, slim items and damage states.
+    void AppendTo(Buffer &destiny, PyList &slims, std::map<int32, PyRep *> &damages) const;
+
+    const uint32 id;
+    const uint32 stamp;    //destiny stamp the ball has been encoded at.
+
+protected:
+    Buffer m_destiny;
+    PyRep *m_slim;    //we own this.
+    PyRep *m_damage;    //we own this.
+};
+
 class SystemBubble {
 public:
     SystemBubble(const GPoint &center, double radius);
-    ~SystemBubble() { m_bubbleID--; };
+    ~SystemBubble();
+
+    //accounted to the "systems" MemoryTag, see SystemManager.
+    static void* operator new( size_t size );
+    static void operator delete( void* p, size_t size );
 
 
     const GPoint m_center;
     const double m_radius;
 
-    void BubblecastDestiny(std::vector<PyTuple *> &updates, std::vector<PyTuple *> &events, const char *desc) const;
-    void BubblecastDestinyUpdate(PyTuple **payload, const char *desc) const;
+    //about is the ball the updates are about, if any; clients budget the updates about other balls.
+    void BubblecastDestiny(std::vector<PyTuple *> &updates, std::vector<PyTuple *> &events, const char *desc, const SystemEntity *about = NULL) const;
+    void BubblecastDestinyUpdate(PyTuple **payload, const char *desc, const SystemEntity *about = NULL) const;
     void BubblecastDestinyEvent(PyTuple **payload, const char *desc) const;
 
     bool ProcessWander(std::vector<SystemEntity *> &wanderers);
@@ -49,9 +79,15 @@ public:
     void clear();
     bool IsEmpty() const { return(m_entities.empty()); }
     void GetEntities(std::set<SystemEntity *> &into) const;
-    uint32 GetBubbleID() { return m_bubbleID; };
+    //appends the entities closer than sqrt(range2) to center.
+    void GetEntitiesInRange(const GPoint &center, double range2, std::vector<SystemEntity *> &into) const;
+    uint32 GetBubbleID() const { return m_bubbleID; };
+    //changes whenever an entity enters or leaves the bubble.
+    uint32 GetRevision() const { return m_revision; }
 
-    //void AppendBalls(DoDestiny_SetState &ss, std::vector<uint8> &setstate_buffer) const;
+    //appends the balls of the entities which are not visible system wide.
+    //the dynamic ones are encoded once per destiny stamp, the static ones only once.
+    void AppendBalls(Buffer &destiny, PyList &slims, std::map<int32, PyRep *> &damages) const;
 
     bool InBubble(const GPoint &pt) const;
 
@@ -65,8 +101,10 @@ protected:
     const double m_position_check_radius_sqrd;  // (radius + BUBBLE_HYSTERESIS_METERS) squared
     static uint32 m_bubbleIncrementer;
     uint32 m_bubbleID;
+    uint32 m_revision;
     std::map<uint32, SystemEntity *> m_entities;    //we do not own these.
     std::set<SystemEntity *> m_dynamicEntities;    //entities which may move. we do not own these.
+    mutable std::map<uint32, EncodedBall *> m_encodedBalls;    //by entity ID, we own these.
 };
 
 
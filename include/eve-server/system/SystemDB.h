@@ -57,16 +57,63 @@ public:
     double z;
 };
 
+class DBSystemJump {
+public:
+    uint32 stargateID;
+    uint32 toCelestialID;
+    uint32 toSystemID;  //0 if the destination is unknown
+};
+
+/**
+ * @brief Everything booting a system loads from the database.
+ *
+ * Holds plain data only, so it may be loaded by a worker thread
+ * and handed to the game thread later (see SystemPreloader).
+ */
+class DBSystemState {
+public:
+    DBSystemState() : systemID(0) {}
+
+    /**
+     * @brief Gets the systems the stargates of this one lead to.
+     *
+     * @param[out] into The systems.
+     */
+    void GetNeighbours(std::set<uint32> &into) const;
+
+    uint32 systemID;
+    std::string name;
+    std::string security;
+    std::vector<DBSystemEntity> celestials;
+    std::vector<DBSystemDynamicEntity> dynamics;
+    std::vector<DBSystemJump> jumps;    //of all the stargates in the system, ordered by stargateID
+};
+
 class SystemDB
 : public ServiceDB
 {
 public:
+    /**
+     * @brief Loads everything needed to boot a system.
+     *
+     * Only queries through sDatabase, so it may be called from
+     * any thread.
+     *
+     * @param[in]  systemID The system.
+     * @param[out] into     The loaded state.
+     *
+     * @return False if any of the queries failed.
+     */
+    bool LoadSystemState(uint32 systemID, DBSystemState &into);
+
     bool LoadSystemEntities(uint32 systemID, std::vector<DBSystemEntity> &into);
     bool LoadSystemDynamicEntities(uint32 systemID, std::vector<DBSystemDynamicEntity> &into);
+    bool LoadSystemJumps(uint32 systemID, std::vector<DBSystemJump> &into);
     static uint32 GetObjectLocationID( uint32 itemID );
 
     PyObject *ListFactions();
-    PyObject *ListJumps(uint32 stargateID);
+    //builds the rowset of the jumps of the stargate out of the jumps of its system:
+    static PyObject *ListJumps(const std::vector<DBSystemJump> &jumps, uint32 stargateID);
 
 protected:
 };
@@ -71,7 +71,8 @@ public:
 
     static SimpleSystemEntity *MakeEntity(SystemManager *system, const DBSystemEntity &entity);
 
-    virtual bool LoadExtras(SystemDB *db);
+    //takes whatever else the entity needs out of the state of its system:
+    virtual bool LoadExtras(const DBSystemState &state);
 
     //some of these are generic enough..
     virtual PyDict *MakeSlimItem() const;
@@ -108,7 +109,7 @@ public:
     SystemStargateEntity(SystemManager *system, const DBSystemEntity &entity);
     virtual ~SystemStargateEntity();
 
-    virtual bool LoadExtras(SystemDB *db);
+    virtual bool LoadExtras(const DBSystemState &state);
     virtual PyDict *MakeSlimItem() const;
 
 protected:
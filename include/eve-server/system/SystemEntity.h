@@ -71,6 +71,8 @@ public:
 
     virtual void Process();
     virtual void ProcessDestiny() = 0;
+    //whether Process() does anything; the others are not ticked by their system.
+    virtual bool IsTicked() const { return false; }
 
     //this is a bit crude, but I prefer this over RTTI.
     virtual EntityClass GetClass() const { return(ecOther); }
@@ -159,8 +161,26 @@ public:
 protected:
     InventoryItemRef m_self;
 
+    //damage resonances of our item; read once per destiny stamp rather than for every hit.
+    struct DamageResonances {
+        //indexed kinetic, thermal, em, explosive; as Damage::MultiplyDup takes them.
+        double shield[4];
+        double armor[4];
+        double hull[4];
+    };
+    const DamageResonances &_GetDamageResonances() const;
+
+    //shield charge as seen by the damage code; ships compute it from their recharge state.
+    virtual double _GetShieldCharge() const;
+    virtual void _SetShieldCharge(double charge);
+
     void _SendDamageStateChanged() const;
     void _SetSelf(InventoryItemRef self);
+
+private:
+    mutable DamageResonances m_resonances;
+    mutable uint32 m_resonancesStamp;
+    mutable bool m_resonancesValid;
 };
 
 
@@ -173,6 +193,8 @@ public:
 
     //partial implementation of SystemEntity interface:
     virtual void ProcessDestiny();
+    //whether ProcessDestiny() would do nothing this tic.
+    bool IsDestinyIdle() const;
     virtual const GPoint &GetPosition() const;
     virtual const GVector &GetVelocity() const;
     virtual void EncodeDestiny( Buffer& into ) const;
@@ -41,11 +41,16 @@ class Client;
 class NPC;
 class InventoryItem;
 class SystemEntity;
+class DynamicSystemEntity;
 class SystemBubble;
+class Damage;
+class EncodedBall;
 class DoDestiny_SetState;
 
 
 class SpawnManager;
+class AsteroidBeltManager;
+class DroneSwarmManager;
 class PyServiceMgr;
 
 class SystemManager
@@ -53,9 +58,53 @@ class SystemManager
 //  public InventoryItem
 {
 public:
+    /**
+     * @brief Timing of the ticks of the system.
+     */
+    struct TickStats
+    {
+        TickStats() { Reset(); }
+
+        void Reset()
+        {
+            ticks = 0;
+            tickTime = 0;
+            maxTickTime = 0;
+            destinyTicks = 0;
+            destinyTime = 0;
+            maxDestinyTime = 0;
+            aiThinks = 0;
+            aiTime = 0;
+        }
+
+        /// Number of Process() calls.
+        uint32 ticks;
+        /// Total time (in microseconds) spent in Process().
+        uint64 tickTime;
+        /// Longest Process() call (in microseconds).
+        uint32 maxTickTime;
+        /// Number of ProcessDestiny() calls.
+        uint32 destinyTicks;
+        /// Total time (in microseconds) spent in ProcessDestiny().
+        uint64 destinyTime;
+        /// Longest ProcessDestiny() call (in microseconds).
+        uint32 maxDestinyTime;
+        /// Number of times an NPC's AI thought.
+        uint32 aiThinks;
+        /// Total time (in microseconds) the AI spent thinking; part of tickTime.
+        uint64 aiTime;
+    };
+
     SystemManager(uint32 systemID, PyServiceMgr &svc);//, ItemData idata);
     virtual ~SystemManager();
 
+    /**
+     * @brief Accounts the booted systems to the "systems" MemoryTag, along with their bubbles.
+     */
+    static void* operator new( size_t size ) { return sMemoryTag.Allocate( size ); }
+    static void operator delete( void* p, size_t size ) { sMemoryTag.Free( p, size ); }
+    static MemoryTag sMemoryTag;
+
     //bubble stuff:
     BubbleManager bubbles;
 
@@ -63,11 +112,29 @@ public:
     const std::string &GetName() const { return(m_systemName); }
     double GetWarpSpeed() const;
 
+    /**
+     * @brief Loads the system from the database and boots it.
+     */
     bool BootSystem();
+    /**
+     * @brief Boots the system out of its state loaded already.
+     *
+     * @param[in] state The state, usually prepared by SystemPreloader.
+     */
+    bool BootSystem(const DBSystemState &state);
+
+    /** @return The systems the stargates of this one lead to; empty until booted. */
+    const std::set<uint32> &GetNeighbours() const { return(m_neighbours); }
 
     bool Process();
     void ProcessDestiny();    //called once for each destiny second.
 
+    /** @return Timing of the ticks since the last ResetTickStats(). */
+    const TickStats &tickStats() const { return(m_tickStats); }
+    void ResetTickStats() { m_tickStats.Reset(); }
+    //accounts a single think of an NPC's AI which took given time (in microseconds).
+    void AddAIThink(uint32 elapsed) { ++m_tickStats.aiThinks; m_tickStats.aiTime += elapsed; }
+
     bool BuildDynamicEntity(Client *who, const DBSystemDynamicEntity &entity);
 
     void AddClient(Client *who);
@@ -79,6 +146,13 @@ public:
 
     SystemEntity *get(uint32 entityID) const;
 
+    //hits are resolved as they come, but their consequences are batched:
+    //sends the damage state of the entity once at the end of the destiny tic.
+    void MarkDamageStateChanged(SystemEntity *who) { m_damageStateChanged.insert(who->GetID()); }
+    //kills the entity once all its system's entities have been processed.
+    void QueueKill(SystemEntity *who, const Damage &fatal_blow);
+    bool IsKillPending(uint32 entityID) const { return(m_pendingKills.find(entityID) != m_pendingKills.end()); }
+
     void MakeSetState(const SystemBubble *bubble, DoDestiny_SetState &into) const;
 
     SystemDB *GetSystemDB() { return(&m_db); }
@@ -87,6 +161,8 @@ public:
     ItemFactory &itemFactory() const;
 
     PyServiceMgr * GetServiceMgr() { return &m_services; }
+    AsteroidBeltManager &belts() const { return(*m_beltManager); }
+    DroneSwarmManager &drones() const { return(*m_droneManager); }
 
     void AddItemToInventory(InventoryItemRef item);
     ShipRef GetShipFromInventory(uint32 shipID);
@@ -101,20 +177,64 @@ protected:
     // Solar System Dynamic Inventory manager:
     SolarSystemRef m_solarSystemRef;    // we do not own this
 
-    bool _LoadSystemCelestials();
-    bool _LoadSystemDynamics();
+    bool _LoadSystemCelestials(const DBSystemState &state);
+    bool _LoadSystemDynamics(const DBSystemState &state);
 
     const uint32 m_systemID;
     std::string m_systemName;
     std::string m_systemSecurity;
+    std::set<uint32> m_neighbours;
 
     SystemDB m_db;
     PyServiceMgr &m_services;    //we do not own this
     SpawnManager *m_spawnManager;    //we own this, never NULL, dynamic to keep the knowledge down.
-
-    //overall system entity lists:
+    AsteroidBeltManager *m_beltManager;    //we own this, never NULL, dynamic to keep the knowledge down.
+    DroneSwarmManager *m_droneManager;    //we own this, never NULL
+
+    //overall system entity lists; we own the entities, but they are also referenced in m_bubbles.
+    //the dynamic entities sit densely in m_dynamicEntities, which the tics walk in order; the
+    //static ones (celestials, stations, gates, asteroids) in m_staticEntities, which is never ticked.
+    //a removal moves the last entity of its list into the hole.
+    struct EntitySlot {
+        SystemEntity *entity;
+        DynamicSystemEntity *mover;    //NULL for static entities.
+        bool ticked;    //whether its Process() does anything.
+        uint32 tickStamp;    //the Process() and ProcessDestiny() which visited it last.
+        uint32 destinyStamp;
+    };
+    struct EntityRef {
+        SystemEntity *entity;
+        bool isStatic;
+        uint32 slot;    //index into m_dynamicEntities or m_staticEntities.
+    };
+    void _InsertEntity(SystemEntity *who);
+    bool _EraseEntity(uint32 entityID);
     bool m_entityChanged;
-    std::map<uint32, SystemEntity *> m_entities;    //we own these, but they are also referenced in m_bubbles
+    std::vector<EntitySlot> m_dynamicEntities;
+    std::vector<SystemEntity *> m_staticEntities;
+    std::tr1::unordered_map<uint32, EntityRef> m_entityIndex;    //by entity ID.
+    uint32 m_tickStamp;    //counts the Process() calls, so a restarted walk skips whom it visited.
+    uint32 m_destinyStamp;    //likewise for ProcessDestiny().
+
+    //encoded balls of the static entities visible system wide (celestials, stations, gates), see MakeSetState.
+    void _ClearStaticBalls() const;
+    mutable std::vector<EncodedBall *> m_staticBalls;    //we own these.
+    mutable bool m_staticBallsStale;
+
+    //the SetState made for each bubble, shared by everybody getting one for the
+    //bubble during the same stamp (such as a fleet arriving through a gate), see MakeSetState.
+    struct SharedSetState;
+    void _ClearSharedSetStates() const;
+    mutable std::map<uint32, SharedSetState *> m_sharedSetStates;    //by bubble ID, we own these.
+    mutable uint32 m_sharedSetStateStamp;
+    uint32 m_entityRevision;    //changes whenever an entity is added or removed.
+
+    TickStats m_tickStats;
+
+    void _SendDamageStates();
+    void _ResolveKills();
+    std::set<uint32> m_damageStateChanged;    //entity IDs.
+    std::map<uint32, Damage *> m_pendingKills;    //fatal blows by entity ID, we own these.
 };
 
 
@@ -0,0 +1,153 @@
+/*
+    ------------------------------------------------------------------------------------
+    LICENSE:
+    ------------------------------------------------------------------------------------
+    This file is part of EVEmu: EVE Online Server Emulator
+    Copyright 2006 - 2011 The EVEmu Team
+    For the latest information visit http://evemu.org
+    ------------------------------------------------------------------------------------
+    This program is free software; you can redistribute it and/or modify it under
+    the terms of the GNU Lesser General Public License as published by the Free Software
+    Foundation; either version 2 of the License, or (at your option) any later
+    version.
+
+    This program is distributed in the hope that it will be useful, but WITHOUT
+    ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+    FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public License along with
+    this program; if not, write to the Free Software Foundation, Inc., 59 Temple
+    Place - Suite 330, Boston, MA 02111-1307, USA, or go to
+    http://www.gnu.org/copyleft/lesser.txt.
+    ------------------------------------------------------------------------------------
+    Author:     EVEmu Team
+*/
+
+#ifndef __SYSTEMPRELOADER_H_INCL__
+#define __SYSTEMPRELOADER_H_INCL__
+
+class DBSystemState;
+
+/**
+ * @brief Loads the state of solar systems before anybody enters them.
+ *
+ * The queries of a system (celestials, dynamic entities, stargate
+ * jumps) are run by sDBAsync's worker threads into a DBSystemState;
+ * the finished states are kept until the system gets booted, so
+ * the game thread only builds the entities and never waits for
+ * the database. States not taken are dropped, oldest first, once
+ * there are more than the limit.
+ *
+ * Must be used by the game thread only.
+ *
+ * @author EVEmu Team
+ */
+class SystemPreloader
+{
+public:
+    /**
+     * @brief Statistics of the preloads.
+     */
+    struct Stats
+    {
+        Stats() { Reset(); }
+
+        void Reset()
+        {
+            requested = 0;
+            loaded = 0;
+            failed = 0;
+            hits = 0;
+            misses = 0;
+            dropped = 0;
+            loadTime = 0;
+        }
+
+        /// Number of preloads started.
+        uint32 requested;
+        /// Number of states loaded.
+        uint32 loaded;
+        /// Number of preloads which failed.
+        uint32 failed;
+        /// Number of boots served by a loaded state.
+        uint32 hits;
+        /// Number of boots which had to load the state themselves.
+        uint32 misses;
+        /// Number of states dropped unused (over the limit or too late).
+        uint32 dropped;
+        /// Time (in milliseconds) the worker threads spent loading.
+        uint32 loadTime;
+    };
+
+    /**
+     * @brief Creates preloader keeping no states.
+     */
+    SystemPreloader();
+    /**
+     * @brief Drops the loaded states.
+     */
+    ~SystemPreloader();
+
+    /** @return Number of loaded states. */
+    size_t GetReadyCount() const { return m_ready.size(); }
+    /** @return Number of preloads being run. */
+    size_t GetPendingCount() const { return m_pending.size(); }
+    /** @return True if the state of the system is being loaded. */
+    bool IsPending(uint32 systemID) const { return m_pending.find(systemID) != m_pending.end(); }
+    /** @return Statistics since the last ResetStats(). */
+    const Stats &stats() const { return m_stats; }
+
+    /**
+     * @brief Sets the most states kept at once.
+     *
+     * @param[in] limit The limit; 0 disables preloading.
+     */
+    void SetLimit(uint32 limit);
+
+    /**
+     * @brief Starts loading the state of a system.
+     *
+     * Does nothing if the system is being loaded or loaded already.
+     *
+     * @param[in] systemID The system.
+     */
+    void Preload(uint32 systemID);
+
+    /**
+     * @brief Takes the loaded state of a system which is about to be booted.
+     *
+     * A preload still being run is forgotten, since the caller will
+     * load the state itself.
+     *
+     * @param[in] systemID The system.
+     *
+     * @return The state, which the caller owns; NULL if not loaded.
+     */
+    DBSystemState *Take(uint32 systemID);
+
+    /**
+     * @brief Resets the statistics.
+     */
+    void ResetStats() { m_stats.Reset(); }
+
+protected:
+    class PreloadQuery;
+    void _Complete(PreloadQuery &query, bool success);
+    /** Drops the oldest states above the limit. */
+    void _Trim();
+
+    /// The most states kept at once.
+    uint32 m_limit;
+
+    /// Systems being loaded.
+    std::set<uint32> m_pending;
+    /// Loaded states, by system; we own these.
+    std::map<uint32, DBSystemState *> m_ready;
+    /// Systems of m_ready, oldest first.
+    std::deque<uint32> m_readyOrder;
+
+    /// Statistics.
+    Stats m_stats;
+};
+
+#endif /* !__SYSTEMPRELOADER_H_INCL__ */
@@ -0,0 +1,84 @@
+/*
+    ------------------------------------------------------------------------------------
+    LICENSE:
+    ------------------------------------------------------------------------------------
+    This file is part of EVEmu: EVE Online Server Emulator
+    Copyright 2006 - 2011 The EVEmu Team
+    For the latest information visit http://evemu.org
+    ------------------------------------------------------------------------------------
+    This program is free software; you can redistribute it and/or modify it under
+    the terms of the GNU Lesser General Public License as published by the Free Software
+    Foundation; either version 2 of the License, or (at your option) any later
+    version.
+
+    This program is distributed in the hope that it will be useful, but WITHOUT
+    ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+    FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public License along with
+    this program; if not, write to the Free Software Foundation, Inc., 59 Temple
+    Place - Suite 330, Boston, MA 02111-1307, USA, or go to
+    http://www.gnu.org/copyleft/lesser.txt.
+    ------------------------------------------------------------------------------------
+    Author:     EVEmu Team
+*/
+
+
+#ifndef __SYSTEM__WARM_START_H__INCL__
+#define __SYSTEM__WARM_START_H__INCL__
+
+/**
+ * @brief The world state kept over a restart.
+ *
+ * At shutdown the booted solar systems are written, busiest first,
+ * with a checksum of the static data they were built from; the next
+ * start boots them again, spawns included, before the main loop runs,
+ * so the first clients after a downtime do not wait for the boots.
+ * The file is ignored if it is of another version or the static data
+ * changed in the meantime.
+ *
+ * @author EVEmu Team
+ */
+class WarmStart
+{
+public:
+    WarmStart();
+
+    /** @return Checksum of the static data, 0 until Init(). */
+    uint32 GetChecksum() const { return mChecksum; }
+
+    /**
+     * @brief Computes the checksum of the static data.
+     *
+     * @return True on success.
+     */
+    bool Init();
+
+    /**
+     * @brief Reads the state written by the last shutdown.
+     *
+     * @param[in]  filename  Name of the file.
+     * @param[out] systemIDs The solar systems which were booted, busiest first.
+     *
+     * @return False if there is no valid state for the current static data.
+     */
+    bool Load( const char* filename, std::vector<uint32>& systemIDs ) const;
+    /**
+     * @brief Writes the state.
+     *
+     * The file is written under a temporary name and renamed,
+     * so a crash never leaves it half-written.
+     *
+     * @param[in] filename  Name of the file.
+     * @param[in] systemIDs The booted solar systems, busiest first.
+     *
+     * @return True on success.
+     */
+    bool Save( const char* filename, const std::vector<uint32>& systemIDs ) const;
+
+protected:
+    /// Checksum of the static data.
+    uint32 mChecksum;
+};
+
+#endif /* !__SYSTEM__WARM_START_H__INCL__ */
@@ -38,12 +38,35 @@
 
 // auth
 #include "auth/PasswordModule.h"
+// cache
+#include "cache/CachedObjectMgr.h"
+// database
+#include "database/DBTable.h"
+#include "database/RowsetReader.h"
+// destiny
+#include "destiny/DestinyStructs.h"
 // marshal
 #include "marshal/EVEMarshal.h"
+#include "marshal/EVEMarshalOpcodes.h"
 #include "marshal/EVEUnmarshal.h"
+#include "marshal/EVEZeroCompress.h"
+// network
+#include "network/EVESharedPayload.h"
+#include "network/EVETrafficStats.h"
+#include "network/PacketCapture.h"
+// packets
+#include "packets/AccountPkts.h"
+#include "packets/Destiny.h"
+#include "packets/General.h"
+#include "packets/Inventory.h"
+// python
+#include "python/PyPacket.h"
 // python/classes
 #include "python/classes/PyDatabase.h"
 // utils
 #include "utils/EvilNumber.h"
+#include "utils/ModifierGraph.h"
+#include "utils/RechargeState.h"
+#include "utils/TypeAttributeTable.h"
 
 #endif /* !__EVE_TEST_H__INCL__ */
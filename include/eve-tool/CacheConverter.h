@@ -0,0 +1,139 @@
+/*
+    ------------------------------------------------------------------------------------
+    LICENSE:
+    ------------------------------------------------------------------------------------
+    This file is part of EVEmu: EVE Online Server Emulator
+    Copyright 2006 - 2011 The EVEmu Team
+    For the latest information visit http://evemu.org
+    ------------------------------------------------------------------------------------
+    This program is free software; you can redistribute it and/or modify it under
+    the terms of the GNU Lesser General Public License as published by the Free Software
+    Foundation; either version 2 of the License, or (at your option) any later
+    version.
+
+    This program is distributed in the hope that it will be useful, but WITHOUT
+    ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+    FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public License along with
+    this program; if not, write to the Free Software Foundation, Inc., 59 Temple
+    Place - Suite 330, Boston, MA 02111-1307, USA, or go to
+    http://www.gnu.org/copyleft/lesser.txt.
+    ------------------------------------------------------------------------------------
+    Author:     EVEmu Team
+*/
+
+
+#ifndef __CACHE_CONVERTER_H__INCL__
+#define __CACHE_CONVERTER_H__INCL__
+
+/**
+ * @brief Converts cached objects into SQL.
+ *
+ * Every conversion loads a cache file from ../data/cache/, decodes it
+ * and dumps the rowsets it contains into an SQL file (see SetSQLDumper).
+ * The conversions are independent of each other, so Run() spreads
+ * them over a number of threads.
+ *
+ * In bulk mode, the rows of every table are written into a data file
+ * next to its SQL file (with the extension .tsv instead of .sql), which
+ * the SQL file imports by LOAD DATA LOCAL INFILE; the path is relative,
+ * so the SQL must be run from the directory the conversion ran in, by
+ * a client which allows local infiles (mysql --local-infile).
+ *
+ * @author EVEmu Team
+ */
+class CacheConverter
+{
+public:
+    CacheConverter();
+
+    /** @return Number of conversions. */
+    size_t size() const { return mJobs.size(); }
+
+    /**
+     * @brief Adds a conversion.
+     *
+     * @param[in] cacheFile Name of the cache file, without directory and extension.
+     * @param[in] tableName Name of table to be created.
+     * @param[in] keyField  Key field of table.
+     * @param[in] fileName  Name of the SQL file.
+     */
+    void Add( const std::string& cacheFile, const std::string& tableName,
+              const std::string& keyField, const std::string& fileName );
+    /**
+     * @brief Adds the conversions of a script.
+     *
+     * The script has the obj2sql commands of eve-tool, one per line
+     * (like obj2sqlAll.et); other lines are skipped.
+     *
+     * @param[in] filename Name of the script.
+     *
+     * @return True on success.
+     */
+    bool LoadScript( const char* filename );
+
+    /**
+     * @brief Runs the conversions.
+     *
+     * @param[in] threads Number of threads.
+     * @param[in] bulk    Whether to write the rows into data files.
+     *
+     * @return Number of conversions which succeeded.
+     */
+    size_t Run( uint32 threads, bool bulk );
+
+    /**
+     * @brief Converts a single cached object.
+     *
+     * @param[in] cacheFile Name of the cache file, without directory and extension.
+     * @param[in] tableName Name of table to be created.
+     * @param[in] keyField  Key field of table.
+     * @param[in] fileName  Name of the SQL file.
+     * @param[in] dataFile  Name of the data file for the rows; NULL to insert them.
+     *
+     * @return True on success.
+     */
+    static bool Convert( const std::string& cacheFile, const std::string& tableName,
+                         const std::string& keyField, const std::string& fileName,
+                         const char* dataFile = NULL );
+    /**
+     * @return Name of the data file of an SQL file.
+     */
+    static std::string GetDataFileName( const std::string& fileName );
+
+protected:
+    /**
+     * @brief A single conversion.
+     */
+    struct Job
+    {
+        std::string cacheFile;
+        std::string tableName;
+        std::string keyField;
+        std::string fileName;
+    };
+
+    /**
+     * @brief Runs conversions until there are none left.
+     */
+    void _Work();
+
+#ifdef WIN32
+    static DWORD WINAPI WorkerLoop( LPVOID arg );
+#else /* !WIN32 */
+    static void* WorkerLoop( void* arg );
+#endif /* !WIN32 */
+
+    /// The conversions.
+    std::vector<Job> mJobs;
+
+    /// Whether the current Run() is in bulk mode.
+    bool mBulk;
+    /// Number of conversions the threads have taken.
+    volatile uint32 mTaken;
+    /// Number of conversions which succeeded.
+    volatile uint32 mSucceeded;
+};
+
+#endif /* !__CACHE_CONVERTER_H__INCL__ */
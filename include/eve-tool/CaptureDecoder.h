@@ -0,0 +1,188 @@
+/*
+    ------------------------------------------------------------------------------------
+    LICENSE:
+    ------------------------------------------------------------------------------------
+    This file is part of EVEmu: EVE Online Server Emulator
+    Copyright 2006 - 2011 The EVEmu Team
+    For the latest information visit http://evemu.org
+    ------------------------------------------------------------------------------------
+    This program is free software; you can redistribute it and/or modify it under
+    the terms of the GNU Lesser General Public License as published by the Free Software
+    Foundation; either version 2 of the License, or (at your option) any later
+    version.
+
+    This program is distributed in the hope that it will be useful, but WITHOUT
+    ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+    FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public License along with
+    this program; if not, write to the Free Software Foundation, Inc., 59 Temple
+    Place - Suite 330, Boston, MA 02111-1307, USA, or go to
+    http://www.gnu.org/copyleft/lesser.txt.
+    ------------------------------------------------------------------------------------
+    Author:     EVEmu Team
+*/
+
+
+#ifndef __CAPTURE_DECODER_H__INCL__
+#define __CAPTURE_DECODER_H__INCL__
+
+/**
+ * @brief Batch decoder of packet captures into a columnar file.
+ *
+ * Every capture written by EVETCPConnection::StartCapture() holds
+ * a single TCP session, so the sessions are decoded independently:
+ * Run() spreads the captures over a number of threads, each of which
+ * streams its capture record by record (PacketCapture::Reader) and
+ * keeps only the calls still waiting for their responses.
+ *
+ * The decoded packets are written in row groups of at most GROUP_ROWS
+ * packets of one session. The file starts with the 8 byte signature
+ * "EVECOL1\0", followed by the row groups; the numbers are
+ * little-endian and a string is its uint32 length and its bytes:
+ *
+ *   uint32 rows       number of packets in the group
+ *   string session    name of the capture
+ *   uint32 count      number of strings in the dictionary
+ *   string strings[]  the dictionary; the first string is empty
+ *
+ * followed by the columns, each holding the values of all the rows:
+ *
+ *   uint64 time       microseconds since the capture started
+ *   uint8  direction  PacketCapture::Direction
+ *   uint8  type       MACHONETMSG_TYPE; NOT_PACKET if not a packet
+ *   uint64 callID     of the call or the call responded to
+ *   uint32 size       length on the wire
+ *   uint32 rawSize    length after inflation
+ *   uint32 service    dictionary index of the service (the broadcast
+ *                     of a notification)
+ *   uint32 method     dictionary index of the method
+ *   uint64 latency    microseconds from the call to a response
+ *
+ * Calls to bound objects are named after the service which bound
+ * them, if the capture holds the binding.
+ *
+ * @author EVEmu Team
+ */
+class CaptureDecoder
+{
+public:
+    /// Type of the records which are not packets (the login handshake) or fail to decode.
+    static const uint8 NOT_PACKET = 0xFF;
+    /// Maximal number of packets in a row group.
+    static const size_t GROUP_ROWS = 16384;
+
+    CaptureDecoder();
+    /**
+     * @brief Closes the output file.
+     */
+    ~CaptureDecoder();
+
+    /** @return Number of captures to decode. */
+    size_t size() const { return mCaptures.size(); }
+
+    /**
+     * @brief Adds a capture to decode.
+     *
+     * @param[in] filename Name of the capture file.
+     */
+    void Add( const std::string& filename );
+
+    /**
+     * @brief Decodes the captures.
+     *
+     * @param[in] filename Name of the output file; overwritten if it exists.
+     * @param[in] threads  Number of threads.
+     *
+     * @return Number of captures which were decoded.
+     */
+    size_t Run( const char* filename, uint32 threads );
+    /**
+     * @brief Logs the totals of the last Run().
+     */
+    void Report() const;
+
+protected:
+    /**
+     * @brief Totals of the decoded captures.
+     */
+    struct Totals
+    {
+        Totals() : packets( 0 ), undecoded( 0 ), bytes( 0 ), rawBytes( 0 ), groups( 0 ) {}
+
+        void operator+=( const Totals& right )
+        {
+            packets += right.packets;
+            undecoded += right.undecoded;
+            bytes += right.bytes;
+            rawBytes += right.rawBytes;
+            groups += right.groups;
+        }
+
+        /// Number of records.
+        uint64 packets;
+        /// Number of records which are not packets.
+        uint64 undecoded;
+        /// Bytes on the wire.
+        uint64 bytes;
+        /// Bytes after inflation.
+        uint64 rawBytes;
+        /// Number of written row groups.
+        uint64 groups;
+    };
+
+    /**
+     * @brief A call waiting for its response.
+     */
+    struct Pending
+    {
+        /// Microseconds since the capture started.
+        uint64 time;
+        std::string service;
+        std::string method;
+    };
+
+    class RowGroup;
+
+    /**
+     * @brief Decodes a single capture.
+     *
+     * @return True on success.
+     */
+    bool _Decode( const std::string& filename, Totals& totals );
+    /**
+     * @brief Writes a row group into the output file and clears it.
+     *
+     * @return True on success.
+     */
+    bool _Flush( RowGroup& group, Totals& totals );
+
+    /**
+     * @brief Decodes captures until there are none left.
+     */
+    void _Work();
+
+#ifdef WIN32
+    static DWORD WINAPI WorkerLoop( LPVOID arg );
+#else /* !WIN32 */
+    static void* WorkerLoop( void* arg );
+#endif /* !WIN32 */
+
+    /// The captures.
+    std::vector<std::string> mCaptures;
+
+    /// Protects the output file and the totals.
+    Mutex mMutex;
+    FILE* mOutput;
+
+    /// Number of captures the threads have taken.
+    volatile uint32 mTaken;
+    /// Number of captures which were decoded.
+    volatile uint32 mSucceeded;
+    /// Totals of the last Run().
+    Totals mTotals;
+    /// Duration of the last Run() in microseconds.
+    uint64 mTime;
+};
+
+#endif /* !__CAPTURE_DECODER_H__INCL__ */
@@ -0,0 +1,92 @@
+/*
+    ------------------------------------------------------------------------------------
+    LICENSE:
+    ------------------------------------------------------------------------------------
+    This file is part of EVEmu: EVE Online Server Emulator
+    Copyright 2006 - 2011 The EVEmu Team
+    For the latest information visit http://evemu.org
+    ------------------------------------------------------------------------------------
+    This program is free software; you can redistribute it and/or modify it under
+    the terms of the GNU Lesser General Public License as published by the Free Software
+    Foundation; either version 2 of the License, or (at your option) any later
+    version.
+
+    This program is distributed in the hope that it will be useful, but WITHOUT
+    ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+    FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public License along with
+    this program; if not, write to the Free Software Foundation, Inc., 59 Temple
+    Place - Suite 330, Boston, MA 02111-1307, USA, or go to
+    http://www.gnu.org/copyleft/lesser.txt.
+    ------------------------------------------------------------------------------------
+    Author:     EVEmu Team
+*/
+
+
+#ifndef __DESTINY_BENCH_H__INCL__
+#define __DESTINY_BENCH_H__INCL__
+
+/**
+ * @brief Fuzz-benchmark of Destiny binaries.
+ *
+ * Generates a random population of balls of all the modes which may
+ * be in a binary, then measures how fast Destiny::State encodes and
+ * decodes it, verifying that the decoded state has no difference to
+ * the generated one. Then decodes mutated copies of the binary
+ * (flipped bytes, truncations) to check that malformed binaries are
+ * rejected and never overrun.
+ *
+ * @author EVEmu Team
+ */
+class DestinyBench
+{
+public:
+    DestinyBench();
+
+    /** @return Number of generated balls. */
+    size_t size() const { return mState.balls().size(); }
+
+    /**
+     * @brief Generates a random population.
+     *
+     * @param[in] count Number of balls.
+     * @param[in] seed  Seed of the generator; the same seed gives the same population.
+     */
+    void Generate( size_t count, uint32 seed );
+
+    /**
+     * @brief Encodes and decodes the population, then decodes mutated binaries.
+     *
+     * @param[in] rounds    Number of encodes and decodes to measure.
+     * @param[in] mutations Number of mutated binaries to decode.
+     *
+     * @return False if a decoded state differs from the generated one.
+     */
+    bool Run( size_t rounds, size_t mutations );
+    /**
+     * @brief Logs throughput and fuzzing results of the last Run().
+     */
+    void Report() const;
+
+protected:
+    /** @return Next random number. */
+    uint32 _Random();
+    /** @return Random number within [min, max). */
+    double _Random( double min, double max );
+
+    /// The generated population.
+    Destiny::State mState;
+    /// State of the generator.
+    uint32 mSeed;
+
+    /// Results of the last Run().
+    size_t mRounds;
+    size_t mBinarySize;
+    uint64 mEncodeTime;
+    uint64 mDecodeTime;
+    size_t mMutations;
+    size_t mRejected;
+};
+
+#endif /* !__DESTINY_BENCH_H__INCL__ */
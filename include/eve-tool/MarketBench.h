@@ -0,0 +1,176 @@
+/*
+    ------------------------------------------------------------------------------------
+    LICENSE:
+    ------------------------------------------------------------------------------------
+    This file is part of EVEmu: EVE Online Server Emulator
+    Copyright 2006 - 2011 The EVEmu Team
+    For the latest information visit http://evemu.org
+    ------------------------------------------------------------------------------------
+    This program is free software; you can redistribute it and/or modify it under
+    the terms of the GNU Lesser General Public License as published by the Free Software
+    Foundation; either version 2 of the License, or (at your option) any later
+    version.
+
+    This program is distributed in the hope that it will be useful, but WITHOUT
+    ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+    FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public License along with
+    this program; if not, write to the Free Software Foundation, Inc., 59 Temple
+    Place - Suite 330, Boston, MA 02111-1307, USA, or go to
+    http://www.gnu.org/copyleft/lesser.txt.
+    ------------------------------------------------------------------------------------
+    Author:     EVEmu Team
+*/
+
+#ifndef __MARKET_BENCH_H__INCL__
+#define __MARKET_BENCH_H__INCL__
+
+/**
+ * @brief Load generator of the market.
+ *
+ * Replays a stream of PlaceCharOrder, ModifyCharOrder, CancelCharOrder
+ * and GetOrders calls against a test database, running for every call
+ * the statements the SQL path of MarketProxyService runs, and measures
+ * the latency of every call and the statements it took.
+ *
+ * A recorded stream is a text file with one call per line; empty
+ * lines and lines starting with '#' are skipped:
+ *
+ *   place  stationID typeID bid price quantity
+ *   modify order price
+ *   cancel order
+ *   orders solarSystemID typeID
+ *
+ * An order is either an orderID or "@n", the order placed by
+ * the n-th place call of the stream (counted from 0).
+ *
+ * Everything the replay writes is undone by Cleanup().
+ *
+ * @author EVEmu Team
+ */
+class MarketBench
+{
+public:
+    enum CallKind
+    {
+        CALL_PLACE,
+        CALL_MODIFY,
+        CALL_CANCEL,
+        CALL_GET_ORDERS,
+
+        CALL_KIND_COUNT
+    };
+
+    /**
+     * @brief A call of the stream.
+     */
+    struct Call
+    {
+        uint8 kind;
+        /// PlaceCharOrder: where, what and how much.
+        uint32 stationID;
+        uint32 typeID;
+        bool bid;
+        double price;
+        uint32 quantity;
+        /// ModifyCharOrder, CancelCharOrder: the order; placeIndex is -1 if orderID is set.
+        int32 placeIndex;
+        uint32 orderID;
+        /// GetOrders: location of the caller.
+        uint32 solarSystemID;
+    };
+
+    MarketBench();
+
+    /** @return Number of calls in the stream. */
+    size_t size() const { return mCalls.size(); }
+
+    /**
+     * @brief Generates a synthetic stream from the stations and market types of the database.
+     *
+     * @param[in] count Number of calls.
+     * @param[in] seed  Seed of the generator; the same seed gives the same stream.
+     *
+     * @return True on success.
+     */
+    bool Generate( size_t count, uint32 seed );
+    /**
+     * @brief Loads a recorded stream.
+     *
+     * @param[in] filename Name of the stream file.
+     *
+     * @return True on success.
+     */
+    bool LoadStream( const char* filename );
+
+    /**
+     * @brief Replays the stream.
+     *
+     * @return True on success, false if a statement failed.
+     */
+    bool Run();
+    /**
+     * @brief Logs throughput, latencies and statements of the last Run().
+     */
+    void Report() const;
+    /**
+     * @brief Deletes the orders and transactions the replay added and restores the balances it changed.
+     */
+    void Cleanup();
+
+protected:
+    /**
+     * @brief Results of one kind of call.
+     */
+    struct KindStats
+    {
+        KindStats() : statements( 0 ) {}
+
+        /// Latency of every call in microseconds.
+        std::vector<uint64> latencies;
+        /// Number of statements the calls ran.
+        uint64 statements;
+    };
+
+    bool _LoadCharacter();
+
+    bool _Place( const Call& call );
+    bool _Modify( const Call& call );
+    bool _Cancel( const Call& call );
+    bool _GetOrders( const Call& call );
+
+    bool _Trade( uint32 orderID, uint32 quantity, bool sellerIsOwner );
+    bool _StoreOrder( const Call& call );
+    uint32 _ResolveOrder( const Call& call ) const;
+
+    /** @brief Runs a query and counts it. */
+    bool _Query( DBQueryResult& res, const char* fmt, ... );
+    bool _Exec( const char* fmt, ... );
+    bool _ExecLID( uint32& lastInsertID, const char* fmt, ... );
+
+    static const char* const CALL_KIND_NAMES[ CALL_KIND_COUNT ];
+
+    /// The stream.
+    std::vector<Call> mCalls;
+    /// The character placing the orders.
+    uint32 mCharacterID;
+
+    /// orderID of the order placed by every place call; 0 if the call traded or failed.
+    std::vector<uint32> mPlacedOrders;
+    /// Orders and transactions added by the replay.
+    std::vector<uint32> mOrders;
+    std::vector<uint32> mTransactions;
+    /// Balance changes of the order owners, by characterID.
+    std::map<uint32, double> mBalances;
+
+    /// Statements of the call in progress.
+    uint64 mStatements;
+    /// Results of the last Run().
+    KindStats mStats[ CALL_KIND_COUNT ];
+    uint64 mTrades;
+    uint64 mMisses;
+    uint64 mTotalTime;
+};
+
+#endif /* !__MARKET_BENCH_H__INCL__ */
@@ -0,0 +1,139 @@
+/*
+    ------------------------------------------------------------------------------------
+    LICENSE:
+    ------------------------------------------------------------------------------------
+    This file is part of EVEmu: EVE Online Server Emulator
+    Copyright 2006 - 2011 The EVEmu Team
+    For the latest information visit http://evemu.org
+    ------------------------------------------------------------------------------------
+    This program is free software; you can redistribute it and/or modify it under
+    the terms of the GNU Lesser General Public License as published by the Free Software
+    Foundation; either version 2 of the License, or (at your option) any later
+    version.
+
+    This program is distributed in the hope that it will be useful, but WITHOUT
+    ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+    FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public License along with
+    this program; if not, write to the Free Software Foundation, Inc., 59 Temple
+    Place - Suite 330, Boston, MA 02111-1307, USA, or go to
+    http://www.gnu.org/copyleft/lesser.txt.
+    ------------------------------------------------------------------------------------
+    Author:     EVEmu Team
+*/
+
+#ifndef __PACKET_REPLAY_H__INCL__
+#define __PACKET_REPLAY_H__INCL__
+
+/**
+ * @brief Load generator replaying captured client sessions.
+ *
+ * Loads a capture written by EVETCPConnection::StartCapture() and
+ * replays the packets the client sent, after logging in, by a number
+ * of synthetic clients at once, keeping the recorded pacing (scaled
+ * by a speed factor). The latency of every call is measured from
+ * sending it until its response arrives.
+ *
+ * The objects the server binds get new bind strings every session;
+ * they are mapped to the recorded ones by their position in the
+ * responses, and a call to an object which is still being bound
+ * waits for the binding call to return.
+ *
+ * Everything else is sent as recorded, including the IDs the calls
+ * carry (characterID etc.), so the accounts should be copies of the
+ * captured one. The login throttle of the server counts the logins
+ * of all the clients, which come from a single address.
+ *
+ * @author EVEmu Team
+ */
+class PacketReplay
+{
+public:
+    PacketReplay();
+    ~PacketReplay();
+
+    /** @return Number of packets to replay. */
+    size_t size() const { return mCalls.size(); }
+
+    /**
+     * @brief Loads a capture.
+     *
+     * @param[in] filename Name of the capture file.
+     *
+     * @return True on success.
+     */
+    bool Load( const char* filename );
+
+    /**
+     * @brief Replays the capture.
+     *
+     * @param[in] address    Address of the server (network byte order).
+     * @param[in] port       Port of the server.
+     * @param[in] clients    Number of clients.
+     * @param[in] userPrefix The clients log in as userPrefix followed by their number (from 0).
+     * @param[in] password   Password of all the accounts.
+     * @param[in] speed      Pacing factor; 2 replays twice as fast as recorded.
+     *
+     * @return True if at least one client logged in.
+     */
+    bool Run( uint32 address, uint16 port, uint32 clients,
+              const std::string& userPrefix, const std::string& password, double speed );
+    /**
+     * @brief Logs logins, throughput and latencies of the last Run().
+     */
+    void Report() const;
+
+protected:
+    class Client;
+
+    /**
+     * @brief A packet the recorded client sent.
+     */
+    struct Call
+    {
+        /// Microseconds since the capture started.
+        uint64 time;
+        PyPacket* packet;
+        /// Bind string of the called object; empty for services and non-calls.
+        std::string bind;
+        /// Name the results are kept under ("service::method"); empty for non-calls.
+        std::string name;
+        /// Bind strings in the recorded response, in order.
+        std::vector<std::string> binds;
+    };
+
+    /**
+     * @brief Results of one method.
+     */
+    struct MethodStats
+    {
+        MethodStats() : errors( 0 ) {}
+
+        /// Latency of every call in microseconds.
+        std::vector<uint64> latencies;
+        /// Number of calls which raised an exception.
+        uint64 errors;
+    };
+
+    void _Clear();
+
+    /// The packets to replay, in order.
+    std::vector<Call> mCalls;
+    /// Every bind string in the recorded responses.
+    std::set<std::string> mBinds;
+
+    /// Pacing factor of the last Run().
+    double mSpeed;
+
+    /// Results of the last Run(), by method.
+    std::map<std::string, MethodStats> mStats;
+    /// Latency of every login in microseconds.
+    std::vector<uint64> mLogins;
+    uint32 mFailedLogins;
+    /// Calls which got no response.
+    uint64 mTimeouts;
+    uint64 mTotalTime;
+};
+
+#endif /* !__PACKET_REPLAY_H__INCL__ */
@@ -0,0 +1,249 @@
+/*
+    ------------------------------------------------------------------------------------
+    LICENSE:
+    ------------------------------------------------------------------------------------
+    This file is part of EVEmu: EVE Online Server Emulator
+    Copyright 2006 - 2011 The EVEmu Team
+    For the latest information visit http://evemu.org
+    ------------------------------------------------------------------------------------
+    This program is free software; you can redistribute it and/or modify it under
+    the terms of the GNU Lesser General Public License as published by the Free Software
+    Foundation; either version 2 of the License, or (at your option) any later
+    version.
+
+    This program is distributed in the hope that it will be useful, but WITHOUT
+    ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+    FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public License along with
+    this program; if not, write to the Free Software Foundation, Inc., 59 Temple
+    Place - Suite 330, Boston, MA 02111-1307, USA, or go to
+    http://www.gnu.org/copyleft/lesser.txt.
+    ------------------------------------------------------------------------------------
+    Author:     EVEmu Team
+*/
+
+
+#ifndef __UNIVERSE_SEEDER_H__INCL__
+#define __UNIVERSE_SEEDER_H__INCL__
+
+/**
+ * @brief Generator of synthetic universes for benchmarks.
+ *
+ * Builds a data set of a given size on top of the static data of
+ * a database: accounts with a character each, their skills, ship
+ * and hangar, corporations with their rosters, market orders all
+ * over the universe and mails between the characters.
+ *
+ * Nothing is inserted by queries; every table gets data files (.tsv)
+ * which a single SQL file imports by LOAD DATA LOCAL INFILE, like the
+ * bulk mode of CacheConverter. The paths are relative, so the SQL must
+ * be run from the directory the generator ran in, by a client which
+ * allows local infiles (mysql --local-infile).
+ *
+ * The IDs continue after the largest ones of the database; the data
+ * set must be loaded before anything else is added to it.
+ *
+ * Apart from the dates, which are relative to the time of the run, the
+ * output depends on the seed only, not on the number of threads: every
+ * character, order and mail draws from a generator of its own.
+ *
+ * @author EVEmu Team
+ */
+class UniverseSeeder
+{
+public:
+    /**
+     * @brief Size and shape of a data set.
+     */
+    struct Parameters
+    {
+        Parameters();
+
+        /// Number of accounts, one character each.
+        uint32 characters;
+        /// Number of player corporations; at most the number of characters.
+        uint32 corporations;
+        /// Number of market orders.
+        uint32 orders;
+        /// Number of mails.
+        uint32 mails;
+
+        /// Skills of every character.
+        uint32 skillsPerCharacter;
+        /// Item stacks in the hangar of every character, besides the ship.
+        uint32 assetsPerCharacter;
+        /// Most recipients of a mail.
+        uint32 recipientsPerMail;
+
+        /// The accounts are named accountPrefix followed by their number (from 0), like the clients of PacketReplay.
+        std::string accountPrefix;
+        /// Password of all the accounts.
+        std::string password;
+
+        /// Seed of the generator; the same seed gives the same data set.
+        uint32 seed;
+    };
+
+    UniverseSeeder();
+
+    /**
+     * @brief Loads the static data and the largest IDs from the database.
+     *
+     * @return True on success.
+     */
+    bool LoadStaticData();
+
+    /**
+     * @brief Generates a data set.
+     *
+     * @param[in] prefix  Prefix of the output files; the SQL file is prefix.sql.
+     * @param[in] params  Size of the data set.
+     * @param[in] threads Number of threads.
+     *
+     * @return True on success.
+     */
+    bool Generate( const std::string& prefix, const Parameters& params, uint32 threads );
+
+protected:
+    enum Table
+    {
+        TABLE_ACCOUNT,
+        TABLE_CHARACTER,
+        TABLE_EMPLOYMENT,
+        TABLE_ENTITY,
+        TABLE_ATTRIBUTES,
+        TABLE_CORPORATION,
+        TABLE_ORDERS,
+        TABLE_MAIL_BODY,
+        TABLE_MAIL_MESSAGE,
+        TABLE_MAIL_RECIPIENT,
+
+        TABLE_COUNT
+    };
+
+    enum JobKind
+    {
+        JOB_CHARACTERS,
+        JOB_CORPORATIONS,
+        JOB_ORDERS,
+        JOB_MAILS,
+
+        JOB_KIND_COUNT
+    };
+
+    /**
+     * @brief A chunk of rows written into data files of its own.
+     */
+    struct Job
+    {
+        uint8 kind;
+        uint32 chunk;
+        /// Index of the first character, corporation, order or mail.
+        uint32 first;
+        uint32 count;
+    };
+
+    struct Station
+    {
+        uint32 stationID;
+        uint32 solarSystemID;
+        uint32 constellationID;
+        uint32 regionID;
+    };
+
+    struct Ancestry
+    {
+        uint32 ancestryID;
+        uint32 raceID;
+        /// The character type of the bloodline.
+        uint32 typeID;
+        uint32 schoolID;
+        /// Charisma, intelligence, memory, perception and willpower of bloodline and ancestry.
+        uint32 attributes[ 5 ];
+    };
+
+    /**
+     * @brief A small deterministic generator, one per character, order or mail.
+     */
+    class Random
+    {
+    public:
+        Random( uint32 seed, uint8 kind, uint32 index );
+
+        uint32 Next();
+        /** @return A number in [0, n). */
+        uint32 Below( uint32 n ) { return (uint32)( ( (uint64)Next() * n ) >> 32 ); }
+        /** @return A number in [0, 1). */
+        double Real() { return Next() / 4294967296.0; }
+
+    protected:
+        uint64 mState;
+    };
+
+    /**
+     * @brief Draws the ancestry, station and corporation of a character, the first draws of its generator.
+     *
+     * @return Index of the corporation.
+     */
+    uint32 _DrawCharacter( uint32 index, Random& random, const Ancestry*& ancestry, const Station*& station ) const;
+    uint32 _CharacterID( uint32 index ) const { return mFirstItemID + index * mItemsPerCharacter; }
+
+    bool _WriteCharacters( const Job& job );
+    bool _WriteCorporations( const Job& job );
+    bool _WriteOrders( const Job& job );
+    bool _WriteMails( const Job& job );
+
+    bool _WriteLoadScript( const std::string& fileName ) const;
+    std::string _GetDataFileName( uint8 table, uint32 chunk ) const;
+
+    /**
+     * @brief Writes chunks until there are none left.
+     */
+    void _Work();
+
+#ifdef WIN32
+    static DWORD WINAPI WorkerLoop( LPVOID arg );
+#else /* !WIN32 */
+    static void* WorkerLoop( void* arg );
+#endif /* !WIN32 */
+
+    static const char* const TABLE_NAMES[ TABLE_COUNT ];
+    static const char* const TABLE_COLUMNS[ TABLE_COUNT ];
+    /// The kind of jobs writing every table.
+    static const uint8 TABLE_JOBS[ TABLE_COUNT ];
+
+    /// The static data.
+    std::vector<Station> mStations;
+    std::vector<Ancestry> mAncestries;
+    /// Market types with their base price.
+    std::vector< std::pair<uint32, double> > mMarketTypes;
+    /// Skills with their rank (skillTimeConstant).
+    std::vector< std::pair<uint32, double> > mSkills;
+    std::vector<uint32> mShipTypes;
+
+    /// The first free IDs.
+    uint32 mFirstAccountID;
+    uint32 mFirstItemID;
+    uint32 mFirstCorporationID;
+    uint32 mFirstOrderID;
+    uint32 mFirstMessageID;
+    uint32 mFirstBodyID;
+
+    /// The data set in progress.
+    Parameters mParams;
+    std::string mPrefix;
+    uint64 mNow;
+    /// Entities of every character: itself, its ship, assets and skills.
+    uint32 mItemsPerCharacter;
+    /// Number of members of every corporation.
+    std::vector<uint32> mMemberCounts;
+
+    std::vector<Job> mJobs;
+    /// Number of chunks the threads have taken.
+    volatile uint32 mTaken;
+    /// Number of chunks which succeeded.
+    volatile uint32 mSucceeded;
+};
+
+#endif /* !__UNIVERSE_SEEDER_H__INCL__ */
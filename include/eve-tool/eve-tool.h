@@ -32,15 +32,20 @@
 #include "eve-core.h"
 
 // database
+#include "database/dbcore.h"
 #include "database/dbtype.h"
 // log
 #include "log/logsys.h"
 #include "log/LogNew.h"
+// network
+#include "network/NetUtils.h"
 // threading
+#include "threading/Atomic.h"
 #include "threading/Mutex.h"
 // utils
 #include "utils/Buffer.h"
 #include "utils/crc32.h"
+#include "utils/Deflate.h"
 #include "utils/misc.h"
 #include "utils/RefPtr.h"
 #include "utils/Seperator.h"
@@ -53,20 +58,29 @@
 /************************************************************************/
 #include "eve-common.h"
 
+#include "EVEVersion.h"
+// auth
+#include "auth/PasswordModule.h"
 // cache
 #include "cache/CachedObjectMgr.h"
 // database
 #include "database/RowsetReader.h"
 #include "database/RowsetToSQL.h"
+#include "database/StaticDataSnapshot.h"
 // destiny
 #include "destiny/DestinyBinDump.h"
+#include "destiny/DestinyState.h"
 // marshal
 #include "marshal/EVEUnmarshal.h"
 // network
+#include "network/EVETCPConnection.h"
+#include "network/PacketCapture.h"
 #include "network/packet_types.h"
 // packets
+#include "packets/Crypto.h"
 #include "packets/General.h"
 // python
+#include "python/PyPacket.h"
 #include "python/PyRep.h"
 #include "python/PyVisitor.h"
 // utils
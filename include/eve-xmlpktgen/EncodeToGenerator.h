@@ -0,0 +1,121 @@
+/*
+    ------------------------------------------------------------------------------------
+    LICENSE:
+    ------------------------------------------------------------------------------------
+    This file is part of EVEmu: EVE Online Server Emulator
+    Copyright 2006 - 2011 The EVEmu Team
+    For the latest information visit http://evemu.org
+    ------------------------------------------------------------------------------------
+    This program is free software; you can redistribute it and/or modify it under
+    the terms of the GNU Lesser General Public License as published by the Free Software
+    Foundation; either version 2 of the License, or (at your option) any later
+    version.
+
+    This program is distributed in the hope that it will be useful, but WITHOUT
+    ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+    FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public License along with
+    this program; if not, write to the Free Software Foundation, Inc., 59 Temple
+    Place - Suite 330, Boston, MA 02111-1307, USA, or go to
+    http://www.gnu.org/copyleft/lesser.txt.
+    ------------------------------------------------------------------------------------
+    Author:     EVEmu Team
+*/
+
+#ifndef __ENCODETOGENERATOR_H_INCL__
+#define __ENCODETOGENERATOR_H_INCL__
+
+#include "Generator.h"
+
+/**
+ * @brief Generates direct-to-wire encoders.
+ *
+ * The generated EncodeTo() methods write the marshal opcodes of the
+ * fields straight into a MarshalStream, producing the same stream as
+ * marshaling the result of Encode() without building the PyRep tree.
+ * Strings of inline elements are looked up in the string table while
+ * generating.
+ *
+ * Entries of inline dicts are written in the order of the definition,
+ * which may differ from the (hashed) order a PyDict would have.
+ *
+ * @author EVEmu Team
+ */
+class ClassEncodeToGenerator
+: public Generator
+{
+public:
+    ClassEncodeToGenerator( FILE* outputFile = NULL );
+
+protected:
+    bool ProcessElementDef( const TiXmlElement* field );
+    bool ProcessElement( const TiXmlElement* field );
+    bool ProcessElementPtr( const TiXmlElement* field );
+
+    bool ProcessRaw( const TiXmlElement* field );
+    bool ProcessInt( const TiXmlElement* field );
+    bool ProcessLong( const TiXmlElement* field );
+    bool ProcessReal( const TiXmlElement* field );
+    bool ProcessBool( const TiXmlElement* field );
+    bool ProcessNone( const TiXmlElement* field );
+    bool ProcessBuffer( const TiXmlElement* field );
+
+    bool ProcessString( const TiXmlElement* field );
+    bool ProcessStringInline( const TiXmlElement* field );
+    bool ProcessWString( const TiXmlElement* field );
+    bool ProcessWStringInline( const TiXmlElement* field );
+    bool ProcessToken( const TiXmlElement* field );
+    bool ProcessTokenInline( const TiXmlElement* field );
+
+    bool ProcessObject( const TiXmlElement* field );
+    bool ProcessObjectInline( const TiXmlElement* field );
+    bool ProcessObjectEx( const TiXmlElement* field );
+
+    bool ProcessTuple( const TiXmlElement* field );
+    bool ProcessTupleInline( const TiXmlElement* field );
+    bool ProcessList( const TiXmlElement* field );
+    bool ProcessListInline( const TiXmlElement* field );
+    bool ProcessListInt( const TiXmlElement* field );
+    bool ProcessListLong( const TiXmlElement* field );
+    bool ProcessListStr( const TiXmlElement* field );
+    bool ProcessDict( const TiXmlElement* field );
+    bool ProcessDictInline( const TiXmlElement* field );
+    bool ProcessDictRaw( const TiXmlElement* field );
+    bool ProcessDictInt( const TiXmlElement* field );
+    bool ProcessDictStr( const TiXmlElement* field );
+
+    bool ProcessSubStreamInline( const TiXmlElement* field );
+    bool ProcessSubStructInline( const TiXmlElement* field );
+
+    /** Writes a reference to a rep field, hacking in a None for NULL. */
+    void SaveRepField( const char* name, bool optional );
+    /** Writes a string constant, with its string table index resolved. */
+    void SaveStringConst( const char* str );
+
+    /**
+     * @brief Obtains the MarshalStream method which saves a value of given Py type.
+     *
+     * @param[in] pyType The type, without the "Py" prefix (e.g. "Int").
+     *
+     * @return The method name; NULL if the type is not supported.
+     */
+    static const char* GetSaveMethod( const char* pyType );
+    /**
+     * @brief Looks up a string in the string table.
+     *
+     * @return The index of the string; 0 (STRING_TABLE_ERROR) if it is not there.
+     */
+    static uint8 LookupStringIndex( const char* str );
+
+private:
+    uint32 mItemNumber;
+    const char* mName;
+
+    /** True if the string table below has been loaded. */
+    static bool smStringTableLoaded;
+    /** The string table, as the client has it. */
+    static std::map<std::string, uint8> smStringTable;
+};
+
+#endif
@@ -103,9 +103,23 @@ protected:
      * @return The encode type of element.
      */
     static const char* GetEncodeType( const TiXmlElement* element );
+    /**
+     * @brief Checks whether given elementDef borrows its fields.
+     *
+     * The string, wstring, buffer and listInt fields of a borrowing
+     * element are non-owning views into the decoded tree, which
+     * the element keeps a reference of.
+     *
+     * @param[in] elementDef The elementDef to be examined.
+     *
+     * @return True if the elementDef has borrow="true".
+     */
+    static bool IsBorrowed( const TiXmlElement* elementDef );
 
     /** The current output file. */
     FILE* mOutputFile;
+    /** True if the current elementDef borrows its fields. */
+    bool mBorrow;
 
 private:
     /** Loads encode types. */
@@ -34,6 +34,13 @@ class ClassHeaderGenerator
 public:
     ClassHeaderGenerator( FILE* outputFile = NULL );
 
+    /**
+     * @brief Sets whether EncodeTo() methods are declared.
+     *
+     * @param[in] encodeTo True if ClassEncodeToGenerator runs too.
+     */
+    void SetEncodeTo( bool encodeTo ) { mEncodeTo = encodeTo; }
+
 protected:
     bool RegisterName( const char* name, uint32 row );
     void ClearNames();
@@ -82,6 +89,7 @@ protected:
 
 private:
     std::set<std::string> mNamesUsed;
+    bool mEncodeTo;
 };
 
 #endif
@@ -31,6 +31,7 @@
 #include "DestructGenerator.h"
 #include "DumpGenerator.h"
 #include "EncodeGenerator.h"
+#include "EncodeToGenerator.h"
 #include "DecodeGenerator.h"
 #include "CloneGenerator.h"
 
@@ -71,6 +72,13 @@ public:
      */
     void SetSourceFile( const char* source );
 
+    /**
+     * @brief Sets whether direct-to-wire EncodeTo() methods are generated.
+     *
+     * @param[in] encodeTo True to generate them.
+     */
+    void SetEncodeTo( bool encodeTo );
+
 protected:
     bool ParseElements( const TiXmlElement* field );
     bool ParseInclude( const TiXmlElement* field );
@@ -89,6 +97,7 @@ private:
     std::string mHeaderFileName;
     FILE*       mSourceFile;
     std::string mSourceFileName;
+    bool        mEncodeToEnabled;
 
     ClassCloneGenerator        mClone;
     ClassConstructGenerator    mConstruct;
@@ -96,6 +105,7 @@ private:
     ClassDestructGenerator    mDestruct;
     ClassDumpGenerator        mDump;
     ClassEncodeGenerator    mEncode;
+    ClassEncodeToGenerator  mEncodeTo;
     ClassHeaderGenerator    mHeader;
 
     static std::string FNameToDef( const char* buf );
@@ -267,6 +267,22 @@ CREATE TABLE IF NOT EXISTS `chrCertificates` (
   PRIMARY KEY (`id`)
 ) ENGINE=InnoDB DEFAULT CHARSET=utf8 AUTO_INCREMENT=1 ;
 
+/*Table structure for table `chrContacts` */
+
+DROP TABLE IF EXISTS `chrContacts`;
+
+CREATE TABLE `chrContacts` (
+  `ownerID` int(10) unsigned NOT NULL default '0',
+  `contactID` int(10) unsigned NOT NULL default '0',
+  `relationshipID` double NOT NULL default '0',
+  `inWatchList` tinyint(3) unsigned NOT NULL default '0',
+  `labelMask` bigint(20) unsigned NOT NULL default '0',
+  PRIMARY KEY  (`ownerID`,`contactID`),
+  KEY `contactID` (`contactID`)
+) ENGINE=InnoDB DEFAULT CHARSET=utf8;
+
+/*Data for the table `chrContacts` */
+
 /*Table structure for table `chrEmployment` */
 
 DROP TABLE IF EXISTS `chrEmployment`;
@@ -282,6 +298,20 @@ CREATE TABLE `chrEmployment` (
 
 /*Data for the table `chrEmployment` */
 
+/*Table structure for table `chrKillRights` */
+
+DROP TABLE IF EXISTS `chrKillRights`;
+
+CREATE TABLE `chrKillRights` (
+  `fromID` int(10) unsigned NOT NULL default '0',
+  `toID` int(10) unsigned NOT NULL default '0',
+  `expiryDate` bigint(20) unsigned NOT NULL default '0',
+  PRIMARY KEY  (`fromID`,`toID`),
+  KEY `toID` (`toID`)
+) ENGINE=InnoDB DEFAULT CHARSET=utf8;
+
+/*Data for the table `chrKillRights` */
+
 /*Table structure for table `chrMissionState` */
 
 DROP TABLE IF EXISTS `chrMissionState`;
@@ -309,6 +339,25 @@ CREATE TABLE `chrNotes` (
 
 /*Data for the table `chrNotes` */
 
+/*Table structure for table `chrNotifications` */
+
+DROP TABLE IF EXISTS `chrNotifications`;
+
+CREATE TABLE `chrNotifications` (
+  `notificationID` int(10) unsigned NOT NULL default '0',
+  `receiverID` int(10) unsigned NOT NULL default '0',
+  `groupID` int(10) unsigned NOT NULL default '0',
+  `typeID` int(10) unsigned NOT NULL default '0',
+  `senderID` int(10) unsigned NOT NULL default '0',
+  `created` bigint(20) unsigned NOT NULL default '0',
+  `processed` tinyint(3) unsigned NOT NULL default '0',
+  `data` text NOT NULL,
+  PRIMARY KEY  (`receiverID`,`notificationID`),
+  KEY `groupID` (`receiverID`,`groupID`,`notificationID`)
+) ENGINE=InnoDB DEFAULT CHARSET=utf8;
+
+/*Data for the table `chrNotifications` */
+
 /*Table structure for table `chrNPCStandings` */
 
 DROP TABLE IF EXISTS `chrNPCStandings`;
@@ -363,6 +412,53 @@ CREATE TABLE `chrStandings` (
 
 /*Data for the table `chrStandings` */
 
+/*Table structure for table `contracts` */
+
+DROP TABLE IF EXISTS `contracts`;
+
+CREATE TABLE `contracts` (
+  `contractID` int(10) unsigned NOT NULL auto_increment,
+  `type` tinyint(3) unsigned NOT NULL default '0',
+  `status` tinyint(3) unsigned NOT NULL default '0',
+  `issuerID` int(10) unsigned NOT NULL default '0',
+  `issuerCorpID` int(10) unsigned NOT NULL default '0',
+  `forCorp` tinyint(3) unsigned NOT NULL default '0',
+  `assigneeID` int(10) unsigned NOT NULL default '0',
+  `acceptorID` int(10) unsigned NOT NULL default '0',
+  `startStationID` int(10) unsigned NOT NULL default '0',
+  `startSolarSystemID` int(10) unsigned NOT NULL default '0',
+  `startRegionID` int(10) unsigned NOT NULL default '0',
+  `endStationID` int(10) unsigned NOT NULL default '0',
+  `price` double NOT NULL default '0',
+  `reward` double NOT NULL default '0',
+  `collateral` double NOT NULL default '0',
+  `volume` double NOT NULL default '0',
+  `title` varchar(100) NOT NULL default '',
+  `dateIssued` bigint(20) unsigned NOT NULL default '0',
+  `dateExpired` bigint(20) unsigned NOT NULL default '0',
+  `dateAccepted` bigint(20) unsigned NOT NULL default '0',
+  `numDays` int(10) unsigned NOT NULL default '0',
+  PRIMARY KEY  (`contractID`),
+  KEY `status` (`status`)
+) ENGINE=InnoDB DEFAULT CHARSET=utf8;
+
+/*Data for the table `contracts` */
+
+/*Table structure for table `contracts_items` */
+
+DROP TABLE IF EXISTS `contracts_items`;
+
+CREATE TABLE `contracts_items` (
+  `contractID` int(10) unsigned NOT NULL default '0',
+  `itemID` int(10) unsigned NOT NULL default '0',
+  `typeID` int(10) unsigned NOT NULL default '0',
+  `quantity` int(10) unsigned NOT NULL default '0',
+  `inCrate` tinyint(3) unsigned NOT NULL default '1',
+  PRIMARY KEY  (`contractID`,`itemID`)
+) ENGINE=InnoDB DEFAULT CHARSET=utf8;
+
+/*Data for the table `contracts_items` */
+
 /*Table structure for table `corporation` */
 
 DROP TABLE IF EXISTS `corporation`;
@@ -473,6 +569,26 @@ CREATE TABLE `crpOffices` (
 
 /*Data for the table `crpOffices` */
 
+/*Table structure for table `crpWars` */
+
+DROP TABLE IF EXISTS `crpWars`;
+
+CREATE TABLE `crpWars` (
+  `warID` int(10) unsigned NOT NULL auto_increment,
+  `declaredByID` int(10) unsigned NOT NULL default '0',
+  `againstID` int(10) unsigned NOT NULL default '0',
+  `timeDeclared` bigint(20) unsigned NOT NULL default '0',
+  `timeFinished` bigint(20) unsigned NOT NULL default '0',
+  `retracted` bigint(20) unsigned NOT NULL default '0',
+  `retractedBy` int(10) unsigned NOT NULL default '0',
+  `billID` int(10) unsigned NOT NULL default '0',
+  `mutual` tinyint(1) unsigned NOT NULL default '0',
+  PRIMARY KEY  (`warID`),
+  KEY `timeFinished` (`timeFinished`)
+) ENGINE=InnoDB DEFAULT CHARSET=utf8;
+
+/*Data for the table `crpWars` */
+
 /*Table structure for table `droneState` */
 
 DROP TABLE IF EXISTS `droneState`;
@@ -575,6 +691,24 @@ CREATE TABLE `invBlueprints` (
 
 /*Data for the table `invBlueprints` */
 
+/*Table structure for table `market_history_new` */
+
+DROP TABLE IF EXISTS `market_history_new`;
+
+CREATE TABLE `market_history_new` (
+  `regionID` int(10) unsigned NOT NULL,
+  `typeID` int(10) unsigned NOT NULL,
+  `historyDate` bigint(20) unsigned NOT NULL,
+  `lowPrice` double NOT NULL,
+  `highPrice` double NOT NULL,
+  `avgPrice` double NOT NULL,
+  `volume` bigint(20) NOT NULL,
+  `orders` bigint(20) NOT NULL,
+  PRIMARY KEY  (`regionID`,`typeID`,`historyDate`)
+) ENGINE=InnoDB DEFAULT CHARSET=utf8;
+
+/*Data for the table `market_history_new` */
+
 /*Table structure for table `market_history_old` */
 
 DROP TABLE IF EXISTS `market_history_old`;
@@ -587,7 +721,8 @@ CREATE TABLE `market_history_old` (
   `highPrice` double NOT NULL,
   `avgPrice` double NOT NULL,
   `volume` int(10) unsigned NOT NULL,
-  `orders` int(10) unsigned NOT NULL
+  `orders` int(10) unsigned NOT NULL,
+  PRIMARY KEY  (`regionID`,`typeID`,`historyDate`)
 ) ENGINE=InnoDB DEFAULT CHARSET=utf8;
 
 /*Data for the table `market_history_old` */
@@ -614,6 +749,18 @@ CREATE TABLE `market_journal` (
 
 /*Data for the table `market_journal` */
 
+/*Table structure for table `market_journal_sequence` */
+
+DROP TABLE IF EXISTS `market_journal_sequence`;
+
+CREATE TABLE `market_journal_sequence` (
+  `journalID` int(10) unsigned NOT NULL default '0',
+  `sequence` bigint(20) unsigned NOT NULL default '0',
+  PRIMARY KEY  (`journalID`)
+) ENGINE=InnoDB DEFAULT CHARSET=utf8;
+
+/*Data for the table `market_journal_sequence` */
+
 /*Table structure for table `market_orders` */
 
 DROP TABLE IF EXISTS `market_orders`;
@@ -0,0 +1,11 @@
+DROP TABLE IF EXISTS chrPaperDolls;
+
+-- the doll and the portrait of a character, marshaled and deflated into a single blob
+-- the version is bumped by every save; characters without a row have no doll
+CREATE TABLE chrPaperDolls
+(
+  characterID INT UNSIGNED NOT NULL,
+  version INT UNSIGNED NOT NULL DEFAULT 0,
+  dollData MEDIUMBLOB,
+  PRIMARY KEY (characterID)
+);
@@ -0,0 +1,14 @@
+DROP TABLE IF EXISTS clientTelemetry;
+
+-- the telemetry of the clients, one row per distinct text of a kind
+CREATE TABLE clientTelemetry
+(
+  kind TINYINT UNSIGNED NOT NULL,
+  hash INT UNSIGNED NOT NULL,
+  sample MEDIUMTEXT,
+  reports INT UNSIGNED NOT NULL DEFAULT 0,
+  firstReported BIGINT,
+  lastReported BIGINT,
+  lastCharacterID INT UNSIGNED NOT NULL DEFAULT 0,
+  PRIMARY KEY (kind, hash)
+);
@@ -0,0 +1,28 @@
+DROP TABLE IF EXISTS dunTemplates;
+DROP TABLE IF EXISTS dunTemplateObjects;
+
+-- dungeons (deadspace complexes and mission pockets) which are instanced on demand
+CREATE TABLE dunTemplates
+(
+  dungeonID INT UNSIGNED NOT NULL AUTO_INCREMENT,
+  dungeonName VARCHAR(100) NOT NULL DEFAULT '',
+  factionID INT UNSIGNED NOT NULL DEFAULT 0,
+  PRIMARY KEY (dungeonID)
+);
+
+-- the objects of a dungeon; positions are relative to the dungeon origin
+-- objectKind: 0 = NPC group (spawnGroupID of spawnGroups), 1 = cargo container, 2 = structure
+CREATE TABLE dunTemplateObjects
+(
+  dungeonID INT UNSIGNED NOT NULL,
+  objectIndex SMALLINT UNSIGNED NOT NULL,
+  objectKind TINYINT UNSIGNED NOT NULL DEFAULT 0,
+  typeID INT UNSIGNED NOT NULL DEFAULT 0,
+  spawnGroupID INT UNSIGNED NOT NULL DEFAULT 0,
+  ownerID INT UNSIGNED NOT NULL DEFAULT 0,
+  itemName VARCHAR(100) NOT NULL DEFAULT '',
+  x DOUBLE NOT NULL DEFAULT 0,
+  y DOUBLE NOT NULL DEFAULT 0,
+  z DOUBLE NOT NULL DEFAULT 0,
+  PRIMARY KEY (dungeonID, objectIndex)
+);
@@ -0,0 +1,31 @@
+# indexes behind the hottest queries of the server, found by the index advisor (/dbstats explain)
+# entity_attributes, chrStandings, chrNPCStandings and mailRecipient are served by their primary keys already
+
+# contents of a container, by flag and owner (InventoryDB::GetItemContents); the primary key makes it covering
+ALTER TABLE `entity`
+	ADD KEY `locationID` (`locationID`, `flag`, `ownerID`),
+	ADD KEY `ownerID` (`ownerID`, `flag`);
+
+# the orders of a character (MarketDB::GetCharOrders), the order book by region and type;
+# regionID_2 and typeID_2 duplicate the keys they are named after
+ALTER TABLE `market_orders`
+	DROP KEY `regionID_2`,
+	DROP KEY `typeID_2`,
+	ADD KEY `charID` (`charID`),
+	ADD KEY `regionID_typeID` (`regionID`, `typeID`, `bid`, `price`);
+
+# the transactions of a character since a date (MarketDB::GetTransactions)
+ALTER TABLE `market_transactions`
+	ADD KEY `clientID` (`clientID`, `transactionDateTime`);
+
+# the wallet journal of a character since a date, in the order of the entries (WalletLedger)
+ALTER TABLE `market_journal`
+	ADD KEY `characterID` (`characterID`, `transDate`, `refID`);
+
+# the bookmarks of an owner, by folder (BookmarkDB)
+ALTER TABLE `bookmarks`
+	ADD KEY `ownerID` (`ownerID`, `folderID`);
+
+# the jobs in progress at startup (RamJobScheduler)
+ALTER TABLE `ramJobs`
+	ADD KEY `completedStatusID` (`completedStatusID`, `endProductionTime`);
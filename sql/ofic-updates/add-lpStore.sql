@@ -0,0 +1,24 @@
+DROP TABLE IF EXISTS lpStoreOffers;
+DROP TABLE IF EXISTS lpStoreRequirements;
+
+-- the offers of the LP store of each corporation
+CREATE TABLE lpStoreOffers
+(
+  offerID INT NOT NULL AUTO_INCREMENT,
+  corporationID INT UNSIGNED NOT NULL,
+  typeID INT UNSIGNED NOT NULL,
+  quantity INT UNSIGNED NOT NULL DEFAULT 1,
+  lpCost INT UNSIGNED NOT NULL,
+  iskCost DOUBLE NOT NULL DEFAULT 0,
+  PRIMARY KEY (offerID),
+  KEY corporationID (corporationID)
+);
+
+-- the items an offer takes in exchange, besides LP and ISK
+CREATE TABLE lpStoreRequirements
+(
+  offerID INT NOT NULL,
+  typeID INT UNSIGNED NOT NULL,
+  quantity INT UNSIGNED NOT NULL DEFAULT 1,
+  PRIMARY KEY (offerID, typeID)
+);
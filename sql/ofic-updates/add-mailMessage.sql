@@ -1,17 +1,37 @@
-DROP TABLE IF EXISTS mailMessage;
-
-CREATE TABLE mailMessage
-(
-  messageID INT NOT NULL AUTO_INCREMENT,
-  senderID BIGINT,
-  toCharacterIDs TEXT,
-  toListID INT,
-  toCorpOrAllianceID INT,
-  title TEXT,
-  body BLOB,
-  sentDate BIGINT,
-  statusMask TINYINT,
-  labelMask INT,
-  unread TINYINT,
-  PRIMARY KEY (messageID)
-);
+DROP TABLE IF EXISTS mailMessage;
+DROP TABLE IF EXISTS mailBody;
+DROP TABLE IF EXISTS mailRecipient;
+
+-- bodies are stored once, shared by all the mails with the same body
+CREATE TABLE mailBody
+(
+  bodyID INT NOT NULL AUTO_INCREMENT,
+  hash INT UNSIGNED NOT NULL,
+  body BLOB,
+  PRIMARY KEY (bodyID),
+  KEY hash (hash)
+);
+
+CREATE TABLE mailMessage
+(
+  messageID INT NOT NULL AUTO_INCREMENT,
+  senderID BIGINT,
+  toCharacterIDs TEXT,
+  toListID INT,
+  toCorpOrAllianceID INT,
+  title TEXT,
+  bodyID INT NOT NULL,
+  sentDate BIGINT,
+  PRIMARY KEY (messageID)
+);
+
+-- every recipient has its own status of a mail
+CREATE TABLE mailRecipient
+(
+  messageID INT NOT NULL,
+  characterID INT UNSIGNED NOT NULL,
+  statusMask TINYINT NOT NULL DEFAULT 0,
+  labelMask INT NOT NULL DEFAULT 0,
+  unread TINYINT NOT NULL DEFAULT 1,
+  PRIMARY KEY (characterID, messageID)
+);
@@ -0,0 +1,15 @@
+DROP TABLE IF EXISTS mapSovereignty;
+
+-- the sovereignty and faction warfare state of the solar systems which have any
+CREATE TABLE mapSovereignty
+(
+  solarSystemID INT UNSIGNED NOT NULL,
+  allianceID INT UNSIGNED NOT NULL DEFAULT 0,
+  corporationID INT UNSIGNED NOT NULL DEFAULT 0,
+  claimStructureID INT UNSIGNED NOT NULL DEFAULT 0,
+  hubID INT UNSIGNED NOT NULL DEFAULT 0,
+  claimTime BIGINT UNSIGNED NOT NULL DEFAULT 0,
+  contested TINYINT NOT NULL DEFAULT 0,
+  occupierID INT UNSIGNED NOT NULL DEFAULT 0,
+  PRIMARY KEY (solarSystemID)
+);
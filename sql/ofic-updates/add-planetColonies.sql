@@ -0,0 +1,39 @@
+DROP TABLE IF EXISTS planetPins;
+DROP TABLE IF EXISTS planetColonyContents;
+
+-- pins of the colonies simulated by the server; kind 0 is an extractor, 1 a factory
+-- times are Win32 times (100 ns ticks since 1601)
+CREATE TABLE planetPins
+(
+  pinID INT UNSIGNED NOT NULL AUTO_INCREMENT,
+  planetID INT UNSIGNED NOT NULL,
+  ownerID INT UNSIGNED NOT NULL,
+  typeID INT UNSIGNED NOT NULL DEFAULT 0,
+  kind TINYINT UNSIGNED NOT NULL,
+  latitude DOUBLE NOT NULL DEFAULT 0,
+  longitude DOUBLE NOT NULL DEFAULT 0,
+  schematicID INT UNSIGNED NOT NULL DEFAULT 0,
+  resourceTypeID INT UNSIGNED NOT NULL DEFAULT 0,
+  -- in seconds
+  cycleTime INT UNSIGNED NOT NULL,
+  -- yield of the first cycle of an extractor
+  qtyPerCycle INT UNSIGNED NOT NULL DEFAULT 0,
+  installTime BIGINT UNSIGNED NOT NULL,
+  -- end of the program of an extractor; 0 for factories
+  expiryTime BIGINT UNSIGNED NOT NULL DEFAULT 0,
+  -- end of the last cycle run
+  lastRunTime BIGINT UNSIGNED NOT NULL,
+  PRIMARY KEY (pinID),
+  KEY colony (planetID, ownerID),
+  KEY ownerID (ownerID)
+);
+
+-- the storage of the colonies
+CREATE TABLE planetColonyContents
+(
+  planetID INT UNSIGNED NOT NULL,
+  ownerID INT UNSIGNED NOT NULL,
+  typeID INT UNSIGNED NOT NULL,
+  quantity INT UNSIGNED NOT NULL DEFAULT 0,
+  PRIMARY KEY (planetID, ownerID, typeID)
+);
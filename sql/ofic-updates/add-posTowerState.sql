@@ -0,0 +1,14 @@
+DROP TABLE IF EXISTS posTowerState;
+
+-- states of the control towers simulated by the server; towers without a row are anchored
+-- times are Win32 times (100 ns ticks since 1601)
+CREATE TABLE posTowerState
+(
+  towerID INT UNSIGNED NOT NULL,
+  state TINYINT UNSIGNED NOT NULL DEFAULT 1,
+  -- start of the current fuel cycle; 0 if the tower burns no fuel
+  cycleStart BIGINT UNSIGNED NOT NULL DEFAULT 0,
+  -- end of the reinforcement; 0 if not reinforced
+  reinforcedUntil BIGINT UNSIGNED NOT NULL DEFAULT 0,
+  PRIMARY KEY (towerID)
+);
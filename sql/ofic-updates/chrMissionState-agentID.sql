@@ -0,0 +1,13 @@
+DROP TABLE IF EXISTS chrMissionState;
+
+-- the mission a character runs for an agent; offers are kept in memory only
+CREATE TABLE chrMissionState
+(
+  characterID INT UNSIGNED NOT NULL DEFAULT 0,
+  agentID INT UNSIGNED NOT NULL DEFAULT 0,
+  missionID INT UNSIGNED NOT NULL DEFAULT 0,
+  missionState TINYINT UNSIGNED NOT NULL DEFAULT 0,
+  expirationTime BIGINT UNSIGNED NOT NULL DEFAULT 0,
+  PRIMARY KEY (characterID, agentID),
+  KEY missionID (missionID)
+);
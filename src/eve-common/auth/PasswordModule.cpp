@@ -27,6 +27,7 @@
 
 #include "auth/PasswordModule.h"
 #include "auth/ShaModule.h"
+#include "utils/Utf16.h"
 
 bool PasswordModule::GeneratePassHash(
     const std::string& user,
@@ -47,10 +48,8 @@ bool PasswordModule::GeneratePassHash(
 {
     // Convert username and password to UTF-16
     std::vector< uint16 > username, password;
-    utf8::utf8to16( user, user + userLen,
-                    std::back_inserter( username ) );
-    utf8::utf8to16( pass, pass + passLen,
-                    std::back_inserter( password ) );
+    Utf8ToUtf16( user, userLen, username );
+    Utf8ToUtf16( pass, passLen, password );
 
     // Lowercase the username
     std::transform( username.begin(), username.end(),
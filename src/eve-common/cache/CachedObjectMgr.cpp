@@ -33,10 +33,20 @@
 #include "python/PyRep.h"
 #include "python/PyDumpVisitor.h"
 #include "utils/EVEUtils.h"
+#include "utils/MappedFile.h"
 
 const uint32 CacheFileMagic = 0xFF886622;
+const uint32 CacheFileFormat = 2;
 static const uint32 HackCacheNodeID = 333444;
 
+/// The cached objects, sized by their contents (mapped ones included).
+static MemoryTag sCacheMemoryTag( "cached objects" );
+
+CachedObjectMgr::CachedObjectMgr()
+: m_generation(1)
+{
+}
+
 CachedObjectMgr::~CachedObjectMgr()
 {
     CachedObjMapItr cur, end;
@@ -51,11 +61,15 @@ CachedObjectMgr::~CachedObjectMgr()
 /************************************************************************/
 /* CacheRecord                                                          */
 /************************************************************************/
-CachedObjectMgr::CacheRecord::CacheRecord() : objectID(NULL), timestamp(0), version(0), cache(NULL) {}
+CachedObjectMgr::CacheRecord::CacheRecord() : objectID(NULL), timestamp(0), version(0), cache(NULL), stale(false), hint(NULL) {}
 CachedObjectMgr::CacheRecord::~CacheRecord()
 {
+    if( cache != NULL )
+        sCacheMemoryTag.Release( cache->content().size() );
+
     PyDecRef( objectID );
     PyDecRef( cache );
+    PySafeDecRef( hint );
 }
 
 PyObject *CachedObjectMgr::CacheRecord::EncodeHint() const
@@ -70,6 +84,15 @@ PyObject *CachedObjectMgr::CacheRecord::EncodeHint() const
     return(spec.Encode());
 }
 
+PyObject *CachedObjectMgr::CacheRecord::GetHint() const
+{
+    //the hint only depends on the version, which never changes for a record
+    if(hint == NULL)
+        hint = EncodeHint();
+
+    PyIncRef( hint );
+    return hint;
+}
 
 
 //extract out the string contents of the object ID... if its a single string,
@@ -100,18 +123,87 @@ bool CachedObjectMgr::HaveCached(const PyRep *objectID) const
 {
     const std::string str = OIDToString(objectID);
 
-    return m_cachedObjects.find(str) != m_cachedObjects.end();
+    return _FindCurrent(str) != NULL;
 }
 
 void CachedObjectMgr::InvalidateCache(const PyRep *objectID)
 {
-    const std::string str = OIDToString(objectID);
-    CachedObjMapItr res = m_cachedObjects.find(str);
+    _InvalidateCache(OIDToString(objectID));
+}
 
-    if(res != m_cachedObjects.end()) {
-        SafeDelete( res->second );
-        m_cachedObjects.erase(res);
+void CachedObjectMgr::_InvalidateCache(const std::string &objectID)
+{
+    CachedObjMapItr res = m_cachedObjects.find(objectID);
+
+    //the record is kept until the object is rebuilt, so that
+    //identical contents may keep their version.
+    if(res != m_cachedObjects.end() && !res->second->stale) {
+        res->second->stale = true;
+        ++m_generation;
+    }
+}
+
+void CachedObjectMgr::AddDependency(const PyRep *objectID, const std::string &table, uint32 key)
+{
+    m_dependents[ std::make_pair( table, key ) ].insert( OIDToString( objectID ) );
+}
+
+size_t CachedObjectMgr::InvalidateDependents(const std::string &table, uint32 key)
+{
+    size_t count = 0;
+
+    DependencyMapItr cur, end;
+    if(key == 0) {
+        //everything depending on the table
+        cur = m_dependents.lower_bound( std::make_pair( table, 0u ) );
+        end = m_dependents.upper_bound( std::make_pair( table, 0xFFFFFFFFu ) );
+    } else {
+        //the key and the whole table
+        cur = m_dependents.find( std::make_pair( table, key ) );
+        end = cur;
+        if(end != m_dependents.end())
+            ++end;
+
+        DependencyMapItr whole = m_dependents.find( std::make_pair( table, 0u ) );
+        if(whole != m_dependents.end()) {
+            count += _InvalidateDependents( whole->second );
+            m_dependents.erase( whole );
+        }
+    }
+
+    while(cur != end) {
+        count += _InvalidateDependents( cur->second );
+        m_dependents.erase( cur++ );
     }
+
+    return count;
+}
+
+size_t CachedObjectMgr::_InvalidateDependents(const std::set<std::string> &objectIDs)
+{
+    size_t count = 0;
+
+    std::set<std::string>::const_iterator cur, end;
+    cur = objectIDs.begin();
+    end = objectIDs.end();
+    for(; cur != end; cur++) {
+        if(_FindCurrent(*cur) != NULL) {
+            _InvalidateCache(*cur);
+            ++count;
+        }
+    }
+
+    return count;
+}
+
+CachedObjectMgr::CacheRecord *CachedObjectMgr::_FindCurrent(const std::string &objectID) const
+{
+    CachedObjMapConstItr res = m_cachedObjects.find(objectID);
+
+    if(res == m_cachedObjects.end() || res->second->stale)
+        return NULL;
+
+    return res->second;
 }
 
 //#define RAW_CACHE_CONTENTS
@@ -165,6 +257,30 @@ void CachedObjectMgr::UpdateCache(const PyRep *objectID, PyRep **in_cached_data)
     SafeDelete( data );
 }
 
+void CachedObjectMgr::UpdateCacheMarshaled(const PyRep *objectID, Buffer **in_marshaled_data, bool deflated)
+{
+    Buffer* data = *in_marshaled_data;
+    *in_marshaled_data = NULL;
+
+    if( deflated || DeflateMarshaled( *data ) ) {
+        PyBuffer* buf = new PyBuffer( &data );
+        _UpdateCache( objectID, &buf );
+    } else {
+        sLog.Error( "Cached Obj Mgr", "Failed to deflate new cache object." );
+    }
+
+    SafeDelete( data );
+}
+
+bool CachedObjectMgr::DeflateMarshaled(Buffer &data)
+{
+    //the same limit MarshalDeflate uses by default.
+    if( data.size() >= 0x2000 )
+        return DeflateData( data );
+
+    return true;
+}
+
 void CachedObjectMgr::_UpdateCache(const PyRep *objectID, PyBuffer **buffer)
 {
     //this is the hard one..
@@ -175,6 +291,7 @@ void CachedObjectMgr::_UpdateCache(const PyRep *objectID, PyBuffer **buffer)
     // retake ownership
     r->cache = *buffer;
     *buffer = NULL;
+    sCacheMemoryTag.Retain( r->cache->content().size() );
 
     r->version = CRC32::Generate( &r->cache->content()[0], r->cache->content().size() );
 
@@ -184,14 +301,32 @@ void CachedObjectMgr::_UpdateCache(const PyRep *objectID, PyBuffer **buffer)
     CachedObjMapItr res = m_cachedObjects.find(str);
 
     if(res != m_cachedObjects.end()) {
+        const Buffer &old = res->second->cache->content();
+        const Buffer &cur = r->cache->content();
+
+        if(res->second->version == r->version
+           && old.size() == cur.size()
+           && (cur.size() == 0 || memcmp(&old[0], &cur[0], cur.size()) == 0))
+        {
+            //same contents, keep the old version so the clients do not fetch it again
+            _debug("CachedObjMgr","Cached object with ID '%s' is unchanged, keeping version 0x%x", str.c_str(), r->version);
+            if(res->second->stale) {
+                res->second->stale = false;
+                ++m_generation;
+            }
+            SafeDelete( r );
+            return;
+        }
 
-        sLog.Debug("CachedObjMgr","Destroying old cached object with ID '%s' of length %u with checksum 0x%x", str.c_str(), res->second->cache->content().size(), res->second->version);
+
+        _debug("CachedObjMgr","Destroying old cached object with ID '%s' of length %u with checksum 0x%x", str.c_str(), res->second->cache->content().size(), res->second->version);
         SafeDelete( res->second );
     }
 
-    sLog.Debug("CachedObjMgr","Registering new cached object with ID '%s' of length %u with checksum 0x%x", str.c_str(), r->cache->content().size(), r->version);
+    _debug("CachedObjMgr","Registering new cached object with ID '%s' of length %u with checksum 0x%x", str.c_str(), r->cache->content().size(), r->version);
 
     m_cachedObjects[str] = r;
+    ++m_generation;
 }
 
 PyObject *CachedObjectMgr::MakeCacheHint(const std::string &objectID)
@@ -199,7 +334,7 @@ PyObject *CachedObjectMgr::MakeCacheHint(const std::string &objectID)
     //this is sub-optimal, but it keeps things more consistent (in case StringCollapseVisitor ever gets more complicated)
     PyString *str = new PyString( objectID );
     PyObject * obj = MakeCacheHint(str);
-    PyDecRef(obj);
+    PyDecRef(str);
     return obj;
 }
 
@@ -207,11 +342,11 @@ PyObject *CachedObjectMgr::MakeCacheHint(const PyRep *objectID)
 {
     const std::string str = OIDToString(objectID);
 
-    CachedObjMapItr res = m_cachedObjects.find(str);
-    if(res == m_cachedObjects.end())
+    CacheRecord *record = _FindCurrent(str);
+    if(record == NULL)
         return NULL;
 
-    return res->second->EncodeHint();
+    return record->GetHint();
 }
 
 PyObject *CachedObjectMgr::GetCachedObject(const std::string &objectID)
@@ -227,24 +362,24 @@ PyObject *CachedObjectMgr::GetCachedObject(const PyRep *objectID)
 {
     const std::string str = OIDToString(objectID);
 
-    CachedObjMapItr res = m_cachedObjects.find(str);
-    if(res == m_cachedObjects.end())
+    CacheRecord *record = _FindCurrent(str);
+    if(record == NULL)
         return NULL;
 
     PyCachedObject co;
-    co.timestamp = res->second->timestamp;
-    co.version = res->second->version;
+    co.timestamp = record->timestamp;
+    co.version = record->version;
     co.nodeID = HackCacheNodeID;    //hack, doesn't matter until we have multi-node networks.
     co.shared = true;
-    co.objectID = res->second->objectID->Clone();
-    co.cache = res->second->cache;
+    co.objectID = record->objectID->Clone();
+    co.cache = record->cache;
 
-    if(res->second->cache->content().size() == 0 || res->second->cache->content()[0] == MarshalHeaderByte)
+    if(record->cache->content().size() == 0 || record->cache->content()[0] == MarshalHeaderByte)
         co.compressed = false;
     else
         co.compressed = true;
 
-    sLog.Debug("CachedObjMgr","Returning cached object '%s' with checksum 0x%x", str.c_str(), co.version);
+    _debug("CachedObjMgr","Returning cached object '%s' with checksum 0x%x", str.c_str(), co.version);
 
     PyObject *result = co.Encode();
     co.cache = NULL;    //avoid a copy
@@ -252,17 +387,31 @@ PyObject *CachedObjectMgr::GetCachedObject(const PyRep *objectID)
     return result;
 }
 
+bool CachedObjectMgr::GetCachedVersion(const std::string &objectID, uint32 &version) const
+{
+    //this is sub-optimal, but it keeps things more consistent (in case StringCollapseVisitor ever gets more complicated)
+    PyString *str = new PyString( objectID );
+    const CacheRecord *record = _FindCurrent(OIDToString(str));
+    PyDecRef(str);
+
+    if(record == NULL)
+        return false;
+
+    version = record->version;
+    return true;
+}
+
 bool CachedObjectMgr::IsCacheUpToDate(const PyRep *objectID, uint32 version, uint64 timestamp)
 {
     const std::string str = OIDToString(objectID);
 
-    CachedObjMapItr res = m_cachedObjects.find(str);
-    if(res == m_cachedObjects.end())
+    CacheRecord *record = _FindCurrent(str);
+    if(record == NULL)
         return false;
 
     //for now, only support exact matches...
-    return (   res->second->version == version
-            && res->second->timestamp == timestamp);
+    return (   record->version == version
+            && record->timestamp == timestamp);
 }
 
 bool CachedObjectMgr::LoadCachedFromFile(const std::string &cacheDir, const std::string &objectID)
@@ -286,32 +435,35 @@ bool CachedObjectMgr::LoadCachedFromFile(const std::string &cacheDir, const PyRe
     std::string filename(cacheDir);
     filename += "/" + str + ".cache";
 
-    FILE *f = fopen(filename.c_str(), "rb");
+    RefPtr<MappedFile> file = MappedFile::Open( filename.c_str() );
 
-    if(f == NULL)
+    if( !file )
         return false;
 
     CacheFileHeader header;
-    if(fread(&header, sizeof(header), 1, f) != 1) {
-        fclose(f);
+    if( file->size() < sizeof( header ) )
         return false;
-    }
 
-    /* check if its a valid cache file */
-    if(header.magic != CacheFileMagic) {
-        fclose(f);
+    memcpy( &header, file->data(), sizeof( header ) );
+
+    /* check if its a valid cache file of our format */
+    if( header.magic != CacheFileMagic
+        || header.format != CacheFileFormat
+        || header.length != file->size() - sizeof( header ) )
+    {
+        sLog.Warning( "Cached Obj Mgr", "Ignoring cache file '%s' of unknown format.", filename.c_str() );
         return false;
     }
 
-    Buffer* buf = new Buffer( header.length );
+    const uint8* data = file->data() + sizeof( header );
 
-    if( fread( &(*buf)[0], sizeof( uint8 ), header.length, f ) != header.length ) {
-        SafeDelete( buf );
-        fclose( f );
+    if( CRC32::Generate( data, header.length ) != header.version ) {
+        sLog.Warning( "Cached Obj Mgr", "Ignoring cache file '%s' with bad checksum.", filename.c_str() );
         return false;
     }
 
-    fclose( f );
+    //the bytes are served straight from the mapping
+    Buffer* buf = new Buffer( data, header.length, file );
 
     CachedObjMapItr res = m_cachedObjects.find( str );
 
@@ -321,10 +473,12 @@ bool CachedObjectMgr::LoadCachedFromFile(const std::string &cacheDir, const PyRe
     CacheRecord* cache = m_cachedObjects[ str ] = new CacheRecord;
     cache->objectID = objectID->Clone();
     cache->cache = new PyBuffer( &buf );
+    sCacheMemoryTag.Retain( cache->cache->content().size() );
     cache->timestamp = header.timestamp;
     cache->version = header.version;
 
     m_cachedObjects[ str ] = cache;
+    ++m_generation;
 
     return true;
 }
@@ -341,10 +495,10 @@ bool CachedObjectMgr::SaveCachedToFile(const std::string &cacheDir, const std::s
 bool CachedObjectMgr::SaveCachedToFile(const std::string &cacheDir, const PyRep *objectID) const
 {
     const std::string str = OIDToString(objectID);
-    CachedObjMapConstItr res = m_cachedObjects.find(str);
+    const CacheRecord *record = _FindCurrent(str);
 
     /* make sure we don't try to save a object we don't have */
-    if(res == m_cachedObjects.end())
+    if(record == NULL)
         return false;
 
     std::string filename(cacheDir);
@@ -352,28 +506,49 @@ bool CachedObjectMgr::SaveCachedToFile(const std::string &cacheDir, const PyRep
     filename += str;
     filename += ".cache";
 
-    FILE *f = fopen(filename.c_str(), "wb");
+    //the old file may be mapped, so it is replaced rather than rewritten
+    const std::string tempname = filename + ".tmp";
+
+    FILE *f = fopen(tempname.c_str(), "wb");
 
     if(f == NULL)
         return false;
 
     CacheFileHeader header;
-    header.timestamp = res->second->timestamp;
-    header.version = res->second->version;
+    header.timestamp = record->timestamp;
+    header.version = record->version;
     header.magic = CacheFileMagic;
-    header.length = res->second->cache->content().size();
+    header.format = CacheFileFormat;
+    header.length = record->cache->content().size();
 
     if(fwrite(&header, sizeof(header), 1, f) != 1) {
         fclose(f);
+        remove(tempname.c_str());
         return false;
     }
 
-    if(fwrite(&res->second->cache->content()[0], sizeof(uint8), header.length, f) != header.length) {
+    if(fwrite(&record->cache->content()[0], sizeof(uint8), header.length, f) != header.length) {
         assert(false);
         fclose(f);
+        remove(tempname.c_str());
+        return false;
+    }
+
+    if(fclose(f) != 0) {
+        remove(tempname.c_str());
         return false;
     }
-    fclose(f);
+
+#ifdef WIN32
+    //rename does not replace existing files here
+    remove(filename.c_str());
+#endif /* WIN32 */
+
+    if(rename(tempname.c_str(), filename.c_str()) != 0) {
+        remove(tempname.c_str());
+        return false;
+    }
+
     return true;
 }
 
@@ -442,7 +617,7 @@ PySubStream* CachedObjectMgr::LoadCachedFile( const char* abs_fname, const char*
 
     fclose( f );
 
-    sLog.Debug("CachedObjMgr","Loaded cache file for '%s': length %u", oname, file_length );
+    _debug("CachedObjMgr","Loaded cache file for '%s': length %u", oname, file_length );
 
     return new PySubStream( new PyBuffer( &buf ) );
 }
@@ -0,0 +1,297 @@
+/*
+    ------------------------------------------------------------------------------------
+    LICENSE:
+    ------------------------------------------------------------------------------------
+    This file is part of EVEmu: EVE Online Server Emulator
+    Copyright 2006 - 2011 The EVEmu Team
+    For the latest information visit http://evemu.org
+    ------------------------------------------------------------------------------------
+    This program is free software; you can redistribute it and/or modify it under
+    the terms of the GNU Lesser General Public License as published by the Free Software
+    Foundation; either version 2 of the License, or (at your option) any later
+    version.
+
+    This program is distributed in the hope that it will be useful, but WITHOUT
+    ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+    FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public License along with
+    this program; if not, write to the Free Software Foundation, Inc., 59 Temple
+    Place - Suite 330, Boston, MA 02111-1307, USA, or go to
+    http://www.gnu.org/copyleft/lesser.txt.
+    ------------------------------------------------------------------------------------
+    Author:     EVEmu Team
+*/
+
+#include "eve-common.h"
+
+#include "database/DBRowsetMarshaler.h"
+#include "marshal/EVEMarshal.h"
+#include "marshal/EVEMarshalOpcodes.h"
+#include "marshal/EVEMarshalStringTable.h"
+#include "marshal/EVEZeroCompress.h"
+#include "python/classes/PyDatabase.h"
+#include "python/PyRep.h"
+
+/************************************************************************/
+/* DBRowsetMarshaler                                                    */
+/************************************************************************/
+DBRowsetMarshaler::DBRowsetMarshaler( DBQueryResult& result )
+: mResult( result ),
+  mHeader( new DBRowDescriptor( result ) ),
+  mFixedCount( 0 ),
+  mBoolCount( 0 )
+{
+    MarshalStream stream;
+    stream.SaveItem( mHeader, mHeaderData );
+
+    // the same layout as MarshalStream gives to packed rows: columns
+    // from the greatest to the smallest, in their order within a size
+    const uint32 cc = result.ColumnCount();
+    size_t dataSize = 0;
+
+    static const uint8 sizes[] = { 64, 32, 16, 8, 1, 0 };
+    for( size_t s = 0; s < sizeof( sizes ) / sizeof( uint8 ); ++s )
+    {
+        for( uint32 i = 0; i < cc; ++i )
+        {
+            const DBTYPE type = result.ColumnType( i );
+            const uint8 size = DBTYPE_GetSizeBits( type );
+            if( sizes[ s ] != size )
+                continue;
+
+            mColumns.push_back( i );
+            mTypes.push_back( type );
+
+            if( 1 < size )
+                ++mFixedCount;
+            else if( 1 == size )
+                ++mBoolCount;
+
+            dataSize += size;
+        }
+    }
+
+    mData.resize( ( dataSize + 7 ) >> 3 );
+}
+
+DBRowsetMarshaler::~DBRowsetMarshaler()
+{
+    PyDecRef( mHeader );
+}
+
+bool DBRowsetMarshaler::Save( Buffer& into )
+{
+    const size_t start = into.size();
+
+    // save the rowset without rows; they come before the terminators
+    // of its list and of its dict
+    PyIncRef( mHeader );
+    DBRowDescriptor* header = mHeader;
+    CRowSet* rowset = new CRowSet( &header );
+
+    bool res = Marshal( rowset, into );
+    PyDecRef( rowset );
+
+    if( !res )
+    {
+        into.Resize<uint8>( start );
+        return false;
+    }
+
+    assert( start + 2 <= into.size() );
+    assert( Op_PackedTerminator == into[ into.size() - 2 ] && Op_PackedTerminator == into[ into.size() - 1 ] );
+    into.Resize<uint8>( into.size() - 2 );
+
+    DBResultRow row;
+    while( mResult.GetRow( row ) )
+        SaveRow( row, into );
+
+    // a streamed result may fail halfway
+    if( 0 != mResult.error.GetErrNo() )
+    {
+        into.Resize<uint8>( start );
+        return false;
+    }
+
+    into.Append<uint8>( Op_PackedTerminator );
+    into.Append<uint8>( Op_PackedTerminator );
+    return true;
+}
+
+void DBRowsetMarshaler::SaveRow( const DBResultRow& row, Buffer& into )
+{
+    into.Append<uint8>( Op_PyPackedRow );
+    into.AppendSeq( mHeaderData.begin<uint8>(), mHeaderData.end<uint8>() );
+
+    // Unpack the fixed-size fields; NULLs are zeros:
+    std::fill( mData.begin(), mData.end(), 0 );
+    uint8* data = ( mData.empty() ? NULL : &mData[0] );
+
+    size_t i = 0;
+    for(; i < mFixedCount; ++i )
+    {
+        const uint32 index = mColumns[ i ];
+        const bool null = row.IsNull( index );
+
+        switch( mTypes[ i ] )
+        {
+            case DBTYPE_I8:
+            case DBTYPE_UI8:
+            case DBTYPE_CY:
+            case DBTYPE_FILETIME:
+            {
+                const int64 v = ( null ? 0 : row.GetInt64( index ) );
+                ::memcpy( data, &v, sizeof( v ) );
+                data += sizeof( v );
+            } break;
+
+            case DBTYPE_I4:
+            case DBTYPE_UI4:
+            {
+                const int32 v = ( null ? 0 : row.GetInt( index ) );
+                ::memcpy( data, &v, sizeof( v ) );
+                data += sizeof( v );
+            } break;
+
+            case DBTYPE_I2:
+            case DBTYPE_UI2:
+            {
+                const int16 v = ( null ? 0 : row.GetInt( index ) );
+                ::memcpy( data, &v, sizeof( v ) );
+                data += sizeof( v );
+            } break;
+
+            case DBTYPE_I1:
+            case DBTYPE_UI1:
+            {
+                const int8 v = ( null ? 0 : row.GetInt( index ) );
+                ::memcpy( data, &v, sizeof( v ) );
+                data += sizeof( v );
+            } break;
+
+            case DBTYPE_R8:
+            {
+                const double v = ( null ? 0.0 : row.GetDouble( index ) );
+                ::memcpy( data, &v, sizeof( v ) );
+                data += sizeof( v );
+            } break;
+
+            case DBTYPE_R4:
+            {
+                const float v = static_cast<float>( null ? 0.0 : row.GetDouble( index ) );
+                ::memcpy( data, &v, sizeof( v ) );
+                data += sizeof( v );
+            } break;
+
+            default:
+                // not fixed-size
+                assert( false );
+                break;
+        }
+    }
+
+    // Pack the booleans, 8 per byte:
+    for( uint8 bitOffset = 0; i < mFixedCount + mBoolCount; ++i )
+    {
+        const uint32 index = mColumns[ i ];
+
+        if( 7 < bitOffset )
+        {
+            bitOffset = 0;
+            ++data;
+        }
+
+        const bool v = ( !row.IsNull( index ) && row.GetBool( index ) );
+        *data |= ( v << bitOffset++ );
+    }
+
+    // Zero-compress straight into the stream:
+    ZeroCompressSized( mData.empty() ? NULL : &mData[0], mData.size(), into );
+
+    // Append the fields that are not packed:
+    for(; i < mColumns.size(); ++i )
+        _SaveField( row, mColumns[ i ], mTypes[ i ], into );
+}
+
+void DBRowsetMarshaler::_SaveField( const DBResultRow& row, uint32 index, DBTYPE type, Buffer& into )
+{
+    // saved as MarshalStream saves the rep DBColumnToPyRep() gives
+    if( row.IsNull( index ) )
+    {
+        into.Append<uint8>( Op_PyNone );
+        return;
+    }
+
+    const char* text = row.GetText( index );
+    const uint32 len = row.ColumnLength( index );
+
+    switch( type )
+    {
+        case DBTYPE_STR:
+        {
+            if( 0 == len )
+            {
+                into.Append<uint8>( Op_PyEmptyString );
+            }
+            else if( 1 == len )
+            {
+                into.Append<uint8>( Op_PyCharString );
+                into.Append<uint8>( text[0] );
+            }
+            else
+            {
+                const uint8 tableIndex = sMarshalStringTable.LookupIndex( text, len );
+                if( STRING_TABLE_ERROR != tableIndex )
+                {
+                    into.Append<uint8>( Op_PyStringTableItem );
+                    into.Append<uint8>( tableIndex );
+                }
+                else
+                {
+                    into.Append<uint8>( Op_PyLongString );
+                    _PutSizeEx( len, into );
+                    into.AppendSeq( text, text + len );
+                }
+            }
+        } break;
+
+        case DBTYPE_WSTR:
+        {
+            if( 0 == len )
+            {
+                into.Append<uint8>( Op_PyEmptyWString );
+            }
+            else
+            {
+                into.Append<uint8>( Op_PyWStringUTF8 );
+                _PutSizeEx( len, into );
+                into.AppendSeq( text, text + len );
+            }
+        } break;
+
+        default:
+            sLog.Error( "DBRowsetMarshaler", "invalid column type: %u", type );
+            /* the same hack as DBColumnToPyRep */
+
+        case DBTYPE_BYTES:
+        {
+            into.Append<uint8>( Op_PyBuffer );
+            _PutSizeEx( len, into );
+            into.AppendSeq( text, text + len );
+        } break;
+    }
+}
+
+void DBRowsetMarshaler::_PutSizeEx( uint32 size, Buffer& into )
+{
+    if( size < 0xFF )
+    {
+        into.Append<uint8>( size );
+    }
+    else
+    {
+        into.Append<uint8>( 0xFF );
+        into.Append<uint32>( size );
+    }
+}
@@ -0,0 +1,463 @@
+/*
+    ------------------------------------------------------------------------------------
+    LICENSE:
+    ------------------------------------------------------------------------------------
+    This file is part of EVEmu: EVE Online Server Emulator
+    Copyright 2006 - 2011 The EVEmu Team
+    For the latest information visit http://evemu.org
+    ------------------------------------------------------------------------------------
+    This program is free software; you can redistribute it and/or modify it under
+    the terms of the GNU Lesser General Public License as published by the Free Software
+    Foundation; either version 2 of the License, or (at your option) any later
+    version.
+
+    This program is distributed in the hope that it will be useful, but WITHOUT
+    ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+    FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public License along with
+    this program; if not, write to the Free Software Foundation, Inc., 59 Temple
+    Place - Suite 330, Boston, MA 02111-1307, USA, or go to
+    http://www.gnu.org/copyleft/lesser.txt.
+    ------------------------------------------------------------------------------------
+    Author:     EVEmu Team
+*/
+
+
+#include "eve-common.h"
+
+#include "database/DBTable.h"
+#include "python/classes/PyDatabase.h"
+#include "python/PyStatic.h"
+
+/************************************************************************/
+/* DBTableRow                                                           */
+/************************************************************************/
+DBTableRow::DBTableRow()
+: mTable( NULL ),
+  mIndex( 0 )
+{
+}
+
+bool DBTableRow::IsNull( uint32 index ) const
+{
+    return 0 != mTable->mColumns[ index ].nulls[ mIndex ];
+}
+
+const char* DBTableRow::GetText( uint32 index ) const
+{
+    const DBTable::Column& col = mTable->mColumns[ index ];
+    const uint64 value = col.values[ mIndex ];
+
+    char buf[32];
+    switch( col.kind )
+    {
+        case DBTable::KIND_INT:
+            snprintf( buf, sizeof( buf ), "%" PRId64, static_cast< int64 >( value ) );
+            break;
+
+        case DBTable::KIND_UINT:
+            snprintf( buf, sizeof( buf ), "%" PRIu64, value );
+            break;
+
+        case DBTable::KIND_REAL:
+            snprintf( buf, sizeof( buf ), "%.17g", GetDouble( index ) );
+            break;
+
+        default:
+            return IsNull( index ) ? "" : &mTable->mText[ static_cast< size_t >( value ) ];
+    }
+
+    mFormatted = buf;
+    return mFormatted.c_str();
+}
+
+int64 DBTableRow::GetInt64( uint32 index ) const
+{
+    const DBTable::Column& col = mTable->mColumns[ index ];
+
+    switch( col.kind )
+    {
+        case DBTable::KIND_REAL:
+            return static_cast< int64 >( GetDouble( index ) );
+
+        case DBTable::KIND_TEXT:
+            return strtoll( GetText( index ), NULL, 0 );
+
+        default:
+            return static_cast< int64 >( col.values[ mIndex ] );
+    }
+}
+
+uint64 DBTableRow::GetUInt64( uint32 index ) const
+{
+    const DBTable::Column& col = mTable->mColumns[ index ];
+
+    switch( col.kind )
+    {
+        case DBTable::KIND_REAL:
+            return static_cast< uint64 >( GetDouble( index ) );
+
+        case DBTable::KIND_TEXT:
+            return strtoull( GetText( index ), NULL, 0 );
+
+        default:
+            return col.values[ mIndex ];
+    }
+}
+
+double DBTableRow::GetDouble( uint32 index ) const
+{
+    const DBTable::Column& col = mTable->mColumns[ index ];
+
+    switch( col.kind )
+    {
+        case DBTable::KIND_INT:
+            return static_cast< double >( static_cast< int64 >( col.values[ mIndex ] ) );
+
+        case DBTable::KIND_UINT:
+            return static_cast< double >( col.values[ mIndex ] );
+
+        case DBTable::KIND_REAL:
+            return mTable->_GetReal( col, mIndex );
+
+        default:
+            return strtod( GetText( index ), NULL );
+    }
+}
+
+uint32 DBTableRow::ColumnCount() const
+{
+    return mTable->ColumnCount();
+}
+
+const char* DBTableRow::ColumnName( uint32 index ) const
+{
+    return mTable->ColumnName( index );
+}
+
+DBTYPE DBTableRow::ColumnType( uint32 index ) const
+{
+    return mTable->ColumnType( index );
+}
+
+uint32 DBTableRow::ColumnLength( uint32 index ) const
+{
+    const DBTable::Column& col = mTable->mColumns[ index ];
+    if( DBTable::KIND_TEXT == col.kind )
+        return col.lengths[ mIndex ];
+
+    return strlen( GetText( index ) );
+}
+
+/************************************************************************/
+/* DBTable                                                              */
+/************************************************************************/
+DBTable::DBTable()
+: mRowCount( 0 )
+{
+}
+
+uint32 DBTable::FindColumn( const char* name ) const
+{
+    const uint32 cc = ColumnCount();
+
+    for( uint32 i = 0; i < cc; ++i )
+    {
+        if( mColumns[ i ].name == name )
+            return i;
+    }
+
+    return cc;
+}
+
+void DBTable::clear()
+{
+    mColumns.clear();
+    mRowCount = 0;
+    mText.clear();
+}
+
+uint32 DBTable::Load( DBQueryResult& result )
+{
+    clear();
+
+    const uint32 cc = result.ColumnCount();
+    for( uint32 i = 0; i < cc; ++i )
+        _AddColumn( result.ColumnName( i ), result.ColumnType( i ) );
+
+    if( !result.IsStreamed() )
+    {
+        for( uint32 i = 0; i < cc; ++i )
+        {
+            mColumns[ i ].values.reserve( result.GetRowCount() );
+            mColumns[ i ].nulls.reserve( result.GetRowCount() );
+        }
+    }
+
+    DBResultRow row;
+    for(; result.GetRow( row ); ++mRowCount )
+    {
+        for( uint32 i = 0; i < cc; ++i )
+        {
+            Column& col = mColumns[ i ];
+
+            if( row.IsNull( i ) )
+                _AddNull( col );
+            else switch( col.kind )
+            {
+                case KIND_INT:
+                    _AddInt( col, row.GetInt64( i ) );
+                    break;
+
+                case KIND_UINT:
+                    _AddUInt( col, row.GetUInt64( i ) );
+                    break;
+
+                case KIND_REAL:
+                    _AddReal( col, row.GetDouble( i ) );
+                    break;
+
+                default:
+                    _AddText( col, row.GetText( i ), row.ColumnLength( i ) );
+                    break;
+            }
+        }
+    }
+
+    return mRowCount;
+}
+
+bool DBTable::GetRow( uint32 index, DBTableRow& into ) const
+{
+    if( RowCount() <= index )
+        return false;
+
+    into.mTable = this;
+    into.mIndex = index;
+
+    return true;
+}
+
+DBRowDescriptor* DBTable::EncodeHeader() const
+{
+    DBRowDescriptor* header = new DBRowDescriptor;
+
+    std::vector< Column >::const_iterator cur, end;
+    cur = mColumns.begin();
+    end = mColumns.end();
+    for(; cur != end; ++cur )
+        header->AddColumn( cur->name.c_str(), cur->type );
+
+    return header;
+}
+
+PyPackedRow* DBTable::EncodePackedRow( uint32 index, DBRowDescriptor* header ) const
+{
+    PyPackedRow* row = new PyPackedRow( header );
+
+    const uint32 cc = ColumnCount();
+    for( uint32 i = 0; i < cc; ++i )
+        row->SetField( i, EncodeValue( index, i ) );
+
+    return row;
+}
+
+PyObjectEx* DBTable::EncodeCRowset() const
+{
+    DBRowDescriptor* header = EncodeHeader();
+    CRowSet* rowset = new CRowSet( &header );
+
+    const uint32 cc = ColumnCount();
+    for( uint32 r = 0; r < mRowCount; ++r )
+    {
+        PyPackedRow* row = rowset->NewRow();
+        for( uint32 i = 0; i < cc; ++i )
+            row->SetField( i, EncodeValue( r, i ) );
+    }
+
+    return rowset;
+}
+
+PyDict* DBTable::EncodePackedRowDict( uint32 keyIndex ) const
+{
+    DBRowDescriptor* header = EncodeHeader();
+
+    PyDict* res = new PyDict;
+    for( uint32 r = 0; r < mRowCount; ++r )
+    {
+        PyIncRef( header );
+        res->SetItem( EncodeValue( r, keyIndex ), EncodePackedRow( r, header ) );
+    }
+
+    PyDecRef( header );
+    return res;
+}
+
+PyRep* DBTable::EncodeValue( uint32 row, uint32 column ) const
+{
+    const Column& col = mColumns[ column ];
+    if( 0 != col.nulls[ row ] )
+        return PyStatic::NewNone();
+
+    const uint64 value = col.values[ row ];
+    switch( col.type )
+    {
+        case DBTYPE_I1:
+        case DBTYPE_UI1:
+        case DBTYPE_I2:
+        case DBTYPE_UI2:
+        case DBTYPE_I4:
+        case DBTYPE_UI4:
+            return PyStatic::NewInt( static_cast< int32 >( value ) );
+
+        case DBTYPE_I8:
+        case DBTYPE_UI8:
+        case DBTYPE_CY:
+        case DBTYPE_FILETIME:
+            return new PyLong( static_cast< int64 >( value ) );
+
+        case DBTYPE_R4:
+        case DBTYPE_R8:
+            return new PyFloat( _GetReal( col, row ) );
+
+        case DBTYPE_BOOL:
+            return PyStatic::NewBool( 0 != value );
+
+        case DBTYPE_STR:
+            return new PyString( &mText[ static_cast< size_t >( value ) ], col.lengths[ row ] );
+
+        case DBTYPE_WSTR:
+            return new PyWString( &mText[ static_cast< size_t >( value ) ], col.lengths[ row ] );
+
+        default:
+        {
+            const uint8* data = reinterpret_cast< const uint8* >( &mText[ static_cast< size_t >( value ) ] );
+            return new PyBuffer( data, data + col.lengths[ row ] );
+        }
+    }
+}
+
+DBTable::ColumnKind DBTable::_GetKind( DBTYPE type )
+{
+    switch( type )
+    {
+        case DBTYPE_UI1:
+        case DBTYPE_UI2:
+        case DBTYPE_UI4:
+        case DBTYPE_UI8:
+            return KIND_UINT;
+
+        case DBTYPE_R4:
+        case DBTYPE_R8:
+            return KIND_REAL;
+
+        case DBTYPE_BYTES:
+        case DBTYPE_STR:
+        case DBTYPE_WSTR:
+            return KIND_TEXT;
+
+        default:
+            return KIND_INT;
+    }
+}
+
+DBTYPE DBTable::_MergeType( DBTYPE type, PyRep::PyType value, bool& valid )
+{
+    DBTYPE seen;
+    switch( value )
+    {
+        case PyRep::PyTypeNone:    return type;
+        case PyRep::PyTypeBool:    seen = DBTYPE_BOOL; break;
+        case PyRep::PyTypeInt:     seen = DBTYPE_I4;   break;
+        case PyRep::PyTypeLong:    seen = DBTYPE_I8;   break;
+        case PyRep::PyTypeFloat:   seen = DBTYPE_R8;   break;
+        case PyRep::PyTypeString:  seen = DBTYPE_STR;  break;
+        case PyRep::PyTypeWString: seen = DBTYPE_WSTR; break;
+        default:
+            valid = false;
+            return type;
+    }
+
+    if( DBTYPE_ERROR == type || type == seen )
+        return seen;
+
+    // numbers widen: bool < I4 < I8 < R8; strings widen to WSTR
+    const bool numbers = ( KIND_TEXT != _GetKind( type ) && KIND_TEXT != _GetKind( seen ) );
+    const bool strings = ( KIND_TEXT == _GetKind( type ) && KIND_TEXT == _GetKind( seen ) );
+    if( strings )
+        return DBTYPE_WSTR;
+    if( !numbers )
+    {
+        valid = false;
+        return type;
+    }
+
+    if( DBTYPE_R8 == type || DBTYPE_R8 == seen )
+        return DBTYPE_R8;
+    if( DBTYPE_I8 == type || DBTYPE_I8 == seen )
+        return DBTYPE_I8;
+    return DBTYPE_I4;
+}
+
+void DBTable::_AddColumn( const char* name, DBTYPE type )
+{
+    mColumns.push_back( Column() );
+
+    Column& col = mColumns.back();
+    col.name = name;
+    col.type = type;
+    col.kind = _GetKind( type );
+}
+
+void DBTable::_AddNull( Column& col )
+{
+    col.values.push_back( 0 );
+    if( KIND_TEXT == col.kind )
+        col.lengths.push_back( 0 );
+    col.nulls.push_back( 1 );
+}
+
+void DBTable::_AddInt( Column& col, int64 value )
+{
+    if( KIND_REAL == col.kind )
+        _AddReal( col, static_cast< double >( value ) );
+    else
+    {
+        col.values.push_back( static_cast< uint64 >( value ) );
+        col.nulls.push_back( 0 );
+    }
+}
+
+void DBTable::_AddUInt( Column& col, uint64 value )
+{
+    col.values.push_back( value );
+    col.nulls.push_back( 0 );
+}
+
+void DBTable::_AddReal( Column& col, double value )
+{
+    uint64 bits;
+    memcpy( &bits, &value, sizeof( bits ) );
+
+    col.values.push_back( bits );
+    col.nulls.push_back( 0 );
+}
+
+void DBTable::_AddText( Column& col, const char* text, uint32 length )
+{
+    col.values.push_back( mText.size() );
+    col.lengths.push_back( length );
+    col.nulls.push_back( 0 );
+
+    mText.append( text, length );
+    mText += '\0';
+}
+
+double DBTable::_GetReal( const Column& col, uint32 row ) const
+{
+    double value;
+    memcpy( &value, &col.values[ row ], sizeof( value ) );
+
+    return value;
+}
@@ -25,11 +25,14 @@
 
 #include "eve-common.h"
 
+#include "database/DBRowsetMarshaler.h"
 #include "database/EVEDBUtils.h"
+#include "marshal/EVEMarshalStringTable.h"
 #include "packets/General.h"
 #include "python/classes/PyDatabase.h"
 #include "python/PyVisitor.h"
 #include "python/PyRep.h"
+#include "python/PyStatic.h"
 
 //this is such crap
 /*StringContentsType ClassifyStringContents(const char *str) {
@@ -62,7 +65,7 @@ PyRep* DBColumnToPyRep( const DBResultRow& row, uint32 index )
 {
     /* check for valid column */
     if( row.IsNull( index ) )
-        return new PyNone;
+        return PyStatic::NewNone();
 
     const DBTYPE type = row.ColumnType( index );
     switch( type )
@@ -73,7 +76,7 @@ PyRep* DBColumnToPyRep( const DBResultRow& row, uint32 index )
         case DBTYPE_UI2:
         case DBTYPE_I4:
         case DBTYPE_UI4:
-            return new PyInt( row.GetInt( index ) );
+            return PyStatic::NewInt( row.GetInt( index ) );
 
         case DBTYPE_I8:
         case DBTYPE_UI8:
@@ -84,7 +87,7 @@ PyRep* DBColumnToPyRep( const DBResultRow& row, uint32 index )
             return new PyFloat( row.GetDouble( index ) );
 
         case DBTYPE_BOOL:
-            return new PyBool( row.GetBool(index) );
+            return PyStatic::NewBool( row.GetBool(index) );
 
         case DBTYPE_STR:
             return new PyString( row.GetText( index ), row.ColumnLength( index ) );
@@ -111,9 +114,10 @@ PyObject *DBResultToRowset(DBQueryResult &result)
     uint32 r;
     uint32 cc = result.ColumnCount();
 
+    static const MarshalStringToken type( "util.Rowset" );
+
     PyDict *args = new PyDict();
-    PyObject *res = new PyObject( "util.Rowset" , args
-    );
+    PyObject *res = new PyObject( new PyString( type ), args );
 
     /* check if we have a empty query result and return a empty RowSet */
     if( cc == 0 )
@@ -121,17 +125,17 @@ PyObject *DBResultToRowset(DBQueryResult &result)
 
     //list off the column names:
     PyList *header = new PyList( cc );
-    args->SetItemString("header", header);
+    args->SetItem(PyStatic::NewString("header"), header);
     for(r = 0; r < cc; r++) {
-        header->SetItemString( r, result.ColumnName(r));
+        header->SetItem( r, PyStatic::InternString( result.ColumnName(r) ) );
     }
 
     //RowClass:
-    args->SetItemString("RowClass", new PyToken("util.Row"));
+    args->SetItem(PyStatic::NewString("RowClass"), new PyToken("util.Row"));
 
     //lines:
     PyList *rowlist = new PyList();
-    args->SetItemString("lines", rowlist);
+    args->SetItem(PyStatic::NewString("lines"), rowlist);
 
     //add a line entry for each result row:
     DBResultRow row;
@@ -150,7 +154,7 @@ PyObject *DBResultToRowset(DBQueryResult &result)
 PyTuple *DBResultToTupleSet(DBQueryResult &result) {
     uint32 cc = result.ColumnCount();
     if(cc == 0)
-        return new PyTuple(0);
+        return PyStatic::NewEmptyTuple();
 
     uint32 r;
 
@@ -162,7 +166,7 @@ PyTuple *DBResultToTupleSet(DBQueryResult &result) {
 
     //list off the column names:
     for(r = 0; r < cc; r++) {
-        cols->SetItemString(r, result.ColumnName(r));
+        cols->SetItem( r, PyStatic::InternString( result.ColumnName(r) ) );
     }
 
     //add a line entry for each result row:
@@ -199,26 +203,28 @@ PyObject *DBResultToIndexRowset(DBQueryResult &result, uint32 key_index) {
     uint32 cc = result.ColumnCount();
 
     //start building the IndexRowset
+    static const MarshalStringToken type( "util.IndexRowset" );
+
     PyDict *args = new PyDict();
-    PyObject *res = new PyObject( "util.IndexRowset", args );
+    PyObject *res = new PyObject( new PyString( type ), args );
 
     if(cc == 0 || cc < key_index)
         return res;
 
     //list off the column names:
     PyList *header = new PyList(cc);
-    args->SetItemString("header", header);
+    args->SetItem(PyStatic::NewString("header"), header);
     for(uint32 i = 0; i < cc; i++)
-        header->SetItemString(i, result.ColumnName(i));
+        header->SetItem( i, PyStatic::InternString( result.ColumnName(i) ) );
 
     //RowClass:
-    args->SetItemString("RowClass", new PyToken("util.Row"));
+    args->SetItem(PyStatic::NewString("RowClass"), new PyToken("util.Row"));
     //idName:
-    args->SetItemString("idName", new PyString( result.ColumnName(key_index) ));
+    args->SetItem(PyStatic::NewString("idName"), new PyString( result.ColumnName(key_index) ));
 
     //items:
     PyDict *items = new PyDict();
-    args->SetItemString("items", items);
+    args->SetItem(PyStatic::NewString("items"), items);
 
     //add a line entry for each result row:
     DBResultRow row;
@@ -237,12 +243,14 @@ PyObject *DBResultToIndexRowset(DBQueryResult &result, uint32 key_index) {
 
 PyObject *DBRowToKeyVal(DBResultRow &row) {
 
+    static const MarshalStringToken type( "util.KeyVal" );
+
     PyDict *args = new PyDict();
-    PyObject *res = new PyObject( "util.KeyVal", args );
+    PyObject *res = new PyObject( new PyString( type ), args );
 
     uint32 cc = row.ColumnCount();
     for( uint32 r = 0; r < cc; r++ )
-        args->SetItemString( row.ColumnName(r), DBColumnToPyRep(row, r));
+        args->SetItem( PyStatic::InternString( row.ColumnName(r) ), DBColumnToPyRep(row, r) );
 
     return res;
 }
@@ -256,15 +264,15 @@ PyObject *DBRowToRow(DBResultRow &row, const char *type)
     //list off the column names:
     uint32 cc = row.ColumnCount();
     PyList *header = new PyList(cc);
-    args->SetItemString("header", header);
+    args->SetItem(PyStatic::NewString("header"), header);
 
     for(uint32 r = 0; r < cc; r++) {
-        header->SetItemString(r, row.ColumnName(r));
+        header->SetItem( r, PyStatic::InternString( row.ColumnName(r) ) );
     }
 
     //lines:
     PyList *rowlist = new PyList(cc);
-    args->SetItemString("line", rowlist);
+    args->SetItem(PyStatic::NewString("line"), rowlist);
 
     //add a line entry for the row:
     for(uint32 r = 0; r < cc; r++) {
@@ -277,7 +285,7 @@ PyObject *DBRowToRow(DBResultRow &row, const char *type)
 PyTuple *DBResultToRowList(DBQueryResult &result, const char *type) {
     uint32 cc = result.ColumnCount();
     if(cc == 0)
-        return(new PyTuple(0));
+        return PyStatic::NewEmptyTuple();
     uint32 r;
 
     PyTuple *res = new PyTuple(2);
@@ -288,7 +296,7 @@ PyTuple *DBResultToRowList(DBQueryResult &result, const char *type) {
 
     //list off the column names:
     for(r = 0; r < cc; r++) {
-        cols->SetItemString(r, result.ColumnName(r));
+        cols->SetItem( r, PyStatic::InternString( result.ColumnName(r) ) );
     }
 
     //add a line entry for each result row:
@@ -424,12 +432,15 @@ PyList *DBResultToPackedRowList( DBQueryResult &result )
 {
     DBRowDescriptor *header = new DBRowDescriptor( result );
 
-    PyList *res = new PyList( result.GetRowCount() );
+    // rows of a streamed result are not counted up front
+    PyList *res = new PyList();
+    if( !result.IsStreamed() )
+        res->items.reserve( result.GetRowCount() );
 
     DBResultRow row;
-    for( uint32 i = 0; result.GetRow( row ); i++ )
+    while( result.GetRow( row ) )
     {
-        res->SetItem( i, CreatePackedRow( row, header ) );
+        res->AddItem( CreatePackedRow( row, header ) );
         PyIncRef( header );
     }
 
@@ -442,14 +453,14 @@ PyTuple *DBResultToPackedRowListTuple( DBQueryResult &result )
 {
     DBRowDescriptor * header = new DBRowDescriptor( result );
 
-    size_t row_count = result.GetRowCount();
-    PyList * list = new PyList( row_count );
+    PyList * list = new PyList();
+    if( !result.IsStreamed() )
+        list->items.reserve( result.GetRowCount() );
 
     DBResultRow row;
-    uint32 i = 0;
     while( result.GetRow(row) )
     {
-        list->SetItem( i++, CreatePackedRow( row, header ) );
+        list->AddItem( CreatePackedRow( row, header ) );
         PyIncRef( header );
     }
 
@@ -538,6 +549,12 @@ PyObjectEx *DBResultToCRowset( DBQueryResult &result )
     return rowset;
 }
 
+bool MarshalDBResultToCRowset( DBQueryResult &result, Buffer &into )
+{
+    DBRowsetMarshaler marshaler( result );
+    return marshaler.Save( into );
+}
+
 PyObjectEx *DBResultToCIndexedRowset( DBQueryResult &result, const char *key )
 {
     uint32 cc = result.ColumnCount();
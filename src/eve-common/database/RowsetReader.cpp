@@ -54,51 +54,91 @@ BaseRowsetReader::iterator::iterator()
 }
 
 std::string BaseRowsetReader::iterator::GetAsString( size_t index ) const
+{
+    std::string str;
+    AppendAsString( index, str );
+
+    return str;
+}
+
+void BaseRowsetReader::iterator::AppendAsString( size_t index, std::string& into ) const
 {
     const PyRep::PyType t = GetType( index );
 
+    char buf[64];
     switch( t )
     {
     case PyRep::PyTypeNone:
-        return "NULL";
+        into += "NULL";
+        return;
     case PyRep::PyTypeBool:
-        return itoa( GetBool( index ) ? 1 : 0 );
+        into += ( GetBool( index ) ? '1' : '0' );
+        return;
     case PyRep::PyTypeInt:
-        return itoa( GetInt( index ) );
+        // the values are signed, though the getters are not
+        snprintf( buf, 64, "%d", (int32)GetInt( index ) );
+        break;
     case PyRep::PyTypeLong:
-        return itoa( GetLong( index ) );
+        snprintf( buf, 64, "%" PRId64, (int64)GetLong( index ) );
+        break;
     case PyRep::PyTypeFloat:
-        {
-            char buf[64];
-            snprintf( buf, 64, "%f", GetFloat( index ) );
-            return buf;
-        }
+        snprintf( buf, 64, "%f", GetFloat( index ) );
+        break;
     case PyRep::PyTypeString:
+    case PyRep::PyTypeWString:
         {
-            std::string str = GetString( index );
-            SearchReplace( str, "'", "\\'" );
+            const char* str = ( PyRep::PyTypeString == t ? GetString( index ) : GetWString( index ) );
 
-            str.insert( str.begin(), '\'' );
-            str.insert( str.end(),   '\'' );
-
-            return str;
+            into += '\'';
+            for(; '\0' != *str; ++str )
+            {
+                if( '\'' == *str || '\\' == *str )
+                    into += '\\';
+                into += *str;
+            }
+            into += '\'';
         }
+        return;
+    default:
+        snprintf( buf, 64, "'UNKNOWN TYPE %u'", t );
+        break;
+    }
+
+    into += buf;
+}
+
+void BaseRowsetReader::iterator::AppendAsData( size_t index, std::string& into ) const
+{
+    const PyRep::PyType t = GetType( index );
+
+    switch( t )
+    {
+    case PyRep::PyTypeNone:
+        into += "\\N";
+        break;
+    case PyRep::PyTypeString:
     case PyRep::PyTypeWString:
         {
-            std::string str = GetWString( index );
-            SearchReplace( str, "'", "\\'" );
-
-            str.insert( str.begin(), '\'' );
-            str.insert( str.end(),   '\'' );
+            const char* str = ( PyRep::PyTypeString == t ? GetString( index ) : GetWString( index ) );
 
-            return str;
+            // the escapes LOAD DATA understands by default
+            for(; '\0' != *str; ++str )
+            {
+                switch( *str )
+                {
+                case '\\': into += "\\\\"; break;
+                case '\t': into += "\\t";  break;
+                case '\n': into += "\\n";  break;
+                case '\r': into += "\\r";  break;
+                default:   into += *str;   break;
+                }
+            }
         }
+        break;
     default:
-        {
-            char buf[64];
-            snprintf( buf, 64, "'UNKNOWN TYPE %u'", t );
-            return buf;
-        }
+        // numbers are the same
+        AppendAsString( index, into );
+        break;
     }
 }
 
@@ -244,10 +284,11 @@ void TuplesetReader::iterator::_SetRow( size_t rowIndex )
 /************************************************************************/
 /* SetSQLDumper                                                         */
 /************************************************************************/
-SetSQLDumper::SetSQLDumper( const char* table, const char* keyField, FILE* out )
+SetSQLDumper::SetSQLDumper( const char* table, const char* keyField, FILE* out, const char* dataFile )
 : mTable( table ),
   mKeyField( keyField ),
-  mOut( out )
+  mOut( out ),
+  mDataFile( NULL != dataFile ? dataFile : "" )
 {
 }
 
@@ -296,7 +337,7 @@ bool SetSQLDumper::VisitTuple( const PyTuple* rep )
             else
             {
                 TuplesetReader reader( rowset );
-                if( ReaderToSQL<TuplesetReader>( mTable.c_str(), mKeyField.c_str(), mOut, reader ) )
+                if( ReaderToSQL<TuplesetReader>( mTable.c_str(), mKeyField.c_str(), mOut, reader, _dataFile() ) )
                     return true;
 
                 sLog.Error( "SetSQLDumper", "Failed to convert tupleset to SQL." );
@@ -322,7 +363,7 @@ bool SetSQLDumper::VisitObject( const PyObject* rep )
         else
         {
             RowsetReader reader( rowset );
-            if( ReaderToSQL<RowsetReader>( mTable.c_str(), mKeyField.c_str(), mOut, reader ) )
+            if( ReaderToSQL<RowsetReader>( mTable.c_str(), mKeyField.c_str(), mOut, reader, _dataFile() ) )
                 return true;
 
             sLog.Error( "SetSQLDumper", "Failed to convert rowset to SQL." );
@@ -0,0 +1,116 @@
+/*
+    ------------------------------------------------------------------------------------
+    LICENSE:
+    ------------------------------------------------------------------------------------
+    This file is part of EVEmu: EVE Online Server Emulator
+    Copyright 2006 - 2011 The EVEmu Team
+    For the latest information visit http://evemu.org
+    ------------------------------------------------------------------------------------
+    This program is free software; you can redistribute it and/or modify it under
+    the terms of the GNU Lesser General Public License as published by the Free Software
+    Foundation; either version 2 of the License, or (at your option) any later
+    version.
+
+    This program is distributed in the hope that it will be useful, but WITHOUT
+    ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+    FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public License along with
+    this program; if not, write to the Free Software Foundation, Inc., 59 Temple
+    Place - Suite 330, Boston, MA 02111-1307, USA, or go to
+    http://www.gnu.org/copyleft/lesser.txt.
+    ------------------------------------------------------------------------------------
+    Author:     EVEmu Team
+*/
+
+#include "eve-common.h"
+
+#include "database/DBSnapshot.h"
+#include "database/StaticDataSnapshot.h"
+
+const char* const STATIC_SNAPSHOT_CATEGORIES = "invCategories";
+const char* const STATIC_SNAPSHOT_GROUPS = "invGroups";
+const char* const STATIC_SNAPSHOT_TYPES = "invTypes";
+const char* const STATIC_SNAPSHOT_TYPE_ATTRIBUTES = "dgmTypeAttributes";
+
+const StaticDataSnapshotTable STATIC_SNAPSHOT_TABLES[] =
+{
+    { STATIC_SNAPSHOT_CATEGORIES,
+      "SELECT"
+      " categoryID,"
+      " categoryName,"
+      " description,"
+      " published"
+      " FROM invCategories"
+      " ORDER BY categoryID" },
+    { STATIC_SNAPSHOT_GROUPS,
+      "SELECT"
+      " groupID,"
+      " categoryID,"
+      " groupName,"
+      " description,"
+      " useBasePrice,"
+      " allowManufacture,"
+      " allowRecycler,"
+      " anchored,"
+      " anchorable,"
+      " fittableNonSingleton,"
+      " published"
+      " FROM invGroups"
+      " ORDER BY groupID" },
+    { STATIC_SNAPSHOT_TYPES,
+      "SELECT"
+      " typeID,"
+      " groupID,"
+      " typeName,"
+      " description,"
+      " radius,"
+      " mass,"
+      " volume,"
+      " capacity,"
+      " portionSize,"
+      " raceID,"
+      " basePrice,"
+      " published,"
+      " marketGroupID,"
+      " chanceOfDuplicating"
+      " FROM invTypes"
+      " ORDER BY typeID" },
+    { STATIC_SNAPSHOT_TYPE_ATTRIBUTES,
+      "SELECT"
+      " typeID,"
+      " attributeID,"
+      " valueInt,"
+      " valueFloat"
+      " FROM dgmTypeAttributes"
+      " ORDER BY typeID" }
+};
+const size_t STATIC_SNAPSHOT_TABLE_COUNT = sizeof( STATIC_SNAPSHOT_TABLES ) / sizeof( StaticDataSnapshotTable );
+
+bool BuildStaticDataSnapshot( const char* filename )
+{
+    DBSnapshotWriter writer;
+
+    for( size_t i = 0; i < STATIC_SNAPSHOT_TABLE_COUNT; ++i )
+    {
+        const StaticDataSnapshotTable& table = STATIC_SNAPSHOT_TABLES[ i ];
+
+        DBQueryResult res;
+        if( !sDatabase.RunQuery( res, "%s", table.query ) )
+        {
+            sLog.Error( "StaticDataSnapshot", "Failed to query %s: %s", table.name, res.error.c_str() );
+            return false;
+        }
+
+        const uint32 rows = writer.AddTable( table.name, res );
+        sLog.Log( "StaticDataSnapshot", "Added %u rows of %s.", rows, table.name );
+    }
+
+    if( !writer.Save( filename ) )
+    {
+        sLog.Error( "StaticDataSnapshot", "Failed to write snapshot '%s'.", filename );
+        return false;
+    }
+
+    return true;
+}
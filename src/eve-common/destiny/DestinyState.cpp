@@ -0,0 +1,469 @@
+/*
+    ------------------------------------------------------------------------------------
+    LICENSE:
+    ------------------------------------------------------------------------------------
+    This file is part of EVEmu: EVE Online Server Emulator
+    Copyright 2006 - 2011 The EVEmu Team
+    For the latest information visit http://evemu.org
+    ------------------------------------------------------------------------------------
+    This program is free software; you can redistribute it and/or modify it under
+    the terms of the GNU Lesser General Public License as published by the Free Software
+    Foundation; either version 2 of the License, or (at your option) any later
+    version.
+
+    This program is distributed in the hope that it will be useful, but WITHOUT
+    ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+    FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public License along with
+    this program; if not, write to the Free Software Foundation, Inc., 59 Temple
+    Place - Suite 330, Boston, MA 02111-1307, USA, or go to
+    http://www.gnu.org/copyleft/lesser.txt.
+    ------------------------------------------------------------------------------------
+    Author:     EVEmu Team
+*/
+
+
+#include "eve-common.h"
+
+#include "destiny/DestinyBinDump.h"
+#include "destiny/DestinyState.h"
+
+namespace
+{
+    /* The reals are compared bitwise, as the binaries have them; NaNs do not differ from themselves. */
+    size_t DiffField( LogType into, uint64 id, const char* name, double before, double after )
+    {
+        if( 0 == memcmp( &before, &after, sizeof( double ) ) )
+            return 0;
+
+        _log( into, "    ball %" PRIu64 ": %s %.17g -> %.17g", id, name, before, after );
+        return 1;
+    }
+
+    size_t DiffField( LogType into, uint64 id, const char* name, uint64 before, uint64 after )
+    {
+        if( before == after )
+            return 0;
+
+        _log( into, "    ball %" PRIu64 ": %s %" PRIu64 " -> %" PRIu64, id, name, before, after );
+        return 1;
+    }
+
+    size_t DiffField( LogType into, uint64 id, const char* name, float before, float after )
+    {
+        if( 0 == memcmp( &before, &after, sizeof( float ) ) )
+            return 0;
+
+        _log( into, "    ball %" PRIu64 ": %s %.9g -> %.9g", id, name, before, after );
+        return 1;
+    }
+
+    size_t DiffField( LogType into, uint64 id, const char* name, uint32 before, uint32 after )
+    {
+        return DiffField( into, id, name, (uint64)before, (uint64)after );
+    }
+
+    size_t DiffField( LogType into, uint64 id, const char* name, uint16 before, uint16 after )
+    {
+        return DiffField( into, id, name, (uint64)before, (uint64)after );
+    }
+
+    size_t DiffField( LogType into, uint64 id, const char* name, uint8 before, uint8 after )
+    {
+        return DiffField( into, id, name, (uint64)before, (uint64)after );
+    }
+
+    /* Makes the name printable, replacing non-ASCII characters by '?'. */
+    std::string NameToString( const std::vector< uint16 >& name )
+    {
+        std::string res;
+        res.reserve( name.size() );
+
+        std::vector< uint16 >::const_iterator cur, end;
+        cur = name.begin();
+        end = name.end();
+        for(; cur != end; ++cur )
+            res += ( 0x20 <= *cur && *cur < 0x7F ) ? (char)*cur : '?';
+
+        return res;
+    }
+}
+
+#define DIFF_FIELD( field ) \
+    diffs += DiffField( into, id, #field, before.field, after.field )
+
+namespace Destiny
+{
+    State::State()
+    {
+        clear();
+    }
+
+    void State::SetHeader( uint8 packetType, uint32 sequence )
+    {
+        mHeader.packet_type = packetType;
+        mHeader.sequence = sequence;
+    }
+
+    void State::clear()
+    {
+        SetHeader( 0, 0 );
+        mBalls.clear();
+    }
+
+    bool State::Decode( const uint8* data, size_t len )
+    {
+        clear();
+
+        if( len < sizeof( AddBall_header ) )
+            return false;
+
+        memcpy( &mHeader, data, sizeof( AddBall_header ) );
+        data += sizeof( AddBall_header );
+        len -= sizeof( AddBall_header );
+
+        while( 0 < len )
+        {
+            mBalls.push_back( Ball() );
+
+            const size_t used = _DecodeBall( data, len, mBalls.back() );
+            if( 0 == used )
+            {
+                clear();
+                return false;
+            }
+
+            data += used;
+            len -= used;
+        }
+
+        return true;
+    }
+
+    void State::Encode( Buffer& into ) const
+    {
+        into.Append( mHeader );
+
+        std::vector< Ball >::const_iterator cur, end;
+        cur = mBalls.begin();
+        end = mBalls.end();
+        for(; cur != end; ++cur )
+            _EncodeBall( *cur, into );
+    }
+
+    size_t State::Diff( LogType into, const State& before, const State& after )
+    {
+        size_t diffs = 0;
+
+        if( before.mHeader.packet_type != after.mHeader.packet_type
+            || before.mHeader.sequence != after.mHeader.sequence )
+        {
+            _log( into, "header: packet_type=%u, sequence=%u -> packet_type=%u, sequence=%u",
+                  before.mHeader.packet_type, before.mHeader.sequence,
+                  after.mHeader.packet_type, after.mHeader.sequence );
+            ++diffs;
+        }
+
+        std::map< uint64, const Ball* > beforeBalls;
+        std::vector< Ball >::const_iterator cur, end;
+        cur = before.mBalls.begin();
+        end = before.mBalls.end();
+        for(; cur != end; ++cur )
+            beforeBalls[ cur->head.entityID ] = &*cur;
+
+        cur = after.mBalls.begin();
+        end = after.mBalls.end();
+        for(; cur != end; ++cur )
+        {
+            std::map< uint64, const Ball* >::iterator res = beforeBalls.find( cur->head.entityID );
+            if( beforeBalls.end() == res )
+            {
+                _log( into, "+ ball %" PRIu64 " (%s, \"%s\")", cur->head.entityID,
+                      DSTBALL_modeNames[ cur->head.mode ], NameToString( cur->name ).c_str() );
+                ++diffs;
+                continue;
+            }
+
+            diffs += _DiffBall( into, *res->second, *cur );
+            beforeBalls.erase( res );
+        }
+
+        std::map< uint64, const Ball* >::const_iterator cur_left, end_left;
+        cur_left = beforeBalls.begin();
+        end_left = beforeBalls.end();
+        for(; cur_left != end_left; ++cur_left )
+        {
+            const Ball& ball = *cur_left->second;
+
+            _log( into, "- ball %" PRIu64 " (%s, \"%s\")", ball.head.entityID,
+                  DSTBALL_modeNames[ ball.head.mode ], NameToString( ball.name ).c_str() );
+            ++diffs;
+        }
+
+        return diffs;
+    }
+
+    size_t State::GetModeSize( uint8 mode )
+    {
+        switch( mode )
+        {
+            case DSTBALL_GOTO:      return sizeof( DSTBALL_GOTO_Struct );
+            case DSTBALL_FOLLOW:    return sizeof( DSTBALL_FOLLOW_Struct );
+            case DSTBALL_STOP:      return sizeof( DSTBALL_STOP_Struct );
+            case DSTBALL_WARP:      return sizeof( DSTBALL_WARP_Struct );
+            case DSTBALL_ORBIT:     return sizeof( DSTBALL_ORBIT_Struct );
+            case DSTBALL_MISSILE:   return sizeof( DSTBALL_MISSILE_Struct );
+            case DSTBALL_MUSHROOM:  return sizeof( DSTBALL_MUSHROOM_Struct );
+            case DSTBALL_TROLL:     return sizeof( DSTBALL_TROLL_Struct );
+            case DSTBALL_FIELD:     return sizeof( DSTBALL_FIELD_Struct );
+            case DSTBALL_RIGID:     return sizeof( DSTBALL_RIGID_Struct );
+            case DSTBALL_FORMATION: return sizeof( DSTBALL_FORMATION_Struct );
+            // BOID and MINIBALL are not allowed in a binary
+            default:                return 0;
+        }
+    }
+
+    size_t State::_DecodeBall( const uint8* data, size_t len, Ball& into )
+    {
+        const size_t initLen = len;
+
+        if( len < sizeof( BallHeader ) )
+            return 0;
+        memcpy( &into.head, data, sizeof( BallHeader ) );
+        data += sizeof( BallHeader );
+        len -= sizeof( BallHeader );
+
+        const size_t modeSize = GetModeSize( into.head.mode );
+        if( 0 == modeSize )
+            return 0;
+
+        into.hasMass = ( DSTBALL_RIGID != into.head.mode );
+        if( into.hasMass )
+        {
+            if( len < sizeof( MassSector ) )
+                return 0;
+            memcpy( &into.mass, data, sizeof( MassSector ) );
+            data += sizeof( MassSector );
+            len -= sizeof( MassSector );
+        }
+
+        into.hasShip = ( 0 != ( into.head.sub_type & IsFree ) );
+        if( into.hasShip )
+        {
+            if( len < sizeof( ShipSector ) )
+                return 0;
+            memcpy( &into.ship, data, sizeof( ShipSector ) );
+            data += sizeof( ShipSector );
+            len -= sizeof( ShipSector );
+        }
+
+        if( len < modeSize )
+            return 0;
+        memset( &into.specific, 0, sizeof( SpecificSectors ) );
+        memcpy( &into.specific, data, modeSize );
+        data += modeSize;
+        len -= modeSize;
+
+        into.miniBalls.clear();
+        if( 0 != ( into.head.sub_type & HasMiniBalls ) )
+        {
+            uint16 count;
+            if( len < sizeof( count ) )
+                return 0;
+            memcpy( &count, data, sizeof( count ) );
+            data += sizeof( count );
+            len -= sizeof( count );
+
+            if( len < count * sizeof( MiniBall ) )
+                return 0;
+            into.miniBalls.resize( count );
+            if( 0 < count )
+                memcpy( &into.miniBalls[0], data, count * sizeof( MiniBall ) );
+            data += count * sizeof( MiniBall );
+            len -= count * sizeof( MiniBall );
+        }
+
+        if( len < sizeof( NameStruct ) )
+            return 0;
+        const uint8 nameLen = *data;
+        data += sizeof( NameStruct );
+        len -= sizeof( NameStruct );
+
+        if( len < nameLen * sizeof( uint16 ) )
+            return 0;
+        into.name.resize( nameLen );
+        if( 0 < nameLen )
+            memcpy( &into.name[0], data, nameLen * sizeof( uint16 ) );
+        len -= nameLen * sizeof( uint16 );
+
+        return initLen - len;
+    }
+
+    void State::_EncodeBall( const Ball& ball, Buffer& into )
+    {
+        into.Append( ball.head );
+
+        if( ball.hasMass )
+            into.Append( ball.mass );
+        if( ball.hasShip )
+            into.Append( ball.ship );
+
+        const uint8* specific = reinterpret_cast< const uint8* >( &ball.specific );
+        into.AppendSeq( specific, specific + GetModeSize( ball.head.mode ) );
+
+        if( 0 != ( ball.head.sub_type & HasMiniBalls ) )
+        {
+            const uint16 count = ball.miniBalls.size();
+            into.Append( count );
+            into.AppendSeq( ball.miniBalls.begin(), ball.miniBalls.end() );
+        }
+
+        const uint8 nameLen = ball.name.size();
+        into.Append( nameLen );
+        into.AppendSeq( ball.name.begin(), ball.name.end() );
+    }
+
+    size_t State::_DiffBall( LogType into, const Ball& before, const Ball& after )
+    {
+        const uint64 id = before.head.entityID;
+        size_t diffs = 0;
+
+        DIFF_FIELD( head.mode );
+        DIFF_FIELD( head.radius );
+        DIFF_FIELD( head.x );
+        DIFF_FIELD( head.y );
+        DIFF_FIELD( head.z );
+        DIFF_FIELD( head.sub_type );
+
+        if( before.hasMass && after.hasMass )
+        {
+            DIFF_FIELD( mass.mass );
+            DIFF_FIELD( mass.cloak );
+            DIFF_FIELD( mass.allianceID );
+            DIFF_FIELD( mass.corpID );
+            DIFF_FIELD( mass.Harmonic );
+        }
+
+        if( before.hasShip && after.hasShip )
+        {
+            DIFF_FIELD( ship.max_speed );
+            DIFF_FIELD( ship.velocity_x );
+            DIFF_FIELD( ship.velocity_y );
+            DIFF_FIELD( ship.velocity_z );
+            DIFF_FIELD( ship.agility );
+            DIFF_FIELD( ship.speed_fraction );
+        }
+
+        // the sector of another mode has other fields; the mode change has been logged
+        if( before.head.mode == after.head.mode )
+        {
+            switch( before.head.mode )
+            {
+                case DSTBALL_GOTO:
+                    DIFF_FIELD( specific.GOTO.formationID );
+                    DIFF_FIELD( specific.GOTO.x );
+                    DIFF_FIELD( specific.GOTO.y );
+                    DIFF_FIELD( specific.GOTO.z );
+                    break;
+
+                case DSTBALL_FOLLOW:
+                    DIFF_FIELD( specific.FOLLOW.formationID );
+                    DIFF_FIELD( specific.FOLLOW.followID );
+                    DIFF_FIELD( specific.FOLLOW.followRange );
+                    break;
+
+                case DSTBALL_STOP:
+                    DIFF_FIELD( specific.STOP.formationID );
+                    break;
+
+                case DSTBALL_WARP:
+                    DIFF_FIELD( specific.WARP.formationID );
+                    DIFF_FIELD( specific.WARP.unknown_x );
+                    DIFF_FIELD( specific.WARP.unknown_y );
+                    DIFF_FIELD( specific.WARP.unknown_z );
+                    DIFF_FIELD( specific.WARP.effectStamp );
+                    DIFF_FIELD( specific.WARP.followRange );
+                    DIFF_FIELD( specific.WARP.followID );
+                    DIFF_FIELD( specific.WARP.ownerID );
+                    break;
+
+                case DSTBALL_ORBIT:
+                    DIFF_FIELD( specific.ORBIT.formationID );
+                    DIFF_FIELD( specific.ORBIT.followID );
+                    DIFF_FIELD( specific.ORBIT.followRange );
+                    break;
+
+                case DSTBALL_MISSILE:
+                    DIFF_FIELD( specific.MISSILE.formationID );
+                    DIFF_FIELD( specific.MISSILE.followID );
+                    DIFF_FIELD( specific.MISSILE.followRange );
+                    DIFF_FIELD( specific.MISSILE.ownerID );
+                    DIFF_FIELD( specific.MISSILE.effectStamp );
+                    DIFF_FIELD( specific.MISSILE.x );
+                    DIFF_FIELD( specific.MISSILE.y );
+                    DIFF_FIELD( specific.MISSILE.z );
+                    break;
+
+                case DSTBALL_MUSHROOM:
+                    DIFF_FIELD( specific.MUSHROOM.formationID );
+                    DIFF_FIELD( specific.MUSHROOM.followRange );
+                    DIFF_FIELD( specific.MUSHROOM.unknown125 );
+                    DIFF_FIELD( specific.MUSHROOM.effectStamp );
+                    DIFF_FIELD( specific.MUSHROOM.ownerID );
+                    break;
+
+                case DSTBALL_TROLL:
+                    DIFF_FIELD( specific.TROLL.formationID );
+                    DIFF_FIELD( specific.TROLL.effectStamp );
+                    break;
+
+                case DSTBALL_FIELD:
+                    DIFF_FIELD( specific.FIELD.formationID );
+                    break;
+
+                case DSTBALL_RIGID:
+                    DIFF_FIELD( specific.RIGID.formationID );
+                    break;
+
+                case DSTBALL_FORMATION:
+                    DIFF_FIELD( specific.FORMATION.formationID );
+                    DIFF_FIELD( specific.FORMATION.followID );
+                    DIFF_FIELD( specific.FORMATION.followRange );
+                    DIFF_FIELD( specific.FORMATION.effectStamp );
+                    break;
+            }
+        }
+
+        if( before.miniBalls.size() != after.miniBalls.size() )
+        {
+            _log( into, "    ball %" PRIu64 ": miniball count %lu -> %lu", id,
+                  before.miniBalls.size(), after.miniBalls.size() );
+            ++diffs;
+        }
+        else
+        {
+            for( size_t i = 0; i < before.miniBalls.size(); ++i )
+            {
+                const MiniBall& b = before.miniBalls[ i ];
+                const MiniBall& a = after.miniBalls[ i ];
+
+                if( 0 != memcmp( &b, &a, sizeof( MiniBall ) ) )
+                {
+                    _log( into, "    ball %" PRIu64 ": miniball[%lu] (%.3f, %.3f, %.3f) r=%.2f -> (%.3f, %.3f, %.3f) r=%.2f",
+                          id, i, b.x, b.y, b.z, b.radius, a.x, a.y, a.z, a.radius );
+                    ++diffs;
+                }
+            }
+        }
+
+        if( before.name != after.name )
+        {
+            _log( into, "    ball %" PRIu64 ": name \"%s\" -> \"%s\"", id,
+                  NameToString( before.name ).c_str(), NameToString( after.name ).c_str() );
+            ++diffs;
+        }
+
+        return diffs;
+    }
+}
@@ -28,6 +28,7 @@
 #include "marshal/EVEMarshal.h"
 #include "marshal/EVEMarshalOpcodes.h"
 #include "marshal/EVEMarshalStringTable.h"
+#include "marshal/EVEZeroCompress.h"
 #include "python/classes/PyDatabase.h"
 #include "python/PyRep.h"
 #include "python/PyVisitor.h"
@@ -39,35 +40,186 @@ bool Marshal( const PyRep* rep, Buffer& into )
     return v.Save( rep, into );
 }
 
-bool MarshalDeflate( const PyRep* rep, Buffer& into, const uint32 deflationLimit )
+bool MarshalDeflate( const PyRep* rep, Buffer& into, const uint32 deflationLimit, int level, size_t* marshaledSize )
 {
-    Buffer data;
-    if( !Marshal( rep, data ) )
-        return false;
-
-    if( data.size() >= deflationLimit )
-        return DeflateData( data, into );
-    else
-    {
-        into.AppendSeq( data.begin<uint8>(), data.end<uint8>() );
-        return true;
-    }
+    MarshalStream v;
+    return v.SaveDeflated( rep, into, deflationLimit, level, marshaledSize );
 }
 
+/// Amount of marshaled bytes which is handed over to the compressor at once.
+static const size_t MARSHAL_DEFLATE_CHUNK = 0x10000;
+
 /************************************************************************/
 /* MarshalStream                                                        */
 /************************************************************************/
-MarshalStream::MarshalStream()
-: mBuffer( NULL )
+MarshalStream::MarshalStream( bool tagDispatch )
+: mTagDispatch( tagDispatch ),
+  mBuffer( NULL ),
+  mSize( 0 ),
+  mDeflate( NULL ),
+  mFlushed( 0 ),
+  mSubStreamIndex( 0 ),
+  mRowFixedCount( 0 ),
+  mRowBoolCount( 0 ),
+  mRowDataSize( 0 )
 {
 }
 
 bool MarshalStream::Save( const PyRep* rep, Buffer& into )
 {
+    // the first pass counts the bytes and the sub-stream lengths
+    size_t size;
+    if( !CalcSize( rep, size ) )
+        return false;
+
+    return SaveCounted( rep, into, size );
+}
+
+bool MarshalStream::SaveDeflated( const PyRep* rep, Buffer& into, uint32 deflationLimit, int level, size_t* marshaledSize )
+{
+    size_t size;
+    if( !CalcSize( rep, size ) )
+        return false;
+
+    if( NULL != marshaledSize )
+        *marshaledSize = size;
+
+    // small streams are not deflated, save them right away
+    if( size < deflationLimit )
+        return SaveCounted( rep, into, size );
+
+    DeflateStream deflate( into, level );
+    return SaveCounted( rep, deflate, size )
+        && deflate.Finish();
+}
+
+bool MarshalStream::SaveCounted( const PyRep* rep, Buffer& into, size_t size )
+{
+    // the slack keeps zero-compression of the last rows from reallocating
+    into.Reserve<uint8>( into.size() + size + ZERO_COMPRESS_SLACK );
+
     mBuffer = &into;
+    mSubStreamIndex = 0;
+
+    const size_t start = into.size();
     bool res = SaveStream( rep );
+
+    mBuffer = NULL;
+
+    // the passes must agree, or the sub-stream lengths are wrong
+    assert( !res || into.size() - start == size );
+    return res;
+}
+
+bool MarshalStream::SaveCounted( const PyRep* rep, DeflateStream& into, size_t size )
+{
+    // the marshaled bytes pass through a chunk-sized buffer
+    Buffer chunk;
+    chunk.Reserve<uint8>( std::min( size, MARSHAL_DEFLATE_CHUNK << 1 ) );
+
+    mBuffer = &chunk;
+    mDeflate = &into;
+    mFlushed = 0;
+    mSubStreamIndex = 0;
+
+    bool res = SaveStream( rep );
+
+    if( res && 0 < chunk.size() )
+    {
+        mFlushed += chunk.size();
+        res = into.Write( &chunk[0], chunk.size() );
+    }
+
+    mBuffer = NULL;
+    mDeflate = NULL;
+
+    // the passes must agree, or the sub-stream lengths are wrong
+    assert( !res || mFlushed == size );
+    return res && into.IsValid();
+}
+
+void MarshalStream::FlushDeflate()
+{
+    if( NULL == mDeflate || mBuffer->size() < MARSHAL_DEFLATE_CHUNK )
+        return;
+
+    mFlushed += mBuffer->size();
+    mDeflate->Write( &( *mBuffer )[0], mBuffer->size() );
+
+    // emptied buffer releases its memory, take the next chunk at once
+    mBuffer->Resize<uint8>( 0 );
+    mBuffer->Reserve<uint8>( MARSHAL_DEFLATE_CHUNK << 1 );
+}
+
+bool MarshalStream::SaveItem( const PyRep* rep, Buffer& into )
+{
+    if( rep == NULL )
+        return false;
+
+    // the same two passes as Save(), without the stream header
+    mBuffer = NULL;
+    mSize = 0;
+    mSubStreamSizes.clear();
+
+    if( !SaveRep( rep ) )
+        return false;
+
+    const size_t size = mSize;
+    into.Reserve<uint8>( into.size() + size + ZERO_COMPRESS_SLACK );
+
+    mBuffer = &into;
+    mSubStreamIndex = 0;
+
+    const size_t start = into.size();
+    bool res = SaveRep( rep );
+
     mBuffer = NULL;
 
+    assert( !res || into.size() - start == size );
+    return res;
+}
+
+bool MarshalStream::CalcSize( const PyRep* rep, size_t& size )
+{
+    mBuffer = NULL;
+    mSize = 0;
+    mSubStreamSizes.clear();
+
+    if( !SaveStream( rep ) )
+        return false;
+
+    size = mSize;
+    return true;
+}
+
+void MarshalStream::BeginCount()
+{
+    mBuffer = NULL;
+    mSize = 0;
+    mSubStreamSizes.clear();
+
+    SaveStreamHeader();
+}
+
+size_t MarshalStream::BeginFill( Buffer& into )
+{
+    into.Reserve<uint8>( into.size() + mSize + ZERO_COMPRESS_SLACK );
+
+    mBuffer = &into;
+    mSubStreamIndex = 0;
+
+    const size_t start = into.size();
+    SaveStreamHeader();
+
+    return start;
+}
+
+bool MarshalStream::EndFill( Buffer& into, size_t start, bool res )
+{
+    mBuffer = NULL;
+
+    // the passes must agree, or the sub-stream lengths are wrong
+    assert( !res || into.size() - start == mSize );
     return res;
 }
 
@@ -76,6 +228,12 @@ bool MarshalStream::SaveStream( const PyRep* rep )
     if( rep == NULL )
         return false;
 
+    SaveStreamHeader();
+    return SaveRep( rep );
+}
+
+void MarshalStream::SaveStreamHeader()
+{
     Put<uint8>( MarshalHeaderByte );
     /*
      * Mapcount
@@ -83,14 +241,36 @@ bool MarshalStream::SaveStream( const PyRep* rep )
      * Note: Atm not supported.
      */
     Put<uint32>( 0 ); // Mapcount
+}
+
+bool MarshalStream::SaveRep( const PyRep* rep )
+{
+    if( !mTagDispatch )
+        return rep->visit( *this );
+
+    /* The most common leaves, in the order of their frequency in
+       rowsets, are saved without any virtual call. A chain of compares
+       predicts better than a jump table on the type here; containers
+       and the rest still go through their Visit* method. */
+    const PyRep::PyType type = rep->GetType();
+    if( PyRep::PyTypeInt == type )
+        return MarshalStream::VisitInteger( rep->AsInt() );
+    if( PyRep::PyTypeString == type )
+        return MarshalStream::VisitString( rep->AsString() );
+    if( PyRep::PyTypeNone == type )
+        return MarshalStream::VisitNone( rep->AsNone() );
+    if( PyRep::PyTypeFloat == type )
+        return MarshalStream::VisitReal( rep->AsFloat() );
+    if( PyRep::PyTypeLong == type )
+        return MarshalStream::VisitLong( rep->AsLong() );
+    if( PyRep::PyTypeBool == type )
+        return MarshalStream::VisitBoolean( rep->AsBool() );
 
     return rep->visit( *this );
 }
 
-bool MarshalStream::VisitInteger( const PyInt* rep )
+void MarshalStream::SaveInt( int32 val )
 {
-    const int32 val = rep->value();
-
     if( val == -1 )
     {
         Put<uint8>( Op_PyMinusOne );
@@ -118,14 +298,10 @@ bool MarshalStream::VisitInteger( const PyInt* rep )
         Put<uint8>( Op_PyByte );
         Put<int8>( val );
     }
-
-    return true;
 }
 
-bool MarshalStream::VisitLong( const PyLong* rep )
+void MarshalStream::SaveLong( int64 val )
 {
-    const int64 val = rep->value();
-
     if( val == -1 )
     {
         Put<uint8>( Op_PyMinusOne );
@@ -140,7 +316,7 @@ bool MarshalStream::VisitLong( const PyLong* rep )
     }
     else if( val + 0x800000u > 0xFFFFFFFF )
     {
-        SaveVarInteger( rep );
+        SaveVarInteger( val );
     }
     else if( val + 0x8000u > 0xFFFF )
     {
@@ -157,57 +333,31 @@ bool MarshalStream::VisitLong( const PyLong* rep )
         Put<uint8>( Op_PyByte );
         Put<int8>(static_cast<int8>(val));
     }
-
-    return true;
-}
-
-bool MarshalStream::VisitBoolean( const PyBool* rep )
-{
-    if( rep->value() == true )
-        Put<uint8>( Op_PyTrue );
-    else
-        Put<uint8>( Op_PyFalse );
-
-    return true;
 }
 
-bool MarshalStream::VisitReal( const PyFloat* rep )
+void MarshalStream::SaveReal( double val )
 {
-    if( rep->value() == 0.0 )
+    if( val == 0.0 )
     {
         Put<uint8>( Op_PyZeroReal );
     }
     else
     {
         Put<uint8>( Op_PyReal );
-        Put<double>( rep->value() );
+        Put<double>( val );
     }
-
-    return true;
 }
 
-bool MarshalStream::VisitNone( const PyNone* rep )
-{
-    Put<uint8>( Op_PyNone );
-    return true;
-}
-
-bool MarshalStream::VisitBuffer( const PyBuffer* rep )
+void MarshalStream::SaveBuffer( const uint8* data, size_t len )
 {
     Put<uint8>( Op_PyBuffer );
 
-    const Buffer& buf = rep->content();
-
-    PutSizeEx( buf.size() );
-    Put( buf.begin<uint8>(), buf.end<uint8>() );
-
-    return true;
+    PutSizeEx( len );
+    Put( data, data + len );
 }
 
-bool MarshalStream::VisitString( const PyString* rep )
+void MarshalStream::SaveString( const char* str, size_t len, uint8 tableIndex )
 {
-    size_t len = rep->content().size();
-
     if( len == 0 )
     {
         Put<uint8>( Op_PyEmptyString );
@@ -215,33 +365,31 @@ bool MarshalStream::VisitString( const PyString* rep )
     else if( len == 1 )
     {
         Put<uint8>( Op_PyCharString );
-        Put<uint8>( rep->content()[0] );
+        Put<uint8>( str[0] );
     }
+    //string is long enough for a string table entry, check it.
+    else if( STRING_TABLE_ERROR != tableIndex )
+    {
+        Put<uint8>( Op_PyStringTableItem );
+        Put<uint8>( tableIndex );
+    }
+    // NOTE: they seem to have stopped using Op_PyShortString
     else
     {
-        //string is long enough for a string table entry, check it.
-        const uint8 index = sMarshalStringTable.LookupIndex( rep->content() );
-        if( STRING_TABLE_ERROR != index )
-        {
-            Put<uint8>( Op_PyStringTableItem );
-            Put<uint8>( index );
-        }
-        // NOTE: they seem to have stopped using Op_PyShortString
-        else
-        {
-            Put<uint8>( Op_PyLongString );
-            PutSizeEx( len );
-            Put( rep->content().begin(), rep->content().end() );
-        }
+        Put<uint8>( Op_PyLongString );
+        PutSizeEx( len );
+        Put( str, str + len );
     }
-
-    return true;
 }
 
-bool MarshalStream::VisitWString( const PyWString* rep )
+void MarshalStream::SaveString( const std::string& str )
 {
-    size_t len = rep->content().size();
+    // short strings are never looked up
+    SaveString( str.c_str(), str.size(), ( 1 < str.size() ? sMarshalStringTable.LookupIndex( str ) : STRING_TABLE_ERROR ) );
+}
 
+void MarshalStream::SaveWString( const char* str, size_t len )
+{
     if( 0 == len )
     {
         Put<uint8>( Op_PyEmptyWString );
@@ -253,27 +401,22 @@ bool MarshalStream::VisitWString( const PyWString* rep )
 
         Put<uint8>( Op_PyWStringUTF8 );
         PutSizeEx( len );
-        Put( rep->content().begin(), rep->content().end() );
+        Put( str, str + len );
     }
-
-    return true;
 }
 
-bool MarshalStream::VisitToken( const PyToken* rep )
+void MarshalStream::SaveToken( const char* str, size_t len )
 {
     Put<uint8>( Op_PyToken );
 
-    const std::string& str = rep->content();
-
-    PutSizeEx( str.size() );
-    Put( str.begin(), str.end() );
-
-    return true;
+    PutSizeEx( len );
+    Put( str, str + len );
 }
 
-bool MarshalStream::VisitTuple( const PyTuple* rep )
+void MarshalStream::SaveTupleHeader( uint32 size )
 {
-    uint32 size = rep->size();
+    FlushDeflate();
+
     if( size == 0 )
     {
         Put<uint8>( Op_PyEmptyTuple );
@@ -291,13 +434,12 @@ bool MarshalStream::VisitTuple( const PyTuple* rep )
         Put<uint8>( Op_PyTuple );
         PutSizeEx( size );
     }
-
-    return PyVisitor::VisitTuple( rep );
 }
 
-bool MarshalStream::VisitList( const PyList* rep )
+void MarshalStream::SaveListHeader( uint32 size )
 {
-    uint32 size = rep->size();
+    FlushDeflate();
+
     if( size == 0 )
     {
         Put<uint8>( Op_PyEmptyList );
@@ -311,16 +453,150 @@ bool MarshalStream::VisitList( const PyList* rep )
         Put<uint8>( Op_PyList );
         PutSizeEx( size );
     }
-
-    return PyVisitor::VisitList( rep );
 }
 
-bool MarshalStream::VisitDict( const PyDict* rep )
+void MarshalStream::SaveDictHeader( uint32 size )
 {
-    uint32 size = rep->size();
+    FlushDeflate();
 
     Put<uint8>( Op_PyDict );
     PutSizeEx( size );
+}
+
+size_t MarshalStream::BeginSubStream()
+{
+    Put<uint8>( Op_PySubStream );
+
+    size_t token = 0;
+    if( NULL == mBuffer )
+    {
+        // reserve the slot first, nested sub-streams come after us;
+        // until the end it keeps where the stream starts
+        token = mSubStreamSizes.size();
+        mSubStreamSizes.push_back( mSize );
+    }
+    else
+    {
+        assert( mSubStreamIndex < mSubStreamSizes.size() );
+        PutSizeEx( mSubStreamSizes[ mSubStreamIndex++ ] );
+    }
+
+    SaveStreamHeader();
+    return token;
+}
+
+void MarshalStream::EndSubStream( size_t token )
+{
+    if( NULL == mBuffer )
+    {
+        // the length prefix goes before the stream, count it now
+        const size_t size = mSize - mSubStreamSizes[ token ];
+        mSubStreamSizes[ token ] = size;
+
+        PutSizeEx( size );
+    }
+}
+
+bool MarshalStream::VisitInteger( const PyInt* rep )
+{
+    SaveInt( rep->value() );
+    return true;
+}
+
+bool MarshalStream::VisitLong( const PyLong* rep )
+{
+    SaveLong( rep->value() );
+    return true;
+}
+
+bool MarshalStream::VisitBoolean( const PyBool* rep )
+{
+    SaveBool( rep->value() );
+    return true;
+}
+
+bool MarshalStream::VisitReal( const PyFloat* rep )
+{
+    SaveReal( rep->value() );
+    return true;
+}
+
+bool MarshalStream::VisitNone( const PyNone* rep )
+{
+    SaveNone();
+    return true;
+}
+
+bool MarshalStream::VisitBuffer( const PyBuffer* rep )
+{
+    Put<uint8>( Op_PyBuffer );
+
+    const Buffer& buf = rep->content();
+
+    PutSizeEx( buf.size() );
+    Put( buf.begin<uint8>(), buf.end<uint8>() );
+
+    return true;
+}
+
+bool MarshalStream::VisitString( const PyString* rep )
+{
+    const std::string& str = rep->content();
+
+    // short strings are never looked up
+    SaveString( str.c_str(), str.size(), ( 1 < str.size() ? rep->tableIndex() : STRING_TABLE_ERROR ) );
+    return true;
+}
+
+bool MarshalStream::VisitWString( const PyWString* rep )
+{
+    SaveWString( rep->content() );
+    return true;
+}
+
+bool MarshalStream::VisitToken( const PyToken* rep )
+{
+    const std::string& str = rep->content();
+
+    SaveToken( str.c_str(), str.size() );
+    return true;
+}
+
+bool MarshalStream::VisitTuple( const PyTuple* rep )
+{
+    SaveTupleHeader( rep->size() );
+
+    PyTuple::const_iterator cur, end;
+    cur = rep->begin();
+    end = rep->end();
+    for(; cur != end; ++cur)
+    {
+        if( !SaveRep( *cur ) )
+            return false;
+    }
+
+    return true;
+}
+
+bool MarshalStream::VisitList( const PyList* rep )
+{
+    SaveListHeader( rep->size() );
+
+    PyList::const_iterator cur, end;
+    cur = rep->begin();
+    end = rep->end();
+    for(; cur != end; ++cur)
+    {
+        if( !SaveRep( *cur ) )
+            return false;
+    }
+
+    return true;
+}
+
+bool MarshalStream::VisitDict( const PyDict* rep )
+{
+    SaveDictHeader( rep->size() );
 
     //we have to reverse the order of key/value to be value/key, so do not call base class.
     PyDict::const_iterator cur, end;
@@ -328,9 +604,9 @@ bool MarshalStream::VisitDict( const PyDict* rep )
     end = rep->end();
     for(; cur != end; ++cur)
     {
-        if( !cur->second->visit( *this ) )
+        if( !SaveRep( cur->second ) )
             return false;
-        if( !cur->first->visit( *this ) )
+        if( !SaveRep( cur->first ) )
             return false;
     }
 
@@ -339,8 +615,11 @@ bool MarshalStream::VisitDict( const PyDict* rep )
 
 bool MarshalStream::VisitObject( const PyObject* rep )
 {
-    Put<uint8>( Op_PyObject );
-    return PyVisitor::VisitObject( rep );
+    SaveObjectHeader();
+
+    if( !SaveRep( rep->type() ) )
+        return false;
+    return SaveRep( rep->arguments() );
 }
 
 bool MarshalStream::VisitObjectEx( const PyObjectEx* rep )
@@ -350,7 +629,7 @@ bool MarshalStream::VisitObjectEx( const PyObjectEx* rep )
     else
         Put<uint8>( Op_PyObjectEx1 );
 
-    if( !rep->header()->visit( *this ) )
+    if( !SaveRep( rep->header() ) )
         return false;
 
     {
@@ -359,7 +638,7 @@ bool MarshalStream::VisitObjectEx( const PyObjectEx* rep )
         end = rep->list().end();
         for(; cur != end; ++cur)
         {
-           if( !(*cur)->visit( *this ) )
+           if( !SaveRep( *cur ) )
                return false;
         }
     }
@@ -371,9 +650,9 @@ bool MarshalStream::VisitObjectEx( const PyObjectEx* rep )
         end = rep->dict().end();
         for(; cur != end; ++cur)
         {
-            if( !cur->first->visit( *this ) )
+            if( !SaveRep( cur->first ) )
                 return false;
-            if( !cur->second->visit( *this ) )
+            if( !SaveRep( cur->second ) )
                 return false;
         }
     }
@@ -384,73 +663,74 @@ bool MarshalStream::VisitObjectEx( const PyObjectEx* rep )
 
 bool MarshalStream::VisitPackedRow( const PyPackedRow* rep )
 {
+    FlushDeflate();
+
     Put<uint8>( Op_PyPackedRow );
 
     DBRowDescriptor* header = rep->header();
-    header->visit( *this );
-
-    // Create size map, sorted from the greatest to the smallest value:
-    std::multimap< uint8, uint32, std::greater< uint8 > > sizeMap;
-    uint32 cc = header->ColumnCount();
-    size_t sum = 0;
-
-    for( uint32 i = 0; i < cc; i++ )
-    {
-        uint8 size = DBTYPE_GetSizeBits( header->GetColumnType( i ) );
+    if( !SaveRep( header ) )
+        return false;
 
-        sizeMap.insert( std::make_pair( size, i ) );
-        sum += size;
-    }
+    SetRowHeader( header );
 
-    Buffer unpacked;
-    sum = ( ( sum + 7 ) >> 3 );
-    unpacked.Reserve<uint8>( sum );
+    // Unpack the fixed-size fields, from the greatest to the smallest:
+    mRowData.assign( mRowDataSize, 0 );
+    uint8* data = ( mRowData.empty() ? NULL : &mRowData[0] );
 
-    std::multimap< uint8, uint32, std::greater< uint8 > >::iterator cur, end;
-    cur = sizeMap.begin();
-    end = sizeMap.lower_bound( 1 );
-    for(; cur != end; cur++)
+    size_t i = 0;
+    for(; i < mRowFixedCount; ++i )
     {
-        const uint32 index = cur->second;
-        const PyRep* r = rep->GetField( index );
+        const PyRep* r = rep->GetField( mRowColumns[ i ] );
 
         /* note the assert are disabled because of performance flows */
-        switch( header->GetColumnType( index ) )
+        switch( mRowTypes[ i ] )
         {
             case DBTYPE_I8:
             case DBTYPE_UI8:
             case DBTYPE_CY:
             case DBTYPE_FILETIME:
             {
-                unpacked.Append<int64>( r->IsNone() ? 0 : r->AsLong()->value() );
+                const int64 v = ( r->IsNone() ? 0 : r->AsLong()->value() );
+                ::memcpy( data, &v, sizeof( v ) );
+                data += sizeof( v );
             } break;
 
             case DBTYPE_I4:
             case DBTYPE_UI4:
             {
-                unpacked.Append<int32>( r->IsNone() ? 0 : r->AsInt()->value() );
+                const int32 v = ( r->IsNone() ? 0 : r->AsInt()->value() );
+                ::memcpy( data, &v, sizeof( v ) );
+                data += sizeof( v );
             } break;
 
             case DBTYPE_I2:
             case DBTYPE_UI2:
             {
-                unpacked.Append<int16>( r->IsNone() ? 0 : r->AsInt()->value() );
+                const int16 v = ( r->IsNone() ? 0 : r->AsInt()->value() );
+                ::memcpy( data, &v, sizeof( v ) );
+                data += sizeof( v );
             } break;
 
             case DBTYPE_I1:
             case DBTYPE_UI1:
             {
-                unpacked.Append<int8>( r->IsNone() ? 0 : r->AsInt()->value() );
+                const int8 v = ( r->IsNone() ? 0 : r->AsInt()->value() );
+                ::memcpy( data, &v, sizeof( v ) );
+                data += sizeof( v );
             } break;
 
             case DBTYPE_R8:
             {
-                unpacked.Append<double>( r->IsNone() ? 0.0 : r->AsFloat()->value() );
+                const double v = ( r->IsNone() ? 0.0 : r->AsFloat()->value() );
+                ::memcpy( data, &v, sizeof( v ) );
+                data += sizeof( v );
             } break;
 
             case DBTYPE_R4:
             {
-                unpacked.Append<float>(static_cast<float>(r->IsNone() ? 0.0 : r->AsFloat()->value()));
+                const float v = static_cast<float>( r->IsNone() ? 0.0 : r->AsFloat()->value() );
+                ::memcpy( data, &v, sizeof( v ) );
+                data += sizeof( v );
             } break;
 
             case DBTYPE_BOOL:
@@ -464,74 +744,118 @@ bool MarshalStream::VisitPackedRow( const PyPackedRow* rep )
         }
     }
 
-    uint8 bitOffset = 0;
-    Buffer::iterator<uint8> bitByte;
-
-    cur = sizeMap.lower_bound( 1 );
-    end = sizeMap.lower_bound( 0 );
-    for(; cur != end; ++cur)
+    // Pack the booleans, 8 per byte:
+    for( uint8 bitOffset = 0; i < mRowFixedCount + mRowBoolCount; ++i )
     {
-        const uint32 index = cur->second;
-        const PyBool* r = rep->GetField( index )->AsBool();
+        const PyBool* r = rep->GetField( mRowColumns[ i ] )->AsBool();
 
         if( 7 < bitOffset )
-            bitOffset = 0;
-        if( 0 == bitOffset )
         {
-            bitByte = unpacked.end<uint8>();
-            unpacked.ResizeAt( bitByte, 1 );
+            bitOffset = 0;
+            ++data;
         }
 
-        *bitByte |= ( r->value() << bitOffset++ );
+        *data |= ( r->value() << bitOffset++ );
     }
 
     //pack the bytes with the zero compression algorithm.
-    if( !SaveZeroCompressed( unpacked ) )
+    if( !SaveZeroCompressed( mRowData.empty() ? NULL : &mRowData[0], mRowData.size() ) )
         return false;
 
     // Append fields that are not packed:
-    cur = sizeMap.lower_bound( 0 );
-    end = sizeMap.end();
-    for(; cur != end; cur++)
+    for(; i < mRowColumns.size(); ++i )
     {
-        const uint32 index = cur->second;
-        const PyRep* r = rep->GetField( index );
+        const PyRep* r = rep->GetField( mRowColumns[ i ] );
 
-        if( !r->visit( *this ) )
+        if( !SaveRep( r ) )
             return false;
     }
 
     return true;
 }
 
+void MarshalStream::SetRowHeader( const DBRowDescriptor* header )
+{
+    // rows of a rowset share their column types, so the layout is usually
+    // ready; compare the types, headers may come and go at the same address
+    const uint32 cc = header->ColumnCount();
+    if( cc == mRowHeaderTypes.size() )
+    {
+        uint32 i = 0;
+        for(; i < cc; ++i )
+            if( header->GetColumnType( i ) != mRowHeaderTypes[ i ] )
+                break;
+
+        if( cc == i )
+            return;
+    }
+
+    mRowHeaderTypes.resize( cc );
+    for( uint32 i = 0; i < cc; ++i )
+        mRowHeaderTypes[ i ] = header->GetColumnType( i );
+
+    mRowColumns.clear();
+    mRowTypes.clear();
+    mRowFixedCount = 0;
+    mRowBoolCount = 0;
+    mRowDataSize = 0;
+
+    // Columns are saved from the greatest to the smallest, keeping the
+    // order of the columns of the same size:
+    static const uint8 sizes[] = { 64, 32, 16, 8, 1, 0 };
+    for( size_t s = 0; s < sizeof( sizes ) / sizeof( uint8 ); ++s )
+    {
+        for( uint32 i = 0; i < cc; ++i )
+        {
+            const DBTYPE type = mRowHeaderTypes[ i ];
+            const uint8 size = DBTYPE_GetSizeBits( type );
+            if( sizes[ s ] != size )
+                continue;
+
+            mRowColumns.push_back( i );
+            mRowTypes.push_back( type );
+
+            if( 1 < size )
+                ++mRowFixedCount;
+            else if( 1 == size )
+                ++mRowBoolCount;
+
+            mRowDataSize += size;
+        }
+    }
+
+    mRowDataSize = ( ( mRowDataSize + 7 ) >> 3 );
+}
+
 bool MarshalStream::VisitSubStruct( const PySubStruct* rep )
 {
-    Put<uint8>(Op_PySubStruct);
-    return PyVisitor::VisitSubStruct( rep );
+    SaveSubStructHeader();
+    return SaveRep( rep->sub() );
 }
 
 bool MarshalStream::VisitSubStream( const PySubStream* rep )
 {
-    Put<uint8>(Op_PySubStream);
-
     if(rep->data() == NULL)
     {
         if(rep->decoded() == NULL)
         {
+            Put<uint8>(Op_PySubStream);
             Put<uint8>(0);
             return false;
         }
 
         //unmarshaled stream
-        //we have to marshal the substream.
-        rep->EncodeData();
-        if( rep->data() == NULL )
-        {
-            Put<uint8>(0);
+        //encode it in place, the length is known from the counting pass.
+        const size_t token = BeginSubStream();
+        if( !SaveRep( rep->decoded() ) )
             return false;
-        }
+
+        EndSubStream( token );
+        return true;
     }
 
+    Put<uint8>(Op_PySubStream);
+
     //we have the marshaled data, use it.
     const Buffer& data = rep->data()->content();
 
@@ -553,9 +877,9 @@ bool MarshalStream::VisitChecksumedStream( const PyChecksumedStream* rep )
     return PyVisitor::VisitChecksumedStream( rep );
 }
 
-void MarshalStream::SaveVarInteger( const PyLong* v )
+void MarshalStream::SaveVarInteger( int64 val )
 {
-    const uint64 value = v->value();
+    const uint64 value = val;
     uint8 integerSize = 0;
 
 #define DoIntegerSizeCheck(x) if( ( (uint8*)&value )[x] != 0 ) integerSize = x + 1;
@@ -577,66 +901,37 @@ void MarshalStream::SaveVarInteger( const PyLong* v )
     }
 }
 
-bool MarshalStream::SaveZeroCompressed( const Buffer& data )
-{
-    Buffer packed;
-
-    Buffer::const_iterator<uint8> cur, end;
-    cur = data.begin<uint8>();
-    end = data.end<uint8>();
-    while( cur < end )
-    {
-        // Insert opcode
-        Buffer::iterator<ZeroCompressOpcode> opcode = packed.end<ZeroCompressOpcode>();
-        packed.ResizeAt( opcode, 1 );
-
-#   define OPCODE_ENCODE( opIsZero, opLen )     \
-        if( 0 == *cur )                         \
-        {                                       \
-            opIsZero = true;                    \
-            opLen    = 7;                       \
-                                                \
-            do                                  \
-            {                                   \
-                ++cur;                          \
-                ++opLen;                        \
-            } while( 7 > opLen && cur < end     \
-                     && 0 == *cur );            \
-        }                                       \
-        else /* 0 != *cur */                    \
-        {                                       \
-            opIsZero = false;                   \
-            opLen    = 0;                       \
-                                                \
-            do                                  \
-            {                                   \
-                packed.Append<uint8>( *cur++ ); \
-                --opLen;                        \
-            } while( 0 < opLen && cur < end     \
-                     && 0 != *cur );            \
-        }
-
-        // Encode first part
-        OPCODE_ENCODE( opcode->firstIsZero, opcode->firstLen );
+bool MarshalStream::SaveZeroCompressed( const uint8* data, size_t len )
+{
+    if( NULL == mBuffer )
+    {
+        const size_t packedLen = ZeroCompress( data, len, NULL );
+        PutSizeEx( packedLen );
+        mSize += packedLen;
 
-        // Check whether we have data for second part
-        if( end <= cur )
-        {
-            opcode->secondIsZero = true;
-            opcode->secondLen    = 0;
-            break;
-        }
+        return true;
+    }
 
-        // Encode second part
-        OPCODE_ENCODE( opcode->secondIsZero, opcode->secondLen );
+    const size_t size = mBuffer->size();
+    const size_t maxSize = size + 5 + ZeroCompressBound( len ) + ZERO_COMPRESS_SLACK;
 
-#   undef OPCODE_ENCODE
+    if( maxSize <= mBuffer->capacity() )
+    {
+        // compress straight into the stream, scanning the data only once
+        ZeroCompressSized( data, len, *mBuffer );
     }
+    else
+    {
+        // near the end of the reserved space; count first not to reallocate
+        const size_t packedLen = ZeroCompress( data, len, NULL );
+        PutSizeEx( packedLen );
 
-    // Write the packed data
-    PutSizeEx( packed.size() );
-    if( 0 < packed.size() )
-        Put( packed.begin<uint8>(), packed.end<uint8>() );
+        const size_t start = mBuffer->size();
+        mBuffer->Resize<uint8>( start + packedLen + ZERO_COMPRESS_SLACK );
+
+        ZeroCompress( data, len, &( *mBuffer )[ start ] );
+        mBuffer->Resize<uint8>( start + packedLen );
+    }
 
     return true;
 }
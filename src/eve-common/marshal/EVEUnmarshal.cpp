@@ -32,8 +32,10 @@
 #include "marshal/EVEUnmarshal.h"
 #include "marshal/EVEMarshalOpcodes.h"
 #include "marshal/EVEMarshalStringTable.h"
+#include "marshal/EVEZeroCompress.h"
 
 #include "utils/EVEUtils.h"
+#include "utils/Utf16.h"
 
 PyRep* Unmarshal( const Buffer& data )
 {
@@ -41,7 +43,7 @@ PyRep* Unmarshal( const Buffer& data )
     return v.Load( data );
 }
 
-PyRep* InflateUnmarshal( const Buffer& data )
+PyRep* InflateUnmarshal( const Buffer& data, size_t* inflatedSize )
 {
     if( IsDeflated( data ) )
     {
@@ -49,10 +51,16 @@ PyRep* InflateUnmarshal( const Buffer& data )
         if( !InflateData( data, inflatedData ) )
             return NULL;
 
+        if( NULL != inflatedSize )
+            *inflatedSize = inflatedData.size();
         return Unmarshal( inflatedData );
     }
     else
+    {
+        if( NULL != inflatedSize )
+            *inflatedSize = data.size();
         return Unmarshal( data );
+    }
 }
 
 /************************************************************************/
@@ -224,7 +232,7 @@ PyRep* UnmarshalStream::LoadIntegerVar()
         int32 intval = 0;
         memcpy( &intval, &*data, len );
 
-        return new PyInt( intval );
+        return PyStatic::NewInt( intval );
     }
     else if( sizeof( int64 ) >= len )
     {
@@ -245,7 +253,7 @@ PyRep* UnmarshalStream::LoadStringChar()
 {
     const Buffer::const_iterator<char> str = Read<char>( 1 );
 
-    return new PyString( str, str + 1 );
+    return PyStatic::NewString( &*str, 1 );
 }
 
 PyRep* UnmarshalStream::LoadStringShort()
@@ -253,7 +261,8 @@ PyRep* UnmarshalStream::LoadStringShort()
     const uint8 len = Read<uint8>();
     const Buffer::const_iterator<char> str = Read<char>( len );
 
-    return new PyString( str, str + len );
+    // don't dereference the iterator if the string is empty
+    return PyStatic::NewString( 0 < len ? &*str : "", len );
 }
 
 PyRep* UnmarshalStream::LoadStringLong()
@@ -279,7 +288,7 @@ PyRep* UnmarshalStream::LoadStringTable()
         return new PyString( ebuf );
     }
     else
-        return new PyString( str );
+        return PyStatic::NewString( str );
 }
 
 PyRep* UnmarshalStream::LoadWStringUCS2Char()
@@ -288,7 +297,7 @@ PyRep* UnmarshalStream::LoadWStringUCS2Char()
 
     // convert to UTF-8
     std::string str;
-    utf8::utf16to8( wstr, wstr + 1, std::back_inserter( str ) );
+    Utf16ToUtf8( &*wstr, 1, str );
 
     return new PyWString( str );
 }
@@ -300,7 +309,8 @@ PyRep* UnmarshalStream::LoadWStringUCS2()
 
     // convert to UTF-8
     std::string str;
-    utf8::utf16to8( wstr, wstr + len, std::back_inserter( str ) );
+    if( 0 < len )
+        Utf16ToUtf8( &*wstr, len, str );
 
     return new PyWString( str );
 }
@@ -702,41 +712,11 @@ PyObjectEx* UnmarshalStream::LoadObjectEx( bool is_type_2 )
 bool UnmarshalStream::LoadZeroCompressed( Buffer& into )
 {
     const uint32 packedLen = ReadSizeEx();
+    if( 0 == packedLen )
+        return true;
 
-    Buffer::const_iterator<uint8> cur, end;
-    cur = Read<uint8>( packedLen );
-    end = cur + packedLen;
-    while( cur < end )
-    {
-        // Load opcode
-        const Buffer::const_iterator<ZeroCompressOpcode> opcode = cur.As<ZeroCompressOpcode>();
-        ++cur;
-
-#   define OPCODE_DECODE( opIsZero, opLen )     \
-        if( opIsZero )                          \
-        {                                       \
-            uint8 len = opLen + 1;              \
-            while( 0 < len-- )                  \
-                into.Append<uint8>( 0 );        \
-        }                                       \
-        else                                    \
-        {                                       \
-            const Buffer::const_iterator<uint8> \
-                dataEnd = 8 - opLen < end - cur \
-                          ? cur + ( 8 - opLen ) \
-                          : end;                \
-                                                \
-            into.AppendSeq( cur, dataEnd );     \
-            cur = dataEnd;                      \
-        }
-
-        // Decode first part
-        OPCODE_DECODE( opcode->firstIsZero, opcode->firstLen )
-        // Decode second part
-        OPCODE_DECODE( opcode->secondIsZero, opcode->secondLen )
-
-#   undef OPCODE_DECODE
-    }
+    const Buffer::const_iterator<uint8> cur = Read<uint8>( packedLen );
+    ZeroUncompress( &*cur, packedLen, into );
 
     return true;
 }
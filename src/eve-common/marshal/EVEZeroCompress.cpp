@@ -0,0 +1,297 @@
+/*
+    ------------------------------------------------------------------------------------
+    LICENSE:
+    ------------------------------------------------------------------------------------
+    This file is part of EVEmu: EVE Online Server Emulator
+    Copyright 2006 - 2011 The EVEmu Team
+    For the latest information visit http://evemu.org
+    ------------------------------------------------------------------------------------
+    This program is free software; you can redistribute it and/or modify it under
+    the terms of the GNU Lesser General Public License as published by the Free Software
+    Foundation; either version 2 of the License, or (at your option) any later
+    version.
+
+    This program is distributed in the hope that it will be useful, but WITHOUT
+    ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+    FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public License along with
+    this program; if not, write to the Free Software Foundation, Inc., 59 Temple
+    Place - Suite 330, Boston, MA 02111-1307, USA, or go to
+    http://www.gnu.org/copyleft/lesser.txt.
+    ------------------------------------------------------------------------------------
+    Author:     EVEmu Team
+*/
+
+#include "eve-common.h"
+
+#include "marshal/EVEMarshalOpcodes.h"
+#include "marshal/EVEZeroCompress.h"
+
+#if defined( __SSE2__ ) || defined( _M_X64 ) || ( defined( _M_IX86_FP ) && 2 <= _M_IX86_FP )
+#   define ZERO_COMPRESS_SSE2
+#   include <emmintrin.h>
+#elif defined( __ARM_NEON ) && defined( __aarch64__ )
+#   define ZERO_COMPRESS_NEON
+#   include <arm_neon.h>
+#endif
+
+#ifdef _MSC_VER
+#   include <intrin.h>
+#endif /* _MSC_VER */
+
+/** Number of bytes covered by a single zero mask. */
+static const size_t ZERO_MASK_LEN = 64;
+/** Longest part of an opcode. */
+static const size_t ZERO_PART_LEN = 8;
+
+/* Returns a mask with bit i set if p[i] is zero; n must not exceed ZERO_MASK_LEN. */
+static inline uint64 ZeroMask( const uint8* p, size_t n )
+{
+    uint64 mask = 0;
+    size_t i = 0;
+
+#if defined( ZERO_COMPRESS_SSE2 )
+    const __m128i zero = _mm_setzero_si128();
+    for(; i + 16 <= n; i += 16 )
+    {
+        const __m128i v = _mm_loadu_si128( (const __m128i*)( p + i ) );
+        mask |= (uint64)(uint32)_mm_movemask_epi8( _mm_cmpeq_epi8( v, zero ) ) << i;
+    }
+#elif defined( ZERO_COMPRESS_NEON )
+    static const uint8 weights[ 16 ] = { 1, 2, 4, 8, 16, 32, 64, 128, 1, 2, 4, 8, 16, 32, 64, 128 };
+    const uint8x16_t w = vld1q_u8( weights );
+    for(; i + 16 <= n; i += 16 )
+    {
+        const uint8x16_t v = vandq_u8( vceqzq_u8( vld1q_u8( p + i ) ), w );
+        const uint64 bits = vaddv_u8( vget_low_u8( v ) ) | ( (uint64)vaddv_u8( vget_high_u8( v ) ) << 8 );
+        mask |= bits << i;
+    }
+#endif
+
+    // a word at a time (little endian, as the rest of the marshal code):
+    // the top bit of each byte is left set unless the byte is zero
+    static const uint64 low = 0x7F7F7F7F7F7F7F7FULL;
+    for(; i + 8 <= n; i += 8 )
+    {
+        uint64 x;
+        ::memcpy( &x, p + i, 8 );
+
+        const uint64 zeros = ~( ( ( x & low ) + low ) | x ) & ~low;
+        // gather the top bits into a single byte
+        mask |= ( ( zeros * 0x0002040810204081ULL ) >> 56 ) << i;
+    }
+
+    for(; i < n; ++i )
+        if( 0 == p[ i ] )
+            mask |= (uint64)1 << i;
+
+    return mask;
+}
+
+/* Returns the number of trailing zero bits of the low byte of bits, 8 if it's zero. */
+static inline size_t RunLength( uint64 bits )
+{
+    const uint32 b = (uint32)( bits & 0xFF ) | 0x100;
+
+#if defined( __GNUC__ )
+    return __builtin_ctz( b );
+#elif defined( _MSC_VER )
+    unsigned long index;
+    _BitScanForward( &index, b );
+    return index;
+#else
+    size_t n = 0;
+    while( 0 == ( b & ( 1 << n ) ) )
+        ++n;
+    return n;
+#endif
+}
+
+/* Encodes a single part starting at cur; bits is the zero mask starting
+   at cur. If wide is true, at least ZERO_PART_LEN bytes are known to be
+   left. Written without branches on the kind of the part, which is as
+   good as random. */
+template< bool wide >
+static inline void EncodePart( const uint8*& cur, const uint8* end, uint64 bits,
+                               uint8* out, size_t& size, bool& isZero, uint8& opLen )
+{
+    const size_t zero = (size_t)( bits & 1 );
+    const size_t literal = zero ^ 1;
+    const size_t left = ( wide ? ZERO_PART_LEN : end - cur );
+
+    // count the run of the same kind as the first byte
+    const size_t run = std::min( std::min( ZERO_PART_LEN, left ),
+                                 RunLength( bits ^ ( 0 - (uint64)zero ) ) );
+
+    if( NULL != out )
+    {
+        // copy a whole part; the excess is overwritten by what follows
+        // or ends up in the slack
+        if( ZERO_PART_LEN <= left )
+            ::memcpy( &out[ size ], cur, ZERO_PART_LEN );
+        else
+            for( size_t i = 0; i < run; ++i )
+                out[ size + i ] = cur[ i ];
+    }
+
+    size += run & ( 0 - literal );
+    cur += run;
+
+    // zero runs keep their length - 1, literals 8 - their length
+    isZero = ( 0 != zero );
+    opLen = (uint8)( ( run - 1 + ( ( ZERO_PART_LEN + 1 - 2 * run ) & ( 0 - literal ) ) ) & 7 );
+}
+
+size_t ZeroCompress( const uint8* data, size_t len, uint8* out )
+{
+    const uint8* const end = data + len;
+    const uint8* cur = data;
+    size_t size = 0;
+
+    // zero mask of [win, win + ZERO_MASK_LEN)
+    const uint8* win = cur;
+    uint64 mask = ( ZERO_MASK_LEN <= len ? ZeroMask( win, ZERO_MASK_LEN ) : 0 );
+
+    ZeroCompressOpcode opcode;
+    bool isZero;
+    uint8 opLen;
+
+    // while a whole mask is left
+    while( ZERO_MASK_LEN <= (size_t)( end - cur ) )
+    {
+        const size_t opcodePos = size++;
+
+        // keep both parts within the mask
+        if( ZERO_MASK_LEN < (size_t)( cur - win ) + 2 * ZERO_PART_LEN )
+        {
+            win = cur;
+            mask = ZeroMask( win, ZERO_MASK_LEN );
+        }
+
+        EncodePart< true >( cur, end, mask >> ( cur - win ), out, size, isZero, opLen );
+        opcode.firstIsZero = isZero;
+        opcode.firstLen    = opLen;
+
+        EncodePart< true >( cur, end, mask >> ( cur - win ), out, size, isZero, opLen );
+        opcode.secondIsZero = isZero;
+        opcode.secondLen    = opLen;
+
+        if( NULL != out )
+            out[ opcodePos ] = *(const uint8*)&opcode;
+    }
+
+    // a single mask covers the rest
+    win = cur;
+    mask = ZeroMask( win, end - cur );
+
+    while( cur < end )
+    {
+        const size_t opcodePos = size++;
+
+        EncodePart< false >( cur, end, mask >> ( cur - win ), out, size, isZero, opLen );
+        opcode.firstIsZero = isZero;
+        opcode.firstLen    = opLen;
+
+        if( cur < end )
+            EncodePart< false >( cur, end, mask >> ( cur - win ), out, size, isZero, opLen );
+        else
+        {
+            // no data for the second part
+            isZero = true;
+            opLen  = 0;
+        }
+        opcode.secondIsZero = isZero;
+        opcode.secondLen    = opLen;
+
+        if( NULL != out )
+            out[ opcodePos ] = *(const uint8*)&opcode;
+    }
+
+    return size;
+}
+
+void ZeroCompressSized( const uint8* data, size_t len, Buffer& into )
+{
+    const size_t size = into.size();
+    into.Resize<uint8>( size + 5 + ZeroCompressBound( len ) + ZERO_COMPRESS_SLACK );
+
+    uint8* const out = &into[ size ];
+    const size_t packedLen = ZeroCompress( data, len, out + 5 );
+
+    if( packedLen < 0xFF )
+    {
+        out[ 0 ] = (uint8)packedLen;
+        ::memmove( out + 1, out + 5, packedLen );
+
+        into.Resize<uint8>( size + 1 + packedLen );
+    }
+    else
+    {
+        const uint32 size32 = (uint32)packedLen;
+        out[ 0 ] = 0xFF;
+        ::memcpy( out + 1, &size32, sizeof( size32 ) );
+
+        into.Resize<uint8>( size + 5 + packedLen );
+    }
+}
+
+/* Returns the number of bytes the part will be uncompressed to, advancing
+   cur past its literal bytes. */
+static inline size_t PartLength( bool isZero, uint8 opLen, const uint8*& cur, const uint8* end )
+{
+    if( isZero )
+        return opLen + 1;
+
+    const size_t n = std::min< size_t >( ZERO_PART_LEN - opLen, end - cur );
+    cur += n;
+    return n;
+}
+
+size_t ZeroUncompressedSize( const uint8* data, size_t len )
+{
+    const uint8* const end = data + len;
+    const uint8* cur = data;
+    size_t size = 0;
+
+    while( cur < end )
+    {
+        const ZeroCompressOpcode opcode = *(const ZeroCompressOpcode*)cur++;
+
+        size += PartLength( opcode.firstIsZero, opcode.firstLen, cur, end );
+        size += PartLength( opcode.secondIsZero, opcode.secondLen, cur, end );
+    }
+
+    return size;
+}
+
+void ZeroUncompress( const uint8* data, size_t len, Buffer& into )
+{
+    if( 0 == len )
+        return;
+
+    // the zero runs are filled in by the resize itself
+    const size_t start = into.size();
+    into.Resize< uint8 >( start + ZeroUncompressedSize( data, len ), 0 );
+
+    const uint8* const end = data + len;
+    const uint8* cur = data;
+    uint8* out = &into[ start ];
+
+    while( cur < end )
+    {
+        const ZeroCompressOpcode opcode = *(const ZeroCompressOpcode*)cur++;
+
+        const uint8* literal = cur;
+        size_t n = PartLength( opcode.firstIsZero, opcode.firstLen, cur, end );
+        if( !opcode.firstIsZero )
+            ::memcpy( out, literal, n );
+        out += n;
+
+        literal = cur;
+        n = PartLength( opcode.secondIsZero, opcode.secondLen, cur, end );
+        if( !opcode.secondIsZero )
+            ::memcpy( out, literal, n );
+        out += n;
+    }
+}
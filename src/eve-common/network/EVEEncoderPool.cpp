@@ -0,0 +1,225 @@
+/*
+    ------------------------------------------------------------------------------------
+    LICENSE:
+    ------------------------------------------------------------------------------------
+    This file is part of EVEmu: EVE Online Server Emulator
+    Copyright 2006 - 2011 The EVEmu Team
+    For the latest information visit http://evemu.org
+    ------------------------------------------------------------------------------------
+    This program is free software; you can redistribute it and/or modify it under
+    the terms of the GNU Lesser General Public License as published by the Free Software
+    Foundation; either version 2 of the License, or (at your option) any later
+    version.
+
+    This program is distributed in the hope that it will be useful, but WITHOUT
+    ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+    FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public License along with
+    this program; if not, write to the Free Software Foundation, Inc., 59 Temple
+    Place - Suite 330, Boston, MA 02111-1307, USA, or go to
+    http://www.gnu.org/copyleft/lesser.txt.
+    ------------------------------------------------------------------------------------
+    Author:     EVEmu Team
+*/
+
+#include "eve-common.h"
+
+#include "network/EVEEncoderPool.h"
+#include "network/EVETCPConnection.h"
+#include "python/PyRep.h"
+
+/*************************************************************************/
+/* EVEEncoderPool                                                        */
+/*************************************************************************/
+EVEEncoderPool::EVEEncoderPool()
+: mRunning( false )
+{
+}
+
+EVEEncoderPool::~EVEEncoderPool()
+{
+    Stop();
+}
+
+void EVEEncoderPool::Start( uint32 threadCount )
+{
+    if( mRunning || 0 == threadCount )
+        return;
+
+    mRunning = true;
+
+    for( uint32 i = 0; i < threadCount; ++i )
+    {
+#ifdef WIN32
+        HANDLE thread = CreateThread( NULL, 0, WorkerLoop, this, 0, NULL );
+        if( NULL == thread )
+#else /* !WIN32 */
+        pthread_t thread;
+        if( 0 != pthread_create( &thread, NULL, WorkerLoop, this ) )
+#endif /* !WIN32 */
+        {
+            sLog.Error( "EVEEncoderPool", "Failed to start encoder thread %u.", i );
+            continue;
+        }
+
+        mThreads.push_back( thread );
+    }
+
+    if( mThreads.empty() )
+        mRunning = false;
+}
+
+void EVEEncoderPool::Stop()
+{
+    if( !mRunning )
+        return;
+
+    mRunning = false;
+    mWork.Signal();
+
+    for( size_t i = 0; i < mThreads.size(); ++i )
+    {
+#ifdef WIN32
+        WaitForSingleObject( mThreads[ i ], INFINITE );
+        CloseHandle( mThreads[ i ] );
+#else /* !WIN32 */
+        pthread_join( mThreads[ i ], NULL );
+#endif /* !WIN32 */
+    }
+    mThreads.clear();
+
+    Process();
+}
+
+void EVEEncoderPool::Process()
+{
+    std::vector<const PyRep*> released;
+
+    {
+        MutexLock lock( mMQueue );
+
+        if( mReleased.empty() )
+            return;
+
+        released.swap( mReleased );
+    }
+
+    std::vector<const PyRep*>::iterator cur, end;
+    cur = released.begin();
+    end = released.end();
+    for(; cur != end; ++cur )
+        PyDecRef( *cur );
+}
+
+void EVEEncoderPool::Submit( EVETCPConnection* con )
+{
+    {
+        MutexLock lock( mMQueue );
+
+        mQueue.push_back( con );
+    }
+
+    mWork.Signal();
+}
+
+void EVEEncoderPool::Cancel( EVETCPConnection* con )
+{
+    while( true )
+    {
+        {
+            MutexLock lock( mMQueue );
+
+            mQueue.erase( std::remove( mQueue.begin(), mQueue.end(), con ), mQueue.end() );
+            if( 0 == mInFlight.count( con ) )
+                return;
+        }
+
+        // a worker is still busy with it
+        Sleep( 1 );
+    }
+}
+
+void EVEEncoderPool::Release( const PyRep* rep )
+{
+    // frozen reps may be released by any thread
+    if( rep->IsFrozen() )
+    {
+        PyDecRef( rep );
+        return;
+    }
+
+    MutexLock lock( mMQueue );
+
+    mReleased.push_back( rep );
+}
+
+void EVEEncoderPool::Run()
+{
+    while( true )
+    {
+        EVETCPConnection* con = NULL;
+        bool more = false;
+
+        {
+            MutexLock lock( mMQueue );
+
+            if( !mQueue.empty() )
+            {
+                con = mQueue.front();
+                mQueue.pop_front();
+
+                mInFlight.insert( con );
+                more = !mQueue.empty();
+            }
+        }
+
+        if( NULL == con )
+        {
+            // stop once everything has been encoded
+            if( !mRunning )
+                break;
+
+            mWork.Wait();
+            continue;
+        }
+
+        // pass the wakeup on if there is more work
+        if( more )
+            mWork.Signal();
+
+        con->EncodeQueued();
+
+        {
+            MutexLock lock( mMQueue );
+
+            mInFlight.erase( mInFlight.find( con ) );
+        }
+    }
+
+    // wake up the next worker so it can stop as well
+    mWork.Signal();
+}
+
+#ifdef WIN32
+DWORD WINAPI EVEEncoderPool::WorkerLoop( LPVOID arg )
+#else /* !WIN32 */
+void* EVEEncoderPool::WorkerLoop( void* arg )
+#endif /* !WIN32 */
+{
+    EVEEncoderPool* pool = reinterpret_cast< EVEEncoderPool* >( arg );
+    assert( pool != NULL );
+
+#ifndef WIN32
+    sLog.Log( "Threading", "Starting EVEEncoderPool worker with thread ID %d", pthread_self() );
+#endif /* !WIN32 */
+
+    pool->Run();
+
+#ifdef WIN32
+    return 0;
+#else /* !WIN32 */
+    sLog.Log( "Threading", "Ending EVEEncoderPool worker with thread ID %d", pthread_self() );
+    return NULL;
+#endif /* !WIN32 */
+}
@@ -28,6 +28,7 @@
 #include "marshal/EVEMarshal.h"
 #include "marshal/EVEUnmarshal.h"
 #include "network/EVESession.h"
+#include "network/EVESharedPayload.h"
 #include "packets/Crypto.h"
 #include "python/PyVisitor.h"
 #include "python/PyRep.h"
@@ -37,7 +38,8 @@
 
 EVEClientSession::EVEClientSession( EVETCPConnection** n )
 : mNet( *n ),
-  mPacketHandler( NULL )
+  mPacketHandler( NULL ),
+  mParked( false )
 {
     *n = NULL;
 }
@@ -51,6 +53,7 @@ EVEClientSession::~EVEClientSession()
 void EVEClientSession::Reset()
 {
     mPacketHandler = NULL;
+    mParked = false;
 
     if( GetState() != TCPConnection::STATE_CONNECTED )
         // Connection has been lost, there's no point in reset
@@ -81,10 +84,13 @@ void EVEClientSession::QueuePacket( const PyPacket* p )
     FastQueuePacket( &packet );
 }
 
-void EVEClientSession::FastQueuePacket( PyPacket** p )
+void EVEClientSession::FastQueuePacket( PyPacket** p, CallTrace* trace )
 {
     if(p == NULL || *p == NULL)
+    {
+        sCallTracer.Discard( &trace );
         return;
+    }
 
     PyRep* r = (*p)->Encode();
     // maybe change PyPacket to a object with a reference..
@@ -92,15 +98,39 @@ void EVEClientSession::FastQueuePacket( PyPacket** p )
     if( r == NULL )
     {
         sLog.Error("Network", "%s: Failed to encode a Fast queue packet???", GetAddress().c_str());
+        sCallTracer.Discard( &trace );
         return;
     }
 
-    mNet->QueueRep( r );
+    mNet->QueueRep( r, trace );
     PyDecRef( r );
 }
 
+void EVEClientSession::FastQueuePacket( PyPacket** p, const EVESharedPayload& payload )
+{
+    if(p == NULL || *p == NULL)
+        return;
+
+    const EVETCPConnection::DeflationSettings& deflation = EVETCPConnection::GetDeflation( ( *p )->type );
+    size_t rawSize = 0;
+    Buffer* buf = payload.EncodePacket( **p, deflation.limit, deflation.level, &rawSize );
+    const std::string kind = EVETrafficStats::GetKind( **p );
+    SafeDelete( *p );
+    if( buf == NULL )
+    {
+        sLog.Error("Network", "%s: Failed to encode a shared payload packet.", GetAddress().c_str());
+        return;
+    }
+
+    mNet->QueueBuffer( &buf, kind, rawSize );
+}
+
 PyPacket* EVEClientSession::PopPacket()
 {
+    // the packets wait for the parked authentication
+    if( mParked )
+        return NULL;
+
     PyRep* r = mNet->PopRep();
     if( r == NULL )
         return NULL;
@@ -114,6 +144,15 @@ PyPacket* EVEClientSession::PopPacket()
     return ( this->*mPacketHandler )( r );
 }
 
+void EVEClientSession::_ResumeAuthentication( bool success )
+{
+    assert( mParked );
+    mParked = false;
+
+    if( success )
+        mPacketHandler = &EVEClientSession::_HandleFuncResult;
+}
+
 PyPacket* EVEClientSession::_HandleVersion( PyRep* rep )
 {
     //we are waiting for their version information...
@@ -145,7 +184,7 @@ PyPacket* EVEClientSession::_HandleCommand( PyRep* rep )
         }
         else
         {
-            sLog.Debug("Network", "%s: Got Queue Check command.", GetAddress().c_str());
+            _debug("Network", "%s: Got Queue Check command.", GetAddress().c_str());
 
             //they return position in queue
             PyRep* rsp = new PyInt( _GetQueuePosition() );
@@ -166,7 +205,7 @@ PyPacket* EVEClientSession::_HandleCommand( PyRep* rep )
         }
         else
         {
-            sLog.Debug("Network", "%s: Got VK command, vipKey=%s.", GetAddress().c_str(), cmd.vipKey.c_str());
+            _debug("Network", "%s: Got VK command, vipKey=%s.", GetAddress().c_str(), cmd.vipKey.c_str());
 
             if( _VerifyVIPKey( cmd.vipKey ) )
                 mPacketHandler = &EVEClientSession::_HandleCrypto;
@@ -0,0 +1,275 @@
+/*
+    ------------------------------------------------------------------------------------
+    LICENSE:
+    ------------------------------------------------------------------------------------
+    This file is part of EVEmu: EVE Online Server Emulator
+    Copyright 2006 - 2011 The EVEmu Team
+    For the latest information visit http://evemu.org
+    ------------------------------------------------------------------------------------
+    This program is free software; you can redistribute it and/or modify it under
+    the terms of the GNU Lesser General Public License as published by the Free Software
+    Foundation; either version 2 of the License, or (at your option) any later
+    version.
+
+    This program is distributed in the hope that it will be useful, but WITHOUT
+    ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+    FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public License along with
+    this program; if not, write to the Free Software Foundation, Inc., 59 Temple
+    Place - Suite 330, Boston, MA 02111-1307, USA, or go to
+    http://www.gnu.org/copyleft/lesser.txt.
+    ------------------------------------------------------------------------------------
+    Author:     EVEmu Team
+*/
+
+#include "eve-common.h"
+
+#include "marshal/EVEMarshal.h"
+#include "network/EVESharedPayload.h"
+#include "network/EVETCPConnection.h"
+#include "python/PyPacket.h"
+#include "python/PyRep.h"
+#include "utils/Deflate.h"
+
+/**
+ * @brief Marshal stream which leaves out a shared payload.
+ *
+ * Records where the payload would be placed, so it can
+ * be spliced in later.
+ */
+class SharedPayloadMarshalStream
+: public MarshalStream
+{
+public:
+    SharedPayloadMarshalStream( const PyTuple* payload )
+    : mPayload( payload ),
+      mInto( NULL ),
+      mOffset( 0 ),
+      mFound( false )
+    {
+    }
+
+    /**
+     * @brief Saves everything but the payload.
+     *
+     * @param[in]  rep    The rep to marshal.
+     * @param[out] into   Buffer which receives the marshaled stream.
+     * @param[out] offset Offset of the payload within @a into.
+     *
+     * @retval true  The payload was found exactly once.
+     * @retval false Marshaling failed or the payload was not found.
+     */
+    bool Save( const PyRep* rep, Buffer& into, size_t& offset )
+    {
+        mInto = &into;
+        mFound = false;
+
+        bool res = MarshalStream::Save( rep, into ) && mFound;
+        offset = mOffset;
+
+        mInto = NULL;
+        return res;
+    }
+
+protected:
+    bool VisitTuple( const PyTuple* rep )
+    {
+        if( rep != mPayload )
+            return MarshalStream::VisitTuple( rep );
+        // the payload is left out of the counted size as well
+        else if( IsCounting() )
+            return true;
+        // nested occurence would break the offset
+        else if( mFound )
+            return false;
+
+        mFound = true;
+        mOffset = mInto->size();
+        return true;
+    }
+
+    const PyTuple* const mPayload;
+    Buffer* mInto;
+    size_t mOffset;
+    bool mFound;
+};
+
+/**
+ * @brief Appends data as uncompressed (stored) deflate blocks.
+ *
+ * The output must be byte-aligned, which holds after
+ * the zlib header or a sync flush.
+ */
+static void AppendStoredBlocks( Buffer& into, const uint8* data, size_t len, bool final )
+{
+    do
+    {
+        const uint16 blockLen = std::min<size_t>( len, 0xFFFF );
+        const bool last = ( blockLen == len );
+
+        // BFINAL bit, BTYPE 00 (stored), padded to byte boundary
+        into.Append<uint8>( ( final && last ) ? 1 : 0 );
+        into.Append<uint8>( blockLen & 0xFF );
+        into.Append<uint8>( blockLen >> 8 );
+        into.Append<uint8>( ~blockLen & 0xFF );
+        into.Append<uint8>( ~blockLen >> 8 );
+        into.AppendSeq( data, data + blockLen );
+
+        data += blockLen;
+        len -= blockLen;
+    } while( 0 < len );
+}
+
+/*************************************************************************/
+/* EVESharedPayload                                                      */
+/*************************************************************************/
+EVESharedPayload::EVESharedPayload( PyTuple** payload )
+: RefObject( 0 ),
+  mPayload( *payload ),
+  mMarshaledAdler( 0 )
+{
+    *payload = NULL;
+
+    Buffer stream;
+    if( !Marshal( mPayload, stream ) )
+    {
+        sLog.Error( "Network", "Failed to marshal shared payload." );
+        return;
+    }
+
+    // drop stream header byte and mapcount, the payload
+    // gets embedded into another stream
+    const size_t headerLen = sizeof( uint8 ) + sizeof( uint32 );
+    mMarshaled.AppendSeq( stream.begin<uint8>() + headerLen, stream.end<uint8>() );
+
+    mMarshaledAdler = adler32( adler32( 0, Z_NULL, 0 ), &mMarshaled[0], mMarshaled.size() );
+}
+
+EVESharedPayload::~EVESharedPayload()
+{
+    PyDecRef( mPayload );
+}
+
+Buffer* EVESharedPayload::EncodePacket( PyPacket& packet, uint32 deflationLimit, int level, size_t* marshaledSize ) const
+{
+    assert( packet.payload == mPayload );
+
+    if( !IsValid() )
+        return NULL;
+
+    PyRep* rep = packet.EncodeShared();
+
+    Buffer envelope;
+    size_t offset;
+
+    SharedPayloadMarshalStream stream( mPayload );
+    bool res = stream.Save( rep, envelope, offset );
+    PyDecRef( rep );
+
+    if( !res )
+    {
+        sLog.Error( "Network", "Failed to marshal shared payload envelope." );
+        return NULL;
+    }
+
+    const uint8* head = &envelope[0];
+    const size_t headLen = offset;
+    const uint8* tail = head + headLen;
+    const size_t tailLen = envelope.size() - headLen;
+
+    Buffer* buf = new Buffer;
+
+    // make room for length
+    const Buffer::iterator<uint32> bufLen = buf->end<uint32>();
+    buf->ResizeAt( bufLen, 1 );
+
+    if( headLen + mMarshaled.size() + tailLen < deflationLimit )
+    {
+        buf->AppendSeq( head, head + headLen );
+        buf->AppendSeq( mMarshaled.begin<uint8>(), mMarshaled.end<uint8>() );
+        buf->AppendSeq( tail, tail + tailLen );
+    }
+    else if( _Deflate( level ) )
+    {
+        // zlib header, default compression
+        buf->Append<uint8>( DeflateHeaderByte );
+        buf->Append<uint8>( 0x9C );
+
+        AppendStoredBlocks( *buf, head, headLen, false );
+        buf->AppendSeq( mDeflated.begin<uint8>(), mDeflated.end<uint8>() );
+        AppendStoredBlocks( *buf, tail, tailLen, true );
+
+        uLong adler = adler32( adler32( 0, Z_NULL, 0 ), head, headLen );
+        adler = adler32_combine( adler, mMarshaledAdler, mMarshaled.size() );
+        adler = adler32_combine( adler, adler32( adler32( 0, Z_NULL, 0 ), tail, tailLen ), tailLen );
+
+        // zlib trailer is big-endian
+        buf->Append<uint8>( ( adler >> 24 ) & 0xFF );
+        buf->Append<uint8>( ( adler >> 16 ) & 0xFF );
+        buf->Append<uint8>( ( adler >> 8 ) & 0xFF );
+        buf->Append<uint8>( adler & 0xFF );
+    }
+    else
+    {
+        SafeDelete( buf );
+        return NULL;
+    }
+
+    if( EVETCPConnection::PACKET_SIZE_LIMIT < buf->size() )
+    {
+        sLog.Error( "Network", "Packet length %u exceeds hardcoded packet length limit %lu.", buf->size(), EVETCPConnection::PACKET_SIZE_LIMIT );
+
+        SafeDelete( buf );
+        return NULL;
+    }
+
+    // write length
+    *bufLen = ( buf->size() - sizeof( uint32 ) );
+
+    if( NULL != marshaledSize )
+        *marshaledSize = headLen + mMarshaled.size() + tailLen;
+    return buf;
+}
+
+bool EVESharedPayload::_Deflate( int level ) const
+{
+    if( 0 < mDeflated.size() )
+        return true;
+
+    z_stream zs;
+    memset( &zs, 0, sizeof( zs ) );
+
+    // raw deflate, so it can be put in the middle of a zlib stream;
+    // the payload is deflated once, with the level it is first asked for
+    if( Z_OK != deflateInit2( &zs, level, Z_DEFLATED, -MAX_WBITS, 8, Z_DEFAULT_STRATEGY ) )
+    {
+        sLog.Error( "Network", "Failed to initialize deflate of shared payload." );
+        return false;
+    }
+
+    // bound of the compressed data plus the sync flush marker
+    const Buffer::iterator<uint8> out = mDeflated.end<uint8>();
+    mDeflated.ResizeAt( out, deflateBound( &zs, mMarshaled.size() ) + 16 );
+
+    zs.next_in = const_cast<Bytef*>( &mMarshaled[0] );
+    zs.avail_in = mMarshaled.size();
+    zs.next_out = &mDeflated[0];
+    zs.avail_out = mDeflated.size();
+
+    // sync flush leaves the stream unfinished and byte-aligned
+    const int res = deflate( &zs, Z_SYNC_FLUSH );
+    const size_t deflatedLen = zs.total_out;
+    deflateEnd( &zs );
+
+    if( Z_OK != res || 0 != zs.avail_in )
+    {
+        sLog.Error( "Network", "Failed to deflate shared payload." );
+
+        mDeflated.Resize<uint8>( 0 );
+        return false;
+    }
+
+    mDeflated.Resize<uint8>( deflatedLen );
+    return true;
+}
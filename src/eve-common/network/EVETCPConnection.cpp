@@ -27,6 +27,7 @@
 
 #include "marshal/EVEMarshal.h"
 #include "marshal/EVEUnmarshal.h"
+#include "network/EVEEncoderPool.h"
 #include "network/EVETCPConnection.h"
 
 /*************************************************************************/
@@ -34,20 +35,231 @@
 /*************************************************************************/
 const uint32 EVETCPConnection::TIMEOUT_MS = 10 * 60 * 1000; // 10 minutes
 const uint32 EVETCPConnection::PACKET_SIZE_LIMIT = 10 * 1024 * 1024; // 10 megabytes
+const uint32 EVETCPConnection::PACKET_QUEUE_SIZE = 0x400;
+
+/* Deflation settings of outbound packets; the last entry
+   is used for packets of unknown type. */
+static struct DeflationTable
+{
+    DeflationTable()
+    {
+        Set( 0x2000, Z_DEFAULT_COMPRESSION );
+    }
+
+    void Set( uint32 limit, int level )
+    {
+        for( size_t i = 0; i <= MACHONETMSG_TYPE_COUNT; ++i )
+        {
+            settings[ i ].limit = limit;
+            settings[ i ].level = level;
+        }
+    }
+
+    EVETCPConnection::DeflationSettings settings[ MACHONETMSG_TYPE_COUNT + 1 ];
+} sDeflation;
+
+/* Finds out type of encoded PyPacket; MACHONETMSG_TYPE_COUNT if unknown. */
+static size_t GetPacketType( const PyRep* rep )
+{
+    if( !rep->IsObject() )
+        return MACHONETMSG_TYPE_COUNT;
+
+    const PyRep* args = rep->AsObject()->arguments();
+    if( !args->IsTuple() || 0 == args->AsTuple()->size() )
+        return MACHONETMSG_TYPE_COUNT;
+
+    const PyRep* type = args->AsTuple()->GetItem( 0 );
+    if( !type->IsInt() )
+        return MACHONETMSG_TYPE_COUNT;
+
+    const uint32 value = type->AsInt()->value();
+    return ( value < MACHONETMSG_TYPE_COUNT ? value : MACHONETMSG_TYPE_COUNT );
+}
+
+void EVETCPConnection::SetDeflation( uint32 limit, int level )
+{
+    sDeflation.Set( limit, level );
+}
+
+void EVETCPConnection::SetDeflation( MACHONETMSG_TYPE type, uint32 limit, int level )
+{
+    assert( type < MACHONETMSG_TYPE_COUNT );
+
+    sDeflation.settings[ type ].limit = limit;
+    sDeflation.settings[ type ].level = level;
+}
+
+const EVETCPConnection::DeflationSettings& EVETCPConnection::GetDeflation( MACHONETMSG_TYPE type )
+{
+    return sDeflation.settings[ type < MACHONETMSG_TYPE_COUNT ? type : MACHONETMSG_TYPE_COUNT ];
+}
 
 EVETCPConnection::EVETCPConnection()
 : TCPConnection(),
-  mTimeoutTimer( TIMEOUT_MS )
+  mTimeoutTimer( TIMEOUT_MS ),
+  mInQueue( PACKET_SIZE_LIMIT ),
+  mRecvStart( 0 ),
+  mPackets( PACKET_QUEUE_SIZE ),
+  mPoppedAt( 0 ),
+  mEncodeScheduled( false ),
+  mTraceCount( 0 )
 {
+    mPopped.packet = NULL;
+    mPopped.received = 0;
+    mPopped.queued = 0;
 }
 
 EVETCPConnection::EVETCPConnection( Socket* sock, uint32 rIP, uint16 rPort )
 : TCPConnection( sock, rIP, rPort ),
-  mTimeoutTimer( TIMEOUT_MS )
+  mTimeoutTimer( TIMEOUT_MS ),
+  mInQueue( PACKET_SIZE_LIMIT ),
+  mRecvStart( 0 ),
+  mPackets( PACKET_QUEUE_SIZE ),
+  mPoppedAt( 0 ),
+  mEncodeScheduled( false ),
+  mTraceCount( 0 )
+{
+    mPopped.packet = NULL;
+    mPopped.received = 0;
+    mPopped.queued = 0;
+}
+
+EVETCPConnection::~EVETCPConnection()
+{
+    // The reactor must not call our overrides once
+    // we start tearing down, so stop it here already
+    Disconnect();
+    WaitLoop();
+
+    // make sure no encoder worker uses us anymore
+    sEncoderPool.Cancel( this );
+
+    // nobody else can touch the queues now
+    ReceivedPacket received;
+    while( mPackets.Pop( received ) )
+        SafeDelete( received.packet );
+
+    while( !mEncodeQueue.empty() )
+    {
+        EncodeEntry& entry = mEncodeQueue.front();
+        if( NULL != entry.rep )
+            PyDecRef( entry.rep );
+        else
+            SafeDelete( entry.packet );
+        sCallTracer.Discard( &entry.trace );
+
+        mEncodeQueue.pop_front();
+    }
+
+    _DiscardTraces();
+}
+
+void EVETCPConnection::QueueRep( const PyRep* rep, CallTrace* trace )
+{
+    if( NULL != trace )
+        trace->Stamp( CallTrace::REPLIED );
+
+    if( !sEncoderPool.IsRunning() )
+    {
+        // no encoder threads, do it ourselves
+        if( NULL != trace )
+            trace->Stamp( CallTrace::ENCODING );
+
+        Buffer* buf = EncodeRep( rep );
+        _Send( &buf, trace );
+
+        return;
+    }
+
+    // the encoder releases it through the pool
+    PyIncRef( rep );
+
+    EncodeEntry entry;
+    entry.rep = rep;
+    entry.packet = NULL;
+    entry.trace = trace;
+
+    _QueueEncode( entry );
+}
+
+void EVETCPConnection::QueueBuffer( Buffer** buf, const std::string& kind, size_t rawSize )
+{
+    _CountTraffic( EVETrafficStats::TRAFFIC_OUT, kind, ( *buf )->size() - sizeof( uint32 ), rawSize );
+
+    if( !sEncoderPool.IsRunning() )
+    {
+        _Capture( PacketCapture::OUTBOUND, **buf, sizeof( uint32 ) );
+        Send( buf );
+        return;
+    }
+
+    // must not overtake PyReps still being encoded
+    EncodeEntry entry;
+    entry.rep = NULL;
+    entry.packet = *buf;
+    entry.trace = NULL;
+    *buf = NULL;
+
+    _QueueEncode( entry );
+}
+
+void EVETCPConnection::_QueueEncode( const EncodeEntry& entry )
 {
+    bool submit = false;
+    {
+        MutexLock lock( mMEncodeQueue );
+
+        mEncodeQueue.push_back( entry );
+
+        if( !mEncodeScheduled )
+        {
+            mEncodeScheduled = true;
+            submit = true;
+        }
+    }
+
+    if( submit )
+        sEncoderPool.Submit( this );
+}
+
+void EVETCPConnection::EncodeQueued()
+{
+    while( true )
+    {
+        EncodeEntry entry;
+
+        {
+            MutexLock lock( mMEncodeQueue );
+
+            if( mEncodeQueue.empty() )
+            {
+                // next QueueRep() must submit us again
+                mEncodeScheduled = false;
+                return;
+            }
+
+            entry = mEncodeQueue.front();
+            mEncodeQueue.pop_front();
+        }
+
+        if( NULL == entry.rep )
+        {
+            _Capture( PacketCapture::OUTBOUND, *entry.packet, sizeof( uint32 ) );
+            Send( &entry.packet );
+            continue;
+        }
+
+        if( NULL != entry.trace )
+            entry.trace->Stamp( CallTrace::ENCODING );
+
+        Buffer* buf = EncodeRep( entry.rep );
+        _Send( &buf, entry.trace );
+
+        sEncoderPool.Release( entry.rep );
+    }
 }
 
-void EVETCPConnection::QueueRep( const PyRep* rep )
+Buffer* EVETCPConnection::EncodeRep( const PyRep* rep )
 {
     Buffer* buf = new Buffer;
 
@@ -55,7 +267,9 @@ void EVETCPConnection::QueueRep( const PyRep* rep )
     const Buffer::iterator<uint32> bufLen = buf->end<uint32>();
     buf->ResizeAt( bufLen, 1 );
 
-    if( !MarshalDeflate( rep, *buf ) )
+    const DeflationSettings& deflation = sDeflation.settings[ GetPacketType( rep ) ];
+    size_t rawSize = 0;
+    if( !MarshalDeflate( rep, *buf, deflation.limit, deflation.level, &rawSize ) )
         sLog.Error( "Network", "Failed to marshal new packet." );
     else if( PACKET_SIZE_LIMIT < buf->size() )
         sLog.Error( "Network", "Packet length %u exceeds hardcoded packet length limit %lu.", buf->size(), PACKET_SIZE_LIMIT );
@@ -65,11 +279,98 @@ void EVETCPConnection::QueueRep( const PyRep* rep )
         // write length
         *bufLen = ( buf->size() - sizeof( uint32 ) );
 
-        Send( &buf );
-
+        _Capture( PacketCapture::OUTBOUND, *buf, sizeof( uint32 ) );
+        _CountTraffic( EVETrafficStats::TRAFFIC_OUT, EVETrafficStats::GetKind( rep ), *bufLen, rawSize );
+        return buf;
     }
 
     SafeDelete( buf );
+    return NULL;
+}
+
+void EVETCPConnection::_Send( Buffer** buf, CallTrace* trace )
+{
+    if( NULL == *buf )
+    {
+        sCallTracer.Discard( &trace );
+        return;
+    }
+
+    if( NULL == trace )
+    {
+        Send( buf );
+        return;
+    }
+
+    trace->Stamp( CallTrace::ENCODED );
+    trace->size = (uint32)( ( *buf )->size() - sizeof( uint32 ) );
+
+    // the I/O thread may send it before Send() returns
+    const Buffer* const packet = *buf;
+    {
+        MutexLock lock( mMTraces );
+
+        mTraces.push_back( std::make_pair( packet, trace ) );
+        AtomicStore( &mTraceCount, (uint32)mTraces.size() );
+    }
+
+    if( !Send( buf ) )
+    {
+        // released without being sent
+        trace = _TakeTrace( packet );
+        sCallTracer.Discard( &trace );
+    }
+}
+
+CallTrace* EVETCPConnection::_TakeTrace( const Buffer* buf )
+{
+    MutexLock lock( mMTraces );
+
+    // the packets are sent in order, the trace is usually the first one
+    std::deque< std::pair< const Buffer*, CallTrace* > >::iterator cur, end;
+    cur = mTraces.begin();
+    end = mTraces.end();
+    for(; cur != end; ++cur )
+    {
+        if( cur->first == buf )
+        {
+            CallTrace* trace = cur->second;
+
+            mTraces.erase( cur );
+            AtomicStore( &mTraceCount, (uint32)mTraces.size() );
+
+            return trace;
+        }
+    }
+
+    return NULL;
+}
+
+void EVETCPConnection::_DiscardTraces()
+{
+    MutexLock lock( mMTraces );
+
+    while( !mTraces.empty() )
+    {
+        sCallTracer.Discard( &mTraces.front().second );
+        mTraces.pop_front();
+    }
+
+    AtomicStore( &mTraceCount, 0 );
+}
+
+void EVETCPConnection::_Capture( PacketCapture::Direction direction, const Buffer& packet, size_t offset )
+{
+    if( !mCapture.IsOpen() || packet.size() <= offset )
+        return;
+
+    mCapture.Write( direction, &packet[ offset ], packet.size() - offset );
+}
+
+void EVETCPConnection::_CountTraffic( EVETrafficStats::Direction direction, const std::string& kind, size_t size, size_t rawSize )
+{
+    mTraffic[ direction ].Add( size, rawSize );
+    sTrafficStats.Add( direction, kind, size, rawSize );
 }
 
 PyRep* EVETCPConnection::PopRep()
@@ -77,19 +378,21 @@ PyRep* EVETCPConnection::PopRep()
     Buffer* packet = NULL;
     PyRep* res = NULL;
 
+    if( mPackets.Pop( mPopped ) )
     {
-        MutexLock lock( mMInQueue );
-        packet = mInQueue.PopPacket();
-    }
+        packet = mPopped.packet;
+        mPopped.packet = NULL;
+        mPoppedAt = ( 0 != mPopped.queued ? GetTimeUSeconds() : 0 );
 
-    if( NULL != packet )
-    {
         if( PACKET_SIZE_LIMIT < packet->size() )
             sLog.Error( "Network", "Packet length %lu exceeds hardcoded packet length limit %u.", packet->size(), PACKET_SIZE_LIMIT );
         else
         {
             //DumpBuffer( packet, PACKET_INBOUND );
-            res = InflateUnmarshal( *packet );
+            size_t rawSize = 0;
+            res = InflateUnmarshal( *packet, &rawSize );
+            if( NULL != res )
+                _CountTraffic( EVETrafficStats::TRAFFIC_IN, EVETrafficStats::GetKind( res ), packet->size(), rawSize );
         }
     }
 
@@ -97,22 +400,67 @@ PyRep* EVETCPConnection::PopRep()
     return res;
 }
 
-bool EVETCPConnection::ProcessReceivedData( char* errbuf )
+void EVETCPConnection::StampTrace( CallTrace& trace ) const
+{
+    trace.at[ CallTrace::RECEIVED ] = mPopped.received;
+    trace.at[ CallTrace::QUEUED ] = mPopped.queued;
+    trace.at[ CallTrace::POPPED ] = mPoppedAt;
+}
+
+uint8* EVETCPConnection::GetRecvSpan( size_t& len )
+{
+    // receive straight into the packetizer
+    return mInQueue.GetInputSpan( len );
+}
+
+bool EVETCPConnection::ProcessReceivedData( size_t len, char* errbuf )
 {
     if( errbuf )
         errbuf[0] = 0;
 
+    // the packets are stamped only while the calls are traced
+    const uint64 now = ( sCallTracer.IsEnabled() ? GetTimeUSeconds() : 0 );
+    if( !mInQueue.IsPending() )
+        mRecvStart = now;
+
+    // mark received bytes valid
+    mInQueue.CommitInput( len );
+    // process packetizer
+    if( !mInQueue.Process() )
     {
-        MutexLock lock( mMInQueue );
+        if( errbuf )
+            snprintf( errbuf, TCPCONN_ERRBUF_SIZE, "EVETCPConnection::ProcessReceivedData(): Packet exceeds hardcoded packet length limit %u", PACKET_SIZE_LIMIT );
 
-        // put bytes into packetizer
-        mInQueue.InputData( *mRecvBuf );
-        // process packetizer
-        mInQueue.Process();
+        return false;
+    }
+
+    // hand complete packets over to the main loop
+    ReceivedPacket received;
+    received.queued = ( 0 != now ? GetTimeUSeconds() : 0 );
+    while( ( received.packet = mInQueue.PopPacket() ) )
+    {
+        _Capture( PacketCapture::INBOUND, *received.packet );
+
+        // the packets after the first one began in this chunk at the latest
+        received.received = mRecvStart;
+        mRecvStart = now;
+
+        if( !mPackets.Push( received ) )
+        {
+            SafeDelete( received.packet );
+
+            if( errbuf )
+                snprintf( errbuf, TCPCONN_ERRBUF_SIZE, "EVETCPConnection::ProcessReceivedData(): Too many packets waiting to be processed" );
+
+            return false;
+        }
     }
 
     mTimeoutTimer.Start();
 
+    // let the main loop pick up the packets
+    Notify();
+
     return true;
 }
 
@@ -137,11 +485,25 @@ void EVETCPConnection::ClearBuffers()
 
     mTimeoutTimer.Start();
 
-    {
-        MutexLock lock( mMInQueue );
+    // packets already queued for the main loop are released along with us
+    mInQueue.ClearBuffers();
 
-        mInQueue.ClearBuffers();
-    }
+    // the send queue is gone, so are its traced packets
+    _DiscardTraces();
+}
+
+void EVETCPConnection::SentBuffer( const Buffer* buf )
+{
+    // most of the packets are not traced
+    if( 0 == AtomicLoad( &mTraceCount ) )
+        return;
+
+    CallTrace* trace = _TakeTrace( buf );
+    if( NULL == trace )
+        return;
+
+    trace->Stamp( CallTrace::SENT );
+    sCallTracer.Finish( &trace );
 }
 
 void EVETCPConnection::DumpBuffer( Buffer* buf, packet_direction packet_direction)
@@ -0,0 +1,151 @@
+/*
+    ------------------------------------------------------------------------------------
+    LICENSE:
+    ------------------------------------------------------------------------------------
+    This file is part of EVEmu: EVE Online Server Emulator
+    Copyright 2006 - 2011 The EVEmu Team
+    For the latest information visit http://evemu.org
+    ------------------------------------------------------------------------------------
+    This program is free software; you can redistribute it and/or modify it under
+    the terms of the GNU Lesser General Public License as published by the Free Software
+    Foundation; either version 2 of the License, or (at your option) any later
+    version.
+
+    This program is distributed in the hope that it will be useful, but WITHOUT
+    ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+    FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public License along with
+    this program; if not, write to the Free Software Foundation, Inc., 59 Temple
+    Place - Suite 330, Boston, MA 02111-1307, USA, or go to
+    http://www.gnu.org/copyleft/lesser.txt.
+    ------------------------------------------------------------------------------------
+    Author:     EVEmu Team
+*/
+
+#include "eve-common.h"
+
+#include "network/EVETrafficStats.h"
+#include "network/packet_types.h"
+#include "python/PyPacket.h"
+#include "python/PyRep.h"
+
+/// Kind of everything which is not a packet.
+static const char* const HANDSHAKE_KIND = "handshake";
+
+static const char* const DIRECTION_NAMES[ EVETrafficStats::TRAFFIC_DIRECTION_COUNT ] =
+{
+    "in",
+    "out"
+};
+
+/* Kind of a packet which is not a notification; the names of some types are missing. */
+static const char* GetTypeKind( uint32 type )
+{
+    if( MACHONETMSG_TYPE_COUNT <= type )
+        return HANDSHAKE_KIND;
+
+    const char* name = MACHONETMSG_TYPE_NAMES[ type ];
+    return ( NULL != name ? name : "UNKNOWN" );
+}
+
+EVETrafficStats::EVETrafficStats()
+: mMutex( "net_traffic_kinds" )
+{
+}
+
+EVETrafficStats::~EVETrafficStats()
+{
+}
+
+std::string EVETrafficStats::GetKind( const PyRep* rep )
+{
+    if( !rep->IsObject() )
+        return HANDSHAKE_KIND;
+
+    // see PyPacket::Encode()
+    const PyRep* args = rep->AsObject()->arguments();
+    if( !args->IsTuple() || 3 > args->AsTuple()->size() )
+        return HANDSHAKE_KIND;
+
+    const PyRep* type = args->AsTuple()->GetItem( 0 );
+    if( !type->IsInt() )
+        return HANDSHAKE_KIND;
+
+    const uint32 value = type->AsInt()->value();
+    if( NOTIFICATION == value )
+    {
+        // the broadcastID of the destination, see PyAddress::Encode()
+        const PyRep* dest = args->AsTuple()->GetItem( 2 );
+        if( dest->IsObject() && dest->AsObject()->arguments()->IsTuple() )
+        {
+            const PyTuple* addr = dest->AsObject()->arguments()->AsTuple();
+            if( 2 <= addr->size() && addr->GetItem( 1 )->IsString() )
+                return addr->GetItem( 1 )->AsString()->content();
+        }
+    }
+
+    return GetTypeKind( value );
+}
+
+std::string EVETrafficStats::GetKind( const PyPacket& packet )
+{
+    if( NOTIFICATION == packet.type && PyAddress::Broadcast == packet.dest.type )
+        return packet.dest.service;
+
+    return GetTypeKind( packet.type );
+}
+
+void EVETrafficStats::Add( Direction direction, const std::string& kind, size_t size, size_t rawSize )
+{
+    const Kind* counters = NULL;
+    {
+        SharedLock< KindMutex > lock( mMutex );
+
+        KindMap::const_iterator res = mKinds[ direction ].find( kind );
+        if( mKinds[ direction ].end() != res )
+            counters = &res->second;
+    }
+
+    if( NULL == counters )
+    {
+        Lock< KindMutex > lock( mMutex );
+
+        // another thread may have added it meanwhile
+        KindMap::iterator res = mKinds[ direction ].find( kind );
+        if( mKinds[ direction ].end() == res )
+        {
+            const std::string labels = std::string( "direction=\"" ) + DIRECTION_NAMES[ direction ] + "\",kind=\"" + kind + "\"";
+
+            Kind k;
+            k.packets = &sMetrics.Counter( "evemu_net_packets_total", "Number of packets of the client connections.", labels.c_str() );
+            k.bytes = &sMetrics.Counter( "evemu_net_packet_bytes_total", "Size of the packets of the client connections as sent.", labels.c_str() );
+            k.rawBytes = &sMetrics.Counter( "evemu_net_packet_raw_bytes_total", "Size of the packets of the client connections before deflation.", labels.c_str() );
+
+            res = mKinds[ direction ].insert( std::make_pair( kind, k ) ).first;
+        }
+
+        // the metrics live as long as the registry
+        counters = &res->second;
+    }
+
+    counters->packets->Add();
+    counters->bytes->Add( size );
+    counters->rawBytes->Add( rawSize );
+}
+
+void EVETrafficStats::GetKinds( Direction direction, std::map< std::string, Totals >& into ) const
+{
+    SharedLock< KindMutex > lock( mMutex );
+
+    KindMap::const_iterator cur, end;
+    cur = mKinds[ direction ].begin();
+    end = mKinds[ direction ].end();
+    for(; cur != end; ++cur )
+    {
+        Totals& totals = into[ cur->first ];
+        totals.packets = cur->second.packets->Get();
+        totals.bytes = cur->second.bytes->Get();
+        totals.rawBytes = cur->second.rawBytes->Get();
+    }
+}
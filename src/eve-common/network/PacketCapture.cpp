@@ -0,0 +1,223 @@
+/*
+    ------------------------------------------------------------------------------------
+    LICENSE:
+    ------------------------------------------------------------------------------------
+    This file is part of EVEmu: EVE Online Server Emulator
+    Copyright 2006 - 2011 The EVEmu Team
+    For the latest information visit http://evemu.org
+    ------------------------------------------------------------------------------------
+    This program is free software; you can redistribute it and/or modify it under
+    the terms of the GNU Lesser General Public License as published by the Free Software
+    Foundation; either version 2 of the License, or (at your option) any later
+    version.
+
+    This program is distributed in the hope that it will be useful, but WITHOUT
+    ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+    FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public License along with
+    this program; if not, write to the Free Software Foundation, Inc., 59 Temple
+    Place - Suite 330, Boston, MA 02111-1307, USA, or go to
+    http://www.gnu.org/copyleft/lesser.txt.
+    ------------------------------------------------------------------------------------
+    Author:     EVEmu Team
+*/
+
+#include "eve-common.h"
+
+#include "network/EVETCPConnection.h"
+#include "network/PacketCapture.h"
+
+/*************************************************************************/
+/* PacketCapture                                                         */
+/*************************************************************************/
+const char PacketCapture::SIGNATURE[ 8 ] = { 'E', 'V', 'E', 'C', 'A', 'P', '1', '\0' };
+
+/* Size of the record header: time, direction and length. */
+static const size_t RECORD_HEADER_SIZE = sizeof( uint64 ) + sizeof( uint8 ) + sizeof( uint32 );
+
+PacketCapture::PacketCapture()
+: mFile( NULL ),
+  mOpen( false ),
+  mStart( 0 )
+{
+}
+
+PacketCapture::~PacketCapture()
+{
+    Close();
+}
+
+bool PacketCapture::Open( const char* filename )
+{
+    MutexLock lock( mMutex );
+
+    if( NULL != mFile )
+        fclose( mFile );
+
+    mFile = fopen( filename, "wb" );
+    if( NULL == mFile )
+    {
+        mOpen = false;
+        return false;
+    }
+
+    if( 1 != fwrite( SIGNATURE, sizeof( SIGNATURE ), 1, mFile ) )
+    {
+        fclose( mFile );
+        mFile = NULL;
+        mOpen = false;
+        return false;
+    }
+
+    mStart = GetTimeUSeconds();
+    mOpen = true;
+    return true;
+}
+
+void PacketCapture::Close()
+{
+    MutexLock lock( mMutex );
+
+    if( NULL != mFile )
+    {
+        fclose( mFile );
+        mFile = NULL;
+    }
+
+    mOpen = false;
+}
+
+void PacketCapture::Write( Direction direction, const uint8* data, size_t length )
+{
+    if( !mOpen )
+        return;
+
+    Write( GetTimeUSeconds() - mStart, direction, data, length );
+}
+
+void PacketCapture::Write( uint64 time, Direction direction, const uint8* data, size_t length )
+{
+    if( !mOpen )
+        return;
+
+    MutexLock lock( mMutex );
+
+    if( NULL == mFile )
+        return;
+
+    uint8 header[ RECORD_HEADER_SIZE ];
+    for( size_t i = 0; i < sizeof( uint64 ); ++i )
+        header[ i ] = (uint8)( time >> ( 8 * i ) );
+    header[ sizeof( uint64 ) ] = (uint8)direction;
+    for( size_t i = 0; i < sizeof( uint32 ); ++i )
+        header[ sizeof( uint64 ) + sizeof( uint8 ) + i ] = (uint8)( length >> ( 8 * i ) );
+
+    if( 1 != fwrite( header, sizeof( header ), 1, mFile )
+        || ( 0 < length && 1 != fwrite( data, length, 1, mFile ) ) )
+    {
+        sLog.Error( "PacketCapture", "Failed to write a packet; the capture is closed." );
+
+        fclose( mFile );
+        mFile = NULL;
+        mOpen = false;
+    }
+}
+
+bool PacketCapture::Load( const char* filename, std::vector< Record >& into )
+{
+    Reader reader;
+    if( !reader.Open( filename ) )
+        return false;
+
+    Record record;
+    while( reader.Read( record ) )
+        into.push_back( record );
+
+    return true;
+}
+
+/*************************************************************************/
+/* PacketCapture::Reader                                                 */
+/*************************************************************************/
+PacketCapture::Reader::Reader()
+: mFile( NULL )
+{
+}
+
+PacketCapture::Reader::~Reader()
+{
+    Close();
+}
+
+bool PacketCapture::Reader::Open( const char* filename )
+{
+    Close();
+
+    mFile = fopen( filename, "rb" );
+    if( NULL == mFile )
+    {
+        sLog.Error( "PacketCapture", "Unable to open capture '%s'.", filename );
+        return false;
+    }
+
+    char signature[ sizeof( SIGNATURE ) ];
+    if( 1 != fread( signature, sizeof( signature ), 1, mFile )
+        || 0 != memcmp( signature, SIGNATURE, sizeof( SIGNATURE ) ) )
+    {
+        sLog.Error( "PacketCapture", "'%s' is not a packet capture.", filename );
+        Close();
+        return false;
+    }
+
+    mFilename = filename;
+    return true;
+}
+
+void PacketCapture::Reader::Close()
+{
+    if( NULL != mFile )
+    {
+        fclose( mFile );
+        mFile = NULL;
+    }
+}
+
+bool PacketCapture::Reader::Read( Record& into )
+{
+    if( NULL == mFile )
+        return false;
+
+    uint8 header[ RECORD_HEADER_SIZE ];
+    if( 1 != fread( header, sizeof( header ), 1, mFile ) )
+    {
+        Close();
+        return false;
+    }
+
+    into.time = 0;
+    for( size_t i = 0; i < sizeof( uint64 ); ++i )
+        into.time |= (uint64)header[ i ] << ( 8 * i );
+    into.direction = header[ sizeof( uint64 ) ];
+
+    uint32 length = 0;
+    for( size_t i = 0; i < sizeof( uint32 ); ++i )
+        length |= (uint32)header[ sizeof( uint64 ) + sizeof( uint8 ) + i ] << ( 8 * i );
+
+    if( EVETCPConnection::PACKET_SIZE_LIMIT < length )
+    {
+        sLog.Error( "PacketCapture", "'%s' holds a packet of %u bytes; the rest of the capture is dropped.", mFilename.c_str(), length );
+        Close();
+        return false;
+    }
+
+    into.data.Resize< uint8 >( length );
+    if( 0 < length && 1 != fread( &into.data[ 0 ], length, 1, mFile ) )
+    {
+        sLog.Warning( "PacketCapture", "'%s' ends in the middle of a packet; the packet is dropped.", mFilename.c_str() );
+        Close();
+        return false;
+    }
+
+    return true;
+}
@@ -0,0 +1,130 @@
+/*
+    ------------------------------------------------------------------------------------
+    LICENSE:
+    ------------------------------------------------------------------------------------
+    This file is part of EVEmu: EVE Online Server Emulator
+    Copyright 2006 - 2011 The EVEmu Team
+    For the latest information visit http://evemu.org
+    ------------------------------------------------------------------------------------
+    This program is free software; you can redistribute it and/or modify it under
+    the terms of the GNU Lesser General Public License as published by the Free Software
+    Foundation; either version 2 of the License, or (at your option) any later
+    version.
+
+    This program is distributed in the hope that it will be useful, but WITHOUT
+    ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+    FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public License along with
+    this program; if not, write to the Free Software Foundation, Inc., 59 Temple
+    Place - Suite 330, Boston, MA 02111-1307, USA, or go to
+    http://www.gnu.org/copyleft/lesser.txt.
+    ------------------------------------------------------------------------------------
+    Author:     EVEmu Team
+*/
+
+
+#include "eve-common.h"
+
+#include "python/PyRep.h"
+
+/************************************************************************/
+/* PyDictStorage                                                        */
+/************************************************************************/
+void PyDictStorage::clear()
+{
+    mEntries.clear();
+    mHashes.clear();
+    mTable.clear();
+}
+
+void PyDictStorage::reserve( size_t count )
+{
+    mEntries.reserve( count );
+    mHashes.reserve( count );
+
+    if( LINEAR_MAX < count )
+    {
+        size_t slots = 16;
+        while( slots < 2 * count )
+            slots <<= 1;
+
+        if( mTable.size() < slots )
+            _Rebuild( slots );
+    }
+}
+
+std::pair<PyDictStorage::iterator, bool> PyDictStorage::insert( const value_type& entry )
+{
+    const int32 hash = _Hash( entry.first );
+
+    const size_t index = _Find( hash );
+    if( size() != index )
+        return std::make_pair( begin() + index, false );
+
+    mEntries.push_back( entry );
+    mHashes.push_back( hash );
+
+    // keep at most half of the slots used
+    if( 2 * size() > mTable.size() )
+    {
+        if( LINEAR_MAX < size() )
+            _Rebuild( mTable.empty() ? 32 : 2 * mTable.size() );
+    }
+    else
+        _Index( index );
+
+    return std::make_pair( begin() + index, true );
+}
+
+int32 PyDictStorage::_Hash( const PyRep* key )
+{
+    assert( key );
+
+    return key->hash();
+}
+
+size_t PyDictStorage::_Find( int32 hash ) const
+{
+    if( mTable.empty() )
+    {
+        const size_t count = mHashes.size();
+        for( size_t i = 0; i < count; ++i )
+        {
+            if( mHashes[ i ] == hash )
+                return i;
+        }
+
+        return count;
+    }
+
+    const size_t mask = mTable.size() - 1;
+    for( size_t slot = _Slot( hash, mask );; slot = ( slot + 1 ) & mask )
+    {
+        const uint32 entry = mTable[ slot ];
+        if( 0 == entry )
+            return size();
+        if( mHashes[ entry - 1 ] == hash )
+            return entry - 1;
+    }
+}
+
+void PyDictStorage::_Index( size_t entry )
+{
+    const size_t mask = mTable.size() - 1;
+
+    size_t slot = _Slot( mHashes[ entry ], mask );
+    while( 0 != mTable[ slot ] )
+        slot = ( slot + 1 ) & mask;
+
+    mTable[ slot ] = entry + 1;
+}
+
+void PyDictStorage::_Rebuild( size_t slots )
+{
+    mTable.assign( slots, 0 );
+
+    const size_t count = size();
+    for( size_t i = 0; i < count; ++i )
+        _Index( i );
+}
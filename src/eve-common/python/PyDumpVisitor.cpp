@@ -340,7 +340,7 @@ bool PyDumpVisitor::VisitSubStruct( const PySubStruct* rep )
 
 bool PyDumpVisitor::VisitSubStream( const PySubStream* rep )
 {
-    _print( "%sSubstream: %s", _pfx(), ( rep->decoded() == NULL ) ? "from data" : "from rep" );
+    _print( "%sSubstream: %s", _pfx(), rep->isDecoded() ? "from rep" : "from data" );
 
     _pfxExtend( "  " );
     bool res = PyVisitor::VisitSubStream( rep );
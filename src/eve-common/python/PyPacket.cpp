@@ -265,6 +265,14 @@ bool PyPacket::Decode(PyRep **in_packet)
 
 
 PyRep *PyPacket::Encode() {
+    return _Encode(false);
+}
+
+PyRep *PyPacket::EncodeShared() {
+    return _Encode(true);
+}
+
+PyRep *PyPacket::_Encode(bool shared) {
     PyTuple *arg_tuple = new PyTuple(7);
 
     //command
@@ -285,11 +293,18 @@ PyRep *PyPacket::Encode() {
     //payload
     //TODO: we don't really need to clone this if we can figure out a way to say "this is read only"
     //or if we can change this encode method to consume the PyPacket (which will almost always be the case)
-    arg_tuple->items[4] = payload->Clone();
+    if(shared) {
+        arg_tuple->items[4] = payload;
+        PyIncRef(payload);
+    } else
+        arg_tuple->items[4] = payload->Clone();
 
     //named arguments
     if(named_payload == NULL) {
         arg_tuple->items[5] = new PyNone();
+    } else if(shared) {
+        arg_tuple->items[5] = named_payload;
+        PyIncRef(named_payload);
     } else {
         arg_tuple->items[5] = named_payload->Clone();
     }
@@ -28,11 +28,14 @@
 #include "marshal/EVEMarshal.h"
 #include "marshal/EVEUnmarshal.h"
 #include "marshal/EVEMarshalOpcodes.h"
+#include "marshal/EVEMarshalStringTable.h"
 #include "python/classes/PyDatabase.h"
 #include "python/PyDumpVisitor.h"
 #include "python/PyVisitor.h"
 #include "python/PyRep.h"
+#include "python/PyStatic.h"
 #include "utils/EVEUtils.h"
+#include "utils/Utf16.h"
 
 /************************************************************************/
 /* PyRep base Class                                                     */
@@ -60,7 +63,7 @@ const char* const PyRep::s_mTypeString[] =
     "UNKNOWN TYPE",     //18
 };
 
-PyRep::PyRep( PyType t ) : RefObject( 1 ), mType( t ) {}
+PyRep::PyRep( PyType t ) : RefObject( 1 ), mType( t ), mFrozen( false ) {}
 PyRep::~PyRep() {}
 
 const char* PyRep::TypeString() const
@@ -91,6 +94,18 @@ int32 PyRep::hash() const
     return -1;
 }
 
+void PyRep::Freeze() const
+{
+    // shared subtrees are frozen only once
+    if( mFrozen )
+        return;
+
+    MakeShared();
+    mFrozen = true;
+
+    _Freeze();
+}
+
 /************************************************************************/
 /* PyRep Integer Class                                                  */
 /************************************************************************/
@@ -306,14 +321,14 @@ int32 PyNone::hash() const
 /************************************************************************/
 /* PyRep Buffer Class                                                   */
 /************************************************************************/
-PyBuffer::PyBuffer( size_t len, const uint8& value ) : PyRep( PyRep::PyTypeBuffer ), mValue( new Buffer( len, value ) ), mHashCache( -1 ) {}
-PyBuffer::PyBuffer( const Buffer& buffer ) : PyRep( PyRep::PyTypeBuffer ), mValue( new Buffer( buffer ) ), mHashCache( -1 ) {}
+PyBuffer::PyBuffer( size_t len, const uint8& value ) : PyRep( PyRep::PyTypeBuffer ), mValue( new Data( new Buffer( len, value ) ) ), mHashCache( -1 ) {}
+PyBuffer::PyBuffer( const Buffer& buffer ) : PyRep( PyRep::PyTypeBuffer ), mValue( new Data( new Buffer( buffer ) ) ), mHashCache( -1 ) {}
 
-PyBuffer::PyBuffer( Buffer** buffer ) : PyRep( PyRep::PyTypeBuffer ), mValue( *buffer ), mHashCache( -1 ) { *buffer = NULL; }
-PyBuffer::PyBuffer( const PyString& str ) : PyRep( PyRep::PyTypeBuffer ), mValue( new Buffer( str.content().begin(), str.content().end() ) ), mHashCache( -1 ) {}
-PyBuffer::PyBuffer( const PyBuffer& buffer ) : PyRep( PyRep::PyTypeBuffer ), mValue( new Buffer( buffer.content() ) ), mHashCache( buffer.mHashCache ) {}
+PyBuffer::PyBuffer( Buffer** buffer ) : PyRep( PyRep::PyTypeBuffer ), mValue( new Data( *buffer ) ), mHashCache( -1 ) { *buffer = NULL; }
+PyBuffer::PyBuffer( const PyString& str ) : PyRep( PyRep::PyTypeBuffer ), mValue( new Data( new Buffer( str.content().begin(), str.content().end() ) ) ), mHashCache( -1 ) {}
+PyBuffer::PyBuffer( const PyBuffer& buffer ) : PyRep( PyRep::PyTypeBuffer ), mValue( buffer.mValue ), mHashCache( buffer.mHashCache ) {}
 
-PyBuffer::~PyBuffer() { delete mValue; }
+PyBuffer::~PyBuffer() {}
 
 PyRep* PyBuffer::Clone() const
 {
@@ -325,6 +340,12 @@ bool PyBuffer::visit( PyVisitor& v ) const
     return v.VisitBuffer( this );
 }
 
+void PyBuffer::_Freeze() const
+{
+    hash();
+    mValue->MakeShared();
+}
+
 int32 PyBuffer::hash() const
 {
     if( mHashCache != -1 )
@@ -370,13 +391,16 @@ size_t PyBuffer::size() const
 /************************************************************************/
 /* PyString                                                             */
 /************************************************************************/
-PyString::PyString( const char* str ) : PyRep( PyRep::PyTypeString ), mValue( str ), mHashCache( -1 ) {}
-PyString::PyString( const char* str, size_t len ) : PyRep( PyRep::PyTypeString ), mValue( str, len ), mHashCache( -1 ) {}
-PyString::PyString( const std::string& str ) : PyRep( PyRep::PyTypeString ), mValue( str ), mHashCache( -1 ) {}
+const uint8 PyString::TABLE_INDEX_UNKNOWN = 0xFF;
 
-PyString::PyString( const PyBuffer& buf ) : PyRep( PyRep::PyTypeString ), mValue( (const char *) &buf.content()[0], buf.content().size() ), mHashCache( -1 ) {}
-PyString::PyString( const PyToken& token ) : PyRep( PyRep::PyTypeString ), mValue( token.content() ), mHashCache( -1 ) {}
-PyString::PyString( const PyString& oth ) : PyRep( PyRep::PyTypeString ), mValue( oth.mValue ), mHashCache( oth.mHashCache ) {}
+PyString::PyString( const char* str ) : PyRep( PyRep::PyTypeString ), mValue( new Data( str ) ), mHashCache( -1 ), mTableIndexCache( TABLE_INDEX_UNKNOWN ) {}
+PyString::PyString( const char* str, size_t len ) : PyRep( PyRep::PyTypeString ), mValue( new Data( str, len ) ), mHashCache( -1 ), mTableIndexCache( TABLE_INDEX_UNKNOWN ) {}
+PyString::PyString( const std::string& str ) : PyRep( PyRep::PyTypeString ), mValue( new Data( str ) ), mHashCache( -1 ), mTableIndexCache( TABLE_INDEX_UNKNOWN ) {}
+PyString::PyString( const MarshalStringToken& token ) : PyRep( PyRep::PyTypeString ), mValue( new Data( token.c_str() ) ), mHashCache( -1 ), mTableIndexCache( token.index() ) {}
+
+PyString::PyString( const PyBuffer& buf ) : PyRep( PyRep::PyTypeString ), mValue( new Data( (const char *) &buf.content()[0], buf.content().size() ) ), mHashCache( -1 ), mTableIndexCache( TABLE_INDEX_UNKNOWN ) {}
+PyString::PyString( const PyToken& token ) : PyRep( PyRep::PyTypeString ), mValue( new Data( token.content() ) ), mHashCache( -1 ), mTableIndexCache( TABLE_INDEX_UNKNOWN ) {}
+PyString::PyString( const PyString& oth ) : PyRep( PyRep::PyTypeString ), mValue( oth.mValue ), mHashCache( oth.mHashCache ), mTableIndexCache( oth.mTableIndexCache ) {}
 
 PyRep* PyString::Clone() const
 {
@@ -388,26 +412,43 @@ bool PyString::visit( PyVisitor& v ) const
     return v.VisitString( this );
 }
 
+void PyString::_Freeze() const
+{
+    hash();
+    tableIndex();
+    mValue->MakeShared();
+}
+
 int32 PyString::hash() const
 {
     if( mHashCache != -1 )
         return mHashCache;
 
-    register int len;
-    register unsigned char *p;
-    register int32 x;
+    mHashCache = Hash( content().c_str(), content().length() );
+    return mHashCache;
+}
 
-    len = mValue.length();
-    p = (unsigned char *) mValue.c_str();
-    x = *p << 7;
-    while (--len >= 0)
-        x = (1000003*x) ^ *p++;
-    x ^= mValue.length();
-    if (x == -1)
-        x = -2;
+int32 PyString::Hash( const char* str, size_t len )
+{
+    const unsigned char* p = (const unsigned char*)str;
 
-    mHashCache = x;
-    return x;
+    uint32 x = ( 0 < len ? *p : 0 ) << 7;
+    for( size_t i = 0; i < len; ++i )
+        x = ( 1000003 * x ) ^ *p++;
+    x ^= (uint32)len;
+
+    if( (int32)x == -1 )
+        return -2;
+
+    return (int32)x;
+}
+
+uint8 PyString::tableIndex() const
+{
+    if( mTableIndexCache == TABLE_INDEX_UNKNOWN )
+        mTableIndexCache = sMarshalStringTable.LookupIndex( content() );
+
+    return mTableIndexCache;
 }
 
 /************************************************************************/
@@ -429,9 +470,14 @@ bool PyWString::visit( PyVisitor& v ) const
     return v.VisitWString( this );
 }
 
+void PyWString::_Freeze() const
+{
+    hash();
+}
+
 size_t PyWString::size() const
 {
-    return utf8::distance( content().begin(), content().end() );
+    return Utf8Length( content().c_str(), content().size() );
 }
 
 int32 PyWString::hash() const
@@ -439,21 +485,8 @@ int32 PyWString::hash() const
     if( mHashCache != -1 )
         return mHashCache;
 
-    register int len;
-    register unsigned char *p;
-    register int32 x;
-
-    len = mValue.length();
-    p = (unsigned char *) mValue.c_str();
-    x = *p << 7;
-    while (--len >= 0)
-        x = (1000003*x) ^ *p++;
-    x ^= mValue.length();
-    if (x == -1)
-        x = -2;
-
-    mHashCache = x;
-    return x;
+    mHashCache = PyString::Hash( mValue.c_str(), mValue.length() );
+    return mHashCache;
 }
 
 /************************************************************************/
@@ -501,6 +534,19 @@ bool PyTuple::visit( PyVisitor& v ) const
     return v.VisitTuple( this );
 }
 
+void PyTuple::_Freeze() const
+{
+    const_iterator cur, end;
+    cur = items.begin();
+    end = items.end();
+    for(; cur != end; ++cur )
+    {
+        // items which have not been set yet are NULL
+        if( NULL != *cur )
+            (*cur)->Freeze();
+    }
+}
+
 void PyTuple::clear()
 {
     iterator cur, end;
@@ -581,6 +627,19 @@ bool PyList::visit( PyVisitor& v ) const
     return v.VisitList( this );
 }
 
+void PyList::_Freeze() const
+{
+    const_iterator cur, end;
+    cur = items.begin();
+    end = items.end();
+    for(; cur != end; ++cur )
+    {
+        // unset items of a packed row are NULL
+        if( NULL != *cur )
+            (*cur)->Freeze();
+    }
+}
+
 void PyList::clear()
 {
     iterator cur, end;
@@ -641,6 +700,18 @@ bool PyDict::visit( PyVisitor& v ) const
     return v.VisitDict( this );
 }
 
+void PyDict::_Freeze() const
+{
+    const_iterator cur, end;
+    cur = items.begin();
+    end = items.end();
+    for(; cur != end; ++cur )
+    {
+        cur->first->Freeze();
+        cur->second->Freeze();
+    }
+}
+
 void PyDict::clear()
 {
     iterator cur, end;
@@ -672,17 +743,19 @@ PyRep* PyDict::GetItemString( const char* key ) const
     /* make sure we have valid arguments */
     assert( key );
 
-    PyString* str = new PyString( key );
-    PyRep* res = GetItem( str );
-    PyDecRef( str );
+    // hash the characters rather than a temporary PyString
+    const_iterator res = items.find_hash( PyString::Hash( key, ::strlen( key ) ) );
+    if( res == items.end() )
+        return NULL;
 
-    return res;
+    return res->second;
 }
 
 void PyDict::SetItem( PyRep* key, PyRep* value )
 {
     /* make sure we have valid arguments */
     assert( key );
+    assert( !IsFrozen() );
 
     /* note: add check if the key object is hashable
      * if not ( it will return -1 then ) return false;
@@ -693,21 +766,16 @@ void PyDict::SetItem( PyRep* key, PyRep* value )
     PyIncRef( key );
     PyIncRef( value );
 
-    /* check if we need to replace a dictionary entry */
-    iterator itr = items.find( key );
-    if( itr == items.end() )
+    /* insert the entry unless we need to replace a dictionary entry */
+    std::pair<iterator, bool> res = items.insert( std::make_pair( key, value ) );
+    if( !res.second )
     {
-        // Keep both key & value
-        items.insert( std::make_pair( key, value ) );
-    }
-    else
-    {
-        // We don't need it anymore, we're using itr->first.
+        // We don't need it anymore, we're using res.first->first.
         PyDecRef( key );
 
-        // Replace itr->second with value.
-        PySafeDecRef( itr->second );
-        itr->second = value;
+        // Replace res.first->second with value.
+        PySafeDecRef( res.first->second );
+        res.first->second = value;
     }
 }
 
@@ -719,8 +787,10 @@ void PyDict::SetItem( const char* key, const char* value )
 
 void PyDict::SetItem( const char* key, PyRep* value )
 {
-    PyString *key_name = new PyString(key);
-    SetItem(key_name, value);
+    // identifiers are usually interned, share the string and its cached hash
+    PyString* key_name = PyStatic::NewString( key );
+    SetItem( key_name, value );
+    PyDecRef( key_name );
 }
 
 PyDict& PyDict::operator=( const PyDict& oth )
@@ -767,6 +837,12 @@ bool PyObject::visit( PyVisitor& v ) const
     return v.VisitObject( this );
 }
 
+void PyObject::_Freeze() const
+{
+    mType->Freeze();
+    mArguments->Freeze();
+}
+
 /************************************************************************/
 /* PyObjectEx                                                           */
 /************************************************************************/
@@ -796,6 +872,13 @@ bool PyObjectEx::visit( PyVisitor& v ) const
     return v.VisitObjectEx( this );
 }
 
+void PyObjectEx::_Freeze() const
+{
+    mHeader->Freeze();
+    mList->Freeze();
+    mDict->Freeze();
+}
+
 PyObjectEx& PyObjectEx::operator=( const PyObjectEx& oth )
 {
     list() = oth.list();
@@ -968,8 +1051,16 @@ bool PyPackedRow::visit( PyVisitor& v ) const
     return v.VisitPackedRow( this );
 }
 
+void PyPackedRow::_Freeze() const
+{
+    mHeader->Freeze();
+    mFields->Freeze();
+}
+
 bool PyPackedRow::SetField( uint32 index, PyRep* value )
 {
+    assert( !IsFrozen() );
+
     if( !header()->VerifyValue( index, value ) )
     {
         PyDecRef( value );
@@ -1018,13 +1109,19 @@ bool PySubStruct::visit( PyVisitor& v ) const
     return v.VisitSubStruct( this );
 }
 
+void PySubStruct::_Freeze() const
+{
+    mSub->Freeze();
+}
+
 /************************************************************************/
 /* PyRep SubStream Class                                                */
 /************************************************************************/
 PySubStream::PySubStream( PyRep* rep ) : PyRep( PyRep::PyTypeSubStream ), mData( NULL ), mDecoded( rep ) {}
 PySubStream::PySubStream( PyBuffer* buffer ): PyRep(PyRep::PyTypeSubStream), mData(  buffer ), mDecoded( NULL ) {}
+// the copy shares the data if there is any, and decodes it again when needed
 PySubStream::PySubStream( const PySubStream& oth ) : PyRep(PyRep::PyTypeSubStream),
-  mData( oth.data() == NULL ? NULL : new PyBuffer( *oth.data() ) ), mDecoded( oth.decoded() == NULL ? NULL : oth.decoded()->Clone() ) {}
+  mData( oth.mData == NULL ? NULL : new PyBuffer( *oth.mData ) ), mDecoded( oth.mData != NULL || oth.mDecoded == NULL ? NULL : oth.mDecoded->Clone() ) {}
 
 PySubStream::~PySubStream()
 {
@@ -1042,15 +1139,33 @@ bool PySubStream::visit( PyVisitor& v ) const
     return v.VisitSubStream( this );
 }
 
+void PySubStream::_Freeze() const
+{
+    // have both forms ready, readers would fill in the missing one
+    EncodeData();
+    DecodeData();
+
+    if( NULL != mData )
+        mData->Freeze();
+    if( NULL != mDecoded )
+        mDecoded->Freeze();
+}
+
+/// Serializes lazy encoding of substreams.
+static Mutex sMSubStreamEncode;
+
 void PySubStream::EncodeData() const
 {
-    if( decoded() == NULL || data() != NULL )
+    // encoder threads may get here concurrently with the game thread
+    MutexLock lock( sMSubStreamEncode );
+
+    if( mDecoded == NULL || mData != NULL )
         return;
 
     Buffer* buf = new Buffer;
-    if( !Marshal( decoded(), *buf ) )
+    if( !Marshal( mDecoded, *buf ) )
     {
-        sLog.Error( "Marshal", "Failed to marshal rep %p.", decoded() );
+        sLog.Error( "Marshal", "Failed to marshal rep %p.", mDecoded );
 
         SafeDelete( buf );
         return;
@@ -1062,10 +1177,10 @@ void PySubStream::EncodeData() const
 
 void PySubStream::DecodeData() const
 {
-    if( data() == NULL || decoded() != NULL )
+    if( mData == NULL || mDecoded != NULL )
         return;
 
-    mDecoded = Unmarshal( data()->content() );
+    mDecoded = Unmarshal( mData->content() );
 }
 
 /************************************************************************/
@@ -1088,6 +1203,11 @@ bool PyChecksumedStream::visit( PyVisitor& v ) const
     return v.VisitChecksumedStream( this );
 }
 
+void PyChecksumedStream::_Freeze() const
+{
+    mStream->Freeze();
+}
+
 
 /************************************************************************/
 /* tuple large integer helper functions                                 */
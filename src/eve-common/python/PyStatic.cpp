@@ -0,0 +1,207 @@
+/*
+    ------------------------------------------------------------------------------------
+    LICENSE:
+    ------------------------------------------------------------------------------------
+    This file is part of EVEmu: EVE Online Server Emulator
+    Copyright 2006 - 2011 The EVEmu Team
+    For the latest information visit http://evemu.org
+    ------------------------------------------------------------------------------------
+    This program is free software; you can redistribute it and/or modify it under
+    the terms of the GNU Lesser General Public License as published by the Free Software
+    Foundation; either version 2 of the License, or (at your option) any later
+    version.
+
+    This program is distributed in the hope that it will be useful, but WITHOUT
+    ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+    FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public License along with
+    this program; if not, write to the Free Software Foundation, Inc., 59 Temple
+    Place - Suite 330, Boston, MA 02111-1307, USA, or go to
+    http://www.gnu.org/copyleft/lesser.txt.
+    ------------------------------------------------------------------------------------
+    Author:     EVEmu Team
+*/
+
+#include "eve-common.h"
+
+#include "marshal/EVEMarshalStringTable.h"
+#include "python/PyStatic.h"
+
+/* Key of the interned strings table; points into content of the string it maps to. */
+struct InternKey
+{
+    const char* str;
+    size_t len;
+};
+
+struct InternKeyHash
+{
+    size_t operator()( const InternKey& key ) const
+    {
+        /* djb2, the same as MarshalStringTable uses */
+        size_t hash = 5381;
+        for( size_t i = 0; i < key.len; ++i )
+            hash = ( ( hash << 5 ) + hash ) + (uint8)key.str[ i ];
+
+        return hash;
+    }
+};
+
+struct InternKeyEqual
+{
+    bool operator()( const InternKey& a, const InternKey& b ) const
+    {
+        return a.len == b.len && 0 == ::memcmp( a.str, b.str, a.len );
+    }
+};
+
+/**
+ * @brief Holds the shared objects; each keeps the reference it was created with.
+ */
+class PyStaticCache
+{
+public:
+    PyStaticCache()
+    : mNone( new PyNone ),
+      mTrue( new PyBool( true ) ),
+      mFalse( new PyBool( false ) ),
+      mEmptyTuple( new PyTuple( 0 ) ),
+      mDynamicCount( 0 )
+    {
+        // frozen, so any thread may take and release their references
+        mNone->Freeze();
+        mTrue->Freeze();
+        mFalse->Freeze();
+        mEmptyTuple->Freeze();
+
+        for( int32 i = PyStatic::SMALL_INT_MIN; i <= PyStatic::SMALL_INT_MAX; ++i )
+        {
+            mSmallInts[ i - PyStatic::SMALL_INT_MIN ] = new PyInt( i );
+            mSmallInts[ i - PyStatic::SMALL_INT_MIN ]->Freeze();
+        }
+
+        for( uint8 i = 1; ; ++i )
+        {
+            const char* str = sMarshalStringTable.LookupString( i );
+            if( NULL == str )
+                break;
+
+            const size_t len = ::strlen( str );
+            if( NULL == Find( str, len ) )
+                Insert( str, len );
+        }
+
+        Insert( "", 0 );
+    }
+
+    PyString* Find( const char* str, size_t len ) const
+    {
+        const InternKey key = { str, len };
+
+        InternMap::const_iterator res = mInterned.find( key );
+        if( mInterned.end() == res )
+            return NULL;
+
+        return res->second;
+    }
+
+    PyString* Insert( const char* str, size_t len )
+    {
+        PyString* res = new PyString( str, len );
+        // resolves the table index and the hash, the shared strings are only read afterwards
+        res->Freeze();
+
+        const InternKey key = { res->content().c_str(), len };
+        mInterned.insert( std::make_pair( key, res ) );
+
+        return res;
+    }
+
+    PyNone* const mNone;
+    PyBool* const mTrue;
+    PyBool* const mFalse;
+    PyTuple* const mEmptyTuple;
+    PyInt* mSmallInts[ PyStatic::SMALL_INT_MAX - PyStatic::SMALL_INT_MIN + 1 ];
+
+    typedef std::tr1::unordered_map<InternKey, PyString*, InternKeyHash, InternKeyEqual> InternMap;
+    InternMap mInterned;
+    /// Number of strings interned by InternString().
+    size_t mDynamicCount;
+};
+
+/* Created on first use and never destroyed, so the shared objects
+   outlive all static objects which might reference them. */
+static PyStaticCache& GetCache()
+{
+    static PyStaticCache* cache = new PyStaticCache;
+    return *cache;
+}
+
+PyInt* PyStatic::NewInt( int32 value )
+{
+    if( SMALL_INT_MIN > value || SMALL_INT_MAX < value )
+        return new PyInt( value );
+
+    PyInt* res = GetCache().mSmallInts[ value - SMALL_INT_MIN ];
+    PyIncRef( res );
+
+    return res;
+}
+
+PyBool* PyStatic::NewBool( bool value )
+{
+    PyBool* res = ( value ? GetCache().mTrue : GetCache().mFalse );
+    PyIncRef( res );
+
+    return res;
+}
+
+PyNone* PyStatic::NewNone()
+{
+    PyNone* res = GetCache().mNone;
+    PyIncRef( res );
+
+    return res;
+}
+
+PyTuple* PyStatic::NewEmptyTuple()
+{
+    PyTuple* res = GetCache().mEmptyTuple;
+    PyIncRef( res );
+
+    return res;
+}
+
+PyString* PyStatic::NewString( const char* str, size_t len )
+{
+    PyString* res = GetCache().Find( str, len );
+    if( NULL == res )
+        return new PyString( str, len );
+
+    PyIncRef( res );
+    return res;
+}
+
+PyString* PyStatic::InternString( const char* str, size_t len )
+{
+    PyStaticCache& cache = GetCache();
+
+    PyString* res = cache.Find( str, len );
+    if( NULL == res )
+    {
+        if( MAX_INTERNED <= cache.mDynamicCount )
+            return new PyString( str, len );
+
+        res = cache.Insert( str, len );
+        ++cache.mDynamicCount;
+    }
+
+    PyIncRef( res );
+    return res;
+}
+
+size_t PyStatic::GetInternedCount()
+{
+    return GetCache().mInterned.size();
+}
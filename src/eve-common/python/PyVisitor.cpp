@@ -141,14 +141,7 @@ bool PyVisitor::VisitSubStruct( const PySubStruct* rep )
 bool PyVisitor::VisitSubStream( const PySubStream* rep )
 {
     if( rep->decoded() == NULL )
-    {
-        if( rep->data() == NULL )
-            return false;
-
-        rep->DecodeData();
-        if( rep->decoded() == NULL )
-            return false;
-    }
+        return false;
     if( !rep->decoded()->visit( *this ) )
         return false;
     return true;
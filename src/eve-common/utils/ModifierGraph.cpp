@@ -0,0 +1,397 @@
+/*
+    ------------------------------------------------------------------------------------
+    LICENSE:
+    ------------------------------------------------------------------------------------
+    This file is part of EVEmu: EVE Online Server Emulator
+    Copyright 2006 - 2011 The EVEmu Team
+    For the latest information visit http://evemu.org
+    ------------------------------------------------------------------------------------
+    This program is free software; you can redistribute it and/or modify it under
+    the terms of the GNU Lesser General Public License as published by the Free Software
+    Foundation; either version 2 of the License, or (at your option) any later
+    version.
+
+    This program is distributed in the hope that it will be useful, but WITHOUT
+    ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+    FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public License along with
+    this program; if not, write to the Free Software Foundation, Inc., 59 Temple
+    Place - Suite 330, Boston, MA 02111-1307, USA, or go to
+    http://www.gnu.org/copyleft/lesser.txt.
+    ------------------------------------------------------------------------------------
+    Author:     EVEmu Team
+*/
+
+#include "eve-common.h"
+
+#include "utils/ModifierGraph.h"
+
+/*************************************************************************/
+/* ModifierGraph                                                         */
+/*************************************************************************/
+/* exp( -( i / 2.67 )^2 ), see http://wiki.eveuniversity.org/Eve_math */
+const double ModifierGraph::sStackingPenalties[ STACKING_PENALTY_COUNT ] =
+{
+    1.000000000000,
+    0.869119980800,
+    0.570583143511,
+    0.282955154023,
+    0.105992649743,
+    0.029991166533,
+    0.006410183118,
+    0.001034920483,
+    0.000126212683,
+    0.000011626754
+};
+
+double ModifierGraph::GetStackingPenalty( uint32 index )
+{
+    if( STACKING_PENALTY_COUNT <= index )
+        return 0.0;
+
+    return sStackingPenalties[ index ];
+}
+
+ModifierGraph::ModifierGraph()
+: mRecomputeCount( 0 )
+{
+}
+
+void ModifierGraph::SetBaseValue( uint32 itemID, uint32 attributeID, double value )
+{
+    const bool known = HasAttribute( itemID, attributeID );
+
+    Node& node = _GetNode( itemID, attributeID );
+    if( !known )
+    {
+        // the item already has this value
+        node.base = node.value = node.reported = value;
+        return;
+    }
+    if( node.base == value )
+        return;
+
+    node.base = value;
+    _Invalidate( node );
+}
+
+bool ModifierGraph::HasAttribute( uint32 itemID, uint32 attributeID ) const
+{
+    return mNodes.find( _Key( itemID, attributeID ) ) != mNodes.end();
+}
+
+bool ModifierGraph::GetValue( uint32 itemID, uint32 attributeID, double& into )
+{
+    NodeMap::iterator res = mNodes.find( _Key( itemID, attributeID ) );
+    if( res == mNodes.end() )
+        return false;
+
+    into = _Evaluate( res->second );
+    return true;
+}
+
+void ModifierGraph::AddModifier( const Modifier& modifier )
+{
+    const int32 found = _FindEntry( modifier );
+    if( 0 <= found )
+    {
+        Entry& entry = mEntries[ found ];
+        if( entry.modifier.operation == modifier.operation
+            && entry.modifier.penalized == modifier.penalized
+            && entry.modifier.value == modifier.value )
+            return;
+
+        entry.modifier = modifier;
+        _Invalidate( *entry.target );
+        return;
+    }
+
+    uint32 index;
+    if( mFreeEntries.empty() )
+    {
+        index = mEntries.size();
+        mEntries.push_back( Entry() );
+    }
+    else
+    {
+        index = mFreeEntries.back();
+        mFreeEntries.pop_back();
+    }
+
+    Entry& entry = mEntries[ index ];
+    entry.modifier = modifier;
+    entry.used = true;
+
+    entry.source = NULL;
+    if( 0 != modifier.sourceAttributeID )
+    {
+        entry.source = &_GetNode( modifier.sourceItemID, modifier.sourceAttributeID );
+        entry.source->outbound.push_back( index );
+    }
+
+    entry.target = &_GetNode( modifier.targetItemID, modifier.targetAttributeID );
+    entry.target->inbound.push_back( index );
+
+    mSources[ modifier.sourceItemID ].push_back( index );
+    _Invalidate( *entry.target );
+}
+
+bool ModifierGraph::RemoveModifier( const Modifier& modifier )
+{
+    const int32 found = _FindEntry( modifier );
+    if( 0 > found )
+        return false;
+
+    _RemoveEntry( found );
+    return true;
+}
+
+uint32 ModifierGraph::RemoveModifiers( uint32 sourceItemID, uint32 effectID )
+{
+    SourceMap::iterator res = mSources.find( sourceItemID );
+    if( res == mSources.end() )
+        return 0;
+
+    // _RemoveEntry() changes the list
+    const std::vector< uint32 > indices = res->second;
+
+    uint32 count = 0;
+    for( size_t i = 0; i < indices.size(); ++i )
+    {
+        if( mEntries[ indices[ i ] ].modifier.effectID == effectID )
+        {
+            _RemoveEntry( indices[ i ] );
+            ++count;
+        }
+    }
+
+    return count;
+}
+
+void ModifierGraph::RemoveItem( uint32 itemID )
+{
+    SourceMap::iterator res = mSources.find( itemID );
+    if( res != mSources.end() )
+    {
+        const std::vector< uint32 > indices = res->second;
+        for( size_t i = 0; i < indices.size(); ++i )
+            _RemoveEntry( indices[ i ] );
+    }
+
+    NodeMap::iterator cur = mNodes.begin();
+    while( cur != mNodes.end() )
+    {
+        Node& node = cur->second;
+        if( node.itemID != itemID )
+        {
+            ++cur;
+            continue;
+        }
+
+        // the ones from other items to this one
+        while( !node.inbound.empty() )
+            _RemoveEntry( node.inbound.back() );
+        // and the ones left from this one to other items
+        while( !node.outbound.empty() )
+            _RemoveEntry( node.outbound.back() );
+
+        mNodes.erase( cur++ );
+    }
+}
+
+void ModifierGraph::Clear()
+{
+    mNodes.clear();
+    mEntries.clear();
+    mFreeEntries.clear();
+    mSources.clear();
+    mDirty.clear();
+}
+
+void ModifierGraph::Update( std::vector< Change >& changes )
+{
+    for( size_t i = 0; i < mDirty.size(); ++i )
+    {
+        NodeMap::iterator res = mNodes.find( mDirty[ i ] );
+        if( res == mNodes.end() )
+            continue;
+
+        Node& node = res->second;
+        const double value = _Evaluate( node );
+        if( value == node.reported )
+            continue;
+        node.reported = value;
+
+        Change change;
+        change.itemID = node.itemID;
+        change.attributeID = node.attributeID;
+        change.value = value;
+        changes.push_back( change );
+    }
+
+    mDirty.clear();
+}
+
+bool ModifierGraph::_SameIdentity( const Modifier& a, const Modifier& b )
+{
+    return a.sourceItemID == b.sourceItemID
+        && a.sourceAttributeID == b.sourceAttributeID
+        && a.effectID == b.effectID
+        && a.targetItemID == b.targetItemID
+        && a.targetAttributeID == b.targetAttributeID;
+}
+
+double ModifierGraph::_ApplyPenalized( std::vector< double >& factors )
+{
+    // bonuses and maluses are penalized separately, strongest first
+    std::sort( factors.begin(), factors.end() );
+
+    double result = 1.0;
+
+    uint32 stack = 0;
+    for( size_t i = 0; i < factors.size() && factors[ i ] < 1.0; ++i )
+        result *= 1.0 + ( factors[ i ] - 1.0 ) * GetStackingPenalty( stack++ );
+
+    stack = 0;
+    for( size_t i = factors.size(); 0 < i && factors[ i - 1 ] > 1.0; --i )
+        result *= 1.0 + ( factors[ i - 1 ] - 1.0 ) * GetStackingPenalty( stack++ );
+
+    return result;
+}
+
+void ModifierGraph::_Erase( std::vector< uint32 >& from, uint32 index )
+{
+    std::vector< uint32 >::iterator res = std::find( from.begin(), from.end(), index );
+    if( res == from.end() )
+        return;
+
+    *res = from.back();
+    from.pop_back();
+}
+
+ModifierGraph::Node& ModifierGraph::_GetNode( uint32 itemID, uint32 attributeID )
+{
+    std::pair< NodeMap::iterator, bool > res = mNodes.insert( std::make_pair( _Key( itemID, attributeID ), Node() ) );
+    Node& node = res.first->second;
+    if( res.second )
+    {
+        node.itemID = itemID;
+        node.attributeID = attributeID;
+        node.base = 0.0;
+        node.value = 0.0;
+        node.reported = 0.0;
+        node.dirty = false;
+    }
+
+    return node;
+}
+
+int32 ModifierGraph::_FindEntry( const Modifier& modifier ) const
+{
+    SourceMap::const_iterator res = mSources.find( modifier.sourceItemID );
+    if( res == mSources.end() )
+        return -1;
+
+    const std::vector< uint32 >& indices = res->second;
+    for( size_t i = 0; i < indices.size(); ++i )
+    {
+        if( _SameIdentity( mEntries[ indices[ i ] ].modifier, modifier ) )
+            return indices[ i ];
+    }
+
+    return -1;
+}
+
+void ModifierGraph::_RemoveEntry( uint32 index )
+{
+    Entry& entry = mEntries[ index ];
+
+    if( NULL != entry.source )
+        _Erase( entry.source->outbound, index );
+    _Erase( entry.target->inbound, index );
+    _Invalidate( *entry.target );
+
+    SourceMap::iterator res = mSources.find( entry.modifier.sourceItemID );
+    _Erase( res->second, index );
+    if( res->second.empty() )
+        mSources.erase( res );
+
+    entry.source = NULL;
+    entry.target = NULL;
+    entry.used = false;
+    mFreeEntries.push_back( index );
+}
+
+void ModifierGraph::_Invalidate( Node& node )
+{
+    // already marked, and so is everything downstream
+    if( node.dirty )
+        return;
+
+    node.dirty = true;
+    mDirty.push_back( _Key( node.itemID, node.attributeID ) );
+
+    for( size_t i = 0; i < node.outbound.size(); ++i )
+        _Invalidate( *mEntries[ node.outbound[ i ] ].target );
+}
+
+double ModifierGraph::_Evaluate( Node& node )
+{
+    if( !node.dirty )
+        return node.value;
+
+    // cleared first, so a cycle takes the previous value
+    node.dirty = false;
+    ++mRecomputeCount;
+
+    bool preAssigned = false, postAssigned = false;
+    double preAssign = 0.0, postAssign = 0.0;
+    double preMultiply = 1.0, add = 0.0, postMultiply = 1.0;
+    std::vector< double > prePenalized, postPenalized;
+
+    for( size_t i = 0; i < node.inbound.size(); ++i )
+    {
+        const Entry& entry = mEntries[ node.inbound[ i ] ];
+        const Modifier& modifier = entry.modifier;
+
+        double value = modifier.value;
+        if( NULL != entry.source )
+            value = _Evaluate( *entry.source );
+
+        double factor = 1.0;
+        bool post = true;
+        switch( modifier.operation )
+        {
+            case OP_PRE_ASSIGN:     preAssigned = true; preAssign = value;      continue;
+            case OP_ADD:            add += value;                               continue;
+            case OP_SUBTRACT:       add -= value;                               continue;
+            case OP_POST_ASSIGN:    postAssigned = true; postAssign = value;    continue;
+
+            case OP_PRE_MULTIPLY:   factor = value;                 post = false;   break;
+            case OP_PRE_DIVIDE:     factor = 1.0 / value;           post = false;   break;
+            case OP_POST_MULTIPLY:  factor = value;                                 break;
+            case OP_POST_DIVIDE:    factor = 1.0 / value;                           break;
+            case OP_POST_PERCENT:   factor = 1.0 + value / 100.0;                   break;
+        }
+
+        if( modifier.penalized )
+            ( post ? postPenalized : prePenalized ).push_back( factor );
+        else
+            ( post ? postMultiply : preMultiply ) *= factor;
+    }
+
+    double value = ( preAssigned ? preAssign : node.base );
+    if( !prePenalized.empty() )
+        preMultiply *= _ApplyPenalized( prePenalized );
+    value *= preMultiply;
+    value += add;
+    if( !postPenalized.empty() )
+        postMultiply *= _ApplyPenalized( postPenalized );
+    value *= postMultiply;
+    if( postAssigned )
+        value = postAssign;
+
+    node.value = value;
+    return value;
+}
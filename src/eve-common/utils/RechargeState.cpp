@@ -0,0 +1,98 @@
+/*
+    ------------------------------------------------------------------------------------
+    LICENSE:
+    ------------------------------------------------------------------------------------
+    This file is part of EVEmu: EVE Online Server Emulator
+    Copyright 2006 - 2011 The EVEmu Team
+    For the latest information visit http://evemu.org
+    ------------------------------------------------------------------------------------
+    This program is free software; you can redistribute it and/or modify it under
+    the terms of the GNU Lesser General Public License as published by the Free Software
+    Foundation; either version 2 of the License, or (at your option) any later
+    version.
+
+    This program is distributed in the hope that it will be useful, but WITHOUT
+    ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+    FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public License along with
+    this program; if not, write to the Free Software Foundation, Inc., 59 Temple
+    Place - Suite 330, Boston, MA 02111-1307, USA, or go to
+    http://www.gnu.org/copyleft/lesser.txt.
+    ------------------------------------------------------------------------------------
+    Author:     EVEmu Team
+*/
+
+#include "eve-common.h"
+
+#include "utils/RechargeState.h"
+
+const double RECHARGE_FULL_RATIO = 0.999;
+
+RechargeState::RechargeState()
+: mCapacity( 0.0 ),
+  mRechargeTime( 0.0 ),
+  mValue( 0.0 ),
+  mStamp( 0 )
+{
+}
+
+void RechargeState::Reset( double capacity, double rechargeTime, double value, uint32 now )
+{
+    mCapacity = std::max( capacity, 0.0 );
+    mRechargeTime = rechargeTime;
+    mStamp = now;
+
+    SetValue( value, now );
+}
+
+void RechargeState::SetLimits( double capacity, double rechargeTime, uint32 now )
+{
+    const double value = GetValue( now );
+    Reset( capacity, rechargeTime, value, now );
+}
+
+double RechargeState::GetValue( uint32 now ) const
+{
+    if( 0.0 >= mCapacity || 0.0 >= mRechargeTime || mValue >= mCapacity )
+        return mValue;
+
+    const int32 elapsed = (int32)( now - mStamp );
+    if( 0 >= elapsed )
+        return mValue;
+
+    const double root = 1.0 + ( ::sqrt( mValue / mCapacity ) - 1.0 ) * ::exp( -5.0 * elapsed / mRechargeTime );
+    return mCapacity * root * root;
+}
+
+void RechargeState::SetValue( double value, uint32 now )
+{
+    mValue = std::min( std::max( value, 0.0 ), mCapacity );
+    mStamp = now;
+}
+
+bool RechargeState::IsFull( uint32 now ) const
+{
+    return GetValue( now ) >= mCapacity * RECHARGE_FULL_RATIO;
+}
+
+uint32 RechargeState::GetTimeToReach( double value, uint32 now ) const
+{
+    const double current = GetValue( now );
+    if( current >= value )
+        return 0;
+    if( value >= mCapacity || 0.0 >= mRechargeTime )
+        return 0xFFFFFFFF;
+
+    // solve the recharge formula for t, measured from mStamp
+    const double from = ::sqrt( mValue / mCapacity ) - 1.0;
+    const double to = ::sqrt( value / mCapacity ) - 1.0;
+    const double t = -mRechargeTime / 5.0 * ::log( to / from );
+
+    const double left = ::ceil( t ) - (int32)( now - mStamp );
+    if( 0.0 >= left )
+        return 0;
+    if( (double)0xFFFFFFFE <= left )
+        return 0xFFFFFFFE;
+    return (uint32)left;
+}
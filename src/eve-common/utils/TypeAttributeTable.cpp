@@ -0,0 +1,153 @@
+/*
+    ------------------------------------------------------------------------------------
+    LICENSE:
+    ------------------------------------------------------------------------------------
+    This file is part of EVEmu: EVE Online Server Emulator
+    Copyright 2006 - 2011 The EVEmu Team
+    For the latest information visit http://evemu.org
+    ------------------------------------------------------------------------------------
+    This program is free software; you can redistribute it and/or modify it under
+    the terms of the GNU Lesser General Public License as published by the Free Software
+    Foundation; either version 2 of the License, or (at your option) any later
+    version.
+
+    This program is distributed in the hope that it will be useful, but WITHOUT
+    ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+    FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public License along with
+    this program; if not, write to the Free Software Foundation, Inc., 59 Temple
+    Place - Suite 330, Boston, MA 02111-1307, USA, or go to
+    http://www.gnu.org/copyleft/lesser.txt.
+    ------------------------------------------------------------------------------------
+    Author:     EVEmu Team
+*/
+
+#include "eve-common.h"
+
+#include "utils/TypeAttributeTable.h"
+
+/*************************************************************************/
+/* TypeAttributeTable::Range                                             */
+/*************************************************************************/
+bool TypeAttributeTable::Range::Find( uint16 attributeID, EvilNumber& into ) const
+{
+    const uint16* end = mAttributeIDs + mCount;
+    const uint16* res = std::lower_bound( mAttributeIDs, end, attributeID );
+    if( res == end || *res != attributeID )
+        return false;
+
+    into = mValues[ res - mAttributeIDs ];
+    return true;
+}
+
+/*************************************************************************/
+/* TypeAttributeTable::Entry                                             */
+/*************************************************************************/
+bool TypeAttributeTable::Entry::operator<( const Entry& oth ) const
+{
+    if( typeID != oth.typeID )
+        return typeID < oth.typeID;
+    if( attributeID != oth.attributeID )
+        return attributeID < oth.attributeID;
+    return order < oth.order;
+}
+
+/*************************************************************************/
+/* TypeAttributeTable                                                    */
+/*************************************************************************/
+TypeAttributeTable::TypeAttributeTable()
+{
+    mOffsets.push_back( 0 );
+}
+
+void TypeAttributeTable::Add( uint32 typeID, uint16 attributeID, const EvilNumber& value )
+{
+    Entry entry;
+    entry.typeID = typeID;
+    entry.attributeID = attributeID;
+    entry.order = mPending.size() + 1;
+    entry.value = value;
+
+    mPending.push_back( entry );
+}
+
+void TypeAttributeTable::Build()
+{
+    // merge whatever is built already
+    for( uint32 t = 0; t < mTypeIDs.size(); ++t )
+    {
+        for( uint32 i = mOffsets[ t ]; i < mOffsets[ t + 1 ]; ++i )
+        {
+            Entry entry;
+            entry.typeID = mTypeIDs[ t ];
+            entry.attributeID = mAttributeIDs[ i ];
+            // before anything added since
+            entry.order = 0;
+            entry.value = mValues[ i ];
+
+            mPending.push_back( entry );
+        }
+    }
+
+    std::sort( mPending.begin(), mPending.end() );
+
+    std::vector< uint32 > typeIDs, offsets;
+    std::vector< uint16 > attributeIDs;
+    std::vector< EvilNumber > values;
+    attributeIDs.reserve( mPending.size() );
+    values.reserve( mPending.size() );
+
+    std::vector< Entry >::const_iterator cur, end;
+    cur = mPending.begin();
+    end = mPending.end();
+    for(; cur != end; ++cur )
+    {
+        // the last one added wins
+        std::vector< Entry >::const_iterator next = cur + 1;
+        if( next != end && next->typeID == cur->typeID && next->attributeID == cur->attributeID )
+            continue;
+
+        if( typeIDs.empty() || typeIDs.back() != cur->typeID )
+        {
+            typeIDs.push_back( cur->typeID );
+            offsets.push_back( attributeIDs.size() );
+        }
+
+        attributeIDs.push_back( cur->attributeID );
+        values.push_back( cur->value );
+    }
+    offsets.push_back( attributeIDs.size() );
+
+    mTypeIDs.swap( typeIDs );
+    mOffsets.swap( offsets );
+    mAttributeIDs.swap( attributeIDs );
+    mValues.swap( values );
+
+    std::vector< Entry >().swap( mPending );
+}
+
+void TypeAttributeTable::Clear()
+{
+    std::vector< Entry >().swap( mPending );
+
+    std::vector< uint32 >().swap( mTypeIDs );
+    std::vector< uint32 >( 1, 0 ).swap( mOffsets );
+    std::vector< uint16 >().swap( mAttributeIDs );
+    std::vector< EvilNumber >().swap( mValues );
+}
+
+bool TypeAttributeTable::Find( uint32 typeID, Range& into ) const
+{
+    std::vector< uint32 >::const_iterator res = std::lower_bound( mTypeIDs.begin(), mTypeIDs.end(), typeID );
+    if( res == mTypeIDs.end() || *res != typeID )
+        return false;
+
+    const uint32 index = res - mTypeIDs.begin();
+    const uint32 first = mOffsets[ index ];
+
+    into.mAttributeIDs = &mAttributeIDs[ first ];
+    into.mValues = &mValues[ first ];
+    into.mCount = mOffsets[ index + 1 ] - first;
+    return true;
+}
@@ -0,0 +1,273 @@
+/*
+    ------------------------------------------------------------------------------------
+    LICENSE:
+    ------------------------------------------------------------------------------------
+    This file is part of EVEmu: EVE Online Server Emulator
+    Copyright 2006 - 2011 The EVEmu Team
+    For the latest information visit http://evemu.org
+    ------------------------------------------------------------------------------------
+    This program is free software; you can redistribute it and/or modify it under
+    the terms of the GNU Lesser General Public License as published by the Free Software
+    Foundation; either version 2 of the License, or (at your option) any later
+    version.
+
+    This program is distributed in the hope that it will be useful, but WITHOUT
+    ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+    FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public License along with
+    this program; if not, write to the Free Software Foundation, Inc., 59 Temple
+    Place - Suite 330, Boston, MA 02111-1307, USA, or go to
+    http://www.gnu.org/copyleft/lesser.txt.
+    ------------------------------------------------------------------------------------
+    Author:     EVEmu Team
+*/
+
+#include "eve-core.h"
+
+#include "database/DBAsyncQueue.h"
+#include "log/LogNew.h"
+
+/*************************************************************************/
+/* DBAsyncQuery                                                          */
+/*************************************************************************/
+DBAsyncQuery::DBAsyncQuery()
+: mReadOnly( false ),
+  mSuccess( false )
+{
+}
+
+DBAsyncQuery::DBAsyncQuery( const char* query_fmt, ... )
+: mReadOnly( false ),
+  mSuccess( false )
+{
+    va_list args;
+    va_start( args, query_fmt );
+    char* query = NULL;
+    const int len = vasprintf( &query, query_fmt, args );
+    va_end( args );
+
+    if( 0 <= len )
+    {
+        mQuery.assign( query, len );
+        free( query );
+    }
+}
+
+bool DBAsyncQuery::Run()
+{
+    if( mReadOnly )
+        return sDatabase.RunReadQueryString( mResult, mQuery );
+
+    return sDatabase.RunQueryString( mResult, mQuery );
+}
+
+/*************************************************************************/
+/* DBAsyncQueue                                                          */
+/*************************************************************************/
+DBAsyncQueue::DBAsyncQueue()
+: mInFlight( 0 ),
+  mNotifyEvent( NULL ),
+  mRunning( false )
+{
+}
+
+DBAsyncQueue::~DBAsyncQueue()
+{
+    Stop();
+}
+
+size_t DBAsyncQueue::GetPendingCount()
+{
+    MutexLock lock( mMQueue );
+
+    return mQueue.size() + mInFlight + mDone.size();
+}
+
+void DBAsyncQueue::Start( uint32 threadCount )
+{
+    if( mRunning || 0 == threadCount )
+        return;
+
+    mRunning = true;
+
+    for( uint32 i = 0; i < threadCount; ++i )
+    {
+#ifdef WIN32
+        HANDLE thread = CreateThread( NULL, 0, WorkerLoop, this, 0, NULL );
+        if( NULL == thread )
+#else /* !WIN32 */
+        pthread_t thread;
+        if( 0 != pthread_create( &thread, NULL, WorkerLoop, this ) )
+#endif /* !WIN32 */
+        {
+            sLog.Error( "DBAsyncQueue", "Failed to start query thread %u.", i );
+            continue;
+        }
+
+        mThreads.push_back( thread );
+    }
+
+    if( mThreads.empty() )
+        mRunning = false;
+}
+
+void DBAsyncQueue::Stop()
+{
+    if( mRunning )
+    {
+        mRunning = false;
+        mWork.Signal();
+
+        for( size_t i = 0; i < mThreads.size(); ++i )
+        {
+#ifdef WIN32
+            WaitForSingleObject( mThreads[ i ], INFINITE );
+            CloseHandle( mThreads[ i ] );
+#else /* !WIN32 */
+            pthread_join( mThreads[ i ], NULL );
+#endif /* !WIN32 */
+        }
+        mThreads.clear();
+    }
+
+    // completions may have submitted more queries
+    while( 0 < Process() );
+}
+
+size_t DBAsyncQueue::Process()
+{
+    std::vector<DBAsyncQuery*> done;
+
+    {
+        MutexLock lock( mMQueue );
+
+        if( mDone.empty() )
+            return 0;
+
+        done.swap( mDone );
+    }
+
+    std::vector<DBAsyncQuery*>::iterator cur, end;
+    cur = done.begin();
+    end = done.end();
+    for(; cur != end; ++cur )
+    {
+        DBAsyncQuery* query = *cur;
+
+        query->Complete( query->mSuccess, query->mResult );
+        SafeDelete( query );
+    }
+
+    return done.size();
+}
+
+void DBAsyncQueue::Submit( DBAsyncQuery* query )
+{
+    if( !mRunning )
+    {
+        // no threads, run it right away; still completed by Process()
+        query->mSuccess = query->Run();
+
+        {
+            MutexLock lock( mMQueue );
+
+            mDone.push_back( query );
+        }
+
+        Notify();
+        return;
+    }
+
+    {
+        MutexLock lock( mMQueue );
+
+        mQueue.push_back( query );
+    }
+
+    mWork.Signal();
+}
+
+void DBAsyncQueue::Run()
+{
+    while( true )
+    {
+        DBAsyncQuery* query = NULL;
+        bool more = false;
+
+        {
+            MutexLock lock( mMQueue );
+
+            if( !mQueue.empty() )
+            {
+                query = mQueue.front();
+                mQueue.pop_front();
+
+                ++mInFlight;
+                more = !mQueue.empty();
+            }
+        }
+
+        if( NULL == query )
+        {
+            // stop once everything has been run
+            if( !mRunning )
+                break;
+
+            mWork.Wait();
+            continue;
+        }
+
+        // pass the wakeup on if there is more work
+        if( more )
+            mWork.Signal();
+
+        query->mSuccess = query->Run();
+
+        {
+            MutexLock lock( mMQueue );
+
+            --mInFlight;
+            mDone.push_back( query );
+        }
+
+        // let the game thread complete it
+        Notify();
+    }
+
+    // wake up the next worker so it can stop as well
+    mWork.Signal();
+}
+
+void DBAsyncQueue::Notify()
+{
+    Event* event = mNotifyEvent;
+    if( NULL != event )
+        event->Signal();
+}
+
+#ifdef WIN32
+DWORD WINAPI DBAsyncQueue::WorkerLoop( LPVOID arg )
+#else /* !WIN32 */
+void* DBAsyncQueue::WorkerLoop( void* arg )
+#endif /* !WIN32 */
+{
+    DBAsyncQueue* queue = reinterpret_cast< DBAsyncQueue* >( arg );
+    assert( queue != NULL );
+
+#ifndef WIN32
+    sLog.Log( "Threading", "Starting DBAsyncQueue worker with thread ID %d", pthread_self() );
+#endif /* !WIN32 */
+
+    // the client library wants to know about threads using it
+    mysql_thread_init();
+    queue->Run();
+    mysql_thread_end();
+
+#ifdef WIN32
+    return 0;
+#else /* !WIN32 */
+    sLog.Log( "Threading", "Ending DBAsyncQueue worker with thread ID %d", pthread_self() );
+    return NULL;
+#endif /* !WIN32 */
+}
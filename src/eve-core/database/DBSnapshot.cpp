@@ -0,0 +1,413 @@
+/*
+    ------------------------------------------------------------------------------------
+    LICENSE:
+    ------------------------------------------------------------------------------------
+    This file is part of EVEmu: EVE Online Server Emulator
+    Copyright 2006 - 2011 The EVEmu Team
+    For the latest information visit http://evemu.org
+    ------------------------------------------------------------------------------------
+    This program is free software; you can redistribute it and/or modify it under
+    the terms of the GNU Lesser General Public License as published by the Free Software
+    Foundation; either version 2 of the License, or (at your option) any later
+    version.
+
+    This program is distributed in the hope that it will be useful, but WITHOUT
+    ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+    FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public License along with
+    this program; if not, write to the Free Software Foundation, Inc., 59 Temple
+    Place - Suite 330, Boston, MA 02111-1307, USA, or go to
+    http://www.gnu.org/copyleft/lesser.txt.
+    ------------------------------------------------------------------------------------
+    Author:     EVEmu Team
+*/
+
+#include "eve-core.h"
+
+#include "database/DBSnapshot.h"
+#include "log/LogNew.h"
+
+/*
+ * The file starts with a header, followed by the tables:
+ *
+ *   uint32 magic, format, table count
+ *
+ * and for every table:
+ *
+ *   uint32 name length, the name
+ *   uint32 column count, row count, text length
+ *   uint8  kind of every column
+ *   uint8  NULL flag of every cell, row by row
+ *   uint64 value of every cell, row by row
+ *   the texts, NUL-terminated
+ *
+ * A value is the number itself, or the offset of the text
+ * in the low 32 bits and its length in the high 32 bits.
+ */
+static const uint32 SNAPSHOT_MAGIC = 0x4E534244; // "DBSN"
+static const uint32 SNAPSHOT_FORMAT = 1;
+
+enum
+{
+    SNAPSHOT_INT,
+    SNAPSHOT_UINT,
+    SNAPSHOT_REAL,
+    SNAPSHOT_TEXT
+};
+
+/*************************************************************************/
+/* DBSnapshotWriter                                                      */
+/*************************************************************************/
+DBSnapshotWriter::DBSnapshotWriter()
+: mTableCount( 0 )
+{
+}
+
+uint32 DBSnapshotWriter::AddTable( const char* name, DBQueryResult& result )
+{
+    const uint32 columnCount = result.ColumnCount();
+
+    Buffer kinds;
+    for( uint32 i = 0; i < columnCount; ++i )
+    {
+        switch( result.ColumnType( i ) )
+        {
+            case DBTYPE_R4:
+            case DBTYPE_R8:
+                kinds.Append<uint8>( SNAPSHOT_REAL );
+                break;
+
+            case DBTYPE_BYTES:
+            case DBTYPE_STR:
+            case DBTYPE_WSTR:
+                kinds.Append<uint8>( SNAPSHOT_TEXT );
+                break;
+
+            default:
+                kinds.Append<uint8>( result.IsUnsigned( i ) ? SNAPSHOT_UINT : SNAPSHOT_INT );
+                break;
+        }
+    }
+
+    Buffer nulls, values;
+    std::string text;
+    uint32 rowCount = 0;
+
+    DBResultRow row;
+    while( result.GetRow( row ) )
+    {
+        for( uint32 i = 0; i < columnCount; ++i )
+        {
+            const bool null = row.IsNull( i );
+            nulls.Append<uint8>( null ? 1 : 0 );
+
+            uint64 value = 0;
+            if( !null )
+            {
+                switch( kinds[ i ] )
+                {
+                    case SNAPSHOT_INT:
+                        value = static_cast< uint64 >( row.GetInt64( i ) );
+                        break;
+
+                    case SNAPSHOT_UINT:
+                        value = row.GetUInt64( i );
+                        break;
+
+                    case SNAPSHOT_REAL:
+                    {
+                        const double d = row.GetDouble( i );
+                        memcpy( &value, &d, sizeof( value ) );
+                    } break;
+
+                    case SNAPSHOT_TEXT:
+                    {
+                        const uint32 len = row.ColumnLength( i );
+                        value = text.size() | ( static_cast< uint64 >( len ) << 32 );
+
+                        text.append( row.GetText( i ), len );
+                        text += '\0';
+                    } break;
+                }
+            }
+
+            values.Append<uint64>( value );
+        }
+
+        ++rowCount;
+    }
+
+    const uint32 nameLength = strlen( name );
+    mTables.Append<uint32>( nameLength );
+    mTables.AppendSeq( name, name + nameLength );
+    mTables.Append<uint32>( columnCount );
+    mTables.Append<uint32>( rowCount );
+    mTables.Append<uint32>( text.size() );
+    mTables.AppendSeq( kinds.begin<uint8>(), kinds.end<uint8>() );
+    mTables.AppendSeq( nulls.begin<uint8>(), nulls.end<uint8>() );
+    mTables.AppendSeq( values.begin<uint8>(), values.end<uint8>() );
+    mTables.AppendSeq( text.begin(), text.end() );
+
+    ++mTableCount;
+    return rowCount;
+}
+
+bool DBSnapshotWriter::Save( const char* filename ) const
+{
+    const std::string tempname = std::string( filename ) + ".tmp";
+
+    FILE* f = fopen( tempname.c_str(), "wb" );
+    if( NULL == f )
+        return false;
+
+    const uint32 header[] = { SNAPSHOT_MAGIC, SNAPSHOT_FORMAT, mTableCount };
+
+    bool res = ( 1 == fwrite( header, sizeof( header ), 1, f ) );
+    if( res && 0 < mTables.size() )
+        res = ( mTables.size() == fwrite( &mTables[0], 1, mTables.size(), f ) );
+
+    res = ( 0 == fclose( f ) ) && res;
+
+#ifdef WIN32
+    // rename does not replace existing files here
+    if( res )
+        remove( filename );
+#endif /* WIN32 */
+
+    if( !res || 0 != rename( tempname.c_str(), filename ) )
+    {
+        remove( tempname.c_str() );
+        return false;
+    }
+
+    return true;
+}
+
+/*************************************************************************/
+/* DBSnapshotRow                                                         */
+/*************************************************************************/
+DBSnapshotRow::DBSnapshotRow()
+: mColumnCount( 0 ),
+  mKinds( NULL ),
+  mNulls( NULL ),
+  mValues( NULL ),
+  mText( NULL )
+{
+}
+
+const char* DBSnapshotRow::GetText( uint32 index ) const
+{
+    const uint64 value = _GetValue( index );
+
+    char buf[32];
+    switch( mKinds[ index ] )
+    {
+        case SNAPSHOT_INT:
+            snprintf( buf, sizeof( buf ), "%" PRId64, static_cast< int64 >( value ) );
+            break;
+
+        case SNAPSHOT_UINT:
+            snprintf( buf, sizeof( buf ), "%" PRIu64, value );
+            break;
+
+        case SNAPSHOT_REAL:
+            snprintf( buf, sizeof( buf ), "%.17g", GetDouble( index ) );
+            break;
+
+        default:
+            return IsNull( index ) ? "" : &mText[ static_cast< uint32 >( value ) ];
+    }
+
+    mFormatted = buf;
+    return mFormatted.c_str();
+}
+
+int64 DBSnapshotRow::GetInt64( uint32 index ) const
+{
+    switch( mKinds[ index ] )
+    {
+        case SNAPSHOT_REAL:
+            return static_cast< int64 >( GetDouble( index ) );
+
+        case SNAPSHOT_TEXT:
+            return strtoll( GetText( index ), NULL, 0 );
+
+        default:
+            return static_cast< int64 >( _GetValue( index ) );
+    }
+}
+
+uint64 DBSnapshotRow::GetUInt64( uint32 index ) const
+{
+    switch( mKinds[ index ] )
+    {
+        case SNAPSHOT_REAL:
+            return static_cast< uint64 >( GetDouble( index ) );
+
+        case SNAPSHOT_TEXT:
+            return strtoull( GetText( index ), NULL, 0 );
+
+        default:
+            return _GetValue( index );
+    }
+}
+
+double DBSnapshotRow::GetDouble( uint32 index ) const
+{
+    const uint64 value = _GetValue( index );
+
+    switch( mKinds[ index ] )
+    {
+        case SNAPSHOT_INT:
+            return static_cast< double >( static_cast< int64 >( value ) );
+
+        case SNAPSHOT_UINT:
+            return static_cast< double >( value );
+
+        case SNAPSHOT_REAL:
+        {
+            double d;
+            memcpy( &d, &value, sizeof( d ) );
+            return d;
+        }
+
+        default:
+            return strtod( GetText( index ), NULL );
+    }
+}
+
+uint32 DBSnapshotRow::ColumnLength( uint32 index ) const
+{
+    if( SNAPSHOT_TEXT == mKinds[ index ] )
+        return static_cast< uint32 >( _GetValue( index ) >> 32 );
+
+    return strlen( GetText( index ) );
+}
+
+uint64 DBSnapshotRow::_GetValue( uint32 index ) const
+{
+    assert( index < mColumnCount );
+
+    // the values are not aligned
+    uint64 value;
+    memcpy( &value, &mValues[ index * sizeof( uint64 ) ], sizeof( value ) );
+    return value;
+}
+
+/*************************************************************************/
+/* DBSnapshot                                                            */
+/*************************************************************************/
+bool DBSnapshot::Table::GetRow( uint32 index, DBSnapshotRow& into ) const
+{
+    if( index >= mRowCount )
+        return false;
+
+    into.mColumnCount = mColumnCount;
+    into.mKinds = mKinds;
+    into.mNulls = &mNulls[ index * mColumnCount ];
+    into.mValues = &mValues[ index * mColumnCount * sizeof( uint64 ) ];
+    into.mText = mText;
+
+    return true;
+}
+
+bool DBSnapshot::Load( const char* filename )
+{
+    mTables.clear();
+
+    FILE* f = fopen( filename, "rb" );
+    if( NULL == f )
+        return false;
+
+    fseek( f, 0, SEEK_END );
+    const long size = ftell( f );
+    fseek( f, 0, SEEK_SET );
+
+    if( 0 >= size )
+    {
+        fclose( f );
+        return false;
+    }
+
+    // the whole file at once
+    mData.Resize<uint8>( size );
+    const bool read = ( mData.size() == fread( &mData[0], 1, mData.size(), f ) );
+    fclose( f );
+
+    if( !read )
+        return false;
+
+    const uint8* cur = &mData[0];
+    const uint8* const end = cur + mData.size();
+
+#define SNAPSHOT_READ( var, len ) \
+    if( (size_t)( end - cur ) < (size_t)( len ) ) \
+        goto invalid; \
+    var = cur; \
+    cur += ( len )
+
+    const uint8* p;
+    uint32 header[3];
+
+    SNAPSHOT_READ( p, sizeof( header ) );
+    memcpy( header, p, sizeof( header ) );
+
+    if( SNAPSHOT_MAGIC != header[0] || SNAPSHOT_FORMAT != header[1] )
+        goto invalid;
+
+    mTables.resize( header[2] );
+    for( uint32 i = 0; i < header[2]; ++i )
+    {
+        Table& table = mTables[ i ];
+        uint32 fields[3];
+
+        SNAPSHOT_READ( p, sizeof( uint32 ) );
+        memcpy( fields, p, sizeof( uint32 ) );
+
+        SNAPSHOT_READ( p, fields[0] );
+        table.mName.assign( (const char*)p, fields[0] );
+
+        SNAPSHOT_READ( p, sizeof( fields ) );
+        memcpy( fields, p, sizeof( fields ) );
+
+        table.mColumnCount = fields[0];
+        table.mRowCount = fields[1];
+
+        const uint64 cells = (uint64)table.mColumnCount * table.mRowCount;
+
+        SNAPSHOT_READ( table.mKinds, table.mColumnCount );
+        SNAPSHOT_READ( table.mNulls, cells );
+        SNAPSHOT_READ( table.mValues, cells * sizeof( uint64 ) );
+        SNAPSHOT_READ( p, fields[2] );
+        table.mText = (const char*)p;
+
+        // the texts must stay within the table
+        if( 0 < fields[2] && '\0' != table.mText[ fields[2] - 1 ] )
+            goto invalid;
+    }
+
+#undef SNAPSHOT_READ
+
+    return true;
+
+invalid:
+    sLog.Error( "DBSnapshot", "Snapshot '%s' is not valid.", filename );
+    mTables.clear();
+    mData.Resize<uint8>( 0 );
+    return false;
+}
+
+const DBSnapshot::Table* DBSnapshot::GetTable( const char* name ) const
+{
+    std::vector< Table >::const_iterator cur, end;
+    cur = mTables.begin();
+    end = mTables.end();
+    for(; cur != end; ++cur )
+    {
+        if( cur->name() == name )
+            return &*cur;
+    }
+
+    return NULL;
+}
@@ -29,35 +29,668 @@
 
 #include "log/LogNew.h"
 #include "log/logsys.h"
+#include "utils/CallTracer.h"
+#include "utils/Metrics.h"
 #include "utils/misc.h"
+#include "utils/TickProfiler.h"
+#include "utils/utils_time.h"
 
 //#define COLUMN_BOUNDS_CHECKING
 
-DBcore::DBcore(bool compress, bool ssl) : pCompress(compress), pSSL(ssl)
+/// Longest time (in milliseconds) a checkout sleeps before it checks the pool again.
+static const uint32 DBCORE_POOL_WAIT_SLICE = 100;
+/// Longest part of a query the slow query log prints.
+static const int DBCORE_SLOW_QUERY_LOG_LENGTH = 1024;
+/// Longest statement kept as a sample for the index advisor.
+static const size_t DBCORE_SAMPLE_LENGTH = 4096;
+/// Fewest rows a full scan must examine to be reported; the small tables are read whole anyway.
+static const uint64 DBCORE_ADVISOR_MIN_ROWS = 100;
+
+/// Call site of the queries run by this thread, as given to DBcore::At().
+static THREAD_LOCAL const char* s_callFile = NULL;
+static THREAD_LOCAL int s_callLine = 0;
+
+/** @return Histogram of the query latencies. */
+static MetricHistogram& QueryLatencyMetric()
+{
+    static MetricHistogram& metric = sMetrics.LatencyHistogram( "evemu_db_query_seconds", "Time the database queries took, results included." );
+    return metric;
+}
+/** @return Histogram of the connection checkout waits. */
+static MetricHistogram& CheckoutWaitMetric()
+{
+    static MetricHistogram& metric = sMetrics.LatencyHistogram( "evemu_db_checkout_wait_seconds", "Time the queries waited for a pooled connection." );
+    return metric;
+}
+/** @return Counter of the failed queries. */
+static MetricCounter& QueryErrorMetric()
+{
+    static MetricCounter& metric = sMetrics.Counter( "evemu_db_query_errors_total", "Number of database queries which failed." );
+    return metric;
+}
+
+/************************************************************************/
+/* DBcore::QueryStats                                                   */
+/************************************************************************/
+DBcore::QueryStats::QueryStats()
+: calls( 0 ),
+  rows( 0 ),
+  totalTime( 0 ),
+  maxTime( 0 ),
+  waitTime( 0 ),
+  maxFile( NULL ),
+  maxLine( 0 )
+{
+    for( size_t i = 0; i < HISTOGRAM_SIZE; ++i )
+        histogram[ i ] = 0;
+}
+
+void DBcore::QueryStats::Record( uint64 time, uint64 _rows, uint32 _waitTime, const char* file, int line )
+{
+    ++calls;
+    rows += _rows;
+    totalTime += time;
+    waitTime += _waitTime;
+
+    if( maxTime <= time )
+    {
+        maxTime = time;
+        maxFile = file;
+        maxLine = line;
+    }
+
+    // decade buckets, starting at 10us
+    size_t bucket = 0;
+    for( uint64 limit = 10; bucket + 1 < HISTOGRAM_SIZE && limit <= time; limit *= 10 )
+        ++bucket;
+
+    ++histogram[ bucket ];
+}
+
+/************************************************************************/
+/* DBcore                                                               */
+/************************************************************************/
+DBcore::DBcore(bool compress, bool ssl)
+: mPoolSize(1),
+  mNextReplica(0),
+  mSlowQueryThreshold(0),
+  mIndexAdvisor(false),
+  pStatus(Closed),
+  pCompress(compress),
+  pPort(0),
+  pSSL(ssl)
 {
-    mysql_init(&mysql);
-    pStatus = Closed;
 }
 
 DBcore::~DBcore()
 {
-    mysql_close(&mysql);
+    // all connections are supposed to be returned by now
+    std::vector<Connection*>::iterator cur, end;
+    cur = mConnections.begin();
+    end = mConnections.end();
+    for(; cur != end; ++cur)
+        SafeDelete( *cur );
+
+    std::vector<Replica*>::iterator curr, endr;
+    curr = mReplicas.begin();
+    endr = mReplicas.end();
+    for(; curr != endr; ++curr)
+        SafeDelete( *curr );
+}
+
+void DBcore::SetPoolSize( size_t size )
+{
+    MutexLock lock(mPoolMutex);
+
+    mPoolSize = std::max< size_t >( 1, size );
+}
+
+DBcore::Stats DBcore::GetStats()
+{
+    MutexLock lock(mPoolMutex);
+
+    return mStats;
+}
+
+void DBcore::ResetStats()
+{
+    MutexLock lock(mPoolMutex);
+
+    mStats.Reset();
+}
+
+void DBcore::GetQueryStats( QueryStatsMap& into )
+{
+    MutexLock lock(mQueryStatsMutex);
+
+    into = mQueryStats;
+}
+
+void DBcore::ResetQueryStats()
+{
+    MutexLock lock(mQueryStatsMutex);
+
+    mQueryStats.clear();
+}
+
+void DBcore::SetSlowQueryThreshold( uint32 threshold )
+{
+    mSlowQueryThreshold = threshold;
+}
+
+void DBcore::SetIndexAdvisor( bool enabled )
+{
+    mIndexAdvisor = enabled;
+}
+
+/** @return True if EXPLAIN takes the statement. */
+static bool _IsExplainable( const char* query, size_t len )
+{
+    static const char* const verbs[] = { "SELECT", "UPDATE", "DELETE" };
+
+    const char* cur = query;
+    const char* end = query + len;
+    while( cur < end && isspace( (unsigned char)*cur ) )
+        ++cur;
+
+    for( size_t i = 0; i < sizeof( verbs ) / sizeof( verbs[ 0 ] ); ++i )
+    {
+        const size_t verbLen = strlen( verbs[ i ] );
+        if( verbLen <= (size_t)( end - cur ) && 0 == strncasecmp( cur, verbs[ i ], verbLen ) )
+            return true;
+    }
+
+    return false;
+}
+
+size_t DBcore::AdviseIndexes( size_t count, std::vector<IndexAdvice>& into )
+{
+    QueryStatsMap stats;
+    GetQueryStats( stats );
+
+    // most expensive first
+    std::vector< std::pair<uint64, const std::string*> > order;
+    QueryStatsMap::const_iterator cur, end;
+    cur = stats.begin();
+    end = stats.end();
+    for(; cur != end; cur++)
+    {
+        if( !cur->second.sample.empty() )
+            order.push_back( std::make_pair( cur->second.totalTime, &cur->first ) );
+    }
+    std::sort( order.rbegin(), order.rend() );
+
+    size_t explained = 0;
+    for( size_t i = 0; i < order.size() && explained < count; ++i )
+    {
+        const QueryStats& s = stats[ *order[ i ].second ];
+
+        DBQueryResult res;
+        if( !RunQueryString( res, "EXPLAIN " + s.sample ) )
+        {
+            sLog.Warning( "DBCore", "Unable to explain %s: %s", order[ i ].second->c_str(), res.error.c_str() );
+            continue;
+        }
+        ++explained;
+
+        // the columns differ between the versions of MySQL
+        int table = -1, access = -1, key = -1, rows = -1, extra = -1;
+        for( uint32 c = 0; c < res.ColumnCount(); ++c )
+        {
+            const char* name = res.ColumnName( c );
+            if( 0 == strcasecmp( name, "table" ) )
+                table = c;
+            else if( 0 == strcasecmp( name, "type" ) )
+                access = c;
+            else if( 0 == strcasecmp( name, "key" ) )
+                key = c;
+            else if( 0 == strcasecmp( name, "rows" ) )
+                rows = c;
+            else if( 0 == strcasecmp( name, "Extra" ) )
+                extra = c;
+        }
+        if( table < 0 || access < 0 || rows < 0 )
+            continue;
+
+        DBResultRow row;
+        while( res.GetRow( row ) )
+        {
+            IndexAdvice advice;
+            advice.table = ( row.IsNull( table ) ? "" : row.GetText( table ) );
+            advice.access = ( row.IsNull( access ) ? "" : row.GetText( access ) );
+            advice.key = ( key < 0 || row.IsNull( key ) ? "" : row.GetText( key ) );
+            advice.rows = ( row.IsNull( rows ) ? 0 : row.GetUInt64( rows ) );
+            advice.extra = ( extra < 0 || row.IsNull( extra ) ? "" : row.GetText( extra ) );
+
+            const bool scan = ( "ALL" == advice.access || "index" == advice.access ) && DBCORE_ADVISOR_MIN_ROWS <= advice.rows;
+            const bool sort = std::string::npos != advice.extra.find( "filesort" )
+                              || std::string::npos != advice.extra.find( "temporary" );
+            if( !scan && !sort )
+                continue;
+
+            advice.fingerprint = *order[ i ].second;
+            advice.calls = s.calls;
+            advice.totalTime = s.totalTime;
+            into.push_back( advice );
+        }
+    }
+
+    return explained;
+}
+
+DBcore& DBcore::At( const char* file, int line )
+{
+    // the directories only make the log longer
+    const char* name = file;
+    for( const char* cur = file; '\0' != *cur; ++cur )
+        if( '/' == *cur || '\\' == *cur )
+            name = cur + 1;
+
+    s_callFile = name;
+    s_callLine = line;
+
+    return *this;
+}
+
+/// Adds a placeholder to a fingerprint; lists of them ("?, ?, ?") are collapsed into one.
+static void _AddPlaceholder( std::string& fp )
+{
+    const size_t len = fp.size();
+    if( 2 <= len && ',' == fp[ len - 1 ] && '?' == fp[ len - 2 ] )
+        fp.resize( len - 1 );
+    else if( 3 <= len && ' ' == fp[ len - 1 ] && ',' == fp[ len - 2 ] && '?' == fp[ len - 3 ] )
+        fp.resize( len - 2 );
+    else
+        fp += '?';
+}
+
+/// Collapses lists of placeholder tuples ("(?), (?)") that end a fingerprint into one.
+static void _CollapseTuples( std::string& fp )
+{
+    static const char tuple[] = "(?)";
+    static const size_t tupleLen = sizeof( tuple ) - 1;
+
+    const size_t len = fp.size();
+    if( len < tupleLen || 0 != fp.compare( len - tupleLen, tupleLen, tuple ) )
+        return;
+
+    size_t sep = len - tupleLen;
+    if( 1 <= sep && ' ' == fp[ sep - 1 ] )
+        --sep;
+    if( 1 <= sep && ',' == fp[ sep - 1 ] )
+        --sep;
+    else
+        return;
+
+    if( tupleLen <= sep && 0 == fp.compare( sep - tupleLen, tupleLen, tuple ) )
+        fp.resize( sep );
+}
+
+std::string DBcore::Fingerprint( const char* query, size_t len )
+{
+    std::string fp;
+    fp.reserve( len );
+
+    const char* cur = query;
+    const char* end = query + len;
+    while( cur < end )
+    {
+        const char c = *cur;
+
+        if( isspace( (unsigned char)c ) )
+        {
+            while( cur < end && isspace( (unsigned char)*cur ) )
+                ++cur;
+
+            if( !fp.empty() && cur < end )
+                fp += ' ';
+        }
+        else if( '\'' == c || '"' == c )
+        {
+            // skip the string including its escapes
+            for( ++cur; cur < end && c != *cur; ++cur )
+            {
+                if( '\\' == *cur && cur + 1 < end )
+                    ++cur;
+            }
+            if( cur < end )
+                ++cur;
+
+            _AddPlaceholder( fp );
+        }
+        else if( isdigit( (unsigned char)c )
+                 && ( fp.empty() || !( isalnum( (unsigned char)fp[ fp.size() - 1 ] ) || '_' == fp[ fp.size() - 1 ] ) ) )
+        {
+            // hexadecimal and decimal numbers alike
+            while( cur < end && ( isalnum( (unsigned char)*cur ) || '.' == *cur ) )
+                ++cur;
+
+            _AddPlaceholder( fp );
+        }
+        else if( '?' == c )
+        {
+            // parameter of a prepared statement
+            ++cur;
+            _AddPlaceholder( fp );
+        }
+        else
+        {
+            ++cur;
+            fp += c;
+
+            if( ')' == c )
+                _CollapseTuples( fp );
+        }
+    }
+
+    return fp;
 }
 
-// Sends the MySQL server a ping
-void DBcore::ping()
+void DBcore::RecordQuery(Connection& conn, const char *query, size_t querylen, uint64 time, uint64 rows, bool sample)
 {
-    // well, if it's locked, someone's using it. If someone's using it, it doesn't need a ping
-    if( MDatabase.TryLock() )
+    // the wait is charged to the first query of the checkout
+    const uint32 waitTime = conn.waitTime;
+    conn.waitTime = 0;
+
+    QueryLatencyMetric().Observe( time );
+    CheckoutWaitMetric().Observe( (uint64)waitTime * 1000 );
+    CallTracer::AddQuery( time );
+
+    const std::string fingerprint = Fingerprint( query, querylen );
+    {
+        MutexLock lock(mQueryStatsMutex);
+
+        QueryStats& stats = mQueryStats[ fingerprint ];
+        stats.Record( time, rows, waitTime, s_callFile, s_callLine );
+
+        if( sample && mIndexAdvisor && stats.sample.empty()
+            && querylen <= DBCORE_SAMPLE_LENGTH && _IsExplainable( query, querylen ) )
+            stats.sample.assign( query, querylen );
+    }
+
+    const uint64 ms = time / 1000;
+    if( 0 < mSlowQueryThreshold && mSlowQueryThreshold <= ms )
     {
-        mysql_ping( &mysql );
-        MDatabase.Unlock();
+        sLog.Warning( "DBCore", "Slow query (%" PRIu64 " ms, %" PRIu64 " rows) at %s:%d: %.*s",
+                      ms, rows, ( NULL != s_callFile ? s_callFile : "(unknown)" ), s_callLine,
+                      (int)std::min< size_t >( querylen, DBCORE_SLOW_QUERY_LOG_LENGTH ), query );
     }
 }
 
+DBcore::Connection* DBcore::Acquire( Replica* replica )
+{
+    std::vector<Connection*>& connections = ( NULL != replica ? replica->connections : mConnections );
+    std::vector<Connection*>& idle = ( NULL != replica ? replica->idle : mIdle );
+
+    uint32 start = 0;
+    bool waited = false;
+
+    while( true )
+    {
+        {
+            MutexLock lock(mPoolMutex);
+
+            Connection* conn = NULL;
+            if( !idle.empty() )
+            {
+                conn = idle.back();
+                idle.pop_back();
+            }
+            else if( connections.size() < mPoolSize )
+            {
+                // the connection gets opened by its first query
+                conn = new Connection;
+                conn->replica = replica;
+                connections.push_back( conn );
+            }
+
+            if( NULL != conn )
+            {
+                ++mStats.checkouts;
+                conn->waitTime = 0;
+                if( waited )
+                {
+                    const uint32 waitTime = GetTickCount() - start;
+                    conn->waitTime = waitTime;
+
+                    ++mStats.waits;
+                    mStats.waitTime += waitTime;
+                    mStats.maxWaitTime = std::max( mStats.maxWaitTime, waitTime );
+                }
+
+                return conn;
+            }
+
+            if( !waited )
+            {
+                start = GetTickCount();
+                waited = true;
+            }
+        }
+
+        // signals are not counted, so do not rely on getting every one
+        mPoolEvent.Wait( DBCORE_POOL_WAIT_SLICE );
+    }
+}
+
+DBcore::Connection* DBcore::AcquireRead()
+{
+    Replica* replica = NULL;
+    {
+        MutexLock lock(mPoolMutex);
+
+        // take turns among the up to date replicas
+        for( size_t i = 0; i < mReplicas.size(); ++i )
+        {
+            Replica* r = mReplicas[ ( mNextReplica + i ) % mReplicas.size() ];
+            if( r->fresh )
+            {
+                replica = r;
+                mNextReplica = ( mNextReplica + i + 1 ) % mReplicas.size();
+                break;
+            }
+        }
+
+        if( NULL != replica )
+            ++mStats.replicaReads;
+        else if( !mReplicas.empty() )
+            ++mStats.primaryReads;
+    }
+
+    return Acquire( replica );
+}
+
+bool DBcore::ReplicaFailed( Connection& conn, const DBerror& err )
+{
+    // only errors of the client mean the replica is gone
+    if( NULL == conn.replica || err.GetErrNo() < CR_MIN_ERROR || CR_MAX_ERROR < err.GetErrNo() )
+        return false;
+
+    MutexLock lock(mPoolMutex);
+
+    if( conn.replica->fresh )
+    {
+        sLog.Error( "DBCore", "Lost replica %s:%d, reading from the primary until it is back.", conn.replica->host.c_str(), conn.replica->port );
+        conn.replica->fresh = false;
+    }
+
+    ++mStats.primaryReads;
+    return true;
+}
+
+void DBcore::Release( Connection* conn )
+{
+    {
+        MutexLock lock(mPoolMutex);
+
+        std::vector<Connection*>& connections = ( NULL != conn->replica ? conn->replica->connections : mConnections );
+        std::vector<Connection*>& idle = ( NULL != conn->replica ? conn->replica->idle : mIdle );
+
+        if( connections.size() <= mPoolSize )
+            idle.push_back( conn );
+        else
+        {
+            // the pool has been shrunk
+            connections.erase( std::find( connections.begin(), connections.end(), conn ) );
+            SafeDelete( conn );
+        }
+    }
+
+    mPoolEvent.Signal();
+}
+
+void DBcore::EndStream( MYSQL* mysql, bool failed )
+{
+    Connection* conn = NULL;
+    {
+        MutexLock lock(mPoolMutex);
+
+        // the primary's connections first, then those of the replicas
+        for( size_t i = 0; NULL == conn && i <= mReplicas.size(); ++i )
+        {
+            const std::vector<Connection*>& connections = ( 0 == i ? mConnections : mReplicas[ i - 1 ]->connections );
+
+            std::vector<Connection*>::const_iterator cur, end;
+            cur = connections.begin();
+            end = connections.end();
+            for(; cur != end; ++cur)
+            {
+                if( &( *cur )->mysql == mysql )
+                {
+                    conn = *cur;
+                    break;
+                }
+            }
+        }
+    }
+
+    assert( NULL != conn );
+    if( failed )
+        // the rest of the rows may still be on the way
+        conn->status = Error;
+
+    Release( conn );
+}
+
+// Pings the idle connections
+size_t DBcore::ping()
+{
+    // connections in use don't need a ping; take the idle ones out meanwhile
+    std::vector<Connection*> idle;
+    {
+        MutexLock lock(mPoolMutex);
+        idle.swap( mIdle );
+
+        std::vector<Replica*>::iterator cur, end;
+        cur = mReplicas.begin();
+        end = mReplicas.end();
+        for(; cur != end; ++cur)
+        {
+            idle.insert( idle.end(), ( *cur )->idle.begin(), ( *cur )->idle.end() );
+            ( *cur )->idle.clear();
+        }
+    }
+
+    size_t failures = 0;
+
+    std::vector<Connection*>::iterator cur, end;
+    cur = idle.begin();
+    end = idle.end();
+    for(; cur != end; ++cur)
+    {
+        Connection& conn = **cur;
+        if( conn.status != Connected )
+            continue;
+
+        if( 0 != mysql_ping( &conn.mysql ) )
+        {
+            sLog.Error( "DBCore", "Connection failed health check: %s", mysql_error( &conn.mysql ) );
+            // reconnected by the next query
+            conn.status = Error;
+            ++failures;
+        }
+    }
+
+    {
+        MutexLock lock(mPoolMutex);
+        for( cur = idle.begin(); cur != end; ++cur )
+            ( NULL != ( *cur )->replica ? ( *cur )->replica->idle : mIdle ).push_back( *cur );
+        mStats.pingFailures += failures;
+    }
+
+    mPoolEvent.Signal();
+    return failures;
+}
+
+void DBcore::AddReplica(const char* host, int16 port)
+{
+    MutexLock lock(mPoolMutex);
+
+    mReplicas.push_back( new Replica( host, port ) );
+}
+
+size_t DBcore::CheckReplicas(uint32 maxLag)
+{
+    std::vector<Replica*> replicas;
+    {
+        MutexLock lock(mPoolMutex);
+        replicas = mReplicas;
+    }
+
+    size_t fresh = 0;
+
+    std::vector<Replica*>::iterator cur, end;
+    cur = replicas.begin();
+    end = replicas.end();
+    for(; cur != end; ++cur)
+    {
+        Replica& replica = **cur;
+
+        // replicas never get removed, so they may be checked without the lock
+        bool upToDate = false;
+        int64 lag = -1;
+        {
+            ConnectionLock conn(*this, Acquire(&replica));
+
+            DBQueryResult res;
+            DBResultRow row;
+            if( DoResultQuery_locked(*conn, res, "SHOW SLAVE STATUS", 17) && res.GetRow(row) )
+            {
+                for( uint32 i = 0; i < row.ColumnCount(); ++i )
+                {
+                    // NULL if the replication is not running
+                    if( 0 == strcmp( row.ColumnName( i ), "Seconds_Behind_Master" ) && !row.IsNull( i ) )
+                        lag = row.GetInt64( i );
+                }
+            }
+
+            upToDate = ( 0 <= lag && lag <= maxLag );
+        }
+
+        MutexLock lock(mPoolMutex);
+
+        if( upToDate && !replica.fresh )
+            sLog.Success( "DBCore", "Replica %s:%d is up to date (%" PRId64 " s behind), reading from it.", replica.host.c_str(), replica.port, lag );
+        else if( !upToDate && ( replica.fresh || !replica.checked ) )
+        {
+            if( 0 <= lag )
+                sLog.Warning( "DBCore", "Replica %s:%d is %" PRId64 " s behind, reading from the primary until it catches up.", replica.host.c_str(), replica.port, lag );
+            else
+                sLog.Warning( "DBCore", "Replica %s:%d does not replicate, reading from the primary until it does.", replica.host.c_str(), replica.port );
+        }
+
+        replica.fresh = upToDate;
+        replica.checked = true;
+        if( upToDate )
+            ++fresh;
+    }
+
+    return fresh;
+}
+
 //query which returns a result (error is stored in the result if it occurs)
 bool DBcore::RunQuery(DBQueryResult &into, const char *query_fmt, ...) {
-    MutexLock lock(MDatabase);
+    ConnectionLock conn(*this);
 
     char query[16384];
     va_list vlist;
@@ -65,32 +698,156 @@ bool DBcore::RunQuery(DBQueryResult &into, const char *query_fmt, ...) {
     uint32 querylen = vsnprintf(query, 16384, query_fmt, vlist);
     va_end(vlist);
 
-    if(!DoQuery_locked(into.error, query, querylen))
+    return DoResultQuery_locked(*conn, into, query, querylen);
+}
+
+//already formatted query which returns a result
+bool DBcore::RunQueryString(DBQueryResult &into, const std::string &query) {
+    ConnectionLock conn(*this);
+
+    return DoResultQuery_locked(*conn, into, query.c_str(), (int32)query.length());
+}
+
+bool DBcore::DoResultQuery_locked(Connection& conn, DBQueryResult &into, const char *query, int32 querylen)
+{
+    MYSQL_RES *result = NULL;
+    if(!DoQuery_locked(conn, into.error, query, querylen, true, &result))
         return false;
 
-    uint32 col_count = mysql_field_count(&mysql);
-    if(col_count == 0) {
-        into.error.SetError(0xFFFF, "DBcore::RunQuery: No Result");
-        sLog.Error("DBCore Query", "Query: %s failed because did not return a result", query);
+    uint32 col_count = mysql_field_count(&conn.mysql);
+    if(col_count == 0) {
+        into.error.SetError(0xFFFF, "DBcore::RunQuery: No Result");
+        sLog.Error("DBCore Query", "Query: %s failed because did not return a result", query);
+        return false;
+    }
+
+    //give them the result set.
+    into.SetResult(&result, col_count);
+
+    //DEBUG STUFF
+    //sLog.Debug("%s",query);
+    //End Debug Stuff
+
+
+    return true;
+}
+
+//query which returns a result fetched row by row
+bool DBcore::RunQueryStream(DBQueryResult &into, const char *query_fmt, ...) {
+    // let go of the previous stream first, it may hold the last free connection
+    into.SetResult(NULL, 0);
+
+    char query[16384];
+    va_list vlist;
+    va_start(vlist, query_fmt);
+    uint32 querylen = vsnprintf(query, 16384, query_fmt, vlist);
+    va_end(vlist);
+
+    Connection* conn = Acquire();
+    if(DoStreamQuery(conn, into, query, querylen))
+        return true;
+
+    Release(conn);
+    return false;
+}
+
+bool DBcore::DoStreamQuery(Connection* conn, DBQueryResult &into, const char *query, int32 querylen)
+{
+    if(!DoQuery_locked(*conn, into.error, query, querylen))
+        return false;
+
+    uint32 col_count = mysql_field_count(&conn->mysql);
+    if(col_count == 0) {
+        into.error.SetError(0xFFFF, "DBcore::RunQuery: No Result");
+        sLog.Error("DBCore Query", "Query: %s failed because did not return a result", query);
+        return false;
+    }
+
+    MYSQL_RES *result = mysql_use_result(&conn->mysql);
+    if(result == NULL) {
+        into.error.SetError(mysql_errno(&conn->mysql), mysql_error(&conn->mysql));
+        sLog.Error("DBCore Query", "#%d in '%s': %s", into.error.GetErrNo(), query, into.error.c_str());
+
+        conn->status = Error;
+        return false;
+    }
+
+    //the result returns the connection once it is done with it.
+    into.SetStream(&result, col_count, &conn->mysql);
+    return true;
+}
+
+//read-only query which returns a result
+bool DBcore::RunReadQuery(DBQueryResult &into, const char *query_fmt, ...) {
+    char query[16384];
+    va_list vlist;
+    va_start(vlist, query_fmt);
+    uint32 querylen = vsnprintf(query, 16384, query_fmt, vlist);
+    va_end(vlist);
+
+    return RunReadQueryString(into, std::string(query, querylen));
+}
+
+//already formatted read-only query which returns a result
+bool DBcore::RunReadQueryString(DBQueryResult &into, const std::string &query) {
+    {
+        ConnectionLock conn(*this, AcquireRead());
+
+        const bool success = DoResultQuery_locked(*conn, into, query.c_str(), (int32)query.length());
+        if(success || !ReplicaFailed(*conn, into.error))
+            return success;
+    }
+
+    //the primary has the data too
+    return RunQueryString(into, query);
+}
+
+//read-only query which returns a result fetched row by row as it arrives
+bool DBcore::RunReadQueryStream(DBQueryResult &into, const char *query_fmt, ...) {
+    // let go of the previous stream first, it may hold the last free connection
+    into.SetResult(NULL, 0);
+
+    char query[16384];
+    va_list vlist;
+    va_start(vlist, query_fmt);
+    uint32 querylen = vsnprintf(query, 16384, query_fmt, vlist);
+    va_end(vlist);
+
+    Connection* conn = AcquireRead();
+    if(DoStreamQuery(conn, into, query, querylen))
+        return true;
+
+    const bool retry = ReplicaFailed(*conn, into.error);
+    Release(conn);
+    if(!retry)
         return false;
-    }
 
-    MYSQL_RES *result = mysql_store_result(&mysql);
+    //the primary has the data too
+    conn = Acquire();
+    if(DoStreamQuery(conn, into, query, querylen))
+        return true;
 
-    //give them the result set.
-    into.SetResult(&result, col_count);
+    Release(conn);
+    return false;
+}
 
-    //DEBUG STUFF
-    //sLog.Debug("%s",query);
-    //End Debug Stuff
+//read-only prepared statement which returns a result
+bool DBcore::RunReadPrepared(DBQueryResult &into, const char *query, const DBParams &params) {
+    {
+        ConnectionLock conn(*this, AcquireRead());
 
+        const bool success = DoPrepared_locked(*conn, into.error, query, params, true, &into) != NULL;
+        if(success || !ReplicaFailed(*conn, into.error))
+            return success;
+    }
 
-    return true;
+    //the primary has the data too
+    return RunPrepared(into, query, params);
 }
 
 //query which returns no information except error status
 bool DBcore::RunQuery(DBerror &err, const char *query_fmt, ...) {
-    MutexLock lock(MDatabase);
+    ConnectionLock conn(*this);
 
     va_list args;
     va_start(args, query_fmt);
@@ -98,7 +855,7 @@ bool DBcore::RunQuery(DBerror &err, const char *query_fmt, ...) {
     uint32 querylen = vasprintf(&query, query_fmt, args);
     va_end(args);
 
-    if(!DoQuery_locked(err, query, querylen)) {
+    if(!DoQuery_locked(*conn, err, query, querylen)) {
         free(query);
         return false;
     }
@@ -109,7 +866,7 @@ bool DBcore::RunQuery(DBerror &err, const char *query_fmt, ...) {
 
 //query which returns affected rows:
 bool DBcore::RunQuery(DBerror &err, uint32 &affected_rows, const char *query_fmt, ...) {
-    MutexLock lock(MDatabase);
+    ConnectionLock conn(*this);
 
     va_list args;
     va_start(args, query_fmt);
@@ -117,20 +874,20 @@ bool DBcore::RunQuery(DBerror &err, uint32 &affected_rows, const char *query_fmt
     uint32 querylen = vasprintf(&query, query_fmt, args);
     va_end(args);
 
-    if(!DoQuery_locked(err, query, querylen)) {
+    if(!DoQuery_locked(*conn, err, query, querylen)) {
         free(query);
         return false;
     }
     free(query);
 
-    affected_rows = (uint32)mysql_affected_rows(&mysql);
+    affected_rows = (uint32)mysql_affected_rows(conn.mysql());
 
     return true;
 }
 
 //query which returns last insert ID:
 bool DBcore::RunQueryLID(DBerror &err, uint32 &last_insert_id, const char *query_fmt, ...) {
-    MutexLock lock(MDatabase);
+    ConnectionLock conn(*this);
 
     va_list args;
     va_start(args, query_fmt);
@@ -138,40 +895,270 @@ bool DBcore::RunQueryLID(DBerror &err, uint32 &last_insert_id, const char *query
     uint32 querylen = vasprintf(&query, query_fmt, args);
     va_end(args);
 
-    if(!DoQuery_locked(err, query, querylen)) {
+    if(!DoQuery_locked(*conn, err, query, querylen)) {
         free(query);
         return false;
     }
     free(query);
 
-    last_insert_id = (uint32)mysql_insert_id(&mysql);
+    last_insert_id = (uint32)mysql_insert_id(conn.mysql());
+
+    return true;
+}
+
+//prepared statement which returns a result
+bool DBcore::RunPrepared(DBQueryResult &into, const char *query, const DBParams &params) {
+    ConnectionLock conn(*this);
+
+    return DoPrepared_locked(*conn, into.error, query, params, true, &into) != NULL;
+}
+
+//prepared statement which returns no information except error status
+bool DBcore::RunPrepared(DBerror &err, const char *query, const DBParams &params) {
+    ConnectionLock conn(*this);
+
+    MYSQL_STMT *stmt = DoPrepared_locked(*conn, err, query, params);
+    if(stmt == NULL)
+        return false;
+
+    //drop whatever it returned so the connection is free for the next query
+    mysql_stmt_free_result(stmt);
+    return true;
+}
+
+//prepared statement which returns affected rows
+bool DBcore::RunPrepared(DBerror &err, uint32 &affected_rows, const char *query, const DBParams &params) {
+    ConnectionLock conn(*this);
+
+    MYSQL_STMT *stmt = DoPrepared_locked(*conn, err, query, params);
+    if(stmt == NULL)
+        return false;
+
+    affected_rows = (uint32)mysql_stmt_affected_rows(stmt);
+    mysql_stmt_free_result(stmt);
+    return true;
+}
+
+//queries in a single transaction
+bool DBcore::RunTransaction(DBerror &err, const std::vector<std::string> &queries) {
+    ConnectionLock conn(*this);
+
+    if(!DoQuery_locked(*conn, err, "START TRANSACTION", 17))
+        return false;
+
+    //no retries from now on, a reconnect would lose the transaction
+    for(size_t i = 0; i < queries.size(); ++i) {
+        if(!DoQuery_locked(*conn, err, queries[i].c_str(), (int32)queries[i].length(), false)) {
+            DBerror rollbackErr;
+            DoQuery_locked(*conn, rollbackErr, "ROLLBACK", 8, false);
+            return false;
+        }
+    }
+
+    return DoQuery_locked(*conn, err, "COMMIT", 6, false);
+}
+
+//queries in a single transaction, the last of which returns a result
+bool DBcore::RunTransaction(DBQueryResult &into, const std::vector<std::string> &queries) {
+    if(queries.empty()) {
+        into.error.SetError(0xFFFF, "DBcore::RunTransaction: No Query");
+        return false;
+    }
+
+    ConnectionLock conn(*this);
+
+    if(!DoQuery_locked(*conn, into.error, "START TRANSACTION", 17))
+        return false;
+
+    //no retries from now on, a reconnect would lose the transaction
+    MYSQL_RES *result = NULL;
+    uint32 col_count = 0;
+    for(size_t i = 0; i < queries.size(); ++i) {
+        const bool last = (i + 1 == queries.size());
+        bool success = DoQuery_locked(*conn, into.error, queries[i].c_str(), (int32)queries[i].length(), false, last ? &result : NULL);
+
+        if(success && last) {
+            col_count = mysql_field_count(conn.mysql());
+            if(col_count == 0) {
+                into.error.SetError(0xFFFF, "DBcore::RunTransaction: No Result");
+                sLog.Error("DBCore Query", "Query: %s failed because did not return a result", queries[i].c_str());
+                success = false;
+            }
+        }
+
+        if(!success) {
+            if(result != NULL)
+                mysql_free_result(result);
+
+            DBerror rollbackErr;
+            DoQuery_locked(*conn, rollbackErr, "ROLLBACK", 8, false);
+            return false;
+        }
+    }
+
+    if(!DoQuery_locked(*conn, into.error, "COMMIT", 6, false)) {
+        mysql_free_result(result);
+        return false;
+    }
 
+    //give them the result set.
+    into.SetResult(&result, col_count);
     return true;
 }
 
-bool DBcore::DoQuery_locked(DBerror &err, const char *query, int32 querylen, bool retry)
+MYSQL_STMT *DBcore::DoPrepared_locked(Connection& conn, DBerror &err, const char *query, const DBParams &params, bool retry, DBQueryResult *into)
+{
+    if (conn.status != Connected)
+        Open_locked(conn);
+
+    ProfileZone zone("Prepared", query);
+    const uint64 start = GetTimeUSeconds();
+
+    MYSQL_STMT *stmt = NULL;
+    int num = 0;
+
+    //find the statement or prepare it
+    std::map<std::string, MYSQL_STMT*>::iterator res = conn.statements.find(query);
+    if (res != conn.statements.end())
+        stmt = res->second;
+    else {
+        stmt = mysql_stmt_init(&conn.mysql);
+        if (stmt == NULL) {
+            err.SetError(mysql_errno(&conn.mysql), mysql_error(&conn.mysql));
+            sLog.Error("DBCore Query", "#%d preparing '%s': %s", err.GetErrNo(), query, err.c_str());
+            return NULL;
+        }
+
+        if (mysql_stmt_prepare(stmt, query, (unsigned long)strlen(query))) {
+            num = mysql_stmt_errno(stmt);
+            err.SetError(num, mysql_stmt_error(stmt));
+            mysql_stmt_close(stmt);
+
+            if (retry && (num == CR_SERVER_LOST || num == CR_SERVER_GONE_ERROR)) {
+                sLog.Error("DBCore", "Lost connection, attempting to recover....");
+                conn.status = Error;
+                return DoPrepared_locked(conn, err, query, params, false, into);
+            }
+
+            sLog.Error("DBCore Query", "#%d preparing '%s': %s", err.GetErrNo(), query, err.c_str());
+            return NULL;
+        }
+
+        conn.statements[query] = stmt;
+
+        MutexLock lock(mPoolMutex);
+        ++mStats.prepares;
+    }
+
+    if (mysql_stmt_param_count(stmt) != params.size()) {
+        err.SetError(0xFFFF, "DBcore::RunPrepared: Parameter count mismatch");
+        sLog.Error("DBCore Query", "'%s' takes %lu params, %lu given", query, (unsigned long)mysql_stmt_param_count(stmt), (unsigned long)params.size());
+        return NULL;
+    }
+
+    //bind the params; the statement does not keep them past execution
+    std::vector<MYSQL_BIND> binds(params.size());
+    if (!binds.empty())
+        memset(&binds[0], 0, binds.size() * sizeof(MYSQL_BIND));
+
+    for (size_t i = 0; i < params.size(); ++i) {
+        const DBParams::Param &p = params.mParams[i];
+        MYSQL_BIND &b = binds[i];
+
+        b.buffer_type = p.type;
+        b.is_unsigned = p.isUnsigned;
+
+        switch (p.type) {
+            case MYSQL_TYPE_LONGLONG:
+                b.buffer = const_cast<int64 *>(&p.i);
+                break;
+            case MYSQL_TYPE_DOUBLE:
+                b.buffer = const_cast<double *>(&p.d);
+                break;
+            case MYSQL_TYPE_STRING:
+            case MYSQL_TYPE_BLOB:
+                b.buffer = const_cast<char *>(p.s.data());
+                b.buffer_length = (unsigned long)p.s.length();
+                break;
+            default:
+                break;
+        }
+    }
+
+    if ((!binds.empty() && mysql_stmt_bind_param(stmt, &binds[0])) || mysql_stmt_execute(stmt)) {
+        num = mysql_stmt_errno(stmt);
+        err.SetError(num, mysql_stmt_error(stmt));
+
+        if (retry && (num == CR_SERVER_LOST || num == CR_SERVER_GONE_ERROR)) {
+            sLog.Error("DBCore", "Lost connection, attempting to recover....");
+            conn.status = Error;
+            return DoPrepared_locked(conn, err, query, params, false, into);
+        }
+
+        sLog.Error("DBCore Query", "#%d in '%s': %s", err.GetErrNo(), query, err.c_str());
+        return NULL;
+    }
+
+    //fetching the result is part of the query's time
+    uint64 rows = 0;
+    if (into != NULL) {
+        if (!into->SetResult(stmt)) {
+            sLog.Error("DBCore Query", "#%d in '%s': %s", into->error.GetErrNo(), query, into->error.c_str());
+            return NULL;
+        }
+        rows = into->GetRowCount();
+    } else if (mysql_stmt_field_count(stmt) == 0)
+        rows = mysql_stmt_affected_rows(stmt);
+
+    //the values of a prepared statement are not in its text
+    RecordQuery(conn, query, strlen(query), GetTimeUSeconds() - start, rows, false);
+
+    err.ClearError();
+    return stmt;
+}
+
+bool DBcore::DoQuery_locked(Connection& conn, DBerror &err, const char *query, int32 querylen, bool retry, MYSQL_RES **result)
 {
-    if (pStatus != Connected)
-        Open_locked();
+    if (conn.status != Connected)
+        Open_locked(conn);
+
+    if (result != NULL)
+        *result = NULL;
 
-    if (mysql_real_query(&mysql, query, querylen)) {
-        int num = mysql_errno(&mysql);
+    ProfileZone zone("Query", query, querylen);
+    const uint64 start = GetTimeUSeconds();
+
+    if (mysql_real_query(&conn.mysql, query, querylen)) {
+        int num = mysql_errno(&conn.mysql);
 
         if (num == CR_SERVER_GONE_ERROR)
-            pStatus = Error;
+            conn.status = Error;
 
         if (retry && (num == CR_SERVER_LOST || num == CR_SERVER_GONE_ERROR))
         {
             sLog.Error("DBCore", "Lost connection, attempting to recover....");
-            return DoQuery_locked(err, query, querylen, false);
+            return DoQuery_locked(conn, err, query, querylen, false, result);
         }
 
-        pStatus = Error;
-        err.SetError(num, mysql_error(&mysql));
+        conn.status = Error;
+        err.SetError(num, mysql_error(&conn.mysql));
         sLog.Error("DBCore Query", "#%d in '%s': %s", err.GetErrNo(), query, err.c_str());
+        QueryErrorMetric().Add();
         return false;
     }
 
+    //fetching the result is part of the query's time
+    uint64 rows = 0;
+    if (mysql_field_count(&conn.mysql) == 0)
+        rows = mysql_affected_rows(&conn.mysql);
+    else if (result != NULL) {
+        *result = mysql_store_result(&conn.mysql);
+        if (*result != NULL)
+            rows = mysql_num_rows(*result);
+    }
+
+    RecordQuery(conn, query, querylen, GetTimeUSeconds() - start, rows, true);
+
     err.ClearError();
     return true;
 }
@@ -182,10 +1169,10 @@ bool DBcore::RunQuery(const char* query, int32 querylen, char* errbuf, MYSQL_RES
         *errnum = 0;
     if (errbuf)
         errbuf[0] = 0;
-    MutexLock lock(MDatabase);
+    ConnectionLock conn(*this);
 
     DBerror err;
-    if(!DoQuery_locked(err, query, querylen, retry))
+    if(!DoQuery_locked(*conn, err, query, querylen, retry, result))
     {
         sLog.Error("DBCore Query", "Query: %s failed", query);
         if(errnum != NULL)
@@ -200,10 +1187,7 @@ bool DBcore::RunQuery(const char* query, int32 querylen, char* errbuf, MYSQL_RES
     }
 
     if (result) {
-        if(mysql_field_count(&mysql)) {
-            *result = mysql_store_result(&mysql);
-        } else {
-            *result = NULL;
+        if(mysql_field_count(conn.mysql()) == 0) {
             if (errnum)
                 *errnum = UINT_MAX;
 
@@ -217,22 +1201,27 @@ bool DBcore::RunQuery(const char* query, int32 querylen, char* errbuf, MYSQL_RES
         }
     }
     if (affected_rows)
-        *affected_rows = (uint32)mysql_affected_rows(&mysql);
+        *affected_rows = (uint32)mysql_affected_rows(conn.mysql());
     if (last_insert_id)
-        *last_insert_id = (uint32)mysql_insert_id(&mysql);
+        *last_insert_id = (uint32)mysql_insert_id(conn.mysql());
     return true;
 }
 
 int32 DBcore::DoEscapeString(char* tobuf, const char* frombuf, int32 fromlen)
 {
-    return mysql_real_escape_string(&mysql, tobuf, frombuf, fromlen);
+    // all connections use the same character set
+    ConnectionLock conn(*this);
+
+    return mysql_real_escape_string(conn.mysql(), tobuf, frombuf, fromlen);
 }
 
 void DBcore::DoEscapeString(std::string &to, const std::string &from)
 {
+    ConnectionLock conn(*this);
+
     uint32 len = (uint32)from.length();
     to.resize(len*2 + 1);   // make enough room
-    uint32 esc_len = mysql_real_escape_string(&mysql, &to[0], from.c_str(), len);
+    uint32 esc_len = mysql_real_escape_string(conn.mysql(), &to[0], from.c_str(), len);
     to.resize(esc_len+1); // optional.
 }
 
@@ -249,34 +1238,34 @@ bool DBcore::IsSafeString(const char *str) {
 }
 
 bool DBcore::Open(const char* iHost, const char* iUser, const char* iPassword, const char* iDatabase, int16 iPort, int32* errnum, char* errbuf, bool iCompress, bool iSSL) {
-    MutexLock lock(MDatabase);
+    {
+        MutexLock lock(mPoolMutex);
+
+        pHost = iHost;
+        pUser = iUser;
+        pPassword = iPassword;
+        pDatabase = iDatabase;
+        pCompress = iCompress;
+        pPort = iPort;
+        pSSL = iSSL;
+    }
 
-    pHost = iHost;
-    pUser = iUser;
-    pPassword = iPassword;
-    pDatabase = iDatabase;
-    pCompress = iCompress;
-    pPort = iPort;
-    pSSL = iSSL;
+    // open the first connection right away to report errors
+    ConnectionLock conn(*this);
+    if (!Open_locked(*conn, errnum, errbuf)) {
+        pStatus = Error;
+        return false;
+    }
 
-    return Open_locked(errnum, errbuf);
+    pStatus = Connected;
+    return true;
 }
 
 bool DBcore::Open(DBerror &err, const char* iHost, const char* iUser, const char* iPassword, const char* iDatabase, int16 iPort, bool iCompress, bool iSSL) {
-    MutexLock lock(MDatabase);
-
-    pHost = iHost;
-    pUser = iUser;
-    pPassword = iPassword;
-    pDatabase = iDatabase;
-    pCompress = iCompress;
-    pPort = iPort;
-    pSSL = iSSL;
-
     int32 errnum;
     char errbuf[1024];
 
-    if(!Open_locked(&errnum, errbuf)) {
+    if(!Open(iHost, iUser, iPassword, iDatabase, iPort, &errnum, errbuf, iCompress, iSSL)) {
         err.SetError(errnum, errbuf);
         return false;
     }
@@ -285,17 +1274,29 @@ bool DBcore::Open(DBerror &err, const char* iHost, const char* iUser, const char
 }
 
 
-bool DBcore::Open_locked(int32* errnum, char* errbuf) {
+bool DBcore::Open_locked(Connection& conn, int32* errnum, char* errbuf) {
     if (errbuf)
         errbuf[0] = 0;
-    if (GetStatus() == Connected)
+    if (conn.status == Connected)
         return true;
-    if (GetStatus() == Error)
-        mysql_close(&mysql);    //do we need to call init again?
+    if (conn.status == Error) {
+        conn.CloseStatements();
+        mysql_close(&conn.mysql);
+        mysql_init(&conn.mysql);
+    }
     if (pHost.empty())
         return false;
 
-    sLog.Log("dbcore", "Connecting to\n\tDB:\t%s\n\tserver:\t%s:%d\n\tuser:\t%s", pDatabase.c_str(), pHost.c_str(), pPort, pUser.c_str());
+    //replicas have the account and database of the primary
+    const std::string& host = (conn.replica != NULL ? conn.replica->host : pHost);
+    const int16 port = (conn.replica != NULL ? conn.replica->port : pPort);
+
+    if (conn.opened) {
+        MutexLock lock(mPoolMutex);
+        ++mStats.reconnects;
+    }
+    else
+        sLog.Log("dbcore", "Connecting to\n\tDB:\t%s\n\tserver:\t%s:%d\n\tuser:\t%s", pDatabase.c_str(), host.c_str(), port, pUser.c_str());
 
     /*
     Quagmire - added CLIENT_FOUND_ROWS flag to the connect
@@ -307,30 +1308,80 @@ bool DBcore::Open_locked(int32* errnum, char* errbuf) {
         flags |= CLIENT_COMPRESS;
     if (pSSL)
         flags |= CLIENT_SSL;
-    if (mysql_real_connect(&mysql, pHost.c_str(), pUser.c_str(), pPassword.c_str(), pDatabase.c_str(), pPort, 0, flags)) {
-        pStatus = Connected;
+    if (mysql_real_connect(&conn.mysql, host.c_str(), pUser.c_str(), pPassword.c_str(), pDatabase.c_str(), port, 0, flags)) {
+        conn.status = Connected;
+        conn.opened = true;
     } else {
-        pStatus = Error;
+        conn.status = Error;
         if (errnum)
-            *errnum = mysql_errno(&mysql);
+            *errnum = mysql_errno(&conn.mysql);
         if (errbuf)
-            snprintf(errbuf, MYSQL_ERRMSG_SIZE, "#%i: %s", mysql_errno(&mysql), mysql_error(&mysql));
+            snprintf(errbuf, MYSQL_ERRMSG_SIZE, "#%i: %s", mysql_errno(&conn.mysql), mysql_error(&conn.mysql));
         return false;
     }
 
     // Setup character set we wish to use
-    if(mysql_set_character_set(&mysql, "utf8") != 0) {
-        pStatus = Error;
+    if(mysql_set_character_set(&conn.mysql, "utf8") != 0) {
+        conn.status = Error;
         if(errnum)
-            *errnum = mysql_errno(&mysql);
+            *errnum = mysql_errno(&conn.mysql);
         if(errbuf)
-            snprintf(errbuf, MYSQL_ERRMSG_SIZE, "#%i: %s", mysql_errno(&mysql), mysql_error(&mysql));
+            snprintf(errbuf, MYSQL_ERRMSG_SIZE, "#%i: %s", mysql_errno(&conn.mysql), mysql_error(&conn.mysql));
         return false;
     }
 
     return true;
 }
 
+/************************************************************************/
+/* DBcore::Connection                                                   */
+/************************************************************************/
+DBcore::Connection::Connection()
+: status(Closed),
+  opened(false),
+  waitTime(0),
+  replica(NULL)
+{
+    mysql_init(&mysql);
+}
+
+DBcore::Connection::~Connection()
+{
+    CloseStatements();
+    mysql_close(&mysql);
+}
+
+void DBcore::Connection::CloseStatements()
+{
+    std::map<std::string, MYSQL_STMT*>::iterator cur, end;
+    cur = statements.begin();
+    end = statements.end();
+    for(; cur != end; ++cur)
+        mysql_stmt_close(cur->second);
+
+    statements.clear();
+}
+
+/************************************************************************/
+/* DBcore::Replica                                                      */
+/************************************************************************/
+DBcore::Replica::Replica(const char* _host, int16 _port)
+: host(_host),
+  port(_port),
+  fresh(false),
+  checked(false)
+{
+}
+
+DBcore::Replica::~Replica()
+{
+    std::vector<Connection*>::iterator cur, end;
+    cur = connections.begin();
+    end = connections.end();
+    for(; cur != end; ++cur)
+        SafeDelete( *cur );
+}
+
 /************************************************************************/
 /* DBerror                                                              */
 /************************************************************************/
@@ -419,10 +1470,99 @@ const DBTYPE DBQueryResult::MYSQL_DBTYPE_TABLE_UNSIGNED[] =
     DBTYPE_ERROR,   //[26]MYSQL_TYPE_GEOMETRY=255       /* Spatial field */
 };
 
+/*************************************************************************/
+/* DBParams                                                              */
+/*************************************************************************/
+DBParams& DBParams::Add( double value )
+{
+    mParams.push_back( Param() );
+    Param& p = mParams.back();
+
+    p.type = MYSQL_TYPE_DOUBLE;
+    p.isUnsigned = false;
+    p.d = value;
+
+    return *this;
+}
+
+DBParams& DBParams::Add( const char* value )
+{
+    if( NULL == value )
+        return AddNull();
+
+    mParams.push_back( Param() );
+    Param& p = mParams.back();
+
+    p.type = MYSQL_TYPE_STRING;
+    p.isUnsigned = false;
+    p.i = 0;
+    p.s = value;
+
+    return *this;
+}
+
+DBParams& DBParams::Add( const std::string& value )
+{
+    mParams.push_back( Param() );
+    Param& p = mParams.back();
+
+    p.type = MYSQL_TYPE_STRING;
+    p.isUnsigned = false;
+    p.i = 0;
+    p.s = value;
+
+    return *this;
+}
+
+DBParams& DBParams::AddBinary( const void* data, size_t length )
+{
+    mParams.push_back( Param() );
+    Param& p = mParams.back();
+
+    p.type = MYSQL_TYPE_BLOB;
+    p.isUnsigned = false;
+    p.i = 0;
+    p.s.assign( (const char*)data, length );
+
+    return *this;
+}
+
+DBParams& DBParams::AddNull()
+{
+    mParams.push_back( Param() );
+    Param& p = mParams.back();
+
+    p.type = MYSQL_TYPE_NULL;
+    p.isUnsigned = false;
+    p.i = 0;
+
+    return *this;
+}
+
+DBParams& DBParams::_AddInt( int64 value, bool isUnsigned )
+{
+    mParams.push_back( Param() );
+    Param& p = mParams.back();
+
+    p.type = MYSQL_TYPE_LONGLONG;
+    p.isUnsigned = isUnsigned;
+    p.i = value;
+
+    return *this;
+}
+
+/*************************************************************************/
+/* DBQueryResult                                                         */
+/*************************************************************************/
 DBQueryResult::DBQueryResult()
 : mColumnCount( 0 ),
   mResult( NULL ),
-  mFields( NULL )
+  mFields( NULL ),
+  mBinary( false ),
+  mRowCount( 0 ),
+  mNextRow( 0 ),
+  mStreamed( false ),
+  mStreamMysql( NULL )
 {
 }
 
@@ -430,18 +1570,45 @@ DBQueryResult::~DBQueryResult()
 {
     SafeDeleteArray( mFields );
 
+    // reads the rest of a streamed result
     if( NULL != mResult )
         mysql_free_result( mResult );
+
+    _EndStream( false );
 }
 
 bool DBQueryResult::GetRow( DBResultRow& into )
 {
+    if( mBinary )
+    {
+        if( mNextRow >= mRowCount )
+            return false;
+
+        into.SetData( this, &mCells[ mNextRow++ * ColumnCount() ] );
+        return true;
+    }
+
     if( NULL == mResult )
         return false;
 
     MYSQL_ROW row = mysql_fetch_row( mResult );
     if( NULL == row )
+    {
+        if( NULL != mStreamMysql )
+        {
+            // the end of the stream, or a failure on its way
+            const bool failed = ( 0 != mysql_errno( mStreamMysql ) );
+            if( failed )
+            {
+                error.SetError( mysql_errno( mStreamMysql ), mysql_error( mStreamMysql ) );
+                sLog.Error( "DBCore Query Result", "Streamed result failed: %s", error.c_str() );
+            }
+
+            _EndStream( failed );
+        }
+
         return false;
+    }
 
     const unsigned long* lengths = mysql_fetch_lengths( mResult );
     if( NULL == lengths )
@@ -453,7 +1620,11 @@ bool DBQueryResult::GetRow( DBResultRow& into )
 
 void DBQueryResult::Reset()
 {
-    if( NULL != mResult )
+    if( mBinary )
+        mNextRow = 0;
+    else if( mStreamed )
+        sLog.Error( "DBCore Query Result", "Reset: Streamed result cannot be rewound" );
+    else if( NULL != mResult )
         mysql_data_seek( mResult, 0);
 }
 
@@ -519,9 +1690,19 @@ void DBQueryResult::SetResult( MYSQL_RES** res, uint32 colCount )
     if( NULL != mResult )
         mysql_free_result( mResult );
 
-    mResult = *res;
-    *res = NULL;
+    _EndStream( false );
+
+    mResult = ( NULL == res ? NULL : *res );
+    if( NULL != res )
+        *res = NULL;
     mColumnCount = colCount;
+    mStreamed = false;
+
+    mBinary = false;
+    mCells.clear();
+    mData.clear();
+    mRowCount = 0;
+    mNextRow = 0;
 
     if( NULL != mResult )
     {
@@ -533,13 +1714,186 @@ void DBQueryResult::SetResult( MYSQL_RES** res, uint32 colCount )
     }
 }
 
+void DBQueryResult::SetStream( MYSQL_RES** res, uint32 colCount, MYSQL* mysql )
+{
+    SetResult( res, colCount );
+
+    mStreamed = true;
+    mStreamMysql = mysql;
+}
+
+void DBQueryResult::_EndStream( bool failed )
+{
+    if( NULL == mStreamMysql )
+        return;
+
+    MYSQL* mysql = mStreamMysql;
+    mStreamMysql = NULL;
+
+    DBcore::get().EndStream( mysql, failed );
+}
+
+bool DBQueryResult::SetResult( MYSQL_STMT* stmt )
+{
+    MYSQL_RES* meta = mysql_stmt_result_metadata( stmt );
+    if( NULL == meta )
+    {
+        error.SetError( 0xFFFF, "DBcore::RunPrepared: No Result" );
+        return false;
+    }
+
+    // let the buffers of texts be allocated up front
+    my_bool updateMaxLength = 1;
+    mysql_stmt_attr_set( stmt, STMT_ATTR_UPDATE_MAX_LENGTH, &updateMaxLength );
+
+    if( mysql_stmt_store_result( stmt ) )
+    {
+        error.SetError( mysql_stmt_errno( stmt ), mysql_stmt_error( stmt ) );
+        mysql_free_result( meta );
+        return false;
+    }
+
+    // keep the metadata for the column info
+    const uint32 cols = mysql_num_fields( meta );
+    SetResult( &meta, cols );
+    mBinary = true;
+
+    mRowCount = (size_t)mysql_stmt_num_rows( stmt );
+    mCells.resize( mRowCount * cols );
+    mText.resize( cols );
+
+    // bind a slot for every column
+    std::vector<MYSQL_BIND> binds( cols );
+    std::vector<Cell> slots( cols );
+    std::vector<my_bool> nulls( cols );
+    std::vector<unsigned long> lengths( cols );
+    std::vector< std::vector<char> > texts( cols );
+    if( 0 < cols )
+        memset( &binds[ 0 ], 0, cols * sizeof( MYSQL_BIND ) );
+
+    for( uint32 i = 0; i < cols; ++i )
+    {
+        MYSQL_BIND& b = binds[ i ];
+        Cell& slot = slots[ i ];
+
+        b.is_null = &nulls[ i ];
+        b.length = &lengths[ i ];
+
+        switch( mFields[ i ]->type )
+        {
+            case MYSQL_TYPE_TINY:
+            case MYSQL_TYPE_SHORT:
+            case MYSQL_TYPE_INT24:
+            case MYSQL_TYPE_LONG:
+            case MYSQL_TYPE_LONGLONG:
+            case MYSQL_TYPE_YEAR:
+                slot.kind = ( IsUnsigned( i ) ? Cell::UInt : Cell::Int );
+                b.buffer_type = MYSQL_TYPE_LONGLONG;
+                b.buffer = &slot.i;
+                b.is_unsigned = IsUnsigned( i );
+                break;
+
+            case MYSQL_TYPE_FLOAT:
+            case MYSQL_TYPE_DOUBLE:
+                slot.kind = Cell::Real;
+                b.buffer_type = MYSQL_TYPE_DOUBLE;
+                b.buffer = &slot.d;
+                break;
+
+            default:
+                // decimals, dates and strings come as text
+                slot.kind = Cell::Text;
+                texts[ i ].resize( mFields[ i ]->max_length + 1 );
+                b.buffer_type = MYSQL_TYPE_STRING;
+                b.buffer = &texts[ i ][ 0 ];
+                b.buffer_length = (unsigned long)texts[ i ].size();
+                break;
+        }
+    }
+
+    if( 0 < cols && mysql_stmt_bind_result( stmt, &binds[ 0 ] ) )
+    {
+        error.SetError( mysql_stmt_errno( stmt ), mysql_stmt_error( stmt ) );
+        mysql_stmt_free_result( stmt );
+        return false;
+    }
+
+    size_t row = 0;
+    for(; row < mRowCount; ++row )
+    {
+        const int res = mysql_stmt_fetch( stmt );
+        if( 0 != res && MYSQL_DATA_TRUNCATED != res )
+            break;
+
+        Cell* cells = &mCells[ row * cols ];
+        for( uint32 i = 0; i < cols; ++i )
+        {
+            Cell& cell = cells[ i ];
+
+            cell = slots[ i ];
+            cell.null = ( 0 != nulls[ i ] );
+            cell.offset = 0;
+            cell.length = 0;
+
+            if( Cell::Text == cell.kind && !cell.null )
+            {
+                cell.offset = (uint32)mData.size();
+                cell.length = (uint32)lengths[ i ];
+                mData.insert( mData.end(), texts[ i ].begin(), texts[ i ].begin() + cell.length );
+                mData.push_back( '\0' );
+            }
+        }
+    }
+    mRowCount = row;
+
+    mysql_stmt_free_result( stmt );
+
+    error.ClearError();
+    return true;
+}
+
+const char* DBQueryResult::_FormatCell( uint32 index, const Cell& cell )
+{
+    char buf[ 32 ];
+
+    switch( cell.kind )
+    {
+        case Cell::Int:
+            snprintf( buf, sizeof( buf ), "%" PRId64, cell.i );
+            break;
+        case Cell::UInt:
+            snprintf( buf, sizeof( buf ), "%" PRIu64, (uint64)cell.i );
+            break;
+        default:
+            // as many digits as the text protocol sends
+            snprintf( buf, sizeof( buf ), "%.17g", cell.d );
+            break;
+    }
+
+    mText[ index ] = buf;
+    return mText[ index ].c_str();
+}
+
 DBResultRow::DBResultRow()
 : mRow( NULL ),
   mLengths( NULL ),
+  mCells( NULL ),
   mResult( NULL )
 {
 }
 
+const char* DBResultRow::_GetCellText( uint32 index ) const
+{
+    const DBQueryResult::Cell& cell = mCells[ index ];
+
+    if( cell.null )
+        return NULL;
+    if( DBQueryResult::Cell::Text == cell.kind )
+        return &mResult->mData[ cell.offset ];
+
+    return mResult->_FormatCell( index, cell );
+}
+
 uint32 DBResultRow::ColumnLength( uint32 index ) const
 {
 #ifdef COLUMN_BOUNDS_CHECKING
@@ -549,6 +1903,9 @@ uint32 DBResultRow::ColumnLength( uint32 index ) const
         return 0;       //nothing better to do...
     }
 #endif
+    if( NULL != mCells )
+        return ( DBQueryResult::Cell::Text == mCells[ index ].kind ? mCells[ index ].length : (uint32)strlen( GetText( index ) ) );
+
     return mLengths[ index ];
 }
 
@@ -561,6 +1918,9 @@ int32 DBResultRow::GetInt( uint32 index ) const
         return 0;       //nothing better to do...
     }
 #endif
+    if( NULL != mCells )
+        return (int32)_GetCellInt64( index );
+
     //use base 0 on the obscure chance that this is a string column with an 0x hex number in it.
     return strtol( GetText( index ), NULL, 0 );
 }
@@ -574,6 +1934,9 @@ bool DBResultRow::GetBool( uint32 index ) const
         return 0;       //nothing better to do...
     }
 #endif
+    if( NULL != mCells && DBQueryResult::Cell::Text != mCells[ index ].kind )
+        return 0 != _GetCellInt64( index );
+
     return GetText(index)[0] == 1;
 }
 
@@ -586,6 +1949,9 @@ uint32 DBResultRow::GetUInt( uint32 index ) const
         return 0;       //nothing better to do...
     }
 #endif
+    if( NULL != mCells )
+        return (uint32)_GetCellUInt64( index );
+
     //use base 0 on the obscure chance that this is a string column with an 0x hex number in it.
     return strtoul( GetText( index ), NULL, 0 );
 }
@@ -603,6 +1969,9 @@ int64 DBResultRow::GetInt64( uint32 index ) const
     //sscanf( GetText( index ), "%" SCNd64, &value );
     //return value;
 
+    if( NULL != mCells )
+        return _GetCellInt64( index );
+
     //use base 0 on the obscure chance that this is a string column with an 0x hex number in it.
     return strtoll( GetText( index ), NULL, 0 );
 }
@@ -617,6 +1986,9 @@ uint64 DBResultRow::GetUInt64( uint32 index ) const
     }
 #endif
 
+    if( NULL != mCells )
+        return _GetCellUInt64( index );
+
     //use base 0 on the obscure chance that this is a string column with an 0x hex number in it.
     return strtoull( GetText( index ), NULL, 0 );
 }
@@ -630,6 +2002,9 @@ float DBResultRow::GetFloat( uint32 index ) const
         return 0;       //nothing better to do...
     }
 #endif
+    if( NULL != mCells )
+        return (float)_GetCellDouble( index );
+
     return strtof( GetText( index ), NULL );
 }
 
@@ -642,6 +2017,9 @@ double DBResultRow::GetDouble( uint32 index ) const
         return 0;       //nothing better to do...
     }
 #endif
+    if( NULL != mCells )
+        return _GetCellDouble( index );
+
     return strtod( GetText( index ), NULL );
 }
 
@@ -650,5 +2028,60 @@ void DBResultRow::SetData( DBQueryResult* res, MYSQL_ROW& row, const unsigned lo
     mRow = row;
     mResult = res;
     mLengths = lengths;
+    mCells = NULL;
+}
+
+void DBResultRow::SetData( DBQueryResult* res, const DBQueryResult::Cell* cells )
+{
+    mRow = NULL;
+    mResult = res;
+    mLengths = NULL;
+    mCells = cells;
+}
+
+int64 DBResultRow::_GetCellInt64( uint32 index ) const
+{
+    const DBQueryResult::Cell& cell = mCells[ index ];
+    if( cell.null )
+        return 0;
+
+    switch( cell.kind )
+    {
+        case DBQueryResult::Cell::Int:
+        case DBQueryResult::Cell::UInt:
+            return cell.i;
+        case DBQueryResult::Cell::Real:
+            return (int64)cell.d;
+        default:
+            return strtoll( &mResult->mData[ cell.offset ], NULL, 0 );
+    }
+}
+
+uint64 DBResultRow::_GetCellUInt64( uint32 index ) const
+{
+    const DBQueryResult::Cell& cell = mCells[ index ];
+    if( !cell.null && DBQueryResult::Cell::Text == cell.kind )
+        return strtoull( &mResult->mData[ cell.offset ], NULL, 0 );
+
+    return (uint64)_GetCellInt64( index );
+}
+
+double DBResultRow::_GetCellDouble( uint32 index ) const
+{
+    const DBQueryResult::Cell& cell = mCells[ index ];
+    if( cell.null )
+        return 0.0;
+
+    switch( cell.kind )
+    {
+        case DBQueryResult::Cell::Int:
+            return (double)cell.i;
+        case DBQueryResult::Cell::UInt:
+            return (double)(uint64)cell.i;
+        case DBQueryResult::Cell::Real:
+            return cell.d;
+        default:
+            return strtod( &mResult->mData[ cell.offset ], NULL );
+    }
 }
 
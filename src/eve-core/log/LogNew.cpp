@@ -29,9 +29,21 @@
 #include "log/logtypes.h"
 #include "log/logsys.h"
 
+/// The logfile of logsys, written by the writer thread in the asynchronous mode.
+extern FILE* logsys_log_file;
+
 /*************************************************************************/
 /* NewLog                                                                */
 /*************************************************************************/
+/// Maximal number of records the writer thread writes before flushing.
+static const size_t WRITE_BATCH_SIZE = 256;
+/// Time (in milliseconds) the writer thread waits for more records.
+static const uint32 WRITER_INTERVAL = 50;
+/// Minimal time (in seconds) between two reports of dropped records.
+static const time_t DROP_REPORT_INTERVAL = 10;
+/// Names of the drop counters of the messages of NewLog.
+static const char* const LEVEL_NAMES[] = { "Log", "Error", "Warning", "Success", "Debug" };
+
 #ifdef WIN32
 const WORD NewLog::COLOR_TABLE[ COLOR_COUNT ] =
 {
@@ -62,7 +74,12 @@ const char* const NewLog::COLOR_TABLE[ COLOR_COUNT ] =
 
 NewLog::NewLog()
 : mLogfile( NULL ),
-  mTime( 0 )
+  mTime( 0 ),
+  mAsync( false ),
+  mWriterRunning( false ),
+  mQueue( NULL ),
+  mReportTime( 0 ),
+  mTimeTextSecond( -1 )
 #ifdef WIN32
   ,mStdOutHandle( GetStdHandle( STD_OUTPUT_HANDLE ) ),
   mStdErrHandle( GetStdHandle( STD_ERROR_HANDLE ) )
@@ -74,10 +91,20 @@ NewLog::NewLog()
 
     //Debug( "Log", "Log system initiated" );
     m_initialized = false;
+
+    for( uint32 i = 0; i < DROP_CATEGORY_COUNT; ++i )
+    {
+        mDropped[ i ] = 0;
+        mReportedDrops[ i ] = 0;
+    }
+    mTimeText[ 0 ] = '\0';
 }
 
 NewLog::~NewLog()
 {
+    StopAsync();
+    SafeDelete( mQueue );
+
     Debug( "Log", "Log system shutting down" );
 
     // close logfile
@@ -179,11 +206,109 @@ bool NewLog::SetLogfile( FILE* file )
     return true;
 }
 
+bool NewLog::StartAsync( uint32 queueSize )
+{
+    if( mAsync )
+        return true;
+
+    // kept until destruction, so late callers never see it go away
+    if( NULL == mQueue )
+        mQueue = new LockFreeQueue< Record* >( queueSize );
+
+    mWriterRunning = true;
+
+#ifdef WIN32
+    mWriter = CreateThread( NULL, 0, WriterLoop, this, 0, NULL );
+    if( NULL == mWriter )
+#else /* !WIN32 */
+    if( 0 != pthread_create( &mWriter, NULL, WriterLoop, this ) )
+#endif /* !WIN32 */
+    {
+        mWriterRunning = false;
+
+        Error( "Log", "Failed to start the writer thread, logging synchronously." );
+        return false;
+    }
+
+    mAsync = true;
+
+    Log( "Log", "Writer thread started, up to %u records queued.", mQueue->GetCapacity() );
+    return true;
+}
+
+void NewLog::StopAsync()
+{
+    if( !mAsync )
+        return;
+
+    mAsync = false;
+    mWriterRunning = false;
+    mWake.Signal();
+
+#ifdef WIN32
+    WaitForSingleObject( mWriter, INFINITE );
+    CloseHandle( mWriter );
+#else /* !WIN32 */
+    pthread_join( mWriter, NULL );
+#endif /* !WIN32 */
+
+    // records queued while the writer was stopping
+    while( 0 < WriteBatch() );
+    ReportDrops();
+}
+
+bool NewLog::QueueLogsys( LogType type, const char* text, size_t length )
+{
+    if( !mAsync )
+        return false;
+
+    Record* record = NewRecord( COLOR_DEFAULT, 0, NULL, text, length );
+    if( NULL != record )
+        Queue( record, LEVEL_COUNT + log_type_info[ type ].category );
+
+    return true;
+}
+
 void NewLog::PrintMsg( Color color, char pfx, const char* source, const char* fmt, va_list ap )
 {
     if( !m_initialized )
         return;
 
+    if( mAsync )
+    {
+        // format on the stack unless the message is long
+        char buf[ 0x400 ];
+        char* text = buf;
+
+        va_list ap2;
+        va_copy( ap2, ap );
+        int length = vsnprintf( buf, sizeof( buf ), fmt, ap2 );
+        va_end( ap2 );
+
+        if( 0 <= length && sizeof( buf ) <= (size_t)length )
+            length = vasprintf( &text, fmt, ap );
+        if( 0 > length )
+            return;
+
+        uint32 level;
+        switch( pfx )
+        {
+            case 'E': level = 1; break;
+            case 'W': level = 2; break;
+            case 'S': level = 3; break;
+            case 'D': level = 4; break;
+            default:  level = 0; break;
+        }
+
+        Record* record = NewRecord( color, pfx, source, text, length );
+        if( NULL != record )
+            Queue( record, level );
+
+        if( buf != text )
+            free( text );
+        return;
+    }
+
     MutexLock l( mMutex );
 
     PrintTime();
@@ -287,3 +412,194 @@ void NewLog::SetLogfileDefault(std::string logPath)
     else
         Warning( "Log", "Unable to open logfile '%s': %s", filename, strerror( errno ) );
 }
+
+NewLog::Record* NewLog::NewRecord( Color color, char pfx, const char* source, const char* text, size_t length )
+{
+    const size_t sourceLength = ( NULL != source ? std::min< size_t >( strlen( source ), 0xFFFF ) : 0 );
+
+    Record* record = (Record*)malloc( sizeof( Record ) + sourceLength + length );
+    if( NULL == record )
+        return NULL;
+
+    record->time = time( NULL );
+    record->color = color;
+    record->pfx = pfx;
+    record->sourceLength = (uint16)sourceLength;
+    record->length = (uint32)( sourceLength + length );
+
+    memcpy( record->text, source, sourceLength );
+    memcpy( &record->text[ sourceLength ], text, length );
+
+    return record;
+}
+
+void NewLog::Queue( Record* record, uint32 category )
+{
+    if( !mQueue->Push( record ) )
+    {
+        free( record );
+
+        AtomicAdd( &mAsyncStats.dropped, 1 );
+        AtomicAdd( &mDropped[ category ], 1 );
+
+        mWake.Signal();
+        return;
+    }
+
+    AtomicAdd( &mAsyncStats.queued, 1 );
+
+    // the writer wakes up by itself unless the queue fills up
+    if( mQueue->GetCapacity() / 4 <= mQueue->GetSize() )
+        mWake.Signal();
+}
+
+void NewLog::WriterRun()
+{
+    while( true )
+    {
+        const size_t count = WriteBatch();
+
+        if( mReportTime + DROP_REPORT_INTERVAL <= time( NULL ) )
+            ReportDrops();
+
+        if( WRITE_BATCH_SIZE <= count )
+            continue;
+
+        // the queue has been drained
+        if( !mWriterRunning )
+            break;
+
+        mWake.Wait( WRITER_INTERVAL );
+    }
+}
+
+size_t NewLog::WriteBatch()
+{
+    MutexLock l( mMutex );
+
+    size_t count = 0;
+    Record* record;
+    while( WRITE_BATCH_SIZE > count && mQueue->Pop( record ) )
+    {
+        WriteRecord( record );
+        free( record );
+
+        ++count;
+    }
+
+    if( 0 < count )
+    {
+        fflush( stdout );
+        if( NULL != mLogfile )
+            fflush( mLogfile );
+        if( NULL != logsys_log_file )
+            fflush( logsys_log_file );
+
+        AtomicAdd( &mAsyncStats.written, (uint32)count );
+        AtomicAdd( &mAsyncStats.batches, 1 );
+    }
+
+    return count;
+}
+
+void NewLog::WriteRecord( const Record* record )
+{
+    // the records come in order, so the time changes once a second at most
+    if( mTimeTextSecond != record->time )
+    {
+        tm t;
+        localtime_r( &record->time, &t );
+
+        snprintf( mTimeText, sizeof( mTimeText ), "%02u:%02u:%02u", t.tm_hour, t.tm_min, t.tm_sec );
+        mTimeTextSecond = record->time;
+    }
+
+    if( 0 == record->pfx )
+    {
+        // a line of logsys
+        printf( "%s %.*s\n", mTimeText, (int)record->length, record->text );
+
+        if( NULL != logsys_log_file )
+            fprintf( logsys_log_file, "%s %.*s\n", mTimeText, (int)record->length, record->text );
+        return;
+    }
+
+    const Color color = (Color)record->color;
+
+    Print( "%s", mTimeText );
+
+    SetColor( color );
+    Print( " %c ", record->pfx );
+
+    if( 0 < record->sourceLength )
+    {
+        SetColor( COLOR_WHITE );
+        Print( "%.*s: ", (int)record->sourceLength, record->text );
+
+        SetColor( color );
+    }
+
+    Print( "%.*s\n", (int)( record->length - record->sourceLength ), &record->text[ record->sourceLength ] );
+
+    SetColor( COLOR_DEFAULT );
+}
+
+void NewLog::ReportDrops()
+{
+    mReportTime = time( NULL );
+
+    std::string counts;
+    uint32 total = 0;
+
+    for( uint32 i = 0; i < DROP_CATEGORY_COUNT; ++i )
+    {
+        const uint32 dropped = AtomicLoad( &mDropped[ i ] );
+        const uint32 count = dropped - mReportedDrops[ i ];
+        if( 0 == count )
+            continue;
+
+        mReportedDrops[ i ] = dropped;
+        total += count;
+
+        char buf[ 64 ];
+        snprintf( buf, sizeof( buf ), "%s%s %u",
+                  ( counts.empty() ? "" : ", " ),
+                  ( LEVEL_COUNT > i ? LEVEL_NAMES[ i ] : log_category_names[ i - LEVEL_COUNT ] ),
+                  count );
+        counts += buf;
+    }
+
+    if( 0 == total )
+        return;
+
+    char buf[ 0x400 ];
+    const int length = snprintf( buf, sizeof( buf ), "Dropped %u records, the queue was full (%s).", total, counts.c_str() );
+
+    // written right away; queued it could be dropped as well
+    Record* record = NewRecord( COLOR_YELLOW, 'W', "Log", buf, std::min< size_t >( length, sizeof( buf ) - 1 ) );
+    if( NULL != record )
+    {
+        MutexLock l( mMutex );
+
+        WriteRecord( record );
+        free( record );
+    }
+}
+
+#ifdef WIN32
+DWORD WINAPI NewLog::WriterLoop( LPVOID arg )
+#else /* !WIN32 */
+void* NewLog::WriterLoop( void* arg )
+#endif /* !WIN32 */
+{
+    NewLog* log = reinterpret_cast< NewLog* >( arg );
+    assert( log != NULL );
+
+    log->WriterRun();
+
+#ifdef WIN32
+    return 0;
+#else /* !WIN32 */
+    return NULL;
+#endif /* !WIN32 */
+}
@@ -25,6 +25,7 @@
 
 #include "eve-core.h"
 
+#include "log/LogNew.h"
 #include "log/logsys.h"
 #include "utils/utils_hex.h"
 
@@ -80,6 +81,28 @@ void log_messageVA(LogType type, const char *fmt, va_list args) {
 
 extern void log_messageVA( LogType type, uint32 iden, const char *fmt, va_list args )
 {
+    if( sLog.IsAsync() )
+    {
+        /* the writer thread adds the time */
+        char line[ 0x1000 ];
+        int length = snprintf( line, sizeof( line ), "[%s] %*s", log_type_info[type].display_name, (int)iden, "" );
+        if( 0 > length )
+            return;
+
+        const int va_size = vsnprintf( &line[length], sizeof( line ) - length, fmt, args );
+        if( 0 < va_size )
+            length = std::min<int>( length + va_size, sizeof( line ) - 1 );
+
+        if( sLog.QueueLogsys( type, line, length ) )
+            return;
+
+        /* the writer stopped meanwhile */
+        fprintf(stdout, "%s\n", line);
+        if(logsys_log_file != NULL)
+            fprintf(logsys_log_file, "%s\n", line);
+        return;
+    }
+
     /* allocate enough room for a large message */
     size_t log_msg_size = 0x1000;
     size_t log_msg_index = 0;
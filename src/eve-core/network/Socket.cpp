@@ -27,6 +27,17 @@
 
 #include "network/Socket.h"
 
+void Socket::SetChunk( Chunk& chunk, const void* buf, unsigned int len )
+{
+#ifdef WIN32
+    chunk.buf = (CHAR*)buf;
+    chunk.len = len;
+#else
+    chunk.iov_base = (void*)buf;
+    chunk.iov_len = len;
+#endif /* !WIN32 */
+}
+
 Socket::Socket( int af, int type, int protocol )
 : mSock( INVALID_SOCKET )
 {
@@ -80,6 +91,25 @@ unsigned int Socket::send( const void* buf, unsigned int len, int flags )
     return ::send( mSock, (const char*)buf, len, flags );
 }
 
+unsigned int Socket::sendv( const Chunk* chunks, unsigned int count, int flags )
+{
+#ifdef WIN32
+    DWORD sent = 0;
+    if( 0 != ::WSASend( mSock, const_cast< LPWSABUF >( chunks ), count, &sent, flags, NULL, NULL ) )
+        return SOCKET_ERROR;
+
+    return sent;
+#else
+    msghdr msg;
+    ::memset( &msg, 0, sizeof( msg ) );
+
+    msg.msg_iov = const_cast< iovec* >( chunks );
+    msg.msg_iovlen = count;
+
+    return ::sendmsg( mSock, &msg, flags );
+#endif /* !WIN32 */
+}
+
 unsigned int Socket::sendto( const void* buf, unsigned int len, int flags, const sockaddr* to, unsigned int tolen )
 {
     return ::sendto( mSock, (const char*)buf, len, flags, to, tolen );
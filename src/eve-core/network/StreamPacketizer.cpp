@@ -27,38 +27,139 @@
 
 #include "network/StreamPacketizer.h"
 
+const uint32 STREAMPACKETIZER_INPUT_SIZE = 0x4000;
+const uint32 STREAMPACKETIZER_DIRECT_SIZE = 0x1000;
+
+StreamPacketizer::StreamPacketizer( uint32 packetSizeLimit )
+: mPacketSizeLimit( packetSizeLimit ),
+  mBuffer( STREAMPACKETIZER_INPUT_SIZE ),
+  mInputStart( 0 ),
+  mInputEnd( 0 ),
+  mPacket( NULL ),
+  mPacketSize( 0 ),
+  mPacketFill( 0 )
+{
+}
+
 StreamPacketizer::~StreamPacketizer()
 {
     ClearBuffers();
 }
 
-void StreamPacketizer::InputData( const Buffer& data )
+bool StreamPacketizer::InputData( const Buffer& data )
 {
-    mBuffer.AppendSeq( data.begin<uint8>(), data.end<uint8>() );
+    Buffer::const_iterator<uint8> cur, end;
+    cur = data.begin<uint8>();
+    end = data.end<uint8>();
+    while( cur != end )
+    {
+        size_t len;
+        uint8* span = GetInputSpan( len );
+
+        if( len > (size_t)( end - cur ) )
+            len = ( end - cur );
+
+        memcpy( span, &*cur, len );
+        CommitInput( len );
+        cur += len;
+
+        if( !Process() )
+            return false;
+    }
+
+    return true;
 }
 
-void StreamPacketizer::Process()
+uint8* StreamPacketizer::GetInputSpan( size_t& len )
 {
-    Buffer::const_iterator<uint8> cur, end;
-    cur = mBuffer.begin<uint8>();
-    end = mBuffer.end<uint8>();
-    while( true )
+    if( NULL != mPacket )
     {
-        if( sizeof( uint32 ) > ( end - cur ) )
-            break;
+        // grow the packet as its data arrive
+        if( mPacketFill == mPacket->size() )
+            mPacket->Resize<uint8>( std::min( 2 * mPacket->size(), mPacketSize ) );
 
-        const Buffer::const_iterator<uint32> len = cur.As<uint32>();
-        const Buffer::const_iterator<uint8> start = ( len + 1 ).As<uint8>();
+        len = mPacket->size() - mPacketFill;
+        return &(*mPacket)[ mPacketFill ];
+    }
 
-        if( *len > (uint32)( end - start ) )
-            break;
+    if( mBuffer.size() - mInputEnd < STREAMPACKETIZER_DIRECT_SIZE && 0 < mInputStart )
+    {
+        // move the partial packet to front
+        memmove( &mBuffer[ 0 ], &mBuffer[ mInputStart ], mInputEnd - mInputStart );
 
-        mPackets.push( new Buffer( start, start + *len ) );
-        cur = ( start + *len );
+        mInputEnd -= mInputStart;
+        mInputStart = 0;
     }
 
-    if( cur != mBuffer.begin<uint8>() )
-        mBuffer.AssignSeq( cur, end );
+    len = mBuffer.size() - mInputEnd;
+    return &mBuffer[ 0 ] + mInputEnd;
+}
+
+void StreamPacketizer::CommitInput( size_t len )
+{
+    if( NULL != mPacket )
+    {
+        assert( mPacketFill + len <= mPacket->size() );
+        mPacketFill += len;
+    }
+    else
+    {
+        assert( mInputEnd + len <= mBuffer.size() );
+        mInputEnd += len;
+    }
+}
+
+bool StreamPacketizer::Process()
+{
+    if( NULL != mPacket )
+    {
+        if( mPacketFill < mPacketSize )
+            return true;
+
+        mPackets.push( mPacket );
+        mPacket = NULL;
+        mPacketSize = mPacketFill = 0;
+    }
+
+    while( sizeof( uint32 ) <= mInputEnd - mInputStart )
+    {
+        uint32 len;
+        memcpy( &len, &mBuffer[ mInputStart ], sizeof( uint32 ) );
+
+        if( 0 < mPacketSizeLimit && mPacketSizeLimit < len )
+            return false;
+
+        const size_t start = mInputStart + sizeof( uint32 );
+        const size_t avail = mInputEnd - start;
+
+        if( len <= avail )
+        {
+            mPackets.push( new Buffer( mBuffer.begin<uint8>() + start,
+                                       mBuffer.begin<uint8>() + ( start + len ) ) );
+            mInputStart = start + len;
+        }
+        else
+        {
+            if( STREAMPACKETIZER_DIRECT_SIZE < len )
+            {
+                // receive the rest straight into the packet's own buffer,
+                // starting with no more than the input buffer would hold
+                mPacket = new Buffer( std::min<size_t>( len, STREAMPACKETIZER_INPUT_SIZE ) );
+                mPacketSize = len;
+                memcpy( &(*mPacket)[ 0 ], &mBuffer[ start ], avail );
+                mPacketFill = avail;
+
+                mInputStart = mInputEnd;
+            }
+
+            break;
+        }
+    }
+
+    if( mInputStart == mInputEnd )
+        mInputStart = mInputEnd = 0;
+
+    return true;
 }
 
 Buffer* StreamPacketizer::PopPacket()
@@ -78,10 +179,9 @@ void StreamPacketizer::ClearBuffers()
     Buffer* buf;
     while( ( buf = PopPacket() ) )
         SafeDelete( buf );
-}
-
-
-
-
 
+    SafeDelete( mPacket );
+    mPacketSize = mPacketFill = 0;
 
+    mInputStart = mInputEnd = 0;
+}
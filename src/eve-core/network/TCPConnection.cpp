@@ -29,22 +29,71 @@
 #include "log/LogNew.h"
 #include "network/TCPConnection.h"
 #include "network/NetUtils.h"
+#include "threading/Atomic.h"
+#include "utils/Metrics.h"
 #include "utils/timer.h"
 
 const uint32 TCPCONN_RECVBUF_SIZE = 0x1000;
-const uint32 TCPCONN_LOOP_GRANULARITY = 5;
+const uint32 TCPCONN_SENDV_MAX = 64;
+const uint32 TCPCONN_SENDQUEUE_SIZE = 0x1000;
 
 #ifdef WIN32
 static InitWinsock winsock;
 #endif
 
+/** Maximal number of bytes waiting in a send queue; 0 for no limit. */
+static volatile uint32 sSendQueueLimit = 0;
+/** Number of connections dropped for a full send queue. */
+static volatile uint32 sDroppedSlowReaders = 0;
+
+/** @return Counter of the bytes sent. */
+static MetricCounter& SentBytesMetric()
+{
+    static MetricCounter& metric = sMetrics.Counter( "evemu_net_sent_bytes_total", "Number of bytes sent to the connections." );
+    return metric;
+}
+/** @return Counter of the bytes received. */
+static MetricCounter& ReceivedBytesMetric()
+{
+    static MetricCounter& metric = sMetrics.Counter( "evemu_net_received_bytes_total", "Number of bytes received from the connections." );
+    return metric;
+}
+/** @return Counter of the send syscalls. */
+static MetricCounter& SendCallsMetric()
+{
+    static MetricCounter& metric = sMetrics.Counter( "evemu_net_send_calls_total", "Number of send calls which sent anything." );
+    return metric;
+}
+/** @return Counter of the connections dropped for a full send queue. */
+static MetricCounter& DroppedSlowReadersMetric()
+{
+    static MetricCounter& metric = sMetrics.Counter( "evemu_net_dropped_slow_readers_total", "Number of connections dropped for a full send queue." );
+    return metric;
+}
+
+void TCPConnection::SetSendQueueLimit( uint32 bytes )
+{
+    AtomicStore( &sSendQueueLimit, bytes );
+}
+
+uint32 TCPConnection::GetDroppedSlowReaders()
+{
+    return AtomicLoad( &sDroppedSlowReaders );
+}
+
 TCPConnection::TCPConnection()
 : mSock( NULL ),
   mSockState( STATE_DISCONNECTED ),
   mrIP( 0 ),
   mrPort( 0 ),
+  mNotifyEvent( NULL ),
+  mSendQueue( TCPCONN_SENDQUEUE_SIZE ),
+  mSendOffset( 0 ),
+  mSendQueueBytes( 0 ),
+  mDropping( false ),
   mRecvBuf( NULL )
 {
+    ::memset( &mSendStats, 0, sizeof( mSendStats ) );
 }
 
 TCPConnection::TCPConnection( Socket* socket, uint32 mrIP, uint16 mrPort )
@@ -52,10 +101,17 @@ TCPConnection::TCPConnection( Socket* socket, uint32 mrIP, uint16 mrPort )
   mSockState( STATE_CONNECTED ),
   mrIP( mrIP ),
   mrPort( mrPort ),
+  mNotifyEvent( NULL ),
+  mSendQueue( TCPCONN_SENDQUEUE_SIZE ),
+  mSendOffset( 0 ),
+  mSendQueueBytes( 0 ),
+  mDropping( false ),
   mRecvBuf( NULL )
 {
-    // Start worker thread
-    StartLoop();
+    ::memset( &mSendStats, 0, sizeof( mSendStats ) );
+
+    // The reactor starts processing us once we are fully
+    // constructed, see TCPServer::AddConnection().
 }
 
 TCPConnection::~TCPConnection()
@@ -70,6 +126,16 @@ TCPConnection::~TCPConnection()
     ClearBuffers();
 }
 
+TCPConnection::SendStats TCPConnection::GetSendStats() const
+{
+    // Counters are only written by the I/O thread, a slightly stale copy is fine
+    SendStats stats = mSendStats;
+    stats.queueDepth = mSendQueue.GetSize();
+    stats.queueBytes = AtomicLoad( &mSendQueueBytes );
+
+    return stats;
+}
+
 std::string TCPConnection::GetAddress()
 {
     /* "The Matrix is a system, 'Neo'. That system is our enemy. But when you're inside, you look around, what do you see?" */
@@ -190,6 +256,25 @@ void TCPConnection::Disconnect()
 
     // Change state
     mSockState = STATE_DISCONNECTING;
+
+    // Let the I/O thread flush and close the socket
+    sTCPReactor.Wake( this );
+}
+
+void TCPConnection::Drop()
+{
+    MutexLock lock( mMSock );
+
+    state_t state = GetState();
+    if( state != STATE_CONNECTING && state != STATE_CONNECTED && state != STATE_DISCONNECTING )
+        return;
+
+    // Change state
+    mSockState = STATE_DISCONNECTING;
+    mDropping = true;
+
+    // Let the I/O thread close the socket
+    sTCPReactor.Wake( this );
 }
 
 bool TCPConnection::Send( Buffer** data )
@@ -198,9 +283,8 @@ bool TCPConnection::Send( Buffer** data )
     Buffer* buf = *data;
     *data = NULL;
 
-    // Check we are in STATE_CONNECTED
-    MutexLock sockLock( mMSock );
-
+    // Check we are in STATE_CONNECTED; no need to lock, if we race with
+    // a disconnect the buffer is released along with the connection
     state_t state = GetState();
     if( state != STATE_CONNECTED )
     {
@@ -209,35 +293,46 @@ bool TCPConnection::Send( Buffer** data )
         return false;
     }
 
+    // Account the buffer before the I/O thread may consume it
+    const uint32 size = buf->size();
+    const uint32 bytes = AtomicAdd( &mSendQueueBytes, size );
+    const uint32 limit = AtomicLoad( &sSendQueueLimit );
+
     // Push buffer to the send queue
-    MutexLock queueLock( mMSendQueue );
+    if( ( 0 < limit && limit < bytes ) || !mSendQueue.Push( buf ) )
+    {
+        // The peer does not keep up; flushing would take as long, so drop it
+        sLog.Error( "TCPConnection", "%s: Send queue full (%u bytes), dropping connection.", GetAddress().c_str(), bytes );
+        AtomicAdd( &mSendQueueBytes, -size );
+        SafeDelete( buf );
 
-    mSendQueue.push_back( buf );
+        AtomicAdd( &sDroppedSlowReaders, 1 );
+        DroppedSlowReadersMetric().Add();
+
+        Drop();
+        return false;
+    }
     buf = NULL;
 
+    // Have the I/O thread push it out
+    sTCPReactor.Wake( this );
+
     return true;
 }
 
 void TCPConnection::StartLoop()
 {
-    // Spawn new thread
-#ifdef WIN32
-    CreateThread( NULL, 0, TCPConnectionLoop, this, 0, NULL );
-#else
-    pthread_t thread;
-    pthread_create( &thread, NULL, TCPConnectionLoop, this );
-#endif
+    // Hand the connection over to the reactor
+    sTCPReactor.Register( this );
 }
 
 void TCPConnection::WaitLoop()
 {
-    // Block calling thread until work thread terminates
-    mMLoopRunning.Lock();
-    mMLoopRunning.Unlock();
+    // Block calling thread until the reactor detaches us
+    WaitReactorDetach();
 }
 
-/* This is always called from an IO thread. Either the server socket's thread, or a
- * special thread we create when we make an outbound connection. */
+/* This is always called from a reactor I/O thread. */
 bool TCPConnection::Process()
 {
     char errbuf[ TCPCONN_ERRBUF_SIZE ];
@@ -293,6 +388,13 @@ bool TCPConnection::Process()
 
         case STATE_DISCONNECTING:
         {
+            // Dropped connections do not flush
+            if( mDropping )
+            {
+                DoDisconnect();
+                return true;
+            }
+
             // Send anything that may be pending
             if( !SendData( errbuf ) )
             {
@@ -302,6 +404,10 @@ bool TCPConnection::Process()
                 return false;
             }
 
+            // Wait for the socket to become writable if anything is left
+            if( !mSendQueue.IsEmpty() )
+                return true;
+
             // Send queue is empty, disconnect
             DoDisconnect();
             return true;
@@ -320,14 +426,36 @@ bool TCPConnection::SendData( char* errbuf )
     if( state != STATE_CONNECTED && state != STATE_DISCONNECTING )
         return false;
 
-    mMSendQueue.Lock();
-    while( !mSendQueue.empty() )
+    // Only we take buffers off the queue, so it peaks right before we drain it
+    const size_t depth = mSendQueue.GetSize();
+    if( mSendStats.maxQueueDepth < depth )
+        mSendStats.maxQueueDepth = depth;
+
+    Socket::Chunk chunks[ TCPCONN_SENDV_MAX ];
+    while( true )
     {
-        Buffer* buf = mSendQueue.front();
-        mSendQueue.pop_front();
-        mMSendQueue.Unlock();
+        // Gather as much of the queue as we can; we are its only consumer
+        unsigned int count = 0;
+        size_t total = 0;
+        Buffer* buf;
+        for( uint32 i = 0; count < TCPCONN_SENDV_MAX && mSendQueue.Peek( i, buf ); ++i )
+        {
+            const size_t offset = ( 0 == i ? mSendOffset : 0 );
+            if( buf->size() <= offset )
+                continue;
 
-        int status = mSock->send( &(*buf)[ 0 ], buf->size(), MSG_NOSIGNAL );
+            Socket::SetChunk( chunks[ count++ ], &(*buf)[ offset ], buf->size() - offset );
+            total += buf->size() - offset;
+        }
+
+        if( 0 == count )
+        {
+            // Drop any empty buffers left in the queue
+            ConsumeSendQueue( 0 );
+            break;
+        }
+
+        int status = mSock->sendv( chunks, count, MSG_NOSIGNAL );
 
         if( status == SOCKET_ERROR )
         {
@@ -337,8 +465,8 @@ bool TCPConnection::SendData( char* errbuf )
             if( errno == EWOULDBLOCK )
 #endif /* !WIN32 */
             {
-                // Act like nothing was sent
-                status = 0;
+                // Socket is full; the reactor calls us again once it is writable
+                return true;
             }
             else
             {
@@ -349,39 +477,58 @@ bool TCPConnection::SendData( char* errbuf )
                     snprintf( errbuf, TCPCONN_ERRBUF_SIZE, "TCPConnection::SendData(): send(): Errorcode: %s", strerror( errno ) );
 #endif
 
-                SafeDelete( buf );
                 return false;
             }
         }
 
-        if( (size_t)status > buf->size() )
+        if( (size_t)status > total )
         {
             if( errbuf )
                 snprintf( errbuf, TCPCONN_ERRBUF_SIZE, "TCPConnection::SendData(): WTF! status > size." );
 
-            SafeDelete( buf );
             return false;
         }
-        else if( (size_t)status < buf->size() )
-        {
-            if( status > 0 )
-                buf->AssignSeq( buf->begin<uint8>() + status, buf->end<uint8>() );
 
-            MutexLock queueLock( mMSendQueue );
+        ConsumeSendQueue( status );
 
-            mSendQueue.push_front( buf );
-            buf = NULL;
-        }
-        else
+        // Socket is full; the reactor calls us again once it is writable
+        if( (size_t)status < total )
+            return true;
+    }
+
+    return true;
+}
+
+void TCPConnection::ConsumeSendQueue( size_t len )
+{
+    if( 0 < len )
+    {
+        ++mSendStats.syscalls;
+        mSendStats.bytes += len;
+
+        SendCallsMetric().Add();
+        SentBytesMetric().Add( len );
+    }
+
+    Buffer* buf;
+    while( mSendQueue.Peek( 0, buf ) )
+    {
+        const size_t left = buf->size() - mSendOffset;
+        if( len < left )
         {
-            SafeDelete( buf );
+            // Remember how far we got instead of moving the data
+            mSendOffset += len;
+            break;
         }
 
-        mMSendQueue.Lock();
-    }
-    mMSendQueue.Unlock();
+        len -= left;
+        mSendOffset = 0;
 
-    return true;
+        mSendQueue.Pop( buf );
+        AtomicAdd( &mSendQueueBytes, -(uint32)buf->size() );
+        SentBuffer( buf );
+        SafeDelete( buf );
+    }
 }
 
 bool TCPConnection::RecvData( char* errbuf )
@@ -397,18 +544,16 @@ bool TCPConnection::RecvData( char* errbuf )
 
     while( true )
     {
-        if( mRecvBuf == NULL )
-            mRecvBuf = new Buffer( TCPCONN_RECVBUF_SIZE );
-        else if( mRecvBuf->size() < TCPCONN_RECVBUF_SIZE )
-            mRecvBuf->Resize<uint8>( TCPCONN_RECVBUF_SIZE );
+        size_t len;
+        uint8* span = GetRecvSpan( len );
 
-        int status = mSock->recv( &(*mRecvBuf)[ 0 ], mRecvBuf->size(), 0 );
+        int status = mSock->recv( span, len, 0 );
 
         if( status > 0 )
         {
-            mRecvBuf->Resize<uint8>( status );
+            ReceivedBytesMetric().Add( status );
 
-            if( !ProcessReceivedData( errbuf ) )
+            if( !ProcessReceivedData( status, errbuf ) )
                 return false;
         }
         else if( status == 0 )
@@ -442,6 +587,15 @@ bool TCPConnection::RecvData( char* errbuf )
     }
 }
 
+uint8* TCPConnection::GetRecvSpan( size_t& len )
+{
+    if( mRecvBuf == NULL )
+        mRecvBuf = new Buffer( TCPCONN_RECVBUF_SIZE );
+
+    len = mRecvBuf->size();
+    return &(*mRecvBuf)[ 0 ];
+}
+
 void TCPConnection::DoDisconnect()
 {
     MutexLock lock( mMSock );
@@ -455,73 +609,43 @@ void TCPConnection::DoDisconnect()
     ClearBuffers();
 
     mSockState = STATE_DISCONNECTED;
+    mDropping = false;
 }
 
 void TCPConnection::ClearBuffers()
 {
-    MutexLock lock( mMSendQueue );
-
-    while( !mSendQueue.empty() )
+    Buffer* buf;
+    while( mSendQueue.Pop( buf ) )
     {
-        Buffer* buf = mSendQueue.front();
-        mSendQueue.pop_front();
-
+        AtomicAdd( &mSendQueueBytes, -(uint32)buf->size() );
         SafeDelete( buf );
     }
+    mSendOffset = 0;
 
     SafeDelete( mRecvBuf );
 }
 
-#ifdef WIN32
-DWORD WINAPI TCPConnection::TCPConnectionLoop( LPVOID arg )
-#else /* !WIN32 */
-void* TCPConnection::TCPConnectionLoop( void* arg )
-#endif /* !WIN32 */
+SOCKET TCPConnection::GetReactorSocket() const
 {
-    TCPConnection* tcpc = reinterpret_cast< TCPConnection* >( arg );
-    assert( tcpc != NULL );
-
-    tcpc->TCPConnectionLoop();
+    MutexLock lock( mMSock );
 
-#ifdef WIN32
-    return 0;
-#else /* !WIN32 */
-    return NULL;
-#endif /* !WIN32 */
+    return ( NULL != mSock ? mSock->fd() : INVALID_SOCKET );
 }
 
-void TCPConnection::TCPConnectionLoop()
+bool TCPConnection::ReactorProcess()
 {
-#ifdef WIN32
-    SetThreadPriority( GetCurrentThread(), THREAD_PRIORITY_ABOVE_NORMAL );
-#endif
-
-#ifndef WIN32
-    sLog.Log( "Threading", "Starting TCPConnectionLoop with thread ID %d", pthread_self() );
-#endif
-
-    mMLoopRunning.Lock();
-
-    uint32 start = GetTickCount();
-    uint32 etime;
-    uint32 last_time;
-
-    while( Process() )
-    {
-        /* UPDATE */
-        last_time = GetTickCount();
-        etime = last_time - start;
-
-        // do the stuff for thread sleeping
-        if( TCPCONN_LOOP_GRANULARITY > etime )
-            Sleep( TCPCONN_LOOP_GRANULARITY - etime );
-
-        start = GetTickCount();
-    }
+    return Process();
+}
 
-    mMLoopRunning.Unlock();
+void TCPConnection::Notify()
+{
+    Event* event = mNotifyEvent;
+    if( NULL != event )
+        event->Signal();
+}
 
-#ifndef WIN32
-    sLog.Log( "Threading", "Ending TCPConnectionLoop with thread ID %d", pthread_self() );
-#endif
+void TCPConnection::ReactorDetach()
+{
+    // Let the owner notice we are gone
+    Notify();
 }
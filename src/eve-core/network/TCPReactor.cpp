@@ -0,0 +1,607 @@
+/*
+    ------------------------------------------------------------------------------------
+    LICENSE:
+    ------------------------------------------------------------------------------------
+    This file is part of EVEmu: EVE Online Server Emulator
+    Copyright 2006 - 2011 The EVEmu Team
+    For the latest information visit http://evemu.org
+    ------------------------------------------------------------------------------------
+    This program is free software; you can redistribute it and/or modify it under
+    the terms of the GNU Lesser General Public License as published by the Free Software
+    Foundation; either version 2 of the License, or (at your option) any later
+    version.
+
+    This program is distributed in the hope that it will be useful, but WITHOUT
+    ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+    FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public License along with
+    this program; if not, write to the Free Software Foundation, Inc., 59 Temple
+    Place - Suite 330, Boston, MA 02111-1307, USA, or go to
+    http://www.gnu.org/copyleft/lesser.txt.
+    ------------------------------------------------------------------------------------
+    Author:     EVEmu Team
+*/
+
+#include "eve-core.h"
+
+#include "log/LogNew.h"
+#include "network/TCPReactor.h"
+
+#ifdef HAVE_SYS_EPOLL_H
+#   include <sys/epoll.h>
+#endif /* HAVE_SYS_EPOLL_H */
+
+const uint32 TCPREACTOR_DEFAULT_THREADS = 2;
+const uint32 TCPREACTOR_SWEEP_INTERVAL = 1000;
+const uint32 TCPREACTOR_POLL_GRANULARITY = 5;
+
+/** Maximal number of events fetched by single epoll_wait(). */
+static const int TCPREACTOR_MAX_EVENTS = 64;
+
+#ifdef HAVE_SYS_EPOLL_H
+/** Time (in milliseconds) between sweeps of this backend. */
+static const uint32 TCPREACTOR_BACKEND_SWEEP = TCPREACTOR_SWEEP_INTERVAL;
+#else /* !HAVE_SYS_EPOLL_H */
+/** Without writability/wakeup events, sweeps drive pending sends too. */
+static const uint32 TCPREACTOR_BACKEND_SWEEP = TCPREACTOR_POLL_GRANULARITY;
+#endif /* !HAVE_SYS_EPOLL_H */
+
+/*************************************************************************/
+/* TCPReactor::Worker                                                    */
+/*************************************************************************/
+/**
+ * @brief Single I/O thread of TCPReactor.
+ *
+ * @author EVEmu Team
+ */
+class TCPReactor::Worker
+{
+public:
+    Worker();
+    ~Worker();
+
+    /** @return Number of handlers pinned to this worker. */
+    size_t GetLoad() const { return mLoad; }
+
+    bool Start();
+    void Stop();
+
+    void Attach( Handler* handler );
+    void Wake( Handler* handler );
+
+protected:
+    /// Maps attached handlers to the socket we watch for them.
+    typedef std::map<Handler*, SOCKET> HandlerMap;
+
+    void Run();
+    void Dispatch( Handler* handler );
+    void Detach( HandlerMap::iterator itr );
+
+    void Watch( Handler* handler, SOCKET sock );
+    void Unwatch( SOCKET sock );
+
+    void Notify();
+    void WaitEvents( std::vector<Handler*>& ready );
+
+#ifdef WIN32
+    static DWORD WINAPI WorkerLoop( LPVOID arg );
+#else /* !WIN32 */
+    static void* WorkerLoop( void* arg );
+#endif /* !WIN32 */
+
+    /// Protects the queues below.
+    Mutex mMQueue;
+    /// Handlers waiting to be attached.
+    std::vector<Handler*> mAttachQueue;
+    /// Handlers woken up since the last iteration.
+    std::set<Handler*> mWakeQueue;
+    /// Set if the thread has been notified already.
+    bool mNotified;
+
+    /// Attached handlers; touched by the worker thread only.
+    HandlerMap mHandlers;
+    /// Number of handlers pinned to us (including pending ones).
+    volatile size_t mLoad;
+    /// Time of the last sweep over all handlers.
+    uint32 mLastSweep;
+
+    /// Cleared when the worker should stop.
+    volatile bool mRunning;
+#ifdef WIN32
+    HANDLE mThread;
+#else /* !WIN32 */
+    pthread_t mThread;
+#endif /* !WIN32 */
+    bool mThreadValid;
+
+#ifdef HAVE_SYS_EPOLL_H
+    /// The epoll instance.
+    int mEpoll;
+    /// Pipe used to interrupt epoll_wait().
+    int mWakePipe[2];
+#endif /* HAVE_SYS_EPOLL_H */
+};
+
+TCPReactor::Worker::Worker()
+: mNotified( false ),
+  mLoad( 0 ),
+  mLastSweep( 0 ),
+  mRunning( false ),
+  mThreadValid( false )
+{
+#ifdef HAVE_SYS_EPOLL_H
+    mEpoll = -1;
+    mWakePipe[0] = mWakePipe[1] = -1;
+#endif /* HAVE_SYS_EPOLL_H */
+}
+
+TCPReactor::Worker::~Worker()
+{
+    Stop();
+
+#ifdef HAVE_SYS_EPOLL_H
+    if( -1 != mEpoll )
+        ::close( mEpoll );
+    if( -1 != mWakePipe[0] )
+        ::close( mWakePipe[0] );
+    if( -1 != mWakePipe[1] )
+        ::close( mWakePipe[1] );
+#endif /* HAVE_SYS_EPOLL_H */
+}
+
+bool TCPReactor::Worker::Start()
+{
+#ifdef HAVE_SYS_EPOLL_H
+    mEpoll = ::epoll_create( TCPREACTOR_MAX_EVENTS );
+    if( -1 == mEpoll )
+    {
+        sLog.Error( "TCPReactor", "epoll_create() failed: %s.", strerror( errno ) );
+        return false;
+    }
+
+    if( -1 == ::pipe( mWakePipe ) )
+    {
+        sLog.Error( "TCPReactor", "pipe() failed: %s.", strerror( errno ) );
+        return false;
+    }
+    ::fcntl( mWakePipe[0], F_SETFL, O_NONBLOCK );
+    ::fcntl( mWakePipe[1], F_SETFL, O_NONBLOCK );
+
+    // NULL data pointer marks the wakeup pipe
+    epoll_event ev;
+    ev.events = EPOLLIN;
+    ev.data.ptr = NULL;
+    ::epoll_ctl( mEpoll, EPOLL_CTL_ADD, mWakePipe[0], &ev );
+#endif /* HAVE_SYS_EPOLL_H */
+
+    mRunning = true;
+    mLastSweep = GetTickCount();
+
+#ifdef WIN32
+    mThread = CreateThread( NULL, 0, WorkerLoop, this, 0, NULL );
+    mThreadValid = ( NULL != mThread );
+#else /* !WIN32 */
+    mThreadValid = ( 0 == pthread_create( &mThread, NULL, WorkerLoop, this ) );
+#endif /* !WIN32 */
+
+    return mThreadValid;
+}
+
+void TCPReactor::Worker::Stop()
+{
+    if( !mThreadValid )
+        return;
+
+    mRunning = false;
+    Notify();
+
+#ifdef WIN32
+    WaitForSingleObject( mThread, INFINITE );
+    CloseHandle( mThread );
+#else /* !WIN32 */
+    pthread_join( mThread, NULL );
+#endif /* !WIN32 */
+
+    mThreadValid = false;
+}
+
+void TCPReactor::Worker::Attach( Handler* handler )
+{
+    // mark it attached right away, so that the owner waits
+    // for us even if we have not picked it up yet
+    {
+        MutexLock lock( handler->mMReactorAttached );
+
+        handler->mReactorAttached = true;
+    }
+
+    handler->mReactorWorker = this;
+
+    {
+        MutexLock lock( mMQueue );
+
+        mAttachQueue.push_back( handler );
+        ++mLoad;
+    }
+
+    Notify();
+}
+
+void TCPReactor::Worker::Wake( Handler* handler )
+{
+    {
+        MutexLock lock( mMQueue );
+
+        mWakeQueue.insert( handler );
+    }
+
+    Notify();
+}
+
+void TCPReactor::Worker::Run()
+{
+    std::vector<Handler*> ready;
+
+    while( mRunning )
+    {
+        ready.clear();
+        WaitEvents( ready );
+
+        std::vector<Handler*> attach;
+        {
+            MutexLock lock( mMQueue );
+
+            attach.swap( mAttachQueue );
+
+            ready.insert( ready.end(), mWakeQueue.begin(), mWakeQueue.end() );
+            mWakeQueue.clear();
+
+            mNotified = false;
+        }
+
+        std::vector<Handler*>::iterator cur, end;
+        cur = attach.begin();
+        end = attach.end();
+        for(; cur != end; ++cur )
+        {
+            mHandlers.insert( std::make_pair( *cur, INVALID_SOCKET ) );
+            (*cur)->ReactorAttach();
+
+            ready.push_back( *cur );
+        }
+
+        // periodic sweep lets handlers check their timeouts
+        const uint32 now = GetTickCount();
+        if( TCPREACTOR_BACKEND_SWEEP <= now - mLastSweep )
+        {
+            HandlerMap::iterator hcur, hend;
+            hcur = mHandlers.begin();
+            hend = mHandlers.end();
+            for(; hcur != hend; ++hcur )
+                ready.push_back( hcur->first );
+
+            mLastSweep = now;
+        }
+
+        // process every handler only once per iteration
+        std::sort( ready.begin(), ready.end() );
+        ready.erase( std::unique( ready.begin(), ready.end() ), ready.end() );
+
+        cur = ready.begin();
+        end = ready.end();
+        for(; cur != end; ++cur )
+            Dispatch( *cur );
+    }
+
+    // reactor is stopping, let go of everybody
+    {
+        MutexLock lock( mMQueue );
+
+        std::vector<Handler*>::iterator cur, end;
+        cur = mAttachQueue.begin();
+        end = mAttachQueue.end();
+        for(; cur != end; ++cur )
+            mHandlers.insert( std::make_pair( *cur, INVALID_SOCKET ) );
+
+        mAttachQueue.clear();
+    }
+
+    while( !mHandlers.empty() )
+        Detach( mHandlers.begin() );
+}
+
+void TCPReactor::Worker::Dispatch( Handler* handler )
+{
+    // the handler may have been detached in the meantime
+    HandlerMap::iterator itr = mHandlers.find( handler );
+    if( mHandlers.end() == itr )
+        return;
+
+    if( !handler->ReactorProcess() )
+    {
+        Detach( itr );
+        return;
+    }
+
+    // the socket may have changed (eg. async connect finished)
+    const SOCKET sock = handler->GetReactorSocket();
+    if( sock != itr->second )
+    {
+        Unwatch( itr->second );
+        itr->second = sock;
+        Watch( handler, sock );
+    }
+
+    // no socket means no events; keep the handler going ourselves
+    if( INVALID_SOCKET == sock )
+        Wake( handler );
+}
+
+void TCPReactor::Worker::Detach( HandlerMap::iterator itr )
+{
+    Handler* handler = itr->first;
+
+    Unwatch( itr->second );
+    mHandlers.erase( itr );
+
+    {
+        MutexLock lock( mMQueue );
+
+        mWakeQueue.erase( handler );
+        --mLoad;
+    }
+
+    handler->mReactorWorker = NULL;
+    handler->ReactorDetach();
+
+    // the owner may free the handler as soon as we release it
+    MutexLock lock( handler->mMReactorAttached );
+
+    handler->mReactorAttached = false;
+    handler->mReactorDetached.Signal();
+}
+
+void TCPReactor::Worker::Watch( Handler* handler, SOCKET sock )
+{
+    if( INVALID_SOCKET == sock )
+        return;
+
+#ifdef HAVE_SYS_EPOLL_H
+    // Edge-triggered: handlers always drain the socket until it would block.
+    epoll_event ev;
+    ev.events = EPOLLIN | EPOLLOUT | EPOLLET;
+    ev.data.ptr = handler;
+
+    if( -1 == ::epoll_ctl( mEpoll, EPOLL_CTL_ADD, sock, &ev ) )
+        sLog.Error( "TCPReactor", "epoll_ctl() failed: %s.", strerror( errno ) );
+#endif /* HAVE_SYS_EPOLL_H */
+}
+
+void TCPReactor::Worker::Unwatch( SOCKET sock )
+{
+    if( INVALID_SOCKET == sock )
+        return;
+
+#ifdef HAVE_SYS_EPOLL_H
+    // Fails harmlessly if the socket has been closed already.
+    epoll_event ev;
+    ::epoll_ctl( mEpoll, EPOLL_CTL_DEL, sock, &ev );
+#endif /* HAVE_SYS_EPOLL_H */
+}
+
+void TCPReactor::Worker::Notify()
+{
+    {
+        MutexLock lock( mMQueue );
+
+        if( mNotified )
+            return;
+        mNotified = true;
+    }
+
+#ifdef HAVE_SYS_EPOLL_H
+    const char c = 0;
+    ::write( mWakePipe[1], &c, sizeof( c ) );
+#endif /* HAVE_SYS_EPOLL_H */
+}
+
+void TCPReactor::Worker::WaitEvents( std::vector<Handler*>& ready )
+{
+    const uint32 elapsed = GetTickCount() - mLastSweep;
+    const uint32 timeout = ( TCPREACTOR_BACKEND_SWEEP > elapsed ? TCPREACTOR_BACKEND_SWEEP - elapsed : 0 );
+
+#ifdef HAVE_SYS_EPOLL_H
+    epoll_event events[ TCPREACTOR_MAX_EVENTS ];
+
+    const int count = ::epoll_wait( mEpoll, events, TCPREACTOR_MAX_EVENTS, timeout );
+    for( int i = 0; i < count; ++i )
+    {
+        Handler* handler = static_cast<Handler*>( events[i].data.ptr );
+
+        if( NULL != handler )
+            ready.push_back( handler );
+        else
+        {
+            // drain the wakeup pipe
+            char buf[ 64 ];
+            while( 0 < ::read( mWakePipe[0], buf, sizeof( buf ) ) );
+        }
+    }
+#else /* !HAVE_SYS_EPOLL_H */
+    fd_set readSet;
+    FD_ZERO( &readSet );
+
+    SOCKET maxSock = 0;
+    size_t watched = 0;
+
+    HandlerMap::const_iterator cur, end;
+    cur = mHandlers.begin();
+    end = mHandlers.end();
+    for(; cur != end && watched < FD_SETSIZE; ++cur )
+    {
+        if( INVALID_SOCKET == cur->second )
+            continue;
+
+        FD_SET( cur->second, &readSet );
+
+        maxSock = std::max( maxSock, cur->second );
+        ++watched;
+    }
+
+    if( 0 == watched )
+    {
+        // select() refuses empty sets on some platforms
+        Sleep( timeout );
+        return;
+    }
+
+    timeval tv;
+    tv.tv_sec = 0;
+    tv.tv_usec = timeout * 1000;
+
+    if( 0 < ::select( (int)maxSock + 1, &readSet, NULL, NULL, &tv ) )
+    {
+        for( cur = mHandlers.begin(); cur != end; ++cur )
+        {
+            if( INVALID_SOCKET == cur->second )
+                continue;
+
+            if( FD_ISSET( cur->second, &readSet ) )
+                ready.push_back( cur->first );
+        }
+    }
+#endif /* !HAVE_SYS_EPOLL_H */
+}
+
+#ifdef WIN32
+DWORD WINAPI TCPReactor::Worker::WorkerLoop( LPVOID arg )
+#else /* !WIN32 */
+void* TCPReactor::Worker::WorkerLoop( void* arg )
+#endif /* !WIN32 */
+{
+    Worker* worker = reinterpret_cast< Worker* >( arg );
+    assert( worker != NULL );
+
+#ifdef WIN32
+    SetThreadPriority( GetCurrentThread(), THREAD_PRIORITY_ABOVE_NORMAL );
+#else /* !WIN32 */
+    sLog.Log( "Threading", "Starting TCPReactor worker with thread ID %d", pthread_self() );
+#endif /* !WIN32 */
+
+    worker->Run();
+
+#ifdef WIN32
+    return 0;
+#else /* !WIN32 */
+    sLog.Log( "Threading", "Ending TCPReactor worker with thread ID %d", pthread_self() );
+    return NULL;
+#endif /* !WIN32 */
+}
+
+/*************************************************************************/
+/* TCPReactor::Handler                                                   */
+/*************************************************************************/
+void TCPReactor::Handler::WaitReactorDetach()
+{
+    mMReactorAttached.Lock();
+
+    while( mReactorAttached )
+    {
+        mMReactorAttached.Unlock();
+        mReactorDetached.Wait();
+        mMReactorAttached.Lock();
+    }
+
+    mMReactorAttached.Unlock();
+}
+
+/*************************************************************************/
+/* TCPReactor                                                            */
+/*************************************************************************/
+TCPReactor::TCPReactor()
+{
+}
+
+TCPReactor::~TCPReactor()
+{
+    Stop();
+}
+
+size_t TCPReactor::GetThreadCount() const
+{
+    MutexLock lock( mMWorkers );
+
+    return mWorkers.size();
+}
+
+void TCPReactor::Start( uint32 threadCount )
+{
+    MutexLock lock( mMWorkers );
+
+    if( !mWorkers.empty() )
+        return;
+
+    if( 0 == threadCount )
+        threadCount = TCPREACTOR_DEFAULT_THREADS;
+
+    for( uint32 i = 0; i < threadCount; ++i )
+    {
+        Worker* worker = new Worker;
+        if( !worker->Start() )
+        {
+            sLog.Error( "TCPReactor", "Failed to start I/O thread %u.", i );
+
+            SafeDelete( worker );
+            continue;
+        }
+
+        mWorkers.push_back( worker );
+    }
+
+    sLog.Log( "TCPReactor", "Started %lu I/O threads.", mWorkers.size() );
+}
+
+void TCPReactor::Stop()
+{
+    MutexLock lock( mMWorkers );
+
+    std::vector<Worker*>::iterator cur, end;
+    cur = mWorkers.begin();
+    end = mWorkers.end();
+    for(; cur != end; ++cur )
+        SafeDelete( *cur );
+
+    mWorkers.clear();
+}
+
+void TCPReactor::Register( Handler* handler )
+{
+    MutexLock lock( mMWorkers );
+
+    if( mWorkers.empty() )
+        Start( TCPREACTOR_DEFAULT_THREADS );
+    if( mWorkers.empty() )
+        return;
+
+    // pick the least loaded worker
+    Worker* worker = mWorkers.front();
+
+    std::vector<Worker*>::const_iterator cur, end;
+    cur = mWorkers.begin();
+    end = mWorkers.end();
+    for(; cur != end; ++cur )
+    {
+        if( (*cur)->GetLoad() < worker->GetLoad() )
+            worker = *cur;
+    }
+
+    worker->Attach( handler );
+}
+
+void TCPReactor::Wake( Handler* handler )
+{
+    Worker* worker = handler->mReactorWorker;
+    if( NULL != worker )
+        worker->Wake( handler );
+}
@@ -29,11 +29,12 @@
 #include "log/LogNew.h"
 
 const uint32 TCPSRV_ERRBUF_SIZE = 1024;
-const uint32 TCPSRV_LOOP_GRANULARITY = 5;
+const uint32 TCPSRV_QUEUE_SIZE = 0x100;
 
 BaseTCPServer::BaseTCPServer()
 : mSock( NULL ),
-  mPort( 0 )
+  mPort( 0 ),
+  mNotifyEvent( NULL )
 {
 }
 
@@ -145,23 +146,20 @@ void BaseTCPServer::Close()
 
     SafeDelete( mSock );
     mPort = 0;
+
+    // Let the reactor notice
+    sTCPReactor.Wake( this );
 }
 
 void BaseTCPServer::StartLoop()
 {
-#ifdef WIN32
-    CreateThread( NULL, 0, TCPServerLoop, this, 0, NULL );
-#else
-    pthread_t thread;
-    pthread_create( &thread, NULL, TCPServerLoop, this );
-#endif
+    sTCPReactor.Register( this );
 }
 
 void BaseTCPServer::WaitLoop()
 {
-    //wait for loop to stop.
-    mMLoopRunning.Lock();
-    mMLoopRunning.Unlock();
+    //wait for the reactor to detach us.
+    WaitReactorDetach();
 }
 
 bool BaseTCPServer::Process()
@@ -204,56 +202,14 @@ void BaseTCPServer::ListenNewConnections()
     }
 }
 
-#ifdef WIN32
-DWORD WINAPI BaseTCPServer::TCPServerLoop( LPVOID arg )
-#else /* !WIN32 */
-void* BaseTCPServer::TCPServerLoop( void* arg )
-#endif /* !WIN32 */
+SOCKET BaseTCPServer::GetReactorSocket() const
 {
-    BaseTCPServer* tcps = reinterpret_cast< BaseTCPServer* >( arg );
-    assert( tcps != NULL );
-
-    tcps->TCPServerLoop();
+    MutexLock lock( mMSock );
 
-#ifdef WIN32
-    return 0;
-#else /* !WIN32 */
-    return NULL;
-#endif /* !WIN32 */
+    return ( NULL != mSock ? mSock->fd() : INVALID_SOCKET );
 }
 
-void BaseTCPServer::TCPServerLoop()
+bool BaseTCPServer::ReactorProcess()
 {
-#ifdef WIN32
-    SetThreadPriority( GetCurrentThread(), THREAD_PRIORITY_ABOVE_NORMAL );
-#endif
-
-#ifndef WIN32
-    sLog.Log( "Threading", "Starting TCPServerLoop with thread ID %d", pthread_self() );
-#endif
-
-    mMLoopRunning.Lock();
-
-    uint32 start = GetTickCount();
-    uint32 etime;
-    uint32 last_time;
-
-    while( Process() )
-    {
-        /* UPDATE */
-        last_time = GetTickCount();
-        etime = last_time - start;
-
-        // do the stuff for thread sleeping
-        if( TCPSRV_LOOP_GRANULARITY > etime )
-            Sleep( TCPSRV_LOOP_GRANULARITY - etime );
-
-        start = GetTickCount();
-    }
-
-    mMLoopRunning.Unlock();
-
-#ifndef WIN32
-    sLog.Log( "Threading", "Ending TCPServerLoop with thread ID %d", pthread_self() );
-#endif
+    return Process();
 }
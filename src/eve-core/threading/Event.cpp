@@ -0,0 +1,115 @@
+/*
+    ------------------------------------------------------------------------------------
+    LICENSE:
+    ------------------------------------------------------------------------------------
+    This file is part of EVEmu: EVE Online Server Emulator
+    Copyright 2006 - 2011 The EVEmu Team
+    For the latest information visit http://evemu.org
+    ------------------------------------------------------------------------------------
+    This program is free software; you can redistribute it and/or modify it under
+    the terms of the GNU Lesser General Public License as published by the Free Software
+    Foundation; either version 2 of the License, or (at your option) any later
+    version.
+
+    This program is distributed in the hope that it will be useful, but WITHOUT
+    ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+    FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public License along with
+    this program; if not, write to the Free Software Foundation, Inc., 59 Temple
+    Place - Suite 330, Boston, MA 02111-1307, USA, or go to
+    http://www.gnu.org/copyleft/lesser.txt.
+    ------------------------------------------------------------------------------------
+    Author:     EVEmu Team
+*/
+
+#include "eve-core.h"
+
+#include "threading/Event.h"
+
+/*************************************************************************/
+/* Event                                                                 */
+/*************************************************************************/
+Event::Event()
+{
+#ifdef WIN32
+    mEvent = CreateEvent( NULL, FALSE, FALSE, NULL );
+#else
+    pthread_mutex_init( &mMutex, NULL );
+    pthread_cond_init( &mCond, NULL );
+    mSignaled = false;
+#endif
+}
+
+Event::~Event()
+{
+#ifdef WIN32
+    CloseHandle( mEvent );
+#else
+    pthread_cond_destroy( &mCond );
+    pthread_mutex_destroy( &mMutex );
+#endif
+}
+
+void Event::Signal()
+{
+#ifdef WIN32
+    SetEvent( mEvent );
+#else
+    pthread_mutex_lock( &mMutex );
+
+    mSignaled = true;
+    pthread_cond_signal( &mCond );
+
+    pthread_mutex_unlock( &mMutex );
+#endif
+}
+
+void Event::Wait()
+{
+#ifdef WIN32
+    WaitForSingleObject( mEvent, INFINITE );
+#else
+    pthread_mutex_lock( &mMutex );
+
+    while( !mSignaled )
+        pthread_cond_wait( &mCond, &mMutex );
+    mSignaled = false;
+
+    pthread_mutex_unlock( &mMutex );
+#endif
+}
+
+bool Event::Wait( uint32 timeout )
+{
+#ifdef WIN32
+    return WAIT_OBJECT_0 == WaitForSingleObject( mEvent, timeout );
+#else
+    timeval now;
+    gettimeofday( &now, NULL );
+
+    timespec deadline;
+    deadline.tv_sec = now.tv_sec + timeout / 1000;
+    deadline.tv_nsec = now.tv_usec * 1000 + ( timeout % 1000 ) * 1000000;
+    if( 1000000000 <= deadline.tv_nsec )
+    {
+        ++deadline.tv_sec;
+        deadline.tv_nsec -= 1000000000;
+    }
+
+    pthread_mutex_lock( &mMutex );
+
+    while( !mSignaled )
+    {
+        if( ETIMEDOUT == pthread_cond_timedwait( &mCond, &mMutex, &deadline ) )
+            break;
+    }
+
+    const bool signaled = mSignaled;
+    mSignaled = false;
+
+    pthread_mutex_unlock( &mMutex );
+
+    return signaled;
+#endif
+}
@@ -0,0 +1,59 @@
+/*
+    ------------------------------------------------------------------------------------
+    LICENSE:
+    ------------------------------------------------------------------------------------
+    This file is part of EVEmu: EVE Online Server Emulator
+    Copyright 2006 - 2011 The EVEmu Team
+    For the latest information visit http://evemu.org
+    ------------------------------------------------------------------------------------
+    This program is free software; you can redistribute it and/or modify it under
+    the terms of the GNU Lesser General Public License as published by the Free Software
+    Foundation; either version 2 of the License, or (at your option) any later
+    version.
+
+    This program is distributed in the hope that it will be useful, but WITHOUT
+    ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+    FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public License along with
+    this program; if not, write to the Free Software Foundation, Inc., 59 Temple
+    Place - Suite 330, Boston, MA 02111-1307, USA, or go to
+    http://www.gnu.org/copyleft/lesser.txt.
+    ------------------------------------------------------------------------------------
+    Author:     EVEmu Team
+*/
+
+
+#include "eve-core.h"
+
+#include "threading/LockProfile.h"
+
+/// Bounds (in microseconds) of the buckets of the wait and hold times.
+static const uint64 LOCK_TIME_BOUNDS[] =
+{
+    1, 2, 5, 10, 25, 50, 100, 250, 500, 1000, 10000, 100000
+};
+
+/*************************************************************************/
+/* LockProfile                                                           */
+/*************************************************************************/
+/** @return The labels of the metrics of given lock. */
+static std::string LockLabels( const char* name )
+{
+    return std::string( "lock=\"" ) + name + "\"";
+}
+
+static MetricHistogram& LockTimeHistogram( const char* name, const char* help, const char* lockName )
+{
+    const std::vector< uint64 > bounds( LOCK_TIME_BOUNDS, LOCK_TIME_BOUNDS + sizeof( LOCK_TIME_BOUNDS ) / sizeof( *LOCK_TIME_BOUNDS ) );
+
+    return sMetrics.Histogram( name, help, bounds, 1e6, LockLabels( lockName ).c_str() );
+}
+
+LockProfile::LockProfile( const char* name )
+: mAcquisitions( sMetrics.Counter( "evemu_lock_acquisitions_total", "Number of acquisitions of the lock.", LockLabels( name ).c_str() ) ),
+  mContentions( sMetrics.Counter( "evemu_lock_contentions_total", "Number of acquisitions of the lock which had to wait.", LockLabels( name ).c_str() ) ),
+  mWaitTime( LockTimeHistogram( "evemu_lock_wait_seconds", "Time the contended acquisitions of the lock waited.", name ) ),
+  mHoldTime( LockTimeHistogram( "evemu_lock_hold_seconds", "Time the lock was held exclusively.", name ) )
+{
+}
@@ -80,111 +80,3 @@ void Mutex::Unlock()
     pthread_mutex_unlock( &mMutex );
 #endif
 }
-
-/*************************************************************************/
-/* MRMutex                                                               */
-/*************************************************************************/
-MRMutex::MRMutex() {
-    rl = 0;
-    wr = 0;
-    rl = 0;
-}
-
-MRMutex::~MRMutex() {
-#ifdef _EQDEBUG
-    if (wl || rl) {
-        cout << "MRMutex::~MRMutex: poor cleanup detected: rl=" << rl << ", wl=" << wl << endl;
-    }
-#endif
-}
-
-void MRMutex::ReadLock() {
-    while (!TryReadLock()) {
-        Sleep(1);
-    }
-}
-
-bool MRMutex::TryReadLock() {
-    MCounters.Lock();
-    if (!wr && !wl) {
-        rl++;
-        MCounters.Unlock();
-        return true;
-    }
-    else {
-        MCounters.Unlock();
-        return false;
-    }
-}
-
-void MRMutex::UnReadLock() {
-    MCounters.Lock();
-    rl--;
-#ifdef _EQDEBUG
-    if (rl < 0) {
-        ThrowError("rl < 0 in MRMutex::UnReadLock()");
-    }
-#endif
-    MCounters.Unlock();
-}
-
-void MRMutex::WriteLock() {
-    MCounters.Lock();
-    if (!rl && !wl) {
-        wl++;
-        MCounters.Unlock();
-        return;
-    }
-    else {
-        wr++;
-        MCounters.Unlock();
-        while (1) {
-            Sleep(1);
-            MCounters.Lock();
-            if (!rl && !wl) {
-                wr--;
-                MCounters.Unlock();
-                return;
-            }
-            MCounters.Lock();
-        }
-    }
-}
-
-bool MRMutex::TryWriteLock() {
-    MCounters.Lock();
-    if (!rl && !wl) {
-        wl++;
-        MCounters.Unlock();
-        return true;
-    }
-    else {
-        MCounters.Unlock();
-        return false;
-    }
-}
-
-void MRMutex::UnWriteLock() {
-    MCounters.Lock();
-    wl--;
-#ifdef _EQDEBUG
-    if (wl < 0) {
-        ThrowError("wl < 0 in MRMutex::UnWriteLock()");
-    }
-#endif
-    MCounters.Unlock();
-}
-
-int32 MRMutex::ReadLockCount() {
-    MCounters.Lock();
-    int32 ret = rl;
-    MCounters.Unlock();
-    return ret;
-}
-
-int32 MRMutex::WriteLockCount() {
-    MCounters.Lock();
-    int32 ret = wl;
-    MCounters.Unlock();
-    return ret;
-}
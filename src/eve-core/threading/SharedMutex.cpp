@@ -0,0 +1,111 @@
+/*
+    ------------------------------------------------------------------------------------
+    LICENSE:
+    ------------------------------------------------------------------------------------
+    This file is part of EVEmu: EVE Online Server Emulator
+    Copyright 2006 - 2011 The EVEmu Team
+    For the latest information visit http://evemu.org
+    ------------------------------------------------------------------------------------
+    This program is free software; you can redistribute it and/or modify it under
+    the terms of the GNU Lesser General Public License as published by the Free Software
+    Foundation; either version 2 of the License, or (at your option) any later
+    version.
+
+    This program is distributed in the hope that it will be useful, but WITHOUT
+    ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+    FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public License along with
+    this program; if not, write to the Free Software Foundation, Inc., 59 Temple
+    Place - Suite 330, Boston, MA 02111-1307, USA, or go to
+    http://www.gnu.org/copyleft/lesser.txt.
+    ------------------------------------------------------------------------------------
+    Author:     EVEmu Team
+*/
+
+
+#include "eve-core.h"
+
+#include "threading/SharedMutex.h"
+
+/*************************************************************************/
+/* SharedMutex                                                           */
+/*************************************************************************/
+SharedMutex::SharedMutex()
+{
+#ifdef WIN32
+    InitializeSRWLock( &mLock );
+#else
+    pthread_rwlockattr_t attr;
+    pthread_rwlockattr_init( &attr );
+
+#   ifdef __GLIBC__
+    // glibc prefers readers by default
+    pthread_rwlockattr_setkind_np( &attr, PTHREAD_RWLOCK_PREFER_WRITER_NONRECURSIVE_NP );
+#   endif /* __GLIBC__ */
+
+    pthread_rwlock_init( &mLock, &attr );
+    pthread_rwlockattr_destroy( &attr );
+#endif
+}
+
+SharedMutex::~SharedMutex()
+{
+#ifndef WIN32
+    pthread_rwlock_destroy( &mLock );
+#endif
+}
+
+void SharedMutex::Lock()
+{
+#ifdef WIN32
+    AcquireSRWLockExclusive( &mLock );
+#else
+    pthread_rwlock_wrlock( &mLock );
+#endif
+}
+
+bool SharedMutex::TryLock()
+{
+#ifdef WIN32
+    return FALSE != TryAcquireSRWLockExclusive( &mLock );
+#else
+    return 0 == pthread_rwlock_trywrlock( &mLock );
+#endif
+}
+
+void SharedMutex::Unlock()
+{
+#ifdef WIN32
+    ReleaseSRWLockExclusive( &mLock );
+#else
+    pthread_rwlock_unlock( &mLock );
+#endif
+}
+
+void SharedMutex::LockShared()
+{
+#ifdef WIN32
+    AcquireSRWLockShared( &mLock );
+#else
+    pthread_rwlock_rdlock( &mLock );
+#endif
+}
+
+bool SharedMutex::TryLockShared()
+{
+#ifdef WIN32
+    return FALSE != TryAcquireSRWLockShared( &mLock );
+#else
+    return 0 == pthread_rwlock_tryrdlock( &mLock );
+#endif
+}
+
+void SharedMutex::UnlockShared()
+{
+#ifdef WIN32
+    ReleaseSRWLockShared( &mLock );
+#else
+    pthread_rwlock_unlock( &mLock );
+#endif
+}
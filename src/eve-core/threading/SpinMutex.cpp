@@ -0,0 +1,68 @@
+/*
+    ------------------------------------------------------------------------------------
+    LICENSE:
+    ------------------------------------------------------------------------------------
+    This file is part of EVEmu: EVE Online Server Emulator
+    Copyright 2006 - 2011 The EVEmu Team
+    For the latest information visit http://evemu.org
+    ------------------------------------------------------------------------------------
+    This program is free software; you can redistribute it and/or modify it under
+    the terms of the GNU Lesser General Public License as published by the Free Software
+    Foundation; either version 2 of the License, or (at your option) any later
+    version.
+
+    This program is distributed in the hope that it will be useful, but WITHOUT
+    ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+    FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public License along with
+    this program; if not, write to the Free Software Foundation, Inc., 59 Temple
+    Place - Suite 330, Boston, MA 02111-1307, USA, or go to
+    http://www.gnu.org/copyleft/lesser.txt.
+    ------------------------------------------------------------------------------------
+    Author:     EVEmu Team
+*/
+
+
+#include "eve-core.h"
+
+#include "threading/SpinMutex.h"
+
+#ifdef HAVE_LINUX_FUTEX_H
+#   include <linux/futex.h>
+#   include <sys/syscall.h>
+#endif /* HAVE_LINUX_FUTEX_H */
+
+/*************************************************************************/
+/* SpinMutex                                                             */
+/*************************************************************************/
+void SpinMutex::_LockContended()
+{
+    for( uint32 i = 0; i < SPIN_COUNT; ++i )
+    {
+        AtomicPause();
+
+        // read first, hammering the cache line with writes slows the holder down
+        if( STATE_UNLOCKED == AtomicLoad( &mState ) && TryLock() )
+            return;
+    }
+
+    // the holder has to wake us up from now on
+    for( uint32 i = 0; STATE_UNLOCKED != AtomicExchange( &mState, STATE_PARKED ); ++i )
+    {
+#ifdef HAVE_LINUX_FUTEX_H
+        ::syscall( SYS_futex, &mState, FUTEX_WAIT_PRIVATE, STATE_PARKED, NULL, NULL, 0 );
+#else /* !HAVE_LINUX_FUTEX_H */
+        Sleep( i < SPIN_COUNT ? 0 : 1 );
+#endif /* !HAVE_LINUX_FUTEX_H */
+    }
+}
+
+void SpinMutex::_UnlockContended()
+{
+    AtomicStore( &mState, STATE_UNLOCKED );
+
+#ifdef HAVE_LINUX_FUTEX_H
+    ::syscall( SYS_futex, &mState, FUTEX_WAKE_PRIVATE, 1, NULL, NULL, 0 );
+#endif /* HAVE_LINUX_FUTEX_H */
+}
@@ -0,0 +1,322 @@
+/*
+    ------------------------------------------------------------------------------------
+    LICENSE:
+    ------------------------------------------------------------------------------------
+    This file is part of EVEmu: EVE Online Server Emulator
+    Copyright 2006 - 2011 The EVEmu Team
+    For the latest information visit http://evemu.org
+    ------------------------------------------------------------------------------------
+    This program is free software; you can redistribute it and/or modify it under
+    the terms of the GNU Lesser General Public License as published by the Free Software
+    Foundation; either version 2 of the License, or (at your option) any later
+    version.
+
+    This program is distributed in the hope that it will be useful, but WITHOUT
+    ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+    FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public License along with
+    this program; if not, write to the Free Software Foundation, Inc., 59 Temple
+    Place - Suite 330, Boston, MA 02111-1307, USA, or go to
+    http://www.gnu.org/copyleft/lesser.txt.
+    ------------------------------------------------------------------------------------
+    Author:     EVEmu Team
+*/
+
+
+#include "eve-core.h"
+
+#include "log/LogNew.h"
+#include "threading/Atomic.h"
+#include "utils/CallTracer.h"
+#include "utils/Metrics.h"
+#include "utils/utils_time.h"
+
+/// The trace the queries of the calling thread are charged to; NULL if none.
+static THREAD_LOCAL CallTrace* sCurrent = NULL;
+
+/*************************************************************************/
+/* CallTrace                                                             */
+/*************************************************************************/
+const char* const CallTrace::STAGE_NAMES[ STAGE_COUNT ] =
+{
+    "receive",
+    "queue",
+    "loop",
+    "unmarshal",
+    "dispatch",
+    "sql",
+    "encode_wait",
+    "encode",
+    "send"
+};
+
+CallTrace::CallTrace()
+: sqlTime( 0 ),
+  queries( 0 ),
+  accountID( 0 ),
+  size( 0 )
+{
+    for( size_t i = 0; i < POINT_COUNT; ++i )
+        at[ i ] = 0;
+}
+
+void CallTrace::Stamp( Point point )
+{
+    at[ point ] = GetTimeUSeconds();
+}
+
+uint64 CallTrace::GetStage( Stage stage ) const
+{
+    switch( stage )
+    {
+        case STAGE_RECEIVE:     return Elapsed( RECEIVED, QUEUED );
+        case STAGE_QUEUE:       return Elapsed( QUEUED, WOKEN );
+        // a call queued during the tick is looked at in the same tick
+        case STAGE_LOOP:        return Elapsed( at[ QUEUED ] < at[ WOKEN ] ? WOKEN : QUEUED, POPPED );
+        case STAGE_UNMARSHAL:   return Elapsed( POPPED, UNMARSHALED );
+        case STAGE_DISPATCH:
+        {
+            const uint64 dispatch = Elapsed( UNMARSHALED, REPLIED );
+            return ( sqlTime < dispatch ? dispatch - sqlTime : 0 );
+        }
+        case STAGE_SQL:         return sqlTime;
+        case STAGE_ENCODE_WAIT: return Elapsed( REPLIED, ENCODING );
+        case STAGE_ENCODE:      return Elapsed( ENCODING, ENCODED );
+        case STAGE_SEND:        return Elapsed( ENCODED, SENT );
+        default:                return 0;
+    }
+}
+
+uint64 CallTrace::Elapsed( Point from, Point to ) const
+{
+    if( 0 == at[ from ] || at[ to ] <= at[ from ] )
+        return 0;
+
+    return at[ to ] - at[ from ];
+}
+
+/*************************************************************************/
+/* CallTracer                                                            */
+/*************************************************************************/
+CallTracer::CallTracer()
+: mRate( 0 ),
+  mHistory( 0 ),
+  mLog( false ),
+  mCountdown( 0 ),
+  mTickStart( 0 ),
+  mDropped( 0 ),
+  mNextLatest( 0 )
+{
+    for( size_t i = 0; i < CallTrace::STAGE_COUNT; ++i )
+    {
+        const std::string labels = std::string( "stage=\"" ) + CallTrace::STAGE_NAMES[ i ] + "\"";
+        mStageMetrics[ i ] = &sMetrics.LatencyHistogram( "evemu_call_stage_seconds", "Time the traced calls spent in a stage.", labels.c_str() );
+    }
+
+    mTotalMetric = &sMetrics.LatencyHistogram( "evemu_call_seconds", "Time from the first byte of a traced call to the last byte of its answer." );
+}
+
+CallTracer::~CallTracer()
+{
+    for( size_t i = 0; i < mFinished.size(); ++i )
+        SafeDelete( mFinished[ i ] );
+
+    Reset();
+}
+
+bool CallTracer::IsEnabled() const
+{
+    return 0 < GetRate();
+}
+
+uint32 CallTracer::GetRate() const
+{
+    return AtomicLoad( &mRate );
+}
+
+void CallTracer::Configure( uint32 rate, size_t history, bool log )
+{
+    SetRate( rate );
+    mHistory = history;
+    mLog = log;
+
+    if( mHistory < mLatest.size() )
+        Reset();
+}
+
+void CallTracer::SetRate( uint32 rate )
+{
+    AtomicStore( &mRate, rate );
+    mCountdown = 0;
+}
+
+void CallTracer::BeginTick()
+{
+    if( IsEnabled() )
+        mTickStart = GetTimeUSeconds();
+}
+
+CallTrace* CallTracer::Sample()
+{
+    const uint32 rate = GetRate();
+    if( 0 == rate || ++mCountdown < rate )
+        return NULL;
+    mCountdown = 0;
+
+    ++mStats.sampled;
+
+    CallTrace* trace = new CallTrace;
+    trace->at[ CallTrace::WOKEN ] = mTickStart;
+    return trace;
+}
+
+void CallTracer::Finish( CallTrace** trace )
+{
+    if( NULL == *trace )
+        return;
+
+    MutexLock lock( mMFinished );
+
+    mFinished.push_back( *trace );
+    *trace = NULL;
+}
+
+void CallTracer::Discard( CallTrace** trace )
+{
+    if( NULL == *trace )
+        return;
+
+    SafeDelete( *trace );
+
+    MutexLock lock( mMFinished );
+    ++mDropped;
+}
+
+void CallTracer::Process()
+{
+    std::vector< CallTrace* > finished;
+    {
+        MutexLock lock( mMFinished );
+
+        finished.swap( mFinished );
+        mStats.dropped += mDropped;
+        mDropped = 0;
+    }
+
+    std::string line;
+    for( size_t i = 0; i < finished.size(); ++i )
+    {
+        CallTrace* trace = finished[ i ];
+
+        ++mStats.finished;
+        for( size_t j = 0; j < CallTrace::STAGE_COUNT; ++j )
+        {
+            const uint64 time = trace->GetStage( (CallTrace::Stage)j );
+
+            mStats.stageTime[ j ] += time;
+            if( mStats.maxStageTime[ j ] < time )
+                mStats.maxStageTime[ j ] = time;
+
+            mStageMetrics[ j ]->Observe( time );
+        }
+
+        const uint64 total = trace->GetTotal();
+        mStats.totalTime += total;
+        if( mStats.maxTotalTime < total )
+            mStats.maxTotalTime = total;
+        mTotalMetric->Observe( total );
+
+        if( mLog )
+        {
+            Format( *trace, line );
+            sLog.Log( "Call Tracer", "%s", line.c_str() );
+        }
+
+        // keep the latest ones, replacing the oldest
+        if( mLatest.size() < mHistory )
+            mLatest.push_back( trace );
+        else if( 0 < mHistory )
+        {
+            mNextLatest %= mLatest.size();
+            SafeDelete( mLatest[ mNextLatest ] );
+            mLatest[ mNextLatest++ ] = trace;
+        }
+        else
+            SafeDelete( trace );
+    }
+}
+
+size_t CallTracer::Dump( size_t count, std::string& summary ) const
+{
+    if( mLatest.size() < count )
+        count = mLatest.size();
+
+    // latest first; until the history fills up, the latest is the last one
+    const size_t latest = ( mLatest.size() < mHistory || 0 == mNextLatest ? mLatest.size() : mNextLatest );
+
+    std::string line;
+    for( size_t i = 0; i < count; ++i )
+    {
+        const CallTrace& trace = *mLatest[ ( latest + mLatest.size() - 1 - i ) % mLatest.size() ];
+
+        Format( trace, line );
+        sLog.Log( "Call Tracer", "%s", line.c_str() );
+
+        if( !summary.empty() )
+            summary += "\n";
+        summary += line;
+    }
+
+    return count;
+}
+
+void CallTracer::Reset()
+{
+    for( size_t i = 0; i < mLatest.size(); ++i )
+        SafeDelete( mLatest[ i ] );
+
+    mLatest.clear();
+    mNextLatest = 0;
+}
+
+void CallTracer::SetCurrent( CallTrace* trace )
+{
+    sCurrent = trace;
+}
+
+CallTrace* CallTracer::GetCurrent()
+{
+    return sCurrent;
+}
+
+void CallTracer::AddQuery( uint64 time )
+{
+    CallTrace* trace = sCurrent;
+    if( NULL == trace )
+        return;
+
+    trace->sqlTime += time;
+    ++trace->queries;
+}
+
+void CallTracer::Format( const CallTrace& trace, std::string& into )
+{
+    char buf[128];
+    snprintf( buf, sizeof( buf ), "%s by account %u: %.2f ms, %u bytes answered; stages (ms):",
+              trace.call.empty() ? "(unknown call)" : trace.call.c_str(),
+              trace.accountID, trace.GetTotal() / 1000.0, trace.size );
+    into = buf;
+
+    for( size_t i = 0; i < CallTrace::STAGE_COUNT; ++i )
+    {
+        snprintf( buf, sizeof( buf ), " %s %.2f", CallTrace::STAGE_NAMES[ i ], trace.GetStage( (CallTrace::Stage)i ) / 1000.0 );
+        into += buf;
+
+        if( CallTrace::STAGE_SQL == i )
+        {
+            snprintf( buf, sizeof( buf ), " (%u queries)", trace.queries );
+            into += buf;
+        }
+    }
+}
@@ -29,40 +29,117 @@
 
 const uint8 DeflateHeaderByte = 0x78; //'x'
 
-bool IsDeflated( const Buffer& data )
+/* zlib contexts of a thread. Setting up a context allocates its window
+   and tables, so they are kept and only reset for every stream. */
+struct ZlibContext
 {
-    return ( DeflateHeaderByte == data[0] );
-}
+    z_stream deflate;
+    /// Level the deflate context was set up with.
+    int deflateLevel;
+    bool deflateReady;
+    bool deflateBusy;
+
+    z_stream inflate;
+    bool inflateReady;
+};
 
-bool DeflateData( Buffer& data )
+/* Thread-local variables may not have constructors, so the context is
+   allocated on first use. It lives as long as the thread. */
+static THREAD_LOCAL ZlibContext* sZlibContext;
+
+static ZlibContext& GetZlibContext()
 {
-    Buffer dataDeflated;
-    if( !DeflateData( data, dataDeflated ) )
-        return false;
+    if( NULL == sZlibContext )
+    {
+        sZlibContext = new ZlibContext;
+        memset( sZlibContext, 0, sizeof( ZlibContext ) );
+    }
 
-    data = dataDeflated;
-    return true;
+    return *sZlibContext;
 }
 
-bool DeflateData( const Buffer& input, Buffer& output )
+static z_stream* AcquireDeflate( int level )
 {
-    const Buffer::iterator<uint8> out = output.end<uint8>();
+    ZlibContext& ctx = GetZlibContext();
 
-    size_t outputSize = compressBound( input.size() );
-    output.ResizeAt( out, outputSize );
+    // only one stream per thread at a time
+    assert( !ctx.deflateBusy );
 
-    int res = compress( &*out, (uLongf*)&outputSize, &input[0], input.size() );
+    if( ctx.deflateReady && ctx.deflateLevel != level )
+    {
+        deflateEnd( &ctx.deflate );
+        ctx.deflateReady = false;
+    }
 
-    if( Z_OK == res )
+    if( ctx.deflateReady )
     {
-        output.ResizeAt( out, outputSize );
-        return true;
+        if( Z_OK != deflateReset( &ctx.deflate ) )
+            return NULL;
     }
     else
     {
-        output.ResizeAt( out, 0 );
-        return false;
+        memset( &ctx.deflate, 0, sizeof( z_stream ) );
+
+        // same parameters as compress2()
+        if( Z_OK != deflateInit( &ctx.deflate, level ) )
+            return NULL;
+
+        ctx.deflateLevel = level;
+        ctx.deflateReady = true;
     }
+
+    ctx.deflateBusy = true;
+    return &ctx.deflate;
+}
+
+static void ReleaseDeflate()
+{
+    GetZlibContext().deflateBusy = false;
+}
+
+static z_stream* AcquireInflate()
+{
+    ZlibContext& ctx = GetZlibContext();
+
+    if( ctx.inflateReady )
+    {
+        if( Z_OK != inflateReset( &ctx.inflate ) )
+            return NULL;
+    }
+    else
+    {
+        memset( &ctx.inflate, 0, sizeof( z_stream ) );
+
+        if( Z_OK != inflateInit( &ctx.inflate ) )
+            return NULL;
+
+        ctx.inflateReady = true;
+    }
+
+    return &ctx.inflate;
+}
+
+bool IsDeflated( const Buffer& data )
+{
+    return ( DeflateHeaderByte == data[0] );
+}
+
+bool DeflateData( Buffer& data, int level )
+{
+    Buffer dataDeflated;
+    if( !DeflateData( data, dataDeflated, level ) )
+        return false;
+
+    data = dataDeflated;
+    return true;
+}
+
+bool DeflateData( const Buffer& input, Buffer& output, int level )
+{
+    DeflateStream stream( output, level );
+
+    return stream.Write( 0 < input.size() ? &input[0] : NULL, input.size() )
+        && stream.Finish();
 }
 
 bool InflateData( Buffer& data )
@@ -77,28 +154,131 @@ bool InflateData( Buffer& data )
 
 bool InflateData( const Buffer& input, Buffer& output )
 {
-    const Buffer::iterator<uint8> out = output.end<uint8>();
+    const size_t start = output.size();
+
+    z_stream* zs = AcquireInflate();
+    if( NULL == zs || 0 == input.size() )
+        return false;
 
-    size_t outputSize = 0;
-    size_t sizeMultiplier = 0;
+    zs->next_in = const_cast<Bytef*>( &input[0] );
+    zs->avail_in = input.size();
 
-    int res = 0;
+    // guess 50% compression ratio first, then keep doubling the room
+    size_t used = start;
+    size_t room = ( input.size() << 1 );
+
+    int res;
     do
     {
-        outputSize = ( input.size() << ++sizeMultiplier );
-        output.ResizeAt( out, outputSize );
+        output.Resize<uint8>( used + room );
+
+        zs->next_out = &output[ used ];
+        zs->avail_out = room;
+
+        res = inflate( zs, Z_NO_FLUSH );
+        used = output.size() - zs->avail_out;
+        room = ( used - start );
 
-        res = uncompress( &*out, (uLongf*)&outputSize, &input[0], input.size() );
-    } while( Z_BUF_ERROR == res );
+    // continue while the output is the only thing missing
+    } while( Z_OK == res && 0 == zs->avail_out );
 
-    if( Z_OK == res )
+    if( Z_STREAM_END == res )
     {
-        output.ResizeAt( out, outputSize );
+        output.Resize<uint8>( used );
         return true;
     }
     else
     {
-        output.ResizeAt( out, 0 );
+        output.Resize<uint8>( start );
+        return false;
+    }
+}
+
+/*************************************************************************/
+/* DeflateStream                                                         */
+/*************************************************************************/
+DeflateStream::DeflateStream( Buffer& output, int level )
+: mOutput( output ),
+  mStart( output.size() ),
+  mUsed( output.size() ),
+  mStream( AcquireDeflate( level ) )
+{
+}
+
+DeflateStream::~DeflateStream()
+{
+    if( NULL != mStream )
+        _Fail();
+}
+
+bool DeflateStream::Write( const uint8* data, size_t len )
+{
+    if( NULL == mStream )
+        return false;
+
+    mStream->next_in = const_cast<Bytef*>( data );
+    mStream->avail_in = len;
+
+    if( !_Deflate( Z_NO_FLUSH ) )
+    {
+        _Fail();
+        return false;
+    }
+
+    return true;
+}
+
+bool DeflateStream::Finish()
+{
+    if( NULL == mStream )
+        return false;
+
+    mStream->next_in = NULL;
+    mStream->avail_in = 0;
+
+    if( !_Deflate( Z_FINISH ) )
+    {
+        _Fail();
         return false;
     }
+
+    mOutput.Resize<uint8>( mUsed );
+
+    ReleaseDeflate();
+    mStream = NULL;
+
+    return true;
+}
+
+bool DeflateStream::_Deflate( int flush )
+{
+    while( true )
+    {
+        // make room for the worst case
+        const size_t room = deflateBound( mStream, mStream->avail_in );
+        if( mOutput.size() < mUsed + room )
+            mOutput.Resize<uint8>( mUsed + room );
+
+        mStream->next_out = &mOutput[ mUsed ];
+        mStream->avail_out = mOutput.size() - mUsed;
+
+        const int res = deflate( mStream, flush );
+        mUsed = mOutput.size() - mStream->avail_out;
+
+        if( Z_STREAM_END == res )
+            return true;
+        else if( Z_OK != res && Z_BUF_ERROR != res )
+            return false;
+        // all input consumed and nothing left pending
+        else if( Z_FINISH != flush && 0 == mStream->avail_in && 0 < mStream->avail_out )
+            return true;
+    }
+}
+
+void DeflateStream::_Fail()
+{
+    mOutput.Resize<uint8>( mStart );
+
+    ReleaseDeflate();
+    mStream = NULL;
 }
@@ -0,0 +1,99 @@
+/*
+    ------------------------------------------------------------------------------------
+    LICENSE:
+    ------------------------------------------------------------------------------------
+    This file is part of EVEmu: EVE Online Server Emulator
+    Copyright 2006 - 2011 The EVEmu Team
+    For the latest information visit http://evemu.org
+    ------------------------------------------------------------------------------------
+    This program is free software; you can redistribute it and/or modify it under
+    the terms of the GNU Lesser General Public License as published by the Free Software
+    Foundation; either version 2 of the License, or (at your option) any later
+    version.
+
+    This program is distributed in the hope that it will be useful, but WITHOUT
+    ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+    FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public License along with
+    this program; if not, write to the Free Software Foundation, Inc., 59 Temple
+    Place - Suite 330, Boston, MA 02111-1307, USA, or go to
+    http://www.gnu.org/copyleft/lesser.txt.
+    ------------------------------------------------------------------------------------
+    Author:     EVEmu Team
+*/
+
+#include "eve-core.h"
+
+#include "utils/MappedFile.h"
+
+/*************************************************************************/
+/* MappedFile                                                            */
+/*************************************************************************/
+RefPtr< MappedFile > MappedFile::Open( const char* filename )
+{
+#ifdef WIN32
+    HANDLE file = CreateFile( filename, GENERIC_READ, FILE_SHARE_READ | FILE_SHARE_DELETE,
+                              NULL, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL );
+    if( INVALID_HANDLE_VALUE == file )
+        return RefPtr< MappedFile >();
+
+    LARGE_INTEGER size;
+    if( !GetFileSizeEx( file, &size ) || 0 == size.QuadPart )
+    {
+        CloseHandle( file );
+        return RefPtr< MappedFile >();
+    }
+
+    HANDLE mapping = CreateFileMapping( file, NULL, PAGE_READONLY, 0, 0, NULL );
+    // the view keeps the file mapped on its own
+    CloseHandle( file );
+
+    if( NULL == mapping )
+        return RefPtr< MappedFile >();
+
+    void* data = MapViewOfFile( mapping, FILE_MAP_READ, 0, 0, 0 );
+    CloseHandle( mapping );
+
+    if( NULL == data )
+        return RefPtr< MappedFile >();
+
+    return RefPtr< MappedFile >( new MappedFile( (const uint8*)data, (size_t)size.QuadPart ) );
+#else /* !WIN32 */
+    const int fd = open( filename, O_RDONLY );
+    if( -1 == fd )
+        return RefPtr< MappedFile >();
+
+    struct stat st;
+    if( 0 != fstat( fd, &st ) || 0 == st.st_size )
+    {
+        close( fd );
+        return RefPtr< MappedFile >();
+    }
+
+    void* data = mmap( NULL, st.st_size, PROT_READ, MAP_SHARED, fd, 0 );
+    // the mapping keeps the file open on its own
+    close( fd );
+
+    if( MAP_FAILED == data )
+        return RefPtr< MappedFile >();
+
+    return RefPtr< MappedFile >( new MappedFile( (const uint8*)data, st.st_size ) );
+#endif /* !WIN32 */
+}
+
+MappedFile::MappedFile( const uint8* data, size_t size )
+: RefObject( 0 ),
+  mData( data ),
+  mSize( size )
+{
+}
+
+MappedFile::~MappedFile()
+{
+#ifdef WIN32
+    UnmapViewOfFile( mData );
+#else /* !WIN32 */
+    munmap( const_cast< uint8* >( mData ), mSize );
+#endif /* !WIN32 */
+}
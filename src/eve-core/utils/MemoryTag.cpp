@@ -0,0 +1,207 @@
+/*
+    ------------------------------------------------------------------------------------
+    LICENSE:
+    ------------------------------------------------------------------------------------
+    This file is part of EVEmu: EVE Online Server Emulator
+    Copyright 2006 - 2011 The EVEmu Team
+    For the latest information visit http://evemu.org
+    ------------------------------------------------------------------------------------
+    This program is free software; you can redistribute it and/or modify it under
+    the terms of the GNU Lesser General Public License as published by the Free Software
+    Foundation; either version 2 of the License, or (at your option) any later
+    version.
+
+    This program is distributed in the hope that it will be useful, but WITHOUT
+    ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+    FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public License along with
+    this program; if not, write to the Free Software Foundation, Inc., 59 Temple
+    Place - Suite 330, Boston, MA 02111-1307, USA, or go to
+    http://www.gnu.org/copyleft/lesser.txt.
+    ------------------------------------------------------------------------------------
+    Author:     EVEmu Team
+*/
+
+
+#include "eve-core.h"
+
+#include "threading/Mutex.h"
+#include "utils/MemoryTag.h"
+#include "utils/Metrics.h"
+
+MemoryTag* MemoryTag::sFirst = NULL;
+volatile uint32 MemoryTag::sSampleRate = 0;
+volatile uint32 MemoryTag::sLiveSamples = 0;
+
+/**
+ * @brief A live sampled allocation.
+ */
+struct SampledAllocation
+{
+    const MemoryTag* tag;
+    size_t size;
+    size_t depth;
+    void* frames[ MemoryTag::MAX_FRAMES ];
+};
+
+/// Number of allocations made since sampling was enabled.
+static volatile uint32 sSampleCounter = 0;
+/// Protects sSamples.
+static Mutex sSamplesMutex;
+/// The live sampled allocations, by address.
+static std::map< void*, SampledAllocation > sSamples;
+
+MemoryTag::MemoryTag( const char* name )
+: mName( name ),
+  mNext( sFirst )
+{
+    // the counters may have been used already, see the header
+    sFirst = this;
+}
+
+MemoryTag::Stats MemoryTag::GetStats() const
+{
+    Stats stats;
+    stats.liveBytes = (int64)AtomicLoad64( &mBytes );
+    stats.liveObjects = (int64)AtomicLoad64( &mObjects );
+    stats.allocations = AtomicLoad64( &mAllocations );
+
+    return stats;
+}
+
+const MemoryTag* MemoryTag::Find( const char* name )
+{
+    for( const MemoryTag* tag = first(); NULL != tag; tag = tag->next() )
+    {
+        if( 0 == strcmp( tag->name(), name ) )
+            return tag;
+    }
+
+    return NULL;
+}
+
+void MemoryTag::SetSampleRate( uint32 rate )
+{
+    AtomicStore( &sSampleRate, rate );
+}
+
+void MemoryTag::DumpSamples( std::vector< Sample >& into )
+{
+    typedef std::pair< const MemoryTag*, std::vector< void* > > Key;
+    std::map< Key, std::pair< size_t, size_t > > groups;
+
+    {
+        MutexLock lock( sSamplesMutex );
+
+        std::map< void*, SampledAllocation >::const_iterator cur, end;
+        cur = sSamples.begin();
+        end = sSamples.end();
+        for(; cur != end; ++cur)
+        {
+            const SampledAllocation& sample = cur->second;
+
+            std::pair< size_t, size_t >& group = groups[ Key( sample.tag, std::vector< void* >( sample.frames, sample.frames + sample.depth ) ) ];
+            ++group.first;
+            group.second += sample.size;
+        }
+    }
+
+    // biggest first
+    std::vector< std::pair< size_t, const Key* > > order;
+    std::map< Key, std::pair< size_t, size_t > >::const_iterator cur, end;
+    cur = groups.begin();
+    end = groups.end();
+    for(; cur != end; ++cur)
+        order.push_back( std::make_pair( cur->second.second, &cur->first ) );
+    std::sort( order.rbegin(), order.rend() );
+
+    for( size_t i = 0; i < order.size(); ++i )
+    {
+        const Key& key = *order[ i ].second;
+        const std::pair< size_t, size_t >& group = groups[ key ];
+
+        Sample sample;
+        sample.tag = key.first;
+        sample.count = group.first;
+        sample.bytes = group.second;
+
+        void* const* frames = &key.second[ 0 ];
+        const size_t depth = key.second.size();
+#ifndef WIN32
+        char** symbols = backtrace_symbols( frames, depth );
+#else /* WIN32 */
+        char** symbols = NULL;
+#endif /* WIN32 */
+        for( size_t j = 0; j < depth; ++j )
+        {
+            if( NULL != symbols )
+                sample.frames.push_back( symbols[ j ] );
+            else
+            {
+                char address[32];
+                snprintf( address, sizeof( address ), "%p", frames[ j ] );
+                sample.frames.push_back( address );
+            }
+        }
+        free( symbols );
+
+        into.push_back( sample );
+    }
+}
+
+void MemoryTag::ClearSamples()
+{
+    MutexLock lock( sSamplesMutex );
+
+    sSamples.clear();
+    AtomicStore( &sLiveSamples, 0 );
+}
+
+void MemoryTag::PublishMetrics()
+{
+    for( MemoryTag* tag = sFirst; NULL != tag; tag = tag->mNext )
+    {
+        if( NULL == tag->mBytesMetric )
+        {
+            const std::string labels = std::string( "tag=\"" ) + tag->name() + "\"";
+
+            tag->mBytesMetric = &sMetrics.Gauge( "evemu_memory_live_bytes", "Number of heap bytes held by a subsystem.", labels.c_str() );
+            tag->mObjectsMetric = &sMetrics.Gauge( "evemu_memory_live_objects", "Number of heap objects held by a subsystem.", labels.c_str() );
+        }
+
+        const Stats stats = tag->GetStats();
+        tag->mBytesMetric->Set( stats.liveBytes );
+        tag->mObjectsMetric->Set( stats.liveObjects );
+    }
+}
+
+void MemoryTag::_Sample( void* p, size_t size )
+{
+    const uint32 rate = AtomicLoad( &sSampleRate );
+    if( 0 == rate || 0 != AtomicAdd( &sSampleCounter, 1 ) % rate )
+        return;
+
+    SampledAllocation sample;
+    sample.tag = this;
+    sample.size = size;
+#ifndef WIN32
+    const int depth = backtrace( sample.frames, MAX_FRAMES );
+    sample.depth = ( 0 < depth ? depth : 0 );
+#else /* WIN32 */
+    sample.depth = CaptureStackBackTrace( 0, MAX_FRAMES, sample.frames, NULL );
+#endif /* WIN32 */
+
+    MutexLock lock( sSamplesMutex );
+
+    if( sSamples.insert( std::make_pair( p, sample ) ).second )
+        AtomicAdd( &sLiveSamples, 1 );
+}
+
+void MemoryTag::_Unsample( void* p )
+{
+    MutexLock lock( sSamplesMutex );
+
+    if( 0 < sSamples.erase( p ) )
+        AtomicAdd( &sLiveSamples, -(uint32)1 );
+}
@@ -0,0 +1,296 @@
+/*
+    ------------------------------------------------------------------------------------
+    LICENSE:
+    ------------------------------------------------------------------------------------
+    This file is part of EVEmu: EVE Online Server Emulator
+    Copyright 2006 - 2011 The EVEmu Team
+    For the latest information visit http://evemu.org
+    ------------------------------------------------------------------------------------
+    This program is free software; you can redistribute it and/or modify it under
+    the terms of the GNU Lesser General Public License as published by the Free Software
+    Foundation; either version 2 of the License, or (at your option) any later
+    version.
+
+    This program is distributed in the hope that it will be useful, but WITHOUT
+    ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+    FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public License along with
+    this program; if not, write to the Free Software Foundation, Inc., 59 Temple
+    Place - Suite 330, Boston, MA 02111-1307, USA, or go to
+    http://www.gnu.org/copyleft/lesser.txt.
+    ------------------------------------------------------------------------------------
+    Author:     EVEmu Team
+*/
+
+
+#include "eve-core.h"
+
+#include "utils/Metrics.h"
+
+/// Bounds (in microseconds) of the buckets of LatencyHistogram().
+static const uint64 LATENCY_BOUNDS[] =
+{
+    100, 250, 500, 1000, 2500, 5000, 10000, 25000, 50000,
+    100000, 250000, 500000, 1000000, 2500000, 10000000
+};
+
+/// Shard of the calling thread; 0 until assigned.
+static THREAD_LOCAL uint32 sShard = 0;
+/// Number of shards assigned so far.
+static volatile uint32 sShardsAssigned = 0;
+
+/*************************************************************************/
+/* Metric                                                                */
+/*************************************************************************/
+uint32 Metric::_GetShard()
+{
+    // assign the threads to the shards round-robin, 1-based
+    if( 0 == sShard )
+        sShard = AtomicAdd( &sShardsAssigned, 1 ) % SHARD_COUNT + 1;
+
+    return sShard - 1;
+}
+
+void Metric::_RenderSample( const std::string& name, const std::string& labels, const char* value, std::string& into )
+{
+    into += name;
+    if( !labels.empty() )
+    {
+        into += '{';
+        into += labels;
+        into += '}';
+    }
+    into += ' ';
+    into += value;
+    into += '\n';
+}
+
+/*************************************************************************/
+/* MetricCounter                                                         */
+/*************************************************************************/
+MetricCounter::MetricCounter()
+{
+    for( uint32 i = 0; i < SHARD_COUNT; ++i )
+        mShards[ i ].value = 0;
+}
+
+uint64 MetricCounter::Get() const
+{
+    uint64 value = 0;
+    for( uint32 i = 0; i < SHARD_COUNT; ++i )
+        value += AtomicLoad64( &mShards[ i ].value );
+
+    return value;
+}
+
+void MetricCounter::Render( const std::string& name, const std::string& labels, std::string& into ) const
+{
+    char value[ 32 ];
+    snprintf( value, sizeof( value ), "%" PRIu64, Get() );
+
+    _RenderSample( name, labels, value, into );
+}
+
+/*************************************************************************/
+/* MetricGauge                                                           */
+/*************************************************************************/
+void MetricGauge::Render( const std::string& name, const std::string& labels, std::string& into ) const
+{
+    char value[ 32 ];
+    snprintf( value, sizeof( value ), "%" PRId64, Get() );
+
+    _RenderSample( name, labels, value, into );
+}
+
+/*************************************************************************/
+/* MetricHistogram                                                       */
+/*************************************************************************/
+MetricHistogram::MetricHistogram( const std::vector< uint64 >& bounds, double scale )
+: mBounds( bounds ),
+  mScale( scale ),
+  // the buckets, the larger values and the sum, rounded up to whole cache lines
+  mStride( ( ( (uint32)bounds.size() + 2 + 7 ) / 8 ) * 8 ),
+  mCells( new uint64[ SHARD_COUNT * mStride ] )
+{
+    for( uint32 i = 0; i < SHARD_COUNT * mStride; ++i )
+        mCells[ i ] = 0;
+}
+
+MetricHistogram::~MetricHistogram()
+{
+    delete[] mCells;
+}
+
+void MetricHistogram::Observe( uint64 value )
+{
+    volatile uint64* shard = &mCells[ _GetShard() * mStride ];
+
+    size_t bucket = 0;
+    while( bucket < mBounds.size() && mBounds[ bucket ] < value )
+        ++bucket;
+
+    AtomicAdd64( &shard[ bucket ], 1 );
+    AtomicAdd64( &shard[ mBounds.size() + 1 ], value );
+}
+
+void MetricHistogram::Render( const std::string& name, const std::string& labels, std::string& into ) const
+{
+    const size_t bucketCount = mBounds.size() + 1;
+
+    // add up the shards
+    std::vector< uint64 > counts( bucketCount + 1, 0 );
+    for( uint32 i = 0; i < SHARD_COUNT; ++i )
+    {
+        const volatile uint64* shard = &mCells[ i * mStride ];
+
+        for( size_t j = 0; j <= bucketCount; ++j )
+            counts[ j ] += AtomicLoad64( &shard[ j ] );
+    }
+
+    const std::string bucketName = name + "_bucket";
+    const std::string separator = ( labels.empty() ? "" : "," );
+
+    char value[ 64 ];
+    uint64 total = 0;
+    for( size_t i = 0; i < bucketCount; ++i )
+    {
+        // the buckets are cumulative
+        total += counts[ i ];
+
+        if( i < mBounds.size() )
+            snprintf( value, sizeof( value ), "le=\"%g\"", (double)mBounds[ i ] / mScale );
+        else
+            snprintf( value, sizeof( value ), "le=\"+Inf\"" );
+        const std::string bucketLabels = labels + separator + value;
+
+        snprintf( value, sizeof( value ), "%" PRIu64, total );
+        _RenderSample( bucketName, bucketLabels, value, into );
+    }
+
+    snprintf( value, sizeof( value ), "%g", (double)counts[ bucketCount ] / mScale );
+    _RenderSample( name + "_sum", labels, value, into );
+
+    snprintf( value, sizeof( value ), "%" PRIu64, total );
+    _RenderSample( name + "_count", labels, value, into );
+}
+
+/*************************************************************************/
+/* MetricRegistry                                                        */
+/*************************************************************************/
+MetricRegistry::MetricRegistry()
+{
+}
+
+MetricRegistry::~MetricRegistry()
+{
+    std::map< std::string, Family >::iterator cur, end;
+    cur = mFamilies.begin();
+    end = mFamilies.end();
+    for(; cur != end; ++cur )
+    {
+        std::map< std::string, Metric* >::iterator curm, endm;
+        curm = cur->second.metrics.begin();
+        endm = cur->second.metrics.end();
+        for(; curm != endm; ++curm )
+            SafeDelete( curm->second );
+    }
+}
+
+MetricCounter& MetricRegistry::Counter( const char* name, const char* help, const char* labels )
+{
+    MutexLock lock( mMutex );
+
+    Metric* metric = _Find( name, help, Metric::METRIC_COUNTER, labels );
+    if( NULL == metric )
+    {
+        metric = new MetricCounter;
+        _Add( name, labels, metric );
+    }
+
+    return *static_cast< MetricCounter* >( metric );
+}
+
+MetricGauge& MetricRegistry::Gauge( const char* name, const char* help, const char* labels )
+{
+    MutexLock lock( mMutex );
+
+    Metric* metric = _Find( name, help, Metric::METRIC_GAUGE, labels );
+    if( NULL == metric )
+    {
+        metric = new MetricGauge;
+        _Add( name, labels, metric );
+    }
+
+    return *static_cast< MetricGauge* >( metric );
+}
+
+MetricHistogram& MetricRegistry::Histogram( const char* name, const char* help, const std::vector< uint64 >& bounds, double scale, const char* labels )
+{
+    MutexLock lock( mMutex );
+
+    Metric* metric = _Find( name, help, Metric::METRIC_HISTOGRAM, labels );
+    if( NULL == metric )
+    {
+        metric = new MetricHistogram( bounds, scale );
+        _Add( name, labels, metric );
+    }
+
+    return *static_cast< MetricHistogram* >( metric );
+}
+
+MetricHistogram& MetricRegistry::LatencyHistogram( const char* name, const char* help, const char* labels )
+{
+    const std::vector< uint64 > bounds( LATENCY_BOUNDS, LATENCY_BOUNDS + sizeof( LATENCY_BOUNDS ) / sizeof( *LATENCY_BOUNDS ) );
+
+    return Histogram( name, help, bounds, 1e6, labels );
+}
+
+void MetricRegistry::Render( std::string& into )
+{
+    static const char* const TYPE_NAMES[] = { "counter", "gauge", "histogram" };
+
+    MutexLock lock( mMutex );
+
+    std::map< std::string, Family >::const_iterator cur, end;
+    cur = mFamilies.begin();
+    end = mFamilies.end();
+    for(; cur != end; ++cur )
+    {
+        into += "# HELP " + cur->first + " " + cur->second.help + "\n";
+        into += "# TYPE " + cur->first + " " + TYPE_NAMES[ cur->second.type ] + "\n";
+
+        std::map< std::string, Metric* >::const_iterator curm, endm;
+        curm = cur->second.metrics.begin();
+        endm = cur->second.metrics.end();
+        for(; curm != endm; ++curm )
+            curm->second->Render( cur->first, curm->first, into );
+    }
+}
+
+Metric* MetricRegistry::_Find( const char* name, const char* help, Metric::Type type, const char* labels )
+{
+    std::map< std::string, Family >::iterator res = mFamilies.find( name );
+    if( mFamilies.end() == res )
+    {
+        Family& family = mFamilies[ name ];
+        family.type = type;
+        family.help = help;
+
+        return NULL;
+    }
+
+    // a name is always registered as the same type
+    assert( type == res->second.type );
+
+    std::map< std::string, Metric* >::iterator resm = res->second.metrics.find( labels );
+    if( res->second.metrics.end() == resm )
+        return NULL;
+
+    return resm->second;
+}
+
+void MetricRegistry::_Add( const char* name, const char* labels, Metric* metric )
+{
+    mFamilies[ name ].metrics[ labels ] = metric;
+}
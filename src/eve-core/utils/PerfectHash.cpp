@@ -0,0 +1,178 @@
+/*
+    ------------------------------------------------------------------------------------
+    LICENSE:
+    ------------------------------------------------------------------------------------
+    This file is part of EVEmu: EVE Online Server Emulator
+    Copyright 2006 - 2011 The EVEmu Team
+    For the latest information visit http://evemu.org
+    ------------------------------------------------------------------------------------
+    This program is free software; you can redistribute it and/or modify it under
+    the terms of the GNU Lesser General Public License as published by the Free Software
+    Foundation; either version 2 of the License, or (at your option) any later
+    version.
+
+    This program is distributed in the hope that it will be useful, but WITHOUT
+    ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+    FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public License along with
+    this program; if not, write to the Free Software Foundation, Inc., 59 Temple
+    Place - Suite 330, Boston, MA 02111-1307, USA, or go to
+    http://www.gnu.org/copyleft/lesser.txt.
+    ------------------------------------------------------------------------------------
+    Author:     EVEmu Team
+*/
+
+#include "eve-core.h"
+
+#include "utils/PerfectHash.h"
+
+/// Number of seeds tried for a bucket before the table is enlarged.
+static const uint32 PERFECTHASH_MAX_SEEDS = 0x1000;
+
+/**
+ * @brief Orders buckets by their size, largest first.
+ */
+struct PerfectHashBucketOrder
+{
+    PerfectHashBucketOrder( const std::vector< std::vector<uint32> >& buckets ) : mBuckets( buckets ) {}
+
+    bool operator()( uint32 a, uint32 b ) const { return mBuckets[ a ].size() > mBuckets[ b ].size(); }
+
+    const std::vector< std::vector<uint32> >& mBuckets;
+};
+
+/*************************************************************************/
+/* PerfectHash                                                           */
+/*************************************************************************/
+const uint32 PerfectHash::INVALID_INDEX = 0xFFFFFFFF;
+
+PerfectHash::PerfectHash()
+{
+}
+
+bool PerfectHash::Build( const std::vector<std::string>& keys )
+{
+    Clear();
+
+    if( keys.empty() )
+        return true;
+
+    // duplicates can never be separated
+    if( std::set<std::string>( keys.begin(), keys.end() ).size() != keys.size() )
+        return false;
+
+    const uint32 bucketCount = keys.size();
+
+    // spread the keys into buckets
+    std::vector< std::vector<uint32> > buckets( bucketCount );
+    for( uint32 i = 0; i < keys.size(); ++i )
+        buckets[ _Hash( 0, keys[ i ] ) % bucketCount ].push_back( i );
+
+    // place the crowded buckets first while there is plenty of room
+    std::vector<uint32> order( bucketCount );
+    for( uint32 i = 0; i < bucketCount; ++i )
+        order[ i ] = i;
+    std::stable_sort( order.begin(), order.end(), PerfectHashBucketOrder( buckets ) );
+
+    // start at load factor of at most 1/2
+    uint32 slotCount = 1;
+    while( slotCount < 2 * keys.size() )
+        slotCount <<= 1;
+
+    while( true )
+    {
+        std::vector<uint32> seeds( bucketCount, 0 );
+        std::vector<uint32> slots( slotCount, INVALID_INDEX );
+        bool placed = true;
+
+        for( uint32 i = 0; placed && i < bucketCount; ++i )
+        {
+            const std::vector<uint32>& bucket = buckets[ order[ i ] ];
+            if( bucket.empty() )
+                break;
+
+            placed = false;
+            for( uint32 seed = 1; !placed && seed < PERFECTHASH_MAX_SEEDS; ++seed )
+            {
+                std::vector<uint32> taken;
+                taken.reserve( bucket.size() );
+
+                placed = true;
+                for( size_t j = 0; placed && j < bucket.size(); ++j )
+                {
+                    const uint32 slot = _Hash( seed, keys[ bucket[ j ] ] ) & ( slotCount - 1 );
+
+                    if( INVALID_INDEX != slots[ slot ]
+                        || taken.end() != std::find( taken.begin(), taken.end(), slot ) )
+                        placed = false;
+                    else
+                        taken.push_back( slot );
+                }
+
+                if( placed )
+                {
+                    seeds[ order[ i ] ] = seed;
+                    for( size_t j = 0; j < bucket.size(); ++j )
+                        slots[ taken[ j ] ] = bucket[ j ];
+                }
+            }
+        }
+
+        if( placed )
+        {
+            mKeys = keys;
+            mSeeds.swap( seeds );
+            mSlots.swap( slots );
+            return true;
+        }
+
+        // unlucky, retry with more room
+        slotCount <<= 1;
+    }
+}
+
+void PerfectHash::Clear()
+{
+    mKeys.clear();
+    mSeeds.clear();
+    mSlots.clear();
+}
+
+uint32 PerfectHash::Find( const std::string& key ) const
+{
+    if( mKeys.empty() )
+        return INVALID_INDEX;
+
+    const uint32 seed = mSeeds[ _Hash( 0, key ) % mSeeds.size() ];
+    const uint32 index = mSlots[ _Hash( seed, key ) & ( mSlots.size() - 1 ) ];
+
+    if( INVALID_INDEX == index || mKeys[ index ] != key )
+        return INVALID_INDEX;
+
+    return index;
+}
+
+uint32 PerfectHash::_Hash( uint32 seed, const std::string& key )
+{
+    // FNV-1a, seeded
+    uint32 h = 2166136261u ^ ( seed * 0x9E3779B9u );
+
+    std::string::const_iterator cur, end;
+    cur = key.begin();
+    end = key.end();
+    for(; cur != end; ++cur )
+    {
+        h ^= (uint8)*cur;
+        h *= 16777619u;
+    }
+
+    // FNV is weak in its low bits, mix them up
+    h ^= h >> 16;
+    h *= 0x85EBCA6Bu;
+    h ^= h >> 13;
+    h *= 0xC2B2AE35u;
+    h ^= h >> 16;
+
+    return h;
+}
@@ -0,0 +1,199 @@
+/*
+    ------------------------------------------------------------------------------------
+    LICENSE:
+    ------------------------------------------------------------------------------------
+    This file is part of EVEmu: EVE Online Server Emulator
+    Copyright 2006 - 2011 The EVEmu Team
+    For the latest information visit http://evemu.org
+    ------------------------------------------------------------------------------------
+    This program is free software; you can redistribute it and/or modify it under
+    the terms of the GNU Lesser General Public License as published by the Free Software
+    Foundation; either version 2 of the License, or (at your option) any later
+    version.
+
+    This program is distributed in the hope that it will be useful, but WITHOUT
+    ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+    FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public License along with
+    this program; if not, write to the Free Software Foundation, Inc., 59 Temple
+    Place - Suite 330, Boston, MA 02111-1307, USA, or go to
+    http://www.gnu.org/copyleft/lesser.txt.
+    ------------------------------------------------------------------------------------
+    Author:     EVEmu Team
+*/
+
+
+#include "eve-core.h"
+
+#include "utils/PointBatch.h"
+
+#if defined( __AVX__ )
+#   include <immintrin.h>
+#   define POINT_BATCH_AVX
+#elif defined( __SSE2__ ) || defined( _M_X64 ) || ( defined( _M_IX86_FP ) && 2 <= _M_IX86_FP )
+#   include <emmintrin.h>
+#   define POINT_BATCH_SSE2
+#elif defined( __aarch64__ )
+#   include <arm_neon.h>
+#   define POINT_BATCH_NEON
+#endif
+
+/*************************************************************************/
+/* PointBatch                                                            */
+/*************************************************************************/
+void PointBatch::clear()
+{
+    mX.clear();
+    mY.clear();
+    mZ.clear();
+}
+
+void PointBatch::reserve( size_t count )
+{
+    mX.reserve( count );
+    mY.reserve( count );
+    mZ.reserve( count );
+}
+
+size_t PointBatch::Add( const GPoint& point )
+{
+    mX.push_back( point.x );
+    mY.push_back( point.y );
+    mZ.push_back( point.z );
+
+    return mX.size() - 1;
+}
+
+void PointBatch::Set( size_t index, const GPoint& point )
+{
+    mX[ index ] = point.x;
+    mY[ index ] = point.y;
+    mZ[ index ] = point.z;
+}
+
+void PointBatch::Remove( size_t index )
+{
+    mX.erase( mX.begin() + index );
+    mY.erase( mY.begin() + index );
+    mZ.erase( mZ.begin() + index );
+}
+
+void PointBatch::DistanceSquared( const GPoint& from, double* into ) const
+{
+    const size_t count = size();
+    const double* x = count ? &mX[ 0 ] : NULL;
+    const double* y = count ? &mY[ 0 ] : NULL;
+    const double* z = count ? &mZ[ 0 ] : NULL;
+    size_t i = 0;
+
+#if defined( POINT_BATCH_AVX )
+    const __m256d fx = _mm256_set1_pd( from.x ), fy = _mm256_set1_pd( from.y ), fz = _mm256_set1_pd( from.z );
+    for(; i + 4 <= count; i += 4 )
+    {
+        const __m256d dx = _mm256_sub_pd( _mm256_loadu_pd( x + i ), fx );
+        const __m256d dy = _mm256_sub_pd( _mm256_loadu_pd( y + i ), fy );
+        const __m256d dz = _mm256_sub_pd( _mm256_loadu_pd( z + i ), fz );
+        _mm256_storeu_pd( into + i, _mm256_add_pd( _mm256_add_pd( _mm256_mul_pd( dx, dx ), _mm256_mul_pd( dy, dy ) ), _mm256_mul_pd( dz, dz ) ) );
+    }
+#elif defined( POINT_BATCH_SSE2 )
+    const __m128d fx = _mm_set1_pd( from.x ), fy = _mm_set1_pd( from.y ), fz = _mm_set1_pd( from.z );
+    for(; i + 2 <= count; i += 2 )
+    {
+        const __m128d dx = _mm_sub_pd( _mm_loadu_pd( x + i ), fx );
+        const __m128d dy = _mm_sub_pd( _mm_loadu_pd( y + i ), fy );
+        const __m128d dz = _mm_sub_pd( _mm_loadu_pd( z + i ), fz );
+        _mm_storeu_pd( into + i, _mm_add_pd( _mm_add_pd( _mm_mul_pd( dx, dx ), _mm_mul_pd( dy, dy ) ), _mm_mul_pd( dz, dz ) ) );
+    }
+#elif defined( POINT_BATCH_NEON )
+    const float64x2_t fx = vdupq_n_f64( from.x ), fy = vdupq_n_f64( from.y ), fz = vdupq_n_f64( from.z );
+    for(; i + 2 <= count; i += 2 )
+    {
+        const float64x2_t dx = vsubq_f64( vld1q_f64( x + i ), fx );
+        const float64x2_t dy = vsubq_f64( vld1q_f64( y + i ), fy );
+        const float64x2_t dz = vsubq_f64( vld1q_f64( z + i ), fz );
+        // no fused multiply-add, the results must match the scalar ones
+        vst1q_f64( into + i, vaddq_f64( vaddq_f64( vmulq_f64( dx, dx ), vmulq_f64( dy, dy ) ), vmulq_f64( dz, dz ) ) );
+    }
+#endif
+
+    for(; i < count; ++i )
+    {
+        const double dx = x[ i ] - from.x;
+        const double dy = y[ i ] - from.y;
+        const double dz = z[ i ] - from.z;
+        into[ i ] = dx * dx + dy * dy + dz * dz;
+    }
+}
+
+size_t PointBatch::FindInRange( const GPoint& from, double range, std::vector< uint32 >& into ) const
+{
+    const size_t count = size();
+    const double* x = count ? &mX[ 0 ] : NULL;
+    const double* y = count ? &mY[ 0 ] : NULL;
+    const double* z = count ? &mZ[ 0 ] : NULL;
+    const double range2 = range * range;
+    const size_t found = into.size();
+    size_t i = 0;
+
+#if defined( POINT_BATCH_AVX )
+    const __m256d fx = _mm256_set1_pd( from.x ), fy = _mm256_set1_pd( from.y ), fz = _mm256_set1_pd( from.z );
+    const __m256d r2 = _mm256_set1_pd( range2 );
+    for(; i + 4 <= count; i += 4 )
+    {
+        const __m256d dx = _mm256_sub_pd( _mm256_loadu_pd( x + i ), fx );
+        const __m256d dy = _mm256_sub_pd( _mm256_loadu_pd( y + i ), fy );
+        const __m256d dz = _mm256_sub_pd( _mm256_loadu_pd( z + i ), fz );
+        const __m256d d2 = _mm256_add_pd( _mm256_add_pd( _mm256_mul_pd( dx, dx ), _mm256_mul_pd( dy, dy ) ), _mm256_mul_pd( dz, dz ) );
+
+        // bit j is set if the point i + j is within range
+        for( int mask = _mm256_movemask_pd( _mm256_cmp_pd( d2, r2, _CMP_LE_OQ ) ), j = 0; 0 != mask; mask >>= 1, ++j )
+            if( mask & 1 )
+                into.push_back( (uint32)( i + j ) );
+    }
+#elif defined( POINT_BATCH_SSE2 )
+    const __m128d fx = _mm_set1_pd( from.x ), fy = _mm_set1_pd( from.y ), fz = _mm_set1_pd( from.z );
+    const __m128d r2 = _mm_set1_pd( range2 );
+    for(; i + 2 <= count; i += 2 )
+    {
+        const __m128d dx = _mm_sub_pd( _mm_loadu_pd( x + i ), fx );
+        const __m128d dy = _mm_sub_pd( _mm_loadu_pd( y + i ), fy );
+        const __m128d dz = _mm_sub_pd( _mm_loadu_pd( z + i ), fz );
+        const __m128d d2 = _mm_add_pd( _mm_add_pd( _mm_mul_pd( dx, dx ), _mm_mul_pd( dy, dy ) ), _mm_mul_pd( dz, dz ) );
+
+        // bit j is set if the point i + j is within range
+        const int mask = _mm_movemask_pd( _mm_cmple_pd( d2, r2 ) );
+        if( mask & 1 )
+            into.push_back( (uint32)i );
+        if( mask & 2 )
+            into.push_back( (uint32)( i + 1 ) );
+    }
+#elif defined( POINT_BATCH_NEON )
+    const float64x2_t fx = vdupq_n_f64( from.x ), fy = vdupq_n_f64( from.y ), fz = vdupq_n_f64( from.z );
+    const float64x2_t r2 = vdupq_n_f64( range2 );
+    for(; i + 2 <= count; i += 2 )
+    {
+        const float64x2_t dx = vsubq_f64( vld1q_f64( x + i ), fx );
+        const float64x2_t dy = vsubq_f64( vld1q_f64( y + i ), fy );
+        const float64x2_t dz = vsubq_f64( vld1q_f64( z + i ), fz );
+        const float64x2_t d2 = vaddq_f64( vaddq_f64( vmulq_f64( dx, dx ), vmulq_f64( dy, dy ) ), vmulq_f64( dz, dz ) );
+
+        const uint64x2_t within = vcleq_f64( d2, r2 );
+        if( 0 != vgetq_lane_u64( within, 0 ) )
+            into.push_back( (uint32)i );
+        if( 0 != vgetq_lane_u64( within, 1 ) )
+            into.push_back( (uint32)( i + 1 ) );
+    }
+#endif
+
+    for(; i < count; ++i )
+    {
+        const double dx = x[ i ] - from.x;
+        const double dy = y[ i ] - from.y;
+        const double dz = z[ i ] - from.z;
+        if( dx * dx + dy * dy + dz * dz <= range2 )
+            into.push_back( (uint32)i );
+    }
+
+    return into.size() - found;
+}
@@ -0,0 +1,121 @@
+/*
+    ------------------------------------------------------------------------------------
+    LICENSE:
+    ------------------------------------------------------------------------------------
+    This file is part of EVEmu: EVE Online Server Emulator
+    Copyright 2006 - 2011 The EVEmu Team
+    For the latest information visit http://evemu.org
+    ------------------------------------------------------------------------------------
+    This program is free software; you can redistribute it and/or modify it under
+    the terms of the GNU Lesser General Public License as published by the Free Software
+    Foundation; either version 2 of the License, or (at your option) any later
+    version.
+
+    This program is distributed in the hope that it will be useful, but WITHOUT
+    ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+    FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public License along with
+    this program; if not, write to the Free Software Foundation, Inc., 59 Temple
+    Place - Suite 330, Boston, MA 02111-1307, USA, or go to
+    http://www.gnu.org/copyleft/lesser.txt.
+    ------------------------------------------------------------------------------------
+    Author:     EVEmu Team
+*/
+
+#include "eve-core.h"
+
+#include "utils/SizeClassPool.h"
+
+/// Number of size classes.
+static const size_t CLASS_COUNT = SizeClassPool::MAX_SIZE / SizeClassPool::GRANULARITY;
+
+/// Free block, links to the next one.
+struct FreeBlock
+{
+    FreeBlock* next;
+};
+
+/* The free lists and statistics of the thread. Plain data only, as
+   thread-local variables may not have constructors. */
+static THREAD_LOCAL FreeBlock* sFreeLists[ CLASS_COUNT ];
+static THREAD_LOCAL size_t sFreeCounts[ CLASS_COUNT ];
+static THREAD_LOCAL uint64 sAllocations;
+static THREAD_LOCAL uint64 sPoolHits;
+static THREAD_LOCAL uint64 sFrees;
+static THREAD_LOCAL uint64 sPoolReturns;
+
+/* Maps size to index of its class; the block is allocated as big as the class. */
+static inline size_t GetClass( size_t size )
+{
+    return ( 0 == size ? 0 : ( size - 1 ) / SizeClassPool::GRANULARITY );
+}
+
+void* SizeClassPool::Allocate( size_t size )
+{
+    ++sAllocations;
+
+    if( MAX_SIZE < size )
+        return ::operator new( size );
+
+    const size_t c = GetClass( size );
+
+    FreeBlock* block = sFreeLists[ c ];
+    if( NULL != block )
+    {
+        sFreeLists[ c ] = block->next;
+        --sFreeCounts[ c ];
+
+        ++sPoolHits;
+        return block;
+    }
+
+    return ::operator new( ( c + 1 ) * GRANULARITY );
+}
+
+void SizeClassPool::Free( void* p, size_t size )
+{
+    if( NULL == p )
+        return;
+
+    ++sFrees;
+
+    if( MAX_SIZE < size )
+    {
+        ::operator delete( p );
+        return;
+    }
+
+    const size_t c = GetClass( size );
+    if( MAX_CACHED <= sFreeCounts[ c ] )
+    {
+        ::operator delete( p );
+        return;
+    }
+
+    FreeBlock* block = static_cast<FreeBlock*>( p );
+    block->next = sFreeLists[ c ];
+    sFreeLists[ c ] = block;
+    ++sFreeCounts[ c ];
+
+    ++sPoolReturns;
+}
+
+SizeClassPool::Stats SizeClassPool::GetStats()
+{
+    Stats stats;
+    stats.allocations = sAllocations;
+    stats.poolHits = sPoolHits;
+    stats.frees = sFrees;
+    stats.poolReturns = sPoolReturns;
+
+    return stats;
+}
+
+void SizeClassPool::ResetStats()
+{
+    sAllocations = 0;
+    sPoolHits = 0;
+    sFrees = 0;
+    sPoolReturns = 0;
+}
@@ -0,0 +1,276 @@
+/*
+    ------------------------------------------------------------------------------------
+    LICENSE:
+    ------------------------------------------------------------------------------------
+    This file is part of EVEmu: EVE Online Server Emulator
+    Copyright 2006 - 2011 The EVEmu Team
+    For the latest information visit http://evemu.org
+    ------------------------------------------------------------------------------------
+    This program is free software; you can redistribute it and/or modify it under
+    the terms of the GNU Lesser General Public License as published by the Free Software
+    Foundation; either version 2 of the License, or (at your option) any later
+    version.
+
+    This program is distributed in the hope that it will be useful, but WITHOUT
+    ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+    FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public License along with
+    this program; if not, write to the Free Software Foundation, Inc., 59 Temple
+    Place - Suite 330, Boston, MA 02111-1307, USA, or go to
+    http://www.gnu.org/copyleft/lesser.txt.
+    ------------------------------------------------------------------------------------
+    Author:     EVEmu Team
+*/
+
+#include "eve-core.h"
+
+#include "log/LogNew.h"
+#include "utils/TickProfiler.h"
+#include "utils/utils_time.h"
+
+/// The tick the calling thread records the zones of; NULL if none.
+static THREAD_LOCAL TickProfiler::Tick* sTick = NULL;
+/// When the recorded tick began.
+static THREAD_LOCAL uint64 sTickStart = 0;
+/// Depth of the next zone entered.
+static THREAD_LOCAL uint16 sDepth = 0;
+
+/*************************************************************************/
+/* TickProfiler                                                          */
+/*************************************************************************/
+TickProfiler::TickProfiler()
+: mEnabled( false ),
+  mThreshold( 0 ),
+  mHistory( 0 ),
+  mStart( 0 ),
+  mNextNumber( 0 ),
+  mFastest( 0 )
+{
+}
+
+void TickProfiler::Configure( bool enabled, uint32 threshold, size_t history )
+{
+    mEnabled = enabled;
+    mThreshold = threshold * 1000;
+    mHistory = history;
+
+    if( mHistory < mSlowest.size() )
+        Reset();
+
+    mCurrent.zones.reserve( MAX_ZONES );
+}
+
+void TickProfiler::BeginTick()
+{
+    if( !mEnabled )
+        return;
+
+    mCurrent.number = mNextNumber++;
+    mCurrent.when = time( NULL );
+    mCurrent.duration = 0;
+    mCurrent.dropped = 0;
+    mCurrent.zones.clear();
+
+    mStart = GetTimeUSeconds();
+
+    sTick = &mCurrent;
+    sTickStart = mStart;
+    sDepth = 0;
+}
+
+void TickProfiler::EndTick()
+{
+    if( NULL == sTick )
+        return;
+    sTick = NULL;
+
+    mCurrent.duration = (uint32)( GetTimeUSeconds() - mStart );
+
+    ++mStats.ticks;
+    mStats.zones += (uint32)mCurrent.zones.size();
+    mStats.droppedZones += mCurrent.dropped;
+    if( mStats.maxTickTime < mCurrent.duration )
+        mStats.maxTickTime = mCurrent.duration;
+
+    if( 0 < mThreshold && mThreshold <= mCurrent.duration )
+    {
+        ++mStats.slowTicks;
+
+        sLog.Warning( "Tick Profiler", "Tick %u took %.2f ms:", mCurrent.number, mCurrent.duration / 1000.0 );
+        _LogTick( mCurrent );
+    }
+
+    // keep the tick if it is one of the slowest, swapping the zones
+    // so that the buffers are reused instead of copied
+    if( mSlowest.size() < mHistory )
+    {
+        mSlowest.push_back( Tick() );
+        Tick& kept = mSlowest.back();
+
+        kept.number = mCurrent.number;
+        kept.when = mCurrent.when;
+        kept.duration = mCurrent.duration;
+        kept.dropped = mCurrent.dropped;
+        kept.zones.swap( mCurrent.zones );
+
+        _FindFastest();
+    }
+    else if( 0 < mHistory && mSlowest[ mFastest ].duration < mCurrent.duration )
+    {
+        Tick& kept = mSlowest[ mFastest ];
+
+        kept.number = mCurrent.number;
+        kept.when = mCurrent.when;
+        kept.duration = mCurrent.duration;
+        kept.dropped = mCurrent.dropped;
+        kept.zones.swap( mCurrent.zones );
+
+        _FindFastest();
+    }
+
+    if( mCurrent.zones.capacity() < MAX_ZONES )
+        mCurrent.zones.reserve( MAX_ZONES );
+}
+
+size_t TickProfiler::Dump( size_t count, std::string& summary ) const
+{
+    // slowest first
+    std::vector< std::pair< uint32, size_t > > order;
+    for( size_t i = 0; i < mSlowest.size(); ++i )
+        order.push_back( std::make_pair( mSlowest[ i ].duration, i ) );
+    std::sort( order.rbegin(), order.rend() );
+
+    if( count < order.size() )
+        order.resize( count );
+
+    for( size_t i = 0; i < order.size(); ++i )
+    {
+        const Tick& tick = mSlowest[ order[ i ].second ];
+
+        // the slowest zone of the loop itself
+        const Zone* slowest = NULL;
+        for( size_t j = 0; j < tick.zones.size(); ++j )
+        {
+            const Zone& zone = tick.zones[ j ];
+            if( 0 == zone.depth && ( NULL == slowest || slowest->duration < zone.duration ) )
+                slowest = &zone;
+        }
+
+        tm t;
+        localtime_r( &tick.when, &t );
+
+        char line[256];
+        if( NULL != slowest )
+            snprintf( line, sizeof( line ), "Tick %u at %02d:%02d:%02d: %.2f ms, %lu zones; slowest %s %.2f ms",
+                      tick.number, t.tm_hour, t.tm_min, t.tm_sec, tick.duration / 1000.0, (unsigned long)tick.zones.size(),
+                      slowest->name, slowest->duration / 1000.0 );
+        else
+            snprintf( line, sizeof( line ), "Tick %u at %02d:%02d:%02d: %.2f ms, no zones",
+                      tick.number, t.tm_hour, t.tm_min, t.tm_sec, tick.duration / 1000.0 );
+
+        sLog.Log( "Tick Profiler", "%s:", line );
+        _LogTick( tick );
+
+        if( !summary.empty() )
+            summary += "\n";
+        summary += line;
+    }
+
+    return order.size();
+}
+
+void TickProfiler::Reset()
+{
+    mSlowest.clear();
+    mFastest = 0;
+}
+
+size_t TickProfiler::Enter( const char* name, const char* detail, size_t length )
+{
+    Tick* tick = sTick;
+    if( NULL == tick )
+        return NO_ZONE;
+
+    if( MAX_ZONES <= tick->zones.size() )
+    {
+        ++tick->dropped;
+        return NO_ZONE;
+    }
+
+    tick->zones.push_back( Zone() );
+    Zone& zone = tick->zones.back();
+
+    zone.name = name;
+    zone.depth = sDepth++;
+    zone.duration = 0;
+
+    if( NULL == detail )
+        length = 0;
+    else if( (size_t)-1 == length )
+        length = strlen( detail );
+    if( DETAIL_SIZE <= length )
+        length = DETAIL_SIZE - 1;
+    memcpy( zone.detail, detail, length );
+    zone.detail[ length ] = '\0';
+
+    zone.start = (uint32)( GetTimeUSeconds() - sTickStart );
+
+    return tick->zones.size() - 1;
+}
+
+void TickProfiler::Leave( size_t zone )
+{
+    Tick* tick = sTick;
+    if( NO_ZONE == zone || NULL == tick || tick->zones.size() <= zone )
+        return;
+
+    Zone& z = tick->zones[ zone ];
+    z.duration = (uint32)( GetTimeUSeconds() - sTickStart ) - z.start;
+
+    sDepth = z.depth;
+}
+
+void TickProfiler::_LogTick( const Tick& tick )
+{
+    for( size_t i = 0; i < tick.zones.size(); ++i )
+    {
+        const Zone& zone = tick.zones[ i ];
+
+        if( '\0' != zone.detail[0] )
+            sLog.Log( "Tick Profiler", "%*s%s (%s): %.2f ms at +%.2f ms", 2 * ( zone.depth + 1 ), "",
+                      zone.name, zone.detail, zone.duration / 1000.0, zone.start / 1000.0 );
+        else
+            sLog.Log( "Tick Profiler", "%*s%s: %.2f ms at +%.2f ms", 2 * ( zone.depth + 1 ), "",
+                      zone.name, zone.duration / 1000.0, zone.start / 1000.0 );
+    }
+
+    if( 0 < tick.dropped )
+        sLog.Log( "Tick Profiler", "  (%u more zones not recorded)", tick.dropped );
+}
+
+void TickProfiler::_FindFastest()
+{
+    mFastest = 0;
+    for( size_t i = 1; i < mSlowest.size(); ++i )
+    {
+        if( mSlowest[ i ].duration < mSlowest[ mFastest ].duration )
+            mFastest = i;
+    }
+}
+
+/*************************************************************************/
+/* ProfileZone                                                           */
+/*************************************************************************/
+ProfileZone::ProfileZone( const char* name, uint32 id )
+: mZone( TickProfiler::NO_ZONE )
+{
+    // format the ID only if the zone is recorded
+    if( NULL == sTick )
+        return;
+
+    char detail[16];
+    const int length = snprintf( detail, sizeof( detail ), "%u", id );
+
+    mZone = TickProfiler::Enter( name, detail, length );
+}
@@ -0,0 +1,278 @@
+/*
+    ------------------------------------------------------------------------------------
+    LICENSE:
+    ------------------------------------------------------------------------------------
+    This file is part of EVEmu: EVE Online Server Emulator
+    Copyright 2006 - 2011 The EVEmu Team
+    For the latest information visit http://evemu.org
+    ------------------------------------------------------------------------------------
+    This program is free software; you can redistribute it and/or modify it under
+    the terms of the GNU Lesser General Public License as published by the Free Software
+    Foundation; either version 2 of the License, or (at your option) any later
+    version.
+
+    This program is distributed in the hope that it will be useful, but WITHOUT
+    ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+    FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public License along with
+    this program; if not, write to the Free Software Foundation, Inc., 59 Temple
+    Place - Suite 330, Boston, MA 02111-1307, USA, or go to
+    http://www.gnu.org/copyleft/lesser.txt.
+    ------------------------------------------------------------------------------------
+    Author:     EVEmu Team
+*/
+
+#include "eve-core.h"
+
+#include "log/logsys.h"
+#include "utils/TimerWheel.h"
+
+const uint32 TIMERWHEEL_LATE_THRESHOLD = 100;
+
+/*************************************************************************/
+/* TimerWheel::Callback                                                  */
+/*************************************************************************/
+TimerWheel::Callback::Callback()
+: mTimerWheel( NULL ),
+  mTimerSlot( NULL ),
+  mTimerPrev( NULL ),
+  mTimerNext( NULL ),
+  mTimerExpiry( 0 )
+{
+}
+
+TimerWheel::Callback::~Callback()
+{
+    if( IsTimerScheduled() )
+        mTimerWheel->Cancel( this );
+}
+
+/*************************************************************************/
+/* TimerWheel                                                            */
+/*************************************************************************/
+TimerWheel::TimerWheel( uint32 now )
+: mExpiring( NULL ),
+  mCount( 0 ),
+  mNow( now ),
+  mTime( now )
+{
+    for( uint32 i = 0; i < INNER_SIZE; ++i )
+        mInner[ i ] = NULL;
+
+    for( uint32 w = 0; w < OUTER_COUNT; ++w )
+        for( uint32 i = 0; i < OUTER_SIZE; ++i )
+            mOuter[ w ][ i ] = NULL;
+}
+
+TimerWheel::~TimerWheel()
+{
+    for( uint32 i = 0; i < INNER_SIZE; ++i )
+        while( NULL != mInner[ i ] )
+            Cancel( mInner[ i ] );
+
+    for( uint32 w = 0; w < OUTER_COUNT; ++w )
+        for( uint32 i = 0; i < OUTER_SIZE; ++i )
+            while( NULL != mOuter[ w ][ i ] )
+                Cancel( mOuter[ w ][ i ] );
+}
+
+void TimerWheel::Schedule( Callback* callback, uint32 delay )
+{
+    if( callback->IsTimerScheduled() )
+        callback->mTimerWheel->Cancel( callback );
+
+    // keep the expiry within comparable distance
+    if( 0x7FFFFFFF < delay )
+        delay = 0x7FFFFFFF;
+
+    callback->mTimerWheel = this;
+    callback->mTimerExpiry = mNow + delay;
+    _Insert( callback );
+
+    ++mCount;
+}
+
+void TimerWheel::Cancel( Callback* callback )
+{
+    if( this != callback->mTimerWheel )
+        return;
+
+    _Unlink( callback );
+    callback->mTimerWheel = NULL;
+
+    --mCount;
+}
+
+uint32 TimerWheel::Process( uint32 now )
+{
+    mNow = now;
+
+    uint32 fired = 0;
+    while( 0 <= (int32)( now - mTime ) )
+    {
+        if( 0 == mCount )
+        {
+            // nothing to walk through
+            mTime = now + 1;
+            break;
+        }
+
+        const uint32 index = mTime & INNER_MASK;
+
+        // entering new round of the inner wheel, refill it from the outer ones
+        if( 0 == index )
+        {
+            for( uint32 w = 0; w < OUTER_COUNT; ++w )
+            {
+                const uint32 outer = ( mTime >> ( INNER_BITS + w * OUTER_BITS ) ) & OUTER_MASK;
+                if( 0 != _Cascade( w, outer ) )
+                    break;
+            }
+        }
+
+        // move the bucket aside, so the callbacks may (re)schedule freely
+        mExpiring = mInner[ index ];
+        mInner[ index ] = NULL;
+        for( Callback* cur = mExpiring; NULL != cur; cur = cur->mTimerNext )
+            cur->mTimerSlot = &mExpiring;
+
+        ++mTime;
+
+        while( NULL != mExpiring )
+        {
+            Callback* callback = mExpiring;
+
+            const uint32 lateness = now - callback->mTimerExpiry;
+            if( TIMERWHEEL_LATE_THRESHOLD < lateness )
+            {
+                _log( COMMON__TIMERS, "Timer %p fired %u ms late.", callback, lateness );
+                ++mStats.late;
+            }
+            if( mStats.maxLateness < lateness )
+                mStats.maxLateness = lateness;
+
+            Cancel( callback );
+            ++fired;
+
+            callback->TimerExpired();
+        }
+    }
+
+    ++mStats.ticks;
+    mStats.fired += fired;
+    if( mStats.maxFired < fired )
+        mStats.maxFired = fired;
+
+    return fired;
+}
+
+uint32 TimerWheel::GetTimeToNextExpiry() const
+{
+    if( 0 == mCount )
+        return 0xFFFFFFFF;
+
+    // Process() walked up to mTime - 1 already
+    if( 0 <= (int32)( mNow - mTime ) )
+        return 0;
+
+    // look for the first non-empty bucket of the inner wheel or the first
+    // round boundary at which the outer wheels bring something in
+    const uint32 end = mTime + INNER_SIZE;
+    uint32 t = mTime;
+    for(; t != end; ++t )
+    {
+        if( 0 == ( t & INNER_MASK ) && _IsCascadePending( t ) )
+            break;
+        if( NULL != mInner[ t & INNER_MASK ] )
+            break;
+    }
+
+    return t - mNow;
+}
+
+bool TimerWheel::_IsCascadePending( uint32 time ) const
+{
+    for( uint32 w = 0; w < OUTER_COUNT; ++w )
+    {
+        const uint32 index = ( time >> ( INNER_BITS + w * OUTER_BITS ) ) & OUTER_MASK;
+        if( NULL != mOuter[ w ][ index ] )
+            return true;
+        // the next wheel cascades only if this one wraps around
+        if( 0 != index )
+            break;
+    }
+
+    return false;
+}
+
+void TimerWheel::_Insert( Callback* callback )
+{
+    const uint32 delta = callback->mTimerExpiry - mTime;
+
+    Callback** slot;
+    if( 0 > (int32)delta )
+    {
+        // already expired, fire as soon as possible
+        slot = &mInner[ mTime & INNER_MASK ];
+    }
+    else if( delta < INNER_SIZE )
+    {
+        slot = &mInner[ callback->mTimerExpiry & INNER_MASK ];
+    }
+    else
+    {
+        uint32 w = 0;
+        uint32 shift = INNER_BITS + OUTER_BITS;
+        for(; w + 1 < OUTER_COUNT; ++w, shift += OUTER_BITS )
+        {
+            if( delta < ( 1U << shift ) )
+                break;
+        }
+
+        // beyond the reach of all wheels, park it in the furthest bucket
+        // and let the cascade reinsert it later
+        uint32 expiry = callback->mTimerExpiry;
+        if( ( 1U << shift ) <= delta )
+            expiry = mTime + ( 1U << shift ) - ( 1U << ( shift - OUTER_BITS ) );
+
+        slot = &mOuter[ w ][ ( expiry >> ( shift - OUTER_BITS ) ) & OUTER_MASK ];
+    }
+
+    callback->mTimerSlot = slot;
+    callback->mTimerPrev = NULL;
+    callback->mTimerNext = *slot;
+    if( NULL != *slot )
+        ( *slot )->mTimerPrev = callback;
+    *slot = callback;
+}
+
+void TimerWheel::_Unlink( Callback* callback )
+{
+    if( NULL != callback->mTimerPrev )
+        callback->mTimerPrev->mTimerNext = callback->mTimerNext;
+    else
+        *callback->mTimerSlot = callback->mTimerNext;
+
+    if( NULL != callback->mTimerNext )
+        callback->mTimerNext->mTimerPrev = callback->mTimerPrev;
+
+    callback->mTimerSlot = NULL;
+    callback->mTimerPrev = NULL;
+    callback->mTimerNext = NULL;
+}
+
+uint32 TimerWheel::_Cascade( uint32 wheel, uint32 index )
+{
+    Callback* callback = mOuter[ wheel ][ index ];
+    mOuter[ wheel ][ index ] = NULL;
+
+    while( NULL != callback )
+    {
+        Callback* next = callback->mTimerNext;
+        _Insert( callback );
+        callback = next;
+    }
+
+    return index;
+}
@@ -0,0 +1,314 @@
+/*
+    ------------------------------------------------------------------------------------
+    LICENSE:
+    ------------------------------------------------------------------------------------
+    This file is part of EVEmu: EVE Online Server Emulator
+    Copyright 2006 - 2011 The EVEmu Team
+    For the latest information visit http://evemu.org
+    ------------------------------------------------------------------------------------
+    This program is free software; you can redistribute it and/or modify it under
+    the terms of the GNU Lesser General Public License as published by the Free Software
+    Foundation; either version 2 of the License, or (at your option) any later
+    version.
+
+    This program is distributed in the hope that it will be useful, but WITHOUT
+    ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+    FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public License along with
+    this program; if not, write to the Free Software Foundation, Inc., 59 Temple
+    Place - Suite 330, Boston, MA 02111-1307, USA, or go to
+    http://www.gnu.org/copyleft/lesser.txt.
+    ------------------------------------------------------------------------------------
+    Author:     EVEmu Team
+*/
+
+
+#include "eve-core.h"
+
+#include "utils/Utf16.h"
+
+#if defined( __SSE2__ ) || defined( _M_X64 ) || ( defined( _M_IX86_FP ) && 2 <= _M_IX86_FP )
+#   include <emmintrin.h>
+#   define UTF16_SSE2
+#elif defined( __aarch64__ )
+#   include <arm_neon.h>
+#   define UTF16_NEON
+#endif
+
+/// The replacement character, U+FFFD.
+static const uint32 UTF_REPLACEMENT = 0xFFFD;
+
+/*************************************************************************/
+/* ASCII runs                                                            */
+/*************************************************************************/
+/* Each returns the number of leading ASCII units it handled, a multiple
+ * of its block size; the caller continues one unit at a time. */
+
+/* Copies leading ASCII UTF-16 units as bytes. */
+static size_t CopyAscii16( const uint16* str, size_t len, char* into )
+{
+    size_t i = 0;
+
+#if defined( UTF16_SSE2 )
+    const __m128i high = _mm_set1_epi16( (short)0xFF80 );
+    const __m128i zero = _mm_setzero_si128();
+    for( ; i + 8 <= len; i += 8 )
+    {
+        const __m128i v = _mm_loadu_si128( (const __m128i*)( str + i ) );
+        if( 0xFFFF != _mm_movemask_epi8( _mm_cmpeq_epi16( _mm_and_si128( v, high ), zero ) ) )
+            break;
+
+        _mm_storel_epi64( (__m128i*)( into + i ), _mm_packus_epi16( v, v ) );
+    }
+#elif defined( UTF16_NEON )
+    for( ; i + 8 <= len; i += 8 )
+    {
+        const uint16x8_t v = vld1q_u16( str + i );
+        if( 0x80 <= vmaxvq_u16( v ) )
+            break;
+
+        vst1_u8( (uint8_t*)( into + i ), vmovn_u16( v ) );
+    }
+#else
+    for( ; i + 4 <= len; i += 4 )
+    {
+        if( 0 != ( ( str[i] | str[i + 1] | str[i + 2] | str[i + 3] ) & 0xFF80 ) )
+            break;
+
+        into[i]     = (char)str[i];
+        into[i + 1] = (char)str[i + 1];
+        into[i + 2] = (char)str[i + 2];
+        into[i + 3] = (char)str[i + 3];
+    }
+#endif
+
+    return i;
+}
+
+/* Widens leading ASCII bytes to UTF-16 units. */
+static size_t CopyAscii8( const char* str, size_t len, uint16* into )
+{
+    size_t i = 0;
+
+#if defined( UTF16_SSE2 )
+    const __m128i zero = _mm_setzero_si128();
+    for( ; i + 16 <= len; i += 16 )
+    {
+        const __m128i v = _mm_loadu_si128( (const __m128i*)( str + i ) );
+        if( 0 != _mm_movemask_epi8( v ) )
+            break;
+
+        _mm_storeu_si128( (__m128i*)( into + i ), _mm_unpacklo_epi8( v, zero ) );
+        _mm_storeu_si128( (__m128i*)( into + i + 8 ), _mm_unpackhi_epi8( v, zero ) );
+    }
+#elif defined( UTF16_NEON )
+    for( ; i + 16 <= len; i += 16 )
+    {
+        const uint8x16_t v = vld1q_u8( (const uint8_t*)( str + i ) );
+        if( 0x80 <= vmaxvq_u8( v ) )
+            break;
+
+        vst1q_u16( into + i, vmovl_u8( vget_low_u8( v ) ) );
+        vst1q_u16( into + i + 8, vmovl_u8( vget_high_u8( v ) ) );
+    }
+#else
+    for( ; i + 4 <= len; i += 4 )
+    {
+        if( 0 != ( ( str[i] | str[i + 1] | str[i + 2] | str[i + 3] ) & 0x80 ) )
+            break;
+
+        into[i]     = (uint8)str[i];
+        into[i + 1] = (uint8)str[i + 1];
+        into[i + 2] = (uint8)str[i + 2];
+        into[i + 3] = (uint8)str[i + 3];
+    }
+#endif
+
+    return i;
+}
+
+/*************************************************************************/
+/* UTF-16 to UTF-8                                                       */
+/*************************************************************************/
+void Utf16ToUtf8( const uint16* str, size_t len, std::string& into )
+{
+    // never more than 3 bytes per unit; a pair of surrogates takes 4
+    const size_t start = into.size();
+    into.resize( start + 3 * len );
+    if( 0 == len )
+        return;
+
+    char* const begin = &into[ start ];
+    char* out = begin;
+
+    size_t i = 0;
+    while( i < len )
+    {
+        uint32 cp = str[ i ];
+        if( cp < 0x80 )
+        {
+            // a run of ASCII is copied by blocks
+            const size_t ascii = CopyAscii16( str + i, len - i, out );
+            if( 0 < ascii )
+            {
+                out += ascii;
+                i += ascii;
+            }
+            else
+            {
+                *out++ = (char)cp;
+                ++i;
+            }
+        }
+        else if( cp < 0x800 )
+        {
+            *out++ = (char)( 0xC0 | ( cp >> 6 ) );
+            *out++ = (char)( 0x80 | ( cp & 0x3F ) );
+            ++i;
+        }
+        else if( cp < 0xD800 || 0xDFFF < cp )
+        {
+            *out++ = (char)( 0xE0 | ( cp >> 12 ) );
+            *out++ = (char)( 0x80 | ( ( cp >> 6 ) & 0x3F ) );
+            *out++ = (char)( 0x80 | ( cp & 0x3F ) );
+            ++i;
+        }
+        else if( cp < 0xDC00 && i + 1 < len && 0xDC00 <= str[ i + 1 ] && str[ i + 1 ] <= 0xDFFF )
+        {
+            // a lead surrogate followed by a trail one
+            cp = 0x10000 + ( ( cp - 0xD800 ) << 10 ) + ( str[ i + 1 ] - 0xDC00 );
+            *out++ = (char)( 0xF0 | ( cp >> 18 ) );
+            *out++ = (char)( 0x80 | ( ( cp >> 12 ) & 0x3F ) );
+            *out++ = (char)( 0x80 | ( ( cp >> 6 ) & 0x3F ) );
+            *out++ = (char)( 0x80 | ( cp & 0x3F ) );
+            i += 2;
+        }
+        else
+        {
+            // unpaired surrogate
+            *out++ = (char)0xEF;
+            *out++ = (char)0xBF;
+            *out++ = (char)0xBD;
+            ++i;
+        }
+    }
+
+    into.resize( start + ( out - begin ) );
+}
+
+/*************************************************************************/
+/* UTF-8 to UTF-16                                                       */
+/*************************************************************************/
+size_t Utf8Length( const char* str, size_t len )
+{
+    // every byte but the continuation ones (10xxxxxx) starts a code point
+    size_t count = 0;
+    size_t i = 0;
+
+#if defined( UTF16_SSE2 )
+    const __m128i limit = _mm_set1_epi8( (char)0xC0 );
+    for( ; i + 16 <= len; i += 16 )
+    {
+        const __m128i v = _mm_loadu_si128( (const __m128i*)( str + i ) );
+        // signed: continuation bytes are the ones below 0xC0 (-64) but negative
+        uint32 mask = _mm_movemask_epi8( _mm_cmplt_epi8( v, limit ) );
+        for( ; 0 != mask; mask &= mask - 1 )
+            ++count;
+    }
+    count = i - count;
+#elif defined( UTF16_NEON )
+    const int8x16_t limit = vdupq_n_s8( (int8_t)0xC0 );
+    for( ; i + 16 <= len; i += 16 )
+    {
+        const uint8x16_t cont = vcltq_s8( vld1q_s8( (const int8_t*)( str + i ) ), limit );
+        count += 16 - vaddvq_u8( vshrq_n_u8( cont, 7 ) );
+    }
+#endif
+
+    for( ; i < len; ++i )
+    {
+        if( 0x80 != ( (uint8)str[ i ] & 0xC0 ) )
+            ++count;
+    }
+
+    return count;
+}
+
+/* Decodes the code point at str[i], advancing i past it. */
+static uint32 DecodeUtf8( const char* str, size_t len, size_t& i )
+{
+    const uint32 lead = (uint8)str[ i++ ];
+    if( lead < 0x80 )
+        return lead;
+
+    size_t follow;
+    uint32 cp, min;
+    if( 0xC2 <= lead && lead < 0xE0 )
+    {
+        follow = 1; cp = lead & 0x1F; min = 0x80;
+    }
+    else if( 0xE0 <= lead && lead < 0xF0 )
+    {
+        follow = 2; cp = lead & 0x0F; min = 0x800;
+    }
+    else if( 0xF0 <= lead && lead < 0xF5 )
+    {
+        follow = 3; cp = lead & 0x07; min = 0x10000;
+    }
+    else
+        return UTF_REPLACEMENT;
+
+    for( ; 0 < follow; --follow )
+    {
+        if( i == len || 0x80 != ( (uint8)str[ i ] & 0xC0 ) )
+            return UTF_REPLACEMENT;
+
+        cp = ( cp << 6 ) | ( (uint8)str[ i++ ] & 0x3F );
+    }
+
+    // overlong forms, surrogates and beyond U+10FFFF
+    if( cp < min || ( 0xD800 <= cp && cp <= 0xDFFF ) || 0x10FFFF < cp )
+        return UTF_REPLACEMENT;
+
+    return cp;
+}
+
+void Utf8ToUtf16( const char* str, size_t len, std::vector< uint16 >& into )
+{
+    // never more units than bytes
+    const size_t start = into.size();
+    into.resize( start + len );
+    if( 0 == len )
+        return;
+
+    uint16* const begin = &into[ start ];
+    uint16* out = begin;
+
+    size_t i = 0;
+    while( i < len )
+    {
+        // a run of ASCII is widened by blocks
+        if( 0 == ( str[ i ] & 0x80 ) )
+        {
+            const size_t ascii = CopyAscii8( str + i, len - i, out );
+            if( 0 < ascii )
+            {
+                out += ascii;
+                i += ascii;
+                continue;
+            }
+        }
+
+        const uint32 cp = DecodeUtf8( str, len, i );
+        if( cp < 0x10000 )
+            *out++ = (uint16)cp;
+        else
+        {
+            *out++ = (uint16)( 0xD800 + ( ( cp - 0x10000 ) >> 10 ) );
+            *out++ = (uint16)( 0xDC00 + ( ( cp - 0x10000 ) & 0x3FF ) );
+        }
+    }
+
+    into.resize( start + ( out - begin ) );
+}
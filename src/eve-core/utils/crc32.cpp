@@ -98,10 +98,86 @@ const uint32 CRC32_LOOKUP_TABLE[ 0x100 ] =
     0xB40BBE37, 0xC30C8EA1, 0x5A05DF1B, 0x2D02EF8D
 };
 
+/* The CRC-32 instructions of ARMv8 compute this very polynomial;
+ * the crc32 instruction of SSE4.2 computes CRC-32C (Castagnoli),
+ * which is not what the clients and the cache files expect, so
+ * x86 uses slicing-by-8 instead.
+ */
+#if defined( __ARM_FEATURE_CRC32 )
+#   include <arm_acle.h>
+#endif /* defined( __ARM_FEATURE_CRC32 ) */
+
+#if !defined( __ARM_FEATURE_CRC32 )
+/**
+ * @brief Lookup tables of slicing-by-8.
+ *
+ * The table k advances a CRC over a byte followed by k zero bytes,
+ * so 8 lookups advance it over 8 bytes at once.
+ */
+class CRC32SliceTables
+{
+public:
+    CRC32SliceTables()
+    {
+        for( size_t i = 0; i < 0x100; ++i )
+        {
+            uint32 crc32 = CRC32_LOOKUP_TABLE[ i ];
+            table[0][ i ] = crc32;
+
+            for( size_t k = 1; k < 8; ++k )
+            {
+                crc32 = ( crc32 >> 8 ) ^ CRC32_LOOKUP_TABLE[ crc32 & 0x000000FF ];
+                table[ k ][ i ] = crc32;
+            }
+        }
+    }
+
+    uint32 table[ 8 ][ 0x100 ];
+};
+
+/* Reads a little-endian word; compilers fold this into a single load. */
+static inline uint32 CRC32Load( const uint8* buf )
+{
+    return (uint32)buf[0] | ( (uint32)buf[1] << 8 ) | ( (uint32)buf[2] << 16 ) | ( (uint32)buf[3] << 24 );
+}
+#endif /* !defined( __ARM_FEATURE_CRC32 ) */
+
 uint32 CRC32::Update( const uint8* buf, size_t bufsize, uint32 crc32 )
 {
-    for( size_t i = 0; i < bufsize; ++i )
-        crc32 = ( crc32 >> 8 ) ^ CRC32_LOOKUP_TABLE[ buf[ i ] ^ ( crc32 & 0x000000FF ) ];
+#if defined( __ARM_FEATURE_CRC32 )
+    for( ; 0 < bufsize && 0 != ( (size_t)buf & 7 ); ++buf, --bufsize )
+        crc32 = __crc32b( crc32, *buf );
+
+    for( ; 8 <= bufsize; buf += 8, bufsize -= 8 )
+    {
+        uint64 word;
+        ::memcpy( &word, buf, sizeof( word ) );
+        crc32 = __crc32d( crc32, word );
+    }
+
+    for( ; 0 < bufsize; ++buf, --bufsize )
+        crc32 = __crc32b( crc32, *buf );
+#else /* !defined( __ARM_FEATURE_CRC32 ) */
+    static const CRC32SliceTables slices;
+    const uint32 ( &t )[ 8 ][ 0x100 ] = slices.table;
+
+    for( ; 0 < bufsize && 0 != ( (size_t)buf & 3 ); ++buf, --bufsize )
+        crc32 = ( crc32 >> 8 ) ^ CRC32_LOOKUP_TABLE[ *buf ^ ( crc32 & 0x000000FF ) ];
+
+    for( ; 8 <= bufsize; buf += 8, bufsize -= 8 )
+    {
+        const uint32 lo = CRC32Load( buf ) ^ crc32;
+        const uint32 hi = CRC32Load( buf + 4 );
+
+        crc32 = t[7][ lo & 0xFF ] ^ t[6][ ( lo >> 8 ) & 0xFF ]
+              ^ t[5][ ( lo >> 16 ) & 0xFF ] ^ t[4][ lo >> 24 ]
+              ^ t[3][ hi & 0xFF ] ^ t[2][ ( hi >> 8 ) & 0xFF ]
+              ^ t[1][ ( hi >> 16 ) & 0xFF ] ^ t[0][ hi >> 24 ];
+    }
+
+    for( ; 0 < bufsize; ++buf, --bufsize )
+        crc32 = ( crc32 >> 8 ) ^ CRC32_LOOKUP_TABLE[ *buf ^ ( crc32 & 0x000000FF ) ];
+#endif /* !defined( __ARM_FEATURE_CRC32 ) */
 
     return crc32;
 }
@@ -30,6 +30,38 @@
 static int32 current_time = 0;
 static int32 current_seconds = 0;
 static int32 last_time = 0;
+static bool has_deadline = false;
+static int32 next_deadline = 0;
+#ifdef WIN32
+static DWORD deadline_thread = 0;
+#else /* !WIN32 */
+static pthread_t deadline_thread;
+#endif /* !WIN32 */
+static bool deadline_thread_set = false;
+
+/* Records the moment at which a timer started at start with period timer expires. */
+static void RecordDeadline( int32 start, int32 timer )
+{
+    // only the thread which asked for deadlines is tracked
+    if( !deadline_thread_set )
+        return;
+#ifdef WIN32
+    if( GetCurrentThreadId() != deadline_thread )
+        return;
+#else /* !WIN32 */
+    if( !pthread_equal( pthread_self(), deadline_thread ) )
+        return;
+#endif /* !WIN32 */
+
+    // Check() fires once current_time - start_time > timer_time
+    const int32 deadline = start + timer + 1;
+
+    if( !has_deadline || deadline - next_deadline < 0 )
+    {
+        next_deadline = deadline;
+        has_deadline = true;
+    }
+}
 
 Timer::Timer(int32 in_timer_time, bool iUseAcurateTiming) {
     timer_time = in_timer_time;
@@ -41,6 +73,7 @@ Timer::Timer(int32 in_timer_time, bool iUseAcurateTiming) {
     }
     else {
         enabled = true;
+        RecordDeadline(start_time, timer_time);
     }
 }
 
@@ -54,6 +87,7 @@ Timer::Timer(int32 start, int32 timer, bool iUseAcurateTiming = false) {
     }
     else {
         enabled = true;
+        RecordDeadline(start_time, timer_time);
     }
 }
 
@@ -72,10 +106,14 @@ bool Timer::Check(bool iReset)
             else
                 start_time = current_time; // Reset timer
             timer_time = set_at_trigger;
+            RecordDeadline(start_time, timer_time);
         }
         return true;
     }
 
+    if (enabled)
+        RecordDeadline(start_time, timer_time);
+
     return false;
 }
 
@@ -98,6 +136,7 @@ void Timer::Start(int32 set_timer_time, bool ChangeResetTimer) {
         if (ChangeResetTimer == true)
             set_at_trigger = set_timer_time;
     }
+    RecordDeadline(start_time, timer_time);
 }
 
 /* This timer updates the timer without restarting it */
@@ -111,6 +150,7 @@ void Timer::SetTimer(int32 set_timer_time) {
         timer_time = set_timer_time;
         set_at_trigger = set_timer_time;
     }
+    RecordDeadline(start_time, timer_time);
 }
 
 int32 Timer::GetRemainingTime() const {
@@ -138,6 +178,7 @@ void Timer::Trigger()
 
     timer_time = set_at_trigger;
     start_time = current_time-timer_time-1;
+    RecordDeadline(start_time, timer_time);
 }
 
 const int32 Timer::GetCurrentTime()
@@ -150,6 +191,28 @@ const int32 Timer::GetTimeSeconds() {
     return(current_seconds);
 }
 
+void Timer::ResetNextDeadline()
+{
+#ifdef WIN32
+    deadline_thread = GetCurrentThreadId();
+#else /* !WIN32 */
+    deadline_thread = pthread_self();
+#endif /* !WIN32 */
+    deadline_thread_set = true;
+
+    has_deadline = false;
+}
+
+uint32 Timer::GetTimeToNextDeadline()
+{
+    if( !has_deadline )
+        return 0xFFFFFFFF;
+    else if( next_deadline - current_time <= 0 )
+        return 0;
+    else
+        return next_deadline - current_time;
+}
+
 const int32 Timer::SetCurrentTime()
 {
     const int32 this_time = ::GetTickCount();
@@ -198,6 +198,27 @@ void ListToINString( const std::vector<int32>& ints, std::string& into, const ch
     }
 }
 
+void ListToINString( const std::vector<uint32>& ints, std::string& into, const char* if_empty )
+{
+    if( ints.empty() )
+    {
+        into = if_empty;
+        return;
+    }
+
+    // "4294967295," is 11 characters
+    char number[ 12 ];
+
+    std::vector<uint32>::const_iterator cur, end;
+    cur = ints.begin();
+    end = ints.end();
+    for(; cur != end; ++cur)
+    {
+        snprintf( number, sizeof( number ), ( cur == ints.begin() ? "%u" : ",%u" ), *cur );
+        into += number;
+    }
+}
+
 void MakeUpperString( const char* source, char* target )
 {
     if( !target )
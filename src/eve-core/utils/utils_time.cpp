@@ -71,3 +71,19 @@ uint64 Win32TimeNow() {
     return(UnixTimeToWin32Time(time(NULL), 0));
 #endif
 }
+
+uint64 GetTimeUSeconds() {
+#ifdef WIN32
+    LARGE_INTEGER freq, count;
+    if(!QueryPerformanceFrequency(&freq) || !QueryPerformanceCounter(&count))
+        return(uint64(GetTickCount()) * 1000);
+    return(uint64(count.QuadPart / freq.QuadPart) * 1000000
+           + uint64(count.QuadPart % freq.QuadPart) * 1000000 / freq.QuadPart);
+#elif defined( HAVE_SYS_TIME_H )
+    timeval tv;
+    ::gettimeofday( &tv, NULL );
+    return(uint64(tv.tv_sec) * 1000000 + tv.tv_usec);
+#else
+    return(uint64(GetTickCount()) * 1000);
+#endif
+}
@@ -26,37 +26,65 @@
 #include "eve-server.h"
 
 #include "Client.h"
+#include "EVEServerConfig.h"
 #include "LiveUpdateDB.h"
 #include "PyBoundObject.h"
+#include "account/LoginAuthenticator.h"
+#include "admin/PacketTrace.h"
+#include "character/CharSelectCache.h"
 #include "character/CharacterService.h"
+#include "character/LoginPipeline.h"
 #include "chat/LSCService.h"
+#include "chat/Presence.h"
 #include "imageserver/ImageServer.h"
+#include "mail/MailStore.h"
+#include "map/MapStatistics.h"
+#include "market/TradeDesk.h"
+#include "missions/AgentCatalogue.h"
 #include "npc/NPC.h"
 #include "ship/DestinyManager.h"
+#include "ship/DroneSwarm.h"
+#include "ship/FleetManager.h"
 #include "ship/ShipOperatorInterface.h"
+#include "standing/StandingCache.h"
+#include "station/StationCache.h"
+#include "system/BookmarkStore.h"
+#include "system/ClusterMap.h"
+#include "system/JumpPipeline.h"
 #include "system/SystemManager.h"
 
 static const uint32 PING_INTERVAL_US = 60000;
+/// The most ships kept warm per client.
+static const size_t MAX_WARM_SHIPS = 3;
 
 Client::Client(PyServiceMgr &services, EVETCPConnection** con)
 : DynamicSystemEntity(NULL),
   EVEClientSession( con ),
   m_services(services),
-  m_pingTimer(PING_INTERVAL_US),
+  m_pingTimer(*this),
+  m_lastReceived(sTimerWheel.now()),
+  m_lastCalled(sTimerWheel.now()),
+  m_idle(false),
+  m_sessionChangeQueued(false),
+  m_trace(NULL),
+  m_traceCallID(0),
   m_system(NULL),
 //  m_destinyTimer(1000, true), //accurate timing is essential
 //  m_lastDestinyTime(Timer::GetTimeSeconds()),
   m_moveState(msIdle),
-  m_moveTimer(500),
   m_movePoint(0, 0, 0),
-  m_timeEndTrain(0),
+  m_skillTrainingTimer(*this),
+  m_warmShipTimer(*this),
   m_destinyEventQueue( new PyList ),
   m_destinyUpdateQueue( new PyList ),
+  m_destinyBudgetStamp(0),
+  m_destinyBudgetLeft(0),
+  m_destinyResyncPending(false),
+  m_destinyResyncStamp(0),
   m_nextNotifySequence(1)
 //  m_nextDestinyUpdate(46751)
 {
-    m_moveTimer.Disable();
-    m_pingTimer.Start();
+    sTimerWheel.Schedule( &m_pingTimer, PING_INTERVAL_US );
 
     m_dockStationID = 0;
     m_justUndocked = false;
@@ -75,6 +103,17 @@ Client::~Client() {
 
         // LSC logout
         m_services.lsc_service->CharacterLogout(GetCharacterID(), LSCChannel::_MakeSenderInfo(this));
+        // the mailbox is loaded again by the next sync
+        sMailStore.Forget(GetCharacterID());
+        // the standings are loaded again by the next session
+        sStandingCache.Forget(GetCharacterID());
+        // and the missions by the next conversation with an agent
+        sAgentCatalogue.Forget(GetCharacterID());
+        // the bookmarks by the next call which needs them
+        sBookmarkStore.Forget(GetCharacterID());
+        // leave the guest list of our station
+        if( IsStation( GetLocationID() ) )
+            OnCharNoLongerInStation();
 
         //before we remove ourself from the system, store our last location.
         SavePosition();
@@ -92,10 +131,25 @@ Client::~Client() {
         //johnsus - characterOnline mod
         // switch character online flag to 0
         m_services.serviceDB().SetCharacterOnlineStatus(GetCharacterID(), false);
+        sPresence.Logout(GetCharacterID());
+        sFleetManager.RemoveMember(GetCharacterID(), false);
+
+        //the ship, location, balance, ... of the selection screen may have changed
+        sCharSelectCache.InvalidateCharacter(GetCharacterID());
     }
 
+    //a login still in flight must not attach to us
+    sLoginPipeline.Cancel(this);
+    sJumpPipeline.Cancel(this);
+    sTradeDesk.Cancel(this);
+    sLoginAuthenticator.Cancel(this);
+    //nobody is left to send our session change to
+    if(m_sessionChangeQueued)
+        sEntityList.DropSessionChange(this);
+
     if(GetAccountID() != 0) { // this is not very good ....
         m_services.serviceDB().SetAccountOnlineStatus(GetAccountID(), false);
+        sCharSelectCache.InvalidateAccount(GetAccountID());
     }
 
     m_services.ClearBoundObjects(this);
@@ -104,6 +158,12 @@ Client::~Client() {
 
     PyDecRef( m_destinyEventQueue );
     PyDecRef( m_destinyUpdateQueue );
+
+    std::vector<HeldDestinyUpdate>::iterator cur, end;
+    cur = m_heldDestinyUpdates.begin();
+    end = m_heldDestinyUpdates.end();
+    for(; cur != end; cur++)
+        PyDecRef( cur->update );
 }
 
 bool Client::ProcessNet()
@@ -111,17 +171,36 @@ bool Client::ProcessNet()
     if( GetState() != TCPConnection::STATE_CONNECTED )
         return false;
 
-    if(m_pingTimer.Check()) {
-        //_log(CLIENT__TRACE, "%s: Sending ping request.", GetName());
-        _SendPingRequest();
-    }
-
     PyPacket *p;
     while((p = PopPacket())) {
+        m_lastReceived = sTimerWheel.now();
+        if( p->type != PING_REQ && p->type != PING_RSP ) {
+            m_lastCalled = m_lastReceived;
+            if( m_idle ) {
+                //whatever was released is loaded again as the calls need it
+                m_idle = false;
+                ++s_sessionStats.woken;
+            }
+        }
+
+        // traced rather than rendered; eve-tool renders the trace
+        if( is_log_enabled( CLIENT__IN_ALL ) && sPacketTrace.Wants( GetAccountID(), p->dest.service ) )
         {
-            _log(CLIENT__IN_ALL, "Received packet:");
-            PyLogDumpVisitor dumper(CLIENT__IN_ALL, CLIENT__IN_ALL);
-            p->Dump(CLIENT__IN_ALL, dumper);
+            PyRep* rep = p->EncodeShared();
+            sPacketTrace.Record( GetAccountID(), PacketCapture::INBOUND, rep );
+            PyDecRef( rep );
+        }
+
+        // a sampled call carries its trace until the answer is sent
+        if( CALL_REQ == p->type && NULL != ( m_trace = sCallTracer.Sample() ) )
+        {
+            mNet->StampTrace( *m_trace );
+            // the packet has been decoded as well
+            m_trace->Stamp( CallTrace::UNMARSHALED );
+            m_trace->accountID = GetAccountID();
+            m_traceCallID = p->source.callID;
+
+            CallTracer::SetCurrent( m_trace );
         }
 
         try
@@ -134,31 +213,86 @@ bool Client::ProcessNet()
             _SendException( p->dest, p->source.callID, p->type, WRAPPEDEXCEPTION, &e.ssException );
         }
 
+        // not answered right away, eg. deferred
+        CallTracer::SetCurrent( NULL );
+        sCallTracer.Discard( &m_trace );
+
         SafeDelete( p );
     }
 
-    // send queued updates
-    _SendQueuedUpdates();
-
     return true;
 }
 
-void Client::Process() {
-    if(m_moveTimer.Check(false)) {
-        m_moveTimer.Disable();
-        _MoveState s = m_moveState;
-        m_moveState = msIdle;
-        switch(s) {
-        case msIdle:
-            sLog.Error("Client","%s: Move timer expired when no move is pending.", GetName());
-            break;
-        //used to delay stargate animation
-        case msJump:
-            _ExecuteJump();
-            break;
+void Client::_PingTimerExpired()
+{
+    if( GetState() == TCPConnection::STATE_CONNECTED )
+    {
+        const uint32 now = sTimerWheel.now();
+
+        //the client answers our pings, so a silent one is gone; do not wait for its send queue to drain
+        if( 0 < sConfig.net.sessionTimeout && sConfig.net.sessionTimeout * 1000 <= now - m_lastReceived )
+        {
+            sLog.Warning( "Client", "%s: Nothing received for %u seconds, disconnecting.", GetName(), ( now - m_lastReceived ) / 1000 );
+            ++s_sessionStats.evicted;
+
+            DropClientConnection();
+            return;
         }
+
+        if( !m_idle && 0 < sConfig.net.idleSessionTimeout && sConfig.net.idleSessionTimeout * 1000 <= now - m_lastCalled )
+            _GoIdle();
+
+        //_log(CLIENT__TRACE, "%s: Sending ping request.", GetName());
+        _SendPingRequest();
     }
 
+    sTimerWheel.Schedule( &m_pingTimer, PING_INTERVAL_US );
+}
+
+void Client::_GoIdle()
+{
+    m_idle = true;
+    ++s_sessionStats.idled;
+
+    //the ships are loaded again when boarded
+    m_warmShips.clear();
+    if( m_warmShipTimer.IsTimerScheduled() )
+        sTimerWheel.Cancel( &m_warmShipTimer );
+
+    if( GetChar() ) {
+        //the mailbox and the bookmarks are loaded again by the next call which needs them
+        sMailStore.Forget( GetCharacterID() );
+        sBookmarkStore.Forget( GetCharacterID() );
+    }
+
+    _log( CLIENT__TRACE, "%s: Idle for %u seconds, caches released.", GetName(), ( sTimerWheel.now() - m_lastCalled ) / 1000 );
+}
+
+Client::MemoryUsage Client::GetMemoryUsage()
+{
+    const TCPConnection::SendStats send = GetSendStats();
+
+    MemoryUsage usage;
+    usage.sendQueueBytes = send.queueBytes;
+    usage.sendQueueBuffers = send.queueDepth;
+
+    usage.heldDestinyBytes = 0;
+    std::vector<HeldDestinyUpdate>::const_iterator cur, end;
+    cur = m_heldDestinyUpdates.begin();
+    end = m_heldDestinyUpdates.end();
+    for(; cur != end; cur++)
+        usage.heldDestinyBytes += cur->size;
+
+    usage.boundObjects = m_services.GetBoundObjectCount( this );
+    usage.itemRefs = ( GetChar() ? 1 : 0 ) + ( Item() ? 1 : 0 ) + m_warmShips.size();
+
+    usage.idle = m_idle;
+    usage.inactiveTime = ( sTimerWheel.now() - m_lastCalled ) / 1000;
+
+    return usage;
+}
+
+void Client::Process() {
     // Check Character Save Timer Expiry:
     if( GetChar()->CheckSaveTimer() )
         GetChar()->SaveCharacter();
@@ -171,12 +305,6 @@ void Client::Process() {
     //if( mModulesMgr.CheckSaveTimer() )
     //    mModulesMgr.SaveModules();
 
-    if( m_timeEndTrain != 0 )
-    {
-        if( m_timeEndTrain <= EvilTimeNow() )    //Win32TimeNow()
-            GetChar()->UpdateSkillQueue();
-    }
-
     GetShip()->Process();
 
     SystemEntity::Process();
@@ -476,8 +604,6 @@ void Client::MoveToLocation( uint32 location, const GPoint& pt )
 
     EnterSystem( false );
     UpdateLocation();
-
-    _SendSessionChange();
 }
 
 void Client::MoveToPosition(const GPoint &pt) {
@@ -519,6 +645,8 @@ void Client::BoardShip(ShipRef new_ship) {
         return;
     }
 
+    ShipRef old_ship = GetShip();
+
     if(m_system != NULL)
         m_system->RemoveClient(this);
 
@@ -529,8 +657,10 @@ void Client::BoardShip(ShipRef new_ship) {
 
     m_shipId = new_ship->itemID();
     m_char->SetActiveShip(m_shipId);
-    if (IsInSpace())
-        mSession.SetInt( "shipid", new_ship->itemID() );
+    if (IsInSpace()) {
+        mSession.SetInt( SESSION_SHIP_ID, new_ship->itemID() );
+        _QueueSessionChange();
+    }
 
     GetShip()->UpdateModules();
 
@@ -540,6 +670,47 @@ void Client::BoardShip(ShipRef new_ship) {
     if(m_destiny != NULL)
         m_destiny->SetShipCapabilities( GetShip() );
 
+    //pods are consumed when left, there's nothing to keep
+    if( old_ship && old_ship.get() != new_ship.get() && old_ship->typeID() != itemTypeCapsule )
+        _KeepShipWarm( old_ship );
+}
+
+void Client::_KeepShipWarm(ShipRef ship)
+{
+    if( sConfig.world.shipGracePeriod == 0 )
+        return;
+
+    //the ship we sit in needs no keeping
+    std::vector<WarmShip>::iterator cur = m_warmShips.begin();
+    while( cur != m_warmShips.end() ) {
+        if( cur->ship == ship || cur->ship->itemID() == m_shipId )
+            cur = m_warmShips.erase( cur );
+        else
+            ++cur;
+    }
+
+    if( m_warmShips.size() >= MAX_WARM_SHIPS )
+        m_warmShips.erase( m_warmShips.begin() );
+
+    WarmShip warm;
+    warm.ship = ship;
+    warm.expires = sTimerWheel.now() + sConfig.world.shipGracePeriod * 1000;
+    m_warmShips.push_back( warm );
+
+    if( !m_warmShipTimer.IsTimerScheduled() )
+        sTimerWheel.Schedule( &m_warmShipTimer, m_warmShips.front().expires - sTimerWheel.now() );
+}
+
+void Client::_WarmShipsExpired()
+{
+    const uint32 now = sTimerWheel.now();
+
+    //all of them share the grace period, so they expire in order
+    while( !m_warmShips.empty() && (int32)( m_warmShips.front().expires - now ) <= 0 )
+        m_warmShips.erase( m_warmShips.begin() );
+
+    if( !m_warmShips.empty() )
+        sTimerWheel.Schedule( &m_warmShipTimer, m_warmShips.front().expires - now );
 }
 
 void Client::_UpdateSession( const CharacterConstRef& character )
@@ -547,40 +718,42 @@ void Client::_UpdateSession( const CharacterConstRef& character )
     if( !character )
         return;
 
-    mSession.SetInt( "charid", character->itemID() );
-    mSession.SetString( "charname", character->itemName().c_str() );
-    mSession.SetInt( "corpid", character->corporationID() );
+    mSession.SetInt( SESSION_CHAR_ID, character->itemID() );
+    mSession.SetString( SESSION_CHAR_NAME, character->itemName().c_str() );
+    mSession.SetInt( SESSION_CORP_ID, character->corporationID() );
     if( character->stationID() == 0 )
     {
-        mSession.Clear( "stationid" );
-        mSession.Clear( "stationid2" );
-        mSession.Clear( "worldspaceid" );
+        mSession.Clear( SESSION_STATION_ID );
+        mSession.Clear( SESSION_STATION_ID2 );
+        mSession.Clear( SESSION_WORLDSPACE_ID );
 
-        mSession.SetInt( "solarsystemid", character->solarSystemID() );
-        mSession.SetInt( "locationid", character->solarSystemID() );
+        mSession.SetInt( SESSION_SOLAR_SYSTEM_ID, character->solarSystemID() );
+        mSession.SetInt( SESSION_LOCATION_ID, character->solarSystemID() );
     }
     else
     {
-        mSession.Clear( "solarsystemid" );
+        mSession.Clear( SESSION_SOLAR_SYSTEM_ID );
 
-        mSession.SetInt( "stationid", character->stationID() );
-        mSession.SetInt( "stationid2", character->stationID() );
-        mSession.SetInt( "worldspaceid", character->stationID() );
-        mSession.SetInt( "locationid", character->stationID() );
+        mSession.SetInt( SESSION_STATION_ID, character->stationID() );
+        mSession.SetInt( SESSION_STATION_ID2, character->stationID() );
+        mSession.SetInt( SESSION_WORLDSPACE_ID, character->stationID() );
+        mSession.SetInt( SESSION_LOCATION_ID, character->stationID() );
     }
-    mSession.SetInt( "solarsystemid2", character->solarSystemID() );
-    mSession.SetInt( "constellationid", character->constellationID() );
-    mSession.SetInt( "regionid", character->regionID() );
+    mSession.SetInt( SESSION_SOLAR_SYSTEM_ID2, character->solarSystemID() );
+    mSession.SetInt( SESSION_CONSTELLATION_ID, character->constellationID() );
+    mSession.SetInt( SESSION_REGION_ID, character->regionID() );
 
-    mSession.SetInt( "hqID", character->corporationHQ() );
-    mSession.SetLong( "corprole", character->corpRole() );
-    mSession.SetLong( "rolesAtAll", character->rolesAtAll() );
-    mSession.SetLong( "rolesAtBase", character->rolesAtBase() );
-    mSession.SetLong( "rolesAtHQ", character->rolesAtHQ() );
-    mSession.SetLong( "rolesAtOther", character->rolesAtOther() );
+    mSession.SetInt( SESSION_HQ_ID, character->corporationHQ() );
+    mSession.SetLong( SESSION_CORP_ROLE, character->corpRole() );
+    mSession.SetLong( SESSION_ROLES_AT_ALL, character->rolesAtAll() );
+    mSession.SetLong( SESSION_ROLES_AT_BASE, character->rolesAtBase() );
+    mSession.SetLong( SESSION_ROLES_AT_HQ, character->rolesAtHQ() );
+    mSession.SetLong( SESSION_ROLES_AT_OTHER, character->rolesAtOther() );
 
     if (IsInSpace())
-        mSession.SetInt("shipid", GetShipID());
+        mSession.SetInt(SESSION_SHIP_ID, GetShipID());
+
+    _QueueSessionChange();
 }
 
 void Client::_UpdateSession2( uint32 characterID )
@@ -630,41 +803,43 @@ void Client::_UpdateSession2( uint32 characterID )
     locationID = characterDataMap["locationID"];
     shipID = characterDataMap["shipID"];
 
-    mSession.SetInt( "charid", characterID );
-    mSession.SetInt( "corpid", corporationID );
+    mSession.SetInt( SESSION_CHAR_ID, characterID );
+    mSession.SetInt( SESSION_CORP_ID, corporationID );
     if( stationID == 0 )
     {
-        mSession.Clear( "stationid" );
-        mSession.Clear( "stationid2" );
-        mSession.Clear( "worldspaceid" );
+        mSession.Clear( SESSION_STATION_ID );
+        mSession.Clear( SESSION_STATION_ID2 );
+        mSession.Clear( SESSION_WORLDSPACE_ID );
 
-        mSession.SetInt( "solarsystemid", solarSystemID );
-        mSession.SetInt( "locationid", solarSystemID );
+        mSession.SetInt( SESSION_SOLAR_SYSTEM_ID, solarSystemID );
+        mSession.SetInt( SESSION_LOCATION_ID, solarSystemID );
     }
     else
     {
-        mSession.Clear( "solarsystemid" );
+        mSession.Clear( SESSION_SOLAR_SYSTEM_ID );
 
-        mSession.SetInt( "stationid", stationID );
-        mSession.SetInt( "stationid2", stationID );
-        mSession.SetInt( "locationid", locationID );
+        mSession.SetInt( SESSION_STATION_ID, stationID );
+        mSession.SetInt( SESSION_STATION_ID2, stationID );
+        mSession.SetInt( SESSION_LOCATION_ID, locationID );
     }
-    mSession.SetInt( "solarsystemid2", solarSystemID );
-    mSession.SetInt( "constellationid", constellationID );
-    mSession.SetInt( "regionid", regionID );
+    mSession.SetInt( SESSION_SOLAR_SYSTEM_ID2, solarSystemID );
+    mSession.SetInt( SESSION_CONSTELLATION_ID, constellationID );
+    mSession.SetInt( SESSION_REGION_ID, regionID );
 
-    mSession.SetInt( "hqID", corporationHQ );
-    mSession.SetLong( "corprole", corpRole );
-    mSession.SetLong( "rolesAtAll", rolesAtAll );
-    mSession.SetLong( "rolesAtBase", rolesAtBase );
-    mSession.SetLong( "rolesAtHQ", rolesAtHQ );
-    mSession.SetLong( "rolesAtOther", rolesAtOther );
+    mSession.SetInt( SESSION_HQ_ID, corporationHQ );
+    mSession.SetLong( SESSION_CORP_ROLE, corpRole );
+    mSession.SetLong( SESSION_ROLES_AT_ALL, rolesAtAll );
+    mSession.SetLong( SESSION_ROLES_AT_BASE, rolesAtBase );
+    mSession.SetLong( SESSION_ROLES_AT_HQ, rolesAtHQ );
+    mSession.SetLong( SESSION_ROLES_AT_OTHER, rolesAtOther );
 
     m_shipId = shipID;
     if( m_char != NULL )
         m_char->SetActiveShip(m_shipId);
     if (IsInSpace())
-        mSession.SetInt( "shipid", shipID );
+        mSession.SetInt( SESSION_SHIP_ID, shipID );
+
+    _QueueSessionChange();
 }
 
 void Client::_SendCallReturn( const PyAddress& source, uint64 callID, PyRep** return_value, const char* channel )
@@ -692,7 +867,7 @@ void Client::_SendCallReturn( const PyAddress& source, uint64 callID, PyRep** re
         p->named_payload->SetItemString( "channel", new PyString( channel ) );
     }
 
-    FastQueuePacket( &p );
+    FastQueuePacket( &p, _TakeTrace( callID ) );
 }
 
 void Client::_SendException( const PyAddress& source, uint64 callID, MACHONETMSG_TYPE in_response_to, MACHONETERR_TYPE exception_type, PyRep** payload )
@@ -717,14 +892,47 @@ void Client::_SendException( const PyAddress& source, uint64 callID, MACHONETMSG
     *payload = NULL;    //consumed
 
     p->payload = e.Encode();
-    FastQueuePacket(&p);
+    FastQueuePacket( &p, _TakeTrace( callID ) );
+}
+
+CallTrace* Client::_TakeTrace( uint64 callID )
+{
+    if( NULL == m_trace || m_traceCallID != callID )
+        return NULL;
+
+    // the queries of the answer are not charged to the call any more
+    CallTracer::SetCurrent( NULL );
+
+    CallTrace* trace = m_trace;
+    m_trace = NULL;
+    return trace;
+}
+
+void Client::_QueueSessionChange()
+{
+    //lookups by location, station, ... must see us at once, only the notification waits.
+    sEntityList.UpdateIndexes( this );
+
+    if( m_sessionChangeQueued ) {
+        ++s_sessionStats.coalesced;
+        return;
+    }
+
+    m_sessionChangeQueued = true;
+    sEntityList.QueueSessionChange( this );
 }
 
 void Client::_SendSessionChange()
 {
+    //whatever is queued goes out now.
+    m_sessionChangeQueued = false;
+
     if( !mSession.isDirty() )
         return;
 
+    //catches session values changed behind our back.
+    sEntityList.UpdateIndexes( this );
+
     SessionChangeNotification scn;
     scn.changes = new PyDict;
 
@@ -732,11 +940,17 @@ void Client::_SendSessionChange()
     if( scn.changes->empty() )
         return;
 
+    ++s_sessionStats.changes;
+
     sLog.Log("Client","Session updated, sending session change");
     scn.changes->Dump(CLIENT__SESSION, "  Changes: ");
 
     //this is probably not necessary...
     scn.nodesOfInterest.push_back( services().GetNodeID() );
+    //the sol node of our location, if it is another one
+    const uint32 locationNode = sClusterMap.GetNodeID( GetLocationID() );
+    if( locationNode != services().GetNodeID() )
+        scn.nodesOfInterest.push_back( locationNode );
 
     //build the packet:
     PyPacket* p = new PyPacket;
@@ -862,12 +1076,9 @@ void Client::_SendPingResponse( const PyAddress& source, uint64 callID )
 //easily provide us with our own copy of the data.
 void Client::QueueDestinyUpdate(PyTuple **du)
 {
-    DoDestinyAction act;
-    act.update_id = DestinyManager::GetStamp();
-    act.update = *du;
+    //the stamp is assigned once the bundle is flushed.
+    m_destinyUpdateQueue->AddItem( *du );
     *du = NULL;
-
-    m_destinyUpdateQueue->AddItem( act.Encode() );
 }
 
 void Client::QueueDestinyEvent(PyTuple** multiEvent)
@@ -876,14 +1087,253 @@ void Client::QueueDestinyEvent(PyTuple** multiEvent)
     *multiEvent = NULL;
 }
 
-void Client::_SendQueuedUpdates() {
+void Client::QueueAttributeChange(PyTuple** change, uint32 itemID, uint32 attributeID)
+{
+    ++s_destinyBudgetStats.attributeChanges;
+
+    const uint64 key = ( (uint64)itemID << 32 ) | attributeID;
+    std::map<uint64, size_t>::iterator res = m_attributeChangeIndex.find( key );
+    if( res == m_attributeChangeIndex.end() )
+    {
+        m_attributeChangeIndex.insert( std::make_pair( key, m_destinyEventQueue->size() ) );
+        QueueDestinyEvent( change );
+        return;
+    }
+
+    //keep the old value of the first change, take time and new value of this one.
+    PyTuple* queued = m_destinyEventQueue->GetItem( res->second )->AsTuple();
+    PyTuple* later = *change;
+
+    PyIncRef( later->GetItem( 4 ) );
+    queued->SetItem( 4, later->GetItem( 4 ) );
+    PyIncRef( later->GetItem( 5 ) );
+    queued->SetItem( 5, later->GetItem( 5 ) );
+
+    PyDecRef( later );
+    *change = NULL;
+
+    ++s_destinyBudgetStats.attributesCoalesced;
+}
+
+/** @return Name of a destiny update; empty if it has none. */
+static std::string GetDestinyUpdateName( const PyTuple* up )
+{
+    if( up->empty() || !up->GetItem( 0 )->IsString() )
+        return std::string();
+    return up->GetItem( 0 )->AsString()->content();
+}
+
+/** @return True if the update is about a ball, which is then stored in ballID. */
+static bool GetDestinyUpdateBall( const PyTuple* up, uint32& ballID )
+{
+    if( up->size() < 2 || !up->GetItem( 1 )->IsTuple() )
+        return false;
+
+    const PyTuple* args = up->GetItem( 1 )->AsTuple();
+    if( args->empty() || !args->GetItem( 0 )->IsInt() )
+        return false;
+
+    ballID = args->GetItem( 0 )->AsInt()->value();
+    return true;
+}
+
+/** @return True if the update only concerns motion of a ball, which a later SetState makes up for. */
+static bool IsMovementUpdate( const std::string& name )
+{
+    static const char* const MOVEMENT_UPDATES[] =
+    {
+        "AlignTo",
+        "FollowBall",
+        "GotoDirection",
+        "GotoPoint",
+        "Orbit",
+        "SetBallPosition",
+        "SetBallVelocity",
+        "SetMaxSpeed",
+        "SetSpeedFraction",
+        "Stop"
+    };
+
+    for( size_t i = 0; i < sizeof( MOVEMENT_UPDATES ) / sizeof( MOVEMENT_UPDATES[ 0 ] ); ++i )
+    {
+        if( name == MOVEMENT_UPDATES[ i ] )
+            return true;
+    }
+    return false;
+}
+
+Client::DestinyBudgetStats Client::s_destinyBudgetStats;
+Client::SessionStats Client::s_sessionStats;
+
+void Client::QueueBubbleUpdate(PyTuple** du, const SystemEntity* about, size_t size)
+{
+    if( 0 == sConfig.world.destinyUpdateBudget
+        || NULL == about || about == this
+        || !IsMovementUpdate( GetDestinyUpdateName( *du ) )
+        || NULL != targets.GetTarget( about->GetID(), false )
+        || NULL != about->targets.GetTarget( GetID(), false ) )
+    {
+        QueueDestinyUpdate( du );
+        return;
+    }
+
+    HeldDestinyUpdate held;
+    held.update = *du;
+    held.ballID = about->GetID();
+    held.distance2 = DistanceTo2( about );
+    held.size = size;
+    *du = NULL;
+
+    m_heldDestinyUpdates.push_back( held );
+    ++s_destinyBudgetStats.held;
+}
+
+void Client::_AdmitHeldUpdates()
+{
+    const uint32 stamp = DestinyManager::GetStamp();
+    if( stamp != m_destinyBudgetStamp )
+    {
+        m_destinyBudgetStamp = stamp;
+        m_destinyBudgetLeft = sConfig.world.destinyUpdateBudget;
+    }
+
+    if( !m_heldDestinyUpdates.empty() )
+    {
+        const size_t count = m_heldDestinyUpdates.size();
+
+        //a later update of the same kind about the same ball supersedes an earlier one.
+        std::map<std::pair<uint32, std::string>, size_t> latest;
+        for( size_t i = 0; i < count; ++i )
+        {
+            const HeldDestinyUpdate& held = m_heldDestinyUpdates[ i ];
+            latest[ std::make_pair( held.ballID, GetDestinyUpdateName( held.update ) ) ] = i;
+        }
+
+        //what is left of each ball, by distance.
+        std::map<uint32, std::pair<double, size_t> > balls;
+        std::map<std::pair<uint32, std::string>, size_t>::const_iterator cur, end;
+        cur = latest.begin();
+        end = latest.end();
+        for(; cur != end; cur++)
+        {
+            const HeldDestinyUpdate& held = m_heldDestinyUpdates[ cur->second ];
+            std::map<uint32, std::pair<double, size_t> >::iterator res = balls.find( held.ballID );
+            if( res == balls.end() )
+                balls.insert( std::make_pair( held.ballID, std::make_pair( held.distance2, held.size ) ) );
+            else
+                res->second.second += held.size;
+        }
+
+        std::vector<std::pair<std::pair<double, size_t>, uint32> > order;
+        std::map<uint32, std::pair<double, size_t> >::const_iterator curb, endb;
+        curb = balls.begin();
+        endb = balls.end();
+        for(; curb != endb; curb++)
+            order.push_back( std::make_pair( curb->second, curb->first ) );
+        std::sort( order.begin(), order.end() );
+
+        //admit the nearest balls as long as they fit.
+        std::set<uint32> admitted;
+        for( size_t i = 0; i < order.size(); ++i )
+        {
+            const size_t size = order[ i ].first.second;
+            if( m_destinyBudgetLeft < size )
+                break;
+
+            m_destinyBudgetLeft -= size;
+            admitted.insert( order[ i ].second );
+        }
+
+        for( size_t i = 0; i < count; ++i )
+        {
+            HeldDestinyUpdate& held = m_heldDestinyUpdates[ i ];
+            if( latest[ std::make_pair( held.ballID, GetDestinyUpdateName( held.update ) ) ] != i )
+            {
+                PyDecRef( held.update );
+                ++s_destinyBudgetStats.merged;
+            }
+            else if( admitted.find( held.ballID ) != admitted.end() )
+            {
+                QueueDestinyUpdate( &held.update );
+            }
+            else
+            {
+                PyDecRef( held.update );
+                ++s_destinyBudgetStats.dropped;
+                m_destinyResyncPending = true;
+            }
+        }
+        m_heldDestinyUpdates.clear();
+    }
+
+    if( m_destinyResyncPending
+        && NULL != m_destiny && NULL != Bubble()
+        && sConfig.world.destinyResyncInterval <= stamp - m_destinyResyncStamp )
+    {
+        //the complete state makes up for whatever has been dropped.
+        m_destiny->SendSetState( Bubble() );
+        m_destinyResyncPending = false;
+        m_destinyResyncStamp = stamp;
+        ++s_destinyBudgetStats.resyncs;
+    }
+}
+
+void Client::FlushDestinyUpdates() {
+    _AdmitHeldUpdates();
+
     if( !m_destinyUpdateQueue->empty() )
     {
         DoDestinyUpdateMain dum;
 
-        //first insert the destiny updates.
-        dum.updates = m_destinyUpdateQueue;
-        PyIncRef( m_destinyUpdateQueue );
+        //all of the bundle applies at the same stamp, so only the last
+        //position and velocity of each ball matter.
+        const size_t count = m_destinyUpdateQueue->size();
+        std::vector<bool> superseded( count, false );
+        std::map<std::pair<uint32, std::string>, size_t> latest;
+        for( size_t i = 0; i < count; ++i )
+        {
+            const PyTuple* up = m_destinyUpdateQueue->GetItem( i )->AsTuple();
+            const std::string name = GetDestinyUpdateName( up );
+            if( name != "SetBallPosition" && name != "SetBallVelocity" )
+                continue;
+
+            uint32 ballID;
+            if( !GetDestinyUpdateBall( up, ballID ) )
+                continue;
+
+            std::pair<std::map<std::pair<uint32, std::string>, size_t>::iterator, bool> res =
+                latest.insert( std::make_pair( std::make_pair( ballID, name ), i ) );
+            if( !res.second )
+            {
+                superseded[ res.first->second ] = true;
+                res.first->second = i;
+            }
+        }
+
+        //insert the destiny updates, all of them with the stamp of this tic.
+        const uint32 stamp = DestinyManager::GetStamp();
+        dum.updates = new PyList;
+
+        for( size_t i = 0; i < count; ++i )
+        {
+            PyRep* up = m_destinyUpdateQueue->GetItem( i );
+            if( superseded[ i ] )
+            {
+                size_t size = 0;
+                MarshalStream().CalcSize( up, size );
+
+                ++s_destinyBudgetStats.superseded;
+                s_destinyBudgetStats.savedBytes += size;
+                continue;
+            }
+
+            DoDestinyAction act;
+            act.update_id = stamp;
+            act.update = up;
+            PyIncRef( act.update );
+
+            dum.updates->AddItem( act.Encode() );
+        }
 
         //encode any multi-events which go along with it.
         dum.events = m_destinyEventQueue;
@@ -895,7 +1345,8 @@ void Client::_SendQueuedUpdates() {
 
         //now send it
         PyTuple* t = dum.Encode();
-        t->Dump(DESTINY__UPDATES, "");
+        if( is_log_enabled( DESTINY__UPDATES ) && sPacketTrace.Wants( GetAccountID(), "DoDestinyUpdate" ) )
+            sPacketTrace.Record( GetAccountID(), PacketCapture::OUTBOUND, t );
         SendNotification( "DoDestinyUpdate", "clientID", &t );
     }
     else if( !m_destinyEventQueue->empty() )
@@ -908,13 +1359,15 @@ void Client::_SendQueuedUpdates() {
 
         //send it
         PyTuple* t = nom.Encode();   //this is consumed below
-        t->Dump(DESTINY__UPDATES, "");
+        if( is_log_enabled( DESTINY__UPDATES ) && sPacketTrace.Wants( GetAccountID(), "OnMultiEvent" ) )
+            sPacketTrace.Record( GetAccountID(), PacketCapture::OUTBOUND, t );
         SendNotification( "OnMultiEvent", "charid", &t );
     } //else nothing to be sent ...
 
     // clear the queues now, after the packets have been sent
     m_destinyEventQueue->clear();
     m_destinyUpdateQueue->clear();
+    m_attributeChangeIndex.clear();
 }
 
 void Client::SendNotification(const char *notifyType, const char *idType, PyTuple **payload, bool seq) {
@@ -936,6 +1389,19 @@ void Client::SendNotification(const char *notifyType, const char *idType, PyTupl
 
 
 void Client::SendNotification(const PyAddress &dest, EVENotificationStream &noti, bool seq) {
+    PyPacket *p = _MakeNotification(dest, noti.Encode(), seq);
+    FastQueuePacket(&p);
+}
+
+void Client::SendNotification(const PyAddress &dest, const EVESharedPayload &payload, bool seq) {
+    PyTuple *t = payload.payload();
+    PyIncRef(t);
+
+    PyPacket *p = _MakeNotification(dest, t, seq);
+    FastQueuePacket(&p, payload);
+}
+
+PyPacket *Client::_MakeNotification(const PyAddress &dest, PyTuple *payload, bool seq) {
 
     //build the packet:
     PyPacket *p = new PyPacket();
@@ -949,7 +1415,7 @@ void Client::SendNotification(const PyAddress &dest, EVENotificationStream &noti
 
     p->userid = GetAccountID();
 
-    p->payload = noti.Encode();
+    p->payload = payload;
 
     if(seq) {
         p->named_payload = new PyDict();
@@ -963,7 +1429,7 @@ void Client::SendNotification(const PyAddress &dest, EVENotificationStream &noti
         p->Dump(CLIENT__NOTIFY_REP, dumper);
     }
 
-    FastQueuePacket(&p);
+    return p;
 }
 
 PyDict *Client::MakeSlimItem() const {
@@ -1001,7 +1467,7 @@ PyDict *Client::MakeSlimItem() const {
 }
 
 void Client::WarpTo(const GPoint &to, double distance) {
-    if(m_moveState != msIdle || m_moveTimer.Enabled()) {
+    if(m_moveState != msIdle) {
         sLog.Log("Client","%s: WarpTo called when a move is already pending. Ignoring.", GetName());
         return;
     }
@@ -1011,7 +1477,7 @@ void Client::WarpTo(const GPoint &to, double distance) {
 }
 
 void Client::StargateJump(uint32 fromGate, uint32 toGate) {
-    if(m_moveState != msIdle || m_moveTimer.Enabled()) {
+    if(m_moveState != msIdle) {
         sLog.Log("Client","%s: StargateJump called when a move is already pending. Ignoring.", GetName());
         return;
     }
@@ -1029,17 +1495,44 @@ void Client::StargateJump(uint32 fromGate, uint32 toGate) {
         return;
     }
 
+    //the destination boots while they watch the JumpOut animation; the move
+    //itself is batched with everybody else using the gate meanwhile.
+    if(!sJumpPipeline.Start(this, toGate, solarSystemID, constellationID, regionID)) {
+        SendErrorMsg("Unable to boot system %u", solarSystemID);
+        return;
+    }
+    m_moveState = msJump;
+
     GetShip()->DeactivateAllModules();
 
-    m_moveSystemID = solarSystemID;
+    sMapStatistics.AddJump(solarSystemID);
+
     m_movePoint = position;
     m_movePoint.MakeRandomPointOnSphere( 15000 );   // Make Jump-In point a random spot on a 10km radius sphere about the stargate
 
     m_destiny->SendJumpOut(fromGate);
     //TODO: send 'effects.GateActivity' on 'toGate' at the same time
+}
 
-    //delay the move so they can see the JumpOut animation
-    _postMove(msJump, 5000);
+bool Client::ArriveThroughGate(uint32 solarSystemID, uint32 constellationID, uint32 regionID) {
+    m_moveState = msIdle;
+    if(m_destiny == NULL)
+        return false;
+
+    GetShip()->Move( solarSystemID, flagAutoFit );
+    GetShip()->Relocate( m_movePoint );
+
+    //the JumpPipeline saves the location of the whole batch at once.
+    GetChar()->SetLocation( 0, solarSystemID, constellationID, regionID, false );
+    _UpdateSession( GetChar() );
+
+    EnterSystem( false );
+    UpdateLocation();
+    return true;
+}
+
+void Client::CompleteJump() {
+    _SendSessionChange();
 }
 
 void Client::SetDockingPoint(GPoint &dockPoint)
@@ -1076,20 +1569,8 @@ void Client::GetUndockAlignToPoint(GPoint &dest)
 }
 // --- END HACK FUNCTIONS FOR UNDOCK ---
 
-void Client::_postMove(_MoveState type, uint32 wait_ms) {
-    m_moveState = type;
-    m_moveTimer.Start(wait_ms);
-}
-
-void Client::_ExecuteJump() {
-    if(m_destiny == NULL)
-        return;
-
-    MoveToLocation(m_moveSystemID, m_movePoint);
-}
-
-bool Client::AddBalance(double amount) {
-    if(!GetChar()->AlterBalance(amount))
+bool Client::AddBalance(double amount, bool save) {
+    if(!GetChar()->AlterBalance(amount, save))
         return false;
 
     //send notification of change
@@ -1148,6 +1629,7 @@ bool Client::SelectCharacter( uint32 char_id )
 
     //johnsus - characterOnline mod
     m_services.serviceDB().SetCharacterOnlineStatus( GetCharacterID(), true );
+    sPresence.Login( GetCharacterID() );
 
     _SendSessionChange();
 
@@ -1158,10 +1640,32 @@ bool Client::SelectCharacter( uint32 char_id )
 
 void Client::UpdateSkillTraining()
 {
+    uint64 endOfTraining = 0;
     if( GetChar() )
-        m_timeEndTrain = GetChar()->GetEndOfTraining();
-    else
-        m_timeEndTrain = 0;
+        endOfTraining = GetChar()->GetEndOfTraining().get_int();
+
+    if( endOfTraining == 0 )
+    {
+        sTimerWheel.Cancel( &m_skillTrainingTimer );
+        return;
+    }
+
+    // the skill progress itself is derived from its start time, so we only
+    // need to wake up when the training is done
+    const uint64 now = Win32TimeNow();
+    const uint64 millisecond = Win32Time_Second / 1000;
+    const uint64 delay = ( endOfTraining > now ? ( endOfTraining - now + millisecond - 1 ) / millisecond : 0 );
+
+    sTimerWheel.Schedule( &m_skillTrainingTimer, (uint32)std::min<uint64>( delay, 0x7FFFFFFF ) );
+}
+
+void Client::_SkillTrainingExpired()
+{
+    if( GetChar() )
+        GetChar()->UpdateSkillQueue();
+
+    // schedule the next skill in queue, if any
+    UpdateSkillTraining();
 }
 
 double Client::GetPropulsionStrength() const {
@@ -1280,7 +1784,7 @@ void Client::TargetsCleared()
 
 void Client::SavePosition() {
     if( !GetShip() || m_destiny == NULL ) {
-        sLog.Debug("Client","%s: Unable to save position. We are probably not in space.", GetName());
+        _debug("Client","%s: Unable to save position. We are probably not in space.", GetName());
         return;
     }
     GetShip()->Relocate( m_destiny->GetPosition() );
@@ -1358,6 +1862,7 @@ DoDestinyUpdate ,*args= ([(31759,
         GetAllianceID(),
         position);
     m_system->AddNPC(drone_npc);
+    m_system->drones().Add(this, drone_npc);
 
     //now we tell the client that "its ALIIIIIVE"
     //DoDestinyUpdate:
@@ -1435,37 +1940,45 @@ DoDestinyUpdate ,*args= ([(31759,
 void Client::JoinCorporationUpdate(uint32 corp_id) {
     GetChar()->JoinCorporation(corp_id);
 
+    //keep our guest row up to date
+    if( IsStation( GetLocationID() ) )
+        OnCharNowInStation();
+
     _UpdateSession( GetChar() );
 
     //logs indicate that we need to push this update out asap.
     _SendSessionChange();
 }
 
+void Client::UpdateFleetSession(uint32 fleetID, uint32 wingID, uint32 squadID, int32 role) {
+    if(fleetID == 0) {
+        mSession.Clear( SESSION_FLEET_ID );
+        mSession.Clear( SESSION_WING_ID );
+        mSession.Clear( SESSION_SQUAD_ID );
+        mSession.Clear( SESSION_FLEET_ROLE );
+    } else {
+        mSession.SetInt( SESSION_FLEET_ID, fleetID );
+        mSession.SetInt( SESSION_WING_ID, wingID );
+        mSession.SetInt( SESSION_SQUAD_ID, squadID );
+        mSession.SetInt( SESSION_FLEET_ROLE, role );
+    }
+
+    _QueueSessionChange();
+}
+
 /************************************************************************/
 /* character notification messages wrapper                              */
 /************************************************************************/
 void Client::OnCharNoLongerInStation()
 {
-    NotifyOnCharNoLongerInStation n;
-    n.charID = GetCharacterID();
-    n.corpID = GetCorporationID();
-    n.allianceID = GetAllianceID();
-
-    PyTuple* tmp = n.Encode();
-    // this entire line should be something like this Broadcast("OnCharNoLongerInStation", "stationid", &tmp);
-    services().entity_list.Broadcast( "OnCharNoLongerInStation", "stationid", &tmp );
+    // the guests of the station are told by the next tick
+    sStationCache.RemoveGuest( GetStationID(), GetCharacterID() );
 }
 
-/* besides broadcasting the message this function should handle everything for this event */
+/* besides joining the guests this function should handle everything for this event */
 void Client::OnCharNowInStation()
 {
-    NotifyOnCharNowInStation n;
-    n.charID = GetCharacterID();
-    n.corpID = GetCorporationID();
-    n.allianceID = GetAllianceID();
-
-    PyTuple* tmp = n.Encode();
-    services().entity_list.Broadcast( "OnCharNowInStation", "stationid", &tmp );
+    sStationCache.AddGuest( GetStationID(), GetCharacterID(), GetCorporationID(), GetAllianceID() );
 }
 
 /************************************************************************/
@@ -1476,6 +1989,25 @@ void Client::DisconnectClient()
     //initiate closing the client TCP Connection
     CloseClientConnection();
 }
+std::string Client::StartPacketCapture()
+{
+    char timestamp[ 16 ];
+    const time_t now = time( NULL );
+    strftime( timestamp, sizeof( timestamp ), "%y%m%d_%H%M%S", localtime( &now ) );
+
+    std::string filename;
+    sprintf( filename, "%s%u_%s.evecap", sConfig.files.captureDir.c_str(), GetAccountID(), timestamp );
+
+    if( !StartCapture( filename.c_str() ) )
+    {
+        sLog.Error( "Client", "%s: Unable to create capture '%s'.", GetAddress().c_str(), filename.c_str() );
+        return "";
+    }
+
+    sLog.Log( "Client", "%s: Capturing the packets of account %u into '%s'.", GetAddress().c_str(), GetAccountID(), filename.c_str() );
+    return filename;
+}
+
 void Client::BanClient()
 {
     //send message to client
@@ -1547,7 +2079,7 @@ bool Client::_VerifyCrypto( CryptoRequestPacket& cr )
     }
     else
     {
-        sLog.Debug("Client","%s: Received Placebo crypto request, accepting.", GetAddress().c_str());
+        _debug("Client","%s: Received Placebo crypto request, accepting.", GetAddress().c_str());
 
         //send out accept response
         PyRep* rsp = new PyString( "OK CC" );
@@ -1560,58 +2092,36 @@ bool Client::_VerifyCrypto( CryptoRequestPacket& cr )
 
 bool Client::_VerifyLogin( CryptoChallengePacket& ccp )
 {
-    std::string account_hash;
-    std::string transport_closed_msg = "LoginAuthFailed";
-
-    AccountInfo account_info;
-    CryptoServerHandshake server_shake;
-
-    /* send passwordVersion required: 1=plain, 2=hashed */
-    PyRep* rsp = new PyInt( 2 );
-
     //sLog.Debug("Client","%s: Received Client Challenge.", GetAddress().c_str());
     //sLog.Debug("Client","Login with %s:", ccp.user_name.c_str());
 
-    if (!services().serviceDB().GetAccountInformation( ccp.user_name.c_str(),  account_info)) {
-        goto error_login_auth_failed;
-    }
+    /* the account is looked up and the hash verified by the workers; the handshake waits meanwhile */
+    if( !sLoginAuthenticator.Submit( this, mNet->GetrIP(), ccp.user_name, ccp.user_password_hash ) )
+    {
+        GPSTransportClosed* except = new GPSTransportClosed( "LoginAuthFailed" );
+        mNet->QueueRep( except );
+        PyDecRef( except );
 
-    /* check wether the account has been banned and if so send the semi correct message */
-    if (account_info.banned) {
-        transport_closed_msg = "ACCOUNTBANNED";
-        goto error_login_auth_failed;
+        return false;
     }
 
-    /* if we have stored a password we need to create a hash from the username and pass and remove the pass */
-    if( account_info.password.empty() )
-        account_hash = account_info.hash;
-    else
-    {
-        /* here we generate the password hash ourselves */
-        std::string password_hash;
-        if( !PasswordModule::GeneratePassHash(
-                ccp.user_name,
-                account_info.password,
-                password_hash ) )
-        {
-            sLog.Error("Client", "unable to generate password hash, sending LoginAuthFailed");
-            goto error_login_auth_failed;
-        }
+    // Setup session, but don't send the change yet.
+    mSession.SetString( SESSION_LANGUAGE_ID, ccp.user_languageid.c_str() );
 
-        if( !services().serviceDB().UpdateAccountHash(
-                ccp.user_name.c_str(),
-                password_hash ) )
-        {
-            sLog.Error("Client", "unable to update account hash, sending LoginAuthFailed");
-            goto error_login_auth_failed;
-        }
+    _ParkAuthentication();
+    return false;
+}
 
-        account_hash = password_hash;
-    }
+void Client::CompleteLogin( bool success, const AccountInfo& account_info, const std::string& reason )
+{
+    if( !success )
+    {
+        GPSTransportClosed* except = new GPSTransportClosed( reason.c_str() );
+        mNet->QueueRep( except );
+        PyDecRef( except );
 
-    /* here we check if the user successfully entered his password or if he failed */
-    if (account_hash != ccp.user_password_hash) {
-        goto error_login_auth_failed;
+        _ResumeAuthentication( false );
+        return;
     }
 
     /* Check if we already have a client online and if we do disconnect it
@@ -1623,19 +2133,19 @@ bool Client::_VerifyLogin( CryptoChallengePacket& ccp )
             client->DisconnectClient();
     }
 
+    /* send passwordVersion required: 1=plain, 2=hashed */
+    PyRep* rsp = new PyInt( 2 );
     mNet->QueueRep( rsp );
     PyDecRef( rsp );
 
     sLog.Log("Client","successful");
 
-    /* update account information, increase login count, last login timestamp and mark account as online */
-    m_services.serviceDB().UpdateAccountInformation( account_info.name.c_str(), true );
-
     /* marshaled Python string "None" */
     static const uint8 handshakeFunc[] = { 0x74, 0x04, 0x00, 0x00, 0x00, 0x4E, 0x6F, 0x6E, 0x65 };
 
     /* send our handshake */
 
+    CryptoServerHandshake server_shake;
     server_shake.serverChallenge = "";
     server_shake.func_marshaled_code = new PyBuffer( handshakeFunc, handshakeFunc + sizeof( handshakeFunc ) );
     server_shake.verification = new PyBool( false );
@@ -1659,21 +2169,40 @@ bool Client::_VerifyLogin( CryptoChallengePacket& ccp )
     PyDecRef( rsp );
 
     // Setup session, but don't send the change yet.
-    mSession.SetString( "address", EVEClientSession::GetAddress().c_str() );
-    mSession.SetString( "languageID", ccp.user_languageid.c_str() );
+    mSession.SetString( SESSION_ADDRESS, EVEClientSession::GetAddress().c_str() );
 
     //user type 1 is normal user, type 23 is a trial account user.
-    mSession.SetInt( "userType", 1 );
-    mSession.SetInt( "userid", account_info.id );
-    mSession.SetLong( "role", account_info.role );
+    mSession.SetInt( SESSION_USER_TYPE, 1 );
+    mSession.SetInt( SESSION_USER_ID, account_info.id );
+    mSession.SetLong( SESSION_ROLE, account_info.role );
 
-    return true;
+    sEntityList.UpdateIndexes( this );
+
+    // the accounts asked for are recorded from their login on, so the capture can be replayed
+    if( _IsCaptured( account_info.name ) )
+        StartPacketCapture();
 
-error_login_auth_failed:
+    _ResumeAuthentication( true );
+}
 
-    GPSTransportClosed* except = new GPSTransportClosed( transport_closed_msg );
-    mNet->QueueRep( except );
-    PyDecRef( except );
+bool Client::_IsCaptured( const std::string& accountName )
+{
+    // a comma-separated list of account names
+    const std::string& list = sConfig.net.captureAccounts;
+    for( size_t start = 0; start < list.size(); )
+    {
+        size_t end = list.find( ',', start );
+        if( std::string::npos == end )
+            end = list.size();
+
+        size_t first = list.find_first_not_of( ' ', start );
+        size_t last = list.find_last_not_of( ' ', end - 1 );
+        if( first < end && std::string::npos != last && first <= last
+            && 0 == list.compare( first, last - first + 1, accountName ) )
+            return true;
+
+        start = end + 1;
+    }
 
     return false;
 }
@@ -1722,7 +2251,7 @@ bool Client::Handle_CallReq( PyPacket* packet, PyCallStream& req )
             return false;
         }
 
-        if( nodeID != m_services.GetNodeID() )
+        if( !sClusterMap.IsLocalNode( nodeID ) )
         {
             sLog.Error("Client","Unknown nodeID %u received (expected %u).", nodeID, m_services.GetNodeID());
             return false;
@@ -1756,18 +2285,37 @@ bool Client::Handle_CallReq( PyPacket* packet, PyCallStream& req )
         //this should be sLog.Debug, but because of the number of messages, I left it as .Log for readability, and ease of finding other debug messages
         sLog.Log("Server", "%s call made to %s",req.method.c_str(),packet->dest.service.c_str());
 
+    if( NULL != m_trace )
+        m_trace->call = ( packet->dest.service.empty() ? req.remoteObjectStr : packet->dest.service ) + "::" + req.method;
+
     //build arguments
     PyCallArgs args( this, req.arg_tuple, req.arg_dict );
+    args.SetDeferrable( packet->dest, packet->source.callID );
 
     //parts of call may be consumed here
     PyResult result = dest->Call( req.method, args );
 
+    //the answer is sent later by PyDeferredCall
+    if( args.IsDeferred() )
+        return true;
+
     _SendSessionChange();  //send out the session change before the return.
     _SendCallReturn( packet->dest, packet->source.callID, &result.ssResult );
 
     return true;
 }
 
+void Client::SendDeferredReturn( const PyAddress& source, uint64 callID, PyRep* result )
+{
+    _SendSessionChange();  //send out the session change before the return.
+    _SendCallReturn( source, callID, &result );
+}
+
+void Client::SendDeferredException( const PyAddress& source, uint64 callID, PyRep* except )
+{
+    _SendException( source, callID, CALL_REQ, WRAPPEDEXCEPTION, &except );
+}
+
 bool Client::Handle_Notify( PyPacket* packet )
 {
     //turn this thing into a notify stream:
@@ -1799,7 +2347,7 @@ bool Client::Handle_Notify( PyPacket* packet )
                 continue;
             }
 
-            if(nodeID != m_services.GetNodeID()) {
+            if(!sClusterMap.IsLocalNode(nodeID)) {
                 sLog.Error("Client","Notification '%s' from %s: Unknown nodeID %u received (expected %u). Skipping.",
                     notify.method.c_str(), GetName(), nodeID, m_services.GetNodeID());
                 continue;
@@ -1818,8 +2366,10 @@ bool Client::Handle_Notify( PyPacket* packet )
     return true;
 }
 
-void Client::UpdateSession(const char *sessionType, int value)
+void Client::UpdateSession( SessionSlot slot, int value )
 {
-    mSession.SetInt(sessionType, value);
+    mSession.SetInt( slot, value );
+
+    _QueueSessionChange();
 }
 
@@ -35,185 +35,184 @@
         * create a SID system (session ID system)
 */
 
-ClientSession::ClientSession() : mSession( new PyDict ), mDirty( false )
+const char* const ClientSession::SLOT_NAMES[ SESSION_SLOT_COUNT ] =
+{
+    "address",
+    "languageID",
+    "userType",
+    "userid",
+    "role",
+
+    "charid",
+    "charname",
+    "corpid",
+    "hqID",
+    "corprole",
+    "rolesAtAll",
+    "rolesAtBase",
+    "rolesAtHQ",
+    "rolesAtOther",
+
+    "locationid",
+    "stationid",
+    "stationid2",
+    "worldspaceid",
+    "solarsystemid",
+    "solarsystemid2",
+    "constellationid",
+    "regionid",
+    "shipid",
+
+    "gangrole",
+    "fleetid",
+    "wingid",
+    "squadid",
+    "fleetrole"
+};
+
+ClientSession::ClientSession() : mDirty( 0 )
 {
     /* default value of attribute */
-    PyTuple* v = new_tuple(new PyNone, new PyLong(0x4000000000000000));
-    mSession->SetItemString( "role", v );
+    SetLong( SESSION_ROLE, 0x4000000000000000LL );
 }
 
-ClientSession::~ClientSession()
+int32 ClientSession::GetLastInt( SessionSlot slot ) const
 {
-    PyDecRef( mSession );
-}
-
-int32 ClientSession::GetLastInt( const char* name ) const
-{
-    PyRep* v = _GetLast( name );
-    if( v == NULL )
-        return 0;
-
-    if( !v->IsInt() )
+    const Value& v = mSlots[ slot ].last;
+    if( v.kind != Value::KIND_INT )
         return 0;
 
-    return v->AsInt()->value();
+    return (int32)v.number;
 }
 
-int32 ClientSession::GetCurrentInt( const char* name ) const
+int32 ClientSession::GetCurrentInt( SessionSlot slot ) const
 {
-    PyRep* v = _GetCurrent( name );
-    if( v == NULL )
+    const Value& v = mSlots[ slot ].current;
+    if( v.kind != Value::KIND_INT )
         return 0;
 
-    if( !v->IsInt() )
-        return 0;
-
-    return v->AsInt()->value();
+    return (int32)v.number;
 }
 
-void ClientSession::SetInt( const char* name, int32 value )
+void ClientSession::SetInt( SessionSlot slot, int32 value )
 {
-    _Set( name, new PyInt( value ) );
+    Value v;
+    v.kind = Value::KIND_INT;
+    v.number = value;
+
+    _Set( slot, v );
 }
 
-int64 ClientSession::GetLastLong( const char* name ) const
+int64 ClientSession::GetLastLong( SessionSlot slot ) const
 {
-    PyRep* v = _GetLast( name );
-    if( v == NULL )
+    const Value& v = mSlots[ slot ].last;
+    if( v.kind != Value::KIND_LONG )
         return 0;
 
-    if( !v->IsLong() )
-        return 0;
-
-    return v->AsLong()->value();
+    return v.number;
 }
 
-int64 ClientSession::GetCurrentLong( const char* name ) const
+int64 ClientSession::GetCurrentLong( SessionSlot slot ) const
 {
-    PyRep* v = _GetCurrent( name );
-    if( v == NULL )
-        return 0;
-
-    if( !v->IsLong() )
+    const Value& v = mSlots[ slot ].current;
+    if( v.kind != Value::KIND_LONG )
         return 0;
 
-    return v->AsLong()->value();
+    return v.number;
 }
 
-void ClientSession::SetLong( const char* name, int64 value )
+void ClientSession::SetLong( SessionSlot slot, int64 value )
 {
-    _Set( name, new PyLong( value ) );
+    Value v;
+    v.kind = Value::KIND_LONG;
+    v.number = value;
+
+    _Set( slot, v );
 }
 
-std::string ClientSession::GetLastString( const char* name ) const
+std::string ClientSession::GetLastString( SessionSlot slot ) const
 {
-    PyRep* v = _GetLast( name );
-    if( v == NULL )
+    const Value& v = mSlots[ slot ].last;
+    if( v.kind != Value::KIND_STRING )
         return std::string();
 
-    if( !v->IsString() )
-        return std::string();
-
-    return v->AsString()->content();
+    return v.text;
 }
 
-std::string ClientSession::GetCurrentString( const char* name ) const
+std::string ClientSession::GetCurrentString( SessionSlot slot ) const
 {
-    PyRep* v = _GetCurrent( name );
-    if( v == NULL )
-        return std::string();
-
-    if( !v->IsString() )
+    const Value& v = mSlots[ slot ].current;
+    if( v.kind != Value::KIND_STRING )
         return std::string();
 
-    return v->AsString()->content();
+    return v.text;
 }
 
-void ClientSession::SetString( const char* name, const char* value )
+void ClientSession::SetString( SessionSlot slot, const char* value )
 {
-    _Set( name, new PyString( value ) );
+    Value v;
+    v.kind = Value::KIND_STRING;
+    v.text = value;
+
+    _Set( slot, v );
 }
 
-void ClientSession::Clear( const char* name )
+void ClientSession::Clear( SessionSlot slot )
 {
-    _Set( name, new PyNone );
+    _Set( slot, Value() );
 }
 
 void ClientSession::EncodeChanges( PyDict* into )
 {
-    PyDict::const_iterator cur, end;
-    cur = mSession->begin();
-    end = mSession->end();
-    for(; cur != end; cur++)
+    for( uint32 i = 0; i < SESSION_SLOT_COUNT; ++i )
     {
-        PyString* str = cur->first->AsString();
-        PyTuple* value = cur->second->AsTuple();
-
-        PyRep* last = value->GetItem( 0 );
-        PyRep* current = value->GetItem( 1 );
-
-        if( last->hash() != current->hash() )
-        {
-            // Duplicate tuple
-            PyTuple* t = new PyTuple( 2 );
-            t->SetItem( 0, last ); PyIncRef( last );
-            t->SetItem( 1, current ); PyIncRef( current );
-            into->SetItem( str, t ); PyIncRef( str );
-
-            // Update our tuple
-            value->SetItem( 0, current ); PyIncRef( current );
-        }
-    }
+        if( 0 == ( mDirty & ( (uint64)1 << i ) ) )
+            continue;
 
-    mDirty = false;
-}
+        Slot& slot = mSlots[ i ];
 
-PyTuple* ClientSession::_GetValueTuple( const char* name ) const
-{
-    PyRep* v = mSession->GetItemString( name );
-    if( v == NULL )
-        return NULL;
-    return v->AsTuple();
-}
+        // changed and changed back since the last time
+        if( slot.last == slot.current )
+            continue;
 
-PyRep* ClientSession::_GetLast( const char* name ) const
-{
-    PyTuple* v = _GetValueTuple( name );
-    if( v == NULL )
-        return NULL;
-    return v->GetItem( 0 );
-}
+        into->SetItemString( SLOT_NAMES[ i ], new_tuple( slot.last.Encode(), slot.current.Encode() ) );
+        slot.last = slot.current;
+    }
 
-PyRep* ClientSession::_GetCurrent( const char* name ) const
-{
-    PyTuple* v = _GetValueTuple( name );
-    if( v == NULL )
-        return NULL;
-    return v->GetItem( 1 );
+    mDirty = 0;
 }
 
-void ClientSession::_Set( const char* name, PyRep* value )
+bool ClientSession::Value::operator==( const Value& oth ) const
 {
-    PyTuple* v = _GetValueTuple( name );
-    if( v == NULL )
+    if( kind != oth.kind )
+        return false;
+
+    switch( kind )
     {
-        v = new PyTuple( 2 );
-        v->SetItem( 0, new PyNone );
-        v->SetItem( 1, new PyNone );
-        mSession->SetItemString( name, v );
+        case KIND_INT:
+        case KIND_LONG:     return number == oth.number;
+        case KIND_STRING:   return text == oth.text;
+        default:            return true;
     }
+}
 
-    PyRep* current = v->GetItem( 1 );
-    if( value->hash() != current->hash() )
+PyRep* ClientSession::Value::Encode() const
+{
+    switch( kind )
     {
-        //v->SetItem( 0, current ); /* didn't the session need to store the old value to? */
-        v->SetItem( 1, value );
-
-        mDirty = true;
+        case KIND_INT:      return new PyInt( (int32)number );
+        case KIND_LONG:     return new PyLong( number );
+        case KIND_STRING:   return new PyString( text );
+        default:            return new PyNone;
     }
-    else
+}
+
+void ClientSession::_Set( SessionSlot slot, const Value& value )
+{
+    Value& current = mSlots[ slot ].current;
+    if( current != value )
     {
-        PyDecRef( value );
+        current = value;
+        mDirty |= (uint64)1 << slot;
     }
 }
-
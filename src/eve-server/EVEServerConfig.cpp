@@ -46,6 +46,9 @@ EVEServerConfig::EVEServerConfig()
     // account
     account.autoAccountRole = 0;
     account.loginMessage = "";
+    account.loginRate = 10;
+    account.loginBurst = 5;
+    account.maxPendingLogins = 256;
 
     // character
     character.startBalance = 6666000000.0f;
@@ -53,6 +56,8 @@ EVEServerConfig::EVEServerConfig()
     character.startSecRating = 0.0;
     character.startCorporation = 0;
     character.terminationDelay = 90 /*s*/;
+    character.skillSweepInterval = 300 /*s*/;
+    character.skillSweepBatch = 50;
 
     // database
     database.host = "localhost";
@@ -60,12 +65,27 @@ EVEServerConfig::EVEServerConfig()
     database.username = "eve";
     database.password = "eve";
     database.db = "evemu";
+    database.poolSize = 4;
+    database.pingInterval = 300 /*s*/;
+    database.asyncThreads = 2;
+    database.writeBehindInterval = 1000 /*ms*/;
+    database.slowQueryThreshold = 500 /*ms*/;
+    database.indexAdvisor = false;
+    database.replicas = "";
+    database.maxReplicaLag = 30 /*s*/;
+    database.lagCheckInterval = 10 /*s*/;
 
     // files
     files.logDir = "../log/";
     files.logSettings = "../etc/log.ini";
+    files.asyncLog = true;
+    files.logQueueSize = 16384;
     files.cacheDir = "../server_cache/";
     files.imageDir = "../image_cache/";
+    files.staticDataSnapshot = "";
+    files.warmStart = "../server_cache/warm.start";
+    files.marketJournal = "../log/market.journal";
+    files.captureDir = "../capture/";
 
     // net
     net.port = 26000;
@@ -73,6 +93,47 @@ EVEServerConfig::EVEServerConfig()
     net.imageServerPort = 26001;
     net.apiServer = "localhost";
     net.apiServerPort = 50001;
+    net.apiCacheSize = 16 * 1024 * 1024;
+    net.apiIoThreads = 2;
+    net.apiWorkerThreads = 4;
+    net.apiKeepAliveTimeout = 15;
+    net.imageIoThreads = 2;
+    net.imageCacheSize = 16 * 1024 * 1024;
+    net.ioThreads = 2;
+    net.encoderThreads = 2;
+    net.deflationLimit = 0x2000;
+    net.deflationLevel = Z_DEFAULT_COMPRESSION;
+    net.callDeflationLimit = 0x2000;
+    net.callDeflationLevel = Z_DEFAULT_COMPRESSION;
+    net.notifyDeflationLimit = 0x2000;
+    net.notifyDeflationLevel = Z_DEFAULT_COMPRESSION;
+    net.captureAccounts = "";
+    net.sendQueueLimit = 8 * 1024 * 1024;
+    net.sessionTimeout = 300;
+    net.idleSessionTimeout = 900;
+
+    // loop
+    loop.eventDriven = true;
+    loop.maxIdleTime = 100;
+    loop.statsInterval = 0;
+    loop.callStats = false;
+    loop.tickProfiler = true;
+    loop.slowTickThreshold = 250;
+    loop.slowTickHistory = 10;
+    loop.memorySampleRate = 0;
+    loop.callTraceRate = 0;
+    loop.callTraceHistory = 32;
+    loop.callTraceLog = true;
+
+    // world
+    world.systemPreloadLimit = 32;
+    world.itemCacheSize = 200000;
+    world.fittingCacheSize = 4096;
+    world.destinyUpdateBudget = 65536;
+    world.destinyResyncInterval = 10;
+    world.shipGracePeriod = 300 /*s*/;
+    world.asteroidSnapshotInterval = 300 /*s*/;
+    world.solNodes = 1;
 }
 
 bool EVEServerConfig::ProcessEveServer( const TiXmlElement* ele )
@@ -84,6 +145,8 @@ bool EVEServerConfig::ProcessEveServer( const TiXmlElement* ele )
     AddMemberParser( "database",  &EVEServerConfig::ProcessDatabase );
     AddMemberParser( "files",     &EVEServerConfig::ProcessFiles );
     AddMemberParser( "net",       &EVEServerConfig::ProcessNet );
+    AddMemberParser( "loop",      &EVEServerConfig::ProcessLoop );
+    AddMemberParser( "world",     &EVEServerConfig::ProcessWorld );
 
     // parse the element
     const bool result = ParseElementChildren( ele );
@@ -95,6 +158,8 @@ bool EVEServerConfig::ProcessEveServer( const TiXmlElement* ele )
     RemoveParser( "database" );
     RemoveParser( "files" );
     RemoveParser( "net" );
+    RemoveParser( "loop" );
+    RemoveParser( "world" );
 
     // return status of parsing
     return result;
@@ -121,11 +186,17 @@ bool EVEServerConfig::ProcessAccount( const TiXmlElement* ele )
 {
     AddValueParser( "autoAccountRole", account.autoAccountRole );
     AddValueParser( "loginMessage",    account.loginMessage );
+    AddValueParser( "loginRate",       account.loginRate );
+    AddValueParser( "loginBurst",      account.loginBurst );
+    AddValueParser( "maxPendingLogins", account.maxPendingLogins );
 
     const bool result = ParseElementChildren( ele );
 
     RemoveParser( "autoAccountRole" );
     RemoveParser( "loginMessage" );
+    RemoveParser( "loginRate" );
+    RemoveParser( "loginBurst" );
+    RemoveParser( "maxPendingLogins" );
 
     return result;
 }
@@ -137,6 +208,8 @@ bool EVEServerConfig::ProcessCharacter( const TiXmlElement* ele )
     AddValueParser( "startSecRating", character.startSecRating );
     AddValueParser( "startCorporation", character.startCorporation );
     AddValueParser( "terminationDelay", character.terminationDelay );
+    AddValueParser( "skillSweepInterval", character.skillSweepInterval );
+    AddValueParser( "skillSweepBatch", character.skillSweepBatch );
 
     const bool result = ParseElementChildren( ele );
 
@@ -145,17 +218,28 @@ bool EVEServerConfig::ProcessCharacter( const TiXmlElement* ele )
     RemoveParser( "startSecRating" );
     RemoveParser( "startCorporation" );
     RemoveParser( "terminationDelay" );
+    RemoveParser( "skillSweepInterval" );
+    RemoveParser( "skillSweepBatch" );
 
     return result;
 }
 
 bool EVEServerConfig::ProcessDatabase( const TiXmlElement* ele )
 {
-    AddValueParser( "host",     database.host );
-    AddValueParser( "port",     database.port );
-    AddValueParser( "username", database.username );
-    AddValueParser( "password", database.password );
-    AddValueParser( "db",       database.db );
+    AddValueParser( "host",                database.host );
+    AddValueParser( "port",                database.port );
+    AddValueParser( "username",            database.username );
+    AddValueParser( "password",            database.password );
+    AddValueParser( "db",                  database.db );
+    AddValueParser( "poolSize",            database.poolSize );
+    AddValueParser( "pingInterval",        database.pingInterval );
+    AddValueParser( "asyncThreads",        database.asyncThreads );
+    AddValueParser( "writeBehindInterval", database.writeBehindInterval );
+    AddValueParser( "slowQueryThreshold",  database.slowQueryThreshold );
+    AddValueParser( "indexAdvisor",        database.indexAdvisor );
+    AddValueParser( "replicas",            database.replicas );
+    AddValueParser( "maxReplicaLag",       database.maxReplicaLag );
+    AddValueParser( "lagCheckInterval",    database.lagCheckInterval );
 
     const bool result = ParseElementChildren( ele );
 
@@ -164,6 +248,15 @@ bool EVEServerConfig::ProcessDatabase( const TiXmlElement* ele )
     RemoveParser( "username" );
     RemoveParser( "password" );
     RemoveParser( "db" );
+    RemoveParser( "poolSize" );
+    RemoveParser( "pingInterval" );
+    RemoveParser( "asyncThreads" );
+    RemoveParser( "writeBehindInterval" );
+    RemoveParser( "slowQueryThreshold" );
+    RemoveParser( "indexAdvisor" );
+    RemoveParser( "replicas" );
+    RemoveParser( "maxReplicaLag" );
+    RemoveParser( "lagCheckInterval" );
 
     return result;
 }
@@ -172,15 +265,27 @@ bool EVEServerConfig::ProcessFiles( const TiXmlElement* ele )
 {
     AddValueParser( "logDir",      files.logDir );
     AddValueParser( "logSettings", files.logSettings );
+    AddValueParser( "asyncLog",    files.asyncLog );
+    AddValueParser( "logQueueSize", files.logQueueSize );
     AddValueParser( "cacheDir",    files.cacheDir );
     AddValueParser( "imageDir",       files.imageDir );
+    AddValueParser( "staticDataSnapshot", files.staticDataSnapshot );
+    AddValueParser( "warmStart", files.warmStart );
+    AddValueParser( "marketJournal", files.marketJournal );
+    AddValueParser( "captureDir", files.captureDir );
 
     const bool result = ParseElementChildren( ele );
 
     RemoveParser( "logDir" );
     RemoveParser( "logSettings" );
+    RemoveParser( "asyncLog" );
+    RemoveParser( "logQueueSize" );
     RemoveParser( "cacheDir" );
     RemoveParser( "imageDir" );
+    RemoveParser( "staticDataSnapshot" );
+    RemoveParser( "warmStart" );
+    RemoveParser( "marketJournal" );
+    RemoveParser( "captureDir" );
 
     return result;
 }
@@ -192,6 +297,24 @@ bool EVEServerConfig::ProcessNet( const TiXmlElement* ele )
     AddValueParser( "imageServer", net.imageServer);
     AddValueParser( "apiServerPort", net.apiServerPort);
     AddValueParser( "apiServer", net.apiServer);
+    AddValueParser( "apiCacheSize", net.apiCacheSize );
+    AddValueParser( "apiIoThreads", net.apiIoThreads );
+    AddValueParser( "apiWorkerThreads", net.apiWorkerThreads );
+    AddValueParser( "apiKeepAliveTimeout", net.apiKeepAliveTimeout );
+    AddValueParser( "imageIoThreads", net.imageIoThreads );
+    AddValueParser( "imageCacheSize", net.imageCacheSize );
+    AddValueParser( "ioThreads", net.ioThreads );
+    AddValueParser( "encoderThreads", net.encoderThreads );
+    AddValueParser( "deflationLimit", net.deflationLimit );
+    AddValueParser( "deflationLevel", net.deflationLevel );
+    AddValueParser( "callDeflationLimit", net.callDeflationLimit );
+    AddValueParser( "callDeflationLevel", net.callDeflationLevel );
+    AddValueParser( "notifyDeflationLimit", net.notifyDeflationLimit );
+    AddValueParser( "notifyDeflationLevel", net.notifyDeflationLevel );
+    AddValueParser( "captureAccounts", net.captureAccounts );
+    AddValueParser( "sendQueueLimit", net.sendQueueLimit );
+    AddValueParser( "sessionTimeout", net.sessionTimeout );
+    AddValueParser( "idleSessionTimeout", net.idleSessionTimeout );
 
     const bool result = ParseElementChildren( ele );
 
@@ -200,6 +323,80 @@ bool EVEServerConfig::ProcessNet( const TiXmlElement* ele )
     RemoveParser( "imageServer" );
     RemoveParser( "apiServerPort" );
     RemoveParser( "apiServer" );
+    RemoveParser( "apiCacheSize" );
+    RemoveParser( "apiIoThreads" );
+    RemoveParser( "apiWorkerThreads" );
+    RemoveParser( "apiKeepAliveTimeout" );
+    RemoveParser( "imageIoThreads" );
+    RemoveParser( "imageCacheSize" );
+    RemoveParser( "ioThreads" );
+    RemoveParser( "encoderThreads" );
+    RemoveParser( "deflationLimit" );
+    RemoveParser( "deflationLevel" );
+    RemoveParser( "callDeflationLimit" );
+    RemoveParser( "callDeflationLevel" );
+    RemoveParser( "notifyDeflationLimit" );
+    RemoveParser( "notifyDeflationLevel" );
+    RemoveParser( "captureAccounts" );
+    RemoveParser( "sendQueueLimit" );
+    RemoveParser( "sessionTimeout" );
+    RemoveParser( "idleSessionTimeout" );
+
+    return result;
+}
+
+bool EVEServerConfig::ProcessLoop( const TiXmlElement* ele )
+{
+    AddValueParser( "eventDriven",       loop.eventDriven );
+    AddValueParser( "maxIdleTime",       loop.maxIdleTime );
+    AddValueParser( "statsInterval",     loop.statsInterval );
+    AddValueParser( "callStats",         loop.callStats );
+    AddValueParser( "tickProfiler",      loop.tickProfiler );
+    AddValueParser( "slowTickThreshold", loop.slowTickThreshold );
+    AddValueParser( "slowTickHistory",   loop.slowTickHistory );
+    AddValueParser( "memorySampleRate",  loop.memorySampleRate );
+    AddValueParser( "callTraceRate",     loop.callTraceRate );
+    AddValueParser( "callTraceHistory",  loop.callTraceHistory );
+    AddValueParser( "callTraceLog",      loop.callTraceLog );
+
+    const bool result = ParseElementChildren( ele );
+
+    RemoveParser( "eventDriven" );
+    RemoveParser( "maxIdleTime" );
+    RemoveParser( "statsInterval" );
+    RemoveParser( "callStats" );
+    RemoveParser( "tickProfiler" );
+    RemoveParser( "slowTickThreshold" );
+    RemoveParser( "slowTickHistory" );
+    RemoveParser( "memorySampleRate" );
+    RemoveParser( "callTraceRate" );
+    RemoveParser( "callTraceHistory" );
+    RemoveParser( "callTraceLog" );
+
+    return result;
+}
+
+bool EVEServerConfig::ProcessWorld( const TiXmlElement* ele )
+{
+    AddValueParser( "systemPreloadLimit",    world.systemPreloadLimit );
+    AddValueParser( "itemCacheSize",         world.itemCacheSize );
+    AddValueParser( "fittingCacheSize",      world.fittingCacheSize );
+    AddValueParser( "destinyUpdateBudget",   world.destinyUpdateBudget );
+    AddValueParser( "destinyResyncInterval", world.destinyResyncInterval );
+    AddValueParser( "shipGracePeriod",       world.shipGracePeriod );
+    AddValueParser( "asteroidSnapshotInterval", world.asteroidSnapshotInterval );
+    AddValueParser( "solNodes",              world.solNodes );
+
+    const bool result = ParseElementChildren( ele );
+
+    RemoveParser( "systemPreloadLimit" );
+    RemoveParser( "itemCacheSize" );
+    RemoveParser( "fittingCacheSize" );
+    RemoveParser( "destinyUpdateBudget" );
+    RemoveParser( "destinyResyncInterval" );
+    RemoveParser( "shipGracePeriod" );
+    RemoveParser( "asteroidSnapshotInterval" );
+    RemoveParser( "solNodes" );
 
     return result;
 }
@@ -30,6 +30,24 @@
 #include "ship/DestinyManager.h"
 #include "system/SystemManager.h"
 
+/** @return Histogram of the durations of EntityList::Process(). */
+static MetricHistogram& EntityTickMetric()
+{
+    static MetricHistogram& metric = sMetrics.LatencyHistogram( "evemu_entity_list_tick_seconds", "Time the clients and solar systems took to process in a tick." );
+    return metric;
+}
+
+EntityList::index_keys::index_keys()
+: characterID( 0 ),
+  accountID( 0 ),
+  corporationID( 0 ),
+  locationID( 0 ),
+  stationID( 0 ),
+  solarSystemID( 0 ),
+  regionID( 0 )
+{
+}
+
 EntityList::EntityList() : m_services( NULL ) {}
 EntityList::~EntityList() {
     {
@@ -58,11 +76,91 @@ void EntityList::Add(Client **client) {
         return;
 
     m_clients.push_back(*client);
+    UpdateIndexes(*client);
     *client = NULL;
 }
 
+template<typename K>
+void EntityList::_Reindex(std::tr1::unordered_map<K, client_set> &index, Client *client, K &key, const K &new_key) {
+    if(key == new_key)
+        return;
+
+    //default (zero/empty) keys are not indexed.
+    if(key != K()) {
+        typename std::tr1::unordered_map<K, client_set>::iterator res = index.find(key);
+        if(res != index.end()) {
+            res->second.erase(client);
+            if(res->second.empty())
+                index.erase(res);
+        }
+    }
+
+    key = new_key;
+
+    if(key != K())
+        index[key].insert(client);
+}
+
+template<typename K>
+void EntityList::_Collect(const std::tr1::unordered_map<K, client_set> &index, const K &key, std::vector<Client *> &result) {
+    typename std::tr1::unordered_map<K, client_set>::const_iterator res = index.find(key);
+    if(res != index.end())
+        result.insert(result.end(), res->second.begin(), res->second.end());
+}
+
+void EntityList::UpdateIndexes(Client *client) {
+    index_keys &keys = m_indexKeys[client];
+
+    CharacterRef c = client->GetChar();
+
+    _Reindex(m_byCharacter, client, keys.characterID, client->GetCharacterID());
+    _Reindex(m_byName, client, keys.name, c ? c->itemName() : std::string());
+    _Reindex(m_byAccount, client, keys.accountID, client->GetAccountID());
+    _Reindex(m_byCorporation, client, keys.corporationID, client->GetCorporationID());
+    _Reindex(m_byLocation, client, keys.locationID, client->GetLocationID());
+    _Reindex(m_byStation, client, keys.stationID, client->GetStationID());
+    _Reindex(m_bySolarSystem, client, keys.solarSystemID, client->GetSystemID());
+    _Reindex(m_byRegion, client, keys.regionID, client->GetRegionID());
+}
+
+void EntityList::_RemoveIndexes(Client *client) {
+    //the client may be already gone, use the pointer as a key only.
+    client_keys::iterator res = m_indexKeys.find(client);
+    if(res == m_indexKeys.end())
+        return;
+
+    index_keys &keys = res->second;
+    _Reindex(m_byCharacter, client, keys.characterID, uint32(0));
+    _Reindex(m_byName, client, keys.name, std::string());
+    _Reindex(m_byAccount, client, keys.accountID, uint32(0));
+    _Reindex(m_byCorporation, client, keys.corporationID, uint32(0));
+    _Reindex(m_byLocation, client, keys.locationID, uint32(0));
+    _Reindex(m_byStation, client, keys.stationID, uint32(0));
+    _Reindex(m_bySolarSystem, client, keys.solarSystemID, uint32(0));
+    _Reindex(m_byRegion, client, keys.regionID, uint32(0));
+
+    m_indexKeys.erase(res);
+}
+
+void EntityList::_FlushSessionChanges() {
+    //a client queued twice sends nothing the second time.
+    std::vector<Client *>::const_iterator cur, end;
+    cur = m_sessionChanges.begin();
+    end = m_sessionChanges.end();
+    for(; cur != end; cur++)
+        (*cur)->FlushSessionChange();
+
+    m_sessionChanges.clear();
+}
+
 void EntityList::Process()
 {
+    static MetricGauge& clientsMetric = sMetrics.Gauge( "evemu_clients", "Number of connected clients." );
+    static MetricGauge& systemsMetric = sMetrics.Gauge( "evemu_systems_booted", "Number of booted solar systems." );
+    static MetricGauge& bubblesMetric = sMetrics.Gauge( "evemu_bubbles", "Number of bubbles in the booted solar systems." );
+
+    const uint64 start = GetTimeUSeconds();
+
     Client *active_client = NULL;
     client_list::iterator client_cur = m_clients.begin();
     client_list::iterator client_end = m_clients.end();
@@ -75,6 +173,7 @@ void EntityList::Process()
         {
             sLog.Log("Entity List", "Destroying client for account %u", active_client->GetAccountID());
             SafeDelete(active_client);
+            _RemoveIndexes(*client_cur);
 
             client_tmp = client_cur++;
             m_clients.erase( client_tmp );
@@ -95,6 +194,7 @@ void EntityList::Process()
     //}
 
     //first process any systems, watching for deletion.
+    size_t bubbleCount = 0;
     system_list::iterator cur, end, tmp;
     cur = m_systems.begin();
     end = m_systems.end();
@@ -111,55 +211,52 @@ void EntityList::Process()
         {
             sLog.Log("Entity List", "Destroying system");
             tmp = cur++;
-            delete cur->second;
+            delete tmp->second;
             m_systems.erase(tmp);
         }
         else
         {
+            bubbleCount += active_system->bubbles.GetBubbleCount();
             cur++;
         }
     }
+    //the session changes of this tic go out before its destiny updates.
+    _FlushSessionChanges();
+
     if( destiny == true )
     {
+        //everything the clients got during this tic goes out in a single bundle.
+        client_cur = m_clients.begin();
+        client_end = m_clients.end();
+        for(; client_cur != client_end; client_cur++)
+            (*client_cur)->FlushDestinyUpdates();
+
         DestinyManager::TicCompleted();
     }
+
+    clientsMetric.Set( m_clients.size() );
+    systemsMetric.Set( m_systems.size() );
+    bubblesMetric.Set( bubbleCount );
+    EntityTickMetric().Observe( GetTimeUSeconds() - start );
 }
 
 Client *EntityList::FindCharacter(uint32 char_id) const {
-    //could likely improve this with a map, but its a little more work since
-    //clients are added to the list before we know who they are.
-
-    client_list::const_iterator cur, end;
-    cur = m_clients.begin();
-    end = m_clients.end();
-    for(; cur != end; cur++) {
-        if((*cur)->GetCharacterID() == char_id)
-            return(*cur);
-    }
-    return NULL;
+    client_index::const_iterator res = m_byCharacter.find(char_id);
+    if(res == m_byCharacter.end())
+        return NULL;
+    return *res->second.begin();
 }
 
 Client *EntityList::FindCharacter(const char *name) const {
-    //could likely improve this with a map, but its a little more work since
-    //clients are added to the list before we know who they are.
-
-    client_list::const_iterator cur, end;
-    cur = m_clients.begin();
-    end = m_clients.end();
-    for(; cur != end; cur++) {
-        CharacterRef c = (*cur)->GetChar();
-
-        if( c ) {
-            if( c->itemName() == name )
-                return *cur;
-        }
-    }
-    return NULL;
+    client_name_index::const_iterator res = m_byName.find(name);
+    if(res == m_byName.end())
+        return NULL;
+    return *res->second.begin();
 }
 
 Client *EntityList::FindByShip(uint32 ship_id) const {
-    //could likely improve this with a map, but its a little more work since
-    //clients are added to the list before we know who they are.
+    //could likely improve this with a map, but the ship is not
+    //a session value, so we are not told when it changes.
 
     client_list::const_iterator cur, end;
     cur = m_clients.begin();
@@ -172,41 +269,42 @@ Client *EntityList::FindByShip(uint32 ship_id) const {
 }
 
 Client *EntityList::FindAccount(uint32 account_id) const {
-    //could likely improve this with a map, but its a little more work since
-    //clients are added to the list before we know who they are.
-
-    client_list::const_iterator cur, end;
-    cur = m_clients.begin();
-    end = m_clients.end();
-    for(; cur != end; cur++) {
-        if((*cur)->GetAccountID() == account_id)
-            return(*cur);
-    }
-    return NULL;
+    client_index::const_iterator res = m_byAccount.find(account_id);
+    if(res == m_byAccount.end())
+        return NULL;
+    return *res->second.begin();
 }
 
 void EntityList::FindByStationID(uint32 stationID, std::vector<Client *> &result) const {
-    //this could likely be done better
+    _Collect(m_byStation, stationID, result);
+}
 
-    client_list::const_iterator cur, end;
-    cur = m_clients.begin();
-    end = m_clients.end();
-    for(; cur != end; cur++) {
-        if((*cur)->GetStationID() == stationID)
-            result.push_back(*cur);
-    }
+void EntityList::FindBySolarSystemID(uint32 solarSystemID, std::vector<Client *> &result) const {
+    _Collect(m_bySolarSystem, solarSystemID, result);
 }
 
 void EntityList::FindByRegionID(uint32 regionID, std::vector<Client *> &result) const {
-    //this could likely be done better
+    _Collect(m_byRegion, regionID, result);
+}
 
-    client_list::const_iterator cur, end;
-    cur = m_clients.begin();
-    end = m_clients.end();
-    for(; cur != end; cur++) {
-        if((*cur)->GetRegionID() == regionID)
-            result.push_back(*cur);
-    }
+void EntityList::FindByCorporationID(uint32 corporationID, std::vector<Client *> &result) const {
+    _Collect(m_byCorporation, corporationID, result);
+}
+
+//marshals the notification once, so all the recipients can share it.
+static EVESharedPayloadRef MakeSharedNotification(PyTuple **payload) {
+    EVENotificationStream notify;
+    notify.remoteObject = 1;
+    notify.args = *payload;
+    *payload = NULL;    //consumed
+
+    PyTuple *t = notify.Encode();
+    return EVESharedPayloadRef( new EVESharedPayload( &t ) );
+}
+
+static EVESharedPayloadRef MakeSharedNotification(EVENotificationStream &noti) {
+    PyTuple *t = noti.Encode();
+    return EVESharedPayloadRef( new EVESharedPayload( &t ) );
 }
 
 void EntityList::Broadcast(const char *notifyType, const char *idType, PyTuple **payload) const {
@@ -225,25 +323,32 @@ void EntityList::Broadcast(const char *notifyType, const char *idType, PyTuple *
 }
 
 void EntityList::Broadcast(const PyAddress &dest, EVENotificationStream &noti) const {
+    if(m_clients.empty())
+        return;
+
+    EVESharedPayloadRef shared = MakeSharedNotification(noti);
+
     client_list::const_iterator cur, end;
     cur = m_clients.begin();
     end = m_clients.end();
     for(; cur != end; cur++) {
-        (*cur)->SendNotification(dest, noti);
+        (*cur)->SendNotification(dest, *shared);
     }
 }
 
 void EntityList::Multicast(const character_set &cset, const PyAddress &dest, EVENotificationStream &noti) const {
-    //this could likely be done better
-
     std::vector<Client *> result;
     GetClients(cset, result);
+    if(result.empty())
+        return;
+
+    EVESharedPayloadRef shared = MakeSharedNotification(noti);
 
     std::vector<Client *>::iterator cur, end;
     cur = result.begin();
     end = result.end();
     for(; cur != end; cur++) {
-        (*cur)->SendNotification(dest, noti);
+        (*cur)->SendNotification(dest, *shared);
     }
 }
 
@@ -251,104 +356,129 @@ void EntityList::Multicast(const character_set &cset, const PyAddress &dest, EVE
 //MulticastTarget function, but this is much more efficient.
 void EntityList::Multicast( const char* notifyType, const char* idType, PyTuple** payload, NotificationDestination target, uint32 target_id, bool seq )
 {
-    PyTuple* p = *payload;
-    *payload = NULL;
+    const client_index* index = NULL;
+    switch( target )
+    {
+    case NOTIF_DEST__LOCATION:
+        index = &m_byLocation;
+        break;
+    case NOTIF_DEST__CORPORATION:
+        index = &m_byCorporation;
+        break;
+    }
 
-    std::list<Client*>::const_iterator cur, end;
-    cur = m_clients.begin();
-    end = m_clients.end();
-    for(; cur != end; cur++)
+    client_index::const_iterator res;
+    if( index != NULL && ( res = index->find( target_id ) ) != index->end() )
     {
-        switch( target )
-        {
-        case NOTIF_DEST__LOCATION:
-            if( (*cur)->GetLocationID() != target_id )
-                continue;
-            break;
-        case NOTIF_DEST__CORPORATION:
-            if( (*cur)->GetCorporationID() != target_id )
-                continue;
-            break;
-        }
+        PyAddress dest;
+        dest.type = PyAddress::Broadcast;
+        dest.service = notifyType;
+        dest.bcast_idtype = idType;
 
-        PyTuple* temp = new PyTuple( *p );
-        (*cur)->SendNotification( notifyType, idType, &temp, seq );
+        EVESharedPayloadRef shared = MakeSharedNotification( payload );
+
+        client_set::const_iterator cur, end;
+        cur = res->second.begin();
+        end = res->second.end();
+        for(; cur != end; cur++)
+            (*cur)->SendNotification( dest, *shared, seq );
     }
 
-    PyDecRef( p );
+    PySafeDecRef( *payload );
+    *payload = NULL;
 }
 
 void EntityList::Multicast(const char *notifyType, const char *idType, PyTuple **in_payload, const MulticastTarget &mcset, bool seq)
 {
-    // consume payload
-    PyTuple *payload = *in_payload;
-    *in_payload = NULL;
+    //matching any criteria is sufficient, but everybody gets it just once.
+    client_set recipients;
 
-    //cache all these locally to avoid calling empty all the time.
-    const bool chars_empty = mcset.characters.empty();
-    const bool locs_empty = mcset.locations.empty();
-    const bool corps_empty = mcset.corporations.empty();
+    std::set<uint32>::const_iterator cur, end;
+    client_index::const_iterator res;
 
-    if( !chars_empty || !locs_empty || !corps_empty )
-    {
-        std::list<Client *>::const_iterator cur, end;
-        cur = m_clients.begin();
-        end = m_clients.end();
-        for(; cur != end; cur++)
-        {
-            if(      !chars_empty
-                 && mcset.characters.find((*cur)->GetCharacterID()) != mcset.characters.end() )
-            {
-                //found, carry on...
-            }
-            else if(   !locs_empty
-                      && mcset.locations.find((*cur)->GetLocationID()) != mcset.locations.end() )
-            {
-                //found, carry on...
-            }
-            else if(   !corps_empty
-                      && mcset.corporations.find((*cur)->GetCorporationID()) != mcset.corporations.end() )
-            {
-                //found, carry on...
-            }
-            else
-            {
-                //not found in any of the above sets.
-                continue;
-            }
-
-            PyTuple *temp = new PyTuple( *payload );
-            (*cur)->SendNotification( notifyType, idType, &temp, seq );
+    cur = mcset.characters.begin();
+    end = mcset.characters.end();
+    for(; cur != end; cur++)
+        if( ( res = m_byCharacter.find( *cur ) ) != m_byCharacter.end() )
+            recipients.insert( res->second.begin(), res->second.end() );
 
-        }
+    cur = mcset.locations.begin();
+    end = mcset.locations.end();
+    for(; cur != end; cur++)
+        if( ( res = m_byLocation.find( *cur ) ) != m_byLocation.end() )
+            recipients.insert( res->second.begin(), res->second.end() );
+
+    cur = mcset.corporations.begin();
+    end = mcset.corporations.end();
+    for(; cur != end; cur++)
+        if( ( res = m_byCorporation.find( *cur ) ) != m_byCorporation.end() )
+            recipients.insert( res->second.begin(), res->second.end() );
+
+    if( !recipients.empty() )
+    {
+        PyAddress dest;
+        dest.type = PyAddress::Broadcast;
+        dest.service = notifyType;
+        dest.bcast_idtype = idType;
+
+        EVESharedPayloadRef shared = MakeSharedNotification( in_payload );
+
+        client_set::const_iterator rcur, rend;
+        rcur = recipients.begin();
+        rend = recipients.end();
+        for(; rcur != rend; rcur++)
+            (*rcur)->SendNotification( dest, *shared, seq );
     }
 
-    PyDecRef( payload );
+    // consume payload if nobody did
+    PySafeDecRef( *in_payload );
+    *in_payload = NULL;
 }
 
 void EntityList::Multicast(const character_set &cset, const char *notifyType, const char *idType, PyTuple **in_payload, bool seq) const {
     std::vector<Client *> result;
     GetClients(cset, result);
 
-    int num_remaining = result.size();
+    if(result.empty() || *in_payload == NULL) {
+        PySafeDecRef(*in_payload);
+        *in_payload = NULL;
+        return;
+    }
+
+    PyAddress dest;
+    dest.type = PyAddress::Broadcast;
+    dest.service = notifyType;
+    dest.bcast_idtype = idType;
+
+    EVESharedPayloadRef shared = MakeSharedNotification(in_payload);
 
     std::vector<Client *>::iterator cur, end;
     cur = result.begin();
     end = result.end();
-    PyTuple *payload;
-    for(; cur != end; cur++, num_remaining--) {
-        //keep a counter to eliminate an extra copy of in_payload
-        if(num_remaining < 2) {
-            payload = *in_payload;
-            *in_payload = NULL;
-        } else {
-            if(*in_payload == NULL)
-                payload = NULL;
-            else
-                payload = (PyTuple *) (*in_payload)->Clone();
-        }
+    for(; cur != end; cur++) {
+        (*cur)->SendNotification(dest, *shared, seq);
+    }
+}
 
-        (*cur)->SendNotification(notifyType, idType, &payload, seq);
+void EntityList::Multicast(const std::vector<Client *> &clients, const char *notifyType, const char *idType, PyTuple **in_payload, bool seq) const {
+    if(clients.empty() || *in_payload == NULL) {
+        PySafeDecRef(*in_payload);
+        *in_payload = NULL;
+        return;
+    }
+
+    PyAddress dest;
+    dest.type = PyAddress::Broadcast;
+    dest.service = notifyType;
+    dest.bcast_idtype = idType;
+
+    EVESharedPayloadRef shared = MakeSharedNotification(in_payload);
+
+    std::vector<Client *>::const_iterator cur, end;
+    cur = clients.begin();
+    end = clients.end();
+    for(; cur != end; cur++) {
+        (*cur)->SendNotification(dest, *shared, seq);
     }
 }
 
@@ -360,20 +490,69 @@ void EntityList::Unicast(uint32 charID, const char *notifyType, const char *idTy
 }
 
 void EntityList::GetClients(const character_set &cset, std::vector<Client *> &result) const {
-    //this could likely be done better
+    character_set::const_iterator cur, end;
+    cur = cset.begin();
+    end = cset.end();
+    for(; cur != end; cur++)
+        _Collect(m_byCharacter, *cur, result);
+}
 
-    character_set::const_iterator res;
-    client_list::const_iterator cur, end;
-    cur = m_clients.begin();
-    end = m_clients.end();
-    for(; cur != end; cur++) {
-        res = cset.find((*cur)->GetCharacterID());
-        if(res != cset.end()) {
-            result.push_back(*cur);
+void EntityList::GetClients(std::vector<Client *> &result) const {
+    result.insert(result.end(), m_clients.begin(), m_clients.end());
+}
+
+void EntityList::GetSystemTickStats(SystemTickStats &into) const
+{
+    into.Reset();
+    into.systems = m_systems.size();
+
+    system_list::const_iterator cur, end;
+    cur = m_systems.begin();
+    end = m_systems.end();
+    for(; cur != end; cur++)
+    {
+        const SystemManager::TickStats &stats = cur->second->tickStats();
+
+        into.ticks += stats.ticks;
+        into.tickTime += stats.tickTime;
+        if(into.maxTickTime < stats.maxTickTime)
+            into.maxTickTime = stats.maxTickTime;
+        into.destinyTime += stats.destinyTime;
+        if(into.maxDestinyTime < stats.maxDestinyTime)
+            into.maxDestinyTime = stats.maxDestinyTime;
+        into.aiThinks += stats.aiThinks;
+        into.aiTime += stats.aiTime;
+
+        const uint64 time = stats.tickTime + stats.destinyTime;
+        if(into.busiestTime < time)
+        {
+            into.busiestSystemID = cur->first;
+            into.busiestTime = time;
         }
     }
 }
 
+void EntityList::GetSystemTimes(std::map<uint32, uint64> &into) const
+{
+    system_list::const_iterator cur, end;
+    cur = m_systems.begin();
+    end = m_systems.end();
+    for(; cur != end; cur++)
+    {
+        const SystemManager::TickStats &stats = cur->second->tickStats();
+        into[cur->first] = stats.tickTime + stats.destinyTime;
+    }
+}
+
+void EntityList::ResetSystemTickStats()
+{
+    system_list::const_iterator cur, end;
+    cur = m_systems.begin();
+    end = m_systems.end();
+    for(; cur != end; cur++)
+        cur->second->ResetTickStats();
+}
+
 SystemManager *EntityList::FindOrBootSystem(uint32 systemID) {
     system_list::iterator res;
     res = m_systems.find(systemID);
@@ -391,11 +570,27 @@ SystemManager *EntityList::FindOrBootSystem(uint32 systemID) {
     );
 */
     SystemManager *mgr = new SystemManager(systemID, *m_services);//, idata);
-    if(!mgr->BootSystem()) {
+
+    DBSystemState *state = m_preloader.Take(systemID);
+    const bool booted = (state != NULL ? mgr->BootSystem(*state) : mgr->BootSystem());
+    SafeDelete( state );
+
+    if(!booted) {
         delete mgr;
         return NULL;
     }
 
     m_systems[systemID] = mgr;
+    _PreloadNeighbours(*mgr);
     return mgr;
 }
+
+void EntityList::_PreloadNeighbours(const SystemManager &system) {
+    std::set<uint32>::const_iterator cur, end;
+    cur = system.GetNeighbours().begin();
+    end = system.GetNeighbours().end();
+    for(; cur != end; cur++) {
+        if(m_systems.find(*cur) == m_systems.end())
+            m_preloader.Preload(*cur);
+    }
+}
@@ -33,7 +33,9 @@ PyCallable_Make_InnerDispatcher(NetService)
 
 NetService::NetService(PyServiceMgr *mgr)
 : PyService(mgr, "machoNet"),
-  m_dispatch(new Dispatcher(this))
+  m_dispatch(new Dispatcher(this)),
+  m_initVals(NULL),
+  m_initValsGeneration(0)
 {
     _SetCallDispatcher(m_dispatch);
 
@@ -42,133 +44,158 @@ NetService::NetService(PyServiceMgr *mgr)
 }
 
 NetService::~NetService() {
+    PySafeDecRef( m_initVals );
+
     delete m_dispatch;
 }
 
+void NetService::PrimeCache() {
+    _BuildInitVals();
+}
+
 PyResult NetService::Handle_GetInitVals(PyCallArgs &call) {
+    //the hint goes stale once the cache changes
+    if(m_initVals == NULL || m_initValsGeneration != m_manager->cache_service->GetGeneration())
+        _BuildInitVals();
+
+    PyIncRef( m_initVals );
+    return m_initVals;
+}
+
+void NetService::_BuildInitVals() {
     PyString* str = new PyString( "machoNet.serviceInfo" );
 
     if(!m_manager->cache_service->IsCacheLoaded(str))
     {
-        PyDict *dict = new PyDict;
-        /* ServiceCallGPCS.py:197
-        where = self.machoNet.serviceInfo[service]
-        if where:
-            for (k, v,) in self.machoNet.serviceInfo.iteritems():
-                if ((k != service) and (v and (v.startswith(where) or where.startswith(v)))):
-                    nodeID = self.services.get(k, None)
-                    break
-        */
-        dict->SetItemString("trademgr", new PyString("station"));
-        dict->SetItemString("tutorialSvc", new PyString("station"));
-        dict->SetItemString("bookmark", new PyString("station"));
-        dict->SetItemString("slash", new PyString("station"));
-        dict->SetItemString("wormholeMgr", new PyString("station"));
-        dict->SetItemString("account", new PyString("station"));
-        dict->SetItemString("gangSvc", new PyString("station"));
-        dict->SetItemString("contractMgr", new PyString("station"));
-
-        dict->SetItemString("LSC", new PyString("location"));
-        dict->SetItemString("station", new PyString("location"));
-        dict->SetItemString("config", new PyString("locationPreferred"));
-
-        dict->SetItemString("scanMgr", new PyString("solarsystem"));
-        dict->SetItemString("keeper", new PyString("solarsystem"));
-
-        dict->SetItemString("stationSvc", new PyNone());
-        dict->SetItemString("zsystem", new PyNone());
-        dict->SetItemString("invbroker", new PyNone());
-        dict->SetItemString("droneMgr", new PyNone());
-        dict->SetItemString("userSvc", new PyNone());
-        dict->SetItemString("map", new PyNone());
-        dict->SetItemString("beyonce", new PyNone());
-        dict->SetItemString("standing2", new PyNone());
-        dict->SetItemString("ram", new PyNone());
-        dict->SetItemString("DB", new PyNone());
-        dict->SetItemString("posMgr", new PyNone());
-        dict->SetItemString("voucher", new PyNone());
-        dict->SetItemString("entity", new PyNone());
-        dict->SetItemString("damageTracker", new PyNone());
-        dict->SetItemString("agentMgr", new PyNone());
-        dict->SetItemString("dogmaIM", new PyNone());
-        dict->SetItemString("machoNet", new PyNone());
-        dict->SetItemString("dungeonExplorationMgr", new PyNone());
-        dict->SetItemString("watchdog", new PyNone());
-        dict->SetItemString("ship", new PyNone());
-        dict->SetItemString("DB2", new PyNone());
-        dict->SetItemString("market", new PyNone());
-        dict->SetItemString("dungeon", new PyNone());
-        dict->SetItemString("npcSvc", new PyNone());
-        dict->SetItemString("sessionMgr", new PyNone());
-        dict->SetItemString("allianceRegistry", new PyNone());
-        dict->SetItemString("cache", new PyNone());
-        dict->SetItemString("character", new PyNone());
-        dict->SetItemString("factory", new PyNone());
-        dict->SetItemString("facWarMgr", new PyNone());
-        dict->SetItemString("corpStationMgr", new PyNone());
-        dict->SetItemString("authentication", new PyNone());
-        dict->SetItemString("effectCompiler", new PyNone());
-        dict->SetItemString("charmgr", new PyNone());
-        dict->SetItemString("BSD", new PyNone());
-        dict->SetItemString("reprocessingSvc", new PyNone());
-        dict->SetItemString("billingMgr", new PyNone());
-        dict->SetItemString("billMgr", new PyNone());
-        dict->SetItemString("lookupSvc", new PyNone());
-        dict->SetItemString("emailreader", new PyNone());
-        dict->SetItemString("lootSvc", new PyNone());
-        dict->SetItemString("http", new PyNone());
-        dict->SetItemString("repairSvc", new PyNone());
-        dict->SetItemString("gagger", new PyNone());
-        dict->SetItemString("dataconfig", new PyNone());
-        dict->SetItemString("lien", new PyNone());
-        dict->SetItemString("i2", new PyNone());
-        dict->SetItemString("pathfinder", new PyNone());
-        dict->SetItemString("alert", new PyNone());
-        dict->SetItemString("director", new PyNone());
-        dict->SetItemString("dogma", new PyNone());
-        dict->SetItemString("aggressionMgr", new PyNone());
-        dict->SetItemString("corporationSvc", new PyNone());
-        dict->SetItemString("certificateMgr", new PyNone());
-        dict->SetItemString("clones", new PyNone());
-        dict->SetItemString("jumpCloneSvc", new PyNone());
-        dict->SetItemString("insuranceSvc", new PyNone());
-        dict->SetItemString("corpmgr", new PyNone());
-        dict->SetItemString("warRegistry", new PyNone());
-        dict->SetItemString("corpRegistry", new PyNone());
-        dict->SetItemString("objectCaching", new PyNone());
-        dict->SetItemString("counter", new PyNone());
-        dict->SetItemString("petitioner", new PyNone());
-        dict->SetItemString("LPSvc", new PyNone());
-        dict->SetItemString("clientStatsMgr", new PyNone());
-        dict->SetItemString("jumpbeaconsvc", new PyNone());
-        dict->SetItemString("debug", new PyNone());
-        dict->SetItemString("languageSvc", new PyNone());
-        dict->SetItemString("skillMgr", new PyNone());
-        dict->SetItemString("voiceMgr", new PyNone());
-        dict->SetItemString("onlineStatus", new PyNone());
-        dict->SetItemString("gangSvcObjectHandler", new PyNone());
-        dict->SetItemString("sovMgr", new PyNone());
-        dict->SetItemString("planetMgr", new PyNone());
-        dict->SetItemString("charFittingMgr", new PyNone());
-        dict->SetItemString("dungeonExplorationMgr", new PyNone());
-        dict->SetItemString("fleetProxy", new PyNone());
-        dict->SetItemString("infoGatheringMgr", new PyNone());
-        dict->SetItemString("clientStatLogger", new PyNone());
-        dict->SetItemString("repairSvc", new PyNone());
-
-        //register it
-        m_manager->cache_service->GiveCache(str, (PyRep **)&dict);
+        PyRep *dict = _BuildServiceInfo();
+        m_manager->cache_service->GiveCache(str, &dict);
     }
 
     PyRep* serverinfo = m_manager->cache_service->GetCacheHint(str);
     PyDecRef( str );
 
-    PyDict* initvals = new PyDict();
+    if(serverinfo == NULL)
+        serverinfo = new PyNone;
 
     PyTuple* result = new PyTuple( 2 );
     result->SetItem( 0, serverinfo );
-    result->SetItem( 1, initvals );
-    return result;
+    result->SetItem( 1, new PyDict );
+    result->Freeze();
+
+    PySafeDecRef( m_initVals );
+    m_initVals = result;
+    //giving the cache above may have bumped the generation already
+    m_initValsGeneration = m_manager->cache_service->GetGeneration();
+}
+
+PyDict *NetService::_BuildServiceInfo() {
+    PyDict *dict = new PyDict;
+    /* ServiceCallGPCS.py:197
+    where = self.machoNet.serviceInfo[service]
+    if where:
+        for (k, v,) in self.machoNet.serviceInfo.iteritems():
+            if ((k != service) and (v and (v.startswith(where) or where.startswith(v)))):
+                nodeID = self.services.get(k, None)
+                break
+    */
+    dict->SetItemString("trademgr", new PyString("station"));
+    dict->SetItemString("tutorialSvc", new PyString("station"));
+    dict->SetItemString("bookmark", new PyString("station"));
+    dict->SetItemString("slash", new PyString("station"));
+    dict->SetItemString("wormholeMgr", new PyString("station"));
+    dict->SetItemString("account", new PyString("station"));
+    dict->SetItemString("gangSvc", new PyString("station"));
+    dict->SetItemString("contractMgr", new PyString("station"));
+
+    dict->SetItemString("LSC", new PyString("location"));
+    dict->SetItemString("station", new PyString("location"));
+    dict->SetItemString("config", new PyString("locationPreferred"));
+
+    dict->SetItemString("scanMgr", new PyString("solarsystem"));
+    dict->SetItemString("keeper", new PyString("solarsystem"));
+
+    dict->SetItemString("stationSvc", new PyNone());
+    dict->SetItemString("zsystem", new PyNone());
+    dict->SetItemString("invbroker", new PyNone());
+    dict->SetItemString("droneMgr", new PyNone());
+    dict->SetItemString("userSvc", new PyNone());
+    dict->SetItemString("map", new PyNone());
+    dict->SetItemString("beyonce", new PyNone());
+    dict->SetItemString("standing2", new PyNone());
+    dict->SetItemString("ram", new PyNone());
+    dict->SetItemString("DB", new PyNone());
+    dict->SetItemString("posMgr", new PyNone());
+    dict->SetItemString("voucher", new PyNone());
+    dict->SetItemString("entity", new PyNone());
+    dict->SetItemString("damageTracker", new PyNone());
+    dict->SetItemString("agentMgr", new PyNone());
+    dict->SetItemString("dogmaIM", new PyNone());
+    dict->SetItemString("machoNet", new PyNone());
+    dict->SetItemString("dungeonExplorationMgr", new PyNone());
+    dict->SetItemString("watchdog", new PyNone());
+    dict->SetItemString("ship", new PyNone());
+    dict->SetItemString("DB2", new PyNone());
+    dict->SetItemString("market", new PyNone());
+    dict->SetItemString("dungeon", new PyNone());
+    dict->SetItemString("npcSvc", new PyNone());
+    dict->SetItemString("sessionMgr", new PyNone());
+    dict->SetItemString("allianceRegistry", new PyNone());
+    dict->SetItemString("cache", new PyNone());
+    dict->SetItemString("character", new PyNone());
+    dict->SetItemString("factory", new PyNone());
+    dict->SetItemString("facWarMgr", new PyNone());
+    dict->SetItemString("corpStationMgr", new PyNone());
+    dict->SetItemString("authentication", new PyNone());
+    dict->SetItemString("effectCompiler", new PyNone());
+    dict->SetItemString("charmgr", new PyNone());
+    dict->SetItemString("BSD", new PyNone());
+    dict->SetItemString("reprocessingSvc", new PyNone());
+    dict->SetItemString("billingMgr", new PyNone());
+    dict->SetItemString("billMgr", new PyNone());
+    dict->SetItemString("lookupSvc", new PyNone());
+    dict->SetItemString("emailreader", new PyNone());
+    dict->SetItemString("lootSvc", new PyNone());
+    dict->SetItemString("http", new PyNone());
+    dict->SetItemString("repairSvc", new PyNone());
+    dict->SetItemString("gagger", new PyNone());
+    dict->SetItemString("dataconfig", new PyNone());
+    dict->SetItemString("lien", new PyNone());
+    dict->SetItemString("i2", new PyNone());
+    dict->SetItemString("pathfinder", new PyNone());
+    dict->SetItemString("alert", new PyNone());
+    dict->SetItemString("director", new PyNone());
+    dict->SetItemString("dogma", new PyNone());
+    dict->SetItemString("aggressionMgr", new PyNone());
+    dict->SetItemString("corporationSvc", new PyNone());
+    dict->SetItemString("certificateMgr", new PyNone());
+    dict->SetItemString("clones", new PyNone());
+    dict->SetItemString("jumpCloneSvc", new PyNone());
+    dict->SetItemString("insuranceSvc", new PyNone());
+    dict->SetItemString("corpmgr", new PyNone());
+    dict->SetItemString("warRegistry", new PyNone());
+    dict->SetItemString("corpRegistry", new PyNone());
+    dict->SetItemString("objectCaching", new PyNone());
+    dict->SetItemString("counter", new PyNone());
+    dict->SetItemString("petitioner", new PyNone());
+    dict->SetItemString("LPSvc", new PyNone());
+    dict->SetItemString("clientStatsMgr", new PyNone());
+    dict->SetItemString("jumpbeaconsvc", new PyNone());
+    dict->SetItemString("debug", new PyNone());
+    dict->SetItemString("languageSvc", new PyNone());
+    dict->SetItemString("skillMgr", new PyNone());
+    dict->SetItemString("voiceMgr", new PyNone());
+    dict->SetItemString("onlineStatus", new PyNone());
+    dict->SetItemString("gangSvcObjectHandler", new PyNone());
+    dict->SetItemString("sovMgr", new PyNone());
+    dict->SetItemString("planetMgr", new PyNone());
+    dict->SetItemString("charFittingMgr", new PyNone());
+    dict->SetItemString("dungeonExplorationMgr", new PyNone());
+    dict->SetItemString("fleetProxy", new PyNone());
+    dict->SetItemString("infoGatheringMgr", new PyNone());
+    dict->SetItemString("clientStatLogger", new PyNone());
+    dict->SetItemString("repairSvc", new PyNone());
+
+    return dict;
 }
 
 PyResult NetService::Handle_GetTime(PyCallArgs &call) {
@@ -27,10 +27,15 @@
 
 #include "PyBoundObject.h"
 
+MemoryTag PyBoundObject::sMemoryTag( "bound objects" );
+
 PyBoundObject::PyBoundObject(PyServiceMgr *mgr)
 : m_manager(mgr),
   m_nodeID(0),
-  m_bindID(0)
+  m_bindID(0),
+  m_boundClient(NULL),
+  m_prevBinding(NULL),
+  m_nextBinding(NULL)
 {
     m_strBoundObjectName = "PyBoundObject";
 }
@@ -39,7 +44,7 @@ PyBoundObject::~PyBoundObject() {
 }
 
 PyResult PyBoundObject::Call(const std::string &method, PyCallArgs &args) {
-    sLog.Debug("Bound Object","NodeID: %u BindID: %u calling %s in service manager '%s'", nodeID(), bindID(), method.c_str(), GetBoundObjectClassStr().c_str());
+    _debug("Bound Object","NodeID: %u BindID: %u calling %s in service manager '%s'", nodeID(), bindID(), method.c_str(), GetBoundObjectClassStr().c_str());
     args.Dump(SERVICE__CALL_TRACE);
 
     return(PyCallable::Call(method, args));
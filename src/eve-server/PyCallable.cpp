@@ -25,6 +25,9 @@
 
 #include "eve-server.h"
 
+#include "Client.h"
+#include "EVEServerConfig.h"
+#include "EntityList.h"
 #include "PyCallable.h"
 
 PyCallable::PyCallable()
@@ -36,16 +39,36 @@ PyCallable::~PyCallable()
 {
 }
 
+/** @return Histogram of the durations of the calls. */
+static MetricHistogram& CallLatencyMetric()
+{
+    static MetricHistogram& metric = sMetrics.LatencyHistogram( "evemu_service_call_seconds", "Time the calls of services and bound objects took." );
+    return metric;
+}
+/** @return Counter of the calls which threw. */
+static MetricCounter& CallExceptionMetric()
+{
+    static MetricCounter& metric = sMetrics.Counter( "evemu_service_call_exceptions_total", "Number of calls of services and bound objects which threw." );
+    return metric;
+}
+
 PyResult PyCallable::Call(const std::string &method, PyCallArgs &args) {
+    ProfileZone zone("Call", method.c_str(), method.length());
+    const uint64 start = GetTimeUSeconds();
+
     //call the dispatcher, capturing the result.
     try {
         PyResult res = m_serviceDispatch->Dispatch(method, args);
+        CallLatencyMetric().Observe(GetTimeUSeconds() - start);
 
         _log(SERVICE__CALL_TRACE, "Call %s returned:", method.c_str());
         res.ssResult->Dump(SERVICE__CALL_TRACE, "      ");
 
         return res;
     } catch(PyException &e) {
+        CallLatencyMetric().Observe(GetTimeUSeconds() - start);
+        CallExceptionMetric().Add();
+
         _log(SERVICE__CALL_TRACE, "Call %s threw exception:", method.c_str());
         e.ssException->Dump(SERVICE__CALL_TRACE, "      ");
 
@@ -53,10 +76,63 @@ PyResult PyCallable::Call(const std::string &method, PyCallArgs &args) {
     }
 }
 
+void PyCallable::GetCallStats(CallStatsMap &into) const {
+    m_serviceDispatch->GetCallStats(into);
+}
+
+void PyCallable::ResetCallStats() {
+    m_serviceDispatch->ResetCallStats();
+}
+
+/* PyCallable::CallStats */
+PyCallable::CallStats::CallStats()
+: calls(0),
+  exceptions(0),
+  totalTime(0),
+  maxTime(0)
+{
+    for(size_t i = 0; i < HISTOGRAM_SIZE; i++)
+        histogram[i] = 0;
+}
+
+bool PyCallable::CallStats::IsEnabled() {
+    return sConfig.loop.callStats;
+}
+
+void PyCallable::CallStats::Record(uint64 time, bool exception) {
+    calls++;
+    if(exception)
+        exceptions++;
+
+    totalTime += time;
+    if(maxTime < time)
+        maxTime = time;
+
+    //bucket by decades, starting at 10us
+    size_t bucket = 0;
+    for(uint64 limit = 10; bucket < HISTOGRAM_SIZE - 1 && limit <= time; limit *= 10)
+        bucket++;
+    histogram[bucket]++;
+}
+
+void PyCallable::CallStats::Merge(const CallStats &oth) {
+    calls += oth.calls;
+    exceptions += oth.exceptions;
+    totalTime += oth.totalTime;
+    if(maxTime < oth.maxTime)
+        maxTime = oth.maxTime;
+
+    for(size_t i = 0; i < HISTOGRAM_SIZE; i++)
+        histogram[i] += oth.histogram[i];
+}
+
 
 PyCallArgs::PyCallArgs(Client *c, PyTuple* tup, PyDict* dict)
 : client(c),
-  tuple(tup)
+  tuple(tup),
+  deferrable(false),
+  deferred(false),
+  callID(0)
 {
     PyIncRef( tup );
 
@@ -84,6 +160,12 @@ PyCallArgs::~PyCallArgs() {
         PySafeDecRef( cur->second );
 }
 
+void PyCallArgs::SetDeferrable(const PyAddress &_source, uint64 _callID) {
+    deferrable = true;
+    source = _source;
+    callID = _callID;
+}
+
 void PyCallArgs::Dump(LogType type) const {
     if(!is_log_enabled(type))
         return;
@@ -134,3 +216,51 @@ PyException& PyException::operator=( const PyException& oth )
     return *this;
 }
 
+
+/* PyDeferredCall */
+PyDeferredCall::PyDeferredCall( PyCallArgs& call )
+: mClient( call.client ),
+  mAccountID( call.client->GetAccountID() ),
+  mSource( call.source ),
+  mCallID( call.callID )
+{
+    assert( call.IsDeferrable() );
+    call.deferred = true;
+}
+
+void PyDeferredCall::Return( PyRep* result )
+{
+    Client* client = _GetClient();
+    if( NULL == client )
+    {
+        PySafeDecRef( result );
+        return;
+    }
+
+    client->SendDeferredReturn( mSource, mCallID, result );
+}
+
+void PyDeferredCall::Throw( PyRep* except )
+{
+    Client* client = _GetClient();
+    if( NULL == client )
+    {
+        PySafeDecRef( except );
+        return;
+    }
+
+    client->SendDeferredException( mSource, mCallID, except );
+}
+
+Client* PyDeferredCall::_GetClient() const
+{
+    // the client may have disconnected and its memory reused
+    Client* client = sEntityList.FindAccount( mAccountID );
+    if( client != mClient )
+    {
+        _log( SERVICE__MESSAGE, "Dropping answer to deferred call %" PRIu64 " of gone account %u.", mCallID, mAccountID );
+        return NULL;
+    }
+
+    return client;
+}
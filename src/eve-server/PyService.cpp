@@ -28,6 +28,7 @@
 #include "Client.h"
 #include "PyBoundObject.h"
 #include "PyService.h"
+#include "system/ClusterMap.h"
 
 PyService::PyService(PyServiceMgr *mgr, const char *serviceName)
 : m_manager(mgr),
@@ -56,20 +57,21 @@ PyResult PyService::Call(const std::string &method, PyCallArgs &args) {
 
 
 /*
- * For now, we are going to keep it simple by trying to use only a single
- * node ID, this may have to change some day.
+ * The node is the sol node owning the location in the bind parameters,
+ * see ClusterMap; anything else resolves to our own node.
 */
 
 PyResult PyService::Handle_MachoResolveObject(PyCallArgs &call) {
-/*    CallMachoResolveObject args;
-    if(!args.Decode(!call.packet)) {
+    CallMachoResolveObject args;
+    uint32 nodeID = m_manager->GetNodeID();
+    if( args.Decode( &call.tuple ) )
+        nodeID = sClusterMap.GetNodeID( args.bindParams );
+    else
         _log(CLIENT__ERROR, "Failed to decode params for MachoResolveObject.");
-        return NULL;
-    }
-*/
+
     //returns nodeID
-    _log(CLIENT__MESSAGE, "%s Service: MachoResolveObject requested, returning %u", GetName(), m_manager->GetNodeID());
-    return(new PyInt(m_manager->GetNodeID()));
+    _log(CLIENT__MESSAGE, "%s Service: MachoResolveObject requested, returning %u", GetName(), nodeID);
+    return(new PyInt(nodeID));
 }
 
 
@@ -97,7 +99,7 @@ PyResult PyService::Handle_MachoBindObject( PyCallArgs& call )
 
     PyTuple* robjs = new PyTuple( 2 );
     //now we register
-    robjs->SetItem( 0, m_manager->BindObject( call.client, our_obj ) );
+    robjs->SetItem( 0, m_manager->BindObject( call.client, our_obj, NULL, sClusterMap.GetNodeID( args.bindParams ) ) );
 
     if( args.call->IsNone() )
         //no call was specified...
@@ -29,6 +29,7 @@
 #include "PyService.h"
 #include "PyServiceMgr.h"
 #include "PyBoundObject.h"
+#include "cache/ObjCacheService.h"
 
 PyServiceMgr::PyServiceMgr( uint32 nodeID, EntityList& elist, ItemFactory& ifactory )
 : item_factory( ifactory ),
@@ -44,62 +45,99 @@ PyServiceMgr::PyServiceMgr( uint32 nodeID, EntityList& elist, ItemFactory& ifact
 
 PyServiceMgr::~PyServiceMgr() {
     {
-        std::set<PyService *>::iterator cur, end;
+        ServiceMap::iterator cur, end;
         cur = m_services.begin();
         end = m_services.end();
         for(; cur != end; cur++) {
-            delete *cur;
+            delete cur->second;
         }
     }
 
     {
-        std::map<uint32, BoundObject>::iterator cur, end;
+        ObjectsBoundMapItr cur, end;
         cur = m_boundObjects.begin();
         end = m_boundObjects.end();
         for(; cur != end; cur++) {
-            delete cur->second.destination;
+            delete cur->second;
         }
     }
 }
 
 void PyServiceMgr::Process() {
-    //well... we used to have something to do, but not right now...
+    static MetricGauge& servicesMetric = sMetrics.Gauge( "evemu_services", "Number of registered services." );
+    static MetricGauge& boundMetric = sMetrics.Gauge( "evemu_bound_objects", "Number of objects bound by the clients." );
+
+    servicesMetric.Set( m_services.size() );
+    boundMetric.Set( m_boundObjects.size() );
 }
 
 void PyServiceMgr::RegisterService(PyService *d) {
-    m_services.insert(d);
+    std::pair<ServiceMap::iterator, bool> res = m_services.insert(std::make_pair(std::string(d->GetName()), d));
+    if(!res.second) {
+        //not deleted, others may still point at it (lsc_service, cache_service)
+        sLog.Error("Service Mgr", "Service %s registered twice, ignoring the new instance.", d->GetName());
+    }
 }
 
 PyService *PyServiceMgr::LookupService(const std::string &name) {
-    std::set<PyService *>::iterator cur, end;
+    ServiceMap::iterator res = m_services.find(name);
+    if(res == m_services.end())
+        return NULL;
+
+    _log(SERVICE__CALLS, "Looked up service %s", res->second->GetName());
+    return res->second;
+}
+
+void PyServiceMgr::PrimeCaches() {
+    //the cache service goes first, the others hand their results to it
+    cache_service->PrimeCache();
+
+    ServiceMap::const_iterator cur, end;
     cur = m_services.begin();
     end = m_services.end();
     for(; cur != end; cur++) {
-        if(name == (*cur)->GetName())
-        {
-            //this is added here so you know which server opens the call
-            //that if it gets loaded
-            sLog.Debug("ServiceOfIterest", (*cur)->GetName());
-            return(*cur);
-        }
+        if(cur->second != (PyService *)cache_service)
+            cur->second->PrimeCache();
+    }
+}
+
+void PyServiceMgr::GetCallStats(std::map<std::string, PyCallable::CallStats> &into) const {
+    ServiceMap::const_iterator cur, end;
+    cur = m_services.begin();
+    end = m_services.end();
+    for(; cur != end; cur++) {
+        PyCallable::CallStatsMap stats;
+        cur->second->GetCallStats(stats);
+
+        PyCallable::CallStatsMap::const_iterator scur, send;
+        scur = stats.begin();
+        send = stats.end();
+        for(; scur != send; scur++)
+            into[cur->first + "::" + scur->first].Merge(scur->second);
     }
-    return NULL;
 }
 
-PySubStruct *PyServiceMgr::BindObject(Client *c, PyBoundObject *cb, PyDict **dict) {
+void PyServiceMgr::ResetCallStats() {
+    ServiceMap::iterator cur, end;
+    cur = m_services.begin();
+    end = m_services.end();
+    for(; cur != end; cur++)
+        cur->second->ResetCallStats();
+}
+
+PySubStruct *PyServiceMgr::BindObject(Client *c, PyBoundObject *cb, PyDict **dict, uint32 nodeID) {
     if(cb == NULL)
     {
         sLog.Error("Service Mgr", "Tried to bind a NULL object!");
         return new PySubStruct(new PyNone());
     }
 
-    cb->_SetNodeBindID(GetNodeID(), _GetBindID());    //tell the object what its bind ID is.
-
-    BoundObject obj;
-    obj.client = c;
-    obj.destination = cb;
+    if(nodeID == 0)
+        nodeID = GetNodeID();
+    cb->_SetNodeBindID(nodeID, _GetBindID());    //tell the object what its bind ID is.
 
-    m_boundObjects[cb->bindID()] = obj;
+    m_boundObjects[cb->bindID()] = cb;
+    _LinkBinding(cb, c);
 
     //sLog.Debug("Service Mgr", "Binding %s to service %s", bind_str, cb->GetName());
 
@@ -128,48 +166,93 @@ PySubStruct *PyServiceMgr::BindObject(Client *c, PyBoundObject *cb, PyDict **dic
 }
 
 void PyServiceMgr::ClearBoundObjects(Client *who) {
-    ObjectsBoundMapItr cur, end;
-    cur = m_boundObjects.begin();
-    end = m_boundObjects.end();
-
-    while(cur != end) {
-        if(cur->second.client == who)
-        {
-            //sLog.Debug("Service Mgr", "Clearing bound object %s", cur->first.c_str());
-            cur->second.destination->Release();
-
-            ObjectsBoundMapItr tmp = cur++;
-            m_boundObjects.erase(tmp);
-        }
-        else
-        {
-            cur++;
-        }
+    ClientBindingMap::iterator res = m_clientBindings.find(who);
+    if(res == m_clientBindings.end())
+        return;
+
+    //only the bindings of this client
+    PyBoundObject *cur = res->second;
+    m_clientBindings.erase(res);
+
+    while(cur != NULL) {
+        PyBoundObject *next = cur->m_nextBinding;
+
+        //sLog.Debug("Service Mgr", "Clearing bound object %u", cur->bindID());
+        m_boundObjects.erase(cur->bindID());
+        cur->Release();
+
+        cur = next;
     }
 }
 
+size_t PyServiceMgr::GetBoundObjectCount(Client *who) const {
+    ClientBindingMap::const_iterator res = m_clientBindings.find(who);
+    if(res == m_clientBindings.end())
+        return 0;
+
+    size_t count = 0;
+    for(const PyBoundObject *cur = res->second; cur != NULL; cur = cur->m_nextBinding)
+        ++count;
+
+    return count;
+}
+
 PyBoundObject *PyServiceMgr::FindBoundObject(uint32 bindID) {
-    std::map<uint32, BoundObject>::iterator res;
+    ObjectsBoundMapItr res;
     res = m_boundObjects.find(bindID);
     if(res == m_boundObjects.end())
         return NULL;
     else
-        return res->second.destination;
+        return res->second;
 }
 
 void PyServiceMgr::ClearBoundObject(uint32 bindID)
 {
-    std::map<uint32, BoundObject>::iterator res;
+    ObjectsBoundMapItr res;
     res = m_boundObjects.find(bindID);
     if(res == m_boundObjects.end()) {
         sLog.Error("Service Mgr", "Unable to find bound object %u to release.", bindID);
         return;
     }
 
-    PyBoundObject *bo = res->second.destination;
+    PyBoundObject *bo = res->second;
 
-    //sLog.Debug("Service Mgr", "Clearing bound object %s (released)", res->first.c_str());
+    //sLog.Debug("Service Mgr", "Clearing bound object %u (released)", res->first);
 
     m_boundObjects.erase(res);
+    _UnlinkBinding(bo);
     bo->Release();
 }
+
+void PyServiceMgr::_LinkBinding(PyBoundObject *obj, Client *who) {
+    PyBoundObject *&head = m_clientBindings[who];
+
+    obj->m_boundClient = who;
+    obj->m_prevBinding = NULL;
+    obj->m_nextBinding = head;
+    if(head != NULL)
+        head->m_prevBinding = obj;
+    head = obj;
+}
+
+void PyServiceMgr::_UnlinkBinding(PyBoundObject *obj) {
+    if(obj->m_prevBinding != NULL)
+        obj->m_prevBinding->m_nextBinding = obj->m_nextBinding;
+    else {
+        //the head of its client's list
+        ClientBindingMap::iterator res = m_clientBindings.find(obj->m_boundClient);
+        if(res != m_clientBindings.end()) {
+            if(obj->m_nextBinding != NULL)
+                res->second = obj->m_nextBinding;
+            else
+                m_clientBindings.erase(res);
+        }
+    }
+
+    if(obj->m_nextBinding != NULL)
+        obj->m_nextBinding->m_prevBinding = obj->m_prevBinding;
+
+    obj->m_boundClient = NULL;
+    obj->m_prevBinding = NULL;
+    obj->m_nextBinding = NULL;
+}
@@ -26,6 +26,7 @@
 #include "eve-server.h"
 
 #include "account/AccountDB.h"
+#include "account/WalletLedger.h"
 
 PyObject *AccountDB::GetEntryTypes() {
     DBQueryResult res;
@@ -52,27 +53,8 @@ PyObject *AccountDB::GetKeyMap() {
 }
 
 PyObject *AccountDB::GetJournal(uint32 charID, uint32 refTypeID, uint32 accountKey, uint64 transDate) {
-//'refID', 'transDate', 'refTypeID','ownerID1', 'ownerID2', 'argID1', 'accountID', 'amount', 'balance', 'reason'
-
-    DBQueryResult res;
-    uint64 dT;
-    //dF = transDate;
-    dT = transDate - Win32Time_Day;
-    // 1 sec = 10.000.000 wow...
-
-    if(!sDatabase.RunQuery(res,
-        "SELECT refID AS transactionID,transDate AS transactionDate,0 AS referenceID, refTypeID AS entryTypeID,ownerID1,ownerID2,argID1, accountKey,amount,balance,reason AS description "
-        "FROM market_journal "
-        "WHERE (transDate >= %" PRIu64 " AND transDate <= %" PRIu64 ") "
-        "AND accountKey = %u "
-        "AND (0 = %u OR refTypeID = %u) "
-        "AND characterID=%u" , dT, transDate, accountKey, refTypeID, refTypeID, charID))
-    {
-        sLog.Error("Account DB", "Error in query: %s", res.error.c_str());
-        return NULL;
-    }
-
-    return DBResultToRowset(res);
+    //served from the window of the ledger
+    return sWalletLedger.GetJournal(charID, refTypeID, accountKey, transDate);
 }
 
 //////////////////////////////////
@@ -83,23 +65,18 @@ bool ServiceDB::GiveCash( uint32 characterID, JournalRefType refTypeID, uint32 o
     uint32 accountID, EVEAccountKeys accountKey, double amount, double balance, const char *reason )
 {
 //the only unknown it is argID1 , what is it ?
-    DBQueryResult res;
-    DBerror err;
-
-    std::string eReason;
-    sDatabase.DoEscapeString(eReason, reason);
-    std::string eArg1;
-    sDatabase.DoEscapeString(eArg1, argID1);
-
-    if(!sDatabase.RunQuery(err,
-        "INSERT INTO market_journal(characterID,refID,transDate,refTypeID,ownerID1,ownerID2,argID1,accountID,accountKey,amount,balance,reason) "
-        "VALUES (%u,NULL,%" PRIu64 ",%u,%u,%u,\"%s\",%u,%u,%.2f,%.2f,\"%s\")",
-        characterID, Win32TimeNow(), refTypeID, ownerFromID, ownerToID, eArg1.c_str(), accountID, accountKey, amount, balance, eReason.c_str()))
-    {
-        sLog.Error("Service DB", "Error in query : %s", err.c_str());
-        return false;
-    }
-
+    WalletEntry entry;
+    entry.refTypeID = refTypeID;
+    entry.ownerID1 = ownerFromID;
+    entry.ownerID2 = ownerToID;
+    entry.argID1 = argID1;
+    entry.accountKey = accountKey;
+    entry.amount = amount;
+    entry.balance = balance;
+    entry.reason = reason;
+
+    //written by the market journal, along with the balance changes
+    sWalletLedger.Record(characterID, accountID, entry);
     return true;
 }
 
@@ -121,27 +98,9 @@ bool AccountDB::CheckIfCorporation(uint32 corpID) {
 }
 
 bool ServiceDB::AddBalanceToCorp(uint32 corpID, double amount) {
-    DBerror err;
-    if (!sDatabase.RunQuery(err, "UPDATE corporation SET balance = balance + (%lf) WHERE corporationID = %u ", amount, corpID))
-    {
-        sLog.Error("Service DB", "Error in query: %s", err.c_str());
-        return false;
-    }
-    return true;
+    return sWalletLedger.AddCorpBalance(corpID, amount);
 }
 
 double ServiceDB::GetCorpBalance(uint32 corpID) {
-    DBQueryResult res;
-    DBResultRow row;
-    if (!sDatabase.RunQuery(res, "SELECT balance FROM corporation WHERE corporationID = %u ", corpID))
-    {
-        sLog.Error("Service DB", "Error in query: %s", res.error.c_str());
-        return 0.0;
-    }
-    if (!res.GetRow(row))
-    {
-        sLog.Error("Service DB", "Corporation %u missing from database.", corpID);
-        return 0.0;
-    }
-    return row.GetDouble(0);
+    return sWalletLedger.GetCorpBalance(corpID);
 }
@@ -50,6 +50,14 @@ AccountService::~AccountService() {
     delete m_dispatch;
 }
 
+void AccountService::PrimeCache() {
+    ObjectCachedMethodID entry_types(GetName(), "GetEntryTypes");
+    _CacheEntryTypes(entry_types);
+
+    ObjectCachedMethodID key_map(GetName(), "GetKeyMap");
+    _CacheKeyMap(key_map);
+}
+
 PyResult AccountService::Handle_GetCashBalance(PyCallArgs &call) {
     const int32 ACCOUNT_KEY_AURUM = 1200;
 
@@ -99,50 +107,48 @@ PyResult AccountService::Handle_GetCashBalance(PyCallArgs &call) {
 // notify OnAccountChange:
 //         accountKey: 'cash', ownerID: charID or corpID, new balance
 
-PyResult AccountService::Handle_GetEntryTypes(PyCallArgs &call) {
-    PyRep *result = NULL;
-
-    ObjectCachedMethodID method_id(GetName(), "GetEntryTypes");
-
+void AccountService::_CacheEntryTypes(const ObjectCachedMethodID &method_id) {
     //check to see if this method is in the cache already.
     if(!m_manager->cache_service->IsCacheLoaded(method_id)) {
         //this method is not in cache yet, load up the contents and cache it.
-        result = m_db.GetEntryTypes();
+        PyRep *result = m_db.GetEntryTypes();
         if(result == NULL) {
             codelog(SERVICE__ERROR, "Failed to load cache, generating empty contents.");
             result = new PyNone();
         }
         m_manager->cache_service->GiveCache(method_id, &result);
     }
+}
+
+PyResult AccountService::Handle_GetEntryTypes(PyCallArgs &call) {
+    ObjectCachedMethodID method_id(GetName(), "GetEntryTypes");
+    _CacheEntryTypes(method_id);
 
     //now we know its in the cache one way or the other, so build a
     //cached object cached method call result.
-    result = m_manager->cache_service->MakeObjectCachedMethodCallResult(method_id);
-
-    return result;
+    return m_manager->cache_service->MakeObjectCachedMethodCallResult(method_id);
 }
 
-PyResult AccountService::Handle_GetKeyMap(PyCallArgs &call) {
-    PyRep *result = NULL;
-
-    ObjectCachedMethodID method_id(GetName(), "GetKeyMap");
-
+void AccountService::_CacheKeyMap(const ObjectCachedMethodID &method_id) {
     //check to see if this method is in the cache already.
     if(!m_manager->cache_service->IsCacheLoaded(method_id)) {
         //this method is not in cache yet, load up the contents and cache it.
-        result = m_db.GetKeyMap();
+        PyRep *result = m_db.GetKeyMap();
         if(result == NULL) {
             codelog(SERVICE__ERROR, "Failed to load cache, generating empty contents.");
             result = new PyNone();
         }
         m_manager->cache_service->GiveCache(method_id, &result);
     }
+}
+
+PyResult AccountService::Handle_GetKeyMap(PyCallArgs &call) {
+    ObjectCachedMethodID method_id(GetName(), "GetKeyMap");
+    _CacheKeyMap(method_id);
 
     //now we know its in the cache one way or the other, so build a
     //cached object cached method call result.
-    result = m_manager->cache_service->MakeObjectCachedMethodCallResult(method_id);
-
-    return result;
+    return m_manager->cache_service->MakeObjectCachedMethodCallResult(method_id);
 }
 
 //give cash takes (ownerID, retval['qty'], retval['reason'][:40])
@@ -48,7 +48,7 @@ ClientStatsMgr::~ClientStatsMgr()
   */
 PyResult ClientStatsMgr::Handle_SubmitStats( PyCallArgs& call )
 {
-    sLog.Debug( "ClientStatsMgr", "Called SubmitStats stub." );
+    _debug( "ClientStatsMgr", "Called SubmitStats stub." );
 
     return new PyNone;
 }
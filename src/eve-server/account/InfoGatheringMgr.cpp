@@ -27,6 +27,7 @@
 
 #include "PyServiceCD.h"
 #include "account/InfoGatheringMgr.h"
+#include "admin/ClientTelemetry.h"
 
 PyCallable_Make_InnerDispatcher(InfoGatheringMgr)
 
@@ -65,5 +66,8 @@ PyResult InfoGatheringMgr::Handle_GetStateAndConfig(PyCallArgs &call) {
 }
 
 PyResult InfoGatheringMgr::Handle_LogInfoEventsFromClient(PyCallArgs &call) {
+    //the events are not decoded yet (see isEnabled above), only counted.
+    sClientTelemetry.Report(ClientTelemetry::KIND_INFO_EVENTS, call.client->GetCharacterID(), "");
+
     return new PyNone;
 }
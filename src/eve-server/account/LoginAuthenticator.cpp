@@ -0,0 +1,232 @@
+/*
+    ------------------------------------------------------------------------------------
+    LICENSE:
+    ------------------------------------------------------------------------------------
+    This file is part of EVEmu: EVE Online Server Emulator
+    Copyright 2006 - 2011 The EVEmu Team
+    For the latest information visit http://evemu.org
+    ------------------------------------------------------------------------------------
+    This program is free software; you can redistribute it and/or modify it under
+    the terms of the GNU Lesser General Public License as published by the Free Software
+    Foundation; either version 2 of the License, or (at your option) any later
+    version.
+
+    This program is distributed in the hope that it will be useful, but WITHOUT
+    ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+    FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public License along with
+    this program; if not, write to the Free Software Foundation, Inc., 59 Temple
+    Place - Suite 330, Boston, MA 02111-1307, USA, or go to
+    http://www.gnu.org/copyleft/lesser.txt.
+    ------------------------------------------------------------------------------------
+    Author:     EVEmu Team
+*/
+
+
+#include "eve-server.h"
+
+#include "Client.h"
+#include "EVEServerConfig.h"
+#include "ServiceDB.h"
+#include "account/LoginAuthenticator.h"
+
+/// Interval (in microseconds) between prunings of the buckets.
+static const uint64 BUCKET_PRUNE_INTERVAL = 60 * 1000000;
+
+/**
+ * @brief Verifies a login on a worker thread.
+ */
+class LoginAuthenticator::AuthQuery
+: public DBAsyncQuery
+{
+public:
+    AuthQuery( uint32 ticket, const std::string& userName, const std::string& passwordHash )
+    : mTicket( ticket ),
+      mUserName( userName ),
+      mPasswordHash( passwordHash ),
+      mReason( "LoginAuthFailed" )
+    {
+    }
+
+    const uint32 mTicket;
+    const std::string mUserName;
+    const std::string mPasswordHash;
+
+    AccountInfo mAccount;
+    /// Reason sent to the client if the login failed.
+    std::string mReason;
+
+protected:
+    bool Run()
+    {
+        ServiceDB db;
+        if( !db.GetAccountInformation( mUserName.c_str(), mAccount ) )
+            return false;
+
+        /* check wether the account has been banned and if so send the semi correct message */
+        if( mAccount.banned )
+        {
+            mReason = "ACCOUNTBANNED";
+            return false;
+        }
+
+        /* if we have stored a password we need to create a hash from the username and pass and remove the pass */
+        std::string accountHash;
+        if( mAccount.password.empty() )
+            accountHash = mAccount.hash;
+        else
+        {
+            if( !PasswordModule::GeneratePassHash( mUserName, mAccount.password, accountHash ) )
+            {
+                sLog.Error( "LoginAuthenticator", "Unable to generate password hash for %s.", mUserName.c_str() );
+                return false;
+            }
+
+            if( !db.UpdateAccountHash( mUserName.c_str(), accountHash ) )
+            {
+                sLog.Error( "LoginAuthenticator", "Unable to update account hash of %s.", mUserName.c_str() );
+                return false;
+            }
+        }
+
+        if( accountHash != mPasswordHash )
+            return false;
+
+        /* update account information, increase login count, last login timestamp and mark account as online */
+        db.UpdateAccountInformation( mAccount.name.c_str(), true );
+        return true;
+    }
+
+    void Complete( bool success, DBQueryResult& result )
+    {
+        sLoginAuthenticator._Complete( *this, success );
+    }
+};
+
+LoginAuthenticator::LoginAuthenticator()
+: mNextTicket( 1 ),
+  mLastPrune( 0 )
+{
+}
+
+bool LoginAuthenticator::Submit( Client* client, uint32 address, const std::string& userName, const std::string& passwordHash )
+{
+    // a login refused for the backlog must not cost the address a token
+    if( sConfig.account.maxPendingLogins <= mLogins.size() )
+    {
+        sLog.Warning( "LoginAuthenticator", "%s: %lu logins pending; refusing %s.", client->GetAddress().c_str(), (unsigned long)mLogins.size(), userName.c_str() );
+        ++mStats.overflowed;
+        return false;
+    }
+
+    if( !_Take( address ) )
+    {
+        sLog.Warning( "LoginAuthenticator", "%s: Too many logins from this address; refusing %s.", client->GetAddress().c_str(), userName.c_str() );
+        ++mStats.throttled;
+        return false;
+    }
+
+    const uint32 ticket = mNextTicket++;
+
+    Login& login = mLogins[ ticket ];
+    login.client = client;
+    login.submitted = GetTimeUSeconds();
+
+    ++mStats.submitted;
+
+    sDBAsync.Submit( new AuthQuery( ticket, userName, passwordHash ) );
+    return true;
+}
+
+void LoginAuthenticator::Cancel( Client* client )
+{
+    std::map< uint32, Login >::iterator cur, end;
+    cur = mLogins.begin();
+    end = mLogins.end();
+    for(; cur != end; ++cur )
+    {
+        if( cur->second.client == client )
+        {
+            mLogins.erase( cur );
+            ++mStats.cancelled;
+            return;
+        }
+    }
+}
+
+void LoginAuthenticator::_Complete( AuthQuery& query, bool success )
+{
+    std::map< uint32, Login >::iterator res = mLogins.find( query.mTicket );
+    if( res == mLogins.end() )
+        // cancelled meanwhile
+        return;
+
+    Login login = res->second;
+    mLogins.erase( res );
+
+    const uint32 time = static_cast<uint32>( ( GetTimeUSeconds() - login.submitted ) / 1000 );
+    mStats.authTime += time;
+    mStats.maxAuthTime = std::max( mStats.maxAuthTime, time );
+
+    if( success )
+        ++mStats.accepted;
+    else
+        ++mStats.rejected;
+
+    login.client->CompleteLogin( success, query.mAccount, query.mReason );
+}
+
+bool LoginAuthenticator::_Take( uint32 address )
+{
+    // no limit
+    if( 0 == sConfig.account.loginRate )
+        return true;
+
+    const uint64 now = GetTimeUSeconds();
+    if( mLastPrune + BUCKET_PRUNE_INTERVAL <= now )
+        _PruneBuckets( now );
+
+    const double burst = std::max<uint32>( sConfig.account.loginBurst, 1 );
+
+    std::tr1::unordered_map< uint32, Bucket >::iterator res = mBuckets.find( address );
+    if( res == mBuckets.end() )
+    {
+        Bucket& bucket = mBuckets[ address ];
+        bucket.tokens = burst - 1.0;
+        bucket.refilled = now;
+        return true;
+    }
+
+    Bucket& bucket = res->second;
+
+    // loginRate is per minute
+    bucket.tokens += ( now - bucket.refilled ) * sConfig.account.loginRate / ( 60.0 * 1000000.0 );
+    bucket.tokens = std::min( bucket.tokens, burst );
+    bucket.refilled = now;
+
+    if( bucket.tokens < 1.0 )
+        return false;
+
+    bucket.tokens -= 1.0;
+    return true;
+}
+
+void LoginAuthenticator::_PruneBuckets( uint64 now )
+{
+    const double burst = std::max<uint32>( sConfig.account.loginBurst, 1 );
+
+    std::tr1::unordered_map< uint32, Bucket >::iterator cur = mBuckets.begin();
+    while( cur != mBuckets.end() )
+    {
+        const Bucket& bucket = cur->second;
+
+        // a full bucket is the same as none
+        if( burst <= bucket.tokens + ( now - bucket.refilled ) * sConfig.account.loginRate / ( 60.0 * 1000000.0 ) )
+            mBuckets.erase( cur++ );
+        else
+            ++cur;
+    }
+
+    mLastPrune = now;
+}
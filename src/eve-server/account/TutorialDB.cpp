@@ -27,66 +27,58 @@
 
 #include "account/TutorialDB.h"
 
-PyRep *TutorialDB::GetPageCriterias(uint32 tutorialID) {
-    DBQueryResult res;
-
-    if(!sDatabase.RunQuery(res,
-        "SELECT pageID, criteriaID"
+bool TutorialDB::GetAllPageCriterias(DBQueryResult &into) {
+    if(!sDatabase.RunQuery(into,
+        "SELECT tutorialID, pageID, criteriaID"
         " FROM tutorial_pages"
         " JOIN tutorial_page_criteria USING (pageID)"
-        " WHERE tutorialID=%u", tutorialID))
+        " ORDER BY tutorialID"))
     {
-        _log(DATABASE__ERROR, "Error in query: %s", res.error.c_str());
-        return NULL;
+        _log(DATABASE__ERROR, "Error in query: %s", into.error.c_str());
+        return false;
     }
 
-    return DBResultToRowset(res);
+    return true;
 }
 
-PyRep *TutorialDB::GetPages(uint32 tutorialID) {
-    DBQueryResult res;
-
-    if(!sDatabase.RunQuery(res,
-        "SELECT pageID, pageNumber, pageName, text, imagePath, audioPath, 0 AS dataID"
+bool TutorialDB::GetAllPages(DBQueryResult &into) {
+    if(!sDatabase.RunQuery(into,
+        "SELECT tutorialID, pageID, pageNumber, pageName, text, imagePath, audioPath, 0 AS dataID"
         " FROM tutorial_pages"
-        " WHERE tutorialID=%u"
-        " ORDER BY pageNumber", tutorialID))
+        " ORDER BY tutorialID, pageNumber"))
     {
-        _log(DATABASE__ERROR, "Error in query: %s", res.error.c_str());
-        return NULL;
+        _log(DATABASE__ERROR, "Error in query: %s", into.error.c_str());
+        return false;
     }
 
-    return DBResultToRowset(res);
+    return true;
 }
 
-PyRep *TutorialDB::GetTutorial(uint32 tutorialID) {
-    DBQueryResult res;
-
-    if(!sDatabase.RunQuery(res,
-        "SELECT tutorialID, tutorialName, nextTutorialID, 0 AS dataID"
+bool TutorialDB::GetTutorialRows(DBQueryResult &into) {
+    //the first column is repeated, as the rowsets start with it
+    if(!sDatabase.RunQuery(into,
+        "SELECT tutorialID AS id, tutorialID, tutorialName, nextTutorialID, 0 AS dataID"
         " FROM tutorials"
-        " WHERE tutorialID=%u", tutorialID))
+        " ORDER BY tutorialID"))
     {
-        _log(DATABASE__ERROR, "Error in query: %s", res.error.c_str());
-        return NULL;
+        _log(DATABASE__ERROR, "Error in query: %s", into.error.c_str());
+        return false;
     }
 
-    return DBResultToRowset(res);
+    return true;
 }
 
-PyRep *TutorialDB::GetTutorialCriterias(uint32 tutorialID) {
-    DBQueryResult res;
-
-    if(!sDatabase.RunQuery(res,
-        "SELECT criteriaID"
+bool TutorialDB::GetAllTutorialCriterias(DBQueryResult &into) {
+    if(!sDatabase.RunQuery(into,
+        "SELECT tutorialID, criteriaID"
         " FROM tutorials_criterias"
-        " WHERE tutorialID=%u", tutorialID))
+        " ORDER BY tutorialID"))
     {
-        _log(DATABASE__ERROR, "Error in query: %s", res.error.c_str());
-        return NULL;
+        _log(DATABASE__ERROR, "Error in query: %s", into.error.c_str());
+        return false;
     }
 
-    return DBResultToRowset(res);
+    return true;
 }
 
 PyRep *TutorialDB::GetAllTutorials() {
@@ -27,6 +27,7 @@
 
 #include "PyServiceCD.h"
 #include "account/TutorialService.h"
+#include "account/TutorialStore.h"
 
 PyCallable_Make_InnerDispatcher(TutorialService)
 
@@ -56,57 +57,32 @@ PyResult TutorialService::Handle_GetTutorialInfo(PyCallArgs &call) {
         return NULL;
     }
 
-    Rsp_GetTutorialInfo rsp;
-
-    rsp.pagecriterias = m_db.GetPageCriterias(args.tutorialID);
-    if(rsp.pagecriterias == NULL) {
-        codelog(SERVICE__ERROR, "An error occured while getting pagecriterias for tutorial %u.", args.tutorialID);
-        return NULL;
-    }
-
-    rsp.pages = m_db.GetPages(args.tutorialID);
-    if(rsp.pages == NULL) {
-        codelog(SERVICE__ERROR, "An error occured while getting pages for tutorial %u.", args.tutorialID);
-        return NULL;
-    }
-
-    rsp.tutorial = m_db.GetTutorial(args.tutorialID);
-    if(rsp.tutorial == NULL) {
-        codelog(SERVICE__ERROR, "An error occured while getting tutorial %u.", args.tutorialID);
-        return NULL;
-    }
-
-    rsp.criterias = m_db.GetTutorialCriterias(args.tutorialID);
-    if(rsp.criterias == NULL) {
-        codelog(SERVICE__ERROR, "An error occured while getting criterias for tutorial %u.", args.tutorialID);
-        return NULL;
-    }
-
-    return(rsp.Encode());
+    //served from memory, marshaled once per tutorial by the cache service
+    return sTutorialStore.GetTutorialInfo(*m_manager->cache_service, args.tutorialID);
 }
 
 PyResult TutorialService::Handle_GetTutorials(PyCallArgs &call) {
-    return(m_db.GetAllTutorials());
+    return sTutorialStore.GetTutorials(*m_manager->cache_service);
 }
 
 PyResult TutorialService::Handle_GetCriterias(PyCallArgs &call) {
-    return(m_db.GetAllCriterias());
+    return sTutorialStore.GetCriterias(*m_manager->cache_service);
 }
 
 PyResult TutorialService::Handle_GetCategories(PyCallArgs &call) {
-    return(m_db.GetCategories());
+    return sTutorialStore.GetCategories(*m_manager->cache_service);
 }
 
 PyResult TutorialService::Handle_GetContextHelp( PyCallArgs& call )
 {
-    sLog.Debug( "TutorialService", "Called GetContextHelp stub." );
+    _debug( "TutorialService", "Called GetContextHelp stub." );
 
     return new PyList;
 }
 
 PyResult TutorialService::Handle_GetCharacterTutorialState( PyCallArgs& call )
 {
-    sLog.Debug( "TutorialService", "Called GetCharacterTutorialState stub." );
+    _debug( "TutorialService", "Called GetCharacterTutorialState stub." );
 
     util_Rowset rs;
     rs.lines = new PyList;
@@ -121,7 +97,7 @@ PyResult TutorialService::Handle_GetCharacterTutorialState( PyCallArgs& call )
 
 PyResult TutorialService::Handle_GetTutorialsAndConnections( PyCallArgs& call )
 {
-    sLog.Debug( "TutorialService", "Called GetTutorialsAndConnections stub." );
+    _debug( "TutorialService", "Called GetTutorialsAndConnections stub." );
 
     return new PyNone;
 }
@@ -0,0 +1,288 @@
+/*
+    ------------------------------------------------------------------------------------
+    LICENSE:
+    ------------------------------------------------------------------------------------
+    This file is part of EVEmu: EVE Online Server Emulator
+    Copyright 2006 - 2011 The EVEmu Team
+    For the latest information visit http://evemu.org
+    ------------------------------------------------------------------------------------
+    This program is free software; you can redistribute it and/or modify it under
+    the terms of the GNU Lesser General Public License as published by the Free Software
+    Foundation; either version 2 of the License, or (at your option) any later
+    version.
+
+    This program is distributed in the hope that it will be useful, but WITHOUT
+    ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+    FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public License along with
+    this program; if not, write to the Free Software Foundation, Inc., 59 Temple
+    Place - Suite 330, Boston, MA 02111-1307, USA, or go to
+    http://www.gnu.org/copyleft/lesser.txt.
+    ------------------------------------------------------------------------------------
+    Author:     EVEmu Team
+*/
+
+
+#include "eve-server.h"
+
+#include "account/TutorialDB.h"
+#include "account/TutorialStore.h"
+
+/************************************************************************/
+/* TutorialStore::Split                                                 */
+/************************************************************************/
+TutorialStore::Split::~Split()
+{
+    std::map< uint32, PyRep* >::iterator cur, end;
+    cur = rowsets.begin();
+    end = rowsets.end();
+    for(; cur != end; cur++ )
+        PySafeDecRef( cur->second );
+}
+
+PyRep* TutorialStore::Split::Take( uint32 key )
+{
+    std::map< uint32, PyRep* >::iterator res = rowsets.find( key );
+    if( rowsets.end() != res )
+    {
+        PyRep* rowset = res->second;
+        rowsets.erase( res );
+
+        return rowset;
+    }
+
+    util_Rowset rs;
+    rs.header = header;
+    rs.lines = new PyList;
+
+    return rs.Encode();
+}
+
+/************************************************************************/
+/* TutorialStore                                                        */
+/************************************************************************/
+TutorialStore::TutorialStore()
+: mUnknownInfo( NULL ),
+  mTutorialsID( "tutorialSvc", "GetTutorials" ),
+  mAllTutorials( NULL ),
+  mCriteriasID( "tutorialSvc", "GetCriterias" ),
+  mCriterias( NULL ),
+  mCategoriesID( "tutorialSvc", "GetCategories" ),
+  mCategories( NULL )
+{
+}
+
+TutorialStore::~TutorialStore()
+{
+    _Clear();
+}
+
+bool TutorialStore::Load()
+{
+    TutorialDB db;
+
+    DBQueryResult pageCriteriasRes, pagesRes, tutorialsRes, criteriasRes;
+    if( !db.GetAllPageCriterias( pageCriteriasRes )
+        || !db.GetAllPages( pagesRes )
+        || !db.GetTutorialRows( tutorialsRes )
+        || !db.GetAllTutorialCriterias( criteriasRes ) )
+        return false;
+
+    PyRep* allTutorials = db.GetAllTutorials();
+    PyRep* criterias = db.GetAllCriterias();
+    PyRep* categories = db.GetCategories();
+    if( NULL == allTutorials || NULL == criterias || NULL == categories )
+    {
+        PySafeDecRef( allTutorials );
+        PySafeDecRef( criterias );
+        PySafeDecRef( categories );
+        return false;
+    }
+
+    Split pageCriterias, pages, tutorials, tutorialCriterias;
+    _Split( pageCriteriasRes, pageCriterias );
+    _Split( pagesRes, pages );
+    _Split( tutorialsRes, tutorials );
+    _Split( criteriasRes, tutorialCriterias );
+
+    _Clear();
+
+    // every tutorial has a row, the rest are only its parts
+    std::vector< uint32 > tutorialIDs;
+    std::map< uint32, PyRep* >::const_iterator cur, end;
+    cur = tutorials.rowsets.begin();
+    end = tutorials.rowsets.end();
+    for(; cur != end; cur++ )
+        tutorialIDs.push_back( cur->first );
+
+    // the key 0 is never a tutorial, so it gets the empty rowsets
+    tutorialIDs.push_back( 0 );
+
+    for( size_t i = 0; i < tutorialIDs.size(); ++i )
+    {
+        const uint32 tutorialID = tutorialIDs[ i ];
+
+        Rsp_GetTutorialInfo rsp;
+        rsp.pagecriterias = pageCriterias.Take( tutorialID );
+        rsp.pages = pages.Take( tutorialID );
+        rsp.tutorial = tutorials.Take( tutorialID );
+        rsp.criterias = tutorialCriterias.Take( tutorialID );
+
+        PyRep* info = rsp.Encode();
+        info->Freeze();
+
+        if( 0 == tutorialID )
+        {
+            mUnknownInfo = info;
+            continue;
+        }
+
+        // the cache service knows the tutorial by this
+        PyTuple* objectID = new PyTuple( 2 );
+        objectID->SetItem( 0, new PyString( "tutorialSvc.GetTutorialInfo" ) );
+        objectID->SetItem( 1, new PyInt( tutorialID ) );
+        objectID->Freeze();
+
+        Tutorial& tutorial = mTutorials[ tutorialID ];
+        tutorial.objectID = objectID;
+        tutorial.info = info;
+    }
+
+    allTutorials->Freeze();
+    mAllTutorials = allTutorials;
+    criterias->Freeze();
+    mCriterias = criterias;
+    categories->Freeze();
+    mCategories = categories;
+
+    return true;
+}
+
+bool TutorialStore::Reload( ObjCacheService& cache )
+{
+    // by the objectIDs of the old content; the replies are rebuilt from whatever is loaded then
+    _Invalidate( cache );
+
+    return Load();
+}
+
+PyRep* TutorialStore::GetTutorialInfo( ObjCacheService& cache, uint32 tutorialID )
+{
+    ++mStats.calls;
+
+    std::map< uint32, Tutorial >::const_iterator res = mTutorials.find( tutorialID );
+    if( mTutorials.end() == res )
+    {
+        ++mStats.unknown;
+
+        PySafeIncRef( mUnknownInfo );
+        return mUnknownInfo;
+    }
+
+    return _Serve( cache, res->second.objectID, res->second.info );
+}
+
+PyRep* TutorialStore::GetTutorials( ObjCacheService& cache )
+{
+    ++mStats.calls;
+
+    return _Serve( cache, mTutorialsID.objectID, mAllTutorials );
+}
+
+PyRep* TutorialStore::GetCriterias( ObjCacheService& cache )
+{
+    ++mStats.calls;
+
+    return _Serve( cache, mCriteriasID.objectID, mCriterias );
+}
+
+PyRep* TutorialStore::GetCategories( ObjCacheService& cache )
+{
+    ++mStats.calls;
+
+    return _Serve( cache, mCategoriesID.objectID, mCategories );
+}
+
+PyRep* TutorialStore::_Serve( ObjCacheService& cache, const PyRep* objectID, PyRep* contents )
+{
+    if( NULL == contents )
+        return NULL;
+
+    if( !cache.IsCacheLoaded( objectID ) )
+    {
+        // marshaled and deflated once by the cache service
+        PyIncRef( contents );
+        cache.GiveCache( objectID, &contents );
+
+        ++mStats.built;
+    }
+
+    return cache.MakeObjectCachedMethodCallResult( objectID );
+}
+
+void TutorialStore::_Invalidate( ObjCacheService& cache )
+{
+    std::map< uint32, Tutorial >::const_iterator cur, end;
+    cur = mTutorials.begin();
+    end = mTutorials.end();
+    for(; cur != end; cur++ )
+        cache.InvalidateCache( cur->second.objectID );
+
+    cache.InvalidateCache( mTutorialsID );
+    cache.InvalidateCache( mCriteriasID );
+    cache.InvalidateCache( mCategoriesID );
+}
+
+void TutorialStore::_Clear()
+{
+    std::map< uint32, Tutorial >::iterator cur, end;
+    cur = mTutorials.begin();
+    end = mTutorials.end();
+    for(; cur != end; cur++ )
+    {
+        PySafeDecRef( cur->second.objectID );
+        PySafeDecRef( cur->second.info );
+    }
+    mTutorials.clear();
+
+    PySafeDecRef( mUnknownInfo );
+    mUnknownInfo = NULL;
+    PySafeDecRef( mAllTutorials );
+    mAllTutorials = NULL;
+    PySafeDecRef( mCriterias );
+    mCriterias = NULL;
+    PySafeDecRef( mCategories );
+    mCategories = NULL;
+}
+
+void TutorialStore::_Split( DBQueryResult& res, Split& into )
+{
+    const uint32 cc = res.ColumnCount();
+    for( uint32 i = 1; i < cc; ++i )
+        into.header.push_back( res.ColumnName( i ) );
+
+    PyList* lines = NULL;
+    uint32 key = 0;
+
+    DBResultRow row;
+    while( res.GetRow( row ) )
+    {
+        // the rows of a key come one after another
+        if( NULL == lines || row.GetUInt( 0 ) != key )
+        {
+            key = row.GetUInt( 0 );
+
+            util_Rowset rs;
+            rs.header = into.header;
+            rs.lines = lines = new PyList;
+
+            into.rowsets[ key ] = rs.Encode();
+        }
+
+        PyList* line = new PyList( cc - 1 );
+        for( uint32 i = 1; i < cc; ++i )
+            line->SetItem( i - 1, DBColumnToPyRep( row, i ) );
+        lines->AddItem( line );
+    }
+}
@@ -48,14 +48,14 @@ PyResult UserService::Handle_GetRedeemTokens( PyCallArgs& call )
 {
     // takes no args
 
-    sLog.Debug( "UserService", "Called GetRedeemTokens stub." );
+    _debug( "UserService", "Called GetRedeemTokens stub." );
 
     return new PyList;
 }
 
 PyResult UserService::Handle_GetCreateDate( PyCallArgs& call )
 {
-    sLog.Debug( "UserService", "Called GetCreateDate stub." );
+    _debug( "UserService", "Called GetCreateDate stub." );
 
     return new PyLong((long)Win32TimeNow());
 }
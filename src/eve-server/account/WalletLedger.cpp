@@ -0,0 +1,296 @@
+/*
+    ------------------------------------------------------------------------------------
+    LICENSE:
+    ------------------------------------------------------------------------------------
+    This file is part of EVEmu: EVE Online Server Emulator
+    Copyright 2006 - 2011 The EVEmu Team
+    For the latest information visit http://evemu.org
+    ------------------------------------------------------------------------------------
+    This program is free software; you can redistribute it and/or modify it under
+    the terms of the GNU Lesser General Public License as published by the Free Software
+    Foundation; either version 2 of the License, or (at your option) any later
+    version.
+
+    This program is distributed in the hope that it will be useful, but WITHOUT
+    ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+    FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public License along with
+    this program; if not, write to the Free Software Foundation, Inc., 59 Temple
+    Place - Suite 330, Boston, MA 02111-1307, USA, or go to
+    http://www.gnu.org/copyleft/lesser.txt.
+    ------------------------------------------------------------------------------------
+    Author:     EVEmu Team
+*/
+
+#include "eve-server.h"
+
+#include "account/WalletLedger.h"
+#include "market/MarketJournal.h"
+
+/// Most windows kept at once.
+static const size_t WALLET_WINDOWS = 1024;
+/// Most entries kept in a window.
+static const size_t WALLET_WINDOW_ENTRIES = 1000;
+
+WalletLedger::WalletLedger()
+: mLastRefID( 0 ),
+  mUseCounter( 0 )
+{
+}
+
+bool WalletLedger::Load()
+{
+    DBQueryResult res;
+    if( !sDatabase.RunQuery( res, "SELECT MAX(refID) FROM market_journal" ) )
+    {
+        codelog( SERVICE__ERROR, "Error in query: %s", res.error.c_str() );
+        return false;
+    }
+
+    mCorpBalances.clear();
+    mWindows.clear();
+
+    mLastRefID = 0;
+    DBResultRow row;
+    if( res.GetRow( row ) && !row.IsNull( 0 ) )
+        mLastRefID = row.GetUInt( 0 );
+
+    return true;
+}
+
+double WalletLedger::GetCorpBalance( uint32 corpID )
+{
+    std::tr1::unordered_map< uint32, double >::const_iterator res = mCorpBalances.find( corpID );
+    if( res != mCorpBalances.end() )
+        return res->second;
+
+    // the changes still in the journal are in memory already
+    DBQueryResult qres;
+    if( !sDatabase.RunQuery( qres, "SELECT balance FROM corporation WHERE corporationID = %u", corpID ) )
+    {
+        codelog( SERVICE__ERROR, "Error in query: %s", qres.error.c_str() );
+        return 0.0;
+    }
+
+    DBResultRow row;
+    if( !qres.GetRow( row ) )
+    {
+        sLog.Error( "WalletLedger", "Corporation %u missing from database.", corpID );
+        return 0.0;
+    }
+
+    return mCorpBalances[ corpID ] = row.GetDouble( 0 );
+}
+
+bool WalletLedger::AddCorpBalance( uint32 corpID, double amount )
+{
+    // loads the balance if it is not resident yet
+    GetCorpBalance( corpID );
+
+    std::tr1::unordered_map< uint32, double >::iterator res = mCorpBalances.find( corpID );
+    if( res == mCorpBalances.end() )
+        return false;
+
+    res->second += amount;
+
+    char buf[128];
+    snprintf( buf, sizeof( buf ),
+        "UPDATE corporation SET balance=balance+%.2f WHERE corporationID=%u", amount, corpID );
+    sMarketJournal.Append( buf );
+
+    ++mStats.changes;
+    return true;
+}
+
+void WalletLedger::AddCharacterBalance( uint32 characterID, double amount )
+{
+    char buf[128];
+    snprintf( buf, sizeof( buf ),
+        "UPDATE character_ SET balance=balance+%.2f WHERE characterID=%u", amount, characterID );
+    sMarketJournal.Append( buf );
+
+    ++mStats.changes;
+}
+
+uint32 WalletLedger::Record( uint32 ownerID, uint32 accountID, WalletEntry& entry )
+{
+    entry.refID = ++mLastRefID;
+    entry.transDate = Win32TimeNow();
+
+    std::string eArg1, eReason;
+    sDatabase.DoEscapeString( eArg1, entry.argID1 );
+    sDatabase.DoEscapeString( eReason, entry.reason );
+
+    std::string query;
+    sprintf( query,
+        "INSERT INTO market_journal(characterID,refID,transDate,refTypeID,ownerID1,ownerID2,argID1,accountID,accountKey,amount,balance,reason)"
+        " VALUES (%u,%u,%" PRIu64 ",%u,%u,%u,\"%s\",%u,%u,%.2f,%.2f,\"%s\")",
+        ownerID, entry.refID, entry.transDate, entry.refTypeID, entry.ownerID1, entry.ownerID2, eArg1.c_str(),
+        accountID, entry.accountKey, entry.amount, entry.balance, eReason.c_str() );
+    sMarketJournal.Append( query );
+
+    std::tr1::unordered_map< uint32, Window >::iterator res = mWindows.find( ownerID );
+    if( res != mWindows.end() )
+    {
+        Window& window = res->second;
+        window.entries.push_back( entry );
+
+        if( WALLET_WINDOW_ENTRIES < window.entries.size() )
+        {
+            // the window no longer has all the entries since the oldest one
+            window.from = window.entries.front().transDate + 1;
+            window.entries.pop_front();
+        }
+    }
+
+    ++mStats.entries;
+    return entry.refID;
+}
+
+PyObject* WalletLedger::GetJournal( uint32 ownerID, uint32 refTypeID, uint32 accountKey, uint64 transDate )
+{
+    const uint64 from = transDate - Win32Time_Day;
+
+    Window* window = _GetWindow( ownerID, from );
+    if( NULL == window )
+        return NULL;
+
+    static const MarshalStringToken type( "util.Rowset" );
+
+    PyDict* args = new PyDict;
+    PyObject* res = new PyObject( new PyString( type ), args );
+
+    PyList* header = new PyList( 11 );
+    header->SetItem( 0, PyStatic::InternString( "transactionID" ) );
+    header->SetItem( 1, PyStatic::InternString( "transactionDate" ) );
+    header->SetItem( 2, PyStatic::InternString( "referenceID" ) );
+    header->SetItem( 3, PyStatic::InternString( "entryTypeID" ) );
+    header->SetItem( 4, PyStatic::InternString( "ownerID1" ) );
+    header->SetItem( 5, PyStatic::InternString( "ownerID2" ) );
+    header->SetItem( 6, PyStatic::InternString( "argID1" ) );
+    header->SetItem( 7, PyStatic::InternString( "accountKey" ) );
+    header->SetItem( 8, PyStatic::InternString( "amount" ) );
+    header->SetItem( 9, PyStatic::InternString( "balance" ) );
+    header->SetItem( 10, PyStatic::InternString( "description" ) );
+    args->SetItem( PyStatic::NewString( "header" ), header );
+
+    args->SetItem( PyStatic::NewString( "RowClass" ), new PyToken( "util.Row" ) );
+
+    PyList* lines = new PyList;
+    args->SetItem( PyStatic::NewString( "lines" ), lines );
+
+    std::deque< WalletEntry >::const_iterator cur, end;
+    cur = window->entries.begin();
+    end = window->entries.end();
+    for(; cur != end; ++cur )
+    {
+        if( cur->transDate < from || transDate < cur->transDate )
+            continue;
+        if( cur->accountKey != accountKey )
+            continue;
+        if( 0 != refTypeID && cur->refTypeID != refTypeID )
+            continue;
+
+        PyList* line = new PyList( 11 );
+        line->SetItem( 0, new PyInt( cur->refID ) );
+        line->SetItem( 1, new PyLong( cur->transDate ) );
+        line->SetItem( 2, new PyInt( 0 ) );
+        line->SetItem( 3, new PyInt( cur->refTypeID ) );
+        line->SetItem( 4, new PyInt( cur->ownerID1 ) );
+        line->SetItem( 5, new PyInt( cur->ownerID2 ) );
+        line->SetItem( 6, new PyString( cur->argID1 ) );
+        line->SetItem( 7, new PyInt( cur->accountKey ) );
+        line->SetItem( 8, new PyFloat( cur->amount ) );
+        line->SetItem( 9, new PyFloat( cur->balance ) );
+        line->SetItem( 10, new PyString( cur->reason ) );
+        lines->AddItem( line );
+    }
+
+    // a window which was just loaded may be over the limit
+    while( WALLET_WINDOW_ENTRIES < window->entries.size() )
+    {
+        window->from = window->entries.front().transDate + 1;
+        window->entries.pop_front();
+    }
+
+    return res;
+}
+
+WalletLedger::Window* WalletLedger::_GetWindow( uint32 ownerID, uint64 from )
+{
+    std::tr1::unordered_map< uint32, Window >::iterator res = mWindows.find( ownerID );
+    if( res != mWindows.end() && res->second.from <= from )
+    {
+        ++mStats.windowHits;
+
+        res->second.lastUsed = ++mUseCounter;
+        return &res->second;
+    }
+
+    ++mStats.windowMisses;
+
+    // the entries still in the journal must be in the database first
+    sMarketJournal.Flush();
+
+    DBQueryResult qres;
+    if( !sDatabase.RunQuery( qres,
+        "SELECT refID, transDate, refTypeID, ownerID1, ownerID2, argID1, accountKey, amount, balance, reason"
+        " FROM market_journal"
+        " WHERE characterID = %u"
+        " AND transDate >= %" PRIu64
+        " ORDER BY refID",
+        ownerID, from ) )
+    {
+        codelog( SERVICE__ERROR, "Error in query: %s", qres.error.c_str() );
+        return NULL;
+    }
+
+    if( res == mWindows.end() )
+    {
+        _EvictWindow();
+        res = mWindows.insert( std::make_pair( ownerID, Window() ) ).first;
+    }
+
+    Window& window = res->second;
+    window.from = from;
+    window.entries.clear();
+    window.lastUsed = ++mUseCounter;
+
+    DBResultRow row;
+    while( qres.GetRow( row ) )
+    {
+        WalletEntry entry;
+        entry.refID = row.GetUInt( 0 );
+        entry.transDate = row.GetUInt64( 1 );
+        entry.refTypeID = row.GetUInt( 2 );
+        entry.ownerID1 = row.GetUInt( 3 );
+        entry.ownerID2 = row.GetUInt( 4 );
+        entry.argID1 = ( row.IsNull( 5 ) ? "" : row.GetText( 5 ) );
+        entry.accountKey = row.GetUInt( 6 );
+        entry.amount = row.GetDouble( 7 );
+        entry.balance = row.GetDouble( 8 );
+        entry.reason = ( row.IsNull( 9 ) ? "" : row.GetText( 9 ) );
+
+        window.entries.push_back( entry );
+    }
+
+    return &window;
+}
+
+void WalletLedger::_EvictWindow()
+{
+    if( mWindows.size() < WALLET_WINDOWS )
+        return;
+
+    std::tr1::unordered_map< uint32, Window >::iterator cur, end, oldest;
+    cur = oldest = mWindows.begin();
+    end = mWindows.end();
+    for(; cur != end; ++cur )
+    {
+        if( cur->second.lastUsed < oldest->second.lastUsed )
+            oldest = cur;
+    }
+
+    mWindows.erase( oldest );
+}
@@ -27,6 +27,7 @@
 
 #include "PyServiceCD.h"
 #include "admin/AlertService.h"
+#include "admin/ClientTelemetry.h"
 
 PyCallable_Make_InnerDispatcher(AlertService)
 
@@ -99,6 +100,16 @@ PyResult AlertService::Handle_BeanDelivery( PyCallArgs& call )
  */
 PyResult AlertService::Handle_SendClientStackTraceAlert(PyCallArgs &call) {
 
+    //the python stack trace payload; counted by its text in the background.
+    if(call.tuple->size() > 1) {
+        PyRep *payload = call.tuple->GetItem(1);
+        if(payload->IsString())
+            sClientTelemetry.Report(ClientTelemetry::KIND_STACK_TRACE, call.client->GetCharacterID(), payload->AsString()->content());
+        else if(payload->IsBuffer() && payload->AsBuffer()->size() > 0)
+            sClientTelemetry.Report(ClientTelemetry::KIND_STACK_TRACE, call.client->GetCharacterID(),
+                                    std::string((const char *)&payload->AsBuffer()->content()[0], payload->AsBuffer()->size()));
+    }
+
 #ifdef DEV_DEBUG_TREAT
     traceLogger->logTrace(*call.tuple);
 #endif//DEV_DEBUG_TREAT
@@ -27,6 +27,7 @@
 
 #include "PyServiceCD.h"
 #include "admin/ClientStatLogger.h"
+#include "admin/ClientTelemetry.h"
 
 PyCallable_Make_InnerDispatcher(ClientStatLogger)
 
@@ -50,7 +51,8 @@ PyResult ClientStatLogger::Handle_LogString(PyCallArgs &call) {
         return NULL;
     }
 
-    sLog.Error("LogFromClient", "This came from client: %s", args.arg.c_str());
+    //storms of these follow client errors, so they are only queued.
+    sClientTelemetry.Report(ClientTelemetry::KIND_LOG_STRING, call.client->GetCharacterID(), args.arg);
 
     return NULL;
 }
@@ -0,0 +1,211 @@
+/*
+    ------------------------------------------------------------------------------------
+    LICENSE:
+    ------------------------------------------------------------------------------------
+    This file is part of EVEmu: EVE Online Server Emulator
+    Copyright 2006 - 2011 The EVEmu Team
+    For the latest information visit http://evemu.org
+    ------------------------------------------------------------------------------------
+    This program is free software; you can redistribute it and/or modify it under
+    the terms of the GNU Lesser General Public License as published by the Free Software
+    Foundation; either version 2 of the License, or (at your option) any later
+    version.
+
+    This program is distributed in the hope that it will be useful, but WITHOUT
+    ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+    FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public License along with
+    this program; if not, write to the Free Software Foundation, Inc., 59 Temple
+    Place - Suite 330, Boston, MA 02111-1307, USA, or go to
+    http://www.gnu.org/copyleft/lesser.txt.
+    ------------------------------------------------------------------------------------
+    Author:     EVEmu Team
+*/
+
+
+#include "eve-server.h"
+
+#include "admin/ClientTelemetry.h"
+
+/// The most reports queued between two flushes.
+static const size_t TELEMETRY_QUEUE_LIMIT = 4096;
+/// Time (in milliseconds) between the first queued report and the flush.
+static const uint32 TELEMETRY_FLUSH_DELAY = 10000;
+/// The longest text kept of a report.
+static const size_t TELEMETRY_TEXT_LIMIT = 8192;
+
+/**
+ * @brief Aggregates the reports and writes them on a worker thread.
+ */
+class ClientTelemetry::FlushQuery
+: public DBAsyncQuery
+{
+public:
+    FlushQuery( ClientTelemetry& telemetry )
+    : mTelemetry( telemetry ),
+      mRows( 0 )
+    {
+    }
+
+    ClientTelemetry& mTelemetry;
+    std::vector< Entry > mEntries;
+    /// Number of distinct texts written.
+    uint32 mRows;
+    /// The error of the insert.
+    DBerror mError;
+
+protected:
+    /**
+     * @brief The reports of a distinct text.
+     */
+    struct Aggregate
+    {
+        const Entry* sample;
+        uint32 count;
+        uint64 firstTime;
+        uint64 lastTime;
+    };
+
+    bool Run()
+    {
+        // by kind and hash of the text
+        std::map< std::pair< uint8, uint32 >, Aggregate > aggregates;
+
+        std::vector< Entry >::const_iterator cur, end;
+        cur = mEntries.begin();
+        end = mEntries.end();
+        for(; cur != end; cur++ )
+        {
+            const uint32 hash = CRC32::Generate( (const uint8*)cur->text.data(), cur->text.size() );
+
+            std::map< std::pair< uint8, uint32 >, Aggregate >::iterator res = aggregates.find( std::make_pair( cur->kind, hash ) );
+            if( aggregates.end() == res )
+            {
+                Aggregate& aggregate = aggregates[ std::make_pair( cur->kind, hash ) ];
+                aggregate.sample = &*cur;
+                aggregate.count = 1;
+                aggregate.firstTime = cur->time;
+                aggregate.lastTime = cur->time;
+            }
+            else
+            {
+                ++res->second.count;
+                res->second.lastTime = cur->time;
+                // the latest reporter is the most interesting one
+                res->second.sample = &*cur;
+            }
+        }
+
+        if( aggregates.empty() )
+            return true;
+
+        std::string query =
+            "INSERT INTO clientTelemetry"
+            " (kind, hash, sample, reports, firstReported, lastReported, lastCharacterID)"
+            " VALUES ";
+
+        std::string textEsc;
+        char buf[128];
+        std::map< std::pair< uint8, uint32 >, Aggregate >::const_iterator cura, enda;
+        cura = aggregates.begin();
+        enda = aggregates.end();
+        for(; cura != enda; cura++ )
+        {
+            sDatabase.DoEscapeString( textEsc, cura->second.sample->text );
+
+            if( cura != aggregates.begin() )
+                query += ", ";
+            snprintf( buf, sizeof( buf ), "(%u, %u, '", cura->first.first, cura->first.second );
+            query += buf;
+            //the escaped string carries its terminator
+            query += textEsc.c_str();
+            snprintf( buf, sizeof( buf ), "', %u, %" PRIu64 ", %" PRIu64 ", %u)",
+                      cura->second.count, cura->second.firstTime, cura->second.lastTime, cura->second.sample->characterID );
+            query += buf;
+        }
+
+        query +=
+            " ON DUPLICATE KEY UPDATE"
+            "  reports = reports + VALUES(reports),"
+            "  lastReported = VALUES(lastReported),"
+            "  lastCharacterID = VALUES(lastCharacterID)";
+
+        if( !sDatabase.RunQuery( mError, "%s", query.c_str() ) )
+            return false;
+
+        mRows = (uint32)aggregates.size();
+        return true;
+    }
+
+    void Complete( bool success, DBQueryResult& result )
+    {
+        mTelemetry._Complete( *this, success );
+    }
+};
+
+ClientTelemetry::ClientTelemetry()
+: mPending( false )
+{
+}
+
+void ClientTelemetry::Report( uint8 kind, uint32 characterID, const std::string& text )
+{
+    if( TELEMETRY_QUEUE_LIMIT <= mQueue.size() )
+    {
+        ++mStats.dropped;
+        return;
+    }
+
+    mQueue.push_back( Entry() );
+    Entry& entry = mQueue.back();
+    entry.kind = kind;
+    entry.characterID = characterID;
+    entry.time = Win32TimeNow();
+    entry.text.assign( text, 0, TELEMETRY_TEXT_LIMIT );
+    ++mStats.reports;
+
+    if( !mPending && !IsTimerScheduled() )
+        sTimerWheel.Schedule( this, TELEMETRY_FLUSH_DELAY );
+}
+
+void ClientTelemetry::Flush()
+{
+    sTimerWheel.Cancel( this );
+
+    if( mQueue.empty() )
+        return;
+
+    FlushQuery* query = new FlushQuery( *this );
+    query->mEntries.swap( mQueue );
+    mPending = true;
+
+    sDBAsync.Submit( query );
+}
+
+void ClientTelemetry::TimerExpired()
+{
+    // the running flush schedules the next one
+    if( mPending )
+        return;
+
+    Flush();
+}
+
+void ClientTelemetry::_Complete( FlushQuery& query, bool success )
+{
+    mPending = false;
+    ++mStats.flushes;
+
+    if( success )
+        mStats.rows += query.mRows;
+    else
+    {
+        _log( SERVICE__ERROR, "Failed to write %lu client telemetry reports: %s", (unsigned long)query.mEntries.size(), query.mError.c_str() );
+        ++mStats.failed;
+    }
+
+    // what came in meanwhile waits a full delay, so a storm is written once per delay
+    if( !mQueue.empty() && !IsTimerScheduled() )
+        sTimerWheel.Schedule( this, TELEMETRY_FLUSH_DELAY );
+}
@@ -26,14 +26,27 @@
 #include "eve-server.h"
 
 #include "Client.h"
+#include "EVEServerConfig.h"
+#include "account/TutorialStore.h"
 #include "admin/AllCommands.h"
 #include "admin/CommandDB.h"
+#include "admin/PacketTrace.h"
+#include "admin/StressTest.h"
 #include "inventory/AttributeEnum.h"
+#include "inventory/InventoryBatch.h"
 #include "inventory/InventoryDB.h"
 #include "inventory/InventoryItem.h"
 #include "manufacturing/Blueprint.h"
+#include "npc/NPC.h"
+#include "pos/PlanetSimulation.h"
+#include "pos/StarbaseSimulator.h"
+#include "pos/Structure.h"
 #include "ship/DestinyManager.h"
 #include "ship/Drone.h"
+#include "ship/FittingEvaluator.h"
+#include "standing/SovereigntyTable.h"
+#include "system/Container.h"
+#include "system/DungeonManager.h"
 #include "system/SystemManager.h"
 #include "system/SystemBubble.h"
 
@@ -1232,3 +1245,1099 @@ PyResult Command_kill( Client* who, CommandDB* db, PyServiceMgr* services, const
     return NULL;
 }
 
+
+PyResult Command_callstats( Client* who, CommandDB* db, PyServiceMgr* services, const Seperator& args )
+{
+    // number of calls shown to the client; the log gets all of them
+    const size_t shownCalls = 15;
+
+    if( args.argCount() == 2 && args.arg( 1 ) == "reset" )
+    {
+        services->ResetCallStats();
+        return new PyString( "Call statistics reset." );
+    }
+    else if( args.argCount() != 1 )
+        throw PyException( MakeCustomError( "Correct Usage: /callstats [reset]" ) );
+
+    if( !PyCallable::CallStats::IsEnabled() )
+        throw PyException( MakeCustomError( "Call statistics are disabled, enable loop.callStats in the config." ) );
+
+    PyCallable::CallStatsMap stats;
+    services->GetCallStats( stats );
+
+    // most expensive first
+    std::vector< std::pair<uint64, std::string> > order;
+    PyCallable::CallStatsMap::const_iterator cur, end;
+    cur = stats.begin();
+    end = stats.end();
+    for(; cur != end; cur++)
+        order.push_back( std::make_pair( cur->second.totalTime, cur->first ) );
+    std::sort( order.rbegin(), order.rend() );
+
+    std::string reply = "Service calls by total time: calls, exceptions, total ms, avg us, max us, histogram <10us ... >=1s";
+    sLog.Log( "Call Stats", "%s", reply.c_str() );
+
+    for( size_t i = 0; i < order.size(); ++i )
+    {
+        const PyCallable::CallStats& s = stats[ order[ i ].second ];
+
+        std::string histogram;
+        for( size_t j = 0; j < PyCallable::CallStats::HISTOGRAM_SIZE; ++j )
+        {
+            char bucket[32];
+            snprintf( bucket, sizeof( bucket ), "%s%" PRIu64, ( 0 < j ? "/" : "" ), s.histogram[ j ] );
+            histogram += bucket;
+        }
+
+        char line[256];
+        snprintf( line, sizeof( line ), "%s: %" PRIu64 ", %" PRIu64 ", %" PRIu64 ", %" PRIu64 ", %" PRIu64 ", %s",
+                  order[ i ].second.c_str(), s.calls, s.exceptions, s.totalTime / 1000, s.totalTime / s.calls, s.maxTime, histogram.c_str() );
+
+        sLog.Log( "Call Stats", "%s", line );
+        if( i < shownCalls )
+        {
+            reply += "\n";
+            reply += line;
+        }
+    }
+
+    return new PyString( reply );
+}
+
+/**
+ * @brief Explains the most expensive statements and lists what they read without a fitting index.
+ *
+ * @param[in] count       The most statements explained.
+ * @param[in] shownLength Longest part of a statement shown.
+ */
+static std::string FormatIndexAdvice( size_t count, size_t shownLength )
+{
+    std::vector<DBcore::IndexAdvice> advice;
+    const size_t explained = sDatabase.AdviseIndexes( count, advice );
+
+    char head[128];
+    snprintf( head, sizeof( head ), "Explained %lu statements, %lu findings: table, access, key, rows, extra, calls, total ms",
+              (unsigned long)explained, (unsigned long)advice.size() );
+    std::string reply = head;
+    sLog.Log( "Index Advisor", "%s", reply.c_str() );
+
+    for( size_t i = 0; i < advice.size(); ++i )
+    {
+        const DBcore::IndexAdvice& a = advice[ i ];
+
+        char line[512];
+        snprintf( line, sizeof( line ), "%s, %s, %s, %" PRIu64 ", %s, %" PRIu64 ", %" PRIu64,
+                  a.table.c_str(), a.access.c_str(), ( a.key.empty() ? "none" : a.key.c_str() ), a.rows,
+                  a.extra.c_str(), a.calls, a.totalTime / 1000 );
+
+        sLog.Log( "Index Advisor", "%s: %s", a.fingerprint.c_str(), line );
+
+        reply += "\n";
+        if( a.fingerprint.size() <= shownLength )
+            reply += a.fingerprint;
+        else
+            reply += a.fingerprint.substr( 0, shownLength ) + "...";
+        reply += ": ";
+        reply += line;
+    }
+
+    return reply;
+}
+
+PyResult Command_dbstats( Client* who, CommandDB* db, PyServiceMgr* services, const Seperator& args )
+{
+    // number of queries shown to the client; the log gets all of them
+    const size_t shownQueries = 15;
+    // longest part of a fingerprint shown to the client
+    const size_t shownLength = 120;
+
+    if( args.argCount() == 2 && args.arg( 1 ) == "reset" )
+    {
+        sDatabase.ResetQueryStats();
+        return new PyString( "Query statistics reset." );
+    }
+    else if( 2 <= args.argCount() && args.argCount() <= 3 && args.arg( 1 ) == "explain" )
+    {
+        if( !sDatabase.IsIndexAdvisorEnabled() )
+            throw PyException( MakeCustomError( "The index advisor is disabled; enable database.indexAdvisor." ) );
+
+        size_t count = shownQueries;
+        if( args.argCount() == 3 )
+        {
+            if( !args.isNumber( 2 ) )
+                throw PyException( MakeCustomError( "Argument 2 must be a number." ) );
+            count = atoi( args.arg( 2 ).c_str() );
+        }
+
+        return new PyString( FormatIndexAdvice( count, shownLength ) );
+    }
+    else if( args.argCount() != 1 )
+        throw PyException( MakeCustomError( "Correct Usage: /dbstats [reset|explain [count]]" ) );
+
+    DBcore::QueryStatsMap stats;
+    sDatabase.GetQueryStats( stats );
+
+    // most expensive first
+    std::vector< std::pair<uint64, std::string> > order;
+    DBcore::QueryStatsMap::const_iterator cur, end;
+    cur = stats.begin();
+    end = stats.end();
+    for(; cur != end; cur++)
+        order.push_back( std::make_pair( cur->second.totalTime, cur->first ) );
+    std::sort( order.rbegin(), order.rend() );
+
+    std::string reply = "Queries by total time: calls, rows, total ms, avg us, max us (at), wait ms, histogram <10us ... >=1s";
+    sLog.Log( "Query Stats", "%s", reply.c_str() );
+
+    for( size_t i = 0; i < order.size(); ++i )
+    {
+        const DBcore::QueryStats& s = stats[ order[ i ].second ];
+
+        std::string histogram;
+        for( size_t j = 0; j < DBcore::QueryStats::HISTOGRAM_SIZE; ++j )
+        {
+            char bucket[32];
+            snprintf( bucket, sizeof( bucket ), "%s%" PRIu64, ( 0 < j ? "/" : "" ), s.histogram[ j ] );
+            histogram += bucket;
+        }
+
+        char line[256];
+        snprintf( line, sizeof( line ), "%" PRIu64 ", %" PRIu64 ", %" PRIu64 ", %" PRIu64 ", %" PRIu64 " (%s:%d), %" PRIu64 ", %s",
+                  s.calls, s.rows, s.totalTime / 1000, s.totalTime / s.calls, s.maxTime,
+                  ( NULL != s.maxFile ? s.maxFile : "unknown" ), s.maxLine, s.waitTime, histogram.c_str() );
+
+        const std::string& fingerprint = order[ i ].second;
+        sLog.Log( "Query Stats", "%s: %s", fingerprint.c_str(), line );
+        if( i < shownQueries )
+        {
+            reply += "\n";
+            if( fingerprint.size() <= shownLength )
+                reply += fingerprint;
+            else
+                reply += fingerprint.substr( 0, shownLength ) + "...";
+            reply += ": ";
+            reply += line;
+        }
+    }
+
+    return new PyString( reply );
+}
+
+PyResult Command_tickprofile( Client* who, CommandDB* db, PyServiceMgr* services, const Seperator& args )
+{
+    // number of ticks dumped if not given
+    size_t count = 5;
+
+    if( args.argCount() == 2 && args.arg( 1 ) == "reset" )
+    {
+        sTickProfiler.Reset();
+        return new PyString( "Tick profile reset." );
+    }
+    else if( args.argCount() == 2 && args.isNumber( 1 ) )
+        count = atoi( args.arg( 1 ).c_str() );
+    else if( args.argCount() != 1 )
+        throw PyException( MakeCustomError( "Correct Usage: /tickprofile [count|reset]" ) );
+
+    if( !sTickProfiler.IsEnabled() )
+        throw PyException( MakeCustomError( "The tick profiler is disabled, enable loop.tickProfiler in the config." ) );
+
+    std::string summary;
+    if( 0 == sTickProfiler.Dump( count, summary ) )
+        return new PyString( "No ticks recorded yet." );
+
+    return new PyString( "Slowest ticks (zones written to the log):\n" + summary );
+}
+
+PyResult Command_calltrace( Client* who, CommandDB* db, PyServiceMgr* services, const Seperator& args )
+{
+    // number of traces dumped if not given
+    size_t count = 10;
+
+    if( args.argCount() == 2 && args.arg( 1 ) == "reset" )
+    {
+        sCallTracer.Reset();
+        return new PyString( "Call traces reset." );
+    }
+    else if( args.argCount() == 3 && args.arg( 1 ) == "rate" && args.isNumber( 2 ) )
+    {
+        const uint32 rate = atoi( args.arg( 2 ).c_str() );
+        sCallTracer.SetRate( rate );
+
+        if( 0 == rate )
+            return new PyString( "Call tracing stopped." );
+
+        char reply[64];
+        snprintf( reply, sizeof( reply ), "Tracing every %u. call.", rate );
+        return new PyString( reply );
+    }
+    else if( args.argCount() == 2 && args.isNumber( 1 ) )
+        count = atoi( args.arg( 1 ).c_str() );
+    else if( args.argCount() != 1 )
+        throw PyException( MakeCustomError( "Correct Usage: /calltrace [count|reset|rate n]" ) );
+
+    std::string summary;
+    if( 0 == sCallTracer.Dump( count, summary ) )
+    {
+        if( !sCallTracer.IsEnabled() )
+            throw PyException( MakeCustomError( "No calls are traced, set loop.callTraceRate in the config or use /calltrace rate n." ) );
+
+        return new PyString( "No calls traced yet." );
+    }
+
+    return new PyString( "Latest traced calls (also written to the log):\n" + summary );
+}
+
+PyResult Command_capture( Client* who, CommandDB* db, PyServiceMgr* services, const Seperator& args )
+{
+    if( ( args.argCount() != 2 && args.argCount() != 3 ) || ( args.argCount() == 3 && !args.isNumber( 2 ) ) )
+        throw PyException( MakeCustomError( "Correct Usage: /capture (ON,OFF) [characterID]" ) );
+
+    Client* target = who;
+    if( args.argCount() == 3 )
+    {
+        target = services->entity_list.FindCharacter( atoi( args.arg( 2 ).c_str() ) );
+        if( NULL == target )
+            throw PyException( MakeCustomError( "Character %s is not online", args.arg( 2 ).c_str() ) );
+    }
+
+    std::string state = args.arg( 1 );
+    std::transform( state.begin(), state.end(), state.begin(), ::toupper );
+    if( state == "OFF" )
+    {
+        if( !target->IsCapturing() )
+            return new PyString( "The session is not being captured." );
+
+        target->StopCapture();
+        return new PyString( "Capture stopped." );
+    }
+    else if( state != "ON" )
+        throw PyException( MakeCustomError( "Correct Usage: /capture (ON,OFF) [characterID]" ) );
+
+    if( target->IsCapturing() )
+        return new PyString( "The session is being captured already." );
+
+    const std::string filename = target->StartPacketCapture();
+    if( filename.empty() )
+        throw PyException( MakeCustomError( "Unable to create a capture in %s", sConfig.files.captureDir.c_str() ) );
+
+    // started mid-session, the replay misses the calls made so far
+    return new PyString( "Capturing into " + filename + "; sessions captured from their login on replay best (net.captureAccounts)." );
+}
+
+PyResult Command_trace( Client* who, CommandDB* db, PyServiceMgr* services, const Seperator& args )
+{
+    const std::string usage = "Correct Usage: /trace [session (characterID)|service (name)|sample (n)|rate (n)|dump|clear]";
+
+    if( args.argCount() == 3 && args.arg( 1 ) == "session" )
+    {
+        if( !args.isNumber( 2 ) )
+            throw PyException( MakeCustomError( "Argument 2 must be a characterID." ) );
+
+        Client* target = services->entity_list.FindCharacter( atoi( args.arg( 2 ).c_str() ) );
+        if( NULL == target )
+            throw PyException( MakeCustomError( "Character %s is not online", args.arg( 2 ).c_str() ) );
+
+        if( sPacketTrace.ToggleAccount( target->GetAccountID() ) )
+            return new PyString( std::string( "Tracing the session of " ) + target->GetName() + "." );
+        return new PyString( std::string( "Not tracing the session of " ) + target->GetName() + " anymore." );
+    }
+    else if( args.argCount() == 3 && args.arg( 1 ) == "service" )
+    {
+        if( sPacketTrace.ToggleService( args.arg( 2 ) ) )
+            return new PyString( "Tracing service " + args.arg( 2 ) + "." );
+        return new PyString( "Not tracing service " + args.arg( 2 ) + " anymore." );
+    }
+    else if( args.argCount() == 3 && ( args.arg( 1 ) == "sample" || args.arg( 1 ) == "rate" ) )
+    {
+        if( !args.isNumber( 2 ) )
+            throw PyException( MakeCustomError( "Argument 2 must be a number." ) );
+
+        if( args.arg( 1 ) == "sample" )
+            sPacketTrace.SetSampling( atoi( args.arg( 2 ).c_str() ) );
+        else
+            sPacketTrace.SetRateLimit( atoi( args.arg( 2 ).c_str() ) );
+    }
+    else if( args.argCount() == 2 && args.arg( 1 ) == "dump" )
+    {
+        std::vector<std::string> files;
+        const size_t written = sPacketTrace.Dump( files );
+        if( 0 == written )
+            return new PyString( "Nothing has been traced." );
+
+        std::string reply;
+        sprintf( reply, "Dumped %lu packets; render them by eve-tool's \"unmarshal @file\":", (unsigned long)written );
+        for( size_t i = 0; i < files.size(); ++i )
+            reply += "\n" + files[ i ];
+        return new PyString( reply );
+    }
+    else if( args.argCount() == 2 && args.arg( 1 ) == "clear" )
+    {
+        sPacketTrace.Clear();
+        return new PyString( "Trace and its filters cleared." );
+    }
+    else if( args.argCount() != 1 )
+        throw PyException( MakeCustomError( "%s", usage.c_str() ) );
+
+    std::string accounts;
+    std::set<uint32>::const_iterator curAccount, endAccount;
+    curAccount = sPacketTrace.accounts().begin();
+    endAccount = sPacketTrace.accounts().end();
+    for(; curAccount != endAccount; curAccount++)
+    {
+        char account[16];
+        snprintf( account, sizeof( account ), "%s%u", ( accounts.empty() ? "" : ", " ), *curAccount );
+        accounts += account;
+    }
+
+    std::string traced;
+    std::set<std::string>::const_iterator curService, endService;
+    curService = sPacketTrace.services().begin();
+    endService = sPacketTrace.services().end();
+    for(; curService != endService; curService++)
+        traced += ( traced.empty() ? "" : ", " ) + *curService;
+
+    const PacketTrace::Stats& s = sPacketTrace.stats();
+
+    std::string reply;
+    sprintf( reply, "CLIENT__IN_ALL %s, DESTINY__UPDATES %s; accounts: %s; services: %s; 1 in %u packets, at most %u/s.\n"
+                    "%u traced, %u sampled out, %u throttled, %u oversized, %u overwritten; %lu held.",
+             ( is_log_enabled( CLIENT__IN_ALL ) ? "on" : "off" ), ( is_log_enabled( DESTINY__UPDATES ) ? "on" : "off" ),
+             ( accounts.empty() ? "all" : accounts.c_str() ), ( traced.empty() ? "all" : traced.c_str() ),
+             sPacketTrace.sampling(), sPacketTrace.rateLimit(),
+             s.traced, s.sampledOut, s.throttled, s.oversized, s.overwritten, (unsigned long)sPacketTrace.size() );
+    return new PyString( reply );
+}
+
+/* Formats traffic totals as "packets, KiB, raw KiB, raw/sent". */
+static std::string FormatTraffic( const EVETrafficStats::Totals& t )
+{
+    char line[128];
+    snprintf( line, sizeof( line ), "%" PRIu64 ", %" PRIu64 ", %" PRIu64 ", %.2f",
+              t.packets, t.bytes / 1024, t.rawBytes / 1024, ( 0 < t.bytes ? (double)t.rawBytes / t.bytes : 1.0 ) );
+    return line;
+}
+
+PyResult Command_netstats( Client* who, CommandDB* db, PyServiceMgr* services, const Seperator& args )
+{
+    // number of kinds and clients shown to the client; the log gets all of them
+    const size_t shownKinds = 15;
+    const size_t shownClients = 10;
+
+    if( args.argCount() == 2 && args.isNumber( 1 ) )
+    {
+        Client* target = services->entity_list.FindCharacter( atoi( args.arg( 1 ).c_str() ) );
+        if( NULL == target )
+            throw PyException( MakeCustomError( "Character %s is not online", args.arg( 1 ).c_str() ) );
+
+        return new PyString( std::string( "Traffic of " ) + target->GetName() + ": packets, KiB, raw KiB, raw/sent"
+                             + "\nin: " + FormatTraffic( target->GetTraffic( EVETrafficStats::TRAFFIC_IN ) )
+                             + "\nout: " + FormatTraffic( target->GetTraffic( EVETrafficStats::TRAFFIC_OUT ) ) );
+    }
+    else if( args.argCount() != 1 )
+        throw PyException( MakeCustomError( "Correct Usage: /netstats [characterID]" ) );
+
+    std::string reply = "Packet kinds by bytes: packets, KiB, raw KiB, raw/sent";
+    sLog.Log( "Net Stats", "%s", reply.c_str() );
+
+    // outbound first, it is where the bandwidth goes
+    static const EVETrafficStats::Direction directions[] = { EVETrafficStats::TRAFFIC_OUT, EVETrafficStats::TRAFFIC_IN };
+    static const char* const directionNames[] = { "out", "in" };
+    for( size_t dir = 0; dir < 2; ++dir )
+    {
+        std::map<std::string, EVETrafficStats::Totals> kinds;
+        sTrafficStats.GetKinds( directions[ dir ], kinds );
+
+        // busiest first
+        std::vector< std::pair<uint64, std::string> > order;
+        std::map<std::string, EVETrafficStats::Totals>::const_iterator cur, end;
+        cur = kinds.begin();
+        end = kinds.end();
+        for(; cur != end; cur++)
+            order.push_back( std::make_pair( cur->second.bytes, cur->first ) );
+        std::sort( order.rbegin(), order.rend() );
+
+        for( size_t i = 0; i < order.size(); ++i )
+        {
+            const std::string line = std::string( directionNames[ dir ] ) + " " + order[ i ].second + ": " + FormatTraffic( kinds[ order[ i ].second ] );
+
+            sLog.Log( "Net Stats", "%s", line.c_str() );
+            if( i < shownKinds )
+                reply += "\n" + line;
+        }
+    }
+
+    std::vector<Client*> clients;
+    services->entity_list.GetClients( clients );
+
+    // busiest first
+    std::vector< std::pair<uint64, Client*> > order;
+    for( size_t i = 0; i < clients.size(); ++i )
+        order.push_back( std::make_pair( clients[ i ]->GetTraffic( EVETrafficStats::TRAFFIC_OUT ).bytes, clients[ i ] ) );
+    std::sort( order.rbegin(), order.rend() );
+
+    reply += "\nClients by bytes sent: packets, KiB, raw KiB, raw/sent";
+    for( size_t i = 0; i < order.size() && i < shownClients; ++i )
+    {
+        Client* c = order[ i ].second;
+        reply += std::string( "\n" ) + c->GetName() + ": " + FormatTraffic( c->GetTraffic( EVETrafficStats::TRAFFIC_OUT ) );
+    }
+
+    return new PyString( reply );
+}
+
+static std::string FormatMemoryUsage( Client* c )
+{
+    const Client::MemoryUsage usage = c->GetMemoryUsage();
+
+    char line[256];
+    snprintf( line, sizeof( line ), "%s: %lu KiB in %lu buffers, %lu KiB held, %lu bound, %lu items, %u s since last call%s",
+              c->GetName(), (unsigned long)( usage.sendQueueBytes / 1024 ), (unsigned long)usage.sendQueueBuffers,
+              (unsigned long)( usage.heldDestinyBytes / 1024 ), (unsigned long)usage.boundObjects, (unsigned long)usage.itemRefs,
+              usage.inactiveTime, ( usage.idle ? " (idle)" : "" ) );
+    return line;
+}
+
+PyResult Command_sessions( Client* who, CommandDB* db, PyServiceMgr* services, const Seperator& args )
+{
+    // number of sessions shown to the client; the log gets all of them
+    const size_t shownClients = 10;
+
+    if( args.argCount() == 2 && args.isNumber( 1 ) )
+    {
+        Client* target = services->entity_list.FindCharacter( atoi( args.arg( 1 ).c_str() ) );
+        if( NULL == target )
+            throw PyException( MakeCustomError( "Character %s is not online", args.arg( 1 ).c_str() ) );
+
+        return new PyString( FormatMemoryUsage( target ) );
+    }
+    else if( args.argCount() != 1 )
+        throw PyException( MakeCustomError( "Correct Usage: /sessions [characterID]" ) );
+
+    std::vector<Client*> clients;
+    services->entity_list.GetClients( clients );
+
+    // most queued first, it is what a slow reader piles up
+    std::vector< std::pair<uint64, Client*> > order;
+    for( size_t i = 0; i < clients.size(); ++i )
+    {
+        const Client::MemoryUsage usage = clients[ i ]->GetMemoryUsage();
+        order.push_back( std::make_pair( (uint64)usage.sendQueueBytes + usage.heldDestinyBytes, clients[ i ] ) );
+    }
+    std::sort( order.rbegin(), order.rend() );
+
+    char header[128];
+    snprintf( header, sizeof( header ), "%lu sessions by queued bytes:", (unsigned long)order.size() );
+
+    std::string reply = header;
+    sLog.Log( "Sessions", "%s", reply.c_str() );
+    for( size_t i = 0; i < order.size(); ++i )
+    {
+        const std::string line = FormatMemoryUsage( order[ i ].second );
+
+        sLog.Log( "Sessions", "%s", line.c_str() );
+        if( i < shownClients )
+            reply += "\n" + line;
+    }
+
+    return new PyString( reply );
+}
+
+PyResult Command_fitsim( Client* who, CommandDB* db, PyServiceMgr* services, const Seperator& args )
+{
+    if( args.argCount() < 2 )
+        throw PyException( MakeCustomError( "Correct Usage: /fitsim (shipTypeID) [moduleTypeID ...]" ) );
+
+    FittingSpec spec;
+    for( uint32 i = 1; i < args.argCount(); ++i )
+    {
+        if( !args.isNumber( i ) )
+            throw PyException( MakeCustomError( "Argument %u should be a typeID", i ) );
+
+        const uint32 typeID = atoi( args.arg( i ).c_str() );
+        if( i == 1 )
+            spec.shipTypeID = typeID;
+        else
+        {
+            FittingSpec::Module module;
+            module.typeID = typeID;
+            spec.modules.push_back( module );
+        }
+    }
+
+    std::vector<InventoryItemRef> skills;
+    who->GetChar()->GetSkillsList( skills );
+
+    std::vector<InventoryItemRef>::const_iterator cur, end;
+    cur = skills.begin();
+    end = skills.end();
+    for(; cur != end; cur++)
+        spec.skills[ (*cur)->typeID() ] = (*cur)->GetAttribute( AttrSkillLevel ).get_int();
+
+    const uint32 hits = sFittingEvaluator.stats().hits;
+    FittingSnapshotRef snapshot = sFittingEvaluator.Evaluate( spec );
+    if( !snapshot )
+        throw PyException( MakeCustomError( "Type %u has no attributes", spec.shipTypeID ) );
+
+    // the attributes the fitting window shows first
+    static const uint32 shown[] =
+    {
+        AttrCpuOutput, AttrCpuLoad, AttrPowerOutput, AttrPowerLoad,
+        AttrCapacitorCapacity, AttrRechargeRate, AttrShieldCapacity, AttrShieldRechargeRate,
+        AttrArmorHP, AttrHp, AttrMaxVelocity, AttrAgility, AttrMaxTargetRange, AttrSignatureRadius
+    };
+
+    std::string reply = ( sFittingEvaluator.stats().hits != hits ? "Fitting (cached):" : "Fitting (computed):" );
+    for( size_t i = 0; i < sizeof( shown ) / sizeof( shown[ 0 ] ); ++i )
+    {
+        double value;
+        if( !snapshot->GetShipAttribute( shown[ i ], value ) )
+            continue;
+
+        char line[64];
+        snprintf( line, sizeof( line ), "\n%u: %.2f", shown[ i ], value );
+        reply += line;
+    }
+
+    return new PyString( reply );
+}
+
+template< typename T >
+static std::string FormatPoolStats( const char* name, const T& s )
+{
+    char line[256];
+    snprintf( line, sizeof( line ), "%s: %" PRIu64 ", %.1f%%, %" PRIu64 ", %.1f%%, %" PRIu64,
+              name, s.allocations, ( 0 < s.allocations ? 100.0 * s.poolHits / s.allocations : 0.0 ),
+              s.frees, ( 0 < s.frees ? 100.0 * s.poolReturns / s.frees : 0.0 ), s.allocations - s.poolHits );
+
+    return line;
+}
+
+template< typename T >
+static std::string FormatObjectPoolStats( const char* name )
+{
+    const typename ObjectPool< T >::Stats s = ObjectPool< T >::GetStats();
+
+    char cached[32];
+    snprintf( cached, sizeof( cached ), ", %" PRIu64 " cached", s.cached );
+
+    return FormatPoolStats( name, s ) + cached;
+}
+
+PyResult Command_poolstats( Client* who, CommandDB* db, PyServiceMgr* services, const Seperator& args )
+{
+    if( args.argCount() == 2 && args.arg( 1 ) == "reset" )
+    {
+        SizeClassPool::ResetStats();
+        ObjectPool< PyPacket >::ResetStats();
+        ObjectPool< EVENotificationStream >::ResetStats();
+        ObjectPool< Damage >::ResetStats();
+        ObjectPool< NPC >::ResetStats();
+        ObjectPool< ContainerEntity >::ResetStats();
+        ObjectPool< StructureEntity >::ResetStats();
+
+        return new PyString( "Pool statistics reset." );
+    }
+    else if( args.argCount() != 1 )
+        throw PyException( MakeCustomError( "Correct Usage: /poolstats [reset]" ) );
+
+    // the statistics are per thread; this is the main loop's
+    std::string reply = "Main thread pools: allocations, hit rate, frees, kept rate, heap allocations";
+    reply += "\n" + FormatPoolStats( "SizeClassPool", SizeClassPool::GetStats() );
+    reply += "\n" + FormatObjectPoolStats< PyPacket >( "PyPacket" );
+    reply += "\n" + FormatObjectPoolStats< EVENotificationStream >( "EVENotificationStream" );
+    reply += "\n" + FormatObjectPoolStats< Damage >( "Damage" );
+    reply += "\n" + FormatObjectPoolStats< NPC >( "NPC" );
+    reply += "\n" + FormatObjectPoolStats< ContainerEntity >( "ContainerEntity" );
+    reply += "\n" + FormatObjectPoolStats< StructureEntity >( "StructureEntity" );
+
+    sLog.Log( "Pool Stats", "%s", reply.c_str() );
+    return new PyString( reply );
+}
+
+PyResult Command_memstats( Client* who, CommandDB* db, PyServiceMgr* services, const Seperator& args )
+{
+    // number of stacks shown to the client, and frames of each; the log gets all of them
+    const size_t shownStacks = 5;
+    const size_t shownFrames = 4;
+
+    if( args.argCount() == 3 && args.arg( 1 ) == "sample" && args.isNumber( 2 ) )
+    {
+        MemoryTag::SetSampleRate( atoi( args.arg( 2 ).c_str() ) );
+        if( 0 == MemoryTag::GetSampleRate() )
+            MemoryTag::ClearSamples();
+
+        return new PyString( "Memory sample rate set to " + args.arg( 2 ) + "." );
+    }
+    else if( ( args.argCount() == 2 || args.argCount() == 3 ) && args.arg( 1 ) == "dump" )
+    {
+        if( args.argCount() == 3 && !args.isNumber( 2 ) )
+            throw PyException( MakeCustomError( "Argument 2 should be a count" ) );
+        const size_t count = ( args.argCount() == 3 ? atoi( args.arg( 2 ).c_str() ) : shownStacks );
+
+        std::vector< MemoryTag::Sample > samples;
+        MemoryTag::DumpSamples( samples );
+
+        char header[128];
+        snprintf( header, sizeof( header ), "%lu call stacks of live sampled allocations (rate %u), biggest first:",
+                  (unsigned long)samples.size(), MemoryTag::GetSampleRate() );
+
+        std::string reply = header;
+        sLog.Log( "Memory Stats", "%s", reply.c_str() );
+        for( size_t i = 0; i < samples.size(); ++i )
+        {
+            const MemoryTag::Sample& sample = samples[ i ];
+
+            char line[256];
+            snprintf( line, sizeof( line ), "%s: %lu allocations, %lu bytes", sample.tag->name(), (unsigned long)sample.count, (unsigned long)sample.bytes );
+
+            sLog.Log( "Memory Stats", "%s", line );
+            if( i < count )
+                reply += std::string( "\n" ) + line;
+
+            for( size_t j = 0; j < sample.frames.size(); ++j )
+            {
+                sLog.Log( "Memory Stats", "    %s", sample.frames[ j ].c_str() );
+                if( i < count && j < shownFrames )
+                    reply += "\n    " + sample.frames[ j ];
+            }
+        }
+
+        return new PyString( reply );
+    }
+    else if( args.argCount() == 2 && args.arg( 1 ) == "clear" )
+    {
+        MemoryTag::ClearSamples();
+
+        return new PyString( "Memory samples cleared." );
+    }
+    else if( args.argCount() != 1 )
+        throw PyException( MakeCustomError( "Correct Usage: /memstats [sample (n)|dump [count]|clear]" ) );
+
+    // biggest first
+    std::vector< std::pair< int64, const MemoryTag* > > order;
+    for( const MemoryTag* tag = MemoryTag::first(); NULL != tag; tag = tag->next() )
+        order.push_back( std::make_pair( tag->GetStats().liveBytes, tag ) );
+    std::sort( order.rbegin(), order.rend() );
+
+    std::string reply = "Memory of the subsystems: live KiB, live objects, allocations";
+    for( size_t i = 0; i < order.size(); ++i )
+    {
+        const MemoryTag::Stats stats = order[ i ].second->GetStats();
+
+        char line[128];
+        snprintf( line, sizeof( line ), "%s: %" PRId64 ", %" PRId64 ", %" PRIu64,
+                  order[ i ].second->name(), stats.liveBytes / 1024, stats.liveObjects, stats.allocations );
+        reply += std::string( "\n" ) + line;
+    }
+
+    sLog.Log( "Memory Stats", "%s", reply.c_str() );
+    return new PyString( reply );
+}
+
+PyResult Command_tutorials( Client* who, CommandDB* db, PyServiceMgr* services, const Seperator& args )
+{
+    if( args.argCount() != 2 || args.arg( 1 ) != "reload" )
+        throw PyException( MakeCustomError( "Correct Usage: /tutorials reload" ) );
+
+    if( !sTutorialStore.Reload( *services->cache_service ) )
+        throw PyException( MakeCustomError( "Failed to load the tutorials; the previous ones are still served." ) );
+
+    char reply[64];
+    snprintf( reply, sizeof( reply ), "Reloaded %lu tutorials.", (unsigned long)sTutorialStore.size() );
+
+    sLog.Log( "GMCommands", "%s", reply );
+    return new PyString( reply );
+}
+
+PyResult Command_dungeon( Client* who, CommandDB* db, PyServiceMgr* services, const Seperator& args )
+{
+    if( args.argCount() == 2 && args.arg( 1 ) == "list" )
+    {
+        std::string reply = "Dungeons:";
+
+        std::map< uint32, DungeonBlueprint >::const_iterator cur, end;
+        cur = sDungeonManager.GetBlueprints().begin();
+        end = sDungeonManager.GetBlueprints().end();
+        for(; cur != end; cur++ )
+        {
+            char line[160];
+            snprintf( line, sizeof( line ), "\n%u: %s (%u objects)",
+                      cur->first, cur->second.dungeonName.c_str(), (uint32)cur->second.objects.size() );
+            reply += line;
+        }
+
+        return new PyString( reply );
+    }
+    else if( args.argCount() == 3 && args.arg( 1 ) == "spawn" && args.isNumber( 2 ) )
+    {
+        if( !who->IsInSpace() )
+            throw PyException( MakeCustomError( "You must be in space to spawn dungeons." ) );
+
+        DungeonInstance* instance = sDungeonManager.Instantiate( atoi( args.arg( 2 ).c_str() ), *who->System(), *services );
+        if( NULL == instance )
+            throw PyException( MakeCustomError( "Unknown dungeon %s.", args.arg( 2 ).c_str() ) );
+
+        const GPoint& origin = instance->GetOrigin();
+        char reply[160];
+        snprintf( reply, sizeof( reply ), "Spawned instance %u with %u entities at (%.0f, %.0f, %.0f).",
+                  instance->GetID(), (uint32)instance->size(), origin.x, origin.y, origin.z );
+
+        return new PyString( reply );
+    }
+    else if( args.argCount() == 3 && args.arg( 1 ) == "clear" && args.isNumber( 2 ) )
+    {
+        if( !sDungeonManager.Teardown( atoi( args.arg( 2 ).c_str() ) ) )
+            throw PyException( MakeCustomError( "Unknown dungeon instance %s.", args.arg( 2 ).c_str() ) );
+
+        return new PyString( "Dungeon instance torn down." );
+    }
+
+    throw PyException( MakeCustomError( "Correct Usage: /dungeon list | spawn (dungeonID) | clear (instanceID)" ) );
+}
+
+PyResult Command_starbase( Client* who, CommandDB* db, PyServiceMgr* services, const Seperator& args )
+{
+    if( args.argCount() == 2 && args.arg( 1 ) == "list" )
+    {
+        static const char* const states[] = { "unanchored", "anchored", "onlining", "reinforced", "online" };
+        const uint64 now = Win32TimeNow();
+
+        std::string reply = "Control towers:";
+
+        std::map< uint32, StarbaseSimulator::Tower >::const_iterator cur, end;
+        cur = sStarbaseSimulator.GetTowers().begin();
+        end = sStarbaseSimulator.GetTowers().end();
+        for(; cur != end; cur++ )
+        {
+            const StarbaseSimulator::Tower& tower = cur->second;
+
+            char line[160];
+            snprintf( line, sizeof( line ), "\n%u (type %u): %s", tower.towerID, tower.typeID,
+                      ( tower.state < sizeof( states ) / sizeof( states[0] ) ? states[ tower.state ] : "unknown" ) );
+            reply += line;
+
+            if( 0 != tower.cycleStart )
+            {
+                snprintf( line, sizeof( line ), ", cycle started %u min ago",
+                          (uint32)( ( now - tower.cycleStart ) / Win32Time_Minute ) );
+                reply += line;
+            }
+        }
+
+        return new PyString( reply );
+    }
+    else if( args.argCount() == 3 && ( args.arg( 1 ) == "online" || args.arg( 1 ) == "offline" ) && args.isNumber( 2 ) )
+    {
+        const StarbaseState state = ( args.arg( 1 ) == "online" ? starbaseStateOnline : starbaseStateAnchored );
+        if( !sStarbaseSimulator.SetState( atoi( args.arg( 2 ).c_str() ), state ) )
+            throw PyException( MakeCustomError( "Unable to change the state of control tower %s.", args.arg( 2 ).c_str() ) );
+
+        return new PyString( "Control tower state changed." );
+    }
+    else if( args.argCount() == 4 && args.arg( 1 ) == "reinforce" && args.isNumber( 2 ) && args.isNumber( 3 ) )
+    {
+        const uint64 until = Win32TimeNow() + atoi( args.arg( 3 ).c_str() ) * Win32Time_Hour;
+        if( !sStarbaseSimulator.Reinforce( atoi( args.arg( 2 ).c_str() ), until ) )
+            throw PyException( MakeCustomError( "Unable to reinforce control tower %s; is it online?", args.arg( 2 ).c_str() ) );
+
+        return new PyString( "Control tower reinforced." );
+    }
+    else if( args.argCount() == 2 && args.arg( 1 ) == "pass" )
+    {
+        sStarbaseSimulator.RunPass();
+
+        return new PyString( "Starbase pass done." );
+    }
+
+    throw PyException( MakeCustomError( "Correct Usage: /starbase list | online (towerID) | offline (towerID) | reinforce (towerID) (hours) | pass" ) );
+}
+
+PyResult Command_colony( Client* who, CommandDB* db, PyServiceMgr* services, const Seperator& args )
+{
+    if( args.argCount() < 3 || !args.isNumber( 1 ) )
+        throw PyException( MakeCustomError( "Correct Usage: /colony (planetID) show | extractor (resourceTypeID) (hours) | factory (schematicID)" ) );
+
+    const uint32 planetID = atoi( args.arg( 1 ).c_str() );
+
+    if( args.argCount() == 3 && args.arg( 2 ) == "show" )
+    {
+        const PlanetSimulation::Colony* colony = sPlanetSimulation.GetColony( planetID, who->GetCharacterID() );
+        if( NULL == colony )
+            throw PyException( MakeCustomError( "Unable to load your colony on planet %u.", planetID ) );
+
+        char line[160];
+        snprintf( line, sizeof( line ), "Colony on planet %u: %u pins", planetID, (uint32)colony->pins.size() );
+        std::string reply = line;
+
+        std::vector< PlanetSimulation::Pin >::const_iterator cur, end;
+        cur = colony->pins.begin();
+        end = colony->pins.end();
+        for(; cur != end; cur++ )
+        {
+            if( PlanetSimulation::PIN_EXTRACTOR == cur->kind )
+                snprintf( line, sizeof( line ), "\n%u: extractor of %u, %u per cycle of %u s", cur->pinID, cur->resourceTypeID, cur->qtyPerCycle, cur->cycleTime );
+            else
+                snprintf( line, sizeof( line ), "\n%u: factory of schematic %u, cycle of %u s", cur->pinID, cur->schematicID, cur->cycleTime );
+            reply += line;
+        }
+
+        std::map< uint32, uint32 >::const_iterator curc, endc;
+        curc = colony->contents.begin();
+        endc = colony->contents.end();
+        for(; curc != endc; curc++ )
+        {
+            if( 0 == curc->second )
+                continue;
+
+            snprintf( line, sizeof( line ), "\n%u x %u", curc->second, curc->first );
+            reply += line;
+        }
+
+        return new PyString( reply );
+    }
+    else if( args.argCount() == 5 && args.arg( 2 ) == "extractor" && args.isNumber( 3 ) && args.isNumber( 4 ) )
+    {
+        // somewhere on the planet, with hourly cycles
+        const uint32 pinID = sPlanetSimulation.InstallExtractor( planetID, who->GetCharacterID(), atoi( args.arg( 3 ).c_str() ),
+                                                                 MakeRandomFloat( 0.0, M_PI ), MakeRandomFloat( 0.0, 2 * M_PI ),
+                                                                 3600, atoi( args.arg( 4 ).c_str() ) * 3600 );
+        if( 0 == pinID )
+            throw PyException( MakeCustomError( "Unable to install an extractor of %s on planet %u.", args.arg( 3 ).c_str(), planetID ) );
+
+        char reply[64];
+        snprintf( reply, sizeof( reply ), "Installed extractor %u.", pinID );
+        return new PyString( reply );
+    }
+    else if( args.argCount() == 4 && args.arg( 2 ) == "factory" && args.isNumber( 3 ) )
+    {
+        const uint32 pinID = sPlanetSimulation.InstallFactory( planetID, who->GetCharacterID(), atoi( args.arg( 3 ).c_str() ) );
+        if( 0 == pinID )
+            throw PyException( MakeCustomError( "Unable to install a factory of schematic %s on planet %u.", args.arg( 3 ).c_str(), planetID ) );
+
+        char reply[64];
+        snprintf( reply, sizeof( reply ), "Installed factory %u.", pinID );
+        return new PyString( reply );
+    }
+
+    throw PyException( MakeCustomError( "Correct Usage: /colony (planetID) show | extractor (resourceTypeID) (hours) | factory (schematicID)" ) );
+}
+
+PyResult Command_sov( Client* who, CommandDB* db, PyServiceMgr* services, const Seperator& args )
+{
+    const uint32 solarSystemID = who->GetSystemID();
+
+    if( args.argCount() == 2 && args.arg( 1 ) == "show" )
+    {
+        const SystemSovereignty* system = sSovereigntyTable.Get( solarSystemID );
+        if( system == NULL )
+            throw PyException( MakeCustomError( "Unknown solar system %u.", solarSystemID ) );
+
+        char reply[256];
+        snprintf( reply, sizeof( reply ),
+                  "Solar system %u: faction %u, alliance %u (corporation %u), %s, occupied by %u; table version %" PRIu64 ".",
+                  system->solarSystemID, system->factionID, system->allianceID, system->corporationID,
+                  ( system->contested ? "contested" : "not contested" ), system->occupierID, sSovereigntyTable.GetVersion() );
+        return new PyString( reply );
+    }
+    else if( args.argCount() == 4 && args.arg( 1 ) == "claim" && args.isNumber( 2 ) && args.isNumber( 3 ) )
+    {
+        if( !sSovereigntyTable.Claim( solarSystemID, atoi( args.arg( 2 ).c_str() ), atoi( args.arg( 3 ).c_str() ), 0 ) )
+            throw PyException( MakeCustomError( "Unable to change the sovereignty of solar system %u.", solarSystemID ) );
+
+        return new PyString( "Sovereignty changed." );
+    }
+    else if( args.argCount() == 3 && args.arg( 1 ) == "contest" && args.isNumber( 2 ) )
+    {
+        if( !sSovereigntyTable.SetContested( solarSystemID, atoi( args.arg( 2 ).c_str() ) != 0 ) )
+            throw PyException( MakeCustomError( "Unable to contest solar system %u.", solarSystemID ) );
+
+        return new PyString( "Contested state changed." );
+    }
+    else if( args.argCount() == 3 && args.arg( 1 ) == "occupy" && args.isNumber( 2 ) )
+    {
+        if( !sSovereigntyTable.Occupy( solarSystemID, atoi( args.arg( 2 ).c_str() ) ) )
+            throw PyException( MakeCustomError( "Unable to change the occupier of solar system %u.", solarSystemID ) );
+
+        return new PyString( "Occupier changed." );
+    }
+
+    throw PyException( MakeCustomError( "Correct Usage: /sov show | claim (allianceID) (corporationID) | contest (0|1) | occupy (factionID)" ) );
+}
+
+/* Formats the tick times of a system, compared to its baseline if there is one. */
+static std::string FormatTickTimes( const StressTest::TickTimes& now, const StressTest::TickTimes* baseline )
+{
+    char line[256];
+    if( NULL == baseline )
+        snprintf( line, sizeof( line ), "tick %.0f us (max %u us), destiny %.0f us, AI %.0f us over %u ticks",
+                  now.tickTime, now.maxTickTime, now.destinyTime, now.aiTime, now.ticks );
+    else
+        snprintf( line, sizeof( line ), "tick %.0f us (%+.0f, max %u us), destiny %.0f us (%+.0f), AI %.0f us (%+.0f) over %u ticks",
+                  now.tickTime, now.tickTime - baseline->tickTime, now.maxTickTime,
+                  now.destinyTime, now.destinyTime - baseline->destinyTime,
+                  now.aiTime, now.aiTime - baseline->aiTime, now.ticks );
+    return line;
+}
+
+PyResult Command_stress( Client* who, CommandDB* db, PyServiceMgr* services, const Seperator& args )
+{
+    // the most objects spawned or created by one command
+    const uint32 maxCount = 5000;
+
+    const std::string usage = "Correct Usage: /stress npcs|cans (typeID) (count) [grid|ring] [spacing] | pilots (typeID) (count) [distance] | items (typeID) (count) [quantity] | ticks | clear";
+    if( args.argCount() < 2 )
+        throw PyException( MakeCustomError( usage.c_str() ) );
+
+    const std::string& mode = args.arg( 1 );
+    SystemManager* system = who->System();
+
+    if( args.argCount() == 2 && mode == "ticks" )
+    {
+        if( NULL == system )
+            throw PyException( MakeCustomError( "You are not in a solar system." ) );
+
+        std::string reply = "Solar system " + system->GetName() + ": "
+            + FormatTickTimes( StressTest::GetTickTimes( *system ), sStressTest.GetBaseline( system->GetID() ) );
+
+        char line[64];
+        snprintf( line, sizeof( line ), "; %u entities spawned.", (uint32)sStressTest.GetEntityCount( system->GetID() ) );
+        return new PyString( reply + line );
+    }
+    else if( args.argCount() == 2 && mode == "clear" )
+    {
+        if( NULL == system )
+            throw PyException( MakeCustomError( "You are not in a solar system." ) );
+
+        char reply[64];
+        snprintf( reply, sizeof( reply ), "Tore down %u stress spawns.", (uint32)sStressTest.TeardownSystem( system->GetID() ) );
+        return new PyString( reply );
+    }
+
+    if( args.argCount() < 4 || !args.isNumber( 2 ) || !args.isNumber( 3 ) )
+        throw PyException( MakeCustomError( usage.c_str() ) );
+
+    const uint32 typeID = atoi( args.arg( 2 ).c_str() );
+    const uint32 count = atoi( args.arg( 3 ).c_str() );
+    if( 0 == count || maxCount < count )
+        throw PyException( MakeCustomError( "The count must be between 1 and %u.", maxCount ) );
+
+    const ItemType* type = services->item_factory.GetType( typeID );
+    if( NULL == type )
+        throw PyException( MakeCustomError( "Unknown type %u.", typeID ) );
+
+    if( mode == "items" )
+    {
+        if( 5 < args.argCount() || ( args.argCount() == 5 && !args.isNumber( 4 ) ) )
+            throw PyException( MakeCustomError( usage.c_str() ) );
+        const uint32 quantity = ( args.argCount() == 5 ? atoi( args.arg( 4 ).c_str() ) : 1 );
+
+        //the same places as /create.
+        uint32 locationID;
+        EVEItemFlags flag;
+        if( who->IsInSpace() )
+        {
+            locationID = who->GetShipID();
+            flag = flagCargoHold;
+        }
+        else
+        {
+            locationID = who->GetStationID();
+            flag = flagHangar;
+        }
+
+        const uint64 start = GetTimeUSeconds();
+
+        // one insert for all of them, then they move in as one batch
+        std::vector< ItemData > data( count, ItemData( typeID, who->GetCharacterID(), 0, flag, quantity ) );
+        std::vector< InventoryItemRef > items;
+        if( !services->item_factory.SpawnItems( data, items ) )
+            throw PyException( MakeCustomError( "Unable to create %u stacks of type %u; only materials, charges, commodities and alike are created in bulk.", count, typeID ) );
+
+        {
+            InventoryBatch::Scope batch;
+
+            std::vector< InventoryItemRef >::iterator cur, end;
+            cur = items.begin();
+            end = items.end();
+            for(; cur != end; cur++ )
+                (*cur)->Move( locationID, flag, true );
+        }
+
+        char reply[128];
+        snprintf( reply, sizeof( reply ), "Created %u stacks of %u in %.1f ms.",
+                  (uint32)items.size(), quantity, ( GetTimeUSeconds() - start ) / 1000.0 );
+        return new PyString( reply );
+    }
+
+    if( !who->IsInSpace() || NULL == system )
+        throw PyException( MakeCustomError( "You must be in space to spawn things." ) );
+
+    std::string reply;
+    if( mode == "npcs" || mode == "cans" )
+    {
+        if( 6 < args.argCount() || ( args.argCount() == 6 && !args.isNumber( 5 ) ) )
+            throw PyException( MakeCustomError( usage.c_str() ) );
+
+        uint8 kind;
+        if( mode == "npcs" )
+        {
+            if( EVEDB::invCategories::Entity != type->categoryID() )
+                throw PyException( MakeCustomError( "Type %u is not an NPC.", typeID ) );
+            kind = DungeonBlueprint::OBJECT_NPC_GROUP;
+        }
+        else
+        {
+            if( EVEDB::invGroups::Cargo_Container != type->groupID()
+                && EVEDB::invGroups::Secure_Cargo_Container != type->groupID()
+                && EVEDB::invGroups::Freight_Container != type->groupID()
+                && EVEDB::invGroups::Audit_Log_Secure_Container != type->groupID() )
+                throw PyException( MakeCustomError( "Type %u is not a container.", typeID ) );
+            kind = DungeonBlueprint::OBJECT_CONTAINER;
+        }
+
+        StressTest::Pattern pattern = StressTest::PATTERN_GRID;
+        if( 4 < args.argCount() )
+        {
+            if( args.arg( 4 ) == "ring" )
+                pattern = StressTest::PATTERN_RING;
+            else if( args.arg( 4 ) != "grid" )
+                throw PyException( MakeCustomError( usage.c_str() ) );
+        }
+        const double spacing = ( args.argCount() == 6 ? atof( args.arg( 5 ).c_str() ) : 1000.0 );
+
+        char line[128];
+        snprintf( line, sizeof( line ), "Spawned %u %s.", (uint32)sStressTest.Spawn(
+                  *system, *services, kind, typeID, count, pattern, spacing, who->GetPosition() ), mode.c_str() );
+        reply = line;
+    }
+    else if( mode == "pilots" )
+    {
+        // there are no connections to back fake clients, so the pilots are NPCs
+        // which keep flying around the caller, each sending its destiny updates
+        if( 5 < args.argCount() || ( args.argCount() == 5 && !args.isNumber( 4 ) ) )
+            throw PyException( MakeCustomError( usage.c_str() ) );
+        if( EVEDB::invCategories::Entity != type->categoryID() )
+            throw PyException( MakeCustomError( "Type %u is not an NPC.", typeID ) );
+        const double distance = ( args.argCount() == 5 ? atof( args.arg( 4 ).c_str() ) : 5000.0 );
+
+        std::vector< NPC* > npcs;
+        sStressTest.Spawn( *system, *services, DungeonBlueprint::OBJECT_NPC_GROUP, typeID, count,
+                           StressTest::PATTERN_RING, 2.0 * M_PI * distance / count, who->GetPosition(), &npcs );
+
+        for( size_t i = 0; i < npcs.size(); ++i )
+            // vary the distances a bit so they do not all fly the same circle
+            npcs[ i ]->Destiny()->Orbit( who, distance * ( 0.5 + (double)i / npcs.size() ) );
+
+        char line[128];
+        snprintf( line, sizeof( line ), "Spawned %u pilots orbiting you.", (uint32)npcs.size() );
+        reply = line;
+    }
+    else
+        throw PyException( MakeCustomError( usage.c_str() ) );
+
+    const StressTest::TickTimes* baseline = sStressTest.GetBaseline( system->GetID() );
+    if( NULL != baseline )
+        reply += " Baseline: " + FormatTickTimes( *baseline, NULL ) + "; see /stress ticks for the deltas.";
+
+    return new PyString( reply );
+}
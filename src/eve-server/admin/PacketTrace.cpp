@@ -0,0 +1,183 @@
+/*
+    ------------------------------------------------------------------------------------
+    LICENSE:
+    ------------------------------------------------------------------------------------
+    This file is part of EVEmu: EVE Online Server Emulator
+    Copyright 2006 - 2011 The EVEmu Team
+    For the latest information visit http://evemu.org
+    ------------------------------------------------------------------------------------
+    This program is free software; you can redistribute it and/or modify it under
+    the terms of the GNU Lesser General Public License as published by the Free Software
+    Foundation; either version 2 of the License, or (at your option) any later
+    version.
+
+    This program is distributed in the hope that it will be useful, but WITHOUT
+    ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+    FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public License along with
+    this program; if not, write to the Free Software Foundation, Inc., 59 Temple
+    Place - Suite 330, Boston, MA 02111-1307, USA, or go to
+    http://www.gnu.org/copyleft/lesser.txt.
+    ------------------------------------------------------------------------------------
+    Author:     EVEmu Team
+*/
+
+
+#include "eve-server.h"
+
+#include "EVEServerConfig.h"
+#include "admin/PacketTrace.h"
+
+/// Number of records the ring holds.
+static const size_t TRACE_RING_SIZE = 4096;
+/// The biggest packet recorded; the ring holds at most TRACE_RING_SIZE of them.
+static const size_t TRACE_PACKET_LIMIT = 64 * 1024;
+/// Default of the most packets recorded per second.
+static const uint32 TRACE_DEFAULT_RATE_LIMIT = 200;
+
+PacketTrace::PacketTrace()
+: mRing( TRACE_RING_SIZE ),
+  mNext( 0 ),
+  mCount( 0 ),
+  mSampling( 1 ),
+  mRateLimit( TRACE_DEFAULT_RATE_LIMIT ),
+  mSeen( 0 ),
+  mWindowStart( 0 ),
+  mWindowCount( 0 )
+{
+}
+
+bool PacketTrace::ToggleAccount( uint32 accountID )
+{
+    if( 0 < mAccounts.erase( accountID ) )
+        return false;
+
+    mAccounts.insert( accountID );
+    return true;
+}
+
+bool PacketTrace::ToggleService( const std::string& service )
+{
+    if( 0 < mServices.erase( service ) )
+        return false;
+
+    mServices.insert( service );
+    return true;
+}
+
+void PacketTrace::Clear()
+{
+    for( size_t i = 0; i < mRing.size(); ++i )
+        mRing[ i ].data.Resize< uint8 >( 0 );
+    mNext = 0;
+    mCount = 0;
+
+    mAccounts.clear();
+    mServices.clear();
+    mSampling = 1;
+    mRateLimit = TRACE_DEFAULT_RATE_LIMIT;
+    mSeen = 0;
+}
+
+bool PacketTrace::Wants( uint32 accountID, const std::string& service )
+{
+    if( !mAccounts.empty() && 0 == mAccounts.count( accountID ) )
+        return false;
+    if( !mServices.empty() && 0 == mServices.count( service ) )
+        return false;
+
+    if( 0 != ( mSeen++ % mSampling ) )
+    {
+        ++mStats.sampledOut;
+        return false;
+    }
+
+    const uint64 now = GetTimeUSeconds();
+    if( mWindowStart + 1000000 <= now )
+    {
+        mWindowStart = now;
+        mWindowCount = 0;
+    }
+    if( mRateLimit <= mWindowCount )
+    {
+        ++mStats.throttled;
+        return false;
+    }
+
+    ++mWindowCount;
+    return true;
+}
+
+void PacketTrace::Record( uint32 accountID, PacketCapture::Direction direction, const PyRep* rep )
+{
+    Entry& entry = mRing[ mNext ];
+
+    entry.data.Resize< uint8 >( 0 );
+    if( !Marshal( rep, entry.data ) || TRACE_PACKET_LIMIT < entry.data.size() )
+    {
+        entry.data.Resize< uint8 >( 0 );
+        ++mStats.oversized;
+        return;
+    }
+
+    entry.time = GetTimeUSeconds();
+    entry.accountID = accountID;
+    entry.direction = (uint8)direction;
+
+    if( mCount < mRing.size() )
+        ++mCount;
+    else
+        ++mStats.overwritten;
+    mNext = ( mNext + 1 ) % mRing.size();
+
+    ++mStats.traced;
+}
+
+size_t PacketTrace::Dump( std::vector< std::string >& files ) const
+{
+    if( 0 == mCount )
+        return 0;
+
+    char timestamp[ 16 ];
+    const time_t now = time( NULL );
+    strftime( timestamp, sizeof( timestamp ), "%y%m%d_%H%M%S", localtime( &now ) );
+
+    // the oldest record is the first slot of a ring which is not full yet
+    const size_t first = ( mCount < mRing.size() ? 0 : mNext );
+    const uint64 start = mRing[ first ].time;
+
+    std::map< uint32, PacketCapture* > captures;
+    size_t written = 0;
+    for( size_t i = 0; i < mCount; ++i )
+    {
+        const Entry& entry = mRing[ ( first + i ) % mRing.size() ];
+
+        PacketCapture*& capture = captures[ entry.accountID ];
+        if( NULL == capture )
+        {
+            std::string filename;
+            sprintf( filename, "%strace_%u_%s.evecap", sConfig.files.captureDir.c_str(), entry.accountID, timestamp );
+
+            capture = new PacketCapture;
+            if( !capture->Open( filename.c_str() ) )
+                sLog.Error( "PacketTrace", "Unable to create trace '%s'.", filename.c_str() );
+            else
+                files.push_back( filename );
+        }
+
+        if( !capture->IsOpen() )
+            continue;
+
+        capture->Write( entry.time - start, (PacketCapture::Direction)entry.direction, &entry.data[ 0 ], entry.data.size() );
+        ++written;
+    }
+
+    std::map< uint32, PacketCapture* >::iterator cur, end;
+    cur = captures.begin();
+    end = captures.end();
+    for(; cur != end; cur++)
+        SafeDelete( cur->second );
+
+    return written;
+}
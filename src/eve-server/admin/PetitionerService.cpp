@@ -92,7 +92,7 @@ PyResult PetitionerService::Handle_GetCategories( PyCallArgs& call )
 {
     //takes no arguments
 
-    sLog.Debug( "PetitionerService", "Called GetCategories stub." );
+    _debug( "PetitionerService", "Called GetCategories stub." );
 
     PyList* result = new PyList;
     result->AddItemString( "Test Cat" );
@@ -106,7 +106,7 @@ PyResult PetitionerService::Handle_GetUnreadMessages( PyCallArgs& call )
 {
     //takes no arguments
 
-    sLog.Debug( "PetitionerService", "Called GetUnreadMessages stub." );
+    _debug( "PetitionerService", "Called GetUnreadMessages stub." );
 
     //unknown...
     return new PyList;
@@ -110,7 +110,7 @@ PyResult SlashService::SlashCommand(Client * client, std::string command)
         throw PyException( MakeCustomError( "You need to have ROLE_SLASH to execute commands." ) );
     }
 
-    sLog.Debug( "SlashService::Handle_SlashCmd()", "Slash command called: '%s'", command.c_str() );
+    _debug( "SlashService::Handle_SlashCmd()", "Slash command called: '%s'", command.c_str() );
 
     return m_commandDispatch->Execute( client, command.c_str() );
 }
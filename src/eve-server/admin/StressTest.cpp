@@ -0,0 +1,184 @@
+/*
+    ------------------------------------------------------------------------------------
+    LICENSE:
+    ------------------------------------------------------------------------------------
+    This file is part of EVEmu: EVE Online Server Emulator
+    Copyright 2006 - 2011 The EVEmu Team
+    For the latest information visit http://evemu.org
+    ------------------------------------------------------------------------------------
+    This program is free software; you can redistribute it and/or modify it under
+    the terms of the GNU Lesser General Public License as published by the Free Software
+    Foundation; either version 2 of the License, or (at your option) any later
+    version.
+
+    This program is distributed in the hope that it will be useful, but WITHOUT
+    ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+    FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public License along with
+    this program; if not, write to the Free Software Foundation, Inc., 59 Temple
+    Place - Suite 330, Boston, MA 02111-1307, USA, or go to
+    http://www.gnu.org/copyleft/lesser.txt.
+    ------------------------------------------------------------------------------------
+    Author:     EVEmu Team
+*/
+
+
+#include "eve-server.h"
+
+#include "admin/StressTest.h"
+#include "npc/NPC.h"
+#include "system/SystemManager.h"
+
+StressTest::StressTest()
+: mNextInstanceID( 1 )
+{
+}
+
+StressTest::~StressTest()
+{
+    std::map< uint32, std::vector< Run* > >::iterator cur, end;
+    cur = mRuns.begin();
+    end = mRuns.end();
+    for(; cur != end; cur++ )
+    {
+        std::vector< Run* >::iterator curr, endr;
+        curr = cur->second.begin();
+        endr = cur->second.end();
+        for(; curr != endr; curr++ )
+            delete *curr;
+    }
+}
+
+size_t StressTest::GetEntityCount( uint32 solarSystemID ) const
+{
+    std::map< uint32, std::vector< Run* > >::const_iterator res = mRuns.find( solarSystemID );
+    if( mRuns.end() == res )
+        return 0;
+
+    size_t count = 0;
+
+    std::vector< Run* >::const_iterator cur, end;
+    cur = res->second.begin();
+    end = res->second.end();
+    for(; cur != end; cur++ )
+        count += (*cur)->instance->size();
+
+    return count;
+}
+
+size_t StressTest::Spawn( SystemManager& system, PyServiceMgr& services, uint8 kind, uint32 typeID, uint32 count,
+                          Pattern pattern, double spacing, const GPoint& center, std::vector< NPC* >* npcs )
+{
+    if( mBaselines.find( system.GetID() ) == mBaselines.end() )
+        mBaselines[ system.GetID() ] = GetTickTimes( system );
+
+    Run* run = new Run;
+    run->blueprint.dungeonID = 0;
+    run->blueprint.dungeonName = "Stress test";
+    run->blueprint.factionID = 0;
+    run->blueprint.objects.resize( count );
+
+    for( uint32 i = 0; i < count; i++ )
+    {
+        DungeonBlueprint::Object& object = run->blueprint.objects[ i ];
+        object.kind = kind;
+        object.typeID = typeID;
+        // owned by EVE System, like the spawns of /spawn
+        object.ownerID = 1;
+        object.offset = _GetOffset( pattern, i, count, spacing );
+
+        if( DungeonBlueprint::OBJECT_NPC_GROUP == kind )
+        {
+            DungeonBlueprint::NPCEntry entry;
+            entry.npcTypeID = typeID;
+            entry.quantity = 1;
+            entry.probability = 1.0f;
+            entry.ownerID = 1;
+            entry.corporationID = 0;
+
+            object.npcs.push_back( entry );
+        }
+    }
+
+    run->instance = new DungeonInstance( mNextInstanceID++, run->blueprint, system, 0, center );
+    const size_t spawned = run->instance->Spawn( services );
+    mRuns[ system.GetID() ].push_back( run );
+
+    if( NULL != npcs )
+        run->instance->GetNPCs( *npcs );
+
+    _log( SPAWN__POP, "Stress test: spawned %u of %u objects of type %u in system %u.",
+          (uint32)spawned, count, typeID, system.GetID() );
+
+    return spawned;
+}
+
+size_t StressTest::TeardownSystem( uint32 solarSystemID )
+{
+    mBaselines.erase( solarSystemID );
+
+    std::map< uint32, std::vector< Run* > >::iterator res = mRuns.find( solarSystemID );
+    if( mRuns.end() == res )
+        return 0;
+
+    const size_t count = res->second.size();
+
+    std::vector< Run* >::iterator cur, end;
+    cur = res->second.begin();
+    end = res->second.end();
+    for(; cur != end; cur++ )
+    {
+        (*cur)->instance->Teardown();
+        delete *cur;
+    }
+
+    mRuns.erase( res );
+    return count;
+}
+
+StressTest::TickTimes StressTest::GetTickTimes( const SystemManager& system )
+{
+    const SystemManager::TickStats& stats = system.tickStats();
+
+    TickTimes times;
+    times.ticks = stats.ticks;
+    times.maxTickTime = stats.maxTickTime;
+    if( 0 < stats.ticks )
+    {
+        times.tickTime = (double)stats.tickTime / stats.ticks;
+        times.aiTime = (double)stats.aiTime / stats.ticks;
+    }
+    if( 0 < stats.destinyTicks )
+        times.destinyTime = (double)stats.destinyTime / stats.destinyTicks;
+
+    return times;
+}
+
+const StressTest::TickTimes* StressTest::GetBaseline( uint32 solarSystemID ) const
+{
+    std::map< uint32, TickTimes >::const_iterator res = mBaselines.find( solarSystemID );
+    if( mBaselines.end() == res )
+        return NULL;
+
+    return &res->second;
+}
+
+GPoint StressTest::_GetOffset( Pattern pattern, uint32 index, uint32 count, double spacing )
+{
+    if( PATTERN_RING == pattern )
+    {
+        // the circumference fits all of them, but the ring never gets narrower than the spacing
+        const double radius = std::max( spacing, count * spacing / ( 2.0 * M_PI ) );
+        const double angle = 2.0 * M_PI * index / count;
+
+        return GPoint( radius * cos( angle ), 0.0, radius * sin( angle ) );
+    }
+
+    // a square grid, its first row a spacing away from the center
+    const uint32 side = (uint32)ceil( sqrt( (double)count ) );
+    const int32 column = (int32)( index % side ) - (int32)( side / 2 );
+    const uint32 row = index / side + 1;
+
+    return GPoint( column * spacing, 0.0, row * spacing );
+}
@@ -31,18 +31,15 @@ APIAccountDB::APIAccountDB()
 {
 }
 
-bool APIAccountDB::GetCharactersList(uint32 accountID, std::vector<std::string> & charIDList, std::vector<std::string> & charNameList,
-    std::vector<std::string> & charCorpIDList, std::vector<std::string> & charCorpNameList)
+bool APIAccountDB::GetCharactersList(uint32 accountID, DBQueryResult & res)
 {
-    DBQueryResult res;
-
     // Get list of characters and their corporation info from the accountID:
-    if( !sDatabase.RunQuery(res,
+    if( !sDatabase.RunReadQuery(res,
         " SELECT "
+        "   entity.itemName AS name, "
         "   character_.characterID, "
-        "   character_.corporationID, "
         "   corporation.corporationName, "
-        "   entity.itemName AS name "
+        "   character_.corporationID "
         " FROM `character_` "
         "   LEFT JOIN corporation ON corporation.corporationID = character_.corporationID "
         "   LEFT JOIN entity ON entity.itemID = character_.characterID "
@@ -52,16 +49,6 @@ bool APIAccountDB::GetCharactersList(uint32 accountID, std::vector<std::string>
         return false;
     }
 
-    DBResultRow row;
-    std::map<std::string, std::string> charInfo;
-    while( res.GetRow( row ) )
-    {
-        charIDList.push_back( std::string(row.GetText(0)) );
-        charCorpIDList.push_back( std::string(row.GetText(1)) );
-        charCorpNameList.push_back( std::string(row.GetText(2)) );
-        charNameList.push_back( std::string(row.GetText(3)) );
-    }
-
     return true;
 }
 
@@ -71,7 +58,7 @@ bool APIAccountDB::GetAccountInfo(uint32 accountID, std::vector<std::string> & a
     DBQueryResult res;
 
     // Get account table info using the accountID:
-    if( !sDatabase.RunQuery(res,
+    if( !sDatabase.RunReadQuery(res,
         " SELECT "
         "   online, "
         "   banned, "
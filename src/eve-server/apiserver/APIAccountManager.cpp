@@ -34,14 +34,14 @@ APIAccountManager::APIAccountManager(const PyServiceMgr &services)
 {
 }
 
-std::tr1::shared_ptr<std::string> APIAccountManager::ProcessCall(const APICommandCall * pAPICommandCall)
+APIXMLDocumentPtr APIAccountManager::ProcessCall(const APICommandCall * pAPICommandCall)
 {
-    sLog.Debug("APIAccountManager::ProcessCall()", "EVEmu API - Account Service Manager");
+    _debug("APIAccountManager::ProcessCall()", "EVEmu API - Account Service Manager");
 
     if( pAPICommandCall->find( "servicehandler" ) == pAPICommandCall->end() )
     {
         sLog.Error( "APIAccountManager::ProcessCall()", "Cannot find 'servicehandler' specifier in pAPICommandCall packet" );
-        return std::tr1::shared_ptr<std::string>(new std::string(""));
+        return APIXMLDocumentPtr(new APIXMLDocument());
     }
 
     if( pAPICommandCall->find( "servicehandler" )->second == "APIKeyRequest.xml.aspx" )
@@ -56,13 +56,13 @@ std::tr1::shared_ptr<std::string> APIAccountManager::ProcessCall(const APIComman
     {
         sLog.Error("APIAccountManager::ProcessCall()", "EVEmu API - Account Service Manager - ERROR: Cannot resolve '%s' as a valid service query for Admin Service Manager",
             pAPICommandCall->find("servicehandler")->second.c_str() );
-        return std::tr1::shared_ptr<std::string>(new std::string(""));
+        return APIXMLDocumentPtr(new APIXMLDocument());
     }
 
     return BuildErrorXMLResponse( "9999", "EVEmu API Server: Account Manager - Unknown call." );
 }
 
-std::tr1::shared_ptr<std::string> APIAccountManager::_APIKeyRequest(const APICommandCall * pAPICommandCall)
+APIXMLDocumentPtr APIAccountManager::_APIKeyRequest(const APICommandCall * pAPICommandCall)
 {
     bool status = false;
     uint32 userID, apiRole;
@@ -75,7 +75,7 @@ std::tr1::shared_ptr<std::string> APIAccountManager::_APIKeyRequest(const APICom
     std::string accountID;
     std::string keyTag;
 
-    sLog.Debug("APIAccountManager::_APIKeyRequest()", "EVEmu API - Account Service Manager - CALL: APIKeyRequest.xml.aspx");
+    _debug("APIAccountManager::_APIKeyRequest()", "EVEmu API - Account Service Manager - CALL: APIKeyRequest.xml.aspx");
 
     // 1: Decode arguments:
     if( pAPICommandCall->find( "username" ) != pAPICommandCall->end() )
@@ -197,15 +197,15 @@ std::tr1::shared_ptr<std::string> APIAccountManager::_APIKeyRequest(const APICom
     }
     _CloseXMLHeader( EVEAPI::CacheStyles::Long );
 
-    return _GetXMLDocumentString();
+    return _GetXMLDocument();
 }
 
-std::tr1::shared_ptr<std::string> APIAccountManager::_Characters(const APICommandCall * pAPICommandCall)
+APIXMLDocumentPtr APIAccountManager::_Characters(const APICommandCall * pAPICommandCall)
 {
 
     sLog.Error( "APIAccountManager::_Characters()", "TODO: Insert code to validate userID and apiKey" );
 
-    sLog.Debug("APIAccountManager::_Characters()", "EVEmu API - Account Service Manager - CALL: Characters.xml.aspx");
+    _debug("APIAccountManager::_Characters()", "EVEmu API - Account Service Manager - CALL: Characters.xml.aspx");
 
     if( pAPICommandCall->find( "userid" ) == pAPICommandCall->end() )
     {
@@ -215,10 +215,7 @@ std::tr1::shared_ptr<std::string> APIAccountManager::_Characters(const APIComman
 
     uint32 status = 0;
     uint32 accountID = 0;
-    std::vector<std::string> charIDList;
-    std::vector<std::string> charNameList;
-    std::vector<std::string> charCorpIDList;
-    std::vector<std::string> charCorpNameList;
+    DBQueryResult res;
 
     std::string userID = pAPICommandCall->find( "userid" )->second;
 
@@ -229,10 +226,10 @@ std::tr1::shared_ptr<std::string> APIAccountManager::_Characters(const APIComman
         return BuildErrorXMLResponse( "203", "Authentication failure." );
     }
 
-    if( !( m_accountDB.GetCharactersList(accountID, charIDList, charNameList, charCorpIDList, charCorpNameList) ) )
+    if( !( m_accountDB.GetCharactersList(accountID, res) ) )
     {
         sLog.Error( "APIAccountManager::_Characters()", "ERROR: m_accountDB.GetCharactersList() call failed for unknown reason - exiting with error" );
-        BuildErrorXMLResponse( "9999", "EVEmu API Server: Account Manager - Characters.xml.aspx STUB" );
+        return BuildErrorXMLResponse( "9999", "EVEmu API Server: Account Manager - Characters.xml.aspx STUB" );
     }
 
     std::vector<std::string> rowset;
@@ -246,15 +243,7 @@ std::tr1::shared_ptr<std::string> APIAccountManager::_Characters(const APIComman
             rowset.push_back("corporationID");
             _BuildXMLRowSet( "characters", "characterID", &rowset );
             {
-                for(uint32 i=0; i<charIDList.size(); i++)
-                {
-                    rowset.clear();
-                    rowset.push_back(charNameList.at(i));
-                    rowset.push_back(charIDList.at(i));
-                    rowset.push_back(charCorpNameList.at(i));
-                    rowset.push_back(charCorpIDList.at(i));
-                    _BuildXMLRow( &rowset );
-                }
+                _BuildXMLRows( res );
             }
             _CloseXMLRowSet();  // close rowset "characters"
         }
@@ -262,10 +251,10 @@ std::tr1::shared_ptr<std::string> APIAccountManager::_Characters(const APIComman
     }
     _CloseXMLHeader( EVEAPI::CacheStyles::Long );
 
-    return _GetXMLDocumentString();
+    return _GetXMLDocument();
 }
 
-std::tr1::shared_ptr<std::string> APIAccountManager::_AccountStatus(const APICommandCall * pAPICommandCall)
+APIXMLDocumentPtr APIAccountManager::_AccountStatus(const APICommandCall * pAPICommandCall)
 {
     sLog.Error( "APIAccountManager::_AccountStatus()", "TODO: Insert code to validate userID and apiKey" );
 
@@ -303,7 +292,7 @@ std::tr1::shared_ptr<std::string> APIAccountManager::_AccountStatus(const APICom
     }
     _CloseXMLHeader( EVEAPI::CacheStyles::Short );
 
-    return _GetXMLDocumentString();
+    return _GetXMLDocument();
 }
 
 std::string APIAccountManager::_GenerateAPIKey()
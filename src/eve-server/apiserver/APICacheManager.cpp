@@ -27,30 +27,121 @@
 
 #include "apiserver/APICacheManager.h"
 
-APICacheManager::APICacheManager()
+APICacheManager::APICacheManager(size_t sizeLimit)
+: m_sizeLimit(sizeLimit)
 {
 }
 
-bool APICacheManager::CacheRetrieve(const std::string * apiDescriptor, std::string * xmlDoc)
+bool APICacheManager::CacheRetrieve(const std::string * apiDescriptor, APIXMLDocumentPtr * xmlDoc)
 {
-    // TODO:
-    // 1) run apiDescriptor string through SHA1 hash, then search for a file
-    //    with the name of the hash with '.apiobj' extension
-    // 2) if no file found, then return FALSE
-    // 3) if file found, open it and grab first line, inspect this expriation time and compare to current time
-    // 4) if expiration has passed, return FALSE
-    // 5) if expiration has NOT passed, read rest of file contents and copy to xmlDoc string, then return TRUE
-    return false;
+    Shard &shard = _GetShard(*apiDescriptor);
+    Lock< ShardMutex > lock(shard.lock);
+
+    EntryMap::iterator res = shard.entries.find(*apiDescriptor);
+    if( res == shard.entries.end() )
+    {
+        ++shard.stats.misses;
+        return false;
+    }
+
+    if( res->second.expiration <= Win32TimeNow() )
+    {
+        _Erase(shard, res);
+
+        ++shard.stats.expired;
+        ++shard.stats.misses;
+        return false;
+    }
+
+    // most recently used now
+    shard.lru.splice(shard.lru.begin(), shard.lru, res->second.lru);
+
+    *xmlDoc = res->second.xmlDoc;
+    ++shard.stats.hits;
+    return true;
+}
+
+bool APICacheManager::CacheDeposit(const std::string * apiDescriptor, const APIXMLDocumentPtr & xmlDoc, uint64 win32timeExpiration)
+{
+    const size_t shardLimit = m_sizeLimit / SHARD_COUNT;
+    const size_t size = _GetEntrySize(*apiDescriptor, *xmlDoc);
+    if( size > shardLimit || win32timeExpiration <= Win32TimeNow() )
+        return false;
+
+    Shard &shard = _GetShard(*apiDescriptor);
+    Lock< ShardMutex > lock(shard.lock);
+
+    EntryMap::iterator res = shard.entries.find(*apiDescriptor);
+    if( res != shard.entries.end() )
+        _Erase(shard, res);
+
+    // make room, least recently used first
+    while( shard.size + size > shardLimit )
+    {
+        _Erase(shard, shard.entries.find(*shard.lru.back()));
+        ++shard.stats.evictions;
+    }
+
+    res = shard.entries.insert(std::make_pair(*apiDescriptor, Entry())).first;
+    res->second.xmlDoc = xmlDoc;
+    res->second.expiration = win32timeExpiration;
+    res->second.lru = shard.lru.insert(shard.lru.begin(), &res->first);
+
+    shard.size += size;
+    ++shard.stats.deposits;
+    return true;
+}
+
+APICacheManager::Stats APICacheManager::GetStats(size_t &entries, size_t &size)
+{
+    Stats total;
+    entries = 0;
+    size = 0;
+
+    for( uint32 i = 0; i < SHARD_COUNT; ++i )
+    {
+        Shard &shard = m_shards[ i ];
+        Lock< ShardMutex > lock(shard.lock);
+
+        total.hits += shard.stats.hits;
+        total.misses += shard.stats.misses;
+        total.expired += shard.stats.expired;
+        total.deposits += shard.stats.deposits;
+        total.evictions += shard.stats.evictions;
+
+        entries += shard.entries.size();
+        size += shard.size;
+    }
+
+    return total;
+}
+
+void APICacheManager::ResetStats()
+{
+    for( uint32 i = 0; i < SHARD_COUNT; ++i )
+    {
+        Shard &shard = m_shards[ i ];
+        Lock< ShardMutex > lock(shard.lock);
+
+        shard.stats.Reset();
+    }
+}
+
+APICacheManager::Shard &APICacheManager::_GetShard(const std::string &apiDescriptor)
+{
+    const uint32 hash = CRC32::Generate((const uint8 *)apiDescriptor.data(), apiDescriptor.size());
+    return m_shards[ hash % SHARD_COUNT ];
+}
+
+size_t APICacheManager::_GetEntrySize(const std::string &apiDescriptor, const APIXMLDocument &xmlDoc)
+{
+    // the key is stored once, in the map; the list keeps a pointer to it
+    return apiDescriptor.size() + xmlDoc.size() + sizeof(EntryMap::value_type) + sizeof(const std::string *);
 }
 
-bool APICacheManager::CacheDeposit(const std::string * apiDescriptor, const std::string * xmlDoc, uint64 win32timeExpiration)
+void APICacheManager::_Erase(Shard &shard, EntryMap::iterator itr)
 {
-    // TODO:
-    // 1) run apiDescriptor string through SHA1 hash, then create a file
-    //    with the name of the hash with '.apiobj' extension
-    // 2) check to see if this filename already exists, if so, return FALSE
-    // 3) place the win32timeExpiration value at the first line of the file, this indicates when this cached object expires
-    // 4) place the xmlDoc string in the rest of the file, save and close it
-    // 5) return TRUE
-    return false;
+    shard.size -= _GetEntrySize(itr->first, *itr->second.xmlDoc);
+    shard.lru.erase(itr->second.lru);
+    shard.entries.erase(itr);
 }
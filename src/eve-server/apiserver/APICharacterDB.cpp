@@ -38,7 +38,7 @@ bool APICharacterDB::GetCharacterSkillsTrained(uint32 characterID, std::vector<s
     DBQueryResult res;
 
     // Get list of characters and their corporation info from the accountID:
-    if( !sDatabase.RunQuery(res,
+    if( !sDatabase.RunReadQuery(res,
         " SELECT "
         "   entity.itemID, "
         "   entity.typeID, "
@@ -112,7 +112,7 @@ bool APICharacterDB::GetCharacterInfo(uint32 characterID, std::vector<std::strin
     DBQueryResult res;
 
     // Get list of characters and their corporation info from the accountID:
-    if( !sDatabase.RunQuery(res,
+    if( !sDatabase.RunReadQuery(res,
         " SELECT "
         "  character_.*, "
         "  chrAncestries.ancestryName, "
@@ -163,7 +163,7 @@ bool APICharacterDB::GetCharacterAttributes(uint32 characterID, std::map<std::st
     DBQueryResult res;
 
     // Get list of characters and their corporation info from the accountID:
-    if( !sDatabase.RunQuery(res,
+    if( !sDatabase.RunReadQuery(res,
         " SELECT "
         "  itemID, "
         "  attributeID, "
@@ -254,7 +254,7 @@ bool APICharacterDB::GetCharacterSkillQueue(uint32 characterID, std::vector<std:
     DBQueryResult res;
 
     // Get list of characters and their corporation info from the accountID:
-    if( !sDatabase.RunQuery(res,
+    if( !sDatabase.RunReadQuery(res,
         " SELECT "
         "  chrSkillQueue.*, "
         "  dgmTypeAttributes.attributeID, "
@@ -359,7 +359,7 @@ bool APIServiceDB::GetAccountIdFromUsername(std::string username, std::string *
     DBQueryResult res;
 
     // Find accountID in 'account' table using accountName:
-    if( !sDatabase.RunQuery(res,
+    if( !sDatabase.RunReadQuery(res,
         "SELECT"
         "    accountID "
         " FROM account "
@@ -386,7 +386,7 @@ bool APIServiceDB::GetApiAccountInfoUsingAccountID(std::string accountID, uint32
     DBQueryResult res;
 
     // Find userID, fullKey, limitedKey, and apiRole from 'accountApi' table using accountID obtained from 'account' table:
-    if( !sDatabase.RunQuery(res,
+    if( !sDatabase.RunReadQuery(res,
         "SELECT"
         "    userID, fullKey, limitedKey, apiRole "
         " FROM accountApi "
@@ -415,7 +415,7 @@ bool APIServiceDB::GetApiAccountInfoUsingUserID(std::string userID, std::string
     DBQueryResult res;
 
     // Find fullKey, limitedKey, and apiRole from 'accountApi' table using userID supplied from an API query string:
-    if( !sDatabase.RunQuery(res,
+    if( !sDatabase.RunReadQuery(res,
         "SELECT"
         "    fullKey, limitedKey, apiRole "
         " FROM accountApi "
@@ -33,14 +33,14 @@ APICharacterManager::APICharacterManager(const PyServiceMgr &services)
 {
 }
 
-std::tr1::shared_ptr<std::string> APICharacterManager::ProcessCall(const APICommandCall * pAPICommandCall)
+APIXMLDocumentPtr APICharacterManager::ProcessCall(const APICommandCall * pAPICommandCall)
 {
-    sLog.Debug("APIAdminManager::ProcessCall()", "EVEmu API - Character Service Manager");
+    _debug("APIAdminManager::ProcessCall()", "EVEmu API - Character Service Manager");
 
     if( pAPICommandCall->find( "servicehandler" ) == pAPICommandCall->end() )
     {
         sLog.Error( "APICharacterManager::ProcessCall()", "Cannot find 'servicehandler' specifier in pAPICommandCall packet" );
-        return std::tr1::shared_ptr<std::string>(new std::string(""));
+        return APIXMLDocumentPtr(new APIXMLDocument());
     }
 
     if( pAPICommandCall->find( "servicehandler" )->second == "CharacterSheet.xml.aspx" )
@@ -55,20 +55,20 @@ std::tr1::shared_ptr<std::string> APICharacterManager::ProcessCall(const APIComm
     {
         sLog.Error("APIAdminManager::ProcessCall()", "EVEmu API - Admin Service Manager - ERROR: Cannot resolve '%s' as a valid service query for Admin Service Manager",
             pAPICommandCall->find("servicehandler")->second.c_str() );
-        return std::tr1::shared_ptr<std::string>(new std::string(""));
+        return APIXMLDocumentPtr(new APIXMLDocument());
     }
-    sLog.Debug("APICharacterManager::ProcessCall()", "EVEmu API - Character Service Manager");
+    _debug("APICharacterManager::ProcessCall()", "EVEmu API - Character Service Manager");
 
-    return std::tr1::shared_ptr<std::string>(new std::string(""));
+    return APIXMLDocumentPtr(new APIXMLDocument());
 }
 
-std::tr1::shared_ptr<std::string> APICharacterManager::_CharacterSheet(const APICommandCall * pAPICommandCall)
+APIXMLDocumentPtr APICharacterManager::_CharacterSheet(const APICommandCall * pAPICommandCall)
 {
     size_t i;
 
     sLog.Error( "APICharacterManager::_CharacterSheet()", "TODO: Insert code to validate userID and apiKey" );
 
-    sLog.Debug("APICharacterManager::_CharacterSheet()", "EVEmu API - Character Service Manager - CALL: CharacterSheet.xml.aspx");
+    _debug("APICharacterManager::_CharacterSheet()", "EVEmu API - Character Service Manager - CALL: CharacterSheet.xml.aspx");
 
     if( pAPICommandCall->find( "userid" ) == pAPICommandCall->end() )
     {
@@ -224,16 +224,16 @@ std::tr1::shared_ptr<std::string> APICharacterManager::_CharacterSheet(const API
     }
     _CloseXMLHeader( EVEAPI::CacheStyles::Long );
 
-    return _GetXMLDocumentString();
+    return _GetXMLDocument();
 }
 
-std::tr1::shared_ptr<std::string> APICharacterManager::_SkillQueue(const APICommandCall * pAPICommandCall)
+APIXMLDocumentPtr APICharacterManager::_SkillQueue(const APICommandCall * pAPICommandCall)
 {
     size_t i;
 
     sLog.Error( "APICharacterManager::_SkillQueue()", "TODO: Insert code to validate userID and apiKey" );
 
-    sLog.Debug("APICharacterManager::_SkillQueue()", "EVEmu API - Character Service Manager - CALL: SkillQueue.xml.aspx");
+    _debug("APICharacterManager::_SkillQueue()", "EVEmu API - Character Service Manager - CALL: SkillQueue.xml.aspx");
 
     if( pAPICommandCall->find( "userid" ) == pAPICommandCall->end() )
     {
@@ -350,14 +350,14 @@ std::tr1::shared_ptr<std::string> APICharacterManager::_SkillQueue(const APIComm
     }
     _CloseXMLHeader( EVEAPI::CacheStyles::Modified );
 
-    return _GetXMLDocumentString();
+    return _GetXMLDocument();
 }
 
-std::tr1::shared_ptr<std::string> APICharacterManager::_SkillInTraining(const APICommandCall * pAPICommandCall)
+APIXMLDocumentPtr APICharacterManager::_SkillInTraining(const APICommandCall * pAPICommandCall)
 {
     sLog.Error( "APICharacterManager::_SkillInTraining()", "TODO: Insert code to validate userID and apiKey" );
 
-    sLog.Debug("APICharacterManager::_SkillInTraining()", "EVEmu API - Character Service Manager - CALL: SkillInTraining.xml.aspx");
+    _debug("APICharacterManager::_SkillInTraining()", "EVEmu API - Character Service Manager - CALL: SkillInTraining.xml.aspx");
 
     if( pAPICommandCall->find( "userid" ) == pAPICommandCall->end() )
     {
@@ -458,5 +458,5 @@ std::tr1::shared_ptr<std::string> APICharacterManager::_SkillInTraining(const AP
     }
     _CloseXMLHeader( EVEAPI::CacheStyles::Modified );
 
-    return _GetXMLDocumentString();
+    return _GetXMLDocument();
 }
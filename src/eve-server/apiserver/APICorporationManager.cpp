@@ -32,9 +32,9 @@ APICorporationManager::APICorporationManager(const PyServiceMgr &services)
 {
 }
 
-std::tr1::shared_ptr<std::string> APICorporationManager::ProcessCall(const APICommandCall * pAPICommandCall)
+APIXMLDocumentPtr APICorporationManager::ProcessCall(const APICommandCall * pAPICommandCall)
 {
-    sLog.Debug("APICorporationManager::ProcessCall()", "EVEmu API - Corporation Service Manager");
+    _debug("APICorporationManager::ProcessCall()", "EVEmu API - Corporation Service Manager");
 
-    return std::tr1::shared_ptr<std::string>(new std::string(""));
+    return APIXMLDocumentPtr(new APIXMLDocument());
 }
@@ -32,9 +32,9 @@ APIEveSystemManager::APIEveSystemManager(const PyServiceMgr &services)
 {
 }
 
-std::tr1::shared_ptr<std::string> APIEveSystemManager::ProcessCall(const APICommandCall * pAPICommandCall)
+APIXMLDocumentPtr APIEveSystemManager::ProcessCall(const APICommandCall * pAPICommandCall)
 {
-    sLog.Debug("APIEveSystemManager::ProcessCall()", "EVEmu API - EvE-System Service Manager");
+    _debug("APIEveSystemManager::ProcessCall()", "EVEmu API - EvE-System Service Manager");
 
-    return std::tr1::shared_ptr<std::string>(new std::string(""));
+    return APIXMLDocumentPtr(new APIXMLDocument());
 }
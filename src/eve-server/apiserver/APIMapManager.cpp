@@ -32,9 +32,9 @@ APIMapManager::APIMapManager(const PyServiceMgr &services)
 {
 }
 
-std::tr1::shared_ptr<std::string> APIMapManager::ProcessCall(const APICommandCall * pAPICommandCall)
+APIXMLDocumentPtr APIMapManager::ProcessCall(const APICommandCall * pAPICommandCall)
 {
-    sLog.Debug("APIMapManager::ProcessCall()", "EVEmu API - Map Service Manager");
+    _debug("APIMapManager::ProcessCall()", "EVEmu API - Map Service Manager");
 
-    return std::tr1::shared_ptr<std::string>(new std::string(""));
+    return APIXMLDocumentPtr(new APIXMLDocument());
 }
@@ -28,6 +28,7 @@
 #include "EVEServerConfig.h"
 #include "apiserver/APIAccountManager.h"
 #include "apiserver/APIAdminManager.h"
+#include "apiserver/APICacheManager.h"
 #include "apiserver/APICharacterManager.h"
 #include "apiserver/APICorporationManager.h"
 #include "apiserver/APIEveSystemManager.h"
@@ -38,6 +39,7 @@
 const char *const APIServer::FallbackURL = "http://api.eveonline.com/";
 
 APIServer::APIServer()
+: m_cache(sConfig.net.apiCacheSize)
 {
     runonce = false;
     std::stringstream urlBuilder;
@@ -62,39 +64,58 @@ void APIServer::CreateServices(const PyServiceMgr &services)
     runonce = true;
 }
 
-std::tr1::shared_ptr<std::vector<char> > APIServer::GetXML(const APICommandCall * pAPICommandCall)
+APIXMLDocumentPtr APIServer::GetXML(const APICommandCall * pAPICommandCall)
 {
     //if( m_APIServiceManagers.find(pAPICommandCall->at(0).first) != m_APIServiceManagers.end() )
     if( pAPICommandCall->find( "service" ) == pAPICommandCall->end() )
     {
         sLog.Error( "APIserver::GetXML()", "Cannot find 'service' specifier in pAPICommandCall packet" );
-        return std::tr1::shared_ptr<std::vector<char> >(new std::vector<char>() );
-        //return std::tr1::shared_ptr<std::string>(new std::string(""));
+        return APIXMLDocumentPtr( new APIXMLDocument() );
     }
 
-    if( m_APIServiceManagers.find(pAPICommandCall->find( "service" )->second) != m_APIServiceManagers.end() )
+    std::map<std::string, APIServiceManager *>::iterator service = m_APIServiceManagers.find( pAPICommandCall->find( "service" )->second );
+    if( service != m_APIServiceManagers.end() )
     {
-        // Get reference to service manager object and call ProcessCall() with the pAPICommandCall packet
-        //m_xmlString = m_APIServiceManagers.find("base")->second->ProcessCall(pAPICommandCall);
-        m_xmlString = m_APIServiceManagers.find( pAPICommandCall->find( "service" )->second )->second->ProcessCall( pAPICommandCall );
-
-        // Convert the std::string to the std::vector<char>:
-        std::tr1::shared_ptr<std::vector<char> > ret = std::tr1::shared_ptr<std::vector<char> >(new std::vector<char>());
-        unsigned long len = m_xmlString->length();
-        for(size_t i=0; i<m_xmlString->length(); i++)
-            ret->push_back(m_xmlString->at(i));
-
-        return ret;
+        // Answer from the cache until the document's "cachedUntil" passes
+        const std::string descriptor = _BuildCacheDescriptor( pAPICommandCall );
+        APIXMLDocumentPtr xmlDoc;
+        if( !m_cache.CacheRetrieve( &descriptor, &xmlDoc ) )
+        {
+            // the managers keep the document being built, so they build one at a time
+            MutexLock lock( service->second->lock() );
+
+            // Get reference to service manager object and call ProcessCall() with the pAPICommandCall packet
+            xmlDoc = service->second->ProcessCall( pAPICommandCall );
+            m_cache.CacheDeposit( &descriptor, xmlDoc, service->second->GetCachedUntil() );
+        }
+
+        // the chunks are shared with the cache, not copied
+        return xmlDoc;
     }
     else
     {
-        // Service call not found, so return NULL:
-        return std::tr1::shared_ptr<std::vector<char> >(new std::vector<char>() );
-        //return NULL;
-        //m_xmlString = m_APIServiceManagers.find("base")->second->ProcessCall(pAPICommandCall);
+        // Service call not found, so return an empty document:
+        return APIXMLDocumentPtr( new APIXMLDocument() );
     }
 }
 
+std::string APIServer::_BuildCacheDescriptor(const APICommandCall * pAPICommandCall)
+{
+    // the call is sorted by parameter name already
+    std::string descriptor;
+
+    APICommandCall::const_iterator cur, end;
+    cur = pAPICommandCall->begin();
+    end = pAPICommandCall->end();
+    for(; cur != end; ++cur)
+    {
+        descriptor.append( cur->first.c_str(), cur->first.size() + 1 );
+        descriptor.append( cur->second.c_str(), cur->second.size() + 1 );
+    }
+
+    return descriptor;
+}
+
 std::string& APIServer::url()
 {
     return _url;
@@ -102,20 +123,43 @@ std::string& APIServer::url()
 
 void APIServer::Run()
 {
-    _ioThread = std::unique_ptr<boost::asio::detail::thread>(new boost::asio::detail::thread(std::tr1::bind(&APIServer::RunInternal, this)));
+    _io = std::unique_ptr<boost::asio::io_service>(new boost::asio::io_service());
+    _workerIo = std::unique_ptr<boost::asio::io_service>(new boost::asio::io_service());
+    _work = std::unique_ptr<boost::asio::io_service::work>(new boost::asio::io_service::work(*_workerIo));
+    _listener = std::unique_ptr<APIServerListener>(new APIServerListener(*_io));
+
+    const uint32 ioThreads = std::max<uint32>(sConfig.net.apiIoThreads, 1);
+    for (uint32 i = 0; i < ioThreads; i++)
+        _ioThreads.push_back(ThreadPtr(new boost::asio::detail::thread(std::tr1::bind(&APIServer::RunService, _io.get()))));
+
+    const uint32 workerThreads = std::max<uint32>(sConfig.net.apiWorkerThreads, 1);
+    for (uint32 i = 0; i < workerThreads; i++)
+        _workerThreads.push_back(ThreadPtr(new boost::asio::detail::thread(std::tr1::bind(&APIServer::RunService, _workerIo.get()))));
+
+    sLog.Log("api server", "%u I/O threads, %u worker threads", ioThreads, workerThreads);
 }
 
 void APIServer::Stop()
 {
+    if (!_io)
+        return;
+
     _io->stop();
-    _ioThread->join();
+    for (size_t i = 0; i < _ioThreads.size(); i++)
+        _ioThreads[i]->join();
+    _ioThreads.clear();
+
+    // let the workers finish the documents they are building
+    _work.reset();
+    _workerIo->stop();
+    for (size_t i = 0; i < _workerThreads.size(); i++)
+        _workerThreads[i]->join();
+    _workerThreads.clear();
 }
 
-void APIServer::RunInternal()
+void APIServer::RunService(boost::asio::io_service* io)
 {
-    _io = std::unique_ptr<boost::asio::io_service>(new boost::asio::io_service());
-    _listener = std::unique_ptr<APIServerListener>(new APIServerListener(*_io));
-    _io->run();
+    io->run();
 }
 
 APIServer::Lock::Lock(boost::asio::detail::mutex& mutex)
@@ -25,17 +25,28 @@
 
 #include "eve-server.h"
 
+#include "EVEServerConfig.h"
 #include "apiserver/APIServer.h"
 #include "apiserver/APIServerConnection.h"
 
-boost::asio::const_buffers_1 APIServerConnection::_responseOK = boost::asio::buffer("HTTP/1.0 200 OK\r\nContent-Type: text/xml\r\n\r\n", 43);
-                                                        // The last parameter must be exactly the # of chars in the string, otherwise
-                                                        // a browser will not recognize the xml structure and think the document is empty
-                                                        // if the size is larger than this string.
-//boost::asio::const_buffers_1 APIServerConnection::_responseNotFound = boost::asio::buffer("HTTP/1.0 404 - File or directory not found.\r\n\r\n", 26);
+/// Largest POST data block accepted (in bytes).
+static const size_t API_MAX_POST_DATA = 64 * 1024;
+
+/** @return Counter of the created connections. */
+static MetricCounter& ConnectionsMetric()
+{
+    static MetricCounter& metric = sMetrics.Counter( "evemu_api_connections_total", "Number of connections created by the API server." );
+    return metric;
+}
+/** @return Counter of the answered requests. */
+static MetricCounter& RequestsMetric()
+{
+    static MetricCounter& metric = sMetrics.Counter( "evemu_api_requests_total", "Number of requests answered by the API server." );
+    return metric;
+}
+
 boost::asio::const_buffers_1 APIServerConnection::_responseRedirectBegin = boost::asio::buffer("HTTP/1.0 301 Moved Permanently\r\nLocation: ", 42);
 boost::asio::const_buffers_1 APIServerConnection::_responseRedirectEnd = boost::asio::buffer("\r\n\r\n", 4);
-boost::asio::const_buffers_1 APIServerConnection::_responseNoContent = boost::asio::buffer("HTTP/1.0 204 No Content", 23);
 boost::asio::const_buffers_1 APIServerConnection::_responseNotFound = boost::asio::buffer(
 "<!DOCTYPE html PUBLIC \"-//W3C//DTD XHTML 1.0 Strict//EN\" \"http://www.w3.org/TR/xhtml1/DTD/xhtml1-strict.dtd\">"
 "<html xmlns=\"http://www.w3.org/1999/xhtml\">"
@@ -69,8 +80,13 @@ boost::asio::const_buffers_1 APIServerConnection::_responseNotFound = boost::asi
 , 1187);
 
 APIServerConnection::APIServerConnection(boost::asio::io_service& io)
-    : _socket(io)
+    : _keepAlive(false),
+      _contentLength(0),
+      _socket(io),
+      _strand(io),
+      _timer(io)
 {
+    ConnectionsMetric().Add();
 }
 
 boost::asio::ip::tcp::socket& APIServerConnection::socket()
@@ -80,54 +96,93 @@ boost::asio::ip::tcp::socket& APIServerConnection::socket()
 
 void APIServerConnection::Process()
 {
-    // receive all HTTP headers from the client
-    boost::asio::async_read_until(_socket, _buffer, "\r\n\r\n", std::tr1::bind(&APIServerConnection::ProcessHeaders, shared_from_this()));
+    // the client has this long to send the next request, or the first one
+    _timer.expires_from_now(boost::posix_time::seconds(sConfig.net.apiKeepAliveTimeout));
+    _timer.async_wait(_strand.wrap(std::tr1::bind(&APIServerConnection::IdleTimeout, shared_from_this(), std::tr1::placeholders::_1)));
+
+    // receive all HTTP headers from the client; a pipelined request may be in the buffer already
+    boost::asio::async_read_until(_socket, _buffer, "\r\n\r\n", _strand.wrap(std::tr1::bind(&APIServerConnection::ProcessHeaders, shared_from_this(), std::tr1::placeholders::_1, std::tr1::placeholders::_2)));
+}
+
+void APIServerConnection::IdleTimeout(const boost::system::error_code& error)
+{
+    // cancelled or re-armed since
+    if (error == boost::asio::error::operation_aborted || boost::asio::deadline_timer::traits_type::now() < _timer.expires_at())
+        return;
+
+    Close();
 }
 
-void APIServerConnection::ProcessHeaders()
+void APIServerConnection::ProcessHeaders(const boost::system::error_code& error, size_t bytes)
 {
-    std::istream stream(&_buffer);
-    std::string query;
+    _timer.cancel();
+
+    // the client closed the connection or went idle for too long
+    if (error)
+    {
+        Close();
+        return;
+    }
+
+    // take the headers of this request off the buffer; whatever follows is its POST data or the next request
+    std::string headers(boost::asio::buffers_begin(_buffer.data()), boost::asio::buffers_begin(_buffer.data()) + bytes);
+    _buffer.consume(bytes);
+
+    std::istringstream stream(headers);
     std::string request;
     std::string get_chk_str;
     std::string post_chk_str;
     int pos;
-    int parameterCount;
-    std::string param;
-    std::string value;
 
     // Clear API Command Call container:
     m_apiCommandCall.clear();
 
     // Get the first header line, every request line ends with "\r\n"
-    // GET /service/ServiceHandler.xml.aspx?param1=value&param2=value&param3=value HTTP/1.0\r\n
-    // POST /service/ServiceHandler.xml.aspx HTTP/1.0\r\n
+    // GET /service/ServiceHandler.xml.aspx?param1=value&param2=value&param3=value HTTP/1.1\r\n
+    // POST /service/ServiceHandler.xml.aspx HTTP/1.1\r\n
     std::getline(stream, request, '\r');
-    query = request;
+    _query = request;
+
+    // HTTP/1.1 keeps the connection open unless told otherwise, HTTP/1.0 closes it unless told otherwise
+    pos = request.find_last_of(' ');
+    _httpVersion = (pos == std::string::npos ? std::string() : request.substr(pos + 1));
+    if (_httpVersion != "HTTP/1.1")
+        _httpVersion = "HTTP/1.0";
+    _keepAlive = (_httpVersion == "HTTP/1.1");
+    _contentLength = 0;
+    ParseHeaderFields(stream);
 
     get_chk_str = request.substr(0,3);
     post_chk_str = request.substr(0,4);
 
     if (get_chk_str.compare("GET") == 0)
     {
-        sLog.Debug( "APIServerConnection::ProcessHeaders()", "RECEIVED new HTTP GET request..." );
+        _debug( "APIServerConnection::ProcessHeaders()", "RECEIVED new HTTP GET request..." );
 
         // Format of an HTTP GET query:
         // 0    5     10          20
-        // GET /service/ServiceHandler.xml.aspx?param1=value&param2=value&param3=value HTTP/1.0\r\n
+        // GET /service/ServiceHandler.xml.aspx?param1=value&param2=value&param3=value HTTP/1.1\r\n
         _http_cmd_str = get_chk_str;
 
         request = request.substr(4);    // Strip off the "GET " prefix
 
-        // Find first space at end of header, if there is one, and strip off the rest of the line, ie the " HTTP/1.0\r\n" string
+        // Find first space at end of header, if there is one, and strip off the rest of the line, ie the " HTTP/1.1\r\n" string
         int del = request.find_first_of(' ');
         if (del == std::string::npos)
         {
+            _keepAlive = false;
             NotFound();
             return;
         }
         request = request.substr(0,del);
 
+        // the metrics are scraped by Prometheus
+        if (request == "/metrics")
+        {
+            SendMetrics();
+            return;
+        }
+
         if (!starts_with(request, "/"))
         {
             NotFound();
@@ -142,72 +197,33 @@ void APIServerConnection::ProcessHeaders()
         pos = request.find_first_of('?');
         _service_handler = request.substr(0,pos);
         m_apiCommandCall.insert( std::pair<std::string, std::string>( "servicehandler", _service_handler ) );
-        request = request.substr(pos+1);
-
-        //// DUPLICATE
-        // Parse the query portion of the GET to a series of string pairs ("param", "value") from the URI
-        while( (pos = request.find_first_of('=')) >= 0 )
-        {
-            param = request.substr(0,pos);
-            std::transform(param.begin(), param.end(), param.begin(), tolower);
-            request = request.substr(pos+1);
-            pos = request.find_first_of('&');
-            if( pos < 0 )
-                value = request;
-            else
-            {
-                value = request.substr(0,pos);
-                request = request.substr(pos);
-                if( request.substr(0,5) == "&amp;" )  // Strip out "&amp;" encoded for "&"
-                    request = request.substr(5);
-                else
-                    request = request.substr(1);
-            }
-            m_apiCommandCall.insert( std::pair<std::string, std::string>( param, value ) );
-        }
-
-        _xmlData = sAPIServer.GetXML(&m_apiCommandCall);
-        if (!_xmlData)
-        {
-            sLog.Error("APIServerConnection::ProcessHeaders()", "Unknown or malformed EVEmu API HTTP CMD Received:\r\n%s\r\n", query.c_str());
-            NotFound();
-            return;
-        }
+        if (pos != std::string::npos)
+            ParseParameters(request.substr(pos+1));
 
-        // Print out to the Log with basic info on the API call and all parameters and their values parsed out
-        sLog.Debug("APIServerConnection::ProcessHeaders()", "HTTP %s CMD Received: Service: %s, Handler: %s", _http_cmd_str.c_str(), _service.c_str(), _service_handler.c_str());
-        APICommandCall::const_iterator cur, end;
-        cur = m_apiCommandCall.begin();
-        end = m_apiCommandCall.end();
-        for (int i=1; cur != end; cur++, i++)
-            sLog.Debug("        ", "%d: param = %s,  value = %s", i, cur->first.c_str(), cur->second.c_str() );
-
-        // first we have to send the responseOK, then our actual result
-        boost::asio::async_write(_socket, _responseOK, boost::asio::transfer_all(), std::tr1::bind(&APIServerConnection::SendXML, shared_from_this()));
-        //// DUPLICATE
+        QueueCall();
     }
     else if (post_chk_str.compare("POST") == 0)
     {
-        sLog.Debug( "APIServerConnection::ProcessHeaders()", "RECEIVED new HTTP POST request..." );
+        _debug( "APIServerConnection::ProcessHeaders()", "RECEIVED new HTTP POST request..." );
 
-        // Format of an HTTP GET query:
+        // Format of an HTTP POST query:
         //
-        // POST /service/ServiceHandler.xml.aspx HTTP/1.0\r\n
+        // POST /service/ServiceHandler.xml.aspx HTTP/1.1\r\n
         // Content-Type: application/x-www-form-urlencoded\r\n
         // Host: api.eve-online.com\r\n
         // Content-Length: 86\r\n
         // \r\n
-        // param1=value&param2=value&param3=value\r\n
-        // \r\n
+        // param1=value&param2=value&param3=value
 
         _http_cmd_str = post_chk_str;
 
         request = request.substr(5);    // Strip off the "POST " prefix
 
-        // Find first space at end of header, if there is one, and strip off the rest of the line, ie the " HTTP/1.0\r\n" string
+        // Find first space at end of header, if there is one, and strip off the rest of the line, ie the " HTTP/1.1\r\n" string
         int del = request.find_first_of(' ');
-        if (del == std::string::npos)
+        if (del == std::string::npos || API_MAX_POST_DATA < _contentLength)
         {
+            _keepAlive = false;
             NotFound();
             return;
         }
@@ -215,6 +231,7 @@ void APIServerConnection::ProcessHeaders()
 
         if (!starts_with(request, "/"))
         {
+            _keepAlive = false;
             NotFound();
             return;
         }
@@ -227,125 +244,60 @@ void APIServerConnection::ProcessHeaders()
         _service_handler = request;
         m_apiCommandCall.insert( std::pair<std::string, std::string>( "servicehandler", _service_handler ) );
 
-        // Read the integer after 'Content-Length:' and use that as the # of bytes in the next step
-        while( (request.substr( 0,15 ).compare( "Content-Length:" )) != 0 )
-        {
-            std::getline(stream, request, '\r');
-            request = request.substr(1);
-            query += request;
-        }
-        pos = request.find_first_of(' ');
-        request = request.substr( pos+1 );
-        uint32 postDataBytes = atoi( request.c_str() );
-        std::getline(stream, request, '\n');
-
-        sLog.Debug( "APIServerConnection::ProcessHeaders()", "    POST Content-Length = %u bytes", postDataBytes );
-
-        // Keep reading lines until we get past the next "\r\n" line (blank line):
-        while( request.compare( "\r" ) != 0 )
-        {
-            std::getline(stream, request, '\n');
-        }
+        _debug( "APIServerConnection::ProcessHeaders()", "    POST Content-Length = %u bytes", (uint32)_contentLength );
 
-        std::getline(stream, request, '\n');
-        pos = request.find_first_of('\r');
-        request = request.substr( 0,pos );
-
-        if( request.compare( "" ) != 0 )
-        {
-            // Decode the arguments of the POST data block here since asio did NOT stop reading past the first "\r\n\r\n"
-            //// DUPLICATE
-            // Parse the query portion of the GET to a series of string pairs ("param", "value") from the URI
-            sLog.Debug( "APIServerConnection::ProcessHeaders()", "POST data found in ProcessHeaders() !  Parsing..." );
-            parameterCount = 0;
-            while( (pos = request.find_first_of('=')) >= 0 )
-            {
-                parameterCount++;
-                param = request.substr(0,pos);
-                std::transform(param.begin(), param.end(), param.begin(), tolower);
-                request = request.substr(pos+1);
-                pos = request.find_first_of('&');
-                if( pos < 0 )
-                    value = request;
-                else
-                {
-                    value = request.substr(0,pos);
-                    request = request.substr(pos);
-                    if( request.substr(0,5) == "&amp;" )  // Strip out "&amp;" encoded for "&"
-                        request = request.substr(5);
-                    else
-                        request = request.substr(1);
-                }
-                m_apiCommandCall.insert( std::pair<std::string, std::string>( param, value ) );
-            }
-
-            // Did we somehow not detect a lack of POST data?  If so, and NO parameters were recovered, queue up the trigger for PostProcessHeaders():
-            if( parameterCount == 0 )
-            {
-                // Call boost::asio::async_read() and feed it the # of bytes from step 1) to get the POST data
-                // The 'CompleteCondition' for THIS boost::asio::async_read, a parameter that specifies when to stop reading,
-                // is transfer_exactly(contentLength), where contentLength is the # of bytes we just recovered from the "Content-Length" header
-                boost::asio::async_read(_socket, _postBuffer, boost::asio::transfer_exactly(postDataBytes), std::tr1::bind(&APIServerConnection::ProcessPostData, shared_from_this()));
-            }
-
-            _xmlData = sAPIServer.GetXML(&m_apiCommandCall);
-            if (!_xmlData)
-            {
-                sLog.Error("APIServerConnection::ProcessHeaders()", "Unknown or malformed EVEmu API HTTP CMD Received:\r\n%s\r\n", query.c_str());
-                NotFound();
-                return;
-            }
-
-            // Print out to the Log with basic info on the API call and all parameters and their values parsed out
-            sLog.Debug("APIServerConnection::ProcessHeaders()", "HTTP %s CMD Received: Service: %s, Handler: %s", _http_cmd_str.c_str(), _service.c_str(), _service_handler.c_str());
-            APICommandCall::const_iterator cur, end;
-            cur = m_apiCommandCall.begin();
-            end = m_apiCommandCall.end();
-            for (int i=1; cur != end; cur++, i++)
-                sLog.Debug("        ", "%d: param = %s,  value = %s", i, cur->first.c_str(), cur->second.c_str() );
-
-            // first we have to send the responseOK, then our actual result
-            boost::asio::async_write(_socket, _responseOK, boost::asio::transfer_all(), std::tr1::bind(&APIServerConnection::SendXML, shared_from_this()));
-            //// DUPLICATE
-        }
+        // asio may have read the POST data along with the headers already
+        if (_contentLength <= _buffer.size())
+            ProcessPostData(boost::system::error_code());
         else
-        {
-            // Call boost::asio::async_read() and feed it the # of bytes from step 1) to get the POST data
-            // The 'CompleteCondition' for THIS boost::asio::async_read, a parameter that specifies when to stop reading,
-            // is transfer_exactly(contentLength), where contentLength is the # of bytes we just recovered from the "Content-Length" header
-            boost::asio::async_read(_socket, _postBuffer, boost::asio::transfer_exactly(postDataBytes), std::tr1::bind(&APIServerConnection::ProcessPostData, shared_from_this()));
-        }
+            boost::asio::async_read(_socket, _buffer, boost::asio::transfer_at_least(_contentLength - _buffer.size()), _strand.wrap(std::tr1::bind(&APIServerConnection::ProcessPostData, shared_from_this(), std::tr1::placeholders::_1)));
     }
     else
     {
+        _keepAlive = false;
         NotFound();
         return;
     }
 }
 
-void APIServerConnection::ProcessPostData()
+void APIServerConnection::ParseHeaderFields(std::istream& stream)
 {
-    std::istream stream(&_postBuffer);
-    std::string query;
-    std::string request;
-    int pos;
-    std::string param;
-    std::string value;
+    std::string line;
+    while (std::getline(stream, line))
+    {
+        if (!line.empty() && line[line.size() - 1] == '\r')
+            line.erase(line.size() - 1);
 
-    std::getline(stream, request, '\r');
+        const size_t colon = line.find(':');
+        if (colon == std::string::npos)
+            continue;
 
-    // Check for empty POST data block, and if empty, return without sending anything back:
-    if( request.compare( "" ) == 0 )
-    {
-        sLog.Error("APIServerConnection::ProcessPostData()", "POST data block is COMPLETELY EMPTY!!" );
-        boost::asio::async_write(_socket, _responseNoContent, boost::asio::transfer_all(), std::tr1::bind(&APIServerConnection::Close, shared_from_this()));
-        //NotFound();
-        return;
+        std::string name = line.substr(0, colon);
+        std::transform(name.begin(), name.end(), name.begin(), tolower);
+
+        const size_t start = line.find_first_not_of(' ', colon + 1);
+        std::string value = (start == std::string::npos ? std::string() : line.substr(start));
+        std::transform(value.begin(), value.end(), value.begin(), tolower);
+
+        if (name == "connection")
+        {
+            if (value == "close")
+                _keepAlive = false;
+            else if (value == "keep-alive")
+                _keepAlive = true;
+        }
+        else if (name == "content-length")
+            _contentLength = strtoul(value.c_str(), NULL, 10);
     }
+}
 
-    _http_cmd_str += request;
+void APIServerConnection::ParseParameters(std::string request)
+{
+    int pos;
+    std::string param;
+    std::string value;
 
-    // Parse the data portion of the POST to a series of string pairs ("param", "value") from the URI
+    // Parse the query portion of the GET or the POST data to a series of string pairs ("param", "value")
     while( (pos = request.find_first_of('=')) >= 0 )
     {
         param = request.substr(0,pos);
@@ -365,40 +317,131 @@ void APIServerConnection::ProcessPostData()
         }
         m_apiCommandCall.insert( std::pair<std::string, std::string>( param, value ) );
     }
+}
+
+void APIServerConnection::ProcessPostData(const boost::system::error_code& error)
+{
+    if (error)
+    {
+        Close();
+        return;
+    }
+
+    // take the POST data off the buffer, leaving the next request there
+    std::string request(boost::asio::buffers_begin(_buffer.data()), boost::asio::buffers_begin(_buffer.data()) + _contentLength);
+    _buffer.consume(_contentLength);
 
+    request = request.substr(0, request.find_first_of("\r\n"));
+
+    // Check for empty POST data block, and if empty, return without sending anything back:
+    if( request.compare( "" ) == 0 )
+    {
+        sLog.Error("APIServerConnection::ProcessPostData()", "POST data block is COMPLETELY EMPTY!!" );
+        SendResponse("204 No Content", NULL, boost::asio::const_buffer());
+        return;
+    }
+
+    _http_cmd_str += request;
+
+    ParseParameters(request);
+
+    QueueCall();
+}
+
+void APIServerConnection::QueueCall()
+{
+    // building the document may take a while, which must not hold up the I/O threads
+    sAPIServer.workers().post(std::tr1::bind(&APIServerConnection::BuildXML, shared_from_this()));
+}
+
+void APIServerConnection::BuildXML()
+{
     _xmlData = sAPIServer.GetXML(&m_apiCommandCall);
     if (!_xmlData)
     {
-        sLog.Error("APIServerConnection::ProcessPostData()", "Unknown or malformed EVEmu API HTTP CMD Received:\r\n%s\r\n", query.c_str());
+        sLog.Error("APIServerConnection::BuildXML()", "Unknown or malformed EVEmu API HTTP CMD Received:\r\n%s\r\n", _query.c_str());
         NotFound();
         return;
     }
 
     // Print out to the Log with basic info on the API call and all parameters and their values parsed out
-    sLog.Debug("APIServerConnection::ProcessPostData()", "HTTP %s CMD Received: Service: %s, Handler: %s", _http_cmd_str.c_str(), _service.c_str(), _service_handler.c_str());
+    _debug("APIServerConnection::BuildXML()", "HTTP %s CMD Received: Service: %s, Handler: %s", _http_cmd_str.c_str(), _service.c_str(), _service_handler.c_str());
     APICommandCall::const_iterator cur, end;
     cur = m_apiCommandCall.begin();
     end = m_apiCommandCall.end();
     for (int i=1; cur != end; cur++, i++)
-        sLog.Debug("        ", "%d: param = %s,  value = %s", i, cur->first.c_str(), cur->second.c_str() );
+        _debug("        ", "%d: param = %s,  value = %s", i, cur->first.c_str(), cur->second.c_str() );
+
+    // gather the chunks of the document into one write
+    std::vector<boost::asio::const_buffer> body;
+    body.reserve(_xmlData->chunks().size());
+    for (size_t i = 0; i < _xmlData->chunks().size(); i++)
+        body.push_back(boost::asio::buffer(*_xmlData->chunks()[i]));
 
-    // first we have to send the responseOK, then our actual result
-    boost::asio::async_write(_socket, _responseOK, boost::asio::transfer_all(), std::tr1::bind(&APIServerConnection::SendXML, shared_from_this()));
+    SendResponse("200 OK", "text/xml", body);
 }
 
-void APIServerConnection::SendXML()
+void APIServerConnection::SendMetrics()
 {
-    boost::asio::async_write(_socket, boost::asio::buffer(*_xmlData, _xmlData->size()), boost::asio::transfer_all(), std::tr1::bind(&APIServerConnection::Close, shared_from_this()));
+    _body.clear();
+    sMetrics.Render(_body);
+
+    SendResponse("200 OK", "text/plain; version=0.0.4", boost::asio::buffer(_body));
 }
 
 void APIServerConnection::NotFound()
 {
-    boost::asio::async_write(_socket, _responseNotFound, boost::asio::transfer_all(), std::tr1::bind(&APIServerConnection::Close, shared_from_this()));
+    SendResponse("404 Not Found", "text/html", _responseNotFound);
+}
+
+void APIServerConnection::SendResponse(const char* status, const char* contentType, const boost::asio::const_buffer& body)
+{
+    SendResponse(status, contentType, std::vector<boost::asio::const_buffer>(1, body));
+}
+
+void APIServerConnection::SendResponse(const char* status, const char* contentType, const std::vector<boost::asio::const_buffer>& body)
+{
+    RequestsMetric().Add();
+
+    // the Content-Length lets the client find the end of the response on a kept connection
+    std::stringstream header;
+    header << _httpVersion << " " << status << "\r\n";
+    if (contentType != NULL)
+        header << "Content-Type: " << contentType << "\r\n";
+    header << "Content-Length: " << boost::asio::buffer_size(body) << "\r\n"
+              "Connection: " << (_keepAlive ? "keep-alive" : "close") << "\r\n"
+              "\r\n";
+    _header = header.str();
+
+    std::vector<boost::asio::const_buffer> buffers;
+    buffers.reserve(body.size() + 1);
+    buffers.push_back(boost::asio::buffer(_header));
+    buffers.insert(buffers.end(), body.begin(), body.end());
+    boost::asio::async_write(_socket, buffers, boost::asio::transfer_all(), _strand.wrap(std::tr1::bind(&APIServerConnection::FinishRequest, shared_from_this(), std::tr1::placeholders::_1)));
+}
+
+void APIServerConnection::FinishRequest(const boost::system::error_code& error)
+{
+    if (error || !_keepAlive)
+    {
+        Close();
+        return;
+    }
+
+    // forget this request and wait for the next one
+    _service.clear();
+    _service_handler.clear();
+    _http_cmd_str.clear();
+    m_apiCommandCall.clear();
+    _xmlData.reset();
+    _body.clear();
+
+    Process();
 }
 
 void APIServerConnection::Redirect()
 {
-    boost::asio::async_write(_socket, _responseRedirectBegin, boost::asio::transfer_all(), std::tr1::bind(&APIServerConnection::RedirectLocation, shared_from_this()));
+    boost::asio::async_write(_socket, _responseRedirectBegin, boost::asio::transfer_all(), _strand.wrap(std::tr1::bind(&APIServerConnection::RedirectLocation, shared_from_this())));
 }
 
 void APIServerConnection::RedirectLocation()
@@ -407,17 +450,19 @@ void APIServerConnection::RedirectLocation()
     std::stringstream url;
     url << APIServer::FallbackURL << _service;// << "/" << _id;
     _redirectUrl = url.str();
-    boost::asio::async_write(_socket, boost::asio::buffer(_redirectUrl), boost::asio::transfer_all(), std::tr1::bind(&APIServerConnection::RedirectFinalize, shared_from_this()));
+    boost::asio::async_write(_socket, boost::asio::buffer(_redirectUrl), boost::asio::transfer_all(), _strand.wrap(std::tr1::bind(&APIServerConnection::RedirectFinalize, shared_from_this())));
 }
 
 void APIServerConnection::RedirectFinalize()
 {
-    boost::asio::async_write(_socket, _responseRedirectEnd, boost::asio::transfer_all(), std::tr1::bind(&APIServerConnection::Close, shared_from_this()));
+    boost::asio::async_write(_socket, _responseRedirectEnd, boost::asio::transfer_all(), _strand.wrap(std::tr1::bind(&APIServerConnection::Close, shared_from_this())));
 }
 
 void APIServerConnection::Close()
 {
-    _socket.close();
+    boost::system::error_code ignored;
+    _timer.cancel(ignored);
+    _socket.close(ignored);
 }
 
 bool APIServerConnection::starts_with(std::string& haystack, const char *const needle)
@@ -33,14 +33,14 @@ APIServerManager::APIServerManager(const PyServiceMgr &services)
 {
 }
 
-std::tr1::shared_ptr<std::string> APIServerManager::ProcessCall(const APICommandCall * pAPICommandCall)
+APIXMLDocumentPtr APIServerManager::ProcessCall(const APICommandCall * pAPICommandCall)
 {
-    sLog.Debug("APIServerManager::ProcessCall()", "EVEmu API - Server Service Manager");
+    _debug("APIServerManager::ProcessCall()", "EVEmu API - Server Service Manager");
 
     if( pAPICommandCall->find( "servicehandler" ) == pAPICommandCall->end() )
     {
         sLog.Error( "APIServerManager::ProcessCall()", "Cannot find 'servicehandler' specifier in pAPICommandCall packet" );
-        return std::tr1::shared_ptr<std::string>(new std::string(""));
+        return APIXMLDocumentPtr(new APIXMLDocument());
     }
 
     if( pAPICommandCall->find( "servicehandler" )->second == "ServerStatus.xml.aspx" )
@@ -51,11 +51,11 @@ std::tr1::shared_ptr<std::string> APIServerManager::ProcessCall(const APICommand
     {
         sLog.Error("APIServerManager::ProcessCall()", "EVEmu API - Server Service Manager - ERROR: Cannot resolve '%s' as a valid service query for Server Service Manager",
             pAPICommandCall->find("servicehandler")->second.c_str() );
-        return std::tr1::shared_ptr<std::string>(new std::string(""));
+        return APIXMLDocumentPtr(new APIXMLDocument());
     }
 }
 
-std::tr1::shared_ptr<std::string> APIServerManager::_ServerStatus(const APICommandCall * pAPICommandCall)
+APIXMLDocumentPtr APIServerManager::_ServerStatus(const APICommandCall * pAPICommandCall)
 {
     uint32 playersOnline = services().entity_list.GetClientCount();
     std::string playersOnlineStr( itoa( playersOnline ) );
@@ -71,5 +71,5 @@ std::tr1::shared_ptr<std::string> APIServerManager::_ServerStatus(const APIComma
     }
     _CloseXMLHeader( EVEAPI::CacheStyles::Modified );
 
-    return _GetXMLDocumentString();
+    return _GetXMLDocument();
 }
@@ -36,7 +36,7 @@ bool APIServiceDB::GetAccountIdFromUsername(std::string username, std::string *
     DBQueryResult res;
 
     // Find accountID in 'account' table using accountName:
-    if( !sDatabase.RunQuery(res,
+    if( !sDatabase.RunReadQuery(res,
         "SELECT"
         "    accountID "
         " FROM account "
@@ -62,7 +62,7 @@ bool APIServiceDB::GetAccountIdFromUserID(std::string userID, uint32 * accountID
     DBQueryResult res;
 
     // Find accountID in 'accountapi' table using userID:
-    if( !sDatabase.RunQuery(res,
+    if( !sDatabase.RunReadQuery(res,
         "SELECT"
         "    accountID "
         " FROM accountApi "
@@ -89,7 +89,7 @@ bool APIServiceDB::GetApiAccountInfoUsingAccountID(std::string accountID, uint32
     DBQueryResult res;
 
     // Find userID, fullKey, limitedKey, and apiRole from 'accountApi' table using accountID obtained from 'account' table:
-    if( !sDatabase.RunQuery(res,
+    if( !sDatabase.RunReadQuery(res,
         "SELECT"
         "    userID, fullKey, limitedKey, apiRole "
         " FROM accountApi "
@@ -118,7 +118,7 @@ bool APIServiceDB::GetApiAccountInfoUsingUserID(std::string userID, std::string
     DBQueryResult res;
 
     // Find fullKey, limitedKey, and apiRole from 'accountApi' table using userID supplied from an API query string:
-    if( !sDatabase.RunQuery(res,
+    if( !sDatabase.RunReadQuery(res,
         "SELECT"
         "    fullKey, limitedKey, apiRole "
         " FROM accountApi "
@@ -30,14 +30,12 @@
 APIServiceManager::APIServiceManager(const PyServiceMgr &services)
 : m_services(services)
 {
-    _pXmlDocOuterTag = NULL;
-    _pXmlElementStack = NULL;
-    _CurrentRowSetColumnString = "";
+    _CachedUntil = 0;
 }
 
-std::tr1::shared_ptr<std::string> APIServiceManager::ProcessCall(const APICommandCall * pAPICommandCall)
+APIXMLDocumentPtr APIServiceManager::ProcessCall(const APICommandCall * pAPICommandCall)
 {
-    sLog.Debug("APIServiceManager::ProcessCall()", "EVEmu API - Default Service Manager");
+    _debug("APIServiceManager::ProcessCall()", "EVEmu API - Default Service Manager");
 
     // EXAMPLE OF USING ALL FEATURES OF THE INHERITED APISERVICEMANAGER XML BUILDING HELPER FUNCTIONS:
     /*
@@ -125,10 +123,10 @@ std::tr1::shared_ptr<std::string> APIServiceManager::ProcessCall(const APIComman
     }
     _CloseXMLHeader( EVEAPI::CacheStyles::Modified );
 
-    return _GetXMLDocumentString();
+    return _GetXMLDocument();
 }
 
-std::tr1::shared_ptr<std::string> APIServiceManager::BuildErrorXMLResponse(std::string errorCode, std::string errorMessage)
+APIXMLDocumentPtr APIServiceManager::BuildErrorXMLResponse(std::string errorCode, std::string errorMessage)
 {
     _BuildXMLHeader();
     {
@@ -136,7 +134,7 @@ std::tr1::shared_ptr<std::string> APIServiceManager::BuildErrorXMLResponse(std::
     }
     _CloseXMLHeader( EVEAPI::CacheStyles::Modified );
 
-    return _GetXMLDocumentString();
+    return _GetXMLDocument();
 }
 
 bool APIServiceManager::_AuthenticateUserNamePassword(std::string username, std::string password)
@@ -187,26 +185,14 @@ bool APIServiceManager::_AuthenticateLimitedAPIQuery(std::string userID, std::st
 
 void APIServiceManager::_BuildXMLHeader()
 {
-    // Build header at beginning of XML document, so clear existing xml document
-    _XmlDoc.Clear();
-    // object pointed to by '_pXmlDocOuterTag' is automatically deleted by the TinyXML system with the above call
-    if( _pXmlElementStack != NULL )
-    {
-        delete _pXmlElementStack;
-        _pXmlElementStack = NULL;
-    }
-    _pXmlElementStack = new std::stack<TiXmlElement *>();
+    // Build header at beginning of XML document, so discard the document being built
+    _XmlWriter.Start();
+    _CachedUntil = 0;
 
-    TiXmlDeclaration * decl = new TiXmlDeclaration( "1.0", "UTF-8", "" );
-    _XmlDoc.LinkEndChild( decl );
+    _XmlWriter.StartElement( "eveapi" );
+    _XmlWriter.Attribute( "version", "2" );
 
-    _pXmlDocOuterTag = new TiXmlElement( "eveapi" );
-    _XmlDoc.LinkEndChild( _pXmlDocOuterTag );
-    _pXmlDocOuterTag->SetAttribute( "version", "2" );
-
-    TiXmlElement * currentTime = new TiXmlElement( "currentTime" );
-    currentTime->LinkEndChild( new TiXmlText( Win32TimeToString(Win32TimeNow()).c_str() ));
-    _pXmlDocOuterTag->LinkEndChild( currentTime );
+    _XmlWriter.Element( "currentTime", Win32TimeToString(Win32TimeNow()).c_str() );
 }
 
 void APIServiceManager::_CloseXMLHeader(uint32 cacheStyle)
@@ -215,38 +201,42 @@ void APIServiceManager::_CloseXMLHeader(uint32 cacheStyle)
     {
         case EVEAPI::CacheStyles::Long:
             // 2 hour cache timer
-            _BuildSingleXMLTag( "cachedUntil", Win32TimeToString(Win32TimeNow() + 120*Win32Time_Minute).c_str() );
+            _CachedUntil = Win32TimeNow() + 120*Win32Time_Minute;
             break;
         case EVEAPI::CacheStyles::Short:
             // 5 minute cache timer
-            _BuildSingleXMLTag( "cachedUntil", Win32TimeToString(Win32TimeNow() + 5*Win32Time_Minute).c_str() );
+            _CachedUntil = Win32TimeNow() + 5*Win32Time_Minute;
             break;
         case EVEAPI::CacheStyles::Modified:
             // 15 minute cache timer
-            _BuildSingleXMLTag( "cachedUntil", Win32TimeToString(Win32TimeNow() + 15*Win32Time_Minute).c_str() );
+            _CachedUntil = Win32TimeNow() + 15*Win32Time_Minute;
             break;
+        default:
+            return;
     }
+
+    _BuildSingleXMLTag( "cachedUntil", Win32TimeToString(_CachedUntil).c_str() );
 }
 
 void APIServiceManager::_BuildXMLRowSet(std::string name, std::string key, const std::vector<std::string> * columns)
 {
-    TiXmlElement * rowset = new TiXmlElement( "rowset" );
+    _CurrentRowSetColumns = *columns;
 
+    std::string columnString;
     std::vector<std::string>::const_iterator current, end;
-    rowset->SetAttribute( "name", name.c_str() );
-    rowset->SetAttribute( "key", key.c_str() );
     current = columns->begin();
     end = columns->end();
-    _CurrentRowSetColumnString = *current;
-    ++current;
     for(; current != end; ++current)
     {
-        _CurrentRowSetColumnString += ",";
-        _CurrentRowSetColumnString += *current;
+        if( !columnString.empty() )
+            columnString += ",";
+        columnString += *current;
     }
-    rowset->SetAttribute( "columns", _CurrentRowSetColumnString.c_str() );
 
-    _pXmlElementStack->push( rowset );
+    _XmlWriter.StartElement( "rowset" );
+    _XmlWriter.Attribute( "name", name.c_str() );
+    _XmlWriter.Attribute( "key", key.c_str() );
+    _XmlWriter.Attribute( "columns", columnString.c_str() );
 }
 
 void APIServiceManager::_CloseXMLRowSet()
@@ -256,94 +246,76 @@ void APIServiceManager::_CloseXMLRowSet()
 
 void APIServiceManager::_BuildXMLRow(const std::vector<std::string> * columns)
 {
-    TiXmlElement * row = new TiXmlElement( "row" );
+    _XmlWriter.StartElement( "row" );
 
-    std::vector<std::string>::const_iterator current, end;
-    std::string column_string = _CurrentRowSetColumnString;
-    std::string column_name;
-    int pos=0;
-    int pos2=0;
-    current = columns->begin();
-    end = columns->end();
-    for(; current != end; ++current)
+    const size_t count = std::min( columns->size(), _CurrentRowSetColumns.size() );
+    for(size_t i = 0; i < count; ++i)
+        _XmlWriter.Attribute( _CurrentRowSetColumns[ i ].c_str(), columns->at( i ).c_str() );
+
+    _XmlWriter.EndElement();
+}
+
+void APIServiceManager::_BuildXMLRows(DBQueryResult& res)
+{
+    const size_t count = std::min<size_t>( res.ColumnCount(), _CurrentRowSetColumns.size() );
+
+    DBResultRow row;
+    while( res.GetRow( row ) )
     {
-        pos = column_string.find_first_of(",");
-        column_name = column_string.substr(0,pos);
-        column_string = column_string.substr(pos+1);
-        row->SetAttribute( column_name.c_str(), current->c_str() );
+        _XmlWriter.StartElement( "row" );
+
+        for(size_t i = 0; i < count; ++i)
+            _XmlWriter.Attribute( _CurrentRowSetColumns[ i ].c_str(), row.IsNull( i ) ? "" : row.GetText( i ) );
+
+        _XmlWriter.EndElement();
     }
-    _pXmlElementStack->top()->LinkEndChild( row );
 }
 
 void APIServiceManager::_BuildXMLTag(std::string name)
 {
-    TiXmlElement * tag = new TiXmlElement( name.c_str() );
-    _pXmlElementStack->push( tag );
+    _XmlWriter.StartElement( name.c_str() );
 }
 
 void APIServiceManager::_BuildXMLTag(std::string name, const std::vector<std::pair<std::string, std::string> > * params)
 {
-    TiXmlElement * tag = new TiXmlElement( name.c_str() );
+    _XmlWriter.StartElement( name.c_str() );
 
     std::vector<std::pair<std::string, std::string> >::const_iterator current, end;
     current = params->begin();
     end = params->end();
     for(; current != end; ++current)
-        tag->SetAttribute( current->first.c_str(), current->second.c_str() );
-
-    _pXmlElementStack->push( tag );
+        _XmlWriter.Attribute( current->first.c_str(), current->second.c_str() );
 }
 
 void APIServiceManager::_BuildXMLTag(std::string name, const std::vector<std::pair<std::string, std::string> > * params, std::string value)
 {
     _BuildXMLTag( name, params );
-    _pXmlElementStack->top()->LinkEndChild( new TiXmlText( value.c_str() ));
+    _XmlWriter.Text( value.c_str() );
 }
 
 void APIServiceManager::_BuildSingleXMLTag(std::string name, std::string value)
 {
-    TiXmlElement * tag = new TiXmlElement( name.c_str() );
-    tag->LinkEndChild( new TiXmlText( value.c_str() ));
-
-    if( _pXmlElementStack->empty() )
-        _pXmlDocOuterTag->LinkEndChild( tag );
-    else
-        _pXmlElementStack->top()->LinkEndChild( tag );
+    _XmlWriter.Element( name.c_str(), value.c_str() );
 }
 
 void APIServiceManager::_BuildErrorXMLTag(std::string code, std::string param)
 {
-    TiXmlElement * error = new TiXmlElement( "error" );
-    error->SetAttribute( "code", code.c_str() );
-    error->LinkEndChild( new TiXmlText( param.c_str() ));
-
-    if( _pXmlElementStack->empty() )
-        _pXmlDocOuterTag->LinkEndChild( error );
-    else
-        _pXmlElementStack->top()->LinkEndChild( error );
+    _XmlWriter.StartElement( "error" );
+    _XmlWriter.Attribute( "code", code.c_str() );
+    _XmlWriter.Text( param.c_str() );
+    _XmlWriter.EndElement();
 }
 
 void APIServiceManager::_CloseXMLTag()
 {
-    if( _pXmlElementStack->empty() )
+    // the outer "eveapi" tag is closed with the document
+    if( _XmlWriter.depth() <= 1 )
         return;
 
-    TiXmlElement * _pTopElement = _pXmlElementStack->top();
-    _pXmlElementStack->pop();
-
-    if( _pXmlElementStack->empty() )
-        _pXmlDocOuterTag->LinkEndChild( _pTopElement );
-    else
-    {
-        TiXmlElement * _pNextTopElement = _pXmlElementStack->top();
-        _pNextTopElement->LinkEndChild( _pTopElement );
-    }
+    _XmlWriter.EndElement();
 }
 
-std::tr1::shared_ptr<std::string> APIServiceManager::_GetXMLDocumentString()
+APIXMLDocumentPtr APIServiceManager::_GetXMLDocument()
 {
-    TiXmlPrinter xmlPrinter;
-    _XmlDoc.Accept( &xmlPrinter );
-
-    return std::tr1::shared_ptr<std::string>(new std::string(xmlPrinter.CStr()));
+    return _XmlWriter.Finish();
 }
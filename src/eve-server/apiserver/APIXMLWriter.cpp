@@ -0,0 +1,206 @@
+/*
+    ------------------------------------------------------------------------------------
+    LICENSE:
+    ------------------------------------------------------------------------------------
+    This file is part of EVEmu: EVE Online Server Emulator
+    Copyright 2006 - 2011 The EVEmu Team
+    For the latest information visit http://evemu.org
+    ------------------------------------------------------------------------------------
+    This program is free software; you can redistribute it and/or modify it under
+    the terms of the GNU Lesser General Public License as published by the Free Software
+    Foundation; either version 2 of the License, or (at your option) any later
+    version.
+
+    This program is distributed in the hope that it will be useful, but WITHOUT
+    ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+    FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public License along with
+    this program; if not, write to the Free Software Foundation, Inc., 59 Temple
+    Place - Suite 330, Boston, MA 02111-1307, USA, or go to
+    http://www.gnu.org/copyleft/lesser.txt.
+    ------------------------------------------------------------------------------------
+    Author:     EVEmu Team
+*/
+
+#include "eve-server.h"
+
+#include "apiserver/APIXMLWriter.h"
+
+APIXMLWriter::APIXMLWriter()
+: mStartTagOpen(false),
+  mAtLineStart(true)
+{
+    Start();
+}
+
+void APIXMLWriter::Start()
+{
+    mDocument.reset(new APIXMLDocument());
+    mChunk.clear();
+    mChunk.reserve(CHUNK_SIZE);
+    mOpen.clear();
+    mStartTagOpen = false;
+    mAtLineStart = true;
+
+    _Append("<?xml version=\"1.0\" encoding=\"UTF-8\" ?>\n");
+}
+
+void APIXMLWriter::StartElement(const char* name)
+{
+    _CloseStartTag();
+    if( !mOpen.empty() )
+        mOpen.back().children = true;
+
+    _NewLine(mOpen.size());
+    _Append("<");
+    _Append(name);
+
+    mOpen.push_back(Open());
+    mOpen.back().name = name;
+    mOpen.back().children = false;
+    mStartTagOpen = true;
+}
+
+void APIXMLWriter::Attribute(const char* name, const char* value)
+{
+    if( !mStartTagOpen )
+        return;
+
+    _Append(" ");
+    _Append(name);
+    _Append("=\"");
+    _AppendEscaped(value);
+    _Append("\"");
+}
+
+void APIXMLWriter::Text(const char* text)
+{
+    _CloseStartTag();
+    _AppendEscaped(text);
+    mAtLineStart = false;
+}
+
+void APIXMLWriter::EndElement()
+{
+    if( mOpen.empty() )
+        return;
+
+    const Open& top = mOpen.back();
+    if( mStartTagOpen )
+    {
+        _Append(" />");
+        mStartTagOpen = false;
+    }
+    else
+    {
+        if( top.children )
+            _NewLine(mOpen.size() - 1);
+        _Append("</");
+        _Append(top.name.c_str(), top.name.size());
+        _Append(">");
+    }
+    _Append("\n");
+    mAtLineStart = true;
+
+    mOpen.pop_back();
+}
+
+APIXMLDocumentPtr APIXMLWriter::Finish()
+{
+    while( !mOpen.empty() )
+        EndElement();
+    _Flush();
+
+    APIXMLDocumentPtr document = mDocument;
+    mDocument.reset(new APIXMLDocument());
+    return document;
+}
+
+void APIXMLWriter::_CloseStartTag()
+{
+    if( !mStartTagOpen )
+        return;
+
+    _Append(">");
+    mStartTagOpen = false;
+    mAtLineStart = false;
+}
+
+void APIXMLWriter::_NewLine(size_t depth)
+{
+    static const char indent[] = "                                ";
+    static const size_t indentSize = sizeof(indent) - 1;
+
+    if( !mAtLineStart )
+        _Append("\n");
+
+    for( size_t spaces = depth * 4; 0 < spaces; )
+    {
+        const size_t length = std::min(spaces, indentSize);
+        _Append(indent, length);
+        spaces -= length;
+    }
+}
+
+void APIXMLWriter::_Append(const char* data, size_t length)
+{
+    while( 0 < length )
+    {
+        const size_t room = CHUNK_SIZE - mChunk.size();
+        if( 0 == room )
+        {
+            _Flush();
+            continue;
+        }
+
+        const size_t part = std::min(room, length);
+        mChunk.append(data, part);
+        data += part;
+        length -= part;
+    }
+}
+
+void APIXMLWriter::_AppendEscaped(const char* str)
+{
+    // copy the runs which need no escaping in one go
+    const char* run = str;
+    for( ; *str != '\0'; ++str )
+    {
+        const char* entity;
+        char code[ 8 ];
+        switch( *str )
+        {
+            case '&':  entity = "&amp;";  break;
+            case '<':  entity = "&lt;";   break;
+            case '>':  entity = "&gt;";   break;
+            case '"':  entity = "&quot;"; break;
+            case '\'': entity = "&apos;"; break;
+            default:
+                if( (unsigned char)*str >= 32 )
+                    continue;
+
+                snprintf(code, sizeof(code), "&#x%02X;", (unsigned char)*str);
+                entity = code;
+                break;
+        }
+
+        _Append(run, str - run);
+        _Append(entity);
+        run = str + 1;
+    }
+    _Append(run, str - run);
+}
+
+void APIXMLWriter::_Flush()
+{
+    if( mChunk.empty() )
+        return;
+
+    // hand the filled chunk over without copying it
+    std::string* chunk = new std::string();
+    chunk->swap(mChunk);
+    mDocument->Append(APIXMLDocument::Chunk(chunk));
+
+    mChunk.reserve(CHUNK_SIZE);
+}
@@ -0,0 +1,213 @@
+/*
+    ------------------------------------------------------------------------------------
+    LICENSE:
+    ------------------------------------------------------------------------------------
+    This file is part of EVEmu: EVE Online Server Emulator
+    Copyright 2006 - 2011 The EVEmu Team
+    For the latest information visit http://evemu.org
+    ------------------------------------------------------------------------------------
+    This program is free software; you can redistribute it and/or modify it under
+    the terms of the GNU Lesser General Public License as published by the Free Software
+    Foundation; either version 2 of the License, or (at your option) any later
+    version.
+
+    This program is distributed in the hope that it will be useful, but WITHOUT
+    ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+    FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public License along with
+    this program; if not, write to the Free Software Foundation, Inc., 59 Temple
+    Place - Suite 330, Boston, MA 02111-1307, USA, or go to
+    http://www.gnu.org/copyleft/lesser.txt.
+    ------------------------------------------------------------------------------------
+    Author:     EVEmu Team
+*/
+
+#include "eve-server.h"
+
+#include "cache/BulkDataVersions.h"
+
+/*
+ * The file is a list of lines:
+ *   change <changeID> <hash>   starts a change, oldest first
+ *   object <objectID>          an object changed by the change above
+ *   version <version> <objectID> the current version of an object
+ */
+static const char BULK_CHANGE_TAG[] = "change";
+static const char BULK_OBJECT_TAG[] = "object";
+static const char BULK_VERSION_TAG[] = "version";
+
+BulkDataVersions::BulkDataVersions()
+{
+}
+
+uint32 BulkDataVersions::GetChangeID() const
+{
+    return m_changes.empty() ? 0 : m_changes.back().changeID;
+}
+
+std::string BulkDataVersions::GetHash() const
+{
+    return m_changes.empty() ? std::string() : m_changes.back().hash;
+}
+
+bool BulkDataVersions::Load(const std::string &filename)
+{
+    m_changes.clear();
+    m_versions.clear();
+
+    FILE *f = fopen(filename.c_str(), "r");
+    if(f == NULL)
+        return false;
+
+    char line[512];
+    while(fgets(line, sizeof(line), f) != NULL) {
+        // strip the newline
+        line[strcspn(line, "\r\n")] = '\0';
+
+        char *value = strchr(line, ' ');
+        if(value == NULL)
+            continue;
+        *value++ = '\0';
+
+        if(0 == strcmp(line, BULK_CHANGE_TAG)) {
+            Change change;
+            char hash[64];
+            if(2 != sscanf(value, "%u %63s", &change.changeID, hash))
+                continue;
+            change.hash = hash;
+            m_changes.push_back(change);
+        } else if(0 == strcmp(line, BULK_OBJECT_TAG)) {
+            if(!m_changes.empty())
+                m_changes.back().objects.insert(value);
+        } else if(0 == strcmp(line, BULK_VERSION_TAG)) {
+            char *objectID = strchr(value, ' ');
+            if(objectID == NULL)
+                continue;
+            *objectID++ = '\0';
+            m_versions[objectID] = strtoul(value, NULL, 16);
+        }
+    }
+
+    fclose(f);
+
+    // do not trust versions which do not match the last change
+    if(m_changes.empty() || HashVersions(m_versions) != m_changes.back().hash) {
+        sLog.Error("BulkDataVersions", "Bulk data versions in %s are inconsistent, starting over.", filename.c_str());
+        m_changes.clear();
+        m_versions.clear();
+        return false;
+    }
+
+    return true;
+}
+
+bool BulkDataVersions::Save(const std::string &filename) const
+{
+    const std::string tmp = filename + ".tmp";
+    FILE *f = fopen(tmp.c_str(), "w");
+    if(f == NULL)
+        return false;
+
+    std::vector<Change>::const_iterator cur, end;
+    cur = m_changes.begin();
+    end = m_changes.end();
+    for(; cur != end; cur++) {
+        fprintf(f, "%s %u %s\n", BULK_CHANGE_TAG, cur->changeID, cur->hash.c_str());
+
+        std::set<std::string>::const_iterator obj = cur->objects.begin();
+        for(; obj != cur->objects.end(); obj++)
+            fprintf(f, "%s %s\n", BULK_OBJECT_TAG, obj->c_str());
+    }
+
+    VersionMap::const_iterator ver = m_versions.begin();
+    for(; ver != m_versions.end(); ver++)
+        fprintf(f, "%s %08x %s\n", BULK_VERSION_TAG, ver->second, ver->first.c_str());
+
+    const bool ok = (0 == ferror(f));
+    if(0 != fclose(f) || !ok || 0 != rename(tmp.c_str(), filename.c_str())) {
+        remove(tmp.c_str());
+        return false;
+    }
+
+    return true;
+}
+
+bool BulkDataVersions::Update(const VersionMap &versions)
+{
+    if(!m_changes.empty() && versions == m_versions)
+        return false;
+
+    Change change;
+    change.changeID = GetChangeID() + 1;
+    change.hash = HashVersions(versions);
+
+    // new, changed and dropped objects
+    VersionMap::const_iterator cur = versions.begin();
+    for(; cur != versions.end(); cur++) {
+        VersionMap::const_iterator old = m_versions.find(cur->first);
+        if(old == m_versions.end() || old->second != cur->second)
+            change.objects.insert(cur->first);
+    }
+    cur = m_versions.begin();
+    for(; cur != m_versions.end(); cur++) {
+        if(versions.find(cur->first) == versions.end())
+            change.objects.insert(cur->first);
+    }
+
+    m_changes.push_back(change);
+    if(m_changes.size() > MAX_CHANGES)
+        m_changes.erase(m_changes.begin());
+
+    m_versions = versions;
+    return true;
+}
+
+bool BulkDataVersions::FindChange(const std::string &hash, uint32 &changeID) const
+{
+    std::vector<Change>::const_reverse_iterator cur, end;
+    cur = m_changes.rbegin();
+    end = m_changes.rend();
+    for(; cur != end; cur++) {
+        if(cur->hash == hash) {
+            changeID = cur->changeID;
+            return true;
+        }
+    }
+
+    return false;
+}
+
+bool BulkDataVersions::GetChangesSince(uint32 changeID, std::set<std::string> &into) const
+{
+    // the first kept change has no known predecessor
+    if(m_changes.empty() || changeID < m_changes.front().changeID)
+        return false;
+
+    into.clear();
+
+    std::vector<Change>::const_iterator cur, end;
+    cur = m_changes.begin();
+    end = m_changes.end();
+    for(; cur != end; cur++) {
+        if(cur->changeID > changeID)
+            into.insert(cur->objects.begin(), cur->objects.end());
+    }
+
+    return true;
+}
+
+std::string BulkDataVersions::HashVersions(const VersionMap &versions)
+{
+    uint32 crc = 0xFFFFFFFF;
+
+    VersionMap::const_iterator cur = versions.begin();
+    for(; cur != versions.end(); cur++) {
+        crc = CRC32::Update((const uint8 *)cur->first.c_str(), cur->first.size() + 1, crc);
+        crc = CRC32::Update((const uint8 *)&cur->second, sizeof(cur->second), crc);
+    }
+
+    char hash[16];
+    snprintf(hash, sizeof(hash), "%08x", CRC32::Finish(crc));
+    return hash;
+}
@@ -25,22 +25,88 @@
 
 #include "eve-server.h"
 
+#include "EVEServerConfig.h"
 #include "PyServiceCD.h"
 #include "cache/BulkMgrService.h"
+#include "cache/ObjCacheService.h"
 
 PyCallable_Make_InnerDispatcher(BulkMgrService)
 
 BulkMgrService::BulkMgrService( PyServiceMgr *mgr )
 : PyService(mgr, "bulkMgr"),
-  m_dispatch(new Dispatcher(this))
+  m_dispatch(new Dispatcher(this)),
+  m_versionsFile(sConfig.files.cacheDir + "BulkData.versions")
 {
     _SetCallDispatcher(m_dispatch);
 
     PyCallable_REG_CALL(BulkMgrService, UpdateBulk);
+
+    if(m_versions.Load(m_versionsFile))
+        sLog.Log("BulkMgr", "Bulk data is at change %u (%s).", m_versions.GetChangeID(), m_versions.GetHash().c_str());
 }
 
 BulkMgrService::~BulkMgrService() {
     delete m_dispatch;
+
+    DeltaMap::iterator cur = m_deltas.begin();
+    for(; cur != m_deltas.end(); cur++)
+        SafeDelete(cur->second);
+}
+
+void BulkMgrService::_UpdateVersions() {
+    // wait until all of it is primed
+    BulkDataVersions::VersionMap versions;
+    if(!m_manager->cache_service->GetBulkDataVersions(versions))
+        return;
+
+    if(!m_versions.Update(versions))
+        return;
+
+    sLog.Log("BulkMgr", "Bulk data changed to change %u (%s).", m_versions.GetChangeID(), m_versions.GetHash().c_str());
+    if(!m_versions.Save(m_versionsFile))
+        sLog.Error("BulkMgr", "Failed to save bulk data versions to %s.", m_versionsFile.c_str());
+
+    DeltaMap::iterator cur = m_deltas.begin();
+    for(; cur != m_deltas.end(); cur++)
+        SafeDelete(cur->second);
+    m_deltas.clear();
+}
+
+const Buffer *BulkMgrService::_GetDelta(uint32 changeID) {
+    DeltaMap::iterator res = m_deltas.find(changeID);
+    if(res != m_deltas.end())
+        return res->second;
+
+    std::set<std::string> changed;
+    if(!m_versions.GetChangesSince(changeID, changed))
+        return NULL;
+
+    // the dropped objects map to None
+    PyDict *objects = new PyDict();
+    std::set<std::string>::const_iterator cur = changed.begin();
+    for(; cur != changed.end(); cur++) {
+        PyObject *obj = m_manager->cache_service->GetCachedObject(*cur);
+        if(obj == NULL)
+            objects->SetItemString(cur->c_str(), new PyNone());
+        else
+            objects->SetItemString(cur->c_str(), obj);
+    }
+
+    // built once for all the clients at the same change
+    Buffer *delta = new Buffer;
+    const bool ok = Marshal(objects, *delta) && DeflateData(*delta);
+    PyDecRef(objects);
+
+    if(!ok) {
+        sLog.Error("BulkMgr", "Failed to build bulk data delta since change %u.", changeID);
+        SafeDelete(delta);
+        return NULL;
+    }
+
+    sLog.Log("BulkMgr", "Built bulk data delta from change %u to %u: %lu objects in %lu bytes.",
+        changeID, m_versions.GetChangeID(), (unsigned long)changed.size(), (unsigned long)delta->size());
+    m_deltas[changeID] = delta;
+    return delta;
 }
 
 PyResult BulkMgrService::Handle_UpdateBulk(PyCallArgs &call)
@@ -51,9 +117,33 @@ PyResult BulkMgrService::Handle_UpdateBulk(PyCallArgs &call)
 	return NULL;
     }
 
-    PyDict* test = new PyDict();
-    test->SetItemString("type", new PyInt(updateBulkStatusOK));
-    test->SetItemString("allowUnsubmitted", new PyBool(false));
+    _UpdateVersions();
+
+    PyDict* res = new PyDict();
+    res->SetItemString("allowUnsubmitted", new PyBool(false));
+
+    // hashes we did not hand out come from stock clients, which keep their own bulk data
+    uint32 changeID;
+    if(!m_versions.FindChange(args.hashValue, changeID) || changeID == m_versions.GetChangeID()) {
+        res->SetItemString("type", new PyInt(updateBulkStatusOK));
+        return res;
+    }
+
+    if(changeID != (uint32)args.changeID) {
+        res->SetItemString("type", new PyInt(updateBulkStatusHashMismatch));
+        return res;
+    }
+
+    const Buffer *delta = _GetDelta(changeID);
+    if(delta == NULL) {
+        res->SetItemString("type", new PyInt(updateBulkStatusTooManyRevisions));
+        return res;
+    }
+
+    res->SetItemString("type", new PyInt(updateBulkStatusNeedToUpdate));
+    res->SetItemString("changeID", new PyInt(m_versions.GetChangeID()));
+    res->SetItemString("hashValue", new PyString(m_versions.GetHash()));
+    res->SetItemString("data", new PyBuffer(*delta));
 
-    return test;
+    return res;
 }
@@ -51,7 +51,6 @@ ObjCacheDB::ObjCacheDB()
     m_generators["config.BulkData.schematics"] = &ObjCacheDB::Generate_Schematics;
     m_generators["config.BulkData.schematicstypemap"] = &ObjCacheDB::Generate_Schematicstypemap;
     m_generators["config.BulkData.sounds"] = &ObjCacheDB::Generate_Sounds;
-    m_generators["config.BulkData.invtypematerials"] = &ObjCacheDB::Generate_Invtypematerials;
     m_generators["config.BulkData.ownericons"] = &ObjCacheDB::Generate_Ownericons;
     m_generators["config.BulkData.icons"] = &ObjCacheDB::Generate_Icons;
 
@@ -60,8 +59,6 @@ ObjCacheDB::ObjCacheDB()
     m_generators["config.BulkData.categories"] = &ObjCacheDB::Generate_invCategories;
     m_generators["config.BulkData.invtypereactions"] = &ObjCacheDB::Generate_invTypeReactions;
 
-    m_generators["config.BulkData.dgmtypeattribs"] = &ObjCacheDB::Generate_dgmTypeAttribs;
-    m_generators["config.BulkData.dgmtypeeffects"] = &ObjCacheDB::Generate_dgmTypeEffects;
     m_generators["config.BulkData.dgmeffects"] = &ObjCacheDB::Generate_dgmEffects;
     m_generators["config.BulkData.dgmattribs"] = &ObjCacheDB::Generate_dgmAttribs;
     m_generators["config.BulkData.metagroups"] = &ObjCacheDB::Generate_invMetaGroups;
@@ -72,27 +69,21 @@ ObjCacheDB::ObjCacheDB()
     m_generators["config.BulkData.ramcompletedstatuses"] = &ObjCacheDB::Generate_ramCompletedStatuses;
     m_generators["config.BulkData.ramtyperequirements"] = &ObjCacheDB::Generate_ramTypeRequirements;
 
-    m_generators["config.BulkData.mapcelestialdescriptions"] = &ObjCacheDB::Generate_mapCelestialDescriptions;
     m_generators["config.BulkData.tickernames"] = &ObjCacheDB::Generate_tickerNames;
     m_generators["config.BulkData.groups"] = &ObjCacheDB::Generate_invGroups;
     m_generators["config.BulkData.certificates"] = &ObjCacheDB::Generate_certificates;
     m_generators["config.BulkData.certificaterelationships"] = &ObjCacheDB::Generate_certificateRelationships;
     m_generators["config.BulkData.shiptypes"] = &ObjCacheDB::Generate_invShipTypes;
-    m_generators["config.BulkData.locations"] = &ObjCacheDB::Generate_cacheLocations;
-    m_generators["config.BulkData.locationwormholeclasses"] = &ObjCacheDB::Generate_locationWormholeClasses;
     m_generators["config.BulkData.bptypes"] = &ObjCacheDB::Generate_invBlueprintTypes;
     m_generators["config.BulkData.graphics"] = &ObjCacheDB::Generate_eveGraphics;
-    m_generators["config.BulkData.types"] = &ObjCacheDB::Generate_invTypes;
     m_generators["config.BulkData.invmetatypes"] = &ObjCacheDB::Generate_invMetaTypes;
     m_generators["config.Bloodlines"] = &ObjCacheDB::Generate_chrBloodlines;
     m_generators["config.Units"] = &ObjCacheDB::Generate_eveUnits;
     m_generators["config.BulkData.units"] = &ObjCacheDB::Generate_eveBulkDataUnits;
-    m_generators["config.BulkData.owners"] = &ObjCacheDB::Generate_cacheOwners;
     m_generators["config.StaticOwners"] = &ObjCacheDB::Generate_eveStaticOwners;
     m_generators["config.Races"] = &ObjCacheDB::Generate_chrRaces;
     m_generators["config.Attributes"] = &ObjCacheDB::Generate_chrAttributes;
     m_generators["config.Flags"] = &ObjCacheDB::Generate_invFlags;
-    m_generators["config.StaticLocations"] = &ObjCacheDB::Generate_eveStaticLocations;
     m_generators["config.InvContrabandTypes"] = &ObjCacheDB::Generate_invContrabandTypes;
 
     m_generators["charCreationInfo.bloodlines"] = &ObjCacheDB::Generate_c_chrBloodlines;
@@ -125,6 +116,17 @@ ObjCacheDB::ObjCacheDB()
     m_generators["charCreationInfo.beards"] = &ObjCacheDB::Generate_a_beards;
     m_generators["charCreationInfo.skins"] = &ObjCacheDB::Generate_a_skins;
     m_generators["charCreationInfo.lipsticks"] = &ObjCacheDB::Generate_a_lipsticks;
+
+    //the biggest static tables are marshaled straight from the streamed rows:
+    m_streamedQueries["config.BulkData.invtypematerials"] = "SELECT typeID, materialTypeID, quantity FROM invTypeMaterials";
+    m_streamedQueries["config.BulkData.dgmtypeattribs"] = "SELECT    dgmTypeAttributes.typeID,    dgmTypeAttributes.attributeID,    IF(valueInt IS NULL, valueFloat, valueInt) AS value FROM dgmTypeAttributes";
+    m_streamedQueries["config.BulkData.dgmtypeeffects"] = "SELECT typeID,effectID,isDefault FROM dgmTypeEffects";
+    m_streamedQueries["config.BulkData.locations"] = "SELECT locationID, locationName, x, y, z FROM cacheLocations";
+    m_streamedQueries["config.BulkData.types"] = "SELECT typeID, groupID, typeName, description, graphicID, radius, mass, volume, capacity, portionSize, raceID, basePrice, published, marketGroupID, chanceOfDuplicating, soundID, iconID, dataID, typeNameID, descriptionID FROM invTypes";
+    m_streamedQueries["config.BulkData.owners"] = "SELECT ownerID, ownerName, typeID FROM cacheOwners";
+    m_streamedQueries["config.BulkData.mapcelestialdescriptions"] = "SELECT celestialID, description FROM mapCelestialDescriptions";
+    m_streamedQueries["config.BulkData.locationwormholeclasses"] = "SELECT locationID, wormholeClassID FROM mapLocationWormholeClasses";
+    m_streamedQueries["config.StaticLocations"] = "SELECT locationID, locationName, x, y, z FROM eveStaticLocations";
 }
 
 PyRep *ObjCacheDB::GetCachableObject(const std::string &type)
@@ -134,6 +136,10 @@ PyRep *ObjCacheDB::GetCachableObject(const std::string &type)
 
     if(res == m_generators.end())
     {
+        std::map<std::string, const char*>::const_iterator streamed = m_streamedQueries.find(type);
+        if(streamed != m_streamedQueries.end())
+            return _GenerateCRowset(type, streamed->second);
+
         _log(SERVICE__ERROR, "Unable to find cachable object generator for type '%s'", type.c_str());
         return NULL;
     }
@@ -142,6 +148,49 @@ PyRep *ObjCacheDB::GetCachableObject(const std::string &type)
     return (this->*f)();
 }
 
+bool ObjCacheDB::IsStreamedObject(const std::string &type) const
+{
+    return m_streamedQueries.find(type) != m_streamedQueries.end();
+}
+
+bool ObjCacheDB::MarshalCachableObject(const std::string &type, Buffer &into)
+{
+    std::map<std::string, const char*>::const_iterator res;
+    res = m_streamedQueries.find(type);
+
+    if(res == m_streamedQueries.end())
+    {
+        _log(SERVICE__ERROR, "Cachable object '%s' is not streamed", type.c_str());
+        return false;
+    }
+
+    DBQueryResult result;
+    if(!sDatabase.RunReadQueryStream(result, "%s", res->second))
+    {
+        _log(SERVICE__ERROR, "Error in query for cached object '%s': %s", type.c_str(), result.error.c_str());
+        return false;
+    }
+
+    if(!MarshalDBResultToCRowset(result, into))
+    {
+        _log(SERVICE__ERROR, "Failed to marshal cached object '%s': %s", type.c_str(), result.error.c_str());
+        return false;
+    }
+
+    return true;
+}
+
+PyRep *ObjCacheDB::_GenerateCRowset(const std::string &type, const char *query)
+{
+    DBQueryResult res;
+    if(!sDatabase.RunQuery(res, "%s", query))
+    {
+        _log(SERVICE__ERROR, "Error in query for cached object '%s': %s", type.c_str(), res.error.c_str());
+        return NULL;
+    }
+    return DBResultToCRowset(res);
+}
+
 //implement all the generators:
 PyRep *ObjCacheDB::Generate_CharNewExtraSpecialities()
 {
@@ -227,18 +276,6 @@ PyRep *ObjCacheDB::Generate_Ownericons()
     return DBResultToCRowset(res);
 }
 
-PyRep *ObjCacheDB::Generate_Invtypematerials()
-{
-    DBQueryResult res;
-    const char *q = "SELECT typeID, materialTypeID, quantity FROM invTypeMaterials";
-    if (sDatabase.RunQuery(res, q) == false)
-    {
-        _log(SERVICE__ERROR, "Error in query for cached object 'config.BulkData.invTypeMaterials': %s", res.error.c_str());
-        return NULL;
-    }
-    return DBResultToCRowset(res);
-}
-
 PyRep *ObjCacheDB::Generate_Sounds()
 {
     DBQueryResult res;
@@ -455,30 +492,6 @@ PyRep *ObjCacheDB::Generate_invTypeReactions()
     return DBResultToCRowset(res);
 }
 
-PyRep *ObjCacheDB::Generate_dgmTypeAttribs()
-{
-    DBQueryResult res;
-    const char *q = "SELECT    dgmTypeAttributes.typeID,    dgmTypeAttributes.attributeID,    IF(valueInt IS NULL, valueFloat, valueInt) AS value FROM dgmTypeAttributes";
-    if(sDatabase.RunQuery(res, q)==false)
-    {
-        _log(SERVICE__ERROR, "Error in query for cached object 'config.BulkData.dgmtypeattribs': %s",res.error.c_str());
-        return NULL;
-    }
-    return DBResultToCRowset(res);
-}
-
-PyRep *ObjCacheDB::Generate_dgmTypeEffects()
-{
-    DBQueryResult res;
-    const char *q = "SELECT typeID,effectID,isDefault FROM dgmTypeEffects";
-    if(sDatabase.RunQuery(res, q)==false)
-    {
-        _log(SERVICE__ERROR, "Error in query for cached object 'config.BulkData.dgmtypeeffects': %s",res.error.c_str());
-        return NULL;
-    }
-    return DBResultToCRowset(res);
-}
-
 PyRep *ObjCacheDB::Generate_dgmEffects()
 {
     DBQueryResult res;
@@ -587,18 +600,6 @@ PyRep *ObjCacheDB::Generate_ramTypeRequirements()
     return DBResultToCRowset(res);
 }
 
-PyRep *ObjCacheDB::Generate_mapCelestialDescriptions()
-{
-    DBQueryResult res;
-    const char *q = "SELECT celestialID, description FROM mapCelestialDescriptions";
-    if(sDatabase.RunQuery(res, q)==false)
-    {
-        _log(SERVICE__ERROR, "Error in query for cached object 'config.BulkData.mapcelestialdescriptions': %s", res.error.c_str());
-        return NULL;
-    }
-    return DBResultToCRowset(res);
-}
-
 PyRep *ObjCacheDB::Generate_tickerNames()
 {
     DBQueryResult res;
@@ -659,30 +660,6 @@ PyRep *ObjCacheDB::Generate_invShipTypes()
     return DBResultToCRowset(res);
 }
 
-PyRep *ObjCacheDB::Generate_cacheLocations()
-{
-    DBQueryResult res;
-    const char *q = "SELECT locationID, locationName, x, y, z FROM cacheLocations";
-    if(sDatabase.RunQuery(res, q)==false)
-    {
-        _log(SERVICE__ERROR, "Error in query for cached object 'config.BulkData.locations': %s", res.error.c_str());
-        return NULL;
-    }
-    return DBResultToCRowset(res);
-}
-
-PyRep *ObjCacheDB::Generate_locationWormholeClasses()
-{
-    DBQueryResult res;
-    const char *q = "SELECT locationID, wormholeClassID FROM mapLocationWormholeClasses";
-    if(sDatabase.RunQuery(res, q)==false)
-    {
-        _log(SERVICE__ERROR, "Error in query for cached object 'config.BulkData.locationwormholeclasses': %s", res.error.c_str());
-        return NULL;
-    }
-    return DBResultToCRowset(res);
-}
-
 PyRep *ObjCacheDB::Generate_invBlueprintTypes()
 {
     DBQueryResult res;
@@ -707,18 +684,6 @@ PyRep *ObjCacheDB::Generate_eveGraphics()
     return DBResultToCRowset(res);
 }
 
-PyRep *ObjCacheDB::Generate_invTypes()
-{
-    DBQueryResult res;
-    const char *q = "SELECT typeID, groupID, typeName, description, graphicID, radius, mass, volume, capacity, portionSize, raceID, basePrice, published, marketGroupID, chanceOfDuplicating, soundID, iconID, dataID, typeNameID, descriptionID FROM invTypes";
-    if(sDatabase.RunQuery(res, q)==false)
-    {
-        _log(SERVICE__ERROR, "Error in query for cached object 'config.BulkData.types': %s", res.error.c_str());
-        return NULL;
-    }
-    return DBResultToCRowset(res);
-}
-
 PyRep *ObjCacheDB::Generate_invMetaTypes()
 {
     DBQueryResult res;
@@ -767,18 +732,6 @@ PyRep *ObjCacheDB::Generate_eveBulkDataUnits()
     return DBResultToCRowset(res);
 }
 
-PyRep *ObjCacheDB::Generate_cacheOwners()
-{
-    DBQueryResult res;
-    const char *q = "SELECT ownerID, ownerName, typeID FROM cacheOwners";
-    if(sDatabase.RunQuery(res, q)==false)
-    {
-        _log(SERVICE__ERROR, "Error in query for cached object 'config.BulkData.owners': %s", res.error.c_str());
-        return NULL;
-    }
-    return DBResultToCRowset(res);
-}
-
 PyRep *ObjCacheDB::Generate_eveStaticOwners()
 {
     DBQueryResult res;
@@ -827,18 +780,6 @@ PyRep *ObjCacheDB::Generate_invFlags()
     return DBResultToPackedRowList(res);
 }
 
-PyRep *ObjCacheDB::Generate_eveStaticLocations()
-{
-    DBQueryResult res;
-    const char *q = "SELECT locationID, locationName, x, y, z FROM eveStaticLocations";
-    if(sDatabase.RunQuery(res, q)==false)
-    {
-        _log(SERVICE__ERROR, "Error in query for cached object 'config.StaticLocations': %s", res.error.c_str());
-        return NULL;
-    }
-    return DBResultToCRowset(res);
-}
-
 PyRep *ObjCacheDB::Generate_invContrabandTypes()
 {
     DBQueryResult res;
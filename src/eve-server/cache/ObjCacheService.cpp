@@ -137,7 +137,8 @@ PyCallable_Make_InnerDispatcher(ObjCacheService)
 ObjCacheService::ObjCacheService(PyServiceMgr *mgr, const char *cacheDir)
 : PyService(mgr, "objectCaching"),
   m_dispatch(new Dispatcher(this)),
-  m_cacheDir(cacheDir)
+  m_cacheDir(cacheDir),
+  m_primeStart(0)
 {
     _SetCallDispatcher(m_dispatch);
 
@@ -199,6 +200,9 @@ ObjCacheService::ObjCacheService(PyServiceMgr *mgr, const char *cacheDir)
     m_cacheKeys["config.StaticLocations"] = "config.StaticLocations";
     m_cacheKeys["config.InvContrabandTypes"] = "config.InvContrabandTypes";
 
+    //asked for by dogmaIM.GetAttributeTypes during login
+    m_cacheKeys["dogmaIM.attributesByName"] = "attributesByName";
+
     m_cacheKeys["charCreationInfo.bloodlines"] = "bloodlines";
     m_cacheKeys["charCreationInfo.races"] = "races";
     m_cacheKeys["charCreationInfo.ancestries"] = "ancestries";
@@ -238,6 +242,9 @@ ObjCacheService::ObjCacheService(PyServiceMgr *mgr, const char *cacheDir)
 }
 
 ObjCacheService::~ObjCacheService() {
+    for(uint32 i = 0; i < hintSetCount; i++)
+        _ClearHintSet(m_hintSets[i]);
+
     delete m_dispatch;
 }
 
@@ -266,17 +273,160 @@ PyResult ObjCacheService::Handle_GetCachableObject(PyCallArgs &call) {
     return result;
 }
 
+/**
+ * @brief Builds one streamed object on a worker thread.
+ *
+ * The rowset is queried, marshaled and deflated by Run(); Complete()
+ * hands the result to the service on the game thread.
+ */
+class ObjCacheService::PrimeQuery
+: public DBAsyncQuery
+{
+public:
+    PrimeQuery(ObjCacheService &service, const std::string &objectID)
+    : m_service(service),
+      m_objectID(objectID),
+      m_data(new Buffer),
+      m_buildTime(0),
+      m_deflateTime(0)
+    {
+    }
+    ~PrimeQuery() { SafeDelete( m_data ); }
+
+    ObjCacheService &m_service;
+    const std::string m_objectID;
+    Buffer *m_data;
+    uint64 m_buildTime;
+    uint64 m_deflateTime;
+
+protected:
+    bool Run()
+    {
+        const uint64 start = GetTimeUSeconds();
+        if(!m_service.m_db.MarshalCachableObject(m_objectID, *m_data))
+            return false;
+
+        const uint64 marshaled = GetTimeUSeconds();
+        m_buildTime = marshaled - start;
+
+        const bool res = CachedObjectMgr::DeflateMarshaled(*m_data);
+        m_deflateTime = GetTimeUSeconds() - marshaled;
+
+        return res;
+    }
+
+    void Complete(bool success, DBQueryResult &result)
+    {
+        m_service._PrimeComplete(*this, success);
+    }
+};
+
 void ObjCacheService::PrimeCache()
 {
+    m_primeStart = GetTimeUSeconds();
+    m_primeTimings.clear();
+
     CacheKeysMapConstItr cur, end;
     cur = m_cacheKeys.begin();
     end = m_cacheKeys.end();
     for(; cur != end; cur++)
     {
         PyString* str = new PyString( cur->first );
-        _LoadCachableObject( str );
+
+        if(!m_cache.HaveCached(str) && m_priming.find(cur->first) == m_priming.end())
+        {
+            const uint64 start = GetTimeUSeconds();
+
+            if(!m_cacheDir.empty() && m_cache.LoadCachedFromFile(m_cacheDir, str))
+            {
+                _log( SERVICE__CACHE, "Loaded cached object '%s' from file.", cur->first.c_str() );
+
+                PrimeTiming &t = m_primeTimings[cur->first];
+                t.source = "file";
+                t.buildTime = GetTimeUSeconds() - start;
+                t.deflateTime = 0;
+                t.readyTime = GetTimeUSeconds() - m_primeStart;
+            }
+            else if(m_db.IsStreamedObject(cur->first))
+            {
+                //big rowsets are built by the worker threads
+                m_priming.insert(cur->first);
+                sDBAsync.Submit(new PrimeQuery(*this, cur->first));
+            }
+            else if(_LoadCachableObject(str))
+            {
+                PrimeTiming &t = m_primeTimings[cur->first];
+                t.source = "main";
+                t.buildTime = GetTimeUSeconds() - start;
+                t.deflateTime = 0;
+                t.readyTime = GetTimeUSeconds() - m_primeStart;
+            }
+        }
+
         PyDecRef( str );
     }
+
+    if(m_priming.empty())
+        _LogPrimeTimings();
+}
+
+void ObjCacheService::_PrimeComplete(PrimeQuery &job, bool success)
+{
+    m_priming.erase(job.m_objectID);
+
+    PyString* str = new PyString( job.m_objectID );
+
+    if(m_cache.HaveCached(str))
+    {
+        //somebody asked for it in the meantime, so it has been loaded already
+    }
+    else if(success)
+    {
+        m_cache.UpdateCacheMarshaled(str, &job.m_data, true);
+        _SaveCachableObject(str);
+
+        PrimeTiming &t = m_primeTimings[job.m_objectID];
+        t.source = "worker";
+        t.buildTime = job.m_buildTime;
+        t.deflateTime = job.m_deflateTime;
+        t.readyTime = GetTimeUSeconds() - m_primeStart;
+    }
+    else
+    {
+        _log(SERVICE__ERROR, "Failed to stream cached object '%s', building it whole", job.m_objectID.c_str());
+
+        const uint64 start = GetTimeUSeconds();
+        if(_LoadCachableObject(str))
+        {
+            PrimeTiming &t = m_primeTimings[job.m_objectID];
+            t.source = "main";
+            t.buildTime = GetTimeUSeconds() - start;
+            t.deflateTime = 0;
+            t.readyTime = GetTimeUSeconds() - m_primeStart;
+        }
+    }
+
+    PyDecRef( str );
+
+    if(m_priming.empty())
+        _LogPrimeTimings();
+}
+
+void ObjCacheService::_LogPrimeTimings()
+{
+    sLog.Log( "ObjCacheService", "Primed %lu cached objects in %.1f ms:",
+              (unsigned long)m_primeTimings.size(), ( GetTimeUSeconds() - m_primeStart ) / 1000.0 );
+    sLog.Log( "ObjCacheService", "  %-48s %-6s %10s %10s %10s", "object", "source", "build ms", "deflate ms", "ready ms" );
+
+    PrimeTimingMap::const_iterator cur, end;
+    cur = m_primeTimings.begin();
+    end = m_primeTimings.end();
+    for(; cur != end; cur++)
+    {
+        const PrimeTiming &t = cur->second;
+        sLog.Log( "ObjCacheService", "  %-48s %-6s %10.1f %10.1f %10.1f",
+                  cur->first.c_str(), t.source, t.buildTime / 1000.0, t.deflateTime / 1000.0, t.readyTime / 1000.0 );
+    }
 }
 
 PySubStream* ObjCacheService::LoadCachedFile(const char *filename, const char *oname)
@@ -301,38 +451,61 @@ bool ObjCacheService::_LoadCachableObject(const PyRep *objectID) {
         }
     }
 
-    //first try to generate it from the database...
-    //we go to the DB with a string, not a rep
-    PyRep *cache = m_db.GetCachableObject(objectID_string);
-    if(cache != NULL) {
-        //we have generated the cache file in question, remember it
-        m_cache.UpdateCache(objectID, &cache);
-    } else {
-        //failed to query from the database... fall back to old
-        //hackish file loading.
-        PySubStream* ss = m_cache.LoadCachedFile( objectID_string.c_str() );
-        if( ss == NULL )
-        {
-            _log(SERVICE__ERROR, "Failed to create or load cache file for '%s'", objectID_string.c_str());
-            return false;
-        }
+    //big rowsets are marshaled straight from the database, row by row
+    bool streamed = false;
+    if(m_db.IsStreamedObject(objectID_string))
+    {
+        Buffer* data = new Buffer;
+        streamed = m_db.MarshalCachableObject(objectID_string, *data);
+        if(streamed)
+            m_cache.UpdateCacheMarshaled(objectID, &data);
+        else
+            _log(SERVICE__ERROR, "Failed to stream cached object '%s', building it whole", objectID_string.c_str());
 
-        //we have generated the cache file in question, remember it
-        m_cache.UpdateCacheFromSS(objectID_string, &ss);
+        SafeDelete( data );
     }
 
-    //if we have a cache dir, write out the cache entry:
-    if(!m_cacheDir.empty())
+    if(!streamed)
     {
-        if(!m_cache.SaveCachedToFile(m_cacheDir, objectID))
-            sLog.Error( "ObjCacheService", "Failed to save cache file for '%s' in '%s'", objectID_string.c_str(), m_cacheDir.c_str() );
-        else
-            sLog.Log( "ObjCacheService", "Saved cached object '%s' to file.", objectID_string.c_str() );
+        //first try to generate it from the database...
+        //we go to the DB with a string, not a rep
+        PyRep *cache = m_db.GetCachableObject(objectID_string);
+        if(cache != NULL) {
+            //we have generated the cache file in question, remember it
+            m_cache.UpdateCache(objectID, &cache);
+        } else {
+            //failed to query from the database... fall back to old
+            //hackish file loading.
+            PySubStream* ss = m_cache.LoadCachedFile( objectID_string.c_str() );
+            if( ss == NULL )
+            {
+                _log(SERVICE__ERROR, "Failed to create or load cache file for '%s'", objectID_string.c_str());
+                return false;
+            }
+
+            //we have generated the cache file in question, remember it
+            m_cache.UpdateCacheFromSS(objectID_string, &ss);
+        }
     }
 
+    _SaveCachableObject(objectID);
+
     return true;
 }
 
+void ObjCacheService::_SaveCachableObject(const PyRep *objectID) {
+    //if we have a cache dir, write out the cache entry:
+    if(m_cacheDir.empty())
+        return;
+
+    const std::string objectID_string = CachedObjectMgr::OIDToString(objectID);
+
+    if(!m_cache.SaveCachedToFile(m_cacheDir, objectID))
+        sLog.Error( "ObjCacheService", "Failed to save cache file for '%s' in '%s'", objectID_string.c_str(), m_cacheDir.c_str() );
+    else
+        sLog.Log( "ObjCacheService", "Saved cached object '%s' to file.", objectID_string.c_str() );
+}
+
 PyRep *ObjCacheService::GetCacheHint(const PyRep* objectID) {
     if(!_LoadCachableObject(objectID))
         return NULL;    //print done already
@@ -347,6 +520,25 @@ PyRep *ObjCacheService::GetCacheHint(const PyRep* objectID) {
 }
 
 void ObjCacheService::InsertCacheHints(hintSet hset, PyDict *into) {
+    if(hset >= hintSetCount)
+        return;
+
+    HintSet &set = m_hintSets[hset];
+    if(set.generation != m_cache.GetGeneration())
+        _BuildHintSet(hset, set);
+
+    std::vector<std::pair<PyRep *, PyRep *> >::const_iterator cur, end;
+    cur = set.hints.begin();
+    end = set.hints.end();
+    for(; cur != end; cur++) {
+        PyIncRef( cur->first );
+        PyIncRef( cur->second );
+
+        into->SetItem(cur->first, cur->second);
+    }
+}
+
+void ObjCacheService::_BuildHintSet(hintSet hset, HintSet &into) {
     const char *const *objects = NULL;
     uint32 object_count = 0;
     switch(hset) {
@@ -366,11 +558,14 @@ void ObjCacheService::InsertCacheHints(hintSet hset, PyDict *into) {
         objects = CharCreateNewExtraCachableObjects;
         object_count = CharCreateNewExtraCachableObjectCount;
         break;
+    default:
+        break;
     }
-    if(objects == NULL)
-        return;
+
+    _ClearHintSet(into);
+
     uint32 r;
-    std::map<std::string, std::string>::const_iterator res;
+    CacheKeysMapConstItr res;
     for(r = 0; r < object_count; r++) {
         //find the dict key to use for this object
         res = m_cacheKeys.find(objects[r]);
@@ -387,18 +582,60 @@ void ObjCacheService::InsertCacheHints(hintSet hset, PyDict *into) {
         if(cache_hint == NULL)
             continue;    //print already done.
 
-        into->SetItemString(res->second.c_str(), cache_hint);
+        into.hints.push_back( std::make_pair( new PyString( res->second ), cache_hint ) );
+    }
+
+    //loading the objects above may have bumped the generation already
+    into.generation = m_cache.GetGeneration();
+}
+
+void ObjCacheService::_ClearHintSet(HintSet &set) {
+    std::vector<std::pair<PyRep *, PyRep *> >::iterator cur, end;
+    cur = set.hints.begin();
+    end = set.hints.end();
+    for(; cur != end; cur++) {
+        PyDecRef( cur->first );
+        PyDecRef( cur->second );
     }
+
+    set.hints.clear();
+    set.generation = 0;
 }
 
 bool ObjCacheService::IsCacheLoaded(const PyRep *objectID) const {
     return(m_cache.HaveCached(objectID));
 }
 
+bool ObjCacheService::GetBulkDataVersions(std::map<std::string, uint32> &into) const {
+    static const char BULK_DATA_PREFIX[] = "config.BulkData.";
+
+    into.clear();
+    for(uint32 i = 0; i < LoginCachableObjectCount; i++) {
+        const char *objectID = LoginCachableObjects[i];
+        if(0 != strncmp(objectID, BULK_DATA_PREFIX, sizeof(BULK_DATA_PREFIX) - 1))
+            continue;
+
+        uint32 version;
+        if(!m_cache.GetCachedVersion(objectID, version))
+            return false;
+        into[objectID] = version;
+    }
+
+    return true;
+}
+
 void ObjCacheService::InvalidateCache(const PyRep *objectID) {
     m_cache.InvalidateCache(objectID);
 }
 
+void ObjCacheService::AddCacheDependency(const PyRep *objectID, const char *table, uint32 key) {
+    m_cache.AddDependency(objectID, table, key);
+}
+
+size_t ObjCacheService::InvalidateCacheDependents(const char *table, uint32 key) {
+    return m_cache.InvalidateDependents(table, key);
+}
+
 void ObjCacheService::GiveCache(const PyRep *objectID, PyRep **contents) {
     //contents is consumed.
     m_cache.UpdateCache(objectID, contents);
@@ -0,0 +1,249 @@
+/*
+    ------------------------------------------------------------------------------------
+    LICENSE:
+    ------------------------------------------------------------------------------------
+    This file is part of EVEmu: EVE Online Server Emulator
+    Copyright 2006 - 2011 The EVEmu Team
+    For the latest information visit http://evemu.org
+    ------------------------------------------------------------------------------------
+    This program is free software; you can redistribute it and/or modify it under
+    the terms of the GNU Lesser General Public License as published by the Free Software
+    Foundation; either version 2 of the License, or (at your option) any later
+    version.
+
+    This program is distributed in the hope that it will be useful, but WITHOUT
+    ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+    FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public License along with
+    this program; if not, write to the Free Software Foundation, Inc., 59 Temple
+    Place - Suite 330, Boston, MA 02111-1307, USA, or go to
+    http://www.gnu.org/copyleft/lesser.txt.
+    ------------------------------------------------------------------------------------
+    Author:     EVEmu Team
+*/
+
+
+#include "eve-server.h"
+
+#include "character/CertificateGraph.h"
+
+CertificateGraph::CertificateGraph()
+{
+}
+
+bool CertificateGraph::Load()
+{
+    mCertificates.clear();
+    mCertificateIndex.clear();
+    mSkillIndex.clear();
+
+    DBQueryResult res;
+    if( !sDatabase.RunQuery( res, "SELECT certificateID FROM crtCertificates" ) )
+    {
+        codelog( SERVICE__ERROR, "Error in query: %s", res.error.c_str() );
+        return false;
+    }
+
+    // requirements by certificateID: skills as (typeID, level), certificates as (certificateID, 0)
+    std::map< uint32, std::vector< std::pair< uint32, uint32 > > > skills, prerequisites;
+
+    DBResultRow row;
+    while( res.GetRow( row ) )
+        skills[ row.GetUInt( 0 ) ];
+
+    if( !sDatabase.RunQuery( res,
+        "SELECT parentID, parentTypeID, parentLevel, childID"
+        " FROM certificateRelationShips"
+        " WHERE childID != 0" ) )
+    {
+        codelog( SERVICE__ERROR, "Error in query: %s", res.error.c_str() );
+        return false;
+    }
+
+    while( res.GetRow( row ) )
+    {
+        const uint32 childID = row.GetUInt( 3 );
+        skills[ childID ];
+
+        if( 0 != row.GetUInt( 1 ) )
+        {
+            const uint32 level = std::min< uint32 >( std::max< uint32 >( row.GetUInt( 2 ), 1 ), MAX_SKILL_LEVEL );
+            skills[ childID ].push_back( std::make_pair( row.GetUInt( 1 ), level ) );
+        }
+        else if( 0 != row.GetUInt( 0 ) )
+        {
+            skills[ row.GetUInt( 0 ) ];
+            prerequisites[ childID ].push_back( std::make_pair( row.GetUInt( 0 ), 0 ) );
+        }
+    }
+
+    // order the certificates so that the prerequisites come first
+    std::map< uint32, uint32 > missing;
+    std::map< uint32, std::vector< uint32 > > dependents;
+    std::vector< uint32 > ready;
+
+    std::map< uint32, std::vector< std::pair< uint32, uint32 > > >::const_iterator cur, end;
+    cur = skills.begin();
+    end = skills.end();
+    for(; cur != end; ++cur )
+    {
+        std::map< uint32, std::vector< std::pair< uint32, uint32 > > >::const_iterator p = prerequisites.find( cur->first );
+        const uint32 count = ( p == prerequisites.end() ? 0 : p->second.size() );
+
+        missing[ cur->first ] = count;
+        if( 0 == count )
+            ready.push_back( cur->first );
+        else
+        {
+            for( size_t i = 0; i < p->second.size(); ++i )
+                dependents[ p->second[ i ].first ].push_back( cur->first );
+        }
+    }
+
+    for( size_t i = 0; i < ready.size(); ++i )
+    {
+        const uint32 certificateID = ready[ i ];
+
+        mCertificateIndex[ certificateID ] = mCertificates.size();
+        mCertificates.push_back( Certificate() );
+        mCertificates.back().certificateID = certificateID;
+
+        const std::vector< uint32 >& next = dependents[ certificateID ];
+        for( size_t j = 0; j < next.size(); ++j )
+        {
+            if( 0 == --missing[ next[ j ] ] )
+                ready.push_back( next[ j ] );
+        }
+    }
+
+    if( mCertificates.size() < skills.size() )
+        sLog.Error( "CertificateGraph", "%lu certificates have cyclic prerequisites, they are never granted.",
+                    (unsigned long)( skills.size() - mCertificates.size() ) );
+
+    // compile the requirements into masks
+    for( size_t i = 0; i < mCertificates.size(); ++i )
+    {
+        Certificate& certificate = mCertificates[ i ];
+
+        const std::vector< std::pair< uint32, uint32 > >& skill = skills[ certificate.certificateID ];
+        for( size_t j = 0; j < skill.size(); ++j )
+        {
+            std::tr1::unordered_map< uint32, uint32 >::const_iterator found = mSkillIndex.find( skill[ j ].first );
+            uint32 index;
+            if( found == mSkillIndex.end() )
+            {
+                index = mSkillIndex.size();
+                mSkillIndex[ skill[ j ].first ] = index;
+            }
+            else
+                index = found->second;
+
+            _AddBit( certificate.skills, index * MAX_SKILL_LEVEL + skill[ j ].second - 1 );
+        }
+
+        const std::vector< std::pair< uint32, uint32 > >& prerequisite = prerequisites[ certificate.certificateID ];
+        for( size_t j = 0; j < prerequisite.size(); ++j )
+            _AddBit( certificate.prerequisites, mCertificateIndex[ prerequisite[ j ].first ] );
+    }
+
+    return true;
+}
+
+void CertificateGraph::BuildSkillBits( const std::map< uint32, uint32 >& skills, SkillBits& into ) const
+{
+    into.assign( ( GetSkillBitCount() + 63 ) / 64, 0 );
+
+    std::map< uint32, uint32 >::const_iterator cur, end;
+    cur = skills.begin();
+    end = skills.end();
+    for(; cur != end; ++cur )
+    {
+        std::tr1::unordered_map< uint32, uint32 >::const_iterator res = mSkillIndex.find( cur->first );
+        if( res == mSkillIndex.end() )
+            continue;
+
+        // every level up to the trained one
+        const uint32 levels = std::min( cur->second, MAX_SKILL_LEVEL );
+        for( uint32 level = 0; level < levels; ++level )
+        {
+            const uint32 bit = res->second * MAX_SKILL_LEVEL + level;
+            into[ bit / 64 ] |= (uint64)1 << ( bit % 64 );
+        }
+    }
+}
+
+void CertificateGraph::Evaluate( const SkillBits& skills, const std::set< uint32 >& held, const std::set< uint32 >* wanted, std::vector< uint32 >& into )
+{
+    ++mStats.evaluations;
+
+    std::vector< uint64 > have( ( mCertificates.size() + 63 ) / 64, 0 );
+
+    std::set< uint32 >::const_iterator cur, end;
+    cur = held.begin();
+    end = held.end();
+    for(; cur != end; ++cur )
+    {
+        std::tr1::unordered_map< uint32, uint32 >::const_iterator res = mCertificateIndex.find( *cur );
+        if( res != mCertificateIndex.end() )
+            have[ res->second / 64 ] |= (uint64)1 << ( res->second % 64 );
+    }
+
+    for( size_t i = 0; i < mCertificates.size(); ++i )
+    {
+        if( 0 != ( have[ i / 64 ] & ( (uint64)1 << ( i % 64 ) ) ) )
+            continue;
+
+        const Certificate& certificate = mCertificates[ i ];
+        if( NULL != wanted && 0 == wanted->count( certificate.certificateID ) )
+            continue;
+
+        if( !_HasBits( skills, certificate.skills ) || !_HasBits( have, certificate.prerequisites ) )
+        {
+            if( NULL != wanted )
+                ++mStats.refused;
+            continue;
+        }
+
+        have[ i / 64 ] |= (uint64)1 << ( i % 64 );
+        into.push_back( certificate.certificateID );
+
+        ++mStats.granted;
+    }
+}
+
+void CertificateGraph::_AddBit( std::vector< Mask >& into, uint32 bit )
+{
+    const uint32 word = bit / 64;
+
+    std::vector< Mask >::iterator cur, end;
+    cur = into.begin();
+    end = into.end();
+    for(; cur != end; ++cur )
+    {
+        if( cur->word == word )
+        {
+            cur->bits |= (uint64)1 << ( bit % 64 );
+            return;
+        }
+    }
+
+    Mask mask;
+    mask.word = word;
+    mask.bits = (uint64)1 << ( bit % 64 );
+    into.push_back( mask );
+}
+
+bool CertificateGraph::_HasBits( const std::vector< uint64 >& bits, const std::vector< Mask >& masks )
+{
+    std::vector< Mask >::const_iterator cur, end;
+    cur = masks.begin();
+    end = masks.end();
+    for(; cur != end; ++cur )
+    {
+        if( cur->word >= bits.size() || ( bits[ cur->word ] & cur->bits ) != cur->bits )
+            return false;
+    }
+
+    return true;
+}
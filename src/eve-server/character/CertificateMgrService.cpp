@@ -52,6 +52,17 @@ CertificateMgrService::~CertificateMgrService()
     delete m_dispatch;
 }
 
+void CertificateMgrService::PrimeCache() {
+    ObjectCachedMethodID categories(GetName(), "GetCertificateCategories");
+    _CacheCertificateCategories(categories);
+
+    ObjectCachedMethodID recommendations(GetName(), "GetAllShipCertificateRecommendations");
+    _CacheAllShipCertificateRecommendations(recommendations);
+
+    ObjectCachedMethodID classes(GetName(), "GetCertificateClasses");
+    _CacheCertificateClasses(classes);
+}
+
 PyResult CertificateMgrService::Handle_GetMyCertificates(PyCallArgs &call) {
     Character::Certificates crt;
     CharacterRef ch = call.client->GetChar();
@@ -78,9 +89,7 @@ PyResult CertificateMgrService::Handle_GetMyCertificates(PyCallArgs &call) {
 
 }
 
-PyResult CertificateMgrService::Handle_GetCertificateCategories(PyCallArgs &call) {
-    ObjectCachedMethodID method_id(GetName(), "GetCertificateCategories");
-
+void CertificateMgrService::_CacheCertificateCategories(const ObjectCachedMethodID &method_id) {
     if(!m_manager->cache_service->IsCacheLoaded(method_id)) {
         PyRep *res = m_db.GetCertificateCategories();
         if(res == NULL) {
@@ -89,13 +98,17 @@ PyResult CertificateMgrService::Handle_GetCertificateCategories(PyCallArgs &call
         }
         m_manager->cache_service->GiveCache(method_id, &res);
     }
+}
+
+PyResult CertificateMgrService::Handle_GetCertificateCategories(PyCallArgs &call) {
+    ObjectCachedMethodID method_id(GetName(), "GetCertificateCategories");
+
+    _CacheCertificateCategories(method_id);
 
     return(m_manager->cache_service->MakeObjectCachedMethodCallResult(method_id));
 }
 
-PyResult CertificateMgrService::Handle_GetAllShipCertificateRecommendations(PyCallArgs &call) {
-    ObjectCachedMethodID method_id(GetName(), "GetAllShipCertificateRecommendations");
-
+void CertificateMgrService::_CacheAllShipCertificateRecommendations(const ObjectCachedMethodID &method_id) {
     if(!m_manager->cache_service->IsCacheLoaded(method_id)) {
         PyRep *res = m_db.GetAllShipCertificateRecommendations();
         if(res == NULL) {
@@ -104,13 +117,17 @@ PyResult CertificateMgrService::Handle_GetAllShipCertificateRecommendations(PyCa
         }
         m_manager->cache_service->GiveCache(method_id, &res);
     }
+}
+
+PyResult CertificateMgrService::Handle_GetAllShipCertificateRecommendations(PyCallArgs &call) {
+    ObjectCachedMethodID method_id(GetName(), "GetAllShipCertificateRecommendations");
+
+    _CacheAllShipCertificateRecommendations(method_id);
 
     return(m_manager->cache_service->MakeObjectCachedMethodCallResult(method_id));
 }
 
-PyResult CertificateMgrService::Handle_GetCertificateClasses(PyCallArgs &call) {
-    ObjectCachedMethodID method_id(GetName(), "GetCertificateClasses");
-
+void CertificateMgrService::_CacheCertificateClasses(const ObjectCachedMethodID &method_id) {
     if(!m_manager->cache_service->IsCacheLoaded(method_id)) {
         PyRep *res = m_db.GetCertificateClasses();
         if(res == NULL) {
@@ -119,6 +136,12 @@ PyResult CertificateMgrService::Handle_GetCertificateClasses(PyCallArgs &call) {
         }
         m_manager->cache_service->GiveCache(method_id, &res);
     }
+}
+
+PyResult CertificateMgrService::Handle_GetCertificateClasses(PyCallArgs &call) {
+    ObjectCachedMethodID method_id(GetName(), "GetCertificateClasses");
+
+    _CacheCertificateClasses(method_id);
 
     return(m_manager->cache_service->MakeObjectCachedMethodCallResult(method_id));
 }
@@ -141,16 +164,18 @@ PyResult CertificateMgrService::Handle_BatchCertificateGrant(PyCallArgs &call) {
         return(NULL);
     }
 
-    PyList *res = new PyList;
     CharacterRef ch = call.client->GetChar();
 
-    std::vector<int32>::iterator cur, end;
-    cur = arg.ints.begin();
-    end = arg.ints.end();
-    for(; cur != end; cur++) {
-        if( ch->GrantCertificate(*cur) )
-            res->AddItemInt(*cur);
-    }
+    //evaluated and written at once
+    std::vector<uint32> granted;
+    ch->GrantCertificates(std::vector<uint32>(arg.ints.begin(), arg.ints.end()), granted);
+
+    PyList *res = new PyList;
+    std::vector<uint32>::iterator cur, end;
+    cur = granted.begin();
+    end = granted.end();
+    for(; cur != end; cur++)
+        res->AddItemInt(*cur);
 
     return res;
 }
@@ -0,0 +1,323 @@
+/*
+    ------------------------------------------------------------------------------------
+    LICENSE:
+    ------------------------------------------------------------------------------------
+    This file is part of EVEmu: EVE Online Server Emulator
+    Copyright 2006 - 2011 The EVEmu Team
+    For the latest information visit http://evemu.org
+    ------------------------------------------------------------------------------------
+    This program is free software; you can redistribute it and/or modify it under
+    the terms of the GNU Lesser General Public License as published by the Free Software
+    Foundation; either version 2 of the License, or (at your option) any later
+    version.
+
+    This program is distributed in the hope that it will be useful, but WITHOUT
+    ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+    FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public License along with
+    this program; if not, write to the Free Software Foundation, Inc., 59 Temple
+    Place - Suite 330, Boston, MA 02111-1307, USA, or go to
+    http://www.gnu.org/copyleft/lesser.txt.
+    ------------------------------------------------------------------------------------
+    Author:     EVEmu Team
+*/
+
+
+#include "eve-server.h"
+
+#include "EVEServerConfig.h"
+#include "character/CharCreationTemplates.h"
+#include "character/Character.h"
+
+/// Highest level of a starting skill.
+static const uint32 MAX_STARTING_SKILL_LEVEL = 5;
+/// The career of the characters whose school has none: Caldari Military.
+static const uint32 DEFAULT_CAREER_ID = 11;
+
+CharCreationTemplates::CharCreationTemplates()
+: mStartCorporation( 0 ),
+  mStartStation( 0 )
+{
+}
+
+bool CharCreationTemplates::Load()
+{
+    mSchoolCareers.clear();
+    mSchoolCorporations.clear();
+    mCareers.clear();
+    mCorporationStations.clear();
+    mStations.clear();
+    mAncestries.clear();
+    mRaceSkills.clear();
+    mCareerSkills.clear();
+    mSpecialitySkills.clear();
+    mTemplates.clear();
+    mStartCorporation = 0;
+    mStartStation = 0;
+
+    DBQueryResult res;
+    DBResultRow row;
+
+    // the first career of a school is the one it starts
+    if( !sDatabase.RunQuery( res, "SELECT schoolID, careerID FROM careers" ) )
+    {
+        codelog( SERVICE__ERROR, "Error in query: %s", res.error.c_str() );
+        return false;
+    }
+    while( res.GetRow( row ) )
+        mSchoolCareers.insert( std::make_pair( row.GetUInt( 0 ), row.GetUInt( 1 ) ) );
+
+    if( !sDatabase.RunQuery( res, "SELECT schoolID, corporationID FROM chrSchools" ) )
+    {
+        codelog( SERVICE__ERROR, "Error in query: %s", res.error.c_str() );
+        return false;
+    }
+    while( res.GetRow( row ) )
+        mSchoolCorporations.insert( std::make_pair( row.GetUInt( 0 ), row.GetUInt( 1 ) ) );
+
+    if( !sDatabase.RunQuery( res,
+        "SELECT"
+        "  careers.careerID,"
+        "  chrSchools.corporationID,"
+        "  chrSchools.schoolID,"
+        "  corporation.allianceID,"
+        "  corporation.stationID,"
+        "  staStations.solarSystemID,"
+        "  staStations.constellationID,"
+        "  staStations.regionID"
+        " FROM careers"
+        "  JOIN chrSchools ON chrSchools.schoolID = careers.schoolID"
+        "  JOIN corporation ON corporation.corporationID = chrSchools.corporationID"
+        "  JOIN staStations ON staStations.stationID = corporation.stationID" ) )
+    {
+        codelog( SERVICE__ERROR, "Error in query: %s", res.error.c_str() );
+        return false;
+    }
+    while( res.GetRow( row ) )
+    {
+        if( mCareers.find( row.GetUInt( 0 ) ) != mCareers.end() )
+            continue;
+
+        Career& career = mCareers[ row.GetUInt( 0 ) ];
+        career.corporationID = row.GetUInt( 1 );
+        career.schoolID = row.GetUInt( 2 );
+        career.allianceID = row.GetUInt( 3 );
+        career.location.stationID = row.GetUInt( 4 );
+        career.location.solarSystemID = row.GetUInt( 5 );
+        career.location.constellationID = row.GetUInt( 6 );
+        career.location.regionID = row.GetUInt( 7 );
+    }
+
+    // the corporations a character may start in, and their stations
+    if( !sDatabase.RunQuery( res,
+        "SELECT corporationID, stationID"
+        " FROM corporation"
+        " WHERE corporationID IN (SELECT corporationID FROM chrSchools)"
+        "  OR corporationID = %u",
+        sConfig.character.startCorporation ) )
+    {
+        codelog( SERVICE__ERROR, "Error in query: %s", res.error.c_str() );
+        return false;
+    }
+    while( res.GetRow( row ) )
+    {
+        mCorporationStations[ row.GetUInt( 0 ) ] = row.GetUInt( 1 );
+        if( 0 != sConfig.character.startCorporation && row.GetUInt( 0 ) == sConfig.character.startCorporation )
+            mStartCorporation = sConfig.character.startCorporation;
+    }
+
+    if( !sDatabase.RunQuery( res,
+        "SELECT stationID, solarSystemID, constellationID, regionID"
+        " FROM staStations"
+        " WHERE stationID IN ("
+        "   SELECT stationID"
+        "    FROM corporation"
+        "    WHERE corporationID IN (SELECT corporationID FROM chrSchools)"
+        "     OR corporationID = %u )"
+        "  OR stationID = %u",
+        sConfig.character.startCorporation, sConfig.character.startStation ) )
+    {
+        codelog( SERVICE__ERROR, "Error in query: %s", res.error.c_str() );
+        return false;
+    }
+    while( res.GetRow( row ) )
+    {
+        Location& location = mStations[ row.GetUInt( 0 ) ];
+        location.stationID = row.GetUInt( 0 );
+        location.solarSystemID = row.GetUInt( 1 );
+        location.constellationID = row.GetUInt( 2 );
+        location.regionID = row.GetUInt( 3 );
+
+        if( 0 != sConfig.character.startStation && location.stationID == sConfig.character.startStation )
+            mStartStation = sConfig.character.startStation;
+    }
+
+    if( !sDatabase.RunQuery( res,
+        "SELECT ancestryID, intelligence, charisma, perception, memory, willpower"
+        " FROM chrAncestries" ) )
+    {
+        codelog( SERVICE__ERROR, "Error in query: %s", res.error.c_str() );
+        return false;
+    }
+    while( res.GetRow( row ) )
+    {
+        Ancestry& ancestry = mAncestries[ row.GetUInt( 0 ) ];
+        ancestry.intelligence = row.GetUInt( 1 );
+        ancestry.charisma = row.GetUInt( 2 );
+        ancestry.perception = row.GetUInt( 3 );
+        ancestry.memory = row.GetUInt( 4 );
+        ancestry.willpower = row.GetUInt( 5 );
+    }
+
+    return _LoadSkills( "SELECT raceID, skillTypeID, levels FROM raceSkills", mRaceSkills )
+        && _LoadSkills( "SELECT careerID, skillTypeID, levels FROM careerSkills", mCareerSkills )
+        && _LoadSkills( "SELECT specialityID, skillTypeID, levels FROM specialitySkills", mSpecialitySkills );
+}
+
+bool CharCreationTemplates::Setup( const CharacterType& type, CharacterData& cdata, Start& into )
+{
+    //Set the character's career based on the school they picked.
+    std::map< uint32, uint32 >::const_iterator res = mSchoolCareers.find( cdata.schoolID );
+    if( res != mSchoolCareers.end() )
+    {
+        // Right now we don't know what causes the specialization switch, so just make both values the same
+        cdata.careerID = res->second;
+        cdata.careerSpecialityID = cdata.careerID;
+    }
+    else
+    {
+        codelog( SERVICE__WARNING, "Could not find default School ID %u. Using Caldari Military.", cdata.schoolID );
+        cdata.careerID = DEFAULT_CAREER_ID;
+        cdata.careerSpecialityID = DEFAULT_CAREER_ID;
+    }
+
+    std::map< uint32, Career >::const_iterator career = mCareers.find( cdata.careerID );
+    std::map< uint32, Ancestry >::const_iterator ancestry = mAncestries.find( cdata.ancestryID );
+    if( career == mCareers.end() || ancestry == mAncestries.end() )
+    {
+        codelog( CLIENT__ERROR, "Failed to load char create details. Bloodline %u, ancestry %u.",
+            type.bloodlineID(), cdata.ancestryID );
+        ++mStats.failures;
+        return false;
+    }
+
+    cdata.corporationID = career->second.corporationID;
+    cdata.schoolID = career->second.schoolID;
+    cdata.allianceID = career->second.allianceID;
+    cdata.stationID = career->second.location.stationID;
+    cdata.solarSystemID = career->second.location.solarSystemID;
+    cdata.constellationID = career->second.location.constellationID;
+    cdata.regionID = career->second.location.regionID;
+
+    into.intelligence = type.intelligence() + ancestry->second.intelligence;
+    into.charisma = type.charisma() + ancestry->second.charisma;
+    into.perception = type.perception() + ancestry->second.perception;
+    into.memory = type.memory() + ancestry->second.memory;
+    into.willpower = type.willpower() + ancestry->second.willpower;
+
+    // Change starting corperation based on value in XML file.
+    if( sConfig.character.startCorporation ) // Skip if 0
+    {
+        if( mStartCorporation )
+            cdata.corporationID = mStartCorporation;
+        else
+            codelog( SERVICE__WARNING, "Could not find default Corporation ID %u. Using Career Defaults instead.", sConfig.character.startCorporation );
+    }
+    else
+    {
+        res = mSchoolCorporations.find( cdata.schoolID );
+        if( res != mSchoolCorporations.end() )
+            cdata.corporationID = res->second;
+        else
+            codelog( SERVICE__ERROR, "Could not place character in default corporation for school." );
+    }
+
+    // Added ability to set starting station in xml config by Pyrii
+    if( sConfig.character.startStation ) // Skip if 0
+    {
+        if( mStartStation )
+            _SetLocation( mStartStation, cdata );
+        else
+            codelog( SERVICE__WARNING, "Could not find default station ID %u. Using Career Defaults instead.", sConfig.character.startStation );
+    }
+    else
+    {
+        res = mCorporationStations.find( cdata.corporationID );
+        if( res != mCorporationStations.end() )
+        {
+            if( !_SetLocation( res->second, cdata ) )
+                codelog( SERVICE__WARNING, "Could not find default station ID %u.", res->second );
+        }
+        else
+            codelog( SERVICE__ERROR, "Could not place character in default station for school." );
+    }
+
+    // the skills of the race, career and speciality merge once
+    const uint64 key = _TemplateKey( type.race(), cdata.careerID, cdata.careerSpecialityID );
+    std::map< uint64, SkillMap >::iterator skills = mTemplates.find( key );
+    if( skills == mTemplates.end() )
+    {
+        skills = mTemplates.insert( std::make_pair( key, SkillMap() ) ).first;
+
+        std::map< uint32, SkillMap >::const_iterator from = mRaceSkills.find( type.race() );
+        if( from != mRaceSkills.end() )
+            _AddSkills( from->second, skills->second );
+        from = mCareerSkills.find( cdata.careerID );
+        if( from != mCareerSkills.end() )
+            _AddSkills( from->second, skills->second );
+        from = mSpecialitySkills.find( cdata.careerSpecialityID );
+        if( from != mSpecialitySkills.end() )
+            _AddSkills( from->second, skills->second );
+
+        ++mStats.merges;
+    }
+    into.skills = &skills->second;
+
+    ++mStats.setups;
+    return true;
+}
+
+bool CharCreationTemplates::_LoadSkills( const char* query, std::map< uint32, SkillMap >& into )
+{
+    DBQueryResult res;
+    if( !sDatabase.RunQuery( res, "%s", query ) )
+    {
+        codelog( SERVICE__ERROR, "Error in query: %s", res.error.c_str() );
+        return false;
+    }
+
+    DBResultRow row;
+    while( res.GetRow( row ) )
+    {
+        uint32& level = into[ row.GetUInt( 0 ) ][ row.GetUInt( 1 ) ];
+        level = std::min( level + row.GetUInt( 2 ), MAX_STARTING_SKILL_LEVEL );
+    }
+
+    return true;
+}
+
+void CharCreationTemplates::_AddSkills( const SkillMap& from, SkillMap& into )
+{
+    SkillMap::const_iterator cur, end;
+    cur = from.begin();
+    end = from.end();
+    for(; cur != end; cur++)
+    {
+        uint32& level = into[ cur->first ];
+        level = std::min( level + cur->second, MAX_STARTING_SKILL_LEVEL );
+    }
+}
+
+bool CharCreationTemplates::_SetLocation( uint32 stationID, CharacterData& cdata ) const
+{
+    std::map< uint32, Location >::const_iterator res = mStations.find( stationID );
+    if( res == mStations.end() )
+        return false;
+
+    cdata.stationID = res->second.stationID;
+    cdata.solarSystemID = res->second.solarSystemID;
+    cdata.constellationID = res->second.constellationID;
+    cdata.regionID = res->second.regionID;
+    return true;
+}
@@ -47,7 +47,7 @@ CharFittingMgrService::~CharFittingMgrService() {
 
 PyResult CharFittingMgrService::Handle_GetFittings(PyCallArgs &call) {
 
-    sLog.Debug("Server", "Called GetFittigs Stub.");
+    _debug("Server", "Called GetFittigs Stub.");
 
     return NULL;
 }
@@ -54,17 +54,21 @@ CharMgrService::~CharMgrService() {
 
 PyResult CharMgrService::Handle_GetContactList(PyCallArgs &call)
 {
-    // another dummy
+    PyObjectEx *addresses = m_db.GetContacts(call.client->GetCharacterID());
+    if(addresses == NULL)
+        return NULL;
+
+    // blocking is not supported yet
     DBRowDescriptor *header = new DBRowDescriptor();
     header->AddColumn("contactID", DBTYPE_I4);
     header->AddColumn("inWatchList", DBTYPE_BOOL);
     header->AddColumn("relationshipID", DBTYPE_R8);
     header->AddColumn("labelMask", DBTYPE_I8);
-    CRowSet *rowset = new CRowSet( &header );
+    CRowSet *blocked = new CRowSet( &header );
 
     PyDict* dict = new PyDict();
-    dict->SetItemString("addresses", rowset);
-    dict->SetItemString("blocked", rowset);
+    dict->SetItemString("addresses", addresses);
+    dict->SetItemString("blocked", blocked);
     PyObject *keyVal = new PyObject( "util.KeyVal", dict);
 
     return keyVal;
@@ -128,7 +132,7 @@ PyResult CharMgrService::Handle_GetPublicInfo3(PyCallArgs &call) {
 
 PyResult CharMgrService::Handle_GetTopBounties( PyCallArgs& call )
 {
-    sLog.Debug( "CharMgrService", "Called GetTopBounties stub." );
+    _debug( "CharMgrService", "Called GetTopBounties stub." );
 
     util_Rowset rs;
     rs.lines = new PyList;
@@ -143,35 +147,35 @@ PyResult CharMgrService::Handle_GetTopBounties( PyCallArgs& call )
 
 PyResult CharMgrService::Handle_GetCloneTypeID( PyCallArgs& call )
 {
-    sLog.Debug( "CharMgrService", "Called GetCloneTypeID stub." );
+    _debug( "CharMgrService", "Called GetCloneTypeID stub." );
 
     return NULL;
 }
 
 PyResult CharMgrService::Handle_GetHomeStation( PyCallArgs& call )
 {
-    sLog.Debug( "CharMgrService", "Called GetHomeStation stub." );
+    _debug( "CharMgrService", "Called GetHomeStation stub." );
 
     return NULL;
 }
 
 PyResult CharMgrService::Handle_GetFactions( PyCallArgs& call )
 {
-    sLog.Debug( "CharMgrService", "Called GetFactions stub." );
+    _debug( "CharMgrService", "Called GetFactions stub." );
 
     return NULL;
 }
 
 PyResult CharMgrService::Handle_SetActivityStatus( PyCallArgs& call )
 {
-    sLog.Debug( "CharMgrService", "Called SetActivityStatus stub." );
+    _debug( "CharMgrService", "Called SetActivityStatus stub." );
 
     return NULL;
 }
 
 PyResult CharMgrService::Handle_GetSettingsInfo( PyCallArgs& call )
 {
-    sLog.Debug( "CharMgrService", "Called GetSettingsInfo stub." );
+    _debug( "CharMgrService", "Called GetSettingsInfo stub." );
 
     return NULL;
 }
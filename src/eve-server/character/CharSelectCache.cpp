@@ -0,0 +1,172 @@
+/*
+    ------------------------------------------------------------------------------------
+    LICENSE:
+    ------------------------------------------------------------------------------------
+    This file is part of EVEmu: EVE Online Server Emulator
+    Copyright 2006 - 2011 The EVEmu Team
+    For the latest information visit http://evemu.org
+    ------------------------------------------------------------------------------------
+    This program is free software; you can redistribute it and/or modify it under
+    the terms of the GNU Lesser General Public License as published by the Free Software
+    Foundation; either version 2 of the License, or (at your option) any later
+    version.
+
+    This program is distributed in the hope that it will be useful, but WITHOUT
+    ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+    FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public License along with
+    this program; if not, write to the Free Software Foundation, Inc., 59 Temple
+    Place - Suite 330, Boston, MA 02111-1307, USA, or go to
+    http://www.gnu.org/copyleft/lesser.txt.
+    ------------------------------------------------------------------------------------
+    Author:     EVEmu Team
+*/
+
+
+#include "eve-server.h"
+
+#include "character/CharSelectCache.h"
+#include "character/CharacterDB.h"
+
+CharSelectCache::CharSelectCache()
+{
+}
+
+CharSelectCache::~CharSelectCache()
+{
+    RowsetMap::iterator cur, end;
+    cur = mLists.begin();
+    end = mLists.end();
+    for(; cur != end; ++cur )
+        PyDecRef( cur->second );
+
+    cur = mInfos.begin();
+    end = mInfos.end();
+    for(; cur != end; ++cur )
+        PyDecRef( cur->second );
+}
+
+bool CharSelectCache::Load()
+{
+    DBQueryResult lists;
+    if( !CharacterDB::GetAllCharacterLists( lists ) )
+        return false;
+
+    DBResultRow row;
+    while( lists.GetRow( row ) )
+        mAccounts[ row.GetUInt( 0 ) ] = row.GetUInt( row.ColumnCount() - 1 );
+
+    lists.Reset();
+    _SplitResult( lists, mLists );
+
+    DBQueryResult infos;
+    if( !CharacterDB::GetAllCharSelectInfo( infos ) )
+        return false;
+
+    _SplitResult( infos, mInfos );
+    return true;
+}
+
+PyRep* CharSelectCache::GetCharacterList( uint32 accountID )
+{
+    RowsetMap::iterator res = mLists.find( accountID );
+    if( res == mLists.end() )
+    {
+        PyRep* list = CharacterDB::GetCharacterList( accountID );
+        if( NULL == list )
+            return NULL;
+
+        res = mLists.insert( std::make_pair( accountID, list ) ).first;
+        ++mStats.misses;
+    }
+    else
+        ++mStats.hits;
+
+    PyIncRef( res->second );
+    return res->second;
+}
+
+PyRep* CharSelectCache::GetCharSelectInfo( uint32 characterID )
+{
+    RowsetMap::iterator res = mInfos.find( characterID );
+    if( res == mInfos.end() )
+    {
+        PyRep* info = CharacterDB::GetCharSelectInfo( characterID );
+        if( NULL == info )
+            return NULL;
+
+        res = mInfos.insert( std::make_pair( characterID, info ) ).first;
+        ++mStats.misses;
+    }
+    else
+        ++mStats.hits;
+
+    PyIncRef( res->second );
+    return res->second;
+}
+
+void CharSelectCache::InvalidateAccount( uint32 accountID )
+{
+    _Drop( mLists, accountID );
+    ++mStats.invalidations;
+}
+
+void CharSelectCache::InvalidateCharacter( uint32 characterID )
+{
+    _Drop( mInfos, characterID );
+    ++mStats.invalidations;
+
+    std::tr1::unordered_map< uint32, uint32 >::iterator res = mAccounts.find( characterID );
+    if( res != mAccounts.end() )
+    {
+        InvalidateAccount( res->second );
+        mAccounts.erase( res );
+    }
+}
+
+void CharSelectCache::_SplitResult( DBQueryResult& res, RowsetMap& into )
+{
+    const uint32 cc = res.ColumnCount() - 1;
+
+    // the header without the key column, shared by all the rowsets
+    DBRowDescriptor* header = new DBRowDescriptor;
+    for( uint32 i = 0; i < cc; ++i )
+        header->AddColumn( res.ColumnName( i ), res.ColumnType( i ) );
+
+    CRowSet* rowset = NULL;
+    uint32 key = 0;
+
+    DBResultRow row;
+    while( res.GetRow( row ) )
+    {
+        const uint32 rowKey = row.GetUInt( cc );
+        if( NULL == rowset || rowKey != key )
+        {
+            key = rowKey;
+
+            DBRowDescriptor* h = header;
+            PyIncRef( h );
+            rowset = new CRowSet( &h );
+
+            _Drop( into, key );
+            into[ key ] = rowset;
+        }
+
+        PyPackedRow* packed = rowset->NewRow();
+        for( uint32 i = 0; i < cc; ++i )
+            packed->SetField( i, DBColumnToPyRep( row, i ) );
+    }
+
+    PyDecRef( header );
+}
+
+void CharSelectCache::_Drop( RowsetMap& map, uint32 key )
+{
+    RowsetMap::iterator res = map.find( key );
+    if( res != map.end() )
+    {
+        PyDecRef( res->second );
+        map.erase( res );
+    }
+}
@@ -28,7 +28,11 @@
 #include "EVEServerConfig.h"
 #include "PyServiceCD.h"
 #include "cache/ObjCacheService.h"
+#include "character/CharCreationTemplates.h"
+#include "character/CharSelectCache.h"
 #include "character/CharUnboundMgrService.h"
+#include "character/LoginPipeline.h"
+#include "character/PaperDollStore.h"
 #include "imageserver/ImageServer.h"
 
 PyCallable_Make_InnerDispatcher(CharUnboundMgrService)
@@ -80,12 +84,13 @@ PyResult CharUnboundMgrService::Handle_SelectCharacterID(PyCallArgs &call) {
         return NULL;
     }
 
-    call.client->SelectCharacter(arg.charID);
+    //the session change follows once the character is loaded
+    sLoginPipeline.Start(call.client, arg.charID);
     return NULL;
 }
 
 PyResult CharUnboundMgrService::Handle_GetCharactersToSelect(PyCallArgs &call) {
-    return(m_db.GetCharacterList(call.client->GetAccountID()));
+    return(sCharSelectCache.GetCharacterList(call.client->GetAccountID()));
 }
 
 PyResult CharUnboundMgrService::Handle_GetCharacterToSelect(PyCallArgs &call) {
@@ -95,7 +100,7 @@ PyResult CharUnboundMgrService::Handle_GetCharacterToSelect(PyCallArgs &call) {
         return NULL;
     }
 
-    PyRep *result = m_db.GetCharSelectInfo(args.arg);
+    PyRep *result = sCharSelectCache.GetCharSelectInfo(args.arg);
     if(result == NULL) {
         _log(CLIENT__ERROR, "Failed to load character %d", args.arg);
         return NULL;
@@ -111,6 +116,9 @@ PyResult CharUnboundMgrService::Handle_DeleteCharacter(PyCallArgs &call) {
         return NULL;
     }
 
+    sCharSelectCache.InvalidateAccount(call.client->GetAccountID());
+    sCharSelectCache.InvalidateCharacter(args.arg);
+
     return m_db.DeleteCharacter(call.client->GetAccountID(), args.arg);
 }
 
@@ -121,7 +129,12 @@ PyResult CharUnboundMgrService::Handle_PrepareCharacterForDelete(PyCallArgs &cal
         return NULL;
     }
 
-    return new PyLong((int64)m_db.PrepareCharacterForDelete(call.client->GetAccountID(), args.arg));
+    PyLong *result = new PyLong((int64)m_db.PrepareCharacterForDelete(call.client->GetAccountID(), args.arg));
+
+    //deletePrepareDateTime is in the character list
+    sCharSelectCache.InvalidateAccount(call.client->GetAccountID());
+
+    return result;
 }
 
 PyResult CharUnboundMgrService::Handle_CancelCharacterDeletePrepare(PyCallArgs &call) {
@@ -132,6 +145,7 @@ PyResult CharUnboundMgrService::Handle_CancelCharacterDeletePrepare(PyCallArgs &
     }
 
     m_db.CancelCharacterDeletePrepare(call.client->GetAccountID(), args.arg);
+    sCharSelectCache.InvalidateAccount(call.client->GetAccountID());
 
     // the client doesn't care what we return here
     return NULL;
@@ -181,7 +195,6 @@ PyResult CharUnboundMgrService::Handle_CreateCharacterWithDoll(PyCallArgs &call)
     // we need to fill these to successfully create character item
     ItemData idata;
     CharacterData cdata;
-    CharacterAppearance capp;
     CorpMemberInfo corpData;
 
     idata.typeID = char_type->id();
@@ -195,82 +208,19 @@ PyResult CharUnboundMgrService::Handle_CreateCharacterWithDoll(PyCallArgs &call)
     cdata.ancestryID = arg.ancestryID;
     cdata.schoolID = arg.schoolID;
 
-    //Set the character's career based on the school they picked.
-    if( m_db.GetCareerBySchool( cdata.schoolID, cdata.careerID ) ) {
-        // Right now we don't know what causes the specialization switch, so just make both values the same
-        cdata.careerSpecialityID = cdata.careerID;
-    } else {
-        codelog(SERVICE__WARNING, "Could not find default School ID %u. Using Caldari Military.", cdata.schoolID);
-        cdata.careerID = 11;
-        cdata.careerSpecialityID = 11;
-    }
-
     corpData.corpRole = 0;
     corpData.rolesAtAll = 0;
     corpData.rolesAtBase = 0;
     corpData.rolesAtHQ = 0;
     corpData.rolesAtOther = 0;
 
-    // Variables for storing attribute bonuses
-    uint8 intelligence = char_type->intelligence();
-    uint8 charisma = char_type->charisma();
-    uint8 perception = char_type->perception();
-    uint8 memory = char_type->memory();
-    uint8 willpower = char_type->willpower();
-
-    // Setting character's starting position, and getting it's location...
-    // Also query attribute bonuses from ancestry
-    if(    !m_db.GetLocationCorporationByCareer(cdata)
-        || !m_db.GetAttributesFromAncestry(cdata.ancestryID, intelligence, charisma, perception, memory, willpower)
-    ) {
-        codelog(CLIENT__ERROR, "Failed to load char create details. Bloodline %u, ancestry %u.",
-            char_type->bloodlineID(), cdata.ancestryID);
+    // career, corporation, location, attributes and skills all come from the templates
+    CharCreationTemplates::Start start;
+    if( !sCharCreationTemplates.Setup( *char_type, cdata, start ) )
         return NULL;
-    }
 
     idata.locationID = cdata.stationID; // Just so our starting items end up in the same place.
 
-    // Change starting corperation based on value in XML file.
-    if( sConfig.character.startCorporation ) { // Skip if 0
-        if( m_db.DoesCorporationExist( sConfig.character.startCorporation ) ) {
-            cdata.corporationID = sConfig.character.startCorporation;
-        } else {
-            codelog(SERVICE__WARNING, "Could not find default Corporation ID %u. Using Career Defaults instead.", sConfig.character.startCorporation);
-        }
-    }
-    else
-    {
-        uint32 corporationID;
-        if(m_db.GetCorporationBySchool(cdata.schoolID, corporationID))
-        {
-            cdata.corporationID = corporationID;
-        }
-        else
-        {
-            codelog(SERVICE__ERROR, "Could not place character in default corporation for school.");
-        }
-    }
-
-    // Added ability to set starting station in xml config by Pyrii
-    if( sConfig.character.startStation ) { // Skip if 0
-        if( !m_db.GetLocationByStation(sConfig.character.startStation, cdata) ) {
-            codelog(SERVICE__WARNING, "Could not find default station ID %u. Using Career Defaults instead.", sConfig.character.startStation);
-        }
-    }
-    else
-    {
-        uint32 stationID;
-        if (m_db.GetCareerStationByCorporation(cdata.corporationID, stationID))
-        {
-            if(!m_db.GetLocationByStation(stationID, cdata))
-                codelog(SERVICE__WARNING, "Could not find default station ID %u.", stationID);
-        }
-        else
-        {
-            codelog(SERVICE__ERROR, "Could not place character in default station for school.");
-        }
-    }
-
     cdata.bounty = 0;
     cdata.balance = sConfig.character.startBalance;
     cdata.aurBalance = 0; // TODO Add aurBalance to the databas
@@ -282,116 +232,73 @@ PyResult CharUnboundMgrService::Handle_CreateCharacterWithDoll(PyCallArgs &call)
     cdata.createDateTime = cdata.startDateTime;
     cdata.corporationDateTime = cdata.startDateTime;
 
-    //this builds appearance data from strdict --- no longer relevant with the next gen stuff
-    //capp.Build(arg.appearance);
-
-    typedef std::map<uint32, uint32>        CharSkillMap;
-    typedef CharSkillMap::iterator          CharSkillMapItr;
-
-    //load skills
-    CharSkillMap startingSkills;
-    if( !m_db.GetSkillsByRace(char_type->race(), startingSkills) )
-    {
-        codelog(CLIENT__ERROR, "Failed to load char create skills. Bloodline %u, Ancestry %u.",
-            char_type->bloodlineID(), cdata.ancestryID);
-        return NULL;
-    }
-
-    //now we have all the data we need, stick it in the DB
-    //create char item
-    CharacterRef char_item = m_manager->item_factory.SpawnCharacter(idata, cdata, capp, corpData);
-    if( !char_item ) {
-        //a return to the client of 0 seems to be the only means of marking failure
-        codelog(CLIENT__ERROR, "Failed to create character '%s'", idata.name.c_str());
-        return NULL;
-    }
-
     // add attribute bonuses
-    // (use Set_##_persist to properly persist attributes into DB)
-    /*char_item->Set_intelligence_persist(intelligence);
-    char_item->Set_charisma_persist(charisma);
-    char_item->Set_perception_persist(perception);
-    char_item->Set_memory_persist(memory);
-    char_item->Set_willpower_persist(willpower);*/
-
-    char_item->SetAttribute(AttrIntelligence, intelligence);
-    char_item->SetAttribute(AttrCharisma, charisma);
-    char_item->SetAttribute(AttrPerception, perception);
-    char_item->SetAttribute(AttrMemory, memory);
-    char_item->SetAttribute(AttrWillpower, willpower);
-
-    // register name
-    m_db.add_name_validation_set(char_item->itemName().c_str(), char_item->itemID());
-
-    //spawn all the skills
-    uint32 skillLevel;
-    EvilNumber skillPoints;
-    CharSkillMapItr cur, end;
-    cur = startingSkills.begin();
-    end = startingSkills.end();
+    ItemAttributeList attributes;
+    attributes.push_back( std::make_pair( (uint32)AttrIntelligence, EvilNumber( start.intelligence ) ) );
+    attributes.push_back( std::make_pair( (uint32)AttrCharisma, EvilNumber( start.charisma ) ) );
+    attributes.push_back( std::make_pair( (uint32)AttrPerception, EvilNumber( start.perception ) ) );
+    attributes.push_back( std::make_pair( (uint32)AttrMemory, EvilNumber( start.memory ) ) );
+    attributes.push_back( std::make_pair( (uint32)AttrWillpower, EvilNumber( start.willpower ) ) );
+
+    // the items go into the character (the skills) or its hangar
+    std::vector<ItemData> items;
+    std::vector<ItemAttributeList> itemAttributes;
+
+    //all the skills
+    CharCreationTemplates::SkillMap::const_iterator cur, end;
+    cur = start.skills->begin();
+    end = start.skills->end();
     for(; cur != end; cur++)
     {
-        ItemData skillItem( cur->first, char_item->itemID(), char_item->itemID(), flagSkill );
-        SkillRef i = m_manager->item_factory.SpawnSkill( skillItem );
-        if( !i ) {
-            _log(CLIENT__ERROR, "Failed to add skill %u to char %s (%u) during char create.", cur->first, char_item->itemName().c_str(), char_item->itemID());
+        const ItemType *skillType = m_manager->item_factory.GetType( cur->first );
+        if( skillType == NULL ) {
+            _log(CLIENT__ERROR, "Failed to add skill %u to char %s during char create.", cur->first, idata.name.c_str());
             continue;
         }
 
-        //_log(CLIENT__MESSAGE, "Training skill %u to level %d (%d points)", i->typeID(), i->skillLevel(), i->skillPoints());
-        //i->Set_skillLevel( cur->second );
-        skillLevel = cur->second;
-        i->SetAttribute(AttrSkillLevel, skillLevel );
-        //i->Set_skillPoints( i->GetSPForLevel( cur->second ) );
-        skillPoints = i->GetSPForLevel( EvilNumber((uint64)cur->second) );
+        items.push_back( ItemData( cur->first, 0, 0, flagSkill ) );
+
+        EvilNumber skillPoints = Skill::GetSPForLevel( *skillType, EvilNumber((uint64)cur->second) );
         skillPoints.to_float();
-        //if( !(skillPoints.to_int()) )
-        //    sLog.Error( "CharacterService::Handle_CreateCharacter2()", "skillPoints.to_int() failed, resulting in a floating point value larger than a 64-bit signed integer... o.O !!" );
-        i->SetAttribute(AttrSkillPoints, skillPoints );
-        i->SaveAttributes();
-        //i->mAttributeMap.Save();
+
+        itemAttributes.push_back( ItemAttributeList() );
+        itemAttributes.back().push_back( std::make_pair( (uint32)AttrSkillLevel, EvilNumber((uint64)cur->second) ) );
+        itemAttributes.back().push_back( std::make_pair( (uint32)AttrSkillPoints, skillPoints ) );
     }
 
     //now set up some initial inventory:
-    InventoryItemRef initInvItem;
-
     // add "Damage Control I"
-    ItemData itemDamageControl( 2046, char_item->itemID(), char_item->locationID(), flagHangar, 1 );
-    initInvItem = m_manager->item_factory.SpawnItem( itemDamageControl );
-
-    if( !initInvItem )
-        codelog(CLIENT__ERROR, "%s: Failed to spawn a starting item", char_item->itemName().c_str());
-
+    items.push_back( ItemData( 2046, 0, cdata.stationID, flagHangar, 1 ) );
     // add 1 unit of "Tritanium"
-    ItemData itemTritanium( 34, char_item->itemID(), char_item->locationID(), flagHangar, 1 );
-    initInvItem = m_manager->item_factory.SpawnItem( itemTritanium );
-
+    items.push_back( ItemData( 34, 0, cdata.stationID, flagHangar, 1 ) );
     // add 1 unit of "Clone Grade Alpha"
-    ItemData itemCloneAlpha( 164, char_item->itemID(), char_item->locationID(), flagClone, 1 );
-    itemCloneAlpha.customInfo="active";
-    initInvItem = m_manager->item_factory.SpawnItem( itemCloneAlpha );
-
-    if( !initInvItem )
-        codelog(CLIENT__ERROR, "%s: Failed to spawn a starting item", char_item->itemName().c_str());
+    items.push_back( ItemData( 164, 0, cdata.stationID, flagClone, 1 ) );
+    items.back().customInfo = "active";
 
     // give the player its ship.
-    std::string ship_name = char_item->itemName() + "'s Ship";
-
-    ItemData shipItem( char_type->shipTypeID(), char_item->itemID(), char_item->locationID(), flagHangar, ship_name.c_str() );
-    ShipRef ship_item = m_manager->item_factory.SpawnShip( shipItem );
+    std::string ship_name = idata.name + "'s Ship";
+    const size_t shipIndex = items.size();
+    items.push_back( ItemData( char_type->shipTypeID(), 0, cdata.stationID, flagHangar, ship_name.c_str() ) );
 
-    // Set shipID
-    //DBQueryResult res;
-    //sDatabase.RunQuery(res, "UPDATE character_ SET shipID = %u WHERE characterID = %u", ship_item->itemID(), char_item->itemID());
-    char_item->SetActiveShip( ship_item->itemID() );
-    char_item->SaveCharacter();
+    itemAttributes.resize( items.size() );
 
-    if( !ship_item ) {
-        codelog(CLIENT__ERROR, "%s: Failed to spawn a starting item", char_item->itemName().c_str());
+    //now we have all the data we need, stick it in the DB in one go
+    std::vector<InventoryItemRef> startingItems;
+    CharacterRef char_item = m_manager->item_factory.SpawnCharacterWithItems( idata, cdata, corpData, attributes, items, itemAttributes, shipIndex, startingItems );
+    if( !char_item ) {
+        //a return to the client of 0 seems to be the only means of marking failure
+        codelog(CLIENT__ERROR, "Failed to create character '%s'", idata.name.c_str());
+        return NULL;
     }
-    else
-        //welcome on board your starting ship
-        //char_item->MoveInto( *ship_item, flagPilot, false );
+
+    // register name
+    m_db.add_name_validation_set(char_item->itemName().c_str(), char_item->itemID());
+
+    // the doll and the portrait go into a single blob
+    PyIncRef(arg.charInfo);
+    PyIncRef(arg.portraitInfo);
+    if(!sPaperDollStore.Save(char_item->itemID(), arg.charInfo, arg.portraitInfo))
+        codelog(CLIENT__ERROR, "Failed to save the paper doll of character %u", char_item->itemID());
 
     _log( CLIENT__MESSAGE, "Sending char create ID %u as reply", char_item->itemID() );
 
@@ -401,5 +308,7 @@ PyResult CharUnboundMgrService::Handle_CreateCharacterWithDoll(PyCallArgs &call)
     // Release the item factory now that the character is finished being accessed:
     m_manager->item_factory.UnsetUsingClient();
 
+    sCharSelectCache.InvalidateAccount(call.client->GetAccountID());
+
     return new PyInt( char_item->itemID() );
 }
@@ -27,8 +27,13 @@
 
 #include "Client.h"
 #include "EntityList.h"
+#include "account/WalletLedger.h"
+#include "chat/NameIndex.h"
+#include "config/OwnerDirectory.h"
+#include "character/CertificateGraph.h"
 #include "character/Character.h"
 #include "inventory/AttributeEnum.h"
+#include "standing/StandingCache.h"
 
 /*
  * CharacterTypeData
@@ -346,7 +351,8 @@ Character::Character(
   m_startDateTime(_charData.startDateTime),
   m_createDateTime(_charData.createDateTime),
   m_corporationDateTime(_charData.corporationDateTime),
-  m_shipID(_charData.shipID)
+  m_shipID(_charData.shipID),
+  m_skillQueueFirstIndex(0)
 {
     // allow characters to be only singletons
     //assert(singleton() && quantity() == -1);
@@ -385,6 +391,10 @@ CharacterRef Character::Spawn(ItemFactory &factory,
 
     CharacterRef charRef = Character::Load( factory, characterID );
 
+    sNameIndex.Add( NameIndex::NAME_CHARACTER, characterID, data.name, data.typeID );
+    // the ID may have been asked for before it existed
+    sOwnerDirectory.Invalidate( characterID );
+
     // Create default dynamic attributes in the AttributeMap:
     charRef.get()->SetAttribute(AttrIsOnline, 1);     // Is Online
 
@@ -429,8 +439,9 @@ bool Character::_Load()
     if( !LoadContents( m_factory ) )
         return false;
 
-    if( !m_factory.db().LoadSkillQueue( itemID(), m_skillQueue ) )
+    if( !m_factory.db().LoadSkillQueue( itemID(), m_skillQueue, m_skillQueueFirstIndex ) )
         return false;
+    m_savedSkillQueue = m_skillQueue;
 
     // Calculate total SP trained and store in internal variable:
     _CalculateTotalSPTrained();
@@ -452,7 +463,7 @@ void Character::Delete() {
     Owner::Delete();
 }
 
-bool Character::AlterBalance(double balanceChange) {
+bool Character::AlterBalance(double balanceChange, bool save) {
     if(balanceChange == 0)
         return true;
 
@@ -464,19 +475,21 @@ bool Character::AlterBalance(double balanceChange) {
 
     m_balance = result;
 
-    //TODO: save some info to journal.
-    SaveCharacter();
+    //only the change is written, by the market journal
+    if(save)
+        sWalletLedger.AddCharacterBalance(itemID(), balanceChange);
 
     return true;
 }
 
-void Character::SetLocation(uint32 stationID, uint32 solarSystemID, uint32 constellationID, uint32 regionID) {
+void Character::SetLocation(uint32 stationID, uint32 solarSystemID, uint32 constellationID, uint32 regionID, bool save) {
     m_stationID = stationID;
     m_solarSystemID = solarSystemID;
     m_constellationID = constellationID;
     m_regionID = regionID;
 
-    SaveCharacter();
+    if( save )
+        SaveCharacter();
 }
 
 void Character::JoinCorporation(uint32 corporationID) {
@@ -546,7 +559,7 @@ SkillRef Character::GetSkillInTraining() const
 {
     InventoryItemRef item;
     if (!FindSingleByFlag(flagSkillInTraining, item))
-        sLog.Debug("Character","unable to find skill in training");
+        _debug("Character","unable to find skill in training");
 
     return SkillRef::StaticCast( item );
 }
@@ -658,6 +671,7 @@ bool Character::InjectSkillIntoBrain(SkillRef skill, uint8 level)
         EvilNumber eTmp = skill->GetAttribute(AttrSkillTimeConstant) * ( pow(2,( 2.5 * level) - 2.5 ) * EVIL_SKILL_BASE_POINTS );
         oldSkill->SetAttribute(AttrSkillPoints, eTmp);
 	oldSkill->SetFlag(flagSkill);
+        sStandingCache.ForgetEffective( itemID() );
         return true;
     }
 
@@ -679,6 +693,7 @@ bool Character::InjectSkillIntoBrain(SkillRef skill, uint8 level)
         skill->MoveInto( *this, flagSkill );
 
     skill->SetAttribute(AttrSkillLevel, level);
+    sStandingCache.ForgetEffective( itemID() );
     //TODO: get right number of skill points
 
     //skill->Set_skillPoints( pow(2,( 2.5 * level) - 2.5 ) * SKILL_BASE_POINTS * ( skill->attributes.GetInt( skill->attributes.Attr_skillTimeConstant ) ) );
@@ -703,13 +718,46 @@ void Character::AddToSkillQueue(uint32 typeID, uint8 level)
 
 bool Character::GrantCertificate( uint32 certificateID )
 {
-    cCertificates i;
-    i.certificateID = certificateID;
-    i.grantDate = Win32TimeNow();
-    i.visibilityFlags = true;
-    m_certificates.push_back( i );
+    std::vector<uint32> granted;
+    GrantCertificates( std::vector<uint32>( 1, certificateID ), granted );
 
-    return true;
+    return !granted.empty();
+}
+
+void Character::GrantCertificates( const std::vector<uint32> &certificateIDs, std::vector<uint32> &granted )
+{
+    std::set<uint32> held;
+    for( size_t i = 0; i < m_certificates.size(); i++ )
+        held.insert( m_certificates[ i ].certificateID );
+
+    std::map<uint32, uint32> levels;
+    std::vector<InventoryItemRef> skills;
+    GetSkillsList( skills );
+    for( size_t i = 0; i < skills.size(); i++ )
+        levels[ skills[ i ]->typeID() ] = static_cast<uint32>( skills[ i ]->GetAttribute( AttrSkillLevel ).get_int() );
+
+    CertificateGraph::SkillBits bits;
+    sCertificateGraph.BuildSkillBits( levels, bits );
+
+    const std::set<uint32> wanted( certificateIDs.begin(), certificateIDs.end() );
+    sCertificateGraph.Evaluate( bits, held, &wanted, granted );
+    if( granted.empty() )
+        return;
+
+    const uint64 now = Win32TimeNow();
+
+    Certificates added;
+    for( size_t i = 0; i < granted.size(); i++ )
+    {
+        cCertificates c;
+        c.certificateID = granted[ i ];
+        c.grantDate = now;
+        c.visibilityFlags = true;
+        added.push_back( c );
+    }
+
+    m_certificates.insert( m_certificates.end(), added.begin(), added.end() );
+    m_factory.db().AddCertificates( itemID(), added );
 }
 
 
@@ -772,7 +820,7 @@ void Character::UpdateSkillQueue()
                 //currentTraining->Set_skillPoints( nextLevelSP - (minRemaining * SPPerMinute) );
                 EvilNumber skillPointsTrained = nextLevelSP - (minRemaining * SPPerMinute);
                 currentTraining->SetAttribute(AttrSkillPoints, skillPointsTrained);
-                sLog.Debug( "", "Skill %s (%u) trained %u skill points before termination from training queue", currentTraining->itemName().c_str(), currentTraining->itemID(), skillPointsTrained.get_float() );
+                _debug( "", "Skill %s (%u) trained %u skill points before termination from training queue", currentTraining->itemName().c_str(), currentTraining->itemID(), skillPointsTrained.get_float() );
             }
 
             currentTraining->SetAttribute(AttrExpiryTime, 0);
@@ -813,13 +861,13 @@ void Character::UpdateSkillQueue()
                 break;
             }
 
-            sLog.Debug( "Character::UpdateSkillQueue()", "%s (%u): Starting training of skill %s (%u)",  m_itemName.c_str(), m_itemID, currentTraining->itemName().c_str(), currentTraining->itemID() );
+            _debug( "Character::UpdateSkillQueue()", "%s (%u): Starting training of skill %s (%u)",  m_itemName.c_str(), m_itemID, currentTraining->itemName().c_str(), currentTraining->itemID() );
 
             EvilNumber SPPerMinute = GetSPPerMin( currentTraining );
             EvilNumber NextLevel = currentTraining->GetAttribute(AttrSkillLevel) + 1;
             EvilNumber SPToNextLevel = currentTraining->GetSPForLevel( NextLevel ) - currentTraining->GetAttribute(AttrSkillPoints);
-            sLog.Debug( "    ", "Training skill at %f SP/min", SPPerMinute.get_float() );
-            sLog.Debug( "    ", "%f SP to next Level of %d", SPToNextLevel.get_float(), NextLevel.get_int() );
+            _debug( "    ", "Training skill at %f SP/min", SPPerMinute.get_float() );
+            _debug( "    ", "%f SP to next Level of %d", SPToNextLevel.get_float(), NextLevel.get_int() );
 
             SPPerMinute.to_float();
             SPToNextLevel.to_float();
@@ -831,7 +879,7 @@ void Character::UpdateSkillQueue()
             currentTraining->SetAttribute(AttrExpiryTime, dbl_timeTraining);    // Set server-side
                                                                                 // skill expiry + 10 sec
 
-            sLog.Debug( "    ", "Calculated time to complete training = %s", Win32TimeToString((uint64)dbl_timeTraining).c_str() );
+            _debug( "    ", "Calculated time to complete training = %s", Win32TimeToString((uint64)dbl_timeTraining).c_str() );
 
             if( c != NULL )
             {
@@ -849,10 +897,11 @@ void Character::UpdateSkillQueue()
 
         if( currentTraining->GetAttribute(AttrExpiryTime) <= EvilTimeNow() ) {
             // training has been finished:
-            sLog.Debug( "Character::UpdateSkillQueue()", "%s (%u): Finishing training of skill %s (%u).", itemName().c_str(), itemID(), currentTraining->itemName().c_str(), currentTraining->itemID() );
+            _debug( "Character::UpdateSkillQueue()", "%s (%u): Finishing training of skill %s (%u).", itemName().c_str(), itemID(), currentTraining->itemName().c_str(), currentTraining->itemID() );
 
             currentTraining->SetAttribute(AttrSkillLevel, currentTraining->GetAttribute(AttrSkillLevel) + 1 );
             currentTraining->SetAttribute(AttrSkillPoints, currentTraining->GetSPForLevel( currentTraining->GetAttribute(AttrSkillLevel) ), true);
+            sStandingCache.ForgetEffective( itemID() );
 
             nextStartTime = currentTraining->GetAttribute(AttrExpiryTime);
             currentTraining->SetAttribute(AttrExpiryTime, 0);
@@ -1003,7 +1052,7 @@ void Character::SaveCharacter()
     // Calculate total Skill Points trained at this time to save to DB:
     _CalculateTotalSPTrained();
 
-    sLog.Debug( "Character::SaveCharacter()", "Saving all character info and skill attribute info to DB for character %s...", itemName().c_str() );
+    _debug( "Character::SaveCharacter()", "Saving all character info and skill attribute info to DB for character %s...", itemName().c_str() );
     // character data
     m_factory.db().SaveCharacter(
         itemID(),
@@ -1067,11 +1116,14 @@ void Character::SaveCharacter()
 void Character::SaveSkillQueue() const {
     _log( ITEM__TRACE, "Saving skill queue of character %u.", itemID() );
 
-    // skill queue
-    m_factory.db().SaveSkillQueue(
+    // skill queue; only the difference to what was saved is written
+    if( m_factory.db().SaveSkillQueue(
         itemID(),
+        m_savedSkillQueue,
+        m_skillQueueFirstIndex,
         m_skillQueue
-    );
+    ) )
+        m_savedSkillQueue = m_skillQueue;
 }
 
 void Character::SaveCertificates() const
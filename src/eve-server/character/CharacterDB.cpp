@@ -141,6 +141,27 @@ PyRep *CharacterDB::GetCharacterList(uint32 accountID) {
     return DBResultToCRowset(res);
 }
 
+bool CharacterDB::GetAllCharacterLists(DBQueryResult &res) {
+    //the columns of GetCharacterList() with accountID last
+    if(!sDatabase.RunQuery(res,
+        "SELECT"
+        " characterID,"
+        " itemName AS characterName,"
+        " deletePrepareDateTime,"
+        " gender,"
+        " typeID,"
+        " accountID"
+        " FROM character_ "
+        "    LEFT JOIN entity ON characterID = itemID"
+        " ORDER BY accountID"))
+    {
+        codelog(SERVICE__ERROR, "Error in query: %s", res.error.c_str());
+        return false;
+    }
+
+    return true;
+}
+
 bool CharacterDB::ValidateCharName(const char *name)
 {
     if (name == NULL || *name == '\0')
@@ -163,25 +184,22 @@ bool CharacterDB::ValidateCharName(const char *name)
 PyRep *CharacterDB::GetCharSelectInfo(uint32 characterID) {
     DBQueryResult res;
 
-    uint32 worldSpaceID = 0;
+    char where[64];
+    snprintf(where, sizeof(where), "WHERE character_.characterID=%u", characterID);
 
-    std::string shipName = "My Ship";
-    uint32 shipTypeID = 606;
+    if(!_QueryCharSelectInfo(res, "", where))
+        return NULL;
 
-    DBQueryResult res2;
-    if(!sDatabase.RunQuery(res2, "SELECT itemName, typeID FROM entity WHERE itemID = (SELECT shipID FROM character_ WHERE characterID = %u)", characterID))
-    {
-        codelog(SERVICE__WARNING, "Unable to get current ship: %s", res.error.c_str());
-    }
-    else
-    {
-        DBResultRow row;
-        while(res2.GetRow(row))
-        {
-            sDatabase.DoEscapeString(shipName, row.GetText(0));
-            shipTypeID = row.GetUInt(1);
-        }
-    }
+    return DBResultToCRowset(res);
+}
+
+bool CharacterDB::GetAllCharSelectInfo(DBQueryResult &res) {
+    //the columns of GetCharSelectInfo() with characterID last
+    return _QueryCharSelectInfo(res, ", character_.characterID", "ORDER BY character_.characterID");
+}
+
+bool CharacterDB::_QueryCharSelectInfo(DBQueryResult &res, const char *extraColumns, const char *condition) {
+    uint32 worldSpaceID = 0;
 
     uint32 unreadMailCount = 0;
     uint32 upcomingEventCount = 0;
@@ -192,25 +210,27 @@ PyRep *CharacterDB::GetCharSelectInfo(uint32 characterID) {
     uint64 allianceMemberStartDate = Win32TimeNow() - 15*Win32Time_Day;
     uint64 startDate = Win32TimeNow() - 24*Win32Time_Day;
 
+    //the current ship is joined in, "My Ship" (606) if there is none
     if(!sDatabase.RunQuery(res,
         "SELECT "
-        " itemName AS shortName,bloodlineID,gender,bounty,character_.corporationID,allianceID,title,startDateTime,createDateTime,"
+        " entity.itemName AS shortName,bloodlineID,gender,bounty,character_.corporationID,allianceID,title,startDateTime,createDateTime,"
         " securityRating,character_.balance, 0 As aurBalance,character_.stationID,solarSystemID,constellationID,regionID,"
-        " petitionMessage,logonMinutes,tickerName, %u AS worldSpaceID, '%s' AS shipName, %u AS shipTypeID, %u AS unreadMailCount,"
+        " petitionMessage,logonMinutes,tickerName, %u AS worldSpaceID, IFNULL(ship.itemName, 'My Ship') AS shipName, IFNULL(ship.typeID, 606) AS shipTypeID, %u AS unreadMailCount,"
         " %u AS upcomingEventCount, %u AS unprocessedNotifications, %u AS daysLeft, %u AS userType, 0 AS paperDollState, 0 AS newPaperdollState,"
         " 0 AS oldPaperdollState, skillPoints, %" PRIu64 " AS skillQueueEndTime, %" PRIu64 " AS allianceMemberStartDate, %" PRIu64 " AS startDate,"
-        " 0 AS locationSecurity"
+        " 0 AS locationSecurity%s"
         " FROM character_ "
-        "    LEFT JOIN entity ON characterID = itemID"
+        "    LEFT JOIN entity ON characterID = entity.itemID"
+        "    LEFT JOIN entity AS ship ON ship.itemID = character_.shipID"
         "    LEFT JOIN corporation USING (corporationID)"
-        "    LEFT JOIN bloodlineTypes USING (typeID)"
-        " WHERE characterID=%u", worldSpaceID, shipName.c_str(), shipTypeID, unreadMailCount, upcomingEventCount, unprocessedNotifications, daysLeft, userType, skillQueueEndTime, allianceMemberStartDate, startDate, characterID))
+        "    LEFT JOIN bloodlineTypes ON bloodlineTypes.typeID = entity.typeID"
+        " %s", worldSpaceID, unreadMailCount, upcomingEventCount, unprocessedNotifications, daysLeft, userType, skillQueueEndTime, allianceMemberStartDate, startDate, extraColumns, condition))
     {
         codelog(SERVICE__ERROR, "Error in query: %s", res.error.c_str());
-        return NULL;
+        return false;
     }
 
-    return DBResultToCRowset(res);
+    return true;
 }
 
 PyObject *CharacterDB::GetCharPublicInfo(uint32 characterID) {
@@ -795,6 +815,18 @@ PyObject *CharacterDB::GetOwnerNoteLabels(uint32 charID) {
     return DBResultToRowset(res);
 }
 
+PyObjectEx *CharacterDB::GetContacts(uint32 charID) {
+    DBQueryResult res;
+
+    if (!sDatabase.RunQuery(res, "SELECT contactID, inWatchList, relationshipID, labelMask FROM chrContacts WHERE ownerID = %u", charID))
+    {
+        codelog(SERVICE__ERROR, "Error on query: %s", res.error.c_str());
+        return (NULL);
+    }
+
+    return DBResultToCRowset(res);
+}
+
 PyObject *CharacterDB::GetOwnerNote(uint32 charID, uint32 noteID) {
     DBQueryResult res;
 
@@ -28,7 +28,9 @@
 #include "EVEServerConfig.h"
 #include "PyServiceCD.h"
 #include "cache/ObjCacheService.h"
+#include "character/CharSelectCache.h"
 #include "character/CharacterService.h"
+#include "character/LoginPipeline.h"
 
 PyCallable_Make_InnerDispatcher(CharacterService)
 
@@ -77,7 +79,7 @@ void CharacterService::GetCharacterData(uint32 characterID, std::map<std::string
 }
 
 PyResult CharacterService::Handle_GetCharactersToSelect(PyCallArgs &call) {
-    return(m_db.GetCharacterList(call.client->GetAccountID()));
+    return(sCharSelectCache.GetCharacterList(call.client->GetAccountID()));
 }
 
 PyResult CharacterService::Handle_GetCharacterToSelect(PyCallArgs &call) {
@@ -87,7 +89,7 @@ PyResult CharacterService::Handle_GetCharacterToSelect(PyCallArgs &call) {
         return NULL;
     }
 
-    PyRep *result = m_db.GetCharSelectInfo(args.arg);
+    PyRep *result = sCharSelectCache.GetCharSelectInfo(args.arg);
     if(result == NULL) {
         _log(CLIENT__ERROR, "Failed to load character %d", args.arg);
         return NULL;
@@ -105,7 +107,8 @@ PyResult CharacterService::Handle_SelectCharacterID(PyCallArgs &call) {
     }
 
     //we don't care about tutorial dungeon right now
-    call.client->SelectCharacter(args.charID);
+    //the session change follows once the character is loaded
+    sLoginPipeline.Start(call.client, args.charID);
 
     return NULL;
 }
@@ -348,6 +351,8 @@ PyResult CharacterService::Handle_CreateCharacter2(PyCallArgs &call) {
     // Release the item factory now that the character is created and loaded
     m_manager->item_factory.UnsetUsingClient();
 
+    sCharSelectCache.InvalidateAccount(call.client->GetAccountID());
+
     return new PyInt( char_item->itemID() );
 }
 
@@ -373,7 +378,7 @@ PyResult CharacterService::Handle_PrepareCharacterForDelete(PyCallArgs &call) {
 
     //TODO: make sure this person actually owns this char...
 
-    sLog.Debug( "CharacterService", "Called PrepareCharacterForDelete stub: deleting immediately." );
+    _debug( "CharacterService", "Called PrepareCharacterForDelete stub: deleting immediately." );
 
     { // character scope to make sure char_item is deleted immediately
         m_manager->item_factory.SetUsingClient( call.client );
@@ -410,6 +415,9 @@ PyResult CharacterService::Handle_PrepareCharacterForDelete(PyCallArgs &call) {
         i->Delete();
     }
 
+    sCharSelectCache.InvalidateAccount(call.client->GetAccountID());
+    sCharSelectCache.InvalidateCharacter(args.arg);
+
     //we return deletePrepareDateTime, in eve time format.
     return(new PyLong(Win32TimeNow() + Win32Time_Second*5));
 }
@@ -423,7 +431,7 @@ PyResult CharacterService::Handle_CancelCharacterDeletePrepare( PyCallArgs& call
         return NULL;
     }
 
-    sLog.Debug( "CharacterService", "Called CancelCharacterDeletePrepare stub." );
+    _debug( "CharacterService", "Called CancelCharacterDeletePrepare stub." );
 
     //returns nothing.
     return NULL;
@@ -492,7 +500,7 @@ PyResult CharacterService::Handle_GetCloneTypeID( PyCallArgs& call )
 
 PyResult CharacterService::Handle_GetRecentShipKillsAndLosses( PyCallArgs& call )
 {
-    sLog.Debug( "CharacterService", "Called GetRecentShipKillsAndLosses stub." );
+    _debug( "CharacterService", "Called GetRecentShipKillsAndLosses stub." );
 
     util_Rowset rs;
 
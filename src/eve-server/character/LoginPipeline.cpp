@@ -0,0 +1,224 @@
+/*
+    ------------------------------------------------------------------------------------
+    LICENSE:
+    ------------------------------------------------------------------------------------
+    This file is part of EVEmu: EVE Online Server Emulator
+    Copyright 2006 - 2011 The EVEmu Team
+    For the latest information visit http://evemu.org
+    ------------------------------------------------------------------------------------
+    This program is free software; you can redistribute it and/or modify it under
+    the terms of the GNU Lesser General Public License as published by the Free Software
+    Foundation; either version 2 of the License, or (at your option) any later
+    version.
+
+    This program is distributed in the hope that it will be useful, but WITHOUT
+    ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+    FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public License along with
+    this program; if not, write to the Free Software Foundation, Inc., 59 Temple
+    Place - Suite 330, Boston, MA 02111-1307, USA, or go to
+    http://www.gnu.org/copyleft/lesser.txt.
+    ------------------------------------------------------------------------------------
+    Author:     EVEmu Team
+*/
+
+
+#include "eve-server.h"
+
+#include "Client.h"
+#include "EntityList.h"
+#include "PyServiceMgr.h"
+#include "character/LoginPipeline.h"
+#include "inventory/InventoryDB.h"
+#include "inventory/InventoryWriteBehind.h"
+
+/// The most logins attached per tick.
+static const size_t LOGIN_ATTACHES_PER_TICK = 4;
+
+/**
+ * @brief Fetches the items of a character on a worker thread.
+ */
+class LoginPipeline::PrefetchQuery
+: public DBAsyncQuery
+{
+public:
+    PrefetchQuery( uint32 ticket, uint32 characterID )
+    : mTicket( ticket ),
+      mCharacterID( characterID ),
+      mShipID( 0 ),
+      mSolarSystemID( 0 )
+    {
+        // not read-only: a replica may not have the rows flushed just before yet
+    }
+
+    const uint32 mTicket;
+    const uint32 mCharacterID;
+
+    uint32 mShipID;
+    uint32 mSolarSystemID;
+    std::map<uint32, ItemData> mItems;
+    std::map<uint32, ItemAttributeList> mAttributes;
+
+protected:
+    bool Run()
+    {
+        return InventoryDB::GetLoginItems( mCharacterID, mShipID, mSolarSystemID, mItems, mAttributes );
+    }
+
+    void Complete( bool success, DBQueryResult& result )
+    {
+        sLoginPipeline._Complete( *this, success );
+    }
+};
+
+LoginPipeline::LoginPipeline()
+: mNextTicket( 1 )
+{
+}
+
+void LoginPipeline::Start( Client* client, uint32 characterID )
+{
+    std::map< uint32, Login >::iterator cur, end;
+    cur = mLogins.begin();
+    end = mLogins.end();
+    for(; cur != end; ++cur )
+    {
+        if( cur->second.client == client )
+        {
+            sLog.Warning( "LoginPipeline", "Account %u is logging in already; ignoring the selection of character %u.", client->GetAccountID(), characterID );
+            return;
+        }
+    }
+
+    const uint32 ticket = mNextTicket++;
+
+    Login& login = mLogins[ ticket ];
+    login.client = client;
+    login.characterID = characterID;
+    login.stage = STAGE_PREFETCH;
+    login.stageStarted = GetTimeUSeconds();
+    login.solarSystemID = 0;
+
+    ++mStats.started;
+
+    // the workers read the rows, so they must be written
+    sInventoryWriteBehind.Flush();
+    sDBAsync.Submit( new PrefetchQuery( ticket, characterID ) );
+}
+
+void LoginPipeline::Cancel( Client* client )
+{
+    std::map< uint32, Login >::iterator cur, end;
+    cur = mLogins.begin();
+    end = mLogins.end();
+    for(; cur != end; ++cur )
+    {
+        if( cur->second.client == client )
+        {
+            client->services().item_factory.DiscardPrefetched( cur->second.containerIDs, cur->second.itemIDs );
+
+            mLogins.erase( cur );
+            ++mStats.cancelled;
+            return;
+        }
+    }
+}
+
+void LoginPipeline::Process()
+{
+    std::vector< uint32 > ready;
+
+    std::map< uint32, Login >::iterator cur, end;
+    cur = mLogins.begin();
+    end = mLogins.end();
+    for(; cur != end && ready.size() < LOGIN_ATTACHES_PER_TICK; ++cur )
+    {
+        Login& login = cur->second;
+
+        if( STAGE_SYSTEM == login.stage )
+        {
+            // the preload either finished or failed; the boot loads what is missing
+            if( sEntityList.systemPreloader().IsPending( login.solarSystemID ) )
+                continue;
+
+            _Account( login.stageStarted, mStats.systemWaitTime, mStats.maxSystemWaitTime );
+            login.stage = STAGE_ATTACH;
+        }
+
+        if( STAGE_ATTACH == login.stage )
+            ready.push_back( cur->first );
+    }
+
+    std::vector< uint32 >::iterator curTicket, endTicket;
+    curTicket = ready.begin();
+    endTicket = ready.end();
+    for(; curTicket != endTicket; ++curTicket )
+        _Attach( *curTicket );
+}
+
+void LoginPipeline::_Complete( PrefetchQuery& query, bool success )
+{
+    std::map< uint32, Login >::iterator res = mLogins.find( query.mTicket );
+    if( res == mLogins.end() )
+        // cancelled meanwhile
+        return;
+
+    Login& login = res->second;
+    _Account( login.stageStarted, mStats.prefetchTime, mStats.maxPrefetchTime );
+
+    if( success )
+    {
+        // SelectCharacter() loads these out of the ItemFactory instead of querying
+        login.containerIDs.push_back( login.characterID );
+        login.containerIDs.push_back( query.mShipID );
+        login.client->services().item_factory.AddPrefetched( login.containerIDs, query.mItems, query.mAttributes, login.itemIDs );
+
+        login.solarSystemID = query.mSolarSystemID;
+    }
+    else
+        // the attach queries whatever it needs itself
+        _log( CLIENT__ERROR, "Failed to prefetch character %u; loading it directly.", login.characterID );
+
+    login.stageStarted = GetTimeUSeconds();
+
+    if( 0 != login.solarSystemID && !sEntityList.IsSystemBooted( login.solarSystemID ) )
+    {
+        sEntityList.systemPreloader().Preload( login.solarSystemID );
+        login.stage = STAGE_SYSTEM;
+    }
+    else
+        login.stage = STAGE_ATTACH;
+}
+
+void LoginPipeline::_Attach( uint32 ticket )
+{
+    std::map< uint32, Login >::iterator res = mLogins.find( ticket );
+    assert( res != mLogins.end() );
+
+    // the login is over whatever the outcome
+    Login login = res->second;
+    mLogins.erase( res );
+
+    login.stageStarted = GetTimeUSeconds();
+    const bool success = login.client->SelectCharacter( login.characterID );
+    _Account( login.stageStarted, mStats.attachTime, mStats.maxAttachTime );
+
+    login.client->services().item_factory.DiscardPrefetched( login.containerIDs, login.itemIDs );
+
+    if( success )
+        ++mStats.completed;
+    else
+    {
+        _log( CLIENT__ERROR, "Failed to select character %u.", login.characterID );
+        ++mStats.failed;
+    }
+}
+
+void LoginPipeline::_Account( uint64 since, uint32& total, uint32& max )
+{
+    const uint32 time = static_cast<uint32>( ( GetTimeUSeconds() - since ) / 1000 );
+
+    total += time;
+    max = std::max( max, time );
+}
@@ -42,3 +42,46 @@ PyRep* PaperDollDB::GetMyPaperDollData() const {
 
     return DBResultToRowset(res);
 }
+
+bool PaperDollDB::LoadDolls(const std::vector<uint32> &characterIDs, DBQueryResult &res) const {
+    std::string list;
+    char buf[16];
+
+    std::vector<uint32>::const_iterator cur, end;
+    cur = characterIDs.begin();
+    end = characterIDs.end();
+    for(; cur != end; cur++)
+    {
+        snprintf(buf, sizeof(buf), "%s%u", (list.empty() ? "" : ", "), *cur);
+        list += buf;
+    }
+
+    if (!sDatabase.RunQuery(res,
+        " SELECT characterID, version, dollData"
+        " FROM chrPaperDolls"
+        " WHERE characterID IN (%s)", list.c_str()))
+    {
+        _log(DATABASE__ERROR, "Error in LoadDolls query: %s", res.error.c_str());
+        return false;
+    }
+
+    return true;
+}
+
+bool PaperDollDB::SaveDoll(uint32 characterID, uint32 version, const Buffer &data) const {
+    std::string escaped;
+    sDatabase.DoEscapeString(escaped, std::string((const char *)&data[0], data.size()));
+
+    DBerror err;
+    if (!sDatabase.RunQuery(err,
+        " INSERT INTO chrPaperDolls (characterID, version, dollData)"
+        " VALUES (%u, %u, '%s')"
+        " ON DUPLICATE KEY UPDATE version = VALUES(version), dollData = VALUES(dollData)",
+        characterID, version, escaped.c_str()))
+    {
+        _log(DATABASE__ERROR, "Failed to save paper doll of character %u: %s", characterID, err.c_str());
+        return false;
+    }
+
+    return true;
+}
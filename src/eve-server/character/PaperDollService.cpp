@@ -27,6 +27,7 @@
 
 #include "PyServiceCD.h"
 #include "character/PaperDollService.h"
+#include "character/PaperDollStore.h"
 
 PyCallable_Make_InnerDispatcher(PaperDollService)
 
@@ -49,7 +50,18 @@ PaperDollService::~PaperDollService() {
 }
 
 PyResult PaperDollService::Handle_GetPaperDollData(PyCallArgs &call) {
-    return new PyList;
+    Call_SingleIntegerArg arg;
+    if(!arg.Decode(&call.tuple)) {
+        codelog(SERVICE__ERROR, "Failed to decode args for GetPaperDollData call");
+        return NULL;
+    }
+
+    const PaperDollStore::Doll *doll = sPaperDollStore.Get(arg.arg);
+    if(doll == NULL || doll->dollInfo == NULL)
+        return new PyList;
+
+    PyIncRef(doll->dollInfo);
+    return doll->dollInfo;
 }
 
 PyResult PaperDollService::Handle_ConvertAndSavePaperDoll(PyCallArgs &call) {
@@ -57,19 +69,36 @@ PyResult PaperDollService::Handle_ConvertAndSavePaperDoll(PyCallArgs &call) {
 }
 
 PyResult PaperDollService::Handle_UpdateExistingCharacterFull(PyCallArgs &call) {
-    return NULL;
+    return _UpdateDoll(call);
 }
 
 PyResult PaperDollService::Handle_UpdateExistingCharacterLimited(PyCallArgs &call) {
-    return NULL;
+    return _UpdateDoll(call);
 }
 
 PyResult PaperDollService::Handle_GetPaperDollPortraitDataFor(PyCallArgs &call) {
-    return NULL;
+    Call_SingleIntegerArg arg;
+    if(!arg.Decode(&call.tuple)) {
+        codelog(SERVICE__ERROR, "Failed to decode args for GetPaperDollPortraitDataFor call");
+        return NULL;
+    }
+
+    const PaperDollStore::Doll *doll = sPaperDollStore.Get(arg.arg);
+    if(doll == NULL || doll->portraitInfo == NULL)
+        return NULL;
+
+    PyIncRef(doll->portraitInfo);
+    return doll->portraitInfo;
 }
 
 PyResult PaperDollService::Handle_GetMyPaperDollData(PyCallArgs &call)
 {
+    const PaperDollStore::Doll *doll = sPaperDollStore.Get(call.client->GetCharacterID());
+    if(doll != NULL && doll->dollInfo != NULL) {
+        PyIncRef(doll->dollInfo);
+        return doll->dollInfo;
+    }
+
     PyDict* args = new PyDict;
 
     args->SetItemString( "colors", new PyDict );
@@ -78,3 +107,27 @@ PyResult PaperDollService::Handle_GetMyPaperDollData(PyCallArgs &call)
 
     return new PyObject("util.KeyVal", args);
 }
+
+PyResult PaperDollService::_UpdateDoll(PyCallArgs &call) {
+    //charID, dollInfo, portraitInfo, dollExists
+    if(call.tuple->size() < 3 || !call.tuple->GetItem(0)->IsInt()) {
+        codelog(SERVICE__ERROR, "Failed to decode args for paper doll update");
+        return NULL;
+    }
+
+    const uint32 characterID = call.tuple->GetItem(0)->AsInt()->value();
+    if(characterID != call.client->GetCharacterID()) {
+        codelog(SERVICE__ERROR, "%s: Refusing to update the paper doll of character %u", call.client->GetName(), characterID);
+        return NULL;
+    }
+
+    PyRep *dollInfo = call.tuple->GetItem(1);
+    PyIncRef(dollInfo);
+    PyRep *portraitInfo = call.tuple->GetItem(2);
+    PyIncRef(portraitInfo);
+
+    if(!sPaperDollStore.Save(characterID, dollInfo, portraitInfo))
+        codelog(SERVICE__ERROR, "Failed to save the paper doll of character %u", characterID);
+
+    return NULL;
+}
@@ -0,0 +1,198 @@
+/*
+    ------------------------------------------------------------------------------------
+    LICENSE:
+    ------------------------------------------------------------------------------------
+    This file is part of EVEmu: EVE Online Server Emulator
+    Copyright 2006 - 2011 The EVEmu Team
+    For the latest information visit http://evemu.org
+    ------------------------------------------------------------------------------------
+    This program is free software; you can redistribute it and/or modify it under
+    the terms of the GNU Lesser General Public License as published by the Free Software
+    Foundation; either version 2 of the License, or (at your option) any later
+    version.
+
+    This program is distributed in the hope that it will be useful, but WITHOUT
+    ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+    FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public License along with
+    this program; if not, write to the Free Software Foundation, Inc., 59 Temple
+    Place - Suite 330, Boston, MA 02111-1307, USA, or go to
+    http://www.gnu.org/copyleft/lesser.txt.
+    ------------------------------------------------------------------------------------
+    Author:     EVEmu Team
+*/
+
+
+#include "eve-server.h"
+
+#include "character/PaperDollStore.h"
+
+PaperDollStore::PaperDollStore()
+{
+}
+
+PaperDollStore::~PaperDollStore()
+{
+    std::tr1::unordered_map< uint32, Doll >::iterator cur, end;
+    cur = mDolls.begin();
+    end = mDolls.end();
+    for(; cur != end; ++cur )
+        _Clear( cur->second );
+}
+
+const PaperDollStore::Doll* PaperDollStore::Get( uint32 characterID )
+{
+    std::tr1::unordered_map< uint32, Doll >::const_iterator res = mDolls.find( characterID );
+    if( res != mDolls.end() )
+    {
+        ++mStats.hits;
+        return &res->second;
+    }
+
+    _Load( std::vector< uint32 >( 1, characterID ) );
+
+    res = mDolls.find( characterID );
+    if( res == mDolls.end() )
+        return NULL;
+
+    return &res->second;
+}
+
+void PaperDollStore::Prefetch( const std::vector< uint32 >& characterIDs )
+{
+    std::vector< uint32 > missing;
+
+    std::vector< uint32 >::const_iterator cur, end;
+    cur = characterIDs.begin();
+    end = characterIDs.end();
+    for(; cur != end; ++cur )
+    {
+        if( mDolls.find( *cur ) == mDolls.end() )
+            missing.push_back( *cur );
+    }
+
+    if( !missing.empty() )
+        _Load( missing );
+}
+
+bool PaperDollStore::Save( uint32 characterID, PyRep* dollInfo, PyRep* portraitInfo )
+{
+    // the version goes on from the stored one
+    const Doll* old = Get( characterID );
+    if( NULL == old )
+    {
+        PySafeDecRef( dollInfo );
+        PySafeDecRef( portraitInfo );
+        return false;
+    }
+
+    PyTuple* blob = new PyTuple( 2 );
+    blob->SetItem( 0, NULL == dollInfo ? new PyNone : dollInfo );
+    blob->SetItem( 1, NULL == portraitInfo ? new PyNone : portraitInfo );
+
+    // always deflated; dolls are plenty of repeated keys
+    Buffer data;
+    if( !MarshalDeflate( blob, data, 0 ) )
+    {
+        sLog.Error( "PaperDollStore", "Failed to marshal the paper doll of character %u.", characterID );
+        PyDecRef( blob );
+        return false;
+    }
+
+    const uint32 version = old->version + 1;
+    if( !mDB.SaveDoll( characterID, version, data ) )
+    {
+        PyDecRef( blob );
+        return false;
+    }
+
+    ++mStats.saves;
+
+    blob->Freeze();
+
+    Doll& doll = mDolls[ characterID ];
+    _Clear( doll );
+
+    doll.version = version;
+    doll.dollInfo = blob->GetItem( 0 );
+    PyIncRef( doll.dollInfo );
+    doll.portraitInfo = blob->GetItem( 1 );
+    PyIncRef( doll.portraitInfo );
+
+    PyDecRef( blob );
+    return true;
+}
+
+void PaperDollStore::Forget( uint32 characterID )
+{
+    std::tr1::unordered_map< uint32, Doll >::iterator res = mDolls.find( characterID );
+    if( res == mDolls.end() )
+        return;
+
+    _Clear( res->second );
+    mDolls.erase( res );
+}
+
+void PaperDollStore::_Load( const std::vector< uint32 >& characterIDs )
+{
+    DBQueryResult res;
+    if( !mDB.LoadDolls( characterIDs, res ) )
+        return;
+
+    ++mStats.queries;
+
+    // the ones without a row have no doll
+    std::vector< uint32 >::const_iterator cur, end;
+    cur = characterIDs.begin();
+    end = characterIDs.end();
+    for(; cur != end; ++cur )
+    {
+        Doll& doll = mDolls[ *cur ];
+        doll.version = 0;
+        doll.dollInfo = NULL;
+        doll.portraitInfo = NULL;
+
+        ++mStats.loads;
+    }
+
+    DBResultRow row;
+    while( res.GetRow( row ) )
+    {
+        const uint32 characterID = row.GetUInt( 0 );
+
+        Doll& doll = mDolls[ characterID ];
+        doll.version = row.GetUInt( 1 );
+
+        if( row.IsNull( 2 ) )
+            continue;
+
+        const uint8* text = (const uint8*)row.GetText( 2 );
+        PyRep* blob = InflateUnmarshal( Buffer( text, text + row.ColumnLength( 2 ) ) );
+        if( NULL == blob || !blob->IsTuple() || 2 != blob->AsTuple()->size() )
+        {
+            sLog.Error( "PaperDollStore", "Invalid paper doll of character %u.", characterID );
+            PySafeDecRef( blob );
+            continue;
+        }
+
+        blob->Freeze();
+
+        doll.dollInfo = blob->AsTuple()->GetItem( 0 );
+        PyIncRef( doll.dollInfo );
+        doll.portraitInfo = blob->AsTuple()->GetItem( 1 );
+        PyIncRef( doll.portraitInfo );
+
+        PyDecRef( blob );
+    }
+}
+
+void PaperDollStore::_Clear( Doll& doll )
+{
+    PySafeDecRef( doll.dollInfo );
+    PySafeDecRef( doll.portraitInfo );
+
+    doll.version = 0;
+    doll.dollInfo = NULL;
+    doll.portraitInfo = NULL;
+}
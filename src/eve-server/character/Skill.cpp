@@ -96,6 +96,11 @@ EvilNumber Skill::GetSPForLevel( EvilNumber level )
     return EVIL_SKILL_BASE_POINTS * GetAttribute(AttrSkillTimeConstant) * e_pow(2, (2.5*(level - 1)));
 }
 
+EvilNumber Skill::GetSPForLevel( const ItemType &type, EvilNumber level )
+{
+    return EVIL_SKILL_BASE_POINTS * EvilNumber(type.attributes.skillTimeConstant()) * e_pow(2, (2.5*(level - 1)));
+}
+
 bool Skill::SkillPrereqsComplete(Character &ch)
 {
     SkillRef requiredSkill;
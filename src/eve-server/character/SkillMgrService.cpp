@@ -109,7 +109,7 @@ PyResult SkillMgrBound::Handle_GetEndOfTraining(PyCallArgs &call) {
 
 PyResult SkillMgrBound::Handle_GetSkillHistory( PyCallArgs& call )
 {
-    sLog.Debug( "SkillMgrBound", "Called GetSkillHistory stub." );
+    _debug( "SkillMgrBound", "Called GetSkillHistory stub." );
 
     util_Rowset rowset;
 
@@ -132,7 +132,7 @@ PyResult SkillMgrBound::Handle_CharAddImplant( PyCallArgs& call )
         return NULL;
     }
 
-    sLog.Debug( "SkillMgrBound", "Called CharAddImplant stub." );
+    _debug( "SkillMgrBound", "Called CharAddImplant stub." );
 
     return NULL;
 }
@@ -147,7 +147,7 @@ PyResult SkillMgrBound::Handle_RemoveImplantFromCharacter( PyCallArgs& call )
         return NULL;
     }
 
-    sLog.Debug( "SkillMgrBound", "Called RemoveImplantFromCharacter stub." );
+    _debug( "SkillMgrBound", "Called RemoveImplantFromCharacter stub." );
 
     return NULL;
 }
@@ -258,7 +258,7 @@ PyResult SkillMgrBound::Handle_CharStartTrainingSkillByTypeID( PyCallArgs& call
         return NULL;
     }
 
-    sLog.Debug( "SkillMgrBound", "Called CharStartTrainingSkillByTypeID stub." );
+    _debug( "SkillMgrBound", "Called CharStartTrainingSkillByTypeID stub." );
 
     return NULL;
 }
@@ -0,0 +1,136 @@
+/*
+    ------------------------------------------------------------------------------------
+    LICENSE:
+    ------------------------------------------------------------------------------------
+    This file is part of EVEmu: EVE Online Server Emulator
+    Copyright 2006 - 2011 The EVEmu Team
+    For the latest information visit http://evemu.org
+    ------------------------------------------------------------------------------------
+    This program is free software; you can redistribute it and/or modify it under
+    the terms of the GNU Lesser General Public License as published by the Free Software
+    Foundation; either version 2 of the License, or (at your option) any later
+    version.
+
+    This program is distributed in the hope that it will be useful, but WITHOUT
+    ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+    FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public License along with
+    this program; if not, write to the Free Software Foundation, Inc., 59 Temple
+    Place - Suite 330, Boston, MA 02111-1307, USA, or go to
+    http://www.gnu.org/copyleft/lesser.txt.
+    ------------------------------------------------------------------------------------
+    Author:     EVEmu Team
+*/
+
+#include "eve-server.h"
+
+#include "EntityList.h"
+#include "character/Character.h"
+#include "character/SkillQueueSweeper.h"
+#include "inventory/InventoryDB.h"
+#include "inventory/ItemFactory.h"
+
+/// Delay (in milliseconds) before the next batch if the last one was full.
+static const uint32 SWEEP_BATCH_DELAY = 1000;
+
+/**
+ * @brief Finds the characters to advance on a worker thread.
+ */
+class SkillQueueSweeper::SweepQuery
+: public DBAsyncQuery
+{
+public:
+    SweepQuery(SkillQueueSweeper &sweeper, uint64 now, uint32 limit)
+    : m_sweeper(sweeper),
+      m_now(now),
+      m_limit(limit)
+    {
+    }
+
+    SkillQueueSweeper &m_sweeper;
+    uint64 m_now;
+    uint32 m_limit;
+    std::vector<uint32> m_characters;
+
+protected:
+    bool Run()
+    {
+        return m_db.GetOfflineCharactersWithDueSkills(m_now, m_limit, m_characters);
+    }
+
+    void Complete(bool success, DBQueryResult &result)
+    {
+        m_sweeper._Complete(*this, success);
+    }
+
+    InventoryDB m_db;
+};
+
+SkillQueueSweeper::SkillQueueSweeper(ItemFactory &factory)
+: m_factory(factory),
+  m_interval(0),
+  m_batch(0),
+  m_pending(false)
+{
+}
+
+void SkillQueueSweeper::Start(uint32 interval, uint32 batch)
+{
+    m_interval = std::min<uint32>(interval, 0x7FFFFFFF / 1000) * 1000;
+    m_batch = batch;
+
+    if(m_interval == 0 || m_batch == 0)
+        sTimerWheel.Cancel(this);
+    else if(!m_pending)
+        sTimerWheel.Schedule(this, m_interval);
+}
+
+void SkillQueueSweeper::TimerExpired()
+{
+    if(m_pending)
+        return;
+
+    m_pending = true;
+    ++m_stats.sweeps;
+
+    sDBAsync.Submit(new SweepQuery(*this, Win32TimeNow(), m_batch));
+}
+
+void SkillQueueSweeper::_Complete(SweepQuery &query, bool success)
+{
+    m_pending = false;
+
+    if(!success) {
+        _log(SERVICE__ERROR, "Failed to query characters with finished skills.");
+        ++m_stats.failed;
+    } else {
+        std::vector<uint32>::const_iterator cur, end;
+        cur = query.m_characters.begin();
+        end = query.m_characters.end();
+        for(; cur != end; cur++) {
+            //logged in meanwhile, the client takes care of it
+            if(sEntityList.FindCharacter(*cur) != NULL)
+                continue;
+
+            CharacterRef character = m_factory.GetCharacter(*cur);
+            if(!character) {
+                _log(SERVICE__ERROR, "Failed to load character %u to complete its skills.", *cur);
+                continue;
+            }
+
+            character->UpdateSkillQueue();
+            ++m_stats.characters;
+        }
+    }
+
+    if(m_interval == 0 || m_batch == 0)
+        //stopped meanwhile
+        return;
+
+    //a full batch means there are likely more
+    if(success && query.m_characters.size() >= m_batch)
+        sTimerWheel.Schedule(this, SWEEP_BATCH_DELAY);
+    else
+        sTimerWheel.Schedule(this, m_interval);
+}
@@ -30,6 +30,15 @@
 #include "chat/LSCChannel.h"
 #include "chat/LSCService.h"
 
+/// Time (in milliseconds) a message uses the quota of its sender up for.
+static const uint64 LSC_MESSAGE_INTERVAL = 1000;
+/// Number of messages a sender may send at once before the quota is used up.
+static const uint64 LSC_MESSAGE_BURST = 5;
+
+const uint32 LSCChannel::LAZY_MEMBER_THRESHOLD = 100;
+
+LSCChannel::MembershipStats LSCChannel::s_membershipStats;
+
 PyRep *LSCChannelChar::Encode() const {
     ChannelJoinChannelCharsLine line;
 
@@ -52,6 +61,15 @@ PyRep *LSCChannelChar::Encode() const {
     return line.Encode();
 }
 
+bool LSCChannelChar::TakeMessage(uint64 now) {
+    const uint64 from = std::max(now, m_quotaUntil);
+    if (from + LSC_MESSAGE_INTERVAL > now + LSC_MESSAGE_INTERVAL * LSC_MESSAGE_BURST)
+        return false;
+
+    m_quotaUntil = from + LSC_MESSAGE_INTERVAL;
+    return true;
+}
+
 PyRep *LSCChannelMod::Encode() {
     ChannelJoinChannelModsLine line;
 
@@ -65,6 +83,8 @@ PyRep *LSCChannelMod::Encode() {
     return line.Encode();
 }
 
+MemoryTag LSCChannel::sMemoryTag( "chat" );
+
 LSCChannel::LSCChannel(
     LSCService *svc,
     uint32 channelID,
@@ -92,13 +112,16 @@ LSCChannel::LSCChannel(
   m_mailingList(mailingList),
   m_cspa(cspa),
   m_temporary(temporary),
-  m_mode(mode)
+  m_mode(mode),
+  m_encodedChars(NULL)
 {
     _log(LSC__CHANNELS, "Creating channel \"%s\"", m_displayName.c_str());
 }
 
 LSCChannel::~LSCChannel() {
     _log(LSC__CHANNELS, "Destroying channel \"%s\"", m_displayName.c_str());
+
+    PySafeDecRef( m_encodedChars );
 }
 
 void LSCChannel::GetChannelInfo(uint32 * channelID, uint32 * ownerID, std::string &displayName, std::string &motd, std::string &comparisonKey,
@@ -135,6 +158,8 @@ void LSCChannel::SetChannelInfo(uint32 ownerID, std::string displayName, std::st
 bool LSCChannel::JoinChannel(Client * c) {
     _log(LSC__CHANNELS, "Channel %s: Join from %s", m_displayName.c_str(), c->GetName());
 
+    if (!IsJoined(c->GetCharacterID()))
+        m_members.push_back(c);
 
     m_chars.insert(
         std::make_pair(
@@ -144,25 +169,7 @@ bool LSCChannel::JoinChannel(Client * c) {
     );
     c->ChannelJoined( this );
 
-
-    //if ((m_type != LSCChannel::normal) && (m_channelID > 2)) {
-        OnLSC_JoinChannel join;
-        join.sender = _MakeSenderInfo(c);
-        join.member_count = m_chars.size();
-        join.channelID = EncodeID();
-
-        MulticastTarget mct;
-
-        std::map<uint32, LSCChannelChar>::iterator cur, end;
-        cur = m_chars.begin();
-        end = m_chars.end();
-        for( ; cur != end; cur++ )
-            mct.characters.insert( cur->first );
-
-        PyTuple *answer = join.Encode();
-        m_service->entityList().Multicast( "OnLSC", GetTypeString(), &answer, mct );
-    //}
-
+    _ChangeMembership( true, c->GetCharacterID(), _MakeSenderInfo(c) );
 
     return true;
 }
@@ -174,22 +181,9 @@ void LSCChannel::LeaveChannel(uint32 charID, OnLSC_SenderInfo * si) {
         return;
 
     m_chars.erase(charID);
+    _RemoveMember(charID);
 
-    OnLSC_LeaveChannel leave;
-    leave.sender = si;
-    leave.member_count = m_chars.size();
-    leave.channelID = EncodeID();
-
-    MulticastTarget mct;
-
-    std::map<uint32, LSCChannelChar>::iterator cur, end;
-    cur = m_chars.begin();
-    end = m_chars.end();
-    for(; cur != end; cur++)
-        mct.characters.insert( cur->first );
-
-    PyTuple *answer = leave.Encode();
-    m_service->entityList().Multicast("OnLSC", GetTypeString(), &answer, mct);
+    _ChangeMembership(false, charID, si);
 }
 
 void LSCChannel::LeaveChannel(Client *c, bool self) {
@@ -200,24 +194,23 @@ void LSCChannel::LeaveChannel(Client *c, bool self) {
     if (m_chars.find(charID) == m_chars.end())
         return;
 
-    OnLSC_LeaveChannel leave;
-    leave.sender = _MakeSenderInfo(c);
-    leave.member_count = m_chars.size();
-    leave.channelID = EncodeID();
-
-    MulticastTarget mct;
+    if (IsLazy() || HasPendingMembership()) {
+        // the leaver is not around at the flush, so it learns of its leave now
+        OnLSC_LeaveChannel leave;
+        leave.sender = _MakeSenderInfo(c);
+        leave.member_count = m_chars.size() - 1;
+        leave.channelID = EncodeID();
 
-    std::map<uint32, LSCChannelChar>::iterator cur, end;
-    cur = m_chars.begin();
-    end = m_chars.end();
-    for(; cur != end; cur++)
-        mct.characters.insert( cur->first );
-
-    PyTuple *answer = leave.Encode();
-    m_service->entityList().Multicast("OnLSC", GetTypeString(), &answer, mct);
+        std::vector<Client *> leaver(1, c);
+        PyTuple *answer = leave.Encode();
+        m_service->entityList().Multicast(leaver, "OnLSC", GetTypeString(), &answer);
+    }
 
     m_chars.erase(charID);
+    _RemoveMember(charID);
     c->ChannelLeft(this);
+
+    _ChangeMembership(false, charID, _MakeSenderInfo(c));
 }
 
 void LSCChannel::Evacuate(Client * c) {
@@ -227,138 +220,169 @@ void LSCChannel::Evacuate(Client * c) {
     dc.member_count = 0;
     dc.sender = _MakeSenderInfo(c);
 
-    MulticastTarget mct;
-
-    std::map<uint32, LSCChannelChar>::iterator cur, end;
-    cur = m_chars.begin();
-    end = m_chars.end();
-    for(; cur != end; cur++)
-        mct.characters.insert(cur->first);
-
     PyTuple *answer = dc.Encode();
-    m_service->entityList().Multicast("OnLSC", GetTypeString(), &answer, mct);
+    m_service->entityList().Multicast(m_members, "OnLSC", GetTypeString(), &answer);
 }
 
 void LSCChannel::SendMessage(Client * c, const char * message, bool self) {
-/*
-    MulticastTarget mct;
+    // commands and self messages only go back to the sender
+    if (message[0] == '#' || self) {
+        OnLSC_SendMessage sm;
+        if (message[0] == '#') {
+            m_service->ExecuteCommand(c, message);
+            sm.sender = _MakeSenderInfo(c);
+        } else
+            sm.sender = _FakeSenderInfo();
+        sm.channelID = EncodeID();
+        sm.message = message;
+        sm.member_count = m_chars.size();
 
-    OnLSC_SendMessage sm;
+        std::vector<Client *> sender(1, c);
+        PyTuple *answer = sm.Encode();
+        m_service->entityList().Multicast(sender, "OnLSC", GetTypeString(), &answer);
+        return;
+    }
+
+    std::map<uint32, LSCChannelChar>::iterator res = m_chars.find(c->GetCharacterID());
+    if (res != m_chars.end() && !res->second.TakeMessage(GetTimeUSeconds() / 1000)) {
+        _log(LSC__CHANNELS, "Channel %s: Dropped message of %s, sending too fast", m_displayName.c_str(), c->GetName());
+        SendMessage(c, "You are sending messages too fast; your last message was not delivered.", true);
+        return;
+    }
 
-    if (message[0] == '#') {
-        m_service->ExecuteCommand(c, message);
-        mct.characters.insert(c->GetCharacterID());
+    // the members with the Kenny translator enabled get the message as it was typed,
+    // the others get it kennyfied if the sender has the translator enabled;
+    // either version is encoded once for all of its recipients
+    std::vector<Client *> kennyfied, notKennyfied;
+    std::vector<Client *>::const_iterator cur, end;
+    cur = m_members.begin();
+    end = m_members.end();
+    for(; cur != end; cur++)
+    {
+        if ((*cur)->IsKennyTranslatorEnabled())
+            kennyfied.push_back(*cur);
+        else
+            notKennyfied.push_back(*cur);
+    }
+
+    if (!notKennyfied.empty()) {
+        OnLSC_SendMessage sm;
         sm.sender = _MakeSenderInfo(c);
-    } else {
-        if (self) {
-            mct.characters.insert(c->GetCharacterID());
-            sm.sender = _FakeSenderInfo();
-        } else {
-            std::map<uint32, LSCChannelChar>::iterator cur, end;
-            cur = m_chars.begin();
-            end = m_chars.end();
-            for(; cur != end; cur++)
-                mct.characters.insert( cur->first );
+        sm.channelID = EncodeID();
+        sm.message = message;
+        sm.member_count = m_chars.size();
+
+        if (c->IsKennyTranslatorEnabled()) {
+            std::string kennyfied_message;
+            normal_to_kennyspeak(sm.message, kennyfied_message);
+            sm.message = kennyfied_message;
+        }
 
-            sm.sender = _MakeSenderInfo(c);
+        PyTuple *answer = sm.Encode();
+        m_service->entityList().Multicast(notKennyfied, "OnLSC", GetTypeString(), &answer);
     }
+
+    if (!kennyfied.empty()) {
+        OnLSC_SendMessage sm;
+        sm.sender = _MakeSenderInfo(c);
+        sm.channelID = EncodeID();
+        sm.message = message;
+        sm.member_count = m_chars.size();
+
+        PyTuple *answer = sm.Encode();
+        m_service->entityList().Multicast(kennyfied, "OnLSC", GetTypeString(), &answer);
     }
+}
 
-    sm.channelID = EncodeID();
-    sm.message = message;
-    sm.member_count = m_chars.size();
+void LSCChannel::FlushMembership() {
+    if (m_pending.empty())
+        return;
 
-    PyTuple *answer = sm.Encode();
-    m_service->entityList().Multicast("OnLSC", GetTypeString(), &answer, mct);
-*/
+    ++s_membershipStats.flushes;
 
-    // NEW KENNY TRANSLATOR VERSION:
-    // execute Multicast() twice: once for all clients where IsKennyTranslatorEnabled() == false and once for all clients where it is true
-    MulticastTarget mct_Kennyfied;
-    OnLSC_SendMessage sm_Kennyfied;
-    uint32 kennyfiedCharListSize = 0;
-    MulticastTarget mct_NotKennyfied;
-    OnLSC_SendMessage sm_NotKennyfied;
-    uint32 notKennyfiedCharListSize = 0;
-
-    if (message[0] == '#') {
-        m_service->ExecuteCommand(c, message);
-        mct_Kennyfied.characters.insert(c->GetCharacterID());
-        sm_Kennyfied.sender = _MakeSenderInfo(c);
-    } else {
-        if (self) {
-            if( c->IsKennyTranslatorEnabled() )
-            {
-                mct_Kennyfied.characters.insert(c->GetCharacterID());
-                sm_Kennyfied.sender = _FakeSenderInfo();
-                kennyfiedCharListSize++;
-            }
-            else
-            {
-                mct_NotKennyfied.characters.insert(c->GetCharacterID());
-                sm_NotKennyfied.sender = _FakeSenderInfo();
-                notKennyfiedCharListSize++;
-            }
-        } else {
-            std::map<uint32, LSCChannelChar>::iterator cur, end;
-            cur = m_chars.begin();
-            end = m_chars.end();
-            for(; cur != end; cur++)
-            {
-                if( (m_service->entityList().FindCharacter(cur->first)->IsKennyTranslatorEnabled()) )
-                {
-                    mct_Kennyfied.characters.insert( cur->first );
-                    kennyfiedCharListSize++;
-                }
-                else
-                {
-                    mct_NotKennyfied.characters.insert( cur->first );
-                    notKennyfiedCharListSize++;
-                }
-            }
-
-            //if( c->IsKennyTranslatorEnabled() )
-            //{
-                sm_Kennyfied.sender = _MakeSenderInfo(c);
-                kennyfiedCharListSize++;
-            //}
-            //else
-            //{
-                sm_NotKennyfied.sender = _MakeSenderInfo(c);
-                notKennyfiedCharListSize++;
-            //}
-    }
+    std::map<uint32, PendingChange>::iterator cur, end;
+    cur = m_pending.begin();
+    end = m_pending.end();
+    for(; cur != end; cur++)
+    {
+        // a join and a leave within the tick cancelled out
+        if (cur->second.delta == 0)
+            continue;
+
+        _SendMembership(0 < cur->second.delta, new OnLSC_SenderInfo(cur->second.sender));
     }
 
-    PyTuple *answerNotKennyfied;
-    sm_NotKennyfied.channelID = EncodeID();
-    sm_NotKennyfied.message = message;
-    sm_NotKennyfied.member_count = notKennyfiedCharListSize;
+    m_pending.clear();
+}
+
+bool LSCChannel::IsJoined(uint32 charID) {
+    return m_chars.find(charID) != m_chars.end();
+}
 
-    // Check if number of non-kennyfied recipients is greater than zero, and if so, send a Multicast() to them
-    // with the normal message sent through kenny translator IF the sender has the Kenny Translator enabled
-    if( notKennyfiedCharListSize > 0 )
+void LSCChannel::_RemoveMember(uint32 charID) {
+    std::vector<Client *>::iterator cur, end;
+    cur = m_members.begin();
+    end = m_members.end();
+    for(; cur != end; cur++)
     {
-        std::string kennyfied_message;
-        if( c->IsKennyTranslatorEnabled() )
+        if ((*cur)->GetCharacterID() == charID)
         {
-            normal_to_kennyspeak(sm_NotKennyfied.message, kennyfied_message);
-            sm_NotKennyfied.message = kennyfied_message;
+            // order does not matter, so the last member fills the gap
+            *cur = m_members.back();
+            m_members.pop_back();
+            return;
         }
-        answerNotKennyfied = sm_NotKennyfied.Encode();
-        m_service->entityList().Multicast("OnLSC", GetTypeString(), &answerNotKennyfied, mct_NotKennyfied);
     }
+}
 
-    sm_Kennyfied.channelID = EncodeID();
-    sm_Kennyfied.message = message;
-    sm_Kennyfied.member_count = kennyfiedCharListSize;
+void LSCChannel::_ChangeMembership(bool join, uint32 charID, OnLSC_SenderInfo * si) {
+    PySafeDecRef(m_encodedChars);
+    m_encodedChars = NULL;
 
-    PyTuple *answerKennyfied = sm_Kennyfied.Encode();
-    m_service->entityList().Multicast("OnLSC", GetTypeString(), &answerKennyfied, mct_Kennyfied);
+    // once anything is queued, everything is, so the members get the changes in order
+    if (!IsLazy() && !HasPendingMembership()) {
+        ++s_membershipStats.immediate;
+        _SendMembership(join, si);
+        return;
+    }
+
+    ++s_membershipStats.queued;
+    if (m_pending.empty())
+        m_service->QueueMembershipFlush(m_channelID);
+
+    std::map<uint32, PendingChange>::iterator res = m_pending.find(charID);
+    if (res == m_pending.end()) {
+        PendingChange change;
+        change.delta = join ? 1 : -1;
+        change.sender = *si;
+        m_pending.insert(std::make_pair(charID, change));
+    } else {
+        if (res->second.delta != 0)
+            ++s_membershipStats.coalesced;
+        res->second.delta += join ? 1 : -1;
+        res->second.sender = *si;
+    }
+
+    SafeDelete(si);
 }
 
-bool LSCChannel::IsJoined(uint32 charID) {
-    return m_chars.find(charID) != m_chars.end();
+void LSCChannel::_SendMembership(bool join, OnLSC_SenderInfo * si) {
+    PyTuple *answer;
+    if (join) {
+        OnLSC_JoinChannel notify;
+        notify.sender = si;
+        notify.member_count = m_chars.size();
+        notify.channelID = EncodeID();
+        answer = notify.Encode();
+    } else {
+        OnLSC_LeaveChannel notify;
+        notify.sender = si;
+        notify.member_count = m_chars.size();
+        notify.channelID = EncodeID();
+        answer = notify.Encode();
+    }
+
+    m_service->entityList().Multicast(m_members, "OnLSC", GetTypeString(), &answer);
 }
 
 OnLSC_SenderInfo *LSCChannel::_MakeSenderInfo(Client *c) {
@@ -448,6 +472,15 @@ PyRep *LSCChannel::EncodeChannelMods()
 }
 
 PyRep *LSCChannel::EncodeChannelChars() {
+    // the list is encoded once for everyone fetching it until the members change
+    if (m_encodedChars != NULL) {
+        ++s_membershipStats.listHits;
+        PyIncRef(m_encodedChars);
+        return m_encodedChars;
+    }
+
+    ++s_membershipStats.listEncodes;
+
     ChannelJoinChannelChars info;
     info.lines = new PyList;
 
@@ -461,7 +494,9 @@ PyRep *LSCChannel::EncodeChannelChars() {
             info.lines->AddItem( res->second.Encode() );
     }
 
-    return info.Encode();
+    m_encodedChars = info.Encode();
+    PyIncRef(m_encodedChars);
+    return m_encodedChars;
 }
 
 PyRep *LSCChannel::EncodeEmptyChannelChars() {
@@ -26,9 +26,15 @@
 #include "eve-server.h"
 
 #include "chat/LSCDB.h"
+#include "chat/NameIndex.h"
 #include "chat/LSCService.h"
 
 PyObject *LSCDB::LookupChars(const char *match, bool exact) {
+    // literal searches are served by the name index, regular expressions fall through to RLIKE
+    PyObject *indexed = sNameIndex.LookupCharacters(match, exact, false);
+    if (indexed != NULL)
+        return indexed;
+
     DBQueryResult res;
 
     std::string matchEsc;
@@ -64,6 +70,10 @@ PyObject *LSCDB::LookupChars(const char *match, bool exact) {
 
 
 PyObject *LSCDB::LookupOwners(const char *match, bool exact) {
+    PyObject *indexed = sNameIndex.LookupOwners(match, exact);
+    if (indexed != NULL)
+        return indexed;
+
     DBQueryResult res;
 
     std::string matchEsc;
@@ -103,6 +113,10 @@ PyObject *LSCDB::LookupOwners(const char *match, bool exact) {
 
 
 PyObject *LSCDB::LookupPlayerChars(const char *match, bool exact) {
+    PyObject *indexed = sNameIndex.LookupCharacters(match, exact, true);
+    if (indexed != NULL)
+        return indexed;
+
     DBQueryResult res;
 
     std::string matchEsc;
@@ -125,6 +139,10 @@ PyObject *LSCDB::LookupPlayerChars(const char *match, bool exact) {
 
 
 PyObject *LSCDB::LookupCorporations(const std::string & search) {
+    PyObject *indexed = sNameIndex.LookupCorporations(search);
+    if (indexed != NULL)
+        return indexed;
+
     DBQueryResult res;
     std::string secure;
     sDatabase.DoEscapeString(secure, search);
@@ -144,6 +162,10 @@ PyObject *LSCDB::LookupCorporations(const std::string & search) {
 
 
 PyObject *LSCDB::LookupFactions(const std::string & search) {
+    PyObject *indexed = sNameIndex.LookupFactions(search);
+    if (indexed != NULL)
+        return indexed;
+
     DBQueryResult res;
     std::string secure;
     sDatabase.DoEscapeString(secure, search);
@@ -163,6 +185,10 @@ PyObject *LSCDB::LookupFactions(const std::string & search) {
 
 
 PyObject *LSCDB::LookupCorporationTickers(const std::string & search) {
+    PyObject *indexed = sNameIndex.LookupCorporationTickers(search);
+    if (indexed != NULL)
+        return indexed;
+
     DBQueryResult res;
     std::string secure;
     sDatabase.DoEscapeString(secure, search);
@@ -182,6 +208,10 @@ PyObject *LSCDB::LookupCorporationTickers(const std::string & search) {
 
 
 PyObject *LSCDB::LookupStations(const std::string & search) {
+    PyObject *indexed = sNameIndex.LookupStations(search);
+    if (indexed != NULL)
+        return indexed;
+
     DBQueryResult res;
     std::string secure;
     sDatabase.DoEscapeString(secure, search);
@@ -201,6 +231,10 @@ PyObject *LSCDB::LookupStations(const std::string & search) {
 
 
 PyObject *LSCDB::LookupKnownLocationsByGroup(const std::string & search, uint32 typeID) {
+    PyObject *indexed = sNameIndex.LookupKnownLocations(search, typeID);
+    if (indexed != NULL)
+        return indexed;
+
     DBQueryResult res;
     std::string secure;
     sDatabase.DoEscapeString(secure, search);
@@ -378,8 +378,11 @@ PyResult LSCService::Handle_JoinChannels(PyCallArgs &call) {
                 // this one'll create an empty query result
                 // noone implemented channel mods.
                 chjr.ChannelMods = channel->EncodeChannelMods();
-                chjr.ChannelChars = channel->EncodeChannelChars();
-               // chjr.ChannelChars = channel->EncodeEmptyChannelChars();
+                // the joiners of a lazy channel fetch the members with GetMembers
+                if( channel->IsLazy() )
+                    chjr.ChannelChars = channel->EncodeEmptyChannelChars();
+                else
+                    chjr.ChannelChars = channel->EncodeChannelChars();
 
                 channel->JoinChannel( call.client );
 
@@ -556,6 +559,21 @@ void LSCService::CharacterLogout(uint32 charID, OnLSC_SenderInfo* si)
     SafeDelete( si );
 }
 
+void LSCService::Process()
+{
+    std::set<uint32>::const_iterator cur, end;
+    cur = m_pendingFlushes.begin();
+    end = m_pendingFlushes.end();
+    for(; cur != end; cur++)
+    {
+        std::map<uint32, LSCChannel*>::iterator res = m_channels.find( *cur );
+        if( res != m_channels.end() )
+            res->second->FlushMembership();
+    }
+
+    m_pendingFlushes.clear();
+}
+
 
 PyResult LSCService::Handle_CreateChannel( PyCallArgs& call )
 {
@@ -1008,7 +1026,7 @@ PyResult LSCService::Handle_SendMessage( PyCallArgs& call )
 
     if( message.at(0) == '.' )
     {
-        sLog.Debug( "LSCService::Handle_SendMessage()", "CALL to SlashService->SlashCmd() via LSC Service, baby!" );
+        _debug( "LSCService::Handle_SendMessage()", "CALL to SlashService->SlashCmd() via LSC Service, baby!" );
 
         if( m_manager->LookupService("slash") != NULL )
             static_cast<SlashService *>(m_manager->LookupService("slash"))->SlashCommand( call.client, message );
@@ -0,0 +1,658 @@
+/*
+    ------------------------------------------------------------------------------------
+    LICENSE:
+    ------------------------------------------------------------------------------------
+    This file is part of EVEmu: EVE Online Server Emulator
+    Copyright 2006 - 2011 The EVEmu Team
+    For the latest information visit http://evemu.org
+    ------------------------------------------------------------------------------------
+    This program is free software; you can redistribute it and/or modify it under
+    the terms of the GNU Lesser General Public License as published by the Free Software
+    Foundation; either version 2 of the License, or (at your option) any later
+    version.
+
+    This program is distributed in the hope that it will be useful, but WITHOUT
+    ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+    FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public License along with
+    this program; if not, write to the Free Software Foundation, Inc., 59 Temple
+    Place - Suite 330, Boston, MA 02111-1307, USA, or go to
+    http://www.gnu.org/copyleft/lesser.txt.
+    ------------------------------------------------------------------------------------
+    Author:     EVEmu Team
+*/
+
+#include "eve-server.h"
+
+#include "chat/NameIndex.h"
+
+/// typeID of the solar systems.
+static const uint32 SOLAR_SYSTEM_TYPE_ID = 5;
+
+/// The characters of a regular expression which are not served from the index.
+static const char* const REGEX_SPECIAL_CHARS = ".[]()*+?{}|\\^$";
+
+/**
+ * @brief Creates an empty util.Rowset with the given columns.
+ *
+ * @param[out] lines The list the lines of the rowset go into.
+ */
+static PyObject* NewRowset( const char* const* columns, size_t count, PyList*& lines )
+{
+    static const MarshalStringToken type( "util.Rowset" );
+
+    PyDict* args = new PyDict;
+    PyObject* res = new PyObject( new PyString( type ), args );
+
+    PyList* header = new PyList( count );
+    for( size_t i = 0; i < count; ++i )
+        header->SetItem( i, PyStatic::InternString( columns[ i ] ) );
+    args->SetItem( PyStatic::NewString( "header" ), header );
+
+    args->SetItem( PyStatic::NewString( "RowClass" ), new PyToken( "util.Row" ) );
+
+    lines = new PyList;
+    args->SetItem( PyStatic::NewString( "lines" ), lines );
+
+    return res;
+}
+
+NameIndex::NameIndex()
+{
+}
+
+bool NameIndex::Load()
+{
+    mEntries.clear();
+    mFreeSlots.clear();
+    mSlots.clear();
+    mTrigrams.clear();
+    mLocationTypes.clear();
+
+    DBQueryResult res;
+    DBResultRow row;
+
+    if( !sDatabase.RunQuery( res,
+        "SELECT characterID, itemName, typeID"
+        " FROM character_"
+        "  LEFT JOIN entity ON characterID = itemID" ) )
+    {
+        codelog( SERVICE__ERROR, "Error in query: %s", res.error.c_str() );
+        return false;
+    }
+    while( res.GetRow( row ) )
+    {
+        if( !row.IsNull( 1 ) )
+            Add( NAME_CHARACTER, row.GetUInt( 0 ), row.GetText( 1 ), row.GetUInt( 2 ) );
+    }
+
+    if( !sDatabase.RunQuery( res,
+        "SELECT corporationID, corporationName, corporationType, tickerName"
+        " FROM corporation" ) )
+    {
+        codelog( SERVICE__ERROR, "Error in query: %s", res.error.c_str() );
+        return false;
+    }
+    while( res.GetRow( row ) )
+    {
+        Add( NAME_CORPORATION, row.GetUInt( 0 ), row.GetText( 1 ), row.GetUInt( 2 ) );
+        Add( NAME_CORPORATION_TICKER, row.GetUInt( 0 ), row.GetText( 3 ), 0, row.GetText( 1 ) );
+    }
+
+    if( !sDatabase.RunQuery( res,
+        "SELECT allianceID, shortName"
+        " FROM alliance_ShortNames" ) )
+    {
+        codelog( SERVICE__ERROR, "Error in query: %s", res.error.c_str() );
+        return false;
+    }
+    while( res.GetRow( row ) )
+        Add( NAME_ALLIANCE, row.GetUInt( 0 ), row.GetText( 1 ), 0 );
+
+    if( !sDatabase.RunQuery( res,
+        "SELECT factionID, factionName"
+        " FROM chrFactions" ) )
+    {
+        codelog( SERVICE__ERROR, "Error in query: %s", res.error.c_str() );
+        return false;
+    }
+    while( res.GetRow( row ) )
+        Add( NAME_FACTION, row.GetUInt( 0 ), row.GetText( 1 ), 0 );
+
+    if( !sDatabase.RunQuery( res,
+        "SELECT solarSystemID, solarSystemName"
+        " FROM mapSolarSystems" ) )
+    {
+        codelog( SERVICE__ERROR, "Error in query: %s", res.error.c_str() );
+        return false;
+    }
+    while( res.GetRow( row ) )
+        Add( NAME_SOLAR_SYSTEM, row.GetUInt( 0 ), row.GetText( 1 ), SOLAR_SYSTEM_TYPE_ID );
+
+    if( !sDatabase.RunQuery( res,
+        "SELECT stationID, stationName, stationTypeID"
+        " FROM staStations" ) )
+    {
+        codelog( SERVICE__ERROR, "Error in query: %s", res.error.c_str() );
+        return false;
+    }
+    while( res.GetRow( row ) )
+        Add( NAME_STATION, row.GetUInt( 0 ), row.GetText( 1 ), row.GetUInt( 2 ) );
+
+    mStats.Reset();
+    return true;
+}
+
+void NameIndex::Add( NameKind kind, uint32 id, const std::string& name, uint32 typeID, const std::string& extra )
+{
+    const uint64 key = _EntryKey( kind, id );
+
+    uint32 slot;
+    std::tr1::unordered_map< uint64, uint32 >::const_iterator res = mSlots.find( key );
+    if( res != mSlots.end() )
+    {
+        slot = res->second;
+        _Unindex( slot );
+    }
+    else if( !mFreeSlots.empty() )
+    {
+        slot = mFreeSlots.back();
+        mFreeSlots.pop_back();
+    }
+    else
+    {
+        slot = mEntries.size();
+        mEntries.push_back( Entry() );
+    }
+    mSlots[ key ] = slot;
+
+    Entry& entry = mEntries[ slot ];
+    entry.id = id;
+    entry.kind = kind;
+    entry.typeID = typeID;
+    entry.name = name;
+    entry.lower = name;
+    std::transform( entry.lower.begin(), entry.lower.end(), entry.lower.begin(), ::tolower );
+    entry.extra = extra;
+
+    if( NAME_SOLAR_SYSTEM == kind || NAME_STATION == kind )
+        mLocationTypes.insert( typeID );
+
+    _Index( slot );
+    ++mStats.updates;
+}
+
+void NameIndex::Rename( uint32 itemID, const std::string& name )
+{
+    static const NameKind ITEM_KINDS[] = { NAME_CHARACTER, NAME_SOLAR_SYSTEM, NAME_STATION };
+
+    for( size_t i = 0; i < sizeof( ITEM_KINDS ) / sizeof( NameKind ); ++i )
+    {
+        std::tr1::unordered_map< uint64, uint32 >::const_iterator res = mSlots.find( _EntryKey( ITEM_KINDS[ i ], itemID ) );
+        if( res == mSlots.end() )
+            continue;
+
+        const Entry& entry = mEntries[ res->second ];
+        if( entry.name != name )
+            Add( ITEM_KINDS[ i ], itemID, name, entry.typeID, entry.extra );
+        return;
+    }
+}
+
+void NameIndex::Remove( NameKind kind, uint32 id )
+{
+    std::tr1::unordered_map< uint64, uint32 >::iterator res = mSlots.find( _EntryKey( kind, id ) );
+    if( res == mSlots.end() )
+        return;
+
+    const uint32 slot = res->second;
+    mSlots.erase( res );
+
+    _Unindex( slot );
+
+    Entry& entry = mEntries[ slot ];
+    entry.name.clear();
+    entry.lower.clear();
+    entry.extra.clear();
+    mFreeSlots.push_back( slot );
+
+    ++mStats.updates;
+}
+
+PyObject* NameIndex::LookupCharacters( const std::string& match, bool exact, bool playersOnly )
+{
+    static const char* const COLUMNS[] = { "characterID", "characterName", "typeID" };
+
+    std::vector< const Entry* > matches;
+    if( "__ALL__" == match )
+    {
+        // every player character, in no particular order
+        std::vector< Entry >::const_iterator cur, end;
+        cur = mEntries.begin();
+        end = mEntries.end();
+        for(; cur != end; ++cur)
+        {
+            if( NAME_CHARACTER == cur->kind && !cur->name.empty() && EVEMU_MINIMUM_ID <= cur->id )
+                matches.push_back( &*cur );
+        }
+        ++mStats.lookups;
+    }
+    else
+    {
+        Query query;
+        if( !_ParseQuery( match, exact, query ) )
+        {
+            ++mStats.fallbacks;
+            return NULL;
+        }
+
+        _Search( query, 1 << NAME_CHARACTER, matches );
+    }
+
+    PyList* lines;
+    PyObject* res = NewRowset( COLUMNS, 3, lines );
+
+    std::vector< const Entry* >::const_iterator cur, end;
+    cur = matches.begin();
+    end = matches.end();
+    for(; cur != end; ++cur)
+    {
+        if( playersOnly && (*cur)->id < EVEMU_MINIMUM_ID )
+            continue;
+
+        PyList* line = new PyList( 3 );
+        line->SetItem( 0, new PyInt( (*cur)->id ) );
+        line->SetItem( 1, new PyString( (*cur)->name ) );
+        line->SetItem( 2, new PyInt( (*cur)->typeID ) );
+        lines->AddItem( line );
+    }
+
+    return res;
+}
+
+PyObject* NameIndex::LookupOwners( const std::string& match, bool exact )
+{
+    static const char* const COLUMNS[] = { "ownerID", "ownerName", "groupID" };
+
+    Query query;
+    if( !_ParseQuery( match, exact, query ) )
+    {
+        ++mStats.fallbacks;
+        return NULL;
+    }
+
+    std::vector< const Entry* > matches;
+    _Search( query, ( 1 << NAME_CHARACTER ) | ( 1 << NAME_CORPORATION ) | ( 1 << NAME_ALLIANCE ), matches );
+
+    PyList* lines;
+    PyObject* res = NewRowset( COLUMNS, 3, lines );
+
+    std::vector< const Entry* >::const_iterator cur, end;
+    cur = matches.begin();
+    end = matches.end();
+    for(; cur != end; ++cur)
+    {
+        uint32 groupID;
+        switch( (*cur)->kind )
+        {
+            case NAME_CHARACTER:
+            {
+                if( (*cur)->id < EVEMU_MINIMUM_ID )
+                    continue;
+                groupID = EVEDB::invGroups::Character;
+            } break;
+            case NAME_CORPORATION: groupID = EVEDB::invGroups::Corporation; break;
+            default:               groupID = EVEDB::invGroups::Alliance;    break;
+        }
+
+        PyList* line = new PyList( 3 );
+        line->SetItem( 0, new PyInt( (*cur)->id ) );
+        line->SetItem( 1, new PyString( (*cur)->name ) );
+        line->SetItem( 2, new PyInt( groupID ) );
+        lines->AddItem( line );
+    }
+
+    return res;
+}
+
+PyObject* NameIndex::LookupCorporations( const std::string& match )
+{
+    static const char* const COLUMNS[] = { "corporationID", "corporationName", "corporationType" };
+
+    Query query;
+    if( !_ParseQuery( match, false, query ) )
+    {
+        ++mStats.fallbacks;
+        return NULL;
+    }
+
+    std::vector< const Entry* > matches;
+    _Search( query, 1 << NAME_CORPORATION, matches );
+
+    PyList* lines;
+    PyObject* res = NewRowset( COLUMNS, 3, lines );
+
+    std::vector< const Entry* >::const_iterator cur, end;
+    cur = matches.begin();
+    end = matches.end();
+    for(; cur != end; ++cur)
+    {
+        PyList* line = new PyList( 3 );
+        line->SetItem( 0, new PyInt( (*cur)->id ) );
+        line->SetItem( 1, new PyString( (*cur)->name ) );
+        line->SetItem( 2, new PyInt( (*cur)->typeID ) );
+        lines->AddItem( line );
+    }
+
+    return res;
+}
+
+PyObject* NameIndex::LookupCorporationTickers( const std::string& match )
+{
+    static const char* const COLUMNS[] = { "corporationID", "corporationName", "tickerName" };
+
+    Query query;
+    if( !_ParseQuery( match, false, query ) )
+    {
+        ++mStats.fallbacks;
+        return NULL;
+    }
+
+    std::vector< const Entry* > matches;
+    _Search( query, 1 << NAME_CORPORATION_TICKER, matches );
+
+    PyList* lines;
+    PyObject* res = NewRowset( COLUMNS, 3, lines );
+
+    std::vector< const Entry* >::const_iterator cur, end;
+    cur = matches.begin();
+    end = matches.end();
+    for(; cur != end; ++cur)
+    {
+        PyList* line = new PyList( 3 );
+        line->SetItem( 0, new PyInt( (*cur)->id ) );
+        line->SetItem( 1, new PyString( (*cur)->extra ) );
+        line->SetItem( 2, new PyString( (*cur)->name ) );
+        lines->AddItem( line );
+    }
+
+    return res;
+}
+
+PyObject* NameIndex::LookupFactions( const std::string& match )
+{
+    static const char* const COLUMNS[] = { "factionID", "factionName" };
+
+    Query query;
+    if( !_ParseQuery( match, false, query ) )
+    {
+        ++mStats.fallbacks;
+        return NULL;
+    }
+
+    std::vector< const Entry* > matches;
+    _Search( query, 1 << NAME_FACTION, matches );
+
+    PyList* lines;
+    PyObject* res = NewRowset( COLUMNS, 2, lines );
+
+    std::vector< const Entry* >::const_iterator cur, end;
+    cur = matches.begin();
+    end = matches.end();
+    for(; cur != end; ++cur)
+    {
+        PyList* line = new PyList( 2 );
+        line->SetItem( 0, new PyInt( (*cur)->id ) );
+        line->SetItem( 1, new PyString( (*cur)->name ) );
+        lines->AddItem( line );
+    }
+
+    return res;
+}
+
+PyObject* NameIndex::LookupStations( const std::string& match )
+{
+    static const char* const COLUMNS[] = { "stationID", "stationName", "stationTypeID" };
+
+    Query query;
+    if( !_ParseQuery( match, false, query ) )
+    {
+        ++mStats.fallbacks;
+        return NULL;
+    }
+
+    std::vector< const Entry* > matches;
+    _Search( query, 1 << NAME_STATION, matches );
+
+    PyList* lines;
+    PyObject* res = NewRowset( COLUMNS, 3, lines );
+
+    std::vector< const Entry* >::const_iterator cur, end;
+    cur = matches.begin();
+    end = matches.end();
+    for(; cur != end; ++cur)
+    {
+        PyList* line = new PyList( 3 );
+        line->SetItem( 0, new PyInt( (*cur)->id ) );
+        line->SetItem( 1, new PyString( (*cur)->name ) );
+        line->SetItem( 2, new PyInt( (*cur)->typeID ) );
+        lines->AddItem( line );
+    }
+
+    return res;
+}
+
+PyObject* NameIndex::LookupKnownLocations( const std::string& match, uint32 typeID )
+{
+    static const char* const COLUMNS[] = { "itemID", "itemName", "typeID" };
+
+    // other items of the entity table are left to the database
+    Query query;
+    if( 0 == mLocationTypes.count( typeID ) || !_ParseQuery( match, false, query ) )
+    {
+        ++mStats.fallbacks;
+        return NULL;
+    }
+
+    std::vector< const Entry* > matches;
+    _Search( query, ( 1 << NAME_SOLAR_SYSTEM ) | ( 1 << NAME_STATION ), matches );
+
+    PyList* lines;
+    PyObject* res = NewRowset( COLUMNS, 3, lines );
+
+    std::vector< const Entry* >::const_iterator cur, end;
+    cur = matches.begin();
+    end = matches.end();
+    for(; cur != end; ++cur)
+    {
+        if( (*cur)->typeID != typeID )
+            continue;
+
+        PyList* line = new PyList( 3 );
+        line->SetItem( 0, new PyInt( (*cur)->id ) );
+        line->SetItem( 1, new PyString( (*cur)->name ) );
+        line->SetItem( 2, new PyInt( (*cur)->typeID ) );
+        lines->AddItem( line );
+    }
+
+    return res;
+}
+
+bool NameIndex::_ParseQuery( const std::string& match, bool exact, Query& into )
+{
+    into.text = match;
+    into.exact = exact;
+    into.anchorStart = false;
+    into.anchorEnd = false;
+
+    if( !exact )
+    {
+        if( !into.text.empty() && '^' == into.text[ 0 ] )
+        {
+            into.anchorStart = true;
+            into.text.erase( 0, 1 );
+        }
+        if( !into.text.empty() && '$' == into.text[ into.text.size() - 1 ] )
+        {
+            into.anchorEnd = true;
+            into.text.erase( into.text.size() - 1 );
+        }
+
+        // MySQL refuses an empty regular expression
+        if( into.text.empty() || std::string::npos != into.text.find_first_of( REGEX_SPECIAL_CHARS ) )
+            return false;
+    }
+
+    // the names compare without case, which only tolower() knows for ASCII
+    std::string::iterator cur, end;
+    cur = into.text.begin();
+    end = into.text.end();
+    for(; cur != end; ++cur)
+    {
+        if( 0x80 & *cur )
+            return false;
+        *cur = ::tolower( *cur );
+    }
+
+    return true;
+}
+
+int NameIndex::_Rank( const Query& query, const std::string& lower )
+{
+    if( query.exact )
+        return ( lower == query.text ? 0 : -1 );
+
+    size_t pos = lower.find( query.text );
+    if( query.anchorEnd )
+        pos = ( lower.size() < query.text.size() ? std::string::npos : lower.size() - query.text.size() );
+    if( std::string::npos == pos
+        || 0 != lower.compare( pos, query.text.size(), query.text )
+        || ( query.anchorStart && 0 != pos ) )
+    {
+        return -1;
+    }
+
+    if( lower.size() == query.text.size() )
+        return 0;
+    if( 0 == pos )
+        return 1;
+
+    // any occurrence at the start of a word ranks above those inside one
+    for(; std::string::npos != pos; pos = lower.find( query.text, pos + 1 ) )
+    {
+        if( !::isalnum( lower[ pos - 1 ] ) )
+            return 2;
+        if( query.anchorEnd )
+            break;
+    }
+    return 3;
+}
+
+uint32 NameIndex::_TrigramKey( uint8 kind, const char* trigram )
+{
+    return ( (uint32)kind << 24 )
+         | ( (uint32)(uint8)trigram[ 0 ] << 16 )
+         | ( (uint32)(uint8)trigram[ 1 ] << 8 )
+         | (uint32)(uint8)trigram[ 2 ];
+}
+
+void NameIndex::_Search( const Query& query, uint32 kinds, std::vector< const Entry* >& into )
+{
+    ++mStats.lookups;
+
+    std::vector< std::pair< std::pair< int, size_t >, const Entry* > > ranked;
+
+    if( query.text.size() < 3 )
+    {
+        // too short for a trigram; there are few such searches
+        std::vector< Entry >::const_iterator cur, end;
+        cur = mEntries.begin();
+        end = mEntries.end();
+        for(; cur != end; ++cur)
+        {
+            if( 0 == ( kinds & ( 1 << cur->kind ) ) || cur->name.empty() )
+                continue;
+
+            ++mStats.examined;
+            const int rank = _Rank( query, cur->lower );
+            if( 0 <= rank )
+                ranked.push_back( std::make_pair( std::make_pair( rank, cur->lower.size() ), &*cur ) );
+        }
+    }
+    else
+    {
+        for( uint8 kind = 0; kind < NAME_KIND_COUNT; ++kind )
+        {
+            if( 0 == ( kinds & ( 1 << kind ) ) )
+                continue;
+
+            // every match has all the trigrams of the text; verify those with the rarest one
+            const std::vector< uint32 >* rarest = NULL;
+            for( size_t i = 0; i + 3 <= query.text.size(); ++i )
+            {
+                std::tr1::unordered_map< uint32, std::vector< uint32 > >::const_iterator res =
+                    mTrigrams.find( _TrigramKey( kind, &query.text[ i ] ) );
+                if( res == mTrigrams.end() )
+                {
+                    rarest = NULL;
+                    break;
+                }
+
+                if( NULL == rarest || res->second.size() < rarest->size() )
+                    rarest = &res->second;
+            }
+            if( NULL == rarest )
+                continue;
+
+            std::vector< uint32 >::const_iterator cur, end;
+            cur = rarest->begin();
+            end = rarest->end();
+            for(; cur != end; ++cur)
+            {
+                const Entry& entry = mEntries[ *cur ];
+
+                ++mStats.examined;
+                const int rank = _Rank( query, entry.lower );
+                if( 0 <= rank )
+                    ranked.push_back( std::make_pair( std::make_pair( rank, entry.lower.size() ), &entry ) );
+            }
+        }
+    }
+
+    std::sort( ranked.begin(), ranked.end() );
+
+    into.reserve( into.size() + ranked.size() );
+    for( size_t i = 0; i < ranked.size(); ++i )
+        into.push_back( ranked[ i ].second );
+}
+
+void NameIndex::_Index( uint32 slot )
+{
+    const Entry& entry = mEntries[ slot ];
+    for( size_t i = 0; i + 3 <= entry.lower.size(); ++i )
+    {
+        std::vector< uint32 >& slots = mTrigrams[ _TrigramKey( entry.kind, &entry.lower[ i ] ) ];
+
+        // a trigram repeated in the name is listed once
+        if( slots.empty() || slots.back() != slot )
+            slots.push_back( slot );
+    }
+}
+
+void NameIndex::_Unindex( uint32 slot )
+{
+    const Entry& entry = mEntries[ slot ];
+    for( size_t i = 0; i + 3 <= entry.lower.size(); ++i )
+    {
+        std::tr1::unordered_map< uint32, std::vector< uint32 > >::iterator res =
+            mTrigrams.find( _TrigramKey( entry.kind, &entry.lower[ i ] ) );
+        if( res == mTrigrams.end() )
+            continue;
+
+        std::vector< uint32 >& slots = res->second;
+        slots.erase( std::remove( slots.begin(), slots.end(), slot ), slots.end() );
+        if( slots.empty() )
+            mTrigrams.erase( res );
+    }
+}
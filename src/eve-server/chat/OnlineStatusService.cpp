@@ -27,6 +27,7 @@
 
 #include "PyServiceCD.h"
 #include "chat/OnlineStatusService.h"
+#include "chat/Presence.h"
 
 PyCallable_Make_InnerDispatcher(OnlineStatusService)
 
@@ -45,11 +46,6 @@ OnlineStatusService::~OnlineStatusService() {
 
 PyResult OnlineStatusService::Handle_GetInitialState(PyCallArgs &call) {
 
-    // this is used to query the initial online state of all friends. dummy.
-
-    DBRowDescriptor *header = new DBRowDescriptor();
-    header->AddColumn("contactID", DBTYPE_I4);
-    header->AddColumn("online", DBTYPE_I4);
-    CRowSet *rowset = new CRowSet( &header );
-    return rowset;
+    // this is used to query the initial online state of all friends.
+    return sPresence.EncodeWatchedState(call.client->GetCharacterID());
 }
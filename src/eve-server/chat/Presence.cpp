@@ -0,0 +1,240 @@
+/*
+    ------------------------------------------------------------------------------------
+    LICENSE:
+    ------------------------------------------------------------------------------------
+    This file is part of EVEmu: EVE Online Server Emulator
+    Copyright 2006 - 2011 The EVEmu Team
+    For the latest information visit http://evemu.org
+    ------------------------------------------------------------------------------------
+    This program is free software; you can redistribute it and/or modify it under
+    the terms of the GNU Lesser General Public License as published by the Free Software
+    Foundation; either version 2 of the License, or (at your option) any later
+    version.
+
+    This program is distributed in the hope that it will be useful, but WITHOUT
+    ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+    FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public License along with
+    this program; if not, write to the Free Software Foundation, Inc., 59 Temple
+    Place - Suite 330, Boston, MA 02111-1307, USA, or go to
+    http://www.gnu.org/copyleft/lesser.txt.
+    ------------------------------------------------------------------------------------
+    Author:     EVEmu Team
+*/
+
+
+#include "eve-server.h"
+
+#include "Client.h"
+#include "EntityList.h"
+#include "chat/Presence.h"
+
+Presence::Presence()
+{
+}
+
+bool Presence::Load()
+{
+    DBQueryResult res;
+
+    if( !sDatabase.RunQuery( res,
+        "SELECT ownerID, contactID"
+        " FROM chrContacts"
+        " WHERE inWatchList = 1" ) )
+    {
+        sLog.Error( "Presence", "Failed to load the watch lists: %s.", res.error.c_str() );
+        return false;
+    }
+
+    mWatchers.clear();
+    mWatched.clear();
+
+    DBResultRow row;
+    while( res.GetRow( row ) )
+    {
+        mWatchers[ row.GetUInt( 1 ) ].insert( row.GetUInt( 0 ) );
+        mWatched[ row.GetUInt( 0 ) ].insert( row.GetUInt( 1 ) );
+    }
+
+    return true;
+}
+
+void Presence::Process()
+{
+    if( mChanges.empty() )
+        return;
+
+    // the events of every online watcher
+    std::map< Client*, PyList* > events;
+
+    std::map< uint32, bool >::const_iterator cur, end;
+    cur = mChanges.begin();
+    end = mChanges.end();
+    for(; cur != end; ++cur )
+    {
+        WatchMap::const_iterator watchers = mWatchers.find( cur->first );
+        if( watchers == mWatchers.end() )
+            continue;
+
+        PyTuple* event = NULL;
+
+        std::set< uint32 >::const_iterator curw, endw;
+        curw = watchers->second.begin();
+        endw = watchers->second.end();
+        for(; curw != endw; ++curw )
+        {
+            if( !IsOnline( *curw ) )
+                continue;
+
+            Client* client = sEntityList.FindCharacter( *curw );
+            if( NULL == client )
+                continue;
+
+            // encoded once for all the watchers
+            if( NULL == event )
+            {
+                event = new PyTuple( 2 );
+                event->SetItem( 0, new PyString( cur->second ? "OnContactLoggedOn" : "OnContactLoggedOff" ) );
+                event->SetItem( 1, new PyInt( cur->first ) );
+            }
+
+            PyList*& list = events[ client ];
+            if( NULL == list )
+                list = new PyList;
+
+            PyIncRef( event );
+            list->AddItem( event );
+            ++mStats.pushed;
+        }
+
+        PySafeDecRef( event );
+    }
+
+    mChanges.clear();
+
+    std::map< Client*, PyList* >::iterator curc, endc;
+    curc = events.begin();
+    endc = events.end();
+    for(; curc != endc; ++curc )
+    {
+        Notify_OnMultiEvent nom;
+        nom.events = curc->second;
+
+        PyTuple* t = nom.Encode();   //this is consumed below
+        curc->first->SendNotification( "OnMultiEvent", "charid", &t );
+        ++mStats.pushes;
+    }
+}
+
+void Presence::Login( uint32 characterID )
+{
+    mOnline.insert( characterID );
+    ++mStats.logins;
+
+    std::map< uint32, bool >::iterator res = mChanges.find( characterID );
+    if( res != mChanges.end() && !res->second )
+    {
+        // logged out and back in within the tick; nothing changed for the watchers
+        mChanges.erase( res );
+        ++mStats.coalesced;
+        return;
+    }
+
+    mChanges[ characterID ] = true;
+}
+
+void Presence::Logout( uint32 characterID )
+{
+    mOnline.erase( characterID );
+    ++mStats.logouts;
+
+    std::map< uint32, bool >::iterator res = mChanges.find( characterID );
+    if( res != mChanges.end() && res->second )
+    {
+        mChanges.erase( res );
+        ++mStats.coalesced;
+        return;
+    }
+
+    mChanges[ characterID ] = false;
+}
+
+void Presence::AddWatcher( uint32 watcherID, uint32 characterID )
+{
+    mWatchers[ characterID ].insert( watcherID );
+    mWatched[ watcherID ].insert( characterID );
+}
+
+void Presence::RemoveWatcher( uint32 watcherID, uint32 characterID )
+{
+    WatchMap::iterator res = mWatchers.find( characterID );
+    if( res != mWatchers.end() )
+    {
+        res->second.erase( watcherID );
+        if( res->second.empty() )
+            mWatchers.erase( res );
+    }
+
+    res = mWatched.find( watcherID );
+    if( res != mWatched.end() )
+    {
+        res->second.erase( characterID );
+        if( res->second.empty() )
+            mWatched.erase( res );
+    }
+}
+
+void Presence::Remove( uint32 characterID )
+{
+    WatchMap::iterator res = mWatched.find( characterID );
+    if( res != mWatched.end() )
+    {
+        const std::set< uint32 > watched = res->second;
+
+        std::set< uint32 >::const_iterator cur, end;
+        cur = watched.begin();
+        end = watched.end();
+        for(; cur != end; ++cur )
+            RemoveWatcher( characterID, *cur );
+    }
+
+    res = mWatchers.find( characterID );
+    if( res != mWatchers.end() )
+    {
+        const std::set< uint32 > watchers = res->second;
+
+        std::set< uint32 >::const_iterator cur, end;
+        cur = watchers.begin();
+        end = watchers.end();
+        for(; cur != end; ++cur )
+            RemoveWatcher( *cur, characterID );
+    }
+
+    mChanges.erase( characterID );
+}
+
+PyObjectEx* Presence::EncodeWatchedState( uint32 watcherID ) const
+{
+    DBRowDescriptor* header = new DBRowDescriptor();
+    header->AddColumn( "contactID", DBTYPE_I4 );
+    header->AddColumn( "online",    DBTYPE_I4 );
+
+    CRowSet* rowset = new CRowSet( &header );
+
+    WatchMap::const_iterator res = mWatched.find( watcherID );
+    if( res == mWatched.end() )
+        return rowset;
+
+    std::set< uint32 >::const_iterator cur, end;
+    cur = res->second.begin();
+    end = res->second.end();
+    for(; cur != end; ++cur )
+    {
+        PyPackedRow* row = rowset->NewRow();
+        row->SetField( (uint32)0, new PyInt( *cur ) );
+        row->SetField( 1, new PyInt( IsOnline( *cur ) ? 1 : 0 ) );
+    }
+
+    return rowset;
+}
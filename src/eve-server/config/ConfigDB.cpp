@@ -484,14 +484,3 @@ PyRep *ConfigDB::GetDynamicCelestials(uint32 solarSystemID) {
     return DBResultToRowset(result);
 }
 
-PyRep *ConfigDB::GetTextsForGroup(const std::string & langID, uint32 textgroup) {
-    DBQueryResult res;
-    if (!sDatabase.RunQuery(res, "SELECT textLabel, `text` FROM intro WHERE langID = '%s' AND textgroup = %u", langID.c_str(), textgroup))
-    {
-        codelog(SERVICE__ERROR, "Error in query: %s", res.error.c_str());
-        return NULL;
-    }
-
-    return DBResultToRowset(res);
-}
-
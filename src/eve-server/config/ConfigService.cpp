@@ -27,6 +27,7 @@
 
 #include "PyServiceCD.h"
 #include "config/ConfigService.h"
+#include "config/OwnerDirectory.h"
 
 PyCallable_Make_InnerDispatcher(ConfigService)
 
@@ -63,7 +64,7 @@ PyResult ConfigService::Handle_GetMultiOwnersEx(PyCallArgs &call) {
         return NULL;
     }
 
-    return(m_db.GetMultiOwnersEx(arg.ints));
+    return(sOwnerDirectory.Get(OwnerDirectory::ROW_OWNER, arg.ints));
 }
 
 PyResult ConfigService::Handle_GetMultiAllianceShortNamesEx(PyCallArgs &call) {
@@ -74,7 +75,7 @@ PyResult ConfigService::Handle_GetMultiAllianceShortNamesEx(PyCallArgs &call) {
         return NULL;
     }
 
-    return(m_db.GetMultiAllianceShortNamesEx(arg.ints));
+    return(sOwnerDirectory.Get(OwnerDirectory::ROW_ALLIANCE_SHORT_NAME, arg.ints));
 }
 
 
@@ -86,7 +87,7 @@ PyResult ConfigService::Handle_GetMultiLocationsEx(PyCallArgs &call) {
         return NULL;
     }
 
-    return(m_db.GetMultiLocationsEx(arg.ints));
+    return(sOwnerDirectory.Get(OwnerDirectory::ROW_LOCATION, arg.ints));
 }
 
 PyResult ConfigService::Handle_GetMultiCorpTickerNamesEx(PyCallArgs &call) {
@@ -97,7 +98,7 @@ PyResult ConfigService::Handle_GetMultiCorpTickerNamesEx(PyCallArgs &call) {
         return NULL;
     }
 
-    return(m_db.GetMultiCorpTickerNamesEx(arg.ints));
+    return(sOwnerDirectory.Get(OwnerDirectory::ROW_CORP_TICKER, arg.ints));
 }
 
 PyResult ConfigService::Handle_GetMultiGraphicsEx(PyCallArgs &call) {
@@ -251,7 +252,7 @@ PyResult ConfigService::Handle_GetMultiInvTypesEx(PyCallArgs &call) {
         return NULL;
     }
 
-    return(m_db.GetMultiInvTypesEx(arg.ints));
+    return(sOwnerDirectory.Get(OwnerDirectory::ROW_INV_TYPE, arg.ints));
 }
 
 
@@ -279,7 +280,7 @@ CREATE TABLE GetMapConnections (
   PRIMARY KEY()
 );
 */
-    sLog.Debug( "ConfigService", "Called GetMapConnections stub." );
+    _debug( "ConfigService", "Called GetMapConnections stub." );
 
     return NULL;
 }
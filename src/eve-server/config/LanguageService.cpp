@@ -26,7 +26,9 @@
 #include "eve-server.h"
 
 #include "PyServiceCD.h"
+#include "cache/ObjCacheService.h"
 #include "config/LanguageService.h"
+#include "config/TextStore.h"
 
 /*
 class LanguageBound
@@ -87,11 +89,7 @@ PyBoundObject *LanguageService::_CreateBoundObject(Client *c, PyTuple *bind_args
 
 
 PyResult LanguageService::Handle_GetLanguages(PyCallArgs &call) {
-    PyRep *result = NULL;
-
-    result = m_db.ListLanguages();
-
-    return result;
+    return sTextStore.GetLanguages();
 }
 PyResult LanguageService::Handle_GetTextsForGroup(PyCallArgs &call) {
     Call_GetTextsForGroup args;
@@ -101,7 +99,17 @@ PyResult LanguageService::Handle_GetTextsForGroup(PyCallArgs &call) {
         return NULL;
     }
 
-    return m_db.GetTextsForGroup(args.languageID, args.textgroup);
+    const PyRep *objectID = sTextStore.GetGroupObjectID(args.languageID, args.textgroup);
+    if(objectID == NULL)
+        return sTextStore.BuildGroup(args.languageID, args.textgroup);
+
+    //marshaled and deflated once per group by the cache service
+    if(!m_manager->cache_service->IsCacheLoaded(objectID)) {
+        PyRep *rowset = sTextStore.BuildGroup(args.languageID, args.textgroup);
+        m_manager->cache_service->GiveCache(objectID, &rowset);
+    }
+
+    return(m_manager->cache_service->MakeObjectCachedMethodCallResult(objectID));
 }
 
 
@@ -0,0 +1,257 @@
+/*
+    ------------------------------------------------------------------------------------
+    LICENSE:
+    ------------------------------------------------------------------------------------
+    This file is part of EVEmu: EVE Online Server Emulator
+    Copyright 2006 - 2011 The EVEmu Team
+    For the latest information visit http://evemu.org
+    ------------------------------------------------------------------------------------
+    This program is free software; you can redistribute it and/or modify it under
+    the terms of the GNU Lesser General Public License as published by the Free Software
+    Foundation; either version 2 of the License, or (at your option) any later
+    version.
+
+    This program is distributed in the hope that it will be useful, but WITHOUT
+    ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+    FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public License along with
+    this program; if not, write to the Free Software Foundation, Inc., 59 Temple
+    Place - Suite 330, Boston, MA 02111-1307, USA, or go to
+    http://www.gnu.org/copyleft/lesser.txt.
+    ------------------------------------------------------------------------------------
+    Author:     EVEmu Team
+*/
+
+
+#include "eve-server.h"
+
+#include "config/OwnerDirectory.h"
+
+OwnerDirectory::OwnerDirectory()
+{
+}
+
+OwnerDirectory::~OwnerDirectory()
+{
+    for( size_t i = 0; i < ROW_KIND_COUNT; ++i )
+    {
+        Table& table = mTables[ i ];
+        PySafeDecRef( table.header );
+
+        std::tr1::unordered_map< uint32, PyRep* >::iterator cur, end;
+        cur = table.rows.begin();
+        end = table.rows.end();
+        for(; cur != end; cur++ )
+            PySafeDecRef( cur->second );
+    }
+}
+
+size_t OwnerDirectory::size() const
+{
+    size_t result = 0;
+    for( size_t i = 0; i < ROW_KIND_COUNT; ++i )
+        result += mTables[ i ].rows.size();
+
+    return result;
+}
+
+PyTuple* OwnerDirectory::Get( RowKind kind, const std::vector< int32 >& ids )
+{
+    Table& table = mTables[ kind ];
+    ++mStats.calls;
+
+    std::vector< int32 > misses;
+
+    std::vector< int32 >::const_iterator cur, end;
+    cur = ids.begin();
+    end = ids.end();
+    for(; cur != end; cur++ )
+    {
+        std::tr1::unordered_map< uint32, PyRep* >::const_iterator res = table.rows.find( *cur );
+        if( table.rows.end() == res )
+            misses.push_back( *cur );
+        else if( NULL == res->second )
+            ++mStats.negativeHits;
+        else
+            ++mStats.hits;
+    }
+
+    std::sort( misses.begin(), misses.end() );
+    misses.erase( std::unique( misses.begin(), misses.end() ), misses.end() );
+    mStats.misses += misses.size();
+
+    if( ROW_LOCATION == kind )
+    {
+        // the query searches either the static map or the entities, depending on the first ID
+        std::vector< int32 > mapIDs, entityIDs;
+        for( cur = misses.begin(), end = misses.end(); cur != end; cur++ )
+        {
+            if( IsStaticMapItem( *cur ) )
+                mapIDs.push_back( *cur );
+            else
+                entityIDs.push_back( *cur );
+        }
+
+        if( ( !mapIDs.empty() || NULL == table.header ) && !_Query( kind, table, mapIDs ) )
+            return NULL;
+        if( !entityIDs.empty() && !_Query( kind, table, entityIDs ) )
+            return NULL;
+    }
+    else if( ( !misses.empty() || NULL == table.header ) && !_Query( kind, table, misses ) )
+        return NULL;
+
+    PyList* rows = new PyList;
+
+    std::set< uint32 > served;
+    for( cur = ids.begin(), end = ids.end(); cur != end; cur++ )
+    {
+        PyRep* row = table.rows[ *cur ];
+        if( NULL == row || !served.insert( *cur ).second )
+            continue;
+
+        PyIncRef( row );
+        rows->AddItem( row );
+    }
+
+    PyTuple* result = new PyTuple( 2 );
+    PyIncRef( table.header );
+    result->SetItem( 0, table.header );
+    result->SetItem( 1, rows );
+    return result;
+}
+
+void OwnerDirectory::Invalidate( uint32 id )
+{
+    bool dropped = false;
+
+    for( size_t i = 0; i < ROW_KIND_COUNT; ++i )
+    {
+        Table& table = mTables[ i ];
+
+        std::tr1::unordered_map< uint32, PyRep* >::iterator res = table.rows.find( id );
+        if( table.rows.end() == res )
+            continue;
+
+        PySafeDecRef( res->second );
+        table.rows.erase( res );
+        dropped = true;
+    }
+
+    if( dropped )
+        ++mStats.invalidations;
+}
+
+bool OwnerDirectory::_Query( RowKind kind, Table& table, const std::vector< int32 >& ids )
+{
+    std::set< uint32 > remaining( ids.begin(), ids.end() );
+
+    bool first = true;
+    while( first || !remaining.empty() )
+    {
+        first = false;
+
+        PyTuple* res = _Run( kind, std::vector< int32 >( remaining.begin(), remaining.end() ) );
+        if( NULL == res )
+            return false;
+
+        ++mStats.queries;
+
+        // no columns at all
+        if( res->size() < 2 )
+        {
+            PyDecRef( res );
+            break;
+        }
+
+        if( NULL == table.header )
+        {
+            table.header = res->GetItem( 0 )->AsList();
+            PyIncRef( table.header );
+            table.header->Freeze();
+        }
+
+        size_t found = 0;
+
+        const PyList* rows = res->GetItem( 1 )->AsList();
+        for( size_t i = 0; i < rows->size(); ++i )
+        {
+            PyRep* row = rows->GetItem( i );
+            const uint32 id = _RowID( row );
+            if( 0 == remaining.erase( id ) )
+                continue;
+
+            PyIncRef( row );
+            row->Freeze();
+
+            PyRep*& slot = table.rows[ id ];
+            PySafeDecRef( slot );
+            slot = row;
+
+            ++found;
+        }
+
+        PyDecRef( res );
+
+        // the next query would return nothing more either
+        if( 0 == found )
+            break;
+    }
+
+    // these do not exist
+    std::set< uint32 >::const_iterator cur, end;
+    cur = remaining.begin();
+    end = remaining.end();
+    for(; cur != end; cur++ )
+        table.rows.insert( std::make_pair( *cur, (PyRep*)NULL ) );
+
+    return true;
+}
+
+PyTuple* OwnerDirectory::_Run( RowKind kind, const std::vector< int32 >& ids )
+{
+    PyRep* res = NULL;
+    switch( kind )
+    {
+        case ROW_OWNER:               res = mDB.GetMultiOwnersEx( ids ); break;
+        case ROW_LOCATION:            res = mDB.GetMultiLocationsEx( ids ); break;
+        case ROW_ALLIANCE_SHORT_NAME: res = mDB.GetMultiAllianceShortNamesEx( ids ); break;
+        case ROW_CORP_TICKER:         res = mDB.GetMultiCorpTickerNamesEx( ids ); break;
+        case ROW_INV_TYPE:            res = mDB.GetMultiInvTypesEx( ids ); break;
+        default:                      break;
+    }
+
+    if( NULL == res )
+        return NULL;
+
+    if( !res->IsTuple() )
+    {
+        PyDecRef( res );
+        return NULL;
+    }
+
+    return res->AsTuple();
+}
+
+uint32 OwnerDirectory::_RowID( const PyRep* row )
+{
+    // a plain list, or a util.Row with its values in "line"
+    const PyRep* id = NULL;
+    if( row->IsList() )
+        id = row->AsList()->GetItem( 0 );
+    else if( row->IsObject() && row->AsObject()->arguments()->IsDict() )
+    {
+        const PyRep* line = row->AsObject()->arguments()->AsDict()->GetItemString( "line" );
+        if( NULL != line && line->IsList() && 0 < line->AsList()->size() )
+            id = line->AsList()->GetItem( 0 );
+    }
+
+    if( NULL == id )
+        return 0;
+    else if( id->IsInt() )
+        return id->AsInt()->value();
+    else if( id->IsLong() )
+        return static_cast< uint32 >( id->AsLong()->value() );
+
+    return 0;
+}
@@ -0,0 +1,191 @@
+/*
+    ------------------------------------------------------------------------------------
+    LICENSE:
+    ------------------------------------------------------------------------------------
+    This file is part of EVEmu: EVE Online Server Emulator
+    Copyright 2006 - 2011 The EVEmu Team
+    For the latest information visit http://evemu.org
+    ------------------------------------------------------------------------------------
+    This program is free software; you can redistribute it and/or modify it under
+    the terms of the GNU Lesser General Public License as published by the Free Software
+    Foundation; either version 2 of the License, or (at your option) any later
+    version.
+
+    This program is distributed in the hope that it will be useful, but WITHOUT
+    ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+    FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public License along with
+    this program; if not, write to the Free Software Foundation, Inc., 59 Temple
+    Place - Suite 330, Boston, MA 02111-1307, USA, or go to
+    http://www.gnu.org/copyleft/lesser.txt.
+    ------------------------------------------------------------------------------------
+    Author:     EVEmu Team
+*/
+
+
+#include "eve-server.h"
+
+#include "config/ConfigDB.h"
+#include "config/TextStore.h"
+
+/// Upper case copy of a languageID; languageIDs were always compared without case.
+static std::string NormalizeLanguageID( const std::string& languageID )
+{
+    std::string result( languageID );
+    for( size_t i = 0; i < result.size(); ++i )
+        result[ i ] = toupper( result[ i ] );
+
+    return result;
+}
+
+TextStore::TextStore()
+: mLanguages( NULL )
+{
+}
+
+TextStore::~TextStore()
+{
+    PySafeDecRef( mLanguages );
+
+    std::tr1::unordered_map< uint64, Group >::iterator cur, end;
+    cur = mGroups.begin();
+    end = mGroups.end();
+    for(; cur != end; cur++ )
+        PySafeDecRef( cur->second.objectID );
+}
+
+bool TextStore::Load()
+{
+    ConfigDB db;
+    PyRep* languages = db.ListLanguages();
+    if( NULL == languages )
+        return false;
+
+    languages->Freeze();
+    PySafeDecRef( mLanguages );
+    mLanguages = languages;
+
+    DBQueryResult res;
+    if( !sDatabase.RunQuery( res,
+        "SELECT langID, textgroup, textLabel, `text`"
+        " FROM intro"
+        " ORDER BY langID, textgroup" ) )
+    {
+        codelog( SERVICE__ERROR, "Error in query: %s", res.error.c_str() );
+        return false;
+    }
+
+    // only needed while loading
+    std::tr1::unordered_map< std::string, uint32 > index;
+
+    DBResultRow row;
+    while( res.GetRow( row ) )
+    {
+        const std::string languageID = NormalizeLanguageID( row.GetText( 0 ) );
+        const uint32 textgroup = row.GetUInt( 1 );
+
+        if( mLanguageIDs.end() == std::find( mLanguageIDs.begin(), mLanguageIDs.end(), languageID ) )
+            mLanguageIDs.push_back( languageID );
+
+        Group& group = mGroups[ _GroupKey( languageID, textgroup ) ];
+        if( group.texts.empty() )
+        {
+            // the cache service knows the group by this
+            PyTuple* objectID = new PyTuple( 3 );
+            objectID->SetItem( 0, new PyString( "languageSvc.GetTextsForGroup" ) );
+            objectID->SetItem( 1, new PyString( languageID ) );
+            objectID->SetItem( 2, new PyInt( textgroup ) );
+            objectID->Freeze();
+
+            group.objectID = objectID;
+        }
+
+        group.texts.push_back( std::make_pair( _Intern( std::string( row.GetText( 2 ), row.ColumnLength( 2 ) ), index ),
+                                               _Intern( std::string( row.GetText( 3 ), row.ColumnLength( 3 ) ), index ) ) );
+    }
+
+    return true;
+}
+
+PyRep* TextStore::GetLanguages()
+{
+    if( NULL == mLanguages )
+        return NULL;
+
+    PyIncRef( mLanguages );
+    return mLanguages;
+}
+
+const PyRep* TextStore::GetGroupObjectID( const std::string& languageID, uint32 textgroup )
+{
+    ++mStats.calls;
+
+    std::tr1::unordered_map< uint64, Group >::const_iterator res = mGroups.find( _GroupKey( NormalizeLanguageID( languageID ), textgroup ) );
+    if( mGroups.end() == res )
+    {
+        ++mStats.unknown;
+        return NULL;
+    }
+
+    return res->second.objectID;
+}
+
+PyObject* TextStore::BuildGroup( const std::string& languageID, uint32 textgroup )
+{
+    PyDict* args = new PyDict;
+
+    PyList* header = new PyList( 2 );
+    header->SetItem( 0, new PyString( "textLabel" ) );
+    header->SetItem( 1, new PyString( "text" ) );
+    args->SetItemString( "header", header );
+    args->SetItemString( "RowClass", new PyToken( "util.Row" ) );
+
+    PyList* lines = new PyList;
+    args->SetItemString( "lines", lines );
+
+    std::tr1::unordered_map< uint64, Group >::const_iterator res = mGroups.find( _GroupKey( NormalizeLanguageID( languageID ), textgroup ) );
+    if( mGroups.end() != res )
+    {
+        std::vector< std::pair< uint32, uint32 > >::const_iterator cur, end;
+        cur = res->second.texts.begin();
+        end = res->second.texts.end();
+        for(; cur != end; cur++ )
+        {
+            const std::pair< uint32, uint32 >& label = mStrings[ cur->first ];
+            const std::pair< uint32, uint32 >& text = mStrings[ cur->second ];
+
+            PyList* line = new PyList( 2 );
+            line->SetItem( 0, new PyWString( mChars.data() + label.first, label.second ) );
+            line->SetItem( 1, new PyWString( mChars.data() + text.first, text.second ) );
+            lines->AddItem( line );
+        }
+
+        ++mStats.built;
+    }
+
+    return new PyObject( "util.Rowset", args );
+}
+
+uint64 TextStore::_GroupKey( const std::string& languageID, uint32 textgroup ) const
+{
+    std::vector< std::string >::const_iterator res = std::find( mLanguageIDs.begin(), mLanguageIDs.end(), languageID );
+    if( mLanguageIDs.end() == res )
+        return 0;
+
+    return ( (uint64)( res - mLanguageIDs.begin() + 1 ) << 32 ) | textgroup;
+}
+
+uint32 TextStore::_Intern( const std::string& str, std::tr1::unordered_map< std::string, uint32 >& index )
+{
+    std::tr1::unordered_map< std::string, uint32 >::const_iterator res = index.find( str );
+    if( index.end() != res )
+        return res->second;
+
+    const uint32 id = mStrings.size();
+    mStrings.push_back( std::make_pair( (uint32)mChars.size(), (uint32)str.size() ) );
+    mChars.append( str );
+
+    index.insert( std::make_pair( str, id ) );
+    return id;
+}
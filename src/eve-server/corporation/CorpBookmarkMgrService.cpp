@@ -48,7 +48,8 @@ CorpBookmarkMgrService::~CorpBookmarkMgrService()
 
 PyResult CorpBookmarkMgrService::Handle_GetBookmarks(PyCallArgs& call)
 {
-    ObjectCachedMethodID method_id(GetName(), "GetBookmarks");
+    //every corporation has its own bookmarks
+    ObjectCachedSessionMethodID method_id(GetName(), "GetBookmarks", call.client->GetCorporationID());
     if(!m_manager->cache_service->IsCacheLoaded(method_id)) {
         PyDict *res = m_db.GetBookmarks(call.client->GetCorporationID());
         if(res == NULL)
@@ -64,5 +65,5 @@ PyResult CorpBookmarkMgrService::Handle_GetBookmarks(PyCallArgs& call)
         m_manager->cache_service->GiveCache(method_id, &result);
     }
 
-    return(m_manager->cache_service->MakeObjectCachedMethodCallResult(method_id));
+    return(m_manager->cache_service->MakeObjectCachedSessionMethodCallResult(method_id, "corpID"));
 }
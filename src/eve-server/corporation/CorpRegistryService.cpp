@@ -30,7 +30,10 @@
 #include "PyServiceCD.h"
 #include "cache/ObjCacheService.h"
 #include "chat/LSCService.h"
+#include "chat/NameIndex.h"
+#include "config/OwnerDirectory.h"
 #include "corporation/CorpRegistryService.h"
+#include "corporation/CorpRoster.h"
 
 class CorpRegistryBound
 : public PyBoundObject
@@ -68,9 +71,10 @@ public:
         PyCallable_REG_CALL(CorpRegistryBound, UpdateCorporation)
         PyCallable_REG_CALL(CorpRegistryBound, UpdateLogo)
 
-        // STUBBS
         PyCallable_REG_CALL(CorpRegistryBound, GetMember)
         PyCallable_REG_CALL(CorpRegistryBound, GetMembers)
+
+        // STUBBS
         PyCallable_REG_CALL(CorpRegistryBound, GetSharesByShareholder)
 
 
@@ -87,7 +91,6 @@ public:
     PyCallable_DECL_CALL(GetInfoWindowDataForChar)
     PyCallable_DECL_CALL(GetLockedItemLocations)
     PyCallable_DECL_CALL(AddCorporation)
-    //PyCallable_DECL_CALL(GetMember)
     PyCallable_DECL_CALL(GetSuggestedTickerNames)
     PyCallable_DECL_CALL(GetOffices)
     PyCallable_DECL_CALL(GetStations)
@@ -101,9 +104,10 @@ public:
     PyCallable_DECL_CALL(UpdateCorporation)
     PyCallable_DECL_CALL(UpdateLogo)
 
-    // STUBBS
     PyCallable_DECL_CALL(GetMember)
     PyCallable_DECL_CALL(GetMembers)
+
+    // STUBBS
     PyCallable_DECL_CALL(GetSharesByShareholder)
 
 
@@ -124,10 +128,10 @@ public:
     // or CorpRegistryBound?
     PyCallable_Make_Dispatcher(SparseCorpOfficeListBound)
 
-    SparseCorpOfficeListBound(PyServiceMgr *mgr, CorporationDB& db)
+    SparseCorpOfficeListBound(PyServiceMgr *mgr, uint32 corpID)
     : PyBoundObject(mgr),
       m_dispatch(new Dispatcher(this)),
-      m_db(db)
+      m_corpID(corpID)
     {
         _SetCallDispatcher(m_dispatch);
 
@@ -148,7 +152,40 @@ public:
 protected:
     Dispatcher *const m_dispatch;
 
-    CorporationDB& m_db;
+    const uint32 m_corpID;
+};
+
+class SparseCorpMemberListBound
+: public PyBoundObject
+{
+public:
+    PyCallable_Make_Dispatcher(SparseCorpMemberListBound)
+
+    SparseCorpMemberListBound(PyServiceMgr *mgr, uint32 corpID)
+    : PyBoundObject(mgr),
+      m_dispatch(new Dispatcher(this)),
+      m_corpID(corpID)
+    {
+        _SetCallDispatcher(m_dispatch);
+
+        PyCallable_REG_CALL(SparseCorpMemberListBound, Fetch)
+        PyCallable_REG_CALL(SparseCorpMemberListBound, FetchByKey)
+        PyCallable_REG_CALL(SparseCorpMemberListBound, GetByKey)
+    }
+    virtual ~SparseCorpMemberListBound() {delete m_dispatch;}
+    virtual void Release() {
+        delete this;
+    }
+
+    PyCallable_DECL_CALL(Fetch) //(startPos, fetchSize)
+    PyCallable_DECL_CALL(FetchByKey) //([keys])
+    PyCallable_DECL_CALL(GetByKey) //(key)
+
+
+protected:
+    Dispatcher *const m_dispatch;
+
+    const uint32 m_corpID;
 };
 
 PyCallable_Make_InnerDispatcher(CorpRegistryService)
@@ -185,7 +222,7 @@ PyResult CorpRegistryBound::Handle_GetInfoWindowDataForChar( PyCallArgs& call )
 {
     //takes characterID
 
-    sLog.Debug( "CorpRegistryBound", "Called GetInfoWindowDataForChar stub." );
+    _debug( "CorpRegistryBound", "Called GetInfoWindowDataForChar stub." );
 
     return new PyNone;
 }
@@ -194,7 +231,7 @@ PyResult CorpRegistryBound::Handle_GetLockedItemLocations( PyCallArgs& call )
 {
     //takes characterID
 
-    sLog.Debug( "CorpRegistryBound", "Called GetLockedItemLocations stub." );
+    _debug( "CorpRegistryBound", "Called GetLockedItemLocations stub." );
 
     //this returns an empty list for me on live.
     return new PyList;
@@ -236,6 +273,12 @@ PyResult CorpRegistryBound::Handle_AddCorporation(PyCallArgs &call) {
         codelog(SERVICE__ERROR, "New corporation creation failed...");
         return (new PyInt(0));
     }
+    //the corporationType AddCorporation gives player corporations
+    sNameIndex.Add(NameIndex::NAME_CORPORATION, corpID, args.corpName, 2);
+    sNameIndex.Add(NameIndex::NAME_CORPORATION_TICKER, corpID, args.corpTicker, 0, args.corpName);
+    //a client may have asked for it before
+    sOwnerDirectory.Invalidate(corpID);
+
     //adding a corporation might affect eveStaticOwners, so we gotta invalidate the cache...
     PyString* cache_name = new PyString( "config.StaticOwners" );
     m_manager->cache_service->InvalidateCache( cache_name );
@@ -319,12 +362,18 @@ bool CorpRegistryBound::JoinCorporation(Client *who, uint32 newCorpID, const Cor
     return true;
 }
 
-/* this is a stubb */
 PyResult CorpRegistryBound::Handle_GetMember(PyCallArgs &call) {
-//    uint32 item = 0;
-    //item += 1;
-    sLog.Debug( "CorpRegistryBound", "Called GetMember stub." );
-    return NULL;
+    Call_SingleIntegerArg arg;
+    if (!arg.Decode(&call.tuple)) {
+        codelog(SERVICE__ERROR, "%s: Bad arguments", call.client->GetName());
+        return NULL;
+    }
+
+    PyObject *member = sCorpRoster.GetMember(call.client->GetCorporationID(), arg.arg);
+    if (member == NULL)
+        return new PyNone;
+
+    return member;
 }
 
 /*
@@ -385,9 +434,18 @@ PyClass
         dict["N=707075:302"]=0x1CC2383E961BFA8
 */
 PyResult CorpRegistryBound::Handle_GetMembers(PyCallArgs &call) {
+    const uint32 corpID = call.client->GetCorporationID();
 
-    sLog.Debug( "CorpRegistryBound", "Called GetMembers stub." );
-    return NULL;
+    // Only the number of members goes out now, the client fetches the rows through the bound list
+    CorpMemberSparseRowset ret;
+    ret.memberNumber = sCorpRoster.GetMemberCount(corpID);
+
+    PyDict *dict = new PyDict();
+    dict->SetItemString("realRowCount", new PyInt(ret.memberNumber));
+
+    ret.bindedObject = m_manager->BindObject(call.client, new SparseCorpMemberListBound(m_manager, corpID), &dict);
+
+    return ret.Encode();
 }
 
 PyResult CorpRegistryBound::Handle_GetSuggestedTickerNames(PyCallArgs &call) {
@@ -426,7 +484,7 @@ PyResult CorpRegistryBound::Handle_GetOffices(PyCallArgs &call) {
     // First create the boundable object
 
     PyBoundObject *bObj;
-    bObj = new SparseCorpOfficeListBound(m_manager, m_db);
+    bObj = new SparseCorpOfficeListBound(m_manager, call.client->GetCorporationID());
     if(bObj == NULL) {
         _log(SERVICE__ERROR, "%s: Unable to create bound object for:", call.client->GetName());
         return NULL;
@@ -439,7 +497,7 @@ PyResult CorpRegistryBound::Handle_GetOffices(PyCallArgs &call) {
 
     // First time we only need the number of rows, not the data itself
     // Data will be fetched from the SparseRowset
-    uint32 officeN = m_db.GetOffices(call.client->GetCorporationID());
+    uint32 officeN = sCorpRoster.GetOfficeCount(call.client->GetCorporationID());
 
     // No idea what this is
     dict->SetItemString("realRowCount", new PyInt(officeN));
@@ -461,7 +519,41 @@ PyResult SparseCorpOfficeListBound::Handle_Fetch(PyCallArgs &call) {
         return NULL;
     }
 
-    return m_db.Fetch(call.client->GetCorporationID(), args.arg1, args.arg2);
+    return sCorpRoster.FetchOffices(m_corpID, args.arg1, args.arg2);
+}
+
+PyResult SparseCorpMemberListBound::Handle_Fetch(PyCallArgs &call) {
+    Call_TwoIntegerArgs args;
+    if (!args.Decode(&call.tuple)) {
+        codelog(SERVICE__ERROR, "%s: Bad arguments", call.client->GetName());
+        return NULL;
+    }
+
+    return sCorpRoster.FetchMembers(m_corpID, args.arg1, args.arg2);
+}
+
+PyResult SparseCorpMemberListBound::Handle_FetchByKey(PyCallArgs &call) {
+    Call_SingleIntList args;
+    if (!args.Decode(&call.tuple)) {
+        codelog(SERVICE__ERROR, "%s: Bad arguments", call.client->GetName());
+        return NULL;
+    }
+
+    return sCorpRoster.FetchMembersByKey(m_corpID, args.ints);
+}
+
+PyResult SparseCorpMemberListBound::Handle_GetByKey(PyCallArgs &call) {
+    Call_SingleIntegerArg arg;
+    if (!arg.Decode(&call.tuple)) {
+        codelog(SERVICE__ERROR, "%s: Bad arguments", call.client->GetName());
+        return NULL;
+    }
+
+    PyObject *member = sCorpRoster.GetMember(m_corpID, arg.arg);
+    if (member == NULL)
+        return new PyNone;
+
+    return member;
 }
 
 PyResult CorpRegistryBound::Handle_GetMyApplications(PyCallArgs &call) {
@@ -0,0 +1,426 @@
+/*
+    ------------------------------------------------------------------------------------
+    LICENSE:
+    ------------------------------------------------------------------------------------
+    This file is part of EVEmu: EVE Online Server Emulator
+    Copyright 2006 - 2011 The EVEmu Team
+    For the latest information visit http://evemu.org
+    ------------------------------------------------------------------------------------
+    This program is free software; you can redistribute it and/or modify it under
+    the terms of the GNU Lesser General Public License as published by the Free Software
+    Foundation; either version 2 of the License, or (at your option) any later
+    version.
+
+    This program is distributed in the hope that it will be useful, but WITHOUT
+    ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+    FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public License along with
+    this program; if not, write to the Free Software Foundation, Inc., 59 Temple
+    Place - Suite 330, Boston, MA 02111-1307, USA, or go to
+    http://www.gnu.org/copyleft/lesser.txt.
+    ------------------------------------------------------------------------------------
+    Author:     EVEmu Team
+*/
+
+
+#include "eve-server.h"
+
+#include "character/Character.h"
+#include "corporation/CorporationCarrier.h"
+#include "corporation/CorpRoster.h"
+
+CorpRoster::CorpRoster()
+{
+}
+
+uint32 CorpRoster::GetMemberCount( uint32 corporationID )
+{
+    Roster* roster = _Get( corporationID );
+    if( roster == NULL )
+        return 0;
+
+    return roster->members.size();
+}
+
+PyList* CorpRoster::FetchMembers( uint32 corporationID, uint32 startPos, uint32 fetchSize )
+{
+    Roster* roster = _Get( corporationID );
+    if( roster == NULL )
+        return NULL;
+
+    PyList* result = new PyList;
+    for( size_t i = startPos; i < roster->members.size() && i - startPos < fetchSize; ++i )
+    {
+        const Member& member = roster->members[ i ];
+        result->AddItem( new_tuple( new PyInt( member.characterID ), _EncodeMember( corporationID, member ) ) );
+    }
+
+    ++mStats.fetches;
+    mStats.rows += result->size();
+    return result;
+}
+
+PyList* CorpRoster::FetchMembersByKey( uint32 corporationID, const std::vector<int32>& keys )
+{
+    Roster* roster = _Get( corporationID );
+    if( roster == NULL )
+        return NULL;
+
+    PyList* result = new PyList;
+    std::vector<int32>::const_iterator cur, end;
+    cur = keys.begin();
+    end = keys.end();
+    for(; cur != end; ++cur )
+    {
+        const Member* member = _FindMember( *roster, *cur );
+        if( member != NULL )
+            result->AddItem( new_tuple( new PyInt( member->characterID ), _EncodeMember( corporationID, *member ) ) );
+    }
+
+    ++mStats.fetches;
+    mStats.rows += result->size();
+    return result;
+}
+
+PyObject* CorpRoster::GetMember( uint32 corporationID, uint32 characterID )
+{
+    Roster* roster = _Get( corporationID );
+    if( roster == NULL )
+        return NULL;
+
+    const Member* member = _FindMember( *roster, characterID );
+    if( member == NULL )
+        return NULL;
+
+    util_Row row;
+    row.header.push_back( "characterID" );
+    row.header.push_back( "corporationID" );
+    row.header.push_back( "divisionID" );
+    row.header.push_back( "squadronID" );
+    row.header.push_back( "title" );
+    row.header.push_back( "roles" );
+    row.header.push_back( "grantableRoles" );
+    row.header.push_back( "startDateTime" );
+    row.header.push_back( "baseID" );
+    row.header.push_back( "rolesAtHQ" );
+    row.header.push_back( "grantableRolesAtHQ" );
+    row.header.push_back( "rolesAtBase" );
+    row.header.push_back( "grantableRolesAtBase" );
+    row.header.push_back( "rolesAtOther" );
+    row.header.push_back( "grantableRolesAtOther" );
+    row.header.push_back( "titleMask" );
+    row.header.push_back( "accountKey" );
+    row.header.push_back( "rowDate" );
+    row.header.push_back( "blockRoles" );
+    row.line = _EncodeMember( corporationID, *member );
+
+    ++mStats.fetches;
+    ++mStats.rows;
+    return row.Encode();
+}
+
+uint32 CorpRoster::GetOfficeCount( uint32 corporationID )
+{
+    Roster* roster = _Get( corporationID );
+    if( roster == NULL )
+        return 0;
+
+    return roster->offices.size();
+}
+
+PyList* CorpRoster::FetchOffices( uint32 corporationID, uint32 startPos, uint32 fetchSize )
+{
+    Roster* roster = _Get( corporationID );
+    if( roster == NULL )
+        return NULL;
+
+    PyList* result = new PyList;
+    for( size_t i = startPos; i < roster->offices.size() && i - startPos < fetchSize; ++i )
+    {
+        const Office& office = roster->offices[ i ];
+
+        PyList* params = new PyList;
+        params->AddItemInt( office.stationID );
+        params->AddItemInt( office.typeID );
+        params->AddItemInt( office.officeID );
+        params->AddItemInt( office.officeFolderID );
+
+        result->AddItem( new_tuple( new PyInt( office.officeID ), params ) );
+    }
+
+    ++mStats.fetches;
+    mStats.rows += result->size();
+    return result;
+}
+
+void CorpRoster::AddMember( uint32 characterID, uint32 corporationID, const std::string& title, uint64 startDateTime, const CorpMemberInfo& roles )
+{
+    Roster* roster = _Find( corporationID );
+    if( roster == NULL )
+        return;
+
+    Member member;
+    member.characterID = characterID;
+    member.title = title;
+    member.startDateTime = startDateTime;
+    _SetRoles( member, roles );
+
+    roster->members.insert( std::lower_bound( roster->members.begin(), roster->members.end(), member ), member );
+    mMemberCorps[ characterID ] = corporationID;
+    ++mStats.updates;
+}
+
+void CorpRoster::MoveMember( uint32 characterID, uint32 oldCorporationID, uint32 corporationID, uint64 startDateTime, const CorpMemberInfo& roles )
+{
+    Member member;
+    bool known = false;
+
+    Roster* old = _Find( oldCorporationID );
+    if( old != NULL )
+    {
+        Member* m = _FindMember( *old, characterID );
+        if( m != NULL )
+        {
+            member = *m;
+            known = true;
+
+            old->members.erase( old->members.begin() + ( m - &old->members[ 0 ] ) );
+            mMemberCorps.erase( characterID );
+            ++mStats.updates;
+        }
+    }
+
+    if( _Find( corporationID ) == NULL )
+        return;
+
+    if( !known )
+    {
+        // the title is not resident; load the roster again when it is used
+        _Drop( corporationID );
+        return;
+    }
+
+    AddMember( characterID, corporationID, member.title, startDateTime, roles );
+}
+
+void CorpRoster::UpdateRoles( uint32 characterID, const CorpMemberInfo& roles )
+{
+    std::tr1::unordered_map< uint32, uint32 >::const_iterator res = mMemberCorps.find( characterID );
+    if( res == mMemberCorps.end() )
+        return;
+
+    Roster* roster = _Find( res->second );
+    if( roster == NULL )
+        return;
+
+    Member* member = _FindMember( *roster, characterID );
+    if( member == NULL )
+        return;
+
+    // every save of a character writes its roles; only the changes count
+    if( member->roles == roles.corpRole
+        && member->rolesAtHQ == roles.rolesAtHQ
+        && member->rolesAtBase == roles.rolesAtBase
+        && member->rolesAtOther == roles.rolesAtOther )
+        return;
+
+    _SetRoles( *member, roles );
+    ++mStats.updates;
+}
+
+void CorpRoster::RemoveMember( uint32 characterID )
+{
+    std::tr1::unordered_map< uint32, uint32 >::iterator res = mMemberCorps.find( characterID );
+    if( res == mMemberCorps.end() )
+        return;
+
+    Roster* roster = _Find( res->second );
+    mMemberCorps.erase( res );
+    if( roster == NULL )
+        return;
+
+    Member* member = _FindMember( *roster, characterID );
+    if( member == NULL )
+        return;
+
+    roster->members.erase( roster->members.begin() + ( member - &roster->members[ 0 ] ) );
+    ++mStats.updates;
+}
+
+void CorpRoster::AddOffice( const OfficeInfo& office )
+{
+    Roster* roster = _Find( office.corporationID );
+    if( roster == NULL )
+        return;
+
+    Office o;
+    o.officeID = office.officeID;
+    o.stationID = office.stationID;
+    o.typeID = office.typeID;
+    o.officeFolderID = office.officeFolderID;
+
+    roster->offices.push_back( o );
+    ++mStats.updates;
+}
+
+CorpRoster::Roster* CorpRoster::_Get( uint32 corporationID )
+{
+    Roster* roster = _Find( corporationID );
+    if( roster != NULL )
+    {
+        mRecent.splice( mRecent.begin(), mRecent, roster->recent );
+        ++mStats.hits;
+        return roster;
+    }
+
+    if( mRosters.size() >= MAX_ROSTERS )
+    {
+        _Drop( mRecent.back() );
+        ++mStats.evictions;
+    }
+
+    Roster& into = mRosters[ corporationID ];
+    mRecent.push_front( corporationID );
+    into.recent = mRecent.begin();
+
+    if( !_Load( corporationID, into ) )
+    {
+        _Drop( corporationID );
+        return NULL;
+    }
+
+    ++mStats.loads;
+    return &into;
+}
+
+CorpRoster::Roster* CorpRoster::_Find( uint32 corporationID )
+{
+    std::map< uint32, Roster >::iterator res = mRosters.find( corporationID );
+    if( res == mRosters.end() )
+        return NULL;
+
+    return &res->second;
+}
+
+bool CorpRoster::_Load( uint32 corporationID, Roster& into )
+{
+    DBQueryResult res;
+    DBResultRow row;
+
+    if( !sDatabase.RunQuery( res,
+        "SELECT characterID, title, corporationDateTime, corpRole, rolesAtHQ, rolesAtBase, rolesAtOther"
+        " FROM character_"
+        " WHERE corporationID = %u"
+        " ORDER BY characterID",
+        corporationID ) )
+    {
+        codelog( SERVICE__ERROR, "Error in query: %s", res.error.c_str() );
+        return false;
+    }
+
+    into.members.reserve( res.GetRowCount() );
+    while( res.GetRow( row ) )
+    {
+        Member member;
+        member.characterID = row.GetUInt( 0 );
+        member.title = row.GetText( 1 );
+        member.startDateTime = row.GetUInt64( 2 );
+        member.roles = row.GetUInt64( 3 );
+        member.rolesAtHQ = row.GetUInt64( 4 );
+        member.rolesAtBase = row.GetUInt64( 5 );
+        member.rolesAtOther = row.GetUInt64( 6 );
+        member.rowDate = member.startDateTime;
+
+        into.members.push_back( member );
+        mMemberCorps[ member.characterID ] = corporationID;
+    }
+
+    if( !sDatabase.RunQuery( res,
+        "SELECT itemID, stationID, typeID, officeFolderID"
+        " FROM crpOffices"
+        " WHERE corporationID = %u"
+        " ORDER BY itemID",
+        corporationID ) )
+    {
+        codelog( SERVICE__ERROR, "Error in query: %s", res.error.c_str() );
+        return false;
+    }
+
+    while( res.GetRow( row ) )
+    {
+        Office office;
+        office.officeID = row.GetUInt( 0 );
+        office.stationID = row.GetUInt( 1 );
+        office.typeID = row.GetUInt( 2 );
+        office.officeFolderID = row.GetUInt( 3 );
+
+        into.offices.push_back( office );
+    }
+
+    return true;
+}
+
+void CorpRoster::_Drop( uint32 corporationID )
+{
+    std::map< uint32, Roster >::iterator res = mRosters.find( corporationID );
+    if( res == mRosters.end() )
+        return;
+
+    std::vector< Member >::const_iterator cur, end;
+    cur = res->second.members.begin();
+    end = res->second.members.end();
+    for(; cur != end; ++cur )
+        mMemberCorps.erase( cur->characterID );
+
+    mRecent.erase( res->second.recent );
+    mRosters.erase( res );
+}
+
+CorpRoster::Member* CorpRoster::_FindMember( Roster& roster, uint32 characterID )
+{
+    Member key;
+    key.characterID = characterID;
+
+    std::vector< Member >::iterator res = std::lower_bound( roster.members.begin(), roster.members.end(), key );
+    if( res == roster.members.end() || res->characterID != characterID )
+        return NULL;
+
+    return &*res;
+}
+
+void CorpRoster::_SetRoles( Member& member, const CorpMemberInfo& roles )
+{
+    member.roles = roles.corpRole;
+    member.rolesAtHQ = roles.rolesAtHQ;
+    member.rolesAtBase = roles.rolesAtBase;
+    member.rolesAtOther = roles.rolesAtOther;
+    member.rowDate = Win32TimeNow();
+}
+
+PyList* CorpRoster::_EncodeMember( uint32 corporationID, const Member& member ) const
+{
+    // grantable roles, divisions, squadrons, bases and titles are not stored yet
+    PyList* line = new PyList;
+    line->AddItem( new PyInt( member.characterID ) );
+    line->AddItem( new PyInt( corporationID ) );
+    line->AddItem( new PyNone );
+    line->AddItem( new PyNone );
+    line->AddItem( new PyString( member.title ) );
+    line->AddItem( new PyLong( member.roles ) );
+    line->AddItem( new PyLong( 0 ) );
+    line->AddItem( new PyLong( member.startDateTime ) );
+    line->AddItem( new PyNone );
+    line->AddItem( new PyLong( member.rolesAtHQ ) );
+    line->AddItem( new PyLong( 0 ) );
+    line->AddItem( new PyLong( member.rolesAtBase ) );
+    line->AddItem( new PyLong( 0 ) );
+    line->AddItem( new PyLong( member.rolesAtOther ) );
+    line->AddItem( new PyLong( 0 ) );
+    line->AddItem( new PyInt( 0 ) );
+    line->AddItem( new PyNone );
+    line->AddItem( new PyLong( member.rowDate ) );
+    line->AddItem( new PyNone );
+
+    return line;
+}
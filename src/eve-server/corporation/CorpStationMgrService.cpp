@@ -217,7 +217,7 @@ PyResult CorpStationMgrIMBound::Handle_SetHomeStation(PyCallArgs &call) {
     //this takes an integer: stationID
     //price is prompted for on the client side.
 
-    sLog.Debug( "CorpStationMgrIMBound", "Called SetHomeStation stub." );
+    _debug( "CorpStationMgrIMBound", "Called SetHomeStation stub." );
 
     return new PyNone;
 }
@@ -229,7 +229,7 @@ PyResult CorpStationMgrIMBound::Handle_SetCloneTypeID(PyCallArgs &call) {
 
     Call_SetCloneTypeID arg;
     if(!arg.Decode(&call.tuple)){
-        sLog.Debug("CoporationMgrIMBound","Failed to determine Clone Type");
+        _debug("CoporationMgrIMBound","Failed to determine Clone Type");
     }
 
     //Get cost of clone
@@ -573,7 +573,7 @@ PyResult CorpStationMgrIMBound::Handle_GetStationOffices( PyCallArgs& call )
 {
     //Hack: Just passing the client an empty PyList to stop it throwing an exception.
     //TODO: Fid out what needs to be in the PyList and when to send it.
-    sLog.Debug( "CorpStationMgrIMBound", "Called GetStationOffices stub." );
+    _debug( "CorpStationMgrIMBound", "Called GetStationOffices stub." );
     /*
     [PySubStream 99 bytes]
         [PyObjectData Name: objectCaching.CachedMethodCallResult]
@@ -615,7 +615,7 @@ PyResult CorpStationMgrIMBound::Handle_GetNumberOfUnrentedOffices( PyCallArgs &c
 
 PyResult CorpStationMgrIMBound::Handle_GetCorporateStationOffice(PyCallArgs &call)
 {
-    sLog.Debug("Server","Called GetCorporateStationOffice Stub");
+    _debug("Server","Called GetCorporateStationOffice Stub");
 
     return new PyTuple(0);
 }
@@ -26,7 +26,9 @@
 #include "eve-server.h"
 
 #include "character/Character.h"
+#include "corporation/CorporationCarrier.h"
 #include "corporation/CorporationDB.h"
+#include "corporation/CorpRoster.h"
 
 PyObject *CorporationDB::ListCorpStations(uint32 corp_id) {
     DBQueryResult res;
@@ -304,7 +306,7 @@ PyObject *CorporationDB::GetEmploymentRecord(uint32 charID) {
 
 PyObject* CorporationDB::GetMedalsReceived( uint32 charID )
 {
-    sLog.Debug( "CorporationDB", "Called GetMedalsReceived stub." );
+    _debug( "CorporationDB", "Called GetMedalsReceived stub." );
 
     util_Rowset rs;
 
@@ -552,12 +554,13 @@ bool CorporationDB::JoinCorporation(uint32 charID, uint32 corpID, uint32 oldCorp
     }
 
     // Set new corp
+    const uint64 startDateTime = Win32TimeNow();
     if (!sDatabase.RunQuery(err,
         "UPDATE character_ SET "
         "   corporationID = %u, corporationDateTime = %" PRIu64 ", "
         "   corpRole = %" PRIu64 ", rolesAtAll = %" PRIu64 ", rolesAtBase = %" PRIu64 ", rolesAtHQ = %" PRIu64 ", rolesAtOther = %" PRIu64 " "
         "   WHERE characterID = %u",
-            corpID, Win32TimeNow(),
+            corpID, startDateTime,
             roles.corpRole, roles.rolesAtAll, roles.rolesAtBase, roles.rolesAtHQ, roles.rolesAtOther,
             charID
         ))
@@ -567,6 +570,8 @@ bool CorporationDB::JoinCorporation(uint32 charID, uint32 corpID, uint32 oldCorp
         return false;
     }
 
+    sCorpRoster.MoveMember(charID, oldCorpID, corpID, startDateTime, roles);
+
     // Increase new corp's member number...
     if (!sDatabase.RunQuery(err,
         "UPDATE corporation "
@@ -769,58 +774,6 @@ PyObject *CorporationDB::GetStations(uint32 corpID) {
     return DBResultToRowset(res);
 }
 
-uint32 CorporationDB::GetOffices(uint32 corpID) {
-    DBQueryResult res;
-
-    if (!sDatabase.RunQuery(res,
-        " SELECT "
-        " COUNT(1) AS OfficeNumber "
-        " FROM crpOffices "
-        " WHERE corporationID = %u ", corpID
-        ))
-    {
-        codelog(SERVICE__ERROR, "Error in query: %s", res.error.c_str());
-        return(0);
-    }
-
-    DBResultRow row;
-    if (!res.GetRow(row)) {
-        codelog(SERVICE__ERROR, "Unable to find corporation's data (%u)", corpID);
-        return 0;
-    }
-    return row.GetUInt(0);
-}
-
-PyRep *CorporationDB::Fetch(uint32 corpID, uint32 from, uint32 count) {
-    DBQueryResult res;
-    DBResultRow rr;
-
-    if (!sDatabase.RunQuery(res,
-        " SELECT stationID, typeID, itemID, officeFolderID "
-        " FROM crpOffices "
-        " WHERE corporationID = %u "
-        " LIMIT %u, %u ", corpID, from, count
-        ))
-    {
-        codelog(SERVICE__ERROR, "Error in query: %s", res.error.c_str());
-        return NULL;
-    }
-
-    res.GetRow(rr);
-
-    // Have to send back a list that contains a tuple that contains an int and a list...
-    // params probably needs the following stuff: stationID, typeID, officeID, officeFolderID
-    Reply_FetchOffice reply;
-    reply.params = new PyList;
-
-    reply.params->AddItemInt( rr.GetInt(0) );
-    reply.params->AddItemInt( rr.GetInt(1) );
-    reply.officeID = rr.GetInt(2);
-    reply.params->AddItemInt( reply.officeID );
-    reply.params->AddItemInt( rr.GetInt(3) );
-
-    return reply.Encode();
-}
 uint32 CorporationDB::GetQuoteForRentingAnOffice(uint32 stationID) {
     DBQueryResult res;
     DBResultRow row;
@@ -884,7 +837,10 @@ uint32 CorporationDB::ReserveOffice(const OfficeInfo & oInfo) {
     }
 
     // If insert is successful, oInfo.officeID now contains the rented office's ID
-    // Nothing else to do...
+    OfficeInfo office(oInfo);
+    office.officeID = officeID;
+    sCorpRoster.AddOffice(office);
+
     return(officeID);
 }
 
@@ -1315,7 +1271,7 @@ bool CorporationDB::ChangeCloneType(uint32 characterID, uint32 typeID) {
         _log(DATABASE__ERROR, "Failed to change clone type of char %u: %s.", characterID, res.error.c_str());
         return false;
     }
-    sLog.Debug( "CorporationDB", "Clone upgrade successful" );
+    _debug( "CorporationDB", "Clone upgrade successful" );
     return true;
 }
 
@@ -121,7 +121,7 @@ PyResult CorporationService::Handle_GetFactionInfo(PyCallArgs &call) {
 
 PyResult CorporationService::Handle_GetCorpInfo(PyCallArgs &call) {
 
-    sLog.Debug("Server", "Called GetCorpInfo Stub.");
+    _debug("Server", "Called GetCorpInfo Stub.");
 
     return NULL;
 }
@@ -170,7 +170,7 @@ PyResult CorporationService::Handle_GetAllCorpMedals( PyCallArgs& call )
         return NULL;
     }
 
-    sLog.Debug( "CorporationService", "Called GetAllCorpMedals stub." );
+    _debug( "CorporationService", "Called GetAllCorpMedals stub." );
 
     PyList* res = new PyList;
 
@@ -201,7 +201,7 @@ PyResult CorporationService::Handle_GetRecruitmentAdTypes( PyCallArgs& call )
 {
     //no args
 
-    sLog.Debug( "CorporationService", "Called GetRecruitmentAdTypes stub." );
+    _debug( "CorporationService", "Called GetRecruitmentAdTypes stub." );
 
     util_Rowset rs;
 
@@ -228,7 +228,7 @@ PyResult CorporationService::Handle_GetRecruitmentAdsByCriteria( PyCallArgs& cal
         return NULL;
     }
 
-    sLog.Debug( "CorporationService", "Called GetRecruitmentAdsByCriteria stub." );
+    _debug( "CorporationService", "Called GetRecruitmentAdsByCriteria stub." );
 
     util_Rowset rs;
 
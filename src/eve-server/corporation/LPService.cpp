@@ -27,6 +27,7 @@
 
 #include "PyServiceCD.h"
 #include "corporation/LPService.h"
+#include "market/EconomyCache.h"
 
 PyCallable_Make_InnerDispatcher(LPService)
 
@@ -49,14 +50,14 @@ LPService::~LPService()
 
 PyResult LPService::Handle_GetLPExchangeRates( PyCallArgs& call )
 {
-    sLog.Debug( "LPService", "Called GetLPExchangeRates stub." );
+    _debug( "LPService", "Called GetLPExchangeRates stub." );
 
     return new PyList;
 }
 
 PyResult LPService::Handle_GetLPForCharacterCorp( PyCallArgs& call )
 {
-    sLog.Debug( "LPService", "Called GetLPForCharacterCorp stub." );
+    _debug( "LPService", "Called GetLPForCharacterCorp stub." );
 
     return new PyInt( 0 );
 }
@@ -65,17 +66,22 @@ PyResult LPService::Handle_GetLPsForCharacter( PyCallArgs& call )
 {
     //no args
 
-    sLog.Debug( "LPService", "Called GetLPsForCharacter stub." );
+    _debug( "LPService", "Called GetLPsForCharacter stub." );
 
     return new PyList;
 }
 
 PyResult LPService::Handle_GetAvailableOffersFromCorp( PyCallArgs& call )
 {
-
-    sLog.Debug( "LPService", "Called GetAvailableOffersFromCorp stub." );
-
-    return new PyList;
+    Call_SingleIntegerArg arg;
+    if( !arg.Decode( &call.tuple ) )
+    {
+        _log( SERVICE__ERROR, "%s: Failed to decode arguments.", call.client->GetName() );
+        return NULL;
+    }
+
+    //the offers are static, every caller gets the same list.
+    return sEconomyCache.GetOffers( arg.arg );
 }
 
 
@@ -29,6 +29,8 @@
 #include "PyServiceCD.h"
 #include "cache/ObjCacheService.h"
 #include "dogmaim/DogmaIMService.h"
+#include "ship/modules/ModuleType.h"
+#include "standing/HostilityResolver.h"
 #include "system/SystemManager.h"
 
 class DogmaIMBound
@@ -187,7 +189,7 @@ PyResult DogmaIMBound::Handle_CheckSendLocationInfo( PyCallArgs& call )
 {
     //no arguments
 
-    sLog.Debug( "DogmaIMBound", "Called CheckSendLocationInfo stub." );
+    _debug( "DogmaIMBound", "Called CheckSendLocationInfo stub." );
 
     return new PyNone;
 }
@@ -276,7 +278,21 @@ PyResult DogmaIMBound::Handle_Activate( PyCallArgs& call )
             return NULL;
         }
 
-        //TODO: make sure we are allowed to do this.
+        //offensive modules may only be used on pilots in high security space if they are hostile
+        if( args.target != 0 && atof( call.client->System()->GetSystemSecurity() ) >= 0.5 )
+        {
+            SystemEntity* target = call.client->System()->get( args.target );
+            if( target != NULL && target->IsClient() )
+            {
+                InventoryItemRef module = m_manager->item_factory.GetItem( args.itemID );
+                MEffect* effect = module ? sModuleTypeTable.GetModuleType( *module )->GetDefaultEffect() : NULL;
+
+                if( effect != NULL && effect->GetIsOffensive()
+                    && !sHostilityResolver.MayAttack( *call.client, *target->CastToClient() ) )
+                    throw PyException( MakeCustomError( "You may not attack %s in high security space.", target->GetName() ) );
+            }
+        }
+
         return new PyInt( call.client->GetShip()->Activate( args.itemID, args.effectName, args.target, args.repeat ) );
     }
 
@@ -372,7 +388,7 @@ PyResult DogmaIMBound::Handle_ClearTargets(PyCallArgs &call) {
 
 PyResult DogmaIMBound::Handle_GetWeaponBankInfoForShip( PyCallArgs& call )
 {
-    sLog.Debug( "DogmaIMBound", "Called GetWeaponBankInfoForShip stub." );
+    _debug( "DogmaIMBound", "Called GetWeaponBankInfoForShip stub." );
 
     return new PyDict;
 }
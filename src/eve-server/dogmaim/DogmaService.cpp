@@ -44,18 +44,30 @@ DogmaService::~DogmaService() {
     delete m_dispatch;
 }
 
-PyResult DogmaService::Handle_GetOperandsForChar(PyCallArgs &call)
-{
+void DogmaService::PrimeCache() {
     ObjectCachedMethodID method_id(GetName(), "GetOperandsForChar");
+    _CacheOperandsForChar(method_id);
+}
 
+bool DogmaService::_CacheOperandsForChar(const ObjectCachedMethodID &method_id) {
     if( !m_manager->cache_service->IsCacheLoaded( method_id ) )
     {
         PyRep* res = m_db.GetOperand();
         if( res == NULL )
-            return NULL;
+            return false;
 
         m_manager->cache_service->GiveCache( method_id, &res );
     }
 
+    return true;
+}
+
+PyResult DogmaService::Handle_GetOperandsForChar(PyCallArgs &call)
+{
+    ObjectCachedMethodID method_id(GetName(), "GetOperandsForChar");
+
+    if(!_CacheOperandsForChar(method_id))
+        return NULL;
+
     return m_manager->cache_service->MakeObjectCachedMethodCallResult( method_id );
 }
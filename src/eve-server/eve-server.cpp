@@ -27,20 +27,28 @@
 
 #include "EVEServerConfig.h"
 #include "NetService.h"
+
+#include "database/DBSnapshot.h"
+#include "database/StaticDataSnapshot.h"
 // account services
 #include "account/AccountService.h"
 #include "account/AuthService.h"
 #include "account/BrowserLockdownSvc.h"
 #include "account/ClientStatMgrService.h"
 #include "account/InfoGatheringMgr.h"
+#include "account/LoginAuthenticator.h"
 #include "account/TutorialService.h"
+#include "account/TutorialStore.h"
 #include "account/UserService.h"
+#include "account/WalletLedger.h"
 // admin services
 #include "admin/AlertService.h"
 #include "admin/AllCommands.h"
 #include "admin/ClientStatLogger.h"
+#include "admin/ClientTelemetry.h"
 #include "admin/CommandDispatcher.h"
 #include "admin/DevToolsProviderService.h"
+#include "admin/PacketTrace.h"
 #include "admin/PetitionerService.h"
 #include "admin/SlashService.h"
 // apiserver services
@@ -50,7 +58,12 @@
 #include "cache/ObjCacheService.h"
 // character services
 #include "character/AggressionMgrService.h"
+#include "character/CertificateGraph.h"
 #include "character/CertificateMgrService.h"
+#include "character/CharCreationTemplates.h"
+#include "character/CharSelectCache.h"
+#include "character/PaperDollStore.h"
+#include "character/LoginPipeline.h"
 #include "character/CharacterService.h"
 #include "character/CharFittingMgrService.h"
 #include "character/CharMgrService.h"
@@ -58,20 +71,26 @@
 #include "character/PaperDollService.h"
 #include "character/PhotoUploadService.h"
 #include "character/SkillMgrService.h"
+#include "character/SkillQueueSweeper.h"
 // chat services
 #include "chat/LookupService.h"
 #include "chat/LSCService.h"
+#include "chat/NameIndex.h"
 #include "chat/OnlineStatusService.h"
+#include "chat/Presence.h"
 #include "chat/VoiceMgrService.h"
 // config services
 #include "config/ConfigService.h"
 #include "config/LanguageService.h"
 #include "config/LocalizationServerService.h"
+#include "config/OwnerDirectory.h"
+#include "config/TextStore.h"
 // corporation services
 #include "corporation/CorpBookmarkMgrService.h"
 #include "corporation/CorpMgrService.h"
 #include "corporation/CorporationService.h"
 #include "corporation/CorpRegistryService.h"
+#include "corporation/CorpRoster.h"
 #include "corporation/CorpStationMgrService.h"
 #include "corporation/LPService.h"
 // dogmaim services
@@ -81,51 +100,80 @@
 #include "imageserver/ImageServer.h"
 // inventory services
 #include "inventory/InvBrokerService.h"
+#include "inventory/InventoryBatch.h"
+#include "inventory/InventoryWriteBehind.h"
 // mail services
 #include "mail/MailMgrService.h"
+#include "mail/MailStore.h"
 #include "mail/MailingListMgrService.h"
 #include "mail/NotificationMgrService.h"
+#include "mail/NotificationQueue.h"
 // manufacturing services
 #include "manufacturing/FactoryService.h"
+#include "manufacturing/RamJobScheduler.h"
 #include "manufacturing/RamProxyService.h"
 // map services
 #include "map/MapService.h"
+#include "map/MapStatistics.h"
+#include "map/RouteMap.h"
 // market services
 #include "market/BillMgrService.h"
+#include "market/ContractBook.h"
 #include "market/ContractMgrService.h"
 #include "market/ContractProxy.h"
+#include "market/EconomyCache.h"
+#include "market/MarketJournal.h"
+#include "market/MarketOrderBook.h"
 #include "market/MarketProxyService.h"
+#include "market/TradeDesk.h"
 // mining services
 #include "mining/ReprocessingService.h"
 // missions services
+#include "missions/AgentCatalogue.h"
 #include "missions/AgentMgrService.h"
 #include "missions/DungeonExplorationMgrService.h"
 #include "missions/MissionMgrService.h"
+// npc services
+#include "npc/SpawnTable.h"
 // pos services
 #include "pos/PlanetMgr.h"
 #include "pos/PosMgrService.h"
+#include "pos/PlanetSimulation.h"
+#include "pos/StarbaseSimulator.h"
 // ship services
 #include "ship/BeyonceService.h"
+#include "ship/FittingEvaluator.h"
+#include "ship/FleetManager.h"
 #include "ship/FleetProxy.h"
 #include "ship/InsuranceService.h"
 #include "ship/RepairService.h"
 #include "ship/ShipService.h"
+#include "ship/modules/ActiveModules.h"
 #include "ship/modules/ModuleEffects.h"
 // standing services
 #include "standing/FactionWarMgrService.h"
+#include "standing/HostilityResolver.h"
 #include "standing/SovereigntyMgrService.h"
+#include "standing/SovereigntyTable.h"
 #include "standing/Standing2Service.h"
+#include "standing/StandingCache.h"
 #include "standing/WarRegistryService.h"
 // station services
 #include "station/HoloscreenMgrService.h"
 #include "station/JumpCloneService.h"
+#include "station/StationCache.h"
 #include "station/StationService.h"
 #include "station/StationSvcService.h"
 // system services
 #include "system/BookmarkService.h"
+#include "system/BookmarkStore.h"
+#include "system/ClusterMap.h"
+#include "system/JumpPipeline.h"
+#include "system/DungeonManager.h"
 #include "system/DungeonService.h"
 #include "system/KeeperService.h"
 #include "system/ScenarioService.h"
+#include "system/WarmStart.h"
 
 static void SetupSignals();
 static void CatchSignal( int sig_num );
@@ -133,6 +181,34 @@ static void CatchSignal( int sig_num );
 static const char* const CONFIG_FILE = EVEMU_ROOT "/etc/eve-server.xml";
 static const uint32 MAIN_LOOP_DELAY = 10; // delay 10 ms.
 
+/**
+ * @brief Timing stats of the main loop.
+ */
+struct MainLoopStats
+{
+    MainLoopStats() { Reset(); }
+
+    void Reset()
+    {
+        iterations = 0;
+        eventWakeups = 0;
+        busyTime = 0;
+        maxBusyTime = 0;
+        idleTime = 0;
+    }
+
+    /// Number of loop iterations.
+    uint32 iterations;
+    /// Number of iterations started by an event rather than a timeout.
+    uint32 eventWakeups;
+    /// Total time (in milliseconds) spent processing.
+    uint32 busyTime;
+    /// Longest single iteration (in milliseconds).
+    uint32 maxBusyTime;
+    /// Total time (in milliseconds) spent waiting for work.
+    uint32 idleTime;
+};
+
 static volatile bool RunLoops = true;
 dgmtypeattributemgr * _sDgmTypeAttrMgr;
 
@@ -186,6 +262,9 @@ int main( int argc, char* argv[] )
     //it is important to do this before doing much of anything, in case they use it.
     Timer::SetCurrentTime();
 
+    // the metrics are registered by many threads, so create the registry before any of them starts
+    sMetrics.Gauge( "evemu_start_time_seconds", "Time the server was started at, in seconds since the epoch." ).Set( time( NULL ) );
+
     // Load server log settings ( will be removed )
     if( load_log_settings( sConfig.files.logSettings.c_str() ) )
         sLog.Success( "server init", "Log settings loaded from %s", sConfig.files.logSettings.c_str() );
@@ -202,7 +281,15 @@ int main( int argc, char* argv[] )
             sLog.Warning( "server init", "Unable to find log directory '%s', only logging to the screen now.", sConfig.files.logDir.c_str() );
     }
 
+    // hand the writing of the log messages over to a thread of its own
+    if( sConfig.files.asyncLog )
+        sLog.StartAsync( sConfig.files.logQueueSize );
+
     //connect to the database...
+    sDatabase.SetPoolSize( sConfig.database.poolSize );
+    sDatabase.SetSlowQueryThreshold( sConfig.database.slowQueryThreshold );
+    sDatabase.SetIndexAdvisor( sConfig.database.indexAdvisor );
+
     DBerror err;
     if( !sDatabase.Open( err,
         sConfig.database.host.c_str(),
@@ -215,10 +302,262 @@ int main( int argc, char* argv[] )
         std::cout << std::endl << "press any key to exit...";  std::cin.get();
         return 1;
     }
-    _sDgmTypeAttrMgr = new dgmtypeattributemgr(); // needs to be after db init as its using it
+
+    //add the read replicas; they get no queries until they are found up to date
+    const std::string& replicas = sConfig.database.replicas;
+    for( size_t begin = 0; begin < replicas.size(); )
+    {
+        size_t end = replicas.find( ',', begin );
+        if( std::string::npos == end )
+            end = replicas.size();
+
+        const std::string replica = replicas.substr( begin, end - begin );
+        const size_t colon = replica.find( ':' );
+        if( !replica.empty() )
+            sDatabase.AddReplica( replica.substr( 0, colon ).c_str(),
+                                  ( std::string::npos == colon ? sConfig.database.port : atoi( replica.c_str() + colon + 1 ) ) );
+
+        begin = end + 1;
+    }
+    if( !replicas.empty() )
+        sDatabase.CheckReplicas( sConfig.database.maxReplicaLag );
+
+    //Read the static data snapshot, if there is one; a missing or incomplete one is written at shutdown
+    DBSnapshot* staticData = NULL;
+    bool staticDataStale = false;
+    if( !sConfig.files.staticDataSnapshot.empty() )
+    {
+        const uint64 start = GetTimeUSeconds();
+
+        staticData = new DBSnapshot;
+        if( staticData->Load( sConfig.files.staticDataSnapshot.c_str() ) )
+            sLog.Success( "server init", "Static data snapshot %s read in %.1f ms.", sConfig.files.staticDataSnapshot.c_str(), ( GetTimeUSeconds() - start ) / 1000.0 );
+        else
+        {
+            sLog.Error( "server init", "Failed to read static data snapshot %s, querying the database instead.", sConfig.files.staticDataSnapshot.c_str() );
+            SafeDelete( staticData );
+            staticDataStale = true;
+        }
+    }
+
+    _sDgmTypeAttrMgr = new dgmtypeattributemgr( staticData ); // needs to be after db init as its using it
+
+    //Start up the asynchronous query threads
+    sDBAsync.Start( sConfig.database.asyncThreads );
+
+    //Set up batching of item and attribute saves
+    sInventoryWriteBehind.SetFlushInterval( sConfig.database.writeBehindInterval );
+
+    //Write the trades the last run left in the market journal, then keep journaling
+    if( !sMarketJournal.Open( sConfig.files.marketJournal ) )
+    {
+        sLog.Error( "server init", "Unable to open the market journal %s.", sConfig.files.marketJournal.c_str() );
+        std::cout << std::endl << "press any key to exit...";  std::cin.get();
+        return 1;
+    }
+    sMarketJournal.SetFlushInterval( sConfig.database.writeBehindInterval );
+
+    //Pick up the wallet journal where it was left; balances load on first use
+    if( !sWalletLedger.Load() )
+    {
+        sLog.Error( "server init", "Unable to load the wallet journal." );
+        std::cout << std::endl << "press any key to exit...";  std::cin.get();
+        return 1;
+    }
+
+    //Load the market orders; browsing and matching never query them afterwards
+    if( !sMarketOrderBook.Load() )
+    {
+        sLog.Error( "server init", "Unable to load the market orders." );
+        std::cout << std::endl << "press any key to exit...";  std::cin.get();
+        return 1;
+    }
+    sLog.Success( "server init", "Loaded %lu market orders.", (unsigned long)sMarketOrderBook.size() );
+
+    //Load the live contracts; searches and listings never query them afterwards
+    if( !sContractBook.Load() )
+    {
+        sLog.Error( "server init", "Unable to load the contracts." );
+        std::cout << std::endl << "press any key to exit...";  std::cin.get();
+        return 1;
+    }
+    sLog.Success( "server init", "Loaded %lu contracts.", (unsigned long)sContractBook.size() );
+
+    //Load the manufacturing jobs in progress; the ramProxy service schedules their completion
+    if( !sRamJobScheduler.Load() )
+    {
+        sLog.Error( "server init", "Unable to load the manufacturing jobs." );
+        std::cout << std::endl << "press any key to exit...";  std::cin.get();
+        return 1;
+    }
+    sLog.Success( "server init", "Loaded %lu manufacturing jobs in progress.", (unsigned long)sRamJobScheduler.size() );
+
+    //Load the names the lookup service searches; searches as you type never scan the tables
+    if( !sNameIndex.Load() )
+    {
+        sLog.Error( "server init", "Unable to load the name index." );
+        std::cout << std::endl << "press any key to exit...";  std::cin.get();
+        return 1;
+    }
+    sLog.Success( "server init", "Indexed %lu names.", (unsigned long)sNameIndex.size() );
+
+    //Load what the new characters start with; creating one queries none of it
+    if( !sCharCreationTemplates.Load() )
+    {
+        sLog.Error( "server init", "Unable to load the character creation templates." );
+        std::cout << std::endl << "press any key to exit...";  std::cin.get();
+        return 1;
+    }
+    sLog.Success( "server init", "Loaded the character creation templates of %lu careers.", (unsigned long)sCharCreationTemplates.size() );
+
+    //Load the insurance, repair and LP store prices; browsing those windows never queries the database
+    if( !sEconomyCache.Load() )
+    {
+        sLog.Error( "server init", "Unable to load the economy cache." );
+        std::cout << std::endl << "press any key to exit...";  std::cin.get();
+        return 1;
+    }
+    sLog.Success( "server init", "Cached the prices of %lu types and %lu LP store offers.", (unsigned long)sEconomyCache.size(), (unsigned long)sEconomyCache.GetOfferCount() );
+
+    //Load the localization texts; logins never query them
+    if( !sTextStore.Load() )
+    {
+        sLog.Error( "server init", "Unable to load the localization texts." );
+        std::cout << std::endl << "press any key to exit...";  std::cin.get();
+        return 1;
+    }
+    sLog.Success( "server init", "Loaded %lu text groups with %lu distinct strings (%lu bytes).",
+                  (unsigned long)sTextStore.size(), (unsigned long)sTextStore.GetStringCount(), (unsigned long)sTextStore.GetPoolSize() );
+
+    //Load the tutorials; new players opening them never query the database
+    if( !sTutorialStore.Load() )
+    {
+        sLog.Error( "server init", "Unable to load the tutorials." );
+        std::cout << std::endl << "press any key to exit...";  std::cin.get();
+        return 1;
+    }
+    sLog.Success( "server init", "Loaded %lu tutorials.", (unsigned long)sTutorialStore.size() );
+
+    //Load the stargate graph and the jump tables of the regions
+    if( !sRouteMap.Load() )
+    {
+        sLog.Error( "server init", "Unable to load the stargate graph." );
+        std::cout << std::endl << "press any key to exit...";  std::cin.get();
+        return 1;
+    }
+    sLog.Success( "server init", "Loaded %lu solar systems and %lu stargate jumps.", (unsigned long)sRouteMap.size(), (unsigned long)sRouteMap.GetJumpCount() );
+
+    //Load the agents and the mission templates the offers are made of
+    if( !sAgentCatalogue.Load() )
+    {
+        sLog.Error( "server init", "Unable to load the agent catalogue." );
+        std::cout << std::endl << "press any key to exit...";  std::cin.get();
+        return 1;
+    }
+    sLog.Success( "server init", "Loaded %lu agents and %lu mission templates.", (unsigned long)sAgentCatalogue.size(), (unsigned long)sAgentCatalogue.GetMissionCount() );
+
+    //Load the spawn groups and the spawns of all the systems
+    if( !sSpawnTable.Load() )
+    {
+        sLog.Error( "server init", "Unable to load the spawn tables." );
+        std::cout << std::endl << "press any key to exit...";  std::cin.get();
+        return 1;
+    }
+    sLog.Success( "server init", "Loaded %lu spawn groups and %lu spawns.", (unsigned long)sSpawnTable.size(), (unsigned long)sSpawnTable.GetSpawnCount() );
+
+    //Load the dungeon templates the instances are spawned from
+    if( !sDungeonManager.Load() )
+    {
+        sLog.Error( "server init", "Unable to load the dungeon templates." );
+        std::cout << std::endl << "press any key to exit...";  std::cin.get();
+        return 1;
+    }
+    sLog.Success( "server init", "Loaded %lu dungeon blueprints.", (unsigned long)sDungeonManager.size() );
+
+    //Load who watches whom; logins and logouts are pushed to the watchers once per tick
+    if( !sPresence.Load() )
+    {
+        sLog.Error( "server init", "Unable to load the watch lists." );
+        std::cout << std::endl << "press any key to exit...";  std::cin.get();
+        return 1;
+    }
+    sLog.Success( "server init", "Loaded the watchers of %lu characters.", (unsigned long)sPresence.GetWatchedCount() );
+
+    //Load the NPC standings; the standings of the characters are loaded once per session
+    if( !sStandingCache.Load() )
+    {
+        sLog.Error( "server init", "Unable to load the NPC standings." );
+        std::cout << std::endl << "press any key to exit...";  std::cin.get();
+        return 1;
+    }
+    sLog.Success( "server init", "Loaded %lu NPC standings.", (unsigned long)sStandingCache.size() );
+
+    //Load the sovereignty and the faction warfare state; entering a system never queries it
+    if( !sSovereigntyTable.Load() )
+    {
+        sLog.Error( "server init", "Unable to load the sovereignty table." );
+        std::cout << std::endl << "press any key to exit...";  std::cin.get();
+        return 1;
+    }
+    sLog.Success( "server init", "Loaded the sovereignty of %lu solar systems.", (unsigned long)sSovereigntyTable.size() );
+
+    //Load the wars and kill rights the aggression checks resolve against
+    if( !sHostilityResolver.Load() )
+    {
+        sLog.Error( "server init", "Unable to load the wars and kill rights." );
+        std::cout << std::endl << "press any key to exit...";  std::cin.get();
+        return 1;
+    }
+    sLog.Success( "server init", "Loaded %lu wars and %lu kill rights.", (unsigned long)sHostilityResolver.size(), (unsigned long)sHostilityResolver.GetKillRightCount() );
+
+    //Compile the certificate requirements, so the grants are evaluated without queries
+    if( !sCertificateGraph.Load() )
+    {
+        sLog.Error( "server init", "Unable to load the certificate requirements." );
+        std::cout << std::endl << "press any key to exit...";  std::cin.get();
+        return 1;
+    }
+    sLog.Success( "server init", "Compiled %lu certificates over %lu skill levels.", (unsigned long)sCertificateGraph.size(), (unsigned long)sCertificateGraph.GetSkillBitCount() );
+
+    //Build the character selection screens, so the logins after a downtime do not query them
+    if( !sCharSelectCache.Load() )
+    {
+        sLog.Error( "server init", "Unable to load the character selection screens." );
+        std::cout << std::endl << "press any key to exit...";  std::cin.get();
+        return 1;
+    }
+    sLog.Success( "server init", "Built %lu character selection rowsets.", (unsigned long)sCharSelectCache.size() );
+
+    //Pick up the notificationIDs where they were left; notifications are written once per tick
+    if( !sNotificationQueue.Load() )
+    {
+        sLog.Error( "server init", "Unable to load the notifications." );
+        std::cout << std::endl << "press any key to exit...";  std::cin.get();
+        return 1;
+    }
+
+    //Start up the network I/O threads
+    sTCPReactor.Start( sConfig.net.ioThreads );
+
+    //Set up deflation of outbound packets
+    EVETCPConnection::SetDeflation( sConfig.net.deflationLimit, sConfig.net.deflationLevel );
+    EVETCPConnection::SetDeflation( CALL_RSP, sConfig.net.callDeflationLimit, sConfig.net.callDeflationLevel );
+    EVETCPConnection::SetDeflation( NOTIFICATION, sConfig.net.notifyDeflationLimit, sConfig.net.notifyDeflationLevel );
+    EVETCPConnection::SetDeflation( SESSIONCHANGENOTIFICATION, sConfig.net.notifyDeflationLimit, sConfig.net.notifyDeflationLevel );
+
+    //Drop the clients which do not read what we send them
+    TCPConnection::SetSendQueueLimit( sConfig.net.sendQueueLimit );
+
+    //Start up the packet encoder threads
+    sEncoderPool.Start( sConfig.net.encoderThreads );
+
+    // Signaled by the I/O and query threads whenever the main loop has some work to do
+    Event mainLoopEvent;
+    sDBAsync.SetNotifyEvent( &mainLoopEvent );
 
     //Start up the TCP server
     EVETCPServer tcps;
+    tcps.SetNotifyEvent( &mainLoopEvent );
 
     char errbuf[ TCPCONN_ERRBUF_SIZE ];
     if( tcps.Open( sConfig.net.port, errbuf ) )
@@ -233,9 +572,53 @@ int main( int argc, char* argv[] )
     }
     //make the item factory
     ItemFactory item_factory( sEntityList );
+    item_factory.SetItemCacheCapacity( sConfig.world.itemCacheSize );
+    if( NULL != staticData )
+    {
+        if( !item_factory.LoadStaticData( *staticData ) )
+        {
+            sLog.Error( "server init", "Static data snapshot %s is not complete, querying the database instead.", sConfig.files.staticDataSnapshot.c_str() );
+            staticDataStale = true;
+        }
+
+        // everything is copied out of it by now
+        SafeDelete( staticData );
+    }
 
     //now, the service manager...
     PyServiceMgr services( 888444, sEntityList, item_factory );
+    sEntityList.systemPreloader().SetLimit( sConfig.world.systemPreloadLimit );
+
+    //Spread the regions over the sol nodes; our node is the first of them
+    if( !sClusterMap.Load( services.GetNodeID(), sConfig.world.solNodes ) )
+    {
+        sLog.Error( "server init", "Unable to load the cluster map." );
+        std::cout << std::endl << "press any key to exit...";  std::cin.get();
+        return 1;
+    }
+    sLog.Success( "server init", "Mapped %lu solar systems to %u sol nodes.", (unsigned long)sClusterMap.size(), sClusterMap.GetNodeCount() );
+
+    //complete the skills of offline characters in the background
+    SkillQueueSweeper skill_sweeper( item_factory );
+    skill_sweeper.Start( sConfig.character.skillSweepInterval, sConfig.character.skillSweepBatch );
+
+    //Load the control towers; their fuel is burnt in batched passes
+    if( !sStarbaseSimulator.Load( item_factory ) )
+    {
+        sLog.Error( "server init", "Unable to load the control towers." );
+        std::cout << std::endl << "press any key to exit...";  std::cin.get();
+        return 1;
+    }
+    sLog.Success( "server init", "Loaded %lu control towers.", (unsigned long)sStarbaseSimulator.size() );
+
+    //Load the schematics; the colonies are loaded and advanced as they are observed
+    if( !sPlanetSimulation.Load() )
+    {
+        sLog.Error( "server init", "Unable to load the planetary schematics." );
+        std::cout << std::endl << "press any key to exit...";  std::cin.get();
+        return 1;
+    }
+    sLog.Success( "server init", "Loaded planetary schematics." );
 
     //setup the command dispatcher
     CommandDispatcher command_dispatcher( services );
@@ -323,8 +706,11 @@ int main( int argc, char* argv[] )
     services.RegisterService(new WarRegistryService(&services));
 
     sLog.Log("server init", "Priming cached objects.");
-    services.cache_service->PrimeCache();
-    sLog.Log("server init", "finished priming");
+    services.PrimeCaches();
+    if( 0 < services.cache_service->GetPrimingCount() )
+        sLog.Log("server init", "Priming %lu cached objects in the background.", (unsigned long)services.cache_service->GetPrimingCount());
+    else
+        sLog.Log("server init", "finished priming");
 
     // start up the image server
     sImageServer.Run();
@@ -338,6 +724,31 @@ int main( int argc, char* argv[] )
     // start up the image server
     sLog.Log("server init", "Loading Dynamic Database Table Objects...");
     sDGM_Effects_Table.Initialize();
+    sFittingEvaluator.SetCapacity( sConfig.world.fittingCacheSize );
+
+    //Boot the solar systems which were booted at the last shutdown
+    WarmStart warm_start;
+    if( !sConfig.files.warmStart.empty() )
+    {
+        std::vector<uint32> systemIDs;
+        if( !warm_start.Init() )
+            sLog.Error( "server init", "Unable to checksum the static data; the solar systems are not kept over restarts." );
+        else if( warm_start.Load( sConfig.files.warmStart.c_str(), systemIDs ) )
+        {
+            const uint64 start = GetTimeUSeconds();
+
+            size_t booted = 0;
+            for( size_t i = 0; i < systemIDs.size(); i++ )
+            {
+                if( NULL != sEntityList.FindOrBootSystem( systemIDs[ i ] ) )
+                    ++booted;
+            }
+            sLog.Success( "server init", "Booted %lu of %lu solar systems of the last run in %.1f ms.",
+                          (unsigned long)booted, (unsigned long)systemIDs.size(), ( GetTimeUSeconds() - start ) / 1000.0 );
+        }
+        else
+            sLog.Log( "server init", "No warm start state in %s for the current static data.", sConfig.files.warmStart.c_str() );
+    }
 
     sLog.Log("server init", "Init done.");
 
@@ -356,39 +767,558 @@ int main( int argc, char* argv[] )
     uint32 etime;
     uint32 last_time = GetTickCount();
 
+    MainLoopStats stats;
+    MetricHistogram& tickMetric = sMetrics.LatencyHistogram( "evemu_main_loop_tick_seconds", "Time the main loop was busy in a tick." );
+    uint32 stats_time = last_time;
+    uint32 ping_time = last_time;
+    uint32 lag_time = last_time;
+    bool woken = false;
+
+    if( sConfig.loop.eventDriven )
+        sLog.Log("server init", "Main loop is event-driven (max idle time %u ms).", sConfig.loop.maxIdleTime );
+
+    sTickProfiler.Configure( sConfig.loop.tickProfiler, sConfig.loop.slowTickThreshold, sConfig.loop.slowTickHistory );
+    MemoryTag::SetSampleRate( sConfig.loop.memorySampleRate );
+    sCallTracer.Configure( sConfig.loop.callTraceRate, sConfig.loop.callTraceHistory, sConfig.loop.callTraceLog );
+
     EVETCPConnection* tcpc;
     while( RunLoops == true )
     {
         Timer::SetCurrentTime();
+        Timer::ResetNextDeadline();
         start = GetTickCount();
+        sTickProfiler.BeginTick();
+        // the calls received until now waited for us
+        sCallTracer.BeginTick();
 
         //check for timeouts in other threads
         //timeout_manager.CheckTimeouts();
-        while( ( tcpc = tcps.PopConnection() ) )
         {
-            Client* c = new Client( services, &tcpc );
+            ProfileZone zone( "Accept" );
+            while( ( tcpc = tcps.PopConnection() ) )
+            {
+                Client* c = new Client( services, &tcpc );
 
-            sEntityList.Add( &c );
+                sEntityList.Add( &c );
+            }
         }
 
-        sEntityList.Process();
-        services.Process();
+        // the item changes of the whole tick are sent and written as one
+        sInventoryBatch.Begin();
+
+        // fire whatever timers expired
+        { ProfileZone zone( "TimerWheel" ); sTimerWheel.Process( Timer::GetCurrentTime() ); }
+
+        { ProfileZone zone( "EntityList" ); sEntityList.Process(); }
+        { ProfileZone zone( "Services" ); services.Process(); }
+        // broadcast the joins and leaves the busy chat channels queued
+        { ProfileZone zone( "LSC" ); services.lsc_service->Process(); }
+        // and the logins and logouts to the watchers
+        { ProfileZone zone( "Presence" ); sPresence.Process(); }
+        // warp the fleets ordered to, all their members in the same tick
+        { ProfileZone zone( "FleetManager" ); sFleetManager.Process(); }
+        // move the pilots who are done watching the JumpOut, a batch per gate
+        { ProfileZone zone( "JumpPipeline" ); sJumpPipeline.Process(); }
+        // attach the logins whose character has been fetched
+        { ProfileZone zone( "LoginPipeline" ); sLoginPipeline.Process(); }
+        // tell the stations who docked and undocked
+        { ProfileZone zone( "StationCache" ); sStationCache.Process(); }
+        // tell the systems whose sovereignty or occupier changed
+        { ProfileZone zone( "SovereigntyTable" ); sSovereigntyTable.Process(); }
+
+        // complete whatever the query threads are done with
+        { ProfileZone zone( "DBAsync" ); sDBAsync.Process(); }
+
+        { ProfileZone zone( "InventoryBatch" ); sInventoryBatch.End(); }
+
+        // drop the items nothing refers to any more, saving their changes
+        { ProfileZone zone( "ItemCache" ); item_factory.TrimItemCache(); }
+        // and tell /metrics how much memory the subsystems hold
+        MemoryTag::PublishMetrics();
+
+        // write the queued item and attribute saves once due
+        { ProfileZone zone( "InventoryWriteBehind" ); sInventoryWriteBehind.Process( Timer::GetCurrentTime() ); }
+        // and the trades of the market journal
+        { ProfileZone zone( "MarketJournal" ); sMarketJournal.Process( Timer::GetCurrentTime() ); }
+        // deliver the mails to corporations and alliances
+        { ProfileZone zone( "MailStore" ); sMailStore.Process(); }
+        // and the notifications enqueued this tick
+        { ProfileZone zone( "NotificationQueue" ); sNotificationQueue.Process(); }
+        // publish the star map statistics once due
+        { ProfileZone zone( "MapStatistics" ); sMapStatistics.Process( Timer::GetCurrentTime() ); }
+
+        // release whatever the encoder threads are done with
+        { ProfileZone zone( "EncoderPool" ); sEncoderPool.Process(); }
+        // and account the calls whose answers are sent
+        { ProfileZone zone( "CallTracer" ); sCallTracer.Process(); }
+
+        sTickProfiler.EndTick();
 
         /* UPDATE */
         last_time = GetTickCount();
         etime = last_time - start;
 
+        tickMetric.Observe( (uint64)etime * 1000 );
+
+        ++stats.iterations;
+        if( woken )
+            ++stats.eventWakeups;
+        stats.busyTime += etime;
+        if( stats.maxBusyTime < etime )
+            stats.maxBusyTime = etime;
+
+        if( 0 < sConfig.loop.statsInterval
+            && sConfig.loop.statsInterval * 1000 <= last_time - stats_time )
+        {
+            sLog.Log("server stats", "Main loop: %u iterations (%u woken by event), busy %u ms (avg %.2f ms, max %u ms), idle %u ms.",
+                     stats.iterations, stats.eventWakeups, stats.busyTime,
+                     (double)stats.busyTime / stats.iterations, stats.maxBusyTime, stats.idleTime );
+
+            const TimerWheel::Stats& timers = sTimerWheel.stats();
+            sLog.Log("server stats", "Timers: %u scheduled, %u fired (max %u per tick), %u late (max %u ms late).",
+                     (uint32)sTimerWheel.size(), timers.fired, timers.maxFired, timers.late, timers.maxLateness );
+
+            const DBcore::Stats db = sDatabase.GetStats();
+            sLog.Log("server stats", "Database: %u connection checkouts, %u waited (total %u ms, max %u ms), %u reconnects, %u failed health checks, %u statements prepared, %u reads from replicas, %u fell back to the primary.",
+                     db.checkouts, db.waits, db.waitTime, db.maxWaitTime, db.reconnects, db.pingFailures, db.prepares, db.replicaReads, db.primaryReads );
+
+            const InventoryWriteBehind::Stats& writes = sInventoryWriteBehind.stats();
+            sLog.Log("server stats", "Inventory writes: %u queued (%u coalesced), %u rows written in %u flushes, %u failed.",
+                     writes.queued, writes.coalesced, writes.rows, writes.flushes, writes.failures );
+
+            const InventoryBatch::Stats& batches = sInventoryBatch.stats();
+            sLog.Log("server stats", "Inventory batches: %u batches, %u item changes (%u coalesced, %u reverted) sent in %u notifications.",
+                     batches.batches, batches.changes, batches.coalesced, batches.reverted, batches.notifications );
+
+            const MarketOrderBook::Stats& market = sMarketOrderBook.stats();
+            sLog.Log("server stats", "Market: %lu orders resident, %u placed orders matched, %u unmatched, %u added, %u removed.",
+                     (unsigned long)sMarketOrderBook.size(), market.matched, market.unmatched, market.placed, market.removed );
+
+            const MarketJournal::Stats& trades = sMarketJournal.stats();
+            sLog.Log("server stats", "Market journal: %u trades (%u statements) written in %u flushes, %u failed, %u replayed.",
+                     trades.trades, trades.statements, trades.flushes, trades.failures, trades.replayed );
+
+            const WalletLedger::Stats& wallets = sWalletLedger.stats();
+            sLog.Log("server stats", "Wallets: %lu corporation balances resident, %u balance changes, %u journal entries, %u journal queries served from memory, %u from the database.",
+                     (unsigned long)sWalletLedger.size(), wallets.changes, wallets.entries, wallets.windowHits, wallets.windowMisses );
+
+            const ContractBook::Stats& contracts = sContractBook.stats();
+            sLog.Log("server stats", "Contracts: %lu resident, %u created, %u expired, %u searches examined %u contracts.",
+                     (unsigned long)sContractBook.size(), contracts.created, contracts.expired, contracts.searches, contracts.examined );
+
+            const RamJobScheduler::Stats& jobs = sRamJobScheduler.stats();
+            sLog.Log("server stats", "Industry: %lu jobs in progress, %u installed, %u finished production, %u completed.",
+                     (unsigned long)sRamJobScheduler.size(), jobs.installed, jobs.finished, jobs.completed );
+
+            const NameIndex::Stats& names = sNameIndex.stats();
+            sLog.Log("server stats", "Name lookups: %lu names indexed, %u lookups examined %u names, %u left to the database, %u names updated.",
+                     (unsigned long)sNameIndex.size(), names.lookups, names.examined, names.fallbacks, names.updates );
+
+            const TradeDesk::Stats& playerTrades = sTradeDesk.stats();
+            sLog.Log("server stats", "Trades: %lu open, %u initiated, %u offer changes held in memory, %u completed, %u failed, %u cancelled.",
+                     (unsigned long)sTradeDesk.size(), playerTrades.opened, playerTrades.changes, playerTrades.completed, playerTrades.failed, playerTrades.cancelled );
+
+            const EconomyCache::Stats& economy = sEconomyCache.stats();
+            sLog.Log("server stats", "Economy cache: %u insurance prices, %u repair quotes and %u LP store offer lists served.",
+                     economy.insuranceQuotes, economy.repairQuotes, economy.offerLists );
+
+            const RouteMap::Stats& routes = sRouteMap.stats();
+            sLog.Log("server stats", "Routes: %u queries, %u served from the jump tables, %u from the route cache, %u searches expanded %u systems.",
+                     routes.queries, routes.tableHits, routes.cacheHits, routes.searches, routes.expanded );
+
+            const MapStatistics::Stats& mapStats = sMapStatistics.stats();
+            sLog.Log("server stats", "Map statistics: %u jumps and %u kills counted, %u snapshots published, %u rowsets built.",
+                     mapStats.jumps, mapStats.kills, mapStats.snapshots, mapStats.builds );
+
+            const AgentCatalogue::Stats& agents = sAgentCatalogue.stats();
+            sLog.Log("server stats", "Agents: %u offers, %u accepted, %u declined, %u completed, missions of %u characters loaded.",
+                     agents.offers, agents.accepted, agents.declined, agents.completed, agents.characterLoads );
+
+            const SpawnTable::Stats& spawns = sSpawnTable.stats();
+            sLog.Log("server stats", "Spawns: %u groups spawned %u transient NPCs, %u NPCs depopped.",
+                     spawns.spawns, spawns.npcs, spawns.depops );
+
+            const DungeonManager::Stats& dungeons = sDungeonManager.stats();
+            sLog.Log("server stats", "Dungeons: %lu instances live, %u spawned with %u entities, %u torn down.",
+                     (unsigned long)sDungeonManager.GetInstanceCount(), dungeons.instances, dungeons.entities, dungeons.teardowns );
+
+            const StarbaseSimulator::Stats& starbases = sStarbaseSimulator.stats();
+            sLog.Log("server stats", "Starbases: %lu towers, %u passes cycled %u towers, burnt %u cycles, %u towers ran out of fuel, %.3f ms per pass (max %.3f ms).",
+                     (unsigned long)sStarbaseSimulator.size(), starbases.passes, starbases.towers, starbases.cycles, starbases.offlined,
+                     ( 0 < starbases.passes ? starbases.passTime / 1000.0 / starbases.passes : 0.0 ), starbases.maxPassTime / 1000.0 );
+
+            const PlanetSimulation::Stats& planets = sPlanetSimulation.stats();
+            sLog.Log("server stats", "Planets: %lu colonies resident, %u loaded, %u observed, %u extractor cycles and %u factory cycles computed, %u heat maps generated.",
+                     (unsigned long)sPlanetSimulation.size(), planets.loads, planets.observations, planets.extractorCycles, planets.factoryCycles, planets.heatMaps );
+
+            const CorpRoster::Stats& rosters = sCorpRoster.stats();
+            sLog.Log("server stats", "Corporation rosters: %lu resident, %u loaded, %u evicted, %u calls served from memory, %u fetches returned %u rows, %u changes applied.",
+                     (unsigned long)sCorpRoster.size(), rosters.loads, rosters.evictions, rosters.hits, rosters.fetches, rosters.rows, rosters.updates );
+
+            const Presence::Stats& presence = sPresence.stats();
+            sLog.Log("server stats", "Presence: %lu online, %u logins, %u logouts (%u cancelled out), %u changes pushed in %u events.",
+                     (unsigned long)sPresence.size(), presence.logins, presence.logouts, presence.coalesced, presence.pushed, presence.pushes );
+
+            const FleetManager::Stats& fleets = sFleetManager.stats();
+            sLog.Log("server stats", "Fleets: %lu fleets of %lu members, %u joins, %u leaves, %u broadcasts to %u members, %u fleet warps moved %u members.",
+                     (unsigned long)sFleetManager.size(), (unsigned long)sFleetManager.GetMemberCount(), fleets.joins, fleets.leaves,
+                     fleets.broadcasts, fleets.broadcastRecipients, fleets.fleetWarps, fleets.warps );
+
+            const StandingCache::Stats& standings = sStandingCache.stats();
+            sLog.Log("server stats", "Standings: %u lookups, effective standings %u memoized / %u computed, %lu characters resident, %u loaded, %u changed.",
+                     standings.lookups, standings.derivedHits, standings.derivedMisses, (unsigned long)sStandingCache.GetCharacterCount(), standings.characterLoads, standings.updates );
+
+            const SovereigntyTable::Stats& sov = sSovereigntyTable.stats();
+            sLog.Log("server stats", "Sovereignty: %lu systems at version %" PRIu64 ", %u queries, %u changes, %u sessions notified.",
+                     (unsigned long)sSovereigntyTable.size(), sSovereigntyTable.GetVersion(), sov.queries, sov.changes, sov.notifications );
+
+            const HostilityResolver::Stats& hostility = sHostilityResolver.stats();
+            sLog.Log("server stats", "Hostility: %lu wars, %lu kill rights, %u checks (%u hostile), %u changes.",
+                     (unsigned long)sHostilityResolver.size(), (unsigned long)sHostilityResolver.GetKillRightCount(), hostility.checks, hostility.hostile, hostility.updates );
+
+            const CharSelectCache::Stats& charSelect = sCharSelectCache.stats();
+            sLog.Log("server stats", "Character selection: %lu rowsets cached, %u hits, %u misses, %u invalidations.",
+                     (unsigned long)sCharSelectCache.size(), charSelect.hits, charSelect.misses, charSelect.invalidations );
+
+            const LoginAuthenticator::Stats& auths = sLoginAuthenticator.stats();
+            sLog.Log("server stats", "Authentication: %u submitted, %u accepted, %u rejected, %u throttled, %u overflowed, %u cancelled, %lu pending; %u ms (max %u).",
+                     auths.submitted, auths.accepted, auths.rejected, auths.throttled, auths.overflowed, auths.cancelled, (unsigned long)sLoginAuthenticator.size(),
+                     auths.authTime, auths.maxAuthTime );
+
+            const LoginPipeline::Stats& logins = sLoginPipeline.stats();
+            sLog.Log("server stats", "Logins: %u started, %u completed, %u failed, %u cancelled, %lu in flight; prefetch %u ms (max %u), system wait %u ms (max %u), attach %u ms (max %u).",
+                     logins.started, logins.completed, logins.failed, logins.cancelled, (unsigned long)sLoginPipeline.size(),
+                     logins.prefetchTime, logins.maxPrefetchTime, logins.systemWaitTime, logins.maxSystemWaitTime, logins.attachTime, logins.maxAttachTime );
+
+            const StationCache::Stats& stationStats = sStationCache.stats();
+            sLog.Log("server stats", "Stations: %lu resident, %lu guests, %u static hits, %u misses, %u docks, %u undocks (%u coalesced), %u notifications.",
+                     (unsigned long)sStationCache.size(), (unsigned long)sStationCache.GetGuestCount(), stationStats.hits, stationStats.misses,
+                     stationStats.arrivals, stationStats.departures, stationStats.coalesced, stationStats.notifications );
+
+            const MailStore::Stats& mails = sMailStore.stats();
+            sLog.Log("server stats", "Mail: %u sent (%u with a stored body), %lu mailboxes resident, %u loaded, %u syncs, bodies %u cached / %u queried, %u deliveries to corporations and alliances (%u failed, %lu pending).",
+                     mails.sent, mails.sharedBodies, (unsigned long)sMailStore.size(), mails.mailboxLoads, mails.syncs, mails.bodyHits, mails.bodyMisses,
+                     mails.deliveries, mails.failedDeliveries, (unsigned long)sMailStore.GetPendingCount() );
+
+            const OwnerDirectory::Stats& owners = sOwnerDirectory.stats();
+            sLog.Log("server stats", "Owner directory: %lu IDs resident, %u calls, %u IDs served from memory, %u known missing, %u queried in %u queries, %u invalidated.",
+                     (unsigned long)sOwnerDirectory.size(), owners.calls, owners.hits, owners.negativeHits, owners.misses, owners.queries, owners.invalidations );
+
+            const TextStore::Stats& texts = sTextStore.stats();
+            sLog.Log("server stats", "Texts: %u group requests, %u rowsets built, %u requests of groups without texts.",
+                     texts.calls, texts.built, texts.unknown );
+
+            const TutorialStore::Stats& tutorials = sTutorialStore.stats();
+            sLog.Log("server stats", "Tutorials: %u calls, %u replies cached, %u requests of unknown tutorials.",
+                     tutorials.calls, tutorials.built, tutorials.unknown );
+
+            const ClientTelemetry::Stats& telemetry = sClientTelemetry.stats();
+            sLog.Log("server stats", "Client telemetry: %u reports queued (%u dropped, %lu waiting), %u flushes wrote %u distinct texts (%u failed).",
+                     telemetry.reports, telemetry.dropped, (unsigned long)sClientTelemetry.size(), telemetry.flushes, telemetry.rows, telemetry.failed );
+
+            const PacketTrace::Stats& trace = sPacketTrace.stats();
+            sLog.Log("server stats", "Packet trace: %u packets traced (%u sampled out, %u throttled, %u oversized), %lu held, %u overwritten.",
+                     trace.traced, trace.sampledOut, trace.throttled, trace.oversized, (unsigned long)sPacketTrace.size(), trace.overwritten );
+
+            const CharCreationTemplates::Stats& creations = sCharCreationTemplates.stats();
+            sLog.Log("server stats", "Character creation: %u characters set up (%u failed), %u skill templates merged.",
+                     creations.setups, creations.failures, creations.merges );
+
+            const PaperDollStore::Stats& dolls = sPaperDollStore.stats();
+            sLog.Log("server stats", "Paper dolls: %lu resident, %u hits, %u loaded by %u queries, %u saved.",
+                     (unsigned long)sPaperDollStore.size(), dolls.hits, dolls.loads, dolls.queries, dolls.saves );
+
+            const ClusterMap::Stats& cluster = sClusterMap.stats();
+            sLog.Log("server stats", "Cluster: %u locations resolved over %u sol nodes, %u to other nodes than ours, %u systems moved.",
+                     cluster.resolves, sClusterMap.GetNodeCount(), cluster.remote, cluster.migrations );
+
+            const JumpPipeline::Stats& jumps = sJumpPipeline.stats();
+            sLog.Log("server stats", "Gate jumps: %u started, %u failed, %u cancelled, %lu in flight, %u arrived in %u batches (largest %u), %u destinations booted.",
+                     jumps.started, jumps.failed, jumps.cancelled, (unsigned long)sJumpPipeline.size(),
+                     jumps.arrived, jumps.batches, jumps.maxBatch, jumps.boots );
+
+            const CertificateGraph::Stats& certificates = sCertificateGraph.stats();
+            sLog.Log("server stats", "Certificates: %u evaluations, %u granted, %u refused.",
+                     certificates.evaluations, certificates.granted, certificates.refused );
+
+            const BookmarkStore::Stats& bookmarks = sBookmarkStore.stats();
+            sLog.Log("server stats", "Bookmarks: %lu characters resident, %u loaded, %u lists and %u lookups served from memory (%u queried), %u deleted, %u moved.",
+                     (unsigned long)sBookmarkStore.size(), bookmarks.loads, bookmarks.lists, bookmarks.lookups, bookmarks.lookupMisses, bookmarks.deleted, bookmarks.moved );
+
+            const NotificationQueue::Stats& notifications = sNotificationQueue.stats();
+            sLog.Log("server stats", "Notifications: %u enqueued (max %u queued, %lu now), %u rows in %u inserts (%u failed), %u pushed in %u events, latency avg %.2f ms (max %.2f ms).",
+                     notifications.enqueued, notifications.maxDepth, (unsigned long)sNotificationQueue.GetDepth(), notifications.persisted, notifications.inserts, notifications.failures,
+                     notifications.pushed, notifications.pushes,
+                     notifications.delivered ? notifications.latency / 1000.0 / notifications.delivered : 0.0, notifications.maxLatency / 1000.0 );
+
+            size_t apiCacheEntries, apiCacheSize;
+            const APICacheManager::Stats api = sAPIServer.cache().GetStats( apiCacheEntries, apiCacheSize );
+            sLog.Log("server stats", "API cache: %u hits, %u misses (%u expired), %u deposits, %u evictions, %lu documents in %lu bytes.",
+                     api.hits, api.misses, api.expired, api.deposits, api.evictions, (unsigned long)apiCacheEntries, (unsigned long)apiCacheSize );
+
+            size_t imageCacheEntries, imageCacheSize;
+            sImageServer.GetCacheSize( imageCacheEntries, imageCacheSize );
+            const ImageServer::Stats& images = sImageServer.stats();
+            sLog.Log("server stats", "Image cache: %u hits, %u misses, %u sent from files, %u not modified, %u evictions, %lu images in %lu bytes.",
+                     images.hits, images.misses, images.cold, images.notModified, images.evictions, (unsigned long)imageCacheEntries, (unsigned long)imageCacheSize );
+
+            const ItemCache& items = item_factory.itemCache();
+            const ItemCache::Stats& itemStats = items.stats();
+            sLog.Log("server stats", "Items: %lu resident in ~%lu bytes, %u lookups hit, %u missed, %u evicted, %u skipped as referenced.",
+                     (unsigned long)items.size(), (unsigned long)items.bytes(), itemStats.hits, itemStats.misses, itemStats.evictions, itemStats.pinned );
+
+            std::string memory;
+            for( const MemoryTag* tag = MemoryTag::first(); NULL != tag; tag = tag->next() )
+            {
+                const MemoryTag::Stats tagStats = tag->GetStats();
+
+                char part[128];
+                snprintf( part, sizeof( part ), "%s%s %" PRId64 " KiB in %" PRId64 " objects", ( memory.empty() ? "" : ", " ),
+                          tag->name(), tagStats.liveBytes / 1024, tagStats.liveObjects );
+                memory += part;
+            }
+            sLog.Log("server stats", "Memory: %s.", memory.c_str() );
+
+            SystemPreloader& preloader = sEntityList.systemPreloader();
+            const SystemPreloader::Stats& preloads = preloader.stats();
+            sLog.Log("server stats", "System preloads: %u started, %u loaded in %u ms, %u failed, %u boots hit, %u missed, %u dropped, %lu ready.",
+                     preloads.requested, preloads.loaded, preloads.loadTime, preloads.failed, preloads.hits, preloads.misses, preloads.dropped, (unsigned long)preloader.GetReadyCount() );
+
+            const FittingEvaluator::Stats& fittings = sFittingEvaluator.stats();
+            sLog.Log("server stats", "Fittings: %u served from cache, %u computed in %.2f ms, %u evicted, %lu cached.",
+                     fittings.hits, fittings.evaluations, fittings.evaluateTime / 1000.0, fittings.evictions, (unsigned long)sFittingEvaluator.size() );
+
+            const SkillQueueSweeper::Stats& sweeps = skill_sweeper.stats();
+            sLog.Log("server stats", "Skill sweeps: %u run, %u offline characters advanced, %u failed.",
+                     sweeps.sweeps, sweeps.characters, sweeps.failed );
+
+            const ActiveModule::CycleStats& cycles = ActiveModule::cycleStats();
+            uint32 busiestGroupID = 0, busiestGroupCycles = 0;
+            std::map<uint32, uint32>::const_iterator cur, end;
+            cur = cycles.groupCycles.begin();
+            end = cycles.groupCycles.end();
+            for(; cur != end; ++cur)
+            {
+                if( busiestGroupCycles < cur->second )
+                {
+                    busiestGroupID = cur->first;
+                    busiestGroupCycles = cur->second;
+                }
+            }
+            sLog.Log("server stats", "Module cycles: %u activations, %u cycles in %lu module groups, busiest group %u with %u cycles.",
+                     cycles.activations, cycles.cycles, (unsigned long)cycles.groupCycles.size(), busiestGroupID, busiestGroupCycles );
+
+            EntityList::SystemTickStats ticks;
+            sEntityList.GetSystemTickStats( ticks );
+            sLog.Log("server stats", "Systems: %lu booted, %u ticks in %.2f ms (max %.2f ms), destiny %.2f ms (max %.2f ms), AI %u thinks in %.2f ms, busiest system %u with %.2f ms.",
+                     (unsigned long)ticks.systems, ticks.ticks, ticks.tickTime / 1000.0, ticks.maxTickTime / 1000.0,
+                     ticks.destinyTime / 1000.0, ticks.maxDestinyTime / 1000.0, ticks.aiThinks, ticks.aiTime / 1000.0,
+                     ticks.busiestSystemID, ticks.busiestTime / 1000.0 );
+
+            const Client::DestinyBudgetStats& budget = Client::destinyBudgetStats();
+            sLog.Log("server stats", "Destiny budget: %u updates held, %u merged, %u dropped, %u resyncs; %u superseded in bundles, %" PRIu64 " bytes saved; %u attribute changes, %u coalesced.",
+                     budget.held, budget.merged, budget.dropped, budget.resyncs, budget.superseded, budget.savedBytes,
+                     budget.attributeChanges, budget.attributesCoalesced );
+
+            const Client::SessionStats& sessions = Client::sessionStats();
+            sLog.Log("server stats", "Sessions: %u went idle, %u woke up, %u dead ones evicted; %u slow readers dropped since startup; %u session changes sent, %u updates coalesced into them.",
+                     sessions.idled, sessions.woken, sessions.evicted, TCPConnection::GetDroppedSlowReaders(), sessions.changes, sessions.coalesced );
+
+            const LSCChannel::MembershipStats& chat = LSCChannel::membershipStats();
+            sLog.Log("server stats", "Chat: %u joins and leaves broadcast at once, %u queued (%u cancelled out) in %u flushes; %u member lists encoded, %u reused.",
+                     chat.immediate, chat.queued, chat.coalesced, chat.flushes, chat.listEncodes, chat.listHits );
+
+            const NewLog::AsyncStats& logging = sLog.asyncStats();
+            sLog.Log("server stats", "Logging: %u messages queued, %u dropped, %u written in %u batches.",
+                     logging.queued, logging.dropped, logging.written, logging.batches );
+
+            const TickProfiler::Stats& profiler = sTickProfiler.stats();
+            sLog.Log("server stats", "Tick profiler: %u ticks, %u slow (max %.2f ms), %u zones recorded, %u dropped.",
+                     profiler.ticks, profiler.slowTicks, profiler.maxTickTime / 1000.0, profiler.zones, profiler.droppedZones );
+
+            const CallTracer::Stats& traces = sCallTracer.stats();
+            if( 0 < traces.finished )
+            {
+                std::string stages;
+                for( size_t i = 0; i < CallTrace::STAGE_COUNT; ++i )
+                {
+                    char stage[64];
+                    snprintf( stage, sizeof( stage ), "%s%s %.2f (max %.2f)", ( 0 < i ? ", " : "" ), CallTrace::STAGE_NAMES[ i ],
+                              traces.stageTime[ i ] / 1000.0 / traces.finished, traces.maxStageTime[ i ] / 1000.0 );
+                    stages += stage;
+                }
+
+                sLog.Log("server stats", "Call tracer: %u calls sampled, %u traced (avg %.2f ms, max %.2f ms), %u dropped; avg per stage (ms): %s.",
+                         traces.sampled, traces.finished, traces.totalTime / 1000.0 / traces.finished, traces.maxTotalTime / 1000.0,
+                         traces.dropped, stages.c_str() );
+            }
+
+            stats.Reset();
+            sTimerWheel.ResetStats();
+            sLog.ResetAsyncStats();
+            sTickProfiler.ResetStats();
+            sCallTracer.ResetStats();
+            sDatabase.ResetStats();
+            sInventoryWriteBehind.ResetStats();
+            sInventoryBatch.ResetStats();
+            sMarketOrderBook.ResetStats();
+            sMarketJournal.ResetStats();
+            sWalletLedger.ResetStats();
+            sContractBook.ResetStats();
+            sRamJobScheduler.ResetStats();
+            sNameIndex.ResetStats();
+            sEconomyCache.ResetStats();
+            sTradeDesk.ResetStats();
+            sAgentCatalogue.ResetStats();
+            sRouteMap.ResetStats();
+            sMapStatistics.ResetStats();
+            sSpawnTable.ResetStats();
+            sDungeonManager.ResetStats();
+            sStarbaseSimulator.ResetStats();
+            sPlanetSimulation.ResetStats();
+            sCorpRoster.ResetStats();
+            sPresence.ResetStats();
+            sFleetManager.ResetStats();
+            sStandingCache.ResetStats();
+            sHostilityResolver.ResetStats();
+            sSovereigntyTable.ResetStats();
+            sCharSelectCache.ResetStats();
+            sLoginAuthenticator.ResetStats();
+            sLoginPipeline.ResetStats();
+            sStationCache.ResetStats();
+            sMailStore.ResetStats();
+            sBookmarkStore.ResetStats();
+            sCharCreationTemplates.ResetStats();
+            sPaperDollStore.ResetStats();
+            sCertificateGraph.ResetStats();
+            sClusterMap.ResetStats();
+            sJumpPipeline.ResetStats();
+            sOwnerDirectory.ResetStats();
+            sTextStore.ResetStats();
+            sTutorialStore.ResetStats();
+            sClientTelemetry.ResetStats();
+            sPacketTrace.ResetStats();
+            sNotificationQueue.ResetStats();
+            sAPIServer.cache().ResetStats();
+            sImageServer.ResetStats();
+            preloader.ResetStats();
+            skill_sweeper.ResetStats();
+            sFittingEvaluator.ResetStats();
+            item_factory.ResetItemCacheStats();
+            //move a hot system off its node by the time the systems took since the last stats
+            std::map<uint32, uint64> systemTimes;
+            sEntityList.GetSystemTimes( systemTimes );
+            sClusterMap.Rebalance( systemTimes );
+            sEntityList.ResetSystemTickStats();
+            Client::ResetDestinyBudgetStats();
+            Client::ResetSessionStats();
+            ActiveModule::ResetCycleStats();
+            LSCChannel::ResetMembershipStats();
+            stats_time = last_time;
+        }
+
+        // check the idle database connections
+        if( 0 < sConfig.database.pingInterval
+            && sConfig.database.pingInterval * 1000 <= last_time - ping_time )
+        {
+            sDatabase.ping();
+            ping_time = last_time;
+        }
+
+        // check how far behind the read replicas are
+        if( !sConfig.database.replicas.empty() && 0 < sConfig.database.lagCheckInterval
+            && sConfig.database.lagCheckInterval * 1000 <= last_time - lag_time )
+        {
+            sDatabase.CheckReplicas( sConfig.database.maxReplicaLag );
+            lag_time = last_time;
+        }
+
         // do the stuff for thread sleeping
-        if( MAIN_LOOP_DELAY > etime )
-            Sleep( MAIN_LOOP_DELAY - etime );
+        if( sConfig.loop.eventDriven )
+        {
+            // sleep until an I/O thread wakes us or the earliest timer expires
+            uint32 wait = Timer::GetTimeToNextDeadline();
+            wait = std::min( wait, sTimerWheel.GetTimeToNextExpiry() );
+            wait = ( wait > etime ? wait - etime : 0 );
+            if( wait > sConfig.loop.maxIdleTime )
+                wait = sConfig.loop.maxIdleTime;
+
+            woken = ( 0 < wait && mainLoopEvent.Wait( wait ) );
+        }
+        else
+        {
+            woken = false;
+
+            if( MAIN_LOOP_DELAY > etime )
+                Sleep( MAIN_LOOP_DELAY - etime );
+        }
+
+        stats.idleTime += GetTickCount() - last_time;
     }
 
     sLog.Log("server shutdown", "Main loop stopped" );
 
+    // Writing the booted solar systems, busiest first
+    if( 0 != warm_start.GetChecksum() )
+    {
+        std::map<uint32, uint64> systemTimes;
+        sEntityList.GetSystemTimes( systemTimes );
+
+        std::vector< std::pair<uint64, uint32> > busiest;
+        std::map<uint32, uint64>::const_iterator cur, end;
+        cur = systemTimes.begin();
+        end = systemTimes.end();
+        for(; cur != end; cur++)
+            busiest.push_back( std::make_pair( cur->second, cur->first ) );
+        std::sort( busiest.rbegin(), busiest.rend() );
+
+        std::vector<uint32> systemIDs;
+        for( size_t i = 0; i < busiest.size(); i++ )
+            systemIDs.push_back( busiest[ i ].second );
+
+        if( warm_start.Save( sConfig.files.warmStart.c_str(), systemIDs ) )
+            sLog.Log("server shutdown", "%lu booted solar systems written to %s.", (unsigned long)systemIDs.size(), sConfig.files.warmStart.c_str() );
+        else
+            sLog.Error("server shutdown", "Failed to write the booted solar systems to %s.", sConfig.files.warmStart.c_str() );
+    }
+
+    // Writing the static data snapshot the start could not use
+    if( staticDataStale )
+    {
+        if( BuildStaticDataSnapshot( sConfig.files.staticDataSnapshot.c_str() ) )
+            sLog.Log("server shutdown", "Static data snapshot written to %s.", sConfig.files.staticDataSnapshot.c_str() );
+        else
+            sLog.Error("server shutdown", "Failed to write the static data snapshot to %s.", sConfig.files.staticDataSnapshot.c_str() );
+    }
+
+    // Handing the queued client telemetry over to the threads
+    sClientTelemetry.Flush();
+
+    // Completing and stopping asynchronous query threads
+    sDBAsync.SetNotifyEvent( NULL );
+    sDBAsync.Stop();
+    sLog.Log("server shutdown", "Asynchronous query threads stopped." );
+
+    // Writing the queued item and attribute saves
+    sInventoryWriteBehind.Flush();
+    sLog.Log("server shutdown", "Queued item saves written." );
+
+    // Writing the journaled trades
+    if( sMarketJournal.Flush() )
+        sLog.Log("server shutdown", "Market journal written." );
+
+    // Flushing and stopping packet encoder threads
+    sEncoderPool.Stop();
+    sLog.Log("server shutdown", "Packet encoder threads stopped." );
+
     // Shutting down EVE Client TCP listener
     tcps.Close();
     sLog.Log("server shutdown", "TCP listener stopped." );
 
+    // Shutting down network I/O threads
+    sTCPReactor.Stop();
+    sLog.Log("server shutdown", "Network I/O threads stopped." );
+
     // Shutting down API Server:
     sAPIServer.Stop();
     sLog.Log("server shutdown", "Image Server TCP listener stopped." );
@@ -402,6 +1332,9 @@ int main( int argc, char* argv[] )
     sLog.Log("server shutdown", "Cleanup db cache" );
     delete _sDgmTypeAttrMgr;
 
+    // Writing the queued log messages
+    sLog.StopAsync();
+
     log_close_logfile();
 
     std::cout << std::endl << "press the ENTER key to exit...";  std::cin.get();
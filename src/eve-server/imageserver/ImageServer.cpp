@@ -40,7 +40,17 @@ const char *const ImageServer::Categories[] = {
 
 const uint32 ImageServer::CategoryCount = 5;
 
+/// Largest share of the cache a single image may take (1/n).
+static const size_t IMAGE_CACHE_MAX_SHARE = 16;
+/// Number of paths requested once which are remembered; the older ones are forgotten.
+static const size_t IMAGE_REQUESTED_LIMIT = 16384;
+
+/// The images uploaded for characters not created yet.
+static MemoryTag sLimboMemoryTag( "image limbo" );
+
 ImageServer::ImageServer()
+: _cacheBytes(0),
+  _cacheLimit(sConfig.net.imageCacheSize)
 {
     std::stringstream urlBuilder;
     urlBuilder << "http://" << sConfig.net.imageServer << ":" << (sConfig.net.imageServerPort) << "/";
@@ -67,10 +77,12 @@ void ImageServer::ReportNewImage(uint32 accountID, std::tr1::shared_ptr<std::vec
 {
     Lock lock(_limboLock);
 
+    // the first image of the account is kept
     if (_limboImages.find(accountID) != _limboImages.end())
-        _limboImages.insert(std::pair<uint32,std::tr1::shared_ptr<std::vector<char> > >(accountID, imageData));
-    else
-        _limboImages[accountID] = imageData;
+        return;
+
+    _limboImages[accountID] = imageData;
+    sLimboMemoryTag.Retain(imageData->size());
 }
 
 void ImageServer::ReportNewCharacter(uint32 creatorAccountID, uint32 characterID)
@@ -99,42 +111,165 @@ void ImageServer::ReportNewCharacter(uint32 creatorAccountID, uint32 characterID
 
     // and delete it from our limbo map
     _limboImages.erase(creatorAccountID);
+    sLimboMemoryTag.Release(data->size());
+
+    // a new character may reuse the ID of a deleted one
+    {
+        Lock cacheLock(_cacheLock);
+        _Uncache(path);
+    }
 
     sLog.Log("image server", "saved image from %i as %s", creatorAccountID, path.c_str());
 }
 
-std::tr1::shared_ptr<std::vector<char> > ImageServer::GetImage(std::string& category, uint32 id, uint32 size)
+bool ImageServer::GetImage(std::string& category, uint32 id, uint32 size, Image& into)
 {
     if (!ValidateCategory(category) || !ValidateSize(category, size))
-        return std::tr1::shared_ptr<std::vector<char> >();
+        return false;
 
-    //std::ifstream stream;
     std::string path(GetFilePath(category, id, size));
-    FILE * fp = fopen(path.c_str(), "rb");
+
+    // the file may have been replaced since it was cached
+    struct stat st;
+    if (stat(path.c_str(), &st) != 0)
+        return false;
+
+    char etag[64];
+    snprintf(etag, sizeof(etag), "\"%lx-%lx\"", (unsigned long)st.st_size, (unsigned long)st.st_mtime);
+
+    {
+        Lock lock(_cacheLock);
+
+        std::tr1::unordered_map<std::string, CacheEntry>::iterator res = _cache.find(path);
+        if (res != _cache.end())
+        {
+            if (res->second.image.etag == etag)
+            {
+                _cacheLru.splice(_cacheLru.begin(), _cacheLru, res->second.lru);
+                into = res->second.image;
+
+                AtomicAdd(&_stats.hits, 1);
+                return true;
+            }
+
+            _Uncache(path);
+        }
+
+        into.data.reset();
+        into.path = path;
+        into.size = (size_t)st.st_size;
+        into.lastModified = FormatHttpDate(st.st_mtime);
+        into.etag = etag;
+
+        // only the images requested before are worth the memory
+        if (_cacheLimit == 0 || _cacheLimit / IMAGE_CACHE_MAX_SHARE < into.size || _requested.insert(path).second)
+        {
+            if (IMAGE_REQUESTED_LIMIT < _requested.size())
+                _requested.clear();
+
+            AtomicAdd(&_stats.cold, 1);
+            return true;
+        }
+
+        _requested.erase(path);
+    }
+
+    // read it outside of the lock
+    into.data = ReadImage(into);
+    if (!into.data)
+        return false;
+
+    AtomicAdd(&_stats.misses, 1);
+
+    Lock lock(_cacheLock);
+
+    // another connection may have cached it meanwhile
+    if (_cache.find(path) != _cache.end())
+        return true;
+
+    _cacheLru.push_front(path);
+    CacheEntry& entry = _cache[path];
+    entry.image = into;
+    entry.lru = _cacheLru.begin();
+    _cacheBytes += into.size;
+
+    while (_cacheLimit < _cacheBytes)
+    {
+        const std::string victim = _cacheLru.back();
+        _Uncache(victim);
+
+        AtomicAdd(&_stats.evictions, 1);
+    }
+
+    return true;
+}
+
+std::tr1::shared_ptr<std::vector<char> > ImageServer::ReadImage(const Image& image)
+{
+    FILE * fp = fopen(image.path.c_str(), "rb");
     if (fp == NULL)
         return std::tr1::shared_ptr<std::vector<char> >();
-    fseek(fp, 0, SEEK_END);
-    size_t length = ftell(fp);
-    fseek(fp, 0, SEEK_SET);
 
-    //stream.open(path, std::ios::binary | std::ios::in);
-    // not found or other error
-    //if (stream.fail())
-    //    return std::tr1::shared_ptr<std::vector<char> >();
+    std::tr1::shared_ptr<std::vector<char> > ret(new std::vector<char>(image.size));
+    const size_t length = (0 < image.size ? fread(&((*ret)[0]), 1, image.size, fp) : 0);
+    fclose(fp);
+
+    // the file changed since it was looked at
+    if (length != image.size)
+        return std::tr1::shared_ptr<std::vector<char> >();
+
+    return ret;
+}
 
-    // get length
-    //stream.seekg(0, std::ios::end);
-    //int length = stream.tellg();
-    //stream.seekg(0, std::ios::beg);
+std::string ImageServer::FormatHttpDate(time_t time)
+{
+    static const char *const days[] = { "Thu", "Fri", "Sat", "Sun", "Mon", "Tue", "Wed" };
+    static const char *const months[] = { "Jan", "Feb", "Mar", "Apr", "May", "Jun", "Jul", "Aug", "Sep", "Oct", "Nov", "Dec" };
+
+    // gmtime() is not reentrant, so convert the days since the epoch to the date by hand
+    const int64 seconds = (int64)time;
+    int64 days_since = seconds / 86400;
+    int64 rest = seconds % 86400;
+    if (rest < 0)
+    {
+        rest += 86400;
+        days_since -= 1;
+    }
 
-    std::tr1::shared_ptr<std::vector<char> > ret = std::tr1::shared_ptr<std::vector<char> >(new std::vector<char>());
-    ret->resize(length);
+    const int64 z = days_since + 719468;
+    const int64 era = (0 <= z ? z : z - 146096) / 146097;
+    const int64 doe = z - era * 146097;
+    const int64 yoe = (doe - doe / 1460 + doe / 36524 - doe / 146096) / 365;
+    const int64 doy = doe - (365 * yoe + yoe / 4 - yoe / 100);
+    const int64 mp = (5 * doy + 2) / 153;
+    const int day = (int)(doy - (153 * mp + 2) / 5 + 1);
+    const int month = (int)(mp < 10 ? mp + 3 : mp - 9);
+    const int year = (int)(yoe + era * 400 + (month <= 2 ? 1 : 0));
+
+    char date[32];
+    snprintf(date, sizeof(date), "%s, %02d %s %04d %02d:%02d:%02d GMT",
+             days[((days_since % 7) + 7) % 7], day, months[month - 1], year,
+             (int)(rest / 3600), (int)(rest / 60 % 60), (int)(rest % 60));
+    return date;
+}
 
-    // HACK
-    //stream.read(&((*ret)[0]), length);
-    fread(&((*ret)[0]), 1, length, fp);
+void ImageServer::GetCacheSize(size_t& entries, size_t& bytes)
+{
+    Lock lock(_cacheLock);
 
-    return ret;
+    entries = _cache.size();
+    bytes = _cacheBytes;
+}
+
+void ImageServer::_Uncache(const std::string& path)
+{
+    std::tr1::unordered_map<std::string, CacheEntry>::iterator res = _cache.find(path);
+    if (res == _cache.end())
+        return;
+
+    _cacheBytes -= res->second.image.size;
+    _cacheLru.erase(res->second.lru);
+    _cache.erase(res);
 }
 
 std::string ImageServer::GetFilePath(std::string& category, uint32 id, uint32 size)
@@ -179,20 +314,28 @@ std::string& ImageServer::url()
 
 void ImageServer::Run()
 {
-    _ioThread = std::auto_ptr<boost::asio::detail::thread>(new boost::asio::detail::thread(std::tr1::bind(&ImageServer::RunInternal, this)));
+    _io = std::auto_ptr<boost::asio::io_service>(new boost::asio::io_service());
+    _listener = std::auto_ptr<ImageServerListener>(new ImageServerListener(*_io));
+
+    const uint32 ioThreads = std::max<uint32>(sConfig.net.imageIoThreads, 1);
+    for (uint32 i = 0; i < ioThreads; i++)
+        _ioThreads.push_back(ThreadPtr(new boost::asio::detail::thread(std::tr1::bind(&ImageServer::RunService, _io.get()))));
 }
 
 void ImageServer::Stop()
 {
+    if (_io.get() == NULL)
+        return;
+
     _io->stop();
-    _ioThread->join();
+    for (size_t i = 0; i < _ioThreads.size(); i++)
+        _ioThreads[i]->join();
+    _ioThreads.clear();
 }
 
-void ImageServer::RunInternal()
+void ImageServer::RunService(boost::asio::io_service* io)
 {
-    _io = std::auto_ptr<boost::asio::io_service>(new boost::asio::io_service());
-    _listener = std::auto_ptr<ImageServerListener>(new ImageServerListener(*_io));
-    _io->run();
+    io->run();
 }
 
 ImageServer::Lock::Lock(boost::asio::detail::mutex& mutex)
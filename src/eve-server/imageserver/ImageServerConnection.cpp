@@ -28,14 +28,31 @@
 #include "imageserver/ImageServer.h"
 #include "imageserver/ImageServerConnection.h"
 
-boost::asio::const_buffers_1 ImageServerConnection::_responseOK = boost::asio::buffer("HTTP/1.0 200 OK\r\nContent-Type: image/jpeg\r\n\r\n", 45);
+#ifdef HAVE_SYS_SENDFILE_H
+#   include <fcntl.h>
+#   include <sys/sendfile.h>
+#endif /* HAVE_SYS_SENDFILE_H */
+
 boost::asio::const_buffers_1 ImageServerConnection::_responseNotFound = boost::asio::buffer("HTTP/1.0 404 Not Found\r\n\r\n", 26);
 boost::asio::const_buffers_1 ImageServerConnection::_responseRedirectBegin = boost::asio::buffer("HTTP/1.0 301 Moved Permanently\r\nLocation: ", 42);
 boost::asio::const_buffers_1 ImageServerConnection::_responseRedirectEnd = boost::asio::buffer("\r\n\r\n", 4);
 
 ImageServerConnection::ImageServerConnection(boost::asio::io_service& io)
-    : _socket(io)
+    : _socket(io),
+      _strand(io)
+#ifdef HAVE_SYS_SENDFILE_H
+      , _fd(-1),
+      _offset(0)
+#endif /* HAVE_SYS_SENDFILE_H */
+{
+}
+
+ImageServerConnection::~ImageServerConnection()
 {
+#ifdef HAVE_SYS_SENDFILE_H
+    if (_fd >= 0)
+        close(_fd);
+#endif /* HAVE_SYS_SENDFILE_H */
 }
 
 boost::asio::ip::tcp::socket& ImageServerConnection::socket()
@@ -46,7 +63,7 @@ boost::asio::ip::tcp::socket& ImageServerConnection::socket()
 void ImageServerConnection::Process()
 {
     // receive all HTTP headers from the client
-    boost::asio::async_read_until(_socket, _buffer, "\r\n\r\n", std::tr1::bind(&ImageServerConnection::ProcessHeaders, shared_from_this()));
+    boost::asio::async_read_until(_socket, _buffer, "\r\n\r\n", _strand.wrap(std::tr1::bind(&ImageServerConnection::ProcessHeaders, shared_from_this())));
 }
 
 void ImageServerConnection::ProcessHeaders()
@@ -101,30 +118,150 @@ void ImageServerConnection::ProcessHeaders()
     _id = atoi(idStr.c_str());
     _size = atoi(sizeStr.c_str());
 
-    _imageData = sImageServer.GetImage(_category, _id, _size);
-    if (!_imageData)
+    if (!sImageServer.GetImage(_category, _id, _size, _image))
     {
         Redirect();
         return;
     }
 
-    // first we have to send the responseOK, then our actual result
-    boost::asio::async_write(_socket, _responseOK, boost::asio::transfer_all(), std::tr1::bind(&ImageServerConnection::SendImage, shared_from_this()));
+    // the client may have the image already; the dates are compared as sent by us
+    ParseConditions(stream);
+    if (_ifNoneMatch.empty() ? (!_ifModifiedSince.empty() && _ifModifiedSince == _image.lastModified)
+                             : (_ifNoneMatch == _image.etag || _ifNoneMatch == "*"))
+    {
+        NotModified();
+        return;
+    }
+
+    SendImage();
+}
+
+void ImageServerConnection::ParseConditions(std::istream& stream)
+{
+    std::string line;
+    while (std::getline(stream, line))
+    {
+        if (!line.empty() && line[line.size() - 1] == '\r')
+            line.erase(line.size() - 1);
+
+        const size_t colon = line.find(':');
+        if (colon == std::string::npos)
+            continue;
+
+        std::string name = line.substr(0, colon);
+        std::transform(name.begin(), name.end(), name.begin(), tolower);
+
+        const size_t start = line.find_first_not_of(' ', colon + 1);
+        const std::string value = (start == std::string::npos ? std::string() : line.substr(start));
+
+        if (name == "if-none-match")
+            _ifNoneMatch = value;
+        else if (name == "if-modified-since")
+            _ifModifiedSince = value;
+    }
 }
 
 void ImageServerConnection::SendImage()
 {
-    boost::asio::async_write(_socket, boost::asio::buffer(*_imageData, _imageData->size()), boost::asio::transfer_all(), std::tr1::bind(&ImageServerConnection::Close, shared_from_this()));
+    std::stringstream header;
+    header << "HTTP/1.0 200 OK\r\n"
+              "Content-Type: " << (_category == "Character" ? "image/jpeg" : "image/png") << "\r\n"
+              "Content-Length: " << _image.size << "\r\n"
+              "Last-Modified: " << _image.lastModified << "\r\n"
+              "ETag: " << _image.etag << "\r\n"
+              "\r\n";
+    _header = header.str();
+
+    if (!_image.data)
+    {
+        // send the headers, then the file
+        boost::asio::async_write(_socket, boost::asio::buffer(_header), boost::asio::transfer_all(), _strand.wrap(std::tr1::bind(&ImageServerConnection::SendFile, shared_from_this())));
+        return;
+    }
+
+    // the headers and the cached image in one go, without copying the image
+    std::vector<boost::asio::const_buffer> buffers;
+    buffers.push_back(boost::asio::buffer(_header));
+    buffers.push_back(boost::asio::buffer(*_image.data));
+    boost::asio::async_write(_socket, buffers, boost::asio::transfer_all(), _strand.wrap(std::tr1::bind(&ImageServerConnection::Close, shared_from_this())));
+}
+
+void ImageServerConnection::SendFile()
+{
+#ifdef HAVE_SYS_SENDFILE_H
+    if (_fd < 0)
+    {
+        _fd = open(_image.path.c_str(), O_RDONLY);
+        if (_fd < 0)
+        {
+            Close();
+            return;
+        }
+
+        // sendfile() must not block the I/O thread; asio ignores SIGPIPE for us
+        boost::system::error_code ec;
+        _socket.native_non_blocking(true, ec);
+        if (ec)
+        {
+            Close();
+            return;
+        }
+    }
+
+    while ((size_t)_offset < _image.size)
+    {
+        const ssize_t sent = sendfile(_socket.native_handle(), _fd, &_offset, _image.size - (size_t)_offset);
+        if (0 < sent)
+            continue;
+        if (sent < 0 && errno == EINTR)
+            continue;
+
+        if (sent < 0 && (errno == EAGAIN || errno == EWOULDBLOCK))
+        {
+            // wait until the socket takes more
+            _socket.async_write_some(boost::asio::null_buffers(), _strand.wrap(std::tr1::bind(&ImageServerConnection::SendFile, shared_from_this())));
+            return;
+        }
+
+        // the client is gone or the file got shorter
+        break;
+    }
+
+    Close();
+#else /* !HAVE_SYS_SENDFILE_H */
+    _image.data = ImageServer::ReadImage(_image);
+    if (!_image.data)
+    {
+        Close();
+        return;
+    }
+
+    boost::asio::async_write(_socket, boost::asio::buffer(*_image.data), boost::asio::transfer_all(), _strand.wrap(std::tr1::bind(&ImageServerConnection::Close, shared_from_this())));
+#endif /* !HAVE_SYS_SENDFILE_H */
+}
+
+void ImageServerConnection::NotModified()
+{
+    sImageServer.CountNotModified();
+
+    std::stringstream header;
+    header << "HTTP/1.0 304 Not Modified\r\n"
+              "Last-Modified: " << _image.lastModified << "\r\n"
+              "ETag: " << _image.etag << "\r\n"
+              "\r\n";
+    _header = header.str();
+
+    boost::asio::async_write(_socket, boost::asio::buffer(_header), boost::asio::transfer_all(), _strand.wrap(std::tr1::bind(&ImageServerConnection::Close, shared_from_this())));
 }
 
 void ImageServerConnection::NotFound()
 {
-    boost::asio::async_write(_socket, _responseNotFound, boost::asio::transfer_all(), std::tr1::bind(&ImageServerConnection::Close, shared_from_this()));
+    boost::asio::async_write(_socket, _responseNotFound, boost::asio::transfer_all(), _strand.wrap(std::tr1::bind(&ImageServerConnection::Close, shared_from_this())));
 }
 
 void ImageServerConnection::Redirect()
 {
-    boost::asio::async_write(_socket, _responseRedirectBegin, boost::asio::transfer_all(), std::tr1::bind(&ImageServerConnection::RedirectLocation, shared_from_this()));
+    boost::asio::async_write(_socket, _responseRedirectBegin, boost::asio::transfer_all(), _strand.wrap(std::tr1::bind(&ImageServerConnection::RedirectLocation, shared_from_this())));
 }
 
 void ImageServerConnection::RedirectLocation()
@@ -133,12 +270,12 @@ void ImageServerConnection::RedirectLocation()
     std::stringstream url;
     url << ImageServer::FallbackURL << _category << "/" << _id << "_" << _size << "." << extension;
     _redirectUrl = url.str();
-    boost::asio::async_write(_socket, boost::asio::buffer(_redirectUrl), boost::asio::transfer_all(), std::tr1::bind(&ImageServerConnection::RedirectFinalize, shared_from_this()));
+    boost::asio::async_write(_socket, boost::asio::buffer(_redirectUrl), boost::asio::transfer_all(), _strand.wrap(std::tr1::bind(&ImageServerConnection::RedirectFinalize, shared_from_this())));
 }
 
 void ImageServerConnection::RedirectFinalize()
 {
-    boost::asio::async_write(_socket, _responseRedirectEnd, boost::asio::transfer_all(), std::tr1::bind(&ImageServerConnection::Close, shared_from_this()));
+    boost::asio::async_write(_socket, _responseRedirectEnd, boost::asio::transfer_all(), _strand.wrap(std::tr1::bind(&ImageServerConnection::Close, shared_from_this())));
 }
 
 void ImageServerConnection::Close()
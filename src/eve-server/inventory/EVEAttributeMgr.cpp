@@ -30,6 +30,7 @@
 #include "inventory/EVEAttributeMgr.h"
 #include "inventory/InventoryDB.h"
 #include "inventory/InventoryItem.h"
+#include "inventory/InventoryWriteBehind.h"
 
 /*
  * EVEAttributeMgr
@@ -337,7 +338,7 @@ void ItemAttributeMgr::_SendAttributeChange(Attr attr, PyRep *oldValue, PyRep *n
         omac.newValue = newValue;
 
         PyTuple* tmp = omac.Encode();
-        c->QueueDestinyEvent(&tmp);
+        c->QueueAttributeChange(&tmp, m_item.itemID(), attr);
     }
     else
     {
@@ -350,19 +351,108 @@ void ItemAttributeMgr::_SendAttributeChange(Attr attr, PyRep *oldValue, PyRep *n
 /************************************************************************/
 /* Start of new attribute system                                        */
 /************************************************************************/
-AttributeMap::AttributeMap( InventoryItem & item ) : mItem(item), mChanged(false)
+/* the presence and int masks hold one bit per dense slot */
+typedef char HotAttributeCountCheck[ AttributeMap::HOT_ATTRIBUTE_COUNT <= 32 ? 1 : -1 ];
+
+/* every dense attribute has an ID below this, others go to the map regardless */
+static const uint32 HOT_ATTRIBUTE_LOOKUP_SIZE = 1024;
+
+/* attribute ID of each dense slot */
+static const uint32 sHotAttributeIDs[ AttributeMap::HOT_ATTRIBUTE_COUNT ] =
+{
+#define HOT_ATTR( attributeID ) attributeID,
+#include "inventory/EVEHotAttributes.h"
+};
+
+class HotAttributeLookup
+{
+public:
+    HotAttributeLookup()
+    {
+        for( uint32 i = 0; i < HOT_ATTRIBUTE_LOOKUP_SIZE; ++i )
+            mSlots[ i ] = AttributeMap::HOT_ATTRIBUTE_COUNT;
+        for( uint32 i = 0; i < AttributeMap::HOT_ATTRIBUTE_COUNT; ++i )
+        {
+            assert( sHotAttributeIDs[ i ] < HOT_ATTRIBUTE_LOOKUP_SIZE );
+            mSlots[ sHotAttributeIDs[ i ] ] = (uint8)i;
+        }
+    }
+
+    uint32 operator[]( uint32 attributeID ) const
+    {
+        return attributeID < HOT_ATTRIBUTE_LOOKUP_SIZE ? mSlots[ attributeID ] : AttributeMap::HOT_ATTRIBUTE_COUNT;
+    }
+
+protected:
+    uint8 mSlots[ HOT_ATTRIBUTE_LOOKUP_SIZE ];
+};
+
+static const HotAttributeLookup sHotAttributeLookup;
+
+uint32 AttributeMap::_GetHotSlot( uint32 attributeID )
+{
+    return sHotAttributeLookup[ attributeID ];
+}
+
+AttributeMap::AttributeMap( InventoryItem & item ) : mItem(item), mHotPresent(0), mHotInt(0), mHotDirty(0)
 {
     // load the initial attributes for this item
     //Load();
 }
 
+EvilNumber AttributeMap::_GetHotNumber( uint32 slot ) const
+{
+    if( mHotInt & ( 1u << slot ) )
+        return EvilNumber( (int64)mHotValues[ slot ] );
+    return EvilNumber( mHotValues[ slot ] );
+}
+
 bool AttributeMap::SetAttribute( uint32 attributeId, EvilNumber &num, bool nofity /*= true*/ )
 {
+    const uint32 slot = _GetHotSlot( attributeId );
+    if( slot < HOT_ATTRIBUTE_COUNT )
+    {
+        const uint32 bit = 1u << slot;
+        const bool isInt = ( num.get_type() == evil_number_int );
+
+        if( !( mHotPresent & bit ) )
+        {
+            mHotValues[ slot ] = num.get_float();
+            mHotPresent |= bit;
+            if( isInt )
+                mHotInt |= bit;
+            else
+                mHotInt &= ~bit;
+            mHotDirty |= bit;
+
+            if (nofity == true)
+                return Add(attributeId, num);
+            return true;
+        }
+
+        EvilNumber old_val = _GetHotNumber( slot );
+        if (old_val == num)
+            return false;
+
+        if (nofity == true)
+            if (!Change(attributeId, old_val, num))
+                return false;
+
+        mHotValues[ slot ] = num.get_float();
+        if( isInt )
+            mHotInt |= bit;
+        else
+            mHotInt &= ~bit;
+        mHotDirty |= bit;
+        return true;
+    }
+
     AttrMapItr itr = mAttributes.find(attributeId);
 
     /* most attribute have default value's which are related to the item type */
     if (itr == mAttributes.end()) {
         mAttributes.insert(std::make_pair(attributeId, num));
+        mDirty.insert(attributeId);
         if (nofity == true)
             return Add(attributeId, num);
         return true;
@@ -379,85 +469,90 @@ bool AttributeMap::SetAttribute( uint32 attributeId, EvilNumber &num, bool nofit
             return false;
 
     itr->second = num;
+    mDirty.insert(attributeId);
     return true;
 }
 
+void AttributeMap::_ReportMissing( uint32 attributeId ) const
+{
+    // ONLY output ERROR message for a "missing" attributeID if it is not in the list of commonly "not found" attributes:
+    switch( attributeId )
+    {
+        case AttrRequiredSkill2:
+        case AttrRequiredSkill3:
+        case AttrRequiredSkill4:
+        case AttrRequiredSkill5:
+        case AttrRequiredSkill6:
+        case AttrCanFitShipGroup1:
+        case AttrCanFitShipGroup2:
+        case AttrCanFitShipGroup3:
+        case AttrCanFitShipGroup4:
+        case AttrCanFitShipType1:
+        case AttrCanFitShipType2:
+        case AttrCanFitShipType3:
+        case AttrCanFitShipType4:
+        case AttrSubSystemSlot:
+            // DO NOT OUTPUT AN ERROR ON THESE MISSING ATTRIBUTES SINCE THEY ARE COMMONLY "MISSING" FROM MANY ITEMS
+            break;
+
+        default:
+            sLog.Error("AttributeMap::GetAttribute()", "unable to find attribute: %u for item %u, '%s' of type %u", attributeId, mItem.itemID(), mItem.itemName().c_str(), mItem.typeID());
+            break;
+    }
+}
+
 EvilNumber AttributeMap::GetAttribute( uint32 attributeId )
 {
-    AttrMapItr itr = mAttributes.find(attributeId);
-    if (itr != mAttributes.end()) {
-        return itr->second;
+    return static_cast<const AttributeMap*>( this )->GetAttribute( attributeId );
+}
+
+EvilNumber AttributeMap::GetAttribute( const uint32 attributeId ) const
+{
+    const uint32 slot = _GetHotSlot( attributeId );
+    if( slot < HOT_ATTRIBUTE_COUNT )
+    {
+        if( mHotPresent & ( 1u << slot ) )
+            return _GetHotNumber( slot );
     }
     else
     {
-        // ONLY output ERROR message for a "missing" attributeID if it is not in the list of commonly "not found" attributes:
-        switch( attributeId )
-        {
-            case AttrRequiredSkill2:
-            case AttrRequiredSkill3:
-            case AttrRequiredSkill4:
-            case AttrRequiredSkill5:
-            case AttrRequiredSkill6:
-            case AttrCanFitShipGroup1:
-            case AttrCanFitShipGroup2:
-            case AttrCanFitShipGroup3:
-            case AttrCanFitShipGroup4:
-            case AttrCanFitShipType1:
-            case AttrCanFitShipType2:
-            case AttrCanFitShipType3:
-            case AttrCanFitShipType4:
-            case AttrSubSystemSlot:
-                // DO NOT OUTPUT AN ERROR ON THESE MISSING ATTRIBUTES SINCE THEY ARE COMMONLY "MISSING" FROM MANY ITEMS
-                break;
-
-            default:
-                sLog.Error("AttributeMap::GetAttribute()", "unable to find attribute: %u for item %u, '%s' of type %u", attributeId, mItem.itemID(), mItem.itemName().c_str(), mItem.typeID());
-                break;
-        }
-
-        return EvilNumber(0);
+        AttrMapConstItr itr = mAttributes.find(attributeId);
+        if (itr != mAttributes.end())
+            return itr->second;
     }
+
+    _ReportMissing( attributeId );
+    return EvilNumber(0);
 }
 
-EvilNumber AttributeMap::GetAttribute( const uint32 attributeId ) const
+double AttributeMap::GetAttributeValue( uint32 attributeId ) const
 {
-    AttrMapConstItr itr = mAttributes.find(attributeId);
-    if (itr != mAttributes.end()) {
-        return itr->second;
+    const uint32 slot = _GetHotSlot( attributeId );
+    if( slot < HOT_ATTRIBUTE_COUNT )
+    {
+        if( mHotPresent & ( 1u << slot ) )
+            return mHotValues[ slot ];
     }
     else
     {
-        // ONLY output ERROR message for a "missing" attributeID if it is not in the list of commonly "not found" attributes:
-        switch( attributeId )
+        AttrMapConstItr itr = mAttributes.find(attributeId);
+        if (itr != mAttributes.end())
         {
-            case AttrRequiredSkill2:
-            case AttrRequiredSkill3:
-            case AttrRequiredSkill4:
-            case AttrRequiredSkill5:
-            case AttrRequiredSkill6:
-            case AttrCanFitShipGroup1:
-            case AttrCanFitShipGroup2:
-            case AttrCanFitShipGroup3:
-            case AttrCanFitShipGroup4:
-            case AttrCanFitShipType1:
-            case AttrCanFitShipType2:
-            case AttrCanFitShipType3:
-            case AttrCanFitShipType4:
-            case AttrSubSystemSlot:
-                // DO NOT OUTPUT AN ERROR ON THESE MISSING ATTRIBUTES SINCE THEY ARE COMMONLY "MISSING" FROM MANY ITEMS
-                break;
-
-            default:
-                sLog.Error("AttributeMap::GetAttribute()", "unable to find attribute: %u for item %u, '%s' of type %u", attributeId, mItem.itemID(), mItem.itemName().c_str(), mItem.typeID());
-                break;
+            EvilNumber value = itr->second;
+            return value.get_float();
         }
-
-        return EvilNumber(0);
     }
+
+    _ReportMissing( attributeId );
+    return 0.0;
 }
 
 bool AttributeMap::HasAttribute(uint32 attributeID)
 {
+    const uint32 slot = _GetHotSlot( attributeID );
+    if( slot < HOT_ATTRIBUTE_COUNT )
+        return ( mHotPresent & ( 1u << slot ) ) != 0;
+
     AttrMapConstItr itr = mAttributes.find(attributeID);
     if (itr != mAttributes.end())
         return true;
@@ -467,22 +562,21 @@ bool AttributeMap::HasAttribute(uint32 attributeID)
 
 bool AttributeMap::Change( uint32 attributeID, EvilNumber& old_val, EvilNumber& new_val )
 {
-    mChanged = true;
     PyTuple* AttrChange = new PyTuple(7);
     AttrChange->SetItem(0, new PyString("OnModuleAttributeChange"));
     AttrChange->SetItem(1, new PyInt(mItem.ownerID()));
     AttrChange->SetItem(2, new PyInt(mItem.itemID()));
     AttrChange->SetItem(3, new PyInt(attributeID));
     AttrChange->SetItem(4, new PyLong(Win32TimeNow()));
-    AttrChange->SetItem(5, old_val.GetPyObject());
-    AttrChange->SetItem(6, new_val.GetPyObject());
+    // the client expects the new value first, see Notify_OnModuleAttributeChange
+    AttrChange->SetItem(5, new_val.GetPyObject());
+    AttrChange->SetItem(6, old_val.GetPyObject());
 
-    return SendAttributeChanges(AttrChange);
+    return SendAttributeChanges(attributeID, AttrChange);
 }
 
 bool AttributeMap::Add( uint32 attributeID, EvilNumber& num )
 {
-    mChanged = true;
     PyTuple* AttrChange = new PyTuple(7);
     AttrChange->SetItem(0, new PyString( "OnModuleAttributeChange" ));
     AttrChange->SetItem(1, new PyInt( mItem.ownerID() ));
@@ -492,10 +586,10 @@ bool AttributeMap::Add( uint32 attributeID, EvilNumber& num )
     AttrChange->SetItem(5, num.GetPyObject());
     AttrChange->SetItem(6, num.GetPyObject());
 
-    return SendAttributeChanges(AttrChange);
+    return SendAttributeChanges(attributeID, AttrChange);
 }
 
-bool AttributeMap::SendAttributeChanges( PyTuple* attrChange )
+bool AttributeMap::SendAttributeChanges( uint32 attributeID, PyTuple* attrChange )
 {
     if (attrChange == NULL)
     {
@@ -509,6 +603,7 @@ bool AttributeMap::SendAttributeChanges( PyTuple* attrChange )
         // This item is owned by the EVE System either directly, as in the case of a character object,
         // or indirectly, as in the case of a Station, which is owned by the corporation that runs it.
         // So, we don't need to queue up Destiny events in these cases.
+        PyDecRef( attrChange );
         return true;
     }
     else
@@ -519,6 +614,7 @@ bool AttributeMap::SendAttributeChanges( PyTuple* attrChange )
         if (client == NULL)
         {
             sLog.Error("AttributeMap::SendAttributeChanges()", "unable to find client:%u", mItem.ownerID());
+            PyDecRef( attrChange );
             //return false;
             return true;
         }
@@ -527,10 +623,11 @@ bool AttributeMap::SendAttributeChanges( PyTuple* attrChange )
             if( client->Destiny() == NULL )
             {
                 sLog.Warning( "AttributeMap::SendAttributeChanges()", "client->Destiny() returned NULL" );
+                PyDecRef( attrChange );
                 //return false;
             }
             else
-                client->QueueDestinyEvent(&attrChange);
+                client->QueueAttributeChange(&attrChange, mItem.itemID(), attributeID);
 
             return true;
         }
@@ -574,19 +671,43 @@ bool AttributeMap::ResetAttribute(uint32 attrID, bool notify)
 bool AttributeMap::Load()
 {
     /* then we possibly overwrite the attributes value's with the default's.. */
-    DgmTypeAttributeSet *attr_set = sDgmTypeAttrMgr.GetDmgTypeAttributeSet( mItem.typeID() );
-    if (attr_set == NULL)
+    DgmTypeAttributeSet attr_set;
+    if (!sDgmTypeAttrMgr.GetDmgTypeAttributeSet( mItem.typeID(), attr_set ))
         return false;
 
-    DgmTypeAttributeSet::AttrSetItr itr = attr_set->attributeset.begin();
+    for (uint32 i = 0; i < attr_set.size(); i++) {
+        EvilNumber number = attr_set.value(i);
+        SetAttribute(attr_set.attributeID(i), number, false);
+    }
 
-    for (; itr != attr_set->attributeset.end(); itr++)
-        SetAttribute((*itr)->attributeID, (*itr)->number, false);
+    /* transient items have nothing saved */
+    if( mItem.IsTransient() )
+    {
+        _ClearDirty();
+        return true;
+    }
+
+    /* then the saved attributes, which may have been loaded along with the item's container */
+    ItemAttributeList saved;
+    if( mItem.GetItemFactory()->TakePreloadedAttributes( mItem.itemID(), saved ) )
+    {
+        ItemAttributeList::iterator cur, end;
+        cur = saved.begin();
+        end = saved.end();
+        for(; cur != end; cur++)
+            SetAttribute( cur->first, cur->second, false );
+
+        // what we loaded is what is stored already
+        _ClearDirty();
+        return true;
+    }
+
+    /* or from the db, where they may be waiting to be written */
+    sInventoryWriteBehind.Flush();
 
-    /* first we load the saved attributes from the db */
     DBQueryResult res;
 
-    if(!sDatabase.RunQuery(res, "SELECT * FROM entity_attributes WHERE itemID='%u'", mItem.itemID())) {
+    if(!sDatabase.RunPrepared(res, "SELECT * FROM entity_attributes WHERE itemID=?", DBParams().Add(mItem.itemID()))) {
         sLog.Error("AttributeMap", "Error in db load query: %s", res.error.c_str());
         return false;
     }
@@ -606,6 +727,7 @@ bool AttributeMap::Load()
         SetAttribute(attributeID, attr_value, false);
     }
 
+    _ClearDirty();
     return true;
 
 /*
@@ -648,17 +770,16 @@ bool AttributeMap::Load()
         // This item was NOT found in the 'entity_attributes' table, so let's assume that
         // this item was just created.
         // 1) Get complete list of attributes with default values from dgmTypeAttributes table using the item's typeID:
-        DgmTypeAttributeSet *attr_set = sDgmTypeAttrMgr.GetDmgTypeAttributeSet( mItem.typeID() );
-        if (attr_set == NULL)
+        DgmTypeAttributeSet attr_set;
+        if (!sDgmTypeAttrMgr.GetDmgTypeAttributeSet( mItem.typeID(), attr_set ))
             return false;
 
-        DgmTypeAttributeSet::AttrSetItr itr = attr_set->attributeset.begin();
-
         // Store all these attributes to the item's AttributeMap
-        for (; itr != attr_set->attributeset.end(); itr++)
+        for (uint32 i = 0; i < attr_set.size(); i++)
         {
-            SetAttribute((*itr)->attributeID, (*itr)->number, false);
-            //Add((*itr)->attributeID, (*itr)->number);
+            EvilNumber number = attr_set.value(i);
+            SetAttribute(attr_set.attributeID(i), number, false);
+            //Add(attr_set.attributeID(i), attr_set.value(i));
         }
 
         // 2) Save these newly created and loaded attributes to the 'entity_attributes' table
@@ -671,14 +792,19 @@ bool AttributeMap::Load()
 
 bool AttributeMap::SaveIntAttribute(uint32 attributeID, int64 value)
 {
+    if (sInventoryWriteBehind.IsEnabled()) {
+        sInventoryWriteBehind.SaveAttribute(mItem.itemID(), attributeID, value);
+        return true;
+    }
+
     // SAVE INTEGER ATTRIBUTE
     DBerror err;
-    if(!sDatabase.RunQuery(err,
+    if(!sDatabase.RunPrepared(err,
         "REPLACE INTO entity_attributes"
         "   (itemID, attributeID, valueInt, valueFloat)"
         " VALUES"
-        "   (%u, %u, %d, NULL)",
-        mItem.itemID(), attributeID, value)
+        "   (?, ?, ?, NULL)",
+        DBParams().Add(mItem.itemID()).Add(attributeID).Add(value))
     ) {
         codelog(SERVICE__ERROR, "Failed to store attribute %d for item %u: %s", attributeID, mItem.itemID(), err.c_str());
         return false;
@@ -689,14 +815,19 @@ bool AttributeMap::SaveIntAttribute(uint32 attributeID, int64 value)
 
 bool AttributeMap::SaveFloatAttribute(uint32 attributeID, double value)
 {
+    if (sInventoryWriteBehind.IsEnabled()) {
+        sInventoryWriteBehind.SaveAttribute(mItem.itemID(), attributeID, value);
+        return true;
+    }
+
     // SAVE FLOAT ATTRIBUTE
     DBerror err;
-    if(!sDatabase.RunQuery(err,
+    if(!sDatabase.RunPrepared(err,
         "REPLACE INTO entity_attributes"
         "   (itemID, attributeID, valueInt, valueFloat)"
         " VALUES"
-        "   (%u, %u, NULL, %f)",
-        mItem.itemID(), attributeID, value)
+        "   (?, ?, NULL, ?)",
+        DBParams().Add(mItem.itemID()).Add(attributeID).Add(value))
     ) {
         codelog(SERVICE__ERROR, "Failed to store attribute %d for item %u: %s", attributeID, mItem.itemID(), err.c_str());
         return false;
@@ -710,40 +841,63 @@ bool AttributeMap::SaveFloatAttribute(uint32 attributeID, double value)
 bool AttributeMap::Save()
 {
     /* if nothing changed... it means this action has been successful we return true... */
-    if (mChanged == false)
+    if (mHotDirty == 0 && mDirty.empty())
         return true;
 
-    AttrMapItr itr = mAttributes.begin();
-    AttrMapItr itr_end = mAttributes.end();
-    for (; itr != itr_end; itr++)
+    /* transient items are never written */
+    if (mItem.IsTransient())
     {
-        if ( itr->second.get_type() == evil_number_int ) {
-
-            DBerror err;
-            bool success = sDatabase.RunQuery(err,
-                "REPLACE INTO entity_attributes (itemID, attributeID, valueInt, valueFloat) VALUES (%u, %u, %" PRId64 ", NULL)",
-                mItem.itemID(), itr->first, itr->second.get_int());
+        _ClearDirty();
+        return true;
+    }
 
-            if (!success)
-                sLog.Error("AttributeMap", "unable to save attribute");
+    for( uint32 slot = 0; slot < HOT_ATTRIBUTE_COUNT; ++slot )
+    {
+        const uint32 bit = 1u << slot;
+        if( !( mHotDirty & mHotPresent & bit ) )
+            continue;
 
-        } else if (itr->second.get_type() == evil_number_float ) {
+        if( mHotInt & bit )
+            SaveIntAttribute( sHotAttributeIDs[ slot ], (int64)mHotValues[ slot ] );
+        else
+            SaveFloatAttribute( sHotAttributeIDs[ slot ], mHotValues[ slot ] );
+    }
 
-            DBerror err;
-            bool success = sDatabase.RunQuery(err,
-                "REPLACE INTO entity_attributes (itemID, attributeID, valueInt, valueFloat) VALUES (%u, %u, NULL, %f)",
-                mItem.itemID(), itr->first, itr->second.get_float());
+    std::set<uint32>::const_iterator cur = mDirty.begin();
+    std::set<uint32>::const_iterator end = mDirty.end();
+    for (; cur != end; cur++)
+    {
+        AttrMapItr itr = mAttributes.find(*cur);
+        if (itr == mAttributes.end())
+            continue;
 
-            if (!success)
-                sLog.Error("AttributeMap", "unable to save attribute");
-        }
+        if ( itr->second.get_type() == evil_number_int )
+            SaveIntAttribute(itr->first, itr->second.get_int());
+        else if ( itr->second.get_type() == evil_number_float )
+            SaveFloatAttribute(itr->first, itr->second.get_float());
     }
 
-    mChanged = false;
+    _ClearDirty();
 
     return true;
 }
 
+void AttributeMap::MarkAllDirty()
+{
+    mHotDirty = mHotPresent;
+
+    AttrMapItr cur = mAttributes.begin();
+    AttrMapItr end = mAttributes.end();
+    for (; cur != end; cur++)
+        mDirty.insert(cur->first);
+}
+
+void AttributeMap::_ClearDirty()
+{
+    mHotDirty = 0;
+    mDirty.clear();
+}
+
 
 bool AttributeMap::SaveAttributes()
 {
@@ -753,6 +907,8 @@ bool AttributeMap::SaveAttributes()
 bool AttributeMap::Delete()
 {
     // Remove all attributes from the entity_attributes table for this item:
+    sInventoryWriteBehind.Forget(mItem.itemID(), true);
+
     DBerror err;
     if(!sDatabase.RunQuery(err,
         "DELETE"
@@ -767,14 +923,32 @@ bool AttributeMap::Delete()
     return true;
 }
 
-AttributeMap::AttrMapItr AttributeMap::begin()
+void AttributeMap::EncodeAttributes( std::map<int32, PyRep *> &into ) const
 {
-    return mAttributes.begin();
+    for( uint32 slot = 0; slot < HOT_ATTRIBUTE_COUNT; ++slot )
+    {
+        if( mHotPresent & ( 1u << slot ) )
+        {
+            EvilNumber value = _GetHotNumber( slot );
+            into[ sHotAttributeIDs[ slot ] ] = value.GetPyObject();
+        }
+    }
+
+    AttrMapConstItr itr = mAttributes.begin();
+    AttrMapConstItr itr_end = mAttributes.end();
+    for (; itr != itr_end; itr++)
+    {
+        EvilNumber value = itr->second;
+        into[ itr->first ] = value.GetPyObject();
+    }
 }
 
-AttributeMap::AttrMapItr AttributeMap::end()
+size_t AttributeMap::size() const
 {
-    return mAttributes.end();
+    size_t count = mAttributes.size();
+    for( uint32 present = mHotPresent; present != 0; present &= present - 1 )
+        ++count;
+    return count;
 }
 /************************************************************************/
 /* End of new attribute system                                          */
@@ -144,22 +144,21 @@ bool Inventory::LoadContents(ItemFactory &factory)
         return true;
     }
 
-    sLog.Debug("Inventory", "Recursively loading contents of inventory %u", inventoryID() );
+    _debug("Inventory", "Recursively loading contents of inventory %u", inventoryID() );
 
-    //load the list of items we need
-    std::vector<uint32> items;
-    if( !GetItems( factory, items ) )
+    //load the items we need along with their attributes, all at once
+    std::map<uint32, ItemData> items;
+    if( !factory.PreloadItems( std::vector<uint32>( 1, inventoryID() ), items ) )
     {
         sLog.Error("Inventory", "Failed  to get items of %u", inventoryID() );
         return false;
     }
 
     //Now get each one from the factory (possibly recursing)
-    ItemData into;
     uint32 characterID = 0;
     uint32 corporationID = 0;
     uint32 locationID = 0;
-    std::vector<uint32>::iterator cur, end;
+    std::map<uint32, ItemData>::iterator cur, end;
     cur = items.begin();
     end = items.end();
     for(; cur != end; cur++)
@@ -167,7 +166,7 @@ bool Inventory::LoadContents(ItemFactory &factory)
         // Each "cur" item should be checked to see if they are "owned" by the character connected to this client,
         // and if not, then do not "get" the entire contents of this for() loop for that item, except in the case that
         // this item is located in space or belongs to this character's corporation:
-        factory.db().GetItem( *cur, into );
+        const ItemData &into = cur->second;
         if( factory.GetUsingClient() != NULL )
         {
             characterID = factory.GetUsingClient()->GetCharacterID();
@@ -187,15 +186,19 @@ bool Inventory::LoadContents(ItemFactory &factory)
             if( factory.GetUsingClient() == NULL )
                 sLog.Error( "Inventory::LoadContents()", "WARNING! Loading Contents while ItemFactory::GetUsingClient() returned NULL!" );
 
-            InventoryItemRef i = factory.GetItem( *cur );
+            InventoryItemRef i = factory.GetItem( cur->first );
+            // drop whatever the load did not use
+            factory.DiscardPreloaded( cur->first );
             if( !i )
             {
-                sLog.Error("Inventory::LoadContents()", "Failed to load item %u contained in %u. Skipping.", *cur, inventoryID() );
+                sLog.Error("Inventory::LoadContents()", "Failed to load item %u contained in %u. Skipping.", cur->first, inventoryID() );
                 continue;
             }
 
             AddItem( i );
         }
+        else
+            factory.DiscardPreloaded( cur->first );
     }
 
     mContentsLoaded = true;
@@ -206,7 +209,7 @@ void Inventory::DeleteContents(ItemFactory &factory)
 {
     LoadContents( factory );
 
-    std::map<uint32, InventoryItemRef>::iterator cur, end;
+    ItemMap::iterator cur, end;
     cur = mContents.begin();
     end = mContents.end();
     for(; cur != end; )
@@ -221,6 +224,9 @@ void Inventory::DeleteContents(ItemFactory &factory)
     }
 
     mContents.clear();
+    mByFlag.clear();
+    mByFlagOwner.clear();
+    mByFlagType.clear();
 }
 
 CRowSet* Inventory::List( EVEItemFlags _flag, uint32 forOwner ) const
@@ -250,16 +256,34 @@ CRowSet* Inventory::List( EVEItemFlags _flag, uint32 forOwner ) const
 
 void Inventory::List( CRowSet* into, EVEItemFlags _flag, uint32 forOwner ) const
 {
-    //there has to be a better way to build this...
-    std::map<uint32, InventoryItemRef>::const_iterator cur, end;
-    cur = mContents.begin();
-    end = mContents.end();
+    const ItemMap* items = &mContents;
+    if( _flag != flagAnywhere )
+    {
+        if( forOwner == 0 )
+        {
+            std::map<uint32, ItemMap>::const_iterator res = mByFlag.find( _flag );
+            if( res == mByFlag.end() )
+                return;
+            items = &res->second;
+        }
+        else
+        {
+            std::map<uint64, ItemMap>::const_iterator res = mByFlagOwner.find( _IndexKey( _flag, forOwner ) );
+            if( res == mByFlagOwner.end() )
+                return;
+            items = &res->second;
+        }
+    }
+
+    ItemMap::const_iterator cur, end;
+    cur = items->begin();
+    end = items->end();
     for(; cur != end; cur++)
     {
         InventoryItemRef i = cur->second;
 
-        if(    ( i->flag() == _flag       || _flag == flagAnywhere )
-            && ( i->ownerID() == forOwner || forOwner == 0 ) )
+        //only the owner is left to check when listing anywhere
+        if( i->ownerID() == forOwner || forOwner == 0 )
         {
             PyPackedRow* row = into->NewRow();
             i->GetItemRow( row );
@@ -269,14 +293,9 @@ void Inventory::List( CRowSet* into, EVEItemFlags _flag, uint32 forOwner ) const
 
 InventoryItemRef Inventory::FindFirstByFlag(EVEItemFlags _flag) const
 {
-    std::map<uint32, InventoryItemRef>::const_iterator cur, end;
-    cur = mContents.begin();
-    end = mContents.end();
-    for(; cur != end; cur++)
-    {
-        if( cur->second->flag() == _flag )
-            return cur->second;
-    }
+    std::map<uint32, ItemMap>::const_iterator res = mByFlag.find( _flag );
+    if( res != mByFlag.end() )
+        return res->second.begin()->second;
 
     sLog.Error("Inventory", "unable to find first by flag");
     return InventoryItemRef();
@@ -284,7 +303,7 @@ InventoryItemRef Inventory::FindFirstByFlag(EVEItemFlags _flag) const
 
 InventoryItemRef Inventory::GetByID(uint32 id) const
 {
-    std::map<uint32, InventoryItemRef>::const_iterator res = mContents.find( id );
+    ItemMap::const_iterator res = mContents.find( id );
     if( res != mContents.end() )
         return res->second;
     else
@@ -293,89 +312,57 @@ InventoryItemRef Inventory::GetByID(uint32 id) const
 
 InventoryItemRef Inventory::GetByTypeFlag(uint32 typeID, EVEItemFlags flag) const
 {
-    std::map<uint32, InventoryItemRef>::const_iterator cur, end;
-    cur = mContents.begin();
-    end = mContents.end();
-    for(; cur != end; cur++)
-    {
-        if( cur->second->typeID() == typeID
-            && cur->second->flag() == flag )
-        {
-            return cur->second;
-        }
-    }
+    std::map<uint64, ItemMap>::const_iterator res = mByFlagType.find( _IndexKey( flag, typeID ) );
+    if( res != mByFlagType.end() )
+        return res->second.begin()->second;
 
     return InventoryItemRef();
 }
 
 uint32 Inventory::FindByFlag(EVEItemFlags _flag, std::vector<InventoryItemRef> &items) const
 {
-    std::map<uint32, InventoryItemRef>::const_iterator cur, end;
-    cur = mContents.begin();
-    end = mContents.end();
-    for(; cur != end; cur++)
+    std::map<uint32, ItemMap>::const_iterator res = mByFlag.find( _flag );
+    if( res != mByFlag.end() )
     {
-        if (cur->second)
-        {
-            if(cur->second->flag() == _flag)
-            {
-                items.push_back( cur->second );
-            }
-        }
+        ItemMap::const_iterator cur, end;
+        cur = res->second.begin();
+        end = res->second.end();
+        for(; cur != end; cur++)
+            items.push_back( cur->second );
     }
     return items.size();
 }
 
 bool Inventory::FindSingleByFlag( EVEItemFlags flag, InventoryItemRef &item ) const
 {
-    std::map<uint32, InventoryItemRef>::const_iterator cur, end;
-    cur = mContents.begin();
-    end = mContents.end();
-    for(; cur != end; cur++)
-    {
-        if (cur->second)
-        {
-            if(cur->second->flag() == flag)
-            {
-                item = cur->second;
-                return true;
-            }
-        }
-    }
-    return false;
+    std::map<uint32, ItemMap>::const_iterator res = mByFlag.find( flag );
+    if( res == mByFlag.end() )
+        return false;
+
+    item = res->second.begin()->second;
+    return true;
 }
 
 bool Inventory::IsEmptyByFlag( EVEItemFlags flag )
 {
-    std::map<uint32, InventoryItemRef>::const_iterator cur, end;
-    cur = mContents.begin();
-    end = mContents.end();
-    for(; cur != end; cur++)
-    {
-        if (cur->second)
-        {
-            if(cur->second->flag() == flag)
-            {
-                return false;
-            }
-        }
-    }
-    return true;
+    return mByFlag.find( flag ) == mByFlag.end();
 }
 
 uint32 Inventory::FindByFlagRange(EVEItemFlags low_flag, EVEItemFlags high_flag, std::vector<InventoryItemRef> &items) const
 {
     uint32 count = 0;
 
-    std::map<uint32, InventoryItemRef>::const_iterator cur, end;
-    cur = mContents.begin();
-    end = mContents.end();
+    std::map<uint32, ItemMap>::const_iterator cur, end;
+    cur = mByFlag.lower_bound( low_flag );
+    end = mByFlag.upper_bound( high_flag );
     for(; cur != end; cur++)
     {
-        if( cur->second->flag() >= low_flag
-            && cur->second->flag() <= high_flag )
+        ItemMap::const_iterator curi, endi;
+        curi = cur->second.begin();
+        endi = cur->second.end();
+        for(; curi != endi; curi++)
         {
-            items.push_back( cur->second );
+            items.push_back( curi->second );
             count++;
         }
     }
@@ -387,14 +374,21 @@ uint32 Inventory::FindByFlagSet(std::set<EVEItemFlags> flags, std::vector<Invent
 {
     uint32 count = 0;
 
-    std::map<uint32, InventoryItemRef>::const_iterator cur, end;
-    cur = mContents.begin();
-    end = mContents.end();
+    std::set<EVEItemFlags>::const_iterator cur, end;
+    cur = flags.begin();
+    end = flags.end();
     for(; cur != end; cur++)
     {
-        if( flags.find( cur->second->flag() ) != flags.end() )
+        std::map<uint32, ItemMap>::const_iterator res = mByFlag.find( *cur );
+        if( res == mByFlag.end() )
+            continue;
+
+        ItemMap::const_iterator curi, endi;
+        curi = res->second.begin();
+        endi = res->second.end();
+        for(; curi != endi; curi++)
         {
-            items.push_back( cur->second );
+            items.push_back( curi->second );
             count++;
         }
     }
@@ -404,45 +398,60 @@ uint32 Inventory::FindByFlagSet(std::set<EVEItemFlags> flags, std::vector<Invent
 
 void Inventory::AddItem(InventoryItemRef item)
 {
-    std::map<uint32, InventoryItemRef>::iterator res = mContents.find( item->itemID() );
+    ItemMap::iterator res = mContents.find( item->itemID() );
     if( res == mContents.end() )
     {
         mContents.insert( std::make_pair( item->itemID(), item ) );
+        _Index( item );
 
-        sLog.Debug("Inventory", "Updated location %u to contain item %u with flag %d.", inventoryID(), item->itemID(), (int)item->flag() );
+        _debug("Inventory", "Updated location %u to contain item %u with flag %d.", inventoryID(), item->itemID(), (int)item->flag() );
     }
     //else already here
-    sLog.Debug("Inventory", "unable to updated location %u to contain item %u with flag %d, because it already happend.", inventoryID(), item->itemID(), (int)item->flag() );
+    _debug("Inventory", "unable to updated location %u to contain item %u with flag %d, because it already happend.", inventoryID(), item->itemID(), (int)item->flag() );
 }
 
 void Inventory::RemoveItem(uint32 itemID)
 {
-    std::map<uint32, InventoryItemRef>::iterator res = mContents.find( itemID );
+    ItemMap::iterator res = mContents.find( itemID );
     if( res != mContents.end() )
     {
+        _Unindex( itemID, res->second->flag(), res->second->ownerID(), res->second->typeID() );
         mContents.erase( res );
 
-        sLog.Debug("Inventory", "Updated location %u to no longer contain item %u.", inventoryID(), itemID );
+        _debug("Inventory", "Updated location %u to no longer contain item %u.", inventoryID(), itemID );
     }
-    sLog.Debug("Inventory", "unable to remove %u from %u.", itemID, inventoryID() );
+    _debug("Inventory", "unable to remove %u from %u.", itemID, inventoryID() );
 }
 
 void Inventory::StackAll(EVEItemFlags locFlag, uint32 forOwner)
 {
+    //take the items out of the index first, as merging moves the merged ones out
+    std::vector<InventoryItemRef> items;
+    if( forOwner == 0 )
+        FindByFlag( locFlag, items );
+    else
+    {
+        std::map<uint64, ItemMap>::const_iterator res = mByFlagOwner.find( _IndexKey( locFlag, forOwner ) );
+        if( res != mByFlagOwner.end() )
+        {
+            ItemMap::const_iterator cur, end;
+            cur = res->second.begin();
+            end = res->second.end();
+            for(; cur != end; cur++)
+                items.push_back( cur->second );
+        }
+    }
+
     std::map<uint32, InventoryItemRef> types;
 
-    std::map<uint32, InventoryItemRef>::iterator cur, end;
-    cur = mContents.begin();
-    end = mContents.end();
-    for(; cur != end; )
+    std::vector<InventoryItemRef>::iterator cur, end;
+    cur = items.begin();
+    end = items.end();
+    for(; cur != end; cur++)
     {
-        // Iterator becomes invalid when the item
-        // is moved out; we have to increment before
-        // calling Merge().
-        InventoryItemRef i = cur->second;
-        cur++;
+        InventoryItemRef i = *cur;
 
-        if( !i->singleton() && ( forOwner == 0 || forOwner == i->ownerID() ) )
+        if( !i->singleton() )
         {
             std::map<uint32, InventoryItemRef>::iterator res = types.find( i->typeID() );
             if( res == types.end() )
@@ -455,22 +464,102 @@ void Inventory::StackAll(EVEItemFlags locFlag, uint32 forOwner)
 
 double Inventory::GetStoredVolume(EVEItemFlags locationFlag) const
 {
-    //double totalVolume = 0.0;
-    EvilNumber totalVolume(0.0);
     //TODO: And implement Sizes for packaged ships
+    std::map<uint32, double>::const_iterator res = mStoredVolumes.find( locationFlag );
+    if( res == mStoredVolumes.end() )
+        return 0.0;
 
-    std::map<uint32, InventoryItemRef>::const_iterator cur, end;
-    cur = mContents.begin();
-    end = mContents.end();
-    for(; cur != end; cur++)
+    return res->second;
+}
+
+uint32 Inventory::GetItemCount(EVEItemFlags locationFlag) const
+{
+    std::map<uint32, ItemMap>::const_iterator res = mByFlag.find( locationFlag );
+    if( res == mByFlag.end() )
+        return 0;
+
+    return res->second.size();
+}
+
+void Inventory::_UpdateIndexes(InventoryItemRef item, EVEItemFlags oldFlag, uint32 oldOwnerID)
+{
+    if( !Contains( item->itemID() ) )
+        return;
+
+    _Unindex( item->itemID(), oldFlag, oldOwnerID, item->typeID() );
+    _Index( item );
+}
+
+void Inventory::_UpdateVolume(InventoryItemRef item)
+{
+    std::map<uint32, double>::iterator res = mItemVolumes.find( item->itemID() );
+    if( res == mItemVolumes.end() )
+        return;
+
+    EvilNumber volume = item->GetAttribute(AttrQuantity) * item->GetAttribute(AttrVolume);
+    mStoredVolumes[ item->flag() ] += volume.get_float() - res->second;
+    res->second = volume.get_float();
+}
+
+void Inventory::_Index(InventoryItemRef item)
+{
+    //double volume = item->quantity() * item->volume();
+    EvilNumber volume = item->GetAttribute(AttrQuantity) * item->GetAttribute(AttrVolume);
+    mItemVolumes[ item->itemID() ] = volume.get_float();
+    mStoredVolumes[ item->flag() ] += volume.get_float();
+
+    mByFlag[ item->flag() ][ item->itemID() ] = item;
+    mByFlagOwner[ _IndexKey( item->flag(), item->ownerID() ) ][ item->itemID() ] = item;
+    mByFlagType[ _IndexKey( item->flag(), item->typeID() ) ][ item->itemID() ] = item;
+}
+
+void Inventory::_Unindex(uint32 itemID, EVEItemFlags flag, uint32 ownerID, uint32 typeID)
+{
+    //empty buckets are dropped, so a flag is in the index only if it holds an item
+    std::map<uint32, ItemMap>::iterator byFlag = mByFlag.find( flag );
+    if( byFlag != mByFlag.end() )
+    {
+        byFlag->second.erase( itemID );
+        if( byFlag->second.empty() )
+            mByFlag.erase( byFlag );
+    }
+
+    std::map<uint32, double>::iterator volume = mItemVolumes.find( itemID );
+    if( volume != mItemVolumes.end() )
     {
-        if( cur->second->flag() == locationFlag )
-            //totalVolume += cur->second->quantity() * cur->second->volume();
-            totalVolume += cur->second->GetAttribute(AttrQuantity) * cur->second->GetAttribute(AttrVolume);
+        //an empty flag starts over from zero, so rounding errors do not pile up
+        if( mByFlag.find( flag ) == mByFlag.end() )
+            mStoredVolumes.erase( flag );
+        else
+            mStoredVolumes[ flag ] -= volume->second;
+
+        mItemVolumes.erase( volume );
+    }
+
+    std::map<uint64, ItemMap>::iterator res = mByFlagOwner.find( _IndexKey( flag, ownerID ) );
+    if( res != mByFlagOwner.end() )
+    {
+        res->second.erase( itemID );
+        if( res->second.empty() )
+            mByFlagOwner.erase( res );
     }
 
-    // this is crap... bleh... as it should return a EvilNumber
-    return totalVolume.get_float();
+    res = mByFlagType.find( _IndexKey( flag, typeID ) );
+    if( res != mByFlagType.end() )
+    {
+        res->second.erase( itemID );
+        if( res->second.empty() )
+            mByFlagType.erase( res );
+    }
+}
+
+void Inventory::ValidateAddItems(EVEItemFlags flag, const std::vector<InventoryItemRef> &items) const
+{
+    std::vector<InventoryItemRef>::const_iterator cur, end;
+    cur = items.begin();
+    end = items.end();
+    for(; cur != end; cur++)
+        ValidateAddItem( flag, *cur );
 }
 
 /*
@@ -491,3 +580,31 @@ void InventoryEx::ValidateAddItem(EVEItemFlags flag, InventoryItemRef item) cons
         throw PyException( MakeUserError( "NotEnoughCargoSpace", args ) );
     }
 }
+
+void InventoryEx::ValidateAddItems(EVEItemFlags flag, const std::vector<InventoryItemRef> &items) const
+{
+    //items already there take no more space.
+    EvilNumber volume = 0.0;
+
+    std::vector<InventoryItemRef>::const_iterator cur, end;
+    cur = items.begin();
+    end = items.end();
+    for(; cur != end; cur++)
+    {
+        if( (*cur)->locationID() == inventoryID() && (*cur)->flag() == flag )
+            continue;
+
+        volume += (*cur)->GetAttribute(AttrQuantity) * (*cur)->GetAttribute(AttrVolume);
+    }
+
+    double capacity = GetRemainingCapacity( flag );
+    if( volume > capacity )
+    {
+        std::map<std::string, PyRep *> args;
+
+        args["available"] = new PyFloat( capacity );
+        args["volume"] = volume.GetPyObject();
+
+        throw PyException( MakeUserError( "NotEnoughCargoSpace", args ) );
+    }
+}
@@ -0,0 +1,177 @@
+/*
+    ------------------------------------------------------------------------------------
+    LICENSE:
+    ------------------------------------------------------------------------------------
+    This file is part of EVEmu: EVE Online Server Emulator
+    Copyright 2006 - 2011 The EVEmu Team
+    For the latest information visit http://evemu.org
+    ------------------------------------------------------------------------------------
+    This program is free software; you can redistribute it and/or modify it under
+    the terms of the GNU Lesser General Public License as published by the Free Software
+    Foundation; either version 2 of the License, or (at your option) any later
+    version.
+
+    This program is distributed in the hope that it will be useful, but WITHOUT
+    ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+    FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public License along with
+    this program; if not, write to the Free Software Foundation, Inc., 59 Temple
+    Place - Suite 330, Boston, MA 02111-1307, USA, or go to
+    http://www.gnu.org/copyleft/lesser.txt.
+    ------------------------------------------------------------------------------------
+    Author:     EVEmu Team
+*/
+
+
+#include "eve-server.h"
+
+#include "Client.h"
+#include "EntityList.h"
+#include "inventory/InventoryBatch.h"
+#include "inventory/InventoryWriteBehind.h"
+
+InventoryBatch::InventoryBatch()
+: mDepth( 0 )
+{
+}
+
+void InventoryBatch::Begin()
+{
+    ++mDepth;
+    sInventoryWriteBehind.BeginBatch();
+}
+
+void InventoryBatch::End()
+{
+    assert( 0 < mDepth );
+
+    // writes the saves of the outermost batch unless they are queued anyway
+    sInventoryWriteBehind.EndBatch();
+
+    if( 0 < --mDepth )
+        return;
+
+    _SendChanges();
+    ++mStats.batches;
+}
+
+void InventoryBatch::QueueItemChange( uint32 toID, InventoryItemRef item, std::map<int32, PyRep*>& changes )
+{
+    ++mStats.changes;
+
+    std::map<ChangeKey, PendingChange>::iterator res = mChanges.find( ChangeKey( toID, item->itemID() ) );
+    if( res == mChanges.end() )
+    {
+        PendingChange& pending = mChanges[ ChangeKey( toID, item->itemID() ) ];
+        pending.item = item;
+        pending.changes = changes;
+
+        changes.clear();
+        return;
+    }
+
+    // keep the oldest previous value of every column
+    std::map<int32, PyRep*>::iterator cur, end;
+    cur = changes.begin();
+    end = changes.end();
+    for(; cur != end; ++cur )
+    {
+        if( !res->second.changes.insert( *cur ).second )
+            PyDecRef( cur->second );
+    }
+
+    changes.clear();
+    ++mStats.coalesced;
+}
+
+void InventoryBatch::_SendChanges()
+{
+    if( mChanges.empty() )
+        return;
+
+    // take them out first; sending must not see them again
+    std::map<ChangeKey, PendingChange> changes;
+    changes.swap( mChanges );
+
+    std::map<ChangeKey, PendingChange>::iterator cur, end;
+    cur = changes.begin();
+    end = changes.end();
+    while( cur != end )
+    {
+        const uint32 toID = cur->first.first;
+
+        Client* c = sEntityList.FindCharacter( toID );
+
+        // the changes of the recipient are next to each other
+        PyList* events = new PyList;
+        for(; cur != end && cur->first.first == toID; ++cur )
+        {
+            if( !_DropUnchanged( cur->second ) )
+            {
+                ++mStats.reverted;
+                continue;
+            }
+
+            NotifyOnItemChange change;
+            change.itemRow = cur->second.item->GetItemRow();
+            change.changes = cur->second.changes;
+            cur->second.changes.clear();
+
+            PyTuple* t = change.Encode();
+
+            PyTuple* event = new PyTuple( 3 );
+            event->SetItem( 0, new PyString( "OnItemChange" ) );
+            event->SetItem( 1, t->GetItem( 0 ) ); PyIncRef( t->GetItem( 0 ) );
+            event->SetItem( 2, t->GetItem( 1 ) ); PyIncRef( t->GetItem( 1 ) );
+            PyDecRef( t );
+
+            events->AddItem( event );
+        }
+
+        if( NULL == c || events->empty() )
+        {
+            // logged off meanwhile, or nothing changed after all
+            PyDecRef( events );
+            continue;
+        }
+
+        Notify_OnMultiEvent nom;
+        nom.events = events;
+
+        PyTuple* t = nom.Encode();   //this is consumed below
+        c->SendNotification( "OnMultiEvent", "charid", &t, false ); //unsequenced, as OnItemChange.
+        ++mStats.notifications;
+    }
+}
+
+bool InventoryBatch::_DropUnchanged( PendingChange& pending )
+{
+    const InventoryItemRef& item = pending.item;
+
+    std::map<int32, PyRep*>::iterator cur = pending.changes.begin();
+    while( cur != pending.changes.end() )
+    {
+        int64 value;
+        switch( cur->first )
+        {
+            case ixOwnerID:     value = item->ownerID(); break;
+            case ixLocationID:  value = item->locationID(); break;
+            case ixFlag:        value = item->flag(); break;
+            case ixSingleton:   value = item->singleton(); break;
+            case ixQuantity:    value = item->quantity(); break;
+            // the others are kept as they are
+            default:            ++cur; continue;
+        }
+
+        if( cur->second->IsInt() && cur->second->AsInt()->value() == value )
+        {
+            PyDecRef( cur->second );
+            pending.changes.erase( cur++ );
+        }
+        else
+            ++cur;
+    }
+
+    return !pending.changes.empty();
+}
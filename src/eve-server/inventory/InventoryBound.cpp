@@ -26,6 +26,7 @@
 #include "eve-server.h"
 
 #include "PyServiceCD.h"
+#include "inventory/InventoryBatch.h"
 #include "inventory/InventoryBound.h"
 
 PyCallable_Make_InnerDispatcher(InventoryBound)
@@ -34,6 +35,7 @@ InventoryBound::InventoryBound( PyServiceMgr *mgr, Inventory &inventory, EVEItem
 : PyBoundObject(mgr),
   m_dispatch(new Dispatcher(this)),
   mInventory(inventory),
+  mItem(mgr->item_factory.GetItem(inventory.inventoryID())),
   mFlag(flag)
 {
     _SetCallDispatcher(m_dispatch);
@@ -107,7 +109,7 @@ PyResult InventoryBound::Handle_ReplaceCharges(PyCallArgs &call) {
 
 PyResult InventoryBound::Handle_ListStations( PyCallArgs& call )
 {
-    sLog.Debug( "InventoryBound", "Called ListStations stub." );
+    _debug( "InventoryBound", "Called ListStations stub." );
 
     util_Rowset rowset;
 
@@ -154,7 +156,7 @@ PyResult InventoryBound::Handle_Add(PyCallArgs &call) {
         uint32 flag = 0;
         if( call.byname.find("flag") == call.byname.end() )
         {
-            sLog.Debug( "InventoryBound::Handle_Add()", "Cannot find key 'flag' from call.byname dictionary." );
+            _debug( "InventoryBound::Handle_Add()", "Cannot find key 'flag' from call.byname dictionary." );
             flag = flagCargoHold;    // hard-code this since ship cargo to cargo container move flag since key 'flag' in client.byname does not exist
         }
         else
@@ -203,6 +205,8 @@ PyResult InventoryBound::Handle_Add(PyCallArgs &call) {
 }
 
 PyResult InventoryBound::Handle_MultiAdd(PyCallArgs &call) {
+    //the moves are saved together and their changes are sent in one notification
+    InventoryBatch::Scope batch;
 
     ShipRef ship = call.client->GetShip();
     uint32 typeID;
@@ -254,7 +258,7 @@ PyResult InventoryBound::Handle_MultiAdd(PyCallArgs &call) {
 	uint32 flag = 0;
 	if( call.byname.find("flag") == call.byname.end() )
 	{
-	    sLog.Debug( "InventoryBound::Handle_MultiAdd()", "Cannot find key 'flag' from call.byname dictionary." );
+	    _debug( "InventoryBound::Handle_MultiAdd()", "Cannot find key 'flag' from call.byname dictionary." );
 	    flag = flagCargoHold;    // hard-code this since ship cargo to cargo container move flag since key 'flag' in client.byname does not exist
 	}
 	else
@@ -294,6 +298,8 @@ PyResult InventoryBound::Handle_MultiMerge(PyCallArgs &call) {
 
     Inventory_CallMultiMergeElement element;
 
+    InventoryBatch::Scope batch;
+
     std::vector<PyRep *>::const_iterator cur, end;
     cur = elements.MMElements->begin();
     end = elements.MMElements->end();
@@ -335,20 +341,21 @@ PyResult InventoryBound::Handle_StackAll(PyCallArgs &call) {
     }
 
     //Stack Items contained in this inventory
+    InventoryBatch::Scope batch;
     mInventory.StackAll(stackFlag, call.client->GetCharacterID());
 
     return NULL;
 }
 
 PyResult InventoryBound::Handle_StripFitting(PyCallArgs &call) {
-    sLog.Debug("Server", "Called StripFitting Stub.");
+    _debug("Server", "Called StripFitting Stub.");
 
     return NULL;
 }
 
 PyResult InventoryBound::Handle_DestroyFitting(PyCallArgs &call) {
 
-    sLog.Debug("InventoryBound","Called DestroyFittings stub");
+    _debug("InventoryBound","Called DestroyFittings stub");
 
     Call_SingleIntegerArg args;
     if(!args.Decode(&call.tuple)){
@@ -378,10 +385,34 @@ PyResult InventoryBound::Handle_SetPassword(PyCallArgs &call) {
     return NULL;
 }
 
-PyRep *InventoryBound::_ExecAdd(Client *c, const std::vector<int32> &items, uint32 quantity, EVEItemFlags flag) {
+template<typename Items>
+PyRep *InventoryBound::_ExecAdd(Client *c, const Items &items, uint32 quantity, EVEItemFlags flag) {
     //If were here, we can try move all the items (validated)
 
-    std::vector<int32>::const_iterator cur, end;
+    const bool slotFlag = (flag == flagAutoFit)
+                       || (flag >= flagLowSlot0 && flag <= flagHiSlot7)
+                       || (flag >= flagRigSlot0 && flag <= flagRigSlot7);
+
+    //whole stacks of several items are validated together, so either all of them move or none does.
+    bool validated = false;
+    if( items.size() > 1 && !slotFlag )
+    {
+        std::vector<InventoryItemRef> sourceItems;
+
+        typename Items::const_iterator cur, end;
+        cur = items.begin();
+        end = items.end();
+        for(; cur != end; cur++) {
+            InventoryItemRef sourceItem = m_manager->item_factory.GetItem( *cur );
+            if( sourceItem )
+                sourceItems.push_back( sourceItem );
+        }
+
+        mInventory.ValidateAddItems( flag, sourceItems );
+        validated = true;
+    }
+
+    typename Items::const_iterator cur, end;
     cur = items.begin();
     end = items.end();
     for(; cur != end; cur++) {
@@ -471,7 +502,7 @@ PyRep *InventoryBound::_ExecAdd(Client *c, const std::vector<int32> &items, uint
             {
                 c->GetShip()->AddItem( flag, sourceItem );
             }
-            else
+            else if( !validated )
             {
                 mInventory.ValidateAddItem( flag, sourceItem );
             }
@@ -493,10 +524,11 @@ PyRep *InventoryBound::_ExecAdd(Client *c, const std::vector<int32> &items, uint
             }
         }
 
-        //update modules
-        c->GetShip()->UpdateModules();
     }
 
+    //update modules, once for all the moved items
+    c->GetShip()->UpdateModules();
+
     //Return Null if no item was created
     return NULL;
 }
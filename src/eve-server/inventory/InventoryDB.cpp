@@ -26,12 +26,78 @@
 #include "eve-server.h"
 
 #include "PyCallable.h"
+#include "account/WalletLedger.h"
+#include "character/CharSelectCache.h"
+#include "character/PaperDollStore.h"
+#include "chat/NameIndex.h"
+#include "chat/Presence.h"
+#include "config/OwnerDirectory.h"
+#include "corporation/CorpRoster.h"
+#include "database/DBRowSchema.h"
+#include "database/DBSnapshot.h"
+#include "inventory/InventoryWriteBehind.h"
+#include "market/MarketJournal.h"
+#include "standing/HostilityResolver.h"
 #include "character/Character.h"
 #include "manufacturing/Blueprint.h"
 #include "ship/Ship.h"
 #include "station/Station.h"
 #include "system/SolarSystem.h"
 
+/// Columns of the type query, in their order.
+typedef DBRowSchema< TypeData,
+    DBField< TypeData, uint32,      &TypeData::groupID >,
+    DBField< TypeData, std::string, &TypeData::name >,
+    DBField< TypeData, std::string, &TypeData::description >,
+    DBField< TypeData, double,      &TypeData::radius >,
+    DBField< TypeData, double,      &TypeData::mass >,
+    DBField< TypeData, double,      &TypeData::volume >,
+    DBField< TypeData, double,      &TypeData::capacity >,
+    DBField< TypeData, uint32,      &TypeData::portionSize >,
+    DBField< TypeData, EVERace,     &TypeData::race >,
+    DBField< TypeData, double,      &TypeData::basePrice >,
+    DBField< TypeData, bool,        &TypeData::published >,
+    DBField< TypeData, uint32,      &TypeData::marketGroupID >,
+    DBField< TypeData, double,      &TypeData::chanceOfDuplicating >
+> TypeDataSchema;
+
+/// Columns of the item queries, in their order.
+typedef DBRowSchema< ItemData,
+    DBField< ItemData, std::string,  &ItemData::name >,
+    DBField< ItemData, uint32,       &ItemData::typeID >,
+    DBField< ItemData, uint32,       &ItemData::ownerID, 1 >,
+    DBField< ItemData, uint32,       &ItemData::locationID, 1 >,
+    DBField< ItemData, EVEItemFlags, &ItemData::flag >,
+    DBField< ItemData, bool,         &ItemData::contraband >,
+    DBField< ItemData, bool,         &ItemData::singleton >,
+    DBField< ItemData, uint32,       &ItemData::quantity >,
+    DBField< ItemData, GPoint,       &ItemData::position >,
+    DBField< ItemData, std::string,  &ItemData::customInfo >
+> ItemDataSchema;
+
+/// Decodes the category columns, starting at given index.
+template<typename Row>
+static void DecodeCategoryColumns(const Row &row, uint32 index, CategoryData &into) {
+    into.name = row.GetText(index + 0);
+    into.description = row.GetText(index + 1);
+    into.published = row.GetInt(index + 2) ? true : false;
+}
+
+/// Decodes the group columns, starting at given index.
+template<typename Row>
+static void DecodeGroupColumns(const Row &row, uint32 index, GroupData &into) {
+    into.category = EVEItemCategories(row.GetUInt(index + 0));
+    into.name = row.GetText(index + 1);
+    into.description = row.GetText(index + 2);
+    into.useBasePrice = row.GetInt(index + 3) ? true : false;
+    into.allowManufacture = row.GetInt(index + 4) ? true : false;
+    into.allowRecycler = row.GetInt(index + 5) ? true : false;
+    into.anchored = row.GetInt(index + 6) ? true : false;
+    into.anchorable = row.GetInt(index + 7) ? true : false;
+    into.fittableNonSingleton = row.GetInt(index + 8) ? true : false;
+    into.published = row.GetInt(index + 9) ? true : false;
+}
+
 bool InventoryDB::GetCategory(EVEItemCategories category, CategoryData &into) {
     DBQueryResult res;
 
@@ -54,10 +120,16 @@ bool InventoryDB::GetCategory(EVEItemCategories category, CategoryData &into) {
         return false;
     }
 
-    into.name = row.GetText(0);
-    into.description = row.GetText(1);
-    into.published = row.GetInt(2) ? true : false;
+    DecodeCategoryColumns(row, 0, into);
+
+    return true;
+}
+
+bool InventoryDB::DecodeCategory(const DBSnapshotRow &row, CategoryData &into) {
+    if(row.ColumnCount() != 1 + 3)
+        return false;
 
+    DecodeCategoryColumns(row, 1, into);
     return true;
 }
 
@@ -90,24 +162,23 @@ bool InventoryDB::GetGroup(uint32 groupID, GroupData &into) {
         return false;
     }
 
-    into.category = EVEItemCategories(row.GetUInt(0));
-    into.name = row.GetText(1);
-    into.description = row.GetText(2);
-    into.useBasePrice = row.GetInt(3) ? true : false;
-    into.allowManufacture = row.GetInt(4) ? true : false;
-    into.allowRecycler = row.GetInt(5) ? true : false;
-    into.anchored = row.GetInt(6) ? true : false;
-    into.anchorable = row.GetInt(7) ? true : false;
-    into.fittableNonSingleton = row.GetInt(8) ? true : false;
-    into.published = row.GetInt(9) ? true : false;
+    DecodeGroupColumns(row, 0, into);
 
     return true;
 }
 
+bool InventoryDB::DecodeGroup(const DBSnapshotRow &row, GroupData &into) {
+    if(row.ColumnCount() != 1 + 10)
+        return false;
+
+    DecodeGroupColumns(row, 1, into);
+    return true;
+}
+
 bool InventoryDB::GetType(uint32 typeID, TypeData &into) {
     DBQueryResult res;
 
-    if(!sDatabase.RunQuery(res,
+    if(!sDatabase.RunPrepared(res,
         "SELECT"
         " groupID,"
         " typeName,"
@@ -123,36 +194,25 @@ bool InventoryDB::GetType(uint32 typeID, TypeData &into) {
         " marketGroupID,"
         " chanceOfDuplicating"
         " FROM invTypes"
-        " WHERE typeID=%u",
-        typeID))
+        " WHERE typeID=?",
+        DBParams().Add(typeID)))
     {
         _log(DATABASE__ERROR, "Failed to query type %u: %s.", typeID, res.error.c_str());
         return false;
     }
 
-    DBResultRow row;
-    if(!res.GetRow(row)) {
+    if(!TypeDataSchema::GetRow(res, into)) {
         _log(DATABASE__ERROR, "Type %u not found.", typeID);
         return false;
     }
 
-    into.groupID = row.GetUInt(0);
-    into.name = row.GetText(1);
-    into.description = row.GetText(2);
-    into.radius = row.GetDouble(3);
-    into.mass = row.GetDouble(4);
-    into.volume = row.GetDouble(5);
-    into.capacity = row.GetDouble(6);
-    into.portionSize = row.GetUInt(7);
-    into.race = EVERace(row.IsNull(8) ? 0 : row.GetUInt(8));
-    into.basePrice = row.GetDouble(9);
-    into.published = row.GetInt(10) ? true : false;
-    into.marketGroupID = row.IsNull(11) ? 0 : row.GetUInt(11);
-    into.chanceOfDuplicating = row.GetDouble(12);
-
     return true;
 }
 
+bool InventoryDB::DecodeType(const DBSnapshotRow &row, TypeData &into) {
+    return TypeDataSchema::Decode(row, into, 1);
+}
+
 bool InventoryDB::GetBlueprintType(uint32 blueprintTypeID, BlueprintTypeData &into) {
     DBQueryResult res;
 
@@ -382,117 +442,104 @@ bool InventoryDB::GetStationType(uint32 stationTypeID, StationTypeData &into) {
 }
 
 bool InventoryDB::GetItem(uint32 itemID, ItemData &into) {
+    //the rows may be waiting to be written
+    sInventoryWriteBehind.Flush();
+
     DBQueryResult res;
 
     // For certain ranges of itemID-s we use specialized tables:
     if(IsRegion(itemID)) {
         //region
-        if(!sDatabase.RunQuery(res,
+        if(!sDatabase.RunPrepared(res,
             "SELECT"
             " regionName, 3 AS typeID, factionID, 1 AS locationID, 0 AS flag, 0 AS contraband,"
             " 1 AS singleton, 1 AS quantity, x, y, z, '' AS customInfo"
             " FROM mapRegions"
-            " WHERE regionID=%u", itemID))
+            " WHERE regionID=?", DBParams().Add(itemID)))
         {
             codelog(SERVICE__ERROR, "Error in query for region %u: %s", itemID, res.error.c_str());
             return NULL;
         }
     } else if(IsConstellation(itemID)) {
         //contellation
-        if(!sDatabase.RunQuery(res,
+        if(!sDatabase.RunPrepared(res,
             "SELECT"
             " constellationName, 4 AS typeID, factionID, regionID, 0 AS flag, 0 AS contraband,"
             " 1 AS singleton, 1 AS quantity, x, y, z, '' AS customInfo"
             " FROM mapConstellations"
-            " WHERE constellationID=%u", itemID))
+            " WHERE constellationID=?", DBParams().Add(itemID)))
         {
             codelog(SERVICE__ERROR, "Error in query for contellation %u: %s", itemID, res.error.c_str());
             return NULL;
         }
     } else if(IsSolarSystem(itemID)) {
         //solar system
-        if(!sDatabase.RunQuery(res,
+        if(!sDatabase.RunPrepared(res,
             "SELECT"
             " solarSystemName, 5 AS typeID, factionID, constellationID, 0 AS flag, 0 AS contraband,"
             " 1 AS singleton, 1 AS quantity, x, y, z, '' AS customInfo"
             " FROM mapSolarSystems"
-            " WHERE solarSystemID=%u", itemID))
+            " WHERE solarSystemID=?", DBParams().Add(itemID)))
         {
             codelog(SERVICE__ERROR, "Error in query for solar system %u: %s", itemID, res.error.c_str());
             return NULL;
         }
     } else if(IsUniverseCelestial(itemID)) {
         //use mapDenormalize
-        if(!sDatabase.RunQuery(res,
+        if(!sDatabase.RunPrepared(res,
             "SELECT"
             " itemName, typeID, 1 AS ownerID, solarSystemID, 0 AS flag, 0 AS contraband,"
             " 1 AS singleton, 1 AS quantity, x, y, z, '' AS customInfo"
             " FROM mapDenormalize"
-            " WHERE itemID=%u", itemID))
+            " WHERE itemID=?", DBParams().Add(itemID)))
         {
             codelog(SERVICE__ERROR, "Error in query for universe celestial %u: %s", itemID, res.error.c_str());
             return NULL;
         }
     } else if(IsStargate(itemID)) {
         //use mapDenormalize LEFT-JOIN-ing mapSolarSystems to get factionID
-        if(!sDatabase.RunQuery(res,
+        if(!sDatabase.RunPrepared(res,
             "SELECT"
             " itemName, typeID, factionID, solarSystemID, 0 AS flag, 0 AS contraband,"
             " 1 AS singleton, 1 AS quantity, mapDenormalize.x, mapDenormalize.y, mapDenormalize.z, '' AS customInfo"
             " FROM mapDenormalize"
             " LEFT JOIN mapSolarSystems USING (solarSystemID)"
-            " WHERE itemID=%u", itemID))
+            " WHERE itemID=?", DBParams().Add(itemID)))
         {
             codelog(SERVICE__ERROR, "Error in query for stargate %u: %s", itemID, res.error.c_str());
             return NULL;
         }
     } else if(IsStation(itemID)) {
         //station
-        if(!sDatabase.RunQuery(res,
+        if(!sDatabase.RunPrepared(res,
             "SELECT"
             " stationName, stationTypeID, corporationID, solarSystemID, 0 AS flag, 0 AS contraband,"
             " 1 AS singleton, 1 AS quantity, x, y, z, '' AS customInfo"
             " FROM staStations"
-            " WHERE stationID=%u", itemID))
+            " WHERE stationID=?", DBParams().Add(itemID)))
         {
             codelog(SERVICE__ERROR, "Error in query for station %u: %s", itemID, res.error.c_str());
             return NULL;
         }
     } else {
         //fallback to entity
-        if(!sDatabase.RunQuery(res,
+        if(!sDatabase.RunPrepared(res,
             "SELECT"
             " itemName, typeID, ownerID, locationID, flag, contraband,"
             " singleton, quantity, x, y, z, customInfo"
-            " FROM entity WHERE itemID=%u", itemID))
+            " FROM entity WHERE itemID=?", DBParams().Add(itemID)))
         {
             codelog(SERVICE__ERROR, "Error in query for item %u: %s", itemID, res.error.c_str());
             return NULL;
         }
     }
 
-    DBResultRow row;
-    if(!res.GetRow(row))
+    if(!ItemDataSchema::GetRow(res, into))
     {
         codelog(SERVICE__ERROR, "Item %u not found.", itemID);
         return false;
     }
 
-    into.name = row.GetText(0);
-    into.typeID = row.GetUInt(1);
-    into.ownerID = (row.IsNull(2) ? 1 : row.GetUInt(2));
-    into.locationID = (row.IsNull(3) ? 1 : row.GetUInt(3));
-    into.flag = (EVEItemFlags)row.GetUInt(4);
-    into.contraband = (row.GetInt(5) ? true : false);
-    into.singleton = (row.GetInt(6) ? true : false);
-    into.quantity = row.GetUInt(7);
-
-    into.position.x = row.GetDouble(8);
-    into.position.y = row.GetDouble(9);
-    into.position.z = row.GetDouble(10);
-
-    into.customInfo = (row.IsNull(11) ? "" : row.GetText(11));
-
     return true;
 }
 
@@ -525,6 +572,128 @@ uint32 InventoryDB::NewItem(const ItemData &data) {
     return(eid);
 }
 
+bool InventoryDB::NewItem(uint32 itemID, const ItemData &data) {
+    DBerror err;
+
+    std::string nameEsc, customInfoEsc;
+    sDatabase.DoEscapeString(nameEsc, data.name);
+    sDatabase.DoEscapeString(customInfoEsc, data.customInfo);
+
+    if(!sDatabase.RunQuery(err,
+        "INSERT INTO entity ("
+        "   itemID, itemName, typeID, ownerID, locationID, flag,"
+        "   contraband, singleton, quantity, x, y, z,"
+        "   customInfo"
+        " ) "
+        "VALUES(%u, '%s', %u, %u, %u, %u,"
+        "   %u, %u, %u, %f, %f, %f,"
+        "   '%s' )",
+        itemID, nameEsc.c_str(), data.typeID, data.ownerID, data.locationID, data.flag,
+        data.contraband?1:0, data.singleton?1:0, data.quantity, data.position.x, data.position.y, data.position.z,
+        customInfoEsc.c_str()
+        )
+    ) {
+        codelog(SERVICE__ERROR, "Failed to insert entity %u: %s", itemID, err.c_str());
+        return false;
+    }
+
+    return true;
+}
+
+/// Head of the multi-row entity inserts; the rows go after it.
+static const char *const NEW_ENTITIES_QUERY =
+    "INSERT INTO entity ("
+    "   itemName, typeID, ownerID, locationID, flag,"
+    "   contraband, singleton, quantity, x, y, z,"
+    "   customInfo"
+    " ) VALUES ";
+
+/**
+ * Appends a row of an entity insert.
+ *
+ * @param[in] ownerID SQL expression of the owner; the owner of data if NULL.
+ * @param[in] locationID SQL expression of the location; the location of data if NULL.
+ */
+static void _AppendEntityRow(std::string &query, const ItemData &data, const char *ownerID = NULL, const char *locationID = NULL) {
+    std::string nameEsc, customInfoEsc;
+    sDatabase.DoEscapeString(nameEsc, data.name);
+    sDatabase.DoEscapeString(customInfoEsc, data.customInfo);
+
+    char owner[16], location[16];
+    if(ownerID == NULL) {
+        snprintf(owner, sizeof(owner), "%u", data.ownerID);
+        ownerID = owner;
+    }
+    if(locationID == NULL) {
+        snprintf(location, sizeof(location), "%u", data.locationID);
+        locationID = location;
+    }
+
+    char buf[256];
+    snprintf(buf, sizeof(buf), "%u, %s, %s, %u, %u, %u, %u, %f, %f, %f, ",
+        data.typeID, ownerID, locationID, data.flag,
+        data.contraband?1:0, data.singleton?1:0, data.quantity, data.position.x, data.position.y, data.position.z);
+    //the escaped strings carry their terminator
+    query += "('";
+    query += nameEsc.c_str();
+    query += "', ";
+    query += buf;
+    query += "'";
+    query += customInfoEsc.c_str();
+    query += "')";
+}
+
+bool InventoryDB::NewItems(const std::vector<ItemData> &data, std::vector<uint32> &into) {
+    if(data.empty())
+        return true;
+
+    std::string query = NEW_ENTITIES_QUERY;
+
+    std::vector<ItemData>::const_iterator cur, end;
+    cur = data.begin();
+    end = data.end();
+    for(; cur != end; cur++) {
+        if(cur != data.begin())
+            query += ", ";
+        _AppendEntityRow(query, *cur);
+    }
+
+    DBerror err;
+    uint32 firstID;
+    //LAST_INSERT_ID() is the ID of the first row of a multi-row insert
+    if(!sDatabase.RunQueryLID(err, firstID, "%s", query.c_str())) {
+        codelog(SERVICE__ERROR, "Failed to insert %lu new entities: %s", (unsigned long)data.size(), err.c_str());
+        return false;
+    }
+
+    for(uint32 i = 0; i < data.size(); i++)
+        into.push_back(firstID + i);
+
+    return true;
+}
+
+bool InventoryDB::GetLastItemID(uint32 fromID, uint32 toID, uint32 &into) {
+    DBQueryResult res;
+
+    if(!sDatabase.RunQuery(res,
+        "SELECT MAX(itemID)"
+        " FROM entity"
+        " WHERE itemID >= %u AND itemID < %u",
+        fromID, toID))
+    {
+        codelog(SERVICE__ERROR, "Error in query: %s", res.error.c_str());
+        return false;
+    }
+
+    DBResultRow row;
+    if(!res.GetRow(row) || row.IsNull(0))
+        into = 0;
+    else
+        into = row.GetUInt(0);
+
+    return true;
+}
+
 bool InventoryDB::SaveItem(uint32 itemID, const ItemData &data) {
     // First check whether they are trying to save proper item:
     if(IsStaticMapItem(itemID)) {
@@ -532,6 +701,11 @@ bool InventoryDB::SaveItem(uint32 itemID, const ItemData &data) {
         return false;
     }
 
+    if(sInventoryWriteBehind.IsEnabled()) {
+        sInventoryWriteBehind.SaveItem(itemID, data);
+        return true;
+    }
+
     DBerror err;
 
     std::string nameEsc, customInfoEsc;
@@ -578,6 +752,9 @@ bool InventoryDB::DeleteItem(uint32 itemID) {
         return false;
     }
 
+    //the attributes are deleted separately, but go with the item
+    sInventoryWriteBehind.Forget(itemID);
+
     DBerror err;
 
     //NOTE: all child entities should be deleted by the caller first.
@@ -602,14 +779,17 @@ bool InventoryDB::DeleteItem(uint32 itemID) {
 // solution until it becomes a problem.
 bool InventoryDB::GetItemContents(uint32 itemID, std::vector<uint32> &into)
 {
+    //the rows may be waiting to be written
+    sInventoryWriteBehind.Flush();
+
     DBQueryResult res;
 
-    if( !sDatabase.RunQuery( res,
+    if( !sDatabase.RunPrepared( res,
         "SELECT "
         " itemID"
         " FROM entity "
-        " WHERE locationID = %u",
-        itemID ) )
+        " WHERE locationID = ?",
+        DBParams().Add( itemID ) ) )
     {
         codelog(SERVICE__ERROR, "Error in query for item %u: %s", itemID, res.error.c_str());
         return false;
@@ -621,17 +801,171 @@ bool InventoryDB::GetItemContents(uint32 itemID, std::vector<uint32> &into)
 
     return true;
 }
-bool InventoryDB::GetItemContents(uint32 itemID, EVEItemFlags flag, std::vector<uint32> &into)
+bool InventoryDB::GetItemContents(const std::vector<uint32> &containerIDs, std::map<uint32, ItemData> &into)
+{
+    if( containerIDs.empty() )
+        return true;
+
+    //the rows may be waiting to be written
+    sInventoryWriteBehind.Flush();
+
+    std::string inList;
+    ListToINString( containerIDs, inList );
+
+    DBQueryResult res;
+
+    if( !sDatabase.RunQuery( res,
+        "SELECT"
+        " itemID, itemName, typeID, ownerID, locationID, flag, contraband,"
+        " singleton, quantity, x, y, z, customInfo"
+        " FROM entity"
+        " WHERE locationID IN (%s)",
+        inList.c_str() ) )
+    {
+        codelog(SERVICE__ERROR, "Error in query for contents of %s: %s", inList.c_str(), res.error.c_str());
+        return false;
+    }
+
+    DBResultRow row;
+    while( res.GetRow( row ) )
+    {
+        if( !ItemDataSchema::Decode( row, into[ row.GetUInt( 0 ) ], 1 ) )
+        {
+            codelog(SERVICE__ERROR, "Unexpected columns in query for contents of %s", inList.c_str());
+            return false;
+        }
+    }
+
+    return true;
+}
+
+bool InventoryDB::GetItemContentsAttributes(const std::vector<uint32> &containerIDs, std::map<uint32, ItemAttributeList> &into)
 {
+    if( containerIDs.empty() )
+        return true;
+
+    //the rows may be waiting to be written
+    sInventoryWriteBehind.Flush();
+
+    std::string inList;
+    ListToINString( containerIDs, inList );
+
     DBQueryResult res;
 
     if( !sDatabase.RunQuery( res,
+        "SELECT"
+        " entity_attributes.itemID, attributeID, valueInt, valueFloat"
+        " FROM entity_attributes"
+        " JOIN entity USING (itemID)"
+        " WHERE locationID IN (%s)",
+        inList.c_str() ) )
+    {
+        codelog(SERVICE__ERROR, "Error in query for attributes of contents of %s: %s", inList.c_str(), res.error.c_str());
+        return false;
+    }
+
+    DBResultRow row;
+    while( res.GetRow( row ) )
+    {
+        EvilNumber value;
+        if( !row.IsNull( 2 ) )
+            value = row.GetInt64( 2 );
+        else
+            value = row.GetDouble( 3 );
+
+        into[ row.GetUInt( 0 ) ].push_back( std::make_pair( row.GetUInt( 1 ), value ) );
+    }
+
+    return true;
+}
+
+bool InventoryDB::GetLoginItems(uint32 characterID, uint32 &shipID, uint32 &solarSystemID,
+                                std::map<uint32, ItemData> &items, std::map<uint32, ItemAttributeList> &attributes)
+{
+    DBQueryResult res;
+
+    if( !sDatabase.RunQuery( res,
+        "SELECT shipID, solarSystemID"
+        " FROM character_"
+        " WHERE characterID = %u",
+        characterID ) )
+    {
+        codelog(SERVICE__ERROR, "Error in query for ship of character %u: %s", characterID, res.error.c_str());
+        return false;
+    }
+
+    DBResultRow row;
+    if( !res.GetRow( row ) )
+    {
+        codelog(SERVICE__ERROR, "Character %u not found.", characterID);
+        return false;
+    }
+
+    shipID = row.GetUInt( 0 );
+    solarSystemID = row.GetUInt( 1 );
+
+    //the character and its ship, and whatever is in them
+    if( !sDatabase.RunQuery( res,
+        "SELECT"
+        " itemID, itemName, typeID, ownerID, locationID, flag, contraband,"
+        " singleton, quantity, x, y, z, customInfo"
+        " FROM entity"
+        " WHERE itemID IN (%u, %u) OR locationID IN (%u, %u)",
+        characterID, shipID, characterID, shipID ) )
+    {
+        codelog(SERVICE__ERROR, "Error in query for items of character %u: %s", characterID, res.error.c_str());
+        return false;
+    }
+
+    while( res.GetRow( row ) )
+    {
+        if( !ItemDataSchema::Decode( row, items[ row.GetUInt( 0 ) ], 1 ) )
+        {
+            codelog(SERVICE__ERROR, "Unexpected columns in query for items of character %u", characterID);
+            return false;
+        }
+    }
+
+    if( !sDatabase.RunQuery( res,
+        "SELECT"
+        " entity_attributes.itemID, attributeID, valueInt, valueFloat"
+        " FROM entity_attributes"
+        " JOIN entity USING (itemID)"
+        " WHERE itemID IN (%u, %u) OR locationID IN (%u, %u)",
+        characterID, shipID, characterID, shipID ) )
+    {
+        codelog(SERVICE__ERROR, "Error in query for attributes of items of character %u: %s", characterID, res.error.c_str());
+        return false;
+    }
+
+    while( res.GetRow( row ) )
+    {
+        EvilNumber value;
+        if( !row.IsNull( 2 ) )
+            value = row.GetInt64( 2 );
+        else
+            value = row.GetDouble( 3 );
+
+        attributes[ row.GetUInt( 0 ) ].push_back( std::make_pair( row.GetUInt( 1 ), value ) );
+    }
+
+    return true;
+}
+
+bool InventoryDB::GetItemContents(uint32 itemID, EVEItemFlags flag, std::vector<uint32> &into)
+{
+    //the rows may be waiting to be written
+    sInventoryWriteBehind.Flush();
+
+    DBQueryResult res;
+
+    if( !sDatabase.RunPrepared( res,
         "SELECT "
         " itemID"
         " FROM entity "
-        " WHERE locationID=%u"
-        "  AND flag=%d",
-        itemID, (int)flag ) )
+        " WHERE locationID=?"
+        "  AND flag=?",
+        DBParams().Add( itemID ).Add( (int32)flag ) ) )
     {
         codelog(SERVICE__ERROR, "Error in query for item %u: %s", itemID, res.error.c_str());
         return false;
@@ -646,16 +980,19 @@ bool InventoryDB::GetItemContents(uint32 itemID, EVEItemFlags flag, std::vector<
 
 bool InventoryDB::GetItemContents(uint32 itemID, EVEItemFlags flag, uint32 ownerID, std::vector<uint32> &into)
 {
+    //the rows may be waiting to be written
+    sInventoryWriteBehind.Flush();
+
     DBQueryResult res;
 
-    if( !sDatabase.RunQuery( res,
+    if( !sDatabase.RunPrepared( res,
         "SELECT "
         " itemID"
         " FROM entity "
-        " WHERE locationID=%u"
-        "  AND flag=%d"
-        "  AND ownerID=%u",
-        itemID, (int)flag, ownerID ) )
+        " WHERE locationID=?"
+        "  AND flag=?"
+        "  AND ownerID=?",
+        DBParams().Add( itemID ).Add( (int32)flag ).Add( ownerID ) ) )
     {
         codelog(SERVICE__ERROR, "Error in query for item %u: %s", itemID, res.error.c_str());
         return false;
@@ -707,25 +1044,27 @@ bool InventoryDB::LoadTypeAttributes(uint32 typeID, EVEAttributeMgr &into) {
     }
 #else
 
-    DgmTypeAttributeSet *attrset = sDgmTypeAttrMgr.GetDmgTypeAttributeSet(typeID);
+    DgmTypeAttributeSet attrset;
 
     // if not found return true because there can be items without attributes I guess
-    if (attrset == NULL)
+    if (!sDgmTypeAttrMgr.GetDmgTypeAttributeSet(typeID, attrset))
         return true;
 
-    DgmTypeAttributeSet::AttrSetItr itr = attrset->begin();
-
-    for (; itr != attrset->end(); itr++) {
-        if ((*itr)->number.get_type() == evil_number_int)
-            into.SetInt((EVEAttributeMgr::Attr)(*itr)->attributeID, static_cast<int32>((*itr)->number.get_int()));
+    for (uint32 i = 0; i < attrset.size(); i++) {
+        EvilNumber number = attrset.value(i);
+        if (number.get_type() == evil_number_int)
+            into.SetInt((EVEAttributeMgr::Attr)attrset.attributeID(i), static_cast<int32>(number.get_int()));
         else
-            into.SetReal((EVEAttributeMgr::Attr)(*itr)->attributeID, (*itr)->number.get_float());
+            into.SetReal((EVEAttributeMgr::Attr)attrset.attributeID(i), number.get_float());
     }
 #endif
     return true;
 }
 
 bool InventoryDB::LoadItemAttributes(uint32 itemID, EVEAttributeMgr &into) {
+    //the rows may be waiting to be written
+    sInventoryWriteBehind.Flush();
+
     DBQueryResult res;
 
     if(!sDatabase.RunQuery(res,
@@ -766,6 +1105,11 @@ bool InventoryDB::LoadItemAttributes(uint32 itemID, EVEAttributeMgr &into) {
 }
 
 bool InventoryDB::UpdateAttribute_int(uint32 itemID, uint32 attributeID, int v) {
+    if(sInventoryWriteBehind.IsEnabled()) {
+        sInventoryWriteBehind.SaveAttribute(itemID, attributeID, (int64)v);
+        return true;
+    }
+
     DBerror err;
     if(!sDatabase.RunQuery(err,
         "REPLACE INTO entity_attributes"
@@ -781,6 +1125,11 @@ bool InventoryDB::UpdateAttribute_int(uint32 itemID, uint32 attributeID, int v)
 }
 
 bool InventoryDB::UpdateAttribute_double(uint32 itemID, uint32 attributeID, double v) {
+    if(sInventoryWriteBehind.IsEnabled()) {
+        sInventoryWriteBehind.SaveAttribute(itemID, attributeID, v);
+        return true;
+    }
+
     DBerror err;
     if(!sDatabase.RunQuery(err,
         "REPLACE INTO entity_attributes"
@@ -795,6 +1144,11 @@ bool InventoryDB::UpdateAttribute_double(uint32 itemID, uint32 attributeID, doub
     return true;
 }
 bool InventoryDB::EraseAttribute(uint32 itemID, uint32 attributeID) {
+    if(sInventoryWriteBehind.IsEnabled()) {
+        sInventoryWriteBehind.EraseAttribute(itemID, attributeID);
+        return true;
+    }
+
     DBerror err;
     if(!sDatabase.RunQuery(err,
         "DELETE FROM entity_attributes"
@@ -808,6 +1162,8 @@ bool InventoryDB::EraseAttribute(uint32 itemID, uint32 attributeID) {
 }
 
 bool InventoryDB::EraseAttributes(uint32 itemID) {
+    sInventoryWriteBehind.Forget(itemID, true);
+
     DBerror err;
     if(!sDatabase.RunQuery(err,
         "DELETE"
@@ -911,6 +1267,9 @@ bool InventoryDB::DeleteBlueprint(uint32 blueprintID) {
 bool InventoryDB::GetCharacter(uint32 characterID, CharacterData &into) {
     DBQueryResult res;
 
+    //the trades change the balance in place
+    sMarketJournal.Flush();
+
     if(!sDatabase.RunQuery(res,
         "SELECT"
         "  chr.accountID,"
@@ -1058,36 +1417,53 @@ static std::string _ToStr(double v) {
     return(buf);
 }
 
-bool InventoryDB::NewCharacter(uint32 characterID, const CharacterData &data, const CharacterAppearance &appData, const CorpMemberInfo &corpData) {
-    DBerror err;
-
+/**
+ * Builds the insert of a character_ row.
+ *
+ * @param[in] characterID SQL expression of the characterID.
+ * @param[in] shipID SQL expression of the shipID.
+ */
+static std::string _NewCharacterQuery(const char *characterID, const char *shipID, const CharacterData &data, const CorpMemberInfo &corpData) {
     std::string titleEsc, descriptionEsc;
     sDatabase.DoEscapeString(titleEsc, data.title);
     sDatabase.DoEscapeString(descriptionEsc, data.description);
 
-    // Table character_ goes first
-    if(!sDatabase.RunQuery(err,
+    std::string query;
+    sprintf(query,
         "INSERT INTO character_"
         // CharacterData:
         "  (characterID, accountID, title, description, bounty, balance, securityRating, petitionMessage,"
         "   logonMinutes, corporationID, corpRole, rolesAtAll, rolesAtBase, rolesAtHQ, rolesAtOther,"
         "   corporationDateTime, startDateTime, createDateTime,"
         "   ancestryID, careerID, schoolID, careerSpecialityID, gender,"
-        "   stationID, solarSystemID, constellationID, regionID, freeRespecs, nextRespec)"
+        "   stationID, solarSystemID, constellationID, regionID, freeRespecs, nextRespec, shipID)"
         " VALUES"
         // CharacterData:
-        "  (%u, %u, '%s', '%s', %f, %f, %f, '%s',"
+        "  (%s, %u, '%s', '%s', %f, %f, %f, '%s',"
         "   %u, %u, %" PRIu64 ", %" PRIu64 ", %" PRIu64 ", %" PRIu64 ", %" PRIu64 ", "
         "   %" PRIu64 ", %" PRIu64 ", %" PRIu64 ","
         "   %u, %u, %u, %u, %u,"
-        "   %u, %u, %u, %u, %u, %u)",
+        "   %u, %u, %u, %u, %u, %u, %s)",
         // CharacterData:
         characterID, data.accountID, titleEsc.c_str(), descriptionEsc.c_str(), data.bounty, data.balance, data.securityRating, "No petition",
         data.logonMinutes, data.corporationID, corpData.corpRole, corpData.rolesAtAll, corpData.rolesAtBase, corpData.rolesAtHQ, corpData.rolesAtOther,
         data.corporationDateTime, data.startDateTime, data.createDateTime,
         data.ancestryID, data.careerID, data.schoolID, data.careerSpecialityID, data.gender,
-        data.stationID, data.solarSystemID, data.constellationID, data.regionID, 2, 0
-    )) {
+        data.stationID, data.solarSystemID, data.constellationID, data.regionID, 2, 0, shipID
+    );
+
+    return query;
+}
+
+bool InventoryDB::NewCharacter(uint32 characterID, const CharacterData &data, const CharacterAppearance &appData, const CorpMemberInfo &corpData) {
+    DBerror err;
+
+    char charID[16], shipID[16];
+    snprintf(charID, sizeof(charID), "%u", characterID);
+    snprintf(shipID, sizeof(shipID), "%u", data.shipID);
+
+    // Table character_ goes first
+    if(!sDatabase.RunQuery(err, "%s", _NewCharacterQuery(charID, shipID, data, corpData).c_str())) {
         _log(DATABASE__ERROR, "Failed to insert character %u: %s.", characterID, err.c_str());
         return false;
     }
@@ -1116,12 +1492,112 @@ bool InventoryDB::NewCharacter(uint32 characterID, const CharacterData &data, co
         //just let it go... its a lot easier this way
     }
 
+    sCorpRoster.AddMember(characterID, data.corporationID, data.title, data.corporationDateTime, corpData);
+
+    return true;
+}
+
+bool InventoryDB::NewCharacterWithItems(const ItemData &data, const CharacterData &charData, const CorpMemberInfo &corpData,
+                                        const ItemAttributeList &attributes, const std::vector<ItemData> &items,
+                                        const std::vector<ItemAttributeList> &itemAttributes, size_t shipIndex,
+                                        uint32 &characterID, std::vector<uint32> &itemIDs)
+{
+    if(items.size() <= shipIndex || items.size() != itemAttributes.size()) {
+        codelog(SERVICE__ERROR, "Refusing to insert character '%s' with no ship or mismatched attributes.", data.name.c_str());
+        return false;
+    }
+
+    std::vector<std::string> queries;
+    std::string query;
+
+    // the character's entity; its ID goes into everything else
+    query = NEW_ENTITIES_QUERY;
+    _AppendEntityRow(query, data);
+    queries.push_back(query);
+    queries.push_back("SET @charID = LAST_INSERT_ID()");
+
+    // all the items in one go; the IDs of a multi-row insert are consecutive (see NewItems())
+    query = NEW_ENTITIES_QUERY;
+    for(size_t i = 0; i < items.size(); i++) {
+        if(i != 0)
+            query += ", ";
+        _AppendEntityRow(query, items[i], "@charID", items[i].locationID == 0 ? "@charID" : NULL);
+    }
+    queries.push_back(query);
+    queries.push_back("SET @itemID = LAST_INSERT_ID()");
+
+    char shipID[32];
+    snprintf(shipID, sizeof(shipID), "@itemID + %lu", (unsigned long)shipIndex);
+    queries.push_back(_NewCharacterQuery("@charID", shipID, charData, corpData));
+
+    sprintf(query,
+        "INSERT INTO chrEmployment"
+        "  (characterID, corporationID, startDate, deleted)"
+        " VALUES"
+        "  (@charID, %u, %" PRIu64 ", 0)",
+        charData.corporationID, Win32TimeNow());
+    queries.push_back(query);
+
+    sprintf(query,
+        "UPDATE corporation"
+        "  SET memberCount = memberCount + 1"
+        " WHERE corporationID = %u",
+        charData.corporationID);
+    queries.push_back(query);
+
+    // the attributes, so the loads find them stored already
+    query.clear();
+    char buf[128];
+    for(size_t i = 0; i <= items.size(); i++) {
+        const ItemAttributeList &attrs = (i == 0 ? attributes : itemAttributes[i - 1]);
+        char itemID[32];
+        if(i == 0)
+            snprintf(itemID, sizeof(itemID), "@charID");
+        else
+            snprintf(itemID, sizeof(itemID), "@itemID + %lu", (unsigned long)(i - 1));
+
+        ItemAttributeList::const_iterator cur, end;
+        cur = attrs.begin();
+        end = attrs.end();
+        for(; cur != end; cur++) {
+            EvilNumber value = cur->second;
+            if(value.get_type() == evil_number_int)
+                snprintf(buf, sizeof(buf), "(%s, %u, %" PRId64 ", NULL)", itemID, cur->first, value.get_int());
+            else
+                snprintf(buf, sizeof(buf), "(%s, %u, NULL, %.17g)", itemID, cur->first, value.get_float());
+
+            query += (query.empty() ? "INSERT INTO entity_attributes (itemID, attributeID, valueInt, valueFloat) VALUES " : ", ");
+            query += buf;
+        }
+    }
+    if(!query.empty())
+        queries.push_back(query);
+
+    queries.push_back("SELECT @charID, @itemID");
+
+    DBQueryResult res;
+    DBResultRow row;
+    if(!sDatabase.RunTransaction(res, queries) || !res.GetRow(row)) {
+        _log(DATABASE__ERROR, "Failed to insert character '%s': %s.", data.name.c_str(), res.error.c_str());
+        return false;
+    }
+
+    characterID = row.GetUInt(0);
+    const uint32 firstID = row.GetUInt(1);
+    for(uint32 i = 0; i < items.size(); i++)
+        itemIDs.push_back(firstID + i);
+
+    sCorpRoster.AddMember(characterID, charData.corporationID, charData.title, charData.corporationDateTime, corpData);
+
     return true;
 }
 
 bool InventoryDB::SaveCharacter(uint32 characterID, const CharacterData &data) {
     DBerror err;
 
+    //the balance changes of the trades go first, the whole balance overwrites them
+    sMarketJournal.Flush();
+
     std::string titleEsc;
     sDatabase.DoEscapeString(titleEsc, data.title);
 
@@ -1187,6 +1663,35 @@ bool InventoryDB::SaveCharacter(uint32 characterID, const CharacterData &data) {
     return true;
 }
 
+bool InventoryDB::SaveCharacterLocations(const std::vector<uint32> &characterIDs, uint32 stationID, uint32 solarSystemID, uint32 constellationID, uint32 regionID) {
+    if( characterIDs.empty() )
+        return true;
+
+    std::string ids;
+    ListToINString( characterIDs, ids );
+
+    DBerror err;
+    if(!sDatabase.RunQuery(err,
+        "UPDATE character_"
+        " SET"
+        "  stationID = %u,"
+        "  solarSystemID = %u,"
+        "  constellationID = %u,"
+        "  regionID = %u"
+        " WHERE characterID IN (%s)",
+        stationID,
+        solarSystemID,
+        constellationID,
+        regionID,
+        ids.c_str()))
+    {
+        _log(DATABASE__ERROR, "Failed to save the location of %lu characters: %s.", (unsigned long)characterIDs.size(), err.c_str());
+        return false;
+    }
+
+    return true;
+}
+
 bool InventoryDB::SaveCorpMemberInfo(uint32 characterID, const CorpMemberInfo &data) {
     DBerror err;
 
@@ -1210,6 +1715,8 @@ bool InventoryDB::SaveCorpMemberInfo(uint32 characterID, const CorpMemberInfo &d
         return false;
     }
 
+    sCorpRoster.UpdateRoles(characterID, data);
+
     return true;
 }
 
@@ -1217,6 +1724,17 @@ bool InventoryDB::SaveCorpMemberInfo(uint32 characterID, const CorpMemberInfo &d
 #undef _VoN
 
 bool InventoryDB::DeleteCharacter(uint32 characterID) {
+    //nothing of the character is left in the journal to be written afterwards
+    sMarketJournal.Flush();
+    sWalletLedger.Forget(characterID);
+    sNameIndex.Remove(NameIndex::NAME_CHARACTER, characterID);
+    sOwnerDirectory.Invalidate(characterID);
+    sCorpRoster.RemoveMember(characterID);
+    sPresence.Remove(characterID);
+    sHostilityResolver.RemoveCharacter(characterID);
+    sCharSelectCache.InvalidateCharacter(characterID);
+    sPaperDollStore.Forget(characterID);
+
     DBerror err;
 
     // eveMailDetails
@@ -1267,28 +1785,31 @@ bool InventoryDB::DeleteCharacter(uint32 characterID) {
         _log(DATABASE__MESSAGE, "Ignoring error.");
     }
 
-    // market_journal
+    // chrPaperDolls
     if(!sDatabase.RunQuery(err,
-        "DELETE FROM market_journal"
+        "DELETE FROM chrPaperDolls"
         " WHERE characterID = %u",
         characterID))
     {
-        _log(DATABASE__ERROR, "Failed to delete market journal of character %u: %s.", characterID, err.c_str());
+        _log(DATABASE__ERROR, "Failed to delete paper doll of character %u: %s.", characterID, err.c_str());
         // ignore the error
         _log(DATABASE__MESSAGE, "Ignoring error.");
     }
 
-    // market_orders
+    // market_journal
     if(!sDatabase.RunQuery(err,
-        "DELETE FROM market_orders"
-        " WHERE charID =% lu",
+        "DELETE FROM market_journal"
+        " WHERE characterID = %u",
         characterID))
     {
-        _log(DATABASE__ERROR, "Failed to delete market orders of character %u: %s.", characterID, err.c_str());
+        _log(DATABASE__ERROR, "Failed to delete market journal of character %u: %s.", characterID, err.c_str());
         // ignore the error
         _log(DATABASE__MESSAGE, "Ignoring error.");
     }
 
+    // market_orders; the order book deletes the rows
+    sMarketOrderBook.RemoveCharacterOrders(characterID);
+
     // market_transactions
     if(!sDatabase.RunQuery(err,
         "DELETE FROM market_transactions"
@@ -1322,6 +1843,17 @@ bool InventoryDB::DeleteCharacter(uint32 characterID) {
         _log(DATABASE__MESSAGE, "Ignoring error.");
     }
 
+    // chrContacts
+    if(!sDatabase.RunQuery(err,
+        "DELETE FROM chrContacts"
+        " WHERE ownerID = %u OR contactID = %u",
+        characterID, characterID))
+    {
+        _log(DATABASE__ERROR, "Failed to delete contacts of character %u: %s.", characterID, err.c_str());
+        // ignore the error
+        _log(DATABASE__MESSAGE, "Ignoring error.");
+    }
+
     // chrEmployment
     if(!sDatabase.RunQuery(err,
         "DELETE FROM chrEmployment"
@@ -1501,21 +2033,23 @@ bool InventoryDB::GetStation(uint32 stationID, StationData &into) {
     return true;
 }
 
-bool InventoryDB::LoadSkillQueue(uint32 characterID, SkillQueue &into) {
+bool InventoryDB::LoadSkillQueue(uint32 characterID, SkillQueue &into, uint32 &firstIndex) {
     DBQueryResult res;
 
-    if( !sDatabase.RunQuery( res,
+    if( !sDatabase.RunPrepared( res,
         "SELECT"
-        " typeID, level"
+        " typeID, level, orderIndex"
         " FROM chrSkillQueue"
-        " WHERE characterID = %u"
+        " WHERE characterID = ?"
         " ORDER BY orderIndex ASC",
-        characterID ) )
+        DBParams().Add( characterID ) ) )
     {
         _log(DATABASE__ERROR, "Failed to query skill queue of character %u: %s.", characterID, res.error.c_str());
         return false;
     }
 
+    firstIndex = 0;
+
     DBResultRow row;
     while( res.GetRow( row ) )
     {
@@ -1523,6 +2057,8 @@ bool InventoryDB::LoadSkillQueue(uint32 characterID, SkillQueue &into) {
         qs.typeID = row.GetUInt( 0 );
         qs.level = row.GetUInt( 1 );
 
+        if( into.empty() )
+            firstIndex = row.GetUInt( 2 );
         into.push_back( qs );
     }
 
@@ -1561,6 +2097,37 @@ bool InventoryDB::LoadCertificates( uint32 characterID, Certificates &into )
 
 }
 
+bool InventoryDB::AddCertificates( uint32 characterID, const Certificates &added )
+{
+    if( added.empty() )
+        return true;
+
+    std::string query;
+    for(size_t i = 0; i < added.size(); i++)
+    {
+        const currentCertificates &im = added[ i ];
+
+        char buf[ 64 ];
+        snprintf( buf, 64, "(NULL, %u, %u, %" PRIu64 ", %u)", characterID, im.certificateID, im.grantDate, im.visibilityFlags ? 1 : 0 );
+        if( i != 0 )
+            query += ',';
+        query += buf;
+    }
+
+    DBerror err;
+    if( !sDatabase.RunQuery( err,
+         "INSERT"
+         " INTO chrCertificates (id, characterID, certificateID, grantDate, visibilityFlags)"
+         " VALUES %s",
+         query.c_str() ))
+    {
+        _log(DATABASE__ERROR, "Failed to insert certificates of character %u: %s", characterID, err.c_str() );
+        return false;
+    }
+
+    return true;
+}
+
 bool InventoryDB::SaveCertificates( uint32 characterID, const Certificates &from )
 {
     DBerror err;
@@ -1585,7 +2152,7 @@ bool InventoryDB::SaveCertificates( uint32 characterID, const Certificates &from
         const currentCertificates &im = from[ i ];
 
         char buf[ 64 ];
-        snprintf( buf, 64, "(NULL, %u, %u, %" PRIu64 ", %u)", characterID, im.certificateID, im.grantDate, im.visibilityFlags );
+        snprintf( buf, 64, "(NULL, %u, %u, %" PRIu64 ", %u)", characterID, im.certificateID, im.grantDate, im.visibilityFlags ? 1 : 0 );
         if( i != 0 )
         query += ',';
         query += buf;
@@ -1605,34 +2172,75 @@ bool InventoryDB::SaveCertificates( uint32 characterID, const Certificates &from
     return true;
 }
 
-bool InventoryDB::SaveSkillQueue(uint32 characterID, const SkillQueue &queue) {
+static bool SameQueuedSkill(const InventoryDB::QueuedSkill &a, const InventoryDB::QueuedSkill &b) {
+    return a.typeID == b.typeID && a.level == b.level;
+}
+
+bool InventoryDB::SaveSkillQueue(uint32 characterID, const SkillQueue &saved, uint32 &firstIndex, const SkillQueue &queue) {
     DBerror err;
 
-    if( !sDatabase.RunQuery( err,
-        "DELETE"
-        " FROM chrSkillQueue"
-        " WHERE characterID = %u",
-        characterID ) )
+    // find how many saved skills were taken off the front, so that the rest
+    // agrees with the new queue as far as both of them go
+    size_t dropped = 0;
+    for(; dropped < saved.size(); dropped++)
     {
-        _log(DATABASE__ERROR, "Failed to delete skill queue of character %u: %s.", characterID, err.c_str());
-        return false;
+        const size_t common = std::min( saved.size() - dropped, queue.size() );
+
+        size_t i = 0;
+        while( i < common && SameQueuedSkill( saved[ dropped + i ], queue[ i ] ) )
+            i++;
+        if( i == common )
+            break;
     }
+    const size_t kept = std::min( saved.size() - dropped, queue.size() );
 
-    if( queue.empty() )
+    if( kept == 0 )
+    {
+        // nothing in common, start over
+        if( !saved.empty() && !sDatabase.RunPrepared( err,
+            "DELETE"
+            " FROM chrSkillQueue"
+            " WHERE characterID = ?",
+            DBParams().Add( characterID ) ) )
+        {
+            _log(DATABASE__ERROR, "Failed to delete skill queue of character %u: %s.", characterID, err.c_str());
+            return false;
+        }
+
+        firstIndex = 0;
+    }
+    else if( dropped + kept < saved.size() || dropped > 0 )
+    {
+        const uint32 keptIndex = firstIndex + dropped;
+        if( !sDatabase.RunPrepared( err,
+            "DELETE"
+            " FROM chrSkillQueue"
+            " WHERE characterID = ?"
+            " AND (orderIndex < ? OR orderIndex >= ?)",
+            DBParams().Add( characterID ).Add( keptIndex ).Add( keptIndex + (uint32)kept ) ) )
+        {
+            _log(DATABASE__ERROR, "Failed to delete skills from queue of character %u: %s.", characterID, err.c_str());
+            return false;
+        }
+
+        firstIndex = keptIndex;
+    }
+
+    if( kept == queue.size() )
         // nothing else to do
         return true;
 
-    // now build insert query:
+    // now build insert query for the skills behind the kept ones:
     std::string query;
 
-    for(size_t i = 0; i < queue.size(); i++)
+    for(size_t i = kept; i < queue.size(); i++)
     {
         const QueuedSkill &qs = queue[ i ];
 
         char buf[ 64 ];
-        snprintf( buf, 64, "(%u, %lu, %u, %u)", characterID, (unsigned long)i, qs.typeID, qs.level );
+        snprintf( buf, 64, "(%u, %lu, %u, %u)", characterID, (unsigned long)( firstIndex + i ), qs.typeID, qs.level );
 
-        if( i != 0 )
+        if( i != kept )
             query += ',';
         query += buf;
     }
@@ -1649,6 +2257,33 @@ bool InventoryDB::SaveSkillQueue(uint32 characterID, const SkillQueue &queue) {
 
     return true;
 }
+
+bool InventoryDB::GetOfflineCharactersWithDueSkills(uint64 now, uint32 limit, std::vector<uint32> &into) {
+    DBQueryResult res;
+
+    if( !sDatabase.RunPrepared( res,
+        "SELECT DISTINCT"
+        " entity.locationID"
+        " FROM entity"
+        " JOIN entity_attributes ON entity_attributes.itemID = entity.itemID"
+        " JOIN character_ ON character_.characterID = entity.locationID"
+        " WHERE entity.flag = ?"
+        " AND entity_attributes.attributeID = ?"
+        " AND COALESCE(entity_attributes.valueFloat, entity_attributes.valueInt) <= ?"
+        " AND character_.online = 0"
+        " LIMIT ?",
+        DBParams().Add( (uint32)flagSkillInTraining ).Add( (uint32)AttrExpiryTime ).Add( now ).Add( limit ) ) )
+    {
+        _log(DATABASE__ERROR, "Failed to query characters with due skills: %s.", res.error.c_str());
+        return false;
+    }
+
+    DBResultRow row;
+    while( res.GetRow( row ) )
+        into.push_back( row.GetUInt( 0 ) );
+
+    return true;
+}
 bool InventoryDB::GetTypeID(uint32 itemID, uint32 &typeID)
 {
     DBQueryResult res;
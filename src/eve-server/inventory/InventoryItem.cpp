@@ -27,7 +27,10 @@
 
 #include "Client.h"
 #include "EntityList.h"
+#include "chat/NameIndex.h"
+#include "config/OwnerDirectory.h"
 #include "character/Skill.h"
+#include "inventory/InventoryBatch.h"
 #include "inventory/Owner.h"
 #include "manufacturing/Blueprint.h"
 #include "ship/Ship.h"
@@ -112,6 +115,8 @@ ItemData::ItemData(
 /*
  * InventoryItem
  */
+MemoryTag InventoryItem::sMemoryTag( "items" );
+
 InventoryItem::InventoryItem(
     ItemFactory &_factory,
     uint32 _itemID,
@@ -133,7 +138,8 @@ InventoryItem::InventoryItem(
   m_singleton(_data.singleton),
   m_quantity(_data.quantity),
   m_position(_data.position),
-  m_customInfo(_data.customInfo)
+  m_customInfo(_data.customInfo),
+  m_transient(false)
 
 {
     // assert for data consistency
@@ -564,6 +570,67 @@ uint32 InventoryItem::_Spawn(ItemFactory &factory,
     return factory.db().NewItem(data);
 }
 
+void InventoryItem::_TransientLoaded()
+{
+    Inventory *inventory = Inventory::Cast( InventoryItemRef( this ) );
+    if( inventory != NULL )
+        inventory->mContentsLoaded = true;
+}
+
+void InventoryItem::Persist()
+{
+    if( !IsTransient() )
+        return;
+
+    if( !m_factory.db().NewItem( itemID(),
+            ItemData(
+                itemName().c_str(),
+                typeID(),
+                ownerID(),
+                locationID(),
+                flag(),
+                contraband(),
+                singleton(),
+                quantity(),
+                position(),
+                customInfo().c_str()
+            ) ) )
+    {
+        codelog( ITEM__ERROR, "Failed to persist transient item %u.", itemID() );
+        return;
+    }
+    m_transient = false;
+
+    // nothing of ours has been written yet
+    mAttributeMap.MarkAllDirty();
+    SaveAttributes();
+
+    // a persisted item must not point to a location which is not
+    if( m_factory.IsTransient( locationID() ) )
+        m_factory.GetItem( locationID() )->Persist();
+
+    // and its contents go along
+    Inventory *inventory = Inventory::Cast( InventoryItemRef( this ) );
+    if( inventory != NULL )
+    {
+        std::vector<InventoryItemRef> contents;
+
+        Inventory::ItemMap::const_iterator cur, end;
+        cur = inventory->mContents.begin();
+        end = inventory->mContents.end();
+        for(; cur != end; cur++)
+            contents.push_back( cur->second );
+
+        std::vector<InventoryItemRef>::const_iterator curc, endc;
+        curc = contents.begin();
+        endc = contents.end();
+        for(; curc != endc; curc++)
+            (*curc)->Persist();
+    }
+
+    _log( ITEM__TRACE, "Persisted transient item %u (%s).", itemID(), itemName().c_str() );
+}
+
 void InventoryItem::Delete() {
     //first, get out of client's sight.
     //this also removes us from our inventory.
@@ -572,10 +639,12 @@ void InventoryItem::Delete() {
 
     //take ourself out of the DB
     //attributes.Delete();
-    m_factory.db().DeleteItem( itemID() );
+    if( !IsTransient() ) {
+        m_factory.db().DeleteItem( itemID() );
 
-    mAttributeMap.Delete();
-    mDefaultAttributeMap.Delete();
+        mAttributeMap.Delete();
+        mDefaultAttributeMap.Delete();
+    }
 
     //delete ourselves from factory cache
     m_factory._DeleteItem( itemID() );
@@ -687,11 +756,7 @@ bool InventoryItem::Populate( Rsp_CommonGetInfo_Entry& result )
     //result..activeEffects[id] = List[11];
 
     //attributes:
-    AttributeMap::AttrMapItr itr = mAttributeMap.begin();
-    AttributeMap::AttrMapItr itr_end = mAttributeMap.end();
-    for (; itr != itr_end; itr++) {
-        result.attributes[(*itr).first] = (*itr).second.GetPyObject();
-    }
+    mAttributeMap.EncodeAttributes( result.attributes );
 
     //no idea what time this is supposed to be
     result.time = Win32TimeNow();
@@ -713,6 +778,9 @@ void InventoryItem::Rename(const char *to) {
 
     m_itemName = to;
     SaveItem();
+
+    sNameIndex.Rename(itemID(), m_itemName);
+    sOwnerDirectory.Invalidate(itemID());
 }
 
 void InventoryItem::MoveInto(Inventory &new_home, EVEItemFlags _flag, bool notify) {
@@ -739,6 +807,15 @@ void InventoryItem::Move(uint32 new_location, EVEItemFlags new_flag, bool notify
     if( new_inventory != NULL )
         new_inventory->AddItem( InventoryItemRef( this ) ); //makes a new ref
 
+    //transient items are persisted once taken out of space, into a persisted
+    //inventory; and anything put into a transient one persists that.
+    if( m_factory.IsTransient( new_location ) ) {
+        if( !IsTransient() )
+            m_factory.GetItem( new_location )->Persist();
+    } else if( IsTransient() && !IsSolarSystem( new_location ) ) {
+        Persist();
+    }
+
     SaveItem();
 
     //notify about the changes.
@@ -782,6 +859,11 @@ bool InventoryItem::SetQuantity(uint32 qty_new, bool notify) {
 
     m_quantity = qty_new;
 
+    //keep our inventory's stored volume up to date, if its loaded.
+    Inventory *inventory = m_factory.GetInventory( m_locationID, false );
+    if( inventory != NULL )
+        inventory->_UpdateVolume( InventoryItemRef( this ) );
+
     SaveItem();
 
     //notify about the changes.
@@ -798,6 +880,11 @@ bool InventoryItem::SetQuantity(uint32 qty_new, bool notify) {
 bool InventoryItem::SetFlag(EVEItemFlags new_flag, bool notify) {
     EVEItemFlags old_flag = m_flag;
     m_flag = new_flag;
+
+    //keep our inventory's flag indexes up to date, if its loaded.
+    Inventory *inventory = m_factory.GetInventory( m_locationID, false );
+    if( inventory != NULL )
+        inventory->_UpdateIndexes( InventoryItemRef( this ), old_flag, m_ownerID );
     
     SaveItem();
     
@@ -894,6 +981,15 @@ void InventoryItem::ChangeOwner(uint32 new_owner, bool notify) {
 
     m_ownerID = new_owner;
 
+    //keep our inventory's owner indexes up to date, if its loaded.
+    Inventory *inventory = m_factory.GetInventory( m_locationID, false );
+    if( inventory != NULL )
+        inventory->_UpdateIndexes( InventoryItemRef( this ), m_flag, old_owner );
+
+    //players (and their corporations) own persisted items only.
+    if( IsTransient() && IsNonStaticItem( new_owner ) )
+        Persist();
+
     SaveItem();
 
     //notify about the changes.
@@ -917,6 +1013,10 @@ void InventoryItem::SaveItem()
     //mAttributeMap.Save();
     SaveAttributes();
 
+    //transient items live in memory only.
+    if( IsTransient() )
+        return;
+
     m_factory.db().SaveItem(
         itemID(),
         ItemData(
@@ -941,6 +1041,12 @@ void InventoryItem::SendItemChange(uint32 toID, std::map<int32, PyRep *> &change
     if(c == NULL)
         return; //not found or not online...
 
+    if(sInventoryBatch.IsOpen()) {
+        //coalesced and sent when the batch ends.
+        sInventoryBatch.QueueItemChange(toID, InventoryItemRef(const_cast<InventoryItem *>(this)), changes);
+        return;
+    }
+
     NotifyOnItemChange change;
     change.itemRow = GetItemRow();
 
@@ -1021,36 +1127,47 @@ void InventoryItem::Relocate(const GPoint &pos) {
 bool InventoryItem::SetAttribute( uint32 attributeID, int64 num, bool notify /* true */ )
 {
     EvilNumber devil_number(num);
-    return mAttributeMap.SetAttribute(attributeID, devil_number, notify);
+    return SetAttribute(attributeID, devil_number, notify);
 }
 
 bool InventoryItem::SetAttribute( uint32 attributeID, double num, bool notify /* true */ )
 {
     EvilNumber devil_number(num);
-    return mAttributeMap.SetAttribute(attributeID, devil_number, notify);
+    return SetAttribute(attributeID, devil_number, notify);
 }
 
 bool InventoryItem::SetAttribute( uint32 attributeID, EvilNumber num, bool notify /* true */ )
 {
-    return mAttributeMap.SetAttribute(attributeID, num, notify);
+    if( !mAttributeMap.SetAttribute(attributeID, num, notify) )
+        return false;
+
+    //the stored volume of our inventory depends on these
+    if( attributeID == AttrQuantity || attributeID == AttrVolume )
+    {
+        Inventory *inventory = m_factory.GetInventory( m_locationID, false );
+        if( inventory != NULL )
+            inventory->_UpdateVolume( InventoryItemRef( this ) );
+    }
+
+    return true;
 }
 
 bool InventoryItem::SetAttribute( uint32 attributeID, int num, bool notify /* true */ )
 {
     EvilNumber devil_number(num);
-    return mAttributeMap.SetAttribute(attributeID, devil_number, notify);
+    return SetAttribute(attributeID, devil_number, notify);
 }
 
 bool InventoryItem::SetAttribute( uint32 attributeID, uint64 num, bool notify /* true */ )
 {
     EvilNumber devil_number(*((int64*)&num));
-    return mAttributeMap.SetAttribute(attributeID, devil_number, notify);
+    return SetAttribute(attributeID, devil_number, notify);
 }
 
 bool InventoryItem::SetAttribute( uint32 attributeID, uint32 num, bool notify /* true */ )
 {
     EvilNumber devil_number((int64)num);
-    return mAttributeMap.SetAttribute(attributeID, devil_number, notify);
+    return SetAttribute(attributeID, devil_number, notify);
 }
 
 EvilNumber InventoryItem::GetAttribute( uint32 attributeID )
@@ -1063,6 +1180,11 @@ EvilNumber InventoryItem::GetAttribute( const uint32 attributeID ) const
      return mAttributeMap.GetAttribute(attributeID);
 }
 
+double InventoryItem::GetAttributeValue( uint32 attributeID ) const
+{
+    return mAttributeMap.GetAttributeValue(attributeID);
+}
+
 EvilNumber InventoryItem::GetDefaultAttribute( uint32 attributeID )
 {
     return mDefaultAttributeMap.GetAttribute(attributeID);
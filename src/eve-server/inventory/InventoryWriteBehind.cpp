@@ -0,0 +1,368 @@
+/*
+    ------------------------------------------------------------------------------------
+    LICENSE:
+    ------------------------------------------------------------------------------------
+    This file is part of EVEmu: EVE Online Server Emulator
+    Copyright 2006 - 2011 The EVEmu Team
+    For the latest information visit http://evemu.org
+    ------------------------------------------------------------------------------------
+    This program is free software; you can redistribute it and/or modify it under
+    the terms of the GNU Lesser General Public License as published by the Free Software
+    Foundation; either version 2 of the License, or (at your option) any later
+    version.
+
+    This program is distributed in the hope that it will be useful, but WITHOUT
+    ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+    FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public License along with
+    this program; if not, write to the Free Software Foundation, Inc., 59 Temple
+    Place - Suite 330, Boston, MA 02111-1307, USA, or go to
+    http://www.gnu.org/copyleft/lesser.txt.
+    ------------------------------------------------------------------------------------
+    Author:     EVEmu Team
+*/
+
+#include "eve-server.h"
+
+#include "inventory/InventoryWriteBehind.h"
+
+/// Maximal number of rows written by a single statement.
+static const size_t INVENTORY_WRITE_BATCH_ROWS = 256;
+
+InventoryWriteBehind::InventoryWriteBehind()
+: mFlushInterval( 0 ),
+  mFirstQueued( 0 ),
+  mBatchDepth( 0 )
+{
+}
+
+void InventoryWriteBehind::SetFlushInterval( uint32 interval )
+{
+    mFlushInterval = interval;
+
+    // nothing may stay queued once disabled
+    if( !IsEnabled() )
+        Flush();
+}
+
+void InventoryWriteBehind::EndBatch()
+{
+    assert( 0 < mBatchDepth );
+
+    // without queueing, a batch is written as soon as it ends
+    if( 0 == --mBatchDepth && 0 == mFlushInterval )
+        Flush();
+}
+
+void InventoryWriteBehind::SaveItem( uint32 itemID, const ItemData& data )
+{
+    std::map<uint32, ItemData>::iterator res = mItems.find( itemID );
+    if( res != mItems.end() )
+    {
+        res->second = data;
+        _Queued( true );
+        return;
+    }
+
+    mItems.insert( std::make_pair( itemID, data ) );
+    _Queued( false );
+}
+
+void InventoryWriteBehind::SaveAttribute( uint32 itemID, uint32 attributeID, int64 value )
+{
+    AttributeWrite write;
+    write.kind = AttributeWrite::Int;
+    write.i = value;
+    write.d = 0.0;
+
+    _QueueAttribute( itemID, attributeID, write );
+}
+
+void InventoryWriteBehind::SaveAttribute( uint32 itemID, uint32 attributeID, double value )
+{
+    AttributeWrite write;
+    write.kind = AttributeWrite::Real;
+    write.i = 0;
+    write.d = value;
+
+    _QueueAttribute( itemID, attributeID, write );
+}
+
+void InventoryWriteBehind::EraseAttribute( uint32 itemID, uint32 attributeID )
+{
+    AttributeWrite write;
+    write.kind = AttributeWrite::Erase;
+    write.i = 0;
+    write.d = 0.0;
+
+    _QueueAttribute( itemID, attributeID, write );
+}
+
+void InventoryWriteBehind::Forget( uint32 itemID, bool attributesOnly )
+{
+    if( !attributesOnly )
+        mItems.erase( itemID );
+
+    // the attributes of the item are next to each other
+    mAttributes.erase( mAttributes.lower_bound( AttributeKey( itemID, 0 ) ),
+                       mAttributes.upper_bound( AttributeKey( itemID, 0xFFFFFFFF ) ) );
+}
+
+void InventoryWriteBehind::SaveMarketOrder( const MarketOrder& order )
+{
+    MarketOrderWrite write;
+    write.erase = false;
+    write.order = order;
+
+    _QueueMarketOrder( order.orderID, write );
+}
+
+void InventoryWriteBehind::EraseMarketOrder( uint32 orderID )
+{
+    MarketOrderWrite write;
+    write.erase = true;
+    write.order.orderID = orderID;
+
+    _QueueMarketOrder( orderID, write );
+}
+
+void InventoryWriteBehind::Process( uint32 now )
+{
+    if( IsPending() && mFlushInterval <= now - mFirstQueued )
+        Flush();
+}
+
+bool InventoryWriteBehind::Flush()
+{
+    if( !IsPending() )
+        return true;
+
+    std::vector<std::string> queries;
+    size_t rows = 0;
+    char buf[ 512 ];
+
+    // entity rows
+    {
+        std::string query;
+        size_t count = 0;
+
+        std::map<uint32, ItemData>::const_iterator cur, end;
+        cur = mItems.begin();
+        end = mItems.end();
+        for(; cur != end; ++cur )
+        {
+            const ItemData& data = cur->second;
+
+            std::string nameEsc, customInfoEsc;
+            sDatabase.DoEscapeString( nameEsc, data.name );
+            sDatabase.DoEscapeString( customInfoEsc, data.customInfo );
+
+            if( 0 == count )
+                query = "INSERT INTO entity"
+                        " (itemID, itemName, typeID, ownerID, locationID, flag, contraband, singleton, quantity, x, y, z, customInfo)"
+                        " VALUES ";
+            else
+                query += ',';
+
+            query += "(";
+            snprintf( buf, sizeof( buf ), "%u, '", cur->first );
+            query += buf;
+            query += nameEsc;
+            snprintf( buf, sizeof( buf ), "', %u, %u, %u, %u, %u, %u, %u, %f, %f, %f, '",
+                      data.typeID, data.ownerID, data.locationID, uint32( data.flag ),
+                      uint32( data.contraband ), uint32( data.singleton ), data.quantity,
+                      data.position.x, data.position.y, data.position.z );
+            query += buf;
+            query += customInfoEsc;
+            query += "')";
+
+            ++rows;
+            if( INVENTORY_WRITE_BATCH_ROWS == ++count )
+            {
+                count = 0;
+                queries.push_back( query );
+            }
+        }
+
+        if( 0 < count )
+            queries.push_back( query );
+    }
+
+    // every entity statement updates the existing rows
+    for( size_t i = 0; i < queries.size(); ++i )
+        queries[ i ] += " ON DUPLICATE KEY UPDATE"
+                        " itemName = VALUES(itemName), typeID = VALUES(typeID), ownerID = VALUES(ownerID),"
+                        " locationID = VALUES(locationID), flag = VALUES(flag), contraband = VALUES(contraband),"
+                        " singleton = VALUES(singleton), quantity = VALUES(quantity),"
+                        " x = VALUES(x), y = VALUES(y), z = VALUES(z), customInfo = VALUES(customInfo)";
+
+    // attribute rows
+    {
+        std::string save, erase;
+        size_t saveCount = 0, eraseCount = 0;
+
+        std::map<AttributeKey, AttributeWrite>::const_iterator cur, end;
+        cur = mAttributes.begin();
+        end = mAttributes.end();
+        for(; cur != end; ++cur )
+        {
+            const AttributeWrite& write = cur->second;
+
+            if( AttributeWrite::Erase == write.kind )
+            {
+                snprintf( buf, sizeof( buf ), "%s(itemID = %u AND attributeID = %u)",
+                          ( 0 == eraseCount ? "DELETE FROM entity_attributes WHERE " : " OR " ),
+                          cur->first.first, cur->first.second );
+                erase += buf;
+
+                if( INVENTORY_WRITE_BATCH_ROWS == ++eraseCount )
+                {
+                    eraseCount = 0;
+                    queries.push_back( erase );
+                    erase.clear();
+                }
+            }
+            else
+            {
+                if( 0 == saveCount )
+                    save = "INSERT INTO entity_attributes (itemID, attributeID, valueInt, valueFloat) VALUES ";
+                else
+                    save += ',';
+
+                if( AttributeWrite::Int == write.kind )
+                    snprintf( buf, sizeof( buf ), "(%u, %u, %" PRId64 ", NULL)", cur->first.first, cur->first.second, write.i );
+                else
+                    snprintf( buf, sizeof( buf ), "(%u, %u, NULL, %.17g)", cur->first.first, cur->first.second, write.d );
+                save += buf;
+
+                if( INVENTORY_WRITE_BATCH_ROWS == ++saveCount )
+                {
+                    saveCount = 0;
+                    queries.push_back( save + " ON DUPLICATE KEY UPDATE valueInt = VALUES(valueInt), valueFloat = VALUES(valueFloat)" );
+                }
+            }
+
+            ++rows;
+        }
+
+        if( 0 < eraseCount )
+            queries.push_back( erase );
+        if( 0 < saveCount )
+            queries.push_back( save + " ON DUPLICATE KEY UPDATE valueInt = VALUES(valueInt), valueFloat = VALUES(valueFloat)" );
+    }
+
+    // market order rows
+    {
+        std::string save, erase;
+        size_t saveCount = 0, eraseCount = 0;
+
+        std::map<uint32, MarketOrderWrite>::const_iterator cur, end;
+        cur = mMarketOrders.begin();
+        end = mMarketOrders.end();
+        for(; cur != end; ++cur )
+        {
+            const MarketOrderWrite& write = cur->second;
+
+            if( write.erase )
+            {
+                snprintf( buf, sizeof( buf ), "%s%u",
+                          ( 0 == eraseCount ? "DELETE FROM market_orders WHERE orderID IN (" : ", " ),
+                          cur->first );
+                erase += buf;
+
+                if( INVENTORY_WRITE_BATCH_ROWS == ++eraseCount )
+                {
+                    eraseCount = 0;
+                    queries.push_back( erase + ")" );
+                    erase.clear();
+                }
+            }
+            else
+            {
+                const MarketOrder& order = write.order;
+
+                if( 0 == saveCount )
+                    save = "INSERT INTO market_orders"
+                           " (orderID, typeID, charID, regionID, stationID, solarSystemID, `range`, bid, price,"
+                           " volEntered, volRemaining, issued, orderState, minVolume, contraband, accountID,"
+                           " duration, isCorp, escrow, jumps)"
+                           " VALUES ";
+                else
+                    save += ',';
+
+                snprintf( buf, sizeof( buf ),
+                          "(%u, %u, %u, %u, %u, %u, %u, %u, %.17g, %u, %u, %" PRIu64 ", %u, %u, %u, %u, %u, %u, %u, %d)",
+                          cur->first, order.typeID, order.charID, order.regionID, order.stationID,
+                          order.solarSystemID, order.range, uint32( order.bid ), order.price,
+                          order.volEntered, order.volRemaining, order.issued, order.orderState,
+                          order.minVolume, uint32( order.contraband ), order.accountID, order.duration,
+                          uint32( order.isCorp ), uint32( order.escrow ), order.jumps );
+                save += buf;
+
+                if( INVENTORY_WRITE_BATCH_ROWS == ++saveCount )
+                {
+                    saveCount = 0;
+                    queries.push_back( save + " ON DUPLICATE KEY UPDATE price = VALUES(price), volRemaining = VALUES(volRemaining), orderState = VALUES(orderState)" );
+                }
+            }
+
+            ++rows;
+        }
+
+        if( 0 < eraseCount )
+            queries.push_back( erase + ")" );
+        if( 0 < saveCount )
+            queries.push_back( save + " ON DUPLICATE KEY UPDATE price = VALUES(price), volRemaining = VALUES(volRemaining), orderState = VALUES(orderState)" );
+    }
+
+    // the queue is empty no matter the outcome; a failed write is not retried, same as before
+    mItems.clear();
+    mAttributes.clear();
+    mMarketOrders.clear();
+
+    DBerror err;
+    if( !sDatabase.RunTransaction( err, queries ) )
+    {
+        sLog.Error( "InventoryWriteBehind", "Failed to write %lu rows: %s", (unsigned long)rows, err.c_str() );
+
+        ++mStats.failures;
+        return false;
+    }
+
+    ++mStats.flushes;
+    mStats.rows += rows;
+    return true;
+}
+
+void InventoryWriteBehind::_QueueAttribute( uint32 itemID, uint32 attributeID, const AttributeWrite& write )
+{
+    std::pair<std::map<AttributeKey, AttributeWrite>::iterator, bool> res =
+        mAttributes.insert( std::make_pair( AttributeKey( itemID, attributeID ), write ) );
+
+    if( !res.second )
+        res.first->second = write;
+
+    _Queued( !res.second );
+}
+
+void InventoryWriteBehind::_QueueMarketOrder( uint32 orderID, const MarketOrderWrite& write )
+{
+    std::pair<std::map<uint32, MarketOrderWrite>::iterator, bool> res =
+        mMarketOrders.insert( std::make_pair( orderID, write ) );
+
+    if( !res.second )
+        res.first->second = write;
+
+    _Queued( !res.second );
+}
+
+void InventoryWriteBehind::_Queued( bool coalesced )
+{
+    ++mStats.queued;
+    if( coalesced )
+        ++mStats.coalesced;
+    else if( 1 == mItems.size() + mAttributes.size() + mMarketOrders.size() )
+        // the first pending write
+        mFirstQueued = Timer::GetCurrentTime();
+}
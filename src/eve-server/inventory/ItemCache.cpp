@@ -0,0 +1,135 @@
+/*
+    ------------------------------------------------------------------------------------
+    LICENSE:
+    ------------------------------------------------------------------------------------
+    This file is part of EVEmu: EVE Online Server Emulator
+    Copyright 2006 - 2011 The EVEmu Team
+    For the latest information visit http://evemu.org
+    ------------------------------------------------------------------------------------
+    This program is free software; you can redistribute it and/or modify it under
+    the terms of the GNU Lesser General Public License as published by the Free Software
+    Foundation; either version 2 of the License, or (at your option) any later
+    version.
+
+    This program is distributed in the hope that it will be useful, but WITHOUT
+    ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+    FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public License along with
+    this program; if not, write to the Free Software Foundation, Inc., 59 Temple
+    Place - Suite 330, Boston, MA 02111-1307, USA, or go to
+    http://www.gnu.org/copyleft/lesser.txt.
+    ------------------------------------------------------------------------------------
+    Author:     EVEmu Team
+*/
+
+#include "eve-server.h"
+
+#include "inventory/InventoryItem.h"
+#include "inventory/ItemCache.h"
+
+const size_t ItemCache::TRIM_SCAN_LIMIT = 1024;
+
+/// Rough memory taken by an attribute held in a std::map.
+static const size_t ITEM_ATTRIBUTE_SIZE = sizeof( uint32 ) + sizeof( EvilNumber ) + 4 * sizeof( void* );
+
+ItemCache::ItemCache()
+: mCapacity( 0 ),
+  mBytes( 0 )
+{
+}
+
+InventoryItemRef ItemCache::Find( uint32 itemID )
+{
+    ItemMap::iterator res = mItems.find( itemID );
+    if( res == mItems.end() )
+    {
+        ++mStats.misses;
+        return InventoryItemRef();
+    }
+
+    // move it to the recent end
+    mLRU.splice( mLRU.begin(), mLRU, res->second.lru );
+
+    ++mStats.hits;
+    return res->second.item;
+}
+
+InventoryItemRef ItemCache::Insert( const InventoryItemRef& item )
+{
+    std::pair<ItemMap::iterator, bool> res = mItems.insert( std::make_pair( item->itemID(), Entry() ) );
+    Entry& entry = res.first->second;
+
+    if( res.second )
+    {
+        entry.item = item;
+        entry.size = _EstimateSize( *item );
+        entry.lru = mLRU.insert( mLRU.begin(), item->itemID() );
+
+        mBytes += entry.size;
+    }
+
+    return entry.item;
+}
+
+bool ItemCache::Erase( uint32 itemID )
+{
+    ItemMap::iterator res = mItems.find( itemID );
+    if( res == mItems.end() )
+        return false;
+
+    mBytes -= res->second.size;
+    mLRU.erase( res->second.lru );
+    mItems.erase( res );
+
+    return true;
+}
+
+void ItemCache::Clear()
+{
+    mItems.clear();
+    mLRU.clear();
+    mBytes = 0;
+}
+
+size_t ItemCache::Trim()
+{
+    if( 0 == mCapacity )
+        return 0;
+
+    size_t dropped = 0;
+    for( size_t scanned = 0; mCapacity < mItems.size() && scanned < TRIM_SCAN_LIMIT; ++scanned )
+    {
+        const uint32 itemID = mLRU.back();
+        ItemMap::iterator res = mItems.find( itemID );
+        assert( res != mItems.end() );
+
+        InventoryItemRef& item = res->second.item;
+        if( 1 < item->GetRefCount() )
+        {
+            // referenced; give it another round
+            mLRU.splice( mLRU.begin(), mLRU, res->second.lru );
+            ++mStats.pinned;
+            continue;
+        }
+
+        // the item is going to be loaded again, so keep what has changed
+        item->SaveAttributes();
+
+        mBytes -= res->second.size;
+        mLRU.pop_back();
+        mItems.erase( res );
+
+        ++mStats.evictions;
+        ++dropped;
+    }
+
+    return dropped;
+}
+
+size_t ItemCache::_EstimateSize( const InventoryItem& item )
+{
+    return sizeof( Entry ) + sizeof( uint32 ) + 4 * sizeof( void* )
+         + sizeof( InventoryItem ) + item.itemName().size()
+         + item.GetAttributeCount() * ITEM_ATTRIBUTE_SIZE;
+}
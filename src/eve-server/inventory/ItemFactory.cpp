@@ -25,7 +25,12 @@
 
 #include "eve-server.h"
 
+#include "chat/NameIndex.h"
+#include "config/OwnerDirectory.h"
+#include "database/DBSnapshot.h"
+#include "database/StaticDataSnapshot.h"
 #include "character/Character.h"
+#include "inventory/InventoryWriteBehind.h"
 #include "manufacturing/Blueprint.h"
 #include "pos/Structure.h"
 #include "ship/Ship.h"
@@ -33,19 +38,13 @@
 #include "system/Container.h"
 #include "system/SolarSystem.h"
 
-ItemFactory::ItemFactory(EntityList& el) : entity_list(el) {}
+ItemFactory::ItemFactory(EntityList& el)
+: entity_list(el),
+  m_nextTransientID(0)
+{
+}
 
 ItemFactory::~ItemFactory() {
-    // items
-    {
-        std::map<uint32, InventoryItemRef>::const_iterator cur, end;
-        cur = m_items.begin();
-        end = m_items.end();
-        for(; cur != end; cur++) {
-            // save attributes of item (because of rechargable attributes)
-            //cur->second->attributes.Save();
-        }
-    }
     // types
     {
         std::map<uint32, ItemType *>::const_iterator cur, end;
@@ -73,6 +72,9 @@ ItemFactory::~ItemFactory() {
 
     // Set Client pointer to NULL
     m_pClient = NULL;
+
+    // write whatever the items saved on their way out
+    sInventoryWriteBehind.Flush();
 }
 
 const ItemCategory *ItemFactory::GetCategory(EVEItemCategories category) {
@@ -149,11 +151,98 @@ const StationType *ItemFactory::GetStationType(uint32 stationTypeID) {
     return _GetType<StationType>(stationTypeID);
 }
 
+template<class _Data>
+const _Data *ItemFactory::StaticData<_Data>::Find(uint32 id) const {
+    if(id >= index.size() || 0 == index[id])
+        return NULL;
+    return &rows[index[id] - 1];
+}
+
+template<class _Data>
+bool ItemFactory::_LoadStaticData(const DBSnapshot &snapshot, const char *table,
+    bool (*decode)(const DBSnapshotRow &, _Data &), StaticData<_Data> &into)
+{
+    const DBSnapshot::Table *t = snapshot.GetTable(table);
+    if(t == NULL) {
+        sLog.Error("ItemFactory", "Static data snapshot has no table %s.", table);
+        return false;
+    }
+
+    StaticData<_Data> data;
+    data.rows.resize(t->RowCount());
+
+    DBSnapshotRow row;
+    for(uint32 i = 0; i < t->RowCount(); i++) {
+        if(!t->GetRow(i, row) || !decode(row, data.rows[i])) {
+            sLog.Error("ItemFactory", "Row %u of static data table %s has wrong columns.", i, table);
+            return false;
+        }
+
+        // the IDs are dense enough to index them directly
+        const uint32 id = row.GetUInt(0);
+        if(id >= data.index.size())
+            data.index.resize(id + 1, 0);
+        data.index[id] = i + 1;
+    }
+
+    std::swap(into.rows, data.rows);
+    std::swap(into.index, data.index);
+    return true;
+}
+
+bool ItemFactory::LoadStaticData(const DBSnapshot &snapshot) {
+    StaticData<CategoryData> categories;
+    StaticData<GroupData> groups;
+    StaticData<TypeData> types;
+    if(!_LoadStaticData(snapshot, STATIC_SNAPSHOT_CATEGORIES, &InventoryDB::DecodeCategory, categories)
+        || !_LoadStaticData(snapshot, STATIC_SNAPSHOT_GROUPS, &InventoryDB::DecodeGroup, groups)
+        || !_LoadStaticData(snapshot, STATIC_SNAPSHOT_TYPES, &InventoryDB::DecodeType, types))
+        return false;
+
+    std::swap(m_staticCategories.rows, categories.rows);
+    std::swap(m_staticCategories.index, categories.index);
+    std::swap(m_staticGroups.rows, groups.rows);
+    std::swap(m_staticGroups.index, groups.index);
+    std::swap(m_staticTypes.rows, types.rows);
+    std::swap(m_staticTypes.index, types.index);
+
+    sLog.Success("ItemFactory", "Loaded static data of %lu categories, %lu groups and %lu types.",
+        (unsigned long)m_staticCategories.rows.size(), (unsigned long)m_staticGroups.rows.size(), (unsigned long)m_staticTypes.rows.size());
+    return true;
+}
+
+bool ItemFactory::GetStaticCategory(EVEItemCategories category, CategoryData &into) const {
+    const CategoryData *data = m_staticCategories.Find(uint32(category));
+    if(data == NULL)
+        return false;
+
+    into = *data;
+    return true;
+}
+
+bool ItemFactory::GetStaticGroup(uint32 groupID, GroupData &into) const {
+    const GroupData *data = m_staticGroups.Find(groupID);
+    if(data == NULL)
+        return false;
+
+    into = *data;
+    return true;
+}
+
+bool ItemFactory::GetStaticType(uint32 typeID, TypeData &into) const {
+    const TypeData *data = m_staticTypes.Find(typeID);
+    if(data == NULL)
+        return false;
+
+    into = *data;
+    return true;
+}
+
 template<class _Ty>
 RefPtr<_Ty> ItemFactory::_GetItem(uint32 itemID)
 {
-    std::map<uint32, InventoryItemRef>::iterator res = m_items.find( itemID );
-    if( res == m_items.end() )
+    InventoryItemRef res = m_items.Find( itemID );
+    if( !res )
     {
         // load the item
         RefPtr<_Ty> item = _Ty::Load( *this, itemID );
@@ -161,10 +250,139 @@ RefPtr<_Ty> ItemFactory::_GetItem(uint32 itemID)
             return RefPtr<_Ty>();
 
         //we keep the original ref.
-        res = m_items.insert( std::make_pair( itemID, item ) ).first;
+        res = m_items.Insert( item );
     }
     // return to the user.
-    return RefPtr<_Ty>::StaticCast( res->second );
+    return RefPtr<_Ty>::StaticCast( res );
+}
+
+bool ItemFactory::PreloadItems(const std::vector<uint32> &containerIDs, std::map<uint32, ItemData> &into)
+{
+    // contents fetched in advance need no queries
+    std::vector<uint32>::const_iterator curID, endID;
+    curID = containerIDs.begin();
+    endID = containerIDs.end();
+    for(; curID != endID; curID++)
+    {
+        if( m_prefetchedContents.find( *curID ) == m_prefetchedContents.end() )
+            break;
+    }
+
+    if( curID == endID && !containerIDs.empty() )
+    {
+        std::set<uint32> containers( containerIDs.begin(), containerIDs.end() );
+
+        std::map<uint32, ItemData>::iterator cur, end;
+        cur = m_preloadedItems.begin();
+        end = m_preloadedItems.end();
+        for(; cur != end; cur++)
+        {
+            if( containers.find( cur->second.locationID ) != containers.end() && !m_items.Contains( cur->first ) )
+                into.insert( *cur );
+        }
+
+        for(curID = containerIDs.begin(); curID != endID; curID++)
+            m_prefetchedContents.erase( *curID );
+
+        return true;
+    }
+
+    std::map<uint32, ItemData> items;
+    std::map<uint32, ItemAttributeList> attributes;
+    if( !m_db.GetItemContents( containerIDs, items )
+        || !m_db.GetItemContentsAttributes( containerIDs, attributes ) )
+        return false;
+
+    std::map<uint32, ItemData>::iterator cur, end;
+    cur = items.begin();
+    end = items.end();
+    for(; cur != end; cur++)
+    {
+        if( m_items.Contains( cur->first ) )
+            continue;
+
+        into.insert( *cur );
+        m_preloadedItems.insert( *cur );
+
+        // the item may have no saved attributes, which is worth knowing too
+        ItemAttributeList &attrs = m_preloadedAttributes[ cur->first ];
+        std::map<uint32, ItemAttributeList>::iterator res = attributes.find( cur->first );
+        if( res != attributes.end() )
+            attrs.swap( res->second );
+    }
+
+    return true;
+}
+
+void ItemFactory::AddPrefetched(const std::vector<uint32> &containerIDs, std::map<uint32, ItemData> &items,
+                                std::map<uint32, ItemAttributeList> &attributes, std::vector<uint32> &itemIDs)
+{
+    std::map<uint32, ItemData>::iterator cur, end;
+    cur = items.begin();
+    end = items.end();
+    for(; cur != end; cur++)
+    {
+        // what is loaded may be newer than what was fetched
+        if( m_items.Contains( cur->first ) )
+            continue;
+
+        m_preloadedItems[ cur->first ] = cur->second;
+
+        ItemAttributeList &attrs = m_preloadedAttributes[ cur->first ];
+        attrs.clear();
+        std::map<uint32, ItemAttributeList>::iterator res = attributes.find( cur->first );
+        if( res != attributes.end() )
+            attrs.swap( res->second );
+
+        itemIDs.push_back( cur->first );
+    }
+
+    items.clear();
+    attributes.clear();
+
+    m_prefetchedContents.insert( containerIDs.begin(), containerIDs.end() );
+}
+
+void ItemFactory::DiscardPrefetched(const std::vector<uint32> &containerIDs, const std::vector<uint32> &itemIDs)
+{
+    std::vector<uint32>::const_iterator cur, end;
+    cur = containerIDs.begin();
+    end = containerIDs.end();
+    for(; cur != end; cur++)
+        m_prefetchedContents.erase( *cur );
+
+    cur = itemIDs.begin();
+    end = itemIDs.end();
+    for(; cur != end; cur++)
+        DiscardPreloaded( *cur );
+}
+
+bool ItemFactory::TakePreloadedItem(uint32 itemID, ItemData &into)
+{
+    std::map<uint32, ItemData>::iterator res = m_preloadedItems.find( itemID );
+    if( res == m_preloadedItems.end() )
+        return false;
+
+    into = res->second;
+    m_preloadedItems.erase( res );
+    return true;
+}
+
+bool ItemFactory::TakePreloadedAttributes(uint32 itemID, ItemAttributeList &into)
+{
+    std::map<uint32, ItemAttributeList>::iterator res = m_preloadedAttributes.find( itemID );
+    if( res == m_preloadedAttributes.end() )
+        return false;
+
+    into.swap( res->second );
+    m_preloadedAttributes.erase( res );
+    return true;
+}
+
+void ItemFactory::DiscardPreloaded(uint32 itemID)
+{
+    m_preloadedItems.erase( itemID );
+    m_preloadedAttributes.erase( itemID );
 }
 
 InventoryItemRef ItemFactory::GetItem(uint32 itemID)
@@ -228,16 +446,124 @@ InventoryItemRef ItemFactory::SpawnItem(ItemData &data) {
         return InventoryItemRef();
 
     // spawn successful; store the ref
-    m_items.insert( std::make_pair( i->itemID(), i ) );
+    m_items.Insert( i );
     return i;
 }
 
+bool ItemFactory::SpawnItems(std::vector<ItemData> &data, std::vector<InventoryItemRef> &into)
+{
+    std::vector<ItemData>::iterator cur, end;
+    cur = data.begin();
+    end = data.end();
+    for(; cur != end; cur++)
+    {
+        const ItemType *t = GetType( cur->typeID );
+        if( t == NULL )
+            return false;
+
+        // only the categories InventoryItem::Spawn() creates as generic items
+        switch( t->categoryID() ) {
+            case EVEDB::invCategories::Material:
+            case EVEDB::invCategories::Accessories:
+            case EVEDB::invCategories::Charge:
+            case EVEDB::invCategories::Trading:
+            case EVEDB::invCategories::Commodity:
+            case EVEDB::invCategories::Implant:
+            case EVEDB::invCategories::Reaction:
+                break;
+            default:
+                _log( ITEM__ERROR, "Refusing to spawn items of type %u in bulk.", cur->typeID );
+                return false;
+        }
+
+        if( cur->name.empty() )
+            cur->name = t->name();
+    }
+
+    std::vector<uint32> itemIDs;
+    if( !m_db.NewItems( data, itemIDs ) )
+        return false;
+
+    // the new items have no attributes yet, so they load from what we have
+    std::map<uint32, ItemData> items;
+    std::map<uint32, ItemAttributeList> attributes;
+    for(size_t i = 0; i < itemIDs.size(); i++)
+        items[ itemIDs[i] ] = data[i];
+
+    std::vector<uint32> containerIDs, prefetchedIDs;
+    AddPrefetched( containerIDs, items, attributes, prefetchedIDs );
+
+    for(size_t i = 0; i < itemIDs.size(); i++)
+    {
+        InventoryItemRef item = GetItem( itemIDs[i] );
+        if( item )
+            into.push_back( item );
+        else
+            codelog( ITEM__ERROR, "Failed to load spawned item %u.", itemIDs[i] );
+    }
+
+    DiscardPrefetched( containerIDs, prefetchedIDs );
+    return into.size() == itemIDs.size();
+}
+
+template<class _Ty>
+RefPtr<_Ty> ItemFactory::_SpawnTransient(ItemData &data)
+{
+    // the IDs of the persisted transient items are taken for good
+    if( m_nextTransientID == 0 )
+    {
+        uint32 lastID;
+        if( !m_db.GetLastItemID( EVEMU_TRANSIENT_MINIMUM_ID, EVEMU_TRANSIENT_MAXIMUM_ID, lastID ) )
+            return RefPtr<_Ty>();
+
+        m_nextTransientID = ( lastID == 0 ? EVEMU_TRANSIENT_MINIMUM_ID : lastID + 1 );
+    }
+
+    if( !IsTransientItem( m_nextTransientID ) )
+    {
+        _log( ITEM__ERROR, "Out of transient item IDs, unable to spawn item of type %u.", data.typeID );
+        return RefPtr<_Ty>();
+    }
+
+    RefPtr<_Ty> i = InventoryItem::SpawnTransient<_Ty>( *this, m_nextTransientID, data );
+    if( !i )
+        return RefPtr<_Ty>();
+    ++m_nextTransientID;
+
+    m_items.Insert( i );
+    return i;
+}
+
+InventoryItemRef ItemFactory::SpawnTransientItem(ItemData &data)
+{
+    return _SpawnTransient<InventoryItem>( data );
+}
+
+CargoContainerRef ItemFactory::SpawnTransientCargoContainer(ItemData &data)
+{
+    return _SpawnTransient<CargoContainer>( data );
+}
+
+StructureRef ItemFactory::SpawnTransientStructure(ItemData &data)
+{
+    return _SpawnTransient<Structure>( data );
+}
+
+bool ItemFactory::IsTransient(uint32 itemID)
+{
+    if( !IsTransientItem( itemID ) )
+        return false;
+
+    InventoryItemRef i = m_items.Find( itemID );
+    return i && i->IsTransient();
+}
+
 BlueprintRef ItemFactory::SpawnBlueprint(ItemData &data, BlueprintData &bpData) {
     BlueprintRef bi = Blueprint::Spawn(*this, data, bpData);
     if( !bi )
         return BlueprintRef();
 
-    m_items.insert( std::make_pair( bi->itemID(), bi ) );
+    m_items.Insert( bi );
     return bi;
 }
 
@@ -246,7 +572,97 @@ CharacterRef ItemFactory::SpawnCharacter(ItemData &data, CharacterData &charData
     if( !c )
         return CharacterRef();
 
-    m_items.insert( std::make_pair( c->itemID(), c ) );
+    m_items.Insert( c );
+    return c;
+}
+
+CharacterRef ItemFactory::SpawnCharacterWithItems(ItemData &data, CharacterData &charData, CorpMemberInfo &corpData,
+                                                  ItemAttributeList &attributes, std::vector<ItemData> &items,
+                                                  std::vector<ItemAttributeList> &itemAttributes, size_t shipIndex,
+                                                  std::vector<InventoryItemRef> &into)
+{
+    // the same checks as the separate spawns do
+    if( GetCharacterType( data.typeID ) == NULL )
+        return CharacterRef();
+    if( !data.singleton || data.quantity != 1 ) {
+        _log( ITEM__ERROR, "Tried to create non-singleton character %s.", data.name.c_str() );
+        return CharacterRef();
+    }
+    if( items.size() <= shipIndex || GetShipType( items[ shipIndex ].typeID ) == NULL )
+        return CharacterRef();
+
+    std::vector<ItemData>::iterator cur, end;
+    cur = items.begin();
+    end = items.end();
+    for(; cur != end; cur++)
+    {
+        const ItemType *t = GetType( cur->typeID );
+        if( t == NULL )
+            return CharacterRef();
+
+        if( cur->name.empty() )
+            cur->name = t->name();
+    }
+
+    // what the separate spawns set once loaded goes in along with the rest
+    attributes.push_back( std::make_pair( (uint32)AttrIsOnline, EvilNumber( 1 ) ) );
+    for(size_t i = 0; i < items.size(); i++)
+    {
+        if( GetType( items[ i ].typeID )->categoryID() == EVEDB::invCategories::Skill )
+            itemAttributes[ i ].push_back( std::make_pair( (uint32)AttrIsOnline, EvilNumber( 1 ) ) );
+    }
+
+    uint32 characterID;
+    std::vector<uint32> itemIDs;
+    if( !m_db.NewCharacterWithItems( data, charData, corpData, attributes, items, itemAttributes, shipIndex, characterID, itemIDs ) )
+        return CharacterRef();
+
+    // all is known, so the loads query neither the items nor their attributes
+    std::map<uint32, ItemData> prefetched;
+    std::map<uint32, ItemAttributeList> prefetchedAttributes;
+    prefetched[ characterID ] = data;
+    prefetchedAttributes[ characterID ].swap( attributes );
+    for(size_t i = 0; i < itemIDs.size(); i++)
+    {
+        ItemData &item = items[ i ];
+        item.ownerID = characterID;
+        if( item.locationID == 0 )
+            item.locationID = characterID;
+
+        prefetched[ itemIDs[ i ] ] = item;
+        prefetchedAttributes[ itemIDs[ i ] ].swap( itemAttributes[ i ] );
+    }
+
+    // the character and the ship hold nothing but what has just been inserted
+    std::vector<uint32> containerIDs, prefetchedIDs;
+    containerIDs.push_back( characterID );
+    containerIDs.push_back( itemIDs[ shipIndex ] );
+    AddPrefetched( containerIDs, prefetched, prefetchedAttributes, prefetchedIDs );
+
+    CharacterRef c = GetCharacter( characterID );
+    if( c )
+    {
+        sNameIndex.Add( NameIndex::NAME_CHARACTER, characterID, data.name, data.typeID );
+        // the ID may have been asked for before it existed
+        sOwnerDirectory.Invalidate( characterID );
+
+        for(size_t i = 0; i < itemIDs.size(); i++)
+        {
+            InventoryItemRef item = GetItem( itemIDs[ i ] );
+            if( item )
+                into.push_back( item );
+            else
+                codelog( ITEM__ERROR, "Failed to load spawned item %u.", itemIDs[ i ] );
+        }
+
+        ShipRef ship = GetShip( itemIDs[ shipIndex ] );
+        if( ship )
+            ship->SetSpawnAttributes();
+    }
+    else
+        codelog( ITEM__ERROR, "Failed to load spawned character %u.", characterID );
+
+    DiscardPrefetched( containerIDs, prefetchedIDs );
     return c;
 }
 
@@ -255,7 +671,7 @@ ShipRef ItemFactory::SpawnShip(ItemData &data) {
     if( !s )
         return ShipRef();
 
-    m_items.insert( std::make_pair( s->itemID(), s ) );
+    m_items.Insert( s );
     return s;
 }
 
@@ -265,7 +681,7 @@ SkillRef ItemFactory::SpawnSkill(ItemData &data)
     if( !s )
         return SkillRef();
 
-    m_items.insert( std::make_pair( s->itemID(), s ) );
+    m_items.Insert( s );
     return s;
 }
 
@@ -275,7 +691,7 @@ OwnerRef ItemFactory::SpawnOwner(ItemData &data)
     if( !o )
         return OwnerRef();
 
-    m_items.insert( std::make_pair( o->itemID(), o ) );
+    m_items.Insert( o );
     return o;
 }
 
@@ -285,7 +701,7 @@ StructureRef ItemFactory::SpawnStructure(ItemData &data)
     if( !o )
         return StructureRef();
 
-    m_items.insert( std::make_pair( o->itemID(), o ) );
+    m_items.Insert( o );
     return o;
 }
 
@@ -295,7 +711,7 @@ CargoContainerRef ItemFactory::SpawnCargoContainer(ItemData &data)
     if( !o )
         return CargoContainerRef();
 
-    m_items.insert( std::make_pair( o->itemID(), o ) );
+    m_items.Insert( o );
     return o;
 }
 
@@ -307,9 +723,7 @@ Inventory *ItemFactory::GetInventory(uint32 inventoryID, bool load)
         item = GetItem( inventoryID );
     else
     {
-        std::map<uint32, InventoryItemRef>::iterator res = m_items.find( inventoryID );
-        if( res != m_items.end() )
-            item = res->second;
+        item = m_items.Find( inventoryID );
     }
 
     return Inventory::Cast( item );
@@ -317,15 +731,8 @@ Inventory *ItemFactory::GetInventory(uint32 inventoryID, bool load)
 
 void ItemFactory::_DeleteItem(uint32 itemID)
 {
-    std::map<uint32, InventoryItemRef>::iterator res = m_items.find( itemID );
-    if( res == m_items.end() )
-    {
+    if( !m_items.Erase( itemID ) )
         sLog.Error("Item Factory", "Item ID %u not found when requesting deletion!", itemID );
-    }
-    else
-    {
-        m_items.erase( res );
-    }
 }
 
 void ItemFactory::SetUsingClient(Client *pClient)
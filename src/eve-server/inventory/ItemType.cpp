@@ -73,7 +73,7 @@ ItemCategory *ItemCategory::_Load(ItemFactory &factory, EVEItemCategories catego
 ) {
     // pull data
     CategoryData data;
-    if(!factory.db().GetCategory(category, data))
+    if(!factory.GetStaticCategory(category, data) && !factory.db().GetCategory(category, data))
         return NULL;
 
     return(
@@ -159,7 +159,7 @@ ItemGroup *ItemGroup::_Load(ItemFactory &factory, uint32 groupID
 ) {
     // pull data
     GroupData data;
-    if(!factory.db().GetGroup(groupID, data))
+    if(!factory.GetStaticGroup(groupID, data) && !factory.db().GetGroup(groupID, data))
         return NULL;
 
     // retrieve category
@@ -27,70 +27,88 @@
 
 #include "mail/MailDB.h"
 
-PyRep* MailDB::GetMailStatus(int charId)
-{
-    DBQueryResult res;
-    if (!sDatabase.RunQuery(res, "SELECT messageID, statusMask, labelMask FROM mailMessage WHERE toCharacterIDs LIKE '%%%u%%'", charId))
-        return NULL;
-    return DBResultToCRowset(res);
-}
+// default label is 1 = Inbox
+static const uint32 MAIL_DEFAULT_LABEL = 1;
 
-PyRep* MailDB::GetNewMail(int charId)
+bool MailDB::GetMailbox(uint32 characterID, std::vector<MailHeader>& into) const
 {
     DBQueryResult res;
-    if (!sDatabase.RunQuery(res, "SELECT messageID, senderID, toCharacterIDs, toListID, toCorpOrAllianceID, title, sentDate FROM mailMessage WHERE toCharacterIDs LIKE '%%%u%%'", charId))
-        return NULL;
-    return DBResultToCRowset(res);
-}
+    if (!sDatabase.RunQuery(res,
+        "SELECT m.messageID, m.senderID, m.toCharacterIDs, m.toListID, m.toCorpOrAllianceID, m.title, m.sentDate, m.bodyID,"
+        " r.statusMask, r.labelMask, r.unread"
+        " FROM mailRecipient r"
+        " JOIN mailMessage m USING (messageID)"
+        " WHERE r.characterID = %u"
+        " ORDER BY m.messageID", characterID))
+    {
+        codelog(SERVICE__ERROR, "Failed to query mails of character %u: %s", characterID, res.error.c_str());
+        return false;
+    }
 
-int MailDB::SendMail(int sender, std::vector<int>& toCharacterIDs, int toListID, int toCorpOrAllianceID, std::string& title, std::string& body, int isReplyTo, int isForwardedFrom)
-{
-    // build a string with ',' seperated char ids
-    std::string toStr;
-    for (size_t i = 0; i < toCharacterIDs.size(); i++)
+    DBResultRow row;
+    while (res.GetRow(row))
     {
-        toStr += itoa(toCharacterIDs[i]);
-        // only add ',' when this isn't the last ID
-        if (i != (toCharacterIDs.size() - 1))
-            toStr += ",";
+        MailHeader header;
+        header.messageID = row.GetUInt(0);
+        header.senderID = row.GetUInt(1);
+        header.toCharacterIDs = row.IsNull(2) ? "" : row.GetText(2);
+        header.toListID = row.GetUInt(3);
+        header.toCorpOrAllianceID = row.GetUInt(4);
+        header.title = row.IsNull(5) ? "" : row.GetText(5);
+        header.sentDate = row.GetUInt64(6);
+        header.bodyID = row.GetUInt(7);
+        header.statusMask = row.GetUInt(8);
+        header.labelMask = row.GetUInt(9);
+        header.unread = row.GetBool(10);
+        into.push_back(header);
     }
 
-    // sanitize these ids
-    if (toListID == -1)
-        toListID = 0;
-    if (toCorpOrAllianceID == -1)
-        toCorpOrAllianceID = 0;
+    return true;
+}
 
-    // compress the body
-    Buffer bodyCompressed;
-    Buffer bodyInput(body.begin(), body.end());
-    DeflateData(bodyInput, bodyCompressed);
+uint32 MailDB::StoreBody(const std::string& compressed, bool& shared) const
+{
+    const uint32 hash = CRC32::Generate((const uint8*)compressed.data(), compressed.size());
 
-    // ugh - buffer doesn't give us the actual buffer.. what the?
-    std::string bodyCompressedStr(bodyCompressed.begin<char>(), bodyCompressed.end<char>());
+    // a hash match is only a candidate; the body itself must be equal
+    DBQueryResult res;
+    if (!sDatabase.RunQuery(res, "SELECT bodyID, body FROM mailBody WHERE hash = %u", hash))
+    {
+        codelog(SERVICE__ERROR, "Failed to query mail bodies: %s", res.error.c_str());
+        return 0;
+    }
+
+    DBResultRow row;
+    while (res.GetRow(row))
+    {
+        if (row.ColumnLength(1) == compressed.size()
+            && memcmp(row.GetText(1), compressed.data(), compressed.size()) == 0)
+        {
+            shared = true;
+            return row.GetUInt(0);
+        }
+    }
 
     // escape it to not break the query with special characters
     std::string bodyEscaped;
-    sDatabase.DoEscapeString(bodyEscaped, bodyCompressedStr);
-
-    // default label is 1 = Inbox
-    const int defaultLabel = 1;
+    sDatabase.DoEscapeString(bodyEscaped, compressed);
 
     DBerror err;
-    uint32 messageID;
-    bool status = sDatabase.RunQueryLID(err, messageID,
-        "INSERT INTO mailMessage (senderID, toCharacterIDs, toListID, toCorpOrAllianceID, title, body, sentDate, statusMask, labelMask, unread) "
-        " VALUES (%u, '%s', %d, %d, '%s', '%s', %" PRIu64 ", 0, %u, 1)", sender, toStr.c_str(), toListID, toCorpOrAllianceID, title.c_str(), bodyEscaped.c_str(), Win32TimeNow(), defaultLabel);
-
-    if (!status)
+    uint32 bodyID;
+    if (!sDatabase.RunQueryLID(err, bodyID, "INSERT INTO mailBody (hash, body) VALUES (%u, '%s')", hash, bodyEscaped.c_str()))
+    {
+        codelog(SERVICE__ERROR, "Failed to insert mail body: %s", err.c_str());
         return 0;
-    return messageID;
+    }
+
+    shared = false;
+    return bodyID;
 }
 
-PyString* MailDB::GetMailBody(int id) const
+PyString* MailDB::GetMailBody(uint32 bodyID) const
 {
     DBQueryResult res;
-    if (!sDatabase.RunQuery(res, "SELECT body FROM mailMessage WHERE messageID = %u", id))
+    if (!sDatabase.RunQuery(res, "SELECT body FROM mailBody WHERE bodyID = %u", bodyID))
         return NULL;
     if (res.GetRowCount() <= 0)
         return NULL;
@@ -102,10 +120,72 @@ PyString* MailDB::GetMailBody(int id) const
     return new PyString(row.GetText(0), row.ColumnLength(0));
 }
 
-void MailDB::SetMailUnread(int id, bool unread)
+bool MailDB::InsertMessage(MailHeader& header) const
+{
+    std::string toEscaped, titleEscaped;
+    sDatabase.DoEscapeString(toEscaped, header.toCharacterIDs);
+    sDatabase.DoEscapeString(titleEscaped, header.title);
+
+    DBerror err;
+    if (!sDatabase.RunQueryLID(err, header.messageID,
+        "INSERT INTO mailMessage (senderID, toCharacterIDs, toListID, toCorpOrAllianceID, title, bodyID, sentDate)"
+        " VALUES (%u, '%s', %u, %u, '%s', %u, %" PRIu64 ")",
+        header.senderID, toEscaped.c_str(), header.toListID, header.toCorpOrAllianceID, titleEscaped.c_str(), header.bodyID, header.sentDate))
+    {
+        codelog(SERVICE__ERROR, "Failed to insert mail: %s", err.c_str());
+        return false;
+    }
+
+    return true;
+}
+
+bool MailDB::InsertRecipients(uint32 messageID, const std::vector<uint32>& characterIDs) const
+{
+    if (characterIDs.empty())
+        return true;
+
+    std::string values;
+    char buf[64];
+    for (size_t i = 0; i < characterIDs.size(); i++)
+    {
+        snprintf(buf, sizeof(buf), "%s(%u, %u, 0, %u, 1)", (i == 0 ? "" : ","), messageID, characterIDs[i], MAIL_DEFAULT_LABEL);
+        values += buf;
+    }
+
+    DBerror err;
+    if (!sDatabase.RunQuery(err,
+        "INSERT IGNORE INTO mailRecipient (messageID, characterID, statusMask, labelMask, unread) VALUES %s", values.c_str()))
+    {
+        codelog(SERVICE__ERROR, "Failed to deliver mail %u: %s", messageID, err.c_str());
+        return false;
+    }
+
+    return true;
+}
+
+bool MailDB::InsertOwnerRecipients(uint32 messageID, uint32 ownerID) const
+{
+    DBerror err;
+    if (!sDatabase.RunQuery(err,
+        "INSERT IGNORE INTO mailRecipient (messageID, characterID, statusMask, labelMask, unread)"
+        " SELECT %u, c.characterID, 0, %u, 1"
+        " FROM character_ c"
+        " JOIN corporation co USING (corporationID)"
+        " WHERE c.corporationID = %u OR co.allianceID = %u",
+        messageID, MAIL_DEFAULT_LABEL, ownerID, ownerID))
+    {
+        codelog(SERVICE__ERROR, "Failed to deliver mail %u to the members of %u: %s", messageID, ownerID, err.c_str());
+        return false;
+    }
+
+    return true;
+}
+
+void MailDB::SetMailUnread(uint32 characterID, uint32 messageID, bool unread) const
 {
     DBerror unused;
-    sDatabase.RunQuery(unused, "UPDATE mailMessage SET unread = %u WHERE messageID = %u", (unread ? 1 : 0), id);
+    sDatabase.RunQuery(unused, "UPDATE mailRecipient SET unread = %u WHERE messageID = %u AND characterID = %u",
+        (unread ? 1 : 0), messageID, characterID);
 }
 
 PyRep* MailDB::GetLabels(int characterID) const
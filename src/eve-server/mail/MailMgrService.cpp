@@ -28,6 +28,7 @@
 #include "PyServiceCD.h"
 #include "mail/MailDB.h"
 #include "mail/MailMgrService.h"
+#include "mail/MailStore.h"
 
 PyCallable_Make_InnerDispatcher(MailMgrService)
 
@@ -83,8 +84,11 @@ PyResult MailMgrService::Handle_SendMail(PyCallArgs &call)
         return NULL;
     }
 
-    int sender = call.client->GetCharacterID();
-    return new PyInt(m_db->SendMail(sender, args.toCharacterIDs, args.toListID, args.toCorpOrAllianceID, args.title, args.body, args.isReplyTo, args.isForwardedFrom));
+    // sanitize these ids
+    uint32 toListID = (args.toListID == -1 ? 0 : args.toListID);
+    uint32 toCorpOrAllianceID = (args.toCorpOrAllianceID == -1 ? 0 : args.toCorpOrAllianceID);
+
+    return new PyInt(sMailStore.Send(call.client->GetCharacterID(), args.toCharacterIDs, toListID, toCorpOrAllianceID, args.title, args.body));
 }
 
 PyResult MailMgrService::Handle_PrimeOwners(PyCallArgs &call)
@@ -112,15 +116,13 @@ PyResult MailMgrService::Handle_SyncMail(PyCallArgs &call)
             return NULL;
         }
 
-        // referring to a mail id range
-        int firstId = args.arg1, secondId = args.arg2;
+        // referring to the mail id range the client has
+        firstId = args.arg1;
+        secondId = args.arg2;
     }
 
-    PyDict* dummy = new PyDict;
-    dummy->SetItemString("oldMail", new PyNone());
-    dummy->SetItemString("newMail", m_db->GetNewMail(call.client->GetCharacterID()));
-    dummy->SetItemString("mailStatus", m_db->GetMailStatus(call.client->GetCharacterID()));
-    return new PyObject("util.KeyVal", dummy);
+    // only the mails newer than the ones the client has are sent
+    return sMailStore.Sync(call.client->GetCharacterID(), secondId);
 }
 
 PyResult MailMgrService::Handle_AssignLabels(PyCallArgs &call)
@@ -204,8 +206,8 @@ PyResult MailMgrService::Handle_GetBody(PyCallArgs &call)
         return NULL;
     }
 
-    m_db->SetMailUnread(args.messageId, args.isUnread);
-    return m_db->GetMailBody(args.messageId);
+    sMailStore.SetUnread(call.client->GetCharacterID(), args.messageId, args.isUnread);
+    return sMailStore.GetBody(call.client->GetCharacterID(), args.messageId);
 }
 
 PyResult MailMgrService::Handle_GetLabels(PyCallArgs &call)
@@ -223,7 +225,7 @@ PyResult MailMgrService::Handle_GetMailHeaders(PyCallArgs &call)
         return NULL;
     }
 
-    return NULL;
+    return sMailStore.GetHeaders(call.client->GetCharacterID(), args.ints);
 }
 
 PyResult MailMgrService::Handle_MarkAllAsRead(PyCallArgs &call)
@@ -249,7 +251,7 @@ PyResult MailMgrService::Handle_MarkAsRead(PyCallArgs &call)
     }
 
     for (size_t i = 0; i < args.ints.size(); i++)
-        m_db->SetMailUnread(args.ints[i], false);
+        sMailStore.SetUnread(call.client->GetCharacterID(), args.ints[i], false);
 
     return NULL;
 }
@@ -293,7 +295,7 @@ PyResult MailMgrService::Handle_MarkAsUnread(PyCallArgs &call)
     }
 
     for (size_t i = 0; i < args.ints.size(); i++)
-        m_db->SetMailUnread(args.ints[i], true);
+        sMailStore.SetUnread(call.client->GetCharacterID(), args.ints[i], true);
 
     return NULL;
 }
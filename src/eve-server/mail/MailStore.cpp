@@ -0,0 +1,359 @@
+/*
+    ------------------------------------------------------------------------------------
+    LICENSE:
+    ------------------------------------------------------------------------------------
+    This file is part of EVEmu: EVE Online Server Emulator
+    Copyright 2006 - 2011 The EVEmu Team
+    For the latest information visit http://evemu.org
+    ------------------------------------------------------------------------------------
+    This program is free software; you can redistribute it and/or modify it under
+    the terms of the GNU Lesser General Public License as published by the Free Software
+    Foundation; either version 2 of the License, or (at your option) any later
+    version.
+
+    This program is distributed in the hope that it will be useful, but WITHOUT
+    ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+    FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public License along with
+    this program; if not, write to the Free Software Foundation, Inc., 59 Temple
+    Place - Suite 330, Boston, MA 02111-1307, USA, or go to
+    http://www.gnu.org/copyleft/lesser.txt.
+    ------------------------------------------------------------------------------------
+    Author:     EVEmu Team
+*/
+
+#include "eve-server.h"
+
+#include "Client.h"
+#include "EntityList.h"
+#include "mail/MailStore.h"
+
+/// Most bodies kept in the cache.
+static const size_t MAIL_CACHED_BODIES = 256;
+/// Most deliveries to corporations and alliances run by a batch.
+static const size_t MAIL_DELIVERY_BATCH = 32;
+
+/**
+ * @brief Delivers a batch of mails to the members of their corporations or alliances on a worker thread.
+ */
+class MailStore::DeliveryQuery
+: public DBAsyncQuery
+{
+public:
+    DeliveryQuery( MailStore& store )
+    : mStore( store )
+    {
+    }
+
+    MailStore& mStore;
+    /// The mails to deliver.
+    std::vector< MailHeader > mMails;
+    /// Whether the delivery of each mail succeeded.
+    std::vector< bool > mDelivered;
+
+protected:
+    bool Run()
+    {
+        bool success = true;
+
+        mDelivered.resize( mMails.size() );
+        for( size_t i = 0; i < mMails.size(); ++i )
+        {
+            mDelivered[ i ] = mDB.InsertOwnerRecipients( mMails[ i ].messageID, mMails[ i ].toCorpOrAllianceID );
+            success = success && mDelivered[ i ];
+        }
+
+        return success;
+    }
+
+    void Complete( bool success, DBQueryResult& result )
+    {
+        mStore._CompleteDelivery( *this, success );
+    }
+
+    MailDB mDB;
+};
+
+/// Columns of the headers, in the order the client expects them.
+static DBRowDescriptor* NewHeaderRowDescriptor()
+{
+    DBRowDescriptor* header = new DBRowDescriptor();
+    header->AddColumn( "messageID",          DBTYPE_I4 );
+    header->AddColumn( "senderID",           DBTYPE_I8 );
+    header->AddColumn( "toCharacterIDs",     DBTYPE_WSTR );
+    header->AddColumn( "toListID",           DBTYPE_I4 );
+    header->AddColumn( "toCorpOrAllianceID", DBTYPE_I4 );
+    header->AddColumn( "title",              DBTYPE_WSTR );
+    header->AddColumn( "sentDate",           DBTYPE_I8 );
+    return header;
+}
+
+static void FillHeaderRow( const MailHeader& mail, PyPackedRow* into )
+{
+    into->SetField( (uint32)0, new PyInt( mail.messageID ) );
+    into->SetField( 1, new PyLong( (int64)mail.senderID ) );
+    into->SetField( 2, new PyWString( mail.toCharacterIDs ) );
+    into->SetField( 3, new PyInt( mail.toListID ) );
+    into->SetField( 4, new PyInt( mail.toCorpOrAllianceID ) );
+    into->SetField( 5, new PyWString( mail.title ) );
+    into->SetField( 6, new PyLong( (int64)mail.sentDate ) );
+}
+
+MailStore::MailStore()
+: mDelivering( 0 )
+{
+}
+
+uint32 MailStore::Send( uint32 senderID, const std::vector<int32>& toCharacterIDs, uint32 toListID, uint32 toCorpOrAllianceID,
+                        const std::string& title, const std::string& body )
+{
+    // compress the body
+    Buffer bodyCompressed;
+    Buffer bodyInput( body.begin(), body.end() );
+    DeflateData( bodyInput, bodyCompressed );
+    const std::string compressed( bodyCompressed.begin<char>(), bodyCompressed.end<char>() );
+
+    bool shared;
+    MailHeader mail;
+    mail.bodyID = mDB.StoreBody( compressed, shared );
+    if( 0 == mail.bodyID )
+        return 0;
+
+    // build a string with ',' seperated char ids, leaving out the duplicates
+    std::vector<uint32> recipients;
+    std::vector<int32>::const_iterator cur, end;
+    cur = toCharacterIDs.begin();
+    end = toCharacterIDs.end();
+    for(; cur != end; ++cur)
+    {
+        if( *cur <= 0 || std::find( recipients.begin(), recipients.end(), (uint32)*cur ) != recipients.end() )
+            continue;
+
+        if( !recipients.empty() )
+            mail.toCharacterIDs += ",";
+        mail.toCharacterIDs += itoa( *cur );
+        recipients.push_back( *cur );
+    }
+
+    mail.senderID = senderID;
+    mail.toListID = toListID;
+    mail.toCorpOrAllianceID = toCorpOrAllianceID;
+    mail.title = title;
+    mail.sentDate = Win32TimeNow();
+    mail.statusMask = 0;
+    mail.labelMask = 1;     // Inbox
+    mail.unread = true;
+
+    if( !mDB.InsertMessage( mail ) )
+        return 0;
+
+    ++mStats.sent;
+    if( shared )
+        ++mStats.sharedBodies;
+
+    // the listed recipients get it right away
+    if( !mDB.InsertRecipients( mail.messageID, recipients ) )
+        return 0;
+
+    std::vector<uint32>::const_iterator curr, endr;
+    curr = recipients.begin();
+    endr = recipients.end();
+    for(; curr != endr; ++curr)
+        _AddToMailbox( *curr, mail );
+
+    // the members of a corporation or alliance in the background
+    if( 0 != toCorpOrAllianceID )
+        mDeliveries.push_back( mail );
+
+    return mail.messageID;
+}
+
+PyObject* MailStore::Sync( uint32 characterID, uint32 lastSeenID )
+{
+    Mailbox* box = _GetMailbox( characterID );
+    if( NULL == box )
+        return NULL;
+
+    ++mStats.syncs;
+
+    DBRowDescriptor* header = NewHeaderRowDescriptor();
+    CRowSet* newMail = new CRowSet( &header );
+    Mailbox::const_iterator cur, end;
+    cur = box->upper_bound( lastSeenID );
+    end = box->end();
+    for(; cur != end; ++cur)
+        FillHeaderRow( cur->second, newMail->NewRow() );
+
+    DBRowDescriptor* statusHeader = new DBRowDescriptor();
+    statusHeader->AddColumn( "messageID",  DBTYPE_I4 );
+    statusHeader->AddColumn( "statusMask", DBTYPE_I1 );
+    statusHeader->AddColumn( "labelMask",  DBTYPE_I4 );
+    CRowSet* mailStatus = new CRowSet( &statusHeader );
+
+    cur = box->begin();
+    for(; cur != end; ++cur)
+    {
+        PyPackedRow* row = mailStatus->NewRow();
+        row->SetField( (uint32)0, new PyInt( cur->second.messageID ) );
+        row->SetField( 1, new PyInt( cur->second.statusMask ) );
+        row->SetField( 2, new PyInt( cur->second.labelMask ) );
+    }
+
+    PyDict* dict = new PyDict;
+    dict->SetItemString( "oldMail", new PyNone() );
+    dict->SetItemString( "newMail", newMail );
+    dict->SetItemString( "mailStatus", mailStatus );
+    return new PyObject( "util.KeyVal", dict );
+}
+
+PyRep* MailStore::GetHeaders( uint32 characterID, const std::vector<int32>& messageIDs )
+{
+    Mailbox* box = _GetMailbox( characterID );
+    if( NULL == box )
+        return NULL;
+
+    DBRowDescriptor* header = NewHeaderRowDescriptor();
+    CRowSet* rowset = new CRowSet( &header );
+    std::vector<int32>::const_iterator cur, end;
+    cur = messageIDs.begin();
+    end = messageIDs.end();
+    for(; cur != end; ++cur)
+    {
+        Mailbox::const_iterator res = box->find( *cur );
+        if( res != box->end() )
+            FillHeaderRow( res->second, rowset->NewRow() );
+    }
+
+    return rowset;
+}
+
+PyString* MailStore::GetBody( uint32 characterID, uint32 messageID )
+{
+    Mailbox* box = _GetMailbox( characterID );
+    if( NULL == box )
+        return NULL;
+
+    Mailbox::const_iterator res = box->find( messageID );
+    if( res == box->end() )
+        return NULL;
+
+    const uint32 bodyID = res->second.bodyID;
+
+    std::map< uint32, std::string >::const_iterator cached = mBodies.find( bodyID );
+    if( cached != mBodies.end() )
+    {
+        ++mStats.bodyHits;
+        return new PyString( cached->second );
+    }
+
+    ++mStats.bodyMisses;
+
+    PyString* body = mDB.GetMailBody( bodyID );
+    if( NULL == body )
+        return NULL;
+
+    // a mass mail is read by many, so its body is worth keeping
+    if( MAIL_CACHED_BODIES <= mBodyOrder.size() )
+    {
+        mBodies.erase( mBodyOrder.front() );
+        mBodyOrder.pop_front();
+    }
+    mBodies.insert( std::make_pair( bodyID, body->content() ) );
+    mBodyOrder.push_back( bodyID );
+
+    return body;
+}
+
+void MailStore::SetUnread( uint32 characterID, uint32 messageID, bool unread )
+{
+    Mailbox* box = _GetMailbox( characterID );
+    if( NULL == box )
+        return;
+
+    Mailbox::iterator res = box->find( messageID );
+    if( res == box->end() || res->second.unread == unread )
+        return;
+
+    res->second.unread = unread;
+    mDB.SetMailUnread( characterID, messageID, unread );
+}
+
+void MailStore::Process()
+{
+    if( 0 != mDelivering || mDeliveries.empty() )
+        return;
+
+    DeliveryQuery* query = new DeliveryQuery( *this );
+    while( !mDeliveries.empty() && query->mMails.size() < MAIL_DELIVERY_BATCH )
+    {
+        query->mMails.push_back( mDeliveries.front() );
+        mDeliveries.pop_front();
+    }
+
+    mDelivering = query->mMails.size();
+    sDBAsync.Submit( query );
+}
+
+MailStore::Mailbox* MailStore::_GetMailbox( uint32 characterID )
+{
+    std::tr1::unordered_map< uint32, Mailbox >::iterator res = mMailboxes.find( characterID );
+    if( res != mMailboxes.end() )
+        return &res->second;
+
+    std::vector<MailHeader> mails;
+    if( !mDB.GetMailbox( characterID, mails ) )
+        return NULL;
+
+    ++mStats.mailboxLoads;
+
+    Mailbox& box = mMailboxes[ characterID ];
+    std::vector<MailHeader>::const_iterator cur, end;
+    cur = mails.begin();
+    end = mails.end();
+    for(; cur != end; ++cur)
+        box.insert( std::make_pair( cur->messageID, *cur ) );
+
+    return &box;
+}
+
+void MailStore::_AddToMailbox( uint32 characterID, const MailHeader& header )
+{
+    std::tr1::unordered_map< uint32, Mailbox >::iterator res = mMailboxes.find( characterID );
+    if( res != mMailboxes.end() )
+        res->second.insert( std::make_pair( header.messageID, header ) );
+}
+
+void MailStore::_CompleteDelivery( DeliveryQuery& query, bool success )
+{
+    mDelivering = 0;
+
+    for( size_t i = 0; i < query.mMails.size(); ++i )
+    {
+        const MailHeader& mail = query.mMails[ i ];
+        if( !query.mDelivered[ i ] )
+        {
+            _log( SERVICE__ERROR, "Failed to deliver mail %u to the members of %u.", mail.messageID, mail.toCorpOrAllianceID );
+            ++mStats.failedDeliveries;
+            continue;
+        }
+
+        ++mStats.deliveries;
+
+        // only the online characters have a resident mailbox
+        std::tr1::unordered_map< uint32, Mailbox >::iterator cur, end;
+        cur = mMailboxes.begin();
+        end = mMailboxes.end();
+        for(; cur != end; ++cur)
+        {
+            Client* client = sEntityList.FindCharacter( cur->first );
+            if( NULL != client
+                && ( client->GetCorporationID() == mail.toCorpOrAllianceID
+                     || client->GetAllianceID() == mail.toCorpOrAllianceID ) )
+                cur->second.insert( std::make_pair( mail.messageID, mail ) );
+        }
+    }
+
+    // start the next batch right away
+    Process();
+}
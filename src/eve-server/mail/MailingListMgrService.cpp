@@ -64,13 +64,13 @@ MailingListMgrService::~MailingListMgrService()
 PyResult MailingListMgrService::Handle_GetJoinedLists(PyCallArgs& call)
 {
     // no args
-    sLog.Debug("MailingListMgrService", "Called GetJoinedLists stub" );
+    _debug("MailingListMgrService", "Called GetJoinedLists stub" );
     return new PyDict();
 }
 
 PyResult MailingListMgrService::Handle_Create(PyCallArgs& call)
 {
-    sLog.Debug("MailingListMgrService", "Called Create stub" );
+    _debug("MailingListMgrService", "Called Create stub" );
     Call_CreateMailingList args;
     if (!args.Decode(&call.tuple))
     {
@@ -83,7 +83,7 @@ PyResult MailingListMgrService::Handle_Create(PyCallArgs& call)
 
 PyResult MailingListMgrService::Handle_Join(PyCallArgs& call)
 {
-    sLog.Debug("MailingListMgrService", "Called Join stub" );
+    _debug("MailingListMgrService", "Called Join stub" );
     Call_SingleStringArg args;
     if(!args.Decode(&call.tuple)) {
         codelog(CLIENT__ERROR, "Failed to decode Join args");
@@ -97,7 +97,7 @@ PyResult MailingListMgrService::Handle_Join(PyCallArgs& call)
 
 PyResult MailingListMgrService::Handle_Leave(PyCallArgs& call)
 {
-    sLog.Debug("MailingListMgrService", "Called Leave stub" );
+    _debug("MailingListMgrService", "Called Leave stub" );
     Call_SingleIntegerArg args;
     if (!args.Decode(&call.tuple))
     {
@@ -112,7 +112,7 @@ PyResult MailingListMgrService::Handle_Leave(PyCallArgs& call)
 
 PyResult MailingListMgrService::Handle_Delete(PyCallArgs& call)
 {
-    sLog.Debug("MailingListMgrService", "Called Delete stub" );
+    _debug("MailingListMgrService", "Called Delete stub" );
     Call_SingleIntegerArg args;
     if (!args.Decode(&call.tuple))
     {
@@ -127,7 +127,7 @@ PyResult MailingListMgrService::Handle_Delete(PyCallArgs& call)
 
 PyResult MailingListMgrService::Handle_KickMembers(PyCallArgs& call)
 {
-    sLog.Debug("MailingListMgrService", "Called KickMembers stub" );
+    _debug("MailingListMgrService", "Called KickMembers stub" );
     Call_MemberList args;
     if (!args.Decode(&call.tuple))
     {
@@ -140,7 +140,7 @@ PyResult MailingListMgrService::Handle_KickMembers(PyCallArgs& call)
 
 PyResult MailingListMgrService::Handle_GetMembers(PyCallArgs& call)
 {
-    sLog.Debug("MailingListMgrService", "Called GetMembers stub" );
+    _debug("MailingListMgrService", "Called GetMembers stub" );
     Call_SingleIntegerArg args;
     if (!args.Decode(&call.tuple))
     {
@@ -155,7 +155,7 @@ PyResult MailingListMgrService::Handle_GetMembers(PyCallArgs& call)
 
 PyResult MailingListMgrService::Handle_SetEntityAccess(PyCallArgs& call)
 {
-    sLog.Debug("MailingListMgrService", "Called SetEntityAccess stub" );
+    _debug("MailingListMgrService", "Called SetEntityAccess stub" );
     Call_SetEntityAccess args;
     if (!args.Decode(&call.tuple))
     {
@@ -168,7 +168,7 @@ PyResult MailingListMgrService::Handle_SetEntityAccess(PyCallArgs& call)
 
 PyResult MailingListMgrService::Handle_ClearEntityAccess(PyCallArgs& call)
 {
-    sLog.Debug("MailingListMgrService", "Called ClearEntityAccess stub" );
+    _debug("MailingListMgrService", "Called ClearEntityAccess stub" );
     Call_ClearEntityAccess args;
     if (!args.Decode(&call.tuple))
     {
@@ -181,7 +181,7 @@ PyResult MailingListMgrService::Handle_ClearEntityAccess(PyCallArgs& call)
 
 PyResult MailingListMgrService::Handle_SetMembersMuted(PyCallArgs& call)
 {
-    sLog.Debug("MailingListMgrService", "Called SetMembersMuted stub" );
+    _debug("MailingListMgrService", "Called SetMembersMuted stub" );
     Call_MemberList args;
     if (!args.Decode(&call.tuple))
     {
@@ -193,7 +193,7 @@ PyResult MailingListMgrService::Handle_SetMembersMuted(PyCallArgs& call)
 
 PyResult MailingListMgrService::Handle_SetMembersOperator(PyCallArgs& call)
 {
-    sLog.Debug("MailingListMgrService", "Called SetMembersOperator stub" );
+    _debug("MailingListMgrService", "Called SetMembersOperator stub" );
     Call_MemberList args;
     if (!args.Decode(&call.tuple))
     {
@@ -205,7 +205,7 @@ PyResult MailingListMgrService::Handle_SetMembersOperator(PyCallArgs& call)
 
 PyResult MailingListMgrService::Handle_SetMembersClear(PyCallArgs& call)
 {
-    sLog.Debug("MailingListMgrService", "Called SetMembersClear stub" );
+    _debug("MailingListMgrService", "Called SetMembersClear stub" );
     Call_MemberList args;
     if (!args.Decode(&call.tuple))
     {
@@ -217,7 +217,7 @@ PyResult MailingListMgrService::Handle_SetMembersClear(PyCallArgs& call)
 
 PyResult MailingListMgrService::Handle_SetDefaultAccess(PyCallArgs& call)
 {
-    sLog.Debug("MailingListMgrService", "Called SetDefaultAccess stub" );
+    _debug("MailingListMgrService", "Called SetDefaultAccess stub" );
     Call_SetDefaultAccess args;
     if (!args.Decode(&call.tuple))
     {
@@ -229,7 +229,7 @@ PyResult MailingListMgrService::Handle_SetDefaultAccess(PyCallArgs& call)
 
 PyResult MailingListMgrService::Handle_GetSettings(PyCallArgs& call)
 {
-    sLog.Debug("MailingListMgrService", "Called GetSettings stub" );
+    _debug("MailingListMgrService", "Called GetSettings stub" );
     Call_SingleIntegerArg args;
     if (!args.Decode(&call.tuple))
     {
@@ -243,7 +243,7 @@ PyResult MailingListMgrService::Handle_GetSettings(PyCallArgs& call)
 
 PyResult MailingListMgrService::Handle_GetWelcomeMail(PyCallArgs& call)
 {
-    sLog.Debug("MailingListMgrService", "Called GetWelcomeMail stub" );
+    _debug("MailingListMgrService", "Called GetWelcomeMail stub" );
     Call_SingleIntegerArg args;
     if (!args.Decode(&call.tuple))
     {
@@ -257,7 +257,7 @@ PyResult MailingListMgrService::Handle_GetWelcomeMail(PyCallArgs& call)
 
 PyResult MailingListMgrService::Handle_SaveWelcomeMail(PyCallArgs& call)
 {
-    sLog.Debug("MailingListMgrService", "Called SaveWelcomeMail stub" );
+    _debug("MailingListMgrService", "Called SaveWelcomeMail stub" );
     Call_SaveWelcomeMail args;
     if (!args.Decode(&call.tuple))
     {
@@ -269,7 +269,7 @@ PyResult MailingListMgrService::Handle_SaveWelcomeMail(PyCallArgs& call)
 
 PyResult MailingListMgrService::Handle_SendWelcomeMail(PyCallArgs& call)
 {
-    sLog.Debug("MailingListMgrService", "Called SendWelcomeMail stub" );
+    _debug("MailingListMgrService", "Called SendWelcomeMail stub" );
     Call_SaveWelcomeMail args;
     if (!args.Decode(&call.tuple))
     {
@@ -281,7 +281,7 @@ PyResult MailingListMgrService::Handle_SendWelcomeMail(PyCallArgs& call)
 
 PyResult MailingListMgrService::Handle_ClearWelcomeMail(PyCallArgs& call)
 {
-    sLog.Debug("MailingListMgrService", "Called ClearWelcomeMail stub" );
+    _debug("MailingListMgrService", "Called ClearWelcomeMail stub" );
     Call_SingleIntegerArg args;
     if (!args.Decode(&call.tuple))
     {
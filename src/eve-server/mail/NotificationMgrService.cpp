@@ -27,6 +27,23 @@
 
 #include "PyServiceCD.h"
 #include "mail/NotificationMgrService.h"
+#include "mail/NotificationQueue.h"
+
+/**
+ * @brief Collects the notificationIDs of a list argument.
+ */
+static void GetNotificationIDs(PyRep* arg, std::vector<uint32>& into)
+{
+    if (!arg->IsList())
+        return;
+
+    PyList::const_iterator cur, end;
+    cur = arg->AsList()->begin();
+    end = arg->AsList()->end();
+    for (; cur != end; cur++)
+        if ((*cur)->IsInt())
+            into.push_back((*cur)->AsInt()->value());
+}
 
 PyCallable_Make_InnerDispatcher(NotificationMgrService)
 
@@ -59,12 +76,12 @@ PyResult NotificationMgrService::Handle_GetByGroupID(PyCallArgs &call)
         return NULL;
     }
     int groupID = args.arg;
-    return new PyTuple(0);
+    return sNotificationQueue.GetByGroupID(call.client->GetCharacterID(), groupID);
 }
 
 PyResult NotificationMgrService::Handle_GetUnprocessed(PyCallArgs &call)
 {
-    return new PyTuple(0);
+    return sNotificationQueue.GetUnprocessed(call.client->GetCharacterID());
 }
 
 PyResult NotificationMgrService::Handle_MarkGroupAsProcessed(PyCallArgs &call)
@@ -76,11 +93,13 @@ PyResult NotificationMgrService::Handle_MarkGroupAsProcessed(PyCallArgs &call)
         return NULL;
     }
     int groupID = args.arg;
+    sNotificationQueue.MarkGroupAsProcessed(call.client->GetCharacterID(), groupID);
     return NULL;
 }
 
 PyResult NotificationMgrService::Handle_MarkAllAsProcessed(PyCallArgs &call)
 {
+    sNotificationQueue.MarkAllAsProcessed(call.client->GetCharacterID());
     return NULL;
 }
 
@@ -93,6 +112,10 @@ PyResult NotificationMgrService::Handle_MarkAsProcessed(PyCallArgs &call)
         return NULL;
     }
     PyRep* notificationsList = args.arg;
+
+    std::vector<uint32> notificationIDs;
+    GetNotificationIDs(notificationsList, notificationIDs);
+    sNotificationQueue.MarkAsProcessed(call.client->GetCharacterID(), notificationIDs);
     return NULL;
 }
 
@@ -105,11 +128,13 @@ PyResult NotificationMgrService::Handle_DeleteGroupNotifications(PyCallArgs &cal
         return NULL;
     }
     int groupID = args.arg;
+    sNotificationQueue.DeleteGroup(call.client->GetCharacterID(), groupID);
     return NULL;
 }
 
 PyResult NotificationMgrService::Handle_DeleteAllNotifications(PyCallArgs &call)
 {
+    sNotificationQueue.DeleteAll(call.client->GetCharacterID());
     return NULL;
 }
 
@@ -122,5 +147,9 @@ PyResult NotificationMgrService::Handle_DeleteNotifications(PyCallArgs &call)
         return NULL;
     }
     PyRep* notificationsIDs = args.arg;
+
+    std::vector<uint32> notificationIDs;
+    GetNotificationIDs(notificationsIDs, notificationIDs);
+    sNotificationQueue.Delete(call.client->GetCharacterID(), notificationIDs);
     return NULL;
 }
@@ -0,0 +1,348 @@
+/*
+    ------------------------------------------------------------------------------------
+    LICENSE:
+    ------------------------------------------------------------------------------------
+    This file is part of EVEmu: EVE Online Server Emulator
+    Copyright 2006 - 2011 The EVEmu Team
+    For the latest information visit http://evemu.org
+    ------------------------------------------------------------------------------------
+    This program is free software; you can redistribute it and/or modify it under
+    the terms of the GNU Lesser General Public License as published by the Free Software
+    Foundation; either version 2 of the License, or (at your option) any later
+    version.
+
+    This program is distributed in the hope that it will be useful, but WITHOUT
+    ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+    FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public License along with
+    this program; if not, write to the Free Software Foundation, Inc., 59 Temple
+    Place - Suite 330, Boston, MA 02111-1307, USA, or go to
+    http://www.gnu.org/copyleft/lesser.txt.
+    ------------------------------------------------------------------------------------
+    Author:     EVEmu Team
+*/
+
+#include "eve-server.h"
+
+#include "Client.h"
+#include "EntityList.h"
+#include "mail/NotificationQueue.h"
+
+/// Most rows written by a single INSERT.
+static const size_t NOTIFICATION_INSERT_ROWS = 500;
+
+NotificationQueue::NotificationQueue()
+: mLastID( 0 )
+{
+}
+
+bool NotificationQueue::Load()
+{
+    DBQueryResult res;
+    if( !sDatabase.RunQuery( res, "SELECT MAX(notificationID) FROM chrNotifications" ) )
+    {
+        sLog.Error( "NotificationQueue", "Failed to query the last notificationID: %s.", res.error.c_str() );
+        return false;
+    }
+
+    DBResultRow row;
+    if( res.GetRow( row ) && !row.IsNull( 0 ) )
+        mLastID = row.GetUInt( 0 );
+
+    return true;
+}
+
+uint32 NotificationQueue::Enqueue( uint32 receiverID, uint32 groupID, uint32 typeID, uint32 senderID, const std::string& data )
+{
+    return Enqueue( std::vector<uint32>( 1, receiverID ), groupID, typeID, senderID, data );
+}
+
+uint32 NotificationQueue::Enqueue( const std::vector<uint32>& receiverIDs, uint32 groupID, uint32 typeID, uint32 senderID, const std::string& data )
+{
+    mQueue.push_back( Notification() );
+
+    Notification& notification = mQueue.back();
+    notification.notificationID = ++mLastID;
+    notification.groupID = groupID;
+    notification.typeID = typeID;
+    notification.senderID = senderID;
+    notification.created = Win32TimeNow();
+    notification.data = data;
+    notification.receiverIDs = receiverIDs;
+    notification.enqueued = GetTimeUSeconds();
+
+    ++mStats.enqueued;
+    if( mStats.maxDepth < mQueue.size() )
+        mStats.maxDepth = mQueue.size();
+
+    return notification.notificationID;
+}
+
+bool NotificationQueue::Process()
+{
+    if( mQueue.empty() )
+        return true;
+
+    if( !_Persist() )
+    {
+        ++mStats.failures;
+        return false;
+    }
+
+    _Push();
+
+    const uint64 now = GetTimeUSeconds();
+    std::vector< Notification >::const_iterator cur, end;
+    cur = mQueue.begin();
+    end = mQueue.end();
+    for(; cur != end; ++cur)
+    {
+        const uint64 latency = now - cur->enqueued;
+        ++mStats.delivered;
+        mStats.latency += latency;
+        if( mStats.maxLatency < latency )
+            mStats.maxLatency = latency;
+    }
+
+    mQueue.clear();
+    return true;
+}
+
+PyRep* NotificationQueue::GetByGroupID( uint32 receiverID, uint32 groupID )
+{
+    // whatever was enqueued meanwhile must be in the result
+    Process();
+
+    DBQueryResult res;
+    if( !sDatabase.RunQuery( res,
+        "SELECT notificationID, typeID, senderID, receiverID, processed, created, data"
+        " FROM chrNotifications"
+        " WHERE receiverID = %u AND groupID = %u"
+        " ORDER BY notificationID", receiverID, groupID ) )
+    {
+        codelog( SERVICE__ERROR, "Failed to query notifications of %u: %s", receiverID, res.error.c_str() );
+        return NULL;
+    }
+
+    return DBResultToRowList( res );
+}
+
+PyRep* NotificationQueue::GetUnprocessed( uint32 receiverID )
+{
+    Process();
+
+    DBQueryResult res;
+    if( !sDatabase.RunQuery( res,
+        "SELECT notificationID, typeID, senderID, receiverID, processed, created, data"
+        " FROM chrNotifications"
+        " WHERE receiverID = %u AND processed = 0"
+        " ORDER BY notificationID", receiverID ) )
+    {
+        codelog( SERVICE__ERROR, "Failed to query notifications of %u: %s", receiverID, res.error.c_str() );
+        return NULL;
+    }
+
+    return DBResultToRowList( res );
+}
+
+void NotificationQueue::MarkGroupAsProcessed( uint32 receiverID, uint32 groupID )
+{
+    Process();
+
+    // a single range of the (receiverID, groupID, notificationID) index
+    DBerror err;
+    if( !sDatabase.RunQuery( err,
+        "UPDATE chrNotifications SET processed = 1"
+        " WHERE receiverID = %u AND groupID = %u AND processed = 0", receiverID, groupID ) )
+        codelog( SERVICE__ERROR, "Failed to mark notifications of %u as processed: %s", receiverID, err.c_str() );
+}
+
+void NotificationQueue::MarkAllAsProcessed( uint32 receiverID )
+{
+    Process();
+
+    DBerror err;
+    if( !sDatabase.RunQuery( err,
+        "UPDATE chrNotifications SET processed = 1"
+        " WHERE receiverID = %u AND processed = 0", receiverID ) )
+        codelog( SERVICE__ERROR, "Failed to mark notifications of %u as processed: %s", receiverID, err.c_str() );
+}
+
+void NotificationQueue::MarkAsProcessed( uint32 receiverID, const std::vector<uint32>& notificationIDs )
+{
+    if( notificationIDs.empty() )
+        return;
+
+    Process();
+
+    std::string ids;
+    ListToINString( notificationIDs, ids );
+
+    DBerror err;
+    if( !sDatabase.RunQuery( err,
+        "UPDATE chrNotifications SET processed = 1"
+        " WHERE receiverID = %u AND notificationID IN (%s)", receiverID, ids.c_str() ) )
+        codelog( SERVICE__ERROR, "Failed to mark notifications of %u as processed: %s", receiverID, err.c_str() );
+}
+
+void NotificationQueue::DeleteGroup( uint32 receiverID, uint32 groupID )
+{
+    Process();
+
+    DBerror err;
+    if( !sDatabase.RunQuery( err,
+        "DELETE FROM chrNotifications"
+        " WHERE receiverID = %u AND groupID = %u", receiverID, groupID ) )
+        codelog( SERVICE__ERROR, "Failed to delete notifications of %u: %s", receiverID, err.c_str() );
+}
+
+void NotificationQueue::DeleteAll( uint32 receiverID )
+{
+    Process();
+
+    DBerror err;
+    if( !sDatabase.RunQuery( err,
+        "DELETE FROM chrNotifications"
+        " WHERE receiverID = %u", receiverID ) )
+        codelog( SERVICE__ERROR, "Failed to delete notifications of %u: %s", receiverID, err.c_str() );
+}
+
+void NotificationQueue::Delete( uint32 receiverID, const std::vector<uint32>& notificationIDs )
+{
+    if( notificationIDs.empty() )
+        return;
+
+    Process();
+
+    std::string ids;
+    ListToINString( notificationIDs, ids );
+
+    DBerror err;
+    if( !sDatabase.RunQuery( err,
+        "DELETE FROM chrNotifications"
+        " WHERE receiverID = %u AND notificationID IN (%s)", receiverID, ids.c_str() ) )
+        codelog( SERVICE__ERROR, "Failed to delete notifications of %u: %s", receiverID, err.c_str() );
+}
+
+bool NotificationQueue::_Persist()
+{
+    std::string values;
+    size_t rows = 0;
+
+    std::vector< Notification >::const_iterator cur, end;
+    cur = mQueue.begin();
+    end = mQueue.end();
+    for(; cur != end; ++cur)
+    {
+        std::string dataEscaped;
+        sDatabase.DoEscapeString( dataEscaped, cur->data );
+
+        std::vector<uint32>::const_iterator curr, endr;
+        curr = cur->receiverIDs.begin();
+        endr = cur->receiverIDs.end();
+        for(; curr != endr; ++curr)
+        {
+            char buf[ 160 ];
+            snprintf( buf, sizeof( buf ), "%s(%u, %u, %u, %u, %u, %" PRIu64 ", 0, '",
+                      ( 0 == rows ? "" : "," ), cur->notificationID, *curr, cur->groupID, cur->typeID, cur->senderID, cur->created );
+            values += buf;
+            values += dataEscaped;
+            values += "')";
+
+            if( NOTIFICATION_INSERT_ROWS <= ++rows )
+            {
+                // IGNORE, so a retry after a failure does not trip over the rows already written
+                DBerror err;
+                if( !sDatabase.RunQuery( err,
+                    "INSERT IGNORE INTO chrNotifications (notificationID, receiverID, groupID, typeID, senderID, created, processed, data)"
+                    " VALUES %s", values.c_str() ) )
+                {
+                    sLog.Error( "NotificationQueue", "Failed to write notifications: %s.", err.c_str() );
+                    return false;
+                }
+
+                ++mStats.inserts;
+                mStats.persisted += rows;
+                values.clear();
+                rows = 0;
+            }
+        }
+    }
+
+    if( 0 < rows )
+    {
+        DBerror err;
+        if( !sDatabase.RunQuery( err,
+            "INSERT IGNORE INTO chrNotifications (notificationID, receiverID, groupID, typeID, senderID, created, processed, data)"
+            " VALUES %s", values.c_str() ) )
+        {
+            sLog.Error( "NotificationQueue", "Failed to write notifications: %s.", err.c_str() );
+            return false;
+        }
+
+        ++mStats.inserts;
+        mStats.persisted += rows;
+    }
+
+    return true;
+}
+
+void NotificationQueue::_Push()
+{
+    // the events of every online receiver
+    std::map< Client*, PyList* > events;
+
+    std::vector< Notification >::const_iterator cur, end;
+    cur = mQueue.begin();
+    end = mQueue.end();
+    for(; cur != end; ++cur)
+    {
+        PyTuple* event = NULL;
+
+        std::vector<uint32>::const_iterator curr, endr;
+        curr = cur->receiverIDs.begin();
+        endr = cur->receiverIDs.end();
+        for(; curr != endr; ++curr)
+        {
+            Client* client = sEntityList.FindCharacter( *curr );
+            if( NULL == client )
+                continue;
+
+            // encoded once for all the receivers
+            if( NULL == event )
+            {
+                event = new PyTuple( 6 );
+                event->SetItem( 0, new PyString( "OnNotificationReceived" ) );
+                event->SetItem( 1, new PyInt( cur->notificationID ) );
+                event->SetItem( 2, new PyInt( cur->typeID ) );
+                event->SetItem( 3, new PyInt( cur->senderID ) );
+                event->SetItem( 4, new PyLong( (int64)cur->created ) );
+                event->SetItem( 5, new PyString( cur->data ) );
+            }
+
+            PyList*& list = events[ client ];
+            if( NULL == list )
+                list = new PyList;
+
+            PyIncRef( event );
+            list->AddItem( event );
+            ++mStats.pushed;
+        }
+
+        PySafeDecRef( event );
+    }
+
+    std::map< Client*, PyList* >::iterator curc, endc;
+    curc = events.begin();
+    endc = events.end();
+    for(; curc != endc; ++curc)
+    {
+        Notify_OnMultiEvent nom;
+        nom.events = curc->second;
+
+        PyTuple* t = nom.Encode();   //this is consumed below
+        curc->first->SendNotification( "OnMultiEvent", "charid", &t );
+        ++mStats.pushes;
+    }
+}
@@ -0,0 +1,251 @@
+/*
+    ------------------------------------------------------------------------------------
+    LICENSE:
+    ------------------------------------------------------------------------------------
+    This file is part of EVEmu: EVE Online Server Emulator
+    Copyright 2006 - 2011 The EVEmu Team
+    For the latest information visit http://evemu.org
+    ------------------------------------------------------------------------------------
+    This program is free software; you can redistribute it and/or modify it under
+    the terms of the GNU Lesser General Public License as published by the Free Software
+    Foundation; either version 2 of the License, or (at your option) any later
+    version.
+
+    This program is distributed in the hope that it will be useful, but WITHOUT
+    ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+    FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public License along with
+    this program; if not, write to the Free Software Foundation, Inc., 59 Temple
+    Place - Suite 330, Boston, MA 02111-1307, USA, or go to
+    http://www.gnu.org/copyleft/lesser.txt.
+    ------------------------------------------------------------------------------------
+    Author:     EVEmu Team
+*/
+
+#include "eve-server.h"
+
+#include "manufacturing/RamJobScheduler.h"
+
+RamJobScheduler::RamJobScheduler()
+: mNextJobID( 1 )
+{
+}
+
+bool RamJobScheduler::Load()
+{
+    DBQueryResult res;
+    if( !sDatabase.RunQuery( res,
+        "SELECT"
+        "   job.jobID, job.ownerID, job.installerID, job.assemblyLineID, job.installedItemID,"
+        "   job.installTime, job.beginProductionTime, job.endProductionTime, job.description,"
+        "   job.runs, job.outputFlag, job.installedInSolarSystemID, job.licensedProductionRuns,"
+        "   line.activityID"
+        " FROM ramJobs AS job"
+        " LEFT JOIN ramAssemblyLines AS line ON job.assemblyLineID = line.assemblyLineID"
+        " WHERE job.completedStatusID = %u",
+        (uint32)ramCompletedStatusInProgress ) )
+    {
+        codelog( SERVICE__ERROR, "Error in query: %s", res.error.c_str() );
+        return false;
+    }
+
+    mJobs.clear();
+    mFinishQueue = FinishQueue();
+    mLines.clear();
+    mManufacturingJobs.clear();
+    mResearchJobs.clear();
+
+    DBResultRow row;
+    while( res.GetRow( row ) )
+    {
+        RamJob job;
+        job.jobID = row.GetUInt( 0 );
+        job.ownerID = row.GetUInt( 1 );
+        job.installerID = row.GetUInt( 2 );
+        job.assemblyLineID = row.GetUInt( 3 );
+        job.installedItemID = row.GetUInt( 4 );
+        job.installTime = row.GetUInt64( 5 );
+        job.beginProductionTime = row.GetUInt64( 6 );
+        job.endProductionTime = row.GetUInt64( 7 );
+        job.description = row.GetText( 8 );
+        job.runs = row.GetUInt( 9 );
+        job.outputFlag = (EVEItemFlags)row.GetUInt( 10 );
+        job.installedInSolarSystemID = row.GetUInt( 11 );
+        job.licensedProductionRuns = ( row.IsNull( 12 ) ? 0 : row.GetInt( 12 ) );
+        job.activity = (EVERamActivity)( row.IsNull( 13 ) ? 0 : row.GetUInt( 13 ) );
+
+        _Insert( job );
+    }
+
+    // the completed jobs keep their IDs too
+    if( !sDatabase.RunQuery( res, "SELECT MAX(jobID) FROM ramJobs" ) )
+    {
+        codelog( SERVICE__ERROR, "Error in query: %s", res.error.c_str() );
+        return false;
+    }
+
+    mNextJobID = 1;
+    if( res.GetRow( row ) && !row.IsNull( 0 ) )
+        mNextJobID = row.GetUInt( 0 ) + 1;
+
+    return true;
+}
+
+const RamJob* RamJobScheduler::GetJob( uint32 jobID ) const
+{
+    std::tr1::unordered_map< uint32, RamJob >::const_iterator res = mJobs.find( jobID );
+    if( res == mJobs.end() )
+        return NULL;
+
+    return &res->second;
+}
+
+uint32 RamJobScheduler::CountManufacturingJobs( uint32 installerID ) const
+{
+    std::map< uint32, uint32 >::const_iterator res = mManufacturingJobs.find( installerID );
+    return ( res == mManufacturingJobs.end() ? 0 : res->second );
+}
+
+uint32 RamJobScheduler::CountResearchJobs( uint32 installerID ) const
+{
+    std::map< uint32, uint32 >::const_iterator res = mResearchJobs.find( installerID );
+    return ( res == mResearchJobs.end() ? 0 : res->second );
+}
+
+uint64 RamJobScheduler::GetNextFreeTime( uint32 assemblyLineID ) const
+{
+    std::map< uint32, LineJobs >::const_iterator res = mLines.find( assemblyLineID );
+    if( res == mLines.end() )
+        return 0;
+
+    // the line works off its queue in order, so it is free once the last job ends
+    return *res->second.rbegin();
+}
+
+uint32 RamJobScheduler::InstallJob( RamJob& job )
+{
+    job.jobID = mNextJobID;
+
+    std::string description;
+    sDatabase.DoEscapeString( description, job.description );
+
+    std::vector< std::string > queries;
+    char buf[ 1024 ];
+
+    snprintf( buf, sizeof( buf ),
+        "INSERT INTO ramJobs"
+        " (jobID, ownerID, installerID, assemblyLineID, installedItemID, installTime, beginProductionTime, endProductionTime, description, runs, outputFlag,"
+        " completedStatusID, installedInSolarSystemID, licensedProductionRuns)"
+        " VALUES"
+        " (%u, %u, %u, %u, %u, %" PRIu64 ", %" PRIu64 ", %" PRIu64 ", '%s', %u, %d, %u, %u, %d)",
+        job.jobID, job.ownerID, job.installerID, job.assemblyLineID, job.installedItemID,
+        job.installTime, job.beginProductionTime, job.endProductionTime, description.c_str(),
+        job.runs, (int)job.outputFlag, (uint32)ramCompletedStatusInProgress, job.installedInSolarSystemID, job.licensedProductionRuns );
+    queries.push_back( buf );
+
+    const uint64 nextFreeTime = std::max( GetNextFreeTime( job.assemblyLineID ), job.endProductionTime );
+    snprintf( buf, sizeof( buf ),
+        "UPDATE ramAssemblyLines"
+        " SET nextFreeTime = %" PRIu64
+        " WHERE assemblyLineID = %u",
+        nextFreeTime, job.assemblyLineID );
+    queries.push_back( buf );
+
+    DBerror err;
+    if( !sDatabase.RunTransaction( err, queries ) )
+    {
+        _log( DATABASE__ERROR, "Failed to install job on assembly line %u: %s.", job.assemblyLineID, err.c_str() );
+        return 0;
+    }
+
+    ++mNextJobID;
+    _Insert( job );
+
+    ++mStats.installed;
+    return job.jobID;
+}
+
+bool RamJobScheduler::CompleteJob( uint32 jobID, EVERamCompletedStatus completedStatus )
+{
+    std::tr1::unordered_map< uint32, RamJob >::iterator res = mJobs.find( jobID );
+    if( res == mJobs.end() )
+        return false;
+
+    DBerror err;
+    if( !sDatabase.RunQuery( err,
+        "UPDATE ramJobs"
+        " SET completedStatusID = %u"
+        " WHERE jobID = %u",
+        (uint32)completedStatus, jobID ) )
+    {
+        _log( DATABASE__ERROR, "Failed to complete job %u (completed status = %u): %s.", jobID, (uint32)completedStatus, err.c_str() );
+        return false;
+    }
+
+    // the stored next free time of the line is left alone; installs go by the resident occupancy
+    _Erase( res->second );
+    mJobs.erase( res );
+
+    ++mStats.completed;
+    return true;
+}
+
+uint64 RamJobScheduler::GetNextFinishTime()
+{
+    _PruneFinishQueue();
+
+    if( mFinishQueue.empty() )
+        return 0;
+
+    return mFinishQueue.top().first;
+}
+
+void RamJobScheduler::PopFinishedJobs( uint64 now, std::vector< uint32 >& into )
+{
+    for( _PruneFinishQueue(); !mFinishQueue.empty() && mFinishQueue.top().first <= now; _PruneFinishQueue() )
+    {
+        into.push_back( mFinishQueue.top().second );
+        mFinishQueue.pop();
+
+        ++mStats.finished;
+    }
+}
+
+void RamJobScheduler::_Insert( const RamJob& job )
+{
+    mJobs[ job.jobID ] = job;
+    mFinishQueue.push( FinishKey( job.endProductionTime, job.jobID ) );
+    mLines[ job.assemblyLineID ].insert( job.endProductionTime );
+
+    if( ramActivityManufacturing == job.activity )
+        ++mManufacturingJobs[ job.installerID ];
+    else
+        ++mResearchJobs[ job.installerID ];
+}
+
+void RamJobScheduler::_Erase( const RamJob& job )
+{
+    // the queue is pruned lazily
+    std::map< uint32, LineJobs >::iterator line = mLines.find( job.assemblyLineID );
+    if( line != mLines.end() )
+    {
+        LineJobs::iterator end = line->second.find( job.endProductionTime );
+        if( end != line->second.end() )
+            line->second.erase( end );
+
+        if( line->second.empty() )
+            mLines.erase( line );
+    }
+
+    std::map< uint32, uint32 >& slots = ( ramActivityManufacturing == job.activity ? mManufacturingJobs : mResearchJobs );
+    std::map< uint32, uint32 >::iterator count = slots.find( job.installerID );
+    if( count != slots.end() && 0 == --count->second )
+        slots.erase( count );
+}
+
+void RamJobScheduler::_PruneFinishQueue()
+{
+    while( !mFinishQueue.empty() && mJobs.end() == mJobs.find( mFinishQueue.top().second ) )
+        mFinishQueue.pop();
+}
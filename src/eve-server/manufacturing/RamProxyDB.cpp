@@ -200,97 +200,28 @@ PyRep *RamProxyDB::AssemblyLinesGet(const uint32 containerID) {
 }
 
 bool RamProxyDB::GetAssemblyLineProperties(const uint32 assemblyLineID, double &baseMaterialMultiplier, double &baseTimeMultiplier, double &costInstall, double &costPerHour) {
-    DBQueryResult res;
-
-    if(!sDatabase.RunQuery(res,
-        "SELECT"
-        " assemblyLineType.baseMaterialMultiplier,"
-        " assemblyLineType.baseTimeMultiplier,"
-        " assemblyLine.costInstall,"
-        " assemblyLine.costPerHour"
-        " FROM ramAssemblyLines AS assemblyLine"
-        " LEFT JOIN ramAssemblyLineTypes AS assemblyLineType ON assemblyLine.assemblyLineTypeID = assemblyLineType.assemblyLineTypeID"
-        " WHERE assemblyLine.assemblyLineID = %u",
-        assemblyLineID))
-    {
-        _log(DATABASE__ERROR, "Failed to query properties for assembly line %u: %s.", assemblyLineID, res.error.c_str());
-        return false;
-    }
-
-    DBResultRow row;
-    if(!res.GetRow(row)) {
-        _log(DATABASE__ERROR, "No properties found for assembly line %u.", assemblyLineID);
+    const AssemblyLine *line = _GetAssemblyLine(assemblyLineID);
+    if(line == NULL)
         return false;
-    }
 
-    baseMaterialMultiplier = row.GetDouble(0);
-    baseTimeMultiplier = row.GetDouble(1);
-    costInstall = row.GetDouble(2);
-    costPerHour = row.GetDouble(3);
+    baseMaterialMultiplier = line->baseMaterialMultiplier;
+    baseTimeMultiplier = line->baseTimeMultiplier;
+    costInstall = line->costInstall;
+    costPerHour = line->costPerHour;
 
     return true;
 }
 
 bool RamProxyDB::GetAssemblyLineVerifyProperties(const uint32 assemblyLineID, uint32 &ownerID, double &minCharSecurity, double &maxCharSecurity, EVERamRestrictionMask &restrictionMask, EVERamActivity &activity) {
-    DBQueryResult res;
-
-    if(!sDatabase.RunQuery(res,
-        "SELECT"
-        " ownerID,"
-        " minimumCharSecurity,"
-        " maximumCharSecurity,"
-        " restrictionMask,"
-        " activityID"
-        " FROM ramAssemblyLines"
-        " WHERE assemblyLineID = %u",
-        assemblyLineID))
-    {
-        _log(DATABASE__ERROR, "Failed to query verify properties for assembly line %u: %s.", assemblyLineID, res.error.c_str());
+    const AssemblyLine *line = _GetAssemblyLine(assemblyLineID);
+    if(line == NULL)
         return false;
-    }
-
-    DBResultRow row;
-    if(!res.GetRow(row)) {
-        _log(DATABASE__ERROR, "No verify properties found for assembly line %u.", assemblyLineID);
-        return false;
-    }
 
-    ownerID = row.GetUInt(0);
-    minCharSecurity = row.GetDouble(1);
-    maxCharSecurity = row.GetDouble(2);
-    restrictionMask = (EVERamRestrictionMask)row.GetUInt(3);
-    activity = (EVERamActivity)row.GetUInt(4);
-
-    return true;
-}
-
-bool RamProxyDB::InstallJob(const uint32 ownerID, const  uint32 installerID, const uint32 assemblyLineID, const uint32 installedItemID, const uint64 beginProductionTime, const uint64 endProductionTime, const char *description, const uint32 runs, const EVEItemFlags outputFlag, const uint32 installedInSolarSystem, const int32 licensedProductionRuns) {
-    DBerror err;
-
-    // insert job
-    if(!sDatabase.RunQuery(err,
-        "INSERT INTO ramJobs"
-        " (ownerID, installerID, assemblyLineID, installedItemID, installTime, beginProductionTime, endProductionTime, description, runs, outputFlag,"
-        " completedStatusID, installedInSolarSystemID, licensedProductionRuns)"
-        " VALUES"
-        " (%u, %u, %u, %u, %" PRIu64 ", %" PRIu64 ", %" PRIu64 ", '%s', %u, %d, 0, %u, %li)",
-        ownerID, installerID, assemblyLineID, installedItemID, Win32TimeNow(), beginProductionTime, endProductionTime, description,
-        runs, (int)outputFlag, installedInSolarSystem, licensedProductionRuns))
-    {
-        _log(DATABASE__ERROR, "Failed to insert new job to database: %s.", err.c_str());
-        return false;
-    }
-
-    // update nextFreeTime
-    if(!sDatabase.RunQuery(err,
-        "UPDATE ramAssemblyLines"
-        " SET nextFreeTime = %" PRIu64
-        " WHERE assemblyLineID = %u",
-        endProductionTime, assemblyLineID))
-    {
-        _log(DATABASE__ERROR, "Failed to update next free time for assembly line %u: %s.", assemblyLineID, err.c_str());
-        return false;
-    }
+    ownerID = line->ownerID;
+    minCharSecurity = line->minCharSecurity;
+    maxCharSecurity = line->maxCharSecurity;
+    restrictionMask = line->restrictionMask;
+    activity = line->activity;
 
     return true;
 }
@@ -311,58 +242,13 @@ bool RamProxyDB::MultiplyMultipliers(const uint32 assemblyLineID, const uint32 p
     return true;
 }
 
-uint32 RamProxyDB::CountManufacturingJobs(const uint32 installerID) {
-    DBQueryResult res;
-
-    if(!sDatabase.RunQuery(res,
-        "SELECT"
-        " COUNT(job.jobID)"
-        " FROM ramJobs AS job"
-        " LEFT JOIN ramAssemblyLines AS line ON job.assemblyLineID = line.assemblyLineID"
-        " WHERE job.installerID = %u"
-        " AND job.completedStatusID = 0"
-        " AND line.activityID = 1",
-        installerID))
-    {
-        _log(DATABASE__ERROR, "Failed to count manufacturing jobs for installer %u.", installerID);
-        return 0;
-    }
-
-    DBResultRow row;
-    if(!res.GetRow(row)) {
-        _log(DATABASE__ERROR, "No rows returned while counting manufacturing jobs for installer %u.", installerID);
-        return 0;
-    }
-
-    return(row.GetUInt(0));
-}
-uint32 RamProxyDB::CountResearchJobs(const uint32 installerID) {
-    DBQueryResult res;
-
-    if(!sDatabase.RunQuery(res,
-        "SELECT"
-        " COUNT(job.jobID)"
-        " FROM ramJobs AS job"
-        " LEFT JOIN ramAssemblyLines AS line ON job.assemblyLineID = line.assemblyLineID"
-        " WHERE job.installerID = %u"
-        " AND job.completedStatusID = 0"
-        " AND line.activityID != 1",
-        installerID))
-    {
-        _log(DATABASE__ERROR, "Failed to count research jobs for installer %u.", installerID);
-        return 0;
-    }
-
-    DBResultRow row;
-    if(!res.GetRow(row)) {
-        _log(DATABASE__ERROR, "No rows returned while counting research jobs for installer %u.", installerID);
-        return 0;
+bool RamProxyDB::GetRequiredItems(const uint32 typeID, const EVERamActivity activity, std::vector<RequiredItem> &into) {
+    std::map<uint64, std::vector<RequiredItem> >::const_iterator cached = m_requiredItems.find(_Key(typeID, activity));
+    if(cached != m_requiredItems.end()) {
+        into.insert(into.end(), cached->second.begin(), cached->second.end());
+        return true;
     }
 
-    return(row.GetUInt(0));
-}
-
-bool RamProxyDB::GetRequiredItems(const uint32 typeID, const EVERamActivity activity, std::vector<RequiredItem> &into) {
     DBQueryResult res;
 
     if(!sDatabase.RunQuery(res,
@@ -384,40 +270,13 @@ bool RamProxyDB::GetRequiredItems(const uint32 typeID, const EVERamActivity acti
         return false;
     }
 
-    DBResultRow row;
-    while(res.GetRow(row))
-        into.push_back(RequiredItem(row.GetUInt(0), row.GetUInt(1), row.GetFloat(2), row.GetInt(3) ? true : false));
-
-    return true;
-}
-
-bool RamProxyDB::GetJobProperties(const uint32 jobID, uint32 &installedItemID, uint32 &ownerID, EVEItemFlags &outputFlag, uint32 &runs, uint32 &licensedProductionRuns, EVERamActivity &activity) {
-    DBQueryResult res;
-
-    if(!sDatabase.RunQuery(res,
-        "SELECT job.installedItemID, job.ownerID, job.outputFlag, job.runs, job.licensedProductionRuns, assemblyLine.activityID"
-        " FROM ramJobs AS job"
-        " LEFT JOIN ramAssemblyLines AS assemblyLine ON job.assemblyLineID = assemblyLine.assemblyLineID"
-        " WHERE job.jobID = %u",
-        jobID))
-    {
-        _log(DATABASE__ERROR, "Failed to query properties of job %u: %s.", jobID, res.error.c_str());
-        return false;
-    }
+    std::vector<RequiredItem> &items = m_requiredItems[_Key(typeID, activity)];
 
     DBResultRow row;
-    if(!res.GetRow(row)) {
-        _log(DATABASE__ERROR, "No properties found for job %u.", jobID);
-        return false;
-    }
-
-    installedItemID = row.GetUInt(0);
-    ownerID = row.GetUInt(1);
-    outputFlag = (EVEItemFlags)row.GetUInt(2);
-    runs = row.GetUInt(3);
-    licensedProductionRuns = row.GetUInt(4);
-    activity = (EVERamActivity)row.GetUInt(5);
+    while(res.GetRow(row))
+        items.push_back(RequiredItem(row.GetUInt(0), row.GetUInt(1), row.GetFloat(2), row.GetInt(3) ? true : false));
 
+    into.insert(into.end(), items.begin(), items.end());
     return true;
 }
 
@@ -449,22 +308,6 @@ bool RamProxyDB::GetJobVerifyProperties(const uint32 jobID, uint32 &ownerID, uin
     return true;
 }
 
-bool RamProxyDB::CompleteJob(const uint32 jobID, const EVERamCompletedStatus completedStatus) {
-    DBerror err;
-
-    if(!sDatabase.RunQuery(err,
-        "UPDATE ramJobs"
-        " SET completedStatusID = %u"
-        " WHERE jobID = %u",
-        (uint32)completedStatus, jobID))
-    {
-        _log(DATABASE__ERROR, "Failed to complete job %u (completed status = %u): %s.", jobID, (uint32)completedStatus, err.c_str());
-        return false;
-    }
-
-    return true;
-}
-
 std::string RamProxyDB::GetStationName(const uint32 stationID) {
     DBQueryResult res;
 
@@ -509,52 +352,98 @@ uint32 RamProxyDB::GetTech2Blueprint(const uint32 blueprintTypeID) {
     return(row.GetUInt(0));
 }
 
-uint64 RamProxyDB::GetNextFreeTime(const uint32 assemblyLineID) {
+uint32 RamProxyDB::GetRegionOfContainer(const uint32 containerID) {
+    std::map<uint32, uint32>::const_iterator cached = m_containerRegions.find(containerID);
+    if(cached != m_containerRegions.end())
+        return(cached->second);
+
     DBQueryResult res;
 
     if(!sDatabase.RunQuery(res,
-        "SELECT"
-        " nextFreeTime"
-        " FROM ramAssemblyLines"
-        " WHERE assemblyLineID = %u",
-        assemblyLineID))
+                "SELECT regionID"
+                " FROM ramAssemblyLineStations"
+                " WHERE stationID = %u",
+                containerID))
     {
-        _log(DATABASE__ERROR, "Failed to query next free time for assembly line %u: %s.", assemblyLineID, res.error.c_str());
+        _log(DATABASE__ERROR, "Unable to query region for container %u: %s", containerID, res.error.c_str());
         return 0;
     }
 
     DBResultRow row;
     if(!res.GetRow(row)) {
-        _log(DATABASE__ERROR, "Assembly line %u not found.", assemblyLineID);
+        _log(DATABASE__ERROR, "No region found for container %u.", containerID);
         return 0;
-    } else
-        return(row.GetUInt64(0));
+    }
+
+    return(m_containerRegions[containerID] = row.GetUInt(0));
 }
 
-uint32 RamProxyDB::GetRegionOfContainer(const uint32 containerID) {
+const RamProxyDB::AssemblyLine *RamProxyDB::_GetAssemblyLine(const uint32 assemblyLineID) {
+    std::map<uint32, AssemblyLine>::const_iterator cached = m_assemblyLines.find(assemblyLineID);
+    if(cached != m_assemblyLines.end())
+        return(&cached->second);
+
     DBQueryResult res;
 
     if(!sDatabase.RunQuery(res,
-                "SELECT regionID"
-                " FROM ramAssemblyLineStations"
-                " WHERE stationID = %u",
-                containerID))
+        "SELECT"
+        " assemblyLineType.baseMaterialMultiplier,"
+        " assemblyLineType.baseTimeMultiplier,"
+        " assemblyLine.costInstall,"
+        " assemblyLine.costPerHour,"
+        " assemblyLine.ownerID,"
+        " assemblyLine.minimumCharSecurity,"
+        " assemblyLine.maximumCharSecurity,"
+        " assemblyLine.restrictionMask,"
+        " assemblyLine.activityID"
+        " FROM ramAssemblyLines AS assemblyLine"
+        " LEFT JOIN ramAssemblyLineTypes AS assemblyLineType ON assemblyLine.assemblyLineTypeID = assemblyLineType.assemblyLineTypeID"
+        " WHERE assemblyLine.assemblyLineID = %u",
+        assemblyLineID))
     {
-        _log(DATABASE__ERROR, "Unable to query region for container %u: %s", containerID, res.error.c_str());
-        return 0;
+        _log(DATABASE__ERROR, "Failed to query properties for assembly line %u: %s.", assemblyLineID, res.error.c_str());
+        return NULL;
     }
 
     DBResultRow row;
     if(!res.GetRow(row)) {
-        _log(DATABASE__ERROR, "No region found for container %u.", containerID);
-        return 0;
+        _log(DATABASE__ERROR, "No properties found for assembly line %u.", assemblyLineID);
+        return NULL;
     }
 
-    return(row.GetUInt(0));
+    AssemblyLine &line = m_assemblyLines[assemblyLineID];
+    line.baseMaterialMultiplier = row.GetDouble(0);
+    line.baseTimeMultiplier = row.GetDouble(1);
+    line.costInstall = row.GetDouble(2);
+    line.costPerHour = row.GetDouble(3);
+    line.ownerID = row.GetUInt(4);
+    line.minCharSecurity = row.GetDouble(5);
+    line.maxCharSecurity = row.GetDouble(6);
+    line.restrictionMask = (EVERamRestrictionMask)row.GetUInt(7);
+    line.activity = (EVERamActivity)row.GetUInt(8);
 
+    return(&line);
 }
 
 bool RamProxyDB::_GetMultipliers(const uint32 assemblyLineID, uint32 groupID, double &materialMultiplier, double &timeMultiplier) {
+    std::map<uint64, Multipliers>::const_iterator cached = m_multipliers.find(_Key(assemblyLineID, groupID));
+    if(cached == m_multipliers.end()) {
+        Multipliers multipliers;
+        if(!_QueryMultipliers(assemblyLineID, groupID, multipliers))
+            return false;   // not cached, so it's queried again next time
+
+        cached = m_multipliers.insert(std::make_pair(_Key(assemblyLineID, groupID), multipliers)).first;
+    }
+
+    if(!cached->second.producable)
+        return false;
+
+    materialMultiplier = cached->second.materialMultiplier;
+    timeMultiplier = cached->second.timeMultiplier;
+    return true;
+}
+
+bool RamProxyDB::_QueryMultipliers(const uint32 assemblyLineID, uint32 groupID, Multipliers &into) {
     DBQueryResult res;
 
     // check table ramAssemblyLineTypeDetailPerGroup first
@@ -572,8 +461,9 @@ bool RamProxyDB::_GetMultipliers(const uint32 assemblyLineID, uint32 groupID, do
 
     DBResultRow row;
     if(res.GetRow(row)) {
-        materialMultiplier = row.GetDouble(0);
-        timeMultiplier = row.GetDouble(1);
+        into.producable = true;
+        into.materialMultiplier = row.GetDouble(0);
+        into.timeMultiplier = row.GetDouble(1);
         return true;
     }
 
@@ -592,11 +482,15 @@ bool RamProxyDB::_GetMultipliers(const uint32 assemblyLineID, uint32 groupID, do
     }
 
     if(res.GetRow(row)) {
-        materialMultiplier = row.GetDouble(0);
-        timeMultiplier = row.GetDouble(1);
-        return true;
+        into.producable = true;
+        into.materialMultiplier = row.GetDouble(0);
+        into.timeMultiplier = row.GetDouble(1);
     } else {
-        return false;
+        into.producable = false;
+        into.materialMultiplier = 1.0;
+        into.timeMultiplier = 1.0;
     }
+
+    return true;
 }
 
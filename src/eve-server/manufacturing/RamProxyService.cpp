@@ -25,6 +25,7 @@
 
 #include "eve-server.h"
 
+#include "EntityList.h"
 #include "PyServiceCD.h"
 #include "manufacturing/Blueprint.h"
 #include "manufacturing/RamProxyService.h"
@@ -33,7 +34,8 @@ PyCallable_Make_InnerDispatcher(RamProxyService)
 
 RamProxyService::RamProxyService(PyServiceMgr *mgr)
 : PyService(mgr, "ramProxy"),
-  m_dispatch(new Dispatcher(this))
+  m_dispatch(new Dispatcher(this)),
+  m_jobFinish(*this)
 {
     _SetCallDispatcher(m_dispatch);
 
@@ -44,6 +46,8 @@ RamProxyService::RamProxyService(PyServiceMgr *mgr)
     PyCallable_REG_CALL(RamProxyService, CompleteJob);
     PyCallable_REG_CALL(RamProxyService, GetRelevantCharSkills);
     PyCallable_REG_CALL(RamProxyService, AssemblyLinesSelectPublic);
+
+    _ScheduleJobFinish();
 }
 
 RamProxyService::~RamProxyService() {
@@ -52,14 +56,14 @@ RamProxyService::~RamProxyService() {
 
 PyResult RamProxyService::Handle_AssemblyLinesSelectPublic(PyCallArgs &call) {
 
-    sLog.Debug("Server", "Called AsemblyLinesSelectPublic Stub.");
+    _debug("Server", "Called AsemblyLinesSelectPublic Stub.");
 
     return new PyList;
 }
 
 PyResult RamProxyService::Handle_GetRelevantCharSkills(PyCallArgs &call) {
 
-    sLog.Debug("Server", "Called GetRelevantCharSkills Stub.");
+    _debug("Server", "Called GetRelevantCharSkills Stub.");
 
     return NULL;
 }
@@ -175,25 +179,30 @@ PyResult RamProxyService::Handle_InstallJob(PyCallArgs &call) {
 
         // calculate proper start time
         uint64 beginProductionTime = Win32TimeNow();
-        if(beginProductionTime < (uint32)rsp.maxJobStartTime)
+        if(beginProductionTime < (uint64)rsp.maxJobStartTime)
             beginProductionTime = rsp.maxJobStartTime;
 
         // register our job
-        if( !m_db.InstallJob(
-            args.isCorpJob ? call.client->GetCorporationID() : call.client->GetCharacterID(),
-            call.client->GetCharacterID(),
-            args.installationAssemblyLineID,
-            installedItem->itemID(),
-            beginProductionTime,
-            beginProductionTime + uint64(rsp.productionTime) * Win32Time_Second,
-            args.description.c_str(),
-            args.runs,
-            (EVEItemFlags)args.flagOutput,
-            pathBomLocation.locationID,
-            args.licensedProductionRuns ) )
-        {
+        RamJob job;
+        job.ownerID = args.isCorpJob ? call.client->GetCorporationID() : call.client->GetCharacterID();
+        job.installerID = call.client->GetCharacterID();
+        job.assemblyLineID = args.installationAssemblyLineID;
+        job.installedItemID = installedItem->itemID();
+        job.installTime = Win32TimeNow();
+        job.beginProductionTime = beginProductionTime;
+        job.endProductionTime = beginProductionTime + uint64(rsp.productionTime) * Win32Time_Second;
+        job.description = args.description;
+        job.runs = args.runs;
+        job.outputFlag = (EVEItemFlags)args.flagOutput;
+        job.installedInSolarSystemID = pathBomLocation.locationID;
+        job.licensedProductionRuns = args.licensedProductionRuns;
+        job.activity = (EVERamActivity)args.activityID;
+
+        if(sRamJobScheduler.InstallJob(job) == 0)
             return NULL;
-        }
+
+        // it may finish before any other job
+        _ScheduleJobFinish();
 
         // do some activity-specific actions
         switch(args.activityID) {
@@ -256,13 +265,18 @@ PyResult RamProxyService::Handle_CompleteJob(PyCallArgs &call) {
 
     _VerifyCompleteJob(args, call.client);
 
-    // hundreds of variables to allocate ... maybe we can make struct for GetJobProperties and InstallJob?
-    uint32 installedItemID, ownerID, runs, licensedProductionRuns;
-    EVEItemFlags outputFlag;
-    EVERamActivity activity;
-    if(!m_db.GetJobProperties(args.jobID, installedItemID, ownerID, outputFlag, runs, licensedProductionRuns, activity))
+    // _VerifyCompleteJob made sure the job is in progress
+    const RamJob *job = sRamJobScheduler.GetJob(args.jobID);
+    if(job == NULL)
         return NULL;
 
+    const uint32 installedItemID = job->installedItemID;
+    const uint32 ownerID = job->ownerID;
+    const uint32 runs = job->runs;
+    const uint32 licensedProductionRuns = job->licensedProductionRuns;
+    const EVEItemFlags outputFlag = job->outputFlag;
+    const EVERamActivity activity = job->activity;
+
     // return item
     InventoryItemRef installedItem = m_manager->item_factory.GetItem( installedItemID );
     if( !installedItem )
@@ -378,7 +392,7 @@ PyResult RamProxyService::Handle_CompleteJob(PyCallArgs &call) {
     }
 
     // regardless on success of this, we will return NULL, so there's no condition here
-    m_db.CompleteJob(args.jobID, args.cancel ? ramCompletedStatusAbort : ramCompletedStatusDelivered);
+    sRamJobScheduler.CompleteJob(args.jobID, args.cancel ? ramCompletedStatusAbort : ramCompletedStatusDelivered);
 
     return NULL;
 }
@@ -480,7 +494,7 @@ void RamProxyService::_VerifyInstallJob_Call(const Call_InstallJob &args, Invent
     // JOBS CHECK
     // ***********
     if(args.activityID == ramActivityManufacturing) {
-        uint32 jobCount = m_db.CountManufacturingJobs(c->GetCharacterID());
+        uint32 jobCount = sRamJobScheduler.CountManufacturingJobs(c->GetCharacterID());
         if(c->GetChar()->GetAttribute(AttrManufactureSlotLimit).get_int() <= jobCount) {
             std::map<std::string, PyRep *> exceptArgs;
             exceptArgs["current"] = new PyInt(jobCount);
@@ -488,7 +502,7 @@ void RamProxyService::_VerifyInstallJob_Call(const Call_InstallJob &args, Invent
             throw(PyException(MakeUserError("MaxFactorySlotUsageReached", exceptArgs)));
         }
     } else {
-        uint32 jobCount = m_db.CountResearchJobs(c->GetCharacterID());
+        uint32 jobCount = sRamJobScheduler.CountResearchJobs(c->GetCharacterID());
         if(c->GetChar()->GetAttribute(AttrMaxLaborotorySlots).get_int() <= jobCount) {
             std::map<std::string, PyRep *> exceptArgs;
             exceptArgs["current"] = new PyInt(jobCount);
@@ -525,8 +539,8 @@ void RamProxyService::_VerifyInstallJob_Call(const Call_InstallJob &args, Invent
     if(!m_db.GetAssemblyLineVerifyProperties(args.installationAssemblyLineID, ownerID, minCharSec, maxCharSec, restrictionMask, activity))
         throw(PyException(MakeUserError("RamInstallationHasNoDefaultContent")));
 
-    // check validity of activity
-    if(activity < ramActivityManufacturing || activity > ramActivityInvention)
+    // check validity of activity; the job keeps the activity of its line
+    if(activity < ramActivityManufacturing || activity > ramActivityInvention || activity != args.activityID)
         throw(PyException(MakeUserError("RamAssemblyLineHasNoActivity")));
 
     // check security rating if required
@@ -749,9 +763,17 @@ void RamProxyService::_VerifyCompleteJob(const Call_CompleteJob &args, Client *c
     uint32 ownerID;
     uint64 endProductionTime;
     EVERamCompletedStatus status;
-    EVERamRestrictionMask restrictionMask;
-    if(!m_db.GetJobVerifyProperties(args.jobID, ownerID, endProductionTime, restrictionMask, status))
-        throw(PyException(MakeUserError("RamCompletionNoSuchJob")));
+    const RamJob *job = sRamJobScheduler.GetJob(args.jobID);
+    if(job != NULL) {
+        ownerID = job->ownerID;
+        endProductionTime = job->endProductionTime;
+        status = ramCompletedStatusInProgress;
+    } else {
+        // not in progress; only the database knows whether it exists at all
+        EVERamRestrictionMask restrictionMask;
+        if(!m_db.GetJobVerifyProperties(args.jobID, ownerID, endProductionTime, restrictionMask, status))
+            throw(PyException(MakeUserError("RamCompletionNoSuchJob")));
+    }
 
     if(ownerID != c->GetCharacterID()) {
         if(ownerID == c->GetCorporationID()) {
@@ -862,7 +884,7 @@ bool RamProxyService::_Calculate(const Call_InstallJob &args, InventoryItemRef i
     // I "hope" this is right, simple tells client how soon will his job be started
     // Unfortunately, rounding done on client's side causes showing "Start time: 0 seconds" when he has to wait less than minute
     // I have no idea how to avoid this ...
-    into.maxJobStartTime = m_db.GetNextFreeTime(args.installationAssemblyLineID);
+    into.maxJobStartTime = sRamJobScheduler.GetNextFreeTime(args.installationAssemblyLineID);
 
     return true;
 }
@@ -958,3 +980,38 @@ void RamProxyService::_GetBOMItems(const PathElement &bomLocation, std::vector<I
         inventory->FindByFlag( (EVEItemFlags)bomLocation.flag, into );
 }
 
+
+void RamProxyService::_FinishJobs()
+{
+    std::vector<uint32> finished;
+    sRamJobScheduler.PopFinishedJobs(Win32TimeNow(), finished);
+
+    std::vector<uint32>::const_iterator cur, end;
+    cur = finished.begin();
+    end = finished.end();
+    for(; cur != end; cur++) {
+        const RamJob *job = sRamJobScheduler.GetJob(*cur);
+        if(job == NULL)
+            continue;
+
+        // the job stays in progress until the installer delivers it
+        Client *installer = m_manager->entity_list.FindCharacter(job->installerID);
+        if(installer != NULL)
+            installer->SendNotifyMsg("Your job \"%s\" has finished and is ready for delivery.", job->description.c_str());
+    }
+
+    _ScheduleJobFinish();
+}
+
+void RamProxyService::_ScheduleJobFinish()
+{
+    const uint64 next = sRamJobScheduler.GetNextFinishTime();
+    if(next == 0) {
+        sTimerWheel.Cancel(&m_jobFinish);
+        return;
+    }
+
+    const uint64 now = Win32TimeNow();
+    const uint64 delay = ( next > now ? ( next - now ) / ( Win32Time_Second / 1000 ) : 0 );
+    sTimerWheel.Schedule(&m_jobFinish, (uint32)std::min<uint64>(delay, 0xFFFFFFFF));
+}
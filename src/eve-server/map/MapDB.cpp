@@ -87,21 +87,21 @@ PyObject *MapDB::GetStationServiceInfo() {
     return DBResultToRowset(res);
 }
 
-PyObject *MapDB::GetStationCount() {
+PyDict *MapDB::GetStationCount() {
     DBQueryResult res;
 
     if(!sDatabase.RunQuery(res,
-        " SELECT "
-        "    stationID "
-        " FROM staStations "
-        " WHERE solarSystemID "
+        "SELECT "
+        "    solarSystemID, COUNT(stationID)"
+        " FROM staStations"
+        " GROUP BY solarSystemID"
         ))
     {
         codelog(SERVICE__ERROR, "Error in query: %s", res.error.c_str());
         return NULL;
     }
 
-    return DBResultToRowset(res);
+    return DBResultToIntIntDict(res);
 }
 
 
@@ -28,6 +28,8 @@
 #include "PyServiceCD.h"
 #include "cache/ObjCacheService.h"
 #include "map/MapService.h"
+#include "map/MapStatistics.h"
+#include "map/RouteMap.h"
 
 PyCallable_Make_InnerDispatcher(MapService)
 
@@ -43,6 +45,9 @@ MapService::MapService(PyServiceMgr *mgr)
     PyCallable_REG_CALL(MapService, GetHistory)
     PyCallable_REG_CALL(MapService, GetIncursionGlobalReport)
     PyCallable_REG_CALL(MapService, GetStationCount)
+    PyCallable_REG_CALL(MapService, GetJumpCount)
+    PyCallable_REG_CALL(MapService, GetRoute)
+    PyCallable_REG_CALL(MapService, GetPilotCounts)
 }
 
 MapService::~MapService() {
@@ -128,22 +133,121 @@ PyResult MapService::Handle_GetStuckSystems(PyCallArgs &call) {
 }
 
 PyResult MapService::Handle_GetHistory(PyCallArgs &call) {
+    //statType, hours
+    Call_TwoIntegerArgs args;
+    if(!args.Decode(&call.tuple)) {
+        codelog(SERVICE__ERROR, "%s: Bad arguments", call.client->GetName());
+        return NULL;
+    }
 
-    sLog.Debug("Server", "Called GetHistory Stub.");
+    std::string method_name("GetHistory_");
+    method_name += itoa(args.arg1);
+    method_name += "_";
+    method_name += itoa(args.arg2);
 
-    return NULL;
+    ObjectCachedMethodID method_id(GetName(), method_name.c_str());
+
+    //the statistics are counted in memory; the cache is refreshed once per published snapshot
+    if(!_IsSnapshotCached(method_name)) {
+        PyRep *result = sMapStatistics.GetHistory(args.arg1, args.arg2);
+        if(result == NULL) {
+            codelog(SERVICE__ERROR, "%s: Unknown history statistic %d", call.client->GetName(), args.arg1);
+            return NULL;
+        }
+
+        m_manager->cache_service->GiveCache(method_id, &result);
+        m_snapshotVersions[method_name] = sMapStatistics.version();
+    }
+
+    return m_manager->cache_service->MakeObjectCachedMethodCallResult(method_id);
 }
 
 PyResult MapService::Handle_GetIncursionGlobalReport(PyCallArgs &call) {
 
-    sLog.Debug("Server", "Called GetIncursionGlobalReport Stub.");
+    _debug("Server", "Called GetIncursionGlobalReport Stub.");
 
     return NULL;
 }
 
 PyResult MapService::Handle_GetStationCount(PyCallArgs &call) {
+    PyRep *result = NULL;
+
+    ObjectCachedMethodID method_id(GetName(), "GetStationCount");
+
+    //check to see if this method is in the cache already.
+    if(!m_manager->cache_service->IsCacheLoaded(method_id)) {
+        //this method is not in cache yet, load up the contents and cache it.
+        result = m_db.GetStationCount();
+        if(result == NULL)
+            result = new PyDict();
+        m_manager->cache_service->GiveCache(method_id, &result);
+    }
+
+    return m_manager->cache_service->MakeObjectCachedMethodCallResult(method_id);
+}
+
+/* emulator calls, answered from the resident stargate graph */
+PyResult MapService::Handle_GetJumpCount(PyCallArgs &call) {
+    Call_TwoIntegerArgs args;
+    if(!args.Decode(&call.tuple)) {
+        codelog(SERVICE__ERROR, "%s: Bad arguments", call.client->GetName());
+        return NULL;
+    }
+
+    return new PyInt(sRouteMap.GetJumps(args.arg1, args.arg2));
+}
+
+PyResult MapService::Handle_GetRoute(PyCallArgs &call) {
+    //fromSystemID, toSystemID[, routeType]
+    const PyTuple *tuple = call.tuple;
+    if(tuple->size() < 2 || tuple->size() > 3
+       || !tuple->GetItem(0)->IsInt() || !tuple->GetItem(1)->IsInt()
+       || (tuple->size() == 3 && !tuple->GetItem(2)->IsInt()))
+    {
+        codelog(SERVICE__ERROR, "%s: Bad arguments", call.client->GetName());
+        return NULL;
+    }
+
+    int32 type = RouteMap::ROUTE_SHORTEST;
+    if(tuple->size() == 3)
+        type = tuple->GetItem(2)->AsInt()->value();
+    if(type < 0 || type >= RouteMap::ROUTE_TYPE_COUNT) {
+        codelog(SERVICE__ERROR, "%s: Invalid route type %d", call.client->GetName(), type);
+        return NULL;
+    }
+
+    std::vector<uint32> route;
+    sRouteMap.GetRoute(tuple->GetItem(0)->AsInt()->value(), tuple->GetItem(1)->AsInt()->value(), (RouteMap::RouteType)type, route);
+
+    //an empty list if there is no route
+    PyList *result = new PyList();
+    std::vector<uint32>::const_iterator cur, end;
+    cur = route.begin();
+    end = route.end();
+    for(; cur != end; cur++)
+        result->AddItem(new PyInt(*cur));
+
+    return result;
+}
+
+PyResult MapService::Handle_GetPilotCounts(PyCallArgs &call) {
+    const std::string method_name("GetPilotCounts");
+    ObjectCachedMethodID method_id(GetName(), method_name.c_str());
+
+    if(!_IsSnapshotCached(method_name)) {
+        PyRep *result = sMapStatistics.GetPilotCounts();
+        m_manager->cache_service->GiveCache(method_id, &result);
+        m_snapshotVersions[method_name] = sMapStatistics.version();
+    }
+
+    return m_manager->cache_service->MakeObjectCachedMethodCallResult(method_id);
+}
 
-    sLog.Debug("Server", "Called GetStationCount stub.");
+bool MapService::_IsSnapshotCached(const std::string &method) {
+    std::map<std::string, uint32>::const_iterator res = m_snapshotVersions.find(method);
+    if(res == m_snapshotVersions.end() || res->second != sMapStatistics.version())
+        return false;
 
-    return new PyDict;
+    ObjectCachedMethodID method_id(GetName(), method.c_str());
+    return m_manager->cache_service->IsCacheLoaded(method_id);
 }
@@ -0,0 +1,249 @@
+/*
+    ------------------------------------------------------------------------------------
+    LICENSE:
+    ------------------------------------------------------------------------------------
+    This file is part of EVEmu: EVE Online Server Emulator
+    Copyright 2006 - 2011 The EVEmu Team
+    For the latest information visit http://evemu.org
+    ------------------------------------------------------------------------------------
+    This program is free software; you can redistribute it and/or modify it under
+    the terms of the GNU Lesser General Public License as published by the Free Software
+    Foundation; either version 2 of the License, or (at your option) any later
+    version.
+
+    This program is distributed in the hope that it will be useful, but WITHOUT
+    ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+    FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public License along with
+    this program; if not, write to the Free Software Foundation, Inc., 59 Temple
+    Place - Suite 330, Boston, MA 02111-1307, USA, or go to
+    http://www.gnu.org/copyleft/lesser.txt.
+    ------------------------------------------------------------------------------------
+    Author:     EVEmu Team
+*/
+
+
+#include "eve-server.h"
+
+#include "Client.h"
+#include "EntityList.h"
+#include "map/MapStatistics.h"
+
+const uint32 MapStatistics::SNAPSHOT_INTERVAL;
+const uint32 MapStatistics::BUCKET_INTERVAL;
+const size_t MapStatistics::HISTORY_HOURS;
+
+MapStatistics::MapStatistics()
+: mBuckets( 1 ),
+  mStarted( false ),
+  mBucketStart( 0 ),
+  mPublishTime( 0 ),
+  mVersion( 0 ),
+  mBuiltPilots( NULL )
+{
+}
+
+MapStatistics::~MapStatistics()
+{
+    _ClearBuilt();
+}
+
+void MapStatistics::AddJump( uint32 solarSystemID )
+{
+    ++mBuckets.front()[ solarSystemID ].jumps;
+    ++mStats.jumps;
+}
+
+void MapStatistics::AddKill( uint32 solarSystemID, KillKind kind )
+{
+    Counters& counters = mBuckets.front()[ solarSystemID ];
+    switch( kind )
+    {
+        case KILL_SHIP: ++counters.shipKills; break;
+        case KILL_POD:  ++counters.podKills;  break;
+        case KILL_NPC:  ++counters.npcKills;  break;
+    }
+
+    ++mStats.kills;
+}
+
+PyRep* MapStatistics::GetHistory( uint32 stat, uint32 hours )
+{
+    if( HISTORY_JUMPS != stat && HISTORY_KILLS != stat && HISTORY_FACWAR_KILLS != stat )
+        return NULL;
+
+    hours = std::max< uint32 >( 1, std::min< uint32 >( hours, HISTORY_HOURS ) );
+
+    const uint64 key = ( (uint64)stat << 32 ) | hours;
+    std::map< uint64, PyRep* >::iterator res = mBuilt.find( key );
+    if( mBuilt.end() != res )
+    {
+        PyIncRef( res->second );
+        return res->second;
+    }
+
+    // sum up the buckets of the hours
+    std::map< uint32, Counters > sums;
+    if( HISTORY_FACWAR_KILLS != stat )
+    {
+        std::list< CounterMap >::const_iterator cur, end;
+        cur = mPublished.begin();
+        end = mPublished.end();
+        for( uint32 i = 0; cur != end && i < hours; ++cur, ++i )
+        {
+            CounterMap::const_iterator curs, ends;
+            curs = cur->begin();
+            ends = cur->end();
+            for(; curs != ends; ++curs )
+            {
+                Counters& sum = sums[ curs->first ];
+                sum.jumps += curs->second.jumps;
+                sum.shipKills += curs->second.shipKills;
+                sum.podKills += curs->second.podKills;
+                sum.npcKills += curs->second.npcKills;
+            }
+        }
+    }
+
+    DBRowDescriptor* header = new DBRowDescriptor();
+    header->AddColumn( "solarSystemID", DBTYPE_I4 );
+    header->AddColumn( "value1",        DBTYPE_I4 );
+    header->AddColumn( "value2",        DBTYPE_I4 );
+    header->AddColumn( "value3",        DBTYPE_I4 );
+
+    CRowSet* rowset = new CRowSet( &header );
+
+    std::map< uint32, Counters >::const_iterator cur, end;
+    cur = sums.begin();
+    end = sums.end();
+    for(; cur != end; ++cur )
+    {
+        const Counters& sum = cur->second;
+        if( HISTORY_JUMPS == stat ? 0 == sum.jumps : 0 == sum.shipKills + sum.npcKills + sum.podKills )
+            continue;
+
+        PyPackedRow* row = rowset->NewRow();
+        row->SetField( (uint32)0, new PyInt( cur->first ) );
+        if( HISTORY_JUMPS == stat )
+        {
+            row->SetField( 1, new PyInt( sum.jumps ) );
+            row->SetField( 2, new PyInt( 0 ) );
+            row->SetField( 3, new PyInt( 0 ) );
+        }
+        else
+        {
+            row->SetField( 1, new PyInt( sum.shipKills ) );
+            row->SetField( 2, new PyInt( sum.npcKills ) );
+            row->SetField( 3, new PyInt( sum.podKills ) );
+        }
+    }
+
+    ++mStats.builds;
+
+    mBuilt[ key ] = rowset;
+    PyIncRef( rowset );
+    return rowset;
+}
+
+PyRep* MapStatistics::GetPilotCounts()
+{
+    if( NULL == mBuiltPilots )
+    {
+        DBRowDescriptor* header = new DBRowDescriptor();
+        header->AddColumn( "solarSystemID", DBTYPE_I4 );
+        header->AddColumn( "pilotsInSpace", DBTYPE_I4 );
+        header->AddColumn( "pilotsDocked",  DBTYPE_I4 );
+
+        CRowSet* rowset = new CRowSet( &header );
+
+        std::map< uint32, std::pair< uint32, uint32 > >::const_iterator cur, end;
+        cur = mPilots.begin();
+        end = mPilots.end();
+        for(; cur != end; ++cur )
+        {
+            PyPackedRow* row = rowset->NewRow();
+            row->SetField( (uint32)0, new PyInt( cur->first ) );
+            row->SetField( 1, new PyInt( cur->second.first ) );
+            row->SetField( 2, new PyInt( cur->second.second ) );
+        }
+
+        ++mStats.builds;
+        mBuiltPilots = rowset;
+    }
+
+    PyIncRef( mBuiltPilots );
+    return mBuiltPilots;
+}
+
+void MapStatistics::Process( uint32 now )
+{
+    if( !mStarted )
+    {
+        mStarted = true;
+        mBucketStart = now;
+
+        _Publish();
+        mPublishTime = now;
+        return;
+    }
+
+    while( BUCKET_INTERVAL <= now - mBucketStart )
+    {
+        mBuckets.push_front( CounterMap() );
+        if( HISTORY_HOURS < mBuckets.size() )
+            mBuckets.pop_back();
+
+        mBucketStart += BUCKET_INTERVAL;
+    }
+
+    if( SNAPSHOT_INTERVAL <= now - mPublishTime )
+    {
+        _Publish();
+        mPublishTime = now;
+    }
+}
+
+void MapStatistics::_Publish()
+{
+    mPublished = mBuckets;
+
+    mPilots.clear();
+
+    std::vector< Client* > clients;
+    sEntityList.GetClients( clients );
+
+    std::vector< Client* >::const_iterator cur, end;
+    cur = clients.begin();
+    end = clients.end();
+    for(; cur != end; ++cur )
+    {
+        const uint32 solarSystemID = (*cur)->GetSystemID();
+        if( 0 == solarSystemID )
+            continue;
+
+        std::pair< uint32, uint32 >& pilots = mPilots[ solarSystemID ];
+        if( (*cur)->IsInSpace() )
+            ++pilots.first;
+        else
+            ++pilots.second;
+    }
+
+    _ClearBuilt();
+
+    ++mVersion;
+    ++mStats.snapshots;
+}
+
+void MapStatistics::_ClearBuilt()
+{
+    std::map< uint64, PyRep* >::iterator cur, end;
+    cur = mBuilt.begin();
+    end = mBuilt.end();
+    for(; cur != end; ++cur )
+        PyDecRef( cur->second );
+    mBuilt.clear();
+
+    PySafeDecRef( mBuiltPilots );
+    mBuiltPilots = NULL;
+}
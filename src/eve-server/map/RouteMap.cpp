@@ -0,0 +1,341 @@
+/*
+    ------------------------------------------------------------------------------------
+    LICENSE:
+    ------------------------------------------------------------------------------------
+    This file is part of EVEmu: EVE Online Server Emulator
+    Copyright 2006 - 2011 The EVEmu Team
+    For the latest information visit http://evemu.org
+    ------------------------------------------------------------------------------------
+    This program is free software; you can redistribute it and/or modify it under
+    the terms of the GNU Lesser General Public License as published by the Free Software
+    Foundation; either version 2 of the License, or (at your option) any later
+    version.
+
+    This program is distributed in the hope that it will be useful, but WITHOUT
+    ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+    FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public License along with
+    this program; if not, write to the Free Software Foundation, Inc., 59 Temple
+    Place - Suite 330, Boston, MA 02111-1307, USA, or go to
+    http://www.gnu.org/copyleft/lesser.txt.
+    ------------------------------------------------------------------------------------
+    Author:     EVEmu Team
+*/
+
+
+#include "eve-server.h"
+
+#include "map/RouteMap.h"
+
+const double RouteMap::HIGH_SECURITY = 0.45;
+const size_t RouteMap::ROUTE_CACHE_SIZE;
+const uint8 RouteMap::UNREACHABLE;
+const uint32 RouteMap::AVOID_COST;
+
+RouteMap::RouteMap()
+: mMaxJumpLength( 0.0 )
+{
+}
+
+bool RouteMap::Load()
+{
+    mSystemIDs.clear();
+    mIndices.clear();
+    mSecurity.clear();
+    mPositions.clear();
+    mRegionOf.clear();
+    mRegionSlot.clear();
+    mOffsets.clear();
+    mNeighbors.clear();
+    mMaxJumpLength = 0.0;
+    mRegions.clear();
+    mRoutes.clear();
+    mRouteIndex.clear();
+
+    DBQueryResult res;
+    DBResultRow row;
+
+    if( !sDatabase.RunQuery( res,
+        "SELECT solarSystemID, regionID, security, x, y, z"
+        " FROM mapSolarSystems"
+        " ORDER BY regionID, solarSystemID" ) )
+    {
+        codelog( SERVICE__ERROR, "Error in query: %s", res.error.c_str() );
+        return false;
+    }
+
+    std::map< uint32, uint32 > regions;
+    while( res.GetRow( row ) )
+    {
+        const uint32 index = mSystemIDs.size();
+        mSystemIDs.push_back( row.GetUInt( 0 ) );
+        mIndices[ row.GetUInt( 0 ) ] = index;
+        mSecurity.push_back( row.GetFloat( 2 ) );
+        mPositions.push_back( GPoint( row.GetDouble( 3 ), row.GetDouble( 4 ), row.GetDouble( 5 ) ) );
+
+        std::map< uint32, uint32 >::iterator region = regions.find( row.GetUInt( 1 ) );
+        if( regions.end() == region )
+        {
+            region = regions.insert( std::make_pair( row.GetUInt( 1 ), (uint32)mRegions.size() ) ).first;
+
+            mRegions.push_back( Region() );
+            mRegions.back().regionID = row.GetUInt( 1 );
+        }
+
+        Region& r = mRegions[ region->second ];
+        mRegionOf.push_back( region->second );
+        mRegionSlot.push_back( r.systems.size() );
+        r.systems.push_back( index );
+    }
+
+    if( !sDatabase.RunQuery( res,
+        "SELECT fromSolarSystemID, toSolarSystemID"
+        " FROM mapSolarSystemJumps" ) )
+    {
+        codelog( SERVICE__ERROR, "Error in query: %s", res.error.c_str() );
+        return false;
+    }
+
+    // both directions, as the table may list a jump once or twice
+    std::vector< std::pair< uint32, uint32 > > jumps;
+    while( res.GetRow( row ) )
+    {
+        const uint32 from = _GetIndex( row.GetUInt( 0 ) );
+        const uint32 to = _GetIndex( row.GetUInt( 1 ) );
+        if( size() == from || size() == to || from == to )
+            continue;
+
+        jumps.push_back( std::make_pair( from, to ) );
+        jumps.push_back( std::make_pair( to, from ) );
+    }
+    std::sort( jumps.begin(), jumps.end() );
+    jumps.erase( std::unique( jumps.begin(), jumps.end() ), jumps.end() );
+
+    mOffsets.resize( size() + 1, 0 );
+    mNeighbors.reserve( jumps.size() );
+    for( size_t i = 0; i < jumps.size(); ++i )
+    {
+        ++mOffsets[ jumps[ i ].first + 1 ];
+        mNeighbors.push_back( jumps[ i ].second );
+
+        const double length = ( mPositions[ jumps[ i ].second ] - mPositions[ jumps[ i ].first ] ).length();
+        if( mMaxJumpLength < length )
+            mMaxJumpLength = length;
+    }
+    for( size_t i = 0; i < size(); ++i )
+        mOffsets[ i + 1 ] += mOffsets[ i ];
+
+    std::vector< Region >::iterator cur, end;
+    cur = mRegions.begin();
+    end = mRegions.end();
+    for(; cur != end; ++cur )
+        _BuildTable( *cur );
+
+    return true;
+}
+
+int32 RouteMap::GetJumps( uint32 fromSystemID, uint32 toSystemID )
+{
+    ++mStats.queries;
+
+    const uint32 from = _GetIndex( fromSystemID );
+    const uint32 to = _GetIndex( toSystemID );
+    if( size() == from || size() == to )
+        return -1;
+
+    if( mRegionOf[ from ] == mRegionOf[ to ] )
+    {
+        const Region& region = mRegions[ mRegionOf[ from ] ];
+        if( region.jumps.empty() )
+            return ( from == to ? 0 : -1 );
+
+        ++mStats.tableHits;
+
+        const uint8 jumps = region.jumps[ mRegionSlot[ from ] * region.systems.size() + mRegionSlot[ to ] ];
+        return ( UNREACHABLE == jumps ? -1 : jumps );
+    }
+
+    const std::vector< uint32 >& route = _FindRoute( from, to, ROUTE_SHORTEST );
+    return ( route.empty() ? -1 : route.size() - 1 );
+}
+
+bool RouteMap::GetRoute( uint32 fromSystemID, uint32 toSystemID, RouteType type, std::vector< uint32 >& into )
+{
+    ++mStats.queries;
+
+    into.clear();
+
+    const uint32 from = _GetIndex( fromSystemID );
+    const uint32 to = _GetIndex( toSystemID );
+    if( size() == from || size() == to )
+        return false;
+
+    const std::vector< uint32 >& route = _FindRoute( from, to, type );
+    for( size_t i = 0; i < route.size(); ++i )
+        into.push_back( mSystemIDs[ route[ i ] ] );
+
+    return !into.empty();
+}
+
+uint32 RouteMap::_GetIndex( uint32 systemID ) const
+{
+    std::tr1::unordered_map< uint32, uint32 >::const_iterator res = mIndices.find( systemID );
+    return ( mIndices.end() == res ? size() : res->second );
+}
+
+void RouteMap::_BuildTable( Region& region )
+{
+    const size_t n = region.systems.size();
+
+    // a region without stargates, such as the wormhole space, needs no table
+    bool hasJumps = false;
+    for( size_t i = 0; i < n && !hasJumps; ++i )
+        hasJumps = ( mOffsets[ region.systems[ i ] ] != mOffsets[ region.systems[ i ] + 1 ] );
+    if( !hasJumps )
+        return;
+
+    const uint32 regionIndex = mRegionOf[ region.systems[ 0 ] ];
+    region.jumps.assign( n * n, UNREACHABLE );
+
+    // the routes may leave the region, so the whole graph is searched until all the systems of the region are found
+    std::vector< uint8 > depth( size() );
+    std::vector< uint32 > visited( size(), 0 );
+    std::vector< uint32 > queue( size() );
+
+    for( size_t i = 0; i < n; ++i )
+    {
+        const uint32 stamp = i + 1;
+        uint8* row = &region.jumps[ i * n ];
+
+        size_t head = 0, tail = 0;
+        queue[ tail++ ] = region.systems[ i ];
+        visited[ region.systems[ i ] ] = stamp;
+        depth[ region.systems[ i ] ] = 0;
+
+        size_t found = 0;
+        while( head < tail && found < n )
+        {
+            const uint32 cur = queue[ head++ ];
+            if( regionIndex == mRegionOf[ cur ] )
+            {
+                row[ mRegionSlot[ cur ] ] = depth[ cur ];
+                ++found;
+            }
+
+            if( UNREACHABLE - 1 == depth[ cur ] )
+                continue;
+
+            for( uint32 j = mOffsets[ cur ]; j < mOffsets[ cur + 1 ]; ++j )
+            {
+                const uint32 next = mNeighbors[ j ];
+                if( stamp == visited[ next ] )
+                    continue;
+
+                visited[ next ] = stamp;
+                depth[ next ] = depth[ cur ] + 1;
+                queue[ tail++ ] = next;
+            }
+        }
+    }
+}
+
+const std::vector< uint32 >& RouteMap::_FindRoute( uint32 from, uint32 to, RouteType type )
+{
+    const uint64 key = _RouteKey( from, to, type );
+
+    std::tr1::unordered_map< uint64, RouteList::iterator >::iterator res = mRouteIndex.find( key );
+    if( mRouteIndex.end() != res )
+    {
+        ++mStats.cacheHits;
+
+        mRoutes.splice( mRoutes.begin(), mRoutes, res->second );
+        return mRoutes.front().second;
+    }
+
+    // no route is cached as empty
+    mRoutes.push_front( CachedRoute( key, std::vector< uint32 >() ) );
+    mRouteIndex[ key ] = mRoutes.begin();
+    _Search( from, to, type, mRoutes.front().second );
+
+    if( ROUTE_CACHE_SIZE < mRoutes.size() )
+    {
+        mRouteIndex.erase( mRoutes.back().first );
+        mRoutes.pop_back();
+    }
+
+    return mRoutes.front().second;
+}
+
+bool RouteMap::_Search( uint32 from, uint32 to, RouteType type, std::vector< uint32 >& into )
+{
+    ++mStats.searches;
+
+    into.clear();
+
+    // A*; every jump costs at least 1, so the estimate never overshoots
+    typedef std::pair< double, uint32 > OpenEntry;
+    std::priority_queue< OpenEntry, std::vector< OpenEntry >, std::greater< OpenEntry > > open;
+
+    std::vector< uint32 > cost( size(), UINT_MAX );
+    std::vector< uint32 > parent( size(), size() );
+    std::vector< bool > closed( size(), false );
+
+    cost[ from ] = 0;
+    open.push( OpenEntry( _GetEstimate( from, to ), from ) );
+
+    while( !open.empty() )
+    {
+        const uint32 cur = open.top().second;
+        open.pop();
+
+        if( closed[ cur ] )
+            continue;
+        closed[ cur ] = true;
+        ++mStats.expanded;
+
+        if( to == cur )
+            break;
+
+        for( uint32 j = mOffsets[ cur ]; j < mOffsets[ cur + 1 ]; ++j )
+        {
+            const uint32 next = mNeighbors[ j ];
+            const uint32 nextCost = cost[ cur ] + _GetCost( next, type );
+            if( closed[ next ] || cost[ next ] <= nextCost )
+                continue;
+
+            cost[ next ] = nextCost;
+            parent[ next ] = cur;
+            open.push( OpenEntry( nextCost + _GetEstimate( next, to ), next ) );
+        }
+    }
+
+    if( !closed[ to ] )
+        return false;
+
+    for( uint32 cur = to; size() != cur; cur = parent[ cur ] )
+        into.push_back( cur );
+    std::reverse( into.begin(), into.end() );
+
+    return true;
+}
+
+uint32 RouteMap::_GetCost( uint32 index, RouteType type ) const
+{
+    const bool high = ( HIGH_SECURITY <= mSecurity[ index ] );
+
+    switch( type )
+    {
+        case ROUTE_SAFER:       return ( high ? 1 : AVOID_COST );
+        case ROUTE_LESS_SECURE: return ( high ? AVOID_COST : 1 );
+        default:                return 1;
+    }
+}
+
+double RouteMap::_GetEstimate( uint32 from, uint32 to ) const
+{
+    if( 0.0 >= mMaxJumpLength )
+        return 0.0;
+
+    return ( mPositions[ to ] - mPositions[ from ] ).length() / mMaxJumpLength;
+}
@@ -46,23 +46,32 @@ BillMgrService::~BillMgrService() {
     delete m_dispatch;
 }
 
-
-PyResult BillMgrService::Handle_GetBillTypes( PyCallArgs& call )
-{
-    PyRep* result = NULL;
-
+void BillMgrService::PrimeCache() {
     ObjectCachedMethodID method_id(GetName(), "GetBillTypes");
+    _CacheBillTypes(method_id);
+}
 
+
+void BillMgrService::_CacheBillTypes(const ObjectCachedMethodID &method_id) {
     //check to see if this method is in the cache already.
     if(!m_manager->cache_service->IsCacheLoaded(method_id)) {
         //this method is not in cache yet, load up the contents and cache it.
-        result = m_db.GetRefTypes();
+        PyRep *result = m_db.GetRefTypes();
         if(result == NULL) {
             codelog(SERVICE__ERROR, "Failed to load cache, generating empty contents.");
             result = new PyNone();
         }
         m_manager->cache_service->GiveCache(method_id, &result);
     }
+}
+
+PyResult BillMgrService::Handle_GetBillTypes( PyCallArgs& call )
+{
+    PyRep* result = NULL;
+
+    ObjectCachedMethodID method_id(GetName(), "GetBillTypes");
+
+    _CacheBillTypes(method_id);
 
     //now we know its in the cache one way or the other, so build a
     //cached object cached method call result.
@@ -0,0 +1,512 @@
+/*
+    ------------------------------------------------------------------------------------
+    LICENSE:
+    ------------------------------------------------------------------------------------
+    This file is part of EVEmu: EVE Online Server Emulator
+    Copyright 2006 - 2011 The EVEmu Team
+    For the latest information visit http://evemu.org
+    ------------------------------------------------------------------------------------
+    This program is free software; you can redistribute it and/or modify it under
+    the terms of the GNU Lesser General Public License as published by the Free Software
+    Foundation; either version 2 of the License, or (at your option) any later
+    version.
+
+    This program is distributed in the hope that it will be useful, but WITHOUT
+    ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+    FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public License along with
+    this program; if not, write to the Free Software Foundation, Inc., 59 Temple
+    Place - Suite 330, Boston, MA 02111-1307, USA, or go to
+    http://www.gnu.org/copyleft/lesser.txt.
+    ------------------------------------------------------------------------------------
+    Author:     EVEmu Team
+*/
+
+#include "eve-server.h"
+
+#include "market/ContractBook.h"
+
+/// Delay (in milliseconds) before a failed expiry is retried.
+static const uint32 CONTRACT_EXPIRY_RETRY = 60 * 1000;
+/// Most contracts expired by a single statement.
+static const size_t CONTRACT_EXPIRY_BATCH = 256;
+
+ContractBook::ContractBook()
+: mExpiryTimer( *this ),
+  mNextContractID( 1 )
+{
+}
+
+bool ContractBook::Load()
+{
+    DBQueryResult res;
+    if( !sDatabase.RunQuery( res,
+        "SELECT"
+        "   contractID, type, status, issuerID, issuerCorpID, forCorp, assigneeID, acceptorID,"
+        "   startStationID, startSolarSystemID, startRegionID, endStationID,"
+        "   price, reward, collateral, volume, title, dateIssued, dateExpired, dateAccepted, numDays"
+        " FROM contracts"
+        " WHERE status NOT IN (%u, %u)",
+        (uint32)contractStatusFinished, (uint32)contractStatusDeleted ) )
+    {
+        codelog( MARKET__ERROR, "Error in query: %s", res.error.c_str() );
+        return false;
+    }
+
+    std::map< uint32, Contract > contracts;
+
+    DBResultRow row;
+    while( res.GetRow( row ) )
+    {
+        Contract& contract = contracts[ row.GetUInt( 0 ) ];
+        contract.contractID = row.GetUInt( 0 );
+        contract.type = (EVEContractType)row.GetUInt( 1 );
+        contract.status = (EVEContractStatus)row.GetUInt( 2 );
+        contract.issuerID = row.GetUInt( 3 );
+        contract.issuerCorpID = row.GetUInt( 4 );
+        contract.forCorp = ( 0 != row.GetInt( 5 ) );
+        contract.assigneeID = row.GetUInt( 6 );
+        contract.acceptorID = row.GetUInt( 7 );
+        contract.startStationID = row.GetUInt( 8 );
+        contract.startSolarSystemID = row.GetUInt( 9 );
+        contract.startRegionID = row.GetUInt( 10 );
+        contract.endStationID = row.GetUInt( 11 );
+        contract.price = row.GetDouble( 12 );
+        contract.reward = row.GetDouble( 13 );
+        contract.collateral = row.GetDouble( 14 );
+        contract.volume = row.GetDouble( 15 );
+        contract.title = row.GetText( 16 );
+        contract.dateIssued = row.GetUInt64( 17 );
+        contract.dateExpired = row.GetUInt64( 18 );
+        contract.dateAccepted = row.GetUInt64( 19 );
+        contract.numDays = row.GetUInt( 20 );
+    }
+
+    if( !sDatabase.RunQuery( res,
+        "SELECT"
+        "   item.contractID, item.itemID, item.typeID, item.quantity, item.inCrate"
+        " FROM contracts_items AS item"
+        " JOIN contracts USING (contractID)"
+        " WHERE contracts.status NOT IN (%u, %u)",
+        (uint32)contractStatusFinished, (uint32)contractStatusDeleted ) )
+    {
+        codelog( MARKET__ERROR, "Error in query: %s", res.error.c_str() );
+        return false;
+    }
+
+    while( res.GetRow( row ) )
+    {
+        std::map< uint32, Contract >::iterator contract = contracts.find( row.GetUInt( 0 ) );
+        if( contract == contracts.end() )
+            continue;
+
+        ContractItem item;
+        item.itemID = row.GetUInt( 1 );
+        item.typeID = row.GetUInt( 2 );
+        item.quantity = row.GetUInt( 3 );
+        item.inCrate = ( 0 != row.GetInt( 4 ) );
+
+        contract->second.items.push_back( item );
+    }
+
+    // the finished contracts keep their IDs too
+    if( !sDatabase.RunQuery( res, "SELECT MAX(contractID) FROM contracts" ) )
+    {
+        codelog( MARKET__ERROR, "Error in query: %s", res.error.c_str() );
+        return false;
+    }
+
+    mContracts.clear();
+    mSearchable.clear();
+    mRegionIndex.clear();
+    mTypeIndex.clear();
+    mIssuerIndex.clear();
+    mAssigneeIndex.clear();
+    mAcceptorIndex.clear();
+    mExpiryQueue.clear();
+
+    mNextContractID = 1;
+    if( res.GetRow( row ) && !row.IsNull( 0 ) )
+        mNextContractID = row.GetUInt( 0 ) + 1;
+
+    std::map< uint32, Contract >::const_iterator cur, end;
+    cur = contracts.begin();
+    end = contracts.end();
+    for(; cur != end; ++cur )
+        _Insert( cur->second );
+
+    // the contracts which expired while the server was down go first
+    _ScheduleExpiry();
+    return true;
+}
+
+const Contract* ContractBook::GetContract( uint32 contractID ) const
+{
+    std::tr1::unordered_map< uint32, Contract >::const_iterator res = mContracts.find( contractID );
+    if( res == mContracts.end() )
+        return NULL;
+
+    return &res->second;
+}
+
+uint32 ContractBook::CreateContract( Contract& contract )
+{
+    contract.contractID = mNextContractID;
+    contract.status = contractStatusOutstanding;
+    contract.acceptorID = 0;
+    contract.dateAccepted = 0;
+
+    std::string title;
+    sDatabase.DoEscapeString( title, contract.title );
+
+    std::vector< std::string > queries;
+    char buf[ 1024 ];
+
+    snprintf( buf, sizeof( buf ),
+        "INSERT INTO contracts"
+        " (contractID, type, status, issuerID, issuerCorpID, forCorp, assigneeID, acceptorID,"
+        " startStationID, startSolarSystemID, startRegionID, endStationID,"
+        " price, reward, collateral, volume, title, dateIssued, dateExpired, dateAccepted, numDays)"
+        " VALUES"
+        " (%u, %u, %u, %u, %u, %u, %u, 0, %u, %u, %u, %u, %f, %f, %f, %f, '%s', %" PRIu64 ", %" PRIu64 ", 0, %u)",
+        contract.contractID, (uint32)contract.type, (uint32)contract.status, contract.issuerID, contract.issuerCorpID,
+        contract.forCorp ? 1 : 0, contract.assigneeID,
+        contract.startStationID, contract.startSolarSystemID, contract.startRegionID, contract.endStationID,
+        contract.price, contract.reward, contract.collateral, contract.volume, title.c_str(),
+        contract.dateIssued, contract.dateExpired, contract.numDays );
+    queries.push_back( buf );
+
+    if( !contract.items.empty() )
+    {
+        std::string items = "INSERT INTO contracts_items (contractID, itemID, typeID, quantity, inCrate) VALUES";
+
+        std::vector< ContractItem >::const_iterator cur, end;
+        cur = contract.items.begin();
+        end = contract.items.end();
+        for(; cur != end; ++cur )
+        {
+            snprintf( buf, sizeof( buf ), "%s (%u, %u, %u, %u, %u)",
+                      ( cur == contract.items.begin() ? "" : "," ),
+                      contract.contractID, cur->itemID, cur->typeID, cur->quantity, cur->inCrate ? 1 : 0 );
+            items += buf;
+        }
+
+        queries.push_back( items );
+    }
+
+    DBerror err;
+    if( !sDatabase.RunTransaction( err, queries ) )
+    {
+        _log( DATABASE__ERROR, "Failed to create contract of %u: %s.", contract.issuerID, err.c_str() );
+        return 0;
+    }
+
+    ++mNextContractID;
+    _Insert( contract );
+    // it may expire before any other contract
+    _ScheduleExpiry();
+
+    ++mStats.created;
+    return contract.contractID;
+}
+
+bool ContractBook::SetStatus( uint32 contractID, EVEContractStatus status, uint32 acceptorID )
+{
+    std::tr1::unordered_map< uint32, Contract >::iterator res = mContracts.find( contractID );
+    if( res == mContracts.end() )
+        return false;
+
+    Contract contract = res->second;
+    contract.status = status;
+    if( 0 != acceptorID )
+    {
+        contract.acceptorID = acceptorID;
+        contract.dateAccepted = Win32TimeNow();
+    }
+
+    DBerror err;
+    if( !sDatabase.RunQuery( err,
+        "UPDATE contracts"
+        " SET status = %u, acceptorID = %u, dateAccepted = %" PRIu64
+        " WHERE contractID = %u",
+        (uint32)contract.status, contract.acceptorID, contract.dateAccepted, contractID ) )
+    {
+        _log( DATABASE__ERROR, "Failed to change status of contract %u to %u: %s.", contractID, (uint32)status, err.c_str() );
+        return false;
+    }
+
+    _Erase( res->second );
+    if( contractStatusFinished != status && contractStatusDeleted != status )
+        _Insert( contract );
+
+    return true;
+}
+
+uint32 ContractBook::Search( const ContractFilter& filter, uint32 after, size_t count, std::vector< const Contract* >& into )
+{
+    ++mStats.searches;
+
+    // walk the narrowest index the filter allows
+    const ContractSet* contracts = &mSearchable;
+    if( 0 != filter.typeID || 0 != filter.regionID )
+    {
+        const ContractIndex& index = ( 0 != filter.typeID ? mTypeIndex : mRegionIndex );
+        ContractIndex::const_iterator res = index.find( 0 != filter.typeID ? filter.typeID : filter.regionID );
+        if( res == index.end() )
+            return 0;
+
+        contracts = &res->second;
+    }
+
+    uint32 last = after;
+
+    ContractSet::const_iterator cur, end;
+    cur = contracts->upper_bound( after );
+    end = contracts->end();
+    for(; cur != end; ++cur )
+    {
+        if( into.size() == count )
+            return last;
+
+        ++mStats.examined;
+        last = *cur;
+
+        const Contract& contract = mContracts.find( *cur )->second;
+        if( _Matches( contract, filter ) )
+            into.push_back( &contract );
+    }
+
+    return 0;
+}
+
+void ContractBook::GetIssuedContracts( uint32 issuerID, std::vector< const Contract* >& into ) const
+{
+    _Get( mIssuerIndex, issuerID, into );
+}
+
+void ContractBook::GetAssignedContracts( uint32 assigneeID, std::vector< const Contract* >& into ) const
+{
+    _Get( mAssigneeIndex, assigneeID, into );
+}
+
+void ContractBook::GetAcceptedContracts( uint32 acceptorID, std::vector< const Contract* >& into ) const
+{
+    _Get( mAcceptorIndex, acceptorID, into );
+}
+
+uint32 ContractBook::CountRequiringAttention( uint32 ownerID ) const
+{
+    uint32 count = 0;
+
+    std::vector< const Contract* > contracts;
+    GetAssignedContracts( ownerID, contracts );
+
+    std::vector< const Contract* >::const_iterator cur, end;
+    cur = contracts.begin();
+    end = contracts.end();
+    for(; cur != end; ++cur )
+    {
+        if( contractStatusOutstanding == ( *cur )->status )
+            ++count;
+    }
+
+    contracts.clear();
+    GetIssuedContracts( ownerID, contracts );
+
+    cur = contracts.begin();
+    end = contracts.end();
+    for(; cur != end; ++cur )
+    {
+        // a corporation contract is the corporation's business, not its issuer's
+        const uint32 owner = ( ( *cur )->forCorp ? ( *cur )->issuerCorpID : ( *cur )->issuerID );
+        if( contractStatusExpired == ( *cur )->status && owner == ownerID )
+            ++count;
+    }
+
+    return count;
+}
+
+bool ContractBook::_IsSearchable( const Contract& contract )
+{
+    return contractStatusOutstanding == contract.status && 0 == contract.assigneeID;
+}
+
+bool ContractBook::_Matches( const Contract& contract, const ContractFilter& filter )
+{
+    if( 0 != filter.regionID && contract.startRegionID != filter.regionID )
+        return false;
+    if( 0 != filter.type && (uint32)contract.type != filter.type )
+        return false;
+    if( 0 != filter.issuerID && contract.issuerID != filter.issuerID && contract.issuerCorpID != filter.issuerID )
+        return false;
+    if( 0.0 < filter.minPrice && contract.price < filter.minPrice )
+        return false;
+    if( 0.0 < filter.maxPrice && contract.price > filter.maxPrice )
+        return false;
+
+    // the type index holds only the offered types, so it needs no check here
+    return true;
+}
+
+void ContractBook::_Index( ContractIndex& index, uint32 key, uint32 contractID )
+{
+    index[ key ].insert( contractID );
+}
+
+void ContractBook::_Unindex( ContractIndex& index, uint32 key, uint32 contractID )
+{
+    ContractIndex::iterator res = index.find( key );
+    if( res == index.end() )
+        return;
+
+    res->second.erase( contractID );
+    if( res->second.empty() )
+        index.erase( res );
+}
+
+void ContractBook::_Get( const ContractIndex& index, uint32 key, std::vector< const Contract* >& into ) const
+{
+    ContractIndex::const_iterator res = index.find( key );
+    if( res == index.end() )
+        return;
+
+    ContractSet::const_iterator cur, end;
+    cur = res->second.begin();
+    end = res->second.end();
+    for(; cur != end; ++cur )
+        into.push_back( GetContract( *cur ) );
+}
+
+void ContractBook::_Insert( const Contract& contract )
+{
+    const uint32 contractID = contract.contractID;
+    mContracts[ contractID ] = contract;
+
+    _Index( mIssuerIndex, contract.issuerID, contractID );
+    if( contract.forCorp )
+        _Index( mIssuerIndex, contract.issuerCorpID, contractID );
+    if( 0 != contract.assigneeID )
+        _Index( mAssigneeIndex, contract.assigneeID, contractID );
+    if( 0 != contract.acceptorID )
+        _Index( mAcceptorIndex, contract.acceptorID, contractID );
+
+    if( contractStatusOutstanding == contract.status )
+        mExpiryQueue.insert( std::make_pair( contract.dateExpired, contractID ) );
+
+    if( _IsSearchable( contract ) )
+    {
+        mSearchable.insert( contractID );
+        _Index( mRegionIndex, contract.startRegionID, contractID );
+
+        std::vector< ContractItem >::const_iterator cur, end;
+        cur = contract.items.begin();
+        end = contract.items.end();
+        for(; cur != end; ++cur )
+        {
+            if( cur->inCrate )
+                _Index( mTypeIndex, cur->typeID, contractID );
+        }
+    }
+}
+
+void ContractBook::_Erase( const Contract& contract )
+{
+    // keep the ID; the contract goes away at the end
+    const uint32 contractID = contract.contractID;
+
+    if( _IsSearchable( contract ) )
+    {
+        mSearchable.erase( contractID );
+        _Unindex( mRegionIndex, contract.startRegionID, contractID );
+
+        std::vector< ContractItem >::const_iterator cur, end;
+        cur = contract.items.begin();
+        end = contract.items.end();
+        for(; cur != end; ++cur )
+        {
+            if( cur->inCrate )
+                _Unindex( mTypeIndex, cur->typeID, contractID );
+        }
+    }
+
+    if( contractStatusOutstanding == contract.status )
+        mExpiryQueue.erase( std::make_pair( contract.dateExpired, contractID ) );
+
+    _Unindex( mIssuerIndex, contract.issuerID, contractID );
+    if( contract.forCorp )
+        _Unindex( mIssuerIndex, contract.issuerCorpID, contractID );
+    if( 0 != contract.assigneeID )
+        _Unindex( mAssigneeIndex, contract.assigneeID, contractID );
+    if( 0 != contract.acceptorID )
+        _Unindex( mAcceptorIndex, contract.acceptorID, contractID );
+
+    mContracts.erase( contractID );
+}
+
+void ContractBook::_Expire()
+{
+    const uint64 now = Win32TimeNow();
+
+    std::vector< uint32 > due;
+    std::string contracts;
+    char buf[ 16 ];
+
+    ExpiryQueue::const_iterator cur, end;
+    cur = mExpiryQueue.begin();
+    end = mExpiryQueue.end();
+    for(; cur != end && cur->first <= now && due.size() < CONTRACT_EXPIRY_BATCH; ++cur )
+    {
+        due.push_back( cur->second );
+
+        snprintf( buf, sizeof( buf ), "%s%u", ( contracts.empty() ? "" : ", " ), cur->second );
+        contracts += buf;
+    }
+
+    if( !due.empty() )
+    {
+        DBerror err;
+        if( !sDatabase.RunQuery( err,
+            "UPDATE contracts"
+            " SET status = %u"
+            " WHERE contractID IN (%s)",
+            (uint32)contractStatusExpired, contracts.c_str() ) )
+        {
+            _log( DATABASE__ERROR, "Failed to expire %lu contracts: %s.", (unsigned long)due.size(), err.c_str() );
+
+            sTimerWheel.Schedule( &mExpiryTimer, CONTRACT_EXPIRY_RETRY );
+            return;
+        }
+
+        std::vector< uint32 >::const_iterator curd, endd;
+        curd = due.begin();
+        endd = due.end();
+        for(; curd != endd; ++curd )
+        {
+            // the issuer takes it back from here
+            Contract contract = mContracts.find( *curd )->second;
+            _Erase( contract );
+
+            contract.status = contractStatusExpired;
+            _Insert( contract );
+        }
+
+        mStats.expired += due.size();
+    }
+
+    _ScheduleExpiry();
+}
+
+void ContractBook::_ScheduleExpiry()
+{
+    if( mExpiryQueue.empty() )
+    {
+        sTimerWheel.Cancel( &mExpiryTimer );
+        return;
+    }
+
+    const uint64 next = mExpiryQueue.begin()->first;
+    const uint64 now = Win32TimeNow();
+    const uint64 delay = ( next > now ? ( next - now ) / ( Win32Time_Second / 1000 ) : 0 );
+    sTimerWheel.Schedule( &mExpiryTimer, (uint32)std::min< uint64 >( delay, 0xFFFFFFFF ) );
+}
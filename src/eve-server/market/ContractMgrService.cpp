@@ -26,6 +26,7 @@
 #include "eve-server.h"
 
 #include "PyServiceCD.h"
+#include "market/ContractBook.h"
 #include "market/ContractMgrService.h"
 
 PyCallable_Make_InnerDispatcher(ContractMgrService)
@@ -46,11 +47,9 @@ ContractMgrService::~ContractMgrService()
 
 PyResult ContractMgrService::Handle_NumRequiringAttention( PyCallArgs& call )
 {
-    sLog.Debug( "ContractMgrService", "Called NumRequiringAttention stub." );
-
     PyDict* args = new PyDict;
-    args->SetItemString( "n", new PyInt( 0 ) );
-    args->SetItemString( "ncorp", new PyInt( 0 ) );
+    args->SetItemString( "n", new PyInt( sContractBook.CountRequiringAttention( call.client->GetCharacterID() ) ) );
+    args->SetItemString( "ncorp", new PyInt( sContractBook.CountRequiringAttention( call.client->GetCorporationID() ) ) );
 
     return new PyObject( "util.KeyVal", args );
 }
@@ -26,6 +26,7 @@
 #include "eve-server.h"
 
 #include "PyServiceCD.h"
+#include "market/ContractBook.h"
 #include "market/ContractProxy.h"
 
 // crap
@@ -47,15 +48,13 @@ ContractProxyService::~ContractProxyService()
 }
 
 PyResult ContractProxyService::Handle_GetMyExpiredContractList(PyCallArgs &call) {
-    sLog.Debug("Server", "Called GetMyExpiredContractList Stub.");
+    _debug("Server", "Called GetMyExpiredContractList Stub.");
 
     return NULL;
 }
 
 PyResult ContractProxyService::Handle_GetLoginInfo(PyCallArgs &call)
 {
-    // currently a stub as I need to redesign or change some sub systems for this.
-
     PyDict* args = new PyDict;
 
     /* create needsAttention row descriptor */
@@ -78,6 +77,42 @@ PyResult ContractProxyService::Handle_GetLoginInfo(PyCallArgs &call)
     assignedToMeHeader->AddColumn( "issuerID",      DBTYPE_I4);
     CRowSet *assignedToMe_rowset = new CRowSet( &assignedToMeHeader );
 
+    /* fill them from the contract book; the meaning of the second needsAttention column is unknown, so it stays empty */
+    std::vector<const Contract*> contracts;
+    sContractBook.GetAcceptedContracts( call.client->GetCharacterID(), contracts );
+
+    std::vector<const Contract*>::const_iterator cur, end;
+    cur = contracts.begin();
+    end = contracts.end();
+    for(; cur != end; cur++)
+    {
+        const Contract& contract = **cur;
+        if( contractStatusInProgress != contract.status )
+            continue;
+
+        PyPackedRow* row = inProgress_rowset->NewRow();
+        row->SetField( (uint32)0, new PyInt( contract.contractID ) );
+        row->SetField( 1, new PyInt( contract.startStationID ) );
+        row->SetField( 2, new PyInt( contract.endStationID ) );
+        row->SetField( 3, new PyLong( (int64)( contract.dateAccepted + contract.numDays * Win32Time_Day ) ) );
+    }
+
+    contracts.clear();
+    sContractBook.GetAssignedContracts( call.client->GetCharacterID(), contracts );
+
+    cur = contracts.begin();
+    end = contracts.end();
+    for(; cur != end; cur++)
+    {
+        const Contract& contract = **cur;
+        if( contractStatusOutstanding != contract.status )
+            continue;
+
+        PyPackedRow* row = assignedToMe_rowset->NewRow();
+        row->SetField( (uint32)0, new PyInt( contract.contractID ) );
+        row->SetField( 1, new PyInt( contract.issuerID ) );
+    }
+
     args->SetItemString( "needsAttention",          needsAttention_rowset );
     args->SetItemString( "inProgress",              inProgress_rowset );
     args->SetItemString( "assignedToMe",            assignedToMe_rowset );
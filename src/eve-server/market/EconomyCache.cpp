@@ -0,0 +1,234 @@
+/*
+    ------------------------------------------------------------------------------------
+    LICENSE:
+    ------------------------------------------------------------------------------------
+    This file is part of EVEmu: EVE Online Server Emulator
+    Copyright 2006 - 2011 The EVEmu Team
+    For the latest information visit http://evemu.org
+    ------------------------------------------------------------------------------------
+    This program is free software; you can redistribute it and/or modify it under
+    the terms of the GNU Lesser General Public License as published by the Free Software
+    Foundation; either version 2 of the License, or (at your option) any later
+    version.
+
+    This program is distributed in the hope that it will be useful, but WITHOUT
+    ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+    FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public License along with
+    this program; if not, write to the Free Software Foundation, Inc., 59 Temple
+    Place - Suite 330, Boston, MA 02111-1307, USA, or go to
+    http://www.gnu.org/copyleft/lesser.txt.
+    ------------------------------------------------------------------------------------
+    Author:     EVEmu Team
+*/
+
+
+#include "eve-server.h"
+
+#include "inventory/AttributeEnum.h"
+#include "market/EconomyCache.h"
+
+/// The premium and the payout of the insurance levels, as fractions of the insured price.
+static const struct
+{
+    double premium;
+    double payout;
+} INSURANCE_LEVELS[ EconomyCache::INSURANCE_LEVEL_COUNT ] =
+{
+    { 0.05, 0.50 },    // basic
+    { 0.10, 0.60 },    // standard
+    { 0.15, 0.70 },    // bronze
+    { 0.20, 0.80 },    // silver
+    { 0.25, 0.90 },    // gold
+    { 0.30, 1.00 }     // platinum
+};
+
+/// Fraction of the base price repairing an item from no hit points to full costs.
+static const double REPAIR_COST_FRACTION = 0.1;
+
+EconomyCache::EconomyCache()
+: mNoOffers( new PyList ),
+  mOfferCount( 0 )
+{
+}
+
+EconomyCache::~EconomyCache()
+{
+    _ClearOffers();
+    PyDecRef( mNoOffers );
+}
+
+bool EconomyCache::Load()
+{
+    return _LoadTypes() && _LoadOffers();
+}
+
+double EconomyCache::GetInsurancePrice( uint32 typeID )
+{
+    ++mStats.insuranceQuotes;
+
+    std::tr1::unordered_map< uint32, TypeCosts >::const_iterator res = mTypes.find( typeID );
+    if( res == mTypes.end() )
+        return 0.0;
+    return res->second.insurancePrice;
+}
+
+double EconomyCache::GetInsurancePremium( uint32 typeID, InsuranceLevel level ) const
+{
+    std::tr1::unordered_map< uint32, TypeCosts >::const_iterator res = mTypes.find( typeID );
+    if( res == mTypes.end() )
+        return 0.0;
+    return res->second.premiums[ level ];
+}
+
+double EconomyCache::GetInsurancePayout( uint32 typeID, InsuranceLevel level ) const
+{
+    std::tr1::unordered_map< uint32, TypeCosts >::const_iterator res = mTypes.find( typeID );
+    if( res == mTypes.end() )
+        return 0.0;
+    return res->second.payouts[ level ];
+}
+
+double EconomyCache::GetRepairUnitCost( uint32 typeID )
+{
+    ++mStats.repairQuotes;
+
+    std::tr1::unordered_map< uint32, TypeCosts >::const_iterator res = mTypes.find( typeID );
+    if( res == mTypes.end() )
+        return 0.0;
+    return res->second.repairUnitCost;
+}
+
+PyList* EconomyCache::GetOffers( uint32 corporationID )
+{
+    ++mStats.offerLists;
+
+    std::map< uint32, PyList* >::const_iterator res = mOffers.find( corporationID );
+    PyList* offers = ( res != mOffers.end() ? res->second : mNoOffers );
+    PyIncRef( offers );
+    return offers;
+}
+
+bool EconomyCache::_LoadTypes()
+{
+    mTypes.clear();
+
+    DBQueryResult res;
+    DBResultRow row;
+
+    if( !sDatabase.RunQuery( res,
+        "SELECT invTypes.typeID, invTypes.basePrice, invGroups.categoryID,"
+        "  COALESCE( dgmTypeAttributes.valueFloat, dgmTypeAttributes.valueInt, 0 )"
+        " FROM invTypes"
+        "  LEFT JOIN invGroups USING( groupID )"
+        "  LEFT JOIN dgmTypeAttributes ON dgmTypeAttributes.typeID = invTypes.typeID"
+        "   AND dgmTypeAttributes.attributeID = %u"
+        " WHERE invGroups.categoryID IN ( %u, %u, %u )",
+        AttrHp,
+        EVEDB::invCategories::Ship, EVEDB::invCategories::Module, EVEDB::invCategories::Drone ) )
+    {
+        codelog( SERVICE__ERROR, "Error in query: %s", res.error.c_str() );
+        return false;
+    }
+
+    while( res.GetRow( row ) )
+    {
+        const double basePrice = row.GetDouble( 1 );
+        const double hp = row.GetDouble( 3 );
+
+        TypeCosts& costs = mTypes[ row.GetUInt( 0 ) ];
+        costs.insurancePrice = ( row.GetUInt( 2 ) == EVEDB::invCategories::Ship ? basePrice : 0.0 );
+        for( uint32 i = 0; i < INSURANCE_LEVEL_COUNT; ++i )
+        {
+            costs.premiums[ i ] = costs.insurancePrice * INSURANCE_LEVELS[ i ].premium;
+            costs.payouts[ i ] = costs.insurancePrice * INSURANCE_LEVELS[ i ].payout;
+        }
+        costs.repairUnitCost = ( hp > 0.0 ? basePrice * REPAIR_COST_FRACTION / hp : 0.0 );
+    }
+
+    return true;
+}
+
+bool EconomyCache::_LoadOffers()
+{
+    _ClearOffers();
+
+    DBQueryResult res;
+    DBResultRow row;
+
+    //the items each offer requires, by offerID.
+    std::map< uint32, PyList* > requirements;
+    if( !sDatabase.RunQuery( res,
+        "SELECT offerID, typeID, quantity"
+        " FROM lpStoreRequirements" ) )
+    {
+        codelog( SERVICE__ERROR, "Error in query: %s", res.error.c_str() );
+        return false;
+    }
+    while( res.GetRow( row ) )
+    {
+        PyList*& items = requirements[ row.GetUInt( 0 ) ];
+        if( items == NULL )
+            items = new PyList;
+
+        PyTuple* item = new PyTuple( 2 );
+        item->SetItem( 0, new PyInt( row.GetUInt( 1 ) ) );
+        item->SetItem( 1, new PyInt( row.GetUInt( 2 ) ) );
+        items->AddItem( item );
+    }
+
+    if( !sDatabase.RunQuery( res,
+        "SELECT corporationID, offerID, typeID, quantity, lpCost, iskCost"
+        " FROM lpStoreOffers"
+        " ORDER BY corporationID, offerID" ) )
+    {
+        codelog( SERVICE__ERROR, "Error in query: %s", res.error.c_str() );
+
+        std::map< uint32, PyList* >::iterator cur = requirements.begin();
+        for(; cur != requirements.end(); ++cur )
+            PyDecRef( cur->second );
+        return false;
+    }
+    while( res.GetRow( row ) )
+    {
+        PyList*& offers = mOffers[ row.GetUInt( 0 ) ];
+        if( offers == NULL )
+            offers = new PyList;
+
+        PyDict* offer = new PyDict;
+        offer->SetItemString( "offerID", new PyInt( row.GetUInt( 1 ) ) );
+        offer->SetItemString( "typeID", new PyInt( row.GetUInt( 2 ) ) );
+        offer->SetItemString( "qty", new PyInt( row.GetUInt( 3 ) ) );
+        offer->SetItemString( "lpCost", new PyInt( row.GetUInt( 4 ) ) );
+        offer->SetItemString( "iskCost", new PyFloat( row.GetDouble( 5 ) ) );
+
+        std::map< uint32, PyList* >::iterator items = requirements.find( row.GetUInt( 1 ) );
+        if( items != requirements.end() )
+        {
+            offer->SetItemString( "reqItems", items->second );    //consumed
+            requirements.erase( items );
+        }
+        else
+            offer->SetItemString( "reqItems", new PyList );
+
+        offers->AddItem( new PyObject( "util.KeyVal", offer ) );
+        ++mOfferCount;
+    }
+
+    //requirements of offers which do not exist.
+    std::map< uint32, PyList* >::iterator cur = requirements.begin();
+    for(; cur != requirements.end(); ++cur )
+        PyDecRef( cur->second );
+
+    return true;
+}
+
+void EconomyCache::_ClearOffers()
+{
+    std::map< uint32, PyList* >::iterator cur = mOffers.begin();
+    for(; cur != mOffers.end(); ++cur )
+        PyDecRef( cur->second );
+    mOffers.clear();
+    mOfferCount = 0;
+}
@@ -25,159 +25,34 @@
 
 #include "eve-server.h"
 
+#include "inventory/InventoryWriteBehind.h"
 #include "market/MarketDB.h"
+#include "market/MarketJournal.h"
+#include "market/MarketOrderBook.h"
 
 PyRep *MarketDB::GetStationAsks(uint32 stationID) {
-    DBQueryResult res;
-
-    if(!sDatabase.RunQuery(res,
-        "SELECT"
-        "    typeID, MAX(price) AS price, volRemaining, stationID "
-        " FROM market_orders "
-        //" WHERE stationID=%u AND bid=%d"
-        " WHERE stationID=%u"
-        " GROUP BY typeID", stationID/*, TransactionTypeSell*/))
-    {
-        codelog(MARKET__ERROR, "Error in query: %s", res.error.c_str());
-        return NULL;
-    }
-
-    //NOTE: this SHOULD return a crazy dbutil.RowDict object which is
-    //made up of packed blue.DBRow objects, but we do not understand
-    //the marshalling of those well enough right now, and this object
-    //provides the same interface. It is significantly bigger on the wire though.
-    return(DBResultToIndexRowset(res, "typeID"));
+    return sMarketOrderBook.GetStationAsks(stationID);
 }
 
 PyRep *MarketDB::GetSystemAsks(uint32 solarSystemID) {
-    DBQueryResult res;
-
-    if(!sDatabase.RunQuery(res,
-        "SELECT"
-        "    typeID, MAX(price) AS price, volRemaining, stationID "
-        " FROM market_orders "
-        //" WHERE solarSystemID=%u AND bid=0"
-        " WHERE solarSystemID=%u"
-        " GROUP BY typeID", solarSystemID))
-    {
-        codelog(MARKET__ERROR, "Error in query: %s", res.error.c_str());
-        return NULL;
-    }
-
-    //NOTE: this SHOULD return a crazy dbutil.RowDict object which is
-    //made up of packed blue.DBRow objects, but we do not understand
-    //the marshalling of those well enough right now, and this object
-    //provides the same interface. It is significantly bigger on the wire though.
-    return(DBResultToIndexRowset(res, "typeID"));
+    return sMarketOrderBook.GetSystemAsks(solarSystemID);
 }
 
 PyRep *MarketDB::GetRegionBest(uint32 regionID) {
-    DBQueryResult res;
-
-    if(!sDatabase.RunQuery(res,
-        "SELECT"
-        "    typeID, MAX(price) AS price, volRemaining, stationID "
-        " FROM market_orders "
-        //" WHERE regionID=%u AND bid=0"
-        " WHERE regionID=%u"
-        " GROUP BY typeID", regionID))
-    {
-        codelog(MARKET__ERROR, "Error in query: %s", res.error.c_str());
-        return NULL;
-    }
-
-    //NOTE: this SHOULD return a crazy dbutil.RowDict object which is
-    //made up of packed blue.DBRow objects, but we do not understand
-    //the marshalling of those well enough right now, and this object
-    //provides the same interface. It is significantly bigger on the wire though.
-    return(DBResultToIndexRowset(res, "typeID"));
+    return sMarketOrderBook.GetRegionBest(regionID);
 }
 
-PyRep *MarketDB::GetOrders( uint32 regionID, uint32 typeID )
+PyRep *MarketDB::GetOrders( uint32 regionID, uint32 typeID, uint32 fromSystemID )
 {
-    DBQueryResult res;
-
-    PyList* tup = new PyList();
-
-    /*DBColumnTypeMap colmap;
-    colmap["volRemaining"] = DBTYPE_R8;
-    colmap["price"] = DBTYPE_CY;
-    colmap["issued"] = DBTYPE_FILETIME;
-
-    colmap["orderID"] = DBTYPE_I4;
-    colmap["volEntered"] = DBTYPE_I4;
-    colmap["minVolume"] = DBTYPE_I4;
-    colmap["stationID"] = DBTYPE_I4;
-    colmap["regionID"] = DBTYPE_I4;
-    colmap["solarSystemID"] = DBTYPE_I4;
-    colmap["jumps"] = DBTYPE_I4;
-
-    colmap["duration"] = DBTYPE_I2;
-    colmap["typeID"] = DBTYPE_I2;
-    colmap["range"] = DBTYPE_I2;
-
-    colmap["bid"] = DBTYPE_BOOL;
-
-    //ordering: (painstakingly determined from packets)
-    DBColumnOrdering ordering;
-    ordering.push_back("price");
-    ordering.push_back("volRemaining");
-    ordering.push_back("issued");
-    ordering.push_back("orderID");
-    ordering.push_back("volEntered");
-    ordering.push_back("minVolume");
-    ordering.push_back("stationID");
-    ordering.push_back("regionID");
-    ordering.push_back("solarSystemID");
-    ordering.push_back("jumps");    //not working right...
-    ordering.push_back("typeID");
-    ordering.push_back("range");
-    ordering.push_back("duration");
-    ordering.push_back("bid");*/
-
-    //query sell orders
-    //TODO: consider the `jumps` field... is it actually used? might be a pain in the ass if we need to actually populate it based on each queryier's location
-    if(!sDatabase.RunQuery(res,
-        "SELECT"
-        "    price, volRemaining, typeID, `range`, orderID,"
-        "   volEntered, minVolume, bid, issued, duration,"
-        "   stationID, regionID, solarSystemID, jumps"
-        " FROM market_orders "
-        " WHERE regionID=%u AND typeID=%u AND bid=%d", regionID, typeID, TransactionTypeSell))
-    {
-        codelog( MARKET__ERROR, "Error in query: %s", res.error.c_str() );
-
-        PyDecRef( tup );
-        return NULL;
-    }
-
-    //this is wrong.
-    tup->AddItem( DBResultToCRowset( res ) );
-
-    //query buy orders
-    if(!sDatabase.RunQuery(res,
-        "SELECT"
-        "    price, volRemaining, typeID, `range`, orderID,"
-        "   volEntered, minVolume, bid, issued, duration,"
-        "   stationID, regionID, solarSystemID, jumps"
-        " FROM market_orders "
-        " WHERE regionID=%u AND typeID=%u AND bid=%d", regionID, typeID, TransactionTypeBuy))
-    {
-        codelog( MARKET__ERROR, "Error in query: %s", res.error.c_str() );
-
-        PyDecRef( tup );
-        return NULL;
-    }
-
-    //this is wrong.
-    tup->AddItem( DBResultToCRowset( res ) );
-
-    return tup;
+    return sMarketOrderBook.GetOrders( regionID, typeID, fromSystemID );
 }
 
 PyRep *MarketDB::GetCharOrders(uint32 characterID) {
     DBQueryResult res;
 
+    //the orders are saved by the write-behind queue
+    sInventoryWriteBehind.Flush();
+
     if(!sDatabase.RunQuery(res,
         "SELECT"
         "   orderID, typeID, charID, regionID, stationID,"
@@ -196,27 +71,7 @@ PyRep *MarketDB::GetCharOrders(uint32 characterID) {
 }
 
 PyRep *MarketDB::GetOrderRow(uint32 orderID) {
-    DBQueryResult res;
-
-    if(!sDatabase.RunQuery(res,
-        "SELECT"
-        "    price, volRemaining, typeID, `range`, orderID,"
-        "   volEntered, minVolume, bid, issued, duration,"
-        "   stationID, regionID, solarSystemID, jumps"
-        " FROM market_orders"
-        " WHERE orderID=%u", orderID))
-    {
-        codelog(MARKET__ERROR, "Error in query: %s", res.error.c_str());
-        return NULL;
-    }
-
-    DBResultRow row;
-    if(!res.GetRow(row)) {
-        codelog(MARKET__ERROR, "Order %u not found.", orderID);
-        return NULL;
-    }
-
-    return(DBRowToPackedRow(row));
+    return sMarketOrderBook.GetOrderRow(orderID);
 }
 
 PyRep *MarketDB::GetOldPriceHistory(uint32 regionID, uint32 typeID) {
@@ -239,18 +94,28 @@ PyRep *MarketDB::GetOldPriceHistory(uint32 regionID, uint32 typeID) {
     ordering.push_back("volume");
     ordering.push_back("orders");*/
 
-    if(!sDatabase.RunQuery(res,
+    if(!sDatabase.RunReadQueryStream(res,
         "SELECT"
         "    historyDate, lowPrice, highPrice, avgPrice,"
         "    volume, orders "
         " FROM market_history_old "
-        " WHERE regionID=%u AND typeID=%u", regionID, typeID))
+        " WHERE regionID=%u AND typeID=%u"
+        " ORDER BY historyDate", regionID, typeID))
+    {
+        codelog(MARKET__ERROR, "Error in query: %s", res.error.c_str());
+        return NULL;
+    }
+
+    //the rows are streamed, the query may still fail on their way
+    PyRep *rowset = DBResultToCRowset(res);
+    if(res.error.GetErrNo() != 0)
     {
         codelog(MARKET__ERROR, "Error in query: %s", res.error.c_str());
+        PyDecRef(rowset);
         return NULL;
     }
 
-    return(DBResultToCRowset(res));
+    return rowset;
 }
 
 PyRep *MarketDB::GetNewPriceHistory(uint32 regionID, uint32 typeID) {
@@ -273,82 +138,95 @@ PyRep *MarketDB::GetNewPriceHistory(uint32 regionID, uint32 typeID) {
     ordering.push_back("volume");
     ordering.push_back("orders");*/
 
-    //build the history record from the recent market transactions.
-    //NOTE: it may be a good idea to cache the historyDate column in each
-    //record when they are inserted instead of re-calculating it each query.
-    // this would also allow us to put together an index as well...
-    if(!sDatabase.RunQuery(res,
+    //the daily records are kept up to date by RecordTransaction().
+    //read from the primary, a replica may not have the latest trade yet.
+    if(!sDatabase.RunQueryStream(res,
         "SELECT"
-        "    transactionDateTime - ( transactionDateTime %% %" PRId64 " ) AS historyDate,"
-        "    MIN(price) AS lowPrice,"
-        "    MAX(price) AS highPrice,"
-        "    AVG(price) AS avgPrice,"
-        "    CAST(SUM(quantity) AS SIGNED INTEGER) AS volume,"
-        "    CAST(COUNT(transactionID) AS SIGNED INTEGER) AS orders"
-        " FROM market_transactions "
+        "    historyDate, lowPrice, highPrice, avgPrice,"
+        "    volume, orders "
+        " FROM market_history_new "
         " WHERE regionID=%u AND typeID=%u"
-        "    AND transactionType=%d "    //both buy and sell transactions get recorded, only compound one set of data... choice was arbitrary.
-        " GROUP BY historyDate",
-        Win32Time_Day, regionID, typeID, TransactionTypeBuy))
+        " ORDER BY historyDate", regionID, typeID))
+    {
+        codelog(MARKET__ERROR, "Error in query: %s", res.error.c_str());
+        return NULL;
+    }
+
+    //the rows are streamed, the query may still fail on their way
+    PyRep *rowset = DBResultToCRowset(res);
+    if(res.error.GetErrNo() != 0)
     {
         codelog(MARKET__ERROR, "Error in query: %s", res.error.c_str());
+        PyDecRef(rowset);
         return NULL;
     }
 
-    return(DBResultToCRowset(res));
+    return rowset;
 }
 
-bool MarketDB::BuildOldPriceHistory() {
-    DBerror err;
+bool MarketDB::BuildOldPriceHistory(std::vector<std::pair<uint32, uint32> > &moved) {
+    DBQueryResult res;
 
     uint64 cutoff_time = Win32TimeNow();
     cutoff_time -= cutoff_time % Win32Time_Day;    //round down to an even day boundary.
     cutoff_time -= HISTORY_AGGREGATION_DAYS * Win32Time_Day;
 
-    //build the history record from the recent market transactions.
-    if(!sDatabase.RunQuery(err,
-        "INSERT INTO"
-        "    market_history_old"
-        "     (regionID, typeID, historyDate, lowPrice, highPrice, avgPrice, volume, orders)"
-        " SELECT"
-        "    regionID,"
-        "    typeID,"
-        "    transactionDateTime - ( transactionDateTime %% %" PRId64 " ) AS historyDate,"
-        "    MIN(price) AS lowPrice,"
-        "    MAX(price) AS highPrice,"
-        "    AVG(price) AS avgPrice,"
-        "    SUM(quantity) AS volume,"
-        "    COUNT(transactionID) AS orders"
-        " FROM market_transactions "
-        " WHERE"
-        "    transactionType=%d AND "    //both buy and sell transactions get recorded, only compound one set of data... choice was arbitrary.
-        "    ( transactionDateTime - ( transactionDateTime %% %" PRId64 " ) ) < %" PRId64
-        " GROUP BY regionID, typeID, historyDate",
-            Win32Time_Day,
-            TransactionTypeBuy,
-            Win32Time_Day,
-            cutoff_time
-            ))
+    //find out whose history is about to change.
+    if(!sDatabase.RunQuery(res,
+        "SELECT DISTINCT regionID, typeID"
+        " FROM market_history_new"
+        " WHERE historyDate < %" PRIu64,
+        cutoff_time))
     {
-        codelog(MARKET__ERROR, "Error in query: %s", err.c_str());
+        codelog(MARKET__ERROR, "Error in query: %s", res.error.c_str());
         return false;
     }
 
-    //now remove the transactions which have been aged out?
-    if(!sDatabase.RunQuery(err,
-        "DELETE FROM"
-        "    market_transactions"
-        " WHERE"
-        "    historyDate < %" PRId64,
-        cutoff_time))
+    moved.clear();
+
+    DBResultRow row;
+    while(res.GetRow(row))
+        moved.push_back(std::make_pair(row.GetUInt(0), row.GetUInt(1)));
+
+    if(moved.empty())
+        return true;
+
+    //move the daily records which have been aged out, all or none of them.
+    char buf[512];
+    std::vector<std::string> queries;
+
+    snprintf(buf, sizeof(buf),
+        "INSERT INTO"
+        "    market_history_old"
+        "     (regionID, typeID, historyDate, lowPrice, highPrice, avgPrice, volume, orders)"
+        " SELECT"
+        "    regionID, typeID, historyDate, lowPrice, highPrice, avgPrice, volume, orders"
+        " FROM market_history_new"
+        " WHERE historyDate < %" PRIu64,
+        cutoff_time);
+    //once moved, the records are never touched again; a retry after a failure leaves them the same.
+    queries.push_back(std::string(buf) +
+        " ON DUPLICATE KEY UPDATE"
+        "    lowPrice = VALUES(lowPrice), highPrice = VALUES(highPrice), avgPrice = VALUES(avgPrice),"
+        "    volume = VALUES(volume), orders = VALUES(orders)");
+
+    snprintf(buf, sizeof(buf),
+        "DELETE FROM market_history_new"
+        " WHERE historyDate < %" PRIu64,
+        cutoff_time);
+    queries.push_back(buf);
 
+    DBerror err;
+    if(!sDatabase.RunTransaction(err, queries))
     {
         codelog(MARKET__ERROR, "Error in query: %s", err.c_str());
+        moved.clear();
         return false;
     }
 
     return true;
 }
+
 PyObject *MarketDB::GetCorporationBills(uint32 corpID, bool payable)
 {
     DBQueryResult res;
@@ -594,32 +472,8 @@ uint32 MarketDB::FindBuyOrder(
     uint32 quantity,
     uint32 orderRange
 ) {
-    DBQueryResult res;
-
-    if(!sDatabase.RunQuery(res,
-        "SELECT orderID"
-        "    FROM market_orders"
-        "    WHERE bid=1"
-        "        AND typeID=%u"
-        "        AND stationID=%u"
-        "        AND volRemaining >= %u"
-        "        AND price <= %f"
-        "    ORDER BY price DESC"
-        "    LIMIT 1",    //right now, we just care about the first order which can satisfy our needs.
-        typeID,
-        stationID,
-        quantity,
-        price))
-    {
-        codelog(MARKET__ERROR, "Error in query: %s", res.error.c_str());
-        return false;
-    }
-
-    DBResultRow row;
-    if(!res.GetRow(row))
-        return(0);    //no order found.
-
-    return(row.GetUInt(0));
+    //right now, we just care about the first order which can satisfy our needs.
+    return sMarketOrderBook.FindBuyOrder(stationID, typeID, price, quantity);
 }
 
 uint32 MarketDB::FindSellOrder(
@@ -629,90 +483,39 @@ uint32 MarketDB::FindSellOrder(
     uint32 quantity,
     uint32 orderRange
 ) {
-    DBQueryResult res;
-
-    if(!sDatabase.RunQuery(res,
-        "SELECT orderID"
-        "    FROM market_orders"
-        "    WHERE bid=0"
-        "        AND typeID=%u"
-        "        AND stationID=%u"
-        "        AND volRemaining >= %u"
-        "        AND price <= %f"
-        "    ORDER BY price ASC"
-        "    LIMIT 1",    //right now, we just care about the first order which can satisfy our needs.
-        typeID,
-        stationID,
-        quantity,
-        price))
-    {
-        codelog(MARKET__ERROR, "Error in query: %s", res.error.c_str());
-        return false;
-    }
-
-    DBResultRow row;
-    if(!res.GetRow(row))
-        return(0);    //no order found.
-
-    return(row.GetUInt(0));
+    //right now, we just care about the first order which can satisfy our needs.
+    return sMarketOrderBook.FindSellOrder(stationID, typeID, price, quantity);
 }
 
 bool MarketDB::GetOrderInfo(uint32 orderID, uint32 *orderOwnerID, uint32 *typeID, uint32 *stationID, uint32 *quantity, double *price, bool *isBuy, bool *isCorp) {
-    DBQueryResult res;
-
-    if(!sDatabase.RunQuery(res,
-        "SELECT"
-        " volRemaining,"
-        " price,"
-        " typeID,"
-        " stationID,"
-        " charID,"
-        " bid,"
-        " isCorp"
-        " FROM market_orders"
-        " WHERE orderID=%u",
-        orderID))
-    {
-        _log(MARKET__ERROR, "Error in query: %s.", res.error.c_str());
-        return false;
-    }
-
-    DBResultRow row;
-    if(!res.GetRow(row)) {
+    const MarketOrder *order = sMarketOrderBook.GetOrder(orderID);
+    if(order == NULL) {
         _log(MARKET__ERROR, "Order %u not found.", orderID);
         return false;
     }
 
     if(quantity != NULL)
-        *quantity = row.GetUInt(0);
+        *quantity = order->volRemaining;
     if(price != NULL)
-        *price = row.GetDouble(1);
+        *price = order->price;
     if(typeID != NULL)
-        *typeID = row.GetUInt(2);
+        *typeID = order->typeID;
     if(stationID != NULL)
-        *stationID = row.GetUInt(3);
+        *stationID = order->stationID;
     if(orderOwnerID != NULL)
-        *orderOwnerID = row.GetUInt(4);
+        *orderOwnerID = order->charID;
     if(isBuy != NULL)
-        *isBuy = row.GetInt(5) ? true : false;
+        *isBuy = order->bid;
     if(isCorp != NULL)
-        *isCorp = row.GetInt(6) ? true : false;
+        *isCorp = order->isCorp;
 
     return true;
 }
 
 //NOTE: this logic needs some work if there are multiple concurrent market services running at once.
 bool MarketDB::AlterOrderQuantity(uint32 orderID, uint32 new_qty) {
-    DBerror err;
-
-    if(!sDatabase.RunQuery(err,
-        "UPDATE"
-        " market_orders"
-        " SET volRemaining = %u"
-        " WHERE orderID = %u",
-        new_qty, orderID))
-    {
-        _log(MARKET__ERROR, "Error in query: %s.", err.c_str());
+    if(!sMarketOrderBook.SetVolumeRemaining(orderID, new_qty)) {
+        _log(MARKET__ERROR, "Order %u not found.", orderID);
         return false;
     }
 
@@ -720,16 +523,8 @@ bool MarketDB::AlterOrderQuantity(uint32 orderID, uint32 new_qty) {
 }
 
 bool MarketDB::AlterOrderPrice(uint32 orderID, double new_price) {
-    DBerror err;
-
-    if(!sDatabase.RunQuery(err,
-        "UPDATE"
-        " market_orders"
-        " SET price = %f"
-        " WHERE orderID = %u",
-        new_price, orderID))
-    {
-        _log(MARKET__ERROR, "Error in query: %s.", err.c_str());
+    if(!sMarketOrderBook.SetPrice(orderID, new_price)) {
+        _log(MARKET__ERROR, "Order %u not found.", orderID);
         return false;
     }
 
@@ -737,15 +532,8 @@ bool MarketDB::AlterOrderPrice(uint32 orderID, double new_price) {
 }
 
 bool MarketDB::DeleteOrder(uint32 orderID) {
-    DBerror err;
-
-    if(!sDatabase.RunQuery(err,
-        "DELETE"
-        " FROM market_orders"
-        " WHERE orderID = %u",
-        orderID))
-    {
-        _log(MARKET__ERROR, "Error in query: %s.", err.c_str());
+    if(!sMarketOrderBook.RemoveOrder(orderID)) {
+        _log(MARKET__ERROR, "Order %u not found.", orderID);
         return false;
     }
 
@@ -754,16 +542,13 @@ bool MarketDB::DeleteOrder(uint32 orderID) {
 
 bool MarketDB::AddCharacterBalance(uint32 char_id, double delta)
 {
-    DBerror err;
-
-    if(!sDatabase.RunQuery(err,
-        "UPDATE character_ SET balance=balance+%.2f WHERE characterID=%u",delta,char_id))
-    {
-        _log(SERVICE__ERROR, "Error in query : %s", err.c_str());
-        return false;
-    }
+    char buf[128];
+    snprintf(buf, sizeof(buf),
+        "UPDATE character_ SET balance=balance+%.2f WHERE characterID=%u", delta, char_id);
 
-    return (true);
+    //written along with the rest of the trade
+    sMarketJournal.Append(buf);
+    return true;
 }
 
 bool MarketDB::RecordTransaction(
@@ -775,9 +560,10 @@ bool MarketDB::RecordTransaction(
     uint32 regionID,
     uint32 stationID
 ) {
-    DBerror err;
+    const uint64 now = Win32TimeNow();
 
-    if(!sDatabase.RunQuery(err,
+    char buf[512];
+    snprintf(buf, sizeof(buf),
         "INSERT INTO"
         " market_transactions ("
         "    transactionID, transactionDateTime, typeID, quantity,"
@@ -787,13 +573,35 @@ bool MarketDB::RecordTransaction(
         "    NULL, %" PRIu64 ", %u, %u,"
         "    %f, %d, %u, %u, %u, 0"
         " )",
-            Win32TimeNow(), typeID, quantity,
+            now, typeID, quantity,
             price, transactionType, charID, regionID, stationID
-            ))
-    {
-        codelog(MARKET__ERROR, "Error in query: %s", err.c_str());
-        return false;
-    }
+            );
+    sMarketJournal.Append(buf);
+
+    //both buy and sell transactions get recorded, only compound one set of data... choice was arbitrary.
+    if(transactionType == TransactionTypeBuy) {
+        //add the trade to its daily record; the assignments are done in order,
+        //so the average is updated before the count it depends on.
+        snprintf(buf, sizeof(buf),
+            "INSERT INTO"
+            " market_history_new ("
+            "    regionID, typeID, historyDate, lowPrice, highPrice, avgPrice, volume, orders"
+            " ) VALUES ("
+            "    %u, %u, %" PRIu64 ", %f, %f, %f, %u, 1"
+            " )"
+            " ON DUPLICATE KEY UPDATE"
+            "    lowPrice = LEAST(lowPrice, VALUES(lowPrice)),"
+            "    highPrice = GREATEST(highPrice, VALUES(highPrice)),"
+            "    avgPrice = avgPrice + (VALUES(avgPrice) - avgPrice) / (orders + 1),"
+            "    volume = volume + VALUES(volume),"
+            "    orders = orders + 1",
+                regionID, typeID, now - ( now % Win32Time_Day ),
+                price, price, price, quantity
+                );
+        sMarketJournal.Append(buf);
+    }
+
+    //written by the journal, exactly once
     return true;
 }
 
@@ -810,8 +618,6 @@ uint32 MarketDB::_StoreOrder(
     bool isCorp,
     bool isBuy
 ) {
-    DBerror err;
-
     uint32 solarSystemID;
     uint32 regionID;
     if(!GetStationInfo(stationID, &solarSystemID, NULL, &regionID, NULL, NULL, NULL)) {
@@ -822,31 +628,28 @@ uint32 MarketDB::_StoreOrder(
     //TODO: figure out what the orderState field means...
     //TODO: implement the contraband flag properly.
     //TODO: implement the isCorp flag properly.
-    uint32 orderID;
-    if(!sDatabase.RunQueryLID(err, orderID,
-        "INSERT INTO market_orders ("
-        "    typeID, charID, regionID, stationID,"
-        "    `range`, bid, price, volEntered, volRemaining, issued,"
-        "    orderState, minVolume, contraband, accountID, duration,"
-        "    isCorp, solarSystemID, escrow, jumps "
-        " ) VALUES ("
-        "    %u, %u, %u, %u, "
-        "    %u, %u, %f, %u, %u, %" PRIu64 ", "
-        "    1, %u, 0, %u, %u, "
-        "    %u, %u, 0, 1"
-        " )",
-            typeID, clientID, regionID, stationID,
-            orderRange, isBuy?1:0, price, quantity, quantity, Win32TimeNow(),
-            minVolume, accountID, duration,
-            isCorp?1:0, solarSystemID
-        ))
-
-    {
-        codelog(MARKET__ERROR, "Error in query: %s", err.c_str());
-        return(0);
-    }
-
-    return(orderID);
+    MarketOrder order;
+    order.typeID = typeID;
+    order.charID = clientID;
+    order.regionID = regionID;
+    order.stationID = stationID;
+    order.solarSystemID = solarSystemID;
+    order.range = orderRange;
+    order.bid = isBuy;
+    order.price = price;
+    order.volEntered = quantity;
+    order.volRemaining = quantity;
+    order.issued = Win32TimeNow();
+    order.orderState = 1;
+    order.minVolume = minVolume;
+    order.contraband = false;
+    order.accountID = accountID;
+    order.duration = duration;
+    order.isCorp = isCorp;
+    order.escrow = false;
+    order.jumps = 1;
+
+    return sMarketOrderBook.AddOrder(order);
 }
 
 PyRep *MarketDB::GetTransactions(uint32 characterID, uint32 typeID, uint32 quantity, double minPrice, double maxPrice, uint64 fromDate, int buySell)
@@ -0,0 +1,280 @@
+/*
+    ------------------------------------------------------------------------------------
+    LICENSE:
+    ------------------------------------------------------------------------------------
+    This file is part of EVEmu: EVE Online Server Emulator
+    Copyright 2006 - 2011 The EVEmu Team
+    For the latest information visit http://evemu.org
+    ------------------------------------------------------------------------------------
+    This program is free software; you can redistribute it and/or modify it under
+    the terms of the GNU Lesser General Public License as published by the Free Software
+    Foundation; either version 2 of the License, or (at your option) any later
+    version.
+
+    This program is distributed in the hope that it will be useful, but WITHOUT
+    ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+    FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public License along with
+    this program; if not, write to the Free Software Foundation, Inc., 59 Temple
+    Place - Suite 330, Boston, MA 02111-1307, USA, or go to
+    http://www.gnu.org/copyleft/lesser.txt.
+    ------------------------------------------------------------------------------------
+    Author:     EVEmu Team
+*/
+
+#include "eve-server.h"
+
+#include "market/MarketJournal.h"
+
+MarketJournal::MarketJournal()
+: mFile( NULL ),
+  mTradeDepth( 0 ),
+  mSequence( 0 ),
+  mFlushInterval( 0 ),
+  mFirstQueued( 0 )
+{
+}
+
+MarketJournal::~MarketJournal()
+{
+    if( NULL != mFile )
+        fclose( mFile );
+}
+
+bool MarketJournal::Open( const std::string& path )
+{
+    uint64 written;
+    if( !_ReadSequence( written ) )
+        return false;
+
+    mSequence = written;
+    mPath = path;
+    if( mPath.empty() )
+        return true;
+
+    // the trades left over by the last run
+    std::string contents;
+    FILE* file = fopen( mPath.c_str(), "rb" );
+    if( NULL != file )
+    {
+        char buf[ 4096 ];
+        size_t len;
+        while( 0 < ( len = fread( buf, 1, sizeof( buf ), file ) ) )
+            contents.append( buf, len );
+
+        fclose( file );
+    }
+
+    std::vector<std::string> statements, trade;
+    uint64 sequence = 0;
+    bool inTrade = false;
+    uint32 trades = 0;
+
+    size_t begin = 0;
+    while( begin < contents.size() )
+    {
+        size_t end = contents.find( '\n', begin );
+        if( std::string::npos == end )
+            // cut short by the crash
+            break;
+
+        const std::string line = contents.substr( begin, end - begin );
+        begin = end + 1;
+
+        if( 0 == line.compare( 0, 2, "T " ) )
+        {
+            // a trade without its end was cut short as well
+            trade.clear();
+            sequence = strtoull( line.c_str() + 2, NULL, 10 );
+            inTrade = true;
+        }
+        else if( "C" == line )
+        {
+            if( inTrade && written < sequence )
+            {
+                statements.insert( statements.end(), trade.begin(), trade.end() );
+                if( mSequence < sequence )
+                    mSequence = sequence;
+                ++trades;
+            }
+
+            trade.clear();
+            inTrade = false;
+        }
+        else if( inTrade )
+            trade.push_back( line );
+    }
+
+    if( !statements.empty() )
+    {
+        if( !_Write( statements, mSequence ) )
+        {
+            sLog.Error( "MarketJournal", "Failed to write %u trades left in %s.", trades, mPath.c_str() );
+            return false;
+        }
+
+        mStats.replayed += trades;
+        sLog.Success( "MarketJournal", "Wrote %u trades left in %s.", trades, mPath.c_str() );
+    }
+
+    // everything in the file is written now
+    return _Truncate();
+}
+
+void MarketJournal::SetFlushInterval( uint32 interval )
+{
+    mFlushInterval = interval;
+
+    // nothing may stay unwritten once disabled
+    if( 0 == mFlushInterval )
+        Flush();
+}
+
+void MarketJournal::BeginTrade()
+{
+    ++mTradeDepth;
+}
+
+void MarketJournal::Append( const std::string& statement )
+{
+    mTrade.push_back( statement );
+
+    // a statement is a line of the file
+    std::string& added = mTrade.back();
+    std::replace( added.begin(), added.end(), '\n', ' ' );
+
+    if( 0 == mTradeDepth )
+    {
+        BeginTrade();
+        CommitTrade();
+    }
+}
+
+void MarketJournal::CommitTrade()
+{
+    if( 0 < mTradeDepth && 0 < --mTradeDepth )
+        return;
+    if( mTrade.empty() )
+        return;
+
+    ++mSequence;
+
+    // the file is synced by Flush(), once for all the trades since the last one
+    if( NULL != mFile )
+    {
+        fprintf( mFile, "T %" PRIu64 "\n", mSequence );
+        for( size_t i = 0; i < mTrade.size(); ++i )
+        {
+            fputs( mTrade[ i ].c_str(), mFile );
+            fputc( '\n', mFile );
+        }
+        fputs( "C\n", mFile );
+
+        if( 0 != fflush( mFile ) )
+            sLog.Error( "MarketJournal", "Failed to append trade %" PRIu64 " to %s.", mSequence, mPath.c_str() );
+    }
+
+    if( mPending.empty() )
+        mFirstQueued = Timer::GetCurrentTime();
+
+    ++mStats.trades;
+    mStats.statements += (uint32)mTrade.size();
+
+    mPending.insert( mPending.end(), mTrade.begin(), mTrade.end() );
+    mTrade.clear();
+
+    if( 0 == mFlushInterval )
+        Flush();
+}
+
+void MarketJournal::Process( uint32 now )
+{
+    if( IsPending() && mFlushInterval <= now - mFirstQueued )
+        Flush();
+}
+
+bool MarketJournal::Flush()
+{
+    if( !IsPending() )
+        return true;
+
+    // the group commit
+    if( NULL != mFile && 0 != fsync( fileno( mFile ) ) )
+        sLog.Error( "MarketJournal", "Failed to sync %s.", mPath.c_str() );
+
+    if( !_Write( mPending, mSequence ) )
+    {
+        // the trades stay in memory and in the file; try again later
+        mFirstQueued = Timer::GetCurrentTime();
+
+        ++mStats.failures;
+        return false;
+    }
+
+    mPending.clear();
+    ++mStats.flushes;
+
+    return _Truncate();
+}
+
+bool MarketJournal::_ReadSequence( uint64& into )
+{
+    DBQueryResult res;
+    if( !sDatabase.RunQuery( res,
+        "SELECT sequence"
+        " FROM market_journal_sequence"
+        " WHERE journalID = 0" ) )
+    {
+        sLog.Error( "MarketJournal", "Error in query: %s", res.error.c_str() );
+        return false;
+    }
+
+    DBResultRow row;
+    if( res.GetRow( row ) )
+        into = row.GetUInt64( 0 );
+    else
+        into = 0;
+
+    return true;
+}
+
+bool MarketJournal::_Write( const std::vector<std::string>& statements, uint64 sequence )
+{
+    std::vector<std::string> queries( statements );
+
+    char buf[ 256 ];
+    snprintf( buf, sizeof( buf ),
+        "INSERT INTO market_journal_sequence (journalID, sequence)"
+        " VALUES (0, %" PRIu64 ")"
+        " ON DUPLICATE KEY UPDATE sequence = VALUES(sequence)",
+        sequence );
+    queries.push_back( buf );
+
+    DBerror err;
+    if( !sDatabase.RunTransaction( err, queries ) )
+    {
+        sLog.Error( "MarketJournal", "Failed to write %lu statements: %s", (unsigned long)statements.size(), err.c_str() );
+        return false;
+    }
+
+    return true;
+}
+
+bool MarketJournal::_Truncate()
+{
+    if( mPath.empty() )
+        return true;
+
+    if( NULL != mFile )
+        fclose( mFile );
+
+    mFile = fopen( mPath.c_str(), "wb" );
+    if( NULL == mFile )
+    {
+        sLog.Error( "MarketJournal", "Failed to open %s; the trades are not kept in a file.", mPath.c_str() );
+        return false;
+    }
+
+    return true;
+}
@@ -0,0 +1,467 @@
+/*
+    ------------------------------------------------------------------------------------
+    LICENSE:
+    ------------------------------------------------------------------------------------
+    This file is part of EVEmu: EVE Online Server Emulator
+    Copyright 2006 - 2011 The EVEmu Team
+    For the latest information visit http://evemu.org
+    ------------------------------------------------------------------------------------
+    This program is free software; you can redistribute it and/or modify it under
+    the terms of the GNU Lesser General Public License as published by the Free Software
+    Foundation; either version 2 of the License, or (at your option) any later
+    version.
+
+    This program is distributed in the hope that it will be useful, but WITHOUT
+    ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+    FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public License along with
+    this program; if not, write to the Free Software Foundation, Inc., 59 Temple
+    Place - Suite 330, Boston, MA 02111-1307, USA, or go to
+    http://www.gnu.org/copyleft/lesser.txt.
+    ------------------------------------------------------------------------------------
+    Author:     EVEmu Team
+*/
+
+#include "eve-server.h"
+
+#include "inventory/InventoryWriteBehind.h"
+#include "map/RouteMap.h"
+#include "market/MarketOrderBook.h"
+
+/// Columns of the order rows, in the order the client expects them.
+static DBRowDescriptor* NewOrderRowDescriptor()
+{
+    DBRowDescriptor* header = new DBRowDescriptor();
+    header->AddColumn( "price",         DBTYPE_R8 );
+    header->AddColumn( "volRemaining",  DBTYPE_UI4 );
+    header->AddColumn( "typeID",        DBTYPE_UI4 );
+    header->AddColumn( "range",         DBTYPE_UI4 );
+    header->AddColumn( "orderID",       DBTYPE_UI4 );
+    header->AddColumn( "volEntered",    DBTYPE_UI4 );
+    header->AddColumn( "minVolume",     DBTYPE_UI4 );
+    header->AddColumn( "bid",           DBTYPE_UI1 );
+    header->AddColumn( "issued",        DBTYPE_UI8 );
+    header->AddColumn( "duration",      DBTYPE_UI4 );
+    header->AddColumn( "stationID",     DBTYPE_UI4 );
+    header->AddColumn( "regionID",      DBTYPE_UI4 );
+    header->AddColumn( "solarSystemID", DBTYPE_I4 );
+    header->AddColumn( "jumps",         DBTYPE_I1 );
+    return header;
+}
+
+static void FillOrderRow( const MarketOrder& order, PyPackedRow* into, int32 jumps )
+{
+    into->SetField( (uint32)0,  new PyFloat( order.price ) );
+    into->SetField( 1,  new PyInt( order.volRemaining ) );
+    into->SetField( 2,  new PyInt( order.typeID ) );
+    into->SetField( 3,  new PyInt( order.range ) );
+    into->SetField( 4,  new PyInt( order.orderID ) );
+    into->SetField( 5,  new PyInt( order.volEntered ) );
+    into->SetField( 6,  new PyInt( order.minVolume ) );
+    into->SetField( 7,  new PyInt( order.bid ? 1 : 0 ) );
+    into->SetField( 8,  new PyLong( (int64)order.issued ) );
+    into->SetField( 9,  new PyInt( order.duration ) );
+    into->SetField( 10, new PyInt( order.stationID ) );
+    into->SetField( 11, new PyInt( order.regionID ) );
+    into->SetField( 12, new PyInt( order.solarSystemID ) );
+    into->SetField( 13, new PyInt( jumps ) );
+}
+
+MarketOrderBook::MarketOrderBook()
+: mNextOrderID( 1 )
+{
+}
+
+bool MarketOrderBook::Load()
+{
+    DBQueryResult res;
+    if( !sDatabase.RunQuery( res,
+        "SELECT"
+        "   orderID, typeID, charID, regionID, stationID, solarSystemID,"
+        "   `range`, bid, price, volEntered, volRemaining, issued,"
+        "   orderState, minVolume, contraband, accountID, duration,"
+        "   isCorp, escrow, jumps"
+        " FROM market_orders" ) )
+    {
+        codelog( MARKET__ERROR, "Error in query: %s", res.error.c_str() );
+        return false;
+    }
+
+    mOrders.clear();
+    mRegionBooks.clear();
+    mStationBooks.clear();
+    mSystemAsks.clear();
+    mNextOrderID = 1;
+
+    DBResultRow row;
+    while( res.GetRow( row ) )
+    {
+        MarketOrder order;
+        order.orderID = row.GetUInt( 0 );
+        order.typeID = row.GetUInt( 1 );
+        order.charID = row.GetUInt( 2 );
+        order.regionID = row.GetUInt( 3 );
+        order.stationID = row.GetUInt( 4 );
+        order.solarSystemID = row.GetUInt( 5 );
+        order.range = row.GetUInt( 6 );
+        order.bid = ( 0 != row.GetInt( 7 ) );
+        order.price = row.GetDouble( 8 );
+        order.volEntered = row.GetUInt( 9 );
+        order.volRemaining = row.GetUInt( 10 );
+        order.issued = row.GetUInt64( 11 );
+        order.orderState = row.GetUInt( 12 );
+        order.minVolume = row.GetUInt( 13 );
+        order.contraband = ( 0 != row.GetInt( 14 ) );
+        order.accountID = row.GetUInt( 15 );
+        order.duration = row.GetUInt( 16 );
+        order.isCorp = ( 0 != row.GetInt( 17 ) );
+        order.escrow = ( 0 != row.GetInt( 18 ) );
+        order.jumps = row.GetInt( 19 );
+
+        _Insert( order );
+
+        if( mNextOrderID <= order.orderID )
+            mNextOrderID = order.orderID + 1;
+    }
+
+    return true;
+}
+
+const MarketOrder* MarketOrderBook::GetOrder( uint32 orderID ) const
+{
+    std::tr1::unordered_map< uint32, MarketOrder >::const_iterator res = mOrders.find( orderID );
+    if( res == mOrders.end() )
+        return NULL;
+
+    return &res->second;
+}
+
+uint32 MarketOrderBook::AddOrder( MarketOrder& order )
+{
+    order.orderID = mNextOrderID++;
+    _Insert( order );
+    _Save( order );
+
+    ++mStats.placed;
+    return order.orderID;
+}
+
+bool MarketOrderBook::SetVolumeRemaining( uint32 orderID, uint32 volRemaining )
+{
+    MarketOrder* order = _FindOrder( orderID );
+    if( NULL == order )
+        return false;
+
+    // the volume is not part of the priority
+    order->volRemaining = volRemaining;
+    _Save( *order );
+
+    return true;
+}
+
+bool MarketOrderBook::SetPrice( uint32 orderID, double price )
+{
+    MarketOrder* order = _FindOrder( orderID );
+    if( NULL == order )
+        return false;
+
+    MarketOrder changed = *order;
+    changed.price = price;
+
+    _Erase( *order );
+    _Insert( changed );
+    _Save( changed );
+
+    return true;
+}
+
+bool MarketOrderBook::RemoveOrder( uint32 orderID )
+{
+    MarketOrder* order = _FindOrder( orderID );
+    if( NULL == order )
+        return false;
+
+    _Erase( *order );
+
+    sInventoryWriteBehind.EraseMarketOrder( orderID );
+    if( !sInventoryWriteBehind.IsEnabled() )
+        sInventoryWriteBehind.Flush();
+
+    ++mStats.removed;
+    return true;
+}
+
+void MarketOrderBook::RemoveCharacterOrders( uint32 charID )
+{
+    std::vector< uint32 > orderIDs;
+
+    std::tr1::unordered_map< uint32, MarketOrder >::const_iterator cur, end;
+    cur = mOrders.begin();
+    end = mOrders.end();
+    for(; cur != end; ++cur )
+        if( cur->second.charID == charID )
+            orderIDs.push_back( cur->first );
+
+    for( size_t i = 0; i < orderIDs.size(); ++i )
+        RemoveOrder( orderIDs[ i ] );
+}
+
+uint32 MarketOrderBook::FindBuyOrder( uint32 stationID, uint32 typeID, double price, uint32 quantity )
+{
+    return _FindMatch( stationID, typeID, true, price, quantity );
+}
+
+uint32 MarketOrderBook::FindSellOrder( uint32 stationID, uint32 typeID, double price, uint32 quantity )
+{
+    return _FindMatch( stationID, typeID, false, price, quantity );
+}
+
+PyRep* MarketOrderBook::GetOrders( uint32 regionID, uint32 typeID, uint32 fromSystemID ) const
+{
+    PyList* orders = new PyList();
+
+    BookMap::const_iterator res = mRegionBooks.find( _BookKey( regionID, typeID ) );
+    for( int side = 0; side < 2; ++side )
+    {
+        DBRowDescriptor* header = NewOrderRowDescriptor();
+        CRowSet* rowset = new CRowSet( &header );
+
+        if( res != mRegionBooks.end() )
+        {
+            // sell orders first
+            const OrderSet& set = ( 0 == side ? res->second.sells : res->second.buys );
+
+            OrderSet::const_iterator cur, end;
+            cur = set.begin();
+            end = set.end();
+            for(; cur != end; ++cur )
+            {
+                const MarketOrder& order = *cur->order;
+
+                int32 jumps = order.jumps;
+                if( 0 != fromSystemID )
+                    jumps = sRouteMap.GetJumps( fromSystemID, order.solarSystemID );
+
+                FillOrderRow( order, rowset->NewRow(), jumps );
+            }
+        }
+
+        //this is wrong.
+        orders->AddItem( rowset );
+    }
+
+    return orders;
+}
+
+PyPackedRow* MarketOrderBook::GetOrderRow( uint32 orderID ) const
+{
+    const MarketOrder* order = GetOrder( orderID );
+    if( NULL == order )
+    {
+        codelog( MARKET__ERROR, "Order %u not found.", orderID );
+        return NULL;
+    }
+
+    PyPackedRow* row = new PyPackedRow( NewOrderRowDescriptor() );
+    FillOrderRow( *order, row, order->jumps );
+    return row;
+}
+
+PyRep* MarketOrderBook::GetStationAsks( uint32 stationID ) const
+{
+    return _GetAsks( mStationBooks, stationID );
+}
+
+PyRep* MarketOrderBook::GetSystemAsks( uint32 solarSystemID ) const
+{
+    return _GetAsks( mSystemAsks, solarSystemID );
+}
+
+PyRep* MarketOrderBook::GetRegionBest( uint32 regionID ) const
+{
+    return _GetAsks( mRegionBooks, regionID );
+}
+
+MarketOrderBook::OrderKey MarketOrderBook::_OrderKey( const MarketOrder& order )
+{
+    OrderKey key;
+    key.rank = ( order.bid ? -order.price : order.price );
+    key.issued = order.issued;
+    key.orderID = order.orderID;
+    key.order = NULL;
+    return key;
+}
+
+void MarketOrderBook::_Insert( const MarketOrder& order )
+{
+    std::pair< std::tr1::unordered_map< uint32, MarketOrder >::iterator, bool > res =
+        mOrders.insert( std::make_pair( order.orderID, order ) );
+    if( !res.second )
+    {
+        // replacing the order, so it has to leave its old place first
+        _Erase( res.first->second );
+        res = mOrders.insert( std::make_pair( order.orderID, order ) );
+    }
+
+    OrderKey key = _OrderKey( order );
+    key.order = &res.first->second;
+
+    Book& region = mRegionBooks[ _BookKey( order.regionID, order.typeID ) ];
+    Book& station = mStationBooks[ _BookKey( order.stationID, order.typeID ) ];
+    if( order.bid )
+    {
+        region.buys.insert( key );
+        station.buys.insert( key );
+    }
+    else
+    {
+        region.sells.insert( key );
+        station.sells.insert( key );
+        mSystemAsks[ _BookKey( order.solarSystemID, order.typeID ) ].insert( key );
+    }
+}
+
+void MarketOrderBook::_Erase( const MarketOrder& order )
+{
+    const OrderKey key = _OrderKey( order );
+
+    BookMap::iterator region = mRegionBooks.find( _BookKey( order.regionID, order.typeID ) );
+    if( region != mRegionBooks.end() )
+    {
+        ( order.bid ? region->second.buys : region->second.sells ).erase( key );
+        if( region->second.empty() )
+            mRegionBooks.erase( region );
+    }
+
+    BookMap::iterator station = mStationBooks.find( _BookKey( order.stationID, order.typeID ) );
+    if( station != mStationBooks.end() )
+    {
+        ( order.bid ? station->second.buys : station->second.sells ).erase( key );
+        if( station->second.empty() )
+            mStationBooks.erase( station );
+    }
+
+    if( !order.bid )
+    {
+        AskMap::iterator system = mSystemAsks.find( _BookKey( order.solarSystemID, order.typeID ) );
+        if( system != mSystemAsks.end() )
+        {
+            system->second.erase( key );
+            if( system->second.empty() )
+                mSystemAsks.erase( system );
+        }
+    }
+
+    // the order itself goes last; order may refer to it
+    mOrders.erase( key.orderID );
+}
+
+void MarketOrderBook::_Save( const MarketOrder& order )
+{
+    sInventoryWriteBehind.SaveMarketOrder( order );
+
+    // written through right away unless the saves are batched
+    if( !sInventoryWriteBehind.IsEnabled() )
+        sInventoryWriteBehind.Flush();
+}
+
+MarketOrder* MarketOrderBook::_FindOrder( uint32 orderID )
+{
+    std::tr1::unordered_map< uint32, MarketOrder >::iterator res = mOrders.find( orderID );
+    if( res == mOrders.end() )
+        return NULL;
+
+    return &res->second;
+}
+
+//NOTE: orderRange is not implemented; only the orders at the station are matched.
+uint32 MarketOrderBook::_FindMatch( uint32 stationID, uint32 typeID, bool bid, double price, uint32 quantity )
+{
+    BookMap::const_iterator res = mStationBooks.find( _BookKey( stationID, typeID ) );
+    if( res != mStationBooks.end() )
+    {
+        const OrderSet& set = ( bid ? res->second.buys : res->second.sells );
+
+        // best first, so the first one which takes the whole quantity wins
+        OrderSet::const_iterator cur, end;
+        cur = set.begin();
+        end = set.end();
+        for(; cur != end; ++cur )
+        {
+            const MarketOrder& order = *cur->order;
+            if( bid ? order.price < price : order.price > price )
+                break;
+
+            if( quantity <= order.volRemaining )
+            {
+                ++mStats.matched;
+                return order.orderID;
+            }
+        }
+    }
+
+    ++mStats.unmatched;
+    return 0;
+}
+
+PyRep* MarketOrderBook::_GetAsks( const AskMap& asks, uint32 locationID ) const
+{
+    //NOTE: this SHOULD return a crazy dbutil.RowDict object which is
+    //made up of packed blue.DBRow objects, but we do not understand
+    //the marshalling of those well enough right now, and this object
+    //provides the same interface. It is significantly bigger on the wire though.
+    static const MarshalStringToken type( "util.IndexRowset" );
+
+    PyDict* args = new PyDict();
+    PyObject* res = new PyObject( new PyString( type ), args );
+
+    PyList* header = new PyList( 4 );
+    header->SetItem( 0, PyStatic::InternString( "typeID" ) );
+    header->SetItem( 1, PyStatic::InternString( "price" ) );
+    header->SetItem( 2, PyStatic::InternString( "volRemaining" ) );
+    header->SetItem( 3, PyStatic::InternString( "stationID" ) );
+    args->SetItem( PyStatic::NewString( "header" ), header );
+    args->SetItem( PyStatic::NewString( "RowClass" ), new PyToken( "util.Row" ) );
+    args->SetItem( PyStatic::NewString( "idName" ), new PyString( "typeID" ) );
+
+    PyDict* items = new PyDict();
+    args->SetItem( PyStatic::NewString( "items" ), items );
+
+    // the sets of the location are next to each other, and the cheapest ask is the first one
+    AskMap::const_iterator cur, end;
+    cur = asks.lower_bound( _BookKey( locationID, 0 ) );
+    end = asks.upper_bound( _BookKey( locationID, 0xFFFFFFFF ) );
+    for(; cur != end; ++cur )
+    {
+        if( cur->second.empty() )
+            continue;
+
+        const MarketOrder& best = *cur->second.begin()->order;
+
+        PyList* line = new PyList( 4 );
+        line->SetItem( 0, PyStatic::NewInt( best.typeID ) );
+        line->SetItem( 1, new PyFloat( best.price ) );
+        line->SetItem( 2, PyStatic::NewInt( best.volRemaining ) );
+        line->SetItem( 3, PyStatic::NewInt( best.stationID ) );
+
+        items->SetItem( PyStatic::NewInt( best.typeID ), line );
+    }
+
+    return res;
+}
+
+PyRep* MarketOrderBook::_GetAsks( const BookMap& books, uint32 locationID ) const
+{
+    // the sell sides of the books, the same as the asks of the solar systems
+    AskMap asks;
+
+    BookMap::const_iterator cur, end;
+    cur = books.lower_bound( _BookKey( locationID, 0 ) );
+    end = books.upper_bound( _BookKey( locationID, 0xFFFFFFFF ) );
+    for(; cur != end; ++cur )
+        if( !cur->second.sells.empty() )
+            asks[ cur->first ].insert( *cur->second.sells.begin() );
+
+    return _GetAsks( asks, locationID );
+}
@@ -28,6 +28,7 @@
 #include "EntityList.h"
 #include "PyServiceCD.h"
 #include "cache/ObjCacheService.h"
+#include "market/MarketJournal.h"
 #include "market/MarketProxyService.h"
 
 /*
@@ -62,11 +63,18 @@ protected:
 };
 */
 
+/// Key of the orders of a type in a region.
+static uint64 OrdersKey(uint32 regionID, uint32 typeID)
+{
+    return ((uint64)regionID << 32) | typeID;
+}
+
 PyCallable_Make_InnerDispatcher(MarketProxyService)
 
 MarketProxyService::MarketProxyService(PyServiceMgr *mgr)
 : PyService(mgr, "marketProxy"),
-  m_dispatch(new Dispatcher(this))
+  m_dispatch(new Dispatcher(this)),
+  m_historyRollup(*this)
 {
     _SetCallDispatcher(m_dispatch);
 
@@ -83,6 +91,9 @@ MarketProxyService::MarketProxyService(PyServiceMgr *mgr)
     PyCallable_REG_CALL(MarketProxyService, CancelCharOrder)
     PyCallable_REG_CALL(MarketProxyService, CharGetNewTransactions)
     PyCallable_REG_CALL(MarketProxyService, StartupCheck)
+
+    //catch up with the days which passed while we were down
+    sTimerWheel.Schedule(&m_historyRollup, 0);
 }
 
 MarketProxyService::~MarketProxyService() {
@@ -212,9 +223,22 @@ PyResult MarketProxyService::Handle_GetOrders(PyCallArgs &call) {
     return result;*/
     PyRep *result = NULL;
 
-    std::string method_name ("GetOrders_");
-    method_name += itoa(args.arg);
-    ObjectCachedMethodID method_id(GetName(), method_name.c_str());
+    uint32 locid = call.client->GetSystemID();
+    if(!IsSolarSystem(locid))
+    {
+        codelog(SERVICE__ERROR, "%s: GetSystemID() returned a non-system %u!", call.client->GetName(), locid);
+        return NULL;
+    }
+
+    uint32 regionID;
+    if(!m_db.GetSystemInfo(locid, NULL, &regionID, NULL, NULL))
+    {
+        codelog(SERVICE__ERROR, "%s: Failed to find parents of system %u!", call.client->GetName(), locid);
+        return NULL;
+    }
+
+    //the jumps of the orders are counted from the solar system of the client
+    ObjectCachedMethodID method_id(GetName(), _OrdersMethod(regionID, args.arg, locid).c_str());
 
 #   pragma message( "TODO: temporary solution, make cache objects with arguments" )
 
@@ -222,28 +246,18 @@ PyResult MarketProxyService::Handle_GetOrders(PyCallArgs &call) {
     if(!m_manager->cache_service->IsCacheLoaded(method_id))
     {
         //this method is not in cache yet, load up the contents and cache it.
-        uint32 locid = call.client->GetSystemID();
-        if(!IsSolarSystem(locid))
-        {
-            codelog(SERVICE__ERROR, "%s: GetSystemID() returned a non-system %u!", call.client->GetName(), locid);
-            return NULL;
-        }
-
-        uint32 regionID;
-        if(!m_db.GetSystemInfo(locid, NULL, &regionID, NULL, NULL))
-        {
-            codelog(SERVICE__ERROR, "%s: Failed to find parents of system %u!", call.client->GetName(), locid);
-            return NULL;
-        }
-
-        result = m_db.GetOrders(regionID, args.arg);
+        result = m_db.GetOrders(regionID, args.arg, locid);
         if(result == NULL) {
             codelog(SERVICE__ERROR, "Failed to load cache, generating empty contents.");
             result = new PyNone();
         }
         m_manager->cache_service->GiveCache(method_id, &result);
+        m_ordersSystems[OrdersKey(regionID, args.arg)].insert(locid);
     }
 
+    //the changes of these orders are sent to the client from now on
+    _WatchOrders(call.client, regionID, args.arg);
+
     //now we know its in the cache one way or the other, so build a
     //cached object cached method call result.
     result = m_manager->cache_service->MakeObjectCachedMethodCallResult(method_id);
@@ -265,63 +279,11 @@ PyResult MarketProxyService::Handle_GetCharOrders(PyCallArgs &call) {
 }
 
 PyResult MarketProxyService::Handle_GetOldPriceHistory(PyCallArgs &call) {
-    Call_SingleIntegerArg args; //itemID
-    if(!args.Decode(&call.tuple)) {
-        codelog(MARKET__ERROR, "Invalid arguments");
-        return NULL;
-    }
-
-    PyRep *result = NULL;
-
-    uint32 locid = call.client->GetSystemID();
-    if(!IsSolarSystem(locid)) {
-        codelog(SERVICE__ERROR, "%s: GetSystemID() returned a non-system %u!", call.client->GetName(), locid);
-        return NULL;
-    }
-
-    uint32 regionID;
-    if(!m_db.GetSystemInfo(locid, NULL, &regionID, NULL, NULL)) {
-        codelog(SERVICE__ERROR, "%s: Failed to find parents of system %u!", call.client->GetName(), locid);
-        return NULL;
-    }
-
-    result = m_db.GetOldPriceHistory(regionID, args.arg);
-    if(result == NULL) {
-        _log(SERVICE__ERROR, "%s: Failed to load Old Price History for item %u of region %u", call.client->GetName(), args.arg, regionID);
-        return NULL;
-    }
-
-    return result;
+    return _GetPriceHistory(call, true);
 }
 
 PyResult MarketProxyService::Handle_GetNewPriceHistory(PyCallArgs &call) {
-    Call_SingleIntegerArg args; //itemID
-    if(!args.Decode(&call.tuple)) {
-        codelog(MARKET__ERROR, "Invalid arguments");
-        return NULL;
-    }
-
-    PyRep *result = NULL;
-
-    uint32 locid = call.client->GetSystemID();
-    if(!IsSolarSystem(locid)) {
-        codelog(SERVICE__ERROR, "%s: GetSystemID() returned a non-system %u!", call.client->GetName(), locid);
-        return NULL;
-    }
-
-    uint32 regionID;
-    if(!m_db.GetSystemInfo(locid, NULL, &regionID, NULL, NULL)) {
-        codelog(SERVICE__ERROR, "%s: Failed to find parents of system %u!", call.client->GetName(), locid);
-        return NULL;
-    }
-
-    result = m_db.GetNewPriceHistory(regionID, args.arg);
-    if(result == NULL) {
-        _log(SERVICE__ERROR, "%s: Failed to load New Price History for item %u of region %u", call.client->GetName(), args.arg, regionID);
-        return NULL;
-    }
-
-    return result;
+    return _GetPriceHistory(call, false);
 }
 
 PyResult MarketProxyService::Handle_PlaceCharOrder(PyCallArgs &call) {
@@ -389,8 +351,8 @@ PyResult MarketProxyService::Handle_PlaceCharOrder(PyCallArgs &call) {
         }
 
         //send notification of new order...
-        _InvalidateOrdersCache(args.typeID);
-        _BroadcastOnOwnOrderChanged(call.client->GetRegionID(), orderID, "Add", args.useCorp);
+        _InvalidateOrdersCache(call.client->GetRegionID(), args.typeID);
+        _BroadcastOnOwnOrderChanged(call.client->GetRegionID(), args.typeID, call.client->GetCharacterID(), orderID, "Add", args.useCorp);
     } else {
         //sell order
 
@@ -493,8 +455,8 @@ PyResult MarketProxyService::Handle_PlaceCharOrder(PyCallArgs &call) {
         }
 
         //notify client about new order.
-        _InvalidateOrdersCache(args.typeID);
-        _BroadcastOnOwnOrderChanged(call.client->GetRegionID(), orderID, "Add", args.useCorp);
+        _InvalidateOrdersCache(call.client->GetRegionID(), args.typeID);
+        _BroadcastOnOwnOrderChanged(call.client->GetRegionID(), args.typeID, call.client->GetCharacterID(), orderID, "Add", args.useCorp);
     }
 
     //returns nothing.
@@ -535,8 +497,8 @@ PyResult MarketProxyService::Handle_ModifyCharOrder(PyCallArgs &call) {
         return NULL;
     }
 
-    _InvalidateOrdersCache(typeID);
-    _BroadcastOnOwnOrderChanged(call.client->GetRegionID(), args.orderID, "Modify", isCorp); //force a refresh of market data.
+    _InvalidateOrdersCache(call.client->GetRegionID(), typeID);
+    _BroadcastOnOwnOrderChanged(call.client->GetRegionID(), typeID, call.client->GetCharacterID(), args.orderID, "Modify", isCorp); //force a refresh of market data.
 
     return NULL;
 }
@@ -589,9 +551,9 @@ PyResult MarketProxyService::Handle_CancelCharOrder(PyCallArgs &call) {
         codelog(MARKET__ERROR, "Failed to delete order %u.", args.orderID);
         return NULL;
     }
-    _InvalidateOrdersCache(typeID);
-    _BroadcastOnOwnOrderChanged(call.client->GetRegionID(), args.orderID, "Expiry", isCorp, order); //force a refresh of market data.
-    _BroadcastOnMarketRefresh(call.client->GetRegionID());
+    _InvalidateOrdersCache(call.client->GetRegionID(), typeID);
+    _BroadcastOnOwnOrderChanged(call.client->GetRegionID(), typeID, ownerID, args.orderID, "Expiry", isCorp, order); //force a refresh of market data.
+    _BroadcastOnMarketRefresh(call.client->GetRegionID(), typeID);
 
     return NULL;
 }
@@ -647,14 +609,31 @@ void MarketProxyService::_SendOnOwnOrderChanged(Client *who, uint32 orderID, con
     who->SendNotification("OnOwnOrderChanged", "clientID", &tmp);   //tmp consumed.
 }
 
+bool MarketProxyService::_AddTradeBalance(Client *who, double amount) {
+    //the character is saved later; the change is written by the journal
+    if(!who->AddBalance(amount, false))
+        return false;
+
+    return m_db.AddCharacterBalance(who->GetCharacterID(), amount);
+}
+
 void MarketProxyService::_SendOnMarketRefresh(Client *who) {
     PyTuple *tmp = new PyTuple(0);
     who->SendNotification("OnMarketRefresh", "clientID", &tmp);   //tmp consumed.
 }
 
-void MarketProxyService::_BroadcastOnOwnOrderChanged(uint32 regionID, uint32 orderID, const char *action, bool isCorp, PyRep* order) {
+void MarketProxyService::_BroadcastOnOwnOrderChanged(uint32 regionID, uint32 typeID, uint32 ownerID, uint32 orderID, const char *action, bool isCorp, PyRep* order) {
+    //only the sessions looking at these orders, and the owner, care about the change
     std::vector<Client *> clients;
-    m_manager->entity_list.FindByRegionID(regionID, clients);
+    _FindOrderWatchers(regionID, typeID, clients);
+
+    Client *owner = m_manager->entity_list.FindCharacter(ownerID);
+    if(owner != NULL && std::find(clients.begin(), clients.end(), owner) == clients.end())
+        clients.push_back(owner);
+
+    if(order == NULL)
+        order = m_db.GetOrderRow(orderID);
+
     std::vector<Client *>::iterator cur, end;
     cur = clients.begin();
     end = clients.end();
@@ -665,9 +644,10 @@ void MarketProxyService::_BroadcastOnOwnOrderChanged(uint32 regionID, uint32 ord
     PySafeDecRef(order);
 }
 
-void MarketProxyService::_BroadcastOnMarketRefresh(uint32 regionID) {
+void MarketProxyService::_BroadcastOnMarketRefresh(uint32 regionID, uint32 typeID) {
     std::vector<Client *> clients;
-    m_manager->entity_list.FindByRegionID(regionID, clients);
+    _FindOrderWatchers(regionID, typeID, clients);
+
     std::vector<Client *>::iterator cur, end;
     cur = clients.begin();
     end = clients.end();
@@ -676,17 +656,174 @@ void MarketProxyService::_BroadcastOnMarketRefresh(uint32 regionID) {
     }
 }
 
-void MarketProxyService::_InvalidateOrdersCache(uint32 typeID)
+void MarketProxyService::_InvalidateOrdersCache(uint32 regionID, uint32 typeID)
+{
+    //only the orders of the type in the region are rebuilt, and keep their version if they end up the same
+    std::map<uint64, std::set<uint32> >::iterator res = m_ordersSystems.find(OrdersKey(regionID, typeID));
+    if(res == m_ordersSystems.end())
+        return;
+
+    std::set<uint32>::iterator cur, end;
+    cur = res->second.begin();
+    end = res->second.end();
+    for(; cur != end; cur++) {
+        ObjectCachedMethodID method_id(GetName(), _OrdersMethod(regionID, typeID, *cur).c_str());
+        m_manager->cache_service->InvalidateCache(method_id);
+    }
+}
+
+std::string MarketProxyService::_OrdersMethod(uint32 regionID, uint32 typeID, uint32 systemID)
 {
-    std::string method_name ("GetOrders_");
+    std::string method_name("GetOrders_");
+    method_name += itoa(regionID);
+    method_name += "_";
     method_name += itoa(typeID);
-    ObjectCachedMethodID method_id(GetName(), method_name.c_str());
-    m_manager->cache_service->InvalidateCache( method_id );
+    method_name += "_";
+    method_name += itoa(systemID);
+    return method_name;
+}
+
+void MarketProxyService::_WatchOrders(Client *who, uint32 regionID, uint32 typeID)
+{
+    const uint32 charID = who->GetCharacterID();
+    const uint64 key = OrdersKey(regionID, typeID);
+
+    //the market window shows the orders of a single type at a time
+    std::map<uint32, uint64>::iterator res = m_watchedOrders.find(charID);
+    if(res != m_watchedOrders.end()) {
+        if(res->second == key)
+            return;
+
+        _UnwatchOrders(charID, res->second);
+        res->second = key;
+    } else
+        m_watchedOrders.insert(std::make_pair(charID, key));
+
+    m_orderWatchers[key].insert(charID);
+}
+
+void MarketProxyService::_UnwatchOrders(uint32 charID, uint64 key)
+{
+    std::map<uint64, std::set<uint32> >::iterator res = m_orderWatchers.find(key);
+    if(res == m_orderWatchers.end())
+        return;
+
+    res->second.erase(charID);
+    if(res->second.empty())
+        m_orderWatchers.erase(res);
+}
+
+void MarketProxyService::_FindOrderWatchers(uint32 regionID, uint32 typeID, std::vector<Client *> &into)
+{
+    const uint64 key = OrdersKey(regionID, typeID);
+
+    std::map<uint64, std::set<uint32> >::iterator res = m_orderWatchers.find(key);
+    if(res == m_orderWatchers.end())
+        return;
+
+    std::set<uint32>::iterator cur = res->second.begin();
+    while(cur != res->second.end()) {
+        Client *who = m_manager->entity_list.FindCharacter(*cur);
+        if(who == NULL || who->GetRegionID() != regionID) {
+            //logged off or left the region; they fetch the orders again anyway
+            m_watchedOrders.erase(*cur);
+            res->second.erase(cur++);
+            continue;
+        }
+
+        into.push_back(who);
+        ++cur;
+    }
+
+    if(res->second.empty())
+        m_orderWatchers.erase(res);
+}
+
+PyResult MarketProxyService::_GetPriceHistory(PyCallArgs &call, bool old)
+{
+    Call_SingleIntegerArg args; //itemID
+    if(!args.Decode(&call.tuple)) {
+        codelog(MARKET__ERROR, "Invalid arguments");
+        return NULL;
+    }
+
+    uint32 locid = call.client->GetSystemID();
+    if(!IsSolarSystem(locid)) {
+        codelog(SERVICE__ERROR, "%s: GetSystemID() returned a non-system %u!", call.client->GetName(), locid);
+        return NULL;
+    }
+
+    uint32 regionID;
+    if(!m_db.GetSystemInfo(locid, NULL, &regionID, NULL, NULL)) {
+        codelog(SERVICE__ERROR, "%s: Failed to find parents of system %u!", call.client->GetName(), locid);
+        return NULL;
+    }
+
+    ObjectCachedMethodID method_id(GetName(), _PriceHistoryMethod(regionID, args.arg, old).c_str());
+
+    //check to see if this history is in the cache already.
+    if(!m_manager->cache_service->IsCacheLoaded(method_id))
+    {
+        //this history is not in cache yet, load up the contents and cache it.
+        PyRep *result = old ? m_db.GetOldPriceHistory(regionID, args.arg) : m_db.GetNewPriceHistory(regionID, args.arg);
+        if(result == NULL) {
+            _log(SERVICE__ERROR, "%s: Failed to load %s Price History for item %u of region %u", call.client->GetName(), old ? "Old" : "New", args.arg, regionID);
+            return NULL;
+        }
+        m_manager->cache_service->GiveCache(method_id, &result);
+    }
+
+    //now we know its in the cache, so build a
+    //cached object cached method call result.
+    return m_manager->cache_service->MakeObjectCachedMethodCallResult(method_id);
+}
+
+std::string MarketProxyService::_PriceHistoryMethod(uint32 regionID, uint32 typeID, bool old)
+{
+    //each region and type has its own object, so a trade only invalidates its own history
+    std::string method_name(old ? "GetOldPriceHistory_" : "GetNewPriceHistory_");
+    method_name += itoa(regionID);
+    method_name += "_";
+    method_name += itoa(typeID);
+    return method_name;
+}
+
+void MarketProxyService::_InvalidatePriceHistoryCache(uint32 regionID, uint32 typeID, bool old)
+{
+    ObjectCachedMethodID method_id(GetName(), _PriceHistoryMethod(regionID, typeID, old).c_str());
+    m_manager->cache_service->InvalidateCache(method_id);
+}
+
+void MarketProxyService::_RollupPriceHistory()
+{
+    std::vector<std::pair<uint32, uint32> > moved;
+    if(m_db.BuildOldPriceHistory(moved)) {
+        //both halves of the moved histories changed
+        std::vector<std::pair<uint32, uint32> >::const_iterator cur, end;
+        cur = moved.begin();
+        end = moved.end();
+        for(; cur != end; cur++) {
+            _InvalidatePriceHistoryCache(cur->first, cur->second, true);
+            _InvalidatePriceHistoryCache(cur->first, cur->second, false);
+        }
+
+        if(!moved.empty())
+            _log(MARKET__TRACE, "Moved the aged out price history of %lu types to the old history.", (unsigned long)moved.size());
+    } else
+        codelog(MARKET__ERROR, "Failed to move the aged out price history, retrying in a day.");
+
+    //run again shortly after the next day boundary
+    const uint64 now = Win32TimeNow();
+    const uint64 untilMidnight = Win32Time_Day - ( now % Win32Time_Day );
+    sTimerWheel.Schedule(&m_historyRollup, (uint32)( untilMidnight / ( Win32Time_Second / 1000 ) ) + 60 * 1000);
 }
 
 //NOTE: there are a lot of race conditions to deal with here if we ever
 //allow multiple market services to run at the same time.
 void MarketProxyService::_ExecuteBuyOrder(uint32 buy_order_id, uint32 stationID, uint32 quantity, Client *seller, InventoryItemRef item, bool isCorp) {
+    //everything written below is a single record of the journal
+    MarketJournal::Trade trade;
+
     uint32 orderOwnerID = 0;
     uint32 typeID = 0;
     uint32 qtyReq = 0;
@@ -739,7 +876,7 @@ void MarketProxyService::_ExecuteBuyOrder(uint32 buy_order_id, uint32 stationID,
     //give the money to the seller...
     double money = price * quantity;
     //TODO: take off market overhead fees...
-    seller->AddBalance(money);
+    _AddTradeBalance(seller, money);
     //TODO: record this in the wallet history.
 
     Client *buyer = m_manager->entity_list.FindCharacter(orderOwnerID);
@@ -750,17 +887,17 @@ void MarketProxyService::_ExecuteBuyOrder(uint32 buy_order_id, uint32 stationID,
             codelog(MARKET__ERROR, "Failed to delete order %u.", buy_order_id);
             return;
         }
-        _InvalidateOrdersCache(typeID);
-        _BroadcastOnOwnOrderChanged(seller->GetRegionID(), buy_order_id, "Expiry", isCorp, order);
-        _BroadcastOnMarketRefresh(seller->GetRegionID());
+        _InvalidateOrdersCache(seller->GetRegionID(), typeID);
+        _BroadcastOnOwnOrderChanged(seller->GetRegionID(), typeID, orderOwnerID, buy_order_id, "Expiry", isCorp, order);
+        _BroadcastOnMarketRefresh(seller->GetRegionID(), typeID);
     } else {
         _log(MARKET__TRACE, "%s: Partially satisfied order %u, altering quantity to %u.", seller->GetName(), buy_order_id, qtyReq - quantity);
         if(!m_db.AlterOrderQuantity(buy_order_id, qtyReq - quantity)) {
             codelog(MARKET__ERROR, "Failed to alter quantity of order %u.", buy_order_id);
             return;
         }
-       _InvalidateOrdersCache(typeID);
-        _BroadcastOnOwnOrderChanged(seller->GetRegionID(), buy_order_id, "Modify", isCorp);
+        _InvalidateOrdersCache(seller->GetRegionID(), typeID);
+        _BroadcastOnOwnOrderChanged(seller->GetRegionID(), typeID, orderOwnerID, buy_order_id, "Modify", isCorp);
     }
 
     //record this transaction in market_transactions
@@ -771,11 +908,15 @@ void MarketProxyService::_ExecuteBuyOrder(uint32 buy_order_id, uint32 stationID,
     if(!m_db.RecordTransaction(typeID, quantity, price, TransactionTypeBuy, orderOwnerID, seller->GetRegionID(), stationID)) {
         codelog(MARKET__ERROR, "%s: Failed to record buy side of transaction.", seller->GetName());
     }
+    _InvalidatePriceHistoryCache(seller->GetRegionID(), typeID, false);
 }
 
 //NOTE: there are a lot of race conditions to deal with here if we ever
 //allow multiple market services to run at the same time.
 void MarketProxyService::_ExecuteSellOrder(uint32 sell_order_id, uint32 stationID, uint32 quantity, Client *buyer, bool isCorp) {
+    //everything written below is a single record of the journal
+    MarketJournal::Trade trade;
+
     uint32 orderOwnerID = 0;
     uint32 typeID = 0;
     uint32 qtyAvail = 0;
@@ -799,7 +940,7 @@ void MarketProxyService::_ExecuteSellOrder(uint32 sell_order_id, uint32 stationI
     double money = price * quantity;
 
     //take the money from the buyer before we spawn the item.
-    if(!buyer->AddBalance(-money)) {
+    if(!_AddTradeBalance(buyer, -money)) {
         codelog(MARKET__ERROR, "%s: Failed to take buyer %s (%u)'s money (%.2f ISK) for order %u", buyer->GetName(), buyer->GetName(), buyer->GetCharacterID(), money, sell_order_id);
         buyer->SendErrorMsg("You cannot afford that.");
         return;
@@ -823,7 +964,7 @@ void MarketProxyService::_ExecuteSellOrder(uint32 sell_order_id, uint32 stationI
     Client *seller = m_manager->entity_list.FindCharacter(orderOwnerID);
     if(seller != NULL) {
         //the seller is logged in, send them a notification...
-        if(!seller->AddBalance(money))
+        if(!_AddTradeBalance(seller, money))
             codelog(MARKET__ERROR, "%s: Failed to give seller %s (%u) %.2f ISK from order %u", buyer->GetName(), seller->GetName(), orderOwnerID, money, sell_order_id);
     } else {
         //seller is not online right now...
@@ -838,17 +979,17 @@ void MarketProxyService::_ExecuteSellOrder(uint32 sell_order_id, uint32 stationI
             codelog(MARKET__ERROR, "Failed to delete order %u.", sell_order_id);
             return;
         }
-        _InvalidateOrdersCache(typeID);
-        _BroadcastOnOwnOrderChanged(buyer->GetRegionID(), sell_order_id, "Expiry", isCorp, order);
-        _BroadcastOnMarketRefresh(buyer->GetRegionID());
+        _InvalidateOrdersCache(buyer->GetRegionID(), typeID);
+        _BroadcastOnOwnOrderChanged(buyer->GetRegionID(), typeID, orderOwnerID, sell_order_id, "Expiry", isCorp, order);
+        _BroadcastOnMarketRefresh(buyer->GetRegionID(), typeID);
     } else {
         _log(MARKET__TRACE, "%s: Partially satisfied order %u, altering quantity to %u.", buyer->GetName(), sell_order_id, qtyAvail - quantity);
         if(!m_db.AlterOrderQuantity(sell_order_id, qtyAvail - quantity)) {
             codelog(MARKET__ERROR, "Failed to alter quantity of order %u.", sell_order_id);
             return;
         }
-        _InvalidateOrdersCache(typeID);
-        _BroadcastOnOwnOrderChanged(buyer->GetRegionID(), sell_order_id, "Modify", isCorp);
+        _InvalidateOrdersCache(buyer->GetRegionID(), typeID);
+        _BroadcastOnOwnOrderChanged(buyer->GetRegionID(), typeID, orderOwnerID, sell_order_id, "Modify", isCorp);
     }
 
     //record this transaction in market_transactions
@@ -859,6 +1000,7 @@ void MarketProxyService::_ExecuteSellOrder(uint32 sell_order_id, uint32 stationI
     if(!m_db.RecordTransaction(typeID, quantity, price, TransactionTypeBuy, buyer->GetCharacterID(), buyer->GetRegionID(), stationID)) {
         codelog(MARKET__ERROR, "%s: Failed to record buy side of transaction.", buyer->GetName());
     }
+    _InvalidatePriceHistoryCache(buyer->GetRegionID(), typeID, false);
 }
 
 
@@ -0,0 +1,260 @@
+/*
+    ------------------------------------------------------------------------------------
+    LICENSE:
+    ------------------------------------------------------------------------------------
+    This file is part of EVEmu: EVE Online Server Emulator
+    Copyright 2006 - 2011 The EVEmu Team
+    For the latest information visit http://evemu.org
+    ------------------------------------------------------------------------------------
+    This program is free software; you can redistribute it and/or modify it under
+    the terms of the GNU Lesser General Public License as published by the Free Software
+    Foundation; either version 2 of the License, or (at your option) any later
+    version.
+
+    This program is distributed in the hope that it will be useful, but WITHOUT
+    ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+    FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public License along with
+    this program; if not, write to the Free Software Foundation, Inc., 59 Temple
+    Place - Suite 330, Boston, MA 02111-1307, USA, or go to
+    http://www.gnu.org/copyleft/lesser.txt.
+    ------------------------------------------------------------------------------------
+    Author:     EVEmu Team
+*/
+
+
+#include "eve-server.h"
+
+#include "Client.h"
+#include "PyServiceMgr.h"
+#include "account/WalletLedger.h"
+#include "inventory/InventoryBatch.h"
+#include "market/MarketJournal.h"
+#include "market/TradeDesk.h"
+
+TradeDesk::TradeDesk()
+: mLastContainerID( 0 )
+{
+}
+
+const TradeSession* TradeDesk::Open( Client* initiator, Client* target )
+{
+    if( initiator == target
+        || initiator->GetStationID() == 0
+        || initiator->GetStationID() != target->GetStationID() )
+        return NULL;
+    if( mTraders.find( initiator->GetCharacterID() ) != mTraders.end()
+        || mTraders.find( target->GetCharacterID() ) != mTraders.end() )
+        return NULL;
+
+    const uint32 tradeContainerID = ++mLastContainerID;
+    TradeSession& session = mSessions[ tradeContainerID ];
+    session.tradeContainerID = tradeContainerID;
+    session.stationID = initiator->GetStationID();
+    session.when = Win32TimeNow();
+    session.traders[ 0 ] = initiator;
+    session.traders[ 1 ] = target;
+    for( uint32 side = 0; side < 2; ++side )
+    {
+        session.accepted[ side ] = false;
+        session.money[ side ] = 0.0;
+    }
+
+    mTraders[ initiator->GetCharacterID() ] = tradeContainerID;
+    mTraders[ target->GetCharacterID() ] = tradeContainerID;
+
+    ++mStats.opened;
+    return &session;
+}
+
+const TradeSession* TradeDesk::Find( uint32 characterID ) const
+{
+    std::map< uint32, uint32 >::const_iterator res = mTraders.find( characterID );
+    if( res == mTraders.end() )
+        return NULL;
+    return &mSessions.find( res->second )->second;
+}
+
+bool TradeDesk::AddItem( Client* who, uint32 itemID )
+{
+    uint32 side;
+    TradeSession* session = _Find( who, side );
+    if( session == NULL || mOfferedItems.find( itemID ) != mOfferedItems.end() )
+        return false;
+
+    InventoryItemRef item = who->services().item_factory.GetItem( itemID );
+    if( !item
+        || item->ownerID() != who->GetCharacterID()
+        || item->locationID() != session->stationID
+        || item->flag() != flagHangar )
+        return false;
+
+    session->items[ side ].push_back( itemID );
+    mOfferedItems.insert( itemID );
+
+    //the offer changed, both have to look at it again.
+    session->accepted[ 0 ] = session->accepted[ 1 ] = false;
+    ++mStats.changes;
+    return true;
+}
+
+bool TradeDesk::OfferMoney( Client* who, double amount )
+{
+    uint32 side;
+    TradeSession* session = _Find( who, side );
+    if( session == NULL || amount < 0.0 || who->GetBalance() < amount )
+        return false;
+
+    session->money[ side ] = amount;
+
+    session->accepted[ 0 ] = session->accepted[ 1 ] = false;
+    ++mStats.changes;
+    return true;
+}
+
+bool TradeDesk::ToggleAccept( Client* who, bool accept )
+{
+    uint32 side;
+    TradeSession* session = _Find( who, side );
+    if( session == NULL )
+        return false;
+
+    session->accepted[ side ] = accept;
+    if( !session->accepted[ 0 ] || !session->accepted[ 1 ] )
+        return true;
+
+    const bool completed = _Complete( *session );
+    if( completed )
+        ++mStats.completed;
+    else
+        ++mStats.failed;
+
+    _Close( session->tradeContainerID );
+    return completed;
+}
+
+void TradeDesk::Cancel( Client* who )
+{
+    uint32 side;
+    TradeSession* session = _Find( who, side );
+    if( session == NULL )
+        return;
+
+    _Close( session->tradeContainerID );
+    ++mStats.cancelled;
+}
+
+TradeSession* TradeDesk::_Find( Client* who, uint32& side )
+{
+    std::map< uint32, uint32 >::const_iterator res = mTraders.find( who->GetCharacterID() );
+    if( res == mTraders.end() )
+        return NULL;
+
+    TradeSession& session = mSessions.find( res->second )->second;
+    side = ( session.traders[ 0 ] == who ? 0 : 1 );
+    return &session;
+}
+
+bool TradeDesk::_Complete( TradeSession& session )
+{
+    //everything is checked before anything changes; a trade goes through whole or not at all.
+    std::vector< InventoryItemRef > items[ 2 ];
+    for( uint32 side = 0; side < 2; ++side )
+    {
+        Client* giver = session.traders[ side ];
+        if( giver->GetStationID() != session.stationID || giver->GetBalance() < session.money[ side ] )
+        {
+            _log( CLIENT__ERROR, "Trade %u: %s can no longer give what was offered.", session.tradeContainerID, giver->GetName() );
+            return false;
+        }
+
+        std::vector< uint32 >::const_iterator cur, end;
+        cur = session.items[ side ].begin();
+        end = session.items[ side ].end();
+        for(; cur != end; ++cur )
+        {
+            InventoryItemRef item = giver->services().item_factory.GetItem( *cur );
+            if( !item
+                || item->ownerID() != giver->GetCharacterID()
+                || item->locationID() != session.stationID
+                || item->flag() != flagHangar )
+            {
+                _log( CLIENT__ERROR, "Trade %u: item %u of %s is no longer in its hangar.", session.tradeContainerID, *cur, giver->GetName() );
+                return false;
+            }
+            items[ side ].push_back( item );
+        }
+    }
+
+    {
+        InventoryBatch::Scope batch;
+        MarketJournal::Trade trade;
+
+        for( uint32 side = 0; side < 2; ++side )
+        {
+            Client* giver = session.traders[ side ];
+            Client* taker = session.traders[ 1 - side ];
+
+            if( 0.0 < session.money[ side ] )
+            {
+                giver->AddBalance( -session.money[ side ] );
+                taker->AddBalance( session.money[ side ] );
+
+                WalletEntry entry;
+                entry.refTypeID = RefType_playerTrading;
+                entry.ownerID1 = giver->GetCharacterID();
+                entry.ownerID2 = taker->GetCharacterID();
+                entry.argID1 = itoa( session.stationID );
+                entry.accountKey = accountCash;
+                entry.reason = "";
+
+                entry.amount = -session.money[ side ];
+                entry.balance = giver->GetBalance();
+                sWalletLedger.Record( giver->GetCharacterID(), giver->GetAccountID(), entry );
+
+                entry.amount = session.money[ side ];
+                entry.balance = taker->GetBalance();
+                sWalletLedger.Record( taker->GetCharacterID(), taker->GetAccountID(), entry );
+            }
+
+            std::vector< InventoryItemRef >::const_iterator cur, end;
+            cur = items[ side ].begin();
+            end = items[ side ].end();
+            for(; cur != end; ++cur )
+            {
+                //the item saves are queued as well; the journal makes the change of owner part of the trade.
+                std::string query;
+                sprintf( query, "UPDATE entity SET ownerID=%u WHERE itemID=%u", taker->GetCharacterID(), (*cur)->itemID() );
+                sMarketJournal.Append( query );
+
+                (*cur)->ChangeOwner( taker->GetCharacterID() );
+            }
+        }
+    }
+
+    //trades are rare enough to be written right away.
+    sMarketJournal.Flush();
+    return true;
+}
+
+void TradeDesk::_Close( uint32 tradeContainerID )
+{
+    std::map< uint32, TradeSession >::iterator res = mSessions.find( tradeContainerID );
+    if( res == mSessions.end() )
+        return;
+
+    TradeSession& session = res->second;
+    for( uint32 side = 0; side < 2; ++side )
+    {
+        mTraders.erase( session.traders[ side ]->GetCharacterID() );
+
+        std::vector< uint32 >::const_iterator cur, end;
+        cur = session.items[ side ].begin();
+        end = session.items[ side ].end();
+        for(; cur != end; ++cur )
+            mOfferedItems.erase( *cur );
+    }
+
+    mSessions.erase( res );
+}
@@ -28,6 +28,7 @@
 #include "EntityList.h"
 #include "PyBoundObject.h"
 #include "PyServiceCD.h"
+#include "market/TradeDesk.h"
 #include "market/TradeService.h"
 
 PyCallable_Make_InnerDispatcher(TradeService);
@@ -47,6 +48,11 @@ public:
         m_strBoundObjectName = "TradeBound";
 
         PyCallable_REG_CALL(TradeBound, List)
+        PyCallable_REG_CALL(TradeBound, Add)
+        PyCallable_REG_CALL(TradeBound, MultiAdd)
+        PyCallable_REG_CALL(TradeBound, OfferMoney)
+        PyCallable_REG_CALL(TradeBound, ToggleAccept)
+        PyCallable_REG_CALL(TradeBound, Abort)
     }
     virtual ~TradeBound()
     {
@@ -59,6 +65,11 @@ public:
     }
 
     PyCallable_DECL_CALL(List)
+    PyCallable_DECL_CALL(Add)
+    PyCallable_DECL_CALL(MultiAdd)
+    PyCallable_DECL_CALL(OfferMoney)
+    PyCallable_DECL_CALL(ToggleAccept)
+    PyCallable_DECL_CALL(Abort)
 
 protected:
     Dispatcher *const m_dispatch;
@@ -103,25 +114,122 @@ PyResult TradeService::Handle_InitiateTrade(PyCallArgs &call){
     }
 
     Client *target = call.client->services().entity_list.FindCharacter( args.arg );
+    if(target == NULL) {
+        call.client->SendErrorMsg("That character is not online.");
+        return NULL;
+    }
+
+    const TradeSession *session = sTradeDesk.Open( call.client, target );
+    if(session == NULL) {
+        call.client->SendErrorMsg("You can only trade with a character docked in your station who is not trading already.");
+        return NULL;
+    }
 
     InitiateTradeRsp rsp;
 
     rsp.nodeID = call.client->services().GetNodeID();
-    rsp.stationID = target->GetStationID();
+    rsp.stationID = session->stationID;
     rsp.ownerID = call.client->GetCharacterID();
     rsp.targetID = target->GetCharacterID();
     rsp.moneyToGive = 0;
     rsp.moneyToReceive = 0;
-    rsp.when = Win32TimeNow();
+    rsp.when = session->when;
     rsp.unknown7 = 0;
 
-    sLog.Debug("Trade Service", "Called InitiateTrade with character: %u", args.arg);
+    _log(CLIENT__MESSAGE, "%s: Initiated trade %u with %s.", call.client->GetName(), session->tradeContainerID, target->GetName());
 
     return rsp.Encode();
 }
+
 PyResult TradeBound::Handle_List(PyCallArgs &call) {
+    const TradeSession *session = sTradeDesk.Find( call.client->GetCharacterID() );
+    if(session == NULL) {
+        codelog(CLIENT__ERROR, "%s: List called outside of a trade", call.client->GetName());
+        return NULL;
+    }
 
     TradeListRsp tradeListResponse;
-    sLog.Debug("TradeBound", "Called List stub");
+    tradeListResponse.tradeContainerID = session->tradeContainerID;
+    tradeListResponse.tradeInitiatorID = session->traders[0]->GetCharacterID();
+    tradeListResponse.tradeTargetID = session->traders[1]->GetCharacterID();
+    tradeListResponse.initiatorAccepted = session->accepted[0];
+    tradeListResponse.targetAccepted = session->accepted[1];
+    tradeListResponse.initiatorMoney = session->money[0];
+    tradeListResponse.targetMoney = session->money[1];
+
+    for(uint32 side = 0; side < 2; side++) {
+        std::vector<uint32>::const_iterator cur, end;
+        cur = session->items[side].begin();
+        end = session->items[side].end();
+        for(; cur != end; cur++) {
+            InventoryItemRef item = m_manager->item_factory.GetItem(*cur);
+            if(item)
+                tradeListResponse.items->AddItem(item->GetItemRow());
+        }
+    }
+
     return tradeListResponse.Encode();
 }
+
+PyResult TradeBound::Handle_Add(PyCallArgs &call) {
+    Call_TradeAdd args;
+    if(!args.Decode(&call.tuple)) {
+        codelog(CLIENT__ERROR, "%s: failed to decode arguments", call.client->GetName());
+        return NULL;
+    }
+
+    if(!sTradeDesk.AddItem(call.client, args.itemID))
+        call.client->SendErrorMsg("That item cannot be traded.");
+
+    return NULL;
+}
+
+PyResult TradeBound::Handle_MultiAdd(PyCallArgs &call) {
+    Call_TradeMultiAdd args;
+    if(!args.Decode(&call.tuple)) {
+        codelog(CLIENT__ERROR, "%s: failed to decode arguments", call.client->GetName());
+        return NULL;
+    }
+
+    std::vector<int32>::const_iterator cur, end;
+    cur = args.itemIDs.begin();
+    end = args.itemIDs.end();
+    for(; cur != end; cur++) {
+        if(!sTradeDesk.AddItem(call.client, *cur))
+            _log(CLIENT__ERROR, "%s: item %d cannot be traded.", call.client->GetName(), *cur);
+    }
+
+    return NULL;
+}
+
+PyResult TradeBound::Handle_OfferMoney(PyCallArgs &call) {
+    Call_SingleRealArg args;
+    if(!args.Decode(&call.tuple)) {
+        codelog(CLIENT__ERROR, "%s: failed to decode arguments", call.client->GetName());
+        return NULL;
+    }
+
+    if(!sTradeDesk.OfferMoney(call.client, args.arg))
+        call.client->SendErrorMsg("You do not have that much ISK.");
+
+    return NULL;
+}
+
+PyResult TradeBound::Handle_ToggleAccept(PyCallArgs &call) {
+    Call_SingleBoolArg args;
+    if(!args.Decode(&call.tuple)) {
+        codelog(CLIENT__ERROR, "%s: failed to decode arguments", call.client->GetName());
+        return NULL;
+    }
+
+    if(!sTradeDesk.ToggleAccept(call.client, args.arg))
+        call.client->SendErrorMsg("The trade failed, as the offer could no longer be honored.");
+
+    return NULL;
+}
+
+PyResult TradeBound::Handle_Abort(PyCallArgs &call) {
+    sTradeDesk.Cancel(call.client);
+
+    return NULL;
+}
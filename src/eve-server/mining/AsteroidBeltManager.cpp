@@ -25,14 +25,20 @@
 
 #include "eve-server.h"
 
+#include "EVEServerConfig.h"
+#include "inventory/AttributeEnum.h"
 #include "mining/Asteroid.h"
 #include "mining/AsteroidBeltManager.h"
+#include "system/SystemManager.h"
 
-AsteroidBeltManager::AsteroidBeltManager(uint32 belt_id)
-: m_beltID(belt_id),
-  m_growthTimer(ASTEROID_GROWTH_INTERVAL_MS)    //default this to worst case. This will almost certainly be changed with a LoadState()
+AsteroidBeltManager::AsteroidBeltManager(SystemManager &system)
+: m_system(system),
+  m_growthTimer(ASTEROID_GROWTH_INTERVAL_MS),
+  m_snapshotTimer(sConfig.world.asteroidSnapshotInterval * 1000)
 {
     m_growthTimer.Start();
+    if(sConfig.world.asteroidSnapshotInterval != 0)
+        m_snapshotTimer.Start();
 }
 
 AsteroidBeltManager::~AsteroidBeltManager() {
@@ -40,66 +46,164 @@ AsteroidBeltManager::~AsteroidBeltManager() {
 }
 
 void AsteroidBeltManager::_Clear() {
-    std::vector<AsteroidEntity*>::const_iterator cur, end;
-    cur = m_asteroids.begin();
-    end = m_asteroids.end();
-    for(; cur != end; cur++) {
-        delete *cur;
-    }
-}
+    //the mining of the last tic counts too.
+    _ApplyMining();
+    SaveState();
 
-void AsteroidBeltManager::Process() {
-    if(m_growthTimer.Check()) {
-        _TriggerGrowth();
-    }
+    m_asteroids.clear();
 }
 
-void AsteroidBeltManager::_TriggerGrowth() {
-    std::vector<AsteroidEntity*>::const_iterator cur, end;
-    cur = m_asteroids.begin();
-    end = m_asteroids.end();
-    for(; cur != end; cur++) {
-        _log(SERVICE__ERROR, "Asteroid Growth not hooked in yet.");
-        //(*cur)->Grow();
+void AsteroidBeltManager::AddAsteroid(AsteroidEntity *roid) {
+    InventoryItemRef item = roid->Item();
+
+    Asteroid &state = m_asteroids[item->itemID()];
+    state.entity = roid;
+    state.mined = 0;
+    state.dirty = false;
+
+    if(item->HasAttribute(AttrQuantity)) {
+        state.ore = static_cast<uint32>(item->GetAttribute(AttrQuantity).get_float());
+    } else {
+        //never mined; its volume is the ore it was spawned with.
+        state.ore = static_cast<uint32>(item->GetAttribute(AttrVolume).get_float());
+        state.dirty = true;
     }
 }
 
+void AsteroidBeltManager::RemoveAsteroid(uint32 asteroidID) {
+    std::map<uint32, Asteroid>::iterator res = m_asteroids.find(asteroidID);
+    if(res == m_asteroids.end())
+        return;
 
-bool AsteroidBeltManager::LoadState() {
-    //load list of asteroids.
-    //load next grow time
-    return false;    //until this is written.
-}
+    Asteroid &roid = res->second;
+    roid.ore -= roid.mined;
+    roid.mined = 0;
+    if(roid.dirty && roid.ore != 0)
+        _Save(roid);
 
-bool AsteroidBeltManager::SaveState() {
-    std::vector<AsteroidEntity*>::const_iterator cur, end;
-    cur = m_asteroids.begin();
-    end = m_asteroids.end();
-    for(; cur != end; cur++) {
-        //TODO: something useful.
-    }
-    return false;    //until this is written.
+    m_mined.erase(asteroidID);
+    m_asteroids.erase(res);
 }
 
-void AsteroidBeltManager::ForceGrowth() {
-    _TriggerGrowth();
-    m_growthTimer.Start(ASTEROID_GROWTH_INTERVAL_MS);
+uint32 AsteroidBeltManager::Mine(uint32 asteroidID, uint32 units) {
+    std::map<uint32, Asteroid>::iterator res = m_asteroids.find(asteroidID);
+    if(res == m_asteroids.end())
+        return 0;
+
+    Asteroid &roid = res->second;
+    const uint32 left = roid.ore - roid.mined;
+    if(units > left)
+        units = left;
+    if(units == 0)
+        return 0;
+
+    roid.mined += units;
+    m_mined.insert(asteroidID);
+
+    _log(MINING__TRACE, "Asteroid %u: %u units mined, %u left.", asteroidID, units, left - units);
+    return units;
 }
 
+uint32 AsteroidBeltManager::GetOre(uint32 asteroidID) const {
+    std::map<uint32, Asteroid>::const_iterator res = m_asteroids.find(asteroidID);
+    if(res == m_asteroids.end())
+        return 0;
+
+    return res->second.ore - res->second.mined;
+}
 
+void AsteroidBeltManager::Process() {
+    _ApplyMining();
 
+    if(m_growthTimer.Check()) {
+        _TriggerGrowth();
+    }
+    if(m_snapshotTimer.Enabled() && m_snapshotTimer.Check()) {
+        SaveState();
+    }
+}
 
+void AsteroidBeltManager::_ApplyMining() {
+    if(m_mined.empty())
+        return;
 
+    std::vector<AsteroidEntity*> depleted;
 
+    std::set<uint32>::const_iterator cur, end;
+    cur = m_mined.begin();
+    end = m_mined.end();
+    for(; cur != end; cur++) {
+        std::map<uint32, Asteroid>::iterator res = m_asteroids.find(*cur);
+        if(res == m_asteroids.end())
+            continue;
+
+        Asteroid &roid = res->second;
+        roid.ore -= roid.mined;
+        roid.mined = 0;
+        roid.dirty = true;
+
+        if(roid.ore == 0)
+            depleted.push_back(roid.entity);
+        else if(sConfig.world.asteroidSnapshotInterval == 0)
+            _Save(roid);
+    }
+    m_mined.clear();
 
+    //the depleted ones are gone for good.
+    std::vector<AsteroidEntity*>::const_iterator curd, endd;
+    curd = depleted.begin();
+    endd = depleted.end();
+    for(; curd != endd; curd++) {
+        InventoryItemRef item = (*curd)->Item();
+        _log(MINING__MESSAGE, "Asteroid %u depleted.", item->itemID());
 
+        //removes it from us too.
+        m_system.RemoveEntity(*curd);
+        delete *curd;
 
+        item->Delete();
+    }
+}
 
+void AsteroidBeltManager::_TriggerGrowth() {
+    std::map<uint32, Asteroid>::iterator cur, end;
+    cur = m_asteroids.begin();
+    end = m_asteroids.end();
+    for(; cur != end; cur++) {
+        Asteroid &roid = cur->second;
 
+        uint32 growth = static_cast<uint32>(roid.ore * ASTEROID_GROWTH_RATE);
+        if(growth == 0)
+            growth = 1;
 
+        roid.ore += growth;
+        roid.dirty = true;
+    }
 
+    _log(MINING__DEBUG, "System %u: %u asteroids grown.", m_system.GetID(), (uint32)m_asteroids.size());
+}
 
+bool AsteroidBeltManager::SaveState() {
+    std::map<uint32, Asteroid>::iterator cur, end;
+    cur = m_asteroids.begin();
+    end = m_asteroids.end();
+    for(; cur != end; cur++) {
+        if(cur->second.dirty)
+            _Save(cur->second);
+    }
+    return true;
+}
 
+void AsteroidBeltManager::_Save(Asteroid &roid) {
+    InventoryItemRef item = roid.entity->Item();
 
+    item->SetAttribute(AttrQuantity, roid.ore, false);
+    item->SaveAttributes();
 
+    roid.dirty = false;
+}
 
+void AsteroidBeltManager::ForceGrowth() {
+    _TriggerGrowth();
+    m_growthTimer.Start(ASTEROID_GROWTH_INTERVAL_MS);
+}
@@ -29,6 +29,7 @@
 #include "PyCallable.h"
 #include "admin/CommandDB.h"
 #include "mining/Asteroid.h"
+#include "mining/AsteroidBeltManager.h"
 #include "system/SystemManager.h"
 
 uint32 GetAsteroidType( double p, const std::map<double, uint32>& roids );
@@ -110,7 +111,12 @@ PyResult Command_spawnbelt( Client* who, CommandDB* db, PyServiceMgr* services,
 
 PyResult Command_growbelt( Client* who, CommandDB* db, PyServiceMgr* services, const Seperator& args )
 {
-    throw PyException( MakeCustomError( "Not implemented yet." ) );
+    if( !who->IsInSpace() )
+        throw PyException( MakeCustomError( "You must be in space to grow asteroids." ) );
+
+    who->System()->belts().ForceGrowth();
+
+    return new PyString( "Asteroids grown." );
 }
 
 uint32 GetAsteroidType( double p, const std::map<double, uint32>& roids )
@@ -160,7 +166,7 @@ void SpawnAsteroid( SystemManager* system, uint32 typeID, double radius, const G
     AsteroidEntity* new_roid = NULL;
     new_roid = new AsteroidEntity( i, system, *(system->GetServiceMgr()), position );
     if( new_roid != NULL )
-        sLog.Debug( "SpawnAsteroid()", "Spawned new asteroid of radius= %fm and volume= %f m3", radius, volume );
+        _debug( "SpawnAsteroid()", "Spawned new asteroid of radius= %fm and volume= %f m3", radius, volume );
     //TODO: check for a local asteroid belt object?
     //TODO: actually add this to the asteroid belt too...
     system->AddEntity( new_roid );
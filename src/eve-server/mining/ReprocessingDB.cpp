@@ -68,11 +68,11 @@ bool ReprocessingDB::IsRecyclable(const uint32 typeID) {
     return(res.GetRow(row));
 }
 
-bool ReprocessingDB::LoadStatic(const uint32 stationID, double &efficiency, double &tax) {
+bool ReprocessingDB::LoadStatic(const uint32 stationID, double &efficiency, double &tax, uint32 &ownerID) {
     DBQueryResult res;
 
     if(!sDatabase.RunQuery(res,
-                "SELECT reprocessingEfficiency, reprocessingStationsTake"
+                "SELECT reprocessingEfficiency, reprocessingStationsTake, corporationID"
                 " FROM staStations"
                 " WHERE stationID=%u",
                 stationID))
@@ -90,34 +90,70 @@ bool ReprocessingDB::LoadStatic(const uint32 stationID, double &efficiency, doub
 
     efficiency = row.GetDouble(0);
     tax = row.GetDouble(1);
+    ownerID = row.GetUInt(2);
 
     return true;
 }
 
 bool ReprocessingDB::GetRecoverables(const uint32 typeID, std::vector<Recoverable> &into) {
+    std::set<uint32> typeIDs;
+    typeIDs.insert(typeID);
+    if(!LoadRecoverables(typeIDs))
+        return false;
+
+    const std::vector<Recoverable> &recoverables = m_recoverables[typeID];
+    into.insert(into.end(), recoverables.begin(), recoverables.end());
+
+    return true;
+}
+
+bool ReprocessingDB::LoadRecoverables(const std::set<uint32> &typeIDs) {
+    std::string types;
+    char buf[16];
+
+    std::set<uint32>::const_iterator cur, end;
+    cur = typeIDs.begin();
+    end = typeIDs.end();
+    for(; cur != end; cur++) {
+        if(m_recoverables.find(*cur) != m_recoverables.end())
+            continue;
+
+        snprintf(buf, sizeof(buf), "%s%u", (types.empty() ? "" : ", "), *cur);
+        types += buf;
+    }
+
+    if(types.empty())
+        return true;
+
     DBQueryResult res;
     DBResultRow row;
 
+    // an item made by a blueprint recovers the materials of its blueprint
     if(!sDatabase.RunQuery(res,
-                "SELECT requiredTypeID, MIN(quantity) FROM typeActivityMaterials"
+                "SELECT IF(activityID = 6, typeID, productTypeID) AS itemTypeID, requiredTypeID, MIN(quantity) FROM typeActivityMaterials"
                 " LEFT JOIN invBlueprintTypes ON typeID = blueprintTypeID"
                 " WHERE damagePerJob = 1 AND ("
-                "   (activityID = 6 AND typeID = %u)"
+                "   (activityID = 6 AND typeID IN (%s))"
                 "   OR"
-                "    (activityID = 1 AND productTypeID = %u))"
-                " GROUP BY requiredTypeID",
-                typeID, typeID, typeID))
+                "    (activityID = 1 AND productTypeID IN (%s)))"
+                " GROUP BY itemTypeID, requiredTypeID",
+                types.c_str(), types.c_str()))
     {
-        _log(DATABASE__ERROR, "Unable to get recoverables for type ID %u: '%s'", typeID, res.error.c_str());
+        _log(DATABASE__ERROR, "Unable to get recoverables for type IDs %s: '%s'", types.c_str(), res.error.c_str());
         return false;
     }
 
+    // the types without any recoverables are cached too
+    cur = typeIDs.begin();
+    for(; cur != end; cur++)
+        m_recoverables[*cur];
+
     Recoverable rec;
 
     while(res.GetRow(row)) {
-        rec.typeID = row.GetInt(0);
-        rec.amountPerBatch = row.GetInt(1);
-        into.push_back(rec);
+        rec.typeID = row.GetInt(1);
+        rec.amountPerBatch = row.GetInt(2);
+        m_recoverables[row.GetUInt(0)].push_back(rec);
     }
 
     return true;
@@ -28,6 +28,7 @@
 #include "PyBoundObject.h"
 #include "PyServiceCD.h"
 #include "mining/ReprocessingService.h"
+#include "standing/StandingCache.h"
 
 class ReprocessingServiceBound
 : public PyBoundObject
@@ -52,10 +53,21 @@ protected:
     ReprocessingDB& m_db;
 
     uint32 m_stationID;
+    uint32 m_stationOwnerID;
     double m_staEfficiency;
     double m_tax;
 
+    /** @return Effective standing of the station owner towards the character. */
+    double _GetStanding(const Client *c) const;
+    /** @return The station's take, lowered by the standing. */
+    double _CalcTax(double standing) const;
+
     double _CalcReprocessingEfficiency(const Client *client, InventoryItemRef item = InventoryItemRef()) const;
+    double _CalcReprocessingEfficiency(const std::vector<InventoryItemRef> &skills, InventoryItemRef item) const;
+    void _GetSkills(const Client *c, std::vector<InventoryItemRef> &into) const;
+
+    InventoryItemRef _GetQuoteItem(uint32 itemID, const Client *c) const;
+    PyRep *_EncodeQuote(InventoryItemRef item, double efficiency, double standing, const std::vector<Recoverable> &recoverables) const;
     PyRep *_GetQuote(uint32 itemID, const Client *c) const;
 };
 
@@ -103,6 +115,7 @@ ReprocessingServiceBound::ReprocessingServiceBound(PyServiceMgr *mgr, Reprocessi
   m_dispatch(new Dispatcher(this)),
   m_db(db),
   m_stationID(stationID),
+  m_stationOwnerID(0),
   m_staEfficiency(0.0),
   m_tax(0.0)
 {
@@ -126,7 +139,7 @@ void ReprocessingServiceBound::Release() {
 }
 
 bool ReprocessingServiceBound::Load() {
-    return(m_db.LoadStatic(m_stationID, m_staEfficiency, m_tax));
+    return(m_db.LoadStatic(m_stationID, m_staEfficiency, m_tax, m_stationOwnerID));
 }
 
 PyResult ReprocessingServiceBound::Handle_GetOptionsForItemTypes(PyCallArgs &call) {
@@ -161,8 +174,10 @@ PyResult ReprocessingServiceBound::Handle_GetReprocessingInfo(PyCallArgs &call)
 
     Rsp_GetReprocessingInfo rsp;
 
-    rsp.tax = m_tax;
-    rsp.reputation = 0.0;   // this should be drain from DB
+    double standing = _GetStanding(call.client);
+
+    rsp.tax = _CalcTax(standing);
+    rsp.reputation = standing;
     rsp.yield = m_staEfficiency;
     rsp.combinedyield = _CalcReprocessingEfficiency(call.client);
 
@@ -188,21 +203,47 @@ PyResult ReprocessingServiceBound::Handle_GetQuotes(PyCallArgs &call) {
         return NULL;
     }
 
-    Rsp_GetQuotes rsp;
+    // one skill snapshot for the whole batch
+    std::vector<InventoryItemRef> skills;
+    _GetSkills(call.client, skills);
+
+    std::vector<InventoryItemRef> items;
+    std::set<uint32> typeIDs;
+
     std::vector<int32>::iterator cur, end;
     cur = call_arg.itemIDs.begin();
     end = call_arg.itemIDs.end();
-
     for(; cur != end; cur++) {
-        PyRep *quote = NULL;
+        InventoryItemRef item;
         try {
-            quote = _GetQuote(*cur, call.client);
+            item = _GetQuoteItem(*cur, call.client);
         } catch(PyException &) {
             // ignore all exceptions
             continue;
         }
-        if(quote != NULL)
-            rsp.quotes[*cur] = quote;
+        if(!item)
+            continue;
+
+        items.push_back(item);
+        typeIDs.insert(item->typeID());
+    }
+
+    // recoverables of all the distinct types in one query
+    if(!m_db.LoadRecoverables(typeIDs))
+        return NULL;
+
+    double standing = _GetStanding(call.client);
+
+    Rsp_GetQuotes rsp;
+    std::vector<InventoryItemRef>::iterator curi, endi;
+    curi = items.begin();
+    endi = items.end();
+    for(; curi != endi; curi++) {
+        std::vector<Recoverable> recoverables;
+        if(!m_db.GetRecoverables((*curi)->typeID(), recoverables))
+            continue;
+
+        rsp.quotes[(*curi)->itemID()] = _EncodeQuote(*curi, _CalcReprocessingEfficiency(skills, *curi), standing, recoverables);
     }
 
     return(rsp.Encode());
@@ -227,6 +268,11 @@ PyResult ReprocessingServiceBound::Handle_Reprocess(PyCallArgs &call) {
     if(call_args.flag == 0)
         call_args.flag = flagHangar;
 
+    std::vector<InventoryItemRef> skills;
+    _GetSkills(call.client, skills);
+
+    double tax = _CalcTax(_GetStanding(call.client));
+
     std::vector<int32>::iterator cur, end;
     cur = call_args.items.begin();
     end = call_args.items.end();
@@ -249,7 +295,7 @@ PyResult ReprocessingServiceBound::Handle_Reprocess(PyCallArgs &call) {
             throw(PyException(MakeUserError("QuantityLessThanMinimumPortion", args)));
         }
 
-        double efficiency = _CalcReprocessingEfficiency( call.client, item );
+        double efficiency = _CalcReprocessingEfficiency( skills, item );
 
         std::vector<Recoverable> recoverables;
         if( !m_db.GetRecoverables( item->typeID(), recoverables ) )
@@ -259,7 +305,7 @@ PyResult ReprocessingServiceBound::Handle_Reprocess(PyCallArgs &call) {
         cur_rec = recoverables.begin();
         end_rec = recoverables.end();
         for(; cur_rec != end_rec; cur_rec++) {
-            uint32 quantity = static_cast<uint32>(cur_rec->amountPerBatch * efficiency * (1.0 - m_tax) * item->quantity() / item->type().portionSize());
+            uint32 quantity = static_cast<uint32>(cur_rec->amountPerBatch * efficiency * (1.0 - tax) * item->quantity() / item->type().portionSize());
             if(quantity == 0)
                 continue;
 
@@ -289,14 +335,21 @@ PyResult ReprocessingServiceBound::Handle_Reprocess(PyCallArgs &call) {
 }
 
 double ReprocessingServiceBound::_CalcReprocessingEfficiency(const Client *c, InventoryItemRef item) const {
+    std::vector<InventoryItemRef> skills;
+    _GetSkills(c, skills);
+
+    return(_CalcReprocessingEfficiency(skills, item));
+}
+
+void ReprocessingServiceBound::_GetSkills(const Client *c, std::vector<InventoryItemRef> &into) const {
     std::set<EVEItemFlags> flags;
     flags.insert(flagSkill);
     flags.insert(flagSkillInTraining);
 
-    std::vector<InventoryItemRef> skills;
-
-    c->GetChar()->FindByFlagSet(flags, skills);
+    c->GetChar()->FindByFlagSet(flags, into);
+}
 
+double ReprocessingServiceBound::_CalcReprocessingEfficiency(const std::vector<InventoryItemRef> &skills, InventoryItemRef item) const {
     // formula is: reprocessingEfficiency + 0.375*(1 + 0.02*RefiningSkill)*(1 + 0.04*RefineryEfficiencySkill)*(1 + 0.05*OreProcessingSkill)
     // commented out until we have skills working different way ...
     double efficiency = 0.375;
@@ -319,14 +372,14 @@ double ReprocessingServiceBound::_CalcReprocessingEfficiency(const Client *c, In
     return(efficiency);
 }
 
-PyRep *ReprocessingServiceBound::_GetQuote(uint32 itemID, const Client *c) const {
+InventoryItemRef ReprocessingServiceBound::_GetQuoteItem(uint32 itemID, const Client *c) const {
     InventoryItemRef item = m_manager->item_factory.GetItem( itemID );
     if( !item )
-        return NULL;    // No action as GetQuote is also called for reprocessed items (probably for check)
+        return InventoryItemRef();  // No action as GetQuote is also called for reprocessed items (probably for check)
 
     if(item->ownerID() != c->GetCharacterID()) {
         _log(SERVICE__ERROR, "Character %u tried to reprocess item %u of character %u.", c->GetCharacterID(), item->itemID(), item->ownerID());
-        return NULL;
+        return InventoryItemRef();
     }
 
     if(item->quantity() < item->type().portionSize()) {
@@ -337,37 +390,59 @@ PyRep *ReprocessingServiceBound::_GetQuote(uint32 itemID, const Client *c) const
         throw(PyException(MakeUserError("QuantityLessThanMinimumPortion", args)));
     }
 
+    return item;
+}
+
+PyRep *ReprocessingServiceBound::_EncodeQuote(InventoryItemRef item, double efficiency, double standing, const std::vector<Recoverable> &recoverables) const {
+    const double tax = _CalcTax(standing);
+
     Rsp_GetQuote res;
     res.lines = new PyList;
     res.leftOvers = item->quantity() % item->type().portionSize();
     res.quantityToProcess = item->quantity() - res.leftOvers;
-    res.playerStanding = 0.0;   // hack
-
-    if(item->quantity() >= item->type().portionSize()) {
-        std::vector<Recoverable> recoverables;
-        if( !m_db.GetRecoverables( item->typeID(), recoverables ) )
-            return NULL;
-
-        double efficiency = _CalcReprocessingEfficiency(c, item);
+    res.playerStanding = standing;
 
-        std::vector<Recoverable>::const_iterator cur, end;
-        cur = recoverables.begin();
-        end = recoverables.end();
-        for(; cur != end; cur++)
-        {
-            uint32 ratio = cur->amountPerBatch * res.quantityToProcess / item->type().portionSize();
+    std::vector<Recoverable>::const_iterator cur, end;
+    cur = recoverables.begin();
+    end = recoverables.end();
+    for(; cur != end; cur++)
+    {
+        uint32 ratio = cur->amountPerBatch * res.quantityToProcess / item->type().portionSize();
 
-            Rsp_GetQuote_Recoverables_Line line;
+        Rsp_GetQuote_Recoverables_Line line;
 
-            line.typeID =           cur->typeID;
-            line.unrecoverable =    uint32((1.0 - efficiency)           * ratio);
-            line.station =          uint32(efficiency * m_tax           * ratio);
-            line.client =           uint32(efficiency * (1.0 - m_tax)   * ratio);
+        line.typeID =           cur->typeID;
+        line.unrecoverable =    uint32((1.0 - efficiency)           * ratio);
+        line.station =          uint32(efficiency * tax             * ratio);
+        line.client =           uint32(efficiency * (1.0 - tax)     * ratio);
 
-            res.lines->AddItem( line.Encode() );
-        }
+        res.lines->AddItem( line.Encode() );
     }
 
     return res.Encode();
 }
 
+PyRep *ReprocessingServiceBound::_GetQuote(uint32 itemID, const Client *c) const {
+    InventoryItemRef item = _GetQuoteItem(itemID, c);
+    if( !item )
+        return NULL;
+
+    std::vector<Recoverable> recoverables;
+    if( !m_db.GetRecoverables( item->typeID(), recoverables ) )
+        return NULL;
+
+    return _EncodeQuote(item, _CalcReprocessingEfficiency(c, item), _GetStanding(c), recoverables);
+}
+
+double ReprocessingServiceBound::_GetStanding(const Client *c) const {
+    return sStandingCache.GetEffectiveStanding(*c->GetChar(), m_stationOwnerID);
+}
+
+double ReprocessingServiceBound::_CalcTax(double standing) const {
+    // the take falls from the station's base at no standing to nothing at 6.67
+    double tax = m_tax * StationTaxesForReprocessing(standing).get_float() / 5.0;
+    if(tax < 0.0)
+        tax = 0.0;
+
+    return(tax);
+}
@@ -25,10 +25,12 @@
 
 #include "eve-server.h"
 
+#include "Client.h"
 #include "missions/Agent.h"
 
 Agent::Agent(uint32 id)
-: m_agentID(id)
+: m_agentID(id),
+  m_info(NULL)
 {
 }
 
@@ -42,7 +44,9 @@ Agent::~Agent() {
 }
 
 bool Agent::Load(MissionDB *from) {
-    return true;
+    //the agents are resident in the catalogue
+    m_info = sAgentCatalogue.GetAgent(m_agentID);
+    return(m_info != NULL);
 }
 
 uint32 Agent::GetLoyaltyPoints(Client *who) {
@@ -58,58 +62,92 @@ uint32 Agent::GetLoyaltyPoints(Client *who) {
  * missions out of order by only accepting the actions which were actually
  * "allocated" previously.)
  *
- *
- *
+ * We use fixed actionIDs (see Action); the offers and missions live in
+ * the agent catalogue, so a conversation queries nothing.
 */
 void Agent::DoAction(
     Client *who, uint32 actionID,
     std::string &say, std::map<uint32, std::string> &choices
 ) {
-    /*
-    if(actionID == 0) {
-        //default dialog...
-        choices[] = "I need something to do.";    //TODO: randomize this like they do on live
-
-    } else {
-
-    }
-
-
-
-    std::map<uint32, AgentActions *>::iterator res;
-    res = m_actions.find(actionID);
-    if(res == m_actions.end()) {
-        _log(AGENT__ERROR, "Agent %d: Unable to find action %u for '%s'", m_agentID, actionID, c->GetName());
-        say = "Invalid Action";
-        return;
+    const uint32 charID = who->GetCharacterID();
+
+    switch(actionID) {
+    case ACTION_REQUEST_MISSION: {
+        const AgentCatalogue::MissionInfo *mission = sAgentCatalogue.OfferMission(charID, m_agentID);
+        if(mission == NULL) {
+            say = "I have no work for you right now.";
+            break;
+        }
+
+        const AgentMissionState *state = sAgentCatalogue.GetMissionState(charID, m_agentID);
+        if(state != NULL && state->missionState == AgentCatalogue::MISSION_ACCEPTED) {
+            say = "You are still working on " + mission->missionName + " for me.";
+            choices[ACTION_COMPLETE] = "I have completed the mission.";
+            choices[ACTION_QUIT] = "I want to quit the mission.";
+        } else {
+            say = "I have a job for you: " + mission->missionName + ".";
+            choices[ACTION_ACCEPT] = "Accept";
+            choices[ACTION_DECLINE] = "Decline";
+        }
+    }   break;
+
+    case ACTION_ACCEPT:
+        if(sAgentCatalogue.AcceptMission(charID, m_agentID))
+            say = "Good. Report back to me when you are done.";
+        else
+            say = "I have not offered you anything.";
+        break;
+
+    case ACTION_DECLINE:
+    case ACTION_QUIT:
+        if(sAgentCatalogue.DeclineMission(charID, m_agentID))
+            say = "Very well. Come back when you want some work.";
+        else
+            say = "You have nothing to decline.";
+        choices[ACTION_REQUEST_MISSION] = "I want work, do you have anything?";
+        break;
+
+    case ACTION_COMPLETE:
+        if(sAgentCatalogue.CompleteMission(charID, m_agentID))
+            say = "Well done. I may have more work for you.";
+        else
+            say = "You have no mission to complete.";
+        choices[ACTION_REQUEST_MISSION] = "I want work, do you have anything?";
+        break;
+
+    case ACTION_LOCATE:
+        say = "I cannot help you with that yet.";
+        break;
+
+    default: {
+        const std::string &division = sAgentCatalogue.GetDivisionName(m_info->divisionID);
+        if(division.empty())
+            say = "What do you want? Spit it out, stooge.";
+        else
+            say = "This is " + division + ". What do you want? Spit it out, stooge.";
+
+        choices[ACTION_REQUEST_MISSION] = "I want work, do you have anything?";
+        choices[ACTION_LOCATE] = "I need to find somebody.  Can you help me?";
+    }   break;
     }
-    AgentActions *action = res->second;
-
-    say = action->agentSays;
-    choices = action->actions;
-    loyaltyPoints = action->loyaltyPoints;
-    */
-
-    say = "What do you want? Spit it out, stooge.";
-    choices[1] = "I want work, do you have anything?";
-    choices[2] = "I need to find somebody.  Can you help me?";
 }
 
-
-
-
-
-
-
-
-
-
-
-
-
-
-
-
-
-
-
+PyRep *Agent::GetMissionBriefingInfo(Client *who) {
+    const AgentMissionState *state = sAgentCatalogue.GetMissionState(who->GetCharacterID(), m_agentID);
+    if(state == NULL || state->missionState == AgentCatalogue::MISSION_COMPLETED)
+        return new PyNone;
+
+    const AgentCatalogue::MissionInfo *mission = sAgentCatalogue.GetMission(state->missionID);
+    if(mission == NULL)
+        return new PyNone;
+
+    PyDict *info = new PyDict;
+    info->SetItemString("missionID", new PyInt(mission->missionID));
+    info->SetItemString("missionName", new PyString(mission->missionName));
+    info->SetItemString("missionTypeName", new PyString(mission->missionTypeName));
+    info->SetItemString("missionLevel", new PyInt(mission->missionLevel));
+    info->SetItemString("importantMission", new PyBool(mission->importantMission));
+    info->SetItemString("missionState", new PyInt(state->missionState));
+    info->SetItemString("expirationTime", new PyLong((int64)state->expirationTime));
+    return info;
+}
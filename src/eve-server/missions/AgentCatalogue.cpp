@@ -0,0 +1,339 @@
+/*
+    ------------------------------------------------------------------------------------
+    LICENSE:
+    ------------------------------------------------------------------------------------
+    This file is part of EVEmu: EVE Online Server Emulator
+    Copyright 2006 - 2011 The EVEmu Team
+    For the latest information visit http://evemu.org
+    ------------------------------------------------------------------------------------
+    This program is free software; you can redistribute it and/or modify it under
+    the terms of the GNU Lesser General Public License as published by the Free Software
+    Foundation; either version 2 of the License, or (at your option) any later
+    version.
+
+    This program is distributed in the hope that it will be useful, but WITHOUT
+    ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+    FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public License along with
+    this program; if not, write to the Free Software Foundation, Inc., 59 Temple
+    Place - Suite 330, Boston, MA 02111-1307, USA, or go to
+    http://www.gnu.org/copyleft/lesser.txt.
+    ------------------------------------------------------------------------------------
+    Author:     EVEmu Team
+*/
+
+
+#include "eve-server.h"
+
+#include "missions/AgentCatalogue.h"
+
+const uint64 AgentCatalogue::OFFER_LIFETIME = Win32Time_Hour;
+const uint64 AgentCatalogue::MISSION_LIFETIME = Win32Time_Day;
+
+AgentCatalogue::AgentCatalogue()
+: mMissionsByLevel( 6 ),
+  mAgentsRowset( NULL )
+{
+}
+
+AgentCatalogue::~AgentCatalogue()
+{
+    PySafeDecRef( mAgentsRowset );
+}
+
+bool AgentCatalogue::Load()
+{
+    DBQueryResult res;
+    DBResultRow row;
+
+    if( !sDatabase.RunQuery( res,
+        "SELECT"
+        "  agt.agentID, agt.agentTypeID, agt.divisionID, agt.level, agt.quality, agt.corporationID,"
+        "  chr.stationID, sta.solarSystemID, bl.bloodlineID, chr.gender"
+        " FROM agtAgents AS agt"
+        " LEFT JOIN characterStatic AS chr ON chr.characterID = agt.agentID"
+        " LEFT JOIN staStations AS sta ON sta.stationID = chr.stationID"
+        " LEFT JOIN bloodlineTypes AS bl ON bl.bloodlineID = agt.agentTypeID" ) )
+    {
+        codelog( SERVICE__ERROR, "Error in query: %s", res.error.c_str() );
+        return false;
+    }
+
+    while( res.GetRow( row ) )
+    {
+        AgentInfo& agent = mAgents[ row.GetUInt( 0 ) ];
+        agent.agentID = row.GetUInt( 0 );
+        agent.agentTypeID = row.GetUInt( 1 );
+        agent.divisionID = row.GetUInt( 2 );
+        agent.level = row.GetUInt( 3 );
+        agent.quality = row.GetInt( 4 );
+        agent.corporationID = row.GetUInt( 5 );
+        agent.stationID = ( row.IsNull( 6 ) ? 0 : row.GetUInt( 6 ) );
+        agent.solarSystemID = ( row.IsNull( 7 ) ? 0 : row.GetUInt( 7 ) );
+        agent.bloodlineID = ( row.IsNull( 8 ) ? 0 : row.GetUInt( 8 ) );
+        agent.gender = ( row.IsNull( 9 ) ? 0 : row.GetUInt( 9 ) );
+    }
+
+    if( !sDatabase.RunQuery( res, "SELECT divisionID, divisionName FROM crpNPCDivisions" ) )
+    {
+        codelog( SERVICE__ERROR, "Error in query: %s", res.error.c_str() );
+        return false;
+    }
+
+    while( res.GetRow( row ) )
+        mDivisions[ row.GetUInt( 0 ) ] = row.GetText( 1 );
+
+    if( !sDatabase.RunQuery( res,
+        "SELECT"
+        "  mis.missionID, mis.missionName, mis.missionLevel, mis.missionTypeID, typ.missionTypeName, mis.importantMission"
+        " FROM agtMissions AS mis"
+        " LEFT JOIN agtMissionTypes AS typ ON typ.missionTypeID = mis.missionTypeID"
+        " ORDER BY mis.missionID" ) )
+    {
+        codelog( SERVICE__ERROR, "Error in query: %s", res.error.c_str() );
+        return false;
+    }
+
+    while( res.GetRow( row ) )
+    {
+        const size_t index = mMissions.size();
+
+        mMissions.push_back( MissionInfo() );
+        MissionInfo& mission = mMissions.back();
+        mission.missionID = row.GetUInt( 0 );
+        mission.missionName = row.GetText( 1 );
+        mission.missionLevel = row.GetUInt( 2 );
+        mission.missionTypeID = row.GetUInt( 3 );
+        mission.missionTypeName = ( row.IsNull( 4 ) ? "" : row.GetText( 4 ) );
+        mission.importantMission = ( 0 != row.GetUInt( 5 ) );
+
+        mMissionIndex[ mission.missionID ] = index;
+        if( mission.missionLevel < mMissionsByLevel.size() )
+            mMissionsByLevel[ mission.missionLevel ].push_back( index );
+    }
+
+    if( !sDatabase.RunQuery( res,
+        "SELECT corporationID, divisionID, level, missionID"
+        " FROM agtMissionGroups"
+        " WHERE missionID IS NOT NULL" ) )
+    {
+        codelog( SERVICE__ERROR, "Error in query: %s", res.error.c_str() );
+        return false;
+    }
+
+    while( res.GetRow( row ) )
+    {
+        std::tr1::unordered_map< uint32, size_t >::const_iterator mission = mMissionIndex.find( row.GetUInt( 3 ) );
+        if( mMissionIndex.end() == mission )
+            continue;
+
+        mMissionGroups[ _GroupKey( row.GetUInt( 0 ), row.GetUInt( 1 ), row.GetUInt( 2 ) ) ] = mission->second;
+    }
+
+    return true;
+}
+
+const AgentCatalogue::AgentInfo* AgentCatalogue::GetAgent( uint32 agentID ) const
+{
+    std::tr1::unordered_map< uint32, AgentInfo >::const_iterator res = mAgents.find( agentID );
+    return ( mAgents.end() == res ? NULL : &res->second );
+}
+
+const std::string& AgentCatalogue::GetDivisionName( uint32 divisionID ) const
+{
+    static const std::string unknown;
+
+    std::map< uint32, std::string >::const_iterator res = mDivisions.find( divisionID );
+    return ( mDivisions.end() == res ? unknown : res->second );
+}
+
+const AgentCatalogue::MissionInfo* AgentCatalogue::GetMission( uint32 missionID ) const
+{
+    std::tr1::unordered_map< uint32, size_t >::const_iterator res = mMissionIndex.find( missionID );
+    return ( mMissionIndex.end() == res ? NULL : &mMissions[ res->second ] );
+}
+
+PyRep* AgentCatalogue::GetAgentsRowset()
+{
+    if( NULL == mAgentsRowset )
+    {
+        DBRowDescriptor* header = new DBRowDescriptor();
+        header->AddColumn( "agentID",       DBTYPE_I4 );
+        header->AddColumn( "agentTypeID",   DBTYPE_I4 );
+        header->AddColumn( "divisionID",    DBTYPE_I4 );
+        header->AddColumn( "level",         DBTYPE_I4 );
+        header->AddColumn( "stationID",     DBTYPE_I4 );
+        header->AddColumn( "quality",       DBTYPE_I4 );
+        header->AddColumn( "corporationID", DBTYPE_I4 );
+        header->AddColumn( "bloodlineID",   DBTYPE_I4 );
+        header->AddColumn( "gender",        DBTYPE_I4 );
+
+        CRowSet* rowset = new CRowSet( &header );
+
+        // by agentID, as the query returned them
+        std::map< uint32, const AgentInfo* > agents;
+        std::tr1::unordered_map< uint32, AgentInfo >::const_iterator cur, end;
+        cur = mAgents.begin();
+        end = mAgents.end();
+        for(; cur != end; ++cur )
+            agents[ cur->first ] = &cur->second;
+
+        std::map< uint32, const AgentInfo* >::const_iterator cura, enda;
+        cura = agents.begin();
+        enda = agents.end();
+        for(; cura != enda; ++cura )
+        {
+            const AgentInfo& agent = *cura->second;
+
+            PyPackedRow* row = rowset->NewRow();
+            row->SetField( (uint32)0, new PyInt( agent.agentID ) );
+            row->SetField( 1, new PyInt( agent.agentTypeID ) );
+            row->SetField( 2, new PyInt( agent.divisionID ) );
+            row->SetField( 3, new PyInt( agent.level ) );
+            row->SetField( 4, new PyInt( agent.stationID ) );
+            row->SetField( 5, new PyInt( agent.quality ) );
+            row->SetField( 6, new PyInt( agent.corporationID ) );
+            row->SetField( 7, new PyInt( agent.bloodlineID ) );
+            row->SetField( 8, new PyInt( agent.gender ) );
+        }
+
+        mAgentsRowset = rowset;
+    }
+
+    PyIncRef( mAgentsRowset );
+    return mAgentsRowset;
+}
+
+const AgentMissionState* AgentCatalogue::GetMissionState( uint32 characterID, uint32 agentID )
+{
+    CharacterMissions* missions = _GetCharacter( characterID );
+    if( NULL == missions )
+        return NULL;
+
+    CharacterMissions::iterator res = missions->find( agentID );
+    if( missions->end() == res )
+        return NULL;
+
+    // expired offers are simply dropped, they were never persisted
+    if( MISSION_OFFERED == res->second.missionState && res->second.expirationTime <= Win32TimeNow() )
+    {
+        missions->erase( res );
+        return NULL;
+    }
+
+    return &res->second;
+}
+
+const AgentCatalogue::MissionInfo* AgentCatalogue::OfferMission( uint32 characterID, uint32 agentID )
+{
+    const AgentInfo* agent = GetAgent( agentID );
+    if( NULL == agent )
+        return NULL;
+
+    const AgentMissionState* state = GetMissionState( characterID, agentID );
+    if( NULL != state && MISSION_COMPLETED != state->missionState )
+        return GetMission( state->missionID );
+
+    const size_t index = _PickMission( characterID, *agent, ( NULL == state ? 0 : state->missionID ) );
+    if( mMissions.size() == index )
+        return NULL;
+
+    AgentMissionState& offer = ( *_GetCharacter( characterID ) )[ agentID ];
+    offer.missionID = mMissions[ index ].missionID;
+    offer.missionState = MISSION_OFFERED;
+    offer.expirationTime = Win32TimeNow() + OFFER_LIFETIME;
+
+    ++mStats.offers;
+
+    return &mMissions[ index ];
+}
+
+bool AgentCatalogue::AcceptMission( uint32 characterID, uint32 agentID )
+{
+    const AgentMissionState* state = GetMissionState( characterID, agentID );
+    if( NULL == state || MISSION_OFFERED != state->missionState )
+        return false;
+
+    AgentMissionState accepted = *state;
+    accepted.missionState = MISSION_ACCEPTED;
+    accepted.expirationTime = Win32TimeNow() + MISSION_LIFETIME;
+    if( !mDB.SaveMissionState( characterID, agentID, accepted ) )
+        return false;
+
+    ( *_GetCharacter( characterID ) )[ agentID ] = accepted;
+
+    ++mStats.accepted;
+    return true;
+}
+
+bool AgentCatalogue::DeclineMission( uint32 characterID, uint32 agentID )
+{
+    const AgentMissionState* state = GetMissionState( characterID, agentID );
+    if( NULL == state || MISSION_COMPLETED == state->missionState )
+        return false;
+
+    if( MISSION_ACCEPTED == state->missionState && !mDB.DeleteMissionState( characterID, agentID ) )
+        return false;
+
+    _GetCharacter( characterID )->erase( agentID );
+
+    ++mStats.declined;
+    return true;
+}
+
+bool AgentCatalogue::CompleteMission( uint32 characterID, uint32 agentID )
+{
+    const AgentMissionState* state = GetMissionState( characterID, agentID );
+    if( NULL == state || MISSION_ACCEPTED != state->missionState )
+        return false;
+
+    AgentMissionState completed = *state;
+    completed.missionState = MISSION_COMPLETED;
+    if( !mDB.SaveMissionState( characterID, agentID, completed ) )
+        return false;
+
+    ( *_GetCharacter( characterID ) )[ agentID ] = completed;
+
+    ++mStats.completed;
+    return true;
+}
+
+AgentCatalogue::CharacterMissions* AgentCatalogue::_GetCharacter( uint32 characterID )
+{
+    std::tr1::unordered_map< uint32, CharacterMissions >::iterator res = mCharacters.find( characterID );
+    if( mCharacters.end() != res )
+        return &res->second;
+
+    CharacterMissions missions;
+    if( !mDB.LoadMissionStates( characterID, missions ) )
+        return NULL;
+
+    ++mStats.characterLoads;
+
+    CharacterMissions& into = mCharacters[ characterID ];
+    into.swap( missions );
+    return &into;
+}
+
+size_t AgentCatalogue::_PickMission( uint32 characterID, const AgentInfo& agent, uint32 lastMissionID ) const
+{
+    // the mission group of the agent, if it has one
+    std::tr1::unordered_map< uint64, size_t >::const_iterator res = mMissionGroups.find( _GroupKey( agent.corporationID, agent.divisionID, agent.level ) );
+    if( mMissionGroups.end() != res )
+        return res->second;
+
+    if( agent.level >= mMissionsByLevel.size() || mMissionsByLevel[ agent.level ].empty() )
+        return mMissions.size();
+
+    // any mission of the level; the same one all day long for the character and the agent
+    const std::vector< size_t >& missions = mMissionsByLevel[ agent.level ];
+    const uint32 day = Win32TimeNow() / Win32Time_Day;
+    const uint32 hash = ( characterID * 2654435761u ) ^ ( agent.agentID * 40503u ) ^ day;
+
+    size_t pick = hash % missions.size();
+    if( lastMissionID == mMissions[ missions[ pick ] ].missionID )
+        pick = ( pick + 1 ) % missions.size();
+
+    return missions[ pick ];
+}
@@ -108,6 +108,11 @@ AgentMgrService::~AgentMgrService() {
     }
 }
 
+void AgentMgrService::PrimeCache() {
+    ObjectCachedMethodID method_id(GetName(), "GetAgents");
+    _CacheAgents(method_id);
+}
+
 Agent *AgentMgrService::_GetAgent(uint32 agentID) {
     std::map<uint32, Agent *>::iterator res;
     res = m_agents.find(agentID);
@@ -143,21 +148,21 @@ PyBoundObject *AgentMgrService::_CreateBoundObject(Client *c, const PyRep *bind_
 }
 
 
+void AgentMgrService::_CacheAgents(const ObjectCachedMethodID &method_id) {
+    //check to see if this method is in the cache already.
+    if(!m_manager->cache_service->IsCacheLoaded(method_id)) {
+        //this method is not in cache yet, build the contents from the agent catalogue and cache it.
+        PyRep *result = sAgentCatalogue.GetAgentsRowset();
+        m_manager->cache_service->GiveCache(method_id, &result);
+    }
+}
+
 PyResult AgentMgrService::Handle_GetAgents(PyCallArgs &call) {
     PyRep *result = NULL;
 
     ObjectCachedMethodID method_id(GetName(), "GetAgents");
 
-    //check to see if this method is in the cache already.
-    if(!m_manager->cache_service->IsCacheLoaded(method_id)) {
-        //this method is not in cache yet, load up the contents and cache it.
-        result = m_db.GetAgents();
-        if(result == NULL) {
-            codelog(SERVICE__ERROR, "Failed to load cache, generating empty contents.");
-            result = new PyNone();
-        }
-        m_manager->cache_service->GiveCache(method_id, &result);
-    }
+    _CacheAgents(method_id);
 
     //now we know its in the cache one way or the other, so build a
     //cached object cached method call result.
@@ -182,24 +187,33 @@ PyResult AgentMgrService::Handle_GetMyEpicJournalDetails( PyCallArgs& call )
 {
     //no args
 
-    sLog.Debug( "AgentMgrService", "Called GetMyEpicJournalDetails stub." );
+    _debug( "AgentMgrService", "Called GetMyEpicJournalDetails stub." );
 
     return new PyList;
 }
 
 
 PyResult AgentMgrService::Handle_GetSolarSystemOfAgent(PyCallArgs &call) {
+    Call_SingleIntegerArg args; //agentID
+    if(!args.Decode(&call.tuple)) {
+        codelog(SERVICE__ERROR, "%s: Bad arguments", call.client->GetName());
+        return NULL;
+    }
 
-    sLog.Debug("AgentMgrService", "Called GetSolarSystemOfAgent Stub.");
+    const AgentCatalogue::AgentInfo *agent = sAgentCatalogue.GetAgent(args.arg);
+    if(agent == NULL) {
+        codelog(SERVICE__ERROR, "%s: Unknown agent %u", call.client->GetName(), args.arg);
+        return NULL;
+    }
 
-    return NULL;
+    return new PyInt(agent->solarSystemID);
 }
 
 PyResult AgentMgrBound::Handle_GetInfoServiceDetails( PyCallArgs& call )
 {
     //takes no arguments
 
-    sLog.Debug( "AgentMgrBound", "Called GetInfoServiceDetails stub." );
+    _debug( "AgentMgrBound", "Called GetInfoServiceDetails stub." );
 
     return new PyNone;
 }
@@ -219,7 +233,10 @@ PyResult AgentMgrBound::Handle_DoAction(PyCallArgs &call) {
     res.dialogue = new PyList;
 
     std::map<uint32, std::string> choices;
-    if( !(args.arg->IsInt()) )
+    if( args.arg->IsNone() )
+        //starting the conversation
+        m_agent->DoAction( call.client, Agent::ACTION_GREETING, res.agentSays, choices );
+    else if( !(args.arg->IsInt()) )
     {
         sLog.Error( "AgentMgrBound::Handle_DoAction()", "args.arg->IsInt() failed.  Expected type Int, got type %s", args.arg->TypeString() );
     }
@@ -259,22 +276,19 @@ PyResult AgentMgrBound::Handle_GetMyJournalDetails(PyCallArgs &call) {
 }
 
 PyResult AgentMgrBound::Handle_GetMissionBriefingInfo(PyCallArgs &call) {
-
-    sLog.Debug("Server", "Called GetMissionBriefingInfo Stub.");
-
-    return NULL;
+    return m_agent->GetMissionBriefingInfo(call.client);
 }
 
 PyResult AgentMgrBound::Handle_GetAgentLocationWrap(PyCallArgs &call) {
 
-    sLog.Debug("Server", "Called GetAgentLocationWrap Stub.");
+    _debug("Server", "Called GetAgentLocationWrap Stub.");
 
     return NULL;
 }
 
 PyResult AgentMgrBound::Handle_GetMissionObjectiveInfo(PyCallArgs &call) {
 
-    sLog.Debug("Server", "Called GetMissionObjectiveInfo Stub.");
+    _debug("Server", "Called GetMissionObjectiveInfo Stub.");
 
     return NULL;
 }
@@ -48,7 +48,7 @@ DungeonExplorationMgrService::~DungeonExplorationMgrService()
 
 PyResult DungeonExplorationMgrService::Handle_GetMyEscalatingPathDetails(PyCallArgs &call) {
 
-    sLog.Debug("Server", "Called GetMyEscalatingPathDetails Stub.");
+    _debug("Server", "Called GetMyEscalatingPathDetails Stub.");
 
     return new PyList;
 }
@@ -27,30 +27,63 @@
 
 #include "missions/MissionDB.h"
 
-PyObjectEx *MissionDB::GetAgents() {
+bool MissionDB::LoadMissionStates(uint32 characterID, std::map<uint32, AgentMissionState> &into) {
     DBQueryResult res;
 
     if(!sDatabase.RunQuery(res,
         "SELECT"
-        "    agt.agentID,"
-        "    agt.agentTypeID,"
-        "    agt.divisionID,"
-        "    agt.level,"
-        "    chr.stationID,"
-        "    agt.quality,"
-        "    agt.corporationID,"
-        "    bl.bloodlineID,"
-        "    chr.gender"
-        " FROM agtAgents AS agt"
-        " LEFT JOIN characterStatic AS chr ON chr.characterID = agt.agentID"
-        " LEFT JOIN bloodlineTypes AS bl ON bl.bloodlineID = agt.agentTypeID"
+        "    agentID, missionID, missionState, expirationTime"
+        " FROM chrMissionState"
+        " WHERE characterID = %u",
+        characterID
     ))
     {
         codelog(SERVICE__ERROR, "Error in query: %s", res.error.c_str());
-        return NULL;
+        return false;
+    }
+
+    DBResultRow row;
+    while(res.GetRow(row)) {
+        AgentMissionState &state = into[row.GetUInt(0)];
+        state.missionID = row.GetUInt(1);
+        state.missionState = row.GetUInt(2);
+        state.expirationTime = row.GetUInt64(3);
+    }
+
+    return true;
+}
+
+bool MissionDB::SaveMissionState(uint32 characterID, uint32 agentID, const AgentMissionState &state) {
+    DBerror err;
+
+    if(!sDatabase.RunQuery(err,
+        "REPLACE INTO chrMissionState"
+        "    (characterID, agentID, missionID, missionState, expirationTime)"
+        " VALUES (%u, %u, %u, %u, %" PRIu64 ")",
+        characterID, agentID, state.missionID, state.missionState, state.expirationTime
+    ))
+    {
+        codelog(SERVICE__ERROR, "Error in query: %s", err.c_str());
+        return false;
+    }
+
+    return true;
+}
+
+bool MissionDB::DeleteMissionState(uint32 characterID, uint32 agentID) {
+    DBerror err;
+
+    if(!sDatabase.RunQuery(err,
+        "DELETE FROM chrMissionState"
+        " WHERE characterID = %u AND agentID = %u",
+        characterID, agentID
+    ))
+    {
+        codelog(SERVICE__ERROR, "Error in query: %s", err.c_str());
+        return false;
     }
 
-    return(DBResultToCRowset(res));
+    return true;
 }
 
 #ifdef NOT_DONE
@@ -88,7 +88,7 @@ PyBoundObject *MissionMgrService::_CreateBoundObject(Client *c, PyTuple *bind_ar
 PyResult MissionMgrService::Handle_GetMyCourierMissions( PyCallArgs& call )
 {
     //SELECT * FROM courierMissions
-    sLog.Debug( "MissionMgrService", "Called GetMyCourierMissions stub." );
+    _debug( "MissionMgrService", "Called GetMyCourierMissions stub." );
 
     return NULL;
 }
@@ -30,6 +30,7 @@
 #include "npc/NPCAI.h"
 #include "npc/SpawnManager.h"
 #include "ship/DestinyManager.h"
+#include "ship/DroneSwarm.h"
 #include "system/SystemManager.h"
 
 using namespace Destiny;
@@ -51,7 +52,8 @@ NPC::NPC(
 //  m_ownerID(self->ownerID()),
   m_corporationID(corporationID),
   m_allianceID(allianceID),
-  m_orbitingID(0)
+  m_orbitingID(0),
+  m_swarmed(false)
 {
     //NOTE: this is bad if we inherit NPC!
     m_AI = new NPCAIMgr(this);
@@ -60,7 +62,7 @@ NPC::NPC(
 
     /* Gets the value from the NPC and put on our own vars */
     //m_shieldCharge = self->shieldCharge();
-    m_shieldCharge = self->GetAttribute(AttrShieldCharge).get_float();
+    m_shieldCharge = self->GetAttributeValue(AttrShieldCharge);
     m_armorDamage = 0.0;
     m_hullDamage = 0.0;
 }
@@ -70,6 +72,8 @@ NPC::~NPC() {
     //possibility of any of these things making virtual calls...
     //
     // this makes inheriting NPC a bad idea (see constructor)
+    if(m_swarmed)
+        m_system->drones().Remove(this);
     m_system->RemoveNPC(this);
     if(m_spawner != NULL)
         m_spawner->SpawnDepoped(m_self->itemID());
@@ -79,7 +83,8 @@ NPC::~NPC() {
 
 void NPC::Process() {
     SystemEntity::Process();
-    m_AI->Process();
+    if(!m_swarmed)
+        m_AI->Process();
 }
 
 void NPC::Orbit(SystemEntity *who) {
@@ -101,11 +106,13 @@ bool NPC::Load(ServiceDB &from) {
 }
 
 void NPC::TargetLost(SystemEntity *who) {
-    m_AI->TargetLost(who);
+    if(!m_swarmed)
+        m_AI->TargetLost(who);
 }
 
 void NPC::TargetedAdd(SystemEntity *who) {
-    m_AI->Targeted(who);
+    if(!m_swarmed)
+        m_AI->Targeted(who);
 }
 
 void NPC::EncodeDestiny( Buffer& into ) const
@@ -195,15 +202,15 @@ void NPC::EncodeDestiny( Buffer& into ) const
 
 void NPC::MakeDamageState(DoDestinyDamageState &into) const {
     //into.shield = m_shieldCharge / m_self->shieldCapacity();
-    into.shield = m_shieldCharge / m_self->GetAttribute(AttrShieldCapacity).get_float();
+    into.shield = m_shieldCharge / m_self->GetAttributeValue(AttrShieldCapacity);
     into.tau = 100000;    //no freakin clue.
     into.timestamp = Win32TimeNow();
     //into.armor = 1.0 - (m_armorDamage / m_self->armorHP());
     //into.structure = 1.0 - (m_hullDamage / m_self->hp());
 
     // the get_float is still a hack... majorly
-    into.armor = 1.0 - (m_armorDamage / m_self->GetAttribute(AttrArmorHP).get_float());
-    into.structure = 1.0 - (m_hullDamage / m_self->GetAttribute(AttrHp).get_float());
+    into.armor = 1.0 - (m_armorDamage / m_self->GetAttributeValue(AttrArmorHP));
+    into.structure = 1.0 - (m_hullDamage / m_self->GetAttributeValue(AttrHp));
 }
 
 void NPC::UseShieldRecharge()
@@ -28,17 +28,32 @@
 #include "inventory/AttributeEnum.h"
 #include "npc/NPC.h"
 #include "npc/NPCAI.h"
+#include "npc/SpawnManager.h"
 #include "ship/DestinyManager.h"
 #include "system/Damage.h"
+#include "system/SystemManager.h"
+
+/**
+ * @return Offset (in milliseconds) of the NPC's look-arounds within the proximity period.
+ *
+ * The NPCs of a spawn share an offset, so they share their proximity
+ * query, while different spawns look around at different times.
+ */
+static int32 GetThinkPhase(const NPC *who, int32 period) {
+    const uint32 key = (who->GetSpawner() != NULL ? who->GetSpawner()->GetID() : who->GetID());
+    return(static_cast<int32>((key * 7919) % period));
+}
 
 NPCAIMgr::NPCAIMgr(NPC *who)
 : m_state(Idle),
   m_entityFlyRange2(who->Item()->GetAttribute(AttrEntityFlyRange)*who->Item()->GetAttribute(AttrEntityFlyRange)),
   m_entityChaseMaxDistance2(who->Item()->GetAttribute(AttrEntityChaseMaxDistance)*who->Item()->GetAttribute(AttrEntityChaseMaxDistance)),
   m_entityAttackRange2(who->Item()->GetAttribute(AttrEntityAttackRange)*who->Item()->GetAttribute(AttrEntityAttackRange)),
+  m_proximityRange(who->Item()->GetAttribute(AttrProximityRange)),
   m_npc(who),
   m_processTimer(50),    //arbitrary.
   m_mainAttackTimer(1),    //we want this to always trigger the first time through.
+  m_proximityTimer(Timer::GetCurrentTime() + GetThinkPhase(who, 1000) - 1000, 1000, false),    //arbitrary period, staggered.
   m_shieldBoosterTimer(static_cast<int32>(who->Item()->GetAttribute(AttrEntityShieldBoostDuration).get_int())),
   m_armorRepairTimer(static_cast<int32>(who->Item()->GetAttribute(AttrEntityArmorRepairDuration).get_int()))
 {
@@ -57,6 +72,13 @@ void NPCAIMgr::Process() {
     if(!m_processTimer.Check())
         return;
 
+    const uint64 start = GetTimeUSeconds();
+    _Think();
+    if(m_npc->System() != NULL)
+        m_npc->System()->AddAIThink(static_cast<uint32>(GetTimeUSeconds() - start));
+}
+
+void NPCAIMgr::_Think() {
     // Test to see if we have a Shield Booster
     if( m_shieldBoosterTimer.Enabled() )
     {
@@ -77,11 +99,18 @@ void NPCAIMgr::Process() {
     }
 
     switch(m_state) {
-    case Idle:
+    case Idle: {
         //TODO: wander around?
-        //TODO: look around for shit to shoot at?
-        //         The parameter proximityRange tells us how far we "see"
-        break;
+        if(!m_proximityTimer.Check())
+            break;
+
+        //look around for something to shoot at.
+        SystemEntity *target = _FindProximityTarget();
+        if(target != NULL) {
+            _log(NPC__AI_TRACE, "[%u] Spotted %u in Idle.", m_npc->GetID(), target->GetID());
+            Targeted(target);
+        }
+    } break;
 
     case Chasing: {
         //NOTE: getting our target like this is pretty weak...
@@ -240,6 +269,47 @@ void NPCAIMgr::TargetLost(SystemEntity *by_who) {
     }
 }
 
+SystemEntity *NPCAIMgr::_FindProximityTarget() const {
+    //The parameter proximityRange tells us how far we "see",
+    //no point in looking further than we can lock though.
+    EvilNumber proximityRange = m_proximityRange;   //get_float() is not const
+    const double range = std::min<double>(proximityRange.get_float(), m_npc->targets.GetMaxTargetRange());
+    if(range <= 0.0)
+        return NULL;
+
+    SystemManager *system = m_npc->System();
+    if(system == NULL)
+        return NULL;
+
+    //the NPCs of a spawn share a single query around the whole group.
+    std::vector<SystemEntity *> candidates;
+    if(m_npc->GetSpawner() != NULL)
+        m_npc->GetSpawner()->GetNearbyClients(range, candidates);
+    else
+        system->bubbles.GetEntitiesInRange(m_npc->GetPosition(), range, candidates);
+
+    //pick the closest player.
+    SystemEntity *target = NULL;
+    double target_dist2 = 0.0;
+
+    std::vector<SystemEntity *>::const_iterator cur, end;
+    cur = candidates.begin();
+    end = candidates.end();
+    for(; cur != end; cur++) {
+        if(!(*cur)->IsClient())
+            continue;
+
+        double dist2 = m_npc->DistanceTo2(*cur);
+        if(dist2 > range * range)
+            continue;
+        if(target == NULL || dist2 < target_dist2) {
+            target = *cur;
+            target_dist2 = dist2;
+        }
+    }
+    return target;
+}
+
 void NPCAIMgr::CheckAttacks(SystemEntity *target) {
     if(m_mainAttackTimer.Check(false)) {
         _log(NPC__AI_TRACE, "[%u] Attack timer expired. Attacking %u.", m_npc->GetID(), target->GetID());
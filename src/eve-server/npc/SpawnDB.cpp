@@ -28,22 +28,15 @@
 #include "npc/SpawnDB.h"
 #include "npc/SpawnManager.h"
 
-bool SpawnDB::LoadSpawnGroups(uint32 solarSystemID, std::map<uint32, SpawnGroup *> &into) {
+bool SpawnDB::LoadSpawnGroups(std::map<uint32, SpawnGroup *> &into) {
     DBQueryResult res;
 
-    //we could avoid this join by doing the `spawns` select first and collecting the
-    //spawn group IDs needed... but this is fine for now.
-
     if(!sDatabase.RunQuery(res,
         "SELECT "
-        " spawnGroups.spawnGroupID,"
-        " spawnGroups.spawnGroupName,"
-        " spawnGroups.formation"
-        " FROM spawns "
-        "   LEFT JOIN spawnGroups ON spawnGroups.spawnGroupID=spawns.spawnGroupID"
-        " WHERE spawns.solarSystemID=%u"
-        " GROUP BY spawnGroups.spawnGroupID",
-            solarSystemID))
+        " spawnGroupID,"
+        " spawnGroupName,"
+        " formation"
+        " FROM spawnGroups"))
     {
         codelog(SPAWN__ERROR, "Error in query: %s", res.error.c_str());
         return false;
@@ -59,19 +52,8 @@ bool SpawnDB::LoadSpawnGroups(uint32 solarSystemID, std::map<uint32, SpawnGroup
         into[ g->id ] = g;
     }
 
-    //now collect the IDs of the groups to build a nice where clause (keep the query/join count down)
-    std::vector<int32> groupIDs;
-    std::map<uint32, SpawnGroup *>::iterator cur, end;
-    cur = into.begin();
-    end = into.end();
-    for(; cur != end; cur++) {
-        groupIDs.push_back(cur->first);
-    }
-
     //now select all the spawn group entries.
-    std::string INstr;
-    ListToINString(groupIDs, INstr, "-1");
-
+    std::map<uint32, SpawnGroup *>::iterator cur, end;
     if(!sDatabase.RunQuery(res,
         "SELECT "
         " spawnGroupID,"
@@ -80,9 +62,7 @@ bool SpawnDB::LoadSpawnGroups(uint32 solarSystemID, std::map<uint32, SpawnGroup
         " probability,"
         " ownerID,"
         " corporationID"
-        " FROM spawnGroupEntries "
-        " WHERE spawnGroupID IN (%s)",
-            INstr.c_str()))
+        " FROM spawnGroupEntries"))
     {
         codelog(SPAWN__ERROR, "Error in query: %s", res.error.c_str());
 
@@ -112,121 +92,84 @@ bool SpawnDB::LoadSpawnGroups(uint32 solarSystemID, std::map<uint32, SpawnGroup
         }
 
         cur->second->entries.push_back(entry);
+        cur->second->maxMembers += entry.quantity;
     }
 
     return true;
 }
 
-
-
-
-bool SpawnDB::LoadSpawnEntries(uint32 solarSystemID, const std::map<uint32, SpawnGroup *> &groups, std::map<uint32, SpawnEntry *> &into) {
+bool SpawnDB::LoadSpawnPoints(const std::map<uint32, SpawnGroup *> &groups, std::map<uint32, std::vector<SpawnPoint> > &into) {
     DBQueryResult res;
 
-    //we could avoid this join by doing the `spawns` select first and collecting the
-    //spawn group IDs needed... but this is fine for now.
-
     if(!sDatabase.RunQuery(res,
         "SELECT "
         " spawnID,"
+        " solarSystemID,"
         " spawnGroupID,"
         " spawnBoundType,"
         " spawnTimer,"
         " respawnTimeMin,"
         " respawnTimeMax"
-        " FROM spawns "
-        " WHERE solarSystemID=%u",
-            solarSystemID))
+        " FROM spawns"
+        " ORDER BY solarSystemID, spawnID"))
     {
         codelog(SPAWN__ERROR, "Error in query: %s", res.error.c_str());
         return false;
     }
 
-    DBResultRow row;
-    uint32 now = Timer::GetTimeSeconds();
+    //where the spawns are, by spawnID, to attach their bounds.
+    std::map<uint32, std::pair<uint32, size_t> > slots;
 
-    std::map<uint32, SpawnGroup *>::const_iterator result;
+    DBResultRow row;
     while(res.GetRow(row)) {
         //process group
-        uint32 groupID = row.GetUInt(1);
-        result = groups.find(groupID);
-        if(result == groups.end()) {
-            _log(SPAWN__ERROR, "Error loading spawn entry %u: Unable to find spawn group %u. Skipping.", row.GetUInt(0), row.GetUInt(1));
+        if(groups.find(row.GetUInt(2)) == groups.end()) {
+            _log(SPAWN__ERROR, "Error loading spawn entry %u: Unable to find spawn group %u. Skipping.", row.GetUInt(0), row.GetUInt(2));
             continue;
         }
 
         //process bounds type
         SpawnEntry::SpawnBoundsType boundsType;
-        switch(row.GetUInt(2)) {    //enum checking.
+        switch(row.GetUInt(3)) {    //enum checking.
             case SpawnEntry::boundsPoint:       boundsType = SpawnEntry::boundsPoint; break;
             case SpawnEntry::boundsLine:        boundsType = SpawnEntry::boundsLine; break;
             //case SpawnEntry::boundsTriangle:  boundsType = SpawnEntry::boundsTriangle; break;
             //case SpawnEntry::boundsSquare:    boundsType = SpawnEntry::boundsSquare; break;
             case SpawnEntry::boundsCube:        boundsType = SpawnEntry::boundsCube; break;
             default:
-                _log(SPAWN__ERROR, "Error loading spawn entry %u: Bounds type %u is invalid. Skipping.", row.GetUInt(0), row.GetUInt(2));
+                _log(SPAWN__ERROR, "Error loading spawn entry %u: Bounds type %u is invalid. Skipping.", row.GetUInt(0), row.GetUInt(3));
                 continue;
         }
 
-        //convert stored timer value into a future milliseconds timer.
-        uint32 timer_val = row.GetUInt(3);
-        if(timer_val <= now)
-            timer_val = 1;  //1 is just as good as 0, without the special implications
-        else
-            timer_val = (timer_val - now) * 1000;
-
-        SpawnEntry *e = new SpawnEntry(
-            row.GetUInt(0),
-            *result->second,
-            row.GetUInt(4),
-            row.GetUInt(5),
-            timer_val,
-            boundsType
-        );
-        into[ e->GetID() ] = e;
+        std::vector<SpawnPoint> &points = into[ row.GetUInt(1) ];
+        slots[ row.GetUInt(0) ] = std::make_pair(row.GetUInt(1), points.size());
+
+        points.push_back(SpawnPoint());
+        SpawnPoint &p = points.back();
+        p.spawnID = row.GetUInt(0);
+        p.spawnGroupID = row.GetUInt(2);
+        p.boundsType = boundsType;
+        p.spawnTimer = row.GetUInt(4);
+        p.respawnTimeMin = row.GetUInt(5);
+        p.respawnTimeMax = row.GetUInt(6);
     }
 
     /*
      * Next, we need to select the bounds of each spawn entry.
      */
-    //now collect the IDs of the entries to build a nice where clause (keep the query/join count down)
-    std::vector<int32> entryIDs;
-    std::map<uint32, SpawnEntry *>::iterator cur, end, tmp;
-    cur = into.begin();
-    end = into.end();
-    for(; cur != end; cur++) {
-        entryIDs.push_back(cur->first);
-    }
-
-    //now select all the spawn group entries.
-    std::string INstr;
-    ListToINString(entryIDs, INstr, "-1");
-
-    //we could avoid this order by clause by exposing the `m_bounds` member of SpawnEntry
     if(!sDatabase.RunQuery(res,
         "SELECT "
         " spawnID,"
         " pointIndex,"
         " x, y, z"
-        " FROM spawnBounds "
-        " WHERE spawnID IN (%s)",
-            INstr.c_str()))
+        " FROM spawnBounds"))
     {
         codelog(SPAWN__ERROR, "Error in query: %s", res.error.c_str());
-
-        //free up all the stuff we allocated.
-        cur = into.begin();
-        end = into.end();
-        for(; cur != end; cur++) {
-            delete cur->second;
-        }
         into.clear();
-
         return false;
     }
 
     while(res.GetRow(row)) {
-        //this could be more optimized, but I just wanna get it working right now...
         uint32 id = row.GetUInt(0);
         uint32 index = row.GetUInt(1);
         GPoint p(
@@ -234,53 +177,17 @@ bool SpawnDB::LoadSpawnEntries(uint32 solarSystemID, const std::map<uint32, Spaw
             row.GetDouble(3),
             row.GetDouble(4) );
 
-        cur = into.find(id);
-        if(cur == into.end()) {
+        std::map<uint32, std::pair<uint32, size_t> >::const_iterator slot = slots.find(id);
+        if(slot == slots.end()) {
             _log(SPAWN__ERROR, "Loading spawn group entry failed, unable to find entry %u for bound point %u,%u", id, id, index);
             continue;
         }
 
-        if(cur->second->bounds.size() <= index)
-            cur->second->bounds.resize(index+1);
-        cur->second->bounds[index] = p;
-    }
-
-    //make sure bounds are loaded properly for each spawn entry...
-    cur = into.begin();
-    while(cur != into.end()) {
-        if(!cur->second->CheckBounds()) {
-            _log(SPAWN__ERROR, "Spawn entry %u removed due to invalid bounds.", cur->first);
-            delete cur->second;
-            tmp = cur;
-            cur++;
-            into.erase(tmp);
-        } else {
-            cur++;
-        }
+        std::vector<GPoint> &bounds = into[ slot->second.first ][ slot->second.second ].bounds;
+        if(bounds.size() <= index)
+            bounds.resize(index+1);
+        bounds[index] = p;
     }
 
     return true;
 }
-
-
-
-
-
-
-
-
-
-
-
-
-
-
-
-
-
-
-
-
-
-
-
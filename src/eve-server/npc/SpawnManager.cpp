@@ -28,6 +28,8 @@
 #include "PyServiceMgr.h"
 #include "npc/NPC.h"
 #include "npc/SpawnManager.h"
+#include "npc/SpawnTable.h"
+#include "ship/DestinyManager.h"
 #include "system/SystemManager.h"
 
 SpawnGroup::Entry::Entry(
@@ -49,13 +51,14 @@ SpawnGroup::Entry::Entry(
 SpawnGroup::SpawnGroup(uint32 _id, const char *_name, uint32 _formation)
 : id(_id),
   name(_name),
-  formation(_formation)
+  formation(_formation),
+  maxMembers(0)
 {
 }
 
 SpawnEntry::SpawnEntry(
     uint32 id,
-    SpawnGroup &group,
+    const SpawnGroup &group,
     uint32 timerMin,
     uint32 timerMax,
     uint32 timerValue,
@@ -64,7 +67,11 @@ SpawnEntry::SpawnEntry(
   m_group(group),
   m_timerMin(timerMin),
   m_timerMax(timerMax),
-  m_timer(timerValue),
+  m_timerValue(timerValue),
+  m_nearbyStamp(0),
+  m_nearbyRange(-1.0),
+  m_system(NULL),
+  m_services(NULL),
   m_boundsType(boundsType)
 {
 }
@@ -76,13 +83,6 @@ SpawnManager::SpawnManager(SystemManager &mgr, PyServiceMgr &svc)
 }
 
 SpawnManager::~SpawnManager() {
-    std::map<uint32, SpawnGroup *>::iterator curs, ends;
-    curs = m_groups.begin();
-    ends = m_groups.end();
-    for(; curs != ends; curs++) {
-        delete curs->second;
-    }
-
     std::map<uint32, SpawnEntry *>::iterator cure, ende;
     cure = m_spawns.begin();
     ende = m_spawns.end();
@@ -91,15 +91,81 @@ SpawnManager::~SpawnManager() {
     }
 }
 
-void SpawnEntry::Process(SystemManager &mgr, PyServiceMgr &svc) {
-    if(m_timer.Check()) {
-        if(!m_spawnedIDs.empty()) {
-            _log(SPAWN__ERROR, "ERROR: spawn entry %u's timer went off when we have active spawn IDs!", m_id);
-            m_spawnedIDs.clear();
+void SpawnEntry::Start(SystemManager &mgr, PyServiceMgr &svc) {
+    m_system = &mgr;
+    m_services = &svc;
+
+    //zero timer never goes off.
+    if(m_timerValue != 0)
+        sTimerWheel.Schedule(this, m_timerValue);
+}
+
+void SpawnEntry::TimerExpired() {
+    if(!m_spawnedIDs.empty()) {
+        _log(SPAWN__ERROR, "ERROR: spawn entry %u's timer went off when we have active spawn IDs!", m_id);
+        m_spawnedIDs.clear();
+    }
+
+    //time to spawn...
+    _DoSpawn(*m_system, *m_services);
+}
+
+void SpawnEntry::GetNearbyClients(double range, std::vector<SystemEntity *> &into) {
+    if(m_system == NULL)
+        return;
+
+    const uint32 stamp = DestinyManager::GetStamp();
+    if(stamp != m_nearbyStamp || m_nearbyRange < range) {
+        m_nearbyClients.clear();
+        m_nearbyStamp = stamp;
+        m_nearbyRange = range;
+
+        //find the middle of the group and how far it spreads.
+        std::vector<SystemEntity *> members;
+        GVector sum(0.0, 0.0, 0.0);
+
+        std::set<uint32>::const_iterator cur, end;
+        cur = m_spawnedIDs.begin();
+        end = m_spawnedIDs.end();
+        for(; cur != end; cur++) {
+            SystemEntity *se = m_system->get(*cur);
+            if(se == NULL)
+                continue;
+
+            members.push_back(se);
+            sum += GVector(se->GetPosition());
+        }
+        if(members.empty())
+            return;
+
+        const GPoint center(sum / double(members.size()));
+        double spread2 = 0.0;
+
+        std::vector<SystemEntity *>::const_iterator curm, endm;
+        curm = members.begin();
+        endm = members.end();
+        for(; curm != endm; curm++)
+            spread2 = std::max(spread2, GVector(center, (*curm)->GetPosition()).lengthSquared());
+
+        std::vector<SystemEntity *> found;
+        m_system->bubbles.GetEntitiesInRange(center, range + sqrt(spread2), found);
+
+        std::vector<SystemEntity *>::const_iterator curf, endf;
+        curf = found.begin();
+        endf = found.end();
+        for(; curf != endf; curf++) {
+            if((*curf)->IsClient())
+                m_nearbyClients.push_back((*curf)->GetID());
         }
+    }
 
-        //time to spawn...
-        _DoSpawn(mgr, svc);
+    std::vector<uint32>::const_iterator cur, end;
+    cur = m_nearbyClients.begin();
+    end = m_nearbyClients.end();
+    for(; cur != end; cur++) {
+        SystemEntity *se = m_system->get(*cur);
+        if(se != NULL)
+            into.push_back(se);
     }
 }
 
@@ -127,9 +193,10 @@ void SpawnEntry::_DoSpawn(SystemManager &mgr, PyServiceMgr &svc) {
     }
     _log(SPAWN__POP, "    selected point (%.1f, %.1f, %.1f)", spawn_point.x, spawn_point.y, spawn_point.z);
 
-    std::vector<NPC *> spawned;
+    //roll the whole group first, so the NPCs are created in one go.
+    std::vector<const SpawnGroup::Entry *> members;
+    members.reserve(m_group.maxMembers);
 
-    //now see what is gunna spawn...
     std::vector<SpawnGroup::Entry>::const_iterator cur, end;
     cur = m_group.entries.begin();
     end = m_group.entries.end();
@@ -145,70 +212,66 @@ void SpawnEntry::_DoSpawn(SystemManager &mgr, PyServiceMgr &svc) {
                 _log(SPAWN__POP, "        [%d] passed proability check of p=%.4f", r, cur->probability);
             }
 
-            //NOTE: this is currently creating an entry in the DB...
-            //which is terrible... we need to make an "in-memory only"
-            // item concept.
-            ItemData idata(
-                cur->npcTypeID,
-                cur->ownerID,    //owner
-                mgr.GetID(),
-                flagAutoFit
-            );
-
-            InventoryItemRef i = svc.item_factory.SpawnItem(idata);
-            if( !i ) {
-                _log(SPAWN__ERROR, "Failed to spawn item with type %u for group %u.", cur->npcTypeID, cur->spawnGroupID);
-                continue;
-            }
-
-            _log(SPAWN__POP, "        [%d] spawning NPC id %u", r, i->itemID());
-
-            //create them all at the same point to start with...
-            //we will move them before they get added to the system
-            NPC *npc = new NPC(&mgr, svc,
-                i, cur->corporationID, 0, spawn_point, this);    //TODO: add allianceID
-            spawned.push_back(npc);
+            members.push_back(&*cur);
         }
     }
 
-    if(spawned.empty()) {
+    if(members.empty()) {
         int32 timer = static_cast<int32>(MakeRandomInt(m_timerMin, m_timerMax));
         _log(SPAWN__POP, "No NPCs produced by spawn entry %u. Resetting spawn timer to %d s.", m_id, timer);
-        m_timer.Start(timer*1000);
+        sTimerWheel.Schedule(this, timer*1000);
         return;
     }
 
     //TODO: apply formation..
-    //hacking it for now...
-    std::vector<NPC *>::iterator curn, endn;
-    curn = spawned.begin();
-    endn = spawned.end();
-    for(; curn != endn; curn++) {
-        _log(SPAWN__POP, "Moving NPC %u to (%.1f, %.1f, %.1f) due to formation.", (*curn)->GetID(), spawn_point.x, spawn_point.y, spawn_point.z);
-        (*curn)->ForcedSetPosition(spawn_point);
-        spawn_point.y += 1000.0f;
-    }
+    //hacking it for now, they line up along y.
+    std::vector<const SpawnGroup::Entry *>::const_iterator curm, endm;
+    curm = members.begin();
+    endm = members.end();
+    for(; curm != endm; curm++) {
+        //the NPCs come and go all the time, so their items live in memory only.
+        ItemData idata(
+            (*curm)->npcTypeID,
+            (*curm)->ownerID,    //owner
+            mgr.GetID(),
+            flagAutoFit
+        );
+
+        InventoryItemRef i = svc.item_factory.SpawnTransientItem(idata);
+        if( !i ) {
+            _log(SPAWN__ERROR, "Failed to spawn item with type %u for group %u.", (*curm)->npcTypeID, (*curm)->spawnGroupID);
+            continue;
+        }
+
+        _log(SPAWN__POP, "Spawning NPC %u at (%.1f, %.1f, %.1f).", i->itemID(), spawn_point.x, spawn_point.y, spawn_point.z);
 
+        NPC *npc = new NPC(&mgr, svc,
+            i, (*curm)->corporationID, 0, spawn_point, this);    //TODO: add allianceID
+        spawn_point.y += 1000.0f;
 
-    //now the NPCs are all set up, lets drop them into the system.
-    curn = spawned.begin();
-    endn = spawned.end();
-    for(; curn != endn; curn++) {
         //load up any NPC attributes...
-        if(!(*curn)->Load(svc.serviceDB())) {
-            _log(SPAWN__POP, "Failed to load NPC data for NPC %u with type %u, depoping.", (*curn)->GetID(), (*curn)->Item()->typeID());
-            delete *curn;
+        if(!npc->Load(svc.serviceDB())) {
+            _log(SPAWN__POP, "Failed to load NPC data for NPC %u with type %u, depoping.", npc->GetID(), i->typeID());
+            delete npc;
             continue;
         }
 
         //record this NPC as something we spawned.
-        m_spawnedIDs.insert((*curn)->GetID());
+        m_spawnedIDs.insert(npc->GetID());
 
-        mgr.AddNPC(*curn);
+        mgr.AddNPC(npc);
     }
 
+    if(m_spawnedIDs.empty()) {
+        int32 timer = static_cast<int32>(MakeRandomInt(m_timerMin, m_timerMax));
+        _log(SPAWN__ERROR, "Spawn entry %u failed to spawn any NPC. Resetting spawn timer to %d s.", m_id, timer);
+        sTimerWheel.Schedule(this, timer*1000);
+        return;
+    }
+    sSpawnTable.CountSpawn(m_spawnedIDs.size());
+
     //timer is disabled while the spawn is up.
-    m_timer.Disable();
+    sTimerWheel.Cancel(this);
 }
 
 void SpawnEntry::SpawnDepoped(uint32 npcID) {
@@ -220,12 +283,13 @@ void SpawnEntry::SpawnDepoped(uint32 npcID) {
     } else {
         _log(SPAWN__DEPOP, "NPC %u depopped for spawn entry %u", npcID, m_id);
         m_spawnedIDs.erase(res);
+        sSpawnTable.CountDepop();
     }
 
     if(m_spawnedIDs.empty()) {
         int32 timer = static_cast<int32>(MakeRandomInt(m_timerMin, m_timerMax));
         _log(SPAWN__DEPOP, "Spawn entry %u's entire spawn group has depopped, resetting timer to %d s.", m_id, timer);
-        m_timer.Start(timer*1000);
+        sTimerWheel.Schedule(this, timer*1000);
     }
 }
 
@@ -263,37 +327,60 @@ bool SpawnEntry::CheckBounds() const {
 
 
 bool SpawnManager::Load() {
-    //TODO: prune any invCategories::Entity items from the system. They
-    // all get spawned by the spawn manager! Unless somebody changes
-    // the spawn manager to be more persistent. This would require a table
-    // mapping the entity table to the spawns table
-    // (Drones too?)
-    if(!m_db.LoadSpawnGroups(m_system.GetID(), m_groups)) {
-        _log(SPAWN__ERROR, "Failed to load spawn groups for system %u!", m_system.GetID());
-        return false;
-    }
+    //the spawns of all the systems are loaded at startup, see SpawnTable.
+    const std::vector<SpawnPoint> *points = sSpawnTable.GetSpawns(m_system.GetID());
+    if(points == NULL)
+        return true;
 
-    if(!m_db.LoadSpawnEntries(m_system.GetID(), m_groups, m_spawns)) {
-        _log(SPAWN__ERROR, "Failed to load spawn entries for system %u!", m_system.GetID());
-        return false;
+    uint32 now = Timer::GetTimeSeconds();
+
+    std::vector<SpawnPoint>::const_iterator cur, end;
+    cur = points->begin();
+    end = points->end();
+    for(; cur != end; cur++) {
+        const SpawnGroup *group = sSpawnTable.GetGroup(cur->spawnGroupID);
+        if(group == NULL)
+            continue;
+
+        //convert stored timer value into a future milliseconds timer.
+        uint32 timer_val = cur->spawnTimer;
+        if(timer_val <= now)
+            timer_val = 1;  //1 is just as good as 0, without the special implications
+        else
+            timer_val = (timer_val - now) * 1000;
+
+        SpawnEntry *e = new SpawnEntry(
+            cur->spawnID,
+            *group,
+            cur->respawnTimeMin,
+            cur->respawnTimeMax,
+            timer_val,
+            cur->boundsType
+        );
+        e->bounds = cur->bounds;
+
+        //make sure bounds are loaded properly for each spawn entry...
+        if(!e->CheckBounds()) {
+            _log(SPAWN__ERROR, "Spawn entry %u removed due to invalid bounds.", e->GetID());
+            delete e;
+            continue;
+        }
+
+        m_spawns[ e->GetID() ] = e;
     }
 
     return true;
 }
 
 bool SpawnManager::DoInitialSpawn() {
-    //right now, just running through Process will spawn what needs to be spawned.
-    Process();
-    return true;
-}
-
-void SpawnManager::Process() {
+    //the entries spawn on their own once their timers go off.
     std::map<uint32, SpawnEntry *>::iterator cur, end;
     cur = m_spawns.begin();
     end = m_spawns.end();
     for(; cur != end; cur++) {
-        cur->second->Process(m_system, m_services);
+        cur->second->Start(m_system, m_services);
     }
+    return true;
 }
 
 
@@ -0,0 +1,89 @@
+/*
+    ------------------------------------------------------------------------------------
+    LICENSE:
+    ------------------------------------------------------------------------------------
+    This file is part of EVEmu: EVE Online Server Emulator
+    Copyright 2006 - 2011 The EVEmu Team
+    For the latest information visit http://evemu.org
+    ------------------------------------------------------------------------------------
+    This program is free software; you can redistribute it and/or modify it under
+    the terms of the GNU Lesser General Public License as published by the Free Software
+    Foundation; either version 2 of the License, or (at your option) any later
+    version.
+
+    This program is distributed in the hope that it will be useful, but WITHOUT
+    ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+    FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public License along with
+    this program; if not, write to the Free Software Foundation, Inc., 59 Temple
+    Place - Suite 330, Boston, MA 02111-1307, USA, or go to
+    http://www.gnu.org/copyleft/lesser.txt.
+    ------------------------------------------------------------------------------------
+    Author:     EVEmu Team
+*/
+
+
+#include "eve-server.h"
+
+#include "npc/SpawnTable.h"
+
+SpawnTable::SpawnTable()
+: mSpawnCount( 0 )
+{
+}
+
+SpawnTable::~SpawnTable()
+{
+    _Clear();
+}
+
+bool SpawnTable::Load()
+{
+    _Clear();
+
+    if( !mDB.LoadSpawnGroups( mGroups ) )
+        return false;
+
+    if( !mDB.LoadSpawnPoints( mGroups, mSpawns ) )
+        return false;
+
+    std::map< uint32, std::vector< SpawnPoint > >::const_iterator cur, end;
+    cur = mSpawns.begin();
+    end = mSpawns.end();
+    for(; cur != end; cur++ )
+        mSpawnCount += cur->second.size();
+
+    return true;
+}
+
+const SpawnGroup* SpawnTable::GetGroup( uint32 spawnGroupID ) const
+{
+    std::map< uint32, SpawnGroup* >::const_iterator res = mGroups.find( spawnGroupID );
+    if( mGroups.end() == res )
+        return NULL;
+
+    return res->second;
+}
+
+const std::vector< SpawnPoint >* SpawnTable::GetSpawns( uint32 solarSystemID ) const
+{
+    std::map< uint32, std::vector< SpawnPoint > >::const_iterator res = mSpawns.find( solarSystemID );
+    if( mSpawns.end() == res )
+        return NULL;
+
+    return &res->second;
+}
+
+void SpawnTable::_Clear()
+{
+    std::map< uint32, SpawnGroup* >::iterator cur, end;
+    cur = mGroups.begin();
+    end = mGroups.end();
+    for(; cur != end; cur++ )
+        delete cur->second;
+
+    mGroups.clear();
+    mSpawns.clear();
+    mSpawnCount = 0;
+}
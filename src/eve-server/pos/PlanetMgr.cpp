@@ -29,7 +29,9 @@
 
 #include "PyBoundObject.h"
 #include "PyServiceCD.h"
+#include "cache/ObjCacheService.h"
 #include "pos/PlanetMgr.h"
+#include "pos/PlanetSimulation.h"
 
 class PlanetMgrBound
 : public PyBoundObject
@@ -37,9 +39,10 @@ class PlanetMgrBound
 public:
     PyCallable_Make_Dispatcher(PlanetMgrBound)
 
-    PlanetMgrBound(PyServiceMgr *mgr)
+    PlanetMgrBound(PyServiceMgr *mgr, uint32 planetID)
     : PyBoundObject(mgr),
-      m_dispatch(new Dispatcher(this))
+      m_dispatch(new Dispatcher(this)),
+      m_planetID(planetID)
     {
         _SetCallDispatcher(m_dispatch);
 
@@ -59,6 +62,8 @@ public:
 
 protected:
     Dispatcher *const m_dispatch;
+
+    const uint32 m_planetID;
 };
 
 PyCallable_Make_InnerDispatcher(PlanetMgrService)
@@ -82,30 +87,36 @@ PyBoundObject *PlanetMgrService::_CreateBoundObject(Client *c, const PyRep *bind
         codelog(SERVICE__ERROR, "%s Service: invalid bind argument type %s", GetName(), bind_args->TypeString());
         return NULL;
     }
-    return new PlanetMgrBound(m_manager);
+    return new PlanetMgrBound(m_manager, bind_args->AsInt()->value());
 }
 
 PyResult PlanetMgrBound::Handle_GetPlanetInfo(PyCallArgs &call) {
-    sLog.Debug("Server", "Called GetPlanetInfo Stub.");
-
-    return NULL;
+    //the colony is advanced to now as it is observed
+    return sPlanetSimulation.GetPlanetInfo(m_planetID, call.client->GetCharacterID());
 }
 
 PyResult PlanetMgrBound::Handle_GetPlanetResourceInfo(PyCallArgs &call) {
-    sLog.Debug("Server", "Called GetPlanetResourceInfo Stub.");
+    //the heat maps never change, so the client may keep the result
+    ObjectCachedSessionMethodID method_id("planetMgr", "GetPlanetResourceInfo", m_planetID);
 
-    return NULL;
+    if(!m_manager->cache_service->IsCacheLoaded(method_id)) {
+        PyRep *res = sPlanetSimulation.GetPlanetResourceInfo(m_planetID);
+        if(res == NULL)
+            return NULL;
+
+        m_manager->cache_service->GiveCache(method_id, &res);
+    }
+
+    return(m_manager->cache_service->MakeObjectCachedMethodCallResult(method_id.objectID));
 }
 
 PyResult PlanetMgrService::Handle_GetPlanetsForChar(PyCallArgs &call) {
-    sLog.Debug("Server", "Called GetPlanetsForChar Stub.");
-
-    return NULL;
+    return sPlanetSimulation.GetPlanetsForChar(call.client->GetCharacterID());
 }
 
 PyResult PlanetMgrService::Handle_GetMyLaunchesDetails(PyCallArgs &call) {
 
-    sLog.Debug("Server", "Called GetMyLaunchesDetails Stub.");
+    _debug("Server", "Called GetMyLaunchesDetails Stub.");
 
     return NULL;
 }
@@ -0,0 +1,623 @@
+/*
+    ------------------------------------------------------------------------------------
+    LICENSE:
+    ------------------------------------------------------------------------------------
+    This file is part of EVEmu: EVE Online Server Emulator
+    Copyright 2006 - 2011 The EVEmu Team
+    For the latest information visit http://evemu.org
+    ------------------------------------------------------------------------------------
+    This program is free software; you can redistribute it and/or modify it under
+    the terms of the GNU Lesser General Public License as published by the Free Software
+    Foundation; either version 2 of the License, or (at your option) any later
+    version.
+
+    This program is distributed in the hope that it will be useful, but WITHOUT
+    ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+    FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public License along with
+    this program; if not, write to the Free Software Foundation, Inc., 59 Temple
+    Place - Suite 330, Boston, MA 02111-1307, USA, or go to
+    http://www.gnu.org/copyleft/lesser.txt.
+    ------------------------------------------------------------------------------------
+    Author:     EVEmu Team
+*/
+
+
+#include "eve-server.h"
+
+#include "pos/PlanetSimulation.h"
+
+/// Resolution of the heat maps, in cells of longitude and latitude.
+static const uint32 PLANET_HEATMAP_WIDTH = 32;
+static const uint32 PLANET_HEATMAP_HEIGHT = 16;
+/// Yield of an hour of an extractor at the full concentration.
+static const double PLANET_EXTRACTOR_OUTPUT = 1000.0;
+/// Fraction by which the yield of an extractor decays every cycle.
+static const double PLANET_EXTRACTOR_DECAY = 0.01;
+
+/**
+ * @brief The resources of the planet types.
+ */
+static const struct
+{
+    uint32 planetTypeID;
+    uint32 resources[ 5 ];
+} PLANET_RESOURCES[] =
+{
+    {   11, { 2268, 2305, 2288, 2287, 2073 } },    // Temperate
+    {   12, { 2268, 2272, 2073, 2310, 2286 } },    // Ice
+    {   13, { 2268, 2267, 2309, 2310, 2311 } },    // Gas
+    { 2014, { 2268, 2288, 2287, 2073, 2286 } },    // Oceanic
+    { 2015, { 2267, 2307, 2272, 2306, 2308 } },    // Lava
+    { 2016, { 2268, 2267, 2288, 2073, 2270 } },    // Barren
+    { 2017, { 2268, 2267, 2309, 2310, 2308 } },    // Storm
+    { 2063, { 2267, 2272, 2270, 2306, 2308 } }     // Plasma
+};
+
+/**
+ * @return Next number (0 - 1) of a xorshift sequence; unlike MakeRandomFloat(), the same for the same seed on every start.
+ */
+static double HeatMapRandom( uint32& state )
+{
+    state ^= state << 13;
+    state ^= state >> 17;
+    state ^= state << 5;
+
+    return state / 4294967296.0;
+}
+
+PlanetSimulation::PlanetSimulation()
+{
+}
+
+PlanetSimulation::~PlanetSimulation()
+{
+    std::map< uint64, Colony* >::iterator cur, end;
+    cur = mColonies.begin();
+    end = mColonies.end();
+    for(; cur != end; cur++ )
+        delete cur->second;
+}
+
+bool PlanetSimulation::Load()
+{
+    DBQueryResult res;
+    if( !sDatabase.RunQuery( res,
+        "SELECT schematicID, cycleTime"
+        " FROM schematics" ) )
+    {
+        codelog( SERVICE__ERROR, "Error in query: %s", res.error.c_str() );
+        return false;
+    }
+
+    mSchematics.clear();
+
+    DBResultRow row;
+    while( res.GetRow( row ) )
+    {
+        Schematic& schematic = mSchematics[ row.GetUInt( 0 ) ];
+        schematic.cycleTime = row.GetUInt( 1 );
+        schematic.pinTypeID = 0;
+    }
+
+    if( !sDatabase.RunQuery( res,
+        "SELECT schematicID, typeID, quantity, isInput"
+        " FROM schematicsTypeMap" ) )
+    {
+        codelog( SERVICE__ERROR, "Error in query: %s", res.error.c_str() );
+        return false;
+    }
+
+    while( res.GetRow( row ) )
+    {
+        std::map< uint32, Schematic >::iterator schematic = mSchematics.find( row.GetUInt( 0 ) );
+        if( mSchematics.end() == schematic )
+            continue;
+
+        if( 0 != row.GetUInt( 3 ) )
+            schematic->second.inputs[ row.GetUInt( 1 ) ] = row.GetUInt( 2 );
+        else
+            schematic->second.outputs[ row.GetUInt( 1 ) ] = row.GetUInt( 2 );
+    }
+
+    if( !sDatabase.RunQuery( res,
+        "SELECT schematicID, MIN( pinTypeID )"
+        " FROM schematicsPinMap"
+        " GROUP BY schematicID" ) )
+    {
+        codelog( SERVICE__ERROR, "Error in query: %s", res.error.c_str() );
+        return false;
+    }
+
+    while( res.GetRow( row ) )
+    {
+        std::map< uint32, Schematic >::iterator schematic = mSchematics.find( row.GetUInt( 0 ) );
+        if( mSchematics.end() != schematic )
+            schematic->second.pinTypeID = row.GetUInt( 1 );
+    }
+
+    return true;
+}
+
+const PlanetSimulation::Colony* PlanetSimulation::GetColony( uint32 planetID, uint32 ownerID )
+{
+    Colony* colony = _GetColony( planetID, ownerID );
+    if( NULL == colony )
+        return NULL;
+
+    ++mStats.observations;
+    _Advance( *colony, Win32TimeNow() );
+
+    return colony;
+}
+
+PlanetSimulation::Colony* PlanetSimulation::_GetColony( uint32 planetID, uint32 ownerID )
+{
+    std::map< uint64, Colony* >::iterator res = mColonies.find( _ColonyKey( planetID, ownerID ) );
+    if( mColonies.end() != res )
+        return res->second;
+
+    DBQueryResult pins;
+    if( !sDatabase.RunQuery( pins,
+        "SELECT pinID, typeID, kind, latitude, longitude, schematicID, resourceTypeID,"
+        " cycleTime, qtyPerCycle, installTime, expiryTime, lastRunTime"
+        " FROM planetPins"
+        " WHERE planetID = %u AND ownerID = %u",
+        planetID, ownerID ) )
+    {
+        codelog( SERVICE__ERROR, "Error in query: %s", pins.error.c_str() );
+        return NULL;
+    }
+
+    DBQueryResult contents;
+    if( !sDatabase.RunQuery( contents,
+        "SELECT typeID, quantity"
+        " FROM planetColonyContents"
+        " WHERE planetID = %u AND ownerID = %u AND quantity > 0",
+        planetID, ownerID ) )
+    {
+        codelog( SERVICE__ERROR, "Error in query: %s", contents.error.c_str() );
+        return NULL;
+    }
+
+    Colony* colony = new Colony;
+    colony->planetID = planetID;
+    colony->ownerID = ownerID;
+
+    DBResultRow row;
+    while( pins.GetRow( row ) )
+    {
+        Pin pin;
+        pin.pinID = row.GetUInt( 0 );
+        pin.typeID = row.GetUInt( 1 );
+        pin.kind = row.GetUInt( 2 );
+        pin.latitude = row.GetDouble( 3 );
+        pin.longitude = row.GetDouble( 4 );
+        pin.schematicID = row.GetUInt( 5 );
+        pin.resourceTypeID = row.GetUInt( 6 );
+        pin.cycleTime = row.GetUInt( 7 );
+        pin.qtyPerCycle = row.GetUInt( 8 );
+        pin.installTime = row.GetUInt64( 9 );
+        pin.expiryTime = row.GetUInt64( 10 );
+        pin.lastRunTime = row.GetUInt64( 11 );
+
+        colony->pins.push_back( pin );
+    }
+
+    while( contents.GetRow( row ) )
+        colony->contents[ row.GetUInt( 0 ) ] = row.GetUInt( 1 );
+
+    mColonies.insert( std::make_pair( _ColonyKey( planetID, ownerID ), colony ) );
+    ++mStats.loads;
+
+    return colony;
+}
+
+uint64 PlanetSimulation::_Extracted( uint32 qtyPerCycle, uint64 cycles )
+{
+    // the sum of the geometric series of the decaying yields
+    const double ratio = 1.0 - PLANET_EXTRACTOR_DECAY;
+    return static_cast< uint64 >( qtyPerCycle * ( 1.0 - pow( ratio, (double)cycles ) ) / PLANET_EXTRACTOR_DECAY );
+}
+
+void PlanetSimulation::_Advance( Colony& colony, uint64 now )
+{
+    std::vector< uint32 > changed;
+
+    // the extractors first, their output feeds the factories
+    std::vector< Pin >::iterator cur, end;
+    cur = colony.pins.begin();
+    end = colony.pins.end();
+    for(; cur != end; cur++ )
+    {
+        Pin& pin = *cur;
+        if( PIN_EXTRACTOR != pin.kind || 0 == pin.cycleTime )
+            continue;
+
+        const uint64 cycleTime = pin.cycleTime * Win32Time_Second;
+        const uint64 until = std::min( now, pin.expiryTime );
+        if( until < pin.lastRunTime + cycleTime )
+            continue;
+
+        // the cycles since the install, rounded the same way every time so nothing is lost
+        const uint64 done = ( pin.lastRunTime - pin.installTime ) / cycleTime;
+        const uint64 total = ( until - pin.installTime ) / cycleTime;
+
+        colony.contents[ pin.resourceTypeID ] += static_cast< uint32 >( _Extracted( pin.qtyPerCycle, total ) - _Extracted( pin.qtyPerCycle, done ) );
+        pin.lastRunTime = pin.installTime + total * cycleTime;
+
+        mStats.extractorCycles += static_cast< uint32 >( total - done );
+        changed.push_back( pin.pinID );
+    }
+
+    for( cur = colony.pins.begin(); cur != end; cur++ )
+    {
+        Pin& pin = *cur;
+        if( PIN_FACTORY != pin.kind || 0 == pin.cycleTime )
+            continue;
+
+        const uint64 cycleTime = pin.cycleTime * Win32Time_Second;
+        if( now < pin.lastRunTime + cycleTime )
+            continue;
+
+        std::map< uint32, Schematic >::const_iterator schematic = mSchematics.find( pin.schematicID );
+        if( mSchematics.end() == schematic )
+            continue;
+
+        const uint64 cycles = ( now - pin.lastRunTime ) / cycleTime;
+
+        // as many of them as there are inputs for; the rest it idled
+        uint64 runs = cycles;
+
+        std::map< uint32, uint32 >::const_iterator curi, endi;
+        curi = schematic->second.inputs.begin();
+        endi = schematic->second.inputs.end();
+        for(; curi != endi; curi++ )
+            runs = std::min< uint64 >( runs, colony.contents[ curi->first ] / curi->second );
+
+        for( curi = schematic->second.inputs.begin(); curi != endi; curi++ )
+            colony.contents[ curi->first ] -= static_cast< uint32 >( runs * curi->second );
+
+        std::map< uint32, uint32 >::const_iterator curo, endo;
+        curo = schematic->second.outputs.begin();
+        endo = schematic->second.outputs.end();
+        for(; curo != endo; curo++ )
+            colony.contents[ curo->first ] += static_cast< uint32 >( runs * curo->second );
+
+        pin.lastRunTime += cycles * cycleTime;
+
+        mStats.factoryCycles += static_cast< uint32 >( runs );
+        changed.push_back( pin.pinID );
+    }
+
+    if( !changed.empty() )
+        _Save( colony, changed );
+}
+
+bool PlanetSimulation::_Save( const Colony& colony, const std::vector< uint32 >& pinIDs )
+{
+    std::string times, ids;
+    char buf[ 64 ];
+
+    std::vector< Pin >::const_iterator cur, end;
+    cur = colony.pins.begin();
+    end = colony.pins.end();
+    for(; cur != end; cur++ )
+    {
+        if( pinIDs.end() == std::find( pinIDs.begin(), pinIDs.end(), cur->pinID ) )
+            continue;
+
+        snprintf( buf, sizeof( buf ), " WHEN %u THEN %" PRIu64, cur->pinID, cur->lastRunTime );
+        times += buf;
+
+        snprintf( buf, sizeof( buf ), "%s%u", ( ids.empty() ? "" : ", " ), cur->pinID );
+        ids += buf;
+    }
+
+    std::string contents;
+
+    std::map< uint32, uint32 >::const_iterator curc, endc;
+    curc = colony.contents.begin();
+    endc = colony.contents.end();
+    for(; curc != endc; curc++ )
+    {
+        snprintf( buf, sizeof( buf ), "%s(%u, %u, %u, %u)",
+                  ( contents.empty() ? "" : ", " ), colony.planetID, colony.ownerID, curc->first, curc->second );
+        contents += buf;
+    }
+
+    DBerror err;
+    if( !sDatabase.RunQuery( err,
+        "UPDATE planetPins"
+        " SET lastRunTime = CASE pinID%s END"
+        " WHERE pinID IN (%s)",
+        times.c_str(), ids.c_str() ) )
+    {
+        _log( DATABASE__ERROR, "Failed to save the pins of colony %u of %u: %s.", colony.planetID, colony.ownerID, err.c_str() );
+        return false;
+    }
+
+    if( !contents.empty()
+        && !sDatabase.RunQuery( err,
+        "INSERT INTO planetColonyContents ( planetID, ownerID, typeID, quantity )"
+        " VALUES %s"
+        " ON DUPLICATE KEY UPDATE quantity = VALUES( quantity )",
+        contents.c_str() ) )
+    {
+        _log( DATABASE__ERROR, "Failed to save the contents of colony %u of %u: %s.", colony.planetID, colony.ownerID, err.c_str() );
+        return false;
+    }
+
+    return true;
+}
+
+uint32 PlanetSimulation::InstallExtractor( uint32 planetID, uint32 ownerID, uint32 resourceTypeID, double latitude, double longitude, uint32 cycleTime, uint32 programTime )
+{
+    const HeatMap* map = _GetHeatMap( planetID );
+    if( NULL == map || map->cells.end() == map->cells.find( resourceTypeID ) || 0 == cycleTime || programTime < cycleTime )
+        return 0;
+
+    Colony* colony = _GetColony( planetID, ownerID );
+    if( NULL == colony )
+        return 0;
+
+    // everything so far happened without it
+    const uint64 now = Win32TimeNow();
+    _Advance( *colony, now );
+
+    Pin pin;
+    pin.typeID = 0;
+    pin.kind = PIN_EXTRACTOR;
+    pin.latitude = latitude;
+    pin.longitude = longitude;
+    pin.schematicID = 0;
+    pin.resourceTypeID = resourceTypeID;
+    pin.cycleTime = cycleTime;
+    pin.qtyPerCycle = static_cast< uint32 >( PLANET_EXTRACTOR_OUTPUT * _Concentration( *map, resourceTypeID, latitude, longitude ) * cycleTime / 3600.0 );
+    pin.installTime = now;
+    pin.expiryTime = now + programTime * Win32Time_Second;
+    pin.lastRunTime = now;
+
+    DBerror err;
+    if( !sDatabase.RunQueryLID( err, pin.pinID,
+        "INSERT INTO planetPins ( planetID, ownerID, typeID, kind, latitude, longitude, schematicID, resourceTypeID,"
+        " cycleTime, qtyPerCycle, installTime, expiryTime, lastRunTime )"
+        " VALUES ( %u, %u, %u, %u, %f, %f, %u, %u, %u, %u, %" PRIu64 ", %" PRIu64 ", %" PRIu64 " )",
+        planetID, ownerID, pin.typeID, (uint32)pin.kind, pin.latitude, pin.longitude, pin.schematicID, pin.resourceTypeID,
+        pin.cycleTime, pin.qtyPerCycle, pin.installTime, pin.expiryTime, pin.lastRunTime ) )
+    {
+        _log( DATABASE__ERROR, "Failed to install extractor on planet %u for %u: %s.", planetID, ownerID, err.c_str() );
+        return 0;
+    }
+
+    colony->pins.push_back( pin );
+    return pin.pinID;
+}
+
+uint32 PlanetSimulation::InstallFactory( uint32 planetID, uint32 ownerID, uint32 schematicID )
+{
+    std::map< uint32, Schematic >::const_iterator schematic = mSchematics.find( schematicID );
+    if( mSchematics.end() == schematic || 0 == schematic->second.cycleTime )
+        return 0;
+
+    Colony* colony = _GetColony( planetID, ownerID );
+    if( NULL == colony )
+        return 0;
+
+    const uint64 now = Win32TimeNow();
+    _Advance( *colony, now );
+
+    Pin pin;
+    pin.typeID = schematic->second.pinTypeID;
+    pin.kind = PIN_FACTORY;
+    pin.latitude = 0.0;
+    pin.longitude = 0.0;
+    pin.schematicID = schematicID;
+    pin.resourceTypeID = 0;
+    pin.cycleTime = schematic->second.cycleTime;
+    pin.qtyPerCycle = 0;
+    pin.installTime = now;
+    pin.expiryTime = 0;
+    pin.lastRunTime = now;
+
+    DBerror err;
+    if( !sDatabase.RunQueryLID( err, pin.pinID,
+        "INSERT INTO planetPins ( planetID, ownerID, typeID, kind, latitude, longitude, schematicID, resourceTypeID,"
+        " cycleTime, qtyPerCycle, installTime, expiryTime, lastRunTime )"
+        " VALUES ( %u, %u, %u, %u, %f, %f, %u, %u, %u, %u, %" PRIu64 ", %" PRIu64 ", %" PRIu64 " )",
+        planetID, ownerID, pin.typeID, (uint32)pin.kind, pin.latitude, pin.longitude, pin.schematicID, pin.resourceTypeID,
+        pin.cycleTime, pin.qtyPerCycle, pin.installTime, pin.expiryTime, pin.lastRunTime ) )
+    {
+        _log( DATABASE__ERROR, "Failed to install factory on planet %u for %u: %s.", planetID, ownerID, err.c_str() );
+        return 0;
+    }
+
+    colony->pins.push_back( pin );
+    return pin.pinID;
+}
+
+PyRep* PlanetSimulation::GetPlanetsForChar( uint32 ownerID )
+{
+    DBQueryResult res;
+    if( !sDatabase.RunQuery( res,
+        "SELECT d.solarSystemID, p.planetID, d.typeID, COUNT( p.pinID ) AS numberOfPins"
+        " FROM planetPins p"
+        " JOIN mapDenormalize d ON d.itemID = p.planetID"
+        " WHERE p.ownerID = %u"
+        " GROUP BY p.planetID",
+        ownerID ) )
+    {
+        codelog( SERVICE__ERROR, "Error in query: %s", res.error.c_str() );
+        return NULL;
+    }
+
+    return DBResultToRowset( res );
+}
+
+PyRep* PlanetSimulation::GetPlanetInfo( uint32 planetID, uint32 ownerID )
+{
+    const Colony* colony = GetColony( planetID, ownerID );
+    if( NULL == colony )
+        return NULL;
+
+    PyList* pins = new PyList;
+
+    std::vector< Pin >::const_iterator cur, end;
+    cur = colony->pins.begin();
+    end = colony->pins.end();
+    for(; cur != end; cur++ )
+    {
+        PyDict* pin = new PyDict;
+        pin->SetItemString( "id", new PyInt( cur->pinID ) );
+        pin->SetItemString( "typeID", new PyInt( cur->typeID ) );
+        pin->SetItemString( "latitude", new PyFloat( cur->latitude ) );
+        pin->SetItemString( "longitude", new PyFloat( cur->longitude ) );
+        pin->SetItemString( "cycleTime", new PyInt( cur->cycleTime ) );
+        pin->SetItemString( "lastRunTime", new PyLong( cur->lastRunTime ) );
+        if( PIN_EXTRACTOR == cur->kind )
+        {
+            pin->SetItemString( "resourceTypeID", new PyInt( cur->resourceTypeID ) );
+            pin->SetItemString( "qtyPerCycle", new PyInt( cur->qtyPerCycle ) );
+            pin->SetItemString( "installTime", new PyLong( cur->installTime ) );
+            pin->SetItemString( "expiryTime", new PyLong( cur->expiryTime ) );
+        }
+        else
+            pin->SetItemString( "schematicID", new PyInt( cur->schematicID ) );
+
+        pins->AddItem( new PyObject( "util.KeyVal", pin ) );
+    }
+
+    PyDict* contents = new PyDict;
+
+    std::map< uint32, uint32 >::const_iterator curc, endc;
+    curc = colony->contents.begin();
+    endc = colony->contents.end();
+    for(; curc != endc; curc++ )
+    {
+        if( 0 < curc->second )
+            contents->SetItem( new PyInt( curc->first ), new PyInt( curc->second ) );
+    }
+
+    PyDict* dict = new PyDict;
+    dict->SetItemString( "planetID", new PyInt( planetID ) );
+    dict->SetItemString( "ownerID", new PyInt( ownerID ) );
+    dict->SetItemString( "pins", pins );
+    dict->SetItemString( "contents", contents );
+    return new PyObject( "util.KeyVal", dict );
+}
+
+PyRep* PlanetSimulation::GetPlanetResourceInfo( uint32 planetID )
+{
+    const HeatMap* map = _GetHeatMap( planetID );
+    if( NULL == map )
+        return NULL;
+
+    PyDict* dict = new PyDict;
+
+    std::map< uint32, std::vector< float > >::const_iterator cur, end;
+    cur = map->cells.begin();
+    end = map->cells.end();
+    for(; cur != end; cur++ )
+    {
+        // the best spot is what the scan shows
+        const float peak = *std::max_element( cur->second.begin(), cur->second.end() );
+        dict->SetItem( new PyInt( cur->first ), new PyInt( static_cast< int32 >( peak * 100.0f ) ) );
+    }
+
+    return dict;
+}
+
+const PlanetSimulation::HeatMap* PlanetSimulation::_GetHeatMap( uint32 planetID )
+{
+    std::map< uint32, HeatMap >::const_iterator res = mHeatMaps.find( planetID );
+    if( mHeatMaps.end() != res )
+        return &res->second;
+
+    DBQueryResult result;
+    if( !sDatabase.RunQuery( result,
+        "SELECT typeID"
+        " FROM mapDenormalize"
+        " WHERE itemID = %u",
+        planetID ) )
+    {
+        codelog( SERVICE__ERROR, "Error in query: %s", result.error.c_str() );
+        return NULL;
+    }
+
+    DBResultRow row;
+    if( !result.GetRow( row ) )
+        return NULL;
+
+    const uint32 planetTypeID = row.GetUInt( 0 );
+
+    size_t kind = 0;
+    const size_t kinds = sizeof( PLANET_RESOURCES ) / sizeof( PLANET_RESOURCES[0] );
+    while( kind < kinds && PLANET_RESOURCES[ kind ].planetTypeID != planetTypeID )
+        ++kind;
+    if( kind == kinds )
+        return NULL;
+
+    HeatMap& map = mHeatMaps[ planetID ];
+    map.planetTypeID = planetTypeID;
+
+    for( size_t i = 0; i < sizeof( PLANET_RESOURCES[0].resources ) / sizeof( uint32 ); ++i )
+    {
+        const uint32 resourceTypeID = PLANET_RESOURCES[ kind ].resources[ i ];
+        std::vector< float >& cells = map.cells[ resourceTypeID ];
+
+        // a thin background with a few hot spots of random size and strength
+        uint32 seed = ( planetID * 2654435761u ) ^ ( resourceTypeID * 40503u ) ^ 0x9E3779B9u;
+        if( 0 == seed )
+            seed = 1;
+
+        const double background = 0.05 + 0.15 * HeatMapRandom( seed );
+        cells.assign( PLANET_HEATMAP_WIDTH * PLANET_HEATMAP_HEIGHT, static_cast< float >( background ) );
+
+        const uint32 spots = 3 + static_cast< uint32 >( 4 * HeatMapRandom( seed ) );
+        for( uint32 s = 0; s < spots; ++s )
+        {
+            // uniformly over the sphere
+            const double spotLatitude = acos( 1.0 - 2.0 * HeatMapRandom( seed ) );
+            const double spotLongitude = 2.0 * M_PI * HeatMapRandom( seed );
+            const double radius = 0.2 + 0.5 * HeatMapRandom( seed );
+            const double strength = 0.3 + 0.7 * HeatMapRandom( seed );
+
+            for( uint32 y = 0; y < PLANET_HEATMAP_HEIGHT; ++y )
+            {
+                const double latitude = ( y + 0.5 ) * M_PI / PLANET_HEATMAP_HEIGHT;
+                for( uint32 x = 0; x < PLANET_HEATMAP_WIDTH; ++x )
+                {
+                    const double longitude = ( x + 0.5 ) * 2.0 * M_PI / PLANET_HEATMAP_WIDTH;
+
+                    // the angle between the cell and the spot
+                    const double cosAngle = cos( latitude ) * cos( spotLatitude )
+                                          + sin( latitude ) * sin( spotLatitude ) * cos( longitude - spotLongitude );
+                    const double angle = acos( std::max( -1.0, std::min( 1.0, cosAngle ) ) ) / radius;
+
+                    float& cell = cells[ y * PLANET_HEATMAP_WIDTH + x ];
+                    cell = static_cast< float >( std::min( 1.0, cell + strength * exp( -angle * angle ) ) );
+                }
+            }
+        }
+    }
+
+    ++mStats.heatMaps;
+    return &map;
+}
+
+float PlanetSimulation::_Concentration( const HeatMap& map, uint32 resourceTypeID, double latitude, double longitude )
+{
+    std::map< uint32, std::vector< float > >::const_iterator res = map.cells.find( resourceTypeID );
+    if( map.cells.end() == res )
+        return 0.0f;
+
+    const uint32 y = std::min( PLANET_HEATMAP_HEIGHT - 1, static_cast< uint32 >( std::max( 0.0, latitude ) / M_PI * PLANET_HEATMAP_HEIGHT ) );
+
+    double turns = fmod( longitude / ( 2.0 * M_PI ), 1.0 );
+    if( turns < 0.0 )
+        turns += 1.0;
+    const uint32 x = std::min( PLANET_HEATMAP_WIDTH - 1, static_cast< uint32 >( turns * PLANET_HEATMAP_WIDTH ) );
+
+    return res->second[ y * PLANET_HEATMAP_WIDTH + x ];
+}
@@ -0,0 +1,471 @@
+/*
+    ------------------------------------------------------------------------------------
+    LICENSE:
+    ------------------------------------------------------------------------------------
+    This file is part of EVEmu: EVE Online Server Emulator
+    Copyright 2006 - 2011 The EVEmu Team
+    For the latest information visit http://evemu.org
+    ------------------------------------------------------------------------------------
+    This program is free software; you can redistribute it and/or modify it under
+    the terms of the GNU Lesser General Public License as published by the Free Software
+    Foundation; either version 2 of the License, or (at your option) any later
+    version.
+
+    This program is distributed in the hope that it will be useful, but WITHOUT
+    ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+    FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public License along with
+    this program; if not, write to the Free Software Foundation, Inc., 59 Temple
+    Place - Suite 330, Boston, MA 02111-1307, USA, or go to
+    http://www.gnu.org/copyleft/lesser.txt.
+    ------------------------------------------------------------------------------------
+    Author:     EVEmu Team
+*/
+
+
+#include "eve-server.h"
+
+#include "inventory/Inventory.h"
+#include "inventory/InventoryWriteBehind.h"
+#include "inventory/ItemFactory.h"
+#include "pos/StarbaseSimulator.h"
+
+/// The flag of the fuel in the bay of a tower.
+static const EVEItemFlags STARBASE_FUEL_FLAG = flagCargoHold;
+/// The purpose of the resources a tower burns to stay online.
+static const uint32 STARBASE_ONLINE_PURPOSE = 1;
+/// Delay (in milliseconds) of a pass past the end of the earliest cycle, so the towers cycling close to each other share it.
+static const uint32 STARBASE_PASS_DELAY = 10 * 60 * 1000;
+
+/** @return Histogram of the durations of the passes. */
+static MetricHistogram& StarbasePassMetric()
+{
+    static MetricHistogram& metric = sMetrics.LatencyHistogram( "evemu_starbase_pass_seconds", "Time a pass of the starbase simulation took." );
+    return metric;
+}
+
+StarbaseSimulator::StarbaseSimulator()
+: mFactory( NULL ),
+  mPassTimer( *this )
+{
+}
+
+bool StarbaseSimulator::Load( ItemFactory& factory )
+{
+    mFactory = &factory;
+
+    DBQueryResult res;
+    if( !sDatabase.RunQuery( res,
+        "SELECT controlTowerTypeID, resourceTypeID, quantity,"
+        " IFNULL( minSecurityLevel, -1 ), IFNULL( factionID, 0 )"
+        " FROM invControlTowerResources"
+        " WHERE purpose = %u",
+        STARBASE_ONLINE_PURPOSE ) )
+    {
+        codelog( SERVICE__ERROR, "Error in query: %s", res.error.c_str() );
+        return false;
+    }
+
+    mFuel.clear();
+
+    DBResultRow row;
+    while( res.GetRow( row ) )
+    {
+        Fuel fuel;
+        fuel.typeID = row.GetUInt( 1 );
+        fuel.quantity = row.GetUInt( 2 );
+        fuel.minSecurityLevel = row.GetDouble( 3 );
+        fuel.factionID = row.GetUInt( 4 );
+
+        mFuel[ row.GetUInt( 0 ) ].push_back( fuel );
+    }
+
+    mTowers.clear();
+    if( !_LoadTowers( 0 ) )
+        return false;
+
+    _SchedulePass();
+    return true;
+}
+
+bool StarbaseSimulator::_LoadTowers( uint32 towerID )
+{
+    char filter[ 32 ] = "";
+    if( 0 != towerID )
+        snprintf( filter, sizeof( filter ), " AND e.itemID = %u", towerID );
+
+    DBQueryResult res;
+    if( !sDatabase.RunQuery( res,
+        "SELECT e.itemID, e.typeID,"
+        " IFNULL( st.state, %u ), IFNULL( st.cycleStart, 0 ), IFNULL( st.reinforcedUntil, 0 ),"
+        " s.security, IFNULL( s.factionID, 0 )"
+        " FROM entity e"
+        " JOIN invTypes t ON t.typeID = e.typeID"
+        " JOIN mapSolarSystems s ON s.solarSystemID = e.locationID"
+        " LEFT JOIN posTowerState st ON st.towerID = e.itemID"
+        " WHERE t.groupID = %u%s",
+        (uint32)starbaseStateAnchored, (uint32)EVEDB::invGroups::Control_Tower, filter ) )
+    {
+        codelog( SERVICE__ERROR, "Error in query: %s", res.error.c_str() );
+        return false;
+    }
+
+    DBResultRow row;
+    while( res.GetRow( row ) )
+    {
+        Tower& tower = mTowers[ row.GetUInt( 0 ) ];
+        tower.towerID = row.GetUInt( 0 );
+        tower.typeID = row.GetUInt( 1 );
+        tower.state = row.GetUInt( 2 );
+        tower.cycleStart = row.GetUInt64( 3 );
+        tower.reinforcedUntil = row.GetUInt64( 4 );
+        tower.security = row.GetDouble( 5 );
+        tower.factionID = row.GetUInt( 6 );
+    }
+
+    return true;
+}
+
+bool StarbaseSimulator::SetState( uint32 towerID, StarbaseState state )
+{
+    if( starbaseStateReinforced == state )
+        return false;
+
+    std::map< uint32, Tower >::iterator res = mTowers.find( towerID );
+    if( mTowers.end() == res )
+    {
+        if( !_LoadTowers( towerID ) )
+            return false;
+
+        res = mTowers.find( towerID );
+        if( mTowers.end() == res )
+            return false;
+    }
+
+    Tower& tower = res->second;
+    if( starbaseStateOnline == state && starbaseStateOnline == tower.state )
+        return true;
+
+    tower.state = state;
+    tower.reinforcedUntil = 0;
+    // only the online towers burn fuel; the first cycle starts now
+    tower.cycleStart = ( starbaseStateOnline == state ? Win32TimeNow() : 0 );
+
+    if( !_SaveStates( std::vector< uint32 >( 1, towerID ) ) )
+        return false;
+
+    _SchedulePass();
+    return true;
+}
+
+bool StarbaseSimulator::Reinforce( uint32 towerID, uint64 until )
+{
+    std::map< uint32, Tower >::iterator res = mTowers.find( towerID );
+    if( mTowers.end() == res || starbaseStateOnline != res->second.state )
+        return false;
+
+    res->second.state = starbaseStateReinforced;
+    res->second.reinforcedUntil = until;
+
+    if( !_SaveStates( std::vector< uint32 >( 1, towerID ) ) )
+        return false;
+
+    _SchedulePass();
+    return true;
+}
+
+void StarbaseSimulator::RunPass()
+{
+    sTimerWheel.Cancel( &mPassTimer );
+    _Pass();
+}
+
+void StarbaseSimulator::_Pass()
+{
+    const uint64 start = GetTimeUSeconds();
+    const uint64 now = Win32TimeNow();
+
+    std::vector< uint32 > due;
+
+    std::map< uint32, Tower >::const_iterator cur, end;
+    cur = mTowers.begin();
+    end = mTowers.end();
+    for(; cur != end; cur++ )
+    {
+        const Tower& tower = cur->second;
+
+        const uint64 cycleEnd = _CycleEnd( tower );
+        if( ( 0 != cycleEnd && cycleEnd <= now )
+            || ( starbaseStateReinforced == tower.state && tower.reinforcedUntil <= now ) )
+            due.push_back( tower.towerID );
+    }
+
+    if( !due.empty() )
+    {
+        // the bays of all the due towers at once
+        std::map< uint32, ItemData > preloaded;
+        if( !mFactory->PreloadItems( due, preloaded ) )
+        {
+            _log( SERVICE__ERROR, "Failed to load the fuel of %u control towers.", (uint32)due.size() );
+
+            sTimerWheel.Schedule( &mPassTimer, STARBASE_PASS_DELAY );
+            return;
+        }
+
+        std::map< uint32, std::vector< uint32 > > bays;
+
+        std::map< uint32, ItemData >::const_iterator curp, endp;
+        curp = preloaded.begin();
+        endp = preloaded.end();
+        for(; curp != endp; curp++ )
+        {
+            if( STARBASE_FUEL_FLAG == curp->second.flag )
+                bays[ curp->second.locationID ].push_back( curp->first );
+            else
+                mFactory->DiscardPreloaded( curp->first );
+        }
+
+        std::vector< uint32 > changed;
+
+        // the fuel is written by the queue in bulk
+        sInventoryWriteBehind.BeginBatch();
+
+        std::vector< uint32 >::const_iterator curd, endd;
+        curd = due.begin();
+        endd = due.end();
+        for(; curd != endd; curd++ )
+        {
+            Tower& tower = mTowers[ *curd ];
+
+            std::vector< InventoryItemRef > bay;
+            _GetBay( tower, bays[ tower.towerID ], bay );
+
+            if( _Cycle( tower, now, bay ) )
+                changed.push_back( tower.towerID );
+        }
+
+        sInventoryWriteBehind.EndBatch();
+
+        _SaveStates( changed );
+
+        mStats.towers += due.size();
+    }
+
+    const uint32 elapsed = static_cast< uint32 >( GetTimeUSeconds() - start );
+    StarbasePassMetric().Observe( elapsed );
+    ++mStats.passes;
+    mStats.passTime += elapsed;
+    if( mStats.maxPassTime < elapsed )
+        mStats.maxPassTime = elapsed;
+
+    _log( SERVICE__MESSAGE, "Starbase pass cycled %u control towers in %u us.", (uint32)due.size(), elapsed );
+
+    _SchedulePass();
+}
+
+void StarbaseSimulator::_GetBay( const Tower& tower, const std::vector< uint32 >& preloaded, std::vector< InventoryItemRef >& into )
+{
+    // the loaded bay is the one to take from
+    Inventory* inventory = mFactory->GetInventory( tower.towerID, false );
+    const bool loaded = ( NULL != inventory && inventory->ContentsLoaded() );
+    if( loaded )
+        inventory->FindByFlag( STARBASE_FUEL_FLAG, into );
+
+    std::vector< uint32 >::const_iterator cur, end;
+    cur = preloaded.begin();
+    end = preloaded.end();
+    for(; cur != end; cur++ )
+    {
+        if( !loaded )
+        {
+            InventoryItemRef item = mFactory->GetItem( *cur );
+            if( item )
+                into.push_back( item );
+        }
+
+        // drop whatever the load did not use
+        mFactory->DiscardPreloaded( *cur );
+    }
+}
+
+bool StarbaseSimulator::_Cycle( Tower& tower, uint64 now, std::vector< InventoryItemRef >& bay )
+{
+    bool changed = false;
+
+    if( starbaseStateReinforced == tower.state && tower.reinforcedUntil <= now )
+    {
+        tower.state = starbaseStateOnline;
+        tower.reinforcedUntil = 0;
+        changed = true;
+    }
+
+    const uint64 cycleEnd = _CycleEnd( tower );
+    if( 0 == cycleEnd || cycleEnd > now )
+        return changed;
+
+    // every cycle which ended since, however long the server was down
+    const uint32 cycles = static_cast< uint32 >( ( now - tower.cycleStart ) / Win32Time_Hour );
+
+    // the fuel the tower needs per cycle where it is
+    std::map< uint32, uint32 > needed;
+
+    std::map< uint32, std::vector< Fuel > >::const_iterator fuel = mFuel.find( tower.typeID );
+    if( mFuel.end() != fuel )
+    {
+        std::vector< Fuel >::const_iterator cur, end;
+        cur = fuel->second.begin();
+        end = fuel->second.end();
+        for(; cur != end; cur++ )
+        {
+            if( tower.security < cur->minSecurityLevel )
+                continue;
+            if( 0 != cur->factionID && cur->factionID != tower.factionID )
+                continue;
+
+            needed[ cur->typeID ] += cur->quantity;
+        }
+    }
+
+    // the cycles the fuel in the bay lasts
+    uint32 burnt = cycles;
+
+    std::map< uint32, uint32 >::const_iterator cur, end;
+    cur = needed.begin();
+    end = needed.end();
+    for(; cur != end; cur++ )
+    {
+        uint64 available = 0;
+
+        std::vector< InventoryItemRef >::const_iterator curb, endb;
+        curb = bay.begin();
+        endb = bay.end();
+        for(; curb != endb; curb++ )
+        {
+            if( (*curb)->typeID() == cur->first )
+                available += (*curb)->quantity();
+        }
+
+        burnt = static_cast< uint32 >( std::min< uint64 >( burnt, available / cur->second ) );
+    }
+
+    // take the fuel off the stacks
+    for( cur = needed.begin(); cur != end; cur++ )
+    {
+        uint64 take = (uint64)cur->second * burnt;
+
+        std::vector< InventoryItemRef >::iterator curb, endb;
+        curb = bay.begin();
+        endb = bay.end();
+        for(; curb != endb && 0 < take; curb++ )
+        {
+            InventoryItemRef item = *curb;
+            if( item->typeID() != cur->first || 0 >= item->quantity() )
+                continue;
+
+            const uint32 quantity = item->quantity();
+            if( take >= quantity )
+            {
+                take -= quantity;
+                item->Delete();
+            }
+            else
+            {
+                item->SetQuantity( quantity - static_cast< uint32 >( take ) );
+                take = 0;
+            }
+        }
+    }
+
+    mStats.cycles += burnt;
+
+    if( burnt < cycles )
+    {
+        // out of fuel
+        _log( SERVICE__MESSAGE, "Control tower %u ran out of fuel after %u of %u cycles.", tower.towerID, burnt, cycles );
+
+        tower.state = starbaseStateAnchored;
+        tower.cycleStart = 0;
+        tower.reinforcedUntil = 0;
+        ++mStats.offlined;
+    }
+    else
+        tower.cycleStart += burnt * Win32Time_Hour;
+
+    return true;
+}
+
+uint64 StarbaseSimulator::_CycleEnd( const Tower& tower )
+{
+    if( 0 == tower.cycleStart )
+        return 0;
+
+    return tower.cycleStart + Win32Time_Hour;
+}
+
+bool StarbaseSimulator::_SaveStates( const std::vector< uint32 >& towerIDs )
+{
+    if( towerIDs.empty() )
+        return true;
+
+    std::string values;
+    char buf[ 96 ];
+
+    std::vector< uint32 >::const_iterator cur, end;
+    cur = towerIDs.begin();
+    end = towerIDs.end();
+    for(; cur != end; cur++ )
+    {
+        const Tower& tower = mTowers[ *cur ];
+
+        snprintf( buf, sizeof( buf ), "%s(%u, %u, %" PRIu64 ", %" PRIu64 ")",
+                  ( values.empty() ? "" : ", " ), tower.towerID, (uint32)tower.state, tower.cycleStart, tower.reinforcedUntil );
+        values += buf;
+    }
+
+    DBerror err;
+    if( !sDatabase.RunQuery( err,
+        "INSERT INTO posTowerState ( towerID, state, cycleStart, reinforcedUntil )"
+        " VALUES %s"
+        " ON DUPLICATE KEY UPDATE"
+        "  state = VALUES( state ),"
+        "  cycleStart = VALUES( cycleStart ),"
+        "  reinforcedUntil = VALUES( reinforcedUntil )",
+        values.c_str() ) )
+    {
+        _log( DATABASE__ERROR, "Failed to save the states of %u control towers: %s.", (uint32)towerIDs.size(), err.c_str() );
+        return false;
+    }
+
+    return true;
+}
+
+void StarbaseSimulator::_SchedulePass()
+{
+    uint64 next = 0;
+
+    std::map< uint32, Tower >::const_iterator cur, end;
+    cur = mTowers.begin();
+    end = mTowers.end();
+    for(; cur != end; cur++ )
+    {
+        const Tower& tower = cur->second;
+
+        uint64 due = _CycleEnd( tower );
+        if( starbaseStateReinforced == tower.state && ( 0 == due || tower.reinforcedUntil < due ) )
+            due = tower.reinforcedUntil;
+
+        if( 0 != due && ( 0 == next || due < next ) )
+            next = due;
+    }
+
+    if( 0 == next )
+    {
+        sTimerWheel.Cancel( &mPassTimer );
+        return;
+    }
+
+    const uint64 now = Win32TimeNow();
+    const uint64 delay = ( next > now ? ( next - now ) / ( Win32Time_Second / 1000 ) : 0 ) + STARBASE_PASS_DELAY;
+    sTimerWheel.Schedule( &mPassTimer, (uint32)std::min< uint64 >( delay, 0xFFFFFFFF ) );
+}
@@ -106,7 +106,7 @@ double Structure::GetCapacity(EVEItemFlags flag) const
     switch( flag ) {
         // the .get_float() part is a evil hack.... as this function should return a EvilNumber.
         case flagAutoFit:
-        case flagCargoHold:           return GetAttribute(AttrCapacity).get_float();
+        case flagCargoHold:           return GetAttributeValue(AttrCapacity);
         case flagSecondaryStorage:    return GetAttribute(AttrCapacitySecondary).get_float();
         case flagSpecializedAmmoHold: return GetAttribute(AttrAmmoCapacity).get_float();
         default:                      return 0.0;
@@ -326,11 +326,11 @@ void StructureEntity::EncodeDestiny( Buffer& into ) const
 
 void StructureEntity::MakeDamageState(DoDestinyDamageState &into) const
 {
-    into.shield = (m_self->GetAttribute(AttrShieldCharge).get_float() / m_self->GetAttribute(AttrShieldCapacity).get_float());
+    into.shield = (m_self->GetAttributeValue(AttrShieldCharge) / m_self->GetAttributeValue(AttrShieldCapacity));
     into.tau = 100000;    //no freaking clue.
     into.timestamp = Win32TimeNow();
 //    armor damage isn't working...
-    into.armor = 1.0 - (m_self->GetAttribute(AttrArmorDamage).get_float() / m_self->GetAttribute(AttrArmorHP).get_float());
-    into.structure = 1.0 - (m_self->GetAttribute(AttrDamage).get_float() / m_self->GetAttribute(AttrHp).get_float());
+    into.armor = 1.0 - (m_self->GetAttributeValue(AttrArmorDamage) / m_self->GetAttributeValue(AttrArmorHP));
+    into.structure = 1.0 - (m_self->GetAttributeValue(AttrDamage) / m_self->GetAttributeValue(AttrHp));
 }
 
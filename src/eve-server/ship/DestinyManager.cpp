@@ -87,6 +87,25 @@ void DestinyManager::Process() {
     ProcessTic();
 }
 
+bool DestinyManager::IsIdle() const {
+    //the states ProcessTic() leaves alone.
+    switch(State) {
+    case DSTBALL_STOP:
+        return(!m_velocity.isNotZero());
+    case DSTBALL_MISSILE:
+    case DSTBALL_MUSHROOM:
+    case DSTBALL_BOID:
+    case DSTBALL_TROLL:
+    case DSTBALL_MINIBALL:
+    case DSTBALL_FIELD:
+    case DSTBALL_FORMATION:
+    case DSTBALL_RIGID:
+        return true;
+    default:
+        return false;
+    }
+}
+
 void DestinyManager::SendSingleDestinyUpdate(PyTuple **up, bool self_only) const {
     std::vector<PyTuple *> updates(1, *up);
     *up = NULL;
@@ -132,7 +151,7 @@ void DestinyManager::SendDestinyUpdate( std::vector<PyTuple*>& updates, std::vec
     {
         _log( DESTINY__TRACE, "[%u] Broadcasting destiny update (%lu, %lu)", GetStamp(), updates.size(), events.size() );
 
-        m_self->Bubble()->BubblecastDestiny( updates, events, "destiny" );
+        m_self->Bubble()->BubblecastDestiny( updates, events, "destiny", m_self );
     }
     else
     {
@@ -349,7 +368,7 @@ void DestinyManager::_Move() {
     GVector calc_acceleration = vector_to_goal * m_accelerationFactor;    //fric*m/(s*agi*kg) = m/s^2
 
     // Check to see if we have a pending docking operation and attempt to dock if so:
-    if( m_self->CastToClient()->GetPendingDockOperation() )
+    if( m_self->IsClient() && m_self->CastToClient()->GetPendingDockOperation() )
         AttemptDockOperation();
 
     _MoveAccel(calc_acceleration);
@@ -509,9 +528,9 @@ void DestinyManager::_InitWarp() {
     warp_slow_time += warp_distance * 3.0f;
     warp_slow_time /= warp_speed * 3.0f;    //v40 ~9.1105
 
-    sLog.Debug( "DestinyManager::_InitWarp():", "Warp will accelerate for %f s, then slow down at %f s", warp_acceleration_time, warp_slow_time);
+    _debug( "DestinyManager::_InitWarp():", "Warp will accelerate for %f s, then slow down at %f s", warp_acceleration_time, warp_slow_time);
 
-    sLog.Debug( "DestinyManager::_InitWarp():", "Opposite warp direction is (%.13f, %.13f, %.13f)",
+    _debug( "DestinyManager::_InitWarp():", "Opposite warp direction is (%.13f, %.13f, %.13f)",
         vector_from_goal.x, vector_from_goal.y, vector_from_goal.z);
 
     delete m_warpState;
@@ -562,7 +581,7 @@ void DestinyManager::_Warp() {
         // Remove ship from bubble only when distance traveled takes the ship beyond the bubble's radius
         m_system->bubbles.UpdateBubble(m_self,true,true);   // use optional 3rd param to indicate ship is warping so as to not add to new bubbles while accelerating into warp
 
-        sLog.Debug( "DestinyManager::_Warp():", "Entity %u: Warp Accelerating: velocity %f m/s with %f m left to go.",
+        _debug( "DestinyManager::_Warp():", "Entity %u: Warp Accelerating: velocity %f m/s with %f m left to go.",
             m_self->GetID(),
             velocity_magnitude, dist_remaining);
 
@@ -582,7 +601,7 @@ void DestinyManager::_Warp() {
     //        m_self->Bubble()->Remove(m_self);
     //    }
 
-        sLog.Debug( "DestinyManager::_Warp():", "Entity %u: Warp Cruising: velocity %f m/s with %f m left to go.",
+        _debug( "DestinyManager::_Warp():", "Entity %u: Warp Cruising: velocity %f m/s with %f m left to go.",
             m_self->GetID(),
             velocity_magnitude, dist_remaining);
     } else {
@@ -602,7 +621,7 @@ void DestinyManager::_Warp() {
         if(velocity_magnitude < 0)
             velocity_magnitude = -velocity_magnitude;
 
-        sLog.Debug( "DestinyManager::_Warp():", "Entity %u: Warp Slowing: velocity %f m/s with %f m left to go.",
+        _debug( "DestinyManager::_Warp():", "Entity %u: Warp Slowing: velocity %f m/s with %f m left to go.",
             m_self->GetID(),
             velocity_magnitude, dist_remaining);
 
@@ -638,7 +657,7 @@ void DestinyManager::_Warp() {
     m_velocity = m_warpState->normvec_them_to_us * (-velocity_magnitude);
 
     if(stop) {
-        sLog.Debug( "DestinyManager::_Warp():", "Entity %u: Warp completed. Exit velocity %f m/s with %f m left to go.",
+        _debug( "DestinyManager::_Warp():", "Entity %u: Warp completed. Exit velocity %f m/s with %f m left to go.",
             m_self->GetID(),
             velocity_magnitude, dist_remaining);
         //they re-calculated the velocity, but it was exactly the same..
@@ -939,7 +958,7 @@ void DestinyManager::Follow(SystemEntity *who, double distance, bool update) {
         SendSingleDestinyUpdate(&tmp);    //consumed
     }
 
-    sLog.Debug( "DestinyManager::GotoDirection()", "SystemEntity '%s' following SystemEntity '%s' at velocity %f",
+    _debug( "DestinyManager::GotoDirection()", "SystemEntity '%s' following SystemEntity '%s' at velocity %f",
                 m_self->GetName(), who->GetName(), m_maxVelocity );
 
     // Forcibly set Speed since it doesn't get updated when Following upon Undock from stations:
@@ -1004,11 +1023,11 @@ void DestinyManager::OrbitingCruise(SystemEntity *who, double distance, bool upd
 
 void DestinyManager::SetShipCapabilities(InventoryItemRef ship)
 {
-    double mass = ship->GetAttribute(AttrMass).get_float();               // Aknor: EVEAttributeMgr cant find this
-    double radius = ship->GetAttribute(AttrRadius).get_float();         // Aknor: EVEAttributeMgr cant find this, assertion failed: "mType == evil_number_float", line 189 EvilNumber.h
+    double mass = ship->GetAttributeValue(AttrMass);               // Aknor: EVEAttributeMgr cant find this
+    double radius = ship->GetAttributeValue(AttrRadius);         // Aknor: EVEAttributeMgr cant find this, assertion failed: "mType == evil_number_float", line 189 EvilNumber.h
     double Inertia = ship->GetAttribute(AttrInertia).get_float();       // Aknor: EVEAttributeMgr cant find this, assertion failed: "mType == evil_number_float", line 189 EvilNumber.h
-    double agility = ship->GetAttribute(AttrAgility).get_float();
-    double maxVelocity = ship->GetAttribute(AttrMaxVelocity).get_float();
+    double agility = ship->GetAttributeValue(AttrAgility);
+    double maxVelocity = ship->GetAttributeValue(AttrMaxVelocity);
 
     //might need to care about turnAngle: Maximum turn angle of a ship in Radians, 0 to pi (3.14).
     //might need newAgility: Maximum "Thrust angle" for an object in Radians, 0 to pi (3.14).
@@ -1105,7 +1124,7 @@ void DestinyManager::AlignTo(const GPoint &direction, bool update) {
         SendSingleDestinyUpdate(&tmp);    //consumed
     }
 
-    sLog.Debug( "DestinyManager::GotoDirection()", "SystemEntity '%s' vectoring to (%f,%f,%f) at velocity %f",
+    _debug( "DestinyManager::GotoDirection()", "SystemEntity '%s' vectoring to (%f,%f,%f) at velocity %f",
                 m_self->GetName(), direction.x, direction.y, direction.z, m_maxVelocity );
 }
 
@@ -1125,7 +1144,7 @@ void DestinyManager::GotoDirection(const GPoint &direction, bool update) {
     //Clear any pending docking operation since the user set a new course:
     m_self->CastToClient()->SetPendingDockOperation( false );
 
-    sLog.Debug( "DestinyManager::GotoDirection()", "SystemEntity '%s' vectoring to (%f,%f,%f) at velocity %f",
+    _debug( "DestinyManager::GotoDirection()", "SystemEntity '%s' vectoring to (%f,%f,%f) at velocity %f",
                 m_self->GetName(), direction.x, direction.y, direction.z, m_maxVelocity );
 
     if(update) {
@@ -1479,7 +1498,7 @@ void DestinyManager::SendBallInfoOnUndock(bool update) const {
 
     DoDestiny_SetBallMass sbmass;
     sbmass.entityID = m_self->GetID();
-    sbmass.mass = m_self->Item()->GetAttribute(AttrMass).get_float();
+    sbmass.mass = m_self->Item()->GetAttributeValue(AttrMass);
     updates.push_back(sbmass.Encode());
 
     DoDestiny_SetBallVelocity sbvelocity;
@@ -1563,7 +1582,7 @@ void DestinyManager::SendEjectShip(const ShipRef capsuleRef, const ShipRef oldSh
     // Set Capsule's max velocity:
     DoDestiny_CmdSetMaxSpeed du_setMaxSpeed;
     du_setMaxSpeed.entityID = capsuleRef->itemID();
-    du_setMaxSpeed.speed = capsuleRef->GetAttribute(AttrMaxVelocity).get_float();
+    du_setMaxSpeed.speed = capsuleRef->GetAttributeValue(AttrMaxVelocity);
     updates.push_back(du_setMaxSpeed.Encode());
 
     SendDestinyUpdate(updates, false);
@@ -0,0 +1,236 @@
+/*
+    ------------------------------------------------------------------------------------
+    LICENSE:
+    ------------------------------------------------------------------------------------
+    This file is part of EVEmu: EVE Online Server Emulator
+    Copyright 2006 - 2011 The EVEmu Team
+    For the latest information visit http://evemu.org
+    ------------------------------------------------------------------------------------
+    This program is free software; you can redistribute it and/or modify it under
+    the terms of the GNU Lesser General Public License as published by the Free Software
+    Foundation; either version 2 of the License, or (at your option) any later
+    version.
+
+    This program is distributed in the hope that it will be useful, but WITHOUT
+    ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+    FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public License along with
+    this program; if not, write to the Free Software Foundation, Inc., 59 Temple
+    Place - Suite 330, Boston, MA 02111-1307, USA, or go to
+    http://www.gnu.org/copyleft/lesser.txt.
+    ------------------------------------------------------------------------------------
+    Author:     EVEmu Team
+*/
+
+
+#include "eve-server.h"
+
+#include "Client.h"
+#include "inventory/AttributeEnum.h"
+#include "npc/NPC.h"
+#include "ship/DestinyManager.h"
+#include "ship/DroneSwarm.h"
+#include "system/Damage.h"
+#include "system/SystemBubble.h"
+#include "system/SystemManager.h"
+
+DroneSwarmManager::DroneSwarmManager(SystemManager &system)
+: m_system(system),
+  m_thinkTimer(DRONE_SWARM_THINK_MS)
+{
+}
+
+DroneSwarmManager::~DroneSwarmManager() {
+}
+
+void DroneSwarmManager::Add(Client *owner, NPC *drone) {
+    Swarm &swarm = m_swarms[owner->GetCharacterID()];
+    //a pilot coming back takes over the drones it left behind.
+    swarm.owner = owner;
+    swarm.drones.push_back(drone);
+    swarm.ordered = false;
+
+    m_owners[drone->GetID()] = owner->GetCharacterID();
+    drone->SetSwarmed(true);
+}
+
+void DroneSwarmManager::Remove(NPC *drone) {
+    std::map<uint32, uint32>::iterator res = m_owners.find(drone->GetID());
+    if(res == m_owners.end())
+        return;
+    std::map<uint32, Swarm>::iterator swarm = m_swarms.find(res->second);
+    m_owners.erase(res);
+    if(swarm == m_swarms.end())
+        return;
+
+    std::vector<NPC *> &drones = swarm->second.drones;
+    drones.erase(std::remove(drones.begin(), drones.end(), drone), drones.end());
+    if(drones.empty())
+        m_swarms.erase(swarm);
+}
+
+void DroneSwarmManager::Abandon(Client *owner) {
+    std::map<uint32, Swarm>::iterator res = m_swarms.find(owner->GetCharacterID());
+    if(res == m_swarms.end())
+        return;
+    //the drones keep their last orders; destiny drops the pilot as it leaves.
+    res->second.owner = NULL;
+    res->second.targetID = 0;
+}
+
+void DroneSwarmManager::Process() {
+    if(m_swarms.empty() || !m_thinkTimer.Check())
+        return;
+
+    std::map<uint32, Swarm>::iterator cur, end;
+    cur = m_swarms.begin();
+    end = m_swarms.end();
+    for(; cur != end; cur++)
+        _Think(cur->second);
+}
+
+void DroneSwarmManager::_Think(Swarm &swarm) {
+    if(swarm.owner == NULL)
+        return;
+
+    //the first target the pilot locked, unless it is the pilot or one of its drones.
+    SystemEntity *target = swarm.owner->targets.GetFirstTarget(true);
+    if(target != NULL) {
+        std::map<uint32, uint32>::const_iterator res = m_owners.find(target->GetID());
+        if(target == swarm.owner
+           || (res != m_owners.end() && res->second == swarm.owner->GetCharacterID()))
+            target = NULL;
+    }
+
+    const uint32 targetID = (target != NULL ? target->GetID() : 0);
+    if(!swarm.ordered || targetID != swarm.targetID) {
+        _log(NPC__AI_TRACE, "Swarm of %s: %u drones now after %u.", swarm.owner->GetName(), (uint32)swarm.drones.size(), targetID);
+        swarm.targetID = targetID;
+        _Order(swarm, target);
+    }
+
+    if(target != NULL)
+        _Volley(swarm, target);
+}
+
+void DroneSwarmManager::_Order(Swarm &swarm, SystemEntity *target) {
+    SystemEntity *orbited = (target != NULL ? target : swarm.owner);
+
+    //the orders of the drones, collected per bubble.
+    std::map<SystemBubble *, std::vector<PyTuple *> > updates;
+
+    std::vector<NPC *>::const_iterator cur, end;
+    cur = swarm.drones.begin();
+    end = swarm.drones.end();
+    for(; cur != end; cur++) {
+        NPC *drone = *cur;
+        double distance = DRONE_IDLE_ORBIT;
+        if(target != NULL) {
+            distance = drone->Item()->GetAttribute(AttrOrbitRange).get_float();
+            if(distance <= 0.0)
+                distance = DRONE_IDLE_ORBIT;
+        }
+
+        drone->Destiny()->SetSpeedFraction(1.0, false);
+        drone->Destiny()->Orbit(orbited, distance, false);
+
+        SystemBubble *bubble = drone->Bubble();
+        if(bubble == NULL)
+            continue;
+        std::vector<PyTuple *> &into = updates[bubble];
+
+        DoDestiny_CmdSetSpeedFraction speed;
+        speed.entityID = drone->GetID();
+        speed.fraction = 1.0;
+        into.push_back(speed.Encode());
+
+        DoDestiny_CmdOrbit orbit;
+        orbit.entityID = drone->GetID();
+        orbit.orbitEntityID = orbited->GetID();
+        orbit.distance = uint32(distance);
+        into.push_back(orbit.Encode());
+    }
+    swarm.ordered = true;
+
+    std::vector<PyTuple *> events;
+    std::map<SystemBubble *, std::vector<PyTuple *> >::iterator bcur, bend;
+    bcur = updates.begin();
+    bend = updates.end();
+    for(; bcur != bend; bcur++)
+        bcur->first->BubblecastDestiny(bcur->second, events, "drone swarm orders");    //consumed
+}
+
+void DroneSwarmManager::_Volley(Swarm &swarm, SystemEntity *target) {
+    const uint32 now = Timer::GetCurrentTime();
+    if(static_cast<int32>(now - swarm.nextVolley) < 0)
+        return;
+
+    //the weapon effects of the drones, collected per bubble.
+    std::map<SystemBubble *, std::vector<PyTuple *> > effects;
+    NPC *source = NULL;
+    double kinetic = 0.0, thermal = 0.0, em = 0.0, explosive = 0.0;
+    uint32 cycle = 0;
+
+    std::vector<NPC *>::const_iterator cur, end;
+    cur = swarm.drones.begin();
+    end = swarm.drones.end();
+    for(; cur != end; cur++) {
+        NPC *drone = *cur;
+        InventoryItemRef self = drone->Item();
+
+        double range = self->GetAttribute(AttrEntityAttackRange).get_float();
+        if(range <= 0.0)
+            range = self->GetAttribute(AttrMaxRange).get_float();
+        if(drone->DistanceTo2(target) > range * range)
+            continue;
+
+        //the swarm fires at the pace of its fastest drone in range.
+        const uint32 speed = static_cast<uint32>(self->GetAttribute(AttrSpeed).get_int());
+        if(cycle == 0 || speed < cycle)
+            cycle = speed;
+
+        Damage d(drone, self, effectTargetAttack);
+        drone->ApplyDamageModifiers(d, drone);
+        kinetic += d.kinetic;
+        thermal += d.thermal;
+        em += d.em;
+        explosive += d.explosive;
+        if(source == NULL)
+            source = drone;
+
+        SystemBubble *bubble = drone->Bubble();
+        if(bubble == NULL)
+            continue;
+
+        DoDestiny_OnSpecialFX13 sfx;
+        sfx.entityID = self->itemID();
+        sfx.moduleID = self->itemID();
+        sfx.moduleTypeID = self->typeID();
+        sfx.targetID = target->GetID();
+        sfx.otherTypeID = target->Item()->typeID();
+        sfx.effect_type = "effects.Laser";
+        sfx.isOffensive = 1;
+        sfx.start = 1;
+        sfx.active = 1;
+        sfx.duration_ms = speed;
+        sfx.repeat = 1;
+        sfx.startTime = Win32TimeNow();
+        effects[bubble].push_back(sfx.Encode());
+    }
+
+    //nobody in range yet; look again on the next think.
+    if(source == NULL)
+        return;
+    swarm.nextVolley = now + std::max<uint32>(cycle, DRONE_SWARM_THINK_MS);
+
+    std::vector<PyTuple *> events;
+    std::map<SystemBubble *, std::vector<PyTuple *> >::iterator bcur, bend;
+    bcur = effects.begin();
+    bend = effects.end();
+    for(; bcur != bend; bcur++)
+        bcur->first->BubblecastDestiny(bcur->second, events, "drone swarm volley");    //consumed
+
+    Damage volley(source, source->Item(), kinetic, thermal, em, explosive, effectTargetAttack);
+    target->ApplyDamage(volley);
+}
@@ -0,0 +1,380 @@
+/*
+    ------------------------------------------------------------------------------------
+    LICENSE:
+    ------------------------------------------------------------------------------------
+    This file is part of EVEmu: EVE Online Server Emulator
+    Copyright 2006 - 2011 The EVEmu Team
+    For the latest information visit http://evemu.org
+    ------------------------------------------------------------------------------------
+    This program is free software; you can redistribute it and/or modify it under
+    the terms of the GNU Lesser General Public License as published by the Free Software
+    Foundation; either version 2 of the License, or (at your option) any later
+    version.
+
+    This program is distributed in the hope that it will be useful, but WITHOUT
+    ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+    FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public License along with
+    this program; if not, write to the Free Software Foundation, Inc., 59 Temple
+    Place - Suite 330, Boston, MA 02111-1307, USA, or go to
+    http://www.gnu.org/copyleft/lesser.txt.
+    ------------------------------------------------------------------------------------
+    Author:     EVEmu Team
+*/
+
+#include "eve-server.h"
+
+#include "inventory/AttributeEnum.h"
+#include "ship/FittingEvaluator.h"
+#include "ship/dgmtypeattributeinfo.h"
+#include "ship/modules/ModuleEffects.h"
+
+/*************************************************************************/
+/* FittingSpec                                                           */
+/*************************************************************************/
+// FNV-1a, 64 bit
+static const uint64 FITTING_HASH_BASIS = 0xCBF29CE484222325ULL;
+static const uint64 FITTING_HASH_PRIME = 0x00000100000001B3ULL;
+
+static void HashValue( uint64& hash, uint32 value )
+{
+    for( uint32 i = 0; i < 4; ++i, value >>= 8 )
+    {
+        hash ^= ( value & 0xFF );
+        hash *= FITTING_HASH_PRIME;
+    }
+}
+
+uint64 FittingSpec::GetHash() const
+{
+    uint64 hash = FITTING_HASH_BASIS;
+    HashValue( hash, shipTypeID );
+
+    HashValue( hash, modules.size() );
+    std::vector< Module >::const_iterator cur, end;
+    cur = modules.begin();
+    end = modules.end();
+    for(; cur != end; ++cur)
+    {
+        HashValue( hash, cur->typeID );
+        HashValue( hash, cur->chargeTypeID );
+        HashValue( hash, ( cur->online ? 1 : 0 ) | ( cur->overloaded ? 2 : 0 ) );
+    }
+
+    HashValue( hash, skills.size() );
+    std::map< uint32, uint8 >::const_iterator curs, ends;
+    curs = skills.begin();
+    ends = skills.end();
+    for(; curs != ends; ++curs)
+    {
+        HashValue( hash, curs->first );
+        HashValue( hash, curs->second );
+    }
+
+    return hash;
+}
+
+bool FittingSpec::operator==( const FittingSpec& oth ) const
+{
+    if( shipTypeID != oth.shipTypeID
+        || modules.size() != oth.modules.size()
+        || skills != oth.skills )
+        return false;
+
+    for( size_t i = 0; i < modules.size(); ++i )
+    {
+        const Module& a = modules[ i ];
+        const Module& b = oth.modules[ i ];
+
+        if( a.typeID != b.typeID
+            || a.chargeTypeID != b.chargeTypeID
+            || a.online != b.online
+            || a.overloaded != b.overloaded )
+            return false;
+    }
+
+    return true;
+}
+
+/*************************************************************************/
+/* FittingSnapshot                                                       */
+/*************************************************************************/
+static bool AttributeLess( const std::pair< uint32, double >& a, uint32 attributeID )
+{
+    return a.first < attributeID;
+}
+
+bool FittingSnapshot::Find( const AttributeList& attributes, uint32 attributeID, double& into )
+{
+    AttributeList::const_iterator res = std::lower_bound( attributes.begin(), attributes.end(), attributeID, AttributeLess );
+    if( res == attributes.end() || res->first != attributeID )
+        return false;
+
+    into = res->second;
+    return true;
+}
+
+/*************************************************************************/
+/* FittingEvaluator                                                      */
+/*************************************************************************/
+namespace
+{
+    // IDs of the items in the graph of a fitting; no real items are involved
+    const uint32 FITTING_SHIP_ID = 1;
+    inline uint32 FittingModuleID( uint32 index ) { return 2 + 2 * index; }
+    inline uint32 FittingChargeID( uint32 index ) { return 3 + 2 * index; }
+    inline uint32 FittingSkillID( uint32 typeID ) { return 0x80000000 | typeID; }
+
+    /**
+     * @brief Builds the graph of a single fitting.
+     */
+    class FittingGraph
+    {
+    public:
+        /**
+         * @brief Adds an item with the attributes of its type.
+         *
+         * @param[in] itemID ID of the item in the graph.
+         * @param[in] typeID Type of the item.
+         * @param[in] scale  Factor of the attributes.
+         *
+         * @return False if the type has no attributes.
+         */
+        bool AddItem( uint32 itemID, uint32 typeID, double scale = 1.0 )
+        {
+            DgmTypeAttributeSet attributes;
+            if( !sDgmTypeAttrMgr.GetDmgTypeAttributeSet( typeID, attributes ) )
+                return false;
+
+            std::set< uint32 >& known = mAttributes[ itemID ];
+            for( uint32 i = 0; i < attributes.size(); ++i )
+            {
+                EvilNumber value = attributes.value( i );
+                mGraph.SetBaseValue( itemID, attributes.attributeID( i ), scale * value.get_float() );
+                known.insert( attributes.attributeID( i ) );
+            }
+
+            mTypes[ itemID ] = typeID;
+            return true;
+        }
+
+        /**
+         * @brief Sets the unmodified value of an attribute of an item.
+         *
+         * @param[in] itemID      ID of the item in the graph.
+         * @param[in] attributeID ID of the attribute.
+         * @param[in] value       The value.
+         */
+        void SetBaseValue( uint32 itemID, uint32 attributeID, double value )
+        {
+            mGraph.SetBaseValue( itemID, attributeID, value );
+            mAttributes[ itemID ].insert( attributeID );
+        }
+
+        /**
+         * @brief Runs the compiled effects of an item for a state.
+         *
+         * @param[in] itemID ID of the item in the graph.
+         * @param[in] state  The state.
+         */
+        void ApplyEffects( uint32 itemID, ModuleEffectTriggers state )
+        {
+            const TypeEffects* effects = sDGM_Effects_Table.GetTypeEffects( mTypes[ itemID ] );
+            const EffectProgram& program = effects->GetProgram( state );
+
+            EffectProgram::const_iterator cur, end;
+            cur = program.begin();
+            end = program.end();
+            for(; cur != end; ++cur)
+            {
+                if( cur->operation == EFFECT_OPERATION_NONE )
+                    continue;
+
+                ModifierGraph::Modifier modifier;
+                modifier.sourceItemID = itemID;
+                modifier.sourceAttributeID = cur->sourceAttributeID;
+                modifier.value = 0.0;
+                modifier.effectID = cur->effectID;
+                modifier.targetAttributeID = cur->targetAttributeID;
+                modifier.operation = (ModifierGraph::Operation)cur->operation;
+                modifier.penalized = ( cur->penalized != 0 );
+
+                switch( EFFECT_TARGET_SELF + cur->target )
+                {
+                    case EFFECT_TARGET_SELF:    modifier.targetItemID = itemID;            break;
+                    case EFFECT_TARGET_SHIP:    modifier.targetItemID = FITTING_SHIP_ID;   break;
+                    default:                    continue;   // nobody is targeted in a fitting
+                }
+
+                // sources the type does not have start from 0, like GetDefaultAttribute()
+                std::set< uint32 >& sources = mAttributes[ itemID ];
+                if( sources.insert( modifier.sourceAttributeID ).second )
+                    mGraph.SetBaseValue( itemID, modifier.sourceAttributeID, 0.0 );
+
+                std::set< uint32 >& targets = mAttributes[ modifier.targetItemID ];
+                if( targets.insert( modifier.targetAttributeID ).second )
+                    mGraph.SetBaseValue( modifier.targetItemID, modifier.targetAttributeID, 0.0 );
+
+                mGraph.AddModifier( modifier );
+            }
+        }
+
+        /**
+         * @brief Copies the computed attributes of an item.
+         *
+         * @param[in]  itemID ID of the item in the graph.
+         * @param[out] into   The attributes.
+         */
+        void GetAttributes( uint32 itemID, FittingSnapshot::AttributeList& into )
+        {
+            std::vector< ModifierGraph::Change > changes;
+            mGraph.Update( changes );
+
+            const std::set< uint32 >& known = mAttributes[ itemID ];
+            into.reserve( known.size() );
+
+            // the set is sorted already
+            std::set< uint32 >::const_iterator cur, end;
+            cur = known.begin();
+            end = known.end();
+            for(; cur != end; ++cur)
+            {
+                double value = 0.0;
+                mGraph.GetValue( itemID, *cur, value );
+                into.push_back( std::make_pair( *cur, value ) );
+            }
+        }
+
+    protected:
+        ModifierGraph mGraph;
+        /// Attributes of each item in the graph.
+        std::map< uint32, std::set< uint32 > > mAttributes;
+        /// Types of the items.
+        std::map< uint32, uint32 > mTypes;
+    };
+}
+
+FittingEvaluator::FittingEvaluator()
+: mCapacity( 0 )
+{
+}
+
+void FittingEvaluator::SetCapacity( size_t capacity )
+{
+    mCapacity = capacity;
+    _Trim();
+}
+
+FittingSnapshotRef FittingEvaluator::Evaluate( const FittingSpec& spec )
+{
+    const uint64 hash = spec.GetHash();
+
+    std::tr1::unordered_map< uint64, Entry >::iterator res = mCache.find( hash );
+    if( res != mCache.end() && res->second.spec == spec )
+    {
+        // most recently used now
+        mOrder.splice( mOrder.end(), mOrder, res->second.order );
+
+        ++mStats.hits;
+        return res->second.snapshot;
+    }
+
+    const uint64 start = GetTimeUSeconds();
+    FittingSnapshotRef snapshot( _Compute( spec ) );
+    mStats.evaluateTime += GetTimeUSeconds() - start;
+    ++mStats.evaluations;
+
+    if( !snapshot || 0 == mCapacity )
+        return snapshot;
+
+    if( res == mCache.end() )
+    {
+        res = mCache.insert( std::make_pair( hash, Entry() ) ).first;
+        res->second.order = mOrder.insert( mOrder.end(), hash );
+    }
+    else
+        // another fitting with the same hash; replace it
+        mOrder.splice( mOrder.end(), mOrder, res->second.order );
+
+    res->second.spec = spec;
+    res->second.snapshot = snapshot;
+
+    _Trim();
+    return snapshot;
+}
+
+void FittingEvaluator::Clear()
+{
+    mCache.clear();
+    mOrder.clear();
+}
+
+FittingSnapshot* FittingEvaluator::_Compute( const FittingSpec& spec ) const
+{
+    FittingGraph graph;
+    if( !graph.AddItem( FITTING_SHIP_ID, spec.shipTypeID ) )
+        return NULL;
+    graph.ApplyEffects( FITTING_SHIP_ID, EFFECT_PERSISTENT );
+
+    std::map< uint32, uint8 >::const_iterator curs, ends;
+    curs = spec.skills.begin();
+    ends = spec.skills.end();
+    for(; curs != ends; ++curs)
+    {
+        if( 0 == curs->second )
+            continue;
+
+        // the bonuses of a skill are per level trained
+        const uint32 skillID = FittingSkillID( curs->first );
+        if( !graph.AddItem( skillID, curs->first, curs->second ) )
+            continue;
+        graph.SetBaseValue( skillID, AttrSkillLevel, curs->second );
+
+        graph.ApplyEffects( skillID, EFFECT_PERSISTENT );
+    }
+
+    for( uint32 i = 0; i < spec.modules.size(); ++i )
+    {
+        const FittingSpec::Module& module = spec.modules[ i ];
+
+        const uint32 moduleID = FittingModuleID( i );
+        if( graph.AddItem( moduleID, module.typeID ) )
+        {
+            graph.ApplyEffects( moduleID, EFFECT_PERSISTENT );
+            if( module.online )
+                graph.ApplyEffects( moduleID, EFFECT_ONLINE );
+            if( module.online && module.overloaded )
+                graph.ApplyEffects( moduleID, EFFECT_OVERLOAD );
+        }
+
+        const uint32 chargeID = FittingChargeID( i );
+        if( 0 != module.chargeTypeID && graph.AddItem( chargeID, module.chargeTypeID ) )
+            graph.ApplyEffects( chargeID, EFFECT_PERSISTENT );
+    }
+
+    FittingSnapshot* snapshot = new FittingSnapshot;
+    graph.GetAttributes( FITTING_SHIP_ID, snapshot->mShip );
+
+    snapshot->mModules.resize( spec.modules.size() );
+    snapshot->mCharges.resize( spec.modules.size() );
+    for( uint32 i = 0; i < spec.modules.size(); ++i )
+    {
+        graph.GetAttributes( FittingModuleID( i ), snapshot->mModules[ i ] );
+        if( 0 != spec.modules[ i ].chargeTypeID )
+            graph.GetAttributes( FittingChargeID( i ), snapshot->mCharges[ i ] );
+    }
+
+    return snapshot;
+}
+
+void FittingEvaluator::_Trim()
+{
+    while( mCache.size() > mCapacity )
+    {
+        mCache.erase( mOrder.front() );
+        mOrder.pop_front();
+
+        ++mStats.evictions;
+    }
+}
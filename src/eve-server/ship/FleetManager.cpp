@@ -0,0 +1,471 @@
+/*
+    ------------------------------------------------------------------------------------
+    LICENSE:
+    ------------------------------------------------------------------------------------
+    This file is part of EVEmu: EVE Online Server Emulator
+    Copyright 2006 - 2011 The EVEmu Team
+    For the latest information visit http://evemu.org
+    ------------------------------------------------------------------------------------
+    This program is free software; you can redistribute it and/or modify it under
+    the terms of the GNU Lesser General Public License as published by the Free Software
+    Foundation; either version 2 of the License, or (at your option) any later
+    version.
+
+    This program is distributed in the hope that it will be useful, but WITHOUT
+    ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+    FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public License along with
+    this program; if not, write to the Free Software Foundation, Inc., 59 Temple
+    Place - Suite 330, Boston, MA 02111-1307, USA, or go to
+    http://www.gnu.org/copyleft/lesser.txt.
+    ------------------------------------------------------------------------------------
+    Author:     EVEmu Team
+*/
+
+
+#include "eve-server.h"
+
+#include "Client.h"
+#include "EntityList.h"
+#include "ship/FleetManager.h"
+
+FleetManager::FleetManager()
+: mNextID( 1 )
+{
+}
+
+void FleetManager::Process()
+{
+    if( mWarps.empty() )
+        return;
+
+    // warps queued while issuing these wait for the next tick
+    std::vector<PendingWarp> warps;
+    warps.swap( mWarps );
+
+    std::vector<uint32> members;
+
+    std::vector<PendingWarp>::const_iterator cur, end;
+    cur = warps.begin();
+    end = warps.end();
+    for(; cur != end; ++cur )
+    {
+        std::tr1::unordered_map<uint32, Member>::const_iterator res = mMembers.find( cur->commanderID );
+        if( res == mMembers.end() )
+            continue;
+
+        Client* commander = sEntityList.FindCharacter( cur->commanderID );
+        if( NULL == commander || !commander->IsInSpace() )
+            continue;
+        const uint32 solarSystemID = commander->GetSystemID();
+
+        members.clear();
+        _GetScope( res->second, (FleetScope)cur->scope, members );
+
+        std::vector<uint32>::const_iterator curm, endm;
+        curm = members.begin();
+        endm = members.end();
+        for(; curm != endm; ++curm )
+        {
+            Client* client = sEntityList.FindCharacter( *curm );
+            if( NULL == client || NULL == client->Destiny() )
+                continue;
+            if( !client->IsInSpace() || client->GetSystemID() != solarSystemID )
+                continue;
+
+            client->WarpTo( cur->to, cur->distance );
+            ++mStats.warps;
+        }
+
+        ++mStats.fleetWarps;
+    }
+}
+
+uint32 FleetManager::CreateFleet( uint32 commanderID )
+{
+    if( mMembers.find( commanderID ) != mMembers.end() )
+        return 0;
+
+    const uint32 fleetID = mNextID++;
+
+    Fleet& fleet = mFleets[ fleetID ];
+    fleet.commanderID = commanderID;
+    fleet.memberCount = 1;
+
+    CreateSquad( CreateWing( fleetID ) );
+
+    Member& member = mMembers[ commanderID ];
+    member.fleetID = fleetID;
+    member.wingID = 0;
+    member.squadID = 0;
+    member.role = ROLE_FLEET_COMMANDER;
+    ++mStats.joins;
+
+    _UpdateSession( commanderID, &member );
+    return fleetID;
+}
+
+uint32 FleetManager::CreateWing( uint32 fleetID )
+{
+    std::tr1::unordered_map<uint32, Fleet>::iterator res = mFleets.find( fleetID );
+    if( res == mFleets.end() || res->second.wings.size() >= MAX_WINGS )
+        return 0;
+
+    const uint32 wingID = mNextID++;
+
+    Wing& wing = mWings[ wingID ];
+    wing.fleetID = fleetID;
+    wing.commanderID = 0;
+
+    res->second.wings.push_back( wingID );
+    return wingID;
+}
+
+uint32 FleetManager::CreateSquad( uint32 wingID )
+{
+    std::tr1::unordered_map<uint32, Wing>::iterator res = mWings.find( wingID );
+    if( res == mWings.end() || res->second.squads.size() >= MAX_SQUADS )
+        return 0;
+
+    const uint32 squadID = mNextID++;
+
+    mSquads[ squadID ].wingID = wingID;
+
+    res->second.squads.push_back( squadID );
+    return squadID;
+}
+
+bool FleetManager::AddMember( uint32 fleetID, uint32 characterID )
+{
+    if( mMembers.find( characterID ) != mMembers.end() )
+        return false;
+
+    std::tr1::unordered_map<uint32, Fleet>::iterator fleet = mFleets.find( fleetID );
+    if( fleet == mFleets.end() )
+        return false;
+
+    std::vector<uint32>::const_iterator curw, endw;
+    curw = fleet->second.wings.begin();
+    endw = fleet->second.wings.end();
+    for(; curw != endw; ++curw )
+    {
+        const Wing& wing = mWings[ *curw ];
+
+        std::vector<uint32>::const_iterator curs, ends;
+        curs = wing.squads.begin();
+        ends = wing.squads.end();
+        for(; curs != ends; ++curs )
+        {
+            Squad& squad = mSquads[ *curs ];
+            if( squad.members.size() >= MAX_SQUAD_MEMBERS )
+                continue;
+
+            squad.members.push_back( characterID );
+
+            Member& member = mMembers[ characterID ];
+            member.fleetID = fleetID;
+            member.wingID = *curw;
+            member.squadID = *curs;
+            member.role = ROLE_MEMBER;
+
+            ++fleet->second.memberCount;
+            ++mStats.joins;
+
+            _UpdateSession( characterID, &member );
+            return true;
+        }
+    }
+
+    return false;
+}
+
+bool FleetManager::MoveMember( uint32 characterID, uint32 wingID, uint32 squadID, FleetRole role )
+{
+    std::tr1::unordered_map<uint32, Member>::iterator res = mMembers.find( characterID );
+    if( res == mMembers.end() )
+        return false;
+    Member& member = res->second;
+
+    if( 0 == wingID )
+    {
+        Fleet& fleet = mFleets[ member.fleetID ];
+        if( 0 != fleet.commanderID )
+            return false;
+
+        _Unplace( characterID, member );
+        fleet.commanderID = characterID;
+
+        member.wingID = 0;
+        member.squadID = 0;
+        member.role = ROLE_FLEET_COMMANDER;
+    }
+    else
+    {
+        std::tr1::unordered_map<uint32, Wing>::iterator wing = mWings.find( wingID );
+        if( wing == mWings.end() || wing->second.fleetID != member.fleetID )
+            return false;
+
+        if( 0 == squadID )
+        {
+            if( 0 != wing->second.commanderID )
+                return false;
+
+            _Unplace( characterID, member );
+            wing->second.commanderID = characterID;
+
+            member.role = ROLE_WING_COMMANDER;
+        }
+        else
+        {
+            std::tr1::unordered_map<uint32, Squad>::iterator squad = mSquads.find( squadID );
+            if( squad == mSquads.end() || squad->second.wingID != wingID )
+                return false;
+            if( ROLE_SQUAD_COMMANDER != role && ROLE_MEMBER != role )
+                return false;
+
+            const bool sameSquad = ( member.squadID == squadID );
+            if( !sameSquad && squad->second.members.size() >= MAX_SQUAD_MEMBERS )
+                return false;
+
+            if( ROLE_SQUAD_COMMANDER == role )
+            {
+                // a squad has one commander
+                std::vector<uint32>::const_iterator cur, end;
+                cur = squad->second.members.begin();
+                end = squad->second.members.end();
+                for(; cur != end; ++cur )
+                {
+                    if( *cur != characterID && ROLE_SQUAD_COMMANDER == mMembers[ *cur ].role )
+                        return false;
+                }
+            }
+
+            if( !sameSquad )
+            {
+                _Unplace( characterID, member );
+                squad->second.members.push_back( characterID );
+            }
+
+            member.role = role;
+        }
+
+        member.wingID = wingID;
+        member.squadID = squadID;
+    }
+
+    _UpdateSession( characterID, &member );
+    return true;
+}
+
+void FleetManager::RemoveMember( uint32 characterID, bool updateSession )
+{
+    std::tr1::unordered_map<uint32, Member>::iterator res = mMembers.find( characterID );
+    if( res == mMembers.end() )
+        return;
+
+    const uint32 fleetID = res->second.fleetID;
+    _Unplace( characterID, res->second );
+    mMembers.erase( res );
+    ++mStats.leaves;
+
+    if( updateSession )
+        _UpdateSession( characterID, NULL );
+
+    Fleet& fleet = mFleets[ fleetID ];
+    if( 0 == --fleet.memberCount )
+        _DisbandFleet( fleetID );
+}
+
+uint32 FleetManager::GetFleetID( uint32 characterID ) const
+{
+    std::tr1::unordered_map<uint32, Member>::const_iterator res = mMembers.find( characterID );
+    if( res == mMembers.end() )
+        return 0;
+
+    return res->second.fleetID;
+}
+
+size_t FleetManager::GetFleetSize( uint32 fleetID ) const
+{
+    std::tr1::unordered_map<uint32, Fleet>::const_iterator res = mFleets.find( fleetID );
+    if( res == mFleets.end() )
+        return 0;
+
+    return res->second.memberCount;
+}
+
+size_t FleetManager::Broadcast( uint32 senderID, FleetScope scope, const std::string& name, uint32 itemID )
+{
+    std::tr1::unordered_map<uint32, Member>::const_iterator res = mMembers.find( senderID );
+    if( res == mMembers.end() )
+        return 0;
+
+    std::vector<uint32> members;
+    _GetScope( res->second, scope, members );
+
+    std::vector<Client*> clients;
+    clients.reserve( members.size() );
+
+    std::vector<uint32>::const_iterator cur, end;
+    cur = members.begin();
+    end = members.end();
+    for(; cur != end; ++cur )
+    {
+        Client* client = sEntityList.FindCharacter( *cur );
+        if( NULL != client )
+            clients.push_back( client );
+    }
+
+    if( clients.empty() )
+        return 0;
+
+    Client* sender = sEntityList.FindCharacter( senderID );
+
+    // encoded once, shared by all the recipients
+    PyTuple* payload = new PyTuple( 5 );
+    payload->SetItem( 0, new PyString( name ) );
+    payload->SetItem( 1, new PyInt( scope ) );
+    payload->SetItem( 2, new PyInt( senderID ) );
+    payload->SetItem( 3, new PyInt( NULL == sender ? 0 : sender->GetSystemID() ) );
+    payload->SetItem( 4, new PyInt( itemID ) );
+
+    sEntityList.Multicast( clients, "OnFleetBroadcast", "charid", &payload, false );
+
+    ++mStats.broadcasts;
+    mStats.broadcastRecipients += (uint32)clients.size();
+    return clients.size();
+}
+
+bool FleetManager::WarpFleet( uint32 commanderID, FleetScope scope, const GPoint& to, double distance )
+{
+    if( mMembers.find( commanderID ) == mMembers.end() )
+        return false;
+
+    PendingWarp warp;
+    warp.commanderID = commanderID;
+    warp.scope = scope;
+    warp.to = to;
+    warp.distance = distance;
+
+    mWarps.push_back( warp );
+    return true;
+}
+
+void FleetManager::_GetScope( const Member& member, FleetScope scope, std::vector<uint32>& into ) const
+{
+    switch( scope )
+    {
+        case SCOPE_SQUAD:
+        {
+            if( 0 != member.squadID )
+            {
+                _GetSquad( member.squadID, into );
+                break;
+            }
+            // commanders have no squad; their scope starts at their wing
+        }
+        case SCOPE_WING:
+        {
+            if( 0 != member.wingID )
+            {
+                _GetWing( member.wingID, into );
+                break;
+            }
+        }
+        case SCOPE_FLEET:
+        {
+            std::tr1::unordered_map<uint32, Fleet>::const_iterator res = mFleets.find( member.fleetID );
+            if( res == mFleets.end() )
+                break;
+
+            if( 0 != res->second.commanderID )
+                into.push_back( res->second.commanderID );
+
+            std::vector<uint32>::const_iterator cur, end;
+            cur = res->second.wings.begin();
+            end = res->second.wings.end();
+            for(; cur != end; ++cur )
+                _GetWing( *cur, into );
+        } break;
+    }
+}
+
+void FleetManager::_GetSquad( uint32 squadID, std::vector<uint32>& into ) const
+{
+    std::tr1::unordered_map<uint32, Squad>::const_iterator res = mSquads.find( squadID );
+    if( res == mSquads.end() )
+        return;
+
+    into.insert( into.end(), res->second.members.begin(), res->second.members.end() );
+}
+
+void FleetManager::_GetWing( uint32 wingID, std::vector<uint32>& into ) const
+{
+    std::tr1::unordered_map<uint32, Wing>::const_iterator res = mWings.find( wingID );
+    if( res == mWings.end() )
+        return;
+
+    if( 0 != res->second.commanderID )
+        into.push_back( res->second.commanderID );
+
+    std::vector<uint32>::const_iterator cur, end;
+    cur = res->second.squads.begin();
+    end = res->second.squads.end();
+    for(; cur != end; ++cur )
+        _GetSquad( *cur, into );
+}
+
+void FleetManager::_Unplace( uint32 characterID, const Member& member )
+{
+    if( 0 == member.wingID )
+    {
+        mFleets[ member.fleetID ].commanderID = 0;
+    }
+    else if( 0 == member.squadID )
+    {
+        mWings[ member.wingID ].commanderID = 0;
+    }
+    else
+    {
+        std::vector<uint32>& members = mSquads[ member.squadID ].members;
+        members.erase( std::find( members.begin(), members.end(), characterID ) );
+    }
+}
+
+void FleetManager::_UpdateSession( uint32 characterID, const Member* member )
+{
+    Client* client = sEntityList.FindCharacter( characterID );
+    if( NULL == client )
+        return;
+
+    if( NULL == member )
+        client->UpdateFleetSession( 0, 0, 0, ROLE_NONE );
+    else
+        client->UpdateFleetSession( member->fleetID, member->wingID, member->squadID, member->role );
+}
+
+void FleetManager::_DisbandFleet( uint32 fleetID )
+{
+    std::tr1::unordered_map<uint32, Fleet>::iterator res = mFleets.find( fleetID );
+    if( res == mFleets.end() )
+        return;
+
+    std::vector<uint32>::const_iterator curw, endw;
+    curw = res->second.wings.begin();
+    endw = res->second.wings.end();
+    for(; curw != endw; ++curw )
+    {
+        const Wing& wing = mWings[ *curw ];
+
+        std::vector<uint32>::const_iterator curs, ends;
+        curs = wing.squads.begin();
+        ends = wing.squads.end();
+        for(; curs != ends; ++curs )
+            mSquads.erase( *curs );
+
+        mWings.erase( *curw );
+    }
+
+    mFleets.erase( res );
+}
@@ -48,7 +48,6 @@ FleetProxyService::~FleetProxyService()
 
 PyResult FleetProxyService::Handle_GetAvailableFleets(PyCallArgs &call) {
 
-    sLog.Debug("Server", "Called GetAvailableFleets Stub.");
-
-    return NULL;
+    // fleets are not advertised; members join by invitation
+    return new PyDict;
 }
@@ -27,6 +27,7 @@
 
 #include "PyBoundObject.h"
 #include "PyServiceCD.h"
+#include "market/EconomyCache.h"
 #include "ship/InsuranceService.h"
 
 class InsuranceBound
@@ -85,19 +86,31 @@ PyBoundObject* InsuranceService::_CreateBoundObject( Client* c, const PyRep* bin
 
 PyResult InsuranceService::Handle_GetInsurancePrice( PyCallArgs& call )
 {
-    sLog.Debug("InsuranceService", "Called GetInsurancePrice stub" );
-    return new PyFloat(0.0);
+    Call_SingleIntegerArg arg;
+    if( !arg.Decode( &call.tuple ) )
+    {
+        _log( SERVICE__ERROR, "%s: Failed to decode arguments.", call.client->GetName() );
+        return NULL;
+    }
+
+    return new PyFloat( sEconomyCache.GetInsurancePrice( arg.arg ) );
 }
 
 PyResult InsuranceBound::Handle_GetInsurancePrice( PyCallArgs& call )
 {
-    sLog.Debug("InsuranceBound", "Called GetInsurancePrice stub" );
-    return new PyFloat(0.0);
+    Call_SingleIntegerArg arg;
+    if( !arg.Decode( &call.tuple ) )
+    {
+        _log( SERVICE__ERROR, "%s: Failed to decode arguments.", call.client->GetName() );
+        return NULL;
+    }
+
+    return new PyFloat( sEconomyCache.GetInsurancePrice( arg.arg ) );
 }
 
 PyResult InsuranceService::Handle_GetContractForShip( PyCallArgs& call )
 {
-    sLog.Debug( "InsuranceService", "Called GetContractForShip stub." );
+    _debug( "InsuranceService", "Called GetContractForShip stub." );
 
     return new PyNone;
 }
@@ -434,7 +434,7 @@ void ModuleContainer::_processEx(processType p, slotType t)
     case typeOfflineAll:
         for(r = 0; r < COUNT; r++, cur++)
         {
-            if(cur == NULL)
+            if(*cur == NULL)
                 continue;
 
             (*cur)->Offline();
@@ -650,13 +650,6 @@ ModuleManager::ModuleManager(Ship *const ship)
         if( !(itemRef == NULL) )
             _fitModule( itemRef, (EVEItemFlags)flagIndex );
     }
-
-    //modifier maps, we own these
-    m_LocalSubsystemModifierMaps = new ModifierMaps;
-    m_LocalShipSkillModifierMaps = new ModifierMaps;
-    m_LocalModuleRigModifierMaps = new ModifierMaps;
-    m_LocalImplantModifierMaps = new ModifierMaps;
-    m_RemoteModifierMaps = new ModifierMaps;
 }
 
 ModuleManager::~ModuleManager()
@@ -664,18 +657,6 @@ ModuleManager::~ModuleManager()
     //module cleanup is handled in the ModuleContainer destructor
     delete m_Modules;
     m_Modules = NULL;
-
-    //modifier map cleanup is handled in the std::map destructor
-    delete m_LocalSubsystemModifierMaps;
-    delete m_LocalShipSkillModifierMaps;
-    delete m_LocalModuleRigModifierMaps;
-    delete m_LocalImplantModifierMaps;
-    delete m_RemoteModifierMaps;
-    m_LocalSubsystemModifierMaps = NULL;
-    m_LocalShipSkillModifierMaps = NULL;
-    m_LocalModuleRigModifierMaps = NULL;
-    m_LocalImplantModifierMaps = NULL;
-    m_RemoteModifierMaps = NULL;
 }
 
 bool ModuleManager::IsSlotOccupied(uint32 flag)
@@ -721,7 +702,7 @@ bool ModuleManager::InstallRig(InventoryItemRef item, EVEItemFlags flag)
         return true;
     }
     else
-        sLog.Debug("ModuleManager","%s tried to fit item %u, which is not a rig", m_Ship->GetOperator()->GetName(), item->itemID());
+        _debug("ModuleManager","%s tried to fit item %u, which is not a rig", m_Ship->GetOperator()->GetName(), item->itemID());
 
     return false;
 }
@@ -741,7 +722,7 @@ bool ModuleManager::SwapSubSystem(InventoryItemRef item, EVEItemFlags flag)
         return true;
     }
     else
-        sLog.Debug("ModuleManager","%s tried to fit item %u, which is not a subsystem", m_Ship->GetOperator()->GetName(), item->itemID());
+        _debug("ModuleManager","%s tried to fit item %u, which is not a subsystem", m_Ship->GetOperator()->GetName(), item->itemID());
 
     return false;
 }
@@ -759,7 +740,7 @@ bool ModuleManager::FitModule(InventoryItemRef item, EVEItemFlags flag)
         }
     }
     else
-        sLog.Debug("ModuleManager","%s tried to fit item %u, which is not a module", m_Ship->GetOperator()->GetName(), item->itemID());
+        _debug("ModuleManager","%s tried to fit item %u, which is not a module", m_Ship->GetOperator()->GetName(), item->itemID());
 
     return false;
 }
@@ -770,6 +751,9 @@ void ModuleManager::UnfitModule(uint32 itemID)
     if( mod != NULL )
     {
         mod->Offline();
+        m_Modifiers.RemoveItem(itemID);
+        _UpdateModifiedAttributes();
+
         m_Modules->RemoveModule(itemID);
     }
 }
@@ -829,24 +813,38 @@ void ModuleManager::Online(uint32 itemID)
 {
     GenericModule * mod = m_Modules->GetModule(itemID);
     if( mod != NULL )
+    {
         mod->Online();
+        if( mod->isOnline() )
+            _ApplyEffects(mod, EFFECT_ONLINE);
+        _UpdateModifiedAttributes();
+    }
 }
 
 void ModuleManager::OnlineAll()
 {
     m_Modules->OnlineAll();
+    _ApplyAllOnlineEffects(true);
+    _UpdateModifiedAttributes();
 }
 
 void ModuleManager::Offline(uint32 itemID)
 {
     GenericModule * mod = m_Modules->GetModule(itemID);
     if( mod != NULL )
+    {
         mod->Offline();
+        _RemoveEffects(mod, EFFECT_OVERLOAD);
+        _RemoveEffects(mod, EFFECT_ONLINE);
+        _UpdateModifiedAttributes();
+    }
 }
 
 void ModuleManager::OfflineAll()
 {
     m_Modules->OfflineAll();
+    _ApplyAllOnlineEffects(false);
+    _UpdateModifiedAttributes();
 }
 
 int32 ModuleManager::Activate(uint32 itemID, std::string effectName, uint32 targetID, uint32 repeat)
@@ -858,7 +856,10 @@ int32 ModuleManager::Activate(uint32 itemID, std::string effectName, uint32 targ
     if( mod != NULL )
     {
         ModuleCommand cmd = _translateEffectName(effectName);
-        mod->getItem()->PutOnline();
+        if(cmd == ONLINE)
+            mod->getItem()->PutOnline();
+        else
+            mod->Activate(targetID);    // the effect name is the module's own; cycles on its own timer from here on
         //if(cmd == ONLINE)
         //    mod->Online();     // this currently fails since m_selectedEffect and m_defaultEffect in the ModuleEffect class are undefined
         //there needs to be more cases here i just don't know what they're called yet
@@ -873,7 +874,10 @@ void ModuleManager::Deactivate(uint32 itemID, std::string effectName)
     if( mod != NULL )
     {
         ModuleCommand cmd = _translateEffectName(effectName);
-        mod->getItem()->PutOffline();
+        if(cmd == ONLINE || cmd == OFFLINE)
+            mod->getItem()->PutOffline();
+        else
+            mod->Deactivate();          // stops at the end of the running cycle
         //if(cmd == OFFLINE)
         //    mod->Offline();     // this currently fails since m_selectedEffect and m_defaultEffect in the ModuleEffect class are undefined
         //there needs to be more cases here i just don't know what they're called yet
@@ -891,6 +895,9 @@ void ModuleManager::Overload(uint32 itemID)
     if( mod != NULL )
     {
         mod->Overload();
+        if( mod->GetModuleState() == MOD_OVERLOADED )
+            _ApplyEffects(mod, EFFECT_OVERLOAD);
+        _UpdateModifiedAttributes();
     }
 }
 
@@ -900,6 +907,8 @@ void ModuleManager::DeOverload(uint32 itemID)
     if( mod != NULL )
     {
         mod->DeOverload();
+        _RemoveEffects(mod, EFFECT_OVERLOAD);
+        _UpdateModifiedAttributes();
     }
 }
 
@@ -923,7 +932,7 @@ void ModuleManager::RepairModule(uint32 itemID)
 
 void ModuleManager::ReplaceCharges()
 {
-    sLog.Debug("ReplaceCharges","Needs to be implemented");
+    _debug("ReplaceCharges","Needs to be implemented");
 }
 
 void ModuleManager::UnloadAllModules()
@@ -933,21 +942,21 @@ void ModuleManager::UnloadAllModules()
 
 void ModuleManager::CharacterLeavingShip()
 {
-    sLog.Debug("CharacterLeavingShip","Needs to be implemented");
+    _debug("CharacterLeavingShip","Needs to be implemented");
     //this is complicated and im gonna leave it alone for now until
     //a few things become more clear
 }
 
 void ModuleManager::CharacterBoardingShip()
 {
-    sLog.Debug("CharacterBoardingShip","Needs to be implemented");
+    _debug("CharacterBoardingShip","Needs to be implemented");
     //this is complicated and im gonna leave it alone for now until
     //a few things become more clear
 }
 
 void ModuleManager::ShipWarping()
 {
-    sLog.Debug("ShipWarping","Needs to be implemented");
+    _debug("ShipWarping","Needs to be implemented");
     //need to remove targets and such
 }
 
@@ -961,7 +970,9 @@ void ModuleManager::ShipJumping()
 
 void ModuleManager::Process()
 {
-    m_Modules->Process();
+    // active modules cycle on their own timers, so there is nothing to
+    // walk the slots for; just flush whatever the cycling modules changed
+    _UpdateModifiedAttributes();
 }
 
 void ModuleManager::ProcessExternalEffect(Effect * e)
@@ -1031,232 +1042,240 @@ void ModuleManager::SaveModules()
 
 int32 ModuleManager::ApplyRemoteEffect(uint32 attributeID, uint32 originatorID, SystemEntity * systemEntity, ModifierRef modifierRef)
 {
-    //
-
-    return 1;
+    return _ApplyModifier(attributeID, originatorID, modifierRef);
 }
 
 int32 ModuleManager::RemoveRemoteEffect(uint32 attributeID, uint32 originatorID, ModifierRef modifierRef)
 {
-    //
-
-    return 1;
+    return _RemoveModifier(attributeID, originatorID, modifierRef);
 }
 
 int32 ModuleManager::ApplySubsystemEffect(uint32 attributeID, uint32 originatorID, ModifierRef modifierRef)
 {
-    ModifierMap * modMap = NULL;
+    return _ApplyModifier(attributeID, originatorID, modifierRef);
+}
 
-    // Make sure the ModifierRef passed in is not NULL:
-    if(modifierRef.get() == NULL)
-        return -1;
+int32 ModuleManager::RemoveSubsystemEffect(uint32 attributeID, uint32 originatorID, ModifierRef modifierRef)
+{
+    return _RemoveModifier(attributeID, originatorID, modifierRef);
+}
 
-    // Check to see if this attributeID does not have a ModifierMap in the Map of ModifierMaps
-    if( m_LocalSubsystemModifierMaps->find(attributeID) == m_LocalSubsystemModifierMaps->end() )
-    {
-        // A Modifier Map for this attributeID does not exist, create a new one:
-        modMap = new ModifierMap();
-        if(modMap == NULL)
-            return -1;
-    }
-    else
-    {
-        // A Modifier Map for this attributeID already exists, find it and get its pointer:
-        modMap = m_LocalSubsystemModifierMaps->find(attributeID)->second;
-    }
+int32 ModuleManager::ApplyShipSkillEffect(uint32 attributeID, uint32 originatorID, ModifierRef modifierRef)
+{
+    return _ApplyModifier(attributeID, originatorID, modifierRef);
+}
 
-    // Check to see if the modifier map has any entries corresponding to the passed-in modifier's value:
-    if( modMap->m_ModifierMap.find(modifierRef->GetModifierValue()) != modMap->m_ModifierMap.end() )
-    {
-        // Modifier entry in this attributeID's Modifier Map already exists (modifierRef->GetModifierValue() found a match),
-        // so check its originatorID and if that matches, DO NOT add this Modifier object to the map as the reference
-        // already exists, the Module class can modify the contents of the Modifier object without really calling this function,
-        // however, to maintain consistent code, the Module classes will always call this function to notify the map class
-        // that the contents of the map was changed, or made 'dirty':
-        modMap->m_MapIsDirty = true;
-        ModifierMapType::iterator cur;
-        std::pair<ModifierMapType::iterator,ModifierMapType::iterator> range;
-        range = modMap->m_ModifierMap.equal_range(modifierRef->GetModifierValue());   // Get the one or more modifier map entries matching this modifier being added
-        for (cur=range.first; cur!=range.second; ++cur)
-            if( cur->second->GetOriginatorID() == originatorID )
-                return 1;   // Yep, we found the Modifier owned by this originatorID, so we return "success" because the Module
-                            // class object already updated this Modifier through its own ModifierRef, we don't need to do anything
-                            // else here except return and prevent ADDING to the ModifierMap
-
-        // For loop searching existing modifiers completed, so this originatorID's Modifier
-        // is NOT in the map yet... Let's add it:
-        modMap->m_ModifierMap.insert(std::pair<double, ModifierRef>(modifierRef->GetModifierValue(), modifierRef));
-    }
-    else
-    {
-        // Modifier entry in this attributeID's Modifier Map does not exist yet, so lets insert it for the first time:
-        // Insert the (modifierValue, ModifierRef) pair into the Modifier Map for this attributeID:
-        modMap->m_ModifierMap.insert(std::pair<double, ModifierRef>(modifierRef->GetModifierValue(), modifierRef));
-        modMap->m_MapIsDirty = true;
-        m_LocalSubsystemModifierMaps->insert(std::pair<uint32, ModifierMap *>(attributeID, modMap));
-    }
+int32 ModuleManager::RemoveShipSkillEffect(uint32 attributeID, uint32 originatorID, ModifierRef modifierRef)
+{
+    return _RemoveModifier(attributeID, originatorID, modifierRef);
+}
 
-    return 1;
+int32 ModuleManager::ApplyModuleRigEffect(uint32 attributeID, uint32 originatorID, ModifierRef modifierRef)
+{
+    return _ApplyModifier(attributeID, originatorID, modifierRef);
 }
 
-int32 ModuleManager::RemoveSubsystemEffect(uint32 attributeID, uint32 originatorID, ModifierRef modifierRef)
+int32 ModuleManager::RemoveModuleRigEffect(uint32 attributeID, uint32 originatorID, ModifierRef modifierRef)
 {
-    bool bModifierFound = false;
-    ModifierMap * modMap = NULL;
+    return _RemoveModifier(attributeID, originatorID, modifierRef);
+}
 
-    if( m_LocalSubsystemModifierMaps->find(attributeID) != m_LocalSubsystemModifierMaps->end() )
-    {
-        modMap = m_LocalSubsystemModifierMaps->find(attributeID)->second;
-        modMap->m_MapIsDirty = true;
-        
-        if( modMap->m_ModifierMap.find(modifierRef->GetModifierValue()) != modMap->m_ModifierMap.end() )
-        {
-            modMap->m_MapIsDirty = true;
-            ModifierMapType::iterator cur;
-            std::pair<ModifierMapType::iterator,ModifierMapType::iterator> range;
-            range = modMap->m_ModifierMap.equal_range(modifierRef->GetModifierValue());   // Get the one or more modifier map entries matching this modifier being removed
-            for (cur=range.first; cur!=range.second; ++cur)
-                if( cur->second->GetOriginatorID() == originatorID )
-                {
-                    bModifierFound = true;  // Yep, we found the Modifier owned by this originatorID, so we break out of the for()
-                                            // so we can now remove this exact Modifier object from the multimap
-                    break;
-                }
+int32 ModuleManager::ApplyImplantEffect(uint32 attributeID, uint32 originatorID, ModifierRef modifierRef)
+{
+    return _ApplyModifier(attributeID, originatorID, modifierRef);
+}
 
-            if( bModifierFound == true )
-            {
-                // For loop searching existing modifiers completed, so this originatorID's Modifier
-                // was found in the map
-                modMap->m_ModifierMap.insert(std::pair<double, ModifierRef>(modifierRef->GetModifierValue(), modifierRef));
-            }
-            else
-                return -1;  // This modifier's originatorID was not found in the map, so return error code
-        }
-        else
-            return -1;  // This modifier's modifier value was not even found in the map, so return error code
+int32 ModuleManager::RemoveImplantEffect(uint32 attributeID, uint32 originatorID, ModifierRef modifierRef)
+{
+    return _RemoveModifier(attributeID, originatorID, modifierRef);
+}
+
+// Translates the calculation type of a Modifier into the graph operation doing the same, so removing
+// the modifier later needs no reverse calculation
+static bool GetModifierOperation(uint32 calcTypeID, double & value, ModifierGraph::Operation & operation)
+{
+    switch(calcTypeID)
+    {
+        case CALC_ADD :                         operation = ModifierGraph::OP_ADD;                                          return true;
+        case CALC_SUBTRACT :                    operation = ModifierGraph::OP_SUBTRACT;                                     return true;
+        case CALC_MULTIPLY :                    operation = ModifierGraph::OP_POST_MULTIPLY;                                return true;
+        case CALC_DIVIDE :                      operation = ModifierGraph::OP_POST_DIVIDE;                                  return true;
+        case CALC_ADD_PERCENT :                 operation = ModifierGraph::OP_POST_MULTIPLY;    value = 1.0 + value;        return true;
+        case CALC_REV_ADD_PERCENT :             operation = ModifierGraph::OP_POST_DIVIDE;      value = 1.0 + value;        return true;
+        case CALC_SUBTRACT_PERCENT :            operation = ModifierGraph::OP_POST_MULTIPLY;    value = 1.0 - value;        return true;
+        case CALC_REV_SUBTRACT_PERCENT :        operation = ModifierGraph::OP_POST_DIVIDE;      value = 1.0 - value;        return true;
+        case CALC_ADD_AS_PERCENT :              operation = ModifierGraph::OP_POST_PERCENT;                                 return true;
+        case CALC_SUBTRACT_AS_PERCENT :         operation = ModifierGraph::OP_POST_DIVIDE;      value = 1.0 + value / 100.0; return true;
+        case CALC_MODIFY_PERCENT_W_PERCENT :    operation = ModifierGraph::OP_POST_PERCENT;                                 return true;
     }
-    else
-        return -1;  // Modifier Map for supplied attributeID does not exist, return error value
 
-    return 1;
+    // CALC_NONE, CALC_AUTO and the rest do not modify anything yet
+    return false;
 }
 
-int32 ModuleManager::ApplyShipSkillEffect(uint32 attributeID, uint32 originatorID, ModifierRef modifierRef)
+int32 ModuleManager::_ApplyModifier(uint32 attributeID, uint32 originatorID, ModifierRef modifierRef)
 {
-    ModifierMap * modMap = NULL;
-
     // Make sure the ModifierRef passed in is not NULL:
     if(modifierRef.get() == NULL)
         return -1;
 
-    // Check to see if this attributeID does not have a ModifierMap in the Map of ModifierMaps
-    if( m_LocalShipSkillModifierMaps->find(attributeID) == m_LocalShipSkillModifierMaps->end() )
-    {
-        // A Modifier Map for this attributeID does not exist, create a new one:
-        modMap = new ModifierMap();
-        if(modMap == NULL)
-            return -1;
-    }
-    else
-    {
-        // A Modifier Map for this attributeID already exists, find it and get its pointer:
-        modMap = m_LocalShipSkillModifierMaps->find(attributeID)->second;
-    }
+    ModifierGraph::Modifier modifier;
+    modifier.sourceItemID = originatorID;
+    modifier.sourceAttributeID = 0;
+    modifier.value = modifierRef->GetModifierValue();
+    modifier.effectID = 0;
+    modifier.targetItemID = (modifierRef->GetTargetID() == 0) ? m_Ship->itemID() : modifierRef->GetTargetID();
+    modifier.targetAttributeID = attributeID;
+    modifier.penalized = modifierRef->GetPenaltiesApply();
+    if( !GetModifierOperation(modifierRef->GetCalculationTypeID(), modifier.value, modifier.operation) )
+        return -1;
 
-    // Check to see if the modifier map has any entries corresponding to the passed-in modifier's value:
-    if( modMap->m_ModifierMap.find(modifierRef->GetModifierValue()) != modMap->m_ModifierMap.end() )
-    {
-        // Modifier entry in this attributeID's Modifier Map already exists (modifierRef->GetModifierValue() found a match),
-        // so check its originatorID and if that matches, DO NOT add this Modifier object to the map as the reference
-        // already exists, the Module class can modify the contents of the Modifier object without really calling this function,
-        // however, to maintain consistent code, the Module classes will always call this function to notify the map class
-        // that the contents of the map was changed, or made 'dirty':
-        modMap->m_MapIsDirty = true;
-        ModifierMapType::iterator cur;
-        std::pair<ModifierMapType::iterator,ModifierMapType::iterator> range;
-        range = modMap->m_ModifierMap.equal_range(modifierRef->GetModifierValue());   // Get the one or more modifier map entries matching this modifier being added
-        for (cur=range.first; cur!=range.second; ++cur)
-            if( cur->second->GetOriginatorID() == originatorID )
-                return 1;   // Yep, we found the Modifier owned by this originatorID, so we return "success" because the Module
-                            // class object already updated this Modifier through its own ModifierRef, we don't need to do anything
-                            // else here except return and prevent ADDING to the ModifierMap
-
-        // For loop searching existing modifiers completed, so this originatorID's Modifier
-        // is NOT in the map yet... Let's add it:
-        modMap->m_ModifierMap.insert(std::pair<double, ModifierRef>(modifierRef->GetModifierValue(), modifierRef));
-    }
-    else
-    {
-        // Modifier entry in this attributeID's Modifier Map does not exist yet, so lets insert it for the first time:
-        // Insert the (modifierValue, ModifierRef) pair into the Modifier Map for this attributeID:
-        modMap->m_ModifierMap.insert(std::pair<double, ModifierRef>(modifierRef->GetModifierValue(), modifierRef));
-        modMap->m_MapIsDirty = true;
-        m_LocalShipSkillModifierMaps->insert(std::pair<uint32, ModifierMap *>(attributeID, modMap));
-    }
+    InventoryItem * target = _GetModifierTarget(modifier.targetItemID);
+    if( target == NULL )
+        return -1;
 
+    // The first modifier of this attribute, so the graph needs to know the value it starts from:
+    if( !m_Modifiers.HasAttribute(modifier.targetItemID, attributeID) )
+        m_Modifiers.SetBaseValue(modifier.targetItemID, attributeID, target->GetDefaultAttribute(attributeID).get_float());
+
+    // Adding it again only updates the value, so the Module classes can always call this
+    // to notify us that the contents of the Modifier object were changed:
+    m_Modifiers.AddModifier(modifier);
     return 1;
 }
 
-int32 ModuleManager::RemoveShipSkillEffect(uint32 attributeID, uint32 originatorID, ModifierRef modifierRef)
+int32 ModuleManager::_RemoveModifier(uint32 attributeID, uint32 originatorID, ModifierRef modifierRef)
 {
-    bool bModifierFound = false;
-    ModifierMap * modMap = NULL;
+    if(modifierRef.get() == NULL)
+        return -1;
 
-    if( m_LocalShipSkillModifierMaps->find(attributeID) != m_LocalShipSkillModifierMaps->end() )
-    {
-        modMap = m_LocalShipSkillModifierMaps->find(attributeID)->second;
-        modMap->m_MapIsDirty = true;
-        
-        if( modMap->m_ModifierMap.find(modifierRef->GetModifierValue()) != modMap->m_ModifierMap.end() )
-        {
-            modMap->m_MapIsDirty = true;
-            ModifierMapType::iterator cur;
-            std::pair<ModifierMapType::iterator,ModifierMapType::iterator> range;
-            range = modMap->m_ModifierMap.equal_range(modifierRef->GetModifierValue());   // Get the one or more modifier map entries matching this modifier being removed
-            for (cur=range.first; cur!=range.second; ++cur)
-                if( cur->second->GetOriginatorID() == originatorID )
-                {
-                    bModifierFound = true;  // Yep, we found the Modifier owned by this originatorID, so we break out of the for()
-                                            // so we can now remove this exact Modifier object from the multimap
-                    break;
-                }
+    ModifierGraph::Modifier modifier;
+    modifier.sourceItemID = originatorID;
+    modifier.sourceAttributeID = 0;
+    modifier.effectID = 0;
+    modifier.targetItemID = (modifierRef->GetTargetID() == 0) ? m_Ship->itemID() : modifierRef->GetTargetID();
+    modifier.targetAttributeID = attributeID;
 
-            if( bModifierFound == true )
-            {
-                // For loop searching existing modifiers completed, so this originatorID's Modifier
-                // was found in the map
-                modMap->m_ModifierMap.insert(std::pair<double, ModifierRef>(modifierRef->GetModifierValue(), modifierRef));
-            }
-            else
-                return -1;  // This modifier's originatorID was not found in the map, so return error code
-        }
-        else
-            return -1;  // This modifier's modifier value was not even found in the map, so return error code
-    }
-    else
-        return -1;  // Modifier Map for supplied attributeID does not exist, return error value
+    if( !m_Modifiers.RemoveModifier(modifier) )
+        return -1;  // This originatorID has no such modifier, so return error code
 
     return 1;
 }
 
-int32 ModuleManager::ApplyModuleRigEffect(uint32 attributeID, uint32 originatorID, ModifierRef modifierRef)
+InventoryItem * ModuleManager::_GetModifierTarget(uint32 itemID)
 {
-    return 1;
+    if( itemID == m_Ship->itemID() )
+        return m_Ship;
+
+    GenericModule * mod = m_Modules->GetModule(itemID);
+    if( mod == NULL )
+        return NULL;
+
+    return mod->getItem().get();
 }
 
-int32 ModuleManager::RemoveModuleRigEffect(uint32 attributeID, uint32 originatorID, ModifierRef modifierRef)
+void ModuleManager::_ApplyEffects(GenericModule * mod, ModuleEffectTriggers state)
 {
-    return 1;
+    const EffectProgram & program = mod->GetTypeEffects()->GetProgram(state);
+
+    EffectProgram::const_iterator cur, end;
+    cur = program.begin();
+    end = program.end();
+    for(; cur != end; ++cur)
+    {
+        if( cur->operation == EFFECT_OPERATION_NONE )
+            continue;
+
+        ModifierGraph::Modifier modifier;
+        modifier.sourceItemID = mod->itemID();
+        modifier.sourceAttributeID = cur->sourceAttributeID;
+        modifier.value = 0.0;
+        modifier.effectID = cur->effectID;
+        modifier.targetAttributeID = cur->targetAttributeID;
+        modifier.operation = (ModifierGraph::Operation)cur->operation;
+        modifier.penalized = (cur->penalized != 0);
+
+        switch( EFFECT_TARGET_SELF + cur->target )
+        {
+            case EFFECT_TARGET_SELF:    modifier.targetItemID = mod->itemID();      break;
+            case EFFECT_TARGET_SHIP:    modifier.targetItemID = m_Ship->itemID();   break;
+            default:                    continue;   // external targets get theirs through ApplyRemoteEffect()
+        }
+
+        InventoryItem * target = _GetModifierTarget(modifier.targetItemID);
+        if( target == NULL )
+            continue;
+
+        // The first modifier from or to these attributes, so the graph needs to know the values they start from:
+        if( !m_Modifiers.HasAttribute(modifier.sourceItemID, modifier.sourceAttributeID) )
+            m_Modifiers.SetBaseValue(modifier.sourceItemID, modifier.sourceAttributeID, mod->getItem()->GetDefaultAttribute(modifier.sourceAttributeID).get_float());
+        if( !m_Modifiers.HasAttribute(modifier.targetItemID, modifier.targetAttributeID) )
+            m_Modifiers.SetBaseValue(modifier.targetItemID, modifier.targetAttributeID, target->GetDefaultAttribute(modifier.targetAttributeID).get_float());
+
+        m_Modifiers.AddModifier(modifier);
+    }
 }
 
-int32 ModuleManager::ApplyImplantEffect(uint32 attributeID, uint32 originatorID, ModifierRef modifierRef)
+void ModuleManager::_RemoveEffects(GenericModule * mod, ModuleEffectTriggers state)
 {
-    return 1;
+    const std::vector<MEffect *> & effects = mod->GetTypeEffects()->GetEffects(state);
+
+    std::vector<MEffect *>::const_iterator cur, end;
+    cur = effects.begin();
+    end = effects.end();
+    for(; cur != end; ++cur)
+        m_Modifiers.RemoveModifiers(mod->itemID(), (*cur)->GetEffectID());
 }
 
-int32 ModuleManager::RemoveImplantEffect(uint32 attributeID, uint32 originatorID, ModifierRef modifierRef)
+void ModuleManager::_ApplyAllOnlineEffects(bool apply)
 {
-    return 1;
+    // the low, medium and high slots, like ModuleContainer::OnlineAll()
+    for(uint32 flagIndex = flagLowSlot0; flagIndex <= flagHiSlot7; flagIndex++)
+    {
+        GenericModule * mod = m_Modules->GetModule((EVEItemFlags)flagIndex);
+        if( mod == NULL )
+            continue;
+
+        // removing what is not there does nothing, so nothing is applied twice:
+        _RemoveEffects(mod, EFFECT_OVERLOAD);
+        _RemoveEffects(mod, EFFECT_ONLINE);
+        if( apply && mod->isOnline() )
+            _ApplyEffects(mod, EFFECT_ONLINE);
+    }
+}
+
+void ModuleManager::_UpdateModifiedAttributes()
+{
+    std::vector<ModifierGraph::Change> changes;
+    m_Modifiers.Update(changes);
+
+    bool rechargeChanged = false;
+    std::vector<ModifierGraph::Change>::const_iterator cur, end;
+    cur = changes.begin();
+    end = changes.end();
+    for(; cur != end; ++cur)
+    {
+        InventoryItem * target = _GetModifierTarget(cur->itemID);
+        if( target != NULL )
+            target->SetAttribute(cur->attributeID, EvilNumber(cur->value));
+
+        if( cur->itemID == m_Ship->itemID() )
+        {
+            switch( cur->attributeID )
+            {
+                case AttrCapacitorCapacity:
+                case AttrRechargeRate:
+                case AttrShieldCapacity:
+                case AttrShieldRechargeRate:
+                    rechargeChanged = true;
+                    break;
+            }
+        }
+    }
+
+    // the charges recharge from their current level towards the new limits
+    if( rechargeChanged )
+        m_Ship->UpdateRecharge();
 }
 
 void ModuleManager::_processExternalEffect(SubEffect * s)
@@ -26,6 +26,8 @@
 #include "eve-server.h"
 
 #include "PyServiceCD.h"
+#include "inventory/AttributeEnum.h"
+#include "market/EconomyCache.h"
 #include "ship/RepairService.h"
 
 PyCallable_Make_InnerDispatcher(RepairService)
@@ -37,6 +39,7 @@ RepairService::RepairService(PyServiceMgr *mgr)
     _SetCallDispatcher(m_dispatch);
 
     PyCallable_REG_CALL(RepairService, UnasembleItems);
+    PyCallable_REG_CALL(RepairService, GetDamageReports);
 }
 
 RepairService::~RepairService() {
@@ -49,3 +52,46 @@ PyResult RepairService::Handle_UnasembleItems(PyCallArgs &call) {
 
     return NULL;
 }
+
+PyResult RepairService::Handle_GetDamageReports(PyCallArgs &call) {
+    Call_SingleIntList args;
+    if(!args.Decode(&call.tuple)) {
+        codelog(SERVICE__ERROR, "Bad incoming params.");
+        return NULL;
+    }
+
+    PyDict *reports = new PyDict;
+
+    std::vector<int32>::const_iterator cur, end;
+    cur = args.ints.begin();
+    end = args.ints.end();
+    for(; cur != end; cur++) {
+        InventoryItemRef item = m_manager->item_factory.GetItem(*cur);
+        if(!item || item->ownerID() != call.client->GetCharacterID())
+            continue;
+
+        //the unit costs come from the economy cache, only the damage is the item's own.
+        DBRowDescriptor *header = new DBRowDescriptor();
+        header->AddColumn( "itemID",                        DBTYPE_I4 );
+        header->AddColumn( "typeID",                        DBTYPE_I4 );
+        header->AddColumn( "groupID",                       DBTYPE_I4 );
+        header->AddColumn( "damage",                        DBTYPE_R8 );
+        header->AddColumn( "maxHealth",                     DBTYPE_R8 );
+        header->AddColumn( "costToRepairOneUnitOfDamage",   DBTYPE_R8 );
+        CRowSet *quote = new CRowSet( &header );
+
+        PyPackedRow *row = quote->NewRow();
+        row->SetField( (uint32)0, new PyInt( item->itemID() ) );
+        row->SetField( 1, new PyInt( item->typeID() ) );
+        row->SetField( 2, new PyInt( item->groupID() ) );
+        row->SetField( 3, new PyFloat( item->GetAttribute(AttrDamage).get_float() ) );
+        row->SetField( 4, new PyFloat( item->GetAttribute(AttrHp).get_float() ) );
+        row->SetField( 5, new PyFloat( sEconomyCache.GetRepairUnitCost( item->typeID() ) ) );
+
+        PyDict *report = new PyDict;
+        report->SetItemString( "quote", quote );
+        reports->SetItem( new PyInt( item->itemID() ), new PyObject( "util.KeyVal", report ) );
+    }
+
+    return reports;
+}
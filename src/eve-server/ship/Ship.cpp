@@ -87,7 +87,8 @@ Ship::Ship(
     // InventoryItem stuff:
     const ShipType &_shipType,
     const ItemData &_data)
-: InventoryItem(_factory, _shipID, _shipType, _data)
+: InventoryItem(_factory, _shipID, _shipType, _data),
+  m_rechargeTimer(*this)
 {
     m_ModuleManager = NULL;
     m_pOperator = new ShipOperatorInterface();
@@ -118,39 +119,45 @@ ShipRef Ship::Spawn(ItemFactory &factory, ItemData &data) {
 
     ShipRef sShipRef = Ship::Load( factory, shipID );
 
+    sShipRef->SetSpawnAttributes();
+
+    return sShipRef;
+}
+
+void Ship::SetSpawnAttributes()
+{
     // Create default dynamic attributes in the AttributeMap:
-    sShipRef->SetAttribute(AttrIsOnline,            1);                                             // Is Online
-    sShipRef->SetAttribute(AttrShieldCharge,        sShipRef->GetAttribute(AttrShieldCapacity));    // Shield Charge
-    sShipRef->SetAttribute(AttrArmorDamage,         0.0);                                           // Armor Damage
-    sShipRef->SetAttribute(AttrMass,                sShipRef->type().attributes.mass());            // Mass
-    sShipRef->SetAttribute(AttrRadius,              sShipRef->type().attributes.radius());          // Radius
-    sShipRef->SetAttribute(AttrVolume,              sShipRef->type().attributes.volume());          // Volume
-    sShipRef->SetAttribute(AttrCapacity,            sShipRef->type().attributes.capacity());        // Capacity
-    sShipRef->SetAttribute(AttrInertia,             1);                                             // Inertia
-    sShipRef->SetAttribute(AttrCharge,              sShipRef->GetAttribute(AttrCapacitorCapacity)); // Set Capacitor Charge to the Capacitor Capacity
+    SetAttribute(AttrIsOnline,            1);                                       // Is Online
+    SetAttribute(AttrShieldCharge,        GetAttribute(AttrShieldCapacity));        // Shield Charge
+    SetAttribute(AttrArmorDamage,         0.0);                                     // Armor Damage
+    SetAttribute(AttrMass,                type().attributes.mass());                // Mass
+    SetAttribute(AttrRadius,              type().attributes.radius());              // Radius
+    SetAttribute(AttrVolume,              type().attributes.volume());              // Volume
+    SetAttribute(AttrCapacity,            type().attributes.capacity());            // Capacity
+    SetAttribute(AttrInertia,             1);                                       // Inertia
+    SetAttribute(AttrCharge,              GetAttribute(AttrCapacitorCapacity));     // Set Capacitor Charge to the Capacitor Capacity
+    _InitRecharge();
 
     // Check for existence of some attributes that may or may not have already been loaded and set them
     // to default values:
     // Maximum Range Capacitor
-    if( !(sShipRef->HasAttribute(AttrMaximumRangeCap)) )
-        sShipRef->SetAttribute(AttrMaximumRangeCap, 249999.0 );
+    if( !(HasAttribute(AttrMaximumRangeCap)) )
+        SetAttribute(AttrMaximumRangeCap, 249999.0 );
     // Maximum Armor Damage Resonance
-    if( !(sShipRef->HasAttribute(AttrArmorMaxDamageResonance)) )
-        sShipRef->SetAttribute(AttrArmorMaxDamageResonance, 1.0f);
+    if( !(HasAttribute(AttrArmorMaxDamageResonance)) )
+        SetAttribute(AttrArmorMaxDamageResonance, 1.0f);
     // Maximum Shield Damage Resonance
-    if( !(sShipRef->HasAttribute(AttrShieldMaxDamageResonance)) )
-        sShipRef->SetAttribute(AttrShieldMaxDamageResonance, 1.0f);
+    if( !(HasAttribute(AttrShieldMaxDamageResonance)) )
+        SetAttribute(AttrShieldMaxDamageResonance, 1.0f);
     // Warp Speed Multiplier
-    if( !(sShipRef.get()->HasAttribute(AttrWarpSpeedMultiplier)) )
-        sShipRef.get()->SetAttribute(AttrWarpSpeedMultiplier, 1.0f);
+    if( !(HasAttribute(AttrWarpSpeedMultiplier)) )
+        SetAttribute(AttrWarpSpeedMultiplier, 1.0f);
     // CPU Load of the ship (new ships have zero load with no modules fitted, of course):
-    if( !(sShipRef.get()->HasAttribute(AttrCpuLoad)) )
-        sShipRef.get()->SetAttribute(AttrCpuLoad, 0);
+    if( !(HasAttribute(AttrCpuLoad)) )
+        SetAttribute(AttrCpuLoad, 0);
     // Power Load of the ship (new ships have zero load with no modules fitted, of course):
-    if( !(sShipRef.get()->HasAttribute(AttrPowerLoad)) )
-        sShipRef.get()->SetAttribute(AttrPowerLoad, 0);
-
-    return sShipRef;
+    if( !(HasAttribute(AttrPowerLoad)) )
+        SetAttribute(AttrPowerLoad, 0);
 }
 
 uint32 Ship::_Spawn(ItemFactory &factory, ItemData &data) {
@@ -176,6 +183,7 @@ bool Ship::_Load()
         return false;
 
     bool loadSuccess = InventoryItem::_Load();      // Attributes are loaded here!
+    _InitRecharge();
 
     // TODO: MOVE THIS TO Ship::Load() or some other place AFTER InventoryItem::mAttributeMap has been loaded
     // allocate the module manager, only the first time:
@@ -202,7 +210,7 @@ double Ship::GetCapacity(EVEItemFlags flag) const
     switch( flag ) {
         // the .get_float() part is a evil hack.... as this function should return a EvilNumber.
         case flagAutoFit:
-        case flagCargoHold:     return GetAttribute(AttrCapacity).get_float();
+        case flagCargoHold:     return GetAttributeValue(AttrCapacity);
         case flagDroneBay:      return GetAttribute(AttrDroneCapacity).get_float();
         case flagShipHangar:    return GetAttribute(AttrShipMaintenanceBayCapacity).get_float();
         case flagHangar:        return GetAttribute(AttrCorporateHangarCapacity).get_float();
@@ -474,8 +482,9 @@ bool Ship::ValidateBoardShip(ShipRef ship, CharacterRef character)
 
 void Ship::SaveShip()
 {
-    sLog.Debug( "Ship::SaveShip()", "Saving all 'entity' info and attribute info to DB for ship %s (%u)...", itemName().c_str(), itemID() );
+    _debug( "Ship::SaveShip()", "Saving all 'entity' info and attribute info to DB for ship %s (%u)...", itemName().c_str(), itemID() );
 
+    StoreRecharge();                    // Bring the capacitor and shield charges up to date
     SaveItem();                         // Save all attributes and item info
     m_ModuleManager->SaveModules();     // Save all attributes and item info for all modules fitted to this ship
 }
@@ -618,6 +627,99 @@ void Ship::Process()
     m_ModuleManager->Process();
 }
 
+void Ship::_InitRecharge()
+{
+    const uint32 now = sTimerWheel.now();
+
+    const double capacitor = GetAttributeValue(AttrCapacitorCapacity);
+    m_capacitor.Reset(capacitor, GetAttributeValue(AttrRechargeRate),
+                      HasAttribute(AttrCharge) ? GetAttributeValue(AttrCharge) : capacitor, now);
+
+    const double shield = GetAttributeValue(AttrShieldCapacity);
+    m_shield.Reset(shield, GetAttributeValue(AttrShieldRechargeRate),
+                   HasAttribute(AttrShieldCharge) ? GetAttributeValue(AttrShieldCharge) : shield, now);
+
+    _ScheduleRechargeTimer();
+}
+
+double Ship::GetCapacitorCharge() const
+{
+    return m_capacitor.GetValue(sTimerWheel.now());
+}
+
+bool Ship::UseCapacitor(double amount)
+{
+    const uint32 now = sTimerWheel.now();
+    const double charge = m_capacitor.GetValue(now);
+    if( charge < amount )
+        return false;
+
+    m_capacitor.SetValue(charge - amount, now);
+    SetAttribute(AttrCharge, m_capacitor.GetValue(now));
+    _ScheduleRechargeTimer();
+    return true;
+}
+
+uint32 Ship::GetTimeToCapacitor(double amount) const
+{
+    return m_capacitor.GetTimeToReach(amount, sTimerWheel.now());
+}
+
+double Ship::GetShieldCharge() const
+{
+    return m_shield.GetValue(sTimerWheel.now());
+}
+
+void Ship::SetShieldCharge(double charge)
+{
+    const uint32 now = sTimerWheel.now();
+    m_shield.SetValue(charge, now);
+    SetAttribute(AttrShieldCharge, m_shield.GetValue(now));
+    _ScheduleRechargeTimer();
+}
+
+void Ship::UpdateRecharge()
+{
+    const uint32 now = sTimerWheel.now();
+    m_capacitor.SetLimits(GetAttributeValue(AttrCapacitorCapacity), GetAttributeValue(AttrRechargeRate), now);
+    m_shield.SetLimits(GetAttributeValue(AttrShieldCapacity), GetAttributeValue(AttrShieldRechargeRate), now);
+
+    StoreRecharge();
+    _ScheduleRechargeTimer();
+}
+
+void Ship::StoreRecharge()
+{
+    const uint32 now = sTimerWheel.now();
+
+    // snap the full ones, the formula only gets there asymptotically
+    if( m_capacitor.IsFull(now) )
+        m_capacitor.SetValue(m_capacitor.capacity(), now);
+    if( m_shield.IsFull(now) )
+        m_shield.SetValue(m_shield.capacity(), now);
+
+    SetAttribute(AttrCharge, m_capacitor.GetValue(now));
+    SetAttribute(AttrShieldCharge, m_shield.GetValue(now));
+}
+
+void Ship::_RechargeTimerExpired()
+{
+    StoreRecharge();
+    _ScheduleRechargeTimer();
+}
+
+void Ship::_ScheduleRechargeTimer()
+{
+    const uint32 now = sTimerWheel.now();
+    const uint32 delay = std::min(m_capacitor.GetTimeToFull(now), m_shield.GetTimeToFull(now));
+
+    // nothing to wait for once both are full, or if they never recharge
+    if( 0 == delay || 0xFFFFFFFF == delay )
+        sTimerWheel.Cancel(&m_rechargeTimer);
+    else
+        sTimerWheel.Schedule(&m_rechargeTimer, delay);
+}
+
 void Ship::OnlineAll()
 {
     m_ModuleManager->OnlineAll();
@@ -755,11 +857,11 @@ void ShipEntity::EncodeDestiny( Buffer& into ) const
 
 void ShipEntity::MakeDamageState(DoDestinyDamageState &into) const
 {
-    into.shield = (m_self->GetAttribute(AttrShieldCharge).get_float() / m_self->GetAttribute(AttrShieldCapacity).get_float());
+    into.shield = (_GetShieldCharge() / m_self->GetAttributeValue(AttrShieldCapacity));
     into.tau = 100000;    //no freaking clue.
     into.timestamp = Win32TimeNow();
 //    armor damage isn't working...
-    into.armor = 1.0 - (m_self->GetAttribute(AttrArmorDamage).get_float() / m_self->GetAttribute(AttrArmorHP).get_float());
-    into.structure = 1.0 - (m_self->GetAttribute(AttrDamage).get_float() / m_self->GetAttribute(AttrHp).get_float());
+    into.armor = 1.0 - (m_self->GetAttributeValue(AttrArmorDamage) / m_self->GetAttributeValue(AttrArmorHP));
+    into.structure = 1.0 - (m_self->GetAttributeValue(AttrDamage) / m_self->GetAttributeValue(AttrHp));
 }
 
@@ -29,10 +29,10 @@
 #include "ship/Ship.h"
 #include "ship/TargetManager.h"
 #include "system/SystemEntity.h"
-
 TargetManager::TargetManager(SystemEntity *self)
 : m_destroyed(false),
-  m_self(self)
+  m_self(self),
+  m_lockTimer(*this)
 {
 }
 
@@ -55,58 +55,101 @@ void TargetManager::DoDestruction() {
     }
 }
 
-void TargetManager::Process() {
-    //process outgoing targeting
+std::vector<TargetManager::TargetEntry>::iterator TargetManager::_FindTarget(SystemEntity *who) {
+    std::vector<TargetEntry>::iterator cur, end;
+    cur = m_targets.begin();
+    end = m_targets.end();
+    for(; cur != end; cur++) {
+        if(cur->who == who)
+            break;
+    }
+    return(cur);
+}
+
+std::vector<TargetManager::TargetedByEntry>::iterator TargetManager::_FindTargetedBy(SystemEntity *who) {
+    std::vector<TargetedByEntry>::iterator cur, end;
+    cur = m_targetedBy.begin();
+    end = m_targetedBy.end();
+    for(; cur != end; cur++) {
+        if(cur->who == who)
+            break;
+    }
+    return(cur);
+}
+
+void TargetManager::_LockTimerExpired() {
+    const uint32 now = sTimerWheel.now();
+
+    //collect the locks first, the notifications may change our targets.
+    std::vector<SystemEntity *> locked;
     {
-        std::map<SystemEntity *, TargetEntry *>::iterator cur, end;
+        std::vector<TargetEntry>::const_iterator cur, end;
         cur = m_targets.begin();
         end = m_targets.end();
         for(; cur != end; cur++) {
-            switch(cur->second->state) {
-                case TargetEntry::Locking: {
-                    //see if we are finished locking...
-                    if(cur->second->timer.Check()) {
-                        cur->second->timer.Disable();
-                        //yay, they are locked..
-                        cur->second->state = TargetEntry::Locked;
-                        _log(TARGET__TRACE, "%u has finished locking %u", m_self->GetID(), cur->first->GetID());
-                        m_self->TargetAdded(cur->first);
-                        cur->first->targets.TargetedByLocked(m_self);
-                    }
-                } break;
-
-                case TargetEntry::Idle:
-                case TargetEntry::Locked:
-                case TargetEntry::PassiveLocking: {
-                    //nothing to do right now...
-                } break;
-            }
+            if(cur->state == TargetEntry::Locking && int32(now - cur->lockExpiry) >= 0)
+                locked.push_back(cur->who);
         }
     }
-    //now incoming...?
-    //nothing to do right now...
-    /*{
-        std::map<SystemEntity *, TargetedByEntry *>::iterator cur, end;
-        cur = m_targetedBy.begin();
-        end = m_targetedBy.end();
-        for(; cur != end; cur++) {
-            cur->first->targets.TargetLost(m_self);
-        }
-    }*/
+
+    std::vector<SystemEntity *>::const_iterator cur, end;
+    cur = locked.begin();
+    end = locked.end();
+    for(; cur != end; cur++) {
+        std::vector<TargetEntry>::iterator res = _FindTarget(*cur);
+        if(res == m_targets.end() || res->state != TargetEntry::Locking)
+            continue;    //cleared in the meantime.
+
+        //yay, they are locked..
+        res->state = TargetEntry::Locked;
+        _log(TARGET__TRACE, "%u has finished locking %u", m_self->GetID(), (*cur)->GetID());
+        m_self->TargetAdded(*cur);
+        (*cur)->targets.TargetedByLocked(m_self);
+    }
+
+    _ScheduleLockTimer();
+}
+
+void TargetManager::_ScheduleLockTimer() {
+    const uint32 now = sTimerWheel.now();
+
+    bool locking = false;
+    int32 delay = 0;
+
+    std::vector<TargetEntry>::const_iterator cur, end;
+    cur = m_targets.begin();
+    end = m_targets.end();
+    for(; cur != end; cur++) {
+        if(cur->state != TargetEntry::Locking)
+            continue;
+
+        const int32 left = int32(cur->lockExpiry - now);
+        if(!locking || left < delay)
+            delay = left;
+        locking = true;
+    }
+
+    if(!locking)
+        sTimerWheel.Cancel(&m_lockTimer);
+    else
+        sTimerWheel.Schedule(&m_lockTimer, delay < 0 ? 0 : delay);
 }
 
 void TargetManager::ClearTargets(bool notify_self) {
     _log(TARGET__TRACE, "%u is clearing all targets", m_self->GetID());
     {
-        std::map<SystemEntity *, TargetEntry *>::iterator cur, end;
-        cur = m_targets.begin();
-        end = m_targets.end();
+        //take them all out at once, so the notifications see us clear.
+        std::vector<TargetEntry> targets;
+        targets.swap(m_targets);
+        sTimerWheel.Cancel(&m_lockTimer);
+
+        std::vector<TargetEntry>::const_iterator cur, end;
+        cur = targets.begin();
+        end = targets.end();
         for(; cur != end; cur++) {
-            _log(TARGET__TRACE, "%u has cleared target %u during clear all.", m_self->GetID(), cur->first->GetID());
-            cur->first->targets.TargetedByLost(m_self);
-            delete cur->second;
+            _log(TARGET__TRACE, "%u has cleared target %u during clear all.", m_self->GetID(), cur->who->GetID());
+            cur->who->targets.TargetedByLost(m_self);
         }
-        m_targets.clear();
     }
     if(notify_self)
         m_self->TargetsCleared();
@@ -119,30 +162,16 @@ void TargetManager::ClearAllTargets(bool notify_self) {
 }
 
 void TargetManager::ClearFromTargets() {
-    std::vector<SystemEntity *> ToNotify;
-    ToNotify.reserve(m_targetedBy.size());
-
     //first, clean up our internal structure.
-    {
-        std::map<SystemEntity *, TargetedByEntry *>::iterator cur, end;
-        cur = m_targetedBy.begin();
-        end = m_targetedBy.end();
-        for(; cur != end; cur++) {
-            //do not notify until we clear our target list! otherwise bad things happen.
-            ToNotify.push_back(cur->first);
-            delete cur->second;
-        }
-        m_targetedBy.clear();
-    }
-
-    {
-        std::vector<SystemEntity *>::iterator curn, endn;
-        curn = ToNotify.begin();
-        endn = ToNotify.end();
-        for(; curn != endn; curn++) {
+    //do not notify until we clear our target list! otherwise bad things happen.
+    std::vector<TargetedByEntry> targetedBy;
+    targetedBy.swap(m_targetedBy);
 
-            (*curn)->targets.TargetLost(m_self);
-        }
+    std::vector<TargetedByEntry>::const_iterator cur, end;
+    cur = targetedBy.begin();
+    end = targetedBy.end();
+    for(; cur != end; cur++) {
+        cur->who->targets.TargetLost(m_self);
     }
 }
 
@@ -155,8 +184,7 @@ void TargetManager::ClearTarget(SystemEntity *who) {
 
 //called directly when a
 void TargetManager::TargetLost(SystemEntity *who) {
-    std::map<SystemEntity *, TargetEntry *>::iterator res;
-    res = m_targets.find(who);
+    std::vector<TargetEntry>::iterator res = _FindTarget(who);
     if(res == m_targets.end()) {
         //not found...
         return;
@@ -171,9 +199,7 @@ void TargetManager::TargetLost(SystemEntity *who) {
 
 bool TargetManager::StartTargeting(SystemEntity *who, uint32 lock_time) {   // needs another argument: "ShipRef ship" to access ship attributes
     //first make sure they are not already in the list
-    std::map<SystemEntity *, TargetEntry *>::iterator res;
-    res = m_targets.find(who);
-    if(res != m_targets.end()) {
+    if(_FindTarget(who) != m_targets.end()) {
         //what to do?
         _log(TARGET__TRACE, "Told to start targeting %u, but we are already processing them. Ignoring request.", who->GetID());
         return false;
@@ -188,21 +214,31 @@ bool TargetManager::StartTargeting(SystemEntity *who, uint32 lock_time) {   // n
     if( m_targets.size() >= maxLockedTargets )
         return false;
 
-    //TODO: check against max locked target range
-    double maxTargetLockRange = 50000;  // hard-coded for now, but this should be queried from ShipRef ship->maxTargetRange()
-    GVector rangeToTarget( who->GetPosition(), m_self->GetPosition() );
-    if( rangeToTarget.length() > maxTargetLockRange )
+    if( !IsInTargetRange( who ) )
         return false;
 
-    TargetEntry *te = new TargetEntry(who);
-    te->state = TargetEntry::Locking;
-    te->timer.Start(lock_time);
-    m_targets[who] = te;
+    TargetEntry te(who);
+    te.state = TargetEntry::Locking;
+    te.lockExpiry = sTimerWheel.now() + lock_time;
+    m_targets.push_back(te);
+
+    //the timer wheel completes the lock, nothing polls for it.
+    _ScheduleLockTimer();
 
     _log(TARGET__TRACE, "%u started targeting %u (%u ms lock time)", m_self->GetID(), who->GetID(), lock_time);
     return true;
 }
 
+double TargetManager::GetMaxTargetRange() const {
+    //TODO: check against max locked target range
+    return 50000;   // hard-coded for now, but this should be queried from ShipRef ship->maxTargetRange()
+}
+
+bool TargetManager::IsInTargetRange(const SystemEntity *who) const {
+    const double range = GetMaxTargetRange();
+    return( m_self->DistanceTo2( who ) <= range * range );
+}
+
 void TargetManager::TargetEntry::Dump() const {
     const char *sname = "Unknown State";
     switch(state) {
@@ -224,8 +260,8 @@ void TargetManager::TargetEntry::Dump() const {
         who->GetName(),
         who->GetID(),
         sname,
-        timer.Enabled() ? "Running" : "Disabled",
-        timer.GetRemainingTime()
+        state == Locking ? "Running" : "Disabled",
+        state == Locking ? int32(lockExpiry - sTimerWheel.now()) : 0
     );
 }
 
@@ -253,37 +289,37 @@ void TargetManager::TargetedByEntry::Dump() const {
 void TargetManager::Dump() const {
     _log(TARGET__TRACE, "Target Dump for %u:", m_self->GetID());
     {
-        std::map<SystemEntity *, TargetEntry *>::const_iterator cur, end;
+        std::vector<TargetEntry>::const_iterator cur, end;
         cur = m_targets.begin();
         end = m_targets.end();
         for(; cur != end; cur++) {
-            cur->second->Dump();
+            cur->Dump();
         }
     }
     {
-        std::map<SystemEntity *, TargetedByEntry *>::const_iterator cur, end;
+        std::vector<TargetedByEntry>::const_iterator cur, end;
         cur = m_targetedBy.begin();
         end = m_targetedBy.end();
         for(; cur != end; ++cur) {
-            cur->second->Dump();
+            cur->Dump();
         }
     }
 }
 
 SystemEntity *TargetManager::GetTarget(uint32 targetID, bool need_locked) const {
-    std::map<SystemEntity *, TargetEntry *>::const_iterator cur, end;
+    std::vector<TargetEntry>::const_iterator cur, end;
     cur = m_targets.begin();
     end = m_targets.end();
     for(; cur != end; cur++) {
-        if(cur->first->GetID() != targetID)
+        if(cur->who->GetID() != targetID)
             continue;
         //found it...
-        if(need_locked && cur->second->state != TargetEntry::Locked) {
+        if(need_locked && cur->state != TargetEntry::Locked) {
             _log(TARGET__TRACE, "Found target %u, but it is not locked.", targetID);
             continue;
         }
-        //_log(TARGET__TRACE, "Found target %u: %s (nl? %s)", targetID, cur->first->GetName(), need_locked?"yes":"no");
-        return(cur->first);
+        //_log(TARGET__TRACE, "Found target %u: %s (nl? %s)", targetID, cur->who->GetName(), need_locked?"yes":"no");
+        return(cur->who);
     }
     //_log(TARGET__TRACE, "Unable to find target %u (nl? %s)", targetID, need_locked?"yes":"no");
     return NULL;    //not found.
@@ -296,7 +332,7 @@ void TargetManager::QueueTBDestinyEvent( PyTuple** up_in ) const
 
     PyTuple* up_dup = NULL;
 
-    std::map<SystemEntity*, TargetedByEntry*>::const_iterator cur, end;
+    std::vector<TargetedByEntry>::const_iterator cur, end;
     cur = m_targetedBy.begin();
     end = m_targetedBy.end();
     for(; cur != end; ++cur)
@@ -304,7 +340,7 @@ void TargetManager::QueueTBDestinyEvent( PyTuple** up_in ) const
         if( NULL == up_dup )
             up_dup = new PyTuple( *up );
 
-        cur->first->QueueDestinyEvent( &up_dup );
+        cur->who->QueueDestinyEvent( &up_dup );
         //they may not have consumed it (NPCs for example), so dont re-dup it in that case.
     }
 
@@ -319,7 +355,7 @@ void TargetManager::QueueTBDestinyUpdate( PyTuple** up_in ) const
 
     PyTuple* up_dup = NULL;
 
-    std::map<SystemEntity*, TargetedByEntry*>::const_iterator cur, end;
+    std::vector<TargetedByEntry>::const_iterator cur, end;
     cur = m_targetedBy.begin();
     end = m_targetedBy.end();
     for(; cur != end; ++cur)
@@ -327,7 +363,7 @@ void TargetManager::QueueTBDestinyUpdate( PyTuple** up_in ) const
         if( NULL == up_dup )
             up_dup = new PyTuple( *up );
 
-        cur->first->QueueDestinyUpdate( &up_dup );
+        cur->who->QueueDestinyUpdate( &up_dup );
         //they may not have consumed it (NPCs for example), so dont re-dup it in that case.
     }
 
@@ -335,33 +371,17 @@ void TargetManager::QueueTBDestinyUpdate( PyTuple** up_in ) const
     PyDecRef( up );
 }
 
-/*void TargetManager::TargetedByLocking(SystemEntity *from_who) {
-    //first make sure they are not already in the list
-    std::map<SystemEntity *, TargetedByEntry *>::iterator res;
-    res = m_targetedBy.find(from_who);
-    if(res != m_targetedBy.end()) {
-        //just re-use the old entry...
-    } else {
-        //new entry.
-        TargetedByEntry *te = new TargetedByEntry(from_who);
-        te->state = TargetedByEntry::Locking;
-        m_targetedBy[from_who] = te;
-    }
-    //no notification, should we even track this event??
-}*/
-
 void TargetManager::TargetedByLocked(SystemEntity *from_who) {
     //first make sure they are not already in the list
-    std::map<SystemEntity *, TargetedByEntry *>::iterator res;
-    res = m_targetedBy.find(from_who);
+    std::vector<TargetedByEntry>::iterator res = _FindTargetedBy(from_who);
     if(res != m_targetedBy.end()) {
         //just re-use the old entry...
-        res->second->state = TargetedByEntry::Locked;
+        res->state = TargetedByEntry::Locked;
     } else {
         //new entry.
-        TargetedByEntry *te = new TargetedByEntry(from_who);
-        te->state = TargetedByEntry::Locking;
-        m_targetedBy[from_who] = te;
+        TargetedByEntry te(from_who);
+        te.state = TargetedByEntry::Locking;
+        m_targetedBy.push_back(te);
     }
     _log(TARGET__TRACE, "%u has been locked by %u", m_self->GetID(), from_who->GetID());
     m_self->TargetedAdd(from_who);
@@ -369,10 +389,8 @@ void TargetManager::TargetedByLocked(SystemEntity *from_who) {
 
 void TargetManager::TargetedByLost(SystemEntity *from_who) {
     //first make sure they are not already in the list
-    std::map<SystemEntity *, TargetedByEntry *>::iterator res;
-    res = m_targetedBy.find(from_who);
+    std::vector<TargetedByEntry>::iterator res = _FindTargetedBy(from_who);
     if(res != m_targetedBy.end()) {
-        delete res->second;
         m_targetedBy.erase(res);
         m_self->TargetedLost(from_who);
         _log(TARGET__TRACE, "%u is no longer locked by %u", m_self->GetID(), from_who->GetID());
@@ -387,15 +405,15 @@ SystemEntity *TargetManager::GetFirstTarget(bool need_locked) {
         return NULL;
     if(!need_locked) {
         //we know there is at least one entry here...
-        return(m_targets.begin()->first);
+        return(m_targets.front().who);
     }
 
-    std::map<SystemEntity *, TargetEntry *>::const_iterator cur, end;
+    std::vector<TargetEntry>::const_iterator cur, end;
     cur = m_targets.begin();
     end = m_targets.end();
     for(; cur != end; cur++) {
-        if(cur->second->state == TargetEntry::Locked)
-            return(cur->first);
+        if(cur->state == TargetEntry::Locked)
+            return(cur->who);
     }
     return NULL;
 }
@@ -403,11 +421,11 @@ SystemEntity *TargetManager::GetFirstTarget(bool need_locked) {
 PyList *TargetManager::GetTargets() const {
     PyList *result = new PyList();
 
-    std::map<SystemEntity *, TargetEntry *>::const_iterator cur, end;
+    std::vector<TargetEntry>::const_iterator cur, end;
     cur = m_targets.begin();
     end = m_targets.end();
     for(; cur != end; cur++)
-        result->AddItemInt( cur->first->GetID() );
+        result->AddItemInt( cur->who->GetID() );
 
     return result;
 }
@@ -415,11 +433,11 @@ PyList *TargetManager::GetTargets() const {
 PyList *TargetManager::GetTargeters() const {
     PyList *result = new PyList();
 
-    std::map<SystemEntity *, TargetedByEntry *>::const_iterator cur, end;
+    std::vector<TargetedByEntry>::const_iterator cur, end;
     cur = m_targetedBy.begin();
     end = m_targetedBy.end();
     for(; cur != end; cur++)
-        result->AddItemInt( cur->first->GetID() );
+        result->AddItemInt( cur->who->GetID() );
 
     return result;
 }
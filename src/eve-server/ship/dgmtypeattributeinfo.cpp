@@ -25,89 +25,81 @@
 
 #include "eve-server.h"
 
+#include "database/DBSnapshot.h"
+#include "database/StaticDataSnapshot.h"
 #include "ship/dgmtypeattributeinfo.h"
 
-dgmtypeattributemgr::dgmtypeattributemgr()
+dgmtypeattributemgr::dgmtypeattributemgr(const DBSnapshot* snapshot)
 {
-    // load shit from db
-    DBQueryResult res;
-
-    if( !sDatabase.RunQuery( res,
-        "SELECT * FROM dgmTypeAttributes ORDER BY typeID" ) )
+    if( snapshot == NULL || !_LoadSnapshot( *snapshot ) )
     {
-        sLog.Error("DgmTypeAttrMgr", "Error in db load query: %s", res.error.c_str());
-        return;
+        // load shit from db
+        _LoadDatabase();
     }
 
-    uint32 currentID = 0;
-    DgmTypeAttributeSet * entry = NULL;
-    DBResultRow row;
-
-    int amount = res.GetRowCount();
-    for (int i = 0; i < amount; i++)
-    {
-        res.GetRow(row);
-        uint32 typeID = row.GetUInt(0);
-
-        // need a better solution for this
-        if (currentID == 0) {
-            currentID = typeID;
-            entry = new DgmTypeAttributeSet;
-        }
-
-        if (currentID != typeID) {
-            mDgmTypeAttrInfo.insert(std::make_pair(currentID, entry));
-            currentID = typeID;
-            entry = new DgmTypeAttributeSet;
-        }
-
-        DmgTypeAttribute * attr_entry = new DmgTypeAttribute();
-        attr_entry->attributeID = row.GetUInt(1);
-        if (row.IsNull(2) == true) {
-            attr_entry->number = EvilNumber(row.GetFloat(3));
-        } else {
-            attr_entry->number = EvilNumber(row.GetInt(2));
-        }
-
-        entry->attributeset.push_back(attr_entry);
-    }
+    mDgmTypeAttrInfo.Build();
 }
 
-dgmtypeattributemgr::~dgmtypeattributemgr()
+template<typename Row>
+void dgmtypeattributemgr::_AddRow(const Row& row)
 {
-    DgmTypeAttributeMapItr itr = mDgmTypeAttrInfo.begin();
-    for (; itr != mDgmTypeAttrInfo.end(); itr++)
-    {
-        delete itr->second;
+    EvilNumber number;
+    if (row.IsNull(2) == true) {
+        number = EvilNumber(row.GetFloat(3));
+    } else {
+        number = EvilNumber(row.GetInt(2));
     }
+
+    mDgmTypeAttrInfo.Add(row.GetUInt(0), row.GetUInt(1), number);
 }
 
-DgmTypeAttributeSet* dgmtypeattributemgr::GetDmgTypeAttributeSet( uint32 typeID )
+bool dgmtypeattributemgr::_LoadSnapshot(const DBSnapshot& snapshot)
 {
-    DgmTypeAttributeMapItr itr;
-    itr = mDgmTypeAttrInfo.find(typeID);
-    if (itr == mDgmTypeAttrInfo.end())
+    const DBSnapshot::Table* table = snapshot.GetTable( STATIC_SNAPSHOT_TYPE_ATTRIBUTES );
+    if( table == NULL || table->ColumnCount() != 4 )
     {
-        sLog.Error("DgmTypeAttrMgr", "unable to find typeID: %u", typeID);
-        return NULL;
+        sLog.Error("DgmTypeAttrMgr", "Static data snapshot has no usable %s table, querying the database.", STATIC_SNAPSHOT_TYPE_ATTRIBUTES);
+        return false;
     }
 
-    if (!itr->second)
+    DBSnapshotRow row;
+
+    const uint32 amount = table->RowCount();
+    for (uint32 i = 0; i < amount; i++)
     {
-        sLog.Error("DgmTypeAttrMgr", "something went wrong with typeID: %u, db problem.... maybe", typeID);
-        return NULL;
+        table->GetRow(i, row);
+        _AddRow(row);
     }
 
-    // whooo we found it :D
-    return itr->second;
+    return true;
 }
 
+bool dgmtypeattributemgr::_LoadDatabase()
+{
+    DBQueryResult res;
 
-DgmTypeAttributeSet::~DgmTypeAttributeSet()
+    if( !sDatabase.RunQuery( res,
+        "SELECT typeID, attributeID, valueInt, valueFloat FROM dgmTypeAttributes ORDER BY typeID" ) )
+    {
+        sLog.Error("DgmTypeAttrMgr", "Error in db load query: %s", res.error.c_str());
+        return false;
+    }
+
+    DBResultRow row;
+    while (res.GetRow(row))
+        _AddRow(row);
+
+    return true;
+}
+
+bool dgmtypeattributemgr::GetDmgTypeAttributeSet( uint32 typeID, DgmTypeAttributeSet& into ) const
 {
-    AttrSetItr itr = attributeset.begin();
-    for (; itr != attributeset.end(); itr++)
+    if (!mDgmTypeAttrInfo.Find(typeID, into))
     {
-        delete (*itr);
+        sLog.Error("DgmTypeAttrMgr", "unable to find typeID: %u", typeID);
+        return false;
     }
+
+    // whooo we found it :D
+    return true;
 }
@@ -28,38 +28,51 @@
 
 #include "ship/modules/ActiveModules.h"
 
+ActiveModule::CycleStats ActiveModule::s_cycleStats;
+
 ActiveModule::ActiveModule(InventoryItemRef item, ShipRef ship)
+: targetID( 0 ),
+  m_cycleTimer( *this )
 {
     m_Item = item;
     m_Ship = ship;
-    m_Effects = new ModuleEffects(m_Item->typeID());
+    m_Type = sModuleTypeTable.GetModuleType(*item);
     m_ShipAttrComp = new ModifyShipAttributesComponent(this, ship);
+    m_ActiveModuleProcComp = new ActiveModuleProcessingComponent(this, ship, m_ShipAttrComp);
 }
 
 ActiveModule::~ActiveModule()
 {
+    //stop cycling before the components go away
+    sTimerWheel.Cancel(&m_cycleTimer);
+
     //delete members
-    delete m_Effects;
     delete m_ShipAttrComp;
+    delete m_ActiveModuleProcComp;
 
     //null ptrs
-    m_Effects = NULL;
+    m_Type = NULL;
     m_ShipAttrComp = NULL;
+    m_ActiveModuleProcComp = NULL;
 }
 
 void ActiveModule::Process()
 {
-
+    //cycles are driven by m_cycleTimer
 }
 
 void ActiveModule::Offline()
 {
+    sTimerWheel.Cancel(&m_cycleTimer);
+
     m_Item->PutOffline();
+    m_Module_State = MOD_OFFLINE;
 }
 
 void ActiveModule::Online()
 {
     m_Item->PutOnline();
+    m_Module_State = MOD_ONLINE;
 }
 
 void ActiveModule::Activate(uint32 targetID)
@@ -68,10 +81,74 @@ void ActiveModule::Activate(uint32 targetID)
     // PROBLEM:
     //   m_Ship does not have access to DestinyManager
     //   Client DOES have access to DestinyManager, so we need to pass reference to it down through Ship and into ModuleManager
+
+    if( !isOnline() )
+        return;
+
+    //already cycling; a pending deactivation is called off
+    if( m_cycleTimer.IsTimerScheduled() )
+    {
+        m_ActiveModuleProcComp->ActivateCycle();
+        m_Module_State = MOD_ACTIVATED;
+        return;
+    }
+
+    if( _GetCycleDuration() == 0 )
+    {
+        sLog.Error("ActiveModule::Activate()", "Module %u (type %u) has no cycle duration.", itemID(), typeID());
+        return;
+    }
+
+    this->targetID = targetID;
+    m_Module_State = MOD_ACTIVATED;
+    m_ActiveModuleProcComp->ActivateCycle();
+    s_cycleStats.activations++;
+
+    _StartCycle();
 }
 
 void ActiveModule::Deactivate()
 {
+    //the running cycle is finished, no new one is started
+    if( m_cycleTimer.IsTimerScheduled() )
+    {
+        m_ActiveModuleProcComp->DeactivateCycle();
+        m_Module_State = MOD_DEACTIVATING;
+    }
+}
+
+uint32 ActiveModule::_GetCycleDuration()
+{
+    if( m_Type == NULL || !m_Type->HasDefaultEffect() )
+        return 0;
 
+    const uint32 attrID = m_Type->GetDefaultEffect()->GetDurationAttributeID();
+    if( attrID == 0 || !m_Item->HasAttribute(attrID) )
+        return 0;
+
+    EvilNumber duration = m_Item->GetAttribute(attrID);
+    const double ms = duration.get_float();
+    return ms > 0 ? (uint32)ms : 0;
+}
+
+void ActiveModule::_StartCycle()
+{
+    m_ActiveModuleProcComp->ProcessActiveCycle();
+
+    s_cycleStats.cycles++;
+    s_cycleStats.groupCycles[m_Type->groupID()]++;
+
+    sTimerWheel.Schedule(&m_cycleTimer, _GetCycleDuration());
 }
 
+void ActiveModule::_CycleTimerExpired()
+{
+    if( !isOnline() || _GetCycleDuration() == 0
+        || !m_ActiveModuleProcComp->ShouldProcessActiveCycle() )
+    {
+        m_Module_State = isOnline() ? MOD_ONLINE : MOD_OFFLINE;
+        return;
+    }
+
+    _StartCycle();
+}
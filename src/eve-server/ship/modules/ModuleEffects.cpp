@@ -101,34 +101,30 @@ void MEffect::_Populate(uint32 effectID)
 
     DBResultRow row2;
 
-    // Initialize the new tables
-    m_TargetAttributeIDs = new int[res->GetRowCount()];
-    m_SourceAttributeIDs = new int[res->GetRowCount()];
-    m_CalculationTypeIDs = new int[res->GetRowCount()];
-    m_ReverseCalculationTypeIDs = new int[res->GetRowCount()];
-
-    int count = 0;
+    // Keep the rows until the actions are known, then compile them together:
+    std::vector<int> infoRows;
 
     while( res->GetRow(row2) )
     {
-        m_TargetAttributeIDs[count] = row2.GetInt(0);
-        m_SourceAttributeIDs[count] = row2.GetInt(1);
-        m_CalculationTypeIDs[count] = row2.GetInt(2);
-        m_ReverseCalculationTypeIDs[count] = row2.GetInt(3);
-        count++;
+        infoRows.push_back(row2.GetInt(0));     // targetAttributeID
+        infoRows.push_back(row2.GetInt(1));     // sourceAttributeID
+        infoRows.push_back(row2.GetInt(2));     // calculationTypeID
+        infoRows.push_back(row2.GetInt(3));     // reverseCalculationTypeID
     }
 
-    if( count == 0 )
+    if( infoRows.empty() )
         sLog.Error("MEffect","Could not populate effect information for effectID: %u from the 'dgmEffectsInfo' table as the SQL query returned ZERO rows", effectID);
 
-    m_numOfIDs = count;
-
     // Finally, get the info for this effectID from the dgmEffectsActions table:
     ModuleDB::GetDgmEffectsActions(effectID, *res);
 
     DBResultRow row3;
     std::string targetGroupIDs;
 
+    m_EffectAppliedWhenID = 0;
+    m_EffectAppliedTargetID = 0;
+    m_StackingPenaltyAppliedID = 0;
+
     if( !(res->GetRow(row3)) )
         sLog.Error("MEffect","Could not populate effect information for effectID: %u from 'dgmEffectsActions table", effectID);
     else
@@ -143,26 +139,75 @@ void MEffect::_Populate(uint32 effectID)
         m_NullifyOnlineEffectEnable = row3.GetInt(7);
         m_NullifiedOnlineEffectID = row3.GetInt(8);
 
-        if( !(targetGroupIDs.empty()) )
+        // comma separated list of groupIDs:
+        std::string::size_type start = 0, pos;
+        while( start < targetGroupIDs.size() )
         {
-            int pos = 0;
-            std::string tempString = "";
-            std::vector<uint32>::iterator it;
-            pos = targetGroupIDs.find_first_of(',');
-            tempString = targetGroupIDs.substr(0,pos);
+            pos = targetGroupIDs.find_first_of(',', start);
+            if( pos == std::string::npos )
+                pos = targetGroupIDs.size();
 
-            while( (pos = targetGroupIDs.find_first_of(',')) )
-            {
-                tempString = targetGroupIDs.substr(0,pos);
-                m_TargetGroupIDs.insert( it, (atoi(tempString.c_str())) );
-            }
+            if( pos > start )
+                m_TargetGroupIDs.push_back( atoi(targetGroupIDs.substr(start, pos - start).c_str()) );
+            start = pos + 1;
         }
     }
 
+    _Compile(infoRows);
+
     delete res;
     res = NULL;
 }
 
+// The calculation types which take their value straight from the source attribute, so the graph can keep
+// the modifier linked to that attribute:
+static uint8 CompileOperation(int calcTypeID)
+{
+    switch(calcTypeID)
+    {
+        case CALC_ADD :                         return ModifierGraph::OP_ADD;
+        case CALC_SUBTRACT :                    return ModifierGraph::OP_SUBTRACT;
+        case CALC_MULTIPLY :                    return ModifierGraph::OP_POST_MULTIPLY;
+        case CALC_DIVIDE :                      return ModifierGraph::OP_POST_DIVIDE;
+        case CALC_ADD_AS_PERCENT :              return ModifierGraph::OP_POST_PERCENT;
+        case CALC_MODIFY_PERCENT_W_PERCENT :    return ModifierGraph::OP_POST_PERCENT;
+    }
+
+    return EFFECT_OPERATION_NONE;
+}
+
+void MEffect::_Compile(const std::vector<int> & infoRows)
+{
+    m_Program.clear();
+    m_Program.reserve(infoRows.size() / 4);
+
+    for(size_t i = 0; i + 4 <= infoRows.size(); i += 4)
+    {
+        const int targetAttributeID = infoRows[i];
+        const int sourceAttributeID = infoRows[i + 1];
+        const int calculationTypeID = infoRows[i + 2];
+        const int reverseCalculationTypeID = infoRows[i + 3];
+
+        if( m_EffectID > 0xFFFF || targetAttributeID < 0 || targetAttributeID > 0xFFFF || sourceAttributeID < 0 || sourceAttributeID > 0xFFFF )
+        {
+            sLog.Error("MEffect","Attribute list of effectID: %u does not fit compiled effects, skipping entry for targetAttributeID: %d", m_EffectID, targetAttributeID);
+            continue;
+        }
+
+        EffectInstruction instruction;
+        instruction.effectID = m_EffectID;
+        instruction.targetAttributeID = targetAttributeID;
+        instruction.sourceAttributeID = sourceAttributeID;
+        instruction.calculation = calculationTypeID - CALC_NONE;
+        instruction.reverseCalculation = reverseCalculationTypeID - CALC_NONE;
+        instruction.operation = CompileOperation(calculationTypeID);
+        instruction.target = m_EffectAppliedTargetID - EFFECT_TARGET_SELF;
+        instruction.penalized = (m_StackingPenaltyAppliedID == STACKING_PENALTY_APPLIES) ? 1 : 0;
+
+        m_Program.push_back(instruction);
+    }
+}
+
 
 // ////////////////////// DGM_Effects_Table Class ////////////////////////////
 DGM_Effects_Table::DGM_Effects_Table()
@@ -171,7 +216,13 @@ DGM_Effects_Table::DGM_Effects_Table()
 
 DGM_Effects_Table::~DGM_Effects_Table()
 {
-    // TODO: loop through entire std::map<> and delete ALL entries, calling ~MEffect() on each
+    std::map<uint32, TypeEffects *>::iterator curType = m_TypeEffectsMap.begin();
+    for(; curType != m_TypeEffectsMap.end(); ++curType)
+        delete curType->second;
+
+    std::map<uint32, MEffect *>::iterator cur = m_EffectsMap.begin();
+    for(; cur != m_EffectsMap.end(); ++cur)
+        delete cur->second;
 }
 
 int DGM_Effects_Table::Initialize()
@@ -222,118 +273,27 @@ MEffect * DGM_Effects_Table::GetEffect(uint32 effectID)
 }
 
 
-// ////////////////////// ModuleEffects Class ////////////////////////////
-
-ModuleEffects::ModuleEffects(uint32 typeID) : m_typeID( typeID ), m_Cached( false )
+const TypeEffects * DGM_Effects_Table::GetTypeEffects(uint32 typeID)
 {
-    m_typeID = 0;
-    m_HighPower = m_MediumPower = m_LowPower = m_Cached = false;
-
-    _populate(typeID);
+    std::map<uint32, TypeEffects *>::iterator res = m_TypeEffectsMap.find(typeID);
+    if( res != m_TypeEffectsMap.end() )
+        return res->second;
+
+    // First module of this type, so build the effects for all of them:
+    TypeEffects * typeEffects = new TypeEffects(typeID);
+    m_TypeEffectsMap.insert(std::pair<uint32, TypeEffects *>(typeID, typeEffects));
+    return typeEffects;
 }
 
-ModuleEffects::~ModuleEffects()
-{
-    //delete arrays
 
-    //null ptrs
-}
+// ////////////////////// TypeEffects Class ////////////////////////////
 
-//useful accessors - probably a better way to do this, but at least it's fast
-bool ModuleEffects::isHighSlot()
-{
-    if( m_Cached )
-        return m_HighPower;
-    else
-    {
-    /*    for(uint32 i = 0; i < m_EffectCount; i++)
-        {
-            if( m_EffectIDs[i] == effectHiPower )
-            {
-                m_HighPower = true;
-                m_MediumPower = false;
-                m_LowPower = false;
-                m_Cached = true; //cache the result
-                return true;
-            }
-        }*/
-    }
-
-    return false;
-}
-
-bool ModuleEffects::isMediumSlot()
-{
-    if( m_Cached )
-        return m_MediumPower;
-    else
-    {
-    /*    for(uint32 i = 0; i < m_EffectCount; i++)
-        {
-            if( m_EffectIDs[i] == effectMedPower )
-            {
-                m_HighPower = false;
-                m_MediumPower = true;
-                m_LowPower = false;
-                m_Cached = true;  //cache the result
-                return true;
-            }
-        }*/
-    }
-
-    return false;
-}
-
-bool ModuleEffects::isLowSlot()
-{
-    if( m_Cached )
-        return m_LowPower;
-    else
-    {
-    /*    for(uint32 i = 0; i < m_EffectCount; i++)
-        {
-            if( m_EffectIDs[i] == effectLoPower )
-            {
-                m_HighPower = false;
-                m_MediumPower = false;
-                m_LowPower = true;
-                m_Cached = true; //cache the result
-                return true;
-            }
-        }*/
-    }
-
-    return false;
-}
-
-bool ModuleEffects::HasEffect(uint32 effectID)
-{
-    std::map<uint32, MEffect *>::const_iterator cur, end;
-
-    if( m_OnlineEffects.find(effectID) != m_OnlineEffects.end() )
-        return true;
-
-    if( m_ActiveEffects.find(effectID) != m_ActiveEffects.end() )
-        return true;
-
-    if( m_OverloadEffects.find(effectID) != m_OverloadEffects.end() )
-        return true;
-
-    return false;
-}
-
-MEffect * ModuleEffects::GetEffect(uint32 effectID)
-{
-    // WARNING: This function MUST be defined!
-    return NULL;
-}
-
-//this will need to be reworked to implement a singleton architecture...i'll do it later -luck
-
-
-// ////////////////// PRIVATE MEMBERS /////////////////////////
-
-void ModuleEffects::_populate(uint32 typeID)
+TypeEffects::TypeEffects(uint32 typeID)
+: m_typeID( typeID ),
+  m_defaultEffect( NULL ),
+  m_HighPower( false ),
+  m_MediumPower( false ),
+  m_LowPower( false )
 {
     //first get list of all of the effects associated with the typeID
     DBQueryResult *res = new DBQueryResult();
@@ -342,22 +302,30 @@ void ModuleEffects::_populate(uint32 typeID)
     //counter
     MEffect * mEffectPtr;
     mEffectPtr = NULL;
-    m_defaultEffect = NULL;     // Set this to NULL until the default effect is found, if there is any
     uint32 effectID;
     uint32 isDefault;
 
-    //go through and find each effect, then add pointer to effect to our own map
+    //go through and find each effect, then add pointer to effect to our own lists
     DBResultRow row;
     while( res->GetRow(row) )
     {
         effectID = row.GetInt(0);
         isDefault = row.GetInt(1);
+        m_EffectIDs.push_back(effectID);
+
         switch( effectID )
         {
-            case 11:    // loPower
-            case 12:    // hiPower
-            case 13:    // medPower
-                // We do not need to make MEffect objects these effectIDs, since they do nothing
+            // We do not need to make MEffect objects these effectIDs, since they do nothing but tell the slot
+            case effectLoPower:
+                m_LowPower = true;
+                mEffectPtr = NULL;
+                break;
+            case effectHiPower:
+                m_HighPower = true;
+                mEffectPtr = NULL;
+                break;
+            case effectMedPower:
+                m_MediumPower = true;
                 mEffectPtr = NULL;
                 break;
 
@@ -374,25 +342,35 @@ void ModuleEffects::_populate(uint32 typeID)
         // that are modified by this effect for which module state during which the effect is active:
         if( mEffectPtr != NULL )
         {
-            switch( mEffectPtr->GetModuleStateWhenEffectApplied(0) )
+            const uint32 state = mEffectPtr->GetModuleStateWhenEffectApplied(0);
+            if( state >= EFFECT_PERSISTENT && state <= EFFECT_OVERLOAD )
             {
-                case EFFECT_ONLINE:
-                    m_OnlineEffects.insert(std::pair<uint32, MEffect *>(effectID,mEffectPtr));
-                    break;
-                case EFFECT_ACTIVE:
-                    m_ActiveEffects.insert(std::pair<uint32, MEffect *>(effectID,mEffectPtr));
-                    break;
-                case EFFECT_OVERLOAD:
-                    m_OverloadEffects.insert(std::pair<uint32, MEffect *>(effectID,mEffectPtr));
-                    break;
-                default:
-                    sLog.Error("ModuleEffects::_populate()", "Illegal value '%u' obtained from the 'effectAppliedInState' field of the 'dgmEffectsInfo' table", mEffectPtr->GetModuleStateWhenEffectApplied(0));
-                    break;
+                m_Effects[state - EFFECT_PERSISTENT].push_back(mEffectPtr);
+
+                const EffectProgram & program = mEffectPtr->GetProgram();
+                m_Programs[state - EFFECT_PERSISTENT].insert(m_Programs[state - EFFECT_PERSISTENT].end(), program.begin(), program.end());
             }
+            else
+                sLog.Error("TypeEffects", "Illegal value '%u' obtained from the 'effectAppliedInState' field of the 'dgmEffectsInfo' table", state);
         }
     }
 
+    std::sort(m_EffectIDs.begin(), m_EffectIDs.end());
+
     //cleanup
     delete res;
     res = NULL;
 }
+
+bool TypeEffects::HasEffect(uint32 effectID) const
+{
+    return std::binary_search(m_EffectIDs.begin(), m_EffectIDs.end(), effectID);
+}
+
+MEffect * TypeEffects::GetEffect(uint32 effectID) const
+{
+    if( !HasEffect(effectID) )
+        return NULL;
+
+    return sDGM_Effects_Table.GetEffect(effectID);
+}
@@ -0,0 +1,271 @@
+/*
+    ------------------------------------------------------------------------------------
+    LICENSE:
+    ------------------------------------------------------------------------------------
+    This file is part of EVEmu: EVE Online Server Emulator
+    Copyright 2006 - 2011 The EVEmu Team
+    For the latest information visit http://evemu.org
+    ------------------------------------------------------------------------------------
+    This program is free software; you can redistribute it and/or modify it under
+    the terms of the GNU Lesser General Public License as published by the Free Software
+    Foundation; either version 2 of the License, or (at your option) any later
+    version.
+
+    This program is distributed in the hope that it will be useful, but WITHOUT
+    ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+    FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public License along with
+    this program; if not, write to the Free Software Foundation, Inc., 59 Temple
+    Place - Suite 330, Boston, MA 02111-1307, USA, or go to
+    http://www.gnu.org/copyleft/lesser.txt.
+    ------------------------------------------------------------------------------------
+    Author:     EVEmu Team
+*/
+
+#include "eve-server.h"
+
+#include "inventory/EffectsEnum.h"
+#include "inventory/InventoryItem.h"
+#include "ship/dgmtypeattributeinfo.h"
+#include "ship/modules/ModuleType.h"
+
+// ////////////////////// ModuleType Class ////////////////////////////
+
+ModuleType::ModuleType(uint32 typeID, uint32 groupID, uint32 categoryID)
+: m_typeID( typeID ),
+  m_groupID( groupID ),
+  m_categoryID( categoryID ),
+  m_Class( _GetModuleClass(groupID) ),
+  m_TypeEffects( sDGM_Effects_Table.GetTypeEffects(typeID) )
+{
+    m_Rig = ( (categoryID >= 773 && categoryID <= 782) || (categoryID == 786) || (categoryID == 787) || (categoryID == 896) || (categoryID == 904) );  //need to use enums, but the enum system is a huge mess
+    m_SubSystem = ( categoryID == EVEDB::invCategories::Subsystem );
+
+    m_Turret = m_TypeEffects->HasEffect(Effect_turretFitted);       // Effect_turretFitted from enum EveAttrEnum::Effect_turretFitted
+    m_Launcher = m_TypeEffects->HasEffect(Effect_launcherFitted);   // Effect_launcherFitted from enum EveAttrEnum::Effect_launcherFitted
+
+    EvilNumber maxGroupFitted;
+    DgmTypeAttributeSet attributes;
+    m_MaxGroupFitLimited = ( sDgmTypeAttrMgr.GetDmgTypeAttributeSet(typeID, attributes)
+                             && attributes.Find(AttrMaxGroupFitted, maxGroupFitted) );
+
+    MEffect * defaultEffect = m_TypeEffects->GetDefaultEffect();
+    m_RequiresTarget = ( defaultEffect != NULL
+                         && (defaultEffect->GetIsAssistance() || defaultEffect->GetIsOffensive()) );
+}
+
+ModuleClass ModuleType::_GetModuleClass(uint32 groupID)
+{
+    switch(groupID)
+    {
+        // Armor Modules Subgroup:
+        case EVEDB::invGroups::Damage_Control:                          return MODULE_CLASS_ACTIVE;    // Active
+        case EVEDB::invGroups::Armor_Repair_Unit:                       return MODULE_CLASS_NONE;    // Active
+        case EVEDB::invGroups::Hull_Repair_Unit:                        return MODULE_CLASS_NONE;    // Active
+        case EVEDB::invGroups::Reinforced_Bulkheads:                    return MODULE_CLASS_PASSIVE;
+        case EVEDB::invGroups::Armor_Coating:                           return MODULE_CLASS_PASSIVE;
+        case EVEDB::invGroups::Armor_Repair_Projector:                  return MODULE_CLASS_NONE;    // Active
+        case EVEDB::invGroups::Armor_Plating_Energized:                 return MODULE_CLASS_PASSIVE;
+        case EVEDB::invGroups::Armor_Hardener:                          return MODULE_CLASS_ACTIVE;    // Active
+        case EVEDB::invGroups::Armor_Reinforcer:                        return MODULE_CLASS_PASSIVE;
+        case EVEDB::invGroups::Remote_Hull_Repairer:                    return MODULE_CLASS_NONE;    // Active
+        case EVEDB::invGroups::Expanded_Cargohold:                      return MODULE_CLASS_PASSIVE;
+
+        // Electronics Modules Subgroup:
+        case EVEDB::invGroups::Cargo_Scanner:                           return MODULE_CLASS_NONE;    // Active
+        case EVEDB::invGroups::Ship_Scanner:                            return MODULE_CLASS_NONE;    // Active
+        case EVEDB::invGroups::Survey_Scanner:                          return MODULE_CLASS_NONE;    // Active
+        case EVEDB::invGroups::Cloaking_Device:                         return MODULE_CLASS_NONE;    // Active
+        case EVEDB::invGroups::Target_Painter:                          return MODULE_CLASS_NONE;    // Active
+        case EVEDB::invGroups::Drone_Control_Unit:                      return MODULE_CLASS_PASSIVE;
+        case EVEDB::invGroups::System_Scanner:                          return MODULE_CLASS_NONE;    // Active
+        case EVEDB::invGroups::Scan_Probe_Launcher:                     return MODULE_CLASS_NONE;    // Active
+        case EVEDB::invGroups::Drone_Navigation_Computer:               return MODULE_CLASS_PASSIVE;
+        case EVEDB::invGroups::Drone_Tracking_Modules:                  return MODULE_CLASS_PASSIVE;
+        case EVEDB::invGroups::Drone_Control_Range_Module:              return MODULE_CLASS_PASSIVE;
+        case EVEDB::invGroups::Tractor_Beam:                            return MODULE_CLASS_NONE;    // Active
+
+        // Engineering Modules Subgroup:
+        case EVEDB::invGroups::Capacitor_Recharger:                     return MODULE_CLASS_PASSIVE;
+        case EVEDB::invGroups::Capacitor_Battery:                       return MODULE_CLASS_PASSIVE;
+        case EVEDB::invGroups::Energy_Transfer_Array:                   return MODULE_CLASS_NONE;    // Active
+        case EVEDB::invGroups::Capacitor_Booster:                       return MODULE_CLASS_NONE;    // Active
+        case EVEDB::invGroups::Auxiliary_Power_Core:                    return MODULE_CLASS_PASSIVE;
+        case EVEDB::invGroups::Power_Diagnostic_System:                 return MODULE_CLASS_PASSIVE;
+        case EVEDB::invGroups::Capacitor_Power_Relay:                   return MODULE_CLASS_PASSIVE;
+        case EVEDB::invGroups::Capacitor_Flux_Coil:                     return MODULE_CLASS_PASSIVE;
+        case EVEDB::invGroups::Reactor_Control_Unit:                    return MODULE_CLASS_PASSIVE;
+        case EVEDB::invGroups::Shield_Flux_Coil:                        return MODULE_CLASS_PASSIVE;
+
+        // EWAR Modules Subgroup:
+        case EVEDB::invGroups::Warp_Scrambler:                          return MODULE_CLASS_NONE;    // Active
+        case EVEDB::invGroups::Stasis_Web:                              return MODULE_CLASS_NONE;    // Active
+        case EVEDB::invGroups::ECM_Burst:                               return MODULE_CLASS_NONE;    // Active
+        case EVEDB::invGroups::Passive_Targeting_System:                return MODULE_CLASS_NONE;    // Active
+        case EVEDB::invGroups::Automated_Targeting_System:              return MODULE_CLASS_NONE;    // Active
+        case EVEDB::invGroups::ECM:                                     return MODULE_CLASS_NONE;    // Active
+        case EVEDB::invGroups::ECCM:                                    return MODULE_CLASS_NONE;    // Active
+        case EVEDB::invGroups::Sensor_Backup_Array:                     return MODULE_CLASS_PASSIVE;
+        case EVEDB::invGroups::Remote_Sensor_Damper:                    return MODULE_CLASS_NONE;    // Active
+        case EVEDB::invGroups::Tracking_Link:                           return MODULE_CLASS_NONE;    // Active
+        case EVEDB::invGroups::Signal_Amplifier:                        return MODULE_CLASS_PASSIVE;
+        case EVEDB::invGroups::Tracking_Enhancer:                       return MODULE_CLASS_PASSIVE;
+        case EVEDB::invGroups::Sensor_Booster:                          return MODULE_CLASS_NONE;    // Active
+        case EVEDB::invGroups::Tracking_Computer:                       return MODULE_CLASS_NONE;    // Active
+        case EVEDB::invGroups::CPU_Enhancer:                            return MODULE_CLASS_PASSIVE;
+        case EVEDB::invGroups::Projected_ECCM:                          return MODULE_CLASS_NONE;    // Active
+        case EVEDB::invGroups::Remote_Sensor_Booster:                   return MODULE_CLASS_NONE;    // Active
+        case EVEDB::invGroups::Tracking_Disruptor:                      return MODULE_CLASS_NONE;    // Active
+        case EVEDB::invGroups::ECM_Stabilizer:                          return MODULE_CLASS_PASSIVE;
+        case EVEDB::invGroups::Remote_ECM_Burst:                        return MODULE_CLASS_NONE;    // Active
+
+        // Gang Assist Modules Subgroup:
+        case EVEDB::invGroups::Gang_Coordinator:                        return MODULE_CLASS_NONE;    // Active
+        case EVEDB::invGroups::Siege_Module:                            return MODULE_CLASS_NONE;    // Active
+        case EVEDB::invGroups::Data_Miners:                             return MODULE_CLASS_NONE;    // Active
+        case EVEDB::invGroups::Jump_Portal_Generator:                   return MODULE_CLASS_NONE;    // Active
+        case EVEDB::invGroups::Cynosural_Field:                         return MODULE_CLASS_NONE;    // Active
+        case EVEDB::invGroups::Clone_Vat_Bay:                           return MODULE_CLASS_PASSIVE;
+
+        // Mining Modules Subgroup:
+        case EVEDB::invGroups::Mining_Laser:                            return MODULE_CLASS_NONE;    // Active
+        case EVEDB::invGroups::Strip_Miner:                             return MODULE_CLASS_NONE;    // Active
+        case EVEDB::invGroups::Frequency_Mining_Laser:                  return MODULE_CLASS_NONE;    // Active
+        case EVEDB::invGroups::Mining_Upgrade:                          return MODULE_CLASS_PASSIVE;
+        case EVEDB::invGroups::Gas_Cloud_Harvester:                     return MODULE_CLASS_NONE;    // Active
+
+        // Propulsion Modules Subgroup:
+        case EVEDB::invGroups::Afterburner:                             return MODULE_CLASS_AFTERBURNER;
+        case EVEDB::invGroups::Warp_Core_Stabilizer:                    return MODULE_CLASS_PASSIVE;
+        case EVEDB::invGroups::Inertial_Stabilizer:                     return MODULE_CLASS_PASSIVE;
+        case EVEDB::invGroups::Nanofiber_Internal_Structure:            return MODULE_CLASS_PASSIVE;
+        case EVEDB::invGroups::Overdrive_Injector_System:               return MODULE_CLASS_PASSIVE;
+
+        // Shield Modules Subgroup:
+        case EVEDB::invGroups::Shield_Extender:                         return MODULE_CLASS_PASSIVE;
+        case EVEDB::invGroups::Shield_Recharger:                        return MODULE_CLASS_PASSIVE;
+        case EVEDB::invGroups::Shield_Booster:                          return MODULE_CLASS_NONE;    // Active
+        case EVEDB::invGroups::Shield_Transporter:                      return MODULE_CLASS_NONE;    // Active
+        case EVEDB::invGroups::Shield_Power_Relay:                      return MODULE_CLASS_PASSIVE;
+        case EVEDB::invGroups::Shield_Hardener:                         return MODULE_CLASS_NONE;    // Active
+        case EVEDB::invGroups::Shield_Amplifier:                        return MODULE_CLASS_PASSIVE;
+        case EVEDB::invGroups::Shield_Boost_Amplifier:                  return MODULE_CLASS_PASSIVE;
+        case EVEDB::invGroups::Shield_Disruptor:                        return MODULE_CLASS_NONE;    // Active
+
+        // Weapon Modules Subgroup:
+        case EVEDB::invGroups::Energy_Weapon:                           return MODULE_CLASS_ACTIVE;    // Active
+        case EVEDB::invGroups::Projectile_Weapon:                       return MODULE_CLASS_ACTIVE;    // Active
+        case EVEDB::invGroups::Gyrostabilizer:                          return MODULE_CLASS_PASSIVE;
+        case EVEDB::invGroups::Energy_Vampire:                          return MODULE_CLASS_NONE;    // Active
+        case EVEDB::invGroups::Energy_Destabilizer:                     return MODULE_CLASS_NONE;    // Active
+        case EVEDB::invGroups::Smart_Bomb:                              return MODULE_CLASS_NONE;    // Active
+        case EVEDB::invGroups::Hybrid_Weapon:                           return MODULE_CLASS_ACTIVE;   // Active
+        case EVEDB::invGroups::Heat_Sink:                               return MODULE_CLASS_PASSIVE;
+        case EVEDB::invGroups::Magnetic_Field_Stabilizer:               return MODULE_CLASS_PASSIVE;
+        case EVEDB::invGroups::Ballistic_Control_system:                return MODULE_CLASS_PASSIVE;
+        case EVEDB::invGroups::Missile_Launcher_Snowball:               return MODULE_CLASS_NONE;    // Active
+        case EVEDB::invGroups::Missile_Launcher_Cruise:                 return MODULE_CLASS_NONE;    // Active
+        case EVEDB::invGroups::Missile_Launcher_Rocket:                 return MODULE_CLASS_NONE;    // Active
+        case EVEDB::invGroups::Missile_Launcher_Siege:                  return MODULE_CLASS_NONE;    // Active
+        case EVEDB::invGroups::Missile_Launcher_Standard:               return MODULE_CLASS_NONE;    // Active
+        case EVEDB::invGroups::Missile_Launcher_Heavy:                  return MODULE_CLASS_NONE;    // Active
+        case EVEDB::invGroups::Missile_Launcher_Assault:                return MODULE_CLASS_NONE;    // Active
+        case EVEDB::invGroups::Missile_Launcher_Defender:               return MODULE_CLASS_NONE;    // Active
+        case EVEDB::invGroups::Missile_Launcher_Citadel:                return MODULE_CLASS_NONE;    // Active
+        case EVEDB::invGroups::Super_Weapon:                            return MODULE_CLASS_NONE;    // Active
+        case EVEDB::invGroups::Interdiction_Sphere_Launcher:            return MODULE_CLASS_NONE;    // Active
+        case EVEDB::invGroups::Missile_Launcher_Heavy_Assault:          return MODULE_CLASS_ACTIVE;    // Active
+        case EVEDB::invGroups::Missile_Launcher_Bomb:                   return MODULE_CLASS_NONE;    // Active
+        case EVEDB::invGroups::Warp_Disrupt_Field_Generator:            return MODULE_CLASS_NONE;    // Active
+
+
+        // Uncategorized and Unknown Modules Groups (some of these groups contain NO REAL typeIDs in the 'invTypes' table:
+        case EVEDB::invGroups::Computer_Interface_Node:                 return MODULE_CLASS_NONE;
+        case EVEDB::invGroups::GM_Modules:                              return MODULE_CLASS_NONE;
+        case EVEDB::invGroups::Cruise_Control:                          return MODULE_CLASS_NONE;
+        case EVEDB::invGroups::Smartbomb_Supercharger:                  return MODULE_CLASS_NONE;
+        case EVEDB::invGroups::Anti_Ballistic_Defense_System:           return MODULE_CLASS_NONE;
+        case EVEDB::invGroups::Microwarpdrive:                          return MODULE_CLASS_NONE;
+        case EVEDB::invGroups::New_EW_Testing:                          return MODULE_CLASS_NONE;
+        case EVEDB::invGroups::Missile_Launcher:                        return MODULE_CLASS_NONE;
+        case EVEDB::invGroups::Countermeasure_Launcher:                 return MODULE_CLASS_NONE;
+        case EVEDB::invGroups::Anti_Cloaking_Pulse:                     return MODULE_CLASS_NONE;
+        case EVEDB::invGroups::Signature_Scrambling:                    return MODULE_CLASS_NONE;
+        case EVEDB::invGroups::Energy_Vampire_Slayer:                   return MODULE_CLASS_NONE;
+        case EVEDB::invGroups::Cheat_Module_Group:                      return MODULE_CLASS_NONE;
+        case EVEDB::invGroups::Autopilot:                               return MODULE_CLASS_NONE;
+        case EVEDB::invGroups::DroneBayExpander:                        return MODULE_CLASS_NONE;
+        case EVEDB::invGroups::Drone_Modules:                           return MODULE_CLASS_NONE;
+        case EVEDB::invGroups::Navigation_Computer:                     return MODULE_CLASS_NONE;
+        case EVEDB::invGroups::Super_Gang_Enhancer:                     return MODULE_CLASS_NONE;
+        case EVEDB::invGroups::Drone_Damage_Modules:                    return MODULE_CLASS_NONE;
+        case EVEDB::invGroups::ECM_Enhancer:                            return MODULE_CLASS_NONE;
+        case EVEDB::invGroups::Cloak_Enhancements:                      return MODULE_CLASS_NONE;
+        case EVEDB::invGroups::Mining_Enhancer:                         return MODULE_CLASS_NONE;
+        case EVEDB::invGroups::Covert_Cynosural_Field_Generator:        return MODULE_CLASS_NONE;
+
+
+        /************************************/
+        /*              Rigs                */
+        /************************************/
+
+        case EVEDB::invGroups::Rig_Armor:                               return MODULE_CLASS_RIG;
+        case EVEDB::invGroups::Rig_Shield:                              return MODULE_CLASS_RIG;
+        case EVEDB::invGroups::Rig_Energy_Weapon:                       return MODULE_CLASS_RIG;
+        case EVEDB::invGroups::Rig_Hybrid_Weapon:                       return MODULE_CLASS_RIG;
+        case EVEDB::invGroups::Rig_Projectile_Weapon:                   return MODULE_CLASS_RIG;
+        case EVEDB::invGroups::Rig_Drones:                              return MODULE_CLASS_RIG;
+        case EVEDB::invGroups::Rig_Launcher:                            return MODULE_CLASS_RIG;
+        case EVEDB::invGroups::Rig_Electronics:                         return MODULE_CLASS_RIG;
+        case EVEDB::invGroups::Rig_Energy_Grid:                         return MODULE_CLASS_RIG;
+        case EVEDB::invGroups::Rig_Astronautic:                         return MODULE_CLASS_RIG;
+        case EVEDB::invGroups::Rig_Electronics_Superiority:             return MODULE_CLASS_RIG;
+        case EVEDB::invGroups::Rig_Mining:                              return MODULE_CLASS_RIG;
+        case EVEDB::invGroups::Rig_Security_Transponder:                return MODULE_CLASS_RIG;
+
+
+        /************************************/
+        /*        SubSystem Modules         */
+        /************************************/
+        case EVEDB::invGroups::Defensive_Systems:                       return MODULE_CLASS_SUBSYSTEM;
+        case EVEDB::invGroups::Electronic_Systems:                      return MODULE_CLASS_SUBSYSTEM;
+        case EVEDB::invGroups::Offensive_Systems:                       return MODULE_CLASS_SUBSYSTEM;
+        case EVEDB::invGroups::Propulsion_Systems:                      return MODULE_CLASS_SUBSYSTEM;
+        case EVEDB::invGroups::Engineering_Systems:                     return MODULE_CLASS_SUBSYSTEM;
+
+
+        default:
+            break;
+    }
+
+    return MODULE_CLASS_NONE;
+}
+
+
+// ////////////////////// ModuleTypeTable Class ////////////////////////////
+
+ModuleTypeTable::ModuleTypeTable()
+{
+}
+
+ModuleTypeTable::~ModuleTypeTable()
+{
+    std::map<uint32, ModuleType *>::iterator cur, end;
+    cur = m_Types.begin();
+    end = m_Types.end();
+    for(; cur != end; cur++)
+        delete cur->second;
+}
+
+const ModuleType * ModuleTypeTable::GetModuleType(const InventoryItem & item)
+{
+    std::map<uint32, ModuleType *>::iterator res = m_Types.find(item.typeID());
+    if( res != m_Types.end() )
+        return res->second;
+
+    // First module of this type, so build its type data for all of them:
+    ModuleType * type = new ModuleType(item.typeID(), item.groupID(), item.categoryID());
+    m_Types.insert(std::pair<uint32, ModuleType *>(item.typeID(), type));
+    return type;
+}
@@ -31,7 +31,7 @@ PassiveModule::PassiveModule(InventoryItemRef item, ShipRef ship)
 {
     m_Item = item;
     m_Ship = ship;
-    m_Effects = new ModuleEffects(m_Item->typeID());
+    m_Type = sModuleTypeTable.GetModuleType(*item);
     m_ShipAttrComp = new ModifyShipAttributesComponent(this, ship);
 
     m_Module_State = MOD_UNFITTED;
@@ -41,11 +41,10 @@ PassiveModule::PassiveModule(InventoryItemRef item, ShipRef ship)
 PassiveModule::~PassiveModule()
 {
     //delete members
-    delete m_Effects;
     delete m_ShipAttrComp;
 
     //null ptrs
-    m_Effects = NULL;
+    m_Type = NULL;
     m_ShipAttrComp = NULL;
 }
 
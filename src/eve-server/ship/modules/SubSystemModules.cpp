@@ -31,18 +31,17 @@ SubSystemModule::SubSystemModule(InventoryItemRef item, ShipRef ship)
 {
     m_Item = item;
     m_Ship = ship;
-    m_Effects = new ModuleEffects(m_Item->typeID());
+    m_Type = sModuleTypeTable.GetModuleType(*item);
     m_ShipAttrComp = new ModifyShipAttributesComponent(this, ship);
 }
 
 SubSystemModule::~SubSystemModule()
 {
     //delete members
-    delete m_Effects;
     delete m_ShipAttrComp;
 
     //null ptrs
-    m_Effects = NULL;
+    m_Type = NULL;
     m_ShipAttrComp = NULL;
 }
 
@@ -40,21 +40,24 @@ ActiveModuleProcessingComponent::~ActiveModuleProcessingComponent()
     //nothing to do yet
 }
 
+void ActiveModuleProcessingComponent::ActivateCycle()
+{
+    m_Stop = false;
+}
+
 void ActiveModuleProcessingComponent::DeactivateCycle()
 {
     m_Stop = true;
 }
 
-//timing and verification function
+//verification function, called by the owner at the end of each cycle;
+//the cycle timing itself is kept by the owner's timer
 bool ActiveModuleProcessingComponent::ShouldProcessActiveCycle()
 {
-    //first check time for cycle timer
-
-    //next check that we have enough capacitor avaiable
+    //check that we have enough capacitor avaiable
 
     //finally check if we have been told to deactivate
-
-    return false;
+    return !m_Stop;
 }
 
 void ActiveModuleProcessingComponent::ProcessActiveCycle()
@@ -89,15 +89,15 @@ EvilNumber ModifyShipAttributesComponent::_calculateNewValue(uint32 targetAttrID
     if( !(m_Mod->isOnline()) )
         mods.push_back(m_Mod);
 
-    std::vector<GenericModule *> sortedMods = _sortModules(targetAttrID, mods);
+    std::vector<GenericModule *> sortedMods = _sortModules(sourceAttrID, mods);
 
     EvilNumber finalVal;
     EvilNumber startVal = m_Ship->GetAttribute(targetAttrID);  //start value
 
     //iterate through all the modules, largest first
-    for(uint32 i = 0; i < mods.size(); i++)
+    for(uint32 i = 0; i < sortedMods.size(); i++)
     {
-        finalVal = _calculateNewAttributeValue(mods[i]->GetAttribute(sourceAttrID), startVal, type, i );
+        finalVal = _calculateNewAttributeValue(sortedMods[i]->GetAttribute(sourceAttrID), startVal, type, i );
         startVal = finalVal; //set the starting value as the calculated value
     }
 
@@ -108,34 +108,26 @@ EvilNumber ModifyShipAttributesComponent::_calculateNewValue(uint32 targetAttrID
 //calculate the new value including the stacking penalty
 EvilNumber ModifyShipAttributesComponent::_calculateNewAttributeValue( EvilNumber sourceAttr, EvilNumber targetAttr, EVECalculationType type, int stackNumber )
 {
-    EvilNumber effectiveness = exp(-pow((double)(stackNumber - 1),2)/7.1289);  //should be correct, but should be checked
+    EvilNumber effectiveness = ModifierGraph::GetStackingPenalty(stackNumber);  //precomputed, the first one is not penalized
     return CalculateNewAttributeValue(targetAttr, sourceAttr * effectiveness, type);
 }
 
-//sorts a vector of modules in descending order by arbitrary attribute.  That is array[0] > array[1]
-std::vector<GenericModule *> ModifyShipAttributesComponent::_sortModules(uint32 sortAttrID, std::vector<GenericModule *> mods)
+//orders modules by an attribute, largest first
+class ModuleAttributeGreater
 {
+public:
+    ModuleAttributeGreater(uint32 attrID) : m_AttrID( attrID ) {}
 
-    //begin basic bubble sort - this needs to be checked thoroughly for bugs
-    bool done = false;
+    bool operator()(GenericModule * a, GenericModule * b) const { return a->GetAttribute(m_AttrID) > b->GetAttribute(m_AttrID); }
 
-    while(!done)  //check if sorted
-    {
-        done = true;  //assume sorted
-
-        for( int i = 0; i != mods.size() + 1; i++)  //iterate though list
-        {
-            if( mods[i]->GetAttribute(sortAttrID) > mods[i+1]->GetAttribute(sortAttrID) )  //check if each pair is sorted
-            {
-                //it's not, so flip the values
-                GenericModule * tmp = mods[i];
-                mods[i] = mods[i+1];
-                mods[i] = tmp;
-
-                done = false;  //we weren't sorted, so now go back and check if we are
-            }
-        }
-    }
+private:
+    uint32 m_AttrID;
+};
+
+//sorts a vector of modules in descending order by arbitrary attribute.  That is array[0] > array[1]
+std::vector<GenericModule *> ModifyShipAttributesComponent::_sortModules(uint32 sortAttrID, std::vector<GenericModule *> mods)
+{
+    std::stable_sort(mods.begin(), mods.end(), ModuleAttributeGreater(sortAttrID));
 
     return mods;  //return sorted list
 }
@@ -31,8 +31,9 @@ Afterburner::Afterburner( InventoryItemRef item, ShipRef ship )
 {
     m_Item = item;
     m_Ship = ship;
-    m_Effects = new ModuleEffects(m_Item->typeID());
+    m_Type = sModuleTypeTable.GetModuleType(*item);
     m_ShipAttrComp = new ModifyShipAttributesComponent(this, ship);
+    m_ActiveModuleProcComp = new ActiveModuleProcessingComponent(this, ship, m_ShipAttrComp);
 }
 
 Afterburner::~Afterburner()
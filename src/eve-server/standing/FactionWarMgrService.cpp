@@ -28,12 +28,14 @@
 #include "PyServiceCD.h"
 #include "cache/ObjCacheService.h"
 #include "standing/FactionWarMgrService.h"
+#include "standing/SovereigntyTable.h"
 
 PyCallable_Make_InnerDispatcher(FactionWarMgrService)
 
 FactionWarMgrService::FactionWarMgrService(PyServiceMgr *mgr)
 : PyService(mgr, "facWarMgr"),
-  m_dispatch(new Dispatcher(this))
+  m_dispatch(new Dispatcher(this)),
+  m_facWarSystemsVersion(0)
 {
     _SetCallDispatcher(m_dispatch);
 
@@ -65,13 +67,13 @@ PyResult FactionWarMgrService::Handle_GetFWSystems( PyCallArgs& call )
 {
     ObjectCachedMethodID method_id( GetName(), "GetFacWarSystems" );
 
-    if( !m_manager->cache_service->IsCacheLoaded( method_id ) )
+    //a new version of the cached object goes out whenever an occupier changes.
+    if( !m_manager->cache_service->IsCacheLoaded( method_id )
+        || m_facWarSystemsVersion != sSovereigntyTable.GetVersion() )
     {
-        PyRep* res = m_db.GetWarFactions();
-        if( res == NULL )
-            return NULL;
-
+        PyRep* res = sSovereigntyTable.GetFacWarSystems();
         m_manager->cache_service->GiveCache( method_id, &res );
+        m_facWarSystemsVersion = sSovereigntyTable.GetVersion();
     }
 
     return m_manager->cache_service->MakeObjectCachedMethodCallResult( method_id );
@@ -86,7 +88,7 @@ PyResult FactionWarMgrService::Handle_GetMyCharacterRankOverview( PyCallArgs& ca
         return NULL;
     }
 
-    sLog.Debug( "FactionWarMgrService", "Called GetMyCharacterRankOverview stub." );
+    _debug( "FactionWarMgrService", "Called GetMyCharacterRankOverview stub." );
 
     util_Rowset rs;
 
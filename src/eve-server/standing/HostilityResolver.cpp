@@ -0,0 +1,447 @@
+/*
+    ------------------------------------------------------------------------------------
+    LICENSE:
+    ------------------------------------------------------------------------------------
+    This file is part of EVEmu: EVE Online Server Emulator
+    Copyright 2006 - 2011 The EVEmu Team
+    For the latest information visit http://evemu.org
+    ------------------------------------------------------------------------------------
+    This program is free software; you can redistribute it and/or modify it under
+    the terms of the GNU Lesser General Public License as published by the Free Software
+    Foundation; either version 2 of the License, or (at your option) any later
+    version.
+
+    This program is distributed in the hope that it will be useful, but WITHOUT
+    ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+    FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public License along with
+    this program; if not, write to the Free Software Foundation, Inc., 59 Temple
+    Place - Suite 330, Boston, MA 02111-1307, USA, or go to
+    http://www.gnu.org/copyleft/lesser.txt.
+    ------------------------------------------------------------------------------------
+    Author:     EVEmu Team
+*/
+
+
+#include "eve-server.h"
+
+#include "Client.h"
+#include "standing/HostilityResolver.h"
+
+HostilityResolver::HostilityResolver()
+{
+}
+
+bool HostilityResolver::Load()
+{
+    DBQueryResult res;
+    DBResultRow row;
+
+    if( !sDatabase.RunQuery( res,
+        "SELECT militiaCorporationID, factionID"
+        " FROM chrFactions"
+        " WHERE militiaCorporationID IS NOT NULL" ) )
+    {
+        sLog.Error( "HostilityResolver", "Failed to load the militias: %s.", res.error.c_str() );
+        return false;
+    }
+
+    mMilitias.clear();
+    while( res.GetRow( row ) )
+        mMilitias[ row.GetUInt( 0 ) ] = row.GetUInt( 1 );
+
+    if( !sDatabase.RunQuery( res,
+        "SELECT warID, declaredByID, againstID, timeDeclared, billID, mutual"
+        " FROM crpWars"
+        " WHERE timeFinished = 0" ) )
+    {
+        sLog.Error( "HostilityResolver", "Failed to load the wars: %s.", res.error.c_str() );
+        return false;
+    }
+
+    mWars.clear();
+    mWarPairs.clear();
+    mOwnerWars.clear();
+    while( res.GetRow( row ) )
+    {
+        War war;
+        war.declaredByID = row.GetUInt( 1 );
+        war.againstID = row.GetUInt( 2 );
+        war.timeDeclared = row.GetUInt64( 3 );
+        war.billID = row.GetUInt( 4 );
+        war.mutual = row.GetBool( 5 );
+
+        _AddWar( row.GetUInt( 0 ), war );
+    }
+
+    if( !sDatabase.RunQuery( res,
+        "SELECT fromID, toID, expiryDate"
+        " FROM chrKillRights"
+        " WHERE expiryDate > %" PRIu64,
+        Win32TimeNow() ) )
+    {
+        sLog.Error( "HostilityResolver", "Failed to load the kill rights: %s.", res.error.c_str() );
+        return false;
+    }
+
+    mKillRights.clear();
+    mRightsHeld.clear();
+    mRightsOn.clear();
+    while( res.GetRow( row ) )
+    {
+        const uint32 fromID = row.GetUInt( 0 );
+        const uint32 toID = row.GetUInt( 1 );
+
+        mKillRights[ _RightKey( fromID, toID ) ] = row.GetUInt64( 2 );
+        mRightsHeld[ fromID ].insert( toID );
+        mRightsOn[ toID ].insert( fromID );
+    }
+
+    return true;
+}
+
+HostilityResolver::Hostility HostilityResolver::GetHostility( uint32 attackerID, uint32 attackerCorpID, uint32 attackerAllianceID,
+                                                              uint32 targetID, uint32 targetCorpID, uint32 targetAllianceID )
+{
+    ++mStats.checks;
+
+    Hostility result = HOSTILITY_NONE;
+
+    if( !mWarPairs.empty() )
+    {
+        const uint32 attackerOwners[] = { attackerCorpID, attackerAllianceID };
+        const uint32 targetOwners[] = { targetCorpID, targetAllianceID };
+
+        for( size_t a = 0; a < 2 && HOSTILITY_NONE == result; ++a )
+        {
+            for( size_t t = 0; t < 2; ++t )
+            {
+                if( 0 != attackerOwners[ a ] && 0 != targetOwners[ t ] && AtWar( attackerOwners[ a ], targetOwners[ t ] ) )
+                {
+                    result = HOSTILITY_WAR;
+                    break;
+                }
+            }
+        }
+    }
+
+    if( HOSTILITY_NONE == result )
+    {
+        const uint32 attackerFactionID = GetWarFactionID( attackerCorpID );
+        if( 0 != attackerFactionID && _FactionsAtWar( attackerFactionID, GetWarFactionID( targetCorpID ) ) )
+            result = HOSTILITY_FACTION_WAR;
+    }
+
+    if( HOSTILITY_NONE == result )
+    {
+        std::tr1::unordered_map< uint64, uint64 >::const_iterator res = mKillRights.find( _RightKey( attackerID, targetID ) );
+        if( res != mKillRights.end() )
+        {
+            if( res->second > Win32TimeNow() )
+                result = HOSTILITY_KILL_RIGHT;
+            else
+                RemoveKillRight( attackerID, targetID );
+        }
+    }
+
+    if( HOSTILITY_NONE != result )
+        ++mStats.hostile;
+
+    return result;
+}
+
+HostilityResolver::Hostility HostilityResolver::GetHostility( const Client& attacker, const Client& target )
+{
+    return GetHostility( attacker.GetCharacterID(), attacker.GetCorporationID(), attacker.GetAllianceID(),
+                         target.GetCharacterID(), target.GetCorporationID(), target.GetAllianceID() );
+}
+
+bool HostilityResolver::AtWar( uint32 ownerID, uint32 otherID ) const
+{
+    return mWarPairs.find( _PairKey( ownerID, otherID ) ) != mWarPairs.end();
+}
+
+uint32 HostilityResolver::GetWarFactionID( uint32 corporationID ) const
+{
+    std::tr1::unordered_map< uint32, uint32 >::const_iterator res = mMilitias.find( corporationID );
+    if( res == mMilitias.end() )
+        return 0;
+
+    return res->second;
+}
+
+uint32 HostilityResolver::DeclareWar( uint32 declaredByID, uint32 againstID, bool mutual )
+{
+    War war;
+    war.declaredByID = declaredByID;
+    war.againstID = againstID;
+    war.timeDeclared = Win32TimeNow();
+    war.billID = 0;
+    war.mutual = mutual;
+
+    DBerror err;
+    uint32 warID;
+    if( !sDatabase.RunQueryLID( err, warID,
+        "INSERT INTO crpWars"
+        " (declaredByID, againstID, timeDeclared, timeFinished, retracted, retractedBy, billID, mutual)"
+        " VALUES (%u, %u, %" PRIu64 ", 0, 0, 0, 0, %u)",
+        declaredByID, againstID, war.timeDeclared, mutual ? 1 : 0 ) )
+    {
+        sLog.Error( "HostilityResolver", "Failed to declare war of %u against %u: %s.", declaredByID, againstID, err.c_str() );
+        return 0;
+    }
+
+    _AddWar( warID, war );
+    ++mStats.updates;
+
+    return warID;
+}
+
+void HostilityResolver::EndWar( uint32 warID, uint32 retractedBy )
+{
+    std::tr1::unordered_map< uint32, War >::iterator res = mWars.find( warID );
+    if( res == mWars.end() )
+        return;
+
+    const uint64 now = Win32TimeNow();
+
+    DBerror err;
+    if( !sDatabase.RunQuery( err,
+        "UPDATE crpWars"
+        " SET timeFinished = %" PRIu64 ", retracted = %" PRIu64 ", retractedBy = %u"
+        " WHERE warID = %u",
+        now, 0 == retractedBy ? 0 : now, retractedBy, warID ) )
+    {
+        sLog.Error( "HostilityResolver", "Failed to end war %u: %s.", warID, err.c_str() );
+        return;
+    }
+
+    const War& war = res->second;
+
+    std::tr1::unordered_map< uint64, uint32 >::iterator pair = mWarPairs.find( _PairKey( war.declaredByID, war.againstID ) );
+    if( pair != mWarPairs.end() && 0 == --pair->second )
+        mWarPairs.erase( pair );
+
+    IDSetMap::iterator owner = mOwnerWars.find( war.declaredByID );
+    if( owner != mOwnerWars.end() )
+    {
+        owner->second.erase( warID );
+        if( owner->second.empty() )
+            mOwnerWars.erase( owner );
+    }
+    owner = mOwnerWars.find( war.againstID );
+    if( owner != mOwnerWars.end() )
+    {
+        owner->second.erase( warID );
+        if( owner->second.empty() )
+            mOwnerWars.erase( owner );
+    }
+
+    mWars.erase( res );
+    ++mStats.updates;
+}
+
+void HostilityResolver::AddKillRight( uint32 fromID, uint32 toID, uint64 expiryDate )
+{
+    DBerror err;
+    if( !sDatabase.RunQuery( err,
+        "REPLACE INTO chrKillRights"
+        " (fromID, toID, expiryDate)"
+        " VALUES (%u, %u, %" PRIu64 ")",
+        fromID, toID, expiryDate ) )
+    {
+        sLog.Error( "HostilityResolver", "Failed to give %u a kill right on %u: %s.", fromID, toID, err.c_str() );
+        return;
+    }
+
+    mKillRights[ _RightKey( fromID, toID ) ] = expiryDate;
+    mRightsHeld[ fromID ].insert( toID );
+    mRightsOn[ toID ].insert( fromID );
+    ++mStats.updates;
+}
+
+void HostilityResolver::RemoveKillRight( uint32 fromID, uint32 toID )
+{
+    if( mKillRights.find( _RightKey( fromID, toID ) ) == mKillRights.end() )
+        return;
+
+    DBerror err;
+    if( !sDatabase.RunQuery( err,
+        "DELETE FROM chrKillRights"
+        " WHERE fromID = %u AND toID = %u",
+        fromID, toID ) )
+    {
+        sLog.Error( "HostilityResolver", "Failed to remove the kill right of %u on %u: %s.", fromID, toID, err.c_str() );
+    }
+
+    _RemoveKillRight( fromID, toID );
+    ++mStats.updates;
+}
+
+void HostilityResolver::RemoveCharacter( uint32 characterID )
+{
+    DBerror err;
+    if( !sDatabase.RunQuery( err,
+        "DELETE FROM chrKillRights"
+        " WHERE fromID = %u OR toID = %u",
+        characterID, characterID ) )
+    {
+        sLog.Error( "HostilityResolver", "Failed to remove the kill rights of %u: %s.", characterID, err.c_str() );
+    }
+
+    IDSetMap::iterator res = mRightsHeld.find( characterID );
+    if( res != mRightsHeld.end() )
+    {
+        const std::set< uint32 > targets = res->second;
+
+        std::set< uint32 >::const_iterator cur, end;
+        cur = targets.begin();
+        end = targets.end();
+        for(; cur != end; ++cur )
+            _RemoveKillRight( characterID, *cur );
+    }
+
+    res = mRightsOn.find( characterID );
+    if( res != mRightsOn.end() )
+    {
+        const std::set< uint32 > holders = res->second;
+
+        std::set< uint32 >::const_iterator cur, end;
+        cur = holders.begin();
+        end = holders.end();
+        for(; cur != end; ++cur )
+            _RemoveKillRight( *cur, characterID );
+    }
+}
+
+PyObject* HostilityResolver::EncodeWars( uint32 ownerID ) const
+{
+    util_IndexRowset irowset;
+
+    irowset.header.push_back( "warID" );
+    irowset.header.push_back( "declaredByID" );
+    irowset.header.push_back( "againstID" );
+    irowset.header.push_back( "timeDeclared" );
+    irowset.header.push_back( "timeFinished" );
+    irowset.header.push_back( "retracted" );
+    irowset.header.push_back( "retractedBy" );
+    irowset.header.push_back( "billID" );
+    irowset.header.push_back( "mutual" );
+
+    irowset.idName = "warID";
+
+    IDSetMap::const_iterator res = mOwnerWars.find( ownerID );
+    if( res != mOwnerWars.end() )
+    {
+        std::set< uint32 >::const_iterator cur, end;
+        cur = res->second.begin();
+        end = res->second.end();
+        for(; cur != end; ++cur )
+        {
+            const War& war = mWars.find( *cur )->second;
+
+            // the wars loaded or declared are active: not finished nor retracted
+            PyList* line = new PyList( 9 );
+            line->SetItem( 0, new PyInt( *cur ) );
+            line->SetItem( 1, new PyInt( war.declaredByID ) );
+            line->SetItem( 2, new PyInt( war.againstID ) );
+            line->SetItem( 3, new PyLong( war.timeDeclared ) );
+            line->SetItem( 4, new PyNone );
+            line->SetItem( 5, new PyNone );
+            line->SetItem( 6, new PyNone );
+            line->SetItem( 7, new PyInt( war.billID ) );
+            line->SetItem( 8, new PyBool( war.mutual ) );
+
+            irowset.items[ *cur ] = line;
+        }
+    }
+
+    return irowset.Encode();
+}
+
+PyTuple* HostilityResolver::EncodeKillRights( uint32 characterID ) const
+{
+    const uint64 now = Win32TimeNow();
+
+    PyDict* held = new PyDict;
+    PyDict* on = new PyDict;
+
+    IDSetMap::const_iterator res = mRightsHeld.find( characterID );
+    if( res != mRightsHeld.end() )
+    {
+        std::set< uint32 >::const_iterator cur, end;
+        cur = res->second.begin();
+        end = res->second.end();
+        for(; cur != end; ++cur )
+        {
+            const uint64 expiryDate = mKillRights.find( _RightKey( characterID, *cur ) )->second;
+            if( expiryDate > now )
+                held->SetItem( new PyInt( *cur ), new PyLong( expiryDate ) );
+        }
+    }
+
+    res = mRightsOn.find( characterID );
+    if( res != mRightsOn.end() )
+    {
+        std::set< uint32 >::const_iterator cur, end;
+        cur = res->second.begin();
+        end = res->second.end();
+        for(; cur != end; ++cur )
+        {
+            const uint64 expiryDate = mKillRights.find( _RightKey( *cur, characterID ) )->second;
+            if( expiryDate > now )
+                on->SetItem( new PyInt( *cur ), new PyLong( expiryDate ) );
+        }
+    }
+
+    return new_tuple( held, on );
+}
+
+bool HostilityResolver::_FactionsAtWar( uint32 factionID, uint32 otherID )
+{
+    // the factional warfare: the Caldari State against the Gallente Federation
+    // and the Amarr Empire against the Minmatar Republic
+    static const uint32 CALDARI_STATE = 500001;
+    static const uint32 MINMATAR_REPUBLIC = 500002;
+    static const uint32 AMARR_EMPIRE = 500003;
+    static const uint32 GALLENTE_FEDERATION = 500004;
+
+    switch( factionID )
+    {
+        case CALDARI_STATE:         return GALLENTE_FEDERATION == otherID;
+        case GALLENTE_FEDERATION:   return CALDARI_STATE == otherID;
+        case AMARR_EMPIRE:          return MINMATAR_REPUBLIC == otherID;
+        case MINMATAR_REPUBLIC:     return AMARR_EMPIRE == otherID;
+        default:                    return false;
+    }
+}
+
+void HostilityResolver::_AddWar( uint32 warID, const War& war )
+{
+    mWars[ warID ] = war;
+    ++mWarPairs[ _PairKey( war.declaredByID, war.againstID ) ];
+    mOwnerWars[ war.declaredByID ].insert( warID );
+    mOwnerWars[ war.againstID ].insert( warID );
+}
+
+void HostilityResolver::_RemoveKillRight( uint32 fromID, uint32 toID )
+{
+    mKillRights.erase( _RightKey( fromID, toID ) );
+
+    IDSetMap::iterator res = mRightsHeld.find( fromID );
+    if( res != mRightsHeld.end() )
+    {
+        res->second.erase( toID );
+        if( res->second.empty() )
+            mRightsHeld.erase( res );
+    }
+
+    res = mRightsOn.find( toID );
+    if( res != mRightsOn.end() )
+    {
+        res->second.erase( fromID );
+        if( res->second.empty() )
+            mRightsOn.erase( res );
+    }
+}
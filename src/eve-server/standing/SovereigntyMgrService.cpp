@@ -29,6 +29,7 @@
 
 #include "PyServiceCD.h"
 #include "standing/SovereigntyMgrService.h"
+#include "standing/SovereigntyTable.h"
 
 PyCallable_Make_InnerDispatcher(SovereigntyMgrService)
 
@@ -46,8 +47,14 @@ SovereigntyMgrService::~SovereigntyMgrService() {
 }
 
 PyResult SovereigntyMgrService::Handle_GetSystemSovereigntyInfo(PyCallArgs &call) {
-    sLog.Debug("Server", "Called GetSystemSovereigntyInfo Stub");
-
+    Call_SingleIntegerArg arg;
+    if(!arg.Decode(&call.tuple)) {
+        _log(SERVICE__ERROR, "Failed to decode args.");
         return NULL;
+    }
 
+    PyRep *res = sSovereigntyTable.GetSovereigntyInfo(arg.arg);
+    if(res == NULL)
+        _log(SERVICE__ERROR, "%s: Unknown solar system %d.", call.client->GetName(), arg.arg);
+    return res;
 }
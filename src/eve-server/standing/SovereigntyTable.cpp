@@ -0,0 +1,269 @@
+/*
+    ------------------------------------------------------------------------------------
+    LICENSE:
+    ------------------------------------------------------------------------------------
+    This file is part of EVEmu: EVE Online Server Emulator
+    Copyright 2006 - 2011 The EVEmu Team
+    For the latest information visit http://evemu.org
+    ------------------------------------------------------------------------------------
+    This program is free software; you can redistribute it and/or modify it under
+    the terms of the GNU Lesser General Public License as published by the Free Software
+    Foundation; either version 2 of the License, or (at your option) any later
+    version.
+
+    This program is distributed in the hope that it will be useful, but WITHOUT
+    ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+    FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public License along with
+    this program; if not, write to the Free Software Foundation, Inc., 59 Temple
+    Place - Suite 330, Boston, MA 02111-1307, USA, or go to
+    http://www.gnu.org/copyleft/lesser.txt.
+    ------------------------------------------------------------------------------------
+    Author:     EVEmu Team
+*/
+
+
+#include "eve-server.h"
+
+#include "EntityList.h"
+#include "standing/SovereigntyTable.h"
+
+SovereigntyTable::SovereigntyTable()
+: mVersion( 0 ),
+  mPushedVersion( 0 ),
+  mFacWarSystems( NULL ),
+  mFacWarVersion( 0 )
+{
+}
+
+SovereigntyTable::~SovereigntyTable()
+{
+    PySafeDecRef( mFacWarSystems );
+}
+
+bool SovereigntyTable::Load()
+{
+    mSystems.clear();
+    mFeed.clear();
+
+    DBQueryResult res;
+    DBResultRow row;
+
+    if( !sDatabase.RunQuery( res,
+        "SELECT mapSolarSystems.solarSystemID, mapSolarSystems.factionID,"
+        "  mapSovereignty.allianceID, mapSovereignty.corporationID, mapSovereignty.claimStructureID,"
+        "  mapSovereignty.hubID, mapSovereignty.claimTime, mapSovereignty.contested, mapSovereignty.occupierID"
+        " FROM mapSolarSystems"
+        "  LEFT JOIN mapSovereignty USING( solarSystemID )" ) )
+    {
+        codelog( SERVICE__ERROR, "Error in query: %s", res.error.c_str() );
+        return false;
+    }
+
+    while( res.GetRow( row ) )
+    {
+        SystemSovereignty& system = mSystems[ row.GetUInt( 0 ) ];
+        system.solarSystemID = row.GetUInt( 0 );
+        system.factionID = ( row.IsNull( 1 ) ? 0 : row.GetUInt( 1 ) );
+        system.allianceID = ( row.IsNull( 2 ) ? 0 : row.GetUInt( 2 ) );
+        system.corporationID = ( row.IsNull( 3 ) ? 0 : row.GetUInt( 3 ) );
+        system.claimStructureID = ( row.IsNull( 4 ) ? 0 : row.GetUInt( 4 ) );
+        system.hubID = ( row.IsNull( 5 ) ? 0 : row.GetUInt( 5 ) );
+        system.claimTime = ( row.IsNull( 6 ) ? 0 : row.GetUInt64( 6 ) );
+        system.contested = ( !row.IsNull( 7 ) && row.GetBool( 7 ) );
+        system.occupierID = ( row.IsNull( 8 ) ? 0 : row.GetUInt( 8 ) );
+    }
+
+    //whatever was built or pushed before is out of date.
+    ++mVersion;
+    mPushedVersion = mVersion;
+    return true;
+}
+
+const SystemSovereignty* SovereigntyTable::Get( uint32 solarSystemID )
+{
+    std::tr1::unordered_map< uint32, SystemSovereignty >::const_iterator res = mSystems.find( solarSystemID );
+    if( res == mSystems.end() )
+        return NULL;
+
+    ++mStats.queries;
+    return &res->second;
+}
+
+PyRep* SovereigntyTable::GetSovereigntyInfo( uint32 solarSystemID )
+{
+    const SystemSovereignty* system = Get( solarSystemID );
+    if( system == NULL )
+        return NULL;
+
+    RspGetSystemSovereigntyInfo rsp;
+    rsp.contested = ( system->contested ? 1 : 0 );
+    rsp.corporationID = system->corporationID;
+    rsp.claimTime = system->claimTime;
+    rsp.claimStructureID = system->claimStructureID;
+    rsp.hubID = system->hubID;
+    rsp.allianceID = system->allianceID;
+    rsp.solarSystemID = system->solarSystemID;
+    return rsp.Encode();
+}
+
+PyDict* SovereigntyTable::GetFacWarSystems()
+{
+    if( mFacWarSystems == NULL || mFacWarVersion != mVersion )
+    {
+        PySafeDecRef( mFacWarSystems );
+        mFacWarSystems = new PyDict;
+        mFacWarVersion = mVersion;
+
+        std::tr1::unordered_map< uint32, SystemSovereignty >::const_iterator cur, end;
+        cur = mSystems.begin();
+        end = mSystems.end();
+        for(; cur != end; ++cur )
+        {
+            const SystemSovereignty& system = cur->second;
+            if( system.occupierID == 0 )
+                continue;
+
+            PyDict* dict = new PyDict;
+            dict->SetItemString( "occupierID", new PyInt( system.occupierID ) );
+            dict->SetItemString( "factionID", new PyInt( system.factionID ) );
+            mFacWarSystems->SetItem( new PyInt( system.solarSystemID ), dict );
+        }
+    }
+
+    PyIncRef( mFacWarSystems );
+    return mFacWarSystems;
+}
+
+bool SovereigntyTable::GetChangesSince( uint64 version, std::vector< uint32 >& into ) const
+{
+    if( version == mVersion )
+        return true;
+    //the feed has to go back to the change right after the known version.
+    if( mFeed.empty() || version + 1 < mFeed.front().version )
+        return false;
+
+    std::deque< Change >::const_iterator cur, end;
+    cur = mFeed.begin();
+    end = mFeed.end();
+    for(; cur != end; ++cur )
+    {
+        if( version < cur->version )
+            into.push_back( cur->solarSystemID );
+    }
+    return true;
+}
+
+bool SovereigntyTable::Claim( uint32 solarSystemID, uint32 allianceID, uint32 corporationID, uint32 claimStructureID )
+{
+    std::tr1::unordered_map< uint32, SystemSovereignty >::iterator res = mSystems.find( solarSystemID );
+    if( res == mSystems.end() )
+        return false;
+
+    SystemSovereignty& system = res->second;
+    if( system.allianceID == allianceID && system.corporationID == corporationID && system.claimStructureID == claimStructureID )
+        return true;
+
+    system.allianceID = allianceID;
+    system.corporationID = corporationID;
+    system.claimStructureID = claimStructureID;
+    system.claimTime = ( allianceID != 0 ? Win32TimeNow() : 0 );
+    return _Changed( system, CHANGE_SOVEREIGNTY );
+}
+
+bool SovereigntyTable::SetContested( uint32 solarSystemID, bool contested )
+{
+    std::tr1::unordered_map< uint32, SystemSovereignty >::iterator res = mSystems.find( solarSystemID );
+    if( res == mSystems.end() )
+        return false;
+
+    SystemSovereignty& system = res->second;
+    if( system.contested == contested )
+        return true;
+
+    system.contested = contested;
+    return _Changed( system, CHANGE_SOVEREIGNTY );
+}
+
+bool SovereigntyTable::Occupy( uint32 solarSystemID, uint32 occupierID )
+{
+    std::tr1::unordered_map< uint32, SystemSovereignty >::iterator res = mSystems.find( solarSystemID );
+    if( res == mSystems.end() )
+        return false;
+
+    SystemSovereignty& system = res->second;
+    if( system.occupierID == occupierID )
+        return true;
+
+    system.occupierID = occupierID;
+    return _Changed( system, CHANGE_OCCUPIER );
+}
+
+void SovereigntyTable::Process()
+{
+    if( mPushedVersion == mVersion )
+        return;
+
+    //a system which changed several times since the last push is notified once per kind.
+    std::set< std::pair< uint32, int > > pushed;
+
+    std::deque< Change >::const_reverse_iterator cur, end;
+    cur = mFeed.rbegin();
+    end = mFeed.rend();
+    for(; cur != end && mPushedVersion < cur->version; ++cur )
+    {
+        if( !pushed.insert( std::make_pair( cur->solarSystemID, (int)cur->kind ) ).second )
+            continue;
+
+        std::vector< Client* > clients;
+        sEntityList.FindBySolarSystemID( cur->solarSystemID, clients );
+        if( clients.empty() )
+            continue;
+
+        const SystemSovereignty& system = mSystems[ cur->solarSystemID ];
+
+        PyTuple* payload = new PyTuple( 2 );
+        payload->SetItem( 0, new PyInt( system.solarSystemID ) );
+        if( cur->kind == CHANGE_SOVEREIGNTY )
+        {
+            payload->SetItem( 1, new PyInt( system.allianceID ) );
+            sEntityList.Multicast( clients, "OnSovereigntyChanged", "solarsystemid2", &payload, false );
+        }
+        else
+        {
+            payload->SetItem( 1, new PyInt( system.occupierID ) );
+            sEntityList.Multicast( clients, "OnSystemOccupierChanged", "solarsystemid2", &payload, false );
+        }
+
+        mStats.notifications += clients.size();
+    }
+
+    mPushedVersion = mVersion;
+}
+
+bool SovereigntyTable::_Changed( const SystemSovereignty& system, ChangeKind kind )
+{
+    Change change;
+    change.version = ++mVersion;
+    change.solarSystemID = system.solarSystemID;
+    change.kind = kind;
+    mFeed.push_back( change );
+    if( FEED_LENGTH < mFeed.size() )
+        mFeed.pop_front();
+
+    ++mStats.changes;
+
+    DBerror err;
+    if( !sDatabase.RunQuery( err,
+        "REPLACE INTO mapSovereignty"
+        " (solarSystemID, allianceID, corporationID, claimStructureID, hubID, claimTime, contested, occupierID)"
+        " VALUES (%u, %u, %u, %u, %u, %" PRIu64 ", %u, %u)",
+        system.solarSystemID, system.allianceID, system.corporationID, system.claimStructureID,
+        system.hubID, system.claimTime, ( system.contested ? 1 : 0 ), system.occupierID ) )
+    {
+        codelog( SERVICE__ERROR, "Error in query: %s", err.c_str() );
+        return false;
+    }
+    return true;
+}
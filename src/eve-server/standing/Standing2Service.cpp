@@ -27,7 +27,9 @@
 
 #include "PyServiceCD.h"
 #include "cache/ObjCacheService.h"
+#include "standing/HostilityResolver.h"
 #include "standing/Standing2Service.h"
+#include "standing/StandingCache.h"
 
 PyCallable_Make_InnerDispatcher(Standing2Service)
 
@@ -51,18 +53,14 @@ Standing2Service::~Standing2Service() {
     delete m_dispatch;
 }
 
+void Standing2Service::PrimeCache() {
+    ObjectCachedMethodID method_id(GetName(), "GetNPCNPCStandings");
+    _CacheNPCNPCStandings(method_id);
+}
 
-PyResult Standing2Service::Handle_GetMyKillRights(PyCallArgs &call) {
-    PyRep *result = NULL;
-
-    PyTuple *tu = new PyTuple(2);
-    PyDict *u1 = new PyDict();
-    PyDict *u2 = new PyDict();
-    tu->items[0] = u1;
-    tu->items[1] = u2;
-    result = tu;
 
-    return result;
+PyResult Standing2Service::Handle_GetMyKillRights(PyCallArgs &call) {
+    return sHostilityResolver.EncodeKillRights(call.client->GetCharacterID());
 }
 
 PyResult Standing2Service::Handle_GetMyStandings(PyCallArgs &call) {
@@ -72,9 +70,9 @@ PyResult Standing2Service::Handle_GetMyStandings(PyCallArgs &call) {
     PyRep *charprime;
     PyRep *npccharstandings;
 
-    charstandings = m_db.GetCharStandings(call.client->GetCharacterID());
+    charstandings = sStandingCache.EncodeCharStandings(call.client->GetCharacterID());
     charprime = m_db.GetCharPrimeStandings(call.client->GetCharacterID());
-    npccharstandings = m_db.GetCharNPCStandings(call.client->GetCharacterID());
+    npccharstandings = sStandingCache.EncodeCharNPCStandings(call.client->GetCharacterID());
 
     PyDict *corpstandings = new PyDict();
     PyDict *corpprime = new PyDict();
@@ -93,19 +91,21 @@ PyResult Standing2Service::Handle_GetMyStandings(PyCallArgs &call) {
 }
 
 
-PyResult Standing2Service::Handle_GetNPCNPCStandings(PyCallArgs &call) {
-    PyRep *result = NULL;
-
-    ObjectCachedMethodID method_id(GetName(), "GetNPCNPCStandings");
-
+void Standing2Service::_CacheNPCNPCStandings(const ObjectCachedMethodID &method_id) {
     //check to see if this method is in the cache already.
     if(!m_manager->cache_service->IsCacheLoaded(method_id)) {
         //this method is not in cache yet, load up the contents and cache it.
-        result = m_db.GetNPCStandings();
-        if(result == NULL)
-            result = new PyNone();
+        PyRep *result = sStandingCache.EncodeNPCStandings();
         m_manager->cache_service->GiveCache(method_id, &result);
     }
+}
+
+PyResult Standing2Service::Handle_GetNPCNPCStandings(PyCallArgs &call) {
+    PyRep *result = NULL;
+
+    ObjectCachedMethodID method_id(GetName(), "GetNPCNPCStandings");
+
+    _CacheNPCNPCStandings(method_id);
 
     //now we know its in the cache one way or the other, so build a
     //cached object cached method call result.
@@ -147,7 +147,7 @@ PyResult Standing2Service::Handle_GetCharStandings(PyCallArgs &call) {
     ObjectCachedSessionMethodID method_id(GetName(), "GetCharStandings", call.client->GetCharacterID());
 
     if(!m_manager->cache_service->IsCacheLoaded(method_id)) {
-        PyObjectEx *t = m_db.GetCharStandings(call.client->GetCharacterID());
+        PyObjectEx *t = sStandingCache.EncodeCharStandings(call.client->GetCharacterID());
 
         m_manager->cache_service->GiveCache(method_id, (PyRep **)&t);
     }
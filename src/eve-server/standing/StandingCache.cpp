@@ -0,0 +1,269 @@
+/*
+    ------------------------------------------------------------------------------------
+    LICENSE:
+    ------------------------------------------------------------------------------------
+    This file is part of EVEmu: EVE Online Server Emulator
+    Copyright 2006 - 2011 The EVEmu Team
+    For the latest information visit http://evemu.org
+    ------------------------------------------------------------------------------------
+    This program is free software; you can redistribute it and/or modify it under
+    the terms of the GNU Lesser General Public License as published by the Free Software
+    Foundation; either version 2 of the License, or (at your option) any later
+    version.
+
+    This program is distributed in the hope that it will be useful, but WITHOUT
+    ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+    FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public License along with
+    this program; if not, write to the Free Software Foundation, Inc., 59 Temple
+    Place - Suite 330, Boston, MA 02111-1307, USA, or go to
+    http://www.gnu.org/copyleft/lesser.txt.
+    ------------------------------------------------------------------------------------
+    Author:     EVEmu Team
+*/
+
+
+#include "eve-server.h"
+
+#include "character/Character.h"
+#include "inventory/AttributeEnum.h"
+#include "standing/StandingCache.h"
+#include "standing/StandingDB.h"
+
+StandingCache::StandingCache()
+{
+}
+
+bool StandingCache::Load()
+{
+    DBQueryResult res;
+
+    if( !sDatabase.RunQuery( res,
+        "SELECT fromID, toID, standing"
+        " FROM npcStandings" ) )
+    {
+        sLog.Error( "StandingCache", "Failed to load NPC standings: %s.", res.error.c_str() );
+        return false;
+    }
+
+    mNPCStandings.clear();
+
+    DBResultRow row;
+    while( res.GetRow( row ) )
+        mNPCStandings[ _Key( row.GetUInt( 0 ), row.GetUInt( 1 ) ) ] = row.GetDouble( 2 );
+
+    return true;
+}
+
+double StandingCache::GetNPCStanding( uint32 fromID, uint32 toID )
+{
+    ++mStats.lookups;
+
+    std::tr1::unordered_map< uint64, double >::const_iterator res = mNPCStandings.find( _Key( fromID, toID ) );
+    if( res == mNPCStandings.end() )
+        return 0.0;
+
+    return res->second;
+}
+
+double StandingCache::GetStanding( uint32 characterID, uint32 fromID )
+{
+    ++mStats.lookups;
+
+    CharStandings* standings = _Get( characterID );
+    if( standings == NULL )
+        return 0.0;
+
+    StandingMap::const_iterator res = standings->npc.find( fromID );
+    if( res == standings->npc.end() )
+        return 0.0;
+
+    return res->second;
+}
+
+double StandingCache::GetEffectiveStanding( const Character& character, uint32 fromID )
+{
+    ++mStats.lookups;
+
+    CharStandings* standings = _Get( character.itemID() );
+    if( standings == NULL )
+        return 0.0;
+
+    StandingMap::const_iterator res = standings->effective.find( fromID );
+    if( res != standings->effective.end() )
+    {
+        ++mStats.derivedHits;
+        return res->second;
+    }
+
+    double standing = 0.0;
+    res = standings->npc.find( fromID );
+    if( res != standings->npc.end() )
+        standing = res->second;
+
+    SkillRef skill = character.GetSkill( standing < 0.0 ? skillDiplomacy : skillConnections );
+    EvilNumber level( 0 );
+    if( skill )
+        level = skill->GetAttribute( AttrSkillLevel );
+
+    double effective = EffectiveStanding( standing, level, level ).get_float();
+
+    standings->effective[ fromID ] = effective;
+    ++mStats.derivedMisses;
+    return effective;
+}
+
+bool StandingCache::SetStanding( uint32 characterID, uint32 fromID, double standing )
+{
+    if( !StandingDB::SetCharNPCStanding( characterID, fromID, standing ) )
+        return false;
+
+    std::tr1::unordered_map< uint32, CharStandings >::iterator res = mCharacters.find( characterID );
+    if( res != mCharacters.end() )
+    {
+        res->second.npc[ fromID ] = standing;
+        res->second.effective.erase( fromID );
+    }
+
+    ++mStats.updates;
+    return true;
+}
+
+PyObject* StandingCache::EncodeNPCStandings() const
+{
+    util_Rowset rs;
+    rs.header.push_back( "fromID" );
+    rs.header.push_back( "toID" );
+    rs.header.push_back( "standing" );
+    rs.lines = new PyList;
+
+    std::tr1::unordered_map< uint64, double >::const_iterator cur, end;
+    cur = mNPCStandings.begin();
+    end = mNPCStandings.end();
+    for(; cur != end; ++cur )
+    {
+        PyList* line = new PyList;
+        line->AddItemInt( (uint32)( cur->first >> 32 ) );
+        line->AddItemInt( (uint32)cur->first );
+        line->AddItemReal( cur->second );
+
+        rs.lines->AddItem( line );
+    }
+
+    return rs.Encode();
+}
+
+PyObjectEx* StandingCache::EncodeCharStandings( uint32 characterID )
+{
+    CharStandings* standings = _Get( characterID );
+    if( standings == NULL )
+        return NULL;
+
+    DBRowDescriptor* header = new DBRowDescriptor();
+    header->AddColumn( "fromID",   DBTYPE_I4 );
+    header->AddColumn( "standing", DBTYPE_R8 );
+
+    CRowSet* rowset = new CRowSet( &header );
+
+    StandingMap::const_iterator cur, end;
+    cur = standings->own.begin();
+    end = standings->own.end();
+    for(; cur != end; ++cur )
+    {
+        PyPackedRow* row = rowset->NewRow();
+        row->SetField( (uint32)0, new PyInt( cur->first ) );
+        row->SetField( 1, new PyFloat( cur->second ) );
+    }
+
+    return rowset;
+}
+
+PyObject* StandingCache::EncodeCharNPCStandings( uint32 characterID )
+{
+    CharStandings* standings = _Get( characterID );
+    if( standings == NULL )
+        return NULL;
+
+    util_Rowset rs;
+    rs.header.push_back( "fromID" );
+    rs.header.push_back( "standing" );
+    rs.lines = new PyList;
+
+    StandingMap::const_iterator cur, end;
+    cur = standings->npc.begin();
+    end = standings->npc.end();
+    for(; cur != end; ++cur )
+    {
+        PyList* line = new PyList;
+        line->AddItemInt( cur->first );
+        line->AddItemReal( cur->second );
+
+        rs.lines->AddItem( line );
+    }
+
+    return rs.Encode();
+}
+
+void StandingCache::ForgetEffective( uint32 characterID )
+{
+    std::tr1::unordered_map< uint32, CharStandings >::iterator res = mCharacters.find( characterID );
+    if( res != mCharacters.end() )
+        res->second.effective.clear();
+}
+
+void StandingCache::Forget( uint32 characterID )
+{
+    mCharacters.erase( characterID );
+}
+
+StandingCache::CharStandings* StandingCache::_Get( uint32 characterID )
+{
+    std::tr1::unordered_map< uint32, CharStandings >::iterator res = mCharacters.find( characterID );
+    if( res != mCharacters.end() )
+        return &res->second;
+
+    CharStandings& into = mCharacters[ characterID ];
+    if( !_Load( characterID, into ) )
+    {
+        mCharacters.erase( characterID );
+        return NULL;
+    }
+
+    ++mStats.characterLoads;
+    return &into;
+}
+
+bool StandingCache::_Load( uint32 characterID, CharStandings& into )
+{
+    DBQueryResult res;
+    DBResultRow row;
+
+    if( !sDatabase.RunQuery( res,
+        "SELECT toID, standing"
+        " FROM chrStandings"
+        " WHERE characterID = %u",
+        characterID ) )
+    {
+        _log( SERVICE__ERROR, "Error in standings query of character %u: %s", characterID, res.error.c_str() );
+        return false;
+    }
+
+    while( res.GetRow( row ) )
+        into.own[ row.GetUInt( 0 ) ] = row.GetDouble( 1 );
+
+    if( !sDatabase.RunQuery( res,
+        "SELECT fromID, standing"
+        " FROM chrNPCStandings"
+        " WHERE characterID = %u",
+        characterID ) )
+    {
+        _log( SERVICE__ERROR, "Error in NPC standings query of character %u: %s", characterID, res.error.c_str() );
+        return false;
+    }
+
+    while( res.GetRow( row ) )
+        into.npc[ row.GetUInt( 0 ) ] = row.GetDouble( 1 );
+
+    return true;
+}
@@ -27,40 +27,6 @@
 
 #include "standing/StandingDB.h"
 
-PyObject *StandingDB::GetNPCStandings() {
-    DBQueryResult res;
-
-    if(!sDatabase.RunQuery(res,
-        "SELECT "
-        " fromID,toID,standing"
-        " FROM npcStandings"
-    ))
-    {
-        codelog(SERVICE__ERROR, "Error in query: %s", res.error.c_str());
-        return NULL;
-    }
-
-    return DBResultToRowset(res);
-}
-
-
-PyObjectEx *StandingDB::GetCharStandings(uint32 characterID) {
-    DBQueryResult res;
-
-    //Hack: Have hardcoded the rename of toId to fromID until i know if its going to affect anything else.
-    if(!sDatabase.RunQuery(res,
-        "SELECT "
-        " toID AS fromID, standing"
-        " FROM chrStandings"
-        " WHERE characterID=%u", characterID
-    ))
-    {
-        _log(SERVICE__ERROR, "Error in GetCharStandings query: %s", res.error.c_str());
-        return NULL;
-    }
-
-    return DBResultToCRowset(res);
-}
 PyObjectEx *StandingDB::GetCorpStandings(uint32 corporationID) {
     DBQueryResult res;
 
@@ -102,21 +68,21 @@ PyObject *StandingDB::GetCharPrimeStandings(uint32 characterID) {
 }
 
 
-PyObject *StandingDB::GetCharNPCStandings(uint32 characterID) {
-    DBQueryResult res;
+bool StandingDB::SetCharNPCStanding(uint32 characterID, uint32 fromID, double standing) {
+    DBerror err;
 
-    if(!sDatabase.RunQuery(res,
-        "SELECT "
-        " fromID, standing"
-        " FROM chrNPCStandings"
-        " WHERE characterID=%u", characterID
+    if(!sDatabase.RunQuery(err,
+        "REPLACE INTO chrNPCStandings"
+        " (characterID, fromID, standing)"
+        " VALUES (%u, %u, %f)",
+        characterID, fromID, standing
     ))
     {
-        _log(SERVICE__ERROR, "Error in GetCharNPCStandings query: %s", res.error.c_str());
-        return NULL;
+        _log(SERVICE__ERROR, "Error in SetCharNPCStanding query: %s", err.c_str());
+        return false;
     }
 
-    return DBResultToRowset(res);
+    return true;
 }
 
 PyObject *StandingDB::GetStandingTransactions( uint32 characterID )
@@ -135,7 +101,7 @@ PyObject *StandingDB::GetStandingTransactions( uint32 characterID )
     return (DBResultToRowset(res));*/
 
     //since we dont support standing changes in any way yet, its useless to have such stuff in db
-    sLog.Debug( "StandingDB", "Called GetStandingTransactions stub." );
+    _debug( "StandingDB", "Called GetStandingTransactions stub." );
 
     util_Rowset res;
 
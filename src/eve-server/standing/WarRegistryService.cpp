@@ -27,6 +27,7 @@
 
 #include "PyBoundObject.h"
 #include "PyServiceCD.h"
+#include "standing/HostilityResolver.h"
 #include "standing/WarRegistryService.h"
 
 class WarRegistryBound
@@ -93,21 +94,5 @@ PyBoundObject *WarRegistryService::_CreateBoundObject(Client *c, const PyRep *bi
 
 PyResult WarRegistryBound::Handle_GetWars( PyCallArgs& call )
 {
-    sLog.Debug( "WarRegistryBound", "Called GetWars stub." );
-
-    util_IndexRowset irowset;
-
-    irowset.header.push_back( "warID" );
-    irowset.header.push_back( "declaredByID" );
-    irowset.header.push_back( "againstID" );
-    irowset.header.push_back( "timeDeclared" );
-    irowset.header.push_back( "timeFinished" );
-    irowset.header.push_back( "retracted" );
-    irowset.header.push_back( "retractedBy" );
-    irowset.header.push_back( "billID" );
-    irowset.header.push_back( "mutual" );
-
-    irowset.idName = "warID";
-
-    return irowset.Encode();
+    return sHostilityResolver.EncodeWars( m_corporationID );
 }
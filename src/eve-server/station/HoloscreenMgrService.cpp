@@ -50,7 +50,7 @@ HoloscreenMgrService::~HoloscreenMgrService()
 
 PyResult HoloscreenMgrService::Handle_GetTwoHourCache(PyCallArgs& call)
 {
-    sLog.Debug("HoloscreenMgrService", "Called GetTwoHourCache stub.");
+    _debug("HoloscreenMgrService", "Called GetTwoHourCache stub.");
 
     PyDict* agents = new PyDict;
 
@@ -69,14 +69,14 @@ PyResult HoloscreenMgrService::Handle_GetTwoHourCache(PyCallArgs& call)
 
 PyResult HoloscreenMgrService::Handle_GetRecentEpicArcCompletions(PyCallArgs& call)
 {
-    sLog.Debug("HoloscreenMgrService", "Called GetRecentEpicArcCompletions stub.");
+    _debug("HoloscreenMgrService", "Called GetRecentEpicArcCompletions stub.");
 
     return NULL;
 }
 
 PyResult HoloscreenMgrService::Handle_GetRuntimeCache(PyCallArgs& call)
 {
-    sLog.Debug("HoloscreenMgrService", "Called GetRuntimeCache stub.");
+    _debug("HoloscreenMgrService", "Called GetRuntimeCache stub.");
 
     PyDict* agents = new PyDict;
 
@@ -324,11 +324,11 @@ void StationEntity::EncodeDestiny( Buffer& into ) const
 }
 
 void StationEntity::MakeDamageState(DoDestinyDamageState &into) const {
-    into.shield = (m_self->GetAttribute(AttrShieldCharge).get_float() / m_self->GetAttribute(AttrShieldCapacity).get_float());
+    into.shield = (m_self->GetAttributeValue(AttrShieldCharge) / m_self->GetAttributeValue(AttrShieldCapacity));
     into.tau = 100000;    //no freaking clue.
     into.timestamp = Win32TimeNow();
 //    armor damage isn't working...
-    into.armor = 1.0 - (m_self->GetAttribute(AttrArmorDamage).get_float() / m_self->GetAttribute(AttrArmorHP).get_float());
-    into.structure = 1.0 - (m_self->GetAttribute(AttrDamage).get_float() / m_self->GetAttribute(AttrHp).get_float());
+    into.armor = 1.0 - (m_self->GetAttributeValue(AttrArmorDamage) / m_self->GetAttributeValue(AttrArmorHP));
+    into.structure = 1.0 - (m_self->GetAttributeValue(AttrDamage) / m_self->GetAttributeValue(AttrHp));
 }
 
@@ -0,0 +1,278 @@
+/*
+    ------------------------------------------------------------------------------------
+    LICENSE:
+    ------------------------------------------------------------------------------------
+    This file is part of EVEmu: EVE Online Server Emulator
+    Copyright 2006 - 2011 The EVEmu Team
+    For the latest information visit http://evemu.org
+    ------------------------------------------------------------------------------------
+    This program is free software; you can redistribute it and/or modify it under
+    the terms of the GNU Lesser General Public License as published by the Free Software
+    Foundation; either version 2 of the License, or (at your option) any later
+    version.
+
+    This program is distributed in the hope that it will be useful, but WITHOUT
+    ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+    FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public License along with
+    this program; if not, write to the Free Software Foundation, Inc., 59 Temple
+    Place - Suite 330, Boston, MA 02111-1307, USA, or go to
+    http://www.gnu.org/copyleft/lesser.txt.
+    ------------------------------------------------------------------------------------
+    Author:     EVEmu Team
+*/
+
+
+#include "eve-server.h"
+
+#include "EntityList.h"
+#include "station/StationCache.h"
+
+StationCache::StationCache()
+: mGuestCount( 0 )
+{
+}
+
+StationCache::~StationCache()
+{
+    std::tr1::unordered_map< uint32, Station >::iterator cur, end;
+    cur = mStations.begin();
+    end = mStations.end();
+    for(; cur != end; ++cur )
+    {
+        Station& station = cur->second;
+
+        PySafeDecRef( station.station );
+        PySafeDecRef( station.itemBits );
+
+        std::map< uint32, PyTuple* >::iterator curg, endg;
+        curg = station.guests.begin();
+        endg = station.guests.end();
+        for(; curg != endg; ++curg )
+            PyDecRef( curg->second );
+    }
+
+    std::map< uint32, std::map< uint32, Change > >::iterator curs, ends;
+    curs = mChanges.begin();
+    ends = mChanges.end();
+    for(; curs != ends; ++curs )
+    {
+        std::map< uint32, Change >::iterator curc, endc;
+        curc = curs->second.begin();
+        endc = curs->second.end();
+        for(; curc != endc; ++curc )
+            PyDecRef( curc->second.row );
+    }
+}
+
+PyRep* StationCache::GetStation( uint32 stationID )
+{
+    Station& station = _Get( stationID );
+    if( NULL == station.station )
+    {
+        station.station = mDB.DoGetStation( stationID );
+        if( NULL == station.station )
+            return NULL;
+
+        ++mStats.misses;
+    }
+    else
+        ++mStats.hits;
+
+    PyIncRef( station.station );
+    return station.station;
+}
+
+PyRep* StationCache::GetStationItemBits( uint32 stationID )
+{
+    Station& station = _Get( stationID );
+    if( NULL == station.itemBits )
+    {
+        station.itemBits = mDB.GetStationItemBits( stationID );
+        if( NULL == station.itemBits )
+            return NULL;
+
+        ++mStats.misses;
+    }
+    else
+        ++mStats.hits;
+
+    PyIncRef( station.itemBits );
+    return station.itemBits;
+}
+
+PyList* StationCache::GetGuests( uint32 stationID )
+{
+    PyList* result = new PyList;
+
+    std::tr1::unordered_map< uint32, Station >::const_iterator res = mStations.find( stationID );
+    if( res == mStations.end() )
+        return result;
+
+    std::map< uint32, PyTuple* >::const_iterator cur, end;
+    cur = res->second.guests.begin();
+    end = res->second.guests.end();
+    for(; cur != end; ++cur )
+    {
+        PyIncRef( cur->second );
+        result->AddItem( cur->second );
+    }
+
+    return result;
+}
+
+void StationCache::GetGuestIDs( uint32 stationID, std::vector< uint32 >& into ) const
+{
+    std::tr1::unordered_map< uint32, Station >::const_iterator res = mStations.find( stationID );
+    if( res == mStations.end() )
+        return;
+
+    std::map< uint32, PyTuple* >::const_iterator cur, end;
+    cur = res->second.guests.begin();
+    end = res->second.guests.end();
+    for(; cur != end; ++cur )
+        into.push_back( cur->first );
+}
+
+void StationCache::AddGuest( uint32 stationID, uint32 characterID, uint32 corporationID, uint32 allianceID )
+{
+    PyTuple* row = new PyTuple( 4 );
+    row->SetItem( 0, new PyInt( characterID ) );
+    row->SetItem( 1, new PyInt( corporationID ) );
+    if( 0 == allianceID )
+        row->SetItem( 2, new PyNone );
+    else
+        row->SetItem( 2, new PyInt( allianceID ) );
+    row->SetItem( 3, new PyNone );
+
+    PyTuple*& guest = _Get( stationID ).guests[ characterID ];
+    if( NULL != guest )
+    {
+        // a guest already; just keep the row up to date
+        PyDecRef( guest );
+        guest = row;
+        return;
+    }
+
+    guest = row;
+    ++mGuestCount;
+    ++mStats.arrivals;
+
+    std::map< uint32, Change >& changes = mChanges[ stationID ];
+    std::map< uint32, Change >::iterator res = changes.find( characterID );
+    if( res != changes.end() )
+    {
+        // undocked and docked again within the tick; nothing changed for the guests
+        PyDecRef( res->second.row );
+        changes.erase( res );
+        if( changes.empty() )
+            mChanges.erase( stationID );
+
+        ++mStats.coalesced;
+        return;
+    }
+
+    Change& change = changes[ characterID ];
+    change.arrived = true;
+    change.row = row;
+    PyIncRef( row );
+}
+
+void StationCache::RemoveGuest( uint32 stationID, uint32 characterID )
+{
+    std::tr1::unordered_map< uint32, Station >::iterator ress = mStations.find( stationID );
+    if( ress == mStations.end() )
+        return;
+
+    std::map< uint32, PyTuple* >::iterator resg = ress->second.guests.find( characterID );
+    if( resg == ress->second.guests.end() )
+        return;
+
+    // the queued change takes over the row
+    PyTuple* row = resg->second;
+    ress->second.guests.erase( resg );
+    --mGuestCount;
+    ++mStats.departures;
+
+    std::map< uint32, Change >& changes = mChanges[ stationID ];
+    std::map< uint32, Change >::iterator res = changes.find( characterID );
+    if( res != changes.end() )
+    {
+        // docked and undocked within the tick
+        PyDecRef( res->second.row );
+        changes.erase( res );
+        if( changes.empty() )
+            mChanges.erase( stationID );
+
+        PyDecRef( row );
+        ++mStats.coalesced;
+        return;
+    }
+
+    Change& change = changes[ characterID ];
+    change.arrived = false;
+    change.row = row;
+}
+
+void StationCache::Process()
+{
+    std::map< uint32, std::map< uint32, Change > >::iterator curs, ends;
+    curs = mChanges.begin();
+    ends = mChanges.end();
+    for(; curs != ends; ++curs )
+    {
+        std::map< uint32, Change >& changes = curs->second;
+
+        PyTuple* payload = NULL;
+        const char* notifyType = NULL;
+        if( 1 == changes.size() )
+        {
+            // a lone change goes as it is
+            const Change& change = changes.begin()->second;
+
+            payload = new PyTuple( 1 );
+            payload->SetItem( 0, change.row );
+            notifyType = change.arrived ? "OnCharNowInStation" : "OnCharNoLongerInStation";
+        }
+        else
+        {
+            PyList* events = new PyList;
+
+            std::map< uint32, Change >::iterator curc, endc;
+            curc = changes.begin();
+            endc = changes.end();
+            for(; curc != endc; ++curc )
+            {
+                PyTuple* event = new PyTuple( 2 );
+                event->SetItem( 0, new PyString( curc->second.arrived ? "OnCharNowInStation" : "OnCharNoLongerInStation" ) );
+                event->SetItem( 1, curc->second.row );
+                events->AddItem( event );
+            }
+
+            Notify_OnMultiEvent nom;
+            nom.events = events;
+
+            payload = nom.Encode();
+            notifyType = "OnMultiEvent";
+        }
+
+        // the rows were handed over to the payload
+        sEntityList.Multicast( notifyType, "stationid", &payload, NOTIF_DEST__LOCATION, curs->first );
+        ++mStats.notifications;
+    }
+
+    mChanges.clear();
+}
+
+StationCache::Station& StationCache::_Get( uint32 stationID )
+{
+    std::tr1::unordered_map< uint32, Station >::iterator res = mStations.find( stationID );
+    if( res != mStations.end() )
+        return res->second;
+
+    Station& station = mStations[ stationID ];
+    station.station = NULL;
+    station.itemBits = NULL;
+    return station;
+}
@@ -25,8 +25,9 @@
 
 #include "eve-server.h"
 
-#include "EntityList.h"
 #include "PyServiceCD.h"
+#include "character/PaperDollStore.h"
+#include "station/StationCache.h"
 #include "station/StationService.h"
 
 PyCallable_Make_InnerDispatcher(StationService)
@@ -60,24 +61,10 @@ PyResult StationService::Handle_GetSolarSystem(PyCallArgs &call) {
 }
 
 PyResult StationService::Handle_GetGuests(PyCallArgs &call) {
-    PyList *res = new PyList();
+    //the client asks for the portraits of all the guests next, load them by one query
+    std::vector<uint32> guests;
+    sStationCache.GetGuestIDs(call.client->GetStationID(), guests);
+    sPaperDollStore.Prefetch(guests);
 
-    std::vector<Client *> clients;
-    m_manager->entity_list.FindByStationID(call.client->GetStationID(), clients);
-    std::vector<Client *>::iterator cur, end;
-    cur = clients.begin();
-    end = clients.end();
-    for(; cur != end; cur++) {
-        PyTuple *t = new PyTuple(4);
-        t->items[0] = new PyInt((*cur)->GetCharacterID());
-        t->items[1] = new PyInt((*cur)->GetCorporationID());
-        t->items[2] = new PyInt((*cur)->GetAllianceID());
-        t->items[3] = new PyInt(0);    //unknown, might be factionID
-        res->AddItem(t);
-    }
-
-    return res;
-
-    //sLog.Debug("StationService", "Called GetGuests stub.");
-    //return NULL;
+    return sStationCache.GetGuests(call.client->GetStationID());
 }
@@ -27,6 +27,7 @@
 
 #include "PyServiceCD.h"
 #include "cache/ObjCacheService.h"
+#include "station/StationCache.h"
 #include "station/StationSvcService.h"
 
 /*
@@ -95,7 +96,7 @@ PyBoundObject* StationSvcService::_CreateBoundObject( Client* c, const PyRep* bi
 
 
 PyResult StationSvcService::Handle_GetStationItemBits(PyCallArgs &call) {
-    return m_db.GetStationItemBits(call.client->GetStationID());
+    return sStationCache.GetStationItemBits(call.client->GetStationID());
 }
 
 
@@ -124,5 +125,5 @@ PyResult StationSvcService::Handle_GetStation(PyCallArgs &call) {
         return (new PyInt(0));
     }
 
-    return m_db.DoGetStation(arg.arg);
+    return sStationCache.GetStation(arg.arg);
 }
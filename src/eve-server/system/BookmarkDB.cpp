@@ -26,21 +26,21 @@
 #include "eve-server.h"
 
 #include "system/BookmarkDB.h"
-#include "system/BookmarkService.h"
 
-PyObjectEx *BookmarkDB::GetBookmarks(uint32 ownerID) {
+bool BookmarkDB::LoadBookmarks(uint32 ownerID, std::vector<BookmarkData> &into) {
     DBQueryResult res;
 
     if(!sDatabase.RunQuery(res,
         "SELECT"
-        " CAST(bookmarkID AS SIGNED INTEGER) AS bookmarkID,"
-        " CAST(ownerID AS SIGNED INTEGER) AS ownerID,"
-        " CAST(itemID AS SIGNED INTEGER) AS itemID,"
-        " CAST(typeID AS SIGNED INTEGER) AS typeID,"
+        " bookmarkID,"
+        " ownerID,"
+        " itemID,"
+        " typeID,"
+        " flag,"
         " memo,"
         " created,"
         " x, y, z,"
-        " CAST(locationID AS SIGNED INTEGER) AS locationID,"
+        " locationID,"
         " note,"
         " creatorID,"
         " folderID"
@@ -48,19 +48,40 @@ PyObjectEx *BookmarkDB::GetBookmarks(uint32 ownerID) {
         " WHERE ownerID = %u",
         ownerID))
     {
-        sLog.Error( "BookmarkDB::GetBookmarks()", "Failed to query bookmarks for owner %u: %s.", ownerID, res.error.c_str() );
-        return(NULL);
+        sLog.Error( "BookmarkDB::LoadBookmarks()", "Failed to query bookmarks for owner %u: %s.", ownerID, res.error.c_str() );
+        return false;
+    }
+
+    DBResultRow row;
+    while( res.GetRow(row) )
+    {
+        BookmarkData bookmark;
+        bookmark.bookmarkID = row.GetUInt(0);
+        bookmark.ownerID = row.GetUInt(1);
+        bookmark.itemID = row.GetUInt(2);
+        bookmark.typeID = row.GetUInt(3);
+        bookmark.flag = row.GetUInt(4);
+        bookmark.memo = row.GetText(5);
+        bookmark.created = row.GetUInt64(6);
+        bookmark.x = row.GetDouble(7);
+        bookmark.y = row.GetDouble(8);
+        bookmark.z = row.GetDouble(9);
+        bookmark.locationID = row.GetUInt(10);
+        bookmark.note = row.GetText(11);
+        bookmark.creatorID = row.GetUInt(12);
+        bookmark.folderID = row.GetUInt(13);
+
+        into.push_back( bookmark );
     }
 
-    return DBResultToCRowset(res);
+    return true;
 }
 
-PyObjectEx *BookmarkDB::GetFolders(uint32 ownerID) {
+bool BookmarkDB::LoadFolders(uint32 ownerID, std::vector<BookmarkFolder> &into) {
     DBQueryResult res;
 
     if(!sDatabase.RunQuery(res,
         "SELECT"
-        " ownerID,"
         " folderID,"
         " folderName,"
         " creatorID"
@@ -68,48 +89,42 @@ PyObjectEx *BookmarkDB::GetFolders(uint32 ownerID) {
         " WHERE ownerID = %u",
         ownerID))
     {
-        sLog.Error( "BookmarkDB::GetBookmarks()", "Failed to query bookmarks for owner %u: %s.", ownerID, res.error.c_str() );
-        return(NULL);
+        sLog.Error( "BookmarkDB::LoadFolders()", "Failed to query bookmark folders for owner %u: %s.", ownerID, res.error.c_str() );
+        return false;
     }
 
-    return DBResultToCRowset(res);
+    DBResultRow row;
+    while( res.GetRow(row) )
+    {
+        BookmarkFolder folder;
+        folder.folderID = row.GetUInt(0);
+        folder.folderName = ( row.IsNull(1) ? "" : row.GetText(1) );
+        folder.creatorID = ( row.IsNull(2) ? 0 : row.GetUInt(2) );
+
+        into.push_back( folder );
+    }
+
+    return true;
 }
 
-uint32 BookmarkDB::GetNextAvailableBookmarkID()
+uint32 BookmarkDB::GetLastBookmarkID()
 {
     DBQueryResult res;
 
     if (!sDatabase.RunQuery(res,
         " SELECT "
-        "    bookmarkID "
-        " FROM bookmarks "
-        " WHERE bookmarkID >= %u ", 0))
+        "    MAX(bookmarkID) "
+        " FROM bookmarks "))
     {
-        sLog.Error( "BookmarkDB::GetNextAvailableBookmarkID()", "Error in query: %s", res.error.c_str() );
+        sLog.Error( "BookmarkDB::GetLastBookmarkID()", "Error in query: %s", res.error.c_str() );
         return 0;
     }
 
-    uint32 currentBookmarkID = 0;
-
-    // Traverse through the rows in the query result until the first gap is found
-    // and return the value that would be first (or only one) in the gap as the next
-    // free bookmark ID:
     DBResultRow row;
-    while( res.GetRow(row) )
-    {
-        const uint32 bookmarkID = row.GetUInt( 0 );
-
-        if( currentBookmarkID < bookmarkID )
-            return currentBookmarkID;
-
-        ++currentBookmarkID;
-    }
+    if( !res.GetRow(row) || row.IsNull(0) )
+        return 0;
 
-        // Check to make sure that the next available bookmarkID is not equal to the Maximum bookmarkID value
-    if( currentBookmarkID <= BookmarkService::MAX_BOOKMARK_ID )
-        return currentBookmarkID;
-    else
-        return 0;    // No free bookmarkIDs found (this should never happen as there are way too many IDs to exhaust)
+    return row.GetUInt(0);
 }
 
 
@@ -220,71 +235,122 @@ bool BookmarkDB::GetBookmarkInformation(uint32 bookmarkID, uint32 &ownerID, uint
 }
 
 
-bool BookmarkDB::SaveNewBookmarkToDatabase(uint32 &bookmarkID, uint32 ownerID, uint32 itemID,
-                               uint32 typeID, uint32 flag, std::string memo, uint64 created,
-                               double x, double y, double z, uint32 locationID)
+bool BookmarkDB::InsertBookmark(const BookmarkData &bookmark)
 {
-    DBQueryResult res;
     DBerror err;
-    DBResultRow row;
 
-    bookmarkID = GetNextAvailableBookmarkID();
+    std::string memo, note;
+    sDatabase.DoEscapeString(memo, bookmark.memo);
+    sDatabase.DoEscapeString(note, bookmark.note);
 
     if (!sDatabase.RunQuery(err,
         " INSERT INTO bookmarks "
-        " (bookmarkID, ownerID, itemID, typeID, flag, memo, created, x, y, z, locationID)"
-        " VALUES (%u, %u, %u, %u, %u, '%s', %" PRIu64 ", %f, %f, %f, %u) ",
-        bookmarkID, ownerID, itemID, typeID, flag, memo.c_str(), created, x, y, z, locationID
+        " (bookmarkID, ownerID, itemID, typeID, flag, memo, created, x, y, z, locationID, note, creatorID, folderID)"
+        " VALUES (%u, %u, %u, %u, %u, '%s', %" PRIu64 ", %f, %f, %f, %u, '%s', %u, %u) ",
+        bookmark.bookmarkID, bookmark.ownerID, bookmark.itemID, bookmark.typeID, bookmark.flag, memo.c_str(), bookmark.created,
+        bookmark.x, bookmark.y, bookmark.z, bookmark.locationID, note.c_str(), bookmark.creatorID, bookmark.folderID
         ))
     {
-        sLog.Error( "BookmarkDB::SaveNewBookmarkToDatabase()", "Error in query, Bookmark content couldn't be saved: %s", err.c_str() );
-        return 0;
+        sLog.Error( "BookmarkDB::InsertBookmark()", "Error in query, Bookmark content couldn't be saved: %s", err.c_str() );
+        return false;
     }
-    else
-        return 1;
+
+    return true;
 }
 
 
-bool BookmarkDB::DeleteBookmarksFromDatabase(uint32 ownerID, std::vector<unsigned long> * bookmarkList)
+std::string BookmarkDB::JoinIDs(const std::vector<uint32> &ids)
 {
-    DBerror err;
-    bool ret = true;
-    std::stringstream st;
-    std::string listString;
-    uint32 i, size;
+    std::string list;
+    char buf[16];
 
-    size = bookmarkList->size();
-    for(i=0; i<size; i++)
+    std::vector<uint32>::const_iterator cur, end;
+    cur = ids.begin();
+    end = ids.end();
+    for(; cur != end; cur++)
     {
-        st << bookmarkList->at(i);
-        if (i<(size-1))
-            st << ", ";
+        snprintf(buf, sizeof(buf), "%s%u", (list.empty() ? "" : ", "), *cur);
+        list += buf;
     }
 
+    return list;
+}
+
+
+bool BookmarkDB::DeleteBookmarksFromDatabase(uint32 ownerID, const std::vector<uint32> &bookmarkIDs)
+{
+    DBerror err;
+
     if (!sDatabase.RunQuery(err,
         " DELETE FROM bookmarks "
-        " WHERE ownerID = %u AND bookmarkID IN (%s)", ownerID, st.str().c_str()
+        " WHERE ownerID = %u AND bookmarkID IN (%s)", ownerID, JoinIDs(bookmarkIDs).c_str()
         ))
     {
         sLog.Error( "BookmarkDB::DeleteBookmarksFromDatabase()", "Error in query: %s", err.c_str() );
-        ret = false;
+        return false;
     }
 
-    return ret;
+    return true;
 }
 
 
-bool BookmarkDB::UpdateBookmarkInDatabase(uint32 bookmarkID, uint32 ownerID, std::string memo)
+bool BookmarkDB::MoveBookmarksInDatabase(uint32 ownerID, const std::vector<uint32> &bookmarkIDs, uint32 folderID)
 {
     DBerror err;
-    std::string new_password;
+
+    if (!sDatabase.RunQuery(err,
+        " UPDATE bookmarks "
+        " SET folderID = %u "
+        " WHERE ownerID = %u AND bookmarkID IN (%s)", folderID, ownerID, JoinIDs(bookmarkIDs).c_str()
+        ))
+    {
+        sLog.Error( "BookmarkDB::MoveBookmarksInDatabase()", "Error in query: %s", err.c_str() );
+        return false;
+    }
+
+    return true;
+}
+
+
+bool BookmarkDB::DeleteFolderFromDatabase(uint32 ownerID, uint32 folderID)
+{
+    DBerror err;
+
+    if (!sDatabase.RunQuery(err,
+        " DELETE FROM bookmarks "
+        " WHERE ownerID = %u AND folderID = %u", ownerID, folderID
+        ))
+    {
+        sLog.Error( "BookmarkDB::DeleteFolderFromDatabase()", "Error in query: %s", err.c_str() );
+        return false;
+    }
+
+    if (!sDatabase.RunQuery(err,
+        " DELETE FROM bookmarkFolders "
+        " WHERE ownerID = %u AND folderID = %u", ownerID, folderID
+        ))
+    {
+        sLog.Error( "BookmarkDB::DeleteFolderFromDatabase()", "Error in query: %s", err.c_str() );
+        return false;
+    }
+
+    return true;
+}
+
+
+bool BookmarkDB::UpdateBookmarkInDatabase(uint32 bookmarkID, uint32 ownerID, const std::string &memo)
+{
+    DBerror err;
+
+    std::string escaped;
+    sDatabase.DoEscapeString(escaped, memo);
 
     if (!sDatabase.RunQuery(err,
         " UPDATE bookmarks "
         " SET "
-        " memo = '%s', "
+        " memo = '%s' "
         " WHERE bookmarkID = %u AND ownerID = %u",
-        memo.c_str(),
+        escaped.c_str(),
         bookmarkID,
         ownerID
         ))
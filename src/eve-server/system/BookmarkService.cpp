@@ -27,6 +27,7 @@
 
 #include "PyServiceCD.h"
 #include "system/BookmarkService.h"
+#include "system/BookmarkStore.h"
 
 // Set the maximum number for any user-created bookmark.
 const uint32 BookmarkService::MAX_BOOKMARK_ID = 0xFFFFFFFF;
@@ -43,8 +44,8 @@ BookmarkService::BookmarkService(PyServiceMgr *mgr)
     PyCallable_REG_CALL(BookmarkService, BookmarkLocation)
     PyCallable_REG_CALL(BookmarkService, DeleteBookmarks)
     PyCallable_REG_CALL(BookmarkService, UpdateBookmark)
-
-    nextBookmarkID = 1000;
+    PyCallable_REG_CALL(BookmarkService, MoveBookmarksToFolder)
+    PyCallable_REG_CALL(BookmarkService, DeleteFolder)
 }
 
 
@@ -55,6 +56,18 @@ BookmarkService::~BookmarkService() {
 
 bool BookmarkService::LookupBookmark(uint32 characterID, uint32 bookmarkID, uint32 &itemID, uint32 &typeID, double &x, double &y, double &z)
 {
+    // Own bookmarks are resident:
+    const BookmarkData* bookmark = sBookmarkStore.Find(characterID, bookmarkID);
+    if( bookmark != NULL )
+    {
+        itemID = bookmark->itemID;
+        typeID = bookmark->typeID;
+        x = bookmark->x;
+        y = bookmark->y;
+        z = bookmark->z;
+        return true;
+    }
+
     // Retrieve bookmark information for external use:
     uint32 ownerID;
     uint32 flag;
@@ -67,12 +80,7 @@ bool BookmarkService::LookupBookmark(uint32 characterID, uint32 bookmarkID, uint
 
 
 PyResult BookmarkService::Handle_GetBookmarks(PyCallArgs &call) {
-    PyTuple* result = new PyTuple(2);
-
-    result->items[0] = m_db.GetBookmarks(call.client->GetCharacterID());
-    result->items[1] = m_db.GetFolders(call.client->GetCharacterID());
-
-    return result;
+    return sBookmarkStore.GetBookmarks(call.client->GetCharacterID());
 }
 
 
@@ -156,20 +164,25 @@ PyResult BookmarkService::Handle_BookmarkLocation(PyCallArgs &call)
     flag = 0;                                           // Don't know what to do with this value
     created = Win32TimeNow();
     memo = label + note;
-    m_db.SaveNewBookmarkToDatabase
-    (
-        bookmarkID,
-        call.client->GetCharacterID(),
-        itemID,
-        typeID,
-        flag,
-        memo,
-        created,
-        point.x,
-        point.y,
-        point.z,
-        locationID
-    );
+
+    BookmarkData bookmark;
+    bookmark.ownerID = ownerID;
+    bookmark.itemID = itemID;
+    bookmark.typeID = typeID;
+    bookmark.flag = flag;
+    bookmark.memo = memo;
+    bookmark.created = created;
+    bookmark.x = point.x;
+    bookmark.y = point.y;
+    bookmark.z = point.z;
+    bookmark.locationID = locationID;
+    bookmark.creatorID = ownerID;
+    bookmark.folderID = 0;
+
+    if( !sBookmarkStore.Add( bookmark ) )
+        return NULL;
+
+    bookmarkID = bookmark.bookmarkID;
 
 
     ////////////////////////////////////////
@@ -207,7 +220,7 @@ PyResult BookmarkService::Handle_DeleteBookmarks(PyCallArgs &call)
     PyList *list = call.tuple->GetItem( 0 )->AsList();
     uint32 i;
     uint32 bookmarkID;
-    std::vector<unsigned long> bookmarkIDs;
+    std::vector<uint32> bookmarkIDs;
 
     if( list->size() > 0 )
     {
@@ -217,7 +230,8 @@ PyResult BookmarkService::Handle_DeleteBookmarks(PyCallArgs &call)
             bookmarkIDs.push_back( bookmarkID );
         }
 
-        m_db.DeleteBookmarksFromDatabase( call.client->GetCharacterID(),&bookmarkIDs );
+        // all of them with a single statement
+        sBookmarkStore.Delete( call.client->GetCharacterID(), bookmarkIDs );
     }
     else
     {
@@ -232,12 +246,8 @@ PyResult BookmarkService::Handle_DeleteBookmarks(PyCallArgs &call)
 PyResult BookmarkService::Handle_UpdateBookmark(PyCallArgs &call)
 {
     uint32 bookmarkID;
-    uint32 ownerID;
-    uint32 itemID;
     uint32 typeID;
-    uint32 flag;
     std::string memo;
-    uint64 created;
     double x;
     double y;
     double z;
@@ -287,22 +297,18 @@ PyResult BookmarkService::Handle_UpdateBookmark(PyCallArgs &call)
     // Take newLabel and newNote to create new 'memo' value:
     memo = newLabel + newNote;
 
-    m_db.GetBookmarkInformation
-    (
-        bookmarkID,
-        ownerID,
-        itemID,
-        typeID,
-        flag,
-        memo,
-        created,
-        x,
-        y,
-        z,
-        locationID
-    );
-
-    m_db.UpdateBookmarkInDatabase(bookmarkID,call.client->GetCharacterID(),memo);
+    const BookmarkData* bookmark = sBookmarkStore.Update(call.client->GetCharacterID(), bookmarkID, memo);
+    if( bookmark == NULL )
+    {
+        sLog.Error( "BookmarkService::Handle_UpdateBookmark()", "%s: Unable to update bookmark %u.", call.client->GetName(), bookmarkID );
+        return NULL;
+    }
+
+    typeID = bookmark->typeID;
+    x = bookmark->x;
+    y = bookmark->y;
+    z = bookmark->z;
+    locationID = bookmark->locationID;
 
     PyTuple* res = NULL;
 
@@ -320,3 +326,49 @@ PyResult BookmarkService::Handle_UpdateBookmark(PyCallArgs &call)
 
     return res;
 }
+
+
+PyResult BookmarkService::Handle_MoveBookmarksToFolder(PyCallArgs &call)
+{
+    ////////////////////////////////////////
+    // call.tuple
+    //       |
+    //       |--> [0] PyInt:      folderID to move into (0 for none)
+    //       \--> [1] PyList:     bookmarkIDs
+    ////////////////////////////////////////
+
+    if ( call.tuple->size() < 2 || !call.tuple->GetItem( 0 )->IsInt() || !call.tuple->GetItem( 1 )->IsList() )
+    {
+        sLog.Error( "BookmarkService::Handle_MoveBookmarksToFolder()", "%s: call.tuple is of the wrong format.  Expected (PyInt, PyList).", call.client->GetName() );
+        return NULL;
+    }
+
+    const uint32 folderID = call.tuple->GetItem( 0 )->AsInt()->value();
+    PyList *list = call.tuple->GetItem( 1 )->AsList();
+
+    std::vector<uint32> bookmarkIDs;
+    for(uint32 i=0; i<(list->size()); i++)
+    {
+        if( list->GetItem(i)->IsInt() )
+            bookmarkIDs.push_back( list->GetItem(i)->AsInt()->value() );
+    }
+
+    // all of them with a single statement
+    sBookmarkStore.Move( call.client->GetCharacterID(), bookmarkIDs, folderID );
+
+    return(new PyNone());
+}
+
+
+PyResult BookmarkService::Handle_DeleteFolder(PyCallArgs &call)
+{
+    if ( call.tuple->size() < 1 || !call.tuple->GetItem( 0 )->IsInt() )
+    {
+        sLog.Error( "BookmarkService::Handle_DeleteFolder()", "%s: call.tuple is of the wrong format.  Expected (PyInt).", call.client->GetName() );
+        return NULL;
+    }
+
+    sBookmarkStore.DeleteFolder( call.client->GetCharacterID(), call.tuple->GetItem( 0 )->AsInt()->value() );
+
+    return(new PyNone());
+}
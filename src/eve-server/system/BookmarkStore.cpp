@@ -0,0 +1,317 @@
+/*
+    ------------------------------------------------------------------------------------
+    LICENSE:
+    ------------------------------------------------------------------------------------
+    This file is part of EVEmu: EVE Online Server Emulator
+    Copyright 2006 - 2011 The EVEmu Team
+    For the latest information visit http://evemu.org
+    ------------------------------------------------------------------------------------
+    This program is free software; you can redistribute it and/or modify it under
+    the terms of the GNU Lesser General Public License as published by the Free Software
+    Foundation; either version 2 of the License, or (at your option) any later
+    version.
+
+    This program is distributed in the hope that it will be useful, but WITHOUT
+    ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+    FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public License along with
+    this program; if not, write to the Free Software Foundation, Inc., 59 Temple
+    Place - Suite 330, Boston, MA 02111-1307, USA, or go to
+    http://www.gnu.org/copyleft/lesser.txt.
+    ------------------------------------------------------------------------------------
+    Author:     EVEmu Team
+*/
+
+
+#include "eve-server.h"
+
+#include "system/BookmarkService.h"
+#include "system/BookmarkStore.h"
+
+BookmarkStore::BookmarkStore()
+: mNextID( 0 )
+{
+}
+
+PyTuple* BookmarkStore::GetBookmarks( uint32 characterID )
+{
+    Book* book = _GetBook( characterID );
+    if( NULL == book )
+        return NULL;
+
+    ++mStats.lists;
+
+    // the columns the bookmarks table used to give
+    DBRowDescriptor* header = new DBRowDescriptor();
+    header->AddColumn( "bookmarkID", DBTYPE_I8 );
+    header->AddColumn( "ownerID",    DBTYPE_I8 );
+    header->AddColumn( "itemID",     DBTYPE_I8 );
+    header->AddColumn( "typeID",     DBTYPE_I8 );
+    header->AddColumn( "memo",       DBTYPE_WSTR );
+    header->AddColumn( "created",    DBTYPE_UI8 );
+    header->AddColumn( "x",          DBTYPE_R8 );
+    header->AddColumn( "y",          DBTYPE_R8 );
+    header->AddColumn( "z",          DBTYPE_R8 );
+    header->AddColumn( "locationID", DBTYPE_I8 );
+    header->AddColumn( "note",       DBTYPE_WSTR );
+    header->AddColumn( "creatorID",  DBTYPE_UI4 );
+    header->AddColumn( "folderID",   DBTYPE_UI4 );
+    CRowSet* bookmarks = new CRowSet( &header );
+
+    // folder by folder
+    std::map< uint32, std::set< uint32 > >::const_iterator curf, endf;
+    curf = book->folderIndex.begin();
+    endf = book->folderIndex.end();
+    for(; curf != endf; curf++ )
+    {
+        std::set< uint32 >::const_iterator cur, end;
+        cur = curf->second.begin();
+        end = curf->second.end();
+        for(; cur != end; cur++ )
+        {
+            const BookmarkData& bookmark = book->bookmarks[ *cur ];
+
+            PyPackedRow* row = bookmarks->NewRow();
+            row->SetField( (uint32)0, new PyLong( (int64)bookmark.bookmarkID ) );
+            row->SetField( 1, new PyLong( (int64)bookmark.ownerID ) );
+            row->SetField( 2, new PyLong( (int64)bookmark.itemID ) );
+            row->SetField( 3, new PyLong( (int64)bookmark.typeID ) );
+            row->SetField( 4, new PyWString( bookmark.memo ) );
+            row->SetField( 5, new PyLong( (int64)bookmark.created ) );
+            row->SetField( 6, new PyFloat( bookmark.x ) );
+            row->SetField( 7, new PyFloat( bookmark.y ) );
+            row->SetField( 8, new PyFloat( bookmark.z ) );
+            row->SetField( 9, new PyLong( (int64)bookmark.locationID ) );
+            row->SetField( 10, new PyWString( bookmark.note ) );
+            row->SetField( 11, new PyInt( bookmark.creatorID ) );
+            row->SetField( 12, new PyInt( bookmark.folderID ) );
+        }
+    }
+
+    DBRowDescriptor* folderHeader = new DBRowDescriptor();
+    folderHeader->AddColumn( "ownerID",    DBTYPE_I4 );
+    folderHeader->AddColumn( "folderID",   DBTYPE_I4 );
+    folderHeader->AddColumn( "folderName", DBTYPE_WSTR );
+    folderHeader->AddColumn( "creatorID",  DBTYPE_I4 );
+    CRowSet* folders = new CRowSet( &folderHeader );
+
+    std::vector< BookmarkFolder >::const_iterator cur, end;
+    cur = book->folders.begin();
+    end = book->folders.end();
+    for(; cur != end; cur++ )
+    {
+        PyPackedRow* row = folders->NewRow();
+        row->SetField( (uint32)0, new PyInt( characterID ) );
+        row->SetField( 1, new PyInt( cur->folderID ) );
+        row->SetField( 2, new PyWString( cur->folderName ) );
+        row->SetField( 3, new PyInt( cur->creatorID ) );
+    }
+
+    PyTuple* result = new PyTuple( 2 );
+    result->SetItem( 0, bookmarks );
+    result->SetItem( 1, folders );
+    return result;
+}
+
+const BookmarkData* BookmarkStore::Find( uint32 characterID, uint32 bookmarkID )
+{
+    Book* book = _GetBook( characterID );
+    if( NULL == book )
+        return NULL;
+
+    std::tr1::unordered_map< uint32, BookmarkData >::const_iterator res = book->bookmarks.find( bookmarkID );
+    if( book->bookmarks.end() == res )
+    {
+        // a bookmark of someone else, such as a corporation's
+        ++mStats.lookupMisses;
+        return NULL;
+    }
+
+    ++mStats.lookups;
+    return &res->second;
+}
+
+bool BookmarkStore::Add( BookmarkData& bookmark )
+{
+    Book* book = _GetBook( bookmark.ownerID );
+    if( NULL == book )
+        return false;
+
+    // one query per run instead of a scan of all the bookmarks per new one
+    if( 0 == mNextID )
+        mNextID = mDB.GetLastBookmarkID() + 1;
+    if( BookmarkService::MAX_BOOKMARK_ID == mNextID )
+    {
+        sLog.Error( "BookmarkStore::Add()", "No free bookmarkIDs left." );
+        return false;
+    }
+
+    bookmark.bookmarkID = mNextID;
+    if( !mDB.InsertBookmark( bookmark ) )
+        return false;
+
+    ++mNextID;
+
+    book->bookmarks[ bookmark.bookmarkID ] = bookmark;
+    book->folderIndex[ bookmark.folderID ].insert( bookmark.bookmarkID );
+
+    return true;
+}
+
+const BookmarkData* BookmarkStore::Update( uint32 characterID, uint32 bookmarkID, const std::string& memo )
+{
+    Book* book = _GetBook( characterID );
+    if( NULL == book )
+        return NULL;
+
+    std::tr1::unordered_map< uint32, BookmarkData >::iterator res = book->bookmarks.find( bookmarkID );
+    if( book->bookmarks.end() == res )
+        return NULL;
+
+    if( !mDB.UpdateBookmarkInDatabase( bookmarkID, characterID, memo ) )
+        return NULL;
+
+    res->second.memo = memo;
+    return &res->second;
+}
+
+bool BookmarkStore::Delete( uint32 characterID, const std::vector< uint32 >& bookmarkIDs )
+{
+    Book* book = _GetBook( characterID );
+    if( NULL == book )
+        return false;
+
+    std::vector< uint32 > known;
+    _FilterKnown( *book, bookmarkIDs, known );
+    if( known.empty() )
+        return true;
+
+    if( !mDB.DeleteBookmarksFromDatabase( characterID, known ) )
+        return false;
+
+    std::vector< uint32 >::const_iterator cur, end;
+    cur = known.begin();
+    end = known.end();
+    for(; cur != end; cur++ )
+    {
+        std::tr1::unordered_map< uint32, BookmarkData >::iterator res = book->bookmarks.find( *cur );
+
+        book->folderIndex[ res->second.folderID ].erase( *cur );
+        book->bookmarks.erase( res );
+    }
+
+    mStats.deleted += known.size();
+    return true;
+}
+
+bool BookmarkStore::Move( uint32 characterID, const std::vector< uint32 >& bookmarkIDs, uint32 folderID )
+{
+    Book* book = _GetBook( characterID );
+    if( NULL == book )
+        return false;
+
+    std::vector< uint32 > known;
+    _FilterKnown( *book, bookmarkIDs, known );
+    if( known.empty() )
+        return true;
+
+    if( !mDB.MoveBookmarksInDatabase( characterID, known, folderID ) )
+        return false;
+
+    std::set< uint32 >& into = book->folderIndex[ folderID ];
+
+    std::vector< uint32 >::const_iterator cur, end;
+    cur = known.begin();
+    end = known.end();
+    for(; cur != end; cur++ )
+    {
+        BookmarkData& bookmark = book->bookmarks[ *cur ];
+
+        book->folderIndex[ bookmark.folderID ].erase( *cur );
+        bookmark.folderID = folderID;
+        into.insert( *cur );
+    }
+
+    mStats.moved += known.size();
+    return true;
+}
+
+bool BookmarkStore::DeleteFolder( uint32 characterID, uint32 folderID )
+{
+    Book* book = _GetBook( characterID );
+    if( NULL == book || 0 == folderID )
+        return false;
+
+    std::vector< BookmarkFolder >::iterator cur, end;
+    cur = book->folders.begin();
+    end = book->folders.end();
+    while( cur != end && cur->folderID != folderID )
+        ++cur;
+    if( cur == end )
+        return false;
+
+    if( !mDB.DeleteFolderFromDatabase( characterID, folderID ) )
+        return false;
+
+    book->folders.erase( cur );
+
+    // the index knows which bookmarks went with it
+    std::map< uint32, std::set< uint32 > >::iterator res = book->folderIndex.find( folderID );
+    if( book->folderIndex.end() != res )
+    {
+        std::set< uint32 >::const_iterator curb, endb;
+        curb = res->second.begin();
+        endb = res->second.end();
+        for(; curb != endb; curb++ )
+            book->bookmarks.erase( *curb );
+
+        mStats.deleted += res->second.size();
+        book->folderIndex.erase( res );
+    }
+
+    return true;
+}
+
+BookmarkStore::Book* BookmarkStore::_GetBook( uint32 characterID )
+{
+    std::tr1::unordered_map< uint32, Book >::iterator res = mBooks.find( characterID );
+    if( mBooks.end() != res )
+        return &res->second;
+
+    std::vector< BookmarkData > bookmarks;
+    std::vector< BookmarkFolder > folders;
+    if( !mDB.LoadBookmarks( characterID, bookmarks ) || !mDB.LoadFolders( characterID, folders ) )
+        return NULL;
+
+    Book& book = mBooks[ characterID ];
+    book.folders.swap( folders );
+
+    std::vector< BookmarkData >::const_iterator cur, end;
+    cur = bookmarks.begin();
+    end = bookmarks.end();
+    for(; cur != end; cur++ )
+    {
+        book.bookmarks[ cur->bookmarkID ] = *cur;
+        book.folderIndex[ cur->folderID ].insert( cur->bookmarkID );
+    }
+
+    ++mStats.loads;
+    return &book;
+}
+
+void BookmarkStore::_FilterKnown( const Book& book, const std::vector< uint32 >& bookmarkIDs, std::vector< uint32 >& into )
+{
+    std::vector< uint32 >::const_iterator cur, end;
+    cur = bookmarkIDs.begin();
+    end = bookmarkIDs.end();
+    for(; cur != end; cur++ )
+    {
+        if( book.bookmarks.end() != book.bookmarks.find( *cur ) )
+            into.push_back( *cur );
+    }
+
+    // and the duplicates
+    std::sort( into.begin(), into.end() );
+    into.erase( std::unique( into.begin(), into.end() ), into.end() );
+}
@@ -31,6 +31,12 @@
 
 //upon this interval, check for entities which may have wandered out of their bubble without a major event happening.
 static const uint32 BubbleWanderTimer_S = 30;
+//how far from its center InBubble() reaches.
+static const double BubbleReach_M = BUBBLE_RADIUS_METERS + BUBBLE_HYSTERESIS_METERS;
+//edge length of a grid cell; a bubble overlaps at most 2 cells along each axis.
+static const double BubbleGridCell_M = 2.0 * BubbleReach_M;
+//a query covering more cells than this per bubble just scans all bubbles.
+static const size_t BubbleGridScanCells = 8;
 
 BubbleManager::BubbleManager()
 : m_wanderTimer(BubbleWanderTimer_S *1000)
@@ -50,6 +56,8 @@ void BubbleManager::clear() {
         delete *cur;
     }
     m_bubbles.clear();
+    m_centers.clear();
+    m_grid.clear();
 }
 
 void BubbleManager::Process() {
@@ -57,20 +65,23 @@ void BubbleManager::Process() {
         std::vector<SystemEntity *> wanderers;
 
         {
-            std::vector<SystemBubble *>::iterator cur, end;
+            std::vector<SystemBubble *>::iterator cur;
             cur = m_bubbles.begin();
-            end = m_bubbles.end();
-            for(; cur != end; ++cur) {
-                if((*cur)->IsEmpty()) {
+            while(cur != m_bubbles.end()) {
+                SystemBubble *b = *cur;
+                if(b->IsEmpty()) {
                     // Remove this bubble now that it is empty of ALL system entities
-                    sLog.Debug( "BubbleManager::Process()", "Bubble %u is empty and is therefore being deleted from the system right now.", (*cur)->GetBubbleID() );
-                    m_bubbles.erase(cur);
-                    cur = m_bubbles.begin();
-                    end = m_bubbles.end();
+                    _debug( "BubbleManager::Process()", "Bubble %u is empty and is therefore being deleted from the system right now.", b->GetBubbleID() );
+                    m_centers.Remove(cur - m_bubbles.begin());
+                    cur = m_bubbles.erase(cur);
+                    _UnindexBubble(b);
+                    delete b;
                 }
-                else
+                else {
                     // If wanderers are found, they are processed and moved to new bubbles, if applicable:
-                    (*cur)->ProcessWander(wanderers);
+                    b->ProcessWander(wanderers);
+                    ++cur;
+                }
             }
         }
         if(!wanderers.empty()) {
@@ -78,7 +89,7 @@ void BubbleManager::Process() {
             cur = wanderers.begin();
             end = wanderers.end();
             for(; cur != end; cur++) {
-                sLog.Debug( "BubbleManager::Process()", "SystemEntity '%s' being added to a bubble.", (*cur)->GetName() );
+                _debug( "BubbleManager::Process()", "SystemEntity '%s' being added to a bubble.", (*cur)->GetName() );
                 Add(*cur, true);
             }
         }
@@ -94,16 +105,16 @@ void BubbleManager::UpdateBubble(SystemEntity *ent, bool notify, bool isWarping,
             _log(DESTINY__BUBBLE_DEBUG, "Entity %u at (%.2f,%.2f,%.2f) is still located in bubble %u at (%.2f,%.2f,%.2f) with radius %.2f", ent->GetID(), ent->GetPosition().x, ent->GetPosition().y, ent->GetPosition().z, b->GetBubbleID(), b->m_center.x, b->m_center.y, b->m_center.z, b->m_radius);
             //_log(DESTINY__BUBBLE_TRACE, "Entity %u is still located in bubble %u", ent->GetID(), b->GetBubbleID());
             //still in bubble...
-            sLog.Debug( "BubbleManager::UpdateBubble()", "SystemEntity '%s' is still located in Bubble %u", ent->GetName(), b->GetBubbleID() );
+            _debug( "BubbleManager::UpdateBubble()", "SystemEntity '%s' is still located in Bubble %u", ent->GetName(), b->GetBubbleID() );
             return;
         }
         _log(DESTINY__BUBBLE_DEBUG, "Entity %u at (%.2f,%.2f,%.2f) is no longer located in bubble %u at (%.2f,%.2f,%.2f) with radius %.2f", ent->GetID(), ent->GetPosition().x, ent->GetPosition().y, ent->GetPosition().z, b->GetBubbleID(), b->m_center.x, b->m_center.y, b->m_center.z, b->m_radius);
         //_log(DESTINY__BUBBLE_TRACE, "Entity %u is no longer located in bubble %u", ent->GetID(), b->GetBubbleID());
         b->Remove(ent, notify);
-        sLog.Debug( "BubbleManager::UpdateBubble()", "SystemEntity '%s' being removed from Bubble %u", ent->GetName(), b->GetBubbleID() );
+        _debug( "BubbleManager::UpdateBubble()", "SystemEntity '%s' being removed from Bubble %u", ent->GetName(), b->GetBubbleID() );
     }
     else
-        sLog.Debug( "BubbleManager::UpdateBubble()", "SystemEntity '%s' not currently in ANY Bubble!!!", ent->GetName() );
+        _debug( "BubbleManager::UpdateBubble()", "SystemEntity '%s' not currently in ANY Bubble!!!", ent->GetName() );
 
     if( !isWarping )
         Add(ent, notify, isPostWarp);
@@ -131,7 +142,7 @@ void BubbleManager::Add(SystemEntity *ent, bool notify, bool isPostWarp) {
 
     if(in_bubble != NULL) {
         in_bubble->Add(ent, notify);
-        sLog.Debug( "BubbleManager::Add()", "SystemEntity '%s' being added to existing Bubble %u", ent->GetName(), in_bubble->GetBubbleID() );
+        _debug( "BubbleManager::Add()", "SystemEntity '%s' being added to existing Bubble %u", ent->GetName(), in_bubble->GetBubbleID() );
         return;
     }
 //    // this System Entity is not in any existing bubble, so let's make a new bubble
@@ -143,9 +154,11 @@ void BubbleManager::Add(SystemEntity *ent, bool notify, bool isPostWarp) {
 //    NewBubbleCenter( shipVelocity, newBubbleCenter );   // Calculate new bubble's center based on entity's velocity and current position
 
     in_bubble = new SystemBubble(newBubbleCenter, BUBBLE_RADIUS_METERS);
-    sLog.Debug( "BubbleManager::Add()", "SystemEntity '%s' being added to NEW Bubble %u", ent->GetName(), in_bubble->GetBubbleID() );
+    _debug( "BubbleManager::Add()", "SystemEntity '%s' being added to NEW Bubble %u", ent->GetName(), in_bubble->GetBubbleID() );
     //TODO: think about bubble colission. should we merge them?
     m_bubbles.push_back(in_bubble);
+    m_centers.Add(in_bubble->m_center);
+    _IndexBubble(in_bubble);
     in_bubble->Add(ent, notify);
 }
 
@@ -165,28 +178,22 @@ void BubbleManager::Remove(SystemEntity *ent, bool notify) {
         return;
     }
     b->Remove(ent, notify);
-    sLog.Debug( "BubbleManager::Remove()", "SystemEntity '%s' being removed from Bubble %u", ent->GetName(), b->GetBubbleID() );
+    _debug( "BubbleManager::Remove()", "SystemEntity '%s' being removed from Bubble %u", ent->GetName(), b->GetBubbleID() );
 
-    std::vector<SystemBubble *>::iterator cur, end;
-    cur = m_bubbles.begin();
-    end = m_bubbles.end();
-    for(; cur != end; ++cur) {
-        SystemBubble *b = *cur;
-        if(b->IsEmpty()) {
-            sLog.Debug( "BubbleManager::Remove()", "Bubble %u is empty and is therefore being deleted from the system right now.", b->GetBubbleID() );
-            m_bubbles.erase(cur);
-            cur = m_bubbles.begin();
-            end = m_bubbles.end();
-        }
+    if(b->IsEmpty()) {
+        _debug( "BubbleManager::Remove()", "Bubble %u is empty and is therefore being deleted from the system right now.", b->GetBubbleID() );
+        _DeleteBubble(b);
     }
 }
 
-//NOTE: this should probably eventually be optimized to use a
-//spacial partitioning scheme to speed up this search.
 SystemBubble * BubbleManager::_FindBubble(const GPoint &pos) const {
+    GridMap::const_iterator res = m_grid.find(_GetCellKey(_GetCell(pos.x), _GetCell(pos.y), _GetCell(pos.z)));
+    if(res == m_grid.end())
+        return NULL;
+
     std::vector<SystemBubble *>::const_iterator cur, end;
-    cur = m_bubbles.begin();
-    end = m_bubbles.end();
+    cur = res->second.begin();
+    end = res->second.end();
     for(; cur != end; ++cur) {
         SystemBubble *b = *cur;
         if(b->InBubble(pos)) {
@@ -196,3 +203,103 @@ SystemBubble * BubbleManager::_FindBubble(const GPoint &pos) const {
     //not in any existing bubble.
     return NULL;
 }
+
+void BubbleManager::GetEntitiesInRange(const GPoint &center, double range, std::vector<SystemEntity *> &into) const {
+    const double range2 = range * range;
+    const double reach2 = (range + BubbleReach_M) * (range + BubbleReach_M);
+
+    const int32 x0 = _GetCell(center.x - range), x1 = _GetCell(center.x + range);
+    const int32 y0 = _GetCell(center.y - range), y1 = _GetCell(center.y + range);
+    const int32 z0 = _GetCell(center.z - range), z1 = _GetCell(center.z + range);
+    const double cells = double(x1 - x0 + 1) * double(y1 - y0 + 1) * double(z1 - z0 + 1);
+
+    if(cells > double(m_bubbles.size() * BubbleGridScanCells)) {
+        //the query is too large for the grid to help.
+        std::vector<uint32> near;
+        m_centers.FindInRange(center, range + BubbleReach_M, near);
+
+        std::vector<uint32>::const_iterator cur, end;
+        cur = near.begin();
+        end = near.end();
+        for(; cur != end; ++cur)
+            m_bubbles[*cur]->GetEntitiesInRange(center, range2, into);
+        return;
+    }
+
+    //a bubble overlapping several cells must only be searched once.
+    std::set<SystemBubble *> searched;
+    for(int32 x = x0; x <= x1; ++x) {
+        for(int32 y = y0; y <= y1; ++y) {
+            for(int32 z = z0; z <= z1; ++z) {
+                GridMap::const_iterator res = m_grid.find(_GetCellKey(x, y, z));
+                if(res == m_grid.end())
+                    continue;
+
+                std::vector<SystemBubble *>::const_iterator cur, end;
+                cur = res->second.begin();
+                end = res->second.end();
+                for(; cur != end; ++cur) {
+                    SystemBubble *b = *cur;
+                    if(GVector(center, b->m_center).lengthSquared() > reach2)
+                        continue;
+                    if(searched.insert(b).second)
+                        b->GetEntitiesInRange(center, range2, into);
+                }
+            }
+        }
+    }
+}
+
+void BubbleManager::_IndexBubble(SystemBubble *b) {
+    const double reach = b->m_radius + BUBBLE_HYSTERESIS_METERS;
+    const int32 x1 = _GetCell(b->m_center.x + reach);
+    const int32 y1 = _GetCell(b->m_center.y + reach);
+    const int32 z1 = _GetCell(b->m_center.z + reach);
+
+    for(int32 x = _GetCell(b->m_center.x - reach); x <= x1; ++x)
+        for(int32 y = _GetCell(b->m_center.y - reach); y <= y1; ++y)
+            for(int32 z = _GetCell(b->m_center.z - reach); z <= z1; ++z)
+                m_grid[_GetCellKey(x, y, z)].push_back(b);
+}
+
+void BubbleManager::_UnindexBubble(SystemBubble *b) {
+    const double reach = b->m_radius + BUBBLE_HYSTERESIS_METERS;
+    const int32 x1 = _GetCell(b->m_center.x + reach);
+    const int32 y1 = _GetCell(b->m_center.y + reach);
+    const int32 z1 = _GetCell(b->m_center.z + reach);
+
+    for(int32 x = _GetCell(b->m_center.x - reach); x <= x1; ++x) {
+        for(int32 y = _GetCell(b->m_center.y - reach); y <= y1; ++y) {
+            for(int32 z = _GetCell(b->m_center.z - reach); z <= z1; ++z) {
+                GridMap::iterator res = m_grid.find(_GetCellKey(x, y, z));
+                if(res == m_grid.end())
+                    continue;
+
+                std::vector<SystemBubble *> &cell = res->second;
+                cell.erase(std::remove(cell.begin(), cell.end(), b), cell.end());
+                if(cell.empty())
+                    m_grid.erase(res);
+            }
+        }
+    }
+}
+
+void BubbleManager::_DeleteBubble(SystemBubble *b) {
+    std::vector<SystemBubble *>::iterator res = std::find(m_bubbles.begin(), m_bubbles.end(), b);
+    if(res != m_bubbles.end()) {
+        m_centers.Remove(res - m_bubbles.begin());
+        m_bubbles.erase(res);
+    }
+    _UnindexBubble(b);
+    delete b;
+}
+
+int32 BubbleManager::_GetCell(double coord) {
+    return static_cast<int32>(floor(coord / BubbleGridCell_M));
+}
+
+uint64 BubbleManager::_GetCellKey(int32 x, int32 y, int32 z) {
+    //21 bits per axis cover +-10^9 km; cells further away alias,
+    //which only costs a few extra InBubble() checks.
+    return (uint64(x & 0x1FFFFF) << 42) | (uint64(y & 0x1FFFFF) << 21) | uint64(z & 0x1FFFFF);
+}
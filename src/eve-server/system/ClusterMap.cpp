@@ -0,0 +1,195 @@
+/*
+    ------------------------------------------------------------------------------------
+    LICENSE:
+    ------------------------------------------------------------------------------------
+    This file is part of EVEmu: EVE Online Server Emulator
+    Copyright 2006 - 2011 The EVEmu Team
+    For the latest information visit http://evemu.org
+    ------------------------------------------------------------------------------------
+    This program is free software; you can redistribute it and/or modify it under
+    the terms of the GNU Lesser General Public License as published by the Free Software
+    Foundation; either version 2 of the License, or (at your option) any later
+    version.
+
+    This program is distributed in the hope that it will be useful, but WITHOUT
+    ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+    FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public License along with
+    this program; if not, write to the Free Software Foundation, Inc., 59 Temple
+    Place - Suite 330, Boston, MA 02111-1307, USA, or go to
+    http://www.gnu.org/copyleft/lesser.txt.
+    ------------------------------------------------------------------------------------
+    Author:     EVEmu Team
+*/
+
+
+#include "eve-server.h"
+
+#include "system/ClusterMap.h"
+
+ClusterMap::ClusterMap()
+: mNodeID( 0 ),
+  mNodeCount( 1 )
+{
+}
+
+bool ClusterMap::Load( uint32 nodeID, uint32 nodeCount )
+{
+    mNodeID = nodeID;
+    mNodeCount = std::max<uint32>( nodeCount, 1 );
+    mSystemRegions.clear();
+    mStationSystems.clear();
+    mRegionNodes.clear();
+    mSystemNodes.clear();
+
+    DBQueryResult res;
+    DBResultRow row;
+
+    if( !sDatabase.RunQuery( res,
+        "SELECT solarSystemID, regionID"
+        " FROM mapSolarSystems" ) )
+    {
+        codelog( SERVICE__ERROR, "Error in query: %s", res.error.c_str() );
+        return false;
+    }
+
+    std::map<uint32, uint32> regionSizes;
+    while( res.GetRow( row ) )
+    {
+        mSystemRegions[ row.GetUInt( 0 ) ] = row.GetUInt( 1 );
+        ++regionSizes[ row.GetUInt( 1 ) ];
+    }
+
+    if( !sDatabase.RunQuery( res,
+        "SELECT stationID, solarSystemID"
+        " FROM staStations" ) )
+    {
+        codelog( SERVICE__ERROR, "Error in query: %s", res.error.c_str() );
+        return false;
+    }
+    while( res.GetRow( row ) )
+        mStationSystems[ row.GetUInt( 0 ) ] = row.GetUInt( 1 );
+
+    //biggest regions first, each to the node owning the fewest solar systems
+    std::vector< std::pair<uint32, uint32> > regions;
+    std::map<uint32, uint32>::const_iterator cur, end;
+    cur = regionSizes.begin();
+    end = regionSizes.end();
+    for(; cur != end; cur++)
+        regions.push_back( std::make_pair( cur->second, cur->first ) );
+    std::sort( regions.rbegin(), regions.rend() );
+
+    std::vector<uint32> load( mNodeCount, 0 );
+    for( size_t i = 0; i < regions.size(); i++ )
+    {
+        const uint32 node = std::min_element( load.begin(), load.end() ) - load.begin();
+        load[ node ] += regions[ i ].first;
+        mRegionNodes[ regions[ i ].second ] = mNodeID + node;
+    }
+
+    return true;
+}
+
+uint32 ClusterMap::GetNodeID( uint32 locationID )
+{
+    ++mStats.resolves;
+
+    std::tr1::unordered_map<uint32, uint32>::const_iterator res = mStationSystems.find( locationID );
+    if( res != mStationSystems.end() )
+        locationID = res->second;
+
+    uint32 nodeID;
+    if( mSystemRegions.find( locationID ) != mSystemRegions.end() )
+        nodeID = _GetSystemNode( locationID );
+    else
+    {
+        res = mRegionNodes.find( locationID );
+        nodeID = ( res == mRegionNodes.end() ? mNodeID : res->second );
+    }
+
+    if( nodeID != mNodeID )
+        ++mStats.remote;
+    return nodeID;
+}
+
+uint32 ClusterMap::_GetSystemNode( uint32 solarSystemID ) const
+{
+    std::tr1::unordered_map<uint32, uint32>::const_iterator res = mSystemNodes.find( solarSystemID );
+    if( res != mSystemNodes.end() )
+        return res->second;
+
+    res = mSystemRegions.find( solarSystemID );
+    if( res == mSystemRegions.end() )
+        return mNodeID;
+
+    res = mRegionNodes.find( res->second );
+    if( res == mRegionNodes.end() )
+        return mNodeID;
+
+    return res->second;
+}
+
+uint32 ClusterMap::GetNodeID( const PyRep* bindParams )
+{
+    if( NULL != bindParams && bindParams->IsTuple() && 0 < bindParams->AsTuple()->size() )
+        bindParams = bindParams->AsTuple()->GetItem( 0 );
+
+    if( NULL != bindParams && bindParams->IsInt() )
+        return GetNodeID( static_cast<uint32>( bindParams->AsInt()->value() ) );
+
+    return mNodeID;
+}
+
+void ClusterMap::GetNodeLoad( std::map<uint32, uint32>& into ) const
+{
+    for( uint32 i = 0; i < mNodeCount; i++ )
+        into[ mNodeID + i ] = 0;
+
+    std::tr1::unordered_map<uint32, uint32>::const_iterator cur, end;
+    cur = mSystemRegions.begin();
+    end = mSystemRegions.end();
+    for(; cur != end; cur++)
+        ++into[ _GetSystemNode( cur->first ) ];
+}
+
+uint32 ClusterMap::Rebalance( const std::map<uint32, uint64>& systemTimes )
+{
+    if( mNodeCount < 2 )
+        return 0;
+
+    //time of every node and its busiest system
+    std::vector<uint64> load( mNodeCount, 0 );
+    std::vector< std::pair<uint64, uint32> > busiest( mNodeCount, std::make_pair( 0, 0 ) );
+
+    std::map<uint32, uint64>::const_iterator cur, end;
+    cur = systemTimes.begin();
+    end = systemTimes.end();
+    for(; cur != end; cur++)
+    {
+        const uint32 node = _GetSystemNode( cur->first ) - mNodeID;
+        if( node >= mNodeCount )
+            continue;
+
+        load[ node ] += cur->second;
+        if( busiest[ node ].first < cur->second )
+            busiest[ node ] = std::make_pair( cur->second, cur->first );
+    }
+
+    const uint32 from = std::max_element( load.begin(), load.end() ) - load.begin();
+    const uint32 to = std::min_element( load.begin(), load.end() ) - load.begin();
+    const uint64 time = busiest[ from ].first;
+
+    //moving it must leave both nodes below the busiest one
+    if( from == to || 0 == time || load[ from ] <= load[ to ] + time )
+        return 0;
+
+    const uint32 solarSystemID = busiest[ from ].second;
+    mSystemNodes[ solarSystemID ] = mNodeID + to;
+    ++mStats.migrations;
+
+    _log( SERVICE__MESSAGE, "ClusterMap: moved solar system %u from node %u to node %u (%" PRIu64 " of %" PRIu64 " us).",
+          solarSystemID, mNodeID + from, mNodeID + to, time, load[ from ] );
+
+    return solarSystemID;
+}
@@ -105,7 +105,7 @@ double CargoContainer::GetCapacity(EVEItemFlags flag) const
 {
     switch( flag ) {
         case flagAutoFit:
-        case flagCargoHold:     return GetAttribute(AttrCapacity).get_float();
+        case flagCargoHold:     return GetAttributeValue(AttrCapacity);
         default:
             return 0.0;
     }
@@ -300,11 +300,11 @@ void ContainerEntity::EncodeDestiny( Buffer& into ) const
 
 void ContainerEntity::MakeDamageState(DoDestinyDamageState &into) const
 {
-    into.shield = 0.0;//(m_self->GetAttribute(AttrShieldCharge).get_float() / m_self->GetAttribute(AttrShieldCapacity).get_float());
+    into.shield = 0.0;//(m_self->GetAttributeValue(AttrShieldCharge) / m_self->GetAttributeValue(AttrShieldCapacity));
     into.tau = 100000;    //no freaking clue.
     into.timestamp = Win32TimeNow();
 //    armor damage isn't working...
-    into.armor = 0.0;//1.0 - (m_self->GetAttribute(AttrArmorDamage).get_float() / m_self->GetAttribute(AttrArmorHP).get_float());
-    into.structure = 1.0 - (m_self->GetAttribute(AttrDamage).get_float() / m_self->GetAttribute(AttrHp).get_float());
+    into.armor = 0.0;//1.0 - (m_self->GetAttributeValue(AttrArmorDamage) / m_self->GetAttributeValue(AttrArmorHP));
+    into.structure = 1.0 - (m_self->GetAttributeValue(AttrDamage) / m_self->GetAttributeValue(AttrHp));
 }
 
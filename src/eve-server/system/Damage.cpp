@@ -29,6 +29,7 @@
 #include "EntityList.h"
 #include "PyServiceMgr.h"
 #include "inventory/AttributeEnum.h"
+#include "map/MapStatistics.h"
 #include "mining/Asteroid.h"
 #include "npc/NPC.h"
 #include "npc/SpawnManager.h"
@@ -157,6 +158,13 @@ void ItemSystemEntity::ApplyDamageModifiers(Damage &d, SystemEntity *target) {
 bool ItemSystemEntity::ApplyDamage(Damage &d) {
     _log(ITEM__TRACE, "%s(%u): Applying %.1f total damage from %u", GetName(), GetID(), d.GetTotal(), d.source->GetID());
 
+    //the kills are resolved after all the hits of the system tick.
+    SystemManager *system = System();
+    if(system != NULL && system->IsKillPending(GetID()))
+        return true;
+
+    const DamageResonances &resonances = _GetDamageResonances();
+
     double total_damage = 0;
     bool killed = false;
     int random_damage = 0;
@@ -176,12 +184,12 @@ bool ItemSystemEntity::ApplyDamage(Damage &d) {
     );*/
 
 
-    double available_shield = m_self->GetAttribute(AttrShieldCharge).get_float();
+    double available_shield = _GetShieldCharge();
     Damage shield_damage = d.MultiplyDup(
-        m_self->GetAttribute(AttrShieldKineticDamageResonance).get_float(),
-        m_self->GetAttribute(AttrShieldThermalDamageResonance).get_float(),
-        m_self->GetAttribute(AttrShieldEmDamageResonance).get_float(),
-        m_self->GetAttribute(AttrShieldExplosiveDamageResonance).get_float()
+        resonances.shield[0],
+        resonances.shield[1],
+        resonances.shield[2],
+        resonances.shield[3]
         );
 
 
@@ -224,11 +232,11 @@ bool ItemSystemEntity::ApplyDamage(Damage &d) {
         //we can take all this damage with our shield...
         //double new_charge = m_self->shieldCharge() - total_shield_damage;
         //m_self->Set_shieldCharge(new_charge);
-        EvilNumber new_charge = m_self->GetAttribute(AttrShieldCharge) - EvilNumber(total_shield_damage);
-        m_self->SetAttribute(AttrShieldCharge, new_charge);
+        double new_charge = available_shield - total_shield_damage;
+        _SetShieldCharge(new_charge);
 
         total_damage += total_shield_damage;
-        _log(ITEM__TRACE, "%s(%u): Applying entire %.1f damage to shields. New charge: %.1f", GetName(), GetID(), total_shield_damage, new_charge.get_float());
+        _log(ITEM__TRACE, "%s(%u): Applying entire %.1f damage to shields. New charge: %.1f", GetName(), GetID(), total_shield_damage, new_charge);
     }
     else
     {
@@ -242,16 +250,16 @@ bool ItemSystemEntity::ApplyDamage(Damage &d) {
             _log(ITEM__TRACE, "%s(%u): Shield depleated with %.1f damage. %.1f damage remains.", GetName(), GetID(), available_shield, d.GetTotal());
 
             //set shield to 0, it is fully depleted.
-            m_self->SetAttribute(AttrShieldCharge, 0);
+            _SetShieldCharge(0.0);
         }
 
         //Armor:
-        double available_armor = m_self->GetAttribute(AttrArmorHP).get_float() - m_self->GetAttribute(AttrArmorDamage).get_float();
+        double available_armor = m_self->GetAttributeValue(AttrArmorHP) - m_self->GetAttributeValue(AttrArmorDamage);
         Damage armor_damage = d.MultiplyDup(
-            m_self->GetAttribute(AttrArmorKineticDamageResonance).get_float(),
-            m_self->GetAttribute(AttrArmorThermalDamageResonance).get_float(),
-            m_self->GetAttribute(AttrArmorEmDamageResonance).get_float(),
-            m_self->GetAttribute(AttrArmorExplosiveDamageResonance).get_float()
+            resonances.armor[0],
+            resonances.armor[1],
+            resonances.armor[2],
+            resonances.armor[3]
         );
         //other:
         //activeEmResistanceBonus
@@ -301,12 +309,12 @@ bool ItemSystemEntity::ApplyDamage(Damage &d) {
             //Hull/Structure:
 
             //The base hp and damage attributes represent structure.
-            double available_hull = m_self->GetAttribute(AttrHp).get_float() - m_self->GetAttribute(AttrDamage).get_float();
+            double available_hull = m_self->GetAttributeValue(AttrHp) - m_self->GetAttributeValue(AttrDamage);
             Damage hull_damage = d.MultiplyDup(
-                m_self->GetAttribute(AttrHullKineticDamageResonance).get_float(),
-                m_self->GetAttribute(AttrHullThermalDamageResonance).get_float(),
-                m_self->GetAttribute(AttrHullEmDamageResonance).get_float(),
-                m_self->GetAttribute(AttrHullExplosiveDamageResonance).get_float()
+                resonances.hull[0],
+                resonances.hull[1],
+                resonances.hull[2],
+                resonances.hull[3]
             );
             //other:
             //passiveEmDamageResonanceMultiplier
@@ -321,10 +329,10 @@ bool ItemSystemEntity::ApplyDamage(Damage &d) {
 
             // If we have a passive or an active module to boost the resistance.
             // The modules itself must provide us this value.
-            hull_damage.em *= m_self->GetAttribute(AttrHullEmDamageResonance).get_float();
-            hull_damage.explosive *= m_self->GetAttribute(AttrHullExplosiveDamageResonance).get_float();
-            hull_damage.kinetic *= m_self->GetAttribute(AttrHullKineticDamageResonance).get_float();
-            hull_damage.thermal *= m_self->GetAttribute(AttrHullThermalDamageResonance).get_float();
+            hull_damage.em *= resonances.hull[2];
+            hull_damage.explosive *= resonances.hull[3];
+            hull_damage.kinetic *= resonances.hull[0];
+            hull_damage.thermal *= resonances.hull[1];
 
 
             // Not sure about this, but with this we get some random hits... :)
@@ -403,13 +411,20 @@ bool ItemSystemEntity::ApplyDamage(Damage &d) {
         PySafeDecRef( up );
     }
 
-    if(killed == true)
+    if(system == NULL)
     {
-        Killed(d);
+        if(killed == true)
+            Killed(d);
+        else
+            _SendDamageStateChanged();
+    }
+    else if(killed == true)
+    {
+        system->QueueKill(this, d);
     }
     else
     {
-        _SendDamageStateChanged();
+        system->MarkDamageStateChanged(this);
     }
 
     return(killed);
@@ -430,6 +445,14 @@ void Client::ApplyDamageModifiers(Damage &d, SystemEntity *target)
 {
 }
 
+double Client::_GetShieldCharge() const {
+    return GetShip()->GetShieldCharge();
+}
+
+void Client::_SetShieldCharge(double charge) {
+    GetShip()->SetShieldCharge(charge);
+}
+
 // for now this uses ItemSystemEntity
 bool Client::ApplyDamage(Damage &d) {
     _ReduceDamage(d);
@@ -441,6 +464,12 @@ bool Client::ApplyDamage(Damage &d) {
 bool NPC::ApplyDamage(Damage &d) {
     _log(ITEM__TRACE, "%u: Applying %.1f total damage from %u", GetID(), d.GetTotal(), d.source->GetID());
 
+    //the kills are resolved after all the hits of the system tick.
+    if(m_system->IsKillPending(GetID()))
+        return true;
+
+    const DamageResonances &resonances = _GetDamageResonances();
+
     double total_damage = 0;
     bool killed = false;
     int random_damage = 0;
@@ -452,10 +481,10 @@ bool NPC::ApplyDamage(Damage &d) {
     //Shield:
     double available_shield = m_shieldCharge;
     Damage shield_damage = d.MultiplyDup(
-        m_self->GetAttribute(AttrShieldKineticDamageResonance).get_float(),
-        m_self->GetAttribute(AttrShieldThermalDamageResonance).get_float(),
-        m_self->GetAttribute(AttrShieldEmDamageResonance).get_float(),
-        m_self->GetAttribute(AttrShieldExplosiveDamageResonance).get_float()
+        resonances.shield[0],
+        resonances.shield[1],
+        resonances.shield[2],
+        resonances.shield[3]
     );
     //other:
     //emDamageResistanceBonus
@@ -519,12 +548,12 @@ bool NPC::ApplyDamage(Damage &d) {
         }
 
         //Armor:
-        double available_armor = m_self->GetAttribute(AttrArmorHP).get_float() - m_armorDamage;
+        double available_armor = m_self->GetAttributeValue(AttrArmorHP) - m_armorDamage;
         Damage armor_damage = d.MultiplyDup(
-            m_self->GetAttribute(AttrArmorKineticDamageResonance).get_float(),
-            m_self->GetAttribute(AttrArmorThermalDamageResonance).get_float(),
-            m_self->GetAttribute(AttrArmorEmDamageResonance).get_float(),
-            m_self->GetAttribute(AttrArmorExplosiveDamageResonance).get_float()
+            resonances.armor[0],
+            resonances.armor[1],
+            resonances.armor[2],
+            resonances.armor[3]
         );
         //other:
         //activeEmResistanceBonus
@@ -567,19 +596,19 @@ bool NPC::ApplyDamage(Damage &d) {
                 _log(ITEM__TRACE, "%s(%u): Armor depleated with %.1f damage. %.1f damage remains.", GetName(), GetID(), available_armor, d.GetTotal());
 
                 //all armor has been penetrated.
-                m_armorDamage = m_self->GetAttribute(AttrArmorHP).get_float();
+                m_armorDamage = m_self->GetAttributeValue(AttrArmorHP);
             }
 
 
             //Hull/Structure:
 
             //The base hp and damage attributes represent structure.
-            double available_hull = m_self->GetAttribute(AttrHp).get_float() - m_hullDamage;
+            double available_hull = m_self->GetAttributeValue(AttrHp) - m_hullDamage;
             Damage hull_damage = d.MultiplyDup(
-                m_self->GetAttribute(AttrHullKineticDamageResonance).get_float(),
-                m_self->GetAttribute(AttrHullThermalDamageResonance).get_float(),
-                m_self->GetAttribute(AttrHullEmDamageResonance).get_float(),
-                m_self->GetAttribute(AttrHullExplosiveDamageResonance).get_float()
+                resonances.hull[0],
+                resonances.hull[1],
+                resonances.hull[2],
+                resonances.hull[3]
             );
             //other:
             //passiveEmDamageResonanceMultiplier
@@ -612,7 +641,7 @@ bool NPC::ApplyDamage(Damage &d) {
                 _log(ITEM__TRACE, "%s(%u): %.1f damage has depleated our structure. Time to explode.", GetName(), GetID(), total_hull_damage);
                 killed = true;
                 //m_hullDamage = m_self->hp();
-                m_hullDamage = m_self->GetAttribute(AttrHp).get_float();
+                m_hullDamage = m_self->GetAttributeValue(AttrHp);
             }
 
             //TODO: deal with damaging modules. no idea the mechanics on this.
@@ -671,31 +700,17 @@ bool NPC::ApplyDamage(Damage &d) {
 
     if(killed == true)
     {
-        Killed(d);
+        m_system->QueueKill(this, d);
     }
     else
     {
-        _SendDamageStateChanged();
+        m_system->MarkDamageStateChanged(this);
     }
 
     return(killed);
 
 }
 
-void NPC::_SendDamageStateChanged() const
-{
-    DoDestinyDamageState state;
-    MakeDamageState(state);
-
-    DoDestiny_OnDamageStateChange ddsc;
-    ddsc.entityID = GetID();
-    ddsc.state = state.Encode();
-
-    PyTuple *up;
-    up = ddsc.Encode();
-    targets.QueueTBDestinyUpdate(&up);
-}
-
 void ItemSystemEntity::_SendDamageStateChanged() const {
     DoDestinyDamageState state;
     MakeDamageState(state);
@@ -723,6 +738,7 @@ void DynamicSystemEntity::Killed(Damage &fatal_blow) {
 void Client::Killed(Damage &fatal_blow) {
     DynamicSystemEntity::Killed(fatal_blow);
 
+    sMapStatistics.AddKill(GetSystemID(), GetShip()->typeID() == itemTypeCapsule ? MapStatistics::KILL_POD : MapStatistics::KILL_SHIP);
 
     if(GetShip()->typeID() == itemTypeCapsule) {
         //we have been pod killed... off we go.
@@ -771,7 +787,7 @@ void Client::Killed(Damage &fatal_blow) {
 
         m_shipId = capsule->itemID();
         if (IsInSpace())
-            mSession.SetInt("shipid", capsule->itemID() );
+            mSession.SetInt(SESSION_SHIP_ID, capsule->itemID() );
 
         //This sends the RemoveBall for the old ship.
 
@@ -793,6 +809,8 @@ void NPC::Killed(Damage &fatal_blow)
 
     DynamicSystemEntity::Killed(fatal_blow);
 
+    sMapStatistics.AddKill(m_system->GetID(), MapStatistics::KILL_NPC);
+
     SystemEntity *killer = fatal_blow.source;
     Client* client = m_services.entity_list.FindByShip( killer->Item()->ownerID() );
     if( !killer->IsClient() )
@@ -895,6 +913,14 @@ void ShipEntity::ApplyDamageModifiers(Damage &d, SystemEntity *target)
 {
 }
 
+double ShipEntity::_GetShieldCharge() const {
+    return _shipRef->GetShieldCharge();
+}
+
+void ShipEntity::_SetShieldCharge(double charge) {
+    _shipRef->SetShieldCharge(charge);
+}
+
 // This is a ShipEntity implementation of damage system (incomplete)
 bool ShipEntity::ApplyDamage(Damage &d) {
 // for now this uses ItemSystemEntity
@@ -0,0 +1,397 @@
+/*
+    ------------------------------------------------------------------------------------
+    LICENSE:
+    ------------------------------------------------------------------------------------
+    This file is part of EVEmu: EVE Online Server Emulator
+    Copyright 2006 - 2011 The EVEmu Team
+    For the latest information visit http://evemu.org
+    ------------------------------------------------------------------------------------
+    This program is free software; you can redistribute it and/or modify it under
+    the terms of the GNU Lesser General Public License as published by the Free Software
+    Foundation; either version 2 of the License, or (at your option) any later
+    version.
+
+    This program is distributed in the hope that it will be useful, but WITHOUT
+    ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+    FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public License along with
+    this program; if not, write to the Free Software Foundation, Inc., 59 Temple
+    Place - Suite 330, Boston, MA 02111-1307, USA, or go to
+    http://www.gnu.org/copyleft/lesser.txt.
+    ------------------------------------------------------------------------------------
+    Author:     EVEmu Team
+*/
+
+
+#include "eve-server.h"
+
+#include "PyServiceMgr.h"
+#include "npc/NPC.h"
+#include "pos/Structure.h"
+#include "system/BubbleManager.h"
+#include "system/Container.h"
+#include "system/DungeonManager.h"
+#include "system/SystemManager.h"
+
+/*************************************************************************/
+/* DungeonInstance                                                       */
+/*************************************************************************/
+DungeonInstance::DungeonInstance( uint32 instanceID, const DungeonBlueprint& blueprint, SystemManager& system, uint32 pocket, const GPoint& origin )
+: mInstanceID( instanceID ),
+  mBlueprint( blueprint ),
+  mSystem( system ),
+  mPocket( pocket ),
+  mOrigin( origin )
+{
+}
+
+size_t DungeonInstance::Spawn( PyServiceMgr& services )
+{
+    std::vector< DungeonBlueprint::Object >::const_iterator cur, end;
+    cur = mBlueprint.objects.begin();
+    end = mBlueprint.objects.end();
+    for(; cur != end; cur++ )
+    {
+        GPoint position( mOrigin + cur->offset );
+
+        switch( cur->kind )
+        {
+            case DungeonBlueprint::OBJECT_NPC_GROUP:
+            {
+                std::vector< DungeonBlueprint::NPCEntry >::const_iterator curn, endn;
+                curn = cur->npcs.begin();
+                endn = cur->npcs.end();
+                for(; curn != endn; curn++ )
+                {
+                    for( uint8 r = 0; r < curn->quantity; r++ )
+                    {
+                        if( curn->probability < 1.0f && MakeRandomFloat( 0, 1.0f ) > curn->probability )
+                            continue;
+
+                        ItemData idata(
+                            curn->npcTypeID,
+                            curn->ownerID,
+                            mSystem.GetID(),
+                            flagAutoFit
+                        );
+
+                        InventoryItemRef i = services.item_factory.SpawnTransientItem( idata );
+                        if( !i )
+                        {
+                            _log( SPAWN__ERROR, "Dungeon %u: failed to spawn NPC of type %u.", mBlueprint.dungeonID, curn->npcTypeID );
+                            continue;
+                        }
+
+                        NPC* npc = new NPC( &mSystem, services, i, curn->corporationID, 0, position, NULL );
+                        if( !npc->Load( services.serviceDB() ) )
+                        {
+                            _log( SPAWN__ERROR, "Dungeon %u: failed to load NPC %u of type %u.", mBlueprint.dungeonID, i->itemID(), curn->npcTypeID );
+                            delete npc;
+                            i->Delete();
+                            continue;
+                        }
+
+                        mSystem.AddNPC( npc );
+                        mEntities.push_back( Entity() );
+                        mEntities.back().entity = npc;
+                        mEntities.back().item = i;
+
+                        //no formations yet, line them up like the spawns do.
+                        position.y += 1000.0;
+                    }
+                }
+            } break;
+
+            case DungeonBlueprint::OBJECT_CONTAINER:
+            {
+                ItemData idata(
+                    cur->typeID,
+                    cur->ownerID,
+                    mSystem.GetID(),
+                    flagAutoFit,
+                    cur->itemName.c_str(),
+                    position
+                );
+
+                CargoContainerRef i = services.item_factory.SpawnTransientCargoContainer( idata );
+                if( !i )
+                {
+                    _log( SPAWN__ERROR, "Dungeon %u: failed to spawn container of type %u.", mBlueprint.dungeonID, cur->typeID );
+                    break;
+                }
+
+                _Add( new ContainerEntity( i, &mSystem, services, position ), i );
+            } break;
+
+            case DungeonBlueprint::OBJECT_STRUCTURE:
+            {
+                ItemData idata(
+                    cur->typeID,
+                    cur->ownerID,
+                    mSystem.GetID(),
+                    flagAutoFit,
+                    cur->itemName.c_str(),
+                    position
+                );
+
+                StructureRef i = services.item_factory.SpawnTransientStructure( idata );
+                if( !i )
+                {
+                    _log( SPAWN__ERROR, "Dungeon %u: failed to spawn structure of type %u.", mBlueprint.dungeonID, cur->typeID );
+                    break;
+                }
+
+                _Add( new StructureEntity( i, &mSystem, services, position ), i );
+            } break;
+        }
+    }
+
+    return mEntities.size();
+}
+
+void DungeonInstance::Teardown()
+{
+    std::vector< Entity >::iterator cur, end;
+    cur = mEntities.begin();
+    end = mEntities.end();
+    for(; cur != end; cur++ )
+    {
+        //the ones a player took over have been persisted; they stay where they are.
+        if( !cur->item->IsTransient() )
+            continue;
+
+        //the killed ones have already left the system; they stay as Killed() left them.
+        if( mSystem.get( cur->item->itemID() ) == cur->entity )
+        {
+            if( cur->entity->IsNPC() )
+            {
+                //its destructor removes it from the system.
+                delete cur->entity;
+            }
+            else
+            {
+                mSystem.RemoveEntity( cur->entity );
+                delete cur->entity;
+            }
+        }
+
+        cur->item->Delete();
+    }
+
+    mEntities.clear();
+}
+
+void DungeonInstance::GetNPCs( std::vector< NPC* >& into ) const
+{
+    std::vector< Entity >::const_iterator cur, end;
+    cur = mEntities.begin();
+    end = mEntities.end();
+    for(; cur != end; cur++ )
+    {
+        //the killed ones are gone already.
+        if( mSystem.get( cur->item->itemID() ) == cur->entity && cur->entity->IsNPC() )
+            into.push_back( cur->entity->CastToNPC() );
+    }
+}
+
+void DungeonInstance::_Add( SystemEntity* entity, InventoryItemRef item )
+{
+    mSystem.AddEntity( entity );
+
+    mEntities.push_back( Entity() );
+    mEntities.back().entity = entity;
+    mEntities.back().item = item;
+}
+
+/*************************************************************************/
+/* DungeonManager                                                        */
+/*************************************************************************/
+const double DungeonManager::POCKET_DISTANCE = 100.0 * ONE_AU_IN_METERS;
+const double DungeonManager::POCKET_SPACING = 4.0 * BUBBLE_RADIUS_METERS;
+
+DungeonManager::DungeonManager()
+: mNextInstanceID( 1 )
+{
+}
+
+DungeonManager::~DungeonManager()
+{
+    std::map< uint32, DungeonInstance* >::iterator cur, end;
+    cur = mInstances.begin();
+    end = mInstances.end();
+    for(; cur != end; cur++ )
+        delete cur->second;
+}
+
+bool DungeonManager::Load()
+{
+    mBlueprints.clear();
+
+    DBQueryResult res;
+    DBResultRow row;
+
+    if( !sDatabase.RunQuery( res,
+        "SELECT dungeonID, dungeonName, factionID"
+        " FROM dunTemplates" ) )
+    {
+        codelog( SERVICE__ERROR, "Error in query: %s", res.error.c_str() );
+        return false;
+    }
+
+    while( res.GetRow( row ) )
+    {
+        DungeonBlueprint& blueprint = mBlueprints[ row.GetUInt( 0 ) ];
+        blueprint.dungeonID = row.GetUInt( 0 );
+        blueprint.dungeonName = row.GetText( 1 );
+        blueprint.factionID = row.GetUInt( 2 );
+    }
+
+    if( !sDatabase.RunQuery( res,
+        "SELECT dungeonID, objectIndex, objectKind, typeID, ownerID, itemName, x, y, z"
+        " FROM dunTemplateObjects"
+        " ORDER BY dungeonID, objectIndex" ) )
+    {
+        codelog( SERVICE__ERROR, "Error in query: %s", res.error.c_str() );
+        return false;
+    }
+
+    // slots of the objects in their blueprints, by dungeonID and objectIndex
+    std::map< std::pair< uint32, uint32 >, size_t > slots;
+    while( res.GetRow( row ) )
+    {
+        std::map< uint32, DungeonBlueprint >::iterator blueprint = mBlueprints.find( row.GetUInt( 0 ) );
+        if( mBlueprints.end() == blueprint )
+        {
+            _log( SERVICE__ERROR, "Object %u of unknown dungeon %u, skipping.", row.GetUInt( 1 ), row.GetUInt( 0 ) );
+            continue;
+        }
+
+        slots[ std::make_pair( row.GetUInt( 0 ), row.GetUInt( 1 ) ) ] = blueprint->second.objects.size();
+
+        blueprint->second.objects.push_back( DungeonBlueprint::Object() );
+        DungeonBlueprint::Object& object = blueprint->second.objects.back();
+        object.kind = row.GetUInt( 2 );
+        object.typeID = row.GetUInt( 3 );
+        object.ownerID = row.GetUInt( 4 );
+        object.itemName = row.GetText( 5 );
+        object.offset = GPoint( row.GetDouble( 6 ), row.GetDouble( 7 ), row.GetDouble( 8 ) );
+    }
+
+    if( !sDatabase.RunQuery( res,
+        "SELECT o.dungeonID, o.objectIndex,"
+        " e.npcTypeID, e.quantity, e.probability, e.ownerID, e.corporationID"
+        " FROM dunTemplateObjects AS o"
+        " JOIN spawnGroupEntries AS e USING (spawnGroupID)"
+        " WHERE o.objectKind = %u",
+        DungeonBlueprint::OBJECT_NPC_GROUP ) )
+    {
+        codelog( SERVICE__ERROR, "Error in query: %s", res.error.c_str() );
+        return false;
+    }
+
+    while( res.GetRow( row ) )
+    {
+        std::map< std::pair< uint32, uint32 >, size_t >::const_iterator slot = slots.find( std::make_pair( row.GetUInt( 0 ), row.GetUInt( 1 ) ) );
+        if( slots.end() == slot )
+            continue;
+
+        DungeonBlueprint::NPCEntry entry;
+        entry.npcTypeID = row.GetUInt( 2 );
+        entry.quantity = row.GetUInt( 3 );
+        entry.probability = row.GetFloat( 4 );
+        entry.ownerID = row.GetUInt( 5 );
+        entry.corporationID = row.GetUInt( 6 );
+
+        mBlueprints[ row.GetUInt( 0 ) ].objects[ slot->second ].npcs.push_back( entry );
+    }
+
+    return true;
+}
+
+const DungeonBlueprint* DungeonManager::GetBlueprint( uint32 dungeonID ) const
+{
+    std::map< uint32, DungeonBlueprint >::const_iterator res = mBlueprints.find( dungeonID );
+    if( mBlueprints.end() == res )
+        return NULL;
+
+    return &res->second;
+}
+
+DungeonInstance* DungeonManager::GetInstance( uint32 instanceID ) const
+{
+    std::map< uint32, DungeonInstance* >::const_iterator res = mInstances.find( instanceID );
+    if( mInstances.end() == res )
+        return NULL;
+
+    return res->second;
+}
+
+DungeonInstance* DungeonManager::Instantiate( uint32 dungeonID, SystemManager& system, PyServiceMgr& services )
+{
+    const DungeonBlueprint* blueprint = GetBlueprint( dungeonID );
+    if( NULL == blueprint )
+        return NULL;
+
+    // the lowest free pocket
+    std::set< uint32 >& pockets = mPockets[ system.GetID() ];
+    uint32 pocket = 0;
+    while( pockets.count( pocket ) > 0 )
+        ++pocket;
+    pockets.insert( pocket );
+
+    DungeonInstance* instance = new DungeonInstance( mNextInstanceID++, *blueprint, system, pocket, _GetPocketOrigin( pocket ) );
+    mInstances[ instance->GetID() ] = instance;
+
+    ++mStats.instances;
+    mStats.entities += instance->Spawn( services );
+
+    _log( SPAWN__POP, "Spawned instance %u of dungeon %u (%s) in pocket %u of system %u with %u entities.",
+          instance->GetID(), dungeonID, blueprint->dungeonName.c_str(), pocket, system.GetID(), (uint32)instance->size() );
+
+    return instance;
+}
+
+bool DungeonManager::Teardown( uint32 instanceID )
+{
+    std::map< uint32, DungeonInstance* >::iterator res = mInstances.find( instanceID );
+    if( mInstances.end() == res )
+        return false;
+
+    DungeonInstance* instance = res->second;
+    mInstances.erase( res );
+
+    instance->Teardown();
+    mPockets[ instance->GetSystem().GetID() ].erase( instance->GetPocket() );
+    ++mStats.teardowns;
+
+    delete instance;
+    return true;
+}
+
+void DungeonManager::TeardownSystem( uint32 solarSystemID )
+{
+    std::vector< uint32 > instanceIDs;
+
+    std::map< uint32, DungeonInstance* >::const_iterator cur, end;
+    cur = mInstances.begin();
+    end = mInstances.end();
+    for(; cur != end; cur++ )
+    {
+        if( cur->second->GetSystem().GetID() == solarSystemID )
+            instanceIDs.push_back( cur->first );
+    }
+
+    std::vector< uint32 >::const_iterator curi, endi;
+    curi = instanceIDs.begin();
+    endi = instanceIDs.end();
+    for(; curi != endi; curi++ )
+        Teardown( *curi );
+
+    mPockets.erase( solarSystemID );
+}
+
+GPoint DungeonManager::_GetPocketOrigin( uint32 pocket )
+{
+    return GPoint( POCKET_DISTANCE, 0.0, pocket * POCKET_SPACING );
+}
@@ -26,6 +26,7 @@
 #include "eve-server.h"
 
 #include "PyServiceCD.h"
+#include "system/DungeonManager.h"
 #include "system/DungeonService.h"
 
 /*
@@ -91,7 +92,7 @@ PyResult DungeonService::Handle_DEGetFactions( PyCallArgs& call )
 {
     //PyRep *result = NULL;
 
-    sLog.Debug( "DungeonService", "Called DEGetFactions stub." );
+    _debug( "DungeonService", "Called DEGetFactions stub." );
 
     return NULL;
 }
@@ -99,18 +100,42 @@ PyResult DungeonService::Handle_DEGetFactions( PyCallArgs& call )
 
 PyResult DungeonService::Handle_DEGetDungeons( PyCallArgs& call )
 {
-    //PyRep *result = NULL;
     //dict args:
     // factionID
     // or dungeonVID
+    uint32 factionID = 0, dungeonID = 0;
+    if( call.byname.find( "factionID" ) != call.byname.end() && call.byname.find( "factionID" )->second->IsInt() )
+        factionID = call.byname.find( "factionID" )->second->AsInt()->value();
+    if( call.byname.find( "dungeonVID" ) != call.byname.end() && call.byname.find( "dungeonVID" )->second->IsInt() )
+        dungeonID = call.byname.find( "dungeonVID" )->second->AsInt()->value();
 
     // rows: status (1=RELEASE,2=TESTING,else Working Copy),
     //       dungeonVName
     //       dungeonVID
+    DBRowDescriptor* header = new DBRowDescriptor();
+    header->AddColumn( "status", DBTYPE_I4 );
+    header->AddColumn( "dungeonVName", DBTYPE_WSTR );
+    header->AddColumn( "dungeonVID", DBTYPE_I4 );
+    CRowSet* rowset = new CRowSet( &header );
+
+    // answered from the resident blueprints
+    std::map< uint32, DungeonBlueprint >::const_iterator cur, end;
+    cur = sDungeonManager.GetBlueprints().begin();
+    end = sDungeonManager.GetBlueprints().end();
+    for(; cur != end; cur++ )
+    {
+        if( 0 != factionID && cur->second.factionID != factionID )
+            continue;
+        if( 0 != dungeonID && cur->first != dungeonID )
+            continue;
+
+        PyPackedRow* row = rowset->NewRow();
+        row->SetField( (uint32)0, new PyInt( 1 ) );
+        row->SetField( 1, new PyWString( cur->second.dungeonName ) );
+        row->SetField( 2, new PyInt( cur->first ) );
+    }
 
-    sLog.Debug( "DungeonService", "Called DEGetDungeons stub." );
-
-    return NULL;
+    return rowset;
 }
 
 
@@ -121,7 +146,7 @@ PyResult DungeonService::Handle_DEGetRooms( PyCallArgs& call )
 
     //rows: roomName
 
-    sLog.Debug( "DungeonService", "Called DEGetRooms stub." );
+    _debug( "DungeonService", "Called DEGetRooms stub." );
 
     return NULL;
 }
@@ -0,0 +1,130 @@
+/*
+    ------------------------------------------------------------------------------------
+    LICENSE:
+    ------------------------------------------------------------------------------------
+    This file is part of EVEmu: EVE Online Server Emulator
+    Copyright 2006 - 2011 The EVEmu Team
+    For the latest information visit http://evemu.org
+    ------------------------------------------------------------------------------------
+    This program is free software; you can redistribute it and/or modify it under
+    the terms of the GNU Lesser General Public License as published by the Free Software
+    Foundation; either version 2 of the License, or (at your option) any later
+    version.
+
+    This program is distributed in the hope that it will be useful, but WITHOUT
+    ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+    FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public License along with
+    this program; if not, write to the Free Software Foundation, Inc., 59 Temple
+    Place - Suite 330, Boston, MA 02111-1307, USA, or go to
+    http://www.gnu.org/copyleft/lesser.txt.
+    ------------------------------------------------------------------------------------
+    Author:     EVEmu Team
+*/
+
+
+#include "eve-server.h"
+
+#include "Client.h"
+#include "EntityList.h"
+#include "inventory/InventoryDB.h"
+#include "ship/DestinyManager.h"
+#include "system/JumpPipeline.h"
+
+/// Length (in seconds) of the JumpOut animation the pilots watch before they move.
+static const double JUMP_OUT_SECONDS = 5.0;
+
+JumpPipeline::JumpPipeline()
+: mSize( 0 )
+{
+}
+
+bool JumpPipeline::Start( Client* client, uint32 toGate, uint32 solarSystemID, uint32 constellationID, uint32 regionID )
+{
+    const bool booted = sEntityList.IsSystemBooted( solarSystemID );
+    if( NULL == sEntityList.FindOrBootSystem( solarSystemID ) )
+    {
+        ++mStats.failed;
+        return false;
+    }
+    if( !booted )
+        ++mStats.boots;
+
+    // everybody starting during the same tic arrives at the same tic
+    const uint32 due = DestinyManager::GetStamp() + (uint32)ceil( JUMP_OUT_SECONDS / TIC_DURATION_IN_SECONDS );
+
+    Batch& batch = mBatches[ std::make_pair( due, toGate ) ];
+    batch.solarSystemID = solarSystemID;
+    batch.constellationID = constellationID;
+    batch.regionID = regionID;
+    batch.clients.push_back( client );
+
+    ++mSize;
+    ++mStats.started;
+    return true;
+}
+
+void JumpPipeline::Cancel( Client* client )
+{
+    std::map< std::pair< uint32, uint32 >, Batch >::iterator cur, end;
+    cur = mBatches.begin();
+    end = mBatches.end();
+    for(; cur != end; ++cur )
+    {
+        std::vector< Client* >& clients = cur->second.clients;
+
+        std::vector< Client* >::iterator res = std::find( clients.begin(), clients.end(), client );
+        if( res != clients.end() )
+        {
+            clients.erase( res );
+            if( clients.empty() )
+                mBatches.erase( cur );
+
+            --mSize;
+            ++mStats.cancelled;
+            return;
+        }
+    }
+}
+
+void JumpPipeline::Process()
+{
+    const uint32 stamp = DestinyManager::GetStamp();
+
+    while( !mBatches.empty() && mBatches.begin()->first.first <= stamp )
+    {
+        Batch batch;
+        std::swap( batch, mBatches.begin()->second );
+        mBatches.erase( mBatches.begin() );
+        mSize -= batch.clients.size();
+
+        // everybody enters the system before anybody is told
+        std::vector< Client* > arrived;
+        std::vector< uint32 > characterIDs;
+
+        std::vector< Client* >::const_iterator cur, end;
+        cur = batch.clients.begin();
+        end = batch.clients.end();
+        for(; cur != end; ++cur )
+        {
+            if( (*cur)->ArriveThroughGate( batch.solarSystemID, batch.constellationID, batch.regionID ) )
+            {
+                arrived.push_back( *cur );
+                characterIDs.push_back( (*cur)->GetCharacterID() );
+            }
+        }
+
+        InventoryDB::SaveCharacterLocations( characterIDs, 0, batch.solarSystemID, batch.constellationID, batch.regionID );
+
+        cur = arrived.begin();
+        end = arrived.end();
+        for(; cur != end; ++cur )
+            (*cur)->CompleteJump();
+
+        mStats.arrived += arrived.size();
+        ++mStats.batches;
+        if( mStats.maxBatch < arrived.size() )
+            mStats.maxBatch = arrived.size();
+    }
+}
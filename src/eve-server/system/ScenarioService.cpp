@@ -87,7 +87,7 @@ PyBoundObject *ScenarioService::_CreateBoundObject(Client *c, const PyRep *bind_
 
 PyResult ScenarioService::Handle_ResetD( PyCallArgs& call )
 {
-    sLog.Debug( "ScenarioService", "Called ResetD stub." );
+    _debug( "ScenarioService", "Called ResetD stub." );
 
     return new PyNone;
 }
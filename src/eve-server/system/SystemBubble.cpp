@@ -25,26 +25,73 @@
 
 #include "eve-server.h"
 
+#include "Client.h"
+#include "EVEServerConfig.h"
 #include "ship/DestinyManager.h"
 #include "system/BubbleManager.h"
 #include "system/SystemBubble.h"
 #include "system/SystemEntity.h"
+#include "system/SystemManager.h"
+
+EncodedBall::EncodedBall(const SystemEntity &ent, uint32 stamp_)
+: id(ent.GetID()),
+  stamp(stamp_),
+  m_slim(new PyObject("foo.SlimItem", ent.MakeSlimItem())),
+  m_damage(ent.MakeDamageState())
+{
+    ent.EncodeDestiny(m_destiny);
+}
+
+EncodedBall::~EncodedBall() {
+    PyDecRef(m_slim);
+    PyDecRef(m_damage);
+}
+
+void EncodedBall::AppendTo(Buffer &destiny, PyList &slims, std::map<int32, PyRep *> &damages) const {
+    destiny.AppendSeq(m_destiny.begin<uint8>(), m_destiny.end<uint8>());
+
+    PyIncRef(m_slim);
+    slims.AddItem(m_slim);
+
+    PyIncRef(m_damage);
+    std::pair<std::map<int32, PyRep *>::iterator, bool> res = damages.insert(std::make_pair(id, m_damage));
+    if(!res.second) {
+        PyDecRef(res.first->second);
+        res.first->second = m_damage;
+    }
+}
 
 uint32 SystemBubble::m_bubbleIncrementer = 0;
 
+void* SystemBubble::operator new( size_t size )
+{
+    return SystemManager::sMemoryTag.Allocate( size );
+}
+
+void SystemBubble::operator delete( void* p, size_t size )
+{
+    SystemManager::sMemoryTag.Free( p, size );
+}
+
 SystemBubble::SystemBubble(const GPoint &center, double radius)
 : m_center(center),
   m_radius(radius),
   m_radius2(radius*radius),
-  m_position_check_radius_sqrd((radius+BUBBLE_HYSTERESIS_METERS) * (radius+BUBBLE_HYSTERESIS_METERS))
+  m_position_check_radius_sqrd((radius+BUBBLE_HYSTERESIS_METERS) * (radius+BUBBLE_HYSTERESIS_METERS)),
+  m_revision(0)
 {
     _log(DESTINY__BUBBLE_DEBUG, "Created new bubble %p at (%.2f,%.2f,%.2f) with radius %.2f", this, m_center.x, m_center.y, m_center.z, m_radius);
     m_bubbleIncrementer++;
     m_bubbleID = m_bubbleIncrementer;
 }
 
+SystemBubble::~SystemBubble() {
+    clear();
+    m_bubbleID--;
+}
+
 //send a set of destiny events and updates to everybody in the bubble.
-void SystemBubble::BubblecastDestiny(std::vector<PyTuple *> &updates, std::vector<PyTuple *> &events, const char *desc) const {
+void SystemBubble::BubblecastDestiny(std::vector<PyTuple *> &updates, std::vector<PyTuple *> &events, const char *desc, const SystemEntity *about) const {
     //this could be done more efficiently....
     {
         std::vector<PyTuple *>::iterator cur, end;
@@ -52,7 +99,7 @@ void SystemBubble::BubblecastDestiny(std::vector<PyTuple *> &updates, std::vecto
         end = updates.end();
         for(; cur != end; cur++) {
             PyTuple *up = *cur;
-            BubblecastDestinyUpdate(&up, desc);    //update is consumed.
+            BubblecastDestinyUpdate(&up, desc, about);    //update is consumed.
         }
         updates.clear();
     }
@@ -70,27 +117,35 @@ void SystemBubble::BubblecastDestiny(std::vector<PyTuple *> &updates, std::vecto
 
 //send a destiny update to everybody in the bubble.
 //assume that static entities are also not interested in destiny updates.
-void SystemBubble::BubblecastDestinyUpdate( PyTuple** payload, const char* desc ) const
+void SystemBubble::BubblecastDestinyUpdate( PyTuple** payload, const char* desc, const SystemEntity* about ) const
 {
     PyTuple* up = *payload;
-    *payload = NULL;    //could optimize out one of the Clones in here...
+    *payload = NULL;
 
-    PyTuple* up_dup = NULL;
+    //the budget of the clients needs the size, which is the same for all of them.
+    size_t size = 0;
+    if( NULL != about && 0 < sConfig.world.destinyUpdateBudget )
+        MarshalStream().CalcSize( up, size );
 
+    //everybody gets a reference to the same tuple rather than a deep copy;
+    //it is read-only from now on.
     std::set<SystemEntity*>::const_iterator cur, end, tmp;
     cur = m_dynamicEntities.begin();
     end = m_dynamicEntities.end();
     for(; cur != end; ++cur)
     {
-        if( NULL == up_dup )
-            up_dup = new PyTuple( *up );
+        PyTuple* up_ref = up;
+        PyIncRef( up_ref );
 
         _log( DESTINY__BUBBLE_TRACE, "Bubblecast %s update to %s (%u)", desc, (*cur)->GetName(), (*cur)->GetID() );
-        (*cur)->QueueDestinyUpdate( &up_dup );
-        //they may not have consumed it (NPCs for example), so dont re-dup it in that case.
+        if( (*cur)->IsClient() )
+            (*cur)->CastToClient()->QueueBubbleUpdate( &up_ref, about, size );
+        else
+            (*cur)->QueueDestinyUpdate( &up_ref );
+        //they may not have consumed it (NPCs for example).
+        PySafeDecRef( up_ref );
     }
 
-    PySafeDecRef( up_dup );
     PyDecRef( up );
 }
 
@@ -99,24 +154,24 @@ void SystemBubble::BubblecastDestinyUpdate( PyTuple** payload, const char* desc
 void SystemBubble::BubblecastDestinyEvent( PyTuple** payload, const char* desc ) const
 {
     PyTuple* up = *payload;
-    *payload = NULL;    //could optimize out one of the Clones in here...
-
-    PyTuple* up_dup = NULL;
+    *payload = NULL;
 
+    //everybody gets a reference to the same tuple rather than a deep copy;
+    //it is read-only from now on.
     std::set<SystemEntity *>::const_iterator cur, end, tmp;
     cur = m_dynamicEntities.begin();
     end = m_dynamicEntities.end();
     for(; cur != end; ++cur)
     {
-        if( NULL == up_dup )
-            up_dup = new PyTuple( *up );
+        PyTuple* up_ref = up;
+        PyIncRef( up_ref );
 
         _log( DESTINY__BUBBLE_TRACE, "Bubblecast %s event to %s (%u)", desc, (*cur)->GetName(), (*cur)->GetID() );
-        (*cur)->QueueDestinyEvent( &up_dup );
-        //they may not have consumed it (NPCs for example), so dont re-dup it in that case.
+        (*cur)->QueueDestinyEvent( &up_ref );
+        //they may not have consumed it (NPCs for example).
+        PySafeDecRef( up_ref );
     }
 
-    PySafeDecRef( up_dup );
     PyDecRef( up );
 }
 
@@ -162,6 +217,7 @@ void SystemBubble::Add(SystemEntity *ent, bool notify) {
 
     _log(DESTINY__BUBBLE_DEBUG, "Adding entity %u at (%.2f,%.2f,%.2f) to bubble %u at (%.2f,%.2f,%.2f) with radius %.2f", ent->GetID(), ent->GetPosition().x, ent->GetPosition().y, ent->GetPosition().z, this->GetBubbleID(), m_center.x, m_center.y, m_center.z, m_radius);
     m_entities[ent->GetID()] = ent;
+    ++m_revision;
     ent->m_bubble = this;
     if(ent->IsStaticEntity() == false) {
         m_dynamicEntities.insert(ent);
@@ -177,7 +233,14 @@ void SystemBubble::Remove(SystemEntity *ent, bool notify) {
     _log(DESTINY__BUBBLE_DEBUG, "Removing entity %u at (%.2f,%.2f,%.2f) from bubble %u at (%.2f,%.2f,%.2f) with radius %.2f", ent->GetID(), ent->GetPosition().x, ent->GetPosition().y, ent->GetPosition().z, this->GetBubbleID(), m_center.x, m_center.y, m_center.z, m_radius);
     ent->m_bubble = NULL;
     m_entities.erase(ent->GetID());
+    ++m_revision;
     m_dynamicEntities.erase(ent);
+
+    std::map<uint32, EncodedBall *>::iterator res = m_encodedBalls.find(ent->GetID());
+    if(res != m_encodedBalls.end()) {
+        delete res->second;
+        m_encodedBalls.erase(res);
+    }
     //notify after removal so we do not remove ourself.
     if(notify) {
         _SendRemoveBalls(ent);
@@ -188,7 +251,15 @@ void SystemBubble::Remove(SystemEntity *ent, bool notify) {
 
 void SystemBubble::clear() {
     m_entities.clear();
+    ++m_revision;
     m_dynamicEntities.clear();
+
+    std::map<uint32, EncodedBall *>::iterator cur, end;
+    cur = m_encodedBalls.begin();
+    end = m_encodedBalls.end();
+    for(; cur != end; cur++)
+        delete cur->second;
+    m_encodedBalls.clear();
 }
 
 void SystemBubble::GetEntities(std::set<SystemEntity *> &into) const {
@@ -200,6 +271,16 @@ void SystemBubble::GetEntities(std::set<SystemEntity *> &into) const {
     }
 }
 
+void SystemBubble::GetEntitiesInRange(const GPoint &center, double range2, std::vector<SystemEntity *> &into) const {
+    std::map<uint32, SystemEntity *>::const_iterator cur, end;
+    cur = m_entities.begin();
+    end = m_entities.end();
+    for(; cur != end; cur++) {
+        if(GVector(center, cur->second->GetPosition()).lengthSquared() <= range2)
+            into.push_back(cur->second);
+    }
+}
+
 bool SystemBubble::InBubble(const GPoint &pt) const
 {
     // Return true (we're still in this bubble) when System Entity is still within BUBBLE_RADIUS_METERS + BUBBLE_HYSTERESIS_METERS
@@ -207,32 +288,31 @@ bool SystemBubble::InBubble(const GPoint &pt) const
     return(GVector(m_center, pt).lengthSquared() < m_position_check_radius_sqrd);
 }
 
-//NOTE: not used right now. May never be used... see SystemManager::MakeSetState
-//this is called as a part of the SetState routine for initial enter space.
-//it appends information for all entities contained within the bubble.
-/*
-void SystemBubble::AppendBalls(DoDestiny_SetState &ss, std::vector<uint8> &setstate_buffer) const {
-    if(m_entities.empty()) {
-        return;
-    }
+//this is called as a part of the SetState and AddBalls routines.
+//everybody entering the bubble during the same destiny stamp shares the encoding.
+void SystemBubble::AppendBalls(Buffer &destiny, PyList &slims, std::map<int32, PyRep *> &damages) const {
+    const uint32 stamp = DestinyManager::GetStamp();
 
-    //go through all entities and gather the info we need...
     std::map<uint32, SystemEntity *>::const_iterator cur, end;
     cur = m_entities.begin();
     end = m_entities.end();
     for(; cur != end; cur++) {
-        //ss.damageState
-        ss.damageState[ cur->second->GetID() ] = cur->second->MakeDamageState();
+        const SystemEntity *ent = cur->second;
+        if(ent->IsVisibleSystemWide())
+            continue;    //it is already in their destiny state
 
-        //ss.slims
-        PyDict *slim_dict = cur->second->MakeSlimItem();
-        ss.slims.add(new PyObject("foo.SlimItem", slim_dict));
+        EncodedBall *&ball = m_encodedBalls[cur->first];
+        if(ball != NULL && ball->stamp != stamp && !ent->IsStaticEntity()) {
+            //it has moved since.
+            delete ball;
+            ball = NULL;
+        }
+        if(ball == NULL)
+            ball = new EncodedBall(*ent, stamp);
 
-        //append the destiny binary data...
-        cur->second->EncodeDestiny(setstate_buffer);
+        ball->AppendTo(destiny, slims, damages);
     }
 }
-*/
 
 void SystemBubble::_SendAddBalls( SystemEntity* to_who )
 {
@@ -253,21 +333,7 @@ void SystemBubble::_SendAddBalls( SystemEntity* to_who )
     DoDestiny_AddBalls addballs;
     addballs.slims = new PyList;
 
-    std::map<uint32, SystemEntity*>::const_iterator cur, end;
-    cur = m_entities.begin();
-    end = m_entities.end();
-    for(; cur != end; ++cur)
-    {
-        if( cur->second->IsVisibleSystemWide() )
-            continue;    //it is already in their destiny state
-
-        //damageState
-        addballs.damages[ cur->second->GetID() ] = cur->second->MakeDamageState();
-        //slim item
-        addballs.slims->AddItem( new PyObject( "foo.SlimItem", cur->second->MakeSlimItem() ) );
-        //append the destiny binary data...
-        cur->second->EncodeDestiny( *destinyBuffer );
-    }
+    AppendBalls( *destinyBuffer, *addballs.slims, addballs.damages );
 
     addballs.destiny_binary = new PyBuffer( &destinyBuffer );
     SafeDelete( destinyBuffer );
@@ -27,6 +27,40 @@
 
 #include "system/SystemDB.h"
 
+void DBSystemState::GetNeighbours(std::set<uint32> &into) const {
+    std::vector<DBSystemJump>::const_iterator cur, end;
+    cur = jumps.begin();
+    end = jumps.end();
+    for(; cur != end; cur++) {
+        if(cur->toSystemID != 0 && cur->toSystemID != systemID)
+            into.insert(cur->toSystemID);
+    }
+}
+
+bool SystemDB::LoadSystemState(uint32 systemID, DBSystemState &into) {
+    into.systemID = systemID;
+
+    if(!GetSystemInfo(systemID, NULL, NULL, &into.name, &into.security))
+        return false;
+
+    if(!LoadSystemEntities(systemID, into.celestials)) {
+        _log(SERVICE__ERROR, "Unable to load celestial entities of system %u.", systemID);
+        return false;
+    }
+
+    if(!LoadSystemDynamicEntities(systemID, into.dynamics)) {
+        _log(SERVICE__ERROR, "Unable to load dynamic entities of system %u.", systemID);
+        return false;
+    }
+
+    if(!LoadSystemJumps(systemID, into.jumps)) {
+        _log(SERVICE__ERROR, "Unable to load stargate jumps of system %u.", systemID);
+        return false;
+    }
+
+    return true;
+}
+
 bool SystemDB::LoadSystemEntities(uint32 systemID, std::vector<DBSystemEntity> &into) {
     DBQueryResult res;
 
@@ -137,22 +171,61 @@ PyObject *SystemDB::ListFactions() {
     return DBResultToRowset(res);
 }
 
-PyObject *SystemDB::ListJumps(uint32 stargateID) {
+bool SystemDB::LoadSystemJumps(uint32 systemID, std::vector<DBSystemJump> &into) {
     DBQueryResult res;
 
+    //the jumps of all the stargates at once, instead of a query per gate
     if(!sDatabase.RunQuery(res,
         "SELECT "
-        " celestialID AS toCelestialID,"
-        " solarSystemID AS locationID"
-        " FROM mapJumps "
-        "    LEFT JOIN mapDenormalize ON celestialID=itemID"
-        " WHERE stargateID=%u", stargateID))
+        " mapJumps.stargateID,"
+        " mapJumps.celestialID,"
+        " destination.solarSystemID"
+        " FROM mapDenormalize AS gate"
+        "    JOIN mapJumps ON mapJumps.stargateID=gate.itemID"
+        "    LEFT JOIN mapDenormalize AS destination ON mapJumps.celestialID=destination.itemID"
+        " WHERE gate.solarSystemID=%u"
+        " ORDER BY mapJumps.stargateID", systemID))
     {
         codelog(SERVICE__ERROR, "Error in query: %s", res.error.c_str());
-        return NULL;
+        return false;
     }
 
-    return DBResultToRowset(res);
+    DBResultRow row;
+    DBSystemJump entry;
+    while(res.GetRow(row)) {
+        entry.stargateID = row.GetUInt(0);
+        entry.toCelestialID = row.GetUInt(1);
+        entry.toSystemID = (row.IsNull(2) ? 0 : row.GetUInt(2));
+        into.push_back(entry);
+    }
+
+    return true;
+}
+
+PyObject *SystemDB::ListJumps(const std::vector<DBSystemJump> &jumps, uint32 stargateID) {
+    util_Rowset rs;
+
+    rs.header.push_back("toCelestialID");
+    rs.header.push_back("locationID");
+
+    std::vector<DBSystemJump>::const_iterator cur, end;
+    cur = jumps.begin();
+    end = jumps.end();
+    for(; cur != end; cur++) {
+        if(cur->stargateID != stargateID)
+            continue;
+
+        PyList *line = new PyList(2);
+        line->SetItem(0, new PyInt(cur->toCelestialID));
+        if(cur->toSystemID == 0)
+            line->SetItem(1, new PyNone);
+        else
+            line->SetItem(1, new PyInt(cur->toSystemID));
+
+        rs.lines->AddItem(line);
+    }
+
+    return rs.Encode();
 }
 
 uint32 SystemDB::GetObjectLocationID( uint32 itemID ) {
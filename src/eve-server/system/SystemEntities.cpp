@@ -61,7 +61,7 @@ SimpleSystemEntity::SimpleSystemEntity( SystemManager* system, const DBSystemEnt
 {
 }
 
-bool SimpleSystemEntity::LoadExtras(SystemDB *db) {
+bool SimpleSystemEntity::LoadExtras(const DBSystemState &state) {
     return true;
 }
 
@@ -169,11 +169,11 @@ SystemStargateEntity::~SystemStargateEntity() {
     PySafeDecRef( m_jumps );
 }
 
-bool SystemStargateEntity::LoadExtras(SystemDB *db) {
-    if(!SystemStationEntity::LoadExtras(db))
+bool SystemStargateEntity::LoadExtras(const DBSystemState &state) {
+    if(!SystemStationEntity::LoadExtras(state))
         return false;
 
-    m_jumps = db->ListJumps(GetID());
+    m_jumps = SystemDB::ListJumps(state.jumps, GetID());
     if(m_jumps == NULL)
         return false;
     return true;
@@ -192,14 +192,12 @@ PyDict *SystemStargateEntity::MakeSlimItem() const {
 
 
 SystemAsteroidBeltEntity::SystemAsteroidBeltEntity(SystemManager *system, const DBSystemEntity &entity)
-: SimpleSystemEntity(system, entity),
-  m_manager(NULL)
+: SimpleSystemEntity(system, entity)
 {
 }
 
 SystemAsteroidBeltEntity::~SystemAsteroidBeltEntity() {
     targets.DoDestruction();
-    delete m_manager;
 }
 
 void SystemAsteroidBeltEntity::EncodeDestiny( Buffer& into ) const
@@ -219,12 +217,11 @@ void SystemAsteroidBeltEntity::EncodeDestiny( Buffer& into ) const
     into.Append( main );
 }
 
-bool SystemAsteroidBeltEntity::LoadExtras(SystemDB *db) {
-    if(!SimpleSystemEntity::LoadExtras(db))
+bool SystemAsteroidBeltEntity::LoadExtras(const DBSystemState &state) {
+    if(!SimpleSystemEntity::LoadExtras(state))
         return false;
 
-    //TODO: fire up the belt manager.
-    //m_manager = new AsteroidBeltManager(data.itemID);
+    //the ore of the asteroids is kept by the belt manager of the system.
 
     return true;
 }
@@ -39,7 +39,7 @@ SystemEntity::SystemEntity()
 }
 
 void SystemEntity::Process() {
-    targets.Process();
+    //target locks are completed by the timer wheel, nothing to poll here.
 }
 
 uint32 SystemEntity::GetLocationID(SystemEntity *se)
@@ -62,7 +62,9 @@ PyTuple *SystemEntity::MakeDamageState() const {
 
 ItemSystemEntity::ItemSystemEntity(InventoryItemRef self)
 : SystemEntity(),
-  m_self()
+  m_self(),
+  m_resonancesStamp(0),
+  m_resonancesValid(false)
 {
     if( self )
         _SetSelf( self );
@@ -73,6 +75,39 @@ ItemSystemEntity::~ItemSystemEntity()
 {
 }
 
+const ItemSystemEntity::DamageResonances &ItemSystemEntity::_GetDamageResonances() const {
+    const uint32 stamp = DestinyManager::GetStamp();
+    if(m_resonancesValid && m_resonancesStamp == stamp)
+        return(m_resonances);
+
+    m_resonances.shield[0] = m_self->GetAttributeValue(AttrShieldKineticDamageResonance);
+    m_resonances.shield[1] = m_self->GetAttributeValue(AttrShieldThermalDamageResonance);
+    m_resonances.shield[2] = m_self->GetAttributeValue(AttrShieldEmDamageResonance);
+    m_resonances.shield[3] = m_self->GetAttributeValue(AttrShieldExplosiveDamageResonance);
+
+    m_resonances.armor[0] = m_self->GetAttributeValue(AttrArmorKineticDamageResonance);
+    m_resonances.armor[1] = m_self->GetAttributeValue(AttrArmorThermalDamageResonance);
+    m_resonances.armor[2] = m_self->GetAttributeValue(AttrArmorEmDamageResonance);
+    m_resonances.armor[3] = m_self->GetAttributeValue(AttrArmorExplosiveDamageResonance);
+
+    m_resonances.hull[0] = m_self->GetAttribute(AttrHullKineticDamageResonance).get_float();
+    m_resonances.hull[1] = m_self->GetAttribute(AttrHullThermalDamageResonance).get_float();
+    m_resonances.hull[2] = m_self->GetAttribute(AttrHullEmDamageResonance).get_float();
+    m_resonances.hull[3] = m_self->GetAttribute(AttrHullExplosiveDamageResonance).get_float();
+
+    m_resonancesStamp = stamp;
+    m_resonancesValid = true;
+    return(m_resonances);
+}
+
+double ItemSystemEntity::_GetShieldCharge() const {
+    return m_self->GetAttributeValue(AttrShieldCharge);
+}
+
+void ItemSystemEntity::_SetShieldCharge(double charge) {
+    m_self->SetAttribute(AttrShieldCharge, charge);
+}
+
 void ItemSystemEntity::_SetSelf(InventoryItemRef self) {
     if( !self ) {
         codelog(ITEM__ERROR, "Tried to set self to NULL!");
@@ -80,6 +115,7 @@ void ItemSystemEntity::_SetSelf(InventoryItemRef self) {
     }
 
     m_self = self;
+    m_resonancesValid = false;
 
     // DEPRECATED NOW WITH THE USE OF NEW ATTRIBUTE SYSTEM AND SAVING OF THOSE ATTRIBUTES TO THE DB -- Aknor Jaden
     //I am not sure where the right place to do this is, but until
@@ -104,7 +140,7 @@ float ItemSystemEntity::GetRadius() const {
     if(!m_self)
         return(1.0f);
     //return(m_self->radius());
-    return static_cast<float>(m_self->GetAttribute(AttrRadius).get_float());
+    return static_cast<float>(m_self->GetAttributeValue(AttrRadius));
 }
 
 const GPoint &ItemSystemEntity::GetPosition() const {
@@ -152,6 +188,10 @@ void DynamicSystemEntity::ProcessDestiny() {
         m_destiny->Process();
 }
 
+bool DynamicSystemEntity::IsDestinyIdle() const {
+    return(m_destiny == NULL || m_destiny->IsIdle());
+}
+
 const GPoint &DynamicSystemEntity::GetPosition() const {
     if(m_destiny == NULL)
         return(ItemSystemEntity::GetPosition());
@@ -168,19 +208,19 @@ const GVector &DynamicSystemEntity::GetVelocity() const {
 double DynamicSystemEntity::GetMass() const {
     if(!Item())
         return(0.0f);
-    return Item()->GetAttribute(AttrMass).get_float();
+    return Item()->GetAttributeValue(AttrMass);
 }
 
 double DynamicSystemEntity::GetMaxVelocity() const {
     if(!Item())
         return(0.0f);
-    return Item()->GetAttribute(AttrMaxVelocity).get_float();
+    return Item()->GetAttributeValue(AttrMaxVelocity);
 }
 
 double DynamicSystemEntity::GetAgility() const {
     if(!Item())
         return(0.0f);
-    return Item()->GetAttribute(AttrAgility).get_float();
+    return Item()->GetAttributeValue(AttrAgility);
 }
 
 //TODO: ask the destiny manager to do this for us!
@@ -291,12 +331,12 @@ void DynamicSystemEntity::EncodeDestiny( Buffer& into ) const
 
 
 void ItemSystemEntity::MakeDamageState(DoDestinyDamageState &into) const {
-    into.shield = (m_self->GetAttribute(AttrShieldCharge).get_float() / m_self->GetAttribute(AttrShieldCapacity).get_float());
+    into.shield = (_GetShieldCharge() / m_self->GetAttributeValue(AttrShieldCapacity));
     into.tau = 100000;    //no freaking clue.
     into.timestamp = Win32TimeNow();
 //    armor damage isn't working...
-    into.armor = 1.0 - (m_self->GetAttribute(AttrArmorDamage).get_float() / m_self->GetAttribute(AttrArmorHP).get_float());
-    into.structure = 1.0 - (m_self->GetAttribute(AttrDamage).get_float() / m_self->GetAttribute(AttrHp).get_float());
+    into.armor = 1.0 - (m_self->GetAttributeValue(AttrArmorDamage) / m_self->GetAttributeValue(AttrArmorHP));
+    into.structure = 1.0 - (m_self->GetAttributeValue(AttrDamage) / m_self->GetAttributeValue(AttrHp));
 }
 
 
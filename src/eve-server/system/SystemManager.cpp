@@ -26,16 +26,21 @@
 #include "eve-server.h"
 
 #include "Client.h"
+#include "admin/StressTest.h"
 #include "chat/LSCService.h"
 #include "mining/Asteroid.h"
+#include "mining/AsteroidBeltManager.h"
 #include "npc/NPC.h"
 #include "npc/SpawnManager.h"
 #include "pos/Structure.h"
 #include "ship/Drone.h"
+#include "ship/DroneSwarm.h"
 #include "ship/Ship.h"
 #include "station/Station.h"
 #include "system/Container.h"
+#include "system/Damage.h"
 #include "system/Deployable.h"
+#include "system/DungeonManager.h"
 #include "system/SolarSystem.h"
 #include "system/SystemBubble.h"
 #include "system/SystemEntities.h"
@@ -43,16 +48,36 @@
 
 using namespace Destiny;
 
+/** @return Histogram of the durations of SystemManager::Process(). */
+static MetricHistogram& SystemTickMetric()
+{
+    static MetricHistogram& metric = sMetrics.LatencyHistogram( "evemu_system_tick_seconds", "Time a solar system took to process its entities." );
+    return metric;
+}
+/** @return Histogram of the durations of SystemManager::ProcessDestiny(). */
+static MetricHistogram& SystemDestinyMetric()
+{
+    static MetricHistogram& metric = sMetrics.LatencyHistogram( "evemu_system_destiny_seconds", "Time a solar system took to process a destiny tick." );
+    return metric;
+}
+
+MemoryTag SystemManager::sMemoryTag( "systems" );
+
 SystemManager::SystemManager(uint32 systemID, PyServiceMgr &svc)//, ItemData idata)
 : m_systemID(systemID),
   m_systemName(""),
   m_services(svc),
   m_spawnManager(new SpawnManager(*this, m_services)),
-  m_entityChanged(false)//,
+  m_beltManager(new AsteroidBeltManager(*this)),
+  m_droneManager(new DroneSwarmManager(*this)),
+  m_entityChanged(false),
+  m_tickStamp(0),
+  m_destinyStamp(0),
+  m_staticBallsStale(true),
+  m_sharedSetStateStamp(0),
+  m_entityRevision(0)//,
 //  InventoryItem( svc.item_factory, systemID, *(svc.item_factory.GetType( 5 )), idata )
 {
-    m_db.GetSystemInfo(GetID(), NULL, NULL, &m_systemName, &m_systemSecurity);
-
     m_solarSystemRef = svc.item_factory.GetSolarSystem( systemID );
     uint32 inventoryID = m_solarSystemRef->itemID();
 
@@ -61,23 +86,132 @@ SystemManager::SystemManager(uint32 systemID, PyServiceMgr &svc)//, ItemData ida
 }
 
 SystemManager::~SystemManager() {
+    //the dungeons remove and delete their own entities.
+    sDungeonManager.TeardownSystem(m_systemID);
+    //and so do the stress tests.
+    sStressTest.TeardownSystem(m_systemID);
+    //snapshots the ore of the asteroids while they are still around.
+    delete m_beltManager;
+
     //we mustn't delete clients because they are owned by the entity list.
-    std::map<uint32, SystemEntity *>::iterator cur, end, tmp;
-    cur = m_entities.begin();
-    end = m_entities.end();
-    while(cur != end) {
-        SystemEntity *se = cur->second;
-        cur++;
-
-        if(!se->IsClient())
-            delete se;
+    std::vector<SystemEntity *> entities(m_staticEntities);
+    for(size_t i = 0; i < m_dynamicEntities.size(); i++)
+        entities.push_back(m_dynamicEntities[i].entity);
+
+    std::vector<SystemEntity *>::iterator cur, end;
+    cur = entities.begin();
+    end = entities.end();
+    for(; cur != end; cur++) {
+        if(!(*cur)->IsClient())
+            delete *cur;
     }
 
     //must be deleted AFTER all the NPCs which it spawn have been, since
     //they will call back to their spawning spawn entries.
     delete m_spawnManager;
+    //likewise, the drones leave their swarms as they go.
+    delete m_droneManager;
 
     bubbles.clear();
+    _ClearStaticBalls();
+    _ClearSharedSetStates();
+
+    std::map<uint32, Damage *>::iterator curk, endk;
+    curk = m_pendingKills.begin();
+    endk = m_pendingKills.end();
+    for(; curk != endk; curk++)
+        delete curk->second;
+}
+
+void SystemManager::_ClearStaticBalls() const {
+    std::vector<EncodedBall *>::iterator cur, end;
+    cur = m_staticBalls.begin();
+    end = m_staticBalls.end();
+    for(; cur != end; cur++)
+        delete *cur;
+    m_staticBalls.clear();
+}
+
+//the parts of a SetState everybody getting one for the same bubble and stamp shares; all but the ego.
+struct SystemManager::SharedSetState {
+    SharedSetState(const DoDestiny_SetState &ss, uint32 entityRevision_, uint32 bubbleRevision_)
+    : entityRevision(entityRevision_),
+      bubbleRevision(bubbleRevision_),
+      state(ss.destiny_state),
+      slims(ss.slims),
+      damageState(ss.damageState),
+      droneState(ss.droneState),
+      solItem(ss.solItem)
+    {
+        PyIncRef(state);
+        PyIncRef(slims);
+        PyIncRef(droneState);
+        PyIncRef(solItem);
+
+        std::map<int32, PyRep *>::const_iterator cur, end;
+        cur = damageState.begin();
+        end = damageState.end();
+        for(; cur != end; cur++)
+            PyIncRef(cur->second);
+    }
+    ~SharedSetState() {
+        PyDecRef(state);
+        PyDecRef(slims);
+        PyDecRef(droneState);
+        PyDecRef(solItem);
+
+        std::map<int32, PyRep *>::const_iterator cur, end;
+        cur = damageState.begin();
+        end = damageState.end();
+        for(; cur != end; cur++)
+            PyDecRef(cur->second);
+    }
+
+    void CopyTo(DoDestiny_SetState &ss) const {
+        PySafeDecRef(ss.destiny_state);
+        ss.destiny_state = state;
+        PyIncRef(state);
+
+        PySafeDecRef(ss.slims);
+        ss.slims = slims;
+        PyIncRef(slims);
+
+        PySafeDecRef(ss.droneState);
+        ss.droneState = droneState;
+        PyIncRef(droneState);
+
+        PySafeDecRef(ss.solItem);
+        ss.solItem = solItem;
+        PyIncRef(solItem);
+
+        std::map<int32, PyRep *>::const_iterator cur, end;
+        cur = damageState.begin();
+        end = damageState.end();
+        for(; cur != end; cur++) {
+            PyRep *&into = ss.damageState[cur->first];
+            PySafeDecRef(into);
+            into = cur->second;
+            PyIncRef(into);
+        }
+    }
+
+    const uint32 entityRevision;
+    const uint32 bubbleRevision;
+
+    PyBuffer *const state;
+    PyList *const slims;
+    const std::map<int32, PyRep *> damageState;
+    PyRep *const droneState;
+    PyRep *const solItem;
+};
+
+void SystemManager::_ClearSharedSetStates() const {
+    std::map<uint32, SharedSetState *>::iterator cur, end;
+    cur = m_sharedSetStates.begin();
+    end = m_sharedSetStates.end();
+    for(; cur != end; cur++)
+        delete cur->second;
+    m_sharedSetStates.clear();
 }
 
 static const int num_hack_sentry_locs = 8;
@@ -92,18 +226,12 @@ GPoint hack_sentry_locs[num_hack_sentry_locs] = {
     GPoint(35000.0f, 35000.0f, 35000.0f)
 };
 
-bool SystemManager::_LoadSystemCelestials() {
-    std::vector<DBSystemEntity> entities;
-    if(!m_db.LoadSystemEntities(m_systemID, entities)) {
-        _log(SERVICE__ERROR, "Unable to load celestial entities during boot of system %u.", m_systemID);
-        return false;
-    }
-
+bool SystemManager::_LoadSystemCelestials(const DBSystemState &state) {
     //uint32 next_hack_entity_ID = m_systemID + 900000000;
 
-    std::vector<DBSystemEntity>::iterator cur, end;
-    cur = entities.begin();
-    end = entities.end();
+    std::vector<DBSystemEntity>::const_iterator cur, end;
+    cur = state.celestials.begin();
+    end = state.celestials.end();
     for(; cur != end; ++cur) {
         if( itemFactory().GetItem( cur->itemID ) )
         {
@@ -128,7 +256,7 @@ bool SystemManager::_LoadSystemCelestials() {
                 stationRef->SetAttribute(AttrRadius,        stationRef->type().attributes.radius());     // Radius
                 stationRef->SetAttribute(AttrVolume,        stationRef->type().attributes.volume());     // Volume
 
-                m_entities[stationEntity->GetStationObject()->itemID()] = stationEntity;
+                _InsertEntity(stationEntity);
                 bubbles.Add(stationEntity, true);
                 m_entityChanged = true;
             }
@@ -140,12 +268,12 @@ bool SystemManager::_LoadSystemCelestials() {
                     codelog(SERVICE__ERROR, "Failed to create entity for item %u (type %u)", cur->itemID, cur->typeID);
                     continue;
                 }
-                if(!se->LoadExtras(&m_db)) {
+                if(!se->LoadExtras(state)) {
                     _log(SERVICE__ERROR, "Failed to load additional data for entity %u. Skipping.", se->GetID());
                     delete se;
                     continue;
                 }
-                m_entities[se->GetID()] = se;
+                _InsertEntity(se);
                 bubbles.Add(se, false);
                 m_entityChanged = true;
             }
@@ -156,12 +284,12 @@ bool SystemManager::_LoadSystemCelestials() {
                     codelog(SERVICE__ERROR, "Failed to create entity for item %u (type %u)", cur->itemID, cur->typeID);
                     continue;
                 }
-                if(!se->LoadExtras(&m_db)) {
+                if(!se->LoadExtras(state)) {
                     _log(SERVICE__ERROR, "Failed to load additional data for entity %u. Skipping.", se->GetID());
                     delete se;
                     continue;
                 }
-                m_entities[se->GetID()] = se;
+                _InsertEntity(se);
                 //bubbles.Add(se, false);
                 m_entityChanged = true;
             }
@@ -494,18 +622,12 @@ public:
     }
 };
 
-bool SystemManager::_LoadSystemDynamics() {
-    std::vector<DBSystemDynamicEntity> entities;
-    if(!m_db.LoadSystemDynamicEntities(m_systemID, entities)) {
-        _log(SERVICE__ERROR, "Unable to load dynamic entities during boot of system %u.", m_systemID);
-        return false;
-    }
-
+bool SystemManager::_LoadSystemDynamics(const DBSystemState &state) {
     //uint32 next_hack_entity_ID = m_systemID + 900000000;
 
-    std::vector<DBSystemDynamicEntity>::iterator cur, end;
-    cur = entities.begin();
-    end = entities.end();
+    std::vector<DBSystemDynamicEntity>::const_iterator cur, end;
+    cur = state.dynamics.begin();
+    end = state.dynamics.end();
     for(; cur != end; cur++) {
         SystemEntity *se = DynamicEntityFactory::BuildEntity(*this, m_services.item_factory, *cur);
         if(se == NULL) {
@@ -514,7 +636,7 @@ bool SystemManager::_LoadSystemDynamics() {
         }
         //TODO: use proper log type.
         _log(SPAWN__MESSAGE, "Loaded dynamic entity %u of type %u for system %u", cur->itemID, cur->typeID, m_systemID);
-        m_entities[se->GetID()] = se;
+        _InsertEntity(se);
         bubbles.Add(se, false);
         m_entityChanged = true;
     }
@@ -523,15 +645,31 @@ bool SystemManager::_LoadSystemDynamics() {
 }
 
 bool SystemManager::BootSystem() {
+    DBSystemState state;
+    if(!m_db.LoadSystemState(m_systemID, state)) {
+        _log(SERVICE__ERROR, "Unable to load state during boot of system %u.", m_systemID);
+        return false;
+    }
+
+    return BootSystem(state);
+}
+
+bool SystemManager::BootSystem(const DBSystemState &state) {
+    assert(state.systemID == m_systemID);
+
+    m_systemName = state.name;
+    m_systemSecurity = state.security;
 
     //load the static system stuff...
-    if(!_LoadSystemCelestials())
+    if(!_LoadSystemCelestials(state))
         return false;
 
     //load the dynamic system stuff (items, roids, etc...)
-    if(!_LoadSystemDynamics())
+    if(!_LoadSystemDynamics(state))
         return false;
 
+    state.GetNeighbours(m_neighbours);
+
     /* temporarily commented out until we find out why they
      * make client angry ...
     //the statics have been loaded, now load up the spawns...
@@ -551,53 +689,88 @@ bool SystemManager::BootSystem() {
 
 //called many times a second
 bool SystemManager::Process() {
+    ProfileZone zone("System", m_systemID);
+    const uint64 start = GetTimeUSeconds();
     m_entityChanged = false;
+    ++m_tickStamp;
+
+    //only the entities whose Process() does anything are visited.
+    for(size_t i = 0; i < m_dynamicEntities.size(); ) {
+        EntitySlot &slot = m_dynamicEntities[i];
+        if(!slot.ticked || slot.tickStamp == m_tickStamp) {
+            i++;
+            continue;
+        }
 
-    std::map<uint32, SystemEntity *>::const_iterator cur, end;
-    cur = m_entities.begin();
-    end = m_entities.end();
-    while(cur != end) {
-        cur->second->Process();
+        slot.tickStamp = m_tickStamp;
+        slot.entity->Process();
 
         if(m_entityChanged) {
-            //somebody changed the entity list, need to start over or bail...
+            //somebody changed the entity list, which may have moved the entities;
+            //start over, skipping those visited already.
             m_entityChanged = false;
-
-            cur = m_entities.begin();
-            end = m_entities.end();
+            i = 0;
         } else {
-            cur++;
+            i++;
         }
     }
 
+    //the mining of the tic hits the asteroids at once.
+    m_beltManager->Process();
+    //so do the drones of every pilot.
+    m_droneManager->Process();
+
+    //everybody had their shot, now the dead may go.
+    _ResolveKills();
+
     bubbles.Process();
 
+    const uint32 elapsed = static_cast<uint32>(GetTimeUSeconds() - start);
+    SystemTickMetric().Observe(elapsed);
+    ++m_tickStats.ticks;
+    m_tickStats.tickTime += elapsed;
+    if(m_tickStats.maxTickTime < elapsed)
+        m_tickStats.maxTickTime = elapsed;
+
     return true;
 }
 
 //called once per second.
 void SystemManager::ProcessDestiny() {
-    //this is here so it isnt called so frequently.
-    m_spawnManager->Process();
-
+    ProfileZone zone("Destiny", m_systemID);
+    const uint64 start = GetTimeUSeconds();
     m_entityChanged = false;
+    ++m_destinyStamp;
 
-    std::map<uint32, SystemEntity *>::const_iterator cur, end;
-    cur = m_entities.begin();
-    end = m_entities.end();
-    while(cur != end) {
-        cur->second->ProcessDestiny();
+    //the balls at rest have nothing to move.
+    for(size_t i = 0; i < m_dynamicEntities.size(); ) {
+        EntitySlot &slot = m_dynamicEntities[i];
+        if(slot.destinyStamp == m_destinyStamp || slot.mover->IsDestinyIdle()) {
+            i++;
+            continue;
+        }
+
+        slot.destinyStamp = m_destinyStamp;
+        slot.entity->ProcessDestiny();
 
         if(m_entityChanged) {
-            //somebody changed the entity list, need to start over or bail...
+            //somebody changed the entity list, which may have moved the entities;
+            //start over, skipping those visited already.
             m_entityChanged = false;
-
-            cur = m_entities.begin();
-            end = m_entities.end();
+            i = 0;
         } else {
-            cur++;
+            i++;
         }
     }
+
+    _SendDamageStates();
+
+    const uint32 elapsed = static_cast<uint32>(GetTimeUSeconds() - start);
+    SystemDestinyMetric().Observe(elapsed);
+    ++m_tickStats.destinyTicks;
+    m_tickStats.destinyTime += elapsed;
+    if(m_tickStats.maxDestinyTime < elapsed)
+        m_tickStats.maxDestinyTime = elapsed;
 }
 
 bool SystemManager::BuildDynamicEntity(Client *who, const DBSystemDynamicEntity &entity)
@@ -609,8 +782,8 @@ bool SystemManager::BuildDynamicEntity(Client *who, const DBSystemDynamicEntity
         return false;
     }
 
-    sLog.Debug( "SystemManager::BuildDynamicEntity()", "Loaded dynamic entity %u of type %u for system %u", entity.itemID, entity.typeID, m_systemID );
-    m_entities[se->GetID()] = se;
+    _debug( "SystemManager::BuildDynamicEntity()", "Loaded dynamic entity %u of type %u for system %u", entity.itemID, entity.typeID, m_systemID );
+    _InsertEntity(se);
     bubbles.Add(se, false);
     m_entityChanged = true;
 
@@ -619,8 +792,6 @@ bool SystemManager::BuildDynamicEntity(Client *who, const DBSystemDynamicEntity
 
 void SystemManager::AddClient(Client *who) {
     AddEntity( who );
-    m_entities[who->GetID()] = who;
-    m_entityChanged = true;
     //this is actually handled in SetPosition via UpdateBubble.
     if(who->IsInSpace()) {
         bubbles.Add(who, false);
@@ -632,6 +803,7 @@ void SystemManager::AddClient(Client *who) {
 }
 
 void SystemManager::RemoveClient(Client *who) {
+    m_droneManager->Abandon(who);
     RemoveEntity(who);
     _log(CLIENT__TRACE, "%s: Removed from system manager for %u", who->GetName(), m_systemID);
 
@@ -656,34 +828,154 @@ void SystemManager::RemoveNPC(NPC *who) {
 }
 
 void SystemManager::AddEntity(SystemEntity *who) {
-    m_entities[who->GetID()] = who;
+    _InsertEntity(who);
     m_entityChanged = true;
+    ++m_entityRevision;
+    if(who->IsStaticEntity())
+        m_staticBallsStale = true;
     bubbles.Add(who, false);
 
+    if(who->GetClass() == SystemEntity::ecAsteroidEntity)
+        m_beltManager->AddAsteroid(static_cast<AsteroidEntity *>(who));
+
     // Add Entity's Item Ref to Solar System Dynamic Inventory:
     AddItemToInventory( this->itemFactory().GetItem( who->GetID() ) );
 }
 
 void SystemManager::RemoveEntity(SystemEntity *who) {
-    std::map<uint32, SystemEntity *>::iterator itr = m_entities.find(who->GetID());
-    if(itr != m_entities.end()) {
-        m_entities.erase(itr);
+    if(_EraseEntity(who->GetID())) {
         m_entityChanged = true;
+        ++m_entityRevision;
+        if(who->IsStaticEntity())
+            m_staticBallsStale = true;
     } else
         _log(SERVICE__ERROR, "Entity %u not found is system %u to be deleted.", who->GetID(), GetID());
 
     bubbles.Remove(who, false);
 
+    if(who->GetClass() == SystemEntity::ecAsteroidEntity)
+        m_beltManager->RemoveAsteroid(who->GetID());
+
     // Remove Entity's Item Ref from Solar System Dynamic Inventory:
     RemoveItemFromInventory( this->itemFactory().GetItem( who->GetID() ) );
 }
 
+void SystemManager::QueueKill(SystemEntity *who, const Damage &fatal_blow) {
+    std::map<uint32, Damage *>::iterator res = m_pendingKills.find(who->GetID());
+    if(res == m_pendingKills.end())
+        m_pendingKills.insert(std::make_pair(who->GetID(), new Damage(fatal_blow)));
+}
+
+void SystemManager::_ResolveKills() {
+    //killing may produce more kills, take them one at a time.
+    while(!m_pendingKills.empty()) {
+        std::map<uint32, Damage *>::iterator res = m_pendingKills.begin();
+        const uint32 entityID = res->first;
+        Damage *fatal_blow = res->second;
+
+        SystemEntity *who = get(entityID);
+        if(who != NULL) {
+            //the dead need no damage state.
+            m_damageStateChanged.erase(entityID);
+            who->Killed(*fatal_blow);
+        }
+
+        //the entry stays until Killed() returns, so it is not hit again meanwhile.
+        m_pendingKills.erase(entityID);
+        delete fatal_blow;
+    }
+}
+
+void SystemManager::_SendDamageStates() {
+    std::set<uint32>::const_iterator cur, end;
+    cur = m_damageStateChanged.begin();
+    end = m_damageStateChanged.end();
+    for(; cur != end; cur++) {
+        SystemEntity *who = get(*cur);
+        if(who == NULL)
+            continue;
+
+        DoDestinyDamageState state;
+        who->MakeDamageState(state);
+
+        DoDestiny_OnDamageStateChange ddsc;
+        ddsc.entityID = who->GetID();
+        ddsc.state = state.Encode();
+
+        PyTuple *up = ddsc.Encode();
+        who->targets.QueueTBDestinyUpdate(&up);
+    }
+    m_damageStateChanged.clear();
+}
+
 SystemEntity *SystemManager::get(uint32 entityID) const {
-    std::map<uint32, SystemEntity *>::const_iterator res;
-    res = m_entities.find(entityID);
-    if(res == m_entities.end())
+    std::tr1::unordered_map<uint32, EntityRef>::const_iterator res;
+    res = m_entityIndex.find(entityID);
+    if(res == m_entityIndex.end())
         return NULL;
-    return(res->second);
+    return(res->second.entity);
+}
+
+void SystemManager::_InsertEntity(SystemEntity *who) {
+    const uint32 entityID = who->GetID();
+
+    std::tr1::unordered_map<uint32, EntityRef>::const_iterator res = m_entityIndex.find(entityID);
+    if(res != m_entityIndex.end()) {
+        if(res->second.entity == who)
+            return;
+        //a new entity of the ID replaces the old one.
+        _EraseEntity(entityID);
+    }
+
+    EntityRef ref;
+    ref.entity = who;
+    ref.isStatic = who->IsStaticEntity();
+    if(ref.isStatic) {
+        ref.slot = static_cast<uint32>(m_staticEntities.size());
+        m_staticEntities.push_back(who);
+    } else {
+        EntitySlot slot;
+        slot.entity = who;
+        //only DynamicSystemEntity and its descendants move.
+        slot.mover = static_cast<DynamicSystemEntity *>(who);
+        slot.ticked = who->IsTicked();
+        //not visited yet, even when added in the middle of a tic.
+        slot.tickStamp = m_tickStamp - 1;
+        slot.destinyStamp = m_destinyStamp - 1;
+
+        ref.slot = static_cast<uint32>(m_dynamicEntities.size());
+        m_dynamicEntities.push_back(slot);
+    }
+
+    m_entityIndex[entityID] = ref;
+}
+
+bool SystemManager::_EraseEntity(uint32 entityID) {
+    std::tr1::unordered_map<uint32, EntityRef>::iterator res = m_entityIndex.find(entityID);
+    if(res == m_entityIndex.end())
+        return false;
+
+    const EntityRef ref = res->second;
+    m_entityIndex.erase(res);
+
+    //the last entity of the list fills the hole.
+    if(ref.isStatic) {
+        if(ref.slot + 1 < m_staticEntities.size()) {
+            SystemEntity *last = m_staticEntities.back();
+            m_staticEntities[ref.slot] = last;
+            m_entityIndex[last->GetID()].slot = ref.slot;
+        }
+        m_staticEntities.pop_back();
+    } else {
+        if(ref.slot + 1 < m_dynamicEntities.size()) {
+            const EntitySlot &last = m_dynamicEntities.back();
+            m_entityIndex[last.entity->GetID()].slot = ref.slot;
+            m_dynamicEntities[ref.slot] = last;
+        }
+        m_dynamicEntities.pop_back();
+    }
+
+    return true;
 }
 
 /* maybe this is the reason why warping sucks... */
@@ -696,6 +988,27 @@ double SystemManager::GetWarpSpeed() const {
 
 void SystemManager::MakeSetState(const SystemBubble *bubble, DoDestiny_SetState &ss) const
 {
+    //within a stamp nothing moves, so the SetState of a bubble only changes
+    //when somebody enters or leaves; everybody else gets the same one.
+    if( m_sharedSetStateStamp != ss.stamp )
+    {
+        _ClearSharedSetStates();
+        m_sharedSetStateStamp = ss.stamp;
+    }
+
+    SharedSetState*& shared = m_sharedSetStates[ bubble->GetBubbleID() ];
+    if( NULL != shared
+        && ( shared->entityRevision != m_entityRevision || shared->bubbleRevision != bubble->GetRevision() ) )
+        SafeDelete( shared );
+
+    if( NULL != shared )
+    {
+        shared->CopyTo( ss );
+        ss.effectStates = new PyList;
+        ss.allianceBridges = new PyList;
+        return;
+    }
+
     Buffer* stateBuffer = new Buffer;
 
     AddBall_header head;
@@ -703,58 +1016,48 @@ void SystemManager::MakeSetState(const SystemBubble *bubble, DoDestiny_SetState
     head.sequence = ss.stamp;
     stateBuffer->Append( head );
 
+    PySafeDecRef( ss.slims );
+    ss.slims = new PyList;
 
-    //I am not thrilled with this mechanism, but I cant think of a better
-    //way to deal with it right now. The issue is that we need to send out
-    // info for all system-wide entities (celestials, etc), as well as all
-    // entities in our current bubble. Well, it is likely that some things
-    // in our bubble are system-wide, and we would be sending out duplciates.
-    // so, we use a set to enforce uniqueness.
-    std::set<SystemEntity*> visibleEntities;
+    //the system wide entities come first; the celestials, stations and
+    //gates never change, so they are encoded only once.
+    if( m_staticBallsStale )
     {
-        std::map<uint32, SystemEntity*>::const_iterator cur, end;
-        cur = m_entities.begin();
-        end = m_entities.end();
+        _ClearStaticBalls();
+
+        std::vector<SystemEntity*>::const_iterator cur, end;
+        cur = m_staticEntities.begin();
+        end = m_staticEntities.end();
         for(; cur != end; ++cur)
         {
-            if( !cur->second->IsVisibleSystemWide() )
-            {
-                //_log(COMMON__WARNING, "%u is not visible!", cur->first);
-                continue;
-            }
-
-            //_log(COMMON__WARNING, "%u is system wide visible!", cur->first);
-            visibleEntities.insert( cur->second );
+            if( (*cur)->IsVisibleSystemWide() )
+                m_staticBalls.push_back( new EncodedBall( **cur, 0 ) );
         }
+        m_staticBallsStale = false;
     }
 
-    //bubble is null??? why???
-    bubble->GetEntities( visibleEntities );
-
-    PySafeDecRef( ss.slims );
-    ss.slims = new PyList;
-
-    //go through all entities and gather the info we need...
-    std::set<SystemEntity*>::const_iterator cur, end;
-    cur = visibleEntities.begin();
-    end = visibleEntities.end();
-    for(; cur != end; ++cur)
     {
-        SystemEntity* ent = *cur;
-        _log(COMMON__WARNING, "Encoding entity %u", ent->GetID());
-
-        //ss.damageState
-        ss.damageState[ ent->GetID() ] = ent->MakeDamageState();
-
-        //ss.aggressors
-
-        //ss.slims
-        ss.slims->AddItem( new PyObject( "foo.SlimItem", ent->MakeSlimItem() ) );
+        std::vector<EncodedBall*>::const_iterator cur, end;
+        cur = m_staticBalls.begin();
+        end = m_staticBalls.end();
+        for(; cur != end; ++cur)
+            (*cur)->AppendTo( *stateBuffer, *ss.slims, ss.damageState );
+    }
 
-        //append the destiny binary data...
-        ent->EncodeDestiny( *stateBuffer );
+    {
+        std::vector<EntitySlot>::const_iterator cur, end;
+        cur = m_dynamicEntities.begin();
+        end = m_dynamicEntities.end();
+        for(; cur != end; ++cur)
+        {
+            if( cur->entity->IsVisibleSystemWide() )
+                EncodedBall( *cur->entity, ss.stamp ).AppendTo( *stateBuffer, *ss.slims, ss.damageState );
+        }
     }
 
+    //then the rest of our bubble, which shares the encoding with everybody entering it this stamp.
+    bubble->AppendBalls( *stateBuffer, *ss.slims, ss.damageState );
+
     //ss.destiny_state
     ss.destiny_state = new PyBuffer( &stateBuffer );
     SafeDelete( stateBuffer );
@@ -783,6 +1086,8 @@ void SystemManager::MakeSetState(const SystemBubble *bubble, DoDestiny_SetState
     //ss.allianceBridges
     ss.allianceBridges = new PyList;
 
+    shared = new SharedSetState( ss, m_entityRevision, bubble->GetRevision() );
+
     _log( DESTINY__TRACE, "Set State:" );
     ss.Dump( DESTINY__TRACE, "    " );
     _log( DESTINY__TRACE, "    Buffer:" );
@@ -0,0 +1,161 @@
+/*
+    ------------------------------------------------------------------------------------
+    LICENSE:
+    ------------------------------------------------------------------------------------
+    This file is part of EVEmu: EVE Online Server Emulator
+    Copyright 2006 - 2011 The EVEmu Team
+    For the latest information visit http://evemu.org
+    ------------------------------------------------------------------------------------
+    This program is free software; you can redistribute it and/or modify it under
+    the terms of the GNU Lesser General Public License as published by the Free Software
+    Foundation; either version 2 of the License, or (at your option) any later
+    version.
+
+    This program is distributed in the hope that it will be useful, but WITHOUT
+    ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+    FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public License along with
+    this program; if not, write to the Free Software Foundation, Inc., 59 Temple
+    Place - Suite 330, Boston, MA 02111-1307, USA, or go to
+    http://www.gnu.org/copyleft/lesser.txt.
+    ------------------------------------------------------------------------------------
+    Author:     EVEmu Team
+*/
+
+#include "eve-server.h"
+
+#include "system/SystemDB.h"
+#include "system/SystemPreloader.h"
+
+/**
+ * @brief Loads the state of a system on a worker thread.
+ */
+class SystemPreloader::PreloadQuery
+: public DBAsyncQuery
+{
+public:
+    PreloadQuery(SystemPreloader &preloader, uint32 systemID)
+    : m_preloader(preloader),
+      m_state(new DBSystemState),
+      m_loadTime(0)
+    {
+        m_state->systemID = systemID;
+    }
+    ~PreloadQuery() { SafeDelete( m_state ); }
+
+    SystemPreloader &m_preloader;
+    DBSystemState *m_state;
+    uint32 m_loadTime;
+
+protected:
+    bool Run()
+    {
+        const uint64 start = GetTimeUSeconds();
+        const bool res = m_db.LoadSystemState(m_state->systemID, *m_state);
+        m_loadTime = static_cast<uint32>( ( GetTimeUSeconds() - start ) / 1000 );
+
+        return res;
+    }
+
+    void Complete(bool success, DBQueryResult &result)
+    {
+        m_preloader._Complete(*this, success);
+    }
+
+    SystemDB m_db;
+};
+
+SystemPreloader::SystemPreloader()
+: m_limit(0)
+{
+}
+
+SystemPreloader::~SystemPreloader()
+{
+    std::map<uint32, DBSystemState *>::iterator cur, end;
+    cur = m_ready.begin();
+    end = m_ready.end();
+    for(; cur != end; cur++)
+        SafeDelete( cur->second );
+}
+
+void SystemPreloader::SetLimit(uint32 limit)
+{
+    m_limit = limit;
+    _Trim();
+}
+
+void SystemPreloader::Preload(uint32 systemID)
+{
+    if(m_limit == 0)
+        return;
+    if(m_pending.find(systemID) != m_pending.end()
+       || m_ready.find(systemID) != m_ready.end())
+        return;
+
+    m_pending.insert(systemID);
+    ++m_stats.requested;
+
+    sDBAsync.Submit(new PreloadQuery(*this, systemID));
+}
+
+DBSystemState *SystemPreloader::Take(uint32 systemID)
+{
+    std::map<uint32, DBSystemState *>::iterator res = m_ready.find(systemID);
+    if(res == m_ready.end()) {
+        //the caller loads it right away, the preload would come too late
+        m_pending.erase(systemID);
+        ++m_stats.misses;
+        return NULL;
+    }
+
+    DBSystemState *state = res->second;
+    m_ready.erase(res);
+    m_readyOrder.erase(std::find(m_readyOrder.begin(), m_readyOrder.end(), systemID));
+
+    ++m_stats.hits;
+    return state;
+}
+
+void SystemPreloader::_Complete(PreloadQuery &query, bool success)
+{
+    const uint32 systemID = query.m_state->systemID;
+    m_stats.loadTime += query.m_loadTime;
+
+    if(!success) {
+        _log(SERVICE__ERROR, "Failed to preload state of system %u.", systemID);
+        ++m_stats.failed;
+        m_pending.erase(systemID);
+        return;
+    }
+
+    ++m_stats.loaded;
+
+    if(m_pending.erase(systemID) == 0) {
+        //booted in the meantime (or preloading was disabled)
+        ++m_stats.dropped;
+        return;
+    }
+
+    _log(SERVICE__MESSAGE, "Preloaded state of system %u in %u ms.", systemID, query.m_loadTime);
+
+    //take it over from the query
+    m_ready[systemID] = query.m_state;
+    m_readyOrder.push_back(systemID);
+    query.m_state = NULL;
+
+    _Trim();
+}
+
+void SystemPreloader::_Trim()
+{
+    while(m_readyOrder.size() > m_limit) {
+        std::map<uint32, DBSystemState *>::iterator res = m_ready.find(m_readyOrder.front());
+        m_readyOrder.pop_front();
+
+        SafeDelete( res->second );
+        m_ready.erase(res);
+        ++m_stats.dropped;
+    }
+}
@@ -0,0 +1,114 @@
+/*
+    ------------------------------------------------------------------------------------
+    LICENSE:
+    ------------------------------------------------------------------------------------
+    This file is part of EVEmu: EVE Online Server Emulator
+    Copyright 2006 - 2011 The EVEmu Team
+    For the latest information visit http://evemu.org
+    ------------------------------------------------------------------------------------
+    This program is free software; you can redistribute it and/or modify it under
+    the terms of the GNU Lesser General Public License as published by the Free Software
+    Foundation; either version 2 of the License, or (at your option) any later
+    version.
+
+    This program is distributed in the hope that it will be useful, but WITHOUT
+    ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+    FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public License along with
+    this program; if not, write to the Free Software Foundation, Inc., 59 Temple
+    Place - Suite 330, Boston, MA 02111-1307, USA, or go to
+    http://www.gnu.org/copyleft/lesser.txt.
+    ------------------------------------------------------------------------------------
+    Author:     EVEmu Team
+*/
+
+
+#include "eve-server.h"
+
+#include "system/WarmStart.h"
+
+/// "WARM"
+static const uint32 WARM_START_MAGIC = 0x4D524157;
+/// Bump whenever the layout changes.
+static const uint32 WARM_START_VERSION = 1;
+
+WarmStart::WarmStart()
+: mChecksum( 0 )
+{
+}
+
+bool WarmStart::Init()
+{
+    DBQueryResult res;
+    DBResultRow row;
+
+    // the tables the booted systems are built from
+    if( !sDatabase.RunQuery( res,
+        "CHECKSUM TABLE invTypes, dgmTypeAttributes, mapDenormalize, mapSolarSystems, staStations" ) )
+    {
+        codelog( SERVICE__ERROR, "Error in query: %s", res.error.c_str() );
+        return false;
+    }
+
+    mChecksum = WARM_START_VERSION;
+    while( res.GetRow( row ) )
+        mChecksum = mChecksum * 31 + ( row.IsNull( 1 ) ? 0 : row.GetUInt( 1 ) );
+
+    return true;
+}
+
+bool WarmStart::Load( const char* filename, std::vector<uint32>& systemIDs ) const
+{
+    FILE* f = fopen( filename, "rb" );
+    if( NULL == f )
+        return false;
+
+    uint32 header[ 4 ];
+    bool res = ( 1 == fread( header, sizeof( header ), 1, f ) )
+               && WARM_START_MAGIC == header[ 0 ]
+               && WARM_START_VERSION == header[ 1 ]
+               && mChecksum == header[ 2 ];
+    if( res && 0 < header[ 3 ] )
+    {
+        systemIDs.resize( header[ 3 ] );
+        res = ( systemIDs.size() == fread( &systemIDs[0], sizeof( uint32 ), systemIDs.size(), f ) );
+    }
+
+    fclose( f );
+
+    if( !res )
+        systemIDs.clear();
+    return res;
+}
+
+bool WarmStart::Save( const char* filename, const std::vector<uint32>& systemIDs ) const
+{
+    const std::string tempname = std::string( filename ) + ".tmp";
+
+    FILE* f = fopen( tempname.c_str(), "wb" );
+    if( NULL == f )
+        return false;
+
+    const uint32 header[] = { WARM_START_MAGIC, WARM_START_VERSION, mChecksum, (uint32)systemIDs.size() };
+
+    bool res = ( 1 == fwrite( header, sizeof( header ), 1, f ) );
+    if( res && !systemIDs.empty() )
+        res = ( systemIDs.size() == fwrite( &systemIDs[0], sizeof( uint32 ), systemIDs.size(), f ) );
+
+    res = ( 0 == fclose( f ) ) && res;
+
+#ifdef WIN32
+    // rename does not replace existing files here
+    if( res )
+        remove( filename );
+#endif /* WIN32 */
+
+    if( !res || 0 != rename( tempname.c_str(), filename ) )
+    {
+        remove( tempname.c_str() );
+        return false;
+    }
+
+    return true;
+}
@@ -0,0 +1,166 @@
+/*
+    ------------------------------------------------------------------------------------
+    LICENSE:
+    ------------------------------------------------------------------------------------
+    This file is part of EVEmu: EVE Online Server Emulator
+    Copyright 2006 - 2011 The EVEmu Team
+    For the latest information visit http://evemu.org
+    ------------------------------------------------------------------------------------
+    This program is free software; you can redistribute it and/or modify it under
+    the terms of the GNU Lesser General Public License as published by the Free Software
+    Foundation; either version 2 of the License, or (at your option) any later
+    version.
+
+    This program is distributed in the hope that it will be useful, but WITHOUT
+    ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+    FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public License along with
+    this program; if not, write to the Free Software Foundation, Inc., 59 Temple
+    Place - Suite 330, Boston, MA 02111-1307, USA, or go to
+    http://www.gnu.org/copyleft/lesser.txt.
+    ------------------------------------------------------------------------------------
+    Author:     EVEmu Team
+*/
+
+
+#include "eve-test.h"
+
+/*
+ * Builds a DBTable from a tupleset with mixed column types and NULLs,
+ * verifies the typed getters and that the encoded CRowset matches the
+ * source values.
+ */
+
+static const uint32 ROW_COUNT = 1000;
+
+static std::string ItemName( uint32 i )
+{
+    char buf[32];
+    snprintf( buf, sizeof( buf ), "item%u", i );
+
+    return buf;
+}
+
+/* Builds a tupleset of ROW_COUNT rows: itemID, typeID, volume, itemName, flag. */
+static PyTuple* BuildTupleset()
+{
+    PyList* header = new PyList;
+    header->AddItemString( "itemID" );
+    header->AddItemString( "typeID" );
+    header->AddItemString( "volume" );
+    header->AddItemString( "itemName" );
+    header->AddItemString( "flag" );
+
+    PyList* lines = new PyList;
+    for( uint32 i = 0; i < ROW_COUNT; ++i )
+    {
+        PyList* line = new PyList;
+        line->AddItem( new PyLong( 140000000000LL + i ) );
+        line->AddItemInt( i % 7 );
+        // the first volume is an integer, the column still widens to real
+        if( 0 == i )
+            line->AddItemInt( 0 );
+        else
+            line->AddItem( new PyFloat( i * 0.5 ) );
+        if( 0 == i % 3 )
+            line->AddItem( new PyNone );
+        else
+            line->AddItemString( ItemName( i ).c_str() );
+        line->AddItem( new PyBool( 0 == i % 2 ) );
+
+        lines->AddItem( line );
+    }
+
+    PyTuple* res = new PyTuple( 2 );
+    res->SetItem( 0, header );
+    res->SetItem( 1, lines );
+
+    return res;
+}
+
+static bool VerifyRow( const DBTableRow& row, uint32 i )
+{
+    if( row.GetInt64( 0 ) != 140000000000LL + i || row.GetInt( 1 ) != (int32)( i % 7 ) )
+        return false;
+    if( row.GetDouble( 2 ) != i * 0.5 || row.GetBool( 4 ) != ( 0 == i % 2 ) )
+        return false;
+
+    if( 0 == i % 3 )
+        return row.IsNull( 3 ) && 0 == row.ColumnLength( 3 );
+
+    const std::string name = ItemName( i );
+    return !row.IsNull( 3 ) && name == row.GetText( 3 ) && name.size() == row.ColumnLength( 3 );
+}
+
+int database_DBTableTest( int argc, char* argv[] )
+{
+    PyTuple* source = BuildTupleset();
+
+    util_Tupleset tupleset;
+    if( !tupleset.Decode( source ) )
+    {
+        sLog.Error( "DBTableTest", "Failed to decode the tupleset." );
+        return EXIT_FAILURE;
+    }
+
+    TuplesetReader reader( tupleset );
+    DBTable table;
+    if( !table.LoadReader( reader ) || ROW_COUNT != table.RowCount() || 5 != table.ColumnCount() )
+    {
+        sLog.Error( "DBTableTest", "Failed to load the table." );
+        return EXIT_FAILURE;
+    }
+
+    if( DBTYPE_I8 != table.ColumnType( 0 ) || DBTYPE_I4 != table.ColumnType( 1 )
+        || DBTYPE_R8 != table.ColumnType( 2 ) || DBTYPE_STR != table.ColumnType( 3 )
+        || DBTYPE_BOOL != table.ColumnType( 4 ) || 3 != table.FindColumn( "itemName" ) )
+    {
+        sLog.Error( "DBTableTest", "Unexpected schema." );
+        return EXIT_FAILURE;
+    }
+
+    DBTableRow row;
+    for( uint32 i = 0; i < ROW_COUNT; ++i )
+    {
+        if( !table.GetRow( i, row ) || !VerifyRow( row, i ) )
+        {
+            sLog.Error( "DBTableTest", "Row %u mismatch.", i );
+            return EXIT_FAILURE;
+        }
+    }
+    if( table.GetRow( ROW_COUNT, row ) )
+    {
+        sLog.Error( "DBTableTest", "Row past the end returned." );
+        return EXIT_FAILURE;
+    }
+
+    PyObjectEx* rowset = table.EncodeCRowset();
+    const PyList& list = rowset->list();
+    bool ok = ( ROW_COUNT == list.size() );
+    for( uint32 i = 0; ok && i < ROW_COUNT; ++i )
+    {
+        const PyPackedRow* packed = list.GetItem( i )->AsPackedRow();
+        ok = ( 140000000000LL + i == packed->GetField( 0 )->AsLong()->value()
+               && (int32)( i % 7 ) == packed->GetField( 1 )->AsInt()->value()
+               && i * 0.5 == packed->GetField( 2 )->AsFloat()->value()
+               && ( 0 == i % 3 ? packed->GetField( 3 )->IsNone()
+                               : packed->GetField( 3 )->AsString()->content() == ItemName( i ) ) );
+    }
+    PyDecRef( rowset );
+
+    PyDict* dict = table.EncodePackedRowDict( 0 );
+    ok = ok && ( ROW_COUNT == dict->size() );
+    PyDecRef( dict );
+
+    PyDecRef( source );
+
+    if( !ok )
+    {
+        sLog.Error( "DBTableTest", "Encoded rows mismatch." );
+        return EXIT_FAILURE;
+    }
+
+    sLog.Success( "DBTableTest", "%u rows of %u columns verified.", table.RowCount(), table.ColumnCount() );
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,148 @@
+/*
+    ------------------------------------------------------------------------------------
+    LICENSE:
+    ------------------------------------------------------------------------------------
+    This file is part of EVEmu: EVE Online Server Emulator
+    Copyright 2006 - 2011 The EVEmu Team
+    For the latest information visit http://evemu.org
+    ------------------------------------------------------------------------------------
+    This program is free software; you can redistribute it and/or modify it under
+    the terms of the GNU Lesser General Public License as published by the Free Software
+    Foundation; either version 2 of the License, or (at your option) any later
+    version.
+
+    This program is distributed in the hope that it will be useful, but WITHOUT
+    ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+    FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public License along with
+    this program; if not, write to the Free Software Foundation, Inc., 59 Temple
+    Place - Suite 330, Boston, MA 02111-1307, USA, or go to
+    http://www.gnu.org/copyleft/lesser.txt.
+    ------------------------------------------------------------------------------------
+    Author:     EVEmu Team
+*/
+
+
+#include "eve-test.h"
+
+/* Marshals the call arguments the way the client sends them. */
+static bool MarshalArgs( PyTuple* args, Buffer& into )
+{
+    bool res = Marshal( args, into );
+    PyDecRef( args );
+
+    return res;
+}
+
+/* Decodes the unmarshaled arguments like a service does, returns the average time of a call in ns. */
+template<typename T>
+static double TimeDecode( const char* name, const Buffer& data, uint32 iterations )
+{
+    PyRep* tuple = Unmarshal( data );
+    if( NULL == tuple )
+        return -1.0;
+
+    uint32 failed = 0;
+
+    const uint64 start = GetTimeUSeconds();
+    for( uint32 i = 0; i < iterations; ++i )
+    {
+        T args;
+        if( !args.Decode( tuple ) )
+            ++failed;
+    }
+    const double ns = ( GetTimeUSeconds() - start ) * 1000.0 / iterations;
+
+    PyDecRef( tuple );
+
+    ::printf( "%-26s %8.1f ns/call%s\n", name, ns, 0 < failed ? " (decode failed)" : "" );
+    return 0 < failed ? -1.0 : ns;
+}
+
+int marshal_BorrowedDecodeBenchmark( int argc, char* argv[] )
+{
+    const uint32 iterations = 1000000;
+    // longer than any short string optimization
+    const std::string text( "Some mailing list with a name long enough to need the heap" );
+
+    Buffer singleInt, twoInts, string, intList, multiAdd2, multiAdd3;
+
+    PyTuple* args = new PyTuple( 1 );
+    args->SetItem( 0, new PyInt( 140000001 ) );
+    MarshalArgs( args, singleInt );
+
+    args = new PyTuple( 2 );
+    args->SetItem( 0, new PyInt( 140000001 ) );
+    args->SetItem( 1, new PyInt( 4 ) );
+    MarshalArgs( args, twoInts );
+
+    args = new PyTuple( 1 );
+    args->SetItem( 0, new PyString( text ) );
+    MarshalArgs( args, string );
+
+    PyList* items = new PyList;
+    for( int32 i = 0; i < 50; ++i )
+        items->AddItemInt( 140000000 + i );
+
+    args = new PyTuple( 1 );
+    args->SetItem( 0, items->Clone() );
+    MarshalArgs( args, intList );
+
+    args = new PyTuple( 2 );
+    args->SetItem( 0, items->Clone() );
+    args->SetItem( 1, new PyInt( 60000004 ) );
+    MarshalArgs( args, multiAdd2 );
+
+    args = new PyTuple( 3 );
+    args->SetItem( 0, items );
+    args->SetItem( 1, new PyNone );
+    args->SetItem( 2, new PyInt( 5 ) );
+    MarshalArgs( args, multiAdd3 );
+
+    // the views must outlive the stolen tuple
+    PyTuple* tuple = Unmarshal( multiAdd3 )->AsTuple();
+    Call_MultiAdd_3 multiAdd;
+    if( !multiAdd.Decode( &tuple ) || NULL != tuple )
+    {
+        ::printf( "Call_MultiAdd_3 failed to decode.\n" );
+        return EXIT_FAILURE;
+    }
+    Call_MultiAdd_3 copy( multiAdd );
+    multiAdd = Call_MultiAdd_3();
+
+    int32 sum = 0;
+    PyIntListView::const_iterator cur, end;
+    cur = copy.itemIDs.begin();
+    end = copy.itemIDs.end();
+    for(; cur != end; cur++ )
+        sum += *cur - 140000000;
+
+    if( 50 != copy.itemIDs.size() || 49 * 50 / 2 != sum
+        || 1 != copy.quantity || 5 != copy.flag )
+    {
+        ::printf( "Call_MultiAdd_3 decoded wrong values.\n" );
+        return EXIT_FAILURE;
+    }
+
+    tuple = Unmarshal( string )->AsTuple();
+    Call_SingleStringArg stringArg;
+    if( !stringArg.Decode( &tuple ) || text != stringArg.arg
+        || text.size() != ::strlen( stringArg.arg.c_str() ) )
+    {
+        ::printf( "Call_SingleStringArg decoded a wrong value.\n" );
+        return EXIT_FAILURE;
+    }
+
+    // the owning twins of the borrowed shapes come first
+    if( 0 > TimeDecode<Call_SingleIntegerArg>( "Call_SingleIntegerArg", singleInt, iterations )
+        || 0 > TimeDecode<Call_TwoIntegerArgs>( "Call_TwoIntegerArgs", twoInts, iterations )
+        || 0 > TimeDecode<Call_SingleWStringSoftArg>( "Call_SingleWStringSoftArg", string, iterations )
+        || 0 > TimeDecode<Call_SingleStringArg>( "Call_SingleStringArg", string, iterations )
+        || 0 > TimeDecode<Call_SingleIntList>( "Call_SingleIntList", intList, iterations )
+        || 0 > TimeDecode<Call_MultiAdd_2>( "Call_MultiAdd_2", multiAdd2, iterations )
+        || 0 > TimeDecode<Call_MultiAdd_3>( "Call_MultiAdd_3", multiAdd3, iterations ) )
+        return EXIT_FAILURE;
+
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,455 @@
+/*
+    ------------------------------------------------------------------------------------
+    LICENSE:
+    ------------------------------------------------------------------------------------
+    This file is part of EVEmu: EVE Online Server Emulator
+    Copyright 2006 - 2011 The EVEmu Team
+    For the latest information visit http://evemu.org
+    ------------------------------------------------------------------------------------
+    This program is free software; you can redistribute it and/or modify it under
+    the terms of the GNU Lesser General Public License as published by the Free Software
+    Foundation; either version 2 of the License, or (at your option) any later
+    version.
+
+    This program is distributed in the hope that it will be useful, but WITHOUT
+    ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+    FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public License along with
+    this program; if not, write to the Free Software Foundation, Inc., 59 Temple
+    Place - Suite 330, Boston, MA 02111-1307, USA, or go to
+    http://www.gnu.org/copyleft/lesser.txt.
+    ------------------------------------------------------------------------------------
+    Author:     EVEmu Team
+*/
+
+#include "eve-test.h"
+
+/* Throughput and allocation benchmarks of the marshal layer.
+ *
+ * Every corpus is a synthetic copy of a packet shape which dominates the
+ * traffic. Each of them is marshaled, deflated, unmarshaled and inflated
+ * over and over again; the results are reported in MB/s of the plain
+ * marshal stream and in PyRep allocations per operation. Marshaling is
+ * also measured with the PyVisitor dispatch, for comparison.
+ *
+ * The optional first argument is time (in milliseconds) spent on each
+ * measurement; the default is MARSHAL_BENCHMARK_TIME.
+ */
+
+/** Default time (in milliseconds) spent on a single measurement. */
+static const uint32 MARSHAL_BENCHMARK_TIME = 200;
+/** Least number of operations per measurement. */
+static const uint32 MARSHAL_BENCHMARK_MIN_OPS = 10;
+/** Timestamp used by the corpora, so that they're the same on every run. */
+static const uint64 MARSHAL_BENCHMARK_TIMESTAMP = 129000000000000000LL;
+
+/* Simple LCG, also to keep the corpora the same. */
+class BenchmarkRandom
+{
+public:
+    BenchmarkRandom() : mState( 0x2F6B3A1D ) {}
+
+    uint32 Next() { return ( mState = mState * 1664525 + 1013904223 ) >> 8; }
+    uint32 Next( uint32 max ) { return Next() % max; }
+    double NextReal( double max ) { return max * Next() / (double)0x00FFFFFF; }
+
+protected:
+    uint32 mState;
+};
+
+/* Market orders, the same shape as DBResultToCRowset() builds. */
+static PyRep* BuildCRowSet( BenchmarkRandom& rnd, uint32 rowCount )
+{
+    DBRowDescriptor* header = new DBRowDescriptor;
+    header->AddColumn( "price", DBTYPE_CY );
+    header->AddColumn( "volRemaining", DBTYPE_R8 );
+    header->AddColumn( "typeID", DBTYPE_I4 );
+    header->AddColumn( "range", DBTYPE_I2 );
+    header->AddColumn( "orderID", DBTYPE_I4 );
+    header->AddColumn( "volEntered", DBTYPE_I4 );
+    header->AddColumn( "minVolume", DBTYPE_I4 );
+    header->AddColumn( "bid", DBTYPE_BOOL );
+    header->AddColumn( "issued", DBTYPE_FILETIME );
+    header->AddColumn( "duration", DBTYPE_I2 );
+    header->AddColumn( "stationID", DBTYPE_I4 );
+    header->AddColumn( "regionID", DBTYPE_I4 );
+    header->AddColumn( "solarSystemID", DBTYPE_I4 );
+    header->AddColumn( "jumps", DBTYPE_I4 );
+
+    CRowSet* rowset = new CRowSet( &header );
+
+    for( uint32 i = 0; i < rowCount; ++i )
+    {
+        PyPackedRow* row = rowset->NewRow();
+
+        row->SetField( (uint32)0, new PyLong( 10000 + rnd.Next( 100000000 ) ) );
+        row->SetField( 1, new PyFloat( rnd.NextReal( 100000.0 ) ) );
+        row->SetField( 2, new PyInt( 34 + rnd.Next( 20 ) ) );
+        row->SetField( 3, new PyInt( -1 ) );
+        row->SetField( 4, new PyInt( 1000000 + i ) );
+        row->SetField( 5, new PyInt( 1 + rnd.Next( 1000000 ) ) );
+        row->SetField( 6, new PyInt( 1 ) );
+        row->SetField( 7, new PyBool( 0 == rnd.Next( 2 ) ) );
+        row->SetField( 8, new PyLong( MARSHAL_BENCHMARK_TIMESTAMP - rnd.Next( 1000000 ) ) );
+        row->SetField( 9, new PyInt( 90 ) );
+        row->SetField( 10, new PyInt( 60000000 + rnd.Next( 10000 ) ) );
+        row->SetField( 11, new PyInt( 10000002 ) );
+        row->SetField( 12, new PyInt( 30000000 + rnd.Next( 10000 ) ) );
+        row->SetField( 13, new PyInt( rnd.Next( 10 ) ) );
+    }
+
+    return rowset;
+}
+
+/* Inventory rows, a list of packed rows sharing a single DBRowDescriptor. */
+static PyRep* BuildPackedRows( BenchmarkRandom& rnd, uint32 rowCount )
+{
+    DBRowDescriptor* header = new DBRowDescriptor;
+    header->AddColumn( "itemID", DBTYPE_I4 );
+    header->AddColumn( "typeID", DBTYPE_I4 );
+    header->AddColumn( "ownerID", DBTYPE_I4 );
+    header->AddColumn( "locationID", DBTYPE_I4 );
+    header->AddColumn( "flag", DBTYPE_UI1 );
+    header->AddColumn( "contraband", DBTYPE_BOOL );
+    header->AddColumn( "singleton", DBTYPE_BOOL );
+    header->AddColumn( "quantity", DBTYPE_I4 );
+    header->AddColumn( "groupID", DBTYPE_I2 );
+    header->AddColumn( "categoryID", DBTYPE_UI1 );
+    header->AddColumn( "customInfo", DBTYPE_STR );
+
+    PyList* rows = new PyList( rowCount );
+    for( uint32 i = 0; i < rowCount; ++i )
+    {
+        PyIncRef( header );
+        PyPackedRow* row = new PyPackedRow( header );
+
+        row->SetField( (uint32)0, new PyInt( 140000000 + i ) );
+        row->SetField( 1, new PyInt( 34 + rnd.Next( 3000 ) ) );
+        row->SetField( 2, new PyInt( 140000000 ) );
+        row->SetField( 3, new PyInt( 60000004 ) );
+        row->SetField( 4, new PyInt( 4 ) );
+        row->SetField( 5, new PyBool( false ) );
+        row->SetField( 6, new PyBool( 0 == rnd.Next( 4 ) ) );
+        row->SetField( 7, new PyInt( 1 + rnd.Next( 10000 ) ) );
+        row->SetField( 8, new PyInt( rnd.Next( 1000 ) ) );
+        row->SetField( 9, new PyInt( rnd.Next( 30 ) ) );
+        row->SetField( 10, new PyString( 0 == rnd.Next( 8 ) ? "Shipment from the market" : "" ) );
+
+        rows->SetItem( i, row );
+    }
+
+    PyDecRef( header );
+    return rows;
+}
+
+/* Destiny state of a busy bubble, as sent on entering space. */
+static PyRep* BuildSetState( BenchmarkRandom& rnd, uint32 ballCount )
+{
+    Buffer* state = new Buffer;
+
+    Destiny::AddBall_header head;
+    head.packet_type = 0;
+    head.sequence = 123456;
+    state->Append( head );
+
+    DoDestiny_SetState ss;
+    ss.stamp = head.sequence;
+    ss.ego = 140000000;
+    ss.slims = new PyList;
+
+    for( uint32 i = 0; i < ballCount; ++i )
+    {
+        const uint32 itemID = 140000000 + i;
+
+        Destiny::BallHeader ball;
+        ball.entityID = itemID;
+        ball.mode = Destiny::DSTBALL_GOTO;
+        ball.radius = (float)rnd.NextReal( 5000.0 );
+        ball.x = rnd.NextReal( 1.0e12 );
+        ball.y = rnd.NextReal( 1.0e11 );
+        ball.z = rnd.NextReal( 1.0e12 );
+        ball.sub_type = Destiny::IsFree | Destiny::IsMassive | Destiny::IsInteractive;
+        state->Append( ball );
+
+        Destiny::MassSector mass;
+        mass.mass = rnd.NextReal( 1.0e8 );
+        mass.cloak = 0;
+        mass.allianceID = 0;
+        mass.corpID = 1000044;
+        mass.Harmonic = -1.0f;
+        state->Append( mass );
+
+        Destiny::ShipSector ship;
+        ship.max_speed = (float)rnd.NextReal( 500.0 );
+        ship.velocity_x = rnd.NextReal( 100.0 );
+        ship.velocity_y = rnd.NextReal( 100.0 );
+        ship.velocity_z = rnd.NextReal( 100.0 );
+        ship.agility = (float)rnd.NextReal( 1.0 );
+        ship.speed_fraction = 1.0f;
+        state->Append( ship );
+
+        Destiny::DSTBALL_GOTO_Struct go;
+        go.formationID = 0xFF;
+        go.x = rnd.NextReal( 1.0e12 );
+        go.y = rnd.NextReal( 1.0e11 );
+        go.z = rnd.NextReal( 1.0e12 );
+        state->Append( go );
+
+        DoDestinyDamageState dmg;
+        dmg.shield = 1.0;
+        dmg.tau = 100000.0;
+        dmg.timestamp = MARSHAL_BENCHMARK_TIMESTAMP;
+        dmg.armor = 1.0;
+        dmg.structure = 1.0;
+        ss.damageState[ itemID ] = dmg.Encode();
+
+        PyDict* slim = new PyDict;
+        slim->SetItemString( "itemID", new PyInt( itemID ) );
+        slim->SetItemString( "typeID", new PyInt( 587 + rnd.Next( 100 ) ) );
+        slim->SetItemString( "ownerID", new PyInt( 140000000 + rnd.Next( 1000 ) ) );
+        slim->SetItemString( "corpID", new PyInt( 1000044 ) );
+        slim->SetItemString( "allianceID", new PyNone );
+        slim->SetItemString( "name", new PyString( "Benchmark Ship" ) );
+        ss.slims->AddItem( new PyObject( "foo.SlimItem", slim ) );
+    }
+
+    ss.destiny_state = new PyBuffer( &state );
+    ss.droneState = new PyNone;
+    ss.solItem = new PyNone;
+    ss.effectStates = new PyList;
+    ss.allianceBridges = new PyList;
+
+    return ss.Encode();
+}
+
+/* Cached object holding a substream with an indexed rowset, as the
+   bulk data and cached method calls are sent. */
+static PyRep* BuildCachedObject( BenchmarkRandom& rnd, uint32 rowCount )
+{
+    DBRowDescriptor* header = new DBRowDescriptor;
+    header->AddColumn( "typeID", DBTYPE_I4 );
+    header->AddColumn( "groupID", DBTYPE_I2 );
+    header->AddColumn( "typeName", DBTYPE_WSTR );
+    header->AddColumn( "volume", DBTYPE_R8 );
+    header->AddColumn( "capacity", DBTYPE_R8 );
+    header->AddColumn( "basePrice", DBTYPE_CY );
+    header->AddColumn( "published", DBTYPE_BOOL );
+
+    CIndexedRowSet* rowset = new CIndexedRowSet( &header );
+    for( uint32 i = 0; i < rowCount; ++i )
+    {
+        PyPackedRow* row = rowset->NewRow( new PyInt( i ) );
+
+        row->SetField( (uint32)0, new PyInt( i ) );
+        row->SetField( 1, new PyInt( rnd.Next( 1000 ) ) );
+        row->SetField( 2, new PyWString( std::string( "Benchmark Type" ) ) );
+        row->SetField( 3, new PyFloat( rnd.NextReal( 1000.0 ) ) );
+        row->SetField( 4, new PyFloat( rnd.NextReal( 1000.0 ) ) );
+        row->SetField( 5, new PyLong( rnd.Next( 100000000 ) ) );
+        row->SetField( 6, new PyBool( true ) );
+    }
+
+    PyCachedObject co;
+    co.timestamp = MARSHAL_BENCHMARK_TIMESTAMP;
+    co.version = 1;
+    co.nodeID = 0xFFAA;
+    co.shared = true;
+    co.cache = new PySubStream( rowset );
+    co.compressed = false;
+    co.objectID = new PyString( "config.BulkData.types" );
+
+    return co.Encode();
+}
+
+/* A corpus: the object itself and its marshaled forms. */
+struct BenchmarkCorpus
+{
+    const char* name;
+    PyRep* rep;
+    Buffer marshaled;
+    Buffer deflated;
+};
+
+/* The measured operations. */
+enum BenchmarkOp
+{
+    BENCHMARK_MARSHAL,
+    BENCHMARK_MARSHAL_VISITOR,
+    BENCHMARK_MARSHAL_DEFLATE,
+    BENCHMARK_UNMARSHAL,
+    BENCHMARK_INFLATE_UNMARSHAL,
+    BENCHMARK_OP_COUNT
+};
+
+static const char* const BENCHMARK_OP_NAMES[ BENCHMARK_OP_COUNT ] =
+{
+    "Marshal",
+    "Marshal (visitor)",
+    "MarshalDeflate",
+    "Unmarshal",
+    "InflateUnmarshal"
+};
+
+static bool RunBenchmarkOp( BenchmarkOp op, const BenchmarkCorpus& corpus )
+{
+    switch( op )
+    {
+        case BENCHMARK_MARSHAL:
+        {
+            Buffer into;
+            return Marshal( corpus.rep, into );
+        }
+        case BENCHMARK_MARSHAL_VISITOR:
+        {
+            // the same encoder, dispatching through PyRep::visit()
+            Buffer into;
+            MarshalStream stream( false );
+            return stream.Save( corpus.rep, into );
+        }
+        case BENCHMARK_MARSHAL_DEFLATE:
+        {
+            Buffer into;
+            return MarshalDeflate( corpus.rep, into );
+        }
+        case BENCHMARK_UNMARSHAL:
+        case BENCHMARK_INFLATE_UNMARSHAL:
+        {
+            PyRep* rep = ( BENCHMARK_UNMARSHAL == op
+                           ? Unmarshal( corpus.marshaled )
+                           : InflateUnmarshal( corpus.deflated ) );
+            if( NULL == rep )
+                return false;
+
+            PyDecRef( rep );
+            return true;
+        }
+        default:
+            return false;
+    }
+}
+
+static bool MeasureBenchmarkOp( BenchmarkOp op, const BenchmarkCorpus& corpus, uint32 timeMs )
+{
+    const uint64 limit = 1000 * (uint64)timeMs;
+
+    uint32 ops = 0;
+    uint64 time = 0;
+
+    SizeClassPool::ResetStats();
+    const uint64 start = GetTimeUSeconds();
+
+    do
+    {
+        if( !RunBenchmarkOp( op, corpus ) )
+        {
+            ::printf( "%s of %s failed.\n", BENCHMARK_OP_NAMES[ op ], corpus.name );
+            return false;
+        }
+
+        ++ops;
+        time = GetTimeUSeconds() - start;
+    } while( MARSHAL_BENCHMARK_MIN_OPS > ops || limit > time );
+
+    const SizeClassPool::Stats stats = SizeClassPool::GetStats();
+    const double seconds = time / 1000000.0;
+
+    ::printf( "  %-18s %-17s %7u ops %10.1f us/op %9.1f MB/s %9.1f allocs/op\n",
+              corpus.name, BENCHMARK_OP_NAMES[ op ], ops,
+              (double)time / ops,
+              corpus.marshaled.size() * (double)ops / ( 1024.0 * 1024.0 ) / seconds,
+              (double)stats.allocations / ops );
+
+    return true;
+}
+
+/* Makes sure the corpus survives the round trip. */
+static bool VerifyBenchmarkCorpus( const BenchmarkCorpus& corpus )
+{
+    // both dispatch methods must produce the same stream
+    Buffer visited;
+    MarshalStream stream( false );
+    if( !stream.Save( corpus.rep, visited )
+        || visited.size() != corpus.marshaled.size()
+        || 0 != ::memcmp( &visited[0], &corpus.marshaled[0], visited.size() ) )
+    {
+        ::printf( "%s differs when marshaled through the visitor.\n", corpus.name );
+        return false;
+    }
+
+    PyRep* rep = InflateUnmarshal( corpus.deflated );
+    if( NULL == rep )
+    {
+        ::printf( "Failed to unmarshal %s.\n", corpus.name );
+        return false;
+    }
+
+    Buffer remarshaled;
+    const bool res = Marshal( rep, remarshaled );
+    PyDecRef( rep );
+
+    if( !res )
+    {
+        ::printf( "Failed to marshal unmarshaled %s.\n", corpus.name );
+        return false;
+    }
+
+    // compare sizes only; dictionaries don't keep the order of their items
+    if( remarshaled.size() != corpus.marshaled.size() )
+    {
+        ::printf( "%s differs after the round trip (%lu vs %lu bytes).\n",
+                  corpus.name, remarshaled.size(), corpus.marshaled.size() );
+        return false;
+    }
+
+    return true;
+}
+
+int marshal_EVEMarshalBenchmark( int argc, char* argv[] )
+{
+    uint32 timeMs = MARSHAL_BENCHMARK_TIME;
+    if( 1 < argc )
+        timeMs = ::strtoul( argv[1], NULL, 10 );
+
+    BenchmarkRandom rnd;
+    BenchmarkCorpus corpora[] =
+    {
+        { "CRowset",      BuildCRowSet( rnd, 1000 ) },
+        { "PackedRows",   BuildPackedRows( rnd, 1000 ) },
+        { "SetState",     BuildSetState( rnd, 200 ) },
+        { "CachedObject", BuildCachedObject( rnd, 1000 ) }
+    };
+    const size_t corpusCount = sizeof( corpora ) / sizeof( BenchmarkCorpus );
+
+    int result = EXIT_SUCCESS;
+    for( size_t i = 0; i < corpusCount; ++i )
+    {
+        BenchmarkCorpus& corpus = corpora[ i ];
+
+        if( !Marshal( corpus.rep, corpus.marshaled )
+            || !MarshalDeflate( corpus.rep, corpus.deflated ) )
+        {
+            ::printf( "Failed to marshal %s.\n", corpus.name );
+            result = EXIT_FAILURE;
+            continue;
+        }
+
+        ::printf( "%s: %lu bytes marshaled, %lu bytes deflated.\n",
+                  corpus.name, corpus.marshaled.size(), corpus.deflated.size() );
+
+        if( !VerifyBenchmarkCorpus( corpus ) )
+        {
+            result = EXIT_FAILURE;
+            continue;
+        }
+
+        for( int op = 0; op < BENCHMARK_OP_COUNT; ++op )
+            if( !MeasureBenchmarkOp( (BenchmarkOp)op, corpus, timeMs ) )
+                result = EXIT_FAILURE;
+    }
+
+    for( size_t i = 0; i < corpusCount; ++i )
+        PyDecRef( corpora[ i ].rep );
+
+    return result;
+}
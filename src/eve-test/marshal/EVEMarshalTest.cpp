@@ -25,6 +25,132 @@
 
 #include "eve-test.h"
 
+/* Unmarshals something alike to a service call many times, counting the allocations. */
+static int UnmarshalBenchmark()
+{
+    const uint32 iterations = 20000;
+
+    PyList* list = new PyList;
+    for( int32 i = 0; i < 16; ++i )
+        list->AddItemInt( 1000 + i );
+
+    PyDict* kwargs = new PyDict;
+    kwargs->SetItemString( "machoVersion", new PyInt( 1 ) );
+    kwargs->SetItemString( "flag", new PyInt( 4 ) );
+
+    PyTuple* args = new PyTuple( 3 );
+    args->SetItem( 0, new PyInt( 60000004 ) );
+    args->SetItem( 1, new PyString( "GetInventoryFromId" ) );
+    args->SetItem( 2, list );
+
+    PyTuple* call = new PyTuple( 4 );
+    call->SetItem( 0, new PyInt( 1 ) );
+    call->SetItem( 1, new PyString( "invbroker" ) );
+    call->SetItem( 2, args );
+    call->SetItem( 3, kwargs );
+
+    Buffer marshaled;
+    bool res = Marshal( call, marshaled );
+    PyDecRef( call );
+
+    if( !res )
+    {
+        ::puts( "Failed to marshal benchmark call." );
+        return EXIT_FAILURE;
+    }
+
+    SizeClassPool::ResetStats();
+    const uint64 start = GetTimeUSeconds();
+
+    for( uint32 i = 0; i < iterations; ++i )
+    {
+        PyRep* rep = Unmarshal( marshaled );
+        if( NULL == rep )
+        {
+            ::puts( "Failed to unmarshal benchmark call." );
+            return EXIT_FAILURE;
+        }
+        PyDecRef( rep );
+    }
+
+    const uint64 time = GetTimeUSeconds() - start;
+    const SizeClassPool::Stats stats = SizeClassPool::GetStats();
+
+    ::printf( "Unmarshaled %u calls in %" PRIu64 " us (%.3f us each).\n",
+              iterations, time, (double)time / iterations );
+    ::printf( "Pooled allocations: %" PRIu64 " (%.1f per call), %" PRIu64 " served by the pool (%.1f%%), %" PRIu64 " freed.\n",
+              stats.allocations, (double)stats.allocations / iterations,
+              stats.poolHits, 0 < stats.allocations ? 100.0 * stats.poolHits / stats.allocations : 0.0,
+              stats.frees );
+
+#ifdef PYREP_POOL
+    // everything freed by a call should be reused by the next one
+    const uint64 perCall = stats.allocations / iterations;
+    if( 0 == perCall || stats.poolReturns != stats.frees || stats.poolHits + perCall < stats.frees )
+    {
+        ::puts( "Pool did not work as expected." );
+        return EXIT_FAILURE;
+    }
+#endif /* PYREP_POOL */
+
+    return EXIT_SUCCESS;
+}
+
+/* Checks that received sub-streams are decoded on demand and re-sent as they came. */
+static int SubStreamTest()
+{
+    PyTuple* inner = new PyTuple( 2 );
+    inner->SetItem( 0, new PyInt( 42 ) );
+    inner->SetItem( 1, new PyString( "payload" ) );
+
+    PyTuple* outer = new PyTuple( 1 );
+    outer->SetItem( 0, new PySubStream( inner ) );
+
+    Buffer marshaled;
+    bool res = Marshal( outer, marshaled );
+    PyDecRef( outer );
+
+    if( !res )
+    {
+        ::puts( "Failed to marshal sub-stream." );
+        return EXIT_FAILURE;
+    }
+
+    PyRep* rep = Unmarshal( marshaled );
+    if( NULL == rep || !rep->IsTuple() || !rep->AsTuple()->GetItem( 0 )->IsSubStream() )
+    {
+        ::puts( "Failed to unmarshal sub-stream." );
+        PySafeDecRef( rep );
+        return EXIT_FAILURE;
+    }
+
+    const PySubStream* ss = rep->AsTuple()->GetItem( 0 )->AsSubStream();
+    if( ss->isDecoded() )
+    {
+        ::puts( "Sub-stream decoded eagerly." );
+        PyDecRef( rep );
+        return EXIT_FAILURE;
+    }
+
+    // the untouched stream must come out byte for byte
+    Buffer again;
+    res = Marshal( rep, again ) && again.size() == marshaled.size()
+          && 0 == ::memcmp( &again[0], &marshaled[0], marshaled.size() );
+
+    // accessing the contents decodes it
+    res = res && !ss->isDecoded() && NULL != ss->decoded() && ss->isDecoded()
+          && ss->decoded()->IsTuple() && 2 == ss->decoded()->AsTuple()->size();
+    PyDecRef( rep );
+
+    if( !res )
+    {
+        ::puts( "Sub-stream did not survive the round trip." );
+        return EXIT_FAILURE;
+    }
+
+    return EXIT_SUCCESS;
+}
+
 int marshal_EVEMarshalTest( int argc, char* argv[] )
 {
     DBRowDescriptor *header = new DBRowDescriptor;
@@ -71,5 +197,8 @@ int marshal_EVEMarshalTest( int argc, char* argv[] )
     rep->Dump( stdout, "    " );
     PyDecRef( rep );
 
-    return EXIT_SUCCESS;
+    if( EXIT_SUCCESS != SubStreamTest() )
+        return EXIT_FAILURE;
+
+    return UnmarshalBenchmark();
 }
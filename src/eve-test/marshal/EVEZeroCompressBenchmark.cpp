@@ -0,0 +1,284 @@
+/*
+    ------------------------------------------------------------------------------------
+    LICENSE:
+    ------------------------------------------------------------------------------------
+    This file is part of EVEmu: EVE Online Server Emulator
+    Copyright 2006 - 2011 The EVEmu Team
+    For the latest information visit http://evemu.org
+    ------------------------------------------------------------------------------------
+    This program is free software; you can redistribute it and/or modify it under
+    the terms of the GNU Lesser General Public License as published by the Free Software
+    Foundation; either version 2 of the License, or (at your option) any later
+    version.
+
+    This program is distributed in the hope that it will be useful, but WITHOUT
+    ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+    FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public License along with
+    this program; if not, write to the Free Software Foundation, Inc., 59 Temple
+    Place - Suite 330, Boston, MA 02111-1307, USA, or go to
+    http://www.gnu.org/copyleft/lesser.txt.
+    ------------------------------------------------------------------------------------
+    Author:     EVEmu Team
+*/
+
+#include "eve-test.h"
+
+/* Checks zero-compression of packed rows against the plain byte by byte
+ * implementation and measures both of them.
+ *
+ * The optional first argument is time (in milliseconds) spent on each
+ * measurement; the default is ZERO_COMPRESS_BENCHMARK_TIME.
+ */
+
+/** Default time (in milliseconds) spent on a single measurement. */
+static const uint32 ZERO_COMPRESS_BENCHMARK_TIME = 200;
+/** Length of each corpus. */
+static const size_t ZERO_COMPRESS_BENCHMARK_LEN = 256 * 1024;
+
+/* Reference encoder, scans a byte at a time. */
+static void ReferenceCompress( const uint8* cur, const uint8* end, Buffer& out )
+{
+    while( cur < end )
+    {
+        const size_t opcodePos = out.size();
+        out.Append<uint8>( 0 );
+        ZeroCompressOpcode opcode;
+
+        for( int part = 0; part < 2; ++part )
+        {
+            bool isZero = true;
+            uint8 opLen = 0;
+
+            if( cur < end )
+            {
+                isZero = ( 0 == *cur );
+                uint8 run = 0;
+                do
+                {
+                    if( !isZero )
+                        out.Append<uint8>( *cur );
+                    ++cur;
+                    ++run;
+                } while( 8 > run && cur < end && isZero == ( 0 == *cur ) );
+
+                opLen = isZero ? run - 1 : ( 8 - run ) & 7;
+            }
+
+            if( 0 == part )
+            {
+                opcode.firstIsZero = isZero;
+                opcode.firstLen    = opLen;
+            }
+            else
+            {
+                opcode.secondIsZero = isZero;
+                opcode.secondLen    = opLen;
+            }
+        }
+
+        out[ opcodePos ] = *(const uint8*)&opcode;
+    }
+}
+
+/* Reference decoder, appends a byte at a time. */
+static void ReferenceUncompress( const uint8* cur, const uint8* end, Buffer& into )
+{
+    while( cur < end )
+    {
+        const ZeroCompressOpcode opcode = *(const ZeroCompressOpcode*)cur++;
+
+        for( int part = 0; part < 2; ++part )
+        {
+            const bool isZero = ( 0 == part ? opcode.firstIsZero : opcode.secondIsZero );
+            const uint8 opLen = ( 0 == part ? opcode.firstLen : opcode.secondLen );
+
+            if( isZero )
+            {
+                for( uint8 i = 0; i <= opLen; ++i )
+                    into.Append<uint8>( 0 );
+            }
+            else
+            {
+                for( uint8 i = opLen; i < 8 && cur < end; ++i )
+                    into.Append<uint8>( *cur++ );
+            }
+        }
+    }
+}
+
+/* Simple LCG, so that the corpora are the same on every run. */
+static uint32 NextRandom( uint32& state )
+{
+    return ( state = state * 1664525 + 1013904223 ) >> 8;
+}
+
+/* Fills the corpus; zeroPercent is the chance of each 4-byte word to be zero,
+   the rest of the words are small integers padded by zeros as in packed rows. */
+static void BuildCorpus( uint32 seed, uint32 zeroPercent, size_t len, Buffer& into )
+{
+    into.Resize<uint8>( len );
+    for( size_t i = 0; i < len; i += 4 )
+    {
+        const uint32 r = NextRandom( seed );
+        const uint32 word = ( r % 100 < zeroPercent ? 0 : NextRandom( seed ) >> ( r % 24 ) );
+
+        for( size_t j = 0; j < 4 && i + j < len; ++j )
+            into[ i + j ] = (uint8)( word >> ( 8 * j ) );
+    }
+}
+
+/* Compares both implementations on the data. */
+static bool VerifyZeroCompress( const uint8* data, size_t len )
+{
+    Buffer expected;
+    ReferenceCompress( data, data + len, expected );
+
+    if( 0 == len )
+    {
+        // nothing at all is expected
+        Buffer unpacked;
+        ZeroUncompress( NULL, 0, unpacked );
+        return 0 == expected.size() && 0 == ZeroCompress( data, len, NULL ) && 0 == unpacked.size();
+    }
+
+    Buffer packed;
+    const size_t packedLen = ZeroCompress( data, len, NULL );
+    packed.Resize<uint8>( packedLen + ZERO_COMPRESS_SLACK );
+    if( packedLen != expected.size()
+        || packedLen > ZeroCompressBound( len )
+        || packedLen != ZeroCompress( data, len, &packed[0] )
+        || 0 != ::memcmp( &packed[0], &expected[0], packedLen ) )
+    {
+        ::printf( "Zero-compression of %lu bytes differs from the reference.\n", len );
+        return false;
+    }
+
+    Buffer expectedUnpacked, unpacked;
+    ReferenceUncompress( &expected[0], &expected[0] + packedLen, expectedUnpacked );
+    ZeroUncompress( &packed[0], packedLen, unpacked );
+    if( unpacked.size() != expectedUnpacked.size()
+        || ZeroUncompressedSize( &packed[0], packedLen ) != unpacked.size()
+        || 0 != ::memcmp( &unpacked[0], &expectedUnpacked[0], unpacked.size() )
+        || unpacked.size() < len
+        || 0 != ::memcmp( &unpacked[0], data, len ) )
+    {
+        ::printf( "Zero-uncompression of %lu bytes differs from the reference.\n", len );
+        return false;
+    }
+
+    return true;
+}
+
+enum ZeroCompressOp
+{
+    OP_REFERENCE_COMPRESS,
+    OP_COMPRESS,
+    OP_REFERENCE_UNCOMPRESS,
+    OP_UNCOMPRESS,
+
+    OP_COUNT
+};
+
+static const char* const ZERO_COMPRESS_OP_NAMES[ OP_COUNT ] =
+{
+    "reference compress",
+    "compress",
+    "reference uncompress",
+    "uncompress"
+};
+
+/* Returns the time of a single operation, in microseconds. */
+static double MeasureZeroCompressOp( ZeroCompressOp op, const Buffer& data, const Buffer& packed, uint32 timeMs )
+{
+    const uint64 limit = 1000 * (uint64)timeMs;
+
+    uint32 ops = 0;
+    uint64 time = 0;
+    Buffer out;
+
+    const uint64 start = GetTimeUSeconds();
+    do
+    {
+        out.Resize<uint8>( 0 );
+        switch( op )
+        {
+            case OP_REFERENCE_COMPRESS:
+                ReferenceCompress( &data[0], &data[0] + data.size(), out );
+                break;
+            case OP_COMPRESS:
+                out.Resize<uint8>( ZeroCompressBound( data.size() ) + ZERO_COMPRESS_SLACK );
+                out.Resize<uint8>( ZeroCompress( &data[0], data.size(), &out[0] ) );
+                break;
+            case OP_REFERENCE_UNCOMPRESS:
+                ReferenceUncompress( &packed[0], &packed[0] + packed.size(), out );
+                break;
+            case OP_UNCOMPRESS:
+                ZeroUncompress( &packed[0], packed.size(), out );
+                break;
+            default:
+                break;
+        }
+
+        ++ops;
+        time = GetTimeUSeconds() - start;
+    } while( 10 > ops || limit > time );
+
+    return (double)time / ops;
+}
+
+int marshal_EVEZeroCompressBenchmark( int argc, char* argv[] )
+{
+    uint32 timeMs = ZERO_COMPRESS_BENCHMARK_TIME;
+    if( 1 < argc )
+        timeMs = ::strtoul( argv[1], NULL, 10 );
+
+    // all the short lengths and alignments first
+    Buffer small;
+    BuildCorpus( 0x1D2C3B4A, 40, 1024, small );
+    for( size_t len = 0; len <= 200; ++len )
+        for( size_t offset = 0; offset < 8; ++offset )
+            if( !VerifyZeroCompress( &small[0] + offset, len ) )
+                return EXIT_FAILURE;
+
+    static const struct
+    {
+        const char* name;
+        uint32 zeroPercent;
+    } corpora[] =
+    {
+        { "Dense",  0 },
+        { "Rows",   30 },
+        { "Sparse", 90 }
+    };
+    const size_t corpusCount = sizeof( corpora ) / sizeof( corpora[0] );
+
+    for( size_t i = 0; i < corpusCount; ++i )
+    {
+        Buffer data;
+        BuildCorpus( 0x2F6B3A1D + i, corpora[ i ].zeroPercent, ZERO_COMPRESS_BENCHMARK_LEN, data );
+
+        if( !VerifyZeroCompress( &data[0], data.size() ) )
+            return EXIT_FAILURE;
+
+        Buffer packed;
+        ReferenceCompress( &data[0], &data[0] + data.size(), packed );
+
+        ::printf( "%s: %lu bytes compressed to %lu bytes.\n", corpora[ i ].name, data.size(), packed.size() );
+
+        double times[ OP_COUNT ];
+        for( int op = 0; op < OP_COUNT; ++op )
+        {
+            times[ op ] = MeasureZeroCompressOp( (ZeroCompressOp)op, data, packed, timeMs );
+            ::printf( "  %-20s %10.1f us/op %9.1f MB/s\n", ZERO_COMPRESS_OP_NAMES[ op ], times[ op ],
+                      data.size() / ( 1024.0 * 1024.0 ) / ( times[ op ] / 1000000.0 ) );
+        }
+
+        ::printf( "  speedup: compress %.2fx, uncompress %.2fx\n",
+                  times[ OP_REFERENCE_COMPRESS ] / times[ OP_COMPRESS ],
+                  times[ OP_REFERENCE_UNCOMPRESS ] / times[ OP_UNCOMPRESS ] );
+    }
+
+    return EXIT_SUCCESS;
+}
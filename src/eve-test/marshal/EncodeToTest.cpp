@@ -0,0 +1,115 @@
+/*
+    ------------------------------------------------------------------------------------
+    LICENSE:
+    ------------------------------------------------------------------------------------
+    This file is part of EVEmu: EVE Online Server Emulator
+    Copyright 2006 - 2011 The EVEmu Team
+    For the latest information visit http://evemu.org
+    ------------------------------------------------------------------------------------
+    This program is free software; you can redistribute it and/or modify it under
+    the terms of the GNU Lesser General Public License as published by the Free Software
+    Foundation; either version 2 of the License, or (at your option) any later
+    version.
+
+    This program is distributed in the hope that it will be useful, but WITHOUT
+    ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+    FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public License along with
+    this program; if not, write to the Free Software Foundation, Inc., 59 Temple
+    Place - Suite 330, Boston, MA 02111-1307, USA, or go to
+    http://www.gnu.org/copyleft/lesser.txt.
+    ------------------------------------------------------------------------------------
+    Author:     EVEmu Team
+*/
+
+#include "eve-test.h"
+
+/* Checks that the direct-to-wire encoder gives the same stream as marshaling Encode(). */
+template<typename T>
+static bool CompareEncoders( const char* name, const T& pkt )
+{
+    PyRep* rep = pkt.Encode();
+
+    Buffer viaRep;
+    bool res = Marshal( rep, viaRep );
+    PyDecRef( rep );
+
+    Buffer direct;
+    res = res && pkt.EncodeTo( direct );
+
+    if( !res || viaRep.size() != direct.size()
+        || 0 != ::memcmp( &viaRep[0], &direct[0], direct.size() ) )
+    {
+        ::printf( "%s: EncodeTo() differs from Encode().\n", name );
+        return false;
+    }
+
+    ::printf( "%s: %lu bytes, same as Encode().\n", name, (unsigned long)direct.size() );
+    return true;
+}
+
+int marshal_EncodeToTest( int argc, char* argv[] )
+{
+    const uint32 iterations = 20000;
+
+    // sub-stream
+    RspPing ping;
+    ping.timestamp = Win32TimeNow();
+
+    // inline strings from the string table and outside of it, None markers
+    DoDestiny_OnSpecialFX13 fx;
+    fx.entityID = 140000001;
+    fx.moduleID = 140000002;
+    fx.moduleTypeID = 0;
+    fx.targetID = 140000003;
+    fx.otherTypeID = 0;
+    fx.area.push_back( -1 );
+    fx.area.push_back( 70000 );
+    fx.effect_type = "effects.Laser";
+    fx.isOffensive = 1;
+    fx.start = 1;
+    fx.active = 0;
+    fx.duration_ms = 5000.0;
+    fx.repeat = 1000;
+    fx.startTime = Win32TimeNow();
+
+    // nested tuples, a buffer, a list and a dict of reps
+    DoDestiny_AddBalls balls;
+    balls.destiny_binary = new PyBuffer( 300, (uint8)0x5A );
+    balls.slims = new PyList;
+    for( int32 i = 0; i < 16; ++i )
+        balls.slims->AddItemInt( 140000000 + i );
+    balls.damages[ 140000001 ] = new PyFloat( 0.5 );
+
+    if( !CompareEncoders( "RspPing", ping )
+        || !CompareEncoders( "DoDestiny_OnSpecialFX13", fx )
+        || !CompareEncoders( "DoDestiny_AddBalls", balls ) )
+        return EXIT_FAILURE;
+
+    // the encoders race each other
+    Buffer out;
+    uint64 start = GetTimeUSeconds();
+    for( uint32 i = 0; i < iterations; ++i )
+    {
+        PyRep* rep = fx.Encode();
+
+        out.Resize<uint8>( 0 );
+        Marshal( rep, out );
+        PyDecRef( rep );
+    }
+    const uint64 viaRep = GetTimeUSeconds() - start;
+
+    start = GetTimeUSeconds();
+    for( uint32 i = 0; i < iterations; ++i )
+    {
+        out.Resize<uint8>( 0 );
+        fx.EncodeTo( out );
+    }
+    const uint64 direct = GetTimeUSeconds() - start;
+
+    ::printf( "Encoded %u packets in %" PRIu64 " us through Encode(), in %" PRIu64 " us through EncodeTo().\n",
+              iterations, viaRep, direct );
+
+    return EXIT_SUCCESS;
+}
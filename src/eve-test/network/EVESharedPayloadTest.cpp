@@ -0,0 +1,130 @@
+/*
+    ------------------------------------------------------------------------------------
+    LICENSE:
+    ------------------------------------------------------------------------------------
+    This file is part of EVEmu: EVE Online Server Emulator
+    Copyright 2006 - 2011 The EVEmu Team
+    For the latest information visit http://evemu.org
+    ------------------------------------------------------------------------------------
+    This program is free software; you can redistribute it and/or modify it under
+    the terms of the GNU Lesser General Public License as published by the Free Software
+    Foundation; either version 2 of the License, or (at your option) any later
+    version.
+
+    This program is distributed in the hope that it will be useful, but WITHOUT
+    ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+    FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public License along with
+    this program; if not, write to the Free Software Foundation, Inc., 59 Temple
+    Place - Suite 330, Boston, MA 02111-1307, USA, or go to
+    http://www.gnu.org/copyleft/lesser.txt.
+    ------------------------------------------------------------------------------------
+    Author:     EVEmu Team
+*/
+
+#include "eve-test.h"
+
+/**
+ * @brief Checks a shared payload packet matches the regular encoding.
+ *
+ * @param[in] argLen Length of the string argument; drives deflation.
+ * @param[in] seq    Whether to add per-recipient named payload.
+ *
+ * @return True on success, false on failure.
+ */
+static bool CheckSharedPayload( size_t argLen, bool seq )
+{
+    PyTuple* args = new PyTuple( 2 );
+    std::string arg;
+    for( size_t i = 0; i < argLen; ++i )
+        arg += (char)( 'a' + ( i * 7 ) % 26 );
+    args->items[0] = new PyString( arg );
+    args->items[1] = new PyInt( 42 );
+
+    EVENotificationStream notify;
+    notify.remoteObject = 1;
+    notify.args = args;
+
+    PyTuple* encoded = notify.Encode();
+    EVESharedPayloadRef shared( new EVESharedPayload( &encoded ) );
+
+    // different recipients must get their own envelope
+    for( uint32 userid = 1; userid <= 3; ++userid )
+    {
+        PyPacket packet;
+        packet.type_string = "macho.Notification";
+        packet.type = NOTIFICATION;
+        packet.source.type = PyAddress::Node;
+        packet.source.typeID = 0xFFAA;
+        packet.dest.type = PyAddress::Broadcast;
+        packet.dest.service = "OnLSC";
+        packet.dest.bcast_idtype = "charid";
+        packet.userid = userid * 1000;
+        packet.payload = shared->payload();
+        PyIncRef( packet.payload );
+
+        if( seq )
+        {
+            packet.named_payload = new PyDict;
+            packet.named_payload->SetItemString( "sn", new PyInt( userid ) );
+        }
+
+        Buffer* buf = shared->EncodePacket( packet );
+        if( NULL == buf )
+        {
+            ::puts( "Failed to encode shared payload packet." );
+            return false;
+        }
+
+        Buffer data;
+        data.AppendSeq( buf->begin<uint8>() + sizeof( uint32 ), buf->end<uint8>() );
+        const bool lengthOk = ( *buf->begin<uint32>() == data.size() );
+        SafeDelete( buf );
+
+        if( !lengthOk )
+        {
+            ::puts( "Shared payload packet has wrong length." );
+            return false;
+        }
+
+        // inflation checks the stream including its checksum
+        if( IsDeflated( data ) && !InflateData( data ) )
+        {
+            ::puts( "Failed to inflate shared payload packet." );
+            return false;
+        }
+
+        PyRep* rep = packet.Encode();
+        Buffer expected;
+        const bool marshaled = Marshal( rep, expected );
+        PyDecRef( rep );
+
+        if( !marshaled
+            || expected.size() != data.size()
+            || 0 != memcmp( &expected[0], &data[0], data.size() ) )
+        {
+            ::printf( "Shared payload packet (length %lu, userid %u) differs from regular one.\n", argLen, packet.userid );
+            return false;
+        }
+    }
+
+    return true;
+}
+
+int network_EVESharedPayloadTest( int argc, char* argv[] )
+{
+    // small packets are not deflated, big ones are
+    const size_t lengths[] = { 10, 0x10000, 0x30000 };
+    const size_t count = sizeof( lengths ) / sizeof( lengths[0] );
+
+    for( size_t i = 0; i < count; ++i )
+    {
+        if( !CheckSharedPayload( lengths[i], false )
+            || !CheckSharedPayload( lengths[i], true ) )
+            return EXIT_FAILURE;
+    }
+
+    ::puts( "Shared payload packets match regular ones." );
+    return EXIT_SUCCESS;
+}
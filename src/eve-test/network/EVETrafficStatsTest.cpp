@@ -0,0 +1,93 @@
+/*
+    ------------------------------------------------------------------------------------
+    LICENSE:
+    ------------------------------------------------------------------------------------
+    This file is part of EVEmu: EVE Online Server Emulator
+    Copyright 2006 - 2011 The EVEmu Team
+    For the latest information visit http://evemu.org
+    ------------------------------------------------------------------------------------
+    This program is free software; you can redistribute it and/or modify it under
+    the terms of the GNU Lesser General Public License as published by the Free Software
+    Foundation; either version 2 of the License, or (at your option) any later
+    version.
+
+    This program is distributed in the hope that it will be useful, but WITHOUT
+    ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+    FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public License along with
+    this program; if not, write to the Free Software Foundation, Inc., 59 Temple
+    Place - Suite 330, Boston, MA 02111-1307, USA, or go to
+    http://www.gnu.org/copyleft/lesser.txt.
+    ------------------------------------------------------------------------------------
+    Author:     EVEmu Team
+*/
+
+#include "eve-test.h"
+
+int network_EVETrafficStatsTest( int argc, char* argv[] )
+{
+    PyPacket packet;
+    packet.type_string = "macho.Notification";
+    packet.type = NOTIFICATION;
+    packet.source.type = PyAddress::Node;
+    packet.source.typeID = 1;
+    packet.dest.type = PyAddress::Broadcast;
+    packet.dest.service = "OnLSC";
+    packet.dest.bcast_idtype = "charid";
+    packet.payload = new PyTuple( 0 );
+
+    // the kind is the same whether read from the packet or from its encoding
+    PyRep* rep = packet.Encode();
+    const std::string notifyKind = EVETrafficStats::GetKind( rep );
+    PyDecRef( rep );
+
+    if( "OnLSC" != notifyKind || "OnLSC" != EVETrafficStats::GetKind( packet ) )
+    {
+        ::printf( "Notification kind is '%s'.\n", notifyKind.c_str() );
+        return EXIT_FAILURE;
+    }
+
+    packet.type_string = "macho.CallRsp";
+    packet.type = CALL_RSP;
+    packet.dest.type = PyAddress::Client;
+    packet.dest.service = "";
+
+    rep = packet.Encode();
+    const std::string callKind = EVETrafficStats::GetKind( rep );
+    PyDecRef( rep );
+
+    if( "CALL_RSP" != callKind || "CALL_RSP" != EVETrafficStats::GetKind( packet ) )
+    {
+        ::printf( "Call response kind is '%s'.\n", callKind.c_str() );
+        return EXIT_FAILURE;
+    }
+
+    // the login handshake is no packet
+    rep = new PyString( "OK CC" );
+    const std::string handshakeKind = EVETrafficStats::GetKind( rep );
+    PyDecRef( rep );
+
+    if( "handshake" != handshakeKind )
+    {
+        ::printf( "Handshake kind is '%s'.\n", handshakeKind.c_str() );
+        return EXIT_FAILURE;
+    }
+
+    sTrafficStats.Add( EVETrafficStats::TRAFFIC_OUT, "OnLSC", 100, 300 );
+    sTrafficStats.Add( EVETrafficStats::TRAFFIC_OUT, "OnLSC", 50, 50 );
+    sTrafficStats.Add( EVETrafficStats::TRAFFIC_IN, "CALL_REQ", 20, 20 );
+
+    std::map< std::string, EVETrafficStats::Totals > kinds;
+    sTrafficStats.GetKinds( EVETrafficStats::TRAFFIC_OUT, kinds );
+
+    if( 1 != kinds.size() || 2 != kinds[ "OnLSC" ].packets
+        || 150 != kinds[ "OnLSC" ].bytes || 350 != kinds[ "OnLSC" ].rawBytes )
+    {
+        ::printf( "Outbound traffic was not counted correctly.\n" );
+        return EXIT_FAILURE;
+    }
+
+    ::printf( "Traffic counted as expected.\n" );
+    return EXIT_SUCCESS;
+}
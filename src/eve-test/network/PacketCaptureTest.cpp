@@ -0,0 +1,135 @@
+/*
+    ------------------------------------------------------------------------------------
+    LICENSE:
+    ------------------------------------------------------------------------------------
+    This file is part of EVEmu: EVE Online Server Emulator
+    Copyright 2006 - 2011 The EVEmu Team
+    For the latest information visit http://evemu.org
+    ------------------------------------------------------------------------------------
+    This program is free software; you can redistribute it and/or modify it under
+    the terms of the GNU Lesser General Public License as published by the Free Software
+    Foundation; either version 2 of the License, or (at your option) any later
+    version.
+
+    This program is distributed in the hope that it will be useful, but WITHOUT
+    ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+    FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public License along with
+    this program; if not, write to the Free Software Foundation, Inc., 59 Temple
+    Place - Suite 330, Boston, MA 02111-1307, USA, or go to
+    http://www.gnu.org/copyleft/lesser.txt.
+    ------------------------------------------------------------------------------------
+    Author:     EVEmu Team
+*/
+
+#include "eve-test.h"
+
+int network_PacketCaptureTest( int argc, char* argv[] )
+{
+    const char* const filename = "PacketCaptureTest.evecap";
+
+    // packet sizes chosen to hit the empty packet and multi-byte lengths
+    const size_t sizes[] = { 5, 0, 300, 0x12345 };
+    const size_t count = sizeof( sizes ) / sizeof( sizes[0] );
+
+    PacketCapture capture;
+    // nothing is recorded before the capture is opened
+    capture.Write( PacketCapture::INBOUND, (const uint8*)"lost", 4 );
+
+    if( !capture.Open( filename ) )
+    {
+        ::printf( "Unable to create '%s'.\n", filename );
+        return EXIT_FAILURE;
+    }
+
+    for( size_t i = 0; i < count; ++i )
+    {
+        Buffer packet( sizes[i] );
+        for( size_t j = 0; j < sizes[i]; ++j )
+            packet[ j ] = (uint8)( i + j );
+
+        capture.Write( ( i % 2 ) ? PacketCapture::OUTBOUND : PacketCapture::INBOUND,
+                       sizes[i] ? &packet[ 0 ] : NULL, sizes[i] );
+    }
+    capture.Close();
+
+    std::vector< PacketCapture::Record > records;
+    if( !PacketCapture::Load( filename, records ) || count != records.size() )
+    {
+        ::printf( "Expected %lu records, loaded %lu.\n", count, records.size() );
+        return EXIT_FAILURE;
+    }
+
+    uint64 time = 0;
+    for( size_t i = 0; i < count; ++i )
+    {
+        const PacketCapture::Record& record = records[i];
+
+        bool ok = ( sizes[i] == record.data.size() )
+               && ( ( i % 2 ) ? PacketCapture::OUTBOUND : PacketCapture::INBOUND ) == record.direction
+               && time <= record.time;
+        for( size_t j = 0; ok && j < sizes[i]; ++j )
+            ok = ( (uint8)( i + j ) == record.data[ j ] );
+
+        if( !ok )
+        {
+            ::printf( "Record %lu is corrupted.\n", i );
+            return EXIT_FAILURE;
+        }
+
+        time = record.time;
+    }
+
+    // streaming reads the same records, reusing a single one
+    PacketCapture::Reader reader;
+    if( !reader.Open( filename ) )
+    {
+        ::printf( "Unable to stream '%s'.\n", filename );
+        return EXIT_FAILURE;
+    }
+
+    PacketCapture::Record streamed;
+    size_t read = 0;
+    for( ; reader.Read( streamed ); ++read )
+    {
+        if( count <= read
+            || records[ read ].time != streamed.time
+            || records[ read ].direction != streamed.direction
+            || records[ read ].data.size() != streamed.data.size()
+            || ( 0 < streamed.data.size() && 0 != memcmp( &records[ read ].data[ 0 ], &streamed.data[ 0 ], streamed.data.size() ) ) )
+        {
+            ::printf( "Streamed record %lu differs from the loaded one.\n", read );
+            return EXIT_FAILURE;
+        }
+    }
+
+    if( count != read )
+    {
+        ::printf( "Expected %lu streamed records, read %lu.\n", count, read );
+        return EXIT_FAILURE;
+    }
+
+    // a record cut short by a crash is dropped, the rest is kept
+    std::vector< char > contents;
+    FILE* file = fopen( filename, "rb" );
+    for( int c; EOF != ( c = fgetc( file ) ); )
+        contents.push_back( (char)c );
+    fclose( file );
+
+    file = fopen( filename, "wb" );
+    fwrite( &contents[ 0 ], contents.size() - 1, 1, file );
+    fclose( file );
+
+    records.clear();
+    if( !PacketCapture::Load( filename, records ) || count - 1 != records.size() )
+    {
+        ::printf( "Expected %lu records of the truncated capture, loaded %lu.\n", count - 1, records.size() );
+        return EXIT_FAILURE;
+    }
+
+    remove( filename );
+
+    ::puts( "All packets captured correctly." );
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,128 @@
+/*
+    ------------------------------------------------------------------------------------
+    LICENSE:
+    ------------------------------------------------------------------------------------
+    This file is part of EVEmu: EVE Online Server Emulator
+    Copyright 2006 - 2011 The EVEmu Team
+    For the latest information visit http://evemu.org
+    ------------------------------------------------------------------------------------
+    This program is free software; you can redistribute it and/or modify it under
+    the terms of the GNU Lesser General Public License as published by the Free Software
+    Foundation; either version 2 of the License, or (at your option) any later
+    version.
+
+    This program is distributed in the hope that it will be useful, but WITHOUT
+    ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+    FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public License along with
+    this program; if not, write to the Free Software Foundation, Inc., 59 Temple
+    Place - Suite 330, Boston, MA 02111-1307, USA, or go to
+    http://www.gnu.org/copyleft/lesser.txt.
+    ------------------------------------------------------------------------------------
+    Author:     EVEmu Team
+*/
+
+#include "eve-test.h"
+
+int network_StreamPacketizerTest( int argc, char* argv[] )
+{
+    // packet sizes chosen to hit small, boundary and direct-receive paths
+    const size_t sizes[] = { 0, 1, 100, STREAMPACKETIZER_DIRECT_SIZE, STREAMPACKETIZER_DIRECT_SIZE + 1,
+                             STREAMPACKETIZER_INPUT_SIZE, 3 * STREAMPACKETIZER_INPUT_SIZE + 7, 5, 0x2000 };
+    const size_t count = sizeof( sizes ) / sizeof( sizes[0] );
+
+    // build the stream
+    Buffer stream;
+    for( size_t i = 0; i < count; ++i )
+    {
+        stream.Append<uint32>( sizes[i] );
+        for( size_t j = 0; j < sizes[i]; ++j )
+            stream.Append<uint8>( (uint8)( i + j ) );
+    }
+
+    // feed it in odd-sized chunks, like recv() would
+    StreamPacketizer packetizer;
+    size_t offset = 0, chunk = 1;
+    while( offset < stream.size() )
+    {
+        size_t len;
+        uint8* span = packetizer.GetInputSpan( len );
+
+        if( len > chunk )
+            len = chunk;
+        if( len > stream.size() - offset )
+            len = stream.size() - offset;
+
+        memcpy( span, &stream[ offset ], len );
+        packetizer.CommitInput( len );
+        offset += len;
+
+        if( !packetizer.Process() )
+        {
+            ::puts( "Packetizer refused the stream." );
+            return EXIT_FAILURE;
+        }
+
+        chunk = ( chunk * 7 + 3 ) % 5000 + 1;
+    }
+
+    for( size_t i = 0; i < count; ++i )
+    {
+        Buffer* packet = packetizer.PopPacket();
+        if( NULL == packet )
+        {
+            ::printf( "Packet %lu is missing.\n", i );
+            return EXIT_FAILURE;
+        }
+
+        bool ok = ( sizes[i] == packet->size() );
+        for( size_t j = 0; ok && j < sizes[i]; ++j )
+            ok = ( (uint8)( i + j ) == (*packet)[ j ] );
+
+        SafeDelete( packet );
+
+        if( !ok )
+        {
+            ::printf( "Packet %lu is corrupted.\n", i );
+            return EXIT_FAILURE;
+        }
+    }
+
+    if( NULL != packetizer.PopPacket() )
+    {
+        ::puts( "Packetizer produced an extra packet." );
+        return EXIT_FAILURE;
+    }
+
+    // the size limit must be honored
+    StreamPacketizer limited( 10 );
+    Buffer big;
+    big.Append<uint32>( 11 );
+    if( limited.InputData( big ) )
+    {
+        ::puts( "Packet size limit has not been honored." );
+        return EXIT_FAILURE;
+    }
+
+    // announcing a big packet must not allocate all of it up front
+    StreamPacketizer announced( 0x1000000 );
+    Buffer header;
+    header.Append<uint32>( 0x1000000 );
+    if( !announced.InputData( header ) )
+    {
+        ::puts( "Packetizer refused a packet within the size limit." );
+        return EXIT_FAILURE;
+    }
+
+    size_t span;
+    announced.GetInputSpan( span );
+    if( STREAMPACKETIZER_INPUT_SIZE < span )
+    {
+        ::printf( "Packetizer allocated %lu bytes for an announced packet.\n", span );
+        return EXIT_FAILURE;
+    }
+
+    ::puts( "All packets framed correctly." );
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,190 @@
+/*
+    ------------------------------------------------------------------------------------
+    LICENSE:
+    ------------------------------------------------------------------------------------
+    This file is part of EVEmu: EVE Online Server Emulator
+    Copyright 2006 - 2011 The EVEmu Team
+    For the latest information visit http://evemu.org
+    ------------------------------------------------------------------------------------
+    This program is free software; you can redistribute it and/or modify it under
+    the terms of the GNU Lesser General Public License as published by the Free Software
+    Foundation; either version 2 of the License, or (at your option) any later
+    version.
+
+    This program is distributed in the hope that it will be useful, but WITHOUT
+    ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+    FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public License along with
+    this program; if not, write to the Free Software Foundation, Inc., 59 Temple
+    Place - Suite 330, Boston, MA 02111-1307, USA, or go to
+    http://www.gnu.org/copyleft/lesser.txt.
+    ------------------------------------------------------------------------------------
+    Author:     EVEmu Team
+*/
+
+
+#include "eve-test.h"
+
+/* Benchmark of PyDict on the shapes which use it the most:
+ *
+ *  - util.KeyVal built from a row and read back by name;
+ *  - the same KeyVal unmarshaled from the wire;
+ *  - a big dict keyed by itemIDs, like DoDestiny_AddBalls damages.
+ *
+ * The results are reported in ns per dict.
+ */
+
+/** The columns of the KeyVal, an inventory row. */
+static const char* const KEYVAL_COLUMNS[] =
+{
+    "itemID", "typeID", "ownerID", "locationID", "flag", "quantity",
+    "groupID", "categoryID", "customInfo", "singleton", "contraband", "stacksize"
+};
+static const size_t KEYVAL_COLUMN_COUNT = sizeof( KEYVAL_COLUMNS ) / sizeof( KEYVAL_COLUMNS[0] );
+/** Number of entries of the big dict. */
+static const int32 BIG_DICT_SIZE = 2000;
+
+/* Builds the KeyVal the way DBRowToKeyVal() does. */
+static PyDict* BuildKeyVal( int32 itemID )
+{
+    PyDict* dict = new PyDict;
+    for( size_t i = 0; i < KEYVAL_COLUMN_COUNT; ++i )
+        dict->SetItemString( KEYVAL_COLUMNS[ i ], new PyInt( itemID + (int32)i ) );
+
+    return dict;
+}
+
+/* Reads back all the columns, returns their sum. */
+static int32 ReadKeyVal( const PyDict* dict )
+{
+    int32 sum = 0;
+    for( size_t i = 0; i < KEYVAL_COLUMN_COUNT; ++i )
+    {
+        PyRep* value = dict->GetItemString( KEYVAL_COLUMNS[ i ] );
+        if( NULL != value )
+            sum += value->AsInt()->value();
+    }
+
+    return sum;
+}
+
+static bool CheckDict()
+{
+    PyDict* dict = BuildKeyVal( 1000 );
+
+    // replacing keeps the position and the size
+    dict->SetItemString( "flag", new PyInt( 1004 ) );
+    if( KEYVAL_COLUMN_COUNT != dict->size()
+        || (int32)( 1000 * KEYVAL_COLUMN_COUNT + KEYVAL_COLUMN_COUNT * ( KEYVAL_COLUMN_COUNT - 1 ) / 2 ) != ReadKeyVal( dict )
+        || NULL != dict->GetItemString( "nonexistent" ) )
+    {
+        ::printf( "KeyVal lookups failed.\n" );
+        return false;
+    }
+
+    // the entries are iterated in the order of insertion
+    size_t i = 0;
+    PyDict::const_iterator cur, end;
+    cur = dict->begin();
+    end = dict->end();
+    for(; cur != end; cur++, i++ )
+    {
+        if( KEYVAL_COLUMNS[ i ] != cur->first->AsString()->content() )
+        {
+            ::printf( "KeyVal iteration order differs.\n" );
+            return false;
+        }
+    }
+    PyDecRef( dict );
+
+    dict = new PyDict;
+    for( int32 id = 0; id < BIG_DICT_SIZE; ++id )
+        dict->SetItem( new PyInt( 140000000 + id * 1024 ), new PyInt( id ) );
+
+    for( int32 id = 0; id < BIG_DICT_SIZE; ++id )
+    {
+        PyInt* key = new PyInt( 140000000 + id * 1024 );
+        PyRep* value = dict->GetItem( key );
+        PyDecRef( key );
+
+        if( NULL == value || id != value->AsInt()->value() )
+        {
+            ::printf( "Big dict lookup of %d failed.\n", id );
+            return false;
+        }
+    }
+
+    PyDict* copy = new PyDict( *dict );
+    if( BIG_DICT_SIZE != (int32)copy->size() )
+    {
+        ::printf( "Big dict copy differs.\n" );
+        return false;
+    }
+    PyDecRef( copy );
+    PyDecRef( dict );
+
+    return true;
+}
+
+int python_PyDictBenchmark( int argc, char* argv[] )
+{
+    const uint32 iterations = 100000;
+
+    if( !CheckDict() )
+        return EXIT_FAILURE;
+
+    // build and read KeyVals
+    int32 sum = 0;
+    uint64 start = GetTimeUSeconds();
+    for( uint32 i = 0; i < iterations; ++i )
+    {
+        PyDict* dict = BuildKeyVal( i );
+        sum += ReadKeyVal( dict );
+        PyDecRef( dict );
+    }
+    const uint64 built = GetTimeUSeconds() - start;
+
+    // read unmarshaled KeyVals
+    PyDict* keyVal = BuildKeyVal( 1000 );
+    Buffer data;
+    Marshal( keyVal, data );
+    PyDecRef( keyVal );
+
+    start = GetTimeUSeconds();
+    for( uint32 i = 0; i < iterations; ++i )
+    {
+        PyRep* dict = Unmarshal( data );
+        sum += ReadKeyVal( dict->AsDict() );
+        PyDecRef( dict );
+    }
+    const uint64 unmarshaled = GetTimeUSeconds() - start;
+
+    // probe a big dict
+    PyDict* big = new PyDict;
+    for( int32 id = 0; id < BIG_DICT_SIZE; ++id )
+        big->SetItem( new PyInt( 140000000 + id * 1024 ), new PyFloat( 0.5 ) );
+
+    std::vector<PyInt*> keys;
+    for( int32 id = 0; id < BIG_DICT_SIZE; ++id )
+        keys.push_back( new PyInt( 140000000 + id * 1024 ) );
+
+    start = GetTimeUSeconds();
+    for( uint32 i = 0; i < iterations; ++i )
+    {
+        if( NULL != big->GetItem( keys[ i % BIG_DICT_SIZE ] ) )
+            ++sum;
+    }
+    const uint64 probed = GetTimeUSeconds() - start;
+
+    for( int32 id = 0; id < BIG_DICT_SIZE; ++id )
+        PyDecRef( keys[ id ] );
+    PyDecRef( big );
+
+    ::printf( "KeyVal built and read:       %8.1f ns/dict\n", built * 1000.0 / iterations );
+    ::printf( "KeyVal unmarshaled and read: %8.1f ns/dict\n", unmarshaled * 1000.0 / iterations );
+    ::printf( "Big dict lookup:             %8.1f ns/lookup\n", probed * 1000.0 / iterations );
+    ::printf( "(checksum %d)\n", sum );
+
+    return EXIT_SUCCESS;
+}
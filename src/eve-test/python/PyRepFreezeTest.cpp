@@ -0,0 +1,204 @@
+/*
+    ------------------------------------------------------------------------------------
+    LICENSE:
+    ------------------------------------------------------------------------------------
+    This file is part of EVEmu: EVE Online Server Emulator
+    Copyright 2006 - 2011 The EVEmu Team
+    For the latest information visit http://evemu.org
+    ------------------------------------------------------------------------------------
+    This program is free software; you can redistribute it and/or modify it under
+    the terms of the GNU Lesser General Public License as published by the Free Software
+    Foundation; either version 2 of the License, or (at your option) any later
+    version.
+
+    This program is distributed in the hope that it will be useful, but WITHOUT
+    ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+    FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public License along with
+    this program; if not, write to the Free Software Foundation, Inc., 59 Temple
+    Place - Suite 330, Boston, MA 02111-1307, USA, or go to
+    http://www.gnu.org/copyleft/lesser.txt.
+    ------------------------------------------------------------------------------------
+    Author:     EVEmu Team
+*/
+
+
+#include "eve-test.h"
+
+/*
+ * Shares a frozen PyRep tree between several threads which take and
+ * release references of its objects and read them; verifies that no
+ * reference is lost and that the tree stays intact. Also compares
+ * the cost of local and shared reference counting.
+ */
+
+static const uint32 THREAD_COUNT = 4;
+static const uint32 ROUNDS_PER_THREAD = 200000;
+static const uint32 REF_ROUNDS = 10000000;
+
+/* Builds a tree like a cached method call result. */
+static PyTuple* BuildTree()
+{
+    PyDict* keyVal = new PyDict;
+    keyVal->SetItemString( "itemID", new PyInt( 140000001 ) );
+    keyVal->SetItemString( "itemName", new PyString( "Ship" ) );
+    keyVal->SetItemString( "description", new PyWString( "A ship", 6 ) );
+
+    PyList* list = new PyList;
+    for( int32 i = 0; i < 16; ++i )
+        list->AddItemInt( i );
+
+    PyTuple* tuple = new PyTuple( 4 );
+    tuple->SetItem( 0, new PyObject( "util.KeyVal", keyVal ) );
+    tuple->SetItem( 1, list );
+    tuple->SetItem( 2, new PySubStream( new PyString( "stream" ) ) );
+    tuple->SetItem( 3, new PyBuffer( (size_t)32, (uint8)0xEE ) );
+
+    return tuple;
+}
+
+/* Reads the tree, returns false if it is not intact. */
+static bool ReadTree( const PyTuple* tree )
+{
+    const PyDict* keyVal = tree->GetItem( 0 )->AsObject()->arguments()->AsDict();
+    const PyRep* name = keyVal->GetItemString( "itemName" );
+    if( NULL == name || name->AsString()->content() != "Ship" )
+        return false;
+
+    const PyList* list = tree->GetItem( 1 )->AsList();
+    if( 16 != list->size() || 15 != list->GetItem( 15 )->AsInt()->value() )
+        return false;
+
+    const PyRep* decoded = tree->GetItem( 2 )->AsSubStream()->decoded();
+    return NULL != decoded && decoded->AsString()->content() == "stream";
+}
+
+#ifdef WIN32
+static DWORD WINAPI ReaderLoop( LPVOID arg )
+#else
+static void* ReaderLoop( void* arg )
+#endif /* !WIN32 */
+{
+    const PyTuple* tree = (const PyTuple*)arg;
+    const PyList* list = tree->GetItem( 1 )->AsList();
+
+    for( uint32 i = 0; i < ROUNDS_PER_THREAD; ++i )
+    {
+        PyRep* item = list->GetItem( i % list->size() );
+        PyIncRef( item );
+        PyIncRef( tree );
+
+        // copies of a frozen string share its characters
+        PyString* copy = new PyString( *tree->GetItem( 0 )->AsObject()->type() );
+        PyDecRef( copy );
+
+        PyDecRef( tree );
+        PyDecRef( item );
+    }
+
+    // a failure shows as a lost reference or a crash
+    return 0;
+}
+
+static bool CheckShared( const PyTuple* tree )
+{
+#ifdef WIN32
+    HANDLE threads[ THREAD_COUNT ];
+#else
+    pthread_t threads[ THREAD_COUNT ];
+#endif /* !WIN32 */
+
+    const PyRep* item = tree->GetItem( 1 )->AsList()->GetItem( 0 );
+    const size_t treeRefs = tree->GetRefCount();
+    const size_t itemRefs = item->GetRefCount();
+
+    const uint32 start = GetTickCount();
+
+    for( uint32 i = 0; i < THREAD_COUNT; ++i )
+    {
+#ifdef WIN32
+        threads[ i ] = CreateThread( NULL, 0, ReaderLoop, (LPVOID)tree, 0, NULL );
+#else
+        pthread_create( &threads[ i ], NULL, ReaderLoop, (void*)tree );
+#endif /* !WIN32 */
+    }
+
+    for( uint32 i = 0; i < THREAD_COUNT; ++i )
+    {
+#ifdef WIN32
+        WaitForSingleObject( threads[ i ], INFINITE );
+        CloseHandle( threads[ i ] );
+#else
+        pthread_join( threads[ i ], NULL );
+#endif /* !WIN32 */
+    }
+
+    ::printf( "%u threads x %u rounds on a frozen tree: %u ms\n", THREAD_COUNT, ROUNDS_PER_THREAD, GetTickCount() - start );
+
+    if( treeRefs != tree->GetRefCount() || itemRefs != item->GetRefCount() )
+    {
+        ::puts( "References of the frozen tree have been lost." );
+        return false;
+    }
+    if( !ReadTree( tree ) )
+    {
+        ::puts( "The frozen tree has been damaged." );
+        return false;
+    }
+
+    return true;
+}
+
+/* Times IncRef/DecRef pairs on a rep, returns ns per pair. */
+static double TimeRefs( const PyRep* rep )
+{
+    const uint64 start = GetTimeUSeconds();
+    for( uint32 i = 0; i < REF_ROUNDS; ++i )
+    {
+        PyIncRef( rep );
+        PyDecRef( rep );
+    }
+
+    return 1000.0 * ( GetTimeUSeconds() - start ) / REF_ROUNDS;
+}
+
+int python_PyRepFreezeTest( int argc, char* argv[] )
+{
+    PyTuple* tree = BuildTree();
+    if( tree->IsFrozen() || tree->IsShared() )
+    {
+        ::puts( "A new tree is frozen." );
+        return EXIT_FAILURE;
+    }
+
+    tree->Freeze();
+
+    const PyRep* keyVal = tree->GetItem( 0 )->AsObject()->arguments();
+    const PySubStream* stream = tree->GetItem( 2 )->AsSubStream();
+    if( !tree->IsFrozen() || !tree->IsShared()
+        || !keyVal->IsFrozen() || !keyVal->AsDict()->GetItemString( "itemID" )->IsShared()
+        || !stream->isDecoded() || NULL == stream->data() || !stream->data()->IsFrozen() )
+    {
+        ::puts( "The tree has not been frozen entirely." );
+        return EXIT_FAILURE;
+    }
+
+    // clones are mutable again
+    PyRep* clone = tree->Clone();
+    if( clone->IsFrozen() || clone->IsShared() )
+    {
+        ::puts( "A clone of a frozen tree is frozen." );
+        return EXIT_FAILURE;
+    }
+
+    if( !CheckShared( tree ) )
+        return EXIT_FAILURE;
+
+    ::printf( "IncRef/DecRef: local %.2f ns, shared %.2f ns\n", TimeRefs( clone ), TimeRefs( tree ) );
+
+    PyDecRef( clone );
+    PyDecRef( tree );
+
+    return EXIT_SUCCESS;
+}
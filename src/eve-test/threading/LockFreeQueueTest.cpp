@@ -0,0 +1,210 @@
+/*
+    ------------------------------------------------------------------------------------
+    LICENSE:
+    ------------------------------------------------------------------------------------
+    This file is part of EVEmu: EVE Online Server Emulator
+    Copyright 2006 - 2011 The EVEmu Team
+    For the latest information visit http://evemu.org
+    ------------------------------------------------------------------------------------
+    This program is free software; you can redistribute it and/or modify it under
+    the terms of the GNU Lesser General Public License as published by the Free Software
+    Foundation; either version 2 of the License, or (at your option) any later
+    version.
+
+    This program is distributed in the hope that it will be useful, but WITHOUT
+    ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+    FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public License along with
+    this program; if not, write to the Free Software Foundation, Inc., 59 Temple
+    Place - Suite 330, Boston, MA 02111-1307, USA, or go to
+    http://www.gnu.org/copyleft/lesser.txt.
+    ------------------------------------------------------------------------------------
+    Author:     EVEmu Team
+*/
+
+#include "eve-test.h"
+
+/*
+ * Compares the lock-free queue with a mutex-protected std::queue
+ * under several producers and a single consumer; also verifies that
+ * nothing is lost and every producer's elements arrive in order.
+ */
+
+static const uint32 PRODUCER_COUNT = 4;
+static const uint32 ITEMS_PER_PRODUCER = 100000;
+static const uint32 QUEUE_CAPACITY = 0x10000;
+
+/// Mutex-protected queue with the same interface, used as the baseline.
+class MutexQueue
+{
+public:
+    MutexQueue( uint32 capacity ) : mCapacity( capacity ) {}
+
+    bool Push( const uint32& value )
+    {
+        MutexLock lock( mMutex );
+
+        if( mCapacity <= mQueue.size() )
+            return false;
+
+        mQueue.push( value );
+        return true;
+    }
+
+    bool Pop( uint32& value )
+    {
+        MutexLock lock( mMutex );
+
+        if( mQueue.empty() )
+            return false;
+
+        value = mQueue.front();
+        mQueue.pop();
+        return true;
+    }
+
+protected:
+    const size_t mCapacity;
+    Mutex mMutex;
+    std::queue<uint32> mQueue;
+};
+
+template< typename Q >
+struct ProducerArgs
+{
+    Q* queue;
+    uint32 id;
+};
+
+template< typename Q >
+#ifdef WIN32
+static DWORD WINAPI ProducerLoop( LPVOID arg )
+#else
+static void* ProducerLoop( void* arg )
+#endif /* !WIN32 */
+{
+    const ProducerArgs< Q >* args = (const ProducerArgs< Q >*)arg;
+
+    for( uint32 i = 0; i < ITEMS_PER_PRODUCER; ++i )
+    {
+        // encode producer in the top byte
+        const uint32 value = ( args->id << 24 ) | i;
+        while( !args->queue->Push( value ) )
+            Sleep( 0 );
+    }
+
+    return 0;
+}
+
+template< typename Q >
+static bool RunBenchmark( const char* name )
+{
+    Q queue( QUEUE_CAPACITY );
+    ProducerArgs< Q > args[ PRODUCER_COUNT ];
+
+#ifdef WIN32
+    HANDLE threads[ PRODUCER_COUNT ];
+#else
+    pthread_t threads[ PRODUCER_COUNT ];
+#endif /* !WIN32 */
+
+    const uint32 start = GetTickCount();
+
+    for( uint32 i = 0; i < PRODUCER_COUNT; ++i )
+    {
+        args[ i ].queue = &queue;
+        args[ i ].id = i;
+
+#ifdef WIN32
+        threads[ i ] = CreateThread( NULL, 0, ProducerLoop< Q >, &args[ i ], 0, NULL );
+#else
+        pthread_create( &threads[ i ], NULL, ProducerLoop< Q >, &args[ i ] );
+#endif /* !WIN32 */
+    }
+
+    uint32 next[ PRODUCER_COUNT ] = { 0 };
+    bool ordered = true;
+
+    uint32 received = 0, value;
+    while( received < PRODUCER_COUNT * ITEMS_PER_PRODUCER )
+    {
+        if( !queue.Pop( value ) )
+        {
+            Sleep( 0 );
+            continue;
+        }
+
+        const uint32 id = value >> 24;
+        if( PRODUCER_COUNT <= id || next[ id ] != ( value & 0xFFFFFF ) )
+            ordered = false;
+        else
+            ++next[ id ];
+
+        ++received;
+    }
+
+    for( uint32 i = 0; i < PRODUCER_COUNT; ++i )
+    {
+#ifdef WIN32
+        WaitForSingleObject( threads[ i ], INFINITE );
+        CloseHandle( threads[ i ] );
+#else
+        pthread_join( threads[ i ], NULL );
+#endif /* !WIN32 */
+    }
+
+    const uint32 elapsed = GetTickCount() - start;
+    ::printf( "%-14s %u producers x %u items: %u ms\n", name, PRODUCER_COUNT, ITEMS_PER_PRODUCER, elapsed );
+
+    if( !ordered )
+        ::printf( "%s: elements lost or out of order.\n", name );
+
+    return ordered && !queue.Pop( value );
+}
+
+int threading_LockFreeQueueTest( int argc, char* argv[] )
+{
+    // single-threaded sanity checks
+    LockFreeQueue< uint32 > small( 3 );
+    if( 4 != small.GetCapacity() )
+    {
+        ::puts( "Capacity has not been rounded up to a power of 2." );
+        return EXIT_FAILURE;
+    }
+
+    uint32 value;
+    for( uint32 i = 0; i < small.GetCapacity(); ++i )
+        small.Push( i );
+    if( small.Push( 100 ) )
+    {
+        ::puts( "Full queue accepted an element." );
+        return EXIT_FAILURE;
+    }
+    if( !small.Peek( 3, value ) || 3 != value || small.Peek( 4, value ) )
+    {
+        ::puts( "Peek() returned wrong element." );
+        return EXIT_FAILURE;
+    }
+    for( uint32 i = 0; i < small.GetCapacity(); ++i )
+    {
+        if( !small.Pop( value ) || i != value )
+        {
+            ::puts( "Pop() returned wrong element." );
+            return EXIT_FAILURE;
+        }
+    }
+    if( !small.IsEmpty() || small.Pop( value ) )
+    {
+        ::puts( "Empty queue returned an element." );
+        return EXIT_FAILURE;
+    }
+
+    // contended benchmarks
+    if( !RunBenchmark< MutexQueue >( "Mutex" ) )
+        return EXIT_FAILURE;
+    if( !RunBenchmark< LockFreeQueue< uint32 > >( "LockFreeQueue" ) )
+        return EXIT_FAILURE;
+
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,241 @@
+/*
+    ------------------------------------------------------------------------------------
+    LICENSE:
+    ------------------------------------------------------------------------------------
+    This file is part of EVEmu: EVE Online Server Emulator
+    Copyright 2006 - 2011 The EVEmu Team
+    For the latest information visit http://evemu.org
+    ------------------------------------------------------------------------------------
+    This program is free software; you can redistribute it and/or modify it under
+    the terms of the GNU Lesser General Public License as published by the Free Software
+    Foundation; either version 2 of the License, or (at your option) any later
+    version.
+
+    This program is distributed in the hope that it will be useful, but WITHOUT
+    ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+    FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public License along with
+    this program; if not, write to the Free Software Foundation, Inc., 59 Temple
+    Place - Suite 330, Boston, MA 02111-1307, USA, or go to
+    http://www.gnu.org/copyleft/lesser.txt.
+    ------------------------------------------------------------------------------------
+    Author:     EVEmu Team
+*/
+
+
+#include "eve-test.h"
+
+#include "threading/LockProfile.h"
+#include "threading/SharedMutex.h"
+#include "threading/SpinMutex.h"
+
+/*
+ * Increments a counter from several threads under Mutex and SpinMutex,
+ * verifying that no increment is lost; reads a map from several
+ * threads under Mutex and SharedMutex while one thread writes it,
+ * verifying that readers never see a half-done write. Reports the time
+ * each lock took, and the contention ProfiledMutex recorded.
+ */
+
+static const uint32 THREAD_COUNT = 4;
+static const uint32 ROUNDS_PER_THREAD = 500000;
+/// Every this many rounds of the map test writes instead of reading.
+static const uint32 WRITE_INTERVAL = 1000;
+static const uint32 MAP_SIZE = 64;
+
+/// Uses the shared locks where the lock has them.
+template< typename T >
+struct ReadLockOf
+{
+    typedef Lock< T > type;
+};
+template<>
+struct ReadLockOf< SharedMutex >
+{
+    typedef SharedLock< SharedMutex > type;
+};
+
+template< typename T >
+struct LockArgs
+{
+    T* lock;
+    uint32 id;
+    /// The counter of the counter test.
+    uint32* counter;
+    /// The map of the map test; its values always sum to 0.
+    std::map< uint32, int32 >* map;
+    bool consistent;
+};
+
+template< typename T >
+#ifdef WIN32
+static DWORD WINAPI CounterLoop( LPVOID arg )
+#else
+static void* CounterLoop( void* arg )
+#endif /* !WIN32 */
+{
+    LockArgs< T >* args = (LockArgs< T >*)arg;
+
+    for( uint32 i = 0; i < ROUNDS_PER_THREAD; ++i )
+    {
+        Lock< T > lock( *args->lock );
+        ++*args->counter;
+    }
+
+    return 0;
+}
+
+template< typename T >
+#ifdef WIN32
+static DWORD WINAPI MapLoop( LPVOID arg )
+#else
+static void* MapLoop( void* arg )
+#endif /* !WIN32 */
+{
+    LockArgs< T >* args = (LockArgs< T >*)arg;
+
+    for( uint32 i = 0; i < ROUNDS_PER_THREAD; ++i )
+    {
+        if( 0 == args->id && 0 == i % WRITE_INTERVAL )
+        {
+            Lock< T > lock( *args->lock );
+
+            // moves a unit between two keys, the sum stays 0
+            --( *args->map )[ i % MAP_SIZE ];
+            ++( *args->map )[ ( i + 1 ) % MAP_SIZE ];
+            continue;
+        }
+
+        typename ReadLockOf< T >::type lock( *args->lock );
+
+        int32 sum = 0;
+        std::map< uint32, int32 >::const_iterator cur, end;
+        cur = args->map->begin();
+        end = args->map->end();
+        for(; cur != end; ++cur )
+            sum += cur->second;
+
+        if( 0 != sum )
+            args->consistent = false;
+    }
+
+    return 0;
+}
+
+template< typename T >
+static bool RunThreads( const char* test, const char* name, T& mutex,
+#ifdef WIN32
+                        DWORD ( WINAPI *loop )( LPVOID )
+#else
+                        void* ( *loop )( void* )
+#endif /* !WIN32 */
+                       )
+{
+    uint32 counter = 0;
+    std::map< uint32, int32 > map;
+    for( uint32 i = 0; i < MAP_SIZE; ++i )
+        map[ i ] = 0;
+
+    LockArgs< T > args[ THREAD_COUNT ];
+#ifdef WIN32
+    HANDLE threads[ THREAD_COUNT ];
+#else
+    pthread_t threads[ THREAD_COUNT ];
+#endif /* !WIN32 */
+
+    const uint32 start = GetTickCount();
+
+    for( uint32 i = 0; i < THREAD_COUNT; ++i )
+    {
+        args[ i ].lock = &mutex;
+        args[ i ].id = i;
+        args[ i ].counter = &counter;
+        args[ i ].map = &map;
+        args[ i ].consistent = true;
+
+#ifdef WIN32
+        threads[ i ] = CreateThread( NULL, 0, loop, &args[ i ], 0, NULL );
+#else
+        pthread_create( &threads[ i ], NULL, loop, &args[ i ] );
+#endif /* !WIN32 */
+    }
+
+    bool consistent = true;
+    for( uint32 i = 0; i < THREAD_COUNT; ++i )
+    {
+#ifdef WIN32
+        WaitForSingleObject( threads[ i ], INFINITE );
+        CloseHandle( threads[ i ] );
+#else
+        pthread_join( threads[ i ], NULL );
+#endif /* !WIN32 */
+
+        consistent = consistent && args[ i ].consistent;
+    }
+
+    ::printf( "%-8s %-26s %u threads x %u rounds: %u ms\n", test, name, THREAD_COUNT, ROUNDS_PER_THREAD, GetTickCount() - start );
+
+    if( loop == CounterLoop< T > && THREAD_COUNT * ROUNDS_PER_THREAD != counter )
+    {
+        ::printf( "%s: increments have been lost.\n", name );
+        return false;
+    }
+    if( !consistent )
+    {
+        ::printf( "%s: a reader has seen a half-done write.\n", name );
+        return false;
+    }
+
+    return true;
+}
+
+int threading_LockTest( int argc, char* argv[] )
+{
+    // single-threaded sanity checks
+    SpinMutex spin;
+    if( !spin.TryLock() || spin.TryLock() )
+    {
+        ::puts( "SpinMutex::TryLock() succeeded on a locked mutex." );
+        return EXIT_FAILURE;
+    }
+    spin.Unlock();
+
+    SharedMutex shared;
+    if( !shared.TryLockShared() || !shared.TryLockShared() || shared.TryLock() )
+    {
+        ::puts( "SharedMutex is not shared by readers or excludes nobody." );
+        return EXIT_FAILURE;
+    }
+    shared.UnlockShared();
+    shared.UnlockShared();
+    if( !shared.TryLock() || shared.TryLockShared() )
+    {
+        ::puts( "SharedMutex::TryLock() does not exclude readers." );
+        return EXIT_FAILURE;
+    }
+    shared.Unlock();
+
+    Mutex mutex;
+    if( !RunThreads( "counter", "Mutex", mutex, CounterLoop< Mutex > )
+        || !RunThreads( "counter", "SpinMutex", spin, CounterLoop< SpinMutex > )
+        || !RunThreads( "map", "Mutex", mutex, MapLoop< Mutex > )
+        || !RunThreads( "map", "SharedMutex", shared, MapLoop< SharedMutex > ) )
+        return EXIT_FAILURE;
+
+    ProfiledMutex< SpinMutex > profiled( "test" );
+    if( !RunThreads( "counter", "ProfiledMutex< SpinMutex >", profiled, CounterLoop< ProfiledMutex< SpinMutex > > ) )
+        return EXIT_FAILURE;
+
+    const uint64 acquisitions = sMetrics.Counter( "evemu_lock_acquisitions_total", "", "lock=\"test\"" ).Get();
+    const uint64 contentions = sMetrics.Counter( "evemu_lock_contentions_total", "", "lock=\"test\"" ).Get();
+    ::printf( "ProfiledMutex: %" PRIu64 " acquisitions, %" PRIu64 " contended\n", acquisitions, contentions );
+
+    if( THREAD_COUNT * ROUNDS_PER_THREAD != acquisitions || acquisitions < contentions )
+    {
+        ::puts( "ProfiledMutex has not recorded all the acquisitions." );
+        return EXIT_FAILURE;
+    }
+
+    return EXIT_SUCCESS;
+}
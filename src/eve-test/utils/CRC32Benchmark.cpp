@@ -0,0 +1,148 @@
+/*
+    ------------------------------------------------------------------------------------
+    LICENSE:
+    ------------------------------------------------------------------------------------
+    This file is part of EVEmu: EVE Online Server Emulator
+    Copyright 2006 - 2011 The EVEmu Team
+    For the latest information visit http://evemu.org
+    ------------------------------------------------------------------------------------
+    This program is free software; you can redistribute it and/or modify it under
+    the terms of the GNU Lesser General Public License as published by the Free Software
+    Foundation; either version 2 of the License, or (at your option) any later
+    version.
+
+    This program is distributed in the hope that it will be useful, but WITHOUT
+    ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+    FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public License along with
+    this program; if not, write to the Free Software Foundation, Inc., 59 Temple
+    Place - Suite 330, Boston, MA 02111-1307, USA, or go to
+    http://www.gnu.org/copyleft/lesser.txt.
+    ------------------------------------------------------------------------------------
+    Author:     EVEmu Team
+*/
+
+
+#include "eve-test.h"
+
+#include "utils/crc32.h"
+
+/* Checks CRC32 against the known check value and the byte-at-a-time
+ * reference (every length and alignment of short buffers) and measures
+ * both of them on buffers as large as the cached objects.
+ *
+ * The optional first argument is time (in milliseconds) spent on each
+ * measurement; the default is CRC32_BENCHMARK_TIME.
+ */
+
+/** Default time (in milliseconds) spent on a single measurement. */
+static const uint32 CRC32_BENCHMARK_TIME = 200;
+/** Sizes of the measured buffers. */
+static const size_t CRC32_BENCHMARK_SIZES[] = { 64, 4096, 1 << 20 };
+
+/* The byte-at-a-time loop CRC32 used to run. */
+static uint32 ReferenceCRC32( const uint8* buf, size_t bufsize, uint32 crc32 = 0xFFFFFFFF )
+{
+    for( size_t i = 0; i < bufsize; ++i )
+        crc32 = ( crc32 >> 8 ) ^ CRC32_LOOKUP_TABLE[ buf[ i ] ^ ( crc32 & 0x000000FF ) ];
+
+    return crc32;
+}
+
+/* Deterministic generator, so the runs are comparable. */
+static void FillCRC32( std::vector< uint8 >& buf )
+{
+    uint32 state = 0x85EBCA6B;
+    for( size_t i = 0; i < buf.size(); ++i )
+        buf[ i ] = ( state = state * 1664525 + 1013904223 ) >> 24;
+}
+
+static bool VerifyCRC32()
+{
+    const char check[] = "123456789";
+    if( 0xCBF43926 != CRC32::Generate( (const uint8*)check, sizeof( check ) - 1 ) )
+    {
+        ::puts( "The check value differs." );
+        return false;
+    }
+
+    std::vector< uint8 > buf( 1024 );
+    FillCRC32( buf );
+
+    for( size_t offset = 0; offset < 8; ++offset )
+    {
+        for( size_t len = 0; len + offset <= 300; ++len )
+        {
+            if( ReferenceCRC32( &buf[ offset ], len ) != CRC32::Update( &buf[ offset ], len ) )
+            {
+                ::printf( "CRC of %u bytes at offset %u differs.\n", (uint32)len, (uint32)offset );
+                return false;
+            }
+        }
+    }
+
+    // a CRC updated piecewise equals the CRC of the whole buffer
+    uint32 crc32 = 0xFFFFFFFF;
+    for( size_t i = 0; i < buf.size(); i += 37 )
+        crc32 = CRC32::Update( &buf[ i ], std::min< size_t >( 37, buf.size() - i ), crc32 );
+    if( CRC32::Finish( crc32 ) != CRC32::Generate( &buf[0], buf.size() ) )
+    {
+        ::puts( "Piecewise CRC differs." );
+        return false;
+    }
+
+    return true;
+}
+
+/* Sums the results, so none of the work is optimized away. */
+static uint32 g_crc32Sink = 0;
+
+/* Returns the throughput, in MB/s. */
+static double MeasureCRC32( bool reference, const std::vector< uint8 >& buf, uint32 timeMs )
+{
+    const uint64 limit = 1000 * (uint64)timeMs;
+
+    uint32 ops = 0;
+    uint64 time = 0;
+    uint32 sum = 0;
+
+    const uint64 start = GetTimeUSeconds();
+    do
+    {
+        if( reference )
+            sum += ReferenceCRC32( &buf[0], buf.size() );
+        else
+            sum += CRC32::Update( &buf[0], buf.size() );
+
+        ++ops;
+        time = GetTimeUSeconds() - start;
+    } while( 10 > ops || limit > time );
+
+    g_crc32Sink += sum;
+    return (double)ops * buf.size() / ( time ? time : 1 );
+}
+
+int utils_CRC32Benchmark( int argc, char* argv[] )
+{
+    uint32 timeMs = CRC32_BENCHMARK_TIME;
+    if( 1 < argc )
+        timeMs = ::strtoul( argv[1], NULL, 10 );
+
+    const bool verified = VerifyCRC32();
+    if( verified )
+    {
+        for( size_t i = 0; i < sizeof( CRC32_BENCHMARK_SIZES ) / sizeof( CRC32_BENCHMARK_SIZES[0] ); ++i )
+        {
+            std::vector< uint8 > buf( CRC32_BENCHMARK_SIZES[ i ] );
+            FillCRC32( buf );
+
+            const double reference = MeasureCRC32( true, buf, timeMs );
+            const double sliced = MeasureCRC32( false, buf, timeMs );
+            ::printf( "  %8u bytes: reference %8.1f MB/s, CRC32 %8.1f MB/s, speedup %.2fx\n",
+                      (uint32)buf.size(), reference, sliced, sliced / reference );
+        }
+    }
+
+    return verified ? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -0,0 +1,146 @@
+/*
+    ------------------------------------------------------------------------------------
+    LICENSE:
+    ------------------------------------------------------------------------------------
+    This file is part of EVEmu: EVE Online Server Emulator
+    Copyright 2006 - 2011 The EVEmu Team
+    For the latest information visit http://evemu.org
+    ------------------------------------------------------------------------------------
+    This program is free software; you can redistribute it and/or modify it under
+    the terms of the GNU Lesser General Public License as published by the Free Software
+    Foundation; either version 2 of the License, or (at your option) any later
+    version.
+
+    This program is distributed in the hope that it will be useful, but WITHOUT
+    ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+    FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public License along with
+    this program; if not, write to the Free Software Foundation, Inc., 59 Temple
+    Place - Suite 330, Boston, MA 02111-1307, USA, or go to
+    http://www.gnu.org/copyleft/lesser.txt.
+    ------------------------------------------------------------------------------------
+    Author:     EVEmu Team
+*/
+
+
+#include "eve-test.h"
+
+/// Stamps the points of a trace a fixed time apart, starting at the given time.
+static void StampTrace( CallTrace& trace, uint64 start )
+{
+    // offsets of the points; the queries of the dispatch take 500 us
+    static const uint64 offsets[ CallTrace::POINT_COUNT ] = { 0, 100, 500, 700, 750, 2750, 2800, 3000, 3300 };
+
+    for( size_t i = 0; i < CallTrace::POINT_COUNT; ++i )
+        trace.at[ i ] = start + offsets[ i ];
+}
+
+int utils_CallTracerTest( int argc, char* argv[] )
+{
+    // the stages expected of StampTrace()
+    static const uint64 stages[ CallTrace::STAGE_COUNT ] = { 100, 400, 200, 50, 1500, 500, 50, 200, 300 };
+
+    CallTracer tracer;
+    tracer.Configure( 2, 2, false );
+
+    // every other call is sampled
+    std::vector< CallTrace* > traces;
+    for( size_t i = 0; i < 6; ++i )
+    {
+        CallTrace* trace = tracer.Sample();
+        if( ( 1 == i % 2 ) != ( NULL != trace ) )
+        {
+            ::printf( "Call %lu sampled unexpectedly.\n", i );
+            return EXIT_FAILURE;
+        }
+
+        if( NULL != trace )
+            traces.push_back( trace );
+    }
+
+    for( size_t i = 0; i < traces.size(); ++i )
+    {
+        CallTrace* trace = traces[ i ];
+        StampTrace( *trace, 1000 * ( i + 1 ) );
+        trace->call = ( 0 == i ? "first" : 1 == i ? "second" : "third" );
+
+        // only the queries run while the trace is current are charged
+        CallTracer::SetCurrent( trace );
+        CallTracer::AddQuery( 300 );
+        CallTracer::AddQuery( 200 );
+        CallTracer::SetCurrent( NULL );
+        CallTracer::AddQuery( 1000 );
+    }
+
+    for( size_t i = 0; i < CallTrace::STAGE_COUNT; ++i )
+    {
+        const uint64 time = traces[ 0 ]->GetStage( (CallTrace::Stage)i );
+        if( stages[ i ] != time )
+        {
+            ::printf( "Stage %s took %lu us, expected %lu us.\n", CallTrace::STAGE_NAMES[ i ], (unsigned long)time, (unsigned long)stages[ i ] );
+            return EXIT_FAILURE;
+        }
+    }
+    if( 3300 != traces[ 0 ]->GetTotal() || 2 != traces[ 0 ]->queries )
+    {
+        ::puts( "Unexpected total time or number of queries." );
+        return EXIT_FAILURE;
+    }
+
+    // a call queued during the tick waits for the rest of it only
+    CallTrace queued;
+    StampTrace( queued, 1000 );
+    queued.at[ CallTrace::WOKEN ] = 900;
+    if( 0 != queued.GetStage( CallTrace::STAGE_QUEUE ) || 600 != queued.GetStage( CallTrace::STAGE_LOOP ) )
+    {
+        ::puts( "A call queued during the tick waited for it." );
+        return EXIT_FAILURE;
+    }
+
+    tracer.Finish( &traces[ 0 ] );
+    tracer.Discard( &traces[ 1 ] );
+    tracer.Finish( &traces[ 2 ] );
+    if( NULL != traces[ 0 ] || NULL != traces[ 1 ] || NULL != traces[ 2 ] )
+    {
+        ::puts( "The traces were not taken over." );
+        return EXIT_FAILURE;
+    }
+    tracer.Process();
+
+    const CallTracer::Stats& stats = tracer.stats();
+    if( 3 != stats.sampled || 2 != stats.finished || 1 != stats.dropped
+        || 2 * stages[ CallTrace::STAGE_DISPATCH ] != stats.stageTime[ CallTrace::STAGE_DISPATCH ]
+        || 3300 != stats.maxTotalTime )
+    {
+        ::printf( "Unexpected stats: %u sampled, %u finished, %u dropped.\n", stats.sampled, stats.finished, stats.dropped );
+        return EXIT_FAILURE;
+    }
+
+    // the latest first
+    std::string summary;
+    if( 2 != tracer.Dump( 10, summary ) || 0 != summary.find( "third " ) || std::string::npos == summary.find( "\nfirst " )
+        || std::string::npos == summary.find( "sql 0.50 (2 queries)" ) )
+    {
+        ::printf( "Unexpected summary:\n%s\n", summary.c_str() );
+        return EXIT_FAILURE;
+    }
+
+    tracer.SetRate( 0 );
+    if( tracer.IsEnabled() || NULL != tracer.Sample() )
+    {
+        ::puts( "A call was sampled with the tracing disabled." );
+        return EXIT_FAILURE;
+    }
+
+    tracer.Reset();
+    summary.clear();
+    if( 0 != tracer.Dump( 10, summary ) )
+    {
+        ::puts( "Traces kept after a reset." );
+        return EXIT_FAILURE;
+    }
+
+    ::puts( "CallTracer OK." );
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,104 @@
+/*
+    ------------------------------------------------------------------------------------
+    LICENSE:
+    ------------------------------------------------------------------------------------
+    This file is part of EVEmu: EVE Online Server Emulator
+    Copyright 2006 - 2011 The EVEmu Team
+    For the latest information visit http://evemu.org
+    ------------------------------------------------------------------------------------
+    This program is free software; you can redistribute it and/or modify it under
+    the terms of the GNU Lesser General Public License as published by the Free Software
+    Foundation; either version 2 of the License, or (at your option) any later
+    version.
+
+    This program is distributed in the hope that it will be useful, but WITHOUT
+    ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+    FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public License along with
+    this program; if not, write to the Free Software Foundation, Inc., 59 Temple
+    Place - Suite 330, Boston, MA 02111-1307, USA, or go to
+    http://www.gnu.org/copyleft/lesser.txt.
+    ------------------------------------------------------------------------------------
+    Author:     EVEmu Team
+*/
+
+#include "eve-test.h"
+
+/**
+ * @brief Checks a deflated stream matches the one of zlib's compress().
+ *
+ * @param[in] input    The data.
+ * @param[in] deflated The stream to check.
+ *
+ * @return True on success, false on failure.
+ */
+static bool CheckCompressed( const Buffer& input, const Buffer& deflated )
+{
+    uLongf len = compressBound( input.size() );
+    Buffer expected;
+    expected.Resize<uint8>( len );
+
+    if( Z_OK != compress( &expected[0], &len, &input[0], input.size() ) )
+        return false;
+
+    return len == deflated.size()
+        && 0 == memcmp( &expected[0], &deflated[0], len );
+}
+
+int utils_DeflateTest( int argc, char* argv[] )
+{
+    const size_t lengths[] = { 1, 1000, 0x30000 };
+    const size_t count = sizeof( lengths ) / sizeof( lengths[0] );
+
+    for( size_t i = 0; i < count; ++i )
+    {
+        // compressible, but not trivially
+        Buffer input;
+        for( size_t j = 0; j < lengths[i]; ++j )
+            input.Append<uint8>( j % 97 < 50 ? 0 : ( j * 7 ) % 13 );
+
+        Buffer deflated;
+        if( !DeflateData( input, deflated ) || !CheckCompressed( input, deflated ) )
+        {
+            ::printf( "Deflated data (length %lu) differ from compress().\n", lengths[i] );
+            return EXIT_FAILURE;
+        }
+
+        // the same stream in chunks of odd sizes
+        Buffer chunked;
+        DeflateStream stream( chunked );
+        for( size_t off = 0, chunk = 1; off < input.size(); off += chunk, chunk = chunk * 3 + 1 )
+            stream.Write( &input[off], std::min( chunk, input.size() - off ) );
+
+        if( !stream.Finish() || !CheckCompressed( input, chunked ) )
+        {
+            ::printf( "Data deflated in chunks (length %lu) differ from compress().\n", lengths[i] );
+            return EXIT_FAILURE;
+        }
+
+        Buffer inflated;
+        if( !InflateData( deflated, inflated )
+            || inflated.size() != input.size()
+            || 0 != memcmp( &inflated[0], &input[0], input.size() ) )
+        {
+            ::printf( "Failed to inflate data (length %lu).\n", lengths[i] );
+            return EXIT_FAILURE;
+        }
+
+        // truncated stream must fail and leave the output alone
+        Buffer truncated;
+        truncated.AppendSeq( deflated.begin<uint8>(), deflated.begin<uint8>() + deflated.size() / 2 );
+
+        Buffer output;
+        output.Append<uint32>( 0 );
+        if( InflateData( truncated, output ) || sizeof( uint32 ) != output.size() )
+        {
+            ::printf( "Inflated truncated data (length %lu).\n", lengths[i] );
+            return EXIT_FAILURE;
+        }
+    }
+
+    ::puts( "Deflate OK." );
+    return EXIT_SUCCESS;
+}
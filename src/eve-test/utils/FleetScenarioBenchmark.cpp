@@ -0,0 +1,732 @@
+/*
+    ------------------------------------------------------------------------------------
+    LICENSE:
+    ------------------------------------------------------------------------------------
+    This file is part of EVEmu: EVE Online Server Emulator
+    Copyright 2006 - 2011 The EVEmu Team
+    For the latest information visit http://evemu.org
+    ------------------------------------------------------------------------------------
+    This program is free software; you can redistribute it and/or modify it under
+    the terms of the GNU Lesser General Public License as published by the Free Software
+    Foundation; either version 2 of the License, or (at your option) any later
+    version.
+
+    This program is distributed in the hope that it will be useful, but WITHOUT
+    ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+    FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public License along with
+    this program; if not, write to the Free Software Foundation, Inc., 59 Temple
+    Place - Suite 330, Boston, MA 02111-1307, USA, or go to
+    http://www.gnu.org/copyleft/lesser.txt.
+    ------------------------------------------------------------------------------------
+    Author:     EVEmu Team
+*/
+
+#include "eve-test.h"
+
+/* Runs a scripted fleet fight through the pieces the server runs it on:
+ * ships activate and deactivate modules on their ModifierGraph, lock
+ * targets on TimerWheel timers, cycle modules on the wheel drawing on
+ * a RechargeState capacitor, and take the hits of the tic on shield,
+ * armor and hull after all the cycles, the way the kills of a system
+ * tick are resolved. The subsystems run one after another within each
+ * tic, so the time of each of them is measured on its own; the percentiles
+ * of those per-tic times are reported.
+ *
+ * The optional arguments are the number of ships and the number of tics;
+ * the defaults are FLEET_BENCHMARK_SHIPS and FLEET_BENCHMARK_TICS.
+ */
+
+/** Default number of ships in the fight. */
+static const uint32 FLEET_BENCHMARK_SHIPS = 200;
+/** Default number of tics to run. */
+static const uint32 FLEET_BENCHMARK_TICS = 300;
+/** Length of a tic (in milliseconds), that of the system tick. */
+static const uint32 FLEET_BENCHMARK_TIC = 1000;
+/** Weapons fitted to each ship. */
+static const uint32 FLEET_BENCHMARK_WEAPONS = 6;
+/** Active hardeners fitted to each ship. */
+static const uint32 FLEET_BENCHMARK_HARDENERS = 3;
+/** Number of modules fitted to each ship. */
+static const uint32 FLEET_BENCHMARK_MODULES = FLEET_BENCHMARK_WEAPONS + FLEET_BENCHMARK_HARDENERS;
+/** Trained skills boosting the weapons. */
+static const uint32 FLEET_BENCHMARK_SKILLS = 20;
+/** Number of itemIDs reserved for each ship, its modules and its skills. */
+static const uint32 FLEET_BENCHMARK_ITEMS = 100;
+
+// ship attributes, each of the resonances for 4 damage types
+static const uint32 FLEET_ATTR_SHIELD_RESONANCE = 10;
+static const uint32 FLEET_ATTR_ARMOR_RESONANCE = 14;
+static const uint32 FLEET_ATTR_HULL_RESONANCE = 18;
+static const uint32 FLEET_ATTR_DAMAGE_MULTIPLIER = 40;
+// module attributes, damage for 4 damage types
+static const uint32 FLEET_ATTR_DAMAGE = 50;
+static const uint32 FLEET_ATTR_DURATION = 54;
+static const uint32 FLEET_ATTR_CAPACITOR_NEED = 55;
+static const uint32 FLEET_ATTR_RESISTANCE_BONUS = 56;
+
+static const uint32 FLEET_SKILL_EFFECT = 132;
+static const uint32 FLEET_WEAPON_EFFECT = 10;
+static const uint32 FLEET_HARDENER_EFFECT = 2052;
+
+static const double FLEET_SHIELD_RESONANCES[ 4 ] = { 1.0, 0.8, 0.6, 0.5 };
+static const double FLEET_ARMOR_RESONANCES[ 4 ]  = { 0.5, 0.65, 0.75, 0.9 };
+static const double FLEET_HULL_RESONANCES[ 4 ]   = { 0.6, 0.6, 0.6, 0.6 };
+static const double FLEET_WEAPON_DAMAGE[ 4 ]     = { 0.0, 40.0, 30.0, 0.0 };
+
+/* Deterministic generator, so the runs are comparable. */
+class FleetRandom
+{
+public:
+    FleetRandom() : mState( 0x6C8E9CF5 ) {}
+
+    uint32 Next() { return ( mState = mState * 1664525 + 1013904223 ) >> 8; }
+    uint32 Next( uint32 max ) { return Next() % max; }
+
+protected:
+    uint32 mState;
+};
+
+enum FleetSubsystem
+{
+    FLEET_ACTIVATION,
+    FLEET_TARGETING,
+    FLEET_CYCLES,
+    FLEET_DAMAGE,
+    FLEET_MODIFIERS,
+
+    FLEET_SUBSYSTEM_COUNT
+};
+
+static const char* const FLEET_SUBSYSTEM_NAMES[ FLEET_SUBSYSTEM_COUNT ] =
+{
+    "activation",
+    "targeting",
+    "cycles",
+    "damage",
+    "modifiers"
+};
+
+class FleetScenario;
+class FleetShip;
+
+/* A module, scheduled only while it cycles. */
+class FleetModule
+: public TimerWheel::Callback
+{
+public:
+    FleetModule() : ship( NULL ), index( 0 ), active( false ), stop( false ) {}
+
+    FleetShip* ship;
+    uint32 index;
+    bool active;
+    /// Set by deactivation; the running cycle is finished.
+    bool stop;
+
+protected:
+    void TimerExpired();
+};
+
+class FleetShip
+{
+public:
+    FleetShip( FleetScenario& scenario, uint32 index );
+
+    uint32 life() const { return mLife; }
+    bool dirty() const { return mDirty; }
+
+    /// Decides what to do this tic, queueing it with the scenario.
+    void Script( FleetRandom& rnd );
+
+    /// Starts a module cycling.
+    void Activate( uint32 m );
+    /// Lets a module finish its cycle.
+    void Deactivate( uint32 m );
+    /// Starts locking the target.
+    void StartLock( FleetShip* target, uint32 delay );
+    /// The cycle of a module has ended.
+    void CycleExpired( FleetModule& module );
+
+    /// Takes a hit; returns true if it destroyed the ship.
+    bool ApplyHit( const double damage[ 4 ] );
+    /// Comes back after being destroyed.
+    void Respawn();
+    /// Recomputes the modified attributes and caches what the hits need.
+    void UpdateModifiers();
+
+protected:
+    void _BuildGraph();
+    void _StartCycle( FleetModule& module );
+    void _StopModule( FleetModule& module );
+    void _DropTarget();
+    void _LockExpired();
+    double _GetValue( uint32 itemID, uint32 attributeID );
+    double _ApplyLayer( const double damage[ 4 ], const double resonances[ 4 ], double ratio );
+
+    uint32 _GetModuleID( uint32 m ) const { return mItemID + 1 + m; }
+    bool _IsHardener( uint32 m ) const { return FLEET_BENCHMARK_WEAPONS <= m; }
+
+    FleetScenario& mScenario;
+    const uint32 mItemID;
+
+    ModifierGraph mGraph;
+    std::vector< ModifierGraph::Change > mChanges;
+    bool mDirty;
+
+    RechargeState mCapacitor;
+    RechargeState mShield;
+    double mArmor;
+    double mHull;
+    /// Increased by each respawn, so the attackers notice.
+    uint32 mLife;
+
+    /// Cached by UpdateModifiers().
+    double mResonances[ 12 ];
+    double mDamage[ FLEET_BENCHMARK_WEAPONS ][ 4 ];
+
+    FleetModule mModules[ FLEET_BENCHMARK_MODULES ];
+
+    /// The ship we lock or have locked, and its life at the time.
+    FleetShip* mTarget;
+    uint32 mTargetLife;
+    bool mLocked;
+    TimerWheelMember< FleetShip, &FleetShip::_LockExpired > mLockTimer;
+};
+
+/* The ships and the work queued between the subsystems of a tic. */
+class FleetScenario
+{
+public:
+    FleetScenario( uint32 shipCount );
+    ~FleetScenario();
+
+    uint32 now() const { return mNow; }
+    /// Locks and module cycles are kept apart, so they can be timed apart.
+    TimerWheel& lockWheel() { return mLockWheel; }
+    TimerWheel& cycleWheel() { return mCycleWheel; }
+
+    uint32 GetShipCount() const { return mShips.size(); }
+    FleetShip* GetShip( uint32 index ) { return mShips[ index ]; }
+
+    void QueueToggle( FleetShip* ship, uint32 m, bool on );
+    void QueueLock( FleetShip* ship, FleetShip* target, uint32 delay );
+    void QueueHit( FleetShip* target, const double damage[ 4 ] );
+
+    /// Runs a single tic, recording the time of each subsystem.
+    void RunTic( FleetRandom& rnd );
+
+    /// Times (in microseconds) of each tic, per subsystem.
+    std::vector< uint64 > times[ FLEET_SUBSYSTEM_COUNT ];
+
+    uint32 activations;
+    uint32 locks;
+    uint32 cycles;
+    uint32 hits;
+    uint32 kills;
+
+protected:
+    struct Toggle
+    {
+        FleetShip* ship;
+        uint32 module;
+        bool on;
+    };
+    struct Lock
+    {
+        FleetShip* ship;
+        FleetShip* target;
+        uint32 delay;
+    };
+    struct Hit
+    {
+        FleetShip* target;
+        double damage[ 4 ];
+    };
+
+    uint32 mNow;
+    TimerWheel mLockWheel;
+    TimerWheel mCycleWheel;
+    std::vector< FleetShip* > mShips;
+
+    std::vector< Toggle > mToggles;
+    std::vector< Lock > mLocks;
+    std::vector< Hit > mHits;
+    std::vector< FleetShip* > mKilled;
+};
+
+void FleetModule::TimerExpired()
+{
+    ship->CycleExpired( *this );
+}
+
+FleetShip::FleetShip( FleetScenario& scenario, uint32 index )
+: mScenario( scenario ),
+  mItemID( 1 + index * FLEET_BENCHMARK_ITEMS ),
+  mDirty( true ),
+  mArmor( 0.0 ),
+  mHull( 0.0 ),
+  mLife( 0 ),
+  mTarget( NULL ),
+  mTargetLife( 0 ),
+  mLocked( false ),
+  mLockTimer( *this )
+{
+    for( uint32 m = 0; m < FLEET_BENCHMARK_MODULES; ++m )
+    {
+        mModules[ m ].ship = this;
+        mModules[ m ].index = m;
+    }
+
+    _BuildGraph();
+    Respawn();
+    UpdateModifiers();
+}
+
+void FleetShip::Script( FleetRandom& rnd )
+{
+    // the target blew up and came back
+    if( NULL != mTarget && mTarget->life() != mTargetLife )
+        _DropTarget();
+
+    if( NULL == mTarget )
+    {
+        FleetShip* target = mScenario.GetShip( rnd.Next( mScenario.GetShipCount() ) );
+        if( this != target && !mLockTimer.IsTimerScheduled() )
+            mScenario.QueueLock( this, target, 2000 + rnd.Next( 4000 ) );
+    }
+    else if( mLocked )
+    {
+        for( uint32 m = 0; m < FLEET_BENCHMARK_WEAPONS; ++m )
+            if( !mModules[ m ].active || mModules[ m ].stop )
+                mScenario.QueueToggle( this, m, true );
+
+        // switch to someone else now and then
+        if( 0 == rnd.Next( 40 ) )
+            for( uint32 m = 0; m < FLEET_BENCHMARK_WEAPONS; ++m )
+                mScenario.QueueToggle( this, m, false );
+    }
+
+    if( 0 == rnd.Next( 8 ) )
+    {
+        const uint32 m = FLEET_BENCHMARK_WEAPONS + rnd.Next( FLEET_BENCHMARK_HARDENERS );
+        mScenario.QueueToggle( this, m, !mModules[ m ].active || mModules[ m ].stop );
+    }
+}
+
+void FleetShip::Activate( uint32 m )
+{
+    FleetModule& module = mModules[ m ];
+
+    // already cycling; a pending deactivation is called off
+    if( module.active )
+    {
+        module.stop = false;
+        return;
+    }
+
+    if( !_IsHardener( m ) && !mLocked )
+        return;
+    if( mCapacitor.GetValue( mScenario.now() ) < _GetValue( _GetModuleID( m ), FLEET_ATTR_CAPACITOR_NEED ) )
+        return;
+
+    if( _IsHardener( m ) )
+    {
+        const uint32 first = ( m - FLEET_BENCHMARK_WEAPONS < 2 ? FLEET_ATTR_SHIELD_RESONANCE : FLEET_ATTR_ARMOR_RESONANCE );
+        for( uint32 i = 0; i < 4; ++i )
+        {
+            ModifierGraph::Modifier modifier;
+            modifier.sourceItemID = _GetModuleID( m );
+            modifier.sourceAttributeID = FLEET_ATTR_RESISTANCE_BONUS;
+            modifier.value = 0.0;
+            modifier.effectID = FLEET_HARDENER_EFFECT;
+            modifier.targetItemID = mItemID;
+            modifier.targetAttributeID = first + i;
+            modifier.operation = ModifierGraph::OP_POST_PERCENT;
+            modifier.penalized = true;
+
+            mGraph.AddModifier( modifier );
+        }
+        mDirty = true;
+    }
+
+    module.active = true;
+    module.stop = false;
+    ++mScenario.activations;
+
+    _StartCycle( module );
+}
+
+void FleetShip::Deactivate( uint32 m )
+{
+    if( mModules[ m ].active )
+        mModules[ m ].stop = true;
+}
+
+void FleetShip::StartLock( FleetShip* target, uint32 delay )
+{
+    mTarget = target;
+    mTargetLife = target->life();
+    mLocked = false;
+
+    mScenario.lockWheel().Schedule( &mLockTimer, delay );
+}
+
+void FleetShip::CycleExpired( FleetModule& module )
+{
+    ++mScenario.cycles;
+
+    if( module.stop
+        || ( !_IsHardener( module.index ) && ( !mLocked || mTarget->life() != mTargetLife ) )
+        || mCapacitor.GetValue( mScenario.now() ) < _GetValue( _GetModuleID( module.index ), FLEET_ATTR_CAPACITOR_NEED ) )
+    {
+        _StopModule( module );
+        return;
+    }
+
+    _StartCycle( module );
+}
+
+bool FleetShip::ApplyHit( const double damage[ 4 ] )
+{
+    const uint32 now = mScenario.now();
+
+    // shield, then armor, then hull; what a layer could not take goes further down
+    const double shield = mShield.GetValue( now );
+    const double shieldDamage = _ApplyLayer( damage, &mResonances[ 0 ], 1.0 );
+    if( shieldDamage <= shield )
+    {
+        mShield.SetValue( shield - shieldDamage, now );
+        return false;
+    }
+    double ratio = 1.0 - shield / shieldDamage;
+    mShield.SetValue( 0.0, now );
+
+    const double armorDamage = _ApplyLayer( damage, &mResonances[ 4 ], ratio );
+    if( armorDamage <= mArmor )
+    {
+        mArmor -= armorDamage;
+        return false;
+    }
+    ratio *= 1.0 - mArmor / armorDamage;
+    mArmor = 0.0;
+
+    const double hullDamage = _ApplyLayer( damage, &mResonances[ 8 ], ratio );
+    if( hullDamage < mHull )
+    {
+        mHull -= hullDamage;
+        return false;
+    }
+    mHull = 0.0;
+
+    return true;
+}
+
+void FleetShip::Respawn()
+{
+    const uint32 now = mScenario.now();
+
+    for( uint32 m = 0; m < FLEET_BENCHMARK_MODULES; ++m )
+        if( mModules[ m ].active )
+            _StopModule( mModules[ m ] );
+    _DropTarget();
+
+    mCapacitor.Reset( 1500.0, 300000.0, 1500.0, now );
+    mShield.Reset( 2000.0, 600000.0, 2000.0, now );
+    mArmor = 1500.0;
+    mHull = 1500.0;
+    ++mLife;
+}
+
+void FleetShip::UpdateModifiers()
+{
+    mChanges.clear();
+    mGraph.Update( mChanges );
+
+    for( uint32 i = 0; i < 12; ++i )
+        mResonances[ i ] = _GetValue( mItemID, FLEET_ATTR_SHIELD_RESONANCE + i );
+    for( uint32 m = 0; m < FLEET_BENCHMARK_WEAPONS; ++m )
+        for( uint32 i = 0; i < 4; ++i )
+            mDamage[ m ][ i ] = _GetValue( _GetModuleID( m ), FLEET_ATTR_DAMAGE + i );
+
+    mDirty = false;
+}
+
+void FleetShip::_BuildGraph()
+{
+    for( uint32 i = 0; i < 4; ++i )
+    {
+        mGraph.SetBaseValue( mItemID, FLEET_ATTR_SHIELD_RESONANCE + i, FLEET_SHIELD_RESONANCES[ i ] );
+        mGraph.SetBaseValue( mItemID, FLEET_ATTR_ARMOR_RESONANCE + i, FLEET_ARMOR_RESONANCES[ i ] );
+        mGraph.SetBaseValue( mItemID, FLEET_ATTR_HULL_RESONANCE + i, FLEET_HULL_RESONANCES[ i ] );
+    }
+    mGraph.SetBaseValue( mItemID, FLEET_ATTR_DAMAGE_MULTIPLIER, 1.0 );
+
+    // each of the skills adds 2 % to the damage multiplier of the ship ...
+    for( uint32 s = 0; s < FLEET_BENCHMARK_SKILLS; ++s )
+    {
+        ModifierGraph::Modifier modifier;
+        modifier.sourceItemID = mItemID + 1 + FLEET_BENCHMARK_MODULES + s;
+        modifier.sourceAttributeID = 0;
+        modifier.value = 2.0;
+        modifier.effectID = FLEET_SKILL_EFFECT;
+        modifier.targetItemID = mItemID;
+        modifier.targetAttributeID = FLEET_ATTR_DAMAGE_MULTIPLIER;
+        modifier.operation = ModifierGraph::OP_POST_PERCENT;
+        modifier.penalized = false;
+
+        mGraph.AddModifier( modifier );
+    }
+
+    // ... which multiplies the damage of the weapons
+    for( uint32 m = 0; m < FLEET_BENCHMARK_MODULES; ++m )
+    {
+        const uint32 moduleID = _GetModuleID( m );
+        if( _IsHardener( m ) )
+        {
+            mGraph.SetBaseValue( moduleID, FLEET_ATTR_DURATION, 10000.0 );
+            mGraph.SetBaseValue( moduleID, FLEET_ATTR_CAPACITOR_NEED, 20.0 );
+            mGraph.SetBaseValue( moduleID, FLEET_ATTR_RESISTANCE_BONUS, -30.0 );
+            continue;
+        }
+
+        mGraph.SetBaseValue( moduleID, FLEET_ATTR_DURATION, 4000.0 );
+        mGraph.SetBaseValue( moduleID, FLEET_ATTR_CAPACITOR_NEED, 5.0 );
+        for( uint32 i = 0; i < 4; ++i )
+        {
+            mGraph.SetBaseValue( moduleID, FLEET_ATTR_DAMAGE + i, FLEET_WEAPON_DAMAGE[ i ] );
+
+            ModifierGraph::Modifier modifier;
+            modifier.sourceItemID = mItemID;
+            modifier.sourceAttributeID = FLEET_ATTR_DAMAGE_MULTIPLIER;
+            modifier.value = 0.0;
+            modifier.effectID = FLEET_WEAPON_EFFECT;
+            modifier.targetItemID = moduleID;
+            modifier.targetAttributeID = FLEET_ATTR_DAMAGE + i;
+            modifier.operation = ModifierGraph::OP_POST_MULTIPLY;
+            modifier.penalized = false;
+
+            mGraph.AddModifier( modifier );
+        }
+    }
+}
+
+void FleetShip::_StartCycle( FleetModule& module )
+{
+    const uint32 now = mScenario.now();
+    const uint32 moduleID = _GetModuleID( module.index );
+
+    // the capacitor is consumed and the weapon fires at the start of the cycle
+    mCapacitor.SetValue( mCapacitor.GetValue( now ) - _GetValue( moduleID, FLEET_ATTR_CAPACITOR_NEED ), now );
+    if( !_IsHardener( module.index ) )
+        mScenario.QueueHit( mTarget, mDamage[ module.index ] );
+
+    mScenario.cycleWheel().Schedule( &module, (uint32)_GetValue( moduleID, FLEET_ATTR_DURATION ) );
+}
+
+void FleetShip::_StopModule( FleetModule& module )
+{
+    mScenario.cycleWheel().Cancel( &module );
+    module.active = false;
+    module.stop = false;
+
+    if( _IsHardener( module.index ) )
+    {
+        mGraph.RemoveModifiers( _GetModuleID( module.index ), FLEET_HARDENER_EFFECT );
+        mDirty = true;
+    }
+}
+
+void FleetShip::_DropTarget()
+{
+    mScenario.lockWheel().Cancel( &mLockTimer );
+    mTarget = NULL;
+    mLocked = false;
+}
+
+void FleetShip::_LockExpired()
+{
+    ++mScenario.locks;
+    mLocked = ( mTarget->life() == mTargetLife );
+    if( !mLocked )
+        mTarget = NULL;
+}
+
+double FleetShip::_GetValue( uint32 itemID, uint32 attributeID )
+{
+    double value = 0.0;
+    mGraph.GetValue( itemID, attributeID, value );
+    return value;
+}
+
+double FleetShip::_ApplyLayer( const double damage[ 4 ], const double resonances[ 4 ], double ratio )
+{
+    double total = 0.0;
+    for( uint32 i = 0; i < 4; ++i )
+        total += damage[ i ] * resonances[ i ];
+    return total * ratio;
+}
+
+FleetScenario::FleetScenario( uint32 shipCount )
+: activations( 0 ),
+  locks( 0 ),
+  cycles( 0 ),
+  hits( 0 ),
+  kills( 0 ),
+  mNow( 0 ),
+  mLockWheel( 0 ),
+  mCycleWheel( 0 )
+{
+    for( uint32 s = 0; s < shipCount; ++s )
+        mShips.push_back( new FleetShip( *this, s ) );
+}
+
+FleetScenario::~FleetScenario()
+{
+    for( size_t s = 0; s < mShips.size(); ++s )
+        delete mShips[ s ];
+}
+
+void FleetScenario::QueueToggle( FleetShip* ship, uint32 m, bool on )
+{
+    Toggle toggle;
+    toggle.ship = ship;
+    toggle.module = m;
+    toggle.on = on;
+
+    mToggles.push_back( toggle );
+}
+
+void FleetScenario::QueueLock( FleetShip* ship, FleetShip* target, uint32 delay )
+{
+    Lock lock;
+    lock.ship = ship;
+    lock.target = target;
+    lock.delay = delay;
+
+    mLocks.push_back( lock );
+}
+
+void FleetScenario::QueueHit( FleetShip* target, const double damage[ 4 ] )
+{
+    Hit hit;
+    hit.target = target;
+    for( uint32 i = 0; i < 4; ++i )
+        hit.damage[ i ] = damage[ i ];
+
+    mHits.push_back( hit );
+}
+
+void FleetScenario::RunTic( FleetRandom& rnd )
+{
+    mNow += FLEET_BENCHMARK_TIC;
+
+    // the script itself is not timed
+    for( size_t s = 0; s < mShips.size(); ++s )
+        mShips[ s ]->Script( rnd );
+
+    uint64 start = GetTimeUSeconds(), end;
+
+    for( size_t i = 0; i < mToggles.size(); ++i )
+    {
+        if( mToggles[ i ].on )
+            mToggles[ i ].ship->Activate( mToggles[ i ].module );
+        else
+            mToggles[ i ].ship->Deactivate( mToggles[ i ].module );
+    }
+    mToggles.clear();
+
+    end = GetTimeUSeconds();
+    times[ FLEET_ACTIVATION ].push_back( end - start );
+    start = end;
+
+    for( size_t i = 0; i < mLocks.size(); ++i )
+        mLocks[ i ].ship->StartLock( mLocks[ i ].target, mLocks[ i ].delay );
+    mLocks.clear();
+    mLockWheel.Process( mNow );
+
+    end = GetTimeUSeconds();
+    times[ FLEET_TARGETING ].push_back( end - start );
+    start = end;
+
+    mCycleWheel.Process( mNow );
+
+    end = GetTimeUSeconds();
+    times[ FLEET_CYCLES ].push_back( end - start );
+    start = end;
+
+    // the kills are resolved after all the hits
+    for( size_t i = 0; i < mHits.size(); ++i )
+    {
+        FleetShip* target = mHits[ i ].target;
+        if( target->ApplyHit( mHits[ i ].damage )
+            && mKilled.end() == std::find( mKilled.begin(), mKilled.end(), target ) )
+            mKilled.push_back( target );
+    }
+    hits += mHits.size();
+    mHits.clear();
+
+    for( size_t i = 0; i < mKilled.size(); ++i )
+        mKilled[ i ]->Respawn();
+    kills += mKilled.size();
+    mKilled.clear();
+
+    end = GetTimeUSeconds();
+    times[ FLEET_DAMAGE ].push_back( end - start );
+    start = end;
+
+    for( size_t s = 0; s < mShips.size(); ++s )
+        if( mShips[ s ]->dirty() )
+            mShips[ s ]->UpdateModifiers();
+
+    end = GetTimeUSeconds();
+    times[ FLEET_MODIFIERS ].push_back( end - start );
+}
+
+static uint64 Percentile( const std::vector< uint64 >& sorted, uint32 percent )
+{
+    return sorted[ ( sorted.size() - 1 ) * percent / 100 ];
+}
+
+int utils_FleetScenarioBenchmark( int argc, char* argv[] )
+{
+    uint32 shipCount = FLEET_BENCHMARK_SHIPS;
+    if( 1 < argc )
+        shipCount = ::strtoul( argv[1], NULL, 10 );
+    uint32 tics = FLEET_BENCHMARK_TICS;
+    if( 2 < argc )
+        tics = ::strtoul( argv[2], NULL, 10 );
+
+    if( 2 > shipCount || 0 == tics )
+    {
+        ::puts( "The fight needs at least 2 ships and 1 tic." );
+        return EXIT_FAILURE;
+    }
+
+    FleetScenario scenario( shipCount );
+    FleetRandom rnd;
+    for( uint32 t = 0; t < tics; ++t )
+        scenario.RunTic( rnd );
+
+    ::printf( "%u ships, %u tics: %u activations, %u locks, %u cycles, %u hits, %u kills.\n",
+              shipCount, tics, scenario.activations, scenario.locks, scenario.cycles, scenario.hits, scenario.kills );
+    ::printf( "  %-12s %10s %10s %10s %10s\n", "us/tic", "p50", "p90", "p99", "max" );
+    for( int s = 0; s < FLEET_SUBSYSTEM_COUNT; ++s )
+    {
+        std::vector< uint64 > sorted( scenario.times[ s ] );
+        std::sort( sorted.begin(), sorted.end() );
+
+        ::printf( "  %-12s %10llu %10llu %10llu %10llu\n", FLEET_SUBSYSTEM_NAMES[ s ],
+                  (unsigned long long)Percentile( sorted, 50 ), (unsigned long long)Percentile( sorted, 90 ),
+                  (unsigned long long)Percentile( sorted, 99 ), (unsigned long long)sorted.back() );
+    }
+
+    // each of the subsystems has to have done something
+    if( 0 == scenario.activations || 0 == scenario.locks || 0 == scenario.hits || 0 == scenario.kills )
+    {
+        ::puts( "The fleet did not fight." );
+        return EXIT_FAILURE;
+    }
+
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,107 @@
+/*
+    ------------------------------------------------------------------------------------
+    LICENSE:
+    ------------------------------------------------------------------------------------
+    This file is part of EVEmu: EVE Online Server Emulator
+    Copyright 2006 - 2011 The EVEmu Team
+    For the latest information visit http://evemu.org
+    ------------------------------------------------------------------------------------
+    This program is free software; you can redistribute it and/or modify it under
+    the terms of the GNU Lesser General Public License as published by the Free Software
+    Foundation; either version 2 of the License, or (at your option) any later
+    version.
+
+    This program is distributed in the hope that it will be useful, but WITHOUT
+    ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+    FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public License along with
+    this program; if not, write to the Free Software Foundation, Inc., 59 Temple
+    Place - Suite 330, Boston, MA 02111-1307, USA, or go to
+    http://www.gnu.org/copyleft/lesser.txt.
+    ------------------------------------------------------------------------------------
+    Author:     EVEmu Team
+*/
+
+#include "eve-test.h"
+
+/**
+ * @brief Writes a file.
+ *
+ * @return True on success, false on failure.
+ */
+static bool WriteFile( const char* filename, const Buffer& data )
+{
+    FILE* f = ::fopen( filename, "wb" );
+    if( NULL == f )
+        return false;
+
+    const bool res = ( 0 == data.size()
+                       || data.size() == ::fwrite( &data[0], 1, data.size(), f ) );
+    return 0 == ::fclose( f ) && res;
+}
+
+int utils_MappedFileTest( int argc, char* argv[] )
+{
+    const char* filename = "MappedFileTest.tmp";
+    const char* tempname = "MappedFileTest.tmp.new";
+
+    Buffer data;
+    for( size_t i = 0; i < 0x5000; ++i )
+        data.Append<uint8>( ( i * 7 ) % 251 );
+
+    if( !WriteFile( filename, data ) )
+    {
+        ::printf( "Failed to write '%s'.\n", filename );
+        return EXIT_FAILURE;
+    }
+
+    Buffer* view = NULL;
+    {
+        RefPtr<MappedFile> file = MappedFile::Open( filename );
+        if( !file || data.size() != file->size() )
+        {
+            ::printf( "Failed to map '%s'.\n", filename );
+            ::remove( filename );
+            return EXIT_FAILURE;
+        }
+
+        // the view keeps the mapping alive on its own
+        view = new Buffer( file->data() + 16, file->size() - 16, file );
+    }
+
+    // replacing the file leaves the mapping alone
+    Buffer other( data.size(), 0xAA );
+    const bool replaced = WriteFile( tempname, other ) && 0 == ::rename( tempname, filename );
+
+    const bool same = ( data.size() - 16 == view->size()
+                        && 0 == memcmp( &data[16], &( *view )[0], view->size() ) );
+
+    // copies own their memory
+    Buffer copy( *view );
+    SafeDelete( view );
+
+    const bool copied = ( data.size() - 16 == copy.size()
+                          && 0 == memcmp( &data[16], &copy[0], copy.size() ) );
+
+    ::remove( filename );
+    ::remove( tempname );
+
+    if( !replaced || !same || !copied )
+    {
+        ::printf( "Mapped data differ from the file (replaced %d, same %d, copied %d).\n", replaced, same, copied );
+        return EXIT_FAILURE;
+    }
+
+    Buffer empty;
+    if( !WriteFile( filename, empty ) || MappedFile::Open( filename ) )
+    {
+        ::printf( "Mapped an empty file.\n" );
+        ::remove( filename );
+        return EXIT_FAILURE;
+    }
+    ::remove( filename );
+
+    ::puts( "MappedFile OK." );
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,156 @@
+/*
+    ------------------------------------------------------------------------------------
+    LICENSE:
+    ------------------------------------------------------------------------------------
+    This file is part of EVEmu: EVE Online Server Emulator
+    Copyright 2006 - 2011 The EVEmu Team
+    For the latest information visit http://evemu.org
+    ------------------------------------------------------------------------------------
+    This program is free software; you can redistribute it and/or modify it under
+    the terms of the GNU Lesser General Public License as published by the Free Software
+    Foundation; either version 2 of the License, or (at your option) any later
+    version.
+
+    This program is distributed in the hope that it will be useful, but WITHOUT
+    ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+    FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public License along with
+    this program; if not, write to the Free Software Foundation, Inc., 59 Temple
+    Place - Suite 330, Boston, MA 02111-1307, USA, or go to
+    http://www.gnu.org/copyleft/lesser.txt.
+    ------------------------------------------------------------------------------------
+    Author:     EVEmu Team
+*/
+
+
+
+#include "eve-test.h"
+
+/*
+ * Verifies that MemoryTag accounts tagged objects by their dynamic
+ * size, the memory retained besides them and the nodes of a tagged
+ * container, and that sampled allocations are grouped by their call
+ * stack until they are freed.
+ */
+
+class TaggedObject
+{
+public:
+    TaggedObject() : value( 42 ) {}
+    virtual ~TaggedObject() {}
+
+    static void* operator new( size_t size ) { return sMemoryTag.Allocate( size ); }
+    static void operator delete( void* p, size_t size ) { sMemoryTag.Free( p, size ); }
+    static MemoryTag sMemoryTag;
+
+    uint64 value;
+};
+
+MemoryTag TaggedObject::sMemoryTag( "test" );
+
+class DerivedTaggedObject
+: public TaggedObject
+{
+public:
+    uint64 extra[4];
+};
+
+static bool ExpectLive( int64 bytes, int64 objects, const char* when )
+{
+    const MemoryTag::Stats stats = TaggedObject::sMemoryTag.GetStats();
+    if( bytes == stats.liveBytes && objects == stats.liveObjects )
+        return true;
+
+    ::printf( "%s: %" PRId64 " bytes in %" PRId64 " objects live, expected %" PRId64 " in %" PRId64 ".\n",
+              when, stats.liveBytes, stats.liveObjects, bytes, objects );
+    return false;
+}
+
+int utils_MemoryTagTest( int argc, char* argv[] )
+{
+    if( &TaggedObject::sMemoryTag != MemoryTag::Find( "test" ) )
+    {
+        ::puts( "The tag is not registered." );
+        return EXIT_FAILURE;
+    }
+
+    const int64 base = sizeof( TaggedObject );
+    const int64 derived = sizeof( DerivedTaggedObject );
+
+    TaggedObject* object = new TaggedObject;
+    TaggedObject* bigger = new DerivedTaggedObject;
+    if( !ExpectLive( base + derived, 2, "Allocated" ) )
+        return EXIT_FAILURE;
+
+    // the derived object is freed through the base
+    delete bigger;
+    if( !ExpectLive( base, 1, "Freed the derived object" ) )
+        return EXIT_FAILURE;
+
+    TaggedObject::sMemoryTag.Retain( 1000 );
+    if( !ExpectLive( base + 1000, 2, "Retained" ) )
+        return EXIT_FAILURE;
+    TaggedObject::sMemoryTag.Release( 1000 );
+
+    {
+        std::map< uint32, uint32, std::less< uint32 >,
+                  MemoryTagAllocator< std::pair< const uint32, uint32 >, TaggedObject::sMemoryTag > > tagged;
+        for( uint32 i = 0; i < 10; ++i )
+            tagged[ i ] = i;
+
+        if( base + 10 >= TaggedObject::sMemoryTag.GetStats().liveBytes
+            || 11 != TaggedObject::sMemoryTag.GetStats().liveObjects )
+        {
+            ::puts( "The nodes of the container are not accounted." );
+            return EXIT_FAILURE;
+        }
+    }
+    if( !ExpectLive( base, 1, "Destroyed the container" ) )
+        return EXIT_FAILURE;
+
+    // sample every allocation
+    MemoryTag::SetSampleRate( 1 );
+    std::vector< TaggedObject* > sampled;
+    for( size_t i = 0; i < 3; ++i )
+        sampled.push_back( new TaggedObject );
+    MemoryTag::SetSampleRate( 0 );
+
+    std::vector< MemoryTag::Sample > samples;
+    MemoryTag::DumpSamples( samples );
+
+    size_t count = 0, bytes = 0;
+    for( size_t i = 0; i < samples.size(); ++i )
+    {
+        if( &TaggedObject::sMemoryTag != samples[ i ].tag || samples[ i ].frames.empty() )
+        {
+            ::puts( "A sample lacks its tag or call stack." );
+            return EXIT_FAILURE;
+        }
+
+        count += samples[ i ].count;
+        bytes += samples[ i ].bytes;
+    }
+    if( 3 != count || 3 * sizeof( TaggedObject ) != bytes )
+    {
+        ::printf( "Sampled %lu allocations of %lu bytes, expected 3.\n", (unsigned long)count, (unsigned long)bytes );
+        return EXIT_FAILURE;
+    }
+
+    // freed allocations are forgotten
+    for( size_t i = 0; i < sampled.size(); ++i )
+        delete sampled[ i ];
+    samples.clear();
+    MemoryTag::DumpSamples( samples );
+    if( !samples.empty() )
+    {
+        ::puts( "Freed allocations are still sampled." );
+        return EXIT_FAILURE;
+    }
+
+    delete object;
+    if( !ExpectLive( 0, 0, "Freed everything" ) )
+        return EXIT_FAILURE;
+
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,84 @@
+/*
+    ------------------------------------------------------------------------------------
+    LICENSE:
+    ------------------------------------------------------------------------------------
+    This file is part of EVEmu: EVE Online Server Emulator
+    Copyright 2006 - 2011 The EVEmu Team
+    For the latest information visit http://evemu.org
+    ------------------------------------------------------------------------------------
+    This program is free software; you can redistribute it and/or modify it under
+    the terms of the GNU Lesser General Public License as published by the Free Software
+    Foundation; either version 2 of the License, or (at your option) any later
+    version.
+
+    This program is distributed in the hope that it will be useful, but WITHOUT
+    ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+    FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public License along with
+    this program; if not, write to the Free Software Foundation, Inc., 59 Temple
+    Place - Suite 330, Boston, MA 02111-1307, USA, or go to
+    http://www.gnu.org/copyleft/lesser.txt.
+    ------------------------------------------------------------------------------------
+    Author:     EVEmu Team
+*/
+
+
+#include "eve-test.h"
+
+static bool Expect( const std::string& text, const char* line )
+{
+    if( std::string::npos != text.find( std::string( line ) + "\n" ) )
+        return true;
+
+    ::printf( "Missing line '%s' in:\n%s", line, text.c_str() );
+    return false;
+}
+
+int utils_MetricsTest( int argc, char* argv[] )
+{
+    MetricRegistry registry;
+
+    MetricCounter& counter = registry.Counter( "test_events_total", "Events." );
+    counter.Add();
+    counter.Add( 41 );
+    // the same name and labels give the same metric
+    if( &counter != &registry.Counter( "test_events_total", "Events." ) )
+    {
+        ::puts( "A counter was registered twice." );
+        return EXIT_FAILURE;
+    }
+    registry.Counter( "test_events_total", "Events.", "kind=\"other\"" ).Add( 3 );
+
+    MetricGauge& gauge = registry.Gauge( "test_level", "Level." );
+    gauge.Set( 10 );
+    gauge.Add( -15 );
+
+    std::vector< uint64 > bounds;
+    bounds.push_back( 10 );
+    bounds.push_back( 100 );
+    MetricHistogram& histogram = registry.Histogram( "test_size", "Sizes.", bounds, 10.0 );
+    histogram.Observe( 5 );
+    histogram.Observe( 10 );
+    histogram.Observe( 50 );
+    histogram.Observe( 1000 );
+
+    std::string text;
+    registry.Render( text );
+
+    if( !Expect( text, "# TYPE test_events_total counter" )
+        || !Expect( text, "test_events_total 42" )
+        || !Expect( text, "test_events_total{kind=\"other\"} 3" )
+        || !Expect( text, "# TYPE test_level gauge" )
+        || !Expect( text, "test_level -5" )
+        || !Expect( text, "# TYPE test_size histogram" )
+        || !Expect( text, "test_size_bucket{le=\"1\"} 2" )
+        || !Expect( text, "test_size_bucket{le=\"10\"} 3" )
+        || !Expect( text, "test_size_bucket{le=\"+Inf\"} 4" )
+        || !Expect( text, "test_size_sum 106.5" )
+        || !Expect( text, "test_size_count 4" ) )
+        return EXIT_FAILURE;
+
+    ::puts( "Metrics OK." );
+    return EXIT_SUCCESS;
+}
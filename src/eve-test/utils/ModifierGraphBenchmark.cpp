@@ -0,0 +1,644 @@
+/*
+    ------------------------------------------------------------------------------------
+    LICENSE:
+    ------------------------------------------------------------------------------------
+    This file is part of EVEmu: EVE Online Server Emulator
+    Copyright 2006 - 2011 The EVEmu Team
+    For the latest information visit http://evemu.org
+    ------------------------------------------------------------------------------------
+    This program is free software; you can redistribute it and/or modify it under
+    the terms of the GNU Lesser General Public License as published by the Free Software
+    Foundation; either version 2 of the License, or (at your option) any later
+    version.
+
+    This program is distributed in the hope that it will be useful, but WITHOUT
+    ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+    FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public License along with
+    this program; if not, write to the Free Software Foundation, Inc., 59 Temple
+    Place - Suite 330, Boston, MA 02111-1307, USA, or go to
+    http://www.gnu.org/copyleft/lesser.txt.
+    ------------------------------------------------------------------------------------
+    Author:     EVEmu Team
+*/
+
+#include "eve-test.h"
+
+/* Checks ModifierGraph against recomputing every modified attribute
+ * from per-attribute multimaps, the way the ModuleManager modifier maps
+ * were meant to be walked, and measures fitting, onlining and overloading
+ * a module with both of them on a fully fitted and skilled ship.
+ *
+ * The optional first argument is time (in milliseconds) spent on each
+ * measurement; the default is MODIFIER_BENCHMARK_TIME.
+ */
+
+/** Default time (in milliseconds) spent on a single measurement. */
+static const uint32 MODIFIER_BENCHMARK_TIME = 200;
+/** Number of modified attributes of the ship. */
+static const uint32 MODIFIER_BENCHMARK_SHIP_ATTRIBUTES = 60;
+/** Number of trained skills modifying the ship. */
+static const uint32 MODIFIER_BENCHMARK_SKILLS = 120;
+/** Number of fitted modules. */
+static const uint32 MODIFIER_BENCHMARK_MODULES = 27;
+/** Number of attributes of a module. */
+static const uint32 MODIFIER_BENCHMARK_MODULE_ATTRIBUTES = 6;
+/** Number of ship attributes a module modifies when online. */
+static const uint32 MODIFIER_BENCHMARK_MODULE_MODIFIERS = 3;
+
+static const uint32 MODIFIER_BENCHMARK_SHIP_ID = 1;
+static const uint32 MODIFIER_BENCHMARK_FIRST_SKILL_ID = 100;
+static const uint32 MODIFIER_BENCHMARK_FIRST_MODULE_ID = 1000;
+static const uint32 MODIFIER_BENCHMARK_SKILL_EFFECT = 132;
+static const uint32 MODIFIER_BENCHMARK_ONLINE_EFFECT = 16;
+static const uint32 MODIFIER_BENCHMARK_OVERLOAD_EFFECT = 3001;
+
+/* Deterministic generator, so the runs are comparable. */
+class ModifierRandom
+{
+public:
+    ModifierRandom() : mState( 0x2545F491 ) {}
+
+    uint32 Next() { return ( mState = mState * 1664525 + 1013904223 ) >> 8; }
+    uint32 Next( uint32 max ) { return Next() % max; }
+
+protected:
+    uint32 mState;
+};
+
+/* The modifiers of the ship, its skills and its modules. */
+struct ModifierFitting
+{
+    std::vector< ModifierGraph::Modifier > skills;
+    /// MODIFIER_BENCHMARK_MODULE_MODIFIERS of each module.
+    std::vector< ModifierGraph::Modifier > online;
+    /// One of each module.
+    std::vector< ModifierGraph::Modifier > overload;
+
+    std::vector< double > shipBase;
+    std::vector< double > moduleBase;
+};
+
+static void BuildFitting( ModifierFitting& fitting )
+{
+    ModifierRandom rnd;
+
+    for( uint32 a = 0; a < MODIFIER_BENCHMARK_SHIP_ATTRIBUTES; ++a )
+        fitting.shipBase.push_back( 1 + rnd.Next( 5000 ) );
+    for( uint32 m = 0; m < MODIFIER_BENCHMARK_MODULES; ++m )
+        for( uint32 a = 0; a < MODIFIER_BENCHMARK_MODULE_ATTRIBUTES; ++a )
+            fitting.moduleBase.push_back( 1 + rnd.Next( 20 ) );
+
+    // skills add a few percent each, never penalized
+    for( uint32 s = 0; s < MODIFIER_BENCHMARK_SKILLS; ++s )
+    {
+        ModifierGraph::Modifier modifier;
+        modifier.sourceItemID = MODIFIER_BENCHMARK_FIRST_SKILL_ID + s;
+        modifier.sourceAttributeID = 0;
+        modifier.value = 2.0 * ( 1 + rnd.Next( 5 ) );
+        modifier.effectID = MODIFIER_BENCHMARK_SKILL_EFFECT;
+        modifier.targetItemID = MODIFIER_BENCHMARK_SHIP_ID;
+        modifier.targetAttributeID = 1 + rnd.Next( MODIFIER_BENCHMARK_SHIP_ATTRIBUTES );
+        modifier.operation = ( 0 == rnd.Next( 4 ) ? ModifierGraph::OP_ADD : ModifierGraph::OP_POST_PERCENT );
+        modifier.penalized = false;
+
+        fitting.skills.push_back( modifier );
+    }
+
+    // modules mostly stack on the same few attributes
+    for( uint32 m = 0; m < MODIFIER_BENCHMARK_MODULES; ++m )
+    {
+        const uint32 moduleID = MODIFIER_BENCHMARK_FIRST_MODULE_ID + m;
+        const uint32 group = rnd.Next( 6 );
+
+        for( uint32 i = 0; i < MODIFIER_BENCHMARK_MODULE_MODIFIERS; ++i )
+        {
+            ModifierGraph::Modifier modifier;
+            modifier.sourceItemID = moduleID;
+            modifier.sourceAttributeID = 1 + i;
+            modifier.value = 0.0;
+            modifier.effectID = MODIFIER_BENCHMARK_ONLINE_EFFECT;
+            modifier.targetItemID = MODIFIER_BENCHMARK_SHIP_ID;
+            modifier.targetAttributeID = 1 + ( 0 == rnd.Next( 3 ) ? rnd.Next( MODIFIER_BENCHMARK_SHIP_ATTRIBUTES ) : group * 3 + i );
+            modifier.operation = ModifierGraph::OP_POST_PERCENT;
+            modifier.penalized = ( 0 != rnd.Next( 4 ) );
+
+            fitting.online.push_back( modifier );
+        }
+
+        // overheating boosts the module, and so its modifiers of the ship
+        ModifierGraph::Modifier modifier;
+        modifier.sourceItemID = moduleID;
+        modifier.sourceAttributeID = 0;
+        modifier.value = 15.0;
+        modifier.effectID = MODIFIER_BENCHMARK_OVERLOAD_EFFECT;
+        modifier.targetItemID = moduleID;
+        modifier.targetAttributeID = 1 + rnd.Next( MODIFIER_BENCHMARK_MODULE_MODIFIERS );
+        modifier.operation = ModifierGraph::OP_POST_PERCENT;
+        modifier.penalized = false;
+
+        fitting.overload.push_back( modifier );
+    }
+}
+
+/* The per-attribute multimaps, walked all over on every change. */
+struct ReferenceModified
+{
+    uint32 itemID;
+    double base;
+    double value;
+    /// Key= modifier value when added, like the ModifierMapType used to be.
+    std::multimap< double, ModifierGraph::Modifier > modifiers;
+};
+typedef std::map< uint64, ReferenceModified > ReferenceModifierMap;
+
+static uint64 ReferenceKey( uint32 itemID, uint32 attributeID )
+{
+    return ( (uint64)itemID << 32 ) | attributeID;
+}
+
+static void ReferenceSetBase( ReferenceModifierMap& map, uint32 itemID, uint32 attributeID, double value )
+{
+    ReferenceModified& attr = map[ ReferenceKey( itemID, attributeID ) ];
+    attr.itemID = itemID;
+    attr.base = attr.value = value;
+}
+
+static void ReferenceAdd( ReferenceModifierMap& map, const ModifierGraph::Modifier& modifier )
+{
+    map[ ReferenceKey( modifier.targetItemID, modifier.targetAttributeID ) ].modifiers.insert( std::make_pair( modifier.value, modifier ) );
+}
+
+static void ReferenceRemove( ReferenceModifierMap& map, const ModifierGraph::Modifier& modifier )
+{
+    ReferenceModified& attr = map[ ReferenceKey( modifier.targetItemID, modifier.targetAttributeID ) ];
+
+    std::multimap< double, ModifierGraph::Modifier >::iterator cur = attr.modifiers.begin();
+    for(; cur != attr.modifiers.end(); ++cur )
+    {
+        if( cur->second.sourceItemID == modifier.sourceItemID
+            && cur->second.sourceAttributeID == modifier.sourceAttributeID
+            && cur->second.effectID == modifier.effectID )
+        {
+            attr.modifiers.erase( cur );
+            return;
+        }
+    }
+}
+
+static void ReferenceRemoveItem( ReferenceModifierMap& map, uint32 itemID )
+{
+    ReferenceModifierMap::iterator cur = map.begin();
+    while( cur != map.end() )
+    {
+        if( cur->second.itemID == itemID )
+        {
+            map.erase( cur++ );
+            continue;
+        }
+
+        std::multimap< double, ModifierGraph::Modifier >::iterator m = cur->second.modifiers.begin();
+        while( m != cur->second.modifiers.end() )
+        {
+            if( m->second.sourceItemID == itemID )
+                cur->second.modifiers.erase( m++ );
+            else
+                ++m;
+        }
+        ++cur;
+    }
+}
+
+static double ReferencePenalized( std::vector< double >& factors )
+{
+    std::sort( factors.begin(), factors.end() );
+
+    double result = 1.0;
+    int stack = 0;
+    for( size_t i = 0; i < factors.size() && factors[ i ] < 1.0; ++i, ++stack )
+        result *= 1.0 + ( factors[ i ] - 1.0 ) * exp( -pow( (double)stack, 2 ) / 7.1289 );
+    stack = 0;
+    for( size_t i = factors.size(); 0 < i && factors[ i - 1 ] > 1.0; --i, ++stack )
+        result *= 1.0 + ( factors[ i - 1 ] - 1.0 ) * exp( -pow( (double)stack, 2 ) / 7.1289 );
+
+    return result;
+}
+
+static void ReferenceRecompute( ReferenceModifierMap& map, ReferenceModified& attr )
+{
+    double preMultiply = 1.0, add = 0.0, postMultiply = 1.0;
+    std::vector< double > prePenalized, postPenalized;
+
+    std::multimap< double, ModifierGraph::Modifier >::const_iterator cur = attr.modifiers.begin();
+    for(; cur != attr.modifiers.end(); ++cur )
+    {
+        const ModifierGraph::Modifier& modifier = cur->second;
+
+        double value = modifier.value;
+        if( 0 != modifier.sourceAttributeID )
+            value = map[ ReferenceKey( modifier.sourceItemID, modifier.sourceAttributeID ) ].value;
+
+        double factor = 1.0;
+        bool post = true;
+        switch( modifier.operation )
+        {
+            case ModifierGraph::OP_ADD:             add += value;                                   continue;
+            case ModifierGraph::OP_SUBTRACT:        add -= value;                                   continue;
+            case ModifierGraph::OP_PRE_MULTIPLY:    factor = value;                 post = false;   break;
+            case ModifierGraph::OP_POST_MULTIPLY:   factor = value;                                 break;
+            case ModifierGraph::OP_POST_PERCENT:    factor = 1.0 + value / 100.0;                   break;
+            default:                                                                                continue;
+        }
+
+        if( modifier.penalized )
+            ( post ? postPenalized : prePenalized ).push_back( factor );
+        else
+            ( post ? postMultiply : preMultiply ) *= factor;
+    }
+
+    attr.value = ( attr.base * preMultiply * ReferencePenalized( prePenalized ) + add )
+               * postMultiply * ReferencePenalized( postPenalized );
+}
+
+/* Recomputes the modules, then the ship they modify. */
+static void ReferenceRecomputeAll( ReferenceModifierMap& map )
+{
+    ReferenceModifierMap::iterator cur;
+    for( cur = map.begin(); cur != map.end(); ++cur )
+        if( MODIFIER_BENCHMARK_SHIP_ID != cur->second.itemID )
+            ReferenceRecompute( map, cur->second );
+    for( cur = map.begin(); cur != map.end(); ++cur )
+        if( MODIFIER_BENCHMARK_SHIP_ID == cur->second.itemID )
+            ReferenceRecompute( map, cur->second );
+}
+
+/* Both of them, and the state of the modules. */
+struct ModifierShip
+{
+    ModifierShip() : online( MODIFIER_BENCHMARK_MODULES, false ), overloaded( MODIFIER_BENCHMARK_MODULES, false ) {}
+
+    ReferenceModifierMap reference;
+    ModifierGraph graph;
+    std::vector< ModifierGraph::Change > changes;
+
+    std::vector< bool > online;
+    std::vector< bool > overloaded;
+};
+
+static void FitModule( const ModifierFitting& fitting, ModifierShip& ship, uint32 m, bool graph, bool reference )
+{
+    for( uint32 a = 0; a < MODIFIER_BENCHMARK_MODULE_ATTRIBUTES; ++a )
+    {
+        const double base = fitting.moduleBase[ m * MODIFIER_BENCHMARK_MODULE_ATTRIBUTES + a ];
+        if( graph )
+            ship.graph.SetBaseValue( MODIFIER_BENCHMARK_FIRST_MODULE_ID + m, 1 + a, base );
+        if( reference )
+            ReferenceSetBase( ship.reference, MODIFIER_BENCHMARK_FIRST_MODULE_ID + m, 1 + a, base );
+    }
+}
+
+static void SetOnline( const ModifierFitting& fitting, ModifierShip& ship, uint32 m, bool online, bool graph, bool reference )
+{
+    for( uint32 i = 0; i < MODIFIER_BENCHMARK_MODULE_MODIFIERS; ++i )
+    {
+        const ModifierGraph::Modifier& modifier = fitting.online[ m * MODIFIER_BENCHMARK_MODULE_MODIFIERS + i ];
+        if( graph )
+        {
+            if( online )
+                ship.graph.AddModifier( modifier );
+            else
+                ship.graph.RemoveModifier( modifier );
+        }
+        if( reference )
+        {
+            if( online )
+                ReferenceAdd( ship.reference, modifier );
+            else
+                ReferenceRemove( ship.reference, modifier );
+        }
+    }
+}
+
+static void SetOverloaded( const ModifierFitting& fitting, ModifierShip& ship, uint32 m, bool overloaded, bool graph, bool reference )
+{
+    const ModifierGraph::Modifier& modifier = fitting.overload[ m ];
+    if( graph )
+    {
+        if( overloaded )
+            ship.graph.AddModifier( modifier );
+        else
+            ship.graph.RemoveModifiers( modifier.sourceItemID, modifier.effectID );
+    }
+    if( reference )
+    {
+        if( overloaded )
+            ReferenceAdd( ship.reference, modifier );
+        else
+            ReferenceRemove( ship.reference, modifier );
+    }
+}
+
+static void Recompute( ModifierShip& ship, bool graph, bool reference )
+{
+    if( graph )
+    {
+        ship.changes.clear();
+        ship.graph.Update( ship.changes );
+    }
+    if( reference )
+        ReferenceRecomputeAll( ship.reference );
+}
+
+static void BuildShip( const ModifierFitting& fitting, ModifierShip& ship )
+{
+    for( uint32 a = 0; a < MODIFIER_BENCHMARK_SHIP_ATTRIBUTES; ++a )
+    {
+        ship.graph.SetBaseValue( MODIFIER_BENCHMARK_SHIP_ID, 1 + a, fitting.shipBase[ a ] );
+        ReferenceSetBase( ship.reference, MODIFIER_BENCHMARK_SHIP_ID, 1 + a, fitting.shipBase[ a ] );
+    }
+    for( size_t s = 0; s < fitting.skills.size(); ++s )
+    {
+        ship.graph.AddModifier( fitting.skills[ s ] );
+        ReferenceAdd( ship.reference, fitting.skills[ s ] );
+    }
+    for( uint32 m = 0; m < MODIFIER_BENCHMARK_MODULES; ++m )
+    {
+        FitModule( fitting, ship, m, true, true );
+        SetOnline( fitting, ship, m, true, true, true );
+        ship.online[ m ] = true;
+    }
+
+    Recompute( ship, true, true );
+}
+
+static bool Close( double a, double b )
+{
+    return fabs( a - b ) <= 1e-9 * std::max( fabs( a ), fabs( b ) );
+}
+
+static bool VerifyShip( ModifierShip& ship )
+{
+    ReferenceModifierMap::const_iterator cur = ship.reference.begin();
+    for(; cur != ship.reference.end(); ++cur )
+    {
+        const uint32 itemID = cur->second.itemID;
+        const uint32 attributeID = (uint32)cur->first;
+
+        double value;
+        if( !ship.graph.GetValue( itemID, attributeID, value ) || !Close( value, cur->second.value ) )
+        {
+            ::printf( "Attribute %u of item %u is %f instead of %f.\n", attributeID, itemID, value, cur->second.value );
+            return false;
+        }
+    }
+
+    return true;
+}
+
+static bool VerifyGraph()
+{
+    // stacking: the strongest is not penalized, the rest are
+    ModifierGraph graph;
+    graph.SetBaseValue( 1, 10, 100.0 );
+
+    ModifierGraph::Modifier modifier;
+    modifier.sourceAttributeID = 0;
+    modifier.effectID = 1;
+    modifier.targetItemID = 1;
+    modifier.targetAttributeID = 10;
+    modifier.operation = ModifierGraph::OP_POST_PERCENT;
+    modifier.penalized = true;
+    for( uint32 i = 0; i < 3; ++i )
+    {
+        modifier.sourceItemID = 2 + i;
+        modifier.value = 10.0 * ( 1 + i );
+        graph.AddModifier( modifier );
+    }
+
+    std::vector< ModifierGraph::Change > changes;
+    graph.Update( changes );
+
+    const double stacked = 100.0 * 1.3 * ( 1.0 + 0.2 * ModifierGraph::GetStackingPenalty( 1 ) )
+                                        * ( 1.0 + 0.1 * ModifierGraph::GetStackingPenalty( 2 ) );
+    if( 1 != changes.size() || !Close( changes[ 0 ].value, stacked ) )
+    {
+        ::puts( "Stacking penalties are not applied." );
+        return false;
+    }
+
+    // a chain: a skill boosts a module, which boosts the ship
+    modifier.sourceItemID = 5;
+    modifier.sourceAttributeID = 20;
+    modifier.targetItemID = 1;
+    modifier.targetAttributeID = 11;
+    modifier.operation = ModifierGraph::OP_ADD;
+    modifier.penalized = false;
+    graph.SetBaseValue( 1, 11, 1.0 );
+    graph.SetBaseValue( 5, 20, 4.0 );
+    graph.AddModifier( modifier );
+
+    modifier.sourceItemID = 6;
+    modifier.sourceAttributeID = 0;
+    modifier.value = 2.0;
+    modifier.targetItemID = 5;
+    modifier.targetAttributeID = 20;
+    modifier.operation = ModifierGraph::OP_POST_MULTIPLY;
+    graph.AddModifier( modifier );
+
+    changes.clear();
+    graph.ResetRecomputeCount();
+    graph.Update( changes );
+
+    double value = 0.0;
+    if( 2 != changes.size() || 2 != graph.GetRecomputeCount() || !graph.GetValue( 1, 11, value ) || 9.0 != value )
+    {
+        ::puts( "Chained modifiers are not recomputed." );
+        return false;
+    }
+
+    // only what is downstream is recomputed
+    graph.SetBaseValue( 5, 20, 5.0 );
+    changes.clear();
+    graph.ResetRecomputeCount();
+    graph.Update( changes );
+    if( 2 != graph.GetRecomputeCount() || !graph.GetValue( 1, 11, value ) || 11.0 != value || !graph.GetValue( 1, 10, value ) || !Close( value, stacked ) )
+    {
+        ::puts( "Attributes which are not downstream are recomputed." );
+        return false;
+    }
+
+    // removing takes the modifiers back out
+    if( 1 != graph.RemoveModifiers( 4, 1 ) )
+    {
+        ::puts( "Modifiers of an effect are not removed." );
+        return false;
+    }
+    graph.RemoveItem( 5 );
+    changes.clear();
+    graph.Update( changes );
+    if( graph.HasAttribute( 5, 20 ) || !graph.GetValue( 1, 11, value ) || 1.0 != value || !graph.GetValue( 1, 10, value )
+        || !Close( value, 100.0 * 1.2 * ( 1.0 + 0.1 * ModifierGraph::GetStackingPenalty( 1 ) ) ) )
+    {
+        ::puts( "Removed modifiers are still applied." );
+        return false;
+    }
+
+    return true;
+}
+
+enum ModifierOp
+{
+    OP_REFERENCE_FIT,
+    OP_FIT,
+    OP_REFERENCE_ONLINE,
+    OP_ONLINE,
+    OP_REFERENCE_OVERLOAD,
+    OP_OVERLOAD,
+
+    OP_COUNT
+};
+
+static const char* const MODIFIER_OP_NAMES[ OP_COUNT ] =
+{
+    "reference fit",
+    "fit",
+    "reference online",
+    "online",
+    "reference overload",
+    "overload"
+};
+
+/* Runs a single operation on a random module. */
+static void RunModifierOp( ModifierOp op, const ModifierFitting& fitting, ModifierShip& ship, ModifierRandom& rnd )
+{
+    const bool reference = ( 0 == op % 2 );
+    const bool graph = !reference;
+    const uint32 m = rnd.Next( MODIFIER_BENCHMARK_MODULES );
+
+    switch( op )
+    {
+        case OP_REFERENCE_FIT:
+        case OP_FIT:
+        {
+            // unfit and fit it again, online as it was
+            if( graph )
+                ship.graph.RemoveItem( MODIFIER_BENCHMARK_FIRST_MODULE_ID + m );
+            else
+                ReferenceRemoveItem( ship.reference, MODIFIER_BENCHMARK_FIRST_MODULE_ID + m );
+            Recompute( ship, graph, reference );
+
+            FitModule( fitting, ship, m, graph, reference );
+            if( ship.online[ m ] )
+                SetOnline( fitting, ship, m, true, graph, reference );
+            if( ship.overloaded[ m ] )
+                SetOverloaded( fitting, ship, m, true, graph, reference );
+        } break;
+        case OP_REFERENCE_ONLINE:
+        case OP_ONLINE:
+        {
+            SetOnline( fitting, ship, m, !ship.online[ m ], graph, reference );
+            ship.online[ m ] = !ship.online[ m ];
+        } break;
+        case OP_REFERENCE_OVERLOAD:
+        case OP_OVERLOAD:
+        {
+            SetOverloaded( fitting, ship, m, !ship.overloaded[ m ], graph, reference );
+            ship.overloaded[ m ] = !ship.overloaded[ m ];
+        } break;
+        default:
+            break;
+    }
+
+    Recompute( ship, graph, reference );
+}
+
+/* Returns the time of a single operation, in microseconds. */
+static double MeasureModifierOp( ModifierOp op, const ModifierFitting& fitting, uint32 timeMs )
+{
+    const uint64 limit = 1000 * (uint64)timeMs;
+
+    ModifierShip ship;
+    BuildShip( fitting, ship );
+
+    ModifierRandom rnd;
+    uint32 ops = 0;
+    uint64 time = 0;
+
+    const uint64 start = GetTimeUSeconds();
+    do
+    {
+        RunModifierOp( op, fitting, ship, rnd );
+
+        ++ops;
+        time = GetTimeUSeconds() - start;
+    } while( 10 > ops || limit > time );
+
+    return (double)time / ops;
+}
+
+/* Runs the same operations on both of them and compares the results. */
+static bool VerifyOps( const ModifierFitting& fitting )
+{
+    ModifierShip ship;
+    BuildShip( fitting, ship );
+    if( !VerifyShip( ship ) )
+        return false;
+
+    ModifierRandom rnd;
+    for( uint32 i = 0; i < 300; ++i )
+    {
+        const ModifierOp op = (ModifierOp)( 2 * rnd.Next( OP_COUNT / 2 ) );
+
+        // the same module and state for both
+        ModifierRandom same = rnd;
+        const std::vector< bool > online = ship.online, overloaded = ship.overloaded;
+        RunModifierOp( op, fitting, ship, rnd );
+
+        ship.online = online;
+        ship.overloaded = overloaded;
+        RunModifierOp( (ModifierOp)( op + 1 ), fitting, ship, same );
+
+        if( !VerifyShip( ship ) )
+        {
+            ::printf( "After %s %u.\n", MODIFIER_OP_NAMES[ op + 1 ], i );
+            return false;
+        }
+    }
+
+    return true;
+}
+
+int utils_ModifierGraphBenchmark( int argc, char* argv[] )
+{
+    uint32 timeMs = MODIFIER_BENCHMARK_TIME;
+    if( 1 < argc )
+        timeMs = ::strtoul( argv[1], NULL, 10 );
+
+    ModifierFitting fitting;
+    BuildFitting( fitting );
+
+    const bool verified = VerifyGraph() && VerifyOps( fitting );
+    if( verified )
+    {
+        {
+            ModifierShip ship;
+            BuildShip( fitting, ship );
+            ::printf( "%u attributes with %u modifiers.\n", ship.graph.GetAttributeCount(), ship.graph.GetModifierCount() );
+        }
+
+        double times[ OP_COUNT ];
+        for( int op = 0; op < OP_COUNT; ++op )
+        {
+            times[ op ] = MeasureModifierOp( (ModifierOp)op, fitting, timeMs );
+            ::printf( "  %-20s %12.2f us/op\n", MODIFIER_OP_NAMES[ op ], times[ op ] );
+        }
+
+        ::printf( "  speedup: fit %.2fx, online %.2fx, overload %.2fx\n",
+                  times[ OP_REFERENCE_FIT ] / times[ OP_FIT ],
+                  times[ OP_REFERENCE_ONLINE ] / times[ OP_ONLINE ],
+                  times[ OP_REFERENCE_OVERLOAD ] / times[ OP_OVERLOAD ] );
+    }
+
+    return verified ? EXIT_SUCCESS : EXIT_FAILURE;
+}
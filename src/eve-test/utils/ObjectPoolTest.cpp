@@ -0,0 +1,159 @@
+/*
+    ------------------------------------------------------------------------------------
+    LICENSE:
+    ------------------------------------------------------------------------------------
+    This file is part of EVEmu: EVE Online Server Emulator
+    Copyright 2006 - 2011 The EVEmu Team
+    For the latest information visit http://evemu.org
+    ------------------------------------------------------------------------------------
+    This program is free software; you can redistribute it and/or modify it under
+    the terms of the GNU Lesser General Public License as published by the Free Software
+    Foundation; either version 2 of the License, or (at your option) any later
+    version.
+
+    This program is distributed in the hope that it will be useful, but WITHOUT
+    ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+    FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public License along with
+    this program; if not, write to the Free Software Foundation, Inc., 59 Temple
+    Place - Suite 330, Boston, MA 02111-1307, USA, or go to
+    http://www.gnu.org/copyleft/lesser.txt.
+    ------------------------------------------------------------------------------------
+    Author:     EVEmu Team
+*/
+
+
+#include "eve-test.h"
+
+/*
+ * Verifies that ObjectPool recycles the objects of its class, sends
+ * derived classes and overflowing objects to the heap, counts it all,
+ * and poisons the objects in debug builds. Then compares a churn of
+ * PyPackets, as every call and notification makes, with the heap.
+ */
+
+static const uint32 CHURN_ROUNDS = 1000000;
+/// Objects alive at once during the churn.
+static const uint32 CHURN_LIVE = 64;
+
+class PooledObject
+{
+public:
+    PooledObject() : value( 42 ) {}
+    virtual ~PooledObject() {}
+
+    static void* operator new( size_t size ) { return ObjectPool< PooledObject >::Allocate( size ); }
+    static void operator delete( void* p, size_t size ) { ObjectPool< PooledObject >::Free( p, size ); }
+
+    uint64 value;
+};
+
+class DerivedObject
+: public PooledObject
+{
+public:
+    uint64 extra[4];
+};
+
+/* The same layout as PyPacket, without the pool. */
+class HeapPacket
+: public PyPacket
+{
+public:
+    static void* operator new( size_t size ) { return ::operator new( size ); }
+    static void operator delete( void* p ) { ::operator delete( p ); }
+};
+
+template< typename T >
+static uint64 Churn()
+{
+    T* live[ CHURN_LIVE ] = { NULL };
+
+    const uint64 start = GetTimeUSeconds();
+    for( uint32 i = 0; i < CHURN_ROUNDS; ++i )
+    {
+        // packets die out of order, like the calls they carry
+        T*& slot = live[ ( i * 2654435761U ) % CHURN_LIVE ];
+        delete slot;
+        slot = new T;
+    }
+    for( uint32 i = 0; i < CHURN_LIVE; ++i )
+        delete live[ i ];
+
+    return GetTimeUSeconds() - start;
+}
+
+int utils_ObjectPoolTest( int argc, char* argv[] )
+{
+    typedef ObjectPool< PooledObject > Pool;
+    Pool::ResetStats();
+
+    PooledObject* first = new PooledObject;
+    delete first;
+
+    // the freed object is handed out again
+    PooledObject* second = new PooledObject;
+    if( second != first || 42 != second->value )
+    {
+        ::printf( "Freed object was not recycled.\n" );
+        return EXIT_FAILURE;
+    }
+
+#ifndef NDEBUG
+    delete second;
+    // the memory after the link is poisoned
+    const uint8* freed = reinterpret_cast< const uint8* >( second ) + sizeof( void* );
+    for( size_t i = sizeof( void* ); i < sizeof( PooledObject ); ++i, ++freed )
+    {
+        if( Pool::FREED_FILL != *freed )
+        {
+            ::printf( "Freed object is not poisoned at byte %lu.\n", i );
+            return EXIT_FAILURE;
+        }
+    }
+    second = new PooledObject;
+#endif /* !NDEBUG */
+
+    // derived objects are bigger and go to the heap
+    PooledObject* derived = new DerivedObject;
+    delete derived;
+    delete second;
+
+    Pool::Stats stats = Pool::GetStats();
+#ifndef NDEBUG
+    const uint64 expected = 4;
+#else /* NDEBUG */
+    const uint64 expected = 3;
+#endif /* NDEBUG */
+    if( expected != stats.allocations || expected - 2 != stats.poolHits
+        || expected != stats.frees || expected - 1 != stats.poolReturns || 1 != stats.cached )
+    {
+        ::printf( "Unexpected stats: %" PRIu64 " allocations, %" PRIu64 " hits, %" PRIu64 " frees, %" PRIu64 " returns, %" PRIu64 " cached.\n",
+                  stats.allocations, stats.poolHits, stats.frees, stats.poolReturns, stats.cached );
+        return EXIT_FAILURE;
+    }
+
+    // the free list is capped
+    std::vector< PooledObject* > many;
+    for( size_t i = 0; i < Pool::MAX_CACHED + 10; ++i )
+        many.push_back( new PooledObject );
+    for( size_t i = 0; i < many.size(); ++i )
+        delete many[ i ];
+    if( Pool::MAX_CACHED != Pool::GetStats().cached )
+    {
+        ::printf( "Free list holds %" PRIu64 " objects, the cap is %lu.\n", Pool::GetStats().cached, Pool::MAX_CACHED );
+        return EXIT_FAILURE;
+    }
+
+    ObjectPool< PyPacket >::ResetStats();
+    const uint64 heapTime = Churn< HeapPacket >();
+    const uint64 poolTime = Churn< PyPacket >();
+
+    const ObjectPool< PyPacket >::Stats packetStats = ObjectPool< PyPacket >::GetStats();
+    ::printf( "PyPacket churn of %u: heap %" PRIu64 " us, pool %" PRIu64 " us (%.2fx), %.2f%% served by the pool.\n",
+              CHURN_ROUNDS, heapTime, poolTime, ( 0 < poolTime ? (double)heapTime / poolTime : 0.0 ),
+              100.0 * packetStats.poolHits / packetStats.allocations );
+
+    return EXIT_SUCCESS;
+}
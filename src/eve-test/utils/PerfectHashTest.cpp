@@ -0,0 +1,77 @@
+/*
+    ------------------------------------------------------------------------------------
+    LICENSE:
+    ------------------------------------------------------------------------------------
+    This file is part of EVEmu: EVE Online Server Emulator
+    Copyright 2006 - 2011 The EVEmu Team
+    For the latest information visit http://evemu.org
+    ------------------------------------------------------------------------------------
+    This program is free software; you can redistribute it and/or modify it under
+    the terms of the GNU Lesser General Public License as published by the Free Software
+    Foundation; either version 2 of the License, or (at your option) any later
+    version.
+
+    This program is distributed in the hope that it will be useful, but WITHOUT
+    ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+    FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public License along with
+    this program; if not, write to the Free Software Foundation, Inc., 59 Temple
+    Place - Suite 330, Boston, MA 02111-1307, USA, or go to
+    http://www.gnu.org/copyleft/lesser.txt.
+    ------------------------------------------------------------------------------------
+    Author:     EVEmu Team
+*/
+
+#include "eve-test.h"
+
+int utils_PerfectHashTest( int argc, char* argv[] )
+{
+    // names similar to what services register
+    std::vector<std::string> keys;
+    for( uint32 i = 0; i < 500; ++i )
+    {
+        char name[32];
+        snprintf( name, sizeof( name ), "GetCharacter%uInfo", i );
+        keys.push_back( name );
+    }
+    keys.push_back( "" );
+    keys.push_back( "a" );
+
+    PerfectHash hash;
+    if( !hash.Build( keys ) )
+    {
+        ::puts( "Failed to build the hash." );
+        return EXIT_FAILURE;
+    }
+
+    for( uint32 i = 0; i < keys.size(); ++i )
+    {
+        if( hash.Find( keys[ i ] ) != i )
+        {
+            ::printf( "Key '%s' not found at %u.\n", keys[ i ].c_str(), i );
+            return EXIT_FAILURE;
+        }
+    }
+
+    const char* const unknown[] = { "b", "GetCharacter500Info", "GetCharacterInfo", "getcharacter1info" };
+    for( size_t i = 0; i < sizeof( unknown ) / sizeof( unknown[0] ); ++i )
+    {
+        if( PerfectHash::INVALID_INDEX != hash.Find( unknown[ i ] ) )
+        {
+            ::printf( "Unknown key '%s' found.\n", unknown[ i ] );
+            return EXIT_FAILURE;
+        }
+    }
+
+    // duplicates must be refused
+    keys.push_back( "a" );
+    if( hash.Build( keys ) || PerfectHash::INVALID_INDEX != hash.Find( "a" ) )
+    {
+        ::puts( "Duplicate keys accepted." );
+        return EXIT_FAILURE;
+    }
+
+    ::puts( "Perfect hash OK." );
+    return EXIT_SUCCESS;
+}
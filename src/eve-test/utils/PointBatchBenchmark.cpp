@@ -0,0 +1,255 @@
+/*
+    ------------------------------------------------------------------------------------
+    LICENSE:
+    ------------------------------------------------------------------------------------
+    This file is part of EVEmu: EVE Online Server Emulator
+    Copyright 2006 - 2011 The EVEmu Team
+    For the latest information visit http://evemu.org
+    ------------------------------------------------------------------------------------
+    This program is free software; you can redistribute it and/or modify it under
+    the terms of the GNU Lesser General Public License as published by the Free Software
+    Foundation; either version 2 of the License, or (at your option) any later
+    version.
+
+    This program is distributed in the hope that it will be useful, but WITHOUT
+    ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+    FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public License along with
+    this program; if not, write to the Free Software Foundation, Inc., 59 Temple
+    Place - Suite 330, Boston, MA 02111-1307, USA, or go to
+    http://www.gnu.org/copyleft/lesser.txt.
+    ------------------------------------------------------------------------------------
+    Author:     EVEmu Team
+*/
+
+
+#include "eve-test.h"
+
+#include "utils/PointBatch.h"
+
+/* Checks PointBatch against GVector math and measures both of them
+ * on queries of one point against a system full of entities.
+ *
+ * The optional first argument is time (in milliseconds) spent on each
+ * measurement; the default is POINT_BATCH_BENCHMARK_TIME.
+ */
+
+/** Default time (in milliseconds) spent on a single measurement. */
+static const uint32 POINT_BATCH_BENCHMARK_TIME = 200;
+/** Number of points, about as many entities as a busy system has. */
+static const uint32 POINT_BATCH_BENCHMARK_POINTS = 4099;
+/** Half of the edge of the cube the points are in (in meters). */
+static const double POINT_BATCH_BENCHMARK_EXTENT = 1.0e6;
+/** Range of the queries (in meters). */
+static const double POINT_BATCH_BENCHMARK_RANGE = 2.5e5;
+/** Number of queries per measured operation. */
+static const uint32 POINT_BATCH_BENCHMARK_QUERIES = 64;
+
+/* Deterministic generator, so the runs are comparable. */
+class PointRandom
+{
+public:
+    PointRandom() : mState( 0x2545F491 ) {}
+
+    uint32 Next() { return ( mState = mState * 1664525 + 1013904223 ) >> 8; }
+    /* Returns a coordinate within the extent. */
+    double Coord() { return ( Next() / double( 1 << 24 ) * 2.0 - 1.0 ) * POINT_BATCH_BENCHMARK_EXTENT; }
+    GPoint Point() { const double x = Coord(), y = Coord(); return GPoint( x, y, Coord() ); }
+
+protected:
+    uint32 mState;
+};
+
+static bool VerifyBatch( const std::vector< GPoint >& points, const PointBatch& batch, const std::vector< GPoint >& queries )
+{
+    if( batch.size() != points.size() )
+    {
+        ::printf( "Batch has %lu points instead of %lu.\n", batch.size(), points.size() );
+        return false;
+    }
+
+    std::vector< double > distances( batch.size() );
+    std::vector< uint32 > found;
+    for( size_t q = 0; q < queries.size(); ++q )
+    {
+        batch.DistanceSquared( queries[ q ], &distances[ 0 ] );
+
+        found.clear();
+        const size_t count = batch.FindInRange( queries[ q ], POINT_BATCH_BENCHMARK_RANGE, found );
+        if( count != found.size() )
+        {
+            ::printf( "Query %lu reports %lu points instead of %lu.\n", q, count, found.size() );
+            return false;
+        }
+
+        size_t f = 0;
+        for( size_t i = 0; i < points.size(); ++i )
+        {
+            const double expected = GVector( queries[ q ], points[ i ] ).lengthSquared();
+            if( distances[ i ] != expected )
+            {
+                ::printf( "Distance of point %lu from query %lu is %f instead of %f.\n", i, q, distances[ i ], expected );
+                return false;
+            }
+
+            if( expected <= POINT_BATCH_BENCHMARK_RANGE * POINT_BATCH_BENCHMARK_RANGE )
+            {
+                if( f == found.size() || found[ f ] != i )
+                {
+                    ::printf( "Point %lu is not found in range of query %lu.\n", i, q );
+                    return false;
+                }
+                ++f;
+            }
+        }
+        if( f != found.size() )
+        {
+            ::printf( "Query %lu finds points out of range.\n", q );
+            return false;
+        }
+    }
+
+    // the boundary is inclusive, the appended indices keep the old ones
+    PointBatch edge;
+    edge.Add( GPoint( 3.0, 0.0, 0.0 ) );
+    edge.Add( GPoint( 0.0, 4.0, 0.0 ) );
+    edge.Add( GPoint( 0.0, 0.0, 5.0 ) );
+    found.assign( 1, 7 );
+    if( 2 != edge.FindInRange( GPoint( 0.0, 0.0, 0.0 ), 4.0, found )
+        || 3 != found.size() || 7 != found[ 0 ] || 0 != found[ 1 ] || 1 != found[ 2 ] )
+    {
+        ::puts( "Points at the range are not found." );
+        return false;
+    }
+
+    // removal keeps the order
+    edge.Remove( 0 );
+    if( 2 != edge.size() || 4.0 != edge.Get( 0 ).y || 5.0 != edge.Get( 1 ).z )
+    {
+        ::puts( "Removal reorders the points." );
+        return false;
+    }
+
+    return true;
+}
+
+enum PointBatchOp
+{
+    OP_REFERENCE_RANGE,
+    OP_RANGE,
+    OP_REFERENCE_DISTANCE,
+    OP_DISTANCE,
+
+    OP_COUNT
+};
+
+static const char* const POINT_BATCH_OP_NAMES[ OP_COUNT ] =
+{
+    "reference range",
+    "range",
+    "reference distance",
+    "distance"
+};
+
+/* Sums the results, so none of the work is optimized away. */
+static double g_pointBatchSink = 0.0;
+
+/* Returns the time of a single query, in nanoseconds. */
+static double MeasurePointBatchOp( PointBatchOp op, const std::vector< GPoint >& points, const PointBatch& batch,
+                                   const std::vector< GPoint >& queries, uint32 timeMs )
+{
+    const uint64 limit = 1000 * (uint64)timeMs;
+    const double range2 = POINT_BATCH_BENCHMARK_RANGE * POINT_BATCH_BENCHMARK_RANGE;
+
+    std::vector< uint32 > found;
+    found.reserve( points.size() );
+    std::vector< double > distances( points.size() );
+
+    uint32 ops = 0;
+    uint64 time = 0;
+    double sum = 0.0;
+
+    const uint64 start = GetTimeUSeconds();
+    do
+    {
+        for( size_t q = 0; q < queries.size(); ++q )
+        {
+            switch( op )
+            {
+                case OP_REFERENCE_RANGE:
+                {
+                    found.clear();
+                    for( size_t i = 0; i < points.size(); ++i )
+                        if( GVector( queries[ q ], points[ i ] ).lengthSquared() <= range2 )
+                            found.push_back( (uint32)i );
+                    sum += found.size();
+                } break;
+                case OP_RANGE:
+                {
+                    found.clear();
+                    sum += batch.FindInRange( queries[ q ], POINT_BATCH_BENCHMARK_RANGE, found );
+                } break;
+                case OP_REFERENCE_DISTANCE:
+                {
+                    for( size_t i = 0; i < points.size(); ++i )
+                        distances[ i ] = GVector( queries[ q ], points[ i ] ).lengthSquared();
+                    sum += distances[ q ];
+                } break;
+                case OP_DISTANCE:
+                {
+                    batch.DistanceSquared( queries[ q ], &distances[ 0 ] );
+                    sum += distances[ q ];
+                } break;
+                default:
+                    break;
+            }
+        }
+
+        ++ops;
+        time = GetTimeUSeconds() - start;
+    } while( 10 > ops || limit > time );
+
+    g_pointBatchSink += sum;
+    return 1000.0 * time / ( (double)ops * queries.size() );
+}
+
+int utils_PointBatchBenchmark( int argc, char* argv[] )
+{
+    uint32 timeMs = POINT_BATCH_BENCHMARK_TIME;
+    if( 1 < argc )
+        timeMs = ::strtoul( argv[1], NULL, 10 );
+
+    PointRandom rnd;
+
+    std::vector< GPoint > points;
+    PointBatch batch;
+    for( uint32 i = 0; i < POINT_BATCH_BENCHMARK_POINTS; ++i )
+    {
+        points.push_back( rnd.Point() );
+        batch.Add( points.back() );
+    }
+
+    std::vector< GPoint > queries;
+    for( uint32 i = 0; i < POINT_BATCH_BENCHMARK_QUERIES; ++i )
+        queries.push_back( rnd.Point() );
+
+    const bool verified = VerifyBatch( points, batch, queries );
+    if( verified )
+    {
+        ::printf( "%lu points, %lu queries.\n", points.size(), queries.size() );
+
+        double times[ OP_COUNT ];
+        for( int op = 0; op < OP_COUNT; ++op )
+        {
+            times[ op ] = MeasurePointBatchOp( (PointBatchOp)op, points, batch, queries, timeMs );
+            ::printf( "  %-20s %12.1f ns/query\n", POINT_BATCH_OP_NAMES[ op ], times[ op ] );
+        }
+
+        ::printf( "  speedup: range %.2fx, distance %.2fx\n",
+                  times[ OP_REFERENCE_RANGE ] / times[ OP_RANGE ],
+                  times[ OP_REFERENCE_DISTANCE ] / times[ OP_DISTANCE ] );
+    }
+
+    return verified ? EXIT_SUCCESS : EXIT_FAILURE;
+}
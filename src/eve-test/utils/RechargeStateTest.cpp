@@ -0,0 +1,119 @@
+/*
+    ------------------------------------------------------------------------------------
+    LICENSE:
+    ------------------------------------------------------------------------------------
+    This file is part of EVEmu: EVE Online Server Emulator
+    Copyright 2006 - 2011 The EVEmu Team
+    For the latest information visit http://evemu.org
+    ------------------------------------------------------------------------------------
+    This program is free software; you can redistribute it and/or modify it under
+    the terms of the GNU Lesser General Public License as published by the Free Software
+    Foundation; either version 2 of the License, or (at your option) any later
+    version.
+
+    This program is distributed in the hope that it will be useful, but WITHOUT
+    ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+    FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public License along with
+    this program; if not, write to the Free Software Foundation, Inc., 59 Temple
+    Place - Suite 330, Boston, MA 02111-1307, USA, or go to
+    http://www.gnu.org/copyleft/lesser.txt.
+    ------------------------------------------------------------------------------------
+    Author:     EVEmu Team
+*/
+
+#include "eve-test.h"
+
+/* Checks RechargeState against a numeric integration of the recharge
+ * rate dC/dt = 10 * Cmax / T * ( sqrt( C / Cmax ) - C / Cmax ), which
+ * is what the closed form solves.
+ */
+
+/** Relative error allowed between the closed form and the integration. */
+static const double RECHARGE_TEST_TOLERANCE = 1e-4;
+
+static bool Near( double a, double b )
+{
+    return ::fabs( a - b ) <= RECHARGE_TEST_TOLERANCE * std::max( 1.0, ::fabs( b ) );
+}
+
+int utils_RechargeStateTest( int argc, char* argv[] )
+{
+    const double capacity = 1125.0;
+    const double rechargeTime = 250000.0;
+    const uint32 start = 0xFFFF0000;  // make the clock wrap around on the way
+
+    // the integration does not leave 0, so start a bit above it
+    RechargeState state;
+    state.Reset( capacity, rechargeTime, capacity * 0.01, start );
+
+    double integrated = capacity * 0.01;
+    for( uint32 t = 1; t <= 600000; ++t )
+    {
+        const double c = integrated / capacity;
+        integrated += 10.0 * capacity / rechargeTime * ( ::sqrt( c ) - c );
+
+        if( 0 == t % 10000 && !Near( state.GetValue( start + t ), integrated ) )
+        {
+            ::printf( "Value at %u ms is %f, integrated %f.\n", t, state.GetValue( start + t ), integrated );
+            return EXIT_FAILURE;
+        }
+    }
+
+    // rebasing keeps the current value
+    const uint32 now = start + 30000;
+    const double before = state.GetValue( now );
+    state.SetLimits( capacity * 2.0, rechargeTime, now );
+    if( !Near( state.GetValue( now ), before ) )
+    {
+        ::printf( "SetLimits() changed the value from %f to %f.\n", before, state.GetValue( now ) );
+        return EXIT_FAILURE;
+    }
+
+    // values are clamped
+    state.SetValue( -5.0, now );
+    if( 0.0 != state.GetValue( now ) )
+    {
+        ::printf( "Negative value not clamped: %f.\n", state.GetValue( now ) );
+        return EXIT_FAILURE;
+    }
+    state.SetValue( capacity * 3.0, now );
+    if( capacity * 2.0 != state.GetValue( now ) || !state.IsFull( now ) || 0 != state.GetTimeToFull( now ) )
+    {
+        ::printf( "Value over capacity not clamped: %f.\n", state.GetValue( now ) );
+        return EXIT_FAILURE;
+    }
+
+    // the computed times agree with the values
+    state.Reset( capacity, rechargeTime, capacity * 0.2, now );
+    const double levels[] = { 0.1, 0.25, 0.5, 0.75, 0.9, RECHARGE_FULL_RATIO };
+    for( size_t i = 0; i < sizeof( levels ) / sizeof( levels[0] ); ++i )
+    {
+        const double level = capacity * levels[ i ];
+        const uint32 wait = state.GetTimeToReach( level, now );
+        if( 0xFFFFFFFF == wait
+            || state.GetValue( now + wait ) < level
+            || ( 0 < wait && state.GetValue( now + wait - 1 ) >= level ) )
+        {
+            ::printf( "Level %f reached in %u ms at %f.\n", level, wait, state.GetValue( now + wait ) );
+            return EXIT_FAILURE;
+        }
+    }
+    if( 0xFFFFFFFF != state.GetTimeToReach( capacity, now ) )
+    {
+        ::puts( "Full capacity should never be reached." );
+        return EXIT_FAILURE;
+    }
+
+    // no recharge without recharge time
+    state.Reset( capacity, 0.0, 100.0, now );
+    if( 100.0 != state.GetValue( now + 100000 ) || 0xFFFFFFFF != state.GetTimeToFull( now ) )
+    {
+        ::puts( "Value recharged without recharge time." );
+        return EXIT_FAILURE;
+    }
+
+    ::puts( "Recharge state OK." );
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,88 @@
+/*
+    ------------------------------------------------------------------------------------
+    LICENSE:
+    ------------------------------------------------------------------------------------
+    This file is part of EVEmu: EVE Online Server Emulator
+    Copyright 2006 - 2011 The EVEmu Team
+    For the latest information visit http://evemu.org
+    ------------------------------------------------------------------------------------
+    This program is free software; you can redistribute it and/or modify it under
+    the terms of the GNU Lesser General Public License as published by the Free Software
+    Foundation; either version 2 of the License, or (at your option) any later
+    version.
+
+    This program is distributed in the hope that it will be useful, but WITHOUT
+    ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+    FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public License along with
+    this program; if not, write to the Free Software Foundation, Inc., 59 Temple
+    Place - Suite 330, Boston, MA 02111-1307, USA, or go to
+    http://www.gnu.org/copyleft/lesser.txt.
+    ------------------------------------------------------------------------------------
+    Author:     EVEmu Team
+*/
+
+#include "eve-test.h"
+
+/// Runs a tick taking about the given time, with a nested zone.
+static void RunTick( TickProfiler& profiler, uint32 ms )
+{
+    profiler.BeginTick();
+    {
+        ProfileZone outer( "Outer", 42 );
+        {
+            ProfileZone inner( "Inner", "detail" );
+            Sleep( ms );
+        }
+    }
+    profiler.EndTick();
+}
+
+int utils_TickProfilerTest( int argc, char* argv[] )
+{
+    TickProfiler profiler;
+    profiler.Configure( true, 0, 2 );
+
+    RunTick( profiler, 1 );
+    RunTick( profiler, 40 );
+    RunTick( profiler, 20 );
+    // zones outside of a tick are not recorded
+    if( TickProfiler::NO_ZONE != TickProfiler::Enter( "Outside" ) )
+    {
+        ::puts( "A zone outside of a tick was recorded." );
+        return EXIT_FAILURE;
+    }
+
+    const TickProfiler::Stats& stats = profiler.stats();
+    if( 3 != stats.ticks || 6 != stats.zones || 0 != stats.droppedZones )
+    {
+        ::printf( "Unexpected stats: %u ticks, %u zones, %u dropped.\n", stats.ticks, stats.zones, stats.droppedZones );
+        return EXIT_FAILURE;
+    }
+
+    // only the two slowest ticks are kept, slowest first
+    std::string summary;
+    if( 2 != profiler.Dump( 10, summary ) )
+    {
+        ::puts( "Unexpected number of kept ticks." );
+        return EXIT_FAILURE;
+    }
+    if( 0 != summary.find( "Tick 1 " ) || std::string::npos == summary.find( "\nTick 2 " )
+        || std::string::npos == summary.find( "slowest Outer" ) )
+    {
+        ::printf( "Unexpected summary:\n%s\n", summary.c_str() );
+        return EXIT_FAILURE;
+    }
+
+    profiler.Reset();
+    summary.clear();
+    if( 0 != profiler.Dump( 10, summary ) )
+    {
+        ::puts( "Ticks kept after a reset." );
+        return EXIT_FAILURE;
+    }
+
+    ::puts( "TickProfiler OK." );
+    return EXIT_SUCCESS;
+}
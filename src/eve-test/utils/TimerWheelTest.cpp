@@ -0,0 +1,158 @@
+/*
+    ------------------------------------------------------------------------------------
+    LICENSE:
+    ------------------------------------------------------------------------------------
+    This file is part of EVEmu: EVE Online Server Emulator
+    Copyright 2006 - 2011 The EVEmu Team
+    For the latest information visit http://evemu.org
+    ------------------------------------------------------------------------------------
+    This program is free software; you can redistribute it and/or modify it under
+    the terms of the GNU Lesser General Public License as published by the Free Software
+    Foundation; either version 2 of the License, or (at your option) any later
+    version.
+
+    This program is distributed in the hope that it will be useful, but WITHOUT
+    ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+    FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public License along with
+    this program; if not, write to the Free Software Foundation, Inc., 59 Temple
+    Place - Suite 330, Boston, MA 02111-1307, USA, or go to
+    http://www.gnu.org/copyleft/lesser.txt.
+    ------------------------------------------------------------------------------------
+    Author:     EVEmu Team
+*/
+
+#include "eve-test.h"
+
+class TestTimer
+: public TimerWheel::Callback
+{
+public:
+    TestTimer() : expiry( 0 ), fired( false ), firedAt( 0 ), now( NULL ) {}
+
+    uint32 expiry;
+    bool fired;
+    uint32 firedAt;
+    const uint32* now;
+
+protected:
+    void TimerExpired() { fired = true; firedAt = *now; }
+};
+
+class RepeatTimer
+: public TimerWheel::Callback
+{
+public:
+    RepeatTimer( TimerWheel& wheel ) : count( 0 ), mWheel( wheel ) {}
+
+    uint32 count;
+
+protected:
+    void TimerExpired()
+    {
+        // rescheduling from within the callback must not fire it again at once
+        ++count;
+        mWheel.Schedule( this, 5 );
+    }
+
+    TimerWheel& mWheel;
+};
+
+int utils_TimerWheelTest( int argc, char* argv[] )
+{
+    const uint32 start = 0xFFFFF000;  // make the clock wrap around on the way
+    const uint32 count = 2000;
+    const uint32 delays[] = { 0, 1, 255, 256, 257, 16383, 16384, 1048575, 1048576, 70000000 };
+
+    uint32 now = start;
+    TimerWheel wheel( start );
+
+    std::vector<TestTimer> timers( count );
+    for( uint32 i = 0; i < count; ++i )
+    {
+        uint32 delay = delays[ i % ( sizeof( delays ) / sizeof( delays[0] ) ) ];
+        if( i >= count / 2 )
+            delay = ( i * 7919 ) % 3000000;
+
+        timers[ i ].now = &now;
+        timers[ i ].expiry = start + delay;
+        wheel.Schedule( &timers[ i ], delay );
+    }
+
+    // cancelled timers never fire
+    wheel.Cancel( &timers[ 3 ] );
+    wheel.Cancel( &timers[ 4 ] );
+
+    {
+        // destroyed timers cancel themselves
+        TestTimer gone;
+        gone.now = &now;
+        wheel.Schedule( &gone, 10 );
+    }
+
+    if( wheel.size() != count - 2 )
+    {
+        ::printf( "Wrong number of scheduled timers: %u.\n", (uint32)wheel.size() );
+        return EXIT_FAILURE;
+    }
+
+    uint32 step = 0;
+    while( 0 < wheel.size() )
+    {
+        wheel.Process( now );
+
+        // irregular steps, but never past the next expiry
+        const uint32 toNext = wheel.GetTimeToNextExpiry();
+        step = ( step * 31 + 17 ) % 5000 + 1;
+        if( toNext < step )
+            step = ( 0 == toNext ? 1 : toNext );
+
+        now += step;
+    }
+
+    for( uint32 i = 0; i < count; ++i )
+    {
+        const TestTimer& t = timers[ i ];
+        if( i == 3 || i == 4 )
+        {
+            if( t.fired )
+            {
+                ::printf( "Cancelled timer %u fired.\n", i );
+                return EXIT_FAILURE;
+            }
+            continue;
+        }
+
+        if( !t.fired || 0 > (int32)( t.firedAt - t.expiry ) )
+        {
+            ::printf( "Timer %u fired at %u, expected %u.\n", i, t.firedAt - start, t.expiry - start );
+            return EXIT_FAILURE;
+        }
+        // GetTimeToNextExpiry() told us when to call Process()
+        if( t.firedAt != t.expiry )
+        {
+            ::printf( "Timer %u fired %u ms late.\n", i, t.firedAt - t.expiry );
+            return EXIT_FAILURE;
+        }
+    }
+
+    if( wheel.stats().fired != count - 2 )
+    {
+        ::printf( "Wrong number of fired timers: %u.\n", wheel.stats().fired );
+        return EXIT_FAILURE;
+    }
+
+    RepeatTimer repeat( wheel );
+    wheel.Schedule( &repeat, 5 );
+    for( uint32 i = 0; i < 10; ++i )
+        wheel.Process( now += 5 );
+    if( repeat.count != 10 )
+    {
+        ::printf( "Repeating timer fired %u times.\n", repeat.count );
+        return EXIT_FAILURE;
+    }
+
+    ::puts( "Timer wheel OK." );
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,415 @@
+/*
+    ------------------------------------------------------------------------------------
+    LICENSE:
+    ------------------------------------------------------------------------------------
+    This file is part of EVEmu: EVE Online Server Emulator
+    Copyright 2006 - 2011 The EVEmu Team
+    For the latest information visit http://evemu.org
+    ------------------------------------------------------------------------------------
+    This program is free software; you can redistribute it and/or modify it under
+    the terms of the GNU Lesser General Public License as published by the Free Software
+    Foundation; either version 2 of the License, or (at your option) any later
+    version.
+
+    This program is distributed in the hope that it will be useful, but WITHOUT
+    ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+    FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public License along with
+    this program; if not, write to the Free Software Foundation, Inc., 59 Temple
+    Place - Suite 330, Boston, MA 02111-1307, USA, or go to
+    http://www.gnu.org/copyleft/lesser.txt.
+    ------------------------------------------------------------------------------------
+    Author:     EVEmu Team
+*/
+
+#include "eve-test.h"
+
+/* Checks TypeAttributeTable against the node-based container the
+ * dgmtypeattributemgr used to keep, and measures both of them on
+ * a table the size of a full invTypes/dgmTypeAttributes load.
+ *
+ * The optional first argument is time (in milliseconds) spent on each
+ * measurement; the default is TYPE_ATTRIBUTE_BENCHMARK_TIME.
+ */
+
+/** Default time (in milliseconds) spent on a single measurement. */
+static const uint32 TYPE_ATTRIBUTE_BENCHMARK_TIME = 200;
+/** Number of types, about as many as invTypes has. */
+static const uint32 TYPE_ATTRIBUTE_BENCHMARK_TYPES = 22000;
+/** Greatest typeID. */
+static const uint32 TYPE_ATTRIBUTE_BENCHMARK_MAX_TYPE_ID = 370000;
+/** Greatest attributeID. */
+static const uint32 TYPE_ATTRIBUTE_BENCHMARK_MAX_ATTRIBUTE_ID = 1800;
+/** Number of lookups per measured operation. */
+static const uint32 TYPE_ATTRIBUTE_BENCHMARK_LOOKUPS = 1000;
+
+/* Deterministic generator, so the runs are comparable. */
+class AttributeRandom
+{
+public:
+    AttributeRandom() : mState( 0x1B873593 ) {}
+
+    uint32 Next() { return ( mState = mState * 1664525 + 1013904223 ) >> 8; }
+    uint32 Next( uint32 max ) { return Next() % max; }
+
+protected:
+    uint32 mState;
+};
+
+/* The container the dgmtypeattributemgr used to keep. */
+struct ReferenceAttribute
+{
+    uint16 attributeID;
+    EvilNumber number;
+};
+typedef std::list< ReferenceAttribute* > ReferenceAttributeSet;
+typedef std::map< uint32, ReferenceAttributeSet* > ReferenceAttributeMap;
+
+static void ClearReference( ReferenceAttributeMap& map )
+{
+    ReferenceAttributeMap::iterator cur, end;
+    cur = map.begin();
+    end = map.end();
+    for(; cur != end; ++cur )
+    {
+        ReferenceAttributeSet::iterator a = cur->second->begin();
+        for(; a != cur->second->end(); ++a )
+            delete *a;
+        delete cur->second;
+    }
+    map.clear();
+}
+
+/* Rows of (typeID, attributeID, value), ordered by typeID like the query. */
+struct AttributeRow
+{
+    uint32 typeID;
+    uint16 attributeID;
+    EvilNumber number;
+};
+
+static void BuildRows( std::vector< AttributeRow >& rows, std::vector< uint32 >& typeIDs )
+{
+    AttributeRandom rnd;
+
+    std::set< uint32 > ids;
+    while( ids.size() < TYPE_ATTRIBUTE_BENCHMARK_TYPES )
+        ids.insert( 1 + rnd.Next( TYPE_ATTRIBUTE_BENCHMARK_MAX_TYPE_ID ) );
+    typeIDs.assign( ids.begin(), ids.end() );
+
+    for( size_t t = 0; t < typeIDs.size(); ++t )
+    {
+        // mostly a handful, ships and modules have dozens
+        const uint32 count = 1 + ( 0 == rnd.Next( 8 ) ? rnd.Next( 80 ) : rnd.Next( 16 ) );
+
+        std::set< uint16 > attributeIDs;
+        while( attributeIDs.size() < count )
+            attributeIDs.insert( 1 + rnd.Next( TYPE_ATTRIBUTE_BENCHMARK_MAX_ATTRIBUTE_ID ) );
+
+        std::set< uint16 >::const_iterator cur = attributeIDs.begin();
+        for(; cur != attributeIDs.end(); ++cur )
+        {
+            AttributeRow row;
+            row.typeID = typeIDs[ t ];
+            row.attributeID = *cur;
+            if( 0 == rnd.Next( 2 ) )
+                row.number = EvilNumber( (int32)rnd.Next( 1000 ) );
+            else
+                row.number = EvilNumber( rnd.Next( 100000 ) / 100.0 );
+
+            rows.push_back( row );
+        }
+    }
+
+    // the rows of a type come in no particular order
+    for( size_t i = rows.size(); 1 < i; --i )
+    {
+        const size_t first = i - 1;
+        size_t begin = first;
+        while( 0 < begin && rows[ begin - 1 ].typeID == rows[ first ].typeID )
+            --begin;
+        std::swap( rows[ first ], rows[ begin + rnd.Next( first - begin + 1 ) ] );
+    }
+}
+
+/* Loads the rows the way the dgmtypeattributemgr used to. */
+static void LoadReference( const std::vector< AttributeRow >& rows, ReferenceAttributeMap& into )
+{
+    uint32 currentID = 0;
+    ReferenceAttributeSet* entry = NULL;
+    for( size_t i = 0; i < rows.size(); ++i )
+    {
+        if( NULL == entry || currentID != rows[ i ].typeID )
+        {
+            if( NULL != entry )
+                into.insert( std::make_pair( currentID, entry ) );
+            currentID = rows[ i ].typeID;
+            entry = new ReferenceAttributeSet;
+        }
+
+        ReferenceAttribute* attr = new ReferenceAttribute;
+        attr->attributeID = rows[ i ].attributeID;
+        attr->number = rows[ i ].number;
+        entry->push_back( attr );
+    }
+    if( NULL != entry )
+        into.insert( std::make_pair( currentID, entry ) );
+}
+
+static void LoadTable( const std::vector< AttributeRow >& rows, TypeAttributeTable& into )
+{
+    for( size_t i = 0; i < rows.size(); ++i )
+        into.Add( rows[ i ].typeID, rows[ i ].attributeID, rows[ i ].number );
+    into.Build();
+}
+
+static bool SameNumber( EvilNumber a, EvilNumber b )
+{
+    if( a.get_type() != b.get_type() )
+        return false;
+    if( evil_number_int == a.get_type() )
+        return a.get_int() == b.get_int();
+    return a.get_float() == b.get_float();
+}
+
+static bool VerifyTable( const ReferenceAttributeMap& reference, const TypeAttributeTable& table )
+{
+    if( table.GetTypeCount() != reference.size() )
+    {
+        ::printf( "Table has %u types instead of %lu.\n", table.GetTypeCount(), reference.size() );
+        return false;
+    }
+
+    ReferenceAttributeMap::const_iterator cur, end;
+    cur = reference.begin();
+    end = reference.end();
+    for(; cur != end; ++cur )
+    {
+        TypeAttributeTable::Range range;
+        if( !table.Find( cur->first, range ) || range.size() != cur->second->size() )
+        {
+            ::printf( "Attributes of type %u differ.\n", cur->first );
+            return false;
+        }
+
+        ReferenceAttributeSet::const_iterator a = cur->second->begin();
+        for(; a != cur->second->end(); ++a )
+        {
+            EvilNumber number;
+            if( !range.Find( (*a)->attributeID, number ) || !SameNumber( number, (*a)->number ) )
+            {
+                ::printf( "Attribute %u of type %u differs.\n", (*a)->attributeID, cur->first );
+                return false;
+            }
+        }
+
+        // and in order
+        for( uint32 i = 1; i < range.size(); ++i )
+        {
+            if( range.attributeID( i - 1 ) >= range.attributeID( i ) )
+            {
+                ::printf( "Attributes of type %u are not sorted.\n", cur->first );
+                return false;
+            }
+        }
+
+        // the neighbours are not there
+        if( table.Find( cur->first + 1, range ) && reference.find( cur->first + 1 ) == reference.end() )
+        {
+            ::printf( "Type %u found, though it has no attributes.\n", cur->first + 1 );
+            return false;
+        }
+    }
+
+    // the last one added wins
+    TypeAttributeTable dup;
+    dup.Add( 5, 10, EvilNumber( 1 ) );
+    dup.Add( 5, 10, EvilNumber( 2 ) );
+    dup.Build();
+    dup.Add( 5, 11, EvilNumber( 3 ) );
+    dup.Add( 4, 10, EvilNumber( 4 ) );
+    dup.Build();
+
+    TypeAttributeTable::Range range;
+    EvilNumber number;
+    if( 2 != dup.GetTypeCount() || !dup.Find( 5, range ) || 2 != range.size()
+        || !range.Find( 10, number ) || !SameNumber( number, EvilNumber( 2 ) )
+        || !range.Find( 11, number ) || !SameNumber( number, EvilNumber( 3 ) )
+        || range.Find( 12, number ) || dup.Find( 6, range ) )
+    {
+        ::puts( "Attributes added more than once are not merged." );
+        return false;
+    }
+
+    return true;
+}
+
+enum TypeAttributeOp
+{
+    OP_REFERENCE_LOAD,
+    OP_LOAD,
+    OP_REFERENCE_ITERATE,
+    OP_ITERATE,
+    OP_REFERENCE_FIND,
+    OP_FIND,
+
+    OP_COUNT
+};
+
+static const char* const TYPE_ATTRIBUTE_OP_NAMES[ OP_COUNT ] =
+{
+    "reference load",
+    "load",
+    "reference iterate",
+    "iterate",
+    "reference find",
+    "find"
+};
+
+/* Sums the attributes, so none of the work is optimized away. */
+static double g_typeAttributeSink = 0.0;
+
+/* Returns the time of a single operation, in microseconds. */
+static double MeasureTypeAttributeOp( TypeAttributeOp op, const std::vector< AttributeRow >& rows,
+                                      const std::vector< uint32 >& lookups,
+                                      const ReferenceAttributeMap& reference, const TypeAttributeTable& table,
+                                      uint32 timeMs )
+{
+    const uint64 limit = 1000 * (uint64)timeMs;
+
+    uint32 ops = 0;
+    uint64 time = 0;
+    double sum = 0.0;
+
+    const uint64 start = GetTimeUSeconds();
+    do
+    {
+        switch( op )
+        {
+            case OP_REFERENCE_LOAD:
+            {
+                ReferenceAttributeMap map;
+                LoadReference( rows, map );
+                ClearReference( map );
+            } break;
+            case OP_LOAD:
+            {
+                TypeAttributeTable t;
+                LoadTable( rows, t );
+            } break;
+            case OP_REFERENCE_ITERATE:
+            {
+                for( size_t i = 0; i < lookups.size(); ++i )
+                {
+                    ReferenceAttributeMap::const_iterator res = reference.find( lookups[ i ] );
+                    if( res == reference.end() )
+                        continue;
+
+                    ReferenceAttributeSet::const_iterator a = res->second->begin();
+                    for(; a != res->second->end(); ++a )
+                        sum += (*a)->attributeID;
+                }
+            } break;
+            case OP_ITERATE:
+            {
+                TypeAttributeTable::Range range;
+                for( size_t i = 0; i < lookups.size(); ++i )
+                {
+                    if( !table.Find( lookups[ i ], range ) )
+                        continue;
+
+                    for( uint32 a = 0; a < range.size(); ++a )
+                        sum += range.attributeID( a );
+                }
+            } break;
+            case OP_REFERENCE_FIND:
+            {
+                for( size_t i = 0; i < lookups.size(); ++i )
+                {
+                    ReferenceAttributeMap::const_iterator res = reference.find( lookups[ i ] );
+                    if( res == reference.end() )
+                        continue;
+
+                    const uint16 attributeID = 1 + ( lookups[ i ] % TYPE_ATTRIBUTE_BENCHMARK_MAX_ATTRIBUTE_ID );
+                    ReferenceAttributeSet::const_iterator a = res->second->begin();
+                    for(; a != res->second->end(); ++a )
+                    {
+                        if( (*a)->attributeID == attributeID )
+                        {
+                            sum += 1.0;
+                            break;
+                        }
+                    }
+                }
+            } break;
+            case OP_FIND:
+            {
+                TypeAttributeTable::Range range;
+                EvilNumber number;
+                for( size_t i = 0; i < lookups.size(); ++i )
+                {
+                    if( !table.Find( lookups[ i ], range ) )
+                        continue;
+
+                    const uint16 attributeID = 1 + ( lookups[ i ] % TYPE_ATTRIBUTE_BENCHMARK_MAX_ATTRIBUTE_ID );
+                    if( range.Find( attributeID, number ) )
+                        sum += 1.0;
+                }
+            } break;
+            default:
+                break;
+        }
+
+        ++ops;
+        time = GetTimeUSeconds() - start;
+    } while( 10 > ops || limit > time );
+
+    g_typeAttributeSink += sum;
+    return (double)time / ops;
+}
+
+int utils_TypeAttributeTableBenchmark( int argc, char* argv[] )
+{
+    uint32 timeMs = TYPE_ATTRIBUTE_BENCHMARK_TIME;
+    if( 1 < argc )
+        timeMs = ::strtoul( argv[1], NULL, 10 );
+
+    std::vector< AttributeRow > rows;
+    std::vector< uint32 > typeIDs;
+    BuildRows( rows, typeIDs );
+
+    ReferenceAttributeMap reference;
+    LoadReference( rows, reference );
+
+    TypeAttributeTable table;
+    LoadTable( rows, table );
+
+    const bool verified = VerifyTable( reference, table );
+    if( verified )
+    {
+        // mostly types which are there, some which are not
+        AttributeRandom rnd;
+        std::vector< uint32 > lookups;
+        for( uint32 i = 0; i < TYPE_ATTRIBUTE_BENCHMARK_LOOKUPS; ++i )
+            lookups.push_back( 0 == rnd.Next( 10 ) ? rnd.Next( TYPE_ATTRIBUTE_BENCHMARK_MAX_TYPE_ID )
+                                                   : typeIDs[ rnd.Next( typeIDs.size() ) ] );
+
+        ::printf( "%u types with %u attributes.\n", table.GetTypeCount(), table.GetAttributeCount() );
+
+        double times[ OP_COUNT ];
+        for( int op = 0; op < OP_COUNT; ++op )
+        {
+            times[ op ] = MeasureTypeAttributeOp( (TypeAttributeOp)op, rows, lookups, reference, table, timeMs );
+            ::printf( "  %-20s %12.1f us/op\n", TYPE_ATTRIBUTE_OP_NAMES[ op ], times[ op ] );
+        }
+
+        ::printf( "  speedup: load %.2fx, iterate %.2fx, find %.2fx\n",
+                  times[ OP_REFERENCE_LOAD ] / times[ OP_LOAD ],
+                  times[ OP_REFERENCE_ITERATE ] / times[ OP_ITERATE ],
+                  times[ OP_REFERENCE_FIND ] / times[ OP_FIND ] );
+    }
+
+    ClearReference( reference );
+    return verified ? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -0,0 +1,214 @@
+/*
+    ------------------------------------------------------------------------------------
+    LICENSE:
+    ------------------------------------------------------------------------------------
+    This file is part of EVEmu: EVE Online Server Emulator
+    Copyright 2006 - 2011 The EVEmu Team
+    For the latest information visit http://evemu.org
+    ------------------------------------------------------------------------------------
+    This program is free software; you can redistribute it and/or modify it under
+    the terms of the GNU Lesser General Public License as published by the Free Software
+    Foundation; either version 2 of the License, or (at your option) any later
+    version.
+
+    This program is distributed in the hope that it will be useful, but WITHOUT
+    ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+    FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public License along with
+    this program; if not, write to the Free Software Foundation, Inc., 59 Temple
+    Place - Suite 330, Boston, MA 02111-1307, USA, or go to
+    http://www.gnu.org/copyleft/lesser.txt.
+    ------------------------------------------------------------------------------------
+    Author:     EVEmu Team
+*/
+
+
+#include "eve-test.h"
+
+#include "utils/Utf16.h"
+
+/* Checks the UTF-16/UTF-8 conversions against the utf8 library and
+ * measures both of them on strings like the ones the clients send:
+ * ASCII names, chat lines with some accents, Cyrillic mails.
+ *
+ * The optional first argument is time (in milliseconds) spent on each
+ * measurement; the default is UTF16_BENCHMARK_TIME.
+ */
+
+/** Default time (in milliseconds) spent on a single measurement. */
+static const uint32 UTF16_BENCHMARK_TIME = 200;
+/** Number of strings of every kind. */
+static const uint32 UTF16_BENCHMARK_STRINGS = 256;
+
+enum Utf16Kind
+{
+    KIND_ASCII,
+    KIND_LATIN,
+    KIND_CYRILLIC,
+
+    KIND_COUNT
+};
+
+static const char* const UTF16_KIND_NAMES[ KIND_COUNT ] =
+{
+    "ascii",
+    "latin",
+    "cyrillic"
+};
+
+/* Deterministic generator, so the runs are comparable. */
+class Utf16Random
+{
+public:
+    Utf16Random() : mState( 0x1B873593 ) {}
+
+    uint32 Next() { return ( mState = mState * 1664525 + 1013904223 ) >> 8; }
+
+    /* Returns a string of the kind, 8 to 263 units long. */
+    void String( Utf16Kind kind, std::vector< uint16 >& into )
+    {
+        into.clear();
+
+        const uint32 len = 8 + Next() % 256;
+        for( uint32 i = 0; i < len; ++i )
+        {
+            const uint32 r = Next();
+            if( KIND_LATIN == kind && 0 == r % 12 )
+                into.push_back( 0xC0 + r / 12 % 0x40 );
+            else if( KIND_CYRILLIC == kind && 0 != r % 5 )
+                into.push_back( 0x410 + r / 5 % 0x40 );
+            else
+                into.push_back( 0 == r % 7 ? ' ' : 'a' + r / 7 % 26 );
+        }
+    }
+
+protected:
+    uint32 mState;
+};
+
+static bool VerifyUtf16()
+{
+    Utf16Random rnd;
+    std::vector< uint16 > wide, back;
+    std::string expected, converted;
+
+    for( int kind = 0; kind < KIND_COUNT; ++kind )
+    {
+        for( uint32 i = 0; i < UTF16_BENCHMARK_STRINGS; ++i )
+        {
+            rnd.String( (Utf16Kind)kind, wide );
+            // some pairs of surrogates as well
+            if( 0 == i % 16 )
+            {
+                wide.push_back( 0xD83D );
+                wide.push_back( 0xDE00 );
+            }
+
+            expected.clear();
+            utf8::utf16to8( wide.begin(), wide.end(), std::back_inserter( expected ) );
+            converted.clear();
+            Utf16ToUtf8( &wide[0], wide.size(), converted );
+            if( converted != expected )
+            {
+                ::printf( "String %u of kind %s differs in UTF-8.\n", i, UTF16_KIND_NAMES[ kind ] );
+                return false;
+            }
+
+            if( Utf8Length( expected.c_str(), expected.size() ) != (size_t)utf8::distance( expected.begin(), expected.end() ) )
+            {
+                ::printf( "String %u of kind %s has a wrong length.\n", i, UTF16_KIND_NAMES[ kind ] );
+                return false;
+            }
+
+            back.clear();
+            Utf8ToUtf16( expected.c_str(), expected.size(), back );
+            if( back != wide )
+            {
+                ::printf( "String %u of kind %s differs in UTF-16.\n", i, UTF16_KIND_NAMES[ kind ] );
+                return false;
+            }
+        }
+    }
+
+    // unpaired surrogates and malformed sequences are replaced, not thrown at
+    const uint16 lone[] = { 'a', 0xDC00, 'b', 0xD800 };
+    converted.clear();
+    Utf16ToUtf8( lone, 4, converted );
+    if( converted != "a\xEF\xBF\xBD" "b\xEF\xBF\xBD" )
+    {
+        ::puts( "Unpaired surrogates are not replaced." );
+        return false;
+    }
+
+    const char malformed[] = "a\xC0\x80\xE2\x82";
+    back.clear();
+    Utf8ToUtf16( malformed, sizeof( malformed ) - 1, back );
+    if( 4 != back.size() || 'a' != back[0] || 0xFFFD != back[1] || 0xFFFD != back[2] || 0xFFFD != back[3] )
+    {
+        ::puts( "Malformed UTF-8 is not replaced." );
+        return false;
+    }
+
+    return true;
+}
+
+/* Sums the results, so none of the work is optimized away. */
+static size_t g_utf16Sink = 0;
+
+/* Returns the time of converting a single string, in nanoseconds. */
+static double MeasureUtf16( bool reference, const std::vector< std::vector< uint16 > >& strings, uint32 timeMs )
+{
+    const uint64 limit = 1000 * (uint64)timeMs;
+
+    uint32 ops = 0;
+    uint64 time = 0;
+    size_t sum = 0;
+
+    const uint64 start = GetTimeUSeconds();
+    do
+    {
+        for( size_t i = 0; i < strings.size(); ++i )
+        {
+            // fresh strings, as the unmarshaler builds them
+            std::string str;
+            if( reference )
+                utf8::utf16to8( strings[ i ].begin(), strings[ i ].end(), std::back_inserter( str ) );
+            else
+                Utf16ToUtf8( &strings[ i ][0], strings[ i ].size(), str );
+            sum += str.size();
+        }
+
+        ++ops;
+        time = GetTimeUSeconds() - start;
+    } while( 10 > ops || limit > time );
+
+    g_utf16Sink += sum;
+    return 1000.0 * time / ( (double)ops * strings.size() );
+}
+
+int utils_Utf16Benchmark( int argc, char* argv[] )
+{
+    uint32 timeMs = UTF16_BENCHMARK_TIME;
+    if( 1 < argc )
+        timeMs = ::strtoul( argv[1], NULL, 10 );
+
+    const bool verified = VerifyUtf16();
+    if( verified )
+    {
+        Utf16Random rnd;
+        for( int kind = 0; kind < KIND_COUNT; ++kind )
+        {
+            std::vector< std::vector< uint16 > > strings( UTF16_BENCHMARK_STRINGS );
+            for( uint32 i = 0; i < UTF16_BENCHMARK_STRINGS; ++i )
+                rnd.String( (Utf16Kind)kind, strings[ i ] );
+
+            const double reference = MeasureUtf16( true, strings, timeMs );
+            const double converted = MeasureUtf16( false, strings, timeMs );
+            ::printf( "  %-10s reference %8.1f ns/string, converted %8.1f ns/string, speedup %.2fx\n",
+                      UTF16_KIND_NAMES[ kind ], reference, converted, reference / converted );
+        }
+    }
+
+    return verified ? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -0,0 +1,226 @@
+/*
+    ------------------------------------------------------------------------------------
+    LICENSE:
+    ------------------------------------------------------------------------------------
+    This file is part of EVEmu: EVE Online Server Emulator
+    Copyright 2006 - 2011 The EVEmu Team
+    For the latest information visit http://evemu.org
+    ------------------------------------------------------------------------------------
+    This program is free software; you can redistribute it and/or modify it under
+    the terms of the GNU Lesser General Public License as published by the Free Software
+    Foundation; either version 2 of the License, or (at your option) any later
+    version.
+
+    This program is distributed in the hope that it will be useful, but WITHOUT
+    ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+    FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public License along with
+    this program; if not, write to the Free Software Foundation, Inc., 59 Temple
+    Place - Suite 330, Boston, MA 02111-1307, USA, or go to
+    http://www.gnu.org/copyleft/lesser.txt.
+    ------------------------------------------------------------------------------------
+    Author:     EVEmu Team
+*/
+
+
+#include "eve-tool.h"
+
+#include "CacheConverter.h"
+
+/************************************************************************/
+/* CacheConverter                                                       */
+/************************************************************************/
+CacheConverter::CacheConverter()
+: mBulk( false ),
+  mTaken( 0 ),
+  mSucceeded( 0 )
+{
+}
+
+void CacheConverter::Add( const std::string& cacheFile, const std::string& tableName,
+                          const std::string& keyField, const std::string& fileName )
+{
+    Job job;
+    job.cacheFile = cacheFile;
+    job.tableName = tableName;
+    job.keyField = keyField;
+    job.fileName = fileName;
+
+    mJobs.push_back( job );
+}
+
+bool CacheConverter::LoadScript( const char* filename )
+{
+    FILE* file = fopen( filename, "r" );
+    if( NULL == file )
+    {
+        sLog.Error( "CacheConverter", "Unable to open script '%s'.", filename );
+        return false;
+    }
+
+    char line[ 1024 ];
+    while( NULL != fgets( line, sizeof( line ), file ) )
+    {
+        line[ strcspn( line, "\r\n" ) ] = '\0';
+
+        const Seperator cmd( line );
+        if( 0 == cmd.argCount() || "obj2sql" != cmd.arg( 0 ) )
+            continue;
+
+        if( 5 != cmd.argCount() )
+        {
+            sLog.Warning( "CacheConverter", "Skipping malformed line '%s' of '%s'.", line, filename );
+            continue;
+        }
+
+        Add( cmd.arg( 1 ), cmd.arg( 2 ), cmd.arg( 3 ), cmd.arg( 4 ) );
+    }
+
+    fclose( file );
+    return true;
+}
+
+size_t CacheConverter::Run( uint32 threads, bool bulk )
+{
+    mBulk = bulk;
+    mTaken = 0;
+    mSucceeded = 0;
+
+    if( threads > mJobs.size() )
+        threads = mJobs.size();
+
+#ifdef WIN32
+    std::vector<HANDLE> workers;
+#else /* !WIN32 */
+    std::vector<pthread_t> workers;
+#endif /* !WIN32 */
+    for( uint32 i = 1; i < threads; ++i )
+    {
+#ifdef WIN32
+        HANDLE thread = CreateThread( NULL, 0, WorkerLoop, this, 0, NULL );
+        if( NULL == thread )
+#else /* !WIN32 */
+        pthread_t thread;
+        if( 0 != pthread_create( &thread, NULL, WorkerLoop, this ) )
+#endif /* !WIN32 */
+        {
+            sLog.Error( "CacheConverter", "Failed to start conversion thread %u.", i );
+            continue;
+        }
+
+        workers.push_back( thread );
+    }
+
+    // the calling thread works too
+    _Work();
+
+    for( size_t i = 0; i < workers.size(); ++i )
+    {
+#ifdef WIN32
+        WaitForSingleObject( workers[ i ], INFINITE );
+        CloseHandle( workers[ i ] );
+#else /* !WIN32 */
+        pthread_join( workers[ i ], NULL );
+#endif /* !WIN32 */
+    }
+
+    return mSucceeded;
+}
+
+bool CacheConverter::Convert( const std::string& cacheFile, const std::string& tableName,
+                              const std::string& keyField, const std::string& fileName,
+                              const char* dataFile )
+{
+    std::string abs_fname( "../data/cache/" );
+    abs_fname += cacheFile;
+    abs_fname += ".cache";
+
+    sLog.Log( "CacheConverter", "Converting cached object %s.", abs_fname.c_str() );
+
+    CachedObjectMgr mgr;
+    PyCachedObjectDecoder* obj = mgr.LoadCachedObject( abs_fname.c_str(), cacheFile.c_str() );
+    if( obj == NULL )
+    {
+        sLog.Error( "CacheConverter", "Unable to load or decode '%s'!", abs_fname.c_str() );
+        return false;
+    }
+
+    obj->cache->DecodeData();
+    if( obj->cache->decoded() == NULL )
+    {
+        sLog.Error( "CacheConverter", "Unable to load or decode body of '%s'!", abs_fname.c_str() );
+
+        SafeDelete( obj );
+        return false;
+    }
+
+    FILE* out = fopen( fileName.c_str(), "w" );
+    if( out == NULL )
+    {
+        sLog.Error( "CacheConverter", "Unable to open output file '%s'", fileName.c_str() );
+
+        SafeDelete( obj );
+        return false;
+    }
+
+    SetSQLDumper dumper( tableName.c_str(), keyField.c_str(), out, dataFile );
+    const bool success = obj->cache->decoded()->visit( dumper );
+    if( success )
+        sLog.Success( "CacheConverter", "Dumping of %s succeeded.", tableName.c_str() );
+    else
+        sLog.Error( "CacheConverter", "Dumping of %s failed.", tableName.c_str() );
+
+    fclose( out );
+    SafeDelete( obj );
+
+    return success;
+}
+
+std::string CacheConverter::GetDataFileName( const std::string& fileName )
+{
+    std::string dataFile( fileName );
+
+    const std::string::size_type ext = dataFile.rfind( ".sql" );
+    if( std::string::npos != ext && dataFile.size() == ext + 4 )
+        dataFile.resize( ext );
+
+    dataFile += ".tsv";
+    return dataFile;
+}
+
+void CacheConverter::_Work()
+{
+    while( true )
+    {
+        // the conversions are taken in order, one at a time
+        const uint32 index = AtomicAdd( &mTaken, 1 ) - 1;
+        if( mJobs.size() <= index )
+            break;
+
+        const Job& job = mJobs[ index ];
+        const std::string dataFile = ( mBulk ? GetDataFileName( job.fileName ) : "" );
+
+        if( Convert( job.cacheFile, job.tableName, job.keyField, job.fileName,
+                     mBulk ? dataFile.c_str() : NULL ) )
+            AtomicAdd( &mSucceeded, 1 );
+    }
+}
+
+#ifdef WIN32
+DWORD WINAPI CacheConverter::WorkerLoop( LPVOID arg )
+#else /* !WIN32 */
+void* CacheConverter::WorkerLoop( void* arg )
+#endif /* !WIN32 */
+{
+    CacheConverter* converter = reinterpret_cast< CacheConverter* >( arg );
+    assert( converter != NULL );
+
+    converter->_Work();
+
+#ifdef WIN32
+    return 0;
+#else /* !WIN32 */
+    return NULL;
+#endif /* !WIN32 */
+}
@@ -0,0 +1,473 @@
+/*
+    ------------------------------------------------------------------------------------
+    LICENSE:
+    ------------------------------------------------------------------------------------
+    This file is part of EVEmu: EVE Online Server Emulator
+    Copyright 2006 - 2011 The EVEmu Team
+    For the latest information visit http://evemu.org
+    ------------------------------------------------------------------------------------
+    This program is free software; you can redistribute it and/or modify it under
+    the terms of the GNU Lesser General Public License as published by the Free Software
+    Foundation; either version 2 of the License, or (at your option) any later
+    version.
+
+    This program is distributed in the hope that it will be useful, but WITHOUT
+    ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+    FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public License along with
+    this program; if not, write to the Free Software Foundation, Inc., 59 Temple
+    Place - Suite 330, Boston, MA 02111-1307, USA, or go to
+    http://www.gnu.org/copyleft/lesser.txt.
+    ------------------------------------------------------------------------------------
+    Author:     EVEmu Team
+*/
+
+
+#include "eve-tool.h"
+
+#include "BindCollector.h"
+#include "CaptureDecoder.h"
+
+/// Signature of the columnar file.
+static const char COLUMNAR_SIGNATURE[ 8 ] = { 'E', 'V', 'E', 'C', 'O', 'L', '1', '\0' };
+
+/**
+ * @brief Appends a number to a buffer, little-endian.
+ */
+template<typename T>
+static void AppendLE( Buffer& into, T value )
+{
+    for( size_t i = 0; i < sizeof( T ); ++i )
+        into.Append< uint8 >( (uint8)( (uint64)value >> ( 8 * i ) ) );
+}
+
+/**
+ * @brief Appends a string to a buffer, prefixed by its length.
+ */
+static void AppendString( Buffer& into, const std::string& str )
+{
+    AppendLE< uint32 >( into, str.size() );
+    into.AppendSeq( str.begin(), str.end() );
+}
+
+/************************************************************************/
+/* CaptureDecoder::RowGroup                                             */
+/************************************************************************/
+/**
+ * @brief Decoded packets of a session, column by column.
+ */
+class CaptureDecoder::RowGroup
+{
+public:
+    /**
+     * @brief A decoded packet.
+     */
+    struct Row
+    {
+        uint64 time;
+        uint8 direction;
+        uint8 type;
+        uint64 callID;
+        uint32 size;
+        uint32 rawSize;
+        uint32 service;
+        uint32 method;
+        uint64 latency;
+    };
+
+    RowGroup( const std::string& session )
+    : mSession( session )
+    {
+        Clear();
+    }
+
+    /** @return Number of rows. */
+    size_t size() const { return mTime.size(); }
+
+    /**
+     * @return Dictionary index of a string, which is added if needed.
+     */
+    uint32 Intern( const std::string& str )
+    {
+        std::map<std::string, uint32>::const_iterator res = mIndex.find( str );
+        if( mIndex.end() != res )
+            return res->second;
+
+        const uint32 index = mStrings.size();
+        mStrings.push_back( str );
+        mIndex.insert( std::make_pair( str, index ) );
+
+        return index;
+    }
+
+    void Add( const Row& row )
+    {
+        mTime.push_back( row.time );
+        mDirection.push_back( row.direction );
+        mType.push_back( row.type );
+        mCallID.push_back( row.callID );
+        mSize.push_back( row.size );
+        mRawSize.push_back( row.rawSize );
+        mService.push_back( row.service );
+        mMethod.push_back( row.method );
+        mLatency.push_back( row.latency );
+    }
+
+    /**
+     * @brief Removes the rows and the strings.
+     */
+    void Clear()
+    {
+        mStrings.clear();
+        mIndex.clear();
+        // the empty string is always at index 0
+        Intern( "" );
+
+        mTime.clear();
+        mDirection.clear();
+        mType.clear();
+        mCallID.clear();
+        mSize.clear();
+        mRawSize.clear();
+        mService.clear();
+        mMethod.clear();
+        mLatency.clear();
+    }
+
+    /**
+     * @brief Encodes the group as laid out in the file.
+     */
+    void Encode( Buffer& into ) const
+    {
+        AppendLE< uint32 >( into, size() );
+        AppendString( into, mSession );
+
+        AppendLE< uint32 >( into, mStrings.size() );
+        for( size_t i = 0; i < mStrings.size(); ++i )
+            AppendString( into, mStrings[ i ] );
+
+        _AppendColumn( into, mTime );
+        _AppendColumn( into, mDirection );
+        _AppendColumn( into, mType );
+        _AppendColumn( into, mCallID );
+        _AppendColumn( into, mSize );
+        _AppendColumn( into, mRawSize );
+        _AppendColumn( into, mService );
+        _AppendColumn( into, mMethod );
+        _AppendColumn( into, mLatency );
+    }
+
+protected:
+    template<typename T>
+    static void _AppendColumn( Buffer& into, const std::vector<T>& column )
+    {
+        for( size_t i = 0; i < column.size(); ++i )
+            AppendLE< T >( into, column[ i ] );
+    }
+
+    const std::string mSession;
+
+    /// The dictionary.
+    std::vector<std::string> mStrings;
+    /// Indexes of the strings in the dictionary.
+    std::map<std::string, uint32> mIndex;
+
+    std::vector<uint64> mTime;
+    std::vector<uint8> mDirection;
+    std::vector<uint8> mType;
+    std::vector<uint64> mCallID;
+    std::vector<uint32> mSize;
+    std::vector<uint32> mRawSize;
+    std::vector<uint32> mService;
+    std::vector<uint32> mMethod;
+    std::vector<uint64> mLatency;
+};
+
+/************************************************************************/
+/* CaptureDecoder                                                       */
+/************************************************************************/
+CaptureDecoder::CaptureDecoder()
+: mOutput( NULL ),
+  mTaken( 0 ),
+  mSucceeded( 0 ),
+  mTime( 0 )
+{
+}
+
+CaptureDecoder::~CaptureDecoder()
+{
+    if( NULL != mOutput )
+        fclose( mOutput );
+}
+
+void CaptureDecoder::Add( const std::string& filename )
+{
+    mCaptures.push_back( filename );
+}
+
+size_t CaptureDecoder::Run( const char* filename, uint32 threads )
+{
+    mTaken = 0;
+    mSucceeded = 0;
+    mTotals = Totals();
+    mTime = 0;
+
+    mOutput = fopen( filename, "wb" );
+    if( NULL == mOutput )
+    {
+        sLog.Error( "CaptureDecoder", "Unable to open output file '%s'.", filename );
+        return 0;
+    }
+
+    if( 1 != fwrite( COLUMNAR_SIGNATURE, sizeof( COLUMNAR_SIGNATURE ), 1, mOutput ) )
+    {
+        sLog.Error( "CaptureDecoder", "Failed to write into '%s'.", filename );
+
+        fclose( mOutput );
+        mOutput = NULL;
+        return 0;
+    }
+
+    if( threads > mCaptures.size() )
+        threads = mCaptures.size();
+
+    const uint64 start = GetTimeUSeconds();
+
+#ifdef WIN32
+    std::vector<HANDLE> workers;
+#else /* !WIN32 */
+    std::vector<pthread_t> workers;
+#endif /* !WIN32 */
+    for( uint32 i = 1; i < threads; ++i )
+    {
+#ifdef WIN32
+        HANDLE thread = CreateThread( NULL, 0, WorkerLoop, this, 0, NULL );
+        if( NULL == thread )
+#else /* !WIN32 */
+        pthread_t thread;
+        if( 0 != pthread_create( &thread, NULL, WorkerLoop, this ) )
+#endif /* !WIN32 */
+        {
+            sLog.Error( "CaptureDecoder", "Failed to start decoding thread %u.", i );
+            continue;
+        }
+
+        workers.push_back( thread );
+    }
+
+    // the calling thread works too
+    _Work();
+
+    for( size_t i = 0; i < workers.size(); ++i )
+    {
+#ifdef WIN32
+        WaitForSingleObject( workers[ i ], INFINITE );
+        CloseHandle( workers[ i ] );
+#else /* !WIN32 */
+        pthread_join( workers[ i ], NULL );
+#endif /* !WIN32 */
+    }
+
+    mTime = GetTimeUSeconds() - start;
+
+    fclose( mOutput );
+    mOutput = NULL;
+
+    return mSucceeded;
+}
+
+void CaptureDecoder::Report() const
+{
+    const double seconds = ( 0 < mTime ? mTime / 1e6 : 1e-6 );
+
+    sLog.Log( "CaptureDecoder", "Decoded %u of %lu captures in %.2f s by %lu row groups.",
+              mSucceeded, mCaptures.size(), mTime / 1e6, (unsigned long)mTotals.groups );
+    sLog.Log( "CaptureDecoder", "%" PRIu64 " packets (%" PRIu64 " not decoded), %.0f packets/s.",
+              mTotals.packets, mTotals.undecoded, mTotals.packets / seconds );
+    sLog.Log( "CaptureDecoder", "%.2f MiB on the wire, %.2f MiB inflated, %.2f MiB/s.",
+              mTotals.bytes / 1048576.0, mTotals.rawBytes / 1048576.0, mTotals.bytes / 1048576.0 / seconds );
+}
+
+bool CaptureDecoder::_Decode( const std::string& filename, Totals& totals )
+{
+    PacketCapture::Reader reader;
+    if( !reader.Open( filename.c_str() ) )
+        return false;
+
+    // the calls, by direction and callID
+    std::map<uint64, Pending> pending;
+    // services which bound the objects, by bind string
+    std::map<std::string, std::string> services;
+
+    RowGroup group( filename );
+    PacketCapture::Record record;
+    while( reader.Read( record ) )
+    {
+        RowGroup::Row row;
+        row.time = record.time;
+        row.direction = record.direction;
+        row.type = NOT_PACKET;
+        row.callID = 0;
+        row.size = record.data.size();
+        row.rawSize = record.data.size();
+        row.service = 0;
+        row.method = 0;
+        row.latency = 0;
+
+        // the login handshake does not consist of packets
+        size_t rawSize = 0;
+        PyRep* rep = InflateUnmarshal( record.data, &rawSize );
+        if( NULL != rep )
+            row.rawSize = rawSize;
+
+        PyPacket* packet = NULL;
+        if( NULL != rep && rep->IsObject() )
+        {
+            packet = new PyPacket;
+            if( !packet->Decode( &rep ) )
+                SafeDelete( packet );
+        }
+        else
+            PySafeDecRef( rep );
+
+        if( NULL == packet )
+            ++totals.undecoded;
+        else
+        {
+            row.type = packet->type;
+
+            if( CALL_REQ == packet->type )
+            {
+                row.callID = packet->source.callID;
+
+                PyCallStream stream;
+                if( stream.Decode( packet->type_string, packet->payload ) )
+                {
+                    Pending call;
+                    call.time = record.time;
+                    call.method = stream.method;
+
+                    if( packet->dest.service.empty() )
+                    {
+                        std::map<std::string, std::string>::const_iterator res = services.find( stream.remoteObjectStr );
+                        call.service = ( services.end() != res ? res->second : "bound" );
+                    }
+                    else
+                        call.service = packet->dest.service;
+
+                    row.service = group.Intern( call.service );
+                    row.method = group.Intern( call.method );
+
+                    pending[ ( row.callID << 1 ) | record.direction ] = call;
+                }
+            }
+            else if( CALL_RSP == packet->type || ERRORRESPONSE == packet->type )
+            {
+                row.callID = packet->dest.callID;
+
+                // responses go the other way than their calls
+                std::map<uint64, Pending>::iterator res = pending.find( ( row.callID << 1 ) | ( PacketCapture::INBOUND == record.direction ? PacketCapture::OUTBOUND : PacketCapture::INBOUND ) );
+                if( pending.end() != res )
+                {
+                    const Pending& call = res->second;
+
+                    row.service = group.Intern( call.service );
+                    row.method = group.Intern( call.method );
+                    row.latency = record.time - call.time;
+
+                    if( CALL_RSP == packet->type && NULL != packet->payload )
+                    {
+                        // bound objects are named after the service which bound them
+                        std::vector<std::string> binds;
+                        BindCollector collector( binds );
+                        packet->payload->visit( collector );
+
+                        for( size_t i = 0; i < binds.size(); ++i )
+                            services[ binds[ i ] ] = call.service;
+                    }
+
+                    pending.erase( res );
+                }
+            }
+            else
+                row.service = group.Intern( packet->dest.service );
+
+            SafeDelete( packet );
+        }
+
+        ++totals.packets;
+        totals.bytes += row.size;
+        totals.rawBytes += row.rawSize;
+
+        group.Add( row );
+        if( GROUP_ROWS <= group.size() && !_Flush( group, totals ) )
+            return false;
+    }
+
+    return 0 == group.size() || _Flush( group, totals );
+}
+
+bool CaptureDecoder::_Flush( RowGroup& group, Totals& totals )
+{
+    // encoded outside the lock, so the threads only wait for the writes
+    Buffer data;
+    group.Encode( data );
+    group.Clear();
+
+    MutexLock lock( mMutex );
+
+    if( NULL == mOutput || 1 != fwrite( &data[ 0 ], data.size(), 1, mOutput ) )
+    {
+        sLog.Error( "CaptureDecoder", "Failed to write a row group." );
+        return false;
+    }
+
+    ++totals.groups;
+    return true;
+}
+
+void CaptureDecoder::_Work()
+{
+    while( true )
+    {
+        // the captures are taken in order, one at a time
+        const uint32 index = AtomicAdd( &mTaken, 1 ) - 1;
+        if( mCaptures.size() <= index )
+            break;
+
+        const std::string& filename = mCaptures[ index ];
+
+        Totals totals;
+        const bool success = _Decode( filename, totals );
+
+        if( success )
+        {
+            sLog.Success( "CaptureDecoder", "Decoded %" PRIu64 " packets of '%s'.", totals.packets, filename.c_str() );
+            AtomicAdd( &mSucceeded, 1 );
+        }
+        else
+            sLog.Error( "CaptureDecoder", "Decoding of '%s' failed.", filename.c_str() );
+
+        MutexLock lock( mMutex );
+        mTotals += totals;
+    }
+}
+
+#ifdef WIN32
+DWORD WINAPI CaptureDecoder::WorkerLoop( LPVOID arg )
+#else /* !WIN32 */
+void* CaptureDecoder::WorkerLoop( void* arg )
+#endif /* !WIN32 */
+{
+    CaptureDecoder* decoder = reinterpret_cast< CaptureDecoder* >( arg );
+    assert( decoder != NULL );
+
+    decoder->_Work();
+
+#ifdef WIN32
+    return 0;
+#else /* !WIN32 */
+    return NULL;
+#endif /* !WIN32 */
+}
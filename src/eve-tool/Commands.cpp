@@ -25,18 +25,32 @@
 
 #include "eve-tool.h"
 
+#include "CacheConverter.h"
+#include "CaptureDecoder.h"
 #include "Commands.h"
+#include "DestinyBench.h"
+#include "MarketBench.h"
+#include "PacketReplay.h"
+#include "UniverseSeeder.h"
 
 /************************************************************************/
 /* Commands declaration                                                 */
 /************************************************************************/
+void DecodeCaptures( const Seperator& cmd );
 void DestinyDumpLogText( const Seperator& cmd );
+void DestinyBenchmark( const Seperator& cmd );
+void DestinyDiff( const Seperator& cmd );
 void CRC32Text( const Seperator& cmd );
 void ExitProgram( const Seperator& cmd );
 void PrintHelp( const Seperator& cmd );
 void ObjectToSQL( const Seperator& cmd );
+void ObjectsToSQL( const Seperator& cmd );
 void PrintTimeNow( const Seperator& cmd );
+void ReplayCapture( const Seperator& cmd );
 void LoadScript( const Seperator& cmd );
+void MarketBenchmark( const Seperator& cmd );
+void SeedUniverse( const Seperator& cmd );
+void StaticDataSnapshot( const Seperator& cmd );
 void TimeToString( const Seperator& cmd );
 void TriToOBJ( const Seperator& cmd );
 void UnmarshalLogText( const Seperator& cmd );
@@ -47,17 +61,25 @@ void StuffExtract( const Seperator& cmd );
 /************************************************************************/
 const EVEToolCommand EVETOOL_COMMANDS[] =
 {
-    { "destiny",   &DestinyDumpLogText, "Converts given string to binary and dumps it as destiny binary." },
-    { "crc32",     &CRC32Text,          "Computes CRC-32 checksum of given arguments."                    },
-    { "exit",      &ExitProgram,        "Quits current session."                                          },
-    { "help",      &PrintHelp,          "Lists available commands or prints help about specified one."    },
-    { "now",       &PrintTimeNow,       "Prints current time in Win32 time format."                       },
-    { "obj2sql",   &ObjectToSQL,        "Converts specified cache object into an SQL update."             },
-    { "script",    &LoadScript,         "Loads input from specified file(s)."                             },
-    { "time",      &TimeToString,       "Interprets given integer as Win32 time."                         },
-    { "tri2obj",   &TriToOBJ,           "Dumps specified TRI file."                                       },
-    { "unmarshal", &UnmarshalLogText,   "Converts given string to binary and unmarshals it."              },
-    { "xstuff",    &StuffExtract,       "Dumps specified STUFF file."                                     }
+    { "decode",       &DecodeCaptures,     "Decodes client captures in parallel into a columnar file."           },
+    { "destiny",      &DestinyDumpLogText, "Converts given string to binary and dumps it as destiny binary."     },
+    { "destinybench", &DestinyBenchmark,   "Encodes and decodes random destiny binaries and reports their cost." },
+    { "destinydiff",  &DestinyDiff,        "Compares two destiny binaries ball by ball and field by field."      },
+    { "crc32",        &CRC32Text,          "Computes CRC-32 checksum of given arguments."                        },
+    { "exit",         &ExitProgram,        "Quits current session."                                              },
+    { "help",         &PrintHelp,          "Lists available commands or prints help about specified one."        },
+    { "marketbench",  &MarketBenchmark,    "Replays market calls against given database and reports their cost." },
+    { "now",          &PrintTimeNow,       "Prints current time in Win32 time format."                           },
+    { "obj2sql",      &ObjectToSQL,        "Converts specified cache object into an SQL update."                 },
+    { "obj2sqlall",   &ObjectsToSQL,       "Converts cache objects listed by obj2sql script in parallel."        },
+    { "replay",       &ReplayCapture,      "Replays client capture against given server by many clients."        },
+    { "script",       &LoadScript,         "Loads input from specified file(s)."                                 },
+    { "seed",         &SeedUniverse,       "Generates a synthetic universe of given size for bulk loading."      },
+    { "snapshot",     &StaticDataSnapshot, "Writes static inventory data of given database into a file."         },
+    { "time",         &TimeToString,       "Interprets given integer as Win32 time."                             },
+    { "tri2obj",      &TriToOBJ,           "Dumps specified TRI file."                                           },
+    { "unmarshal",    &UnmarshalLogText,   "Unmarshals given strings or the packets of a capture (@file)."       },
+    { "xstuff",       &StuffExtract,       "Dumps specified STUFF file."                                         }
 };
 const size_t EVETOOL_COMMAND_COUNT = ( sizeof( EVETOOL_COMMANDS ) / sizeof( EVEToolCommand ) );
 
@@ -93,6 +115,32 @@ void ProcessCommand( const Seperator& cmd )
 /************************************************************************/
 /* Commands implementation                                              */
 /************************************************************************/
+void DecodeCaptures( const Seperator& cmd )
+{
+    const char* cmdName = cmd.arg( 0 ).c_str();
+
+    if( 4 > cmd.argCount() )
+    {
+        sLog.Error( cmdName, "Usage: %s output-file threads capture-file [capture-file] ...", cmdName );
+        return;
+    }
+
+    const uint32 threads = atoi( cmd.arg( 2 ).c_str() );
+    if( 0 == threads )
+    {
+        sLog.Error( cmdName, "The number of threads must be positive." );
+        return;
+    }
+
+    CaptureDecoder decoder;
+    for( size_t i = 3; i < cmd.argCount(); ++i )
+        decoder.Add( cmd.arg( i ) );
+
+    sLog.Log( cmdName, "Decoding %lu captures by %u threads.", decoder.size(), threads );
+    decoder.Run( cmd.arg( 1 ).c_str(), threads );
+    decoder.Report();
+}
+
 void DestinyDumpLogText( const Seperator& cmd )
 {
     const char* cmdName = cmd.arg( 0 ).c_str();
@@ -118,6 +166,60 @@ void DestinyDumpLogText( const Seperator& cmd )
     }
 }
 
+void DestinyBenchmark( const Seperator& cmd )
+{
+    const char* cmdName = cmd.arg( 0 ).c_str();
+
+    if( 4 < cmd.argCount() )
+    {
+        sLog.Error( cmdName, "Usage: %s [ball-count] [rounds] [seed]", cmdName );
+        return;
+    }
+
+    const size_t ballCount = ( 2 <= cmd.argCount() ? atoi( cmd.arg( 1 ).c_str() ) : 1000 );
+    const size_t rounds = ( 3 <= cmd.argCount() ? atoi( cmd.arg( 2 ).c_str() ) : 1000 );
+    const uint32 seed = ( 4 == cmd.argCount() ? atoi( cmd.arg( 3 ).c_str() ) : 1 );
+
+    DestinyBench bench;
+    bench.Generate( ballCount, seed );
+
+    sLog.Log( cmdName, "Benchmarking %lu balls.", bench.size() );
+    if( bench.Run( rounds, rounds ) )
+        bench.Report();
+}
+
+void DestinyDiff( const Seperator& cmd )
+{
+    const char* cmdName = cmd.arg( 0 ).c_str();
+
+    if( 3 != cmd.argCount() )
+    {
+        sLog.Error( cmdName, "Usage: %s destiny-binary-before destiny-binary-after", cmdName );
+        return;
+    }
+
+    Destiny::State states[2];
+    for( size_t i = 0; i < 2; ++i )
+    {
+        Buffer destinyBinary;
+        if( !PyDecodeEscape( cmd.arg( 1 + i ).c_str(), destinyBinary ) )
+        {
+            sLog.Error( cmdName, "Failed to decode destiny binary." );
+            return;
+        }
+
+        if( !states[i].Decode( &destinyBinary[0], destinyBinary.size() ) )
+        {
+            sLog.Error( cmdName, "Malformed destiny binary %lu.", 1 + i );
+            return;
+        }
+    }
+
+    const size_t diffs = Destiny::State::Diff( DESTINY__MESSAGE, states[0], states[1] );
+    sLog.Log( cmdName, "%lu balls before, %lu balls after, %lu differences.",
+              states[0].balls().size(), states[1].balls().size(), diffs );
+}
+
 void CRC32Text( const Seperator& cmd )
 {
     const char* cmdName = cmd.arg( 0 ).c_str();
@@ -185,56 +287,49 @@ void ObjectToSQL( const Seperator& cmd )
 {
     const char* cmdName = cmd.arg( 0 ).c_str();
 
-    if( 5 != cmd.argCount() )
+    if( 5 != cmd.argCount() && 6 != cmd.argCount() )
     {
-        sLog.Error( cmdName, "Usage: %s [cache_file] [table_name] [key_field] [file_name]", cmdName );
+        sLog.Error( cmdName, "Usage: %s [cache_file] [table_name] [key_field] [file_name] [data_file]", cmdName );
         return;
     }
-    const std::string& cacheFile = cmd.arg( 1 );
-    const std::string& tableName = cmd.arg( 2 );
-    const std::string& keyField = cmd.arg( 3 );
-    const std::string& fileName = cmd.arg( 4 );
 
-    std::string abs_fname( "../data/cache/" );
-    abs_fname += cacheFile;
-    abs_fname += ".cache";
+    CacheConverter::Convert( cmd.arg( 1 ), cmd.arg( 2 ), cmd.arg( 3 ), cmd.arg( 4 ),
+                             6 == cmd.argCount() ? cmd.arg( 5 ).c_str() : NULL );
+}
 
-    sLog.Log( cmdName, "Converting cached object %s:\n", abs_fname.c_str() );
+void ObjectsToSQL( const Seperator& cmd )
+{
+    const char* cmdName = cmd.arg( 0 ).c_str();
 
-    CachedObjectMgr mgr;
-    PyCachedObjectDecoder* obj = mgr.LoadCachedObject( abs_fname.c_str(), cacheFile.c_str() );
-    if( obj == NULL )
+    if( 2 > cmd.argCount() || 4 < cmd.argCount() )
     {
-        sLog.Error( cmdName, "Unable to load or decode '%s'!", abs_fname.c_str() );
+        sLog.Error( cmdName, "Usage: %s script-file [threads] [bulk]", cmdName );
         return;
     }
 
-    obj->cache->DecodeData();
-    if( obj->cache->decoded() == NULL )
+    const uint32 threads = ( 3 <= cmd.argCount() ? atoi( cmd.arg( 2 ).c_str() ) : 4 );
+    const bool bulk = ( 4 == cmd.argCount() && "bulk" == cmd.arg( 3 ) );
+    if( 0 == threads || ( 4 == cmd.argCount() && !bulk ) )
     {
-        sLog.Error( cmdName, "Unable to load or decode body of '%s'!", abs_fname.c_str() );
-
-        SafeDelete( obj );
+        sLog.Error( cmdName, "The number of threads must be positive; the last argument may only be 'bulk'." );
         return;
     }
 
-    FILE* out = fopen( fileName.c_str(), "w" );
-    if( out == NULL )
-    {
-        sLog.Error( cmdName, "Unable to open output file '%s'", fileName.c_str() );
-
-        SafeDelete( obj );
+    CacheConverter converter;
+    const std::string& filename = cmd.arg( 1 );
+    if( !converter.LoadScript( filename.c_str() ) )
         return;
-    }
 
-    SetSQLDumper dumper( tableName.c_str(), keyField.c_str(), out );
-    if( obj->cache->decoded()->visit( dumper ) )
-        sLog.Success( cmdName, "Dumping of %s succeeded.", tableName.c_str() );
-    else
-        sLog.Error( cmdName, "Dumping of %s failed.", tableName.c_str() );
+    sLog.Log( cmdName, "Converting %lu cached objects by %u threads.", converter.size(), threads );
+
+    const uint64 start = GetTimeUSeconds();
+    const size_t succeeded = converter.Run( threads, bulk );
+    const uint64 time = GetTimeUSeconds() - start;
 
-    fclose( out );
-    SafeDelete( obj );
+    if( succeeded == converter.size() )
+        sLog.Success( cmdName, "Converted %lu cached objects in %.2f s.", succeeded, time / 1e6 );
+    else
+        sLog.Error( cmdName, "Converted %lu of %lu cached objects in %.2f s.", succeeded, converter.size(), time / 1e6 );
 }
 
 void LoadScript( const Seperator& cmd )
@@ -251,6 +346,165 @@ void LoadScript( const Seperator& cmd )
         ProcessFile( cmd.arg( i ) );
 }
 
+void MarketBenchmark( const Seperator& cmd )
+{
+    const char* cmdName = cmd.arg( 0 ).c_str();
+
+    if( 6 > cmd.argCount() || 8 < cmd.argCount() )
+    {
+        sLog.Error( cmdName, "Usage: %s calls|stream-file host user password database [port] [seed]", cmdName );
+        return;
+    }
+
+    const int16 port = ( 7 <= cmd.argCount() ? atoi( cmd.arg( 6 ).c_str() ) : 3306 );
+    const uint32 seed = ( 8 == cmd.argCount() ? atoi( cmd.arg( 7 ).c_str() ) : 1 );
+
+    DBerror err;
+    if( !sDatabase.Open( err,
+                         cmd.arg( 2 ).c_str(),
+                         cmd.arg( 3 ).c_str(),
+                         cmd.arg( 4 ).c_str(),
+                         cmd.arg( 5 ).c_str(),
+                         port ) )
+    {
+        sLog.Error( cmdName, "Unable to connect to the database: %s", err.c_str() );
+        return;
+    }
+
+    // a number asks for a synthetic stream, anything else is a recorded one
+    MarketBench bench;
+    const std::string& source = cmd.arg( 1 );
+    if( cmd.isNumber( 1 ) ? !bench.Generate( atoi( source.c_str() ), seed )
+                          : !bench.LoadStream( source.c_str() ) )
+    {
+        sLog.Error( cmdName, "Failed to prepare the calls from '%s'.", source.c_str() );
+        return;
+    }
+
+    sLog.Log( cmdName, "Replaying %lu calls.", bench.size() );
+    if( bench.Run() )
+        bench.Report();
+
+    bench.Cleanup();
+}
+
+void ReplayCapture( const Seperator& cmd )
+{
+    const char* cmdName = cmd.arg( 0 ).c_str();
+
+    if( 7 != cmd.argCount() && 8 != cmd.argCount() )
+    {
+        sLog.Error( cmdName, "Usage: %s capture-file host port clients user-prefix password [speed]", cmdName );
+        return;
+    }
+
+    const uint16 port = atoi( cmd.arg( 3 ).c_str() );
+    const uint32 clients = atoi( cmd.arg( 4 ).c_str() );
+    const double speed = ( 8 == cmd.argCount() ? atof( cmd.arg( 7 ).c_str() ) : 1.0 );
+    if( 0 == clients || 0 >= speed )
+    {
+        sLog.Error( cmdName, "The number of clients and the speed must be positive." );
+        return;
+    }
+
+    char errbuf[ ERRBUF_SIZE ];
+    const uint32 address = ResolveIP( cmd.arg( 2 ).c_str(), errbuf );
+    if( 0 == address )
+    {
+        sLog.Error( cmdName, "Unable to resolve '%s': %s", cmd.arg( 2 ).c_str(), errbuf );
+        return;
+    }
+
+    PacketReplay replay;
+    const std::string& filename = cmd.arg( 1 );
+    if( !replay.Load( filename.c_str() ) )
+    {
+        sLog.Error( cmdName, "Failed to load the capture '%s'.", filename.c_str() );
+        return;
+    }
+
+    sLog.Log( cmdName, "Replaying %lu packets by %u clients.", replay.size(), clients );
+    replay.Run( address, port, clients, cmd.arg( 5 ), cmd.arg( 6 ), speed );
+    replay.Report();
+}
+
+void SeedUniverse( const Seperator& cmd )
+{
+    const char* cmdName = cmd.arg( 0 ).c_str();
+
+    if( 11 > cmd.argCount() || 13 < cmd.argCount() )
+    {
+        sLog.Error( cmdName, "Usage: %s output-prefix threads characters corporations orders mails host user password database [port] [seed]", cmdName );
+        return;
+    }
+
+    const uint32 threads = atoi( cmd.arg( 2 ).c_str() );
+    if( 0 == threads )
+    {
+        sLog.Error( cmdName, "The number of threads must be positive." );
+        return;
+    }
+
+    UniverseSeeder::Parameters params;
+    params.characters = atoi( cmd.arg( 3 ).c_str() );
+    params.corporations = atoi( cmd.arg( 4 ).c_str() );
+    params.orders = atoi( cmd.arg( 5 ).c_str() );
+    params.mails = atoi( cmd.arg( 6 ).c_str() );
+    if( 13 == cmd.argCount() )
+        params.seed = atoi( cmd.arg( 12 ).c_str() );
+
+    const int16 port = ( 12 <= cmd.argCount() ? atoi( cmd.arg( 11 ).c_str() ) : 3306 );
+
+    DBerror err;
+    if( !sDatabase.Open( err,
+                         cmd.arg( 7 ).c_str(),
+                         cmd.arg( 8 ).c_str(),
+                         cmd.arg( 9 ).c_str(),
+                         cmd.arg( 10 ).c_str(),
+                         port ) )
+    {
+        sLog.Error( cmdName, "Unable to connect to the database: %s", err.c_str() );
+        return;
+    }
+
+    UniverseSeeder seeder;
+    if( !seeder.LoadStaticData() )
+        return;
+
+    sLog.Log( cmdName, "Generating %u characters, %u corporations, %u orders and %u mails by %u threads.",
+              params.characters, params.corporations, params.orders, params.mails, threads );
+    seeder.Generate( cmd.arg( 1 ), params, threads );
+}
+
+void StaticDataSnapshot( const Seperator& cmd )
+{
+    const char* cmdName = cmd.arg( 0 ).c_str();
+
+    if( 6 != cmd.argCount() && 7 != cmd.argCount() )
+    {
+        sLog.Error( cmdName, "Usage: %s file host user password database [port]", cmdName );
+        return;
+    }
+
+    const int16 port = ( 7 == cmd.argCount() ? atoi( cmd.arg( 6 ).c_str() ) : 3306 );
+
+    DBerror err;
+    if( !sDatabase.Open( err,
+                         cmd.arg( 2 ).c_str(),
+                         cmd.arg( 3 ).c_str(),
+                         cmd.arg( 4 ).c_str(),
+                         cmd.arg( 5 ).c_str(),
+                         port ) )
+    {
+        sLog.Error( cmdName, "Unable to connect to the database: %s", err.c_str() );
+        return;
+    }
+
+    const std::string& filename = cmd.arg( 1 );
+    if( BuildStaticDataSnapshot( filename.c_str() ) )
+        sLog.Success( cmdName, "Static data snapshot written to '%s'.", filename.c_str() );
+}
+
 void TimeToString( const Seperator& cmd )
 {
     const char* cmdName = cmd.arg( 0 ).c_str();
@@ -305,7 +559,7 @@ void UnmarshalLogText( const Seperator& cmd )
 
     if( 1 == cmd.argCount() )
     {
-        sLog.Error( cmdName, "Usage: %s marshal-binary [marshal-binary] ...", cmdName );
+        sLog.Error( cmdName, "Usage: %s marshal-binary|@capture-file [marshal-binary|@capture-file] ...", cmdName );
         return;
     }
 
@@ -313,6 +567,32 @@ void UnmarshalLogText( const Seperator& cmd )
     {
         const std::string& marshalBinaryStr = cmd.arg( i );
 
+        // captures and packet traces hold marshalled packets
+        if( 0 == marshalBinaryStr.compare( 0, 1, "@" ) )
+        {
+            std::vector<PacketCapture::Record> records;
+            if( !PacketCapture::Load( marshalBinaryStr.c_str() + 1, records ) )
+                continue;
+
+            for( size_t j = 0; j < records.size(); ++j )
+            {
+                const PacketCapture::Record& record = records[ j ];
+                const char* direction = ( PacketCapture::INBOUND == record.direction ? "in" : "out" );
+
+                PyRep* r = InflateUnmarshal( record.data );
+                if( NULL == r )
+                    sLog.Error( cmdName, "%.6f s %s: Failed to unmarshal %lu bytes.", record.time / 1000000.0, direction, (unsigned long)record.data.size() );
+                else
+                {
+                    sLog.Success( cmdName, "%.6f s %s:", record.time / 1000000.0, direction );
+                    r->Dump( stdout, "    " );
+
+                    PyDecRef( r );
+                }
+            }
+            continue;
+        }
+
         Buffer marshalBinary;
         if( !PyDecodeEscape( marshalBinaryStr.c_str(), marshalBinary ) )
         {
@@ -0,0 +1,217 @@
+/*
+    ------------------------------------------------------------------------------------
+    LICENSE:
+    ------------------------------------------------------------------------------------
+    This file is part of EVEmu: EVE Online Server Emulator
+    Copyright 2006 - 2011 The EVEmu Team
+    For the latest information visit http://evemu.org
+    ------------------------------------------------------------------------------------
+    This program is free software; you can redistribute it and/or modify it under
+    the terms of the GNU Lesser General Public License as published by the Free Software
+    Foundation; either version 2 of the License, or (at your option) any later
+    version.
+
+    This program is distributed in the hope that it will be useful, but WITHOUT
+    ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+    FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public License along with
+    this program; if not, write to the Free Software Foundation, Inc., 59 Temple
+    Place - Suite 330, Boston, MA 02111-1307, USA, or go to
+    http://www.gnu.org/copyleft/lesser.txt.
+    ------------------------------------------------------------------------------------
+    Author:     EVEmu Team
+*/
+
+
+#include "eve-tool.h"
+
+#include "DestinyBench.h"
+
+/// The modes a binary may have.
+static const uint8 BALL_MODES[] =
+{
+    Destiny::DSTBALL_GOTO,
+    Destiny::DSTBALL_FOLLOW,
+    Destiny::DSTBALL_STOP,
+    Destiny::DSTBALL_WARP,
+    Destiny::DSTBALL_ORBIT,
+    Destiny::DSTBALL_MISSILE,
+    Destiny::DSTBALL_MUSHROOM,
+    Destiny::DSTBALL_TROLL,
+    Destiny::DSTBALL_FIELD,
+    Destiny::DSTBALL_RIGID,
+    Destiny::DSTBALL_FORMATION
+};
+static const size_t BALL_MODE_COUNT = sizeof( BALL_MODES ) / sizeof( uint8 );
+
+/// Half of the size of the generated space, in meters.
+static const double SPACE_EXTENT = 1.0e12;
+
+DestinyBench::DestinyBench()
+: mSeed( 1 ),
+  mRounds( 0 ),
+  mBinarySize( 0 ),
+  mEncodeTime( 0 ),
+  mDecodeTime( 0 ),
+  mMutations( 0 ),
+  mRejected( 0 )
+{
+}
+
+void DestinyBench::Generate( size_t count, uint32 seed )
+{
+    mSeed = seed;
+
+    mState.clear();
+    mState.SetHeader( 0, _Random() );
+
+    for( size_t i = 0; i < count; ++i )
+    {
+        Destiny::Ball ball;
+        memset( &ball.head, 0, sizeof( ball.head ) );
+        memset( &ball.mass, 0, sizeof( ball.mass ) );
+        memset( &ball.ship, 0, sizeof( ball.ship ) );
+        memset( &ball.specific, 0, sizeof( ball.specific ) );
+
+        ball.head.entityID = 140000000 + i;
+        ball.head.mode = BALL_MODES[ _Random() % BALL_MODE_COUNT ];
+        ball.head.radius = (float)_Random( 10.0, 5000.0 );
+        ball.head.x = _Random( -SPACE_EXTENT, SPACE_EXTENT );
+        ball.head.y = _Random( -SPACE_EXTENT, SPACE_EXTENT );
+        ball.head.z = _Random( -SPACE_EXTENT, SPACE_EXTENT );
+        ball.head.sub_type = _Random() & ( Destiny::IsFree | Destiny::IsGlobal | Destiny::IsMassive
+                                           | Destiny::IsInteractive | Destiny::HasMiniBalls );
+
+        ball.hasMass = ( Destiny::DSTBALL_RIGID != ball.head.mode );
+        ball.mass.mass = _Random( 1.0e3, 1.0e9 );
+        ball.mass.cloak = _Random() % 2;
+        ball.mass.allianceID = _Random();
+        ball.mass.corpID = _Random();
+        ball.mass.Harmonic = (float)_Random( -1.0, 1.0 );
+
+        ball.hasShip = ( 0 != ( ball.head.sub_type & Destiny::IsFree ) );
+        ball.ship.max_speed = (float)_Random( 0.0, 5000.0 );
+        ball.ship.velocity_x = _Random( -5000.0, 5000.0 );
+        ball.ship.velocity_y = _Random( -5000.0, 5000.0 );
+        ball.ship.velocity_z = _Random( -5000.0, 5000.0 );
+        ball.ship.agility = (float)_Random( 0.1, 10.0 );
+        ball.ship.speed_fraction = (float)_Random( 0.0, 1.0 );
+
+        // fill the sector with random bytes; every field of every mode gets a value
+        uint8* specific = reinterpret_cast< uint8* >( &ball.specific );
+        for( size_t j = 0; j < Destiny::State::GetModeSize( ball.head.mode ); ++j )
+            specific[ j ] = (uint8)_Random();
+
+        if( 0 != ( ball.head.sub_type & Destiny::HasMiniBalls ) )
+        {
+            ball.miniBalls.resize( _Random() % 4 );
+            for( size_t j = 0; j < ball.miniBalls.size(); ++j )
+            {
+                Destiny::MiniBall& mini = ball.miniBalls[ j ];
+                mini.x = _Random( -1.0e4, 1.0e4 );
+                mini.y = _Random( -1.0e4, 1.0e4 );
+                mini.z = _Random( -1.0e4, 1.0e4 );
+                mini.radius = (float)_Random( 100.0, 5000.0 );
+            }
+        }
+
+        ball.name.resize( _Random() % 32 );
+        for( size_t j = 0; j < ball.name.size(); ++j )
+            ball.name[ j ] = 'A' + _Random() % 26;
+
+        mState.AddBall( ball );
+    }
+}
+
+bool DestinyBench::Run( size_t rounds, size_t mutations )
+{
+    mRounds = rounds;
+    mEncodeTime = 0;
+    mDecodeTime = 0;
+    mMutations = mutations;
+    mRejected = 0;
+
+    Buffer binary;
+    mState.Encode( binary );
+    mBinarySize = binary.size();
+
+    Destiny::State decoded;
+    if( !decoded.Decode( &binary[0], binary.size() )
+        || 0 != Destiny::State::Diff( DESTINY__ERROR, mState, decoded ) )
+    {
+        sLog.Error( "DestinyBench", "Decoded state differs from the generated one." );
+        return false;
+    }
+
+    for( size_t i = 0; i < rounds; ++i )
+    {
+        Buffer encoded;
+        encoded.Reserve<uint8>( mBinarySize );
+
+        uint64 start = GetTimeUSeconds();
+        mState.Encode( encoded );
+        mEncodeTime += GetTimeUSeconds() - start;
+
+        start = GetTimeUSeconds();
+        const bool success = decoded.Decode( &encoded[0], encoded.size() );
+        mDecodeTime += GetTimeUSeconds() - start;
+
+        if( !success || decoded.balls().size() != mState.balls().size() )
+        {
+            sLog.Error( "DestinyBench", "Failed to decode the binary in round %lu.", i );
+            return false;
+        }
+    }
+
+    // decode copies with flipped bytes or cut short; they may not crash nor overrun
+    for( size_t i = 0; i < mutations; ++i )
+    {
+        Buffer mutated( binary.begin<uint8>(), binary.end<uint8>() );
+
+        if( 0 == i % 2 )
+        {
+            const size_t flips = 1 + _Random() % 8;
+            for( size_t j = 0; j < flips; ++j )
+                mutated[ _Random() % mutated.size() ] ^= (uint8)( 1 + _Random() % 0xFF );
+        }
+        else
+            mutated.Resize<uint8>( _Random() % mutated.size() );
+
+        // a truncated buffer is copied so that reading past it is caught by memory checkers
+        std::vector< uint8 > data( mutated.begin<uint8>(), mutated.end<uint8>() );
+        if( data.empty() || !decoded.Decode( &data[0], data.size() ) )
+            ++mRejected;
+    }
+
+    return true;
+}
+
+void DestinyBench::Report() const
+{
+    const size_t balls = mState.balls().size();
+    const double encodeSeconds = mEncodeTime / 1000000.0;
+    const double decodeSeconds = mDecodeTime / 1000000.0;
+    const double megabytes = (double)mBinarySize * mRounds / ( 1024.0 * 1024.0 );
+
+    sLog.Log( "DestinyBench", "%lu balls, %lu bytes per binary, %lu rounds.", balls, mBinarySize, mRounds );
+    if( 0 < mEncodeTime )
+        sLog.Log( "DestinyBench", "Encode: %.3f s, %.0f balls/s, %.1f MB/s.",
+                  encodeSeconds, balls * mRounds / encodeSeconds, megabytes / encodeSeconds );
+    if( 0 < mDecodeTime )
+        sLog.Log( "DestinyBench", "Decode: %.3f s, %.0f balls/s, %.1f MB/s.",
+                  decodeSeconds, balls * mRounds / decodeSeconds, megabytes / decodeSeconds );
+    sLog.Log( "DestinyBench", "Mutations: %lu decoded, %lu rejected.", mMutations, mRejected );
+}
+
+uint32 DestinyBench::_Random()
+{
+    // the LCG of Numerical Recipes; deterministic across platforms unlike rand()
+    mSeed = mSeed * 1664525 + 1013904223;
+    return mSeed >> 8;
+}
+
+double DestinyBench::_Random( double min, double max )
+{
+    return min + ( max - min ) * ( _Random() / (double)( 1 << 24 ) );
+}
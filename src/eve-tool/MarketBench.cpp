@@ -0,0 +1,747 @@
+/*
+    ------------------------------------------------------------------------------------
+    LICENSE:
+    ------------------------------------------------------------------------------------
+    This file is part of EVEmu: EVE Online Server Emulator
+    Copyright 2006 - 2011 The EVEmu Team
+    For the latest information visit http://evemu.org
+    ------------------------------------------------------------------------------------
+    This program is free software; you can redistribute it and/or modify it under
+    the terms of the GNU Lesser General Public License as published by the Free Software
+    Foundation; either version 2 of the License, or (at your option) any later
+    version.
+
+    This program is distributed in the hope that it will be useful, but WITHOUT
+    ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+    FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public License along with
+    this program; if not, write to the Free Software Foundation, Inc., 59 Temple
+    Place - Suite 330, Boston, MA 02111-1307, USA, or go to
+    http://www.gnu.org/copyleft/lesser.txt.
+    ------------------------------------------------------------------------------------
+    Author:     EVEmu Team
+*/
+
+#include "eve-tool.h"
+
+#include "MarketBench.h"
+
+/// Values of market_transactions.transactionType.
+static const int TRANSACTION_TYPE_SELL = 0;
+static const int TRANSACTION_TYPE_BUY = 1;
+
+/// Most orders deleted by a single statement of Cleanup().
+static const size_t CLEANUP_BATCH_SIZE = 500;
+
+const char* const MarketBench::CALL_KIND_NAMES[ CALL_KIND_COUNT ] =
+{
+    "PlaceCharOrder",
+    "ModifyCharOrder",
+    "CancelCharOrder",
+    "GetOrders"
+};
+
+MarketBench::MarketBench()
+: mCharacterID( 0 ),
+  mStatements( 0 ),
+  mTrades( 0 ),
+  mMisses( 0 ),
+  mTotalTime( 0 )
+{
+}
+
+bool MarketBench::Generate( size_t count, uint32 seed )
+{
+    struct Station
+    {
+        uint32 stationID;
+        uint32 solarSystemID;
+    };
+    std::vector<Station> stations;
+    std::vector< std::pair<uint32, double> > types;
+
+    DBQueryResult res;
+    DBResultRow row;
+
+    // a handful of stations, so the books get deep enough to match
+    if( !sDatabase.RunQuery( res,
+        "SELECT stationID, solarSystemID"
+        " FROM staStations"
+        " ORDER BY stationID"
+        " LIMIT 8" ) )
+    {
+        sLog.Error( "MarketBench", "Failed to query stations: %s", res.error.c_str() );
+        return false;
+    }
+    while( res.GetRow( row ) )
+    {
+        Station s;
+        s.stationID = row.GetUInt( 0 );
+        s.solarSystemID = row.GetUInt( 1 );
+        stations.push_back( s );
+    }
+
+    if( !sDatabase.RunQuery( res,
+        "SELECT typeID, basePrice"
+        " FROM invTypes"
+        " WHERE marketGroupID IS NOT NULL"
+        "  AND published = 1"
+        " ORDER BY typeID"
+        " LIMIT 64" ) )
+    {
+        sLog.Error( "MarketBench", "Failed to query market types: %s", res.error.c_str() );
+        return false;
+    }
+    while( res.GetRow( row ) )
+        types.push_back( std::make_pair( row.GetUInt( 0 ), std::max( row.GetDouble( 1 ), 100.0 ) ) );
+
+    if( stations.empty() || types.empty() )
+    {
+        sLog.Error( "MarketBench", "The database has no stations or no market types." );
+        return false;
+    }
+
+    mCalls.clear();
+    ::srand( seed );
+
+    uint32 placeCount = 0;
+    for( size_t i = 0; i < count; ++i )
+    {
+        const Station& station = stations[ ::rand() % stations.size() ];
+        const std::pair<uint32, double>& type = types[ ::rand() % types.size() ];
+        const uint32 roll = ::rand() % 100;
+
+        Call call;
+        call.kind = CALL_GET_ORDERS;
+        call.stationID = station.stationID;
+        call.typeID = type.first;
+        call.bid = false;
+        call.price = 0.0;
+        call.quantity = 0;
+        call.placeIndex = -1;
+        call.orderID = 0;
+        call.solarSystemID = station.solarSystemID;
+
+        // half of the calls place orders; buys and sells are priced around
+        // the same base price, so about a half of them cross the book
+        if( 50 <= roll || 0 == placeCount )
+        {
+            call.kind = CALL_PLACE;
+            call.bid = ( 0 == ::rand() % 2 );
+            call.price = type.second * ( 0.9 + 0.2 * ::rand() / RAND_MAX );
+            call.quantity = 1 + ::rand() % 10;
+
+            ++placeCount;
+        }
+        else if( 35 <= roll )
+        {
+            call.kind = CALL_MODIFY;
+            call.placeIndex = ::rand() % placeCount;
+            call.price = type.second * ( 0.9 + 0.2 * ::rand() / RAND_MAX );
+        }
+        else if( 20 <= roll )
+        {
+            call.kind = CALL_CANCEL;
+            call.placeIndex = ::rand() % placeCount;
+        }
+
+        mCalls.push_back( call );
+    }
+
+    return _LoadCharacter();
+}
+
+bool MarketBench::LoadStream( const char* filename )
+{
+    FILE* file = fopen( filename, "r" );
+    if( NULL == file )
+    {
+        sLog.Error( "MarketBench", "Unable to open stream '%s'.", filename );
+        return false;
+    }
+
+    mCalls.clear();
+
+    bool success = true;
+    size_t lineNo = 0;
+    uint32 placeCount = 0;
+    char line[ 256 ];
+    while( success && NULL != fgets( line, sizeof( line ), file ) )
+    {
+        ++lineNo;
+
+        const Seperator sep( line, " \t\r\n" );
+        if( 0 == sep.argCount() || '#' == sep.arg( 0 )[0] )
+            continue;
+
+        Call call;
+        call.stationID = 0;
+        call.typeID = 0;
+        call.bid = false;
+        call.price = 0.0;
+        call.quantity = 0;
+        call.placeIndex = -1;
+        call.orderID = 0;
+        call.solarSystemID = 0;
+
+        const std::string& kind = sep.arg( 0 );
+        if( "place" == kind && 6 == sep.argCount() )
+        {
+            call.kind = CALL_PLACE;
+            call.stationID = atoi( sep.arg( 1 ).c_str() );
+            call.typeID = atoi( sep.arg( 2 ).c_str() );
+            call.bid = ( 0 != atoi( sep.arg( 3 ).c_str() ) );
+            call.price = atof( sep.arg( 4 ).c_str() );
+            call.quantity = atoi( sep.arg( 5 ).c_str() );
+
+            ++placeCount;
+        }
+        else if( ( "modify" == kind && 3 == sep.argCount() )
+                 || ( "cancel" == kind && 2 == sep.argCount() ) )
+        {
+            call.kind = ( "modify" == kind ? CALL_MODIFY : CALL_CANCEL );
+
+            const std::string& order = sep.arg( 1 );
+            if( '@' == order[0] )
+            {
+                call.placeIndex = atoi( order.c_str() + 1 );
+                if( call.placeIndex < 0 || (uint32)call.placeIndex >= placeCount )
+                {
+                    sLog.Error( "MarketBench", "%s:%lu: there is no place call %s before.", filename, lineNo, order.c_str() );
+                    success = false;
+                }
+            }
+            else
+                call.orderID = atoi( order.c_str() );
+
+            if( CALL_MODIFY == call.kind )
+                call.price = atof( sep.arg( 2 ).c_str() );
+        }
+        else if( "orders" == kind && 3 == sep.argCount() )
+        {
+            call.kind = CALL_GET_ORDERS;
+            call.solarSystemID = atoi( sep.arg( 1 ).c_str() );
+            call.typeID = atoi( sep.arg( 2 ).c_str() );
+        }
+        else
+        {
+            sLog.Error( "MarketBench", "%s:%lu: malformed call '%s'.", filename, lineNo, kind.c_str() );
+            success = false;
+        }
+
+        mCalls.push_back( call );
+    }
+
+    fclose( file );
+
+    return success && _LoadCharacter();
+}
+
+bool MarketBench::Run()
+{
+    // the place calls are numbered in the stream order, so that "@n" can be resolved
+    mPlacedOrders.clear();
+    for( size_t i = 0; i < CALL_KIND_COUNT; ++i )
+        mStats[ i ] = KindStats();
+    mTrades = 0;
+    mMisses = 0;
+
+    const uint64 start = GetTimeUSeconds();
+    for( size_t i = 0; i < mCalls.size(); ++i )
+    {
+        const Call& call = mCalls[ i ];
+
+        mStatements = 0;
+        const uint64 callStart = GetTimeUSeconds();
+
+        bool success = false;
+        switch( call.kind )
+        {
+            case CALL_PLACE:      success = _Place( call );     break;
+            case CALL_MODIFY:     success = _Modify( call );    break;
+            case CALL_CANCEL:     success = _Cancel( call );    break;
+            case CALL_GET_ORDERS: success = _GetOrders( call ); break;
+        }
+
+        KindStats& stats = mStats[ call.kind ];
+        stats.latencies.push_back( GetTimeUSeconds() - callStart );
+        stats.statements += mStatements;
+
+        if( !success )
+        {
+            sLog.Error( "MarketBench", "Call %lu (%s) failed, stopping.", i, CALL_KIND_NAMES[ call.kind ] );
+            mTotalTime = GetTimeUSeconds() - start;
+            return false;
+        }
+    }
+    mTotalTime = GetTimeUSeconds() - start;
+
+    return true;
+}
+
+void MarketBench::Report() const
+{
+    uint64 calls = 0;
+    uint64 statements = 0;
+
+    sLog.Log( "MarketBench", "Call: calls, p50 us, p99 us, max us, statements per call" );
+    for( size_t i = 0; i < CALL_KIND_COUNT; ++i )
+    {
+        std::vector<uint64> latencies = mStats[ i ].latencies;
+        if( latencies.empty() )
+            continue;
+        std::sort( latencies.begin(), latencies.end() );
+
+        const size_t n = latencies.size();
+        sLog.Log( "MarketBench", "%s: %lu, %" PRIu64 ", %" PRIu64 ", %" PRIu64 ", %.2f",
+                  CALL_KIND_NAMES[ i ], n,
+                  latencies[ ( n - 1 ) / 2 ],
+                  latencies[ ( n - 1 ) * 99 / 100 ],
+                  latencies[ n - 1 ],
+                  (double)mStats[ i ].statements / n );
+
+        calls += n;
+        statements += mStats[ i ].statements;
+    }
+
+    const double seconds = mTotalTime / 1000000.0;
+    sLog.Log( "MarketBench", "%" PRIu64 " calls in %.3f s: %.1f calls/s, %" PRIu64 " statements.",
+              calls, seconds, ( 0 < mTotalTime ? calls / seconds : 0.0 ), statements );
+    sLog.Log( "MarketBench", "%" PRIu64 " trades: %.2f statements per trade; %" PRIu64 " modify/cancel calls found no order.",
+              mTrades, ( 0 < mTrades ? (double)statements / mTrades : 0.0 ), mMisses );
+}
+
+void MarketBench::Cleanup()
+{
+    DBerror err;
+
+    for( size_t i = 0; i < mOrders.size(); i += CLEANUP_BATCH_SIZE )
+    {
+        std::string ids;
+        ListToINString( std::vector<uint32>( mOrders.begin() + i,
+                                             mOrders.begin() + std::min( i + CLEANUP_BATCH_SIZE, mOrders.size() ) ),
+                        ids, "0" );
+
+        if( !sDatabase.RunQuery( err, "DELETE FROM market_orders WHERE orderID IN (%s)", ids.c_str() ) )
+            sLog.Error( "MarketBench", "Failed to delete the orders: %s", err.c_str() );
+    }
+    mOrders.clear();
+
+    for( size_t i = 0; i < mTransactions.size(); i += CLEANUP_BATCH_SIZE )
+    {
+        std::string ids;
+        ListToINString( std::vector<uint32>( mTransactions.begin() + i,
+                                             mTransactions.begin() + std::min( i + CLEANUP_BATCH_SIZE, mTransactions.size() ) ),
+                        ids, "0" );
+
+        if( !sDatabase.RunQuery( err, "DELETE FROM market_transactions WHERE transactionID IN (%s)", ids.c_str() ) )
+            sLog.Error( "MarketBench", "Failed to delete the transactions: %s", err.c_str() );
+    }
+    mTransactions.clear();
+
+    std::map<uint32, double>::const_iterator cur, end;
+    cur = mBalances.begin();
+    end = mBalances.end();
+    for(; cur != end; ++cur)
+    {
+        if( !sDatabase.RunQuery( err,
+            "UPDATE character_ SET balance = balance - %.2f WHERE characterID = %u",
+            cur->second, cur->first ) )
+        {
+            sLog.Error( "MarketBench", "Failed to restore balance of character %u: %s", cur->first, err.c_str() );
+        }
+    }
+    mBalances.clear();
+}
+
+bool MarketBench::_LoadCharacter()
+{
+    DBQueryResult res;
+    if( !sDatabase.RunQuery( res,
+        "SELECT characterID"
+        " FROM character_"
+        " ORDER BY characterID"
+        " LIMIT 1" ) )
+    {
+        sLog.Error( "MarketBench", "Failed to query characters: %s", res.error.c_str() );
+        return false;
+    }
+
+    // without any character the balance updates simply change no rows
+    DBResultRow row;
+    mCharacterID = ( res.GetRow( row ) ? row.GetUInt( 0 ) : 0 );
+
+    return true;
+}
+
+bool MarketBench::_Place( const Call& call )
+{
+    DBQueryResult res;
+    DBResultRow row;
+
+    // the best order of the other side at the station which takes the whole quantity
+    if( call.bid )
+    {
+        if( !_Query( res,
+            "SELECT orderID"
+            " FROM market_orders"
+            " WHERE bid=0"
+            "  AND typeID=%u"
+            "  AND stationID=%u"
+            "  AND volRemaining >= %u"
+            "  AND price <= %f"
+            " ORDER BY price ASC"
+            " LIMIT 1",
+            call.typeID, call.stationID, call.quantity, call.price ) )
+        {
+            return false;
+        }
+    }
+    else
+    {
+        if( !_Query( res,
+            "SELECT orderID"
+            " FROM market_orders"
+            " WHERE bid=1"
+            "  AND typeID=%u"
+            "  AND stationID=%u"
+            "  AND volRemaining >= %u"
+            "  AND price >= %f"
+            " ORDER BY price DESC"
+            " LIMIT 1",
+            call.typeID, call.stationID, call.quantity, call.price ) )
+        {
+            return false;
+        }
+    }
+
+    if( res.GetRow( row ) )
+    {
+        mPlacedOrders.push_back( 0 );
+
+        // the owner of a sell order is paid; the seller of a buy order gets paid by the client itself
+        return _Trade( row.GetUInt( 0 ), call.quantity, call.bid );
+    }
+
+    return _StoreOrder( call );
+}
+
+bool MarketBench::_Modify( const Call& call )
+{
+    const uint32 orderID = _ResolveOrder( call );
+
+    DBQueryResult res;
+    if( !_Query( res,
+        "SELECT volRemaining, price, typeID, stationID, charID, bid, isCorp"
+        " FROM market_orders"
+        " WHERE orderID=%u",
+        orderID ) )
+    {
+        return false;
+    }
+
+    DBResultRow row;
+    if( !res.GetRow( row ) )
+    {
+        ++mMisses;
+        return true;
+    }
+
+    return _Exec(
+        "UPDATE market_orders"
+        " SET price = %f"
+        " WHERE orderID = %u",
+        call.price, orderID );
+}
+
+bool MarketBench::_Cancel( const Call& call )
+{
+    const uint32 orderID = _ResolveOrder( call );
+
+    DBQueryResult res;
+    if( !_Query( res,
+        "SELECT volRemaining, price, typeID, stationID, charID, bid, isCorp"
+        " FROM market_orders"
+        " WHERE orderID=%u",
+        orderID ) )
+    {
+        return false;
+    }
+
+    DBResultRow row;
+    if( !res.GetRow( row ) )
+    {
+        ++mMisses;
+        return true;
+    }
+
+    // the row sent in the OnOwnOrderChanged notification
+    if( !_Query( res,
+        "SELECT"
+        "  price, volRemaining, typeID, `range`, orderID,"
+        "  volEntered, minVolume, bid, issued, duration,"
+        "  stationID, regionID, solarSystemID, jumps"
+        " FROM market_orders"
+        " WHERE orderID=%u",
+        orderID ) )
+    {
+        return false;
+    }
+
+    return _Exec(
+        "DELETE FROM market_orders"
+        " WHERE orderID = %u",
+        orderID );
+}
+
+bool MarketBench::_GetOrders( const Call& call )
+{
+    DBQueryResult res;
+    if( !_Query( res,
+        "SELECT constellationID, regionID, solarSystemName, securityClass"
+        " FROM mapSolarSystems"
+        " WHERE solarSystemID = %u",
+        call.solarSystemID ) )
+    {
+        return false;
+    }
+
+    DBResultRow row;
+    const uint32 regionID = ( res.GetRow( row ) ? row.GetUInt( 1 ) : 0 );
+
+    for( int bid = 0; bid <= 1; ++bid )
+    {
+        if( !_Query( res,
+            "SELECT"
+            "  price, volRemaining, typeID, `range`, orderID,"
+            "  volEntered, minVolume, bid, issued, duration,"
+            "  stationID, regionID, solarSystemID, jumps"
+            " FROM market_orders"
+            " WHERE regionID=%u AND typeID=%u AND bid=%d",
+            regionID, call.typeID, bid ) )
+        {
+            return false;
+        }
+
+        // the rows are fetched, as the service would to build its rowsets
+        while( res.GetRow( row ) )
+            ;
+    }
+
+    return true;
+}
+
+bool MarketBench::_Trade( uint32 orderID, uint32 quantity, bool sellerIsOwner )
+{
+    DBQueryResult res;
+    if( !_Query( res,
+        "SELECT volRemaining, price, typeID, stationID, charID, bid, isCorp"
+        " FROM market_orders"
+        " WHERE orderID=%u",
+        orderID ) )
+    {
+        return false;
+    }
+
+    DBResultRow row;
+    if( !res.GetRow( row ) )
+        return true;
+
+    const uint32 volRemaining = row.GetUInt( 0 );
+    const double price = row.GetDouble( 1 );
+    const uint32 typeID = row.GetUInt( 2 );
+    const uint32 stationID = row.GetUInt( 3 );
+    const uint32 ownerID = row.GetUInt( 4 );
+
+    if( sellerIsOwner )
+    {
+        const double money = price * quantity;
+        if( !_Exec(
+            "UPDATE character_ SET balance=balance+%.2f WHERE characterID=%u",
+            money, ownerID ) )
+        {
+            return false;
+        }
+        mBalances[ ownerID ] += money;
+    }
+
+    if( volRemaining <= quantity )
+    {
+        if( !_Query( res,
+            "SELECT"
+            "  price, volRemaining, typeID, `range`, orderID,"
+            "  volEntered, minVolume, bid, issued, duration,"
+            "  stationID, regionID, solarSystemID, jumps"
+            " FROM market_orders"
+            " WHERE orderID=%u",
+            orderID ) )
+        {
+            return false;
+        }
+
+        if( !_Exec(
+            "DELETE FROM market_orders"
+            " WHERE orderID = %u",
+            orderID ) )
+        {
+            return false;
+        }
+    }
+    else
+    {
+        if( !_Exec(
+            "UPDATE market_orders"
+            " SET volRemaining = %u"
+            " WHERE orderID = %u",
+            volRemaining - quantity, orderID ) )
+        {
+            return false;
+        }
+    }
+
+    // both sides of the trade are recorded
+    for( int type = TRANSACTION_TYPE_SELL; type <= TRANSACTION_TYPE_BUY; ++type )
+    {
+        uint32 transactionID;
+        if( !_ExecLID( transactionID,
+            "INSERT INTO market_transactions ("
+            "  transactionID, transactionDateTime, typeID, quantity,"
+            "  price, transactionType, clientID, regionID, stationID,"
+            "  corpTransaction"
+            " ) VALUES ("
+            "  NULL, %" PRIu64 ", %u, %u,"
+            "  %f, %d, %u, 0, %u, 0"
+            " )",
+            Win32TimeNow(), typeID, quantity,
+            price, type, ( ( TRANSACTION_TYPE_BUY == type ) == sellerIsOwner ? mCharacterID : ownerID ), stationID ) )
+        {
+            return false;
+        }
+        mTransactions.push_back( transactionID );
+    }
+
+    ++mTrades;
+    return true;
+}
+
+bool MarketBench::_StoreOrder( const Call& call )
+{
+    DBQueryResult res;
+    if( !_Query( res,
+        "SELECT"
+        "  solarSystemID, constellationID, regionID,"
+        "  x, y, z,"
+        "  dockEntryX, dockEntryY, dockEntryZ,"
+        "  dockOrientationX, dockOrientationY, dockOrientationZ"
+        " FROM staStations"
+        " LEFT JOIN staStationTypes USING (stationTypeID)"
+        " WHERE stationID = %u",
+        call.stationID ) )
+    {
+        return false;
+    }
+
+    DBResultRow row;
+    if( !res.GetRow( row ) )
+    {
+        sLog.Error( "MarketBench", "Station %u not found.", call.stationID );
+        return false;
+    }
+    const uint32 solarSystemID = row.GetUInt( 0 );
+    const uint32 regionID = row.GetUInt( 2 );
+
+    uint32 orderID;
+    if( !_ExecLID( orderID,
+        "INSERT INTO market_orders ("
+        "  typeID, charID, regionID, stationID,"
+        "  `range`, bid, price, volEntered, volRemaining, issued,"
+        "  orderState, minVolume, contraband, accountID, duration,"
+        "  isCorp, solarSystemID, escrow, jumps"
+        " ) VALUES ("
+        "  %u, %u, %u, %u,"
+        "  32767, %u, %f, %u, %u, %" PRIu64 ","
+        "  1, 1, 0, 1000, 90,"
+        "  0, %u, 0, 1"
+        " )",
+        call.typeID, mCharacterID, regionID, call.stationID,
+        call.bid ? 1 : 0, call.price, call.quantity, call.quantity, Win32TimeNow(),
+        solarSystemID ) )
+    {
+        return false;
+    }
+
+    mPlacedOrders.push_back( orderID );
+    mOrders.push_back( orderID );
+    return true;
+}
+
+uint32 MarketBench::_ResolveOrder( const Call& call ) const
+{
+    if( 0 <= call.placeIndex && (size_t)call.placeIndex < mPlacedOrders.size() )
+        return mPlacedOrders[ call.placeIndex ];
+
+    return call.orderID;
+}
+
+bool MarketBench::_Query( DBQueryResult& res, const char* fmt, ... )
+{
+    va_list ap;
+    va_start( ap, fmt );
+
+    std::string query;
+    vsprintf( query, fmt, ap );
+
+    va_end( ap );
+
+    ++mStatements;
+    if( !sDatabase.RunQueryString( res, query ) )
+    {
+        sLog.Error( "MarketBench", "Query failed: %s", res.error.c_str() );
+        return false;
+    }
+
+    return true;
+}
+
+bool MarketBench::_Exec( const char* fmt, ... )
+{
+    va_list ap;
+    va_start( ap, fmt );
+
+    std::string query;
+    vsprintf( query, fmt, ap );
+
+    va_end( ap );
+
+    ++mStatements;
+    DBerror err;
+    if( !sDatabase.RunQuery( err, "%s", query.c_str() ) )
+    {
+        sLog.Error( "MarketBench", "Query failed: %s", err.c_str() );
+        return false;
+    }
+
+    return true;
+}
+
+bool MarketBench::_ExecLID( uint32& lastInsertID, const char* fmt, ... )
+{
+    va_list ap;
+    va_start( ap, fmt );
+
+    std::string query;
+    vsprintf( query, fmt, ap );
+
+    va_end( ap );
+
+    ++mStatements;
+    DBerror err;
+    if( !sDatabase.RunQueryLID( err, lastInsertID, "%s", query.c_str() ) )
+    {
+        sLog.Error( "MarketBench", "Query failed: %s", err.c_str() );
+        return false;
+    }
+
+    return true;
+}
@@ -0,0 +1,574 @@
+/*
+    ------------------------------------------------------------------------------------
+    LICENSE:
+    ------------------------------------------------------------------------------------
+    This file is part of EVEmu: EVE Online Server Emulator
+    Copyright 2006 - 2011 The EVEmu Team
+    For the latest information visit http://evemu.org
+    ------------------------------------------------------------------------------------
+    This program is free software; you can redistribute it and/or modify it under
+    the terms of the GNU Lesser General Public License as published by the Free Software
+    Foundation; either version 2 of the License, or (at your option) any later
+    version.
+
+    This program is distributed in the hope that it will be useful, but WITHOUT
+    ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+    FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public License along with
+    this program; if not, write to the Free Software Foundation, Inc., 59 Temple
+    Place - Suite 330, Boston, MA 02111-1307, USA, or go to
+    http://www.gnu.org/copyleft/lesser.txt.
+    ------------------------------------------------------------------------------------
+    Author:     EVEmu Team
+*/
+
+#include "eve-tool.h"
+
+#include "BindCollector.h"
+#include "PacketReplay.h"
+
+/// Time (in microseconds) after which a client which got nothing from the server gives up.
+static const uint64 REPLAY_TIMEOUT_US = 60 * 1000 * 1000;
+
+/**
+ * @brief A synthetic client replaying the calls.
+ */
+class PacketReplay::Client
+{
+public:
+    enum State
+    {
+        STATE_VERSION,
+        STATE_CRYPTO,
+        STATE_HANDSHAKE,
+        STATE_ACK,
+        STATE_READY,
+        STATE_DONE
+    };
+
+    Client( PacketReplay& replay, const std::string& user, const std::string& passHash )
+    : mReplay( replay ),
+      mUser( user ),
+      mPassHash( passHash ),
+      mState( STATE_VERSION ),
+      mNext( 0 ),
+      mStart( 0 ),
+      mLastActivity( 0 )
+    {
+    }
+
+    State state() const { return mState; }
+    const std::string& user() const { return mUser; }
+
+    bool Connect( uint32 address, uint16 port, char* errbuf )
+    {
+        mStart = mLastActivity = GetTimeUSeconds();
+        return mNet.Connect( address, port, errbuf );
+    }
+
+    /**
+     * @brief Handles the received packets and sends the calls which are due.
+     *
+     * @return False once the client is done.
+     */
+    bool Process( uint64 now )
+    {
+        if( STATE_DONE == mState )
+            return false;
+
+        PyRep* rep;
+        while( STATE_DONE != mState && NULL != ( rep = mNet.PopRep() ) )
+        {
+            mLastActivity = now;
+            _Handle( rep, now );
+        }
+
+        if( STATE_READY == mState )
+            _Send( now );
+
+        if( STATE_DONE != mState )
+        {
+            if( TCPConnection::STATE_CONNECTED != mNet.GetState() )
+                _Finish( "Connection closed" );
+            else if( REPLAY_TIMEOUT_US < now - mLastActivity )
+                _Finish( "Timed out" );
+        }
+
+        return STATE_DONE != mState;
+    }
+
+protected:
+    /**
+     * @brief A call waiting for its response.
+     */
+    struct Pending
+    {
+        size_t call;
+        uint64 sent;
+    };
+
+    void _Handle( PyRep* rep, uint64 now )
+    {
+        switch( mState )
+        {
+            case STATE_VERSION:
+                if( rep->IsTuple() )
+                    _SendLogin();
+                else
+                    _Finish( "Invalid version exchange" );
+                break;
+
+            case STATE_CRYPTO:
+                if( rep->IsString() && "OK CC" == rep->AsString()->content() )
+                    _SendChallenge();
+                else
+                    _Finish( "Crypto request refused" );
+                break;
+
+            case STATE_HANDSHAKE:
+                // the password version comes first
+                if( rep->IsTuple() )
+                    _SendHandshakeResult();
+                else if( !rep->IsInt() )
+                    _Finish( "Login refused" );
+                break;
+
+            case STATE_ACK:
+                if( rep->IsDict() )
+                {
+                    mReplay.mLogins.push_back( now - mStart );
+                    mState = STATE_READY;
+                    mStart = now;
+                }
+                else
+                    _Finish( "Handshake refused" );
+                break;
+
+            case STATE_READY:
+                _HandlePacket( rep, now );
+                // consumed
+                return;
+
+            default:
+                break;
+        }
+
+        PyDecRef( rep );
+    }
+
+    void _HandlePacket( PyRep* rep, uint64 now )
+    {
+        PyPacket packet;
+        if( !rep->IsObject() || !packet.Decode( &rep ) )
+        {
+            PySafeDecRef( rep );
+            return;
+        }
+
+        if( CALL_RSP != packet.type && ERRORRESPONSE != packet.type )
+            return;
+
+        std::map<uint64, Pending>::iterator res = mPending.find( packet.dest.callID );
+        if( mPending.end() == res )
+            return;
+
+        const Call& call = mReplay.mCalls[ res->second.call ];
+
+        MethodStats& stats = mReplay.mStats[ call.name ];
+        stats.latencies.push_back( now - res->second.sent );
+        if( ERRORRESPONSE == packet.type )
+            ++stats.errors;
+
+        // pair the bind strings with the recorded ones
+        if( !call.binds.empty() )
+        {
+            std::vector<std::string> binds;
+            BindCollector collector( binds );
+            packet.payload->visit( collector );
+
+            for( size_t i = 0; i < binds.size() && i < call.binds.size(); ++i )
+                mBinds[ call.binds[ i ] ] = binds[ i ];
+        }
+
+        mPending.erase( res );
+    }
+
+    void _Send( uint64 now )
+    {
+        const std::vector<Call>& calls = mReplay.mCalls;
+        const uint64 first = calls.front().time;
+
+        for(; mNext < calls.size(); ++mNext )
+        {
+            const Call& call = calls[ mNext ];
+            if( now < mStart + (uint64)( ( call.time - first ) / mReplay.mSpeed ) )
+                return;
+
+            PyPacket* packet = call.packet->Clone();
+            if( !call.bind.empty() )
+            {
+                std::map<std::string, std::string>::const_iterator res = mBinds.find( call.bind );
+                if( mBinds.end() != res )
+                {
+                    PyCallStream stream;
+                    if( stream.Decode( packet->type_string, packet->payload ) )
+                    {
+                        stream.remoteObjectStr = res->second;
+                        packet->payload = stream.Encode();
+                    }
+                }
+                else if( 0 < mReplay.mBinds.count( call.bind ) && !mPending.empty() )
+                {
+                    // the object is still being bound
+                    SafeDelete( packet );
+                    return;
+                }
+            }
+
+            if( CALL_REQ == packet->type && !call.name.empty() )
+            {
+                Pending& pending = mPending[ packet->source.callID ];
+                pending.call = mNext;
+                pending.sent = now;
+            }
+
+            PyRep* rep = packet->Encode();
+            mNet.QueueRep( rep );
+            PyDecRef( rep );
+
+            SafeDelete( packet );
+        }
+
+        if( mPending.empty() )
+        {
+            mState = STATE_DONE;
+            mNet.Disconnect();
+        }
+    }
+
+    void _SendLogin()
+    {
+        VersionExchangeClient version;
+        version.birthday = EVEBirthday;
+        version.macho_version = MachoNetVersion;
+        version.user_count = 0;
+        version.version_number = EVEVersionNumber;
+        version.build_version = EVEBuildVersion;
+        version.project_version = EVEProjectVersion;
+        _Queue( version.Encode() );
+
+        NetCommand_VK command;
+        command.vipKey = "";
+        _Queue( command.Encode() );
+
+        CryptoRequestPacket request;
+        request.keyVersion = "placebo";
+        request.keyParams = new PyDict;
+        _Queue( request.Encode() );
+
+        mState = STATE_CRYPTO;
+    }
+
+    void _SendChallenge()
+    {
+        CryptoChallengePacket challenge;
+        challenge.clientChallenge = "";
+        challenge.macho_version = MachoNetVersion;
+        challenge.boot_version = EVEVersionNumber;
+        challenge.boot_build = EVEBuildVersion;
+        challenge.boot_codename = EVEProjectCodename;
+        challenge.boot_region = EVEProjectRegion;
+        challenge.user_name = mUser;
+        challenge.user_password_hash = mPassHash;
+        challenge.user_languageid = "EN";
+        challenge.user_affiliateid = 0;
+        _Queue( challenge.Encode() );
+
+        mState = STATE_HANDSHAKE;
+    }
+
+    void _SendHandshakeResult()
+    {
+        CryptoHandshakeResult result;
+        // binascii.crc_hqx of marshaled single-element tuple containing 64 zero-bytes string
+        result.challenge_responsehash = "55087";
+        result.func_output = "";
+        result.func_result = new PyNone;
+        _Queue( result.Encode() );
+
+        mState = STATE_ACK;
+    }
+
+    void _Queue( PyRep* rep )
+    {
+        mNet.QueueRep( rep );
+        PyDecRef( rep );
+    }
+
+    void _Finish( const char* reason )
+    {
+        if( STATE_READY != mState )
+        {
+            sLog.Error( "PacketReplay", "%s: %s during login.", mUser.c_str(), reason );
+            ++mReplay.mFailedLogins;
+        }
+        else if( mNext < mReplay.mCalls.size() || !mPending.empty() )
+            sLog.Error( "PacketReplay", "%s: %s after %lu of %lu packets.",
+                        mUser.c_str(), reason, mNext, mReplay.mCalls.size() );
+
+        mReplay.mTimeouts += mPending.size();
+        mPending.clear();
+
+        mState = STATE_DONE;
+        mNet.Disconnect();
+    }
+
+    PacketReplay& mReplay;
+    EVETCPConnection mNet;
+
+    const std::string mUser;
+    const std::string mPassHash;
+
+    State mState;
+    /// Index of the next call to send.
+    size_t mNext;
+    /// When the client connected; when it logged in once it is ready.
+    uint64 mStart;
+    /// When the client last received something.
+    uint64 mLastActivity;
+
+    /// Live bind strings, by the recorded ones.
+    std::map<std::string, std::string> mBinds;
+    /// Calls waiting for their response, by callID.
+    std::map<uint64, Pending> mPending;
+};
+
+PacketReplay::PacketReplay()
+: mSpeed( 1.0 ),
+  mFailedLogins( 0 ),
+  mTimeouts( 0 ),
+  mTotalTime( 0 )
+{
+}
+
+PacketReplay::~PacketReplay()
+{
+    _Clear();
+}
+
+bool PacketReplay::Load( const char* filename )
+{
+    _Clear();
+
+    std::vector<PacketCapture::Record> records;
+    if( !PacketCapture::Load( filename, records ) )
+        return false;
+
+    // index of the calls in mCalls, by callID
+    std::map<uint64, size_t> calls;
+    // services which bound the objects, by bind string
+    std::map<std::string, std::string> services;
+
+    for( size_t i = 0; i < records.size(); ++i )
+    {
+        const PacketCapture::Record& record = records[ i ];
+
+        // the login handshake does not consist of packets
+        PyRep* rep = InflateUnmarshal( record.data );
+        if( NULL == rep )
+            continue;
+        if( !rep->IsObject() )
+        {
+            PyDecRef( rep );
+            continue;
+        }
+
+        PyPacket* packet = new PyPacket;
+        if( !packet->Decode( &rep ) )
+        {
+            SafeDelete( packet );
+            continue;
+        }
+
+        if( PacketCapture::INBOUND == record.direction )
+        {
+            Call call;
+            call.time = record.time;
+            call.packet = packet;
+
+            if( CALL_REQ == packet->type )
+            {
+                PyPacket* copy = packet->Clone();
+
+                PyCallStream stream;
+                if( stream.Decode( copy->type_string, copy->payload ) )
+                {
+                    if( packet->dest.service.empty() )
+                    {
+                        call.bind = stream.remoteObjectStr;
+
+                        std::map<std::string, std::string>::const_iterator res = services.find( call.bind );
+                        call.name = ( services.end() != res ? res->second : "bound" );
+                    }
+                    else
+                        call.name = packet->dest.service;
+
+                    call.name += "::" + stream.method;
+                    calls[ packet->source.callID ] = mCalls.size();
+                }
+
+                SafeDelete( copy );
+            }
+
+            mCalls.push_back( call );
+        }
+        else if( CALL_RSP == packet->type || ERRORRESPONSE == packet->type )
+        {
+            std::map<uint64, size_t>::const_iterator res = calls.find( packet->dest.callID );
+            if( calls.end() != res )
+            {
+                Call& call = mCalls[ res->second ];
+
+                BindCollector collector( call.binds );
+                packet->payload->visit( collector );
+
+                // bound objects are named after the service which bound them
+                const std::string service = call.name.substr( 0, call.name.find( "::" ) );
+                for( size_t j = 0; j < call.binds.size(); ++j )
+                {
+                    mBinds.insert( call.binds[ j ] );
+                    services[ call.binds[ j ] ] = service;
+                }
+            }
+
+            SafeDelete( packet );
+        }
+        else
+            SafeDelete( packet );
+    }
+
+    if( mCalls.empty() )
+    {
+        sLog.Error( "PacketReplay", "No client packets in capture '%s'.", filename );
+        return false;
+    }
+
+    return true;
+}
+
+bool PacketReplay::Run( uint32 address, uint16 port, uint32 clients,
+                        const std::string& userPrefix, const std::string& password, double speed )
+{
+    mStats.clear();
+    mLogins.clear();
+    mFailedLogins = 0;
+    mTimeouts = 0;
+    mSpeed = speed;
+
+    std::vector<Client*> active;
+    for( uint32 i = 0; i < clients; ++i )
+    {
+        const std::string user = userPrefix + itoa( i );
+
+        std::string passHash;
+        if( !PasswordModule::GeneratePassHash( user, password, passHash ) )
+        {
+            sLog.Error( "PacketReplay", "%s: Failed to hash the password.", user.c_str() );
+            ++mFailedLogins;
+            continue;
+        }
+
+        Client* client = new Client( *this, user, passHash );
+
+        char errbuf[ ERRBUF_SIZE ];
+        if( !client->Connect( address, port, errbuf ) )
+        {
+            sLog.Error( "PacketReplay", "%s: Failed to connect: %s", user.c_str(), errbuf );
+            ++mFailedLogins;
+
+            SafeDelete( client );
+            continue;
+        }
+
+        active.push_back( client );
+    }
+
+    const uint64 start = GetTimeUSeconds();
+    while( !active.empty() )
+    {
+        const uint64 now = GetTimeUSeconds();
+
+        for( size_t i = 0; i < active.size(); )
+        {
+            if( active[ i ]->Process( now ) )
+                ++i;
+            else
+            {
+                SafeDelete( active[ i ] );
+                active[ i ] = active.back();
+                active.pop_back();
+            }
+        }
+
+        Sleep( 1 );
+    }
+    mTotalTime = GetTimeUSeconds() - start;
+
+    return !mLogins.empty();
+}
+
+void PacketReplay::Report() const
+{
+    if( !mLogins.empty() )
+    {
+        std::vector<uint64> logins = mLogins;
+        std::sort( logins.begin(), logins.end() );
+
+        const size_t n = logins.size();
+        sLog.Log( "PacketReplay", "%lu logins (%u failed): p50 %" PRIu64 " us, p99 %" PRIu64 " us, max %" PRIu64 " us.",
+                  n, mFailedLogins,
+                  logins[ ( n - 1 ) / 2 ],
+                  logins[ ( n - 1 ) * 99 / 100 ],
+                  logins[ n - 1 ] );
+    }
+    else
+        sLog.Log( "PacketReplay", "No logins (%u failed).", mFailedLogins );
+
+    uint64 calls = 0;
+    uint64 errors = 0;
+
+    sLog.Log( "PacketReplay", "Method: calls, errors, p50 us, p90 us, p99 us, max us" );
+    std::map<std::string, MethodStats>::const_iterator cur, end;
+    cur = mStats.begin();
+    end = mStats.end();
+    for(; cur != end; ++cur )
+    {
+        std::vector<uint64> latencies = cur->second.latencies;
+        std::sort( latencies.begin(), latencies.end() );
+
+        const size_t n = latencies.size();
+        sLog.Log( "PacketReplay", "%s: %lu, %" PRIu64 ", %" PRIu64 ", %" PRIu64 ", %" PRIu64 ", %" PRIu64,
+                  cur->first.c_str(), n, cur->second.errors,
+                  latencies[ ( n - 1 ) / 2 ],
+                  latencies[ ( n - 1 ) * 9 / 10 ],
+                  latencies[ ( n - 1 ) * 99 / 100 ],
+                  latencies[ n - 1 ] );
+
+        calls += n;
+        errors += cur->second.errors;
+    }
+
+    const double seconds = mTotalTime / 1000000.0;
+    sLog.Log( "PacketReplay", "%" PRIu64 " calls in %.3f s: %.1f calls/s, %" PRIu64 " errors, %" PRIu64 " without response.",
+              calls, seconds, ( 0 < mTotalTime ? calls / seconds : 0.0 ), errors, mTimeouts );
+}
+
+void PacketReplay::_Clear()
+{
+    for( size_t i = 0; i < mCalls.size(); ++i )
+        SafeDelete( mCalls[ i ].packet );
+
+    mCalls.clear();
+    mBinds.clear();
+}
@@ -0,0 +1,999 @@
+/*
+    ------------------------------------------------------------------------------------
+    LICENSE:
+    ------------------------------------------------------------------------------------
+    This file is part of EVEmu: EVE Online Server Emulator
+    Copyright 2006 - 2011 The EVEmu Team
+    For the latest information visit http://evemu.org
+    ------------------------------------------------------------------------------------
+    This program is free software; you can redistribute it and/or modify it under
+    the terms of the GNU Lesser General Public License as published by the Free Software
+    Foundation; either version 2 of the License, or (at your option) any later
+    version.
+
+    This program is distributed in the hope that it will be useful, but WITHOUT
+    ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+    FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public License along with
+    this program; if not, write to the Free Software Foundation, Inc., 59 Temple
+    Place - Suite 330, Boston, MA 02111-1307, USA, or go to
+    http://www.gnu.org/copyleft/lesser.txt.
+    ------------------------------------------------------------------------------------
+    Author:     EVEmu Team
+*/
+
+
+#include "eve-tool.h"
+
+#include "UniverseSeeder.h"
+
+/// Rows of every kind in a single chunk.
+static const uint32 CHUNK_SIZES[] = { 10000, 100000, 100000, 50000 };
+
+/// Attributes written by the generator; charisma is followed by intelligence, memory, perception and willpower.
+static const uint32 ATTR_CHARISMA = 164;
+static const uint32 ATTR_SKILL_POINTS = 276;
+static const uint32 ATTR_SKILL_LEVEL = 280;
+static const uint32 ATTR_SKILL_TIME_CONSTANT = 275;
+
+/// Skill points of level 1 per rank.
+static const double SKILL_BASE_POINTS = 250.0;
+/// mailRecipient.labelMask of the inbox.
+static const uint32 MAIL_LABEL_INBOX = 1;
+
+/// Words of the mail bodies.
+static const char* const MAIL_WORDS[] =
+{
+    "fleet", "undock", "station", "jump", "gate", "market", "order", "isk",
+    "corp", "war", "pos", "mining", "belt", "ore", "skill", "ship",
+    "fit", "module", "meet", "at", "the", "in", "tonight", "bring"
+};
+static const size_t MAIL_WORD_COUNT = sizeof( MAIL_WORDS ) / sizeof( MAIL_WORDS[0] );
+
+/**
+ * @brief A data file of LOAD DATA, written a row at a time.
+ */
+class DataFile
+{
+public:
+    DataFile() : mFile( NULL ), mFailed( false ), mRowStart( true ) {}
+    ~DataFile() { Close(); }
+
+    bool Open( const std::string& fileName )
+    {
+        mFile = fopen( fileName.c_str(), "wb" );
+        if( NULL == mFile )
+            sLog.Error( "UniverseSeeder", "Unable to open data file '%s'.", fileName.c_str() );
+
+        return NULL != mFile;
+    }
+    /** @return True if everything has been written. */
+    bool Close()
+    {
+        if( NULL != mFile )
+        {
+            _Flush();
+            mFailed = ( 0 != fclose( mFile ) ) || mFailed;
+            mFile = NULL;
+        }
+
+        return !mFailed;
+    }
+
+    void Int( uint64 value )
+    {
+        char buf[ 32 ];
+        snprintf( buf, sizeof( buf ), "%" PRIu64, value );
+        _Field( buf );
+    }
+    void SignedInt( int64 value )
+    {
+        char buf[ 32 ];
+        snprintf( buf, sizeof( buf ), "%" PRId64, value );
+        _Field( buf );
+    }
+    void Real( double value )
+    {
+        char buf[ 64 ];
+        snprintf( buf, sizeof( buf ), "%.2f", value );
+        _Field( buf );
+    }
+    void Null() { _Field( "\\N" ); }
+    void Text( const std::string& value ) { Text( value.data(), value.size() ); }
+    void Text( const char* value, size_t length )
+    {
+        _Field( "" );
+
+        // the escapes LOAD DATA understands by default
+        for( size_t i = 0; i < length; ++i )
+        {
+            switch( value[ i ] )
+            {
+            case '\0': mRow += "\\0";  break;
+            case '\\': mRow += "\\\\"; break;
+            case '\t': mRow += "\\t";  break;
+            case '\n': mRow += "\\n";  break;
+            case '\r': mRow += "\\r";  break;
+            default:   mRow += value[ i ]; break;
+            }
+        }
+    }
+
+    void EndRow()
+    {
+        mRow += '\n';
+        mRowStart = true;
+
+        if( 0x10000 <= mRow.size() )
+            _Flush();
+    }
+
+protected:
+    void _Field( const char* value )
+    {
+        if( !mRowStart )
+            mRow += '\t';
+        mRowStart = false;
+
+        mRow += value;
+    }
+    void _Flush()
+    {
+        if( !mRow.empty() && mRow.size() != fwrite( mRow.data(), 1, mRow.size(), mFile ) )
+            mFailed = true;
+        mRow.clear();
+    }
+
+    FILE* mFile;
+    bool mFailed;
+    bool mRowStart;
+    std::string mRow;
+};
+
+/************************************************************************/
+/* UniverseSeeder                                                       */
+/************************************************************************/
+const char* const UniverseSeeder::TABLE_NAMES[ TABLE_COUNT ] =
+{
+    "account",
+    "character_",
+    "chrEmployment",
+    "entity",
+    "entity_attributes",
+    "corporation",
+    "market_orders",
+    "mailBody",
+    "mailMessage",
+    "mailRecipient"
+};
+
+const char* const UniverseSeeder::TABLE_COLUMNS[ TABLE_COUNT ] =
+{
+    "accountID,accountName,password,role",
+    "characterID,accountID,title,description,bounty,balance,securityRating,petitionMessage,"
+        "logonMinutes,corporationID,corpRole,rolesAtAll,rolesAtBase,rolesAtHQ,rolesAtOther,"
+        "corporationDateTime,startDateTime,createDateTime,"
+        "ancestryID,careerID,schoolID,careerSpecialityID,gender,"
+        "stationID,solarSystemID,constellationID,regionID,freeRespecs,nextRespec,shipID",
+    "characterID,corporationID,startDate,deleted",
+    "itemID,itemName,typeID,ownerID,locationID,flag,contraband,singleton,quantity,x,y,z,customInfo",
+    "itemID,attributeID,valueInt,valueFloat",
+    "corporationID,corporationName,description,tickerName,url,"
+        "taxRate,minimumJoinStanding,corporationType,hasPlayerPersonnelManager,sendCharTerminationMessage,"
+        "creatorID,ceoID,stationID,raceID,allianceID,shares,memberCount,memberLimit,"
+        "allowedMemberRaceIDs,graphicID,isRecruiting",
+    "orderID,typeID,charID,regionID,stationID,"
+        "`range`,bid,price,volEntered,volRemaining,issued,"
+        "orderState,minVolume,contraband,accountID,duration,"
+        "isCorp,solarSystemID,escrow,jumps",
+    "bodyID,hash,body",
+    "messageID,senderID,toCharacterIDs,toListID,toCorpOrAllianceID,title,bodyID,sentDate",
+    "messageID,characterID,statusMask,labelMask,unread"
+};
+
+const uint8 UniverseSeeder::TABLE_JOBS[ TABLE_COUNT ] =
+{
+    JOB_CHARACTERS,
+    JOB_CHARACTERS,
+    JOB_CHARACTERS,
+    JOB_CHARACTERS,
+    JOB_CHARACTERS,
+    JOB_CORPORATIONS,
+    JOB_ORDERS,
+    JOB_MAILS,
+    JOB_MAILS,
+    JOB_MAILS
+};
+
+UniverseSeeder::Parameters::Parameters()
+: characters( 1000 ),
+  corporations( 50 ),
+  orders( 100000 ),
+  mails( 10000 ),
+  skillsPerCharacter( 40 ),
+  assetsPerCharacter( 25 ),
+  recipientsPerMail( 5 ),
+  accountPrefix( "seed" ),
+  password( "seed" ),
+  seed( 1 )
+{
+}
+
+UniverseSeeder::Random::Random( uint32 seed, uint8 kind, uint32 index )
+{
+    // splitmix64 of the three, so that neighbouring indexes start far apart
+    uint64 z = ( (uint64)seed << 32 ) ^ ( (uint64)kind << 56 ) ^ index;
+    z += 0x9E3779B97F4A7C15ULL;
+    z = ( z ^ ( z >> 30 ) ) * 0xBF58476D1CE4E5B9ULL;
+    z = ( z ^ ( z >> 27 ) ) * 0x94D049BB133111EBULL;
+    z ^= ( z >> 31 );
+
+    mState = ( 0 != z ? z : 1 );
+}
+
+uint32 UniverseSeeder::Random::Next()
+{
+    // xorshift64*
+    mState ^= mState >> 12;
+    mState ^= mState << 25;
+    mState ^= mState >> 27;
+
+    return (uint32)( ( mState * 0x2545F4914F6CDD1DULL ) >> 32 );
+}
+
+UniverseSeeder::UniverseSeeder()
+: mFirstAccountID( 1 ),
+  mFirstItemID( 1 ),
+  mFirstCorporationID( 1 ),
+  mFirstOrderID( 1 ),
+  mFirstMessageID( 1 ),
+  mFirstBodyID( 1 ),
+  mNow( 0 ),
+  mItemsPerCharacter( 0 ),
+  mTaken( 0 ),
+  mSucceeded( 0 )
+{
+}
+
+bool UniverseSeeder::LoadStaticData()
+{
+    DBQueryResult res;
+    DBResultRow row;
+
+    if( !sDatabase.RunQuery( res,
+        "SELECT stationID, solarSystemID, constellationID, regionID"
+        " FROM staStations"
+        " ORDER BY stationID" ) )
+    {
+        sLog.Error( "UniverseSeeder", "Failed to query stations: %s", res.error.c_str() );
+        return false;
+    }
+    mStations.clear();
+    while( res.GetRow( row ) )
+    {
+        Station s;
+        s.stationID = row.GetUInt( 0 );
+        s.solarSystemID = row.GetUInt( 1 );
+        s.constellationID = row.GetUInt( 2 );
+        s.regionID = row.GetUInt( 3 );
+        mStations.push_back( s );
+    }
+
+    if( !sDatabase.RunQuery( res,
+        "SELECT a.ancestryID, b.raceID,"
+        "  (SELECT MIN(t.typeID) FROM bloodlineTypes t WHERE t.bloodlineID = a.bloodlineID),"
+        "  (SELECT MIN(s.schoolID) FROM chrSchools s WHERE s.raceID = b.raceID),"
+        "  a.charisma + b.charisma, a.intelligence + b.intelligence, a.memory + b.memory,"
+        "  a.perception + b.perception, a.willpower + b.willpower"
+        " FROM chrAncestries a"
+        "  JOIN chrBloodlines b USING (bloodlineID)"
+        " ORDER BY a.ancestryID" ) )
+    {
+        sLog.Error( "UniverseSeeder", "Failed to query ancestries: %s", res.error.c_str() );
+        return false;
+    }
+    mAncestries.clear();
+    while( res.GetRow( row ) )
+    {
+        // a bloodline without a character type cannot be played
+        if( row.IsNull( 2 ) )
+            continue;
+
+        Ancestry a;
+        a.ancestryID = row.GetUInt( 0 );
+        a.raceID = row.GetUInt( 1 );
+        a.typeID = row.GetUInt( 2 );
+        a.schoolID = ( row.IsNull( 3 ) ? 0 : row.GetUInt( 3 ) );
+        for( uint32 i = 0; i < 5; ++i )
+            a.attributes[ i ] = row.GetUInt( 4 + i );
+        mAncestries.push_back( a );
+    }
+
+    if( !sDatabase.RunQuery( res,
+        "SELECT typeID, basePrice"
+        " FROM invTypes"
+        " WHERE marketGroupID IS NOT NULL"
+        "  AND published = 1"
+        " ORDER BY typeID" ) )
+    {
+        sLog.Error( "UniverseSeeder", "Failed to query market types: %s", res.error.c_str() );
+        return false;
+    }
+    mMarketTypes.clear();
+    while( res.GetRow( row ) )
+        mMarketTypes.push_back( std::make_pair( row.GetUInt( 0 ), std::max( row.GetDouble( 1 ), 100.0 ) ) );
+
+    if( !sDatabase.RunQuery( res,
+        "SELECT t.typeID, COALESCE(a.valueFloat, a.valueInt, 1)"
+        " FROM invTypes t"
+        "  JOIN invGroups g USING (groupID)"
+        "  LEFT JOIN dgmTypeAttributes a ON a.typeID = t.typeID AND a.attributeID = %u"
+        " WHERE g.categoryID = 16"
+        "  AND t.published = 1"
+        " ORDER BY t.typeID",
+        ATTR_SKILL_TIME_CONSTANT ) )
+    {
+        sLog.Error( "UniverseSeeder", "Failed to query skills: %s", res.error.c_str() );
+        return false;
+    }
+    mSkills.clear();
+    while( res.GetRow( row ) )
+        mSkills.push_back( std::make_pair( row.GetUInt( 0 ), row.GetDouble( 1 ) ) );
+
+    if( !sDatabase.RunQuery( res,
+        "SELECT t.typeID"
+        " FROM invTypes t"
+        "  JOIN invGroups g USING (groupID)"
+        " WHERE g.categoryID = 6"
+        "  AND t.published = 1"
+        " ORDER BY t.typeID" ) )
+    {
+        sLog.Error( "UniverseSeeder", "Failed to query ships: %s", res.error.c_str() );
+        return false;
+    }
+    mShipTypes.clear();
+    while( res.GetRow( row ) )
+        mShipTypes.push_back( row.GetUInt( 0 ) );
+
+    if( mStations.empty() || mAncestries.empty() || mMarketTypes.empty() || mSkills.empty() || mShipTypes.empty() )
+    {
+        sLog.Error( "UniverseSeeder", "The database lacks stations, ancestries, market types, skills or ships." );
+        return false;
+    }
+
+    // the data set goes after everything there is
+    if( !sDatabase.RunQuery( res,
+        "SELECT"
+        "  (SELECT IFNULL(MAX(accountID), 0) FROM account),"
+        "  (SELECT IFNULL(MAX(itemID), 0) FROM entity),"
+        "  (SELECT IFNULL(MAX(corporationID), 0) FROM corporation),"
+        "  (SELECT IFNULL(MAX(orderID), 0) FROM market_orders),"
+        "  (SELECT IFNULL(MAX(messageID), 0) FROM mailMessage),"
+        "  (SELECT IFNULL(MAX(bodyID), 0) FROM mailBody)" )
+        || !res.GetRow( row ) )
+    {
+        sLog.Error( "UniverseSeeder", "Failed to query the largest IDs: %s", res.error.c_str() );
+        return false;
+    }
+    mFirstAccountID = row.GetUInt( 0 ) + 1;
+    mFirstItemID = row.GetUInt( 1 ) + 1;
+    mFirstCorporationID = row.GetUInt( 2 ) + 1;
+    mFirstOrderID = row.GetUInt( 3 ) + 1;
+    mFirstMessageID = row.GetUInt( 4 ) + 1;
+    mFirstBodyID = row.GetUInt( 5 ) + 1;
+
+    sLog.Log( "UniverseSeeder", "Loaded %lu stations, %lu ancestries, %lu market types, %lu skills and %lu ships.",
+              mStations.size(), mAncestries.size(), mMarketTypes.size(), mSkills.size(), mShipTypes.size() );
+    return true;
+}
+
+bool UniverseSeeder::Generate( const std::string& prefix, const Parameters& params, uint32 threads )
+{
+    if( 0 == params.characters || 0 == params.corporations || params.corporations > params.characters )
+    {
+        sLog.Error( "UniverseSeeder", "There must be some characters and between 1 and as many corporations." );
+        return false;
+    }
+    if( 0 == params.recipientsPerMail && 0 < params.mails )
+    {
+        sLog.Error( "UniverseSeeder", "The mails need recipients." );
+        return false;
+    }
+
+    mParams = params;
+    mParams.skillsPerCharacter = std::min<uint32>( mParams.skillsPerCharacter, mSkills.size() );
+    mPrefix = prefix;
+    mNow = Win32TimeNow();
+    mItemsPerCharacter = 2 + mParams.assetsPerCharacter + mParams.skillsPerCharacter;
+
+    if( (uint64)mFirstItemID + (uint64)mParams.characters * mItemsPerCharacter > 0xFFFFFFFFULL )
+    {
+        sLog.Error( "UniverseSeeder", "%u characters with %u items each do not fit in the item IDs.",
+                    mParams.characters, mItemsPerCharacter );
+        return false;
+    }
+
+    const uint64 start = GetTimeUSeconds();
+
+    // the corporations must know their rosters before they are written
+    mMemberCounts.assign( mParams.corporations, 0 );
+    for( uint32 i = 0; i < mParams.characters; ++i )
+    {
+        Random random( mParams.seed, JOB_CHARACTERS, i );
+        const Ancestry* ancestry;
+        const Station* station;
+
+        ++mMemberCounts[ _DrawCharacter( i, random, ancestry, station ) ];
+    }
+
+    const uint32 counts[ JOB_KIND_COUNT ] = { mParams.characters, mParams.corporations, mParams.orders, mParams.mails };
+
+    mJobs.clear();
+    for( uint8 kind = 0; kind < JOB_KIND_COUNT; ++kind )
+    {
+        for( uint32 first = 0, chunk = 0; first < counts[ kind ]; first += CHUNK_SIZES[ kind ], ++chunk )
+        {
+            Job job;
+            job.kind = kind;
+            job.chunk = chunk;
+            job.first = first;
+            job.count = std::min( CHUNK_SIZES[ kind ], counts[ kind ] - first );
+
+            mJobs.push_back( job );
+        }
+    }
+
+    mTaken = 0;
+    mSucceeded = 0;
+
+    if( threads > mJobs.size() )
+        threads = mJobs.size();
+
+#ifdef WIN32
+    std::vector<HANDLE> workers;
+#else /* !WIN32 */
+    std::vector<pthread_t> workers;
+#endif /* !WIN32 */
+    for( uint32 i = 1; i < threads; ++i )
+    {
+#ifdef WIN32
+        HANDLE thread = CreateThread( NULL, 0, WorkerLoop, this, 0, NULL );
+        if( NULL == thread )
+#else /* !WIN32 */
+        pthread_t thread;
+        if( 0 != pthread_create( &thread, NULL, WorkerLoop, this ) )
+#endif /* !WIN32 */
+        {
+            sLog.Error( "UniverseSeeder", "Failed to start generator thread %u.", i );
+            continue;
+        }
+
+        workers.push_back( thread );
+    }
+
+    // the calling thread works too
+    _Work();
+
+    for( size_t i = 0; i < workers.size(); ++i )
+    {
+#ifdef WIN32
+        WaitForSingleObject( workers[ i ], INFINITE );
+        CloseHandle( workers[ i ] );
+#else /* !WIN32 */
+        pthread_join( workers[ i ], NULL );
+#endif /* !WIN32 */
+    }
+
+    if( mJobs.size() != mSucceeded )
+    {
+        sLog.Error( "UniverseSeeder", "%lu of %lu chunks failed.", mJobs.size() - mSucceeded, mJobs.size() );
+        return false;
+    }
+
+    const std::string scriptFile = mPrefix + ".sql";
+    if( !_WriteLoadScript( scriptFile ) )
+        return false;
+
+    sLog.Success( "UniverseSeeder", "Generated %u characters (%u items each), %u corporations, %u orders and %u mails"
+                                    " in %lu chunks in %.3f s; load them by %s.",
+                  mParams.characters, mItemsPerCharacter, mParams.corporations, mParams.orders, mParams.mails,
+                  mJobs.size(), ( GetTimeUSeconds() - start ) / 1000000.0, scriptFile.c_str() );
+    return true;
+}
+
+uint32 UniverseSeeder::_DrawCharacter( uint32 index, Random& random, const Ancestry*& ancestry, const Station*& station ) const
+{
+    ancestry = &mAncestries[ random.Below( mAncestries.size() ) ];
+    station = &mStations[ random.Below( mStations.size() ) ];
+
+    // every corporation is founded by one of the first characters; the rest
+    // join them with a square skew, so there are a few large corporations
+    // and a long tail of small ones
+    const double skew = random.Real();
+    if( index < mParams.corporations )
+        return index;
+
+    return (uint32)( mParams.corporations * skew * skew );
+}
+
+bool UniverseSeeder::_WriteCharacters( const Job& job )
+{
+    DataFile files[ TABLE_ATTRIBUTES + 1 ];
+    for( uint8 table = TABLE_ACCOUNT; table <= TABLE_ATTRIBUTES; ++table )
+    {
+        if( !files[ table ].Open( _GetDataFileName( table, job.chunk ) ) )
+            return false;
+    }
+
+    DataFile& accounts = files[ TABLE_ACCOUNT ];
+    DataFile& characters = files[ TABLE_CHARACTER ];
+    DataFile& employment = files[ TABLE_EMPLOYMENT ];
+    DataFile& entities = files[ TABLE_ENTITY ];
+    DataFile& attributes = files[ TABLE_ATTRIBUTES ];
+
+    // the skills of a character are the first ones of a partial shuffle
+    std::vector<uint32> skillOrder( mSkills.size() );
+    for( size_t i = 0; i < skillOrder.size(); ++i )
+        skillOrder[ i ] = i;
+
+    char name[ 128 ];
+    for( uint32 i = job.first; i < job.first + job.count; ++i )
+    {
+        Random random( mParams.seed, JOB_CHARACTERS, i );
+        const Ancestry* ancestry;
+        const Station* station;
+        const uint32 corporation = _DrawCharacter( i, random, ancestry, station );
+
+        const uint32 accountID = mFirstAccountID + i;
+        const uint32 characterID = _CharacterID( i );
+        const uint32 corporationID = mFirstCorporationID + corporation;
+        const uint32 shipID = characterID + 1;
+        const uint64 created = mNow - random.Below( 365 * 3 ) * Win32Time_Day;
+        const uint64 joined = created + random.Below( (uint32)( ( mNow - created ) / Win32Time_Hour ) + 1 ) * Win32Time_Hour;
+
+        snprintf( name, sizeof( name ), "%s%u", mParams.accountPrefix.c_str(), i );
+
+        accounts.Int( accountID );
+        accounts.Text( name );
+        accounts.Text( mParams.password );
+        accounts.Int( ROLE_PLAYER );
+        accounts.EndRow();
+
+        // the character sits in its ship, docked in a hangar
+        entities.Int( characterID );
+        entities.Text( name );
+        entities.Int( ancestry->typeID );
+        entities.Int( 1 );  // EVE System
+        entities.Int( shipID );
+        entities.Int( flagPilot );
+        entities.Int( 0 );
+        entities.Int( 1 );
+        entities.Int( 1 );
+        entities.Int( 0 );
+        entities.Int( 0 );
+        entities.Int( 0 );
+        entities.Null();
+        entities.EndRow();
+
+        for( uint32 attr = 0; attr < 5; ++attr )
+        {
+            attributes.Int( characterID );
+            attributes.Int( ATTR_CHARISMA + attr );
+            attributes.Int( ancestry->attributes[ attr ] );
+            attributes.Null();
+            attributes.EndRow();
+        }
+
+        const std::string shipName = std::string( name ) + "'s Ship";
+        entities.Int( shipID );
+        entities.Text( shipName );
+        entities.Int( mShipTypes[ random.Below( mShipTypes.size() ) ] );
+        entities.Int( characterID );
+        entities.Int( station->stationID );
+        entities.Int( flagHangar );
+        entities.Int( 0 );
+        entities.Int( 1 );
+        entities.Int( 1 );
+        entities.Int( 0 );
+        entities.Int( 0 );
+        entities.Int( 0 );
+        entities.Null();
+        entities.EndRow();
+
+        uint32 itemID = shipID + 1;
+        for( uint32 a = 0; a < mParams.assetsPerCharacter; ++a, ++itemID )
+        {
+            // mostly small stacks, now and then a large one
+            const uint32 quantity = ( 0 == random.Below( 10 ) ? 1 + random.Below( 100000 ) : 1 + random.Below( 100 ) );
+
+            entities.Int( itemID );
+            entities.Text( "", 0 );
+            entities.Int( mMarketTypes[ random.Below( mMarketTypes.size() ) ].first );
+            entities.Int( characterID );
+            entities.Int( station->stationID );
+            entities.Int( flagHangar );
+            entities.Int( 0 );
+            entities.Int( 0 );
+            entities.Int( quantity );
+            entities.Int( 0 );
+            entities.Int( 0 );
+            entities.Int( 0 );
+            entities.Null();
+            entities.EndRow();
+        }
+
+        for( uint32 s = 0; s < mParams.skillsPerCharacter; ++s, ++itemID )
+        {
+            std::swap( skillOrder[ s ], skillOrder[ s + random.Below( skillOrder.size() - s ) ] );
+            const std::pair<uint32, double>& skill = mSkills[ skillOrder[ s ] ];
+
+            const uint32 level = 1 + random.Below( 5 );
+            const uint64 points = (uint64)( SKILL_BASE_POINTS * skill.second * pow( 2.0, 2.5 * ( level - 1 ) ) );
+
+            entities.Int( itemID );
+            entities.Text( "", 0 );
+            entities.Int( skill.first );
+            entities.Int( characterID );
+            entities.Int( characterID );
+            entities.Int( flagSkill );
+            entities.Int( 0 );
+            entities.Int( 1 );
+            entities.Int( 1 );
+            entities.Int( 0 );
+            entities.Int( 0 );
+            entities.Int( 0 );
+            entities.Null();
+            entities.EndRow();
+
+            attributes.Int( itemID );
+            attributes.Int( ATTR_SKILL_LEVEL );
+            attributes.Int( level );
+            attributes.Null();
+            attributes.EndRow();
+
+            attributes.Int( itemID );
+            attributes.Int( ATTR_SKILL_POINTS );
+            attributes.Int( points );
+            attributes.Null();
+            attributes.EndRow();
+        }
+
+        characters.Int( characterID );
+        characters.Int( accountID );
+        characters.Text( "No Title" );
+        characters.Text( "", 0 );
+        characters.Int( 0 );
+        // balances spread over many orders of magnitude
+        characters.Real( pow( 10.0, 3.0 + 7.0 * random.Real() ) );
+        characters.Real( 10.0 * random.Real() - 5.0 );
+        characters.Text( "No petition" );
+        characters.Int( random.Below( 100000 ) );
+        characters.Int( corporationID );
+        for( uint32 r = 0; r < 5; ++r )
+            characters.Int( 0 );
+        characters.Int( joined );
+        characters.Int( created );
+        characters.Int( created );
+        characters.Int( ancestry->ancestryID );
+        characters.Int( 11 );   // the career hacked in by CreateCharacter2 as well
+        characters.Int( ancestry->schoolID );
+        characters.Int( 11 );
+        characters.Int( random.Below( 2 ) );
+        characters.Int( station->stationID );
+        characters.Int( station->solarSystemID );
+        characters.Int( station->constellationID );
+        characters.Int( station->regionID );
+        characters.Int( 2 );
+        characters.Int( 0 );
+        characters.Int( shipID );
+        characters.EndRow();
+
+        employment.Int( characterID );
+        employment.Int( corporationID );
+        employment.Int( joined );
+        employment.Int( 0 );
+        employment.EndRow();
+    }
+
+    bool success = true;
+    for( uint8 table = TABLE_ACCOUNT; table <= TABLE_ATTRIBUTES; ++table )
+        success = files[ table ].Close() && success;
+
+    return success;
+}
+
+bool UniverseSeeder::_WriteCorporations( const Job& job )
+{
+    DataFile corporations;
+    if( !corporations.Open( _GetDataFileName( TABLE_CORPORATION, job.chunk ) ) )
+        return false;
+
+    char name[ 128 ];
+    char ticker[ 8 ];
+    for( uint32 c = job.first; c < job.first + job.count; ++c )
+    {
+        // the founder is the c-th character; its corporation is at its station
+        Random random( mParams.seed, JOB_CHARACTERS, c );
+        const Ancestry* ancestry;
+        const Station* station;
+        _DrawCharacter( c, random, ancestry, station );
+
+        snprintf( name, sizeof( name ), "%s Corporation %u", mParams.accountPrefix.c_str(), c );
+
+        // the ticker is the index in base 36, unique up to 36^5 corporations
+        const char digits[] = "0123456789ABCDEFGHIJKLMNOPQRSTUVWXYZ";
+        uint32 n = c;
+        size_t len = 0;
+        do
+        {
+            ticker[ len++ ] = digits[ n % 36 ];
+            n /= 36;
+        } while( 0 != n && len < 5 );
+        ticker[ len ] = '\0';
+        std::reverse( ticker, ticker + len );
+
+        const uint32 founderID = _CharacterID( c );
+
+        corporations.Int( mFirstCorporationID + c );
+        corporations.Text( name );
+        corporations.Text( "", 0 );
+        corporations.Text( ticker );
+        corporations.Text( "", 0 );
+        corporations.Real( 0.1 );
+        corporations.Int( 0 );
+        corporations.Int( 2 );
+        corporations.Int( 0 );
+        corporations.Int( 1 );
+        corporations.Int( founderID );
+        corporations.Int( founderID );
+        corporations.Int( station->stationID );
+        corporations.Int( ancestry->raceID );
+        corporations.Int( 0 );
+        corporations.Int( 1000 );
+        corporations.Int( mMemberCounts[ c ] );
+        corporations.Int( std::max<uint32>( mMemberCounts[ c ], 10 ) );
+        corporations.Int( ancestry->raceID );
+        corporations.Int( 0 );
+        corporations.Int( 0 );
+        corporations.EndRow();
+    }
+
+    return corporations.Close();
+}
+
+bool UniverseSeeder::_WriteOrders( const Job& job )
+{
+    DataFile orders;
+    if( !orders.Open( _GetDataFileName( TABLE_ORDERS, job.chunk ) ) )
+        return false;
+
+    for( uint32 i = job.first; i < job.first + job.count; ++i )
+    {
+        Random random( mParams.seed, JOB_ORDERS, i );
+
+        const Station& station = mStations[ random.Below( mStations.size() ) ];
+        const std::pair<uint32, double>& type = mMarketTypes[ random.Below( mMarketTypes.size() ) ];
+        const bool bid = ( 0 == random.Below( 2 ) );
+        // bids below the base price and asks above it, so the books do not cross
+        const double price = type.second * ( bid ? 0.7 + 0.3 * random.Real() : 1.0 + 0.3 * random.Real() );
+        const uint32 entered = 1 + random.Below( 10000 );
+        const uint32 remaining = 1 + random.Below( entered );
+        const uint32 duration = 90;
+        const uint64 issued = mNow - random.Below( duration * 24 ) * Win32Time_Hour;
+
+        orders.Int( mFirstOrderID + i );
+        orders.Int( type.first );
+        orders.Int( _CharacterID( random.Below( mParams.characters ) ) );
+        orders.Int( station.regionID );
+        orders.Int( station.stationID );
+        orders.Int( 32767 );
+        orders.Int( bid ? 1 : 0 );
+        orders.Real( price );
+        orders.Int( entered );
+        orders.Int( remaining );
+        orders.Int( issued );
+        orders.Int( 1 );
+        orders.Int( 1 );
+        orders.Int( 0 );
+        orders.Int( 1000 );
+        orders.Int( duration );
+        orders.Int( 0 );
+        orders.Int( station.solarSystemID );
+        orders.Int( 0 );
+        orders.Int( 1 );
+        orders.EndRow();
+    }
+
+    return orders.Close();
+}
+
+bool UniverseSeeder::_WriteMails( const Job& job )
+{
+    DataFile bodies, messages, recipients;
+    if( !bodies.Open( _GetDataFileName( TABLE_MAIL_BODY, job.chunk ) )
+        || !messages.Open( _GetDataFileName( TABLE_MAIL_MESSAGE, job.chunk ) )
+        || !recipients.Open( _GetDataFileName( TABLE_MAIL_RECIPIENT, job.chunk ) ) )
+    {
+        return false;
+    }
+
+    std::string body, title, to;
+    std::vector<uint32> toIDs;
+    for( uint32 i = job.first; i < job.first + job.count; ++i )
+    {
+        Random random( mParams.seed, JOB_MAILS, i );
+
+        const uint32 messageID = mFirstMessageID + i;
+        const uint32 bodyID = mFirstBodyID + i;
+        const uint32 senderID = _CharacterID( random.Below( mParams.characters ) );
+
+        title.clear();
+        for( uint32 w = 1 + random.Below( 6 ); 0 < w; --w )
+        {
+            if( !title.empty() )
+                title += ' ';
+            title += MAIL_WORDS[ random.Below( MAIL_WORD_COUNT ) ];
+        }
+
+        body.clear();
+        for( uint32 w = 10 + random.Below( 300 ); 0 < w; --w )
+        {
+            if( !body.empty() )
+                body += ( 0 == random.Below( 12 ) ? "<br>" : " " );
+            body += MAIL_WORDS[ random.Below( MAIL_WORD_COUNT ) ];
+        }
+
+        // the bodies are stored compressed, like MailStore does
+        Buffer input( body.begin(), body.end() );
+        Buffer compressed;
+        if( !DeflateData( input, compressed ) )
+        {
+            sLog.Error( "UniverseSeeder", "Failed to compress body of mail %u.", i );
+            return false;
+        }
+
+        bodies.Int( bodyID );
+        bodies.Int( CRC32::Generate( &compressed[ 0 ], compressed.size() ) );
+        bodies.Text( (const char*)&compressed[ 0 ], compressed.size() );
+        bodies.EndRow();
+
+        to.clear();
+        toIDs.clear();
+        for( uint32 r = 1 + random.Below( mParams.recipientsPerMail ); 0 < r; --r )
+        {
+            const uint32 characterID = _CharacterID( random.Below( mParams.characters ) );
+            if( std::find( toIDs.begin(), toIDs.end(), characterID ) != toIDs.end() )
+                continue;
+
+            char buf[ 16 ];
+            snprintf( buf, sizeof( buf ), "%s%u", ( to.empty() ? "" : "," ), characterID );
+            to += buf;
+            toIDs.push_back( characterID );
+        }
+
+        const uint32 period = 90 * 24 * 60;
+        const uint32 age = random.Below( period );
+        const uint64 sent = mNow - age * Win32Time_Minute;
+
+        messages.Int( messageID );
+        messages.Int( senderID );
+        messages.Text( to );
+        messages.Int( 0 );
+        messages.Int( 0 );
+        messages.Text( title );
+        messages.Int( bodyID );
+        messages.Int( sent );
+        messages.EndRow();
+
+        for( size_t r = 0; r < toIDs.size(); ++r )
+        {
+            recipients.Int( messageID );
+            recipients.Int( toIDs[ r ] );
+            recipients.Int( 0 );
+            recipients.Int( MAIL_LABEL_INBOX );
+            // the older a mail, the more likely it has been read
+            recipients.Int( random.Real() < 1.0 - 0.9 * age / period ? 1 : 0 );
+            recipients.EndRow();
+        }
+    }
+
+    const bool success = bodies.Close();
+    return messages.Close() && recipients.Close() && success;
+}
+
+bool UniverseSeeder::_WriteLoadScript( const std::string& fileName ) const
+{
+    FILE* out = fopen( fileName.c_str(), "w" );
+    if( NULL == out )
+    {
+        sLog.Error( "UniverseSeeder", "Unable to open output file '%s'", fileName.c_str() );
+        return false;
+    }
+
+    fprintf( out,
+             "-- Synthetic universe of %u characters, %u corporations, %u orders and %u mails (seed %u).\n"
+             "-- Run from the directory of the data files by: mysql --local-infile\n"
+             "\n"
+             "SET unique_checks = 0;\n"
+             "SET foreign_key_checks = 0;\n"
+             "\n",
+             mParams.characters, mParams.corporations, mParams.orders, mParams.mails, mParams.seed );
+
+    for( uint8 table = 0; table < TABLE_COUNT; ++table )
+    {
+        std::vector<Job>::const_iterator cur, end;
+        cur = mJobs.begin();
+        end = mJobs.end();
+        for(; cur != end; ++cur)
+        {
+            if( TABLE_JOBS[ table ] != cur->kind )
+                continue;
+
+            fprintf( out,
+                     "LOAD DATA LOCAL INFILE '%s' INTO TABLE `%s`(%s);\n",
+                     _GetDataFileName( table, cur->chunk ).c_str(),
+                     TABLE_NAMES[ table ],
+                     TABLE_COLUMNS[ table ] );
+        }
+    }
+
+    fprintf( out,
+             "\n"
+             "SET foreign_key_checks = 1;\n"
+             "SET unique_checks = 1;\n" );
+
+    const bool success = ( 0 == ferror( out ) );
+    return ( 0 == fclose( out ) ) && success;
+}
+
+std::string UniverseSeeder::_GetDataFileName( uint8 table, uint32 chunk ) const
+{
+    char buf[ 64 ];
+    snprintf( buf, sizeof( buf ), ".%s.%u.tsv", TABLE_NAMES[ table ], chunk );
+
+    return mPrefix + buf;
+}
+
+void UniverseSeeder::_Work()
+{
+    while( true )
+    {
+        // the chunks are taken in order, one at a time
+        const uint32 index = AtomicAdd( &mTaken, 1 ) - 1;
+        if( mJobs.size() <= index )
+            break;
+
+        const Job& job = mJobs[ index ];
+
+        bool success = false;
+        switch( job.kind )
+        {
+            case JOB_CHARACTERS:   success = _WriteCharacters( job );   break;
+            case JOB_CORPORATIONS: success = _WriteCorporations( job ); break;
+            case JOB_ORDERS:       success = _WriteOrders( job );       break;
+            case JOB_MAILS:        success = _WriteMails( job );        break;
+        }
+
+        if( success )
+            AtomicAdd( &mSucceeded, 1 );
+    }
+}
+
+#ifdef WIN32
+DWORD WINAPI UniverseSeeder::WorkerLoop( LPVOID arg )
+#else /* !WIN32 */
+void* UniverseSeeder::WorkerLoop( void* arg )
+#endif /* !WIN32 */
+{
+    UniverseSeeder* seeder = reinterpret_cast< UniverseSeeder* >( arg );
+    assert( seeder != NULL );
+
+    seeder->_Work();
+
+#ifdef WIN32
+    return 0;
+#else /* !WIN32 */
+    return NULL;
+#endif /* !WIN32 */
+}
@@ -49,6 +49,8 @@ bool ClassCloneGenerator::ProcessElementDef( const TiXmlElement* field )
         return false;
     }
 
+    mBorrow = IsBorrowed( field );
+
     fprintf( mOutputFile,
         "%s& %s::operator=( const %s& oth )\n"
         "{\n",
@@ -58,6 +60,12 @@ bool ClassCloneGenerator::ProcessElementDef( const TiXmlElement* field )
     if( !ParseElementChildren( field ) )
         return false;
 
+    if( mBorrow )
+        fprintf( mOutputFile,
+            "    mBorrowedFrom = oth.mBorrowedFrom;\n"
+            "\n"
+        );
+
     fprintf( mOutputFile,
         "    return *this;\n"
         "}\n"
@@ -235,19 +243,27 @@ bool ClassCloneGenerator::ProcessBuffer( const TiXmlElement* field )
         return false;
     }
 
-    fprintf( mOutputFile,
-        "    PySafeDecRef( %s );\n"
-        "    if( oth.%s == NULL )\n"
-        "        %s = NULL;\n" //TODO: log an error
-        "    else\n"
-        "        %s = new PyBuffer( *oth.%s );\n"
-        "\n",
-        name,
-        name,
+    //borrowed buffers are shared along with the decoded tree
+    if( mBorrow )
+        fprintf( mOutputFile,
+            "    %s = oth.%s;\n"
+            "\n",
+            name, name
+        );
+    else
+        fprintf( mOutputFile,
+            "    PySafeDecRef( %s );\n"
+            "    if( oth.%s == NULL )\n"
+            "        %s = NULL;\n" //TODO: log an error
+            "    else\n"
+            "        %s = new PyBuffer( *oth.%s );\n"
+            "\n",
             name,
+            name,
+                name,
 
-            name, name
-    );
+                name, name
+        );
 
     return true;
 }
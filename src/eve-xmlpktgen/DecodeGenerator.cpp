@@ -44,6 +44,8 @@ bool ClassDecodeGenerator::ProcessElementDef( const TiXmlElement* field )
         return false;
     }
 
+    mBorrow = IsBorrowed( field );
+
     const TiXmlElement* main = field->FirstChildElement();
 
     fprintf( mOutputFile,
@@ -52,6 +54,13 @@ bool ClassDecodeGenerator::ProcessElementDef( const TiXmlElement* field )
         mName
     );
 
+    //keep the tree alive for the borrowed fields
+    if( mBorrow )
+        fprintf( mOutputFile,
+            "    mBorrowedFrom = RefPtr<PyRep>( packet );\n"
+            "\n"
+        );
+
     mItemNumber = 0;
 
     push( "packet" );
@@ -390,31 +399,49 @@ bool ClassDecodeGenerator::ProcessBuffer( const TiXmlElement* field )
     }
 
     const char* v = top();
-    fprintf( mOutputFile,
-        "    PySafeDecRef( %s );\n"
-        "    if( %s->IsBuffer() )\n"
-        "    {\n"
-        "        %s = %s->AsBuffer();\n"
-        "        PyIncRef( %s );\n"
-        "    }\n"
-        "    else if( %s->IsString() )\n"
-        "        %s = new PyBuffer( *%s->AsString() );\n"
-        "    else\n"
-        "    {\n"
-        "        _log(NET__PACKET_ERROR, \"Decode %s failed: %s is not a buffer: %%s\", %s->TypeString());\n"
-        "\n"
-        "        return false;\n"
-        "    }\n"
-        "\n",
-        name,
-        v,
-            name, v,
+    //borrowed buffers are neither referenced nor converted from strings
+    if( mBorrow )
+        fprintf( mOutputFile,
+            "    if( %s->IsBuffer() )\n"
+            "        %s = %s->AsBuffer();\n"
+            "    else\n"
+            "    {\n"
+            "        _log(NET__PACKET_ERROR, \"Decode %s failed: %s is not a buffer: %%s\", %s->TypeString());\n"
+            "\n"
+            "        return false;\n"
+            "    }\n"
+            "\n",
+            v,
+                name, v,
+
+                mName, name, v
+        );
+    else
+        fprintf( mOutputFile,
+            "    PySafeDecRef( %s );\n"
+            "    if( %s->IsBuffer() )\n"
+            "    {\n"
+            "        %s = %s->AsBuffer();\n"
+            "        PyIncRef( %s );\n"
+            "    }\n"
+            "    else if( %s->IsString() )\n"
+            "        %s = new PyBuffer( *%s->AsString() );\n"
+            "    else\n"
+            "    {\n"
+            "        _log(NET__PACKET_ERROR, \"Decode %s failed: %s is not a buffer: %%s\", %s->TypeString());\n"
+            "\n"
+            "        return false;\n"
+            "    }\n"
+            "\n",
             name,
-        v,
-            name, v,
+            v,
+                name, v,
+                name,
+            v,
+                name, v,
 
-            mName, name, v
-    );
+                mName, name, v
+        );
 
     pop();
     return true;
@@ -1080,6 +1107,48 @@ bool ClassDecodeGenerator::ProcessListInt( const TiXmlElement* field )
     snprintf( iname, sizeof( iname ), "list_%u", mItemNumber++ );
 
     const char* v = top();
+    //borrowed lists are only checked to contain integers
+    if( mBorrow )
+    {
+        fprintf( mOutputFile,
+            "    if( !%s->IsList() )\n"
+            "    {\n"
+            "        _log( NET__PACKET_ERROR, \"Decode %s failed: %s is not a list: %%s\", %s->TypeString() );\n"
+            "\n"
+            "        return false;\n"
+            "    }\n"
+            "    PyList* %s = %s->AsList();\n"
+            "\n"
+            "    PyList::const_iterator %s_cur, %s_end;\n"
+            "    %s_cur = %s->begin();\n"
+            "    %s_end = %s->end();\n"
+            "    for( uint32 %s_index = 0; %s_cur != %s_end; %s_cur++, %s_index++ )\n"
+            "    {\n"
+            "        if( !(*%s_cur)->IsInt() )\n"
+            "        {\n"
+            "            _log(NET__PACKET_ERROR, \"Decode %s failed: Element %%u in list %s is not an integer: %%s\", %s_index, (*%s_cur)->TypeString());\n"
+            "\n"
+            "            return false;\n"
+            "        }\n"
+            "    }\n"
+            "    %s = %s;\n"
+            "\n",
+            v,
+                mName, name, v,
+            iname, v,
+            iname, iname,
+            iname, iname,
+            iname, iname,
+            iname, iname, iname, iname, iname,
+                iname,
+                    mName, iname, iname, iname,
+            name, iname
+        );
+
+        pop();
+        return true;
+    }
+
     //make sure its a list
     fprintf( mOutputFile,
         "    if( !%s->IsList() )\n"
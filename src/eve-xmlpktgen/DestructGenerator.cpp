@@ -49,6 +49,8 @@ bool ClassDestructGenerator::ProcessElementDef( const TiXmlElement* field )
         return false;
     }
 
+    mBorrow = IsBorrowed( field );
+
     fprintf( mOutputFile,
         "%s::~%s()\n"
         "{\n",
@@ -139,10 +141,12 @@ bool ClassDestructGenerator::ProcessBuffer( const TiXmlElement* field )
         return false;
     }
 
-    fprintf( mOutputFile,
-        "    PySafeDecRef( %s );\n",
-        name
-    );
+    //borrowed buffers are not referenced
+    if( !mBorrow )
+        fprintf( mOutputFile,
+            "    PySafeDecRef( %s );\n",
+            name
+        );
 
     return true;
 }
@@ -49,6 +49,8 @@ bool ClassDumpGenerator::ProcessElementDef( const TiXmlElement* field )
         return false;
     }
 
+    mBorrow = IsBorrowed( field );
+
     fprintf( mOutputFile,
         "void %s::Dump( LogType l_type, const char* pfx ) const\n"
         "{\n"
@@ -558,14 +560,14 @@ bool ClassDumpGenerator::ProcessListInt( const TiXmlElement* field )
     fprintf( mOutputFile,
         "    _log( l_type, \"%%s%s: Integer list with %%lu entries\", pfx, %s.size() );\n"
         "\n"
-        "    std::vector<int32>::const_iterator %s_cur, %s_end;\n"
+        "    %s::const_iterator %s_cur, %s_end;\n"
         "    %s_cur = %s.begin();\n"
         "    %s_end = %s.end();\n"
         "    for( int %s_index = 0; %s_cur != %s_end; %s_cur++, %s_index++ )\n"
         "        _log( l_type, \"%%s   [%%02d] %%d\", pfx, %s_index, *%s_cur );\n"
         "\n",
         name, name,
-        name, name,
+        mBorrow ? "PyIntListView" : "std::vector<int32>", name, name,
         name, name,
         name, name,
         name, name, name, name, name,
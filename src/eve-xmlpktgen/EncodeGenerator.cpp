@@ -44,6 +44,8 @@ bool ClassEncodeGenerator::ProcessElementDef( const TiXmlElement* field )
         return false;
     }
 
+    mBorrow = IsBorrowed( field );
+
     const TiXmlElement* main = field->FirstChildElement();
     if( main->NextSiblingElement() != NULL )
     {
@@ -361,11 +363,18 @@ bool ClassEncodeGenerator::ProcessStringInline( const TiXmlElement* field )
         return false;
     }
 
+    // the token looks up the string table once, not every marshal
+    const uint32 num = mItemNumber++;
+
     const char* v = top();
     fprintf( mOutputFile,
-        "    %s = new PyString( \"%s\" );\n"
+        "    {\n"
+        "        static const MarshalStringToken str%u( \"%s\" );\n"
+        "        %s = new PyString( str%u );\n"
+        "    }\n"
         "\n",
-        v, value
+        num, value,
+        v, num
     );
 
     pop();
@@ -839,7 +848,7 @@ bool ClassEncodeGenerator::ProcessListInt( const TiXmlElement* field )
 
     fprintf( mOutputFile,
         "    PyList* %s = new PyList;\n"
-        "    std::vector<int32>::const_iterator %s_cur, %s_end;\n"
+        "    %s::const_iterator %s_cur, %s_end;\n"
         "    %s_cur = %s.begin();\n"
         "    %s_end = %s.end();\n"
         "    for(; %s_cur != %s_end; %s_cur++)\n"
@@ -849,7 +858,7 @@ bool ClassEncodeGenerator::ProcessListInt( const TiXmlElement* field )
         "    %s = %s;\n"
         "\n",
         rname,
-        name, name,
+        mBorrow ? "PyIntListView" : "std::vector<int32>", name, name,
         name, name,
         name, name,
         name, name, name,
@@ -0,0 +1,1028 @@
+/*
+    ------------------------------------------------------------------------------------
+    LICENSE:
+    ------------------------------------------------------------------------------------
+    This file is part of EVEmu: EVE Online Server Emulator
+    Copyright 2006 - 2011 The EVEmu Team
+    For the latest information visit http://evemu.org
+    ------------------------------------------------------------------------------------
+    This program is free software; you can redistribute it and/or modify it under
+    the terms of the GNU Lesser General Public License as published by the Free Software
+    Foundation; either version 2 of the License, or (at your option) any later
+    version.
+
+    This program is distributed in the hope that it will be useful, but WITHOUT
+    ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+    FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public License along with
+    this program; if not, write to the Free Software Foundation, Inc., 59 Temple
+    Place - Suite 330, Boston, MA 02111-1307, USA, or go to
+    http://www.gnu.org/copyleft/lesser.txt.
+    ------------------------------------------------------------------------------------
+    Author:     EVEmu Team
+*/
+
+#include "eve-xmlpktgen.h"
+
+#include "EncodeToGenerator.h"
+
+/************************************************************************/
+/* ClassEncodeToGenerator                                               */
+/************************************************************************/
+bool ClassEncodeToGenerator::smStringTableLoaded = false;
+std::map<std::string, uint8> ClassEncodeToGenerator::smStringTable;
+
+ClassEncodeToGenerator::ClassEncodeToGenerator( FILE* outputFile )
+: Generator( outputFile ),
+  mItemNumber( 0 ),
+  mName( NULL )
+{
+    RegisterProcessors();
+}
+
+bool ClassEncodeToGenerator::ProcessElementDef( const TiXmlElement* field )
+{
+    mName = field->Attribute( "name" );
+    if( mName == NULL )
+    {
+        _log( COMMON__ERROR, "<element> at line %d is missing the name attribute, skipping.", field->Row() );
+        return false;
+    }
+
+    mBorrow = IsBorrowed( field );
+
+    const TiXmlElement* main = field->FirstChildElement();
+    if( main->NextSiblingElement() != NULL )
+    {
+        _log( COMMON__ERROR, "<element> at line %d contains more than one root element. skipping.", field->Row() );
+        return false;
+    }
+
+    fprintf( mOutputFile,
+        "bool %s::EncodeTo( MarshalStream& into ) const\n"
+        "{\n",
+        mName
+    );
+
+    mItemNumber = 0;
+
+    if( !ParseElement( main ) )
+        return false;
+
+    fprintf( mOutputFile,
+        "    return true;\n"
+        "}\n"
+        "\n"
+        "bool %s::EncodeTo( Buffer& into ) const\n"
+        "{\n"
+        "    MarshalStream stream;\n"
+        "    return stream.SaveEncoded( *this, into );\n"
+        "}\n"
+        "\n",
+        mName
+    );
+
+    return true;
+}
+
+bool ClassEncodeToGenerator::ProcessElement( const TiXmlElement* field )
+{
+    const char* name = field->Attribute( "name" );
+    if( name == NULL )
+    {
+        _log( COMMON__ERROR, "field at line %d is missing the name attribute, skipping.", field->Row() );
+        return false;
+    }
+
+    fprintf( mOutputFile,
+        "    if( !%s.EncodeTo( into ) )\n"
+        "        return false;\n"
+        "\n",
+        name
+    );
+
+    return true;
+}
+
+bool ClassEncodeToGenerator::ProcessElementPtr( const TiXmlElement* field )
+{
+    const char* name = field->Attribute( "name" );
+    if( name == NULL )
+    {
+        _log( COMMON__ERROR, "field at line %d is missing the name attribute, skipping.", field->Row() );
+        return false;
+    }
+
+    fprintf( mOutputFile,
+        "    if( NULL == %s )\n"
+        "    {\n"
+        "        _log(NET__PACKET_ERROR, \"EncodeTo %s: %s is NULL! hacking in a PyNone\");\n"
+        "        into.SaveNone();\n"
+        "    }\n"
+        "    else if( !%s->EncodeTo( into ) )\n"
+        "        return false;\n"
+        "\n",
+        name,
+            mName, name,
+        name
+    );
+
+    return true;
+}
+
+bool ClassEncodeToGenerator::ProcessRaw( const TiXmlElement* field )
+{
+    const char* name = field->Attribute( "name" );
+    if( name == NULL )
+    {
+        _log( COMMON__ERROR, "field at line %d is missing the name attribute, skipping.", field->Row() );
+        return false;
+    }
+
+    SaveRepField( name, false );
+    return true;
+}
+
+bool ClassEncodeToGenerator::ProcessInt( const TiXmlElement* field )
+{
+    const char* name = field->Attribute( "name" );
+    if( name == NULL )
+    {
+        _log( COMMON__ERROR, "field at line %d is missing the name attribute, skipping.", field->Row() );
+        return false;
+    }
+
+    const char* none_marker = field->Attribute( "none_marker" );
+    if( none_marker != NULL )
+        fprintf( mOutputFile,
+            "    if( %s == %s )\n"
+            "        into.SaveNone();\n"
+            "    else\n",
+            name, none_marker
+        );
+
+    fprintf( mOutputFile,
+        "        into.SaveInt( %s );\n"
+        "\n",
+        name
+    );
+
+    return true;
+}
+
+bool ClassEncodeToGenerator::ProcessLong( const TiXmlElement* field )
+{
+    const char* name = field->Attribute( "name" );
+    if( name == NULL )
+    {
+        _log( COMMON__ERROR, "field at line %d is missing the name attribute, skipping.", field->Row() );
+        return false;
+    }
+
+    const char* none_marker = field->Attribute( "none_marker" );
+    if( none_marker != NULL )
+        fprintf( mOutputFile,
+            "    if( %s == %s )\n"
+            "        into.SaveNone();\n"
+            "    else\n",
+            name, none_marker
+        );
+
+    fprintf( mOutputFile,
+        "        into.SaveLong( %s );\n"
+        "\n",
+        name
+    );
+
+    return true;
+}
+
+bool ClassEncodeToGenerator::ProcessReal( const TiXmlElement* field )
+{
+    const char* name = field->Attribute( "name" );
+    if( name == NULL )
+    {
+        _log( COMMON__ERROR, "field at line %d is missing the name attribute, skipping.", field->Row() );
+        return false;
+    }
+
+    const char* none_marker = field->Attribute( "none_marker" );
+    if( none_marker != NULL )
+        fprintf( mOutputFile,
+            "    if( %s == %s )\n"
+            "        into.SaveNone();\n"
+            "    else\n",
+            name, none_marker
+        );
+
+    fprintf( mOutputFile,
+        "        into.SaveReal( %s );\n"
+        "\n",
+        name
+    );
+
+    return true;
+}
+
+bool ClassEncodeToGenerator::ProcessBool( const TiXmlElement* field )
+{
+    const char* name = field->Attribute( "name" );
+    if( name == NULL )
+    {
+        _log( COMMON__ERROR, "field at line %d is missing the name attribute, skipping.", field->Row() );
+        return false;
+    }
+
+    fprintf( mOutputFile,
+        "    into.SaveBool( %s );\n"
+        "\n",
+        name
+    );
+
+    return true;
+}
+
+bool ClassEncodeToGenerator::ProcessNone( const TiXmlElement* field )
+{
+    fprintf( mOutputFile,
+        "    into.SaveNone();\n"
+        "\n"
+    );
+
+    return true;
+}
+
+bool ClassEncodeToGenerator::ProcessBuffer( const TiXmlElement* field )
+{
+    const char* name = field->Attribute( "name" );
+    if( name == NULL )
+    {
+        _log( COMMON__ERROR, "field at line %d is missing the name attribute, skipping.", field->Row() );
+        return false;
+    }
+
+    fprintf( mOutputFile,
+        "    if( NULL == %s )\n"
+        "    {\n"
+        "        _log(NET__PACKET_ERROR, \"EncodeTo %s: %s is NULL! hacking in an empty buffer.\");\n"
+        "        into.SaveBuffer( NULL, 0 );\n"
+        "    }\n"
+        "    else if( !into.SaveRep( %s ) )\n"
+        "        return false;\n"
+        "\n",
+        name,
+            mName, name,
+        name
+    );
+
+    return true;
+}
+
+bool ClassEncodeToGenerator::ProcessString( const TiXmlElement* field )
+{
+    const char* name = field->Attribute( "name" );
+    if( name == NULL )
+    {
+        _log( COMMON__ERROR, "field at line %d is missing the name attribute, skipping.", field->Row() );
+        return false;
+    }
+
+    const char* none_marker = field->Attribute( "none_marker" );
+    if( none_marker != NULL )
+        fprintf( mOutputFile,
+            "    if( %s == \"%s\" )\n"
+            "        into.SaveNone();\n"
+            "    else\n",
+            name, none_marker
+        );
+
+    fprintf( mOutputFile,
+        "        into.SaveString( %s );\n"
+        "\n",
+        name
+    );
+
+    return true;
+}
+
+bool ClassEncodeToGenerator::ProcessStringInline( const TiXmlElement* field )
+{
+    const char* value = field->Attribute( "value" );
+    if( NULL == value )
+    {
+        _log( COMMON__ERROR, "String element at line %d has no value attribute.", field->Row() );
+        return false;
+    }
+
+    SaveStringConst( value );
+    return true;
+}
+
+bool ClassEncodeToGenerator::ProcessWString( const TiXmlElement* field )
+{
+    const char* name = field->Attribute( "name" );
+    if( name == NULL )
+    {
+        _log( COMMON__ERROR, "field at line %d is missing the name attribute, skipping.", field->Row() );
+        return false;
+    }
+
+    const char* none_marker = field->Attribute( "none_marker" );
+    if( none_marker != NULL )
+        fprintf( mOutputFile,
+            "    if( %s == \"%s\" )\n"
+            "        into.SaveNone();\n"
+            "    else\n",
+            name, none_marker
+        );
+
+    fprintf( mOutputFile,
+        "        into.SaveWString( %s );\n"
+        "\n",
+        name
+    );
+
+    return true;
+}
+
+bool ClassEncodeToGenerator::ProcessWStringInline( const TiXmlElement* field )
+{
+    const char* value = field->Attribute( "value" );
+    if( NULL == value )
+    {
+        _log( COMMON__ERROR, "WString element at line %d has no value attribute.", field->Row() );
+        return false;
+    }
+
+    fprintf( mOutputFile,
+        "    into.SaveWString( \"%s\", %lu );\n"
+        "\n",
+        value, strlen( value )
+    );
+
+    return true;
+}
+
+bool ClassEncodeToGenerator::ProcessToken( const TiXmlElement* field )
+{
+    const char* name = field->Attribute( "name" );
+    if( name == NULL )
+    {
+        _log( COMMON__ERROR, "field at line %d is missing the name attribute, skipping.", field->Row() );
+        return false;
+    }
+
+    bool optional = false;
+    const char* optional_str = field->Attribute( "optional" );
+    if( optional_str != NULL )
+        optional = str2<bool>( optional_str );
+
+    SaveRepField( name, optional );
+    return true;
+}
+
+bool ClassEncodeToGenerator::ProcessTokenInline( const TiXmlElement* field )
+{
+    const char* value = field->Attribute( "value" );
+    if( NULL == value )
+    {
+        _log( COMMON__ERROR, "Token element at line %d has no type attribute.", field->Row() );
+        return false;
+    }
+
+    fprintf( mOutputFile,
+        "    into.SaveToken( \"%s\", %lu );\n"
+        "\n",
+        value, strlen( value )
+    );
+
+    return true;
+}
+
+bool ClassEncodeToGenerator::ProcessObject( const TiXmlElement* field )
+{
+    const char* name = field->Attribute( "name" );
+    if( name == NULL )
+    {
+        _log( COMMON__ERROR, "field at line %d is missing the name attribute, skipping.", field->Row() );
+        return false;
+    }
+
+    bool optional = false;
+    const char* optional_str = field->Attribute( "optional" );
+    if( NULL != optional_str )
+        optional = str2<bool>( optional_str );
+
+    SaveRepField( name, optional );
+    return true;
+}
+
+bool ClassEncodeToGenerator::ProcessObjectInline( const TiXmlElement* field )
+{
+    fprintf( mOutputFile,
+        "    into.SaveObjectHeader();\n"
+        "\n"
+    );
+
+    // the type and the arguments, in this order
+    return ParseElementChildren( field, 2 );
+}
+
+bool ClassEncodeToGenerator::ProcessObjectEx( const TiXmlElement* field )
+{
+    const char* name = field->Attribute( "name" );
+    if( name == NULL )
+    {
+        _log( COMMON__ERROR, "field at line %d is missing the name attribute, skipping.", field->Row() );
+        return false;
+    }
+    const char* type = field->Attribute( "type" );
+    if( type == NULL )
+    {
+        _log( COMMON__ERROR, "field at line %d is missing the type attribute.", field->Row() );
+        return false;
+    }
+
+    bool optional = false;
+    const char* optional_str = field->Attribute( "optional" );
+    if( optional_str != NULL )
+        optional = str2<bool>( optional_str );
+
+    SaveRepField( name, optional );
+    return true;
+}
+
+bool ClassEncodeToGenerator::ProcessTuple( const TiXmlElement* field )
+{
+    const char* name = field->Attribute( "name" );
+    if( name == NULL )
+    {
+        _log( COMMON__ERROR, "field at line %d is missing the name attribute, skipping.", field->Row() );
+        return false;
+    }
+
+    bool optional = false;
+    const char* optional_str = field->Attribute( "optional" );
+    if( optional_str != NULL )
+        optional = str2<bool>( optional_str );
+
+    fprintf( mOutputFile,
+        "    if( %s == NULL )\n"
+        "    {\n"
+        "        _log(NET__PACKET_ERROR, \"EncodeTo %s: %s is NULL! hacking in an empty tuple.\");\n"
+        "        into.SaveTupleHeader( 0 );\n"
+        "    }\n"
+        "    else\n",
+        name,
+            mName, name
+    );
+
+    if( optional )
+        fprintf( mOutputFile,
+            "    if( %s->empty() )\n"
+            "        into.SaveNone();\n"
+            "    else\n",
+            name
+        );
+
+    fprintf( mOutputFile,
+        "    if( !into.SaveRep( %s ) )\n"
+        "        return false;\n"
+        "\n",
+        name
+    );
+
+    return true;
+}
+
+bool ClassEncodeToGenerator::ProcessTupleInline( const TiXmlElement* field )
+{
+    //first, we need to know how many elements this tuple has:
+    const TiXmlNode* i = NULL;
+
+    uint32 count = 0;
+    while( ( i = field->IterateChildren( i ) ) )
+    {
+        if( i->Type() == TiXmlNode::TINYXML_ELEMENT )
+            count++;
+    }
+
+    fprintf( mOutputFile,
+        "    into.SaveTupleHeader( %u );\n"
+        "\n",
+        count
+    );
+
+    return ParseElementChildren( field );
+}
+
+bool ClassEncodeToGenerator::ProcessList( const TiXmlElement* field )
+{
+    const char* name = field->Attribute( "name" );
+    if( name == NULL )
+    {
+        _log( COMMON__ERROR, "field at line %d is missing the name attribute, skipping.", field->Row() );
+        return false;
+    }
+
+    bool optional = false;
+    const char* optional_str = field->Attribute( "optional" );
+    if( optional_str != NULL )
+        optional = str2<bool>( optional_str );
+
+    fprintf( mOutputFile,
+        "    if( %s == NULL )\n"
+        "    {\n"
+        "        _log(NET__PACKET_ERROR, \"EncodeTo %s: %s is NULL! hacking in an empty list.\");\n"
+        "        into.SaveListHeader( 0 );\n"
+        "    }\n"
+        "    else\n",
+        name,
+            mName, name
+    );
+
+    if( optional )
+        fprintf( mOutputFile,
+            "    if( %s->empty() )\n"
+            "        into.SaveNone();\n"
+            "    else\n",
+            name
+        );
+
+    fprintf( mOutputFile,
+        "    if( !into.SaveRep( %s ) )\n"
+        "        return false;\n"
+        "\n",
+        name
+    );
+
+    return true;
+}
+
+bool ClassEncodeToGenerator::ProcessListInline( const TiXmlElement* field )
+{
+    //first, we need to know how many elements this list has:
+    const TiXmlNode* i = NULL;
+
+    uint32 count = 0;
+    while( ( i = field->IterateChildren( i ) ) )
+    {
+        if( i->Type() == TiXmlNode::TINYXML_ELEMENT )
+            count++;
+    }
+
+    fprintf( mOutputFile,
+        "    into.SaveListHeader( %u );\n"
+        "\n",
+        count
+    );
+
+    return ParseElementChildren( field );
+}
+
+bool ClassEncodeToGenerator::ProcessListInt( const TiXmlElement* field )
+{
+    const char* name = field->Attribute( "name" );
+    if( name == NULL )
+    {
+        _log( COMMON__ERROR, "field at line %d is missing the name attribute, skipping.", field->Row() );
+        return false;
+    }
+
+    fprintf( mOutputFile,
+        "    into.SaveListHeader( %s.size() );\n"
+        "    %s::const_iterator %s_cur, %s_end;\n"
+        "    %s_cur = %s.begin();\n"
+        "    %s_end = %s.end();\n"
+        "    for(; %s_cur != %s_end; %s_cur++)\n"
+        "        into.SaveInt( *%s_cur );\n"
+        "\n",
+        name,
+        mBorrow ? "PyIntListView" : "std::vector<int32>", name, name,
+        name, name,
+        name, name,
+        name, name, name,
+            name
+    );
+
+    return true;
+}
+
+bool ClassEncodeToGenerator::ProcessListLong( const TiXmlElement* field )
+{
+    const char* name = field->Attribute( "name" );
+    if( name == NULL )
+    {
+        _log( COMMON__ERROR, "field at line %d is missing the name attribute, skipping.", field->Row() );
+        return false;
+    }
+
+    fprintf( mOutputFile,
+        "    into.SaveListHeader( %s.size() );\n"
+        "    std::vector<int64>::const_iterator %s_cur, %s_end;\n"
+        "    %s_cur = %s.begin();\n"
+        "    %s_end = %s.end();\n"
+        "    for(; %s_cur != %s_end; %s_cur++)\n"
+        "        into.SaveLong( *%s_cur );\n"
+        "\n",
+        name,
+        name, name,
+        name, name,
+        name, name,
+        name, name, name,
+            name
+    );
+
+    return true;
+}
+
+bool ClassEncodeToGenerator::ProcessListStr( const TiXmlElement* field )
+{
+    const char* name = field->Attribute( "name" );
+    if( name == NULL )
+    {
+        _log( COMMON__ERROR, "field at line %d is missing the name attribute, skipping.", field->Row() );
+        return false;
+    }
+
+    fprintf( mOutputFile,
+        "    into.SaveListHeader( %s.size() );\n"
+        "    std::vector<std::string>::const_iterator %s_cur, %s_end;\n"
+        "    %s_cur = %s.begin();\n"
+        "    %s_end = %s.end();\n"
+        "    for(; %s_cur != %s_end; %s_cur++)\n"
+        "        into.SaveString( *%s_cur );\n"
+        "\n",
+        name,
+        name, name,
+        name, name,
+        name, name,
+        name, name, name,
+            name
+    );
+
+    return true;
+}
+
+bool ClassEncodeToGenerator::ProcessDict( const TiXmlElement* field )
+{
+    const char* name = field->Attribute( "name" );
+    if( name == NULL )
+    {
+        _log( COMMON__ERROR, "field at line %d is missing the name attribute, skipping.", field->Row() );
+        return false;
+    }
+
+    bool optional = false;
+    const char* optional_str = field->Attribute( "optional" );
+    if( optional_str != NULL )
+        optional = str2<bool>( optional_str );
+
+    fprintf( mOutputFile,
+        "    if( %s == NULL )\n"
+        "    {\n"
+        "        _log(NET__PACKET_ERROR, \"EncodeTo %s: %s is NULL! hacking in an empty dict.\");\n"
+        "        into.SaveDictHeader( 0 );\n"
+        "    }\n"
+        "    else\n",
+        name,
+            mName, name
+    );
+
+    if( optional )
+        fprintf( mOutputFile,
+            "    if( %s->empty() )\n"
+            "        into.SaveNone();\n"
+            "    else\n",
+            name
+        );
+
+    fprintf( mOutputFile,
+        "    if( !into.SaveRep( %s ) )\n"
+        "        return false;\n"
+        "\n",
+        name
+    );
+
+    return true;
+}
+
+bool ClassEncodeToGenerator::ProcessDictInline( const TiXmlElement* field )
+{
+    //first, we need to know how many entries this dict has:
+    const TiXmlNode* i = NULL;
+
+    uint32 count = 0;
+    while( ( i = field->IterateChildren( i ) ) )
+    {
+        if( i->Type() == TiXmlNode::TINYXML_ELEMENT
+            && strcmp( i->Value(), "dictInlineEntry" ) == 0 )
+            count++;
+    }
+
+    fprintf( mOutputFile,
+        "    into.SaveDictHeader( %u );\n"
+        "\n",
+        count
+    );
+
+    //now we process each entry, the value goes before the key:
+    while( ( i = field->IterateChildren( i ) ) )
+    {
+        if( i->Type() == TiXmlNode::TINYXML_ELEMENT )
+        {
+            const TiXmlElement* ele = i->ToElement();
+
+            //we only handle dictInlineEntry elements
+            if( strcmp( ele->Value(), "dictInlineEntry" ) != 0 )
+            {
+                _log( COMMON__ERROR, "non-dictInlineEntry in <dictInline> at line %d, ignoring.", ele->Row() );
+                continue;
+            }
+            const char* key = ele->Attribute( "key" );
+            if( key == NULL )
+            {
+                _log( COMMON__ERROR, "<dictInlineEntry> at line %d lacks a key attribute", ele->Row() );
+                return false;
+            }
+
+            bool keyTypeInt = false;
+            const char* keyType = ele->Attribute( "key_type" );
+            if( keyType != NULL )
+                keyTypeInt = ( strcmp( keyType, "int" ) == 0 );
+
+            if( !ParseElementChildren( ele, 1 ) )
+                return false;
+
+            if( keyTypeInt )
+                fprintf( mOutputFile,
+                    "    into.SaveInt( %s );\n"
+                    "\n",
+                    key
+                );
+            else
+                SaveStringConst( key );
+        }
+    }
+
+    return true;
+}
+
+bool ClassEncodeToGenerator::ProcessDictRaw( const TiXmlElement* field )
+{
+    const char* name = field->Attribute( "name" );
+    if( name == NULL )
+    {
+        _log( COMMON__ERROR, "field at line %d is missing the name attribute, skipping.", field->Row() );
+        return false;
+    }
+
+    const char* key = field->Attribute( "key" );
+    if( key == NULL )
+    {
+        _log( COMMON__ERROR, "field at line %d is missing the key attribute, skipping.", field->Row() );
+        return false;
+    }
+    const char* pykey = field->Attribute( "pykey" );
+    if( pykey == NULL )
+    {
+        _log( COMMON__ERROR, "field at line %d is missing the pykey attribute, skipping.", field->Row() );
+        return false;
+    }
+    const char* value = field->Attribute( "value" );
+    if( value == NULL )
+    {
+        _log( COMMON__ERROR, "field at line %d is missing the value attribute, skipping.", field->Row() );
+        return false;
+    }
+    const char* pyvalue = field->Attribute( "pyvalue" );
+    if( pyvalue == NULL )
+    {
+        _log( COMMON__ERROR, "field at line %d is missing the pyvalue attribute, skipping.", field->Row() );
+        return false;
+    }
+
+    const char* saveKey = GetSaveMethod( pykey );
+    if( saveKey == NULL )
+    {
+        _log( COMMON__ERROR, "field at line %d has unsupported pykey '%s'.", field->Row(), pykey );
+        return false;
+    }
+    const char* saveValue = GetSaveMethod( pyvalue );
+    if( saveValue == NULL )
+    {
+        _log( COMMON__ERROR, "field at line %d has unsupported pyvalue '%s'.", field->Row(), pyvalue );
+        return false;
+    }
+
+    fprintf( mOutputFile,
+        "    into.SaveDictHeader( %s.size() );\n"
+        "    std::map<%s, %s>::const_iterator %s_cur, %s_end;\n"
+        "    %s_cur = %s.begin();\n"
+        "    %s_end = %s.end();\n"
+        "    for(; %s_cur != %s_end; %s_cur++)\n"
+        "    {\n"
+        "        into.%s( %s_cur->second );\n"
+        "        into.%s( %s_cur->first );\n"
+        "    }\n"
+        "\n",
+        name,
+        key, value, name, name,
+        name, name,
+        name, name,
+        name, name, name,
+            saveValue, name,
+            saveKey, name
+    );
+
+    return true;
+}
+
+bool ClassEncodeToGenerator::ProcessDictInt( const TiXmlElement* field )
+{
+    const char* name = field->Attribute( "name" );
+    if( name == NULL )
+    {
+        _log( COMMON__ERROR, "field at line %d is missing the name attribute, skipping.", field->Row() );
+        return false;
+    }
+
+    fprintf( mOutputFile,
+        "    into.SaveDictHeader( %s.size() );\n"
+        "    std::map<int32, PyRep*>::const_iterator %s_cur, %s_end;\n"
+        "    %s_cur = %s.begin();\n"
+        "    %s_end = %s.end();\n"
+        "    for(; %s_cur != %s_end; %s_cur++)\n"
+        "    {\n"
+        "        if( !into.SaveRep( %s_cur->second ) )\n"
+        "            return false;\n"
+        "        into.SaveInt( %s_cur->first );\n"
+        "    }\n"
+        "\n",
+        name,
+        name, name,
+        name, name,
+        name, name,
+        name, name, name,
+            name,
+            name
+    );
+
+    return true;
+}
+
+bool ClassEncodeToGenerator::ProcessDictStr( const TiXmlElement* field )
+{
+    const char* name = field->Attribute( "name" );
+    if( name == NULL )
+    {
+        _log( COMMON__ERROR, "field at line %d is missing the name attribute, skipping.", field->Row() );
+        return false;
+    }
+
+    fprintf( mOutputFile,
+        "    into.SaveDictHeader( %s.size() );\n"
+        "    std::map<std::string, PyRep*>::const_iterator %s_cur, %s_end;\n"
+        "    %s_cur = %s.begin();\n"
+        "    %s_end = %s.end();\n"
+        "    for(; %s_cur != %s_end; %s_cur++)\n"
+        "    {\n"
+        "        if( !into.SaveRep( %s_cur->second ) )\n"
+        "            return false;\n"
+        "        into.SaveString( %s_cur->first );\n"
+        "    }\n"
+        "\n",
+        name,
+        name, name,
+        name, name,
+        name, name,
+        name, name, name,
+            name,
+            name
+    );
+
+    return true;
+}
+
+bool ClassEncodeToGenerator::ProcessSubStreamInline( const TiXmlElement* field )
+{
+    char varname[16];
+    snprintf( varname, sizeof( varname ), "ss_%u", mItemNumber++ );
+
+    fprintf( mOutputFile,
+        "    const size_t %s = into.BeginSubStream();\n"
+        "\n",
+        varname
+    );
+
+    if( !ParseElementChildren( field, 1 ) )
+        return false;
+
+    fprintf( mOutputFile,
+        "    into.EndSubStream( %s );\n"
+        "\n",
+        varname
+    );
+
+    return true;
+}
+
+bool ClassEncodeToGenerator::ProcessSubStructInline( const TiXmlElement* field )
+{
+    fprintf( mOutputFile,
+        "    into.SaveSubStructHeader();\n"
+        "\n"
+    );
+
+    return ParseElementChildren( field, 1 );
+}
+
+void ClassEncodeToGenerator::SaveRepField( const char* name, bool optional )
+{
+    if( optional )
+        fprintf( mOutputFile,
+            "    if( NULL == %s )\n"
+            "        into.SaveNone();\n"
+            "    else\n",
+            name
+        );
+    else
+        fprintf( mOutputFile,
+            "    if( NULL == %s )\n"
+            "    {\n"
+            "        _log(NET__PACKET_ERROR, \"EncodeTo %s: %s is NULL! hacking in a PyNone\");\n"
+            "        into.SaveNone();\n"
+            "    }\n"
+            "    else\n",
+            name,
+                mName, name
+        );
+
+    fprintf( mOutputFile,
+        "    if( !into.SaveRep( %s ) )\n"
+        "        return false;\n"
+        "\n",
+        name
+    );
+}
+
+void ClassEncodeToGenerator::SaveStringConst( const char* str )
+{
+    const uint8 index = LookupStringIndex( str );
+    if( 0 != index )
+        fprintf( mOutputFile,
+            "    into.SaveString( \"%s\", %lu, %u );\n"
+            "\n",
+            str, strlen( str ), index
+        );
+    else
+        fprintf( mOutputFile,
+            "    into.SaveString( \"%s\", %lu, STRING_TABLE_ERROR );\n"
+            "\n",
+            str, strlen( str )
+        );
+}
+
+const char* ClassEncodeToGenerator::GetSaveMethod( const char* pyType )
+{
+    if( strcmp( pyType, "Int" ) == 0 )
+        return "SaveInt";
+    else if( strcmp( pyType, "Long" ) == 0 )
+        return "SaveLong";
+    else if( strcmp( pyType, "Float" ) == 0 )
+        return "SaveReal";
+    else if( strcmp( pyType, "Bool" ) == 0 )
+        return "SaveBool";
+    else if( strcmp( pyType, "String" ) == 0 )
+        return "SaveString";
+    else if( strcmp( pyType, "WString" ) == 0 )
+        return "SaveWString";
+    else
+        return NULL;
+}
+
+uint8 ClassEncodeToGenerator::LookupStringIndex( const char* str )
+{
+    if( !smStringTableLoaded )
+    {
+        // the same list MarshalStringTable has, indexed from 1
+        static const char* const strings[] =
+        {
+#define MARSHAL_STRING( str ) str,
+#include "marshal/EVEMarshalStrings.h"
+#undef MARSHAL_STRING
+        };
+
+        for( size_t i = 0; i < sizeof( strings ) / sizeof( const char* ); ++i )
+            smStringTable[ strings[ i ] ] = (uint8)( i + 1 );
+
+        smStringTableLoaded = true;
+    }
+
+    std::map<std::string, uint8>::const_iterator res = smStringTable.find( str );
+    if( res == smStringTable.end() )
+        return 0;
+
+    return res->second;
+}
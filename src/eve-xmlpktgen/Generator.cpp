@@ -34,7 +34,8 @@ bool Generator::smEncTypesLoaded = false;
 std::map<std::string, std::string> Generator::smEncTypes;
 
 Generator::Generator( FILE* outputFile )
-: mOutputFile( outputFile )
+: mOutputFile( outputFile ),
+  mBorrow( false )
 {
     LoadEncTypes();
 }
@@ -90,6 +91,15 @@ const char* Generator::GetEncodeType( const TiXmlElement* element )
     return res->second.c_str();
 }
 
+bool Generator::IsBorrowed( const TiXmlElement* elementDef )
+{
+    const char* borrow = elementDef->Attribute( "borrow" );
+    if( borrow == NULL )
+        return false;
+
+    return str2<bool>( borrow );
+}
+
 void Generator::LoadEncTypes()
 {
     if( !smEncTypesLoaded )
@@ -28,7 +28,8 @@
 #include "HeaderGenerator.h"
 
 ClassHeaderGenerator::ClassHeaderGenerator( FILE* outputFile )
-: Generator( outputFile )
+: Generator( outputFile ),
+  mEncodeTo( false )
 {
     RegisterProcessors();
 }
@@ -67,6 +68,8 @@ bool ClassHeaderGenerator::ProcessElementDef( const TiXmlElement* field )
         return false;
     }
 
+    mBorrow = IsBorrowed( field );
+
     const TiXmlElement* main = field->FirstChildElement();
     if( main->NextSiblingElement() != NULL )
     {
@@ -88,10 +91,7 @@ bool ClassHeaderGenerator::ProcessElementDef( const TiXmlElement* field )
         "    bool Decode( PyRep* packet );\n"
         "    bool Decode( PyRep** packet );\n"
         "    bool Decode( %s** packet );\n"
-        "    %s* Encode() const;\n"
-        "\n"
-        "    %s& operator=( const %s& oth );\n"
-        "\n",
+        "    %s* Encode() const;\n",
         name,
 
         name,
@@ -99,14 +99,33 @@ bool ClassHeaderGenerator::ProcessElementDef( const TiXmlElement* field )
         name,
 
             encode_type,
-        encode_type,
+        encode_type
+    );
+
+    if( mEncodeTo )
+        fprintf( mOutputFile,
+            "    bool EncodeTo( MarshalStream& into ) const;\n"
+            "    bool EncodeTo( Buffer& into ) const;\n"
+        );
 
+    fprintf( mOutputFile,
+        "\n"
+        "    %s& operator=( const %s& oth );\n"
+        "\n",
         name, name
     );
 
     if( !ParseElement( main ) )
         return false;
 
+    if( mBorrow )
+        fprintf( mOutputFile,
+            "\n"
+            "protected:\n"
+            "    /** The decoded tree the borrowed fields point into. */\n"
+            "    RefPtr<PyRep>\tmBorrowedFrom;\n"
+        );
+
     fprintf( mOutputFile,
         "};\n"
         "\n"
@@ -307,7 +326,8 @@ bool ClassHeaderGenerator::ProcessString( const TiXmlElement* field )
         return false;
 
     fprintf( mOutputFile,
-        "    std::string\t\t%s;\n",
+        "    %s%s;\n",
+        mBorrow ? "PyStringView\t" : "std::string\t\t",
         name
     );
 
@@ -332,7 +352,8 @@ bool ClassHeaderGenerator::ProcessWString( const TiXmlElement* field )
         return false;
 
     fprintf( mOutputFile,
-        "    std::string\t\t%s;\n",
+        "    %s%s;\n",
+        mBorrow ? "PyStringView\t" : "std::string\t\t",
         name
     );
 
@@ -480,7 +501,8 @@ bool ClassHeaderGenerator::ProcessListInt( const TiXmlElement* field )
         return false;
 
     fprintf( mOutputFile,
-        "    std::vector<int32>\t%s;\n",
+        "    %s%s;\n",
+        mBorrow ? "PyIntListView\t" : "std::vector<int32>\t",
         name
     );
 
@@ -60,7 +60,8 @@ XMLPacketGen::XMLPacketGen( const char* header, const char* source )
 : mHeaderFile( NULL ),
   mHeaderFileName( header ),
   mSourceFile( NULL ),
-  mSourceFileName( source )
+  mSourceFileName( source ),
+  mEncodeToEnabled( false )
 {
     AddMemberParser( "elements",   &XMLPacketGen::ParseElements );
     AddMemberParser( "include",    &XMLPacketGen::ParseInclude );
@@ -93,16 +94,24 @@ bool XMLPacketGen::ParseElements( const TiXmlElement* field )
         "\n"
         "#include \"python/PyVisitor.h\"\n"
         "#include \"python/PyRep.h\"\n"
+        "#include \"python/PyRepView.h\"\n"
         "\n",
         smGenFileComment,
         def.c_str(),
         def.c_str()
     );
+    if( mEncodeToEnabled )
+        fprintf( mHeaderFile,
+            "class MarshalStream;\n"
+            "\n"
+        );
     fprintf( mSourceFile,
         "%s\n"
         "\n"
         "#include \"eve-common.h\"\n"
         "\n"
+        "#include \"marshal/EVEMarshal.h\"\n"
+        "#include \"marshal/EVEMarshalStringTable.h\"\n"
         "#include \"%s\"\n"
         "\n",
         smGenFileComment,
@@ -147,6 +156,7 @@ bool XMLPacketGen::ParseElementDef( const TiXmlElement* field )
                  && mDestruct.ParseElement( field )
                  && mDump.ParseElement( field )
                  && mEncode.ParseElement( field )
+                 && ( !mEncodeToEnabled || mEncodeTo.ParseElement( field ) )
                  && mHeader.ParseElement( field ) );
 
     return res;
@@ -185,12 +195,21 @@ void XMLPacketGen::SetSourceFile( const char* source )
             mDestruct.SetOutputFile( NULL );
             mDump.SetOutputFile( NULL );
             mEncode.SetOutputFile( NULL );
+            mEncodeTo.SetOutputFile( NULL );
         }
 
         mSourceFileName = source;
     }
 }
 
+void XMLPacketGen::SetEncodeTo( bool encodeTo )
+{
+    mEncodeToEnabled = encodeTo;
+
+    // the header must declare what the source defines
+    mHeader.SetEncodeTo( encodeTo );
+}
+
 bool XMLPacketGen::OpenFiles()
 {
     bool res = true;
@@ -223,6 +242,7 @@ bool XMLPacketGen::OpenFiles()
             mDestruct.SetOutputFile( mSourceFile );
             mDump.SetOutputFile( mSourceFile );
             mEncode.SetOutputFile( mSourceFile );
+            mEncodeTo.SetOutputFile( mSourceFile );
         }
     }
 
@@ -42,6 +42,7 @@ int main( int argc, char* argv[] )
 
     std::string dirInclude = ".";
     std::string dirSource = ".";
+    bool encodeTo = false;
 
     // parse options
     for(; 0 < argc; --argc, ++argv )
@@ -82,6 +83,11 @@ int main( int argc, char* argv[] )
                 }
                 break;
 
+            /* direct-to-wire encoders */
+            case 'w':
+                encodeTo = true;
+                break;
+
             /* help */
             case 'h':
                 usage();
@@ -102,6 +108,8 @@ int main( int argc, char* argv[] )
 
     // process files
     XMLPacketGen gen;
+    gen.SetEncodeTo( encodeTo );
+
     for(; 0 < argc; --argc, ++argv )
     {
         std::string name = *argv;
@@ -137,6 +145,7 @@ void usage()
             "Options:\n"
             "  -I directory    Output header files to directory\n"
             "  -S directory    Output source files to directory\n"
+            "  -w              Generate direct-to-wire EncodeTo() methods too\n"
             "  -h              Show this help and exit\n"
     );
 }